@@ -0,0 +1,46 @@
+// 融合注意力的微基准：BERT-base的双向自注意力，Qwen2的GQA因果注意力（prefill与带KV cache的decode）
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+struct AttentionShape {
+    const char* name;
+    int64_t batch, q_heads, kv_heads, q_len, kv_len, head_dim;
+    bool causal;
+};
+
+const std::vector<AttentionShape>& AttentionShapes() {
+    static const std::vector<AttentionShape> shapes = {
+        {"bert_base_seq128", 1, 12, 12, 128, 128, 64, false},
+        {"bert_base_seq512", 1, 12, 12, 512, 512, 64, false},
+        {"bert_base_batch8_seq128", 8, 12, 12, 128, 128, 64, false},
+        {"qwen2_0.5b_prefill_512", 1, 14, 2, 512, 512, 64, true},
+        {"qwen2_0.5b_decode_kv1024", 1, 14, 2, 1, 1024, 64, true},
+        {"qwen_7b_prefill_1024", 1, 32, 32, 1024, 1024, 128, true},
+        {"qwen_7b_decode_kv2048", 1, 32, 32, 1, 2048, 128, true},
+    };
+    return shapes;
+}
+
+} // anonymous namespace
+
+void RegisterAttentionBenchmarks() {
+    for (const AttentionShape& s : AttentionShapes()) {
+        RegisterKernel("FusedAttention", s.name, [s]() {
+            KernelCase c;
+            c.op_type = "FusedAttention";
+            c.attributes = {{"causal", AttributeValue(static_cast<int64_t>(s.causal))}};
+            c.inputs = {RandomTensor(Shape({s.batch, s.q_heads, s.q_len, s.head_dim}), DataType::FLOAT32, 1),
+                        RandomTensor(Shape({s.batch, s.kv_heads, s.kv_len, s.head_dim}), DataType::FLOAT32, 2),
+                        RandomTensor(Shape({s.batch, s.kv_heads, s.kv_len, s.head_dim}), DataType::FLOAT32, 3)};
+            return c;
+        }, true);
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
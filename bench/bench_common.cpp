@@ -0,0 +1,229 @@
+// 算子微基准的公共部分与入口
+// 参考ONNX Runtime的onnxruntime_benchmark（Google Benchmark）：每个用例单独创建算子与张量，
+// 首次Execute在计时之外完成（权重打包/变换等惰性准备），计时循环只调用Execute
+
+#include "bench_common.h"
+#include "inferunity/float16.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+// 已注册用例覆盖的算子类型，用于报告没有基准的已注册算子
+std::set<std::string>& CoveredOps() {
+    static std::set<std::string> ops;
+    return ops;
+}
+
+uint32_t NextRandom(uint32_t* state) {
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+void RunKernel(benchmark::State& state, const KernelCaseBuilder& builder) {
+    const size_t threads = static_cast<size_t>(state.range(0));
+    if (ThreadPool::GetThreadCount() != threads) {
+        ThreadPoolOptions options;
+        options.num_threads = threads;
+        ThreadPool::Configure(options);
+    }
+    
+    KernelCase kernel_case = builder();
+    std::unique_ptr<Operator> op = OperatorRegistry::Instance().Create(kernel_case.op_type);
+    if (!op) {
+        state.SkipWithError(("operator not registered: " + kernel_case.op_type).c_str());
+        return;
+    }
+    for (const auto& attribute : kernel_case.attributes) {
+        op->SetAttribute(attribute.first, attribute.second);
+    }
+    
+    std::vector<Tensor*> inputs;
+    std::vector<TensorInfo> input_infos;
+    for (const auto& tensor : kernel_case.inputs) {
+        inputs.push_back(tensor.get());
+        input_infos.push_back(TensorInfo{tensor->GetShape(), tensor->GetDataType(), tensor.get()});
+    }
+    Status status = op->ValidateInputs(inputs);
+    std::vector<TensorInfo> output_infos;
+    if (status.IsOk()) {
+        status = op->InferOutputInfo(input_infos, output_infos);
+    }
+    std::vector<std::shared_ptr<Tensor>> output_tensors;
+    std::vector<Tensor*> outputs;
+    for (const TensorInfo& info : output_infos) {
+        output_tensors.push_back(CreateTensor(info.shape, info.dtype, DeviceType::CPU));
+        outputs.push_back(output_tensors.back().get());
+    }
+    
+    ExecutionContext ctx;
+    if (status.IsOk()) {
+        status = op->Execute(inputs, outputs, &ctx);
+    }
+    if (!status.IsOk()) {
+        state.SkipWithError(status.Message().c_str());
+        return;
+    }
+    
+    for (auto _ : state) {
+        status = op->Execute(inputs, outputs, &ctx);
+        benchmark::DoNotOptimize(status);
+    }
+    if (!status.IsOk()) {
+        state.SkipWithError(status.Message().c_str());
+        return;
+    }
+    
+    const OperatorCost cost = op->EstimateCost(input_infos, output_infos);
+    // 以每秒计的速率，控制台按1000进位显示（如FLOP=31.2G/s、Bytes=228M/s）
+    state.counters["FLOP"] = benchmark::Counter(cost.flops, benchmark::Counter::kIsIterationInvariantRate,
+                                                benchmark::Counter::OneK::kIs1000);
+    state.counters["Bytes"] = benchmark::Counter(static_cast<double>(cost.GetBytes()),
+                                                 benchmark::Counter::kIsIterationInvariantRate,
+                                                 benchmark::Counter::OneK::kIs1000);
+    state.counters["FLOP/byte"] = cost.GetArithmeticIntensity();
+}
+
+} // anonymous namespace
+
+std::vector<int64_t> ThreadCounts(bool sweep) {
+    const int64_t max_threads = std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<int64_t> counts = {1};
+    if (sweep) {
+        for (int64_t threads = 2; threads < max_threads; threads *= 2) {
+            counts.push_back(threads);
+        }
+    }
+    if (max_threads > 1) {
+        counts.push_back(max_threads);
+    }
+    return counts;
+}
+
+void RegisterKernel(const std::string& op_type, const std::string& shape_name,
+                    KernelCaseBuilder builder, bool thread_sweep) {
+    CoveredOps().insert(op_type);
+    auto* registered = benchmark::RegisterBenchmark(
+        (op_type + "/" + shape_name).c_str(),
+        [builder](benchmark::State& state) { RunKernel(state, builder); });
+    registered->ArgName("threads")->Unit(benchmark::kMicrosecond)->UseRealTime();
+    for (int64_t threads : ThreadCounts(thread_sweep)) {
+        registered->Arg(threads);
+    }
+}
+
+std::shared_ptr<Tensor> RandomTensor(const Shape& shape, DataType dtype, uint32_t seed) {
+    auto tensor = CreateTensor(shape, dtype, DeviceType::CPU);
+    uint32_t state = seed * 2654435761u + 1;
+    const size_t count = tensor->GetElementCount();
+    switch (dtype) {
+        case DataType::FLOAT32: {
+            float* data = static_cast<float*>(tensor->GetData());
+            for (size_t i = 0; i < count; ++i) {
+                data[i] = static_cast<float>(NextRandom(&state) >> 8) / 8388608.0f - 1.0f;
+            }
+            break;
+        }
+        case DataType::FLOAT16: {
+            uint16_t* data = static_cast<uint16_t*>(tensor->GetData());
+            for (size_t i = 0; i < count; ++i) {
+                data[i] = FloatToHalf(static_cast<float>(NextRandom(&state) >> 8) / 8388608.0f - 1.0f);
+            }
+            break;
+        }
+        case DataType::BOOL: {
+            uint8_t* data = static_cast<uint8_t*>(tensor->GetData());
+            for (size_t i = 0; i < count; ++i) {
+                data[i] = static_cast<uint8_t>(NextRandom(&state) & 1);
+            }
+            break;
+        }
+        default: {
+            uint8_t* data = static_cast<uint8_t*>(tensor->GetData());
+            const size_t bytes = count * GetDataTypeSize(dtype);
+            for (size_t i = 0; i < bytes; ++i) {
+                data[i] = static_cast<uint8_t>(NextRandom(&state));
+            }
+            break;
+        }
+    }
+    return tensor;
+}
+
+std::shared_ptr<Tensor> FilledTensor(const Shape& shape, float value) {
+    auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    std::fill_n(static_cast<float*>(tensor->GetData()), tensor->GetElementCount(), value);
+    return tensor;
+}
+
+std::shared_ptr<Tensor> Int64Tensor(const Shape& shape, const std::vector<int64_t>& values) {
+    auto tensor = CreateTensor(shape, DataType::INT64, DeviceType::CPU);
+    std::memcpy(tensor->GetData(), values.data(), values.size() * sizeof(int64_t));
+    return tensor;
+}
+
+std::shared_ptr<Tensor> IndexTensor(const Shape& shape, int64_t limit, uint32_t seed) {
+    auto tensor = CreateTensor(shape, DataType::INT64, DeviceType::CPU);
+    uint32_t state = seed * 2654435761u + 1;
+    int64_t* data = static_cast<int64_t*>(tensor->GetData());
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        data[i] = static_cast<int64_t>(NextRandom(&state) % static_cast<uint32_t>(limit));
+    }
+    return tensor;
+}
+
+std::shared_ptr<Tensor> ScalarTensor(float value) {
+    return FilledTensor(Shape({1}), value);
+}
+
+std::shared_ptr<Tensor> ScalarTensor(DataType dtype, int64_t value) {
+    auto tensor = CreateTensor(Shape({1}), dtype, DeviceType::CPU);
+    switch (dtype) {
+        case DataType::INT8: *static_cast<int8_t*>(tensor->GetData()) = static_cast<int8_t>(value); break;
+        case DataType::UINT8: *static_cast<uint8_t*>(tensor->GetData()) = static_cast<uint8_t>(value); break;
+        case DataType::INT32: *static_cast<int32_t*>(tensor->GetData()) = static_cast<int32_t>(value); break;
+        default: *static_cast<int64_t*>(tensor->GetData()) = value; break;
+    }
+    return tensor;
+}
+
+} // namespace bench
+} // namespace inferunity
+
+int main(int argc, char** argv) {
+    using namespace inferunity::bench;
+    RegisterConvBenchmarks();
+    RegisterGemmBenchmarks();
+    RegisterAttentionBenchmarks();
+    RegisterNormalizationBenchmarks();
+    RegisterElementwiseBenchmarks();
+    RegisterPoolingBenchmarks();
+    RegisterShapeBenchmarks();
+    
+    // 新注册的算子没有用例时提醒补上
+    for (const std::string& op : inferunity::OperatorRegistry::Instance().GetRegisteredOps()) {
+        if (!CoveredOps().count(op)) {
+            std::cerr << "Warning: no microbenchmark for registered operator " << op << std::endl;
+        }
+    }
+    
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
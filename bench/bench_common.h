@@ -0,0 +1,55 @@
+#pragma once
+
+// 算子微基准的公共部分（基于Google Benchmark）
+// 每个用例描述一个算子调用：算子类型、属性和输入张量（在基准运行时才构造，避免注册时分配全部形状）。
+// 输出按InferOutputInfo分配，计时只包含Execute；每次迭代的解析FLOP与字节数取自Operator::EstimateCost，
+// 以FLOP与Bytes速率计数器（即FLOP/s、字节/秒）报告。线程数作为基准参数，运行前通过ThreadPool::Configure切换
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace bench {
+
+struct KernelCase {
+    std::string op_type;
+    std::map<std::string, AttributeValue> attributes;
+    std::vector<std::shared_ptr<Tensor>> inputs;
+};
+
+using KernelCaseBuilder = std::function<KernelCase()>;
+
+// 线程数扫描：sweep为true时取1、2、4…直到硬件并发数，否则只取1与硬件并发数
+std::vector<int64_t> ThreadCounts(bool sweep);
+
+// 注册一个用例，基准名为"<op_type>/<shape_name>/threads:N"
+void RegisterKernel(const std::string& op_type, const std::string& shape_name,
+                    KernelCaseBuilder builder, bool thread_sweep = false);
+
+// 确定性的伪随机数据：FLOAT32/FLOAT16在[-1, 1]，BOOL为0/1，其余类型逐字节随机
+std::shared_ptr<Tensor> RandomTensor(const Shape& shape, DataType dtype = DataType::FLOAT32,
+                                     uint32_t seed = 1);
+std::shared_ptr<Tensor> FilledTensor(const Shape& shape, float value);
+std::shared_ptr<Tensor> Int64Tensor(const Shape& shape, const std::vector<int64_t>& values);
+// 在[0, limit)内的INT64索引
+std::shared_ptr<Tensor> IndexTensor(const Shape& shape, int64_t limit, uint32_t seed = 1);
+std::shared_ptr<Tensor> ScalarTensor(float value);
+std::shared_ptr<Tensor> ScalarTensor(DataType dtype, int64_t value);
+
+// 各类算子的用例注册（bench_*.cpp）
+void RegisterConvBenchmarks();
+void RegisterGemmBenchmarks();
+void RegisterAttentionBenchmarks();
+void RegisterNormalizationBenchmarks();
+void RegisterElementwiseBenchmarks();
+void RegisterPoolingBenchmarks();
+void RegisterShapeBenchmarks();
+
+} // namespace bench
+} // namespace inferunity
@@ -0,0 +1,117 @@
+// 卷积类算子的微基准：ResNet-50各阶段的卷积形状（batch 1）
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+struct ConvShape {
+    const char* name;
+    int64_t channels, height, width, out_channels, kernel, stride;
+    
+    int64_t GetPad() const { return kernel / 2; }
+    int64_t GetOutHeight() const { return (height + 2 * GetPad() - kernel) / stride + 1; }
+    int64_t GetOutWidth() const { return (width + 2 * GetPad() - kernel) / stride + 1; }
+};
+
+const std::vector<ConvShape>& ResNetConvShapes() {
+    static const std::vector<ConvShape> shapes = {
+        {"resnet50_conv1_7x7s2", 3, 224, 224, 64, 7, 2},
+        {"resnet50_res2_1x1_reduce", 256, 56, 56, 64, 1, 1},
+        {"resnet50_res2_3x3", 64, 56, 56, 64, 3, 1},
+        {"resnet50_res2_1x1_expand", 64, 56, 56, 256, 1, 1},
+        {"resnet50_res3_downsample_1x1s2", 256, 56, 56, 512, 1, 2},
+        {"resnet50_res3_3x3", 128, 28, 28, 128, 3, 1},
+        {"resnet50_res4_3x3", 256, 14, 14, 256, 3, 1},
+        {"resnet50_res5_3x3", 512, 7, 7, 512, 3, 1},
+        {"resnet50_res5_1x1_expand", 512, 7, 7, 2048, 1, 1},
+    };
+    return shapes;
+}
+
+std::map<std::string, AttributeValue> ConvAttributes(const ConvShape& s) {
+    const int64_t pad = s.GetPad();
+    return {
+        {"kernel_shape", AttributeValue(std::vector<int64_t>{s.kernel, s.kernel})},
+        {"strides", AttributeValue(std::vector<int64_t>{s.stride, s.stride})},
+        {"pads", AttributeValue(std::vector<int64_t>{pad, pad, pad, pad})},
+    };
+}
+
+// X、W、B
+KernelCase ConvCase(const std::string& op_type, const ConvShape& s) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.attributes = ConvAttributes(s);
+    c.inputs = {RandomTensor(Shape({1, s.channels, s.height, s.width}), DataType::FLOAT32, 1),
+                RandomTensor(Shape({s.out_channels, s.channels, s.kernel, s.kernel}), DataType::FLOAT32, 2),
+                RandomTensor(Shape({s.out_channels}), DataType::FLOAT32, 3)};
+    return c;
+}
+
+bool IsBottleneck3x3(const ConvShape& s) {
+    return s.kernel == 3;
+}
+
+bool IsExpand1x1(const ConvShape& s) {
+    return s.kernel == 1 && s.out_channels > s.channels;
+}
+
+} // anonymous namespace
+
+void RegisterConvBenchmarks() {
+    for (const ConvShape& s : ResNetConvShapes()) {
+        RegisterKernel("Conv", s.name, [s]() { return ConvCase("Conv", s); }, true);
+        
+        if (IsBottleneck3x3(s)) {
+            RegisterKernel("FusedConvReLU", s.name, [s]() { return ConvCase("FusedConvReLU", s); });
+            
+            // BN参数：scale、B、mean、var（方差为正）
+            RegisterKernel("FusedConvBNReLU", s.name, [s]() {
+                KernelCase c = ConvCase("FusedConvBNReLU", s);
+                const Shape channels({s.out_channels});
+                c.inputs.push_back(RandomTensor(channels, DataType::FLOAT32, 4));
+                c.inputs.push_back(RandomTensor(channels, DataType::FLOAT32, 5));
+                c.inputs.push_back(RandomTensor(channels, DataType::FLOAT32, 6));
+                c.inputs.push_back(FilledTensor(channels, 1.0f));
+                return c;
+            });
+            
+            // 8通道分块布局，输入[N, C/8, H, W, 8]
+            RegisterKernel("NchwcConv", s.name, [s]() {
+                KernelCase c = ConvCase("NchwcConv", s);
+                c.inputs[0] = RandomTensor(Shape({1, s.channels / 8, s.height, s.width, 8}), DataType::FLOAT32, 1);
+                return c;
+            }, true);
+            
+            // UINT8激活、INT8权重、INT32 bias
+            RegisterKernel("QLinearConv", s.name, [s]() {
+                KernelCase c;
+                c.op_type = "QLinearConv";
+                c.attributes = ConvAttributes(s);
+                c.inputs = {RandomTensor(Shape({1, s.channels, s.height, s.width}), DataType::UINT8, 1),
+                            ScalarTensor(0.02f), ScalarTensor(DataType::UINT8, 128),
+                            RandomTensor(Shape({s.out_channels, s.channels, s.kernel, s.kernel}), DataType::INT8, 2),
+                            ScalarTensor(0.01f), ScalarTensor(DataType::INT8, 0),
+                            ScalarTensor(0.05f), ScalarTensor(DataType::UINT8, 128),
+                            RandomTensor(Shape({s.out_channels}), DataType::INT32, 3)};
+                return c;
+            }, true);
+        }
+        
+        // 残差块末尾的1x1扩展卷积 + 残差 + ReLU
+        if (IsExpand1x1(s)) {
+            RegisterKernel("FusedConvAddReLU", s.name, [s]() {
+                KernelCase c = ConvCase("FusedConvAddReLU", s);
+                c.inputs.push_back(RandomTensor(Shape({1, s.out_channels, s.GetOutHeight(), s.GetOutWidth()}),
+                                                DataType::FLOAT32, 4));
+                return c;
+            });
+        }
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
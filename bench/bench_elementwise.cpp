@@ -0,0 +1,131 @@
+// 逐元素、softmax与归约算子的微基准：BERT FFN激活[1, 128, 3072]、ResNet激活[1, 64, 112, 112]，
+// 注意力分数[1, 12, 128, 128]与LLM词表logits
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+struct TensorShape {
+    const char* name;
+    std::vector<int64_t> dims;
+};
+
+const std::vector<TensorShape>& ActivationShapes() {
+    static const std::vector<TensorShape> shapes = {
+        {"bert_base_ffn_1x128x3072", {1, 128, 3072}},
+        {"resnet50_conv1_1x64x112x112", {1, 64, 112, 112}},
+    };
+    return shapes;
+}
+
+KernelCase UnaryCase(const std::string& op_type, const Shape& shape) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.inputs = {RandomTensor(shape, DataType::FLOAT32, 1)};
+    return c;
+}
+
+KernelCase BinaryCase(const std::string& op_type, const Shape& a, const Shape& b) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.inputs = {RandomTensor(a, DataType::FLOAT32, 1), RandomTensor(b, DataType::FLOAT32, 2)};
+    // Div的除数、Pow的底数保持为正
+    if (op_type == "Div" || op_type == "Pow") {
+        for (auto& input : c.inputs) {
+            float* data = static_cast<float*>(input->GetData());
+            for (size_t i = 0; i < input->GetElementCount(); ++i) {
+                data[i] = data[i] * 0.5f + 1.0f;
+            }
+        }
+    }
+    return c;
+}
+
+} // anonymous namespace
+
+void RegisterElementwiseBenchmarks() {
+    for (const TensorShape& s : ActivationShapes()) {
+        const Shape shape(s.dims);
+        for (const char* op_type : {"Relu", "Sigmoid", "Tanh", "Gelu", "Silu"}) {
+            const std::string op(op_type);
+            RegisterKernel(op, s.name, [op, shape]() { return UnaryCase(op, shape); }, op == "Gelu");
+        }
+    }
+    
+    // 二元算子：同形与沿最后一维广播（bias）
+    const Shape hidden({1, 128, 768});
+    const Shape ffn({1, 128, 3072});
+    for (const char* op_type : {"Add", "Sub", "Mul", "Div", "Max", "Min"}) {
+        const std::string op(op_type);
+        RegisterKernel(op, "bert_base_1x128x768_same_shape",
+                       [op, hidden]() { return BinaryCase(op, hidden, hidden); }, op == "Add");
+        RegisterKernel(op, "bert_base_1x128x3072_bias_broadcast",
+                       [op, ffn]() { return BinaryCase(op, ffn, Shape({3072})); });
+    }
+    RegisterKernel("Pow", "bert_base_1x128x768_square", [hidden]() {
+        KernelCase c = BinaryCase("Pow", hidden, Shape({1}));
+        static_cast<float*>(c.inputs[1]->GetData())[0] = 2.0f;
+        return c;
+    });
+    RegisterKernel("Where", "bert_base_1x128x768", [hidden]() {
+        KernelCase c;
+        c.op_type = "Where";
+        c.inputs = {RandomTensor(hidden, DataType::BOOL, 1), RandomTensor(hidden, DataType::FLOAT32, 2),
+                    RandomTensor(hidden, DataType::FLOAT32, 3)};
+        return c;
+    });
+    
+    // 融合Pass产生的逐元素链：bias + GELU（BERT FFN）与x * sigmoid(x)（Qwen MLP的SiLU分解）
+    RegisterKernel("FusedElementwise", "bert_base_bias_gelu_1x128x3072", [ffn]() {
+        KernelCase c = BinaryCase("FusedElementwise", ffn, Shape({3072}));
+        c.attributes = {{"ops", AttributeValue(std::string("Add,Gelu"))}};
+        return c;
+    }, true);
+    RegisterKernel("FusedElementwise", "qwen2_0.5b_silu_1x512x4864", []() {
+        KernelCase c = UnaryCase("FusedElementwise", Shape({1, 512, 4864}));
+        c.attributes = {{"ops", AttributeValue(std::string("Sigmoid,Mul@0"))}};
+        return c;
+    });
+    
+    // softmax：注意力分数与Qwen2的词表logits（151936）
+    const std::vector<TensorShape> softmax_shapes = {
+        {"bert_base_scores_1x12x128x128", {1, 12, 128, 128}},
+        {"qwen2_vocab_logits_1x151936", {1, 151936}},
+    };
+    for (const TensorShape& s : softmax_shapes) {
+        const Shape shape(s.dims);
+        for (const char* op_type : {"Softmax", "LogSoftmax"}) {
+            const std::string op(op_type);
+            RegisterKernel(op, s.name, [op, shape]() {
+                KernelCase c = UnaryCase(op, shape);
+                c.attributes = {{"axis", AttributeValue(static_cast<int64_t>(-1))}};
+                return c;
+            }, op == "Softmax");
+        }
+    }
+    
+    // 归约：隐藏维（LayerNorm分解子图）与空间维（全局池化分解）
+    const std::vector<std::pair<TensorShape, std::vector<int64_t>>> reduce_shapes = {
+        {{"bert_base_1x128x768_last_axis", {1, 128, 768}}, {-1}},
+        {{"resnet50_1x2048x7x7_spatial", {1, 2048, 7, 7}}, {2, 3}},
+    };
+    for (const auto& entry : reduce_shapes) {
+        const Shape shape(entry.first.dims);
+        const std::vector<int64_t> axes = entry.second;
+        for (const char* op_type : {"ReduceSum", "ReduceMean", "ReduceMax", "ReduceMin",
+                                    "ReduceSumSquare", "ReduceL2"}) {
+            const std::string op(op_type);
+            RegisterKernel(op, entry.first.name, [op, shape, axes]() {
+                KernelCase c = UnaryCase(op, shape);
+                c.attributes = {{"axes", AttributeValue(axes)}, {"keepdims", AttributeValue(static_cast<int64_t>(1))}};
+                return c;
+            });
+        }
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
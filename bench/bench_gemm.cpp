@@ -0,0 +1,98 @@
+// 矩阵乘类算子的微基准：BERT-base（序列长128）与Qwen的投影/MLP形状，覆盖prefill与decode（M=1）
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+struct GemmShape {
+    const char* name;
+    int64_t m, k, n;
+};
+
+const std::vector<GemmShape>& TransformerGemmShapes() {
+    static const std::vector<GemmShape> shapes = {
+        {"bert_base_attn_proj", 128, 768, 768},
+        {"bert_base_ffn_up", 128, 768, 3072},
+        {"bert_base_ffn_down", 128, 3072, 768},
+        {"qwen2_0.5b_prefill_mlp_up", 512, 896, 4864},
+        {"qwen2_0.5b_decode_mlp_up", 1, 896, 4864},
+        {"qwen2_0.5b_decode_mlp_down", 1, 4864, 896},
+        {"qwen_7b_prefill_proj", 128, 4096, 4096},
+        {"qwen_7b_decode_proj", 1, 4096, 4096},
+    };
+    return shapes;
+}
+
+bool IsDecode(const GemmShape& s) {
+    return s.m == 1;
+}
+
+} // anonymous namespace
+
+void RegisterGemmBenchmarks() {
+    for (const GemmShape& s : TransformerGemmShapes()) {
+        RegisterKernel("MatMul", s.name, [s]() {
+            KernelCase c;
+            c.op_type = "MatMul";
+            c.inputs = {RandomTensor(Shape({s.m, s.k}), DataType::FLOAT32, 1),
+                        RandomTensor(Shape({s.k, s.n}), DataType::FLOAT32, 2)};
+            return c;
+        }, true);
+        
+        RegisterKernel("FusedMatMulAdd", s.name, [s]() {
+            KernelCase c;
+            c.op_type = "FusedMatMulAdd";
+            c.inputs = {RandomTensor(Shape({s.m, s.k}), DataType::FLOAT32, 1),
+                        RandomTensor(Shape({s.k, s.n}), DataType::FLOAT32, 2),
+                        RandomTensor(Shape({s.n}), DataType::FLOAT32, 3)};
+            return c;
+        });
+        
+        // 4位分块量化权重（block 32，FLOAT16 scales，无zero points）：LLM decode的主要路径
+        RegisterKernel("MatMulNBits", s.name, [s]() {
+            const int64_t bits = 4, block_size = 32;
+            const int64_t blocks = (s.k + block_size - 1) / block_size;
+            KernelCase c;
+            c.op_type = "MatMulNBits";
+            c.attributes = {{"K", AttributeValue(s.k)}, {"N", AttributeValue(s.n)},
+                            {"bits", AttributeValue(bits)}, {"block_size", AttributeValue(block_size)}};
+            c.inputs = {RandomTensor(Shape({s.m, s.k}), DataType::FLOAT32, 1),
+                        RandomTensor(Shape({s.n, blocks, block_size * bits / 8}), DataType::UINT8, 2),
+                        RandomTensor(Shape({s.n * blocks}), DataType::FLOAT16, 3)};
+            return c;
+        }, IsDecode(s));
+        
+        RegisterKernel("QLinearMatMul", s.name, [s]() {
+            KernelCase c;
+            c.op_type = "QLinearMatMul";
+            c.inputs = {RandomTensor(Shape({s.m, s.k}), DataType::UINT8, 1),
+                        ScalarTensor(0.02f), ScalarTensor(DataType::UINT8, 128),
+                        RandomTensor(Shape({s.k, s.n}), DataType::INT8, 2),
+                        ScalarTensor(0.01f), ScalarTensor(DataType::INT8, 0),
+                        ScalarTensor(0.05f), ScalarTensor(DataType::UINT8, 128)};
+            return c;
+        });
+    }
+    
+    // 注意力中的批量矩阵乘（未融合路径）：BERT-base的Q*K^T与P*V
+    RegisterKernel("MatMul", "bert_base_scores_batched", []() {
+        KernelCase c;
+        c.op_type = "MatMul";
+        c.inputs = {RandomTensor(Shape({12, 128, 64}), DataType::FLOAT32, 1),
+                    RandomTensor(Shape({12, 64, 128}), DataType::FLOAT32, 2)};
+        return c;
+    });
+    RegisterKernel("MatMul", "bert_base_context_batched", []() {
+        KernelCase c;
+        c.op_type = "MatMul";
+        c.inputs = {RandomTensor(Shape({12, 128, 128}), DataType::FLOAT32, 1),
+                    RandomTensor(Shape({12, 128, 64}), DataType::FLOAT32, 2)};
+        return c;
+    });
+}
+
+} // namespace bench
+} // namespace inferunity
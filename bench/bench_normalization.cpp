@@ -0,0 +1,102 @@
+// 归一化算子的微基准：Transformer的LayerNorm/RMSNorm宽度（BERT 768/1024，Qwen 896/4096），
+// ResNet-50的BatchNormalization通道与分辨率
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+struct NormShape {
+    const char* name;
+    int64_t rows, width;
+};
+
+const std::vector<NormShape>& NormShapes() {
+    static const std::vector<NormShape> shapes = {
+        {"bert_base_128x768", 128, 768},
+        {"bert_large_128x1024", 128, 1024},
+        {"qwen2_0.5b_512x896", 512, 896},
+        {"qwen_7b_128x4096", 128, 4096},
+        {"qwen_7b_decode_1x4096", 1, 4096},
+    };
+    return shapes;
+}
+
+struct ChannelShape {
+    const char* name;
+    int64_t channels, height, width;
+};
+
+const std::vector<ChannelShape>& BatchNormShapes() {
+    static const std::vector<ChannelShape> shapes = {
+        {"resnet50_conv1_64x112x112", 64, 112, 112},
+        {"resnet50_res2_256x56x56", 256, 56, 56},
+        {"resnet50_res5_2048x7x7", 2048, 7, 7},
+    };
+    return shapes;
+}
+
+// 输入为[1, rows, width]：LayerNorm类为(x[, residual], scale, bias)，RMSNorm类为(x[, residual], scale)
+KernelCase LastAxisNormCase(const std::string& op_type, const NormShape& s, bool fused_add, bool with_bias) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.attributes = {{"axis", AttributeValue(static_cast<int64_t>(-1))}};
+    c.inputs.push_back(RandomTensor(Shape({1, s.rows, s.width}), DataType::FLOAT32, 1));
+    if (fused_add) {
+        c.inputs.push_back(RandomTensor(Shape({1, s.rows, s.width}), DataType::FLOAT32, 2));
+    }
+    c.inputs.push_back(RandomTensor(Shape({s.width}), DataType::FLOAT32, 3));
+    if (with_bias) {
+        c.inputs.push_back(RandomTensor(Shape({s.width}), DataType::FLOAT32, 4));
+    }
+    return c;
+}
+
+// scale、B、mean、var
+void AppendBatchNormParams(int64_t channels, KernelCase* c) {
+    const Shape shape({channels});
+    c->inputs.push_back(RandomTensor(shape, DataType::FLOAT32, 2));
+    c->inputs.push_back(RandomTensor(shape, DataType::FLOAT32, 3));
+    c->inputs.push_back(RandomTensor(shape, DataType::FLOAT32, 4));
+    c->inputs.push_back(FilledTensor(shape, 1.0f));
+}
+
+} // anonymous namespace
+
+void RegisterNormalizationBenchmarks() {
+    for (const NormShape& s : NormShapes()) {
+        RegisterKernel("LayerNormalization", s.name,
+                       [s]() { return LastAxisNormCase("LayerNormalization", s, false, true); }, true);
+        RegisterKernel("AddLayerNorm", s.name,
+                       [s]() { return LastAxisNormCase("AddLayerNorm", s, true, true); });
+        RegisterKernel("RMSNorm", s.name,
+                       [s]() { return LastAxisNormCase("RMSNorm", s, false, false); }, true);
+        RegisterKernel("AddRMSNorm", s.name,
+                       [s]() { return LastAxisNormCase("AddRMSNorm", s, true, false); });
+    }
+    
+    for (const ChannelShape& s : BatchNormShapes()) {
+        for (const char* op_type : {"BatchNormalization", "FusedBNReLU"}) {
+            const std::string op(op_type);
+            RegisterKernel(op, s.name, [s, op]() {
+                KernelCase c;
+                c.op_type = op;
+                c.inputs = {RandomTensor(Shape({1, s.channels, s.height, s.width}), DataType::FLOAT32, 1)};
+                AppendBatchNormParams(s.channels, &c);
+                return c;
+            });
+        }
+        RegisterKernel("NchwcBatchNormalization", s.name, [s]() {
+            KernelCase c;
+            c.op_type = "NchwcBatchNormalization";
+            c.inputs = {RandomTensor(Shape({1, s.channels / 8, s.height, s.width, 8}), DataType::FLOAT32, 1)};
+            AppendBatchNormParams(s.channels, &c);
+            return c;
+        });
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
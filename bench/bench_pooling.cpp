@@ -0,0 +1,58 @@
+// 池化算子的微基准：ResNet-50 stem的3x3/s2 MaxPool与head的全局池化，NCHW与NCHWc两种布局
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+const int64_t kBlock = 8;
+
+std::map<std::string, AttributeValue> WindowAttributes(int64_t kernel, int64_t stride, int64_t pad) {
+    return {
+        {"kernel_shape", AttributeValue(std::vector<int64_t>{kernel, kernel})},
+        {"strides", AttributeValue(std::vector<int64_t>{stride, stride})},
+        {"pads", AttributeValue(std::vector<int64_t>{pad, pad, pad, pad})},
+    };
+}
+
+KernelCase PoolCase(const std::string& op_type, int64_t channels, int64_t size, bool blocked) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.inputs = {blocked ? RandomTensor(Shape({1, channels / kBlock, size, size, kBlock}), DataType::FLOAT32, 1)
+                        : RandomTensor(Shape({1, channels, size, size}), DataType::FLOAT32, 1)};
+    return c;
+}
+
+} // anonymous namespace
+
+void RegisterPoolingBenchmarks() {
+    // stem：[1, 64, 112, 112]上3x3、步长2的MaxPool；平均池化取同样的窗口
+    for (const char* op_type : {"MaxPool", "AveragePool", "AvgPool", "NchwcMaxPool", "NchwcAveragePool"}) {
+        const std::string op(op_type);
+        const bool blocked = op.compare(0, 5, "Nchwc") == 0;
+        RegisterKernel(op, "resnet50_stem_3x3s2_1x64x112x112", [op, blocked]() {
+            KernelCase c = PoolCase(op, 64, 112, blocked);
+            c.attributes = WindowAttributes(3, 2, 1);
+            return c;
+        }, op == "MaxPool");
+    }
+    
+    // head：[1, 2048, 7, 7]上的全局池化；NCHWc版本直接输出NCHW，需给出逻辑通道数
+    for (const char* op_type : {"GlobalAveragePool", "GlobalAvgPool", "GlobalMaxPool",
+                                "NchwcGlobalAveragePool", "NchwcGlobalMaxPool"}) {
+        const std::string op(op_type);
+        const bool blocked = op.compare(0, 5, "Nchwc") == 0;
+        RegisterKernel(op, "resnet50_head_1x2048x7x7", [op, blocked]() {
+            KernelCase c = PoolCase(op, 2048, 7, blocked);
+            if (blocked) {
+                c.attributes = {{"channels", AttributeValue(static_cast<int64_t>(2048))}};
+            }
+            return c;
+        });
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
@@ -0,0 +1,117 @@
+// 数据搬运、类型转换与量化算子的微基准：Transformer的多头拆分/合并、KV cache拼接、词嵌入查表，
+// 以及NCHW与NCHWc之间的布局转换
+
+#include "bench_common.h"
+
+namespace inferunity {
+namespace bench {
+
+namespace {
+
+KernelCase SingleInputCase(const std::string& op_type, const Shape& shape,
+                           DataType dtype = DataType::FLOAT32) {
+    KernelCase c;
+    c.op_type = op_type;
+    c.inputs = {RandomTensor(shape, dtype, 1)};
+    return c;
+}
+
+} // anonymous namespace
+
+void RegisterShapeBenchmarks() {
+    const Shape hidden({1, 128, 768});
+    
+    // 多头拆分：[1, 128, 12, 64] -> [1, 12, 128, 64]
+    RegisterKernel("Transpose", "bert_base_split_heads", []() {
+        KernelCase c = SingleInputCase("Transpose", Shape({1, 128, 12, 64}));
+        c.attributes = {{"perm", AttributeValue(std::vector<int64_t>{0, 2, 1, 3})}};
+        return c;
+    }, true);
+    RegisterKernel("Reshape", "bert_base_split_heads", [hidden]() {
+        KernelCase c = SingleInputCase("Reshape", hidden);
+        c.inputs.push_back(Int64Tensor(Shape({4}), {1, 128, 12, 64}));
+        return c;
+    });
+    RegisterKernel("Shape", "bert_base_1x128x768", [hidden]() { return SingleInputCase("Shape", hidden); });
+    
+    // 融合的QKV投影输出[1, 128, 2304]按Q/K/V拆开
+    RegisterKernel("Split", "bert_base_qkv", []() {
+        KernelCase c = SingleInputCase("Split", Shape({1, 128, 2304}));
+        c.attributes = {{"axis", AttributeValue(static_cast<int64_t>(2))},
+                        {"split", AttributeValue(std::vector<int64_t>{768, 768, 768})}};
+        return c;
+    });
+    RegisterKernel("Slice", "bert_base_qkv_take_k", []() {
+        KernelCase c = SingleInputCase("Slice", Shape({1, 128, 2304}));
+        c.inputs.push_back(Int64Tensor(Shape({1}), {768}));
+        c.inputs.push_back(Int64Tensor(Shape({1}), {1536}));
+        c.attributes = {{"axes", AttributeValue(std::vector<int64_t>{2})}};
+        return c;
+    });
+    
+    // decode时把新一步的K追加到KV cache：[1, 2, 1023, 64] + [1, 2, 1, 64]
+    RegisterKernel("Concat", "qwen2_0.5b_kv_cache_append", []() {
+        KernelCase c;
+        c.op_type = "Concat";
+        c.attributes = {{"axis", AttributeValue(static_cast<int64_t>(2))}};
+        c.inputs = {RandomTensor(Shape({1, 2, 1023, 64}), DataType::FLOAT32, 1),
+                    RandomTensor(Shape({1, 2, 1, 64}), DataType::FLOAT32, 2)};
+        return c;
+    });
+    
+    // 词嵌入查表：BERT词表30522 x 768，128个token
+    RegisterKernel("Gather", "bert_base_word_embeddings", []() {
+        KernelCase c;
+        c.op_type = "Gather";
+        c.attributes = {{"axis", AttributeValue(static_cast<int64_t>(0))}};
+        c.inputs = {RandomTensor(Shape({30522, 768}), DataType::FLOAT32, 1), IndexTensor(Shape({1, 128}), 30522, 2)};
+        return c;
+    });
+    RegisterKernel("Embedding", "bert_base_word_embeddings", []() {
+        KernelCase c;
+        c.op_type = "Embedding";
+        c.inputs = {IndexTensor(Shape({1, 128}), 30522, 2), RandomTensor(Shape({30522, 768}), DataType::FLOAT32, 1)};
+        return c;
+    });
+    
+    // FLOAT32 -> FLOAT16（TensorProto编号10）
+    RegisterKernel("Cast", "bert_base_fp32_to_fp16", [hidden]() {
+        KernelCase c = SingleInputCase("Cast", hidden);
+        c.attributes = {{"to", AttributeValue(static_cast<int64_t>(10))}};
+        return c;
+    });
+    
+    RegisterKernel("QuantizeLinear", "bert_base_1x128x768_uint8", [hidden]() {
+        KernelCase c = SingleInputCase("QuantizeLinear", hidden);
+        c.inputs.push_back(ScalarTensor(0.02f));
+        c.inputs.push_back(ScalarTensor(DataType::UINT8, 128));
+        return c;
+    });
+    RegisterKernel("DequantizeLinear", "bert_base_1x128x768_uint8", [hidden]() {
+        KernelCase c = SingleInputCase("DequantizeLinear", hidden, DataType::UINT8);
+        c.inputs.push_back(ScalarTensor(0.02f));
+        c.inputs.push_back(ScalarTensor(DataType::UINT8, 128));
+        return c;
+    });
+    
+    // NCHW <-> NCHWc（块大小8）
+    RegisterKernel("ReorderInput", "resnet50_res2_1x64x56x56", []() {
+        KernelCase c = SingleInputCase("ReorderInput", Shape({1, 64, 56, 56}));
+        c.attributes = {{"block_size", AttributeValue(static_cast<int64_t>(8))}};
+        return c;
+    });
+    RegisterKernel("ReorderOutput", "resnet50_res2_1x64x56x56", []() {
+        KernelCase c = SingleInputCase("ReorderOutput", Shape({1, 8, 56, 56, 8}));
+        c.attributes = {{"channels", AttributeValue(static_cast<int64_t>(64))}};
+        return c;
+    });
+    
+    // CPU上的跨设备拷贝退化为内存拷贝，作为带宽基线
+    for (const char* op_type : {"MemcpyToDevice", "MemcpyFromDevice"}) {
+        const std::string op(op_type);
+        RegisterKernel(op, "bert_base_1x128x768", [op, hidden]() { return SingleInputCase(op, hidden); });
+    }
+}
+
+} // namespace bench
+} // namespace inferunity
@@ -4,6 +4,7 @@
 #include "inferunity/engine.h"
 #include "inferunity/logger.h"
 #include "inferunity/graph.h"
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <unordered_set>
@@ -95,7 +96,7 @@ void CheckOperators(inferunity::InferenceSession* session) {
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "用法: " << argv[0] << " <qwen2.5-0.5b-model.onnx>" << std::endl;
+        std::cerr << "用法: " << argv[0] << " <qwen2.5-0.5b-model.onnx> [weight_bits(4|8)]" << std::endl;
         std::cerr << "示例: " << argv[0] << " qwen2.5-0.5b-instruct.onnx" << std::endl;
         return 1;
     }
@@ -123,6 +124,10 @@ int main(int argc, char* argv[]) {
     options.graph_optimization_level = inferunity::SessionOptions::GraphOptimizationLevel::ALL;
     options.enable_profiling = true;
     options.num_threads = 0;  // 自动检测
+    // 解码阶段MatMul受权重带宽限制：可选把FP32权重按组量化为4/8位（已是MatMulNBits的模型无需设置）
+    if (argc > 2) {
+        options.weight_only_quantization_bits = std::atoi(argv[2]);
+    }
     
     auto session = inferunity::InferenceSession::Create(options);
     if (!session) {
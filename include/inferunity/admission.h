@@ -0,0 +1,72 @@
+#pragma once
+
+// 准入控制与负载削减（参考Google SRE的adaptive throttling与Envoy的adaptive concurrency）：
+// 过载时无界排队使每个请求都超时，吞吐全部浪费在注定失败的请求上。受理前按在途的运行数与最近运行耗时
+// 预测完成时间，超过请求的截止时间时立即拒绝；已排队的请求开始执行前再检查一次，剩余时间已不够一次运行的
+// 直接放弃。被拒绝的请求返回ERROR_OVERLOADED，客户端可据此重试其他副本；按时完成的请求数（goodput）保持
+
+#include "types.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace inferunity {
+
+struct AdmissionOptions {
+    // 运行耗时的指数滑动平均中最近一次的权重
+    double latency_smoothing = 0.2;
+    // 没有截止时间的请求的目标完成时间（毫秒），0表示这类请求不按预测拒绝
+    double default_deadline_ms = 0.0;
+    // 预测的运行耗时乘以该倍数后再与截止时间比较，> 1时更早拒绝
+    double safety_factor = 1.0;
+};
+
+struct AdmissionStats {
+    uint64_t admitted = 0;
+    uint64_t rejected = 0;             // 受理时预测超过截止时间而拒绝
+    uint64_t shed = 0;                 // 排队后开始前剩余时间不够而放弃
+    uint64_t completed = 0;
+    size_t queued = 0;                 // 已受理、尚未开始
+    size_t running = 0;
+    double service_time_ms = 0.0;      // 当前的单次运行耗时估计，尚无完成的运行时为0
+    double predicted_queue_delay_ms = 0.0;  // 此刻受理的请求预计的排队时间
+};
+
+// 队列延迟的预测：concurrency个运行同时执行，新请求需等前面的queued + running - concurrency + 1个运行完成，
+// 每个运行耗时按滑动平均估计。尚无完成的运行时不拒绝。所有方法线程安全
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    explicit AdmissionController(const AdmissionOptions& options = AdmissionOptions());
+    
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+    
+    // 受理一个截止时间为deadline（Clock::time_point::max()表示没有）的请求：预测的排队时间加运行耗时超过
+    // 截止时间时返回ERROR_OVERLOADED，否则计入排队
+    Status Admit(Clock::time_point deadline, size_t concurrency);
+    // 已受理的请求开始执行：有截止时间且剩余时间不够一次运行时返回ERROR_OVERLOADED并移出队列
+    // （之后不调用Finish），否则转为执行中
+    Status Start(Clock::time_point deadline);
+    // 执行结束；service_ms为本次运行耗时，< 0表示运行失败，不更新估计
+    void Finish(double service_ms);
+    // 已受理的请求没有开始就结束（例如排队期间被取消），只移出队列
+    void Withdraw();
+    
+    double PredictQueueDelayMs(size_t concurrency) const;
+    AdmissionStats GetStats() const;
+    const AdmissionOptions& GetOptions() const { return options_; }
+
+private:
+    // 需持有mutex_
+    double PredictQueueDelayLocked(size_t concurrency) const;
+    
+    AdmissionOptions options_;
+    mutable std::mutex mutex_;
+    AdmissionStats stats_;
+    size_t concurrency_ = 1;  // 最近一次Admit给出的并发数
+};
+
+} // namespace inferunity
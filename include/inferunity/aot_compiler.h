@@ -0,0 +1,46 @@
+#pragma once
+
+// 静态图AOT编译（参考TVM的AOT执行器与TFLite Micro的离线代码生成）
+// 把形状全部静态、已优化并完成内存规划的图生成为独立的C++源文件：生成的函数按执行顺序直接调用
+// aot_kernels.h中的内核，形状与属性是字面量，中间张量是arena内预先算好的偏移，常量权重放在单独的
+// 字节数组里与程序一起链接。运行时不需要算子注册表、属性表、执行计划和虚函数分派，
+// 调用全部可见，整个程序可以做LTO
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+struct MemoryPlan;
+
+struct AotCompileOptions {
+    // 生成的符号以它为前缀，须是合法的C标识符
+    std::string function_name = "inferunity_model";
+    // 生成代码包含的头文件名（通常是写出header的文件名）
+    std::string header_name = "inferunity_model.h";
+};
+
+// 生成的接口（extern "C"，声明在header中）：
+//   size_t <name>_arena_size(void);  中间张量与卷积工作区所需的字节数
+//   void <name>(const float* const* inputs, float* const* outputs, void* arena);
+// inputs/outputs按图的输入、输出顺序；arena至少<name>_arena_size()字节且64字节对齐，调用之间内容无需保留。
+// 同一arena不能被并发调用共用
+struct AotCompileResult {
+    std::string source;          // 模型函数
+    std::string header;          // 接口声明，注释中列出各输入输出的名称与形状
+    std::string weights_source;  // 权重：64字节对齐的<name>_weights字节数组
+    std::vector<uint8_t> weights;
+    size_t arena_size = 0;
+    size_t num_kernel_calls = 0;
+};
+
+// plan须是同一图的PlanMemory结果（执行顺序为graph.TopologicalSort()，图输出不在规划中）。
+// 计算的张量须为FLOAT32且形状静态；图中有不支持的算子时返回ERROR_NOT_IMPLEMENTED，消息列出全部不支持的节点
+Status CompileGraphToSource(const Graph& graph, const MemoryPlan& plan, const AotCompileOptions& options,
+                            AotCompileResult* result);
+
+} // namespace inferunity
@@ -0,0 +1,94 @@
+#pragma once
+
+// AOT生成代码调用的内核（见aot_compiler.h）
+// 普通的非虚函数：形状与属性在代码生成时确定，以字面量传入，不经过算子注册表、属性表与执行计划；
+// 内部仍复用算子库的GEMM与SIMD内核（向量核按运行时CPU特性选择，见simd_utils.h）。
+// 所有张量为连续的FLOAT32，输出不得与输入部分重叠（完全相同的地址即原地执行，逐元素内核允许）
+
+#include <cstddef>
+#include <cstdint>
+
+namespace inferunity {
+namespace aot {
+
+enum class Activation : int { NONE = 0, RELU = 1, GELU = 2, GELU_TANH = 3 };
+
+// C[batch][M, N] = alpha * op(A) * op(B) + beta * bias，随后应用激活。
+// a_stride/b_stride为相邻批次的元素跨度（B在批次间共享时为0）；
+// bias_size为0（无）、1（标量）、N（按行广播）或batch * M * N（与C同形）
+struct GemmShape {
+    int64_t batch;
+    int64_t M, N, K;
+    bool trans_a, trans_b;
+    int64_t a_stride, b_stride;
+    float alpha, beta;
+    int64_t bias_size;
+    Activation activation;
+};
+
+void Gemm(const GemmShape& shape, const float* a, const float* b, const float* bias, float* c);
+
+enum class UnaryOp : int { RELU = 0, SIGMOID = 1, TANH = 2, GELU = 3, GELU_TANH = 4, SILU = 5 };
+
+void Unary(UnaryOp op, const float* x, float* y, int64_t count);
+
+// c[count] = a op b。a_size/b_size为count、1（标量）或count的约数——较小的操作数是输出的尾部维度，
+// 沿前面的维度循环使用（即去掉前导1后为输出形状后缀的广播）
+enum class BinaryOp : int { ADD = 0, SUB = 1, MUL = 2, DIV = 3, MAX = 4, MIN = 5 };
+
+void Binary(BinaryOp op, const float* a, int64_t a_size, const float* b, int64_t b_size, float* c,
+            int64_t count);
+
+// 沿最后一维的Softmax/LogSoftmax，x与y为[rows, cols]
+void Softmax(const float* x, float* y, int64_t rows, int64_t cols, bool log_softmax);
+
+// 按行（cols个元素）的LayerNorm/RMSNorm（rms时忽略beta，beta可为nullptr）；gamma/beta为[cols]。
+// residual不为nullptr时先求x = x + residual（AddLayerNorm/AddRMSNorm），sum不为nullptr时写出x
+void LayerNorm(const float* x, const float* residual, const float* gamma, const float* beta, float* y,
+               float* sum, int64_t rows, int64_t cols, float epsilon, bool rms);
+
+// 二维卷积（NCHW，权重[out_c, in_c / group, kernel_h, kernel_w]），字段同Conv2DParams（conv_kernels.h）
+struct Conv2DShape {
+    int64_t batch;
+    int64_t in_c, in_h, in_w;
+    int64_t out_c, out_h, out_w;
+    int64_t kernel_h, kernel_w;
+    int64_t stride_h, stride_w;
+    int64_t pad_top, pad_left, pad_bottom, pad_right;
+    int64_t dilation_h, dilation_w;
+    int64_t group;
+};
+
+// 卷积所需工作区的float个数：一般路径为一组的im2col矩阵，1x1直连与深度卷积为0
+int64_t Conv2DWorkspaceSize(const Conv2DShape& shape);
+
+// bias为[out_c]或nullptr；workspace至少Conv2DWorkspaceSize(shape)个float
+void Conv2D(const Conv2DShape& shape, const float* x, const float* w, const float* bias, bool relu,
+            float* y, float* workspace);
+
+// 二维池化（NCHW），窗口越界部分不参与计算；平均池化count_include_pad时除数为窗口大小
+struct Pool2DShape {
+    int64_t batch, channels;
+    int64_t in_h, in_w;
+    int64_t out_h, out_w;
+    int64_t kernel_h, kernel_w;
+    int64_t stride_h, stride_w;
+    int64_t pad_top, pad_left;
+    bool count_include_pad;
+};
+
+void MaxPool2D(const Pool2DShape& shape, const float* x, float* y);
+void AveragePool2D(const Pool2DShape& shape, const float* x, float* y);
+
+// planes个连续的size元素平面各自求平均
+void GlobalAveragePool(const float* x, float* y, int64_t planes, int64_t size);
+
+// 沿某一轴拼接：输出分为outer块，每块依次是各输入的sizes[i]个连续元素。
+// 内存规划把输入直接放在输出中对应位置时（地址相同）跳过拷贝
+void Concat(const float* const* inputs, const int64_t* sizes, int64_t num_inputs, int64_t outer, float* y);
+
+// 地址相同时不拷贝
+void Copy(const float* x, float* y, int64_t count);
+
+} // namespace aot
+} // namespace inferunity
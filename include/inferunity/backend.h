@@ -3,6 +3,7 @@
 #include "types.h"
 #include "tensor.h"
 #include "operator.h"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -14,6 +15,10 @@ namespace inferunity {
 // 前向声明
 class Graph;
 class Node;
+struct SessionOptions;
+
+// 委托给编译型提供者执行的融合子图节点（见ExecutionProvider::CompileSubgraph）
+constexpr const char* kDelegatedSubgraphOp = "DelegatedSubgraph";
 
 // 设备接口
 class Device {
@@ -41,6 +46,23 @@ public:
     virtual void* CreateStream() = 0;
     virtual void DestroyStream(void* stream) = 0;
     virtual Status SynchronizeStream(void* stream) = 0;
+    
+    // 流池：并发的运行各自取用互不共享的流，用完归还；默认每次新建和销毁
+    virtual void* AcquireStream() { return CreateStream(); }
+    virtual void ReleaseStream(void* stream) { DestroyStream(stream); }
+    
+    // 事件 (参考CUDA event)：RecordEvent标记流上已入队的工作，StreamWaitEvent让另一条流等待这些工作完成，
+    // 不阻塞主机；默认实现对应按顺序同步执行的设备，事件为空操作
+    virtual void* CreateEvent() { return nullptr; }
+    virtual void DestroyEvent(void* event) { (void)event; }
+    virtual Status RecordEvent(void* event, void* stream) {
+        (void)event; (void)stream;
+        return Status::Ok();
+    }
+    virtual Status StreamWaitEvent(void* stream, void* event) {
+        (void)stream; (void)event;
+        return Status::Ok();
+    }
 };
 
 // 执行提供者接口 (参考ONNX Runtime的ExecutionProvider设计)
@@ -58,8 +80,21 @@ public:
     virtual std::shared_ptr<Device> GetDevice(int device_id = 0) = 0;
     virtual int GetDeviceCount() const = 0;
     
-    // 算子支持 (参考TensorFlow Lite的算子注册机制)
+    // 算子支持 (参考TensorFlow Lite的算子注册机制)；支持的集合在提供者的生命周期内不变
     virtual bool SupportsOperator(const std::string& op_type) const = 0;
+    // 按驻留ID查询（提供者分配等逐节点调用的路径）：结果按ID缓存在定长表中，
+    // 每个类型只调用一次SupportsOperator，之后是一次数组读取
+    bool SupportsOperatorId(OpTypeId op_type) const {
+        if (op_type >= kSupportTableSize) {
+            return SupportsOperator(GetOpTypeName(op_type));
+        }
+        uint8_t state = support_table_[op_type].load(std::memory_order_relaxed);
+        if (state == kSupportUnknown) {
+            state = SupportsOperator(GetOpTypeName(op_type)) ? kSupported : kUnsupported;
+            support_table_[op_type].store(state, std::memory_order_relaxed);
+        }
+        return state == kSupported;
+    }
     virtual std::unique_ptr<Operator> CreateOperator(const std::string& op_type) = 0;
     
     // 图优化 (参考TVM的图优化Pass)
@@ -72,12 +107,69 @@ public:
     // 执行节点
     virtual Status ExecuteNode(Node* node, ExecutionContext* ctx) = 0;
     
+    // 节点第output_index个输出所在的设备（如MemcpyFromDevice的输出在主机上）
+    virtual DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const {
+        (void)node; (void)output_index;
+        return GetDeviceType();
+    }
+    
+    // 设备与主机共享物理内存（移动SoC上的DSP/NPU，见DmaBufAllocator）：输出直接放在主机可访问的内存里，
+    // 图分区在它与CPU之间不插入拷贝节点，GetOutputDeviceType应返回DeviceType::CPU
+    virtual bool SharesHostMemory() const { return false; }
+    
+    // 使用调用方给出的输入输出张量执行节点，不读写Value上绑定的张量；
+    // 支持时同一节点可以在多个ExecutionState上并发执行（见SupportsConcurrentExecution）
+    virtual bool SupportsConcurrentExecution() const { return false; }
+    virtual Status ExecuteKernel(Node* node, const std::vector<Tensor*>& inputs,
+                                 const std::vector<Tensor*>& outputs, ExecutionContext* ctx) {
+        (void)node; (void)inputs; (void)outputs; (void)ctx;
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED);
+    }
+    
+    // 多流执行 (参考ONNX Runtime的多流执行计划)：支持时执行计划把相互独立的分支分配到设备的不同流上，
+    // ExecuteNode把工作入队到ExecutionContext::GetStream()给出的流，跨流依赖由运行时用设备事件表达
+    virtual bool SupportsMultiStream() const { return false; }
+    
+    // 整图捕获与重放 (参考ONNX Runtime的CUDA Graph支持)：CaptureBegin与CaptureEnd之间的ExecuteNode
+    // 只把工作记录进图，ReplayGraph一次提交全部记录的工作；重放之间各节点的输入输出地址必须保持不变
+    virtual bool IsGraphCaptureEnabled() const { return false; }
+    virtual bool IsGraphCaptured() const { return false; }
+    virtual Status CaptureBegin() { return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED); }
+    virtual Status CaptureEnd() { return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED); }
+    virtual Status ReplayGraph() { return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED); }
+    virtual void ResetGraph() {}
+    
+    // 子图委托 (参考ONNX Runtime编译型执行提供者的Compile)：原生提供者不支持的连通子图整体交给提供者编译，
+    // 图中以一个kDelegatedSubgraphOp节点代替；fused_node的输入输出依次对应subgraph的图输入输出，
+    // 之后ExecuteNode(fused_node)执行整个子图
+    virtual bool SupportsSubgraphCompilation() const { return false; }
+    virtual Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) {
+        (void)fused_node; (void)subgraph;
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED);
+    }
+    
+    // 优先认领 (参考ONNX Runtime TensorRT EP的GetCapability)：ClaimsSubgraphs为true的编译型提供者
+    // 在分区前认领CanCompileNode的连通子图（见DelegateClaimedSubgraphs），不论原生提供者是否支持
+    virtual bool ClaimsSubgraphs() const { return false; }
+    virtual bool CanCompileNode(const Node* node) const { (void)node; return false; }
+    
+    // 会话配置：提供者创建后由会话传入SessionOptions，读取精度、缓存目录等提供者相关的选项
+    virtual Status ConfigureSession(const SessionOptions& options) { (void)options; return Status::Ok(); }
+    
     // 量化支持
     virtual bool SupportsQuantization() const { return false; }
     virtual Status QuantizeModel(Graph* graph, DataType target_dtype) {
         (void)graph; (void)target_dtype;
         return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED);
     }
+
+private:
+    static constexpr size_t kSupportTableSize = 4096;
+    static constexpr uint8_t kSupportUnknown = 0;
+    static constexpr uint8_t kUnsupported = 1;
+    static constexpr uint8_t kSupported = 2;
+    // 并发查询同一未知类型时可能都调用一次SupportsOperator，结果相同
+    std::unique_ptr<std::atomic<uint8_t>[]> support_table_{new std::atomic<uint8_t>[kSupportTableSize]()};
 };
 
 // 为了向后兼容，保留Backend作为别名
@@ -127,7 +219,7 @@ public:
         }
         return providers;
     }
-    
+
 private:
     std::unordered_map<std::string, ProviderFactory> factories_;
 };
@@ -144,21 +236,21 @@ public:
         if (available_providers.empty()) {
             return nullptr;
         }
-        
+    
         // 策略1: 选择第一个支持该算子的提供者 (参考ONNX Runtime的默认策略)
         for (ExecutionProvider* provider : available_providers) {
-            if (provider->SupportsOperator(node->GetOpType())) {
+            if (provider->SupportsOperatorId(node->GetOpTypeId())) {
                 return provider;
             }
         }
-        
+    
         // 策略2: 回退到CPU提供者 (参考ONNX Runtime的fallback机制)
         for (ExecutionProvider* provider : available_providers) {
             if (provider->GetDeviceType() == DeviceType::CPU) {
                 return provider;
             }
         }
-        
+    
         // 策略3: 使用第一个可用提供者
         return available_providers[0];
     }
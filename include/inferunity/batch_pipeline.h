@@ -0,0 +1,105 @@
+#pragma once
+
+// 离线批量推理流水线 (参考tf.data的num_parallel_calls/prefetch与Spark的批量打分)
+// 读取 → 预处理 → 组批 → 推理 → 后处理 → 写出，阶段之间以有界队列相连，每个阶段有自己的线程：
+// 推理线程只从队列取已组好的批，不等待文件读取、解码与结果写出；下游较慢时队列写满，上游随之阻塞（背压），
+// 在途的记录数有上界。各阶段的忙碌、等待上游与等待下游的时间用于判断瓶颈与调整线程数
+
+#include "types.h"
+#include "tensor.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class InferenceSession;
+
+// 流过流水线的一条记录
+struct BatchRecord {
+    uint64_t index = 0;                                // 读取顺序的编号（由流水线分配）
+    std::string data;                                  // 读取阶段给出的原始数据（如一行文本或一个文件的内容）
+    std::shared_ptr<void> user_data;                   // 各阶段之间传递的其他数据
+    std::vector<std::shared_ptr<Tensor>> inputs;       // 预处理阶段给出，按图输入顺序，第0维为样本数（通常为1）
+    std::vector<std::shared_ptr<Tensor>> outputs;      // 推理后从批输出中按样本切出的视图
+    std::string result;                                // 后处理阶段给出，交给写出阶段
+    Status status;                                     // 失败的记录跳过之后的阶段，仍交给写出阶段
+};
+
+// 各阶段的回调；除reader外，阶段线程数大于1时回调会被并发调用
+struct BatchPipelineStages {
+    // 填写记录后返回true，没有更多记录时返回false
+    std::function<bool(BatchRecord* record)> reader;
+    // 把data解码成inputs；为空时要求reader直接给出inputs
+    std::function<Status(BatchRecord& record)> preprocess;
+    // 把outputs转换成result；为空时跳过
+    std::function<Status(BatchRecord& record)> postprocess;
+    // 写出一条记录（包括失败的记录，可据record.status区分）；返回错误时整个流水线停止
+    std::function<Status(BatchRecord& record)> writer;
+};
+
+struct BatchPipelineOptions {
+    size_t batch_size = 32;          // 每批最多的记录数
+    // 批中最早的记录等待超过该时长时不凑满也交给推理，上游较慢时推理不必空等；0表示总是凑满（读取结束时除外）
+    int64_t max_batch_delay_us = 10000;
+    size_t reader_threads = 1;       // 大于1时reader须线程安全
+    size_t preprocess_threads = 2;
+    size_t infer_threads = 1;        // 大于1时需要会话SupportsConcurrentRun()，否则按1处理
+    size_t postprocess_threads = 1;
+    size_t writer_threads = 1;
+    size_t queue_capacity = 0;       // 每个记录队列的容量，0表示4 * batch_size；批队列的容量为其除以batch_size（至少2）
+    bool preserve_order = false;     // 按读取顺序写出（写出阶段按1个线程处理）
+    bool stop_on_error = false;      // 记录失败时停止流水线并返回该错误；否则计入failed_records后继续
+};
+
+struct BatchPipelineStageStats {
+    std::string name;
+    size_t threads = 0;
+    uint64_t items = 0;              // 处理的记录数（组批与推理阶段为批数）
+    double busy_ms = 0.0;            // 各线程执行回调（组批与推理阶段为拼接与Run）的时间之和
+    double input_wait_ms = 0.0;      // 等待上游的时间之和：偏大说明上游是瓶颈
+    double output_wait_ms = 0.0;     // 下游队列已满而阻塞的时间之和：偏大说明下游是瓶颈
+    double utilization = 0.0;        // busy_ms / (threads * wall_ms)
+};
+
+struct BatchPipelineStats {
+    std::vector<BatchPipelineStageStats> stages;  // 按流水线顺序
+    uint64_t records = 0;
+    uint64_t batches = 0;
+    uint64_t failed_records = 0;
+    double wall_ms = 0.0;
+
+    // 每个阶段一行的表格，最后一行指出利用率最高的阶段
+    std::string ToString() const;
+};
+
+class BatchInferencePipeline {
+public:
+    BatchInferencePipeline(InferenceSession* session, BatchPipelineStages stages,
+                           const BatchPipelineOptions& options = BatchPipelineOptions());
+
+    BatchInferencePipeline(const BatchInferencePipeline&) = delete;
+    BatchInferencePipeline& operator=(const BatchInferencePipeline&) = delete;
+
+    // 运行到reader返回false且所有记录写出后返回；stats不为空时填写本次运行的统计
+    Status Run(BatchPipelineStats* stats = nullptr);
+
+    // 从其他线程停止正在进行的Run：各阶段处理完手上的记录后退出，Run返回ERROR_CANCELLED
+    void Cancel();
+
+    const BatchPipelineOptions& GetOptions() const { return options_; }
+
+private:
+    struct RunState;
+
+    InferenceSession* session_;
+    BatchPipelineStages stages_;
+    BatchPipelineOptions options_;
+    std::mutex mutex_;
+    RunState* running_ = nullptr;  // 进行中的运行，供Cancel使用
+};
+
+} // namespace inferunity
@@ -0,0 +1,156 @@
+#pragma once
+
+// 动态批处理 (参考Triton Inference Server的dynamic_batching与TF Serving的BatchingSession)
+// 多个线程各自提交单个请求，后台线程把输入形状兼容的请求沿第0维拼成一批，
+// 凑满max_batch_size个样本或最早的请求等满max_delay_us后执行一次Run，再把输出按样本拆回各请求的future。
+// 变长序列（NLP请求）可按长度分桶补齐或首尾拼接后成批（见SequenceBatchingOptions）；
+// 选用不同LoRA适配器的请求可以合成一批（见RunOptions::lora_adapters）
+
+#include "types.h"
+#include "tensor.h"
+#include "metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace inferunity {
+
+class InferenceSession;
+
+// 变长序列的成批方式 (参考TF Serving的pad_variable_length_inputs与BERT推理中的序列打包/变长注意力)
+enum class SequenceBatchingMode {
+    NONE,    // 只合并除第0维外形状完全相同的请求
+    // 序列长度向上取到所在的桶，同一桶的请求补齐到桶长后合并，输出按各请求的原长度截回；
+    // 形状只有桶数种，会话为每个（桶, 批大小）保留一个形状特化计划
+    BUCKET,
+    // 各序列沿序列轴首尾相接成[1, 总token数, ...]，另外生成每个token的段号（与段内位置）输入，
+    // 模型据此只在段内做注意力，不计算任何补齐；token输出按段切回[样本数, 原长度, ...]
+    PACKED
+};
+
+struct SequenceBatchingOptions {
+    SequenceBatchingMode mode = SequenceBatchingMode::NONE;
+    int sequence_axis = 1;                // 输入输出中的序列轴，不能是第0维；PACKED要求为1
+    std::vector<int64_t> buckets;         // BUCKET：升序的桶长；超过最大桶的请求按原长度成批
+    // 带序列轴的输入（请求输入的下标），各请求中这些输入的序列长度须相同；为空表示秩大于sequence_axis的全部输入
+    std::vector<size_t> sequence_inputs;
+    std::vector<double> pad_values;       // BUCKET：各请求输入的补齐值（如token的pad id，mask为0），缺省为0
+    // PACKED：接收段号（INT64 [1, 总token数]，第i条序列的token为i）与段内位置（INT64，每段从0开始）的图输入下标；
+    // 请求只给出其余的图输入（按图输入顺序）。segment_ids_input必填，position_ids_input为-1表示不生成
+    int segment_ids_input = -1;
+    int position_ids_input = -1;
+    int64_t max_batch_tokens = 0;         // PACKED：每批token数上限，0表示只受max_batch_size限制
+};
+
+struct DynamicBatcherOptions {
+    int max_batch_size = 0;           // 每批最多的样本数（第0维之和），0表示使用SessionOptions::max_batch_size
+    int64_t max_delay_us = 1000;      // 最早的请求入队后最多等待的时间
+    int64_t default_timeout_us = 0;   // 请求从入队到开始执行的时限，0表示不超时
+    size_t max_queue_size = 0;        // 排队请求上限，超过时直接拒绝，0表示不限制
+    SequenceBatchingOptions sequence;
+};
+
+struct BatchResult {
+    Status status;
+    std::vector<std::shared_ptr<Tensor>> outputs;  // 本请求的输出，第0维为提交时的样本数
+};
+
+struct DynamicBatcherStats {
+    Histogram batch_size;       // 每批的请求数
+    Histogram queue_time_us;    // 请求从入队到开始执行的等待时间
+    uint64_t num_batches = 0;
+    uint64_t num_requests = 0;  // 已执行的请求数
+    uint64_t num_timeouts = 0;  // 超时未执行的请求数
+    uint64_t num_rejected = 0;  // 因队列已满或已停止而拒绝的请求数
+    // 变长序列：请求本身的token数与实际计算的token数（含补齐），两者之比为补齐的浪费
+    uint64_t sequence_tokens = 0;
+    uint64_t computed_tokens = 0;
+};
+
+class DynamicBatcher {
+public:
+    // 批处理器通过线程安全的Run(inputs, shared_ptr outputs)执行，session仍可被其他线程直接使用
+    explicit DynamicBatcher(InferenceSession* session,
+                            const DynamicBatcherOptions& options = DynamicBatcherOptions());
+    ~DynamicBatcher();
+    
+    DynamicBatcher(const DynamicBatcher&) = delete;
+    DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+    
+    // 提交一个请求（按图输入顺序，第0维为样本数）；timeout_us < 0使用default_timeout_us。
+    // lora_adapter为请求的各样本选用的LoRA适配器（会话需enable_lora），空字符串表示基座；PACKED模式不支持
+    std::future<BatchResult> Submit(std::vector<std::shared_ptr<Tensor>> inputs, int64_t timeout_us = -1,
+                                    const std::string& lora_adapter = "");
+    // 同上，结果交给callback而不经过future（事件循环不能阻塞等待）：执行或超时后在调度线程上调用，
+    // 未受理时在调用线程上立即调用；callback应尽快返回，不能在其中提交新的请求
+    using BatchCallback = std::function<void(BatchResult result)>;
+    void Submit(std::vector<std::shared_ptr<Tensor>> inputs, BatchCallback callback, int64_t timeout_us = -1,
+                const std::string& lora_adapter = "");
+    
+    // 停止后台线程，尚未执行的请求以ERROR_RUNTIME_ERROR返回
+    void Stop();
+    
+    DynamicBatcherStats GetStats() const;
+    const DynamicBatcherOptions& GetOptions() const { return options_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    struct Request {
+        std::vector<std::shared_ptr<Tensor>> inputs;
+        int64_t rows = 0;
+        int64_t length = 0;   // 序列长度，不按序列成批时为0
+        int64_t bucket = 0;   // BUCKET：补齐后的长度
+        std::string lora_adapter;
+        Clock::time_point enqueue_time;
+        Clock::time_point deadline;  // time_point::max()表示不超时
+        std::promise<BatchResult> promise;
+        BatchCallback callback;      // 非空时结果交给它，promise不使用
+    };
+    
+    // callback非空时受理成功返回无效的future
+    std::future<BatchResult> Enqueue(std::vector<std::shared_ptr<Tensor>> inputs, int64_t timeout_us,
+                                     const std::string& lora_adapter, BatchCallback callback);
+    static void Complete(Request& request, BatchResult result);
+    
+    // 请求输入中带序列轴的下标
+    bool IsSequenceInput(const std::vector<std::shared_ptr<Tensor>>& inputs, size_t index) const;
+    // 两个请求能否合并为一批
+    bool Compatible(const Request& a, const Request& b) const;
+    // 组装批输入（按图输入顺序）与拆分输出；失败时返回错误，调用方负责让请求失败
+    Status MergeInputs(const std::vector<std::unique_ptr<Request>>& batch,
+                       std::vector<std::shared_ptr<Tensor>>* merged);
+    Status SplitOutputs(const std::vector<std::unique_ptr<Request>>& batch,
+                        const std::vector<std::shared_ptr<Tensor>>& outputs, std::vector<BatchResult>* results);
+    
+    void WorkerLoop();
+    // 从队首起收集与队首输入兼容的请求；调用时持有锁
+    std::vector<std::unique_ptr<Request>> TakeBatch();
+    // 丢弃已超时的请求；调用时持有锁
+    void ExpireRequests(Clock::time_point now);
+    void ExecuteBatch(std::vector<std::unique_ptr<Request>>& batch);
+    
+    InferenceSession* session_;
+    DynamicBatcherOptions options_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<Request>> queue_;
+    int64_t queued_rows_ = 0;
+    bool stop_ = false;
+    DynamicBatcherStats stats_;
+    // 注册表中的会话指标（inferunity_batcher_*，标签为会话ID）
+    std::shared_ptr<ShardedHistogram> batch_size_metric_;
+    std::shared_ptr<ShardedHistogram> queue_wait_metric_;
+    std::thread worker_;
+};
+
+} // namespace inferunity
@@ -0,0 +1,66 @@
+#pragma once
+
+// 张量并行与流水线并行的通信（参考NCCL的ncclAllReduce/ncclAllGather/ncclSend与Megatron-LM）：
+// 一个通信组由world_size个rank组成，每个rank是一个独立的会话（通常各占一块设备），
+// 图中的AllReduce/AllGather节点按rank调用组内的集合操作，所有rank以相同的顺序到达同一组集合操作。
+// 默认实现在进程内经由主机内存交换数据；设备类型可以注册自己的实现（如CUDA上的NCCL）
+
+#include "types.h"
+#include "tensor.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace inferunity {
+
+class CollectiveGroup {
+public:
+    virtual ~CollectiveGroup() = default;
+
+    int GetWorldSize() const { return world_size_; }
+    // 图中的AllReduce/AllGather节点以group_id属性引用通信组（见Find）
+    int64_t GetId() const { return id_; }
+    // rank对应的设备编号
+    const std::vector<int>& GetDeviceIds() const { return device_ids_; }
+
+    // 各rank的input逐元素求和，结果写入各自的output（与input形状相同）。
+    // tag用于校验各rank到达的是同一个集合操作；stream为设备流（主机实现忽略）
+    virtual Status AllReduceSum(int rank, int64_t tag, const Tensor& input, Tensor* output,
+                                void* stream = nullptr) = 0;
+    // 各rank的input沿axis按rank顺序拼接，output在axis上是input的world_size倍
+    virtual Status AllGather(int rank, int64_t tag, const Tensor& input, int64_t axis, Tensor* output,
+                             void* stream = nullptr) = 0;
+
+    // 点对点传输（流水线并行的阶段间传递，参考ncclSend/ncclRecv）：rank把input发给peer，peer以相同的tag
+    // 收进同样大小的output，同一对rank之间的消息按发送顺序到达。主机实现在Send时拷贝一份后立即返回，
+    // Recv阻塞到消息到达；stream为nullptr时设备实现在返回前等待传输完成
+    virtual Status Send(int rank, int peer, int64_t tag, const Tensor& input, void* stream = nullptr) = 0;
+    virtual Status Recv(int rank, int peer, int64_t tag, Tensor* output, void* stream = nullptr) = 0;
+
+    // 某个rank出错时中止：正在等待与之后进入集合操作的rank立即返回错误，直到Reset
+    virtual void Abort() = 0;
+    // 所有rank都已退出集合操作后恢复可用
+    virtual void Reset() = 0;
+
+    // 创建设备类型为device_type、各rank在device_ids上的通信组；没有注册该设备类型的实现时
+    // 使用主机实现（要求张量在主机内存中）
+    static std::shared_ptr<CollectiveGroup> Create(DeviceType device_type, const std::vector<int>& device_ids);
+    // 按编号查找仍然存活的通信组，不存在时返回nullptr
+    static std::shared_ptr<CollectiveGroup> Find(int64_t id);
+
+protected:
+    explicit CollectiveGroup(const std::vector<int>& device_ids);
+
+private:
+    int world_size_;
+    int64_t id_;
+    std::vector<int> device_ids_;
+};
+
+// 设备类型的通信组实现（如CUDA上的NCCL），返回nullptr表示不可用、回退到主机实现
+using CollectiveGroupFactory =
+    std::function<std::shared_ptr<CollectiveGroup>(const std::vector<int>& device_ids)>;
+void SetCollectiveGroupFactory(DeviceType device_type, CollectiveGroupFactory factory);
+
+} // namespace inferunity
@@ -0,0 +1,135 @@
+#pragma once
+
+// 迭代级（连续）批处理调度 (参考Orca的iteration-level scheduling与vLLM的Scheduler/chunked prefill)：
+// 以解码步而不是请求为调度单位，每一步结束后已完成的序列立即退出、释放KV块，排队的请求立即加入，
+// 不必等一批中最长的序列生成完。每步在token预算内先为运行中的序列安排解码token（或剩余prompt的
+// prefill分块），再用剩余预算接纳新请求的prefill分块；各序列本步的token首尾相接打包，不做填充，
+// 由模型的step函数配合attention::PagedAttentionPacked在分页KV cache上执行。
+// cache启用前缀缓存时，新请求（及被换出后重新计算的序列）复用已缓存的前缀块，只prefill其余部分。
+// cache有交换区（PagedKVCacheOptions::max_swap_blocks）时，被抢占的序列优先把KV块换出到交换区，
+// 块池有空间时先于新请求换回，从原来的位置继续解码；交换区放不下时才退回重新计算
+
+#include "types.h"
+#include "kv_cache.h"
+#include "metrics.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace inferunity {
+
+struct ContinuousBatchingOptions {
+    int64_t max_num_tokens = 512;     // 每步的token预算（prefill分块与解码token之和）
+    int64_t max_num_sequences = 64;   // 同时运行的序列数
+    int64_t max_prefill_chunk = 0;    // 单个序列每步最多prefill的token数，0表示只受预算限制
+};
+
+struct GenerationRequest {
+    int64_t id = 0;                   // 请求编号，同时作为KV cache中的序列编号
+    std::vector<int32_t> prompt;
+    int64_t max_new_tokens = 16;
+    int32_t eos_token = -1;           // 生成该token后结束，< 0表示不检查
+};
+
+struct GenerationResult {
+    int64_t id = 0;
+    Status status;                    // 被取消的请求为ERROR_RUNTIME_ERROR
+    std::vector<int32_t> tokens;      // 生成的token（不含prompt）
+};
+
+// 一步的打包输入：第b个序列本步的token为tokens[query_offsets[b], query_offsets[b + 1])，
+// 其绝对位置（RoPE的位置、KV cache中的槽位）为positions中对应的元素。
+// 调度器已为这些位置调用过PagedKVCache::AppendSlots
+struct ScheduledBatch {
+    std::vector<int64_t> sequences;
+    std::vector<int64_t> query_offsets;  // sequences.size() + 1个元素
+    std::vector<int32_t> tokens;
+    std::vector<int64_t> positions;
+    // 本步之后该序列的全部已知token都已进入KV cache，需要在其最后一个位置采样下一个token；
+    // 为false的是尚未完成的prefill分块
+    std::vector<bool> sample;
+    
+    size_t GetNumTokens() const { return tokens.size(); }
+};
+
+struct ContinuousBatchingStats {
+    Histogram tokens_per_step;        // 每步打包的token数
+    Histogram sequences_per_step;     // 每步的序列数
+    uint64_t num_steps = 0;
+    uint64_t num_prefill_tokens = 0;
+    uint64_t num_decode_tokens = 0;
+    uint64_t num_finished = 0;
+    uint64_t num_preemptions = 0;     // KV块不足时被换出、之后重新计算的次数
+    uint64_t num_swap_outs = 0;       // KV块不足时换出到交换区、之后换回继续的次数
+    uint64_t num_swap_ins = 0;
+};
+
+class ContinuousBatchScheduler {
+public:
+    // 执行一步：按batch运行模型，为每个序列写出一个采样的token（sample为false的位置被忽略）
+    using StepFunction = std::function<Status(const ScheduledBatch& batch, std::vector<int32_t>* sampled)>;
+    
+    // cache须已添加各层；调度器独占管理其中的序列
+    ContinuousBatchScheduler(PagedKVCache* cache,
+                             const ContinuousBatchingOptions& options = ContinuousBatchingOptions());
+    
+    ContinuousBatchScheduler(const ContinuousBatchScheduler&) = delete;
+    ContinuousBatchScheduler& operator=(const ContinuousBatchScheduler&) = delete;
+    
+    // 提交与取消可以在其他线程进行，在下一次Schedule时生效
+    Status AddRequest(const GenerationRequest& request);
+    void AbortRequest(int64_t id);
+    bool HasPendingRequests() const;
+    
+    // 安排下一步并为其预留KV槽位；没有可运行的序列时batch为空。
+    // 块不足时按后到先出换出运行中的序列（换出到交换区，或释放其块、之后连同已生成的token重新prefill）；
+    // 返回时本步换入的块已经就绪
+    Status Schedule(ScheduledBatch* batch, std::vector<GenerationResult>* finished);
+    // 提交step的结果：推进各序列，已完成的序列退出并释放KV块，结果追加到finished
+    Status Update(const ScheduledBatch& batch, const std::vector<int32_t>& sampled,
+                  std::vector<GenerationResult>* finished);
+    // step失败时撤销Schedule预留的槽位，序列保持调度前的状态
+    void Rollback(const ScheduledBatch& batch);
+    
+    // Schedule + step + Update
+    Status Step(const StepFunction& step, std::vector<GenerationResult>* finished);
+    
+    ContinuousBatchingStats GetStats() const;
+    const ContinuousBatchingOptions& GetOptions() const { return options_; }
+
+private:
+    struct Sequence {
+        GenerationRequest request;
+        std::vector<int32_t> tokens;   // prompt + 已生成的token
+        int64_t num_computed = 0;      // 已进入KV cache的token数
+        size_t num_generated = 0;
+    };
+    
+    // 以下调用时持有锁
+    // 本步为seq安排的token数：剩余的已知token，受预算与prefill分块上限约束
+    int64_t ChunkSize(const Sequence& seq, int64_t budget) const;
+    void AddToBatch(const Sequence& seq, int64_t tokens, ScheduledBatch* batch);
+    // 把seq的KV块换出到交换区并放入换出队列队首；交换区不足时释放其块并放回等待队列队首，之后从头重新计算
+    void Preempt(std::unique_ptr<Sequence> seq);
+    // 按换出的先后换回序列并安排其下一段token，块不足时停止；返回是否换入了序列
+    bool SwapInSequences(int64_t* budget, ScheduledBatch* batch);
+    // 输出结果；seq已不在KV cache中
+    void Finish(std::unique_ptr<Sequence> seq, Status status, std::vector<GenerationResult>* finished);
+    void DrainAborted(std::vector<GenerationResult>* finished);
+    
+    PagedKVCache* cache_;
+    ContinuousBatchingOptions options_;
+    
+    mutable std::mutex mutex_;
+    std::deque<std::unique_ptr<Sequence>> waiting_;
+    std::deque<std::unique_ptr<Sequence>> swapped_;   // 已换出到交换区，保留已计算的位置
+    std::vector<std::unique_ptr<Sequence>> running_;  // 按加入的先后排列
+    std::unordered_set<int64_t> aborted_;
+    ContinuousBatchingStats stats_;
+};
+
+} // namespace inferunity
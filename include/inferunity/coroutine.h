@@ -0,0 +1,72 @@
+#pragma once
+
+// C++20协程接口：co_await session->RunCoro(inputs, executor)
+// 建立在回调式RunAsync之上（见engine.h）：推理在运行时线程池上执行，完成后把协程的恢复投递给调用方的executor，
+// 不需要额外的线程等待future.get()。库本身按C++17编译，本头文件只在C++20翻译单元中提供协程接口
+
+#include "engine.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define INFERUNITY_HAS_COROUTINES 1
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace inferunity {
+
+// 在完成推理的线程池线程上直接恢复协程
+struct InlineExecutor {
+    void operator()(std::function<void()> fn) const { fn(); }
+};
+
+// executor为可调用对象executor(std::function<void()>)：把恢复操作投递到调用方的事件循环或线程池。
+// 未受理的请求（如在途运行已满）不挂起，co_await直接返回带错误的结果
+template <typename Executor>
+class RunAwaitable {
+public:
+    RunAwaitable(InferenceSession* session, std::vector<std::shared_ptr<Tensor>> inputs, Executor executor)
+        : session_(session), inputs_(std::move(inputs)), executor_(std::move(executor)) {}
+    
+    bool await_ready() const noexcept { return false; }
+    
+    bool await_suspend(std::coroutine_handle<> handle) {
+        // 回调可能在RunAsync返回前于其他线程恢复协程，之后不能再访问成员
+        Status status = session_->RunAsync(std::move(inputs_),
+            [this, handle](Status run_status, std::vector<std::shared_ptr<Tensor>> outputs) {
+                result_.status = run_status;
+                result_.outputs = std::move(outputs);
+                // 协程恢复后本对象随之销毁，投递时使用executor的副本
+                Executor executor = executor_;
+                executor([handle]() { handle.resume(); });
+            });
+        if (!status.IsOk()) {
+            result_.status = status;
+            return false;
+        }
+        return true;
+    }
+    
+    RunResult await_resume() { return std::move(result_); }
+
+private:
+    InferenceSession* session_;
+    std::vector<std::shared_ptr<Tensor>> inputs_;
+    Executor executor_;
+    RunResult result_;
+};
+
+template <typename Executor>
+auto InferenceSession::RunCoro(std::vector<std::shared_ptr<Tensor>> inputs, Executor executor) {
+    return RunAwaitable<Executor>(this, std::move(inputs), std::move(executor));
+}
+
+inline auto InferenceSession::RunCoro(std::vector<std::shared_ptr<Tensor>> inputs) {
+    return RunCoro(std::move(inputs), InlineExecutor());
+}
+
+} // namespace inferunity
+
+#endif
@@ -0,0 +1,40 @@
+// CPU特性检测
+// 参考ONNX Runtime的CPUIDInfo：进程内只检测一次，SIMD核与GEMM微内核据此在运行时选择实现
+
+#pragma once
+
+namespace inferunity {
+
+struct CpuFeatures {
+    // x86（同时要求CPU支持和操作系统保存对应寄存器状态）
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512_vnni = false;
+    bool avx512_bf16 = false;
+    bool amx_tile = false;     // Linux上还需要向内核申请了AMX tile数据状态的使用权限
+    bool amx_int8 = false;
+    bool amx_bf16 = false;
+    bool hybrid = false;       // 混合架构（CPUID.07H:EDX[15]，如Alder Lake的P/E核）
+    // ARM
+    bool neon = false;
+    bool neon_dotprod = false;  // SDOT/UDOT (ARMv8.2 dotprod)
+    bool neon_fp16 = false;     // 半精度向量运算 (ARMv8.2 FP16)
+    bool sve = false;
+    // WebAssembly（SIMD128是编译期特性：不支持的引擎拒绝加载整个模块）
+    bool wasm_simd128 = false;
+};
+
+// 检测结果（首次调用时通过CPUID/getauxval检测，之后直接返回缓存）
+const CpuFeatures& GetCpuFeatures();
+
+// 调用线程当前所在核的类型（CPUID.1AH:EAX[31:24]）：0x40为性能核，0x20为能效核；
+// 非混合架构或非x86返回0。结果只对执行CPUID时所在的核有效，调用方应先把线程固定到该核
+int GetCurrentHybridCoreType();
+
+} // namespace inferunity
@@ -5,11 +5,57 @@
 
 #ifdef ENABLE_CUDA
 #include "backend.h"
+#include "memory.h"
+#include "data_transfer.h"
 #include <cuda_runtime.h>
+#include <cublasLt.h>
+#include <cudnn.h>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace inferunity {
 
+class KernelTuningCache;
+
+// 每个GPU一个缓存分配器，由该设备上的所有CUDADevice与张量共享
+std::shared_ptr<CachingDeviceAllocator> GetCUDACachingAllocator(int device_id);
+
+// 锁页主机内存的暂存缓冲池 (参考PyTorch的CachingHostAllocator)：cudaHostAlloc分配并按块缓存，
+// 块在其上记录的拷贝流事件完成之后才会被再次分配，主机不会覆盖仍在传输中的数据
+std::shared_ptr<CachingDeviceAllocator> GetCUDAPinnedAllocator();
+
+// 主机与GPU之间的数据传输：上传与下载各用一条专用的拷贝流，与计算流以及彼此之间并行；
+// 可分页内存经锁页暂存缓冲中转，这样cudaMemcpyAsync才真正异步
+class CUDADataTransfer : public DataTransfer {
+public:
+    explicit CUDADataTransfer(int device_id);
+    ~CUDADataTransfer() override;
+    
+    Status CopyHostToDevice(void* dst, const void* src, size_t size) override;
+    Status CopyDeviceToHost(void* dst, const void* src, size_t size) override;
+    Status CopyDeviceToDevice(void* dst, const void* src, size_t size) override;
+    
+    Status CopyHostToDeviceAsync(void* dst, const void* src, size_t size, void* stream,
+                                 std::shared_ptr<TransferEvent>* event) override;
+    Status CopyDeviceToHostAsync(void* dst, const void* src, size_t size, void* stream,
+                                 std::shared_ptr<TransferEvent>* event) override;
+
+private:
+    // 拷贝流先等待stream上已入队的工作
+    Status WaitForStream(cudaStream_t copy_stream, void* stream);
+    Status RecordTransferEvent(cudaStream_t copy_stream, std::shared_ptr<TransferEvent>* event);
+    
+    int device_id_;
+    cudaStream_t upload_stream_ = nullptr;
+    cudaStream_t download_stream_ = nullptr;
+    std::shared_ptr<CachingDeviceAllocator> pinned_;
+};
+
+// 每个GPU一个数据传输，拷贝流由该设备上的所有会话共享
+std::shared_ptr<CUDADataTransfer> GetCUDADataTransfer(int device_id);
+
 // CUDA设备实现
 class CUDADevice : public Device {
 public:
@@ -38,11 +84,64 @@ public:
     void DestroyStream(void* stream) override;
     Status SynchronizeStream(void* stream) override;
     
+    // 流池按设备共享：多流运行取出的流归还后留给后续运行复用，不反复创建
+    void* AcquireStream() override;
+    void ReleaseStream(void* stream) override;
+    
+    // 跨流依赖
+    void* CreateEvent() override;
+    void DestroyEvent(void* event) override;
+    Status RecordEvent(void* event, void* stream) override;
+    Status StreamWaitEvent(void* stream, void* event) override;
+    
+    const std::shared_ptr<CachingDeviceAllocator>& GetAllocator() const { return allocator_; }
+    // 算子与拷贝使用的流，CUDA Graph在该流上捕获
+    cudaStream_t GetStream() const { return default_stream_; }
+    
+    // 在指定流上拷贝，stream为nullptr时使用默认流
+    Status CopyOnStream(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream);
+    bool IsCapturing(cudaStream_t stream) const;
+
 private:
+    // 流处于捕获状态时不能同步，拷贝只入队
+    Status SynchronizeUnlessCapturing(cudaStream_t stream);
+    
     int device_id_;
+    std::shared_ptr<CachingDeviceAllocator> allocator_;
     cudaStream_t default_stream_;
 };
 
+// 编译节点时按静态形状创建并自动调优的GPU kernel（cuBLASLt GEMM、cuDNN卷积）
+class CUDAKernel {
+public:
+    virtual ~CUDAKernel() = default;
+    
+    // 运行时输入形状与编译时一致
+    virtual bool Matches(const std::vector<Tensor*>& inputs) const = 0;
+    virtual Status Compute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                           cudaStream_t stream) = 0;
+};
+
+struct CUDAKernelContext {
+    std::string device_name;  // GPU型号，调优缓存键的一部分
+    cublasLtHandle_t cublaslt = nullptr;
+    cudnnHandle_t cudnn = nullptr;
+    CachingDeviceAllocator* allocator = nullptr;
+    KernelTuningCache* tuning_cache = nullptr;
+    size_t max_workspace_bytes = 64 << 20;
+    std::string codegen_cache_dir;  // NVRTC生成的PTX的磁盘缓存，为空时只在进程内复用
+};
+
+// MatMul/FusedMatMulAdd使用cuBLASLt，Conv/FusedConvReLU使用cuDNN，FusedElementwise使用NVRTC生成的kernel；
+// 节点或形状不适用（动态维度、非对称padding等）时*kernel为nullptr，节点走通用算子路径
+Status CreateCUDAKernel(const Node* node, const std::vector<Shape>& input_shapes, DataType dtype,
+                        const CUDAKernelContext& context, std::unique_ptr<CUDAKernel>* kernel);
+
+// 逐元素融合的代码生成（见cuda_codegen.cpp）：把FusedElementwise的整条链生成为一个kernel，
+// 广播方式按静态形状写进代码；未启用NVRTC或链中有不支持的步骤时*kernel为nullptr
+Status CreateCUDAFusedElementwiseKernel(const Node* node, const std::vector<Shape>& input_shapes, DataType dtype,
+                                        const CUDAKernelContext& context, std::unique_ptr<CUDAKernel>* kernel);
+
 // CUDA执行提供者
 class CUDAExecutionProvider : public ExecutionProvider {
 public:
@@ -53,6 +152,8 @@ public:
     std::string GetName() const override { return "CUDAExecutionProvider"; }
     DeviceType GetDeviceType() const override { return DeviceType::CUDA; }
     bool IsAvailable() const override;
+    // 会话的device_id与构造时不同时改用该GPU（张量并行的各rank各占一块）
+    Status ConfigureSession(const SessionOptions& options) override;
     
     // 设备管理
     std::shared_ptr<Device> GetDevice(int device_id = 0) override;
@@ -72,12 +173,39 @@ public:
     // 执行节点
     Status ExecuteNode(Node* node, ExecutionContext* ctx) override;
     
+    // MemcpyFromDevice的输出在主机上
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override;
+    
+    // CUDA Graph：在设备的默认流上捕获整个执行计划，之后用cudaGraphLaunch重放
+    bool IsGraphCaptureEnabled() const override { return device_ != nullptr; }
+    bool IsGraphCaptured() const override { return graph_exec_ != nullptr; }
+    Status CaptureBegin() override;
+    Status CaptureEnd() override;
+    Status ReplayGraph() override;
+    void ResetGraph() override;
+    
+    // 多流执行：算子与拷贝入队到ExecutionContext给出的流
+    bool SupportsMultiStream() const override { return device_ != nullptr; }
+
 private:
     int device_id_;
     std::shared_ptr<CUDADevice> device_;
+    cudaGraph_t graph_ = nullptr;
+    cudaGraphExec_t graph_exec_ = nullptr;
+    cublasLtHandle_t cublaslt_ = nullptr;
+    cudnnHandle_t cudnn_ = nullptr;
+    std::string codegen_cache_dir_;
+    std::unordered_map<const Node*, std::unique_ptr<CUDAKernel>> kernels_;
+    
+    CUDAKernelContext GetKernelContext() const;
+    // 按给定的输入形状（重新）创建节点的kernel
+    Status BuildKernel(const Node* node, const std::vector<Shape>& input_shapes);
     
     // 检查CUDA是否可用
     static bool CheckCUDAAvailable();
+    
+    // 分区边界上的主机与设备间拷贝
+    Status ExecuteMemcpy(Node* node, ExecutionContext* ctx);
 };
 
 } // namespace inferunity
@@ -0,0 +1,54 @@
+#pragma once
+
+// 主机与设备之间的数据传输 (参考ONNX Runtime的IDataTransfer/DataTransferManager)：
+// 执行提供者为自己的设备类型注册数据传输，Tensor::CopyTo/CopyFrom经由它跨设备搬运数据。
+// 异步版本把拷贝入队到设备专用的拷贝流后立即返回完成事件，前后请求的上传、计算与下载可以彼此重叠
+
+#include "types.h"
+#include <memory>
+
+namespace inferunity {
+
+// 异步拷贝的完成事件
+class TransferEvent {
+public:
+    virtual ~TransferEvent() = default;
+    
+    // 非阻塞查询
+    virtual bool IsComplete() = 0;
+    // 阻塞直到拷贝完成，返回拷贝的结果
+    virtual Status Wait() = 0;
+    // 让设备流上之后入队的工作等待拷贝完成，不阻塞主机；默认在主机上等待
+    virtual Status WaitOnStream(void* stream) {
+        (void)stream;
+        return Wait();
+    }
+};
+
+// 已经完成的事件（同步完成的拷贝）
+std::shared_ptr<TransferEvent> MakeCompletedTransferEvent(Status status = Status::Ok());
+
+class DataTransfer {
+public:
+    virtual ~DataTransfer() = default;
+    
+    // 同步拷贝：返回时数据已经可用
+    virtual Status CopyHostToDevice(void* dst, const void* src, size_t size) = 0;
+    virtual Status CopyDeviceToHost(void* dst, const void* src, size_t size) = 0;
+    virtual Status CopyDeviceToDevice(void* dst, const void* src, size_t size) = 0;
+    
+    // 异步拷贝：在stream（为nullptr时不依赖任何流）上已入队的工作完成之后开始。
+    // 上传返回后src即可复用（需要时先暂存到锁页缓冲），dst在事件完成前不能读取；
+    // 下载的dst在事件完成前必须保持有效。默认实现同步拷贝并返回已完成的事件
+    virtual Status CopyHostToDeviceAsync(void* dst, const void* src, size_t size, void* stream,
+                                         std::shared_ptr<TransferEvent>* event);
+    virtual Status CopyDeviceToHostAsync(void* dst, const void* src, size_t size, void* stream,
+                                         std::shared_ptr<TransferEvent>* event);
+};
+
+// 注册设备类型的数据传输，传入nullptr取消注册
+void SetDataTransfer(DeviceType device, std::shared_ptr<DataTransfer> transfer);
+// 未注册时返回nullptr
+std::shared_ptr<DataTransfer> GetDataTransfer(DeviceType device);
+
+} // namespace inferunity
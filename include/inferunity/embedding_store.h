@@ -0,0 +1,86 @@
+#pragma once
+
+// 分层存储的大嵌入表（参考Meta的推荐模型SSD嵌入缓存与Caffeine的W-TinyLFU）：表放在SSD上的文件里，
+// 内存中只保留容量固定的热点行。一批下标先去重，每个不同的行只查一次；命中的行从内存复制，
+// 未命中的行按行号排序后把相邻的行合并成一次连续读，各段用pread在线程池上并行读盘。
+// 读入的行经TinyLFU准入：缓存满时只有访问频率（计数最小草图估计）高于最久未用行的新行才替换它，
+// 一次性的冷门id不会冲掉热点行。计数每累计约10倍容量次访问后减半，频率随时间衰减
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+struct EmbeddingStoreOptions {
+    int64_t cache_rows = 0;                          // 内存中热点行的容量，0表示不缓存（每次都读盘）
+    size_t max_read_bytes = size_t(1) << 20;         // 合并相邻行时单次读的字节上限
+};
+
+struct EmbeddingStoreStats {
+    uint64_t lookups = 0;       // 查找的下标数（含重复）
+    uint64_t unique_rows = 0;   // 去重后的行数
+    uint64_t hits = 0;          // 去重后命中内存的行
+    uint64_t misses = 0;        // 去重后读盘的行
+    uint64_t admissions = 0;    // 读入后进入缓存的行
+    uint64_t rejections = 0;    // 缓存已满且频率不高于淘汰候选、未准入的行
+    uint64_t reads = 0;         // 合并后的读请求数
+    uint64_t bytes_read = 0;
+    int64_t cached_rows = 0;
+    
+    double GetHitRate() const {
+        return unique_rows ? static_cast<double>(hits) / static_cast<double>(unique_rows) : 0.0;
+    }
+};
+
+// 行为[num_rows, row_bytes]的行主序表，从文件offset处开始。所有方法线程安全，
+// 并发的查找只在查缓存与准入时互斥，读盘不持锁
+class TieredEmbeddingStore {
+public:
+    static Status Open(const std::string& path, uint64_t offset, int64_t num_rows, size_t row_bytes,
+                       const EmbeddingStoreOptions& options, std::unique_ptr<TieredEmbeddingStore>* store);
+    ~TieredEmbeddingStore();
+    
+    TieredEmbeddingStore(const TieredEmbeddingStore&) = delete;
+    TieredEmbeddingStore& operator=(const TieredEmbeddingStore&) = delete;
+    
+    // output[i] = 表的第rows[i]行（output为[count, row_bytes]）；行号越界或读盘失败时返回错误
+    Status Lookup(const int64_t* rows, int64_t count, void* output);
+    
+    int64_t GetNumRows() const { return num_rows_; }
+    size_t GetRowBytes() const { return row_bytes_; }
+    EmbeddingStoreStats GetStats() const;
+
+private:
+    TieredEmbeddingStore() = default;
+    
+    // 计数最小草图：4组哈希，计数饱和于15
+    void RecordAccess(int64_t row);
+    uint32_t EstimateFrequency(int64_t row) const;
+    // 调用方持锁；缓存满时按TinyLFU决定是否替换最久未用的行
+    void Admit(int64_t row, const uint8_t* data);
+    
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    int64_t num_rows_ = 0;
+    size_t row_bytes_ = 0;
+    EmbeddingStoreOptions options_;
+    
+    mutable std::mutex mutex_;
+    std::vector<uint8_t> slots_;                    // cache_rows个行槽
+    std::vector<int64_t> free_slots_;
+    std::list<std::pair<int64_t, int64_t>> lru_;    // (行, 槽)，表头最近使用
+    std::unordered_map<int64_t, std::list<std::pair<int64_t, int64_t>>::iterator> index_;
+    std::vector<uint8_t> sketch_;                   // 4 x sketch_width_
+    size_t sketch_width_ = 0;
+    uint64_t sketch_additions_ = 0;
+    EmbeddingStoreStats stats_;
+};
+
+} // namespace inferunity
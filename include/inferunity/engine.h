@@ -6,14 +6,35 @@
 #include "runtime.h"
 #include "backend.h"
 #include "optimizer.h"
+#include "memory_planner.h"
+#include "execution_plan.h"
+#include "kv_cache.h"
+#include "lora.h"
+#include "pipeline_parallel.h"
+#include "preprocess.h"
+#include "sampling.h"
+#include "partitioner.h"
+#include "quantization.h"
+#include "metrics.h"
+#include "result_cache.h"
+#include "output_pool.h"
+#include "admission.h"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <condition_variable>
+#include <functional>
 #include <future>
+#include <map>
+#include <mutex>
 
 namespace inferunity {
 
+class SharedWeightStore;  // 见model_repository.h
+class CollectiveGroup;    // 见collectives.h
+
 // 会话配置 (参考ONNX Runtime的SessionOptions)
 struct SessionOptions {
     // 执行提供者配置 (参考ONNX Runtime的ExecutionProvider配置)
@@ -29,16 +50,341 @@ struct SessionOptions {
     };
     GraphOptimizationLevel graph_optimization_level = GraphOptimizationLevel::ALL;
     bool enable_operator_fusion = true;
+    // 分块通道布局（见MemoryLayoutOptimizationPass）：优化级别为ALL且只用CPU提供者时，
+    // Conv及其后的池化、BN与逐元素算子在NCHWc布局上执行，只在布局边界转换
+    bool enable_blocked_layout = true;
+    // 跨层深度优先分块（见DepthFirstTilingPass）：只用CPU提供者时，中间特征图超过depth_first_tile_bytes的
+    // 卷积/池化链按输出行分块整链执行；0表示关闭，通常取每个核的L2大小
+    int64_t depth_first_tile_bytes = 0;
+    // 内存感知的执行顺序调度（见MemoryAwareSchedulingPass）：在全部优化之后选峰值活跃内存较小的拓扑序
+    bool enable_memory_aware_scheduling = true;
+    // 权重按执行顺序重排进一块对齐缓冲（见CacheOptimizationPass），只用CPU提供者时生效；
+    // 关闭时仍保证初始化器64字节对齐（见MemoryAlignmentPass）
+    bool enable_weight_reordering = true;
+    // 训练后静态量化（见quantization.h）：设置了校准表时先按表插入Q/DQ（激活为quantization_dtype），
+    // 再由支持量化的提供者把QDQ子图折叠为整数内核；未设置时只折叠模型自带的QDQ
     bool enable_quantization = false;
     DataType quantization_dtype = DataType::INT8;
+    std::shared_ptr<const CalibrationTable> quantization_calibration;
+    // 混合精度（见MixedPrecisionPass）：只用CPU提供者时MatMul的常量权重以FLOAT16/BFLOAT16存储，
+    // FLOAT32表示不转换；allow_bf16_compute允许这些MatMul在CPU支持时以BF16原生计算（精度低于FP32累加前的转换）
+    // allow_bf16_compute同时允许OneDNNExecutionProvider在CPU支持AVX512-BF16/AMX时以BF16执行认领的浮点子图
+    DataType mixed_precision_weight_dtype = DataType::FLOAT32;
+    bool allow_bf16_compute = false;
+    // 仅权重量化（见WeightOnlyQuantizationPass）：只用CPU提供者时MatMul的常量权重按组量化为4/8位，
+    // 0表示不量化；优先于混合精度
+    int weight_only_quantization_bits = 0;
+    int weight_only_quantization_block_size = 32;
+    // 稀疏权重（见SparseWeightPass）：只用CPU提供者时非零比例低于该值的MatMul常量权重改为稀疏存储，
+    // 0表示不转换；先于仅权重量化与混合精度
+    float sparse_weight_density_threshold = 0.0f;
     
     // 性能配置
-    int num_threads = 0;  // 0表示自动 (参考ONNX Runtime的线程配置)
+    int num_threads = 0;  // 单个算子的线程数，0表示使用线程池全部线程 (参考ONNX Runtime的intra_op_num_threads)
+    int64_t intra_op_min_work_per_thread = 16384;  // 算子内每线程最少处理的元素数，小张量保持单线程
+    // 推理突发模式（见ThreadPoolBurst）：> 0时每次Run期间线程池的空闲线程在休眠前再自旋这么多微秒，
+    // Run开始时预先唤醒已休眠的线程，小模型的算子之间不再付出休眠/唤醒的延迟，代价是Run期间空闲的核被占用。
+    // run_first_task_on_caller让Run线程发起的并行循环由它自己先执行第一块，少唤醒一个工作线程
+    int64_t thread_pool_burst_spin_us = 0;
+    bool run_first_task_on_caller = false;
+    // 线程池划分（见ThreadPoolInstance，参考ONNX Runtime的intra_op/inter_op线程池与use_per_session_threads）：
+    // 算子内的并行循环使用intra-op池，图级并行的分支与RunAsync使用inter-op池。给出*_thread_pool时使用该池，
+    // 多个会话传入同一个实例即显式共享；否则use_per_session_threads时会话创建私有的池，线程数分别为
+    // intra_op_pool_size与inter_op_pool_size（0表示硬件并发数）；都没有时使用进程全局线程池
+    std::shared_ptr<ThreadPoolInstance> intra_op_thread_pool;
+    std::shared_ptr<ThreadPoolInstance> inter_op_thread_pool;
+    bool use_per_session_threads = false;
+    size_t intra_op_pool_size = 0;
+    size_t inter_op_pool_size = 0;
+    // 会话的默认优先级（见RunPriority）：多个会话共享线程池时，HIGH会话的任务先于其他会话执行，LOW会话
+    // 只用空闲的线程，并在节点之间让给进行中的HIGH运行。RunOptions::priority与调用线程的PriorityScope优先；
+    // 为交互式请求保留核见ThreadPoolOptions::reserved_high_priority_threads
+    RunPriority priority = RunPriority::DEFAULT;
+    // 混合架构上只用性能核执行算子内并行（见ThreadPoolOptions::performance_cores_only），适合延迟敏感的会话：
+    // 没有显式给出intra_op_thread_pool时会话创建只含性能核的私有intra-op池。调用Run的线程本身不受影响
+    bool performance_cores_only = false;
     int max_batch_size = 1;
     bool enable_profiling = false;
+    // 启用性能分析时会话创建后即开始分层追踪（见tracing.h），覆盖加载、优化Pass、内存规划与每次运行的节点；
+    // EndProfiling把事件写入<profile_file_prefix>_<时间>.json（Chrome Trace格式，可用Perfetto打开），
+    // 每个线程最多保留profiling_events_per_thread个最新的事件
+    std::string profile_file_prefix = "inferunity_profile";
+    size_t profiling_events_per_thread = 65536;
+    // Profile时逐节点采集硬件计数器（周期、指令、LLC未命中、浮点运算，见perf_counters.h）
+    bool profile_hardware_counters = false;
+    // 常驻指标（见metrics.h）中会话相关时间序列的session标签，为空时自动编号为session<N>；
+    // 应在进程内唯一。指标记录的开关是进程级的MetricsRegistry::SetEnabled
+    std::string session_id;
     
     // 内存配置 (参考NCNN的内存池配置)
     size_t memory_pool_size = 0;  // 0表示无限制
+    
+    // 静态内存规划：加载模型时为中间张量规划偏移并分配单个arena
+    bool enable_memory_planning = true;
+    MemoryPlanStrategy memory_plan_strategy = MemoryPlanStrategy::AUTO;
+    // 激活内存预算（字节，0表示不限制，需要enable_memory_planning）：静态规划的arena超出预算时重计算
+    // 廉价算子的输出（见PlanMemoryWithinBudget），仍超出时LoadModel返回ERROR_OUT_OF_MEMORY，不会到运行中才失败。
+    // 只约束形状静态的规划，形状特化的规划在运行时按实际形状计算
+    size_t activation_memory_budget = 0;
+    // 形状特化：图输入含符号维度时，按每次运行的输入形状绑定符号，求出中间张量的具体形状并做内存规划；
+    // 同样的输入形状再次出现时直接复用，最多缓存这么多种形状（淘汰最久未用的），0表示不特化
+    size_t max_shape_specialized_plans = 8;
+    // 大页（见HugePagePolicy）：不小于2MB的激活arena（串行、形状特化与执行状态）映射在大页上；
+    // 不小于2MB的常量在TRANSPARENT策略下原地建议透明大页，HUGETLB策略下打包复制进一个大页区域
+    // （共享权重时不复制，只原地建议）。不可用时逐级回退到普通页，统计见GetHugePageStats
+    HugePagePolicy huge_page_policy = HugePagePolicy::NONE;
+    
+    // KV cache：加载模型时把past/present键值改为会话持有的预分配缓冲（见kv_cache.h），
+    // Run时不再传入past、也不再返回present；序列槽位数为max_batch_size
+    bool enable_kv_cache = false;
+    int64_t kv_cache_max_sequence_length = 2048;
+    // 流式推理（按帧/块输入的音频、视频模型，见RunStreaming）：每对{状态输入名, 状态输出名}是在两次Run之间
+    // 延续的状态（卷积回看缓存、RNN隐状态等），由会话持有并原地更新，调用方每次只传入新的块
+    std::vector<std::pair<std::string, std::string>> streaming_states;
+    
+    // 多LoRA适配器（见lora.h）：加载模型时把优化后图中以二维常量为B的MatMul登记为可挂载的权重，
+    // 之后用RegisterLoraAdapter按ID注册适配器，Run时由RunOptions::lora_adapters选用。
+    // 增量由CPU的MatMul内核累加；不支持整图捕获与张量并行
+    bool enable_lora = false;
+    
+    // 采样头：加载模型时在logits输出（sampling_logits_name，为空时取第一个输出）之后追加Sampling算子，
+    // Run返回INT64 [B, 1]的next_tokens而不是logits（见sampling.h）
+    bool enable_sampling_head = false;
+    SamplingOptions sampling;
+    std::string sampling_logits_name;
+    
+    // 图像输入预处理：加载模型时在图输入（image_preprocess_input_name，为空时取第一个输入）之前插入
+    // ImagePreprocess算子，Run直接接受uint8 NHWC图像（见preprocess.h）
+    bool enable_image_preprocess = false;
+    ImagePreprocessOptions image_preprocess;
+    std::string image_preprocess_input_name;
+    
+    // 并发推理：返回shared_ptr输出的Run在独立的执行状态（中间张量与激活arena）上执行，
+    // 多个线程共享图和权重；最多缓存这么多个空闲执行状态供后续运行复用，0表示每次运行新建
+    int execution_state_pool_size = 4;
+    // 输出缓冲回收（见OutputBufferPool）：并发路径上返回所有权的Run交出的输出在调用方释放后回到会话，
+    // 下一次运行由生产者直接写入，形状不变时既不分配也不拷贝；值为每个输出最多保留的空闲缓冲数，0表示不回收
+    size_t output_buffer_pool_size = 4;
+    
+    // 异步推理：RunAsync在运行时线程池上执行，在途（已提交未完成）的运行最多这么多个，
+    // 达到上限时RunAsync立即返回ERROR_RESOURCE_EXHAUSTED而不阻塞调用方，0表示不限制
+    size_t max_inflight_async_runs = 64;
+    // 准入控制（见AdmissionController）：RunAsync受理前按在途运行数与最近的运行耗时预测完成时间，超过截止时间
+    // （RunOptions::cancellation的截止时间，没有时为admission.default_deadline_ms）时立即返回ERROR_OVERLOADED；
+    // 排队后剩余时间已不够一次运行的请求在开始前放弃，callback得到ERROR_OVERLOADED
+    bool enable_admission_control = false;
+    AdmissionOptions admission;
+    
+    // 流水线推理（RunPipelined）：执行计划按代价切成pipeline_num_stages个阶段，各由一个专用线程执行，
+    // 阶段间最多排队pipeline_queue_capacity个micro-batch；每个阶段内的算子使用pipeline_intra_op_threads个线程
+    size_t pipeline_num_stages = 2;
+    size_t pipeline_queue_capacity = 2;
+    int pipeline_intra_op_threads = 1;
+    
+    // 执行提供者跨多种设备时按代价模型分区（见partitioner.h）：每个子图放到预计最快的提供者上，
+    // 只在分区边界插入拷贝；关闭时每个节点使用第一个支持它的提供者
+    bool enable_cost_based_partitioning = true;
+    // 存在支持子图编译的提供者（如ONNXRuntimeExecutionProvider）时，其余提供者都不支持的连通子图
+    // 委托给它整体执行（见DelegateUnsupportedSubgraphs），其余节点仍由原生提供者执行
+    bool enable_subgraph_delegation = true;
+    // 认领子图的编译型提供者（如TensorRTExecutionProvider，见ExecutionProvider::ClaimsSubgraphs）
+    // 只接管至少这么多个节点的连通子图，更小的子图留给原生提供者
+    size_t min_claimed_subgraph_nodes = 3;
+    
+    // TensorRT执行提供者（见tensorrt_backend.cpp）：引擎按子图构建，允许时启用FP16/INT8 kernel；
+    // INT8使用quantization_calibration中的范围作为各张量的动态范围。动态维度的优化配置取
+    // [1, tensorrt_max_dynamic_dim]，批维度取[1, max_batch_size]。构建好的引擎序列化到
+    // tensorrt_engine_cache_dir（为空时用optimized_model_cache_dir），以子图哈希和GPU型号为键，
+    // 之后的会话直接反序列化，不再重新构建
+    bool tensorrt_fp16 = true;
+    bool tensorrt_int8 = false;
+    size_t tensorrt_workspace_bytes = size_t(1) << 30;
+    int64_t tensorrt_max_dynamic_dim = 1024;
+    std::string tensorrt_engine_cache_dir;
+    
+    // XNNPACK执行提供者（见xnnpack_backend.cpp，ARM上使用）：xnnpack_fp16在CPU支持ARMv8.2 FP16算术时
+    // 提示XNNPACK以FP16执行认领的子图（激活与权重在内部转换，输入输出仍为FP32）
+    bool xnnpack_fp16 = false;
+    
+    // 移动端NPU执行提供者（见snpe_backend.cpp、armnn_backend.cpp）：编译产物（SNPE的DLC及其初始化缓存、
+    // Arm NN GpuAcc/EthosNAcc的网络缓存）存放在npu_artifact_cache_dir（为空时用optimized_model_cache_dir），
+    // 以子图的ONNX导出内容为键。snpe_runtimes按优先级列出SNPE的运行时（DSP、GPU、CPU），
+    // armnn_backends按优先级列出Arm NN的后端
+    std::string npu_artifact_cache_dir;
+    std::string snpe_runtimes = "DSP,GPU,CPU";
+    std::string armnn_backends = "EthosNAcc,GpuAcc,CpuAcc";
+    
+    // CUDA Graph：整个执行计划都在一个支持整图捕获的提供者上（见ExecutionProvider::CaptureBegin）时，
+    // 第一次运行捕获、之后重放，省去逐个算子的启动开销；输入拷进会话持有的固定缓冲，
+    // 中间张量与输出在运行之间保持地址不变，输入形状变化时重新捕获
+    bool enable_cuda_graph = false;
+    
+    // 多流执行：支持多流的提供者（如CUDA）上，相互独立的分支分配到最多这么多条流并发执行，
+    // 跨流依赖用设备事件同步；每次运行从设备的流池取流，并发的会话与运行互不共享流。
+    // 1表示在默认流上顺序执行；启用CUDA Graph时捕获只在单条流上进行，忽略该选项
+    int max_parallel_streams = 1;
+    
+    // kernel自动调优缓存（见kernel_tuning.h）：加载模型时读入，编译节点时新调优的结果写回，
+    // 以GPU型号、形状和数据类型为键，重启后命中的节点跳过算法搜索；为空时缓存只在进程内有效
+    std::string kernel_tuning_cache_path;
+    
+    // CUDA上的逐元素融合代码生成（见cuda_codegen.cpp，需NVRTC）：加载时把融合Pass合并出的FusedElementwise
+    // 链按静态形状生成一个CUDA kernel，用NVRTC编译为PTX，整条链一次启动、每个输入只读一遍。
+    // PTX以生成代码与GPU架构的哈希为键存放在cuda_codegen_cache_dir（为空时用optimized_model_cache_dir），
+    // 之后的会话直接加载，不再编译；两者都为空时PTX只在进程内复用
+    std::string cuda_codegen_cache_dir;
+    
+    // CPU算子自动调优：加载模型时对形状已知的卷积、GEMM与注意力节点实测候选的算子内线程数
+    // （不超过num_threads）与卷积算法，最快的组合记入节点的已编译内核；结果写入上面的调优缓存，
+    // 以CPU指令集与核数为设备键，同一台机器重启后命中的节点不再实测
+    bool enable_cpu_autotuning = false;
+    
+    // 加载完成后按执行顺序预取各步骤用到的权重页（见PrefetchMemory）：权重是模型文件映射的视图时，
+    // 首次推理不再逐页等待缺页读盘；权重已在内存中时没有作用
+    bool prefetch_weights = false;
+    
+    // 权重流式驻留（模型权重大于内存时，见WeightStreamingSchedule）：权重是模型文件映射的视图时，
+    // 按顺序执行的运行只让即将执行的步骤的权重驻留，执行第i步前预取之后最多weight_streaming_lookahead步
+    // 首次用到的权重，权重最后一次使用之后回收其页。weight_streaming_budget为已预取未回收的权重字节上限，
+    // 0表示不启用；启用时不做权重重排（重排会把映射的权重复制进堆内存），prefetch_weights不再生效
+    size_t weight_streaming_budget = 0;
+    int weight_streaming_lookahead = 2;
+    // 跨节点的权重预取（见WeightPrefetcher）：> 0时第i个步骤执行期间由辅助线程预取之后这么多步的常量，
+    // 映射的权重先让内核读盘，每步开头最多weight_prefetch_cache_bytes字节预取进末级缓存；0表示不启用
+    int weight_prefetch_lookahead = 0;
+    size_t weight_prefetch_cache_bytes = size_t(1) << 20;
+    
+    // 结果缓存（见ResultCache）：> 0时返回所有权的Run（含RunAsync）先按输入内容查缓存，命中时不执行图，
+    // 直接返回上次输出的副本；值为缓存的输出总字节数上限，按最久未用淘汰。result_cache_ttl_ms > 0时
+    // 条目超过该时间后失效。启用KV cache时不缓存（输出依赖会话中的序列状态）
+    size_t result_cache_bytes = 0;
+    double result_cache_ttl_ms = 0.0;
+    
+    // 大嵌入表分层存储（见TieredEmbeddingStore）：> 0时CPU上的Embedding与按第0轴的Gather，若表是模型文件映射
+    // 的视图且行数多于该值，改为从文件按需读行，内存中只保留这么多行热点行（TinyLFU准入）
+    int64_t embedding_cache_rows = 0;
+    
+    // 加载完成后立即预热（见InferenceSession::Warmup），首个请求不再承担缺页、arena分配与缓存填充的开销。
+    // warmup_input_shapes为预热运行的输入形状（每项按图输入顺序给出全部输入的形状），输入含符号维度时
+    // 借此建立各个形状桶的特化计划；为空时按图输入的形状运行（符号维度取1）。每种形状运行warmup_runs次
+    bool warmup_on_load = false;
+    std::vector<std::vector<Shape>> warmup_input_shapes;
+    int warmup_runs = 2;
+    
+    // 优化图缓存目录：非空时把图优化后的结果以紧凑格式（见model_format.h）写入该目录，
+    // 键为(模型内容哈希, 影响优化的选项, CPU指令集, 库版本)；键相同的会话直接映射缓存文件，
+    // 跳过图优化Pass；目录需已存在。kernel_tuning_cache_path为空时调优缓存也放在这个目录
+    std::string optimized_model_cache_dir;
+    
+    // 跨会话的权重去重（见model_repository.h）：图优化之后，常量换成表中内容相同的只读共享副本，
+    // 多个会话共用一个表时相同的权重只驻留一份；ModelRepository为其中的会话统一设置
+    std::shared_ptr<SharedWeightStore> shared_weights;
+    
+    // 多进程数据并行：非空时把图优化后的结果发布到该名称的共享内存段（见PublishCompactModel），
+    // 工作进程以相同的选项创建会话并调用LoadModelFromSharedMemory，权重在进程间只驻留一份
+    std::string shared_model_name;
+    
+    // NUMA绑定（见numa.h）：>= 0时会话的加载与运行在该节点上进行——调用线程在期间绑定到节点的CPU，
+    // 中间张量、执行状态与预打包权重从节点本地的内存池分配，算子内并行与RunAsync只使用该节点的线程组
+    // （需ThreadPoolOptions::numa_aware）。numa_replicate_weights把常量复制到节点本地内存，
+    // 共享权重时每个节点各保留一份副本；否则权重留在原处，跨节点共享。-1表示不绑定
+    int numa_node = -1;
+    bool numa_replicate_weights = false;
+    
+    // 张量并行（见TensorParallelShardingPass与collectives.h）：> 1时加载模型按Megatron-LM的列/行并行把
+    // 常量权重的MatMul切成tensor_parallel_size份，第r份由一个内部会话在tensor_parallel_device_ids[r]
+    // （为空时为device_id + r）上加载与执行，集合通信使用第一个非CPU提供者的设备类型的通信组
+    // （CUDA上为NCCL，否则为进程内的主机实现）。Run时各rank同步执行同一步，输出取自rank 0；
+    // 不支持IOBinding与流水线推理
+    int tensor_parallel_size = 1;
+    std::vector<int> tensor_parallel_device_ids;
+    
+    // 流水线并行（见pipeline_parallel.h）：> 1时把优化后的图按代价模型（SetCostModel给出，否则为默认的
+    // 设备画像）切成pipeline_parallel_size个连续阶段，第s个阶段由一个内部会话在pipeline_parallel_device_ids[s]
+    // （为空时为device_id + s）上加载与执行，阶段之间经通信组点对点传递边界张量。Run是一个micro-batch，
+    // RunPipelined让多个micro-batch同时处于不同的阶段，阶段间最多排队pipeline_queue_capacity个；
+    // 不支持IOBinding、KV cache、采样头、LoRA与张量并行
+    int pipeline_parallel_size = 1;
+    std::vector<int> pipeline_parallel_device_ids;
+};
+
+// 单次运行的选项（参考ONNX Runtime的RunOptions）
+struct RunOptions {
+    // 取消令牌（见CancellationToken）：客户端断开时Cancel，或用WithTimeout给出截止时间。执行在节点之间
+    // 检查，节点内的并行循环跳过剩余的块，运行在一个节点的延迟内返回ERROR_CANCELLED/ERROR_TIMEOUT并
+    // 立即归还执行状态；排队中的异步运行开始前已触发时不再执行。nullptr表示不可取消
+    std::shared_ptr<CancellationToken> cancellation;
+    // 本次运行的优先级，DEFAULT表示使用SessionOptions::priority
+    RunPriority priority = RunPriority::DEFAULT;
+    // 各样本（图输入的第0维）选用的LoRA适配器ID，空字符串表示只用基座权重；只有一个元素时整批共用。
+    // 每个MatMul的输出行按元素个数等分给各样本，同一批可以混合不同的适配器。为空表示不用适配器
+    std::vector<std::string> lora_adapters;
+};
+
+// 异步推理的结果
+struct RunResult {
+    Status status;
+    std::vector<std::shared_ptr<Tensor>> outputs;  // 按图输出顺序，所有权属于调用方
+};
+
+// 预热的统计（见InferenceSession::Warmup）
+struct WarmupStats {
+    size_t touched_weight_bytes = 0;  // 逐页触碰过的常量字节数
+    size_t prepared_states = 0;       // 预先创建并放入执行状态池的状态数
+    size_t shapes = 0;                // 运行过的输入形状种数
+    size_t runs = 0;
+    double elapsed_ms = 0.0;
+    double last_run_ms = 0.0;         // 最后一次预热运行的耗时，可作为热态延迟的参考
+};
+
+// 加载模型后的内存占用估计（见InferenceSession::EstimateMemory），单位为字节
+struct MemoryEstimate {
+    size_t weights = 0;            // 优化后的图中的常量
+    size_t prepacked_weights = 0;  // 加载时为GEMM/卷积预打包或变换的权重副本
+    size_t activation_arena = 0;   // 静态内存规划的arena（未启用内存规划时为逐张量分配的总和）
+    size_t outputs = 0;            // 不在arena中的图输出
+    size_t kv_cache = 0;           // 启用KV cache时按max_batch_size与kv_cache_max_sequence_length分配的缓存
+    size_t scratch = 0;            // 算子的工作区（如im2col）与GEMM打包缓冲
+    
+    size_t Total() const {
+        return weights + prepacked_weights + activation_arena + outputs + kv_cache + scratch;
+    }
+    // 每项一行的表格
+    std::string ToString() const;
+};
+
+class InferenceSession;
+struct ShapeSpecializedPlan;  // 形状特化的内存规划与执行状态池，定义在engine.cpp
+struct PrunedExecutionPlan;   // 只计算部分输出的执行计划与执行状态池，定义在engine.cpp
+
+// 输入输出绑定 (参考ONNX Runtime的IoBinding)：
+// 把调用方持有的缓冲按名称绑定到图输入和输出，名称和类型在绑定时校验一次，之后每次Run都直接复用。
+// 绑定的输出缓冲由生产它的算子直接写入，不经过会话内的张量，也没有额外拷贝和分配；
+// 未绑定的输出由会话分配，Run之后通过GetOutputs取得
+class IOBinding {
+public:
+    Status BindInput(const std::string& name, std::shared_ptr<Tensor> tensor);
+    Status BindOutput(const std::string& name, std::shared_ptr<Tensor> tensor);
+    void ClearBoundInputs();
+    void ClearBoundOutputs();
+    
+    // 按图输出顺序：绑定的缓冲，或上一次Run由会话分配的张量
+    const std::vector<std::shared_ptr<Tensor>>& GetOutputs() const { return outputs_; }
+    std::shared_ptr<Tensor> GetOutput(const std::string& name) const;
+
+private:
+    friend class InferenceSession;
+    explicit IOBinding(const InferenceSession* session);
+    
+    int FindIndex(const std::vector<std::string>& names, const std::string& name) const;
+    
+    const InferenceSession* session_;
+    const Graph* graph_;  // 创建时的图，重新加载模型后绑定失效
+    std::vector<std::string> input_names_;
+    std::vector<std::string> output_names_;
+    std::vector<std::shared_ptr<Tensor>> inputs_;
+    std::vector<std::shared_ptr<Tensor>> bound_outputs_;
+    std::vector<std::shared_ptr<Tensor>> outputs_;
 };
 
 // 推理会话 (参考ONNX Runtime的InferenceSession设计)
@@ -54,6 +400,30 @@ public:
     Status LoadModel(const std::string& filepath);
     Status LoadModelFromMemory(const void* data, size_t size);
     Status LoadModelFromGraph(std::unique_ptr<Graph> graph);
+    // 连接其他进程发布的已优化模型（见SessionOptions::shared_model_name）：只读映射权重，
+    // 跳过解析、量化与图优化Pass，之后的分区与执行准备照常进行
+    Status LoadModelFromSharedMemory(const std::string& name);
+    
+    // 估计以options加载模型后的内存占用而不创建会话：解析与优化照常进行（优化Pass改写权重），
+    // 之后的KV cache、内存规划与预打包只计算大小，不分配arena、缓存与打包缓冲，也不编译节点。
+    // input_shapes按图输入顺序给出具体形状（为空时使用模型中的形状），符号维度按1计。
+    // 不支持tensor_parallel_size > 1与pipeline_parallel_size > 1
+    static Status EstimateMemory(const std::string& filepath, const SessionOptions& options,
+                                 const std::vector<Shape>& input_shapes, MemoryEstimate* estimate);
+    static Status EstimateMemory(std::unique_ptr<Graph> graph, const SessionOptions& options,
+                                 const std::vector<Shape>& input_shapes, MemoryEstimate* estimate);
+    
+    // 预热：并行逐页触碰常量使其驻留，预先分配串行路径的arena与执行状态池，再以零输入按
+    // SessionOptions::warmup_input_shapes（为空时按图输入的形状）各运行warmup_runs次，填充kernel缓存、
+    // 预打包权重与形状特化计划并唤醒线程池。成功后IsWarm()为true，重新加载模型后复位。
+    // 启用KV cache时不运行（零输入会写入缓存的序列），只做触碰与预分配
+    Status Warmup(WarmupStats* stats = nullptr);
+    bool IsWarm() const { return warm_.load(std::memory_order_acquire); }
+    
+    // 最近一次加载模型各阶段的耗时（毫秒，按执行顺序）：Parse、Validate、InferShapes、Quantize、Optimize、
+    // PartitionGraph、PlanMemory、PrepareExecution:<提供者>（节点编译与权重预打包）、BuildExecutionPlan、Warmup，
+    // 未执行的阶段不出现。加载成功后也以INFO日志输出
+    const std::vector<std::pair<std::string, double>>& GetLoadStageTimings() const { return load_stage_timings_; }
     
     // 模型信息
     const Graph* GetGraph() const { return graph_.get(); }
@@ -62,25 +432,102 @@ public:
     std::vector<std::string> GetInputNames() const;
     std::vector<std::string> GetOutputNames() const;
     
-    // 推理
+    // 推理（输出指向会话内的张量，下一次Run前有效；多线程调用时串行执行）
     Status Run(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs);
     Status Run(const std::unordered_map<std::string, Tensor*>& inputs,
                std::unordered_map<std::string, Tensor*>& outputs);
+    // 输出张量的所有权交给调用方，之后的Run不会覆盖；自有的输出张量直接移交，不拷贝。
+    // 线程安全：多个线程可以同时调用，各自使用执行状态池中的一个状态（启用KV cache时串行执行）
+    Status Run(const std::vector<Tensor*>& inputs, std::vector<std::shared_ptr<Tensor>>& outputs);
+    // 同上，按run_options取消或超时。其他Run重载可以在CancellationScope内调用得到同样的效果
+    // （流水线推理、整图捕获的重放与张量并行不检查取消）
+    Status Run(const RunOptions& run_options, const std::vector<Tensor*>& inputs,
+               std::vector<std::shared_ptr<Tensor>>& outputs);
+    // 只计算output_names中的输出（例如只要embedding、不要分类logits），outputs按output_names的顺序：
+    // 只执行这些输出的祖先节点，裁剪后的计划按输出集合缓存；为空时计算全部输出。线程安全性同上，
+    // 不支持执行状态的路径（KV cache、整图捕获等）仍执行整个图后再挑出所需的输出
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<std::string>& output_names,
+               std::vector<std::shared_ptr<Tensor>>& outputs);
+    // 缓存的裁剪计划个数
+    size_t GetNumPrunedPlans() const;
+    
+    // 使用IOBinding中绑定的输入输出执行（线程安全性同上；同一个IOBinding不能同时用于多个Run）
+    std::unique_ptr<IOBinding> CreateIOBinding() const;
+    Status Run(IOBinding& binding);
     
-    // 异步推理
+    // 流式推理（需要SessionOptions::streaming_states）：inputs按图输入顺序只给出非状态输入，outputs按图输出
+    // 顺序只包含非状态输出。状态输入取自会话持有的缓冲，状态输出由算子直接写入另一块缓冲，成功后两者交换，
+    // 不拷贝也不分配；失败时状态保持不变。状态在首次运行前与ResetStreamingState之后为零，
+    // 形状未知（动态维度）的状态需先用SetStreamingState给出初值。多个线程调用时串行执行
+    Status RunStreaming(const std::vector<Tensor*>& inputs, std::vector<std::shared_ptr<Tensor>>& outputs);
+    Status ResetStreamingState();
+    // 按状态输入名读取/设置状态的当前值（新的流从给定的上下文开始）
+    std::shared_ptr<Tensor> GetStreamingState(const std::string& input_name);
+    Status SetStreamingState(const std::string& input_name, const Tensor& value);
+    
+    // 异步推理 (参考ONNX Runtime的RunAsync)：输入的所有权随请求交给会话，在线程池上执行（线程安全性同Run），
+    // 完成后在工作线程上调用callback；callback应尽快返回，不能在其中等待其他异步运行。
+    // 返回值只表示是否受理：在途运行达到max_inflight_async_runs时返回ERROR_RESOURCE_EXHAUSTED，准入控制预测无法
+    // 按时完成时返回ERROR_OVERLOADED，callback都不会被调用
+    using RunCallback = std::function<void(Status status, std::vector<std::shared_ptr<Tensor>> outputs)>;
+    Status RunAsync(std::vector<std::shared_ptr<Tensor>> inputs, RunCallback callback);
+    // 同上，通过future取得结果；未受理时future立即就绪并带有错误
+    std::future<RunResult> RunAsync(std::vector<std::shared_ptr<Tensor>> inputs);
+    // 带运行选项的异步推理：排队期间已取消或超时的请求不执行，callback直接得到相应的错误
+    Status RunAsync(const RunOptions& run_options, std::vector<std::shared_ptr<Tensor>> inputs,
+                    RunCallback callback);
+    std::future<RunResult> RunAsync(const RunOptions& run_options, std::vector<std::shared_ptr<Tensor>> inputs);
+    // 旧接口：输出指向会话内的张量，inputs中的张量和outputs须保持有效直到future就绪
     std::future<Status> RunAsync(const std::vector<Tensor*>& inputs,
                                 std::vector<Tensor*>& outputs);
     
+    // 协程接口：co_await RunCoro(inputs, executor)得到RunResult，完成后经executor恢复协程；
+    // 不带executor时在线程池线程上直接恢复。需要C++20，定义见coroutine.h
+    template <typename Executor>
+    auto RunCoro(std::vector<std::shared_ptr<Tensor>> inputs, Executor executor);
+    auto RunCoro(std::vector<std::shared_ptr<Tensor>> inputs);
+    
+    // 在途的异步运行个数；等待它们全部完成（析构时自动调用）
+    size_t GetNumInflightRuns() const;
+    void WaitForAsyncRuns();
+    
     // 批量推理（顺序执行）
     Status RunBatch(
         const std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_inputs,
         std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_outputs);
     
     // 批量推理（优化版本：合并batch维度）
+    // 各样本的同一输入在内存中相邻（如CreateBatchInputTensors的槽位）时直接作为批输入，不拷贝；
+    // 输出为合并结果按样本切出的视图（SplitBatch），不逐样本拷贝
     Status RunBatchOptimized(
         const std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_inputs,
         std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_outputs);
     
+    // 为第input_index个输入预分配batch_size个样本的批缓冲，返回各样本的槽位视图，调用方直接写入
+    std::vector<std::shared_ptr<Tensor>> CreateBatchInputTensors(size_t input_index, size_t batch_size);
+    
+    // 流水线推理：各micro-batch依次流过流水线的各阶段，阶段N处理第i个时阶段N-1处理第i+1个；
+    // 输出的所有权交给调用方。需要SupportsConcurrentRun()（流水线并行时各阶段在各自的设备上），多个线程调用时串行执行
+    Status RunPipelined(
+        const std::vector<std::vector<std::shared_ptr<Tensor>>>& micro_batches,
+        std::vector<std::vector<std::shared_ptr<Tensor>>>& outputs);
+    // 用一个micro-batch逐算子计时，按实测耗时重新平衡流水线阶段
+    Status CalibratePipeline(const std::vector<std::shared_ptr<Tensor>>& inputs);
+    // 流水线执行器（首次RunPipelined或CalibratePipeline之前为nullptr）
+    const PipelineExecutor* GetPipelineExecutor() const { return pipeline_.get(); }
+    // 流水线并行的执行器（pipeline_parallel_size > 1时加载后可用，否则为nullptr）
+    PipelineParallelExecutor* GetPipelineParallelExecutor() const { return pipeline_parallel_.get(); }
+    
+    // 会话使用的intra-op/inter-op线程池（nullptr表示进程全局线程池），可通过它们Resize
+    std::shared_ptr<ThreadPoolInstance> GetIntraOpThreadPool() const { return intra_op_pool_; }
+    std::shared_ptr<ThreadPoolInstance> GetInterOpThreadPool() const { return inter_op_pool_; }
+    
+    // LoRA适配器（需enable_lora）：注册时检查各权重名与A/B的形状，同一ID再次注册时替换；
+    // 注销不影响已经开始的运行。重新加载模型时清空
+    Status RegisterLoraAdapter(const std::string& adapter_id, LoraAdapter adapter);
+    Status UnregisterLoraAdapter(const std::string& adapter_id);
+    std::vector<std::string> GetLoraAdapterIds() const { return lora_registry_.GetAdapterIds(); }
+    
     // 张量创建
     std::shared_ptr<Tensor> CreateInputTensor(size_t input_index);
     std::shared_ptr<Tensor> CreateInputTensor(const std::string& input_name);
@@ -89,28 +536,224 @@ public:
     
     // 性能分析
     Status Profile(ProfilingResult& result);
+    // 结束追踪并写出trace文件（参考ONNX Runtime的EndProfiling），返回文件路径；
+    // 未启用enable_profiling或写入失败时返回空字符串。之前调用过Profile时，最近一次的内存时间线
+    // （见MemoryTimeline）同时写入同名的*_memory.json，trace中的live_bytes计数器给出同一条曲线
+    std::string EndProfiling();
     
     // 配置 (参考ONNX Runtime的配置管理)
     void SetOptions(const SessionOptions& options);
     const SessionOptions& GetOptions() const { return options_; }
     
+    // 会话指标的session标签（SessionOptions::session_id或自动编号）
+    const std::string& GetSessionId() const { return session_id_; }
+    
+    // 内存规划结果（arena_size为规划峰值，naive_size为逐张量分配的总和）
+    const MemoryPlan& GetMemoryPlan() const { return memory_plan_; }
+    
+    // 会话激活内存的记账：串行路径、形状特化计划与空闲执行状态的arena（流水线执行器的状态不计入）
+    MemoryStats GetMemoryStats() const { return memory_account_->GetStats(); }
+    // 释放空闲的激活内存（串行路径与形状特化计划的arena、空闲执行状态与流水线执行器），返回释放的字节数；
+    // 正在执行的运行不受影响，之后的运行按需重新分配。启用整图捕获时保留串行路径的arena（重放依赖固定地址）
+    size_t ReleaseActivationMemory();
+    
+    // 加载模型时编译的执行计划（未加载模型时为nullptr）
+    const ExecutionPlan* GetExecutionPlan() const { return execution_plan_.get(); }
+    // 启用权重流式驻留时执行计划的预取/回收安排，否则为nullptr
+    const WeightStreamingSchedule* GetWeightStreamingSchedule() const { return weight_streaming_.get(); }
+    // 启用跨节点权重预取时的预取器，否则为nullptr
+    const WeightPrefetcher* GetWeightPrefetcher() const { return weight_prefetcher_.get(); }
+    // 未启用输出缓冲回收或不支持并发Run时为nullptr；GetStats()给出复用、新分配与归还的次数
+    const OutputBufferPool* GetOutputBufferPool() const { return output_pool_.get(); }
+    // 未启用结果缓存时为nullptr；GetStats()给出命中率、淘汰与过期次数
+    ResultCache* GetResultCache() { return result_cache_.get(); }
+    // 未启用准入控制时为nullptr；GetStats()给出拒绝、放弃的次数与当前的排队预测
+    const AdmissionController* GetAdmissionController() const { return admission_.get(); }
+    
+    // 图分区使用的代价模型（如录入了实测耗时），在下一次加载模型时生效；nullptr表示使用默认参数
+    void SetCostModel(std::shared_ptr<const CostModel> cost_model) { cost_model_ = std::move(cost_model); }
+    
+    // 会话持有的KV cache（未启用enable_kv_cache时为nullptr），用于Reset/Trim/Fork序列
+    KVCache* GetKVCache() { return kv_cache_.get(); }
+    
+    // 是否以整图捕获与重放的方式执行（enable_cuda_graph且计划满足捕获条件）
+    bool IsGraphCaptureEnabled() const { return capture_provider_ != nullptr; }
+    
+    // 是否支持并发Run，以及执行状态池中空闲状态的个数
+    bool SupportsConcurrentRun() const { return concurrent_run_; }
+    size_t GetNumIdleExecutionStates() const;
+    
+    // 缓存的形状特化计划个数，以及运行时命中已有计划的次数
+    size_t GetNumShapeSpecializedPlans() const;
+    uint64_t GetShapeSpecializedPlanHits() const;
+    
     // 为了向后兼容，保留Engine作为别名
     using Engine = InferenceSession;
     using EngineConfig = SessionOptions;
-    
+
 private:
     InferenceSession(const SessionOptions& options);
     
     Status Initialize();
+    // 解析得到的图交给LoadModelFromGraph，解析的耗时放在各阶段耗时的最前面
+    Status LoadParsedGraph(std::unique_ptr<Graph> graph,
+                           const std::vector<std::pair<std::string, double>>& parse_timing);
     Status LoadAndOptimizeGraph();
+    // 按quantization_calibration插入Q/DQ，再交给支持量化的提供者折叠
+    Status QuantizeModel();
     Status PrepareExecutionProviders();
+    Status PlanSessionMemory();
+    Status BuildExecutionPlan();
+    Status PrepareKVCache();
+    // 登记可挂载LoRA的MatMul权重，并给这些MatMul写上lora_target属性
+    void PrepareLoraTargets();
+    // 按RunOptions::lora_adapters建立本次运行的LoraBatch（不用适配器时为nullptr）
+    Status CreateLoraBatch(const RunOptions& run_options, std::shared_ptr<const LoraBatch>* batch) const;
+    Status PartitionGraph();
+    // 按rank切分图并加载各rank的会话
+    Status PrepareTensorParallel();
+    // 按代价切分阶段并加载各阶段的会话
+    Status PreparePipelineParallel();
+    // 按内存规划之后的图填写memory_estimate_的权重、预打包、输出与工作区
+    void FinishMemoryEstimate();
+    
+    Status RunSequential(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs);
+    // 返回所有权的Run去掉结果缓存之后的部分
+    Status RunDetached(const std::vector<Tensor*>& inputs, std::vector<std::shared_ptr<Tensor>>& outputs);
+    // 需持有run_mutex_：串行路径的arena被ReleaseActivationMemory释放后重新分配并绑定
+    Status EnsureSessionArena();
+    Status RunCaptured(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs);
+    // 各rank在各自的线程上运行（rank 0在调用线程上），任一rank失败时中止通信组，其余rank随之返回
+    Status RunTensorParallel(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs);
+    void PrepareGraphCapture();
+    void PrefetchWeights() const;
+    // 在intra-op池上逐页触碰执行计划用到的CPU常量，返回触碰的字节数
+    size_t TouchWeights() const;
+    // 把常量复制为numa_node本地的张量（numa_replicate_weights且没有共享权重时）
+    void ReplicateWeightsToNumaNode();
+    // 按huge_page_policy把大常量放到大页上
+    void PlaceWeightsOnHugePages();
+    // 优化图缓存文件的路径，由未优化图的内容与会话选项决定
+    std::string GetOptimizedModelCachePath() const;
+    ExecutionOptions GetExecutionOptions() const;
+    ExecutionPlanOptions GetExecutionPlanOptions() const;
+    // 取得输出张量的所有权：source被取走时置空，否则拷贝一份；allow_move为false时总是拷贝
+    static Status DetachOutput(const Value* value, std::shared_ptr<Tensor>* source,
+                               std::shared_ptr<Tensor>* output, bool allow_move = true);
+    // 同上，交出的输出套上回收池的句柄，拷贝的目标取自回收池；recycled为运行前放进槽位的缓冲
+    Status DetachPooledOutput(size_t index, const Value* value, const Tensor* recycled,
+                              std::shared_ptr<Tensor>* source, std::shared_ptr<Tensor>* output);
+    // 按输入形状取得（必要时创建）形状特化的计划；图输入没有符号维度或无法特化时返回nullptr
+    std::shared_ptr<ShapeSpecializedPlan> GetShapeSpecializedPlan(const std::vector<Tensor*>& inputs);
+    // specialized不为空时使用该形状的计划与其执行状态池
+    Status AcquireExecutionState(std::unique_ptr<ExecutionState>* state,
+                                 ShapeSpecializedPlan* specialized = nullptr);
+    void ReleaseExecutionState(std::unique_ptr<ExecutionState> state,
+                               ShapeSpecializedPlan* specialized = nullptr);
+    Status PreparePipeline();
+    // 在途计数：BeginAsyncRun达到上限时返回false
+    bool BeginAsyncRun();
+    void EndAsyncRun();
+    // 异步运行从提交到开始执行的等待时间
+    void RecordAsyncQueueWait(int64_t enqueue_ns);
+    // 准入控制：受理前预测（BeginAsyncRun之后调用，拒绝时已归还在途计数），开始前再检查截止时间
+    Status AdmitAsyncRun(CancellationToken::Clock::time_point deadline);
+    Status StartAdmittedRun(CancellationToken::Clock::time_point deadline);
     
     SessionOptions options_;
+    std::string session_id_;
+    // 注册表中的会话指标，会话销毁时注销
+    std::shared_ptr<ShardedHistogram> run_latency_metric_;
+    std::shared_ptr<ShardedHistogram> async_queue_wait_metric_;
+    std::shared_ptr<Gauge> arena_high_water_metric_;
+    std::shared_ptr<Counter> result_cache_hits_metric_;
+    std::shared_ptr<Counter> result_cache_misses_metric_;
+    std::shared_ptr<Gauge> async_queue_depth_metric_;
+    std::shared_ptr<Counter> admission_rejected_metric_;
+    std::shared_ptr<Counter> admission_shed_metric_;
     std::unique_ptr<Graph> graph_;
     std::unique_ptr<Optimizer> optimizer_;
     std::unique_ptr<ExecutionEngine> execution_engine_;
     std::vector<std::shared_ptr<ExecutionProvider>> execution_providers_;
+    MemoryPlan memory_plan_;
+    std::shared_ptr<MemoryArena> memory_arena_;
+    std::shared_ptr<MemoryAccount> memory_account_;
+    std::unique_ptr<ExecutionPlan> execution_plan_;
+    std::shared_ptr<const WeightStreamingSchedule> weight_streaming_;
+    std::shared_ptr<WeightPrefetcher> weight_prefetcher_;
+    std::unique_ptr<KVCache> kv_cache_;
+    LoraRegistry lora_registry_;
+    std::unique_ptr<ResultCache> result_cache_;
+    std::shared_ptr<OutputBufferPool> output_pool_;
+    std::unique_ptr<AdmissionController> admission_;
+    std::shared_ptr<const CostModel> cost_model_;
+    std::unordered_map<const Node*, ExecutionProvider*> node_providers_;  // 图分区的结果
+    
+    // 整图捕获：capture_inputs_是捕获时绑定的固定输入缓冲，形状变化时重建并重新捕获
+    ExecutionProvider* capture_provider_ = nullptr;
+    std::vector<std::shared_ptr<Tensor>> capture_inputs_;
     bool initialized_;
+    
+    // Value上的张量只供串行路径使用；并发路径的中间结果在各自的ExecutionState里
+    std::mutex run_mutex_;
+    bool state_run_ = false;       // 计划中的提供者都支持ExecuteKernel，可以在ExecutionState上执行
+    bool concurrent_run_ = false;  // state_run_且没有KV cache等会话级可变状态
+    mutable std::mutex state_pool_mutex_;
+    std::vector<std::unique_ptr<ExecutionState>> idle_states_;
+    
+    // 形状特化：symbolic_tensors_是加载时记录的各中间值的（符号）形状，串行运行会释放Value上的中间张量；
+    // 计划以各输入的秩与维度为键
+    std::vector<std::pair<const Value*, std::shared_ptr<Tensor>>> symbolic_tensors_;
+    mutable std::mutex specialized_mutex_;
+    std::map<std::vector<int64_t>, std::shared_ptr<ShapeSpecializedPlan>> specialized_plans_;
+    uint64_t specialized_clock_ = 0;
+    uint64_t specialized_hits_ = 0;
+    
+    // 部分输出：以所需输出在图输出中的下标序列为键，与execution_plan_一同重建
+    mutable std::mutex pruned_mutex_;
+    std::map<std::vector<int>, std::shared_ptr<PrunedExecutionPlan>> pruned_plans_;
+    
+    std::mutex pipeline_mutex_;
+    std::unique_ptr<PipelineExecutor> pipeline_;
+    
+    // 流式推理的状态，首次使用时按当前的图建立（重新加载模型后重建）
+    struct StreamingState {
+        int input_index = -1;
+        int output_index = -1;
+        std::shared_ptr<Tensor> current;  // 下一块的状态输入
+        std::shared_ptr<Tensor> next;     // 状态输出直接写入，运行成功后与current交换
+    };
+    Status EnsureStreamingStates();
+    std::mutex streaming_mutex_;
+    std::vector<StreamingState> streaming_states_;
+    std::unique_ptr<IOBinding> streaming_binding_;
+    
+    // SessionOptions给出的或会话私有的线程池，Initialize时确定
+    std::shared_ptr<ThreadPoolInstance> intra_op_pool_;
+    std::shared_ptr<ThreadPoolInstance> inter_op_pool_;
+    
+    mutable std::mutex async_mutex_;
+    std::condition_variable async_cv_;
+    size_t inflight_runs_ = 0;
+    
+    // 张量并行：各rank的会话共用一个通信组；协调会话的图只保留输入输出，自己不执行
+    std::shared_ptr<CollectiveGroup> tensor_parallel_group_;
+    std::vector<std::unique_ptr<InferenceSession>> tensor_parallel_ranks_;
+    // 流水线并行：各阶段的会话由执行器持有；协调会话的图同样只保留输入输出
+    std::unique_ptr<PipelineParallelExecutor> pipeline_parallel_;
+    
+    // 下一次LoadAndOptimizeGraph的图已经优化过（来自共享内存发布的模型）
+    bool graph_preoptimized_ = false;
+    // EstimateMemory创建的会话：内存规划之后填写估计并结束加载
+    MemoryEstimate* memory_estimate_ = nullptr;
+    std::vector<Shape> estimate_input_shapes_;
+    // 最近一次Profile的内存时间线，EndProfiling时写出
+    MemoryTimeline last_memory_timeline_;
+    
+    std::vector<std::pair<std::string, double>> load_stage_timings_;
+    
+    // Warmup成功完成，LoadModelFromGraph时复位
+    std::atomic<bool> warm_{false};
 };
 
 } // namespace inferunity
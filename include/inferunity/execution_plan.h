@@ -0,0 +1,301 @@
+#pragma once
+
+// 执行计划
+// 参考ONNX Runtime的SequentialExecutionPlan：加载模型时一次性确定节点顺序、
+// 每个节点的执行提供者、值的整数槽位以及中间张量的释放点，运行时只按数组顺序执行
+
+#include "types.h"
+#include "backend.h"
+#include "memory_planner.h"
+#include "metrics.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class Node;
+class Value;
+
+// 单个执行步骤
+struct ExecutionStep {
+    Node* node = nullptr;
+    ExecutionProvider* provider = nullptr;
+    std::vector<int> input_slots;
+    std::vector<int> output_slots;
+    std::vector<int> release_slots;  // 本步骤之后不再被使用的中间张量
+    // 多流执行：步骤所在的流（0为默认流）、执行前需要等待的其他流上的步骤，
+    // 以及执行后是否记录事件供其他流等待；提供者不支持多流时stream恒为0
+    int stream = 0;
+    std::vector<int> wait_steps;
+    bool record_event = false;
+    // 视图步骤：CPU上只改布局的算子且输出不是图输出时，运行时直接构造输出视图（见Operator::IsViewOperator），
+    // 做不成视图时照常执行
+    std::shared_ptr<Operator> view_op;
+    // 形状计算步骤：绑定输入时由ShapeProgram在主机上求值，执行时跳过，不派发给提供者
+    bool host_shape = false;
+    // 按算子类型累计的耗时与次数（常驻指标），构建计划时取得
+    const OpMetrics* op_metrics = nullptr;
+};
+
+struct ExecutionPlanOptions {
+    // 节点顺序（为空时使用拓扑排序）
+    std::vector<Node*> node_order;
+    // 在最后一个消费者之后释放动态分配的中间张量，降低峰值内存
+    bool release_intermediates = true;
+    // 不释放的值（例如已绑定到内存规划arena的视图，跨运行复用）
+    std::unordered_set<const Value*> persistent_values;
+    // 图分区给出的节点到提供者的分配，未列出的节点使用ExecutionProviderSelector
+    std::unordered_map<const Node*, ExecutionProvider*> node_providers;
+    // 支持多流的提供者上最多使用的流数，1表示全部在默认流上顺序执行
+    int num_streams = 1;
+    // 只计算这些图输出（为空时计算全部）：计划只包含它们的祖先节点，输出槽位按给出的顺序
+    std::vector<const Value*> output_values;
+    // 把只计算形状的节点（Shape及其后的Gather/Slice/Concat/算术）从计划中分出来，绑定输入时在主机上求值
+    bool host_shape_evaluation = true;
+};
+
+// 形状计算分区（参考TensorRT的shape tensor与ONNX Runtime在CPU上执行形状子图的做法）：
+// 动态形状的模型里Shape -> Gather -> Concat -> Reshape这类链无法常量折叠，每次运行都要在几个INT64元素上
+// 执行真正的内核，设备提供者上还会引入同步。构建计划时找出只依赖输入形状与小整数常量的节点，
+// 编译成寄存器形式的指令；每次绑定输入后用标量解释器求出它们的值，计划中的这些步骤不再执行。
+// 中间值的维度取自形状推断给出的符号表达式，运行时按图输入的实际维度求值
+class ShapeProgram {
+public:
+    // 标记steps中可在主机上求值的步骤（host_shape）并编译；没有这样的步骤时返回nullptr
+    static std::unique_ptr<ShapeProgram> Build(const std::vector<Value*>& values,
+                                               const std::vector<int>& input_slots,
+                                               const std::vector<bool>& is_graph_output,
+                                               std::vector<ExecutionStep>* steps);
+    
+    // 按本次的图输入求值，outputs[i]对应GetOutputSlots()[i]；下标越界、除零等错误与对应内核一致地报错
+    Status Evaluate(const std::vector<Tensor*>& inputs, std::vector<std::shared_ptr<Tensor>>* outputs) const;
+    
+    // 被计划中其他步骤读取的形状值的槽位
+    const std::vector<int>& GetOutputSlots() const { return output_slots_; }
+    size_t GetNumNodes() const { return num_nodes_; }
+
+private:
+    enum class OpCode { SHAPE, GATHER, CONCAT, SLICE, CAST, ADD, SUB, MUL, DIV, MAX, MIN };
+    
+    // 系数乘以若干图输入维度之积
+    struct DimTerm {
+        int64_t coefficient = 1;
+        std::vector<std::pair<int, int>> factors;  // (图输入下标, 维度)
+    };
+    
+    // 秩不超过1的整数值
+    struct Register {
+        int rank = 1;
+        std::vector<int64_t> data;
+    };
+    
+    struct Instruction {
+        OpCode code;
+        std::vector<int> inputs;       // 寄存器；SLICE为data, starts, ends, axes, steps
+        int output = -1;
+        DataType dtype = DataType::INT64;
+        std::vector<DimTerm> dims;     // SHAPE
+    };
+    
+    struct Output {
+        int reg = -1;
+        DataType dtype = DataType::INT64;
+        DeviceType device = DeviceType::CPU;  // 读取它的步骤所在的设备
+    };
+    
+    ShapeProgram() = default;
+    
+    std::vector<Register> initial_;            // 常量寄存器的初值，其余为空
+    std::vector<Instruction> instructions_;
+    std::vector<Output> outputs_;
+    std::vector<int> output_slots_;
+    size_t num_nodes_ = 0;
+};
+
+// 加载后不可变；图结构变化后需要重新构建
+class ExecutionPlan {
+public:
+    static Status Build(const Graph* graph,
+                        const std::vector<ExecutionProvider*>& providers,
+                        const ExecutionPlanOptions& options,
+                        std::unique_ptr<ExecutionPlan>* plan);
+    
+    const Graph* GetGraph() const { return graph_; }
+    const std::vector<ExecutionStep>& GetSteps() const { return steps_; }
+    
+    // 槽位 -> Value
+    const std::vector<Value*>& GetValues() const { return values_; }
+    const std::vector<int>& GetInputSlots() const { return input_slots_; }
+    const std::vector<int>& GetOutputSlots() const { return output_slots_; }
+    
+    // Value的槽位，不在计划中时返回-1
+    int GetSlot(const Value* value) const;
+    
+    std::vector<Node*> GetNodeOrder() const;
+    
+    // 实际用到的流数
+    int GetNumStreams() const { return num_streams_; }
+    
+    // 形状计算分区，没有在主机上求值的步骤时为nullptr
+    const ShapeProgram* GetShapeProgram() const { return shape_program_.get(); }
+
+private:
+    ExecutionPlan() = default;
+    
+    const Graph* graph_ = nullptr;
+    std::vector<ExecutionStep> steps_;
+    std::vector<Value*> values_;
+    std::unordered_map<const Value*, int> slot_of_;
+    std::vector<int> input_slots_;
+    std::vector<int> output_slots_;
+    int num_streams_ = 1;
+    std::unique_ptr<ShapeProgram> shape_program_;
+};
+
+// 权重流式驻留（模型权重大于内存时，参考llama.cpp的mmap加载与DeepSpeed ZeRO-Inference的逐层预取）：
+// 只处理模型文件映射的常量视图（不持有数据的张量），它们的页可以被内核丢弃后重新读盘。
+// 每个权重在首次使用它的步骤之前预取，在最后一次使用它的步骤之后回收页；
+// 执行第i步前预取到第i + lookahead_steps步为止，已预取未回收的权重不超过budget_bytes
+// （单个步骤的权重超过预算时该步骤仍照常预取）。加载后不可变，多个运行可以同时使用
+struct WeightStreamingOptions {
+    size_t budget_bytes = 0;
+    int lookahead_steps = 2;
+};
+
+class WeightStreamingSchedule {
+public:
+    struct Region {
+        const void* data = nullptr;
+        size_t size = 0;
+        size_t first_step = 0;  // 首次使用该权重的步骤
+    };
+    
+    WeightStreamingSchedule(const ExecutionPlan& plan, const WeightStreamingOptions& options);
+    
+    const ExecutionPlan& GetPlan() const { return *plan_; }
+    const WeightStreamingOptions& GetOptions() const { return options_; }
+    // 第step步首次使用的权重与其字节数、在第step步之后不再使用的权重
+    const std::vector<Region>& GetLoads(size_t step) const { return loads_[step]; }
+    size_t GetLoadBytes(size_t step) const { return load_bytes_[step]; }
+    const std::vector<Region>& GetReleases(size_t step) const { return releases_[step]; }
+    // 可流式驻留的权重总字节数
+    size_t GetTotalBytes() const { return total_bytes_; }
+
+private:
+    const ExecutionPlan* plan_ = nullptr;
+    WeightStreamingOptions options_;
+    std::vector<std::vector<Region>> loads_;
+    std::vector<size_t> load_bytes_;
+    std::vector<std::vector<Region>> releases_;
+    size_t total_bytes_ = 0;
+};
+
+// 一次运行（或其中[begin, end)的步骤）的滑动窗口：BeforeStep发出预取（madvise(MADV_WILLNEED)，内核异步读盘，
+// 第i步计算时后面的权重已在读入），AfterStep回收最后一次使用的权重；schedule属于其他计划时什么也不做
+class WeightStreamingWindow {
+public:
+    WeightStreamingWindow(const WeightStreamingSchedule* schedule, const ExecutionPlan& plan,
+                          size_t begin, size_t end);
+    
+    void BeforeStep(size_t step);
+    void AfterStep(size_t step);
+    
+    // 已预取未回收的权重字节数及其峰值
+    size_t GetResidentBytes() const { return resident_bytes_; }
+    size_t GetPeakResidentBytes() const { return peak_resident_bytes_; }
+
+private:
+    const WeightStreamingSchedule* schedule_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t next_ = 0;  // 下一个待预取的步骤
+    size_t resident_bytes_ = 0;
+    size_t peak_resident_bytes_ = 0;
+};
+
+// 跨节点的权重预取（参考TVM的prefetch调度与ONNX Runtime的weight prefetch讨论）：执行计划固定，
+// 第i步执行期间由辅助线程预取之后lookahead_steps步用到的CPU常量——文件映射的视图先madvise(MADV_WILLNEED)
+// 让内核异步读盘，再对开头最多cache_bytes_per_step字节发出软件预取，把它们带进共享的末级缓存。
+// 只是提示，不改变执行结果；执行线程只更新目标步骤，不等待预取完成
+struct WeightPrefetchOptions {
+    int lookahead_steps = 1;
+    size_t cache_bytes_per_step = size_t(1) << 20;
+};
+
+class WeightPrefetcher {
+public:
+    WeightPrefetcher(const ExecutionPlan& plan, const WeightPrefetchOptions& options);
+    ~WeightPrefetcher();
+    
+    WeightPrefetcher(const WeightPrefetcher&) = delete;
+    WeightPrefetcher& operator=(const WeightPrefetcher&) = delete;
+    
+    // 执行第step步之前调用：辅助线程随后预取(step, step + lookahead_steps]的权重，已落后的步骤直接跳过；
+    // plan不是构建时的计划时什么也不做
+    void Advance(const ExecutionPlan& plan, size_t step);
+    
+    // 辅助线程已处理的步骤数与发出的字节数（统计用）
+    size_t GetPrefetchedSteps() const { return prefetched_steps_.load(std::memory_order_relaxed); }
+    size_t GetPrefetchedBytes() const { return prefetched_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    struct Region {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;  // 不持有数据的视图（可能不在内存中）
+    };
+    
+    void PrefetchStep(size_t step);
+    void Loop();
+    
+    const ExecutionPlan* plan_ = nullptr;
+    WeightPrefetchOptions options_;
+    std::vector<std::vector<Region>> regions_;  // 每个步骤的常量输入
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t next_ = 0;    // 下一个待预取的步骤
+    size_t target_ = 0;  // 预取到该步骤之前为止
+    bool stop_ = false;
+    std::atomic<size_t> prefetched_steps_{0};
+    std::atomic<size_t> prefetched_bytes_{0};
+    std::thread thread_;
+};
+
+// 单次运行的可变状态（参考ONNX Runtime的ExecutionFrame）：每个槽位的张量与自己的激活arena。
+// 图、计划和权重只读共享，不同的ExecutionState可以在多个线程上同时执行同一个计划
+class ExecutionState {
+public:
+    // 常量槽位沿用Value上的张量（权重不复制）；memory_plan不为空时，
+    // 规划内的值按相同偏移绑定到本状态自己的arena（account不为空时记入该账户，huge_pages见MemoryArena::Create）
+    static Status Create(const ExecutionPlan& plan, const MemoryPlan* memory_plan,
+                         std::unique_ptr<ExecutionState>* state,
+                         std::shared_ptr<MemoryAccount> account = nullptr,
+                         HugePagePolicy huge_pages = HugePagePolicy::NONE);
+    
+    const ExecutionPlan& GetPlan() const { return *plan_; }
+    // 槽位 -> 张量
+    std::vector<std::shared_ptr<Tensor>>& GetTensors() { return tensors_; }
+    size_t GetArenaSize() const { return arena_ ? arena_->GetSize() : 0; }
+    
+    // 调用方预先分配的输出缓冲（IOBinding）：执行时直接写入，推断出的形状与之不符时报错
+    void BindOutput(int slot, std::shared_ptr<Tensor> tensor);
+    const std::shared_ptr<Tensor>& GetBoundOutput(int slot) const { return bound_[slot]; }
+    void ClearBoundOutputs();
+
+private:
+    ExecutionState() = default;
+    
+    const ExecutionPlan* plan_ = nullptr;
+    std::vector<std::shared_ptr<Tensor>> tensors_;
+    std::vector<std::shared_ptr<Tensor>> bound_;
+    std::shared_ptr<MemoryArena> arena_;
+};
+
+} // namespace inferunity
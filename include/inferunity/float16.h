@@ -0,0 +1,132 @@
+#pragma once
+
+// 半精度浮点的标量转换（参考ONNX Runtime的MLFloat16/BFloat16）：
+// FLOAT16为IEEE 754 binary16，BFLOAT16为FP32的高16位；FP32转半精度就近舍入到偶数，
+// 溢出为无穷大，NaN保持为静默NaN。批量转换见simd_utils.h的Convert*SIMD
+// FP8为OCP的E4M3（指数偏置7、3位尾数、没有无穷大，最大有限值448），转换时饱和到±448，用于量化的KV cache
+
+#include <cstdint>
+#include <cstring>
+
+namespace inferunity {
+
+inline float HalfToFloat(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // 非规格化数：左移到隐含位后调整指数
+        uint32_t e = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --e;
+        }
+        bits = sign | (e << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline uint16_t FloatToHalf(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t abs = bits & 0x7FFFFFFFu;
+    if (abs >= 0x7F800000u) {
+        return static_cast<uint16_t>(sign | (abs > 0x7F800000u ? 0x7E00u : 0x7C00u));
+    }
+    if (abs >= 0x477FF000u) {  // 舍入后超过65504
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (abs < 0x38800000u) {
+        // 结果为非规格化数或0：按2^-24的步长舍入
+        if (abs < 0x33000000u) {
+            return sign;
+        }
+        const uint32_t shift = 126u - (abs >> 23);
+        const uint32_t mantissa = (abs & 0x7FFFFFu) | 0x800000u;
+        uint32_t value = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t half = 1u << (shift - 1u);
+        if (remainder > half || (remainder == half && (value & 1u))) {
+            ++value;
+        }
+        return static_cast<uint16_t>(sign | value);
+    }
+    const uint32_t rounded = abs + 0xFFFu + ((abs >> 13) & 1u);
+    return static_cast<uint16_t>(sign | ((rounded - 0x38000000u) >> 13));
+}
+
+inline float BFloat16ToFloat(uint16_t b) {
+    const uint32_t bits = static_cast<uint32_t>(b) << 16;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline uint16_t FloatToBFloat16(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<uint16_t>((bits >> 16) | 0x40u);
+    }
+    return static_cast<uint16_t>((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+}
+
+constexpr float kFp8E4M3Max = 448.0f;
+
+inline float Fp8E4M3ToFloat(uint8_t v) {
+    const uint32_t sign = static_cast<uint32_t>(v & 0x80u) << 24;
+    const uint32_t exponent = (v >> 3) & 0xFu;
+    const uint32_t mantissa = v & 0x7u;
+    uint32_t bits;
+    if (exponent == 0xFu && mantissa == 0x7u) {
+        bits = sign | 0x7FC00000u;
+    } else if (exponent == 0) {
+        // 非规格化数：mantissa * 2^-9
+        const float f = static_cast<float>(mantissa) * (1.0f / 512.0f);
+        return sign ? -f : f;
+    } else {
+        bits = sign | ((exponent + 120u) << 23) | (mantissa << 20);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline uint8_t FloatToFp8E4M3(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    const uint8_t sign = static_cast<uint8_t>((bits >> 24) & 0x80u);
+    const uint32_t abs = bits & 0x7FFFFFFFu;
+    if (abs > 0x7F800000u) {
+        return static_cast<uint8_t>(sign | 0x7Fu);
+    }
+    if (abs >= 0x43E00000u) {  // >= 448（含无穷大）
+        return static_cast<uint8_t>(sign | 0x7Eu);
+    }
+    if (abs < 0x3C800000u) {
+        // 结果为非规格化数或0：按2^-9的步长就近舍入到偶数（舍入到2^-6时恰为最小规格化数的编码）
+        float a;
+        std::memcpy(&a, &abs, sizeof(a));
+        const float units = a * 512.0f;
+        uint32_t value = static_cast<uint32_t>(units);
+        const float remainder = units - static_cast<float>(value);
+        if (remainder > 0.5f || (remainder == 0.5f && (value & 1u))) {
+            ++value;
+        }
+        return static_cast<uint8_t>(sign | value);
+    }
+    const uint32_t rounded = abs + 0x7FFFFu + ((abs >> 20) & 1u);
+    return static_cast<uint8_t>(sign | ((rounded - (120u << 23)) >> 20));
+}
+
+} // namespace inferunity
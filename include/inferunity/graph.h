@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include "tensor.h"
+#include "op_type.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -11,6 +12,7 @@
 namespace inferunity {
 
 // 前向声明
+class Graph;
 class Node;
 class Value;
 
@@ -21,50 +23,127 @@ public:
     explicit Value(int64_t id) : id_(id), tensor_(nullptr), producer_(nullptr) {}
     
     int64_t GetId() const { return id_; }
-    void SetId(int64_t id) { id_ = id; }
+    // 属于某个Graph时同时更新其id/名称索引
+    void SetId(int64_t id);
     
     const std::string& GetName() const { return name_; }
-    void SetName(const std::string& name) { name_ = name; }
+    void SetName(const std::string& name);
     
     std::shared_ptr<Tensor> GetTensor() const { return tensor_; }
-    void SetTensor(std::shared_ptr<Tensor> tensor) { tensor_ = tensor; }
+    void SetTensor(std::shared_ptr<Tensor> tensor) {
+        tensor_ = tensor;
+        tensor_shared_ = false;
+    }
+    // 写时复制（见Graph::Clone）：张量与其他图共享时先换成自己的副本再返回，之后可以原地修改。
+    // 原地改写常量数据的代码须经此取得张量；只替换张量指针的改写（多数Pass）直接用SetTensor
+    std::shared_ptr<Tensor> GetMutableTensor();
+    // 张量是否可能被其他图引用：Clone后原图与副本共享的常量都处于此状态，直到换成自己的张量
+    bool IsTensorShared() const { return tensor_shared_; }
     
     const Shape& GetShape() const;
     DataType GetDataType() const;
     
     Node* GetProducer() const { return producer_; }
-    void SetProducer(Node* node) { producer_ = node; }
+    void SetProducer(Node* node);
     
     const std::vector<Node*>& GetConsumers() const { return consumers_; }
     void AddConsumer(Node* node);
     void RemoveConsumer(Node* node);
-    
+
 private:
+    friend class Graph;
+    
     int64_t id_;
     std::string name_;  // 值名称（用于输入输出映射）
     std::shared_ptr<Tensor> tensor_;
+    bool tensor_shared_ = false;
     Node* producer_;
     std::vector<Node*> consumers_;
+    Graph* graph_ = nullptr;  // 所属图
+    size_t slot_ = 0;         // 在所属图values_中的下标
+    bool removed_ = false;    // 墓碑：已从图中删除，等待压缩
+};
+
+// 算子属性值（支持多种类型，对应ONNX的AttributeProto）
+class AttributeValue {
+public:
+    enum class Type {
+        FLOAT,
+        INT,
+        STRING,
+        FLOATS,
+        INTS,
+        TENSOR,
+        GRAPH
+    };
+    
+    AttributeValue() : type_(Type::FLOAT) {}
+    explicit AttributeValue(float v) : type_(Type::FLOAT), float_val_(v) {}
+    explicit AttributeValue(int64_t v) : type_(Type::INT), int_val_(v) {}
+    explicit AttributeValue(const std::string& v) : type_(Type::STRING), string_val_(v) {}
+    explicit AttributeValue(const std::vector<float>& v) : type_(Type::FLOATS), floats_val_(v) {}
+    explicit AttributeValue(const std::vector<int64_t>& v) : type_(Type::INTS), ints_val_(v) {}
+    // 张量属性（如Constant的value）：共享张量，复制属性不复制数据
+    explicit AttributeValue(std::shared_ptr<Tensor> v) : type_(Type::TENSOR), tensor_val_(std::move(v)) {}
+    // 子图属性（If的分支、Loop/Scan的循环体）：同样共享，子图引用的外层值已作为其末尾的图输入
+    // （同时是节点末尾的输入，个数记在节点的num_implicit_inputs属性中，见ONNX解析器）
+    explicit AttributeValue(std::shared_ptr<Graph> v) : type_(Type::GRAPH), graph_val_(std::move(v)) {}
+    
+    Type GetType() const { return type_; }
+    float GetFloat() const { return float_val_; }
+    int64_t GetInt() const { return int_val_; }
+    const std::string& GetString() const { return string_val_; }
+    const std::vector<float>& GetFloats() const { return floats_val_; }
+    const std::vector<int64_t>& GetInts() const { return ints_val_; }
+    const std::shared_ptr<Tensor>& GetTensor() const { return tensor_val_; }
+    const std::shared_ptr<Graph>& GetGraph() const { return graph_val_; }
+    
+    // 文本形式（用于DOT/文本序列化和按字符串比较的图匹配）：列表以逗号连接，
+    // 浮点数保留可往返的精度且总带小数点，张量与子图为空串
+    std::string ToString() const;
+    
+    bool operator==(const AttributeValue& other) const;
+    bool operator!=(const AttributeValue& other) const { return !(*this == other); }
+
+private:
+    Type type_;
+    float float_val_ = 0.0f;
+    int64_t int_val_ = 0;
+    std::string string_val_;
+    std::vector<float> floats_val_;
+    std::vector<int64_t> ints_val_;
+    std::shared_ptr<Tensor> tensor_val_;
+    std::shared_ptr<Graph> graph_val_;
 };
 
+// 文本属性 -> AttributeValue（整串解析，避免"1e-05"被截成整数1）：
+// 单个整数为INT，单个数值为FLOAT，逗号分隔的整数/数值为INTS/FLOATS，其余为STRING
+AttributeValue ParseNodeAttribute(const std::string& value);
+
 // 节点属性（键值对）
-using NodeAttributes = std::unordered_map<std::string, std::string>;
+using NodeAttributes = std::unordered_map<std::string, AttributeValue>;
 
 // 计算节点
 class Node {
 public:
-    Node() : id_(-1), op_type_(""), name_("") {}
+    Node() : id_(-1), op_type_(""), op_type_id_(InternOpType("")), name_("") {}
     Node(int64_t id, const std::string& op_type, const std::string& name = "")
-        : id_(id), op_type_(op_type), name_(name) {}
+        : id_(id), op_type_(op_type), op_type_id_(InternOpType(op_type)), name_(name) {}
     
     int64_t GetId() const { return id_; }
-    void SetId(int64_t id) { id_ = id; }
+    // 属于某个Graph时同时更新其id/名称索引
+    void SetId(int64_t id);
     
     const std::string& GetOpType() const { return op_type_; }
-    void SetOpType(const std::string& op_type) { op_type_ = op_type; }
+    // 驻留的类型ID（见op_type.h），按类型比较或查表时代替字符串
+    OpTypeId GetOpTypeId() const { return op_type_id_; }
+    void SetOpType(const std::string& op_type) {
+        op_type_ = op_type;
+        op_type_id_ = InternOpType(op_type);
+    }
     
     const std::string& GetName() const { return name_; }
-    void SetName(const std::string& name) { name_ = name; }
+    void SetName(const std::string& name);
     
     // 输入输出
     const std::vector<Value*>& GetInputs() const { return inputs_; }
@@ -73,29 +152,48 @@ public:
     void AddInput(Value* value);
     void AddOutput(Value* value);
     void RemoveInput(Value* value);
+    // 把输入中的old_value换成new_value，保持输入顺序
+    void ReplaceInput(Value* old_value, Value* new_value);
     void RemoveOutput(Value* value);
     
     // 属性
     const NodeAttributes& GetAttributes() const { return attributes_; }
+    void SetAttribute(const std::string& key, const AttributeValue& value);
+    // 文本形式的便捷接口：按ParseNodeAttribute的规则存为类型化的值
     void SetAttribute(const std::string& key, const std::string& value);
+    void SetAttribute(const std::string& key, const char* value) { SetAttribute(key, std::string(value)); }
+    // 属性的ToString()，不存在时返回default_value
     std::string GetAttribute(const std::string& key, const std::string& default_value = "") const;
+    // 类型化读取，不存在时返回nullptr
+    const AttributeValue* FindAttribute(const std::string& key) const;
     bool HasAttribute(const std::string& key) const;
     
     // 设备分配
     DeviceType GetDevice() const { return device_; }
     void SetDevice(DeviceType device) { device_ = device; }
-    
+
 private:
+    friend class Graph;
+    friend class Value;
+    
     int64_t id_;
     std::string op_type_;
+    OpTypeId op_type_id_;
     std::string name_;
     std::vector<Value*> inputs_;
     std::vector<Value*> outputs_;
     NodeAttributes attributes_;
     DeviceType device_;
+    Graph* graph_ = nullptr;  // 所属图
+    size_t slot_ = 0;         // 在所属图nodes_中的下标，拓扑排序等按下标使用稠密数组
+    size_t topo_rank_ = 0;    // 在所属图缓存的拓扑序中的位置
+    bool removed_ = false;    // 墓碑：已从图中删除，等待压缩
 };
 
 // 计算图
+// 节点与值按添加顺序存放，id与名称各有哈希索引，查找为O(1)；删除只断开连接并留下墓碑（O(1)），
+// 墓碑在下次GetNodes()/GetValues()或Compact()时一次性压缩，其余元素保持原有顺序。
+// 压缩发生在const访问中，图被多个线程并发读取前应先调用Compact()
 class Graph {
 public:
     Graph();
@@ -105,36 +203,54 @@ public:
     Graph(const Graph&) = delete;
     Graph& operator=(const Graph&) = delete;
     
-    // 允许移动
-    Graph(Graph&&) = default;
-    Graph& operator=(Graph&&) = default;
+    // 允许移动（节点与值改为指向新的Graph）
+    Graph(Graph&& other) noexcept;
+    Graph& operator=(Graph&& other) noexcept;
     
     // 节点管理
     Node* AddNode(const std::string& op_type, const std::string& name = "");
     Node* GetNode(int64_t id) const;
+    // 同名时返回最早添加的节点
     Node* GetNodeByName(const std::string& name) const;
     void RemoveNode(Node* node);
-    const std::vector<std::unique_ptr<Node>>& GetNodes() const { return nodes_; }
+    const std::vector<std::unique_ptr<Node>>& GetNodes() const { Compact(); return nodes_; }
     
     // 值管理
     Value* AddValue();
     Value* GetValue(int64_t id) const;
+    // 依次在图输入、图输出、全部值中查找，同名时返回最早添加的值
     Value* FindValueByName(const std::string& name) const;
     void RemoveValue(Value* value);
-    const std::vector<std::unique_ptr<Value>>& GetValues() const { return values_; }
+    const std::vector<std::unique_ptr<Value>>& GetValues() const { Compact(); return values_; }
+    
+    // 释放墓碑并重排下标
+    void Compact() const;
     
     // 输入输出
     void AddInput(Value* value);
     void AddOutput(Value* value);
+    // 把图输入或图输出中的old_value换成new_value，保持顺序
+    void ReplaceInput(Value* old_value, Value* new_value);
+    void ReplaceOutput(Value* old_value, Value* new_value);
     const std::vector<Value*>& GetInputs() const { return inputs_; }
     const std::vector<Value*>& GetOutputs() const { return outputs_; }
     
     // 图操作
     void Clear();
-    Graph Clone() const;  // 深拷贝
+    // 复制图结构：常量（没有生产者、带数据的值）的张量按引用共享，不复制权重，原图与副本的这些值
+    // 都标记为共享，原地修改前经Value::GetMutableTensor复制；其余的值只复制形状、类型与布局，
+    // 副本上的形状推断、优化与执行不影响原图
+    Graph Clone() const;
     
-    // 拓扑排序
+    // 拓扑排序：同时就绪的节点按其在节点列表中的顺序输出，节点已按拓扑序存放时结果就是存放顺序
     std::vector<Node*> TopologicalSort() const;
+    // 把节点列表重排为order（须是图中全部节点的一个排列），之后TopologicalSort按此顺序输出，
+    // 序列化也按此顺序写出；用于执行顺序调度（见MemoryAwareSchedulingPass）
+    Status ReorderNodes(const std::vector<Node*>& order);
+    // 增量维护的拓扑序 (参考Pearce-Kelly动态拓扑排序)：首次调用时计算，之后新增节点追加到末尾，
+    // 新增的边只在违反当前顺序时重排两端之间受影响的区间，删除不会破坏顺序；
+    // 与TopologicalSort()一样返回副本，遍历时可以修改图。图中有环时每次回退为完整排序
+    std::vector<Node*> GetTopologicalOrder() const;
     
     // 验证
     Status Validate() const;
@@ -145,10 +261,68 @@ public:
     
     // 可视化（生成DOT格式）
     std::string ToDot() const;
-    
+
 private:
-    std::vector<std::unique_ptr<Node>> nodes_;
-    std::vector<std::unique_ptr<Value>> values_;
+    friend class Node;
+    friend class Value;
+    
+    // 键 -> 最早添加的元素；存在重复键时，删除或改名会使索引过期，下次查找时按添加顺序整表重建
+    template <typename Key, typename T>
+    class LookupIndex {
+    public:
+        // appended为true表示item是最后添加的元素，重复键时保留已有的更早元素即可
+        void Insert(const Key& key, T* item, bool appended) {
+            if (!items_.emplace(key, item).second) {
+                has_duplicates_ = true;
+                stale_ = stale_ || !appended;
+            }
+        }
+        void Erase(const Key& key, const T* item) {
+            auto it = items_.find(key);
+            if (it != items_.end() && it->second == item) {
+                items_.erase(it);
+                stale_ = stale_ || has_duplicates_;
+            }
+        }
+        template <typename Rebuild>
+        T* Find(const Key& key, Rebuild&& rebuild) {
+            if (stale_) {
+                Clear();
+                rebuild(*this);
+            }
+            auto it = items_.find(key);
+            return it != items_.end() ? it->second : nullptr;
+        }
+        void Clear() {
+            items_.clear();
+            has_duplicates_ = false;
+            stale_ = false;
+        }
+    
+    private:
+        std::unordered_map<Key, T*> items_;
+        bool has_duplicates_ = false;
+        bool stale_ = false;
+    };
+    
+    // 由Node/Value::SetId/SetName在修改前调用
+    void OnNodeKeyChanged(Node* node, int64_t new_id, const std::string& new_name);
+    void OnValueKeyChanged(Value* value, int64_t new_id, const std::string& new_name);
+    void AdoptElements();  // 移动后把节点与值的所属图指向this
+    // 由Value在新增from -> to的边后调用（通知to所属的图）
+    void OnEdgeAdded(Node* from, Node* to);
+    void ReorderTopological(Node* from, Node* to);
+    
+    mutable std::vector<std::unique_ptr<Node>> nodes_;
+    mutable std::vector<std::unique_ptr<Value>> values_;
+    mutable size_t removed_nodes_ = 0;   // nodes_中的墓碑数
+    mutable size_t removed_values_ = 0;  // values_中的墓碑数
+    mutable LookupIndex<int64_t, Node> node_ids_;
+    mutable LookupIndex<std::string, Node> node_names_;  // 不含空名称
+    mutable LookupIndex<int64_t, Value> value_ids_;
+    mutable LookupIndex<std::string, Value> value_names_;
+    mutable std::vector<Node*> topo_order_;  // 缓存的拓扑序，可能含墓碑，压缩时一并清理
+    mutable bool topo_valid_ = false;
     std::vector<Value*> inputs_;
     std::vector<Value*> outputs_;
     int64_t next_node_id_;
@@ -0,0 +1,58 @@
+#pragma once
+
+// 算子kernel的自动调优 (参考cuDNN的cudnnFind*与TVM/ONNX Runtime的调优结果缓存)：
+// 编译节点时对每个候选算法实测耗时并选出最快的，结果按(设备型号, kernel, 形状, 数据类型)记录；
+// 缓存可以持久化到磁盘，进程重启后命中缓存的节点直接使用记录的算法，不再搜索
+
+#include "types.h"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+struct TuningRecord {
+    int algorithm = -1;          // 后端定义的算法编号
+    double time_us = 0.0;        // 调优时测得的耗时
+    size_t workspace_bytes = 0;  // 算法需要的临时空间
+};
+
+class KernelTuningCache {
+public:
+    // 缓存键；各字段中的分隔符会被替换，保证一行一条记录
+    static std::string MakeKey(const std::string& device, const std::string& kernel,
+                               const std::string& signature, DataType dtype);
+    
+    bool Lookup(const std::string& key, TuningRecord* record) const;
+    void Insert(const std::string& key, const TuningRecord& record);
+    size_t Size() const;
+    void Clear();
+    
+    // 从文件读入记录（与已有记录合并，文件中的优先）；文件不存在不算错误
+    Status Load(const std::string& path);
+    // 写入临时文件后重命名，并发进程不会读到写了一半的缓存
+    Status Save(const std::string& path) const;
+    
+    // 设置持久化路径：立即读入，之后每次Insert都写回；空路径关闭持久化
+    Status SetPath(const std::string& path);
+    std::string GetPath() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, TuningRecord> records_;
+    std::string path_;
+};
+
+// 进程内共享的调优缓存
+KernelTuningCache& GetKernelTuningCache();
+
+// 在candidates中选出最快的算法：缓存命中且算法仍在候选中时直接返回，否则逐个调用benchmark
+// （给出time_us与workspace_bytes，返回错误表示该算法不可用）并把结果写入缓存。
+// 所有候选都不可用时返回ERROR_NOT_FOUND
+Status AutotuneKernel(const std::string& key, const std::vector<int>& candidates,
+                      const std::function<Status(int algorithm, TuningRecord* measured)>& benchmark,
+                      KernelTuningCache* cache, TuningRecord* result);
+
+} // namespace inferunity
@@ -0,0 +1,263 @@
+#pragma once
+
+// 自回归解码的KV cache
+// 参考ONNX Runtime GroupQueryAttention的past/present共享缓冲（past_present_share_buffer）
+// 与llama.cpp的序列操作（llama_kv_cache_seq_rm/seq_cp）：
+// 每层预分配[max_batch, kv_heads, capacity, head_dim]的K/V缓冲，新位置由FusedAttention原地追加，
+// 每个token的代价与已缓存长度成线性关系，不再重复拼接前缀
+
+#include "types.h"
+#include "tensor.h"
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+
+struct KVCacheOptions {
+    int64_t max_sequence_length = 2048;  // 每个序列可缓存的位置数
+    int64_t max_batch_size = 1;          // 序列槽位数（batch维的第b个样本即第b个序列）
+    bool allocate = true;                // 为false时AddLayer只创建形状，不分配缓冲（用于内存估计）
+};
+
+// 一层注意力的缓存
+struct KVCacheLayer {
+    std::string past_key_name;      // 原图中的past输入名
+    std::string past_value_name;
+    std::string present_key_name;   // 原图中的present输出名
+    std::string present_value_name;
+    std::shared_ptr<Tensor> key;      // [max_batch, kv_heads, capacity, key_dim]
+    std::shared_ptr<Tensor> value;    // [max_batch, kv_heads, capacity, value_dim]
+    std::shared_ptr<Tensor> lengths;  // INT64 [max_batch]，每个序列已缓存的位置数
+};
+
+class KVCache {
+public:
+    explicit KVCache(const KVCacheOptions& options = KVCacheOptions());
+    
+    const KVCacheOptions& GetOptions() const { return options_; }
+    int64_t GetCapacity() const { return options_.max_sequence_length; }
+    
+    // 添加一层并分配缓冲
+    Status AddLayer(int64_t kv_heads, int64_t key_dim, int64_t value_dim, KVCacheLayer** layer);
+    size_t GetNumLayers() const { return layers_.size(); }
+    const KVCacheLayer& GetLayer(size_t index) const { return layers_[index]; }
+    // 各层缓存与长度的总字节数（不分配时也按形状计算）
+    size_t GetMemoryBytes() const;
+    
+    // 序列seq已缓存的位置数（各层一致）
+    int64_t GetSequenceLength(int64_t seq) const;
+    
+    // 清空所有序列
+    void Reset();
+    // 清空单个序列
+    Status Reset(int64_t seq);
+    // 截断到length个位置（投机解码回退、重新生成最后若干token），不移动数据
+    Status Trim(int64_t seq, int64_t length);
+    // 把src的已缓存前缀复制到dst（beam search、并行采样共享prompt）
+    Status Fork(int64_t src, int64_t dst);
+
+private:
+    Status CheckSequence(int64_t seq) const;
+    void SetLength(int64_t seq, int64_t length);
+    
+    KVCacheOptions options_;
+    std::vector<KVCacheLayer> layers_;
+};
+
+// 把图中的KV cache改写为共享缓冲形式：
+// K/V由Concat(past, new)沿序列维产生的FusedAttention改为kv_cache=1，
+// past输入与present输出从图中移除，由cache中的缓冲与长度张量代替。
+// past只被该Concat使用、present只被该注意力使用（或为图输出）时才改写；没有可改写的层时返回错误
+Status BindKVCache(Graph* graph, KVCache* cache);
+
+// 分页KV cache（参考vLLM的PagedAttention与BlockSpaceManager）：
+// 存储按block_size个位置切成固定大小的块，每块从内存池（memory_pool.cpp）分配，
+// 依次存放各层的K [kv_heads, block_size, key_dim]与V [kv_heads, block_size, value_dim]。
+// 每个序列持有一张块表（逻辑块 -> 物理块），长度不同的序列只占用各自所需的块；
+// Fork让新序列共享源序列的全部块（引用计数），写入共享的未满块时先复制（copy-on-write）
+//
+// 前缀缓存（参考vLLM的automatic prefix caching）：写满的块按(前一块的哈希, 块内token)的链式哈希登记，
+// 引用归零后仍保留内容，按LRU放在可回收列表中；之后prompt前缀相同的序列直接引用这些块，
+// 只需prefill剩余的部分。块不足时先用空闲块，再在max_blocks以内分配新块，最后回收最久未用的缓存块
+//
+// 量化存储（参考vLLM的kv_cache_dtype与TensorRT-LLM的INT8/FP8 KV cache）：每个(头, 位置)的键、值向量各带
+// 一个FP32缩放，INT8为对称量化（scale = max|x| / 127），FP8为E4M3（scale = max|x| / 448）。
+// 注意力写入新位置时量化，读取时按键值分块反量化，KV内存与注意力读取的字节数约为FP32的1/4
+//
+// 换出与换入（参考vLLM的swap_space与CacheEngine::swap_in/swap_out）：max_blocks限定的块池满时，
+// 暂停的序列可以把全部块换出到另一块至多max_swap_blocks个块的主机交换区，释放的块立即可供其他序列使用；
+// 之后换回新的块，从原来的长度继续，不必重新prefill。拷贝由缓存自己的拷贝流（一个辅助线程）
+// 按提交顺序异步执行：换出的源块在拷贝完成前不会被重新分配，换入的块在WaitForSwaps之后才能读取
+enum class KVCacheStorage {
+    FLOAT32,
+    INT8,
+    FP8_E4M3
+};
+
+struct PagedKVCacheOptions {
+    int64_t block_size = 16;  // 每块的位置数
+    int64_t max_blocks = 0;   // 物理块上限（KV内存预算），0表示不限制
+    bool enable_prefix_caching = false;
+    KVCacheStorage storage = KVCacheStorage::FLOAT32;
+    int64_t max_swap_blocks = 0;  // 交换区的块数，0表示不支持换出
+};
+
+// 一个位置的键或值（dim个float）按存储格式写入dst：FLOAT32时原样拷贝，量化时同时写入*scale
+void QuantizeKVRow(KVCacheStorage storage, const float* src, int64_t dim, uint8_t* dst, float* scale);
+// rows个连续位置反量化为FP32（scales每个位置一个，FLOAT32时忽略）
+void DequantizeKVRows(KVCacheStorage storage, const uint8_t* src, const float* scales, int64_t rows,
+                      int64_t dim, float* dst);
+
+struct PrefixCacheStats {
+    uint64_t num_queries = 0;     // 带token的AddSequence次数
+    uint64_t num_hits = 0;        // 至少复用了一个块的次数
+    uint64_t queried_tokens = 0;  // 查询的prompt token总数
+    uint64_t cached_tokens = 0;   // 直接复用、不必prefill的token总数
+    uint64_t num_evictions = 0;   // 被回收的缓存块
+    
+    double GetHitRate() const {
+        return queried_tokens ? static_cast<double>(cached_tokens) / static_cast<double>(queried_tokens) : 0.0;
+    }
+};
+
+struct KVSwapStats {
+    uint64_t num_swap_outs = 0;      // 换出的序列次数
+    uint64_t num_swap_ins = 0;
+    uint64_t swapped_out_blocks = 0;
+    uint64_t swapped_in_blocks = 0;
+};
+
+class PagedKVCache {
+public:
+    explicit PagedKVCache(const PagedKVCacheOptions& options = PagedKVCacheOptions());
+    ~PagedKVCache();
+    
+    PagedKVCache(const PagedKVCache&) = delete;
+    PagedKVCache& operator=(const PagedKVCache&) = delete;
+    
+    const PagedKVCacheOptions& GetOptions() const { return options_; }
+    int64_t GetBlockSize() const { return options_.block_size; }
+    KVCacheStorage GetStorage() const { return options_.storage; }
+    // 一个物理块（含全部层的K/V与缩放）的字节数
+    size_t GetBlockBytes() const { return block_bytes_; }
+    
+    // 添加一层，须在分配任何块之前调用；返回层编号
+    Status AddLayer(int64_t kv_heads, int64_t key_dim, int64_t value_dim, size_t* layer = nullptr);
+    size_t GetNumLayers() const { return layers_.size(); }
+    int64_t GetKVHeads(size_t layer) const { return layers_[layer].kv_heads; }
+    int64_t GetKeyDim(size_t layer) const { return layers_[layer].key_dim; }
+    int64_t GetValueDim(size_t layer) const { return layers_[layer].value_dim; }
+    
+    // 序列管理
+    Status AddSequence(int64_t seq);
+    // 添加序列并按前缀缓存复用tokens开头已缓存的整块，*cached_tokens为复用的位置数（序列的初始长度）。
+    // 至少留下最后一个token不复用，使调用方总能得到最后位置的输出；未启用前缀缓存时等同AddSequence
+    Status AddSequence(int64_t seq, const std::vector<int32_t>& tokens, int64_t* cached_tokens);
+    // 登记seq的前computed个位置中写满的块（tokens为该序列的全部token），之后的序列可以复用
+    Status CachePrefix(int64_t seq, const std::vector<int32_t>& tokens, int64_t computed);
+    Status RemoveSequence(int64_t seq);
+    bool HasSequence(int64_t seq) const { return sequences_.count(seq) > 0; }
+    int64_t GetSequenceLength(int64_t seq) const;
+    const std::vector<int32_t>& GetBlockTable(int64_t seq) const;
+    
+    // 为seq追加tokens个位置：必要时分配新块，并对共享的未满末块做copy-on-write；
+    // 之后[length - tokens, length)的位置由注意力核写入。块不足时返回ERROR_OUT_OF_MEMORY且不做修改
+    Status AppendSlots(int64_t seq, int64_t tokens);
+    // 截断到length个位置，释放不再需要的块
+    Status Trim(int64_t seq, int64_t length);
+    // dst共享src的全部块（相同system prompt的前缀只存一份）；dst不能已存在
+    Status Fork(int64_t src, int64_t dst);
+    
+    // 把seq的全部块换出到交换区并释放（共享的块各换出一份私有副本），长度不变；交换区不足时返回
+    // ERROR_OUT_OF_MEMORY且不做修改。换出的序列只能SwapIn或RemoveSequence
+    Status SwapOut(int64_t seq);
+    // 为换出的seq分配新块并换回，块不足时返回ERROR_OUT_OF_MEMORY且不做修改；读取前须WaitForSwaps
+    Status SwapIn(int64_t seq);
+    bool IsSwappedOut(int64_t seq) const;
+    // 块池现在能否容纳换出的seq
+    bool CanSwapIn(int64_t seq) const;
+    // 等待已提交的换入换出全部完成
+    void WaitForSwaps();
+    size_t GetNumSwapBlocks() const { return swap_blocks_.size(); }
+    size_t GetNumFreeSwapBlocks() const;
+    const KVSwapStats& GetSwapStats() const { return swap_stats_; }
+    
+    // 物理块的某层K/V起始地址（FLOAT32存储）
+    float* GetKeyBlock(size_t layer, int32_t block) const;
+    float* GetValueBlock(size_t layer, int32_t block) const;
+    // 任意存储格式下的原始数据（布局同上，量化时每个元素1字节）与每个(头, 位置)的缩放
+    // [kv_heads, block_size]；FLOAT32存储时缩放为nullptr
+    uint8_t* GetKeyBlockData(size_t layer, int32_t block) const;
+    uint8_t* GetValueBlockData(size_t layer, int32_t block) const;
+    float* GetKeyScales(size_t layer, int32_t block) const;
+    float* GetValueScales(size_t layer, int32_t block) const;
+    
+    // 统计：已分配（含空闲）的物理块、空闲块、被多个序列共享的块
+    size_t GetNumBlocks() const { return blocks_.size(); }
+    size_t GetNumFreeBlocks() const { return free_blocks_.size(); }
+    size_t GetNumSharedBlocks() const;
+    int GetBlockRefCount(int32_t block) const { return blocks_[block].ref_count; }
+    // 已登记哈希的块（含正在使用的），其中引用为零、可被回收的块
+    size_t GetNumCachedBlocks() const { return cached_blocks_.size(); }
+    size_t GetNumEvictableBlocks() const { return evictable_.size(); }
+    const PrefixCacheStats& GetPrefixCacheStats() const { return prefix_stats_; }
+
+private:
+    struct LayerLayout {
+        int64_t kv_heads = 0;
+        int64_t key_dim = 0;
+        int64_t value_dim = 0;
+        size_t key_offset = 0;    // 在块内的字节偏移
+        size_t value_offset = 0;
+        size_t key_scale_offset = 0;  // 量化存储时缩放的字节偏移
+        size_t value_scale_offset = 0;
+    };
+    struct Block {
+        uint8_t* data = nullptr;
+        int ref_count = 0;
+        bool swap_pending = false;      // 正被拷贝流读出（换出），拷贝完成前不能重新分配
+        bool cached = false;            // 已登记在cached_blocks_中
+        uint64_t hash = 0;
+        uint64_t parent_hash = 0;       // 与tokens一起校验，防止哈希碰撞
+        std::vector<int32_t> tokens;
+        std::list<int32_t>::iterator lru;  // 引用为零时在evictable_中的位置
+    };
+    struct Sequence {
+        std::vector<int32_t> block_table;
+        std::vector<uint64_t> block_hashes;  // 开头已登记的整块的链式哈希
+        int64_t length = 0;
+        bool swapped = false;
+        std::vector<int32_t> swap_table;     // 换出时各逻辑块所在的交换区块
+    };
+    class SwapStream;
+    
+    Status AcquireBlock(int32_t* block);
+    void ReleaseBlock(int32_t block);
+    size_t AvailableBlocks() const;
+    // 从cached_blocks_中移除
+    void Uncache(int32_t block);
+    
+    PrefixCacheStats prefix_stats_;
+    std::unordered_map<uint64_t, int32_t> cached_blocks_;
+    std::list<int32_t> evictable_;  // 队首最久未用
+    
+    PagedKVCacheOptions options_;
+    std::vector<LayerLayout> layers_;
+    size_t block_bytes_ = 0;
+    std::vector<Block> blocks_;
+    std::vector<int32_t> free_blocks_;
+    std::unordered_map<int64_t, Sequence> sequences_;
+    
+    std::vector<uint8_t*> swap_blocks_;
+    std::vector<int32_t> free_swap_blocks_;
+    std::vector<int32_t> swap_pending_blocks_;  // swap_pending的块，WaitForSwaps时清除
+    KVSwapStats swap_stats_;
+    std::unique_ptr<SwapStream> swap_stream_;   // 首次换出时创建
+};
+
+} // namespace inferunity
@@ -1,17 +1,31 @@
-// 简单的日志系统框架
-// 参考ONNX Runtime和TensorFlow的日志系统设计
+// 日志系统
+// 参考ONNX Runtime和TensorFlow的日志系统设计，后端参考spdlog/NanoLog的异步模式：
+// 调用线程只把(级别, 时间戳, 源位置, 消息)写入自己的无锁环形缓冲（单生产者单消费者），
+// 时间格式化与输出由后台线程完成，文件句柄在SetFileOutput时打开一次并一直持有。
+// 低于当前级别的日志不会求值消息表达式；VERBOSE在INFERUNITY_LOG_MIN_LEVEL > 0时于编译期整体去除
+// （默认Release构建去除）。缓冲满时INFO及以下的消息被丢弃并计数，WARNING及以上改为同步写出
 
 #ifndef INFERUNITY_LOGGER_H
 #define INFERUNITY_LOGGER_H
 
-#include <string>
-#include <sstream>
-#include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
-#include <iomanip>
-#include <chrono>
+#include <memory>
 #include <mutex>
-#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 编译期保留的最低日志级别（LogLevel的数值）
+#ifndef INFERUNITY_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define INFERUNITY_LOG_MIN_LEVEL 1
+#else
+#define INFERUNITY_LOG_MIN_LEVEL 0
+#endif
+#endif
 
 namespace inferunity {
 
@@ -27,130 +41,109 @@ enum class LogLevel {
 // 日志器类（单例模式）
 class Logger {
 public:
-    static Logger& Instance() {
-        static Logger instance;
-        return instance;
-    }
+    static Logger& Instance();
     
     // 设置日志级别
-    void SetLevel(LogLevel level) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        level_ = level;
-    }
-    
-    LogLevel GetLevel() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return level_;
+    void SetLevel(LogLevel level) { level_.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel GetLevel() const { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+    bool IsEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
     }
     
     // 设置是否输出到控制台
-    void SetConsoleOutput(bool enable) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        console_output_ = enable;
-    }
+    void SetConsoleOutput(bool enable);
     
-    // 设置是否输出到文件
-    void SetFileOutput(const std::string& filename) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        log_file_ = filename;
-    }
+    // 设置输出文件（追加写入），空字符串表示不输出到文件
+    void SetFileOutput(const std::string& filename);
     
-    // 日志输出函数
-    void Log(LogLevel level, const std::string& message, const std::string& file = "", int line = 0) {
-        if (level < level_) {
-            return;  // 低于当前级别，不输出
-        }
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        std::string level_str = LogLevelToString(level);
-        std::string timestamp = GetTimestamp();
-        
-        std::ostringstream oss;
-        oss << "[" << timestamp << "] [" << level_str << "]";
-        if (!file.empty()) {
-            oss << " [" << file;
-            if (line > 0) {
-                oss << ":" << line;
-            }
-            oss << "]";
-        }
-        oss << " " << message << std::endl;
-        
-        std::string log_message = oss.str();
-        
-        // 输出到控制台
-        if (console_output_) {
-            if (level >= LogLevel::ERROR) {
-                std::cerr << log_message;
-            } else {
-                std::cout << log_message;
-            }
-        }
-        
-        // 输出到文件（如果设置了）
-        if (!log_file_.empty()) {
-            // 简化实现：直接追加到文件
-            // 实际应用中可以使用更复杂的文件管理
-            std::ofstream ofs(log_file_, std::ios::app);
-            if (ofs.is_open()) {
-                ofs << log_message;
-                ofs.close();
-            }
-        }
-    }
+    // 异步输出（默认开启）；关闭时先写出已排队的消息，之后每条日志在调用线程同步写出
+    void SetAsync(bool enable);
+    bool IsAsync() const { return async_.load(std::memory_order_acquire); }
+    
+    // 每个线程环形缓冲的容量（条），只影响之后新登记的线程
+    void SetBufferCapacity(size_t capacity);
     
+    // 日志输出函数；file须是静态存储的字符串（如__FILE__）
+    void Log(LogLevel level, std::string message, const char* file = "", int line = 0);
+    
+    // 等待调用之前提交的消息全部写出
+    void Flush();
+    
+    // 缓冲满而丢弃的消息数
+    uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    
+    // fork前后的处理（由InstallForkHandlers注册）：写出已排队的消息、停止后台线程并持有输出锁，
+    // fork后在父子进程中释放；后台线程在下一条异步日志时重新启动
+    void BeforeFork();
+    void AfterFork();
+
 private:
-    Logger() : level_(LogLevel::INFO), console_output_(true) {}
+    struct Record {
+        LogLevel level = LogLevel::INFO;
+        int64_t timestamp_us = 0;  // system_clock
+        const char* file = "";
+        int line = 0;
+        std::string message;
+    };
+    struct ThreadBuffer;
+    struct ThreadBufferHandle;
+    
+    Logger();
     ~Logger() = default;
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
-    std::string LogLevelToString(LogLevel level) const {
-        switch (level) {
-            case LogLevel::VERBOSE: return "VERBOSE";
-            case LogLevel::INFO: return "INFO";
-            case LogLevel::WARNING: return "WARNING";
-            case LogLevel::ERROR: return "ERROR";
-            case LogLevel::FATAL: return "FATAL";
-            default: return "UNKNOWN";
-        }
-    }
+    ThreadBuffer* GetThreadBuffer();
+    void StartFlusher();
+    void FlusherLoop();
+    // 取出各缓冲中的记录，按时间戳写出；返回写出的条数
+    size_t Drain();
+    void Write(const Record& record);  // 调用方持有output_mutex_
+    static void ShutdownAtExit();
     
-    std::string GetTimestamp() const {
-        // 简化实现：使用当前时间
-        // 实际应用中可以使用更精确的时间格式化
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        
-        // 使用线程安全的localtime_r（POSIX）或localtime_s（Windows）
-        // 为了跨平台兼容，使用std::localtime（在线程安全锁内调用）
-        std::tm tm_buf;
-        #ifdef _WIN32
-            localtime_s(&tm_buf, &time_t);
-        #else
-            localtime_r(&time_t, &tm_buf);
-        #endif
-        
-        std::stringstream ss;
-        ss << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
-        return ss.str();
-    }
+    std::atomic<int> level_;
+    std::atomic<bool> async_{true};
+    std::atomic<uint64_t> dropped_{0};
+    size_t buffer_capacity_ = 1024;
+    
+    // 输出目标与格式化缓冲
+    std::mutex output_mutex_;
+    bool console_output_ = true;
+    std::ofstream file_;
+    uint64_t reported_dropped_ = 0;
     
-    LogLevel level_;
-    bool console_output_;
-    std::string log_file_;
-    mutable std::mutex mutex_;
+    // 登记的线程缓冲与后台线程
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::mutex flusher_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::thread flusher_;
+    std::atomic<bool> flusher_started_{false};  // Log的快速路径不取flusher_mutex_
+    bool stop_ = false;
+    bool stopped_for_fork_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
 };
 
-// 便捷宏定义
-#define LOG_VERBOSE(msg) inferunity::Logger::Instance().Log(inferunity::LogLevel::VERBOSE, msg, __FILE__, __LINE__)
-#define LOG_INFO(msg) inferunity::Logger::Instance().Log(inferunity::LogLevel::INFO, msg, __FILE__, __LINE__)
-#define LOG_WARNING(msg) inferunity::Logger::Instance().Log(inferunity::LogLevel::WARNING, msg, __FILE__, __LINE__)
-#define LOG_ERROR(msg) inferunity::Logger::Instance().Log(inferunity::LogLevel::ERROR, msg, __FILE__, __LINE__)
-#define LOG_FATAL(msg) inferunity::Logger::Instance().Log(inferunity::LogLevel::FATAL, msg, __FILE__, __LINE__)
+// 便捷宏定义：级别不够时消息表达式不求值
+#define INFERUNITY_LOG(level, msg) \
+    do { \
+        if (inferunity::Logger::Instance().IsEnabled(level)) { \
+            inferunity::Logger::Instance().Log(level, msg, __FILE__, __LINE__); \
+        } \
+    } while (0)
+
+#if INFERUNITY_LOG_MIN_LEVEL > 0
+#define LOG_VERBOSE(msg) do { } while (0)
+#else
+#define LOG_VERBOSE(msg) INFERUNITY_LOG(inferunity::LogLevel::VERBOSE, msg)
+#endif
+#define LOG_INFO(msg) INFERUNITY_LOG(inferunity::LogLevel::INFO, msg)
+#define LOG_WARNING(msg) INFERUNITY_LOG(inferunity::LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) INFERUNITY_LOG(inferunity::LogLevel::ERROR, msg)
+#define LOG_FATAL(msg) INFERUNITY_LOG(inferunity::LogLevel::FATAL, msg)
 
 } // namespace inferunity
 
 #endif // INFERUNITY_LOGGER_H
-
@@ -0,0 +1,102 @@
+#pragma once
+
+// 多LoRA适配器的批量服务 (参考Punica的SGMV与S-LoRA)：
+// 同一基座模型挂载多个低秩适配器，不为每个适配器合并出一份完整权重。适配器按ID注册，
+// 每个适配器对若干MatMul常量权重W[K, N]给出A[K, r]与B[r, N]，作用后的结果为 X*W + scale * X*A*B。
+// 一次运行按行分段选用适配器（见RunOptions::lora_adapters），同一批中的请求可以选用不同的适配器，
+// 基座权重的GEMM整批只做一次，各段的低秩增量在MatMul内核的结果上分段累加（见RunLoraSgmv）
+
+#include "types.h"
+#include "tensor.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+// 一个权重上的低秩矩阵，均为CPU上的FLOAT32
+struct LoraWeights {
+    std::shared_ptr<Tensor> a;  // [K, r]
+    std::shared_ptr<Tensor> b;  // [r, N]
+};
+
+struct LoraAdapter {
+    float scale = 1.0f;  // 一般为alpha / r
+    // 键为MatMul常量权重（第二个输入）的张量名
+    std::unordered_map<std::string, LoraWeights> weights;
+};
+
+// 可挂载适配器的权重：op(W)为[k, n]
+struct LoraTarget {
+    int64_t k = 0;
+    int64_t n = 0;
+};
+
+// 一段行上的增量，a为空表示这一段只用基座权重
+struct LoraDelta {
+    const float* a = nullptr;
+    const float* b = nullptr;
+    int64_t rank = 0;
+    float scale = 0.0f;
+};
+
+// 一次运行选用的适配器：MatMul输出的行按段数等分，第s段使用第s个适配器。
+// 持有选用的适配器，运行期间注销适配器不影响已经开始的运行
+class LoraBatch {
+public:
+    size_t GetNumSegments() const { return num_segments_; }
+
+    // 某个权重在各段上的增量（长度为GetNumSegments()）；没有一段的适配器作用于该权重时返回nullptr
+    const LoraDelta* Find(const std::string& target) const {
+        auto it = deltas_.find(target);
+        return it == deltas_.end() ? nullptr : it->second.data();
+    }
+
+private:
+    friend class LoraRegistry;
+
+    size_t num_segments_ = 0;
+    std::vector<std::shared_ptr<const LoraAdapter>> adapters_;
+    std::unordered_map<std::string, std::vector<LoraDelta>> deltas_;
+};
+
+// 会话的适配器表：加载模型时记录可挂载的权重，之后按ID注册与注销适配器，线程安全
+class LoraRegistry {
+public:
+    // 重新加载模型时调用，同时清空已注册的适配器
+    void SetTargets(std::unordered_map<std::string, LoraTarget> targets);
+    const std::unordered_map<std::string, LoraTarget>& GetTargets() const { return targets_; }
+
+    // 检查每个权重名都是可挂载的权重、A/B的形状与之匹配；同一ID再次注册时替换
+    Status Register(const std::string& adapter_id, LoraAdapter adapter);
+    Status Unregister(const std::string& adapter_id);
+    std::vector<std::string> GetAdapterIds() const;
+
+    // 按各段选用的适配器ID（空字符串表示基座）建立一次运行的LoraBatch；全部为基座时*batch为nullptr
+    Status CreateBatch(const std::vector<std::string>& adapter_ids, std::shared_ptr<const LoraBatch>* batch) const;
+
+private:
+    std::unordered_map<std::string, LoraTarget> targets_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const LoraAdapter>> adapters_;
+};
+
+// 作用域内调用线程的运行所选用的适配器，会话据此填写ExecutionOptions::lora；可以嵌套，析构时恢复外层
+class LoraScope {
+public:
+    explicit LoraScope(std::shared_ptr<const LoraBatch> batch);
+    ~LoraScope();
+
+    // 调用线程当前的LoraBatch，没有作用域时为nullptr
+    static const std::shared_ptr<const LoraBatch>& Current();
+
+    LoraScope(const LoraScope&) = delete;
+    LoraScope& operator=(const LoraScope&) = delete;
+
+private:
+    std::shared_ptr<const LoraBatch> previous_;
+};
+
+} // namespace inferunity
@@ -2,12 +2,17 @@
 
 #include "types.h"
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace inferunity {
 
 // 前向声明
 class Graph;
+struct MemoryStats;
 
 // 内存分配器接口
 class MemoryAllocator {
@@ -35,41 +40,48 @@ public:
     
     // 获取分配的内存大小（可选）
     virtual size_t GetAllocatedSize(void* ptr) const { return 0; }
+    
+    // 分配器自身维护的统计（可选），GetMemoryStats(device)优先使用
+    virtual bool GetStats(MemoryStats* stats) const { (void)stats; return false; }
 };
 
-// CPU内存分配器
+// CPU内存分配器：全局分级内存池（AllocateMemory/FreeMemory）的分配器接口。
+// 张量、CPU设备（CPUDevice）与MemoryPool都经由内存池分配，统计只在GetMemoryStats()一处
 class CPUAllocator : public MemoryAllocator {
 public:
     void* Allocate(size_t size) override;
     void Free(void* ptr) override;
+    void* AllocateAligned(size_t size, size_t alignment) override;
     size_t GetAllocatedSize(void* ptr) const override;
+    bool GetStats(MemoryStats* stats) const override;
 };
 
-// 内存池分配器（用于减少分配开销）
-class MemoryPool {
+// 固定块大小的分配器：预先从内存池取initial_blocks个block_size的块，之后复用；
+// 超过block_size的请求直接走内存池。非线程安全
+class MemoryPool : public MemoryAllocator {
 public:
     explicit MemoryPool(size_t block_size, size_t initial_blocks = 16);
-    ~MemoryPool();
-    
-    void* Allocate(size_t size);
-    void Free(void* ptr);
-    void Reset();  // 释放所有块，但保留池
+    ~MemoryPool() override;
     
+    void* Allocate(size_t size) override;
+    void Free(void* ptr) override;
+    void Reset();  // 所有块重新标记为空闲（之前返回的指针失效），但保留池
+
 private:
-    struct Block {
-        void* data;
-        bool in_use;
-    };
-    
     size_t block_size_;
-    std::vector<Block> blocks_;
+    std::unordered_map<void*, bool> blocks_;  // 块 -> 是否使用中
     std::vector<void*> free_blocks_;
     
     void* AllocateNewBlock();
 };
 
-// 获取设备对应的内存分配器
+// 获取设备对应的内存分配器；未替换的设备返回进程内常驻的CPUAllocator
 std::shared_ptr<MemoryAllocator> GetMemoryAllocator(DeviceType device);
+// 替换设备的分配器（如CUDA后端注册缓存分配器），之后在该设备上创建的张量共享它；nullptr恢复默认
+void SetMemoryAllocator(DeviceType device, std::shared_ptr<MemoryAllocator> allocator);
+// 张量分配的热路径：未替换的设备无锁返回常驻的默认分配器且不增加引用计数（*owner置空）；
+// 替换过的设备加锁取得分配器，由*owner持有，保证张量释放前分配器不被销毁
+MemoryAllocator* ResolveMemoryAllocator(DeviceType device, std::shared_ptr<MemoryAllocator>* owner);
 
 // 内存统计
 struct MemoryStats {
@@ -81,11 +93,86 @@ struct MemoryStats {
 
 MemoryStats GetMemoryStats(DeviceType device);
 
+// 设备内存的底层操作，由后端实现（CUDA后端使用cudaMalloc/cudaFree与cudaEvent）
+class DeviceMemoryBackend {
+public:
+    virtual ~DeviceMemoryBackend() = default;
+    
+    virtual void* RawAllocate(size_t size) = 0;
+    virtual void RawFree(void* ptr) = 0;
+    
+    // 在stream上记录事件，返回nullptr表示不需要等待；事件完成前块不会被重新分配
+    virtual void* RecordEvent(void* stream) { (void)stream; return nullptr; }
+    virtual bool QueryEvent(void* event) { (void)event; return true; }
+    virtual void DestroyEvent(void* event) { (void)event; }
+    virtual void SynchronizeDevice() {}
+};
+
+struct CachingAllocatorOptions {
+    size_t small_size = 1 << 20;            // 不超过该大小的请求从小块段中分配
+    size_t small_segment_size = 2 << 20;    // 小块段的大小
+    size_t large_segment_size = 20 << 20;   // 不超过10MB的大请求使用的段大小
+    size_t max_split_size = 0;              // 超过该大小的空闲块不再切分，0表示不限制
+    size_t max_cached_bytes = 0;            // 缓存的空闲段超过该值时归还设备，0表示不限制
+};
+
+struct CachingAllocatorStats {
+    size_t reserved_bytes = 0;         // 向设备申请的段总大小
+    size_t peak_reserved_bytes = 0;
+    size_t device_allocations = 0;     // RawAllocate次数
+    size_t device_frees = 0;           // RawFree次数
+    size_t cache_hits = 0;             // 由缓存块满足的分配
+    size_t splits = 0;
+    size_t merges = 0;
+    size_t pending_frees = 0;          // 等待事件完成的已释放块
+};
+
+// 按流缓存的设备分配器 (参考PyTorch CUDACachingAllocator与ONNX Runtime BFCArena)：
+// 空闲块按大小分级（每级按(流, 大小, 地址)排序，最佳适配），大块切分后剩余部分留在缓存，
+// 释放时与同一段内相邻的空闲块合并；块只在分配它的流上复用，被其他流使用过的块（RecordStream）
+// 释放后等所记录的事件完成才回到缓存。AllocateOnStream返回的地址至少按256字节对齐
+class CachingDeviceAllocator : public MemoryAllocator {
+public:
+    explicit CachingDeviceAllocator(std::unique_ptr<DeviceMemoryBackend> backend,
+                                    const CachingAllocatorOptions& options = CachingAllocatorOptions());
+    ~CachingDeviceAllocator() override;
+    
+    CachingDeviceAllocator(const CachingDeviceAllocator&) = delete;
+    CachingDeviceAllocator& operator=(const CachingDeviceAllocator&) = delete;
+    
+    // 在默认流（nullptr）上分配
+    void* Allocate(size_t size) override;
+    void* AllocateAligned(size_t size, size_t alignment) override;
+    void Free(void* ptr) override;
+    size_t GetAllocatedSize(void* ptr) const override;
+    bool GetStats(MemoryStats* stats) const override;
+    
+    void* AllocateOnStream(size_t size, void* stream);
+    // ptr即将在stream（不同于分配它的流）上使用
+    void RecordStream(void* ptr, void* stream);
+    // 等待未完成的事件，把完全空闲的段归还设备
+    void EmptyCache();
+    
+    CachingAllocatorStats GetCachingStats() const;
+    const CachingAllocatorOptions& GetOptions() const { return options_; }
+
+private:
+    struct Impl;
+    CachingAllocatorOptions options_;
+    std::unique_ptr<Impl> impl_;
+};
+
 // 张量生命周期分析（参考NCNN的BlobAllocator）
 struct TensorLifetime {
     int64_t birth;   // 出生时间（节点执行顺序）
     int64_t death;   // 死亡时间（最后使用时间）
     void* value_ptr;  // Value指针（避免循环依赖）
+    bool is_alias = false;  // 视图算子的输出，与输入共享存储，不单独分配（见Operator::IsViewOperator）
+    void* inplace_of = nullptr;  // 原地执行时复用其缓冲的输入Value（见Operator::GetInPlaceInput）
+    void* slice_of = nullptr;    // 作为Concat/Pad的输入、Split的输出时所在的整体Value（见Operator::GetSliceAlias）
+    int slice_index = -1;        // 在整体中的切片序号
+    int slice_axis = -1;         // 放在Pad的输出内部时所在的轴与起始位置（见Operator::GetSliceOrigin）
+    int64_t slice_start = 0;
 };
 
 std::vector<TensorLifetime> AnalyzeTensorLifetimes(const Graph* graph);
@@ -99,12 +186,281 @@ void FreeMemory(void* ptr);
 void ReleaseUnusedMemory();
 MemoryStats GetMemoryStats();  // CPU设备的内存统计
 
-// 内存碎片整理
+// 内存碎片整理：按默认的MemoryTrimOptions执行一轮TrimMemory
 void DefragmentMemory();
 
 // 内存池配置
 void SetMemoryPoolMaxSize(size_t max_size);
 void SetMemoryReleaseThreshold(double threshold);  // 0.0-1.0，未使用内存占比阈值
 
+// 空闲内存归还策略 (参考TCMalloc的后台ReleaseMemoryToSystem与jemalloc的dirty/muzzy衰减)：
+// 流量突发后池中留下大量空闲块，长时间运行的服务RSS只增不减。中心池中闲置超过idle_ttl_ms的块
+// 整块释放；闲置超过decommit_after_ms的大块先用madvise(MADV_DONTNEED)归还物理页、保留地址空间，
+// 再次复用时按零页重新缺页。线程本地缓存（每线程最多4MB）在所属线程下一次分配/释放时归还中心池后才参与
+struct MemoryTrimOptions {
+    int64_t idle_ttl_ms = 60000;
+    int64_t decommit_after_ms = 5000;      // 小于0表示不decommit
+    size_t decommit_min_bytes = 64 * 1024;  // 更小的块与其他块共享页，不单独归还
+    int64_t interval_ms = 10000;           // 后台线程两轮之间的间隔
+};
+
+// 同步执行一轮回收，返回本轮归还给系统的字节数（整块释放与decommit之和）
+size_t TrimMemory(const MemoryTrimOptions& options = MemoryTrimOptions());
+
+// 启动后台回收线程，每interval_ms执行一轮TrimMemory；已在运行时更新选项
+Status StartMemoryTrimmer(const MemoryTrimOptions& options = MemoryTrimOptions());
+void StopMemoryTrimmer();
+bool IsMemoryTrimmerRunning();
+
+// fork前后的内存池处理（由InstallForkHandlers注册，一般不直接调用）：停止后台回收线程并持有中心池的锁，
+// fork后在父子进程中释放并恢复回收线程。线程池的工作线程在此之前已经退出，其线程缓存已归还中心池
+void MemoryPoolBeforeFork();
+void MemoryPoolAfterFork();
+
+// 归还给系统的内存统计（累计值自进程启动起计）
+struct MemoryReturnStats {
+    size_t released_bytes = 0;        // 整块释放的字节数（含ReleaseUnusedMemory与阈值回收）
+    size_t released_blocks = 0;
+    size_t decommitted_bytes = 0;     // madvise归还的字节数
+    size_t decommitted_blocks = 0;
+    size_t decommitted_resident = 0;  // 当前处于decommit状态、仍在池中的块容量
+    size_t cached_bytes = 0;          // 池中空闲块的容量（含decommit的块）
+    size_t trim_passes = 0;           // TrimMemory执行的轮数（含后台线程）
+    size_t process_rss_bytes = 0;     // 进程当前RSS（/proc/self/statm，其他平台为0）
+};
+
+MemoryReturnStats GetMemoryReturnStats();
+
+// 大页策略 (参考PyTorch/oneDNN为大权重与工作区使用大页的做法)：GEMM与Embedding在大张量上跨页访问，
+// 4KB页的TLB未命中明显；只对不小于kHugePageSize的区域生效，更小的请求仍走内存池
+enum class HugePagePolicy {
+    NONE,          // 普通页
+    TRANSPARENT,   // 透明大页：按2MB对齐映射后madvise(MADV_HUGEPAGE)，由内核在缺页或khugepaged时合并
+    HUGETLB_2MB,   // hugetlbfs预留的2MB页（MAP_HUGETLB），预留不足时退回TRANSPARENT
+    HUGETLB_1GB    // 1GB页，不足时依次退回2MB页与TRANSPARENT
+};
+
+const char* HugePagePolicyName(HugePagePolicy policy);
+
+// 区域实际得到的页
+enum class HugePageBacking {
+    NORMAL,        // 请求了大页但只得到普通页（透明大页被禁用或不是Linux）
+    TRANSPARENT,
+    HUGETLB_2MB,
+    HUGETLB_1GB
+};
+
+constexpr size_t kHugePageSize = size_t(2) << 20;
+
+// 大页统计（进程级）：各种页上当前映射的字节数，以及回退情况
+struct HugePageStats {
+    size_t hugetlb_1gb_bytes = 0;
+    size_t hugetlb_2mb_bytes = 0;
+    size_t transparent_bytes = 0;      // 已madvise的区域，内核是否真正合并见anon_huge_bytes
+    size_t advised_bytes = 0;          // 累计经AdviseHugePages原地建议的字节数
+    size_t fallback_bytes = 0;         // 请求了大页但只得到普通页的区域
+    size_t hugetlb_failures = 0;       // 累计MAP_HUGETLB失败（预留不足）的次数
+    size_t anon_huge_bytes = 0;        // 进程实际驻留在透明大页上的字节数（/proc/self/smaps_rollup的AnonHugePages）
+};
+
+HugePageStats GetHugePageStats();
+
+// 映射在大页上的匿名内存区域，起始地址按2MB对齐；调用线程绑定了NUMA节点时在首次触碰前绑定到该节点
+class HugePageRegion {
+public:
+    // size小于kHugePageSize或策略为NONE时返回nullptr，由调用方使用普通分配
+    static std::unique_ptr<HugePageRegion> Allocate(size_t size, HugePagePolicy policy);
+    ~HugePageRegion();
+    
+    HugePageRegion(const HugePageRegion&) = delete;
+    HugePageRegion& operator=(const HugePageRegion&) = delete;
+    
+    void* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    HugePageBacking GetBacking() const { return backing_; }
+
+private:
+    HugePageRegion() = default;
+    
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    void* data_ = nullptr;
+    size_t size_ = 0;             // 映射中按页大小取整后的可用大小
+    HugePageBacking backing_ = HugePageBacking::NORMAL;
+};
+
+// 对已有的内存（文件映射或堆上的大权重）建议使用透明大页，只对完整落在范围内的2MB区间生效；
+// 返回是否有区间被建议（计入HugePageStats::advised_bytes）
+bool AdviseHugePages(const void* data, size_t size);
+
+// 页预取 (madvise(MADV_WILLNEED))：让内核异步读入[data, data + size)所在的页，不阻塞调用方；
+// 用于文件映射的权重（见ONNXParser::LoadFromFile），对已驻留的内存没有副作用，不支持的平台上为空操作
+void PrefetchMemory(const void* data, size_t size);
+// 页回收 (madvise(MADV_PAGEOUT)，内核较旧时MADV_COLD)：让内核回收[data, data + size)内完整的页，
+// 文件映射中未改写的页直接丢弃、之后访问时重新读盘，写时复制过的页换出而不丢失内容；
+// 用于按执行顺序流式驻留的权重（见WeightStreamingSchedule），不支持的平台上为空操作
+void ReleaseMemory(const void* data, size_t size);
+
+// 线程私有的暂存区 (参考oneDNN的scratchpad与XNNPACK的workspace)：算子一次执行中的临时缓冲
+// （im2col矩阵、GEMM打包面板、Winograd变换、Softmax行缓冲等）从所在线程的连续块中按64字节对齐顺序切出，
+// 不经过内存池、不加锁。主块按编译节点时声明的大小（OperatorMemory::scratch_bytes）预留；
+// 放不下的请求另外分配溢出块，回到空闲状态时释放溢出块并把主块扩大到峰值用量，稳态下不再分配
+class ScratchArena {
+public:
+    static constexpr size_t kAlignment = 64;
+    
+    // 回退点：切出位置与溢出块数
+    struct Mark {
+        size_t offset = 0;
+        size_t overflow = 0;
+    };
+    
+    // 调用线程的暂存区，线程退出时释放
+    static ScratchArena& ForCurrentThread();
+    
+    ScratchArena() = default;
+    ~ScratchArena();
+    
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+    
+    // 主块至少保留bytes；有未回收的缓冲时推迟到回到空闲状态
+    void Reserve(size_t bytes);
+    
+    // 切出size字节，alignment须为2的幂；size为0时可能返回nullptr
+    void* Allocate(size_t size, size_t alignment = kAlignment);
+    template<typename T>
+    T* Allocate(size_t count) {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T) > kAlignment ? alignof(T) : kAlignment));
+    }
+    
+    // 回到mark：之后切出的地址全部失效
+    Mark GetMark() const { return Mark{offset_, overflow_.size()}; }
+    void Rewind(const Mark& mark);
+    void Reset() { Rewind(Mark()); }
+    
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetUsedBytes() const { return offset_ + overflow_bytes_; }
+    size_t GetPeakBytes() const { return peak_; }
+    size_t GetOverflowCount() const { return overflow_count_; }  // 累计的溢出分配次数
+
+private:
+    void Grow(size_t bytes);
+    
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    size_t reserved_ = 0;          // Reserve请求的最大值
+    size_t peak_ = 0;              // 主块与溢出块用量之和的峰值
+    struct OverflowBlock {
+        void* data;
+        size_t bytes;      // 计入对齐余量
+        size_t alignment;
+    };
+    std::vector<OverflowBlock> overflow_;
+    size_t overflow_bytes_ = 0;
+    size_t overflow_count_ = 0;
+};
+
+// 暂存区作用域：构造时记下调用线程暂存区的位置（并预留reserve_bytes），析构时回到该位置。
+// 后端在每个节点执行前后、ParallelForOuter在每个并行块前后各建立一个
+class ScratchScope {
+public:
+    explicit ScratchScope(size_t reserve_bytes = 0);
+    ~ScratchScope() { arena_.Rewind(mark_); }
+    
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+    
+    ScratchArena& GetArena() { return arena_; }
+
+private:
+    ScratchArena& arena_;
+    ScratchArena::Mark mark_;
+};
+
+// 只读共享的模型文件映射 (参考ONNX Runtime的mmap加载)：MAP_PRIVATE写时复制，
+// 未被改写的页在进程间共享；图优化（如BN折叠）改写权重时只复制被写的页。
+// 作为视图的权重张量在删除器中持有映射的shared_ptr，最后一个视图释放后才解除映射
+class MappedFile {
+public:
+    static Status Open(const std::string& filepath, std::shared_ptr<MappedFile>* file);
+    // 只读打开POSIX共享内存段（shm_open）并映射，语义与Open相同：其他进程发布的内容按页共享，
+    // 本进程改写的页写时复制，不影响段本身与其他进程
+    static Status OpenSharedMemory(const std::string& name, std::shared_ptr<MappedFile>* file);
+    // 映射已打开的文件描述符（如经fork继承或SCM_RIGHTS传来的memfd）的全部内容；fd仍归调用方所有
+    static Status OpenDescriptor(int fd, const std::string& label, std::shared_ptr<MappedFile>* file);
+    // 复制已在内存中的模型字节（如WebAssembly里fetch得到的缓冲）到64字节对齐的自有缓冲，
+    // 供没有文件映射的平台使用；data在返回后即可释放
+    static Status FromMemory(const void* data, size_t size, const std::string& label,
+                             std::shared_ptr<MappedFile>* file);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const uint8_t* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    // Open打开的普通文件的路径，共享内存段与文件描述符映射为空
+    const std::string& GetPath() const { return path_; }
+
+private:
+    MappedFile() = default;
+    
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string path_;
+    bool owned_ = false;  // data_来自AllocateMemory而不是mmap
+#ifdef _WIN32
+    std::vector<uint8_t> buffer_;
+#endif
+};
+
+// 查找[data, data + size)所在的文件映射（MappedFile::Open打开的普通文件，映射存活期间有效），
+// 返回文件路径与区域起点在文件中的偏移；不完整落在任何这样的映射内时返回false
+bool FindMappedFileRegion(const void* data, size_t size, std::string* path, uint64_t* offset);
+
+// dma-buf共享内存分配器 (参考Android的ION/dma-heap与NNAPI的共享内存池)：每次分配从Linux dma-heap
+// （/dev/dma_heap下的system堆，高通设备上优先qcom,system）取一个dma-buf并映射到主机，
+// NPU/DSP提供者按文件描述符导入后与CPU零拷贝共享。没有dma-heap的系统退回内存池，
+// FindDmaBufRegion对这些指针返回false。每次分配都是一次系统调用，适合子图边界上长期存在的缓冲
+class DmaBufAllocator : public MemoryAllocator {
+public:
+    // 进程内共享的实例
+    static std::shared_ptr<DmaBufAllocator> Instance();
+    
+    DmaBufAllocator();
+    ~DmaBufAllocator() override;
+    
+    DmaBufAllocator(const DmaBufAllocator&) = delete;
+    DmaBufAllocator& operator=(const DmaBufAllocator&) = delete;
+    
+    void* Allocate(size_t size) override;
+    void Free(void* ptr) override;
+    // 映射按页对齐，不超过页大小的对齐要求直接满足
+    void* AllocateAligned(size_t size, size_t alignment) override;
+    size_t GetAllocatedSize(void* ptr) const override;
+    
+    // 找到了可用的dma-heap
+    bool IsAvailable() const { return heap_fd_ >= 0; }
+
+private:
+    int heap_fd_ = -1;
+};
+
+// dma-buf中的一段区域：fd在对应的缓冲释放前有效，归分配器所有
+struct DmaBufRegion {
+    int fd = -1;
+    void* base = nullptr;   // 整个dma-buf的映射起点
+    size_t size = 0;        // 整个dma-buf的大小
+    size_t offset = 0;      // 区域起点相对base的偏移
+};
+
+// 查找[data, data + size)所在的dma-buf（DmaBufAllocator分配且未释放）；不完整落在其中时返回false
+bool FindDmaBufRegion(const void* data, size_t size, DmaBufRegion* region);
+
+// CPU访问dma-buf前后的缓存同步（DMA_BUF_IOCTL_SYNC）：设备写完后CPU读之前begin，CPU写完交给设备之前end
+Status SyncDmaBuf(int fd, bool begin_cpu_access, bool write);
+
 } // namespace inferunity
 
@@ -0,0 +1,157 @@
+#pragma once
+
+// 静态内存规划器
+// 参考TFLite的ArenaPlanner/SimpleMemoryArena以及Pisarchyk & Lee (2020)
+// "Efficient Memory Management for Deep Neural Net Inference"中的offset计算策略：
+// 离线为每个中间张量分配一个arena内的偏移，运行时只需一次对齐分配
+
+#include "types.h"
+#include "memory.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class Node;
+class Value;
+class Tensor;
+
+enum class MemoryPlanStrategy {
+    AUTO,               // 两种策略都计算，取峰值较小者
+    GREEDY_BY_SIZE,     // 按张量大小降序，放入冲突张量之间最合适的空隙
+    GREEDY_BY_BREADTH   // 按算子的活跃内存（breadth）降序，逐个算子放置其张量
+};
+
+const char* MemoryPlanStrategyName(MemoryPlanStrategy strategy);
+
+struct MemoryPlannerOptions {
+    MemoryPlanStrategy strategy = MemoryPlanStrategy::AUTO;
+    size_t alignment = 64;              // 每个张量的起始偏移对齐（满足AVX-512加载）
+    bool include_graph_outputs = false; // 图输出默认独立分配，避免下一次推理覆盖已返回的结果
+    // 形状特化：按给定的（只有形状的）张量规划，代替Value上带符号维度的张量，不在表中的Value不规划；
+    // 为空时使用Value上的张量，只规划形状完全静态的
+    const std::unordered_map<const Value*, std::shared_ptr<Tensor>>* tensors = nullptr;
+};
+
+// 单个张量的规划结果
+struct MemoryPlanEntry {
+    Value* value = nullptr;
+    Shape shape;            // 规划时的具体形状与类型，arena视图按此创建
+    DataType dtype = DataType::UNKNOWN;
+    MemoryLayout layout = MemoryLayout::NCHW;
+    size_t offset = 0;      // arena内偏移
+    size_t size = 0;        // 对齐后的字节数
+    int64_t birth = 0;      // 生产者在执行顺序中的位置
+    int64_t death = 0;      // 最后一个消费者的位置
+    // 所在缓冲的张量，不另占空间：原地执行时为所复用的张量（偏移相同），
+    // Concat/Split的切片为整体张量，偏移为整体的偏移加alias_offset
+    const Value* shares_with = nullptr;
+    size_t alias_offset = 0;
+};
+
+struct MemoryPlan {
+    MemoryPlanStrategy strategy = MemoryPlanStrategy::AUTO;  // 实际采用的策略
+    size_t alignment = 64;
+    size_t arena_size = 0;   // 规划后的峰值（arena大小）
+    size_t naive_size = 0;   // 每个张量独立分配时的总和
+    size_t lower_bound = 0;  // 任一算子处同时存活张量之和的最大值（理论下界）
+    std::vector<MemoryPlanEntry> entries;
+};
+
+// 根据生命周期求解偏移；只规划有生产者、形状已知的CPU中间张量
+// 生命周期按顺序执行计算，区间[birth, death]重叠的张量不会共享内存；
+// 原地执行的输出（TensorLifetime::inplace_of）大小与输入一致时取输入的偏移；
+// Concat的输入与Split的输出（TensorLifetime::slice_of）连续且对齐时放在整体缓冲内的对应切片，不另占空间
+Status PlanMemory(const Graph* graph, const std::vector<TensorLifetime>& lifetimes,
+                  const MemoryPlannerOptions& options, MemoryPlan* plan);
+Status PlanMemory(const Graph* graph, const MemoryPlannerOptions& options, MemoryPlan* plan);
+
+// 在激活内存预算内规划（budget为0时同PlanMemory）：arena超出预算时以计算换内存，逐个重计算跨过峰值的
+// 廉价算子（逐元素、归一化）的输出——在之后第一次使用前复制生产者，之后的使用者改读副本，缩短原张量的生命周期。
+// 仍无法放进预算时返回ERROR_OUT_OF_MEMORY，图中保留已做的改写；新增节点与其原节点记入recomputed
+Status PlanMemoryWithinBudget(Graph* graph, size_t budget, const MemoryPlannerOptions& options, MemoryPlan* plan,
+                              std::vector<std::pair<Node*, const Node*>>* recomputed = nullptr);
+
+// arena的内存记账（如按会话统计，见InferenceSession::GetMemoryStats）：arena在创建时记入、析构时扣除，
+// 由arena共同持有，统计对象可以晚于所属会话释放
+class MemoryAccount {
+public:
+    void OnAllocate(size_t size);
+    void OnFree(size_t size);
+    MemoryStats GetStats() const;
+    size_t GetAllocatedBytes() const { return allocated_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> allocated_bytes_{0};
+    std::atomic<size_t> peak_allocated_bytes_{0};
+    std::atomic<size_t> allocation_count_{0};
+    std::atomic<size_t> free_count_{0};
+};
+
+// 一次分配的对齐内存区域，所有规划内的张量都是其视图
+class MemoryArena {
+public:
+    // huge_pages不为NONE且size不小于kHugePageSize时映射在大页上（见HugePageRegion），否则从内存池分配
+    static std::shared_ptr<MemoryArena> Create(size_t size, size_t alignment = 64,
+                                               std::shared_ptr<MemoryAccount> account = nullptr,
+                                               HugePagePolicy huge_pages = HugePagePolicy::NONE);
+    ~MemoryArena();
+    
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    
+    void* GetBase() const { return base_; }
+    size_t GetSize() const { return size_; }
+    // 不在大页区域上时为NORMAL
+    HugePageBacking GetBacking() const {
+        return huge_pages_ ? huge_pages_->GetBacking() : HugePageBacking::NORMAL;
+    }
+
+private:
+    MemoryArena() = default;
+    
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    std::shared_ptr<MemoryAccount> account_;
+    std::unique_ptr<HugePageRegion> huge_pages_;
+};
+
+// 将每个规划内Value的Tensor替换为arena中对应偏移的视图
+// 视图持有arena的引用，最后一个视图释放后arena才会释放
+Status BindMemoryPlan(const MemoryPlan& plan, const std::shared_ptr<MemoryArena>& arena);
+
+// arena上的顺序分配器（参考ONNX Runtime的IAllocator/BFCArena与TFLite的scratch arena）：
+// 按对齐依次切出，Free不回收，Reset后整体复用；arena用完后的请求转交内存池。
+// 用于生命周期同为一次推理的临时张量（配合CreateTensorWithAllocator），非线程安全
+class ArenaAllocator : public MemoryAllocator {
+public:
+    ArenaAllocator(std::shared_ptr<MemoryArena> arena, size_t alignment = 64);
+    
+    void* Allocate(size_t size) override;
+    void Free(void* ptr) override;
+    void* AllocateAligned(size_t size, size_t alignment) override;
+    bool GetStats(MemoryStats* stats) const override;
+    
+    // 之前从arena切出的地址全部失效；溢出到内存池的块不受影响，仍需各自Free
+    void Reset();
+    size_t GetUsedBytes() const { return offset_; }
+    size_t GetOverflowCount() const { return overflow_count_; }
+
+private:
+    bool Owns(const void* ptr) const;
+    
+    std::shared_ptr<MemoryArena> arena_;
+    size_t alignment_;
+    size_t offset_ = 0;
+    size_t peak_offset_ = 0;
+    size_t allocation_count_ = 0;
+    size_t free_count_ = 0;
+    size_t overflow_count_ = 0;
+};
+
+} // namespace inferunity
@@ -0,0 +1,225 @@
+#pragma once
+
+// 常驻运行时指标 (参考Prometheus客户端库与TensorFlow的monitoring::Counter/Sampler)
+// 计数器、仪表和直方图按线程分片：每个线程固定写一个缓存行对齐的分片（relaxed原子加），
+// 读取时把各分片求和，记录路径上没有锁也没有跨核的缓存行争用。指标在MetricsRegistry中按
+// (名称, 标签)登记一次，埋点处持有返回的指针；Collect拉取快照，ExportPrometheus输出文本格式。
+// 内置的埋点：会话的运行延迟、异步运行与动态批处理的排队时间、批大小、各算子类型的累计耗时、
+// arena高水位、缓存分配器的命中次数与线程池的忙碌时间（利用率 = rate(busy) / 线程数）
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace inferunity {
+
+// 有序的(键, 值)标签，如{{"session", "session1"}}
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+constexpr size_t kMetricShards = 16;
+
+// 当前线程写入的分片：线程第一次记录时轮流分配
+size_t MetricShardIndex();
+
+inline int64_t MetricNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 固定桶直方图：bounds为各桶上界（升序），最后一个桶收集超过最大上界的值
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds = {});
+    // 由已有的各桶计数构造（如分片直方图的快照），counts须有bounds.size() + 1个元素
+    Histogram(std::vector<double> bounds, std::vector<uint64_t> counts, double sum, double max);
+    
+    void Record(double value);
+    
+    const std::vector<double>& GetBounds() const { return bounds_; }
+    const std::vector<uint64_t>& GetCounts() const { return counts_; }  // bounds.size() + 1个桶
+    uint64_t GetCount() const { return count_; }
+    double GetSum() const { return sum_; }
+    double GetMax() const { return max_; }
+    double GetMean() const { return count_ ? sum_ / static_cast<double>(count_) : 0.0; }
+    // 近似分位数：返回第一个累计计数达到p的桶的上界（溢出桶返回最大值）
+    double GetPercentile(double p) const;
+
+private:
+    std::vector<double> bounds_;
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double max_ = 0.0;
+};
+
+// 单调递增的计数器
+class Counter {
+public:
+    void Add(uint64_t delta = 1) {
+        shards_[MetricShardIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+    uint64_t Value() const;
+    void Reset();
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kMetricShards> shards_;
+};
+
+// 可增减的仪表（如线程数、arena字节数）；写入不频繁，不分片
+class Gauge {
+public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    // 只在value更大时更新，用于高水位
+    void SetMax(int64_t value);
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// 分片直方图：每个分片各有一组桶计数，快照时合并为Histogram
+class ShardedHistogram {
+public:
+    explicit ShardedHistogram(std::vector<double> bounds);
+    
+    void Record(double value);
+    Histogram Snapshot() const;
+    const std::vector<double>& GetBounds() const { return bounds_; }
+    void Reset();
+
+private:
+    struct alignas(64) Shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> counts;
+        std::atomic<double> sum{0.0};
+        std::atomic<double> max{0.0};
+    };
+    std::vector<double> bounds_;
+    std::array<Shard, kMetricShards> shards_;
+};
+
+// 作用域计时：析构时把经过的微秒数记入直方图；histogram为nullptr或指标关闭时不计时
+class ScopedLatency {
+public:
+    explicit ScopedLatency(ShardedHistogram* histogram);
+    ~ScopedLatency();
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    ShardedHistogram* histogram_;
+    int64_t start_ns_;
+};
+
+// 按算子类型累计的执行耗时与次数，由执行计划为每个步骤缓存（见ExecutionStep::op_metrics）
+struct OpMetrics {
+    Counter* time_ns = nullptr;
+    Counter* executions = nullptr;
+};
+
+// 作用域计时：析构时累加到算子类型的耗时与次数
+class ScopedOpTimer {
+public:
+    explicit ScopedOpTimer(const OpMetrics* metrics);
+    ~ScopedOpTimer() {
+        if (metrics_) {
+            metrics_->time_ns->Add(static_cast<uint64_t>(MetricNowNs() - start_ns_));
+            metrics_->executions->Add();
+        }
+    }
+    ScopedOpTimer(const ScopedOpTimer&) = delete;
+    ScopedOpTimer& operator=(const ScopedOpTimer&) = delete;
+
+private:
+    const OpMetrics* metrics_;
+    int64_t start_ns_;
+};
+
+enum class MetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+// Collect返回的一个时间序列
+struct MetricSample {
+    std::string name;
+    std::string help;
+    MetricLabels labels;
+    MetricType type = MetricType::COUNTER;
+    double value = 0.0;   // 计数器与仪表
+    Histogram histogram;  // 直方图
+    
+    // 标签的值，不存在时返回空字符串
+    std::string GetLabel(const std::string& key) const;
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Instance();
+    
+    // 全局开关（默认开启）；关闭后埋点跳过计时，已登记的指标保留
+    void SetEnabled(bool enable) { enabled_.store(enable, std::memory_order_relaxed); }
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    
+    // 取得（不存在时登记）指标；同一名称的类型须一致，否则返回nullptr。
+    // 直方图的bounds只在第一次登记时生效
+    std::shared_ptr<Counter> GetCounter(const std::string& name, const MetricLabels& labels = {},
+                                        const std::string& help = "");
+    std::shared_ptr<Gauge> GetGauge(const std::string& name, const MetricLabels& labels = {},
+                                    const std::string& help = "");
+    std::shared_ptr<ShardedHistogram> GetHistogram(const std::string& name, const std::vector<double>& bounds,
+                                                   const MetricLabels& labels = {},
+                                                   const std::string& help = "");
+    
+    // 注销带有该标签且只被注册表持有的指标（如会话销毁后的各项会话指标）
+    void Unregister(const std::string& label_key, const std::string& label_value);
+    
+    // 按(名称, 标签)排序的快照；name_prefix非空时只返回名称以它开头的指标
+    std::vector<MetricSample> Collect(const std::string& name_prefix = "") const;
+    // Prometheus文本格式（text/plain; version=0.0.4）
+    std::string ExportPrometheus() const;
+    
+    // 计数器与直方图清零，仪表不变（用于测试）
+    void Reset();
+
+private:
+    struct Entry {
+        std::string name;
+        MetricLabels labels;
+        MetricType type = MetricType::COUNTER;
+        std::shared_ptr<Counter> counter;
+        std::shared_ptr<Gauge> gauge;
+        std::shared_ptr<ShardedHistogram> histogram;
+        
+        long UseCount() const;
+    };
+    
+    MetricsRegistry() = default;
+    Entry* FindOrAdd(const std::string& name, const MetricLabels& labels, MetricType type,
+                     const std::string& help);
+    
+    std::atomic<bool> enabled_{true};
+    mutable std::mutex mutex_;
+    std::map<std::pair<std::string, MetricLabels>, Entry> entries_;
+    std::map<std::string, std::string> help_;
+};
+
+// 算子类型的累计耗时与次数（inferunity_op_time_ns_total / inferunity_op_executions_total），进程内一直有效
+const OpMetrics* GetOpMetrics(const std::string& op_type);
+
+// 默认的桶：延迟为10us到10s的1-2.5-5序列，批大小为1到max_batch_size的2的幂
+std::vector<double> LatencyBucketsUs();
+std::vector<double> BatchSizeBuckets(int max_batch_size);
+
+} // namespace inferunity
@@ -0,0 +1,91 @@
+#pragma once
+
+// 多模型集成与模型流水线 (参考Triton Inference Server的ensemble调度与DeepStream的级联推理)：
+// 若干会话按数据依赖组成有向无环图（如检测→分类、嵌入→排序），一个模型的输出张量直接作为下游模型的输入，
+// 所有权随shared_ptr传递，不拷贝。每个步骤在依赖就绪时经InferenceSession::RunAsync提交到共享的运行时线程池，
+// 互不依赖的模型同时执行；多条输入（条目）流过集成时按条目独立推进，上游完成一条后下游立即开始处理这一条，
+// 不等待整批。某个中间输出的所有消费者都已提交后集成不再持有它
+//
+// 张量用名称引用：集成输入直接用其名称，步骤的输出写作"步骤名:输出名"（输出名见GetOutputNames）
+
+#include "types.h"
+#include "tensor.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class InferenceSession;
+
+// 集成中的一个模型
+struct EnsembleStep {
+    std::string name;                      // 在集成内唯一，不含':'
+    InferenceSession* session = nullptr;   // 不持有，须在集成之后销毁；同一会话可出现在多个步骤中
+    std::vector<std::string> inputs;       // 按会话的图输入顺序给出每个输入的来源
+};
+
+struct ModelEnsembleOptions {
+    std::vector<std::string> input_names;   // 集成输入，Run的inputs按此顺序
+    std::vector<std::string> output_names;  // 集成输出（集成输入或步骤输出），Run的outputs按此顺序
+    size_t max_inflight_items = 0;          // RunStream同时推进的条目数上限，0表示不限制
+};
+
+// 集成的累计统计
+struct ModelEnsembleStats {
+    uint64_t items = 0;           // 完成的条目数（含失败的）
+    uint64_t failed_items = 0;
+    uint64_t step_runs = 0;       // 提交的步骤运行数
+    size_t peak_inflight_items = 0;
+};
+
+class ModelEnsemble {
+public:
+    // 检查步骤名、来源与会话的输入个数，并按依赖排序；有环或引用了不存在的张量时返回ERROR_INVALID_ARGUMENT
+    static Status Create(std::vector<EnsembleStep> steps, const ModelEnsembleOptions& options,
+                         std::unique_ptr<ModelEnsemble>* ensemble);
+    ~ModelEnsemble();
+
+    ModelEnsemble(const ModelEnsemble&) = delete;
+    ModelEnsemble& operator=(const ModelEnsemble&) = delete;
+
+    // 执行一条输入，全部步骤完成后返回；outputs按output_names的顺序，所有权属于调用方
+    Status Run(const std::vector<std::shared_ptr<Tensor>>& inputs, std::vector<std::shared_ptr<Tensor>>* outputs);
+
+    // 依次流过多条输入：每条完成（或失败）时在完成它的线程上调用on_item，顺序不保证与输入一致。
+    // 一条失败不影响其他条目；全部完成后返回，结果为第一个失败条目的错误。on_item应尽快返回
+    using ItemCallback = std::function<void(size_t index, Status status,
+                                            std::vector<std::shared_ptr<Tensor>> outputs)>;
+    Status RunStream(const std::vector<std::vector<std::shared_ptr<Tensor>>>& items, const ItemCallback& on_item);
+
+    // 按依赖排序后的步骤名
+    std::vector<std::string> GetStepNames() const;
+    const ModelEnsembleOptions& GetOptions() const { return options_; }
+    ModelEnsembleStats GetStats() const;
+
+private:
+    struct Step;
+    struct Item;
+    struct StreamState;
+
+    ModelEnsemble() = default;
+    void StartItem(StreamState* stream, size_t index);
+    void LaunchStep(const std::shared_ptr<Item>& item, size_t step);
+    void CompleteStep(const std::shared_ptr<Item>& item, size_t step, Status status,
+                      std::vector<std::shared_ptr<Tensor>> outputs);
+    void FinishItem(const std::shared_ptr<Item>& item);
+
+    std::vector<Step> steps_;
+    ModelEnsembleOptions options_;
+    std::vector<std::pair<int, size_t>> output_sources_;  // 集成输出的来源：(步骤下标或-1表示集成输入, 序号)
+
+    std::atomic<uint64_t> items_{0};
+    std::atomic<uint64_t> failed_items_{0};
+    std::atomic<uint64_t> step_runs_{0};
+    std::atomic<size_t> peak_inflight_{0};
+};
+
+} // namespace inferunity
@@ -0,0 +1,87 @@
+#pragma once
+
+// 原生紧凑二进制模型格式 (参考FlatBuffers/TFLite的零拷贝加载)：
+// 固定布局的值/节点/属性记录表 + 64字节对齐的权重段，加载时只做mmap与偏移到指针的转换，
+// 权重张量直接是映射的视图，不经过protobuf解析也不拷贝数据
+//
+// 文件布局（小端）：
+//   [头部] 魔数"IUNM"、版本、各段的偏移与记录数
+//   [值表] ValueRecord数组：名称、动态维度的符号名、数据类型、形状、权重在权重段中的区间
+//   [节点表] NodeRecord数组：算子类型、名称、设备、输入/输出/属性在各池中的区间
+//   [属性表] AttributeRecord数组：键、AttributeValue类型与值，列表引用维度池/浮点池，张量数据在权重段
+//   [索引池] 节点输入输出与图输入输出引用的值下标（uint32）
+//   [维度池] 形状维度与INTS属性（int64）
+//   [浮点池] FLOATS属性（float）
+//   [字符串池] 所有名称与属性文本，不带结尾的'\0'
+//   [权重段] 每个权重与张量属性按kCompactModelWeightAlignment对齐
+//
+// 权重段可以压缩（版本4起，见CompactModelSaveOptions）：段内依次为块表与各块的压缩数据，每个权重按chunk_size
+// 切成独立的块，块用LZ4块格式（参考LZ4 block format，在库内实现，不依赖liblz4）压缩，浮点权重先按元素字节
+// 重排（参考Blosc的shuffle过滤器：各元素同一位置的字节排在一起，指数字节高度重复）。加载时各块在线程池上
+// 并行解压，直接写入对齐的权重缓冲区中该权重的最终位置；压缩段的页在解压前发起预读，读盘与解压重叠。
+// 压缩的权重不再是文件映射的视图，换取网络拉取与磁盘占用的减少
+
+#include "types.h"
+#include "graph.h"
+#include <memory>
+#include <string>
+
+namespace inferunity {
+
+constexpr uint32_t kCompactModelVersion = 4;
+constexpr size_t kCompactModelWeightAlignment = 64;
+
+enum class WeightCompression {
+    NONE,   // 权重段按原样写出，加载时零拷贝映射
+    LZ4     // 分块LZ4（浮点权重先做字节重排），加载时并行解压
+};
+
+struct CompactModelSaveOptions {
+    WeightCompression compression = WeightCompression::NONE;
+    size_t chunk_size = size_t(1) << 20;  // 每块的原始字节数，按kCompactModelWeightAlignment向上取整
+    bool byte_shuffle = true;             // 多字节元素的权重先按字节重排再压缩
+};
+
+// 把图写成紧凑格式：没有生产者、不是图输入且带数据的Value作为权重写入权重段；
+// 图输入保存形状与类型，中间值只保存连接关系（加载后由形状推断重新得到形状）
+Status SaveCompactModel(const Graph& graph, const std::string& filepath);
+// 同上，按options压缩权重段；压不小的块按原样存放
+Status SaveCompactModel(const Graph& graph, const std::string& filepath, const CompactModelSaveOptions& options);
+
+// 映射紧凑格式文件并重建图；权重张量是映射的视图（IsOwned()为false），
+// 映射由权重张量共同持有，最后一个权重释放后才解除。权重段压缩时权重张量是解压缓冲区的视图，
+// 缓冲区由权重张量共同持有，映射在加载返回前解除；也接受版本3的文件
+Status LoadCompactModel(const std::string& filepath, std::unique_ptr<Graph>& graph);
+// 同上，模型字节已在内存中（没有文件映射的平台，如浏览器里fetch得到的缓冲）：复制到64字节对齐的
+// 自有缓冲后重建图，权重张量是该缓冲的视图；data在返回后即可释放
+Status LoadCompactModelFromMemory(const void* data, size_t size, std::unique_ptr<Graph>& graph);
+
+// 多进程数据并行服务 (参考vLLM/Triton的多实例共享权重)：发布方把（通常已优化的）图以紧凑格式
+// 写入名为name的POSIX共享内存段（shm_open，名称以'/'开头），已存在的同名段被替换；
+// 工作进程用LoadCompactModelFromSharedMemory只读映射，权重页在所有进程间只驻留一份，
+// 加载也不需要解析。段在UnlinkSharedCompactModel之前一直存在，已映射的进程不受删除影响
+Status PublishCompactModel(const Graph& graph, const std::string& name);
+
+// 同上，写入封印（不可改写、不可改变大小）的匿名memfd（仅Linux），fd经fork继承或SCM_RIGHTS
+// 传给工作进程，由LoadCompactModelFromDescriptor映射；调用方负责关闭fd
+Status PublishCompactModelToMemfd(const Graph& graph, int* fd);
+
+// 映射发布的模型并重建图，权重张量是映射的视图（同LoadCompactModel）
+Status LoadCompactModelFromSharedMemory(const std::string& name, std::unique_ptr<Graph>& graph);
+Status LoadCompactModelFromDescriptor(int fd, std::unique_ptr<Graph>& graph);
+
+// 删除共享内存段的名称；内存在最后一个映射解除后释放
+Status UnlinkSharedCompactModel(const std::string& name);
+
+// 按文件头的魔数判断是否为紧凑格式，不依赖扩展名
+bool IsCompactModelFile(const std::string& filepath);
+bool IsCompactModelBuffer(const void* data, size_t size);
+
+// 模型内容哈希：覆盖节点（类型、名称、属性、连接）、图输入输出与权重的形状和数据，
+// 不依赖Value/Node的编号；用作优化图缓存的键
+uint64_t HashGraph(const Graph& graph);
+
+// 张量内容哈希：覆盖数据类型、形状与数据（与HashGraph使用同一个哈希函数），用于跨会话的权重去重
+uint64_t HashTensorData(const Tensor& tensor);
+
+} // namespace inferunity
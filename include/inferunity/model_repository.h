@@ -0,0 +1,127 @@
+#pragma once
+
+// 多模型托管 (参考Triton Inference Server的模型仓库与ONNX Runtime的跨会话共享initializer)：
+// 同一节点上托管多个由同一基座微调出的模型变体，它们的大部分权重逐字节相同。
+// SharedWeightStore按内容去重常量张量，ModelRepository在一个激活内存预算内托管多个会话
+
+#include "engine.h"
+#include "memory.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+// 跨会话的权重去重表：常量张量按内容哈希查找（命中后再逐字节确认），内容相同的只保留一份副本，
+// 各会话的常量Value指向同一个张量。副本放在只读映射的页上（没有mmap的平台上是普通堆内存），
+// 误写会直接报错而不会悄悄影响其他会话。表只持有弱引用，最后一个使用它的会话释放后副本随之释放
+class SharedWeightStore {
+public:
+    // 小于min_tensor_bytes的常量（形状、轴等小张量）不值得查表，保持各会话私有
+    explicit SharedWeightStore(size_t min_tensor_bytes = 1024);
+    
+    SharedWeightStore(const SharedWeightStore&) = delete;
+    SharedWeightStore& operator=(const SharedWeightStore&) = delete;
+    
+    // 把graph中的常量（没有生产者、不是图输入的CPU张量）换成共享副本；线程安全。
+    // numa_node >= 0时只与同一节点的副本共享，新副本放在该节点的内存上（每个节点各一份）
+    Status Deduplicate(Graph* graph, int numa_node = -1);
+    
+    // 存活的共享副本个数与总大小（每份只计一次）
+    size_t GetNumTensors() const;
+    size_t GetResidentBytes() const;
+    // 累计命中已有副本而省下的字节数
+    size_t GetDeduplicatedBytes() const;
+
+private:
+    struct Entry {
+        std::weak_ptr<Tensor> tensor;
+        int numa_node = -1;
+    };
+    
+    std::shared_ptr<Tensor> Intern(const std::shared_ptr<Tensor>& tensor, int numa_node);
+    
+    size_t min_tensor_bytes_;
+    mutable std::mutex mutex_;
+    std::unordered_multimap<uint64_t, Entry> entries_;
+    size_t deduplicated_bytes_ = 0;
+};
+
+struct ModelRepositoryOptions {
+    // 所有会话激活内存（执行状态与中间张量的arena，见InferenceSession::GetMemoryStats）的总预算，
+    // 0表示不限制。超出时按最久未用的顺序释放空闲会话的arena，下一次运行时重新分配；
+    // 正在运行的会话不会被释放，所以这是软上限
+    size_t memory_budget_bytes = 0;
+    // 跨会话共享内容相同的权重
+    bool share_weights = true;
+    size_t min_shared_weight_bytes = 1024;
+};
+
+// 会话的内存占用
+struct ModelMemoryUsage {
+    MemoryStats activation;        // 会话arena的记账（InferenceSession::GetMemoryStats）
+    size_t weight_bytes = 0;       // 会话引用的全部常量
+    size_t shared_weight_bytes = 0;  // 其中与其他会话共享的部分
+};
+
+// 模型仓库：按名称托管多个会话，会话共用一个SharedWeightStore，通过仓库的Run执行时参与
+// 激活内存预算的LRU淘汰。所有方法线程安全；同一个模型可以被多个线程同时运行
+class ModelRepository {
+public:
+    explicit ModelRepository(const ModelRepositoryOptions& options = ModelRepositoryOptions());
+    ~ModelRepository();
+    
+    ModelRepository(const ModelRepository&) = delete;
+    ModelRepository& operator=(const ModelRepository&) = delete;
+    
+    // 以name加载模型（name已存在时返回ERROR_INVALID_ARGUMENT）；options.shared_weights由仓库设置
+    Status LoadModel(const std::string& name, const std::string& filepath,
+                     const SessionOptions& options = SessionOptions());
+    Status LoadModelFromGraph(const std::string& name, std::unique_ptr<Graph> graph,
+                              const SessionOptions& options = SessionOptions());
+    // 卸载后正在进行的运行仍然完成，会话在最后一个运行结束后释放
+    Status UnloadModel(const std::string& name);
+    
+    bool HasModel(const std::string& name) const;
+    std::vector<std::string> GetModelNames() const;
+    // 直接取得会话：绕过仓库运行的不更新LRU，也不触发预算检查
+    std::shared_ptr<InferenceSession> GetSession(const std::string& name) const;
+    
+    // 运行前按模型规划的arena大小预留预算（必要时淘汰其他空闲会话），运行后再检查一次
+    Status Run(const std::string& name, const std::vector<Tensor*>& inputs,
+               std::vector<std::shared_ptr<Tensor>>& outputs);
+    
+    Status GetMemoryUsage(const std::string& name, ModelMemoryUsage* usage) const;
+    // 所有会话当前的激活内存之和
+    size_t GetActivationMemoryBytes() const;
+    // 因预算释放会话arena的次数
+    size_t GetNumEvictions() const;
+    
+    const ModelRepositoryOptions& GetOptions() const { return options_; }
+    const SharedWeightStore& GetWeightStore() const { return *weights_; }
+
+private:
+    struct Entry {
+        std::shared_ptr<InferenceSession> session;
+        uint64_t last_used = 0;
+        size_t in_flight = 0;
+    };
+    
+    Status AddSession(const std::string& name, std::unique_ptr<InferenceSession> session);
+    SessionOptions PrepareOptions(const SessionOptions& options) const;
+    // 需持有mutex_：在当前占用加上reserve超过预算时，按last_used从旧到新释放空闲会话（不含keep）
+    void EnforceBudget(const Entry* keep, size_t reserve);
+    size_t ActivationBytesLocked() const;
+    
+    ModelRepositoryOptions options_;
+    std::shared_ptr<SharedWeightStore> weights_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+    uint64_t clock_ = 0;
+    size_t evictions_ = 0;
+};
+
+} // namespace inferunity
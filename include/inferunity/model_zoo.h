@@ -0,0 +1,53 @@
+#pragma once
+
+// 基准模型库 (参考MLPerf Inference的基准模型与ONNX Model Zoo)：按公开模型的结构生成随机权重的图，
+// 基准测试不必下载模型文件，同一组选项在任何机器上得到相同的图与权重。
+// 权重按扇入缩放的均匀分布生成（参考PyTorch的默认初始化），激活在各层之间保持有限的量级；
+// 生成的图与导出的ONNX模型使用相同的算子（Conv + BatchNormalization、MatMul + Add等），
+// 由图优化按与真实模型相同的方式融合。注意力直接用FusedAttention表示
+//
+//   resnet50      ResNet-50 v1.5：瓶颈块[3, 4, 6, 3]，stride在3x3卷积上
+//   mobilenet_v3  MobileNetV3-Large：深度可分离倒残差块与SE；h-swish以Silu代替（没有HardSwish算子）
+//   bert_base     BERT-base编码器：12层，隐藏维768，12头，FFN 3072，GELU；不带attention mask与token type
+//   qwen_0.5b     Qwen2-0.5B形状的解码器（prefill）：24层，隐藏维896，14个查询头/2个键值头（GQA），
+//                 RoPE、RMSNorm、SwiGLU FFN 4864，词表151936
+//   dlrm          DLRM式推荐模型：稠密特征13维的底部MLP、26个嵌入表的求和池化、点积交互与顶部MLP
+
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+
+struct ZooModelOptions {
+    int64_t batch_size = 1;
+    // bert_base/qwen_0.5b为序列长度（默认128），dlrm为每个嵌入表每个样本的索引数（默认1）
+    int64_t sequence_length = 0;
+    int64_t image_size = 0;            // resnet50/mobilenet_v3的输入边长，0表示224
+    double width = 1.0;                // 通道数/隐藏维的倍数（Transformer按头数缩放，头维度不变）
+    double depth = 1.0;                // 每个阶段的块数/层数（dlrm为嵌入表数）的倍数，每个阶段至少保留1块
+    int64_t vocab_size = 0;            // bert_base/qwen_0.5b的词表大小，dlrm每个嵌入表的行数；0表示默认
+    uint64_t seed = 1;                 // 权重与示例输入的随机种子
+};
+
+struct ZooModelInfo {
+    std::string name;
+    std::string description;
+};
+
+// 可生成的模型
+const std::vector<ZooModelInfo>& GetZooModels();
+
+// 生成模型：图输入的Value带有一份合法的示例输入（词表内的token id、嵌入表内的索引），
+// 可直接作为Run的输入；名称未知或选项非法时返回ERROR_INVALID_ARGUMENT
+Status BuildZooModel(const std::string& name, const ZooModelOptions& options, std::unique_ptr<Graph>* graph);
+
+// 解析"name[:key=value,...]"形式的规格（键为batch/seq/image/width/depth/vocab/seed），
+// 例如"bert_base:batch=8,seq=384"；基准测试的模型列表以"zoo:"前缀引用
+Status ParseZooModelSpec(const std::string& spec, std::string* name, ZooModelOptions* options);
+
+} // namespace inferunity
@@ -0,0 +1,83 @@
+// NUMA拓扑、混合架构的核类型与节点亲和性
+// 参考ONNX Runtime的线程亲和性配置与oneDNN/TensorFlow的NUMA感知线程池：多路服务器上线程池按节点分组、
+// 内存池按节点分池，绑定到节点的会话只使用本节点的线程与内存，不跨插槽互联访问权重与激活。
+// 混合架构（Intel P/E核、ARM big.LITTLE）上线程池按核的相对算力切分并行循环，也可以只用性能核
+
+#pragma once
+
+#include "types.h"
+#include <cstddef>
+#include <vector>
+
+namespace inferunity {
+
+struct NumaNode {
+    int id = 0;             // 内核中的节点编号（/sys/devices/system/node/node<id>）
+    std::vector<int> cpus;  // 节点上进程可用的CPU
+};
+
+// 以下接口中的node均为nodes中的下标，而不是内核编号
+struct NumaTopology {
+    std::vector<NumaNode> nodes;
+};
+
+// 首次调用时读取/sys/devices/system/node，只保留进程亲和性掩码内有CPU的节点；
+// 非Linux或读取失败时返回包含全部CPU的单个节点
+const NumaTopology& GetNumaTopology();
+size_t GetNumNumaNodes();
+
+// 混合架构中的核类型
+enum class CoreType {
+    PERFORMANCE,  // 性能核（Intel P核、ARM的big/prime核）；非混合架构上所有核都是性能核
+    EFFICIENCY,   // 能效核（Intel E核、ARM的LITTLE核）
+};
+
+struct CpuCore {
+    int cpu = 0;
+    CoreType type = CoreType::PERFORMANCE;
+    int capacity = 1024;  // 相对算力，最快的核为1024（同Linux的cpu_capacity）
+};
+
+struct CpuCoreTopology {
+    std::vector<CpuCore> cores;  // 进程可用的CPU，按编号排序
+    bool hybrid = false;         // 存在能效核
+    
+    std::vector<int> PerformanceCpus() const;
+    // cpu不在cores中时返回1024
+    int CapacityOf(int cpu) const;
+};
+
+// 首次调用时检测进程亲和性掩码内各CPU的类型与算力：Intel混合架构读/sys/devices/cpu_core与cpu_atom
+// 的cpus列表，没有时逐核执行CPUID 1AH；算力取sysfs的cpu_capacity（ARM），没有时按cpuinfo_max_freq
+// 折算，都没有时能效核记为512。ARM上没有类型信息，算力低于最快核一半的记为能效核
+const CpuCoreTopology& GetCpuCoreTopology();
+
+// 当前线程的首选节点：内存池从该节点的空闲块分配，线程池把任务投递到该节点的线程组；-1表示未绑定。
+// 只记录在线程本地，不改变亲和性
+int GetCurrentNumaNode();
+void SetCurrentNumaNode(int node);
+
+// 把调用线程的CPU亲和性设为node上的CPU（仅Linux）
+Status BindCurrentThreadToNumaNode(int node);
+
+// 把[data, data + size)内的完整页设为优先从node分配（mbind MPOL_PREFERRED），只影响尚未触碰的页；
+// migrate为true时同时迁移已驻留的页。单节点、非Linux或内核不支持时返回false，内存不受影响
+bool BindMemoryToNumaNode(void* data, size_t size, int node, bool migrate = false);
+
+// 作用域内把当前线程的首选节点设为node；bind_thread时同时把线程绑定到节点的CPU（只在多节点时），
+// 析构时恢复原来的首选节点与亲和性。node<0或与当前的首选节点相同时不做任何事
+class NumaNodeScope {
+public:
+    explicit NumaNodeScope(int node, bool bind_thread = true);
+    ~NumaNodeScope();
+    
+    NumaNodeScope(const NumaNodeScope&) = delete;
+    NumaNodeScope& operator=(const NumaNodeScope&) = delete;
+
+private:
+    int previous_node_ = -1;
+    bool active_ = false;
+    std::vector<int> previous_cpus_;  // 非空表示需要恢复的亲和性
+};
+
+} // namespace inferunity
@@ -0,0 +1,37 @@
+#pragma once
+
+// 算子类型的驻留ID（参考MLIR的OperationName与LLVM的Intrinsic ID）：每个类型字符串在首次出现时分到
+// 进程内唯一的稠密整数，节点、融合模式、算子注册表与提供者的支持表都按ID比较和下标查表，
+// 图优化与提供者分配不再对类型字符串做哈希。ID只在进程内有效，不写入模型或缓存
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace inferunity {
+
+using OpTypeId = uint32_t;
+constexpr OpTypeId kInvalidOpTypeId = ~OpTypeId(0);
+
+// 返回op_type的ID，首次出现时分配（线程安全）
+OpTypeId InternOpType(const std::string& op_type);
+// 只查找不分配，未出现过时返回kInvalidOpTypeId
+OpTypeId FindOpType(const std::string& op_type);
+// ID对应的类型名；引用在进程内一直有效
+const std::string& GetOpTypeName(OpTypeId id);
+// 已分配的ID个数（所有ID都小于它），用作按ID下标的表的大小
+size_t GetOpTypeCount();
+
+// 构造时驻留的算子类型，融合模式等长期存在的常量用它代替字符串，可由字符串字面量隐式构造
+struct OpType {
+    OpTypeId id;
+    
+    OpType(const char* name) : id(InternOpType(name)) {}
+    OpType(const std::string& name) : id(InternOpType(name)) {}
+    
+    const std::string& GetName() const { return GetOpTypeName(id); }
+    bool operator==(const OpType& other) const { return id == other.id; }
+    bool operator!=(const OpType& other) const { return id != other.id; }
+};
+
+} // namespace inferunity
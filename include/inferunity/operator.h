@@ -2,7 +2,11 @@
 
 #include "types.h"
 #include "tensor.h"
+#include "tensor_view.h"
 #include "graph.h"
+#include "memory.h"
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <string>
@@ -12,40 +16,44 @@ namespace inferunity {
 
 // 前向声明
 class ExecutionContext;
+class LoraBatch;
 
-// 算子属性值（支持多种类型）
-class AttributeValue {
-public:
-    enum class Type {
-        FLOAT,
-        INT,
-        STRING,
-        FLOATS,
-        INTS,
-        TENSOR
-    };
-    
-    AttributeValue() : type_(Type::FLOAT) {}
-    explicit AttributeValue(float v) : type_(Type::FLOAT), float_val_(v) {}
-    explicit AttributeValue(int64_t v) : type_(Type::INT), int_val_(v) {}
-    explicit AttributeValue(const std::string& v) : type_(Type::STRING), string_val_(v) {}
-    explicit AttributeValue(const std::vector<float>& v) : type_(Type::FLOATS), floats_val_(v) {}
-    explicit AttributeValue(const std::vector<int64_t>& v) : type_(Type::INTS), ints_val_(v) {}
-    
-    Type GetType() const { return type_; }
-    float GetFloat() const { return float_val_; }
-    int64_t GetInt() const { return int_val_; }
-    const std::string& GetString() const { return string_val_; }
-    const std::vector<float>& GetFloats() const { return floats_val_; }
-    const std::vector<int64_t>& GetInts() const { return ints_val_; }
+// 只有元数据的张量描述，用于加载期的形状与类型推断；
+// constant指向常量输入的张量（如Reshape的目标形状），其余输入为nullptr
+struct TensorInfo {
+    Shape shape;
+    DataType dtype = DataType::UNKNOWN;
+    const Tensor* constant = nullptr;
+};
+
+// 切片别名的方向（见Operator::GetSliceAlias）
+enum class SliceAlias {
+    NONE,
+    INPUTS_IN_OUTPUT,   // Concat：各输入依次是输出中的切片
+    OUTPUTS_IN_INPUT,   // Split：各输出依次是第0个输入中的切片
+    INPUT_INSIDE_OUTPUT // Pad：第0个输入是输出内部的一块（见Operator::GetSliceOrigin）
+};
+
+// 算子的解析代价（参考Roofline模型与PyTorch的FlopCounterMode）：浮点运算数与读写的字节数，
+// 用于性能分析的屋顶线效率、代价模型分区与流水线阶段划分（见CostModel::EstimateCost）
+struct OperatorCost {
+    double flops = 0.0;
+    size_t bytes_read = 0;
+    size_t bytes_written = 0;
     
-private:
-    Type type_;
-    float float_val_;
-    int64_t int_val_;
-    std::string string_val_;
-    std::vector<float> floats_val_;
-    std::vector<int64_t> ints_val_;
+    size_t GetBytes() const { return bytes_read + bytes_written; }
+    // 算术强度（FLOP/字节），没有访存时为0
+    double GetArithmeticIntensity() const {
+        const size_t bytes = GetBytes();
+        return bytes ? flops / static_cast<double>(bytes) : 0.0;
+    }
+};
+
+// 算子在输入输出张量之外使用的内存（见Operator::EstimateMemory与InferenceSession::EstimateMemory）
+struct OperatorMemory {
+    size_t prepacked_bytes = 0;  // PrePack后算子持有的常量输入的变换结果
+    size_t workspace_bytes = 0;  // 算子实例在执行之间保留的工作区（如卷积的im2col矩阵）
+    size_t scratch_bytes = 0;    // 一次执行中临时使用、执行后即可复用的缓冲（如GEMM的线程私有打包缓冲）
 };
 
 // 算子接口
@@ -63,11 +71,91 @@ public:
     virtual Status InferOutputShape(const std::vector<Tensor*>& inputs,
                                    std::vector<Shape>& output_shapes) const = 0;
     
+    // 推断第output_index个输出的数据类型；默认与第一个输入相同
+    virtual DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                         size_t output_index) const {
+        (void)output_index;
+        return inputs.empty() ? DataType::FLOAT32 : inputs[0]->GetDataType();
+    }
+    
+    // 只依据元数据推断全部输出的形状与类型，不分配张量数据（参考ONNX的InferenceContext）；
+    // 默认把描述包装成不带数据的张量，转调InferOutputShape与InferOutputDataType
+    virtual Status InferOutputInfo(const std::vector<TensorInfo>& inputs,
+                                   std::vector<TensorInfo>& outputs) const;
+    
+    // 按输入输出的形状估计一次执行的代价；默认按逐元素算子计（见GetElementwiseFlops），
+    // 读全部输入、写全部输出。MatMul/Conv/归一化/注意力等按各自的计算量覆盖
+    virtual OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                                      const std::vector<TensorInfo>& outputs) const;
+    
+    // 只依据元数据估计PrePack与执行会另外使用的内存，不分配也不打包；常量输入的constant不为空。
+    // 默认不预打包、不使用工作区
+    virtual OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const {
+        (void)inputs;
+        return OperatorMemory();
+    }
+    
     // 执行算子
     virtual Status Execute(const std::vector<Tensor*>& inputs,
                           const std::vector<Tensor*>& outputs,
                           ExecutionContext* ctx) = 0;
     
+    // 轻量调用约定（见TensorView）：返回true的算子实现ExecuteViews，输入输出是栈上的POD视图数组，
+    // 一次调用不分配内存；这样的算子一般继承TensorViewOperator，Execute经适配转到ExecuteViews
+    virtual bool SupportsViewExecution() const { return false; }
+    virtual Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) {
+        (void)inputs;
+        (void)outputs;
+        (void)ctx;
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, GetName() + " does not support view execution");
+    }
+    
+    // 只改布局的算子（参考PyTorch的view语义）：输出可以是第0个输入存储上的步长视图，
+    // 不分配输出也不执行Execute。视图算子的Execute仍需可用，输出不便做成视图时回退到拷贝
+    virtual bool IsViewOperator() const { return false; }
+    
+    // 按实际输入构造输出视图；返回nullptr表示这次不能做成视图
+    virtual std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const {
+        (void)inputs;
+        return nullptr;
+    }
+    
+    // 原地执行（参考ONNX Runtime的KernelDef::MayInplace）：返回输出0可以复用其缓冲的输入下标，-1表示不能。
+    // 只有逐元素先读后写同一位置、输出与该输入大小相同的内核可以声明；是否真的复用由内存规划决定
+    virtual int GetInPlaceInput() const { return -1; }
+    
+    // 切片别名（参考MXNet的内存规划与TVM的buffer aliasing）：切分轴之前各维乘积为1时切片在内存中连续相邻，
+    // 内存规划把切片直接放进整体的缓冲（见PlanMemory），内核发现数据已就位时不再拷贝；
+    // 声明的算子在切片不在整体缓冲内时仍需照常拷贝
+    virtual SliceAlias GetSliceAlias() const { return SliceAlias::NONE; }
+    
+    // INPUT_INSIDE_OUTPUT时第0个输入在输出中的位置：除第*axis轴从*start开始外各维与输出对齐。
+    // inputs为形状推断得到的张量（常量输入带数据），算子已设置节点属性；返回false表示这次不能放进输出
+    virtual bool GetSliceOrigin(const std::vector<Tensor*>& inputs, int* axis, int64_t* start) const {
+        (void)inputs;
+        (void)axis;
+        (void)start;
+        return false;
+    }
+    
+    // 常量输入预打包（参考ONNX Runtime的OpKernel::PrePack）：会话加载时对每个常量初始化器输入调用一次，
+    // input_shapes为形状推断得到的全部输入形状（可能含未知维度）。算子把变换后的权重保存在自身，
+    // 执行时若输入仍是同一张量则直接使用；*is_packed返回是否保存了打包结果
+    virtual Status PrePack(int input_index, const Tensor& tensor,
+                           const std::vector<Shape>& input_shapes, bool* is_packed) {
+        (void)input_index;
+        (void)tensor;
+        (void)input_shapes;
+        *is_packed = false;
+        return Status::Ok();
+    }
+    
+    // 形状特化（参考TVM按静态形状生成专用内核）：编译节点时调用一次，input_shapes为形状推断得到的输入形状
+    //（可能含未知维度）。算子可按常见配置选定行长等为模板参数的专用内核，执行时实际形状不符仍走通用内核
+    virtual void SpecializeForShapes(const std::vector<Shape>& input_shapes) {
+        (void)input_shapes;
+    }
+    
     // 获取属性
     virtual void SetAttribute(const std::string& key, const AttributeValue& value) {
         attributes_[key] = value;
@@ -79,10 +167,79 @@ public:
         return it != attributes_.end() ? it->second : default_value;
     }
     
+    bool HasAttribute(const std::string& key) const {
+        return attributes_.find(key) != attributes_.end();
+    }
+    
+    // 类型化属性读取（参考ONNX Runtime的OpNodeProtoHelper::GetAttrOrDefault）
+    // 字符串属性经解析后单个整数为INT、逗号列表为INTS，这里统一做类型兼容
+    int64_t GetIntAttribute(const std::string& key, int64_t default_value) const {
+        auto it = attributes_.find(key);
+        if (it == attributes_.end()) return default_value;
+        switch (it->second.GetType()) {
+            case AttributeValue::Type::INT: return it->second.GetInt();
+            case AttributeValue::Type::FLOAT: return static_cast<int64_t>(it->second.GetFloat());
+            case AttributeValue::Type::INTS:
+                return it->second.GetInts().size() == 1 ? it->second.GetInts()[0] : default_value;
+            default: return default_value;
+        }
+    }
+    
+    float GetFloatAttribute(const std::string& key, float default_value) const {
+        auto it = attributes_.find(key);
+        if (it == attributes_.end()) return default_value;
+        switch (it->second.GetType()) {
+            case AttributeValue::Type::FLOAT: return it->second.GetFloat();
+            case AttributeValue::Type::INT: return static_cast<float>(it->second.GetInt());
+            default: return default_value;
+        }
+    }
+    
+    std::vector<int64_t> GetIntsAttribute(const std::string& key,
+                                          const std::vector<int64_t>& default_value = {}) const {
+        auto it = attributes_.find(key);
+        if (it == attributes_.end()) return default_value;
+        switch (it->second.GetType()) {
+            case AttributeValue::Type::INTS: return it->second.GetInts();
+            case AttributeValue::Type::INT: return {it->second.GetInt()};
+            default: return default_value;
+        }
+    }
+    
+    std::string GetStringAttribute(const std::string& key, const std::string& default_value) const {
+        auto it = attributes_.find(key);
+        if (it == attributes_.end() || it->second.GetType() != AttributeValue::Type::STRING) {
+            return default_value;
+        }
+        return it->second.GetString();
+    }
+    
+    // 子图属性，不存在或类型不符时返回nullptr
+    std::shared_ptr<Graph> GetGraphAttribute(const std::string& key) const {
+        auto it = attributes_.find(key);
+        if (it == attributes_.end() || it->second.GetType() != AttributeValue::Type::GRAPH) {
+            return nullptr;
+        }
+        return it->second.GetGraph();
+    }
+
 protected:
     std::unordered_map<std::string, AttributeValue> attributes_;
 };
 
+// 以视图为原生接口的算子的基类：旧接口Execute把Tensor*翻译成栈上的视图后转调ExecuteViews
+// （张量个数不超过kMaxInlineViews时不分配内存），两种调用方式得到相同的结果
+class TensorViewOperator : public Operator {
+public:
+    static constexpr size_t kMaxInlineViews = 16;
+    
+    bool SupportsViewExecution() const override { return true; }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) final;
+};
+
 // 算子注册表
 class OperatorRegistry {
 public:
@@ -96,6 +253,11 @@ public:
     // 注册算子
     void Register(const std::string& op_type, OperatorFactory factory) {
         factories_[op_type] = factory;
+        const OpTypeId id = InternOpType(op_type);
+        if (id >= factories_by_id_.size()) {
+            factories_by_id_.resize(id + 1);
+        }
+        factories_by_id_[id] = factory;
     }
     
     // 创建算子
@@ -107,6 +269,14 @@ public:
         return nullptr;
     }
     
+    // 按驻留ID创建（如Node::GetOpTypeId()），下标查表，不哈希类型字符串
+    std::unique_ptr<Operator> Create(OpTypeId op_type) const {
+        if (op_type < factories_by_id_.size() && factories_by_id_[op_type]) {
+            return factories_by_id_[op_type]();
+        }
+        return nullptr;
+    }
+    
     // 检查是否已注册
     bool IsRegistered(const std::string& op_type) const {
         return factories_.find(op_type) != factories_.end();
@@ -120,11 +290,31 @@ public:
         }
         return ops;
     }
-    
+
 private:
     std::unordered_map<std::string, OperatorFactory> factories_;
+    std::vector<OperatorFactory> factories_by_id_;  // 按OpTypeId下标
 };
 
+// 把节点的全部属性复制到算子（参考ONNX Runtime的OpKernelInfo）；属性已是类型化的值，不再解析
+void ApplyNodeAttributes(const Node& node, Operator* op);
+
+// 解析代价的公共估计（Operator::EstimateCost的实现使用）
+// 描述的字节数；未知维度按1计
+size_t GetTensorInfoBytes(const TensorInfo& info);
+// 逐元素算子每个输出元素的近似运算数：算术与比较为1，超越函数按多项式近似的运算数计，
+// 只搬运数据的算子（Reshape/Transpose/Concat/Cast等）为0，未知的算子类型为1
+double GetElementwiseFlops(const std::string& op_type);
+// 每个输出元素flops_per_element次运算，读全部输入、写全部输出
+OperatorCost EstimateElementwiseCost(const std::vector<TensorInfo>& inputs,
+                                     const std::vector<TensorInfo>& outputs, double flops_per_element);
+// 矩阵乘：每个输出元素做k次乘加，另有epilogue_flops次逐元素运算（bias、激活）
+OperatorCost EstimateMatMulCost(const std::vector<TensorInfo>& inputs, const std::vector<TensorInfo>& outputs,
+                                int64_t k, double epilogue_flops);
+// 卷积：权重为inputs[weight_index]的OIHW，每个输出元素做Cin/group×kh×kw次乘加
+OperatorCost EstimateConvCost(const std::vector<TensorInfo>& inputs, const std::vector<TensorInfo>& outputs,
+                              size_t weight_index, double epilogue_flops);
+
 // 显式初始化所有算子（确保静态注册代码被执行）
 void InitializeOperators();
 
@@ -141,6 +331,53 @@ void InitializeOperators();
         static OpRegistrar_##op_class g_registrar_##op_class; \
     }
 
+// 算子内并行配置 (参考ONNX Runtime的intra_op_num_threads)
+// 线程来自共享的ThreadPool；元素数不足min_work_per_thread的块不再拆分，小张量保持单线程
+struct IntraOpParallelism {
+    int num_threads = 1;                    // 单个算子最多使用的线程数（含调用线程）
+    int64_t min_work_per_thread = 16384;    // 每个线程至少处理的元素数
+};
+
+// 运行的取消令牌与截止时间（参考ONNX Runtime的RunOptions::terminate与gRPC的deadline）：
+// 执行器在节点之间检查，算子内的并行循环在执行每一块前检查（见CancellationScope）；触发后剩余的块与节点
+// 不再执行，运行返回ERROR_CANCELLED（Cancel）或ERROR_TIMEOUT（已过截止时间）
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    CancellationToken() = default;
+    explicit CancellationToken(Clock::time_point deadline) : deadline_(deadline) {}
+    
+    static std::shared_ptr<CancellationToken> Create() { return std::make_shared<CancellationToken>(); }
+    static std::shared_ptr<CancellationToken> WithTimeout(Clock::duration timeout) {
+        return std::make_shared<CancellationToken>(Clock::now() + timeout);
+    }
+    
+    // 可在运行进行中从任意线程调用（例如客户端断开时）
+    void Cancel() { cancelled_.store(true, std::memory_order_release); }
+    bool IsCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+    Clock::time_point GetDeadline() const { return deadline_; }
+    
+    // 已取消或已过截止时间；一旦为true不再变回false
+    bool IsTriggered() const {
+        return IsCancelled() || (deadline_ != Clock::time_point::max() && Clock::now() >= deadline_);
+    }
+    
+    Status Check() const {
+        if (IsCancelled()) {
+            return Status::Error(StatusCode::ERROR_CANCELLED, "Run cancelled");
+        }
+        if (deadline_ != Clock::time_point::max() && Clock::now() >= deadline_) {
+            return Status::Error(StatusCode::ERROR_TIMEOUT, "Run deadline exceeded");
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    const Clock::time_point deadline_ = Clock::time_point::max();
+};
+
 // 执行上下文
 class ExecutionContext {
 public:
@@ -150,21 +387,71 @@ public:
     DeviceType GetDeviceType() const { return device_type_; }
     void SetDeviceType(DeviceType device) { device_type_ = device; }
     
-    // 获取设备特定的资源
+    // 设备特定的资源（如BLAS句柄、设备流池）：每个类型在首次使用时分到进程内唯一的槽位，
+    // 查找是一次数组下标访问，不再按类型名字符串哈希
     template<typename T>
     T* GetDeviceResource() const {
-        auto it = device_resources_.find(typeid(T).name());
-        return it != device_resources_.end() ? static_cast<T*>(it->second) : nullptr;
+        const size_t slot = ResourceSlot<T>();
+        return slot < device_resources_.size() ? static_cast<T*>(device_resources_[slot]) : nullptr;
     }
     
     template<typename T>
     void SetDeviceResource(T* resource) {
-        device_resources_[typeid(T).name()] = resource;
+        const size_t slot = ResourceSlot<T>();
+        if (slot >= device_resources_.size()) {
+            device_resources_.resize(slot + 1, nullptr);
+        }
+        device_resources_[slot] = resource;
     }
     
+    // 算子内并行
+    const IntraOpParallelism& GetIntraOpParallelism() const { return intra_op_; }
+    void SetIntraOpParallelism(const IntraOpParallelism& config) { intra_op_ = config; }
+    
+    // 当前节点使用的设备流，nullptr表示设备的默认流
+    void* GetStream() const { return stream_; }
+    void SetStream(void* stream) { stream_ = stream; }
+    
+    // 本次运行的取消令牌，nullptr表示不可取消；由调度器在节点之间检查
+    const CancellationToken* GetCancellationToken() const { return cancellation_; }
+    void SetCancellationToken(const CancellationToken* token) { cancellation_ = token; }
+    bool IsCancelled() const { return cancellation_ && cancellation_->IsTriggered(); }
+    
+    // 本次运行选用的LoRA适配器（见lora.h），nullptr表示只用基座权重；MatMul按自己的权重名查找增量
+    const LoraBatch* GetLoraBatch() const { return lora_; }
+    void SetLoraBatch(const LoraBatch* batch) { lora_ = batch; }
+    
+    // 当前节点编译时声明的每线程暂存字节数（Operator::EstimateMemory的scratch_bytes），由后端在执行前设置；
+    // ParallelForOuter按它为各工作线程预留暂存区
+    size_t GetScratchBytes() const { return scratch_bytes_; }
+    void SetScratchBytes(size_t bytes) { scratch_bytes_ = bytes; }
+    
+    // 从调用线程的暂存区（见ScratchArena）切出count个T，64字节对齐；节点执行或并行块结束后整体回收，
+    // 不经过内存池。在算子内并行的块中调用时取得的是执行该块的工作线程的暂存区
+    template<typename T>
+    T* AllocateScratch(size_t count) const {
+        return ScratchArena::ForCurrentThread().Allocate<T>(count);
+    }
+
 private:
     DeviceType device_type_;
-    std::unordered_map<std::string, void*> device_resources_;
+    void* stream_ = nullptr;
+    const CancellationToken* cancellation_ = nullptr;
+    const LoraBatch* lora_ = nullptr;
+    IntraOpParallelism intra_op_;
+    size_t scratch_bytes_ = 0;
+    std::vector<void*> device_resources_;  // 按ResourceSlot<T>()下标
+    
+    static size_t NextResourceSlot() {
+        static std::atomic<size_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    template<typename T>
+    static size_t ResourceSlot() {
+        static const size_t slot = NextResourceSlot();
+        return slot;
+    }
 };
 
 } // namespace inferunity
@@ -2,6 +2,7 @@
 
 #include "types.h"
 #include "graph.h"
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -20,8 +21,40 @@ public:
     // Pass依赖关系
     virtual std::vector<std::string> GetDependencies() const { return {}; }
     
-    // 是否可重复运行
+    // 是否可重复运行：Optimizer反复运行可重复的Pass直到图不再变化（不动点）
     virtual bool IsRepeatable() const { return false; }
+    
+    // 只改写含这些算子的图，图中一个都没有时Optimizer跳过该Pass；空表示总是运行
+    virtual std::vector<std::string> GetTargetOpTypes() const { return {}; }
+    
+    // 运行并报告是否改变了图。默认调用Run，比较前后的结构指纹（节点、算子类型、连接关系与值类型），
+    // 只改写属性或常量内容的Pass需要准确标志时应覆盖
+    virtual Status Apply(Graph* graph, bool* modified);
+};
+
+// Pass之间共享的图级分析：Optimize开始时计算一次，只在某次Pass改变了图之后重新计算
+struct GraphAnalysis {
+    std::vector<size_t> op_counts;  // 按OpTypeId下标（见op_type.h）
+    size_t num_nodes = 0;
+    uint64_t fingerprint = 0;
+    
+    static GraphAnalysis Compute(const Graph& graph);
+    size_t GetOpCount(OpTypeId op_type) const {
+        return op_type < op_counts.size() ? op_counts[op_type] : 0;
+    }
+    bool HasAnyOp(const std::vector<std::string>& op_types) const;
+};
+
+// 单个Pass在最近一次Optimize中的统计
+struct PassStatistics {
+    std::string name;
+    int runs = 0;             // 实际运行次数，可重复的Pass包括确认不动点的最后一次
+    bool skipped = false;     // 图中没有目标算子
+    bool modified = false;    // 至少一次运行改变了图
+    bool converged = true;    // 可重复的Pass在迭代上限内到达不动点
+    double time_ms = 0.0;     // 全部运行的墙钟时间
+    size_t nodes_before = 0;
+    size_t nodes_after = 0;
 };
 
 // 优化器管理器
@@ -42,9 +75,18 @@ public:
     // 获取已注册的Pass列表
     std::vector<std::string> GetRegisteredPasses() const;
     
+    // 可重复Pass的最大运行次数（默认8），达到上限仍在变化时停止迭代并记录未收敛
+    void SetMaxIterations(int max_iterations) { max_iterations_ = max_iterations > 0 ? max_iterations : 1; }
+    int GetMaxIterations() const { return max_iterations_; }
+    
+    // 最近一次Optimize中各Pass的统计，按运行顺序
+    const std::vector<PassStatistics>& GetPassStatistics() const { return statistics_; }
+
 private:
     std::vector<std::unique_ptr<OptimizationPass>> passes_;
     std::unordered_map<std::string, OptimizationPass*> pass_map_;
+    int max_iterations_ = 8;
+    std::vector<PassStatistics> statistics_;
     
     // 按依赖关系排序Pass
     std::vector<OptimizationPass*> SortPasses() const;
@@ -59,14 +101,75 @@ public:
     Status Run(Graph* graph) override;
 };
 
+// Conv+BatchNormalization折叠：推理时BN参数为常量，离线改写Conv的权重和bias后删除BN节点
+// W' = W * γ/σ, b' = (b - μ) * γ/σ + β，其中σ = sqrt(var + ε)
+class ConvBNFoldingPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "ConvBNFolding"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"BatchNormalization"}; }
+};
+
 // 死代码消除
 class DeadCodeEliminationPass : public OptimizationPass {
 public:
     std::string GetName() const override { return "DeadCodeElimination"; }
     Status Run(Graph* graph) override;
+    // 每次只删除没有使用者的一层节点，上游随之变为死代码
+    bool IsRepeatable() const override { return true; }
+};
+
+// 公共子表达式消除（参考ONNX Runtime的CommonSubexpressionElimination）：先按内容合并不超过4KB的相同常量，
+// 再按拓扑序以(算子类型, 带类型的属性, 输入)为键合并重复节点，重复的Shape/Gather/Unsqueeze链与
+// 同一输入上的相同Transpose只保留一份；随机算子与输出是图输出的重复节点不合并
+class CommonSubexpressionEliminationPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "CommonSubexpressionElimination"; }
+    Status Run(Graph* graph) override;
+};
+
+// 恒等算子消除：Identity、推理模式的Dropout（mask输出未使用）、输入输出形状相同的Reshape、
+// 恒等perm的Transpose、互逆的Transpose对与目标类型等于输入类型的Cast，使用者直接读取其输入；
+// 被删节点的输出是图输出时由输入接替并沿用输出名（输入本身是图输入或常量时保留节点）
+class IdentityEliminationPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "IdentityElimination"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override {
+        return {"Identity", "Dropout", "Reshape", "Transpose", "Cast"};
+    }
+};
+
+// 转置下沉（参考ONNX Runtime的TransposeOptimizer）：导出的图在每个逐元素算子前后把布局转来转去。
+// Transpose移到其唯一的逐元素使用者之后（其他输入须是同一perm的Transpose或常量，常量在加载时按逆置换重排），
+// 相邻的Transpose合并为一个、复合为恒等时整对删除；停在MatMul前的交换后两维的Transpose由
+// OperatorFusionPass折叠进transA/transB
+class TransposeOptimizationPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "TransposeOptimization"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"Transpose"}; }
+};
+
+// 横向融合（参考TensorRT的horizontal layer fusion与TASO的同输入MatMul合并）：读同一输入的兄弟算子合并为一个更大的算子。
+// 常量二维权重的MatMul（注意力的Q/K/V投影）按输出列拼接权重，各自唯一使用者为常量bias的Add时bias一并拼接；
+// 卷积核、步长、填充、膨胀相同且group为1的Conv（Inception分支的1x1卷积）按输出通道拼接权重与bias，
+// 各自唯一使用者都是Relu时一并合并。原来的输出改由Slice从合并结果切出（运行时为不拷贝的步长视图）。
+// 应在ConvBN折叠之后、算子融合之前运行，合并后的MatMul+Add、Conv+Relu再由OperatorFusionPass融合
+class HorizontalFusionPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "HorizontalFusion"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"MatMul", "Conv"}; }
 };
 
 // 算子融合
+// 融合规则以声明式模式描述（见src/optimizers/fusion_pattern.h），分三个阶段各自应用到不动点：
+// 1. 分解子图还原：Transpose折叠进MatMul、注意力(MatMul-Softmax-MatMul)、LayerNorm/RMSNorm分解、x*sigmoid(x)
+//    随后同形的残差Add并入其后的LayerNorm/RMSNorm（AddLayerNorm/AddRMSNorm，和作为第二个输出）；
+//    常量表上的Gather+ReduceSum/ReduceMean(axes=1)还原为EmbeddingBag
+// 2. 计算密集算子+后处理：Conv+BN+ReLU、Conv+Add+ReLU、Conv+ReLU、BN+ReLU、MatMul+Add(+GELU/ReLU)
+// 3. 剩余的逐元素算子链合并为FusedElementwise
 class OperatorFusionPass : public OptimizationPass {
 public:
     std::string GetName() const override { return "OperatorFusion"; }
@@ -77,19 +180,162 @@ public:
     bool CanFuseMatMulAdd(Node* matmul, Node* add) const;
     bool CanFuseConvReLU(Node* conv, Node* relu) const;
     bool CanFuseBNReLU(Node* bn, Node* relu) const;
+    bool CanFoldTransposeIntoMatMul(Node* transpose, Node* matmul) const;
+};
+
+// 跨层深度优先分块（参考Halide的compute_at与fused-layer CNN加速器）：输入为NCHW FLOAT32的
+// Conv/FusedConvReLU/MaxPool/AveragePool(+Relu)单消费者链合并为FusedTileGroup，按输出行分块逐块算完整条链，
+// 中间特征图只以块的形式留在缓存中。只在链中最大的中间结果（单个样本）超过tile_bytes时合并，
+// 每组最多max_stages级以限制halo行的重复计算。应在OperatorFusionPass之后、内存布局优化之前运行
+class DepthFirstTilingPass : public OptimizationPass {
+public:
+    explicit DepthFirstTilingPass(int64_t tile_bytes = 256 * 1024, size_t max_stages = 4)
+        : tile_bytes_(tile_bytes), max_stages_(max_stages) {}
     
+    std::string GetName() const override { return "DepthFirstTiling"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override {
+        return {"Conv", "FusedConvReLU", "MaxPool", "AveragePool"};
+    }
+
 private:
-    Status FuseConvBNReLU(Graph* graph, Node* conv, Node* bn, Node* relu);
-    Status FuseMatMulAdd(Graph* graph, Node* matmul, Node* add);
-    Status FuseConvReLU(Graph* graph, Node* conv, Node* relu);
-    Status FuseBNReLU(Graph* graph, Node* bn, Node* relu);
+    int64_t tile_bytes_;
+    size_t max_stages_;
 };
 
-// 内存布局优化
+// 内存布局优化（参考ONNX Runtime的NchwcTransformer）：把group为1、权重为常量的Conv（含FusedConvReLU/
+// FusedConvAddReLU）改为分块通道布局的NchwcConv，并沿MaxPool/AveragePool/BatchNormalization、
+// 逐元素激活与同形的Add/Sub/Mul传播分块布局，全局池化直接从分块布局输出NCHW；其余算子与图输出之前
+// 插入ReorderOutput转回NCHW，第一次进入分块布局的值前插入ReorderInput。block_size为0时按CPU取值（AVX-512为16，其余为8）
 class MemoryLayoutOptimizationPass : public OptimizationPass {
 public:
+    explicit MemoryLayoutOptimizationPass(int64_t block_size = 0) : block_size_(block_size) {}
+    
     std::string GetName() const override { return "MemoryLayoutOptimization"; }
     Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override {
+        return {"Conv", "FusedConvReLU", "FusedConvAddReLU"};
+    }
+
+private:
+    int64_t block_size_;
+};
+
+// Q/DQ折叠（参考ONNX Runtime的QDQ transformer）：先消去量化参数相同的Q(DQ(x))，再把
+// DQ(x), DQ(w) -> Conv(-> Relu) -> Q改写为QLinearConv，DQ(a), DQ(b) -> MatMul -> Q改写为QLinearMatMul；
+// 要求激活按张量量化、权重为常量（Conv按输出通道、MatMul按列或按张量），浮点bias折算为INT32
+class QDQFusionPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "QDQFusion"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"QuantizeLinear", "DequantizeLinear"}; }
+};
+
+// 混合精度（参考ONNX Runtime的float16转换工具与TensorRT的混合精度策略）：MatMul/FusedMatMulAdd
+// 的二维FLOAT32常量权重转为weight_dtype（FLOAT16或BFLOAT16）存储，GEMM打包时再转换回FP32；
+// 激活、bias以及LayerNorm/Softmax等归约算子保持FP32。权重被其他算子共用时保持不变。
+// bf16_compute为true时给这些节点加上compute_precision="bf16"，CPU有AVX-512-BF16/AMX-BF16时原生计算。
+// node_names不为空时只改写这些节点（见SearchMixedPrecision）
+class MixedPrecisionPass : public OptimizationPass {
+public:
+    explicit MixedPrecisionPass(DataType weight_dtype = DataType::BFLOAT16, bool bf16_compute = false,
+                                std::vector<std::string> node_names = {})
+        : weight_dtype_(weight_dtype), bf16_compute_(bf16_compute), node_names_(std::move(node_names)) {}
+    
+    std::string GetName() const override { return "MixedPrecision"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"MatMul", "FusedMatMulAdd"}; }
+
+private:
+    DataType weight_dtype_;
+    bool bf16_compute_;
+    std::vector<std::string> node_names_;
+};
+
+// 仅权重量化（参考ONNX Runtime的MatMul4BitsQuantizer）：MatMul与无激活FusedMatMulAdd的二维FLOAT32
+// 常量权重按列每block_size个元素一组以RTN量化为bits位（4或8）无符号整数，FP16 scale带零点，
+// 节点改写为MatMulNBits；激活保持FP32，适合权重带宽受限的LLM解码
+class WeightOnlyQuantizationPass : public OptimizationPass {
+public:
+    explicit WeightOnlyQuantizationPass(int64_t bits = 4, int64_t block_size = 32)
+        : bits_(bits), block_size_(block_size) {}
+    
+    std::string GetName() const override { return "WeightOnlyQuantization"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"MatMul", "FusedMatMulAdd"}; }
+
+private:
+    int64_t bits_;
+    int64_t block_size_;
+};
+
+// 稀疏权重（参考XNNPACK的稀疏推理与NVIDIA Ampere的2:4结构化稀疏）：常量权重的非零比例低于density_threshold时，
+// MatMul/FusedMatMulAdd改写为SparseMatMul，权重按块稀疏CSR（8x1或4x1块）或2:4结构化稀疏存放，
+// 取总字节数最少的格式，不比稠密存储省内存的权重保持原样
+class SparseWeightPass : public OptimizationPass {
+public:
+    explicit SparseWeightPass(float density_threshold = 0.3f) : density_threshold_(density_threshold) {}
+    
+    std::string GetName() const override { return "SparseWeight"; }
+    Status Run(Graph* graph) override;
+    std::vector<std::string> GetTargetOpTypes() const override { return {"MatMul", "FusedMatMulAdd"}; }
+
+private:
+    float density_threshold_;
+};
+
+// 张量并行切分（参考Megatron-LM (Shoeybi et al., 2019)的列并行/行并行线性层）：把图改写为world_size个rank中
+// 第rank个的分片。权重为二维常量的MatMul/FusedMatMulAdd按输出列切分（列并行），输出沿最后一维分片；
+// 分片沿逐元素算子、Transpose、拆分/合并分片维的Reshape（多头注意力的[B,S,H*D] <-> [B,S,H,D]）、
+// 非分片轴上的Softmax与分片维为批维的MatMul传播。以沿最后一维分片的值为输入的常量权重MatMul按行切分
+// （行并行），之后插入AllReduce求和，bias只保留在rank 0；其余算子与图输出之前插入AllGather。
+// 插入的集合通信节点引用group_id对应的CollectiveGroup（见collectives.h），各rank按相同顺序编号（tag）。
+// 应在常量折叠之后、算子融合之前运行，分片值的形状改为分片后的形状
+class TensorParallelShardingPass : public OptimizationPass {
+public:
+    TensorParallelShardingPass(int world_size, int rank, int64_t group_id)
+        : world_size_(world_size), rank_(rank), group_id_(group_id) {}
+    
+    std::string GetName() const override { return "TensorParallelSharding"; }
+    Status Run(Graph* graph) override;
+
+private:
+    int world_size_;
+    int rank_;
+    int64_t group_id_;
+};
+
+// 内存感知的执行顺序调度（参考Serenity (Ahn et al., MLSys 2020)的内存感知调度）：在节点的拓扑序中选一个
+// 峰值活跃内存较小的，先按“执行后活跃内存净增最少”贪心排出顺序，再对峰值所在的连续窗口（12个节点）
+// 用状态压缩DP求窗口内的最优排列。活跃内存按静态内存规划的口径计算（有生产者、形状静态的CPU中间张量，
+// 不含图输出，不考虑原地执行与切片别名）。峰值降低时写回节点顺序（Graph::ReorderNodes），
+// TopologicalSort、内存规划、执行计划与序列化都沿用；应在其他改写图结构的Pass之后运行
+class MemoryAwareSchedulingPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "MemoryAwareScheduling"; }
+    Status Run(Graph* graph) override;
+};
+
+// 权重按执行顺序重排（参考TensorRT的权重流式布局）：节点读取的CPU常量按首次使用的先后拷进一块64字节对齐的缓冲，
+// 推理时权重按地址递增被读取，便于预取；不超过small_tensor_bytes的小张量（bias、归一化的scale等）集中放在
+// 缓冲开头，每个张量从缓存行边界开始。拷贝期间新旧两份权重同时存在；应在其他改写权重的Pass之后运行
+class CacheOptimizationPass : public OptimizationPass {
+public:
+    explicit CacheOptimizationPass(size_t small_tensor_bytes = 4096) : small_tensor_bytes_(small_tensor_bytes) {}
+    
+    std::string GetName() const override { return "CacheOptimization"; }
+    Status Run(Graph* graph) override;
+
+private:
+    size_t small_tensor_bytes_;
+};
+
+// 初始化器64字节对齐：起始地址未对齐的CPU常量（如外部数据中任意偏移处的权重）拷到对齐的新缓冲，
+// 内核可以对权重使用对齐加载；已对齐的张量不动
+class MemoryAlignmentPass : public OptimizationPass {
+public:
+    std::string GetName() const override { return "MemoryAlignment"; }
+    Status Run(Graph* graph) override;
 };
 
 // 子图替换
@@ -97,7 +343,7 @@ class SubgraphReplacementPass : public OptimizationPass {
 public:
     std::string GetName() const override { return "SubgraphReplacement"; }
     Status Run(Graph* graph) override;
-    
+
 private:
     // 辅助函数：检查张量是否全为0
     bool IsZeroTensor(Tensor* tensor) const;
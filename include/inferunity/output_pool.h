@@ -0,0 +1,62 @@
+#pragma once
+
+// 每次运行的输出缓冲回收池（参考Triton的响应缓冲复用与ONNX Runtime的OrtValue分配器复用）：
+// 返回所有权的Run把输出交给调用方时套上一个句柄，调用方释放最后一个句柄后缓冲回到会话的空闲表，
+// 而不是还给分配器；下一次运行先从空闲表取缓冲交给生产输出的算子直接写入，形状相同时
+// 既不分配也不拷贝。空闲表中的缓冲只属于会话，交出后只属于一个调用方，并发的运行互不共享
+
+#include "tensor.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace inferunity {
+
+struct OutputBufferPoolStats {
+    uint64_t reused = 0;     // 取到的空闲缓冲被算子直接写入或作为拷贝目标
+    uint64_t allocated = 0;  // 没有可用的空闲缓冲，输出由算子新分配或拷贝进新张量
+    uint64_t returned = 0;   // 调用方释放句柄后回到空闲表的缓冲
+    uint64_t dropped = 0;    // 空闲表已满而释放给分配器的缓冲
+    size_t free_buffers = 0;
+    size_t free_bytes = 0;
+};
+
+// 按图输出下标分别维护空闲表，同一个输出在相邻的运行之间形状通常不变。会话每次加载模型时新建一个池，
+// 旧池上交出的句柄释放时张量直接还给分配器。所有方法线程安全
+class OutputBufferPool : public std::enable_shared_from_this<OutputBufferPool> {
+public:
+    // 每个输出最多保留max_free_per_output个空闲缓冲
+    OutputBufferPool(size_t num_outputs, size_t max_free_per_output);
+
+    OutputBufferPool(const OutputBufferPool&) = delete;
+    OutputBufferPool& operator=(const OutputBufferPool&) = delete;
+
+    // 第index个输出最近归还的空闲缓冲，没有时返回nullptr；由运行交给生产者，形状不符时算子另行分配
+    std::shared_ptr<Tensor> Acquire(size_t index);
+    // 形状、类型与设备都相同的空闲缓冲，没有时新建一个（作为拷贝目标）
+    std::shared_ptr<Tensor> Acquire(size_t index, const Shape& shape, DataType dtype, DeviceType device);
+    // 运行没有用上的缓冲放回空闲表
+    void Release(size_t index, std::shared_ptr<Tensor> tensor);
+    // 运行是否用上了Acquire(index)取到的缓冲，计入统计
+    void RecordUse(bool reused);
+
+    // 把tensor交给调用方：返回的句柄与tensor指向同一个张量，最后一个句柄释放时张量回到第index个
+    // 输出的空闲表（池已销毁时直接释放）。tensor不能再被其他地方持有
+    std::shared_ptr<Tensor> Hand(size_t index, std::shared_ptr<Tensor> tensor);
+
+    OutputBufferPoolStats GetStats() const;
+    size_t GetNumOutputs() const { return free_.size(); }
+
+private:
+    void Return(size_t index, std::shared_ptr<Tensor> tensor);
+
+    size_t max_free_per_output_;
+    mutable std::mutex mutex_;
+    std::vector<std::vector<std::shared_ptr<Tensor>>> free_;  // 每个输出一个表，表尾为最近归还
+    OutputBufferPoolStats stats_;
+};
+
+} // namespace inferunity
@@ -0,0 +1,110 @@
+#pragma once
+
+// 基于代价模型的图分区 (参考ONNX Runtime的GetCapability/节点分配与TVM的异构执行)：
+// 估计每个节点在各执行提供者上的耗时与每条跨设备边的传输耗时，把图切成分配给不同提供者的连续子图，
+// 使端到端耗时最小；只在分区边界插入MemcpyToDevice/MemcpyFromDevice节点
+
+#include "types.h"
+#include "backend.h"
+#include "runtime.h"
+#include "operator.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class Node;
+class Value;
+
+// 设备的解析代价参数：耗时 = launch_overhead_us + max(FLOPs / flops_per_us, 字节数 / bytes_per_us)
+struct DeviceCostProfile {
+    double flops_per_us = 5.0e4;      // 每微秒浮点运算数
+    double bytes_per_us = 2.0e4;      // 每微秒访存字节数
+    double launch_overhead_us = 1.0;  // 每个算子的固定开销
+};
+
+// 代价模型：实测数据库优先，没有记录时使用FLOP/字节的解析估计
+class CostModel {
+public:
+    CostModel();
+    virtual ~CostModel() = default;
+    
+    void SetDeviceProfile(DeviceType device, const DeviceCostProfile& profile);
+    const DeviceCostProfile& GetDeviceProfile(DeviceType device) const;
+    // 主机与设备之间的传输（如PCIe）：带宽与每次拷贝的固定延迟
+    void SetTransferProfile(double bytes_per_us, double latency_us);
+    
+    // 实测耗时（微秒）：key为节点名或算子类型，节点名优先
+    void RecordNodeTime(const std::string& provider, const std::string& key, double time_us);
+    // 录入某个提供者上的Profile结果（按节点名）
+    void RecordProfile(const std::string& provider, const ProfilingResult& result);
+    
+    // 节点在提供者上的预计耗时（微秒）；拷贝节点的耗时计入边的传输代价，这里为0
+    virtual double EstimateNodeTime(const Node* node, const ExecutionProvider* provider) const;
+    // 把bytes字节从src设备搬到dst设备的耗时；两个不同的非主机设备之间经主机中转
+    virtual double EstimateTransferTime(size_t bytes, DeviceType src, DeviceType dst) const;
+    
+    // 解析模型：按节点属性创建已注册的算子，调用Operator::EstimateCost（MatMul/Conv按乘加计数，
+    // 逐元素算子按每个元素的运算数）；未注册的算子按逐元素估计
+    static OperatorCost EstimateCost(const Node* node);
+    static double EstimateFlops(const Node* node);
+    static size_t EstimateBytes(const Node* node);
+
+private:
+    std::unordered_map<int, DeviceCostProfile> profiles_;
+    double transfer_bytes_per_us_ = 1.2e4;
+    double transfer_latency_us_ = 10.0;
+    std::unordered_map<std::string, double> measured_;  // "provider/key" -> 耗时
+};
+
+struct PartitionResult {
+    std::unordered_map<const Node*, ExecutionProvider*> assignment;  // 含插入的拷贝节点
+    size_t num_partitions = 0;         // 拓扑序上分配给同一提供者的连续子图个数
+    size_t num_copies = 0;             // 插入的拷贝节点数
+    double estimated_latency_us = 0.0; // 顺序执行时节点耗时与边界传输耗时之和
+};
+
+class GraphPartitioner {
+public:
+    // cost_model为nullptr时使用默认参数的CostModel
+    explicit GraphPartitioner(std::shared_ptr<const CostModel> cost_model = nullptr);
+    
+    // 只计算分配，不修改图
+    Status Assign(const Graph* graph, const std::vector<ExecutionProvider*>& providers,
+                  PartitionResult* result) const;
+    // 计算分配并在分区边界插入拷贝节点；图输入、常量和图输出位于主机上
+    Status Partition(Graph* graph, const std::vector<ExecutionProvider*>& providers,
+                     PartitionResult* result) const;
+    
+    const CostModel& GetCostModel() const { return *cost_model_; }
+
+private:
+    std::shared_ptr<const CostModel> cost_model_;
+};
+
+struct DelegationResult {
+    std::unordered_map<const Node*, ExecutionProvider*> assignment;  // 融合节点 -> delegate
+    size_t num_subgraphs = 0;          // 替换成kDelegatedSubgraphOp节点的子图个数
+    size_t num_delegated_nodes = 0;    // 子图内的原节点总数
+};
+
+// 子图委托 (参考ONNX Runtime的GetCapability与融合节点)：把native_providers都不支持的节点
+// 按拓扑序生长成尽量大的连通子图（合并不能产生经由子图外节点的环），每个子图抽取为独立的Graph交给
+// delegate->CompileSubgraph，并在原图中替换为一个kDelegatedSubgraphOp节点；
+// 子图用到的常量随子图一起交给delegate
+Status DelegateUnsupportedSubgraphs(Graph* graph, const std::vector<ExecutionProvider*>& native_providers,
+                                    ExecutionProvider* delegate, DelegationResult* result);
+
+// 优先认领 (参考ONNX Runtime TensorRT EP的GetCapability)：delegate->CanCompileNode认领的节点即使原生提供者
+// 也支持，同样按上面的规则生长成子图交给delegate编译；不足min_nodes个节点的子图编译收益抵不过
+// 边界拷贝，留给原生提供者。应在DelegateUnsupportedSubgraphs之前调用
+Status DelegateClaimedSubgraphs(Graph* graph, ExecutionProvider* delegate, size_t min_nodes,
+                                DelegationResult* result);
+
+// 抽取子图时边界值在子图内的占位：只携带value的形状与类型，不持有数据；value没有张量时返回nullptr
+std::shared_ptr<Tensor> MetadataTensor(const Value* value);
+
+} // namespace inferunity
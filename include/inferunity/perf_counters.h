@@ -0,0 +1,106 @@
+#pragma once
+
+// 硬件性能计数器 (参考Linux perf与PAPI的预设事件PAPI_TOT_CYC/PAPI_TOT_INS/PAPI_L3_TCM/PAPI_SP_OPS)
+// 通过perf_event_open为进程的每个线程打开一组只计用户态的计数器：周期、指令、末级缓存访问与未命中，
+// Intel CPU上另开FP_ARITH_INST_RETIRED的单精度事件，按向量宽度加权得到浮点运算数。
+// 访存字节按末级缓存未命中数×缓存行估计。计数器只覆盖Open时已存在的线程，因此应在线程池创建之后打开
+
+#include "types.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace inferunity {
+
+struct HardwareCounterValues {
+    static constexpr uint64_t kCacheLineBytes = 64;
+    
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t llc_references = 0;
+    uint64_t llc_misses = 0;
+    uint64_t fp_ops = 0;       // 单精度浮点运算数（按向量宽度加权，FMA计2次）
+    bool has_fp_ops = false;   // CPU提供浮点运算事件（目前为Intel）
+    
+    double GetIpc() const {
+        return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+    }
+    // 末级缓存未命中换算的访存字节数（每次未命中一条缓存行）
+    uint64_t GetLlcMissBytes() const { return llc_misses * kCacheLineBytes; }
+    
+    HardwareCounterValues& operator+=(const HardwareCounterValues& other);
+};
+
+// 两次读数之差（计数器单调，差值不会为负）
+HardwareCounterValues operator-(const HardwareCounterValues& end, const HardwareCounterValues& start);
+
+class HardwareCounters {
+public:
+    HardwareCounters();
+    ~HardwareCounters();
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+    
+    // 为进程当前的所有线程打开计数器；非Linux、内核或虚拟机不提供PMU、
+    // 权限不足（perf_event_paranoid）时返回错误，计数器保持关闭
+    Status Open();
+    void Close();
+    bool IsOpen() const;
+    
+    // 各线程自Open以来的累计值之和（计数器多路复用时按启用/运行时间缩放）
+    HardwareCounterValues Read() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// 屋顶线模型的峰值（参考Williams等的Roofline模型）：peak_gflops为峰值算力，peak_gbps为峰值访存带宽
+struct RooflinePeaks {
+    double peak_gflops = 0.0;
+    double peak_gbps = 0.0;
+    
+    // 脊点：算术强度（FLOP/字节）低于它的算子受带宽限制，峰值未知时为0
+    double GetRidgePoint() const { return peak_gbps > 0 ? peak_gflops / peak_gbps : 0.0; }
+    // 以峰值算力与带宽执行flops次运算、搬运bytes字节的最短耗时（毫秒），即max(计算耗时, 访存耗时)；
+    // 实测耗时除以它的倒数为屋顶线效率
+    double GetRooflineTimeMs(double flops, double bytes) const;
+};
+
+// 峰值算力估计：每核2个FMA单元 × 向量宽度 × 2（乘加） × 主频 × 线程池线程数
+double EstimatePeakGflops(double cpu_ghz);
+// 峰值带宽估计：线程池并行拷贝256MB，取三次中最快的一次（读+写计两次字节）
+double MeasureMemoryBandwidthGbps();
+
+// 本机实测的能力（由inferunity_calibrate测得，见tools/calibrate.cpp）：各指令集的FP32 FMA峰值、
+// 各级缓存与内存的带宽、线程池派发延迟。加载后（见LoadMachineProfile）Profile工具的屋顶线分析与
+// 默认的CostModel（图分区）使用实测值，而不是按CPU特性与主频的估计
+struct MachineProfile {
+    std::string cpu_model;
+    size_t threads = 0;                                // 测量全核峰值与带宽时的线程数
+    std::map<std::string, double> core_peak_gflops;    // 单核峰值，按指令集（scalar/sse/avx2/avx512/neon）
+    std::map<std::string, double> all_core_peak_gflops;
+    // 全部线程合计的读+写带宽（GB/s），工作集分别落在L1、L2、L3与内存
+    double l1_gbps = 0.0;
+    double l2_gbps = 0.0;
+    double l3_gbps = 0.0;
+    double dram_gbps = 0.0;
+    double dispatch_latency_us = 0.0;                  // 每个线程一块的空ParallelFor的往返耗时
+    
+    // 可用指令集中最高的全核峰值与内存带宽
+    RooflinePeaks GetRooflinePeaks() const;
+    
+    // 文本格式：首行为版本头，之后每行一个"键 值"，指令集峰值的键为core_peak_gflops.<isa>
+    Status Save(const std::string& path) const;
+    Status Load(const std::string& path);
+};
+
+// 进程内使用的机器画像；之后创建的CostModel按它设置CPU的代价参数
+void SetMachineProfile(const MachineProfile& profile);
+// 没有加载过时返回false
+bool GetMachineProfile(MachineProfile* profile);
+// Load后SetMachineProfile
+Status LoadMachineProfile(const std::string& path);
+
+} // namespace inferunity
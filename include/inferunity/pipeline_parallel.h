@@ -0,0 +1,89 @@
+#pragma once
+
+// 跨设备的流水线并行 (参考GPipe的micro-batch流水线与Megatron-LM的pipeline parallel)：
+// 与张量并行互补，深而不宽的模型按代价把优化后的图的拓扑序切成连续的阶段（见PipelineScheduler），
+// 每个阶段是一个加载在自己设备上的会话。相邻阶段之间经通信组的Send/Recv（CUDA上为ncclSend/ncclRecv，
+// 否则为主机实现）传递边界张量，形状等元数据经主机上的有界队列先行送达。
+// 每个阶段有一个计算线程和一个发送线程：算完第i个micro-batch后把边界张量交给发送线程，
+// 随即开始第i+1个，传输与计算重叠；阶段s处理第i个micro-batch时阶段s-1已在处理第i+1个
+
+#include "types.h"
+#include "tensor.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class InferenceSession;
+class CollectiveGroup;
+
+// 一个阶段的子图与边界；张量按名称引用，原图中没有名称的值命名为"value_<id>"
+struct PipelineStageGraph {
+    std::unique_ptr<Graph> graph;       // 只含本阶段节点的子图，常量随节点带走；加载进会话后为空
+    std::vector<std::string> inputs;    // 子图输入：本阶段用到的原图输入与上一阶段送来的边界张量
+    std::vector<std::string> received;  // 从上一阶段收到的边界张量（含本阶段不用、只是转发的）
+    std::vector<std::string> sent;      // 发给下一阶段的边界张量（后面的阶段还要用到的）
+    std::vector<std::string> outputs;   // 子图输出：sent中本阶段算出的部分与本阶段算出的原图输出
+    double cost = 0.0;
+};
+
+struct PipelineStagePartition {
+    std::vector<PipelineStageGraph> stages;
+    std::vector<std::string> graph_inputs;   // 原图输入，Run的micro-batch按此顺序
+    std::vector<std::string> graph_outputs;  // 原图输出，Run的结果按此顺序
+};
+
+// 按代价把图的拓扑序切成num_stages个连续阶段，使最大阶段代价最小；node_costs按节点名给出代价
+// （如CostModel::EstimateNodeTime），未给出的节点按EstimateNodeCost估计。
+// 节点数少于阶段数、或原图输出不是节点的输出时返回错误
+Status SplitPipelineStages(const Graph& graph, size_t num_stages,
+                           const std::unordered_map<std::string, double>& node_costs,
+                           PipelineStagePartition* partition);
+
+class PipelineParallelExecutor {
+public:
+    // sessions[s]已加载partition.stages[s]的子图（阶段的graph已交给会话），group的rank s即阶段s，
+    // 边界张量的接收缓冲分配在device_type上；queue_capacity为相邻阶段之间最多排队的micro-batch数
+    static Status Create(PipelineStagePartition partition, std::vector<std::unique_ptr<InferenceSession>> sessions,
+                         std::shared_ptr<CollectiveGroup> group, DeviceType device_type, size_t queue_capacity,
+                         std::unique_ptr<PipelineParallelExecutor>* executor);
+    ~PipelineParallelExecutor();
+
+    PipelineParallelExecutor(const PipelineParallelExecutor&) = delete;
+    PipelineParallelExecutor& operator=(const PipelineParallelExecutor&) = delete;
+
+    // 各micro-batch（按原图输入顺序）依次流过全部阶段，outputs[i]按原图输出顺序，所有权属于调用方。
+    // 一个micro-batch失败不影响其他的；返回下标最小的失败micro-batch的错误。同一时间只执行一次Run
+    Status Run(const std::vector<std::vector<Tensor*>>& micro_batches,
+               std::vector<std::vector<std::shared_ptr<Tensor>>>* outputs);
+
+    size_t GetNumStages() const { return stages_.size(); }
+    const PipelineStageGraph& GetStage(size_t stage) const { return stages_[stage]; }
+    InferenceSession* GetStageSession(size_t stage) const { return sessions_[stage].get(); }
+
+private:
+    struct Route;
+    struct Message;
+    class Channel;
+    struct RunState;
+
+    PipelineParallelExecutor() = default;
+    void StageLoop(RunState* run, size_t stage);
+    void SendLoop(RunState* run, size_t stage);
+
+    std::vector<PipelineStageGraph> stages_;
+    std::vector<Route> routes_;
+    std::vector<std::string> graph_inputs_;
+    std::vector<std::string> graph_outputs_;
+    std::vector<std::unique_ptr<InferenceSession>> sessions_;
+    std::shared_ptr<CollectiveGroup> group_;
+    size_t queue_capacity_ = 2;
+    DeviceType device_type_ = DeviceType::CPU;
+    std::mutex run_mutex_;
+};
+
+} // namespace inferunity
@@ -0,0 +1,32 @@
+#pragma once
+
+// 图像输入的融合预处理 (参考TensorRT/Triton DALI的图像预处理与OpenVINO的PrePostProcessor)：
+// 在图输入之前插入ImagePreprocess算子，客户端直接传入uint8 NHWC图像，缩放、归一化、HWC->CHW与类型转换
+// 在会话内一遍完成，不再在Run之前分几遍处理整幅图像；模型启用分块布局时预处理直接写出NCHWc
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+
+struct ImagePreprocessOptions {
+    std::vector<float> mean;           // 每通道均值（按模型输入的通道顺序），为空表示0
+    std::vector<float> std;            // 每通道标准差，为空表示1
+    float scale = 1.0f;                // 减均值之前乘的系数，如1/255：out = (x * scale - mean) / std
+    bool reverse_channels = false;     // 客户端图像的通道顺序与模型相反（BGR <-> RGB）
+    // 客户端图像的尺寸，-1为动态；与模型输入的H、W不同时先缩放到模型的尺寸
+    int64_t input_height = -1;
+    int64_t input_width = -1;
+    std::string resize_mode = "linear";  // linear / nearest，half_pixel坐标
+};
+
+// 把图输入input_name（为空时取第一个输入，FLOAT32或FLOAT16的[N, C, H, W]，C、H、W已知）换成同名的
+// UINT8 [N, input_height, input_width, C]输入，经ImagePreprocess得到原来的值（改名为<name>_preprocessed）
+Status PrependImagePreprocess(Graph* graph, const ImagePreprocessOptions& options,
+                              const std::string& input_name = "");
+
+} // namespace inferunity
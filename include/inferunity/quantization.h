@@ -0,0 +1,115 @@
+#pragma once
+
+// 训练后静态量化 (参考ONNX Runtime的quantize_static与TensorRT的INT8校准)：
+// 1. CalibrationRunner在用户数据集上执行浮点模型，统计可量化节点（Conv/MatMul）输入输出的激活范围；
+// 2. QuantizeGraph按范围在激活上插入QuantizeLinear/DequantizeLinear，常量权重按输出通道对称量化为INT8，
+//    后接DequantizeLinear；
+// 3. QDQFusionPass（见optimizer.h）把DQ -> Conv/MatMul(-> Relu) -> Q折叠成QLinearConv/QLinearMatMul整数核，
+//    相邻的Q(DQ(x))在参数相同时直接消去。CPU提供者的QuantizeModel执行第3步
+
+#include "types.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class Tensor;
+class Value;
+
+enum class CalibrationMethod {
+    MIN_MAX,     // 观测到的最小/最大值
+    PERCENTILE,  // 两端各去掉(100 - percentile)/2%的离群值
+    ENTROPY      // 选取使截断后分布与量化分布KL散度最小的阈值（参考TensorRT的熵校准）
+};
+
+// 激活范围，校准结果总是包含0（零点必须能精确表示）
+struct TensorRange {
+    float min = 0.0f;
+    float max = 0.0f;
+};
+
+// 值的校准键 -> 激活范围
+using CalibrationTable = std::unordered_map<std::string, TensorRange>;
+
+// 值的名称；未命名的值为"value_<id>"（与ONNX导出的命名一致）
+std::string CalibrationKey(const Value* value);
+
+struct QuantizationOptions {
+    DataType activation_dtype = DataType::INT8;  // INT8或UINT8（非对称，带零点）；权重总是INT8对称
+    CalibrationMethod calibration_method = CalibrationMethod::MIN_MAX;
+    float percentile = 99.99f;                   // PERCENTILE保留的比例（%）
+    int num_histogram_bins = 2048;               // PERCENTILE/ENTROPY的直方图精度
+    bool per_channel = true;                     // 权重按输出通道量化，否则按张量
+    // 权重只用7位（[-63, 63]，参考ONNX Runtime的reduce_range）：相邻两个权重之和不超过128，
+    // 没有VNNI的x86上也能走u8s8的maddubs路径而不饱和
+    bool reduce_range = false;
+    std::vector<std::string> op_types = {"Conv", "MatMul"};
+    // 不为空时只校准与量化这些节点（按节点名，见SearchMixedPrecision）
+    std::vector<std::string> node_names;
+};
+
+// 校准运行器：在graph的副本上把需要观测的激活加为图输出，用CPU提供者顺序执行数据集
+// （每个样本按图输入顺序给出全部输入）；直方图方法先统计范围，再遍历一遍数据集建立直方图
+class CalibrationRunner {
+public:
+    explicit CalibrationRunner(const QuantizationOptions& options = QuantizationOptions())
+        : options_(options) {}
+    
+    Status Run(const Graph& graph, const std::vector<std::vector<std::shared_ptr<Tensor>>>& dataset,
+               CalibrationTable* table) const;
+    
+    const QuantizationOptions& GetOptions() const { return options_; }
+
+private:
+    QuantizationOptions options_;
+};
+
+// 按校准范围改写图；没有校准范围、权重不是FLOAT32常量的节点保持浮点
+Status QuantizeGraph(Graph* graph, const CalibrationTable& table,
+                     const QuantizationOptions& options = QuantizationOptions());
+
+// 混合精度搜索的精度指标
+enum class PrecisionAccuracyMetric {
+    MAX_RELATIVE_ERROR,  // 各样本各输出的max|y - y_ref| / max|y_ref|取最大，不超过tolerance
+    TOP1_AGREEMENT       // 第一个输出按最后一维取argmax，与FP32一致的行所占比例不低于tolerance
+};
+
+struct PrecisionSearchOptions {
+    PrecisionAccuracyMetric metric = PrecisionAccuracyMetric::MAX_RELATIVE_ERROR;
+    double tolerance = 0.01;
+    // 每层依次尝试的精度（从低到高，第一个满足精度的被采用）：INT8按QuantizeGraph插入Q/DQ
+    // （quantization.op_types中的Conv/MatMul），FLOAT16/BFLOAT16按MixedPrecisionPass以半精度存储权重（MatMul）
+    std::vector<DataType> candidates = {DataType::INT8, DataType::BFLOAT16};
+    QuantizationOptions quantization;  // INT8的校准与量化选项，node_names由搜索填写
+    bool bf16_compute = false;         // 同MixedPrecisionPass
+    size_t max_layers = 0;             // 只尝试代价最高的前max_layers层，0表示全部
+    std::string output_path;           // 不为空时把结果图以原生格式（SaveCompactModel）写出
+};
+
+// 一层的搜索结果
+struct LayerPrecision {
+    std::string node_name;
+    std::string op_type;
+    double time_ms = 0.0;                    // 剖析得到的耗时
+    double estimated_flops = 0.0;
+    DataType precision = DataType::FLOAT32;  // 采用的精度，没有满足精度的候选时为FLOAT32
+};
+
+struct PrecisionSearchResult {
+    std::vector<LayerPrecision> layers;  // 按代价从高到低
+    double accuracy = 0.0;               // 结果图的精度指标（相对误差或一致率）
+    size_t evaluations = 0;              // 在数据集上评估过的候选图个数
+};
+
+// 自动混合精度搜索（参考TensorRT的逐层精度回退与Intel Neural Compressor的精度驱动调优）：
+// 在数据集上校准并以FP32的输出为参考，按剖析得到的各层耗时（相同时按估计的浮点运算数）从高到低，
+// 逐层把精度降到第一个仍满足精度要求的候选，否则保持FP32。结果图是插入了Q/DQ、权重转为半精度的
+// 未优化图，以enable_quantization加载时由提供者折叠Q/DQ
+Status SearchMixedPrecision(const Graph& graph, const std::vector<std::vector<std::shared_ptr<Tensor>>>& dataset,
+                            const PrecisionSearchOptions& options, std::unique_ptr<Graph>* result_graph,
+                            PrecisionSearchResult* result = nullptr);
+
+} // namespace inferunity
@@ -0,0 +1,83 @@
+#pragma once
+
+// 推理结果缓存（参考Triton Inference Server的response cache）：完全相同的请求（同一张图片、
+// 同一段prompt前缀的embedding）不再执行图，直接返回上次的输出。
+// 键为各输入的dtype、形状与数据字节的XXH64哈希；条目按最久未用淘汰，使缓存的输出总字节数
+// 不超过容量，可设置存活时间（模型外部的数据更新后旧结果自动失效）
+
+#include "tensor.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+// 64位xxHash（XXH64），每周期吸收32字节
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed = 0);
+
+struct ResultCacheOptions {
+    size_t capacity_bytes = size_t(64) << 20;  // 缓存的输出张量总字节数上限
+    double ttl_ms = 0.0;                        // 条目的存活时间，0表示不过期
+};
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;     // 为腾出容量淘汰的条目
+    uint64_t expirations = 0;   // 查找时发现已过期而删除的条目
+    size_t entries = 0;
+    size_t bytes = 0;
+    
+    double GetHitRate() const {
+        const uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+    }
+};
+
+// 输入到输出的LRU缓存。条目保存输出的副本，命中时也返回副本，调用方修改返回的张量不影响缓存。
+// 所有方法线程安全
+class ResultCache {
+public:
+    explicit ResultCache(const ResultCacheOptions& options = ResultCacheOptions());
+    
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+    
+    // 计算输入的键；有输入不在CPU上、不连续或没有数据时返回false，这样的请求不缓存
+    static bool ComputeKey(const std::vector<Tensor*>& inputs, uint64_t* key);
+    
+    // 命中且未过期时把输出的副本写入outputs并返回true
+    bool Lookup(uint64_t key, std::vector<std::shared_ptr<Tensor>>* outputs);
+    // 存入outputs的副本；输出不在CPU上或单个结果超过容量时不存
+    void Insert(uint64_t key, const std::vector<std::shared_ptr<Tensor>>& outputs);
+    // 删除所有条目（重新加载模型后旧结果失效），统计计数保留
+    void Clear();
+    
+    ResultCacheStats GetStats() const;
+    const ResultCacheOptions& GetOptions() const { return options_; }
+
+private:
+    struct Entry {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        size_t bytes = 0;
+        int64_t inserted_ns = 0;
+        std::list<uint64_t>::iterator lru;   // 在lru_中的位置，表头为最近使用
+    };
+    
+    // 需持有mutex_
+    void EraseLocked(std::unordered_map<uint64_t, Entry>::iterator it);
+    
+    ResultCacheOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    std::list<uint64_t> lru_;
+    ResultCacheStats stats_;
+};
+
+} // namespace inferunity
@@ -8,6 +8,8 @@
 #include "graph.h"
 #include "operator.h"
 #include "backend.h"
+#include "execution_plan.h"
+#include "perf_counters.h"
 #include <memory>
 #include <vector>
 #include <functional>
@@ -15,6 +17,9 @@
 #include <condition_variable>
 #include <future>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 
 namespace inferunity {
 
@@ -40,7 +45,17 @@ public:
     std::vector<Node*> GetExecutionOrder(const Graph* graph) const override;
 };
 
+// 节点代价估计：CostModel::EstimateCost在默认CPU代价参数下的屋顶线耗时（纳秒，至少为1），
+// 用于关键路径优先级与流水线阶段划分
+int64_t EstimateNodeCost(const Node* node);
+
+// 把按执行顺序排列的代价切成num_stages个连续区间，使最大区间代价最小（元素不少于num_stages时区间均非空）；
+// 返回num_stages + 1个边界，第s个区间为[bounds[s], bounds[s + 1])
+std::vector<size_t> PartitionByCost(const std::vector<double>& costs, size_t num_stages);
+
 // PipelineScheduler
+// 把拓扑序按代价（SetNodeCosts给出的实测值，否则为EstimateNodeCost）切成连续的阶段；
+// 跨micro-batch的流水线执行见PipelineExecutor
 class PipelineScheduler : public Scheduler {
 public:
     explicit PipelineScheduler(int num_stages = 4);
@@ -48,13 +63,22 @@ public:
                    const std::vector<Backend*>& backends,
                    ExecutionContext* ctx) override;
     std::vector<Node*> GetExecutionOrder(const Graph* graph) const override;
+    
+    // 按节点名给出的代价（如ProfilingResult中的耗时），未给出的节点使用估计值
+    void SetNodeCosts(const std::unordered_map<std::string, double>& costs) { node_costs_ = costs; }
+    const std::vector<std::vector<Node*>>& GetStages() const { return stages_; }
 private:
     int num_stages_;
     std::vector<std::vector<Node*>> stages_;
+    std::unordered_map<std::string, double> node_costs_;
     void PartitionGraph(const Graph* graph);
 };
 
 // ParallelScheduler
+// 基于依赖计数的DAG执行器（参考ONNX Runtime的ParallelExecutor）：
+// 节点在共享线程池上执行，就绪节点按关键路径长度优先调度；就绪集合无锁，
+// 完成节点的线程直接接着执行其优先级最高的新就绪后继，只为其余的后继唤醒辅助线程。
+// ctx带有取消令牌时每个节点开始前检查，触发后不再开始新的节点
 class ParallelScheduler : public Scheduler {
 public:
     explicit ParallelScheduler(int num_threads = 0);
@@ -62,8 +86,29 @@ public:
                    const std::vector<Backend*>& backends,
                    ExecutionContext* ctx) override;
     std::vector<Node*> GetExecutionOrder(const Graph* graph) const override;
+    
+    // 图结构变化后丢弃缓存的依赖关系，下一次Schedule时重建
+    void Invalidate();
+
 private:
+    struct DagPlan {
+        const Graph* graph = nullptr;
+        std::vector<Backend*> backends;
+        std::vector<Node*> nodes;                 // 拓扑序
+        std::vector<Backend*> providers;          // 每个节点分配的执行提供者
+        std::vector<int> dependency_counts;       // 只计入图内生产者节点（去重）
+        std::vector<std::vector<int>> consumers;  // 按优先级降序
+        std::vector<int64_t> priorities;          // 到汇点的关键路径长度
+        std::vector<int> ranks;                   // 按优先级降序的名次，即就绪集合中的位置
+        std::vector<int> by_rank;                 // 名次到节点的映射
+        std::vector<int> initial_ready;           // 无生产者依赖的节点
+    };
+    
+    Status BuildPlan(const Graph* graph, const std::vector<Backend*>& backends);
+    
     int num_threads_;
+    mutable std::mutex plan_mutex_;
+    std::shared_ptr<const DagPlan> plan_;
 };
 
 // 执行模式
@@ -78,6 +123,48 @@ struct ExecutionOptions {
     bool enable_profiling = false;
     int max_parallel_streams = 1;
     std::string backend_preference = "";  // 后端偏好
+    int intra_op_num_threads = 0;  // 算子内线程数，0表示使用线程池全部线程
+    int64_t intra_op_min_work_per_thread = 16384;
+    // Profile时逐节点采集硬件计数器（见perf_counters.h），不可用时只记录耗时
+    bool profile_hardware_counters = false;
+    // 取消令牌：执行计划在每个节点前后检查，触发后返回其错误；并行循环在执行期间跳过剩余的块
+    std::shared_ptr<CancellationToken> cancellation;
+    // 权重流式驻留（见WeightStreamingSchedule）：只对构建它的计划生效，按顺序执行步骤时预取与回收权重页
+    std::shared_ptr<const WeightStreamingSchedule> weight_streaming;
+    // 跨节点的权重预取（见WeightPrefetcher）：只对构建它的计划生效，每个步骤执行前推进预取目标
+    std::shared_ptr<WeightPrefetcher> weight_prefetcher;
+    // 本次运行选用的LoRA适配器（见LoraScope），nullptr表示只用基座权重
+    std::shared_ptr<const LoraBatch> lora;
+};
+
+// 性能分析期间张量的分配与释放（见MemoryTimeline）
+struct MemoryEvent {
+    size_t step = 0;              // 所在节点在node_profiles中的序号；图输入为0
+    std::string node_name;        // 分配时为生产者，释放时为最后一个使用者；图输入为空
+    std::string tensor_name;
+    int64_t bytes = 0;            // 分配为正，释放为负
+    size_t live_bytes = 0;        // 事件之后存活的字节数
+    double time_ms = 0.0;         // 相对运行开始
+};
+
+// 存活字节数随执行的变化：节点输出绑定时记为分配，执行计划释放最后一次使用的张量时记为释放。
+// 视图与原地执行的输出和输入共用缓冲，不重复计入；常量不计入
+struct MemoryTimeline {
+    struct LiveTensor {
+        std::string tensor_name;
+        std::string producer;     // 生产者节点名，图输入为空
+        size_t bytes = 0;
+    };
+    
+    std::vector<MemoryEvent> events;
+    size_t peak_bytes = 0;
+    size_t peak_step = 0;         // 峰值出现的节点序号
+    std::string peak_node;
+    std::vector<LiveTensor> live_at_peak;  // 峰值时存活的张量，按字节数从大到小
+    
+    // JSON：events数组、peak与live_at_peak，可与trace文件一起分析
+    std::string ToJson() const;
+    Status WriteJson(const std::string& path) const;
 };
 
 // 性能分析结果
@@ -86,23 +173,274 @@ struct ProfilingResult {
         std::string node_name;
         std::string op_type;
         double execution_time_ms;
-        size_t memory_used_bytes;
+        size_t memory_used_bytes;   // 节点输出的字节数
+        size_t live_bytes = 0;      // 节点执行后（释放之前）存活的字节数
+        // 解析估计（CostModel::EstimateCost，按执行时的实际形状），用于屋顶线分析
+        double estimated_flops = 0.0;
+        size_t estimated_bytes = 0;
+        // 节点执行期间所有线程的硬件计数（hardware_counters为true时有效）
+        HardwareCounterValues counters;
     };
     
     std::vector<NodeProfile> node_profiles;
     double total_time_ms;
-    size_t peak_memory_bytes;
+    size_t peak_memory_bytes;   // 同memory_timeline.peak_bytes
+    MemoryTimeline memory_timeline;
+    // 是否采集到了硬件计数器；请求了但不可用时hardware_counter_error说明原因
+    bool hardware_counters = false;
+    std::string hardware_counter_error;
+};
+
+// 线程池配置
+struct ThreadPoolOptions {
+    size_t num_threads = 0;       // 0表示使用硬件并发数
+    bool pin_threads = false;     // 将第i个工作线程绑定到第i个CPU（仅Linux）
+    int spin_iterations = 1024;   // 空闲线程休眠前的自旋次数
+    // NUMA感知（见numa.h）：每个节点一组工作线程，绑定在节点的CPU上（pin_threads时再固定到单个CPU），
+    // num_threads按各节点的CPU数分到各组；任务只在组内窃取，绑定到节点的线程提交的任务只由本组执行，
+    // 未绑定的线程提交的任务分散到各组。只有一个节点或线程数少于节点数时与关闭相同
+    bool numa_aware = false;
+    // 混合架构（Intel P/E核、ARM big.LITTLE，见numa.h的GetCpuCoreTopology）：为true时工作线程只在性能核上
+    // 运行（pin_threads时各固定到一个性能核），num_threads为0时取性能核数，适合延迟敏感的会话；
+    // 否则并行循环按各线程所在核的算力多切块（见GetBalancedChunkCount）。非混合架构上没有影响
+    bool performance_cores_only = false;
+    // 只执行HIGH优先级任务的工作线程数（见RunPriority）：为交互式请求保留的核不会被批处理任务占满。
+    // 每组至少保留一个普通线程；0表示不保留
+    size_t reserved_high_priority_threads = 0;
+};
+
+// 运行与线程池任务的优先级（参考Linux的SCHED_IDLE与Triton的请求优先级）：线程池的注入队列按优先级分开，
+// 工作线程先取HIGH，再取自己的队列与NORMAL，最后才取LOW；LOW的运行还在节点之间让给进行中的HIGH运行
+enum class RunPriority {
+    DEFAULT = -1,  // 沿用外层（最外层为NORMAL）
+    HIGH = 0,      // 交互式、延迟敏感的请求
+    NORMAL = 1,
+    LOW = 2        // 批处理：只用空闲的线程，并在节点边界被HIGH运行抢占
+};
+
+class ThreadPoolImpl;
+class ThreadPoolScope;
+
+// 一个工作线程的累计统计（见ThreadPool::GetStats）；计时只在指标开启时进行（见MetricsRegistry::SetEnabled）
+struct ThreadPoolWorkerStats {
+    uint64_t tasks = 0;
+    uint64_t local_tasks = 0;       // 取自自己的队列
+    uint64_t injected_tasks = 0;    // 取自注入队列（外部线程提交的任务与HIGH/LOW任务）
+    uint64_t stolen_tasks = 0;      // 从组内其他线程的队列窃取
+    int64_t busy_ns = 0;            // 执行任务
+    int64_t queue_wait_ns = 0;      // 所执行的任务从提交到开始执行的等待之和
+    int64_t spin_ns = 0;            // 找不到任务后自旋（包括突发模式的自旋）
+    int64_t sleep_ns = 0;           // 在条件变量上休眠
+};
+
+// 线程池的调度统计：工作线程的分布说明是否空闲、是否依赖窃取；并行区域的不均衡度说明ParallelFor的
+// 各执行者是否同时完成
+struct ThreadPoolStats {
+    std::vector<ThreadPoolWorkerStats> workers;
+    // 提交了辅助任务的ParallelFor区域数；不均衡度 = 最忙的执行者耗时 / 各执行者（调用线程与辅助任务）的
+    // 平均耗时，1表示完全均衡，没有领到块的辅助任务按0计入
+    uint64_t parallel_regions = 0;
+    double mean_imbalance = 0.0;
+    double max_imbalance = 0.0;
+    
+    // 每个工作线程一行的表格与并行区域的汇总
+    std::string ToString() const;
 };
 
-// 线程池
+// 线程池（工作窃取：每个工作线程一个Chase-Lev队列，空闲时随机窃取）
+// 静态接口作用于调用线程当前的线程池（见ThreadPoolScope）：ParallelFor与线程数查询使用intra-op池，
+// EnqueueTask/WaitAll使用inter-op池；没有作用域时两者都是进程全局线程池
 class ThreadPool {
 public:
+    // 重新配置全局线程池；旧线程池等待已提交任务完成后销毁
+    static void Configure(const ThreadPoolOptions& options);
+    
     static void EnqueueTask(std::function<void()> task);
     static void WaitAll();
     static size_t GetThreadCount();
+    // EnqueueTask所用的inter-op池的线程数
+    static size_t GetInterOpThreadCount();
+    // 调用线程发起的ParallelFor可用的工作线程数：NUMA分组时为所在组的线程数，否则同GetThreadCount
+    static size_t GetAvailableThreadCount();
+    static size_t GetNumaGroupCount();
+    // threads个线程执行的并行循环应切成的块数：同构核上等于threads；混合架构上以最慢的核为单位按各线程
+    // 所在核的算力放大，块由线程动态领取，快核多领，整个循环不必等最慢的能效核做完均分的一份
+    static size_t GetBalancedChunkCount(size_t threads);
+    static bool IsWorkerThread();
     static size_t GetPendingTaskCount();
+    // intra-op池自创建或上次ResetStats以来的调度统计。同样导出为指标（inferunity_thread_pool_*，
+    // 所有线程池合计）；追踪开启时另记录task_queue_wait_us与parallel_for_imbalance_pct计数器事件
+    static ThreadPoolStats GetStats();
+    static void ResetStats();
+    
+    // 将[begin, end)按grain切块并行执行fn(chunk_begin, chunk_end)，返回时所有块均已完成
+    // 调用线程也参与取块，因此可在线程池任务内部嵌套调用而不会死锁
+    // fn以引用传递，不会为每个块构造std::function
+    template <typename F>
+    static void ParallelFor(int64_t begin, int64_t end, int64_t grain, F&& fn) {
+        using Fn = typename std::remove_reference<F>::type;
+        ParallelForRange(begin, end, grain,
+                         [](void* context, int64_t chunk_begin, int64_t chunk_end) {
+                             (*static_cast<Fn*>(context))(chunk_begin, chunk_end);
+                         },
+                         const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+    }
+    
+    using RangeFunction = void (*)(void* context, int64_t begin, int64_t end);
+    static void ParallelForRange(int64_t begin, int64_t end, int64_t grain,
+                                 RangeFunction fn, void* context);
+    
+    // 突发模式的底层接口，一般通过ThreadPoolBurst使用
+    static void BeginBurst(int64_t spin_us);
+    static void EndBurst();
+};
+
+// 推理突发模式（参考ONNX Runtime的allow_spinning与OpenMP的OMP_WAIT_POLICY=active）：作用域存在期间，
+// 空闲的工作线程在休眠前最多再自旋spin_us微秒（pause，间或yield），一次推理中算子之间的短暂空闲不再经过
+// 条件变量的休眠/唤醒；进入作用域时唤醒已休眠的线程，使其在第一个ParallelFor到来前已在自旋。
+// caller_runs_first时调用线程发起的ParallelFor把调用线程算作一个执行者：先领取第一块，只为其余的块
+// 提交至多threads - 1个辅助任务（只影响创建作用域的线程）。作用域可以嵌套、可在多个线程上同时存在，
+// 全部结束后恢复spin_iterations的行为；spin_us <= 0时不自旋也不预先唤醒，只应用caller_runs_first
+class ThreadPoolBurst {
+public:
+    ThreadPoolBurst(int64_t spin_us, bool caller_runs_first = false);
+    ~ThreadPoolBurst();
+    
+    ThreadPoolBurst(const ThreadPoolBurst&) = delete;
+    ThreadPoolBurst& operator=(const ThreadPoolBurst&) = delete;
+
+private:
+    bool active_ = false;
+    bool previous_caller_runs_first_ = false;
 };
 
+// 可单独创建的线程池（参考ONNX Runtime的intra-op/inter-op线程池）：由会话私有，或把同一个实例交给多个会话
+// 显式共享。Resize/Reconfigure随时可以调用：之后进入作用域的运行使用新的工作线程，进行中的运行在旧线程上
+// 完成后旧线程退出，多租户主机可以据此在模型之间确定地划分和调整核
+class ThreadPoolInstance {
+public:
+    explicit ThreadPoolInstance(const ThreadPoolOptions& options = ThreadPoolOptions());
+    ~ThreadPoolInstance();
+    
+    static std::shared_ptr<ThreadPoolInstance> Create(const ThreadPoolOptions& options = ThreadPoolOptions());
+    
+    void Reconfigure(const ThreadPoolOptions& options);
+    // 只改变线程数，其余配置不变；0表示硬件并发数
+    void Resize(size_t num_threads);
+    ThreadPoolOptions GetOptions() const;
+    size_t GetThreadCount() const;
+    
+    ThreadPoolInstance(const ThreadPoolInstance&) = delete;
+    ThreadPoolInstance& operator=(const ThreadPoolInstance&) = delete;
+
+private:
+    friend class ThreadPoolScope;
+    
+    std::shared_ptr<ThreadPoolImpl> Acquire() const;
+    
+    mutable std::mutex mutex_;
+    ThreadPoolOptions options_;
+    std::shared_ptr<ThreadPoolImpl> impl_;
+};
+
+// 作用域内调用线程的ThreadPool静态接口改用给定的池：intra_op用于ParallelFor与线程数查询，inter_op用于
+// EnqueueTask/WaitAll；nullptr表示沿用外层作用域（最外层为全局线程池）。作用域内提交的任务在工作线程上
+// 执行时继承同样的设置；作用域可以嵌套，析构时恢复外层设置
+class ThreadPoolScope {
+public:
+    ThreadPoolScope(const std::shared_ptr<ThreadPoolInstance>& intra_op,
+                    const std::shared_ptr<ThreadPoolInstance>& inter_op);
+    ~ThreadPoolScope();
+    
+    ThreadPoolScope(const ThreadPoolScope&) = delete;
+    ThreadPoolScope& operator=(const ThreadPoolScope&) = delete;
+
+private:
+    friend class ThreadPool;
+    
+    ThreadPoolScope(std::shared_ptr<ThreadPoolImpl> intra_op, std::shared_ptr<ThreadPoolImpl> inter_op);
+    
+    std::shared_ptr<ThreadPoolImpl> intra_op_;
+    std::shared_ptr<ThreadPoolImpl> inter_op_;
+    ThreadPoolScope* previous_ = nullptr;
+};
+
+// 作用域内调用线程的取消令牌（参考Go的context.Context）：InferenceSession的运行把它交给执行计划，
+// 调用线程发起的ParallelFor在执行每一块前检查，已触发时跳过该块（调用方随后在节点边界返回错误）。
+// 作用域可以嵌套，析构时恢复外层令牌；nullptr表示沿用外层
+class CancellationScope {
+public:
+    explicit CancellationScope(std::shared_ptr<CancellationToken> token);
+    ~CancellationScope();
+    
+    // 调用线程当前的令牌，没有作用域时为nullptr
+    static const std::shared_ptr<CancellationToken>& Current();
+    
+    CancellationScope(const CancellationScope&) = delete;
+    CancellationScope& operator=(const CancellationScope&) = delete;
+
+private:
+    std::shared_ptr<CancellationToken> previous_;
+};
+
+// 作用域内调用线程的优先级：调用线程提交的任务（含ParallelFor的辅助任务）进入对应优先级的队列，
+// 在工作线程上执行时继承该优先级。作用域可以嵌套，析构时恢复外层优先级；DEFAULT表示沿用外层，
+// fallback为true时只在外层没有给出优先级时生效（会话的默认优先级不覆盖单次运行的优先级）
+class PriorityScope {
+public:
+    explicit PriorityScope(RunPriority priority, bool fallback = false);
+    ~PriorityScope();
+    
+    // 调用线程当前的优先级，没有作用域时为NORMAL
+    static RunPriority Current();
+    // 进程内进行中的HIGH作用域数（工作线程执行HIGH任务不计入）
+    static int ActiveHighPriorityRuns();
+    // 节点边界的抢占点：调用线程的优先级为LOW且有HIGH作用域进行中时等待它们结束，令牌触发时立即返回；
+    // 每次最多等待200ms，持续的HIGH负载下LOW运行仍能前进
+    static void YieldToHigherPriority(const CancellationToken* cancellation);
+    
+    PriorityScope(const PriorityScope&) = delete;
+    PriorityScope& operator=(const PriorityScope&) = delete;
+
+private:
+    RunPriority previous_;
+    bool counted_ = false;
+};
+
+// fork安全（参考PyTorch/OpenBLAS的pthread_atfork处理）：注册fork前后的处理函数，此后进程fork时
+// 先让所有线程池（全局线程池与ThreadPoolInstance）的工作线程执行完已提交的任务后退出，停止内存池的
+// 后台回收线程与日志的后台线程，并持有它们的锁；fork后在父子进程中释放，并按原配置重新启动工作线程，
+// 子进程中的会话可以直接运行。只需调用一次，之后Python的os.fork、multiprocessing的fork启动方式同样生效。
+// 不默认注册：注册后每次fork（包括fork + exec启动子进程）都要等待线程池空闲。
+// 不能在线程池的工作线程中fork；会话自己创建的其他线程（DynamicBatcher、权重预取等）不随fork重建，
+// 应在子进程中创建。其他平台上为空操作
+void InstallForkHandlers();
+
+// 预fork服务（参考gunicorn的preload_app与Nginx的master/worker）：父进程加载模型并调用InferenceSession::Warmup
+// （预打包权重、形状特化计划与arena都在此时生成）后，fork出num_workers个子进程，子进程以写时复制继承已加载的
+// 会话，只有各自写入的页（输入输出与中间张量）才会复制，常驻内存中的权重由所有子进程共享。
+// 子进程i执行worker_main(i)，写出日志后以其返回值退出（抛出异常时为1），不会返回到调用方；父进程得到各子进程的pid，
+// 由调用方负责waitpid。调用前会自动InstallForkHandlers。子进程继承父进程的线程池线程数，
+// 多个子进程同时推理时宜在worker_main开头用ThreadPool::Configure缩小。不支持fork的平台返回ERROR_NOT_IMPLEMENTED
+Status ForkWorkers(size_t num_workers, const std::function<int(size_t worker_index)>& worker_main,
+                   std::vector<int>* worker_pids);
+
+// 推断节点输出形状并绑定输出张量；形状、类型和设备一致的已绑定张量直接复用
+Status BindNodeOutputs(Node* node, ExecutionProvider* provider);
+// 同上，输入输出张量由调用方给出（ExecutionState的槽位），不经过Value
+Status BindOutputTensors(Node* node, ExecutionProvider* provider,
+                         const std::vector<Tensor*>& inputs,
+                         std::vector<std::shared_ptr<Tensor>>& outputs);
+
+// ExecutionState上的分段执行：BeginStateRun绑定输入，ExecuteStateSteps执行计划中[begin, end)的步骤，
+// EndStateRun取出输出并解除调用方缓冲。ExecutionEngine::ExecutePlan(state)与流水线的各阶段都由它们组成
+Status BeginStateRun(const ExecutionPlan& plan, ExecutionState* state,
+                     const std::vector<Tensor*>& inputs);
+Status ExecuteStateSteps(const ExecutionPlan& plan, ExecutionState* state,
+                         size_t begin, size_t end, const ExecutionOptions& options);
+void EndStateRun(const ExecutionPlan& plan, ExecutionState* state, bool succeeded,
+                 std::vector<Tensor*>& outputs);
+
 // 执行引擎
 class ExecutionEngine {
 public:
@@ -130,7 +468,29 @@ public:
     // 性能分析
     Status Profile(const Graph* graph,
                    const std::vector<Tensor*>& inputs,
-                   ProfilingResult& result);
+                   ProfilingResult& result,
+                   const ExecutionOptions& options = ExecutionOptions());
+    
+    // 按预编译的执行计划执行（不再做拓扑排序和提供者选择）
+    Status ExecutePlan(const ExecutionPlan& plan,
+                       const std::vector<Tensor*>& inputs,
+                       std::vector<Tensor*>& outputs,
+                       const ExecutionOptions& options = ExecutionOptions());
+    std::future<Status> ExecutePlanAsync(const ExecutionPlan& plan,
+                                         const std::vector<Tensor*>& inputs,
+                                         std::vector<Tensor*>& outputs,
+                                         const ExecutionOptions& options = ExecutionOptions());
+    // 在独立的ExecutionState上执行：中间结果只写入state，多个线程可各用一个state同时执行同一计划；
+    // 要求计划中所有提供者SupportsConcurrentExecution()。outputs在该state下一次执行前有效
+    Status ExecutePlan(const ExecutionPlan& plan,
+                       ExecutionState* state,
+                       const std::vector<Tensor*>& inputs,
+                       std::vector<Tensor*>& outputs,
+                       const ExecutionOptions& options = ExecutionOptions());
+    Status ProfilePlan(const ExecutionPlan& plan,
+                       const std::vector<Tensor*>& inputs,
+                       ProfilingResult& result,
+                       const ExecutionOptions& options = ExecutionOptions());
     
     // 执行图（使用ExecutionContext）
     Status ExecuteGraph(Graph* graph, ExecutionContext* ctx);
@@ -139,18 +499,76 @@ public:
     Status ExecuteGraphAsync(Graph* graph, ExecutionContext* ctx,
                              std::function<void(Status)> callback);
     
-    // 并行执行多个图
+    // 并行执行多个相互独立的图；模型之间有数据依赖时使用ModelEnsemble（见model_ensemble.h）
     Status ExecuteGraphsParallel(const std::vector<Graph*>& graphs,
                                 const std::vector<ExecutionContext*>& contexts);
-    
+
 private:
     std::vector<std::shared_ptr<ExecutionProvider>> backends_;
     std::vector<ExecutionProvider*> backend_ptrs_;
     std::unique_ptr<Scheduler> scheduler_;
-    Status ExecuteInternal(const Graph* graph,
-                          const std::vector<Tensor*>& inputs,
-                          std::vector<Tensor*>& outputs,
-                          const ExecutionOptions& options);
+    
+    // 按调度器给出的顺序临时构建计划（不释放中间张量，保持跨运行复用）
+    Status BuildTransientPlan(const Graph* graph, std::unique_ptr<ExecutionPlan>* plan) const;
+    Status RunPlan(const ExecutionPlan& plan,
+                   const std::vector<Tensor*>& inputs,
+                   std::vector<Tensor*>& outputs,
+                   const ExecutionOptions& options,
+                   ProfilingResult* profile);
+};
+
+// 流水线执行配置
+struct PipelineOptions {
+    size_t num_stages = 2;
+    size_t queue_capacity = 2;              // 相邻阶段之间最多排队的micro-batch数
+    int intra_op_threads_per_stage = 1;     // 每个阶段内算子可用的线程数，1表示由阶段线程独自执行
+    int64_t intra_op_min_work_per_thread = 16384;
+    std::vector<double> step_costs;         // 每个执行步骤的代价（如实测耗时），为空时按EstimateNodeCost估计
+};
+
+// 跨micro-batch的流水线执行器 (参考GPipe与TensorRT的多stream流水线)：
+// 执行计划按代价切成连续的阶段，每个阶段由一个专用线程执行，micro-batch经有界的单生产者单消费者队列
+// 在相邻阶段之间传递，阶段N处理第i个micro-batch时阶段N-1已在处理第i+1个。
+// 每个在途的micro-batch使用自己的ExecutionState，要求计划中的提供者都SupportsConcurrentExecution()
+class PipelineExecutor {
+public:
+    static Status Create(const ExecutionPlan& plan, const MemoryPlan* memory_plan,
+                         const PipelineOptions& options, std::unique_ptr<PipelineExecutor>* executor);
+    ~PipelineExecutor();
+    
+    PipelineExecutor(const PipelineExecutor&) = delete;
+    PipelineExecutor& operator=(const PipelineExecutor&) = delete;
+    
+    // 依次执行各micro-batch（按图输入顺序）；第index个完成后在调用线程上调用collect取走输出，
+    // 之后其ExecutionState被下一个micro-batch复用。返回第一个失败的micro-batch的错误
+    using CollectFunction = std::function<Status(size_t index, ExecutionState* state)>;
+    Status Run(const std::vector<std::vector<Tensor*>>& micro_batches, const CollectFunction& collect);
+    
+    // 用一个micro-batch逐步骤计时，按实测耗时重新划分阶段
+    Status Calibrate(const std::vector<Tensor*>& inputs);
+    
+    size_t GetNumStages() const { return bounds_.size() - 1; }
+    // num_stages + 1个步骤边界
+    const std::vector<size_t>& GetStageBounds() const { return bounds_; }
+    double GetStageCost(size_t stage) const;
+
+private:
+    struct MicroBatch;
+    class Queue;
+    
+    PipelineExecutor(const ExecutionPlan& plan, const PipelineOptions& options);
+    void StageLoop(size_t stage);
+    void Repartition();
+    
+    const ExecutionPlan& plan_;
+    PipelineOptions options_;
+    ExecutionOptions stage_options_;
+    std::vector<double> costs_;
+    std::vector<size_t> bounds_;
+    std::vector<std::unique_ptr<ExecutionState>> states_;
+    std::vector<std::unique_ptr<Queue>> queues_;  // queues_[s]为阶段s的输入，最后一个交回调用线程
+    std::vector<std::thread> threads_;
+    std::mutex run_mutex_;
 };
 
 } // namespace inferunity
@@ -0,0 +1,27 @@
+#pragma once
+
+// 解码步的采样头 (参考HuggingFace transformers的LogitsProcessor与ONNX Runtime contrib的Sampling算子)：
+// 在最后的logits投影之后追加Sampling算子（重复惩罚、温度、top-k、top-p或贪心argmax），
+// 会话只输出每个batch的下一个token id，[B, vocab]的logits不再离开会话、也不必在调用方排序
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+
+namespace inferunity {
+
+class Graph;
+
+struct SamplingOptions {
+    float temperature = 1.0f;          // <= 0为贪心argmax
+    int64_t top_k = 0;                 // 只在最大的k个logit中采样，0表示不限制
+    float top_p = 1.0f;                // nucleus：保留累积概率达到top_p的最小候选集
+    float repetition_penalty = 1.0f;   // != 1时增加图输入past_tokens（INT64 [B, N]）
+    uint64_t seed = 0;
+};
+
+// 把图输出logits_name（为空时取第一个输出，[B, V]或[B, S, V]）换成Sampling节点的输出
+// next_tokens（INT64 [B, 1]，取每个batch最后一个位置）；logits只被采样头使用时不再是图输出
+Status AppendSamplingHead(Graph* graph, const SamplingOptions& options, const std::string& logits_name = "");
+
+} // namespace inferunity
@@ -0,0 +1,87 @@
+#pragma once
+
+// 内置的推理服务前端 (参考Triton Inference Server的HTTP/REST前端与KServe v2推理协议)
+// 每个I/O线程运行一个epoll事件循环，各自持有一个SO_REUSEPORT监听套接字，由内核在线程间分配连接；
+// 套接字非阻塞，事件循环从不等待推理。请求体直接收进按64字节对齐的缓冲，二进制扩展的输入张量是该缓冲的视图，
+// 不经过拷贝就交给动态批处理器（见DynamicBatcher）或会话的RunAsync（受准入控制约束）；
+// 推理完成后在工作线程上编码响应，经eventfd交回所属的事件循环，用writev直接发送输出张量的数据。
+// 同一端口提供GET /metrics（Prometheus文本格式，见MetricsRegistry）。只支持Linux
+
+#include "types.h"
+#include "batcher.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace inferunity {
+
+class InferenceSession;
+
+struct ServerOptions {
+    std::string host = "0.0.0.0";
+    int port = 8000;                          // 0表示由系统分配，启动后用GetPort取得
+    int num_io_threads = 1;                   // 事件循环线程数
+    int backlog = 1024;
+    size_t max_request_bytes = 64 << 20;      // 请求体上限，超过时返回413
+    size_t max_header_bytes = 16 << 10;       // 请求头上限，超过时返回431
+    int64_t default_timeout_us = 0;           // 请求未给出parameters.timeout时的时限，0表示不超时
+    bool expose_metrics = true;               // 提供GET /metrics
+};
+
+struct ServedModelOptions {
+    std::string version = "1";
+    // 经动态批处理器执行；否则每个请求直接调用会话的RunAsync
+    bool dynamic_batching = false;
+    DynamicBatcherOptions batching;
+};
+
+struct ServerStats {
+    uint64_t connections = 0;        // 累计接受的连接数
+    uint64_t requests = 0;           // 累计处理的HTTP请求数
+    uint64_t infer_requests = 0;     // 其中的推理请求数
+    uint64_t infer_failures = 0;     // 推理请求中返回错误的个数
+    uint64_t zero_copy_bytes = 0;    // 作为接收缓冲视图交给推理的输入字节数
+    uint64_t copied_bytes = 0;       // 解码时拷贝的输入字节数（JSON数据与未对齐的二进制输入）
+};
+
+class InferenceServer {
+public:
+    explicit InferenceServer(const ServerOptions& options = ServerOptions());
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // 在Start之前注册模型；会话须已初始化，且在服务器停止前保持有效
+    Status AddModel(const std::string& name, InferenceSession* session,
+                    const ServedModelOptions& options = ServedModelOptions());
+
+    // 绑定端口并启动事件循环线程
+    Status Start();
+    // 停止接受连接，取消在途的推理并等待其回调返回后关闭全部连接；析构时自动调用
+    void Stop();
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    // 实际监听的端口（port为0时由系统分配）
+    int GetPort() const { return bound_port_; }
+    // 累计统计（含此前启动过的事件循环）；不能与Start/Stop并发调用
+    ServerStats GetStats() const;
+
+private:
+    struct Model;
+    class EventLoop;
+
+    const Model* FindModel(const std::string& name) const;
+
+    ServerOptions options_;
+    std::vector<std::unique_ptr<Model>> models_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::atomic<bool> running_{false};
+    int bound_port_ = 0;
+    ServerStats stopped_stats_;  // 已停止的事件循环累计的统计
+};
+
+} // namespace inferunity
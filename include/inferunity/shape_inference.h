@@ -0,0 +1,37 @@
+#pragma once
+
+// 图级形状推断 (参考ONNX的符号形状推断与ONNX Runtime的SymbolicShapeInference)：
+// 按拓扑序调用各算子的InferOutputShape，为中间Value设置只有形状的张量；
+// 图输入的动态维度作为符号传播，输出维度能写成符号与整数的乘积时记录表达式（如"batch*seq"），
+// 运行时按输入的具体形状绑定符号即可求出各中间张量的形状
+
+#include "types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+class Graph;
+class Tensor;
+
+// 符号 -> 具体取值
+using ShapeSymbolBindings = std::unordered_map<std::string, int64_t>;
+
+// 推断所有中间Value的形状与数据类型；无法推断的节点输出记为未知并继续，返回遇到的第一个错误
+Status InferShapes(Graph* graph);
+
+// 图输入是否含动态维度
+bool HasSymbolicInputs(const Graph& graph);
+
+// 求符号表达式的值；表达式为空或含未绑定的符号时返回-1
+int64_t EvaluateSymbolicDim(const std::string& expr, const ShapeSymbolBindings& bindings);
+
+// 把形状中的动态维度按表达式求值；存在无法求值的维度时返回false
+bool ResolveSymbolicShape(const Shape& shape, const ShapeSymbolBindings& bindings, Shape* resolved);
+
+// 按实际输入的形状绑定图输入上的符号；秩不符或同一符号取到不同的值时返回错误
+Status BindShapeSymbols(const Graph& graph, const std::vector<Tensor*>& inputs,
+                        ShapeSymbolBindings* bindings);
+
+} // namespace inferunity
@@ -0,0 +1,79 @@
+#pragma once
+
+// 投机解码 (参考Leviathan et al. "Fast Inference from Transformers via Speculative Decoding"
+// 与Chen et al. "Accelerating Large Language Model Decoding with Speculative Sampling")：
+// 小的draft模型逐个提出k个token，目标模型用一次前向（k + 1个位置的因果注意力）给出每个位置的分布，
+// 按接受-拒绝采样逐个接受：接受的输出服从目标模型的分布，被拒绝位置之后的KV cache回退。
+// 两个会话都需启用KV cache（SessionOptions::enable_kv_cache），使用各自cache的序列0；
+// 模型输入为token id（INT64 [1, S]），可选position_ids [1, S]与attention_mask [1, past + S]，
+// 输出logits为[1, S, vocab]或[S, vocab]
+
+#include "types.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+class InferenceSession;
+
+struct SpeculativeDecodingOptions {
+    int64_t num_draft_tokens = 4;   // 每轮draft提出的token数k
+    float temperature = 0.0f;       // <= 0为贪心：输出与目标模型单独贪心解码完全相同
+    int64_t max_new_tokens = 32;
+    int64_t eos_token = -1;         // 生成该token后结束，< 0表示不检查
+    uint64_t seed = 0;
+    std::string input_ids_name;     // 为空时取第一个图输入
+    std::string logits_name;        // 为空时取第一个图输出
+};
+
+struct SpeculativeDecodingStats {
+    uint64_t num_rounds = 0;        // 目标模型的前向次数
+    uint64_t num_draft_runs = 0;
+    uint64_t num_proposed = 0;      // draft提出的token数
+    uint64_t num_accepted = 0;      // 被目标模型接受的draft token数
+    uint64_t num_generated = 0;
+    
+    double GetAcceptanceRate() const {
+        return num_proposed ? static_cast<double>(num_accepted) / static_cast<double>(num_proposed) : 0.0;
+    }
+    // 每次目标模型前向平均产生的token数（不投机时为1）
+    double GetTokensPerRound() const {
+        return num_rounds ? static_cast<double>(num_generated) / static_cast<double>(num_rounds) : 0.0;
+    }
+};
+
+class SpeculativeDecoder {
+public:
+    SpeculativeDecoder(InferenceSession* target, InferenceSession* draft,
+                       const SpeculativeDecodingOptions& options = SpeculativeDecodingOptions());
+    
+    // 从prompt生成至多max_new_tokens个token（不含prompt）；开始时清空两个会话的序列0
+    Status Generate(const std::vector<int64_t>& prompt, std::vector<int64_t>* generated);
+    
+    const SpeculativeDecodingStats& GetStats() const { return stats_; }
+    const SpeculativeDecodingOptions& GetOptions() const { return options_; }
+
+private:
+    // 把tokens送入session（KV cache中已有past个位置），logits为每个位置一行
+    Status Forward(InferenceSession* session, const std::vector<int64_t>& tokens, int64_t past,
+                   std::vector<std::vector<float>>* logits);
+    // logits -> 采样分布：贪心时为argmax处的one-hot，否则为softmax(logits / temperature)
+    std::vector<float> Distribution(const std::vector<float>& logits) const;
+    int64_t Sample(const std::vector<float>& probs);
+    
+    InferenceSession* target_;
+    InferenceSession* draft_;
+    SpeculativeDecodingOptions options_;
+    SpeculativeDecodingStats stats_;
+    std::mt19937_64 rng_;
+};
+
+// 一个位置上的接受-拒绝：以min(1, p(x) / q(x))接受draft的token x（uniform为[0, 1)的随机数），
+// 拒绝时从归一化的max(0, p - q)中按resample_uniform采样，写入*token。
+// 对x ~ q，*token的分布恰为p；返回是否接受
+bool SpeculativeAcceptToken(const std::vector<float>& target_probs, const std::vector<float>& draft_probs,
+                            int64_t draft_token, float uniform, float resample_uniform, int64_t* token);
+
+} // namespace inferunity
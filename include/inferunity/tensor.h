@@ -3,12 +3,14 @@
 #include "types.h"
 #include <memory>
 #include <cstring>
+#include <vector>
 
 namespace inferunity {
 
 // 前向声明
 class MemoryAllocator;
 class Device;
+class TransferEvent;
 
 // 张量类 - 核心数据结构
 class Tensor {
@@ -42,6 +44,12 @@ public:
     bool IsOwned() const { return owns_data_; }
     void SetData(void* data, bool owns = false);
     
+    // 步长（以元素计，参考PyTorch的strided张量）：为空表示行主序连续；
+    // 非连续张量的data_指向首个元素，只有支持步长的代码可以直接读取
+    std::vector<int64_t> GetStrides() const;
+    bool IsContiguous() const;
+    void SetStrides(const std::vector<int64_t>& strides);
+    
     // 形状操作（视图，不拷贝数据）
     Tensor Reshape(const Shape& new_shape);
     Tensor Slice(const std::vector<int64_t>& starts, const std::vector<int64_t>& ends);
@@ -49,15 +57,19 @@ public:
     // 设备间传输
     Status CopyTo(Tensor& dst) const;
     Status CopyFrom(const Tensor& src);
+    // 非阻塞版本：主机与设备之间的拷贝在设备的拷贝流上异步进行，event完成前不能读取或释放目标张量；
+    // stream非空时拷贝排在该流上已入队的工作之后（见DataTransfer）
+    Status CopyToAsync(Tensor& dst, std::shared_ptr<TransferEvent>* event, void* stream = nullptr) const;
+    Status CopyFromAsync(const Tensor& src, std::shared_ptr<TransferEvent>* event, void* stream = nullptr);
     
     // 数据填充
     Status FillZero();
     Status FillValue(float value);
     
-    // 序列化
+    // 序列化（格式见tensor_wire.h，拷贝数据；零拷贝收发用EncodeTensorWire/DecodeTensorWire）
     Status Serialize(std::vector<uint8_t>& buffer) const;
     Status Deserialize(const std::vector<uint8_t>& buffer);
-    
+
 private:
     Shape shape_;
     DataType dtype_;
@@ -65,18 +77,45 @@ private:
     MemoryLayout layout_;
     void* data_;
     bool owns_data_;
-    std::shared_ptr<MemoryAllocator> allocator_;
+    std::vector<int64_t> strides_;
+    // 分配data_的分配器；默认分配器常驻进程，只有替换过的或调用方指定的分配器由allocator_owner_持有
+    MemoryAllocator* allocator_ = nullptr;
+    std::shared_ptr<MemoryAllocator> allocator_owner_;
     
     void AllocateMemory();
     void FreeMemory();
+    
+    friend std::shared_ptr<Tensor> CreateTensorWithAllocator(const Shape& shape, DataType dtype,
+                                                             std::shared_ptr<MemoryAllocator> allocator,
+                                                             DeviceType device);
 };
 
-// 张量工厂函数
+// 张量工厂函数：Tensor对象与shared_ptr控制块合为一次分配，取自内存池的线程本地缓存
+// （小对象分级复用，不经过malloc），数据按设备的分配器分配（见ResolveMemoryAllocator）
 std::shared_ptr<Tensor> CreateTensor(const Shape& shape, DataType dtype, 
                                       DeviceType device = DeviceType::CPU);
 std::shared_ptr<Tensor> CreateTensorFromData(const Shape& shape, DataType dtype,
                                              void* data, MemoryLayout layout = MemoryLayout::NCHW,
                                              DeviceType device = DeviceType::CPU);
+// 用指定的分配器（如ArenaAllocator、MemoryPool）分配数据，张量持有分配器直到释放；分配失败时返回nullptr
+std::shared_ptr<Tensor> CreateTensorWithAllocator(const Shape& shape, DataType dtype,
+                                                  std::shared_ptr<MemoryAllocator> allocator,
+                                                  DeviceType device = DeviceType::CPU);
+
+// 沿第0维的批组装(参考ONNX Runtime的IOBinding：预先绑定一块批缓冲，避免逐样本拷入拷出)
+// 把batch按rows[i]行拆成视图，每个视图持有batch的引用，不拷贝数据
+std::vector<std::shared_ptr<Tensor>> SplitBatch(const std::shared_ptr<Tensor>& batch,
+                                                const std::vector<int64_t>& rows);
+// 沿第0维合并样本：相邻样本在内存中首尾相接（如SplitBatch得到的槽位）时返回不拷贝的视图，
+// 此时样本须在返回值使用期间保持有效；否则分配新张量逐个拷入。样本类型或其余维度不一致时返回nullptr
+std::shared_ptr<Tensor> ConcatBatch(const std::vector<const Tensor*>& samples);
+
+// 共享base存储的步长视图（Transpose/Slice/Reshape等只改布局的算子用它代替拷贝）：
+// offset与strides以元素计（strides为空表示连续），视图持有base的引用；base没有数据或视图越界时返回nullptr
+std::shared_ptr<Tensor> CreateStridedView(const std::shared_ptr<Tensor>& base, const Shape& shape,
+                                          const std::vector<int64_t>& strides, int64_t offset = 0);
+// 连续张量原样返回；非连续的CPU张量按行主序拷成新的连续张量，其余设备返回nullptr
+std::shared_ptr<Tensor> MakeContiguous(const std::shared_ptr<Tensor>& tensor);
 
 } // namespace inferunity
 
@@ -0,0 +1,54 @@
+#pragma once
+
+// 轻量的张量视图（参考DLPack的DLTensor与XNNPACK的内核参数）：数据指针、类型与内联的维度/步长数组，
+// 是POD，放在栈上按值传递。执行器把Tensor*翻译成视图后调用算子的ExecuteViews
+// （见Operator::SupportsViewExecution），一次调用不分配内存，内核读维度也不再经过Shape里的std::vector
+
+#include "tensor.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace inferunity {
+
+constexpr int kTensorViewMaxDims = 8;
+
+struct TensorView {
+    void* data;
+    DataType dtype;
+    DeviceType device;
+    MemoryLayout layout;
+    bool contiguous;                       // 行主序连续
+    int32_t ndims;
+    int64_t dims[kTensorViewMaxDims];
+    int64_t strides[kTensorViewMaxDims];   // 以元素计，连续时为后面各维的乘积
+    
+    int64_t GetElementCount() const {
+        int64_t count = 1;
+        for (int32_t i = 0; i < ndims; ++i) {
+            count *= dims[i];
+        }
+        return count;
+    }
+    
+    template<typename T>
+    T* Data() const { return static_cast<T*>(data); }
+};
+static_assert(std::is_trivially_copyable<TensorView>::value, "TensorView must stay POD");
+
+// 翻译Tensor的元数据（不拷贝数据）；维数超过kTensorViewMaxDims时返回false
+bool MakeTensorView(const Tensor& tensor, TensorView* view);
+
+// 视图数组的只读引用（C++17没有std::span）
+struct TensorViewSpan {
+    const TensorView* data = nullptr;
+    size_t size = 0;
+    
+    const TensorView& operator[](size_t index) const { return data[index]; }
+    bool empty() const { return size == 0; }
+    const TensorView* begin() const { return data; }
+    const TensorView* end() const { return data + size; }
+};
+
+} // namespace inferunity
@@ -0,0 +1,79 @@
+#pragma once
+
+// 张量的零拷贝传输格式（参考Arrow IPC的"元数据+body"与gRPC/brpc用iovec发送的做法）
+// 一条消息是固定128字节的头加上紧随其后的载荷：
+//   [TensorWireHeader(128B)] [payload(payload_size B)]
+// 头长是64的倍数，接收缓冲64字节对齐时载荷也64字节对齐，可直接作为张量数据使用。
+// 发送侧得到(头, 张量数据指针)两段，交给writev/sendmsg，载荷不经过中间缓冲；
+// 接收侧把收到的缓冲包装成不持有数据的张量，不拷贝。字段按主机字节序（小端）存放
+
+#include "tensor.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#define INFERUNITY_HAS_IOVEC 1
+#endif
+
+namespace inferunity {
+
+constexpr uint32_t kTensorWireMagic = 0x54554E49;  // "INUT"
+constexpr uint16_t kTensorWireVersion = 1;
+constexpr size_t kTensorWireMaxDims = 8;
+
+struct TensorWireHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;   // sizeof(TensorWireHeader)，载荷从此偏移开始
+    int32_t dtype;          // DataType
+    uint8_t layout;         // MemoryLayout
+    uint8_t reserved0[3];
+    uint32_t ndims;
+    uint32_t reserved1;
+    int64_t dims[kTensorWireMaxDims];
+    uint64_t payload_size;  // 字节数，等于元素数乘以元素大小
+    uint8_t reserved[32];
+};
+static_assert(sizeof(TensorWireHeader) == 128, "TensorWireHeader must stay 128 bytes");
+
+// 只填写头，不访问数据（Tensor::Serialize与EncodeTensorWire共用）；维数超过kTensorWireMaxDims时返回错误
+Status BuildTensorWireHeader(const Tensor& tensor, TensorWireHeader* header);
+// 校验头（魔数、版本、维数、载荷大小与形状是否一致），合法时可用消息前header_size+payload_size字节
+Status ValidateTensorWireHeader(const TensorWireHeader& header);
+
+// 一条待发送的消息：头加上直接指向张量数据的载荷（FillIovec得到的第二段，空张量时只有一段）。
+// 数据不拷贝，发送完成前张量须保持有效且不被修改
+struct TensorWireMessage {
+    TensorWireHeader header;
+    const void* payload = nullptr;
+    size_t payload_size = 0;
+    
+    size_t GetTotalSize() const { return sizeof(TensorWireHeader) + payload_size; }
+#ifdef INFERUNITY_HAS_IOVEC
+    // 按本对象当前地址填写iov（至少2个元素），返回段数；消息被拷贝或移动后须重新调用
+    int FillIovec(struct iovec* iov) const;
+#endif
+};
+
+// 张量须在CPU上且连续（非连续的先用MakeContiguous）
+Status EncodeTensorWire(const Tensor& tensor, TensorWireMessage* message);
+
+// 把buffer开头的一条消息包装成张量：数据指向buffer内的载荷，不拷贝，buffer须在张量使用期间有效。
+// 载荷地址未按元素大小对齐时返回错误；consumed（可选）返回这条消息占用的字节数，便于解析连续的多条消息
+Status DecodeTensorWire(const void* buffer, size_t size, std::shared_ptr<Tensor>* tensor,
+                        size_t* consumed = nullptr);
+// 同上，返回的张量持有owner的引用（如接收缓冲的shared_ptr），张量存活期间buffer不会释放
+Status DecodeTensorWire(const void* buffer, size_t size, std::shared_ptr<const void> owner,
+                        std::shared_ptr<Tensor>* tensor, size_t* consumed = nullptr);
+
+#ifdef INFERUNITY_HAS_IOVEC
+// 用writev把整条消息写到fd（处理部分写入与EINTR）
+Status WriteTensorWire(int fd, const Tensor& tensor);
+// 从fd读一条消息：先读头，再把载荷直接读进新分配的张量，不经过中间缓冲
+Status ReadTensorWire(int fd, std::shared_ptr<Tensor>* tensor);
+#endif
+
+} // namespace inferunity
@@ -0,0 +1,108 @@
+#pragma once
+
+// 分层追踪 (参考ONNX Runtime的Profiler与Chrome Trace Event格式)
+// 事件记录在各线程自己的环形缓冲中（单写者、不加锁），缓冲写满后覆盖最旧的事件；
+// 未启用时TraceScope只有一次原子读。导出的JSON可以直接用chrome://tracing或Perfetto UI打开：
+// 每个线程一条轨道（线程池工作线程带名称），多流执行时节点事件放在所属流的轨道上；
+// 会话加载、各优化Pass与内存规划按时间嵌套在加载事件之下，线程池任务显示算子内并行的空隙
+
+#include "types.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+enum class TraceCategory : uint8_t {
+    SESSION,      // 会话级：加载模型、Run
+    OPTIMIZER,    // 图优化Pass
+    MEMORY,       // 内存规划与arena
+    NODE,         // 节点执行
+    THREAD_POOL   // 线程池任务
+};
+
+const char* TraceCategoryName(TraceCategory category);
+
+struct TraceEvent {
+    static constexpr size_t kMaxNameLength = 63;
+    static constexpr size_t kMaxDetailLength = 31;
+    
+    TraceCategory category = TraceCategory::SESSION;
+    bool counter = false;      // 计数器事件（如arena字节数），value为计数值
+    int stream = -1;           // 执行流，-1表示不属于某条流
+    uint32_t thread_id = 0;    // 追踪器给线程分配的序号
+    int64_t start_ns = 0;      // 相对Tracer::Start的时刻
+    int64_t duration_ns = 0;
+    int64_t value = 0;
+    char name[kMaxNameLength + 1] = {};
+    char detail[kMaxDetailLength + 1] = {};  // 节点的算子类型等，超长时截断
+};
+
+class Tracer {
+public:
+    static Tracer& Instance();
+    
+    // 开始记录（已在记录时清空重来）：每个线程最多保留events_per_thread个最新的事件
+    void Start(size_t events_per_thread = 65536);
+    void Stop();
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    
+    // 相对Start的当前时刻（纳秒）
+    int64_t Now() const;
+    
+    // 当前线程在轨道上显示的名称（如"ThreadPool worker 3"），未设置时为"thread <序号>"
+    static void SetCurrentThreadName(const std::string& name);
+    
+    // 记录[start_ns, end_ns)的完整事件与计数器事件；未启用时直接返回
+    void RecordComplete(TraceCategory category, const char* name, const char* detail,
+                        int stream, int64_t start_ns, int64_t end_ns);
+    void RecordCounter(TraceCategory category, const char* name, int64_t value);
+    
+    // 以下在Stop之后调用：各线程缓冲中的事件按开始时刻排序，以及被覆盖丢弃的事件数
+    std::vector<TraceEvent> Collect() const;
+    uint64_t GetDroppedEventCount() const;
+    // Chrome Trace Event格式（JSON对象格式，traceEvents + 线程名称元数据）
+    std::string ExportChromeTrace() const;
+    Status WriteChromeTrace(const std::string& path) const;
+
+private:
+    struct ThreadBuffer;
+    
+    Tracer() = default;
+    ThreadBuffer* GetThreadBuffer();
+    
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> generation_{0};  // 每次Start递增，线程发现变化时换用新缓冲
+    std::atomic<int64_t> epoch_ns_{0};     // Start时的steady_clock时刻
+    size_t capacity_ = 65536;
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+// 作用域事件：构造时记下开始时刻，析构时记录完整事件；name与detail须在作用域内有效
+class TraceScope {
+public:
+    TraceScope(TraceCategory category, const char* name, const char* detail = nullptr, int stream = -1)
+        : category_(category), name_(name), detail_(detail), stream_(stream),
+          start_ns_(Tracer::Instance().IsEnabled() ? Tracer::Instance().Now() : -1) {}
+    ~TraceScope() {
+        if (start_ns_ >= 0) {
+            Tracer& tracer = Tracer::Instance();
+            tracer.RecordComplete(category_, name_, detail_, stream_, start_ns_, tracer.Now());
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceCategory category_;
+    const char* name_;
+    const char* detail_;
+    int stream_;
+    int64_t start_ns_;
+};
+
+} // namespace inferunity
@@ -71,6 +71,9 @@ enum class MemoryLayout : uint8_t {
 struct Shape {
     std::vector<int64_t> dims;
     std::vector<bool> is_dynamic;  // 对应维度是否为动态
+    // 动态维度的符号表达式：符号与整数的乘积，如"batch"、"batch*seq"、"2*seq"；
+    // 为空或空串表示未命名/未知。只是标注，不参与比较
+    std::vector<std::string> symbols;
     
     Shape() = default;
     explicit Shape(const std::vector<int64_t>& d) : dims(d), is_dynamic(d.size(), false) {}
@@ -122,6 +125,10 @@ enum class StatusCode : int32_t {
     ERROR_RUNTIME_ERROR = 5,
     ERROR_INVALID_MODEL = 6,
     ERROR_DEVICE_ERROR = 7,
+    ERROR_TIMEOUT = 8,
+    ERROR_RESOURCE_EXHAUSTED = 9,  // 队列或在途请求已满，稍后重试
+    ERROR_CANCELLED = 10,          // 运行被调用方取消（见CancellationToken）
+    ERROR_OVERLOADED = 11,         // 预测在截止时间前无法完成，请求被准入控制拒绝或放弃（见AdmissionController）
     ERROR_UNKNOWN = 255
 };
 
@@ -141,7 +148,7 @@ public:
     static Status Error(StatusCode code, const std::string& msg = "") {
         return Status(code, msg);
     }
-    
+
 private:
     StatusCode code_;
     std::string message_;
@@ -31,3 +31,17 @@ outputs = session.run(inputs)
 for i, output in enumerate(outputs):
     print(f"Output {i}: shape={output.shape}, dtype={output.dtype}")
 
+
+# 7. 零拷贝互操作：Tensor与NumPy数组共享内存
+tensor = iu.from_numpy(input_data)  # 不拷贝，tensor持有input_data的引用
+view = np.asarray(tensor)           # 缓冲协议，同样不拷贝
+assert view.ctypes.data == input_data.ctypes.data
+
+# 8. 异步推理：run_async返回asyncio.Future，推理期间不持有GIL
+import asyncio
+
+async def run_concurrently():
+    return await asyncio.gather(*(session.run_async([input_data]) for _ in range(4)))
+
+results = asyncio.run(run_concurrently())
+print(f"Async runs: {len(results)}")
@@ -10,62 +10,432 @@
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
 #include "inferunity/graph.h"
+#include "inferunity/runtime.h"
+
+#include <functional>
+#include <string>
 
 namespace py = pybind11;
 using namespace inferunity;
 
-// NumPy数组到Tensor的转换
-std::shared_ptr<Tensor> numpy_to_tensor(py::array_t<float> arr) {
-    auto buf = arr.request();
-    
-    // 获取形状
+namespace {
+
+// DLPack的ABI结构（与dlpack.h v0.8布局一致；只用到交换张量所需的部分，不引入额外头文件）
+enum DLDeviceTypeCode : int32_t {
+    kDLCPU = 1,
+    kDLCUDA = 2,
+};
+
+enum DLDataTypeCode : uint8_t {
+    kDLInt = 0,
+    kDLUInt = 1,
+    kDLFloat = 2,
+    kDLBfloat = 4,
+    kDLBool = 6,
+};
+
+struct DLDevice {
+    int32_t device_type;
+    int32_t device_id;
+};
+
+struct DLDataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+struct DLTensor {
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;  // 以元素计，为空表示行主序连续
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void (*deleter)(DLManagedTensor* self);
+};
+
+// DLPack约定的capsule名称：未消费为"dltensor"，消费方取走后改名为"used_dltensor"
+const char* const kDLTensorCapsuleName = "dltensor";
+const char* const kUsedDLTensorCapsuleName = "used_dltensor";
+
+// 缓冲协议的格式字符（BFLOAT16按位模式以uint16暴露）
+std::string BufferFormat(DataType dtype) {
+    switch (dtype) {
+        case DataType::FLOAT32: return "f";
+        case DataType::FLOAT16: return "e";
+        case DataType::BFLOAT16: return "H";
+        case DataType::INT8: return "b";
+        case DataType::INT16: return "h";
+        case DataType::INT32: return "i";
+        case DataType::INT64: return "q";
+        case DataType::UINT8: return "B";
+        case DataType::UINT16: return "H";
+        case DataType::UINT32: return "I";
+        case DataType::UINT64: return "Q";
+        case DataType::BOOL: return "?";
+        default:
+            throw std::runtime_error("Unsupported tensor data type for NumPy interop");
+    }
+}
+
+// DataType到NumPy dtype：BFLOAT16优先使用ml_dtypes.bfloat16，未安装时退化为uint16位模式
+py::dtype ToNumpyDtype(DataType dtype) {
+    if (dtype == DataType::BFLOAT16) {
+        try {
+            return py::dtype::from_args(py::module_::import("ml_dtypes").attr("bfloat16"));
+        } catch (py::error_already_set&) {
+            return py::dtype("H");
+        }
+    }
+    return py::dtype(BufferFormat(dtype));
+}
+
+// NumPy dtype到DataType，不支持的类型（如float64、object）返回UNKNOWN
+DataType FromNumpyDtype(const py::dtype& dtype) {
+    if (py::str(dtype.attr("name")).cast<std::string>() == "bfloat16") {
+        return DataType::BFLOAT16;
+    }
+    const auto size = dtype.itemsize();
+    switch (dtype.kind()) {
+        case 'f':
+            if (size == 4) return DataType::FLOAT32;
+            if (size == 2) return DataType::FLOAT16;
+            break;
+        case 'i':
+            if (size == 1) return DataType::INT8;
+            if (size == 2) return DataType::INT16;
+            if (size == 4) return DataType::INT32;
+            if (size == 8) return DataType::INT64;
+            break;
+        case 'u':
+            if (size == 1) return DataType::UINT8;
+            if (size == 2) return DataType::UINT16;
+            if (size == 4) return DataType::UINT32;
+            if (size == 8) return DataType::UINT64;
+            break;
+        case 'b':
+            return DataType::BOOL;
+        default:
+            break;
+    }
+    return DataType::UNKNOWN;
+}
+
+// 包装外部内存为不拥有数据的Tensor：最后一个引用释放时先析构Tensor，再在持有GIL的情况下
+// 执行release（释放NumPy数组引用或调用DLPack deleter）；推理线程上释放也安全
+std::shared_ptr<Tensor> WrapExternalBuffer(const Shape& shape, DataType dtype, void* data,
+                                           DeviceType device, std::function<void()> release) {
+    return std::shared_ptr<Tensor>(
+        new Tensor(shape, dtype, data, MemoryLayout::NCHW, device),
+        [release](Tensor* tensor) {
+            delete tensor;
+            py::gil_scoped_acquire gil;
+            release();
+        });
+}
+
+// 以字节计的行主序步长
+std::vector<ssize_t> ByteStrides(const Tensor& tensor) {
+    const ssize_t item_size = static_cast<ssize_t>(Tensor::GetDataTypeSize(tensor.GetDataType()));
+    std::vector<ssize_t> strides;
+    for (int64_t stride : tensor.GetStrides()) {
+        strides.push_back(static_cast<ssize_t>(stride) * item_size);
+    }
+    return strides;
+}
+
+std::vector<ssize_t> NumpyShape(const Tensor& tensor) {
+    const auto& dims = tensor.GetShape().dims;
+    return std::vector<ssize_t>(dims.begin(), dims.end());
+}
+
+void CheckHostTensor(const Tensor& tensor) {
+    if (tensor.GetDeviceType() != DeviceType::CPU) {
+        throw std::runtime_error("Only CPU tensors can be viewed from NumPy; copy the tensor to CPU first");
+    }
+}
+
+DLDevice ToDLDevice(DeviceType device) {
+    switch (device) {
+        case DeviceType::CPU: return {kDLCPU, 0};
+        case DeviceType::CUDA: return {kDLCUDA, 0};
+        default:
+            throw std::runtime_error("DLPack export only supports CPU and CUDA tensors");
+    }
+}
+
+DLDataType ToDLDataType(DataType dtype) {
+    const uint8_t bits = static_cast<uint8_t>(Tensor::GetDataTypeSize(dtype) * 8);
+    switch (dtype) {
+        case DataType::FLOAT32:
+        case DataType::FLOAT16:
+            return {kDLFloat, bits, 1};
+        case DataType::BFLOAT16:
+            return {kDLBfloat, bits, 1};
+        case DataType::INT8:
+        case DataType::INT16:
+        case DataType::INT32:
+        case DataType::INT64:
+            return {kDLInt, bits, 1};
+        case DataType::UINT8:
+        case DataType::UINT16:
+        case DataType::UINT32:
+        case DataType::UINT64:
+            return {kDLUInt, bits, 1};
+        case DataType::BOOL:
+            return {kDLBool, bits, 1};
+        default:
+            throw std::runtime_error("Unsupported tensor data type for DLPack export");
+    }
+}
+
+DataType FromDLDataType(const DLDataType& dtype) {
+    if (dtype.lanes != 1) {
+        return DataType::UNKNOWN;
+    }
+    switch (dtype.code) {
+        case kDLFloat:
+            if (dtype.bits == 32) return DataType::FLOAT32;
+            if (dtype.bits == 16) return DataType::FLOAT16;
+            break;
+        case kDLBfloat:
+            if (dtype.bits == 16) return DataType::BFLOAT16;
+            break;
+        case kDLInt:
+            if (dtype.bits == 8) return DataType::INT8;
+            if (dtype.bits == 16) return DataType::INT16;
+            if (dtype.bits == 32) return DataType::INT32;
+            if (dtype.bits == 64) return DataType::INT64;
+            break;
+        case kDLUInt:
+            if (dtype.bits == 8) return DataType::UINT8;
+            if (dtype.bits == 16) return DataType::UINT16;
+            if (dtype.bits == 32) return DataType::UINT32;
+            if (dtype.bits == 64) return DataType::UINT64;
+            break;
+        case kDLBool:
+            if (dtype.bits == 8) return DataType::BOOL;
+            break;
+        default:
+            break;
+    }
+    return DataType::UNKNOWN;
+}
+
+DeviceType FromDLDevice(const DLDevice& device) {
+    switch (device.device_type) {
+        case kDLCPU: return DeviceType::CPU;
+        case kDLCUDA: return DeviceType::CUDA;
+        default: return DeviceType::UNKNOWN;
+    }
+}
+
+// 导出方的上下文：持有Tensor引用以及DLTensor指向的形状与步长数组
+struct DLPackExportContext {
+    std::shared_ptr<Tensor> tensor;
     std::vector<int64_t> shape;
-    for (size_t i = 0; i < buf.ndim; ++i) {
-        shape.push_back(buf.shape[i]);
+    std::vector<int64_t> strides;
+    DLManagedTensor managed;
+};
+
+} // anonymous namespace
+
+// NumPy数组到Tensor的转换（参考ONNX Runtime的OrtValue.ortvalue_from_numpy）
+// C连续且类型受支持的数组直接包装为不拥有数据的Tensor，Tensor持有数组引用，不拷贝；
+// 非连续或非本机字节序的数组先转成连续副本，副本的生命周期同样由Tensor管理
+std::shared_ptr<Tensor> numpy_to_tensor(py::array arr) {
+    const DataType dtype = FromNumpyDtype(arr.dtype());
+    if (dtype == DataType::UNKNOWN) {
+        throw std::runtime_error("Unsupported NumPy dtype " + py::str(arr.dtype()).cast<std::string>() +
+                                 "; convert with astype() first (e.g. float64 -> float32)");
+    }
+    if (!arr.dtype().attr("isnative").cast<bool>()) {
+        arr = py::array::ensure(arr.attr("astype")(arr.dtype().attr("newbyteorder")("=")));
+    }
+    if (!(arr.flags() & py::array::c_style)) {
+        arr = py::array::ensure(arr, py::array::c_style);
     }
     
-    // 创建Tensor
-    Shape tensor_shape(shape);
-    auto tensor = CreateTensor(tensor_shape, DataType::FLOAT32, DeviceType::CPU);
+    std::vector<int64_t> dims;
+    for (ssize_t i = 0; i < arr.ndim(); ++i) {
+        dims.push_back(static_cast<int64_t>(arr.shape(i)));
+    }
     
-    // 复制数据
-    float* tensor_data = static_cast<float*>(tensor->GetData());
-    float* numpy_data = static_cast<float*>(buf.ptr);
-    std::memcpy(tensor_data, numpy_data, buf.size * sizeof(float));
+    auto* owner = new py::object(arr);
+    return WrapExternalBuffer(Shape(dims), dtype, const_cast<void*>(arr.data()), DeviceType::CPU,
+                              [owner]() { delete owner; });
+}
+
+// Tensor到NumPy数组的转换：数组直接引用Tensor内存，base为持有Tensor引用的capsule，
+// 数组（及其所有视图）存活期间Tensor不会被释放
+py::array tensor_to_numpy(const std::shared_ptr<Tensor>& tensor) {
+    if (!tensor) {
+        throw std::runtime_error("Tensor is null");
+    }
+    CheckHostTensor(*tensor);
     
-    return tensor;
+    auto* keep_alive = new std::shared_ptr<Tensor>(tensor);
+    py::capsule base(keep_alive, [](void* ptr) {
+        delete static_cast<std::shared_ptr<Tensor>*>(ptr);
+    });
+    return py::array(ToNumpyDtype(tensor->GetDataType()), NumpyShape(*tensor), ByteStrides(*tensor),
+                     tensor->GetData(), base);
 }
 
-// Tensor到NumPy数组的转换
-py::array_t<float> tensor_to_numpy(std::shared_ptr<Tensor> tensor) {
+// Tensor导出为DLPack capsule（不拷贝）；消费方负责调用deleter，未被消费的capsule在析构时自行释放
+py::capsule tensor_to_dlpack(const std::shared_ptr<Tensor>& tensor) {
     if (!tensor) {
         throw std::runtime_error("Tensor is null");
     }
+    auto* ctx = new DLPackExportContext();
+    ctx->tensor = tensor;
+    ctx->shape = tensor->GetShape().dims;
+    ctx->strides = tensor->GetStrides();
     
-    const Shape& shape = tensor->GetShape();
-    std::vector<size_t> numpy_shape;
-    std::vector<size_t> numpy_strides;
+    DLTensor& dl = ctx->managed.dl_tensor;
+    try {
+        dl.device = ToDLDevice(tensor->GetDeviceType());
+        dl.dtype = ToDLDataType(tensor->GetDataType());
+    } catch (...) {
+        delete ctx;
+        throw;
+    }
+    dl.data = tensor->GetData();
+    dl.ndim = static_cast<int32_t>(ctx->shape.size());
+    dl.shape = ctx->shape.data();
+    dl.strides = ctx->strides.data();
+    dl.byte_offset = 0;
+    ctx->managed.manager_ctx = ctx;
+    ctx->managed.deleter = [](DLManagedTensor* self) {
+        delete static_cast<DLPackExportContext*>(self->manager_ctx);
+    };
     
-    size_t stride = sizeof(float);
-    for (int64_t i = shape.dims.size() - 1; i >= 0; --i) {
-        numpy_shape.push_back(static_cast<size_t>(shape.dims[i]));
-        numpy_strides.push_back(stride);
-        stride *= shape.dims[i];
+    return py::capsule(&ctx->managed, kDLTensorCapsuleName, [](PyObject* capsule) {
+        if (PyCapsule_IsValid(capsule, kDLTensorCapsuleName)) {
+            auto* managed = static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule, kDLTensorCapsuleName));
+            managed->deleter(managed);
+        }
+    });
+}
+
+// 从DLPack导入（不拷贝）：接受capsule或实现了__dlpack__的对象（torch.Tensor、NumPy数组等）。
+// 只接受行主序连续的张量；导入成功后capsule改名为used_dltensor，Tensor释放时调用生产方的deleter
+std::shared_ptr<Tensor> tensor_from_dlpack(py::object obj) {
+    py::object capsule = py::hasattr(obj, "__dlpack__") ? obj.attr("__dlpack__")() : obj;
+    if (!PyCapsule_IsValid(capsule.ptr(), kDLTensorCapsuleName)) {
+        throw std::runtime_error("Expected a DLPack capsule named 'dltensor' (a capsule can only be consumed once)");
     }
-    std::reverse(numpy_shape.begin(), numpy_shape.end());
-    std::reverse(numpy_strides.begin(), numpy_strides.end());
+    auto* managed = static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule.ptr(), kDLTensorCapsuleName));
+    const DLTensor& dl = managed->dl_tensor;
     
-    float* data = static_cast<float*>(tensor->GetData());
-    size_t size = tensor->GetElementCount();
+    const DataType dtype = FromDLDataType(dl.dtype);
+    if (dtype == DataType::UNKNOWN) {
+        throw std::runtime_error("Unsupported DLPack data type");
+    }
+    const DeviceType device = FromDLDevice(dl.device);
+    if (device == DeviceType::UNKNOWN) {
+        throw std::runtime_error("Unsupported DLPack device type");
+    }
+    
+    std::vector<int64_t> dims(dl.shape, dl.shape + dl.ndim);
+    if (dl.strides) {
+        // 长度为1的维度步长任意
+        int64_t expected = 1;
+        for (int32_t i = dl.ndim - 1; i >= 0; --i) {
+            if (dims[i] != 1 && dl.strides[i] != expected) {
+                throw std::runtime_error("DLPack tensor is not contiguous; call .contiguous() before importing");
+            }
+            expected *= dims[i];
+        }
+    }
     
-    return py::array_t<float>(
-        numpy_shape,
-        numpy_strides,
-        data,
-        py::cast(tensor)  // 保持Tensor对象存活
-    );
+    PyCapsule_SetName(capsule.ptr(), kUsedDLTensorCapsuleName);
+    void* data = static_cast<char*>(dl.data) + dl.byte_offset;
+    return WrapExternalBuffer(Shape(dims), dtype, data, device, [managed]() {
+        if (managed->deleter) {
+            managed->deleter(managed);
+        }
+    });
+}
+
+// 推理输入：Tensor直接使用；NumPy数组零拷贝包装；其余实现__dlpack__的对象走DLPack；
+// 列表等可转换对象先转成NumPy数组
+std::shared_ptr<Tensor> to_input_tensor(const py::object& obj) {
+    if (py::isinstance<Tensor>(obj)) {
+        return obj.cast<std::shared_ptr<Tensor>>();
+    }
+    if (py::isinstance<py::array>(obj)) {
+        return numpy_to_tensor(py::reinterpret_borrow<py::array>(obj));
+    }
+    if (py::hasattr(obj, "__dlpack__")) {
+        return tensor_from_dlpack(obj);
+    }
+    return numpy_to_tensor(py::array::ensure(obj));
+}
+
+// run_async的Python端状态：事件循环与asyncio.Future。回调在推理工作线程上触发，
+// 这里的Python对象只在持有GIL时访问和释放
+struct AsyncRunHandle {
+    py::object loop;
+    py::object future;
+    
+    ~AsyncRunHandle() {
+        py::gil_scoped_acquire gil;
+        loop.release().dec_ref();
+        future.release().dec_ref();
+    }
+    
+    // 经call_soon_threadsafe在事件循环线程上完成future；future已取消或循环已关闭时丢弃结果
+    void Settle(py::object value, bool failed) {
+        py::cpp_function settle([](py::object future, py::object value, bool failed) {
+            if (!future.attr("done")().cast<bool>()) {
+                future.attr(failed ? "set_exception" : "set_result")(value);
+            }
+        });
+        try {
+            loop.attr("call_soon_threadsafe")(settle, future, value, failed);
+        } catch (py::error_already_set&) {
+        }
+    }
+};
+
+py::object RuntimeErrorObject(const std::string& message) {
+    return py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(message);
 }
 
+// 未传入loop时使用当前正在运行的事件循环（在协程中调用），否则使用线程的默认事件循环
+py::object ResolveEventLoop(py::object loop) {
+    if (!loop.is_none()) {
+        return loop;
+    }
+    py::module_ asyncio = py::module_::import("asyncio");
+    try {
+        return asyncio.attr("get_running_loop")();
+    } catch (py::error_already_set&) {
+        return asyncio.attr("get_event_loop")();
+    }
+}
+
+// 会话析构时等待在途的异步运行，而它们的回调需要GIL：析构前先释放GIL，避免死锁
+struct SessionDeleter {
+    void operator()(InferenceSession* session) const {
+        if (PyGILState_Check()) {
+            py::gil_scoped_release release;
+            delete session;
+        } else {
+            delete session;
+        }
+    }
+};
+using SessionHolder = std::unique_ptr<InferenceSession, SessionDeleter>;
+
 // SessionOptions绑定
 void bind_session_options(py::module& m) {
     py::class_<SessionOptions>(m, "SessionOptions")
@@ -106,14 +476,39 @@ void bind_shape(py::module& m) {
         .def("get_static_shape", &Shape::GetStaticShape);
 }
 
+// ProfilingResult绑定
+void bind_profiling_result(py::module& m) {
+    py::class_<ProfilingResult::NodeProfile>(m, "NodeProfile")
+        .def_readonly("node_name", &ProfilingResult::NodeProfile::node_name)
+        .def_readonly("op_type", &ProfilingResult::NodeProfile::op_type)
+        .def_readonly("execution_time_ms", &ProfilingResult::NodeProfile::execution_time_ms)
+        .def_readonly("memory_used_bytes", &ProfilingResult::NodeProfile::memory_used_bytes)
+        .def_readonly("estimated_flops", &ProfilingResult::NodeProfile::estimated_flops)
+        .def_readonly("estimated_bytes", &ProfilingResult::NodeProfile::estimated_bytes);
+    
+    py::class_<ProfilingResult>(m, "ProfilingResult")
+        .def_readonly("node_profiles", &ProfilingResult::node_profiles)
+        .def_readonly("total_time_ms", &ProfilingResult::total_time_ms)
+        .def_readonly("peak_memory_bytes", &ProfilingResult::peak_memory_bytes)
+        .def_readonly("hardware_counters", &ProfilingResult::hardware_counters)
+        .def_readonly("hardware_counter_error", &ProfilingResult::hardware_counter_error);
+}
+
 // InferenceSession绑定
+// 加载、推理与性能分析期间都释放GIL，其他Python线程可以并发执行
 void bind_inference_session(py::module& m) {
-    py::class_<InferenceSession, std::unique_ptr<InferenceSession>>(m, "InferenceSession")
-        .def_static("create", &InferenceSession::Create,
-                   py::arg("options") = SessionOptions(),
+    py::class_<InferenceSession, SessionHolder>(m, "InferenceSession")
+        .def_static("create", [](const SessionOptions& options) {
+            return SessionHolder(InferenceSession::Create(options).release());
+        }, py::arg("options") = SessionOptions(),
                    "Create an inference session")
         .def("load_model", py::overload_cast<const std::string&>(&InferenceSession::LoadModel),
-             "Load model from file")
+             py::call_guard<py::gil_scoped_release>(), "Load model from file")
+        .def("load_model_from_memory", [](InferenceSession& session, const py::bytes& data) {
+            std::string buffer = data;
+            py::gil_scoped_release release;
+            return session.LoadModelFromMemory(buffer.data(), buffer.size());
+        }, py::arg("data"), "Load model from serialized bytes")
         .def("get_input_shapes", &InferenceSession::GetInputShapes,
              "Get input shapes")
         .def("get_output_shapes", &InferenceSession::GetOutputShapes,
@@ -122,50 +517,124 @@ void bind_inference_session(py::module& m) {
              "Get input names")
         .def("get_output_names", &InferenceSession::GetOutputNames,
              "Get output names")
-        .def("run", [](InferenceSession& session, 
-                       const std::vector<py::array_t<float>>& inputs) {
-            // 转换输入
+        .def("run", [](InferenceSession& session, const std::vector<py::object>& inputs) {
+            // 输入零拷贝包装，推理期间由input_storage保持存活
             std::vector<Tensor*> input_tensors;
             std::vector<std::shared_ptr<Tensor>> input_storage;
-            
-            for (const auto& arr : inputs) {
-                auto tensor = numpy_to_tensor(arr);
-                input_storage.push_back(tensor);
-                input_tensors.push_back(tensor.get());
+            for (const auto& obj : inputs) {
+                input_storage.push_back(to_input_tensor(obj));
+                input_tensors.push_back(input_storage.back().get());
             }
             
-            // 执行推理
-            std::vector<Tensor*> outputs;
-            Status status = session.Run(input_tensors, outputs);
-            
+            // 输出所有权移交给调用方；推理期间释放GIL，其他Python线程可以并发调用run
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            Status status;
+            {
+                py::gil_scoped_release release;
+                status = session.Run(input_tensors, outputs);
+            }
             if (!status.IsOk()) {
                 throw std::runtime_error("Run failed: " + status.Message());
             }
             
-            // 转换输出
-            std::vector<py::array_t<float>> result;
-            for (Tensor* output : outputs) {
-                // 注意：这里需要保持Tensor的引用
-                // 简化实现，实际应该从session获取shared_ptr
-                result.push_back(py::array_t<float>());  // TODO: 完整实现
+            // 输出数组直接引用输出Tensor的内存
+            py::list result;
+            for (const auto& output : outputs) {
+                result.append(tensor_to_numpy(output));
             }
+            return result;
+        }, py::arg("inputs"),
+        "Run inference; inputs may be NumPy arrays, Tensors or DLPack-compatible objects")
+        .def("run_async", [](InferenceSession& session, const std::vector<py::object>& inputs, py::object loop) {
+            // 基于原生RunAsync：输入的所有权随请求交给会话，完成后在事件循环线程上完成asyncio.Future
+            std::vector<std::shared_ptr<Tensor>> input_tensors;
+            for (const auto& obj : inputs) {
+                input_tensors.push_back(to_input_tensor(obj));
+            }
+            
+            auto handle = std::make_shared<AsyncRunHandle>();
+            handle->loop = ResolveEventLoop(loop);
+            handle->future = handle->loop.attr("create_future")();
+            py::object future = handle->future;
             
+            Status status;
+            {
+                py::gil_scoped_release release;
+                status = session.RunAsync(std::move(input_tensors),
+                    [handle](Status run_status, std::vector<std::shared_ptr<Tensor>> outputs) {
+                        py::gil_scoped_acquire gil;
+                        if (!run_status.IsOk()) {
+                            handle->Settle(RuntimeErrorObject("Run failed: " + run_status.Message()), true);
+                            return;
+                        }
+                        try {
+                            py::list result;
+                            for (const auto& output : outputs) {
+                                result.append(tensor_to_numpy(output));
+                            }
+                            handle->Settle(result, false);
+                        } catch (const std::exception& e) {
+                            handle->Settle(RuntimeErrorObject(e.what()), true);
+                        }
+                    });
+            }
+            // 未受理（如在途运行达到上限）时future立即带上错误
+            if (!status.IsOk()) {
+                future.attr("set_exception")(RuntimeErrorObject("RunAsync rejected: " + status.Message()));
+            }
+            return future;
+        }, py::arg("inputs"), py::arg("loop") = py::none(),
+        "Run inference asynchronously; returns an asyncio.Future resolving to the output arrays")
+        .def("profile", [](InferenceSession& session) {
+            ProfilingResult result;
+            Status status;
+            {
+                py::gil_scoped_release release;
+                status = session.Profile(result);
+            }
+            if (!status.IsOk()) {
+                throw std::runtime_error("Profile failed: " + status.Message());
+            }
             return result;
-        }, "Run inference")
+        }, "Profile one run per node")
+        .def("end_profiling", &InferenceSession::EndProfiling, py::call_guard<py::gil_scoped_release>(),
+             "Stop tracing and write the trace file; returns its path")
         .def("create_input_tensor", [](InferenceSession& session, size_t index) {
             return session.CreateInputTensor(index);
         }, "Create input tensor");
 }
 
-// Tensor绑定
+// Tensor绑定（支持缓冲协议：np.asarray(tensor)、memoryview(tensor)不拷贝）
 void bind_tensor(py::module& m) {
-    py::class_<Tensor, std::shared_ptr<Tensor>>(m, "Tensor")
+    py::class_<Tensor, std::shared_ptr<Tensor>>(m, "Tensor", py::buffer_protocol())
+        .def_buffer([](Tensor& tensor) -> py::buffer_info {
+            CheckHostTensor(tensor);
+            return py::buffer_info(tensor.GetData(),
+                                   static_cast<ssize_t>(Tensor::GetDataTypeSize(tensor.GetDataType())),
+                                   BufferFormat(tensor.GetDataType()),
+                                   static_cast<ssize_t>(tensor.GetShape().dims.size()),
+                                   NumpyShape(tensor), ByteStrides(tensor));
+        })
         .def("get_shape", &Tensor::GetShape, py::return_value_policy::reference_internal)
-        .def("get_data", [](Tensor& tensor) {
-            return tensor_to_numpy(std::shared_ptr<Tensor>(&tensor, [](Tensor*){}));
-        }, "Get data as NumPy array")
+        .def("get_data_type", &Tensor::GetDataType)
+        .def("get_device_type", &Tensor::GetDeviceType)
+        .def("get_data", [](std::shared_ptr<Tensor> tensor) {
+            return tensor_to_numpy(tensor);
+        }, "Get data as a NumPy array sharing the tensor memory")
+        .def("numpy", [](std::shared_ptr<Tensor> tensor) {
+            return tensor_to_numpy(tensor);
+        }, "Get data as a NumPy array sharing the tensor memory")
+        .def("is_owned", &Tensor::IsOwned)
         .def("get_element_count", &Tensor::GetElementCount)
-        .def("get_size_in_bytes", &Tensor::GetSizeInBytes);
+        .def("get_size_in_bytes", &Tensor::GetSizeInBytes)
+        .def("__dlpack__", [](std::shared_ptr<Tensor> tensor, py::object /*stream*/) {
+            // 推理在返回前已同步完成，无需在消费方的流上等待
+            return tensor_to_dlpack(tensor);
+        }, py::arg("stream") = py::none(), "Export as a DLPack capsule")
+        .def("__dlpack_device__", [](const Tensor& tensor) {
+            const DLDevice device = ToDLDevice(tensor.GetDeviceType());
+            return py::make_tuple(device.device_type, device.device_id);
+        });
 }
 
 // 主模块
@@ -177,16 +646,24 @@ PYBIND11_MODULE(inferunity_py, m) {
     bind_shape(m);
     bind_session_options(m);
     bind_tensor(m);
+    bind_profiling_result(m);
     bind_inference_session(m);
     
     // 数据类型枚举
     py::enum_<DataType>(m, "DataType")
         .value("FLOAT32", DataType::FLOAT32)
         .value("FLOAT16", DataType::FLOAT16)
+        .value("BFLOAT16", DataType::BFLOAT16)
+        .value("INT8", DataType::INT8)
+        .value("INT16", DataType::INT16)
         .value("INT32", DataType::INT32)
         .value("INT64", DataType::INT64)
-        .value("INT8", DataType::INT8)
         .value("UINT8", DataType::UINT8)
+        .value("UINT16", DataType::UINT16)
+        .value("UINT32", DataType::UINT32)
+        .value("UINT64", DataType::UINT64)
+        .value("BOOL", DataType::BOOL)
+        .value("STRING", DataType::STRING)
         .value("UNKNOWN", DataType::UNKNOWN);
     
     // 设备类型枚举
@@ -202,5 +679,12 @@ PYBIND11_MODULE(inferunity_py, m) {
         Shape s(shape);
         return CreateTensor(s, dtype, DeviceType::CPU);
     }, "Create a tensor", py::arg("shape"), py::arg("dtype") = DataType::FLOAT32);
+    m.def("from_numpy", [](py::array arr) { return numpy_to_tensor(arr); },
+          "Wrap a NumPy array as a Tensor without copying (C-contiguous arrays)", py::arg("array"));
+    m.def("from_dlpack", &tensor_from_dlpack,
+          "Import a DLPack capsule or __dlpack__ object as a Tensor without copying", py::arg("obj"));
+    m.def("to_dlpack", &tensor_to_dlpack, "Export a Tensor as a DLPack capsule", py::arg("tensor"));
+    // 之后os.fork与multiprocessing的fork启动方式在子进程中重建线程池，父进程预热的会话可以直接使用
+    m.def("install_fork_handlers", &InstallForkHandlers,
+          "Make os.fork() safe: thread pools and background threads are stopped before fork and restarted after");
 }
-
@@ -0,0 +1,382 @@
+// Arm NN执行提供者（Ethos-N NPU、Mali GPU、Cortex-A）
+// 参考ONNX Runtime的ArmNNExecutionProvider：认领Arm NN的ONNX解析器支持的连通子图，子图导出为ONNX后由
+// armnnOnnxParser解析，按armnn_backends的优先级优化并加载。GpuAcc/EthosNAcc编译出的网络通过后端的
+// CachedNetworkFilePath选项缓存到磁盘，以子图的ONNX导出内容为键，之后的会话直接加载。
+// 子图边界上的张量放在dma-buf中（见npu::BoundaryBuffer），网络以MemorySource::Malloc加载，
+// 对齐的主机内存由Arm NN直接导入而不拷贝；提供者与主机共享内存，图分区不插入拷贝节点
+
+#include "inferunity/backend.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/tensor.h"
+#include "npu_common.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_ARMNN
+#include <armnn/ArmNN.hpp>
+#include <armnnOnnxParser/IOnnxParser.hpp>
+
+namespace inferunity {
+
+namespace {
+
+// armnnOnnxParser支持、且图中以标准ONNX形式存在的算子
+const std::unordered_set<std::string>& ArmNNSupportedOps() {
+    static const std::unordered_set<std::string> ops = {
+        "Conv", "MatMul", "Gemm", "BatchNormalization",
+        "Relu", "LeakyRelu", "Sigmoid", "Tanh", "Clip",
+        "Add", "Mul",
+        "MaxPool", "AveragePool", "GlobalAveragePool",
+        "Reshape", "Flatten", "Concat", "Gather", "Unsqueeze", "Shape"
+    };
+    return ops;
+}
+
+// 缓存编译结果的后端（CpuAcc没有编译产物）
+bool SupportsNetworkCache(const std::string& backend) {
+    return backend == "GpuAcc" || backend == "EthosNAcc";
+}
+
+// 一个认领子图加载到Arm NN运行时后的网络；输入输出按绑定id交换数据
+class ArmNNSubgraph {
+public:
+    ArmNNSubgraph(armnn::IRuntime* runtime, armnn::NetworkId network_id,
+                  std::vector<armnn::LayerBindingId> input_ids, std::vector<armnn::LayerBindingId> output_ids,
+                  std::vector<Shape> output_shapes)
+        : runtime_(runtime), network_id_(network_id), input_ids_(std::move(input_ids)),
+          output_ids_(std::move(output_ids)), output_shapes_(std::move(output_shapes)),
+          input_buffers_(input_ids_.size()), output_buffers_(output_ids_.size()) {}
+
+    ~ArmNNSubgraph() {
+        runtime_->UnloadNetwork(network_id_);
+    }
+
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+        if (inputs.size() != input_ids_.size() || outputs.size() != output_ids_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Arm NN subgraph input/output count mismatch");
+        }
+        // 边界缓冲按子图复用，同一子图的运行串行执行
+        std::lock_guard<std::mutex> lock(mutex_);
+        armnn::InputTensors input_tensors;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            armnn::TensorInfo info = runtime_->GetInputTensorInfo(network_id_, input_ids_[i]);
+            if (inputs[i]->GetDataType() != DataType::FLOAT32 ||
+                inputs[i]->GetShape().GetElementCount() != static_cast<int64_t>(info.GetNumElements())) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Arm NN network loaded for a different input shape");
+            }
+            void* data = nullptr;
+            DmaBufRegion region;
+            Status status = input_buffers_[i].PrepareInput(*inputs[i], &data, &region);
+            if (!status.IsOk()) {
+                return status;
+            }
+            info.SetConstant(true);
+            input_tensors.emplace_back(input_ids_[i], armnn::ConstTensor(info, data));
+        }
+        armnn::OutputTensors output_tensors;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            void* data = nullptr;
+            DmaBufRegion region;
+            Status status = output_buffers_[i].PrepareOutput(outputs[i], output_shapes_[i], DataType::FLOAT32,
+                                                             &data, &region);
+            if (!status.IsOk()) {
+                return status;
+            }
+            output_tensors.emplace_back(output_ids_[i],
+                                        armnn::Tensor(runtime_->GetOutputTensorInfo(network_id_, output_ids_[i]), data));
+        }
+        if (runtime_->EnqueueWorkload(network_id_, input_tensors, output_tensors) != armnn::Status::Success) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Arm NN workload execution failed");
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            Status status = output_buffers_[i].FinishOutput(outputs[i]);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    armnn::IRuntime* runtime_;
+    armnn::NetworkId network_id_;
+    std::vector<armnn::LayerBindingId> input_ids_;
+    std::vector<armnn::LayerBindingId> output_ids_;
+    std::vector<Shape> output_shapes_;
+    std::vector<npu::BoundaryBuffer> input_buffers_;
+    std::vector<npu::BoundaryBuffer> output_buffers_;
+    std::mutex mutex_;
+};
+
+} // namespace
+
+class ArmNNExecutionProvider : public ExecutionProvider {
+public:
+    ArmNNExecutionProvider()
+        : host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")),
+          runtime_(armnn::IRuntime::Create(armnn::IRuntime::CreationOptions())) {
+        backends_ = npu::SplitList(SessionOptions().armnn_backends);
+    }
+
+    ~ArmNNExecutionProvider() override {
+        // 网络先于运行时卸载
+        subgraphs_.clear();
+    }
+
+    std::string GetName() const override {
+        return "ArmNNExecutionProvider";
+    }
+
+    DeviceType GetDeviceType() const override {
+        return DeviceType::ARMNN;
+    }
+
+    bool IsAvailable() const override {
+        return runtime_ && !AvailableBackends().empty();
+    }
+
+    // 边界张量在主机可访问的内存中，设备接口沿用CPU提供者
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
+    }
+
+    int GetDeviceCount() const override {
+        return 1;
+    }
+
+    bool SharesHostMemory() const override { return true; }
+
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override {
+        (void)node; (void)output_index;
+        return DeviceType::CPU;
+    }
+
+    Status ConfigureSession(const SessionOptions& options) override {
+        backends_ = npu::SplitList(options.armnn_backends);
+        cache_dir_ = options.npu_artifact_cache_dir.empty() ? options.optimized_model_cache_dir
+                                                            : options.npu_artifact_cache_dir;
+        return Status::Ok();
+    }
+
+    // 逐节点的算子由CPU提供者执行；Arm NN只执行认领的子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        // 层融合由armnn::Optimize完成
+        (void)graph;
+        return Status::Ok();
+    }
+
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    bool SupportsSubgraphCompilation() const override { return IsAvailable(); }
+    bool ClaimsSubgraphs() const override { return IsAvailable(); }
+
+    // 解析器只接受静态形状；输出为FP32
+    bool CanCompileNode(const Node* node) const override {
+        if (!node || !ArmNNSupportedOps().count(node->GetOpType())) {
+            return false;
+        }
+        for (const Value* output : node->GetOutputs()) {
+            if (output->GetDataType() != DataType::FLOAT32 && node->GetOpType() != "Shape") {
+                return false;
+            }
+            for (int64_t d : output->GetShape().dims) {
+                if (d <= 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 子图导出为ONNX后解析、优化并加载；编译型后端的网络按导出内容缓存到磁盘
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        const std::vector<armnn::BackendId> backends = AvailableBackends();
+        if (!runtime_ || backends.empty()) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "No requested Arm NN backend is available");
+        }
+        npu::ExportedSubgraph exported;
+        Status status = npu::ExportSubgraph(*subgraph, &exported);
+        if (!status.IsOk()) {
+            return status;
+        }
+
+        std::map<std::string, armnn::TensorShape> input_shapes;
+        for (size_t i = 0; i < subgraph->GetInputs().size(); ++i) {
+            const std::vector<int64_t>& dims = subgraph->GetInputs()[i]->GetShape().dims;
+            std::vector<unsigned int> shape(dims.begin(), dims.end());
+            input_shapes.emplace(exported.input_names[i],
+                                 armnn::TensorShape(static_cast<unsigned int>(shape.size()), shape.data()));
+        }
+        armnnOnnxParser::IOnnxParserPtr parser = armnnOnnxParser::IOnnxParser::Create();
+        armnn::INetworkPtr network(nullptr, nullptr);
+        std::vector<armnn::LayerBindingId> input_ids;
+        std::vector<armnn::LayerBindingId> output_ids;
+        try {
+            const std::vector<uint8_t> model(exported.model_bytes.begin(), exported.model_bytes.end());
+            network = parser->CreateNetworkFromBinary(model, input_shapes);
+            for (const std::string& name : exported.input_names) {
+                input_ids.push_back(parser->GetNetworkInputBindingInfo(name).first);
+            }
+            for (const std::string& name : exported.output_names) {
+                output_ids.push_back(parser->GetNetworkOutputBindingInfo(name).first);
+            }
+        } catch (const armnn::Exception& e) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               std::string("Arm NN cannot parse subgraph: ") + e.what());
+        }
+
+        // 缓存文件存在时加载，否则编译后保存
+        armnn::OptimizerOptionsOpaque optimizer_options;
+        for (const armnn::BackendId& backend : backends) {
+            const std::string name = backend.Get();
+            const std::string cache_path = npu::ArtifactPath(cache_dir_, "armnn_" + name, exported.hash, "bin");
+            if (!SupportsNetworkCache(name) || cache_path.empty()) {
+                continue;
+            }
+            const bool cached = std::ifstream(cache_path, std::ios::binary).good();
+            if (!cached) {
+                std::ofstream(cache_path, std::ios::binary).close();
+            }
+            optimizer_options.AddModelOption(armnn::BackendOptions(name, {
+                {"SaveCachedNetwork", !cached},
+                {"CachedNetworkFilePath", cache_path}
+            }));
+            LOG_INFO("Arm NN " + name + " network cache " + (cached ? "loaded from " : "written to ") + cache_path);
+        }
+        std::vector<std::string> messages;
+        armnn::IOptimizedNetworkPtr optimized = armnn::Optimize(
+            *network, backends, runtime_->GetDeviceSpec(), optimizer_options,
+            armnn::Optional<std::vector<std::string>&>(messages));
+        if (!optimized) {
+            std::string reason;
+            for (const std::string& message : messages) {
+                reason += " " + message;
+            }
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Arm NN failed to optimize subgraph:" + reason);
+        }
+
+        armnn::NetworkId network_id;
+        std::string error;
+        armnn::INetworkProperties properties(false, armnn::MemorySource::Malloc, armnn::MemorySource::Malloc);
+        if (runtime_->LoadNetwork(network_id, std::move(optimized), error, properties) != armnn::Status::Success) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Arm NN failed to load network: " + error);
+        }
+        std::vector<Shape> output_shapes;
+        for (const Value* output : subgraph->GetOutputs()) {
+            output_shapes.push_back(output->GetShape());
+        }
+        subgraphs_[fused_node] = std::make_unique<ArmNNSubgraph>(runtime_.get(), network_id, std::move(input_ids),
+                                                                 std::move(output_ids), std::move(output_shapes));
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "Arm NN backend only executes claimed subgraphs: " + node->GetOpType());
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Claimed subgraph input has no tensor: " + input->GetName());
+            }
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs);
+    }
+
+private:
+    // armnn_backends中运行时实际支持的后端，保持给定的优先级
+    std::vector<armnn::BackendId> AvailableBackends() const {
+        std::vector<armnn::BackendId> backends;
+        if (!runtime_) {
+            return backends;
+        }
+        const armnn::BackendIdSet supported = runtime_->GetDeviceSpec().GetSupportedBackends();
+        for (const std::string& name : backends_) {
+            if (supported.count(armnn::BackendId(name))) {
+                backends.emplace_back(name);
+            }
+        }
+        return backends;
+    }
+
+    std::unique_ptr<ExecutionProvider> host_provider_;
+    armnn::IRuntimePtr runtime_;
+    std::vector<std::string> backends_;
+    std::string cache_dir_;
+    std::unordered_map<Node*, std::unique_ptr<ArmNNSubgraph>> subgraphs_;
+};
+
+// 注册Arm NN执行提供者
+namespace {
+    void RegisterArmNNExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("ArmNNExecutionProvider", []() {
+            return std::make_unique<ArmNNExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("ArmNN", []() {
+            return std::make_unique<ArmNNExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterArmNNExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_ARMNN未定义
+
+namespace inferunity {
+    // Arm NN未启用时的占位实现
+    // 注册函数为空，不会注册Arm NN后端
+}
+
+#endif  // INFERUNITY_USE_ARMNN
@@ -2,16 +2,23 @@
 #include "inferunity/operator.h"
 #include "inferunity/memory.h"
 #include "inferunity/graph.h"
+#include "inferunity/engine.h"
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/optimizer.h"
+#include "inferunity/runtime.h"
 #include "inferunity/tensor.h"
+#include "operators/conv_kernels.h"
+#include "operators/simd_utils.h"
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
-#ifdef __APPLE__
-#include <stdlib.h>
-#else
-#include <malloc.h>
-#endif
 
 // 前向声明形状推断函数
 namespace inferunity {
@@ -26,34 +33,17 @@ public:
     DeviceType GetType() const override { return DeviceType::CPU; }
     std::string GetName() const override { return "CPU"; }
     
+    // 与张量共用分级内存池，设备分配计入GetMemoryStats()
     void* Allocate(size_t size) override {
-        return std::malloc(size);
+        return AllocateMemory(size);
     }
     
     void Free(void* ptr) override {
-        std::free(ptr);
+        FreeMemory(ptr);
     }
     
     void* AllocateAligned(size_t size, size_t alignment) override {
-        void* ptr = nullptr;
-        #ifdef _WIN32
-            ptr = _aligned_malloc(size, alignment);
-        #elif defined(__APPLE__)
-            // macOS使用posix_memalign
-            if (posix_memalign(&ptr, alignment, size) != 0) {
-                return nullptr;
-            }
-        #else
-            // Linux使用aligned_alloc或posix_memalign
-            #if __STDC_VERSION__ >= 201112L
-                ptr = aligned_alloc(alignment, size);
-            #else
-                if (posix_memalign(&ptr, alignment, size) != 0) {
-                    return nullptr;
-                }
-            #endif
-        #endif
-        return ptr;
+        return AllocateMemory(size, alignment);
     }
     
     Status Copy(void* dst, const void* src, size_t size) override {
@@ -117,25 +107,36 @@ public:
         static const std::unordered_set<std::string> supported_operators = {
             // 基础算子
             "Conv", "Relu", "Sigmoid", "Tanh", "Gelu", "GELU", "Silu", "SiLU", "Swish",
-            "MatMul", "Add", "Mul", "Sub",
-            "MaxPool", "AvgPool", "AveragePool", "GlobalMaxPool", "GlobalAvgPool",
+            "MatMul", "Gemm", "Add", "Mul", "Sub", "Div", "Pow", "Max", "Min", "Where",
+            "MaxPool", "AvgPool", "AveragePool", "GlobalMaxPool", "GlobalAvgPool", "GlobalAveragePool",
             "BatchNormalization", "LayerNormalization", "RMSNorm",
             "Softmax", "LogSoftmax",
+            "ReduceSum", "ReduceMean", "ReduceMax", "ReduceMin", "ReduceSumSquare", "ReduceL2",
             // 形状操作
             "Reshape", "Concat", "Split", "Transpose", "Gather", "Slice",
             // Transformer专用
-            "Embedding",
+            "Embedding", "AddLayerNorm", "AddRMSNorm",
             // 融合算子
             "FusedConvBNReLU", "FusedMatMulAdd", "FusedConvReLU", "FusedBNReLU",
+            "FusedConvAddReLU", "FusedElementwise", "FusedAttention", "FusedDepthwisePointwise", "FusedTileGroup",
+            // 分块通道布局
+            "ReorderInput", "ReorderOutput", "NchwcConv", "NchwcMaxPool", "NchwcAveragePool",
+            "NchwcBatchNormalization", "NchwcGlobalMaxPool", "NchwcGlobalAveragePool",
+            // 量化
+            "QuantizeLinear", "DequantizeLinear", "QLinearConv", "QLinearMatMul",
             // 其他常用算子
-            "Dropout", "Flatten", "Pad", "Resize"
+            "Dropout", "Flatten", "Pad", "Resize", "ImagePreprocess",
+            // 检测后处理
+            "TopK", "NonMaxSuppression",
+            // 循环网络
+            "LSTM", "GRU"
         };
-        
+    
         // 检查是否在支持列表中
         if (supported_operators.find(op_type) != supported_operators.end()) {
             return true;
         }
-        
+    
         // 也检查算子注册表（支持动态注册的算子）
         return OperatorRegistry::Instance().IsRegistered(op_type);
     }
@@ -151,28 +152,50 @@ public:
         if (!graph) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
         }
-        
+    
         // 1. 形状推断（确保所有节点都有正确的形状信息）
         Status shape_status = InferShapes(graph);
         if (!shape_status.IsOk()) {
             // 形状推断失败不是致命错误，继续优化
         }
-        
+    
         // 2. 验证图结构
         Status validate_status = graph->Validate();
         if (!validate_status.IsOk()) {
             return validate_status;
         }
-        
+    
         // 3. CPU特定的优化：
         // - 确保所有节点都分配到CPU设备
         for (const auto& node : graph->GetNodes()) {
             node->SetDevice(DeviceType::CPU);
         }
-        
+    
         // 4. 内存布局优化（已在优化器中实现，这里可以再次应用）
         // 注意：实际优化应该在Optimizer中完成，这里只是确保设备分配
-        
+    
+        return Status::Ok();
+    }
+    
+    // QDQ图（QuantizeGraph或导入的QDQ模型）折叠为QLinearConv/QLinearMatMul整数内核
+    bool SupportsQuantization() const override { return true; }
+    Status QuantizeModel(Graph* graph, DataType target_dtype) override {
+        if (!graph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+        }
+        if (target_dtype != DataType::INT8 && target_dtype != DataType::UINT8) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "CPU quantization only supports INT8 or UINT8");
+        }
+        QDQFusionPass pass;
+        return pass.Run(graph);
+    }
+    
+    Status ConfigureSession(const SessionOptions& options) override {
+        autotune_ = options.enable_cpu_autotuning;
+        max_threads_ = options.num_threads;
+        min_work_per_thread_ = options.intra_op_min_work_per_thread;
+        embedding_cache_rows_ = options.embedding_cache_rows;
         return Status::Ok();
     }
     
@@ -182,27 +205,26 @@ public:
         // 1. 验证算子是否支持
         // 2. 预分配内存
         // 3. 选择最优的内核实现
-        
+    
         if (!node) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
         }
-        
+    
         // 检查算子是否支持
-        if (!SupportsOperator(node->GetOpType())) {
+        if (!SupportsOperatorId(node->GetOpTypeId())) {
             return Status::Error(StatusCode::ERROR_NOT_FOUND,
                                "Operator not supported: " + node->GetOpType());
         }
-        
+    
         // 验证节点输入输出
         if (node->GetInputs().empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Node has no inputs");
         }
-        
-        // CPU后端不需要特殊的编译步骤
-        // 实际的内核选择在ExecuteNode时动态决定
-        
-        return Status::Ok();
+    
+        // 创建算子实例并解析属性，缓存到kernels_中供ExecuteNode直接复用
+        CompiledKernel* kernel = nullptr;
+        return BuildKernel(node, &kernel);
     }
     
     Status PrepareExecution(Graph* graph) override {
@@ -210,14 +232,14 @@ public:
         // 1. 分配内存
         // 2. 编译节点
         // 3. 预计算常量
-        
+    
         if (!graph) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
         }
-        
+    
         // 1. 形状推断（应该在图优化阶段完成）
         // 这里只验证形状是否已推断
-        
+    
         // 2. 为所有输出Value预分配Tensor（可选优化）
         // 这样可以避免在执行时动态分配
         for (Value* output : graph->GetOutputs()) {
@@ -233,74 +255,399 @@ public:
                 }
             }
         }
-        
-        // 3. 编译所有节点（验证和准备）
+    
+        // 3. 编译所有节点（验证和准备），旧的内核缓存整体失效
+        {
+            std::unique_lock<std::shared_mutex> lock(kernels_mutex_);
+            kernels_.clear();
+        }
+        // 各节点的编译相互独立，在线程池上并行（BuildKernel在登记时加锁）
+        std::vector<Node*> nodes;
         for (const auto& node : graph->GetNodes()) {
-            Status compile_status = CompileNode(node.get());
-            if (!compile_status.IsOk()) {
-                // 编译失败，记录但继续
-                // 实际执行时可能会失败
+            nodes.push_back(node.get());
+        }
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(nodes.size()), 16, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                // 编译失败，记录但继续，实际执行时可能会失败
+                (void)CompileNode(nodes[i]);
             }
+        });
+    
+        // 4. 自动调优（可选）：在预打包之前选定卷积算法，预打包按选中的算法变换权重
+        if (autotune_) {
+            AutotuneKernels(graph);
         }
-        
-        // 4. 内存预分配（可选，由内存管理器处理）
+    
+        // 5. 权重预打包（参考ONNX Runtime SessionState的PrePack）：常量初始化器输入
+        // 在这里一次性变换为内核布局，打包结果由PrepackedWeightCache在会话之间共享
+        PrePackConstantInputs(graph);
+    
+        // 6. 内存预分配（可选，由内存管理器处理）
         // 这里可以触发内存生命周期分析
-        
+    
         return Status::Ok();
     }
     
     Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
-        // 执行节点
-        auto op = CreateOperator(node->GetOpType());
-        if (!op) {
-            return Status::Error(StatusCode::ERROR_NOT_FOUND,
-                               "Operator not found: " + node->GetOpType());
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
         }
-        
-        // 将Node的属性复制到Operator（参考ONNX Runtime的实现）
-        for (const auto& attr : node->GetAttributes()) {
-            // 将字符串属性转换为AttributeValue
-            // 简化实现：尝试解析为int或float，否则作为字符串
-            AttributeValue attr_value;
-            try {
-                // 尝试解析为整数
-                int64_t int_val = std::stoll(attr.second);
-                attr_value = AttributeValue(int_val);
-            } catch (...) {
-                try {
-                    // 尝试解析为浮点数
-                    float float_val = std::stof(attr.second);
-                    attr_value = AttributeValue(float_val);
-                } catch (...) {
-                    // 作为字符串
-                    attr_value = AttributeValue(attr.second);
-                }
+    
+        // 命中编译缓存：稳态下不再创建算子、不再解析属性字符串
+        // （参考ONNX Runtime的SessionState中缓存的OpKernel）
+        CompiledKernel* kernel = FindKernel(node);
+        if (!kernel) {
+            Status status = BuildKernel(node, &kernel);
+            if (!status.IsOk()) {
+                return status;
             }
-            op->SetAttribute(attr.first, attr_value);
         }
-        
-        // 准备输入输出
-        std::vector<Tensor*> inputs;
-        std::vector<Tensor*> outputs;
-        
+    
+        // 刷新输入输出指针：Value上的Tensor可能在两次运行之间被重新绑定，
+        // 这里复用已预留容量的数组，不产生堆分配
+        kernel->inputs.clear();
         for (Value* input : node->GetInputs()) {
-            if (input->GetTensor()) {
-                inputs.push_back(input->GetTensor().get());
+            if (Tensor* tensor = input->GetTensor().get()) {
+                kernel->inputs.push_back(tensor);
             }
         }
-        
+        kernel->outputs.clear();
         for (Value* output : node->GetOutputs()) {
-            if (output->GetTensor()) {
-                outputs.push_back(output->GetTensor().get());
+            if (Tensor* tensor = output->GetTensor().get()) {
+                kernel->outputs.push_back(tensor);
             }
         }
-        
+    
         // 执行
-        return op->Execute(inputs, outputs, ctx);
+        return RunKernel(kernel, kernel->inputs, kernel->outputs, ctx);
     }
     
+    bool SupportsConcurrentExecution() const override { return true; }
+    
+    Status ExecuteKernel(Node* node, const std::vector<Tensor*>& inputs,
+                         const std::vector<Tensor*>& outputs, ExecutionContext* ctx) override {
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        // 算子实例在并发的运行之间共享：执行中的临时缓冲取自调用线程的暂存区，按形状缓存的准备结果
+        // （如卷积计划）由算子在锁内查找；输入输出数组由调用方（各自的ExecutionState）持有
+        CompiledKernel* kernel = FindKernel(node);
+        if (!kernel) {
+            Status status = BuildKernel(node, &kernel);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return RunKernel(kernel, inputs, outputs, ctx);
+    }
+
 private:
+    // 已编译的节点内核：算子实例、类型化属性和预留的输入输出指针数组
+    struct CompiledKernel {
+        int64_t node_id = -1;
+        std::unique_ptr<Operator> op;
+        std::vector<Tensor*> inputs;
+        std::vector<Tensor*> outputs;
+        int num_threads = 0;  // 调优选出的算子内线程数，0表示沿用执行上下文的配置
+        size_t scratch_bytes = 0;  // 编译时按输入形状声明的每线程暂存字节数
+    };
+    
+    // 调优选出的线程数少于上下文的配置时，本次执行临时收紧（上下文属于调用线程，执行后恢复）。
+    // 算子从暂存区切出的临时缓冲在节点执行结束时回收
+    static Status RunKernel(CompiledKernel* kernel, const std::vector<Tensor*>& inputs,
+                            const std::vector<Tensor*>& outputs, ExecutionContext* ctx) {
+        ScratchScope scratch(kernel->scratch_bytes);
+        if (ctx) {
+            ctx->SetScratchBytes(kernel->scratch_bytes);
+        }
+        if (kernel->num_threads <= 0 || !ctx ||
+            ctx->GetIntraOpParallelism().num_threads <= kernel->num_threads) {
+            return kernel->op->Execute(inputs, outputs, ctx);
+        }
+        const IntraOpParallelism saved = ctx->GetIntraOpParallelism();
+        IntraOpParallelism tuned = saved;
+        tuned.num_threads = kernel->num_threads;
+        ctx->SetIntraOpParallelism(tuned);
+        Status status = kernel->op->Execute(inputs, outputs, ctx);
+        ctx->SetIntraOpParallelism(saved);
+        return status;
+    }
+    
+    // 调优候选编码为TuningRecord::algorithm：卷积算法 * kAlgorithmStride + 线程数
+    static constexpr int kAlgorithmStride = 1 << 16;
+    
+    static bool IsAutotunable(const std::string& op_type) {
+        static const std::unordered_set<std::string> tunable = {
+            "Conv", "FusedConvReLU", "FusedConvBNReLU", "FusedConvAddReLU", "FusedDepthwisePointwise",
+            "NchwcConv", "MatMul", "Gemm", "FusedMatMulAdd", "FusedAttention"
+        };
+        return tunable.count(op_type) > 0;
+    }
+    
+    // 设备键：同一指令集与核数的机器共用调优结果
+    static std::string TuningDevice() {
+        return std::string("CPU ") + simd::GetSimdIsaName() + " x" +
+               std::to_string(ThreadPool::GetAvailableThreadCount());
+    }
+    
+    // 形状签名：全部输入形状与按键排序的属性（strides、trans等同样决定最优配置）
+    static std::string TuningSignature(const Node& node) {
+        std::string signature;
+        for (const Value* input : node.GetInputs()) {
+            signature += "[";
+            if (input) {
+                for (int64_t dim : input->GetShape().dims) {
+                    signature += std::to_string(dim) + ",";
+                }
+            }
+            signature += "]";
+        }
+        const std::map<std::string, AttributeValue> attributes(node.GetAttributes().begin(),
+                                                               node.GetAttributes().end());
+        for (const auto& attr : attributes) {
+            signature += attr.first + "=" + attr.second.ToString() + ";";
+        }
+        return signature;
+    }
+    
+    static bool IsStaticShape(const Shape& shape) {
+        if (shape.dims.empty() || shape.IsDynamic()) {
+            return false;
+        }
+        return std::all_of(shape.dims.begin(), shape.dims.end(), [](int64_t dim) { return dim > 0; });
+    }
+    
+    // 对形状静态的计算密集节点实测(卷积算法, 线程数)候选（参考TVM的AutoTVM与ONNX Runtime的TunableOp）：
+    // 常量输入用真实权重，其余输入与输出用按形状新建的临时张量；最快的组合写入调优缓存并记在已编译内核上
+    void AutotuneKernels(Graph* graph) {
+        std::unordered_set<const Value*> graph_inputs(graph->GetInputs().begin(),
+                                                      graph->GetInputs().end());
+        const int max_threads = max_threads_ > 0 ? max_threads_ :
+            static_cast<int>(std::max<size_t>(ThreadPool::GetAvailableThreadCount(), 1));
+        std::vector<int> thread_counts;
+        for (int threads = 1; threads < max_threads; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(max_threads);
+        const std::string device = TuningDevice();
+    
+        for (const auto& node : graph->GetNodes()) {
+            CompiledKernel* kernel = FindKernel(node.get());
+            if (!kernel || !IsAutotunable(node->GetOpType())) {
+                continue;
+            }
+            std::vector<std::shared_ptr<Tensor>> scratch;
+            std::vector<Tensor*> inputs;
+            std::vector<Tensor*> outputs;
+            bool runnable = true;
+            for (Value* input : node->GetInputs()) {
+                auto tensor = input ? input->GetTensor() : nullptr;
+                const bool constant = input && !input->GetProducer() && !graph_inputs.count(input) &&
+                                      tensor && tensor->GetData();
+                if (!constant) {
+                    if (!input || !IsStaticShape(input->GetShape())) {
+                        runnable = false;
+                        break;
+                    }
+                    tensor = CreateTensor(input->GetShape(), input->GetDataType() == DataType::UNKNOWN ?
+                                          DataType::FLOAT32 : input->GetDataType(), DeviceType::CPU);
+                    std::memset(tensor->GetData(), 0, tensor->GetSizeInBytes());
+                    scratch.push_back(tensor);
+                }
+                inputs.push_back(tensor.get());
+            }
+            for (Value* output : node->GetOutputs()) {
+                if (!runnable || !IsStaticShape(output->GetShape())) {
+                    runnable = false;
+                    break;
+                }
+                scratch.push_back(CreateTensor(output->GetShape(), output->GetDataType() == DataType::UNKNOWN ?
+                                               DataType::FLOAT32 : output->GetDataType(), DeviceType::CPU));
+                outputs.push_back(scratch.back().get());
+            }
+            if (!runnable) {
+                continue;
+            }
+    
+            // 卷积类节点另外在适用的算法之间选择；节点已指定conv_algorithm时只调线程数
+            std::vector<operators::ConvAlgorithm> algorithms = {operators::ConvAlgorithm::AUTO};
+            static const std::unordered_set<std::string> conv_ops = {
+                "Conv", "FusedConvReLU", "FusedConvBNReLU", "FusedConvAddReLU"
+            };
+            if (conv_ops.count(node->GetOpType()) && !node->HasAttribute("conv_algorithm") && inputs.size() > 1) {
+                operators::Conv2DParams params;
+                if (operators::ParseConv2DParams(*kernel->op, inputs[0]->GetShape(), inputs[1]->GetShape(),
+                                                 &params).IsOk()) {
+                    for (auto algorithm : {operators::ConvAlgorithm::IM2COL_GEMM, operators::ConvAlgorithm::POINTWISE,
+                                           operators::ConvAlgorithm::WINOGRAD_F23, operators::ConvAlgorithm::WINOGRAD_F43,
+                                           operators::ConvAlgorithm::DEPTHWISE}) {
+                        if (operators::IsConvAlgorithmApplicable(algorithm, params)) {
+                            algorithms.push_back(algorithm);
+                        }
+                    }
+                }
+            }
+            std::vector<int> candidates;
+            for (auto algorithm : algorithms) {
+                for (int threads : thread_counts) {
+                    candidates.push_back(static_cast<int>(algorithm) * kAlgorithmStride + threads);
+                }
+            }
+    
+            auto apply = [&](int candidate) {
+                const auto algorithm = static_cast<operators::ConvAlgorithm>(candidate / kAlgorithmStride);
+                if (algorithms.size() > 1) {
+                    kernel->op->SetAttribute("conv_algorithm",
+                                             AttributeValue(std::string(operators::ConvAlgorithmName(algorithm))));
+                }
+                kernel->num_threads = candidate % kAlgorithmStride;
+            };
+            auto benchmark = [&](int candidate, TuningRecord* measured) {
+                apply(candidate);
+                ExecutionContext ctx;
+                IntraOpParallelism intra_op;
+                intra_op.num_threads = kernel->num_threads;
+                intra_op.min_work_per_thread = min_work_per_thread_;
+                ctx.SetIntraOpParallelism(intra_op);
+                ctx.SetScratchBytes(kernel->scratch_bytes);
+                ScratchScope scratch(kernel->scratch_bytes);
+                // 第一次执行完成算法准备与权重变换，不计时；之后取几次中最快的
+                Status status = kernel->op->Execute(inputs, outputs, &ctx);
+                if (!status.IsOk()) {
+                    return status;
+                }
+                double best = 0.0;
+                for (int repeat = 0; repeat < 3; ++repeat) {
+                    auto start = std::chrono::steady_clock::now();
+                    status = kernel->op->Execute(inputs, outputs, &ctx);
+                    if (!status.IsOk()) {
+                        return status;
+                    }
+                    const double elapsed = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start).count();
+                    best = repeat == 0 ? elapsed : std::min(best, elapsed);
+                }
+                measured->time_us = best;
+                return Status::Ok();
+            };
+    
+            const std::string key = KernelTuningCache::MakeKey(device, node->GetOpType(), TuningSignature(*node),
+                                                               node->GetInputs()[0]->GetDataType());
+            TuningRecord winner;
+            if (AutotuneKernel(key, candidates, benchmark, &GetKernelTuningCache(), &winner).IsOk()) {
+                apply(winner.algorithm);
+            } else {
+                // 所有候选都失败（如输入不满足算子要求）：恢复编译时的配置
+                apply(static_cast<int>(operators::ConvAlgorithm::AUTO) * kAlgorithmStride);
+            }
+        }
+    }
+    
+    // 常量初始化器：带张量、没有生产者且不是图输入（图输入在每次运行时重新绑定）
+    void PrePackConstantInputs(Graph* graph) {
+        std::unordered_set<const Value*> graph_inputs(graph->GetInputs().begin(),
+                                                      graph->GetInputs().end());
+        // 每个节点只改写自己的算子实例，打包结果经PrepackedWeightCache去重，按节点并行；
+        // 权重大小差别很大，每次只取一个节点
+        std::vector<std::pair<Node*, CompiledKernel*>> kernels;
+        for (const auto& node : graph->GetNodes()) {
+            if (CompiledKernel* kernel = FindKernel(node.get())) {
+                kernels.emplace_back(node.get(), kernel);
+            }
+        }
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(kernels.size()), 1, [&](int64_t begin, int64_t end) {
+            std::vector<Shape> input_shapes;
+            for (int64_t k = begin; k < end; ++k) {
+                const auto& inputs = kernels[k].first->GetInputs();
+                input_shapes.clear();
+                for (Value* input : inputs) {
+                    input_shapes.push_back(input ? input->GetShape() : Shape());
+                }
+                for (size_t i = 0; i < inputs.size(); ++i) {
+                    Value* input = inputs[i];
+                    if (!input || input->GetProducer() || graph_inputs.count(input)) {
+                        continue;
+                    }
+                    auto tensor = input->GetTensor();
+                    if (!tensor || !tensor->GetData()) {
+                        continue;
+                    }
+                    bool is_packed = false;
+                    // 预打包失败不是致命错误：执行时按原始权重计算
+                    (void)kernels[k].second->op->PrePack(static_cast<int>(i), *tensor, input_shapes, &is_packed);
+                }
+            }
+        });
+    }
+    
+    CompiledKernel* FindKernel(Node* node) {
+        std::shared_lock<std::shared_mutex> lock(kernels_mutex_);
+        auto it = kernels_.find(node);
+        // 节点被删除后地址可能被新节点复用，用节点ID校验
+        if (it != kernels_.end() && it->second->node_id == node->GetId()) {
+            return it->second.get();
+        }
+        return nullptr;
+    }
+    
+    Status BuildKernel(Node* node, CompiledKernel** out) {
+        auto kernel = std::make_unique<CompiledKernel>();
+        kernel->node_id = node->GetId();
+        kernel->op = OperatorRegistry::Instance().Create(node->GetOpTypeId());
+        if (!kernel->op) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND,
+                               "Operator not found: " + node->GetOpType());
+        }
+    
+        // 将Node的属性复制到Operator（参考ONNX Runtime的实现），只在编译时解析一次
+        ApplyNodeAttributes(*node, kernel->op.get());
+        static const OpType kEmbedding("Embedding");
+        static const OpType kGather("Gather");
+        if (embedding_cache_rows_ > 0 && (node->GetOpTypeId() == kEmbedding.id || node->GetOpTypeId() == kGather.id)) {
+            kernel->op->SetAttribute("hot_row_cache_rows", AttributeValue(embedding_cache_rows_));
+        }
+        std::vector<Shape> input_shapes;
+        input_shapes.reserve(node->GetInputs().size());
+        for (const Value* input : node->GetInputs()) {
+            input_shapes.push_back(input ? input->GetShape() : Shape());
+        }
+        kernel->op->SpecializeForShapes(input_shapes);
+        // 暂存区需求按元数据估计；没有生产者且带张量的输入按常量计（决定是否预打包）
+        std::vector<TensorInfo> infos;
+        infos.reserve(node->GetInputs().size());
+        for (const Value* input : node->GetInputs()) {
+            infos.push_back(input ? TensorInfo{input->GetShape(), input->GetDataType(),
+                                               input->GetProducer() ? nullptr : input->GetTensor().get()}
+                                  : TensorInfo());
+        }
+        kernel->scratch_bytes = kernel->op->EstimateMemory(infos).scratch_bytes;
+    
+        kernel->inputs.reserve(node->GetInputs().size());
+        kernel->outputs.reserve(node->GetOutputs().size());
+    
+        std::unique_lock<std::shared_mutex> lock(kernels_mutex_);
+        auto& slot = kernels_[node];
+        // 并发运行时其他线程可能已经编译了同一节点，保留已有内核，避免释放正在使用的算子
+        if (slot && slot->node_id == node->GetId()) {
+            *out = slot.get();
+            return Status::Ok();
+        }
+        slot = std::move(kernel);
+        *out = slot.get();
+        return Status::Ok();
+    }
+    
     std::shared_ptr<Device> device_;
+    
+    // 来自SessionOptions（见ConfigureSession）
+    bool autotune_ = false;
+    int max_threads_ = 0;
+    int64_t min_work_per_thread_ = 16384;
+    int64_t embedding_cache_rows_ = 0;
+    
+    // 节点 -> 已编译内核（CompileNode/PrepareExecution填充，ExecuteNode按需补齐）
+    std::unordered_map<const Node*, std::unique_ptr<CompiledKernel>> kernels_;
+    std::shared_mutex kernels_mutex_;
 };
 
 // 注册CPU执行提供者 (参考ONNX Runtime的注册方式)
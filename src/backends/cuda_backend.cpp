@@ -4,19 +4,608 @@
 #ifdef ENABLE_CUDA
 
 #include "inferunity/cuda_backend.h"
+#include "inferunity/engine.h"
 #include "inferunity/operator.h"
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
 #include "inferunity/logger.h"
+#include "inferunity/memory.h"
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/collectives.h"
 #include <cuda_runtime.h>
 #include <cublas_v2.h>
 #include <cudnn.h>
+#ifdef INFERUNITY_USE_NCCL
+#include <nccl.h>
+#endif
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+// 前向声明形状推断函数
 namespace inferunity {
+    Status InferShapes(Graph* graph);
+}
+
+namespace inferunity {
+
+namespace {
+
+// cudaMalloc/cudaFree与流事件，供缓存分配器使用
+class CUDAMemoryBackend : public DeviceMemoryBackend {
+public:
+    explicit CUDAMemoryBackend(int device_id) : device_id_(device_id) {}
+    
+    void* RawAllocate(size_t size) override {
+        cudaSetDevice(device_id_);
+        void* ptr = nullptr;
+        if (cudaMalloc(&ptr, size) != cudaSuccess) {
+            cudaGetLastError();  // 清除错误状态，由分配器释放缓存后重试
+            return nullptr;
+        }
+        return ptr;
+    }
+    
+    void RawFree(void* ptr) override {
+        cudaSetDevice(device_id_);
+        cudaFree(ptr);
+    }
+    
+    void* RecordEvent(void* stream) override {
+        cudaEvent_t event;
+        if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess) {
+            return nullptr;
+        }
+        cudaEventRecord(event, static_cast<cudaStream_t>(stream));
+        return static_cast<void*>(event);
+    }
+    
+    bool QueryEvent(void* event) override {
+        return cudaEventQuery(static_cast<cudaEvent_t>(event)) != cudaErrorNotReady;
+    }
+    
+    void DestroyEvent(void* event) override {
+        cudaEventDestroy(static_cast<cudaEvent_t>(event));
+    }
+    
+    void SynchronizeDevice() override {
+        cudaSetDevice(device_id_);
+        cudaDeviceSynchronize();
+    }
+
+private:
+    int device_id_;
+};
+
+// 锁页主机内存：cudaHostAlloc/cudaFreeHost，事件沿用设备内存后端
+class CUDAPinnedMemoryBackend : public CUDAMemoryBackend {
+public:
+    CUDAPinnedMemoryBackend() : CUDAMemoryBackend(0) {}
+    
+    void* RawAllocate(size_t size) override {
+        void* ptr = nullptr;
+        if (cudaHostAlloc(&ptr, size, cudaHostAllocPortable) != cudaSuccess) {
+            cudaGetLastError();
+            return nullptr;
+        }
+        return ptr;
+    }
+    
+    void RawFree(void* ptr) override {
+        cudaFreeHost(ptr);
+    }
+};
+
+class CUDATransferEvent : public TransferEvent {
+public:
+    explicit CUDATransferEvent(cudaEvent_t event) : event_(event) {}
+    ~CUDATransferEvent() override { cudaEventDestroy(event_); }
+    
+    bool IsComplete() override { return cudaEventQuery(event_) != cudaErrorNotReady; }
+    
+    Status Wait() override {
+        if (cudaEventSynchronize(event_) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaEventSynchronize failed");
+        }
+        return Status::Ok();
+    }
+    
+    Status WaitOnStream(void* stream) override {
+        if (cudaStreamWaitEvent(static_cast<cudaStream_t>(stream), event_, 0) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamWaitEvent failed");
+        }
+        return Status::Ok();
+    }
+
+private:
+    cudaEvent_t event_;
+};
+
+// 下载到可分页内存时，拷贝流在暂存缓冲就绪后回调主机把数据搬到目标
+struct StagedCopy {
+    void* dst;
+    const void* staging;
+    size_t size;
+};
+
+void CUDART_CB CopyStagedToHost(void* data) {
+    auto* copy = static_cast<StagedCopy*>(data);
+    std::memcpy(copy->dst, copy->staging, copy->size);
+    delete copy;
+}
+
+bool IsPinnedHostMemory(const void* ptr) {
+    cudaPointerAttributes attributes;
+    if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+        cudaGetLastError();
+        return false;
+    }
+    return attributes.type == cudaMemoryTypeHost;
+}
+
+// 每个设备一个的流池：多流运行与并发会话从中取用互不共享的流
+class CUDAStreamPool {
+public:
+    explicit CUDAStreamPool(int device_id) : device_id_(device_id) {}
+    
+    ~CUDAStreamPool() {
+        for (cudaStream_t stream : idle_) {
+            cudaStreamDestroy(stream);
+        }
+    }
+    
+    cudaStream_t Acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                cudaStream_t stream = idle_.back();
+                idle_.pop_back();
+                return stream;
+            }
+        }
+        cudaSetDevice(device_id_);
+        cudaStream_t stream = nullptr;
+        if (cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) != cudaSuccess) {
+            return nullptr;
+        }
+        return stream;
+    }
+    
+    void Release(cudaStream_t stream) {
+        if (!stream) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(stream);
+    }
+
+private:
+    int device_id_;
+    std::mutex mutex_;
+    std::vector<cudaStream_t> idle_;
+};
+
+CUDAStreamPool& GetCUDAStreamPool(int device_id) {
+    static std::mutex mutex;
+    static std::unordered_map<int, std::unique_ptr<CUDAStreamPool>> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[device_id];
+    if (!pool) {
+        pool = std::make_unique<CUDAStreamPool>(device_id);
+    }
+    return *pool;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<CachingDeviceAllocator> GetCUDACachingAllocator(int device_id) {
+    static std::mutex mutex;
+    static std::unordered_map<int, std::shared_ptr<CachingDeviceAllocator>> allocators;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& allocator = allocators[device_id];
+    if (!allocator) {
+        allocator = std::make_shared<CachingDeviceAllocator>(std::make_unique<CUDAMemoryBackend>(device_id));
+    }
+    return allocator;
+}
+
+std::shared_ptr<CachingDeviceAllocator> GetCUDAPinnedAllocator() {
+    static std::shared_ptr<CachingDeviceAllocator> allocator =
+        std::make_shared<CachingDeviceAllocator>(std::make_unique<CUDAPinnedMemoryBackend>());
+    return allocator;
+}
+
+namespace {
+
+// DeviceType::CUDA的张量分配器：在调用线程的当前设备上分配，按指针所在的设备释放。
+// 同一进程内的多个会话可以各用一块GPU（如张量并行的各rank），执行提供者在加载与执行前切换当前设备
+class CUDADeviceRoutingAllocator : public MemoryAllocator {
+public:
+    void* Allocate(size_t size) override {
+        return GetCUDACachingAllocator(CurrentDevice())->Allocate(size);
+    }
+    
+    void* AllocateAligned(size_t size, size_t alignment) override {
+        return GetCUDACachingAllocator(CurrentDevice())->AllocateAligned(size, alignment);
+    }
+    
+    void Free(void* ptr) override {
+        if (!ptr) {
+            return;
+        }
+        cudaPointerAttributes attributes;
+        int device = 0;
+        if (cudaPointerGetAttributes(&attributes, ptr) == cudaSuccess) {
+            device = attributes.device;
+        } else {
+            cudaGetLastError();
+        }
+        GetCUDACachingAllocator(device)->Free(ptr);
+    }
+    
+    bool GetStats(MemoryStats* stats) const override {
+        return GetCUDACachingAllocator(CurrentDevice())->GetStats(stats);
+    }
+
+private:
+    static int CurrentDevice() {
+        int device = 0;
+        cudaGetDevice(&device);
+        return device;
+    }
+};
+
+std::shared_ptr<MemoryAllocator> GetCUDADeviceRoutingAllocator() {
+    static std::shared_ptr<MemoryAllocator> allocator = std::make_shared<CUDADeviceRoutingAllocator>();
+    return allocator;
+}
+
+#ifdef INFERUNITY_USE_NCCL
+// NCCL通信组：进程内每个rank一个communicator（ncclCommInitAll），集合操作入队到算子的流上
+class NCCLCollectiveGroup : public CollectiveGroup {
+public:
+    static std::shared_ptr<CollectiveGroup> Create(const std::vector<int>& device_ids) {
+        auto group = std::shared_ptr<NCCLCollectiveGroup>(new NCCLCollectiveGroup(device_ids));
+        return group->InitCommunicators() ? group : nullptr;
+    }
+    
+    ~NCCLCollectiveGroup() override {
+        DestroyCommunicators();
+    }
+    
+    Status AllReduceSum(int rank, int64_t tag, const Tensor& input, Tensor* output, void* stream) override {
+        (void)tag;
+        ncclDataType_t type;
+        Status status = Prepare(rank, input, output, input.GetSizeInBytes(), &type);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return Check(ncclAllReduce(input.GetData(), output->GetData(), input.GetElementCount(), type, ncclSum,
+                                   comms_[rank], static_cast<cudaStream_t>(stream)), "ncclAllReduce");
+    }
+    
+    Status AllGather(int rank, int64_t tag, const Tensor& input, int64_t axis, Tensor* output,
+                     void* stream) override {
+        (void)tag;
+        const auto& dims = input.GetShape().dims;
+        if (axis < 0 || axis >= static_cast<int64_t>(dims.size())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllGather axis out of range");
+        }
+        const size_t world_size = static_cast<size_t>(GetWorldSize());
+        ncclDataType_t type;
+        Status status = Prepare(rank, input, output, input.GetSizeInBytes() * world_size, &type);
+        if (!status.IsOk()) {
+            return status;
+        }
+        cudaStream_t cuda_stream = static_cast<cudaStream_t>(stream);
+        size_t outer = 1;
+        for (int64_t i = 0; i < axis; ++i) {
+            outer *= static_cast<size_t>(dims[i]);
+        }
+        if (outer == 1) {
+            return Check(ncclAllGather(input.GetData(), output->GetData(), input.GetElementCount(), type,
+                                       comms_[rank], cuda_stream), "ncclAllGather");
+        }
+        // NCCL按rank顺序拼接整块，axis不是最外层时先收到暂存缓冲，再按块交错写入输出
+        const size_t bytes = input.GetSizeInBytes();
+        const size_t chunk = bytes / outer;
+        auto allocator = GetCUDACachingAllocator(GetDeviceIds()[rank]);
+        void* staging = allocator->Allocate(bytes * world_size);
+        if (!staging) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "AllGather staging buffer");
+        }
+        status = Check(ncclAllGather(input.GetData(), staging, input.GetElementCount(), type,
+                                     comms_[rank], cuda_stream), "ncclAllGather");
+        for (size_t r = 0; status.IsOk() && r < world_size; ++r) {
+            if (cudaMemcpy2DAsync(static_cast<uint8_t*>(output->GetData()) + r * chunk, chunk * world_size,
+                                  static_cast<const uint8_t*>(staging) + r * bytes, chunk, chunk, outer,
+                                  cudaMemcpyDeviceToDevice, cuda_stream) != cudaSuccess) {
+                status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpy2DAsync failed");
+            }
+        }
+        // 暂存缓冲在流上的拷贝完成之后才能交还分配器
+        cudaStreamSynchronize(cuda_stream);
+        allocator->Free(staging);
+        return status;
+    }
+    
+    Status Send(int rank, int peer, int64_t tag, const Tensor& input, void* stream) override {
+        (void)tag;
+        ncclDataType_t type;
+        Status status = Prepare(rank, input, &input, input.GetSizeInBytes(), &type);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (peer < 0 || peer >= GetWorldSize() || peer == rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Send peer out of range");
+        }
+        status = Check(ncclSend(input.GetData(), input.GetElementCount(), type, peer, comms_[rank],
+                                static_cast<cudaStream_t>(stream)), "ncclSend");
+        return status.IsOk() && !stream ? SynchronizeDefaultStream() : status;
+    }
+    
+    Status Recv(int rank, int peer, int64_t tag, Tensor* output, void* stream) override {
+        (void)tag;
+        ncclDataType_t type;
+        Status status = Prepare(rank, *output, output, output->GetSizeInBytes(), &type);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (peer < 0 || peer >= GetWorldSize() || peer == rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Recv peer out of range");
+        }
+        status = Check(ncclRecv(output->GetData(), output->GetElementCount(), type, peer, comms_[rank],
+                                static_cast<cudaStream_t>(stream)), "ncclRecv");
+        return status.IsOk() && !stream ? SynchronizeDefaultStream() : status;
+    }
+    
+    // 中止communicator使阻塞在集合操作中的rank返回，Reset时重新建立
+    void Abort() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        for (ncclComm_t comm : comms_) {
+            if (comm) {
+                ncclCommAbort(comm);
+            }
+        }
+        comms_.clear();
+    }
+    
+    void Reset() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (aborted_ && InitCommunicators()) {
+            aborted_ = false;
+        }
+    }
+
+private:
+    explicit NCCLCollectiveGroup(const std::vector<int>& device_ids) : CollectiveGroup(device_ids) {}
+    
+    bool InitCommunicators() {
+        std::vector<ncclComm_t> comms(GetDeviceIds().size(), nullptr);
+        if (ncclCommInitAll(comms.data(), static_cast<int>(comms.size()), GetDeviceIds().data()) != ncclSuccess) {
+            return false;
+        }
+        comms_ = std::move(comms);
+        return true;
+    }
+    
+    void DestroyCommunicators() {
+        for (ncclComm_t comm : comms_) {
+            if (comm) {
+                ncclCommDestroy(comm);
+            }
+        }
+        comms_.clear();
+    }
+    
+    Status Prepare(int rank, const Tensor& input, const Tensor* output, size_t output_bytes, ncclDataType_t* type) {
+        if (aborted_.load() || rank < 0 || rank >= static_cast<int>(comms_.size())) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "NCCL collective group aborted");
+        }
+        if (output->GetSizeInBytes() != output_bytes || output->GetDataType() != input.GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Collective output does not match input");
+        }
+        switch (input.GetDataType()) {
+            case DataType::FLOAT32: *type = ncclFloat32; break;
+            case DataType::FLOAT16: *type = ncclFloat16; break;
+            case DataType::BFLOAT16: *type = ncclBfloat16; break;
+            case DataType::INT32: *type = ncclInt32; break;
+            case DataType::INT64: *type = ncclInt64; break;
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "NCCL collective: unsupported data type");
+        }
+        cudaSetDevice(GetDeviceIds()[rank]);
+        return Status::Ok();
+    }
+    
+    static Status SynchronizeDefaultStream() {
+        if (cudaStreamSynchronize(nullptr) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "cudaStreamSynchronize failed");
+        }
+        return Status::Ok();
+    }
+    
+    static Status Check(ncclResult_t result, const char* what) {
+        if (result != ncclSuccess) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR,
+                               std::string(what) + " failed: " + ncclGetErrorString(result));
+        }
+        return Status::Ok();
+    }
+    
+    std::mutex mutex_;
+    std::atomic<bool> aborted_{false};
+    std::vector<ncclComm_t> comms_;
+};
+
+// CUDA上的通信组使用NCCL，初始化失败时CollectiveGroup::Create回退到主机实现
+static bool g_nccl_registered = []() {
+    SetCollectiveGroupFactory(DeviceType::CUDA, NCCLCollectiveGroup::Create);
+    return true;
+}();
+#endif // INFERUNITY_USE_NCCL
+
+} // anonymous namespace
+
+// CUDA数据传输实现
+CUDADataTransfer::CUDADataTransfer(int device_id)
+    : device_id_(device_id), pinned_(GetCUDAPinnedAllocator()) {
+    cudaSetDevice(device_id_);
+    cudaStreamCreateWithFlags(&upload_stream_, cudaStreamNonBlocking);
+    cudaStreamCreateWithFlags(&download_stream_, cudaStreamNonBlocking);
+}
+
+CUDADataTransfer::~CUDADataTransfer() {
+    if (upload_stream_) {
+        cudaStreamSynchronize(upload_stream_);
+        cudaStreamDestroy(upload_stream_);
+    }
+    if (download_stream_) {
+        cudaStreamSynchronize(download_stream_);
+        cudaStreamDestroy(download_stream_);
+    }
+}
+
+Status CUDADataTransfer::CopyHostToDevice(void* dst, const void* src, size_t size) {
+    std::shared_ptr<TransferEvent> event;
+    Status status = CopyHostToDeviceAsync(dst, src, size, nullptr, &event);
+    return status.IsOk() ? event->Wait() : status;
+}
+
+Status CUDADataTransfer::CopyDeviceToHost(void* dst, const void* src, size_t size) {
+    std::shared_ptr<TransferEvent> event;
+    Status status = CopyDeviceToHostAsync(dst, src, size, nullptr, &event);
+    return status.IsOk() ? event->Wait() : status;
+}
+
+Status CUDADataTransfer::CopyDeviceToDevice(void* dst, const void* src, size_t size) {
+    cudaSetDevice(device_id_);
+    if (cudaMemcpyAsync(dst, src, size, cudaMemcpyDeviceToDevice, upload_stream_) != cudaSuccess ||
+        cudaStreamSynchronize(upload_stream_) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpyAsync failed");
+    }
+    return Status::Ok();
+}
+
+Status CUDADataTransfer::CopyHostToDeviceAsync(void* dst, const void* src, size_t size, void* stream,
+                                               std::shared_ptr<TransferEvent>* event) {
+    cudaSetDevice(device_id_);
+    Status status = WaitForStream(upload_stream_, stream);
+    if (!status.IsOk()) {
+        return status;
+    }
+    // 可分页内存先拷进锁页暂存缓冲，调用返回后src即可复用
+    const void* from = src;
+    void* staging = nullptr;
+    if (!IsPinnedHostMemory(src)) {
+        staging = pinned_->AllocateOnStream(size, nullptr);
+        if (!staging) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate pinned staging buffer");
+        }
+        std::memcpy(staging, src, size);
+        from = staging;
+    }
+    const cudaError_t error = cudaMemcpyAsync(dst, from, size, cudaMemcpyHostToDevice, upload_stream_);
+    if (staging) {
+        // 暂存块在上传完成之后才会被再次分配
+        pinned_->RecordStream(staging, upload_stream_);
+        pinned_->Free(staging);
+    }
+    if (error != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpyAsync failed");
+    }
+    return RecordTransferEvent(upload_stream_, event);
+}
+
+Status CUDADataTransfer::CopyDeviceToHostAsync(void* dst, const void* src, size_t size, void* stream,
+                                               std::shared_ptr<TransferEvent>* event) {
+    cudaSetDevice(device_id_);
+    Status status = WaitForStream(download_stream_, stream);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (IsPinnedHostMemory(dst)) {
+        if (cudaMemcpyAsync(dst, src, size, cudaMemcpyDeviceToHost, download_stream_) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpyAsync failed");
+        }
+        return RecordTransferEvent(download_stream_, event);
+    }
+    void* staging = pinned_->AllocateOnStream(size, nullptr);
+    if (!staging) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate pinned staging buffer");
+    }
+    cudaError_t error = cudaMemcpyAsync(staging, src, size, cudaMemcpyDeviceToHost, download_stream_);
+    if (error == cudaSuccess) {
+        auto* copy = new StagedCopy{dst, staging, size};
+        error = cudaLaunchHostFunc(download_stream_, CopyStagedToHost, copy);
+        if (error != cudaSuccess) {
+            delete copy;
+        }
+    }
+    // 事件在主机回调之后记录，暂存块在数据搬到dst之后才会被再次分配
+    pinned_->RecordStream(staging, download_stream_);
+    pinned_->Free(staging);
+    if (error != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpyAsync failed");
+    }
+    return RecordTransferEvent(download_stream_, event);
+}
+
+Status CUDADataTransfer::WaitForStream(cudaStream_t copy_stream, void* stream) {
+    if (!stream) {
+        return Status::Ok();
+    }
+    cudaEvent_t ready;
+    if (cudaEventCreateWithFlags(&ready, cudaEventDisableTiming) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaEventCreate failed");
+    }
+    cudaError_t error = cudaEventRecord(ready, static_cast<cudaStream_t>(stream));
+    if (error == cudaSuccess) {
+        error = cudaStreamWaitEvent(copy_stream, ready, 0);
+    }
+    cudaEventDestroy(ready);
+    if (error != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamWaitEvent failed");
+    }
+    return Status::Ok();
+}
+
+Status CUDADataTransfer::RecordTransferEvent(cudaStream_t copy_stream, std::shared_ptr<TransferEvent>* event) {
+    cudaEvent_t done;
+    if (cudaEventCreateWithFlags(&done, cudaEventDisableTiming) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaEventCreate failed");
+    }
+    if (cudaEventRecord(done, copy_stream) != cudaSuccess) {
+        cudaEventDestroy(done);
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaEventRecord failed");
+    }
+    auto result = std::make_shared<CUDATransferEvent>(done);
+    if (event) {
+        *event = std::move(result);
+    } else {
+        return result->Wait();
+    }
+    return Status::Ok();
+}
+
+std::shared_ptr<CUDADataTransfer> GetCUDADataTransfer(int device_id) {
+    static std::mutex mutex;
+    static std::unordered_map<int, std::shared_ptr<CUDADataTransfer>> transfers;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& transfer = transfers[device_id];
+    if (!transfer) {
+        transfer = std::make_shared<CUDADataTransfer>(device_id);
+    }
+    return transfer;
+}
 
 // CUDA设备实现
-CUDADevice::CUDADevice(int device_id) : device_id_(device_id) {
+CUDADevice::CUDADevice(int device_id)
+    : device_id_(device_id), allocator_(GetCUDACachingAllocator(device_id)) {
     cudaSetDevice(device_id_);
     cudaStreamCreate(&default_stream_);
 }
@@ -34,37 +623,55 @@ std::string CUDADevice::GetName() const {
 }
 
 void* CUDADevice::Allocate(size_t size) {
-    void* ptr = nullptr;
-    cudaMalloc(&ptr, size);
-    return ptr;
+    return allocator_->Allocate(size);
 }
 
 void CUDADevice::Free(void* ptr) {
-    if (ptr) {
-        cudaFree(ptr);
-    }
+    allocator_->Free(ptr);
 }
 
 void* CUDADevice::AllocateAligned(size_t size, size_t alignment) {
-    void* ptr = nullptr;
-    cudaMalloc(&ptr, size);
-    // CUDA内存分配通常已经对齐，这里简化处理
-    return ptr;
+    return allocator_->AllocateAligned(size, alignment);
+}
+
+// 拷贝在流上异步入队，使其可以被CUDA Graph捕获；未捕获时等待完成，保持同步语义
+Status CUDADevice::CopyOnStream(void* dst, const void* src, size_t size, cudaMemcpyKind kind,
+                                cudaStream_t stream) {
+    if (!stream) {
+        stream = default_stream_;
+    }
+    if (cudaMemcpyAsync(dst, src, size, kind, stream) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaMemcpyAsync failed");
+    }
+    return SynchronizeUnlessCapturing(stream);
 }
 
 Status CUDADevice::Copy(void* dst, const void* src, size_t size) {
     // 设备间拷贝
-    cudaMemcpy(dst, src, size, cudaMemcpyDeviceToDevice);
-    return Status::Ok();
+    return CopyOnStream(dst, src, size, cudaMemcpyDeviceToDevice, default_stream_);
 }
 
 Status CUDADevice::CopyFromHost(void* dst, const void* src, size_t size) {
-    cudaMemcpy(dst, src, size, cudaMemcpyHostToDevice);
-    return Status::Ok();
+    return CopyOnStream(dst, src, size, cudaMemcpyHostToDevice, default_stream_);
 }
 
 Status CUDADevice::CopyToHost(void* dst, const void* src, size_t size) {
-    cudaMemcpy(dst, src, size, cudaMemcpyDeviceToHost);
+    return CopyOnStream(dst, src, size, cudaMemcpyDeviceToHost, default_stream_);
+}
+
+bool CUDADevice::IsCapturing(cudaStream_t stream) const {
+    cudaStreamCaptureStatus capture = cudaStreamCaptureStatusNone;
+    cudaStreamIsCapturing(stream ? stream : default_stream_, &capture);
+    return capture != cudaStreamCaptureStatusNone;
+}
+
+Status CUDADevice::SynchronizeUnlessCapturing(cudaStream_t stream) {
+    if (IsCapturing(stream)) {
+        return Status::Ok();
+    }
+    if (cudaStreamSynchronize(stream) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamSynchronize failed");
+    }
     return Status::Ok();
 }
 
@@ -92,15 +699,97 @@ Status CUDADevice::SynchronizeStream(void* stream) {
     return Status::Ok();
 }
 
+void* CUDADevice::AcquireStream() {
+    return static_cast<void*>(GetCUDAStreamPool(device_id_).Acquire());
+}
+
+void CUDADevice::ReleaseStream(void* stream) {
+    GetCUDAStreamPool(device_id_).Release(static_cast<cudaStream_t>(stream));
+}
+
+void* CUDADevice::CreateEvent() {
+    cudaEvent_t event = nullptr;
+    if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess) {
+        return nullptr;
+    }
+    return static_cast<void*>(event);
+}
+
+void CUDADevice::DestroyEvent(void* event) {
+    if (event) {
+        cudaEventDestroy(static_cast<cudaEvent_t>(event));
+    }
+}
+
+Status CUDADevice::RecordEvent(void* event, void* stream) {
+    if (!event || cudaEventRecord(static_cast<cudaEvent_t>(event),
+                                  static_cast<cudaStream_t>(stream)) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaEventRecord failed");
+    }
+    return Status::Ok();
+}
+
+Status CUDADevice::StreamWaitEvent(void* stream, void* event) {
+    if (!event || cudaStreamWaitEvent(static_cast<cudaStream_t>(stream),
+                                      static_cast<cudaEvent_t>(event), 0) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamWaitEvent failed");
+    }
+    return Status::Ok();
+}
+
 // CUDA执行提供者实现
 CUDAExecutionProvider::CUDAExecutionProvider(int device_id) 
     : device_id_(device_id), device_(nullptr) {
     if (IsAvailable()) {
         device_ = std::make_shared<CUDADevice>(device_id_);
+        // 放在CUDA上的张量从当前设备的缓存分配器取内存
+        SetMemoryAllocator(DeviceType::CUDA, GetCUDADeviceRoutingAllocator());
+        // 张量的主机与设备间拷贝经由设备共享的拷贝流
+        SetDataTransfer(DeviceType::CUDA, GetCUDADataTransfer(device_id_));
+        cublasLtCreate(&cublaslt_);
+        cudnnCreate(&cudnn_);
+    }
+}
+
+CUDAExecutionProvider::~CUDAExecutionProvider() {
+    ResetGraph();
+    kernels_.clear();
+    if (cudnn_) {
+        cudnnDestroy(cudnn_);
+    }
+    if (cublaslt_) {
+        cublasLtDestroy(cublaslt_);
     }
 }
 
-CUDAExecutionProvider::~CUDAExecutionProvider() = default;
+Status CUDAExecutionProvider::ConfigureSession(const SessionOptions& options) {
+    codegen_cache_dir_ = options.cuda_codegen_cache_dir.empty() ? options.optimized_model_cache_dir
+                                                                : options.cuda_codegen_cache_dir;
+    if (!device_ || options.device_id == device_id_) {
+        return Status::Ok();
+    }
+    int device_count = 0;
+    cudaGetDeviceCount(&device_count);
+    if (options.device_id < 0 || options.device_id >= device_count) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "CUDA device_id out of range: " + std::to_string(options.device_id));
+    }
+    // cuBLASLt/cuDNN句柄绑定在创建时的当前设备上，随设备一起重建
+    if (cudnn_) {
+        cudnnDestroy(cudnn_);
+        cudnn_ = nullptr;
+    }
+    if (cublaslt_) {
+        cublasLtDestroy(cublaslt_);
+        cublaslt_ = nullptr;
+    }
+    device_id_ = options.device_id;
+    device_ = std::make_shared<CUDADevice>(device_id_);
+    SetDataTransfer(DeviceType::CUDA, GetCUDADataTransfer(device_id_));
+    cublasLtCreate(&cublaslt_);
+    cudnnCreate(&cudnn_);
+    return Status::Ok();
+}
 
 bool CUDAExecutionProvider::IsAvailable() const {
     return CheckCUDAAvailable();
@@ -136,7 +825,9 @@ bool CUDAExecutionProvider::SupportsOperator(const std::string& op_type) const {
         // 形状操作
         "Reshape", "Concat", "Split", "Transpose", "Gather", "Slice",
         // 融合算子
-        "FusedConvBNReLU", "FusedMatMulAdd", "FusedConvReLU", "FusedBNReLU"
+        "FusedConvBNReLU", "FusedMatMulAdd", "FusedConvReLU", "FusedBNReLU", "FusedElementwise",
+        // 图分区插入的跨设备拷贝
+        "MemcpyToDevice", "MemcpyFromDevice"
     };
     
     return supported_operators.find(op_type) != supported_operators.end() ||
@@ -181,14 +872,45 @@ Status CUDAExecutionProvider::CompileNode(Node* node) {
     }
     
     // 检查算子是否支持
-    if (!SupportsOperator(node->GetOpType())) {
+    if (!SupportsOperatorId(node->GetOpTypeId())) {
         return Status::Error(StatusCode::ERROR_NOT_FOUND,
                            "Operator not supported by CUDA: " + node->GetOpType());
     }
     
-    // CUDA后端可以在这里进行JIT编译或kernel选择
-    // 目前简化实现
-    
+    // GEMM与卷积在编译时按静态形状选定cuBLASLt/cuDNN算法（命中调优缓存时不再实测），
+    // 融合的逐元素链在编译时生成并编译kernel（命中PTX缓存时不再编译）
+    std::vector<Shape> input_shapes;
+    for (const Value* input : node->GetInputs()) {
+        input_shapes.push_back(input->GetShape());
+    }
+    return BuildKernel(node, input_shapes);
+}
+
+CUDAKernelContext CUDAExecutionProvider::GetKernelContext() const {
+    CUDAKernelContext context;
+    context.device_name = device_ ? device_->GetName() : "";
+    context.cublaslt = cublaslt_;
+    context.cudnn = cudnn_;
+    context.allocator = device_ ? device_->GetAllocator().get() : nullptr;
+    context.tuning_cache = &GetKernelTuningCache();
+    context.codegen_cache_dir = codegen_cache_dir_;
+    return context;
+}
+
+Status CUDAExecutionProvider::BuildKernel(const Node* node, const std::vector<Shape>& input_shapes) {
+    kernels_.erase(node);
+    if (!device_ || !cublaslt_ || !cudnn_ || node->GetInputs().empty()) {
+        return Status::Ok();
+    }
+    std::unique_ptr<CUDAKernel> kernel;
+    Status status = CreateCUDAKernel(node, input_shapes, node->GetInputs()[0]->GetDataType(),
+                                     GetKernelContext(), &kernel);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (kernel) {
+        kernels_[node] = std::move(kernel);
+    }
     return Status::Ok();
 }
 
@@ -196,6 +918,9 @@ Status CUDAExecutionProvider::PrepareExecution(Graph* graph) {
     if (!graph) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
     }
+    if (device_) {
+        cudaSetDevice(device_id_);
+    }
     
     // 为所有输出Value预分配CUDA Tensor
     for (Value* output : graph->GetOutputs()) {
@@ -234,6 +959,14 @@ Status CUDAExecutionProvider::ExecuteNode(Node* node, ExecutionContext* ctx) {
     // 3. 管理CUDA流和内存
     // 这里应该调用CUDA特定的算子实现
     
+    // 会话可能在别的GPU上（见ConfigureSession），输出张量在当前设备上分配
+    if (device_) {
+        cudaSetDevice(device_id_);
+    }
+    if (node->GetOpType() == "MemcpyToDevice" || node->GetOpType() == "MemcpyFromDevice") {
+        return ExecuteMemcpy(node, ctx);
+    }
+    
     auto op = CreateOperator(node->GetOpType());
     if (!op) {
         return Status::Error(StatusCode::ERROR_NOT_FOUND,
@@ -266,10 +999,121 @@ Status CUDAExecutionProvider::ExecuteNode(Node* node, ExecutionContext* ctx) {
         }
     }
     
-    // 执行算子
+    // 编译时选定的cuBLASLt/cuDNN kernel；输入形状与编译时不同则按实际形状重新选择
+    auto kernel = kernels_.find(node);
+    if (kernel != kernels_.end() && !kernel->second->Matches(inputs)) {
+        std::vector<Shape> input_shapes;
+        for (Tensor* input : inputs) {
+            input_shapes.push_back(input->GetShape());
+        }
+        Status status = BuildKernel(node, input_shapes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        kernel = kernels_.find(node);
+    }
+    if (kernel != kernels_.end()) {
+        cudaStream_t stream = ctx && ctx->GetStream() ? static_cast<cudaStream_t>(ctx->GetStream())
+                                                      : device_->GetStream();
+        return kernel->second->Compute(inputs, outputs, stream);
+    }
+    
+    // 执行算子：kernel入队到ctx->GetStream()给出的流，nullptr为默认流
     return op->Execute(inputs, outputs, ctx);
 }
 
+DeviceType CUDAExecutionProvider::GetOutputDeviceType(const Node* node, size_t output_index) const {
+    (void)output_index;
+    return node->GetOpType() == "MemcpyFromDevice" ? DeviceType::CPU : DeviceType::CUDA;
+}
+
+Status CUDAExecutionProvider::ExecuteMemcpy(Node* node, ExecutionContext* ctx) {
+    if (node->GetInputs().size() != 1 || node->GetOutputs().size() != 1 ||
+        !node->GetInputs()[0]->GetTensor()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           node->GetOpType() + " requires 1 input and 1 output");
+    }
+    const bool to_device = node->GetOpType() == "MemcpyToDevice";
+    const DeviceType target = to_device ? DeviceType::CUDA : DeviceType::CPU;
+    auto src = node->GetInputs()[0]->GetTensor();
+    Value* output = node->GetOutputs()[0];
+    auto dst = output->GetTensor();
+    if (!dst || dst->GetDeviceType() != target || dst->GetDataType() != src->GetDataType() ||
+        dst->GetShape().dims != src->GetShape().dims) {
+        dst = CreateTensor(src->GetShape(), src->GetDataType(), target);
+        output->SetTensor(dst);
+    }
+    const size_t bytes = src->GetSizeInBytes();
+    cudaStream_t stream = ctx && ctx->GetStream() ? static_cast<cudaStream_t>(ctx->GetStream())
+                                                  : device_->GetStream();
+    // 捕获期间拷贝必须留在捕获流上，主机侧的暂存拷贝也不会被重放
+    if (device_->IsCapturing(stream)) {
+        return device_->CopyOnStream(dst->GetData(), src->GetData(), bytes,
+                                     to_device ? cudaMemcpyHostToDevice : cudaMemcpyDeviceToHost, stream);
+    }
+    // 拷贝在设备共享的拷贝流上进行，排在计算流已入队的工作之后（目标块可能刚被计算流释放）；
+    // 上传后计算流只在设备侧等待，主机不阻塞；下载的消费者在主机上，需要等它完成
+    auto transfer = GetCUDADataTransfer(device_id_);
+    std::shared_ptr<TransferEvent> event;
+    Status status = to_device
+        ? transfer->CopyHostToDeviceAsync(dst->GetData(), src->GetData(), bytes, stream, &event)
+        : transfer->CopyDeviceToHostAsync(dst->GetData(), src->GetData(), bytes, stream, &event);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return to_device ? event->WaitOnStream(stream) : event->Wait();
+}
+
+Status CUDAExecutionProvider::CaptureBegin() {
+    if (!device_) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "CUDA device is not available");
+    }
+    ResetGraph();
+    // 全局捕获模式：捕获期间的不安全CUDA调用（如cudaMalloc）直接报错，而不是被悄悄排除在图外
+    if (cudaStreamBeginCapture(device_->GetStream(), cudaStreamCaptureModeGlobal) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamBeginCapture failed");
+    }
+    return Status::Ok();
+}
+
+Status CUDAExecutionProvider::CaptureEnd() {
+    if (!device_) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "CUDA device is not available");
+    }
+    if (cudaStreamEndCapture(device_->GetStream(), &graph_) != cudaSuccess || !graph_) {
+        graph_ = nullptr;
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaStreamEndCapture failed");
+    }
+    if (cudaGraphInstantiate(&graph_exec_, graph_, nullptr, nullptr, 0) != cudaSuccess) {
+        graph_exec_ = nullptr;
+        ResetGraph();
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaGraphInstantiate failed");
+    }
+    return Status::Ok();
+}
+
+Status CUDAExecutionProvider::ReplayGraph() {
+    if (!graph_exec_) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "No CUDA graph captured");
+    }
+    if (cudaGraphLaunch(graph_exec_, device_->GetStream()) != cudaSuccess) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudaGraphLaunch failed");
+    }
+    // 图中的MemcpyFromDevice把输出写回主机，返回前等待完成
+    return device_->SynchronizeStream(device_->GetStream());
+}
+
+void CUDAExecutionProvider::ResetGraph() {
+    if (graph_exec_) {
+        cudaGraphExecDestroy(graph_exec_);
+        graph_exec_ = nullptr;
+    }
+    if (graph_) {
+        cudaGraphDestroy(graph_);
+        graph_ = nullptr;
+    }
+}
+
 } // namespace inferunity
 
 #endif // ENABLE_CUDA
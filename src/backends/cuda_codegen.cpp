@@ -0,0 +1,390 @@
+// CUDA上的逐元素融合代码生成
+// 参考TVM/XLA的injective融合与PyTorch NVFuser的运行时编译：融合Pass合并出的FusedElementwise链
+// （步骤与广播约定见fused_ops.cpp）在编译节点时按静态形状生成一个kernel，每个线程从各输入读一次、
+// 整条链在寄存器中完成、输出写一次。NVRTC把生成的代码编译为PTX，PTX以代码与GPU架构的哈希为键
+// 缓存在进程内与磁盘上，之后的节点与会话直接加载模块，不再编译
+
+#ifdef ENABLE_CUDA
+
+#include "inferunity/cuda_backend.h"
+#include "inferunity/graph.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "inferunity/logger.h"
+#include "core/hash_utils.h"
+
+#ifdef INFERUNITY_USE_NVRTC
+#include <cuda.h>
+#include <nvrtc.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#endif
+
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+#ifdef INFERUNITY_USE_NVRTC
+
+namespace {
+
+constexpr int kBlockThreads = 256;
+constexpr int kMaxBlocksPerSM = 8;
+constexpr const char* kKernelName = "fused_elementwise";
+
+// 步骤对应的表达式：v为链的当前值，b为二元步骤的操作数
+const std::unordered_map<std::string, std::string>& BinaryExpressions() {
+    static const std::unordered_map<std::string, std::string> expressions = {
+        {"Add", "v + b"}, {"Sub", "v - b"}, {"RSub", "b - v"},
+        {"Mul", "v * b"}, {"Div", "v / b"}, {"RDiv", "b / v"},
+        {"Max", "fmaxf(v, b)"}, {"Min", "fminf(v, b)"}, {"Pow", "powf(v, b)"}
+    };
+    return expressions;
+}
+
+const std::unordered_map<std::string, std::string>& UnaryExpressions() {
+    static const std::unordered_map<std::string, std::string> expressions = {
+        {"Relu", "fmaxf(v, 0.0f)"},
+        {"Sigmoid", "1.0f / (1.0f + expf(-v))"},
+        {"Tanh", "tanhf(v)"},
+        {"Gelu", "0.5f * v * (1.0f + erff(v * 0.70710678118654752f))"},
+        {"GeluTanh", "0.5f * v * (1.0f + tanhf(0.79788456080286536f * (v + 0.044715f * v * v * v)))"},
+        {"Silu", "v / (1.0f + expf(-v))"},
+        {"Exp", "expf(v)"},
+        {"Log", "logf(v)"},
+        {"Sqrt", "sqrtf(v)"}
+    };
+    return expressions;
+}
+
+// 与FusedElementwise的CPU实现相同的广播约定：输出第i个元素读操作数的第(i / repeat) % size个元素，
+// 操作数的非1维（右对齐）必须是输出中连续的一段
+bool ResolveOperand(const Shape& shape, const Shape& output, int64_t* size, int64_t* repeat) {
+    *size = shape.GetElementCount();
+    *repeat = 1;
+    const int64_t total = output.GetElementCount();
+    if (*size == total || *size == 1) {
+        return *size == 1 || shape.dims.size() <= output.dims.size();
+    }
+    if (shape.dims.size() > output.dims.size()) {
+        return false;
+    }
+    const size_t offset = output.dims.size() - shape.dims.size();
+    int64_t last = -1;
+    for (size_t d = 0; d < shape.dims.size(); ++d) {
+        if (shape.dims[d] == 1) continue;
+        if (shape.dims[d] != output.dims[d + offset] || (last >= 0 && last + 1 != static_cast<int64_t>(d))) {
+            return false;
+        }
+        last = static_cast<int64_t>(d);
+    }
+    for (size_t d = static_cast<size_t>(last) + 1 + offset; d < output.dims.size(); ++d) {
+        *repeat *= output.dims[d];
+    }
+    return true;
+}
+
+// 生成整条链的kernel源码；各输入的下标表达式按静态形状写定，元素数n作为参数
+Status GenerateSource(const std::string& ops, const std::vector<Shape>& shapes, std::string* source) {
+    const Shape& output = shapes[0];
+    const int64_t total = output.GetElementCount();
+    std::ostringstream params;
+    std::ostringstream loads;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        int64_t size = 1;
+        int64_t repeat = 1;
+        if (!ResolveOperand(shapes[i], output, &size, &repeat)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "FusedElementwise operand is not broadcastable");
+        }
+        params << ", const float* __restrict__ in" << i;
+        loads << "        const float x" << i << " = ";
+        if (size == total && total != 1) {
+            loads << "in" << i << "[i];\n";
+        } else if (size == 1) {
+            loads << "in" << i << "[0];\n";
+        } else if (repeat == 1) {
+            loads << "in" << i << "[i % " << size << "LL];\n";
+        } else {
+            loads << "in" << i << "[(i / " << repeat << "LL) % " << size << "LL];\n";
+        }
+    }
+
+    std::ostringstream body;
+    size_t next_input = 1;
+    std::stringstream ss(ops);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        const size_t at = token.find('@');
+        const std::string op = token.substr(0, at);
+        auto binary = BinaryExpressions().find(op);
+        if (binary != BinaryExpressions().end()) {
+            size_t input = next_input;
+            if (at == std::string::npos) {
+                ++next_input;
+            } else {
+                const int index = std::atoi(token.c_str() + at + 1);
+                if (index < 0 || static_cast<size_t>(index) >= shapes.size()) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                         "FusedElementwise operand out of range: " + token);
+                }
+                input = static_cast<size_t>(index);
+            }
+            if (input >= shapes.size()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                     "FusedElementwise ops do not match the number of inputs");
+            }
+            body << "        { const float b = x" << input << "; v = " << binary->second << "; }\n";
+            continue;
+        }
+        auto unary = UnaryExpressions().find(op);
+        if (unary == UnaryExpressions().end() || at != std::string::npos) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "FusedElementwise step not supported: " + token);
+        }
+        body << "        v = " << unary->second << ";\n";
+    }
+    if (next_input != shapes.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "FusedElementwise ops do not match the number of inputs");
+    }
+
+    std::ostringstream code;
+    code << "extern \"C\" __global__ void " << kKernelName << "(float* __restrict__ y" << params.str()
+         << ", long long n) {\n"
+         << "    for (long long i = blockIdx.x * (long long)blockDim.x + threadIdx.x; i < n;\n"
+         << "         i += (long long)gridDim.x * blockDim.x) {\n"
+         << loads.str()
+         << "        float v = x0;\n"
+         << body.str()
+         << "        y[i] = v;\n"
+         << "    }\n"
+         << "}\n";
+    *source = code.str();
+    return Status::Ok();
+}
+
+Status CompilePtx(const std::string& source, const std::string& arch, std::string* ptx) {
+    nvrtcProgram program = nullptr;
+    if (nvrtcCreateProgram(&program, source.c_str(), "fused_elementwise.cu", 0, nullptr, nullptr) != NVRTC_SUCCESS) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "nvrtcCreateProgram failed");
+    }
+    const std::string arch_option = "--gpu-architecture=" + arch;
+    const char* options[] = {arch_option.c_str(), "--std=c++14"};
+    const nvrtcResult result = nvrtcCompileProgram(program, 2, options);
+    if (result != NVRTC_SUCCESS) {
+        size_t log_size = 0;
+        nvrtcGetProgramLogSize(program, &log_size);
+        std::string log(log_size, '\0');
+        if (log_size > 0) {
+            nvrtcGetProgramLog(program, &log[0]);
+        }
+        nvrtcDestroyProgram(&program);
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                             std::string("NVRTC compilation failed: ") + nvrtcGetErrorString(result) + "\n" + log);
+    }
+    size_t ptx_size = 0;
+    nvrtcGetPTXSize(program, &ptx_size);
+    ptx->assign(ptx_size, '\0');
+    nvrtcGetPTX(program, &(*ptx)[0]);
+    nvrtcDestroyProgram(&program);
+    return Status::Ok();
+}
+
+// 进程内的PTX缓存：同一段代码在同一架构上只编译一次，多个节点与会话共用
+struct PtxCache {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const std::string>> entries;
+};
+
+PtxCache& GetPtxCache() {
+    static PtxCache cache;
+    return cache;
+}
+
+// 依次查进程内缓存、磁盘缓存，都没有时编译并写回两者
+Status GetOrCompilePtx(const std::string& source, const std::string& arch, const std::string& cache_dir,
+                       std::shared_ptr<const std::string>* ptx) {
+    int nvrtc_major = 0;
+    int nvrtc_minor = 0;
+    nvrtcVersion(&nvrtc_major, &nvrtc_minor);
+    const std::string key = ";arch=" + arch + ";nvrtc=" + std::to_string(nvrtc_major) + "." +
+                            std::to_string(nvrtc_minor);
+    const uint64_t hash = HashBytes(HashBytes(kFnv1aOffsetBasis, source), key);
+
+    PtxCache& cache = GetPtxCache();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.entries.find(hash);
+        if (it != cache.entries.end()) {
+            *ptx = it->second;
+            return Status::Ok();
+        }
+    }
+
+    std::string cache_path;
+    if (!cache_dir.empty()) {
+        std::ostringstream path;
+        path << cache_dir << "/nvrtc_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".ptx";
+        cache_path = path.str();
+    }
+    auto compiled = std::make_shared<std::string>();
+    if (!cache_path.empty()) {
+        std::ifstream file(cache_path, std::ios::binary);
+        if (file) {
+            compiled->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    }
+    if (compiled->empty()) {
+        Status status = CompilePtx(source, arch, compiled.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+        // 先写临时文件再改名，并发启动的会话不会读到写了一半的PTX
+        if (!cache_path.empty()) {
+            const std::string temp_path = cache_path + ".tmp" + std::to_string(reinterpret_cast<uintptr_t>(compiled.get()));
+            std::ofstream file(temp_path, std::ios::binary);
+            file.write(compiled->data(), static_cast<std::streamsize>(compiled->size()));
+            file.close();
+            if (!file || std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+                std::remove(temp_path.c_str());
+                LOG_WARNING("Fused elementwise PTX not cached: " + cache_path);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto inserted = cache.entries.emplace(hash, std::move(compiled));
+    *ptx = inserted.first->second;
+    return Status::Ok();
+}
+
+class NvrtcFusedElementwiseKernel : public CUDAKernel {
+public:
+    ~NvrtcFusedElementwiseKernel() override {
+        if (module_) cuModuleUnload(module_);
+    }
+
+    Status Init(const Node* node, const std::vector<Shape>& shapes, DataType dtype,
+                const CUDAKernelContext& context) {
+        auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+        if (!op || dtype != DataType::FLOAT32 || shapes.empty() || shapes.size() != node->GetInputs().size()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported FusedElementwise");
+        }
+        ApplyNodeAttributes(*node, op.get());
+        std::string source;
+        Status status = GenerateSource(op->GetStringAttribute("ops", ""), shapes, &source);
+        if (!status.IsOk()) {
+            return status;
+        }
+
+        // 模块加载到运行时API在当前设备上的主上下文
+        int device = 0;
+        int major = 0;
+        int minor = 0;
+        int sm_count = 0;
+        cudaGetDevice(&device);
+        cudaFree(nullptr);
+        cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, device);
+        cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, device);
+        cudaDeviceGetAttribute(&sm_count, cudaDevAttrMultiProcessorCount, device);
+        const std::string arch = "compute_" + std::to_string(major) + std::to_string(minor);
+
+        std::shared_ptr<const std::string> ptx;
+        status = GetOrCompilePtx(source, arch, context.codegen_cache_dir, &ptx);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (cuModuleLoadData(&module_, ptx->c_str()) != CUDA_SUCCESS ||
+            cuModuleGetFunction(&function_, module_, kKernelName) != CUDA_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to load fused elementwise PTX");
+        }
+        shapes_ = shapes;
+        max_blocks_ = std::max(1, sm_count) * kMaxBlocksPerSM;
+        return Status::Ok();
+    }
+
+    bool Matches(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != shapes_.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < shapes_.size(); ++i) {
+            if (!inputs[i] || inputs[i]->GetShape().dims != shapes_[i].dims) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Status Compute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                   cudaStream_t stream) override {
+        if (outputs.empty() || !outputs[0]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid outputs");
+        }
+        long long n = static_cast<long long>(outputs[0]->GetElementCount());
+        if (n == 0) {
+            return Status::Ok();
+        }
+        void* y = outputs[0]->GetData();
+        std::vector<const void*> data(inputs.size());
+        std::vector<void*> args;
+        args.reserve(inputs.size() + 2);
+        args.push_back(&y);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            data[i] = inputs[i]->GetData();
+            args.push_back(&data[i]);
+        }
+        args.push_back(&n);
+        const long long blocks = std::min<long long>((n + kBlockThreads - 1) / kBlockThreads, max_blocks_);
+        const CUresult result = cuLaunchKernel(function_, static_cast<unsigned int>(blocks), 1, 1,
+                                               kBlockThreads, 1, 1, 0, reinterpret_cast<CUstream>(stream),
+                                               args.data(), nullptr);
+        if (result != CUDA_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Fused elementwise kernel launch failed");
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::vector<Shape> shapes_;
+    CUmodule module_ = nullptr;
+    CUfunction function_ = nullptr;
+    int max_blocks_ = kMaxBlocksPerSM;
+};
+
+} // anonymous namespace
+
+Status CreateCUDAFusedElementwiseKernel(const Node* node, const std::vector<Shape>& input_shapes, DataType dtype,
+                                        const CUDAKernelContext& context, std::unique_ptr<CUDAKernel>* kernel) {
+    kernel->reset();
+    auto created = std::make_unique<NvrtcFusedElementwiseKernel>();
+    Status status = created->Init(node, input_shapes, dtype, context);
+    if (status.Code() == StatusCode::ERROR_NOT_IMPLEMENTED) {
+        return Status::Ok();  // 步骤或广播不适用，走通用算子
+    }
+    if (status.IsOk()) {
+        *kernel = std::move(created);
+    }
+    return status;
+}
+
+#else
+
+Status CreateCUDAFusedElementwiseKernel(const Node*, const std::vector<Shape>&, DataType,
+                                        const CUDAKernelContext&, std::unique_ptr<CUDAKernel>* kernel) {
+    kernel->reset();  // 没有NVRTC时走通用算子
+    return Status::Ok();
+}
+
+#endif // INFERUNITY_USE_NVRTC
+
+} // namespace inferunity
+
+#endif // ENABLE_CUDA
@@ -0,0 +1,450 @@
+// CUDA kernel：cuBLASLt GEMM与cuDNN卷积
+// 参考ONNX Runtime的CUDA MatMul/Conv实现：编译节点时按静态形状创建描述符，
+// 实测cuBLASLt启发式给出的候选/全部cuDNN前向算法，最优结果写入调优缓存（见kernel_tuning.h）
+
+#ifdef ENABLE_CUDA
+
+#include "inferunity/cuda_backend.h"
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/graph.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "inferunity/logger.h"
+#include <cublasLt.h>
+#include <cudnn.h>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+constexpr int kWarmupIterations = 1;
+constexpr int kTimedIterations = 5;
+constexpr int kMaxHeuristicAlgorithms = 8;
+
+// 设备上的临时缓冲，调优与workspace使用
+class DeviceBuffer {
+public:
+    DeviceBuffer(CachingDeviceAllocator* allocator, size_t size)
+        : allocator_(allocator), data_(size ? allocator->Allocate(size) : nullptr), size_(size) {}
+    ~DeviceBuffer() {
+        if (data_) {
+            allocator_->Free(data_);
+        }
+    }
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+    
+    void* Get() const { return data_; }
+    bool IsValid() const { return size_ == 0 || data_ != nullptr; }
+
+private:
+    CachingDeviceAllocator* allocator_;
+    void* data_;
+    size_t size_;
+};
+
+// 在stream上重复执行launch并用事件计时，返回单次耗时（微秒）
+template <typename Launch>
+Status TimeOnStream(const Launch& launch, cudaStream_t stream, double* time_us) {
+    for (int i = 0; i < kWarmupIterations; ++i) {
+        Status status = launch();
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    cudaEvent_t start, stop;
+    cudaEventCreate(&start);
+    cudaEventCreate(&stop);
+    cudaEventRecord(start, stream);
+    Status status = Status::Ok();
+    for (int i = 0; i < kTimedIterations && status.IsOk(); ++i) {
+        status = launch();
+    }
+    cudaEventRecord(stop, stream);
+    cudaEventSynchronize(stop);
+    float elapsed_ms = 0.0f;
+    cudaEventElapsedTime(&elapsed_ms, start, stop);
+    cudaEventDestroy(start);
+    cudaEventDestroy(stop);
+    if (status.IsOk()) {
+        *time_us = elapsed_ms * 1000.0 / kTimedIterations;
+    }
+    return status;
+}
+
+std::string JoinDims(const std::vector<int64_t>& dims) {
+    std::string text;
+    for (size_t i = 0; i < dims.size(); ++i) {
+        text += (i ? "x" : "") + std::to_string(dims[i]);
+    }
+    return text;
+}
+
+std::unique_ptr<Operator> CreateAttributedOperator(const Node* node) {
+    auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+    if (op) {
+        ApplyNodeAttributes(*node, op.get());
+    }
+    return op;
+}
+
+bool SameDims(const std::vector<Tensor*>& inputs, const std::vector<Shape>& shapes) {
+    if (inputs.size() < shapes.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        if (!inputs[i] || inputs[i]->GetShape().dims != shapes[i].dims) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Y[M,N] = alpha · X[M,K] · W (+ bias[N])，行主序。
+// cuBLASLt按列主序计算，行主序的Y等价于列主序的Yᵀ = Wᵀ·Xᵀ，交换两个操作数即可，不需要转置拷贝
+class CublasLtGemmKernel : public CUDAKernel {
+public:
+    ~CublasLtGemmKernel() override {
+        if (preference_) cublasLtMatmulPreferenceDestroy(preference_);
+        if (w_layout_) cublasLtMatrixLayoutDestroy(w_layout_);
+        if (x_layout_) cublasLtMatrixLayoutDestroy(x_layout_);
+        if (y_layout_) cublasLtMatrixLayoutDestroy(y_layout_);
+        if (desc_) cublasLtMatmulDescDestroy(desc_);
+    }
+    
+    Status Init(const Node* node, const std::vector<Shape>& shapes, DataType dtype,
+                const CUDAKernelContext& context) {
+        auto op = CreateAttributedOperator(node);
+        if (!op || shapes.size() < 2 || shapes[0].dims.size() < 2 || shapes[1].dims.size() != 2 ||
+            op->GetIntAttribute("transA", 0) != 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported GEMM layout");
+        }
+        const bool trans_b = op->GetIntAttribute("transB", 0) != 0;
+        alpha_ = op->GetFloatAttribute("alpha", 1.0f);
+        const std::vector<int64_t>& a = shapes[0].dims;
+        const std::vector<int64_t>& b = shapes[1].dims;
+        k_ = a.back();
+        m_ = std::accumulate(a.begin(), a.end() - 1, int64_t(1), std::multiplies<int64_t>());
+        n_ = trans_b ? b[0] : b[1];
+        if ((trans_b ? b[1] : b[0]) != k_ || m_ <= 0 || n_ <= 0 || k_ <= 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported GEMM shape");
+        }
+        has_bias_ = shapes.size() > 2;
+        if (has_bias_ && (shapes[2].GetElementCount() != static_cast<size_t>(n_) ||
+                          shapes[2].dims.empty() || shapes[2].dims.back() != n_)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Only row-vector bias is fused");
+        }
+        shapes_ = shapes;
+        dtype_ = dtype;
+        context_ = context;
+        
+        const cudaDataType_t type = dtype == DataType::FLOAT16 ? CUDA_R_16F : CUDA_R_32F;
+        if (cublasLtMatmulDescCreate(&desc_, CUBLAS_COMPUTE_32F, CUDA_R_32F) != CUBLAS_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cublasLtMatmulDescCreate failed");
+        }
+        const cublasOperation_t op_w = trans_b ? CUBLAS_OP_T : CUBLAS_OP_N;
+        cublasLtMatmulDescSetAttribute(desc_, CUBLASLT_MATMUL_DESC_TRANSA, &op_w, sizeof(op_w));
+        // bias在GEMM写回时加上，不再单独启动kernel
+        const cublasLtEpilogue_t epilogue = has_bias_ ? CUBLASLT_EPILOGUE_BIAS : CUBLASLT_EPILOGUE_DEFAULT;
+        cublasLtMatmulDescSetAttribute(desc_, CUBLASLT_MATMUL_DESC_EPILOGUE, &epilogue, sizeof(epilogue));
+        
+        // 列主序视角：W为[N,K]（transB时为[K,N]再转置），X为[K,M]，Y为[N,M]
+        cublasLtMatrixLayoutCreate(&w_layout_, type, trans_b ? k_ : n_, trans_b ? n_ : k_, trans_b ? k_ : n_);
+        cublasLtMatrixLayoutCreate(&x_layout_, type, k_, m_, k_);
+        cublasLtMatrixLayoutCreate(&y_layout_, type, n_, m_, n_);
+        cublasLtMatmulPreferenceCreate(&preference_);
+        cublasLtMatmulPreferenceSetAttribute(preference_, CUBLASLT_MATMUL_PREF_MAX_WORKSPACE_BYTES,
+                                             &context.max_workspace_bytes, sizeof(context.max_workspace_bytes));
+        
+        int returned = 0;
+        if (cublasLtMatmulAlgoGetHeuristic(context.cublaslt, desc_, w_layout_, x_layout_, y_layout_, y_layout_,
+                                           preference_, kMaxHeuristicAlgorithms, heuristics_, &returned) !=
+                CUBLAS_STATUS_SUCCESS || returned == 0) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "No cuBLASLt algorithm for " + node->GetName());
+        }
+        
+        // 启发式结果的顺序对同一GPU型号与库版本是确定的，缓存记录下标
+        std::vector<int> candidates(returned);
+        std::iota(candidates.begin(), candidates.end(), 0);
+        const std::string signature = "m" + std::to_string(m_) + "n" + std::to_string(n_) + "k" +
+            std::to_string(k_) + (trans_b ? "t" : "") + "e" + std::to_string(static_cast<int>(epilogue)) +
+            "v" + std::to_string(cublasLtGetVersion());
+        const std::string key = KernelTuningCache::MakeKey(context.device_name, "cublasLt.Gemm", signature, dtype);
+        TuningRecord best;
+        Status status = AutotuneKernel(key, candidates,
+            [&](int algorithm, TuningRecord* measured) { return Benchmark(algorithm, measured); },
+            context.tuning_cache, &best);
+        if (!status.IsOk()) {
+            return status;
+        }
+        algorithm_ = best.algorithm;
+        workspace_ = std::make_unique<DeviceBuffer>(context.allocator, heuristics_[algorithm_].workspaceSize);
+        return workspace_->IsValid() ? Status::Ok()
+            : Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate cuBLASLt workspace");
+    }
+    
+    bool Matches(const std::vector<Tensor*>& inputs) const override { return SameDims(inputs, shapes_); }
+    
+    Status Compute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                   cudaStream_t stream) override {
+        const void* bias = has_bias_ ? inputs[2]->GetData() : nullptr;
+        return Launch(inputs[1]->GetData(), inputs[0]->GetData(), bias, outputs[0]->GetData(),
+                      algorithm_, workspace_->Get(), stream);
+    }
+
+private:
+    Status Launch(const void* w, const void* x, const void* bias, void* y, int algorithm,
+                  void* workspace, cudaStream_t stream) {
+        if (bias) {
+            cublasLtMatmulDescSetAttribute(desc_, CUBLASLT_MATMUL_DESC_BIAS_POINTER, &bias, sizeof(bias));
+        }
+        const float beta = 0.0f;
+        const cublasLtMatmulHeuristicResult_t& heuristic = heuristics_[algorithm];
+        if (cublasLtMatmul(context_.cublaslt, desc_, &alpha_, w, w_layout_, x, x_layout_, &beta,
+                           y, y_layout_, y, y_layout_, &heuristic.algo, workspace,
+                           heuristic.workspaceSize, stream) != CUBLAS_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cublasLtMatmul failed");
+        }
+        return Status::Ok();
+    }
+    
+    Status Benchmark(int algorithm, TuningRecord* measured) {
+        const size_t element = GetDataTypeSize(dtype_);
+        DeviceBuffer w(context_.allocator, static_cast<size_t>(k_ * n_) * element);
+        DeviceBuffer x(context_.allocator, static_cast<size_t>(m_ * k_) * element);
+        DeviceBuffer y(context_.allocator, static_cast<size_t>(m_ * n_) * element);
+        DeviceBuffer bias(context_.allocator, has_bias_ ? static_cast<size_t>(n_) * element : 0);
+        DeviceBuffer workspace(context_.allocator, heuristics_[algorithm].workspaceSize);
+        if (!w.IsValid() || !x.IsValid() || !y.IsValid() || !bias.IsValid() || !workspace.IsValid()) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Tuning buffers");
+        }
+        cudaMemset(w.Get(), 0, static_cast<size_t>(k_ * n_) * element);
+        cudaMemset(x.Get(), 0, static_cast<size_t>(m_ * k_) * element);
+        measured->workspace_bytes = heuristics_[algorithm].workspaceSize;
+        return TimeOnStream([&]() {
+            return Launch(w.Get(), x.Get(), has_bias_ ? bias.Get() : nullptr, y.Get(), algorithm, workspace.Get(), nullptr);
+        }, nullptr, &measured->time_us);
+    }
+    
+    std::vector<Shape> shapes_;
+    DataType dtype_ = DataType::FLOAT32;
+    CUDAKernelContext context_;
+    int64_t m_ = 0, n_ = 0, k_ = 0;
+    float alpha_ = 1.0f;
+    bool has_bias_ = false;
+    cublasLtMatmulDesc_t desc_ = nullptr;
+    cublasLtMatrixLayout_t w_layout_ = nullptr, x_layout_ = nullptr, y_layout_ = nullptr;
+    cublasLtMatmulPreference_t preference_ = nullptr;
+    cublasLtMatmulHeuristicResult_t heuristics_[kMaxHeuristicAlgorithms] = {};
+    int algorithm_ = 0;
+    std::unique_ptr<DeviceBuffer> workspace_;
+};
+
+// NCHW二维卷积（可带bias与ReLU），前向算法在全部cuDNN算法中实测选出
+class CudnnConvKernel : public CUDAKernel {
+public:
+    ~CudnnConvKernel() override {
+        if (x_desc_) cudnnDestroyTensorDescriptor(x_desc_);
+        if (y_desc_) cudnnDestroyTensorDescriptor(y_desc_);
+        if (bias_desc_) cudnnDestroyTensorDescriptor(bias_desc_);
+        if (w_desc_) cudnnDestroyFilterDescriptor(w_desc_);
+        if (conv_desc_) cudnnDestroyConvolutionDescriptor(conv_desc_);
+        if (activation_desc_) cudnnDestroyActivationDescriptor(activation_desc_);
+    }
+    
+    Status Init(const Node* node, const std::vector<Shape>& shapes, DataType dtype,
+                const CUDAKernelContext& context) {
+        auto op = CreateAttributedOperator(node);
+        if (!op || shapes.size() < 2 || shapes[0].dims.size() != 4 || shapes[1].dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Only 2D NCHW convolution is supported");
+        }
+        const std::string auto_pad = op->GetStringAttribute("auto_pad", "NOTSET");
+        const std::vector<int64_t> strides = op->GetIntsAttribute("strides", {1, 1});
+        std::vector<int64_t> pads = op->GetIntsAttribute("pads", {0, 0, 0, 0});
+        if (pads.size() == 2) {
+            pads = {pads[0], pads[1], pads[0], pads[1]};
+        }
+        const std::vector<int64_t> dilations = op->GetIntsAttribute("dilations", {1, 1});
+        const int64_t group = op->GetIntAttribute("group", 1);
+        // cuDNN只支持对称padding
+        if (auto_pad != "NOTSET" || strides.size() != 2 || dilations.size() != 2 || pads.size() != 4 ||
+            pads[0] != pads[2] || pads[1] != pads[3] || group <= 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported convolution attributes");
+        }
+        shapes_ = shapes;
+        dtype_ = dtype;
+        context_ = context;
+        has_bias_ = shapes.size() > 2 && shapes[2].GetElementCount() == static_cast<size_t>(shapes[1].dims[0]);
+        relu_ = node->GetOpType() == "FusedConvReLU";
+        
+        const cudnnDataType_t type = dtype == DataType::FLOAT16 ? CUDNN_DATA_HALF : CUDNN_DATA_FLOAT;
+        const std::vector<int64_t>& x = shapes[0].dims;
+        const std::vector<int64_t>& w = shapes[1].dims;
+        cudnnCreateTensorDescriptor(&x_desc_);
+        cudnnCreateTensorDescriptor(&y_desc_);
+        cudnnCreateFilterDescriptor(&w_desc_);
+        cudnnCreateConvolutionDescriptor(&conv_desc_);
+        cudnnSetTensor4dDescriptor(x_desc_, CUDNN_TENSOR_NCHW, type, x[0], x[1], x[2], x[3]);
+        cudnnSetFilter4dDescriptor(w_desc_, type, CUDNN_TENSOR_NCHW, w[0], w[1], w[2], w[3]);
+        cudnnSetConvolution2dDescriptor(conv_desc_, pads[0], pads[1], strides[0], strides[1],
+                                        dilations[0], dilations[1], CUDNN_CROSS_CORRELATION, CUDNN_DATA_FLOAT);
+        cudnnSetConvolutionGroupCount(conv_desc_, static_cast<int>(group));
+        cudnnSetConvolutionMathType(conv_desc_, dtype == DataType::FLOAT16 ? CUDNN_TENSOR_OP_MATH
+                                                                            : CUDNN_DEFAULT_MATH);
+        int n = 0, c = 0, h = 0, wd = 0;
+        if (cudnnGetConvolution2dForwardOutputDim(conv_desc_, x_desc_, w_desc_, &n, &c, &h, &wd) !=
+            CUDNN_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid convolution for " + node->GetName());
+        }
+        y_dims_ = {n, c, h, wd};
+        cudnnSetTensor4dDescriptor(y_desc_, CUDNN_TENSOR_NCHW, type, n, c, h, wd);
+        if (has_bias_) {
+            cudnnCreateTensorDescriptor(&bias_desc_);
+            cudnnSetTensor4dDescriptor(bias_desc_, CUDNN_TENSOR_NCHW, type, 1, c, 1, 1);
+        }
+        if (relu_) {
+            cudnnCreateActivationDescriptor(&activation_desc_);
+            cudnnSetActivationDescriptor(activation_desc_, CUDNN_ACTIVATION_RELU, CUDNN_NOT_PROPAGATE_NAN, 0.0);
+        }
+        
+        std::vector<int> candidates(CUDNN_CONVOLUTION_FWD_ALGO_COUNT);
+        std::iota(candidates.begin(), candidates.end(), 0);
+        const std::string signature = "x" + JoinDims(x) + "w" + JoinDims(w) + "s" + JoinDims(strides) +
+            "p" + JoinDims(pads) + "d" + JoinDims(dilations) + "g" + std::to_string(group) +
+            "v" + std::to_string(cudnnGetVersion());
+        const std::string key = KernelTuningCache::MakeKey(context.device_name, "cudnn.ConvFwd", signature, dtype);
+        TuningRecord best;
+        Status status = AutotuneKernel(key, candidates,
+            [&](int algorithm, TuningRecord* measured) { return Benchmark(algorithm, measured); },
+            context.tuning_cache, &best);
+        if (!status.IsOk()) {
+            return status;
+        }
+        algorithm_ = static_cast<cudnnConvolutionFwdAlgo_t>(best.algorithm);
+        workspace_bytes_ = best.workspace_bytes;
+        workspace_ = std::make_unique<DeviceBuffer>(context.allocator, workspace_bytes_);
+        return workspace_->IsValid() ? Status::Ok()
+            : Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate cuDNN workspace");
+    }
+    
+    bool Matches(const std::vector<Tensor*>& inputs) const override { return SameDims(inputs, shapes_); }
+    
+    Status Compute(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                   cudaStream_t stream) override {
+        cudnnSetStream(context_.cudnn, stream);
+        return Launch(inputs[0]->GetData(), inputs[1]->GetData(), has_bias_ ? inputs[2]->GetData() : nullptr,
+                      outputs[0]->GetData(), algorithm_, workspace_->Get(), workspace_bytes_);
+    }
+
+private:
+    Status Launch(const void* x, const void* w, const void* bias, void* y, cudnnConvolutionFwdAlgo_t algorithm,
+                  void* workspace, size_t workspace_bytes) {
+        const float one = 1.0f, zero = 0.0f;
+        if (cudnnConvolutionForward(context_.cudnn, &one, x_desc_, x, w_desc_, w, conv_desc_, algorithm,
+                                    workspace, workspace_bytes, &zero, y_desc_, y) != CUDNN_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudnnConvolutionForward failed");
+        }
+        if (bias && cudnnAddTensor(context_.cudnn, &one, bias_desc_, bias, &one, y_desc_, y) != CUDNN_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudnnAddTensor failed");
+        }
+        if (relu_ && cudnnActivationForward(context_.cudnn, activation_desc_, &one, y_desc_, y, &zero, y_desc_, y) !=
+            CUDNN_STATUS_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "cudnnActivationForward failed");
+        }
+        return Status::Ok();
+    }
+    
+    Status Benchmark(int algorithm, TuningRecord* measured) {
+        const auto algo = static_cast<cudnnConvolutionFwdAlgo_t>(algorithm);
+        size_t workspace_bytes = 0;
+        if (cudnnGetConvolutionForwardWorkspaceSize(context_.cudnn, x_desc_, w_desc_, conv_desc_, y_desc_, algo,
+                                                    &workspace_bytes) != CUDNN_STATUS_SUCCESS ||
+            workspace_bytes > context_.max_workspace_bytes) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Algorithm not available");
+        }
+        const size_t element = GetDataTypeSize(dtype_);
+        const size_t x_bytes = shapes_[0].GetElementCount() * element;
+        const size_t w_bytes = shapes_[1].GetElementCount() * element;
+        const size_t y_bytes = static_cast<size_t>(y_dims_[0] * y_dims_[1] * y_dims_[2] * y_dims_[3]) * element;
+        DeviceBuffer x(context_.allocator, x_bytes);
+        DeviceBuffer w(context_.allocator, w_bytes);
+        DeviceBuffer y(context_.allocator, y_bytes);
+        DeviceBuffer workspace(context_.allocator, workspace_bytes);
+        if (!x.IsValid() || !w.IsValid() || !y.IsValid() || !workspace.IsValid()) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Tuning buffers");
+        }
+        cudaMemset(x.Get(), 0, x_bytes);
+        cudaMemset(w.Get(), 0, w_bytes);
+        cudnnSetStream(context_.cudnn, nullptr);
+        measured->workspace_bytes = workspace_bytes;
+        return TimeOnStream([&]() {
+            return Launch(x.Get(), w.Get(), nullptr, y.Get(), algo, workspace.Get(), workspace_bytes);
+        }, nullptr, &measured->time_us);
+    }
+    
+    std::vector<Shape> shapes_;
+    std::vector<int64_t> y_dims_;
+    DataType dtype_ = DataType::FLOAT32;
+    CUDAKernelContext context_;
+    bool has_bias_ = false;
+    bool relu_ = false;
+    cudnnTensorDescriptor_t x_desc_ = nullptr, y_desc_ = nullptr, bias_desc_ = nullptr;
+    cudnnFilterDescriptor_t w_desc_ = nullptr;
+    cudnnConvolutionDescriptor_t conv_desc_ = nullptr;
+    cudnnActivationDescriptor_t activation_desc_ = nullptr;
+    cudnnConvolutionFwdAlgo_t algorithm_ = CUDNN_CONVOLUTION_FWD_ALGO_IMPLICIT_GEMM;
+    size_t workspace_bytes_ = 0;
+    std::unique_ptr<DeviceBuffer> workspace_;
+};
+
+template <typename Kernel>
+Status InitKernel(const Node* node, const std::vector<Shape>& shapes, DataType dtype,
+                  const CUDAKernelContext& context, std::unique_ptr<CUDAKernel>* kernel) {
+    auto created = std::make_unique<Kernel>();
+    Status status = created->Init(node, shapes, dtype, context);
+    if (status.Code() == StatusCode::ERROR_NOT_IMPLEMENTED) {
+        return Status::Ok();  // 形状或属性不适用，走通用算子
+    }
+    if (status.IsOk()) {
+        *kernel = std::move(created);
+    }
+    return status;
+}
+
+} // anonymous namespace
+
+Status CreateCUDAKernel(const Node* node, const std::vector<Shape>& input_shapes, DataType dtype,
+                        const CUDAKernelContext& context, std::unique_ptr<CUDAKernel>* kernel) {
+    if (!node || !kernel) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node or kernel is null");
+    }
+    kernel->reset();
+    if (dtype != DataType::FLOAT32 && dtype != DataType::FLOAT16) {
+        return Status::Ok();
+    }
+    for (const Shape& shape : input_shapes) {
+        for (int64_t dim : shape.dims) {
+            if (dim <= 0) {
+                return Status::Ok();  // 动态形状在运行时按实际形状再创建
+            }
+        }
+    }
+    const std::string& op_type = node->GetOpType();
+    if (op_type == "MatMul" || op_type == "FusedMatMulAdd") {
+        return InitKernel<CublasLtGemmKernel>(node, input_shapes, dtype, context, kernel);
+    }
+    if (op_type == "Conv" || op_type == "FusedConvReLU") {
+        return InitKernel<CudnnConvKernel>(node, input_shapes, dtype, context, kernel);
+    }
+    if (op_type == "FusedElementwise") {
+        return CreateCUDAFusedElementwiseKernel(node, input_shapes, dtype, context, kernel);
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
+
+#endif // ENABLE_CUDA
@@ -0,0 +1,60 @@
+#pragma once
+
+// 委托子图的提供者（oneDNN、XNNPACK）共用的节点判断与属性读取
+
+#include "inferunity/graph.h"
+#include "inferunity/types.h"
+#include <cstdint>
+#include <string>
+
+namespace inferunity {
+namespace delegate {
+
+// 没有生产者且已有数据的值（初始化器）
+inline bool IsConstant(const Value* value) {
+    return !value->GetProducer() && value->GetTensor() && value->GetTensor()->GetData();
+}
+
+inline bool IsFloat(const Value* value) {
+    return value->GetDataType() == DataType::FLOAT32;
+}
+
+// 浮点卷积/矩阵乘：提供者只接管含这类节点的子图
+inline bool IsComputeOp(const std::string& type) {
+    return type == "Conv" || type == "MatMul" || type == "Gemm";
+}
+
+inline bool IsQuantizedComputeOp(const std::string& type) {
+    return type == "QLinearConv" || type == "QLinearMatMul";
+}
+
+inline bool IsPoolOp(const std::string& type) {
+    return type == "MaxPool" || type == "AveragePool" || type == "GlobalAveragePool";
+}
+
+// 整数属性；FLOAT类型的属性截断取整，缺失或类型不符时返回default_value
+inline int64_t IntAttribute(const Node* node, const std::string& key, int64_t default_value) {
+    const AttributeValue* value = node->FindAttribute(key);
+    if (!value) {
+        return default_value;
+    }
+    if (value->GetType() == AttributeValue::Type::INT) {
+        return value->GetInt();
+    }
+    return value->GetType() == AttributeValue::Type::FLOAT ? static_cast<int64_t>(value->GetFloat()) : default_value;
+}
+
+// 浮点属性；INT类型的属性转换为float，缺失或类型不符时返回default_value
+inline float FloatAttribute(const Node* node, const std::string& key, float default_value) {
+    const AttributeValue* value = node->FindAttribute(key);
+    if (!value) {
+        return default_value;
+    }
+    if (value->GetType() == AttributeValue::Type::FLOAT) {
+        return value->GetFloat();
+    }
+    return value->GetType() == AttributeValue::Type::INT ? static_cast<float>(value->GetInt()) : default_value;
+}
+
+}  // namespace delegate
+}  // namespace inferunity
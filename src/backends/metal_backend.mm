@@ -0,0 +1,870 @@
+// Metal执行提供者（Apple Silicon）
+// Conv、GEMM、逐元素、池化与Softmax由MPSGraph执行，每个节点按输入形状构建一张小图并缓存；
+// 形状或属性不适用的节点在主机上执行。张量内存来自共享存储模式的MTLHeap，主机与GPU在统一内存上
+// 访问同一份数据：张量的数据指针就是MTLBuffer的contents，拷贝与主机侧算子不需要额外传输
+
+#include "inferunity/backend.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/memory.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "operators/conv_kernels.h"
+#include "operators/pooling.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_METAL
+#import <Metal/Metal.h>
+#import <MetalPerformanceShaders/MetalPerformanceShaders.h>
+#import <MetalPerformanceShadersGraph/MetalPerformanceShadersGraph.h>
+
+namespace inferunity {
+
+namespace {
+
+// MTLHeap是Metal自带的子分配器：缓冲从堆中切分，释放后空间回到堆里。每个张量是独立的MTLBuffer，
+// 偏移总为0，可直接交给MPSGraphTensorData；不支持共享存储堆的设备退回逐个创建缓冲
+class MetalAllocator : public MemoryAllocator {
+public:
+    explicit MetalAllocator(id<MTLDevice> device) : device_(device) {}
+
+    void* Allocate(size_t size) override {
+        @autoreleasepool {
+            const size_t length = std::max<size_t>(size, 4);
+            std::lock_guard<std::mutex> lock(mutex_);
+            id<MTLBuffer> buffer = nil;
+            if (use_heaps_) {
+                for (id<MTLHeap> heap : heaps_) {
+                    buffer = [heap newBufferWithLength:length options:MTLResourceStorageModeShared];
+                    if (buffer) {
+                        break;
+                    }
+                }
+                if (!buffer) {
+                    MTLHeapDescriptor* descriptor = [[MTLHeapDescriptor alloc] init];
+                    descriptor.storageMode = MTLStorageModeShared;
+                    const MTLSizeAndAlign size_align =
+                        [device_ heapBufferSizeAndAlignWithLength:length options:MTLResourceStorageModeShared];
+                    descriptor.size = std::max<NSUInteger>(kHeapSize, size_align.size);
+                    id<MTLHeap> heap = [device_ newHeapWithDescriptor:descriptor];
+                    if (heap) {
+                        heaps_.push_back(heap);
+                        buffer = [heap newBufferWithLength:length options:MTLResourceStorageModeShared];
+                    } else {
+                        use_heaps_ = false;
+                    }
+                }
+            }
+            if (!buffer) {
+                buffer = [device_ newBufferWithLength:length options:MTLResourceStorageModeShared];
+            }
+            if (!buffer) {
+                return nullptr;
+            }
+            void* ptr = [buffer contents];
+            buffers_[reinterpret_cast<uintptr_t>(ptr)] = {buffer, size};
+            stats_.allocated_bytes += size;
+            stats_.peak_allocated_bytes = std::max(stats_.peak_allocated_bytes, stats_.allocated_bytes);
+            ++stats_.allocation_count;
+            return ptr;
+        }
+    }
+
+    // 基类的AllocateAligned返回缓冲内部的地址，Free按所在缓冲释放
+    void Free(void* ptr) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = FindLocked(ptr);
+        if (it == buffers_.end()) {
+            return;
+        }
+        stats_.allocated_bytes -= it->second.size;
+        ++stats_.free_count;
+        buffers_.erase(it);
+    }
+
+    size_t GetAllocatedSize(void* ptr) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = buffers_.find(reinterpret_cast<uintptr_t>(ptr));
+        return it == buffers_.end() ? 0 : it->second.size;
+    }
+
+    bool GetStats(MemoryStats* stats) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *stats = stats_;
+        return true;
+    }
+
+    // 指针 -> 所在的MTLBuffer与偏移；不是Metal分配的内存返回nil
+    id<MTLBuffer> Resolve(const void* ptr, size_t* offset) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = FindLocked(ptr);
+        if (it == buffers_.end()) {
+            return nil;
+        }
+        *offset = reinterpret_cast<uintptr_t>(ptr) - it->first;
+        return it->second.buffer;
+    }
+
+private:
+    struct Entry {
+        id<MTLBuffer> buffer;
+        size_t size;
+    };
+
+    static constexpr NSUInteger kHeapSize = 64 << 20;
+
+    std::map<uintptr_t, Entry>::const_iterator FindLocked(const void* ptr) const {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        auto it = buffers_.upper_bound(address);
+        if (it == buffers_.begin()) {
+            return buffers_.end();
+        }
+        --it;
+        return address < it->first + std::max<size_t>(it->second.size, 4) ? it : buffers_.end();
+    }
+
+    id<MTLDevice> device_;
+    std::vector<id<MTLHeap>> heaps_;
+    bool use_heaps_ = true;
+    std::map<uintptr_t, Entry> buffers_;
+    MemoryStats stats_ = {0, 0, 0, 0};
+    mutable std::mutex mutex_;
+};
+
+// Metal设备：内存对主机可见，拷贝直接在主机上完成；执行提供者每次提交后都等待完成
+class MetalDevice : public Device {
+public:
+    MetalDevice(id<MTLDevice> device, id<MTLCommandQueue> queue, std::shared_ptr<MetalAllocator> allocator)
+        : device_(device), queue_(queue), allocator_(std::move(allocator)) {}
+
+    DeviceType GetType() const override { return DeviceType::METAL; }
+    std::string GetName() const override { return std::string("Metal:") + [[device_ name] UTF8String]; }
+
+    void* Allocate(size_t size) override { return allocator_->Allocate(size); }
+    void Free(void* ptr) override { allocator_->Free(ptr); }
+    void* AllocateAligned(size_t size, size_t alignment) override {
+        return allocator_->AllocateAligned(size, alignment);
+    }
+
+    Status Copy(void* dst, const void* src, size_t size) override {
+        std::memcpy(dst, src, size);
+        return Status::Ok();
+    }
+    Status CopyFromHost(void* dst, const void* src, size_t size) override { return Copy(dst, src, size); }
+    Status CopyToHost(void* dst, const void* src, size_t size) override { return Copy(dst, src, size); }
+
+    // 命令队列按提交顺序完成，等待一个空命令缓冲即等待之前的全部工作
+    Status Synchronize() override {
+        @autoreleasepool {
+            id<MTLCommandBuffer> commands = [queue_ commandBuffer];
+            [commands commit];
+            [commands waitUntilCompleted];
+            return Status::Ok();
+        }
+    }
+
+    void* CreateStream() override { return nullptr; }
+    void DestroyStream(void* stream) override { (void)stream; }
+    Status SynchronizeStream(void* stream) override {
+        (void)stream;
+        return Synchronize();
+    }
+
+private:
+    id<MTLDevice> device_;
+    id<MTLCommandQueue> queue_;
+    std::shared_ptr<MetalAllocator> allocator_;
+};
+
+MPSDataType ToMPSDataType(DataType dtype) {
+    return dtype == DataType::FLOAT16 ? MPSDataTypeFloat16 : MPSDataTypeFloat32;
+}
+
+NSArray<NSNumber*>* ToMPSShape(const std::vector<int64_t>& dims) {
+    NSMutableArray<NSNumber*>* shape = [NSMutableArray arrayWithCapacity:std::max<size_t>(dims.size(), 1)];
+    for (int64_t dim : dims) {
+        [shape addObject:@(dim)];
+    }
+    if (dims.empty()) {
+        [shape addObject:@1];
+    }
+    return shape;
+}
+
+// from能否按numpy规则广播到to
+bool BroadcastsTo(const std::vector<int64_t>& from, const std::vector<int64_t>& to) {
+    if (from.size() > to.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < from.size(); ++i) {
+        const int64_t dim = from[from.size() - 1 - i];
+        if (dim != 1 && dim != to[to.size() - 1 - i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsGraphOp(const std::string& op_type) {
+    static const std::unordered_set<std::string> ops = {
+        "Conv", "FusedConvReLU", "MatMul", "Gemm", "FusedMatMulAdd",
+        "Add", "Sub", "Mul", "Div", "Relu", "Sigmoid", "Tanh", "LeakyRelu", "Clip",
+        "MaxPool", "AveragePool", "GlobalMaxPool", "GlobalAveragePool", "Softmax", "LogSoftmax"
+    };
+    return ops.count(op_type) > 0;
+}
+
+// 一个节点在一组输入形状下的MPSGraph
+struct MetalGraph {
+    MPSGraph* graph = nil;
+    NSArray<MPSGraphTensor*>* inputs = nil;   // 与节点的浮点输入一一对应
+    MPSGraphTensor* output = nil;
+};
+
+} // namespace
+
+class MetalExecutionProvider : public ExecutionProvider {
+private:
+    // 记录好的工作：编码进命令缓冲的图，或必须在GPU完成后于主机上执行的动作
+    struct CapturedStep {
+        std::function<void(MPSCommandBuffer*)> encode;
+        std::function<Status()> host_action;
+    };
+
+    id<MTLDevice> mtl_device_ = nil;
+    id<MTLCommandQueue> queue_ = nil;
+    std::shared_ptr<MetalAllocator> allocator_;
+    std::shared_ptr<MetalDevice> device_;
+
+    // 整图捕获 (见ExecutionProvider::CaptureBegin)：连续的图编码进同一个MPSCommandBuffer，
+    // 只在主机动作之前提交并等待；不捕获时每个节点单独提交
+    bool capturing_ = false;
+    std::vector<CapturedStep> captured_;
+    bool captured_ready_ = false;
+
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> uploaded_constants_;
+    std::map<std::pair<const Node*, size_t>, std::shared_ptr<Tensor>> staging_;
+    std::unordered_map<const Node*, std::shared_ptr<Tensor>> staging_outputs_;
+    std::unordered_set<const Value*> graph_inputs_;
+    std::unordered_map<const Node*, std::unique_ptr<Operator>> operators_;
+    std::unordered_map<const Node*, std::map<std::string, MetalGraph>> graphs_;
+    std::mutex mutex_;
+
+    // 绑定给MPSGraph的张量必须位于某个MTLBuffer的起始处
+    id<MTLBuffer> BufferOf(const Tensor* tensor) const {
+        if (!tensor || !tensor->GetData()) {
+            return nil;
+        }
+        size_t offset = 0;
+        id<MTLBuffer> buffer = allocator_->Resolve(tensor->GetData(), &offset);
+        return offset == 0 ? buffer : nil;
+    }
+
+    Operator* GetOperator(const Node* node) {
+        auto it = operators_.find(node);
+        if (it != operators_.end()) {
+            return it->second.get();
+        }
+        auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+        if (!op) {
+            return nullptr;
+        }
+        ApplyNodeAttributes(*node, op.get());
+        Operator* raw = op.get();
+        operators_[node] = std::move(op);
+        return raw;
+    }
+
+    Status RunOnHost(std::function<Status()> action) {
+        if (!capturing_) {
+            return action();
+        }
+        CapturedStep step;
+        step.host_action = std::move(action);
+        captured_.push_back(std::move(step));
+        return Status::Ok();
+    }
+
+    Status Commit(MPSCommandBuffer* commands) {
+        [commands commit];
+        [commands waitUntilCompleted];
+        if ([commands status] == MTLCommandBufferStatusError) {
+            NSError* error = [commands error];
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR,
+                                 std::string("Metal command buffer failed: ") +
+                                 (error ? [[error localizedDescription] UTF8String] : "unknown error"));
+        }
+        return Status::Ok();
+    }
+
+    // 捕获时追加到计划中，否则立即编码、提交并等待
+    Status Encode(std::function<void(MPSCommandBuffer*)> encode) {
+        if (capturing_) {
+            CapturedStep step;
+            step.encode = std::move(encode);
+            captured_.push_back(std::move(step));
+            return Status::Ok();
+        }
+        MPSCommandBuffer* commands = [MPSCommandBuffer commandBufferFromCommandQueue:queue_];
+        encode(commands);
+        return Commit(commands);
+    }
+
+    // 着色器的输入：Metal缓冲中的张量直接绑定；主机上的常量上传一次，其余输入拷入暂存张量
+    Status ResolveInput(const Node* node, size_t index, Tensor* tensor, const Tensor** resolved) {
+        if (BufferOf(tensor)) {
+            *resolved = tensor;
+            return Status::Ok();
+        }
+        const Value* value = node->GetInputs()[index];
+        if (!value->GetProducer() && !graph_inputs_.count(value)) {
+            auto& uploaded = uploaded_constants_[tensor];
+            if (!uploaded) {
+                uploaded = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::METAL);
+                std::memcpy(uploaded->GetData(), tensor->GetData(), tensor->GetSizeInBytes());
+            }
+            *resolved = uploaded.get();
+            return Status::Ok();
+        }
+        auto& staging = staging_[{node, index}];
+        if (!staging || staging->GetShape().dims != tensor->GetShape().dims ||
+            staging->GetDataType() != tensor->GetDataType()) {
+            staging = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::METAL);
+        }
+        Tensor* dst = staging.get();
+        *resolved = dst;
+        return RunOnHost([tensor, dst]() {
+            std::memcpy(dst->GetData(), tensor->GetData(), tensor->GetSizeInBytes());
+            return Status::Ok();
+        });
+    }
+
+    // 为节点构建MPSGraph；返回false时节点在主机上执行
+    bool BuildGraph(const Node* node, Operator* op, const std::vector<Tensor*>& inputs, size_t float_inputs,
+                    const Tensor* output, MetalGraph* result) {
+        const std::string& op_type = node->GetOpType();
+        const MPSDataType dtype = ToMPSDataType(output->GetDataType());
+        MPSGraph* graph = [[MPSGraph alloc] init];
+        NSMutableArray<MPSGraphTensor*>* placeholders = [NSMutableArray array];
+        for (size_t i = 0; i < float_inputs; ++i) {
+            [placeholders addObject:[graph placeholderWithShape:ToMPSShape(inputs[i]->GetShape().dims)
+                                                       dataType:dtype name:nil]];
+        }
+        auto scalar = [&](double value) { return [graph constantWithScalar:value dataType:dtype]; };
+        MPSGraphTensor* x = placeholders[0];
+        MPSGraphTensor* y = nil;
+        const std::vector<int64_t>& out_dims = output->GetShape().dims;
+
+        if (op_type == "Relu") {
+            y = [graph reLUWithTensor:x name:nil];
+        } else if (op_type == "Sigmoid") {
+            y = [graph sigmoidWithTensor:x name:nil];
+        } else if (op_type == "Tanh") {
+            y = [graph tanhWithTensor:x name:nil];
+        } else if (op_type == "LeakyRelu") {
+            y = [graph leakyReLUWithTensor:x alpha:op->GetFloatAttribute("alpha", 0.01f) name:nil];
+        } else if (op_type == "Clip") {
+            // opset 11起min/max是输入，只接受FLOAT32标量
+            float bounds[2] = {op->GetFloatAttribute("min", -3.402823466e38f),
+                               op->GetFloatAttribute("max", 3.402823466e38f)};
+            for (size_t i = 1; i < inputs.size() && i < 3; ++i) {
+                if (!inputs[i] || !inputs[i]->GetData() || inputs[i]->GetElementCount() == 0) {
+                    continue;
+                }
+                if (inputs[i]->GetDataType() != DataType::FLOAT32) {
+                    return false;
+                }
+                bounds[i - 1] = *static_cast<const float*>(inputs[i]->GetData());
+            }
+            y = [graph clampWithTensor:x minValueTensor:scalar(bounds[0]) maxValueTensor:scalar(bounds[1]) name:nil];
+        } else if (op_type == "Add" || op_type == "Sub" || op_type == "Mul" || op_type == "Div") {
+            if (float_inputs != 2 || !BroadcastsTo(inputs[0]->GetShape().dims, out_dims) ||
+                !BroadcastsTo(inputs[1]->GetShape().dims, out_dims)) {
+                return false;
+            }
+            MPSGraphTensor* b = placeholders[1];
+            if (op_type == "Add") {
+                y = [graph additionWithPrimaryTensor:x secondaryTensor:b name:nil];
+            } else if (op_type == "Sub") {
+                y = [graph subtractionWithPrimaryTensor:x secondaryTensor:b name:nil];
+            } else if (op_type == "Mul") {
+                y = [graph multiplicationWithPrimaryTensor:x secondaryTensor:b name:nil];
+            } else {
+                y = [graph divisionWithPrimaryTensor:x secondaryTensor:b name:nil];
+            }
+        } else if (op_type == "MatMul" || op_type == "Gemm" || op_type == "FusedMatMulAdd") {
+            const std::vector<int64_t>& a_dims = inputs[0]->GetShape().dims;
+            const std::vector<int64_t>& b_dims = inputs[1]->GetShape().dims;
+            const std::string activation = op->GetStringAttribute("activation", "");
+            // 1D操作数的升降维交给主机实现
+            if (a_dims.size() < 2 || b_dims.size() < 2 ||
+                (!activation.empty() && activation != "relu" && activation != "gelu")) {
+                return false;
+            }
+            MPSGraphTensor* a = x;
+            MPSGraphTensor* b = placeholders[1];
+            if (op_type != "MatMul" && op->GetIntAttribute("transA", 0) != 0) {
+                a = [graph transposeTensor:a dimension:a_dims.size() - 2 withDimension:a_dims.size() - 1 name:nil];
+            }
+            if (op_type != "MatMul" && op->GetIntAttribute("transB", 0) != 0) {
+                b = [graph transposeTensor:b dimension:b_dims.size() - 2 withDimension:b_dims.size() - 1 name:nil];
+            }
+            y = [graph matrixMultiplicationWithPrimaryTensor:a secondaryTensor:b name:nil];
+            const float alpha = op->GetFloatAttribute("alpha", 1.0f);
+            if (alpha != 1.0f) {
+                y = [graph multiplicationWithPrimaryTensor:y secondaryTensor:scalar(alpha) name:nil];
+            }
+            if (float_inputs > 2 && inputs[2]->GetElementCount() > 0) {
+                if (!BroadcastsTo(inputs[2]->GetShape().dims, out_dims)) {
+                    return false;
+                }
+                MPSGraphTensor* bias = placeholders[2];
+                const float beta = op_type == "Gemm" ? op->GetFloatAttribute("beta", 1.0f) : 1.0f;
+                if (beta != 1.0f) {
+                    bias = [graph multiplicationWithPrimaryTensor:bias secondaryTensor:scalar(beta) name:nil];
+                }
+                y = [graph additionWithPrimaryTensor:y secondaryTensor:bias name:nil];
+            }
+            if (activation == "relu") {
+                y = [graph reLUWithTensor:y name:nil];
+            } else if (activation == "gelu") {
+                // 0.5 * x * (1 + erf(x / sqrt(2)))
+                MPSGraphTensor* erf = [graph erfWithTensor:[graph multiplicationWithPrimaryTensor:y
+                                                                                  secondaryTensor:scalar(0.7071067811865476)
+                                                                                             name:nil]
+                                                      name:nil];
+                MPSGraphTensor* gate = [graph additionWithPrimaryTensor:erf secondaryTensor:scalar(1.0) name:nil];
+                y = [graph multiplicationWithPrimaryTensor:[graph multiplicationWithPrimaryTensor:y
+                                                                                  secondaryTensor:scalar(0.5)
+                                                                                             name:nil]
+                                           secondaryTensor:gate name:nil];
+            }
+        } else if (op_type == "Conv" || op_type == "FusedConvReLU") {
+            operators::Conv2DParams conv;
+            if (inputs[0]->GetShape().dims.size() != 4 ||
+                !operators::ParseConv2DParams(*op, inputs[0]->GetShape(), inputs[1]->GetShape(), &conv).IsOk()) {
+                return false;
+            }
+            MPSGraphConvolution2DOpDescriptor* descriptor =
+                [MPSGraphConvolution2DOpDescriptor descriptorWithStrideInX:conv.stride_w
+                                                                 strideInY:conv.stride_h
+                                                           dilationRateInX:conv.dilation_w
+                                                           dilationRateInY:conv.dilation_h
+                                                                    groups:conv.group
+                                                               paddingLeft:conv.pad_left
+                                                              paddingRight:conv.pad_right
+                                                                paddingTop:conv.pad_top
+                                                             paddingBottom:conv.pad_bottom
+                                                              paddingStyle:MPSGraphPaddingStyleExplicit
+                                                                dataLayout:MPSGraphTensorNamedDataLayoutNCHW
+                                                             weightsLayout:MPSGraphTensorNamedDataLayoutOIHW];
+            y = [graph convolution2DWithSourceTensor:x weightsTensor:placeholders[1] descriptor:descriptor name:nil];
+            if (float_inputs > 2 && inputs[2]->GetElementCount() == static_cast<size_t>(conv.out_c)) {
+                MPSGraphTensor* bias = [graph reshapeTensor:placeholders[2] withShape:@[@1, @(conv.out_c), @1, @1]
+                                                       name:nil];
+                y = [graph additionWithPrimaryTensor:y secondaryTensor:bias name:nil];
+            }
+            if (op_type == "FusedConvReLU") {
+                y = [graph reLUWithTensor:y name:nil];
+            }
+        } else if (op_type == "MaxPool" || op_type == "AveragePool") {
+            operators::Pool2DParams pool;
+            const std::vector<int64_t> dilations = op->GetIntsAttribute("dilations", {});
+            if (inputs[0]->GetShape().dims.size() != 4 ||
+                std::any_of(dilations.begin(), dilations.end(), [](int64_t d) { return d != 1; }) ||
+                !operators::ParsePool2DParams(*op, inputs[0]->GetShape(), &pool).IsOk()) {
+                return false;
+            }
+            MPSGraphPooling2DOpDescriptor* descriptor =
+                [MPSGraphPooling2DOpDescriptor descriptorWithKernelWidth:pool.kernel_w
+                                                            kernelHeight:pool.kernel_h
+                                                               strideInX:pool.stride_w
+                                                               strideInY:pool.stride_h
+                                                         dilationRateInX:1
+                                                         dilationRateInY:1
+                                                             paddingLeft:pool.pad_left
+                                                            paddingRight:pool.pad_right
+                                                              paddingTop:pool.pad_top
+                                                           paddingBottom:pool.pad_bottom
+                                                            paddingStyle:MPSGraphPaddingStyleExplicit
+                                                              dataLayout:MPSGraphTensorNamedDataLayoutNCHW];
+            descriptor.ceilMode = op->GetIntAttribute("ceil_mode", 0) != 0;
+            descriptor.includeZeroPadToAverage = pool.count_include_pad;
+            y = op_type == "MaxPool" ? [graph maxPooling2DWithSourceTensor:x descriptor:descriptor name:nil]
+                                     : [graph avgPooling2DWithSourceTensor:x descriptor:descriptor name:nil];
+        } else if (op_type == "GlobalMaxPool" || op_type == "GlobalAveragePool") {
+            if (inputs[0]->GetShape().dims.size() != 4) {
+                return false;
+            }
+            y = op_type == "GlobalMaxPool" ? [graph reductionMaximumWithTensor:x axes:@[@2, @3] name:nil]
+                                           : [graph meanOfTensor:x axes:@[@2, @3] name:nil];
+        } else if (op_type == "Softmax" || op_type == "LogSoftmax") {
+            const int64_t rank = static_cast<int64_t>(inputs[0]->GetShape().dims.size());
+            int64_t axis = op->GetIntAttribute("axis", -1);
+            if (axis < 0) {
+                axis += rank;
+            }
+            if (axis < 0 || axis >= rank) {
+                return false;
+            }
+            if (op_type == "Softmax") {
+                y = [graph softMaxWithTensor:x axis:axis name:nil];
+            } else {
+                // x - max - log(sum(exp(x - max)))
+                MPSGraphTensor* shifted = [graph subtractionWithPrimaryTensor:x
+                                                              secondaryTensor:[graph reductionMaximumWithTensor:x axis:axis name:nil]
+                                                                         name:nil];
+                MPSGraphTensor* sum = [graph reductionSumWithTensor:[graph exponentWithTensor:shifted name:nil]
+                                                               axis:axis name:nil];
+                y = [graph subtractionWithPrimaryTensor:shifted
+                                        secondaryTensor:[graph logarithmWithTensor:sum name:nil] name:nil];
+            }
+        }
+        if (!y) {
+            return false;
+        }
+        // 图推导出的形状与运行时分配的输出不一致时（如属性组合不受支持）交给主机
+        NSArray<NSNumber*>* shape = [y shape];
+        if (!shape || [shape count] != std::max<size_t>(out_dims.size(), 1)) {
+            return false;
+        }
+        for (size_t d = 0; d < out_dims.size(); ++d) {
+            if ([shape[d] longLongValue] != out_dims[d]) {
+                return false;
+            }
+        }
+        result->graph = graph;
+        result->inputs = placeholders;
+        result->output = y;
+        return true;
+    }
+
+    // 选择并编码节点的MPSGraph；*handled为false时由主机执行
+    Status ExecuteGraph(Node* node, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                        bool* handled) {
+        *handled = false;
+        Operator* op = GetOperator(node);
+        if (!op || !IsGraphOp(node->GetOpType()) || inputs.empty() || outputs.size() != 1 || !outputs[0] ||
+            !outputs[0]->GetData()) {
+            return Status::Ok();
+        }
+        Tensor* output = outputs[0];
+        const DataType dtype = output->GetDataType();
+        if (dtype != DataType::FLOAT32 && dtype != DataType::FLOAT16) {
+            return Status::Ok();
+        }
+        const size_t float_inputs = node->GetOpType() == "Clip" ? 1 : inputs.size();
+        std::string signature = std::to_string(static_cast<int>(dtype));
+        for (size_t i = 0; i < float_inputs; ++i) {
+            if (!inputs[i] || !inputs[i]->GetData() || inputs[i]->GetDataType() != dtype) {
+                return Status::Ok();
+            }
+            signature += ";";
+            for (int64_t dim : inputs[i]->GetShape().dims) {
+                signature += std::to_string(dim) + ",";
+            }
+        }
+        // Clip的min/max输入是图中的常量
+        for (size_t i = float_inputs; i < inputs.size(); ++i) {
+            if (inputs[i] && inputs[i]->GetData() && inputs[i]->GetDataType() == DataType::FLOAT32 &&
+                inputs[i]->GetElementCount() > 0) {
+                signature += ";" + std::to_string(*static_cast<const float*>(inputs[i]->GetData()));
+            }
+        }
+
+        auto& node_graphs = graphs_[node];
+        auto it = node_graphs.find(signature);
+        if (it == node_graphs.end()) {
+            MetalGraph built;
+            if (!BuildGraph(node, op, inputs, float_inputs, output, &built)) {
+                built = MetalGraph();
+            }
+            it = node_graphs.emplace(signature, built).first;
+        }
+        const MetalGraph& metal_graph = it->second;
+        if (!metal_graph.graph) {
+            return Status::Ok();
+        }
+        *handled = true;
+
+        NSMutableDictionary<MPSGraphTensor*, MPSGraphTensorData*>* feeds = [NSMutableDictionary dictionary];
+        const MPSDataType mps_dtype = ToMPSDataType(dtype);
+        for (size_t i = 0; i < float_inputs; ++i) {
+            const Tensor* bound = nullptr;
+            Status status = ResolveInput(node, i, inputs[i], &bound);
+            if (!status.IsOk()) {
+                return status;
+            }
+            feeds[metal_graph.inputs[i]] =
+                [[MPSGraphTensorData alloc] initWithMTLBuffer:BufferOf(bound)
+                                                        shape:ToMPSShape(bound->GetShape().dims)
+                                                     dataType:mps_dtype];
+        }
+        // 输出不在缓冲起始处（例如规划器分配的视图）时先写入暂存张量，完成后拷回
+        Tensor* target = output;
+        if (!BufferOf(output)) {
+            auto& staging = staging_outputs_[node];
+            if (!staging || staging->GetShape().dims != output->GetShape().dims || staging->GetDataType() != dtype) {
+                staging = CreateTensor(output->GetShape(), dtype, DeviceType::METAL);
+            }
+            target = staging.get();
+        }
+        NSDictionary<MPSGraphTensor*, MPSGraphTensorData*>* results = @{
+            metal_graph.output : [[MPSGraphTensorData alloc] initWithMTLBuffer:BufferOf(target)
+                                                                         shape:ToMPSShape(output->GetShape().dims)
+                                                                      dataType:mps_dtype]
+        };
+        MPSGraph* graph = metal_graph.graph;
+        Status status = Encode([graph, feeds, results](MPSCommandBuffer* commands) {
+            [graph encodeToCommandBuffer:commands feeds:feeds targetOperations:nil resultsDictionary:results
+                     executionDescriptor:nil];
+        });
+        if (!status.IsOk() || target == output) {
+            return status;
+        }
+        return RunOnHost([target, output]() {
+            std::memcpy(output->GetData(), target->GetData(), output->GetSizeInBytes());
+            return Status::Ok();
+        });
+    }
+
+    // 跨设备拷贝：统一内存上只是主机拷贝（捕获时排在之前的命令缓冲完成之后）
+    Status ExecuteMemcpy(Node* node) {
+        if (node->GetInputs().size() != 1 || node->GetOutputs().size() != 1 || !node->GetInputs()[0]->GetTensor()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, node->GetOpType() + " requires 1 input and 1 output");
+        }
+        const DeviceType target = node->GetOpType() == "MemcpyToDevice" ? DeviceType::METAL : DeviceType::CPU;
+        auto src = node->GetInputs()[0]->GetTensor();
+        Value* output = node->GetOutputs()[0];
+        auto dst = output->GetTensor();
+        if (!dst || dst->GetDeviceType() != target || dst->GetDataType() != src->GetDataType() ||
+            dst->GetShape().dims != src->GetShape().dims) {
+            dst = CreateTensor(src->GetShape(), src->GetDataType(), target);
+            output->SetTensor(dst);
+        }
+        return RunOnHost([src, dst]() {
+            std::memcpy(dst->GetData(), src->GetData(), src->GetSizeInBytes());
+            return Status::Ok();
+        });
+    }
+
+public:
+    MetalExecutionProvider() {
+        @autoreleasepool {
+            // MPSGraph的encodeToCommandBuffer与池化的ceilMode需要macOS 12 / iOS 15
+            if (@available(macOS 12.0, iOS 15.0, *)) {
+                mtl_device_ = MTLCreateSystemDefaultDevice();
+            }
+            if (!mtl_device_) {
+                return;
+            }
+            queue_ = [mtl_device_ newCommandQueue];
+            if (!queue_) {
+                mtl_device_ = nil;
+                return;
+            }
+            if (![mtl_device_ hasUnifiedMemory]) {
+                LOG_WARNING("Metal device has no unified memory; shared buffers live in system memory");
+            }
+            static std::shared_ptr<MetalAllocator> allocator = std::make_shared<MetalAllocator>(mtl_device_);
+            allocator_ = allocator;
+            device_ = std::make_shared<MetalDevice>(mtl_device_, queue_, allocator_);
+            // 放在Metal上的张量都从共享存储的堆中分配
+            SetMemoryAllocator(DeviceType::METAL, allocator_);
+        }
+    }
+
+    std::string GetName() const override { return "MetalExecutionProvider"; }
+    DeviceType GetDeviceType() const override { return DeviceType::METAL; }
+    bool IsAvailable() const override { return device_ != nullptr; }
+
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        (void)device_id;
+        return device_;
+    }
+
+    int GetDeviceCount() const override { return device_ ? 1 : 0; }
+
+    // MPSGraph覆盖的算子与分区插入的拷贝；形状或属性不适用时在主机上执行
+    bool SupportsOperator(const std::string& op_type) const override {
+        return IsGraphOp(op_type) || op_type == "MemcpyToDevice" || op_type == "MemcpyFromDevice";
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        return OperatorRegistry::Instance().Create(op_type);
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    // 图依赖运行时的输入形状，在第一次执行时构建
+    Status CompileNode(Node* node) override {
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        if (!graph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        graph_inputs_ = std::unordered_set<const Value*>(graph->GetInputs().begin(), graph->GetInputs().end());
+        operators_.clear();
+        graphs_.clear();
+        staging_.clear();
+        staging_outputs_.clear();
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        if (!node || !device_) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null or Metal is unavailable");
+        }
+        @autoreleasepool {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (node->GetOpType() == "MemcpyToDevice" || node->GetOpType() == "MemcpyFromDevice") {
+                return ExecuteMemcpy(node);
+            }
+
+            std::vector<Tensor*> inputs;
+            for (Value* input : node->GetInputs()) {
+                inputs.push_back(input->GetTensor().get());
+            }
+            std::vector<Tensor*> outputs;
+            for (Value* output : node->GetOutputs()) {
+                if (!output->GetTensor()) {
+                    DataType dtype = output->GetDataType() == DataType::UNKNOWN ? DataType::FLOAT32 : output->GetDataType();
+                    output->SetTensor(CreateTensor(output->GetShape(), dtype, DeviceType::METAL));
+                }
+                outputs.push_back(output->GetTensor().get());
+            }
+
+            bool handled = false;
+            Status status = ExecuteGraph(node, inputs, outputs, &handled);
+            if (!status.IsOk() || handled) {
+                return status;
+            }
+
+            // 主机回退：共享存储的缓冲可由主机算子直接读写
+            Operator* op = GetOperator(node);
+            if (!op) {
+                return Status::Error(StatusCode::ERROR_NOT_FOUND, "Failed to create operator: " + node->GetOpType());
+            }
+            return RunOnHost([op, inputs, outputs, ctx]() {
+                return op->Execute(inputs, outputs, ctx);
+            });
+        }
+    }
+
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override {
+        (void)output_index;
+        return node->GetOpType() == "MemcpyFromDevice" ? DeviceType::CPU : DeviceType::METAL;
+    }
+
+    // 整图捕获：执行计划被记录为编码与主机动作的序列，重放时相邻的编码合并进一个命令缓冲
+    bool IsGraphCaptureEnabled() const override { return device_ != nullptr; }
+    bool IsGraphCaptured() const override { return captured_ready_; }
+
+    Status CaptureBegin() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        captured_.clear();
+        captured_ready_ = false;
+        capturing_ = true;
+        return Status::Ok();
+    }
+
+    Status CaptureEnd() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capturing_ = false;
+        captured_ready_ = true;
+        size_t command_buffers = 0;
+        bool in_batch = false;
+        for (const CapturedStep& step : captured_) {
+            if (step.encode && !in_batch) {
+                ++command_buffers;
+            }
+            in_batch = static_cast<bool>(step.encode);
+        }
+        LOG_INFO("Metal plan captured: " + std::to_string(captured_.size()) + " steps in " +
+                 std::to_string(command_buffers) + " command buffers");
+        return Status::Ok();
+    }
+
+    Status ReplayGraph() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!captured_ready_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "No Metal plan captured");
+        }
+        @autoreleasepool {
+            MPSCommandBuffer* commands = nil;
+            for (const CapturedStep& step : captured_) {
+                if (step.encode) {
+                    if (!commands) {
+                        commands = [MPSCommandBuffer commandBufferFromCommandQueue:queue_];
+                    }
+                    step.encode(commands);
+                    continue;
+                }
+                // 主机动作读取之前各图的结果，先提交并等待当前批次
+                if (commands) {
+                    Status status = Commit(commands);
+                    commands = nil;
+                    if (!status.IsOk()) {
+                        return status;
+                    }
+                }
+                Status status = step.host_action();
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            return commands ? Commit(commands) : Status::Ok();
+        }
+    }
+
+    void ResetGraph() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        captured_.clear();
+        captured_ready_ = false;
+        capturing_ = false;
+    }
+};
+
+// 注册Metal执行提供者
+namespace {
+    void RegisterMetalExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("MetalExecutionProvider", []() {
+            return std::make_unique<MetalExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("Metal", []() {
+            return std::make_unique<MetalExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterMetalExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_METAL未定义
+
+namespace inferunity {
+    // Metal未启用时的占位实现
+    // 注册函数为空，不会注册Metal后端
+}
+
+#endif  // INFERUNITY_USE_METAL
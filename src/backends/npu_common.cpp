@@ -0,0 +1,172 @@
+#include "npu_common.h"
+#include "inferunity/logger.h"
+#include "inferunity/quantization.h"
+#include "frontend/onnx_exporter.h"
+#include "core/hash_utils.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace inferunity {
+namespace npu {
+
+namespace {
+
+// NPU写完、CPU读取之前使缓存失效
+void SyncForCpu(const DmaBufRegion& region) {
+    if (region.fd >= 0) {
+        SyncDmaBuf(region.fd, true, false);
+        SyncDmaBuf(region.fd, false, false);
+    }
+}
+
+// CPU写完、交给NPU之前写回缓存
+void SyncForDevice(const DmaBufRegion& region) {
+    if (region.fd >= 0) {
+        SyncDmaBuf(region.fd, true, true);
+        SyncDmaBuf(region.fd, false, true);
+    }
+}
+
+} // namespace
+
+Status ExportSubgraph(const Graph& subgraph, ExportedSubgraph* exported) {
+    Status status = frontend::ExportToONNX(subgraph, &exported->model_bytes);
+    if (!status.IsOk()) {
+        return status;
+    }
+    exported->input_names.clear();
+    exported->output_names.clear();
+    for (const Value* input : subgraph.GetInputs()) {
+        exported->input_names.push_back(CalibrationKey(input));
+    }
+    for (const Value* output : subgraph.GetOutputs()) {
+        exported->output_names.push_back(CalibrationKey(output));
+    }
+    exported->hash = HashBytes(kFnv1aOffsetBasis, exported->model_bytes);
+    return Status::Ok();
+}
+
+std::string ArtifactPath(const std::string& dir, const std::string& prefix, uint64_t hash,
+                         const std::string& extension) {
+    if (dir.empty()) {
+        return std::string();
+    }
+    std::ostringstream path;
+    path << dir << "/" << prefix << "_" << std::hex << std::setw(16) << std::setfill('0') << hash << "." << extension;
+    return path.str();
+}
+
+bool ReadArtifact(const std::string& path, std::string* bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    bytes->assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return !bytes->empty();
+}
+
+bool WriteArtifact(const std::string& path, const std::string& bytes) {
+    const std::string temp_path = path + ".tmp" + std::to_string(reinterpret_cast<uintptr_t>(&bytes));
+    std::ofstream file(temp_path, std::ios::binary);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    file.close();
+    if (file && std::rename(temp_path.c_str(), path.c_str()) == 0) {
+        return true;
+    }
+    std::remove(temp_path.c_str());
+    LOG_WARNING("NPU artifact not cached: " + path);
+    return false;
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        const size_t begin = item.find_first_not_of(" \t");
+        const size_t end = item.find_last_not_of(" \t");
+        if (begin != std::string::npos) {
+            items.push_back(item.substr(begin, end - begin + 1));
+        }
+    }
+    return items;
+}
+
+Status BoundaryBuffer::ReserveStaging(size_t bytes) {
+    if (staging_ && staging_->GetSizeInBytes() >= bytes) {
+        return Status::Ok();
+    }
+    staging_ = CreateTensorWithAllocator(Shape({static_cast<int64_t>(bytes)}), DataType::UINT8,
+                                         DmaBufAllocator::Instance());
+    if (!staging_ || !staging_->GetData()) {
+        staging_.reset();
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate NPU staging buffer");
+    }
+    return Status::Ok();
+}
+
+Status BoundaryBuffer::PrepareInput(const Tensor& tensor, void** data, DmaBufRegion* region) {
+    const size_t bytes = tensor.GetSizeInBytes();
+    if (FindDmaBufRegion(tensor.GetData(), bytes, region)) {
+        *data = const_cast<void*>(tensor.GetData());
+    } else {
+        Status status = ReserveStaging(bytes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::memcpy(staging_->GetData(), tensor.GetData(), bytes);
+        *data = staging_->GetData();
+        if (!FindDmaBufRegion(*data, bytes, region)) {
+            region->fd = -1;
+        }
+    }
+    SyncForDevice(*region);
+    return Status::Ok();
+}
+
+Status BoundaryBuffer::PrepareOutput(Tensor* tensor, const Shape& shape, DataType dtype, void** data,
+                                     DmaBufRegion* region) {
+    if (!tensor->GetData() || tensor->GetDataType() != dtype || tensor->GetShape().dims != shape.dims ||
+        tensor->GetDeviceType() != DeviceType::CPU) {
+        auto shared = CreateTensorWithAllocator(shape, dtype, DmaBufAllocator::Instance());
+        if (!shared || !shared->GetData()) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate NPU output buffer");
+        }
+        *tensor = std::move(*shared);
+    }
+    const size_t bytes = tensor->GetSizeInBytes();
+    output_staged_ = !FindDmaBufRegion(tensor->GetData(), bytes, region);
+    if (output_staged_) {
+        Status status = ReserveStaging(bytes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        *data = staging_->GetData();
+        if (!FindDmaBufRegion(*data, bytes, region)) {
+            region->fd = -1;
+        }
+    } else {
+        *data = tensor->GetData();
+    }
+    return Status::Ok();
+}
+
+Status BoundaryBuffer::FinishOutput(Tensor* tensor) {
+    const size_t bytes = tensor->GetSizeInBytes();
+    DmaBufRegion region;
+    void* source = output_staged_ ? staging_->GetData() : tensor->GetData();
+    if (FindDmaBufRegion(source, bytes, &region)) {
+        SyncForCpu(region);
+    }
+    if (output_staged_) {
+        std::memcpy(tensor->GetData(), source, bytes);
+    }
+    return Status::Ok();
+}
+
+} // namespace npu
+} // namespace inferunity
@@ -0,0 +1,59 @@
+#pragma once
+
+// 移动端NPU提供者（SNPE、Arm NN）共用的部分：认领的子图导出为ONNX后按内容哈希缓存编译产物，
+// 子图边界上的张量经dma-buf与NPU零拷贝交接（见DmaBufAllocator）
+
+#include "inferunity/graph.h"
+#include "inferunity/memory.h"
+#include "inferunity/tensor.h"
+#include "inferunity/types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace npu {
+
+// 导出的子图：输入输出按导出时的张量名（CalibrationKey）绑定
+struct ExportedSubgraph {
+    std::string model_bytes;
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    uint64_t hash = 0;   // model_bytes的64位FNV-1a
+};
+
+Status ExportSubgraph(const Graph& subgraph, ExportedSubgraph* exported);
+
+// 缓存产物的路径：<dir>/<prefix>_<哈希>.<extension>；dir为空时返回空串（不缓存）
+std::string ArtifactPath(const std::string& dir, const std::string& prefix, uint64_t hash,
+                         const std::string& extension);
+
+bool ReadArtifact(const std::string& path, std::string* bytes);
+// 先写临时文件再改名，并发启动的会话不会读到写了一半的产物
+bool WriteArtifact(const std::string& path, const std::string& bytes);
+
+// 逗号分隔的列表（如SessionOptions::snpe_runtimes），去掉空白与空项
+std::vector<std::string> SplitList(const std::string& list);
+
+// 子图边界上的一个张量交给NPU时使用的内存：本身在dma-buf中时直接使用（零拷贝），
+// 否则经由常驻的dma-buf暂存缓冲拷贝。CPU与NPU交接时按需同步dma-buf的缓存
+class BoundaryBuffer {
+public:
+    // 输入：返回交给NPU的地址，*region为其所在的dma-buf（不在dma-buf中时fd为-1）
+    Status PrepareInput(const Tensor& tensor, void** data, DmaBufRegion* region);
+
+    // 输出：张量没有数据或形状/类型不符时直接分配在dma-buf中，之后在CPU上的消费者零拷贝读取；
+    // 已绑定其他内存（如内存规划的arena）时NPU写入暂存缓冲，由FinishOutput拷出
+    Status PrepareOutput(Tensor* tensor, const Shape& shape, DataType dtype, void** data, DmaBufRegion* region);
+    Status FinishOutput(Tensor* tensor);
+
+private:
+    Status ReserveStaging(size_t bytes);
+
+    std::shared_ptr<Tensor> staging_;
+    bool output_staged_ = false;
+};
+
+} // namespace npu
+} // namespace inferunity
@@ -0,0 +1,1329 @@
+// oneDNN执行提供者（x86服务器）
+// 参考ONNX Runtime的DnnlExecutionProvider：认领以Conv/MatMul为主的连通子图（见DelegateClaimedSubgraphs），
+// 子图内的节点编译成oneDNN原语。卷积/矩阵乘之后单一消费者的激活与二元运算折叠成post-op（eltwise、
+// 残差加为sum、与广播常量的运算为binary）；原语的输入输出用format_tag::any，由oneDNN选定分块布局，
+// 子图内相邻原语之间直接传递分块的memory，只在子图边界或布局不一致时插入reorder。
+// 原语按(算子, 形状, 属性, post-op)缓存，常量权重按原语要求的格式只重排一次；每种输入形状编译一份执行计划。
+// 允许BF16计算且CPU支持AVX512-BF16/AMX时浮点子图以BF16执行，QLinearConv/QLinearMatMul以INT8执行，
+// oneDNN在AMX硬件上自动选用tile内核
+
+#include "inferunity/backend.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "delegate_utils.h"
+#include "operators/conv_kernels.h"
+#include "operators/pooling.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_ONEDNN
+#include <dnnl.hpp>
+
+namespace inferunity {
+
+namespace {
+
+using delegate::FloatAttribute;
+using delegate::IntAttribute;
+using delegate::IsComputeOp;
+using delegate::IsConstant;
+using delegate::IsFloat;
+using delegate::IsPoolOp;
+using delegate::IsQuantizedComputeOp;
+
+using dnnl_tag = dnnl::memory::format_tag;
+using dnnl_dt = dnnl::memory::data_type;
+
+constexpr size_t kPrimitiveCacheCapacity = 1024;
+constexpr size_t kMaxPostOps = 8;
+
+bool ToDnnlDataType(DataType dtype, dnnl_dt* out) {
+    switch (dtype) {
+        case DataType::FLOAT32: *out = dnnl_dt::f32; return true;
+        case DataType::BFLOAT16: *out = dnnl_dt::bf16; return true;
+        case DataType::FLOAT16: *out = dnnl_dt::f16; return true;
+        case DataType::INT32: *out = dnnl_dt::s32; return true;
+        case DataType::INT8: *out = dnnl_dt::s8; return true;
+        case DataType::UINT8: *out = dnnl_dt::u8; return true;
+        default: return false;
+    }
+}
+
+dnnl_tag PlainTag(size_t rank) {
+    switch (rank) {
+        case 1: return dnnl_tag::a;
+        case 2: return dnnl_tag::ab;
+        case 3: return dnnl_tag::abc;
+        case 4: return dnnl_tag::abcd;
+        case 5: return dnnl_tag::abcde;
+        case 6: return dnnl_tag::abcdef;
+        default: return dnnl_tag::undef;
+    }
+}
+
+// 标量按[1]描述
+dnnl::memory::dims ToDnnlDims(const std::vector<int64_t>& dims) {
+    return dims.empty() ? dnnl::memory::dims{1} : dnnl::memory::dims(dims.begin(), dims.end());
+}
+
+std::string DimsKey(const std::vector<int64_t>& dims) {
+    std::string key;
+    for (int64_t d : dims) {
+        key += std::to_string(d) + "x";
+    }
+    return key;
+}
+
+bool IsBinaryOp(const std::string& type, dnnl::algorithm* algorithm) {
+    if (type == "Add") {
+        *algorithm = dnnl::algorithm::binary_add;
+    } else if (type == "Sub") {
+        *algorithm = dnnl::algorithm::binary_sub;
+    } else if (type == "Mul") {
+        *algorithm = dnnl::algorithm::binary_mul;
+    } else if (type == "Div") {
+        *algorithm = dnnl::algorithm::binary_div;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool IsEltwiseOp(const Node* node, dnnl::algorithm* algorithm, float* alpha) {
+    const std::string& type = node->GetOpType();
+    *alpha = 0.0f;
+    if (type == "Relu") {
+        *algorithm = dnnl::algorithm::eltwise_relu;
+    } else if (type == "Sigmoid") {
+        *algorithm = dnnl::algorithm::eltwise_logistic;
+    } else if (type == "Tanh") {
+        *algorithm = dnnl::algorithm::eltwise_tanh;
+    } else if (type == "Gelu") {
+        *algorithm = node->GetAttribute("approximate", "none") == "tanh" ? dnnl::algorithm::eltwise_gelu_tanh
+                                                                          : dnnl::algorithm::eltwise_gelu_erf;
+    } else if (type == "Silu") {
+        *algorithm = dnnl::algorithm::eltwise_swish;
+        *alpha = 1.0f;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// INT8对称量化的权重：oneDNN的卷积/矩阵乘不支持权重零点
+bool IsSymmetricInt8Weight(const Value* weight, const Value* zero_point) {
+    if (!IsConstant(weight) || weight->GetDataType() != DataType::INT8 || !IsConstant(zero_point)) {
+        return false;
+    }
+    const Tensor& zp = *zero_point->GetTensor();
+    if (zp.GetDataType() != DataType::INT8 && zp.GetDataType() != DataType::UINT8) {
+        return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(zp.GetData());
+    return std::all_of(data, data + zp.GetElementCount(), [](uint8_t v) { return v == 0; });
+}
+
+std::vector<float> ReadScales(const Tensor& tensor) {
+    const float* data = static_cast<const float*>(tensor.GetData());
+    return std::vector<float>(data, data + tensor.GetElementCount());
+}
+
+int32_t ReadZeroPoint(const Tensor& tensor) {
+    if (tensor.GetDataType() == DataType::UINT8) {
+        return *static_cast<const uint8_t*>(tensor.GetData());
+    }
+    return *static_cast<const int8_t*>(tensor.GetData());
+}
+
+struct CachedPrimitive {
+    dnnl::primitive primitive;
+    dnnl::memory::desc src_md;
+    dnnl::memory::desc weights_md;
+    dnnl::memory::desc dst_md;
+};
+
+// 提供者内各子图共享的oneDNN状态：CPU引擎、原语缓存与重排后的常量权重
+class DnnlContext {
+public:
+    DnnlContext() : engine_(dnnl::engine::kind::cpu, 0) {}
+
+    const dnnl::engine& GetEngine() const { return engine_; }
+    bool UseBF16() const { return bf16_; }
+    void SetUseBF16(bool bf16) { bf16_ = bf16; }
+
+    // 命中时直接返回；未命中时调用create建立原语并缓存，超出容量淘汰最久未用的。create可能抛出dnnl::error
+    CachedPrimitive GetPrimitive(const std::string& key, const std::function<CachedPrimitive()>& create) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = primitives_.find(key);
+            if (it != primitives_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second.second);
+                return it->second.first;
+            }
+        }
+        // 建立原语较慢，不持锁；并发建立同一个键时后来者直接覆盖
+        CachedPrimitive created = create();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = primitives_.find(key);
+        if (it != primitives_.end()) {
+            return it->second.first;
+        }
+        lru_.push_front(key);
+        primitives_.emplace(key, std::make_pair(created, lru_.begin()));
+        if (primitives_.size() > kPrimitiveCacheCapacity) {
+            primitives_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        return created;
+    }
+
+    // 常量权重按原语要求的格式（分块布局、BF16等）重排一次，之后各子图、各执行计划共用
+    dnnl::memory GetWeights(const std::shared_ptr<Tensor>& weights, const dnnl::memory::desc& plain_md,
+                            const dnnl::memory::desc& wanted_md) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WeightEntry& entry = weights_[weights.get()];
+        entry.tensor = weights;
+        for (const auto& version : entry.versions) {
+            if (version.get_desc() == wanted_md) {
+                return version;
+            }
+        }
+        dnnl::memory plain(plain_md, engine_, weights->GetData());
+        dnnl::memory reordered = plain;
+        if (plain_md != wanted_md) {
+            reordered = dnnl::memory(wanted_md, engine_);
+            dnnl::stream stream(engine_);
+            dnnl::reorder(plain, reordered).execute(stream, plain, reordered);
+            stream.wait();
+        }
+        entry.versions.push_back(reordered);
+        return reordered;
+    }
+
+private:
+    // 持有张量，权重的地址在缓存的生命周期内不会被别的张量复用
+    struct WeightEntry {
+        std::shared_ptr<Tensor> tensor;
+        std::vector<dnnl::memory> versions;
+    };
+
+    dnnl::engine engine_;
+    bool bf16_ = false;
+    std::mutex mutex_;
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, std::pair<CachedPrimitive, std::list<std::string>::iterator>> primitives_;
+    std::unordered_map<const Tensor*, WeightEntry> weights_;
+};
+
+// 执行计划中的一步：oneDNN原语，或子图中oneDNN无法表达的节点回退到参考算子（输入输出为普通布局）
+struct DnnlStep {
+    dnnl::primitive primitive;
+    std::unordered_map<int, dnnl::memory> args;
+    Operator* reference = nullptr;
+    std::vector<dnnl::memory> reference_inputs;
+    std::vector<dnnl::memory> reference_outputs;
+    std::vector<Shape> input_shapes;
+    std::vector<Shape> output_shapes;
+    std::vector<DataType> input_dtypes;
+    std::vector<DataType> output_dtypes;
+};
+
+// 一种输入形状的执行计划：边界memory为普通布局，每次运行重设数据指针；aliases是按不同维数
+// 重新描述边界memory的别名（广播的二元运算），随边界一起刷新
+struct DnnlPlan {
+    std::vector<DnnlStep> steps;
+    std::vector<dnnl::memory> inputs;
+    std::vector<dnnl::memory> outputs;
+    std::vector<std::pair<dnnl::memory, dnnl::memory>> aliases;   // (别名, 被别名的memory)
+    std::vector<std::vector<int64_t>> output_dims;
+    std::vector<DataType> output_dtypes;
+};
+
+// post-op链中的一项，binary/sum的operand为另一个操作数
+struct PostOp {
+    enum class Kind { ELTWISE, BINARY, SUM };
+    Kind kind;
+    dnnl::algorithm algorithm;
+    float alpha = 0.0f;
+    Value* operand = nullptr;
+    std::vector<int64_t> operand_dims;   // 左补1到与输出同维
+};
+
+class DnnlSubgraph {
+public:
+    DnnlSubgraph(DnnlContext* context, std::unique_ptr<Graph> graph, size_t max_plans)
+        : context_(context), graph_(std::move(graph)), max_plans_(std::max<size_t>(max_plans, 1)),
+          stream_(context->GetEngine()) {}
+
+    // 为每个节点创建参考算子：形状推断、解析卷积/池化参数以及回退执行都用它
+    Status Initialize() {
+        order_ = graph_->TopologicalSort();
+        for (size_t i = 0; i < order_.size(); ++i) {
+            position_[order_[i]] = i;
+        }
+        for (Node* node : order_) {
+            auto op = OperatorRegistry::Instance().Create(node->GetOpTypeId());
+            if (!op) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Operator not registered: " + node->GetOpType());
+            }
+            ApplyNodeAttributes(*node, op.get());
+            references_[node] = std::move(op);
+        }
+        for (size_t i = 0; i < graph_->GetOutputs().size(); ++i) {
+            output_index_[graph_->GetOutputs()[i]] = i;
+        }
+        return Status::Ok();
+    }
+
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+        if (inputs.size() != graph_->GetInputs().size() || outputs.size() != graph_->GetOutputs().size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "oneDNN subgraph input/output count mismatch");
+        }
+        // 计划中的memory与流不能并发使用
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string signature;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!inputs[i] || (!inputs[i]->GetData() && inputs[i]->GetElementCount() > 0)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "oneDNN subgraph input has no data: " + graph_->GetInputs()[i]->GetName());
+            }
+            signature += DimsKey(inputs[i]->GetShape().dims) + std::to_string(static_cast<int>(inputs[i]->GetDataType())) + ";";
+        }
+        DnnlPlan* plan = nullptr;
+        Status status = GetPlan(signature, inputs, &plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            plan->inputs[i].set_data_handle(inputs[i]->GetData());
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            Tensor* tensor = outputs[i];
+            const std::vector<int64_t>& dims = plan->output_dims[i];
+            if (!tensor->GetData() || tensor->GetDataType() != plan->output_dtypes[i] ||
+                tensor->GetShape().dims != dims || tensor->GetDeviceType() != DeviceType::CPU) {
+                *tensor = Tensor(Shape(dims), plan->output_dtypes[i]);
+            }
+            plan->outputs[i].set_data_handle(tensor->GetData());
+        }
+        for (auto& alias : plan->aliases) {
+            alias.first.set_data_handle(alias.second.get_data_handle());
+        }
+
+        try {
+            for (DnnlStep& step : plan->steps) {
+                if (!step.reference) {
+                    step.primitive.execute(stream_, step.args);
+                    continue;
+                }
+                stream_.wait();
+                status = RunReference(step);
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            stream_.wait();
+        } catch (const dnnl::error& e) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, std::string("oneDNN execution failed: ") + e.what());
+        }
+        return Status::Ok();
+    }
+
+private:
+    // 构建计划期间每个值的状态：dims/dtype为逻辑形状与类型，versions为同一个值在不同格式下的memory，
+    // versions[0]是生产者写出的格式
+    struct ValueState {
+        std::vector<int64_t> dims;
+        DataType dtype = DataType::UNKNOWN;
+        std::vector<dnnl::memory> versions;
+    };
+
+    struct Builder {
+        DnnlPlan* plan;
+        std::unordered_map<const Value*, ValueState> values;
+        std::unordered_set<const Node*> absorbed;           // 已折叠成post-op的节点
+    };
+
+    Status GetPlan(const std::string& signature, const std::vector<Tensor*>& inputs, DnnlPlan** plan) {
+        for (auto it = plans_.begin(); it != plans_.end(); ++it) {
+            if (it->first == signature) {
+                plans_.splice(plans_.begin(), plans_, it);
+                *plan = plans_.front().second.get();
+                return Status::Ok();
+            }
+        }
+        auto built = std::make_unique<DnnlPlan>();
+        Status status = BuildPlan(inputs, built.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+        plans_.emplace_front(signature, std::move(built));
+        if (plans_.size() > max_plans_) {
+            plans_.pop_back();
+        }
+        *plan = plans_.front().second.get();
+        return Status::Ok();
+    }
+
+    Status BuildPlan(const std::vector<Tensor*>& inputs, DnnlPlan* plan) {
+        Builder builder;
+        builder.plan = plan;
+        const dnnl::engine& engine = context_->GetEngine();
+
+        // 边界输入：普通布局，数据指针在运行时设置
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const Value* value = graph_->GetInputs()[i];
+            dnnl_dt dt;
+            if (!ToDnnlDataType(inputs[i]->GetDataType(), &dt)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported oneDNN input type: " + value->GetName());
+            }
+            const std::vector<int64_t>& dims = inputs[i]->GetShape().dims;
+            dnnl::memory memory(dnnl::memory::desc(ToDnnlDims(dims), dt, PlainTag(std::max<size_t>(dims.size(), 1))),
+                                engine, DNNL_MEMORY_NONE);
+            plan->inputs.push_back(memory);
+            ValueState& state = builder.values[value];
+            state.dims = dims;
+            state.dtype = inputs[i]->GetDataType();
+            state.versions.push_back(memory);
+        }
+
+        // 按实际输入形状推断子图内各值的形状
+        for (size_t index = 0; index < order_.size(); ++index) {
+            Node* node = order_[index];
+            std::vector<TensorInfo> infos;
+            for (Value* input : node->GetInputs()) {
+                TensorInfo info;
+                if (IsConstant(input)) {
+                    info.shape = Shape(input->GetTensor()->GetShape().dims);
+                    info.dtype = input->GetTensor()->GetDataType();
+                    info.constant = input->GetTensor().get();
+                } else {
+                    const ValueState& state = builder.values[input];
+                    info.shape = Shape(state.dims);
+                    info.dtype = state.dtype;
+                }
+                infos.push_back(info);
+            }
+            std::vector<TensorInfo> outs;
+            Status status = references_[node]->InferOutputInfo(infos, outs);
+            if (!status.IsOk()) {
+                return status;
+            }
+            for (size_t i = 0; i < node->GetOutputs().size() && i < outs.size(); ++i) {
+                ValueState& state = builder.values[node->GetOutputs()[i]];
+                state.dims = outs[i].shape.dims;
+                state.dtype = outs[i].dtype;
+            }
+        }
+        for (const Value* output : graph_->GetOutputs()) {
+            const ValueState& state = builder.values[output];
+            dnnl_dt dt;
+            if (!ToDnnlDataType(state.dtype, &dt)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported oneDNN output type: " + output->GetName());
+            }
+            plan->outputs.emplace_back(dnnl::memory::desc(ToDnnlDims(state.dims), dt,
+                                                          PlainTag(std::max<size_t>(state.dims.size(), 1))),
+                                       engine, DNNL_MEMORY_NONE);
+            plan->output_dims.push_back(state.dims);
+            plan->output_dtypes.push_back(state.dtype);
+        }
+
+        // 逐节点降级为原语；oneDNN不支持的配置（原语建立失败）回退到参考算子
+        for (size_t index = 0; index < order_.size(); ++index) {
+            Node* node = order_[index];
+            if (builder.absorbed.count(node)) {
+                continue;
+            }
+            Status status;
+            try {
+                status = BuildNode(&builder, node, index);
+            } catch (const dnnl::error& e) {
+                status = Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, e.what());
+            }
+            if (status.Code() == StatusCode::ERROR_NOT_IMPLEMENTED) {
+                LOG_VERBOSE("oneDNN falls back to reference kernel for " + node->GetName() + ": " + status.Message());
+                status = BuildReference(&builder, node);
+            }
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+    Status BuildNode(Builder* builder, Node* node, size_t index) {
+        const std::string& type = node->GetOpType();
+        dnnl::algorithm algorithm;
+        float alpha = 0.0f;
+        if (type == "Conv" || type == "QLinearConv") {
+            return BuildConv(builder, node, index);
+        }
+        if (type == "MatMul" || type == "Gemm" || type == "QLinearMatMul") {
+            return BuildMatMul(builder, node, index);
+        }
+        if (IsEltwiseOp(node, &algorithm, &alpha)) {
+            return BuildEltwise(builder, node, algorithm, alpha);
+        }
+        if (IsBinaryOp(type, &algorithm)) {
+            return BuildBinary(builder, node, algorithm);
+        }
+        if (IsPoolOp(type)) {
+            return BuildPool(builder, node);
+        }
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "No oneDNN lowering for " + type);
+    }
+
+    bool IsSubgraphOutput(const Value* value) const {
+        return output_index_.count(value) > 0;
+    }
+
+    // 值在md格式下的memory：已有该格式的版本时直接复用，否则从已有版本reorder一份（同一个值的多个消费者共用）
+    dnnl::memory GetMemory(Builder* builder, Value* value, const dnnl::memory::desc& md) {
+        ValueState& state = builder->values[value];
+        if (state.versions.empty()) {
+            // 常量：包装张量数据
+            const Tensor& tensor = *value->GetTensor();
+            dnnl_dt dt = dnnl_dt::f32;
+            ToDnnlDataType(tensor.GetDataType(), &dt);
+            state.dims = tensor.GetShape().dims;
+            state.dtype = tensor.GetDataType();
+            state.versions.emplace_back(dnnl::memory::desc(ToDnnlDims(state.dims), dt,
+                                                           PlainTag(std::max<size_t>(state.dims.size(), 1))),
+                                        context_->GetEngine(), const_cast<void*>(tensor.GetData()));
+        }
+        for (const auto& version : state.versions) {
+            if (version.get_desc() == md) {
+                return version;
+            }
+        }
+        dnnl::memory converted(md, context_->GetEngine());
+        AddReorder(builder, state.versions[0], converted);
+        state.versions.push_back(converted);
+        return converted;
+    }
+
+    // 值当前的（生产者写出的）memory
+    dnnl::memory GetMemory(Builder* builder, Value* value) {
+        ValueState& state = builder->values[value];
+        if (state.versions.empty()) {
+            return GetMemory(builder, value, PlainDesc(builder, value, state.dtype));
+        }
+        return state.versions[0];
+    }
+
+    dnnl::memory::desc PlainDesc(Builder* builder, const Value* value, DataType dtype) {
+        const ValueState& state = builder->values[value];
+        const std::vector<int64_t>& dims = IsConstant(value) ? value->GetTensor()->GetShape().dims : state.dims;
+        dnnl_dt dt = dnnl_dt::f32;
+        ToDnnlDataType(dtype, &dt);
+        return dnnl::memory::desc(ToDnnlDims(dims), dt, PlainTag(std::max<size_t>(dims.size(), 1)));
+    }
+
+    void AddReorder(Builder* builder, const dnnl::memory& from, const dnnl::memory& to) {
+        DnnlStep step;
+        step.primitive = dnnl::reorder(from, to);
+        step.args = {{DNNL_ARG_FROM, from}, {DNNL_ARG_TO, to}};
+        builder->plan->steps.push_back(std::move(step));
+    }
+
+    // 生产者要写出md格式的output：子图输出且格式恰为普通布局时直接写进边界memory
+    dnnl::memory AllocateOutput(Builder* builder, const Value* value, const dnnl::memory::desc& md) {
+        auto it = output_index_.find(value);
+        if (it != output_index_.end() && builder->plan->outputs[it->second].get_desc() == md) {
+            return builder->plan->outputs[it->second];
+        }
+        return dnnl::memory(md, context_->GetEngine());
+    }
+
+    // 生产步骤加入计划之后登记输出；写在内部memory上的子图输出再reorder到边界
+    void FinishOutput(Builder* builder, Value* value, const dnnl::memory& memory) {
+        ValueState& state = builder->values[value];
+        state.versions.assign(1, memory);
+        auto it = output_index_.find(value);
+        if (it != output_index_.end()) {
+            const dnnl::memory& boundary = builder->plan->outputs[it->second];
+            if (boundary.get() != memory.get()) {
+                AddReorder(builder, memory, boundary);
+                state.versions.push_back(boundary);
+            }
+        }
+    }
+
+    // operand能否按oneDNN的规则广播到dims：左补1到同维后每一维为1或相等
+    static bool BroadcastsTo(const std::vector<int64_t>& operand, const std::vector<int64_t>& dims,
+                             std::vector<int64_t>* padded) {
+        if (operand.size() > dims.size()) {
+            return false;
+        }
+        padded->assign(dims.size() - operand.size(), 1);
+        padded->insert(padded->end(), operand.begin(), operand.end());
+        for (size_t i = 0; i < dims.size(); ++i) {
+            if ((*padded)[i] != 1 && (*padded)[i] != dims[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 从卷积/矩阵乘的输出起沿单一消费者收集可折叠的激活与二元运算，返回链末端的值
+    Value* CollectPostOps(Builder* builder, Node* anchor, std::vector<PostOp>* post_ops, std::vector<Node*>* chain) {
+        Value* current = anchor->GetOutputs()[0];
+        const std::vector<int64_t> dims = builder->values[current].dims;
+        while (post_ops->size() < kMaxPostOps && !IsSubgraphOutput(current) && current->GetConsumers().size() == 1) {
+            Node* consumer = current->GetConsumers()[0];
+            if (consumer->GetOutputs().size() != 1) {
+                break;
+            }
+            PostOp op;
+            dnnl::algorithm algorithm;
+            float alpha = 0.0f;
+            if (IsEltwiseOp(consumer, &algorithm, &alpha)) {
+                op.kind = PostOp::Kind::ELTWISE;
+                op.algorithm = algorithm;
+                op.alpha = alpha;
+            } else if (IsBinaryOp(consumer->GetOpType(), &algorithm) && consumer->GetInputs().size() == 2) {
+                const auto& inputs = consumer->GetInputs();
+                // Sub/Div只折叠链上的值在左边的情形
+                const bool commutative = algorithm == dnnl::algorithm::binary_add ||
+                                         algorithm == dnnl::algorithm::binary_mul;
+                if (inputs[0] != current && !(commutative && inputs[1] == current)) {
+                    break;
+                }
+                Value* operand = inputs[0] == current ? inputs[1] : inputs[0];
+                if (operand == current) {
+                    break;
+                }
+                const ValueState& operand_state = builder->values[operand];
+                const std::vector<int64_t>& operand_dims =
+                    IsConstant(operand) ? operand->GetTensor()->GetShape().dims : operand_state.dims;
+                const DataType operand_dtype =
+                    IsConstant(operand) ? operand->GetTensor()->GetDataType() : operand_state.dtype;
+                if (operand_dtype != DataType::FLOAT32 || !BroadcastsTo(operand_dims, dims, &op.operand_dims)) {
+                    break;
+                }
+                op.operand = operand;
+                op.algorithm = algorithm;
+                // 残差加：另一项是子图内算出的同形状值时用sum，累加进目标memory
+                op.kind = algorithm == dnnl::algorithm::binary_add && !IsConstant(operand) && operand_dims == dims
+                              ? PostOp::Kind::SUM : PostOp::Kind::BINARY;
+            } else {
+                break;
+            }
+            post_ops->push_back(op);
+            chain->push_back(consumer);
+            current = consumer->GetOutputs()[0];
+        }
+        return current;
+    }
+
+    static dnnl::post_ops MakePostOps(const std::vector<PostOp>& post_ops, std::string* key) {
+        dnnl::post_ops ops;
+        for (const PostOp& op : post_ops) {
+            switch (op.kind) {
+                case PostOp::Kind::ELTWISE:
+                    ops.append_eltwise(op.algorithm, op.alpha, 0.0f);
+                    *key += "|eltwise" + std::to_string(static_cast<int>(op.algorithm)) + ":" + std::to_string(op.alpha);
+                    break;
+                case PostOp::Kind::SUM:
+                    ops.append_sum(1.0f);
+                    *key += "|sum";
+                    break;
+                case PostOp::Kind::BINARY:
+                    ops.append_binary(op.algorithm, dnnl::memory::desc(op.operand_dims, dnnl_dt::f32,
+                                                                       PlainTag(op.operand_dims.size())));
+                    *key += "|binary" + std::to_string(static_cast<int>(op.algorithm)) + ":" + DimsKey(op.operand_dims);
+                    break;
+            }
+        }
+        return ops;
+    }
+
+    // 把post-op的操作数加入执行参数；sum的另一项在原语执行前放进目标memory，
+    // 它在此之后不再被读取且格式一致时直接把它的memory当作目标（残差原地累加）
+    dnnl::memory BindPostOps(Builder* builder, const std::vector<PostOp>& post_ops, const std::vector<Node*>& chain,
+                             size_t index, Value* output, const dnnl::memory::desc& dst_md,
+                             std::unordered_map<int, dnnl::memory>* args) {
+        dnnl::memory dst;
+        for (size_t i = 0; i < post_ops.size(); ++i) {
+            const PostOp& op = post_ops[i];
+            if (op.kind == PostOp::Kind::BINARY) {
+                dnnl::memory operand = GetMemory(builder, op.operand, PlainDesc(builder, op.operand, DataType::FLOAT32));
+                const dnnl::memory::desc padded(op.operand_dims, dnnl_dt::f32, PlainTag(op.operand_dims.size()));
+                if (operand.get_desc() != padded) {
+                    dnnl::memory alias(padded, context_->GetEngine(), operand.get_data_handle());
+                    builder->plan->aliases.emplace_back(alias, operand);
+                    operand = alias;
+                }
+                (*args)[DNNL_ARG_ATTR_MULTIPLE_POST_OP(static_cast<int>(i)) | DNNL_ARG_SRC_1] = operand;
+            } else if (op.kind == PostOp::Kind::SUM) {
+                ValueState& addend = builder->values[op.operand];
+                bool last_use = true;
+                for (const Node* consumer : op.operand->GetConsumers()) {
+                    last_use = last_use && (position_[consumer] < index ||
+                                            std::find(chain.begin(), chain.end(), consumer) != chain.end());
+                }
+                if (last_use && !IsSubgraphOutput(op.operand) && !IsSubgraphOutput(output) &&
+                    !addend.versions.empty() && addend.versions[0].get_desc() == dst_md &&
+                    !IsBoundary(builder, addend.versions[0])) {
+                    dst = addend.versions[0];
+                } else {
+                    dst = AllocateOutput(builder, output, dst_md);
+                    AddReorder(builder, GetMemory(builder, op.operand), dst);
+                }
+            }
+        }
+        return dst ? dst : AllocateOutput(builder, output, dst_md);
+    }
+
+    bool IsBoundary(Builder* builder, const dnnl::memory& memory) const {
+        for (const auto& input : builder->plan->inputs) {
+            if (input.get() == memory.get()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Status BuildConv(Builder* builder, Node* node, size_t index) {
+        const bool quantized = node->GetOpType() == "QLinearConv";
+        const auto& inputs = node->GetInputs();
+        Value* x = inputs[0];
+        Value* w = inputs[quantized ? 3 : 1];
+        Value* b = quantized ? (inputs.size() > 8 ? inputs[8] : nullptr) : (inputs.size() > 2 ? inputs[2] : nullptr);
+        const ValueState& x_state = builder->values[x];
+        const Tensor& weight = *w->GetTensor();
+
+        operators::Conv2DParams p;
+        Status status = operators::ParseConv2DParams(*references_[node], Shape(x_state.dims), weight.GetShape(), &p);
+        if (!status.IsOk()) {
+            return status;
+        }
+
+        std::vector<PostOp> post_ops;
+        std::vector<Node*> chain;
+        Value* output = quantized ? node->GetOutputs()[0] : CollectPostOps(builder, node, &post_ops, &chain);
+
+        dnnl_dt src_dt = context_->UseBF16() ? dnnl_dt::bf16 : dnnl_dt::f32;
+        dnnl_dt wei_dt = src_dt;
+        dnnl_dt dst_dt = src_dt;
+        std::vector<float> src_scale, wei_scale, dst_scale;
+        int32_t src_zp = 0, dst_zp = 0;
+        if (quantized) {
+            src_dt = x_state.dtype == DataType::UINT8 ? dnnl_dt::u8 : dnnl_dt::s8;
+            wei_dt = dnnl_dt::s8;
+            dst_dt = builder->values[output].dtype == DataType::UINT8 ? dnnl_dt::u8 : dnnl_dt::s8;
+            src_scale = ReadScales(*inputs[1]->GetTensor());
+            src_zp = ReadZeroPoint(*inputs[2]->GetTensor());
+            wei_scale = ReadScales(*inputs[4]->GetTensor());
+            dst_scale = ReadScales(*inputs[6]->GetTensor());
+            dst_zp = ReadZeroPoint(*inputs[7]->GetTensor());
+        }
+
+        const dnnl::memory::dims src_dims{p.batch, p.in_c, p.in_h, p.in_w};
+        const dnnl::memory::dims dst_dims{p.batch, p.out_c, p.out_h, p.out_w};
+        dnnl::memory::dims wei_dims{p.out_c, p.in_c / p.group, p.kernel_h, p.kernel_w};
+        dnnl_tag wei_tag = dnnl_tag::oihw;
+        if (p.group > 1) {
+            wei_dims = {p.group, p.out_c / p.group, p.in_c / p.group, p.kernel_h, p.kernel_w};
+            wei_tag = dnnl_tag::goihw;
+        }
+        const dnnl::memory::dims strides{p.stride_h, p.stride_w};
+        const dnnl::memory::dims dilates{p.dilation_h - 1, p.dilation_w - 1};
+        const dnnl::memory::dims pad_l{p.pad_top, p.pad_left};
+        const dnnl::memory::dims pad_r{p.pad_bottom, p.pad_right};
+        const int wei_mask = wei_scale.size() > 1 ? (p.group > 1 ? 3 : 1) : 0;
+
+        std::string key = node->GetOpType() + "|" + DimsKey(src_dims) + "|" + DimsKey(wei_dims) + "|" +
+                          DimsKey(strides) + DimsKey(dilates) + DimsKey(pad_l) + DimsKey(pad_r) + "|" +
+                          std::to_string(static_cast<int>(src_dt)) + std::to_string(static_cast<int>(dst_dt)) +
+                          (b ? "|bias" : "") + "|mask" + std::to_string(wei_mask) + (src_zp ? "|src_zp" : "") +
+                          (dst_zp ? "|dst_zp" : "");
+        const dnnl::post_ops ops = MakePostOps(post_ops, &key);
+        const dnnl::engine& engine = context_->GetEngine();
+        CachedPrimitive cached = context_->GetPrimitive(key, [&]() {
+            dnnl::primitive_attr attr;
+            attr.set_post_ops(ops);
+            if (quantized) {
+                attr.set_scales_mask(DNNL_ARG_SRC, 0);
+                attr.set_scales_mask(DNNL_ARG_WEIGHTS, wei_mask);
+                attr.set_scales_mask(DNNL_ARG_DST, 0);
+                if (src_zp) {
+                    attr.set_zero_points_mask(DNNL_ARG_SRC, 0);
+                }
+                if (dst_zp) {
+                    attr.set_zero_points_mask(DNNL_ARG_DST, 0);
+                }
+            }
+            const dnnl::memory::desc src_md(src_dims, src_dt, dnnl_tag::any);
+            const dnnl::memory::desc wei_md(wei_dims, wei_dt, dnnl_tag::any);
+            const dnnl::memory::desc dst_md(dst_dims, dst_dt, dnnl_tag::any);
+            dnnl::convolution_forward::primitive_desc pd =
+                b ? dnnl::convolution_forward::primitive_desc(
+                        engine, dnnl::prop_kind::forward_inference, dnnl::algorithm::convolution_direct, src_md, wei_md,
+                        dnnl::memory::desc({p.out_c}, dnnl_dt::f32, dnnl_tag::a), dst_md, strides, dilates, pad_l, pad_r, attr)
+                  : dnnl::convolution_forward::primitive_desc(
+                        engine, dnnl::prop_kind::forward_inference, dnnl::algorithm::convolution_direct, src_md, wei_md,
+                        dst_md, strides, dilates, pad_l, pad_r, attr);
+            return CachedPrimitive{dnnl::convolution_forward(pd), pd.src_desc(), pd.weights_desc(), pd.dst_desc()};
+        });
+
+        DnnlStep step;
+        step.primitive = cached.primitive;
+        step.args[DNNL_ARG_SRC] = GetMemory(builder, x, cached.src_md);
+        step.args[DNNL_ARG_WEIGHTS] = context_->GetWeights(w->GetTensor(), dnnl::memory::desc(wei_dims, wei_dt, wei_tag),
+                                                           cached.weights_md);
+        if (b) {
+            step.args[DNNL_ARG_BIAS] = quantized ? MakeQuantizedBias(*b->GetTensor(), src_scale[0], wei_scale)
+                                                 : GetMemory(builder, b, dnnl::memory::desc({p.out_c}, dnnl_dt::f32, dnnl_tag::a));
+        }
+        if (quantized) {
+            BindQuantization(src_scale, wei_scale, dst_scale, src_zp, dst_zp, &step.args);
+        }
+        dnnl::memory dst = BindPostOps(builder, post_ops, chain, index, output, cached.dst_md, &step.args);
+        step.args[DNNL_ARG_DST] = dst;
+        builder->plan->steps.push_back(std::move(step));
+        builder->absorbed.insert(chain.begin(), chain.end());
+        FinishOutput(builder, output, dst);
+        return Status::Ok();
+    }
+
+    // A为[..., M, K]，B为常量[K, N]（Gemm的transB为[N, K]）；B左补1到与A同维
+    Status BuildMatMul(Builder* builder, Node* node, size_t index) {
+        const std::string& type = node->GetOpType();
+        const bool quantized = type == "QLinearMatMul";
+        const auto& inputs = node->GetInputs();
+        Value* a = inputs[0];
+        Value* b = inputs[quantized ? 3 : 1];
+        Value* c = type == "Gemm" && inputs.size() > 2 ? inputs[2] : nullptr;
+        const ValueState& a_state = builder->values[a];
+        const std::vector<int64_t>& b_dims = b->GetTensor()->GetShape().dims;
+        const bool trans_b = type == "Gemm" && IntAttribute(node, "transB", 0) != 0;
+        if (a_state.dims.size() < 2 || b_dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "oneDNN MatMul expects a constant 2-D weight");
+        }
+        const size_t rank = a_state.dims.size();
+        const int64_t k = trans_b ? b_dims[1] : b_dims[0];
+        const int64_t n = trans_b ? b_dims[0] : b_dims[1];
+        if (a_state.dims.back() != k) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMul inner dimensions mismatch: " + node->GetName());
+        }
+
+        std::vector<PostOp> post_ops;
+        std::vector<Node*> chain;
+        Value* output = quantized ? node->GetOutputs()[0] : CollectPostOps(builder, node, &post_ops, &chain);
+
+        dnnl_dt src_dt = context_->UseBF16() ? dnnl_dt::bf16 : dnnl_dt::f32;
+        dnnl_dt wei_dt = src_dt;
+        dnnl_dt dst_dt = src_dt;
+        std::vector<float> src_scale, wei_scale, dst_scale;
+        int32_t src_zp = 0, dst_zp = 0;
+        if (quantized) {
+            src_dt = a_state.dtype == DataType::UINT8 ? dnnl_dt::u8 : dnnl_dt::s8;
+            wei_dt = dnnl_dt::s8;
+            dst_dt = builder->values[output].dtype == DataType::UINT8 ? dnnl_dt::u8 : dnnl_dt::s8;
+            src_scale = ReadScales(*inputs[1]->GetTensor());
+            src_zp = ReadZeroPoint(*inputs[2]->GetTensor());
+            wei_scale = ReadScales(*inputs[4]->GetTensor());
+            dst_scale = ReadScales(*inputs[6]->GetTensor());
+            dst_zp = ReadZeroPoint(*inputs[7]->GetTensor());
+        }
+
+        const dnnl::memory::dims src_dims(a_state.dims.begin(), a_state.dims.end());
+        dnnl::memory::dims wei_dims(rank - 2, 1);
+        wei_dims.push_back(k);
+        wei_dims.push_back(n);
+        dnnl::memory::dims dst_dims = src_dims;
+        dst_dims.back() = n;
+        dnnl::memory::dims bias_dims(rank - 1, 1);
+        bias_dims.push_back(n);
+        // 权重的原始布局：普通[K, N]，transB时按步长描述[N, K]的转置
+        dnnl::memory::dims wei_strides(rank, k * n);
+        wei_strides[rank - 2] = trans_b ? 1 : n;
+        wei_strides[rank - 1] = trans_b ? k : 1;
+        const dnnl::memory::desc wei_plain_md(wei_dims, wei_dt, wei_strides);
+        if (c && c->GetTensor()->GetElementCount() != static_cast<size_t>(n)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "oneDNN Gemm expects a per-column bias");
+        }
+        const int wei_mask = wei_scale.size() > 1 ? 1 << (rank - 1) : 0;
+
+        std::string key = type + "|" + DimsKey(src_dims) + "|" + DimsKey(wei_dims) + (trans_b ? "T" : "") + "|" +
+                          std::to_string(static_cast<int>(src_dt)) + std::to_string(static_cast<int>(dst_dt)) +
+                          (c ? "|bias" : "") + "|mask" + std::to_string(wei_mask) + (src_zp ? "|src_zp" : "") +
+                          (dst_zp ? "|dst_zp" : "");
+        const dnnl::post_ops ops = MakePostOps(post_ops, &key);
+        const dnnl::engine& engine = context_->GetEngine();
+        const dnnl::memory::desc bias_md(bias_dims, dnnl_dt::f32, PlainTag(rank));
+        CachedPrimitive cached = context_->GetPrimitive(key, [&]() {
+            dnnl::primitive_attr attr;
+            attr.set_post_ops(ops);
+            if (quantized) {
+                attr.set_scales_mask(DNNL_ARG_SRC, 0);
+                attr.set_scales_mask(DNNL_ARG_WEIGHTS, wei_mask);
+                attr.set_scales_mask(DNNL_ARG_DST, 0);
+                if (src_zp) {
+                    attr.set_zero_points_mask(DNNL_ARG_SRC, 0);
+                }
+                if (dst_zp) {
+                    attr.set_zero_points_mask(DNNL_ARG_DST, 0);
+                }
+            }
+            const dnnl::memory::desc src_md(src_dims, src_dt, PlainTag(rank));
+            const dnnl::memory::desc wei_md(wei_dims, wei_dt, dnnl_tag::any);
+            const dnnl::memory::desc dst_md(dst_dims, dst_dt, PlainTag(rank));
+            dnnl::matmul::primitive_desc pd = c ? dnnl::matmul::primitive_desc(engine, src_md, wei_md, bias_md, dst_md, attr)
+                                                : dnnl::matmul::primitive_desc(engine, src_md, wei_md, dst_md, attr);
+            return CachedPrimitive{dnnl::matmul(pd), pd.src_desc(), pd.weights_desc(), pd.dst_desc()};
+        });
+
+        DnnlStep step;
+        step.primitive = cached.primitive;
+        step.args[DNNL_ARG_SRC] = GetMemory(builder, a, cached.src_md);
+        step.args[DNNL_ARG_WEIGHTS] = context_->GetWeights(b->GetTensor(), wei_plain_md, cached.weights_md);
+        if (c) {
+            dnnl::memory bias = GetMemory(builder, c, PlainDesc(builder, c, DataType::FLOAT32));
+            dnnl::memory alias(bias_md, context_->GetEngine(), bias.get_data_handle());
+            step.args[DNNL_ARG_BIAS] = alias;
+        }
+        if (quantized) {
+            BindQuantization(src_scale, wei_scale, dst_scale, src_zp, dst_zp, &step.args);
+        }
+        dnnl::memory dst = BindPostOps(builder, post_ops, chain, index, output, cached.dst_md, &step.args);
+        step.args[DNNL_ARG_DST] = dst;
+        builder->plan->steps.push_back(std::move(step));
+        builder->absorbed.insert(chain.begin(), chain.end());
+        FinishOutput(builder, output, dst);
+        return Status::Ok();
+    }
+
+    // oneDNN v3的量化参数在运行时以memory传入：dst = (src_scale * wei_scale * acc + bias) / dst_scale + dst_zp
+    void BindQuantization(const std::vector<float>& src_scale, const std::vector<float>& wei_scale,
+                          const std::vector<float>& dst_scale, int32_t src_zp, int32_t dst_zp,
+                          std::unordered_map<int, dnnl::memory>* args) {
+        (*args)[DNNL_ARG_ATTR_SCALES | DNNL_ARG_SRC] = MakeOwned(src_scale);
+        (*args)[DNNL_ARG_ATTR_SCALES | DNNL_ARG_WEIGHTS] = MakeOwned(wei_scale);
+        (*args)[DNNL_ARG_ATTR_SCALES | DNNL_ARG_DST] = MakeOwned(dst_scale);
+        if (src_zp) {
+            (*args)[DNNL_ARG_ATTR_ZERO_POINTS | DNNL_ARG_SRC] = MakeOwned(std::vector<int32_t>{src_zp});
+        }
+        if (dst_zp) {
+            (*args)[DNNL_ARG_ATTR_ZERO_POINTS | DNNL_ARG_DST] = MakeOwned(std::vector<int32_t>{dst_zp});
+        }
+    }
+
+    // QLinearConv的INT32偏置以input_scale * weight_scale为单位，oneDNN的偏置在缩放之后以FP32加上
+    dnnl::memory MakeQuantizedBias(const Tensor& bias, float src_scale, const std::vector<float>& wei_scale) {
+        const int32_t* data = static_cast<const int32_t*>(bias.GetData());
+        std::vector<float> converted(bias.GetElementCount());
+        for (size_t c = 0; c < converted.size(); ++c) {
+            converted[c] = static_cast<float>(data[c]) * src_scale * wei_scale[wei_scale.size() > 1 ? c : 0];
+        }
+        return MakeOwned(converted);
+    }
+
+    dnnl::memory MakeOwned(const std::vector<float>& values) {
+        dnnl::memory memory(dnnl::memory::desc({static_cast<int64_t>(values.size())}, dnnl_dt::f32, dnnl_tag::a),
+                            context_->GetEngine());
+        std::copy(values.begin(), values.end(), static_cast<float*>(memory.get_data_handle()));
+        return memory;
+    }
+
+    dnnl::memory MakeOwned(const std::vector<int32_t>& values) {
+        dnnl::memory memory(dnnl::memory::desc({static_cast<int64_t>(values.size())}, dnnl_dt::s32, dnnl_tag::a),
+                            context_->GetEngine());
+        std::copy(values.begin(), values.end(), static_cast<int32_t*>(memory.get_data_handle()));
+        return memory;
+    }
+
+    // 逐元素激活沿用输入的格式，分块布局在卷积之间继续传递
+    Status BuildEltwise(Builder* builder, Node* node, dnnl::algorithm algorithm, float alpha) {
+        dnnl::memory src = GetMemory(builder, node->GetInputs()[0]);
+        const dnnl::memory::desc md = src.get_desc();
+        Value* output = node->GetOutputs()[0];
+        auto pd = dnnl::eltwise_forward::primitive_desc(context_->GetEngine(), dnnl::prop_kind::forward_inference,
+                                                        algorithm, md, md, alpha, 0.0f);
+        DnnlStep step;
+        step.primitive = dnnl::eltwise_forward(pd);
+        dnnl::memory dst = AllocateOutput(builder, output, md);
+        step.args = {{DNNL_ARG_SRC, src}, {DNNL_ARG_DST, dst}};
+        builder->plan->steps.push_back(std::move(step));
+        FinishOutput(builder, output, dst);
+        return Status::Ok();
+    }
+
+    // 第一个操作数与输出同形状时沿用它的格式，第二个操作数按普通布局左补1广播；
+    // Add/Mul在第一个操作数被广播时交换操作数
+    Status BuildBinary(Builder* builder, Node* node, dnnl::algorithm algorithm) {
+        const auto& inputs = node->GetInputs();
+        if (inputs.size() != 2) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Binary op expects 2 inputs");
+        }
+        Value* output = node->GetOutputs()[0];
+        const std::vector<int64_t> dims = builder->values[output].dims;
+        Value* lhs = inputs[0];
+        Value* rhs = inputs[1];
+        auto dims_of = [&](Value* value) {
+            return IsConstant(value) ? value->GetTensor()->GetShape().dims : builder->values[value].dims;
+        };
+        if (dims_of(lhs) != dims && (algorithm == dnnl::algorithm::binary_add ||
+                                     algorithm == dnnl::algorithm::binary_mul)) {
+            std::swap(lhs, rhs);
+        }
+        std::vector<int64_t> rhs_dims;
+        if (dims_of(lhs) != dims || !BroadcastsTo(dims_of(rhs), dims, &rhs_dims) || dims.empty()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported broadcast for oneDNN binary");
+        }
+        dnnl::memory src0 = GetMemory(builder, lhs);
+        dnnl::memory src1 = GetMemory(builder, rhs, PlainDesc(builder, rhs, builder->values[output].dtype));
+        const dnnl::memory::desc src1_md(rhs_dims, src1.get_desc().get_data_type(), PlainTag(rhs_dims.size()));
+        if (src1.get_desc() != src1_md) {
+            dnnl::memory alias(src1_md, context_->GetEngine(), src1.get_data_handle());
+            builder->plan->aliases.emplace_back(alias, src1);
+            src1 = alias;
+        }
+        const dnnl::memory::desc dst_md = src0.get_desc();
+        auto pd = dnnl::binary::primitive_desc(context_->GetEngine(), algorithm, dst_md, src1_md, dst_md);
+        DnnlStep step;
+        step.primitive = dnnl::binary(pd);
+        dnnl::memory dst = AllocateOutput(builder, output, dst_md);
+        step.args = {{DNNL_ARG_SRC_0, src0}, {DNNL_ARG_SRC_1, src1}, {DNNL_ARG_DST, dst}};
+        builder->plan->steps.push_back(std::move(step));
+        FinishOutput(builder, output, dst);
+        return Status::Ok();
+    }
+
+    // ceil_mode按多出的输出行列折算为右侧/下侧的padding
+    Status BuildPool(Builder* builder, Node* node) {
+        Value* input = node->GetInputs()[0];
+        Value* output = node->GetOutputs()[0];
+        if (node->GetOutputs().size() != 1) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "MaxPool indices are not supported by oneDNN");
+        }
+        const std::vector<int64_t>& in_dims = builder->values[input].dims;
+        if (in_dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "oneDNN pooling expects NCHW input");
+        }
+        const std::string& type = node->GetOpType();
+        operators::Pool2DParams p;
+        if (type == "GlobalAveragePool") {
+            p.batch = in_dims[0];
+            p.channels = in_dims[1];
+            p.in_h = in_dims[2];
+            p.in_w = in_dims[3];
+            p.kernel_h = p.in_h;
+            p.kernel_w = p.in_w;
+            p.stride_h = p.stride_w = 1;
+            p.out_h = p.out_w = 1;
+        } else {
+            Status status = operators::ParsePool2DParams(*references_[node], Shape(in_dims), &p);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        const dnnl::memory::dims strides{p.stride_h, p.stride_w};
+        const dnnl::memory::dims kernel{p.kernel_h, p.kernel_w};
+        const dnnl::memory::dims pad_l{p.pad_top, p.pad_left};
+        const dnnl::memory::dims pad_r{(p.out_h - 1) * p.stride_h + p.kernel_h - p.in_h - p.pad_top,
+                                       (p.out_w - 1) * p.stride_w + p.kernel_w - p.in_w - p.pad_left};
+        const dnnl::algorithm algorithm = type == "MaxPool" ? dnnl::algorithm::pooling_max
+                                          : p.count_include_pad ? dnnl::algorithm::pooling_avg_include_padding
+                                                                : dnnl::algorithm::pooling_avg_exclude_padding;
+        dnnl::memory src = GetMemory(builder, input);
+        const dnnl::memory::desc dst_md({p.batch, p.channels, p.out_h, p.out_w}, src.get_desc().get_data_type(),
+                                        dnnl_tag::any);
+        auto pd = dnnl::pooling_forward::primitive_desc(context_->GetEngine(), dnnl::prop_kind::forward_inference,
+                                                        algorithm, src.get_desc(), dst_md, strides, kernel,
+                                                        dnnl::memory::dims{0, 0}, pad_l, pad_r);
+        DnnlStep step;
+        step.primitive = dnnl::pooling_forward(pd);
+        dnnl::memory dst = AllocateOutput(builder, output, pd.dst_desc());
+        step.args = {{DNNL_ARG_SRC, src}, {DNNL_ARG_DST, dst}};
+        builder->plan->steps.push_back(std::move(step));
+        FinishOutput(builder, output, dst);
+        return Status::Ok();
+    }
+
+    // 回退：输入按逻辑类型reorder成普通布局，参考算子在包装计划memory的张量上执行
+    Status BuildReference(Builder* builder, Node* node) {
+        DnnlStep step;
+        step.reference = references_[node].get();
+        for (Value* input : node->GetInputs()) {
+            ValueState& state = builder->values[input];
+            const DataType dtype = IsConstant(input) ? input->GetTensor()->GetDataType() : state.dtype;
+            dnnl_dt dt;
+            if (!ToDnnlDataType(dtype, &dt)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported type in oneDNN subgraph: " + node->GetName());
+            }
+            step.reference_inputs.push_back(GetMemory(builder, input, PlainDesc(builder, input, dtype)));
+            step.input_shapes.push_back(IsConstant(input) ? input->GetTensor()->GetShape() : Shape(state.dims));
+            step.input_dtypes.push_back(dtype);
+        }
+        std::vector<std::pair<Value*, dnnl::memory>> produced;
+        for (Value* output : node->GetOutputs()) {
+            const ValueState& state = builder->values[output];
+            dnnl_dt dt;
+            if (!ToDnnlDataType(state.dtype, &dt)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported type in oneDNN subgraph: " + node->GetName());
+            }
+            dnnl::memory memory = AllocateOutput(builder, output, PlainDesc(builder, output, state.dtype));
+            step.reference_outputs.push_back(memory);
+            step.output_shapes.push_back(Shape(state.dims));
+            step.output_dtypes.push_back(state.dtype);
+            produced.emplace_back(output, memory);
+        }
+        builder->plan->steps.push_back(std::move(step));
+        for (auto& entry : produced) {
+            FinishOutput(builder, entry.first, entry.second);
+        }
+        return Status::Ok();
+    }
+
+    Status RunReference(DnnlStep& step) {
+        std::vector<Tensor> tensors;
+        tensors.reserve(step.reference_inputs.size() + step.reference_outputs.size());
+        std::vector<Tensor*> inputs;
+        std::vector<Tensor*> outputs;
+        for (size_t i = 0; i < step.reference_inputs.size(); ++i) {
+            tensors.emplace_back(step.input_shapes[i], step.input_dtypes[i], step.reference_inputs[i].get_data_handle());
+            inputs.push_back(&tensors.back());
+        }
+        for (size_t i = 0; i < step.reference_outputs.size(); ++i) {
+            tensors.emplace_back(step.output_shapes[i], step.output_dtypes[i], step.reference_outputs[i].get_data_handle());
+            outputs.push_back(&tensors.back());
+        }
+        ExecutionContext ctx(DeviceType::CPU);
+        return step.reference->Execute(inputs, outputs, &ctx);
+    }
+
+    DnnlContext* context_;
+    std::unique_ptr<Graph> graph_;
+    size_t max_plans_;
+    std::vector<Node*> order_;
+    std::unordered_map<const Node*, size_t> position_;   // 节点在order_中的位置
+    std::unordered_map<const Node*, std::unique_ptr<Operator>> references_;
+    std::unordered_map<const Value*, size_t> output_index_;
+    std::list<std::pair<std::string, std::unique_ptr<DnnlPlan>>> plans_;   // 表头最近使用
+    dnnl::stream stream_;
+    std::mutex mutex_;
+};
+
+} // namespace
+
+class OneDNNExecutionProvider : public ExecutionProvider {
+public:
+    OneDNNExecutionProvider()
+        : host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")),
+          context_(std::make_unique<DnnlContext>()) {}
+
+    ~OneDNNExecutionProvider() override {
+        // 子图的流与memory先于引擎释放
+        subgraphs_.clear();
+    }
+
+    std::string GetName() const override {
+        return "OneDNNExecutionProvider";
+    }
+
+    DeviceType GetDeviceType() const override {
+        return DeviceType::CPU;
+    }
+
+    bool IsAvailable() const override {
+        return dnnl::engine::get_count(dnnl::engine::kind::cpu) > 0;
+    }
+
+    // 与CPU提供者共用主机设备，子图边界上不需要拷贝
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
+    }
+
+    int GetDeviceCount() const override {
+        return 1;
+    }
+
+    // allow_bf16_compute且CPU有AVX512-BF16或AMX-BF16时浮点子图以BF16执行
+    Status ConfigureSession(const SessionOptions& options) override {
+        const CpuFeatures& features = GetCpuFeatures();
+        context_->SetUseBF16(options.allow_bf16_compute && (features.avx512_bf16 || features.amx_bf16));
+        max_plans_ = options.max_shape_specialized_plans;
+        return Status::Ok();
+    }
+
+    // 逐节点的算子由CPU提供者执行；oneDNN只执行认领的子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        // post-op融合与布局选择在编译子图时完成
+        (void)graph;
+        return Status::Ok();
+    }
+
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    bool SupportsSubgraphCompilation() const override { return true; }
+    bool ClaimsSubgraphs() const override { return true; }
+
+    // FP32的卷积/矩阵乘（权重为常量）、它们之后的激活/二元运算/池化，以及权重为对称INT8的QLinearConv/QLinearMatMul
+    bool CanCompileNode(const Node* node) const override {
+        if (!node) {
+            return false;
+        }
+        const std::string& type = node->GetOpType();
+        const auto& inputs = node->GetInputs();
+        dnnl::algorithm algorithm;
+        float alpha = 0.0f;
+        if (type == "Conv") {
+            return inputs.size() >= 2 && IsFloat(inputs[0]) && IsConstant(inputs[1]) && IsFloat(inputs[1]) &&
+                   inputs[1]->GetTensor()->GetShape().dims.size() == 4 &&
+                   (inputs.size() < 3 || (IsConstant(inputs[2]) && IsFloat(inputs[2])));
+        }
+        if (type == "MatMul") {
+            return inputs.size() == 2 && IsFloat(inputs[0]) && IsConstant(inputs[1]) && IsFloat(inputs[1]) &&
+                   inputs[1]->GetTensor()->GetShape().dims.size() == 2;
+        }
+        if (type == "Gemm") {
+            return inputs.size() >= 2 && IsFloat(inputs[0]) && IsConstant(inputs[1]) && IsFloat(inputs[1]) &&
+                   inputs[1]->GetTensor()->GetShape().dims.size() == 2 && IntAttribute(node, "transA", 0) == 0 &&
+                   FloatAttribute(node, "alpha", 1.0f) == 1.0f && FloatAttribute(node, "beta", 1.0f) == 1.0f &&
+                   (inputs.size() < 3 || (IsConstant(inputs[2]) && IsFloat(inputs[2])));
+        }
+        if (type == "QLinearConv" || type == "QLinearMatMul") {
+            if (inputs.size() < 8) {
+                return false;
+            }
+            for (size_t i = 1; i < inputs.size(); ++i) {
+                if (!IsConstant(inputs[i])) {
+                    return false;
+                }
+            }
+            const size_t weight_rank = type == "QLinearConv" ? 4 : 2;
+            return IsSymmetricInt8Weight(inputs[3], inputs[5]) &&
+                   inputs[3]->GetTensor()->GetShape().dims.size() == weight_rank &&
+                   inputs[1]->GetTensor()->GetElementCount() == 1 && inputs[6]->GetTensor()->GetElementCount() == 1 &&
+                   (inputs.size() < 9 || inputs[8]->GetDataType() == DataType::INT32);
+        }
+        if (IsEltwiseOp(node, &algorithm, &alpha)) {
+            return inputs.size() == 1 && IsFloat(inputs[0]);
+        }
+        if (IsBinaryOp(type, &algorithm)) {
+            return inputs.size() == 2 && IsFloat(inputs[0]) && IsFloat(inputs[1]);
+        }
+        if (IsPoolOp(type)) {
+            return inputs.size() == 1 && node->GetOutputs().size() == 1 && IsFloat(inputs[0]);
+        }
+        return false;
+    }
+
+    // 只接管含卷积/矩阵乘的子图：纯逐元素的子图在边界上的重排抵不过收益，留给CPU提供者
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        const auto& nodes = subgraph->GetNodes();
+        if (std::none_of(nodes.begin(), nodes.end(), [](const std::unique_ptr<Node>& node) {
+                return IsComputeOp(node->GetOpType()) || IsQuantizedComputeOp(node->GetOpType());
+            })) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Subgraph has no Conv/MatMul for oneDNN");
+        }
+        auto compiled = std::make_unique<DnnlSubgraph>(context_.get(), std::move(subgraph), max_plans_);
+        Status status = compiled->Initialize();
+        if (!status.IsOk()) {
+            return status;
+        }
+        subgraphs_[fused_node] = std::move(compiled);
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "oneDNN backend only executes claimed subgraphs: " + node->GetOpType());
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Claimed subgraph input has no tensor: " + input->GetName());
+            }
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs);
+    }
+
+private:
+    std::unique_ptr<ExecutionProvider> host_provider_;
+    std::unique_ptr<DnnlContext> context_;
+    size_t max_plans_ = 8;
+    std::unordered_map<Node*, std::unique_ptr<DnnlSubgraph>> subgraphs_;
+};
+
+// 注册oneDNN执行提供者
+namespace {
+    void RegisterOneDNNExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("OneDNNExecutionProvider", []() {
+            return std::make_unique<OneDNNExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("OneDNN", []() {
+            return std::make_unique<OneDNNExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterOneDNNExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_ONEDNN未定义
+
+namespace inferunity {
+    // oneDNN未启用时的占位实现
+    // 注册函数为空，不会注册oneDNN后端
+}
+
+#endif  // INFERUNITY_USE_ONEDNN
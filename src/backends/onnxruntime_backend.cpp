@@ -3,16 +3,223 @@
 
 #include "inferunity/backend.h"
 #include "inferunity/logger.h"
+#include "inferunity/tensor.h"
+#include "frontend/onnx_exporter.h"
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #ifdef INFERUNITY_USE_ONNXRUNTIME
 #include <onnxruntime_cxx_api.h>
 
 namespace inferunity {
 
-class ONNXRuntimeExecutionProvider : public ExecutionProvider {
+namespace {
+
+bool ToOrtElementType(DataType dtype, ONNXTensorElementDataType* type) {
+    switch (dtype) {
+        case DataType::FLOAT32: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT; return true;
+        case DataType::FLOAT16: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16; return true;
+        case DataType::BFLOAT16: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16; return true;
+        case DataType::INT8: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8; return true;
+        case DataType::INT16: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16; return true;
+        case DataType::INT32: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32; return true;
+        case DataType::INT64: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64; return true;
+        case DataType::UINT8: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8; return true;
+        case DataType::UINT16: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16; return true;
+        case DataType::UINT32: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32; return true;
+        case DataType::UINT64: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64; return true;
+        case DataType::BOOL: *type = ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL; return true;
+        default: return false;
+    }
+}
+
+bool FromOrtElementType(ONNXTensorElementDataType type, DataType* dtype) {
+    switch (type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: *dtype = DataType::FLOAT32; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: *dtype = DataType::FLOAT16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16: *dtype = DataType::BFLOAT16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: *dtype = DataType::INT8; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16: *dtype = DataType::INT16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32: *dtype = DataType::INT32; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64: *dtype = DataType::INT64; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8: *dtype = DataType::UINT8; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16: *dtype = DataType::UINT16; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32: *dtype = DataType::UINT32; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64: *dtype = DataType::UINT64; return true;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL: *dtype = DataType::BOOL; return true;
+        default: return false;
+    }
+}
+
+// 一个Ort::Session及其输入输出绑定：整模型（LoadModel）与每个委托子图各用一个
+class OrtModel {
+public:
+    explicit OrtModel(std::unique_ptr<Ort::Session> session)
+        : session_(std::move(session)),
+          memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
+        CacheModelIO();
+    }
+    
+    size_t GetInputCount() const { return input_names_.size(); }
+    size_t GetOutputCount() const { return output_names_.size(); }
+    
+    Status Run(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
+        if (inputs.size() != input_names_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Input count mismatch");
+        }
+        
+        if (outputs.size() != output_names_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Output count mismatch");
+        }
+        
+        try {
+            // 上一次运行由ORT分配的输出即将释放，仍引用它们的输出张量不能作为预分配缓冲绑定
+            std::unordered_set<const void*> stale_outputs;
+            for (auto& value : ort_owned_outputs_) {
+                stale_outputs.insert(value.GetTensorMutableRawData());
+            }
+            binding_->ClearBoundInputs();
+            binding_->ClearBoundOutputs();
+            ort_owned_outputs_.clear();
+            
+            // 输入：把InferUnity张量的内存包装成Ort::Value视图，不拷贝
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                Ort::Value value{nullptr};
+                Status status = WrapTensor(inputs[i], &value);
+                if (!status.IsOk()) {
+                    return status;
+                }
+                binding_->BindInput(input_names_cstr_[i], value);
+            }
+            
+            // 输出：调用方预分配且形状与模型声明一致的张量直接作为ORT的输出缓冲，
+            // 动态形状的输出绑定到ORT的分配器
+            std::vector<bool> preallocated(outputs.size(), false);
+            for (size_t i = 0; i < outputs.size(); ++i) {
+                if (CanBindOutput(i, outputs[i]) && !stale_outputs.count(outputs[i]->GetData())) {
+                    Ort::Value value{nullptr};
+                    Status status = WrapTensor(outputs[i], &value);
+                    if (!status.IsOk()) {
+                        return status;
+                    }
+                    binding_->BindOutput(output_names_cstr_[i], value);
+                    preallocated[i] = true;
+                } else {
+                    binding_->BindOutput(output_names_cstr_[i], memory_info_);
+                }
+            }
+            
+            session_->Run(Ort::RunOptions{nullptr}, *binding_);
+            
+            std::vector<Ort::Value> ort_outputs = binding_->GetOutputValues();
+            for (size_t i = 0; i < outputs.size(); ++i) {
+                if (preallocated[i]) {
+                    continue;
+                }
+                auto& ort_output = ort_outputs[i];
+                auto shape_info = ort_output.GetTensorTypeAndShapeInfo();
+                DataType dtype;
+                if (!FromOrtElementType(shape_info.GetElementType(), &dtype)) {
+                    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                       "Unsupported ONNX Runtime output type: " + output_names_[i]);
+                }
+                // 调用方的张量成为ORT输出内存的视图，ORT的Ort::Value保持到下一次Run
+                *outputs[i] = Tensor(Shape(shape_info.GetShape()), dtype,
+                                     ort_output.GetTensorMutableRawData(),
+                                     outputs[i]->GetLayout(), DeviceType::CPU);
+                ort_owned_outputs_.push_back(std::move(ort_output));
+            }
+            
+            return Status::Ok();
+        } catch (const std::exception& e) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "ONNX Runtime inference failed: " + std::string(e.what()));
+        }
+    }
+
 private:
-    Ort::Env env_;
+    // 缓存输入输出名称与输出声明，并为新Session创建IoBinding
+    void CacheModelIO() {
+        size_t num_input_nodes = session_->GetInputCount();
+        size_t num_output_nodes = session_->GetOutputCount();
+        
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < num_input_nodes; ++i) {
+            input_names_ptrs_.push_back(session_->GetInputNameAllocated(i, allocator));
+            input_names_.push_back(input_names_ptrs_.back().get());
+        }
+        for (size_t i = 0; i < num_output_nodes; ++i) {
+            output_names_ptrs_.push_back(session_->GetOutputNameAllocated(i, allocator));
+            output_names_.push_back(output_names_ptrs_.back().get());
+            
+            auto type_info = session_->GetOutputTypeInfo(i);
+            if (type_info.GetONNXType() == ONNX_TYPE_TENSOR) {
+                auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
+                output_types_.push_back(tensor_info.GetElementType());
+                output_dims_.push_back(tensor_info.GetShape());
+            } else {
+                output_types_.push_back(ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED);
+                output_dims_.push_back({});
+            }
+        }
+        // 名称全部写入后再取c_str，避免vector扩容使指针失效
+        for (const auto& name : input_names_) {
+            input_names_cstr_.push_back(name.c_str());
+        }
+        for (const auto& name : output_names_) {
+            output_names_cstr_.push_back(name.c_str());
+        }
+        
+        binding_ = std::make_unique<Ort::IoBinding>(*session_);
+    }
+    
+    // 以InferUnity张量的内存创建Ort::Value视图
+    Status WrapTensor(Tensor* tensor, Ort::Value* value) const {
+        if (!tensor || (!tensor->GetData() && tensor->GetElementCount() > 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Tensor has no data");
+        }
+        if (tensor->GetDeviceType() != DeviceType::CPU) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "ONNX Runtime backend only binds host tensors");
+        }
+        ONNXTensorElementDataType type;
+        if (!ToOrtElementType(tensor->GetDataType(), &type)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "Unsupported tensor data type for ONNX Runtime");
+        }
+        const Shape& shape = tensor->GetShape();
+        std::vector<int64_t> dims(shape.dims.begin(), shape.dims.end());
+        *value = Ort::Value::CreateTensor(memory_info_, tensor->GetData(), tensor->GetSizeInBytes(),
+                                          dims.data(), dims.size(), type);
+        return Status::Ok();
+    }
+    
+    // 输出声明为静态形状、调用方张量已分配且类型和形状一致时，ORT可以直接写入该张量
+    bool CanBindOutput(size_t index, const Tensor* tensor) const {
+        if (!tensor || !tensor->GetData() || tensor->GetDeviceType() != DeviceType::CPU) {
+            return false;
+        }
+        ONNXTensorElementDataType type;
+        if (!ToOrtElementType(tensor->GetDataType(), &type) || type != output_types_[index]) {
+            return false;
+        }
+        const std::vector<int64_t>& declared = output_dims_[index];
+        const std::vector<int64_t>& dims = tensor->GetShape().dims;
+        if (declared.size() != dims.size()) {
+            return false;
+        }
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (declared[d] < 0 || declared[d] != dims[d]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     std::unique_ptr<Ort::Session> session_;
     Ort::MemoryInfo memory_info_;
     std::vector<std::string> input_names_;
@@ -21,20 +228,56 @@ private:
     std::vector<Ort::AllocatedStringPtr> output_names_ptrs_;
     std::vector<const char*> input_names_cstr_;
     std::vector<const char*> output_names_cstr_;
+    // 模型声明的输出类型与形状（动态维度为-1），用于判断调用方的输出张量能否直接绑定
+    std::vector<ONNXTensorElementDataType> output_types_;
+    std::vector<std::vector<int64_t>> output_dims_;
+    // IOBinding (参考ONNX Runtime的IoBinding)：输入以视图方式绑定InferUnity张量的内存，
+    // 形状已知的输出直接写入调用方预分配的张量，其余输出由ORT分配后以视图交给调用方
+    std::unique_ptr<Ort::IoBinding> binding_;
+    // ORT分配的输出：调用方的输出张量引用其内存，保持到下一次Run
+    std::vector<Ort::Value> ort_owned_outputs_;
+};
+
+} // namespace
+
+class ONNXRuntimeExecutionProvider : public ExecutionProvider {
+private:
+    Ort::Env env_;
+    // LoadModel加载的整模型
+    std::unique_ptr<OrtModel> model_;
+    // 委托子图 (见DelegateUnsupportedSubgraphs)：融合节点 -> 由子图导出的ONNX模型
+    std::unordered_map<const Node*, std::unique_ptr<OrtModel>> subgraphs_;
+    // 输入输出都在主机内存上，设备沿用CPU执行提供者的实现
+    std::unique_ptr<ExecutionProvider> host_provider_;
     int optimization_level_ = 2;
     size_t memory_usage_ = 0;
     
+    Ort::SessionOptions CreateSessionOptions() const {
+        Ort::SessionOptions session_options;
+        if (optimization_level_ >= 2) {
+            session_options.SetGraphOptimizationLevel(
+                GraphOptimizationLevel::ORT_ENABLE_ALL);
+        } else if (optimization_level_ >= 1) {
+            session_options.SetGraphOptimizationLevel(
+                GraphOptimizationLevel::ORT_ENABLE_BASIC);
+        } else {
+            session_options.SetGraphOptimizationLevel(
+                GraphOptimizationLevel::ORT_DISABLE_ALL);
+        }
+        return session_options;
+    }
+
 public:
     ONNXRuntimeExecutionProvider() 
         : env_(ORT_LOGGING_LEVEL_WARNING, "InferUnity"),
-          memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
+          host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")) {
     }
     
     std::string GetName() const override {
         return "ONNXRuntimeExecutionProvider";
     }
     
-    std::string GetVersion() const override {
+    std::string GetVersion() const {
         return OrtGetApiBase()->GetVersionString();
     }
     
@@ -44,69 +287,107 @@ public:
         return DeviceType::CPU;
     }
     
-    std::vector<std::string> GetSupportedOps() const override {
-        // ONNX Runtime支持所有ONNX标准算子
-        // 这里返回空列表表示支持所有（实际应该查询Session）
-        return {};
+    bool IsAvailable() const override {
+        return true;  // ONNX Runtime总是可用（如果已链接）
     }
     
-    bool IsOpSupported(const std::string& op_type) const override {
-        // ONNX Runtime支持所有ONNX标准算子
-        return true;
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
     }
     
-    bool IsAvailable() const override {
-        return true;  // ONNX Runtime总是可用（如果已链接）
+    int GetDeviceCount() const override { return 1; }
+    
+    // 逐节点的算子由原生提供者执行；ONNX Runtime只执行委托给它的整段子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
     }
     
-    Status LoadModel(const std::string& model_path) override {
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+    
+    Status OptimizeGraph(Graph* graph) override {
+        // ONNX Runtime的图优化在创建Session时自动执行
+        (void)graph;
+        return Status::Ok();
+    }
+    
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_INVALID_STATE,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+    
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+    
+    bool SupportsSubgraphCompilation() const override { return true; }
+    
+    // 子图导出为ONNX模型后在内存中创建Session，各融合节点各自持有
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        std::string model_bytes;
+        Status status = frontend::ExportToONNX(*subgraph, &model_bytes);
+        if (!status.IsOk()) {
+            return status;
+        }
         try {
-            Ort::SessionOptions session_options;
-            
-            // 设置优化级别
-            if (optimization_level_ >= 2) {
-                session_options.SetGraphOptimizationLevel(
-                    GraphOptimizationLevel::ORT_ENABLE_ALL);
-            } else if (optimization_level_ >= 1) {
-                session_options.SetGraphOptimizationLevel(
-                    GraphOptimizationLevel::ORT_ENABLE_BASIC);
-            } else {
-                session_options.SetGraphOptimizationLevel(
-                    GraphOptimizationLevel::ORT_DISABLE_ALL);
-            }
-            
-            // 创建Session
-            session_ = std::make_unique<Ort::Session>(
-                env_, model_path.c_str(), session_options);
-            
-            // 获取输入/输出名称
-            size_t num_input_nodes = session_->GetInputCount();
-            size_t num_output_nodes = session_->GetOutputCount();
-            
-            input_names_.clear();
-            output_names_.clear();
-            input_names_ptrs_.clear();
-            output_names_ptrs_.clear();
-            input_names_cstr_.clear();
-            output_names_cstr_.clear();
-            
-            for (size_t i = 0; i < num_input_nodes; ++i) {
-                auto name_ptr = session_->GetInputNameAllocated(i, Ort::AllocatorWithDefaultOptions());
-                input_names_ptrs_.push_back(std::move(name_ptr));
-                input_names_.push_back(input_names_ptrs_.back().get());
-                input_names_cstr_.push_back(input_names_.back().c_str());
+            auto session = std::make_unique<Ort::Session>(
+                env_, model_bytes.data(), model_bytes.size(), CreateSessionOptions());
+            subgraphs_[fused_node] = std::make_unique<OrtModel>(std::move(session));
+        } catch (const std::exception& e) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Failed to compile subgraph with ONNX Runtime: " + std::string(e.what()));
+        }
+        return Status::Ok();
+    }
+    
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "ONNX Runtime backend only executes delegated subgraphs: " + node->GetOpType());
+        }
+        
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_INVALID_STATE,
+                                   "Delegated subgraph input has no tensor: " + input->GetName());
             }
-            
-            for (size_t i = 0; i < num_output_nodes; ++i) {
-                auto name_ptr = session_->GetOutputNameAllocated(i, Ort::AllocatorWithDefaultOptions());
-                output_names_ptrs_.push_back(std::move(name_ptr));
-                output_names_.push_back(output_names_ptrs_.back().get());
-                output_names_cstr_.push_back(output_names_.back().c_str());
+            inputs.push_back(input->GetTensor().get());
+        }
+        // 输出没有绑定张量时由ORT分配，Value上的张量成为ORT输出内存的视图
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
             }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs);
+    }
+    
+    Status LoadModel(const std::string& model_path) {
+        try {
+            auto session = std::make_unique<Ort::Session>(
+                env_, model_path.c_str(), CreateSessionOptions());
+            model_ = std::make_unique<OrtModel>(std::move(session));
             
             LOG_INFO("ONNX Runtime model loaded: " + model_path);
-            LOG_INFO("Inputs: " + std::to_string(num_input_nodes));
-            LOG_INFO("Outputs: " + std::to_string(num_output_nodes));
+            LOG_INFO("Inputs: " + std::to_string(model_->GetInputCount()));
+            LOG_INFO("Outputs: " + std::to_string(model_->GetOutputCount()));
             
             return Status::Ok();
         } catch (const std::exception& e) {
@@ -115,22 +396,12 @@ public:
         }
     }
     
-    Status LoadModelFromMemory(const void* data, size_t size) override {
+    Status LoadModelFromMemory(const void* data, size_t size) {
         try {
-            Ort::SessionOptions session_options;
-            
-            if (optimization_level_ >= 2) {
-                session_options.SetGraphOptimizationLevel(
-                    GraphOptimizationLevel::ORT_ENABLE_ALL);
-            }
-            
             // 从内存加载模型
-            session_ = std::make_unique<Ort::Session>(
-                env_, data, size, session_options);
-            
-            // 获取输入/输出名称（同上）
-            // ... (省略重复代码)
-            
+            auto session = std::make_unique<Ort::Session>(
+                env_, data, size, CreateSessionOptions());
+            model_ = std::make_unique<OrtModel>(std::move(session));
             return Status::Ok();
         } catch (const std::exception& e) {
             return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
@@ -138,115 +409,53 @@ public:
         }
     }
     
-    Status LoadGraph(Graph* graph) override {
-        // ONNX Runtime后端不支持从内部Graph加载
-        // 应该先将Graph序列化为ONNX格式，然后加载
-        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
-                           "ONNX Runtime backend does not support LoadGraph. Use LoadModel instead.");
+    // 整图交给ONNX Runtime：导出为ONNX模型后加载
+    Status LoadGraph(Graph* graph) {
+        if (!graph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+        }
+        std::string model_bytes;
+        Status status = frontend::ExportToONNX(*graph, &model_bytes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return LoadModelFromMemory(model_bytes.data(), model_bytes.size());
     }
     
     Status Run(const std::vector<Tensor*>& inputs,
-              std::vector<Tensor*>& outputs) override {
-        if (!session_) {
+              std::vector<Tensor*>& outputs) {
+        if (!model_) {
             return Status::Error(StatusCode::ERROR_INVALID_STATE,
                                "Model not loaded");
         }
-        
-        if (inputs.size() != input_names_.size()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Input count mismatch");
-        }
-        
-        try {
-            // 转换输入Tensor到ONNX Runtime格式
-            std::vector<Ort::Value> ort_inputs;
-            for (size_t i = 0; i < inputs.size(); ++i) {
-                auto* tensor = inputs[i];
-                const Shape& shape = tensor->GetShape();
-                
-                // 创建ONNX Runtime Tensor
-                std::vector<int64_t> dims(shape.dims.begin(), shape.dims.end());
-                auto ort_tensor = Ort::Value::CreateTensor<float>(
-                    memory_info_,
-                    static_cast<float*>(tensor->GetData()),
-                    tensor->GetElementCount(),
-                    dims.data(),
-                    dims.size()
-                );
-                ort_inputs.push_back(std::move(ort_tensor));
-            }
-            
-            // 执行推理
-            auto ort_outputs = session_->Run(
-                Ort::RunOptions{nullptr},
-                input_names_cstr_.data(), ort_inputs.data(), ort_inputs.size(),
-                output_names_cstr_.data(), output_names_cstr_.size()
-            );
-            
-            // 转换输出Tensor
-            if (outputs.size() != ort_outputs.size()) {
-                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                                   "Output count mismatch");
-            }
-            
-            for (size_t i = 0; i < outputs.size(); ++i) {
-                auto& ort_output = ort_outputs[i];
-                auto* output = outputs[i];
-                
-                // 获取形状信息
-                auto shape_info = ort_output.GetTensorTypeAndShapeInfo();
-                std::vector<int64_t> dims = shape_info.GetShape();
-                
-                // 更新输出Tensor的形状和数据
-                Shape output_shape(dims);
-                if (output->GetShape() != output_shape) {
-                    // 需要重新分配内存
-                    output->Reshape(output_shape);
-                }
-                
-                // 拷贝数据
-                float* output_data = static_cast<float*>(output->GetData());
-                const float* ort_data = ort_output.GetTensorMutableData<float>();
-                std::memcpy(output_data, ort_data, output->GetSizeInBytes());
-            }
-            
-            return Status::Ok();
-        } catch (const std::exception& e) {
-            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
-                               "ONNX Runtime inference failed: " + std::string(e.what()));
-        }
+        return model_->Run(inputs, outputs);
     }
     
-    Status SetOptimizationLevel(int level) override {
+    Status SetOptimizationLevel(int level) {
         optimization_level_ = level;
         // 注意：如果Session已创建，需要重新加载模型
         return Status::Ok();
     }
     
-    Status OptimizeGraph(Graph* graph) override {
-        // ONNX Runtime的图优化在LoadModel时自动执行
-        return Status::Ok();
-    }
-    
-    Status AllocateMemory(size_t size) override {
+    Status AllocateMemory(size_t size) {
         memory_usage_ += size;
         return Status::Ok();
     }
     
-    Status ReleaseMemory() override {
+    Status ReleaseMemory() {
         memory_usage_ = 0;
         return Status::Ok();
     }
     
-    size_t GetMemoryUsage() const override {
+    size_t GetMemoryUsage() const {
         return memory_usage_;
     }
     
-    void ResetProfiling() override {
+    void ResetProfiling() {
         // ONNX Runtime支持性能分析，这里简化处理
     }
     
-    std::string GetProfilingReport() const override {
+    std::string GetProfilingReport() const {
         // 返回ONNX Runtime的性能报告
         return "Profiling report not implemented";
     }
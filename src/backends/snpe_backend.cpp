@@ -0,0 +1,463 @@
+// Qualcomm SNPE执行提供者（Hexagon DSP/HTP、Adreno GPU）
+// 参考ONNX Runtime的SNPEExecutionProvider与QNN EP的上下文缓存：认领SNPE支持的连通子图，按子图的ONNX导出内容
+// 哈希查找离线转换好的DLC（snpe-onnx-to-dlc/snpe-dlc-graph-prepare，SNPE不能在设备上转换ONNX），
+// 首次构建后把初始化缓存写回DLC，之后的会话跳过DSP上的图准备。缓存中还没有DLC时把导出的ONNX写到
+// 缓存目录供离线转换，子图留给原生提供者。
+// 子图边界上的张量经dma-buf与DSP共享（见npu::BoundaryBuffer）：缓冲向FastRPC登记后DSP直接访问，
+// 不经过驱动内的拷贝；提供者与主机共享内存，图分区不插入拷贝节点
+
+#include "inferunity/backend.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/tensor.h"
+#include "npu_common.h"
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_SNPE
+#include <DlContainer/IDlContainer.hpp>
+#include <DlSystem/DlEnums.hpp>
+#include <DlSystem/IUserBuffer.hpp>
+#include <DlSystem/IUserBufferFactory.hpp>
+#include <DlSystem/RuntimeList.hpp>
+#include <DlSystem/StringList.hpp>
+#include <DlSystem/TensorShape.hpp>
+#include <DlSystem/UserBufferMap.hpp>
+#include <SNPE/SNPE.hpp>
+#include <SNPE/SNPEBuilder.hpp>
+#include <SNPE/SNPEFactory.hpp>
+#include <dlfcn.h>
+
+namespace inferunity {
+
+namespace {
+
+// SNPE的ONNX转换器支持、且图中以标准ONNX形式存在的算子
+const std::unordered_set<std::string>& SNPESupportedOps() {
+    static const std::unordered_set<std::string> ops = {
+        "Conv", "ConvTranspose", "MatMul", "Gemm",
+        "Relu", "LeakyRelu", "PRelu", "Sigmoid", "Tanh", "Elu", "Clip", "HardSigmoid",
+        "Add", "Sub", "Mul", "Div", "Max", "Min", "Sqrt", "Exp", "Abs", "Neg",
+        "MaxPool", "AveragePool", "GlobalMaxPool", "GlobalAveragePool",
+        "BatchNormalization", "InstanceNormalization", "Softmax", "LogSoftmax",
+        "ReduceMean", "ReduceSum", "ReduceMax", "ReduceMin",
+        "Reshape", "Flatten", "Transpose", "Concat", "Split", "Slice", "Squeeze", "Unsqueeze",
+        "Pad", "Resize", "Identity", "DepthToSpace", "SpaceToDepth"
+    };
+    return ops;
+}
+
+bool ParseRuntime(const std::string& name, zdl::DlSystem::Runtime_t* runtime) {
+    if (name == "DSP" || name == "HTP") {
+        *runtime = zdl::DlSystem::Runtime_t::DSP;
+    } else if (name == "GPU") {
+        *runtime = zdl::DlSystem::Runtime_t::GPU;
+    } else if (name == "CPU") {
+        *runtime = zdl::DlSystem::Runtime_t::CPU;
+    } else if (name == "AIP") {
+        *runtime = zdl::DlSystem::Runtime_t::AIP_FIXED8_TF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// FastRPC的缓冲登记（libcdsprpc）：登记过的dma-buf由DSP直接映射；没有该库（非高通设备）时为空操作
+class FastRpcRegistry {
+public:
+    static FastRpcRegistry& Instance() {
+        static FastRpcRegistry registry;
+        return registry;
+    }
+
+    void Register(const DmaBufRegion& region) {
+        if (!register_buf_ || region.fd < 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (registered_.insert({region.base, region.fd}).second) {
+            register_buf_(region.base, static_cast<int>(region.size), region.fd);
+        }
+    }
+
+private:
+    using RegisterBufFn = void (*)(void* buffer, int size, int fd);
+
+    FastRpcRegistry() {
+        if (void* library = dlopen("libcdsprpc.so", RTLD_NOW | RTLD_LOCAL)) {
+            register_buf_ = reinterpret_cast<RegisterBufFn>(dlsym(library, "remote_register_buf"));
+        }
+    }
+
+    RegisterBufFn register_buf_ = nullptr;
+    std::mutex mutex_;
+    std::set<std::pair<void*, int>> registered_;   // 映射地址可能被新的dma-buf复用，按(地址, fd)记录
+};
+
+// 一个认领子图的SNPE实例；输入输出按导出时的张量名绑定，user buffer指向边界缓冲
+class SNPESubgraph {
+public:
+    SNPESubgraph(std::unique_ptr<zdl::SNPE::SNPE> snpe, std::vector<std::string> input_names,
+                 std::vector<std::string> output_names, std::vector<Shape> output_shapes)
+        : snpe_(std::move(snpe)), input_names_(std::move(input_names)), output_names_(std::move(output_names)),
+          input_buffers_(input_names_.size()), output_buffers_(output_names_.size()),
+          output_shapes_(std::move(output_shapes)) {}
+
+    // DLC的输入输出维度是静态的：逐个张量创建user buffer。转换时以--preserve_io layout保留了
+    // ONNX的布局，输出张量沿用子图中的形状，这里只核对元素个数
+    Status Initialize() {
+        zdl::DlSystem::IUserBufferFactory& factory = zdl::SNPE::SNPEFactory::getUserBufferFactory();
+        auto create = [&](const std::string& name, std::vector<size_t>* counts,
+                          std::vector<std::unique_ptr<zdl::DlSystem::IUserBuffer>>* buffers,
+                          zdl::DlSystem::UserBufferMap* map) -> Status {
+            auto attributes = snpe_->getInputOutputBufferAttributes(name.c_str());
+            if (!attributes) {
+                return Status::Error(StatusCode::ERROR_INVALID_MODEL, "SNPE network has no tensor " + name);
+            }
+            const zdl::DlSystem::TensorShape dims = (*attributes)->getDims();
+            std::vector<size_t> strides(dims.rank());
+            size_t stride = sizeof(float);
+            for (size_t i = dims.rank(); i-- > 0;) {
+                strides[i] = stride;
+                stride *= dims[i];
+            }
+            counts->push_back(stride / sizeof(float));
+            buffers->push_back(factory.createUserBuffer(nullptr, stride, zdl::DlSystem::TensorShape(strides),
+                                                        &encoding_));
+            if (!buffers->back()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create SNPE user buffer: " + name);
+            }
+            map->add(name.c_str(), buffers->back().get());
+            return Status::Ok();
+        };
+        for (const std::string& name : input_names_) {
+            Status status = create(name, &input_counts_, &input_user_buffers_, &input_map_);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        std::vector<size_t> output_counts;
+        for (const std::string& name : output_names_) {
+            Status status = create(name, &output_counts, &output_user_buffers_, &output_map_);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        for (size_t i = 0; i < output_counts.size(); ++i) {
+            if (static_cast<int64_t>(output_counts[i]) != output_shapes_[i].GetElementCount()) {
+                return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                                   "SNPE DLC output does not match the subgraph: " + output_names_[i]);
+            }
+        }
+        return Status::Ok();
+    }
+
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+        if (inputs.size() != input_names_.size() || outputs.size() != output_names_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SNPE subgraph input/output count mismatch");
+        }
+        // SNPE实例不能并发执行
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (inputs[i]->GetDataType() != DataType::FLOAT32 ||
+                inputs[i]->GetShape().GetElementCount() != static_cast<int64_t>(input_counts_[i])) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "SNPE network compiled for a different input shape: " + input_names_[i]);
+            }
+            void* data = nullptr;
+            DmaBufRegion region;
+            Status status = input_buffers_[i].PrepareInput(*inputs[i], &data, &region);
+            if (!status.IsOk()) {
+                return status;
+            }
+            FastRpcRegistry::Instance().Register(region);
+            input_user_buffers_[i]->setBufferAddress(data);
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            void* data = nullptr;
+            DmaBufRegion region;
+            Status status = output_buffers_[i].PrepareOutput(outputs[i], output_shapes_[i], DataType::FLOAT32,
+                                                             &data, &region);
+            if (!status.IsOk()) {
+                return status;
+            }
+            FastRpcRegistry::Instance().Register(region);
+            output_user_buffers_[i]->setBufferAddress(data);
+        }
+        if (!snpe_->execute(input_map_, output_map_)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               std::string("SNPE execution failed: ") + zdl::DlSystem::getLastErrorString());
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            Status status = output_buffers_[i].FinishOutput(outputs[i]);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::unique_ptr<zdl::SNPE::SNPE> snpe_;
+    std::vector<std::string> input_names_;
+    std::vector<std::string> output_names_;
+    std::vector<npu::BoundaryBuffer> input_buffers_;
+    std::vector<npu::BoundaryBuffer> output_buffers_;
+    zdl::DlSystem::UserBufferEncodingFloat encoding_;
+    std::vector<Shape> output_shapes_;
+    std::vector<size_t> input_counts_;
+    std::vector<std::unique_ptr<zdl::DlSystem::IUserBuffer>> input_user_buffers_;
+    std::vector<std::unique_ptr<zdl::DlSystem::IUserBuffer>> output_user_buffers_;
+    zdl::DlSystem::UserBufferMap input_map_;
+    zdl::DlSystem::UserBufferMap output_map_;
+    std::mutex mutex_;
+};
+
+} // namespace
+
+class SNPEExecutionProvider : public ExecutionProvider {
+public:
+    SNPEExecutionProvider()
+        : host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")) {
+        runtimes_ = npu::SplitList(SessionOptions().snpe_runtimes);
+    }
+
+    std::string GetName() const override {
+        return "SNPEExecutionProvider";
+    }
+
+    DeviceType GetDeviceType() const override {
+        return DeviceType::SNPE;
+    }
+
+    bool IsAvailable() const override {
+        for (const std::string& name : runtimes_) {
+            zdl::DlSystem::Runtime_t runtime;
+            if (ParseRuntime(name, &runtime) && zdl::SNPE::SNPEFactory::isRuntimeAvailable(runtime)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 边界张量在主机可访问的dma-buf中，设备接口沿用CPU提供者
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
+    }
+
+    int GetDeviceCount() const override {
+        return 1;
+    }
+
+    bool SharesHostMemory() const override { return true; }
+
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override {
+        (void)node; (void)output_index;
+        return DeviceType::CPU;
+    }
+
+    Status ConfigureSession(const SessionOptions& options) override {
+        runtimes_ = npu::SplitList(options.snpe_runtimes);
+        cache_dir_ = options.npu_artifact_cache_dir.empty() ? options.optimized_model_cache_dir
+                                                            : options.npu_artifact_cache_dir;
+        return Status::Ok();
+    }
+
+    // 逐节点的算子由CPU提供者执行；SNPE只执行认领的子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        // 层融合与量化在离线转换DLC时完成
+        (void)graph;
+        return Status::Ok();
+    }
+
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    bool SupportsSubgraphCompilation() const override { return true; }
+    bool ClaimsSubgraphs() const override { return true; }
+
+    // 输入输出都是静态形状的FP32张量（DLC的维度是固定的）
+    bool CanCompileNode(const Node* node) const override {
+        if (!node || !SNPESupportedOps().count(node->GetOpType())) {
+            return false;
+        }
+        for (const Value* output : node->GetOutputs()) {
+            if (output->GetDataType() != DataType::FLOAT32) {
+                return false;
+            }
+            for (int64_t d : output->GetShape().dims) {
+                if (d <= 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // 查DLC缓存：命中时构建SNPE实例，DLC中还没有初始化缓存时写回；未命中时导出ONNX供离线转换
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        if (cache_dir_.empty()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "SNPE needs npu_artifact_cache_dir to locate converted DLC files");
+        }
+        npu::ExportedSubgraph exported;
+        Status status = npu::ExportSubgraph(*subgraph, &exported);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::string dlc_path = npu::ArtifactPath(cache_dir_, "snpe", exported.hash, "dlc");
+        std::string dlc;
+        if (!npu::ReadArtifact(dlc_path, &dlc)) {
+            const std::string onnx_path = npu::ArtifactPath(cache_dir_, "snpe", exported.hash, "onnx");
+            std::string existing;
+            if (!npu::ReadArtifact(onnx_path, &existing)) {
+                npu::WriteArtifact(onnx_path, exported.model_bytes);
+            }
+            LOG_WARNING("SNPE DLC not found, subgraph stays on the native provider. Convert " + onnx_path +
+                        " with snpe-onnx-to-dlc --preserve_io layout (and snpe-dlc-graph-prepare for HTP) into " +
+                        dlc_path);
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "SNPE DLC not found: " + dlc_path);
+        }
+
+        std::unique_ptr<zdl::DlContainer::IDlContainer> container = zdl::DlContainer::IDlContainer::open(
+            reinterpret_cast<const uint8_t*>(dlc.data()), dlc.size());
+        if (!container) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Cannot open SNPE DLC: " + dlc_path);
+        }
+        zdl::DlSystem::RuntimeList runtime_list;
+        for (const std::string& name : runtimes_) {
+            zdl::DlSystem::Runtime_t runtime;
+            if (ParseRuntime(name, &runtime) && zdl::SNPE::SNPEFactory::isRuntimeAvailable(runtime)) {
+                runtime_list.add(runtime);
+            }
+        }
+        if (runtime_list.empty()) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "No requested SNPE runtime is available");
+        }
+        zdl::DlSystem::StringList output_names;
+        for (const std::string& name : exported.output_names) {
+            output_names.append(name.c_str());
+        }
+        zdl::SNPE::SNPEBuilder builder(container.get());
+        std::unique_ptr<zdl::SNPE::SNPE> snpe = builder.setRuntimeProcessorOrder(runtime_list)
+            .setOutputTensors(output_names)
+            .setUseUserSuppliedBuffers(true)
+            .setInitCacheMode(true)
+            .setPerformanceProfile(zdl::DlSystem::PerformanceProfile_t::HIGH_PERFORMANCE)
+            .build();
+        if (!snpe) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               std::string("Failed to build SNPE network: ") + zdl::DlSystem::getLastErrorString());
+        }
+        // 构建时生成的初始化缓存写回DLC，之后的会话直接加载
+        std::vector<uint8_t> saved;
+        if (container->save(saved) && saved.size() != dlc.size()) {
+            if (npu::WriteArtifact(dlc_path, std::string(saved.begin(), saved.end()))) {
+                LOG_INFO("SNPE init cache stored in " + dlc_path);
+            }
+        }
+
+        std::vector<Shape> output_shapes;
+        for (const Value* output : subgraph->GetOutputs()) {
+            output_shapes.push_back(output->GetShape());
+        }
+        auto compiled = std::make_unique<SNPESubgraph>(std::move(snpe), std::move(exported.input_names),
+                                                       std::move(exported.output_names), std::move(output_shapes));
+        status = compiled->Initialize();
+        if (!status.IsOk()) {
+            return status;
+        }
+        subgraphs_[fused_node] = std::move(compiled);
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "SNPE backend only executes claimed subgraphs: " + node->GetOpType());
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Claimed subgraph input has no tensor: " + input->GetName());
+            }
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs);
+    }
+
+private:
+    std::unique_ptr<ExecutionProvider> host_provider_;
+    std::vector<std::string> runtimes_;
+    std::string cache_dir_;
+    std::unordered_map<Node*, std::unique_ptr<SNPESubgraph>> subgraphs_;
+};
+
+// 注册SNPE执行提供者
+namespace {
+    void RegisterSNPEExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("SNPEExecutionProvider", []() {
+            return std::make_unique<SNPEExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("SNPE", []() {
+            return std::make_unique<SNPEExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterSNPEExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_SNPE未定义
+
+namespace inferunity {
+    // SNPE未启用时的占位实现
+    // 注册函数为空，不会注册SNPE后端
+}
+
+#endif  // INFERUNITY_USE_SNPE
@@ -0,0 +1,621 @@
+// TensorRT执行提供者
+// 参考ONNX Runtime的TensorRTExecutionProvider：认领TensorRT能编译的连通子图，子图经ONNX导出后由
+// nvonnxparser解析并构建引擎；构建好的引擎序列化到磁盘缓存，之后的会话直接反序列化
+
+#include "inferunity/backend.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/quantization.h"
+#include "inferunity/tensor.h"
+#include "frontend/onnx_exporter.h"
+#include "core/hash_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_TENSORRT
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <cuda_runtime.h>
+
+namespace inferunity {
+
+namespace {
+
+// TensorRT的日志转发到InferUnity的日志，INFO及以下的构建细节丢弃
+class TRTLogger : public nvinfer1::ILogger {
+public:
+    void log(Severity severity, const char* msg) noexcept override {
+        switch (severity) {
+            case Severity::kINTERNAL_ERROR:
+            case Severity::kERROR: LOG_ERROR(std::string("TensorRT: ") + msg); break;
+            case Severity::kWARNING: LOG_WARNING(std::string("TensorRT: ") + msg); break;
+            default: break;
+        }
+    }
+};
+
+TRTLogger& GetTRTLogger() {
+    static TRTLogger logger;
+    return logger;
+}
+
+bool FromTRTDataType(nvinfer1::DataType type, DataType* dtype) {
+    switch (type) {
+        case nvinfer1::DataType::kFLOAT: *dtype = DataType::FLOAT32; return true;
+        case nvinfer1::DataType::kHALF: *dtype = DataType::FLOAT16; return true;
+        case nvinfer1::DataType::kINT8: *dtype = DataType::INT8; return true;
+        case nvinfer1::DataType::kINT32: *dtype = DataType::INT32; return true;
+        case nvinfer1::DataType::kBOOL: *dtype = DataType::BOOL; return true;
+        case nvinfer1::DataType::kUINT8: *dtype = DataType::UINT8; return true;
+#if NV_TENSORRT_MAJOR >= 10
+        case nvinfer1::DataType::kINT64: *dtype = DataType::INT64; return true;
+#endif
+        default: return false;
+    }
+}
+
+// 子图的输入输出能直接交给TensorRT的类型；INT64常量由解析器转换，不受此限
+bool IsTRTIOType(DataType dtype) {
+    switch (dtype) {
+        case DataType::FLOAT32:
+        case DataType::FLOAT16:
+        case DataType::INT8:
+        case DataType::INT32:
+        case DataType::BOOL:
+        case DataType::UINT8:
+            return true;
+#if NV_TENSORRT_MAJOR >= 10
+        case DataType::INT64:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// nvonnxparser支持、且图中以标准ONNX形式存在的算子
+const std::unordered_set<std::string>& TRTSupportedOps() {
+    static const std::unordered_set<std::string> ops = {
+        "Conv", "ConvTranspose", "MatMul", "Gemm",
+        "Relu", "LeakyRelu", "Sigmoid", "Tanh", "Elu", "Selu", "Softplus", "HardSigmoid", "Clip", "Erf",
+        "Add", "Sub", "Mul", "Div", "Pow", "Sqrt", "Exp", "Log", "Abs", "Neg", "Reciprocal", "Min", "Max",
+        "MaxPool", "AveragePool", "GlobalMaxPool", "GlobalAveragePool",
+        "BatchNormalization", "InstanceNormalization", "Softmax", "LogSoftmax",
+        "ReduceMean", "ReduceSum", "ReduceMax", "ReduceMin",
+        "Reshape", "Flatten", "Transpose", "Concat", "Split", "Slice", "Gather", "Squeeze", "Unsqueeze",
+        "Pad", "Resize", "Identity", "Cast", "Shape", "Expand", "Where", "Equal", "Greater", "Less"
+    };
+    return ops;
+}
+
+// 设备上的暂存缓冲，按需增长
+struct DeviceBuffer {
+    void* data = nullptr;
+    size_t capacity = 0;
+
+    Status Reserve(size_t size) {
+        if (size <= capacity) {
+            return Status::Ok();
+        }
+        if (data) {
+            cudaFree(data);
+            data = nullptr;
+            capacity = 0;
+        }
+        if (cudaMalloc(&data, std::max<size_t>(size, 1)) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "cudaMalloc failed for TensorRT buffer");
+        }
+        capacity = size;
+        return Status::Ok();
+    }
+
+    ~DeviceBuffer() {
+        if (data) {
+            cudaFree(data);
+        }
+    }
+};
+
+// 一个委托子图的TensorRT引擎及其执行上下文；输入输出按子图导出时的张量名绑定
+class TRTSubgraph {
+public:
+    TRTSubgraph(std::unique_ptr<nvinfer1::ICudaEngine> engine, std::vector<std::string> input_names,
+                std::vector<std::string> output_names)
+        : engine_(std::move(engine)),
+          context_(engine_->createExecutionContext()),
+          input_names_(std::move(input_names)),
+          output_names_(std::move(output_names)),
+          input_buffers_(input_names_.size()),
+          output_buffers_(output_names_.size()) {}
+
+    bool IsValid() const { return context_ != nullptr; }
+
+    // 主机上的输入经暂存缓冲上传，GPU上的输入直接绑定；输出写入调用方GPU上形状一致的张量，
+    // 否则下载到主机张量
+    Status Run(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs, cudaStream_t stream) {
+        if (inputs.size() != input_names_.size() || outputs.size() != output_names_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TensorRT subgraph input/output count mismatch");
+        }
+        // 同一个执行上下文不能并发入队
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Tensor* tensor = inputs[i];
+            if (!tensor || (!tensor->GetData() && tensor->GetElementCount() > 0)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TensorRT input has no data: " + input_names_[i]);
+            }
+            const char* name = input_names_[i].c_str();
+            DataType expected;
+            if (!FromTRTDataType(engine_->getTensorDataType(name), &expected) || expected != tensor->GetDataType()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TensorRT input type mismatch: " + input_names_[i]);
+            }
+            const std::vector<int64_t>& dims = tensor->GetShape().dims;
+            nvinfer1::Dims trt_dims;
+            trt_dims.nbDims = static_cast<int32_t>(dims.size());
+            std::copy(dims.begin(), dims.end(), trt_dims.d);
+            if (!context_->setInputShape(name, trt_dims)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Input shape outside the TensorRT optimization profile: " + input_names_[i]);
+            }
+
+            void* address = tensor->GetData();
+            if (tensor->GetDeviceType() != DeviceType::CUDA) {
+                Status status = input_buffers_[i].Reserve(tensor->GetSizeInBytes());
+                if (!status.IsOk()) {
+                    return status;
+                }
+                if (cudaMemcpyAsync(input_buffers_[i].data, tensor->GetData(), tensor->GetSizeInBytes(),
+                                    cudaMemcpyHostToDevice, stream) != cudaSuccess) {
+                    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "TensorRT input upload failed");
+                }
+                address = input_buffers_[i].data;
+            }
+            context_->setTensorAddress(name, address);
+        }
+
+        // 全部输入形状确定后才能取得输出形状
+        std::vector<Tensor*> downloads(outputs.size(), nullptr);
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            const char* name = output_names_[i].c_str();
+            const nvinfer1::Dims trt_dims = context_->getTensorShape(name);
+            DataType dtype;
+            if (trt_dims.nbDims < 0 || !FromTRTDataType(engine_->getTensorDataType(name), &dtype)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported TensorRT output: " + output_names_[i]);
+            }
+            std::vector<int64_t> dims(trt_dims.d, trt_dims.d + trt_dims.nbDims);
+            if (std::any_of(dims.begin(), dims.end(), [](int64_t d) { return d < 0; })) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "Data-dependent TensorRT output shape: " + output_names_[i]);
+            }
+
+            Tensor* tensor = outputs[i];
+            const bool matches = tensor->GetData() && tensor->GetDataType() == dtype && tensor->GetShape().dims == dims;
+            if (matches && tensor->GetDeviceType() == DeviceType::CUDA) {
+                context_->setTensorAddress(name, tensor->GetData());
+                continue;
+            }
+            if (!matches || tensor->GetDeviceType() != DeviceType::CPU) {
+                *tensor = Tensor(Shape(dims), dtype);
+            }
+            Status status = output_buffers_[i].Reserve(tensor->GetSizeInBytes());
+            if (!status.IsOk()) {
+                return status;
+            }
+            context_->setTensorAddress(name, output_buffers_[i].data);
+            downloads[i] = tensor;
+        }
+
+        if (!context_->enqueueV3(stream)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "TensorRT enqueue failed");
+        }
+        for (size_t i = 0; i < downloads.size(); ++i) {
+            if (downloads[i] && cudaMemcpyAsync(downloads[i]->GetData(), output_buffers_[i].data,
+                                                downloads[i]->GetSizeInBytes(), cudaMemcpyDeviceToHost,
+                                                stream) != cudaSuccess) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "TensorRT output download failed");
+            }
+        }
+        // 主机上的输出在返回后即被读取
+        if (cudaStreamSynchronize(stream) != cudaSuccess) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "TensorRT execution failed");
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::unique_ptr<nvinfer1::ICudaEngine> engine_;
+    std::unique_ptr<nvinfer1::IExecutionContext> context_;
+    std::vector<std::string> input_names_;
+    std::vector<std::string> output_names_;
+    std::vector<DeviceBuffer> input_buffers_;
+    std::vector<DeviceBuffer> output_buffers_;
+    std::mutex mutex_;
+};
+
+} // namespace
+
+class TensorRTExecutionProvider : public ExecutionProvider {
+private:
+    std::unique_ptr<nvinfer1::IRuntime> runtime_;
+    // 委托子图 (见DelegateClaimedSubgraphs)：融合节点 -> TensorRT引擎
+    std::unordered_map<const Node*, std::unique_ptr<TRTSubgraph>> subgraphs_;
+    // 输出默认下载到主机，设备沿用CPU执行提供者的实现
+    std::unique_ptr<ExecutionProvider> host_provider_;
+    cudaStream_t stream_ = nullptr;
+    int device_id_ = 0;
+    std::string device_key_;  // GPU型号与计算能力，引擎缓存键的一部分
+
+    // 来自SessionOptions（见ConfigureSession）
+    bool fp16_ = true;
+    bool int8_ = false;
+    size_t workspace_bytes_ = size_t(1) << 30;
+    int64_t max_dynamic_dim_ = 1024;
+    int64_t max_batch_size_ = 1;
+    std::string cache_dir_;
+    std::shared_ptr<const CalibrationTable> calibration_;
+
+    // 动态维度的范围：第0维视为批维度
+    void DynamicRange(int index, int64_t* min_dim, int64_t* max_dim) const {
+        *min_dim = 1;
+        *max_dim = index == 0 ? std::max<int64_t>(max_batch_size_, 1) : std::max<int64_t>(max_dynamic_dim_, 1);
+    }
+
+    // 引擎缓存键：子图的ONNX字节、影响构建结果的选项、GPU与TensorRT版本
+    std::string GetEngineCachePath(const std::string& model_bytes, const std::vector<std::string>& tensor_names) const {
+        std::ostringstream key;
+        key << "fp16=" << fp16_ << ";int8=" << int8_ << ";workspace=" << workspace_bytes_
+            << ";max_dynamic_dim=" << max_dynamic_dim_ << ";max_batch=" << max_batch_size_
+            << ";device=" << device_key_ << ";trt=" << getInferLibVersion() << ";ranges=";
+        if (int8_ && calibration_) {
+            for (const std::string& name : tensor_names) {
+                auto it = calibration_->find(name);
+                if (it != calibration_->end()) {
+                    key << name << ":" << std::setprecision(9) << it->second.min << ":" << it->second.max << ",";
+                }
+            }
+        }
+        const uint64_t hash = HashBytes(HashBytes(kFnv1aOffsetBasis, model_bytes), key.str());
+        std::ostringstream path;
+        path << cache_dir_ << "/trt_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".engine";
+        return path.str();
+    }
+
+    Status BuildEngine(const std::string& model_bytes, std::string* plan) const {
+        std::unique_ptr<nvinfer1::IBuilder> builder(nvinfer1::createInferBuilder(GetTRTLogger()));
+        if (!builder) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create TensorRT builder");
+        }
+#if NV_TENSORRT_MAJOR >= 10
+        const uint32_t flags = 0;
+#else
+        const uint32_t flags = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+#endif
+        std::unique_ptr<nvinfer1::INetworkDefinition> network(builder->createNetworkV2(flags));
+        std::unique_ptr<nvonnxparser::IParser> parser(nvonnxparser::createParser(*network, GetTRTLogger()));
+        if (!network || !parser || !parser->parse(model_bytes.data(), model_bytes.size())) {
+            std::string message = "TensorRT failed to parse subgraph";
+            for (int i = 0; parser && i < parser->getNbErrors(); ++i) {
+                message += std::string(": ") + parser->getError(i)->desc();
+            }
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, message);
+        }
+
+        std::unique_ptr<nvinfer1::IBuilderConfig> config(builder->createBuilderConfig());
+        config->setMemoryPoolLimit(nvinfer1::MemoryPoolType::kWORKSPACE, workspace_bytes_);
+        if (fp16_) {
+            config->setFlag(nvinfer1::BuilderFlag::kFP16);
+        }
+        if (int8_) {
+            // 显式动态范围代替校准器：范围取对称的max(|min|, |max|)，没有范围的张量保持高精度
+            if (!calibration_) {
+                LOG_WARNING("TensorRT INT8 requested without quantization_calibration; building without INT8");
+            } else {
+                config->setFlag(nvinfer1::BuilderFlag::kINT8);
+                for (int l = 0; l < network->getNbLayers(); ++l) {
+                    nvinfer1::ILayer* layer = network->getLayer(l);
+                    for (int o = 0; o < layer->getNbOutputs(); ++o) {
+                        nvinfer1::ITensor* tensor = layer->getOutput(o);
+                        auto it = calibration_->find(tensor->getName());
+                        if (it != calibration_->end()) {
+                            const float range = std::max(std::abs(it->second.min), std::abs(it->second.max));
+                            tensor->setDynamicRange(-range, range);
+                        }
+                    }
+                }
+                for (int i = 0; i < network->getNbInputs(); ++i) {
+                    nvinfer1::ITensor* tensor = network->getInput(i);
+                    auto it = calibration_->find(tensor->getName());
+                    if (it != calibration_->end()) {
+                        const float range = std::max(std::abs(it->second.min), std::abs(it->second.max));
+                        tensor->setDynamicRange(-range, range);
+                    }
+                }
+            }
+        }
+
+        // 优化配置：动态维度取[1, 上限]，kernel按上限调优
+        nvinfer1::IOptimizationProfile* profile = builder->createOptimizationProfile();
+        bool dynamic = false;
+        for (int i = 0; i < network->getNbInputs(); ++i) {
+            nvinfer1::ITensor* input = network->getInput(i);
+            nvinfer1::Dims min_dims = input->getDimensions();
+            nvinfer1::Dims max_dims = min_dims;
+            bool input_dynamic = false;
+            for (int d = 0; d < min_dims.nbDims; ++d) {
+                if (min_dims.d[d] < 0) {
+                    int64_t lo, hi;
+                    DynamicRange(d, &lo, &hi);
+                    min_dims.d[d] = static_cast<decltype(min_dims.d[d])>(lo);
+                    max_dims.d[d] = static_cast<decltype(max_dims.d[d])>(hi);
+                    input_dynamic = true;
+                }
+            }
+            if (input_dynamic) {
+                profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMIN, min_dims);
+                profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT, max_dims);
+                profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMAX, max_dims);
+                dynamic = true;
+            }
+        }
+        if (dynamic) {
+            config->addOptimizationProfile(profile);
+        }
+
+        std::unique_ptr<nvinfer1::IHostMemory> serialized(builder->buildSerializedNetwork(*network, *config));
+        if (!serialized) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "TensorRT engine build failed");
+        }
+        plan->assign(static_cast<const char*>(serialized->data()), serialized->size());
+        return Status::Ok();
+    }
+
+public:
+    TensorRTExecutionProvider()
+        : host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")) {
+        if (IsAvailable()) {
+            cudaSetDevice(device_id_);
+            cudaStreamCreate(&stream_);
+            cudaDeviceProp prop;
+            cudaGetDeviceProperties(&prop, device_id_);
+            device_key_ = std::string(prop.name) + "_sm" + std::to_string(prop.major) + std::to_string(prop.minor);
+            runtime_.reset(nvinfer1::createInferRuntime(GetTRTLogger()));
+        }
+    }
+
+    ~TensorRTExecutionProvider() override {
+        // 引擎先于runtime释放
+        subgraphs_.clear();
+        runtime_.reset();
+        if (stream_) {
+            cudaStreamDestroy(stream_);
+        }
+    }
+
+    std::string GetName() const override {
+        return "TensorRTExecutionProvider";
+    }
+
+    DeviceType GetDeviceType() const override {
+        return DeviceType::TENSORRT;
+    }
+
+    bool IsAvailable() const override {
+        int count = 0;
+        return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+    }
+
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
+    }
+
+    int GetDeviceCount() const override {
+        int count = 0;
+        cudaGetDeviceCount(&count);
+        return count;
+    }
+
+    Status ConfigureSession(const SessionOptions& options) override {
+        fp16_ = options.tensorrt_fp16;
+        int8_ = options.tensorrt_int8;
+        workspace_bytes_ = options.tensorrt_workspace_bytes;
+        max_dynamic_dim_ = options.tensorrt_max_dynamic_dim;
+        max_batch_size_ = options.max_batch_size;
+        cache_dir_ = options.tensorrt_engine_cache_dir.empty() ? options.optimized_model_cache_dir
+                                                              : options.tensorrt_engine_cache_dir;
+        calibration_ = options.quantization_calibration;
+        return Status::Ok();
+    }
+
+    // 逐节点的算子由原生提供者执行；TensorRT只执行认领或委托给它的整段子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        // TensorRT在构建引擎时自行做层融合与kernel选择
+        (void)graph;
+        return Status::Ok();
+    }
+
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_INVALID_STATE,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    bool SupportsSubgraphCompilation() const override { return runtime_ != nullptr; }
+    bool ClaimsSubgraphs() const override { return runtime_ != nullptr; }
+
+    // 标准ONNX算子，且非常量的输入输出都是TensorRT能绑定的类型
+    bool CanCompileNode(const Node* node) const override {
+        if (!node || !TRTSupportedOps().count(node->GetOpType())) {
+            return false;
+        }
+        for (const Value* input : node->GetInputs()) {
+            const bool constant = !input->GetProducer() && input->GetTensor() && input->GetTensor()->GetData();
+            if (input->GetTensor() && !constant && !IsTRTIOType(input->GetTensor()->GetDataType())) {
+                return false;
+            }
+        }
+        for (const Value* output : node->GetOutputs()) {
+            if (output->GetTensor() && !IsTRTIOType(output->GetTensor()->GetDataType())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 子图导出为ONNX模型，先查引擎缓存，未命中时构建并写入缓存
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        if (!runtime_) {
+            return Status::Error(StatusCode::ERROR_INVALID_STATE, "TensorRT runtime not available");
+        }
+        std::string model_bytes;
+        Status status = frontend::ExportToONNX(*subgraph, &model_bytes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        // 导出按CalibrationKey命名张量，引擎的输入输出与INT8动态范围都按这些名字查找
+        std::vector<std::string> input_names;
+        std::vector<std::string> output_names;
+        for (const Value* input : subgraph->GetInputs()) {
+            input_names.push_back(CalibrationKey(input));
+        }
+        for (const Value* output : subgraph->GetOutputs()) {
+            output_names.push_back(CalibrationKey(output));
+        }
+        std::vector<std::string> tensor_names;
+        for (const auto& value : subgraph->GetValues()) {
+            tensor_names.push_back(CalibrationKey(value.get()));
+        }
+        std::sort(tensor_names.begin(), tensor_names.end());
+
+        const std::string cache_path = cache_dir_.empty() ? std::string() : GetEngineCachePath(model_bytes, tensor_names);
+        std::unique_ptr<nvinfer1::ICudaEngine> engine;
+        if (!cache_path.empty()) {
+            std::ifstream file(cache_path, std::ios::binary);
+            if (file) {
+                const std::string plan((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                engine.reset(runtime_->deserializeCudaEngine(plan.data(), plan.size()));
+                if (engine) {
+                    LOG_INFO("TensorRT engine loaded from cache: " + cache_path);
+                } else {
+                    LOG_WARNING("TensorRT engine cache unreadable, rebuilding: " + cache_path);
+                }
+            }
+        }
+        if (!engine) {
+            std::string plan;
+            status = BuildEngine(model_bytes, &plan);
+            if (!status.IsOk()) {
+                return status;
+            }
+            engine.reset(runtime_->deserializeCudaEngine(plan.data(), plan.size()));
+            if (!engine) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to deserialize built TensorRT engine");
+            }
+            // 先写临时文件再改名，并发启动的会话不会读到写了一半的引擎
+            if (!cache_path.empty()) {
+                const std::string temp_path = cache_path + ".tmp" + std::to_string(reinterpret_cast<uintptr_t>(this));
+                std::ofstream file(temp_path, std::ios::binary);
+                file.write(plan.data(), static_cast<std::streamsize>(plan.size()));
+                file.close();
+                if (file && std::rename(temp_path.c_str(), cache_path.c_str()) == 0) {
+                    LOG_INFO("TensorRT engine cached: " + cache_path);
+                } else {
+                    std::remove(temp_path.c_str());
+                    LOG_WARNING("TensorRT engine not cached: " + cache_path);
+                }
+            }
+        }
+
+        auto compiled = std::make_unique<TRTSubgraph>(std::move(engine), std::move(input_names), std::move(output_names));
+        if (!compiled->IsValid()) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create TensorRT execution context");
+        }
+        subgraphs_[fused_node] = std::move(compiled);
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "TensorRT backend only executes delegated subgraphs: " + node->GetOpType());
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_INVALID_STATE,
+                                   "Delegated subgraph input has no tensor: " + input->GetName());
+            }
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs, stream_);
+    }
+};
+
+// 注册TensorRT执行提供者
+namespace {
+    void RegisterTensorRTExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("TensorRTExecutionProvider", []() {
+            return std::make_unique<TensorRTExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("TensorRT", []() {
+            return std::make_unique<TensorRTExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterTensorRTExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_TENSORRT未定义
+
+namespace inferunity {
+    // TensorRT未启用时的占位实现
+    // 注册函数为空，不会注册TensorRT后端
+}
+
+#endif  // INFERUNITY_USE_TENSORRT
@@ -0,0 +1,1327 @@
+// Vulkan执行提供者
+// 面向没有CUDA的Android与AMD/Intel集显：Conv、GEMM、逐元素、池化与Softmax由SPIR-V计算着色器执行
+// （见vulkan_shaders/，构建时由glslc编译），其余算子形状或属性不适用时在主机上执行。
+// 张量内存来自主机可见的设备内存（集显与移动端上即统一内存），由CachingDeviceAllocator在大块
+// VkDeviceMemory上子分配；映射地址就是张量的数据指针，主机侧算子与拷贝可以直接读写
+
+#include "inferunity/backend.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/memory.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "operators/conv_kernels.h"
+#include "operators/matmul_kernels.h"
+#include "operators/pooling.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_VULKAN
+#include <vulkan/vulkan.h>
+
+namespace inferunity {
+
+namespace {
+
+// glslc -mfmt=c生成的SPIR-V初始化列表
+const uint32_t kUnaryFp32[] =
+#include "unary_fp32.spv.h"
+;
+const uint32_t kUnaryFp16[] =
+#include "unary_fp16.spv.h"
+;
+const uint32_t kBinaryFp32[] =
+#include "binary_fp32.spv.h"
+;
+const uint32_t kBinaryFp16[] =
+#include "binary_fp16.spv.h"
+;
+const uint32_t kGemmFp32[] =
+#include "gemm_fp32.spv.h"
+;
+const uint32_t kGemmFp16[] =
+#include "gemm_fp16.spv.h"
+;
+const uint32_t kConv2dFp32[] =
+#include "conv2d_fp32.spv.h"
+;
+const uint32_t kConv2dFp16[] =
+#include "conv2d_fp16.spv.h"
+;
+const uint32_t kPool2dFp32[] =
+#include "pool2d_fp32.spv.h"
+;
+const uint32_t kPool2dFp16[] =
+#include "pool2d_fp16.spv.h"
+;
+const uint32_t kSoftmaxFp32[] =
+#include "softmax_fp32.spv.h"
+;
+const uint32_t kSoftmaxFp16[] =
+#include "softmax_fp16.spv.h"
+;
+
+enum class VulkanShader { UNARY, BINARY, GEMM, CONV2D, POOL2D, SOFTMAX, COUNT };
+
+struct ShaderInfo {
+    const uint32_t* fp32;
+    size_t fp32_bytes;
+    const uint32_t* fp16;
+    size_t fp16_bytes;
+    uint32_t num_bindings;
+    uint32_t push_constant_bytes;
+};
+
+// 推送常量的布局与着色器中的Params块一一对应
+struct UnaryParams { uint32_t count, op; float alpha, beta; };
+struct BinaryParams { uint32_t out_dims[4], a_strides[4], b_strides[4]; uint32_t count, op; };
+struct GemmParams {
+    uint32_t M, N, K, batch1;
+    uint32_t a_batch0, a_batch1, b_batch0, b_batch1;
+    uint32_t a_row, a_col, b_row, b_col;
+    uint32_t bias_mode, bias_count;
+    float alpha, beta;
+    uint32_t relu;
+};
+struct Conv2dParams {
+    uint32_t batch, in_c, in_h, in_w, out_c, out_h, out_w, kernel_h, kernel_w;
+    uint32_t stride_h, stride_w, pad_top, pad_left, dilation_h, dilation_w, group, has_bias, relu;
+};
+struct Pool2dParams {
+    uint32_t planes, in_h, in_w, out_h, out_w, kernel_h, kernel_w, stride_h, stride_w;
+    uint32_t pad_top, pad_left, mode, count_include_pad;
+};
+struct SoftmaxParams { uint32_t rows, cols, log_softmax; };
+
+const ShaderInfo& GetShaderInfo(VulkanShader shader) {
+    static const ShaderInfo infos[] = {
+        {kUnaryFp32, sizeof(kUnaryFp32), kUnaryFp16, sizeof(kUnaryFp16), 2, sizeof(UnaryParams)},
+        {kBinaryFp32, sizeof(kBinaryFp32), kBinaryFp16, sizeof(kBinaryFp16), 3, sizeof(BinaryParams)},
+        {kGemmFp32, sizeof(kGemmFp32), kGemmFp16, sizeof(kGemmFp16), 4, sizeof(GemmParams)},
+        {kConv2dFp32, sizeof(kConv2dFp32), kConv2dFp16, sizeof(kConv2dFp16), 4, sizeof(Conv2dParams)},
+        {kPool2dFp32, sizeof(kPool2dFp32), kPool2dFp16, sizeof(kPool2dFp16), 2, sizeof(Pool2dParams)},
+        {kSoftmaxFp32, sizeof(kSoftmaxFp32), kSoftmaxFp16, sizeof(kSoftmaxFp16), 2, sizeof(SoftmaxParams)},
+    };
+    return infos[static_cast<int>(shader)];
+}
+
+// 进程内共享的Vulkan实例、逻辑设备与计算队列；没有可用的Vulkan设备时Get()返回nullptr
+class VulkanContext {
+public:
+    static std::shared_ptr<VulkanContext> Get() {
+        static std::shared_ptr<VulkanContext> context = []() {
+            auto created = std::make_shared<VulkanContext>();
+            if (!created->Initialize()) {
+                return std::shared_ptr<VulkanContext>();
+            }
+            return created;
+        }();
+        return context;
+    }
+
+    ~VulkanContext() {
+        if (device_) {
+            vkDeviceWaitIdle(device_);
+            if (pipeline_cache_) {
+                vkDestroyPipelineCache(device_, pipeline_cache_, nullptr);
+            }
+            vkDestroyDevice(device_, nullptr);
+        }
+        if (instance_) {
+            vkDestroyInstance(instance_, nullptr);
+        }
+    }
+
+    VkDevice GetDevice() const { return device_; }
+    VkQueue GetQueue() const { return queue_; }
+    uint32_t GetQueueFamily() const { return queue_family_; }
+    VkPipelineCache GetPipelineCache() const { return pipeline_cache_; }
+    const VkPhysicalDeviceProperties& GetProperties() const { return properties_; }
+    bool SupportsFp16Storage() const { return fp16_storage_; }
+    // 多个提供者共用一个队列，提交需要互斥
+    std::mutex& GetQueueMutex() { return queue_mutex_; }
+
+    // 依次尝试设备本地且主机可见、仅主机可见的内存类型
+    int FindMemoryType(uint32_t type_bits, bool device_local) const {
+        const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        const VkMemoryPropertyFlags wanted = device_local ? (host | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) : host;
+        for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+            if ((type_bits & (1u << i)) && (memory_properties_.memoryTypes[i].propertyFlags & wanted) == wanted) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // 段（一次vkAllocateMemory）的映射地址 -> 覆盖整段的VkBuffer
+    void RegisterSegment(void* base, size_t size, VkBuffer buffer, VkDeviceMemory memory) {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        segments_[reinterpret_cast<uintptr_t>(base)] = {size, buffer, memory};
+    }
+
+    bool UnregisterSegment(void* base, VkBuffer* buffer, VkDeviceMemory* memory) {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        auto it = segments_.find(reinterpret_cast<uintptr_t>(base));
+        if (it == segments_.end()) {
+            return false;
+        }
+        *buffer = it->second.buffer;
+        *memory = it->second.memory;
+        segments_.erase(it);
+        return true;
+    }
+
+    // 映射地址 -> 所在段的VkBuffer与偏移；不在任何段中（主机内存）时返回false
+    bool Resolve(const void* ptr, VkBuffer* buffer, VkDeviceSize* offset, VkDeviceSize* remaining) const {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        auto it = segments_.upper_bound(address);
+        if (it == segments_.begin()) {
+            return false;
+        }
+        --it;
+        if (address >= it->first + it->second.size) {
+            return false;
+        }
+        *buffer = it->second.buffer;
+        *offset = address - it->first;
+        *remaining = it->second.size - *offset;
+        return true;
+    }
+
+private:
+    struct Segment {
+        size_t size;
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+    };
+
+    bool Initialize() {
+        VkApplicationInfo app = {};
+        app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        app.pApplicationName = "InferUnity";
+        app.pEngineName = "InferUnity";
+        app.apiVersion = VK_API_VERSION_1_1;
+        VkInstanceCreateInfo instance_info = {};
+        instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        instance_info.pApplicationInfo = &app;
+        if (vkCreateInstance(&instance_info, nullptr, &instance_) != VK_SUCCESS) {
+            instance_ = VK_NULL_HANDLE;
+            return false;
+        }
+
+        // 选择带计算队列的设备：独显优先，其次集显
+        uint32_t count = 0;
+        vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+        std::vector<VkPhysicalDevice> devices(count);
+        vkEnumeratePhysicalDevices(instance_, &count, devices.data());
+        int best_score = -1;
+        for (VkPhysicalDevice candidate : devices) {
+            uint32_t family_count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &family_count, nullptr);
+            std::vector<VkQueueFamilyProperties> families(family_count);
+            vkGetPhysicalDeviceQueueFamilyProperties(candidate, &family_count, families.data());
+            for (uint32_t f = 0; f < family_count; ++f) {
+                if (!(families[f].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+                    continue;
+                }
+                VkPhysicalDeviceProperties properties;
+                vkGetPhysicalDeviceProperties(candidate, &properties);
+                const int score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 3
+                    : properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 2 : 1;
+                if (score > best_score) {
+                    best_score = score;
+                    physical_device_ = candidate;
+                    queue_family_ = f;
+                    properties_ = properties;
+                }
+                break;
+            }
+        }
+        if (!physical_device_) {
+            return false;
+        }
+        vkGetPhysicalDeviceMemoryProperties(physical_device_, &memory_properties_);
+
+        // fp16存储只需要storageBuffer16BitAccess，计算仍为fp32
+        VkPhysicalDevice16BitStorageFeatures storage16 = {};
+        storage16.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+        if (properties_.apiVersion >= VK_API_VERSION_1_1) {
+            VkPhysicalDeviceFeatures2 features = {};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &storage16;
+            vkGetPhysicalDeviceFeatures2(physical_device_, &features);
+        }
+        fp16_storage_ = storage16.storageBuffer16BitAccess == VK_TRUE;
+        VkPhysicalDevice16BitStorageFeatures enabled16 = {};
+        enabled16.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+        enabled16.storageBuffer16BitAccess = fp16_storage_ ? VK_TRUE : VK_FALSE;
+
+        const float priority = 1.0f;
+        VkDeviceQueueCreateInfo queue_info = {};
+        queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_info.queueFamilyIndex = queue_family_;
+        queue_info.queueCount = 1;
+        queue_info.pQueuePriorities = &priority;
+        VkDeviceCreateInfo device_info = {};
+        device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        device_info.pNext = fp16_storage_ ? &enabled16 : nullptr;
+        device_info.queueCreateInfoCount = 1;
+        device_info.pQueueCreateInfos = &queue_info;
+        if (vkCreateDevice(physical_device_, &device_info, nullptr, &device_) != VK_SUCCESS) {
+            device_ = VK_NULL_HANDLE;
+            return false;
+        }
+        vkGetDeviceQueue(device_, queue_family_, 0, &queue_);
+
+        VkPipelineCacheCreateInfo cache_info = {};
+        cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        vkCreatePipelineCache(device_, &cache_info, nullptr, &pipeline_cache_);
+
+        LOG_INFO(std::string("Vulkan device: ") + properties_.deviceName +
+                 (fp16_storage_ ? " (fp16 storage)" : ""));
+        return true;
+    }
+
+    VkInstance instance_ = VK_NULL_HANDLE;
+    VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkQueue queue_ = VK_NULL_HANDLE;
+    uint32_t queue_family_ = 0;
+    VkPipelineCache pipeline_cache_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties_ = {};
+    VkPhysicalDeviceMemoryProperties memory_properties_ = {};
+    bool fp16_storage_ = false;
+    std::mutex queue_mutex_;
+    mutable std::mutex segments_mutex_;
+    std::map<uintptr_t, Segment> segments_;
+};
+
+// 段的分配与释放：每段一个持久映射的VkDeviceMemory和覆盖整段的存储缓冲。
+// CachingDeviceAllocator在段内按256字节对齐切分，不超过Vulkan规定的minStorageBufferOffsetAlignment上限
+class VulkanMemoryBackend : public DeviceMemoryBackend {
+public:
+    explicit VulkanMemoryBackend(std::shared_ptr<VulkanContext> context) : context_(std::move(context)) {}
+
+    void* RawAllocate(size_t size) override {
+        VkDevice device = context_->GetDevice();
+        VkBufferCreateInfo buffer_info = {};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = size;
+        buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+            return nullptr;
+        }
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+        // 设备本地且主机可见的堆在没有Resizable BAR的独显上只有256MB，分配失败时退回系统内存
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        for (bool device_local : {true, false}) {
+            const int type = context_->FindMemoryType(requirements.memoryTypeBits, device_local);
+            if (type < 0) {
+                continue;
+            }
+            VkMemoryAllocateInfo alloc_info = {};
+            alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            alloc_info.allocationSize = requirements.size;
+            alloc_info.memoryTypeIndex = static_cast<uint32_t>(type);
+            if (vkAllocateMemory(device, &alloc_info, nullptr, &memory) == VK_SUCCESS) {
+                break;
+            }
+            memory = VK_NULL_HANDLE;
+        }
+        void* mapped = nullptr;
+        if (!memory || vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS ||
+            vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+            if (memory) {
+                vkFreeMemory(device, memory, nullptr);
+            }
+            vkDestroyBuffer(device, buffer, nullptr);
+            return nullptr;
+        }
+        // 段内偏移与映射地址同余，映射地址未按存储缓冲偏移对齐时子分配的偏移也不对齐
+        const VkDeviceSize alignment = context_->GetProperties().limits.minStorageBufferOffsetAlignment;
+        if (alignment > 1 && reinterpret_cast<uintptr_t>(mapped) % alignment != 0) {
+            LOG_ERROR("Vulkan mapped memory is not aligned to minStorageBufferOffsetAlignment");
+            vkUnmapMemory(device, memory);
+            vkFreeMemory(device, memory, nullptr);
+            vkDestroyBuffer(device, buffer, nullptr);
+            return nullptr;
+        }
+        context_->RegisterSegment(mapped, size, buffer, memory);
+        return mapped;
+    }
+
+    void RawFree(void* ptr) override {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        if (!context_->UnregisterSegment(ptr, &buffer, &memory)) {
+            return;
+        }
+        VkDevice device = context_->GetDevice();
+        vkUnmapMemory(device, memory);
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+    }
+
+    // 提供者每次提交后都等待完成，空闲块不会仍被在途的命令缓冲引用
+    void SynchronizeDevice() override {
+        vkDeviceWaitIdle(context_->GetDevice());
+    }
+
+private:
+    std::shared_ptr<VulkanContext> context_;
+};
+
+std::shared_ptr<CachingDeviceAllocator> GetVulkanAllocator(const std::shared_ptr<VulkanContext>& context) {
+    static std::shared_ptr<CachingDeviceAllocator> allocator =
+        std::make_shared<CachingDeviceAllocator>(std::make_unique<VulkanMemoryBackend>(context));
+    return allocator;
+}
+
+// Vulkan设备：内存是主机可见的映射内存，拷贝直接在主机上完成；执行提供者每次提交后都等待完成，
+// 设备没有异步的流
+class VulkanDevice : public Device {
+public:
+    VulkanDevice(std::shared_ptr<VulkanContext> context, std::shared_ptr<CachingDeviceAllocator> allocator)
+        : context_(std::move(context)), allocator_(std::move(allocator)) {}
+
+    DeviceType GetType() const override { return DeviceType::VULKAN; }
+    std::string GetName() const override { return std::string("Vulkan:") + context_->GetProperties().deviceName; }
+
+    void* Allocate(size_t size) override { return allocator_->Allocate(size); }
+    void Free(void* ptr) override { allocator_->Free(ptr); }
+    void* AllocateAligned(size_t size, size_t alignment) override {
+        return allocator_->AllocateAligned(size, alignment);
+    }
+
+    Status Copy(void* dst, const void* src, size_t size) override {
+        std::memcpy(dst, src, size);
+        return Status::Ok();
+    }
+    Status CopyFromHost(void* dst, const void* src, size_t size) override { return Copy(dst, src, size); }
+    Status CopyToHost(void* dst, const void* src, size_t size) override { return Copy(dst, src, size); }
+
+    Status Synchronize() override {
+        std::lock_guard<std::mutex> lock(context_->GetQueueMutex());
+        return vkQueueWaitIdle(context_->GetQueue()) == VK_SUCCESS
+            ? Status::Ok() : Status::Error(StatusCode::ERROR_DEVICE_ERROR, "vkQueueWaitIdle failed");
+    }
+
+    void* CreateStream() override { return nullptr; }
+    void DestroyStream(void* stream) override { (void)stream; }
+    Status SynchronizeStream(void* stream) override {
+        (void)stream;
+        return Synchronize();
+    }
+
+private:
+    std::shared_ptr<VulkanContext> context_;
+    std::shared_ptr<CachingDeviceAllocator> allocator_;
+};
+
+struct VulkanPipeline {
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+};
+
+bool IsShaderOp(const std::string& op_type) {
+    static const std::unordered_set<std::string> ops = {
+        "Conv", "FusedConvReLU", "MatMul", "Gemm", "FusedMatMulAdd",
+        "Add", "Sub", "Mul", "Div", "Relu", "Sigmoid", "Tanh", "LeakyRelu", "Clip",
+        "MaxPool", "AveragePool", "GlobalMaxPool", "GlobalAveragePool", "Softmax", "LogSoftmax"
+    };
+    return ops.count(op_type) > 0;
+}
+
+template <typename T>
+bool FitsUint32(T value) {
+    return value >= 0 && static_cast<uint64_t>(value) <= UINT32_MAX;
+}
+
+} // namespace
+
+class VulkanExecutionProvider : public ExecutionProvider {
+private:
+    // 一次记录好的工作：命令缓冲段，或段之间在主机上完成的动作（输入上传、输出下载、主机回退的算子）
+    struct CapturedStep {
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+        std::function<Status()> host_action;
+    };
+
+    std::shared_ptr<VulkanContext> context_;
+    std::shared_ptr<CachingDeviceAllocator> allocator_;
+    std::shared_ptr<VulkanDevice> device_;
+    VulkanPipeline pipelines_[static_cast<int>(VulkanShader::COUNT)][2];
+    VkCommandPool command_pool_ = VK_NULL_HANDLE;
+    VkCommandBuffer eager_commands_ = VK_NULL_HANDLE;
+    VkFence fence_ = VK_NULL_HANDLE;
+    // 逐节点执行用的描述符池每次提交后重置；捕获的描述符集保留到ResetGraph
+    std::vector<VkDescriptorPool> eager_pools_;
+    std::vector<VkDescriptorPool> capture_pools_;
+
+    // 整图捕获 (见ExecutionProvider::CaptureBegin)：每个算子作为一次dispatch记录进当前命令缓冲段，
+    // 重放时依次提交各段并在段之间完成主机动作，整个计划只有段数次提交
+    bool capturing_ = false;
+    VkCommandBuffer capture_segment_ = VK_NULL_HANDLE;
+    std::vector<CapturedStep> captured_;
+    bool captured_ready_ = false;
+
+    // 主机上的常量（权重）上传一次后常驻设备内存；其余主机输入每次执行时拷入暂存张量
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> uploaded_constants_;
+    std::map<std::pair<const Node*, size_t>, std::shared_ptr<Tensor>> staging_;
+    std::unordered_set<const Value*> graph_inputs_;
+    // 解析属性（ParseConv2DParams等）与主机回退共用的算子实例
+    std::unordered_map<const Node*, std::unique_ptr<Operator>> operators_;
+    std::mutex mutex_;
+
+    bool IsResident(const Tensor* tensor) const {
+        VkBuffer buffer;
+        VkDeviceSize offset, remaining;
+        return tensor && tensor->GetData() && context_->Resolve(tensor->GetData(), &buffer, &offset, &remaining);
+    }
+
+    Operator* GetOperator(const Node* node) {
+        auto it = operators_.find(node);
+        if (it != operators_.end()) {
+            return it->second.get();
+        }
+        auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+        if (!op) {
+            return nullptr;
+        }
+        ApplyNodeAttributes(*node, op.get());
+        Operator* raw = op.get();
+        operators_[node] = std::move(op);
+        return raw;
+    }
+
+    Status GetPipeline(VulkanShader shader, bool fp16, VulkanPipeline** result) {
+        VulkanPipeline& entry = pipelines_[static_cast<int>(shader)][fp16 ? 1 : 0];
+        *result = &entry;
+        if (entry.pipeline) {
+            return Status::Ok();
+        }
+        const ShaderInfo& info = GetShaderInfo(shader);
+        VkDevice device = context_->GetDevice();
+
+        std::vector<VkDescriptorSetLayoutBinding> bindings(info.num_bindings);
+        for (uint32_t b = 0; b < info.num_bindings; ++b) {
+            bindings[b] = {};
+            bindings[b].binding = b;
+            bindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[b].descriptorCount = 1;
+            bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo set_info = {};
+        set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_info.bindingCount = info.num_bindings;
+        set_info.pBindings = bindings.data();
+        VkPushConstantRange push_range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, info.push_constant_bytes};
+        VkPipelineLayoutCreateInfo layout_info = {};
+        layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_info.setLayoutCount = 1;
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges = &push_range;
+        VkShaderModuleCreateInfo module_info = {};
+        module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_info.codeSize = fp16 ? info.fp16_bytes : info.fp32_bytes;
+        module_info.pCode = fp16 ? info.fp16 : info.fp32;
+        VkShaderModule module = VK_NULL_HANDLE;
+        layout_info.pSetLayouts = &entry.set_layout;
+        if (vkCreateDescriptorSetLayout(device, &set_info, nullptr, &entry.set_layout) != VK_SUCCESS ||
+            vkCreatePipelineLayout(device, &layout_info, nullptr, &entry.layout) != VK_SUCCESS ||
+            vkCreateShaderModule(device, &module_info, nullptr, &module) != VK_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to create Vulkan pipeline layout");
+        }
+        VkComputePipelineCreateInfo pipeline_info = {};
+        pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_info.stage.module = module;
+        pipeline_info.stage.pName = "main";
+        pipeline_info.layout = entry.layout;
+        const VkResult created = vkCreateComputePipelines(device, context_->GetPipelineCache(), 1,
+                                                          &pipeline_info, nullptr, &entry.pipeline);
+        vkDestroyShaderModule(device, module, nullptr);
+        if (created != VK_SUCCESS) {
+            entry.pipeline = VK_NULL_HANDLE;
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to create Vulkan compute pipeline");
+        }
+        return Status::Ok();
+    }
+
+    Status AllocateDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorSet* set) {
+        std::vector<VkDescriptorPool>& pools = capturing_ ? capture_pools_ : eager_pools_;
+        VkDescriptorSetAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &layout;
+        if (!pools.empty()) {
+            alloc_info.descriptorPool = pools.back();
+            if (vkAllocateDescriptorSets(context_->GetDevice(), &alloc_info, set) == VK_SUCCESS) {
+                return Status::Ok();
+            }
+        }
+        // 当前池用尽时新建一个
+        VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024};
+        VkDescriptorPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.maxSets = 256;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        if (vkCreateDescriptorPool(context_->GetDevice(), &pool_info, nullptr, &pool) != VK_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to create Vulkan descriptor pool");
+        }
+        pools.push_back(pool);
+        alloc_info.descriptorPool = pool;
+        if (vkAllocateDescriptorSets(context_->GetDevice(), &alloc_info, set) != VK_SUCCESS) {
+            return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to allocate Vulkan descriptor set");
+        }
+        return Status::Ok();
+    }
+
+    Status AllocateCommandBuffer(VkCommandBuffer* commands) {
+        VkCommandBufferAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = command_pool_;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = 1;
+        return vkAllocateCommandBuffers(context_->GetDevice(), &alloc_info, commands) == VK_SUCCESS
+            ? Status::Ok() : Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to allocate Vulkan command buffer");
+    }
+
+    Status BeginCommands(VkCommandBuffer commands, bool reusable) {
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = reusable ? 0 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        return vkBeginCommandBuffer(commands, &begin_info) == VK_SUCCESS
+            ? Status::Ok() : Status::Error(StatusCode::ERROR_DEVICE_ERROR, "vkBeginCommandBuffer failed");
+    }
+
+    // 段末尾让着色器写入对主机可见，再结束记录
+    Status EndCommands(VkCommandBuffer commands) {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        return vkEndCommandBuffer(commands) == VK_SUCCESS
+            ? Status::Ok() : Status::Error(StatusCode::ERROR_DEVICE_ERROR, "vkEndCommandBuffer failed");
+    }
+
+    Status SubmitAndWait(VkCommandBuffer commands) {
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &commands;
+        {
+            std::lock_guard<std::mutex> lock(context_->GetQueueMutex());
+            if (vkQueueSubmit(context_->GetQueue(), 1, &submit, fence_) != VK_SUCCESS) {
+                return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "vkQueueSubmit failed");
+            }
+        }
+        const VkResult waited = vkWaitForFences(context_->GetDevice(), 1, &fence_, VK_TRUE, UINT64_MAX);
+        vkResetFences(context_->GetDevice(), 1, &fence_);
+        return waited == VK_SUCCESS ? Status::Ok()
+                                    : Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Vulkan execution failed");
+    }
+
+    // 捕获期间的主机动作：先结束当前段，动作排在它之后、下一段之前；否则立即执行
+    Status RunOnHost(std::function<Status()> action) {
+        if (!capturing_) {
+            return action();
+        }
+        Status status = CloseCaptureSegment();
+        if (!status.IsOk()) {
+            return status;
+        }
+        CapturedStep step;
+        step.host_action = std::move(action);
+        captured_.push_back(std::move(step));
+        return Status::Ok();
+    }
+
+    Status CloseCaptureSegment() {
+        if (!capture_segment_) {
+            return Status::Ok();
+        }
+        Status status = EndCommands(capture_segment_);
+        CapturedStep step;
+        step.commands = capture_segment_;
+        captured_.push_back(step);
+        capture_segment_ = VK_NULL_HANDLE;
+        return status;
+    }
+
+    // 记录一次dispatch：捕获时追加到当前段，否则单独提交并等待完成
+    Status Dispatch(VulkanShader shader, bool fp16, const std::vector<const Tensor*>& buffers,
+                    const void* push_constants, uint32_t groups_x, uint32_t groups_y, uint32_t groups_z) {
+        if (groups_x == 0 || groups_y == 0 || groups_z == 0) {
+            return Status::Ok();
+        }
+        VulkanPipeline* pipeline = nullptr;
+        Status status = GetPipeline(shader, fp16, &pipeline);
+        if (!status.IsOk()) {
+            return status;
+        }
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        status = AllocateDescriptorSet(pipeline->set_layout, &set);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<VkDescriptorBufferInfo> infos(buffers.size());
+        std::vector<VkWriteDescriptorSet> writes(buffers.size());
+        for (size_t b = 0; b < buffers.size(); ++b) {
+            VkDeviceSize remaining = 0;
+            if (!context_->Resolve(buffers[b]->GetData(), &infos[b].buffer, &infos[b].offset, &remaining)) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Tensor is not in Vulkan device memory");
+            }
+            infos[b].range = std::min<VkDeviceSize>(remaining, std::max<size_t>((buffers[b]->GetSizeInBytes() + 3) & ~size_t(3), 4));
+            writes[b] = {};
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = set;
+            writes[b].dstBinding = static_cast<uint32_t>(b);
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &infos[b];
+        }
+        vkUpdateDescriptorSets(context_->GetDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        VkCommandBuffer commands = eager_commands_;
+        if (capturing_) {
+            if (!capture_segment_) {
+                status = AllocateCommandBuffer(&capture_segment_);
+                if (status.IsOk()) {
+                    status = BeginCommands(capture_segment_, true);
+                }
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            commands = capture_segment_;
+        } else {
+            vkResetCommandBuffer(commands, 0);
+            status = BeginCommands(commands, false);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+        vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &set, 0, nullptr);
+        vkCmdPushConstants(commands, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           GetShaderInfo(shader).push_constant_bytes, push_constants);
+        vkCmdDispatch(commands, groups_x, groups_y, groups_z);
+        // 后续dispatch读取本次的输出
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+        if (capturing_) {
+            return Status::Ok();
+        }
+        status = EndCommands(commands);
+        if (status.IsOk()) {
+            status = SubmitAndWait(commands);
+        }
+        for (VkDescriptorPool pool : eager_pools_) {
+            vkResetDescriptorPool(context_->GetDevice(), pool, 0);
+        }
+        return status;
+    }
+
+    // count个元素的一维调度，每组64个调用
+    Status Dispatch1D(VulkanShader shader, bool fp16, const std::vector<const Tensor*>& buffers,
+                      const void* push_constants, uint64_t count) {
+        const uint64_t groups = (count + 63) / 64;
+        const uint64_t max_x = context_->GetProperties().limits.maxComputeWorkGroupCount[0];
+        const uint64_t x = std::min<uint64_t>(groups, max_x);
+        const uint64_t y = x ? (groups + x - 1) / x : 0;
+        if (y > context_->GetProperties().limits.maxComputeWorkGroupCount[1]) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Tensor too large for one Vulkan dispatch");
+        }
+        return Dispatch(shader, fp16, buffers, push_constants, static_cast<uint32_t>(x), static_cast<uint32_t>(y), 1);
+    }
+
+    // 着色器的输入：设备内存中的张量直接绑定；主机上的常量上传一次，其余主机输入拷入暂存张量
+    Status ResolveInput(const Node* node, size_t index, Tensor* tensor, const Tensor** resolved) {
+        if (IsResident(tensor)) {
+            *resolved = tensor;
+            return Status::Ok();
+        }
+        const Value* value = node->GetInputs()[index];
+        if (!value->GetProducer() && !graph_inputs_.count(value)) {
+            auto& uploaded = uploaded_constants_[tensor];
+            if (!uploaded) {
+                uploaded = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::VULKAN);
+                std::memcpy(uploaded->GetData(), tensor->GetData(), tensor->GetSizeInBytes());
+            }
+            *resolved = uploaded.get();
+            return Status::Ok();
+        }
+        auto& staging = staging_[{node, index}];
+        if (!staging || staging->GetShape().dims != tensor->GetShape().dims ||
+            staging->GetDataType() != tensor->GetDataType()) {
+            staging = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::VULKAN);
+        }
+        Tensor* dst = staging.get();
+        *resolved = dst;
+        return RunOnHost([tensor, dst]() {
+            std::memcpy(dst->GetData(), tensor->GetData(), tensor->GetSizeInBytes());
+            return Status::Ok();
+        });
+    }
+
+    // 按算子与形状选择着色器并记录dispatch；*handled为false时由主机执行
+    Status ExecuteShader(Node* node, const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs,
+                         bool* handled) {
+        *handled = false;
+        const std::string& op_type = node->GetOpType();
+        Operator* op = GetOperator(node);
+        if (!op || inputs.empty() || outputs.size() != 1 || !IsResident(outputs[0])) {
+            return Status::Ok();
+        }
+        Tensor* output = outputs[0];
+        const DataType dtype = output->GetDataType();
+        const bool fp16 = dtype == DataType::FLOAT16;
+        if ((dtype != DataType::FLOAT32 && !fp16) || (fp16 && !context_->SupportsFp16Storage()) ||
+            !FitsUint32(static_cast<int64_t>(output->GetElementCount()))) {
+            return Status::Ok();
+        }
+        // 浮点输入（权重、bias）与输出同一类型；Clip的min/max与Softmax之外的整数输入不走着色器
+        const size_t float_inputs = op_type == "Clip" ? 1 : inputs.size();
+        for (size_t i = 0; i < float_inputs; ++i) {
+            if (!inputs[i] || inputs[i]->GetDataType() != dtype || !inputs[i]->GetData()) {
+                return Status::Ok();
+            }
+        }
+        std::vector<const Tensor*> bound(float_inputs, nullptr);
+        auto bind_inputs = [&]() {
+            for (size_t i = 0; i < float_inputs; ++i) {
+                Status status = ResolveInput(node, i, inputs[i], &bound[i]);
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            return Status::Ok();
+        };
+        const uint32_t count = static_cast<uint32_t>(output->GetElementCount());
+
+        if (op_type == "Relu" || op_type == "Sigmoid" || op_type == "Tanh" || op_type == "LeakyRelu" ||
+            op_type == "Clip") {
+            UnaryParams params = {count, 0, 0.0f, 0.0f};
+            if (op_type == "Sigmoid") {
+                params.op = 1;
+            } else if (op_type == "Tanh") {
+                params.op = 2;
+            } else if (op_type == "LeakyRelu") {
+                params.op = 3;
+                params.alpha = op->GetFloatAttribute("alpha", 0.01f);
+            } else if (op_type == "Clip") {
+                // opset 11起min/max是输入，只接受FLOAT32标量
+                params.op = 4;
+                params.alpha = op->GetFloatAttribute("min", -3.402823466e38f);
+                params.beta = op->GetFloatAttribute("max", 3.402823466e38f);
+                for (size_t i = 1; i < inputs.size() && i < 3; ++i) {
+                    if (!inputs[i] || !inputs[i]->GetData() || inputs[i]->GetElementCount() == 0) {
+                        continue;
+                    }
+                    if (inputs[i]->GetDataType() != DataType::FLOAT32) {
+                        return Status::Ok();
+                    }
+                    (i == 1 ? params.alpha : params.beta) = *static_cast<const float*>(inputs[i]->GetData());
+                }
+            }
+            if (inputs[0]->GetElementCount() != output->GetElementCount()) {
+                return Status::Ok();
+            }
+            *handled = true;
+            Status status = bind_inputs();
+            return status.IsOk() ? Dispatch1D(VulkanShader::UNARY, fp16, {bound[0], output}, &params, count) : status;
+        }
+
+        if (op_type == "Add" || op_type == "Sub" || op_type == "Mul" || op_type == "Div") {
+            const std::vector<int64_t>& out_dims = output->GetShape().dims;
+            if (inputs.size() != 2 || out_dims.size() > 4) {
+                return Status::Ok();
+            }
+            BinaryParams params = {};
+            params.count = count;
+            params.op = op_type == "Add" ? 0 : op_type == "Sub" ? 1 : op_type == "Mul" ? 2 : 3;
+            // 右对齐补齐到4维；广播维的跨度为0
+            const size_t pad = 4 - out_dims.size();
+            for (size_t d = 0; d < 4; ++d) {
+                params.out_dims[d] = d < pad ? 1 : static_cast<uint32_t>(out_dims[d - pad]);
+            }
+            for (int operand = 0; operand < 2; ++operand) {
+                const std::vector<int64_t>& dims = inputs[operand]->GetShape().dims;
+                if (dims.size() > out_dims.size()) {
+                    return Status::Ok();
+                }
+                uint32_t* strides = operand == 0 ? params.a_strides : params.b_strides;
+                uint32_t stride = 1;
+                for (int d = 3; d >= 0; --d) {
+                    const size_t from_end = 3 - static_cast<size_t>(d);
+                    const int64_t dim = from_end < dims.size() ? dims[dims.size() - 1 - from_end] : 1;
+                    if (dim != 1 && dim != params.out_dims[d]) {
+                        return Status::Ok();
+                    }
+                    strides[d] = dim == 1 ? 0 : stride;
+                    stride *= static_cast<uint32_t>(dim);
+                }
+            }
+            *handled = true;
+            Status status = bind_inputs();
+            return status.IsOk() ? Dispatch1D(VulkanShader::BINARY, fp16, {bound[0], bound[1], output}, &params, count)
+                                 : status;
+        }
+
+        if (op_type == "MatMul" || op_type == "Gemm" || op_type == "FusedMatMulAdd") {
+            const bool gemm = op_type == "Gemm";
+            const bool trans_a = op_type != "MatMul" && op->GetIntAttribute("transA", 0) != 0;
+            const bool trans_b = op_type != "MatMul" && op->GetIntAttribute("transB", 0) != 0;
+            const std::string activation = op->GetStringAttribute("activation", "");
+            if (inputs.size() < 2 || (!activation.empty() && activation != "relu")) {
+                return Status::Ok();
+            }
+            operators::MatMulShape shape;
+            if (!operators::ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(), trans_a, trans_b,
+                                               &shape).IsOk() ||
+                shape.batch_dims.size() > 2 || output->GetShape().dims != shape.output_dims) {
+                return Status::Ok();
+            }
+            GemmParams params = {};
+            params.M = static_cast<uint32_t>(shape.M);
+            params.N = static_cast<uint32_t>(shape.N);
+            params.K = static_cast<uint32_t>(shape.K);
+            params.batch1 = shape.batch_dims.size() == 2 ? static_cast<uint32_t>(shape.batch_dims[1]) : 1;
+            const size_t nb = shape.batch_dims.size();
+            params.a_batch0 = nb >= 1 ? static_cast<uint32_t>(shape.a_batch_strides[0]) : 0;
+            params.b_batch0 = nb >= 1 ? static_cast<uint32_t>(shape.b_batch_strides[0]) : 0;
+            params.a_batch1 = nb == 2 ? static_cast<uint32_t>(shape.a_batch_strides[1]) : 0;
+            params.b_batch1 = nb == 2 ? static_cast<uint32_t>(shape.b_batch_strides[1]) : 0;
+            params.a_row = shape.trans_a ? 1 : static_cast<uint32_t>(shape.lda);
+            params.a_col = shape.trans_a ? static_cast<uint32_t>(shape.lda) : 1;
+            params.b_row = shape.trans_b ? 1 : static_cast<uint32_t>(shape.ldb);
+            params.b_col = shape.trans_b ? static_cast<uint32_t>(shape.ldb) : 1;
+            params.alpha = op->GetFloatAttribute("alpha", 1.0f);
+            params.beta = gemm ? op->GetFloatAttribute("beta", 1.0f) : 1.0f;
+            params.relu = activation == "relu" ? 1 : 0;
+            const Tensor* bias = inputs.size() > 2 ? inputs[2] : nullptr;
+            if (bias && bias->GetElementCount() > 0) {
+                // bias的广播规则与FusedMatMulAdd一致
+                const std::vector<int64_t>& dims = bias->GetShape().dims;
+                const size_t bias_count = bias->GetElementCount();
+                if (bias_count == 1) {
+                    params.bias_mode = 3;
+                } else if (bias_count == params.M && params.M != 1 && dims.size() >= 2 && dims.back() == 1) {
+                    params.bias_mode = 2;
+                } else if (bias_count == params.N && dims.back() == shape.N) {
+                    params.bias_mode = 1;
+                } else if (bias_count == static_cast<size_t>(shape.M * shape.N) || bias_count == count) {
+                    params.bias_mode = 4;
+                    params.bias_count = static_cast<uint32_t>(bias_count);
+                } else {
+                    return Status::Ok();
+                }
+            }
+            const uint32_t batch = static_cast<uint32_t>(shape.batch_count);
+            if (batch > context_->GetProperties().limits.maxComputeWorkGroupCount[2]) {
+                return Status::Ok();
+            }
+            *handled = true;
+            Status status = bind_inputs();
+            if (!status.IsOk()) {
+                return status;
+            }
+            // 没有bias时绑定输出占位，着色器不会读取
+            const Tensor* bias_binding = params.bias_mode ? bound[2] : output;
+            return Dispatch(VulkanShader::GEMM, fp16, {bound[0], bound[1], bias_binding, output}, &params,
+                            (params.N + 15) / 16, (params.M + 15) / 16, batch);
+        }
+
+        if (op_type == "Conv" || op_type == "FusedConvReLU") {
+            operators::Conv2DParams conv;
+            if (inputs.size() < 2 || inputs[0]->GetShape().dims.size() != 4 ||
+                !operators::ParseConv2DParams(*op, inputs[0]->GetShape(), inputs[1]->GetShape(), &conv).IsOk() ||
+                output->GetShape().dims != std::vector<int64_t>{conv.batch, conv.out_c, conv.out_h, conv.out_w}) {
+                return Status::Ok();
+            }
+            const bool has_bias = inputs.size() > 2 && inputs[2]->GetElementCount() == static_cast<size_t>(conv.out_c);
+            Conv2dParams params = {
+                static_cast<uint32_t>(conv.batch), static_cast<uint32_t>(conv.in_c),
+                static_cast<uint32_t>(conv.in_h), static_cast<uint32_t>(conv.in_w),
+                static_cast<uint32_t>(conv.out_c), static_cast<uint32_t>(conv.out_h),
+                static_cast<uint32_t>(conv.out_w), static_cast<uint32_t>(conv.kernel_h),
+                static_cast<uint32_t>(conv.kernel_w), static_cast<uint32_t>(conv.stride_h),
+                static_cast<uint32_t>(conv.stride_w), static_cast<uint32_t>(conv.pad_top),
+                static_cast<uint32_t>(conv.pad_left), static_cast<uint32_t>(conv.dilation_h),
+                static_cast<uint32_t>(conv.dilation_w), static_cast<uint32_t>(conv.group),
+                has_bias ? 1u : 0u, op_type == "FusedConvReLU" ? 1u : 0u};
+            *handled = true;
+            Status status = bind_inputs();
+            if (!status.IsOk()) {
+                return status;
+            }
+            return Dispatch1D(VulkanShader::CONV2D, fp16, {bound[0], bound[1], has_bias ? bound[2] : output, output},
+                              &params, count);
+        }
+
+        if (op_type == "MaxPool" || op_type == "AveragePool" || op_type == "GlobalMaxPool" ||
+            op_type == "GlobalAveragePool") {
+            const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+            if (dims.size() != 4) {
+                return Status::Ok();
+            }
+            Pool2dParams params = {};
+            params.planes = static_cast<uint32_t>(dims[0] * dims[1]);
+            params.in_h = static_cast<uint32_t>(dims[2]);
+            params.in_w = static_cast<uint32_t>(dims[3]);
+            params.mode = op_type == "MaxPool" || op_type == "GlobalMaxPool" ? 0 : 1;
+            if (op_type == "GlobalMaxPool" || op_type == "GlobalAveragePool") {
+                params.out_h = params.out_w = 1;
+                params.kernel_h = params.in_h;
+                params.kernel_w = params.in_w;
+                params.stride_h = params.stride_w = 1;
+            } else {
+                const std::vector<int64_t> dilations = op->GetIntsAttribute("dilations", {});
+                operators::Pool2DParams pool;
+                if (std::any_of(dilations.begin(), dilations.end(), [](int64_t d) { return d != 1; }) ||
+                    !operators::ParsePool2DParams(*op, inputs[0]->GetShape(), &pool).IsOk()) {
+                    return Status::Ok();
+                }
+                params.out_h = static_cast<uint32_t>(pool.out_h);
+                params.out_w = static_cast<uint32_t>(pool.out_w);
+                params.kernel_h = static_cast<uint32_t>(pool.kernel_h);
+                params.kernel_w = static_cast<uint32_t>(pool.kernel_w);
+                params.stride_h = static_cast<uint32_t>(pool.stride_h);
+                params.stride_w = static_cast<uint32_t>(pool.stride_w);
+                params.pad_top = static_cast<uint32_t>(pool.pad_top);
+                params.pad_left = static_cast<uint32_t>(pool.pad_left);
+                params.count_include_pad = pool.count_include_pad ? 1 : 0;
+            }
+            if (output->GetShape().dims != std::vector<int64_t>{dims[0], dims[1], params.out_h, params.out_w}) {
+                return Status::Ok();
+            }
+            *handled = true;
+            Status status = bind_inputs();
+            return status.IsOk() ? Dispatch1D(VulkanShader::POOL2D, fp16, {bound[0], output}, &params, count) : status;
+        }
+
+        if (op_type == "Softmax" || op_type == "LogSoftmax") {
+            const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+            int64_t axis = op->GetIntAttribute("axis", -1);
+            if (axis < 0) {
+                axis += static_cast<int64_t>(dims.size());
+            }
+            if (dims.empty() || axis != static_cast<int64_t>(dims.size()) - 1 || dims.back() <= 0) {
+                return Status::Ok();
+            }
+            SoftmaxParams params = {count / static_cast<uint32_t>(dims.back()), static_cast<uint32_t>(dims.back()),
+                                    op_type == "LogSoftmax" ? 1u : 0u};
+            const uint32_t max_x = context_->GetProperties().limits.maxComputeWorkGroupCount[0];
+            const uint32_t x = std::min(params.rows, max_x);
+            const uint32_t y = x ? (params.rows + x - 1) / x : 0;
+            *handled = true;
+            Status status = bind_inputs();
+            return status.IsOk() ? Dispatch(VulkanShader::SOFTMAX, fp16, {bound[0], output}, &params, x, y, 1)
+                                 : status;
+        }
+        return Status::Ok();
+    }
+
+    // 跨设备拷贝：内存都可由主机直接访问，拷贝在主机上完成（捕获时排进重放的主机动作）
+    Status ExecuteMemcpy(Node* node) {
+        if (node->GetInputs().size() != 1 || node->GetOutputs().size() != 1 || !node->GetInputs()[0]->GetTensor()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, node->GetOpType() + " requires 1 input and 1 output");
+        }
+        const DeviceType target = node->GetOpType() == "MemcpyToDevice" ? DeviceType::VULKAN : DeviceType::CPU;
+        auto src = node->GetInputs()[0]->GetTensor();
+        Value* output = node->GetOutputs()[0];
+        auto dst = output->GetTensor();
+        if (!dst || dst->GetDeviceType() != target || dst->GetDataType() != src->GetDataType() ||
+            dst->GetShape().dims != src->GetShape().dims) {
+            dst = CreateTensor(src->GetShape(), src->GetDataType(), target);
+            output->SetTensor(dst);
+        }
+        return RunOnHost([src, dst]() {
+            std::memcpy(dst->GetData(), src->GetData(), src->GetSizeInBytes());
+            return Status::Ok();
+        });
+    }
+
+    void DestroyCaptured() {
+        for (const CapturedStep& step : captured_) {
+            if (step.commands) {
+                vkFreeCommandBuffers(context_->GetDevice(), command_pool_, 1, &step.commands);
+            }
+        }
+        captured_.clear();
+        if (capture_segment_) {
+            vkFreeCommandBuffers(context_->GetDevice(), command_pool_, 1, &capture_segment_);
+            capture_segment_ = VK_NULL_HANDLE;
+        }
+        for (VkDescriptorPool pool : capture_pools_) {
+            vkDestroyDescriptorPool(context_->GetDevice(), pool, nullptr);
+        }
+        capture_pools_.clear();
+        captured_ready_ = false;
+    }
+
+public:
+    VulkanExecutionProvider() : context_(VulkanContext::Get()) {
+        if (!context_) {
+            return;
+        }
+        allocator_ = GetVulkanAllocator(context_);
+        device_ = std::make_shared<VulkanDevice>(context_, allocator_);
+        // 放在Vulkan上的张量都从同一个子分配器取内存
+        SetMemoryAllocator(DeviceType::VULKAN, allocator_);
+
+        VkCommandPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        pool_info.queueFamilyIndex = context_->GetQueueFamily();
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateCommandPool(context_->GetDevice(), &pool_info, nullptr, &command_pool_) != VK_SUCCESS ||
+            !AllocateCommandBuffer(&eager_commands_).IsOk() ||
+            vkCreateFence(context_->GetDevice(), &fence_info, nullptr, &fence_) != VK_SUCCESS) {
+            LOG_ERROR("Failed to create Vulkan command pool");
+            device_.reset();
+        }
+    }
+
+    ~VulkanExecutionProvider() override {
+        if (!context_) {
+            return;
+        }
+        VkDevice device = context_->GetDevice();
+        DestroyCaptured();
+        uploaded_constants_.clear();
+        staging_.clear();
+        for (VkDescriptorPool pool : eager_pools_) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+        for (auto& shader : pipelines_) {
+            for (VulkanPipeline& entry : shader) {
+                if (entry.pipeline) vkDestroyPipeline(device, entry.pipeline, nullptr);
+                if (entry.layout) vkDestroyPipelineLayout(device, entry.layout, nullptr);
+                if (entry.set_layout) vkDestroyDescriptorSetLayout(device, entry.set_layout, nullptr);
+            }
+        }
+        if (fence_) {
+            vkDestroyFence(device, fence_, nullptr);
+        }
+        if (command_pool_) {
+            vkDestroyCommandPool(device, command_pool_, nullptr);
+        }
+    }
+
+    std::string GetName() const override { return "VulkanExecutionProvider"; }
+    DeviceType GetDeviceType() const override { return DeviceType::VULKAN; }
+    bool IsAvailable() const override { return device_ != nullptr; }
+
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        (void)device_id;
+        return device_;
+    }
+
+    int GetDeviceCount() const override { return device_ ? 1 : 0; }
+
+    // 着色器覆盖的算子与分区插入的拷贝；这些算子形状或属性不适用时在主机上执行
+    bool SupportsOperator(const std::string& op_type) const override {
+        return IsShaderOp(op_type) || op_type == "MemcpyToDevice" || op_type == "MemcpyFromDevice";
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        return OperatorRegistry::Instance().Create(op_type);
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    // 管线在编译时创建，第一次执行不再付出着色器编译的开销
+    Status CompileNode(Node* node) override {
+        if (!node || !device_) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null or Vulkan is unavailable");
+        }
+        static const std::unordered_map<std::string, VulkanShader> shaders = {
+            {"Conv", VulkanShader::CONV2D}, {"FusedConvReLU", VulkanShader::CONV2D},
+            {"MatMul", VulkanShader::GEMM}, {"Gemm", VulkanShader::GEMM}, {"FusedMatMulAdd", VulkanShader::GEMM},
+            {"Add", VulkanShader::BINARY}, {"Sub", VulkanShader::BINARY}, {"Mul", VulkanShader::BINARY},
+            {"Div", VulkanShader::BINARY}, {"Relu", VulkanShader::UNARY}, {"Sigmoid", VulkanShader::UNARY},
+            {"Tanh", VulkanShader::UNARY}, {"LeakyRelu", VulkanShader::UNARY}, {"Clip", VulkanShader::UNARY},
+            {"MaxPool", VulkanShader::POOL2D}, {"AveragePool", VulkanShader::POOL2D},
+            {"GlobalMaxPool", VulkanShader::POOL2D}, {"GlobalAveragePool", VulkanShader::POOL2D},
+            {"Softmax", VulkanShader::SOFTMAX}, {"LogSoftmax", VulkanShader::SOFTMAX}};
+        auto it = shaders.find(node->GetOpType());
+        if (it == shaders.end()) {
+            return Status::Ok();
+        }
+        const bool fp16 = !node->GetOutputs().empty() && node->GetOutputs()[0]->GetDataType() == DataType::FLOAT16;
+        if (fp16 && !context_->SupportsFp16Storage()) {
+            return Status::Ok();
+        }
+        VulkanPipeline* pipeline = nullptr;
+        return GetPipeline(it->second, fp16, &pipeline);
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        if (!graph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        graph_inputs_ = std::unordered_set<const Value*>(graph->GetInputs().begin(), graph->GetInputs().end());
+        operators_.clear();
+        staging_.clear();
+        for (const auto& node : graph->GetNodes()) {
+            if (node->GetDevice() == DeviceType::VULKAN) {
+                Status status = CompileNode(node.get());
+                if (!status.IsOk()) {
+                    LOG_WARNING("Vulkan node compilation failed: " + status.Message());
+                }
+            }
+        }
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        if (!node || !device_) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null or Vulkan is unavailable");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (node->GetOpType() == "MemcpyToDevice" || node->GetOpType() == "MemcpyFromDevice") {
+            return ExecuteMemcpy(node);
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                DataType dtype = output->GetDataType() == DataType::UNKNOWN ? DataType::FLOAT32 : output->GetDataType();
+                output->SetTensor(CreateTensor(output->GetShape(), dtype, DeviceType::VULKAN));
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+
+        bool handled = false;
+        Status status = ExecuteShader(node, inputs, outputs, &handled);
+        if (!status.IsOk() || handled) {
+            return status;
+        }
+
+        // 主机回退：映射内存可由主机算子直接读写
+        Operator* op = GetOperator(node);
+        if (!op) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Failed to create operator: " + node->GetOpType());
+        }
+        if (capturing_) {
+            LOG_WARNING("Vulkan graph capture runs " + node->GetOpType() + " on the host between command buffers");
+        }
+        return RunOnHost([op, inputs, outputs, ctx]() {
+            return op->Execute(inputs, outputs, ctx);
+        });
+    }
+
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override {
+        (void)output_index;
+        return node->GetOpType() == "MemcpyFromDevice" ? DeviceType::CPU : DeviceType::VULKAN;
+    }
+
+    // 整图捕获：各算子的dispatch记录进可重复提交的命令缓冲，ReplayGraph按段提交
+    bool IsGraphCaptureEnabled() const override { return device_ != nullptr; }
+    bool IsGraphCaptured() const override { return captured_ready_; }
+
+    Status CaptureBegin() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        DestroyCaptured();
+        capturing_ = true;
+        return Status::Ok();
+    }
+
+    Status CaptureEnd() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Status status = CloseCaptureSegment();
+        capturing_ = false;
+        if (!status.IsOk()) {
+            DestroyCaptured();
+            return status;
+        }
+        captured_ready_ = true;
+        size_t segments = 0;
+        for (const CapturedStep& step : captured_) {
+            segments += step.commands ? 1 : 0;
+        }
+        LOG_INFO("Vulkan plan captured into " + std::to_string(segments) + " command buffers");
+        return Status::Ok();
+    }
+
+    Status ReplayGraph() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!captured_ready_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "No Vulkan command buffers captured");
+        }
+        for (const CapturedStep& step : captured_) {
+            Status status = step.commands ? SubmitAndWait(step.commands) : step.host_action();
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+    void ResetGraph() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        DestroyCaptured();
+        capturing_ = false;
+    }
+};
+
+// 注册Vulkan执行提供者
+namespace {
+    void RegisterVulkanExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("VulkanExecutionProvider", []() {
+            return std::make_unique<VulkanExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("Vulkan", []() {
+            return std::make_unique<VulkanExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterVulkanExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_VULKAN未定义
+
+namespace inferunity {
+    // Vulkan未启用时的占位实现
+    // 注册函数为空，不会注册Vulkan后端
+}
+
+#endif  // INFERUNITY_USE_VULKAN
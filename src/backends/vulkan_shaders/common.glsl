@@ -0,0 +1,17 @@
+// Vulkan计算着色器的公共定义
+// FP16_STORAGE：张量以float16_t存储（需要storageBuffer16BitAccess），计算仍为fp32
+
+#ifdef FP16_STORAGE
+#extension GL_EXT_shader_16bit_storage : require
+#define STORAGE_T float16_t
+#else
+#define STORAGE_T float
+#endif
+
+#define LOAD(buf, i) float(buf[i])
+#define STORE(buf, i, v) buf[i] = STORAGE_T(v)
+
+// 一维调度的全局序号：工作组数超过maxComputeWorkGroupCount[0]时按二维调度
+uint GlobalIndex() {
+    return (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * gl_WorkGroupSize.x + gl_LocalInvocationID.x;
+}
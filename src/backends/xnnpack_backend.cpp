@@ -0,0 +1,879 @@
+// XNNPACK执行提供者（ARM服务器与移动端）
+// 参考ONNX Runtime的XnnpackExecutionProvider与TFLite的XNNPACK delegate：认领以Conv/MatMul为主的连通子图
+// （见DelegateClaimedSubgraphs），每种输入形状定义一个XNNPACK子图并创建runtime。XNNPACK的卷积与池化
+// 使用NHWC布局：子图内的4维值一律按NHWC保存，只在子图边界各做一次静态转置；卷积后的Clamp等由
+// XNNPACK的子图优化折叠进卷积。卷积核按XNNPACK的布局（OHWI、深度卷积为1HWC）转换后登记在
+// PrepackedWeightCache中，同一份权重在各会话、各形状之间只转换一次。允许时在ARMv8.2+的FP16算术上
+// 以FP16执行（XNN_FLAG_HINT_FP16_INFERENCE，不支持时XNNPACK仍用FP32）。
+// 某种形状下有节点无法表达时，该形状整个子图回退到参考算子
+
+#include "inferunity/backend.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "delegate_utils.h"
+#include "operators/conv_kernels.h"
+#include "operators/pooling.h"
+#include "operators/prepacked_weights.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef INFERUNITY_USE_XNNPACK
+#include <pthreadpool.h>
+#include <xnnpack.h>
+
+namespace inferunity {
+
+namespace {
+
+using delegate::FloatAttribute;
+using delegate::IntAttribute;
+using delegate::IsComputeOp;
+using delegate::IsConstant;
+using delegate::IsFloat;
+using delegate::IsPoolOp;
+
+constexpr float kNoMin = -std::numeric_limits<float>::infinity();
+constexpr float kNoMax = std::numeric_limits<float>::infinity();
+
+bool IsBinaryOp(const std::string& type, xnn_binary_operator* op) {
+    if (type == "Add") {
+        *op = xnn_binary_add;
+    } else if (type == "Sub") {
+        *op = xnn_binary_subtract;
+    } else if (type == "Mul") {
+        *op = xnn_binary_multiply;
+    } else if (type == "Div") {
+        *op = xnn_binary_divide;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool IsUnaryOp(const std::string& type, xnn_unary_operator* op) {
+    if (type == "Relu") {
+        *op = xnn_unary_clamp;
+    } else if (type == "Sigmoid") {
+        *op = xnn_unary_sigmoid;
+    } else if (type == "Tanh") {
+        *op = xnn_unary_tanh;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<size_t> ToXnnDims(const std::vector<int64_t>& dims) {
+    return std::vector<size_t>(dims.begin(), dims.end());
+}
+
+// NCHW形状/数据与NHWC之间的转换
+std::vector<int64_t> ToNhwc(const std::vector<int64_t>& dims) {
+    return {dims[0], dims[2], dims[3], dims[1]};
+}
+
+using WeightBuffer = std::vector<float>;
+
+// ONNX卷积核[O, I/g, KH, KW]转为XNNPACK的布局：普通卷积为[O, KH, KW, I/g]，
+// 深度卷积为[1, KH, KW, O]（O = C * depth_multiplier）
+std::shared_ptr<const WeightBuffer> PackFilter(const Tensor& weight, bool depthwise) {
+    const std::vector<int64_t>& dims = weight.GetShape().dims;
+    const float* src = static_cast<const float*>(weight.GetData());
+    const std::string key = operators::PrepackedWeightCache::MakeKey(
+        depthwise ? "xnnpack_1hwo" : "xnnpack_ohwi", dims, src, weight.GetElementCount());
+    return operators::PrepackedWeightCache::Instance().GetOrCreate<WeightBuffer>(key, [&]() {
+        const int64_t out_c = dims[0], in_c = dims[1], kh = dims[2], kw = dims[3];
+        auto packed = std::make_shared<WeightBuffer>(weight.GetElementCount());
+        for (int64_t o = 0; o < out_c; ++o) {
+            for (int64_t i = 0; i < in_c; ++i) {
+                for (int64_t y = 0; y < kh; ++y) {
+                    for (int64_t x = 0; x < kw; ++x) {
+                        const float value = src[((o * in_c + i) * kh + y) * kw + x];
+                        if (depthwise) {
+                            (*packed)[(y * kw + x) * out_c + o] = value;
+                        } else {
+                            (*packed)[((o * kh + y) * kw + x) * in_c + i] = value;
+                        }
+                    }
+                }
+            }
+        }
+        return std::shared_ptr<const WeightBuffer>(std::move(packed));
+    });
+}
+
+// 一种输入形状的执行计划：XNNPACK runtime，或回退到参考算子时为空
+struct XnnPlan {
+    xnn_runtime_t runtime = nullptr;
+    std::vector<uint32_t> input_ids;
+    std::vector<uint32_t> output_ids;
+    std::vector<std::vector<int64_t>> output_dims;
+    std::vector<DataType> output_dtypes;
+    // runtime引用的静态数据（转换后的卷积核、NHWC的常量）
+    std::vector<std::shared_ptr<const WeightBuffer>> static_data;
+
+    ~XnnPlan() {
+        if (runtime) {
+            xnn_delete_runtime(runtime);
+        }
+    }
+};
+
+class XnnSubgraph {
+public:
+    XnnSubgraph(std::unique_ptr<Graph> graph, pthreadpool_t threadpool, uint32_t runtime_flags, size_t max_plans)
+        : graph_(std::move(graph)), threadpool_(threadpool), runtime_flags_(runtime_flags),
+          max_plans_(std::max<size_t>(max_plans, 1)) {}
+
+    // 为每个节点创建参考算子：形状推断、解析卷积/池化参数以及回退执行都用它
+    Status Initialize() {
+        order_ = graph_->TopologicalSort();
+        for (Node* node : order_) {
+            auto op = OperatorRegistry::Instance().Create(node->GetOpTypeId());
+            if (!op) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Operator not registered: " + node->GetOpType());
+            }
+            ApplyNodeAttributes(*node, op.get());
+            references_[node] = std::move(op);
+        }
+        for (size_t i = 0; i < graph_->GetOutputs().size(); ++i) {
+            output_index_[graph_->GetOutputs()[i]] = i;
+        }
+        return Status::Ok();
+    }
+
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+        if (inputs.size() != graph_->GetInputs().size() || outputs.size() != graph_->GetOutputs().size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "XNNPACK subgraph input/output count mismatch");
+        }
+        // runtime不能并发调用
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string signature;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!inputs[i] || (!inputs[i]->GetData() && inputs[i]->GetElementCount() > 0) ||
+                inputs[i]->GetDataType() != DataType::FLOAT32) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "XNNPACK subgraph expects FP32 input: " + graph_->GetInputs()[i]->GetName());
+            }
+            for (int64_t d : inputs[i]->GetShape().dims) {
+                signature += std::to_string(d) + "x";
+            }
+            signature += ";";
+        }
+        XnnPlan* plan = nullptr;
+        Status status = GetPlan(signature, inputs, &plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            Tensor* tensor = outputs[i];
+            const std::vector<int64_t>& dims = plan->output_dims[i];
+            if (!tensor->GetData() || tensor->GetDataType() != plan->output_dtypes[i] ||
+                tensor->GetShape().dims != dims || tensor->GetDeviceType() != DeviceType::CPU) {
+                *tensor = Tensor(Shape(dims), plan->output_dtypes[i]);
+            }
+        }
+        if (!plan->runtime) {
+            return RunReference(inputs, outputs);
+        }
+
+        std::vector<xnn_external_value> externals;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            externals.push_back({plan->input_ids[i], inputs[i]->GetData()});
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            externals.push_back({plan->output_ids[i], outputs[i]->GetData()});
+        }
+        if (xnn_setup_runtime_v2(plan->runtime, externals.size(), externals.data()) != xnn_status_success ||
+            xnn_invoke_runtime(plan->runtime) != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "XNNPACK runtime execution failed");
+        }
+        return Status::Ok();
+    }
+
+private:
+    // 构建期间每个值在XNNPACK子图中的id；dims为逻辑（ONNX）形状，4维值在子图中按NHWC保存
+    struct XnnValue {
+        uint32_t id = XNN_INVALID_VALUE_ID;
+        std::vector<int64_t> dims;
+        DataType dtype = DataType::UNKNOWN;
+    };
+
+    struct Builder {
+        xnn_subgraph_t subgraph = nullptr;
+        XnnPlan* plan = nullptr;
+        std::unordered_map<const Value*, XnnValue> values;
+    };
+
+    Status GetPlan(const std::string& signature, const std::vector<Tensor*>& inputs, XnnPlan** plan) {
+        for (auto it = plans_.begin(); it != plans_.end(); ++it) {
+            if (it->first == signature) {
+                plans_.splice(plans_.begin(), plans_, it);
+                *plan = plans_.front().second.get();
+                return Status::Ok();
+            }
+        }
+        auto built = std::make_unique<XnnPlan>();
+        Status status = BuildPlan(inputs, built.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+        plans_.emplace_front(signature, std::move(built));
+        if (plans_.size() > max_plans_) {
+            plans_.pop_back();
+        }
+        *plan = plans_.front().second.get();
+        return Status::Ok();
+    }
+
+    Status BuildPlan(const std::vector<Tensor*>& inputs, XnnPlan* plan) {
+        Builder builder;
+        builder.plan = plan;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            XnnValue& value = builder.values[graph_->GetInputs()[i]];
+            value.dims = inputs[i]->GetShape().dims;
+            value.dtype = inputs[i]->GetDataType();
+        }
+        // 按实际输入形状推断子图内各值的形状
+        for (Node* node : order_) {
+            std::vector<TensorInfo> infos;
+            for (Value* input : node->GetInputs()) {
+                TensorInfo info;
+                if (IsConstant(input)) {
+                    info.shape = Shape(input->GetTensor()->GetShape().dims);
+                    info.dtype = input->GetTensor()->GetDataType();
+                    info.constant = input->GetTensor().get();
+                } else {
+                    const XnnValue& value = builder.values[input];
+                    info.shape = Shape(value.dims);
+                    info.dtype = value.dtype;
+                }
+                infos.push_back(info);
+            }
+            std::vector<TensorInfo> outs;
+            Status status = references_[node]->InferOutputInfo(infos, outs);
+            if (!status.IsOk()) {
+                return status;
+            }
+            for (size_t i = 0; i < node->GetOutputs().size() && i < outs.size(); ++i) {
+                XnnValue& value = builder.values[node->GetOutputs()[i]];
+                value.dims = outs[i].shape.dims;
+                value.dtype = outs[i].dtype;
+            }
+        }
+        for (const Value* output : graph_->GetOutputs()) {
+            plan->output_dims.push_back(builder.values[output].dims);
+            plan->output_dtypes.push_back(builder.values[output].dtype);
+        }
+
+        const uint32_t num_externals = static_cast<uint32_t>(inputs.size() + graph_->GetOutputs().size());
+        if (xnn_create_subgraph(num_externals, 0, &builder.subgraph) != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create XNNPACK subgraph");
+        }
+        Status status = DefineSubgraph(&builder);
+        if (status.IsOk()) {
+            // 权重由各runtime自己打包；跨会话共享的是PrepackedWeightCache中布局转换后的卷积核
+            if (xnn_create_runtime_v3(builder.subgraph, nullptr, threadpool_, runtime_flags_, &plan->runtime) !=
+                    xnn_status_success ||
+                xnn_reshape_runtime(plan->runtime) != xnn_status_success) {
+                status = Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK runtime creation failed");
+            }
+        }
+        xnn_delete_subgraph(builder.subgraph);
+        if (!status.IsOk()) {
+            if (status.Code() != StatusCode::ERROR_NOT_IMPLEMENTED) {
+                return status;
+            }
+            LOG_WARNING("XNNPACK falls back to reference kernels for this input shape: " + status.Message());
+            if (plan->runtime) {
+                xnn_delete_runtime(plan->runtime);
+                plan->runtime = nullptr;
+            }
+            plan->static_data.clear();
+        }
+        return Status::Ok();
+    }
+
+    Status DefineSubgraph(Builder* builder) {
+        const auto& graph_inputs = graph_->GetInputs();
+        // 边界输入：4维输入从NCHW转置为子图内的NHWC
+        for (size_t i = 0; i < graph_inputs.size(); ++i) {
+            XnnValue& value = builder->values[graph_inputs[i]];
+            uint32_t external_id = XNN_INVALID_VALUE_ID;
+            Status status = DefineTensor(builder, value.dims, nullptr, static_cast<uint32_t>(i),
+                                         XNN_VALUE_FLAG_EXTERNAL_INPUT, &external_id);
+            if (!status.IsOk()) {
+                return status;
+            }
+            builder->plan->input_ids.push_back(external_id);
+            value.id = external_id;
+            if (value.dims.size() == 4) {
+                status = DefineTransposed(builder, external_id, value.dims, {0, 2, 3, 1}, XNN_INVALID_VALUE_ID, 0,
+                                          &value.id);
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+        }
+        builder->plan->output_ids.assign(graph_->GetOutputs().size(), XNN_INVALID_VALUE_ID);
+
+        for (Node* node : order_) {
+            Status status = DefineNode(builder, node);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+    Status DefineTensor(Builder* builder, const std::vector<int64_t>& dims, const void* data, uint32_t external_id,
+                        uint32_t flags, uint32_t* id) {
+        const std::vector<size_t> xnn_dims = ToXnnDims(dims);
+        if (xnn_define_tensor_value(builder->subgraph, xnn_datatype_fp32, xnn_dims.size(), xnn_dims.data(), data,
+                                    external_id, flags, id) != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected tensor definition");
+        }
+        return Status::Ok();
+    }
+
+    Status DefineTransposed(Builder* builder, uint32_t input_id, const std::vector<int64_t>& input_dims,
+                            const std::vector<size_t>& perm, uint32_t external_id, uint32_t flags, uint32_t* id) {
+        std::vector<int64_t> dims(perm.size());
+        for (size_t i = 0; i < perm.size(); ++i) {
+            dims[i] = input_dims[perm[i]];
+        }
+        Status status = DefineTensor(builder, dims, nullptr, external_id, flags, id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (xnn_define_static_transpose(builder->subgraph, perm.size(), perm.data(), input_id, *id, 0) !=
+            xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected transpose");
+        }
+        return Status::Ok();
+    }
+
+    // 节点输出在子图内的id（4维为NHWC形状）；非4维的子图输出直接写外部值，4维的子图输出再转置回NCHW
+    Status DefineOutput(Builder* builder, const Value* value, uint32_t* id) {
+        XnnValue& state = builder->values[value];
+        auto it = output_index_.find(value);
+        const bool external = it != output_index_.end() && state.dims.size() != 4;
+        const uint32_t external_id = external ? static_cast<uint32_t>(graph_->GetInputs().size() + it->second)
+                                              : XNN_INVALID_VALUE_ID;
+        Status status = DefineTensor(builder, state.dims.size() == 4 ? ToNhwc(state.dims) : state.dims, nullptr,
+                                     external_id, external ? XNN_VALUE_FLAG_EXTERNAL_OUTPUT : 0, id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        state.id = *id;
+        if (external) {
+            builder->plan->output_ids[it->second] = *id;
+        }
+        return Status::Ok();
+    }
+
+    // 节点定义完之后把4维的子图输出从NHWC转置到外部值
+    Status FinishOutput(Builder* builder, const Value* value) {
+        auto it = output_index_.find(value);
+        const XnnValue& state = builder->values[value];
+        if (it == output_index_.end() || state.dims.size() != 4) {
+            return Status::Ok();
+        }
+        uint32_t external_id = static_cast<uint32_t>(graph_->GetInputs().size() + it->second);
+        uint32_t id = XNN_INVALID_VALUE_ID;
+        Status status = DefineTransposed(builder, state.id, ToNhwc(state.dims), {0, 3, 1, 2}, external_id,
+                                         XNN_VALUE_FLAG_EXTERNAL_OUTPUT, &id);
+        if (status.IsOk()) {
+            builder->plan->output_ids[it->second] = id;
+        }
+        return status;
+    }
+
+    // 操作数的id：常量按需定义为静态张量；与4维输出一起参与运算的常量左补1到4维后转为NHWC
+    Status OperandId(Builder* builder, Value* value, size_t output_rank, uint32_t* id) {
+        if (!IsConstant(value)) {
+            const XnnValue& state = builder->values[value];
+            if (output_rank == 4 && state.dims.size() != 4) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Broadcast of a non-4D activation in NHWC");
+            }
+            *id = state.id;
+            return Status::Ok();
+        }
+        const Tensor& tensor = *value->GetTensor();
+        std::vector<int64_t> dims = tensor.GetShape().dims;
+        const float* src = static_cast<const float*>(tensor.GetData());
+        auto data = std::make_shared<WeightBuffer>(src, src + tensor.GetElementCount());
+        if (output_rank == 4 && !dims.empty()) {
+            if (dims.size() > 4) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Constant rank exceeds 4");
+            }
+            dims.insert(dims.begin(), 4 - dims.size(), 1);
+            const int64_t n = dims[0], c = dims[1], h = dims[2], w = dims[3];
+            for (int64_t b = 0; b < n; ++b) {
+                for (int64_t ch = 0; ch < c; ++ch) {
+                    for (int64_t y = 0; y < h; ++y) {
+                        for (int64_t x = 0; x < w; ++x) {
+                            (*data)[((b * h + y) * w + x) * c + ch] = src[((b * c + ch) * h + y) * w + x];
+                        }
+                    }
+                }
+            }
+            dims = ToNhwc(dims);
+        }
+        builder->plan->static_data.push_back(data);
+        return DefineTensor(builder, dims, data->data(), XNN_INVALID_VALUE_ID, 0, id);
+    }
+
+    Status DefineNode(Builder* builder, Node* node) {
+        const std::string& type = node->GetOpType();
+        Value* output = node->GetOutputs()[0];
+        uint32_t output_id = XNN_INVALID_VALUE_ID;
+        xnn_binary_operator binary_op;
+        xnn_unary_operator unary_op;
+        Status status;
+        if (type == "Conv") {
+            status = DefineConv(builder, node);
+        } else if (type == "MatMul" || type == "Gemm") {
+            status = DefineFullyConnected(builder, node);
+        } else if (IsPoolOp(type)) {
+            status = DefinePool(builder, node);
+        } else if (IsUnaryOp(type, &unary_op)) {
+            status = DefineOutput(builder, output, &output_id);
+            if (status.IsOk()) {
+                xnn_unary_params params;
+                params.clamp.min = 0.0f;
+                params.clamp.max = kNoMax;
+                if (xnn_define_unary(builder->subgraph, unary_op, unary_op == xnn_unary_clamp ? &params : nullptr,
+                                     builder->values[node->GetInputs()[0]].id, output_id, 0) != xnn_status_success) {
+                    status = Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected " + type);
+                }
+            }
+        } else if (IsBinaryOp(type, &binary_op)) {
+            const size_t rank = builder->values[output].dims.size();
+            uint32_t a = XNN_INVALID_VALUE_ID;
+            uint32_t b = XNN_INVALID_VALUE_ID;
+            status = OperandId(builder, node->GetInputs()[0], rank, &a);
+            if (status.IsOk()) {
+                status = OperandId(builder, node->GetInputs()[1], rank, &b);
+            }
+            if (status.IsOk()) {
+                status = DefineOutput(builder, output, &output_id);
+            }
+            if (status.IsOk() && xnn_define_binary(builder->subgraph, binary_op, nullptr, a, b, output_id, 0) !=
+                                     xnn_status_success) {
+                status = Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected " + type);
+            }
+        } else {
+            status = Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "No XNNPACK lowering for " + type);
+        }
+        if (!status.IsOk()) {
+            return status;
+        }
+        return FinishOutput(builder, output);
+    }
+
+    // group为1或组卷积用convolution_2d；group == in_c时用depthwise_convolution_2d
+    Status DefineConv(Builder* builder, Node* node) {
+        const auto& inputs = node->GetInputs();
+        const XnnValue& x = builder->values[inputs[0]];
+        const Tensor& weight = *inputs[1]->GetTensor();
+        operators::Conv2DParams p;
+        Status status = operators::ParseConv2DParams(*references_[node], Shape(x.dims), weight.GetShape(), &p);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const bool depthwise = p.group > 1 && p.group == p.in_c && p.out_c % p.in_c == 0;
+        std::shared_ptr<const WeightBuffer> filter = PackFilter(weight, depthwise);
+        builder->plan->static_data.push_back(filter);
+        const std::vector<int64_t> filter_dims = depthwise
+            ? std::vector<int64_t>{1, p.kernel_h, p.kernel_w, p.out_c}
+            : std::vector<int64_t>{p.out_c, p.kernel_h, p.kernel_w, p.in_c / p.group};
+        uint32_t filter_id = XNN_INVALID_VALUE_ID;
+        status = DefineTensor(builder, filter_dims, filter->data(), XNN_INVALID_VALUE_ID, 0, &filter_id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        uint32_t bias_id = XNN_INVALID_VALUE_ID;
+        if (inputs.size() > 2) {
+            status = DefineTensor(builder, {p.out_c}, inputs[2]->GetTensor()->GetData(), XNN_INVALID_VALUE_ID, 0,
+                                  &bias_id);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        uint32_t output_id = XNN_INVALID_VALUE_ID;
+        status = DefineOutput(builder, node->GetOutputs()[0], &output_id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const xnn_status result = depthwise
+            ? xnn_define_depthwise_convolution_2d(
+                  builder->subgraph, p.pad_top, p.pad_right, p.pad_bottom, p.pad_left, p.kernel_h, p.kernel_w,
+                  p.stride_h, p.stride_w, p.dilation_h, p.dilation_w, p.out_c / p.in_c, p.in_c, kNoMin, kNoMax,
+                  x.id, filter_id, bias_id, output_id, 0)
+            : xnn_define_convolution_2d(
+                  builder->subgraph, p.pad_top, p.pad_right, p.pad_bottom, p.pad_left, p.kernel_h, p.kernel_w,
+                  p.stride_h, p.stride_w, p.dilation_h, p.dilation_w, p.group, p.in_c / p.group, p.out_c / p.group,
+                  kNoMin, kNoMax, x.id, filter_id, bias_id, output_id, 0);
+        if (result != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected Conv " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    // A为[..., K]（4维A按NCHW语义做批量矩阵乘，与子图内的NHWC不符，不接管），B为常量[K, N]
+    // （Gemm transB时为[N, K]），偏置为N个元素
+    Status DefineFullyConnected(Builder* builder, Node* node) {
+        const auto& inputs = node->GetInputs();
+        const XnnValue& a = builder->values[inputs[0]];
+        if (a.dims.size() < 2 || a.dims.size() == 4) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK fully connected expects 2-D/3-D input");
+        }
+        const Tensor& b = *inputs[1]->GetTensor();
+        const bool trans_b = node->GetOpType() == "Gemm" && IntAttribute(node, "transB", 0) != 0;
+        uint32_t filter_id = XNN_INVALID_VALUE_ID;
+        Status status = DefineTensor(builder, b.GetShape().dims, b.GetData(), XNN_INVALID_VALUE_ID, 0, &filter_id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t n = trans_b ? b.GetShape().dims[0] : b.GetShape().dims[1];
+        uint32_t bias_id = XNN_INVALID_VALUE_ID;
+        if (inputs.size() > 2) {
+            const Tensor& c = *inputs[2]->GetTensor();
+            if (c.GetElementCount() != static_cast<size_t>(n)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK Gemm expects a per-column bias");
+            }
+            status = DefineTensor(builder, {n}, c.GetData(), XNN_INVALID_VALUE_ID, 0, &bias_id);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        uint32_t output_id = XNN_INVALID_VALUE_ID;
+        status = DefineOutput(builder, node->GetOutputs()[0], &output_id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        // XNNPACK的权重默认为[N, K]；ONNX MatMul的[K, N]用XNN_FLAG_TRANSPOSE_WEIGHTS
+        if (xnn_define_fully_connected(builder->subgraph, kNoMin, kNoMax, a.id, filter_id, bias_id, output_id,
+                                       trans_b ? 0 : XNN_FLAG_TRANSPOSE_WEIGHTS) != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    // XNNPACK的平均池化不计padding；ceil_mode按多出的输出行列折算为右侧/下侧的padding
+    Status DefinePool(Builder* builder, Node* node) {
+        if (node->GetOutputs().size() != 1) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "MaxPool indices are not supported by XNNPACK");
+        }
+        const XnnValue& x = builder->values[node->GetInputs()[0]];
+        if (x.dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK pooling expects NCHW input");
+        }
+        uint32_t output_id = XNN_INVALID_VALUE_ID;
+        Status status = DefineOutput(builder, node->GetOutputs()[0], &output_id);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::string& type = node->GetOpType();
+        if (type == "GlobalAveragePool") {
+            if (xnn_define_global_average_pooling_2d(builder->subgraph, kNoMin, kNoMax, x.id, output_id, 0) !=
+                xnn_status_success) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected " + node->GetName());
+            }
+            return Status::Ok();
+        }
+        operators::Pool2DParams p;
+        status = operators::ParsePool2DParams(*references_[node], Shape(x.dims), &p);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t pad_bottom = (p.out_h - 1) * p.stride_h + p.kernel_h - p.in_h - p.pad_top;
+        const int64_t pad_right = (p.out_w - 1) * p.stride_w + p.kernel_w - p.in_w - p.pad_left;
+        xnn_status result;
+        if (type == "MaxPool") {
+            result = xnn_define_max_pooling_2d(builder->subgraph, p.pad_top, pad_right, pad_bottom, p.pad_left,
+                                               p.kernel_h, p.kernel_w, p.stride_h, p.stride_w, 1, 1, kNoMin, kNoMax,
+                                               x.id, output_id, 0);
+        } else {
+            if (p.count_include_pad && (p.pad_top || p.pad_left || pad_bottom || pad_right)) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK average pooling excludes padding");
+            }
+            result = xnn_define_average_pooling_2d(builder->subgraph, p.pad_top, pad_right, pad_bottom, p.pad_left,
+                                                   p.kernel_h, p.kernel_w, p.stride_h, p.stride_w, kNoMin, kNoMax,
+                                                   x.id, output_id, 0);
+        }
+        if (result != xnn_status_success) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "XNNPACK rejected " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    // 回退：按拓扑序逐个执行参考算子
+    Status RunReference(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs) {
+        std::unordered_map<const Value*, Tensor*> tensors;
+        std::vector<std::shared_ptr<Tensor>> intermediates;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            tensors[graph_->GetInputs()[i]] = inputs[i];
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            tensors[graph_->GetOutputs()[i]] = outputs[i];
+        }
+        ExecutionContext ctx(DeviceType::CPU);
+        for (Node* node : order_) {
+            std::vector<Tensor*> node_inputs;
+            for (Value* input : node->GetInputs()) {
+                node_inputs.push_back(IsConstant(input) ? input->GetTensor().get() : tensors[input]);
+            }
+            std::vector<Shape> shapes;
+            Status status = references_[node]->InferOutputShape(node_inputs, shapes);
+            if (!status.IsOk()) {
+                return status;
+            }
+            std::vector<Tensor*> node_outputs;
+            for (size_t i = 0; i < node->GetOutputs().size(); ++i) {
+                Value* output = node->GetOutputs()[i];
+                if (!tensors.count(output)) {
+                    intermediates.push_back(CreateTensor(shapes[i], references_[node]->InferOutputDataType(node_inputs, i),
+                                                         DeviceType::CPU));
+                    tensors[output] = intermediates.back().get();
+                }
+                node_outputs.push_back(tensors[output]);
+            }
+            status = references_[node]->Execute(node_inputs, node_outputs, &ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+    std::unique_ptr<Graph> graph_;
+    pthreadpool_t threadpool_;
+    uint32_t runtime_flags_;
+    size_t max_plans_;
+    std::vector<Node*> order_;
+    std::unordered_map<const Node*, std::unique_ptr<Operator>> references_;
+    std::unordered_map<const Value*, size_t> output_index_;
+    std::list<std::pair<std::string, std::unique_ptr<XnnPlan>>> plans_;   // 表头最近使用
+    std::mutex mutex_;
+};
+
+} // namespace
+
+class XNNPACKExecutionProvider : public ExecutionProvider {
+public:
+    XNNPACKExecutionProvider()
+        : host_provider_(ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider")) {
+        initialized_ = xnn_initialize(nullptr) == xnn_status_success;
+    }
+
+    ~XNNPACKExecutionProvider() override {
+        // runtime先于线程池释放
+        subgraphs_.clear();
+        if (threadpool_) {
+            pthreadpool_destroy(threadpool_);
+        }
+    }
+
+    std::string GetName() const override {
+        return "XNNPACKExecutionProvider";
+    }
+
+    DeviceType GetDeviceType() const override {
+        return DeviceType::CPU;
+    }
+
+    bool IsAvailable() const override {
+        return initialized_;
+    }
+
+    // 与CPU提供者共用主机设备，子图边界上不需要拷贝
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        return host_provider_ ? host_provider_->GetDevice(device_id) : nullptr;
+    }
+
+    int GetDeviceCount() const override {
+        return 1;
+    }
+
+    // 线程数取num_threads（0表示硬件并发数）；xnnpack_fp16且CPU支持ARMv8.2 FP16算术时提示XNNPACK以FP16执行
+    Status ConfigureSession(const SessionOptions& options) override {
+        const size_t threads = options.num_threads > 0 ? static_cast<size_t>(options.num_threads)
+                                                       : std::max(1u, std::thread::hardware_concurrency());
+        if (threadpool_) {
+            pthreadpool_destroy(threadpool_);
+        }
+        threadpool_ = threads > 1 ? pthreadpool_create(threads) : nullptr;
+        runtime_flags_ = options.xnnpack_fp16 && GetCpuFeatures().neon_fp16 ? XNN_FLAG_HINT_FP16_INFERENCE : 0;
+        max_plans_ = options.max_shape_specialized_plans;
+        return Status::Ok();
+    }
+
+    // 逐节点的算子由CPU提供者执行；XNNPACK只执行认领的子图
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == kDelegatedSubgraphOp;
+    }
+
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+
+    Status OptimizeGraph(Graph* graph) override {
+        // 激活折叠与布局选择由XNNPACK的子图优化完成
+        (void)graph;
+        return Status::Ok();
+    }
+
+    Status CompileNode(Node* node) override {
+        if (node && node->GetOpType() == kDelegatedSubgraphOp && !subgraphs_.count(node)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Delegated subgraph not compiled: " + node->GetName());
+        }
+        return Status::Ok();
+    }
+
+    Status PrepareExecution(Graph* graph) override {
+        (void)graph;
+        return Status::Ok();
+    }
+
+    bool SupportsSubgraphCompilation() const override { return initialized_; }
+    bool ClaimsSubgraphs() const override { return initialized_; }
+
+    // FP32的2维卷积（常量权重）、MatMul/Gemm（常量二维权重）、池化、ReLU/Sigmoid/Tanh与四则运算
+    bool CanCompileNode(const Node* node) const override {
+        if (!node) {
+            return false;
+        }
+        const std::string& type = node->GetOpType();
+        const auto& inputs = node->GetInputs();
+        for (const Value* input : inputs) {
+            if (!IsFloat(input)) {
+                return false;
+            }
+        }
+        xnn_binary_operator binary_op;
+        xnn_unary_operator unary_op;
+        if (type == "Conv") {
+            return inputs.size() >= 2 && IsConstant(inputs[1]) && inputs[1]->GetTensor()->GetShape().dims.size() == 4 &&
+                   (inputs.size() < 3 || IsConstant(inputs[2]));
+        }
+        if (type == "MatMul") {
+            return inputs.size() == 2 && IsConstant(inputs[1]) && inputs[1]->GetTensor()->GetShape().dims.size() == 2;
+        }
+        if (type == "Gemm") {
+            return inputs.size() >= 2 && IsConstant(inputs[1]) && inputs[1]->GetTensor()->GetShape().dims.size() == 2 &&
+                   IntAttribute(node, "transA", 0) == 0 && FloatAttribute(node, "alpha", 1.0f) == 1.0f &&
+                   FloatAttribute(node, "beta", 1.0f) == 1.0f && (inputs.size() < 3 || IsConstant(inputs[2]));
+        }
+        if (IsPoolOp(type)) {
+            return inputs.size() == 1 && node->GetOutputs().size() == 1;
+        }
+        if (IsUnaryOp(type, &unary_op)) {
+            return inputs.size() == 1;
+        }
+        if (IsBinaryOp(type, &binary_op)) {
+            return inputs.size() == 2;
+        }
+        return false;
+    }
+
+    // 只接管含卷积/矩阵乘的子图：纯逐元素的子图抵不过边界上的转置，留给CPU提供者
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        if (!fused_node || !subgraph) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Fused node and subgraph must be non-null");
+        }
+        const auto& nodes = subgraph->GetNodes();
+        if (std::none_of(nodes.begin(), nodes.end(), [](const std::unique_ptr<Node>& node) {
+                return IsComputeOp(node->GetOpType());
+            })) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Subgraph has no Conv/MatMul for XNNPACK");
+        }
+        auto compiled = std::make_unique<XnnSubgraph>(std::move(subgraph), threadpool_, runtime_flags_, max_plans_);
+        Status status = compiled->Initialize();
+        if (!status.IsOk()) {
+            return status;
+        }
+        subgraphs_[fused_node] = std::move(compiled);
+        return Status::Ok();
+    }
+
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        if (!node) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
+        }
+        auto it = subgraphs_.find(node);
+        if (it == subgraphs_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "XNNPACK backend only executes claimed subgraphs: " + node->GetOpType());
+        }
+
+        std::vector<Tensor*> inputs;
+        for (Value* input : node->GetInputs()) {
+            if (!input->GetTensor()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Claimed subgraph input has no tensor: " + input->GetName());
+            }
+            inputs.push_back(input->GetTensor().get());
+        }
+        std::vector<Tensor*> outputs;
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetTensor()) {
+                output->SetTensor(std::make_shared<Tensor>());
+            }
+            outputs.push_back(output->GetTensor().get());
+        }
+        return it->second->Run(inputs, outputs);
+    }
+
+private:
+    std::unique_ptr<ExecutionProvider> host_provider_;
+    bool initialized_ = false;
+    pthreadpool_t threadpool_ = nullptr;
+    uint32_t runtime_flags_ = 0;
+    size_t max_plans_ = 8;
+    std::unordered_map<Node*, std::unique_ptr<XnnSubgraph>> subgraphs_;
+};
+
+// 注册XNNPACK执行提供者
+namespace {
+    void RegisterXNNPACKExecutionProvider() {
+        ExecutionProviderRegistry::Instance().Register("XNNPACKExecutionProvider", []() {
+            return std::make_unique<XNNPACKExecutionProvider>();
+        });
+        ExecutionProviderRegistry::Instance().Register("XNNPACK", []() {
+            return std::make_unique<XNNPACKExecutionProvider>();
+        });
+    }
+
+    static bool g_registered = []() {
+        RegisterXNNPACKExecutionProvider();
+        return true;
+    }();
+}
+
+} // namespace inferunity
+
+#else  // INFERUNITY_USE_XNNPACK未定义
+
+namespace inferunity {
+    // XNNPACK未启用时的占位实现
+    // 注册函数为空，不会注册XNNPACK后端
+}
+
+#endif  // INFERUNITY_USE_XNNPACK
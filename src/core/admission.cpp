@@ -0,0 +1,96 @@
+// 准入控制实现
+
+#include "inferunity/admission.h"
+#include <algorithm>
+
+namespace inferunity {
+
+AdmissionController::AdmissionController(const AdmissionOptions& options) : options_(options) {}
+
+double AdmissionController::PredictQueueDelayLocked(size_t concurrency) const {
+    const size_t slots = std::max<size_t>(concurrency, 1);
+    const size_t ahead = stats_.queued + stats_.running;
+    if (ahead < slots) {
+        return 0.0;
+    }
+    return static_cast<double>(ahead - slots + 1) * stats_.service_time_ms / static_cast<double>(slots);
+}
+
+double AdmissionController::PredictQueueDelayMs(size_t concurrency) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return PredictQueueDelayLocked(concurrency);
+}
+
+Status AdmissionController::Admit(Clock::time_point deadline, size_t concurrency) {
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    concurrency_ = std::max<size_t>(concurrency, 1);
+    if (deadline == Clock::time_point::max() && options_.default_deadline_ms > 0.0) {
+        deadline = now + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(options_.default_deadline_ms));
+    }
+    if (deadline != Clock::time_point::max() && stats_.service_time_ms > 0.0) {
+        const double budget_ms = std::chrono::duration<double, std::milli>(deadline - now).count();
+        const double predicted_ms = PredictQueueDelayLocked(concurrency_) +
+                                    stats_.service_time_ms * options_.safety_factor;
+        if (predicted_ms > budget_ms) {
+            ++stats_.rejected;
+            return Status::Error(StatusCode::ERROR_OVERLOADED,
+                                 "Predicted completion in " + std::to_string(predicted_ms) +
+                                 " ms exceeds the deadline (" + std::to_string(budget_ms) + " ms)");
+        }
+    }
+    ++stats_.admitted;
+    ++stats_.queued;
+    return Status::Ok();
+}
+
+Status AdmissionController::Start(Clock::time_point deadline) {
+    const Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.queued > 0) {
+        --stats_.queued;
+    }
+    if (deadline != Clock::time_point::max() && stats_.service_time_ms > 0.0) {
+        const double remaining_ms = std::chrono::duration<double, std::milli>(deadline - now).count();
+        if (stats_.service_time_ms * options_.safety_factor > remaining_ms) {
+            ++stats_.shed;
+            return Status::Error(StatusCode::ERROR_OVERLOADED,
+                                 "Request shed: " + std::to_string(remaining_ms) +
+                                 " ms left before the deadline");
+        }
+    }
+    ++stats_.running;
+    return Status::Ok();
+}
+
+void AdmissionController::Finish(double service_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.running > 0) {
+        --stats_.running;
+    }
+    ++stats_.completed;
+    if (service_ms < 0.0) {
+        return;
+    }
+    const double alpha = std::min(std::max(options_.latency_smoothing, 0.0), 1.0);
+    stats_.service_time_ms = stats_.service_time_ms > 0.0
+        ? alpha * service_ms + (1.0 - alpha) * stats_.service_time_ms
+        : service_ms;
+}
+
+void AdmissionController::Withdraw() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.queued > 0) {
+        --stats_.queued;
+    }
+}
+
+AdmissionStats AdmissionController::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AdmissionStats stats = stats_;
+    stats.predicted_queue_delay_ms = PredictQueueDelayLocked(concurrency_);
+    return stats;
+}
+
+} // namespace inferunity
@@ -0,0 +1,15 @@
+// 内部对齐工具：内存规划、暂存区、模型文件与AOT生成代码的偏移对齐共用
+
+#pragma once
+
+#include <type_traits>
+
+namespace inferunity {
+
+// 把value向上取整到alignment的整数倍；alignment不必是2的幂，类型跟随value
+template <typename T>
+constexpr T AlignUp(T value, typename std::common_type<T>::type alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace inferunity
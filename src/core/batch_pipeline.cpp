@@ -0,0 +1,586 @@
+// 离线批量推理流水线实现
+// 每个阶段若干线程，从输入队列取、向输出队列放；一个阶段的最后一个线程退出时关闭它的输出队列，
+// 下游取空后随之退出。出错或取消时所有队列丢弃已有的元素并关闭，阻塞中的Push/Pop立即返回
+
+#include "inferunity/batch_pipeline.h"
+#include "inferunity/engine.h"
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace inferunity {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using RecordPtr = std::unique_ptr<BatchRecord>;
+
+int64_t ElapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// 有界阻塞队列：满时Push阻塞，空时Pop阻塞
+template <typename T>
+class BoundedQueue {
+public:
+    enum class PopResult { ITEM, TIMEOUT, CLOSED };
+
+    explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+    // 已关闭时返回false，item被丢弃
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 关闭且取空后返回CLOSED；deadline之前没有元素时返回TIMEOUT
+    PopResult PopUntil(T* item, Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto ready = [this] { return closed_ || !items_.empty(); };
+        if (deadline == Clock::time_point::max()) {
+            not_empty_.wait(lock, ready);
+        } else if (!not_empty_.wait_until(lock, deadline, ready)) {
+            return PopResult::TIMEOUT;
+        }
+        if (items_.empty()) {
+            return PopResult::CLOSED;
+        }
+        *item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return PopResult::ITEM;
+    }
+
+    bool Pop(T* item) {
+        return PopUntil(item, Clock::time_point::max()) == PopResult::ITEM;
+    }
+
+    // 生产者全部结束：已有的元素仍可取出
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    // 出错或取消：丢弃已有的元素
+    void Abort() {
+        std::deque<T> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            dropped.swap(items_);
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+// 组好的一批：records与rows一一对应；inputs为空表示批中都是失败的记录，推理阶段直接放行
+struct PipelineBatch {
+    std::vector<RecordPtr> records;
+    std::vector<int64_t> rows;
+    std::vector<std::shared_ptr<Tensor>> inputs;
+};
+using BatchPtr = std::unique_ptr<PipelineBatch>;
+
+struct StageCounters {
+    std::string name;
+    size_t threads = 0;
+    std::atomic<size_t> active{0};  // 尚未退出的线程数，归零时关闭输出队列
+    std::atomic<uint64_t> items{0};
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> input_wait_ns{0};
+    std::atomic<int64_t> output_wait_ns{0};
+
+    void Init(const std::string& stage_name, size_t num_threads) {
+        name = stage_name;
+        threads = num_threads;
+        active.store(num_threads);
+    }
+
+    // 线程退出；最后一个线程返回true
+    bool Leave() {
+        return active.fetch_sub(1) == 1;
+    }
+};
+
+// 回调抛出的异常转成记录的错误
+template <typename F>
+Status Invoke(const char* stage, F&& callback) {
+    try {
+        return callback();
+    } catch (const std::exception& e) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, std::string(stage) + " exception: " + e.what());
+    }
+}
+
+// 记录的输入须非空且共享第0维（样本数）；返回样本数，不合法时返回-1
+int64_t RecordRows(const BatchRecord& record) {
+    int64_t rows = -1;
+    for (const auto& input : record.inputs) {
+        if (!input || !input->GetData() || input->GetShape().dims.empty()) {
+            return -1;
+        }
+        const int64_t dim0 = input->GetShape().dims[0];
+        if (dim0 <= 0 || (rows >= 0 && dim0 != rows)) {
+            return -1;
+        }
+        rows = dim0;
+    }
+    return rows;
+}
+
+// 两条记录能否沿第0维拼接：输入个数、类型与第0维以外的维度一致
+bool Compatible(const BatchRecord& a, const BatchRecord& b) {
+    if (a.inputs.size() != b.inputs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.inputs.size(); ++i) {
+        const auto& da = a.inputs[i]->GetShape().dims;
+        const auto& db = b.inputs[i]->GetShape().dims;
+        if (a.inputs[i]->GetDataType() != b.inputs[i]->GetDataType() || da.size() != db.size() ||
+            !std::equal(da.begin() + 1, da.end(), db.begin() + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// 一次Run的全部状态：五个队列依次连接六个阶段
+struct BatchInferencePipeline::RunState {
+    RunState(size_t record_capacity, size_t batch_capacity)
+        : read_queue(record_capacity), preprocessed_queue(record_capacity), batch_queue(batch_capacity),
+          inferred_queue(batch_capacity), result_queue(record_capacity) {}
+
+    BoundedQueue<RecordPtr> read_queue;
+    BoundedQueue<RecordPtr> preprocessed_queue;
+    BoundedQueue<BatchPtr> batch_queue;
+    BoundedQueue<BatchPtr> inferred_queue;
+    BoundedQueue<RecordPtr> result_queue;
+
+    StageCounters reader, preprocess, assemble, infer, postprocess, writer;
+    std::atomic<uint64_t> next_index{0};
+    std::atomic<uint64_t> failed_records{0};
+    std::atomic<bool> stopped{false};
+    std::mutex error_mutex;
+    Status error;
+
+    // 第一个错误停止整个流水线
+    void Fail(const Status& status) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (stopped.exchange(true)) {
+                return;
+            }
+            error = status;
+        }
+        read_queue.Abort();
+        preprocessed_queue.Abort();
+        batch_queue.Abort();
+        inferred_queue.Abort();
+        result_queue.Abort();
+    }
+};
+
+BatchInferencePipeline::BatchInferencePipeline(InferenceSession* session, BatchPipelineStages stages,
+                                               const BatchPipelineOptions& options)
+    : session_(session), stages_(std::move(stages)), options_(options) {
+    options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+    options_.max_batch_delay_us = std::max<int64_t>(options_.max_batch_delay_us, 0);
+    options_.reader_threads = std::max<size_t>(options_.reader_threads, 1);
+    options_.preprocess_threads = std::max<size_t>(options_.preprocess_threads, 1);
+    options_.infer_threads = std::max<size_t>(options_.infer_threads, 1);
+    options_.postprocess_threads = std::max<size_t>(options_.postprocess_threads, 1);
+    options_.writer_threads = std::max<size_t>(options_.writer_threads, 1);
+    if (options_.infer_threads > 1 && session_ && !session_->SupportsConcurrentRun()) {
+        LOG_WARNING("Session does not support concurrent Run, batch pipeline uses one inference thread");
+        options_.infer_threads = 1;
+    }
+    if (options_.preserve_order) {
+        options_.writer_threads = 1;
+    }
+}
+
+void BatchInferencePipeline::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        running_->Fail(Status::Error(StatusCode::ERROR_CANCELLED, "Batch pipeline cancelled"));
+    }
+}
+
+Status BatchInferencePipeline::Run(BatchPipelineStats* stats) {
+    if (!session_ || !stages_.reader || !stages_.writer) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Batch pipeline needs a session, a reader and a writer");
+    }
+    const size_t record_capacity = options_.queue_capacity > 0 ? options_.queue_capacity : 4 * options_.batch_size;
+    const size_t batch_capacity = std::max<size_t>(2, record_capacity / options_.batch_size);
+    RunState state(record_capacity, batch_capacity);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Batch pipeline is already running");
+        }
+        running_ = &state;
+    }
+    state.reader.Init("reader", options_.reader_threads);
+    state.preprocess.Init("preprocess", options_.preprocess_threads);
+    state.assemble.Init("assemble", 1);
+    state.infer.Init("infer", options_.infer_threads);
+    state.postprocess.Init("postprocess", options_.postprocess_threads);
+    state.writer.Init("writer", options_.writer_threads);
+
+    // 记录失败：stop_on_error时停止流水线，否则计数后继续流向写出阶段
+    auto record_failed = [this, &state](BatchRecord& record, const Status& status) {
+        record.status = status;
+        state.failed_records.fetch_add(1, std::memory_order_relaxed);
+        if (options_.stop_on_error) {
+            state.Fail(status);
+        }
+    };
+    // 计时的Pop/Push，分别计入阶段的等待上游与等待下游时间
+    auto pop = [](auto& queue, auto* item, StageCounters& counters) {
+        const Clock::time_point start = Clock::now();
+        const bool ok = queue.Pop(item);
+        counters.input_wait_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+        return ok;
+    };
+    auto push = [](auto& queue, auto item, StageCounters& counters) {
+        const Clock::time_point start = Clock::now();
+        const bool ok = queue.Push(std::move(item));
+        counters.output_wait_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+        return ok;
+    };
+
+    auto reader_loop = [&]() {
+        StageCounters& counters = state.reader;
+        while (!state.stopped.load(std::memory_order_acquire)) {
+            RecordPtr record = std::make_unique<BatchRecord>();
+            const Clock::time_point start = Clock::now();
+            bool more = false;
+            try {
+                more = stages_.reader(record.get());
+            } catch (const std::exception& e) {
+                state.Fail(Status::Error(StatusCode::ERROR_RUNTIME_ERROR, std::string("reader exception: ") + e.what()));
+            }
+            counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+            if (!more) {
+                break;
+            }
+            record->index = state.next_index.fetch_add(1, std::memory_order_relaxed);
+            counters.items.fetch_add(1, std::memory_order_relaxed);
+            if (!push(state.read_queue, std::move(record), counters)) {
+                break;
+            }
+        }
+        if (counters.Leave()) {
+            state.read_queue.Close();
+        }
+    };
+
+    auto preprocess_loop = [&]() {
+        StageCounters& counters = state.preprocess;
+        RecordPtr record;
+        while (pop(state.read_queue, &record, counters)) {
+            const Clock::time_point start = Clock::now();
+            if (stages_.preprocess) {
+                Status status = Invoke("preprocess", [&]() { return stages_.preprocess(*record); });
+                if (!status.IsOk()) {
+                    record_failed(*record, status);
+                }
+            }
+            if (record->status.IsOk() && RecordRows(*record) < 0) {
+                record_failed(*record, Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                                     "Record inputs need a shared positive batch dimension"));
+            }
+            counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+            counters.items.fetch_add(1, std::memory_order_relaxed);
+            if (!push(state.preprocessed_queue, std::move(record), counters)) {
+                break;
+            }
+        }
+        if (counters.Leave()) {
+            state.preprocessed_queue.Close();
+        }
+    };
+
+    // 单线程组批：输入不兼容时先交出当前批；失败的记录单独成批直接放行
+    auto assemble_loop = [&]() {
+        StageCounters& counters = state.assemble;
+        const auto delay = std::chrono::microseconds(options_.max_batch_delay_us);
+        BatchPtr batch;
+        Clock::time_point batch_start;
+        auto flush = [&]() {
+            if (!batch) {
+                return true;
+            }
+            const Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < batch->records[0]->inputs.size(); ++i) {
+                std::vector<const Tensor*> samples;
+                for (const auto& record : batch->records) {
+                    samples.push_back(record->inputs[i].get());
+                }
+                auto merged = ConcatBatch(samples);
+                if (!merged) {
+                    for (auto& record : batch->records) {
+                        record_failed(*record, Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
+                                                             "Failed to assemble batched input"));
+                    }
+                    batch->inputs.clear();
+                    break;
+                }
+                batch->inputs.push_back(std::move(merged));
+            }
+            counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+            counters.items.fetch_add(1, std::memory_order_relaxed);
+            return push(state.batch_queue, std::move(batch), counters);
+        };
+
+        bool open = true;
+        while (open) {
+            const Clock::time_point deadline = batch && delay.count() > 0 ? batch_start + delay
+                                                                         : Clock::time_point::max();
+            RecordPtr record;
+            const Clock::time_point start = Clock::now();
+            const auto result = state.preprocessed_queue.PopUntil(&record, deadline);
+            counters.input_wait_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+            if (result == BoundedQueue<RecordPtr>::PopResult::CLOSED) {
+                break;
+            }
+            if (result == BoundedQueue<RecordPtr>::PopResult::TIMEOUT) {
+                open = flush();
+                continue;
+            }
+            if (!record->status.IsOk()) {
+                BatchPtr failed = std::make_unique<PipelineBatch>();
+                failed->rows.push_back(0);
+                failed->records.push_back(std::move(record));
+                open = push(state.batch_queue, std::move(failed), counters);
+                continue;
+            }
+            if (batch && !Compatible(*batch->records[0], *record)) {
+                if (!flush()) {
+                    break;
+                }
+            }
+            if (!batch) {
+                batch = std::make_unique<PipelineBatch>();
+                batch_start = Clock::now();
+            }
+            batch->rows.push_back(RecordRows(*record));
+            batch->records.push_back(std::move(record));
+            if (batch->records.size() >= options_.batch_size ||
+                (delay.count() > 0 && Clock::now() >= batch_start + delay)) {
+                open = flush();
+            }
+        }
+        if (open) {
+            flush();
+        }
+        if (counters.Leave()) {
+            state.batch_queue.Close();
+        }
+    };
+
+    auto infer_loop = [&]() {
+        StageCounters& counters = state.infer;
+        BatchPtr batch;
+        while (pop(state.batch_queue, &batch, counters)) {
+            if (!batch->inputs.empty()) {
+                const Clock::time_point start = Clock::now();
+                std::vector<Tensor*> input_ptrs;
+                for (const auto& input : batch->inputs) {
+                    input_ptrs.push_back(input.get());
+                }
+                std::vector<std::shared_ptr<Tensor>> outputs;
+                Status status = session_->Run(input_ptrs, outputs);
+                // 输出取得所有权后按记录切成视图，不逐条拷贝
+                for (size_t o = 0; status.IsOk() && o < outputs.size(); ++o) {
+                    auto views = SplitBatch(outputs[o], batch->rows);
+                    if (views.size() != batch->records.size()) {
+                        status = Status::Error(StatusCode::ERROR_INVALID_MODEL, "Output is not batched along dimension 0");
+                        break;
+                    }
+                    for (size_t r = 0; r < views.size(); ++r) {
+                        batch->records[r]->outputs.push_back(std::move(views[r]));
+                    }
+                }
+                if (!status.IsOk()) {
+                    for (auto& record : batch->records) {
+                        record->outputs.clear();
+                        record_failed(*record, status);
+                    }
+                }
+                // ConcatBatch可能返回引用样本内存的视图，推理完成后才释放样本的输入
+                batch->inputs.clear();
+                for (auto& record : batch->records) {
+                    record->inputs.clear();
+                }
+                counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+                counters.items.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!push(state.inferred_queue, std::move(batch), counters)) {
+                break;
+            }
+        }
+        if (counters.Leave()) {
+            state.inferred_queue.Close();
+        }
+    };
+
+    auto postprocess_loop = [&]() {
+        StageCounters& counters = state.postprocess;
+        BatchPtr batch;
+        bool open = true;
+        while (open && pop(state.inferred_queue, &batch, counters)) {
+            for (auto& record : batch->records) {
+                if (record->status.IsOk() && stages_.postprocess) {
+                    const Clock::time_point start = Clock::now();
+                    Status status = Invoke("postprocess", [&]() { return stages_.postprocess(*record); });
+                    if (!status.IsOk()) {
+                        record_failed(*record, status);
+                    }
+                    counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+                }
+                counters.items.fetch_add(1, std::memory_order_relaxed);
+                if (!push(state.result_queue, std::move(record), counters)) {
+                    open = false;
+                    break;
+                }
+            }
+        }
+        if (counters.Leave()) {
+            state.result_queue.Close();
+        }
+    };
+
+    // preserve_order时单线程按编号重排：先到的记录暂存，等前面的记录写出
+    auto writer_loop = [&]() {
+        StageCounters& counters = state.writer;
+        auto write = [&](BatchRecord& record) {
+            const Clock::time_point start = Clock::now();
+            Status status = Invoke("writer", [&]() { return stages_.writer(record); });
+            counters.busy_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+            counters.items.fetch_add(1, std::memory_order_relaxed);
+            if (!status.IsOk()) {
+                state.Fail(status);
+                return false;
+            }
+            return true;
+        };
+        std::map<uint64_t, RecordPtr> pending;
+        uint64_t next = 0;
+        RecordPtr record;
+        while (pop(state.result_queue, &record, counters)) {
+            if (!options_.preserve_order) {
+                if (!write(*record)) {
+                    break;
+                }
+                continue;
+            }
+            pending.emplace(record->index, std::move(record));
+            while (!pending.empty() && pending.begin()->first == next) {
+                if (!write(*pending.begin()->second)) {
+                    break;
+                }
+                pending.erase(pending.begin());
+                ++next;
+            }
+        }
+        counters.Leave();
+    };
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    auto launch = [&threads](size_t count, const std::function<void()>& loop) {
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back(loop);
+        }
+    };
+    launch(options_.reader_threads, reader_loop);
+    launch(options_.preprocess_threads, preprocess_loop);
+    launch(1, assemble_loop);
+    launch(options_.infer_threads, infer_loop);
+    launch(options_.postprocess_threads, postprocess_loop);
+    launch(options_.writer_threads, writer_loop);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double wall_ms = static_cast<double>(ElapsedNs(start)) / 1e6;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = nullptr;
+    }
+
+    BatchPipelineStats result;
+    result.wall_ms = wall_ms;
+    result.records = state.writer.items.load();
+    result.batches = state.infer.items.load();
+    result.failed_records = state.failed_records.load();
+    for (StageCounters* counters : {&state.reader, &state.preprocess, &state.assemble, &state.infer,
+                                    &state.postprocess, &state.writer}) {
+        BatchPipelineStageStats stage;
+        stage.name = counters->name;
+        stage.threads = counters->threads;
+        stage.items = counters->items.load();
+        stage.busy_ms = static_cast<double>(counters->busy_ns.load()) / 1e6;
+        stage.input_wait_ms = static_cast<double>(counters->input_wait_ns.load()) / 1e6;
+        stage.output_wait_ms = static_cast<double>(counters->output_wait_ns.load()) / 1e6;
+        stage.utilization = wall_ms > 0.0 ? stage.busy_ms / (static_cast<double>(stage.threads) * wall_ms) : 0.0;
+        result.stages.push_back(std::move(stage));
+    }
+    LOG_INFO("Batch pipeline wrote " + std::to_string(result.records) + " records in " +
+             std::to_string(result.batches) + " batches (" + std::to_string(result.failed_records) + " failed)");
+    if (stats) {
+        *stats = std::move(result);
+    }
+    return state.error;
+}
+
+std::string BatchPipelineStats::ToString() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(12) << "stage" << std::right << std::setw(8) << "threads" << std::setw(12) << "items"
+        << std::setw(12) << "busy_ms" << std::setw(14) << "input_wait_ms" << std::setw(15) << "output_wait_ms"
+        << std::setw(8) << "util%" << "\n";
+    const BatchPipelineStageStats* bottleneck = nullptr;
+    for (const BatchPipelineStageStats& stage : stages) {
+        out << std::left << std::setw(12) << stage.name << std::right << std::setw(8) << stage.threads
+            << std::setw(12) << stage.items << std::setw(12) << stage.busy_ms << std::setw(14) << stage.input_wait_ms
+            << std::setw(15) << stage.output_wait_ms << std::setw(8) << stage.utilization * 100.0 << "\n";
+        if (!bottleneck || stage.utilization > bottleneck->utilization) {
+            bottleneck = &stage;
+        }
+    }
+    out << records << " records, " << batches << " batches, " << failed_records << " failed, " << wall_ms << " ms";
+    if (bottleneck) {
+        out << "; busiest stage: " << bottleneck->name;
+    }
+    out << "\n";
+    return out.str();
+}
+
+} // namespace inferunity
@@ -0,0 +1,568 @@
+// 动态批处理实现
+// 参考Triton的dynamic batcher：单个调度线程按到达顺序收集兼容请求，
+// 队首请求的等待时间达到max_delay_us或凑满max_batch_size个样本时立即执行，
+// 超时的请求在执行前剔除，不占用批次
+
+#include "inferunity/batcher.h"
+#include "inferunity/engine.h"
+#include "inferunity/float16.h"
+#include <algorithm>
+#include <cstring>
+
+namespace inferunity {
+
+namespace {
+
+std::vector<double> QueueTimeBounds() {
+    return {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+}
+
+std::future<BatchResult> ReadyResult(StatusCode code, const std::string& message) {
+    std::promise<BatchResult> promise;
+    BatchResult result;
+    result.status = Status::Error(code, message);
+    promise.set_value(std::move(result));
+    return promise.get_future();
+}
+
+int64_t Product(const std::vector<int64_t>& dims, size_t begin, size_t end) {
+    int64_t product = 1;
+    for (size_t d = begin; d < end && d < dims.size(); ++d) {
+        product *= dims[d];
+    }
+    return product;
+}
+
+// 用value填充count个dtype类型的元素（补齐值）
+void FillScalar(uint8_t* dst, size_t count, DataType dtype, double value) {
+    uint8_t pattern[8] = {};
+    auto store = [&pattern](auto scalar) { std::memcpy(pattern, &scalar, sizeof(scalar)); };
+    switch (dtype) {
+        case DataType::FLOAT32: store(static_cast<float>(value)); break;
+        case DataType::FLOAT16: store(FloatToHalf(static_cast<float>(value))); break;
+        case DataType::BFLOAT16: store(FloatToBFloat16(static_cast<float>(value))); break;
+        case DataType::INT8: store(static_cast<int8_t>(value)); break;
+        case DataType::INT16: store(static_cast<int16_t>(value)); break;
+        case DataType::INT32: store(static_cast<int32_t>(value)); break;
+        case DataType::INT64: store(static_cast<int64_t>(value)); break;
+        case DataType::UINT8: store(static_cast<uint8_t>(value)); break;
+        case DataType::UINT16: store(static_cast<uint16_t>(value)); break;
+        case DataType::UINT32: store(static_cast<uint32_t>(value)); break;
+        case DataType::UINT64: store(static_cast<uint64_t>(value)); break;
+        case DataType::BOOL: store(static_cast<uint8_t>(value != 0.0)); break;
+        default: break;
+    }
+    const size_t size = Tensor::GetDataTypeSize(dtype);
+    if (std::all_of(pattern, pattern + size, [](uint8_t byte) { return byte == 0; })) {
+        std::memset(dst, 0, count * size);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(dst + i * size, pattern, size);
+    }
+}
+
+// 段号与段内位置：第i条序列的token段号为i
+std::shared_ptr<Tensor> MakeSegmentTensor(const std::vector<std::pair<int64_t, int64_t>>& segments,
+                                          int64_t tokens, bool positions) {
+    auto tensor = CreateTensor(Shape({1, tokens}), DataType::INT64);
+    if (!tensor) {
+        return nullptr;
+    }
+    int64_t* data = static_cast<int64_t*>(tensor->GetData());
+    int64_t segment = 0;
+    for (const auto& request : segments) {
+        for (int64_t row = 0; row < request.first; ++row, ++segment) {
+            for (int64_t t = 0; t < request.second; ++t) {
+                *data++ = positions ? t : segment;
+            }
+        }
+    }
+    return tensor;
+}
+
+} // anonymous namespace
+
+DynamicBatcher::DynamicBatcher(InferenceSession* session, const DynamicBatcherOptions& options)
+    : session_(session), options_(options) {
+    if (options_.max_batch_size <= 0) {
+        options_.max_batch_size = session_ ? session_->GetOptions().max_batch_size : 1;
+    }
+    options_.max_batch_size = std::max(options_.max_batch_size, 1);
+    options_.max_delay_us = std::max<int64_t>(options_.max_delay_us, 0);
+    stats_.batch_size = Histogram(BatchSizeBuckets(options_.max_batch_size));
+    stats_.queue_time_us = Histogram(QueueTimeBounds());
+    if (session_) {
+        MetricsRegistry& registry = MetricsRegistry::Instance();
+        const MetricLabels labels = {{"session", session_->GetSessionId()}};
+        batch_size_metric_ = registry.GetHistogram("inferunity_batcher_batch_size",
+                                                   BatchSizeBuckets(options_.max_batch_size), labels,
+                                                   "Requests per dynamic batch");
+        queue_wait_metric_ = registry.GetHistogram("inferunity_batcher_queue_wait_us", LatencyBucketsUs(),
+                                                   labels, "Time a request waits in the batch queue");
+    }
+    worker_ = std::thread(&DynamicBatcher::WorkerLoop, this);
+}
+
+DynamicBatcher::~DynamicBatcher() {
+    Stop();
+}
+
+std::future<BatchResult> DynamicBatcher::Submit(std::vector<std::shared_ptr<Tensor>> inputs,
+                                                int64_t timeout_us, const std::string& lora_adapter) {
+    return Enqueue(std::move(inputs), timeout_us, lora_adapter, nullptr);
+}
+
+void DynamicBatcher::Submit(std::vector<std::shared_ptr<Tensor>> inputs, BatchCallback callback,
+                            int64_t timeout_us, const std::string& lora_adapter) {
+    std::future<BatchResult> rejected = Enqueue(std::move(inputs), timeout_us, lora_adapter, callback);
+    if (rejected.valid()) {
+        callback(rejected.get());
+    }
+}
+
+void DynamicBatcher::Complete(Request& request, BatchResult result) {
+    if (request.callback) {
+        request.callback(std::move(result));
+    } else {
+        request.promise.set_value(std::move(result));
+    }
+}
+
+std::future<BatchResult> DynamicBatcher::Enqueue(std::vector<std::shared_ptr<Tensor>> inputs, int64_t timeout_us,
+                                                 const std::string& lora_adapter, BatchCallback callback) {
+    if (!session_) {
+        return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "Batcher has no session");
+    }
+    // PACKED把各请求拼成一行，MatMul的行无法按样本等分给各适配器
+    if (!lora_adapter.empty() && options_.sequence.mode == SequenceBatchingMode::PACKED) {
+        return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA adapters are not supported with packed sequences");
+    }
+    int64_t rows = -1;
+    for (const auto& input : inputs) {
+        if (!input || !input->GetData() || input->GetShape().dims.empty()) {
+            return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "Batched inputs need a batch dimension");
+        }
+        const int64_t dim0 = input->GetShape().dims[0];
+        if (dim0 <= 0 || (rows >= 0 && dim0 != rows)) {
+            return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Batched inputs must share a positive batch dimension");
+        }
+        rows = dim0;
+    }
+    if (rows < 0) {
+        return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "Empty request");
+    }
+    
+    // 变长序列：各序列输入的长度须一致，BUCKET取不小于它的最小桶
+    const SequenceBatchingOptions& sequence = options_.sequence;
+    int64_t length = 0;
+    int64_t bucket = 0;
+    if (sequence.mode != SequenceBatchingMode::NONE) {
+        const size_t axis = static_cast<size_t>(sequence.sequence_axis);
+        if (sequence.sequence_axis < 1 ||
+            (sequence.mode == SequenceBatchingMode::PACKED &&
+             (sequence.sequence_axis != 1 || sequence.segment_ids_input < 0))) {
+            return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid sequence batching options");
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!IsSequenceInput(inputs, i)) {
+                continue;
+            }
+            const auto& dims = inputs[i]->GetShape().dims;
+            if (dims.size() <= axis || dims[axis] <= 0 || (length > 0 && dims[axis] != length)) {
+                return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Sequence inputs must share a positive length along the sequence axis");
+            }
+            length = dims[axis];
+        }
+        if (length == 0) {
+            return ReadyResult(StatusCode::ERROR_INVALID_ARGUMENT, "Request has no sequence input");
+        }
+        bucket = length;
+        if (sequence.mode == SequenceBatchingMode::BUCKET) {
+            auto it = std::lower_bound(sequence.buckets.begin(), sequence.buckets.end(), length);
+            if (it != sequence.buckets.end()) {
+                bucket = *it;
+            }
+        }
+    }
+    
+    auto request = std::make_unique<Request>();
+    request->inputs = std::move(inputs);
+    request->rows = rows;
+    request->length = length;
+    request->bucket = bucket;
+    request->lora_adapter = lora_adapter;
+    request->enqueue_time = Clock::now();
+    if (timeout_us < 0) {
+        timeout_us = options_.default_timeout_us;
+    }
+    request->deadline = timeout_us > 0
+        ? request->enqueue_time + std::chrono::microseconds(timeout_us)
+        : Clock::time_point::max();
+    request->callback = std::move(callback);
+    std::future<BatchResult> future = request->callback ? std::future<BatchResult>()
+                                                        : request->promise.get_future();
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ || (options_.max_queue_size > 0 && queue_.size() >= options_.max_queue_size)) {
+            ++stats_.num_rejected;
+            return stop_ ? ReadyResult(StatusCode::ERROR_RUNTIME_ERROR, "Batcher is stopped")
+                         : ReadyResult(StatusCode::ERROR_RESOURCE_EXHAUSTED, "Batcher queue is full");
+        }
+        queued_rows_ += rows;
+        queue_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+void DynamicBatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& request : queue_) {
+        BatchResult result;
+        result.status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Batcher stopped before execution");
+        Complete(*request, std::move(result));
+    }
+    queue_.clear();
+    queued_rows_ = 0;
+}
+
+DynamicBatcherStats DynamicBatcher::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DynamicBatcher::WorkerLoop() {
+    const auto delay = std::chrono::microseconds(options_.max_delay_us);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        // 队首请求最多等待max_delay_us；样本凑满时提前执行
+        const Clock::time_point flush = queue_.front()->enqueue_time + delay;
+        cv_.wait_until(lock, flush, [this] {
+            return stop_ || queued_rows_ >= options_.max_batch_size;
+        });
+        if (stop_) {
+            return;
+        }
+        ExpireRequests(Clock::now());
+        if (queue_.empty()) {
+            continue;
+        }
+        std::vector<std::unique_ptr<Request>> batch = TakeBatch();
+        lock.unlock();
+        ExecuteBatch(batch);
+        lock.lock();
+    }
+}
+
+bool DynamicBatcher::IsSequenceInput(const std::vector<std::shared_ptr<Tensor>>& inputs, size_t index) const {
+    const SequenceBatchingOptions& sequence = options_.sequence;
+    if (!sequence.sequence_inputs.empty()) {
+        return std::find(sequence.sequence_inputs.begin(), sequence.sequence_inputs.end(), index) !=
+               sequence.sequence_inputs.end();
+    }
+    return inputs[index]->GetShape().dims.size() > static_cast<size_t>(std::max(sequence.sequence_axis, 0));
+}
+
+// 输入个数、类型与第0维以外的维度一致；按序列成批时序列输入的序列轴不比较，BUCKET另要求同一个桶
+bool DynamicBatcher::Compatible(const Request& a, const Request& b) const {
+    const SequenceBatchingOptions& sequence = options_.sequence;
+    if (a.inputs.size() != b.inputs.size() ||
+        (sequence.mode == SequenceBatchingMode::BUCKET && a.bucket != b.bucket)) {
+        return false;
+    }
+    const bool by_sequence = sequence.mode != SequenceBatchingMode::NONE;
+    const size_t axis = static_cast<size_t>(std::max(sequence.sequence_axis, 0));
+    for (size_t i = 0; i < a.inputs.size(); ++i) {
+        const auto& da = a.inputs[i]->GetShape().dims;
+        const auto& db = b.inputs[i]->GetShape().dims;
+        if (a.inputs[i]->GetDataType() != b.inputs[i]->GetDataType() || da.size() != db.size()) {
+            return false;
+        }
+        const bool skip_axis = by_sequence && IsSequenceInput(a.inputs, i);
+        for (size_t d = 1; d < da.size(); ++d) {
+            if (da[d] != db[d] && !(skip_axis && d == axis)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::unique_ptr<DynamicBatcher::Request>> DynamicBatcher::TakeBatch() {
+    std::vector<std::unique_ptr<Request>> batch;
+    std::deque<std::unique_ptr<Request>> remaining;
+    int64_t rows = 0;
+    int64_t tokens = 0;
+    const int64_t max_tokens = options_.sequence.mode == SequenceBatchingMode::PACKED
+                                   ? options_.sequence.max_batch_tokens : 0;
+    for (auto& request : queue_) {
+        // 队首总是执行，即使它本身超过max_batch_size
+        const int64_t request_tokens = request->rows * request->length;
+        if (batch.empty() ||
+            (Compatible(*batch[0], *request) &&
+             rows + request->rows <= options_.max_batch_size &&
+             (max_tokens <= 0 || tokens + request_tokens <= max_tokens))) {
+            rows += request->rows;
+            tokens += request_tokens;
+            batch.push_back(std::move(request));
+        } else {
+            remaining.push_back(std::move(request));
+        }
+    }
+    queue_.swap(remaining);
+    queued_rows_ -= rows;
+    return batch;
+}
+
+void DynamicBatcher::ExpireRequests(Clock::time_point now) {
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        if ((*it)->deadline <= now) {
+            BatchResult result;
+            result.status = Status::Error(StatusCode::ERROR_TIMEOUT, "Request timed out in batch queue");
+            Complete(**it, std::move(result));
+            queued_rows_ -= (*it)->rows;
+            ++stats_.num_timeouts;
+            it = queue_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DynamicBatcher::ExecuteBatch(std::vector<std::unique_ptr<Request>>& batch) {
+    const Clock::time_point start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.num_batches;
+        stats_.num_requests += batch.size();
+        stats_.batch_size.Record(static_cast<double>(batch.size()));
+        for (const auto& request : batch) {
+            stats_.sequence_tokens += static_cast<uint64_t>(request->rows * request->length);
+            stats_.computed_tokens += static_cast<uint64_t>(request->rows * request->bucket);
+        }
+        const bool record_metrics = batch_size_metric_ && MetricsRegistry::Instance().IsEnabled();
+        if (record_metrics) {
+            batch_size_metric_->Record(static_cast<double>(batch.size()));
+        }
+        for (const auto& request : batch) {
+            const double wait_us = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::microseconds>(start - request->enqueue_time).count());
+            stats_.queue_time_us.Record(wait_us);
+            if (record_metrics) {
+                queue_wait_metric_->Record(wait_us);
+            }
+        }
+    }
+    
+    auto fail_all = [&batch](const Status& status) {
+        for (auto& request : batch) {
+            BatchResult result;
+            result.status = status;
+            Complete(*request, std::move(result));
+        }
+    };
+    
+    std::vector<std::shared_ptr<Tensor>> merged;
+    Status status = MergeInputs(batch, &merged);
+    if (!status.IsOk()) {
+        fail_all(status);
+        return;
+    }
+    std::vector<Tensor*> input_ptrs;
+    for (const auto& tensor : merged) {
+        input_ptrs.push_back(tensor.get());
+    }
+    
+    // 有请求选用LoRA适配器时按样本给出各行的适配器，基座权重的GEMM仍整批只做一次
+    RunOptions run_options;
+    for (const auto& request : batch) {
+        if (!request->lora_adapter.empty()) {
+            for (const auto& other : batch) {
+                run_options.lora_adapters.insert(run_options.lora_adapters.end(),
+                                                 static_cast<size_t>(other->rows), other->lora_adapter);
+            }
+            break;
+        }
+    }
+    
+    // 输出取得所有权后按请求切成视图，不逐请求拷贝
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    status = session_->Run(run_options, input_ptrs, outputs);
+    if (!status.IsOk()) {
+        fail_all(status);
+        return;
+    }
+    std::vector<BatchResult> results(batch.size());
+    status = SplitOutputs(batch, outputs, &results);
+    if (!status.IsOk()) {
+        fail_all(status);
+        return;
+    }
+    for (size_t r = 0; r < batch.size(); ++r) {
+        Complete(*batch[r], std::move(results[r]));
+    }
+}
+
+Status DynamicBatcher::MergeInputs(const std::vector<std::unique_ptr<Request>>& batch,
+                                   std::vector<std::shared_ptr<Tensor>>* merged) {
+    const SequenceBatchingOptions& sequence = options_.sequence;
+    const Request& head = *batch[0];
+    const size_t axis = static_cast<size_t>(std::max(sequence.sequence_axis, 0));
+    int64_t rows = 0;
+    int64_t tokens = 0;
+    bool padded = false;
+    std::vector<std::pair<int64_t, int64_t>> segments;  // 各请求的(样本数, 长度)
+    for (const auto& request : batch) {
+        rows += request->rows;
+        tokens += request->rows * request->length;
+        padded = padded || request->length != request->bucket;
+        segments.emplace_back(request->rows, request->length);
+    }
+    
+    for (size_t i = 0; i < head.inputs.size(); ++i) {
+        const bool pack = sequence.mode == SequenceBatchingMode::PACKED && IsSequenceInput(head.inputs, i);
+        const bool pad = sequence.mode == SequenceBatchingMode::BUCKET && padded && IsSequenceInput(head.inputs, i);
+        if (!pack && !pad) {
+            // 客户端写入相邻槽位（SplitBatch得到的视图）时ConcatBatch不拷贝
+            std::vector<const Tensor*> samples;
+            for (const auto& request : batch) {
+                samples.push_back(request->inputs[i].get());
+            }
+            auto tensor = ConcatBatch(samples);
+            if (!tensor) {
+                return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to assemble batched input");
+            }
+            merged->push_back(std::move(tensor));
+            continue;
+        }
+        
+        // PACKED：[r, L, ...]在内存中就是r * L个相接的token，依次拷入[1, 总token数, ...]；
+        // BUCKET：每个序列轴之前的位置拷入L * inner个元素，其后的(桶长 - L) * inner个元素为补齐值
+        const DataType dtype = head.inputs[i]->GetDataType();
+        const size_t element_size = Tensor::GetDataTypeSize(dtype);
+        Shape shape = head.inputs[i]->GetShape();
+        shape.dims[0] = pack ? 1 : rows;
+        shape.dims[axis] = pack ? tokens : head.bucket;
+        auto tensor = CreateTensor(shape, dtype);
+        if (!tensor) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to assemble batched input");
+        }
+        uint8_t* dst = static_cast<uint8_t*>(tensor->GetData());
+        const double pad_value = i < sequence.pad_values.size() ? sequence.pad_values[i] : 0.0;
+        for (const auto& request : batch) {
+            auto source = MakeContiguous(request->inputs[i]);
+            if (!source) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Batched inputs must be on the CPU");
+            }
+            const uint8_t* src = static_cast<const uint8_t*>(source->GetData());
+            const size_t bytes = source->GetSizeInBytes();
+            if (pack) {
+                std::memcpy(dst, src, bytes);
+                dst += bytes;
+                continue;
+            }
+            const auto& dims = source->GetShape().dims;
+            const size_t inner = static_cast<size_t>(Product(dims, axis + 1, dims.size())) * element_size;
+            const size_t copied = static_cast<size_t>(request->length) * inner;
+            const size_t slot = static_cast<size_t>(head.bucket) * inner;
+            for (int64_t o = 0; o < Product(dims, 0, axis); ++o) {
+                std::memcpy(dst, src, copied);
+                FillScalar(dst + copied, (slot - copied) / element_size, dtype, pad_value);
+                src += copied;
+                dst += slot;
+            }
+        }
+        merged->push_back(std::move(tensor));
+    }
+    
+    if (sequence.mode == SequenceBatchingMode::PACKED) {
+        // 段号与段内位置按图输入下标插入，先插下标小的
+        std::vector<std::pair<int, bool>> generated = {{sequence.segment_ids_input, false}};
+        if (sequence.position_ids_input >= 0) {
+            generated.emplace_back(sequence.position_ids_input, true);
+        }
+        std::sort(generated.begin(), generated.end());
+        for (const auto& input : generated) {
+            auto tensor = MakeSegmentTensor(segments, tokens, input.second);
+            if (!tensor || static_cast<size_t>(input.first) > merged->size()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid segment input index");
+            }
+            merged->insert(merged->begin() + input.first, std::move(tensor));
+        }
+    }
+    return Status::Ok();
+}
+
+Status DynamicBatcher::SplitOutputs(const std::vector<std::unique_ptr<Request>>& batch,
+                                    const std::vector<std::shared_ptr<Tensor>>& outputs,
+                                    std::vector<BatchResult>* results) {
+    const SequenceBatchingOptions& sequence = options_.sequence;
+    const size_t axis = static_cast<size_t>(std::max(sequence.sequence_axis, 0));
+    std::vector<int64_t> rows;  // 各请求的样本数
+    int64_t tokens = 0;
+    for (const auto& request : batch) {
+        rows.push_back(request->rows);
+        tokens += request->rows * request->length;
+    }
+    for (const auto& output : outputs) {
+        const auto& dims = output->GetShape().dims;
+        if (sequence.mode == SequenceBatchingMode::PACKED && dims.size() >= 2 && dims[0] == 1 &&
+            dims[1] == tokens) {
+            // token输出：各段在[1, 总token数, ...]中相接，切回[r, L, ...]的连续视图
+            const int64_t inner = Product(dims, 2, dims.size());
+            const auto packed = MakeContiguous(output);
+            int64_t offset = 0;
+            for (size_t r = 0; r < batch.size(); ++r) {
+                Shape shape = output->GetShape();
+                shape.dims[0] = batch[r]->rows;
+                shape.dims[1] = batch[r]->length;
+                auto view = CreateStridedView(packed, shape, {}, offset * inner);
+                if (!view) {
+                    return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Failed to split packed output");
+                }
+                (*results)[r].outputs.push_back(std::move(view));
+                offset += batch[r]->rows * batch[r]->length;
+            }
+            continue;
+        }
+        auto views = SplitBatch(output, rows);
+        if (views.size() != batch.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Output is not batched along dimension 0");
+        }
+        for (size_t r = 0; r < batch.size(); ++r) {
+            const Request& request = *batch[r];
+            const auto& view_dims = views[r]->GetShape().dims;
+            if (sequence.mode == SequenceBatchingMode::BUCKET && request.length < request.bucket &&
+                view_dims.size() > axis && view_dims[axis] == request.bucket) {
+                // 序列轴上截去补齐的部分，拷成连续张量
+                Shape trimmed = views[r]->GetShape();
+                trimmed.dims[axis] = request.length;
+                views[r] = MakeContiguous(CreateStridedView(views[r], trimmed, views[r]->GetStrides()));
+                if (!views[r]) {
+                    return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Failed to trim padded output");
+                }
+            }
+            (*results)[r].outputs.push_back(std::move(views[r]));
+        }
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
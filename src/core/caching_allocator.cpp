@@ -0,0 +1,401 @@
+// 设备缓存分配器实现
+// 参考PyTorch CUDACachingAllocator：请求按512字节取整，不超过small_size的请求从2MB的小块段中切分，
+// 更大的请求按段大小（20MB，或超过10MB时按2MB取整）向设备申请；cudaMalloc/cudaFree会同步设备，
+// 因此段一经申请就留在缓存里，只在申请失败、超过max_cached_bytes或EmptyCache时归还
+
+#include "inferunity/memory.h"
+#include "inferunity/logger.h"
+#include "inferunity/metrics.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+constexpr size_t kMinBlockSize = 512;          // 所有块按512字节取整，地址对齐由段基址（>=256字节对齐）保证
+constexpr size_t kLargeRoundSize = 2 << 20;    // 超过10MB的请求按2MB取整成段
+constexpr size_t kMinLargeAlloc = 10 << 20;
+constexpr size_t kAddressAlignment = 256;
+constexpr size_t kNumBins = 24;                // 第i级收集[512 * 2^i, 512 * 2^(i+1))的块，最后一级不设上界
+
+size_t RoundSize(size_t size) {
+    return ((size + kMinBlockSize - 1) / kMinBlockSize) * kMinBlockSize;
+}
+
+size_t BinIndex(size_t size) {
+    size_t bin = 0;
+    for (size_t s = size / kMinBlockSize; s > 1 && bin + 1 < kNumBins; s >>= 1) {
+        ++bin;
+    }
+    return bin;
+}
+
+} // anonymous namespace
+
+struct CachingDeviceAllocator::Impl {
+    // 段内的块按地址串成双向链表，用于合并相邻的空闲块
+    struct Block {
+        void* stream = nullptr;
+        size_t size = 0;
+        size_t requested = 0;
+        char* ptr = nullptr;
+        bool small = false;
+        bool allocated = false;
+        int pending_events = 0;
+        Block* prev = nullptr;
+        Block* next = nullptr;
+        std::vector<void*> stream_uses;  // 分配流以外使用过该块的流
+    };
+    
+    struct BlockLess {
+        bool operator()(const Block* a, const Block* b) const {
+            if (a->stream != b->stream) return a->stream < b->stream;
+            if (a->size != b->size) return a->size < b->size;
+            return a->ptr < b->ptr;
+        }
+    };
+    
+    // 按大小分级的空闲链表；同一级内按(流, 大小, 地址)排序，lower_bound即最佳适配
+    struct BlockPool {
+        std::set<Block*, BlockLess> bins[kNumBins];
+    };
+    
+    struct PendingEvent {
+        void* event;
+        Block* block;
+    };
+    
+    Impl(std::unique_ptr<DeviceMemoryBackend> memory_backend, const CachingAllocatorOptions& allocator_options)
+        : backend(std::move(memory_backend)), options(allocator_options),
+          request_metric(MetricsRegistry::Instance().GetCounter(
+              "inferunity_allocator_requests_total", {{"allocator", "caching"}},
+              "Allocation requests served by the allocator")),
+          hit_metric(MetricsRegistry::Instance().GetCounter(
+              "inferunity_allocator_cache_hits_total", {{"allocator", "caching"}},
+              "Allocation requests served from cached blocks")) {}
+    
+    std::unique_ptr<DeviceMemoryBackend> backend;
+    const CachingAllocatorOptions& options;
+    
+    mutable std::mutex mutex;
+    BlockPool small_pool;
+    BlockPool large_pool;
+    std::unordered_map<void*, Block*> active;  // 已分配（含等待事件）的块
+    std::deque<PendingEvent> pending;
+    MemoryStats stats{0, 0, 0, 0};
+    CachingAllocatorStats caching_stats;
+    // 常驻指标：命中率 = cache_hits / requests
+    std::shared_ptr<Counter> request_metric;
+    std::shared_ptr<Counter> hit_metric;
+    
+    BlockPool& PoolOf(const Block* block) {
+        return block->small ? small_pool : large_pool;
+    }
+    
+    void Insert(Block* block) {
+        PoolOf(block).bins[BinIndex(block->size)].insert(block);
+    }
+    
+    void Erase(Block* block) {
+        PoolOf(block).bins[BinIndex(block->size)].erase(block);
+    }
+    
+    Block* FindFree(BlockPool& pool, size_t size, void* stream) {
+        Block key;
+        key.stream = stream;
+        key.size = size;
+        for (size_t bin = BinIndex(size); bin < kNumBins; ++bin) {
+            auto& blocks = pool.bins[bin];
+            auto it = blocks.lower_bound(&key);
+            if (it == blocks.end() || (*it)->stream != stream) {
+                continue;
+            }
+            Block* block = *it;
+            // 超过max_split_size的块不切分，避免一个小请求占着整个大块
+            if (options.max_split_size > 0 && block->size > options.max_split_size &&
+                size <= options.max_split_size) {
+                continue;
+            }
+            blocks.erase(it);
+            return block;
+        }
+        return nullptr;
+    }
+    
+    size_t SegmentSize(size_t size) const {
+        if (size <= options.small_size) {
+            return std::max(options.small_segment_size, size);
+        }
+        if (size < kMinLargeAlloc) {
+            return std::max(options.large_segment_size, size);
+        }
+        return ((size + kLargeRoundSize - 1) / kLargeRoundSize) * kLargeRoundSize;
+    }
+    
+    bool ShouldSplit(const Block* block, size_t size) const {
+        const size_t remaining = block->size - size;
+        if (block->small) {
+            return remaining >= kMinBlockSize;
+        }
+        if (options.max_split_size > 0 && block->size > options.max_split_size) {
+            return false;
+        }
+        return remaining > options.small_size;
+    }
+    
+    // 块回到缓存，与同一段内相邻的空闲块合并
+    void ReturnBlock(Block* block) {
+        block->allocated = false;
+        block->stream_uses.clear();
+        for (Block* neighbor : {block->prev, block->next}) {
+            if (!neighbor || neighbor->allocated) {
+                continue;
+            }
+            Erase(neighbor);
+            if (neighbor == block->prev) {
+                block->ptr = neighbor->ptr;
+                block->prev = neighbor->prev;
+                if (block->prev) block->prev->next = block;
+            } else {
+                block->next = neighbor->next;
+                if (block->next) block->next->prev = block;
+            }
+            block->size += neighbor->size;
+            delete neighbor;
+            ++caching_stats.merges;
+        }
+        Insert(block);
+    }
+    
+    void ProcessEvents() {
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (!backend->QueryEvent(it->event)) {
+                ++it;
+                continue;
+            }
+            backend->DestroyEvent(it->event);
+            Block* block = it->block;
+            it = pending.erase(it);
+            if (--block->pending_events == 0) {
+                --caching_stats.pending_frees;
+                ReturnBlock(block);
+            }
+        }
+    }
+    
+    void SynchronizeAndProcessEvents() {
+        if (pending.empty()) {
+            return;
+        }
+        backend->SynchronizeDevice();
+        ProcessEvents();
+    }
+    
+    // 完全空闲（整段未切分）的块归还设备；max_bytes为需要腾出的字节数，0表示全部
+    void ReleaseSegments(size_t max_bytes) {
+        size_t released = 0;
+        for (BlockPool* pool : {&large_pool, &small_pool}) {
+            for (auto& bin : pool->bins) {
+                for (auto it = bin.begin(); it != bin.end();) {
+                    Block* block = *it;
+                    if (block->prev || block->next) {
+                        ++it;
+                        continue;
+                    }
+                    it = bin.erase(it);
+                    backend->RawFree(block->ptr);
+                    caching_stats.reserved_bytes -= block->size;
+                    ++caching_stats.device_frees;
+                    released += block->size;
+                    delete block;
+                    if (max_bytes > 0 && released >= max_bytes) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    
+    Block* AllocateSegment(size_t size, void* stream) {
+        const size_t segment_size = SegmentSize(size);
+        void* ptr = backend->RawAllocate(segment_size);
+        if (!ptr) {
+            // 设备内存不足：等待事件完成、归还所有缓存的段后重试
+            SynchronizeAndProcessEvents();
+            ReleaseSegments(0);
+            ptr = backend->RawAllocate(segment_size);
+        }
+        if (!ptr) {
+            LOG_WARNING("Device allocation of " + std::to_string(segment_size) + " bytes failed");
+            return nullptr;
+        }
+        Block* block = new Block();
+        block->stream = stream;
+        block->size = segment_size;
+        block->ptr = static_cast<char*>(ptr);
+        block->small = size <= options.small_size;
+        caching_stats.reserved_bytes += segment_size;
+        caching_stats.peak_reserved_bytes = std::max(caching_stats.peak_reserved_bytes,
+                                                     caching_stats.reserved_bytes);
+        ++caching_stats.device_allocations;
+        return block;
+    }
+    
+    void* Allocate(size_t requested, void* stream) {
+        if (requested == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ProcessEvents();
+        const size_t size = RoundSize(requested);
+        BlockPool& pool = size <= options.small_size ? small_pool : large_pool;
+        Block* block = FindFree(pool, size, stream);
+        request_metric->Add();
+        if (block) {
+            ++caching_stats.cache_hits;
+            hit_metric->Add();
+        } else {
+            block = AllocateSegment(size, stream);
+            if (!block) {
+                return nullptr;
+            }
+        }
+        
+        if (ShouldSplit(block, size)) {
+            Block* remaining = new Block();
+            remaining->stream = stream;
+            remaining->size = block->size - size;
+            remaining->ptr = block->ptr + size;
+            remaining->small = block->small;
+            remaining->prev = block;
+            remaining->next = block->next;
+            if (remaining->next) remaining->next->prev = remaining;
+            block->next = remaining;
+            block->size = size;
+            Insert(remaining);
+            ++caching_stats.splits;
+        }
+        
+        block->allocated = true;
+        block->requested = requested;
+        active[block->ptr] = block;
+        stats.allocated_bytes += block->size;
+        stats.peak_allocated_bytes = std::max(stats.peak_allocated_bytes, stats.allocated_bytes);
+        ++stats.allocation_count;
+        return block->ptr;
+    }
+    
+    void Free(void* ptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = active.find(ptr);
+        if (it == active.end()) {
+            LOG_WARNING("Freeing a pointer not owned by the caching allocator");
+            return;
+        }
+        Block* block = it->second;
+        active.erase(it);
+        stats.allocated_bytes -= block->size;
+        ++stats.free_count;
+        
+        // 其他流上可能还有读写该块的核函数：在这些流上记录事件，完成后才复用
+        for (void* stream : block->stream_uses) {
+            void* event = backend->RecordEvent(stream);
+            if (event) {
+                pending.push_back({event, block});
+                ++block->pending_events;
+            }
+        }
+        if (block->pending_events > 0) {
+            ++caching_stats.pending_frees;
+            return;
+        }
+        ReturnBlock(block);
+        
+        if (options.max_cached_bytes > 0) {
+            const size_t cached = caching_stats.reserved_bytes - stats.allocated_bytes;
+            if (cached > options.max_cached_bytes) {
+                ReleaseSegments(cached - options.max_cached_bytes);
+            }
+        }
+    }
+};
+
+CachingDeviceAllocator::CachingDeviceAllocator(std::unique_ptr<DeviceMemoryBackend> backend,
+                                               const CachingAllocatorOptions& options)
+    : options_(options), impl_(new Impl(std::move(backend), options_)) {}
+
+CachingDeviceAllocator::~CachingDeviceAllocator() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->SynchronizeAndProcessEvents();
+    impl_->ReleaseSegments(0);
+    if (!impl_->active.empty()) {
+        LOG_WARNING("Caching allocator destroyed with " + std::to_string(impl_->active.size()) +
+                    " live blocks");
+    }
+}
+
+void* CachingDeviceAllocator::Allocate(size_t size) {
+    return impl_->Allocate(size, nullptr);
+}
+
+void* CachingDeviceAllocator::AllocateAligned(size_t size, size_t alignment) {
+    if (alignment > kAddressAlignment) {
+        LOG_WARNING("Caching allocator only guarantees " + std::to_string(kAddressAlignment) +
+                    "-byte alignment");
+        return nullptr;
+    }
+    return impl_->Allocate(size, nullptr);
+}
+
+void CachingDeviceAllocator::Free(void* ptr) {
+    if (ptr) {
+        impl_->Free(ptr);
+    }
+}
+
+size_t CachingDeviceAllocator::GetAllocatedSize(void* ptr) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = impl_->active.find(ptr);
+    return it != impl_->active.end() ? it->second->requested : 0;
+}
+
+bool CachingDeviceAllocator::GetStats(MemoryStats* stats) const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    *stats = impl_->stats;
+    return true;
+}
+
+void* CachingDeviceAllocator::AllocateOnStream(size_t size, void* stream) {
+    return impl_->Allocate(size, stream);
+}
+
+void CachingDeviceAllocator::RecordStream(void* ptr, void* stream) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = impl_->active.find(ptr);
+    if (it == impl_->active.end()) {
+        return;
+    }
+    auto* block = it->second;
+    if (stream != block->stream &&
+        std::find(block->stream_uses.begin(), block->stream_uses.end(), stream) == block->stream_uses.end()) {
+        block->stream_uses.push_back(stream);
+    }
+}
+
+void CachingDeviceAllocator::EmptyCache() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->SynchronizeAndProcessEvents();
+    impl_->ReleaseSegments(0);
+}
+
+CachingAllocatorStats CachingDeviceAllocator::GetCachingStats() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->caching_stats;
+}
+
+} // namespace inferunity
@@ -0,0 +1,308 @@
+// 张量并行与流水线并行的通信
+// 主机实现参考NCCL的环形AllReduce：每个rank负责归约1/world_size的数据，再从其他rank取回其余部分；
+// 点对点传输经由每对rank之间的信箱
+
+#include "inferunity/collectives.h"
+#include "inferunity/float16.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<int64_t, std::weak_ptr<CollectiveGroup>>& Groups() {
+    static std::unordered_map<int64_t, std::weak_ptr<CollectiveGroup>> groups;
+    return groups;
+}
+
+std::unordered_map<int, CollectiveGroupFactory>& Factories() {
+    static std::unordered_map<int, CollectiveGroupFactory> factories;
+    return factories;
+}
+
+float LoadElement(const void* data, DataType dtype, size_t index) {
+    switch (dtype) {
+        case DataType::FLOAT16:
+            return HalfToFloat(static_cast<const uint16_t*>(data)[index]);
+        case DataType::BFLOAT16:
+            return BFloat16ToFloat(static_cast<const uint16_t*>(data)[index]);
+        default:
+            return static_cast<const float*>(data)[index];
+    }
+}
+
+void StoreElement(void* data, DataType dtype, size_t index, float value) {
+    switch (dtype) {
+        case DataType::FLOAT16:
+            static_cast<uint16_t*>(data)[index] = FloatToHalf(value);
+            break;
+        case DataType::BFLOAT16:
+            static_cast<uint16_t*>(data)[index] = FloatToBFloat16(value);
+            break;
+        default:
+            static_cast<float*>(data)[index] = value;
+            break;
+    }
+}
+
+// 进程内的主机实现：各rank在三个屏障之间经由对方的输入/输出缓冲交换数据，
+// 求和按rank顺序以FP32累加，每个rank得到逐位相同的结果
+class HostCollectiveGroup : public CollectiveGroup {
+public:
+    explicit HostCollectiveGroup(const std::vector<int>& device_ids)
+        : CollectiveGroup(device_ids), slots_(device_ids.size()), mailboxes_(device_ids.size() * device_ids.size()) {}
+
+    Status AllReduceSum(int rank, int64_t tag, const Tensor& input, Tensor* output, void* stream) override {
+        (void)stream;
+        DataType dtype = input.GetDataType();
+        if (dtype != DataType::FLOAT32 && dtype != DataType::FLOAT16 && dtype != DataType::BFLOAT16) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "AllReduce supports floating-point tensors only");
+        }
+        if (output->GetSizeInBytes() != input.GetSizeInBytes() || output->GetDataType() != dtype) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllReduce output does not match input");
+        }
+        Status status = Publish(rank, tag, input, output);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int world_size = GetWorldSize();
+        const size_t count = input.GetElementCount();
+        auto slice_begin = [&](int r) { return count * static_cast<size_t>(r) / static_cast<size_t>(world_size); };
+
+        // 归约自己负责的一段，写进自己的输出
+        for (size_t i = slice_begin(rank); i < slice_begin(rank + 1); ++i) {
+            float sum = 0.0f;
+            for (int r = 0; r < world_size; ++r) {
+                sum += LoadElement(slots_[r].input, dtype, i);
+            }
+            StoreElement(output->GetData(), dtype, i, sum);
+        }
+        status = Barrier();
+        if (!status.IsOk()) {
+            return status;
+        }
+        // 其余各段从负责它的rank的输出取回
+        const size_t element_size = Tensor::GetDataTypeSize(dtype);
+        for (int r = 0; r < world_size; ++r) {
+            if (r == rank) {
+                continue;
+            }
+            const size_t begin = slice_begin(r);
+            std::memcpy(static_cast<uint8_t*>(output->GetData()) + begin * element_size,
+                        static_cast<const uint8_t*>(slots_[r].output) + begin * element_size,
+                        (slice_begin(r + 1) - begin) * element_size);
+        }
+        // 对方读完之前输出缓冲不能被复用
+        return Barrier();
+    }
+
+    Status AllGather(int rank, int64_t tag, const Tensor& input, int64_t axis, Tensor* output,
+                     void* stream) override {
+        (void)stream;
+        const auto& dims = input.GetShape().dims;
+        if (axis < 0 || axis >= static_cast<int64_t>(dims.size())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllGather axis out of range");
+        }
+        const int world_size = GetWorldSize();
+        if (output->GetSizeInBytes() != input.GetSizeInBytes() * static_cast<size_t>(world_size) ||
+            output->GetDataType() != input.GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllGather output does not match input");
+        }
+        Status status = Publish(rank, tag, input, output);
+        if (!status.IsOk()) {
+            return status;
+        }
+        size_t outer = 1;
+        for (int64_t i = 0; i < axis; ++i) {
+            outer *= static_cast<size_t>(dims[i]);
+        }
+        const size_t chunk = outer > 0 ? input.GetSizeInBytes() / outer : 0;
+        uint8_t* dst = static_cast<uint8_t*>(output->GetData());
+        for (size_t o = 0; o < outer; ++o) {
+            for (int r = 0; r < world_size; ++r) {
+                std::memcpy(dst + (o * world_size + r) * chunk,
+                            static_cast<const uint8_t*>(slots_[r].input) + o * chunk, chunk);
+            }
+        }
+        return Barrier();
+    }
+
+    Status Send(int rank, int peer, int64_t tag, const Tensor& input, void* stream) override {
+        (void)stream;
+        if (rank < 0 || rank >= GetWorldSize() || peer < 0 || peer >= GetWorldSize() || peer == rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Send peer out of range");
+        }
+        const uint8_t* data = static_cast<const uint8_t*>(input.GetData());
+        Message message{tag, std::vector<uint8_t>(data, data + input.GetSizeInBytes())};
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (aborted_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Collective group aborted");
+        }
+        mailboxes_[Mailbox(rank, peer)].push_back(std::move(message));
+        cv_.notify_all();
+        return Status::Ok();
+    }
+
+    Status Recv(int rank, int peer, int64_t tag, Tensor* output, void* stream) override {
+        (void)stream;
+        if (rank < 0 || rank >= GetWorldSize() || peer < 0 || peer >= GetWorldSize() || peer == rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Recv peer out of range");
+        }
+        std::deque<Message>& mailbox = mailboxes_[Mailbox(peer, rank)];
+        Message message;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&]() { return !mailbox.empty() || aborted_; });
+            if (aborted_) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Collective group aborted");
+            }
+            message = std::move(mailbox.front());
+            mailbox.pop_front();
+        }
+        if (message.tag != tag || message.bytes.size() != output->GetSizeInBytes()) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Recv does not match the next message from rank " + std::to_string(peer) +
+                               " (tag " + std::to_string(tag) + ")");
+        }
+        std::memcpy(output->GetData(), message.bytes.data(), message.bytes.size());
+        return Status::Ok();
+    }
+
+    void Abort() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        cv_.notify_all();
+    }
+
+    void Reset() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = false;
+        arrived_ = 0;
+        for (auto& mailbox : mailboxes_) {
+            mailbox.clear();
+        }
+    }
+
+private:
+    struct Slot {
+        const void* input = nullptr;
+        void* output = nullptr;
+        int64_t tag = 0;
+        size_t bytes = 0;
+    };
+
+    // 登记本rank的缓冲并等待所有rank到达；各rank到达的不是同一个集合操作时一致地返回错误
+    Status Publish(int rank, int64_t tag, const Tensor& input, Tensor* output) {
+        if (rank < 0 || rank >= GetWorldSize()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Collective rank out of range");
+        }
+        slots_[rank] = Slot{input.GetData(), output->GetData(), tag, input.GetSizeInBytes()};
+        Status status = Barrier();
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (const Slot& slot : slots_) {
+            if (slot.tag != tag || slot.bytes != slots_[0].bytes) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Ranks entered different collectives (tag " + std::to_string(tag) + ")");
+            }
+        }
+        return Status::Ok();
+    }
+
+    Status Barrier() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (aborted_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Collective group aborted");
+        }
+        const uint64_t generation = generation_;
+        if (++arrived_ == GetWorldSize()) {
+            arrived_ = 0;
+            ++generation_;
+            cv_.notify_all();
+            return Status::Ok();
+        }
+        cv_.wait(lock, [&]() { return generation_ != generation || aborted_; });
+        if (generation_ == generation) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Collective group aborted");
+        }
+        return Status::Ok();
+    }
+
+    struct Message {
+        int64_t tag = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    size_t Mailbox(int src, int dst) const {
+        return static_cast<size_t>(src) * static_cast<size_t>(GetWorldSize()) + static_cast<size_t>(dst);
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<std::deque<Message>> mailboxes_;  // 按(发送方, 接收方)下标
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int arrived_ = 0;
+    uint64_t generation_ = 0;
+    bool aborted_ = false;
+};
+
+int64_t NextGroupId() {
+    static std::atomic<int64_t> next_id{1};
+    return next_id.fetch_add(1);
+}
+
+} // anonymous namespace
+
+CollectiveGroup::CollectiveGroup(const std::vector<int>& device_ids)
+    : world_size_(static_cast<int>(device_ids.size())), id_(NextGroupId()), device_ids_(device_ids) {}
+
+std::shared_ptr<CollectiveGroup> CollectiveGroup::Create(DeviceType device_type, const std::vector<int>& device_ids) {
+    if (device_ids.empty()) {
+        return nullptr;
+    }
+    CollectiveGroupFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        auto it = Factories().find(static_cast<int>(device_type));
+        if (it != Factories().end()) {
+            factory = it->second;
+        }
+    }
+    std::shared_ptr<CollectiveGroup> group = factory ? factory(device_ids) : nullptr;
+    if (!group) {
+        group = std::make_shared<HostCollectiveGroup>(device_ids);
+    }
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    auto& groups = Groups();
+    for (auto it = groups.begin(); it != groups.end();) {
+        it = it->second.expired() ? groups.erase(it) : std::next(it);
+    }
+    groups[group->GetId()] = group;
+    return group;
+}
+
+std::shared_ptr<CollectiveGroup> CollectiveGroup::Find(int64_t id) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    auto it = Groups().find(id);
+    return it != Groups().end() ? it->second.lock() : nullptr;
+}
+
+void SetCollectiveGroupFactory(DeviceType device_type, CollectiveGroupFactory factory) {
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    Factories()[static_cast<int>(device_type)] = std::move(factory);
+}
+
+} // namespace inferunity
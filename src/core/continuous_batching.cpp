@@ -0,0 +1,319 @@
+// 迭代级批处理调度实现
+// 参考vLLM的Scheduler：运行队列按到达顺序优先，KV块不足时换出最晚加入的序列（交换区放得下时swap式，
+// 否则recompute式抢占），有序列被换出的一步不再换入或接纳新请求；换出的序列先于新请求换回
+
+#include "inferunity/continuous_batching.h"
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace inferunity {
+
+ContinuousBatchScheduler::ContinuousBatchScheduler(PagedKVCache* cache, const ContinuousBatchingOptions& options)
+    : cache_(cache), options_(options) {
+    stats_.tokens_per_step = Histogram(BatchSizeBuckets(static_cast<int>(options_.max_num_tokens)));
+    stats_.sequences_per_step = Histogram(BatchSizeBuckets(static_cast<int>(options_.max_num_sequences)));
+}
+
+Status ContinuousBatchScheduler::AddRequest(const GenerationRequest& request) {
+    if (request.prompt.empty() || request.max_new_tokens <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Generation request needs a prompt and max_new_tokens > 0");
+    }
+    auto seq = std::make_unique<Sequence>();
+    seq->request = request;
+    seq->tokens = request.prompt;
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiting_.push_back(std::move(seq));
+    return Status::Ok();
+}
+
+void ContinuousBatchScheduler::AbortRequest(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_.insert(id);
+}
+
+bool ContinuousBatchScheduler::HasPendingRequests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !waiting_.empty() || !running_.empty() || !swapped_.empty();
+}
+
+Status ContinuousBatchScheduler::Schedule(ScheduledBatch* batch, std::vector<GenerationResult>* finished) {
+    if (!cache_ || cache_->GetNumLayers() == 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Scheduler needs a paged KV cache with layers");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    DrainAborted(finished);
+    *batch = ScheduledBatch();
+    batch->query_offsets.push_back(0);
+    int64_t budget = options_.max_num_tokens;
+    bool preempted = false;
+    
+    // 运行中的序列：解码token或剩余prompt的分块
+    for (size_t i = 0; i < running_.size() && budget > 0;) {
+        Sequence* seq = running_[i].get();
+        const int64_t tokens = ChunkSize(*seq, budget);
+        bool reserved = cache_->AppendSlots(seq->request.id, tokens).IsOk();
+        // 块不足：从最晚加入、本步尚未安排的序列开始换出，直到够用或只剩自己
+        while (!reserved && running_.size() > i + 1) {
+            std::unique_ptr<Sequence> victim = std::move(running_.back());
+            running_.pop_back();
+            Preempt(std::move(victim));
+            preempted = true;
+            reserved = cache_->AppendSlots(seq->request.id, tokens).IsOk();
+        }
+        if (reserved) {
+            AddToBatch(*seq, tokens, batch);
+            budget -= tokens;
+            ++i;
+            continue;
+        }
+        std::unique_ptr<Sequence> self = std::move(running_[i]);
+        running_.erase(running_.begin() + static_cast<std::ptrdiff_t>(i));
+        if (i == 0 && batch->sequences.empty()) {
+            // 整个cache都给它也放不下，重新计算只会再次失败
+            cache_->RemoveSequence(self->request.id);
+            Finish(std::move(self),
+                   Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Sequence does not fit in the KV cache"),
+                   finished);
+        } else {
+            Preempt(std::move(self));
+            preempted = true;
+        }
+    }
+    
+    // 换出的序列先于新请求，全部换回之前不接纳新请求
+    bool swapped_in = false;
+    if (!preempted) {
+        swapped_in = SwapInSequences(&budget, batch);
+    }
+    if (swapped_in) {
+        cache_->WaitForSwaps();
+    }
+    
+    // 用剩余预算接纳新请求（先到先服务）
+    while (!preempted && swapped_.empty() && budget > 0 && !waiting_.empty() &&
+           static_cast<int64_t>(running_.size()) < options_.max_num_sequences) {
+        Sequence* seq = waiting_.front().get();
+        const int64_t id = seq->request.id;
+        // 前缀缓存命中的整块直接复用，只prefill其余部分
+        int64_t cached = 0;
+        if (!cache_->AddSequence(id, seq->tokens, &cached).IsOk()) {
+            std::unique_ptr<Sequence> duplicate = std::move(waiting_.front());
+            waiting_.pop_front();
+            Finish(std::move(duplicate),
+                   Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Duplicate request id: " + std::to_string(id)),
+                   finished);
+            continue;
+        }
+        seq->num_computed = cached;
+        const int64_t tokens = ChunkSize(*seq, budget);
+        if (!cache_->AppendSlots(id, tokens).IsOk()) {
+            cache_->RemoveSequence(id);
+            seq->num_computed = 0;
+            if (running_.empty()) {
+                std::unique_ptr<Sequence> rejected = std::move(waiting_.front());
+                waiting_.pop_front();
+                Finish(std::move(rejected),
+                       Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Sequence does not fit in the KV cache"),
+                       finished);
+                continue;
+            }
+            break;
+        }
+        AddToBatch(*seq, tokens, batch);
+        budget -= tokens;
+        running_.push_back(std::move(waiting_.front()));
+        waiting_.pop_front();
+    }
+    return Status::Ok();
+}
+
+Status ContinuousBatchScheduler::Update(const ScheduledBatch& batch, const std::vector<int32_t>& sampled,
+                                        std::vector<GenerationResult>* finished) {
+    if (sampled.size() < batch.sequences.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Step returned fewer tokens than sequences");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<int64_t, size_t> index;
+    for (size_t i = 0; i < running_.size(); ++i) {
+        index.emplace(running_[i]->request.id, i);
+    }
+    std::vector<size_t> done;
+    for (size_t b = 0; b < batch.sequences.size(); ++b) {
+        auto it = index.find(batch.sequences[b]);
+        if (it == index.end()) {
+            continue;
+        }
+        Sequence* seq = running_[it->second].get();
+        const int64_t tokens = batch.query_offsets[b + 1] - batch.query_offsets[b];
+        if (tokens == 1 && seq->num_generated > 0) {
+            ++stats_.num_decode_tokens;
+        } else {
+            stats_.num_prefill_tokens += static_cast<uint64_t>(tokens);
+        }
+        seq->num_computed += tokens;
+        cache_->CachePrefix(seq->request.id, seq->tokens, seq->num_computed);
+        if (!batch.sample[b]) {
+            continue;
+        }
+        const int32_t token = sampled[b];
+        seq->tokens.push_back(token);
+        ++seq->num_generated;
+        if (static_cast<int64_t>(seq->num_generated) >= seq->request.max_new_tokens ||
+            (seq->request.eos_token >= 0 && token == seq->request.eos_token)) {
+            done.push_back(it->second);
+        }
+    }
+    // 从后往前移除，前面的下标保持有效
+    std::sort(done.rbegin(), done.rend());
+    for (size_t i : done) {
+        std::unique_ptr<Sequence> seq = std::move(running_[i]);
+        running_.erase(running_.begin() + static_cast<std::ptrdiff_t>(i));
+        cache_->RemoveSequence(seq->request.id);
+        Finish(std::move(seq), Status::Ok(), finished);
+    }
+    ++stats_.num_steps;
+    stats_.tokens_per_step.Record(static_cast<double>(batch.GetNumTokens()));
+    stats_.sequences_per_step.Record(static_cast<double>(batch.sequences.size()));
+    return Status::Ok();
+}
+
+void ContinuousBatchScheduler::Rollback(const ScheduledBatch& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& seq : running_) {
+        if (std::find(batch.sequences.begin(), batch.sequences.end(), seq->request.id) != batch.sequences.end()) {
+            cache_->Trim(seq->request.id, seq->num_computed);
+        }
+    }
+}
+
+Status ContinuousBatchScheduler::Step(const StepFunction& step, std::vector<GenerationResult>* finished) {
+    ScheduledBatch batch;
+    Status status = Schedule(&batch, finished);
+    if (!status.IsOk() || batch.sequences.empty()) {
+        return status;
+    }
+    std::vector<int32_t> sampled(batch.sequences.size(), 0);
+    status = step(batch, &sampled);
+    if (!status.IsOk()) {
+        Rollback(batch);
+        return status;
+    }
+    return Update(batch, sampled, finished);
+}
+
+ContinuousBatchingStats ContinuousBatchScheduler::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+int64_t ContinuousBatchScheduler::ChunkSize(const Sequence& seq, int64_t budget) const {
+    int64_t tokens = std::min(static_cast<int64_t>(seq.tokens.size()) - seq.num_computed, budget);
+    if (options_.max_prefill_chunk > 0) {
+        tokens = std::min(tokens, options_.max_prefill_chunk);
+    }
+    return tokens;
+}
+
+void ContinuousBatchScheduler::AddToBatch(const Sequence& seq, int64_t tokens, ScheduledBatch* batch) {
+    batch->sequences.push_back(seq.request.id);
+    for (int64_t j = 0; j < tokens; ++j) {
+        batch->tokens.push_back(seq.tokens[static_cast<size_t>(seq.num_computed + j)]);
+        batch->positions.push_back(seq.num_computed + j);
+    }
+    batch->query_offsets.push_back(static_cast<int64_t>(batch->tokens.size()));
+    batch->sample.push_back(seq.num_computed + tokens == static_cast<int64_t>(seq.tokens.size()));
+}
+
+void ContinuousBatchScheduler::Preempt(std::unique_ptr<Sequence> seq) {
+    if (cache_->GetOptions().max_swap_blocks > 0 && cache_->SwapOut(seq->request.id).IsOk()) {
+        ++stats_.num_swap_outs;
+        swapped_.push_front(std::move(seq));
+        return;
+    }
+    cache_->RemoveSequence(seq->request.id);
+    seq->num_computed = 0;
+    ++stats_.num_preemptions;
+    waiting_.push_front(std::move(seq));
+}
+
+bool ContinuousBatchScheduler::SwapInSequences(int64_t* budget, ScheduledBatch* batch) {
+    bool swapped_in = false;
+    while (*budget > 0 && !swapped_.empty() &&
+           static_cast<int64_t>(running_.size()) < options_.max_num_sequences) {
+        Sequence* seq = swapped_.front().get();
+        const int64_t id = seq->request.id;
+        if (!cache_->CanSwapIn(id) || !cache_->SwapIn(id).IsOk()) {
+            break;
+        }
+        const int64_t tokens = ChunkSize(*seq, *budget);
+        if (!cache_->AppendSlots(id, tokens).IsOk()) {
+            // 换回的块够了但下一段token的块不够：原样换出等下一步，换不出时改为重新计算
+            if (!cache_->SwapOut(id).IsOk()) {
+                std::unique_ptr<Sequence> recompute = std::move(swapped_.front());
+                swapped_.pop_front();
+                cache_->RemoveSequence(id);
+                recompute->num_computed = 0;
+                ++stats_.num_preemptions;
+                waiting_.push_front(std::move(recompute));
+            }
+            break;
+        }
+        swapped_in = true;
+        ++stats_.num_swap_ins;
+        AddToBatch(*seq, tokens, batch);
+        *budget -= tokens;
+        running_.push_back(std::move(swapped_.front()));
+        swapped_.pop_front();
+    }
+    return swapped_in;
+}
+
+void ContinuousBatchScheduler::Finish(std::unique_ptr<Sequence> seq, Status status,
+                                      std::vector<GenerationResult>* finished) {
+    ++stats_.num_finished;
+    if (finished) {
+        GenerationResult result;
+        result.id = seq->request.id;
+        result.status = std::move(status);
+        result.tokens.assign(seq->tokens.end() - static_cast<std::ptrdiff_t>(seq->num_generated), seq->tokens.end());
+        finished->push_back(std::move(result));
+    }
+}
+
+void ContinuousBatchScheduler::DrainAborted(std::vector<GenerationResult>* finished) {
+    if (aborted_.empty()) {
+        return;
+    }
+    const Status aborted = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Generation request aborted");
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+        if (aborted_.count((*it)->request.id)) {
+            Finish(std::move(*it), aborted, finished);
+            it = waiting_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = swapped_.begin(); it != swapped_.end();) {
+        if (aborted_.count((*it)->request.id)) {
+            cache_->RemoveSequence((*it)->request.id);
+            Finish(std::move(*it), aborted, finished);
+            it = swapped_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = running_.begin(); it != running_.end();) {
+        if (aborted_.count((*it)->request.id)) {
+            cache_->RemoveSequence((*it)->request.id);
+            Finish(std::move(*it), aborted, finished);
+            it = running_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    aborted_.clear();
+}
+
+} // namespace inferunity
@@ -0,0 +1,159 @@
+// CPU特性检测实现
+// x86使用CPUID + XGETBV（AVX/AVX-512还需要操作系统启用YMM/ZMM状态），
+// Linux AArch64使用getauxval(AT_HWCAP)
+
+#include "inferunity/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define INFERUNITY_CPU_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+
+#ifdef INFERUNITY_CPU_X86
+struct CpuidRegs {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+CpuidRegs Cpuid(unsigned int leaf, unsigned int subleaf) {
+    CpuidRegs r;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r.eax = regs[0]; r.ebx = regs[1]; r.ecx = regs[2]; r.edx = regs[3];
+#else
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+    return r;
+}
+
+unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+
+inline bool Bit(unsigned int value, int bit) {
+    return (value >> bit) & 1u;
+}
+
+// Linux 5.16起AMX的tile数据状态默认不分配，进程须先通过arch_prctl(ARCH_REQ_XCOMP_PERM)申请，
+// 否则第一次执行tile指令会收到SIGILL
+bool RequestAmxPermission() {
+#if defined(__linux__) && defined(__x86_64__)
+    constexpr long kArchReqXcompPerm = 0x1023;
+    constexpr long kXfeatureXtileData = 18;
+    return syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtileData) == 0;
+#else
+    return true;
+#endif
+}
+#endif
+
+CpuFeatures Detect() {
+    CpuFeatures f;
+#ifdef INFERUNITY_CPU_X86
+    const unsigned int max_leaf = Cpuid(0, 0).eax;
+    if (max_leaf < 1) {
+        return f;
+    }
+    const CpuidRegs leaf1 = Cpuid(1, 0);
+    f.sse42 = Bit(leaf1.ecx, 20);
+    
+    // OS通过XSAVE保存的寄存器状态：bit1/2为XMM/YMM，bit5-7为AVX-512的opmask/ZMM
+    const bool osxsave = Bit(leaf1.ecx, 27);
+    const unsigned long long xcr0 = osxsave ? ReadXcr0() : 0;
+    const bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+    const bool zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+    
+    f.avx = ymm_enabled && Bit(leaf1.ecx, 28);
+    f.fma = f.avx && Bit(leaf1.ecx, 12);
+    f.f16c = f.avx && Bit(leaf1.ecx, 29);
+    if (max_leaf >= 7) {
+        const CpuidRegs leaf7 = Cpuid(7, 0);
+        f.avx2 = f.avx && Bit(leaf7.ebx, 5);
+        f.avx512f = zmm_enabled && Bit(leaf7.ebx, 16);
+        f.avx512bw = f.avx512f && Bit(leaf7.ebx, 30);
+        f.avx512vl = f.avx512f && Bit(leaf7.ebx, 31);
+        f.avx512_vnni = f.avx512f && Bit(leaf7.ecx, 11);
+        if (leaf7.eax >= 1) {
+            f.avx512_bf16 = f.avx512f && Bit(Cpuid(7, 1).eax, 5);
+        }
+        f.hybrid = Bit(leaf7.edx, 15);
+        // XCR0的bit17/18为TILECFG/TILEDATA
+        const bool tile_enabled = (xcr0 & 0x60000) == 0x60000;
+        if (tile_enabled && Bit(leaf7.edx, 24) && RequestAmxPermission()) {
+            f.amx_tile = true;
+            f.amx_int8 = Bit(leaf7.edx, 25);
+            f.amx_bf16 = Bit(leaf7.edx, 22);
+        }
+    }
+#elif defined(__aarch64__)
+#if defined(__linux__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    f.neon = (hwcap & HWCAP_ASIMD) != 0;
+#ifdef HWCAP_ASIMDDP
+    f.neon_dotprod = (hwcap & HWCAP_ASIMDDP) != 0;
+#endif
+#ifdef HWCAP_ASIMDHP
+    f.neon_fp16 = (hwcap & HWCAP_ASIMDHP) != 0;
+#endif
+#ifdef HWCAP_SVE
+    f.sve = (hwcap & HWCAP_SVE) != 0;
+#endif
+#else
+    f.neon = true;  // AArch64的基础指令集包含Advanced SIMD
+#if defined(__ARM_FEATURE_DOTPROD)
+    f.neon_dotprod = true;
+#endif
+#if defined(__ARM_FEATURE_FP16_VECTOR_ARITHMETIC)
+    f.neon_fp16 = true;
+#endif
+#endif
+#elif defined(__ARM_NEON)
+    f.neon = true;
+#elif defined(__wasm_simd128__)
+    f.wasm_simd128 = true;  // 模块验证时已由引擎确认，运行时无从也无需检测
+#endif
+    return f;
+}
+
+} // anonymous namespace
+
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = Detect();
+    return features;
+}
+
+int GetCurrentHybridCoreType() {
+#ifdef INFERUNITY_CPU_X86
+    if (!GetCpuFeatures().hybrid || Cpuid(0, 0).eax < 0x1a) {
+        return 0;
+    }
+    return static_cast<int>(Cpuid(0x1a, 0).eax >> 24);
+#else
+    return 0;
+#endif
+}
+
+} // namespace inferunity
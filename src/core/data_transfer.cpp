@@ -0,0 +1,67 @@
+// 数据传输注册表
+// 参考ONNX Runtime的DataTransferManager：按设备类型查找主机与设备之间的拷贝实现
+
+#include "inferunity/data_transfer.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+class CompletedTransferEvent : public TransferEvent {
+public:
+    explicit CompletedTransferEvent(Status status) : status_(std::move(status)) {}
+    
+    bool IsComplete() override { return true; }
+    Status Wait() override { return status_; }
+
+private:
+    Status status_;
+};
+
+std::mutex transfer_mutex;
+std::unordered_map<DeviceType, std::shared_ptr<DataTransfer>> transfers;
+
+} // anonymous namespace
+
+std::shared_ptr<TransferEvent> MakeCompletedTransferEvent(Status status) {
+    return std::make_shared<CompletedTransferEvent>(std::move(status));
+}
+
+Status DataTransfer::CopyHostToDeviceAsync(void* dst, const void* src, size_t size, void* stream,
+                                           std::shared_ptr<TransferEvent>* event) {
+    (void)stream;
+    Status status = CopyHostToDevice(dst, src, size);
+    if (event) {
+        *event = MakeCompletedTransferEvent(status);
+    }
+    return status;
+}
+
+Status DataTransfer::CopyDeviceToHostAsync(void* dst, const void* src, size_t size, void* stream,
+                                           std::shared_ptr<TransferEvent>* event) {
+    (void)stream;
+    Status status = CopyDeviceToHost(dst, src, size);
+    if (event) {
+        *event = MakeCompletedTransferEvent(status);
+    }
+    return status;
+}
+
+void SetDataTransfer(DeviceType device, std::shared_ptr<DataTransfer> transfer) {
+    std::lock_guard<std::mutex> lock(transfer_mutex);
+    if (transfer) {
+        transfers[device] = std::move(transfer);
+    } else {
+        transfers.erase(device);
+    }
+}
+
+std::shared_ptr<DataTransfer> GetDataTransfer(DeviceType device) {
+    std::lock_guard<std::mutex> lock(transfer_mutex);
+    auto it = transfers.find(device);
+    return it != transfers.end() ? it->second : nullptr;
+}
+
+} // namespace inferunity
@@ -0,0 +1,169 @@
+#include "inferunity/memory.h"
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+    // DmaBufAllocator分配的缓冲：映射起点 -> (fd, 大小)，供FindDmaBufRegion按地址反查
+    struct DmaBufEntry {
+        int fd;
+        size_t size;
+    };
+    std::mutex dma_bufs_mutex;
+    std::map<const uint8_t*, DmaBufEntry> dma_bufs;
+
+    size_t PageSize() {
+#ifdef __linux__
+        static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return page_size;
+#else
+        return 4096;
+#endif
+    }
+}
+
+std::shared_ptr<DmaBufAllocator> DmaBufAllocator::Instance() {
+    static std::shared_ptr<DmaBufAllocator> instance = std::make_shared<DmaBufAllocator>();
+    return instance;
+}
+
+DmaBufAllocator::DmaBufAllocator() {
+#ifdef __linux__
+    // 高通的system堆带有DSP可访问的属性，其余平台用标准的system堆
+    const char* heaps[] = {"/dev/dma_heap/qcom,system", "/dev/dma_heap/system"};
+    for (const char* heap : heaps) {
+        heap_fd_ = ::open(heap, O_RDONLY | O_CLOEXEC);
+        if (heap_fd_ >= 0) {
+            LOG_INFO(std::string("dma-buf heap: ") + heap);
+            break;
+        }
+    }
+#endif
+    if (heap_fd_ < 0) {
+        LOG_VERBOSE("No dma-buf heap available, shared buffers fall back to the memory pool");
+    }
+}
+
+DmaBufAllocator::~DmaBufAllocator() {
+#ifdef __linux__
+    if (heap_fd_ >= 0) {
+        ::close(heap_fd_);
+    }
+#endif
+}
+
+void* DmaBufAllocator::Allocate(size_t size) {
+    if (heap_fd_ < 0) {
+        return AllocateMemory(size, 64);
+    }
+#ifdef __linux__
+    const size_t mapped_size = (std::max<size_t>(size, 1) + PageSize() - 1) / PageSize() * PageSize();
+    struct dma_heap_allocation_data request = {};
+    request.len = mapped_size;
+    request.fd_flags = O_RDWR | O_CLOEXEC;
+    if (::ioctl(heap_fd_, DMA_HEAP_IOCTL_ALLOC, &request) != 0) {
+        LOG_WARNING("dma-buf allocation of " + std::to_string(mapped_size) + " bytes failed, errno " +
+                    std::to_string(errno));
+        return nullptr;
+    }
+    const int fd = static_cast<int>(request.fd);
+    void* data = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(dma_bufs_mutex);
+    dma_bufs[static_cast<const uint8_t*>(data)] = DmaBufEntry{fd, mapped_size};
+    return data;
+#else
+    return nullptr;
+#endif
+}
+
+void DmaBufAllocator::Free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (heap_fd_ < 0) {
+        FreeMemory(ptr);
+        return;
+    }
+#ifdef __linux__
+    DmaBufEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(dma_bufs_mutex);
+        auto it = dma_bufs.find(static_cast<const uint8_t*>(ptr));
+        if (it == dma_bufs.end()) {
+            return;
+        }
+        entry = it->second;
+        dma_bufs.erase(it);
+    }
+    ::munmap(ptr, entry.size);
+    ::close(entry.fd);
+#endif
+}
+
+void* DmaBufAllocator::AllocateAligned(size_t size, size_t alignment) {
+    if (alignment > PageSize() || (heap_fd_ < 0 && alignment > 64)) {
+        return nullptr;
+    }
+    return Allocate(size);
+}
+
+size_t DmaBufAllocator::GetAllocatedSize(void* ptr) const {
+    std::lock_guard<std::mutex> lock(dma_bufs_mutex);
+    auto it = dma_bufs.find(static_cast<const uint8_t*>(ptr));
+    return it != dma_bufs.end() ? it->second.size : 0;
+}
+
+bool FindDmaBufRegion(const void* data, size_t size, DmaBufRegion* region) {
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    std::lock_guard<std::mutex> lock(dma_bufs_mutex);
+    auto it = dma_bufs.upper_bound(begin);
+    if (it == dma_bufs.begin()) {
+        return false;
+    }
+    --it;
+    const uint8_t* base = it->first;
+    if (size > it->second.size || static_cast<size_t>(begin - base) > it->second.size - size) {
+        return false;
+    }
+    region->fd = it->second.fd;
+    region->base = const_cast<uint8_t*>(base);
+    region->size = it->second.size;
+    region->offset = static_cast<size_t>(begin - base);
+    return true;
+}
+
+Status SyncDmaBuf(int fd, bool begin_cpu_access, bool write) {
+#ifdef __linux__
+    struct dma_buf_sync sync = {};
+    sync.flags = (begin_cpu_access ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) |
+                 (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+    if (::ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) != 0) {
+        return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "DMA_BUF_IOCTL_SYNC failed, errno " + std::to_string(errno));
+    }
+    return Status::Ok();
+#else
+    (void)fd;
+    (void)begin_cpu_access;
+    (void)write;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "dma-buf is only available on Linux");
+#endif
+}
+
+} // namespace inferunity
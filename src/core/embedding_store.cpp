@@ -0,0 +1,246 @@
+#include "inferunity/embedding_store.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+
+constexpr int kSketchDepth = 4;
+constexpr uint8_t kMaxFrequency = 15;
+
+uint64_t MixRow(int64_t row, uint64_t seed) {
+    // splitmix64的终混函数，每组哈希用不同的种子
+    uint64_t x = static_cast<uint64_t>(row) + seed * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 一段连续行的读请求：表中[first_row, first_row + rows)读到staging的第position行开始处
+struct ReadRun {
+    int64_t first_row;
+    int64_t rows;
+    size_t position;
+};
+
+} // anonymous namespace
+
+Status TieredEmbeddingStore::Open(const std::string& path, uint64_t offset, int64_t num_rows, size_t row_bytes,
+                                  const EmbeddingStoreOptions& options,
+                                  std::unique_ptr<TieredEmbeddingStore>* store) {
+#ifdef _WIN32
+    (void)offset;
+    (void)num_rows;
+    (void)row_bytes;
+    (void)options;
+    (void)store;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Tiered embedding store is not supported: " + path);
+#else
+    if (num_rows <= 0 || row_bytes == 0 || options.cache_rows < 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid embedding table geometry");
+    }
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open embedding table: " + path);
+    }
+    std::unique_ptr<TieredEmbeddingStore> created(new TieredEmbeddingStore());
+    created->fd_ = fd;
+    created->offset_ = offset;
+    created->num_rows_ = num_rows;
+    created->row_bytes_ = row_bytes;
+    created->options_ = options;
+    const int64_t capacity = std::min(options.cache_rows, num_rows);
+    created->options_.cache_rows = capacity;
+    created->slots_.resize(static_cast<size_t>(capacity) * row_bytes);
+    created->free_slots_.reserve(static_cast<size_t>(capacity));
+    for (int64_t slot = capacity - 1; slot >= 0; --slot) {
+        created->free_slots_.push_back(slot);
+    }
+    created->index_.reserve(static_cast<size_t>(capacity));
+    // 草图宽度取不小于容量的2的幂，容量为0时仍保留最小的草图
+    size_t width = 64;
+    while (width < static_cast<size_t>(capacity)) {
+        width <<= 1;
+    }
+    created->sketch_width_ = width;
+    created->sketch_.assign(width * kSketchDepth, 0);
+    *store = std::move(created);
+    return Status::Ok();
+#endif
+}
+
+TieredEmbeddingStore::~TieredEmbeddingStore() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+void TieredEmbeddingStore::RecordAccess(int64_t row) {
+    for (int d = 0; d < kSketchDepth; ++d) {
+        uint8_t& counter = sketch_[d * sketch_width_ + (MixRow(row, d + 1) & (sketch_width_ - 1))];
+        if (counter < kMaxFrequency) {
+            ++counter;
+        }
+    }
+    // 老化：累计次数达到约10倍容量后全部减半，旧的热点逐渐让位给新的热点
+    if (++sketch_additions_ >= 10 * std::max<uint64_t>(sketch_width_, options_.cache_rows)) {
+        for (uint8_t& counter : sketch_) {
+            counter >>= 1;
+        }
+        sketch_additions_ /= 2;
+    }
+}
+
+uint32_t TieredEmbeddingStore::EstimateFrequency(int64_t row) const {
+    uint32_t frequency = kMaxFrequency;
+    for (int d = 0; d < kSketchDepth; ++d) {
+        frequency = std::min<uint32_t>(frequency,
+                                       sketch_[d * sketch_width_ + (MixRow(row, d + 1) & (sketch_width_ - 1))]);
+    }
+    return frequency;
+}
+
+void TieredEmbeddingStore::Admit(int64_t row, const uint8_t* data) {
+    if (options_.cache_rows == 0 || index_.count(row)) {
+        return;  // 不缓存，或并发的查找已经读入了这一行
+    }
+    int64_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        const int64_t victim = lru_.back().first;
+        if (EstimateFrequency(row) <= EstimateFrequency(victim)) {
+            ++stats_.rejections;
+            return;
+        }
+        slot = lru_.back().second;
+        index_.erase(victim);
+        lru_.pop_back();
+    }
+    std::memcpy(slots_.data() + static_cast<size_t>(slot) * row_bytes_, data, row_bytes_);
+    lru_.emplace_front(row, slot);
+    index_[row] = lru_.begin();
+    ++stats_.admissions;
+}
+
+Status TieredEmbeddingStore::Lookup(const int64_t* rows, int64_t count, void* output) {
+#ifdef _WIN32
+    (void)rows;
+    (void)count;
+    (void)output;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Tiered embedding store is not supported");
+#else
+    if (count <= 0) {
+        return Status::Ok();
+    }
+    for (int64_t i = 0; i < count; ++i) {
+        if (rows[i] < 0 || rows[i] >= num_rows_) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "Embedding row out of range: " + std::to_string(rows[i]));
+        }
+    }
+    
+    // 去重后按行号递增：staging的第k行对应unique[k]
+    std::vector<int64_t> unique(rows, rows + count);
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+    const size_t row_bytes = row_bytes_;
+    std::vector<uint8_t> staging(unique.size() * row_bytes);
+    
+    // 查缓存：命中的行复制到staging，未命中的相邻行号合并成读请求
+    std::vector<ReadRun> runs;
+    std::vector<size_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.lookups += static_cast<uint64_t>(count);
+        stats_.unique_rows += unique.size();
+        for (size_t k = 0; k < unique.size(); ++k) {
+            const int64_t row = unique[k];
+            RecordAccess(row);
+            auto it = index_.find(row);
+            if (it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                std::memcpy(staging.data() + k * row_bytes,
+                            slots_.data() + static_cast<size_t>(it->second->second) * row_bytes, row_bytes);
+                continue;
+            }
+            missing.push_back(k);
+            ReadRun* last = runs.empty() ? nullptr : &runs.back();
+            if (last && last->first_row + last->rows == row &&
+                static_cast<size_t>(last->rows + 1) * row_bytes <= options_.max_read_bytes) {
+                ++last->rows;
+            } else {
+                runs.push_back({row, 1, k});
+            }
+        }
+        stats_.hits += unique.size() - missing.size();
+        stats_.misses += missing.size();
+        stats_.reads += runs.size();
+        stats_.bytes_read += missing.size() * row_bytes;
+    }
+    
+    // 读盘不持锁：各段互不重叠，在线程池上并行发出，SSD的队列深度随之提高
+    std::atomic<int> failed_errno{0};
+    ThreadPool::ParallelFor(0, static_cast<int64_t>(runs.size()), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end && failed_errno.load(std::memory_order_relaxed) == 0; ++r) {
+            const ReadRun& run = runs[r];
+            uint8_t* cursor = staging.data() + run.position * row_bytes;
+            size_t remaining = static_cast<size_t>(run.rows) * row_bytes;
+            off_t position = static_cast<off_t>(offset_ + static_cast<uint64_t>(run.first_row) * row_bytes);
+            while (remaining > 0) {
+                const ssize_t n = ::pread(fd_, cursor, remaining, position);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    failed_errno.store(n == 0 ? EIO : errno, std::memory_order_relaxed);
+                    break;
+                }
+                cursor += n;
+                position += n;
+                remaining -= static_cast<size_t>(n);
+            }
+        }
+    });
+    if (failed_errno.load() != 0) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                             std::string("Embedding table read failed: ") + std::strerror(failed_errno.load()));
+    }
+    
+    if (!missing.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t k : missing) {
+            Admit(unique[k], staging.data() + k * row_bytes);
+        }
+        stats_.cached_rows = static_cast<int64_t>(index_.size());
+    }
+    
+    uint8_t* out = static_cast<uint8_t*>(output);
+    for (int64_t i = 0; i < count; ++i) {
+        const size_t k = static_cast<size_t>(std::lower_bound(unique.begin(), unique.end(), rows[i]) - unique.begin());
+        std::memcpy(out + static_cast<size_t>(i) * row_bytes, staging.data() + k * row_bytes, row_bytes);
+    }
+    return Status::Ok();
+#endif
+}
+
+EmbeddingStoreStats TieredEmbeddingStore::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EmbeddingStoreStats stats = stats_;
+    stats.cached_rows = static_cast<int64_t>(index_.size());
+    return stats;
+}
+
+} // namespace inferunity
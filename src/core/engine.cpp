@@ -2,30 +2,218 @@
 #include "inferunity/runtime.h"
 #include "inferunity/optimizer.h"
 #include "inferunity/backend.h"
+#include "inferunity/collectives.h"
 #include "inferunity/tensor.h"
 #include "inferunity/logger.h"
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/memory.h"
+#include "inferunity/model_format.h"
+#include "inferunity/model_repository.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/numa.h"
+#include "inferunity/shape_inference.h"
+#include "inferunity/tracing.h"
+#include "inferunity/metrics.h"
 #include "frontend/onnx_parser.h"
+#include "core/hash_utils.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
 #include <thread>
 #include <functional>
 
-// 前向声明形状推断函数
 namespace inferunity {
-    Status InferShapes(Graph* graph);
+
+// 一种具体输入形状的内存规划：串行路径每次运行前把views绑定到Value上（arena与views在串行路径
+// 第一次使用时创建，由run_mutex_保护），并发路径的执行状态按memory_plan各自分配arena，
+// 空闲时放回这个计划的状态池
+struct ShapeSpecializedPlan {
+    ShapeSymbolBindings symbols;
+    MemoryPlan memory_plan;
+    std::shared_ptr<MemoryArena> arena;
+    std::vector<std::pair<Value*, std::shared_ptr<Tensor>>> views;
+    std::vector<std::unique_ptr<ExecutionState>> idle_states;  // 由state_pool_mutex_保护
+    uint64_t last_used = 0;
+};
+
+// 只计算部分输出的计划：节点是完整计划中所需输出的祖先，顺序不变，因此沿用完整计划的内存规划
+struct PrunedExecutionPlan {
+    std::unique_ptr<ExecutionPlan> plan;
+    std::vector<std::unique_ptr<ExecutionState>> idle_states;  // 由state_pool_mutex_保护
+};
+
+namespace {
+
+// 动态维度按1创建，供CreateInputTensor与Profile使用
+Shape ConcreteInputShape(const Shape& shape) {
+    std::vector<int64_t> dims = shape.dims;
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (dims[i] < 0 || (i < shape.is_dynamic.size() && shape.is_dynamic[i])) {
+            dims[i] = 1;
+        }
+    }
+    return Shape(dims);
 }
 
-namespace inferunity {
+// 加载阶段计时：作用域结束时把耗时（毫秒）追加到timings
+class LoadStageTimer {
+public:
+    LoadStageTimer(std::vector<std::pair<std::string, double>>* timings, std::string stage)
+        : timings_(timings), stage_(std::move(stage)), start_ns_(MetricNowNs()) {}
+    ~LoadStageTimer() {
+        timings_->emplace_back(std::move(stage_), static_cast<double>(MetricNowNs() - start_ns_) / 1e6);
+    }
+    
+    LoadStageTimer(const LoadStageTimer&) = delete;
+    LoadStageTimer& operator=(const LoadStageTimer&) = delete;
+
+private:
+    std::vector<std::pair<std::string, double>>* timings_;
+    std::string stage_;
+    int64_t start_ns_;
+};
+
+// 串行路径把调用方的输入以非自有指针绑定到图输入Value上；
+// 运行结束后恢复加载时的张量，避免Value上留下调用方可能已经释放的指针
+class GraphInputGuard {
+public:
+    explicit GraphInputGuard(Graph* graph) : graph_(graph) {
+        for (Value* input : graph_->GetInputs()) {
+            saved_.push_back(input->GetTensor());
+        }
+    }
+    ~GraphInputGuard() {
+        const auto& inputs = graph_->GetInputs();
+        for (size_t i = 0; i < inputs.size() && i < saved_.size(); ++i) {
+            inputs[i]->SetTensor(saved_[i]);
+        }
+    }
+
+private:
+    Graph* graph_;
+    std::vector<std::shared_ptr<Tensor>> saved_;
+};
+
+// 异步运行结束时（包括callback抛出异常）归还在途计数
+class AsyncRunGuard {
+public:
+    explicit AsyncRunGuard(std::function<void()> done) : done_(std::move(done)) {}
+    ~AsyncRunGuard() { done_(); }
+
+private:
+    std::function<void()> done_;
+};
+
+// 绑定了NUMA节点的会话是否同时绑定调用线程的CPU：线程池工作线程（RunAsync）已由所在的组绑定
+bool BindsCallerThread(int numa_node) {
+    return numa_node >= 0 && !ThreadPool::IsWorkerThread();
+}
+
+// 为串行路径分配计划的arena并建立各中间值的视图
+Status CreateSpecializedViews(ShapeSpecializedPlan* plan, const std::shared_ptr<MemoryAccount>& account,
+                              HugePagePolicy huge_pages) {
+    auto arena = MemoryArena::Create(plan->memory_plan.arena_size, plan->memory_plan.alignment, account,
+                                     huge_pages);
+    if (!arena) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate memory arena");
+    }
+    uint8_t* base = static_cast<uint8_t*>(arena->GetBase());
+    for (const auto& entry : plan->memory_plan.entries) {
+        // 删除器捕获arena：视图存活期间arena不会被释放
+        plan->views.emplace_back(entry.value, std::shared_ptr<Tensor>(
+            new Tensor(entry.shape, entry.dtype, base + entry.offset, entry.layout, DeviceType::CPU),
+            [arena](Tensor* tensor) { delete tensor; }));
+    }
+    plan->arena = arena;
+    return Status::Ok();
+}
+
+// 张量并行与流水线并行的内部会话所在的设备：给出的列表，为空时从device_id起连续编号
+Status ResolveParallelDeviceIds(const std::vector<int>& given, int first, int count, const char* option,
+                                std::vector<int>* device_ids) {
+    *device_ids = given;
+    if (device_ids->empty()) {
+        for (int i = 0; i < count; ++i) {
+            device_ids->push_back(first + i);
+        }
+    }
+    if (static_cast<int>(device_ids->size()) != count) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, std::string(option) + " must have one entry per device");
+    }
+    return Status::Ok();
+}
+
+// 通信组的设备类型：第一个非CPU提供者的设备，没有时为CPU
+DeviceType ParallelDeviceType(const std::vector<std::shared_ptr<ExecutionProvider>>& providers) {
+    for (const auto& provider : providers) {
+        if (provider->GetDeviceType() != DeviceType::CPU) {
+            return provider->GetDeviceType();
+        }
+    }
+    return DeviceType::CPU;
+}
+
+// 完整的权重只留在内部会话里，协调会话的图只用来描述输入输出
+void StripConstantData(Graph* graph) {
+    const auto& graph_inputs = graph->GetInputs();
+    for (const auto& value : graph->GetValues()) {
+        auto tensor = value->GetTensor();
+        if (!value->GetProducer() && tensor && tensor->GetData() &&
+            std::find(graph_inputs.begin(), graph_inputs.end(), value.get()) == graph_inputs.end()) {
+            value->SetTensor(std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr));
+        }
+    }
+}
+
+} // anonymous namespace
 
 InferenceSession::InferenceSession(const SessionOptions& options)
-    : options_(options), initialized_(false) {
+    : options_(options), memory_account_(std::make_shared<MemoryAccount>()), initialized_(false) {
     optimizer_ = std::make_unique<Optimizer>();
     execution_engine_ = std::make_unique<ExecutionEngine>();
+    
+    static std::atomic<uint64_t> next_session_id{0};
+    session_id_ = options_.session_id.empty()
+        ? "session" + std::to_string(++next_session_id) : options_.session_id;
+    MetricsRegistry& registry = MetricsRegistry::Instance();
+    const MetricLabels labels = {{"session", session_id_}};
+    run_latency_metric_ = registry.GetHistogram("inferunity_session_run_latency_us", LatencyBucketsUs(), labels,
+                                                "End-to-end latency of InferenceSession::Run");
+    async_queue_wait_metric_ = registry.GetHistogram("inferunity_session_async_queue_wait_us", LatencyBucketsUs(),
+                                                     labels, "Time a RunAsync request waits for a worker");
+    arena_high_water_metric_ = registry.GetGauge("inferunity_session_arena_high_water_bytes", labels,
+                                                 "Largest activation arena planned by the session");
+    result_cache_hits_metric_ = registry.GetCounter("inferunity_session_result_cache_hits_total", labels,
+                                                    "Runs answered from the result cache");
+    result_cache_misses_metric_ = registry.GetCounter("inferunity_session_result_cache_misses_total", labels,
+                                                      "Cacheable runs that missed the result cache");
+    async_queue_depth_metric_ = registry.GetGauge("inferunity_session_async_queue_depth", labels,
+                                                  "RunAsync requests accepted but not yet started");
+    admission_rejected_metric_ = registry.GetCounter("inferunity_session_admission_rejected_total", labels,
+                                                     "RunAsync requests rejected by admission control");
+    admission_shed_metric_ = registry.GetCounter("inferunity_session_admission_shed_total", labels,
+                                                 "Queued requests dropped before running to meet deadlines");
 }
 
-InferenceSession::~InferenceSession() = default;
+InferenceSession::~InferenceSession() {
+    // 线程池任务持有this，须在成员销毁前结束
+    WaitForAsyncRuns();
+    run_latency_metric_.reset();
+    async_queue_wait_metric_.reset();
+    arena_high_water_metric_.reset();
+    result_cache_hits_metric_.reset();
+    result_cache_misses_metric_.reset();
+    async_queue_depth_metric_.reset();
+    admission_rejected_metric_.reset();
+    admission_shed_metric_.reset();
+    MetricsRegistry::Instance().Unregister("session", session_id_);
+}
 
 std::unique_ptr<InferenceSession> InferenceSession::Create(const SessionOptions& options) {
     auto session = std::unique_ptr<InferenceSession>(new InferenceSession(options));
@@ -37,16 +225,57 @@ std::unique_ptr<InferenceSession> InferenceSession::Create(const SessionOptions&
 }
 
 Status InferenceSession::Initialize() {
+    if (options_.numa_node >= static_cast<int>(GetNumNumaNodes())) {
+        LOG_WARNING("NUMA node " + std::to_string(options_.numa_node) + " not present; session is not bound");
+        options_.numa_node = -1;
+    }
+    // 追踪是进程级的，已由其他会话或调用方开启时沿用
+    if (options_.enable_profiling && !Tracer::Instance().IsEnabled()) {
+        Tracer::Instance().Start(options_.profiling_events_per_thread);
+    }
+    result_cache_.reset();
+    if (options_.result_cache_bytes > 0) {
+        ResultCacheOptions cache_options;
+        cache_options.capacity_bytes = options_.result_cache_bytes;
+        cache_options.ttl_ms = options_.result_cache_ttl_ms;
+        result_cache_ = std::make_unique<ResultCache>(cache_options);
+    }
+    admission_.reset();
+    if (options_.enable_admission_control) {
+        admission_ = std::make_unique<AdmissionController>(options_.admission);
+    }
+    // 显式给出的池优先，其次是会话私有的池；都没有时留空，使用全局线程池
+    intra_op_pool_ = options_.intra_op_thread_pool;
+    inter_op_pool_ = options_.inter_op_thread_pool;
+    if (options_.use_per_session_threads) {
+        ThreadPoolOptions pool_options;
+        if (!intra_op_pool_) {
+            pool_options.num_threads = options_.intra_op_pool_size;
+            pool_options.performance_cores_only = options_.performance_cores_only;
+            intra_op_pool_ = ThreadPoolInstance::Create(pool_options);
+        }
+        if (!inter_op_pool_) {
+            pool_options.num_threads = options_.inter_op_pool_size;
+            pool_options.performance_cores_only = false;
+            inter_op_pool_ = ThreadPoolInstance::Create(pool_options);
+        }
+    } else if (options_.performance_cores_only && !intra_op_pool_ && GetCpuCoreTopology().hybrid) {
+        // 全局线程池不能按会话限制核，改用私有的性能核池
+        ThreadPoolOptions pool_options;
+        pool_options.num_threads = options_.intra_op_pool_size;
+        pool_options.performance_cores_only = true;
+        intra_op_pool_ = ThreadPoolInstance::Create(pool_options);
+    }
+    
     // 确保所有执行提供者被注册
     InitializeExecutionProviders(); // 显式调用注册函数
     
     // 注册默认优化Pass (参考TVM的Pass注册机制)
     optimizer_->RegisterPass(std::make_unique<ConstantFoldingPass>());
+    optimizer_->RegisterPass(std::make_unique<TransposeOptimizationPass>());
+    optimizer_->RegisterPass(std::make_unique<IdentityEliminationPass>());
+    optimizer_->RegisterPass(std::make_unique<CommonSubexpressionEliminationPass>());
     optimizer_->RegisterPass(std::make_unique<DeadCodeEliminationPass>());
-    if (options_.enable_operator_fusion) {
-        optimizer_->RegisterPass(std::make_unique<OperatorFusionPass>());
-    }
-    optimizer_->RegisterPass(std::make_unique<MemoryLayoutOptimizationPass>());
     
     // 准备执行提供者 (参考ONNX Runtime的提供者初始化)
     Status status = PrepareExecutionProviders();
@@ -54,6 +283,62 @@ Status InferenceSession::Initialize() {
         return status;
     }
     
+    // 认领子图的编译型提供者只认标准ONNX算子且自己做层融合，融合出的内部算子会挡住它的认领
+    bool claiming_delegate = false;
+    for (const auto& provider : execution_providers_) {
+        claiming_delegate = claiming_delegate || (options_.enable_subgraph_delegation &&
+                                                  provider->SupportsSubgraphCompilation() &&
+                                                  provider->ClaimsSubgraphs());
+    }
+    if (options_.enable_operator_fusion) {
+        // BN先折叠进Conv权重，剩下的Conv+ReLU再由融合Pass合并
+        optimizer_->RegisterPass(std::make_unique<ConvBNFoldingPass>());
+        if (!claiming_delegate) {
+            // 同输入的兄弟MatMul/Conv先合并，合并结果的bias/ReLU再参与纵向融合
+            optimizer_->RegisterPass(std::make_unique<HorizontalFusionPass>());
+            optimizer_->RegisterPass(std::make_unique<OperatorFusionPass>());
+        }
+    }
+    
+    // 分块通道布局的算子只有CPU实现，只在全部提供者都是CPU时改写布局
+    bool cpu_only = true;
+    for (const auto& provider : execution_providers_) {
+        cpu_only = cpu_only && provider->GetDeviceType() == DeviceType::CPU;
+    }
+    // 深度优先分块先认领大特征图上的卷积链，其余卷积再改为分块通道布局
+    if (options_.depth_first_tile_bytes > 0 && cpu_only && options_.enable_operator_fusion && !claiming_delegate) {
+        optimizer_->RegisterPass(std::make_unique<DepthFirstTilingPass>(options_.depth_first_tile_bytes));
+    }
+    // 认领子图的提供者（如oneDNN）自己选择卷积的分块布局，改写出的NCHWc算子会挡住它的认领
+    if (options_.enable_blocked_layout && cpu_only && !claiming_delegate &&
+        options_.graph_optimization_level == SessionOptions::GraphOptimizationLevel::ALL) {
+        optimizer_->RegisterPass(std::make_unique<MemoryLayoutOptimizationPass>());
+    }
+    // SparseMatMul目前只有CPU实现
+    if (cpu_only && options_.sparse_weight_density_threshold > 0.0f) {
+        optimizer_->RegisterPass(std::make_unique<SparseWeightPass>(options_.sparse_weight_density_threshold));
+    }
+    // MatMulNBits目前只有CPU实现
+    if (cpu_only && options_.weight_only_quantization_bits != 0) {
+        optimizer_->RegisterPass(std::make_unique<WeightOnlyQuantizationPass>(
+            options_.weight_only_quantization_bits, options_.weight_only_quantization_block_size));
+    }
+    // 半精度权重目前只有CPU的MatMul/FusedMatMulAdd能直接读取
+    if (cpu_only && (options_.mixed_precision_weight_dtype == DataType::FLOAT16 ||
+                     options_.mixed_precision_weight_dtype == DataType::BFLOAT16)) {
+        optimizer_->RegisterPass(std::make_unique<MixedPrecisionPass>(
+            options_.mixed_precision_weight_dtype, options_.allow_bf16_compute));
+    }
+    // 执行顺序在图结构确定之后调度
+    if (options_.enable_memory_aware_scheduling) {
+        optimizer_->RegisterPass(std::make_unique<MemoryAwareSchedulingPass>());
+    }
+    // 权重布局按最终的执行顺序与最终的权重确定
+    if (cpu_only && options_.enable_weight_reordering && options_.weight_streaming_budget == 0) {
+        optimizer_->RegisterPass(std::make_unique<CacheOptimizationPass>());
+    }
+    optimizer_->RegisterPass(std::make_unique<MemoryAlignmentPass>());
+    
     initialized_ = true;
     return Status::Ok();
 }
@@ -85,6 +370,10 @@ Status InferenceSession::PrepareExecutionProviders() {
     for (const std::string& name : provider_names) {
         auto provider = ExecutionProviderRegistry::Instance().Create(name);
         if (provider && provider->IsAvailable()) {
+            Status status = provider->ConfigureSession(options_);
+            if (!status.IsOk()) {
+                return status;
+            }
             // 将unique_ptr转换为shared_ptr
             execution_providers_.push_back(std::shared_ptr<ExecutionProvider>(provider.release()));
         }
@@ -100,25 +389,41 @@ Status InferenceSession::PrepareExecutionProviders() {
 }
 
 Status InferenceSession::LoadModel(const std::string& filepath) {
+    TraceScope trace(TraceCategory::SESSION, "LoadModel", filepath.c_str());
     // 根据文件扩展名选择解析器
     // 参考ONNX Runtime的模型加载机制
     std::string ext = filepath.substr(filepath.find_last_of(".") + 1);
     
     if (ext == "onnx") {
         // 使用ONNX解析器
-        frontend::ONNXParser parser;
-        Status status = parser.LoadFromFile(filepath);
-        if (!status.IsOk()) {
-            return status;
+        std::vector<std::pair<std::string, double>> parse_timing;
+        std::unique_ptr<Graph> graph;
+        {
+            LoadStageTimer timer(&parse_timing, "Parse");
+            frontend::ONNXParser parser;
+            Status status = parser.LoadFromFile(filepath);
+            if (!status.IsOk()) {
+                return status;
+            }
+            status = parser.ConvertToGraph(graph);
+            if (!status.IsOk()) {
+                return status;
+            }
         }
-        
+        return LoadParsedGraph(std::move(graph), parse_timing);
+    }
+    // 原生紧凑格式（inferunity_convert生成）：按魔数识别，加载只是映射文件与偏移修正
+    if (IsCompactModelFile(filepath)) {
+        std::vector<std::pair<std::string, double>> parse_timing;
         std::unique_ptr<Graph> graph;
-        status = parser.ConvertToGraph(graph);
-        if (!status.IsOk()) {
-            return status;
+        {
+            LoadStageTimer timer(&parse_timing, "Parse");
+            Status status = LoadCompactModel(filepath, graph);
+            if (!status.IsOk()) {
+                return status;
+            }
         }
-        
-        return LoadModelFromGraph(std::move(graph));
+        return LoadParsedGraph(std::move(graph), parse_timing);
     }
     // 其他格式支持（待实现）
     // else if (ext == "pb") {
@@ -140,143 +445,2048 @@ Status InferenceSession::LoadModelFromMemory(const void* data, size_t size) {
                            "Invalid data or size");
     }
     
-    // 尝试检测模型格式（简化实现，实际应该更智能）
-    // 检查ONNX格式的magic number（protobuf格式）
-    // ONNX模型通常以protobuf格式存储，可以通过解析来判断
-    
-    // 首先尝试ONNX格式
-    frontend::ONNXParser parser;
-    Status status = parser.LoadFromMemory(data, size);
-    if (status.IsOk()) {
-        std::unique_ptr<Graph> graph;
-        status = parser.ConvertToGraph(graph);
-        if (status.IsOk()) {
-            return LoadModelFromGraph(std::move(graph));
+    // 原生紧凑格式：按魔数识别；没有文件映射的平台（WebAssembly）由宿主fetch模型后经这里加载
+    if (IsCompactModelBuffer(data, size)) {
+        std::vector<std::pair<std::string, double>> parse_timing;
+        std::unique_ptr<Graph> graph;
+        {
+            LoadStageTimer timer(&parse_timing, "Parse");
+            Status status = LoadCompactModelFromMemory(data, size, graph);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return LoadParsedGraph(std::move(graph), parse_timing);
+    }
+    
+    // 尝试检测模型格式（简化实现，实际应该更智能）
+    // 检查ONNX格式的magic number（protobuf格式）
+    // ONNX模型通常以protobuf格式存储，可以通过解析来判断
+    
+    // 首先尝试ONNX格式
+    std::vector<std::pair<std::string, double>> parse_timing;
+    std::unique_ptr<Graph> graph;
+    Status status;
+    {
+        LoadStageTimer timer(&parse_timing, "Parse");
+        frontend::ONNXParser parser;
+        status = parser.LoadFromMemory(data, size);
+        if (status.IsOk()) {
+            status = parser.ConvertToGraph(graph);
+        }
+    }
+    if (status.IsOk()) {
+        return LoadParsedGraph(std::move(graph), parse_timing);
+    }
+    
+    // 其他格式支持（待实现）
+    // TensorFlow Lite (.tflite): 需要实现FlatBuffer解析器
+    // TensorFlow SavedModel (.pb): 需要实现protobuf解析器
+    // 目前只支持ONNX格式
+    
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                       "Unsupported model format in memory. Only ONNX and compact formats are supported.");
+}
+
+Status InferenceSession::LoadParsedGraph(std::unique_ptr<Graph> graph,
+                                         const std::vector<std::pair<std::string, double>>& parse_timing) {
+    Status status = LoadModelFromGraph(std::move(graph));
+    load_stage_timings_.insert(load_stage_timings_.begin(), parse_timing.begin(), parse_timing.end());
+    return status;
+}
+
+Status InferenceSession::LoadModelFromSharedMemory(const std::string& name) {
+    TraceScope trace(TraceCategory::SESSION, "LoadModelFromSharedMemory", name.c_str());
+    std::unique_ptr<Graph> graph;
+    Status status = LoadCompactModelFromSharedMemory(name, graph);
+    if (!status.IsOk()) {
+        return status;
+    }
+    graph_preoptimized_ = true;
+    return LoadModelFromGraph(std::move(graph));
+}
+
+Status InferenceSession::LoadModelFromGraph(std::unique_ptr<Graph> graph) {
+    // 优化Pass改写的权重、预打包权重与arena都在绑定的节点上分配
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    {
+        std::lock_guard<std::mutex> lock(state_pool_mutex_);
+        idle_states_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(specialized_mutex_);
+        specialized_plans_.clear();
+        symbolic_tensors_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        pipeline_.reset();
+    }
+    state_run_ = false;
+    concurrent_run_ = false;
+    if (capture_provider_) {
+        capture_provider_->ResetGraph();
+        capture_provider_ = nullptr;
+    }
+    capture_inputs_.clear();
+    weight_prefetcher_.reset();
+    weight_streaming_.reset();
+    execution_plan_.reset();
+    if (result_cache_) {
+        result_cache_->Clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(pruned_mutex_);
+        pruned_plans_.clear();
+    }
+    memory_plan_ = MemoryPlan();
+    memory_arena_.reset();
+    kv_cache_.reset();
+    node_providers_.clear();
+    tensor_parallel_ranks_.clear();
+    tensor_parallel_group_.reset();
+    pipeline_parallel_.reset();
+    warm_.store(false, std::memory_order_release);
+    load_stage_timings_.clear();
+    graph_ = std::move(graph);
+    Status status = LoadAndOptimizeGraph();
+    if (status.IsOk() && !load_stage_timings_.empty()) {
+        std::string summary;
+        for (const auto& stage : load_stage_timings_) {
+            summary += (summary.empty() ? "" : ", ") + stage.first + " " + std::to_string(stage.second) + " ms";
+        }
+        LOG_INFO("Load stages: " + summary);
+    }
+    return status;
+}
+
+Status InferenceSession::LoadAndOptimizeGraph() {
+    if (!graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Graph is null");
+    }
+    TraceScope trace(TraceCategory::SESSION, "LoadAndOptimizeGraph");
+    
+    // 共享内存发布的模型已经优化过，与缓存命中一样跳过优化Pass
+    const bool preoptimized = graph_preoptimized_;
+    graph_preoptimized_ = false;
+    
+    // 验证图
+    Status status;
+    {
+        LoadStageTimer timer(&load_stage_timings_, "Validate");
+        status = graph_->Validate();
+    }
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 内存估计：按给定的输入形状做形状推断与内存规划
+    if (memory_estimate_ && !estimate_input_shapes_.empty()) {
+        const std::vector<Value*>& inputs = graph_->GetInputs();
+        if (inputs.size() != estimate_input_shapes_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Expected " + std::to_string(inputs.size()) + " input shapes, got " +
+                               std::to_string(estimate_input_shapes_.size()));
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            inputs[i]->SetTensor(std::make_shared<Tensor>(estimate_input_shapes_[i], inputs[i]->GetDataType(), nullptr));
+        }
+    }
+    
+    // 图像预处理在优化之前插入：分块布局Pass可以让它直接写出NCHWc，插入后的图参与缓存键的哈希
+    if (options_.enable_image_preprocess && !preoptimized) {
+        status = PrependImagePreprocess(graph_.get(), options_.image_preprocess,
+                                        options_.image_preprocess_input_name);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 优化图缓存：命中时换成缓存里已优化的图（权重是缓存文件的映射视图），跳过优化Pass
+    std::string cache_path;
+    bool cache_hit = preoptimized;
+    if (!preoptimized && !options_.optimized_model_cache_dir.empty()) {
+        cache_path = GetOptimizedModelCachePath();
+        std::unique_ptr<Graph> cached;
+        if (IsCompactModelFile(cache_path) && LoadCompactModel(cache_path, cached).IsOk()) {
+            graph_ = std::move(cached);
+            cache_hit = true;
+            LOG_INFO("Optimized model cache hit: " + cache_path);
+        }
+    }
+    
+    // 形状推断（参考ONNX Runtime的ShapeInference）；缓存只保存权重与图输入的形状，命中时也要执行
+    {
+        TraceScope infer_trace(TraceCategory::SESSION, "InferShapes");
+        LoadStageTimer timer(&load_stage_timings_, "InferShapes");
+        status = InferShapes(graph_.get());
+    }
+    if (!status.IsOk()) {
+        // 形状推断失败不影响加载，只记录警告
+        LOG_WARNING("Shape inference failed: " + status.Message());
+    }
+    
+    // 张量并行：各rank的会话各自完成量化、优化与之后的步骤
+    if (options_.tensor_parallel_size > 1 && options_.pipeline_parallel_size > 1) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Tensor parallelism cannot be combined with pipeline parallelism");
+    }
+    if (options_.tensor_parallel_size > 1) {
+        return PrepareTensorParallel();
+    }
+    
+    // 量化在其他优化之前：常量折叠会把权重的DequantizeLinear折回浮点
+    if (!cache_hit && options_.enable_quantization) {
+        LoadStageTimer timer(&load_stage_timings_, "Quantize");
+        status = QuantizeModel();
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 优化图 (参考ONNX Runtime的图优化级别)
+    if (!cache_hit && options_.graph_optimization_level != SessionOptions::GraphOptimizationLevel::NONE) {
+        TraceScope optimize_trace(TraceCategory::OPTIMIZER, "OptimizeGraph");
+        LoadStageTimer timer(&load_stage_timings_, "Optimize");
+        status = optimizer_->Optimize(graph_.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    // 先写临时文件再改名，并发启动的会话不会读到写了一半的缓存
+    if (!cache_path.empty() && !cache_hit) {
+        const std::string temp_path = cache_path + ".tmp" + std::to_string(reinterpret_cast<uintptr_t>(this));
+        status = SaveCompactModel(*graph_, temp_path);
+        if (status.IsOk() && std::rename(temp_path.c_str(), cache_path.c_str()) == 0) {
+            LOG_INFO("Optimized model cached: " + cache_path);
+        } else {
+            std::remove(temp_path.c_str());
+            LOG_WARNING("Optimized model not cached: " + (status.IsOk() ? cache_path : status.Message()));
+        }
+    }
+    // 发布在共享权重与分区之前：工作进程拿到的是与缓存相同的、与设备无关的优化图
+    if (!options_.shared_model_name.empty() && !preoptimized) {
+        status = PublishCompactModel(*graph_, options_.shared_model_name);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 流水线并行：在优化后的图上按代价切分阶段，各阶段的会话完成之后的步骤
+    if (options_.pipeline_parallel_size > 1) {
+        return PreparePipelineParallel();
+    }
+    
+    // 跨会话共享权重：优化Pass已经改写完权重，之后的分区、预打包与执行都读取共享副本
+    if (options_.shared_weights) {
+        status = options_.shared_weights->Deduplicate(
+            graph_.get(), options_.numa_replicate_weights ? options_.numa_node : -1);
+        if (!status.IsOk()) {
+            return status;
+        }
+    } else if (options_.numa_replicate_weights && options_.numa_node >= 0) {
+        ReplicateWeightsToNumaNode();
+    }
+    if (options_.huge_page_policy != HugePagePolicy::NONE) {
+        PlaceWeightsOnHugePages();
+    }
+    
+    // KV cache改写依赖算子融合得到的FusedAttention
+    if (options_.enable_kv_cache) {
+        status = PrepareKVCache();
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    // 采样头不进入优化图缓存与共享内存中的图，不同的采样参数共用同一份缓存
+    if (options_.enable_sampling_head) {
+        status = AppendSamplingHead(graph_.get(), options_.sampling, options_.sampling_logits_name);
+        if (!status.IsOk()) {
+            return status;
+        }
+        status = InferShapes(graph_.get());
+        if (!status.IsOk()) {
+            LOG_WARNING("Shape inference after sampling head failed: " + status.Message());
+        }
+    }
+    
+    // lora_target属性不进入优化图缓存，分区与编译节点时随节点属性交给算子
+    if (options_.enable_lora) {
+        PrepareLoraTargets();
+    }
+    
+    // 跨设备分区会插入拷贝节点，放在内存规划之前
+    {
+        LoadStageTimer timer(&load_stage_timings_, "PartitionGraph");
+        status = PartitionGraph();
+    }
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 静态内存规划（需要形状推断的结果，放在图优化之后）；内存估计时总是规划，以得到arena或逐张量分配的大小
+    if (options_.enable_memory_planning || memory_estimate_) {
+        {
+            LoadStageTimer timer(&load_stage_timings_, "PlanMemory");
+            status = PlanSessionMemory();
+        }
+        if (!status.IsOk() && options_.activation_memory_budget > 0) {
+            return status;
+        }
+        if (!status.IsOk()) {
+            LOG_WARNING("Memory planning failed: " + status.Message());
+        }
+    }
+    if (memory_estimate_) {
+        FinishMemoryEstimate();
+        return Status::Ok();
+    }
+    
+    // 图输入含符号维度时，静态规划只覆盖形状确定的张量；记录各中间值的符号形状，
+    // 运行时按输入形状特化（见GetShapeSpecializedPlan）
+    if (options_.enable_memory_planning && options_.max_shape_specialized_plans > 0 &&
+        HasSymbolicInputs(*graph_)) {
+        for (const auto& value : graph_->GetValues()) {
+            auto tensor = value->GetTensor();
+            if (value->GetProducer() && tensor) {
+                symbolic_tensors_.emplace_back(value.get(), std::make_shared<Tensor>(
+                    tensor->GetShape(), tensor->GetDataType(), nullptr, tensor->GetLayout(), tensor->GetDeviceType()));
+            }
+        }
+    }
+    
+    // 分配执行提供者 (参考ONNX Runtime的节点分配)；图分区已经给出分配时沿用分区的结果
+    if (node_providers_.empty()) {
+        std::vector<ExecutionProvider*> provider_ptrs;
+        for (const auto& provider : execution_providers_) {
+            provider_ptrs.push_back(provider.get());
+        }
+        status = ExecutionProviderSelector::AssignProviders(graph_.get(), provider_ptrs);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 准备执行（编译节点时的kernel调优使用持久化的调优缓存）
+    std::string tuning_cache_path = options_.kernel_tuning_cache_path;
+    if (tuning_cache_path.empty() && !options_.optimized_model_cache_dir.empty()) {
+        tuning_cache_path = options_.optimized_model_cache_dir + "/kernel_tuning.cache";
+    }
+    if (!tuning_cache_path.empty()) {
+        status = GetKernelTuningCache().SetPath(tuning_cache_path);
+        if (!status.IsOk()) {
+            LOG_WARNING("Kernel tuning cache not loaded: " + status.Message());
+        }
+    }
+    for (const auto& provider : execution_providers_) {
+        const std::string provider_name = provider->GetName();
+        TraceScope prepare_trace(TraceCategory::SESSION, "PrepareExecution", provider_name.c_str());
+        LoadStageTimer timer(&load_stage_timings_, "PrepareExecution:" + provider_name);
+        status = provider->PrepareExecution(graph_.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 编译执行计划：Run时不再做拓扑排序和提供者选择
+    {
+        LoadStageTimer timer(&load_stage_timings_, "BuildExecutionPlan");
+        status = BuildExecutionPlan();
+    }
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (options_.prefetch_weights && !weight_streaming_) {
+        PrefetchWeights();
+    }
+    if (options_.warmup_on_load) {
+        LoadStageTimer timer(&load_stage_timings_, "Warmup");
+        return Warmup();
+    }
+    return Status::Ok();
+}
+
+Status InferenceSession::PrepareTensorParallel() {
+    TraceScope trace(TraceCategory::SESSION, "PrepareTensorParallel");
+    const int world_size = options_.tensor_parallel_size;
+    std::vector<int> device_ids;
+    Status status = ResolveParallelDeviceIds(options_.tensor_parallel_device_ids, options_.device_id, world_size,
+                                             "tensor_parallel_device_ids", &device_ids);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 先折叠常量子图：导出模型里由Shape算子计算的Reshape目标形状成为常量，分片才能沿Reshape传播
+    if (options_.graph_optimization_level != SessionOptions::GraphOptimizationLevel::NONE) {
+        status = ConstantFoldingPass().Run(graph_.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+        status = InferShapes(graph_.get());
+        if (!status.IsOk()) {
+            LOG_WARNING("Shape inference failed: " + status.Message());
+        }
+    }
+    
+    tensor_parallel_group_ = CollectiveGroup::Create(ParallelDeviceType(execution_providers_), device_ids);
+    if (!tensor_parallel_group_) {
+        return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to create the collective group");
+    }
+    for (int r = 0; r < world_size; ++r) {
+        auto shard = std::make_unique<Graph>(graph_->Clone());
+        {
+            TraceScope shard_trace(TraceCategory::OPTIMIZER, "TensorParallelSharding");
+            status = TensorParallelShardingPass(world_size, r, tensor_parallel_group_->GetId()).Run(shard.get());
+        }
+        if (!status.IsOk()) {
+            return status;
+        }
+        SessionOptions rank_options = options_;
+        rank_options.tensor_parallel_size = 1;
+        rank_options.tensor_parallel_device_ids.clear();
+        rank_options.device_id = device_ids[r];
+        rank_options.session_id = session_id_ + "_tp" + std::to_string(r);
+        auto session = Create(rank_options);
+        if (!session) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Failed to create the session of tensor-parallel rank " + std::to_string(r));
+        }
+        status = session->LoadModelFromGraph(std::move(shard));
+        if (!status.IsOk()) {
+            return status;
+        }
+        tensor_parallel_ranks_.push_back(std::move(session));
+    }
+    
+    // 未切分的常量与各rank共享
+    StripConstantData(graph_.get());
+    return Status::Ok();
+}
+
+Status InferenceSession::PreparePipelineParallel() {
+    TraceScope trace(TraceCategory::SESSION, "PreparePipelineParallel");
+    const int num_stages = options_.pipeline_parallel_size;
+    if (options_.enable_kv_cache || options_.enable_sampling_head || options_.enable_lora) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Pipeline parallelism does not support the KV cache, the sampling head or LoRA");
+    }
+    std::vector<int> device_ids;
+    Status status = ResolveParallelDeviceIds(options_.pipeline_parallel_device_ids, options_.device_id, num_stages,
+                                             "pipeline_parallel_device_ids", &device_ids);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 阶段按各节点在主设备上的预计耗时平衡
+    const DeviceType device_type = ParallelDeviceType(execution_providers_);
+    const ExecutionProvider* provider = nullptr;
+    for (const auto& candidate : execution_providers_) {
+        if (candidate->GetDeviceType() == device_type) {
+            provider = candidate.get();
+            break;
+        }
+    }
+    const CostModel default_cost_model;
+    const CostModel& cost_model = cost_model_ ? *cost_model_ : default_cost_model;
+    std::unordered_map<std::string, double> node_costs;
+    if (provider) {
+        for (const auto& node : graph_->GetNodes()) {
+            node_costs[node->GetName()] = cost_model.EstimateNodeTime(node.get(), provider);
+        }
+    }
+    PipelineStagePartition partition;
+    status = SplitPipelineStages(*graph_, static_cast<size_t>(num_stages), node_costs, &partition);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    auto group = CollectiveGroup::Create(device_type, device_ids);
+    if (!group) {
+        return Status::Error(StatusCode::ERROR_DEVICE_ERROR, "Failed to create the collective group");
+    }
+    std::vector<std::unique_ptr<InferenceSession>> sessions;
+    for (int s = 0; s < num_stages; ++s) {
+        // 阶段的子图来自已经优化过的图，不再优化、缓存或发布
+        SessionOptions stage_options = options_;
+        stage_options.pipeline_parallel_size = 1;
+        stage_options.pipeline_parallel_device_ids.clear();
+        stage_options.optimized_model_cache_dir.clear();
+        stage_options.shared_model_name.clear();
+        stage_options.enable_image_preprocess = false;
+        stage_options.device_id = device_ids[s];
+        stage_options.session_id = session_id_ + "_pp" + std::to_string(s);
+        auto session = Create(stage_options);
+        if (!session) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                               "Failed to create the session of pipeline stage " + std::to_string(s));
+        }
+        session->SetCostModel(cost_model_);
+        session->graph_preoptimized_ = true;
+        status = session->LoadModelFromGraph(std::move(partition.stages[s].graph));
+        if (!status.IsOk()) {
+            return status;
+        }
+        sessions.push_back(std::move(session));
+    }
+    status = PipelineParallelExecutor::Create(std::move(partition), std::move(sessions), std::move(group),
+                                              device_type, options_.pipeline_queue_capacity, &pipeline_parallel_);
+    if (!status.IsOk()) {
+        return status;
+    }
+    StripConstantData(graph_.get());
+    return Status::Ok();
+}
+
+Status InferenceSession::QuantizeModel() {
+    if (options_.quantization_calibration) {
+        QuantizationOptions quantization_options;
+        quantization_options.activation_dtype = options_.quantization_dtype;
+        Status status = QuantizeGraph(graph_.get(), *options_.quantization_calibration, quantization_options);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    auto provider = std::find_if(execution_providers_.begin(), execution_providers_.end(),
+                                 [](const std::shared_ptr<ExecutionProvider>& p) { return p->SupportsQuantization(); });
+    if (provider != execution_providers_.end()) {
+        Status status = (*provider)->QuantizeModel(graph_.get(), options_.quantization_dtype);
+        if (!status.IsOk()) {
+            return status;
+        }
+    } else {
+        LOG_WARNING("No execution provider supports quantization; QDQ nodes run in floating point");
+    }
+    Status status = InferShapes(graph_.get());
+    if (!status.IsOk()) {
+        LOG_WARNING("Shape inference after quantization failed: " + status.Message());
+    }
+    return Status::Ok();
+}
+
+std::string InferenceSession::GetOptimizedModelCachePath() const {
+    // 影响优化结果的选项；分区、内存规划等在缓存的图之上每次重新计算，不参与键
+    std::ostringstream key;
+    key << "level=" << static_cast<int>(options_.graph_optimization_level)
+        << ";fusion=" << options_.enable_operator_fusion
+        << ";blocked_layout=" << options_.enable_blocked_layout
+        << ";depth_first_tile_bytes=" << options_.depth_first_tile_bytes
+        << ";memory_scheduling=" << options_.enable_memory_aware_scheduling
+        << ";subgraph_delegation=" << options_.enable_subgraph_delegation
+        << ";quantization=" << options_.enable_quantization
+        << ";quantization_dtype=" << static_cast<int>(options_.quantization_dtype)
+        << ";mixed_precision=" << static_cast<int>(options_.mixed_precision_weight_dtype)
+        << ";bf16_compute=" << options_.allow_bf16_compute
+        << ";weight_only_bits=" << options_.weight_only_quantization_bits
+        << ";weight_only_block_size=" << options_.weight_only_quantization_block_size
+        << ";calibration=";
+    if (options_.enable_quantization && options_.quantization_calibration) {
+        std::map<std::string, TensorRange> ranges(options_.quantization_calibration->begin(),
+                                                  options_.quantization_calibration->end());
+        for (const auto& entry : ranges) {
+            key << entry.first << ":" << std::setprecision(9) << entry.second.min << ":"
+                << entry.second.max << ",";
+        }
+    }
+    key << ";providers=";
+    for (const std::string& provider : options_.execution_providers) {
+        key << provider << ",";
+    }
+    const CpuFeatures& cpu = GetCpuFeatures();
+    key << ";isa=" << cpu.sse42 << cpu.avx << cpu.avx2 << cpu.fma << cpu.f16c << cpu.avx512f << cpu.avx512bw
+        << cpu.avx512vl << cpu.avx512_vnni << cpu.avx512_bf16 << cpu.amx_int8 << cpu.amx_bf16
+        << cpu.neon << cpu.neon_dotprod << cpu.neon_fp16 << cpu.sve;
+#ifdef INFERUNITY_VERSION
+    key << ";version=" << INFERUNITY_VERSION;
+#endif
+    key << ";format=" << kCompactModelVersion;
+    
+    // 键字符串与模型内容哈希合并为文件名
+    const std::string key_text = key.str();
+    const uint64_t hash = HashBytes(HashGraph(*graph_), key_text);
+    std::ostringstream path;
+    path << options_.optimized_model_cache_dir << "/model_" << std::hex << std::setw(16)
+         << std::setfill('0') << hash << ".ium";
+    return path.str();
+}
+
+void InferenceSession::PrefetchWeights() const {
+    // 按步骤顺序发出预取，内核按同样的顺序读入，靠前的步骤先就绪
+    std::unordered_set<const Tensor*> issued;
+    size_t bytes = 0;
+    for (const ExecutionStep& step : execution_plan_->GetSteps()) {
+        for (const Value* input : step.node->GetInputs()) {
+            const Tensor* tensor = input->GetTensor().get();
+            // 只有不持有数据的常量（映射视图）可能不在内存中
+            if (input->GetProducer() || !tensor || tensor->IsOwned() || !tensor->GetData() ||
+                std::find(graph_->GetInputs().begin(), graph_->GetInputs().end(), input) != graph_->GetInputs().end() ||
+                !issued.insert(tensor).second) {
+                continue;
+            }
+            PrefetchMemory(tensor->GetData(), tensor->GetSizeInBytes());
+            bytes += tensor->GetSizeInBytes();
+        }
+    }
+    if (bytes > 0) {
+        LOG_INFO("Prefetching " + std::to_string(bytes) + " bytes of weights in execution order");
+    }
+}
+
+size_t InferenceSession::TouchWeights() const {
+    // 常量按页切块交给intra-op池：每页读一个字节即触发缺页，映射视图的页从磁盘读入，匿名内存的页被分配
+    constexpr size_t kPageSize = 4096;
+    std::unordered_set<const Tensor*> seen;
+    std::vector<const uint8_t*> bases;
+    std::vector<size_t> sizes;
+    std::vector<int64_t> page_offsets = {0};
+    size_t bytes = 0;
+    for (const ExecutionStep& step : execution_plan_->GetSteps()) {
+        for (const Value* input : step.node->GetInputs()) {
+            const Tensor* tensor = input ? input->GetTensor().get() : nullptr;
+            if (!tensor || input->GetProducer() || !tensor->GetData() ||
+                tensor->GetDeviceType() != DeviceType::CPU || tensor->GetSizeInBytes() == 0 ||
+                std::find(graph_->GetInputs().begin(), graph_->GetInputs().end(), input) != graph_->GetInputs().end() ||
+                !seen.insert(tensor).second) {
+                continue;
+            }
+            bases.push_back(static_cast<const uint8_t*>(tensor->GetData()));
+            sizes.push_back(tensor->GetSizeInBytes());
+            page_offsets.push_back(page_offsets.back() +
+                                   static_cast<int64_t>((tensor->GetSizeInBytes() + kPageSize - 1) / kPageSize));
+            bytes += tensor->GetSizeInBytes();
+        }
+    }
+    std::atomic<uint32_t> sink{0};
+    ThreadPool::ParallelFor(0, page_offsets.back(), 64, [&](int64_t begin, int64_t end) {
+        size_t t = static_cast<size_t>(std::upper_bound(page_offsets.begin(), page_offsets.end(), begin) -
+                                       page_offsets.begin()) - 1;
+        uint32_t sum = 0;
+        for (int64_t page = begin; page < end; ++page) {
+            while (page >= page_offsets[t + 1]) {
+                ++t;
+            }
+            const size_t offset = static_cast<size_t>(page - page_offsets[t]) * kPageSize;
+            sum += static_cast<const volatile uint8_t*>(bases[t])[offset];
+            // 跨页的最后一个字节，张量不从页边界开始时保证覆盖其末页
+            sum += static_cast<const volatile uint8_t*>(bases[t])[std::min(offset + kPageSize, sizes[t]) - 1];
+        }
+        sink.fetch_add(sum, std::memory_order_relaxed);
+    });
+    return bytes;
+}
+
+Status InferenceSession::Warmup(WarmupStats* stats) {
+    if (!graph_ || !execution_plan_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model not loaded");
+    }
+    TraceScope trace(TraceCategory::SESSION, "Warmup");
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    const int64_t start_ns = MetricNowNs();
+    WarmupStats result;
+    result.touched_weight_bytes = TouchWeights();
+    
+    // 预热运行的输入：按给定的形状，或图输入的形状（符号维度取1），内容为零
+    const std::vector<Value*>& graph_inputs = graph_->GetInputs();
+    std::vector<std::vector<Shape>> shape_sets = options_.warmup_input_shapes;
+    if (shape_sets.empty()) {
+        std::vector<Shape> shapes;
+        for (const Value* input : graph_inputs) {
+            shapes.push_back(ConcreteInputShape(input->GetShape()));
+        }
+        shape_sets.push_back(shapes);
+    }
+    const bool run_model = !kv_cache_;
+    for (const std::vector<Shape>& shapes : shape_sets) {
+        if (shapes.size() != graph_inputs.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Warmup input shapes must cover all " + std::to_string(graph_inputs.size()) +
+                               " graph inputs");
+        }
+        std::vector<std::shared_ptr<Tensor>> owned;
+        std::vector<Tensor*> inputs;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            auto tensor = CreateTensor(shapes[i], graph_inputs[i]->GetDataType());
+            if (!tensor) {
+                return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate warmup input");
+            }
+            if (tensor->GetData()) {
+                std::memset(tensor->GetData(), 0, tensor->GetSizeInBytes());
+            }
+            inputs.push_back(tensor.get());
+            owned.push_back(std::move(tensor));
+        }
+    
+        // 串行路径的arena与（该形状的）执行状态池预先分配到上限，并发请求到来时不再分配
+        if (concurrent_run_) {
+            std::shared_ptr<ShapeSpecializedPlan> specialized = GetShapeSpecializedPlan(inputs);
+            std::vector<std::unique_ptr<ExecutionState>> states(
+                static_cast<size_t>(std::max(options_.execution_state_pool_size, 0)));
+            for (auto& state : states) {
+                Status status = AcquireExecutionState(&state, specialized.get());
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            for (auto& state : states) {
+                ReleaseExecutionState(std::move(state), specialized.get());
+            }
+            result.prepared_states += states.size();
+        } else {
+            std::lock_guard<std::mutex> lock(run_mutex_);
+            Status status = EnsureSessionArena();
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        if (!run_model) {
+            continue;
+        }
+        ++result.shapes;
+        for (int r = 0; r < std::max(options_.warmup_runs, 1); ++r) {
+            const int64_t run_start_ns = MetricNowNs();
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            Status status = Run(inputs, outputs);
+            if (!status.IsOk()) {
+                return status;
+            }
+            result.last_run_ms = static_cast<double>(MetricNowNs() - run_start_ns) / 1e6;
+            ++result.runs;
+        }
+    }
+    
+    result.elapsed_ms = static_cast<double>(MetricNowNs() - start_ns) / 1e6;
+    warm_.store(true, std::memory_order_release);
+    LOG_INFO("Session warm after " + std::to_string(result.elapsed_ms) + " ms: touched " +
+             std::to_string(result.touched_weight_bytes) + " weight bytes, " + std::to_string(result.runs) +
+             " runs over " + std::to_string(result.shapes) + " shapes, last run " +
+             std::to_string(result.last_run_ms) + " ms");
+    if (stats) {
+        *stats = result;
+    }
+    return Status::Ok();
+}
+
+void InferenceSession::ReplicateWeightsToNumaNode() {
+    // 在LoadModelFromGraph的节点作用域内分配：大块由内存池mbind到节点，小块由绑核的加载线程首次触碰
+    const std::unordered_set<const Value*> inputs(graph_->GetInputs().begin(), graph_->GetInputs().end());
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> copies;
+    size_t bytes = 0;
+    for (const auto& value : graph_->GetValues()) {
+        if (value->GetProducer() || inputs.count(value.get())) {
+            continue;
+        }
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        if (!tensor || !tensor->GetData() || tensor->GetDeviceType() != DeviceType::CPU ||
+            tensor->GetDataType() == DataType::STRING || !tensor->IsContiguous()) {
+            continue;
+        }
+        auto it = copies.find(tensor.get());
+        if (it == copies.end()) {
+            const size_t size = tensor->GetSizeInBytes();
+            void* data = AllocateMemory(size, 64);
+            if (!data) {
+                LOG_WARNING("NUMA weight replication failed; keeping weights in place");
+                return;
+            }
+            std::memcpy(data, tensor->GetData(), size);
+            bytes += size;
+            // 保留原张量的布局（NCHWc等预变换的权重）
+            std::shared_ptr<Tensor> copy(
+                new Tensor(tensor->GetShape(), tensor->GetDataType(), data, tensor->GetLayout(), DeviceType::CPU),
+                [data](Tensor* t) {
+                    delete t;
+                    FreeMemory(data);
+                });
+            it = copies.emplace(tensor.get(), copy).first;
+        }
+        value->SetTensor(it->second);
+    }
+    LOG_INFO("Replicated " + std::to_string(bytes) + " bytes of weights to NUMA node " +
+             std::to_string(options_.numa_node));
+}
+
+void InferenceSession::PlaceWeightsOnHugePages() {
+    const std::unordered_set<const Value*> inputs(graph_->GetInputs().begin(), graph_->GetInputs().end());
+    std::vector<Value*> large;
+    std::unordered_map<const Tensor*, size_t> offsets;  // 同一个张量只放一次
+    size_t total = 0;
+    for (const auto& value : graph_->GetValues()) {
+        if (value->GetProducer() || inputs.count(value.get())) {
+            continue;
+        }
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        if (!tensor || !tensor->GetData() || tensor->GetDeviceType() != DeviceType::CPU ||
+            tensor->GetDataType() == DataType::STRING || !tensor->IsContiguous() ||
+            tensor->GetSizeInBytes() < kHugePageSize) {
+            continue;
+        }
+        large.push_back(value.get());
+        if (offsets.emplace(tensor.get(), total).second) {
+            total += (tensor->GetSizeInBytes() + 63) / 64 * 64;
+        }
+    }
+    if (large.empty()) {
+        return;
+    }
+    
+    // hugetlbfs的页必须在映射时取得，已有的权重只能复制过去；共享副本被多个会话引用，不复制
+    std::shared_ptr<HugePageRegion> region;
+    if (!options_.shared_weights && (options_.huge_page_policy == HugePagePolicy::HUGETLB_2MB ||
+                                     options_.huge_page_policy == HugePagePolicy::HUGETLB_1GB)) {
+        region = HugePageRegion::Allocate(total, options_.huge_page_policy);
+    }
+    if (!region || region->GetBacking() == HugePageBacking::NORMAL) {
+        size_t advised = 0;
+        for (const auto& entry : offsets) {
+            if (AdviseHugePages(entry.first->GetData(), entry.first->GetSizeInBytes())) {
+                advised += entry.first->GetSizeInBytes();
+            }
+        }
+        LOG_INFO("Advised transparent huge pages for " + std::to_string(advised) + " of " +
+                 std::to_string(total) + " weight bytes");
+        return;
+    }
+    
+    uint8_t* base = static_cast<uint8_t*>(region->GetData());
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> copies;
+    for (Value* value : large) {
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        auto it = copies.find(tensor.get());
+        if (it == copies.end()) {
+            uint8_t* data = base + offsets[tensor.get()];
+            std::memcpy(data, tensor->GetData(), tensor->GetSizeInBytes());
+            // 视图持有区域：最后一个引用这些权重的张量释放后才解除映射
+            it = copies.emplace(tensor.get(), std::shared_ptr<Tensor>(
+                new Tensor(tensor->GetShape(), tensor->GetDataType(), data, tensor->GetLayout(), DeviceType::CPU),
+                [region](Tensor* t) { delete t; })).first;
+        }
+        value->SetTensor(it->second);
+    }
+    LOG_INFO("Placed " + std::to_string(total) + " weight bytes on " +
+             std::string(region->GetBacking() == HugePageBacking::HUGETLB_1GB ? "1GB" :
+                         region->GetBacking() == HugePageBacking::HUGETLB_2MB ? "2MB" : "transparent") +
+             " huge pages");
+}
+
+ExecutionPlanOptions InferenceSession::GetExecutionPlanOptions() const {
+    // 内存规划内的张量是arena视图，跨运行复用，不参与释放
+    ExecutionPlanOptions plan_options;
+    plan_options.node_providers = node_providers_;
+    // 捕获的图引用固定地址，中间张量不能在运行之间释放或重新分配
+    plan_options.release_intermediates = !options_.enable_cuda_graph;
+    plan_options.num_streams = options_.enable_cuda_graph ? 1 : std::max(options_.max_parallel_streams, 1);
+    for (const auto& entry : memory_plan_.entries) {
+        plan_options.persistent_values.insert(entry.value);
+    }
+    return plan_options;
+}
+
+Status InferenceSession::BuildExecutionPlan() {
+    TraceScope trace(TraceCategory::SESSION, "BuildExecutionPlan");
+    std::vector<ExecutionProvider*> provider_ptrs;
+    for (const auto& provider : execution_providers_) {
+        provider_ptrs.push_back(provider.get());
+    }
+    
+    std::unique_ptr<ExecutionPlan> plan;
+    Status status = ExecutionPlan::Build(graph_.get(), provider_ptrs, GetExecutionPlanOptions(), &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    execution_plan_ = std::move(plan);
+    weight_streaming_.reset();
+    if (options_.weight_streaming_budget > 0) {
+        WeightStreamingOptions streaming;
+        streaming.budget_bytes = options_.weight_streaming_budget;
+        streaming.lookahead_steps = options_.weight_streaming_lookahead;
+        weight_streaming_ = std::make_shared<const WeightStreamingSchedule>(*execution_plan_, streaming);
+        LOG_INFO("Streaming " + std::to_string(weight_streaming_->GetTotalBytes()) +
+                 " bytes of mapped weights within a budget of " + std::to_string(streaming.budget_bytes));
+    }
+    weight_prefetcher_.reset();
+    if (options_.weight_prefetch_lookahead > 0) {
+        WeightPrefetchOptions prefetch;
+        prefetch.lookahead_steps = options_.weight_prefetch_lookahead;
+        prefetch.cache_bytes_per_step = options_.weight_prefetch_cache_bytes;
+        weight_prefetcher_ = std::make_shared<WeightPrefetcher>(*execution_plan_, prefetch);
+    }
+    {
+        std::lock_guard<std::mutex> lock(pruned_mutex_);
+        pruned_plans_.clear();
+    }
+    
+    // KV cache在注意力内原地追加，属于会话级可变状态，不能并发
+    state_run_ = true;
+    for (const ExecutionStep& step : execution_plan_->GetSteps()) {
+        state_run_ = state_run_ && step.provider->SupportsConcurrentExecution();
+    }
+    concurrent_run_ = state_run_ && !kv_cache_;
+    PrepareGraphCapture();
+    // 旧池交出的句柄释放时直接还给分配器，新图的输出形状可能不同
+    output_pool_.reset();
+    if (concurrent_run_ && options_.output_buffer_pool_size > 0) {
+        output_pool_ = std::make_shared<OutputBufferPool>(graph_->GetOutputs().size(),
+                                                          options_.output_buffer_pool_size);
+    }
+    return Status::Ok();
+}
+
+void InferenceSession::PrepareGraphCapture() {
+    if (capture_provider_) {
+        capture_provider_->ResetGraph();
+    }
+    capture_provider_ = nullptr;
+    capture_inputs_.clear();
+    if (!options_.enable_cuda_graph || !execution_plan_ || execution_plan_->GetSteps().empty()) {
+        return;
+    }
+    // 所有步骤（含分区边界的拷贝）都要在同一个可捕获的提供者上；KV cache每步改变序列长度，不能重放
+    ExecutionProvider* provider = execution_plan_->GetSteps()[0].provider;
+    for (const ExecutionStep& step : execution_plan_->GetSteps()) {
+        if (step.provider != provider) {
+            provider = nullptr;
+            break;
+        }
+    }
+    if (!provider || !provider->IsGraphCaptureEnabled() || kv_cache_) {
+        LOG_WARNING("Graph capture disabled: the plan must run entirely on one capture-capable provider");
+        return;
+    }
+    // 重放路径依赖Value上绑定的固定张量，走串行路径
+    capture_provider_ = provider;
+    state_run_ = false;
+    concurrent_run_ = false;
+}
+
+Status InferenceSession::PartitionGraph() {
+    TraceScope trace(TraceCategory::SESSION, "PartitionGraph");
+    node_providers_.clear();
+    std::vector<ExecutionProvider*> provider_ptrs;
+    std::vector<DeviceType> devices;
+    ExecutionProvider* delegate = nullptr;
+    for (const auto& provider : execution_providers_) {
+        // 编译型提供者只执行委托给它的子图，不参与逐节点的分区
+        if (options_.enable_subgraph_delegation && !delegate && provider->SupportsSubgraphCompilation()) {
+            delegate = provider.get();
+            continue;
+        }
+        provider_ptrs.push_back(provider.get());
+        if (std::find(devices.begin(), devices.end(), provider->GetDeviceType()) == devices.end()) {
+            devices.push_back(provider->GetDeviceType());
+        }
+    }
+    
+    // 先让编译型提供者认领它能编译的子图，再把原生提供者都不支持的子图换成融合节点，
+    // 之后的分区和分配把融合节点当作普通节点
+    DelegationResult delegation;
+    if (delegate && delegate->ClaimsSubgraphs()) {
+        Status status = DelegateClaimedSubgraphs(graph_.get(), delegate, options_.min_claimed_subgraph_nodes,
+                                                 &delegation);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    if (delegate && !provider_ptrs.empty()) {
+        DelegationResult unsupported;
+        Status status = DelegateUnsupportedSubgraphs(graph_.get(), provider_ptrs, delegate, &unsupported);
+        if (!status.IsOk()) {
+            return status;
+        }
+        delegation.assignment.insert(unsupported.assignment.begin(), unsupported.assignment.end());
+    }
+    
+    // 只有一种设备时没有传输代价可权衡，沿用ExecutionProviderSelector
+    if (!options_.enable_cost_based_partitioning || devices.size() < 2) {
+        return Status::Ok();
+    }
+    
+    GraphPartitioner partitioner(cost_model_);
+    PartitionResult result;
+    Status status = partitioner.Partition(graph_.get(), provider_ptrs, &result);
+    if (!status.IsOk()) {
+        return status;
+    }
+    node_providers_ = std::move(result.assignment);
+    for (const auto& entry : delegation.assignment) {
+        node_providers_[entry.first] = entry.second;
+    }
+    if (result.num_copies > 0) {
+        // 拷贝节点的输出需要形状，供内存规划使用
+        status = InferShapes(graph_.get());
+        if (!status.IsOk()) {
+            LOG_WARNING("Shape inference after partitioning failed: " + status.Message());
+        }
+    }
+    return Status::Ok();
+}
+
+Status InferenceSession::PrepareKVCache() {
+    KVCacheOptions cache_options;
+    cache_options.max_sequence_length = options_.kv_cache_max_sequence_length;
+    cache_options.max_batch_size = options_.max_batch_size;
+    cache_options.allocate = memory_estimate_ == nullptr;
+    auto cache = std::make_unique<KVCache>(cache_options);
+    Status status = BindKVCache(graph_.get(), cache.get());
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (memory_estimate_) {
+        memory_estimate_->kv_cache = cache->GetMemoryBytes();
+    }
+    LOG_INFO("KV cache: " + std::to_string(cache->GetNumLayers()) + " layers, capacity " +
+             std::to_string(cache_options.max_sequence_length) + " x " +
+             std::to_string(cache_options.max_batch_size) + " sequences");
+    kv_cache_ = std::move(cache);
+    return Status::Ok();
+}
+
+void InferenceSession::PrepareLoraTargets() {
+    const std::unordered_set<const Value*> inputs(graph_->GetInputs().begin(), graph_->GetInputs().end());
+    std::unordered_map<std::string, LoraTarget> targets;
+    for (const auto& node : graph_->GetNodes()) {
+        if (node->GetOpType() != "MatMul" || node->GetInputs().size() < 2) {
+            continue;
+        }
+        const Value* weight = node->GetInputs()[1];
+        std::shared_ptr<Tensor> tensor = weight->GetTensor();
+        if (weight->GetProducer() || inputs.count(weight) || weight->GetName().empty() ||
+            !tensor || !tensor->GetData() || tensor->GetShape().dims.size() != 2) {
+            continue;
+        }
+        const AttributeValue* trans_b = node->FindAttribute("transB");
+        const auto& dims = tensor->GetShape().dims;
+        const bool transposed = trans_b && trans_b->GetInt() != 0;
+        LoraTarget target;
+        target.k = transposed ? dims[1] : dims[0];
+        target.n = transposed ? dims[0] : dims[1];
+        targets[weight->GetName()] = target;
+        node->SetAttribute("lora_target", AttributeValue(weight->GetName()));
+    }
+    LOG_INFO("LoRA: " + std::to_string(targets.size()) + " MatMul weights can take adapters");
+    lora_registry_.SetTargets(std::move(targets));
+}
+
+Status InferenceSession::RegisterLoraAdapter(const std::string& adapter_id, LoraAdapter adapter) {
+    if (!options_.enable_lora) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA adapters need SessionOptions::enable_lora");
+    }
+    return lora_registry_.Register(adapter_id, std::move(adapter));
+}
+
+Status InferenceSession::UnregisterLoraAdapter(const std::string& adapter_id) {
+    return lora_registry_.Unregister(adapter_id);
+}
+
+Status InferenceSession::CreateLoraBatch(const RunOptions& run_options,
+                                         std::shared_ptr<const LoraBatch>* batch) const {
+    batch->reset();
+    if (run_options.lora_adapters.empty()) {
+        return Status::Ok();
+    }
+    if (!options_.enable_lora) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA adapters need SessionOptions::enable_lora");
+    }
+    if (capture_provider_ || tensor_parallel_group_) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                             "LoRA adapters are not supported with graph capture or tensor parallelism");
+    }
+    return lora_registry_.CreateBatch(run_options.lora_adapters, batch);
+}
+
+Status InferenceSession::PlanSessionMemory() {
+    TraceScope trace(TraceCategory::MEMORY, "PlanSessionMemory");
+    MemoryPlannerOptions planner_options;
+    planner_options.strategy = options_.memory_plan_strategy;
+    
+    MemoryPlan plan;
+    std::vector<std::pair<Node*, const Node*>> recomputed;
+    Status status = PlanMemoryWithinBudget(graph_.get(), options_.activation_memory_budget, planner_options,
+                                           &plan, &recomputed);
+    if (!status.IsOk()) {
+        return status;
+    }
+    // 重计算的副本沿用原节点的分配
+    for (const auto& pair : recomputed) {
+        auto it = node_providers_.find(pair.second);
+        if (it != node_providers_.end()) {
+            node_providers_[pair.first] = it->second;
+        }
+    }
+    if (memory_estimate_) {
+        memory_estimate_->activation_arena = options_.enable_memory_planning ? plan.arena_size : plan.naive_size;
+        memory_plan_ = std::move(plan);
+        return Status::Ok();
+    }
+    auto arena = MemoryArena::Create(plan.arena_size, plan.alignment, memory_account_, options_.huge_page_policy);
+    if (!arena) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate memory arena");
+    }
+    status = BindMemoryPlan(plan, arena);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    memory_plan_ = std::move(plan);
+    memory_arena_ = arena;
+    Tracer::Instance().RecordCounter(TraceCategory::MEMORY, "arena_bytes",
+                                     static_cast<int64_t>(memory_plan_.arena_size));
+    arena_high_water_metric_->SetMax(static_cast<int64_t>(memory_plan_.arena_size));
+    LOG_INFO("Memory plan (" + std::string(MemoryPlanStrategyName(memory_plan_.strategy)) + "): " +
+             std::to_string(memory_plan_.entries.size()) + " tensors, arena " +
+             std::to_string(memory_plan_.arena_size) + " bytes, naive " +
+             std::to_string(memory_plan_.naive_size) + " bytes, lower bound " +
+             std::to_string(memory_plan_.lower_bound) + " bytes");
+    return Status::Ok();
+}
+
+Status InferenceSession::EstimateMemory(const std::string& filepath, const SessionOptions& options,
+                                        const std::vector<Shape>& input_shapes, MemoryEstimate* estimate) {
+    if (!estimate) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Estimate is null");
+    }
+    if (options.tensor_parallel_size > 1 || options.pipeline_parallel_size > 1) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Memory estimation does not support tensor or pipeline parallelism");
+    }
+    // 估计不写优化图缓存、不发布共享模型、不预热，也不与其他会话共享权重
+    SessionOptions estimate_options = options;
+    estimate_options.optimized_model_cache_dir.clear();
+    estimate_options.shared_model_name.clear();
+    estimate_options.shared_weights.reset();
+    estimate_options.warmup_on_load = false;
+    estimate_options.prefetch_weights = false;
+    auto session = Create(estimate_options);
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Failed to create session");
+    }
+    MemoryEstimate result;
+    session->memory_estimate_ = &result;
+    session->estimate_input_shapes_ = input_shapes;
+    Status status = session->LoadModel(filepath);
+    if (!status.IsOk()) {
+        return status;
+    }
+    *estimate = result;
+    return Status::Ok();
+}
+
+Status InferenceSession::EstimateMemory(std::unique_ptr<Graph> graph, const SessionOptions& options,
+                                        const std::vector<Shape>& input_shapes, MemoryEstimate* estimate) {
+    if (!estimate) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Estimate is null");
+    }
+    if (options.tensor_parallel_size > 1 || options.pipeline_parallel_size > 1) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Memory estimation does not support tensor or pipeline parallelism");
+    }
+    SessionOptions estimate_options = options;
+    estimate_options.optimized_model_cache_dir.clear();
+    estimate_options.shared_model_name.clear();
+    estimate_options.shared_weights.reset();
+    estimate_options.warmup_on_load = false;
+    estimate_options.prefetch_weights = false;
+    auto session = Create(estimate_options);
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Failed to create session");
+    }
+    MemoryEstimate result;
+    session->memory_estimate_ = &result;
+    session->estimate_input_shapes_ = input_shapes;
+    Status status = session->LoadModelFromGraph(std::move(graph));
+    if (!status.IsOk()) {
+        return status;
+    }
+    *estimate = result;
+    return Status::Ok();
+}
+
+void InferenceSession::FinishMemoryEstimate() {
+    MemoryEstimate& estimate = *memory_estimate_;
+    std::unordered_set<const Value*> graph_inputs(graph_->GetInputs().begin(), graph_->GetInputs().end());
+    std::unordered_set<const Value*> planned;
+    for (const MemoryPlanEntry& entry : memory_plan_.entries) {
+        planned.insert(entry.value);
+    }
+    auto is_constant = [&](const Value* value) {
+        auto tensor = value->GetTensor();
+        return !value->GetProducer() && !graph_inputs.count(value) && tensor && tensor->GetData();
+    };
+    for (const auto& value : graph_->GetValues()) {
+        if (is_constant(value.get())) {
+            estimate.weights += value->GetTensor()->GetSizeInBytes();
+        }
+    }
+    for (const Value* output : graph_->GetOutputs()) {
+        if (output->GetProducer() && !planned.count(output)) {
+            estimate.outputs += GetTensorInfoBytes(TensorInfo{output->GetShape(), output->GetDataType(), nullptr});
+        }
+    }
+    
+    // 与PrepareExecution一致：每个节点一个算子实例，同一常量的打包结果经PrepackedWeightCache去重；
+    // 工作区随算子实例常驻，GEMM打包缓冲为线程私有，取最大者
+    std::unordered_set<const Value*> packed_weights;
+    size_t max_scratch = 0;
+    for (const auto& node : graph_->GetNodes()) {
+        auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+        if (!op) {
+            continue;
+        }
+        ApplyNodeAttributes(*node, op.get());
+        std::vector<TensorInfo> infos;
+        const Value* weight = nullptr;
+        for (const Value* input : node->GetInputs()) {
+            const bool constant = input && is_constant(input);
+            infos.push_back(input ? TensorInfo{input->GetShape(), input->GetDataType(),
+                                               constant ? input->GetTensor().get() : nullptr}
+                                  : TensorInfo());
+            if (constant && !weight && infos.size() == 2) {
+                weight = input;
+            }
+        }
+        const OperatorMemory memory = op->EstimateMemory(infos);
+        if (memory.prepacked_bytes > 0 && (!weight || packed_weights.insert(weight).second)) {
+            estimate.prepacked_weights += memory.prepacked_bytes;
+        }
+        estimate.scratch += memory.workspace_bytes;
+        max_scratch = std::max(max_scratch, memory.scratch_bytes);
+    }
+    estimate.scratch += max_scratch * std::max<size_t>(1, ThreadPool::GetThreadCount());
+    LOG_INFO("Memory estimate: " + std::to_string(estimate.Total()) + " bytes");
+}
+
+std::string MemoryEstimate::ToString() const {
+    std::ostringstream out;
+    const std::pair<const char*, size_t> rows[] = {
+        {"weights", weights}, {"prepacked_weights", prepacked_weights}, {"activation_arena", activation_arena},
+        {"outputs", outputs}, {"kv_cache", kv_cache}, {"scratch", scratch}, {"total", Total()},
+    };
+    for (const auto& row : rows) {
+        out << std::left << std::setw(20) << row.first << std::right << std::setw(16) << row.second << "\n";
+    }
+    return out.str();
+}
+
+std::vector<Shape> InferenceSession::GetInputShapes() const {
+    std::vector<Shape> shapes;
+    if (graph_) {
+        for (Value* input : graph_->GetInputs()) {
+            shapes.push_back(input->GetShape());
+        }
+    }
+    return shapes;
+}
+
+std::vector<Shape> InferenceSession::GetOutputShapes() const {
+    std::vector<Shape> shapes;
+    if (graph_) {
+        for (Value* output : graph_->GetOutputs()) {
+            shapes.push_back(output->GetShape());
+        }
+    }
+    return shapes;
+}
+
+std::vector<std::string> InferenceSession::GetInputNames() const {
+    std::vector<std::string> names;
+    if (graph_) {
+        for (Value* input : graph_->GetInputs()) {
+            std::string name = input->GetName();
+            if (name.empty()) {
+                // 如果没有名称，使用默认名称
+                name = "input_" + std::to_string(names.size());
+            }
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+std::vector<std::string> InferenceSession::GetOutputNames() const {
+    std::vector<std::string> names;
+    if (graph_) {
+        for (Value* output : graph_->GetOutputs()) {
+            std::string name = output->GetName();
+            if (name.empty()) {
+                // 如果没有名称，使用默认名称
+                name = "output_" + std::to_string(names.size());
+            }
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+Status InferenceSession::Run(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
+    // 输出指向Value上的张量，多个线程同时调用时串行执行
+    TraceScope trace(TraceCategory::SESSION, "Run");
+    ScopedLatency latency(run_latency_metric_.get());
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    PriorityScope priority(options_.priority, true);
+    ThreadPoolBurst burst(options_.thread_pool_burst_spin_us, options_.run_first_task_on_caller);
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    return RunSequential(inputs, outputs);
+}
+
+Status InferenceSession::RunSequential(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
+    if (!graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Model not loaded");
+    }
+    
+    if (!tensor_parallel_ranks_.empty()) {
+        return RunTensorParallel(inputs, outputs);
+    }
+    if (pipeline_parallel_) {
+        // 一个micro-batch流过全部阶段，输出挂在协调会话的输出Value上，与其他路径一样由调用方取走
+        std::vector<std::vector<std::shared_ptr<Tensor>>> results;
+        Status status = pipeline_parallel_->Run({inputs}, &results);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::vector<Value*>& graph_outputs = graph_->GetOutputs();
+        outputs.clear();
+        for (size_t i = 0; i < graph_outputs.size(); ++i) {
+            graph_outputs[i]->SetTensor(results[0][i]);
+            outputs.push_back(results[0][i].get());
+        }
+        return Status::Ok();
+    }
+    if (capture_provider_) {
+        return RunCaptured(inputs, outputs);
+    }
+    Status arena_status = EnsureSessionArena();
+    if (!arena_status.IsOk()) {
+        return arena_status;
+    }
+    ExecutionOptions options = GetExecutionOptions();
+    GraphInputGuard guard(graph_.get());
+    if (execution_plan_) {
+        // 中间张量改用按本次输入形状规划的arena视图
+        std::shared_ptr<ShapeSpecializedPlan> specialized = GetShapeSpecializedPlan(inputs);
+        if (specialized && !specialized->arena) {
+            Status status = CreateSpecializedViews(specialized.get(), memory_account_, options_.huge_page_policy);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        if (specialized) {
+            for (const auto& view : specialized->views) {
+                view.first->SetTensor(view.second);
+            }
+        }
+        return execution_engine_->ExecutePlan(*execution_plan_, inputs, outputs, options);
+    }
+    return execution_engine_->Execute(graph_.get(), inputs, outputs, options);
+}
+
+Status InferenceSession::RunTensorParallel(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
+    const size_t world_size = tensor_parallel_ranks_.size();
+    std::vector<std::vector<Tensor*>> rank_outputs(world_size);
+    std::mutex error_mutex;
+    Status first_error = Status::Ok();
+    auto run_rank = [&](size_t r) {
+        Status status = tensor_parallel_ranks_[r]->Run(inputs, rank_outputs[r]);
+        if (!status.IsOk()) {
+            {
+                // 其余rank因中止而返回的错误不覆盖最先出错的原因
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (first_error.IsOk()) {
+                    first_error = status;
+                }
+            }
+            tensor_parallel_group_->Abort();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t r = 1; r < world_size; ++r) {
+        threads.emplace_back(run_rank, r);
+    }
+    run_rank(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (!first_error.IsOk()) {
+        tensor_parallel_group_->Reset();
+        return first_error;
+    }
+    outputs = rank_outputs[0];
+    return Status::Ok();
+}
+
+Status InferenceSession::EnsureSessionArena() {
+    if (memory_arena_ || memory_plan_.entries.empty()) {
+        return Status::Ok();
+    }
+    auto arena = MemoryArena::Create(memory_plan_.arena_size, memory_plan_.alignment, memory_account_,
+                                     options_.huge_page_policy);
+    if (!arena) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate memory arena");
+    }
+    Status status = BindMemoryPlan(memory_plan_, arena);
+    if (status.IsOk()) {
+        memory_arena_ = arena;
+    }
+    return status;
+}
+
+size_t InferenceSession::ReleaseActivationMemory() {
+    const size_t before = memory_account_->GetAllocatedBytes();
+    {
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        pipeline_.reset();
+    }
+    // 空闲状态先移出再释放，锁内只做交换
+    std::vector<std::unique_ptr<ExecutionState>> states;
+    {
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+        if (memory_arena_ && !capture_provider_) {
+            // Value上的视图持有arena，换成只有形状的占位张量后arena才会释放
+            for (const auto& entry : memory_plan_.entries) {
+                entry.value->SetTensor(CreateTensorFromData(entry.shape, entry.dtype, nullptr,
+                                                            entry.layout, DeviceType::CPU));
+            }
+            memory_arena_.reset();
+        }
+        std::lock_guard<std::mutex> specialized_lock(specialized_mutex_);
+        std::lock_guard<std::mutex> pool_lock(state_pool_mutex_);
+        for (auto& entry : specialized_plans_) {
+            entry.second->views.clear();
+            entry.second->arena.reset();
+            for (auto& state : entry.second->idle_states) {
+                states.push_back(std::move(state));
+            }
+            entry.second->idle_states.clear();
+        }
+        for (auto& state : idle_states_) {
+            states.push_back(std::move(state));
+        }
+        idle_states_.clear();
+    }
+    states.clear();
+    const size_t after = memory_account_->GetAllocatedBytes();
+    return before > after ? before - after : 0;
+}
+
+Status InferenceSession::RunCaptured(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
+    if (inputs.size() != execution_plan_->GetInputSlots().size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Input count mismatch");
+    }
+    // 输入形状或类型与捕获时不同：重建固定缓冲，重新捕获
+    bool changed = capture_inputs_.size() != inputs.size();
+    for (size_t i = 0; !changed && i < inputs.size(); ++i) {
+        changed = !inputs[i] || inputs[i]->GetShape().dims != capture_inputs_[i]->GetShape().dims ||
+                  inputs[i]->GetDataType() != capture_inputs_[i]->GetDataType();
+    }
+    if (changed) {
+        capture_provider_->ResetGraph();
+        capture_inputs_.clear();
+        for (Tensor* input : inputs) {
+            if (!input) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Input is null");
+            }
+            capture_inputs_.push_back(CreateTensor(input->GetShape(), input->GetDataType(),
+                                                   input->GetDeviceType()));
+        }
+    }
+    // 重放期间图输入Value也绑定在固定缓冲上
+    GraphInputGuard guard(graph_.get());
+    const std::vector<Value*>& values = execution_plan_->GetValues();
+    std::vector<Tensor*> stable_inputs;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        Status status = inputs[i]->CopyTo(*capture_inputs_[i]);
+        if (!status.IsOk()) {
+            return status;
+        }
+        values[execution_plan_->GetInputSlots()[i]]->SetTensor(capture_inputs_[i]);
+        stable_inputs.push_back(capture_inputs_[i].get());
+    }
+    
+    if (!capture_provider_->IsGraphCaptured()) {
+        ExecutionOptions options = GetExecutionOptions();
+        // 预热：第一次运行分配中间张量与输出、初始化库句柄，捕获期间不能再分配
+        Status status = execution_engine_->ExecutePlan(*execution_plan_, stable_inputs, outputs, options);
+        if (!status.IsOk()) {
+            return status;
+        }
+        status = capture_provider_->CaptureBegin();
+        if (!status.IsOk()) {
+            return status;
+        }
+        status = execution_engine_->ExecutePlan(*execution_plan_, stable_inputs, outputs, options);
+        Status end_status = capture_provider_->CaptureEnd();
+        if (!status.IsOk() || !end_status.IsOk()) {
+            capture_provider_->ResetGraph();
+            return status.IsOk() ? end_status : status;
+        }
+    }
+    
+    Status status = capture_provider_->ReplayGraph();
+    if (!status.IsOk()) {
+        return status;
+    }
+    outputs.clear();
+    for (int slot : execution_plan_->GetOutputSlots()) {
+        if (values[slot]->GetTensor()) {
+            outputs.push_back(values[slot]->GetTensor().get());
+        }
+    }
+    return Status::Ok();
+}
+
+ExecutionOptions InferenceSession::GetExecutionOptions() const {
+    ExecutionOptions options;
+    options.enable_profiling = options_.enable_profiling;
+    options.intra_op_num_threads = options_.num_threads;
+    options.intra_op_min_work_per_thread = options_.intra_op_min_work_per_thread;
+    options.max_parallel_streams = options_.max_parallel_streams;
+    options.cancellation = CancellationScope::Current();
+    options.lora = LoraScope::Current();
+    options.weight_streaming = weight_streaming_;
+    options.weight_prefetcher = weight_prefetcher_;
+    return options;
+}
+
+Status InferenceSession::Run(const RunOptions& run_options, const std::vector<Tensor*>& inputs,
+                            std::vector<std::shared_ptr<Tensor>>& outputs) {
+    std::shared_ptr<const LoraBatch> lora;
+    Status status = CreateLoraBatch(run_options, &lora);
+    if (!status.IsOk()) {
+        return status;
+    }
+    CancellationScope cancellation(run_options.cancellation);
+    PriorityScope priority(run_options.priority);
+    LoraScope lora_scope(std::move(lora));
+    return Run(inputs, outputs);
+}
+
+Status InferenceSession::Run(const std::vector<Tensor*>& inputs,
+                            std::vector<std::shared_ptr<Tensor>>& outputs) {
+    // 输入内容相同的请求直接返回缓存的输出；KV cache的输出依赖会话中的序列状态、选用LoRA适配器的运行
+    // 依赖适配器，都不缓存
+    uint64_t cache_key = 0;
+    const bool cacheable = result_cache_ && graph_ && !kv_cache_ && !LoraScope::Current() &&
+                           ResultCache::ComputeKey(inputs, &cache_key);
+    if (cacheable) {
+        if (result_cache_->Lookup(cache_key, &outputs)) {
+            result_cache_hits_metric_->Add();
+            return Status::Ok();
+        }
+        result_cache_misses_metric_->Add();
+    }
+    Status status = RunDetached(inputs, outputs);
+    if (cacheable && status.IsOk()) {
+        result_cache_->Insert(cache_key, outputs);
+    }
+    return status;
+}
+
+Status InferenceSession::RunDetached(const std::vector<Tensor*>& inputs,
+                                     std::vector<std::shared_ptr<Tensor>>& outputs) {
+    if (!graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Model not loaded");
+    }
+    outputs.clear();
+    TraceScope trace(TraceCategory::SESSION, "Run");
+    ScopedLatency latency(run_latency_metric_.get());
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    PriorityScope priority(options_.priority, true);
+    ThreadPoolBurst burst(options_.thread_pool_burst_spin_us, options_.run_first_task_on_caller);
+    
+    // 并发路径：中间结果写入独立的执行状态，图和权重只读共享
+    if (concurrent_run_) {
+        std::shared_ptr<ShapeSpecializedPlan> specialized = GetShapeSpecializedPlan(inputs);
+        std::unique_ptr<ExecutionState> state;
+        Status status = AcquireExecutionState(&state, specialized.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+        const std::vector<Value*>& values = execution_plan_->GetValues();
+        const std::vector<int>& output_slots = execution_plan_->GetOutputSlots();
+        // 回收池中上次交出、已被调用方释放的缓冲放进输出槽位，形状相同时生产者直接写入
+        std::vector<std::shared_ptr<Tensor>> recycled(output_pool_ ? output_slots.size() : 0);
+        for (size_t i = 0; i < recycled.size(); ++i) {
+            const int slot = output_slots[i];
+            if (!tensors[slot] && values[slot]->GetProducer()) {
+                recycled[i] = output_pool_->Acquire(i);
+                tensors[slot] = recycled[i];
+            }
+        }
+        std::vector<Tensor*> output_ptrs;
+        status = execution_engine_->ExecutePlan(*execution_plan_, state.get(), inputs, output_ptrs,
+                                                GetExecutionOptions());
+        for (size_t i = 0; status.IsOk() && i < output_slots.size(); ++i) {
+            const int slot = output_slots[i];
+            if (!tensors[slot]) {
+                continue;
+            }
+            std::shared_ptr<Tensor> output;
+            if (output_pool_) {
+                status = DetachPooledOutput(i, values[slot], recycled[i].get(), &tensors[slot], &output);
+                if (recycled[i] && output.get() == recycled[i].get()) {
+                    recycled[i].reset();
+                }
+            } else {
+                status = DetachOutput(values[slot], &tensors[slot], &output);
+            }
+            if (!status.IsOk()) {
+                break;
+            }
+            outputs.push_back(output);
+        }
+        // 没有用上的缓冲（形状改变、运行失败）放回池中，不留在执行状态里
+        for (size_t i = 0; i < recycled.size(); ++i) {
+            if (!recycled[i]) {
+                continue;
+            }
+            if (tensors[output_slots[i]] == recycled[i]) {
+                tensors[output_slots[i]].reset();
+            }
+            output_pool_->Release(i, std::move(recycled[i]));
+        }
+        ReleaseExecutionState(std::move(state), specialized.get());
+        return status;
+    }
+    
+    // KV cache等会话级可变状态：串行执行，结果从Value上取走
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    std::vector<Tensor*> output_ptrs;
+    Status status = RunSequential(inputs, output_ptrs);
+    if (!status.IsOk()) {
+        return status;
+    }
+    std::unordered_map<Tensor*, std::shared_ptr<Tensor>> detached;
+    for (Tensor* ptr : output_ptrs) {
+        auto it = detached.find(ptr);
+        if (it != detached.end()) {
+            outputs.push_back(it->second);
+            continue;
+        }
+        std::shared_ptr<Tensor> output;
+        for (Value* value : graph_->GetOutputs()) {
+            if (value->GetTensor().get() == ptr) {
+                // 重放写入固定地址，输出不能被取走
+                std::shared_ptr<Tensor> source = value->GetTensor();
+                status = DetachOutput(value, &source, &output, !capture_provider_);
+                if (!status.IsOk()) {
+                    return status;
+                }
+                if (!source) {
+                    value->SetTensor(nullptr);
+                }
+                break;
+            }
+        }
+        if (!output) {
+            // 直通到输出的调用方输入已从图输入Value上解绑，直接拷贝
+            output = CreateTensor(ptr->GetShape(), ptr->GetDataType(), ptr->GetDeviceType());
+            status = ptr->CopyTo(*output);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        detached[ptr] = output;
+        outputs.push_back(output);
+    }
+    return Status::Ok();
+}
+
+Status InferenceSession::Run(const std::vector<Tensor*>& inputs, const std::vector<std::string>& output_names,
+                            std::vector<std::shared_ptr<Tensor>>& outputs) {
+    if (!graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Model not loaded");
+    }
+    outputs.clear();
+    if (output_names.empty()) {
+        return Run(inputs, outputs);
+    }
+    const std::vector<std::string> all_names = GetOutputNames();
+    std::vector<int> key;
+    for (const std::string& name : output_names) {
+        auto it = std::find(all_names.begin(), all_names.end(), name);
+        if (it == all_names.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown output: " + name);
+        }
+        key.push_back(static_cast<int>(it - all_names.begin()));
+    }
+    
+    // 没有执行状态的路径执行整个图，再按名称挑出输出
+    if (!state_run_ || capture_provider_ || !tensor_parallel_ranks_.empty() || pipeline_parallel_) {
+        std::vector<std::shared_ptr<Tensor>> all_outputs;
+        Status status = Run(inputs, all_outputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (all_outputs.size() != all_names.size()) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Output not produced");
+        }
+        for (int index : key) {
+            outputs.push_back(all_outputs[index]);
+        }
+        return Status::Ok();
+    }
+    
+    std::shared_ptr<PrunedExecutionPlan> pruned;
+    {
+        std::lock_guard<std::mutex> lock(pruned_mutex_);
+        auto it = pruned_plans_.find(key);
+        if (it != pruned_plans_.end()) {
+            pruned = it->second;
+        }
+    }
+    if (!pruned) {
+        ExecutionPlanOptions plan_options = GetExecutionPlanOptions();
+        plan_options.node_order = execution_plan_->GetNodeOrder();
+        for (int index : key) {
+            plan_options.output_values.push_back(graph_->GetOutputs()[index]);
+        }
+        std::vector<ExecutionProvider*> provider_ptrs;
+        for (const auto& provider : execution_providers_) {
+            provider_ptrs.push_back(provider.get());
         }
+        pruned = std::make_shared<PrunedExecutionPlan>();
+        Status status = ExecutionPlan::Build(graph_.get(), provider_ptrs, plan_options, &pruned->plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+        LOG_INFO("Pruned execution plan: " + std::to_string(pruned->plan->GetSteps().size()) + " of " +
+                 std::to_string(execution_plan_->GetSteps().size()) + " nodes for " +
+                 std::to_string(key.size()) + " outputs");
+        std::lock_guard<std::mutex> lock(pruned_mutex_);
+        pruned = pruned_plans_.emplace(key, pruned).first->second;
     }
     
-    // 其他格式支持（待实现）
-    // TensorFlow Lite (.tflite): 需要实现FlatBuffer解析器
-    // TensorFlow SavedModel (.pb): 需要实现protobuf解析器
-    // 目前只支持ONNX格式
+    TraceScope trace(TraceCategory::SESSION, "Run", "PartialOutputs");
+    ScopedLatency latency(run_latency_metric_.get());
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    PriorityScope priority(options_.priority, true);
+    ThreadPoolBurst burst(options_.thread_pool_burst_spin_us, options_.run_first_task_on_caller);
     
-    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
-                       "Unsupported model format in memory. Only ONNX format is supported.");
+    // 形状特化时按该形状的内存规划新建执行状态（特化计划可能被淘汰，不放回池中）
+    std::shared_ptr<ShapeSpecializedPlan> specialized = GetShapeSpecializedPlan(inputs);
+    std::unique_ptr<ExecutionState> state;
+    if (!specialized) {
+        std::lock_guard<std::mutex> lock(state_pool_mutex_);
+        if (!pruned->idle_states.empty()) {
+            state = std::move(pruned->idle_states.back());
+            pruned->idle_states.pop_back();
+        }
+    }
+    if (!state) {
+        const MemoryPlan* memory_plan = specialized ? &specialized->memory_plan : &memory_plan_;
+        std::lock_guard<std::mutex> lock(run_mutex_);
+        Status status = ExecutionState::Create(*pruned->plan, memory_plan->entries.empty() ? nullptr : memory_plan,
+                                               &state, memory_account_, options_.huge_page_policy);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    std::unique_lock<std::mutex> lock(run_mutex_, std::defer_lock);
+    if (!concurrent_run_) {
+        lock.lock();
+    }
+    std::vector<Tensor*> output_ptrs;
+    Status status = execution_engine_->ExecutePlan(*pruned->plan, state.get(), inputs, output_ptrs,
+                                                   GetExecutionOptions());
+    std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+    const std::vector<Value*>& values = pruned->plan->GetValues();
+    // 同一个输出请求多次时只取走一次
+    std::unordered_map<int, std::shared_ptr<Tensor>> detached;
+    for (int slot : pruned->plan->GetOutputSlots()) {
+        if (!status.IsOk()) {
+            break;
+        }
+        auto it = detached.find(slot);
+        if (it != detached.end()) {
+            outputs.push_back(it->second);
+            continue;
+        }
+        if (!tensors[slot]) {
+            status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Output not produced");
+            break;
+        }
+        std::shared_ptr<Tensor> output;
+        status = DetachOutput(values[slot], &tensors[slot], &output);
+        detached[slot] = output;
+        outputs.push_back(output);
+    }
+    if (lock.owns_lock()) {
+        lock.unlock();
+    }
+    if (!status.IsOk()) {
+        outputs.clear();
+    }
+    if (!specialized) {
+        std::lock_guard<std::mutex> pool_lock(state_pool_mutex_);
+        if (pruned->idle_states.size() < static_cast<size_t>(std::max(options_.execution_state_pool_size, 0))) {
+            pruned->idle_states.push_back(std::move(state));
+        }
+    }
+    return status;
 }
 
-Status InferenceSession::LoadModelFromGraph(std::unique_ptr<Graph> graph) {
-    graph_ = std::move(graph);
-    return LoadAndOptimizeGraph();
+size_t InferenceSession::GetNumPrunedPlans() const {
+    std::lock_guard<std::mutex> lock(pruned_mutex_);
+    return pruned_plans_.size();
 }
 
-Status InferenceSession::LoadAndOptimizeGraph() {
-    if (!graph_) {
+std::unique_ptr<IOBinding> InferenceSession::CreateIOBinding() const {
+    return std::unique_ptr<IOBinding>(new IOBinding(this));
+}
+
+Status InferenceSession::Run(IOBinding& binding) {
+    if (!graph_ || binding.session_ != this || binding.graph_ != graph_.get()) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                           "Graph is null");
+                           "IOBinding does not belong to the loaded model");
+    }
+    if (!tensor_parallel_ranks_.empty() || pipeline_parallel_) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "IOBinding is not supported with tensor or pipeline parallelism");
+    }
+    TraceScope trace(TraceCategory::SESSION, "Run", "IOBinding");
+    ScopedLatency latency(run_latency_metric_.get());
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    PriorityScope priority(options_.priority, true);
+    ThreadPoolBurst burst(options_.thread_pool_burst_spin_us, options_.run_first_task_on_caller);
+    std::vector<Tensor*> inputs;
+    for (size_t i = 0; i < binding.inputs_.size(); ++i) {
+        if (!binding.inputs_[i]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Input not bound: " + binding.input_names_[i]);
+        }
+        inputs.push_back(binding.inputs_[i].get());
     }
+    const std::vector<Value*>& graph_outputs = graph_->GetOutputs();
+    binding.outputs_.assign(graph_outputs.size(), nullptr);
     
-    // 验证图
-    Status status = graph_->Validate();
-    if (!status.IsOk()) {
+    // 没有生产者的输出（图输入直通、常量）拷贝到绑定的缓冲，其余由算子直接写入
+    auto collect = [this, &binding, &graph_outputs](size_t i, std::shared_ptr<Tensor>* source) {
+        const auto& bound = binding.bound_outputs_[i];
+        if (!bound) {
+            return DetachOutput(graph_outputs[i], source, &binding.outputs_[i], !capture_provider_);
+        }
+        if (source->get() != bound.get()) {
+            Status status = (*source)->CopyTo(*bound);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        binding.outputs_[i] = bound;
+        return Status::Ok();
+    };
+    
+    if (!state_run_) {
+        std::lock_guard<std::mutex> lock(run_mutex_);
+        std::vector<Tensor*> output_ptrs;
+        Status status = RunSequential(inputs, output_ptrs);
+        for (size_t i = 0; status.IsOk() && i < graph_outputs.size(); ++i) {
+            std::shared_ptr<Tensor> source = graph_outputs[i]->GetTensor();
+            if (!source) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Output not produced");
+            }
+            status = collect(i, &source);
+            if (!source) {
+                graph_outputs[i]->SetTensor(nullptr);
+            }
+        }
         return status;
     }
     
-    // 形状推断（参考ONNX Runtime的ShapeInference）
-    status = InferShapes(graph_.get());
+    std::shared_ptr<ShapeSpecializedPlan> specialized = GetShapeSpecializedPlan(inputs);
+    std::unique_ptr<ExecutionState> state;
+    Status status = AcquireExecutionState(&state, specialized.get());
     if (!status.IsOk()) {
-        // 形状推断失败不影响加载，只记录警告
-        LOG_WARNING("Shape inference failed: " + status.Message());
+        return status;
     }
-    
-    // 优化图 (参考ONNX Runtime的图优化级别)
-    if (options_.graph_optimization_level != SessionOptions::GraphOptimizationLevel::NONE) {
-        status = optimizer_->Optimize(graph_.get());
-        if (!status.IsOk()) {
-            return status;
+    std::unique_lock<std::mutex> lock(run_mutex_, std::defer_lock);
+    if (!concurrent_run_) {
+        lock.lock();
+    }
+    const std::vector<int>& output_slots = execution_plan_->GetOutputSlots();
+    for (size_t i = 0; i < output_slots.size(); ++i) {
+        if (binding.bound_outputs_[i]) {
+            state->BindOutput(output_slots[i], binding.bound_outputs_[i]);
         }
     }
-    
-    // 分配执行提供者 (参考ONNX Runtime的节点分配)
-    std::vector<ExecutionProvider*> provider_ptrs;
-    for (const auto& provider : execution_providers_) {
-        provider_ptrs.push_back(provider.get());
+    std::vector<Tensor*> output_ptrs;
+    status = execution_engine_->ExecutePlan(*execution_plan_, state.get(), inputs, output_ptrs,
+                                            GetExecutionOptions());
+    std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+    for (size_t i = 0; status.IsOk() && i < output_slots.size(); ++i) {
+        // 绑定的缓冲在ExecutePlan结束时已从槽位移除
+        std::shared_ptr<Tensor>& source = tensors[output_slots[i]];
+        if (!source && binding.bound_outputs_[i]) {
+            binding.outputs_[i] = binding.bound_outputs_[i];
+            continue;
+        }
+        if (!source) {
+            status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Output not produced");
+            break;
+        }
+        status = collect(i, &source);
+    }
+    state->ClearBoundOutputs();
+    if (lock.owns_lock()) {
+        lock.unlock();
+    }
+    ReleaseExecutionState(std::move(state), specialized.get());
+    return status;
+}
+
+Status InferenceSession::DetachOutput(const Value* value, std::shared_ptr<Tensor>* source,
+                                     std::shared_ptr<Tensor>* output, bool allow_move) {
+    // 图输出默认不进入arena（见MemoryPlannerOptions::include_graph_outputs），是自有张量时直接取走，
+    // 下一次运行会重新分配；图输入直通、arena视图、常量等非自有张量拷贝一份
+    const std::shared_ptr<Tensor>& tensor = *source;
+    if (allow_move && tensor->IsOwned() && value->GetProducer()) {
+        *output = std::move(*source);
+        source->reset();
+        return Status::Ok();
     }
-    status = ExecutionProviderSelector::AssignProviders(graph_.get(), provider_ptrs);
+    auto copy = CreateTensor(tensor->GetShape(), tensor->GetDataType(), tensor->GetDeviceType());
+    Status status = tensor->CopyTo(*copy);
     if (!status.IsOk()) {
         return status;
     }
-    
-    // 准备执行
-    for (const auto& provider : execution_providers_) {
-        status = provider->PrepareExecution(graph_.get());
-        if (!status.IsOk()) {
-            return status;
-        }
-    }
-    
+    *output = copy;
     return Status::Ok();
 }
 
-std::vector<Shape> InferenceSession::GetInputShapes() const {
-    std::vector<Shape> shapes;
-    if (graph_) {
-        for (Value* input : graph_->GetInputs()) {
-            shapes.push_back(input->GetShape());
-        }
+Status InferenceSession::DetachPooledOutput(size_t index, const Value* value, const Tensor* recycled,
+                                           std::shared_ptr<Tensor>* source, std::shared_ptr<Tensor>* output) {
+    // 自有张量直接交出；图输入直通、arena视图等拷贝进池中形状相同的缓冲
+    if ((*source)->IsOwned() && value->GetProducer()) {
+        output_pool_->RecordUse(recycled && source->get() == recycled);
+        *output = output_pool_->Hand(index, std::move(*source));
+        source->reset();
+        return Status::Ok();
     }
-    return shapes;
+    const Tensor& tensor = **source;
+    std::shared_ptr<Tensor> copy = output_pool_->Acquire(index, tensor.GetShape(), tensor.GetDataType(),
+                                                         tensor.GetDeviceType());
+    Status status = tensor.CopyTo(*copy);
+    if (!status.IsOk()) {
+        return status;
+    }
+    *output = output_pool_->Hand(index, std::move(copy));
+    return Status::Ok();
 }
 
-std::vector<Shape> InferenceSession::GetOutputShapes() const {
-    std::vector<Shape> shapes;
-    if (graph_) {
-        for (Value* output : graph_->GetOutputs()) {
-            shapes.push_back(output->GetShape());
+Status InferenceSession::AcquireExecutionState(std::unique_ptr<ExecutionState>* state,
+                                              ShapeSpecializedPlan* specialized) {
+    std::vector<std::unique_ptr<ExecutionState>>& pool = specialized ? specialized->idle_states : idle_states_;
+    {
+        std::lock_guard<std::mutex> lock(state_pool_mutex_);
+        if (!pool.empty()) {
+            *state = std::move(pool.back());
+            pool.pop_back();
+            return Status::Ok();
         }
     }
-    return shapes;
+    // 新状态的常量取自Value上的张量，与串行路径改写Value互斥
+    const MemoryPlan* memory_plan = specialized ? &specialized->memory_plan : &memory_plan_;
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    return ExecutionState::Create(*execution_plan_, memory_plan->entries.empty() ? nullptr : memory_plan, state,
+                                  memory_account_, options_.huge_page_policy);
 }
 
-std::vector<std::string> InferenceSession::GetInputNames() const {
-    std::vector<std::string> names;
-    if (graph_) {
-        for (Value* input : graph_->GetInputs()) {
-            std::string name = input->GetName();
-            if (name.empty()) {
-                // 如果没有名称，使用默认名称
-                name = "input_" + std::to_string(names.size());
-            }
-            names.push_back(name);
-        }
+void InferenceSession::ReleaseExecutionState(std::unique_ptr<ExecutionState> state,
+                                             ShapeSpecializedPlan* specialized) {
+    std::vector<std::unique_ptr<ExecutionState>>& pool = specialized ? specialized->idle_states : idle_states_;
+    std::lock_guard<std::mutex> lock(state_pool_mutex_);
+    if (pool.size() < static_cast<size_t>(std::max(options_.execution_state_pool_size, 0))) {
+        pool.push_back(std::move(state));
     }
-    return names;
 }
 
-std::vector<std::string> InferenceSession::GetOutputNames() const {
-    std::vector<std::string> names;
-    if (graph_) {
-        for (Value* output : graph_->GetOutputs()) {
-            std::string name = output->GetName();
-            if (name.empty()) {
-                // 如果没有名称，使用默认名称
-                name = "output_" + std::to_string(names.size());
-            }
-            names.push_back(name);
+std::shared_ptr<ShapeSpecializedPlan> InferenceSession::GetShapeSpecializedPlan(const std::vector<Tensor*>& inputs) {
+    if (symbolic_tensors_.empty()) {
+        return nullptr;
+    }
+    std::vector<int64_t> key;
+    for (const Tensor* input : inputs) {
+        if (!input) {
+            return nullptr;
         }
+        const std::vector<int64_t>& dims = input->GetShape().dims;
+        key.push_back(static_cast<int64_t>(dims.size()));
+        key.insert(key.end(), dims.begin(), dims.end());
     }
-    return names;
-}
-
-Status InferenceSession::Run(const std::vector<Tensor*>& inputs, std::vector<Tensor*>& outputs) {
-    if (!graph_) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                           "Model not loaded");
+    {
+        std::lock_guard<std::mutex> lock(specialized_mutex_);
+        auto it = specialized_plans_.find(key);
+        if (it != specialized_plans_.end()) {
+            it->second->last_used = ++specialized_clock_;
+            ++specialized_hits_;
+            return it->second;
+        }
     }
     
-    ExecutionOptions options;
-    options.enable_profiling = options_.enable_profiling;
+    // 符号冲突或秩不符时不特化，由执行时的形状推断报告错误
+    auto plan = std::make_shared<ShapeSpecializedPlan>();
+    if (!BindShapeSymbols(*graph_, inputs, &plan->symbols).IsOk()) {
+        return nullptr;
+    }
+    std::unordered_map<const Value*, std::shared_ptr<Tensor>> tensors;
+    for (const auto& entry : symbolic_tensors_) {
+        const Tensor& symbolic = *entry.second;
+        Shape shape;
+        if (ResolveSymbolicShape(symbolic.GetShape(), plan->symbols, &shape)) {
+            tensors[entry.first] = CreateTensorFromData(shape, symbolic.GetDataType(), nullptr,
+                                                        symbolic.GetLayout(), symbolic.GetDeviceType());
+        }
+    }
+    MemoryPlannerOptions planner_options;
+    planner_options.strategy = options_.memory_plan_strategy;
+    planner_options.tensors = &tensors;
+    TraceScope trace(TraceCategory::MEMORY, "PlanShapeSpecializedMemory");
+    Status status = PlanMemory(graph_.get(), planner_options, &plan->memory_plan);
+    if (!status.IsOk()) {
+        LOG_WARNING("Shape-specialized memory planning failed: " + status.Message());
+        return nullptr;
+    }
+    LOG_INFO("Shape-specialized memory plan: " + std::to_string(plan->memory_plan.entries.size()) +
+             " tensors, arena " + std::to_string(plan->memory_plan.arena_size) + " bytes");
+    arena_high_water_metric_->SetMax(static_cast<int64_t>(plan->memory_plan.arena_size));
     
-    return execution_engine_->Execute(graph_.get(), inputs, outputs, options);
+    std::lock_guard<std::mutex> lock(specialized_mutex_);
+    // 其他线程可能同时创建了同一形状的计划
+    auto inserted = specialized_plans_.emplace(key, plan);
+    inserted.first->second->last_used = ++specialized_clock_;
+    while (specialized_plans_.size() > options_.max_shape_specialized_plans) {
+        auto oldest = specialized_plans_.begin();
+        for (auto it = specialized_plans_.begin(); it != specialized_plans_.end(); ++it) {
+            if (it->second->last_used < oldest->second->last_used) {
+                oldest = it;
+            }
+        }
+        specialized_plans_.erase(oldest);
+    }
+    return inserted.first->second;
+}
+
+size_t InferenceSession::GetNumShapeSpecializedPlans() const {
+    std::lock_guard<std::mutex> lock(specialized_mutex_);
+    return specialized_plans_.size();
+}
+
+uint64_t InferenceSession::GetShapeSpecializedPlanHits() const {
+    std::lock_guard<std::mutex> lock(specialized_mutex_);
+    return specialized_hits_;
+}
+
+size_t InferenceSession::GetNumIdleExecutionStates() const {
+    std::lock_guard<std::mutex> lock(state_pool_mutex_);
+    return idle_states_.size();
 }
 
 Status InferenceSession::Run(const std::unordered_map<std::string, Tensor*>& inputs,
@@ -297,7 +2507,7 @@ Status InferenceSession::Run(const std::unordered_map<std::string, Tensor*>& inp
             size_t index = input_tensors.size();
             name = "input_" + std::to_string(index);
         }
-        
+    
         auto it = inputs.find(name);
         if (it != inputs.end()) {
             input_tensors.push_back(it->second);
@@ -327,13 +2537,193 @@ Status InferenceSession::Run(const std::unordered_map<std::string, Tensor*>& inp
     return Status::Ok();
 }
 
+Status InferenceSession::RunAsync(std::vector<std::shared_ptr<Tensor>> inputs, RunCallback callback) {
+    return RunAsync(RunOptions(), std::move(inputs), std::move(callback));
+}
+
+Status InferenceSession::RunAsync(const RunOptions& run_options, std::vector<std::shared_ptr<Tensor>> inputs,
+                                  RunCallback callback) {
+    if (!callback) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "RunAsync needs a callback");
+    }
+    std::shared_ptr<const LoraBatch> lora;
+    Status lora_status = CreateLoraBatch(run_options, &lora);
+    if (!lora_status.IsOk()) {
+        return lora_status;
+    }
+    if (!BeginAsyncRun()) {
+        return Status::Error(StatusCode::ERROR_RESOURCE_EXHAUSTED, "Too many in-flight async runs");
+    }
+    const CancellationToken::Clock::time_point deadline =
+        run_options.cancellation ? run_options.cancellation->GetDeadline() : CancellationToken::Clock::time_point::max();
+    Status admitted = AdmitAsyncRun(deadline);
+    if (!admitted.IsOk()) {
+        return admitted;
+    }
+    // 输入和callback都移入任务，调用方返回后仍然有效
+    auto task = std::make_shared<std::pair<std::vector<std::shared_ptr<Tensor>>, RunCallback>>(
+        std::move(inputs), std::move(callback));
+    const int64_t enqueue_ns = MetricNowNs();
+    // 作为绑定节点的线程提交，任务进入该节点的线程组
+    NumaNodeScope numa(options_.numa_node, false);
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    // 任务按运行的优先级排队，执行时再作为该优先级的运行参与抢占
+    PriorityScope run_priority(run_options.priority);
+    PriorityScope session_priority(options_.priority, true);
+    const RunPriority priority = PriorityScope::Current();
+    ThreadPool::EnqueueTask([this, task, enqueue_ns, priority, deadline, cancellation = run_options.cancellation,
+                             lora]() {
+        AsyncRunGuard guard([this]() { EndAsyncRun(); });
+        RecordAsyncQueueWait(enqueue_ns);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        // 过载时排队过久的请求已被放弃，剩余时间已不够一次运行的请求由准入控制放弃，不再占用执行资源
+        Status status = cancellation ? cancellation->Check() : Status::Ok();
+        if (admission_ && !status.IsOk()) {
+            admission_->Withdraw();
+        } else if (admission_) {
+            status = StartAdmittedRun(deadline);
+        }
+        if (status.IsOk()) {
+            std::vector<Tensor*> input_ptrs;
+            for (const auto& input : task->first) {
+                input_ptrs.push_back(input.get());
+            }
+            CancellationScope scope(cancellation);
+            PriorityScope priority_scope(priority);
+            LoraScope lora_scope(lora);
+            const int64_t start_ns = MetricNowNs();
+            status = Run(input_ptrs, outputs);
+            if (admission_) {
+                admission_->Finish(status.IsOk() ? static_cast<double>(MetricNowNs() - start_ns) / 1e6 : -1.0);
+            }
+        }
+        task->first.clear();
+        task->second(status, std::move(outputs));
+    });
+    return Status::Ok();
+}
+
+std::future<RunResult> InferenceSession::RunAsync(std::vector<std::shared_ptr<Tensor>> inputs) {
+    return RunAsync(RunOptions(), std::move(inputs));
+}
+
+std::future<RunResult> InferenceSession::RunAsync(const RunOptions& run_options,
+                                                  std::vector<std::shared_ptr<Tensor>> inputs) {
+    auto promise = std::make_shared<std::promise<RunResult>>();
+    std::future<RunResult> future = promise->get_future();
+    Status status = RunAsync(run_options, std::move(inputs),
+                             [promise](Status run_status, std::vector<std::shared_ptr<Tensor>> outputs) {
+        RunResult result;
+        result.status = run_status;
+        result.outputs = std::move(outputs);
+        promise->set_value(std::move(result));
+    });
+    if (!status.IsOk()) {
+        RunResult result;
+        result.status = status;
+        promise->set_value(std::move(result));
+    }
+    return future;
+}
+
 std::future<Status> InferenceSession::RunAsync(const std::vector<Tensor*>& inputs,
                                              std::vector<Tensor*>& outputs) {
-    ExecutionOptions options;
-    options.mode = ExecutionMode::ASYNCHRONOUS;
-    options.enable_profiling = options_.enable_profiling;
-    
-    return execution_engine_->ExecuteAsync(graph_.get(), inputs, outputs, options);
+    auto promise = std::make_shared<std::promise<Status>>();
+    std::future<Status> future = promise->get_future();
+    if (!BeginAsyncRun()) {
+        promise->set_value(Status::Error(StatusCode::ERROR_RESOURCE_EXHAUSTED,
+                                         "Too many in-flight async runs"));
+        return future;
+    }
+    Status admitted = AdmitAsyncRun(CancellationToken::Clock::time_point::max());
+    if (!admitted.IsOk()) {
+        promise->set_value(admitted);
+        return future;
+    }
+    // 经过Run加锁，与其他线程上的Run串行；输入指针按值捕获
+    std::vector<Tensor*>* output_ptr = &outputs;
+    const int64_t enqueue_ns = MetricNowNs();
+    NumaNodeScope numa(options_.numa_node, false);
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    PriorityScope session_priority(options_.priority, true);
+    const RunPriority priority = PriorityScope::Current();
+    ThreadPool::EnqueueTask([this, inputs, output_ptr, promise, enqueue_ns, priority]() {
+        AsyncRunGuard guard([this]() { EndAsyncRun(); });
+        RecordAsyncQueueWait(enqueue_ns);
+        PriorityScope priority_scope(priority);
+        if (!admission_) {
+            promise->set_value(Run(inputs, *output_ptr));
+            return;
+        }
+        // 没有截止时间的请求开始时不会被放弃
+        admission_->Start(CancellationToken::Clock::time_point::max());
+        const int64_t start_ns = MetricNowNs();
+        Status status = Run(inputs, *output_ptr);
+        admission_->Finish(status.IsOk() ? static_cast<double>(MetricNowNs() - start_ns) / 1e6 : -1.0);
+        promise->set_value(status);
+    });
+    return future;
+}
+
+void InferenceSession::RecordAsyncQueueWait(int64_t enqueue_ns) {
+    async_queue_depth_metric_->Add(-1);
+    if (MetricsRegistry::Instance().IsEnabled()) {
+        async_queue_wait_metric_->Record(static_cast<double>(MetricNowNs() - enqueue_ns) / 1000.0);
+    }
+}
+
+size_t InferenceSession::GetNumInflightRuns() const {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    return inflight_runs_;
+}
+
+void InferenceSession::WaitForAsyncRuns() {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    async_cv_.wait(lock, [this] { return inflight_runs_ == 0; });
+}
+
+bool InferenceSession::BeginAsyncRun() {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    if (options_.max_inflight_async_runs > 0 && inflight_runs_ >= options_.max_inflight_async_runs) {
+        return false;
+    }
+    ++inflight_runs_;
+    async_queue_depth_metric_->Add(1);
+    return true;
+}
+
+Status InferenceSession::AdmitAsyncRun(CancellationToken::Clock::time_point deadline) {
+    if (!admission_) {
+        return Status::Ok();
+    }
+    // 同时执行的运行数：支持并发运行时为inter-op池的线程数，否则Run串行执行
+    size_t concurrency = 1;
+    if (SupportsConcurrentRun()) {
+        ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+        concurrency = ThreadPool::GetInterOpThreadCount();
+    }
+    Status status = admission_->Admit(deadline, concurrency);
+    if (!status.IsOk()) {
+        admission_rejected_metric_->Add();
+        async_queue_depth_metric_->Add(-1);
+        EndAsyncRun();
+    }
+    return status;
+}
+
+Status InferenceSession::StartAdmittedRun(CancellationToken::Clock::time_point deadline) {
+    Status status = admission_->Start(deadline);
+    if (!status.IsOk()) {
+        admission_shed_metric_->Add();
+    }
+    return status;
+}
+
+void InferenceSession::EndAsyncRun() {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    if (--inflight_runs_ == 0) {
+        async_cv_.notify_all();
+    }
 }
 
 std::shared_ptr<Tensor> InferenceSession::CreateInputTensor(size_t input_index) {
@@ -342,7 +2732,7 @@ std::shared_ptr<Tensor> InferenceSession::CreateInputTensor(size_t input_index)
     }
     
     Value* input_value = graph_->GetInputs()[input_index];
-    Shape shape = input_value->GetShape();
+    Shape shape = ConcreteInputShape(input_value->GetShape());
     DataType dtype = input_value->GetDataType();
     
     return CreateTensor(shape, dtype);
@@ -358,7 +2748,7 @@ std::shared_ptr<Tensor> InferenceSession::CreateInputTensor(const std::string& i
         return nullptr;
     }
     
-    Shape shape = input_value->GetShape();
+    Shape shape = ConcreteInputShape(input_value->GetShape());
     DataType dtype = input_value->GetDataType();
     
     return CreateTensor(shape, dtype);
@@ -392,18 +2782,67 @@ Status InferenceSession::Profile(ProfilingResult& result) {
                            "Model not loaded");
     }
     
-    // 创建虚拟输入
+    // 创建虚拟输入（未声明类型的输入按FLOAT32）
+    std::vector<std::shared_ptr<Tensor>> dummy_inputs;
     std::vector<Tensor*> inputs;
     for (Value* input_value : graph_->GetInputs()) {
-        auto tensor = CreateTensor(input_value->GetShape(), input_value->GetDataType());
+        const DataType dtype = input_value->GetDataType() == DataType::UNKNOWN ? DataType::FLOAT32
+                                                                                : input_value->GetDataType();
+        auto tensor = CreateTensor(ConcreteInputShape(input_value->GetShape()), dtype);
         tensor->FillZero();
         inputs.push_back(tensor.get());
+        dummy_inputs.push_back(tensor);
     }
     
-    return execution_engine_->Profile(graph_.get(), inputs, result);
+    NumaNodeScope numa(options_.numa_node, BindsCallerThread(options_.numa_node));
+    ThreadPoolScope pools(intra_op_pool_, inter_op_pool_);
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    Status status = EnsureSessionArena();
+    if (!status.IsOk()) {
+        return status;
+    }
+    GraphInputGuard guard(graph_.get());
+    ExecutionOptions options = GetExecutionOptions();
+    options.profile_hardware_counters = options_.profile_hardware_counters;
+    status = execution_plan_ ? execution_engine_->ProfilePlan(*execution_plan_, inputs, result, options)
+                             : execution_engine_->Profile(graph_.get(), inputs, result, options);
+    if (status.IsOk()) {
+        last_memory_timeline_ = result.memory_timeline;
+    }
+    return status;
 }
 
 // 批量推理实现
+std::string InferenceSession::EndProfiling() {
+    if (!options_.enable_profiling) {
+        return std::string();
+    }
+    Tracer& tracer = Tracer::Instance();
+    tracer.Stop();
+    
+    const std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H-%M-%S", std::localtime(&now));
+    const std::string path = options_.profile_file_prefix + "_" + timestamp + ".json";
+    Status status = tracer.WriteChromeTrace(path);
+    if (!status.IsOk()) {
+        LOG_WARNING("Profiling trace not written: " + status.Message());
+        return std::string();
+    }
+    LOG_INFO("Profiling trace written: " + path + " (" + std::to_string(tracer.GetDroppedEventCount()) +
+             " events dropped)");
+    if (!last_memory_timeline_.events.empty()) {
+        const std::string memory_path = options_.profile_file_prefix + "_" + timestamp + "_memory.json";
+        status = last_memory_timeline_.WriteJson(memory_path);
+        if (status.IsOk()) {
+            LOG_INFO("Memory timeline written: " + memory_path);
+        } else {
+            LOG_WARNING("Memory timeline not written: " + status.Message());
+        }
+    }
+    return path;
+}
+
 Status InferenceSession::RunBatch(
     const std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_inputs,
     std::vector<std::vector<std::shared_ptr<Tensor>>>& batch_outputs) {
@@ -435,7 +2874,7 @@ Status InferenceSession::RunBatch(
         if (!status.IsOk()) {
             return status;
         }
-        
+    
         // 转换为shared_ptr
         std::vector<std::shared_ptr<Tensor>> outputs;
         for (Tensor* t : output_ptrs) {
@@ -459,30 +2898,25 @@ Status InferenceSession::RunBatchOptimized(
     size_t batch_size = batch_inputs.size();
     size_t num_inputs = batch_inputs[0].size();
     
-    // 合并batch维度
+    // 合并batch维度：槽位相邻时ConcatBatch返回视图，否则拷入新张量
     std::vector<std::shared_ptr<Tensor>> merged_inputs;
-    
+    std::vector<int64_t> rows(batch_size, 0);
     for (size_t i = 0; i < num_inputs; ++i) {
-        const Shape& ref_shape = batch_inputs[0][i]->GetShape();
-        DataType dtype = batch_inputs[0][i]->GetDataType();
-        
-        std::vector<int64_t> merged_dims = ref_shape.dims;
-        if (merged_dims.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Invalid input shape");
-        }
-        
-        merged_dims[0] = static_cast<int64_t>(batch_size) * merged_dims[0];
-        auto merged_tensor = CreateTensor(Shape(merged_dims), dtype, DeviceType::CPU);
-        
-        size_t sample_size = batch_inputs[0][i]->GetSizeInBytes();
-        uint8_t* merged_data = static_cast<uint8_t*>(merged_tensor->GetData());
-        
+        std::vector<const Tensor*> samples;
         for (size_t b = 0; b < batch_size; ++b) {
-            const void* sample_data = batch_inputs[b][i]->GetData();
-            std::memcpy(merged_data + b * sample_size, sample_data, sample_size);
+            if (batch_inputs[b].size() != num_inputs || !batch_inputs[b][i] ||
+                batch_inputs[b][i]->GetShape().dims.empty()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Invalid input shape");
+            }
+            samples.push_back(batch_inputs[b][i].get());
+            rows[b] = batch_inputs[b][i]->GetShape().dims[0];
+        }
+        auto merged_tensor = ConcatBatch(samples);
+        if (!merged_tensor) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Inputs cannot be merged along the batch dimension");
         }
-        
         merged_inputs.push_back(merged_tensor);
     }
     
@@ -491,44 +2925,120 @@ Status InferenceSession::RunBatchOptimized(
     for (const auto& t : merged_inputs) {
         merged_input_ptrs.push_back(t.get());
     }
-    std::vector<Tensor*> merged_output_ptrs;
-    Status status = Run(merged_input_ptrs, merged_output_ptrs);
+    std::vector<std::shared_ptr<Tensor>> merged_outputs;
+    Status status = Run(merged_input_ptrs, merged_outputs);
     if (!status.IsOk()) {
         return status;
     }
     
-    // 分割输出
+    // 分割输出：按样本切出视图
     batch_outputs.clear();
     batch_outputs.resize(batch_size);
     
-    for (size_t o = 0; o < merged_output_ptrs.size(); ++o) {
-        const Shape& output_shape = merged_output_ptrs[o]->GetShape();
-        DataType dtype = merged_output_ptrs[o]->GetDataType();
-        
-        std::vector<int64_t> sample_dims = output_shape.dims;
-        if (sample_dims.empty()) continue;
-        sample_dims[0] = sample_dims[0] / static_cast<int64_t>(batch_size);
-        
-        size_t element_size = Tensor::GetDataTypeSize(dtype);
-        size_t sample_size = 1;
-        for (int64_t dim : sample_dims) {
-            sample_size *= dim;
-        }
-        sample_size *= element_size;
-        
-        const uint8_t* merged_data = static_cast<const uint8_t*>(merged_output_ptrs[o]->GetData());
-        
+    for (const auto& merged_output : merged_outputs) {
+        auto views = SplitBatch(merged_output, rows);
+        if (views.size() != batch_size) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                               "Output is not batched along dimension 0");
+        }
         for (size_t b = 0; b < batch_size; ++b) {
-            auto sample_tensor = CreateTensor(Shape(sample_dims), dtype, DeviceType::CPU);
-            uint8_t* sample_data = static_cast<uint8_t*>(sample_tensor->GetData());
-            std::memcpy(sample_data, merged_data + b * sample_size, sample_size);
-            batch_outputs[b].push_back(sample_tensor);
+            batch_outputs[b].push_back(views[b]);
         }
     }
     
     return Status::Ok();
 }
 
+Status InferenceSession::PreparePipeline() {
+    if (pipeline_) {
+        return Status::Ok();
+    }
+    if (!graph_ || !execution_plan_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model not loaded");
+    }
+    if (!concurrent_run_) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Pipelined execution needs providers that support concurrent execution "
+                           "and no KV cache");
+    }
+    PipelineOptions pipeline_options;
+    pipeline_options.num_stages = options_.pipeline_num_stages;
+    pipeline_options.queue_capacity = options_.pipeline_queue_capacity;
+    pipeline_options.intra_op_threads_per_stage = options_.pipeline_intra_op_threads;
+    pipeline_options.intra_op_min_work_per_thread = options_.intra_op_min_work_per_thread;
+    // 各micro-batch的执行状态按Value上规划的形状建立arena视图，与串行路径互斥
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    return PipelineExecutor::Create(*execution_plan_,
+                                    memory_plan_.entries.empty() ? nullptr : &memory_plan_,
+                                    pipeline_options, &pipeline_);
+}
+
+Status InferenceSession::RunPipelined(
+    const std::vector<std::vector<std::shared_ptr<Tensor>>>& micro_batches,
+    std::vector<std::vector<std::shared_ptr<Tensor>>>& outputs) {
+    std::vector<std::vector<Tensor*>> input_ptrs(micro_batches.size());
+    for (size_t i = 0; i < micro_batches.size(); ++i) {
+        for (const auto& input : micro_batches[i]) {
+            input_ptrs[i].push_back(input.get());
+        }
+    }
+    if (pipeline_parallel_) {
+        return pipeline_parallel_->Run(input_ptrs, &outputs);
+    }
+    
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    Status status = PreparePipeline();
+    if (!status.IsOk()) {
+        return status;
+    }
+    outputs.assign(micro_batches.size(), {});
+    const ExecutionPlan& plan = *execution_plan_;
+    return pipeline_->Run(input_ptrs, [&outputs, &plan](size_t index, ExecutionState* state) {
+        std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+        for (int slot : plan.GetOutputSlots()) {
+            if (!tensors[slot]) {
+                continue;
+            }
+            std::shared_ptr<Tensor> output;
+            Status status = DetachOutput(plan.GetValues()[slot], &tensors[slot], &output);
+            if (!status.IsOk()) {
+                return status;
+            }
+            outputs[index].push_back(output);
+        }
+        return Status::Ok();
+    });
+}
+
+Status InferenceSession::CalibratePipeline(const std::vector<std::shared_ptr<Tensor>>& inputs) {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    Status status = PreparePipeline();
+    if (!status.IsOk()) {
+        return status;
+    }
+    std::vector<Tensor*> input_ptrs;
+    for (const auto& input : inputs) {
+        input_ptrs.push_back(input.get());
+    }
+    return pipeline_->Calibrate(input_ptrs);
+}
+
+std::vector<std::shared_ptr<Tensor>> InferenceSession::CreateBatchInputTensors(size_t input_index,
+                                                                               size_t batch_size) {
+    auto sample = CreateInputTensor(input_index);
+    if (!sample || sample->GetShape().dims.empty() || batch_size == 0) {
+        return {};
+    }
+    std::vector<int64_t> dims = sample->GetShape().dims;
+    const int64_t rows = dims[0] > 0 ? dims[0] : 1;
+    dims[0] = rows * static_cast<int64_t>(batch_size);
+    auto batch = CreateTensor(Shape(dims), sample->GetDataType());
+    if (!batch->GetData()) {
+        return {};
+    }
+    return SplitBatch(batch, std::vector<int64_t>(batch_size, rows));
+}
+
 void InferenceSession::SetOptions(const SessionOptions& options) {
     options_ = options;
     // 重新初始化 (参考ONNX Runtime的配置更新)
@@ -5,6 +5,7 @@
 #include <queue>
 #include <sstream>
 #include <fstream>
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -20,9 +21,62 @@ DataType Value::GetDataType() const {
     return tensor_ ? tensor_->GetDataType() : DataType::UNKNOWN;
 }
 
+std::shared_ptr<Tensor> Value::GetMutableTensor() {
+    if (!tensor_shared_ || !tensor_ || !tensor_->GetData()) {
+        tensor_shared_ = false;
+        return tensor_;
+    }
+    std::shared_ptr<Tensor> copy;
+    if (!tensor_->IsContiguous()) {
+        copy = MakeContiguous(tensor_);  // 按行主序拷成新的张量
+    } else {
+        auto storage = CreateTensor(tensor_->GetShape(), tensor_->GetDataType(), tensor_->GetDeviceType());
+        if (storage && storage->CopyFrom(*tensor_).IsOk()) {
+            // 保留布局：包装为持有storage的张量
+            copy.reset(new Tensor(tensor_->GetShape(), tensor_->GetDataType(), storage->GetData(),
+                                  tensor_->GetLayout(), tensor_->GetDeviceType()),
+                       [storage](Tensor* view) { delete view; });
+        }
+    }
+    if (!copy) {
+        return nullptr;  // 无法复制（如非CPU的非连续张量），调用方不能原地修改
+    }
+    SetTensor(copy);
+    return tensor_;
+}
+
+void Value::SetId(int64_t id) {
+    if (graph_ && !removed_) {
+        graph_->OnValueKeyChanged(this, id, name_);
+    }
+    id_ = id;
+}
+
+void Value::SetName(const std::string& name) {
+    if (graph_ && !removed_) {
+        graph_->OnValueKeyChanged(this, id_, name);
+    }
+    name_ = name;
+}
+
+void Value::SetProducer(Node* node) {
+    producer_ = node;
+    if (!node) {
+        return;
+    }
+    for (Node* consumer : consumers_) {
+        if (consumer->graph_) {
+            consumer->graph_->OnEdgeAdded(node, consumer);
+        }
+    }
+}
+
 void Value::AddConsumer(Node* node) {
     if (std::find(consumers_.begin(), consumers_.end(), node) == consumers_.end()) {
         consumers_.push_back(node);
+        if (producer_ && node->graph_) {
+            node->graph_->OnEdgeAdded(producer_, node);
+        }
     }
 }
 
@@ -34,11 +88,24 @@ void Value::RemoveConsumer(Node* node) {
 }
 
 // Node实现
-void Node::AddInput(Value* value) {
-    if (std::find(inputs_.begin(), inputs_.end(), value) == inputs_.end()) {
-        inputs_.push_back(value);
-        value->AddConsumer(this);
+void Node::SetId(int64_t id) {
+    if (graph_ && !removed_) {
+        graph_->OnNodeKeyChanged(this, id, name_);
+    }
+    id_ = id;
+}
+
+void Node::SetName(const std::string& name) {
+    if (graph_ && !removed_) {
+        graph_->OnNodeKeyChanged(this, id_, name);
     }
+    name_ = name;
+}
+
+void Node::AddInput(Value* value) {
+    // 同一个值可以占多个输入位置（如Mul(x, x)），消费者只记录一次
+    inputs_.push_back(value);
+    value->AddConsumer(this);
 }
 
 void Node::AddOutput(Value* value) {
@@ -56,6 +123,16 @@ void Node::RemoveInput(Value* value) {
     value->RemoveConsumer(this);
 }
 
+void Node::ReplaceInput(Value* old_value, Value* new_value) {
+    if (old_value == new_value ||
+        std::find(inputs_.begin(), inputs_.end(), old_value) == inputs_.end()) {
+        return;
+    }
+    std::replace(inputs_.begin(), inputs_.end(), old_value, new_value);
+    old_value->RemoveConsumer(this);
+    new_value->AddConsumer(this);
+}
+
 void Node::RemoveOutput(Value* value) {
     outputs_.erase(
         std::remove(outputs_.begin(), outputs_.end(), value),
@@ -66,13 +143,22 @@ void Node::RemoveOutput(Value* value) {
     }
 }
 
-void Node::SetAttribute(const std::string& key, const std::string& value) {
+void Node::SetAttribute(const std::string& key, const AttributeValue& value) {
     attributes_[key] = value;
 }
 
+void Node::SetAttribute(const std::string& key, const std::string& value) {
+    attributes_[key] = ParseNodeAttribute(value);
+}
+
 std::string Node::GetAttribute(const std::string& key, const std::string& default_value) const {
     auto it = attributes_.find(key);
-    return it != attributes_.end() ? it->second : default_value;
+    return it != attributes_.end() ? it->second.ToString() : default_value;
+}
+
+const AttributeValue* Node::FindAttribute(const std::string& key) const {
+    auto it = attributes_.find(key);
+    return it != attributes_.end() ? &it->second : nullptr;
 }
 
 bool Node::HasAttribute(const std::string& key) const {
@@ -85,32 +171,153 @@ Graph::Graph() : next_node_id_(0), next_value_id_(0) {
 
 Graph::~Graph() = default;
 
+Graph::Graph(Graph&& other) noexcept : Graph() {
+    *this = std::move(other);
+}
+
+Graph& Graph::operator=(Graph&& other) noexcept {
+    if (this != &other) {
+        nodes_ = std::move(other.nodes_);
+        values_ = std::move(other.values_);
+        removed_nodes_ = other.removed_nodes_;
+        removed_values_ = other.removed_values_;
+        node_ids_ = std::move(other.node_ids_);
+        node_names_ = std::move(other.node_names_);
+        value_ids_ = std::move(other.value_ids_);
+        value_names_ = std::move(other.value_names_);
+        inputs_ = std::move(other.inputs_);
+        outputs_ = std::move(other.outputs_);
+        topo_order_ = std::move(other.topo_order_);
+        topo_valid_ = other.topo_valid_;
+        next_node_id_ = other.next_node_id_;
+        next_value_id_ = other.next_value_id_;
+        other.Clear();
+        AdoptElements();
+    }
+    return *this;
+}
+
+void Graph::AdoptElements() {
+    for (const auto& node : nodes_) {
+        node->graph_ = this;
+    }
+    for (const auto& value : values_) {
+        value->graph_ = this;
+    }
+}
+
+void Graph::OnNodeKeyChanged(Node* node, int64_t new_id, const std::string& new_name) {
+    const bool appended = node->slot_ + 1 == nodes_.size();
+    if (new_id != node->id_) {
+        node_ids_.Erase(node->id_, node);
+        node_ids_.Insert(new_id, node, appended);
+    }
+    if (new_name != node->name_) {
+        if (!node->name_.empty()) {
+            node_names_.Erase(node->name_, node);
+        }
+        if (!new_name.empty()) {
+            node_names_.Insert(new_name, node, appended);
+        }
+    }
+}
+
+void Graph::OnValueKeyChanged(Value* value, int64_t new_id, const std::string& new_name) {
+    const bool appended = value->slot_ + 1 == values_.size();
+    if (new_id != value->id_) {
+        value_ids_.Erase(value->id_, value);
+        value_ids_.Insert(new_id, value, appended);
+    }
+    if (new_name != value->name_) {
+        if (!value->name_.empty()) {
+            value_names_.Erase(value->name_, value);
+        }
+        if (!new_name.empty()) {
+            value_names_.Insert(new_name, value, appended);
+        }
+    }
+}
+
+void Graph::Compact() const {
+    if (removed_nodes_ > 0) {
+        // 先从拓扑序中去掉墓碑，之后墓碑节点才会被释放
+        if (topo_valid_) {
+            topo_order_.erase(std::remove_if(topo_order_.begin(), topo_order_.end(),
+                                             [](const Node* n) { return n->removed_; }),
+                              topo_order_.end());
+            for (size_t i = 0; i < topo_order_.size(); ++i) {
+                topo_order_[i]->topo_rank_ = i;
+            }
+        }
+        nodes_.erase(std::remove_if(nodes_.begin(), nodes_.end(),
+                                    [](const std::unique_ptr<Node>& n) { return n->removed_; }),
+                     nodes_.end());
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            nodes_[i]->slot_ = i;
+        }
+        removed_nodes_ = 0;
+    }
+    if (removed_values_ > 0) {
+        values_.erase(std::remove_if(values_.begin(), values_.end(),
+                                     [](const std::unique_ptr<Value>& v) { return v->removed_; }),
+                      values_.end());
+        for (size_t i = 0; i < values_.size(); ++i) {
+            values_[i]->slot_ = i;
+        }
+        removed_values_ = 0;
+    }
+}
+
 Node* Graph::AddNode(const std::string& op_type, const std::string& name) {
     auto node = std::make_unique<Node>(GenerateNodeId(), op_type, name);
     Node* ptr = node.get();
+    ptr->graph_ = this;
+    ptr->slot_ = nodes_.size();
     nodes_.push_back(std::move(node));
+    node_ids_.Insert(ptr->GetId(), ptr, true);
+    // 新节点还没有连接，排在末尾不破坏拓扑序
+    if (topo_valid_) {
+        ptr->topo_rank_ = topo_order_.size();
+        topo_order_.push_back(ptr);
+    }
+    if (!name.empty()) {
+        node_names_.Insert(name, ptr, true);
+    }
     return ptr;
 }
 
 Node* Graph::GetNode(int64_t id) const {
-    for (const auto& node : nodes_) {
-        if (node->GetId() == id) {
-            return node.get();
+    return node_ids_.Find(id, [this](LookupIndex<int64_t, Node>& index) {
+        for (const auto& node : nodes_) {
+            if (!node->removed_) {
+                index.Insert(node->GetId(), node.get(), true);
+            }
         }
-    }
-    return nullptr;
+    });
 }
 
 Node* Graph::GetNodeByName(const std::string& name) const {
-    for (const auto& node : nodes_) {
-        if (node->GetName() == name) {
-            return node.get();
+    if (name.empty()) {
+        for (const auto& node : nodes_) {
+            if (!node->removed_ && node->GetName().empty()) {
+                return node.get();
+            }
         }
+        return nullptr;
     }
-    return nullptr;
+    return node_names_.Find(name, [this](LookupIndex<std::string, Node>& index) {
+        for (const auto& node : nodes_) {
+            if (!node->removed_ && !node->GetName().empty()) {
+                index.Insert(node->GetName(), node.get(), true);
+            }
+        }
+    });
 }
 
 void Graph::RemoveNode(Node* node) {
+    if (!node || node->graph_ != this || node->removed_) {
+        return;
+    }
     // 断开连接
     for (Value* input : node->GetInputs()) {
         input->RemoveConsumer(node);
@@ -121,36 +328,45 @@ void Graph::RemoveNode(Node* node) {
         }
     }
     
-    // 移除节点
-    nodes_.erase(
-        std::remove_if(nodes_.begin(), nodes_.end(),
-                      [node](const std::unique_ptr<Node>& n) { return n.get() == node; }),
-        nodes_.end()
-    );
+    // 留下墓碑，压缩时释放
+    node_ids_.Erase(node->GetId(), node);
+    if (!node->GetName().empty()) {
+        node_names_.Erase(node->GetName(), node);
+    }
+    node->removed_ = true;
+    ++removed_nodes_;
 }
 
 Value* Graph::AddValue() {
     auto value = std::make_unique<Value>(GenerateValueId());
     Value* ptr = value.get();
+    ptr->graph_ = this;
+    ptr->slot_ = values_.size();
     values_.push_back(std::move(value));
+    value_ids_.Insert(ptr->GetId(), ptr, true);
     return ptr;
 }
 
 Value* Graph::GetValue(int64_t id) const {
-    for (const auto& value : values_) {
-        if (value->GetId() == id) {
-            return value.get();
+    return value_ids_.Find(id, [this](LookupIndex<int64_t, Value>& index) {
+        for (const auto& value : values_) {
+            if (!value->removed_) {
+                index.Insert(value->GetId(), value.get(), true);
+            }
         }
-    }
-    return nullptr;
+    });
 }
 
 void Graph::RemoveValue(Value* value) {
-    // 断开连接
+    if (!value || value->graph_ != this || value->removed_) {
+        return;
+    }
+    // 断开连接（RemoveInput会修改消费者列表，先复制）
     if (Node* producer = value->GetProducer()) {
         producer->RemoveOutput(value);
     }
-    for (Node* consumer : value->GetConsumers()) {
+    std::vector<Node*> consumers = value->GetConsumers();
+    for (Node* consumer : consumers) {
         consumer->RemoveInput(value);
     }
     
@@ -158,12 +374,13 @@ void Graph::RemoveValue(Value* value) {
     inputs_.erase(std::remove(inputs_.begin(), inputs_.end(), value), inputs_.end());
     outputs_.erase(std::remove(outputs_.begin(), outputs_.end(), value), outputs_.end());
     
-    // 移除值
-    values_.erase(
-        std::remove_if(values_.begin(), values_.end(),
-                      [value](const std::unique_ptr<Value>& v) { return v.get() == value; }),
-        values_.end()
-    );
+    // 留下墓碑，压缩时释放
+    value_ids_.Erase(value->GetId(), value);
+    if (!value->GetName().empty()) {
+        value_names_.Erase(value->GetName(), value);
+    }
+    value->removed_ = true;
+    ++removed_values_;
 }
 
 void Graph::AddInput(Value* value) {
@@ -178,16 +395,33 @@ void Graph::AddOutput(Value* value) {
     }
 }
 
+void Graph::ReplaceInput(Value* old_value, Value* new_value) {
+    std::replace(inputs_.begin(), inputs_.end(), old_value, new_value);
+}
+
+void Graph::ReplaceOutput(Value* old_value, Value* new_value) {
+    std::replace(outputs_.begin(), outputs_.end(), old_value, new_value);
+}
+
 void Graph::Clear() {
     nodes_.clear();
     values_.clear();
+    removed_nodes_ = 0;
+    removed_values_ = 0;
+    node_ids_.Clear();
+    node_names_.Clear();
+    value_ids_.Clear();
+    value_names_.Clear();
     inputs_.clear();
     outputs_.clear();
+    topo_order_.clear();
+    topo_valid_ = false;
     next_node_id_ = 0;
     next_value_id_ = 0;
 }
 
 Graph Graph::Clone() const {
+    Compact();
     Graph new_graph;
     
     // 创建Value映射（旧Value -> 新Value）
@@ -197,9 +431,19 @@ Graph Graph::Clone() const {
     for (const auto& value : values_) {
         Value* new_value = new_graph.AddValue();
         new_value->SetId(value->GetId());
-        
-        // 复制形状和数据类型信息
-        // 注意：Tensor不复制，因为这是图结构的拷贝
+        new_value->SetName(value->GetName());
+    
+        // 常量按引用共享，两边都标记为共享（写时复制）；其余的值换成只有形状、类型与布局的新张量，
+        // 副本上绑定或推断的张量不会出现在原图中
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        if (tensor && !value->GetProducer() && tensor->GetData()) {
+            new_value->SetTensor(tensor);
+            new_value->tensor_shared_ = true;
+            value->tensor_shared_ = true;
+        } else if (tensor) {
+            new_value->SetTensor(std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr,
+                                                          tensor->GetLayout(), tensor->GetDeviceType()));
+        }
         value_map[value.get()] = new_value;
     }
     
@@ -208,28 +452,28 @@ Graph Graph::Clone() const {
     for (const auto& node : nodes_) {
         Node* new_node = new_graph.AddNode(node->GetOpType(), node->GetName());
         new_node->SetId(node->GetId());
-        
+    
         // 复制属性
         for (const auto& attr : node->GetAttributes()) {
             new_node->SetAttribute(attr.first, attr.second);
         }
-        
+    
         // 复制设备类型
         new_node->SetDevice(node->GetDevice());
-        
+    
         node_map[node.get()] = new_node;
     }
     
     // 3. 连接输入输出
     for (const auto& node : nodes_) {
         Node* new_node = node_map[node.get()];
-        
+    
         // 连接输入
         for (Value* input : node->GetInputs()) {
             Value* new_input = value_map[input];
             new_node->AddInput(new_input);
         }
-        
+    
         // 连接输出
         for (Value* output : node->GetOutputs()) {
             Value* new_output = value_map[output];
@@ -250,38 +494,42 @@ Graph Graph::Clone() const {
 
 std::vector<Node*> Graph::TopologicalSort() const {
     std::vector<Node*> sorted;
-    std::unordered_map<Node*, int> in_degree;
+    sorted.reserve(nodes_.size() - removed_nodes_);
+    // 入度按节点下标存放在稠密数组中
+    std::vector<int> in_degree(nodes_.size(), 0);
     
-    // 计算入度
+    // 计算入度；就绪队列按节点下标出队，结果只由节点顺序决定
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> queue;
     for (const auto& node : nodes_) {
-        in_degree[node.get()] = 0;
-    }
-    for (const auto& node : nodes_) {
-        for (Value* input : node->GetInputs()) {
-            if (Node* producer = input->GetProducer()) {
-                in_degree[node.get()]++;
+        if (node->removed_) {
+            continue;
+        }
+        // 同一个Value可能在输入中出现多次（如Add(x, x)），而消费者列表去重，只计一次
+        const auto& inputs = node->GetInputs();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (inputs[i]->GetProducer() &&
+                std::find(inputs.begin(), inputs.begin() + i, inputs[i]) == inputs.begin() + i) {
+                in_degree[node->slot_]++;
             }
         }
-    }
-    
-    // 拓扑排序
-    std::queue<Node*> queue;
-    for (const auto& node : nodes_) {
-        if (in_degree[node.get()] == 0) {
-            queue.push(node.get());
+        if (in_degree[node->slot_] == 0) {
+            queue.push(node->slot_);
         }
     }
     
+    // 拓扑排序
     while (!queue.empty()) {
-        Node* node = queue.front();
+        Node* node = nodes_[queue.top()].get();
         queue.pop();
         sorted.push_back(node);
-        
+    
         for (Value* output : node->GetOutputs()) {
             for (Node* consumer : output->GetConsumers()) {
-                in_degree[consumer]--;
-                if (in_degree[consumer] == 0) {
-                    queue.push(consumer);
+                if (consumer->graph_ != this || consumer->removed_) {
+                    continue;
+                }
+                if (--in_degree[consumer->slot_] == 0) {
+                    queue.push(consumer->slot_);
                 }
             }
         }
@@ -290,7 +538,143 @@ std::vector<Node*> Graph::TopologicalSort() const {
     return sorted;
 }
 
+Status Graph::ReorderNodes(const std::vector<Node*>& order) {
+    Compact();
+    if (order.size() != nodes_.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node order must cover every node once");
+    }
+    std::vector<bool> seen(nodes_.size(), false);
+    for (const Node* node : order) {
+        if (!node || node->graph_ != this || seen[node->slot_]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node order must cover every node once");
+        }
+        seen[node->slot_] = true;
+    }
+    std::vector<std::unique_ptr<Node>> reordered;
+    reordered.reserve(nodes_.size());
+    for (Node* node : order) {
+        reordered.push_back(std::move(nodes_[node->slot_]));
+    }
+    nodes_ = std::move(reordered);
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        nodes_[i]->slot_ = i;
+    }
+    // 同名节点的“最早添加”按列表顺序重建
+    node_names_.Clear();
+    node_ids_.Clear();
+    for (const auto& node : nodes_) {
+        node_ids_.Insert(node->GetId(), node.get(), true);
+        if (!node->GetName().empty()) {
+            node_names_.Insert(node->GetName(), node.get(), true);
+        }
+    }
+    topo_valid_ = false;
+    return Status::Ok();
+}
+
+std::vector<Node*> Graph::GetTopologicalOrder() const {
+    if (!topo_valid_) {
+        std::vector<Node*> sorted = TopologicalSort();
+        if (sorted.size() != nodes_.size() - removed_nodes_) {
+            return sorted;  // 有环：不缓存
+        }
+        topo_order_ = sorted;
+        for (size_t i = 0; i < topo_order_.size(); ++i) {
+            topo_order_[i]->topo_rank_ = i;
+        }
+        topo_valid_ = true;
+        return sorted;
+    }
+    std::vector<Node*> order;
+    order.reserve(nodes_.size() - removed_nodes_);
+    for (Node* node : topo_order_) {
+        if (!node->removed_) {
+            order.push_back(node);
+        }
+    }
+    return order;
+}
+
+void Graph::OnEdgeAdded(Node* from, Node* to) {
+    if (!topo_valid_ || to->removed_) {
+        return;
+    }
+    if (from->graph_ != this || from->removed_ || from == to) {
+        topo_valid_ = false;
+        return;
+    }
+    if (from->topo_rank_ > to->topo_rank_) {
+        ReorderTopological(from, to);
+    }
+}
+
+void Graph::ReorderTopological(Node* from, Node* to) {
+    // 只有拓扑序位于[to, from]之间的节点可能需要移动：
+    // 从to向后能到达的节点（forward）必须整体排到从from向前能到达的节点（backward）之后
+    const size_t lower = to->topo_rank_;
+    const size_t upper = from->topo_rank_;
+    std::vector<Node*> forward;
+    std::vector<Node*> backward;
+    std::unordered_set<const Node*> visited = {to};
+    std::vector<Node*> stack = {to};
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        forward.push_back(node);
+        for (Value* output : node->outputs_) {
+            for (Node* consumer : output->consumers_) {
+                if (consumer == from) {
+                    topo_valid_ = false;  // 新边形成环
+                    return;
+                }
+                if (consumer->graph_ == this && !consumer->removed_ && consumer->topo_rank_ < upper &&
+                    visited.insert(consumer).second) {
+                    stack.push_back(consumer);
+                }
+            }
+        }
+    }
+    visited = {from};
+    stack = {from};
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        backward.push_back(node);
+        for (Value* input : node->inputs_) {
+            Node* producer = input->producer_;
+            if (producer && producer->graph_ == this && !producer->removed_ &&
+                producer->topo_rank_ > lower && visited.insert(producer).second) {
+                stack.push_back(producer);
+            }
+        }
+    }
+    
+    // 两组各自保持原有相对顺序，复用它们原来占据的位置
+    auto by_rank = [](const Node* a, const Node* b) { return a->topo_rank_ < b->topo_rank_; };
+    std::sort(forward.begin(), forward.end(), by_rank);
+    std::sort(backward.begin(), backward.end(), by_rank);
+    std::vector<size_t> ranks;
+    ranks.reserve(forward.size() + backward.size());
+    for (const Node* node : backward) {
+        ranks.push_back(node->topo_rank_);
+    }
+    for (const Node* node : forward) {
+        ranks.push_back(node->topo_rank_);
+    }
+    std::sort(ranks.begin(), ranks.end());
+    size_t next = 0;
+    for (Node* node : backward) {
+        node->topo_rank_ = ranks[next++];
+        topo_order_[node->topo_rank_] = node;
+    }
+    for (Node* node : forward) {
+        node->topo_rank_ = ranks[next++];
+        topo_order_[node->topo_rank_] = node;
+    }
+}
+
 Status Graph::Validate() const {
+    Compact();
     // 1. 检查所有输入都有生产者或是图输入或是初始值（权重）
     for (const auto& node : nodes_) {
         for (Value* input : node->GetInputs()) {
@@ -299,7 +683,7 @@ Status Graph::Validate() const {
                 bool is_graph_input = std::find(inputs_.begin(), inputs_.end(), input) != inputs_.end();
                 // 检查是否是初始值（权重）- 有Tensor但没有生产者
                 bool is_initializer = (input->GetTensor() != nullptr);
-                
+    
                 if (!is_graph_input && !is_initializer) {
                     return Status::Error(StatusCode::ERROR_INVALID_MODEL,
                                        "Input value has no producer and is not a graph input");
@@ -314,7 +698,7 @@ Status Graph::Validate() const {
             // 这是节点的输出
             bool is_graph_output = std::find(outputs_.begin(), outputs_.end(), value.get()) != outputs_.end();
             bool has_consumers = !value->GetConsumers().empty();
-            
+    
             if (!is_graph_output && !has_consumers) {
                 // 死代码（未使用的输出），这是警告而不是错误
                 // 可以继续执行，但建议优化
@@ -352,30 +736,16 @@ Status Graph::Validate() const {
         value_ids.insert(id);
     }
     
-    // 5. 检查输入输出Value在values_中存在
+    // 5. 检查输入输出Value属于本图
     for (Value* input : inputs_) {
-        bool found = false;
-        for (const auto& value : values_) {
-            if (value.get() == input) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
+        if (input->graph_ != this || input->removed_) {
             return Status::Error(StatusCode::ERROR_INVALID_MODEL,
                                "Graph input value not found in values list");
         }
     }
     
     for (Value* output : outputs_) {
-        bool found = false;
-        for (const auto& value : values_) {
-            if (value.get() == output) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
+        if (output->graph_ != this || output->removed_) {
             return Status::Error(StatusCode::ERROR_INVALID_MODEL,
                                "Graph output value not found in values list");
         }
@@ -397,6 +767,7 @@ Status Graph::Validate() const {
 }
 
 Status Graph::Serialize(const std::string& filepath) const {
+    Compact();
     // 使用简单的文本格式序列化（参考ONNX的文本格式）
     // 格式：
     // Graph {
@@ -442,30 +813,30 @@ Status Graph::Serialize(const std::string& filepath) const {
         file << "      id: " << node->GetId() << "\n";
         file << "      op_type: \"" << node->GetOpType() << "\"\n";
         file << "      name: \"" << node->GetName() << "\"\n";
-        
+    
         file << "      inputs: [";
         for (size_t i = 0; i < node->GetInputs().size(); ++i) {
             file << node->GetInputs()[i]->GetId();
             if (i < node->GetInputs().size() - 1) file << ", ";
         }
         file << "]\n";
-        
+    
         file << "      outputs: [";
         for (size_t i = 0; i < node->GetOutputs().size(); ++i) {
             file << node->GetOutputs()[i]->GetId();
             if (i < node->GetOutputs().size() - 1) file << ", ";
         }
         file << "]\n";
-        
+    
         file << "      attrs: {";
         bool first = true;
         for (const auto& attr : node->GetAttributes()) {
             if (!first) file << ", ";
-            file << "\"" << attr.first << "\": \"" << attr.second << "\"";
+            file << "\"" << attr.first << "\": \"" << attr.second.ToString() << "\"";
             first = false;
         }
         file << "}\n";
-        
+    
         file << "    }\n";
     }
     file << "  ]\n";
@@ -475,7 +846,7 @@ Status Graph::Serialize(const std::string& filepath) const {
     for (const auto& value : values_) {
         file << "    Value {\n";
         file << "      id: " << value->GetId() << "\n";
-        
+    
         const Shape& shape = value->GetShape();
         file << "      shape: [";
         for (size_t i = 0; i < shape.dims.size(); ++i) {
@@ -483,7 +854,7 @@ Status Graph::Serialize(const std::string& filepath) const {
             if (i < shape.dims.size() - 1) file << ", ";
         }
         file << "]\n";
-        
+    
         file << "      dtype: " << static_cast<int>(value->GetDataType()) << "\n";
         file << "    }\n";
     }
@@ -524,9 +895,9 @@ Status Graph::Deserialize(const std::string& filepath) {
             line.pop_back();
         }
         line.erase(line.find_last_not_of(" \t") + 1);
-        
+    
         if (line.empty() || line[0] == '#') continue;
-        
+    
         // 解析输入
         if (line.find("inputs: [") != std::string::npos) {
             std::string ids_str = line.substr(line.find('[') + 1);
@@ -556,7 +927,7 @@ Status Graph::Deserialize(const std::string& filepath) {
             int64_t node_id = -1;
             std::string op_type, name;
             std::vector<int64_t> input_value_ids, output_value_ids;
-            
+    
             while (std::getline(file, line) && line.find("}") == std::string::npos) {
                 line.erase(0, line.find_first_not_of(" \t"));
                 if (line.find("id:") != std::string::npos) {
@@ -590,12 +961,12 @@ Status Graph::Deserialize(const std::string& filepath) {
                     }
                 }
             }
-            
+    
             if (node_id >= 0 && !op_type.empty()) {
                 Node* node = AddNode(op_type, name);
                 node->SetId(node_id);
                 node_map[node_id] = node;
-                
+    
                 // 创建或获取Value
                 for (int64_t vid : input_value_ids) {
                     if (value_map.find(vid) == value_map.end()) {
@@ -671,16 +1042,25 @@ Value* Graph::FindValueByName(const std::string& name) const {
     }
     
     // 在所有值中查找
-    for (const auto& value : values_) {
-        if (value && value->GetName() == name) {
-            return value.get();
+    if (name.empty()) {
+        for (const auto& value : values_) {
+            if (!value->removed_ && value->GetName().empty()) {
+                return value.get();
+            }
         }
+        return nullptr;
     }
-    
-    return nullptr;
+    return value_names_.Find(name, [this](LookupIndex<std::string, Value>& index) {
+        for (const auto& value : values_) {
+            if (!value->removed_ && !value->GetName().empty()) {
+                index.Insert(value->GetName(), value.get(), true);
+            }
+        }
+    });
 }
 
 std::string Graph::ToDot() const {
+    Compact();
     std::ostringstream oss;
     oss << "digraph G {\n";
     
@@ -0,0 +1,26 @@
+// 内部哈希工具：优化模型缓存文件名与各后端的编译缓存键共用同一个哈希函数
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace inferunity {
+
+constexpr uint64_t kFnv1aOffsetBasis = 0xcbf29ce484222325ULL;
+
+// 64位FNV-1a，把data起的size个字节混入hash；首次调用传kFnv1aOffsetBasis，可链式调用合并多段内容
+inline uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+inline uint64_t HashBytes(uint64_t hash, const std::string& bytes) {
+    return HashBytes(hash, bytes.data(), bytes.size());
+}
+
+} // namespace inferunity
@@ -0,0 +1,88 @@
+// 输入输出绑定实现
+// 参考ONNX Runtime的IoBinding：绑定时按名称定位图输入输出并校验一次，
+// 输出缓冲在Run时交给ExecutionState，由生产它的算子直接写入
+
+#include "inferunity/engine.h"
+
+namespace inferunity {
+
+IOBinding::IOBinding(const InferenceSession* session)
+    : session_(session), graph_(session->GetGraph()),
+      input_names_(session->GetInputNames()), output_names_(session->GetOutputNames()),
+      inputs_(input_names_.size()), bound_outputs_(output_names_.size()) {}
+
+int IOBinding::FindIndex(const std::vector<std::string>& names, const std::string& name) const {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+Status IOBinding::BindInput(const std::string& name, std::shared_ptr<Tensor> tensor) {
+    if (!graph_ || session_->GetGraph() != graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "IOBinding does not belong to the loaded model");
+    }
+    const int index = FindIndex(input_names_, name);
+    if (index < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown input: " + name);
+    }
+    if (!tensor || !tensor->GetData()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Input buffer is empty: " + name);
+    }
+    
+    // 模型声明了类型和秩时校验一次；具体维度（如batch）允许与加载时不同
+    const Value* value = graph_->GetInputs()[index];
+    if (value->GetTensor()) {
+        if (value->GetDataType() != tensor->GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Input data type mismatch: " + name);
+        }
+        if (value->GetShape().dims.size() != tensor->GetShape().dims.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Input rank mismatch: " + name);
+        }
+    }
+    inputs_[index] = std::move(tensor);
+    return Status::Ok();
+}
+
+Status IOBinding::BindOutput(const std::string& name, std::shared_ptr<Tensor> tensor) {
+    if (!graph_ || session_->GetGraph() != graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "IOBinding does not belong to the loaded model");
+    }
+    const int index = FindIndex(output_names_, name);
+    if (index < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown output: " + name);
+    }
+    if (!tensor || !tensor->GetData()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Output buffer is empty: " + name);
+    }
+    // 形状在执行时与推断结果比较，不符时在写入前报错
+    bound_outputs_[index] = std::move(tensor);
+    return Status::Ok();
+}
+
+void IOBinding::ClearBoundInputs() {
+    for (auto& tensor : inputs_) {
+        tensor.reset();
+    }
+}
+
+void IOBinding::ClearBoundOutputs() {
+    for (auto& tensor : bound_outputs_) {
+        tensor.reset();
+    }
+    outputs_.clear();
+}
+
+std::shared_ptr<Tensor> IOBinding::GetOutput(const std::string& name) const {
+    const int index = FindIndex(output_names_, name);
+    if (index < 0 || static_cast<size_t>(index) >= outputs_.size()) {
+        return nullptr;
+    }
+    return outputs_[index];
+}
+
+} // namespace inferunity
@@ -0,0 +1,240 @@
+// KV cache实现
+// 参考ONNX Runtime GroupQueryAttention的共享缓冲：缓冲在创建时按最大长度一次分配，
+// 序列的追加、截断与清空只修改长度，Fork按已缓存长度逐行复制
+
+#include "inferunity/kv_cache.h"
+#include "inferunity/graph.h"
+#include <algorithm>
+#include <cstring>
+
+namespace inferunity {
+
+KVCache::KVCache(const KVCacheOptions& options) : options_(options) {}
+
+Status KVCache::AddLayer(int64_t kv_heads, int64_t key_dim, int64_t value_dim, KVCacheLayer** layer) {
+    if (kv_heads <= 0 || key_dim <= 0 || value_dim <= 0 ||
+        options_.max_batch_size <= 0 || options_.max_sequence_length <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid KV cache dimensions");
+    }
+    KVCacheLayer entry;
+    const int64_t batch = options_.max_batch_size;
+    const int64_t capacity = options_.max_sequence_length;
+    const Shape key_shape({batch, kv_heads, capacity, key_dim});
+    const Shape value_shape({batch, kv_heads, capacity, value_dim});
+    if (!options_.allocate) {
+        entry.key = std::make_shared<Tensor>(key_shape, DataType::FLOAT32, nullptr);
+        entry.value = std::make_shared<Tensor>(value_shape, DataType::FLOAT32, nullptr);
+        entry.lengths = std::make_shared<Tensor>(Shape({batch}), DataType::INT64, nullptr);
+        layers_.push_back(std::move(entry));
+        *layer = &layers_.back();
+        return Status::Ok();
+    }
+    entry.key = CreateTensor(key_shape, DataType::FLOAT32);
+    entry.value = CreateTensor(value_shape, DataType::FLOAT32);
+    entry.lengths = CreateTensor(Shape({batch}), DataType::INT64);
+    if (!entry.key->GetData() || !entry.value->GetData() || !entry.lengths->GetData()) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate KV cache");
+    }
+    entry.lengths->FillZero();
+    layers_.push_back(std::move(entry));
+    *layer = &layers_.back();
+    return Status::Ok();
+}
+
+size_t KVCache::GetMemoryBytes() const {
+    size_t bytes = 0;
+    for (const KVCacheLayer& layer : layers_) {
+        bytes += layer.key->GetSizeInBytes() + layer.value->GetSizeInBytes() + layer.lengths->GetSizeInBytes();
+    }
+    return bytes;
+}
+
+int64_t KVCache::GetSequenceLength(int64_t seq) const {
+    if (layers_.empty() || !CheckSequence(seq).IsOk()) {
+        return 0;
+    }
+    return static_cast<const int64_t*>(layers_[0].lengths->GetData())[seq];
+}
+
+void KVCache::Reset() {
+    for (const KVCacheLayer& layer : layers_) {
+        layer.lengths->FillZero();
+    }
+}
+
+Status KVCache::Reset(int64_t seq) {
+    return Trim(seq, 0);
+}
+
+Status KVCache::Trim(int64_t seq, int64_t length) {
+    Status status = CheckSequence(seq);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (length < 0 || length > GetSequenceLength(seq)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "KV cache trim length exceeds cached length");
+    }
+    SetLength(seq, length);
+    return Status::Ok();
+}
+
+Status KVCache::Fork(int64_t src, int64_t dst) {
+    Status status = CheckSequence(src);
+    if (status.IsOk()) {
+        status = CheckSequence(dst);
+    }
+    if (!status.IsOk() || src == dst) {
+        return status;
+    }
+    
+    const int64_t length = GetSequenceLength(src);
+    for (const KVCacheLayer& layer : layers_) {
+        for (Tensor* buffer : {layer.key.get(), layer.value.get()}) {
+            const auto& dims = buffer->GetShape().dims;  // [batch, heads, capacity, dim]
+            const int64_t heads = dims[1];
+            const int64_t row = dims[2] * dims[3];
+            float* data = static_cast<float*>(buffer->GetData());
+            for (int64_t h = 0; h < heads; ++h) {
+                std::memcpy(data + (dst * heads + h) * row, data + (src * heads + h) * row,
+                            static_cast<size_t>(length * dims[3]) * sizeof(float));
+            }
+        }
+    }
+    SetLength(dst, length);
+    return Status::Ok();
+}
+
+Status KVCache::CheckSequence(int64_t seq) const {
+    if (seq < 0 || seq >= options_.max_batch_size) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "KV cache sequence index out of range: " + std::to_string(seq));
+    }
+    return Status::Ok();
+}
+
+void KVCache::SetLength(int64_t seq, int64_t length) {
+    for (const KVCacheLayer& layer : layers_) {
+        static_cast<int64_t*>(layer.lengths->GetData())[seq] = length;
+    }
+}
+
+namespace {
+
+// past沿序列维（倒数第二维）拼接本次的新位置
+struct CacheConcat {
+    Node* concat = nullptr;
+    Value* past = nullptr;
+    Value* current = nullptr;
+    Value* present = nullptr;
+};
+
+bool FindCacheConcat(const Graph& graph, const Node* attention, Value* present, CacheConcat* result) {
+    Node* concat = present->GetProducer();
+    if (!concat || concat->GetOpType() != "Concat" || concat->GetInputs().size() != 2) {
+        return false;
+    }
+    const std::string axis = concat->GetAttribute("axis");
+    if (axis != "-2" && axis != "2") {
+        return false;
+    }
+    Value* past = concat->GetInputs()[0];
+    const auto& inputs = graph.GetInputs();
+    if (std::find(inputs.begin(), inputs.end(), past) == inputs.end() ||
+        past->GetConsumers().size() != 1) {
+        return false;
+    }
+    for (const Node* consumer : present->GetConsumers()) {
+        if (consumer != attention) {
+            return false;
+        }
+    }
+    *result = {concat, past, concat->GetInputs()[1], present};
+    return true;
+}
+
+// 缓冲维度取past或新位置中已知的那个（动态维度为-1）
+int64_t KnownDim(const Value* a, const Value* b, size_t axis) {
+    for (const Value* value : {a, b}) {
+        const auto& dims = value->GetShape().dims;
+        if (dims.size() == 4 && dims[axis] > 0) {
+            return dims[axis];
+        }
+    }
+    return -1;
+}
+
+Value* AddCacheValue(Graph* graph, const std::string& name, const std::shared_ptr<Tensor>& tensor) {
+    Value* value = graph->AddValue();
+    value->SetName(name);
+    value->SetTensor(tensor);
+    return value;
+}
+
+} // anonymous namespace
+
+Status BindKVCache(Graph* graph, KVCache* cache) {
+    if (!graph || !cache) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph or KV cache is null");
+    }
+    
+    std::vector<Node*> attentions;
+    for (const auto& node : graph->GetNodes()) {
+        if (node->GetOpType() == "FusedAttention" && node->GetAttribute("kv_cache", "0") == "0" &&
+            node->GetInputs().size() >= 3) {
+            attentions.push_back(node.get());
+        }
+    }
+    
+    for (Node* attention : attentions) {
+        const std::vector<Value*> inputs = attention->GetInputs();
+        CacheConcat key, value;
+        if (!FindCacheConcat(*graph, attention, inputs[1], &key) ||
+            !FindCacheConcat(*graph, attention, inputs[2], &value)) {
+            continue;
+        }
+        const int64_t heads = KnownDim(key.past, key.current, 1);
+        const int64_t key_dim = KnownDim(key.past, key.current, 3);
+        const int64_t value_dim = KnownDim(value.past, value.current, 3);
+        KVCacheLayer* layer = nullptr;
+        if (heads <= 0 || key_dim <= 0 || value_dim <= 0 ||
+            !cache->AddLayer(heads, key_dim, value_dim, &layer).IsOk()) {
+            continue;
+        }
+        layer->past_key_name = key.past->GetName();
+        layer->past_value_name = value.past->GetName();
+        layer->present_key_name = key.present->GetName();
+        layer->present_value_name = value.present->GetName();
+        
+        // 输入改为(Q, K_new, V_new, cache_k, cache_v, lengths, [mask], [cos, sin])
+        const std::string prefix = attention->GetName() + ".kv_cache";
+        std::vector<Value*> rewired = {
+            inputs[0], key.current, value.current,
+            AddCacheValue(graph, prefix + ".key", layer->key),
+            AddCacheValue(graph, prefix + ".value", layer->value),
+            AddCacheValue(graph, prefix + ".lengths", layer->lengths),
+        };
+        rewired.insert(rewired.end(), inputs.begin() + 3, inputs.end());
+        for (Value* input : inputs) {
+            attention->RemoveInput(input);
+        }
+        for (Value* input : rewired) {
+            attention->AddInput(input);
+        }
+        attention->SetAttribute("kv_cache", "1");
+        
+        for (const CacheConcat* concat : {&key, &value}) {
+            graph->RemoveNode(concat->concat);
+            graph->RemoveValue(concat->present);
+            graph->RemoveValue(concat->past);
+        }
+    }
+    
+    if (cache->GetNumLayers() == 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "No attention with past/present key values found for KV cache");
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,339 @@
+// 日志系统实现
+// 参考spdlog的异步日志：每个线程第一次记录时登记一个单生产者单消费者的环形缓冲，
+// 后台线程定时（WARNING及以上立即唤醒）取出各缓冲的记录，按时间戳合并后格式化写出；
+// 进程退出时（atexit）停止后台线程并写出剩余记录，之后的日志改为同步输出
+
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+namespace inferunity {
+
+namespace {
+
+constexpr auto kFlushInterval = std::chrono::milliseconds(10);
+
+int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* LogLevelToString(LogLevel level) {
+    switch (level) {
+        case LogLevel::VERBOSE: return "VERBOSE";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+        default: return "UNKNOWN";
+    }
+}
+
+} // anonymous namespace
+
+// head只由消费者（持有output_mutex_）推进，tail只由所属线程推进
+struct Logger::ThreadBuffer {
+    explicit ThreadBuffer(size_t capacity) : records(capacity) {}
+    std::vector<Record> records;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> closed{false};  // 所属线程已退出，取空后注销
+};
+
+// 线程退出时标记缓冲，剩余记录仍由后台线程写出
+struct Logger::ThreadBufferHandle {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~ThreadBufferHandle() {
+        if (buffer) {
+            buffer->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+Logger& Logger::Instance() {
+    // 有意不析构：静态对象的析构函数（如线程池）在退出阶段仍会记录日志
+    static Logger* instance = [] {
+        Logger* logger = new Logger();
+        std::atexit(&Logger::ShutdownAtExit);
+        return logger;
+    }();
+    return *instance;
+}
+
+Logger::Logger() : level_(static_cast<int>(LogLevel::INFO)) {}
+
+void Logger::SetConsoleOutput(bool enable) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    console_output_ = enable;
+}
+
+void Logger::SetFileOutput(const std::string& filename) {
+    // 已排队的消息写到原来的目标
+    Flush();
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (file_.is_open()) {
+        file_.close();
+    }
+    if (!filename.empty()) {
+        file_.open(filename, std::ios::app);
+        if (!file_.is_open()) {
+            std::cerr << "[Logger] Failed to open log file: " << filename << std::endl;
+        }
+    }
+}
+
+void Logger::SetAsync(bool enable) {
+    async_.store(enable, std::memory_order_release);
+    if (!enable) {
+        Flush();
+    }
+}
+
+void Logger::SetBufferCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffer_capacity_ = std::max<size_t>(1, capacity);
+}
+
+Logger::ThreadBuffer* Logger::GetThreadBuffer() {
+    static thread_local ThreadBufferHandle handle;
+    if (!handle.buffer) {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        handle.buffer = std::make_shared<ThreadBuffer>(buffer_capacity_);
+        buffers_.push_back(handle.buffer);
+    }
+    return handle.buffer.get();
+}
+
+void Logger::Log(LogLevel level, std::string message, const char* file, int line) {
+    if (!IsEnabled(level)) {
+        return;  // 低于当前级别，不输出
+    }
+    Record record;
+    record.level = level;
+    record.timestamp_us = NowMicros();
+    record.file = file ? file : "";
+    record.line = line;
+    record.message = std::move(message);
+    
+    if (IsAsync()) {
+        if (!flusher_started_.load(std::memory_order_acquire)) {
+            StartFlusher();
+        }
+        ThreadBuffer* buffer = GetThreadBuffer();
+        const uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        if (tail - buffer->head.load(std::memory_order_acquire) < buffer->records.size()) {
+            buffer->records[tail % buffer->records.size()] = std::move(record);
+            buffer->tail.store(tail + 1, std::memory_order_release);
+            if (level >= LogLevel::FATAL) {
+                Flush();
+            } else if (level >= LogLevel::WARNING) {
+                wake_.notify_one();
+            }
+            return;
+        }
+        // 缓冲已满：一般信息直接丢弃，警告及以上不能丢，改为同步写出
+        if (level < LogLevel::WARNING) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    Write(record);
+    if (console_output_) {
+        std::cout.flush();
+    }
+    if (file_.is_open()) {
+        file_.flush();
+    }
+}
+
+void Logger::Flush() {
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    if (!flusher_.joinable() || stop_) {
+        lock.unlock();
+        Drain();
+        return;
+    }
+    const uint64_t target = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [&] { return flush_completed_ >= target; });
+}
+
+void Logger::StartFlusher() {
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    if (!flusher_.joinable() && !stop_) {
+        flusher_ = std::thread(&Logger::FlusherLoop, this);
+    }
+    flusher_started_.store(true, std::memory_order_release);
+}
+
+void Logger::FlusherLoop() {
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    while (true) {
+        const uint64_t requested = flush_requested_;
+        const bool stop = stop_;
+        lock.unlock();
+        Drain();
+        lock.lock();
+        if (requested > flush_completed_) {
+            flush_completed_ = requested;
+            flushed_.notify_all();
+        }
+        if (stop) {
+            return;
+        }
+        if (flush_requested_ == requested && !stop_) {
+            wake_.wait_for(lock, kFlushInterval);
+        }
+    }
+}
+
+size_t Logger::Drain() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+    }
+    
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    std::vector<Record> batch;
+    for (const auto& buffer : buffers) {
+        const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; ++i) {
+            batch.push_back(std::move(buffer->records[i % buffer->records.size()]));
+        }
+        buffer->head.store(tail, std::memory_order_release);
+    }
+    // 已退出且取空的线程缓冲注销
+    {
+        std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::shared_ptr<ThreadBuffer>& b) {
+            return b->closed.load(std::memory_order_acquire) &&
+                   b->head.load(std::memory_order_relaxed) == b->tail.load(std::memory_order_acquire);
+        }), buffers_.end());
+    }
+    
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > reported_dropped_) {
+        Record record;
+        record.level = LogLevel::WARNING;
+        record.timestamp_us = NowMicros();
+        record.message = std::to_string(dropped - reported_dropped_) + " log messages dropped (buffer full)";
+        batch.push_back(std::move(record));
+        reported_dropped_ = dropped;
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+    std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+        return a.timestamp_us < b.timestamp_us;
+    });
+    for (const Record& record : batch) {
+        Write(record);
+    }
+    if (console_output_) {
+        std::cout.flush();
+    }
+    if (file_.is_open()) {
+        file_.flush();
+    }
+    return batch.size();
+}
+
+void Logger::Write(const Record& record) {
+    const std::time_t seconds = static_cast<std::time_t>(record.timestamp_us / 1000000);
+    std::tm tm_buf;
+#ifdef _WIN32
+    localtime_s(&tm_buf, &seconds);
+#else
+    localtime_r(&seconds, &tm_buf);
+#endif
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+    
+    std::string text;
+    text.reserve(record.message.size() + 64);
+    text += '[';
+    text += timestamp;
+    text += "] [";
+    text += LogLevelToString(record.level);
+    text += ']';
+    if (record.file[0] != '\0') {
+        text += " [";
+        text += record.file;
+        if (record.line > 0) {
+            text += ':';
+            text += std::to_string(record.line);
+        }
+        text += ']';
+    }
+    text += ' ';
+    text += record.message;
+    text += '\n';
+    
+    // 输出到控制台
+    if (console_output_) {
+        if (record.level >= LogLevel::ERROR) {
+            std::cerr << text;
+        } else {
+            std::cout << text;
+        }
+    }
+    // 输出到文件（如果设置了）
+    if (file_.is_open()) {
+        file_ << text;
+    }
+}
+
+void Logger::BeforeFork() {
+    std::thread flusher;
+    {
+        std::lock_guard<std::mutex> lock(flusher_mutex_);
+        stopped_for_fork_ = flusher_.joinable() && !stop_;
+        if (stopped_for_fork_) {
+            stop_ = true;
+            flusher = std::move(flusher_);
+        }
+    }
+    wake_.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    Drain();
+    flusher_mutex_.lock();
+    buffers_mutex_.lock();
+    output_mutex_.lock();
+}
+
+void Logger::AfterFork() {
+    output_mutex_.unlock();
+    buffers_mutex_.unlock();
+    if (stopped_for_fork_) {
+        stop_ = false;
+        stopped_for_fork_ = false;
+        flusher_started_.store(false, std::memory_order_release);
+    }
+    flusher_mutex_.unlock();
+}
+
+void Logger::ShutdownAtExit() {
+    Logger& logger = Instance();
+    logger.async_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(logger.flusher_mutex_);
+        logger.stop_ = true;
+    }
+    logger.wake_.notify_all();
+    if (logger.flusher_.joinable()) {
+        logger.flusher_.join();
+    }
+    logger.Drain();
+}
+
+} // namespace inferunity
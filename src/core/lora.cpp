@@ -0,0 +1,144 @@
+// LoRA适配器表实现
+// 注册时一次检查形状并记下数据指针，运行时的LoraBatch只是各段增量的查找表
+
+#include "inferunity/lora.h"
+#include <algorithm>
+
+namespace inferunity {
+
+namespace {
+
+thread_local std::shared_ptr<const LoraBatch> tls_lora_batch;
+
+Status CheckLoraMatrix(const std::shared_ptr<Tensor>& tensor, const std::string& what) {
+    if (!tensor || !tensor->GetData()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA " + what + " has no data");
+    }
+    if (tensor->GetDataType() != DataType::FLOAT32 || tensor->GetDeviceType() != DeviceType::CPU ||
+        tensor->GetShape().dims.size() != 2 || !tensor->IsContiguous()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "LoRA " + what + " must be a contiguous 2-D FLOAT32 CPU tensor");
+    }
+    return Status::Ok();
+}
+
+} // namespace
+
+void LoraRegistry::SetTargets(std::unordered_map<std::string, LoraTarget> targets) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_ = std::move(targets);
+    adapters_.clear();
+}
+
+Status LoraRegistry::Register(const std::string& adapter_id, LoraAdapter adapter) {
+    if (adapter_id.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA adapter id is empty");
+    }
+    if (adapter.weights.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LoRA adapter " + adapter_id + " has no weights");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : adapter.weights) {
+        const std::string& name = entry.first;
+        auto target = targets_.find(name);
+        if (target == targets_.end()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "LoRA adapter " + adapter_id + ": " + name + " is not a MatMul weight of the model");
+        }
+        Status status = CheckLoraMatrix(entry.second.a, name + " A");
+        if (status.IsOk()) {
+            status = CheckLoraMatrix(entry.second.b, name + " B");
+        }
+        if (!status.IsOk()) {
+            return status;
+        }
+        const auto& a_dims = entry.second.a->GetShape().dims;
+        const auto& b_dims = entry.second.b->GetShape().dims;
+        if (a_dims[0] != target->second.k || b_dims[1] != target->second.n ||
+            a_dims[1] != b_dims[0] || a_dims[1] <= 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "LoRA adapter " + adapter_id + ": " + name + " expects A [" +
+                                 std::to_string(target->second.k) + ", r] and B [r, " +
+                                 std::to_string(target->second.n) + "]");
+        }
+    }
+    adapters_[adapter_id] = std::make_shared<const LoraAdapter>(std::move(adapter));
+    return Status::Ok();
+}
+
+Status LoraRegistry::Unregister(const std::string& adapter_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (adapters_.erase(adapter_id) == 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown LoRA adapter: " + adapter_id);
+    }
+    return Status::Ok();
+}
+
+std::vector<std::string> LoraRegistry::GetAdapterIds() const {
+    std::vector<std::string> ids;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : adapters_) {
+            ids.push_back(entry.first);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+Status LoraRegistry::CreateBatch(const std::vector<std::string>& adapter_ids,
+                                 std::shared_ptr<const LoraBatch>* batch) const {
+    batch->reset();
+    auto result = std::make_shared<LoraBatch>();
+    result->num_segments_ = adapter_ids.size();
+    result->adapters_.resize(adapter_ids.size());
+    bool any = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t s = 0; s < adapter_ids.size(); ++s) {
+            if (adapter_ids[s].empty()) {
+                continue;
+            }
+            auto it = adapters_.find(adapter_ids[s]);
+            if (it == adapters_.end()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown LoRA adapter: " + adapter_ids[s]);
+            }
+            result->adapters_[s] = it->second;
+            any = true;
+        }
+    }
+    if (!any) {
+        return Status::Ok();
+    }
+    for (size_t s = 0; s < adapter_ids.size(); ++s) {
+        const LoraAdapter* adapter = result->adapters_[s].get();
+        if (!adapter) {
+            continue;
+        }
+        for (const auto& entry : adapter->weights) {
+            std::vector<LoraDelta>& deltas = result->deltas_[entry.first];
+            deltas.resize(adapter_ids.size());
+            LoraDelta& delta = deltas[s];
+            delta.a = static_cast<const float*>(entry.second.a->GetData());
+            delta.b = static_cast<const float*>(entry.second.b->GetData());
+            delta.rank = entry.second.a->GetShape().dims[1];
+            delta.scale = adapter->scale;
+        }
+    }
+    *batch = std::move(result);
+    return Status::Ok();
+}
+
+LoraScope::LoraScope(std::shared_ptr<const LoraBatch> batch) : previous_(tls_lora_batch) {
+    tls_lora_batch = std::move(batch);
+}
+
+LoraScope::~LoraScope() {
+    tls_lora_batch = std::move(previous_);
+}
+
+const std::shared_ptr<const LoraBatch>& LoraScope::Current() {
+    return tls_lora_batch;
+}
+
+} // namespace inferunity
@@ -1,180 +1,617 @@
 #include "inferunity/memory.h"
+#include "inferunity/logger.h"
+#include "inferunity/numa.h"
+#include "core/align_utils.h"
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <algorithm>
+#include <iterator>
 #include <mutex>
+#include <new>
 #include <unordered_map>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace inferunity {
 
-// CPU分配器实现
-// 使用内存池进行分配，以便统计和管理
+// CPU分配器实现：直接转发到分级内存池
 void* CPUAllocator::Allocate(size_t size) {
-    // 使用内存池分配（带对齐）
-    return AllocateMemory(size, 16);  // 16字节对齐
+    return AllocateMemory(size, 16);  // 16字节对齐（缓存块实际按64字节对齐）
 }
 
 void CPUAllocator::Free(void* ptr) {
-    // 使用内存池释放
     FreeMemory(ptr);
 }
 
+void* CPUAllocator::AllocateAligned(size_t size, size_t alignment) {
+    // 内存池按对齐分配，释放时同样交给Free，不需要基类的偏移技巧
+    return AllocateMemory(size, alignment);
+}
+
 size_t CPUAllocator::GetAllocatedSize(void* ptr) const {
-    // 标准malloc不提供此功能，需要自定义实现
     (void)ptr;
     return 0;
 }
 
-// 内存池实现
+bool CPUAllocator::GetStats(MemoryStats* stats) const {
+    *stats = GetMemoryStats();
+    return true;
+}
+
+// 固定块分配器实现
 MemoryPool::MemoryPool(size_t block_size, size_t initial_blocks)
     : block_size_(block_size) {
     blocks_.reserve(initial_blocks);
+    free_blocks_.reserve(initial_blocks);
     for (size_t i = 0; i < initial_blocks; ++i) {
-        AllocateNewBlock();
+        void* block = AllocateNewBlock();
+        if (!block) {
+            break;
+        }
+        blocks_[block] = false;
+        free_blocks_.push_back(block);
     }
 }
 
 MemoryPool::~MemoryPool() {
-    Reset();
     for (auto& block : blocks_) {
-        if (block.data) {
-            std::free(block.data);
-        }
+        FreeMemory(block.first);
     }
 }
 
 void* MemoryPool::Allocate(size_t size) {
     if (size > block_size_) {
-        // 大块直接分配
-        return std::malloc(size);
+        // 大块直接从内存池分配
+        return AllocateMemory(size);
     }
     
-    // 从空闲块中查找
+    void* ptr = nullptr;
     if (!free_blocks_.empty()) {
-        void* ptr = free_blocks_.back();
+        ptr = free_blocks_.back();
         free_blocks_.pop_back();
-        return ptr;
+    } else {
+        ptr = AllocateNewBlock();
+        if (!ptr) {
+            return nullptr;
+        }
     }
-    
-    // 分配新块
-    return AllocateNewBlock();
+    blocks_[ptr] = true;
+    return ptr;
 }
 
 void MemoryPool::Free(void* ptr) {
     if (!ptr) return;
     
-    // 检查是否是大块
-    bool found = false;
-    for (auto& block : blocks_) {
-        if (block.data == ptr) {
-            if (block.in_use) {
-                block.in_use = false;
-                free_blocks_.push_back(ptr);
-                found = true;
-            }
-            break;
-        }
+    auto it = blocks_.find(ptr);
+    if (it == blocks_.end()) {
+        // 超过block_size的块
+        FreeMemory(ptr);
+        return;
     }
-    
-    if (!found) {
-        // 可能是大块，直接释放
-        std::free(ptr);
+    if (it->second) {
+        it->second = false;
+        free_blocks_.push_back(ptr);
     }
 }
 
 void MemoryPool::Reset() {
-    for (auto& block : blocks_) {
-        block.in_use = false;
-    }
     free_blocks_.clear();
     for (auto& block : blocks_) {
-        if (block.data) {
-            free_blocks_.push_back(block.data);
-        }
+        block.second = false;
+        free_blocks_.push_back(block.first);
     }
 }
 
 void* MemoryPool::AllocateNewBlock() {
-    void* data = std::malloc(block_size_);
-    if (data) {
-        blocks_.push_back({data, true});
-    }
-    return data;
+    return AllocateMemory(block_size_);
 }
 
 // 全局分配器管理
 namespace {
     std::mutex allocator_mutex;
     std::unordered_map<DeviceType, std::shared_ptr<MemoryAllocator>> allocators;
+    // 被SetMemoryAllocator替换过的设备，按DeviceBit置位；热路径只读这个掩码
+    std::atomic<uint32_t> replaced_devices{0};
     
-    std::shared_ptr<MemoryAllocator> GetOrCreateAllocator(DeviceType device) {
-        std::lock_guard<std::mutex> lock(allocator_mutex);
-        auto it = allocators.find(device);
-        if (it != allocators.end()) {
-            return it->second;
-        }
-        
-        std::shared_ptr<MemoryAllocator> allocator;
-        switch (device) {
-            case DeviceType::CPU:
-                allocator = std::make_shared<CPUAllocator>();
-                break;
-            // 其他设备的分配器（CUDA等）
-            // 可以通过ExecutionProviderRegistry获取相应设备的分配器
-            // 目前只实现CPU分配器，其他设备分配器在相应后端中实现
-            default:
-                allocator = std::make_shared<CPUAllocator>();
-                break;
-        }
-        
-        allocators[device] = allocator;
+    uint32_t DeviceBit(DeviceType device) {
+        return 1u << std::min<uint32_t>(static_cast<uint32_t>(device), 31u);
+    }
+    
+    // 默认分配器常驻到进程退出（静态析构期间释放的张量仍可使用它）
+    CPUAllocator* DefaultAllocator() {
+        static CPUAllocator* allocator = new CPUAllocator();
         return allocator;
     }
 }
 
 std::shared_ptr<MemoryAllocator> GetMemoryAllocator(DeviceType device) {
-    return GetOrCreateAllocator(device);
+    std::shared_ptr<MemoryAllocator> owner;
+    MemoryAllocator* allocator = ResolveMemoryAllocator(device, &owner);
+    // 默认分配器不归引用计数管理，返回不持有所有权的别名指针
+    return owner ? owner : std::shared_ptr<MemoryAllocator>(std::shared_ptr<MemoryAllocator>(), allocator);
+}
+
+MemoryAllocator* ResolveMemoryAllocator(DeviceType device, std::shared_ptr<MemoryAllocator>* owner) {
+    owner->reset();
+    if ((replaced_devices.load(std::memory_order_acquire) & DeviceBit(device)) == 0) {
+        return DefaultAllocator();
+    }
+    std::lock_guard<std::mutex> lock(allocator_mutex);
+    auto it = allocators.find(device);
+    if (it == allocators.end()) {
+        return DefaultAllocator();
+    }
+    *owner = it->second;
+    return owner->get();
 }
 
-// 内存统计（线程安全）
+void SetMemoryAllocator(DeviceType device, std::shared_ptr<MemoryAllocator> allocator) {
+    std::lock_guard<std::mutex> lock(allocator_mutex);
+    if (allocator) {
+        allocators[device] = std::move(allocator);
+    } else {
+        allocators.erase(device);
+    }
+    // 多个设备可能映射到同一位（见DeviceBit），位按仍有替换的设备重新计算
+    uint32_t mask = 0;
+    for (const auto& entry : allocators) {
+        mask |= DeviceBit(entry.first);
+    }
+    replaced_devices.store(mask, std::memory_order_release);
+}
+
+// 内存统计：只来自分配器自身（CPU为内存池），不另行记账
+MemoryStats GetMemoryStats(DeviceType device) {
+    std::shared_ptr<MemoryAllocator> owner;
+    MemoryAllocator* allocator = ResolveMemoryAllocator(device, &owner);
+    // 未替换的设备张量也落在内存池，池统计只归CPU
+    if (!owner && device != DeviceType::CPU) {
+        return MemoryStats{0, 0, 0, 0};
+    }
+    MemoryStats stats{0, 0, 0, 0};
+    if (allocator->GetStats(&stats)) {
+        return stats;
+    }
+    return device == DeviceType::CPU ? ::inferunity::GetMemoryStats() : MemoryStats{0, 0, 0, 0};
+}
+
+void PrefetchMemory(const void* data, size_t size) {
+#ifndef _WIN32
+    if (!data || size == 0) {
+        return;
+    }
+    // madvise要求起始地址按页对齐
+    static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+    const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#else
+    (void)data;
+    (void)size;
+#endif
+}
+
+void ReleaseMemory(const void* data, size_t size) {
+#if defined(__linux__) && (defined(MADV_PAGEOUT) || defined(MADV_COLD))
+    if (!data || size == 0) {
+        return;
+    }
+    // 只回收完整落在范围内的页，相邻权重共享的首尾页保留
+    static const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page_size - 1) & ~(page_size - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(page_size - 1);
+    if (end <= begin) {
+        return;
+    }
+#ifdef MADV_PAGEOUT
+    if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_PAGEOUT) == 0) {
+        return;
+    }
+#endif
+#ifdef MADV_COLD
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_COLD);
+#endif
+#else
+    (void)data;
+    (void)size;
+#endif
+}
+
+// 暂存区的块直接向系统申请：线程退出时内存池的线程缓存可能已先行析构
 namespace {
-    std::mutex stats_mutex;
-    std::unordered_map<DeviceType, MemoryStats> device_stats;
+
+void* AllocateScratchBlock(size_t size, size_t alignment) {
+    return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+}
+
+void FreeScratchBlock(void* ptr, size_t alignment) {
+    ::operator delete(ptr, std::align_val_t(alignment));
+}
+
+} // anonymous namespace
+
+ScratchArena& ScratchArena::ForCurrentThread() {
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::~ScratchArena() {
+    for (const OverflowBlock& block : overflow_) {
+        FreeScratchBlock(block.data, block.alignment);
+    }
+    if (data_) {
+        FreeScratchBlock(data_, kAlignment);
+    }
+}
+
+void ScratchArena::Reserve(size_t bytes) {
+    reserved_ = std::max(reserved_, bytes);
+    if (offset_ == 0 && overflow_.empty() && reserved_ > capacity_) {
+        Grow(reserved_);
+    }
+}
+
+void ScratchArena::Grow(size_t bytes) {
+    // 按页取整，相近的请求不反复重新分配
+    const size_t capacity = AlignUp(bytes, 4096);
+    void* data = AllocateScratchBlock(capacity, kAlignment);
+    if (!data) {
+        return;
+    }
+    if (data_) {
+        FreeScratchBlock(data_, kAlignment);
+    }
+    data_ = static_cast<uint8_t*>(data);
+    capacity_ = capacity;
+}
+
+void* ScratchArena::Allocate(size_t size, size_t alignment) {
+    alignment = std::max(alignment, kAlignment);
+    if (data_) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(data_);
+        const size_t begin = AlignUp(base + offset_, alignment) - base;
+        if (begin <= capacity_ && size <= capacity_ - begin) {
+            offset_ = begin + size;
+            peak_ = std::max(peak_, GetUsedBytes());
+            return data_ + begin;
+        }
+    }
+    if (size == 0) {
+        return nullptr;
+    }
+    void* block = AllocateScratchBlock(size, alignment);
+    if (!block) {
+        return nullptr;
+    }
+    // 对齐的余量也计入，扩大后的主块能一次容纳同样的请求序列
+    overflow_.push_back(OverflowBlock{block, size + alignment, alignment});
+    overflow_bytes_ += size + alignment;
+    ++overflow_count_;
+    peak_ = std::max(peak_, GetUsedBytes());
+    return block;
+}
+
+void ScratchArena::Rewind(const Mark& mark) {
+    while (overflow_.size() > mark.overflow) {
+        FreeScratchBlock(overflow_.back().data, overflow_.back().alignment);
+        overflow_bytes_ -= overflow_.back().bytes;
+        overflow_.pop_back();
+    }
+    offset_ = std::min(mark.offset, offset_);
+    // 回到空闲状态时按峰值与预留扩大主块，溢出只发生在第一次遇到更大的请求时
+    if (offset_ == 0 && overflow_.empty()) {
+        const size_t target = std::max(peak_, reserved_);
+        if (target > capacity_) {
+            Grow(target);
+        }
+    }
+}
+
+ScratchScope::ScratchScope(size_t reserve_bytes)
+    : arena_(ScratchArena::ForCurrentThread()) {
+    if (reserve_bytes > 0) {
+        arena_.Reserve(reserve_bytes);
+    }
+    mark_ = arena_.GetMark();
+}
+
+// 大页区域
+namespace {
+    std::atomic<size_t> huge_1gb_bytes{0};
+    std::atomic<size_t> huge_2mb_bytes{0};
+    std::atomic<size_t> transparent_bytes{0};
+    std::atomic<size_t> fallback_bytes{0};
+    std::atomic<size_t> hugetlb_failures{0};
+    std::atomic<size_t> advised_bytes{0};
     
-    void UpdateStats(DeviceType device, size_t allocated, bool is_alloc) {
-        std::lock_guard<std::mutex> lock(stats_mutex);
-        MemoryStats& stats = device_stats[device];
-        if (is_alloc) {
-            stats.allocated_bytes += allocated;
-            stats.allocation_count++;
-            if (stats.allocated_bytes > stats.peak_allocated_bytes) {
-                stats.peak_allocated_bytes = stats.allocated_bytes;
-            }
-        } else {
-            stats.allocated_bytes -= allocated;
-            stats.free_count++;
+    std::atomic<size_t>& BackingCounter(HugePageBacking backing) {
+        switch (backing) {
+            case HugePageBacking::HUGETLB_1GB: return huge_1gb_bytes;
+            case HugePageBacking::HUGETLB_2MB: return huge_2mb_bytes;
+            case HugePageBacking::TRANSPARENT: return transparent_bytes;
+            default: return fallback_bytes;
         }
     }
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+    // hugetlbfs预留的页；预留不足时mmap直接失败，而不是在缺页时SIGBUS
+    void* MapHugeTlb(size_t size, size_t page_shift) {
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                          static_cast<int>(page_shift << MAP_HUGE_SHIFT);
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        return data == MAP_FAILED ? nullptr : data;
+    }
+#endif
 }
 
-MemoryStats GetMemoryStats(DeviceType device) {
-    // 对于CPU设备，使用内存池统计
-    if (device == DeviceType::CPU) {
-        return ::inferunity::GetMemoryStats();
+const char* HugePagePolicyName(HugePagePolicy policy) {
+    switch (policy) {
+        case HugePagePolicy::NONE: return "none";
+        case HugePagePolicy::TRANSPARENT: return "transparent";
+        case HugePagePolicy::HUGETLB_2MB: return "hugetlb_2mb";
+        case HugePagePolicy::HUGETLB_1GB: return "hugetlb_1gb";
     }
-    // 其他设备使用设备特定统计
-    std::lock_guard<std::mutex> lock(stats_mutex);
-    auto it = device_stats.find(device);
-    if (it != device_stats.end()) {
-        return it->second;
+    return "unknown";
+}
+
+std::unique_ptr<HugePageRegion> HugePageRegion::Allocate(size_t size, HugePagePolicy policy) {
+    if (policy == HugePagePolicy::NONE || size < kHugePageSize) {
+        return nullptr;
     }
-    return MemoryStats{0, 0, 0, 0};
+    std::unique_ptr<HugePageRegion> region(new HugePageRegion());
+#ifndef _WIN32
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    // 1GB -> 2MB -> 透明大页
+    const size_t shifts[] = {30, 21};
+    for (size_t page_shift : shifts) {
+        if ((page_shift == 30 && policy != HugePagePolicy::HUGETLB_1GB) ||
+            policy == HugePagePolicy::TRANSPARENT) {
+            continue;
+        }
+        const size_t mapped_size = AlignUp(size, size_t(1) << page_shift);
+        if (void* data = MapHugeTlb(mapped_size, page_shift)) {
+            region->mapping_ = data;
+            region->mapped_size_ = mapped_size;
+            region->data_ = data;
+            region->size_ = mapped_size;
+            region->backing_ = page_shift == 30 ? HugePageBacking::HUGETLB_1GB : HugePageBacking::HUGETLB_2MB;
+            break;
+        }
+        hugetlb_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+    if (!region->mapping_) {
+        // 多映射一个大页，把起始地址对齐到2MB，内核才能用大页填充整个区域
+        const size_t usable = AlignUp(size, kHugePageSize);
+        const size_t mapped_size = usable + kHugePageSize;
+        void* data = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+        region->mapping_ = data;
+        region->mapped_size_ = mapped_size;
+        region->data_ = reinterpret_cast<void*>(AlignUp(reinterpret_cast<uintptr_t>(data), kHugePageSize));
+        region->size_ = usable;
+        region->backing_ = HugePageBacking::NORMAL;
+#ifdef MADV_HUGEPAGE
+        if (::madvise(region->data_, usable, MADV_HUGEPAGE) == 0) {
+            region->backing_ = HugePageBacking::TRANSPARENT;
+        }
+#endif
+    }
+    const int node = GetCurrentNumaNode();
+    if (node >= 0) {
+        BindMemoryToNumaNode(region->data_, region->size_, node);
+    }
+    BackingCounter(region->backing_).fetch_add(region->size_, std::memory_order_relaxed);
+    if (region->backing_ == HugePageBacking::NORMAL) {
+        LOG_VERBOSE("Huge pages unavailable for " + std::to_string(size) + " bytes; using normal pages");
+    }
+    return region;
+#else
+    (void)region;
+    return nullptr;
+#endif
+}
+
+HugePageRegion::~HugePageRegion() {
+#ifndef _WIN32
+    if (mapping_) {
+        ::munmap(mapping_, mapped_size_);
+        BackingCounter(backing_).fetch_sub(size_, std::memory_order_relaxed);
+    }
+#endif
 }
 
-// 内存碎片整理功能（简化实现）
-// 注意：由于MemoryPool的blocks_是private，这里提供概念性实现
-// 实际使用时需要在MemoryPool类中添加Defragment()方法
+bool AdviseHugePages(const void* data, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    const uintptr_t begin = AlignUp(reinterpret_cast<uintptr_t>(data), kHugePageSize);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(uintptr_t(kHugePageSize) - 1);
+    if (!data || end <= begin) {
+        return false;
+    }
+    if (::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) != 0) {
+        return false;
+    }
+    advised_bytes.fetch_add(end - begin, std::memory_order_relaxed);
+    return true;
+#else
+    (void)data;
+    (void)size;
+    return false;
+#endif
+}
 
-} // namespace inferunity
+HugePageStats GetHugePageStats() {
+    HugePageStats stats;
+    stats.hugetlb_1gb_bytes = huge_1gb_bytes.load(std::memory_order_relaxed);
+    stats.hugetlb_2mb_bytes = huge_2mb_bytes.load(std::memory_order_relaxed);
+    stats.transparent_bytes = transparent_bytes.load(std::memory_order_relaxed);
+    stats.fallback_bytes = fallback_bytes.load(std::memory_order_relaxed);
+    stats.hugetlb_failures = hugetlb_failures.load(std::memory_order_relaxed);
+    stats.advised_bytes = advised_bytes.load(std::memory_order_relaxed);
+#if defined(__linux__)
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    size_t kb = 0;
+    while (smaps >> key) {
+        if (key == "AnonHugePages:" && smaps >> kb) {
+            stats.anon_huge_bytes = kb * 1024;
+            break;
+        }
+    }
+#endif
+    return stats;
+}
+
+namespace {
+    // MappedFile::Open打开的映射，供FindMappedFileRegion按地址反查文件
+    std::mutex mapped_files_mutex;
+    std::vector<const MappedFile*> mapped_files;
+}
 
+Status MappedFile::Open(const std::string& filepath, std::shared_ptr<MappedFile>* file) {
+#ifdef _WIN32
+    // 没有mmap时读入内存，接口保持一致
+    auto mapped = std::shared_ptr<MappedFile>(new MappedFile());
+    std::ifstream stream(filepath, std::ios::binary);
+    if (!stream.is_open()) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open file: " + filepath);
+    }
+    stream.seekg(0, std::ios::end);
+    mapped->buffer_.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(reinterpret_cast<char*>(mapped->buffer_.data()), mapped->buffer_.size());
+    mapped->data_ = mapped->buffer_.data();
+    mapped->size_ = mapped->buffer_.size();
+    *file = std::move(mapped);
+    return Status::Ok();
+#elif defined(__EMSCRIPTEN__)
+    // WebAssembly的文件系统（MEMFS/预加载包）本身就在线性内存里，映射也只是复制；直接读入对齐的自有缓冲
+    std::ifstream stream(filepath, std::ios::binary);
+    if (!stream.is_open()) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open file: " + filepath);
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    Status status = FromMemory(bytes.data(), bytes.size(), filepath, file);
+    if (status.IsOk()) {
+        (*file)->path_ = filepath;
+        std::lock_guard<std::mutex> lock(mapped_files_mutex);
+        mapped_files.push_back(file->get());
+    }
+    return status;
+#else
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open file: " + filepath);
+    }
+    Status status = OpenDescriptor(fd, filepath, file);
+    ::close(fd);  // 映射建立后不再需要文件描述符
+    if (status.IsOk()) {
+        (*file)->path_ = filepath;
+        std::lock_guard<std::mutex> lock(mapped_files_mutex);
+        mapped_files.push_back(file->get());
+    }
+    return status;
+#endif
+}
+
+Status MappedFile::OpenSharedMemory(const std::string& name, std::shared_ptr<MappedFile>* file) {
+#ifdef _WIN32
+    (void)file;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Shared memory is not supported: " + name);
+#else
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open shared memory: " + name);
+    }
+    Status status = OpenDescriptor(fd, name, file);
+    ::close(fd);
+    return status;
+#endif
+}
+
+Status MappedFile::OpenDescriptor(int fd, const std::string& label, std::shared_ptr<MappedFile>* file) {
+#ifdef _WIN32
+    (void)fd;
+    (void)file;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "File descriptors are not supported: " + label);
+#else
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Empty or unreadable file: " + label);
+    }
+    void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot map file: " + label);
+    }
+    auto mapped = std::shared_ptr<MappedFile>(new MappedFile());
+    mapped->data_ = static_cast<uint8_t*>(data);
+    mapped->size_ = static_cast<size_t>(info.st_size);
+    *file = std::move(mapped);
+    return Status::Ok();
+#endif
+}
+
+Status MappedFile::FromMemory(const void* data, size_t size, const std::string& label,
+                              std::shared_ptr<MappedFile>* file) {
+    if (!data || size == 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Empty model buffer: " + label);
+    }
+    void* buffer = AllocateMemory(size, 64);
+    if (!buffer) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Cannot allocate model buffer: " + label);
+    }
+    std::memcpy(buffer, data, size);
+    auto mapped = std::shared_ptr<MappedFile>(new MappedFile());
+    mapped->data_ = static_cast<uint8_t*>(buffer);
+    mapped->size_ = size;
+    mapped->owned_ = true;
+    *file = std::move(mapped);
+    return Status::Ok();
+}
+
+MappedFile::~MappedFile() {
+    if (!path_.empty()) {
+        std::lock_guard<std::mutex> lock(mapped_files_mutex);
+        mapped_files.erase(std::remove(mapped_files.begin(), mapped_files.end(), this), mapped_files.end());
+    }
+    if (owned_) {
+        FreeMemory(data_);
+        return;
+    }
+#ifndef _WIN32
+    if (data_) {
+        ::munmap(data_, size_);
+    }
+#endif
+}
+
+bool FindMappedFileRegion(const void* data, size_t size, std::string* path, uint64_t* offset) {
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    std::lock_guard<std::mutex> lock(mapped_files_mutex);
+    for (const MappedFile* file : mapped_files) {
+        const uint8_t* base = file->GetData();
+        if (begin >= base && begin <= base + file->GetSize() &&
+            size <= static_cast<size_t>(base + file->GetSize() - begin)) {
+            *path = file->GetPath();
+            *offset = static_cast<uint64_t>(begin - base);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace inferunity
@@ -0,0 +1,761 @@
+// 静态内存规划器实现
+// 参考TFLite的ArenaPlanner（SimpleMemoryArena::Allocate的最佳空隙查找）
+// 与Pisarchyk & Lee (2020)的Greedy by Size / Greedy by Breadth算法
+
+#include "inferunity/memory_planner.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "inferunity/logger.h"
+#include "core/align_utils.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+bool LifetimesOverlap(const MemoryPlanEntry& a, const MemoryPlanEntry& b) {
+    // 同一算子的输入（death == i）和输出（birth == i）同时存活
+    return a.birth <= b.death && b.birth <= a.death;
+}
+
+// 已放置张量按偏移有序，在与当前张量生命周期冲突的张量之间寻找能容纳它的最小空隙
+class OffsetAssigner {
+public:
+    explicit OffsetAssigner(std::vector<MemoryPlanEntry>& entries) : entries_(entries) {}
+    
+    void Assign(size_t index) {
+        MemoryPlanEntry& entry = entries_[index];
+        size_t best_offset = std::numeric_limits<size_t>::max();
+        size_t best_gap = std::numeric_limits<size_t>::max();
+        size_t prev_end = 0;
+        for (size_t placed_index : placed_) {
+            const MemoryPlanEntry& placed = entries_[placed_index];
+            if (!LifetimesOverlap(entry, placed)) {
+                continue;
+            }
+            if (placed.offset >= prev_end) {
+                const size_t gap = placed.offset - prev_end;
+                if (gap >= entry.size && gap < best_gap) {
+                    best_gap = gap;
+                    best_offset = prev_end;
+                }
+            }
+            prev_end = std::max(prev_end, placed.offset + placed.size);
+        }
+        entry.offset = best_offset != std::numeric_limits<size_t>::max() ? best_offset : prev_end;
+        
+        auto pos = std::upper_bound(placed_.begin(), placed_.end(), index,
+                                    [this](size_t lhs, size_t rhs) {
+                                        return entries_[lhs].offset < entries_[rhs].offset;
+                                    });
+        placed_.insert(pos, index);
+    }
+
+private:
+    std::vector<MemoryPlanEntry>& entries_;
+    std::vector<size_t> placed_;
+};
+
+// 切片按序号依次占据整体的连续字节：除切分轴外各维与整体相同，切片在该轴上的长度之和等于整体，
+// 且切分轴之前各维乘积为1。只有一个切片时它就是整体本身。偏移须满足规划的对齐
+bool ComputeSliceOffsets(const MemoryPlanEntry& whole, const std::vector<const MemoryPlanEntry*>& parts,
+                         size_t alignment, std::vector<size_t>* offsets) {
+    const std::vector<int64_t>& dims = whole.shape.dims;
+    size_t axis = dims.size();
+    for (const MemoryPlanEntry* part : parts) {
+        if (part->dtype != whole.dtype || part->shape.dims.size() != dims.size()) {
+            return false;
+        }
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (part->shape.dims[d] != dims[d]) {
+                axis = std::min(axis, d);
+            }
+        }
+    }
+    if (axis == dims.size()) {
+        if (parts.size() != 1) {
+            return false;
+        }
+        offsets->assign(1, 0);
+        return true;
+    }
+    int64_t total = 0;
+    for (const MemoryPlanEntry* part : parts) {
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (d != axis && part->shape.dims[d] != dims[d]) {
+                return false;
+            }
+        }
+        total += part->shape.dims[axis];
+    }
+    for (size_t d = 0; d < axis; ++d) {
+        if (dims[d] != 1) {
+            return false;
+        }
+    }
+    if (total != dims[axis]) {
+        return false;
+    }
+    offsets->clear();
+    size_t offset = 0;
+    for (const MemoryPlanEntry* part : parts) {
+        if (offset % alignment != 0) {
+            return false;
+        }
+        offsets->push_back(offset);
+        offset += static_cast<size_t>(part->shape.GetElementCount()) * GetDataTypeSize(part->dtype);
+    }
+    return true;
+}
+
+// 放在输出内部的输入（Pad）：除axis轴外各维与整体相同，axis之前各维乘积为1时它在整体中连续，
+// 从axis轴的start处开始。偏移须满足规划的对齐
+bool ComputeInteriorOffset(const MemoryPlanEntry& whole, const MemoryPlanEntry& part, int axis, int64_t start,
+                           size_t alignment, size_t* offset) {
+    const std::vector<int64_t>& dims = whole.shape.dims;
+    if (part.dtype != whole.dtype || part.shape.dims.size() != dims.size() || axis < 0 ||
+        static_cast<size_t>(axis) >= dims.size() || start < 0 ||
+        start + part.shape.dims[static_cast<size_t>(axis)] > dims[static_cast<size_t>(axis)]) {
+        return false;
+    }
+    int64_t inner = 1;
+    for (size_t d = 0; d < dims.size(); ++d) {
+        if (d != static_cast<size_t>(axis) && part.shape.dims[d] != dims[d]) {
+            return false;
+        }
+        if (d < static_cast<size_t>(axis) && dims[d] != 1) {
+            return false;
+        }
+        if (d > static_cast<size_t>(axis)) {
+            inner *= dims[d];
+        }
+    }
+    *offset = static_cast<size_t>(start * inner) * GetDataTypeSize(whole.dtype);
+    return *offset % alignment == 0;
+}
+
+size_t ComputeArenaSize(const std::vector<MemoryPlanEntry>& entries) {
+    size_t arena = 0;
+    for (const auto& entry : entries) {
+        arena = std::max(arena, entry.offset + entry.size);
+    }
+    return arena;
+}
+
+void PlanGreedyBySize(std::vector<MemoryPlanEntry>& entries) {
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+        if (entries[a].size != entries[b].size) return entries[a].size > entries[b].size;
+        return entries[a].birth < entries[b].birth;
+    });
+    
+    OffsetAssigner assigner(entries);
+    for (size_t index : order) {
+        assigner.Assign(index);
+    }
+}
+
+// 每个执行步骤上存活的张量（birth <= step <= death）
+std::vector<std::vector<size_t>> CollectLiveSets(const std::vector<MemoryPlanEntry>& entries,
+                                                 int64_t num_steps) {
+    std::vector<std::vector<size_t>> live(static_cast<size_t>(std::max<int64_t>(num_steps, 0)));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const int64_t first = std::max<int64_t>(entries[i].birth, 0);
+        const int64_t last = std::min<int64_t>(entries[i].death, num_steps - 1);
+        for (int64_t step = first; step <= last; ++step) {
+            live[static_cast<size_t>(step)].push_back(i);
+        }
+    }
+    return live;
+}
+
+void PlanGreedyByBreadth(std::vector<MemoryPlanEntry>& entries, int64_t num_steps) {
+    auto live = CollectLiveSets(entries, num_steps);
+    std::vector<size_t> breadth(live.size(), 0);
+    std::vector<size_t> steps(live.size());
+    for (size_t step = 0; step < live.size(); ++step) {
+        steps[step] = step;
+        for (size_t index : live[step]) {
+            breadth[step] += entries[index].size;
+        }
+    }
+    std::stable_sort(steps.begin(), steps.end(), [&breadth](size_t a, size_t b) {
+        return breadth[a] > breadth[b];
+    });
+    
+    OffsetAssigner assigner(entries);
+    std::vector<bool> assigned(entries.size(), false);
+    for (size_t step : steps) {
+        std::vector<size_t>& tensors = live[step];
+        std::stable_sort(tensors.begin(), tensors.end(), [&entries](size_t a, size_t b) {
+            return entries[a].size > entries[b].size;
+        });
+        for (size_t index : tensors) {
+            if (!assigned[index]) {
+                assigner.Assign(index);
+                assigned[index] = true;
+            }
+        }
+    }
+}
+
+// 重计算比保留输出更划算的廉价算子：逐元素与归一化，输出大小与输入相当、计算量小
+bool IsRecomputable(const std::string& op_type) {
+    static const std::unordered_set<std::string> kOps = {
+        "Relu", "LeakyRelu", "Sigmoid", "Tanh", "Gelu", "Silu", "HardSigmoid", "HardSwish", "Clip",
+        "Neg", "Abs", "Sqrt", "Exp", "Cast", "Add", "Sub", "Mul", "Div", "FusedElementwise",
+        "BatchNormalization", "LayerNormalization", "RMSNormalization", "InstanceNormalization"};
+    return kOps.count(op_type) != 0;
+}
+
+// 在活跃内存最大的那一步上减少一个张量：找跨过该步（该步本身不使用）、由廉价算子产生的最大张量，
+// 在该步之后第一次使用前复制其生产者重新计算，之后的使用者改读副本（该步之前没有使用者时直接推迟生产者）。
+// 生产者的输入须在副本执行时仍然存活
+// （或不在arena中），这样不会延长其他张量的生命周期。找不到时返回false
+bool RecomputeAcrossPeak(Graph* graph, const MemoryPlan& plan,
+                         std::vector<std::pair<Node*, const Node*>>* recomputed) {
+    std::vector<Node*> order = graph->TopologicalSort();
+    if (order.empty()) {
+        return false;
+    }
+    std::unordered_map<const Node*, int64_t> position;
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = static_cast<int64_t>(i);
+    }
+    
+    // 共享缓冲的张量并入根：根的块从最早的出生存活到最晚的死亡
+    std::unordered_map<const Value*, size_t> index;
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        index[plan.entries[i].value] = i;
+    }
+    std::vector<size_t> root(plan.entries.size());
+    std::vector<int64_t> birth(plan.entries.size()), death(plan.entries.size());
+    std::vector<bool> shared(plan.entries.size(), false);
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        size_t r = i;
+        for (size_t guard = 0; plan.entries[r].shares_with && guard < plan.entries.size(); ++guard) {
+            auto it = index.find(plan.entries[r].shares_with);
+            if (it == index.end()) break;
+            r = it->second;
+        }
+        root[i] = r;
+        birth[i] = plan.entries[i].birth;
+        death[i] = plan.entries[i].death;
+    }
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        if (root[i] != i) {
+            shared[root[i]] = true;
+            birth[root[i]] = std::min(birth[root[i]], plan.entries[i].birth);
+            death[root[i]] = std::max(death[root[i]], plan.entries[i].death);
+        }
+    }
+    std::vector<int64_t> delta(order.size() + 1, 0);
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        if (root[i] == i && birth[i] >= 0 && death[i] < static_cast<int64_t>(order.size())) {
+            delta[birth[i]] += static_cast<int64_t>(plan.entries[i].size);
+            delta[death[i] + 1] -= static_cast<int64_t>(plan.entries[i].size);
+        }
+    }
+    int64_t peak_step = 0;
+    int64_t live = 0, peak_live = -1;
+    for (size_t step = 0; step < order.size(); ++step) {
+        live += delta[step];
+        if (live > peak_live) {
+            peak_live = live;
+            peak_step = static_cast<int64_t>(step);
+        }
+    }
+    
+    const MemoryPlanEntry* best = nullptr;
+    int64_t best_first_use = 0;
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        const MemoryPlanEntry& entry = plan.entries[i];
+        if (root[i] != i || shared[i] || entry.birth >= peak_step || entry.death <= peak_step ||
+            (best && entry.size <= best->size)) {
+            continue;
+        }
+        const Node* producer = entry.value->GetProducer();
+        if (!producer || producer->GetOutputs().size() != 1 || !IsRecomputable(producer->GetOpType())) {
+            continue;
+        }
+        int64_t first_use = std::numeric_limits<int64_t>::max();
+        bool used_at_peak = false;
+        for (const Node* consumer : entry.value->GetConsumers()) {
+            auto it = position.find(consumer);
+            if (it == position.end()) continue;
+            used_at_peak = used_at_peak || it->second == peak_step;
+            if (it->second > peak_step) first_use = std::min(first_use, it->second);
+        }
+        if (used_at_peak || first_use == std::numeric_limits<int64_t>::max()) {
+            continue;
+        }
+        bool inputs_live = true;
+        const auto& inputs = producer->GetInputs();
+        for (size_t k = 0; k < inputs.size() && inputs_live; ++k) {
+            // 重复的输入无法用AddInput复制
+            inputs_live = inputs[k] && std::find(inputs.begin(), inputs.begin() + k, inputs[k]) == inputs.begin() + k;
+            auto it = inputs_live ? index.find(inputs[k]) : index.end();
+            inputs_live = inputs_live && (it == index.end() || death[root[it->second]] >= first_use);
+        }
+        if (inputs_live) {
+            best = &entry;
+            best_first_use = first_use;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+    
+    Value* original = best->value;
+    Node* producer = original->GetProducer();
+    const bool used_before = std::any_of(original->GetConsumers().begin(), original->GetConsumers().end(),
+                                         [&](const Node* consumer) {
+                                             auto it = position.find(consumer);
+                                             return it != position.end() && it->second < peak_step;
+                                         });
+    if (!used_before) {
+        // 峰值之前没有使用者：直接把生产者推迟到第一次使用之前，不需要副本
+        order.insert(order.begin() + best_first_use, producer);
+        order.erase(order.begin() + position[producer]);
+        Status status = graph->ReorderNodes(order);
+        (void)status;  // order覆盖全部节点
+        return true;
+    }
+    Node* clone = graph->AddNode(producer->GetOpType(),
+                                 producer->GetName().empty() ? "" : producer->GetName() + "_recompute");
+    for (const auto& attr : producer->GetAttributes()) {
+        clone->SetAttribute(attr.first, attr.second);
+    }
+    for (Value* input : producer->GetInputs()) {
+        clone->AddInput(input);
+    }
+    clone->SetDevice(producer->GetDevice());
+    Value* copy = graph->AddValue();
+    if (!original->GetName().empty()) {
+        copy->SetName(original->GetName() + "_recompute");
+    }
+    auto tensor = original->GetTensor();
+    copy->SetTensor(std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr,
+                                             tensor->GetLayout(), tensor->GetDeviceType()));
+    clone->AddOutput(copy);
+    const std::vector<Node*> consumers = original->GetConsumers();
+    for (Node* consumer : consumers) {
+        auto it = position.find(consumer);
+        if (it != position.end() && it->second > peak_step) {
+            consumer->ReplaceInput(original, copy);
+        }
+    }
+    
+    // 副本紧挨在第一次使用之前执行
+    order.insert(order.begin() + best_first_use, clone);
+    Status status = graph->ReorderNodes(order);
+    (void)status;  // order覆盖全部节点
+    if (recomputed) {
+        recomputed->emplace_back(clone, producer);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+const char* MemoryPlanStrategyName(MemoryPlanStrategy strategy) {
+    switch (strategy) {
+        case MemoryPlanStrategy::AUTO: return "auto";
+        case MemoryPlanStrategy::GREEDY_BY_SIZE: return "greedy_by_size";
+        case MemoryPlanStrategy::GREEDY_BY_BREADTH: return "greedy_by_breadth";
+    }
+    return "unknown";
+}
+
+Status PlanMemory(const Graph* graph, const std::vector<TensorLifetime>& lifetimes,
+                  const MemoryPlannerOptions& options, MemoryPlan* plan) {
+    if (!graph || !plan) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph or plan is null");
+    }
+    if (options.alignment == 0 || (options.alignment & (options.alignment - 1)) != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Memory plan alignment must be a power of two");
+    }
+    
+    *plan = MemoryPlan();
+    plan->alignment = options.alignment;
+    
+    std::unordered_set<const Value*> graph_outputs(graph->GetOutputs().begin(),
+                                                   graph->GetOutputs().end());
+    const int64_t num_steps = static_cast<int64_t>(graph->GetNodes().size());
+    
+    // 收集可规划的张量：图输入/常量（无生产者，birth < 0）、视图和形状未知的Value不参与
+    std::vector<MemoryPlanEntry> entries;
+    for (const auto& lifetime : lifetimes) {
+        Value* value = static_cast<Value*>(lifetime.value_ptr);
+        if (!value || lifetime.birth < 0 || !value->GetProducer() || lifetime.is_alias) continue;
+        if (!options.include_graph_outputs && graph_outputs.count(value)) continue;
+        std::shared_ptr<Tensor> tensor;
+        if (options.tensors) {
+            auto it = options.tensors->find(value);
+            if (it != options.tensors->end()) tensor = it->second;
+        } else {
+            tensor = value->GetTensor();
+        }
+        if (!tensor || tensor->GetDeviceType() != DeviceType::CPU) continue;
+        // 动态维度的大小要到运行时才知道
+        const Shape& shape = tensor->GetShape();
+        if (shape.IsDynamic()) continue;
+        const size_t bytes = static_cast<size_t>(shape.GetElementCount()) * GetDataTypeSize(tensor->GetDataType());
+        if (bytes == 0) continue;
+        
+        MemoryPlanEntry entry;
+        entry.value = value;
+        entry.shape = Shape(shape.dims);
+        entry.dtype = tensor->GetDataType();
+        entry.layout = tensor->GetLayout();
+        entry.size = AlignUp(bytes, options.alignment);
+        entry.birth = lifetime.birth;
+        entry.death = std::max(lifetime.birth, lifetime.death);
+        plan->naive_size += entry.size;
+        entries.push_back(entry);
+    }
+    
+    std::unordered_map<const Value*, size_t> index_of;
+    for (size_t i = 0; i < entries.size(); ++i) index_of.emplace(entries[i].value, i);
+    auto bytes_of = [](const MemoryPlanEntry& entry) {
+        return static_cast<size_t>(entry.shape.GetElementCount()) * GetDataTypeSize(entry.dtype);
+    };
+    
+    // 原地执行：输出与所复用的输入共用缓冲（链式复用归到最早的张量）
+    std::unordered_map<const Value*, const Value*> inplace_of;
+    // 一个Value可以同时是Concat的输出和Split的输入，切片按切分节点（Split本身或产生整体的Concat）分组
+    struct SliceGroup {
+        const Value* whole = nullptr;
+        std::vector<std::pair<int, const Value*>> parts;
+        int axis = -1;          // Pad：唯一的切片在整体内部的位置
+        int64_t start = 0;
+    };
+    std::vector<SliceGroup> slices;
+    std::unordered_map<const Node*, size_t> slice_group_of;
+    for (const auto& lifetime : lifetimes) {
+        const Value* value = static_cast<const Value*>(lifetime.value_ptr);
+        if (lifetime.inplace_of) {
+            inplace_of.emplace(value, static_cast<const Value*>(lifetime.inplace_of));
+        }
+        if (lifetime.slice_of) {
+            const Value* whole = static_cast<const Value*>(lifetime.slice_of);
+            const auto& producer_inputs = value->GetProducer()->GetInputs();
+            const Node* node = std::find(producer_inputs.begin(), producer_inputs.end(), whole) != producer_inputs.end()
+                ? value->GetProducer() : whole->GetProducer();
+            auto group = slice_group_of.emplace(node, slices.size());
+            if (group.second) {
+                slices.push_back(SliceGroup{whole, {}, lifetime.slice_axis, lifetime.slice_start});
+            }
+            slices[group.first->second].parts.emplace_back(lifetime.slice_index, value);
+        }
+    }
+    if (!inplace_of.empty()) {
+        std::vector<size_t> by_birth(entries.size());
+        for (size_t i = 0; i < by_birth.size(); ++i) by_birth[i] = i;
+        std::stable_sort(by_birth.begin(), by_birth.end(), [&entries](size_t a, size_t b) {
+            return entries[a].birth < entries[b].birth;
+        });
+        for (size_t index : by_birth) {
+            auto it = inplace_of.find(entries[index].value);
+            if (it == inplace_of.end()) continue;
+            auto source = index_of.find(it->second);
+            if (source == index_of.end()) continue;
+            const MemoryPlanEntry& owner = entries[source->second].shares_with
+                ? entries[index_of.at(entries[source->second].shares_with)] : entries[source->second];
+            if (bytes_of(owner) != bytes_of(entries[index])) continue;
+            entries[index].shares_with = owner.value;
+        }
+    }
+    
+    // 切片别名：Concat/Pad的输入、Split的输出（TensorLifetime::slice_of）连同各自的原地执行分组放在整体缓冲内的
+    // 对应偏移。某个切片不在规划内、切片不连续或偏移不满足对齐时整组照常独立分配，由内核拷贝
+    std::vector<size_t> inplace_root(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        inplace_root[i] = entries[i].shares_with ? index_of.at(entries[i].shares_with) : i;
+    }
+    for (SliceGroup& group_slices : slices) {
+        auto whole = index_of.find(group_slices.whole);
+        auto& parts = group_slices.parts;
+        if (whole == index_of.end()) continue;
+        std::sort(parts.begin(), parts.end());
+        std::vector<size_t> groups;
+        std::vector<const MemoryPlanEntry*> part_entries;
+        for (size_t k = 0; k < parts.size(); ++k) {
+            auto part = index_of.find(parts[k].second);
+            if (parts[k].first != static_cast<int>(k) || part == index_of.end()) break;
+            const size_t group = inplace_root[part->second];
+            // 分组已放进别的缓冲，或整体本身就在这个分组里
+            bool nested = entries[group].shares_with != nullptr;
+            size_t up = whole->second;
+            while (!nested) {
+                nested = up == group;
+                if (!entries[up].shares_with) break;
+                up = index_of.at(entries[up].shares_with);
+            }
+            if (nested || std::find(groups.begin(), groups.end(), group) != groups.end()) break;
+            groups.push_back(group);
+            part_entries.push_back(&entries[part->second]);
+        }
+        std::vector<size_t> offsets(1, 0);
+        if (groups.size() != parts.size()) {
+            continue;
+        }
+        if (group_slices.axis >= 0) {
+            if (parts.size() != 1 || !ComputeInteriorOffset(entries[whole->second], *part_entries[0], group_slices.axis,
+                                                             group_slices.start, options.alignment, &offsets[0])) {
+                continue;
+            }
+        } else if (!ComputeSliceOffsets(entries[whole->second], part_entries, options.alignment, &offsets)) {
+            continue;
+        }
+        for (size_t k = 0; k < groups.size(); ++k) {
+            entries[groups[k]].shares_with = group_slices.whole;
+            entries[groups[k]].alias_offset = offsets[k];
+        }
+    }
+    
+    // 共用缓冲的张量并为一块：块取最外层张量的大小，生命周期覆盖块内所有张量
+    std::vector<size_t> root_of(entries.size());
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        size_t root = i;
+        while (entries[root].shares_with) root = index_of.at(entries[root].shares_with);
+        root_of[i] = root;
+        if (root == i) roots.push_back(i);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        MemoryPlanEntry& root = entries[root_of[i]];
+        root.birth = std::min(root.birth, entries[i].birth);
+        root.death = std::max(root.death, entries[i].death);
+    }
+    std::vector<MemoryPlanEntry> blocks;
+    blocks.reserve(roots.size());
+    for (size_t root : roots) blocks.push_back(entries[root]);
+    
+    for (const auto& tensors : CollectLiveSets(blocks, num_steps)) {
+        size_t breadth = 0;
+        for (size_t index : tensors) breadth += blocks[index].size;
+        plan->lower_bound = std::max(plan->lower_bound, breadth);
+    }
+    
+    if (options.strategy == MemoryPlanStrategy::GREEDY_BY_SIZE) {
+        PlanGreedyBySize(blocks);
+        plan->strategy = MemoryPlanStrategy::GREEDY_BY_SIZE;
+    } else if (options.strategy == MemoryPlanStrategy::GREEDY_BY_BREADTH) {
+        PlanGreedyByBreadth(blocks, num_steps);
+        plan->strategy = MemoryPlanStrategy::GREEDY_BY_BREADTH;
+    } else {
+        std::vector<MemoryPlanEntry> by_breadth = blocks;
+        PlanGreedyBySize(blocks);
+        PlanGreedyByBreadth(by_breadth, num_steps);
+        plan->strategy = MemoryPlanStrategy::GREEDY_BY_SIZE;
+        if (ComputeArenaSize(by_breadth) < ComputeArenaSize(blocks)) {
+            blocks.swap(by_breadth);
+            plan->strategy = MemoryPlanStrategy::GREEDY_BY_BREADTH;
+        }
+    }
+    plan->arena_size = ComputeArenaSize(blocks);
+    
+    // 块内的张量取所在缓冲的偏移加上自己的别名偏移；先输出各块，再输出块内的张量
+    std::vector<bool> resolved(entries.size(), false);
+    for (size_t k = 0; k < roots.size(); ++k) {
+        entries[roots[k]].offset = blocks[k].offset;
+        resolved[roots[k]] = true;
+    }
+    std::vector<size_t> chain;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        for (size_t up = i; !resolved[up]; up = index_of.at(entries[up].shares_with)) {
+            chain.push_back(up);
+        }
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            MemoryPlanEntry& entry = entries[*it];
+            entry.offset = entries[index_of.at(entry.shares_with)].offset + entry.alias_offset;
+            resolved[*it] = true;
+        }
+        chain.clear();
+    }
+    std::vector<MemoryPlanEntry> ordered;
+    ordered.reserve(entries.size());
+    for (size_t root : roots) ordered.push_back(entries[root]);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (root_of[i] != i) ordered.push_back(entries[i]);
+    }
+    entries.swap(ordered);
+    plan->entries = std::move(entries);
+    return Status::Ok();
+}
+
+Status PlanMemory(const Graph* graph, const MemoryPlannerOptions& options, MemoryPlan* plan) {
+    return PlanMemory(graph, AnalyzeTensorLifetimes(graph), options, plan);
+}
+
+Status PlanMemoryWithinBudget(Graph* graph, size_t budget, const MemoryPlannerOptions& options,
+                              MemoryPlan* plan, std::vector<std::pair<Node*, const Node*>>* recomputed) {
+    if (!graph || !plan) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph or plan is null");
+    }
+    // 每次重计算只减少峰值处的一个张量，上限防止病态的图反复改写
+    constexpr size_t kMaxRecomputations = 256;
+    size_t num_recomputed = 0;
+    for (;;) {
+        Status status = PlanMemory(graph, options, plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (budget == 0 || plan->arena_size <= budget) {
+            break;
+        }
+        if (num_recomputed >= kMaxRecomputations || !RecomputeAcrossPeak(graph, *plan, recomputed)) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
+                               "Activation memory budget of " + std::to_string(budget) +
+                               " bytes is infeasible: the memory plan needs " +
+                               std::to_string(plan->arena_size) + " bytes after recomputing " +
+                               std::to_string(num_recomputed) + " tensors");
+        }
+        ++num_recomputed;
+    }
+    if (num_recomputed > 0) {
+        LOG_INFO("Recomputed " + std::to_string(num_recomputed) + " tensors to fit the activation budget of " +
+                 std::to_string(budget) + " bytes");
+    }
+    return Status::Ok();
+}
+
+// ---------------------------------------------------------------------------
+// MemoryAccount
+// ---------------------------------------------------------------------------
+void MemoryAccount::OnAllocate(size_t size) {
+    const size_t allocated = allocated_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = peak_allocated_bytes_.load(std::memory_order_relaxed);
+    while (allocated > peak && !peak_allocated_bytes_.compare_exchange_weak(peak, allocated,
+                                                                            std::memory_order_relaxed)) {
+    }
+    allocation_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryAccount::OnFree(size_t size) {
+    allocated_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    free_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+MemoryStats MemoryAccount::GetStats() const {
+    return MemoryStats{allocated_bytes_.load(std::memory_order_relaxed),
+                       peak_allocated_bytes_.load(std::memory_order_relaxed),
+                       allocation_count_.load(std::memory_order_relaxed),
+                       free_count_.load(std::memory_order_relaxed)};
+}
+
+// ---------------------------------------------------------------------------
+// MemoryArena
+// ---------------------------------------------------------------------------
+std::shared_ptr<MemoryArena> MemoryArena::Create(size_t size, size_t alignment,
+                                                 std::shared_ptr<MemoryAccount> account,
+                                                 HugePagePolicy huge_pages) {
+    std::shared_ptr<MemoryArena> arena(new MemoryArena());
+    arena->size_ = size;
+    // 大页区域按2MB对齐，满足任何不超过它的对齐要求
+    if (alignment <= kHugePageSize) {
+        arena->huge_pages_ = HugePageRegion::Allocate(size, huge_pages);
+    }
+    if (arena->huge_pages_) {
+        arena->base_ = arena->huge_pages_->GetData();
+    } else if (size > 0) {
+        arena->base_ = AllocateMemory(size, alignment);
+        if (!arena->base_) {
+            return nullptr;
+        }
+    }
+    if (account) {
+        account->OnAllocate(size);
+        arena->account_ = std::move(account);
+    }
+    return arena;
+}
+
+MemoryArena::~MemoryArena() {
+    if (base_ && !huge_pages_) {
+        FreeMemory(base_);
+    }
+    if (account_) {
+        account_->OnFree(size_);
+    }
+}
+
+Status BindMemoryPlan(const MemoryPlan& plan, const std::shared_ptr<MemoryArena>& arena) {
+    if (!arena || arena->GetSize() < plan.arena_size) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Memory arena is smaller than the planned size");
+    }
+    uint8_t* base = static_cast<uint8_t*>(arena->GetBase());
+    for (const auto& entry : plan.entries) {
+        // 删除器捕获arena：视图存活期间arena不会被释放
+        std::shared_ptr<Tensor> view(
+            new Tensor(entry.shape, entry.dtype, base + entry.offset, entry.layout, DeviceType::CPU),
+            [arena](Tensor* tensor) { delete tensor; });
+        entry.value->SetTensor(view);
+    }
+    return Status::Ok();
+}
+
+ArenaAllocator::ArenaAllocator(std::shared_ptr<MemoryArena> arena, size_t alignment)
+    : arena_(std::move(arena)), alignment_(std::max<size_t>(alignment, 16)) {
+}
+
+void* ArenaAllocator::Allocate(size_t size) {
+    return AllocateAligned(size, alignment_);
+}
+
+void* ArenaAllocator::AllocateAligned(size_t size, size_t alignment) {
+    alignment = std::max(alignment, alignment_);
+    if (arena_ && arena_->GetBase()) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(arena_->GetBase());
+        const uintptr_t begin = AlignUp(base + offset_, alignment);
+        if (begin + size <= base + arena_->GetSize()) {
+            offset_ = begin + size - base;
+            peak_offset_ = std::max(peak_offset_, offset_);
+            ++allocation_count_;
+            return reinterpret_cast<void*>(begin);
+        }
+    }
+    ++overflow_count_;
+    ++allocation_count_;
+    return AllocateMemory(size, alignment);
+}
+
+void ArenaAllocator::Free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    ++free_count_;
+    if (!Owns(ptr)) {
+        FreeMemory(ptr);
+    }
+}
+
+bool ArenaAllocator::GetStats(MemoryStats* stats) const {
+    stats->allocated_bytes = offset_;
+    stats->peak_allocated_bytes = peak_offset_;
+    stats->allocation_count = allocation_count_;
+    stats->free_count = free_count_;
+    return true;
+}
+
+void ArenaAllocator::Reset() {
+    offset_ = 0;
+}
+
+bool ArenaAllocator::Owns(const void* ptr) const {
+    if (!arena_ || !arena_->GetBase()) {
+        return false;
+    }
+    const uint8_t* base = static_cast<const uint8_t*>(arena_->GetBase());
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    return p >= base && p < base + arena_->GetSize();
+}
+
+} // namespace inferunity
@@ -1,188 +1,523 @@
 // 内存池实现
-// 参考 ONNX Runtime 和 TensorFlow 的内存池设计
+// 参考 TCMalloc/jemalloc 的分级（size class）设计与 ONNX Runtime BFCArena 的统计语义：
+// 请求大小向上取整到 2^k 或 1.5*2^k 的级别，每个级别维护空闲链表；
+// 每个线程持有本地缓存，与中心池之间按批次补充/归还，释放时通过块头部O(1)定位级别。
+// 多NUMA节点时中心池按节点分槽（槽0给未绑定节点的线程），绑定到节点的线程只复用本节点的块，
+// 大块在首次触碰前用mbind设为节点本地，小块依靠绑核线程的首次触碰落在本节点。
+// 空闲块按闲置时间归还系统：先madvise(MADV_DONTNEED)交还物理页，超过TTL后整块释放（见TrimMemory）
 
 #include "inferunity/memory.h"
 #include "inferunity/logger.h"
+#include "inferunity/numa.h"
+#include "core/align_utils.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <mutex>
-#include <unordered_map>
 #include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace inferunity {
 
-// 内存块
-struct MemoryBlock {
-    void* ptr;
-    size_t size;
-    bool in_use;
-    std::chrono::steady_clock::time_point allocated_time;
-    
-    MemoryBlock() : ptr(nullptr), size(0), in_use(false),
-                    allocated_time(std::chrono::steady_clock::now()) {}
+namespace {
+
+constexpr size_t kMinClassShift = 5;                  // 最小级别32字节
+constexpr size_t kMaxClassShift = 30;                 // 超过1GB的请求直接分配，不缓存
+constexpr size_t kNumSizeClasses = 2 * (kMaxClassShift - kMinClassShift) + 1;
+constexpr uint32_t kDirectClass = static_cast<uint32_t>(kNumSizeClasses);
+constexpr size_t kBlockAlignment = 64;                // 缓存块统一按64字节对齐，可满足任意不超过64的请求
+constexpr size_t kMaxThreadCachedBlock = 256 * 1024;  // 更大的块直接进出中心池
+constexpr size_t kThreadCacheMaxBytes = 4 * 1024 * 1024;
+constexpr size_t kTrimMinBytes = 64 * 1024 * 1024;    // 池小于该值时不按阈值回收，避免反复malloc/free
+constexpr uint64_t kBlockMagic = 0x496e66556e697479ULL;
+constexpr size_t kNumaBindMinBytes = 64 * 1024;       // 更小的块一般共享页，只靠首次触碰
+
+// 位于用户指针之前的块头部
+struct BlockHeader {
+    uint64_t magic;          // kBlockMagic ^ 用户地址，用于识别非本池指针
+    void* raw;               // malloc返回的原始指针
+    BlockHeader* next;       // 空闲链表
+    size_t capacity;         // 级别大小（直接分配时为请求大小）
+    int64_t released_time;   // 归还中心池的时间（steady_clock计数）
+    uint32_t size_class;
+    uint32_t in_use;
+    uint32_t slot;           // 所属的中心池槽（见MemoryPoolImpl::CurrentSlot）
+    uint32_t decommitted;    // 物理页已用MADV_DONTNEED归还，内容为零页
+};
+
+size_t ClassSize(uint32_t size_class) {
+    const size_t shift = kMinClassShift + size_class / 2;
+    return (size_class & 1) ? (size_t(3) << (shift - 1)) : (size_t(1) << shift);
+}
+
+// 2^k 与 1.5*2^k 交替：32, 48, 64, 96, 128, ...，内部碎片不超过1/3
+uint32_t SizeClassOf(size_t size) {
+    if (size <= (size_t(1) << kMinClassShift)) {
+        return 0;
+    }
+    size_t shift = 0;
+    for (size_t v = size - 1; v > 1; v >>= 1) {
+        ++shift;
+    }
+    // 2^shift < size <= 2^(shift+1)
+    const uint32_t base = static_cast<uint32_t>(2 * (shift - kMinClassShift));
+    return size <= (size_t(3) << (shift - 1)) ? base + 1 : base + 2;
+}
+
+inline BlockHeader* HeaderOf(void* ptr) {
+    return reinterpret_cast<BlockHeader*>(ptr) - 1;
+}
+
+inline void* UserPointer(BlockHeader* header) {
+    return header + 1;
+}
+
+int64_t NowTicks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+int64_t MillisecondsToTicks(int64_t ms) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::milliseconds(ms)).count();
+}
+
+size_t ProcessResidentBytes() {
+#ifndef _WIN32
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (statm >> total_pages >> resident_pages) {
+        return resident_pages * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+// 线程本地缓存：每个级别一条无锁链表
+struct ThreadCacheBin {
+    BlockHeader* head = nullptr;
+    uint32_t count = 0;
+};
+
+struct ThreadCache {
+    ThreadCacheBin bins[kNumSizeClasses];
+    size_t bytes = 0;
+    uint64_t epoch = 0;
+    uint32_t slot = 0;  // 缓存中的块全部属于这个槽
     
-    MemoryBlock(void* p, size_t s) 
-        : ptr(p), size(s), in_use(true),
-          allocated_time(std::chrono::steady_clock::now()) {}
+    ~ThreadCache();
 };
 
+// 线程退出后（thread_local已析构）仍可能有释放请求，此时直接走中心池
+thread_local bool tls_cache_alive = false;
+
+ThreadCache* CurrentThreadCache() {
+    thread_local ThreadCache cache;
+    thread_local bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        tls_cache_alive = true;
+    }
+    return tls_cache_alive ? &cache : nullptr;
+}
+
+// 每个级别在线程缓存中最多保留的块数；批次为其一半
+uint32_t ThreadCacheLimit(size_t capacity) {
+    const size_t limit = (64 * 1024) / capacity;
+    return static_cast<uint32_t>(std::max<size_t>(2, std::min<size_t>(64, limit)));
+}
+
+} // anonymous namespace
+
 // 内存池实现
 class MemoryPoolImpl {
 private:
-    std::mutex mutex_;
-    std::unordered_map<void*, MemoryBlock> blocks_;
-    size_t total_allocated_ = 0;
-    size_t peak_allocated_ = 0;
-    size_t current_allocated_ = 0;
-    size_t unused_memory_ = 0;  // 未使用内存总量
-    size_t max_pool_size_ = 0;  // 最大池大小（0表示无限制）
-    double release_threshold_ = 0.5;  // 释放阈值：当未使用内存超过总内存的50%时触发释放
-    
-    // 对齐分配
-    void* AllocateAligned(size_t size, size_t alignment) {
-        // 需要额外空间存储原始指针（sizeof(uintptr_t)）和对齐（alignment - 1）
-        size_t header_size = sizeof(uintptr_t);
-        size_t total_size = size + alignment - 1 + header_size;
-        void* raw_ptr = std::malloc(total_size);
-        if (!raw_ptr) {
-            return nullptr;
+    // 中心池的每个级别单独加锁，不同级别的分配互不竞争
+    struct CentralBin {
+        std::mutex mutex;
+        BlockHeader* head = nullptr;
+        size_t count = 0;
+    };
+    
+    struct SlotBins {
+        CentralBin bins[kNumSizeClasses];
+    };
+    
+    // 单节点时只有槽0；多节点时槽0给未绑定的线程，槽n + 1给绑定到节点n的线程
+    size_t num_slots_ = 1;
+    std::unique_ptr<SlotBins[]> slots_;
+    std::atomic<size_t> total_allocated_{0};     // 池持有的全部块容量（使用中 + 缓存）
+    std::atomic<size_t> current_allocated_{0};   // 使用中的块容量
+    std::atomic<size_t> peak_allocated_{0};
+    std::atomic<size_t> block_count_{0};
+    std::atomic<size_t> cached_count_{0};        // 线程缓存与中心池中的空闲块数
+    std::atomic<size_t> max_pool_size_{0};       // 最大池大小（0表示无限制）
+    std::atomic<double> release_threshold_{0.5}; // 释放阈值：未使用内存占比超过该值时回收中心池
+    std::atomic<uint64_t> release_epoch_{0};     // 递增后各线程在下一次操作时归还本地缓存
+    std::atomic<size_t> released_bytes_{0};      // 归还系统的统计，见MemoryReturnStats
+    std::atomic<size_t> released_blocks_{0};
+    std::atomic<size_t> decommitted_bytes_{0};
+    std::atomic<size_t> decommitted_blocks_{0};
+    std::atomic<size_t> decommitted_resident_{0};
+    std::atomic<size_t> trim_passes_{0};
+    
+    uint32_t CurrentSlot() const {
+        if (num_slots_ == 1) {
+            return 0;
+        }
+        const int node = GetCurrentNumaNode();
+        return node >= 0 ? static_cast<uint32_t>(node) + 1 : 0;
+    }
+    
+    BlockHeader* NewBlock(uint32_t size_class, size_t capacity, size_t alignment, uint32_t slot) {
+        const size_t max_size = max_pool_size_.load(std::memory_order_relaxed);
+        if (max_size > 0 && total_allocated_.load(std::memory_order_relaxed) + capacity > max_size) {
+            // 尝试释放未使用的内存
+            ReleaseUnused();
+            if (total_allocated_.load(std::memory_order_relaxed) + capacity > max_size) {
+                LOG_WARNING("Memory pool size limit reached: " +
+                           std::to_string(max_size) + " bytes");
+                // 继续分配，但记录警告
+            }
         }
         
-        // 计算对齐后的地址（在header之后）
-        uintptr_t addr = reinterpret_cast<uintptr_t>(raw_ptr);
-        uintptr_t aligned_addr = (addr + header_size + alignment - 1) & ~(alignment - 1);
-        void* aligned_ptr = reinterpret_cast<void*>(aligned_addr);
-        
-        // 在对齐指针之前存储原始指针（用于释放）
-        uintptr_t* header = reinterpret_cast<uintptr_t*>(aligned_ptr) - 1;
-        *header = reinterpret_cast<uintptr_t>(raw_ptr);
+        void* raw = std::malloc(sizeof(BlockHeader) + alignment - 1 + capacity);
+        if (!raw) {
+            return nullptr;
+        }
+        uintptr_t addr = reinterpret_cast<uintptr_t>(raw) + sizeof(BlockHeader);
+        addr = AlignUp(addr, alignment);
+        BlockHeader* header = HeaderOf(reinterpret_cast<void*>(addr));
+        header->magic = kBlockMagic ^ addr;
+        header->raw = raw;
+        header->next = nullptr;
+        header->capacity = capacity;
+        header->released_time = 0;
+        header->size_class = size_class;
+        header->in_use = 0;
+        header->slot = slot;
+        header->decommitted = 0;
+        if (slot > 0 && capacity >= kNumaBindMinBytes) {
+            BindMemoryToNumaNode(UserPointer(header), capacity, static_cast<int>(slot) - 1);
+        }
         
-        return aligned_ptr;
+        total_allocated_.fetch_add(capacity, std::memory_order_relaxed);
+        block_count_.fetch_add(1, std::memory_order_relaxed);
+        cached_count_.fetch_add(1, std::memory_order_relaxed);
+        return header;
     }
     
-    void FreeAligned(void* ptr) {
-        if (!ptr) return;
+    void DestroyBlock(BlockHeader* header) {
+        if (header->decommitted) {
+            decommitted_resident_.fetch_sub(header->capacity, std::memory_order_relaxed);
+        }
+        total_allocated_.fetch_sub(header->capacity, std::memory_order_relaxed);
+        block_count_.fetch_sub(1, std::memory_order_relaxed);
+        cached_count_.fetch_sub(1, std::memory_order_relaxed);
+        header->magic = 0;
+        std::free(header->raw);
+    }
+    
+    // 释放中心池中的空闲块并计入归还统计，返回块容量
+    size_t ReleaseBlock(BlockHeader* header) {
+        const size_t capacity = header->capacity;
+        DestroyBlock(header);
+        released_bytes_.fetch_add(capacity, std::memory_order_relaxed);
+        released_blocks_.fetch_add(1, std::memory_order_relaxed);
+        return capacity;
+    }
+    
+    // 把块内完整的页交还系统，块头所在的页保留；返回实际归还的字节数
+    size_t DecommitBlock(BlockHeader* header) {
+#ifndef _WIN32
+        static const uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const uintptr_t data = reinterpret_cast<uintptr_t>(UserPointer(header));
+        const uintptr_t begin = (data + page - 1) & ~(page - 1);
+        const uintptr_t end = (data + header->capacity) & ~(page - 1);
+        if (end <= begin ||
+            ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED) != 0) {
+            return 0;
+        }
+        header->decommitted = 1;
+        decommitted_resident_.fetch_add(header->capacity, std::memory_order_relaxed);
+        decommitted_bytes_.fetch_add(end - begin, std::memory_order_relaxed);
+        decommitted_blocks_.fetch_add(1, std::memory_order_relaxed);
+        return end - begin;
+#else
+        (void)header;
+        return 0;
+#endif
+    }
+    
+    void* MarkInUse(BlockHeader* header) {
+        if (header->decommitted) {
+            header->decommitted = 0;
+            decommitted_resident_.fetch_sub(header->capacity, std::memory_order_relaxed);
+        }
+        header->in_use = 1;
+        header->next = nullptr;
+        cached_count_.fetch_sub(1, std::memory_order_relaxed);
+        const size_t current =
+            current_allocated_.fetch_add(header->capacity, std::memory_order_relaxed) + header->capacity;
+        size_t peak = peak_allocated_.load(std::memory_order_relaxed);
+        while (current > peak &&
+               !peak_allocated_.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+        return UserPointer(header);
+    }
+    
+    // 从中心池取最多max_count个块，链成链表返回
+    BlockHeader* PopCentral(uint32_t slot, uint32_t size_class, uint32_t max_count, uint32_t* popped) {
+        CentralBin& bin = slots_[slot].bins[size_class];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        BlockHeader* head = bin.head;
+        BlockHeader* tail = nullptr;
+        uint32_t n = 0;
+        for (BlockHeader* it = head; it && n < max_count; it = it->next) {
+            tail = it;
+            ++n;
+        }
+        if (tail) {
+            bin.head = tail->next;
+            tail->next = nullptr;
+            bin.count -= n;
+        } else {
+            head = nullptr;
+        }
+        *popped = n;
+        return head;
+    }
+    
+    // 将[head, tail]的n个块归还中心池
+    void PushCentral(uint32_t slot, uint32_t size_class, BlockHeader* head, BlockHeader* tail, uint32_t n) {
+        const int64_t now = NowTicks();
+        for (BlockHeader* it = head; it; it = it->next) {
+            it->released_time = now;
+        }
+        CentralBin& bin = slots_[slot].bins[size_class];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        tail->next = bin.head;
+        bin.head = head;
+        bin.count += n;
+    }
+    
+    // 将线程缓存某级别的前n个块归还中心池
+    void FlushBin(ThreadCache& cache, uint32_t size_class, uint32_t n) {
+        ThreadCacheBin& bin = cache.bins[size_class];
+        n = std::min(n, bin.count);
+        if (n == 0) return;
+        BlockHeader* head = bin.head;
+        BlockHeader* tail = head;
+        for (uint32_t i = 1; i < n; ++i) {
+            tail = tail->next;
+        }
+        bin.head = tail->next;
+        bin.count -= n;
+        cache.bytes -= n * ClassSize(size_class);
+        tail->next = nullptr;
+        PushCentral(cache.slot, size_class, head, tail, n);
+    }
+    
+    void SyncEpoch(ThreadCache& cache) {
+        const uint64_t epoch = release_epoch_.load(std::memory_order_acquire);
+        if (cache.epoch != epoch) {
+            FlushThreadCache(cache);
+            cache.epoch = epoch;
+        }
+    }
+    
+    // 未使用内存占比超过阈值时，从最大的级别开始释放中心池的块
+    void TrimToThreshold() {
+        const size_t total = total_allocated_.load(std::memory_order_relaxed);
+        if (total < kTrimMinBytes) return;
+        const double threshold = release_threshold_.load(std::memory_order_relaxed);
+        auto over_threshold = [&]() {
+            const size_t held = total_allocated_.load(std::memory_order_relaxed);
+            const size_t in_use = current_allocated_.load(std::memory_order_relaxed);
+            return held > in_use && static_cast<double>(held - in_use) > threshold * held;
+        };
+        if (!over_threshold()) return;
         
-        // 验证指针是否有效（基本检查）
-        // 注意：这里不能完全验证，但可以避免明显的错误
-        try {
-            uintptr_t* header = reinterpret_cast<uintptr_t*>(ptr) - 1;
-            void* raw_ptr = reinterpret_cast<void*>(*header);
-            
-            // 基本验证：raw_ptr应该在合理范围内
-            if (raw_ptr && raw_ptr < ptr) {
-                std::free(raw_ptr);
-            } else {
-                LOG_ERROR("Invalid raw pointer in FreeAligned: " + 
-                         std::to_string(reinterpret_cast<uintptr_t>(raw_ptr)));
+        size_t released = 0;
+        for (int64_t c = static_cast<int64_t>(kNumSizeClasses) - 1; c >= 0 && over_threshold(); --c) {
+            for (size_t slot = 0; slot < num_slots_ && over_threshold(); ++slot) {
+                CentralBin& bin = slots_[slot].bins[c];
+                std::lock_guard<std::mutex> lock(bin.mutex);
+                while (bin.head && over_threshold()) {
+                    BlockHeader* header = bin.head;
+                    bin.head = header->next;
+                    --bin.count;
+                    released += ReleaseBlock(header);
+                }
             }
-        } catch (...) {
-            LOG_ERROR("Exception in FreeAligned for pointer: " + 
-                     std::to_string(reinterpret_cast<uintptr_t>(ptr)));
+        }
+        if (released > 0) {
+            LOG_VERBOSE("Memory pool trimmed " + std::to_string(released) +
+                      " bytes above release threshold");
         }
     }
     
+    void* AllocateDirect(size_t size, size_t alignment) {
+        BlockHeader* header = NewBlock(kDirectClass, size, alignment, CurrentSlot());
+        if (!header) {
+            LOG_ERROR("Memory allocation failed: size=" + std::to_string(size));
+            return nullptr;
+        }
+        return MarkInUse(header);
+    }
+
 public:
+    MemoryPoolImpl() {
+        const size_t nodes = GetNumNumaNodes();
+        num_slots_ = nodes > 1 ? nodes + 1 : 1;
+        slots_.reset(new SlotBins[num_slots_]);
+    }
+    
     void* Allocate(size_t size, size_t alignment = 16) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        if (alignment < 16) {
+            alignment = 16;
+        }
+        if ((alignment & (alignment - 1)) != 0) {
+            size_t pow2 = 16;
+            while (pow2 < alignment) pow2 <<= 1;
+            alignment = pow2;
+        }
+        if (alignment > kBlockAlignment || size > (size_t(1) << kMaxClassShift)) {
+            return AllocateDirect(size, alignment);
+        }
         
-        // 查找可重用的内存块（优先使用大小最接近的块以减少碎片）
-        void* best_fit = nullptr;
-        size_t best_size = SIZE_MAX;
+        const uint32_t size_class = SizeClassOf(size);
+        const size_t capacity = ClassSize(size_class);
+        const uint32_t slot = CurrentSlot();
+        ThreadCache* cache = capacity <= kMaxThreadCachedBlock ? CurrentThreadCache() : nullptr;
         
-        for (auto& pair : blocks_) {
-            if (!pair.second.in_use && pair.second.size >= size) {
-                // 优先选择大小最接近的块（最佳适配）
-                if (pair.second.size < best_size) {
-                    best_fit = pair.second.ptr;
-                    best_size = pair.second.size;
-                }
+        BlockHeader* header = nullptr;
+        if (cache) {
+            SyncEpoch(*cache);
+            if (cache->slot != slot) {
+                // 线程换了首选节点：缓存的块归还原来的槽
+                FlushThreadCache(*cache);
+                cache->slot = slot;
+            }
+            ThreadCacheBin& bin = cache->bins[size_class];
+            if (!bin.head) {
+                // 批量补充：一次加锁取回半个缓存容量
+                uint32_t popped = 0;
+                BlockHeader* batch = PopCentral(slot, size_class, ThreadCacheLimit(capacity) / 2, &popped);
+                bin.head = batch;
+                bin.count = popped;
+                cache->bytes += popped * capacity;
             }
+            if (bin.head) {
+                header = bin.head;
+                bin.head = header->next;
+                --bin.count;
+                cache->bytes -= capacity;
+            }
+        } else {
+            uint32_t popped = 0;
+            header = PopCentral(slot, size_class, 1, &popped);
         }
         
-        if (best_fit) {
-            auto it = blocks_.find(best_fit);
-            if (it != blocks_.end()) {
-                it->second.in_use = true;
-                it->second.allocated_time = std::chrono::steady_clock::now();
-                unused_memory_ -= it->second.size;
-                current_allocated_ += it->second.size;
-                return it->second.ptr;
+        if (!header) {
+            header = NewBlock(size_class, capacity, kBlockAlignment, slot);
+            if (!header) {
+                LOG_ERROR("Memory allocation failed: size=" + std::to_string(size));
+                return nullptr;
             }
         }
+        return MarkInUse(header);
+    }
+    
+    void Free(void* ptr) {
+        if (!ptr) return;
         
-        // 检查是否超过最大池大小限制
-        if (max_pool_size_ > 0 && total_allocated_ + size > max_pool_size_) {
-            // 尝试释放未使用的内存
-            ReleaseUnused();
-            
-            // 如果仍然超过限制，尝试碎片整理
-            if (total_allocated_ + size > max_pool_size_) {
-                Defragment();
-            }
-            
-            // 再次检查
-            if (max_pool_size_ > 0 && total_allocated_ + size > max_pool_size_) {
-                LOG_WARNING("Memory pool size limit reached: " + 
-                           std::to_string(max_pool_size_) + " bytes");
-                // 继续分配，但记录警告
-            }
+        BlockHeader* header = HeaderOf(ptr);
+        if (header->magic != (kBlockMagic ^ reinterpret_cast<uintptr_t>(ptr))) {
+            // 指针不是本池分配的块，不执行任何操作，避免崩溃
+            LOG_WARNING("Attempted to free unknown pointer: " +
+                       std::to_string(reinterpret_cast<uintptr_t>(ptr)));
+            return;
         }
+        if (!header->in_use) {
+            LOG_WARNING("Attempted to free pointer twice: " +
+                       std::to_string(reinterpret_cast<uintptr_t>(ptr)));
+            return;
+        }
+        header->in_use = 0;
+        current_allocated_.fetch_sub(header->capacity, std::memory_order_relaxed);
+        cached_count_.fetch_add(1, std::memory_order_relaxed);
         
-        // 分配新内存块
-        void* ptr = AllocateAligned(size, alignment);
-        if (!ptr) {
-            LOG_ERROR("Memory allocation failed: size=" + std::to_string(size));
-            return nullptr;
+        const uint32_t size_class = header->size_class;
+        if (size_class == kDirectClass) {
+            DestroyBlock(header);
+            return;
+        }
+        
+        ThreadCache* cache = header->capacity <= kMaxThreadCachedBlock ? CurrentThreadCache() : nullptr;
+        if (cache) {
+            SyncEpoch(*cache);
+        }
+        // 其他节点的块直接回到它的槽，不进入本线程的缓存
+        if (!cache || header->slot != cache->slot) {
+            header->next = nullptr;
+            PushCentral(header->slot, size_class, header, header, 1);
+            TrimToThreshold();
+            return;
         }
         
-        blocks_[ptr] = MemoryBlock(ptr, size);
-        total_allocated_ += size;
-        current_allocated_ += size;
-        peak_allocated_ = std::max(peak_allocated_, current_allocated_);
+        ThreadCacheBin& bin = cache->bins[size_class];
+        header->next = bin.head;
+        bin.head = header;
+        ++bin.count;
+        cache->bytes += header->capacity;
         
-        return ptr;
+        // 超出本地缓存上限时批量归还一半
+        const uint32_t limit = ThreadCacheLimit(header->capacity);
+        if (bin.count > limit || cache->bytes > kThreadCacheMaxBytes) {
+            FlushBin(*cache, size_class, std::max<uint32_t>(1, bin.count / 2));
+            TrimToThreshold();
+        }
     }
     
-    void Free(void* ptr) {
-        if (!ptr) return;
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = blocks_.find(ptr);
-        if (it != blocks_.end()) {
-            it->second.in_use = false;
-            current_allocated_ -= it->second.size;
-            unused_memory_ += it->second.size;
-            
-            // 检查是否需要自动释放未使用内存
-            if (total_allocated_ > 0 && 
-                static_cast<double>(unused_memory_) / total_allocated_ > release_threshold_) {
-                // 异步释放，避免在Free中执行耗时操作
-                // 这里只标记，实际释放由ReleaseUnused执行
-            }
-        } else {
-            // 指针不在blocks_中，可能是无效指针或已经被释放
-            // 不执行任何操作，避免崩溃
-            LOG_WARNING("Attempted to free unknown pointer: " + 
-                       std::to_string(reinterpret_cast<uintptr_t>(ptr)));
+    // 将线程缓存全部归还中心池
+    void FlushThreadCache(ThreadCache& cache) {
+        for (uint32_t c = 0; c < kNumSizeClasses; ++c) {
+            FlushBin(cache, c, cache.bins[c].count);
         }
     }
     
+    // 释放中心池中的全部空闲块；其他线程的本地缓存在它们下一次分配/释放时归还
     void ReleaseUnused() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        if (ThreadCache* cache = CurrentThreadCache()) {
+            FlushThreadCache(*cache);
+        }
+        release_epoch_.fetch_add(1, std::memory_order_acq_rel);
         
         size_t released = 0;
-        auto it = blocks_.begin();
-        while (it != blocks_.end()) {
-            if (!it->second.in_use) {
-                FreeAligned(it->second.ptr);
-                unused_memory_ -= it->second.size;
-                total_allocated_ -= it->second.size;
-                released += it->second.size;
-                it = blocks_.erase(it);
-            } else {
-                ++it;
+        for (size_t slot = 0; slot < num_slots_; ++slot) {
+            for (auto& bin : slots_[slot].bins) {
+                BlockHeader* head = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(bin.mutex);
+                    head = bin.head;
+                    bin.head = nullptr;
+                    bin.count = 0;
+                }
+                while (head) {
+                    BlockHeader* next = head->next;
+                    released += ReleaseBlock(head);
+                    head = next;
+                }
             }
         }
         
@@ -191,86 +526,115 @@ public:
         }
     }
     
-    // 内存碎片整理：合并相邻的未使用内存块
-    // 注意：由于对齐分配的实现，实际内存块可能不连续，这里只做概念性实现
-    void Defragment() {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // 按闲置时间回收中心池的空闲块：超过TTL的整块释放，超过decommit_after的大块归还物理页。
+    // 分级分配下同级别块可互换，碎片只来自长期闲置的级别；块各自由malloc分配，不存在可合并的相邻区域
+    size_t Trim(const MemoryTrimOptions& options) {
+        if (ThreadCache* cache = CurrentThreadCache()) {
+            FlushThreadCache(*cache);
+        }
+        // 其他线程的缓存在下一次操作时归还，归还时刻起参与下一轮的闲置计时
+        release_epoch_.fetch_add(1, std::memory_order_acq_rel);
         
-        // 简化实现：只释放长时间未使用的内存块
-        // 真正的碎片整理需要更复杂的实现（如buddy allocator）
-        auto now = std::chrono::steady_clock::now();
-        auto max_age = std::chrono::seconds(60);  // 60秒未使用则释放
+        const int64_t now = NowTicks();
+        const int64_t ttl = MillisecondsToTicks(std::max<int64_t>(0, options.idle_ttl_ms));
+        const bool decommit = options.decommit_after_ms >= 0;
+        const int64_t decommit_after = MillisecondsToTicks(std::max<int64_t>(0, options.decommit_after_ms));
+        const size_t decommit_min = std::max(options.decommit_min_bytes, kNumaBindMinBytes);
         
-        size_t merged_count = 0;
-        auto it = blocks_.begin();
-        while (it != blocks_.end()) {
-            if (!it->second.in_use) {
-                auto age = now - it->second.allocated_time;
-                if (age > max_age) {
-                    // 释放长时间未使用的块
-                    FreeAligned(it->second.ptr);
-                    unused_memory_ -= it->second.size;
-                    total_allocated_ -= it->second.size;
-                    it = blocks_.erase(it);
-                    merged_count++;
-                } else {
-                    ++it;
+        size_t released = 0;
+        size_t released_count = 0;
+        size_t decommitted = 0;
+        for (size_t slot = 0; slot < num_slots_; ++slot) {
+            for (uint32_t c = 0; c < kNumSizeClasses; ++c) {
+                CentralBin& bin = slots_[slot].bins[c];
+                const bool decommit_class = decommit && ClassSize(c) >= decommit_min;
+                std::lock_guard<std::mutex> lock(bin.mutex);
+                BlockHeader** link = &bin.head;
+                while (*link) {
+                    BlockHeader* header = *link;
+                    const int64_t idle = now - header->released_time;
+                    if (idle >= ttl) {
+                        *link = header->next;
+                        --bin.count;
+                        released += ReleaseBlock(header);
+                        ++released_count;
+                        continue;
+                    }
+                    if (decommit_class && !header->decommitted && idle >= decommit_after) {
+                        decommitted += DecommitBlock(header);
+                    }
+                    link = &header->next;
                 }
-            } else {
-                ++it;
             }
         }
+        trim_passes_.fetch_add(1, std::memory_order_relaxed);
         
-        if (merged_count > 0) {
-            LOG_INFO("Defragmented memory: released " + std::to_string(merged_count) + " old blocks");
+        if (released_count > 0 || decommitted > 0) {
+            LOG_VERBOSE("Memory trim: released " + std::to_string(released_count) + " idle blocks (" +
+                      std::to_string(released) + " bytes), decommitted " +
+                      std::to_string(decommitted) + " bytes");
         }
+        return released + decommitted;
     }
     
     // 设置最大池大小
     void SetMaxPoolSize(size_t max_size) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        max_pool_size_ = max_size;
+        max_pool_size_.store(max_size, std::memory_order_relaxed);
         
         // 如果当前大小超过限制，释放未使用的内存
-        if (max_pool_size_ > 0 && total_allocated_ > max_pool_size_) {
+        if (max_size > 0 && total_allocated_.load(std::memory_order_relaxed) > max_size) {
             ReleaseUnused();
         }
     }
     
     // 设置释放阈值
     void SetReleaseThreshold(double threshold) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        release_threshold_ = std::max(0.0, std::min(1.0, threshold));
+        release_threshold_.store(std::max(0.0, std::min(1.0, threshold)), std::memory_order_relaxed);
     }
     
     MemoryStats GetStats() const {
-        std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(mutex_));
-        
         MemoryStats stats;
-        stats.allocated_bytes = total_allocated_;
-        stats.peak_allocated_bytes = peak_allocated_;
-        stats.allocation_count = blocks_.size();
-        
-        size_t unused_count = 0;
-        for (const auto& pair : blocks_) {
-            if (!pair.second.in_use) {
-                unused_count++;
+        stats.allocated_bytes = total_allocated_.load(std::memory_order_relaxed);
+        stats.peak_allocated_bytes = peak_allocated_.load(std::memory_order_relaxed);
+        stats.allocation_count = block_count_.load(std::memory_order_relaxed);
+        stats.free_count = cached_count_.load(std::memory_order_relaxed);
+        return stats;
+    }
+    
+    MemoryReturnStats GetReturnStats() const {
+        MemoryReturnStats stats;
+        stats.released_bytes = released_bytes_.load(std::memory_order_relaxed);
+        stats.released_blocks = released_blocks_.load(std::memory_order_relaxed);
+        stats.decommitted_bytes = decommitted_bytes_.load(std::memory_order_relaxed);
+        stats.decommitted_blocks = decommitted_blocks_.load(std::memory_order_relaxed);
+        stats.decommitted_resident = decommitted_resident_.load(std::memory_order_relaxed);
+        const size_t held = total_allocated_.load(std::memory_order_relaxed);
+        const size_t in_use = current_allocated_.load(std::memory_order_relaxed);
+        stats.cached_bytes = held > in_use ? held - in_use : 0;
+        stats.trim_passes = trim_passes_.load(std::memory_order_relaxed);
+        stats.process_rss_bytes = ProcessResidentBytes();
+        return stats;
+    }
+    
+    // fork期间持有中心池的全部锁：子进程中不会留下被其他线程持有到一半的空闲链表
+    void LockForFork() {
+        for (size_t s = 0; s < num_slots_; ++s) {
+            for (CentralBin& bin : slots_[s].bins) {
+                bin.mutex.lock();
             }
         }
-        stats.free_count = unused_count;
-        
-        // 计算碎片率（未使用内存占总内存的比例）
-        // 注意：这里使用unused_memory_而不是遍历计算，因为可能有合并的块
-        
-        return stats;
     }
     
-    ~MemoryPoolImpl() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& pair : blocks_) {
-            FreeAligned(pair.second.ptr);
+    void UnlockAfterFork() {
+        for (size_t s = num_slots_; s-- > 0;) {
+            for (size_t c = kNumSizeClasses; c-- > 0;) {
+                slots_[s].bins[c].mutex.unlock();
+            }
         }
-        blocks_.clear();
+    }
+    
+    ~MemoryPoolImpl() {
+        ReleaseUnused();
     }
 };
 
@@ -285,6 +649,92 @@ MemoryPoolImpl* GetMemoryPool() {
     return g_memory_pool;
 }
 
+namespace {
+
+ThreadCache::~ThreadCache() {
+    tls_cache_alive = false;
+    if (g_memory_pool) {
+        g_memory_pool->FlushThreadCache(*this);
+    }
+}
+
+// 后台回收线程；静态对象析构时停止，内存池本身不析构
+class MemoryTrimmer {
+public:
+    ~MemoryTrimmer() { Stop(); }
+    
+    void Start(const MemoryTrimOptions& options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        thread_ = std::thread([this]() { Loop(); });
+    }
+    
+    void Stop() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+            thread = std::move(thread_);
+        }
+        cv_.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    
+    bool IsRunning() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+    
+    // fork前停止后台线程，fork后按原选项重新启动
+    void StopForFork() {
+        resume_after_fork_ = IsRunning();
+        Stop();
+    }
+    
+    void ResumeAfterFork() {
+        if (resume_after_fork_) {
+            Start(options_);
+        }
+    }
+
+private:
+    void Loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            const auto interval = std::chrono::milliseconds(std::max<int64_t>(1, options_.interval_ms));
+            if (cv_.wait_for(lock, interval, [this]() { return !running_; })) {
+                break;
+            }
+            // 等待期间Start可能更新了选项，新的间隔从下一轮起生效
+            const MemoryTrimOptions options = options_;
+            lock.unlock();
+            GetMemoryPool()->Trim(options);
+            lock.lock();
+        }
+    }
+    
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    MemoryTrimOptions options_;
+    bool running_ = false;
+    bool resume_after_fork_ = false;
+};
+
+MemoryTrimmer& GetMemoryTrimmer() {
+    static MemoryTrimmer trimmer;
+    return trimmer;
+}
+
+} // anonymous namespace
+
 } // namespace inferunity
 
 // 公共接口实现
@@ -303,7 +753,38 @@ void ReleaseUnusedMemory() {
 }
 
 void DefragmentMemory() {
-    GetMemoryPool()->Defragment();
+    GetMemoryPool()->Trim(MemoryTrimOptions());
+}
+
+size_t TrimMemory(const MemoryTrimOptions& options) {
+    return GetMemoryPool()->Trim(options);
+}
+
+Status StartMemoryTrimmer(const MemoryTrimOptions& options) {
+    if (options.interval_ms <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Memory trimmer interval must be positive");
+    }
+    GetMemoryTrimmer().Start(options);
+    return Status::Ok();
+}
+
+void StopMemoryTrimmer() {
+    GetMemoryTrimmer().Stop();
+}
+
+bool IsMemoryTrimmerRunning() {
+    return GetMemoryTrimmer().IsRunning();
+}
+
+void MemoryPoolBeforeFork() {
+    GetMemoryTrimmer().StopForFork();
+    GetMemoryPool()->LockForFork();
+}
+
+void MemoryPoolAfterFork() {
+    GetMemoryPool()->UnlockAfterFork();
+    GetMemoryTrimmer().ResumeAfterFork();
 }
 
 void SetMemoryPoolMaxSize(size_t max_size) {
@@ -318,5 +799,8 @@ MemoryStats GetMemoryStats() {
     return GetMemoryPool()->GetStats();
 }
 
-} // namespace inferunity
+MemoryReturnStats GetMemoryReturnStats() {
+    return GetMemoryPool()->GetReturnStats();
+}
 
+} // namespace inferunity
@@ -0,0 +1,409 @@
+// 多模型集成实现
+// 每个条目有自己的Item：各步骤未就绪的依赖数、已产出的张量与尚未提交的消费者数。
+// 步骤完成的回调在线程池线程上更新Item并提交新就绪的步骤；条目的最后一个步骤完成时交回结果，
+// 并在同一线程上开始下一个等待中的条目
+
+#include "inferunity/model_ensemble.h"
+#include "inferunity/engine.h"
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+constexpr int kEnsembleInput = -1;
+
+} // anonymous namespace
+
+struct ModelEnsemble::Step {
+    std::string name;
+    InferenceSession* session = nullptr;
+    std::vector<std::pair<int, size_t>> sources;  // 每个输入的来源：(步骤下标或kEnsembleInput, 序号)
+    std::vector<size_t> consumers;                // 以本步骤输出为输入的步骤（去重）
+    size_t num_dependencies = 0;                  // 不同的上游步骤数
+    std::vector<size_t> output_uses;              // 每个输出被后续步骤引用的次数
+    std::vector<bool> output_pinned;              // 该输出是集成输出，条目完成前不释放
+};
+
+struct ModelEnsemble::StreamState {
+    const std::vector<std::vector<std::shared_ptr<Tensor>>>* items = nullptr;
+    const ItemCallback* on_item = nullptr;
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t next = 0;
+    size_t inflight = 0;
+    size_t completed = 0;
+    Status first_error;
+};
+
+struct ModelEnsemble::Item {
+    StreamState* stream = nullptr;
+    size_t index = 0;
+    std::vector<std::shared_ptr<Tensor>> inputs;
+    std::mutex mutex;
+    std::vector<std::vector<std::shared_ptr<Tensor>>> outputs;  // 按步骤
+    std::vector<std::vector<size_t>> uses;                       // 各步骤输出尚未提交的消费者数
+    std::vector<size_t> pending;                                 // 各步骤尚未完成的上游数
+    size_t running = 0;                                          // 已提交未完成的步骤数
+    size_t finished = 0;
+    Status status;
+};
+
+Status ModelEnsemble::Create(std::vector<EnsembleStep> steps, const ModelEnsembleOptions& options,
+                             std::unique_ptr<ModelEnsemble>* ensemble) {
+    if (!ensemble) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Ensemble output is null");
+    }
+    if (steps.empty() || options.output_names.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Ensemble needs at least one step and one output");
+    }
+    std::unordered_map<std::string, size_t> input_index;
+    for (size_t i = 0; i < options.input_names.size(); ++i) {
+        if (!input_index.emplace(options.input_names[i], i).second) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Duplicate ensemble input: " + options.input_names[i]);
+        }
+    }
+    std::unordered_map<std::string, size_t> step_index;
+    std::vector<std::vector<std::string>> output_names(steps.size());
+    for (size_t s = 0; s < steps.size(); ++s) {
+        const EnsembleStep& step = steps[s];
+        if (step.name.empty() || step.name.find(':') != std::string::npos) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid ensemble step name: " + step.name);
+        }
+        if (!step_index.emplace(step.name, s).second) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Duplicate ensemble step: " + step.name);
+        }
+        if (!step.session || !step.session->GetGraph()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Ensemble step " + step.name + " has no loaded session");
+        }
+        if (step.inputs.size() != step.session->GetInputNames().size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Ensemble step " + step.name + " expects " +
+                               std::to_string(step.session->GetInputNames().size()) + " inputs");
+        }
+        output_names[s] = step.session->GetOutputNames();
+    }
+
+    // 名称 -> (原始步骤下标或kEnsembleInput, 序号)
+    auto resolve = [&](const std::string& ref, std::pair<int, size_t>* source) {
+        const size_t colon = ref.find(':');
+        if (colon == std::string::npos) {
+            auto it = input_index.find(ref);
+            if (it == input_index.end()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown ensemble input: " + ref);
+            }
+            *source = {kEnsembleInput, it->second};
+            return Status::Ok();
+        }
+        auto it = step_index.find(ref.substr(0, colon));
+        if (it == step_index.end()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown ensemble step in " + ref);
+        }
+        const auto& names = output_names[it->second];
+        auto name = std::find(names.begin(), names.end(), ref.substr(colon + 1));
+        if (name == names.end()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown step output: " + ref);
+        }
+        *source = {static_cast<int>(it->second), static_cast<size_t>(name - names.begin())};
+        return Status::Ok();
+    };
+
+    std::vector<std::vector<std::pair<int, size_t>>> sources(steps.size());
+    std::vector<std::unordered_set<size_t>> upstream(steps.size());
+    for (size_t s = 0; s < steps.size(); ++s) {
+        for (const std::string& ref : steps[s].inputs) {
+            std::pair<int, size_t> source;
+            Status status = resolve(ref, &source);
+            if (!status.IsOk()) {
+                return status;
+            }
+            sources[s].push_back(source);
+            if (source.first != kEnsembleInput) {
+                upstream[s].insert(static_cast<size_t>(source.first));
+            }
+        }
+    }
+
+    // 按依赖排序（Kahn），同层保持给出的顺序；剩余未排的步骤说明有环
+    std::vector<size_t> order;
+    std::vector<size_t> indegree(steps.size());
+    for (size_t s = 0; s < steps.size(); ++s) {
+        indegree[s] = upstream[s].size();
+    }
+    std::vector<bool> placed(steps.size(), false);
+    while (order.size() < steps.size()) {
+        size_t ready = steps.size();
+        for (size_t s = 0; s < steps.size() && ready == steps.size(); ++s) {
+            if (!placed[s] && indegree[s] == 0) {
+                ready = s;
+            }
+        }
+        if (ready == steps.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Ensemble steps contain a cycle");
+        }
+        placed[ready] = true;
+        order.push_back(ready);
+        for (size_t s = 0; s < steps.size(); ++s) {
+            if (upstream[s].count(ready)) {
+                --indegree[s];
+            }
+        }
+    }
+    std::vector<size_t> position(steps.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = i;
+    }
+
+    std::unique_ptr<ModelEnsemble> result(new ModelEnsemble());
+    result->options_ = options;
+    result->steps_.resize(steps.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        EnsembleStep& source_step = steps[order[i]];
+        Step& step = result->steps_[i];
+        step.name = std::move(source_step.name);
+        step.session = source_step.session;
+        step.num_dependencies = upstream[order[i]].size();
+        step.output_uses.assign(output_names[order[i]].size(), 0);
+        step.output_pinned.assign(output_names[order[i]].size(), false);
+        for (auto source : sources[order[i]]) {
+            if (source.first != kEnsembleInput) {
+                source.first = static_cast<int>(position[static_cast<size_t>(source.first)]);
+            }
+            step.sources.push_back(source);
+        }
+    }
+    for (size_t s = 0; s < result->steps_.size(); ++s) {
+        for (const auto& source : result->steps_[s].sources) {
+            if (source.first == kEnsembleInput) {
+                continue;
+            }
+            Step& producer = result->steps_[static_cast<size_t>(source.first)];
+            ++producer.output_uses[source.second];
+            if (std::find(producer.consumers.begin(), producer.consumers.end(), s) == producer.consumers.end()) {
+                producer.consumers.push_back(s);
+            }
+        }
+    }
+    for (const std::string& ref : options.output_names) {
+        std::pair<int, size_t> source;
+        Status status = resolve(ref, &source);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (source.first != kEnsembleInput) {
+            source.first = static_cast<int>(position[static_cast<size_t>(source.first)]);
+            result->steps_[static_cast<size_t>(source.first)].output_pinned[source.second] = true;
+        }
+        result->output_sources_.push_back(source);
+    }
+    *ensemble = std::move(result);
+    return Status::Ok();
+}
+
+ModelEnsemble::~ModelEnsemble() = default;
+
+std::vector<std::string> ModelEnsemble::GetStepNames() const {
+    std::vector<std::string> names;
+    for (const Step& step : steps_) {
+        names.push_back(step.name);
+    }
+    return names;
+}
+
+ModelEnsembleStats ModelEnsemble::GetStats() const {
+    ModelEnsembleStats stats;
+    stats.items = items_.load(std::memory_order_relaxed);
+    stats.failed_items = failed_items_.load(std::memory_order_relaxed);
+    stats.step_runs = step_runs_.load(std::memory_order_relaxed);
+    stats.peak_inflight_items = peak_inflight_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+Status ModelEnsemble::Run(const std::vector<std::shared_ptr<Tensor>>& inputs,
+                          std::vector<std::shared_ptr<Tensor>>* outputs) {
+    if (!outputs) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Outputs is null");
+    }
+    std::vector<std::shared_ptr<Tensor>> result;
+    Status status = RunStream({inputs}, [&](size_t, Status, std::vector<std::shared_ptr<Tensor>> item_outputs) {
+        result = std::move(item_outputs);
+    });
+    if (status.IsOk()) {
+        *outputs = std::move(result);
+    }
+    return status;
+}
+
+Status ModelEnsemble::RunStream(const std::vector<std::vector<std::shared_ptr<Tensor>>>& items,
+                                const ItemCallback& on_item) {
+    if (items.empty()) {
+        return Status::Ok();
+    }
+    StreamState stream;
+    stream.items = &items;
+    stream.on_item = &on_item;
+    const size_t window = options_.max_inflight_items > 0 ? std::min(options_.max_inflight_items, items.size())
+                                                          : items.size();
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.next = window;
+        stream.inflight = window;
+    }
+    size_t peak = peak_inflight_.load(std::memory_order_relaxed);
+    while (peak < window && !peak_inflight_.compare_exchange_weak(peak, window, std::memory_order_relaxed)) {
+    }
+    for (size_t i = 0; i < window; ++i) {
+        StartItem(&stream, i);
+    }
+    std::unique_lock<std::mutex> lock(stream.mutex);
+    stream.done.wait(lock, [&] { return stream.completed == items.size(); });
+    return stream.first_error;
+}
+
+void ModelEnsemble::StartItem(StreamState* stream, size_t index) {
+    auto item = std::make_shared<Item>();
+    item->stream = stream;
+    item->index = index;
+    item->inputs = (*stream->items)[index];
+    if (item->inputs.size() != options_.input_names.size() ||
+        std::any_of(item->inputs.begin(), item->inputs.end(), [](const auto& tensor) { return !tensor; })) {
+        item->status = Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                     "Ensemble expects " + std::to_string(options_.input_names.size()) +
+                                     " non-null inputs");
+        FinishItem(item);
+        return;
+    }
+    item->outputs.resize(steps_.size());
+    item->uses.resize(steps_.size());
+    item->pending.resize(steps_.size());
+    std::vector<size_t> ready;
+    for (size_t s = 0; s < steps_.size(); ++s) {
+        item->uses[s] = steps_[s].output_uses;
+        item->pending[s] = steps_[s].num_dependencies;
+        if (item->pending[s] == 0) {
+            ready.push_back(s);
+        }
+    }
+    // 先计入全部就绪的步骤，再逐个提交：较早的步骤即使立即完成也不会提前结束条目
+    item->running = ready.size();
+    for (size_t s : ready) {
+        LaunchStep(item, s);
+    }
+}
+
+void ModelEnsemble::LaunchStep(const std::shared_ptr<Item>& item, size_t step) {
+    const Step& info = steps_[step];
+    std::vector<std::shared_ptr<Tensor>> inputs;
+    inputs.reserve(info.sources.size());
+    {
+        std::lock_guard<std::mutex> lock(item->mutex);
+        for (const auto& source : info.sources) {
+            if (source.first == kEnsembleInput) {
+                inputs.push_back(item->inputs[source.second]);
+                continue;
+            }
+            const size_t producer = static_cast<size_t>(source.first);
+            inputs.push_back(item->outputs[producer][source.second]);
+            // 最后一个消费者已取得引用，集成不再持有该中间结果
+            if (--item->uses[producer][source.second] == 0 && !steps_[producer].output_pinned[source.second]) {
+                item->outputs[producer][source.second].reset();
+            }
+        }
+    }
+    step_runs_.fetch_add(1, std::memory_order_relaxed);
+    Status status = info.session->RunAsync(std::move(inputs),
+        [this, item, step](Status run_status, std::vector<std::shared_ptr<Tensor>> outputs) {
+            CompleteStep(item, step, std::move(run_status), std::move(outputs));
+        });
+    if (!status.IsOk()) {
+        // 未受理时回调不会被调用
+        CompleteStep(item, step, status, {});
+    }
+}
+
+void ModelEnsemble::CompleteStep(const std::shared_ptr<Item>& item, size_t step, Status status,
+                                 std::vector<std::shared_ptr<Tensor>> outputs) {
+    const Step& info = steps_[step];
+    if (status.IsOk() && outputs.size() != info.output_uses.size()) {
+        status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Unexpected output count");
+    }
+    std::vector<size_t> ready;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(item->mutex);
+        --item->running;
+        ++item->finished;
+        if (!status.IsOk()) {
+            if (item->status.IsOk()) {
+                item->status = Status::Error(status.Code(), "Ensemble step " + info.name + ": " + status.Message());
+            }
+        } else if (item->status.IsOk()) {
+            item->outputs[step] = std::move(outputs);
+            for (size_t consumer : info.consumers) {
+                if (--item->pending[consumer] == 0) {
+                    ready.push_back(consumer);
+                }
+            }
+            item->running += ready.size();
+        }
+        // 失败后不再提交新的步骤，等已提交的完成
+        finished = item->running == 0 && (!item->status.IsOk() || item->finished == steps_.size());
+    }
+    for (size_t s : ready) {
+        LaunchStep(item, s);
+    }
+    if (finished) {
+        FinishItem(item);
+    }
+}
+
+void ModelEnsemble::FinishItem(const std::shared_ptr<Item>& item) {
+    StreamState* stream = item->stream;
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    if (item->status.IsOk()) {
+        for (const auto& source : output_sources_) {
+            outputs.push_back(source.first == kEnsembleInput
+                                  ? item->inputs[source.second]
+                                  : item->outputs[static_cast<size_t>(source.first)][source.second]);
+        }
+    } else {
+        failed_items_.fetch_add(1, std::memory_order_relaxed);
+        LOG_VERBOSE("Ensemble item " + std::to_string(item->index) + " failed: " + item->status.Message());
+    }
+    items_.fetch_add(1, std::memory_order_relaxed);
+    if (*stream->on_item) {
+        (*stream->on_item)(item->index, item->status, std::move(outputs));
+    }
+
+    // 腾出的位置交给下一个等待中的条目；最后一个条目完成后不再访问stream（RunStream随即返回）
+    bool start_next = false;
+    size_t next = 0;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        if (!item->status.IsOk() && stream->first_error.IsOk()) {
+            stream->first_error = item->status;
+        }
+        ++stream->completed;
+        if (stream->next < stream->items->size()) {
+            start_next = true;
+            next = stream->next++;
+        } else {
+            --stream->inflight;
+        }
+        if (stream->completed == stream->items->size()) {
+            stream->done.notify_all();
+        }
+    }
+    if (start_next) {
+        StartItem(stream, next);
+    }
+}
+
+} // namespace inferunity
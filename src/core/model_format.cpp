@@ -0,0 +1,1220 @@
+// 紧凑二进制模型格式实现
+// 保存时按固定布局写出记录表，权重逐个对齐写入；加载时映射整个文件，
+// 校验各段边界后直接读取记录，权重张量指向映射内的对齐地址。
+// 压缩的权重段按块并行压缩与解压，块之间没有依赖
+
+#include "inferunity/model_format.h"
+#include "inferunity/memory.h"
+#include "inferunity/tensor.h"
+#include "inferunity/logger.h"
+#include "inferunity/runtime.h"
+#include "core/align_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+
+constexpr char kMagic[4] = {'I', 'U', 'N', 'M'};
+constexpr uint32_t kByteOrderMark = 0x01020304;  // 读到其他值说明文件来自不同字节序的机器
+
+constexpr uint32_t kMinCompactModelVersion = 3;  // 版本4只增加了权重段压缩，布局不变
+
+constexpr uint32_t kValueHasShape = 1u << 0;
+constexpr uint32_t kValueHasWeight = 1u << 1;
+
+constexpr uint32_t kHeaderCompressedWeights = 1u << 0;
+
+constexpr uint32_t kChunkStored = 0;
+constexpr uint32_t kChunkLz4 = 1;
+
+// 段：offset为相对文件开头的字节偏移，count为元素个数
+struct Section {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t flags;          // kHeaderCompressedWeights
+    uint64_t file_size;
+    Section values;
+    Section nodes;
+    Section attributes;
+    Section indices;
+    Section dims;
+    Section floats;
+    Section strings;
+    Section weights;      // count为权重段的字节数
+    uint32_t inputs_begin;   // 图输入在索引池中的区间
+    uint32_t num_inputs;
+    uint32_t outputs_begin;  // 图输出在索引池中的区间
+    uint32_t num_outputs;
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct ValueRecord {
+    StringRef name;
+    StringRef symbols;       // 各维度的符号名，以'\n'分隔；没有动态维度时为空
+    int32_t dtype;
+    uint32_t flags;
+    uint32_t dims_begin;
+    uint32_t rank;
+    uint64_t weight_offset;  // 相对权重段开头
+    uint64_t weight_size;
+};
+
+struct NodeRecord {
+    StringRef op_type;
+    StringRef name;
+    uint32_t inputs_begin;
+    uint32_t num_inputs;
+    uint32_t outputs_begin;
+    uint32_t num_outputs;
+    uint32_t attributes_begin;
+    uint32_t num_attributes;
+    int32_t device;
+    uint32_t reserved;
+};
+
+// 属性按AttributeValue的类型保存：INTS与TENSOR的形状在维度池中，FLOATS在浮点池中，
+// TENSOR的数据与权重一样对齐写入权重段
+struct AttributeRecord {
+    StringRef key;
+    int32_t type;            // AttributeValue::Type
+    int32_t dtype;           // TENSOR的数据类型
+    StringRef text;          // STRING
+    uint32_t list_begin;     // INTS/TENSOR形状在维度池中、FLOATS在浮点池中的区间
+    uint32_t list_count;
+    int64_t int_value;
+    float float_value;
+    uint32_t reserved;
+    uint64_t weight_offset;  // TENSOR数据相对权重段开头
+    uint64_t weight_size;
+};
+
+// 压缩的权重段：开头为WeightChunkTable，随后num_chunks个WeightChunk，再后为各块的数据。
+// 记录中的weight_offset相对于解压后的权重段
+struct WeightChunkTable {
+    uint64_t raw_size;       // 解压后权重段的字节数
+    uint64_t num_chunks;
+};
+
+struct WeightChunk {
+    uint64_t raw_offset;     // 在解压后权重段中的偏移
+    uint64_t data_offset;    // 块数据相对压缩权重段开头
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t codec;          // kChunkStored/kChunkLz4
+    uint32_t shuffle;        // 字节重排的元素宽度，1表示未重排
+};
+
+bool IsWeight(const Value* value, const std::unordered_set<const Value*>& graph_inputs) {
+    const Tensor* tensor = value->GetTensor().get();
+    return !value->GetProducer() && !graph_inputs.count(value) &&
+           tensor && tensor->GetData() && tensor->GetSizeInBytes() > 0;
+}
+
+// 段在文件范围内且起始地址满足记录的对齐要求
+bool SectionInBounds(const Section& section, size_t element_size, size_t alignment, uint64_t file_size) {
+    if (section.offset % alignment != 0 || section.offset > file_size) {
+        return false;
+    }
+    return section.count <= (file_size - section.offset) / element_size;
+}
+
+// 64位FNV-1a的按字扩展：每次吸收8字节，权重很大时比逐字节快得多
+class Hasher {
+public:
+    void Update(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            Mix(word);
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes + i, size - i);
+        Mix(tail ^ (static_cast<uint64_t>(size - i) << 56));
+    }
+    void Update(const std::string& text) {
+        Update(static_cast<uint64_t>(text.size()));
+        Update(text.data(), text.size());
+    }
+    void Update(uint64_t value) { Mix(value); }
+    uint64_t Digest() const { return hash_; }
+
+private:
+    void Mix(uint64_t word) {
+        hash_ = (hash_ ^ word) * 0x100000001b3ULL;
+        hash_ ^= hash_ >> 29;
+    }
+    
+    uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+// ---- LZ4块格式 ----
+// 序列为token（高4位字面量长度、低4位匹配长度-4，15表示后续还有长度字节）、字面量、2字节小端偏移、
+// 匹配长度的后续字节；最后一个序列只有字面量。压缩用单路哈希表贪心匹配，连续未命中时加大步长
+
+constexpr size_t kLz4MinMatch = 4;
+constexpr size_t kLz4LastLiterals = 5;   // 块的最后5字节总是字面量
+constexpr size_t kLz4MatchLimit = 12;    // 最后一个匹配须在块结束前12字节之前开始
+constexpr size_t kLz4MaxOffset = 65535;
+constexpr int kLz4HashBits = 14;
+
+size_t Lz4CompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+inline uint32_t Load32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint8_t* Lz4WriteLength(uint8_t* out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *out++ = 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+// 写入dst（容量至少为Lz4CompressBound(size)），返回压缩后的字节数
+size_t Lz4Compress(const uint8_t* src, size_t size, uint8_t* dst) {
+    uint8_t* out = dst;
+    auto emit = [&](size_t anchor, size_t literals, size_t offset, size_t match) {
+        uint8_t* token = out++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+        if (literals >= 15) {
+            out = Lz4WriteLength(out, literals - 15);
+        }
+        std::memcpy(out, src + anchor, literals);
+        out += literals;
+        if (match > 0) {
+            *out++ = static_cast<uint8_t>(offset & 0xff);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+            const size_t code = match - kLz4MinMatch;
+            *token |= static_cast<uint8_t>(std::min<size_t>(code, 15));
+            if (code >= 15) {
+                out = Lz4WriteLength(out, code - 15);
+            }
+        }
+    };
+    
+    size_t anchor = 0;
+    if (size > kLz4MatchLimit) {
+        std::vector<uint32_t> table(size_t(1) << kLz4HashBits, 0);
+        const size_t match_start_limit = size - kLz4MatchLimit;
+        const size_t match_end_limit = size - kLz4LastLiterals;
+        size_t pos = 1;
+        size_t misses = 0;
+        while (pos < match_start_limit) {
+            const uint32_t sequence = Load32(src + pos);
+            const uint32_t hash = (sequence * 2654435761u) >> (32 - kLz4HashBits);
+            const size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos);
+            if (pos - candidate > kLz4MaxOffset || Load32(src + candidate) != sequence) {
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            size_t match = kLz4MinMatch;
+            while (pos + match < match_end_limit && src[candidate + match] == src[pos + match]) {
+                ++match;
+            }
+            emit(anchor, pos - anchor, pos - candidate, match);
+            pos += match;
+            anchor = pos;
+            misses = 0;
+        }
+    }
+    emit(anchor, size - anchor, 0, 0);
+    return static_cast<size_t>(out - dst);
+}
+
+// 解压到恰好raw_size字节；数据不合法（越界、偏移超出已解压部分、长度不符）时返回false
+bool Lz4Decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t raw_size) {
+    const uint8_t* in = src;
+    const uint8_t* in_end = src + size;
+    uint8_t* out = dst;
+    uint8_t* out_end = dst + raw_size;
+    auto read_length = [&](size_t* length) {
+        uint8_t byte;
+        do {
+            if (in >= in_end) {
+                return false;
+            }
+            byte = *in++;
+            *length += byte;
+        } while (byte == 255);
+        return true;
+    };
+    while (in < in_end) {
+        const uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(&literals)) {
+            return false;
+        }
+        if (literals > static_cast<size_t>(in_end - in) || literals > static_cast<size_t>(out_end - out)) {
+            return false;
+        }
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == in_end) {
+            break;
+        }
+        if (in_end - in < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t match = token & 15;
+        if (match == 15 && !read_length(&match)) {
+            return false;
+        }
+        match += kLz4MinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(out - dst) || match > static_cast<size_t>(out_end - out)) {
+            return false;
+        }
+        const uint8_t* from = out - offset;
+        if (offset >= match) {
+            std::memcpy(out, from, match);
+        } else {
+            // 重叠的匹配（游程）须逐字节复制
+            for (size_t i = 0; i < match; ++i) {
+                out[i] = from[i];
+            }
+        }
+        out += match;
+    }
+    return out == out_end;
+}
+
+// 字节重排：width字节的元素，各元素的第b个字节连续存放
+void ShuffleBytes(const uint8_t* src, size_t size, size_t width, uint8_t* dst) {
+    const size_t count = size / width;
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t b = 0; b < width; ++b) {
+            dst[b * count + i] = src[i * width + b];
+        }
+    }
+}
+
+void UnshuffleBytes(const uint8_t* src, size_t size, size_t width, uint8_t* dst) {
+    const size_t count = size / width;
+    for (size_t b = 0; b < width; ++b) {
+        const uint8_t* plane = src + b * count;
+        for (size_t i = 0; i < count; ++i) {
+            dst[i * width + b] = plane[i];
+        }
+    }
+}
+
+// 一个块的压缩结果
+struct CompressedChunk {
+    WeightChunk record{};
+    std::vector<uint8_t> data;
+};
+
+// 把各权重切块并行压缩；压不小的块按原样存放（不重排）
+std::vector<CompressedChunk> CompressWeights(const std::vector<std::pair<uint64_t, const Tensor*>>& weights,
+                                             const CompactModelSaveOptions& options) {
+    // 块表以32位记录块的原始大小
+    const uint64_t chunk_size = AlignUp(std::min<uint64_t>(std::max<uint64_t>(options.chunk_size, 1), uint64_t(1) << 30),
+                                        kCompactModelWeightAlignment);
+    std::vector<CompressedChunk> chunks;
+    std::vector<const uint8_t*> sources;
+    for (const auto& weight : weights) {
+        const uint64_t size = weight.second->GetSizeInBytes();
+        const size_t width = GetDataTypeSize(weight.second->GetDataType());
+        for (uint64_t begin = 0; begin < size; begin += chunk_size) {
+            CompressedChunk chunk;
+            chunk.record.raw_offset = weight.first + begin;
+            chunk.record.raw_size = static_cast<uint32_t>(std::min(chunk_size, size - begin));
+            chunk.record.shuffle = options.byte_shuffle && width > 1 ? static_cast<uint32_t>(width) : 1;
+            chunks.push_back(std::move(chunk));
+            sources.push_back(static_cast<const uint8_t*>(weight.second->GetData()) + begin);
+        }
+    }
+    ThreadPool::ParallelFor(0, static_cast<int64_t>(chunks.size()), 1, [&](int64_t begin, int64_t end) {
+        std::vector<uint8_t> shuffled;
+        for (int64_t c = begin; c < end; ++c) {
+            WeightChunk& record = chunks[c].record;
+            std::vector<uint8_t>& data = chunks[c].data;
+            const uint8_t* source = sources[c];
+            if (record.shuffle > 1) {
+                shuffled.resize(record.raw_size);
+                ShuffleBytes(source, record.raw_size, record.shuffle, shuffled.data());
+                source = shuffled.data();
+            }
+            data.resize(Lz4CompressBound(record.raw_size));
+            const size_t compressed = Lz4Compress(source, record.raw_size, data.data());
+            if (compressed < record.raw_size) {
+                record.codec = kChunkLz4;
+                data.resize(compressed);
+            } else {
+                record.codec = kChunkStored;
+                record.shuffle = 1;
+                data.assign(sources[c], sources[c] + record.raw_size);
+            }
+            data.shrink_to_fit();
+            record.stored_size = static_cast<uint32_t>(data.size());
+        }
+    });
+    return chunks;
+}
+
+// 校验块表并把各块并行解压到新分配的对齐缓冲区
+Status DecompressWeights(const uint8_t* section, uint64_t section_size, const std::string& filepath,
+                         std::shared_ptr<uint8_t>* buffer, uint64_t* raw_size) {
+    const Status corrupted = Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                                           "Corrupted compressed weights: " + filepath);
+    WeightChunkTable table;
+    if (section_size < sizeof(WeightChunkTable)) {
+        return corrupted;
+    }
+    std::memcpy(&table, section, sizeof(table));
+    if (table.num_chunks > (section_size - sizeof(WeightChunkTable)) / sizeof(WeightChunk)) {
+        return corrupted;
+    }
+    const uint64_t data_begin = sizeof(WeightChunkTable) + table.num_chunks * sizeof(WeightChunk);
+    std::vector<WeightChunk> chunks(static_cast<size_t>(table.num_chunks));
+    std::memcpy(chunks.data(), section + sizeof(WeightChunkTable), chunks.size() * sizeof(WeightChunk));
+    uint64_t covered = 0;
+    for (const WeightChunk& chunk : chunks) {
+        const bool valid_codec = chunk.codec == kChunkLz4 ||
+                                 (chunk.codec == kChunkStored && chunk.stored_size == chunk.raw_size);
+        if (!valid_codec || chunk.shuffle == 0 || chunk.raw_size % chunk.shuffle != 0 ||
+            chunk.raw_offset > table.raw_size || chunk.raw_size > table.raw_size - chunk.raw_offset ||
+            chunk.data_offset < data_begin || chunk.data_offset > section_size ||
+            chunk.stored_size > section_size - chunk.data_offset) {
+            return corrupted;
+        }
+        // 权重之间只有不足一个对齐单位的填充
+        covered += chunk.raw_size + kCompactModelWeightAlignment;
+    }
+    if (table.raw_size > covered) {
+        return corrupted;
+    }
+    
+    *raw_size = table.raw_size;
+    void* data = AllocateMemory(static_cast<size_t>(std::max<uint64_t>(table.raw_size, 1)),
+                                kCompactModelWeightAlignment);
+    if (!data) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
+                           "Cannot allocate " + std::to_string(table.raw_size) + " bytes of weights: " + filepath);
+    }
+    buffer->reset(static_cast<uint8_t*>(data), [](uint8_t* ptr) { FreeMemory(ptr); });
+    uint8_t* output = buffer->get();
+    
+    // 先为整个压缩段发起预读，前面的块解压时后面的页已在读入
+    PrefetchMemory(section + data_begin, static_cast<size_t>(section_size - data_begin));
+    std::atomic<bool> failed{false};
+    ThreadPool::ParallelFor(0, static_cast<int64_t>(chunks.size()), 1, [&](int64_t begin, int64_t end) {
+        std::vector<uint8_t> shuffled;
+        for (int64_t c = begin; c < end && !failed.load(std::memory_order_relaxed); ++c) {
+            const WeightChunk& chunk = chunks[c];
+            const uint8_t* source = section + chunk.data_offset;
+            uint8_t* target = output + chunk.raw_offset;
+            if (chunk.codec == kChunkStored) {
+                std::memcpy(target, source, chunk.raw_size);
+                continue;
+            }
+            uint8_t* decoded = target;
+            if (chunk.shuffle > 1) {
+                shuffled.resize(chunk.raw_size);
+                decoded = shuffled.data();
+            }
+            if (!Lz4Decompress(source, chunk.stored_size, decoded, chunk.raw_size)) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            if (chunk.shuffle > 1) {
+                UnshuffleBytes(decoded, chunk.raw_size, chunk.shuffle, target);
+            }
+        }
+    });
+    if (failed.load()) {
+        buffer->reset();
+        return corrupted;
+    }
+    return Status::Ok();
+}
+
+template <typename T>
+const T* SectionData(const uint8_t* base, const Section& section) {
+    return reinterpret_cast<const T*>(base + section.offset);
+}
+
+// 属性按键排序，同一个图每次写出的文件与哈希相同
+std::vector<const std::pair<const std::string, AttributeValue>*> SortedAttributes(const Node& node) {
+    std::vector<const std::pair<const std::string, AttributeValue>*> sorted;
+    for (const auto& attr : node.GetAttributes()) {
+        sorted.push_back(&attr);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    return sorted;
+}
+
+// 紧凑格式的输出目标：Begin在写入前得到总大小，Write按顺序追加，Finish提交
+class CompactModelSink {
+public:
+    virtual ~CompactModelSink() = default;
+    virtual Status Begin(uint64_t size) = 0;
+    virtual void Write(const void* data, uint64_t size) = 0;
+    virtual Status Finish() = 0;
+};
+
+class FileSink : public CompactModelSink {
+public:
+    explicit FileSink(const std::string& filepath) : filepath_(filepath) {}
+    
+    Status Begin(uint64_t size) override {
+        (void)size;
+        file_.open(filepath_, std::ios::binary);
+        if (!file_.is_open()) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to open file: " + filepath_);
+        }
+        return Status::Ok();
+    }
+    void Write(const void* data, uint64_t size) override {
+        file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+    Status Finish() override {
+        if (!file_.good()) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to write file: " + filepath_);
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::string filepath_;
+    std::ofstream file_;
+};
+
+#ifndef _WIN32
+// 写入共享内存段或memfd：按总大小ftruncate后经共享映射写入。魔数最后写入，
+// 发布完成之前映射该段的进程只会看到"不是紧凑格式"而不是写了一半的模型
+class DescriptorSink : public CompactModelSink {
+public:
+    DescriptorSink(int fd, const std::string& label) : fd_(fd), label_(label) {}
+    ~DescriptorSink() override { Unmap(); }
+    
+    Status Begin(uint64_t size) override {
+        if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Cannot resize shared memory: " + label_);
+        }
+        void* data = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot map shared memory: " + label_);
+        }
+        data_ = static_cast<uint8_t*>(data);
+        size_ = static_cast<size_t>(size);
+        return Status::Ok();
+    }
+    void Write(const void* data, uint64_t size) override {
+        std::memcpy(data_ + written_, data, static_cast<size_t>(size));
+        if (written_ == 0) {
+            std::memset(data_, 0, sizeof(kMagic));
+        }
+        written_ += static_cast<size_t>(size);
+    }
+    Status Finish() override {
+        if (written_ != size_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Incomplete shared model: " + label_);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(data_, kMagic, sizeof(kMagic));
+        Unmap();
+        return Status::Ok();
+    }
+
+private:
+    void Unmap() {
+        if (data_) {
+            ::munmap(data_, size_);
+            data_ = nullptr;
+        }
+    }
+    
+    int fd_;
+    std::string label_;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t written_ = 0;
+};
+#endif
+
+} // namespace
+
+namespace {
+
+Status WriteCompactModel(const Graph& graph, CompactModelSink* sink,
+                         const CompactModelSaveOptions& options = CompactModelSaveOptions()) {
+    std::unordered_map<const Value*, uint32_t> value_index;
+    for (const auto& value : graph.GetValues()) {
+        value_index.emplace(value.get(), static_cast<uint32_t>(value_index.size()));
+    }
+    std::unordered_set<const Value*> graph_inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    
+    std::vector<ValueRecord> values;
+    std::vector<NodeRecord> nodes;
+    std::vector<AttributeRecord> attributes;
+    std::vector<uint32_t> indices;
+    std::vector<int64_t> dims;
+    std::vector<float> floats;
+    std::string strings;
+    std::vector<std::pair<uint64_t, const Tensor*>> weights;  // 权重段内偏移 -> 数据
+    
+    auto add_string = [&strings](const std::string& text) {
+        StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+        strings += text;
+        return ref;
+    };
+    auto add_indices = [&](const std::vector<Value*>& list, uint32_t* begin, uint32_t* count) {
+        *begin = static_cast<uint32_t>(indices.size());
+        *count = static_cast<uint32_t>(list.size());
+        for (const Value* value : list) {
+            indices.push_back(value_index.at(value));
+        }
+    };
+    
+    uint64_t weights_size = 0;
+    auto add_weight = [&](const Tensor* tensor, uint64_t* weight_offset, uint64_t* weight_size) {
+        *weight_offset = AlignUp(weights_size, kCompactModelWeightAlignment);
+        *weight_size = tensor->GetSizeInBytes();
+        weights_size = *weight_offset + *weight_size;
+        weights.emplace_back(*weight_offset, tensor);
+    };
+    for (const auto& value : graph.GetValues()) {
+        ValueRecord record{};
+        record.name = add_string(value->GetName());
+        record.dtype = static_cast<int32_t>(DataType::UNKNOWN);
+        const Tensor* tensor = value->GetTensor().get();
+        const bool is_weight = IsWeight(value.get(), graph_inputs);
+        // 中间值的形状由加载后的形状推断重新得到，只保存权重与图输入的形状
+        if (tensor && (is_weight || graph_inputs.count(value.get()))) {
+            const Shape& shape = tensor->GetShape();
+            record.dtype = static_cast<int32_t>(tensor->GetDataType());
+            record.flags |= kValueHasShape;
+            record.dims_begin = static_cast<uint32_t>(dims.size());
+            record.rank = static_cast<uint32_t>(shape.dims.size());
+            std::string symbols;
+            for (size_t i = 0; i < shape.dims.size(); ++i) {
+                bool dynamic = i < shape.is_dynamic.size() && shape.is_dynamic[i];
+                dims.push_back(dynamic ? -1 : shape.dims[i]);
+                if (i > 0) symbols += '\n';
+                if (dynamic && i < shape.symbols.size()) symbols += shape.symbols[i];
+            }
+            if (shape.IsDynamic()) {
+                record.symbols = add_string(symbols);
+            }
+        }
+        if (is_weight) {
+            if (tensor->GetDataType() == DataType::STRING || tensor->GetDeviceType() != DeviceType::CPU) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "Unsupported weight for compact model: " + value->GetName());
+            }
+            record.flags |= kValueHasWeight;
+            add_weight(tensor, &record.weight_offset, &record.weight_size);
+        }
+        values.push_back(record);
+    }
+    
+    for (const auto& node : graph.GetNodes()) {
+        NodeRecord record{};
+        record.op_type = add_string(node->GetOpType());
+        record.name = add_string(node->GetName());
+        record.device = static_cast<int32_t>(node->GetDevice());
+        add_indices(node->GetInputs(), &record.inputs_begin, &record.num_inputs);
+        add_indices(node->GetOutputs(), &record.outputs_begin, &record.num_outputs);
+        const auto sorted = SortedAttributes(*node);
+        record.attributes_begin = static_cast<uint32_t>(attributes.size());
+        record.num_attributes = static_cast<uint32_t>(sorted.size());
+        for (const auto* attr : sorted) {
+            const AttributeValue& value = attr->second;
+            AttributeRecord attr_record{};
+            attr_record.key = add_string(attr->first);
+            attr_record.type = static_cast<int32_t>(value.GetType());
+            switch (value.GetType()) {
+                case AttributeValue::Type::INT:
+                    attr_record.int_value = value.GetInt();
+                    break;
+                case AttributeValue::Type::FLOAT:
+                    attr_record.float_value = value.GetFloat();
+                    break;
+                case AttributeValue::Type::STRING:
+                    attr_record.text = add_string(value.GetString());
+                    break;
+                case AttributeValue::Type::INTS:
+                    attr_record.list_begin = static_cast<uint32_t>(dims.size());
+                    attr_record.list_count = static_cast<uint32_t>(value.GetInts().size());
+                    dims.insert(dims.end(), value.GetInts().begin(), value.GetInts().end());
+                    break;
+                case AttributeValue::Type::FLOATS:
+                    attr_record.list_begin = static_cast<uint32_t>(floats.size());
+                    attr_record.list_count = static_cast<uint32_t>(value.GetFloats().size());
+                    floats.insert(floats.end(), value.GetFloats().begin(), value.GetFloats().end());
+                    break;
+                case AttributeValue::Type::TENSOR: {
+                    const Tensor* tensor = value.GetTensor().get();
+                    if (!tensor || !tensor->GetData() || tensor->GetDataType() == DataType::STRING ||
+                        tensor->GetDeviceType() != DeviceType::CPU) {
+                        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                           "Unsupported tensor attribute for compact model: " +
+                                           node->GetName() + "." + attr->first);
+                    }
+                    const auto& shape = tensor->GetShape().dims;
+                    attr_record.dtype = static_cast<int32_t>(tensor->GetDataType());
+                    attr_record.list_begin = static_cast<uint32_t>(dims.size());
+                    attr_record.list_count = static_cast<uint32_t>(shape.size());
+                    dims.insert(dims.end(), shape.begin(), shape.end());
+                    add_weight(tensor, &attr_record.weight_offset, &attr_record.weight_size);
+                    break;
+                }
+                case AttributeValue::Type::GRAPH:
+                    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                       "Subgraph attributes are not supported by compact models: " +
+                                       node->GetName() + "." + attr->first);
+            }
+            attributes.push_back(attr_record);
+        }
+        nodes.push_back(record);
+    }
+    
+    // 压缩时权重段为块表与各块数据，块数据紧接块表依次存放
+    const bool compress = options.compression == WeightCompression::LZ4;
+    std::vector<CompressedChunk> chunks;
+    WeightChunkTable chunk_table{weights_size, 0};
+    uint64_t section_size = weights_size;
+    if (compress) {
+        chunks = CompressWeights(weights, options);
+        chunk_table.num_chunks = chunks.size();
+        section_size = sizeof(WeightChunkTable) + chunks.size() * sizeof(WeightChunk);
+        for (CompressedChunk& chunk : chunks) {
+            chunk.record.data_offset = section_size;
+            section_size += chunk.record.stored_size;
+        }
+    }
+    
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kCompactModelVersion;
+    header.byte_order = kByteOrderMark;
+    header.flags = compress ? kHeaderCompressedWeights : 0;
+    add_indices(graph.GetInputs(), &header.inputs_begin, &header.num_inputs);
+    add_indices(graph.GetOutputs(), &header.outputs_begin, &header.num_outputs);
+    
+    // 依次排布各段，每段按8字节对齐，权重段按权重对齐
+    uint64_t offset = sizeof(FileHeader);
+    auto place = [&offset](Section* section, uint64_t count, size_t element_size, uint64_t alignment) {
+        offset = AlignUp(offset, alignment);
+        section->offset = offset;
+        section->count = count;
+        offset += count * element_size;
+    };
+    place(&header.values, values.size(), sizeof(ValueRecord), 8);
+    place(&header.nodes, nodes.size(), sizeof(NodeRecord), 8);
+    place(&header.attributes, attributes.size(), sizeof(AttributeRecord), 8);
+    place(&header.indices, indices.size(), sizeof(uint32_t), 8);
+    place(&header.dims, dims.size(), sizeof(int64_t), 8);
+    place(&header.floats, floats.size(), sizeof(float), 8);
+    place(&header.strings, strings.size(), 1, 8);
+    place(&header.weights, section_size, 1, kCompactModelWeightAlignment);
+    header.file_size = offset;
+    
+    Status status = sink->Begin(header.file_size);
+    if (!status.IsOk()) {
+        return status;
+    }
+    uint64_t written = 0;
+    auto write = [sink, &written](const void* data, uint64_t size) {
+        sink->Write(data, size);
+        written += size;
+    };
+    auto pad_to = [&](uint64_t target) {
+        static const char zeros[kCompactModelWeightAlignment] = {};
+        while (written < target) {
+            write(zeros, std::min<uint64_t>(target - written, sizeof(zeros)));
+        }
+    };
+    write(&header, sizeof(header));
+    pad_to(header.values.offset);
+    write(values.data(), values.size() * sizeof(ValueRecord));
+    pad_to(header.nodes.offset);
+    write(nodes.data(), nodes.size() * sizeof(NodeRecord));
+    pad_to(header.attributes.offset);
+    write(attributes.data(), attributes.size() * sizeof(AttributeRecord));
+    pad_to(header.indices.offset);
+    write(indices.data(), indices.size() * sizeof(uint32_t));
+    pad_to(header.dims.offset);
+    write(dims.data(), dims.size() * sizeof(int64_t));
+    pad_to(header.floats.offset);
+    write(floats.data(), floats.size() * sizeof(float));
+    pad_to(header.strings.offset);
+    write(strings.data(), strings.size());
+    if (compress) {
+        pad_to(header.weights.offset);
+        write(&chunk_table, sizeof(chunk_table));
+        for (const CompressedChunk& chunk : chunks) {
+            write(&chunk.record, sizeof(WeightChunk));
+        }
+        for (const CompressedChunk& chunk : chunks) {
+            write(chunk.data.data(), chunk.data.size());
+        }
+    } else {
+        for (const auto& weight : weights) {
+            pad_to(header.weights.offset + weight.first);
+            write(weight.second->GetData(), weight.second->GetSizeInBytes());
+        }
+    }
+    pad_to(header.file_size);
+    
+    return sink->Finish();
+}
+
+// 从映射重建图；filepath只用于错误信息
+Status ParseCompactModel(const std::shared_ptr<MappedFile>& file, const std::string& filepath,
+                         std::unique_ptr<Graph>& graph) {
+    const uint8_t* base = file->GetData();
+    const uint64_t file_size = file->GetSize();
+    
+    FileHeader header;
+    if (file_size < sizeof(FileHeader)) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Truncated compact model: " + filepath);
+    }
+    std::memcpy(&header, base, sizeof(FileHeader));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Not a compact model: " + filepath);
+    }
+    if (header.version < kMinCompactModelVersion || header.version > kCompactModelVersion ||
+        header.byte_order != kByteOrderMark || (header.version < 4 && header.flags != 0)) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                           "Unsupported compact model version " + std::to_string(header.version) +
+                           ": " + filepath);
+    }
+    if (header.file_size != file_size ||
+        !SectionInBounds(header.values, sizeof(ValueRecord), 8, file_size) ||
+        !SectionInBounds(header.nodes, sizeof(NodeRecord), 8, file_size) ||
+        !SectionInBounds(header.attributes, sizeof(AttributeRecord), 8, file_size) ||
+        !SectionInBounds(header.indices, sizeof(uint32_t), 8, file_size) ||
+        !SectionInBounds(header.dims, sizeof(int64_t), 8, file_size) ||
+        !SectionInBounds(header.floats, sizeof(float), 8, file_size) ||
+        !SectionInBounds(header.strings, 1, 1, file_size) ||
+        !SectionInBounds(header.weights, 1, kCompactModelWeightAlignment, file_size)) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Corrupted compact model: " + filepath);
+    }
+    
+    const ValueRecord* values = SectionData<ValueRecord>(base, header.values);
+    const NodeRecord* nodes = SectionData<NodeRecord>(base, header.nodes);
+    const AttributeRecord* attributes = SectionData<AttributeRecord>(base, header.attributes);
+    const uint32_t* indices = SectionData<uint32_t>(base, header.indices);
+    const int64_t* dims = SectionData<int64_t>(base, header.dims);
+    const float* floats = SectionData<float>(base, header.floats);
+    const char* strings = SectionData<char>(base, header.strings);
+    const uint8_t* weights = base + header.weights.offset;
+    uint64_t weights_size = header.weights.count;
+    // 权重视图的持有者：未压缩时为映射，压缩时为解压缓冲区（映射随加载返回解除）
+    std::shared_ptr<const void> weight_owner = file;
+    if (header.flags & kHeaderCompressedWeights) {
+        std::shared_ptr<uint8_t> buffer;
+        Status status = DecompressWeights(weights, header.weights.count, filepath, &buffer, &weights_size);
+        if (!status.IsOk()) {
+            return status;
+        }
+        weights = buffer.get();
+        weight_owner = buffer;
+    }
+    
+    bool corrupted = false;
+    auto get_string = [&](const StringRef& ref) {
+        if (ref.offset > header.strings.count || ref.size > header.strings.count - ref.offset) {
+            corrupted = true;
+            return std::string();
+        }
+        return std::string(strings + ref.offset, ref.size);
+    };
+    auto in_range = [](uint64_t begin, uint64_t count, uint64_t total) {
+        return begin <= total && count <= total - begin;
+    };
+    
+    auto loaded = std::make_unique<Graph>();
+    std::vector<Value*> value_list;
+    value_list.reserve(static_cast<size_t>(header.values.count));
+    for (uint64_t i = 0; i < header.values.count; ++i) {
+        const ValueRecord& record = values[i];
+        Value* value = loaded->AddValue();
+        value->SetName(get_string(record.name));
+        value_list.push_back(value);
+        if (!(record.flags & kValueHasShape)) {
+            continue;
+        }
+        if (!in_range(record.dims_begin, record.rank, header.dims.count)) {
+            corrupted = true;
+            break;
+        }
+        Shape shape(std::vector<int64_t>(dims + record.dims_begin, dims + record.dims_begin + record.rank));
+        bool dynamic = false;
+        for (size_t d = 0; d < shape.dims.size(); ++d) {
+            if (shape.dims[d] < 0) {
+                shape.is_dynamic[d] = true;
+                dynamic = true;
+            }
+        }
+        const DataType dtype = static_cast<DataType>(record.dtype);
+        if (record.flags & kValueHasWeight) {
+            const size_t bytes = static_cast<size_t>(shape.GetElementCount()) * GetDataTypeSize(dtype);
+            if (dynamic || bytes != record.weight_size ||
+                !in_range(record.weight_offset, record.weight_size, weights_size)) {
+                corrupted = true;
+                break;
+            }
+            // 不拷贝：张量是映射（或解压缓冲区）的视图，删除器持有它
+            uint8_t* data = const_cast<uint8_t*>(weights + record.weight_offset);
+            value->SetTensor(std::shared_ptr<Tensor>(new Tensor(shape, dtype, data),
+                                                     [weight_owner](Tensor* view) { delete view; }));
+        } else if (!dynamic) {
+            // 形状确定的图输入预先创建张量，与ONNX解析器一致
+            value->SetTensor(CreateTensor(shape, dtype));
+        } else {
+            // 动态输入只保留形状与符号名
+            const std::string symbols = get_string(record.symbols);
+            shape.symbols.assign(shape.dims.size(), std::string());
+            size_t begin = 0;
+            for (size_t d = 0; d < shape.dims.size() && begin <= symbols.size(); ++d) {
+                size_t end = std::min(symbols.find('\n', begin), symbols.size());
+                if (shape.is_dynamic[d]) {
+                    shape.symbols[d] = symbols.substr(begin, end - begin);
+                }
+                begin = end + 1;
+            }
+            value->SetTensor(std::make_shared<Tensor>(shape, dtype, nullptr));
+        }
+    }
+    
+    for (uint64_t i = 0; i < header.nodes.count && !corrupted; ++i) {
+        const NodeRecord& record = nodes[i];
+        if (!in_range(record.inputs_begin, record.num_inputs, header.indices.count) ||
+            !in_range(record.outputs_begin, record.num_outputs, header.indices.count) ||
+            !in_range(record.attributes_begin, record.num_attributes, header.attributes.count)) {
+            corrupted = true;
+            break;
+        }
+        Node* node = loaded->AddNode(get_string(record.op_type), get_string(record.name));
+        node->SetDevice(static_cast<DeviceType>(record.device));
+        for (uint32_t a = 0; a < record.num_attributes && !corrupted; ++a) {
+            const AttributeRecord& attr = attributes[record.attributes_begin + a];
+            const uint64_t list_total = attr.type == static_cast<int32_t>(AttributeValue::Type::FLOATS)
+                ? header.floats.count : header.dims.count;
+            if (!in_range(attr.list_begin, attr.list_count, list_total)) {
+                corrupted = true;
+                break;
+            }
+            const int64_t* list_ints = dims + attr.list_begin;
+            const float* list_floats = floats + attr.list_begin;
+            AttributeValue value;
+            switch (static_cast<AttributeValue::Type>(attr.type)) {
+                case AttributeValue::Type::INT:
+                    value = AttributeValue(attr.int_value);
+                    break;
+                case AttributeValue::Type::FLOAT:
+                    value = AttributeValue(attr.float_value);
+                    break;
+                case AttributeValue::Type::STRING:
+                    value = AttributeValue(get_string(attr.text));
+                    break;
+                case AttributeValue::Type::INTS:
+                    value = AttributeValue(std::vector<int64_t>(list_ints, list_ints + attr.list_count));
+                    break;
+                case AttributeValue::Type::FLOATS:
+                    value = AttributeValue(std::vector<float>(list_floats, list_floats + attr.list_count));
+                    break;
+                case AttributeValue::Type::TENSOR: {
+                    Shape shape(std::vector<int64_t>(list_ints, list_ints + attr.list_count));
+                    const DataType dtype = static_cast<DataType>(attr.dtype);
+                    const size_t bytes = static_cast<size_t>(shape.GetElementCount()) * GetDataTypeSize(dtype);
+                    if (bytes != attr.weight_size ||
+                        !in_range(attr.weight_offset, attr.weight_size, weights_size)) {
+                        corrupted = true;
+                        break;
+                    }
+                    uint8_t* data = const_cast<uint8_t*>(weights + attr.weight_offset);
+                    value = AttributeValue(std::shared_ptr<Tensor>(new Tensor(shape, dtype, data),
+                                                                   [weight_owner](Tensor* view) { delete view; }));
+                    break;
+                }
+                default:
+                    corrupted = true;
+                    break;
+            }
+            node->SetAttribute(get_string(attr.key), value);
+        }
+        for (uint32_t k = 0; k < record.num_inputs; ++k) {
+            uint32_t index = indices[record.inputs_begin + k];
+            if (index >= value_list.size()) {
+                corrupted = true;
+                break;
+            }
+            node->AddInput(value_list[index]);
+        }
+        for (uint32_t k = 0; k < record.num_outputs; ++k) {
+            uint32_t index = indices[record.outputs_begin + k];
+            if (index >= value_list.size()) {
+                corrupted = true;
+                break;
+            }
+            node->AddOutput(value_list[index]);
+        }
+    }
+    
+    if (!corrupted && in_range(header.inputs_begin, header.num_inputs, header.indices.count) &&
+        in_range(header.outputs_begin, header.num_outputs, header.indices.count)) {
+        for (uint32_t k = 0; k < header.num_inputs && !corrupted; ++k) {
+            uint32_t index = indices[header.inputs_begin + k];
+            corrupted = index >= value_list.size();
+            if (!corrupted) {
+                loaded->AddInput(value_list[index]);
+            }
+        }
+        for (uint32_t k = 0; k < header.num_outputs && !corrupted; ++k) {
+            uint32_t index = indices[header.outputs_begin + k];
+            corrupted = index >= value_list.size();
+            if (!corrupted) {
+                loaded->AddOutput(value_list[index]);
+            }
+        }
+    } else {
+        corrupted = true;
+    }
+    if (corrupted) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Corrupted compact model: " + filepath);
+    }
+    
+    LOG_INFO("Loaded compact model " + filepath + ": " + std::to_string(header.nodes.count) + " nodes, " +
+             std::to_string(weights_size) +
+             ((header.flags & kHeaderCompressedWeights)
+                  ? " bytes of weights decompressed from " + std::to_string(header.weights.count) + " bytes"
+                  : " bytes of mapped weights"));
+    graph = std::move(loaded);
+    return Status::Ok();
+}
+
+} // namespace
+
+Status SaveCompactModel(const Graph& graph, const std::string& filepath) {
+    FileSink sink(filepath);
+    return WriteCompactModel(graph, &sink);
+}
+
+Status SaveCompactModel(const Graph& graph, const std::string& filepath, const CompactModelSaveOptions& options) {
+    FileSink sink(filepath);
+    return WriteCompactModel(graph, &sink, options);
+}
+
+Status LoadCompactModel(const std::string& filepath, std::unique_ptr<Graph>& graph) {
+    std::shared_ptr<MappedFile> file;
+    Status status = MappedFile::Open(filepath, &file);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return ParseCompactModel(file, filepath, graph);
+}
+
+Status LoadCompactModelFromMemory(const void* data, size_t size, std::unique_ptr<Graph>& graph) {
+    const std::string label = "memory buffer";
+    std::shared_ptr<MappedFile> file;
+    Status status = MappedFile::FromMemory(data, size, label, &file);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return ParseCompactModel(file, label, graph);
+}
+
+Status PublishCompactModel(const Graph& graph, const std::string& name) {
+#ifdef _WIN32
+    (void)graph;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Shared memory is not supported: " + name);
+#else
+    // 替换同名的旧段：已经映射旧段的进程继续使用旧内容，之后连接的进程看到新模型
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0444);
+    if (fd < 0) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot create shared memory: " + name);
+    }
+    Status status;
+    {
+        DescriptorSink sink(fd, name);
+        status = WriteCompactModel(graph, &sink);
+    }
+    ::close(fd);
+    if (!status.IsOk()) {
+        ::shm_unlink(name.c_str());
+        return status;
+    }
+    LOG_INFO("Published compact model to shared memory " + name);
+    return Status::Ok();
+#endif
+}
+
+Status PublishCompactModelToMemfd(const Graph& graph, int* fd) {
+#if defined(__linux__)
+    int memfd = ::memfd_create("inferunity_model", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot create memfd");
+    }
+    Status status;
+    {
+        DescriptorSink sink(memfd, "memfd");
+        status = WriteCompactModel(graph, &sink);
+    }
+    // 封印之后任何进程都不能再改写或改变大小，接收方可以放心地零拷贝映射
+    if (status.IsOk() &&
+        ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot seal memfd");
+    }
+    if (!status.IsOk()) {
+        ::close(memfd);
+        return status;
+    }
+    *fd = memfd;
+    return Status::Ok();
+#else
+    (void)graph;
+    (void)fd;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "memfd is not supported on this platform");
+#endif
+}
+
+Status LoadCompactModelFromSharedMemory(const std::string& name, std::unique_ptr<Graph>& graph) {
+    std::shared_ptr<MappedFile> file;
+    Status status = MappedFile::OpenSharedMemory(name, &file);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return ParseCompactModel(file, name, graph);
+}
+
+Status LoadCompactModelFromDescriptor(int fd, std::unique_ptr<Graph>& graph) {
+    const std::string label = "fd " + std::to_string(fd);
+    std::shared_ptr<MappedFile> file;
+    Status status = MappedFile::OpenDescriptor(fd, label, &file);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return ParseCompactModel(file, label, graph);
+}
+
+Status UnlinkSharedCompactModel(const std::string& name) {
+#ifdef _WIN32
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Shared memory is not supported: " + name);
+#else
+    if (::shm_unlink(name.c_str()) != 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Shared memory not found: " + name);
+    }
+    return Status::Ok();
+#endif
+}
+
+bool IsCompactModelBuffer(const void* data, size_t size) {
+    return data && size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool IsCompactModelFile(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+uint64_t HashTensorData(const Tensor& tensor) {
+    Hasher hasher;
+    hasher.Update(static_cast<uint64_t>(tensor.GetDataType()));
+    hasher.Update(static_cast<uint64_t>(tensor.GetShape().dims.size()));
+    for (int64_t dim : tensor.GetShape().dims) {
+        hasher.Update(static_cast<uint64_t>(dim));
+    }
+    if (tensor.GetData()) {
+        hasher.Update(tensor.GetData(), tensor.GetSizeInBytes());
+    }
+    return hasher.Digest();
+}
+
+uint64_t HashGraph(const Graph& graph) {
+    // 值用在图中的出现顺序编号，同一个模型多次解析得到相同的哈希
+    std::unordered_map<const Value*, uint64_t> value_index;
+    for (const auto& value : graph.GetValues()) {
+        value_index.emplace(value.get(), value_index.size());
+    }
+    std::unordered_set<const Value*> graph_inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    
+    Hasher hasher;
+    hasher.Update(static_cast<uint64_t>(kCompactModelVersion));
+    for (const auto& value : graph.GetValues()) {
+        hasher.Update(value->GetName());
+        const Tensor* tensor = value->GetTensor().get();
+        const bool is_weight = IsWeight(value.get(), graph_inputs);
+        if (tensor && (is_weight || graph_inputs.count(value.get()))) {
+            hasher.Update(static_cast<uint64_t>(tensor->GetDataType()));
+            for (int64_t dim : tensor->GetShape().dims) {
+                hasher.Update(static_cast<uint64_t>(dim));
+            }
+        }
+        if (is_weight) {
+            hasher.Update(tensor->GetData(), tensor->GetSizeInBytes());
+        }
+    }
+    for (const auto& node : graph.GetNodes()) {
+        hasher.Update(node->GetOpType());
+        hasher.Update(node->GetName());
+        for (const auto* attr : SortedAttributes(*node)) {
+            const AttributeValue& value = attr->second;
+            hasher.Update(attr->first);
+            hasher.Update(static_cast<uint64_t>(value.GetType()));
+            hasher.Update(value.ToString());
+            if (value.GetType() == AttributeValue::Type::TENSOR && value.GetTensor() &&
+                value.GetTensor()->GetData()) {
+                hasher.Update(value.GetTensor()->GetData(), value.GetTensor()->GetSizeInBytes());
+            }
+        }
+        hasher.Update(static_cast<uint64_t>(node->GetInputs().size()));
+        for (const Value* input : node->GetInputs()) {
+            hasher.Update(value_index.at(input));
+        }
+        hasher.Update(static_cast<uint64_t>(node->GetOutputs().size()));
+        for (const Value* output : node->GetOutputs()) {
+            hasher.Update(value_index.at(output));
+        }
+    }
+    for (const auto* list : {&graph.GetInputs(), &graph.GetOutputs()}) {
+        hasher.Update(static_cast<uint64_t>(list->size()));
+        for (const Value* value : *list) {
+            hasher.Update(value_index.at(value));
+        }
+    }
+    return hasher.Digest();
+}
+
+} // namespace inferunity
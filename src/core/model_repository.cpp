@@ -0,0 +1,383 @@
+#include "inferunity/model_repository.h"
+#include "inferunity/logger.h"
+#include "inferunity/model_format.h"
+#include "inferunity/numa.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+
+// 共享副本：复制到匿名映射后把页设为只读；没有mmap时使用普通的自有张量。
+// 指定了节点时在写入（首次触碰）之前把映射设为该节点的内存
+std::shared_ptr<Tensor> CreateReadOnlyCopy(const Tensor& source, int numa_node) {
+    const size_t size = source.GetSizeInBytes();
+#ifndef _WIN32
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t mapped_size = (size + page - 1) / page * page;
+    void* data = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data != MAP_FAILED) {
+        if (numa_node >= 0) {
+            BindMemoryToNumaNode(data, mapped_size, numa_node);
+        }
+        std::memcpy(data, source.GetData(), size);
+        ::mprotect(data, mapped_size, PROT_READ);
+        return std::shared_ptr<Tensor>(
+            new Tensor(source.GetShape(), source.GetDataType(), data, source.GetLayout(), DeviceType::CPU),
+            [data, mapped_size](Tensor* tensor) {
+                delete tensor;
+                ::munmap(data, mapped_size);
+            });
+    }
+#endif
+    NumaNodeScope numa(numa_node, false);
+    auto copy = std::make_shared<Tensor>(source.GetShape(), source.GetDataType(), DeviceType::CPU);
+    if (!copy->GetData()) {
+        return nullptr;
+    }
+    std::memcpy(copy->GetData(), source.GetData(), size);
+    return copy;
+}
+
+bool SameContent(const Tensor& a, const Tensor& b) {
+    return a.GetDataType() == b.GetDataType() && a.GetShape().dims == b.GetShape().dims &&
+           a.GetLayout() == b.GetLayout() &&
+           std::memcmp(a.GetData(), b.GetData(), a.GetSizeInBytes()) == 0;
+}
+
+// 常量：没有生产者、不是图输入。先排除图输入再读取张量，串行运行会改写图输入Value上的张量
+template <typename Visitor>
+void ForEachConstant(const Graph& graph, Visitor visit) {
+    const std::unordered_set<const Value*> inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    for (const auto& value : graph.GetValues()) {
+        if (value->GetProducer() || inputs.count(value.get())) {
+            continue;
+        }
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        if (tensor && tensor->GetData()) {
+            visit(value.get(), tensor);
+        }
+    }
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// SharedWeightStore
+// ---------------------------------------------------------------------------
+SharedWeightStore::SharedWeightStore(size_t min_tensor_bytes) : min_tensor_bytes_(min_tensor_bytes) {}
+
+Status SharedWeightStore::Deduplicate(Graph* graph, int numa_node) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    // 同一个图内多个Value可能已经共用一个张量，只查一次
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> interned;
+    ForEachConstant(*graph, [&](Value* value, const std::shared_ptr<Tensor>& tensor) {
+        if (tensor->GetDeviceType() != DeviceType::CPU || tensor->GetDataType() == DataType::STRING ||
+            !tensor->IsContiguous() || tensor->GetSizeInBytes() < min_tensor_bytes_) {
+            return;
+        }
+        auto it = interned.find(tensor.get());
+        if (it == interned.end()) {
+            it = interned.emplace(tensor.get(), Intern(tensor, numa_node)).first;
+        }
+        if (it->second) {
+            value->SetTensor(it->second);
+        }
+    });
+    return Status::Ok();
+}
+
+std::shared_ptr<Tensor> SharedWeightStore::Intern(const std::shared_ptr<Tensor>& tensor, int numa_node) {
+    // 哈希与逐字节比较在锁外进行，权重很大时不阻塞其他会话的加载
+    const uint64_t hash = HashTensorData(*tensor);
+    std::vector<std::shared_ptr<Tensor>> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto range = entries_.equal_range(hash);
+        for (auto it = range.first; it != range.second;) {
+            if (auto shared = it->second.tensor.lock()) {
+                if (it->second.numa_node == numa_node) {
+                    candidates.push_back(shared);
+                }
+                ++it;
+            } else {
+                it = entries_.erase(it);
+            }
+        }
+    }
+    for (const auto& candidate : candidates) {
+        if (candidate == tensor) {
+            return candidate;
+        }
+        if (SameContent(*candidate, *tensor)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            deduplicated_bytes_ += tensor->GetSizeInBytes();
+            return candidate;
+        }
+    }
+    
+    std::shared_ptr<Tensor> copy = CreateReadOnlyCopy(*tensor, numa_node);
+    if (!copy) {
+        LOG_WARNING("Shared weight copy failed; keeping a private copy");
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 并发加载的会话可能同时插入了同样的内容，再确认一次
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto shared = it->second.tensor.lock();
+        if (shared && it->second.numa_node == numa_node && SameContent(*shared, *tensor)) {
+            deduplicated_bytes_ += tensor->GetSizeInBytes();
+            return shared;
+        }
+    }
+    entries_.emplace(hash, Entry{copy, numa_node});
+    return copy;
+}
+
+size_t SharedWeightStore::GetNumTensors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& entry : entries_) {
+        count += entry.second.tensor.expired() ? 0 : 1;
+    }
+    return count;
+}
+
+size_t SharedWeightStore::GetResidentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& entry : entries_) {
+        if (auto tensor = entry.second.tensor.lock()) {
+            bytes += tensor->GetSizeInBytes();
+        }
+    }
+    return bytes;
+}
+
+size_t SharedWeightStore::GetDeduplicatedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return deduplicated_bytes_;
+}
+
+// ---------------------------------------------------------------------------
+// ModelRepository
+// ---------------------------------------------------------------------------
+ModelRepository::ModelRepository(const ModelRepositoryOptions& options)
+    : options_(options),
+      weights_(std::make_shared<SharedWeightStore>(options.min_shared_weight_bytes)) {}
+
+ModelRepository::~ModelRepository() = default;
+
+SessionOptions ModelRepository::PrepareOptions(const SessionOptions& options) const {
+    SessionOptions prepared = options;
+    prepared.shared_weights = options_.share_weights ? weights_ : nullptr;
+    return prepared;
+}
+
+Status ModelRepository::LoadModel(const std::string& name, const std::string& filepath,
+                                  const SessionOptions& options) {
+    if (HasModel(name)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model already loaded: " + name);
+    }
+    auto session = InferenceSession::Create(PrepareOptions(options));
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create session for " + name);
+    }
+    Status status = session->LoadModel(filepath);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return AddSession(name, std::move(session));
+}
+
+Status ModelRepository::LoadModelFromGraph(const std::string& name, std::unique_ptr<Graph> graph,
+                                           const SessionOptions& options) {
+    if (HasModel(name)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model already loaded: " + name);
+    }
+    auto session = InferenceSession::Create(PrepareOptions(options));
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create session for " + name);
+    }
+    Status status = session->LoadModelFromGraph(std::move(graph));
+    if (!status.IsOk()) {
+        return status;
+    }
+    return AddSession(name, std::move(session));
+}
+
+Status ModelRepository::AddSession(const std::string& name, std::unique_ptr<InferenceSession> session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 加载在锁外进行，其间可能有同名模型先完成
+    if (entries_.count(name)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model already loaded: " + name);
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->session = std::shared_ptr<InferenceSession>(session.release());
+    entry->last_used = ++clock_;
+    entries_.emplace(name, entry);
+    // 加载时分配的arena同样计入预算
+    EnforceBudget(entry.get(), 0);
+    return Status::Ok();
+}
+
+Status ModelRepository::UnloadModel(const std::string& name) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(name);
+        if (it == entries_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Model not loaded: " + name);
+        }
+        entry = it->second;
+        entries_.erase(it);
+    }
+    // 会话（可能还有在途的运行）在锁外释放
+    entry.reset();
+    return Status::Ok();
+}
+
+bool ModelRepository::HasModel(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(name) > 0;
+}
+
+std::vector<std::string> ModelRepository::GetModelNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto& entry : entries_) {
+        names.push_back(entry.first);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::shared_ptr<InferenceSession> ModelRepository::GetSession(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    return it != entries_.end() ? it->second->session : nullptr;
+}
+
+Status ModelRepository::Run(const std::string& name, const std::vector<Tensor*>& inputs,
+                            std::vector<std::shared_ptr<Tensor>>& outputs) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(name);
+        if (it == entries_.end()) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Model not loaded: " + name);
+        }
+        entry = it->second;
+        ++entry->in_flight;
+        entry->last_used = ++clock_;
+        // 被释放过的会话这次运行会重新分配规划的arena
+        const size_t reserve = entry->session->GetMemoryStats().allocated_bytes == 0
+            ? entry->session->GetMemoryPlan().arena_size : 0;
+        EnforceBudget(entry.get(), reserve);
+    }
+    
+    Status status = entry->session->Run(inputs, outputs);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    --entry->in_flight;
+    EnforceBudget(entry.get(), 0);
+    return status;
+}
+
+size_t ModelRepository::ActivationBytesLocked() const {
+    size_t bytes = 0;
+    for (const auto& entry : entries_) {
+        bytes += entry.second->session->GetMemoryStats().allocated_bytes;
+    }
+    return bytes;
+}
+
+void ModelRepository::EnforceBudget(const Entry* keep, size_t reserve) {
+    if (options_.memory_budget_bytes == 0) {
+        return;
+    }
+    size_t used = ActivationBytesLocked();
+    if (used + reserve <= options_.memory_budget_bytes) {
+        return;
+    }
+    std::vector<Entry*> candidates;
+    for (const auto& entry : entries_) {
+        if (entry.second.get() != keep && entry.second->in_flight == 0 &&
+            entry.second->session->GetMemoryStats().allocated_bytes > 0) {
+            candidates.push_back(entry.second.get());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Entry* a, const Entry* b) { return a->last_used < b->last_used; });
+    for (Entry* candidate : candidates) {
+        if (used + reserve <= options_.memory_budget_bytes) {
+            break;
+        }
+        const size_t released = candidate->session->ReleaseActivationMemory();
+        used = used > released ? used - released : 0;
+        ++evictions_;
+    }
+    if (used + reserve > options_.memory_budget_bytes) {
+        LOG_WARNING("Model repository over memory budget: " + std::to_string(used + reserve) + " > " +
+                    std::to_string(options_.memory_budget_bytes) + " bytes (remaining sessions are busy)");
+    }
+}
+
+Status ModelRepository::GetMemoryUsage(const std::string& name, ModelMemoryUsage* usage) const {
+    if (!usage) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Usage is null");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Model not loaded: " + name);
+    }
+    const InferenceSession& session = *it->second->session;
+    *usage = ModelMemoryUsage();
+    usage->activation = session.GetMemoryStats();
+    if (!session.GetGraph()) {
+        return Status::Ok();
+    }
+    
+    // 其他会话引用的常量，用来判断哪些权重是共享的
+    std::unordered_set<const Tensor*> others;
+    for (const auto& entry : entries_) {
+        if (entry.second != it->second && entry.second->session->GetGraph()) {
+            ForEachConstant(*entry.second->session->GetGraph(),
+                            [&others](Value*, const std::shared_ptr<Tensor>& tensor) { others.insert(tensor.get()); });
+        }
+    }
+    std::unordered_set<const Tensor*> counted;
+    ForEachConstant(*session.GetGraph(), [&](Value*, const std::shared_ptr<Tensor>& tensor) {
+        if (!counted.insert(tensor.get()).second) {
+            return;
+        }
+        usage->weight_bytes += tensor->GetSizeInBytes();
+        if (others.count(tensor.get())) {
+            usage->shared_weight_bytes += tensor->GetSizeInBytes();
+        }
+    });
+    return Status::Ok();
+}
+
+size_t ModelRepository::GetActivationMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ActivationBytesLocked();
+}
+
+size_t ModelRepository::GetNumEvictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+} // namespace inferunity
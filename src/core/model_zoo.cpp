@@ -0,0 +1,581 @@
+// 基准模型库实现
+// 每个模型由ZooBuilder逐层添加节点，节点与权重按PyTorch/HuggingFace模块的路径命名（如layer1.0.conv2），
+// 剖析结果可以与原模型逐层对照。权重由种子与权重序号派生的splitmix64序列生成，与平台和标准库无关
+
+#include "inferunity/model_zoo.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace inferunity {
+
+namespace {
+
+uint64_t SplitMix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// [-1, 1)上的均匀分布，24位精度
+float UniformSigned(uint64_t* state) {
+    return static_cast<float>(static_cast<double>(SplitMix64(state) >> 40) / (1ull << 23) - 1.0);
+}
+
+using Attributes = std::vector<std::pair<std::string, AttributeValue>>;
+
+AttributeValue Ints(const std::vector<int64_t>& values) {
+    return AttributeValue(values);
+}
+
+AttributeValue Int(int64_t value) {
+    return AttributeValue(value);
+}
+
+class ZooBuilder {
+public:
+    explicit ZooBuilder(uint64_t seed) : graph_(std::make_unique<Graph>()), seed_(seed) {}
+    
+    // 图输入，带一份[low, high)上均匀分布的示例数据
+    Value* Input(const std::string& name, const Shape& shape, float low, float high) {
+        auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        uint64_t state = NextStream();
+        float* data = static_cast<float*>(tensor->GetData());
+        for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+            data[i] = low + (high - low) * 0.5f * (UniformSigned(&state) + 1.0f);
+        }
+        return AddInput(name, tensor);
+    }
+    
+    // INT64的图输入（token id、嵌入表索引），示例数据在[0, upper)内
+    Value* IndexInput(const std::string& name, const Shape& shape, int64_t upper) {
+        auto tensor = CreateTensor(shape, DataType::INT64, DeviceType::CPU);
+        uint64_t state = NextStream();
+        int64_t* data = static_cast<int64_t*>(tensor->GetData());
+        for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+            data[i] = static_cast<int64_t>(SplitMix64(&state) % static_cast<uint64_t>(upper));
+        }
+        return AddInput(name, tensor);
+    }
+    
+    // [-bound, bound)上均匀分布的权重
+    Value* Weight(const std::string& name, const Shape& shape, float bound) {
+        auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        uint64_t state = NextStream();
+        float* data = static_cast<float*>(tensor->GetData());
+        for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+            data[i] = bound * UniformSigned(&state);
+        }
+        return Constant(name, tensor);
+    }
+    
+    // 按扇入缩放（±1/sqrt(fan_in)，PyTorch的Linear/Conv默认初始化）
+    Value* ScaledWeight(const std::string& name, const Shape& shape, int64_t fan_in) {
+        return Weight(name, shape, 1.0f / std::sqrt(static_cast<float>(std::max<int64_t>(fan_in, 1))));
+    }
+    
+    Value* Fill(const std::string& name, const Shape& shape, float value) {
+        auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        std::fill_n(static_cast<float*>(tensor->GetData()), tensor->GetElementCount(), value);
+        return Constant(name, tensor);
+    }
+    
+    Value* Dims(const std::string& name, const std::vector<int64_t>& dims) {
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(dims.size())}), DataType::INT64, DeviceType::CPU);
+        std::copy(dims.begin(), dims.end(), static_cast<int64_t*>(tensor->GetData()));
+        return Constant(name, tensor);
+    }
+    
+    Value* Constant(const std::string& name, std::shared_ptr<Tensor> tensor) {
+        Value* value = graph_->AddValue();
+        value->SetName(name);
+        value->SetTensor(std::move(tensor));
+        return value;
+    }
+    
+    // 添加一个单输出节点，返回其输出
+    Value* Apply(const std::string& name, const std::string& op, const std::vector<Value*>& inputs,
+                 const Attributes& attributes = {}) {
+        Node* node = graph_->AddNode(op, name);
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        for (const auto& attribute : attributes) {
+            node->SetAttribute(attribute.first, attribute.second);
+        }
+        Value* output = graph_->AddValue();
+        output->SetName(name);
+        node->AddOutput(output);
+        return output;
+    }
+    
+    void Output(Value* value, const std::string& name) {
+        value->SetName(name);
+        graph_->AddOutput(value);
+    }
+    
+    std::unique_ptr<Graph> Release() { return std::move(graph_); }
+    
+private:
+    Value* AddInput(const std::string& name, std::shared_ptr<Tensor> tensor) {
+        Value* value = graph_->AddValue();
+        value->SetName(name);
+        value->SetTensor(std::move(tensor));
+        graph_->AddInput(value);
+        return value;
+    }
+    
+    // 每个张量一条独立的随机序列：插入新的层不改变其他张量的内容
+    uint64_t NextStream() {
+        uint64_t state = seed_ ^ (0xD1B54A32D192ED03ull * ++streams_);
+        SplitMix64(&state);
+        return state;
+    }
+    
+    std::unique_ptr<Graph> graph_;
+    uint64_t seed_;
+    uint64_t streams_ = 0;
+};
+
+// 按倍数缩放的个数，至少为1
+int64_t ScaleCount(int64_t count, double factor) {
+    return std::max<int64_t>(1, std::llround(static_cast<double>(count) * factor));
+}
+
+// 按倍数缩放的通道数，取multiple的整数倍（MobileNet的make_divisible：不低于原值的90%）
+int64_t ScaleChannels(int64_t channels, double factor, int64_t multiple = 8) {
+    const double scaled = static_cast<double>(channels) * factor;
+    int64_t rounded = std::max<int64_t>(multiple, (static_cast<int64_t>(scaled + multiple / 2.0) / multiple) * multiple);
+    if (rounded < 0.9 * scaled) {
+        rounded += multiple;
+    }
+    return rounded;
+}
+
+// ---------------- 卷积网络 ----------------
+
+Value* Conv(ZooBuilder& b, const std::string& name, Value* x, int64_t in_c, int64_t out_c, int64_t kernel,
+            int64_t stride, int64_t group, bool bias) {
+    std::vector<Value*> inputs = {
+        x, b.ScaledWeight(name + ".weight", Shape({out_c, in_c / group, kernel, kernel}), in_c / group * kernel * kernel)};
+    if (bias) {
+        inputs.push_back(b.ScaledWeight(name + ".bias", Shape({out_c}), in_c / group * kernel * kernel));
+    }
+    const int64_t pad = kernel / 2;
+    return b.Apply(name, "Conv", inputs,
+                   {{"kernel_shape", Ints({kernel, kernel})}, {"strides", Ints({stride, stride})},
+                    {"pads", Ints({pad, pad, pad, pad})}, {"group", Int(group)}});
+}
+
+// Conv（无偏置）+ BatchNormalization (+ 激活)，与torchvision导出的ONNX模型相同，由图优化折叠
+Value* ConvBN(ZooBuilder& b, const std::string& name, Value* x, int64_t in_c, int64_t out_c, int64_t kernel,
+              int64_t stride, int64_t group, const std::string& activation) {
+    Value* y = Conv(b, name, x, in_c, out_c, kernel, stride, group, false);
+    const std::string bn = name + ".bn";
+    y = b.Apply(bn, "BatchNormalization",
+                {y, b.Fill(bn + ".weight", Shape({out_c}), 1.0f), b.Fill(bn + ".bias", Shape({out_c}), 0.0f),
+                 b.Fill(bn + ".running_mean", Shape({out_c}), 0.0f), b.Fill(bn + ".running_var", Shape({out_c}), 1.0f)},
+                {{"epsilon", AttributeValue(1e-5f)}});
+    return activation.empty() ? y : b.Apply(name + "." + activation, activation, {y});
+}
+
+// 全局平均池化、展平后的全连接分类层
+Value* Classifier(ZooBuilder& b, const std::string& name, Value* x, int64_t in_features, int64_t classes) {
+    x = b.Apply("avgpool", "GlobalAveragePool", {x});
+    x = b.Apply("flatten", "Flatten", {x}, {{"axis", Int(1)}});
+    return b.Apply(name, "Gemm",
+                   {x, b.ScaledWeight(name + ".weight", Shape({in_features, classes}), in_features),
+                    b.ScaledWeight(name + ".bias", Shape({classes}), in_features)});
+}
+
+Status BuildResNet50(const ZooModelOptions& options, ZooBuilder& b) {
+    const int64_t size = options.image_size > 0 ? options.image_size : 224;
+    Value* x = b.Input("input", Shape({options.batch_size, 3, size, size}), -1.0f, 1.0f);
+    int64_t in_c = ScaleChannels(64, options.width);
+    x = ConvBN(b, "conv1", x, 3, in_c, 7, 2, 1, "Relu");
+    x = b.Apply("maxpool", "MaxPool", {x},
+                {{"kernel_shape", Ints({3, 3})}, {"strides", Ints({2, 2})}, {"pads", Ints({1, 1, 1, 1})}});
+    
+    const int64_t blocks[] = {3, 4, 6, 3};
+    const int64_t widths[] = {64, 128, 256, 512};
+    for (int stage = 0; stage < 4; ++stage) {
+        const int64_t width = ScaleChannels(widths[stage], options.width);
+        const int64_t out_c = width * 4;
+        const int64_t count = ScaleCount(blocks[stage], options.depth);
+        for (int64_t i = 0; i < count; ++i) {
+            const std::string name = "layer" + std::to_string(stage + 1) + "." + std::to_string(i);
+            const int64_t stride = (i == 0 && stage > 0) ? 2 : 1;
+            Value* y = ConvBN(b, name + ".conv1", x, in_c, width, 1, 1, 1, "Relu");
+            y = ConvBN(b, name + ".conv2", y, width, width, 3, stride, 1, "Relu");
+            y = ConvBN(b, name + ".conv3", y, width, out_c, 1, 1, 1, "");
+            Value* identity = i == 0 ? ConvBN(b, name + ".downsample", x, in_c, out_c, 1, stride, 1, "") : x;
+            x = b.Apply(name + ".relu", "Relu", {b.Apply(name + ".add", "Add", {y, identity})});
+            in_c = out_c;
+        }
+    }
+    b.Output(Classifier(b, "fc", x, in_c, 1000), "logits");
+    return Status::Ok();
+}
+
+// MobileNetV3-Large的倒残差块配置（kernel, expand, out, SE, h-swish, stride）
+struct InvertedResidual {
+    int64_t kernel;
+    int64_t expand;
+    int64_t out;
+    bool se;
+    bool hswish;
+    int64_t stride;
+};
+
+const InvertedResidual kMobileNetV3Large[] = {
+    {3, 16, 16, false, false, 1},
+    {3, 64, 24, false, false, 2}, {3, 72, 24, false, false, 1},
+    {5, 72, 40, true, false, 2}, {5, 120, 40, true, false, 1}, {5, 120, 40, true, false, 1},
+    {3, 240, 80, false, true, 2}, {3, 200, 80, false, true, 1}, {3, 184, 80, false, true, 1},
+    {3, 184, 80, false, true, 1},
+    {3, 480, 112, true, true, 1}, {3, 672, 112, true, true, 1},
+    {5, 672, 160, true, true, 2}, {5, 960, 160, true, true, 1}, {5, 960, 160, true, true, 1},
+};
+
+Status BuildMobileNetV3(const ZooModelOptions& options, ZooBuilder& b) {
+    const int64_t size = options.image_size > 0 ? options.image_size : 224;
+    Value* x = b.Input("input", Shape({options.batch_size, 3, size, size}), -1.0f, 1.0f);
+    int64_t in_c = ScaleChannels(16, options.width);
+    x = ConvBN(b, "features.0", x, 3, in_c, 3, 2, 1, "Silu");
+    
+    // 输出通道相同的相邻块为一个阶段，depth缩放每个阶段的块数（保留阶段的第一块，即带stride的块）
+    const size_t rows = sizeof(kMobileNetV3Large) / sizeof(kMobileNetV3Large[0]);
+    int index = 1;
+    for (size_t begin = 0; begin < rows;) {
+        size_t end = begin + 1;
+        while (end < rows && kMobileNetV3Large[end].out == kMobileNetV3Large[begin].out) {
+            ++end;
+        }
+        const size_t count = static_cast<size_t>(ScaleCount(static_cast<int64_t>(end - begin), options.depth));
+        for (size_t r = begin; r < begin + std::min(count, end - begin); ++r) {
+            const InvertedResidual& block = kMobileNetV3Large[r];
+            const std::string name = "features." + std::to_string(index++);
+            const std::string activation = block.hswish ? "Silu" : "Relu";
+            const int64_t expand = ScaleChannels(block.expand, options.width);
+            const int64_t out_c = ScaleChannels(block.out, options.width);
+            Value* y = x;
+            if (expand != in_c) {
+                y = ConvBN(b, name + ".expand", y, in_c, expand, 1, 1, 1, activation);
+            }
+            y = ConvBN(b, name + ".depthwise", y, expand, expand, block.kernel, block.stride, expand, activation);
+            if (block.se) {
+                const int64_t squeeze = ScaleChannels(expand / 4, 1.0);
+                Value* s = b.Apply(name + ".se.avgpool", "GlobalAveragePool", {y});
+                s = b.Apply(name + ".se.relu", "Relu", {Conv(b, name + ".se.fc1", s, expand, squeeze, 1, 1, 1, true)});
+                s = b.Apply(name + ".se.sigmoid", "Sigmoid", {Conv(b, name + ".se.fc2", s, squeeze, expand, 1, 1, 1, true)});
+                y = b.Apply(name + ".se.scale", "Mul", {y, s});
+            }
+            y = ConvBN(b, name + ".project", y, expand, out_c, 1, 1, 1, "");
+            if (block.stride == 1 && in_c == out_c) {
+                y = b.Apply(name + ".add", "Add", {y, x});
+            }
+            x = y;
+            in_c = out_c;
+        }
+        begin = end;
+    }
+    
+    const int64_t last_c = ScaleChannels(960, options.width);
+    x = ConvBN(b, "features." + std::to_string(index), x, in_c, last_c, 1, 1, 1, "Silu");
+    const int64_t hidden = ScaleChannels(1280, options.width);
+    x = b.Apply("classifier.0.act", "Silu", {Classifier(b, "classifier.0", x, last_c, hidden)});
+    x = b.Apply("classifier.3", "Gemm",
+                {x, b.ScaledWeight("classifier.3.weight", Shape({hidden, 1000}), hidden),
+                 b.ScaledWeight("classifier.3.bias", Shape({1000}), hidden)});
+    b.Output(x, "logits");
+    return Status::Ok();
+}
+
+// ---------------- Transformer ----------------
+
+// 带偏置（可选）的全连接：MatMul + Add，由图优化融合为FusedMatMulAdd
+Value* Dense(ZooBuilder& b, const std::string& name, Value* x, int64_t in_features, int64_t out_features, bool bias) {
+    Value* y = b.Apply(name, "MatMul", {x, b.ScaledWeight(name + ".weight", Shape({in_features, out_features}), in_features)});
+    if (bias) {
+        y = b.Apply(name + ".add", "Add", {y, b.ScaledWeight(name + ".bias", Shape({out_features}), in_features)});
+    }
+    return y;
+}
+
+// [B, S, H * D] -> [B, H, S, D]
+Value* SplitHeads(ZooBuilder& b, const std::string& name, Value* x, int64_t batch, int64_t seq, int64_t heads,
+                  int64_t head_dim) {
+    x = b.Apply(name + ".reshape", "Reshape", {x, b.Dims(name + ".shape", {batch, seq, heads, head_dim})});
+    return b.Apply(name + ".transpose", "Transpose", {x}, {{"perm", Ints({0, 2, 1, 3})}});
+}
+
+// [B, H, S, D] -> [B, S, H * D]
+Value* MergeHeads(ZooBuilder& b, const std::string& name, Value* x, int64_t batch, int64_t seq, int64_t hidden) {
+    x = b.Apply(name + ".transpose", "Transpose", {x}, {{"perm", Ints({0, 2, 1, 3})}});
+    return b.Apply(name + ".reshape", "Reshape", {x, b.Dims(name + ".shape", {batch, seq, hidden})});
+}
+
+Value* LayerNorm(ZooBuilder& b, const std::string& name, Value* x, int64_t hidden) {
+    return b.Apply(name, "LayerNormalization",
+                   {x, b.Fill(name + ".weight", Shape({hidden}), 1.0f), b.Fill(name + ".bias", Shape({hidden}), 0.0f)},
+                   {{"axis", Int(-1)}, {"epsilon", AttributeValue(1e-12f)}});
+}
+
+Value* RMSNorm(ZooBuilder& b, const std::string& name, Value* x, int64_t hidden) {
+    return b.Apply(name, "RMSNorm", {x, b.Fill(name + ".weight", Shape({hidden}), 1.0f)},
+                   {{"epsilon", AttributeValue(1e-6f)}});
+}
+
+Status BuildBertBase(const ZooModelOptions& options, ZooBuilder& b) {
+    const int64_t batch = options.batch_size;
+    const int64_t seq = options.sequence_length > 0 ? options.sequence_length : 128;
+    const int64_t vocab = options.vocab_size > 0 ? options.vocab_size : 30522;
+    const int64_t head_dim = 64;
+    const int64_t heads = ScaleCount(12, options.width);
+    const int64_t hidden = heads * head_dim;
+    const int64_t ffn = 4 * hidden;
+    const int64_t layers = ScaleCount(12, options.depth);
+    
+    // 嵌入按BERT的初始化（标准差0.02）
+    Value* ids = b.IndexInput("input_ids", Shape({batch, seq}), vocab);
+    Value* x = b.Apply("embeddings.word_embeddings", "Gather",
+                       {b.Weight("embeddings.word_embeddings.weight", Shape({vocab, hidden}), 0.035f), ids});
+    x = b.Apply("embeddings.add", "Add",
+                {x, b.Weight("embeddings.position_embeddings.weight", Shape({seq, hidden}), 0.035f)});
+    x = LayerNorm(b, "embeddings.LayerNorm", x, hidden);
+    
+    for (int64_t l = 0; l < layers; ++l) {
+        const std::string name = "encoder.layer." + std::to_string(l);
+        const std::string self = name + ".attention.self";
+        Value* q = SplitHeads(b, self + ".query", Dense(b, self + ".query", x, hidden, hidden, true),
+                              batch, seq, heads, head_dim);
+        Value* k = SplitHeads(b, self + ".key", Dense(b, self + ".key", x, hidden, hidden, true),
+                              batch, seq, heads, head_dim);
+        Value* v = SplitHeads(b, self + ".value", Dense(b, self + ".value", x, hidden, hidden, true),
+                              batch, seq, heads, head_dim);
+        Value* context = MergeHeads(b, self + ".context", b.Apply(self + ".attention", "FusedAttention", {q, k, v}),
+                                    batch, seq, hidden);
+        Value* y = Dense(b, name + ".attention.output.dense", context, hidden, hidden, true);
+        x = LayerNorm(b, name + ".attention.output.LayerNorm", b.Apply(name + ".attention.output.add", "Add", {y, x}),
+                      hidden);
+        y = b.Apply(name + ".intermediate.gelu", "Gelu", {Dense(b, name + ".intermediate.dense", x, hidden, ffn, true)});
+        y = Dense(b, name + ".output.dense", y, ffn, hidden, true);
+        x = LayerNorm(b, name + ".output.LayerNorm", b.Apply(name + ".output.add", "Add", {y, x}), hidden);
+    }
+    b.Output(x, "last_hidden_state");
+    return Status::Ok();
+}
+
+Status BuildQwenDecoder(const ZooModelOptions& options, ZooBuilder& b) {
+    const int64_t batch = options.batch_size;
+    const int64_t seq = options.sequence_length > 0 ? options.sequence_length : 128;
+    const int64_t vocab = options.vocab_size > 0 ? options.vocab_size : 151936;
+    const int64_t head_dim = 64;
+    // 保持Qwen2-0.5B每7个查询头共享一个键值头
+    const int64_t kv_heads = ScaleCount(2, options.width);
+    const int64_t heads = kv_heads * 7;
+    const int64_t hidden = heads * head_dim;
+    const int64_t intermediate = ScaleChannels(4864, options.width, 64);
+    const int64_t layers = ScaleCount(24, options.depth);
+    
+    // RoPE表[S, D/2]，θ_i = 1e6^(-2i/D)（Qwen2的rope_theta）
+    auto cos_table = CreateTensor(Shape({seq, head_dim / 2}), DataType::FLOAT32, DeviceType::CPU);
+    auto sin_table = CreateTensor(Shape({seq, head_dim / 2}), DataType::FLOAT32, DeviceType::CPU);
+    float* cos_data = static_cast<float*>(cos_table->GetData());
+    float* sin_data = static_cast<float*>(sin_table->GetData());
+    for (int64_t p = 0; p < seq; ++p) {
+        for (int64_t i = 0; i < head_dim / 2; ++i) {
+            const double theta = static_cast<double>(p) * std::pow(1e6, -2.0 * static_cast<double>(i) / head_dim);
+            cos_data[p * head_dim / 2 + i] = static_cast<float>(std::cos(theta));
+            sin_data[p * head_dim / 2 + i] = static_cast<float>(std::sin(theta));
+        }
+    }
+    Value* cos = b.Constant("rotary_emb.cos", cos_table);
+    Value* sin = b.Constant("rotary_emb.sin", sin_table);
+    
+    Value* ids = b.IndexInput("input_ids", Shape({batch, seq}), vocab);
+    Value* x = b.Apply("model.embed_tokens", "Gather",
+                       {b.Weight("model.embed_tokens.weight", Shape({vocab, hidden}), 0.035f), ids});
+    for (int64_t l = 0; l < layers; ++l) {
+        const std::string name = "model.layers." + std::to_string(l);
+        const std::string attn = name + ".self_attn";
+        Value* h = RMSNorm(b, name + ".input_layernorm", x, hidden);
+        Value* q = SplitHeads(b, attn + ".q_proj", Dense(b, attn + ".q_proj", h, hidden, heads * head_dim, true),
+                              batch, seq, heads, head_dim);
+        Value* k = SplitHeads(b, attn + ".k_proj", Dense(b, attn + ".k_proj", h, hidden, kv_heads * head_dim, true),
+                              batch, seq, kv_heads, head_dim);
+        Value* v = SplitHeads(b, attn + ".v_proj", Dense(b, attn + ".v_proj", h, hidden, kv_heads * head_dim, true),
+                              batch, seq, kv_heads, head_dim);
+        Value* context = b.Apply(attn + ".attention", "FusedAttention", {q, k, v, cos, sin},
+                                 {{"causal", Int(1)}, {"rotary", Int(1)}});
+        context = MergeHeads(b, attn + ".context", context, batch, seq, hidden);
+        x = b.Apply(attn + ".add", "Add", {x, Dense(b, attn + ".o_proj", context, hidden, hidden, false)});
+    
+        // gate_proj与up_proj合并为SwiGLU的[H, 2I]权重
+        const std::string mlp = name + ".mlp";
+        h = RMSNorm(b, name + ".post_attention_layernorm", x, hidden);
+        h = b.Apply(mlp + ".act", "SwiGLU",
+                    {h, b.ScaledWeight(mlp + ".gate_up_proj.weight", Shape({hidden, 2 * intermediate}), hidden)});
+        x = b.Apply(mlp + ".add", "Add", {x, Dense(b, mlp + ".down_proj", h, intermediate, hidden, false)});
+    }
+    x = RMSNorm(b, "model.norm", x, hidden);
+    b.Output(Dense(b, "lm_head", x, hidden, vocab, false), "logits");
+    return Status::Ok();
+}
+
+// ---------------- 推荐模型 ----------------
+
+Value* Mlp(ZooBuilder& b, const std::string& name, Value* x, int64_t in_features,
+           const std::vector<int64_t>& layers, bool relu_last) {
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const std::string layer = name + "." + std::to_string(i);
+        x = b.Apply(layer, "Gemm",
+                    {x, b.ScaledWeight(layer + ".weight", Shape({in_features, layers[i]}), in_features),
+                     b.ScaledWeight(layer + ".bias", Shape({layers[i]}), in_features)});
+        if (i + 1 < layers.size() || relu_last) {
+            x = b.Apply(layer + ".relu", "Relu", {x});
+        }
+        in_features = layers[i];
+    }
+    return x;
+}
+
+// DLRM（参考MLPerf的dlrm参考实现）：嵌入袋按求和池化，交互为全部特征两两点积（不去除对称的一半）
+Status BuildDlrm(const ZooModelOptions& options, ZooBuilder& b) {
+    const int64_t batch = options.batch_size;
+    const int64_t pooling = options.sequence_length > 0 ? options.sequence_length : 1;
+    const int64_t rows = options.vocab_size > 0 ? options.vocab_size : 100000;
+    const int64_t dim = ScaleChannels(64, options.width);
+    const int64_t tables = ScaleCount(26, options.depth);
+    const int64_t features = tables + 1;
+    
+    Value* dense = b.Input("dense_features", Shape({batch, 13}), 0.0f, 1.0f);
+    Value* bottom = Mlp(b, "bot_l", dense, 13,
+                        {ScaleChannels(512, options.width), ScaleChannels(256, options.width), dim}, true);
+    std::vector<Value*> stacked = {
+        b.Apply("bot_l.reshape", "Reshape", {bottom, b.Dims("bot_l.shape", {batch, 1, dim})})};
+    for (int64_t t = 0; t < tables; ++t) {
+        const std::string name = "emb_l." + std::to_string(t);
+        Value* indices = b.IndexInput("sparse_" + std::to_string(t), Shape({batch, pooling}), rows);
+        Value* table = b.Weight(name + ".weight", Shape({rows, dim}),
+                                1.0f / std::sqrt(static_cast<float>(rows)));
+        Value* pooled = b.Apply(name + ".sum", "ReduceSum", {b.Apply(name, "Gather", {table, indices})},
+                                {{"axes", Ints({1})}, {"keepdims", Int(1)}});
+        stacked.push_back(pooled);
+    }
+    
+    // [B, F, d] x [B, d, F] -> [B, F * F]，与底部MLP的输出拼接后进入顶部MLP
+    Value* t = b.Apply("interact.concat", "Concat", stacked, {{"axis", Int(1)}});
+    Value* z = b.Apply("interact.bmm", "MatMul",
+                       {t, b.Apply("interact.transpose", "Transpose", {t}, {{"perm", Ints({0, 2, 1})}})});
+    z = b.Apply("interact.reshape", "Reshape", {z, b.Dims("interact.shape", {batch, features * features})});
+    Value* r = b.Apply("interact.output", "Concat", {bottom, z}, {{"axis", Int(1)}});
+    Value* top = Mlp(b, "top_l", r, dim + features * features,
+                     {ScaleChannels(512, options.width), ScaleChannels(256, options.width), 1}, false);
+    b.Output(b.Apply("top_l.sigmoid", "Sigmoid", {top}), "probability");
+    return Status::Ok();
+}
+
+struct ZooEntry {
+    ZooModelInfo info;
+    std::function<Status(const ZooModelOptions&, ZooBuilder&)> build;
+};
+
+const std::vector<ZooEntry>& GetZooEntries() {
+    static const std::vector<ZooEntry> entries = {
+        {{"resnet50", "ResNet-50 v1.5 image classifier (25.6M parameters, 4.1 GFLOPs at 224x224)"}, BuildResNet50},
+        {{"mobilenet_v3", "MobileNetV3-Large with squeeze-excite (5.5M parameters, 0.22 GFLOPs)"}, BuildMobileNetV3},
+        {{"bert_base", "BERT-base encoder, 12 layers, hidden 768 (110M parameters)"}, BuildBertBase},
+        {{"qwen_0.5b", "Qwen2-0.5B-shaped decoder prefill, 24 layers, GQA 14/2 heads (494M parameters)"},
+         BuildQwenDecoder},
+        {{"dlrm", "DLRM-style recommender, 26 embedding tables with dot interaction"}, BuildDlrm},
+    };
+    return entries;
+}
+
+} // anonymous namespace
+
+const std::vector<ZooModelInfo>& GetZooModels() {
+    static const std::vector<ZooModelInfo> models = [] {
+        std::vector<ZooModelInfo> infos;
+        for (const auto& entry : GetZooEntries()) {
+            infos.push_back(entry.info);
+        }
+        return infos;
+    }();
+    return models;
+}
+
+Status BuildZooModel(const std::string& name, const ZooModelOptions& options, std::unique_ptr<Graph>* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph output is null");
+    }
+    if (options.batch_size < 1 || options.sequence_length < 0 || options.vocab_size < 0 ||
+        !(options.width > 0.0) || !(options.depth > 0.0)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid model zoo options for " + name);
+    }
+    if (options.image_size != 0 && options.image_size < 32) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model zoo image size must be at least 32");
+    }
+    for (const auto& entry : GetZooEntries()) {
+        if (entry.info.name != name) {
+            continue;
+        }
+        ZooBuilder builder(options.seed);
+        Status status = entry.build(options, builder);
+        if (!status.IsOk()) {
+            return status;
+        }
+        *graph = builder.Release();
+        return Status::Ok();
+    }
+    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown model zoo model: " + name);
+}
+
+Status ParseZooModelSpec(const std::string& spec, std::string* name, ZooModelOptions* options) {
+    const size_t colon = spec.find(':');
+    *name = spec.substr(0, colon);
+    if (name->empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model zoo spec has no model name: " + spec);
+    }
+    if (colon == std::string::npos) {
+        return Status::Ok();
+    }
+    size_t begin = colon + 1;
+    while (begin <= spec.size()) {
+        size_t end = spec.find(',', begin);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        const std::string item = spec.substr(begin, end - begin);
+        const size_t equals = item.find('=');
+        if (equals == std::string::npos || equals + 1 >= item.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid model zoo option '" + item + "'");
+        }
+        const std::string key = item.substr(0, equals);
+        const std::string text = item.substr(equals + 1);
+        char* parsed_end = nullptr;
+        const double value = std::strtod(text.c_str(), &parsed_end);
+        if (*parsed_end != '\0') {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid value for model zoo option '" + key + "'");
+        }
+        if (key == "batch") options->batch_size = static_cast<int64_t>(value);
+        else if (key == "seq") options->sequence_length = static_cast<int64_t>(value);
+        else if (key == "image") options->image_size = static_cast<int64_t>(value);
+        else if (key == "width") options->width = value;
+        else if (key == "depth") options->depth = value;
+        else if (key == "vocab") options->vocab_size = static_cast<int64_t>(value);
+        else if (key == "seed") options->seed = static_cast<uint64_t>(value);
+        else {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unknown model zoo option '" + key + "'");
+        }
+        begin = end + 1;
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,357 @@
+// NUMA拓扑、混合架构的核类型与节点亲和性实现
+// Linux上从sysfs读取节点的cpulist与各核的类型、算力，线程亲和性用pthread_setaffinity_np，
+// 内存策略直接调用mbind系统调用（不依赖libnuma）；其他平台视为单节点、同构核
+
+#include "inferunity/numa.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+namespace {
+
+thread_local int tls_numa_node = -1;
+
+#if defined(__linux__)
+// <numaif.h>中的常量，避免依赖libnuma的头文件
+constexpr int kMpolPreferred = 1;
+constexpr unsigned kMpolMfMove = 1u << 1;
+
+// "0-3,8-11"形式的CPU/节点列表
+std::vector<int> ParseIdList(const std::string& text) {
+    std::vector<int> ids;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; ++id) {
+                ids.push_back(id);
+            }
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return ids;
+}
+
+std::string ReadFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+std::vector<int> CpusOf(const cpu_set_t& set) {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool SetThreadCpus(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#endif
+
+NumaTopology DetectTopology() {
+    NumaTopology topology;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    const std::vector<int> node_ids = ParseIdList(ReadFirstLine("/sys/devices/system/node/online"));
+    for (int id : node_ids) {
+        NumaNode node;
+        node.id = id;
+        const std::string path = "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+        for (int cpu : ParseIdList(ReadFirstLine(path))) {
+            if (!have_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        // 只有内存没有CPU的节点（或不在亲和性掩码内）不参与分组
+        if (!node.cpus.empty()) {
+            topology.nodes.push_back(std::move(node));
+        }
+    }
+    if (topology.nodes.empty()) {
+        NumaNode node;
+        node.cpus = have_mask ? CpusOf(allowed) : std::vector<int>();
+        topology.nodes.push_back(std::move(node));
+    }
+#else
+    topology.nodes.emplace_back();
+#endif
+    if (topology.nodes.size() == 1 && topology.nodes[0].cpus.empty()) {
+        const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < cpus; ++cpu) {
+            topology.nodes[0].cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return topology;
+}
+
+#if defined(__linux__)
+// sysfs中的整数，不存在或无法解析时返回0
+int64_t ReadSysfsInt(const std::string& path) {
+    try {
+        return std::stoll(ReadFirstLine(path));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+// 把调用线程依次固定到每个核上执行CPUID 1AH，结束后恢复原来的亲和性；有核读不到类型时返回false
+bool ProbeHybridCoreTypes(std::vector<CpuCore>* cores) {
+    cpu_set_t previous;
+    CPU_ZERO(&previous);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) {
+        return false;
+    }
+    constexpr int kAtomCoreType = 0x20;
+    constexpr int kPerformanceCoreType = 0x40;
+    bool complete = true;
+    for (CpuCore& core : *cores) {
+        const int type = SetThreadCpus({core.cpu}) ? GetCurrentHybridCoreType() : 0;
+        if (type != kAtomCoreType && type != kPerformanceCoreType) {
+            complete = false;
+            break;
+        }
+        core.type = type == kAtomCoreType ? CoreType::EFFICIENCY : CoreType::PERFORMANCE;
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+    return complete;
+}
+#endif
+
+CpuCoreTopology DetectCoreTopology() {
+    CpuCoreTopology topology;
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        cpus = CpusOf(allowed);
+    }
+#endif
+    if (cpus.empty()) {
+        const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    for (int cpu : cpus) {
+        CpuCore core;
+        core.cpu = cpu;
+        topology.cores.push_back(core);
+    }
+#if defined(__linux__)
+    // 类型：Intel混合架构的内核为P核与E核各注册一个PMU，其cpus列出对应的CPU
+    const std::vector<int> atom_cpus = ParseIdList(ReadFirstLine("/sys/devices/cpu_atom/cpus"));
+    const std::vector<int> core_cpus = ParseIdList(ReadFirstLine("/sys/devices/cpu_core/cpus"));
+    bool typed = false;
+    if (!atom_cpus.empty() && !core_cpus.empty()) {
+        for (CpuCore& core : topology.cores) {
+            if (std::find(atom_cpus.begin(), atom_cpus.end(), core.cpu) != atom_cpus.end()) {
+                core.type = CoreType::EFFICIENCY;
+            }
+        }
+        typed = true;
+    } else if (GetCpuFeatures().hybrid) {
+        typed = ProbeHybridCoreTypes(&topology.cores);
+    }
+    
+    // 算力：优先调度器使用的cpu_capacity，其次最高频率；只有全部核都读到时才采用
+    std::vector<int64_t> capacity(topology.cores.size(), 0);
+    for (const char* file : {"cpu_capacity", "cpufreq/cpuinfo_max_freq"}) {
+        bool complete = true;
+        for (size_t i = 0; i < topology.cores.size() && complete; ++i) {
+            capacity[i] = ReadSysfsInt("/sys/devices/system/cpu/cpu" +
+                                       std::to_string(topology.cores[i].cpu) + "/" + file);
+            complete = capacity[i] > 0;
+        }
+        if (complete) {
+            break;
+        }
+        std::fill(capacity.begin(), capacity.end(), 0);
+    }
+    const int64_t max_capacity = capacity.empty() ? 0 : *std::max_element(capacity.begin(), capacity.end());
+    for (size_t i = 0; i < topology.cores.size(); ++i) {
+        CpuCore& core = topology.cores[i];
+        if (max_capacity > 0) {
+            core.capacity = static_cast<int>(std::max<int64_t>(1, capacity[i] * 1024 / max_capacity));
+        } else if (typed && core.type == CoreType::EFFICIENCY) {
+            core.capacity = 512;
+        }
+        if (!typed && core.capacity * 2 < 1024) {
+            core.type = CoreType::EFFICIENCY;
+        }
+    }
+#endif
+    for (const CpuCore& core : topology.cores) {
+        topology.hybrid = topology.hybrid || core.type == CoreType::EFFICIENCY;
+    }
+    return topology;
+}
+
+} // anonymous namespace
+
+std::vector<int> CpuCoreTopology::PerformanceCpus() const {
+    std::vector<int> cpus;
+    for (const CpuCore& core : cores) {
+        if (core.type == CoreType::PERFORMANCE) {
+            cpus.push_back(core.cpu);
+        }
+    }
+    return cpus;
+}
+
+int CpuCoreTopology::CapacityOf(int cpu) const {
+    for (const CpuCore& core : cores) {
+        if (core.cpu == cpu) {
+            return core.capacity;
+        }
+    }
+    return 1024;
+}
+
+const CpuCoreTopology& GetCpuCoreTopology() {
+    static const CpuCoreTopology topology = []() {
+        CpuCoreTopology detected = DetectCoreTopology();
+        if (detected.hybrid) {
+            LOG_INFO("Hybrid CPU: " + std::to_string(detected.PerformanceCpus().size()) + " performance of " +
+                     std::to_string(detected.cores.size()) + " cores");
+        }
+        return detected;
+    }();
+    return topology;
+}
+
+const NumaTopology& GetNumaTopology() {
+    static const NumaTopology topology = []() {
+        NumaTopology detected = DetectTopology();
+        if (detected.nodes.size() > 1) {
+            LOG_INFO("NUMA topology: " + std::to_string(detected.nodes.size()) + " nodes");
+        }
+        return detected;
+    }();
+    return topology;
+}
+
+size_t GetNumNumaNodes() {
+    return GetNumaTopology().nodes.size();
+}
+
+int GetCurrentNumaNode() {
+    return tls_numa_node;
+}
+
+void SetCurrentNumaNode(int node) {
+    tls_numa_node = node >= 0 && static_cast<size_t>(node) < GetNumNumaNodes() ? node : -1;
+}
+
+Status BindCurrentThreadToNumaNode(int node) {
+    const NumaTopology& topology = GetNumaTopology();
+    if (node < 0 || static_cast<size_t>(node) >= topology.nodes.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "NUMA node out of range: " + std::to_string(node));
+    }
+#if defined(__linux__)
+    if (!SetThreadCpus(topology.nodes[node].cpus)) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                           "Failed to bind thread to NUMA node " + std::to_string(node));
+    }
+#endif
+    return Status::Ok();
+}
+
+bool BindMemoryToNumaNode(void* data, size_t size, int node, bool migrate) {
+    const NumaTopology& topology = GetNumaTopology();
+    if (!data || size == 0 || topology.nodes.size() <= 1 || node < 0 ||
+        static_cast<size_t>(node) >= topology.nodes.size()) {
+        return false;
+    }
+#if defined(__linux__) && defined(SYS_mbind)
+    // mbind要求起始地址按页对齐，只设置完整落在范围内的页
+    const uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page - 1) & ~(page - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(page - 1);
+    if (end <= begin) {
+        return false;
+    }
+    const int id = topology.nodes[node].id;
+    const size_t bits = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(static_cast<size_t>(id) / bits + 1, 0);
+    mask[id / bits] |= 1ul << (id % bits);
+    const long result = ::syscall(SYS_mbind, begin, end - begin, kMpolPreferred, mask.data(),
+                                  mask.size() * bits + 1, migrate ? kMpolMfMove : 0u);
+    return result == 0;
+#else
+    (void)migrate;
+    return false;
+#endif
+}
+
+NumaNodeScope::NumaNodeScope(int node, bool bind_thread) {
+    previous_node_ = tls_numa_node;
+    if (node < 0 || node == previous_node_ || static_cast<size_t>(node) >= GetNumNumaNodes()) {
+        return;
+    }
+    active_ = true;
+    tls_numa_node = node;
+#if defined(__linux__)
+    if (bind_thread && GetNumNumaNodes() > 1) {
+        cpu_set_t current;
+        CPU_ZERO(&current);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(current), &current) == 0 &&
+            BindCurrentThreadToNumaNode(node).IsOk()) {
+            previous_cpus_ = CpusOf(current);
+        }
+    }
+#else
+    (void)bind_thread;
+#endif
+}
+
+NumaNodeScope::~NumaNodeScope() {
+    if (!active_) {
+        return;
+    }
+    tls_numa_node = previous_node_;
+#if defined(__linux__)
+    if (!previous_cpus_.empty()) {
+        SetThreadCpus(previous_cpus_);
+    }
+#endif
+}
+
+} // namespace inferunity
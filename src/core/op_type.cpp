@@ -0,0 +1,62 @@
+#include "inferunity/op_type.h"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+// 名字存放在deque中，追加时已有元素的地址不变，GetOpTypeName返回的引用一直有效
+struct OpTypeTable {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, OpTypeId> ids;
+    std::deque<std::string> names;
+};
+
+OpTypeTable& Table() {
+    static OpTypeTable table;
+    return table;
+}
+
+} // anonymous namespace
+
+OpTypeId InternOpType(const std::string& op_type) {
+    OpTypeTable& table = Table();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(op_type);
+        if (it != table.ids.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto inserted = table.ids.emplace(op_type, static_cast<OpTypeId>(table.names.size()));
+    if (inserted.second) {
+        table.names.push_back(op_type);
+    }
+    return inserted.first->second;
+}
+
+OpTypeId FindOpType(const std::string& op_type) {
+    OpTypeTable& table = Table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(op_type);
+    return it != table.ids.end() ? it->second : kInvalidOpTypeId;
+}
+
+const std::string& GetOpTypeName(OpTypeId id) {
+    static const std::string empty;
+    OpTypeTable& table = Table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return id < table.names.size() ? table.names[id] : empty;
+}
+
+size_t GetOpTypeCount() {
+    OpTypeTable& table = Table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names.size();
+}
+
+} // namespace inferunity
@@ -0,0 +1,141 @@
+// 节点属性 -> 算子属性
+// 节点上的属性是类型化的AttributeValue，编译内核、常量折叠等实例化算子时直接复制；
+// 文本形式只在Node::SetAttribute(key, string)与ToString()处转换
+
+#include "inferunity/operator.h"
+#include "inferunity/graph.h"
+#include <iomanip>
+#include <sstream>
+
+namespace inferunity {
+
+namespace {
+
+bool ParseInt(const std::string& text, int64_t* value) {
+    try {
+        size_t pos = 0;
+        *value = std::stoll(text, &pos);
+        return pos == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ParseFloat(const std::string& text, float* value) {
+    try {
+        size_t pos = 0;
+        *value = std::stof(text, &pos);
+        return pos == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+std::string FormatFloat(float value) {
+    std::ostringstream ss;
+    ss << std::setprecision(9) << value;
+    std::string text = ss.str();
+    // 整数值的文本会被解析为INT，补上小数点
+    if (text.find_first_of(".eEn") == std::string::npos) {
+        text += ".0";
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+std::string AttributeValue::ToString() const {
+    std::string text;
+    switch (type_) {
+        case Type::FLOAT:
+            return FormatFloat(float_val_);
+        case Type::INT:
+            return std::to_string(int_val_);
+        case Type::STRING:
+            return string_val_;
+        case Type::FLOATS:
+            for (float v : floats_val_) {
+                if (!text.empty()) text += ",";
+                text += FormatFloat(v);
+            }
+            return text;
+        case Type::INTS:
+            for (int64_t v : ints_val_) {
+                if (!text.empty()) text += ",";
+                text += std::to_string(v);
+            }
+            return text;
+        case Type::TENSOR:
+        case Type::GRAPH:
+        default:
+            return text;
+    }
+}
+
+bool AttributeValue::operator==(const AttributeValue& other) const {
+    if (type_ != other.type_) {
+        return false;
+    }
+    switch (type_) {
+        case Type::FLOAT: return float_val_ == other.float_val_;
+        case Type::INT: return int_val_ == other.int_val_;
+        case Type::STRING: return string_val_ == other.string_val_;
+        case Type::FLOATS: return floats_val_ == other.floats_val_;
+        case Type::INTS: return ints_val_ == other.ints_val_;
+        case Type::TENSOR: return tensor_val_ == other.tensor_val_;
+        case Type::GRAPH: return graph_val_ == other.graph_val_;
+        default: return false;
+    }
+}
+
+AttributeValue ParseNodeAttribute(const std::string& value) {
+    if (value.find(',') == std::string::npos) {
+        int64_t int_val = 0;
+        if (ParseInt(value, &int_val)) {
+            return AttributeValue(int_val);
+        }
+        float float_val = 0.0f;
+        if (ParseFloat(value, &float_val)) {
+            return AttributeValue(float_val);
+        }
+        return AttributeValue(value);
+    }
+    
+    std::vector<std::string> tokens;
+    size_t start = 0;
+    while (true) {
+        size_t end = value.find(',', start);
+        tokens.push_back(value.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    
+    std::vector<int64_t> ints;
+    for (const auto& token : tokens) {
+        int64_t v = 0;
+        if (!ParseInt(token, &v)) break;
+        ints.push_back(v);
+    }
+    if (ints.size() == tokens.size()) {
+        return AttributeValue(ints);
+    }
+    
+    std::vector<float> floats;
+    for (const auto& token : tokens) {
+        float v = 0.0f;
+        if (!ParseFloat(token, &v)) break;
+        floats.push_back(v);
+    }
+    if (floats.size() == tokens.size()) {
+        return AttributeValue(floats);
+    }
+    return AttributeValue(value);
+}
+
+void ApplyNodeAttributes(const Node& node, Operator* op) {
+    for (const auto& attr : node.GetAttributes()) {
+        op->SetAttribute(attr.first, attr.second);
+    }
+}
+
+} // namespace inferunity
@@ -0,0 +1,97 @@
+// 算子解析代价实现
+// 参考PyTorch的FlopCounterMode与fvcore的逐算子FLOP计数：乘加计2次运算，逐元素算子按每个元素的运算数计，
+// 字节数为张量描述的大小（读全部输入、写全部输出），与缓存是否命中无关
+
+#include "inferunity/operator.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+int64_t InfoElements(const TensorInfo& info) {
+    return std::max<int64_t>(info.shape.GetElementCount(), 0);
+}
+
+size_t SumBytes(const std::vector<TensorInfo>& infos) {
+    size_t bytes = 0;
+    for (const TensorInfo& info : infos) {
+        bytes += GetTensorInfoBytes(info);
+    }
+    return bytes;
+}
+
+int64_t OutputElements(const std::vector<TensorInfo>& outputs) {
+    int64_t elements = 0;
+    for (const TensorInfo& info : outputs) {
+        elements += InfoElements(info);
+    }
+    return elements;
+}
+
+} // anonymous namespace
+
+size_t GetTensorInfoBytes(const TensorInfo& info) {
+    return static_cast<size_t>(InfoElements(info)) * GetDataTypeSize(info.dtype);
+}
+
+double GetElementwiseFlops(const std::string& op_type) {
+    // 超越函数按SIMD多项式近似（见simd_utils）的乘加数粗略计
+    static const std::unordered_map<std::string, double> table = {
+        {"Add", 1}, {"Sub", 1}, {"Mul", 1}, {"Div", 1}, {"Max", 1}, {"Min", 1}, {"Where", 1},
+        {"Relu", 1}, {"Sqrt", 1}, {"Exp", 8}, {"Log", 8}, {"Pow", 16},
+        {"Sigmoid", 10}, {"Tanh", 10}, {"Silu", 11}, {"Gelu", 14}, {"GeluTanh", 14},
+        {"Softmax", 12}, {"LogSoftmax", 12},
+        {"ReduceSum", 1}, {"ReduceMean", 1}, {"ReduceMax", 1}, {"ReduceMin", 1},
+        {"ReduceSumSquare", 2}, {"ReduceL2", 2},
+        {"QuantizeLinear", 3}, {"DequantizeLinear", 2},
+        {"Reshape", 0}, {"Flatten", 0}, {"Squeeze", 0}, {"Unsqueeze", 0}, {"Transpose", 0},
+        {"Concat", 0}, {"Split", 0}, {"Slice", 0}, {"Gather", 0}, {"Embedding", 0}, {"Cast", 0},
+        {"Shape", 0}, {"Identity", 0}, {"MemcpyToDevice", 0}, {"MemcpyFromDevice", 0},
+        {"ReorderInput", 0}, {"ReorderOutput", 0},
+    };
+    auto it = table.find(op_type);
+    return it != table.end() ? it->second : 1.0;
+}
+
+OperatorCost EstimateElementwiseCost(const std::vector<TensorInfo>& inputs,
+                                     const std::vector<TensorInfo>& outputs, double flops_per_element) {
+    // 归约等输出少于输入的算子按输入元素数计
+    const int64_t elements = std::max(OutputElements(outputs), inputs.empty() ? 0 : InfoElements(inputs[0]));
+    OperatorCost cost;
+    cost.flops = flops_per_element * static_cast<double>(elements);
+    cost.bytes_read = SumBytes(inputs);
+    cost.bytes_written = SumBytes(outputs);
+    return cost;
+}
+
+OperatorCost EstimateMatMulCost(const std::vector<TensorInfo>& inputs, const std::vector<TensorInfo>& outputs,
+                                int64_t k, double epilogue_flops) {
+    const double elements = static_cast<double>(OutputElements(outputs));
+    OperatorCost cost;
+    cost.flops = elements * (2.0 * static_cast<double>(std::max<int64_t>(k, 1)) + epilogue_flops);
+    cost.bytes_read = SumBytes(inputs);
+    cost.bytes_written = SumBytes(outputs);
+    return cost;
+}
+
+OperatorCost EstimateConvCost(const std::vector<TensorInfo>& inputs, const std::vector<TensorInfo>& outputs,
+                              size_t weight_index, double epilogue_flops) {
+    int64_t macs_per_output = 1;
+    if (weight_index < inputs.size()) {
+        const auto& dims = inputs[weight_index].shape.dims;
+        const int64_t weight_elements = InfoElements(inputs[weight_index]);
+        if (!dims.empty() && dims[0] > 0 && weight_elements > 0) {
+            macs_per_output = std::max<int64_t>(weight_elements / dims[0], 1);
+        }
+    }
+    return EstimateMatMulCost(inputs, outputs, macs_per_output, epilogue_flops);
+}
+
+OperatorCost Operator::EstimateCost(const std::vector<TensorInfo>& inputs,
+                                    const std::vector<TensorInfo>& outputs) const {
+    return EstimateElementwiseCost(inputs, outputs, GetElementwiseFlops(GetName()));
+}
+
+} // namespace inferunity
@@ -0,0 +1,98 @@
+// 输出缓冲回收池实现
+// 交出的句柄是一个别名shared_ptr：删除器持有真正的张量，最后一个句柄释放时把它放回空闲表
+
+#include "inferunity/output_pool.h"
+#include <algorithm>
+
+namespace inferunity {
+
+OutputBufferPool::OutputBufferPool(size_t num_outputs, size_t max_free_per_output)
+    : max_free_per_output_(max_free_per_output), free_(num_outputs) {}
+
+std::shared_ptr<Tensor> OutputBufferPool::Acquire(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= free_.size() || free_[index].empty()) {
+        return nullptr;
+    }
+    std::shared_ptr<Tensor> tensor = std::move(free_[index].back());
+    free_[index].pop_back();
+    return tensor;
+}
+
+std::shared_ptr<Tensor> OutputBufferPool::Acquire(size_t index, const Shape& shape, DataType dtype,
+                                                  DeviceType device) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index < free_.size()) {
+            std::vector<std::shared_ptr<Tensor>>& buffers = free_[index];
+            for (size_t i = buffers.size(); i-- > 0;) {
+                const Tensor& candidate = *buffers[i];
+                if (candidate.GetShape().dims == shape.dims && candidate.GetDataType() == dtype &&
+                    candidate.GetDeviceType() == device) {
+                    std::shared_ptr<Tensor> tensor = std::move(buffers[i]);
+                    buffers.erase(buffers.begin() + static_cast<std::ptrdiff_t>(i));
+                    ++stats_.reused;
+                    return tensor;
+                }
+            }
+        }
+        ++stats_.allocated;
+    }
+    return CreateTensor(shape, dtype, device);
+}
+
+void OutputBufferPool::Release(size_t index, std::shared_ptr<Tensor> tensor) {
+    if (!tensor) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index < free_.size() && free_[index].size() < max_free_per_output_) {
+        free_[index].push_back(std::move(tensor));
+    }
+}
+
+void OutputBufferPool::RecordUse(bool reused) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reused) {
+        ++stats_.reused;
+    } else {
+        ++stats_.allocated;
+    }
+}
+
+std::shared_ptr<Tensor> OutputBufferPool::Hand(size_t index, std::shared_ptr<Tensor> tensor) {
+    if (!tensor) {
+        return nullptr;
+    }
+    Tensor* raw = tensor.get();
+    std::weak_ptr<OutputBufferPool> pool = weak_from_this();
+    return std::shared_ptr<Tensor>(raw, [pool, index, owner = std::move(tensor)](Tensor*) mutable {
+        if (auto alive = pool.lock()) {
+            alive->Return(index, std::move(owner));
+        }
+    });
+}
+
+void OutputBufferPool::Return(size_t index, std::shared_ptr<Tensor> tensor) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= free_.size() || free_[index].size() >= max_free_per_output_) {
+        ++stats_.dropped;
+        return;
+    }
+    free_[index].push_back(std::move(tensor));
+    ++stats_.returned;
+}
+
+OutputBufferPoolStats OutputBufferPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OutputBufferPoolStats stats = stats_;
+    for (const auto& buffers : free_) {
+        stats.free_buffers += buffers.size();
+        for (const auto& tensor : buffers) {
+            stats.free_bytes += tensor->GetSizeInBytes();
+        }
+    }
+    return stats;
+}
+
+} // namespace inferunity
@@ -0,0 +1,593 @@
+// 分页KV cache实现
+// 参考vLLM的BlockAllocator/BlockSpaceManager：物理块由引用计数管理，引用归零的块放回空闲列表复用，
+// 登记了前缀哈希的块则进入LRU可回收列表，直到空闲块与新分配都不够时才被回收；析构时统一归还内存池。
+// 换入换出的拷贝在一个辅助线程上按提交顺序执行，同一交换区块上先后的拷贝因此不会乱序
+
+#include "inferunity/kv_cache.h"
+#include "inferunity/float16.h"
+#include "inferunity/memory.h"
+#include "core/align_utils.h"
+#include "core/hash_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace inferunity {
+
+namespace {
+
+// 块内各段的起点按缓存行对齐
+constexpr size_t kBlockAlignment = 64;
+
+int64_t BlocksFor(int64_t length, int64_t block_size) {
+    return (length + block_size - 1) / block_size;
+}
+
+size_t StorageElementSize(KVCacheStorage storage) {
+    return storage == KVCacheStorage::FLOAT32 ? sizeof(float) : 1;
+}
+
+// FP8 E4M3的256个编码对应的FP32值，反量化时查表
+struct Fp8Table {
+    float values[256];
+    Fp8Table() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = Fp8E4M3ToFloat(static_cast<uint8_t>(i));
+        }
+    }
+};
+
+// 块的链式哈希（64位FNV-1a，依次混入父块哈希与本块token）：前缀不同的相同token块得到不同的哈希
+uint64_t HashBlock(uint64_t parent, const int32_t* tokens, int64_t count) {
+    const uint64_t hash = HashBytes(kFnv1aOffsetBasis, &parent, sizeof(parent));
+    return HashBytes(hash, tokens, static_cast<size_t>(count) * sizeof(int32_t));
+}
+
+} // anonymous namespace
+
+void QuantizeKVRow(KVCacheStorage storage, const float* src, int64_t dim, uint8_t* dst, float* scale) {
+    if (storage == KVCacheStorage::FLOAT32) {
+        std::memcpy(dst, src, static_cast<size_t>(dim) * sizeof(float));
+        return;
+    }
+    float max_abs = 0.0f;
+    for (int64_t i = 0; i < dim; ++i) {
+        max_abs = std::max(max_abs, std::fabs(src[i]));
+    }
+    const float range = storage == KVCacheStorage::INT8 ? 127.0f : kFp8E4M3Max;
+    const float s = max_abs > 0.0f ? max_abs / range : 1.0f;
+    const float inv = 1.0f / s;
+    *scale = s;
+    if (storage == KVCacheStorage::INT8) {
+        for (int64_t i = 0; i < dim; ++i) {
+            const float q = std::min(std::max(std::nearbyint(src[i] * inv), -127.0f), 127.0f);
+            dst[i] = static_cast<uint8_t>(static_cast<int8_t>(q));
+        }
+    } else {
+        for (int64_t i = 0; i < dim; ++i) {
+            dst[i] = FloatToFp8E4M3(src[i] * inv);
+        }
+    }
+}
+
+void DequantizeKVRows(KVCacheStorage storage, const uint8_t* src, const float* scales, int64_t rows,
+                      int64_t dim, float* dst) {
+    if (storage == KVCacheStorage::FLOAT32) {
+        std::memcpy(dst, src, static_cast<size_t>(rows * dim) * sizeof(float));
+        return;
+    }
+    static const Fp8Table fp8;
+    for (int64_t r = 0; r < rows; ++r) {
+        const uint8_t* q = src + r * dim;
+        float* out = dst + r * dim;
+        const float s = scales[r];
+        if (storage == KVCacheStorage::INT8) {
+            const int8_t* values = reinterpret_cast<const int8_t*>(q);
+            for (int64_t i = 0; i < dim; ++i) {
+                out[i] = static_cast<float>(values[i]) * s;
+            }
+        } else {
+            for (int64_t i = 0; i < dim; ++i) {
+                out[i] = fp8.values[q[i]] * s;
+            }
+        }
+    }
+}
+
+// 换入换出的拷贝流：每次提交一批整块拷贝，辅助线程依次执行；Synchronize等待已提交的全部完成
+class PagedKVCache::SwapStream {
+public:
+    explicit SwapStream(size_t block_bytes) : block_bytes_(block_bytes), thread_([this] { Loop(); }) {}
+    
+    ~SwapStream() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+    
+    // 每个元素为(目标, 源)
+    void Enqueue(std::vector<std::pair<uint8_t*, const uint8_t*>> copies) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(copies));
+        ++submitted_;
+        cv_.notify_all();
+    }
+    
+    void Synchronize() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return completed_ == submitted_; });
+    }
+
+private:
+    void Loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            std::vector<std::pair<uint8_t*, const uint8_t*>> copies = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            for (const auto& copy : copies) {
+                std::memcpy(copy.first, copy.second, block_bytes_);
+            }
+            lock.lock();
+            ++completed_;
+            done_cv_.notify_all();
+        }
+    }
+    
+    size_t block_bytes_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    std::deque<std::vector<std::pair<uint8_t*, const uint8_t*>>> queue_;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+PagedKVCache::PagedKVCache(const PagedKVCacheOptions& options) : options_(options) {}
+
+PagedKVCache::~PagedKVCache() {
+    // 先等拷贝流退出，它可能还在读写块
+    swap_stream_.reset();
+    for (Block& block : blocks_) {
+        FreeMemory(block.data);
+    }
+    for (uint8_t* data : swap_blocks_) {
+        FreeMemory(data);
+    }
+}
+
+Status PagedKVCache::AddLayer(int64_t kv_heads, int64_t key_dim, int64_t value_dim, size_t* layer) {
+    if (!blocks_.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Layers must be added before any KV block is allocated");
+    }
+    if (kv_heads <= 0 || key_dim <= 0 || value_dim <= 0 || options_.block_size <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid paged KV cache dimensions");
+    }
+    LayerLayout layout;
+    layout.kv_heads = kv_heads;
+    layout.key_dim = key_dim;
+    layout.value_dim = value_dim;
+    const size_t element = StorageElementSize(options_.storage);
+    const size_t positions = static_cast<size_t>(kv_heads * options_.block_size);
+    layout.key_offset = block_bytes_;
+    block_bytes_ = AlignUp(block_bytes_ + positions * static_cast<size_t>(key_dim) * element, kBlockAlignment);
+    layout.value_offset = block_bytes_;
+    block_bytes_ = AlignUp(block_bytes_ + positions * static_cast<size_t>(value_dim) * element, kBlockAlignment);
+    if (options_.storage != KVCacheStorage::FLOAT32) {
+        layout.key_scale_offset = block_bytes_;
+        block_bytes_ = AlignUp(block_bytes_ + positions * sizeof(float), kBlockAlignment);
+        layout.value_scale_offset = block_bytes_;
+        block_bytes_ = AlignUp(block_bytes_ + positions * sizeof(float), kBlockAlignment);
+    }
+    if (layer) {
+        *layer = layers_.size();
+    }
+    layers_.push_back(layout);
+    return Status::Ok();
+}
+
+Status PagedKVCache::AddSequence(int64_t seq) {
+    if (!sequences_.emplace(seq, Sequence()).second) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Sequence already exists: " + std::to_string(seq));
+    }
+    return Status::Ok();
+}
+
+Status PagedKVCache::AddSequence(int64_t seq, const std::vector<int32_t>& tokens, int64_t* cached_tokens) {
+    Status status = AddSequence(seq);
+    if (!status.IsOk()) {
+        return status;
+    }
+    int64_t cached = 0;
+    if (options_.enable_prefix_caching && !tokens.empty()) {
+        Sequence& sequence = sequences_[seq];
+        const int64_t block_size = options_.block_size;
+        const int64_t max_blocks = (static_cast<int64_t>(tokens.size()) - 1) / block_size;
+        uint64_t parent = 0;
+        for (int64_t i = 0; i < max_blocks; ++i) {
+            const int32_t* block_tokens = tokens.data() + i * block_size;
+            const uint64_t hash = HashBlock(parent, block_tokens, block_size);
+            auto it = cached_blocks_.find(hash);
+            if (it == cached_blocks_.end()) {
+                break;
+            }
+            Block& block = blocks_[it->second];
+            if (block.parent_hash != parent ||
+                !std::equal(block.tokens.begin(), block.tokens.end(), block_tokens)) {
+                break;
+            }
+            if (block.ref_count++ == 0) {
+                evictable_.erase(block.lru);
+            }
+            sequence.block_table.push_back(it->second);
+            sequence.block_hashes.push_back(hash);
+            parent = hash;
+        }
+        cached = static_cast<int64_t>(sequence.block_table.size()) * block_size;
+        sequence.length = cached;
+        ++prefix_stats_.num_queries;
+        prefix_stats_.num_hits += cached > 0 ? 1 : 0;
+        prefix_stats_.queried_tokens += tokens.size();
+        prefix_stats_.cached_tokens += static_cast<uint64_t>(cached);
+    }
+    if (cached_tokens) {
+        *cached_tokens = cached;
+    }
+    return Status::Ok();
+}
+
+Status PagedKVCache::CachePrefix(int64_t seq, const std::vector<int32_t>& tokens, int64_t computed) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end() || it->second.swapped || computed < 0 || computed > it->second.length) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Invalid prefix of sequence " + std::to_string(seq));
+    }
+    if (!options_.enable_prefix_caching) {
+        return Status::Ok();
+    }
+    Sequence& sequence = it->second;
+    const int64_t block_size = options_.block_size;
+    const int64_t full = std::min<int64_t>(computed, static_cast<int64_t>(tokens.size())) / block_size;
+    for (int64_t i = static_cast<int64_t>(sequence.block_hashes.size()); i < full; ++i) {
+        const uint64_t parent = i > 0 ? sequence.block_hashes[i - 1] : 0;
+        const int32_t* block_tokens = tokens.data() + i * block_size;
+        const uint64_t hash = HashBlock(parent, block_tokens, block_size);
+        Block& block = blocks_[sequence.block_table[i]];
+        // 同样的内容已由其他块登记（并发prefill了相同前缀）时保留已有的那个
+        if (!block.cached && !cached_blocks_.count(hash)) {
+            block.cached = true;
+            block.hash = hash;
+            block.parent_hash = parent;
+            block.tokens.assign(block_tokens, block_tokens + block_size);
+            cached_blocks_.emplace(hash, sequence.block_table[i]);
+        }
+        sequence.block_hashes.push_back(hash);
+    }
+    return Status::Ok();
+}
+
+Status PagedKVCache::RemoveSequence(int64_t seq) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Unknown sequence: " + std::to_string(seq));
+    }
+    for (int32_t block : it->second.block_table) {
+        ReleaseBlock(block);
+    }
+    // 交换区块上仍在进行的拷贝排在之后复用它的拷贝之前，可以直接放回
+    free_swap_blocks_.insert(free_swap_blocks_.end(), it->second.swap_table.begin(), it->second.swap_table.end());
+    sequences_.erase(it);
+    return Status::Ok();
+}
+
+int64_t PagedKVCache::GetSequenceLength(int64_t seq) const {
+    auto it = sequences_.find(seq);
+    return it == sequences_.end() ? 0 : it->second.length;
+}
+
+const std::vector<int32_t>& PagedKVCache::GetBlockTable(int64_t seq) const {
+    static const std::vector<int32_t> empty;
+    auto it = sequences_.find(seq);
+    return it == sequences_.end() ? empty : it->second.block_table;
+}
+
+Status PagedKVCache::AppendSlots(int64_t seq, int64_t tokens) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end() || it->second.swapped || tokens < 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Unknown or swapped-out sequence: " + std::to_string(seq));
+    }
+    if (layers_.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Paged KV cache has no layers");
+    }
+    Sequence& sequence = it->second;
+    const int64_t block_size = options_.block_size;
+    const int64_t new_length = sequence.length + tokens;
+    
+    // 末块未满且被共享（或登记在前缀缓存中，如Trim之后）时，写入前需要复制一份
+    const bool copy_last = tokens > 0 && sequence.length % block_size != 0 &&
+                           (blocks_[sequence.block_table.back()].ref_count > 1 ||
+                            blocks_[sequence.block_table.back()].cached);
+    const size_t needed = static_cast<size_t>(BlocksFor(new_length, block_size)) -
+                          sequence.block_table.size() + (copy_last ? 1 : 0);
+    if (needed > AvailableBlocks()) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Paged KV cache is out of blocks");
+    }
+    
+    if (copy_last) {
+        int32_t copy = 0;
+        Status status = AcquireBlock(&copy);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int32_t shared = sequence.block_table.back();
+        if (!swap_pending_blocks_.empty()) {
+            WaitForSwaps();  // 末块可能刚换入
+        }
+        std::memcpy(blocks_[copy].data, blocks_[shared].data, block_bytes_);
+        ReleaseBlock(shared);
+        sequence.block_table.back() = copy;
+    }
+    while (static_cast<int64_t>(sequence.block_table.size()) < BlocksFor(new_length, block_size)) {
+        int32_t block = 0;
+        Status status = AcquireBlock(&block);
+        if (!status.IsOk()) {
+            return status;
+        }
+        sequence.block_table.push_back(block);
+    }
+    sequence.length = new_length;
+    return Status::Ok();
+}
+
+Status PagedKVCache::Trim(int64_t seq, int64_t length) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end() || it->second.swapped || length < 0 || length > it->second.length) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Invalid trim of sequence " + std::to_string(seq));
+    }
+    Sequence& sequence = it->second;
+    const size_t keep = static_cast<size_t>(BlocksFor(length, options_.block_size));
+    for (size_t i = keep; i < sequence.block_table.size(); ++i) {
+        ReleaseBlock(sequence.block_table[i]);
+    }
+    sequence.block_table.resize(keep);
+    sequence.block_hashes.resize(std::min(sequence.block_hashes.size(),
+                                          static_cast<size_t>(length / options_.block_size)));
+    sequence.length = length;
+    return Status::Ok();
+}
+
+Status PagedKVCache::Fork(int64_t src, int64_t dst) {
+    auto it = sequences_.find(src);
+    if (it == sequences_.end() || it->second.swapped || sequences_.count(dst)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Cannot fork sequence " + std::to_string(src) + " into " + std::to_string(dst));
+    }
+    Sequence copy = it->second;
+    for (int32_t block : copy.block_table) {
+        ++blocks_[block].ref_count;
+    }
+    sequences_.emplace(dst, std::move(copy));
+    return Status::Ok();
+}
+
+Status PagedKVCache::SwapOut(int64_t seq) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end() || it->second.swapped) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Unknown or swapped-out sequence: " + std::to_string(seq));
+    }
+    Sequence& sequence = it->second;
+    const size_t count = sequence.block_table.size();
+    if (count > GetNumFreeSwapBlocks()) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "KV swap space is full");
+    }
+    while (free_swap_blocks_.size() < count) {
+        uint8_t* data = static_cast<uint8_t*>(AllocateMemory(block_bytes_, kBlockAlignment));
+        if (!data) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate KV swap block");
+        }
+        free_swap_blocks_.push_back(static_cast<int32_t>(swap_blocks_.size()));
+        swap_blocks_.push_back(data);
+    }
+    if (!swap_stream_) {
+        swap_stream_ = std::make_unique<SwapStream>(block_bytes_);
+    }
+    
+    std::vector<std::pair<uint8_t*, const uint8_t*>> copies;
+    for (int32_t block : sequence.block_table) {
+        const int32_t swap_block = free_swap_blocks_.back();
+        free_swap_blocks_.pop_back();
+        sequence.swap_table.push_back(swap_block);
+        copies.emplace_back(swap_blocks_[swap_block], blocks_[block].data);
+        if (!blocks_[block].swap_pending) {
+            blocks_[block].swap_pending = true;
+            swap_pending_blocks_.push_back(block);
+        }
+        ReleaseBlock(block);
+    }
+    if (!copies.empty()) {
+        swap_stream_->Enqueue(std::move(copies));
+    }
+    sequence.block_table.clear();
+    sequence.block_hashes.clear();
+    sequence.swapped = true;
+    ++swap_stats_.num_swap_outs;
+    swap_stats_.swapped_out_blocks += count;
+    return Status::Ok();
+}
+
+Status PagedKVCache::SwapIn(int64_t seq) {
+    auto it = sequences_.find(seq);
+    if (it == sequences_.end() || !it->second.swapped) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Sequence is not swapped out: " + std::to_string(seq));
+    }
+    if (!CanSwapIn(seq)) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Paged KV cache is out of blocks");
+    }
+    Sequence& sequence = it->second;
+    std::vector<int32_t> table;
+    for (size_t i = 0; i < sequence.swap_table.size(); ++i) {
+        int32_t block = 0;
+        Status status = AcquireBlock(&block);
+        if (!status.IsOk()) {
+            for (int32_t acquired : table) {
+                ReleaseBlock(acquired);
+            }
+            return status;
+        }
+        table.push_back(block);
+    }
+    std::vector<std::pair<uint8_t*, const uint8_t*>> copies;
+    for (size_t i = 0; i < table.size(); ++i) {
+        copies.emplace_back(blocks_[table[i]].data, swap_blocks_[sequence.swap_table[i]]);
+        // 读取换入的块之前须WaitForSwaps；复用前同样等待
+        blocks_[table[i]].swap_pending = true;
+        swap_pending_blocks_.push_back(table[i]);
+    }
+    if (!copies.empty()) {
+        swap_stream_->Enqueue(std::move(copies));
+    }
+    free_swap_blocks_.insert(free_swap_blocks_.end(), sequence.swap_table.begin(), sequence.swap_table.end());
+    sequence.swap_table.clear();
+    sequence.block_table = std::move(table);
+    sequence.swapped = false;
+    ++swap_stats_.num_swap_ins;
+    swap_stats_.swapped_in_blocks += sequence.block_table.size();
+    return Status::Ok();
+}
+
+bool PagedKVCache::IsSwappedOut(int64_t seq) const {
+    auto it = sequences_.find(seq);
+    return it != sequences_.end() && it->second.swapped;
+}
+
+bool PagedKVCache::CanSwapIn(int64_t seq) const {
+    auto it = sequences_.find(seq);
+    return it != sequences_.end() && it->second.swapped && it->second.swap_table.size() <= AvailableBlocks();
+}
+
+void PagedKVCache::WaitForSwaps() {
+    if (swap_stream_) {
+        swap_stream_->Synchronize();
+    }
+    for (int32_t block : swap_pending_blocks_) {
+        blocks_[block].swap_pending = false;
+    }
+    swap_pending_blocks_.clear();
+}
+
+size_t PagedKVCache::GetNumFreeSwapBlocks() const {
+    const size_t limit = static_cast<size_t>(std::max<int64_t>(options_.max_swap_blocks, 0));
+    return free_swap_blocks_.size() + (limit > swap_blocks_.size() ? limit - swap_blocks_.size() : 0);
+}
+
+float* PagedKVCache::GetKeyBlock(size_t layer, int32_t block) const {
+    return reinterpret_cast<float*>(GetKeyBlockData(layer, block));
+}
+
+float* PagedKVCache::GetValueBlock(size_t layer, int32_t block) const {
+    return reinterpret_cast<float*>(GetValueBlockData(layer, block));
+}
+
+uint8_t* PagedKVCache::GetKeyBlockData(size_t layer, int32_t block) const {
+    return blocks_[block].data + layers_[layer].key_offset;
+}
+
+uint8_t* PagedKVCache::GetValueBlockData(size_t layer, int32_t block) const {
+    return blocks_[block].data + layers_[layer].value_offset;
+}
+
+float* PagedKVCache::GetKeyScales(size_t layer, int32_t block) const {
+    if (options_.storage == KVCacheStorage::FLOAT32) {
+        return nullptr;
+    }
+    return reinterpret_cast<float*>(blocks_[block].data + layers_[layer].key_scale_offset);
+}
+
+float* PagedKVCache::GetValueScales(size_t layer, int32_t block) const {
+    if (options_.storage == KVCacheStorage::FLOAT32) {
+        return nullptr;
+    }
+    return reinterpret_cast<float*>(blocks_[block].data + layers_[layer].value_scale_offset);
+}
+
+size_t PagedKVCache::GetNumSharedBlocks() const {
+    return static_cast<size_t>(std::count_if(blocks_.begin(), blocks_.end(),
+                                             [](const Block& block) { return block.ref_count > 1; }));
+}
+
+Status PagedKVCache::AcquireBlock(int32_t* block) {
+    if (!free_blocks_.empty()) {
+        *block = free_blocks_.back();
+        free_blocks_.pop_back();
+    } else if (options_.max_blocks <= 0 || static_cast<int64_t>(blocks_.size()) < options_.max_blocks) {
+        uint8_t* data = static_cast<uint8_t*>(AllocateMemory(block_bytes_, kBlockAlignment));
+        if (!data) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate KV block");
+        }
+        *block = static_cast<int32_t>(blocks_.size());
+        blocks_.push_back(Block());
+        blocks_.back().data = data;
+    } else if (!evictable_.empty()) {
+        // 回收最久未用的缓存块
+        *block = evictable_.front();
+        evictable_.pop_front();
+        Uncache(*block);
+        ++prefix_stats_.num_evictions;
+    } else {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Paged KV cache is out of blocks");
+    }
+    if (blocks_[*block].swap_pending) {
+        WaitForSwaps();  // 换出还在读这个块
+    }
+    blocks_[*block].ref_count = 1;
+    return Status::Ok();
+}
+
+void PagedKVCache::ReleaseBlock(int32_t block) {
+    Block& entry = blocks_[block];
+    if (--entry.ref_count == 0) {
+        if (entry.cached) {
+            entry.lru = evictable_.insert(evictable_.end(), block);
+        } else {
+            free_blocks_.push_back(block);
+        }
+    }
+}
+
+void PagedKVCache::Uncache(int32_t block) {
+    Block& entry = blocks_[block];
+    if (entry.cached) {
+        cached_blocks_.erase(entry.hash);
+        entry.cached = false;
+        entry.tokens.clear();
+    }
+}
+
+size_t PagedKVCache::AvailableBlocks() const {
+    if (options_.max_blocks <= 0) {
+        return static_cast<size_t>(-1);
+    }
+    return free_blocks_.size() + evictable_.size() + static_cast<size_t>(options_.max_blocks) - blocks_.size();
+}
+
+} // namespace inferunity
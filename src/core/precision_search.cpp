@@ -0,0 +1,289 @@
+// 自动混合精度搜索实现
+// 参考TensorRT的逐层精度回退（layer precision constraints）与Intel Neural Compressor的
+// 精度驱动调优：以FP32的输出为参考，按代价从高到低逐层降低精度，每一步在数据集上验证
+
+#include "inferunity/quantization.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/model_format.h"
+#include "inferunity/optimizer.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace inferunity {
+
+namespace {
+
+using Dataset = std::vector<std::vector<std::shared_ptr<Tensor>>>;
+
+bool IsHalfPrecision(DataType dtype) {
+    return dtype == DataType::FLOAT16 || dtype == DataType::BFLOAT16;
+}
+
+// 只用于LOG_VERBOSE，非调试构建中该宏为空
+[[maybe_unused]] const char* PrecisionName(DataType dtype) {
+    switch (dtype) {
+        case DataType::INT8: return "int8";
+        case DataType::FLOAT16: return "fp16";
+        case DataType::BFLOAT16: return "bf16";
+        default: return "fp32";
+    }
+}
+
+// 该精度是否可能用于该节点（是否真正改写由ApplyPrecisions检查）
+bool IsCandidateFor(const Node& node, DataType precision, const PrecisionSearchOptions& options) {
+    const std::string& type = node.GetOpType();
+    if (precision == DataType::INT8) {
+        const auto& op_types = options.quantization.op_types;
+        return std::find(op_types.begin(), op_types.end(), type) != op_types.end();
+    }
+    return IsHalfPrecision(precision) && (type == "MatMul" || type == "FusedMatMulAdd");
+}
+
+// 节点已按precision改写：INT8的权重来自DequantizeLinear，半精度的权重以该类型存储
+bool IsLowered(const Graph& graph, const std::string& node_name, DataType precision) {
+    const Node* node = graph.GetNodeByName(node_name);
+    if (!node || node->GetInputs().size() < 2 || !node->GetInputs()[1]) {
+        return false;
+    }
+    const Value* weight = node->GetInputs()[1];
+    if (precision == DataType::INT8) {
+        return weight->GetProducer() && weight->GetProducer()->GetOpType() == "DequantizeLinear";
+    }
+    return weight->GetDataType() == precision;
+}
+
+// 在graph的副本上按各节点的精度改写
+Status ApplyPrecisions(const Graph& graph, const std::map<std::string, DataType>& precisions,
+                       const CalibrationTable& table, const PrecisionSearchOptions& options,
+                       std::unique_ptr<Graph>* lowered) {
+    auto copy = std::make_unique<Graph>(graph.Clone());
+    QuantizationOptions quantization = options.quantization;
+    quantization.node_names.clear();
+    std::map<DataType, std::vector<std::string>> half_nodes;
+    for (const auto& entry : precisions) {
+        if (entry.second == DataType::INT8) {
+            quantization.node_names.push_back(entry.first);
+        } else if (IsHalfPrecision(entry.second)) {
+            half_nodes[entry.second].push_back(entry.first);
+        }
+    }
+    Status status;
+    if (!quantization.node_names.empty()) {
+        status = QuantizeGraph(copy.get(), table, quantization);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    for (auto& entry : half_nodes) {
+        status = MixedPrecisionPass(entry.first, options.bf16_compute, std::move(entry.second)).Run(copy.get());
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    *lowered = std::move(copy);
+    return Status::Ok();
+}
+
+// 以CPU提供者执行数据集，Q/DQ由提供者折叠为整数核
+Status RunDataset(const Graph& graph, const Dataset& dataset, Dataset* outputs) {
+    SessionOptions session_options;
+    session_options.execution_providers = {"CPUExecutionProvider"};
+    session_options.enable_quantization = true;
+    auto session = InferenceSession::Create(session_options);
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create evaluation session");
+    }
+    Status status = session->LoadModelFromGraph(std::make_unique<Graph>(graph.Clone()));
+    if (!status.IsOk()) {
+        return status;
+    }
+    outputs->clear();
+    for (const auto& sample : dataset) {
+        std::vector<Tensor*> inputs;
+        for (const auto& tensor : sample) {
+            inputs.push_back(tensor.get());
+        }
+        std::vector<std::shared_ptr<Tensor>> sample_outputs;
+        status = session->Run(inputs, sample_outputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        outputs->push_back(std::move(sample_outputs));
+    }
+    return Status::Ok();
+}
+
+// 相对误差（越小越好）或一致率（越大越好）
+double MeasureAccuracy(const Dataset& reference, const Dataset& outputs, PrecisionAccuracyMetric metric) {
+    size_t agree = 0, rows = 0;
+    double max_error = 0.0;
+    for (size_t s = 0; s < reference.size() && s < outputs.size(); ++s) {
+        for (size_t o = 0; o < reference[s].size() && o < outputs[s].size(); ++o) {
+            const Tensor& expected = *reference[s][o];
+            const Tensor& actual = *outputs[s][o];
+            if (expected.GetDataType() != DataType::FLOAT32 || actual.GetDataType() != DataType::FLOAT32 ||
+                expected.GetElementCount() != actual.GetElementCount()) {
+                continue;
+            }
+            const float* e = static_cast<const float*>(expected.GetData());
+            const float* a = static_cast<const float*>(actual.GetData());
+            const size_t count = expected.GetElementCount();
+            if (metric == PrecisionAccuracyMetric::MAX_RELATIVE_ERROR) {
+                double diff = 0.0, scale = 0.0;
+                for (size_t i = 0; i < count; ++i) {
+                    diff = std::max(diff, static_cast<double>(std::fabs(a[i] - e[i])));
+                    scale = std::max(scale, static_cast<double>(std::fabs(e[i])));
+                }
+                max_error = std::max(max_error, diff / std::max(scale, 1e-12));
+            } else if (o == 0 && !expected.GetShape().dims.empty() && expected.GetShape().dims.back() > 0) {
+                const size_t width = static_cast<size_t>(expected.GetShape().dims.back());
+                for (size_t row = 0; row + width <= count; row += width) {
+                    agree += std::max_element(e + row, e + row + width) - e ==
+                             std::max_element(a + row, a + row + width) - a;
+                    ++rows;
+                }
+            }
+        }
+    }
+    if (metric == PrecisionAccuracyMetric::MAX_RELATIVE_ERROR) {
+        return max_error;
+    }
+    return rows > 0 ? static_cast<double>(agree) / static_cast<double>(rows) : 1.0;
+}
+
+bool MeetsTolerance(double accuracy, const PrecisionSearchOptions& options) {
+    return options.metric == PrecisionAccuracyMetric::MAX_RELATIVE_ERROR ? accuracy <= options.tolerance
+                                                                         : accuracy >= options.tolerance;
+}
+
+} // anonymous namespace
+
+Status SearchMixedPrecision(const Graph& graph, const Dataset& dataset, const PrecisionSearchOptions& options,
+                            std::unique_ptr<Graph>* result_graph, PrecisionSearchResult* result) {
+    if (!result_graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Result graph is null");
+    }
+    if (dataset.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Calibration dataset is empty");
+    }
+    for (DataType candidate : options.candidates) {
+        if (candidate != DataType::INT8 && !IsHalfPrecision(candidate)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Precision candidates must be INT8, FLOAT16 or BFLOAT16");
+        }
+    }
+    
+    Dataset reference;
+    Status status = RunDataset(graph, dataset, &reference);
+    if (!status.IsOk()) {
+        return status;
+    }
+    CalibrationTable table;
+    if (std::find(options.candidates.begin(), options.candidates.end(), DataType::INT8) != options.candidates.end()) {
+        status = CalibrationRunner(options.quantization).Run(graph, dataset, &table);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    // 各层的代价：不做优化的会话保留原节点名，剖析耗时（零输入）与估计的浮点运算数
+    std::vector<LayerPrecision> layers;
+    {
+        SessionOptions profile_options;
+        profile_options.execution_providers = {"CPUExecutionProvider"};
+        profile_options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+        auto session = InferenceSession::Create(profile_options);
+        if (!session) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create profiling session");
+        }
+        status = session->LoadModelFromGraph(std::make_unique<Graph>(graph.Clone()));
+        ProfilingResult profile;
+        if (status.IsOk()) {
+            status = session->Profile(profile);
+        }
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (const auto& node_profile : profile.node_profiles) {
+            const Node* node = graph.GetNodeByName(node_profile.node_name);
+            if (!node || std::none_of(options.candidates.begin(), options.candidates.end(), [&](DataType dtype) {
+                    return IsCandidateFor(*node, dtype, options);
+                })) {
+                continue;
+            }
+            LayerPrecision layer;
+            layer.node_name = node_profile.node_name;
+            layer.op_type = node_profile.op_type;
+            layer.time_ms = node_profile.execution_time_ms;
+            layer.estimated_flops = node_profile.estimated_flops;
+            layers.push_back(layer);
+        }
+    }
+    std::stable_sort(layers.begin(), layers.end(), [](const LayerPrecision& a, const LayerPrecision& b) {
+        return a.time_ms != b.time_ms ? a.time_ms > b.time_ms : a.estimated_flops > b.estimated_flops;
+    });
+    
+    // 逐层贪心：候选按给出的顺序尝试，采用第一个满足精度且确实改写了该层的
+    std::map<std::string, DataType> precisions;
+    std::unique_ptr<Graph> accepted = std::make_unique<Graph>(graph.Clone());
+    double accuracy = options.metric == PrecisionAccuracyMetric::MAX_RELATIVE_ERROR ? 0.0 : 1.0;
+    size_t evaluations = 0;
+    const size_t layer_count = options.max_layers > 0 ? std::min(options.max_layers, layers.size()) : layers.size();
+    for (size_t i = 0; i < layer_count; ++i) {
+        LayerPrecision& layer = layers[i];
+        const Node* node = graph.GetNodeByName(layer.node_name);
+        for (DataType candidate : options.candidates) {
+            if (!IsCandidateFor(*node, candidate, options)) {
+                continue;
+            }
+            std::map<std::string, DataType> trial = precisions;
+            trial[layer.node_name] = candidate;
+            std::unique_ptr<Graph> lowered;
+            status = ApplyPrecisions(graph, trial, table, options, &lowered);
+            if (!status.IsOk()) {
+                return status;
+            }
+            if (!IsLowered(*lowered, layer.node_name, candidate)) {
+                continue;
+            }
+            Dataset outputs;
+            status = RunDataset(*lowered, dataset, &outputs);
+            ++evaluations;
+            if (!status.IsOk()) {
+                LOG_WARNING("Mixed precision candidate for " + layer.node_name + " failed: " + status.Message());
+                continue;
+            }
+            const double trial_accuracy = MeasureAccuracy(reference, outputs, options.metric);
+            if (MeetsTolerance(trial_accuracy, options)) {
+                precisions = std::move(trial);
+                accepted = std::move(lowered);
+                accuracy = trial_accuracy;
+                layer.precision = candidate;
+                break;
+            }
+        }
+        LOG_VERBOSE("Mixed precision: " + layer.node_name + " -> " + PrecisionName(layer.precision));
+    }
+    LOG_INFO("Mixed precision search lowered " + std::to_string(precisions.size()) + " of " +
+             std::to_string(layers.size()) + " layers with " + std::to_string(evaluations) + " evaluations");
+    
+    if (!options.output_path.empty()) {
+        status = SaveCompactModel(*accepted, options.output_path);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    if (result) {
+        result->layers = std::move(layers);
+        result->accuracy = accuracy;
+        result->evaluations = evaluations;
+    }
+    *result_graph = std::move(accepted);
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,68 @@
+// 图像预处理的图改写
+
+#include "inferunity/preprocess.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+
+namespace inferunity {
+
+Status PrependImagePreprocess(Graph* graph, const ImagePreprocessOptions& options, const std::string& input_name) {
+    if (!graph || graph->GetInputs().empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Image preprocess needs a graph with inputs");
+    }
+    const auto& inputs = graph->GetInputs();
+    Value* image = inputs.front();
+    if (!input_name.empty()) {
+        auto it = std::find_if(inputs.begin(), inputs.end(),
+                               [&](const Value* input) { return input->GetName() == input_name; });
+        if (it == inputs.end()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph has no input: " + input_name);
+        }
+        image = *it;
+    }
+    const auto& dims = image->GetShape().dims;
+    const DataType dtype = image->GetDataType();
+    if (dims.size() != 4 || dims[1] <= 0 || dims[2] <= 0 || dims[3] <= 0 ||
+        (dtype != DataType::FLOAT32 && dtype != DataType::FLOAT16)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Image preprocess needs a FLOAT32/FLOAT16 NCHW input with known C, H and W: " +
+                           image->GetName());
+    }
+    const int64_t channels = dims[1];
+    if ((options.mean.size() > 1 && static_cast<int64_t>(options.mean.size()) != channels) ||
+        (options.std.size() > 1 && static_cast<int64_t>(options.std.size()) != channels)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Image preprocess mean/std need one entry per channel");
+    }
+    if (options.resize_mode != "linear" && options.resize_mode != "nearest") {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Image preprocess resize_mode must be linear or nearest");
+    }
+    
+    Node* node = graph->AddNode("ImagePreprocess", "image_preprocess");
+    if (!options.mean.empty()) {
+        node->SetAttribute("mean", AttributeValue(options.mean));
+    }
+    if (!options.std.empty()) {
+        node->SetAttribute("std", AttributeValue(options.std));
+    }
+    node->SetAttribute("scale", AttributeValue(options.scale));
+    node->SetAttribute("reverse_channels", AttributeValue(static_cast<int64_t>(options.reverse_channels)));
+    node->SetAttribute("height", AttributeValue(dims[2]));
+    node->SetAttribute("width", AttributeValue(dims[3]));
+    node->SetAttribute("mode", AttributeValue(options.resize_mode));
+    node->SetAttribute("to", AttributeValue(static_cast<int64_t>(dtype == DataType::FLOAT16 ? 10 : 1)));
+    
+    Value* raw = graph->AddValue();
+    const std::string name = image->GetName();
+    image->SetName(name + "_preprocessed");
+    raw->SetName(name);
+    raw->SetTensor(std::make_shared<Tensor>(Shape({dims[0], options.input_height, options.input_width, channels}),
+                                            DataType::UINT8, nullptr));
+    graph->ReplaceInput(image, raw);
+    node->AddInput(raw);
+    node->AddOutput(image);
+    return Status::Ok();
+}
+
+} // namespace inferunity
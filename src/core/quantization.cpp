@@ -0,0 +1,538 @@
+// 训练后静态量化实现：激活校准与Q/DQ插入
+// 参考ONNX Runtime的quantization/calibrate.py（MinMax/Percentile/Entropy校准器）与
+// qdq_quantizer.py（激活Q/DQ对、按通道对称量化的权重）
+
+#include "inferunity/quantization.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+// 熵校准把截断后的分布压缩到的量化级数（8位有符号的正半轴，参考TensorRT）
+constexpr int kEntropyQuantizedBins = 128;
+
+bool IsInitializer(const Graph& graph, const Value* value) {
+    const auto& inputs = graph.GetInputs();
+    return value && !value->GetProducer() && value->GetTensor() && value->GetTensor()->GetData() &&
+           std::find(inputs.begin(), inputs.end(), value) == inputs.end();
+}
+
+bool IsFloatInitializer(const Graph& graph, const Value* value, size_t rank) {
+    return IsInitializer(graph, value) && value->GetDataType() == DataType::FLOAT32 &&
+           value->GetShape().dims.size() == rank;
+}
+
+// 可量化节点：类型在options.op_types中，权重（输入1）为FLOAT32常量；Conv为4D权重，MatMul为2D
+bool IsQuantizable(const Graph& graph, const Node& node, const QuantizationOptions& options) {
+    const std::string& op_type = node.GetOpType();
+    if (std::find(options.op_types.begin(), options.op_types.end(), op_type) == options.op_types.end()) {
+        return false;
+    }
+    if (!options.node_names.empty() &&
+        std::find(options.node_names.begin(), options.node_names.end(), node.GetName()) == options.node_names.end()) {
+        return false;
+    }
+    const auto& inputs = node.GetInputs();
+    if (op_type == "Conv") {
+        return (inputs.size() == 2 || inputs.size() == 3) && IsFloatInitializer(graph, inputs[1], 4) &&
+               !IsInitializer(graph, inputs[0]);
+    }
+    if (op_type == "MatMul") {
+        return inputs.size() == 2 && IsFloatInitializer(graph, inputs[1], 2) && !IsInitializer(graph, inputs[0]);
+    }
+    return false;
+}
+
+// 需要量化的输出：Conv的唯一消费者是Relu时取Relu的输出，之后QDQFusionPass把Relu吸收进QLinearConv
+Value* QuantizedOutput(const Graph& graph, Node* node) {
+    Value* output = node->GetOutputs()[0];
+    const auto& graph_outputs = graph.GetOutputs();
+    if (node->GetOpType() == "Conv" && output->GetConsumers().size() == 1 &&
+        output->GetConsumers()[0]->GetOpType() == "Relu" &&
+        std::find(graph_outputs.begin(), graph_outputs.end(), output) == graph_outputs.end()) {
+        return output->GetConsumers()[0]->GetOutputs()[0];
+    }
+    return output;
+}
+
+bool GetQuantizedRange(DataType dtype, int32_t* qmin, int32_t* qmax) {
+    switch (dtype) {
+        case DataType::INT8: *qmin = -128; *qmax = 127; return true;
+        case DataType::UINT8: *qmin = 0; *qmax = 255; return true;
+        default: return false;
+    }
+}
+
+// ---- 校准 ----
+
+// 观测值的统计：范围与直方图
+struct ActivationStats {
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    float hist_lo = 0.0f;
+    float hist_hi = 0.0f;
+    std::vector<double> histogram;
+};
+
+void UpdateRange(const float* data, size_t count, ActivationStats* stats) {
+    for (size_t i = 0; i < count; ++i) {
+        stats->min = std::min(stats->min, data[i]);
+        stats->max = std::max(stats->max, data[i]);
+    }
+}
+
+// abs为true时统计|x|（熵校准），否则统计x（百分位校准）
+void UpdateHistogram(const float* data, size_t count, bool abs, ActivationStats* stats) {
+    const size_t bins = stats->histogram.size();
+    const float width = (stats->hist_hi - stats->hist_lo) / static_cast<float>(bins);
+    if (width <= 0.0f) {
+        stats->histogram[0] += static_cast<double>(count);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const float x = abs ? std::fabs(data[i]) : data[i];
+        const int64_t bin = static_cast<int64_t>((x - stats->hist_lo) / width);
+        stats->histogram[static_cast<size_t>(std::min<int64_t>(std::max<int64_t>(bin, 0), bins - 1))] += 1.0;
+    }
+}
+
+TensorRange PercentileRange(const ActivationStats& stats, float percentile) {
+    const auto& hist = stats.histogram;
+    double total = 0.0;
+    for (double c : hist) {
+        total += c;
+    }
+    const double tail = total * std::max(0.0, 100.0 - percentile) / 200.0;
+    const float width = (stats.hist_hi - stats.hist_lo) / static_cast<float>(hist.size());
+    size_t lower = 0;
+    for (double cumulative = 0.0; lower + 1 < hist.size(); ++lower) {
+        cumulative += hist[lower];
+        if (cumulative > tail) {
+            break;
+        }
+    }
+    size_t upper = hist.size() - 1;
+    for (double cumulative = 0.0; upper > lower; --upper) {
+        cumulative += hist[upper];
+        if (cumulative > tail) {
+            break;
+        }
+    }
+    TensorRange range;
+    range.min = stats.hist_lo + static_cast<float>(lower) * width;
+    range.max = stats.hist_lo + static_cast<float>(upper + 1) * width;
+    return range;
+}
+
+// TensorRT的熵校准：对每个候选截断点i，P为前i个bin（超出部分累加到最后一个bin），
+// Q把前i个bin合并成kEntropyQuantizedBins级后再均匀展开到原先非零的bin上，取KL(P||Q)最小的i
+float EntropyThreshold(const ActivationStats& stats) {
+    const std::vector<double>& hist = stats.histogram;
+    const size_t bins = hist.size();
+    const float width = stats.hist_hi / static_cast<float>(bins);
+    if (bins <= static_cast<size_t>(kEntropyQuantizedBins) || width <= 0.0f) {
+        return stats.hist_hi;
+    }
+    std::vector<double> suffix(bins + 1, 0.0);
+    for (size_t i = bins; i-- > 0;) {
+        suffix[i] = suffix[i + 1] + hist[i];
+    }
+    std::vector<double> p(bins), q(bins);
+    double best_kl = std::numeric_limits<double>::max();
+    size_t best = bins;
+    for (size_t i = kEntropyQuantizedBins; i <= bins; ++i) {
+        for (size_t k = 0; k < i; ++k) {
+            p[k] = hist[k];
+        }
+        p[i - 1] += suffix[i];
+        for (size_t j = 0; j < static_cast<size_t>(kEntropyQuantizedBins); ++j) {
+            const size_t start = j * i / kEntropyQuantizedBins;
+            const size_t end = (j + 1) * i / kEntropyQuantizedBins;
+            double sum = 0.0;
+            size_t nonzero = 0;
+            for (size_t k = start; k < end; ++k) {
+                sum += hist[k];
+                nonzero += hist[k] != 0.0;
+            }
+            for (size_t k = start; k < end; ++k) {
+                q[k] = (hist[k] != 0.0 && nonzero > 0) ? sum / static_cast<double>(nonzero) : 0.0;
+            }
+        }
+        double p_sum = 0.0, q_sum = 0.0;
+        for (size_t k = 0; k < i; ++k) {
+            p_sum += p[k];
+            q_sum += q[k];
+        }
+        if (p_sum <= 0.0 || q_sum <= 0.0) {
+            continue;
+        }
+        double kl = 0.0;
+        for (size_t k = 0; k < i; ++k) {
+            if (p[k] <= 0.0) {
+                continue;
+            }
+            const double pk = p[k] / p_sum;
+            // Q为0而P不为0时（最后一个bin吸收的离群值）用一个很小的概率平滑
+            const double qk = q[k] > 0.0 ? q[k] / q_sum : 1e-10;
+            kl += pk * std::log(pk / qk);
+        }
+        if (kl < best_kl) {
+            best_kl = kl;
+            best = i;
+        }
+    }
+    return std::min(stats.hist_hi, (static_cast<float>(best) + 0.5f) * width);
+}
+
+// ---- Q/DQ插入 ----
+
+std::shared_ptr<Tensor> FloatTensor(const std::vector<float>& values) {
+    auto tensor = CreateTensor(Shape({static_cast<int64_t>(values.size())}), DataType::FLOAT32, DeviceType::CPU);
+    std::copy(values.begin(), values.end(), static_cast<float*>(tensor->GetData()));
+    return tensor;
+}
+
+std::shared_ptr<Tensor> ZeroPointTensor(DataType dtype, int32_t value, int64_t count) {
+    auto tensor = CreateTensor(Shape({count}), dtype, DeviceType::CPU);
+    for (int64_t i = 0; i < count; ++i) {
+        if (dtype == DataType::INT8) {
+            static_cast<int8_t*>(tensor->GetData())[i] = static_cast<int8_t>(value);
+        } else {
+            static_cast<uint8_t*>(tensor->GetData())[i] = static_cast<uint8_t>(value);
+        }
+    }
+    return tensor;
+}
+
+class QDQInserter {
+public:
+    QDQInserter(Graph* graph, const QuantizationOptions& options) : graph_(graph), options_(options) {}
+    
+    // x -> Q -> DQ，返回DQ的输出；同一个值只插入一次，已是DQ输出的值不再量化
+    Value* QuantizeActivation(Value* x, const TensorRange& range) {
+        if (x->GetProducer() && x->GetProducer()->GetOpType() == "DequantizeLinear") {
+            return x;
+        }
+        auto it = quantized_.find(x);
+        if (it != quantized_.end()) {
+            return it->second;
+        }
+        const std::string key = CalibrationKey(x);
+        Value* dequantized = graph_->AddValue();
+        dequantized->SetName(key + "_dequantized");
+        InsertPair(x, dequantized, key, range);
+        quantized_[x] = dequantized;
+        return dequantized;
+    }
+    
+    // 生产者改为输出y_float，y由DQ产生；消费者与图输出仍使用y
+    void QuantizeOutput(Value* y, const TensorRange& range) {
+        if (y->GetProducer() && y->GetProducer()->GetOpType() == "DequantizeLinear") {
+            return;
+        }
+        const std::string key = CalibrationKey(y);
+        Node* producer = y->GetProducer();
+        Value* y_float = graph_->AddValue();
+        y_float->SetName(key + "_float");
+        producer->RemoveOutput(y);
+        producer->AddOutput(y_float);
+        InsertPair(y_float, y, key, range);
+    }
+    
+    // 常量权重按axis上的通道对称量化为INT8（取值[-127, 127]，reduce_range时[-63, 63]），零点为0，后接DQ
+    Value* QuantizeWeight(Value* weight, int64_t axis) {
+        const Shape& shape = weight->GetShape();
+        const float* w = static_cast<const float*>(weight->GetTensor()->GetData());
+        const int64_t channels = options_.per_channel ? shape.dims[axis] : 1;
+        int64_t outer = 1, inner = 1;
+        for (int64_t i = 0; i < axis; ++i) {
+            outer *= shape.dims[i];
+        }
+        for (size_t i = static_cast<size_t>(axis) + 1; i < shape.dims.size(); ++i) {
+            inner *= shape.dims[i];
+        }
+        if (channels == 1) {
+            inner *= outer * shape.dims[axis];
+            outer = 1;
+        }
+        std::vector<float> scales(channels, 0.0f);
+        for (int64_t o = 0; o < outer; ++o) {
+            for (int64_t c = 0; c < channels; ++c) {
+                const float* src = w + (o * channels + c) * inner;
+                for (int64_t i = 0; i < inner; ++i) {
+                    scales[c] = std::max(scales[c], std::fabs(src[i]));
+                }
+            }
+        }
+        const float qmax = options_.reduce_range ? 63.0f : 127.0f;
+        for (float& scale : scales) {
+            scale = scale > 0.0f ? scale / qmax : 1.0f;
+        }
+        auto quantized = CreateTensor(shape, DataType::INT8, DeviceType::CPU);
+        int8_t* q = static_cast<int8_t*>(quantized->GetData());
+        for (int64_t o = 0; o < outer; ++o) {
+            for (int64_t c = 0; c < channels; ++c) {
+                const int64_t offset = (o * channels + c) * inner;
+                for (int64_t i = 0; i < inner; ++i) {
+                    const float v = std::nearbyint(w[offset + i] / scales[c]);
+                    q[offset + i] = static_cast<int8_t>(std::min(std::max(v, -qmax), qmax));
+                }
+            }
+        }
+        const std::string key = CalibrationKey(weight);
+        Node* dq = graph_->AddNode("DequantizeLinear", key + "_dequantize");
+        if (channels > 1) {
+            dq->SetAttribute("axis", AttributeValue(axis));
+        }
+        dq->AddInput(Constant(quantized, key + "_quantized"));
+        dq->AddInput(Constant(FloatTensor(scales), key + "_scale"));
+        dq->AddInput(Constant(ZeroPointTensor(DataType::INT8, 0, channels), key + "_zero_point"));
+        Value* dequantized = graph_->AddValue();
+        dequantized->SetName(key + "_dequantized");
+        dq->AddOutput(dequantized);
+        return dequantized;
+    }
+
+private:
+    // input -> QuantizeLinear -> DequantizeLinear -> output
+    void InsertPair(Value* input, Value* output, const std::string& key, const TensorRange& range) {
+        float scale = 1.0f;
+        int32_t zero_point = 0;
+        ComputeScaleZeroPoint(range, &scale, &zero_point);
+        Value* scale_value = Constant(FloatTensor({scale}), key + "_scale");
+        Value* zp_value = Constant(ZeroPointTensor(options_.activation_dtype, zero_point, 1), key + "_zero_point");
+        
+        Node* q = graph_->AddNode("QuantizeLinear", key + "_quantize");
+        Value* quantized = graph_->AddValue();
+        quantized->SetName(key + "_quantized");
+        q->AddInput(input);
+        q->AddInput(scale_value);
+        q->AddInput(zp_value);
+        q->AddOutput(quantized);
+        
+        Node* dq = graph_->AddNode("DequantizeLinear", key + "_dequantize");
+        dq->AddInput(quantized);
+        dq->AddInput(scale_value);
+        dq->AddInput(zp_value);
+        dq->AddOutput(output);
+    }
+    
+    // 非对称量化：scale = (max - min) / (qmax - qmin)，零点使0.0精确可表示
+    void ComputeScaleZeroPoint(const TensorRange& range, float* scale, int32_t* zero_point) const {
+        int32_t qmin = 0, qmax = 255;
+        GetQuantizedRange(options_.activation_dtype, &qmin, &qmax);
+        const float lo = std::min(range.min, 0.0f);
+        const float hi = std::max(range.max, 0.0f);
+        *scale = (hi - lo) / static_cast<float>(qmax - qmin);
+        if (!(*scale > 0.0f) || !std::isfinite(*scale)) {
+            *scale = 1.0f;
+            *zero_point = std::max(qmin, 0);
+            return;
+        }
+        const float zp = std::nearbyint(static_cast<float>(qmin) - lo / *scale);
+        *zero_point = static_cast<int32_t>(std::min(std::max(zp, static_cast<float>(qmin)),
+                                                    static_cast<float>(qmax)));
+    }
+    
+    Value* Constant(const std::shared_ptr<Tensor>& tensor, const std::string& name) {
+        Value* value = graph_->AddValue();
+        value->SetName(name);
+        value->SetTensor(tensor);
+        return value;
+    }
+    
+    Graph* graph_;
+    const QuantizationOptions& options_;
+    std::unordered_map<Value*, Value*> quantized_;
+};
+
+} // anonymous namespace
+
+std::string CalibrationKey(const Value* value) {
+    return value->GetName().empty() ? "value_" + std::to_string(value->GetId()) : value->GetName();
+}
+
+Status CalibrationRunner::Run(const Graph& graph,
+                              const std::vector<std::vector<std::shared_ptr<Tensor>>>& dataset,
+                              CalibrationTable* table) const {
+    if (!table) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Calibration table is null");
+    }
+    if (dataset.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Calibration dataset is empty");
+    }
+    if (options_.calibration_method != CalibrationMethod::MIN_MAX && options_.num_histogram_bins < 1) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "num_histogram_bins must be positive");
+    }
+    
+    // 在副本上把需要观测的激活加为图输出；观测值是图输入时直接读取样本
+    Graph calibration_graph = graph.Clone();
+    const auto& graph_inputs = calibration_graph.GetInputs();
+    struct Observation {
+        std::string key;
+        int input_index = -1;
+        int output_index = -1;
+    };
+    std::vector<Observation> observations;
+    std::unordered_set<Value*> observed;
+    for (Node* node : calibration_graph.TopologicalSort()) {
+        if (!IsQuantizable(calibration_graph, *node, options_)) {
+            continue;
+        }
+        for (Value* value : {node->GetInputs()[0], QuantizedOutput(calibration_graph, node)}) {
+            if (!observed.insert(value).second) {
+                continue;
+            }
+            Observation observation;
+            observation.key = CalibrationKey(value);
+            auto input_it = std::find(graph_inputs.begin(), graph_inputs.end(), value);
+            if (input_it != graph_inputs.end()) {
+                observation.input_index = static_cast<int>(input_it - graph_inputs.begin());
+            } else {
+                const auto& outputs = calibration_graph.GetOutputs();
+                auto output_it = std::find(outputs.begin(), outputs.end(), value);
+                if (output_it == outputs.end()) {
+                    calibration_graph.AddOutput(value);
+                    output_it = calibration_graph.GetOutputs().end() - 1;
+                }
+                observation.output_index = static_cast<int>(output_it - calibration_graph.GetOutputs().begin());
+            }
+            observations.push_back(observation);
+        }
+    }
+    table->clear();
+    if (observations.empty()) {
+        return Status::Ok();
+    }
+    
+    SessionOptions session_options;
+    session_options.execution_providers = {"CPUExecutionProvider"};
+    session_options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(session_options);
+    if (!session) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to create calibration session");
+    }
+    Status status = session->LoadModelFromGraph(std::make_unique<Graph>(std::move(calibration_graph)));
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 对每个样本执行一次，把各观测值交给visit
+    std::vector<ActivationStats> stats(observations.size());
+    auto run_dataset = [&](const std::function<void(ActivationStats*, const Tensor&)>& visit) -> Status {
+        for (const auto& sample : dataset) {
+            std::vector<Tensor*> inputs;
+            for (const auto& tensor : sample) {
+                inputs.push_back(tensor.get());
+            }
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            Status run_status = session->Run(inputs, outputs);
+            if (!run_status.IsOk()) {
+                return run_status;
+            }
+            for (size_t i = 0; i < observations.size(); ++i) {
+                const Observation& observation = observations[i];
+                const Tensor* tensor = observation.input_index >= 0
+                    ? (static_cast<size_t>(observation.input_index) < sample.size()
+                           ? sample[observation.input_index].get() : nullptr)
+                    : (static_cast<size_t>(observation.output_index) < outputs.size()
+                           ? outputs[observation.output_index].get() : nullptr);
+                if (!tensor || tensor->GetDataType() != DataType::FLOAT32) {
+                    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                       "Calibration value is missing or not FLOAT32: " + observation.key);
+                }
+                visit(&stats[i], *tensor);
+            }
+        }
+        return Status::Ok();
+    };
+    
+    status = run_dataset([](ActivationStats* s, const Tensor& t) {
+        UpdateRange(static_cast<const float*>(t.GetData()), t.GetElementCount(), s);
+    });
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    const bool entropy = options_.calibration_method == CalibrationMethod::ENTROPY;
+    if (options_.calibration_method != CalibrationMethod::MIN_MAX) {
+        for (ActivationStats& s : stats) {
+            s.hist_lo = entropy ? 0.0f : s.min;
+            s.hist_hi = entropy ? std::max(std::fabs(s.min), std::fabs(s.max)) : s.max;
+            s.histogram.assign(static_cast<size_t>(options_.num_histogram_bins), 0.0);
+        }
+        status = run_dataset([entropy](ActivationStats* s, const Tensor& t) {
+            UpdateHistogram(static_cast<const float*>(t.GetData()), t.GetElementCount(), entropy, s);
+        });
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    
+    for (size_t i = 0; i < observations.size(); ++i) {
+        const ActivationStats& s = stats[i];
+        TensorRange range{s.min, s.max};
+        if (options_.calibration_method == CalibrationMethod::PERCENTILE) {
+            range = PercentileRange(s, options_.percentile);
+        } else if (entropy) {
+            const float threshold = EntropyThreshold(s);
+            range.min = std::max(s.min, -threshold);
+            range.max = std::min(s.max, threshold);
+        }
+        range.min = std::min(range.min, 0.0f);
+        range.max = std::max(range.max, 0.0f);
+        (*table)[observations[i].key] = range;
+    }
+    return Status::Ok();
+}
+
+Status QuantizeGraph(Graph* graph, const CalibrationTable& table, const QuantizationOptions& options) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    int32_t qmin = 0, qmax = 0;
+    if (!GetQuantizedRange(options.activation_dtype, &qmin, &qmax)) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Quantization only supports INT8 or UINT8 activations");
+    }
+    
+    QDQInserter inserter(graph, options);
+    int quantized_nodes = 0;
+    for (Node* node : graph->TopologicalSort()) {
+        if (!IsQuantizable(*graph, *node, options)) {
+            continue;
+        }
+        Value* x = node->GetInputs()[0];
+        Value* y = QuantizedOutput(*graph, node);
+        auto x_range = table.find(CalibrationKey(x));
+        auto y_range = table.find(CalibrationKey(y));
+        // 输入已由前一层的DQ给出时不需要它的校准范围
+        const bool x_quantized = x->GetProducer() && x->GetProducer()->GetOpType() == "DequantizeLinear";
+        if ((!x_quantized && x_range == table.end()) || y_range == table.end()) {
+            continue;
+        }
+        
+        Value* weight = node->GetInputs()[1];
+        node->ReplaceInput(weight, inserter.QuantizeWeight(weight, node->GetOpType() == "Conv" ? 0 : 1));
+        if (weight->GetConsumers().empty()) {
+            graph->RemoveValue(weight);
+        }
+        if (!x_quantized) {
+            node->ReplaceInput(x, inserter.QuantizeActivation(x, x_range->second));
+        }
+        inserter.QuantizeOutput(y, y_range->second);
+        ++quantized_nodes;
+    }
+    LOG_INFO("Quantized " + std::to_string(quantized_nodes) + " nodes");
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,210 @@
+#include "inferunity/result_cache.h"
+#include "inferunity/metrics.h"
+#include <cstring>
+
+namespace inferunity {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline uint64_t Rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t Read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    return Rotl(acc, 31) * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t value) {
+    acc ^= Round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // anonymous namespace
+
+uint64_t XXHash64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        // 四路独立的累加器，每个周期各吸收8字节
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+        h = MergeRound(h, v1);
+        h = MergeRound(h, v2);
+        h = MergeRound(h, v3);
+        h = MergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<uint64_t>(size);
+    
+    for (; p + 8 <= end; p += 8) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+        h = Rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<uint64_t>(*p) * kPrime5;
+        h = Rotl(h, 11) * kPrime1;
+    }
+    
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+ResultCache::ResultCache(const ResultCacheOptions& options) : options_(options) {}
+
+bool ResultCache::ComputeKey(const std::vector<Tensor*>& inputs, uint64_t* key) {
+    // 逐个输入链式哈希：元数据与数据字节各一段，上一段的结果作为下一段的种子
+    const uint64_t count = inputs.size();
+    uint64_t hash = XXHash64(&count, sizeof(count));
+    for (const Tensor* input : inputs) {
+        if (!input || input->GetDeviceType() != DeviceType::CPU || !input->IsContiguous()) {
+            return false;
+        }
+        const size_t bytes = input->GetSizeInBytes();
+        if (bytes > 0 && !input->GetData()) {
+            return false;
+        }
+        const std::vector<int64_t>& dims = input->GetShape().dims;
+        const int64_t dtype = static_cast<int64_t>(input->GetDataType());
+        hash = XXHash64(&dtype, sizeof(dtype), hash);
+        hash = XXHash64(dims.data(), dims.size() * sizeof(int64_t), hash);
+        hash = XXHash64(input->GetData(), bytes, hash);
+    }
+    *key = hash;
+    return true;
+}
+
+bool ResultCache::Lookup(uint64_t key, std::vector<std::shared_ptr<Tensor>>* outputs) {
+    std::vector<std::shared_ptr<Tensor>> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            ++stats_.misses;
+            return false;
+        }
+        if (options_.ttl_ms > 0.0 &&
+            static_cast<double>(MetricNowNs() - it->second.inserted_ns) / 1e6 > options_.ttl_ms) {
+            EraseLocked(it);
+            ++stats_.expirations;
+            ++stats_.misses;
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        ++stats_.hits;
+        // 条目中的张量只读，拷贝在锁外进行
+        cached = it->second.outputs;
+    }
+    outputs->clear();
+    for (const auto& tensor : cached) {
+        auto copy = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::CPU);
+        if (!tensor->CopyTo(*copy).IsOk()) {
+            outputs->clear();
+            return false;
+        }
+        outputs->push_back(copy);
+    }
+    return true;
+}
+
+void ResultCache::Insert(uint64_t key, const std::vector<std::shared_ptr<Tensor>>& outputs) {
+    size_t bytes = 0;
+    for (const auto& tensor : outputs) {
+        if (!tensor || tensor->GetDeviceType() != DeviceType::CPU) {
+            return;
+        }
+        bytes += tensor->GetSizeInBytes();
+    }
+    if (bytes > options_.capacity_bytes) {
+        return;
+    }
+    Entry entry;
+    entry.bytes = bytes;
+    for (const auto& tensor : outputs) {
+        auto copy = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::CPU);
+        if (!tensor->CopyTo(*copy).IsOk()) {
+            return;
+        }
+        entry.outputs.push_back(copy);
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto existing = entries_.find(key);
+    if (existing != entries_.end()) {
+        // 并发的相同请求都未命中时各自插入，保留较新的一份
+        EraseLocked(existing);
+    }
+    while (!lru_.empty() && stats_.bytes + bytes > options_.capacity_bytes) {
+        EraseLocked(entries_.find(lru_.back()));
+        ++stats_.evictions;
+    }
+    entry.inserted_ns = MetricNowNs();
+    lru_.push_front(key);
+    entry.lru = lru_.begin();
+    entries_.emplace(key, std::move(entry));
+    stats_.bytes += bytes;
+    stats_.entries = entries_.size();
+    ++stats_.insertions;
+}
+
+void ResultCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+ResultCacheStats ResultCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ResultCache::EraseLocked(std::unordered_map<uint64_t, Entry>::iterator it) {
+    stats_.bytes -= it->second.bytes;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+    stats_.entries = entries_.size();
+}
+
+} // namespace inferunity
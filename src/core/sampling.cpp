@@ -0,0 +1,51 @@
+// 采样头的图改写
+
+#include "inferunity/sampling.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+
+namespace inferunity {
+
+Status AppendSamplingHead(Graph* graph, const SamplingOptions& options, const std::string& logits_name) {
+    if (!graph || graph->GetOutputs().empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Sampling head needs a graph with outputs");
+    }
+    if (options.top_k < 0 || options.top_p <= 0.0f || options.repetition_penalty <= 0.0f) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Sampling head needs top_k >= 0, top_p > 0 and repetition_penalty > 0");
+    }
+    const auto& outputs = graph->GetOutputs();
+    Value* logits = outputs.front();
+    if (!logits_name.empty()) {
+        auto it = std::find_if(outputs.begin(), outputs.end(),
+                               [&](const Value* output) { return output->GetName() == logits_name; });
+        if (it == outputs.end()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph has no output: " + logits_name);
+        }
+        logits = *it;
+    }
+    
+    Node* node = graph->AddNode("Sampling", "sampling_head");
+    node->SetAttribute("temperature", AttributeValue(options.temperature));
+    node->SetAttribute("top_k", AttributeValue(options.top_k));
+    node->SetAttribute("top_p", AttributeValue(options.top_p));
+    node->SetAttribute("repetition_penalty", AttributeValue(options.repetition_penalty));
+    node->SetAttribute("seed", AttributeValue(static_cast<int64_t>(options.seed)));
+    node->AddInput(logits);
+    if (options.repetition_penalty != 1.0f) {
+        Value* past = graph->AddValue();
+        past->SetName("past_tokens");
+        const int64_t batch = logits->GetShape().dims.empty() ? 1 : logits->GetShape().dims.front();
+        past->SetTensor(std::make_shared<Tensor>(Shape({batch, -1}), DataType::INT64, nullptr));
+        graph->AddInput(past);
+        node->AddInput(past);
+    }
+    Value* tokens = graph->AddValue();
+    tokens->SetName("next_tokens");
+    node->AddOutput(tokens);
+    graph->ReplaceOutput(logits, tokens);
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -1,15 +1,56 @@
 // 形状推断系统实现
-// 参考ONNX Runtime的形状推断实现
+// 参考ONNX Runtime的形状推断实现与SymbolicShapeInference的符号维度传播
+//
+// 不为每个算子单独编写符号规则，而是用两次探测复用算子的InferOutputInfo（只传元数据，不分配张量）：
+// 每个符号在两次探测中分别取两组互不相同的大素数，对每个输出维度，
+// 两次结果相同的是静态维度；否则按各符号的素数分解，两次得到相同的系数与符号指数时
+// 即为符号与整数的乘积（如2*batch*seq），其余（如batch+1、seq/2）记为未知
 
+#include "inferunity/shape_inference.h"
 #include "inferunity/graph.h"
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
-#include <queue>
-#include <unordered_set>
+#include <cctype>
+#include <memory>
 #include <unordered_map>
 
 namespace inferunity {
 
+namespace {
+
+// 两次探测的素数区间互不重叠，且远大于模型中常见的静态维度
+constexpr int64_t kProbePrimeStart[2] = {10007, 20011};
+
+bool IsPrime(int64_t n) {
+    if (n < 2) return false;
+    for (int64_t d = 2; d * d <= n; ++d) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+std::vector<int64_t> ProbePrimes(int64_t start, size_t count) {
+    std::vector<int64_t> primes;
+    for (int64_t n = start; primes.size() < count; ++n) {
+        if (IsPrime(n)) {
+            primes.push_back(n);
+        }
+    }
+    return primes;
+}
+
+bool IsDynamicDim(const Shape& shape, size_t i) {
+    return shape.dims[i] < 0 || (i < shape.is_dynamic.size() && shape.is_dynamic[i]);
+}
+
+// 只有形状、不分配内存的张量
+std::shared_ptr<Tensor> MakeShapeTensor(const Shape& shape, DataType dtype) {
+    return CreateTensorFromData(shape, dtype, nullptr);
+}
+
+// 一次探测中各Value的元数据；不在表中表示形状未知
+using ProbeTensors = std::unordered_map<const Value*, TensorInfo>;
+
 // 形状推断器（参考ONNX Runtime的ShapeInference类）
 class ShapeInference {
 public:
@@ -18,45 +59,127 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
         }
         
+        const std::vector<std::string> symbols = CollectSymbols(graph);
+        
         // 拓扑排序
-        std::vector<Node*> nodes = graph->TopologicalSort();
+        std::vector<Node*> nodes = graph->GetTopologicalOrder();
+        
+        Status first_error = Status::Ok();
+        std::vector<int64_t> primes[2];
+        ProbeTensors probes[2];
+        for (int run = 0; run < 2; ++run) {
+            primes[run] = ProbePrimes(kProbePrimeStart[run], symbols.size());
+            Status status = Probe(graph, nodes, symbols, primes[run], &probes[run]);
+            if (first_error.IsOk() && !status.IsOk()) {
+                first_error = status;
+            }
+        }
         
-        // 为每个节点推断输出形状
         for (Node* node : nodes) {
-            Status status = InferNode(node);
-            if (!status.IsOk()) {
-                return status;
+            for (Value* output : node->GetOutputs()) {
+                auto known = output->GetTensor();
+                // 已有数据的张量（如常量折叠或内存规划的结果）保持不变
+                if (known && known->GetData()) {
+                    continue;
+                }
+                auto it0 = probes[0].find(output);
+                auto it1 = probes[1].find(output);
+                Shape merged;
+                if (it0 == probes[0].end() || it1 == probes[1].end() ||
+                    !MergeShapes(it0->second.shape, it1->second.shape, symbols, primes, &merged)) {
+                    continue;
+                }
+                output->SetTensor(MakeShapeTensor(merged, it0->second.dtype));
             }
         }
         
-        return Status::Ok();
+        return first_error;
     }
-    
+
 private:
-    static Status InferNode(Node* node) {
+    // 图输入的动态维度即为符号：沿用模型给出的名称（ONNX的dim_param），未命名的记为"<输入名>_dim<i>"；
+    // 同名符号在所有输入中取相同的值
+    static std::vector<std::string> CollectSymbols(Graph* graph) {
+        std::vector<std::string> symbols;
+        std::unordered_map<std::string, size_t> index;
+        for (Value* input : graph->GetInputs()) {
+            auto tensor = input->GetTensor();
+            if (!tensor || tensor->GetData()) {
+                continue;
+            }
+            Shape shape = tensor->GetShape();
+            shape.is_dynamic.resize(shape.dims.size(), false);
+            shape.symbols.resize(shape.dims.size());
+            for (size_t i = 0; i < shape.dims.size(); ++i) {
+                if (!IsDynamicDim(shape, i)) {
+                    shape.symbols[i].clear();
+                    continue;
+                }
+                shape.dims[i] = -1;
+                shape.is_dynamic[i] = true;
+                if (shape.symbols[i].empty()) {
+                    shape.symbols[i] = input->GetName() + "_dim" + std::to_string(i);
+                }
+                if (index.emplace(shape.symbols[i], symbols.size()).second) {
+                    symbols.push_back(shape.symbols[i]);
+                }
+            }
+            input->SetTensor(MakeShapeTensor(shape, tensor->GetDataType()));
+        }
+        return symbols;
+    }
+    
+    // 以primes[k]作为第k个符号的取值，按拓扑序推断一次所有节点的输出形状
+    static Status Probe(Graph* graph, const std::vector<Node*>& nodes, const std::vector<std::string>& symbols,
+                        const std::vector<int64_t>& primes, ProbeTensors* tensors) {
+        std::unordered_map<std::string, int64_t> values;
+        for (size_t k = 0; k < symbols.size(); ++k) {
+            values[symbols[k]] = primes[k];
+        }
+        for (Value* input : graph->GetInputs()) {
+            auto tensor = input->GetTensor();
+            if (!tensor) {
+                continue;
+            }
+            Shape shape = tensor->GetShape();
+            for (size_t i = 0; i < shape.dims.size(); ++i) {
+                if (IsDynamicDim(shape, i)) {
+                    shape.dims[i] = values[shape.symbols[i]];
+                }
+            }
+            (*tensors)[input] = TensorInfo{Shape(shape.dims), tensor->GetDataType(), nullptr};
+        }
+        // 常量带上真实张量，Reshape等算子需要读取其中的数据
+        for (const auto& value : graph->GetValues()) {
+            const Tensor* tensor = value->GetTensor().get();
+            if (!value->GetProducer() && tensor && tensor->GetData() && !tensors->count(value.get())) {
+                (*tensors)[value.get()] = TensorInfo{tensor->GetShape(), tensor->GetDataType(), tensor};
+            }
+        }
+        
+        Status first_error = Status::Ok();
+        for (Node* node : nodes) {
+            Status status = InferNode(node, tensors);
+            if (first_error.IsOk() && !status.IsOk()) {
+                first_error = status;
+            }
+        }
+        return first_error;
+    }
+    
+    static Status InferNode(Node* node, ProbeTensors* tensors) {
         if (!node) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node is null");
         }
         
-        // 准备输入张量（用于形状推断）
-        std::vector<Tensor*> input_tensors;
+        // 准备输入描述（用于形状推断）；有输入形状未知时输出也未知
+        std::vector<TensorInfo> input_infos;
         for (Value* input : node->GetInputs()) {
-            if (input->GetTensor()) {
-                input_tensors.push_back(input->GetTensor().get());
-            } else {
-                // 如果没有张量，创建一个虚拟张量用于形状推断
-                // 使用Value的形状信息
-                const Shape& shape = input->GetShape();
-                if (!shape.dims.empty()) {
-                    // 创建临时张量用于形状推断
-                    auto temp_tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
-                    input_tensors.push_back(temp_tensor.get());
-                }
+            auto it = tensors->find(input);
+            if (it == tensors->end()) {
+                return Status::Ok();
             }
-        }
-        
-        if (input_tensors.empty()) {
-            return Status::Ok();  // 没有输入，跳过
+            input_infos.push_back(it->second);
         }
         
         // 创建算子并推断输出形状
@@ -65,34 +188,200 @@ private:
             // 算子未注册，跳过形状推断
             return Status::Ok();
         }
+        ApplyNodeAttributes(*node, op.get());
         
-        std::vector<Shape> output_shapes;
-        Status status = op->InferOutputShape(input_tensors, output_shapes);
+        std::vector<TensorInfo> output_infos;
+        Status status = op->InferOutputInfo(input_infos, output_infos);
         if (!status.IsOk()) {
-            return status;
+            return Status::Error(status.Code(),
+                               "Shape inference failed for node " + node->GetName() + ": " + status.Message());
         }
         
-        // 设置输出Value的形状
         const auto& outputs = node->GetOutputs();
-        for (size_t i = 0; i < outputs.size() && i < output_shapes.size(); ++i) {
-            Value* output = outputs[i];
-            // 更新Value的形状信息（如果Value没有张量）
-            if (!output->GetTensor()) {
-                // 可以通过设置Shape到Value（需要扩展Value接口）
-                // 这里简化：创建临时张量
-                auto tensor = CreateTensor(output_shapes[i], DataType::FLOAT32, DeviceType::CPU);
-                output->SetTensor(tensor);
-            }
+        for (size_t i = 0; i < outputs.size() && i < output_infos.size(); ++i) {
+            (*tensors)[outputs[i]] = TensorInfo{Shape(output_infos[i].shape.dims), output_infos[i].dtype, nullptr};
         }
-        
         return Status::Ok();
     }
+    
+    // 把维度按各符号的素数分解为 系数 × Π符号^指数
+    static bool Factor(int64_t dim, const std::vector<int64_t>& primes,
+                       int64_t* coefficient, std::vector<int>* exponents) {
+        if (dim <= 0) {
+            return false;
+        }
+        exponents->assign(primes.size(), 0);
+        for (size_t k = 0; k < primes.size(); ++k) {
+            while (dim % primes[k] == 0) {
+                dim /= primes[k];
+                ++(*exponents)[k];
+            }
+        }
+        *coefficient = dim;
+        return true;
+    }
+    
+    static bool MergeShapes(const Shape& first, const Shape& second, const std::vector<std::string>& symbols,
+                            const std::vector<int64_t> (&primes)[2], Shape* merged) {
+        // 秩依赖于符号取值时整个形状未知
+        if (first.dims.size() != second.dims.size()) {
+            return false;
+        }
+        const size_t rank = first.dims.size();
+        merged->dims.assign(rank, -1);
+        merged->is_dynamic.assign(rank, true);
+        merged->symbols.assign(rank, std::string());
+        for (size_t i = 0; i < rank; ++i) {
+            const int64_t d0 = first.dims[i];
+            const int64_t d1 = second.dims[i];
+            if (d0 == d1) {
+                if (d0 >= 0) {
+                    merged->dims[i] = d0;
+                    merged->is_dynamic[i] = false;
+                }
+                continue;
+            }
+            int64_t c0 = 0, c1 = 0;
+            std::vector<int> e0, e1;
+            if (!Factor(d0, primes[0], &c0, &e0) || !Factor(d1, primes[1], &c1, &e1) ||
+                c0 != c1 || e0 != e1) {
+                continue;
+            }
+            std::string expr = c0 != 1 ? std::to_string(c0) : std::string();
+            for (size_t k = 0; k < e0.size(); ++k) {
+                for (int n = 0; n < e0[k]; ++n) {
+                    expr += (expr.empty() ? "" : "*") + symbols[k];
+                }
+            }
+            merged->symbols[i] = expr;
+        }
+        return true;
+    }
 };
 
+} // anonymous namespace
+
+Status Operator::InferOutputInfo(const std::vector<TensorInfo>& inputs,
+                                 std::vector<TensorInfo>& outputs) const {
+    // 不带数据的张量只记录形状与类型，构造时不分配内存；常量输入直接使用其张量
+    std::vector<std::unique_ptr<Tensor>> descriptors;
+    std::vector<Tensor*> tensors;
+    for (const TensorInfo& info : inputs) {
+        if (info.constant) {
+            tensors.push_back(const_cast<Tensor*>(info.constant));
+            continue;
+        }
+        descriptors.push_back(std::make_unique<Tensor>(info.shape, info.dtype, nullptr));
+        tensors.push_back(descriptors.back().get());
+    }
+    std::vector<Shape> shapes;
+    Status status = InferOutputShape(tensors, shapes);
+    if (!status.IsOk()) {
+        return status;
+    }
+    outputs.clear();
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        outputs.push_back(TensorInfo{shapes[i], InferOutputDataType(tensors, i), nullptr});
+    }
+    return Status::Ok();
+}
+
 // 全局形状推断函数
 Status InferShapes(Graph* graph) {
     return ShapeInference::InferGraph(graph);
 }
 
-} // namespace inferunity
+bool HasSymbolicInputs(const Graph& graph) {
+    for (const Value* input : graph.GetInputs()) {
+        auto tensor = input->GetTensor();
+        if (!tensor || tensor->GetData()) {
+            continue;
+        }
+        const Shape& shape = tensor->GetShape();
+        for (size_t i = 0; i < shape.dims.size(); ++i) {
+            if (IsDynamicDim(shape, i)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int64_t EvaluateSymbolicDim(const std::string& expr, const ShapeSymbolBindings& bindings) {
+    if (expr.empty()) {
+        return -1;
+    }
+    int64_t value = 1;
+    size_t begin = 0;
+    while (begin <= expr.size()) {
+        size_t end = expr.find('*', begin);
+        if (end == std::string::npos) {
+            end = expr.size();
+        }
+        const std::string token = expr.substr(begin, end - begin);
+        if (token.empty()) {
+            return -1;
+        }
+        if (std::isdigit(static_cast<unsigned char>(token[0]))) {
+            value *= std::stoll(token);
+        } else {
+            auto it = bindings.find(token);
+            if (it == bindings.end()) {
+                return -1;
+            }
+            value *= it->second;
+        }
+        begin = end + 1;
+    }
+    return value;
+}
+
+bool ResolveSymbolicShape(const Shape& shape, const ShapeSymbolBindings& bindings, Shape* resolved) {
+    std::vector<int64_t> dims = shape.dims;
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (!IsDynamicDim(shape, i)) {
+            continue;
+        }
+        dims[i] = i < shape.symbols.size() ? EvaluateSymbolicDim(shape.symbols[i], bindings) : -1;
+        if (dims[i] < 0) {
+            return false;
+        }
+    }
+    *resolved = Shape(dims);
+    return true;
+}
+
+Status BindShapeSymbols(const Graph& graph, const std::vector<Tensor*>& inputs,
+                        ShapeSymbolBindings* bindings) {
+    const auto& graph_inputs = graph.GetInputs();
+    if (inputs.size() != graph_inputs.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Input count mismatch: expected " + std::to_string(graph_inputs.size()) +
+                           ", got " + std::to_string(inputs.size()));
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto declared = graph_inputs[i]->GetTensor();
+        if (!declared || !inputs[i]) {
+            continue;
+        }
+        const Shape& shape = declared->GetShape();
+        const std::vector<int64_t>& actual = inputs[i]->GetShape().dims;
+        if (shape.dims.size() != actual.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Rank mismatch for input " + graph_inputs[i]->GetName());
+        }
+        for (size_t d = 0; d < actual.size(); ++d) {
+            if (!IsDynamicDim(shape, d) || d >= shape.symbols.size() || shape.symbols[d].empty()) {
+                continue;
+            }
+            auto result = bindings->emplace(shape.symbols[d], actual[d]);
+            if (!result.second && result.first->second != actual[d]) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Conflicting values for shape symbol " + shape.symbols[d]);
+            }
+        }
+    }
+    return Status::Ok();
+}
 
+} // namespace inferunity
@@ -0,0 +1,294 @@
+// 投机解码实现
+// 参考Leviathan et al.的Algorithm 1：draft逐个提出k个token，目标模型一次前向验证，
+// 逐位置接受-拒绝，拒绝处从残差分布max(0, p - q)重新采样，全部接受时额外采样一个token；
+// 被拒绝位置之后的KV cache用KVCache::Trim回退
+
+#include "inferunity/speculative_decoding.h"
+#include "inferunity/engine.h"
+#include "inferunity/kv_cache.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace inferunity {
+
+namespace {
+
+constexpr int64_t kSequence = 0;
+
+// 按uniform * sum(weights)落在的累积区间取下标；weights全为0时返回-1
+int64_t SampleFromWeights(const std::vector<float>& weights, float uniform) {
+    double total = 0.0;
+    for (float w : weights) {
+        total += std::max(w, 0.0f);
+    }
+    if (total <= 0.0) {
+        return -1;
+    }
+    const double target = static_cast<double>(uniform) * total;
+    double cumulative = 0.0;
+    int64_t last = -1;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        if (weights[i] <= 0.0f) {
+            continue;
+        }
+        cumulative += weights[i];
+        last = static_cast<int64_t>(i);
+        if (target < cumulative) {
+            return last;
+        }
+    }
+    return last;  // 舍入误差落在最后
+}
+
+} // anonymous namespace
+
+bool SpeculativeAcceptToken(const std::vector<float>& target_probs, const std::vector<float>& draft_probs,
+                            int64_t draft_token, float uniform, float resample_uniform, int64_t* token) {
+    const int64_t vocab = static_cast<int64_t>(target_probs.size());
+    const bool valid = draft_token >= 0 && draft_token < vocab &&
+                       draft_probs.size() == target_probs.size();
+    if (valid) {
+        const float q = draft_probs[static_cast<size_t>(draft_token)];
+        const float p = target_probs[static_cast<size_t>(draft_token)];
+        // 以min(1, p / q)的概率接受
+        if (q > 0.0f && uniform * q < p) {
+            *token = draft_token;
+            return true;
+        }
+    }
+    std::vector<float> residual(target_probs.size());
+    for (size_t i = 0; i < residual.size(); ++i) {
+        residual[i] = target_probs[i] - (valid ? draft_probs[i] : 0.0f);
+    }
+    int64_t sampled = SampleFromWeights(residual, resample_uniform);
+    if (sampled < 0) {
+        // p与q（数值上）相同时残差为0，此时直接按p采样
+        sampled = SampleFromWeights(target_probs, resample_uniform);
+    }
+    *token = std::max<int64_t>(sampled, 0);
+    return false;
+}
+
+SpeculativeDecoder::SpeculativeDecoder(InferenceSession* target, InferenceSession* draft,
+                                       const SpeculativeDecodingOptions& options)
+    : target_(target), draft_(draft), options_(options), rng_(options.seed) {
+}
+
+Status SpeculativeDecoder::Generate(const std::vector<int64_t>& prompt, std::vector<int64_t>* generated) {
+    if (!target_ || !draft_ || !generated) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Speculative decoding needs target and draft sessions");
+    }
+    KVCache* target_cache = target_->GetKVCache();
+    KVCache* draft_cache = draft_->GetKVCache();
+    if (!target_cache || !draft_cache) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Speculative decoding requires SessionOptions::enable_kv_cache on both sessions");
+    }
+    if (prompt.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Speculative decoding needs a non-empty prompt");
+    }
+    generated->clear();
+    Status status = target_cache->Reset(kSequence);
+    if (status.IsOk()) {
+        status = draft_cache->Reset(kSequence);
+    }
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 已确定、尚未进入各自cache的token
+    std::vector<int64_t> target_pending = prompt;
+    std::vector<int64_t> draft_pending = prompt;
+    std::vector<std::vector<float>> logits;
+    const int64_t max_new_tokens = options_.max_new_tokens;
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    
+    while (static_cast<int64_t>(generated->size()) < max_new_tokens) {
+        const int64_t target_past = target_cache->GetSequenceLength(kSequence);
+        const int64_t draft_past = draft_cache->GetSequenceLength(kSequence);
+        const int64_t target_room = target_cache->GetCapacity() - target_past -
+                                    static_cast<int64_t>(target_pending.size());
+        if (target_room < 0) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Speculative decoding exceeds the KV cache capacity");
+        }
+        // 本轮的draft数：至少留一个位置给目标模型采样的token；draft只需缓存前k - 1个
+        int64_t k = std::min({options_.num_draft_tokens,
+                              max_new_tokens - static_cast<int64_t>(generated->size()) - 1, target_room});
+        const int64_t draft_room = draft_cache->GetCapacity() - draft_past -
+                                   static_cast<int64_t>(draft_pending.size());
+        k = draft_room < 0 ? 0 : std::max<int64_t>(std::min(k, draft_room + 1), 0);
+    
+        std::vector<int64_t> drafts;
+        std::vector<std::vector<float>> draft_probs;
+        std::vector<int64_t> feed = draft_pending;
+        for (int64_t i = 0; i < k; ++i) {
+            status = Forward(draft_, feed, draft_cache->GetSequenceLength(kSequence), &logits);
+            if (!status.IsOk()) {
+                return status;
+            }
+            ++stats_.num_draft_runs;
+            draft_probs.push_back(Distribution(logits.back()));
+            drafts.push_back(Sample(draft_probs.back()));
+            feed.assign(1, drafts.back());
+        }
+    
+        // 目标模型一次前向：logits第base + i行是第i个draft位置的分布，第base + k行用于额外的token
+        std::vector<int64_t> verify = target_pending;
+        verify.insert(verify.end(), drafts.begin(), drafts.end());
+        status = Forward(target_, verify, target_past, &logits);
+        if (!status.IsOk()) {
+            return status;
+        }
+        ++stats_.num_rounds;
+        const size_t base = target_pending.size() - 1;
+        if (!drafts.empty() && logits.front().size() != draft_probs.front().size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Target and draft models have different vocabularies");
+        }
+        int64_t accepted = 0;
+        int64_t next = 0;
+        bool rejected = false;
+        for (int64_t i = 0; i < k && !rejected; ++i) {
+            const std::vector<float> probs = Distribution(logits[base + static_cast<size_t>(i)]);
+            const float u = uniform(rng_);
+            const float resample = uniform(rng_);
+            rejected = !SpeculativeAcceptToken(probs, draft_probs[static_cast<size_t>(i)],
+                                               drafts[static_cast<size_t>(i)], u, resample, &next);
+            accepted += rejected ? 0 : 1;
+        }
+        if (!rejected) {
+            next = Sample(Distribution(logits[base + static_cast<size_t>(k)]));
+        }
+        stats_.num_proposed += static_cast<uint64_t>(k);
+        stats_.num_accepted += static_cast<uint64_t>(accepted);
+    
+        std::vector<int64_t> emitted(drafts.begin(), drafts.begin() + accepted);
+        emitted.push_back(next);
+        bool finished = false;
+        for (int64_t token : emitted) {
+            generated->push_back(token);
+            ++stats_.num_generated;
+            if (options_.eos_token >= 0 && token == options_.eos_token) {
+                finished = true;
+                break;
+            }
+        }
+        if (finished) {
+            break;
+        }
+    
+        // 回退被拒绝的位置：目标cache保留pending与被接受的draft，新采样的token下一轮再写入
+        status = target_cache->Trim(kSequence, target_past + static_cast<int64_t>(target_pending.size()) + accepted);
+        if (!status.IsOk()) {
+            return status;
+        }
+        target_pending.assign(1, next);
+        if (k > 0) {
+            // draft cache中只有pending与前k - 1个draft；全部接受时最后一个draft尚未写入
+            status = draft_cache->Trim(kSequence, draft_past + static_cast<int64_t>(draft_pending.size()) +
+                                                  std::min(accepted, k - 1));
+            if (!status.IsOk()) {
+                return status;
+            }
+            draft_pending.clear();
+            if (accepted == k) {
+                draft_pending.push_back(drafts.back());
+            }
+        }
+        draft_pending.push_back(next);
+    }
+    return Status::Ok();
+}
+
+Status SpeculativeDecoder::Forward(InferenceSession* session, const std::vector<int64_t>& tokens, int64_t past,
+                                   std::vector<std::vector<float>>* logits) {
+    const int64_t S = static_cast<int64_t>(tokens.size());
+    const std::vector<std::string> input_names = session->GetInputNames();
+    const std::string& ids_name = options_.input_ids_name.empty() && !input_names.empty()
+                                      ? input_names.front() : options_.input_ids_name;
+    std::vector<std::shared_ptr<Tensor>> owned;
+    std::vector<Tensor*> inputs;
+    for (const std::string& name : input_names) {
+        std::shared_ptr<Tensor> tensor;
+        if (name == ids_name) {
+            tensor = CreateTensor(Shape({1, S}), DataType::INT64, DeviceType::CPU);
+            std::copy(tokens.begin(), tokens.end(), static_cast<int64_t*>(tensor->GetData()));
+        } else if (name == "position_ids") {
+            tensor = CreateTensor(Shape({1, S}), DataType::INT64, DeviceType::CPU);
+            int64_t* positions = static_cast<int64_t*>(tensor->GetData());
+            for (int64_t i = 0; i < S; ++i) {
+                positions[i] = past + i;
+            }
+        } else if (name == "attention_mask") {
+            tensor = CreateTensor(Shape({1, past + S}), DataType::INT64, DeviceType::CPU);
+            std::fill_n(static_cast<int64_t*>(tensor->GetData()), past + S, static_cast<int64_t>(1));
+        } else {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Speculative decoding cannot feed model input: " + name);
+        }
+        if (!tensor) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate input: " + name);
+        }
+        inputs.push_back(tensor.get());
+        owned.push_back(std::move(tensor));
+    }
+    
+    std::vector<Tensor*> outputs;
+    Status status = session->Run(inputs, outputs);
+    if (!status.IsOk()) {
+        return status;
+    }
+    size_t index = 0;
+    if (!options_.logits_name.empty()) {
+        const std::vector<std::string> output_names = session->GetOutputNames();
+        index = static_cast<size_t>(std::find(output_names.begin(), output_names.end(), options_.logits_name) -
+                                    output_names.begin());
+    }
+    if (index >= outputs.size() || !outputs[index] || outputs[index]->GetDataType() != DataType::FLOAT32) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model has no FLOAT32 logits output");
+    }
+    const Tensor* output = outputs[index];
+    const std::vector<int64_t>& dims = output->GetShape().dims;
+    const int64_t vocab = dims.empty() ? 0 : dims.back();
+    if (vocab <= 0 || static_cast<int64_t>(output->GetElementCount()) != S * vocab) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Logits must be [1, S, vocab] or [S, vocab]");
+    }
+    const float* data = static_cast<const float*>(output->GetData());
+    logits->resize(static_cast<size_t>(S));
+    for (int64_t i = 0; i < S; ++i) {
+        (*logits)[static_cast<size_t>(i)].assign(data + i * vocab, data + (i + 1) * vocab);
+    }
+    return Status::Ok();
+}
+
+std::vector<float> SpeculativeDecoder::Distribution(const std::vector<float>& logits) const {
+    std::vector<float> probs(logits.size(), 0.0f);
+    if (logits.empty()) {
+        return probs;
+    }
+    if (options_.temperature <= 0.0f) {
+        probs[static_cast<size_t>(std::max_element(logits.begin(), logits.end()) - logits.begin())] = 1.0f;
+        return probs;
+    }
+    const float max_logit = *std::max_element(logits.begin(), logits.end());
+    double total = 0.0;
+    for (size_t i = 0; i < logits.size(); ++i) {
+        probs[i] = std::exp((logits[i] - max_logit) / options_.temperature);
+        total += probs[i];
+    }
+    for (float& p : probs) {
+        p = static_cast<float>(p / total);
+    }
+    return probs;
+}
+
+int64_t SpeculativeDecoder::Sample(const std::vector<float>& probs) {
+    if (options_.temperature <= 0.0f) {
+        return static_cast<int64_t>(std::max_element(probs.begin(), probs.end()) - probs.begin());
+    }
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    return std::max<int64_t>(SampleFromWeights(probs, uniform(rng_)), 0);
+}
+
+} // namespace inferunity
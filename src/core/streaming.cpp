@@ -0,0 +1,194 @@
+// 流式推理实现
+// 参考流式ASR/视频模型的cache输入输出约定（如WeNet/Zipformer导出的ONNX模型）：
+// 每个状态有两块会话持有的缓冲，当前值作为输入绑定，状态输出通过IOBinding绑定到另一块由算子直接写入，
+// 运行成功后交换；调用方每次只传入新的块，不再为重叠的窗口重新计算
+
+#include "inferunity/engine.h"
+
+namespace inferunity {
+
+namespace {
+
+int FindName(const std::vector<std::string>& names, const std::string& name) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+Status AllocateStateBuffers(const Shape& shape, DataType dtype, std::shared_ptr<Tensor>* current,
+                            std::shared_ptr<Tensor>* next) {
+    *current = CreateTensor(shape, dtype);
+    *next = CreateTensor(shape, dtype);
+    if (!*current || !(*current)->GetData() || !*next || !(*next)->GetData()) {
+        current->reset();
+        next->reset();
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate streaming state");
+    }
+    return (*current)->FillZero();
+}
+
+} // anonymous namespace
+
+Status InferenceSession::EnsureStreamingStates() {
+    if (!graph_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model not loaded");
+    }
+    if (options_.streaming_states.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Streaming requires SessionOptions::streaming_states");
+    }
+    if (streaming_binding_ && streaming_binding_->graph_ == graph_.get()) {
+        return Status::Ok();
+    }
+    
+    streaming_states_.clear();
+    streaming_binding_.reset();
+    const std::vector<std::string> input_names = GetInputNames();
+    const std::vector<std::string> output_names = GetOutputNames();
+    std::vector<StreamingState> states;
+    for (const auto& names : options_.streaming_states) {
+        StreamingState state;
+        state.input_index = FindName(input_names, names.first);
+        state.output_index = FindName(output_names, names.second);
+        if (state.input_index < 0) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown streaming state input: " + names.first);
+        }
+        if (state.output_index < 0) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown streaming state output: " + names.second);
+        }
+        for (const StreamingState& other : states) {
+            if (other.input_index == state.input_index || other.output_index == state.output_index) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Streaming state listed twice: " + names.first);
+            }
+        }
+        // 形状含动态维度时等SetStreamingState给出初值
+        const Value* value = graph_->GetInputs()[state.input_index];
+        if (value->GetTensor() && !value->GetShape().IsDynamic()) {
+            Status status = AllocateStateBuffers(value->GetShape(), value->GetDataType(),
+                                                 &state.current, &state.next);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        states.push_back(std::move(state));
+    }
+    streaming_states_ = std::move(states);
+    streaming_binding_ = CreateIOBinding();
+    return Status::Ok();
+}
+
+Status InferenceSession::RunStreaming(const std::vector<Tensor*>& inputs,
+                                      std::vector<std::shared_ptr<Tensor>>& outputs) {
+    outputs.clear();
+    std::lock_guard<std::mutex> lock(streaming_mutex_);
+    Status status = EnsureStreamingStates();
+    if (!status.IsOk()) {
+        return status;
+    }
+    IOBinding& binding = *streaming_binding_;
+    const size_t num_inputs = binding.input_names_.size();
+    const size_t num_outputs = binding.output_names_.size();
+    if (inputs.size() + streaming_states_.size() != num_inputs) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Expected " + std::to_string(num_inputs - streaming_states_.size()) +
+                           " non-state inputs, got " + std::to_string(inputs.size()));
+    }
+    
+    std::vector<bool> state_input(num_inputs, false);
+    std::vector<bool> state_output(num_outputs, false);
+    for (const StreamingState& state : streaming_states_) {
+        if (!state.current) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Streaming state has a dynamic shape; call SetStreamingState first: " +
+                               binding.input_names_[state.input_index]);
+        }
+        state_input[state.input_index] = true;
+        state_output[state.output_index] = true;
+        binding.inputs_[state.input_index] = state.current;
+        binding.bound_outputs_[state.output_index] = state.next;
+    }
+    size_t next_input = 0;
+    for (size_t i = 0; status.IsOk() && i < num_inputs; ++i) {
+        if (state_input[i]) {
+            continue;
+        }
+        // 调用方的输入只在本次Run内使用，以不持有所有权的别名绑定
+        std::shared_ptr<Tensor> input(std::shared_ptr<Tensor>(), inputs[next_input++]);
+        status = binding.BindInput(binding.input_names_[i], std::move(input));
+    }
+    if (status.IsOk()) {
+        status = Run(binding);
+    }
+    binding.ClearBoundInputs();
+    if (status.IsOk()) {
+        for (StreamingState& state : streaming_states_) {
+            std::swap(state.current, state.next);
+        }
+        for (size_t i = 0; i < num_outputs; ++i) {
+            if (!state_output[i]) {
+                outputs.push_back(std::move(binding.outputs_[i]));
+            }
+        }
+    }
+    binding.ClearBoundOutputs();
+    return status;
+}
+
+Status InferenceSession::ResetStreamingState() {
+    std::lock_guard<std::mutex> lock(streaming_mutex_);
+    Status status = EnsureStreamingStates();
+    if (!status.IsOk()) {
+        return status;
+    }
+    for (StreamingState& state : streaming_states_) {
+        if (state.current) {
+            status = state.current->FillZero();
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+    }
+    return Status::Ok();
+}
+
+std::shared_ptr<Tensor> InferenceSession::GetStreamingState(const std::string& input_name) {
+    std::lock_guard<std::mutex> lock(streaming_mutex_);
+    if (!EnsureStreamingStates().IsOk()) {
+        return nullptr;
+    }
+    for (const StreamingState& state : streaming_states_) {
+        if (streaming_binding_->input_names_[state.input_index] == input_name) {
+            return state.current;
+        }
+    }
+    return nullptr;
+}
+
+Status InferenceSession::SetStreamingState(const std::string& input_name, const Tensor& value) {
+    std::lock_guard<std::mutex> lock(streaming_mutex_);
+    Status status = EnsureStreamingStates();
+    if (!status.IsOk()) {
+        return status;
+    }
+    for (StreamingState& state : streaming_states_) {
+        if (streaming_binding_->input_names_[state.input_index] != input_name) {
+            continue;
+        }
+        // 形状或类型变化时换一对缓冲（动态形状的状态第一次给出初值）
+        if (!state.current || state.current->GetShape().dims != value.GetShape().dims ||
+            state.current->GetDataType() != value.GetDataType()) {
+            status = AllocateStateBuffers(value.GetShape(), value.GetDataType(), &state.current, &state.next);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return value.CopyTo(*state.current);
+    }
+    return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown streaming state: " + input_name);
+}
+
+} // namespace inferunity
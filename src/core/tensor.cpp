@@ -1,8 +1,11 @@
 #include "inferunity/tensor.h"
 #include "inferunity/memory.h"
+#include "inferunity/data_transfer.h"
+#include "inferunity/tensor_wire.h"
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <functional>
 
 namespace inferunity {
 
@@ -34,7 +37,9 @@ Tensor::Tensor(Tensor&& other) noexcept
       layout_(other.layout_),
       data_(other.data_),
       owns_data_(other.owns_data_),
-      allocator_(std::move(other.allocator_)) {
+      strides_(std::move(other.strides_)),
+      allocator_(other.allocator_),
+      allocator_owner_(std::move(other.allocator_owner_)) {
     other.data_ = nullptr;
     other.owns_data_ = false;
 }
@@ -48,7 +53,9 @@ Tensor& Tensor::operator=(Tensor&& other) noexcept {
         layout_ = other.layout_;
         data_ = other.data_;
         owns_data_ = other.owns_data_;
-        allocator_ = std::move(other.allocator_);
+        strides_ = std::move(other.strides_);
+        allocator_ = other.allocator_;
+        allocator_owner_ = std::move(other.allocator_owner_);
         other.data_ = nullptr;
         other.owns_data_ = false;
     }
@@ -63,6 +70,7 @@ size_t Tensor::GetDataTypeSize(DataType dtype) {
     switch (dtype) {
         case DataType::FLOAT32: return 4;
         case DataType::FLOAT16: return 2;
+        case DataType::BFLOAT16: return 2;
         case DataType::INT32: return 4;
         case DataType::INT64: return 8;
         case DataType::INT8: return 1;
@@ -71,6 +79,87 @@ size_t Tensor::GetDataTypeSize(DataType dtype) {
     }
 }
 
+namespace {
+
+std::vector<int64_t> ContiguousStrides(const std::vector<int64_t>& dims) {
+    std::vector<int64_t> strides(dims.size());
+    int64_t stride = 1;
+    for (int i = static_cast<int>(dims.size()) - 1; i >= 0; --i) {
+        strides[i] = stride;
+        stride *= std::max<int64_t>(dims[i], 1);
+    }
+    return strides;
+}
+
+// 按行主序遍历dims，把src中以strides排布的元素依次写入连续的dst；最内维步长为1时整行拷贝
+void GatherStrided(const uint8_t* src, uint8_t* dst, const std::vector<int64_t>& dims,
+                   const std::vector<int64_t>& strides, size_t element_size) {
+    const int rank = static_cast<int>(dims.size());
+    if (rank == 0) {
+        std::memcpy(dst, src, element_size);
+        return;
+    }
+    for (int64_t dim : dims) {
+        if (dim <= 0) {
+            return;
+        }
+    }
+    
+    const int64_t inner = dims[rank - 1];
+    const int64_t inner_stride = strides[rank - 1];
+    std::vector<int64_t> index(rank - 1, 0);
+    while (true) {
+        int64_t offset = 0;
+        for (int i = 0; i + 1 < rank; ++i) {
+            offset += index[i] * strides[i];
+        }
+        const uint8_t* row = src + offset * static_cast<int64_t>(element_size);
+        if (inner_stride == 1) {
+            std::memcpy(dst, row, inner * element_size);
+            dst += inner * element_size;
+        } else {
+            for (int64_t j = 0; j < inner; ++j) {
+                std::memcpy(dst, row + j * inner_stride * static_cast<int64_t>(element_size), element_size);
+                dst += element_size;
+            }
+        }
+    
+        int axis = rank - 2;
+        while (axis >= 0 && ++index[axis] == dims[axis]) {
+            index[axis] = 0;
+            --axis;
+        }
+        if (axis < 0) {
+            return;
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::vector<int64_t> Tensor::GetStrides() const {
+    return strides_.empty() ? ContiguousStrides(shape_.dims) : strides_;
+}
+
+bool Tensor::IsContiguous() const {
+    if (strides_.empty()) {
+        return true;
+    }
+    // 长度为1的维度步长任意，不影响连续性
+    int64_t expected = 1;
+    for (int i = static_cast<int>(shape_.dims.size()) - 1; i >= 0; --i) {
+        if (shape_.dims[i] != 1 && strides_[i] != expected) {
+            return false;
+        }
+        expected *= shape_.dims[i];
+    }
+    return true;
+}
+
+void Tensor::SetStrides(const std::vector<int64_t>& strides) {
+    strides_ = strides.size() == shape_.dims.size() ? strides : std::vector<int64_t>();
+}
+
 void Tensor::SetData(void* data, bool owns) {
     FreeMemory();
     data_ = data;
@@ -95,6 +184,7 @@ Tensor Tensor::Reshape(const Shape& new_shape) {
     view.data_ = data_;
     view.owns_data_ = false;  // 视图不拥有数据
     view.allocator_ = allocator_;
+    view.allocator_owner_ = allocator_owner_;
     return view;
 }
 
@@ -115,7 +205,7 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
     for (size_t i = 0; i < starts.size(); ++i) {
         int64_t start = starts[i];
         int64_t end = ends[i];
-        
+    
         // 处理负数索引（从末尾开始）
         if (start < 0) {
             start = shape_.dims[i] + start;
@@ -123,15 +213,15 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
         if (end < 0) {
             end = shape_.dims[i] + end;
         }
-        
+    
         // 边界检查
-        start = std::max(0LL, std::min(start, static_cast<int64_t>(shape_.dims[i])));
-        end = std::max(0LL, std::min(end, static_cast<int64_t>(shape_.dims[i])));
-        
+        start = std::max<int64_t>(0, std::min<int64_t>(start, shape_.dims[i]));
+        end = std::max<int64_t>(0, std::min<int64_t>(end, shape_.dims[i]));
+    
         if (end <= start) {
             return Tensor();  // 无效切片
         }
-        
+    
         new_dims.push_back(end - start);
         offsets.push_back(start);
     }
@@ -184,23 +274,24 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
                     layout_, device_type_);
         view.owns_data_ = false;  // 视图不拥有数据
         view.allocator_ = allocator_;  // 共享分配器
+        view.allocator_owner_ = allocator_owner_;
         return view;
     } else {
         // 非连续切片：复制数据到新tensor
         Tensor result(Shape(new_dims), dtype_, device_type_);
         size_t element_count = result.GetElementCount();
-        
+    
         // 计算原始和结果的strides
         std::vector<size_t> result_strides(new_dims.size());
         result_strides[new_dims.size() - 1] = 1;
         for (int i = static_cast<int>(new_dims.size()) - 2; i >= 0; --i) {
             result_strides[i] = result_strides[i + 1] * new_dims[i + 1];
         }
-        
+    
         // 复制数据：使用嵌套循环遍历所有元素
         const uint8_t* src_base = static_cast<const uint8_t*>(data_);
         uint8_t* dst_data = static_cast<uint8_t*>(result.GetData());
-        
+    
         // 使用递归函数复制每个元素
         std::function<void(const std::vector<size_t>&)> copy_element;
         copy_element = [&](const std::vector<size_t>& indices) {
@@ -210,13 +301,13 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
                 for (size_t i = 0; i < indices.size(); ++i) {
                     src_elem_idx += (offsets[i] + indices[i]) * strides[i];
                 }
-                
+    
                 // 计算目标索引（相对于结果tensor的索引）
                 size_t dst_elem_idx = 0;
                 for (size_t i = 0; i < indices.size(); ++i) {
                     dst_elem_idx += indices[i] * result_strides[i];
                 }
-                
+    
                 // 复制元素
                 // data_offset是起始位置的字节偏移，src_elem_idx是元素索引
                 const uint8_t* src_ptr = src_base + src_elem_idx * element_size;
@@ -224,7 +315,7 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
                 std::memcpy(dst_ptr, src_ptr, element_size);
                 return;
             }
-            
+    
             // 递归到下一维度
             for (size_t i = 0; i < new_dims[indices.size()]; ++i) {
                 std::vector<size_t> new_indices = indices;
@@ -232,105 +323,126 @@ Tensor Tensor::Slice(const std::vector<int64_t>& starts, const std::vector<int64
                 copy_element(new_indices);
             }
         };
-        
+    
         copy_element(std::vector<size_t>());
-        
+    
         return result;
     }
 }
 
-Status Tensor::CopyTo(Tensor& dst) const {
-    // 比较形状
-    bool shape_match = (shape_.dims.size() == dst.shape_.dims.size());
-    if (shape_match) {
-        for (size_t i = 0; i < shape_.dims.size(); ++i) {
-            if (shape_.dims[i] != dst.shape_.dims[i]) {
-                shape_match = false;
-                break;
-            }
-        }
-    }
-    
-    if (!shape_match || dtype_ != dst.dtype_) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, 
+namespace {
+
+Status CheckCopyCompatible(const Tensor& src, const Tensor& dst) {
+    if (src.GetShape().dims != dst.GetShape().dims || src.GetDataType() != dst.GetDataType()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                            "Shape or dtype mismatch");
     }
+    return Status::Ok();
+}
+
+std::string DeviceName(DeviceType device) {
+    return std::to_string(static_cast<int>(device));
+}
+
+} // anonymous namespace
+
+// 跨设备拷贝经由设备类型注册的DataTransfer (参考ONNX Runtime的DataTransferManager)；
+// 两个非CPU设备之间通过主机缓冲中转
+Status Tensor::CopyTo(Tensor& dst) const {
+    Status status = CheckCopyCompatible(*this, dst);
+    if (!status.IsOk()) {
+        return status;
+    }
     
     size_t size = GetSizeInBytes();
-    if (device_type_ == dst.device_type_) {
-        // 同设备拷贝
-        if (device_type_ == DeviceType::CPU) {
-            std::memcpy(dst.data_, data_, size);
-        } else {
-            // 对于非CPU设备，需要通过Device接口进行拷贝
-            // 注意：Tensor不直接存储Device引用，需要通过ExecutionProvider获取
-            // 同设备拷贝可以通过Device::Copy方法实现
-            // 当前实现：对于CPU设备使用memcpy，其他设备需要后端支持
-            // 完整实现需要：通过ExecutionProviderRegistry获取相应设备的Device接口
-            std::memcpy(dst.data_, data_, size);  // CPU设备实现
-        }
-    } else {
-        // 跨设备拷贝：通过CPU作为中转
-        // 策略：src -> CPU -> dst
-        // 这是最通用的方法，适用于所有设备组合
-        
-        if (device_type_ == DeviceType::CPU) {
-            // 从CPU拷贝到其他设备
-            // 实现方式：通过ExecutionProviderRegistry获取目标设备的ExecutionProvider
-            // 然后调用Device::CopyFromHost方法
-            // 当前实现：仅支持CPU到CPU的拷贝
-            if (dst.device_type_ == DeviceType::CPU) {
-                std::memcpy(dst.data_, data_, size);
-            } else {
-                // 需要目标设备的Device接口
-                // 完整实现示例：
-                // auto provider = ExecutionProviderRegistry::Instance().Create(provider_name);
-                // if (provider) {
-                //     auto device = provider->GetDevice();
-                //     return device->CopyFromHost(dst.data_, data_, size);
-                // }
-                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
-                                   "Copy from CPU to " + std::to_string(static_cast<int>(dst.device_type_)) + 
-                                   " requires device backend. Use ExecutionProvider to get Device interface.");
-            }
-        } else if (dst.device_type_ == DeviceType::CPU) {
-            // 从其他设备拷贝到CPU
-            // 实现方式：通过ExecutionProviderRegistry获取源设备的ExecutionProvider
-            // 然后调用Device::CopyToHost方法
-            // 当前实现：仅支持CPU到CPU的拷贝
-            if (device_type_ == DeviceType::CPU) {
-                std::memcpy(dst.data_, data_, size);
-            } else {
-                // 需要源设备的Device接口
-                // 完整实现示例：
-                // auto provider = ExecutionProviderRegistry::Instance().Create(provider_name);
-                // if (provider) {
-                //     auto device = provider->GetDevice();
-                //     return device->CopyToHost(dst.data_, data_, size);
-                // }
-                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
-                                   "Copy from " + std::to_string(static_cast<int>(device_type_)) + 
-                                   " to CPU requires device backend. Use ExecutionProvider to get Device interface.");
-            }
-        } else {
-            // 两个非CPU设备之间的拷贝：通过CPU中转
-            // 策略：src -> CPU -> dst
-            // 完整实现需要：
-            // 1. 获取源设备的Device，调用CopyToHost将数据拷贝到CPU临时缓冲区
-            // 2. 获取目标设备的Device，调用CopyFromHost将数据从CPU临时缓冲区拷贝到目标设备
-            // 当前实现：需要两个设备的Device接口
+    if (size == 0) {
+        return Status::Ok();
+    }
+    if (!dst.IsContiguous()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Copy destination is not contiguous");
+    }
+    if (!IsContiguous()) {
+        // 非连续的源按行主序收集：目标在主机上时直接写入，否则经主机上的连续张量中转
+        if (device_type_ != DeviceType::CPU) {
             return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
-                               "Cross-device copy between non-CPU devices requires device backends. "
-                               "Use ExecutionProviderRegistry to get Device interfaces.");
+                               "Strided copy requires a CPU source");
+        }
+        if (dst.device_type_ == DeviceType::CPU) {
+            GatherStrided(static_cast<const uint8_t*>(data_), static_cast<uint8_t*>(dst.data_),
+                          shape_.dims, strides_, GetDataTypeSize(dtype_));
+            return Status::Ok();
         }
+        Tensor dense(shape_, dtype_, DeviceType::CPU);
+        GatherStrided(static_cast<const uint8_t*>(data_), static_cast<uint8_t*>(dense.data_),
+                      shape_.dims, strides_, GetDataTypeSize(dtype_));
+        return dense.CopyTo(dst);
     }
-    return Status::Ok();
+    if (device_type_ == dst.device_type_) {
+        // 同设备拷贝；未注册数据传输的设备（张量位于主机内存）使用memcpy
+        auto transfer = device_type_ == DeviceType::CPU ? nullptr : GetDataTransfer(device_type_);
+        if (transfer) {
+            return transfer->CopyDeviceToDevice(dst.data_, data_, size);
+        }
+        std::memcpy(dst.data_, data_, size);
+        return Status::Ok();
+    }
+    
+    auto src_transfer = device_type_ == DeviceType::CPU ? nullptr : GetDataTransfer(device_type_);
+    auto dst_transfer = dst.device_type_ == DeviceType::CPU ? nullptr : GetDataTransfer(dst.device_type_);
+    if ((device_type_ != DeviceType::CPU && !src_transfer) ||
+        (dst.device_type_ != DeviceType::CPU && !dst_transfer)) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Copy from " + DeviceName(device_type_) + " to " + DeviceName(dst.device_type_) +
+                           " requires a registered DataTransfer (created by the device's ExecutionProvider)");
+    }
+    if (device_type_ == DeviceType::CPU) {
+        return dst_transfer->CopyHostToDevice(dst.data_, data_, size);
+    }
+    if (dst.device_type_ == DeviceType::CPU) {
+        return src_transfer->CopyDeviceToHost(dst.data_, data_, size);
+    }
+    std::vector<uint8_t> staging(size);
+    status = src_transfer->CopyDeviceToHost(staging.data(), data_, size);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return dst_transfer->CopyHostToDevice(dst.data_, staging.data(), size);
 }
 
 Status Tensor::CopyFrom(const Tensor& src) {
     return src.CopyTo(*this);
 }
 
+Status Tensor::CopyToAsync(Tensor& dst, std::shared_ptr<TransferEvent>* event, void* stream) const {
+    if (!event) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Event is null");
+    }
+    Status status = CheckCopyCompatible(*this, dst);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 主机与设备之间的连续拷贝异步入队，其余情况（含非连续的源）同步完成
+    const size_t size = GetSizeInBytes();
+    const bool async = size > 0 && IsContiguous() && dst.IsContiguous();
+    if (async && device_type_ == DeviceType::CPU && dst.device_type_ != DeviceType::CPU) {
+        if (auto transfer = GetDataTransfer(dst.device_type_)) {
+            return transfer->CopyHostToDeviceAsync(dst.data_, data_, size, stream, event);
+        }
+    } else if (async && device_type_ != DeviceType::CPU && dst.device_type_ == DeviceType::CPU) {
+        if (auto transfer = GetDataTransfer(device_type_)) {
+            return transfer->CopyDeviceToHostAsync(dst.data_, data_, size, stream, event);
+        }
+    }
+    status = CopyTo(dst);
+    *event = MakeCompletedTransferEvent(status);
+    return status;
+}
+
+Status Tensor::CopyFromAsync(const Tensor& src, std::shared_ptr<TransferEvent>* event, void* stream) {
+    return src.CopyToAsync(*this, event, stream);
+}
+
 Status Tensor::FillZero() {
     if (data_) {
         std::memset(data_, 0, GetSizeInBytes());
@@ -352,97 +464,59 @@ Status Tensor::FillValue(float value) {
 }
 
 Status Tensor::Serialize(std::vector<uint8_t>& buffer) const {
-    // 序列化格式（参考NCNN的模型格式）：
-    // [shape_size(4B)] [shape_dims(8B each)] [dtype(4B)] [data_size(8B)] [data]
-    
-    buffer.clear();
-    
-    // 序列化形状
-    size_t shape_size = shape_.dims.size();
-    buffer.resize(sizeof(size_t));
-    std::memcpy(buffer.data(), &shape_size, sizeof(size_t));
-    
-    // 序列化维度
-    for (int64_t dim : shape_.dims) {
-        size_t offset = buffer.size();
-        buffer.resize(offset + sizeof(int64_t));
-        std::memcpy(buffer.data() + offset, &dim, sizeof(int64_t));
+    // 格式同tensor_wire.h：[TensorWireHeader(128B)] [data]，一次分配整条消息
+    TensorWireHeader header;
+    Status status = BuildTensorWireHeader(*this, &header);
+    if (!status.IsOk()) {
+        return status;
     }
-    
-    // 序列化数据类型
-    int32_t dtype_int = static_cast<int32_t>(dtype_);
-    size_t offset = buffer.size();
-    buffer.resize(offset + sizeof(int32_t));
-    std::memcpy(buffer.data() + offset, &dtype_int, sizeof(int32_t));
-    
-    // 序列化数据
-    size_t data_size = GetSizeInBytes();
-    offset = buffer.size();
-    buffer.resize(offset + sizeof(size_t));
-    std::memcpy(buffer.data() + offset, &data_size, sizeof(size_t));
+    const size_t data_size = static_cast<size_t>(header.payload_size);
+    buffer.resize(sizeof(TensorWireHeader) + data_size);
+    std::memcpy(buffer.data(), &header, sizeof(TensorWireHeader));
     
     if (data_ && data_size > 0) {
-        offset = buffer.size();
-        buffer.resize(offset + data_size);
-        std::memcpy(buffer.data() + offset, data_, data_size);
+        uint8_t* payload = buffer.data() + sizeof(TensorWireHeader);
+        if (IsContiguous()) {
+            std::memcpy(payload, data_, data_size);
+        } else {
+            GatherStrided(static_cast<const uint8_t*>(data_), payload,
+                          shape_.dims, strides_, GetDataTypeSize(dtype_));
+        }
     }
     
     return Status::Ok();
 }
 
 Status Tensor::Deserialize(const std::vector<uint8_t>& buffer) {
-    if (buffer.size() < sizeof(size_t)) {
+    if (buffer.size() < sizeof(TensorWireHeader)) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Buffer too small");
     }
-    
-    size_t offset = 0;
-    
-    // 反序列化形状大小
-    size_t shape_size;
-    std::memcpy(&shape_size, buffer.data() + offset, sizeof(size_t));
-    offset += sizeof(size_t);
-    
-    if (buffer.size() < offset + shape_size * sizeof(int64_t)) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid buffer format");
+    TensorWireHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(TensorWireHeader));
+    Status status = ValidateTensorWireHeader(header);
+    if (!status.IsOk()) {
+        return status;
     }
-    
-    // 反序列化维度
-    std::vector<int64_t> dims(shape_size);
-    for (size_t i = 0; i < shape_size; ++i) {
-        std::memcpy(&dims[i], buffer.data() + offset, sizeof(int64_t));
-        offset += sizeof(int64_t);
-    }
-    shape_ = Shape(dims);
-    
-    // 反序列化数据类型
-    if (buffer.size() < offset + sizeof(int32_t)) {
+    const size_t data_size = static_cast<size_t>(header.payload_size);
+    if (buffer.size() < sizeof(TensorWireHeader) + data_size) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid buffer format");
     }
-    int32_t dtype_int;
-    std::memcpy(&dtype_int, buffer.data() + offset, sizeof(int32_t));
-    offset += sizeof(int32_t);
-    dtype_ = static_cast<DataType>(dtype_int);
     
-    // 反序列化数据大小
-    if (buffer.size() < offset + sizeof(size_t)) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid buffer format");
-    }
-    size_t data_size;
-    std::memcpy(&data_size, buffer.data() + offset, sizeof(size_t));
-    offset += sizeof(size_t);
+    FreeMemory();
+    data_ = nullptr;
+    owns_data_ = true;
+    shape_ = Shape(std::vector<int64_t>(header.dims, header.dims + header.ndims));
+    strides_.clear();
+    dtype_ = static_cast<DataType>(header.dtype);
+    layout_ = static_cast<MemoryLayout>(header.layout);
     
-    // 分配内存并复制数据
+    // 分配内存并复制数据（不拷贝的读取见DecodeTensorWire）
     if (data_size > 0) {
-        if (buffer.size() < offset + data_size) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid buffer format");
-        }
-        
         AllocateMemory();
         if (!data_) {
             return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate memory");
         }
-        
-        std::memcpy(data_, buffer.data() + offset, data_size);
+        std::memcpy(data_, buffer.data() + sizeof(TensorWireHeader), data_size);
     }
     
     return Status::Ok();
@@ -454,8 +528,10 @@ void Tensor::AllocateMemory() {
         return;
     }
     
-    // 获取内存分配器
-    allocator_ = GetMemoryAllocator(device_type_);
+    // 获取内存分配器（默认分配器无锁、不增加引用计数）；已有分配器（CreateTensorWithAllocator指定或此前分配时取得）时沿用
+    if (!allocator_) {
+        allocator_ = ResolveMemoryAllocator(device_type_, &allocator_owner_);
+    }
     if (allocator_) {
         data_ = allocator_->Allocate(size);
     } else {
@@ -480,15 +556,201 @@ void Tensor::FreeMemory() {
     }
 }
 
+namespace {
+
+// 经由内存池分配的STL分配器：allocate_shared用它一次取得Tensor与控制块，
+// 小于256KB的请求命中池的线程本地缓存，相当于按大小分级的线程本地slab
+template <typename T>
+struct PooledObjectAllocator {
+    using value_type = T;
+    
+    PooledObjectAllocator() = default;
+    template <typename U>
+    PooledObjectAllocator(const PooledObjectAllocator<U>&) {}
+    
+    T* allocate(size_t n) {
+        void* ptr = ::inferunity::AllocateMemory(n * sizeof(T), std::max<size_t>(alignof(T), 16));
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, size_t) { ::inferunity::FreeMemory(ptr); }
+    
+    template <typename U>
+    bool operator==(const PooledObjectAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const PooledObjectAllocator<U>&) const { return false; }
+};
+
+} // anonymous namespace
+
 std::shared_ptr<Tensor> CreateTensor(const Shape& shape, DataType dtype, DeviceType device) {
-    return std::make_shared<Tensor>(shape, dtype, device);
+    return std::allocate_shared<Tensor>(PooledObjectAllocator<Tensor>(), shape, dtype, device);
 }
 
 std::shared_ptr<Tensor> CreateTensorFromData(const Shape& shape, DataType dtype,
                                              void* data, MemoryLayout layout,
                                              DeviceType device) {
-    return std::make_shared<Tensor>(shape, dtype, data, layout, device);
+    return std::allocate_shared<Tensor>(PooledObjectAllocator<Tensor>(), shape, dtype, data, layout, device);
 }
 
-} // namespace inferunity
+std::shared_ptr<Tensor> CreateTensorWithAllocator(const Shape& shape, DataType dtype,
+                                                  std::shared_ptr<MemoryAllocator> allocator,
+                                                  DeviceType device) {
+    if (!allocator) {
+        return CreateTensor(shape, dtype, device);
+    }
+    auto tensor = std::allocate_shared<Tensor>(PooledObjectAllocator<Tensor>());
+    tensor->shape_ = shape;
+    tensor->dtype_ = dtype;
+    tensor->device_type_ = device;
+    tensor->owns_data_ = true;
+    tensor->allocator_ = allocator.get();
+    tensor->allocator_owner_ = std::move(allocator);
+    const size_t size = tensor->GetSizeInBytes();
+    if (size > 0) {
+        tensor->data_ = tensor->allocator_->Allocate(size);
+        if (!tensor->data_) {
+            return nullptr;
+        }
+    }
+    return tensor;
+}
+
+std::vector<std::shared_ptr<Tensor>> SplitBatch(const std::shared_ptr<Tensor>& batch,
+                                                const std::vector<int64_t>& rows) {
+    std::vector<std::shared_ptr<Tensor>> views;
+    if (!batch || batch->GetShape().dims.empty()) {
+        return views;
+    }
+    const std::vector<int64_t>& dims = batch->GetShape().dims;
+    int64_t total = 0;
+    for (int64_t count : rows) {
+        if (count <= 0) {
+            return views;
+        }
+        total += count;
+    }
+    if (total != dims[0]) {
+        return views;
+    }
+    
+    const size_t row_bytes = dims[0] > 0 ? batch->GetSizeInBytes() / static_cast<size_t>(dims[0]) : 0;
+    uint8_t* data = static_cast<uint8_t*>(batch->GetData());
+    for (int64_t count : rows) {
+        std::vector<int64_t> view_dims = dims;
+        view_dims[0] = count;
+        // 删除器捕获batch，视图存活期间底层缓冲不会释放
+        views.emplace_back(new Tensor(Shape(view_dims), batch->GetDataType(), data,
+                                      batch->GetLayout(), batch->GetDeviceType()),
+                           [batch](Tensor* view) { delete view; });
+        data += row_bytes * static_cast<size_t>(count);
+    }
+    return views;
+}
 
+std::shared_ptr<Tensor> ConcatBatch(const std::vector<const Tensor*>& samples) {
+    if (samples.empty() || !samples[0] || samples[0]->GetShape().dims.empty()) {
+        return nullptr;
+    }
+    const Tensor* first = samples[0];
+    const std::vector<int64_t>& ref_dims = first->GetShape().dims;
+    std::vector<int64_t> dims = ref_dims;
+    dims[0] = 0;
+    bool contiguous = true;
+    const uint8_t* next = static_cast<const uint8_t*>(first->GetData());
+    for (const Tensor* sample : samples) {
+        if (!sample || sample->GetDataType() != first->GetDataType() ||
+            sample->GetDeviceType() != first->GetDeviceType()) {
+            return nullptr;
+        }
+        const std::vector<int64_t>& sample_dims = sample->GetShape().dims;
+        if (sample_dims.size() != ref_dims.size() ||
+            !std::equal(sample_dims.begin() + 1, sample_dims.end(), ref_dims.begin() + 1)) {
+            return nullptr;
+        }
+        dims[0] += sample_dims[0];
+        contiguous = contiguous && sample->GetData() == next;
+        next = static_cast<const uint8_t*>(sample->GetData()) + sample->GetSizeInBytes();
+    }
+    
+    if (samples.size() == 1 || contiguous) {
+        return CreateTensorFromData(Shape(dims), first->GetDataType(),
+                                    const_cast<void*>(first->GetData()), first->GetLayout(),
+                                    first->GetDeviceType());
+    }
+    if (first->GetDeviceType() != DeviceType::CPU) {
+        return nullptr;
+    }
+    auto merged = CreateTensor(Shape(dims), first->GetDataType(), DeviceType::CPU);
+    if (!merged->GetData()) {
+        return nullptr;
+    }
+    uint8_t* dst = static_cast<uint8_t*>(merged->GetData());
+    for (const Tensor* sample : samples) {
+        const size_t bytes = sample->GetSizeInBytes();
+        if (bytes > 0) {
+            std::memcpy(dst, sample->GetData(), bytes);
+        }
+        dst += bytes;
+    }
+    return merged;
+}
+
+std::shared_ptr<Tensor> CreateStridedView(const std::shared_ptr<Tensor>& base, const Shape& shape,
+                                          const std::vector<int64_t>& strides, int64_t offset) {
+    const std::vector<int64_t> dense = ContiguousStrides(shape.dims);
+    const std::vector<int64_t>& view_strides = strides.empty() ? dense : strides;
+    if (!base || !base->GetData() || view_strides.size() != shape.dims.size() || offset < 0) {
+        return nullptr;
+    }
+    // 视图能访问到的最远元素不能超出base可访问的范围（只支持非负步长）
+    auto extent = [](const std::vector<int64_t>& dims, const std::vector<int64_t>& steps, int64_t* last) {
+        for (size_t i = 0; i < dims.size(); ++i) {
+            if (dims[i] == 0) {
+                return false;
+            }
+            *last += (dims[i] - 1) * steps[i];
+        }
+        return true;
+    };
+    for (size_t i = 0; i < view_strides.size(); ++i) {
+        if (view_strides[i] < 0 || shape.dims[i] < 0) {
+            return nullptr;
+        }
+    }
+    int64_t view_last = offset;
+    int64_t base_last = 0;
+    if (extent(shape.dims, view_strides, &view_last) &&
+        (!extent(base->GetShape().dims, base->GetStrides(), &base_last) || view_last > base_last)) {
+        return nullptr;
+    }
+    
+    uint8_t* data = static_cast<uint8_t*>(base->GetData()) +
+                    offset * static_cast<int64_t>(Tensor::GetDataTypeSize(base->GetDataType()));
+    // 与SplitBatch相同，删除器捕获base，视图存活期间底层存储不会释放
+    std::shared_ptr<Tensor> view(new Tensor(shape, base->GetDataType(), data,
+                                            base->GetLayout(), base->GetDeviceType()),
+                                 [base](Tensor* v) { delete v; });
+    if (view_strides != dense) {
+        view->SetStrides(view_strides);
+    }
+    return view;
+}
+
+std::shared_ptr<Tensor> MakeContiguous(const std::shared_ptr<Tensor>& tensor) {
+    if (!tensor || tensor->IsContiguous()) {
+        return tensor;
+    }
+    if (tensor->GetDeviceType() != DeviceType::CPU) {
+        return nullptr;
+    }
+    auto dense = CreateTensor(tensor->GetShape(), tensor->GetDataType(), DeviceType::CPU);
+    if (!tensor->CopyTo(*dense).IsOk()) {
+        return nullptr;
+    }
+    return dense;
+}
+
+} // namespace inferunity
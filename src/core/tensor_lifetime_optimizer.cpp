@@ -2,15 +2,33 @@
 // 参考 NCNN 的 BlobAllocator 和 ONNX Runtime 的内存复用机制
 
 #include "inferunity/memory.h"
+#include "inferunity/memory_planner.h"
 #include "inferunity/graph.h"
+#include "inferunity/operator.h"
 #include "inferunity/logger.h"
 #include <algorithm>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <set>
 
 namespace inferunity {
 
+namespace {
+
+// 每种算子类型只创建一个实例，查询视图/原地执行能力
+const Operator* ProbeOperator(const std::string& op_type,
+                              std::unordered_map<std::string, std::unique_ptr<Operator>>& cache) {
+    auto it = cache.find(op_type);
+    if (it == cache.end()) {
+        it = cache.emplace(op_type, OperatorRegistry::Instance().Create(op_type)).first;
+    }
+    return it->second.get();
+}
+
+} // namespace
+
 // Tensor生命周期分析
 std::vector<TensorLifetime> AnalyzeTensorLifetimes(const Graph* graph) {
     if (!graph) {
@@ -20,16 +38,24 @@ std::vector<TensorLifetime> AnalyzeTensorLifetimes(const Graph* graph) {
     // 获取拓扑排序（执行顺序）
     std::vector<Node*> execution_order = graph->TopologicalSort();
     
-    // 建立节点索引映射
-    std::unordered_map<Node*, int64_t> node_index;
+    // 一次遍历所有节点的输入输出，记录每个Value的出生（生产者位置）和死亡（最后使用位置）
+    std::unordered_map<const Value*, int64_t> birth;
+    std::unordered_map<const Value*, int64_t> last_use;
     for (size_t i = 0; i < execution_order.size(); ++i) {
-        node_index[execution_order[i]] = static_cast<int64_t>(i);
+        const int64_t step = static_cast<int64_t>(i);
+        for (Value* output : execution_order[i]->GetOutputs()) {
+            birth.emplace(output, step);
+        }
+        for (Value* input : execution_order[i]->GetInputs()) {
+            int64_t& last = last_use.emplace(input, step).first->second;
+            last = std::max(last, step);
+        }
     }
+    std::unordered_set<const Value*> graph_outputs(graph->GetOutputs().begin(),
+                                                   graph->GetOutputs().end());
     
-    // 分析每个Value的生命周期
     std::vector<TensorLifetime> lifetimes;
-    
-    // 遍历所有Value
+    lifetimes.reserve(graph->GetValues().size());
     for (const auto& value_ptr : graph->GetValues()) {
         Value* value = value_ptr.get();
         if (!value) continue;
@@ -37,134 +63,194 @@ std::vector<TensorLifetime> AnalyzeTensorLifetimes(const Graph* graph) {
         TensorLifetime lifetime;
         lifetime.value_ptr = value;
         
-        // 找到产生该Value的节点（birth）
-        Node* producer = nullptr;
-        for (Node* node : execution_order) {
-            for (Value* output : node->GetOutputs()) {
-                if (output == value) {
-                    producer = node;
-                    break;
-                }
-            }
-            if (producer) break;
-        }
+        // 输入Value和常量没有生产者，birth = -1（在开始前就存在）
+        auto birth_it = birth.find(value);
+        lifetime.birth = birth_it != birth.end() ? birth_it->second : -1;
         
-        if (producer) {
-            auto it = node_index.find(producer);
-            if (it != node_index.end()) {
-                lifetime.birth = it->second;
-            }
+        auto use_it = last_use.find(value);
+        if (graph_outputs.count(value)) {
+            // 输出Value在最后才死亡
+            lifetime.death = static_cast<int64_t>(execution_order.size());
+        } else if (use_it != last_use.end()) {
+            lifetime.death = use_it->second;
         } else {
-            // 输入Value，birth = -1（在开始前就存在）
-            lifetime.birth = -1;
+            // 未被使用的Value
+            lifetime.death = lifetime.birth;
         }
         
-        // 找到最后使用该Value的节点（death）
-        int64_t last_use = -1;
-        for (Node* node : execution_order) {
-            for (Value* input : node->GetInputs()) {
-                if (input == value) {
-                    auto it = node_index.find(node);
-                    if (it != node_index.end()) {
-                        last_use = std::max(last_use, it->second);
-                    }
-                }
+        lifetimes.push_back(lifetime);
+    }
+    
+    // 视图的存储属于第0个输入：逆拓扑序把视图的死亡时间传给输入，视图链上的源张量活到最后一个视图用完；
+    // 图输出不做成视图（执行计划同样如此），仍单独分配
+    std::unordered_map<const Value*, size_t> index_of;
+    for (size_t i = 0; i < lifetimes.size(); ++i) {
+        index_of.emplace(static_cast<const Value*>(lifetimes[i].value_ptr), i);
+    }
+    std::unordered_map<std::string, std::unique_ptr<Operator>> ops;
+    for (auto it = execution_order.rbegin(); it != execution_order.rend(); ++it) {
+        Node* node = *it;
+        if (node->GetInputs().empty() || node->GetOutputs().size() != 1 ||
+            graph_outputs.count(node->GetOutputs()[0])) {
+            continue;
+        }
+        const Operator* op = ProbeOperator(node->GetOpType(), ops);
+        if (!op || !op->IsViewOperator()) {
+            continue;
+        }
+        auto output_it = index_of.find(node->GetOutputs()[0]);
+        auto input_it = index_of.find(node->GetInputs()[0]);
+        if (output_it == index_of.end() || input_it == index_of.end()) {
+            continue;
+        }
+        TensorLifetime& output = lifetimes[output_it->second];
+        TensorLifetime& input = lifetimes[input_it->second];
+        output.is_alias = true;
+        input.death = std::max(input.death, output.death);
+    }
+    
+    // 切片别名：Concat的输入与Split的输出记为整体的第k个切片，Pad的输入记为输出内部的一块，
+    // 偏移与是否连续由内存规划按形状确定。
+    // 切片与整体都须是中间张量（不是视图、不是图输出），一个Value只属于一个整体，Concat的重复输入不能同时放在两处
+    auto sliceable = [&](const Value* value) -> TensorLifetime* {
+        auto it = index_of.find(value);
+        if (it == index_of.end() || graph_outputs.count(value)) {
+            return nullptr;
+        }
+        TensorLifetime& lifetime = lifetimes[it->second];
+        return lifetime.birth >= 0 && !lifetime.is_alias ? &lifetime : nullptr;
+    };
+    for (Node* node : execution_order) {
+        const auto& inputs = node->GetInputs();
+        const auto& outputs = node->GetOutputs();
+        if (inputs.empty() || outputs.empty()) {
+            continue;
+        }
+        const Operator* op = ProbeOperator(node->GetOpType(), ops);
+        const SliceAlias alias = op ? op->GetSliceAlias() : SliceAlias::NONE;
+        if (alias == SliceAlias::NONE || (alias == SliceAlias::INPUTS_IN_OUTPUT && outputs.size() != 1)) {
+            continue;
+        }
+        if (alias == SliceAlias::INPUT_INSIDE_OUTPUT) {
+            // 位置取决于节点属性与常量输入（Pad的pads），按节点创建算子查询
+            TensorLifetime* part = sliceable(inputs[0]);
+            auto instance = OperatorRegistry::Instance().Create(node->GetOpType());
+            if (outputs.size() != 1 || !sliceable(outputs[0]) || !part || part->slice_of ||
+                inputs[0] == outputs[0] || !instance) {
+                continue;
             }
+            ApplyNodeAttributes(*node, instance.get());
+            std::vector<Tensor*> tensors;
+            for (Value* input : inputs) {
+                tensors.push_back(input ? input->GetTensor().get() : nullptr);
+            }
+            int axis = -1;
+            int64_t start = 0;
+            if (!tensors[0] || !instance->GetSliceOrigin(tensors, &axis, &start)) {
+                continue;
+            }
+            part->slice_of = outputs[0];
+            part->slice_index = 0;
+            part->slice_axis = axis;
+            part->slice_start = start;
+            continue;
         }
-        
-        // 检查是否是输出Value
-        bool is_output = false;
-        for (Value* output : graph->GetOutputs()) {
-            if (output == value) {
-                is_output = true;
+        Value* whole = alias == SliceAlias::INPUTS_IN_OUTPUT ? outputs[0] : inputs[0];
+        const std::vector<Value*>& parts = alias == SliceAlias::INPUTS_IN_OUTPUT ? inputs : outputs;
+        if (!sliceable(whole)) {
+            continue;
+        }
+        std::vector<TensorLifetime*> slices;
+        for (size_t k = 0; k < parts.size(); ++k) {
+            TensorLifetime* slice = sliceable(parts[k]);
+            if (!slice || slice->slice_of || parts[k] == whole ||
+                std::find(parts.begin(), parts.begin() + k, parts[k]) != parts.begin() + k) {
                 break;
             }
+            slices.push_back(slice);
         }
-        
-        if (is_output) {
-            // 输出Value在最后才死亡
-            lifetime.death = static_cast<int64_t>(execution_order.size());
-        } else if (last_use >= 0) {
-            lifetime.death = last_use;
-        } else {
-            // 未被使用的Value
-            lifetime.death = lifetime.birth;
+        if (slices.size() != parts.size()) {
+            continue;
         }
-        
-        lifetimes.push_back(lifetime);
+        for (size_t k = 0; k < slices.size(); ++k) {
+            slices[k]->slice_of = whole;
+            slices[k]->slice_index = static_cast<int>(k);
+        }
+    }
+    // 整体缓冲内（含嵌套的切片）所有张量中最晚的死亡时间
+    std::unordered_map<const Value*, int64_t> contents_death;
+    for (const auto& lifetime : lifetimes) {
+        for (const void* whole = lifetime.slice_of; whole;
+             whole = lifetimes[index_of.at(static_cast<const Value*>(whole))].slice_of) {
+            int64_t& death = contents_death.emplace(static_cast<const Value*>(whole), lifetime.death).first->second;
+            death = std::max(death, lifetime.death);
+        }
+    }
+    
+    // 原地执行（参考ONNX Runtime的MayInplace）：第k个输入是中间张量、本节点之后不再被读取时，
+    // 输出复用它的缓冲；大小是否一致由内存规划器检查
+    for (size_t i = 0; i < execution_order.size(); ++i) {
+        Node* node = execution_order[i];
+        if (node->GetOutputs().size() != 1 || graph_outputs.count(node->GetOutputs()[0])) {
+            continue;
+        }
+        const Operator* op = ProbeOperator(node->GetOpType(), ops);
+        const int k = op ? op->GetInPlaceInput() : -1;
+        if (k < 0 || k >= static_cast<int>(node->GetInputs().size())) {
+            continue;
+        }
+        const Value* shared = node->GetInputs()[static_cast<size_t>(k)];
+        auto output_it = index_of.find(node->GetOutputs()[0]);
+        auto input_it = index_of.find(shared);
+        if (output_it == index_of.end() || input_it == index_of.end() ||
+            graph_outputs.count(shared)) {
+            continue;
+        }
+        TensorLifetime& output = lifetimes[output_it->second];
+        const TensorLifetime& input = lifetimes[input_it->second];
+        if (output.is_alias || input.is_alias || input.birth < 0 ||
+            input.death != static_cast<int64_t>(i)) {
+            continue;
+        }
+        // 切片所在的整体缓冲可能在之后仍被读取；整体只有在其中的切片都不再使用时才能被覆盖
+        auto contents = contents_death.find(shared);
+        if (input.slice_of || (contents != contents_death.end() && contents->second > static_cast<int64_t>(i))) {
+            continue;
+        }
+        output.inplace_of = input.value_ptr;
     }
     
     return lifetimes;
 }
 
-// 基于生命周期分析的内存复用分配
+// 基于生命周期分析的内存复用分配：离线规划偏移后一次性分配arena并绑定视图
 Status AllocateMemoryWithReuse(Graph* graph) {
     if (!graph) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
     }
     
-    // 分析Tensor生命周期
-    std::vector<TensorLifetime> lifetimes = AnalyzeTensorLifetimes(graph);
-    
-    // 按出生时间排序
-    std::sort(lifetimes.begin(), lifetimes.end(), 
-              [](const TensorLifetime& a, const TensorLifetime& b) {
-                  return a.birth < b.birth;
-              });
-    
-    // 内存复用分配（贪心算法）
-    // 对于每个Tensor，查找可以复用的内存块
-    std::vector<std::pair<Value*, void*>> allocations;
-    std::vector<std::pair<void*, size_t>> free_blocks;  // <ptr, size>
+    MemoryPlan plan;
+    Status status = PlanMemory(graph, MemoryPlannerOptions(), &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
     
-    for (const auto& lifetime : lifetimes) {
-        Value* value = static_cast<Value*>(lifetime.value_ptr);
-        if (!value) continue;
-        
-        const Shape& shape = value->GetShape();
-        DataType dtype = value->GetDataType();
-        size_t size = shape.GetElementCount() * GetDataTypeSize(dtype);
-        
-        if (size == 0) continue;
-        
-        // 释放已死亡的Tensor内存
-        for (auto it = free_blocks.begin(); it != free_blocks.end();) {
-            // 检查这个内存块对应的Tensor是否已死亡
-            // 简化实现：假设所有free_blocks都可以重用
-            ++it;
-        }
-        
-        // 查找可重用的内存块
-        void* ptr = nullptr;
-        for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
-            if (it->second >= size) {
-                ptr = it->first;
-                free_blocks.erase(it);
-                break;
-            }
-        }
-        
-        // 如果没有可重用的，分配新内存
-        if (!ptr) {
-            ptr = AllocateMemory(size, 16);  // 16字节对齐
-            if (!ptr) {
-                return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
-                                   "Failed to allocate memory for tensor");
-            }
-        }
-        
-        // 创建Tensor并设置内存
-        auto tensor = CreateTensorFromData(shape, dtype, ptr, MemoryLayout::NCHW, DeviceType::CPU);
-        value->SetTensor(tensor);
-        
-        allocations.push_back({value, ptr});
+    auto arena = MemoryArena::Create(plan.arena_size, plan.alignment);
+    if (!arena) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
+                           "Failed to allocate memory arena");
+    }
+    status = BindMemoryPlan(plan, arena);
+    if (!status.IsOk()) {
+        return status;
     }
     
-    LOG_INFO("Memory reuse allocation completed: " + 
-             std::to_string(allocations.size()) + " tensors allocated");
+    LOG_INFO("Memory reuse allocation completed: " + std::to_string(plan.entries.size()) +
+             " tensors, planned " + std::to_string(plan.arena_size) + " bytes (" +
+             MemoryPlanStrategyName(plan.strategy) + ") vs naive " +
+             std::to_string(plan.naive_size) + " bytes");
     
     return Status::Ok();
 }
 
 } // namespace inferunity
-
@@ -0,0 +1,58 @@
+#include "inferunity/tensor_view.h"
+#include "inferunity/operator.h"
+
+namespace inferunity {
+
+bool MakeTensorView(const Tensor& tensor, TensorView* view) {
+    const std::vector<int64_t>& dims = tensor.GetShape().dims;
+    if (dims.size() > static_cast<size_t>(kTensorViewMaxDims)) {
+        return false;
+    }
+    view->data = const_cast<void*>(tensor.GetData());
+    view->dtype = tensor.GetDataType();
+    view->device = tensor.GetDeviceType();
+    view->layout = tensor.GetLayout();
+    view->contiguous = tensor.IsContiguous();
+    view->ndims = static_cast<int32_t>(dims.size());
+    if (view->contiguous) {
+        // 连续张量按形状算步长，不经过GetStrides（返回新的vector）
+        int64_t stride = 1;
+        for (int i = view->ndims - 1; i >= 0; --i) {
+            view->dims[i] = dims[i];
+            view->strides[i] = stride;
+            stride *= dims[i] > 1 ? dims[i] : 1;
+        }
+    } else {
+        const std::vector<int64_t> strides = tensor.GetStrides();
+        for (int i = 0; i < view->ndims; ++i) {
+            view->dims[i] = dims[i];
+            view->strides[i] = strides[i];
+        }
+    }
+    return true;
+}
+
+Status TensorViewOperator::Execute(const std::vector<Tensor*>& inputs,
+                                   const std::vector<Tensor*>& outputs,
+                                   ExecutionContext* ctx) {
+    const size_t total = inputs.size() + outputs.size();
+    TensorView inline_views[kMaxInlineViews];
+    std::vector<TensorView> heap_views;
+    TensorView* views = inline_views;
+    if (total > kMaxInlineViews) {
+        heap_views.resize(total);
+        views = heap_views.data();
+    }
+    for (size_t i = 0; i < total; ++i) {
+        const Tensor* tensor = i < inputs.size() ? inputs[i] : outputs[i - inputs.size()];
+        if (!tensor || !MakeTensorView(*tensor, &views[i])) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 GetName() + ": tensor is missing or exceeds the view rank limit");
+        }
+    }
+    TensorViewSpan input_span{views, inputs.size()};
+    TensorViewSpan output_span{views + inputs.size(), outputs.size()};
+    return ExecuteViews(input_span, output_span, ctx);
+}
+
+} // namespace inferunity
@@ -0,0 +1,218 @@
+#include "inferunity/tensor_wire.h"
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#ifdef INFERUNITY_HAS_IOVEC
+#include <unistd.h>
+#endif
+
+namespace inferunity {
+
+Status BuildTensorWireHeader(const Tensor& tensor, TensorWireHeader* header) {
+    const std::vector<int64_t>& dims = tensor.GetShape().dims;
+    if (dims.size() > kTensorWireMaxDims) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Tensor rank exceeds wire format limit: " + std::to_string(dims.size()));
+    }
+    std::memset(header, 0, sizeof(TensorWireHeader));
+    header->magic = kTensorWireMagic;
+    header->version = kTensorWireVersion;
+    header->header_size = static_cast<uint16_t>(sizeof(TensorWireHeader));
+    header->dtype = static_cast<int32_t>(tensor.GetDataType());
+    header->layout = static_cast<uint8_t>(tensor.GetLayout());
+    header->ndims = static_cast<uint32_t>(dims.size());
+    for (size_t i = 0; i < dims.size(); ++i) {
+        header->dims[i] = dims[i];
+    }
+    header->payload_size = tensor.GetSizeInBytes();
+    return Status::Ok();
+}
+
+Status ValidateTensorWireHeader(const TensorWireHeader& header) {
+    if (header.magic != kTensorWireMagic) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid tensor wire magic");
+    }
+    if (header.version != kTensorWireVersion || header.header_size != sizeof(TensorWireHeader)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Unsupported tensor wire version " + std::to_string(header.version));
+    }
+    if (header.ndims > kTensorWireMaxDims) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid tensor wire rank");
+    }
+    if (header.dtype < 0 || header.dtype > static_cast<int32_t>(DataType::BOOL)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Unsupported tensor wire dtype " + std::to_string(header.dtype));
+    }
+    // 形状与载荷大小须一致，防止按伪造的头越界访问
+    uint64_t count = 1;
+    for (uint32_t i = 0; i < header.ndims; ++i) {
+        const int64_t dim = header.dims[i];
+        if (dim < 0 || (dim > 0 && count > std::numeric_limits<uint64_t>::max() / static_cast<uint64_t>(dim))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid tensor wire dims");
+        }
+        count *= static_cast<uint64_t>(dim);
+    }
+    const uint64_t element_size = Tensor::GetDataTypeSize(static_cast<DataType>(header.dtype));
+    if (count > std::numeric_limits<uint64_t>::max() / element_size ||
+        count * element_size != header.payload_size) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Tensor wire payload size does not match shape");
+    }
+    return Status::Ok();
+}
+
+#ifdef INFERUNITY_HAS_IOVEC
+int TensorWireMessage::FillIovec(struct iovec* iov) const {
+    iov[0].iov_base = const_cast<TensorWireHeader*>(&header);
+    iov[0].iov_len = sizeof(TensorWireHeader);
+    if (payload_size == 0) {
+        return 1;
+    }
+    iov[1].iov_base = const_cast<void*>(payload);
+    iov[1].iov_len = payload_size;
+    return 2;
+}
+#endif
+
+Status EncodeTensorWire(const Tensor& tensor, TensorWireMessage* message) {
+    if (tensor.GetDeviceType() != DeviceType::CPU) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Tensor wire encoding requires a CPU tensor");
+    }
+    if (!tensor.IsContiguous()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Tensor wire encoding requires a contiguous tensor (use MakeContiguous)");
+    }
+    Status status = BuildTensorWireHeader(tensor, &message->header);
+    if (!status.IsOk()) {
+        return status;
+    }
+    message->payload_size = static_cast<size_t>(message->header.payload_size);
+    message->payload = message->payload_size > 0 ? tensor.GetData() : nullptr;
+    if (message->payload_size > 0 && !message->payload) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Tensor has no data");
+    }
+    return Status::Ok();
+}
+
+Status DecodeTensorWire(const void* buffer, size_t size, std::shared_ptr<const void> owner,
+                        std::shared_ptr<Tensor>* tensor, size_t* consumed) {
+    if (!buffer || size < sizeof(TensorWireHeader)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Buffer too small for tensor wire header");
+    }
+    // 缓冲不一定满足头的对齐要求，头按值拷出（128字节），载荷不拷贝
+    TensorWireHeader header;
+    std::memcpy(&header, buffer, sizeof(TensorWireHeader));
+    Status status = ValidateTensorWireHeader(header);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (header.payload_size > size - sizeof(TensorWireHeader)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Buffer truncated before tensor wire payload");
+    }
+    const DataType dtype = static_cast<DataType>(header.dtype);
+    uint8_t* payload = const_cast<uint8_t*>(static_cast<const uint8_t*>(buffer)) + sizeof(TensorWireHeader);
+    if (reinterpret_cast<uintptr_t>(payload) % Tensor::GetDataTypeSize(dtype) != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Tensor wire payload is misaligned");
+    }
+    
+    const Shape shape(std::vector<int64_t>(header.dims, header.dims + header.ndims));
+    const MemoryLayout layout = static_cast<MemoryLayout>(header.layout);
+    if (owner) {
+        // 删除器捕获owner，张量存活期间接收缓冲不会释放
+        tensor->reset(new Tensor(shape, dtype, payload, layout, DeviceType::CPU),
+                      [owner](Tensor* view) { delete view; });
+    } else {
+        *tensor = CreateTensorFromData(shape, dtype, payload, layout, DeviceType::CPU);
+    }
+    if (consumed) {
+        *consumed = sizeof(TensorWireHeader) + static_cast<size_t>(header.payload_size);
+    }
+    return Status::Ok();
+}
+
+Status DecodeTensorWire(const void* buffer, size_t size, std::shared_ptr<Tensor>* tensor, size_t* consumed) {
+    return DecodeTensorWire(buffer, size, nullptr, tensor, consumed);
+}
+
+#ifdef INFERUNITY_HAS_IOVEC
+namespace {
+
+Status ReadFully(int fd, void* data, size_t size) {
+    uint8_t* cursor = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t n = ::read(fd, cursor, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                 n == 0 ? "Unexpected end of tensor wire stream" : std::strerror(errno));
+        }
+        cursor += n;
+        size -= static_cast<size_t>(n);
+    }
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+Status WriteTensorWire(int fd, const Tensor& tensor) {
+    TensorWireMessage message;
+    Status status = EncodeTensorWire(tensor, &message);
+    if (!status.IsOk()) {
+        return status;
+    }
+    struct iovec iov[2];
+    int count = message.FillIovec(iov);
+    struct iovec* cursor = iov;
+    while (count > 0) {
+        const ssize_t n = ::writev(fd, cursor, count);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, std::strerror(errno));
+        }
+        // 部分写入：跳过已写完的段，调整当前段的起点
+        size_t written = static_cast<size_t>(n);
+        while (count > 0 && written >= cursor->iov_len) {
+            written -= cursor->iov_len;
+            ++cursor;
+            --count;
+        }
+        if (count > 0) {
+            cursor->iov_base = static_cast<uint8_t*>(cursor->iov_base) + written;
+            cursor->iov_len -= written;
+        }
+    }
+    return Status::Ok();
+}
+
+Status ReadTensorWire(int fd, std::shared_ptr<Tensor>* tensor) {
+    TensorWireHeader header;
+    Status status = ReadFully(fd, &header, sizeof(TensorWireHeader));
+    if (!status.IsOk()) {
+        return status;
+    }
+    status = ValidateTensorWireHeader(header);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const Shape shape(std::vector<int64_t>(header.dims, header.dims + header.ndims));
+    const DataType dtype = static_cast<DataType>(header.dtype);
+    auto storage = CreateTensor(shape, dtype, DeviceType::CPU);
+    if (header.payload_size > 0) {
+        status = ReadFully(fd, storage->GetData(), static_cast<size_t>(header.payload_size));
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    // 布局随消息还原：包装为持有storage的张量
+    tensor->reset(new Tensor(shape, dtype, storage->GetData(), static_cast<MemoryLayout>(header.layout),
+                             DeviceType::CPU),
+                  [storage](Tensor* view) { delete view; });
+    return Status::Ok();
+}
+#endif
+
+} // namespace inferunity
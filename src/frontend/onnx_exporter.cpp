@@ -0,0 +1,244 @@
+// ONNX模型导出实现
+// 与onnx_parser_impl.cpp的解析过程对应：Value -> ValueInfoProto/TensorProto，Node -> NodeProto
+
+#include "frontend/onnx_exporter.h"
+#include "inferunity/tensor.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef INFERUNITY_USE_ONNX_PROTOBUF
+#include "onnx.pb.h"
+#define USE_ONNX_PROTOBUF 1
+#else
+#if __has_include("onnx.pb.h")
+#include "onnx.pb.h"
+#define USE_ONNX_PROTOBUF 1
+#else
+#define USE_ONNX_PROTOBUF 0
+#endif
+#endif
+
+namespace inferunity {
+namespace frontend {
+
+#if USE_ONNX_PROTOBUF
+
+namespace {
+
+// ONNX TensorProto::DataType (ONNXParser::ConvertDataType的逆映射)
+int32_t ToONNXDataType(DataType dtype) {
+    switch (dtype) {
+        case DataType::FLOAT32: return onnx::TensorProto::FLOAT;
+        case DataType::UINT8: return onnx::TensorProto::UINT8;
+        case DataType::INT8: return onnx::TensorProto::INT8;
+        case DataType::UINT16: return onnx::TensorProto::UINT16;
+        case DataType::INT16: return onnx::TensorProto::INT16;
+        case DataType::INT32: return onnx::TensorProto::INT32;
+        case DataType::INT64: return onnx::TensorProto::INT64;
+        case DataType::STRING: return onnx::TensorProto::STRING;
+        case DataType::BOOL: return onnx::TensorProto::BOOL;
+        case DataType::FLOAT16: return onnx::TensorProto::FLOAT16;
+        case DataType::UINT32: return onnx::TensorProto::UINT32;
+        case DataType::UINT64: return onnx::TensorProto::UINT64;
+        case DataType::BFLOAT16: return onnx::TensorProto::BFLOAT16;
+        default: return onnx::TensorProto::UNDEFINED;
+    }
+}
+
+// 以文本设置的单元素列表会存为INT/FLOAT，这些属性按ONNX定义总是导出为列表
+const std::unordered_set<std::string>& ListAttributeNames() {
+    static const std::unordered_set<std::string> names = {
+        "kernel_shape", "pads", "strides", "dilations", "perm", "axes",
+        "output_shape", "output_padding", "shape", "sizes", "scales", "starts", "ends", "split"
+    };
+    return names;
+}
+
+void ExportTensor(const Tensor& tensor, onnx::TensorProto* proto) {
+    proto->set_data_type(ToONNXDataType(tensor.GetDataType()));
+    for (int64_t dim : tensor.GetShape().dims) {
+        proto->add_dims(dim);
+    }
+    proto->set_raw_data(tensor.GetData(), tensor.GetSizeInBytes());
+}
+
+void ExportAttribute(const std::string& name, const AttributeValue& value, onnx::AttributeProto* attr) {
+    attr->set_name(name);
+    const bool is_list = ListAttributeNames().count(name) > 0;
+    switch (value.GetType()) {
+        case AttributeValue::Type::INT:
+            if (is_list) {
+                attr->set_type(onnx::AttributeProto::INTS);
+                attr->add_ints(value.GetInt());
+            } else {
+                attr->set_type(onnx::AttributeProto::INT);
+                attr->set_i(value.GetInt());
+            }
+            break;
+        case AttributeValue::Type::FLOAT:
+            if (is_list) {
+                attr->set_type(onnx::AttributeProto::FLOATS);
+                attr->add_floats(value.GetFloat());
+            } else {
+                attr->set_type(onnx::AttributeProto::FLOAT);
+                attr->set_f(value.GetFloat());
+            }
+            break;
+        case AttributeValue::Type::INTS:
+            attr->set_type(onnx::AttributeProto::INTS);
+            for (int64_t v : value.GetInts()) {
+                attr->add_ints(v);
+            }
+            break;
+        case AttributeValue::Type::FLOATS:
+            attr->set_type(onnx::AttributeProto::FLOATS);
+            for (float v : value.GetFloats()) {
+                attr->add_floats(v);
+            }
+            break;
+        case AttributeValue::Type::TENSOR:
+            attr->set_type(onnx::AttributeProto::TENSOR);
+            if (value.GetTensor()) {
+                ExportTensor(*value.GetTensor(), attr->mutable_t());
+            }
+            break;
+        case AttributeValue::Type::STRING:
+        default:
+            attr->set_type(onnx::AttributeProto::STRING);
+            attr->set_s(value.GetString());
+            break;
+    }
+}
+
+void ExportValueInfo(const Value* value, const std::string& name, onnx::ValueInfoProto* info) {
+    info->set_name(name);
+    const Tensor* tensor = value->GetTensor().get();
+    if (!tensor) {
+        return;
+    }
+    auto* tensor_type = info->mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(ToONNXDataType(tensor->GetDataType()));
+    auto* shape = tensor_type->mutable_shape();
+    const Shape& tensor_shape = tensor->GetShape();
+    for (size_t i = 0; i < tensor_shape.dims.size(); ++i) {
+        auto* dim = shape->add_dim();
+        bool dynamic = tensor_shape.dims[i] < 0 ||
+                       (i < tensor_shape.is_dynamic.size() && tensor_shape.is_dynamic[i]);
+        if (dynamic) {
+            const bool named = i < tensor_shape.symbols.size() && !tensor_shape.symbols[i].empty();
+            dim->set_dim_param(named ? tensor_shape.symbols[i] : name + "_dim" + std::to_string(i));
+        } else {
+            dim->set_dim_value(tensor_shape.dims[i]);
+        }
+    }
+}
+
+} // namespace
+
+Status ExportToONNX(const Graph& graph, std::string* model_bytes, int64_t opset_version) {
+    if (!model_bytes) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Output buffer is null");
+    }
+    
+    onnx::ModelProto model;
+    model.set_ir_version(7);
+    model.set_producer_name("InferUnity");
+    auto* opset = model.add_opset_import();
+    opset->set_domain("");
+    opset->set_version(opset_version);
+    onnx::GraphProto* onnx_graph = model.mutable_graph();
+    onnx_graph->set_name("inferunity_graph");
+    
+    // 名称在导出的模型内必须唯一
+    std::unordered_map<const Value*, std::string> names;
+    std::unordered_set<std::string> used_names;
+    auto name_of = [&](const Value* value) -> const std::string& {
+        auto it = names.find(value);
+        if (it != names.end()) {
+            return it->second;
+        }
+        std::string name = value->GetName().empty()
+            ? "value_" + std::to_string(value->GetId()) : value->GetName();
+        while (used_names.count(name)) {
+            name += "_" + std::to_string(value->GetId());
+        }
+        used_names.insert(name);
+        return names.emplace(value, name).first->second;
+    };
+    
+    std::unordered_set<const Value*> graph_inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    for (const Value* input : graph.GetInputs()) {
+        ExportValueInfo(input, name_of(input), onnx_graph->add_input());
+    }
+    
+    for (const auto& value : graph.GetValues()) {
+        const Tensor* tensor = value->GetTensor().get();
+        if (value->GetProducer() || graph_inputs.count(value.get()) || !tensor || !tensor->GetData()) {
+            continue;
+        }
+        if (ToONNXDataType(tensor->GetDataType()) == onnx::TensorProto::UNDEFINED) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "Unsupported initializer data type: " + name_of(value.get()));
+        }
+        onnx::TensorProto* init = onnx_graph->add_initializer();
+        init->set_name(name_of(value.get()));
+        ExportTensor(*tensor, init);
+    }
+    
+    for (Node* node : graph.TopologicalSort()) {
+        onnx::NodeProto* onnx_node = onnx_graph->add_node();
+        onnx_node->set_name(node->GetName());
+        onnx_node->set_op_type(node->GetOpType());
+        // input_slots（见解析器）还原为空的可选输入
+        const AttributeValue* slots = node->FindAttribute("input_slots");
+        const auto& inputs = node->GetInputs();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (slots && i < slots->GetInts().size()) {
+                while (onnx_node->input_size() < slots->GetInts()[i]) {
+                    onnx_node->add_input("");
+                }
+            }
+            onnx_node->add_input(name_of(inputs[i]));
+        }
+        for (const Value* output : node->GetOutputs()) {
+            onnx_node->add_output(name_of(output));
+        }
+        for (const auto& attr : node->GetAttributes()) {
+            if (attr.first == "input_slots") {
+                continue;
+            }
+            // 子图已把外层引用改写为图输入，还原为ONNX的隐式捕获前不能导出
+            if (attr.second.GetType() == AttributeValue::Type::GRAPH) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "Exporting subgraph attributes is not supported: " + node->GetName());
+            }
+            ExportAttribute(attr.first, attr.second, onnx_node->add_attribute());
+        }
+    }
+    
+    for (const Value* output : graph.GetOutputs()) {
+        ExportValueInfo(output, name_of(output), onnx_graph->add_output());
+    }
+    
+    if (!model.SerializeToString(model_bytes)) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to serialize ONNX model");
+    }
+    return Status::Ok();
+}
+
+#else
+
+Status ExportToONNX(const Graph& graph, std::string* model_bytes, int64_t opset_version) {
+    (void)graph;
+    (void)model_bytes;
+    (void)opset_version;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                       "ONNX protobuf not available. Please install ONNX protobuf files.");
+}
+
+#endif
+
+} // namespace frontend
+} // namespace inferunity
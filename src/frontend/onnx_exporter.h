@@ -0,0 +1,19 @@
+#pragma once
+
+#include "inferunity/graph.h"
+#include "inferunity/types.h"
+#include <string>
+
+namespace inferunity {
+namespace frontend {
+
+// ONNX模型导出 (ONNXParser的逆过程)：把内部Graph序列化为ONNX ModelProto，
+// 用于把子图交给ONNX Runtime等外部运行时执行
+// - 图输入输出的类型与形状取自Value上的张量，负数维度导出为动态维度
+// - 没有生产者、不是图输入且带数据的Value导出为initializer
+// - 属性按AttributeValue的类型导出；kernel_shape、pads等按ONNX定义总是导出为列表
+// - 没有名称的Value按编号命名为"value_<id>"
+Status ExportToONNX(const Graph& graph, std::string* model_bytes, int64_t opset_version = 13);
+
+} // namespace frontend
+} // namespace inferunity
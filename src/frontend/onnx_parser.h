@@ -4,6 +4,8 @@
 #include "inferunity/types.h"
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace inferunity {
 namespace frontend {
@@ -42,6 +44,14 @@ private:
     // 转换属性
     Status ConvertAttributes(const void* onnx_node, Node* node);
     
+    // 转换节点的子图属性（If/Loop/Scan）：各子图引用的外层名称取并集，按首次出现的顺序
+    // 追加为每个子图末尾的图输入，并由implicit_names返回（指向proto中的字符串），调用方把它们接在节点输入之后
+    Status ConvertSubgraphAttributes(const void* onnx_node, Node* node,
+                                     std::vector<const std::string*>* implicit_names);
+    // 转换一个GraphProto；captured按首次出现的顺序返回子图内没有定义的名称及为其创建的值
+    Status ConvertSubgraph(const void* onnx_graph, std::shared_ptr<Graph>* subgraph,
+                           std::vector<std::pair<const std::string*, Value*>>* captured);
+    
     std::string model_version_;
     std::vector<std::string> input_names_;
     std::vector<std::string> output_names_;
@@ -1,12 +1,17 @@
 #include "frontend/onnx_parser.h"
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
+#include "inferunity/memory.h"
+#include "inferunity/runtime.h"
 #include <fstream>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <memory>
+#include <string_view>
 
 // 如果ONNX protobuf可用，使用它
 #ifdef INFERUNITY_USE_ONNX_PROTOBUF
@@ -25,165 +30,290 @@
 namespace inferunity {
 namespace frontend {
 
-// 简化的ONNX数据结构（当没有protobuf时使用）
-// 参考ONNX Runtime的实现，但简化
-struct SimpleONNXModel {
-    struct Tensor {
-        std::string name;
-        std::vector<int64_t> dims;
-        int32_t data_type;
-        std::vector<uint8_t> raw_data;
+// 解析后的模型 (参考ONNX Runtime直接在GraphProto上构图)：节点、属性与名称都留在ModelProto里，
+// ConvertToGraph直接读取，不再先复制成一份中间结构
+struct ParsedONNXModel {
+    // initializer数据的位置，与graph.initializer()按下标一一对应
+    struct InitializerData {
+        // 外部数据 (data_location = EXTERNAL)：相对模型文件目录的路径与区间，length为0表示到文件末尾
+        std::string external_location;
+        size_t external_offset = 0;
+        size_t external_length = 0;
+        // 从文件加载时raw_data被剥离，数据直接位于模型文件或外部数据文件的映射中；
+        // mapping持有该映射，作为视图的initializer张量各持有一份引用
+        const uint8_t* mapped_data = nullptr;
+        size_t mapped_size = 0;
+        std::shared_ptr<const void> mapping;
     };
-    
-    struct InputInfo {
-        std::string name;
-        std::vector<int64_t> dims;  // 输入形状（可能包含-1或动态维度）
-        int32_t data_type;
-    };
-    
-    struct Node {
-        std::string name;
-        std::string op_type;
-        std::vector<std::string> inputs;
-        std::vector<std::string> outputs;
-        std::unordered_map<std::string, std::string> attributes;
-    };
-    
-    std::string model_version;
-    std::vector<std::string> input_names;
-    std::vector<InputInfo> input_infos;  // 输入信息（包含形状）
-    std::vector<std::string> output_names;
-    std::vector<Tensor> initializers;  // 权重
-    std::vector<Node> nodes;
+
+#if USE_ONNX_PROTOBUF
+    onnx::ModelProto model;
+#endif
+    std::vector<InitializerData> initializers;
 };
 
+namespace {
+
+#if USE_ONNX_PROTOBUF
+
+// initializer的raw_data在映射中的位置
+struct RawDataLocation {
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// AttributeProto -> AttributeValue；TENSOR属性需要数据类型转换，由调用方处理
+AttributeValue AttributeFromProto(const onnx::AttributeProto& attr) {
+    switch (attr.type()) {
+        case onnx::AttributeProto::INT:
+            return AttributeValue(static_cast<int64_t>(attr.i()));
+        case onnx::AttributeProto::FLOAT:
+            return AttributeValue(attr.f());
+        case onnx::AttributeProto::STRING:
+            return AttributeValue(attr.s());
+        case onnx::AttributeProto::INTS:
+            return AttributeValue(std::vector<int64_t>(attr.ints().begin(), attr.ints().end()));
+        case onnx::AttributeProto::FLOATS:
+            return AttributeValue(std::vector<float>(attr.floats().begin(), attr.floats().end()));
+        case onnx::AttributeProto::STRINGS: {
+            // 字符串列表（如LSTM的activations）以逗号连接
+            std::string joined;
+            for (const auto& value : attr.strings()) {
+                joined += (joined.empty() ? "" : ",") + value;
+            }
+            return AttributeValue(joined);
+        }
+        default:
+            return AttributeValue(std::string());
+    }
+}
+
+// 张量属性（如Constant的value）的数据：优先raw_data，其次float_data/int32_data/int64_data
+std::shared_ptr<Tensor> TensorFromProto(const onnx::TensorProto& proto, DataType dtype) {
+    Shape shape(std::vector<int64_t>(proto.dims().begin(), proto.dims().end()));
+    auto tensor = CreateTensor(shape, dtype);
+    const size_t bytes = tensor->GetSizeInBytes();
+    if (!proto.raw_data().empty()) {
+        std::memcpy(tensor->GetData(), proto.raw_data().data(), std::min(bytes, proto.raw_data().size()));
+    } else if (dtype == DataType::FLOAT32) {
+        std::memcpy(tensor->GetData(), proto.float_data().data(),
+                    std::min(bytes, proto.float_data().size() * sizeof(float)));
+    } else if (dtype == DataType::INT64) {
+        std::memcpy(tensor->GetData(), proto.int64_data().data(),
+                    std::min(bytes, proto.int64_data().size() * sizeof(int64_t)));
+    } else if (dtype == DataType::INT32) {
+        std::memcpy(tensor->GetData(), proto.int32_data().data(),
+                    std::min(bytes, proto.int32_data().size() * sizeof(int32_t)));
+    }
+    return tensor;
+}
+
+bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WriteVarint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+// 按protobuf线格式复制消息，去掉initializer的raw_data并记录其在映射中的位置，
+// 使ModelProto的解析不再把权重拷贝一遍。depth: 0为ModelProto，1为GraphProto，2为initializer
+// (ModelProto.graph = 7, GraphProto.initializer = 5, TensorProto.name = 8, TensorProto.raw_data = 9)
+bool StripInitializerData(const uint8_t* p, const uint8_t* end, int depth, const uint8_t* base,
+                          std::string* out, std::string* tensor_name, RawDataLocation* tensor_data,
+                          std::unordered_map<std::string, RawDataLocation>* locations) {
+    while (p < end) {
+        const uint8_t* field_begin = p;
+        uint64_t key;
+        if (!ReadVarint(p, end, &key)) {
+            return false;
+        }
+        const uint64_t field = key >> 3;
+        switch (key & 7) {
+            case 0: {
+                uint64_t value;
+                if (!ReadVarint(p, end, &value)) {
+                    return false;
+                }
+                break;
+            }
+            case 1:
+                if (end - p < 8) {
+                    return false;
+                }
+                p += 8;
+                break;
+            case 5:
+                if (end - p < 4) {
+                    return false;
+                }
+                p += 4;
+                break;
+            case 2: {
+                uint64_t length;
+                if (!ReadVarint(p, end, &length) || length > static_cast<uint64_t>(end - p)) {
+                    return false;
+                }
+                const uint8_t* payload = p;
+                p += length;
+                if ((depth == 0 && field == 7) || (depth == 1 && field == 5)) {
+                    std::string child;
+                    std::string name;
+                    RawDataLocation data;
+                    if (!StripInitializerData(payload, p, depth + 1, base, &child, &name, &data, locations)) {
+                        return false;
+                    }
+                    if (depth == 1 && data.size > 0) {
+                        (*locations)[name] = data;
+                    }
+                    WriteVarint(out, key);
+                    WriteVarint(out, child.size());
+                    out->append(child);
+                    continue;
+                }
+                if (depth == 2 && field == 9) {
+                    tensor_data->offset = static_cast<size_t>(payload - base);
+                    tensor_data->size = static_cast<size_t>(length);
+                    continue;
+                }
+                if (depth == 2 && field == 8) {
+                    tensor_name->assign(reinterpret_cast<const char*>(payload), static_cast<size_t>(length));
+                }
+                break;
+            }
+            default:
+                // 已废弃的group编码，ONNX模型中不会出现
+                return false;
+        }
+        out->append(reinterpret_cast<const char*>(field_begin), static_cast<size_t>(p - field_begin));
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
 ONNXParser::ONNXParser() : model_proto_(nullptr) {
 }
 
 ONNXParser::~ONNXParser() {
     if (model_proto_) {
-        delete static_cast<SimpleONNXModel*>(model_proto_);
+        delete static_cast<ParsedONNXModel*>(model_proto_);
         model_proto_ = nullptr;
     }
 }
 
 Status ONNXParser::LoadFromFile(const std::string& filepath) {
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        return Status::Error(StatusCode::ERROR_NOT_FOUND,
-                           "Cannot open ONNX file: " + filepath);
+    std::shared_ptr<MappedFile> file;
+    Status status = MappedFile::Open(filepath, &file);
+    if (!status.IsOk()) {
+        return status;
     }
-    
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    std::vector<uint8_t> data(size);
-    file.read(reinterpret_cast<char*>(data.data()), size);
-    
-    return LoadFromMemory(data.data(), data.size());
-}
-
-Status ONNXParser::LoadFromMemory(const void* data, size_t size) {
 #if USE_ONNX_PROTOBUF
-    // 使用ONNX protobuf解析
-    onnx::ModelProto model;
-    if (!model.ParseFromArray(data, size)) {
+    // 解析去掉权重的模型骨架，initializer成为映射内的视图
+    std::string skeleton;
+    std::string unused_name;
+    RawDataLocation unused_data;
+    std::unordered_map<std::string, RawDataLocation> locations;
+    const uint8_t* begin = file->GetData();
+    if (!StripInitializerData(begin, begin + file->GetSize(), 0, begin,
+                              &skeleton, &unused_name, &unused_data, &locations)) {
         return Status::Error(StatusCode::ERROR_INVALID_MODEL,
-                            "Failed to parse ONNX model");
+                            "Failed to parse ONNX model: " + filepath);
+    }
+    status = LoadFromMemory(skeleton.data(), skeleton.size());
+    if (!status.IsOk()) {
+        return status;
     }
     
-    // 转换为简化格式以便处理
-    auto* simple_model = new SimpleONNXModel();
-    simple_model->model_version = model.model_version();
-    
-    // 解析输入输出（参考ONNX Runtime的实现）
-    const auto& graph = model.graph();
-    for (const auto& input : graph.input()) {
-        simple_model->input_names.push_back(input.name());
-        
-        // 解析输入形状和类型（参考ONNX Runtime）
-        SimpleONNXModel::InputInfo input_info;
-        input_info.name = input.name();
-        
-        if (input.type().has_tensor_type()) {
-            const auto& tensor_type = input.type().tensor_type();
-            input_info.data_type = tensor_type.elem_type();
-            
-            // 解析形状维度
-            if (tensor_type.has_shape()) {
-                const auto& shape = tensor_type.shape();
-                for (const auto& dim : shape.dim()) {
-                    if (dim.has_dim_value()) {
-                        input_info.dims.push_back(dim.dim_value());
-                    } else if (dim.has_dim_param()) {
-                        // 动态维度，使用-1表示（参考ONNX Runtime）
-                        input_info.dims.push_back(-1);
-                    } else {
-                        // 未知维度，使用-1
-                        input_info.dims.push_back(-1);
-                    }
+    // 外部数据文件同样映射，同一个文件只映射一次
+    const size_t slash = filepath.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? "" : filepath.substr(0, slash + 1);
+    std::unordered_map<std::string, std::shared_ptr<MappedFile>> external_files;
+    auto* parsed = static_cast<ParsedONNXModel*>(model_proto_);
+    const auto& onnx_initializers = parsed->model.graph().initializer();
+    for (int i = 0; i < onnx_initializers.size(); ++i) {
+        const onnx::TensorProto& tensor = onnx_initializers.Get(i);
+        ParsedONNXModel::InitializerData& init = parsed->initializers[i];
+        if (!init.external_location.empty()) {
+            std::shared_ptr<MappedFile>& external = external_files[init.external_location];
+            if (!external) {
+                status = MappedFile::Open(directory + init.external_location, &external);
+                if (!status.IsOk()) {
+                    return status;
                 }
             }
+            const size_t available = init.external_offset <= external->GetSize()
+                ? external->GetSize() - init.external_offset : 0;
+            const size_t length = init.external_length > 0 ? init.external_length : available;
+            if (init.external_offset > external->GetSize() || length > available) {
+                return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                                    "External data out of range for initializer: " + tensor.name());
+            }
+            init.mapped_data = external->GetData() + init.external_offset;
+            init.mapped_size = length;
+            init.mapping = external;
+            continue;
+        }
+        auto it = locations.find(tensor.name());
+        if (it != locations.end() && tensor.raw_data().empty()) {
+            init.mapped_data = begin + it->second.offset;
+            init.mapped_size = it->second.size;
+            init.mapping = file;
         }
-        simple_model->input_infos.push_back(input_info);
-    }
-    for (const auto& output : graph.output()) {
-        simple_model->output_names.push_back(output.name());
     }
-    
-    // 解析初始值（权重）
-    for (const auto& init : graph.initializer()) {
-        SimpleONNXModel::Tensor tensor;
-        tensor.name = init.name();
-        for (int64_t dim : init.dims()) {
-            tensor.dims.push_back(dim);
-        }
-        tensor.data_type = init.data_type();
-        tensor.raw_data = std::vector<uint8_t>(
-            init.raw_data().begin(), init.raw_data().end());
-        simple_model->initializers.push_back(tensor);
+    return Status::Ok();
+#else
+    return LoadFromMemory(file->GetData(), file->GetSize());
+#endif
+}
+
+Status ONNXParser::LoadFromMemory(const void* data, size_t size) {
+#if USE_ONNX_PROTOBUF
+    // 使用ONNX protobuf解析，解析结果直接作为构图的输入
+    auto parsed = std::make_unique<ParsedONNXModel>();
+    if (!parsed->model.ParseFromArray(data, static_cast<int>(size))) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                            "Failed to parse ONNX model");
     }
     
-    // 解析节点
-    for (const auto& onnx_node : graph.node()) {
-        SimpleONNXModel::Node node;
-        node.name = onnx_node.name();
-        node.op_type = onnx_node.op_type();
-        for (const std::string& input : onnx_node.input()) {
-            node.inputs.push_back(input);
-        }
-        for (const std::string& output : onnx_node.output()) {
-            node.outputs.push_back(output);
+    // 只记录外部数据的位置，raw_data留在ModelProto中
+    const auto& onnx_initializers = parsed->model.graph().initializer();
+    parsed->initializers.resize(static_cast<size_t>(onnx_initializers.size()));
+    for (int i = 0; i < onnx_initializers.size(); ++i) {
+        const onnx::TensorProto& init = onnx_initializers.Get(i);
+        if (init.data_location() != onnx::TensorProto::EXTERNAL) {
+            continue;
         }
-        
-        // 解析属性
-        for (const auto& attr : onnx_node.attribute()) {
-            std::string value;
-            if (attr.type() == onnx::AttributeProto::INT) {
-                value = std::to_string(attr.i());
-            } else if (attr.type() == onnx::AttributeProto::FLOAT) {
-                value = std::to_string(attr.f());
-            } else if (attr.type() == onnx::AttributeProto::STRING) {
-                value = attr.s();
-            } else if (attr.type() == onnx::AttributeProto::INTS) {
-                for (int64_t v : attr.ints()) {
-                    if (!value.empty()) value += ",";
-                    value += std::to_string(v);
-                }
-            } else if (attr.type() == onnx::AttributeProto::FLOATS) {
-                for (float v : attr.floats()) {
-                    if (!value.empty()) value += ",";
-                    value += std::to_string(v);
-                }
+        ParsedONNXModel::InitializerData& tensor = parsed->initializers[i];
+        for (const auto& entry : init.external_data()) {
+            if (entry.key() == "location") {
+                tensor.external_location = entry.value();
+            } else if (entry.key() == "offset") {
+                tensor.external_offset = static_cast<size_t>(std::stoull(entry.value()));
+            } else if (entry.key() == "length") {
+                tensor.external_length = static_cast<size_t>(std::stoull(entry.value()));
             }
-            node.attributes[attr.name()] = value;
         }
-        
-        simple_model->nodes.push_back(node);
     }
     
-    model_proto_ = simple_model;
+    if (model_proto_) {
+        delete static_cast<ParsedONNXModel*>(model_proto_);
+    }
+    model_proto_ = parsed.release();
     return Status::Ok();
 #else
     // 没有protobuf时的简化实现
@@ -200,153 +330,345 @@ Status ONNXParser::ConvertToGraph(std::unique_ptr<Graph>& graph) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                            "Model not loaded");
     }
-    
-    auto* simple_model = static_cast<SimpleONNXModel*>(model_proto_);
+#if USE_ONNX_PROTOBUF
+    auto* parsed = static_cast<ParsedONNXModel*>(model_proto_);
+    const onnx::GraphProto& onnx_graph = parsed->model.graph();
     graph = std::make_unique<Graph>();
+    input_names_.clear();
+    output_names_.clear();
     
-    // 1. 创建输入Value节点和初始值（权重）的Value节点
-    // 注意：在ONNX中，初始值可能同时出现在graph.input和graph.initializer中
-    // 我们需要先处理初始值，然后处理输入（如果输入不在初始值中）
-    std::unordered_map<std::string, Value*> name_to_value;
-    int64_t value_id = 0;
-    
-    // 先创建初始值（权重）的Value节点
-    std::unordered_set<std::string> initializer_names;
-    for (const auto& init : simple_model->initializers) {
+    // 名称表的键引用ModelProto中的字符串，构图期间不复制名称；
+    // Graph的增删不是线程安全的，Value与Node的创建和连接串行进行，
+    // 权重张量的构造（可能需要拷贝数据）与属性转换按块并行
+    size_t num_values = static_cast<size_t>(onnx_graph.initializer_size() + onnx_graph.input_size());
+    for (const auto& onnx_node : onnx_graph.node()) {
+        num_values += static_cast<size_t>(onnx_node.output_size());
+    }
+    std::unordered_map<std::string_view, Value*> name_to_value;
+    name_to_value.reserve(num_values);
+    auto add_named_value = [&graph, &name_to_value](const std::string& name) {
         Value* value = graph->AddValue();
-        value->SetId(value_id++);
-        
-        // 创建张量并填充数据
-        Shape shape(init.dims);
-        DataType dtype = ConvertDataType(init.data_type);
-        auto tensor = CreateTensor(shape, dtype);
-        
-        // 复制数据
-        if (!init.raw_data.empty()) {
-            std::memcpy(tensor->GetData(), init.raw_data.data(),
-                       std::min(init.raw_data.size(), tensor->GetSizeInBytes()));
-        }
-        
-        value->SetTensor(tensor);
-        name_to_value[init.name] = value;
-        initializer_names.insert(init.name);
+        value->SetName(name);
+        name_to_value[name] = value;
+        return value;
+    };
+    
+    // 1. 初始值（权重）的Value；ONNX中初始值可能同时出现在graph.input和graph.initializer中，先处理初始值
+    const int num_initializers = onnx_graph.initializer_size();
+    std::vector<Value*> initializer_values(static_cast<size_t>(num_initializers));
+    for (int i = 0; i < num_initializers; ++i) {
+        initializer_values[i] = add_named_value(onnx_graph.initializer(i).name());
     }
+    ThreadPool::ParallelFor(0, num_initializers, 16, [&](int64_t chunk_begin, int64_t chunk_end) {
+        for (int64_t i = chunk_begin; i < chunk_end; ++i) {
+            const onnx::TensorProto& onnx_tensor = onnx_graph.initializer(static_cast<int>(i));
+            const ParsedONNXModel::InitializerData& init = parsed->initializers[i];
+            Shape shape(std::vector<int64_t>(onnx_tensor.dims().begin(), onnx_tensor.dims().end()));
+            DataType dtype = ConvertDataType(onnx_tensor.data_type());
+            const size_t bytes = shape.GetElementCount() * Tensor::GetDataTypeSize(dtype);
+            const size_t element_size = std::max<size_t>(Tensor::GetDataTypeSize(dtype), 1);
+            std::shared_ptr<Tensor> tensor;
+            if (init.mapped_data && init.mapped_size == bytes && bytes > 0 &&
+                reinterpret_cast<uintptr_t>(init.mapped_data) % element_size == 0) {
+                // 不拷贝：张量是文件映射的视图，删除器持有映射，图中的权重存活期间映射不会释放
+                auto mapping = init.mapping;
+                tensor = std::shared_ptr<Tensor>(
+                    new Tensor(shape, dtype, const_cast<uint8_t*>(init.mapped_data)),
+                    [mapping](Tensor* view) { delete view; });
+            } else {
+                tensor = CreateTensor(shape, dtype);
+                // 复制数据（映射中的数据未按元素对齐或类型被转换时也走这里）
+                const uint8_t* source = init.mapped_data ? init.mapped_data
+                    : reinterpret_cast<const uint8_t*>(onnx_tensor.raw_data().data());
+                const size_t source_size = init.mapped_data ? init.mapped_size : onnx_tensor.raw_data().size();
+                if (source_size > 0) {
+                    std::memcpy(tensor->GetData(), source, std::min(source_size, tensor->GetSizeInBytes()));
+                }
+            }
+            initializer_values[i]->SetTensor(tensor);
+        }
+    });
     
     // 然后创建图输入Value节点（排除已经是初始值的）
     // 参考ONNX Runtime：对于有明确形状的输入，预先创建Tensor
-    for (size_t i = 0; i < simple_model->input_names.size(); ++i) {
-        const std::string& input_name = simple_model->input_names[i];
-        const auto& input_info = simple_model->input_infos[i];
-        
-        // 如果输入名称已经在初始值中，跳过（初始值已经创建了Value）
-        if (initializer_names.find(input_name) != initializer_names.end()) {
-            // 这个输入是初始值，已经创建了Value，只需要记录名称
-            input_names_.push_back(input_name);
+    for (const auto& input : onnx_graph.input()) {
+        input_names_.push_back(input.name());
+        if (name_to_value.count(input.name())) {
+            // 这个输入是初始值，已经创建了Value
             continue;
         }
         
-        // 这是真正的图输入（不是初始值）
-        Value* value = graph->AddValue();
-        value->SetId(value_id++);
-        
-        // 如果输入有明确的形状（不是动态维度），创建Tensor并设置形状
-        // 参考ONNX Runtime：预先创建Tensor以便形状推断
-        bool has_concrete_shape = true;
-        for (int64_t dim : input_info.dims) {
-            if (dim < 0) {
-                has_concrete_shape = false;
-                break;
+        Value* value = add_named_value(input.name());
+        // 解析输入形状和类型；动态或未知维度记为-1，此时只创建不分配内存的形状张量，
+        // dim_param作为符号名供形状推断传播
+        if (input.type().has_tensor_type() && input.type().tensor_type().has_shape()) {
+            const auto& tensor_type = input.type().tensor_type();
+            Shape shape;
+            bool has_concrete_shape = true;
+            for (const auto& dim : tensor_type.shape().dim()) {
+                const bool concrete = dim.has_dim_value() && dim.dim_value() >= 0;
+                shape.dims.push_back(concrete ? dim.dim_value() : -1);
+                shape.is_dynamic.push_back(!concrete);
+                shape.symbols.push_back(concrete ? std::string() : dim.dim_param());
+                has_concrete_shape = has_concrete_shape && concrete;
+            }
+            const DataType dtype = ConvertDataType(tensor_type.elem_type());
+            if (has_concrete_shape && !shape.dims.empty()) {
+                value->SetTensor(CreateTensor(Shape(shape.dims), dtype));
+            } else if (!has_concrete_shape) {
+                value->SetTensor(std::make_shared<Tensor>(shape, dtype, nullptr));
             }
         }
-        
-        if (has_concrete_shape && !input_info.dims.empty()) {
-            Shape input_shape(input_info.dims);
-            DataType input_dtype = ConvertDataType(input_info.data_type);
-            auto input_tensor = CreateTensor(input_shape, input_dtype);
-            value->SetTensor(input_tensor);
-        }
-        
-        name_to_value[input_name] = value;
         graph->AddInput(value);
-        input_names_.push_back(input_name);
     }
     
-    // 2. 解析节点，构建计算图
-    for (const auto& onnx_node : simple_model->nodes) {
-        Node* node = graph->AddNode(onnx_node.op_type, onnx_node.name);
-        
-        // 设置属性
-        for (const auto& attr : onnx_node.attributes) {
-            node->SetAttribute(attr.first, attr.second);
-        }
-        
-        // 连接输入
-        for (const std::string& input_name : onnx_node.inputs) {
-            // 跳过空字符串（ONNX中某些输入可能为空）
+    // 2. 按拓扑序创建节点并连接；未出现过的输入名（如引用了后面节点的输出）创建新的Value
+    const int num_nodes = onnx_graph.node_size();
+    std::vector<Node*> nodes(static_cast<size_t>(num_nodes));
+    for (int i = 0; i < num_nodes; ++i) {
+        const onnx::NodeProto& onnx_node = onnx_graph.node(i);
+        Node* node = graph->AddNode(onnx_node.op_type(), onnx_node.name());
+        // 跳过空字符串（ONNX中可选输入可能为空）；空输入之后还有输入时，把各输入在ONNX中的位置记为
+        // input_slots属性（如MatMulNBits省略zero_points但带bias），供算子按位置取可选输入
+        std::vector<int64_t> slots;
+        bool has_gap = false;
+        for (int slot = 0; slot < onnx_node.input_size(); ++slot) {
+            const std::string& input_name = onnx_node.input(slot);
             if (input_name.empty()) {
+                has_gap = true;
                 continue;
             }
-            
             auto it = name_to_value.find(input_name);
-            if (it != name_to_value.end()) {
-                node->AddInput(it->second);
-            } else {
-                // 输入不存在，可能是：
-                // 1. 中间结果（之前节点的输出）
-                // 2. 初始值（权重）但名称不匹配
-                // 3. 图输入但名称不匹配
-                // 先检查是否是初始值（权重），ONNX中初始值可能同时出现在input和initializer中
-                bool found_in_initializers = false;
-                for (const auto& init : simple_model->initializers) {
-                    if (init.name == input_name) {
-                        // 这是初始值，应该已经创建了，但可能名称不匹配
-                        // 重新查找或创建
-                        found_in_initializers = true;
-                        break;
-                    }
+            node->AddInput(it != name_to_value.end() ? it->second : add_named_value(input_name));
+            slots.push_back(slot);
+        }
+        // 子图引用的外层值作为末尾的输入
+        std::vector<const std::string*> implicit_names;
+        Status status = ConvertSubgraphAttributes(&onnx_node, node, &implicit_names);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (size_t k = 0; k < implicit_names.size(); ++k) {
+            auto it = name_to_value.find(*implicit_names[k]);
+            node->AddInput(it != name_to_value.end() ? it->second : add_named_value(*implicit_names[k]));
+            slots.push_back(onnx_node.input_size() + static_cast<int64_t>(k));
+        }
+        if (has_gap && !slots.empty() && slots.back() + 1 != static_cast<int64_t>(slots.size())) {
+            node->SetAttribute("input_slots", AttributeValue(slots));
+        }
+        for (const std::string& output_name : onnx_node.output()) {
+            node->AddOutput(add_named_value(output_name));
+        }
+        nodes[i] = node;
+    }
+    
+    // 3. 其余属性按类型转换，只写各自的节点，按块并行
+    ThreadPool::ParallelFor(0, num_nodes, 256, [&](int64_t chunk_begin, int64_t chunk_end) {
+        for (int64_t i = chunk_begin; i < chunk_end; ++i) {
+            for (const auto& attr : onnx_graph.node(static_cast<int>(i)).attribute()) {
+                if (attr.type() == onnx::AttributeProto::GRAPH) {
+                    continue;  // 已在第2步转换
                 }
-                
-                if (!found_in_initializers) {
-                    // 这是中间结果（之前节点的输出），创建新的Value
-                    Value* value = graph->AddValue();
-                    value->SetId(value_id++);
-                    name_to_value[input_name] = value;
-                    node->AddInput(value);
+                if (attr.type() == onnx::AttributeProto::TENSOR) {
+                    nodes[i]->SetAttribute(attr.name(), AttributeValue(
+                        TensorFromProto(attr.t(), ConvertDataType(attr.t().data_type()))));
                 } else {
-                    // 是初始值但没找到，说明解析有问题，创建新Value并记录警告
-                    Value* value = graph->AddValue();
-                    value->SetId(value_id++);
-                    name_to_value[input_name] = value;
-                    node->AddInput(value);
+                    nodes[i]->SetAttribute(attr.name(), AttributeFromProto(attr));
                 }
             }
         }
-        
-        // 创建输出Value
-        for (const std::string& output_name : onnx_node.outputs) {
-            Value* value = graph->AddValue();
-            value->SetId(value_id++);
-            name_to_value[output_name] = value;
-            node->AddOutput(value);
-        }
-    }
+    });
     
     // 4. 设置图输出
-    for (const std::string& output_name : simple_model->output_names) {
-        auto it = name_to_value.find(output_name);
+    for (const auto& output : onnx_graph.output()) {
+        auto it = name_to_value.find(output.name());
         if (it != name_to_value.end()) {
             graph->AddOutput(it->second);
-            output_names_.push_back(output_name);
+            output_names_.push_back(output.name());
         }
     }
     
     // 5. 验证图
-    Status status = graph->Validate();
-    if (!status.IsOk()) {
-        return status;
+    return graph->Validate();
+#else
+    (void)graph;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                       "ONNX protobuf not available. Please install ONNX protobuf files.");
+#endif
+}
+
+Status ONNXParser::ConvertSubgraphAttributes(const void* onnx_node, Node* node,
+                                             std::vector<const std::string*>* implicit_names) {
+#if USE_ONNX_PROTOBUF
+    const auto& proto = *static_cast<const onnx::NodeProto*>(onnx_node);
+    struct Branch {
+        const std::string* name;
+        std::shared_ptr<Graph> graph;
+        std::vector<std::pair<const std::string*, Value*>> captured;
+    };
+    std::vector<Branch> branches;
+    std::unordered_set<std::string_view> seen;
+    for (const auto& attr : proto.attribute()) {
+        if (attr.type() == onnx::AttributeProto::GRAPHS) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "GRAPHS attributes are not supported: " + proto.name() + "." + attr.name());
+        }
+        if (attr.type() != onnx::AttributeProto::GRAPH) {
+            continue;
+        }
+        Branch branch;
+        branch.name = &attr.name();
+        Status status = ConvertSubgraph(&attr.g(), &branch.graph, &branch.captured);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (const auto& entry : branch.captured) {
+            if (seen.insert(*entry.first).second) {
+                implicit_names->push_back(entry.first);
+            }
+        }
+        branches.push_back(std::move(branch));
+    }
+    if (branches.empty()) {
+        return Status::Ok();
+    }
+    
+    // 各分支按同一顺序接收全部外层值（If的两个分支引用的值可能不同），未引用的输入不连接任何节点
+    for (Branch& branch : branches) {
+        std::unordered_map<std::string_view, Value*> captured;
+        for (const auto& entry : branch.captured) {
+            captured.emplace(*entry.first, entry.second);
+        }
+        for (const std::string* name : *implicit_names) {
+            Value* value = nullptr;
+            auto it = captured.find(*name);
+            if (it != captured.end()) {
+                value = it->second;
+            } else {
+                value = branch.graph->AddValue();
+                value->SetName(*name);
+            }
+            branch.graph->AddInput(value);
+        }
+        Status status = branch.graph->Validate();
+        if (!status.IsOk()) {
+            return Status::Error(status.Code(), "Invalid subgraph " + proto.name() + "." + *branch.name +
+                               ": " + status.Message());
+        }
+        node->SetAttribute(*branch.name, AttributeValue(branch.graph));
+    }
+    node->SetAttribute("num_implicit_inputs", AttributeValue(static_cast<int64_t>(implicit_names->size())));
+    return Status::Ok();
+#else
+    (void)onnx_node;
+    (void)node;
+    (void)implicit_names;
+    return Status::Ok();
+#endif
+}
+
+Status ONNXParser::ConvertSubgraph(const void* onnx_graph, std::shared_ptr<Graph>* subgraph,
+                                   std::vector<std::pair<const std::string*, Value*>>* captured) {
+#if USE_ONNX_PROTOBUF
+    const auto& proto = *static_cast<const onnx::GraphProto*>(onnx_graph);
+    auto graph = std::make_shared<Graph>();
+    std::unordered_map<std::string_view, Value*> name_to_value;
+    auto add_named_value = [&graph, &name_to_value](const std::string& name) {
+        Value* value = graph->AddValue();
+        value->SetName(name);
+        name_to_value[name] = value;
+        return value;
+    };
+    // 子图内没有定义的名称引用外层作用域
+    auto resolve = [&](const std::string& name) {
+        auto it = name_to_value.find(name);
+        if (it != name_to_value.end()) {
+            return it->second;
+        }
+        Value* value = add_named_value(name);
+        captured->emplace_back(&name, value);
+        return value;
+    };
+    
+    // 子图的初始值不经过文件映射（StripInitializerData只处理顶层图），数据留在proto中
+    for (const auto& initializer : proto.initializer()) {
+        add_named_value(initializer.name())->SetTensor(
+            TensorFromProto(initializer, ConvertDataType(initializer.data_type())));
+    }
+    // 形式输入（Loop的迭代号与条件等）只记录形状与类型，不分配数据，避免被当作常量
+    for (const auto& input : proto.input()) {
+        if (name_to_value.count(input.name())) {
+            continue;
+        }
+        Value* value = add_named_value(input.name());
+        if (input.type().has_tensor_type()) {
+            const auto& tensor_type = input.type().tensor_type();
+            Shape shape;
+            for (const auto& dim : tensor_type.shape().dim()) {
+                const bool concrete = dim.has_dim_value() && dim.dim_value() >= 0;
+                shape.dims.push_back(concrete ? dim.dim_value() : -1);
+                shape.is_dynamic.push_back(!concrete);
+                shape.symbols.push_back(concrete ? std::string() : dim.dim_param());
+            }
+            value->SetTensor(std::make_shared<Tensor>(shape, ConvertDataType(tensor_type.elem_type()), nullptr));
+        }
+        graph->AddInput(value);
     }
     
+    for (const auto& onnx_node : proto.node()) {
+        Node* node = graph->AddNode(onnx_node.op_type(), onnx_node.name());
+        std::vector<int64_t> slots;
+        bool has_gap = false;
+        for (int slot = 0; slot < onnx_node.input_size(); ++slot) {
+            if (onnx_node.input(slot).empty()) {
+                has_gap = true;
+                continue;
+            }
+            node->AddInput(resolve(onnx_node.input(slot)));
+            slots.push_back(slot);
+        }
+        // 嵌套子图捕获的名称在本层同样可能来自更外层
+        std::vector<const std::string*> implicit_names;
+        Status status = ConvertSubgraphAttributes(&onnx_node, node, &implicit_names);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (size_t k = 0; k < implicit_names.size(); ++k) {
+            node->AddInput(resolve(*implicit_names[k]));
+            slots.push_back(onnx_node.input_size() + static_cast<int64_t>(k));
+        }
+        if (has_gap && !slots.empty() && slots.back() + 1 != static_cast<int64_t>(slots.size())) {
+            node->SetAttribute("input_slots", AttributeValue(slots));
+        }
+        for (const std::string& output_name : onnx_node.output()) {
+            node->AddOutput(add_named_value(output_name));
+        }
+        for (const auto& attr : onnx_node.attribute()) {
+            if (attr.type() == onnx::AttributeProto::GRAPH) {
+                continue;
+            }
+            if (attr.type() == onnx::AttributeProto::TENSOR) {
+                node->SetAttribute(attr.name(), AttributeValue(
+                    TensorFromProto(attr.t(), ConvertDataType(attr.t().data_type()))));
+            } else {
+                node->SetAttribute(attr.name(), AttributeFromProto(attr));
+            }
+        }
+    }
+    
+    // 输出可以直接是外层的值
+    for (const auto& output : proto.output()) {
+        graph->AddOutput(resolve(output.name()));
+    }
+    *subgraph = std::move(graph);
     return Status::Ok();
+#else
+    (void)onnx_graph;
+    (void)subgraph;
+    (void)captured;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                       "ONNX protobuf not available. Please install ONNX protobuf files.");
+#endif
 }
 
 Status ONNXParser::ParseNode(const void* onnx_node, Node* node) {
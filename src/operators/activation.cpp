@@ -3,6 +3,8 @@
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
 #include <algorithm>
 #include <cmath>
 
@@ -10,9 +12,10 @@ namespace inferunity {
 namespace operators {
 
 // ReLU算子
-class ReluOperator : public Operator {
+class ReluOperator : public TensorViewOperator {
 public:
     std::string GetName() const override { return "Relu"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -27,25 +30,20 @@ public:
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
+    Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        size_t count = input->GetElementCount();
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
+    
+        const int64_t count = inputs[0].GetElementCount();
+        const float* input_data = inputs[0].Data<const float>();
+        float* output_data = outputs[0].Data<float>();
+    
         // ReLU: max(0, x)
-        for (size_t i = 0; i < count; ++i) {
-            output_data[i] = std::max(0.0f, input_data[i]);
-        }
-        
+        ParallelForElements(ctx, count, [&](int64_t begin, int64_t end) {
+            simd::ReluSIMD(input_data + begin, output_data + begin, static_cast<size_t>(end - begin));
+        });
+    
         return Status::Ok();
     }
 };
@@ -53,9 +51,10 @@ public:
 REGISTER_OPERATOR("Relu", ReluOperator);
 
 // Sigmoid算子
-class SigmoidOperator : public Operator {
+class SigmoidOperator : public TensorViewOperator {
 public:
     std::string GetName() const override { return "Sigmoid"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -70,25 +69,20 @@ public:
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
+    Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        size_t count = input->GetElementCount();
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
+    
+        const int64_t count = inputs[0].GetElementCount();
+        const float* input_data = inputs[0].Data<const float>();
+        float* output_data = outputs[0].Data<float>();
+    
         // Sigmoid: 1 / (1 + exp(-x))
-        for (size_t i = 0; i < count; ++i) {
-            output_data[i] = 1.0f / (1.0f + std::exp(-input_data[i]));
-        }
-        
+        ParallelForElements(ctx, count, [&](int64_t begin, int64_t end) {
+            simd::SigmoidSIMD(input_data + begin, output_data + begin, static_cast<size_t>(end - begin));
+        });
+    
         return Status::Ok();
     }
 };
@@ -96,9 +90,10 @@ public:
 REGISTER_OPERATOR("Sigmoid", SigmoidOperator);
 
 // Tanh算子
-class TanhOperator : public Operator {
+class TanhOperator : public TensorViewOperator {
 public:
     std::string GetName() const override { return "Tanh"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -113,25 +108,20 @@ public:
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
+    Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        size_t count = input->GetElementCount();
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
+    
+        const int64_t count = inputs[0].GetElementCount();
+        const float* input_data = inputs[0].Data<const float>();
+        float* output_data = outputs[0].Data<float>();
+    
         // Tanh: tanh(x)
-        for (size_t i = 0; i < count; ++i) {
-            output_data[i] = std::tanh(input_data[i]);
-        }
-        
+        ParallelForElements(ctx, count, [&](int64_t begin, int64_t end) {
+            simd::TanhSIMD(input_data + begin, output_data + begin, static_cast<size_t>(end - begin));
+        });
+    
         return Status::Ok();
     }
 };
@@ -140,10 +130,11 @@ REGISTER_OPERATOR("Tanh", TanhOperator);
 
 // GELU算子（Gaussian Error Linear Unit，Transformer常用）
 // GELU(x) = x * 0.5 * (1 + erf(x / sqrt(2)))
-// 近似实现：GELU(x) ≈ 0.5 * x * (1 + tanh(sqrt(2/π) * (x + 0.044715 * x^3)))
-class GeluOperator : public Operator {
+// tanh近似（approximate="tanh"）：GELU(x) ≈ 0.5 * x * (1 + tanh(sqrt(2/π) * (x + 0.044715 * x^3)))
+class GeluOperator : public TensorViewOperator {
 public:
     std::string GetName() const override { return "Gelu"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -158,33 +149,33 @@ public:
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
+    Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        size_t count = input->GetElementCount();
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
-        // GELU近似实现：0.5 * x * (1 + tanh(sqrt(2/π) * (x + 0.044715 * x^3)))
-        const float sqrt_2_over_pi = 0.7978845608f;  // sqrt(2/π)
-        const float coeff = 0.044715f;
-        
-        for (size_t i = 0; i < count; ++i) {
-            float x = input_data[i];
-            float x3 = x * x * x;
-            float inner = sqrt_2_over_pi * (x + coeff * x3);
-            output_data[i] = 0.5f * x * (1.0f + std::tanh(inner));
-        }
-        
+    
+        const int64_t count = inputs[0].GetElementCount();
+        const float* input_data = inputs[0].Data<const float>();
+        float* output_data = outputs[0].Data<float>();
+    
+        ParallelForElements(ctx, count, [&](int64_t begin, int64_t end) {
+            simd::GeluSIMD(input_data + begin, output_data + begin,
+                           static_cast<size_t>(end - begin), tanh_approximation_);
+        });
+    
         return Status::Ok();
     }
+    
+    // approximate="tanh"时使用tanh近似，否则使用erf精确形式（ONNX Gelu默认"none"）；设置属性时解析一次
+    void SetAttribute(const std::string& key, const AttributeValue& value) override {
+        Operator::SetAttribute(key, value);
+        if (key == "approximate") {
+            tanh_approximation_ = value.GetType() == AttributeValue::Type::STRING && value.GetString() == "tanh";
+        }
+    }
+
+private:
+    bool tanh_approximation_ = false;
 };
 
 REGISTER_OPERATOR("Gelu", GeluOperator);
@@ -192,9 +183,10 @@ REGISTER_OPERATOR("Gelu", GeluOperator);
 
 // SiLU算子（Sigmoid Linear Unit，Swish激活函数）
 // SiLU(x) = x * sigmoid(x) = x / (1 + exp(-x))
-class SiluOperator : public Operator {
+class SiluOperator : public TensorViewOperator {
 public:
     std::string GetName() const override { return "Silu"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -209,27 +201,20 @@ public:
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
+    Status ExecuteViews(TensorViewSpan inputs, TensorViewSpan outputs, ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        size_t count = input->GetElementCount();
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
+    
+        const int64_t count = inputs[0].GetElementCount();
+        const float* input_data = inputs[0].Data<const float>();
+        float* output_data = outputs[0].Data<float>();
+    
         // SiLU: x * sigmoid(x) = x / (1 + exp(-x))
-        for (size_t i = 0; i < count; ++i) {
-            float x = input_data[i];
-            float sigmoid_x = 1.0f / (1.0f + std::exp(-x));
-            output_data[i] = x * sigmoid_x;
-        }
-        
+        ParallelForElements(ctx, count, [&](int64_t begin, int64_t end) {
+            simd::SiluSIMD(input_data + begin, output_data + begin, static_cast<size_t>(end - begin));
+        });
+    
         return Status::Ok();
     }
 };
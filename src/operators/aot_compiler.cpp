@@ -0,0 +1,753 @@
+// 静态图AOT编译实现
+// 按执行顺序为每个节点生成一次aot_kernels.h内核调用：形状与属性在这里由算子的属性解析
+// （与算子实例相同的默认值）后写成字面量；值的地址按以下规则确定：
+//   图输入/输出为inputs[i]/outputs[j]，常量为权重blob内的偏移，规划的中间张量为arena内的偏移，
+//   未规划的Reshape/Flatten/Dropout输出是输入的视图，与输入同址
+// 生成的代码只依赖aot_kernels.h，不包含图、算子或张量
+
+#include "inferunity/aot_compiler.h"
+#include "inferunity/aot_kernels.h"
+#include "inferunity/graph.h"
+#include "inferunity/memory_planner.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "conv_kernels.h"
+#include "matmul_kernels.h"
+#include "pooling.h"
+#include "core/align_utils.h"
+#include "optimizers/fusion_pattern.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+constexpr size_t kWeightAlignment = 64;
+
+std::string FloatLiteral(float value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string text = buffer;
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+    return text + "f";
+}
+
+std::string BoolLiteral(bool value) {
+    return value ? "true" : "false";
+}
+
+std::string DimsToString(const Shape& shape) {
+    std::string text = "[";
+    for (size_t i = 0; i < shape.dims.size(); ++i) {
+        text += (i ? ", " : "") + std::to_string(shape.dims[i]);
+    }
+    return text + "]";
+}
+
+int64_t NormalizeAxis(int64_t axis, size_t rank) {
+    return axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+}
+
+// 值是否被使用（有消费者或是图输出）
+bool IsUsed(const Graph& graph, const Value* value) {
+    return !value->GetConsumers().empty() || fusion::IsGraphOutput(graph, value);
+}
+
+// 操作数广播后的长度：与输出相同、标量，或去掉前导1后为输出形状的后缀；其余形状返回-1
+int64_t SuffixBroadcastSize(const Shape& operand, const Shape& output) {
+    const int64_t count = operand.GetElementCount();
+    if (count == output.GetElementCount() || count == 1) {
+        return count;
+    }
+    size_t first = 0;
+    while (first < operand.dims.size() && operand.dims[first] == 1) {
+        ++first;
+    }
+    const size_t rank = operand.dims.size() - first;
+    if (rank > output.dims.size() ||
+        !std::equal(operand.dims.begin() + first, operand.dims.end(), output.dims.end() - rank)) {
+        return -1;
+    }
+    return count;
+}
+
+class AotCodegen {
+public:
+    AotCodegen(const Graph& graph, const MemoryPlan& plan, const AotCompileOptions& options)
+        : graph_(graph), plan_(plan), options_(options) {}
+    
+    Status Run(AotCompileResult* result);
+
+private:
+    Status Unsupported(const std::string& reason) const {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, reason);
+    }
+    
+    // 参与计算的值：FLOAT32、形状静态，返回其指针表达式；常量首次使用时放入权重blob
+    Status Input(const Value* value, std::string* expr, Shape* shape = nullptr);
+    // 节点输出的指针表达式（规划的中间张量或图输出），须可写
+    Status Output(const Value* value, std::string* expr, Shape* shape = nullptr);
+    Status CheckTensor(const Value* value, Shape* shape) const;
+    
+    Status EmitNode(const Node& node, const Operator& op);
+    Status EmitGemm(const Node& node, const Operator& op);
+    Status EmitBinary(const Node& node);
+    Status EmitUnary(const Node& node, const Operator& op);
+    Status EmitSoftmax(const Node& node, const Operator& op);
+    Status EmitNorm(const Node& node, const Operator& op);
+    Status EmitConv(const Node& node, const Operator& op);
+    Status EmitPool(const Node& node, const Operator& op);
+    Status EmitGlobalAveragePool(const Node& node);
+    Status EmitConcat(const Node& node, const Operator& op);
+    Status EmitCopy(const Node& node);
+    
+    // 当前节点的一行代码，节点生成成功后才并入函数体
+    void Line(const std::string& text) { pending_.push_back(text); }
+    static std::string ArenaExpr(size_t byte_offset) {
+        return "buffer + " + std::to_string(byte_offset / sizeof(float));
+    }
+    
+    std::string GenerateSource(size_t arena_size) const;
+    std::string GenerateHeader() const;
+    std::string GenerateWeightsSource() const;
+    
+    const Graph& graph_;
+    const MemoryPlan& plan_;
+    const AotCompileOptions& options_;
+    std::unordered_map<const Value*, std::string> refs_;
+    std::unordered_set<const Value*> writable_;
+    std::vector<uint8_t> weights_;
+    size_t workspace_bytes_ = 0;
+    std::vector<std::string> pending_;
+    std::vector<std::string> body_;
+    size_t num_calls_ = 0;
+};
+
+Status AotCodegen::CheckTensor(const Value* value, Shape* shape) const {
+    if (!value || !value->GetTensor()) {
+        return Unsupported("value without tensor info");
+    }
+    const Shape& value_shape = value->GetTensor()->GetShape();
+    if (value_shape.IsDynamic() ||
+        std::any_of(value_shape.dims.begin(), value_shape.dims.end(), [](int64_t d) { return d < 0; })) {
+        return Unsupported("value '" + value->GetName() + "' has a dynamic shape");
+    }
+    if (value->GetTensor()->GetDataType() != DataType::FLOAT32) {
+        return Unsupported("value '" + value->GetName() + "' is not FLOAT32");
+    }
+    if (shape) {
+        *shape = value_shape;
+    }
+    return Status::Ok();
+}
+
+Status AotCodegen::Input(const Value* value, std::string* expr, Shape* shape) {
+    Status status = CheckTensor(value, shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    auto it = refs_.find(value);
+    if (it != refs_.end()) {
+        *expr = it->second;
+        return Status::Ok();
+    }
+    const auto& graph_inputs = graph_.GetInputs();
+    const bool is_constant = !value->GetProducer() && value->GetTensor()->GetData() &&
+                             std::find(graph_inputs.begin(), graph_inputs.end(), value) == graph_inputs.end();
+    if (!is_constant) {
+        return Unsupported("value '" + value->GetName() + "' has no buffer in the memory plan");
+    }
+    const size_t offset = AlignUp(weights_.size(), kWeightAlignment);
+    const size_t bytes = value->GetTensor()->GetSizeInBytes();
+    const uint8_t* data = static_cast<const uint8_t*>(value->GetTensor()->GetData());
+    weights_.resize(offset);
+    weights_.insert(weights_.end(), data, data + bytes);
+    *expr = "Weight(" + std::to_string(offset) + ")";
+    refs_[value] = *expr;
+    return Status::Ok();
+}
+
+Status AotCodegen::Output(const Value* value, std::string* expr, Shape* shape) {
+    Status status = CheckTensor(value, shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (!writable_.count(value)) {
+        return Unsupported("output '" + value->GetName() + "' has no buffer in the memory plan");
+    }
+    *expr = refs_.at(value);
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitNode(const Node& node, const Operator& op) {
+    const std::string& type = node.GetOpType();
+    if (node.GetOutputs().empty()) {
+        return Unsupported("node without outputs");
+    }
+    // 除Dropout的mask与MaxPool的indices外只支持单输出
+    for (size_t i = 1; i < node.GetOutputs().size(); ++i) {
+        const bool fused_sum = (type == "AddLayerNorm" || type == "AddRMSNorm") && i == 1;
+        if (!fused_sum && IsUsed(graph_, node.GetOutputs()[i])) {
+            return Unsupported("output " + std::to_string(i) + " is used");
+        }
+    }
+    if (type == "MatMul" || type == "Gemm" || type == "FusedMatMulAdd") {
+        return EmitGemm(node, op);
+    }
+    if (type == "Add" || type == "Sub" || type == "Mul" || type == "Div" || type == "Max" || type == "Min") {
+        return EmitBinary(node);
+    }
+    if (type == "Relu" || type == "Sigmoid" || type == "Tanh" || type == "Gelu" || type == "Silu") {
+        return EmitUnary(node, op);
+    }
+    if (type == "Softmax" || type == "LogSoftmax") {
+        return EmitSoftmax(node, op);
+    }
+    if (type == "LayerNormalization" || type == "RMSNorm" || type == "AddLayerNorm" || type == "AddRMSNorm") {
+        return EmitNorm(node, op);
+    }
+    if (type == "Conv" || type == "FusedConvReLU") {
+        return EmitConv(node, op);
+    }
+    if (type == "MaxPool" || type == "AveragePool" || type == "AvgPool") {
+        return EmitPool(node, op);
+    }
+    if (type == "GlobalAveragePool" || type == "GlobalAvgPool") {
+        return EmitGlobalAveragePool(node);
+    }
+    if (type == "Concat") {
+        return EmitConcat(node, op);
+    }
+    if (type == "Reshape" || type == "Flatten" || type == "Dropout") {
+        return EmitCopy(node);
+    }
+    return Unsupported("operator not supported by the AOT compiler");
+}
+
+Status AotCodegen::EmitGemm(const Node& node, const Operator& op) {
+    const std::string& type = node.GetOpType();
+    const auto& inputs = node.GetInputs();
+    if (inputs.size() < 2 || (type == "FusedMatMulAdd" && inputs.size() < 3)) {
+        return Unsupported("missing inputs");
+    }
+    std::string a, b, c, bias = "nullptr";
+    Shape a_shape, b_shape, c_shape;
+    Status status = Input(inputs[0], &a, &a_shape);
+    if (status.IsOk()) status = Input(inputs[1], &b, &b_shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &c, &c_shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    operators::MatMulShape mm;
+    status = operators::ComputeMatMulShape(a_shape, b_shape, op.GetIntAttribute("transA", 0) != 0,
+                                           op.GetIntAttribute("transB", 0) != 0, &mm);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 批次：B共享时A不转置则并入M，否则逐批次；A、B批维度相同时各自按矩阵大小步进，其余广播不支持
+    aot::GemmShape g{1, mm.M, mm.N, mm.K, mm.trans_a, mm.trans_b, 0, 0, op.GetFloatAttribute("alpha", 1.0f),
+                     type == "Gemm" ? op.GetFloatAttribute("beta", 1.0f) : 1.0f, 0, aot::Activation::NONE};
+    const int64_t a_matrix = mm.M * mm.K;
+    const int64_t b_matrix = mm.K * mm.N;
+    if (mm.batch_count > 1) {
+        const std::vector<int64_t> a_batch(a_shape.dims.begin(), a_shape.dims.end() - std::min<size_t>(2, a_shape.dims.size()));
+        const std::vector<int64_t> b_batch(b_shape.dims.begin(), b_shape.dims.end() - std::min<size_t>(2, b_shape.dims.size()));
+        if (a_shape.GetElementCount() != mm.batch_count * a_matrix) {
+            return Unsupported("MatMul batch broadcast of A");
+        }
+        if (b_shape.GetElementCount() == b_matrix) {
+            if (mm.trans_a) {
+                g.batch = mm.batch_count;
+                g.a_stride = a_matrix;
+            } else {
+                g.M *= mm.batch_count;
+            }
+        } else if (a_batch == b_batch) {
+            g.batch = mm.batch_count;
+            g.a_stride = a_matrix;
+            g.b_stride = b_matrix;
+        } else {
+            return Unsupported("MatMul batch broadcast of B");
+        }
+    }
+    
+    const Value* bias_value = type == "MatMul" ? nullptr : (inputs.size() > 2 ? inputs[2] : nullptr);
+    if (bias_value) {
+        Shape bias_shape;
+        status = Input(bias_value, &bias, &bias_shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t count = bias_shape.GetElementCount();
+        const bool row_bias = count == mm.N && !bias_shape.dims.empty() && bias_shape.dims.back() == mm.N;
+        if (count != 1 && !row_bias && count != c_shape.GetElementCount()) {
+            return Unsupported("bias shape " + DimsToString(bias_shape) + " is not broadcast along rows");
+        }
+        g.bias_size = count;
+    }
+    const std::string activation = op.GetStringAttribute("activation", "");
+    if (activation == "relu") {
+        g.activation = aot::Activation::RELU;
+    } else if (activation == "gelu") {
+        g.activation = op.GetStringAttribute("approximate", "none") == "tanh" ? aot::Activation::GELU_TANH
+                                                                              : aot::Activation::GELU;
+    } else if (!activation.empty()) {
+        return Unsupported("activation '" + activation + "'");
+    }
+    static const char* const kActivations[] = {"NONE", "RELU", "GELU", "GELU_TANH"};
+    std::ostringstream call;
+    call << "aot::Gemm({" << g.batch << ", " << g.M << ", " << g.N << ", " << g.K << ", "
+         << BoolLiteral(g.trans_a) << ", " << BoolLiteral(g.trans_b) << ", " << g.a_stride << ", " << g.b_stride
+         << ", " << FloatLiteral(g.alpha) << ", " << FloatLiteral(g.beta) << ", " << g.bias_size
+         << ", aot::Activation::" << kActivations[static_cast<int>(g.activation)] << "}, "
+         << a << ", " << b << ", " << bias << ", " << c << ")";
+    Line(call.str());
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitBinary(const Node& node) {
+    static const std::unordered_map<std::string, std::string> kOps = {
+        {"Add", "ADD"}, {"Sub", "SUB"}, {"Mul", "MUL"}, {"Div", "DIV"}, {"Max", "MAX"}, {"Min", "MIN"}};
+    const auto& inputs = node.GetInputs();
+    if (inputs.size() != 2) {
+        return Unsupported("expects 2 inputs");
+    }
+    std::string a, b, c;
+    Shape a_shape, b_shape, c_shape;
+    Status status = Input(inputs[0], &a, &a_shape);
+    if (status.IsOk()) status = Input(inputs[1], &b, &b_shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &c, &c_shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const int64_t a_size = SuffixBroadcastSize(a_shape, c_shape);
+    const int64_t b_size = SuffixBroadcastSize(b_shape, c_shape);
+    const int64_t count = c_shape.GetElementCount();
+    if (a_size < 0 || b_size < 0 || std::max(a_size, b_size) != count ||
+        (a_size > 1 && b_size > 1 && count % std::min(a_size, b_size) != 0)) {
+        return Unsupported("broadcast of " + DimsToString(a_shape) + " and " + DimsToString(b_shape));
+    }
+    Line("aot::Binary(aot::BinaryOp::" + kOps.at(node.GetOpType()) + ", " + a + ", " + std::to_string(a_size) +
+         ", " + b + ", " + std::to_string(b_size) + ", " + c + ", " + std::to_string(count) + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitUnary(const Node& node, const Operator& op) {
+    std::string kind = node.GetOpType() == "Relu" ? "RELU" : node.GetOpType() == "Sigmoid" ? "SIGMOID"
+                     : node.GetOpType() == "Tanh" ? "TANH" : node.GetOpType() == "Silu" ? "SILU" : "GELU";
+    if (kind == "GELU" && op.GetStringAttribute("approximate", "none") == "tanh") {
+        kind = "GELU_TANH";
+    }
+    std::string x, y;
+    Shape shape;
+    Status status = Input(node.GetInputs().empty() ? nullptr : node.GetInputs()[0], &x);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y, &shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    Line("aot::Unary(aot::UnaryOp::" + kind + ", " + x + ", " + y + ", " +
+         std::to_string(shape.GetElementCount()) + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitSoftmax(const Node& node, const Operator& op) {
+    std::string x, y;
+    Shape shape;
+    Status status = Input(node.GetInputs().empty() ? nullptr : node.GetInputs()[0], &x, &shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const int64_t axis = NormalizeAxis(op.GetIntAttribute("axis", -1), shape.dims.size());
+    if (axis < 0 || axis >= static_cast<int64_t>(shape.dims.size())) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "axis out of range");
+    }
+    // 只支持沿最后一个非1维度：行是连续的
+    for (size_t i = static_cast<size_t>(axis) + 1; i < shape.dims.size(); ++i) {
+        if (shape.dims[i] != 1) {
+            return Unsupported("softmax over a non-trailing axis");
+        }
+    }
+    const int64_t cols = shape.dims[axis];
+    const int64_t rows = cols > 0 ? shape.GetElementCount() / cols : 0;
+    Line("aot::Softmax(" + x + ", " + y + ", " + std::to_string(rows) + ", " + std::to_string(cols) + ", " +
+         BoolLiteral(node.GetOpType() == "LogSoftmax") + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitNorm(const Node& node, const Operator& op) {
+    const std::string& type = node.GetOpType();
+    const bool rms = type == "RMSNorm" || type == "AddRMSNorm";
+    const bool fused_add = type == "AddLayerNorm" || type == "AddRMSNorm";
+    const auto& inputs = node.GetInputs();
+    const size_t param_index = fused_add ? 2 : 1;
+    if (inputs.size() <= param_index) {
+        return Unsupported("missing inputs");
+    }
+    std::string x, residual = "nullptr", gamma, beta = "nullptr", y, sum = "nullptr";
+    Shape shape, gamma_shape, beta_shape;
+    Status status = Input(inputs[0], &x, &shape);
+    if (status.IsOk() && fused_add) status = Input(inputs[1], &residual);
+    if (status.IsOk()) status = Input(inputs[param_index], &gamma, &gamma_shape);
+    if (status.IsOk() && !rms && inputs.size() > param_index + 1) {
+        status = Input(inputs[param_index + 1], &beta, &beta_shape);
+    }
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y);
+    if (status.IsOk() && fused_add && node.GetOutputs().size() > 1 && IsUsed(graph_, node.GetOutputs()[1])) {
+        status = Output(node.GetOutputs()[1], &sum);
+    }
+    if (!status.IsOk()) {
+        return status;
+    }
+    const int64_t axis = NormalizeAxis(op.GetIntAttribute("axis", -1), shape.dims.size());
+    if (axis < 0 || axis >= static_cast<int64_t>(shape.dims.size())) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "axis out of range");
+    }
+    int64_t cols = 1;
+    for (size_t i = static_cast<size_t>(axis); i < shape.dims.size(); ++i) {
+        cols *= shape.dims[i];
+    }
+    if (gamma_shape.GetElementCount() != cols || (beta != "nullptr" && beta_shape.GetElementCount() != cols)) {
+        return Unsupported("scale/bias broadcast along the normalized axes");
+    }
+    const float epsilon = op.GetFloatAttribute("epsilon", rms ? 1e-6f : 1e-5f);
+    const int64_t rows = cols > 0 ? shape.GetElementCount() / cols : 0;
+    Line("aot::LayerNorm(" + x + ", " + residual + ", " + gamma + ", " + beta + ", " + y + ", " + sum + ", " +
+         std::to_string(rows) + ", " + std::to_string(cols) + ", " + FloatLiteral(epsilon) + ", " +
+         BoolLiteral(rms) + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitConv(const Node& node, const Operator& op) {
+    const auto& inputs = node.GetInputs();
+    if (inputs.size() < 2) {
+        return Unsupported("missing inputs");
+    }
+    std::string x, w, bias = "nullptr", y;
+    Shape x_shape, w_shape, bias_shape;
+    Status status = Input(inputs[0], &x, &x_shape);
+    if (status.IsOk()) status = Input(inputs[1], &w, &w_shape);
+    if (status.IsOk() && inputs.size() > 2) status = Input(inputs[2], &bias, &bias_shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (x_shape.dims.size() != 4 || w_shape.dims.size() != 4) {
+        return Unsupported("only 2-D NCHW convolution");
+    }
+    operators::Conv2DParams p;
+    status = operators::ParseConv2DParams(op, x_shape, w_shape, &p);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (inputs.size() > 2 && bias_shape.GetElementCount() != p.out_c) {
+        return Unsupported("bias shape " + DimsToString(bias_shape));
+    }
+    const aot::Conv2DShape s{p.batch, p.in_c, p.in_h, p.in_w, p.out_c, p.out_h, p.out_w,
+                             p.kernel_h, p.kernel_w, p.stride_h, p.stride_w,
+                             p.pad_top, p.pad_left, p.pad_bottom, p.pad_right,
+                             p.dilation_h, p.dilation_w, p.group};
+    // 卷积工作区放在中间张量之后，各卷积依次使用、共用一块
+    const int64_t workspace = aot::Conv2DWorkspaceSize(s);
+    workspace_bytes_ = std::max(workspace_bytes_, static_cast<size_t>(workspace) * sizeof(float));
+    std::ostringstream call;
+    call << "aot::Conv2D({" << s.batch << ", " << s.in_c << ", " << s.in_h << ", " << s.in_w << ", "
+         << s.out_c << ", " << s.out_h << ", " << s.out_w << ", " << s.kernel_h << ", " << s.kernel_w << ", "
+         << s.stride_h << ", " << s.stride_w << ", " << s.pad_top << ", " << s.pad_left << ", "
+         << s.pad_bottom << ", " << s.pad_right << ", " << s.dilation_h << ", " << s.dilation_w << ", "
+         << s.group << "}, " << x << ", " << w << ", " << bias << ", "
+         << BoolLiteral(node.GetOpType() == "FusedConvReLU") << ", " << y << ", "
+         << (workspace > 0 ? ArenaExpr(AlignUp(plan_.arena_size, kWeightAlignment)) : "nullptr") << ")";
+    Line(call.str());
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitPool(const Node& node, const Operator& op) {
+    std::string x, y;
+    Shape shape;
+    Status status = Input(node.GetInputs().empty() ? nullptr : node.GetInputs()[0], &x, &shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const std::vector<int64_t> dilations = op.GetIntsAttribute("dilations", {});
+    if (shape.dims.size() != 4 ||
+        std::any_of(dilations.begin(), dilations.end(), [](int64_t d) { return d != 1; })) {
+        return Unsupported("only 2-D NCHW pooling without dilation");
+    }
+    operators::Pool2DParams p;
+    status = operators::ParsePool2DParams(op, shape, &p);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const bool max_pool = node.GetOpType() == "MaxPool";
+    std::ostringstream call;
+    call << (max_pool ? "aot::MaxPool2D({" : "aot::AveragePool2D({") << p.batch << ", " << p.channels << ", "
+         << p.in_h << ", " << p.in_w << ", " << p.out_h << ", " << p.out_w << ", " << p.kernel_h << ", "
+         << p.kernel_w << ", " << p.stride_h << ", " << p.stride_w << ", " << p.pad_top << ", " << p.pad_left
+         << ", " << BoolLiteral(p.count_include_pad) << "}, " << x << ", " << y << ")";
+    Line(call.str());
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitGlobalAveragePool(const Node& node) {
+    std::string x, y;
+    Shape shape;
+    Status status = Input(node.GetInputs().empty() ? nullptr : node.GetInputs()[0], &x, &shape);
+    if (status.IsOk()) status = Output(node.GetOutputs()[0], &y);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (shape.dims.size() < 3) {
+        return Unsupported("GlobalAveragePool input must be at least 3-D");
+    }
+    const int64_t planes = shape.dims[0] * shape.dims[1];
+    const int64_t size = planes > 0 ? shape.GetElementCount() / planes : 0;
+    Line("aot::GlobalAveragePool(" + x + ", " + y + ", " + std::to_string(planes) + ", " +
+         std::to_string(size) + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitConcat(const Node& node, const Operator& op) {
+    std::string y;
+    Shape shape;
+    Status status = Output(node.GetOutputs()[0], &y, &shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const int64_t axis = NormalizeAxis(op.GetIntAttribute("axis", 0), shape.dims.size());
+    if (axis < 0 || axis >= static_cast<int64_t>(shape.dims.size())) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "axis out of range");
+    }
+    int64_t outer = 1;
+    for (int64_t i = 0; i < axis; ++i) {
+        outer *= shape.dims[i];
+    }
+    std::string parts, sizes;
+    for (const Value* input : node.GetInputs()) {
+        std::string expr;
+        Shape input_shape;
+        status = Input(input, &expr, &input_shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        parts += (parts.empty() ? "" : ", ") + expr;
+        sizes += (sizes.empty() ? "" : ", ") + std::to_string(outer > 0 ? input_shape.GetElementCount() / outer : 0);
+    }
+    const std::string tag = std::to_string(num_calls_);
+    Line("const float* const concat" + tag + "[] = {" + parts + "}");
+    Line("const int64_t concat" + tag + "_sizes[] = {" + sizes + "}");
+    Line("aot::Concat(concat" + tag + ", concat" + tag + "_sizes, " + std::to_string(node.GetInputs().size()) +
+         ", " + std::to_string(outer) + ", " + y + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::EmitCopy(const Node& node) {
+    if (node.GetInputs().empty()) {
+        return Unsupported("missing inputs");
+    }
+    std::string x;
+    Status status = Input(node.GetInputs()[0], &x);
+    if (!status.IsOk()) {
+        return status;
+    }
+    // 内存规划把视图的输出留作输入的别名；输出另有缓冲（图输出）时才拷贝
+    const Value* output = node.GetOutputs()[0];
+    if (!writable_.count(output)) {
+        refs_[output] = x;
+        return Status::Ok();
+    }
+    std::string y;
+    Shape shape;
+    status = Output(output, &y, &shape);
+    if (!status.IsOk()) {
+        return status;
+    }
+    Line("aot::Copy(" + x + ", " + y + ", " + std::to_string(shape.GetElementCount()) + ")");
+    return Status::Ok();
+}
+
+Status AotCodegen::Run(AotCompileResult* result) {
+    const auto& graph_inputs = graph_.GetInputs();
+    const auto& graph_outputs = graph_.GetOutputs();
+    for (size_t i = 0; i < graph_inputs.size(); ++i) {
+        refs_[graph_inputs[i]] = "inputs[" + std::to_string(i) + "]";
+    }
+    for (size_t j = 0; j < graph_outputs.size(); ++j) {
+        if (refs_.count(graph_outputs[j]) || !graph_outputs[j]->GetProducer()) {
+            return Unsupported("graph output '" + graph_outputs[j]->GetName() + "' is not computed by a node");
+        }
+        refs_[graph_outputs[j]] = "outputs[" + std::to_string(j) + "]";
+        writable_.insert(graph_outputs[j]);
+    }
+    for (const MemoryPlanEntry& entry : plan_.entries) {
+        if (entry.offset % sizeof(float) != 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Memory plan offset is not float aligned");
+        }
+        refs_[entry.value] = ArenaExpr(entry.offset);
+        writable_.insert(entry.value);
+    }
+    
+    std::vector<std::string> unsupported;
+    for (Node* node : graph_.TopologicalSort()) {
+        pending_.clear();
+        std::unique_ptr<Operator> op = OperatorRegistry::Instance().Create(node->GetOpType());
+        Status status = op ? Status::Ok() : Unsupported("operator not registered");
+        if (status.IsOk()) {
+            ApplyNodeAttributes(*node, op.get());
+            status = EmitNode(*node, *op);
+        }
+        if (!status.IsOk()) {
+            if (status.Code() != StatusCode::ERROR_NOT_IMPLEMENTED) {
+                return Status::Error(status.Code(), node->GetName() + " (" + node->GetOpType() + "): " +
+                                                    status.Message());
+            }
+            unsupported.push_back(node->GetName() + " (" + node->GetOpType() + "): " + status.Message());
+            // 之后的节点照常检查，不因缺少这个节点的输出再报错
+            for (const Value* output : node->GetOutputs()) {
+                if (!refs_.count(output)) {
+                    refs_[output] = "nullptr";
+                }
+            }
+            continue;
+        }
+        if (pending_.empty()) {
+            continue;
+        }
+        body_.push_back("// " + node->GetName() + " (" + node->GetOpType() + ")");
+        body_.insert(body_.end(), pending_.begin(), pending_.end());
+        ++num_calls_;
+    }
+    if (!unsupported.empty()) {
+        std::string message = "AOT compilation does not support:";
+        for (const std::string& item : unsupported) {
+            message += "\n  " + item;
+        }
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, message);
+    }
+    
+    const size_t arena_size = workspace_bytes_ > 0
+        ? AlignUp(plan_.arena_size, kWeightAlignment) + workspace_bytes_
+        : plan_.arena_size;
+    result->source = GenerateSource(arena_size);
+    result->header = GenerateHeader();
+    result->weights_source = GenerateWeightsSource();
+    result->weights = weights_;
+    result->arena_size = arena_size;
+    result->num_kernel_calls = num_calls_;
+    return Status::Ok();
+}
+
+std::string AotCodegen::GenerateSource(size_t arena_size) const {
+    const std::string& name = options_.function_name;
+    std::ostringstream out;
+    out << "// Generated by the inferunity AOT compiler; do not edit.\n"
+        << "// " << num_calls_ << " kernel calls, arena " << arena_size << " bytes, weights " << weights_.size()
+        << " bytes\n\n"
+        << "#include \"" << options_.header_name << "\"\n"
+        << "#include \"inferunity/aot_kernels.h\"\n"
+        << "#include <cstdint>\n\n"
+        << "namespace aot = inferunity::aot;\n\n"
+        << "extern \"C\" const unsigned char " << name << "_weights[];\n\n"
+        << "namespace {\n\n"
+        << "constexpr size_t kArenaSize = " << arena_size << ";\n\n"
+        << "inline const float* Weight(size_t offset) {\n"
+        << "    return reinterpret_cast<const float*>(" << name << "_weights + offset);\n"
+        << "}\n\n"
+        << "} // namespace\n\n"
+        << "extern \"C\" size_t " << name << "_arena_size(void) {\n"
+        << "    return kArenaSize;\n"
+        << "}\n\n"
+        << "extern \"C\" void " << name << "(const float* const* inputs, float* const* outputs, void* arena) {\n"
+        << "    float* const buffer = static_cast<float*>(arena);\n"
+        << "    (void)inputs;\n"
+        << "    (void)outputs;\n"
+        << "    (void)buffer;\n";
+    for (const std::string& line : body_) {
+        out << "    " << line << (line.compare(0, 2, "//") == 0 ? "\n" : ";\n");
+    }
+    out << "}\n";
+    return out.str();
+}
+
+std::string AotCodegen::GenerateHeader() const {
+    const std::string& name = options_.function_name;
+    std::ostringstream out;
+    out << "// Generated by the inferunity AOT compiler; do not edit.\n";
+    out << "// Inputs:\n";
+    for (size_t i = 0; i < graph_.GetInputs().size(); ++i) {
+        const Value* value = graph_.GetInputs()[i];
+        out << "//   [" << i << "] " << value->GetName() << ": float32"
+            << (value->GetTensor() ? DimsToString(value->GetTensor()->GetShape()) : "[]") << "\n";
+    }
+    out << "// Outputs:\n";
+    for (size_t j = 0; j < graph_.GetOutputs().size(); ++j) {
+        const Value* value = graph_.GetOutputs()[j];
+        out << "//   [" << j << "] " << value->GetName() << ": float32"
+            << (value->GetTensor() ? DimsToString(value->GetTensor()->GetShape()) : "[]") << "\n";
+    }
+    out << "\n#pragma once\n\n"
+        << "#include <stddef.h>\n\n"
+        << "#ifdef __cplusplus\n"
+        << "extern \"C\" {\n"
+        << "#endif\n\n"
+        << "// Bytes of scratch memory (64-byte aligned) to pass as arena\n"
+        << "size_t " << name << "_arena_size(void);\n\n"
+        << "void " << name << "(const float* const* inputs, float* const* outputs, void* arena);\n\n"
+        << "#ifdef __cplusplus\n"
+        << "}\n"
+        << "#endif\n";
+    return out.str();
+}
+
+std::string AotCodegen::GenerateWeightsSource() const {
+    const std::string& name = options_.function_name;
+    std::ostringstream out;
+    out << "// Generated by the inferunity AOT compiler; do not edit.\n"
+        << "// " << weights_.size() << " bytes of constant weights\n\n"
+        << "extern \"C\" {\n\n"
+        << "extern const unsigned char " << name << "_weights[];\n"
+        << "alignas(64) const unsigned char " << name << "_weights[" << std::max<size_t>(weights_.size(), 1)
+        << "] = {";
+    char byte[8];
+    for (size_t i = 0; i < weights_.size(); ++i) {
+        std::snprintf(byte, sizeof(byte), "0x%02x,", weights_[i]);
+        out << (i % 16 == 0 ? "\n    " : " ") << byte;
+    }
+    if (weights_.empty()) {
+        out << "0";
+    }
+    out << "\n};\n\n"
+        << "} // extern \"C\"\n";
+    return out.str();
+}
+
+} // anonymous namespace
+
+Status CompileGraphToSource(const Graph& graph, const MemoryPlan& plan, const AotCompileOptions& options,
+                            AotCompileResult* result) {
+    if (!result) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "result is null");
+    }
+    const std::string& name = options.function_name;
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])) ||
+        !std::all_of(name.begin(), name.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        })) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "AOT function name must be a C identifier: " + name);
+    }
+    AotCodegen codegen(graph, plan, options);
+    return codegen.Run(result);
+}
+
+} // namespace inferunity
@@ -0,0 +1,311 @@
+// AOT生成代码调用的内核实现
+// 与对应算子的Execute走同一批GEMM/SIMD内核，只是去掉了张量、属性与上下文：
+// 调用在生成函数的线程上顺序执行，GEMM内部的并行与算子中一致
+
+#include "inferunity/aot_kernels.h"
+#include "conv_kernels.h"
+#include "gemm.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace inferunity {
+namespace aot {
+
+namespace {
+
+simd::BinaryOp ToSimdOp(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::ADD: return simd::BinaryOp::ADD;
+        case BinaryOp::SUB: return simd::BinaryOp::SUB;
+        case BinaryOp::MUL: return simd::BinaryOp::MUL;
+        case BinaryOp::DIV: return simd::BinaryOp::DIV;
+        case BinaryOp::MAX: return simd::BinaryOp::MAX;
+        case BinaryOp::MIN: return simd::BinaryOp::MIN;
+    }
+    return simd::BinaryOp::ADD;
+}
+
+operators::Conv2DParams ToConvParams(const Conv2DShape& s) {
+    operators::Conv2DParams p;
+    p.batch = s.batch;
+    p.in_c = s.in_c;
+    p.in_h = s.in_h;
+    p.in_w = s.in_w;
+    p.out_c = s.out_c;
+    p.out_h = s.out_h;
+    p.out_w = s.out_w;
+    p.kernel_h = s.kernel_h;
+    p.kernel_w = s.kernel_w;
+    p.stride_h = s.stride_h;
+    p.stride_w = s.stride_w;
+    p.pad_top = s.pad_top;
+    p.pad_left = s.pad_left;
+    p.pad_bottom = s.pad_bottom;
+    p.pad_right = s.pad_right;
+    p.dilation_h = s.dilation_h;
+    p.dilation_w = s.dilation_w;
+    p.group = s.group;
+    return p;
+}
+
+bool IsPointwise(const Conv2DShape& s) {
+    return s.kernel_h == 1 && s.kernel_w == 1 && s.stride_h == 1 && s.stride_w == 1 &&
+           s.pad_top == 0 && s.pad_left == 0 && s.pad_bottom == 0 && s.pad_right == 0;
+}
+
+bool IsDepthwise(const Conv2DShape& s) {
+    return s.group > 1 && s.group == s.in_c && s.out_c % s.in_c == 0;
+}
+
+// 一组输入通道展开为col[channels * kernel_h * kernel_w, out_h * out_w]，越界位置补0
+void Im2Col(const Conv2DShape& s, const float* x, int64_t channels, float* col) {
+    const int64_t out_hw = s.out_h * s.out_w;
+    for (int64_t c = 0; c < channels; ++c) {
+        const float* plane = x + c * s.in_h * s.in_w;
+        for (int64_t kh = 0; kh < s.kernel_h; ++kh) {
+            for (int64_t kw = 0; kw < s.kernel_w; ++kw) {
+                float* row = col + ((c * s.kernel_h + kh) * s.kernel_w + kw) * out_hw;
+                for (int64_t oh = 0; oh < s.out_h; ++oh) {
+                    const int64_t ih = oh * s.stride_h - s.pad_top + kh * s.dilation_h;
+                    float* out = row + oh * s.out_w;
+                    if (ih < 0 || ih >= s.in_h) {
+                        std::fill(out, out + s.out_w, 0.0f);
+                        continue;
+                    }
+                    for (int64_t ow = 0; ow < s.out_w; ++ow) {
+                        const int64_t iw = ow * s.stride_w - s.pad_left + kw * s.dilation_w;
+                        out[ow] = iw >= 0 && iw < s.in_w ? plane[ih * s.in_w + iw] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Pool2D(const Pool2DShape& s, const float* x, float* y, bool max_pool) {
+    for (int64_t plane = 0; plane < s.batch * s.channels; ++plane) {
+        const float* in = x + plane * s.in_h * s.in_w;
+        float* out = y + plane * s.out_h * s.out_w;
+        for (int64_t oh = 0; oh < s.out_h; ++oh) {
+            const int64_t h0 = oh * s.stride_h - s.pad_top;
+            const int64_t h_begin = std::max<int64_t>(h0, 0);
+            const int64_t h_end = std::min(h0 + s.kernel_h, s.in_h);
+            for (int64_t ow = 0; ow < s.out_w; ++ow) {
+                const int64_t w0 = ow * s.stride_w - s.pad_left;
+                const int64_t w_begin = std::max<int64_t>(w0, 0);
+                const int64_t w_end = std::min(w0 + s.kernel_w, s.in_w);
+                float acc = max_pool ? std::numeric_limits<float>::lowest() : 0.0f;
+                for (int64_t ih = h_begin; ih < h_end; ++ih) {
+                    for (int64_t iw = w_begin; iw < w_end; ++iw) {
+                        const float v = in[ih * s.in_w + iw];
+                        acc = max_pool ? std::max(acc, v) : acc + v;
+                    }
+                }
+                if (!max_pool) {
+                    const int64_t count = s.count_include_pad ? s.kernel_h * s.kernel_w
+                                                              : (h_end - h_begin) * (w_end - w_begin);
+                    acc = count > 0 ? acc / static_cast<float>(count) : 0.0f;
+                }
+                out[oh * s.out_w + ow] = acc;
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+void Gemm(const GemmShape& shape, const float* a, const float* b, const float* bias, float* c) {
+    const int64_t lda = shape.trans_a ? shape.M : shape.K;
+    const int64_t ldb = shape.trans_b ? shape.K : shape.N;
+    const int64_t mn = shape.M * shape.N;
+    // [N]的bias在beta为1时作为GEMM的列bias在写回时加上，其余情况先把beta * bias广播到C再累加
+    const bool col_bias = bias && shape.bias_size == shape.N && shape.bias_size > 1 && shape.beta == 1.0f;
+    gemm::GemmEpilogue epilogue;
+    epilogue.col_bias = col_bias ? bias : nullptr;
+    epilogue.relu = shape.activation == Activation::RELU;
+    for (int64_t i = 0; i < shape.batch; ++i) {
+        float* ci = c + i * mn;
+        float beta = 0.0f;
+        if (bias && shape.bias_size > 0 && !col_bias) {
+            if (shape.bias_size == 1) {
+                std::fill(ci, ci + mn, shape.beta * bias[0]);
+            } else if (shape.bias_size == shape.N) {
+                for (int64_t m = 0; m < shape.M; ++m) {
+                    simd::ScaleSIMD(bias, ci + m * shape.N, static_cast<size_t>(shape.N), shape.beta);
+                }
+            } else {
+                simd::ScaleSIMD(bias + i * mn, ci, static_cast<size_t>(mn), shape.beta);
+            }
+            beta = 1.0f;
+        }
+        gemm::Sgemm(shape.trans_a, shape.trans_b, shape.M, shape.N, shape.K, shape.alpha,
+                    a + i * shape.a_stride, lda, b + i * shape.b_stride, ldb, beta, ci, shape.N, &epilogue);
+    }
+    if (shape.activation == Activation::GELU || shape.activation == Activation::GELU_TANH) {
+        simd::GeluSIMD(c, c, static_cast<size_t>(shape.batch * mn), shape.activation == Activation::GELU_TANH);
+    }
+}
+
+void Unary(UnaryOp op, const float* x, float* y, int64_t count) {
+    const size_t n = static_cast<size_t>(count);
+    switch (op) {
+        case UnaryOp::RELU: simd::ReluSIMD(x, y, n); break;
+        case UnaryOp::SIGMOID: simd::SigmoidSIMD(x, y, n); break;
+        case UnaryOp::TANH: simd::TanhSIMD(x, y, n); break;
+        case UnaryOp::GELU: simd::GeluSIMD(x, y, n, false); break;
+        case UnaryOp::GELU_TANH: simd::GeluSIMD(x, y, n, true); break;
+        case UnaryOp::SILU: simd::SiluSIMD(x, y, n); break;
+    }
+}
+
+void Binary(BinaryOp op, const float* a, int64_t a_size, const float* b, int64_t b_size, float* c,
+            int64_t count) {
+    const simd::BinaryOp simd_op = ToSimdOp(op);
+    const bool a_scalar = a_size == 1 && count > 1;
+    const bool b_scalar = b_size == 1 && count > 1;
+    if ((a_size == count || a_scalar) && (b_size == count || b_scalar)) {
+        simd::BinarySIMD(simd_op, a, a_scalar, b, b_scalar, c, static_cast<size_t>(count));
+        return;
+    }
+    // 较小的操作数按行循环使用
+    const int64_t row = std::min(a_size, b_size);
+    for (int64_t offset = 0; offset < count; offset += row) {
+        simd::BinarySIMD(simd_op, a_size == row ? a : a + offset, false, b_size == row ? b : b + offset, false,
+                         c + offset, static_cast<size_t>(row));
+    }
+}
+
+void Softmax(const float* x, float* y, int64_t rows, int64_t cols, bool log_softmax) {
+    const size_t n = static_cast<size_t>(cols);
+    const int slot = simd::FindSpecializedRowSlot(cols);
+    for (int64_t r = 0; r < rows; ++r) {
+        const float* in = x + r * cols;
+        float* out = y + r * cols;
+        if (slot >= 0) {
+            simd::SoftmaxRowFixedSIMD(slot, in, out, log_softmax);
+            continue;
+        }
+        float max_value = 0.0f, sum = 0.0f;
+        simd::OnlineMaxExpSumSIMD(in, n, &max_value, &sum);
+        if (log_softmax) {
+            simd::AddScalarSIMD(in, out, n, -max_value - std::log(sum));
+        } else {
+            simd::ExpShiftScaleSIMD(in, out, n, max_value, 1.0f / sum);
+        }
+    }
+}
+
+void LayerNorm(const float* x, const float* residual, const float* gamma, const float* beta, float* y,
+               float* sum, int64_t rows, int64_t cols, float epsilon, bool rms) {
+    const size_t n = static_cast<size_t>(cols);
+    const int slot = simd::FindSpecializedRowSlot(cols);
+    for (int64_t r = 0; r < rows; ++r) {
+        const float* a = x + r * cols;
+        const float* b = residual ? residual + r * cols : nullptr;
+        float* out = y + r * cols;
+        float* row_sum = sum ? sum + r * cols : nullptr;
+        if (slot >= 0) {
+            simd::NormRowFixedSIMD(slot, a, b, row_sum, out, epsilon, gamma, beta, rms);
+            continue;
+        }
+        // 与LayerNormalization算子相同：融合相加时x先写到sum（或暂存到y）
+        float* x_sum = b ? (row_sum ? row_sum : out) : nullptr;
+        const float* in = b ? x_sum : a;
+        if (rms) {
+            const float mean_sq = simd::AddSumSquaresSIMD(a, b, x_sum, n) / static_cast<float>(n);
+            simd::NormalizeScaleSIMD(in, out, n, 0.0f, 1.0f / std::sqrt(mean_sq + epsilon), gamma, nullptr);
+        } else {
+            float mean = 0.0f, m2 = 0.0f;
+            simd::AddWelfordSIMD(a, b, x_sum, n, &mean, &m2);
+            const float var = std::max(m2 / static_cast<float>(n), 0.0f);
+            simd::NormalizeScaleSIMD(in, out, n, mean, 1.0f / std::sqrt(var + epsilon), gamma, beta);
+        }
+    }
+}
+
+int64_t Conv2DWorkspaceSize(const Conv2DShape& shape) {
+    if (IsDepthwise(shape) || IsPointwise(shape)) {
+        return 0;
+    }
+    return shape.in_c / shape.group * shape.kernel_h * shape.kernel_w * shape.out_h * shape.out_w;
+}
+
+void Conv2D(const Conv2DShape& shape, const float* x, const float* w, const float* bias, bool relu,
+            float* y, float* workspace) {
+    const int64_t in_plane = shape.in_h * shape.in_w;
+    const int64_t out_hw = shape.out_h * shape.out_w;
+    if (IsDepthwise(shape)) {
+        const operators::Conv2DParams params = ToConvParams(shape);
+        const int64_t multiplier = shape.out_c / shape.in_c;
+        const int64_t taps = shape.kernel_h * shape.kernel_w;
+        for (int64_t n = 0; n < shape.batch; ++n) {
+            for (int64_t oc = 0; oc < shape.out_c; ++oc) {
+                operators::DepthwiseConvRows(params, x + (n * shape.in_c + oc / multiplier) * in_plane,
+                                             w + oc * taps, 1.0f, bias ? bias[oc] : 0.0f, relu, 0, shape.out_h,
+                                             y + (n * shape.out_c + oc) * out_hw);
+            }
+        }
+        return;
+    }
+    // 每组一次GEMM：W_g[oc_g, ic_g * kh * kw] x col[ic_g * kh * kw, out_h * out_w]，bias与ReLU在写回时完成
+    const int64_t ic_g = shape.in_c / shape.group;
+    const int64_t oc_g = shape.out_c / shape.group;
+    const int64_t k = ic_g * shape.kernel_h * shape.kernel_w;
+    const bool pointwise = IsPointwise(shape);
+    for (int64_t n = 0; n < shape.batch; ++n) {
+        for (int64_t g = 0; g < shape.group; ++g) {
+            const float* x_g = x + (n * shape.in_c + g * ic_g) * in_plane;
+            const float* col = x_g;
+            if (!pointwise) {
+                Im2Col(shape, x_g, ic_g, workspace);
+                col = workspace;
+            }
+            gemm::GemmEpilogue epilogue;
+            epilogue.row_bias = bias ? bias + g * oc_g : nullptr;
+            epilogue.relu = relu;
+            gemm::Sgemm(false, false, oc_g, out_hw, k, 1.0f, w + g * oc_g * k, k, col, out_hw, 0.0f,
+                        y + (n * shape.out_c + g * oc_g) * out_hw, out_hw, &epilogue);
+        }
+    }
+}
+
+void MaxPool2D(const Pool2DShape& shape, const float* x, float* y) {
+    Pool2D(shape, x, y, true);
+}
+
+void AveragePool2D(const Pool2DShape& shape, const float* x, float* y) {
+    Pool2D(shape, x, y, false);
+}
+
+void GlobalAveragePool(const float* x, float* y, int64_t planes, int64_t size) {
+    const float scale = size > 0 ? 1.0f / static_cast<float>(size) : 0.0f;
+    for (int64_t p = 0; p < planes; ++p) {
+        y[p] = simd::ReduceSumSIMD(x + p * size, static_cast<size_t>(size)) * scale;
+    }
+}
+
+void Concat(const float* const* inputs, const int64_t* sizes, int64_t num_inputs, int64_t outer, float* y) {
+    int64_t row = 0;
+    for (int64_t i = 0; i < num_inputs; ++i) {
+        row += sizes[i];
+    }
+    for (int64_t o = 0; o < outer; ++o) {
+        float* dst = y + o * row;
+        for (int64_t i = 0; i < num_inputs; ++i) {
+            Copy(inputs[i] + o * sizes[i], dst, sizes[i]);
+            dst += sizes[i];
+        }
+    }
+}
+
+void Copy(const float* x, float* y, int64_t count) {
+    if (x != y && count > 0) {
+        std::memcpy(y, x, static_cast<size_t>(count) * sizeof(float));
+    }
+}
+
+} // namespace aot
+} // namespace inferunity
@@ -0,0 +1,918 @@
+// 融合多头注意力算子实现
+// 参考FlashAttention（Dao et al.）与ONNX Runtime的MultiHeadAttention/GroupQueryAttention：
+// 按[Br, Bc]分块计算Q*K^T，每行维护在线softmax的max/sum，P*V直接累加到输出块，
+// 不物化[B, H, S, T]的注意力分数
+
+#include "attention.h"
+#include "gemm.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+constexpr int64_t kQueryBlock = 32;  // Br：每个任务处理的查询行数
+constexpr int64_t kKeyBlock = 64;    // Bc：每次与查询块相乘的键数
+// 解码阶段：每段至少的键数（段太短时合并的开销超过并行收益）与每次计算分数的键数
+constexpr int64_t kDecodeMinSplitKeys = 256;
+constexpr int64_t kDecodeKeyBlock = 128;
+
+// [B, H, L, D]（秩4）或[B*H, L, D]（秩3，H视为1）
+struct HeadLayout {
+    int64_t batch = 0;
+    int64_t heads = 0;
+    int64_t length = 0;
+    int64_t dim = 0;
+};
+
+bool ParseLayout(const Shape& shape, HeadLayout* layout) {
+    const auto& d = shape.dims;
+    if (d.size() == 4) {
+        *layout = {d[0], d[1], d[2], d[3]};
+    } else if (d.size() == 3) {
+        *layout = {d[0], 1, d[1], d[2]};
+    } else {
+        return false;
+    }
+    return layout->batch > 0 && layout->heads > 0 && layout->length > 0 && layout->dim > 0;
+}
+
+// 加性mask按右对齐广播到[B, H, S, T]，长度为1的维度跨度为0
+struct MaskStrides {
+    int64_t b = 0, h = 0, s = 0, t = 0;
+};
+
+bool ComputeMaskStrides(const Shape& mask_shape, const HeadLayout& q, int64_t kv_len,
+                        MaskStrides* strides) {
+    const auto& d = mask_shape.dims;
+    if (d.empty() || d.size() > 4) {
+        return false;
+    }
+    const int64_t full[4] = {q.batch, q.heads, q.length, kv_len};
+    int64_t* out[4] = {&strides->b, &strides->h, &strides->s, &strides->t};
+    int64_t stride = 1;
+    for (int i = 3, j = static_cast<int>(d.size()) - 1; i >= 0; --i, --j) {
+        const int64_t dim = j >= 0 ? d[j] : 1;
+        if (dim != 1 && dim != full[i]) {
+            return false;
+        }
+        *out[i] = dim == 1 ? 0 : stride;
+        stride *= dim;
+    }
+    return true;
+}
+
+// 旋转位置编码（RoPE）：cos/sin表为[P, D/2]或[P, D]（两半重复，HuggingFace格式）
+// interleaved=false时旋转(x[i], x[i + D/2])（GPT-NeoX/LLaMA/Qwen），true时旋转(x[2i], x[2i + 1])（GPT-J）
+struct RotaryTable {
+    const float* cos = nullptr;
+    const float* sin = nullptr;
+    int64_t positions = 0;
+    int64_t row_stride = 0;
+    bool interleaved = false;
+};
+
+void ApplyRotary(const RotaryTable& rope, const float* x, float* y, int64_t dim, int64_t position) {
+    const int64_t half = dim / 2;
+    const float* c = rope.cos + position * rope.row_stride;
+    const float* s = rope.sin + position * rope.row_stride;
+    for (int64_t i = 0; i < half; ++i) {
+        const int64_t a = rope.interleaved ? 2 * i : i;
+        const int64_t b = rope.interleaved ? 2 * i + 1 : i + half;
+        const float x0 = x[a];
+        const float x1 = x[b];
+        y[a] = x0 * c[i] - x1 * s[i];
+        y[b] = x1 * c[i] + x0 * s[i];
+    }
+}
+
+// 校验cos/sin表覆盖[0, max_positions)并填写rope；表的前导维度按位置展开
+Status PrepareRotary(const Tensor* cos, const Tensor* sin, int64_t dim, int64_t max_positions,
+                     bool interleaved, const std::string& op_name, RotaryTable* rope) {
+    const auto& dims = cos->GetShape().dims;
+    if (dim % 2 != 0 || dims.size() < 2 || sin->GetShape().dims != dims ||
+        cos->GetDataType() != DataType::FLOAT32 || sin->GetDataType() != DataType::FLOAT32) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           op_name + " rotary tables must be FLOAT32 [P, D/2] or [P, D] with even D");
+    }
+    const int64_t width = dims.back();
+    const int64_t positions = static_cast<int64_t>(cos->GetElementCount()) / width;
+    if ((width != dim / 2 && width != dim) || positions < max_positions) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           op_name + " rotary tables do not cover all positions");
+    }
+    rope->cos = static_cast<const float*>(cos->GetData());
+    rope->sin = static_cast<const float*>(sin->GetData());
+    rope->positions = positions;
+    rope->row_stride = width;  // [P, D]格式的前D/2列即为cos(θ_i)
+    rope->interleaved = interleaved;
+    return Status::Ok();
+}
+
+// 从位置position开始连续存放的一段键值：每个位置key_dim/value_dim个float，count为连续的位置数。
+// 量化存储时key/value为空，改由key_data/value_data（每个元素1字节）与每个位置的缩放给出
+struct KVRun {
+    const float* key = nullptr;
+    const float* value = nullptr;
+    int64_t count = 0;
+    const uint8_t* key_data = nullptr;
+    const uint8_t* value_data = nullptr;
+    const float* key_scale = nullptr;
+    const float* value_scale = nullptr;
+};
+using KVLocator = std::function<KVRun(int64_t batch, int64_t kv_head, int64_t position)>;
+
+// 一次注意力计算：K/V按(batch, kv_head)分行，每行容量capacity个位置，
+// 第b个样本的有效键数为past[b] + S（无KV cache时past[b] = T - S、capacity = T）
+struct AttentionProblem {
+    HeadLayout q;
+    int64_t kv_heads = 0;
+    int64_t dv = 0;
+    int64_t capacity = 0;
+    std::vector<int64_t> past;
+    const float* Q = nullptr;
+    const float* K = nullptr;
+    const float* V = nullptr;
+    KVLocator locate;  // 非空时代替K/V/capacity定位键值（分页KV cache）
+    KVCacheStorage storage = KVCacheStorage::FLOAT32;  // locate给出的键值的存储格式
+    const float* mask = nullptr;
+    MaskStrides mask_strides;
+    const RotaryTable* rope = nullptr;  // 非空时对Q应用RoPE（K已在写入前旋转）
+    float scale = 1.0f;
+    bool causal = false;
+    float* O = nullptr;
+    // 打包布局（非空时）：Q/O为[1, Hq, S, D]，第b个序列的查询是[query_offsets[b], query_offsets[b + 1])，
+    // K/V只经locate定位；past与locate的第一个参数是序列下标
+    std::vector<int64_t> query_offsets;
+};
+
+// 连续布局[B, Hkv, capacity, D]的定位
+KVLocator ContiguousLocator(const AttentionProblem& p) {
+    const int64_t D = p.q.dim;
+    return [&p, D](int64_t b, int64_t kv_head, int64_t position) {
+        const int64_t row = (b * p.kv_heads + kv_head) * p.capacity + position;
+        return KVRun{p.K + row * D, p.V + row * p.dv, p.capacity - position};
+    };
+}
+
+// 取cols个位置的键值：FP32存储直接返回原指针，量化存储时反量化到key_tile/value_tile（各至少cols行）。
+// 反量化在分块内完成，键值从KV cache只按1字节每元素读一遍
+KVRun LoadKVTile(const AttentionProblem& p, const KVRun& run, int64_t cols, std::vector<float>* key_tile,
+                 std::vector<float>* value_tile) {
+    if (p.storage == KVCacheStorage::FLOAT32) {
+        return run;
+    }
+    key_tile->resize(static_cast<size_t>(cols * p.q.dim));
+    value_tile->resize(static_cast<size_t>(cols * p.dv));
+    DequantizeKVRows(p.storage, run.key_data, run.key_scale, cols, p.q.dim, key_tile->data());
+    DequantizeKVRows(p.storage, run.value_data, run.value_scale, cols, p.dv, value_tile->data());
+    KVRun tile = run;
+    tile.key = key_tile->data();
+    tile.value = value_tile->data();
+    return tile;
+}
+
+// 解码阶段的注意力（参考Flash-Decoding）：每个(序列, 头)只有一行查询，小批量时按头并行喂不满线程。
+// 行数不足线程数时把键值序列切成几段，各段独立算出局部的max m_s、sum l_s与未归一化的o_s = P_s * V_s，
+// 再按log-sum-exp合并：m = max(m_s)，l = sum(l_s * exp(m_s - m))，o = sum(o_s * exp(m_s - m)) / l。
+// 键值经locate读取，连续与分页KV cache相同；分数与P*V用瘦矩阵内核，K、V各流式读一遍
+void RunDecodeAttention(const AttentionProblem& p, ExecutionContext* ctx) {
+    const int64_t S = p.q.length;
+    const int64_t D = p.q.dim;
+    const int64_t Dv = p.dv;
+    const int64_t group = p.q.heads / p.kv_heads;
+    const bool packed = !p.query_offsets.empty();
+    const int64_t num_seqs = packed ? static_cast<int64_t>(p.query_offsets.size()) - 1 : p.q.batch;
+    const int64_t rows = num_seqs * p.q.heads;
+    const int64_t max_total = *std::max_element(p.past.begin(), p.past.begin() + num_seqs) + 1;
+    const int64_t threads = ctx ? std::max(ctx->GetIntraOpParallelism().num_threads, 1) : 1;
+    int64_t splits = 1;
+    if (rows < threads) {
+        splits = std::min((threads + rows - 1) / rows, (max_total + kDecodeMinSplitKeys - 1) / kDecodeMinSplitKeys);
+        splits = std::max<int64_t>(splits, 1);
+    }
+    const int64_t chunk = (max_total + splits - 1) / splits;
+    // 第row行查询的(序列, 头)与其在Q/O中的行
+    auto query_row = [&](int64_t row) {
+        const int64_t b = row / p.q.heads;
+        const int64_t h = row % p.q.heads;
+        return packed ? h * S + p.query_offsets[b] : (b * p.q.heads + h) * S;
+    };
+    
+    // 每段的结果：[o_s(Dv), m_s, l_s]
+    const int64_t stride = Dv + 2;
+    std::vector<float> partial(static_cast<size_t>(rows * splits * stride));
+    ParallelForOuter(ctx, rows * splits, chunk * (D + Dv), [&](int64_t begin, int64_t end) {
+        std::vector<float> scores(kDecodeKeyBlock);
+        std::vector<float> q_scaled(D);
+        std::vector<float> key_tile, value_tile;
+        for (int64_t task = begin; task < end; ++task) {
+            const int64_t row = task / splits;
+            const int64_t b = row / p.q.heads;
+            const int64_t h = row % p.q.heads;
+            const int64_t past = p.past[b];
+            float* acc = partial.data() + task * stride;
+            float& row_max = acc[Dv];
+            float& row_sum = acc[Dv + 1];
+            std::fill(acc, acc + Dv, 0.0f);
+            row_max = -std::numeric_limits<float>::infinity();
+            row_sum = 0.0f;
+            // 唯一的查询位于绝对位置past，causal时也看到全部past + 1个键
+            const int64_t key_end = std::min(past + 1, (task % splits + 1) * chunk);
+            int64_t k_begin = (task % splits) * chunk;
+            if (k_begin >= key_end) {
+                continue;
+            }
+    
+            // 缩放提前乘进查询，分数的GEMV直接写出
+            const float* q = p.Q + query_row(row) * D;
+            if (p.rope) {
+                ApplyRotary(*p.rope, q, q_scaled.data(), D, past);
+                q = q_scaled.data();
+            }
+            simd::ScaleSIMD(q, q_scaled.data(), static_cast<size_t>(D), p.scale);
+            const int64_t kv_head = h / group;
+            const float* mask_bh = p.mask ? p.mask + b * p.mask_strides.b + h * p.mask_strides.h : nullptr;
+    
+            while (k_begin < key_end) {
+                const KVRun located = p.locate(b, kv_head, k_begin);
+                const int64_t cols = std::min({kDecodeKeyBlock, key_end - k_begin, located.count});
+                const KVRun run = LoadKVTile(p, located, cols, &key_tile, &value_tile);
+                float* s = scores.data();
+                gemm::SgemmSkinny(true, 1, cols, D, 1.0f, q_scaled.data(), D, run.key, D, 0.0f, s, cols);
+                if (mask_bh) {
+                    const float* m = mask_bh + k_begin * p.mask_strides.t;
+                    for (int64_t j = 0; j < cols; ++j) {
+                        s[j] += m[j * p.mask_strides.t];
+                    }
+                }
+                const float new_max = std::max(row_max, simd::ReduceMaxSIMD(s, static_cast<size_t>(cols)));
+                if (new_max != -std::numeric_limits<float>::infinity()) {
+                    const float correction = std::exp(row_max - new_max);
+                    row_sum = row_sum * correction + simd::ExpShiftSumSIMD(s, s, static_cast<size_t>(cols), new_max);
+                    row_max = new_max;
+                    if (correction != 1.0f) {
+                        simd::ScaleSIMD(acc, acc, static_cast<size_t>(Dv), correction);
+                    }
+                    gemm::SgemmSkinny(false, 1, Dv, cols, 1.0f, s, cols, run.value, Dv, 1.0f, acc, Dv);
+                }
+                k_begin += cols;
+            }
+        }
+    });
+    
+    ParallelForOuter(ctx, rows, splits * Dv, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const float* row_partial = partial.data() + row * splits * stride;
+            float global_max = -std::numeric_limits<float>::infinity();
+            for (int64_t split = 0; split < splits; ++split) {
+                global_max = std::max(global_max, row_partial[split * stride + Dv]);
+            }
+            float* out = p.O + query_row(row) * Dv;
+            std::fill(out, out + Dv, 0.0f);
+            float sum = 0.0f;
+            for (int64_t split = 0; split < splits; ++split) {
+                const float* part = row_partial + split * stride;
+                if (part[Dv + 1] == 0.0f) {
+                    continue;  // 空段或该段全部被mask
+                }
+                const float weight = std::exp(part[Dv] - global_max);
+                sum += part[Dv + 1] * weight;
+                simd::ScaleAddSIMD(part, weight, out, static_cast<size_t>(Dv));
+            }
+            simd::ScaleSIMD(out, out, static_cast<size_t>(Dv), sum > 0.0f ? 1.0f / sum : 0.0f);
+        }
+    });
+}
+
+void RunAttention(AttentionProblem& p, ExecutionContext* ctx) {
+    if (!p.locate) {
+        p.locate = ContiguousLocator(p);
+    }
+    // 每个序列只有一个新位置时（单token解码）走按键值切分的解码路径
+    bool decode = p.q.length == 1;
+    for (size_t b = 1; b < p.query_offsets.size(); ++b) {
+        decode = p.query_offsets[b] - p.query_offsets[b - 1] == 1;
+        if (!decode) {
+            break;
+        }
+    }
+    if (decode) {
+        RunDecodeAttention(p, ctx);
+        return;
+    }
+    const int64_t S = p.q.length;
+    const int64_t D = p.q.dim;
+    const int64_t Dv = p.dv;
+    const int64_t group = p.q.heads / p.kv_heads;
+    const bool packed = !p.query_offsets.empty();
+    const int64_t num_seqs = packed ? static_cast<int64_t>(p.query_offsets.size()) - 1 : p.q.batch;
+    auto seq_length = [&](int64_t b) { return packed ? p.query_offsets[b + 1] - p.query_offsets[b] : S; };
+    // 每个序列的任务数不同（打包时长度不一），task_offsets[b]为第b个序列的第一个任务
+    std::vector<int64_t> task_offsets(static_cast<size_t>(num_seqs) + 1, 0);
+    for (int64_t b = 0; b < num_seqs; ++b) {
+        task_offsets[b + 1] = task_offsets[b] + p.q.heads * ((seq_length(b) + kQueryBlock - 1) / kQueryBlock);
+    }
+    const int64_t tasks = task_offsets.back();
+    
+    // 每个任务：一个(b, h)的Br行查询，与全部键值块做在线softmax
+    const int64_t task_cost = kQueryBlock * (p.past[0] + seq_length(0)) * (D + Dv);
+    ParallelForOuter(ctx, tasks, task_cost, [&](int64_t begin, int64_t end) {
+        std::vector<float> scores(kQueryBlock * kKeyBlock);
+        std::vector<float> acc(kQueryBlock * Dv);
+        std::vector<float> row_max(kQueryBlock);
+        std::vector<float> row_sum(kQueryBlock);
+        std::vector<float> q_rot(p.rope ? kQueryBlock * D : 0);
+        std::vector<float> key_tile, value_tile;
+    
+        for (int64_t task = begin; task < end; ++task) {
+            const int64_t b = std::upper_bound(task_offsets.begin(), task_offsets.end(), task) -
+                              task_offsets.begin() - 1;
+            const int64_t length = seq_length(b);
+            const int64_t q_blocks = (length + kQueryBlock - 1) / kQueryBlock;
+            const int64_t local = task - task_offsets[b];
+            const int64_t h = local / q_blocks;
+            const int64_t q_begin = (local % q_blocks) * kQueryBlock;
+            const int64_t rows = std::min(kQueryBlock, length - q_begin);
+            // 该(b, h)第0个查询在Q/O中的行
+            const int64_t row_base = packed ? h * S + p.query_offsets[b] : (b * p.q.heads + h) * S;
+            const int64_t past = p.past[b];  // 查询i的绝对位置为past + i
+    
+            const float* q_block = p.Q + (row_base + q_begin) * D;
+            if (p.rope) {
+                for (int64_t i = 0; i < rows; ++i) {
+                    ApplyRotary(*p.rope, q_block + i * D, q_rot.data() + i * D, D, past + q_begin + i);
+                }
+                q_block = q_rot.data();
+            }
+            const int64_t kv_head = h / group;
+            const float* mask_bh = p.mask ? p.mask + b * p.mask_strides.b + h * p.mask_strides.h : nullptr;
+    
+            std::fill(acc.begin(), acc.begin() + rows * Dv, 0.0f);
+            std::fill(row_max.begin(), row_max.end(), -std::numeric_limits<float>::infinity());
+            std::fill(row_sum.begin(), row_sum.end(), 0.0f);
+    
+            // causal时第rows-1行能看到的最后一个键之后的块整体跳过
+            const int64_t total = past + length;
+            const int64_t key_end = p.causal ? std::min(total, past + q_begin + rows) : total;
+            for (int64_t k_begin = 0; k_begin < key_end;) {
+                // 键值块不跨越存储中不连续的边界（分页时为块边界）
+                const KVRun located = p.locate(b, kv_head, k_begin);
+                const int64_t cols = std::min({kKeyBlock, key_end - k_begin, located.count});
+                const KVRun run = LoadKVTile(p, located, cols, &key_tile, &value_tile);
+    
+                // scores[rows, cols] = scale * Q_block * K_tile^T
+                gemm::Sgemm(false, true, rows, cols, D, p.scale, q_block, D,
+                            run.key, D, 0.0f, scores.data(), kKeyBlock);
+    
+                for (int64_t i = 0; i < rows; ++i) {
+                    float* s = scores.data() + i * kKeyBlock;
+                    const int64_t query = q_begin + i;
+                    if (mask_bh) {
+                        const float* m = mask_bh + query * p.mask_strides.s + k_begin * p.mask_strides.t;
+                        for (int64_t j = 0; j < cols; ++j) {
+                            s[j] += m[j * p.mask_strides.t];
+                        }
+                    }
+                    int64_t visible = cols;
+                    if (p.causal) {
+                        visible = std::max<int64_t>(0, std::min(cols, past + query + 1 - k_begin));
+                        std::fill(s + visible, s + cols, -std::numeric_limits<float>::infinity());
+                    }
+    
+                    // 在线softmax：新的行最大值下把已有累加结果与sum按exp(m_old - m_new)缩放
+                    const float tile_max = visible > 0 ? simd::ReduceMaxSIMD(s, static_cast<size_t>(visible))
+                                                       : -std::numeric_limits<float>::infinity();
+                    const float new_max = std::max(row_max[i], tile_max);
+                    if (new_max == -std::numeric_limits<float>::infinity()) {
+                        std::fill(s, s + cols, 0.0f);  // 该行迄今全部被mask
+                        continue;
+                    }
+                    const float correction = std::exp(row_max[i] - new_max);
+                    const float tile_sum = simd::ExpShiftSumSIMD(s, s, static_cast<size_t>(cols), new_max);
+                    row_sum[i] = row_sum[i] * correction + tile_sum;
+                    row_max[i] = new_max;
+                    if (correction != 1.0f) {
+                        simd::ScaleSIMD(acc.data() + i * Dv, acc.data() + i * Dv,
+                                        static_cast<size_t>(Dv), correction);
+                    }
+                }
+    
+                // acc[rows, Dv] += P[rows, cols] * V_tile[cols, Dv]
+                gemm::Sgemm(false, false, rows, Dv, cols, 1.0f, scores.data(), kKeyBlock,
+                            run.value, Dv, 1.0f, acc.data(), Dv);
+                k_begin += cols;
+            }
+    
+            float* out = p.O + (row_base + q_begin) * Dv;
+            for (int64_t i = 0; i < rows; ++i) {
+                const float inv_sum = row_sum[i] > 0.0f ? 1.0f / row_sum[i] : 0.0f;
+                simd::ScaleSIMD(acc.data() + i * Dv, out + i * Dv, static_cast<size_t>(Dv), inv_sum);
+            }
+        }
+    });
+}
+
+} // anonymous namespace
+
+// FusedAttention算子
+// 输入：Q [B, Hq, S, D], K [B, Hkv, T, D], V [B, Hkv, T, Dv],
+//      [cache_k, cache_v, cache_lengths](kv_cache=1时), mask(可选，加性), [cos, sin](rotary=1时)
+// 输出：[B, Hq, S, Dv]
+// 属性：scale（默认1/sqrt(D)）、causal（查询i只看到键j <= i + T - S）、
+//      rotary/rotary_interleaved（对Q、K应用RoPE，位置为T - S + i与j）
+// Hkv < Hq时为分组查询注意力（GQA），每Hq/Hkv个查询头共享一个键值头
+//
+// kv_cache=1时（参考ONNX Runtime GroupQueryAttention的past/present共享缓冲）：
+// K/V只含本次的S个新位置，cache_k/cache_v为预分配的[Bmax, Hkv, capacity, D]缓冲，
+// cache_lengths为INT64 [Bmax]的已缓存长度。新的K/V原地写入缓冲的cache_lengths[b]处，
+// 注意力覆盖cache_lengths[b] + S个位置，随后cache_lengths[b]增加S；前缀不做拷贝
+class FusedAttentionOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedAttention"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        const size_t expected_min = 3 + (KVCache() ? 3 : 0) + (Rotary() ? 2 : 0);
+        if (inputs.size() < expected_min || inputs.size() > expected_min + 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedAttention requires Q, K, V, optional KV cache, mask and rotary cos/sin");
+        }
+        HeadLayout q, k, v;
+        if (!ParseLayout(inputs[0]->GetShape(), &q) || !ParseLayout(inputs[1]->GetShape(), &k) ||
+            !ParseLayout(inputs[2]->GetShape(), &v)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedAttention inputs must be [B, H, L, D] or [B*H, L, D]");
+        }
+        if (k.batch != q.batch || v.batch != q.batch || k.dim != q.dim || v.heads != k.heads ||
+            v.length != k.length || q.heads % k.heads != 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedAttention Q/K/V shapes are incompatible");
+        }
+        if (KVCache()) {
+            HeadLayout ck, cv;
+            if (!ParseLayout(inputs[3]->GetShape(), &ck) || !ParseLayout(inputs[4]->GetShape(), &cv) ||
+                ck.batch < q.batch || ck.heads != k.heads || ck.dim != k.dim ||
+                cv.batch != ck.batch || cv.heads != k.heads || cv.length != ck.length || cv.dim != v.dim ||
+                k.length != q.length) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedAttention KV cache buffers do not match K/V");
+            }
+            if (inputs[5]->GetDataType() != DataType::INT64 ||
+                inputs[5]->GetElementCount() < static_cast<size_t>(q.batch)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedAttention cache_lengths must be INT64 [batch]");
+            }
+        } else if (Causal() && k.length < q.length) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedAttention causal mask requires kv length >= query length");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedAttention requires Q, K, V");
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        if (dims.empty() || inputs[2]->GetShape().dims.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedAttention inputs have no shape");
+        }
+        dims.back() = inputs[2]->GetShape().dims.back();
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        HeadLayout q, k, v;
+        if (inputs.size() < 3 || !ParseLayout(inputs[0].shape, &q) || !ParseLayout(inputs[1].shape, &k) ||
+            !ParseLayout(inputs[2].shape, &v)) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        // 使用KV缓存时注意力覆盖的长度取决于运行时的cache_lengths，按缓存容量估计上界
+        double length = static_cast<double>(k.length);
+        HeadLayout cache;
+        if (KVCache() && inputs.size() > 3 && ParseLayout(inputs[3].shape, &cache)) {
+            length = static_cast<double>(cache.length);
+        }
+        // 因果mask下第i个查询只看前length - S + i + 1个位置
+        double attended = length;
+        if (Causal() && length >= static_cast<double>(q.length)) {
+            attended = length - static_cast<double>(q.length - 1) / 2.0;
+        }
+        // QK^T与PV各为乘加，softmax每个分数约12次运算（见GetElementwiseFlops）
+        const double scores = static_cast<double>(q.batch * q.heads * q.length) * attended;
+        OperatorCost cost;
+        cost.flops = scores * (2.0 * static_cast<double>(q.dim) + 2.0 * static_cast<double>(v.dim) +
+                               GetElementwiseFlops("Softmax"));
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (KVCache() && (i == 3 || i == 4)) {
+                continue;
+            }
+            cost.bytes_read += GetTensorInfoBytes(inputs[i]);
+        }
+        for (const TensorInfo& output : outputs) {
+            cost.bytes_written += GetTensorInfoBytes(output);
+        }
+        if (KVCache()) {
+            // 只读缓存中被覆盖的位置，本次的K/V写入缓存
+            const size_t element = GetDataTypeSize(inputs[1].dtype);
+            const double kv_dims = static_cast<double>(k.dim + v.dim);
+            cost.bytes_read += static_cast<size_t>(static_cast<double>(q.batch * k.heads) * length * kv_dims) * element;
+            cost.bytes_written += static_cast<size_t>(q.batch * k.heads * k.length) * (k.dim + v.dim) * element;
+        }
+        return cost;
+    }
+    
+    // 不使用KV缓存时旋转后的K计入暂存区
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        OperatorMemory memory;
+        if (Rotary() && !KVCache() && inputs.size() > 1) {
+            memory.scratch_bytes = GetTensorInfoBytes(inputs[1]);
+        }
+        return memory;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        AttentionProblem problem;
+        HeadLayout k, v;
+        ParseLayout(inputs[0]->GetShape(), &problem.q);
+        ParseLayout(inputs[1]->GetShape(), &k);
+        ParseLayout(inputs[2]->GetShape(), &v);
+        const HeadLayout& q = problem.q;
+        const int64_t S = q.length;
+        const int64_t D = q.dim;
+        problem.kv_heads = k.heads;
+        problem.dv = v.dim;
+        if (outputs[0]->GetElementCount() != static_cast<size_t>(q.batch * q.heads * S * v.dim)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedAttention output shape mismatch");
+        }
+    
+        const size_t mask_index = KVCache() ? 6 : 3;
+        const bool has_mask = inputs.size() == mask_index + 1 + (Rotary() ? 2 : 0);
+        int64_t* cache_lengths = nullptr;
+        if (KVCache()) {
+            cache_lengths = static_cast<int64_t*>(inputs[5]->GetData());
+            problem.capacity = inputs[3]->GetShape().dims[2];
+            problem.past.assign(cache_lengths, cache_lengths + q.batch);
+        } else {
+            problem.capacity = k.length;
+            problem.past.assign(q.batch, k.length - S);
+        }
+    
+        RotaryTable rope;
+        if (Rotary()) {
+            const int64_t max_positions = *std::max_element(problem.past.begin(), problem.past.end()) + S;
+            status = PrepareRotary(inputs[inputs.size() - 2], inputs[inputs.size() - 1], D, max_positions,
+                                   GetIntAttribute("rotary_interleaved", 0) != 0, GetName(), &rope);
+            if (!status.IsOk()) {
+                return status;
+            }
+            problem.rope = &rope;
+        }
+    
+        const float* K = static_cast<const float*>(inputs[1]->GetData());
+        const float* V = static_cast<const float*>(inputs[2]->GetData());
+        if (KVCache()) {
+            status = AppendToCache(inputs, k, problem.past, problem.capacity, problem.rope, ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+            problem.K = static_cast<const float*>(inputs[3]->GetData());
+            problem.V = static_cast<const float*>(inputs[4]->GetData());
+        } else {
+            if (Rotary()) {
+                // K的每个位置只旋转一次，供所有查询块共享；旋转结果放在调用线程的暂存区
+                float* rotated_k = ScratchArena::ForCurrentThread().Allocate<float>(inputs[1]->GetElementCount());
+                ParallelForOuter(ctx, k.batch * k.heads, k.length * D, [&](int64_t begin, int64_t end) {
+                    for (int64_t r = begin; r < end; ++r) {
+                        for (int64_t j = 0; j < k.length; ++j) {
+                            const int64_t offset = (r * k.length + j) * D;
+                            ApplyRotary(rope, K + offset, rotated_k + offset, D, j);
+                        }
+                    }
+                });
+                K = rotated_k;
+            }
+            problem.K = K;
+            problem.V = V;
+        }
+    
+        if (has_mask) {
+            // 有mask时各样本的键数须一致（等于mask的最后一维）
+            const int64_t total = problem.past[0] + S;
+            if (std::any_of(problem.past.begin(), problem.past.end(),
+                            [&](int64_t past) { return past != problem.past[0]; }) ||
+                !ComputeMaskStrides(inputs[mask_index]->GetShape(), q, total, &problem.mask_strides)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedAttention mask is not broadcastable to [B, H, S, T]");
+            }
+            problem.mask = static_cast<const float*>(inputs[mask_index]->GetData());
+        }
+    
+        problem.Q = static_cast<const float*>(inputs[0]->GetData());
+        problem.O = static_cast<float*>(outputs[0]->GetData());
+        problem.scale = GetFloatAttribute("scale", 1.0f / std::sqrt(static_cast<float>(D)));
+        problem.causal = Causal();
+        RunAttention(problem, ctx);
+    
+        if (cache_lengths) {
+            for (int64_t b = 0; b < q.batch; ++b) {
+                cache_lengths[b] += S;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    bool Causal() const { return GetIntAttribute("causal", 0) != 0; }
+    bool Rotary() const { return GetIntAttribute("rotary", 0) != 0; }
+    bool KVCache() const { return GetIntAttribute("kv_cache", 0) != 0; }
+    
+    // 把本次的K/V写入缓存的past[b]处（K在写入前应用RoPE）
+    Status AppendToCache(const std::vector<Tensor*>& inputs, const HeadLayout& k,
+                         const std::vector<int64_t>& past, int64_t capacity,
+                         const RotaryTable* rope, ExecutionContext* ctx) const {
+        const int64_t S = k.length;
+        const int64_t D = k.dim;
+        const int64_t Dv = inputs[2]->GetShape().dims.back();
+        for (int64_t b = 0; b < k.batch; ++b) {
+            if (past[b] < 0 || past[b] + S > capacity) {
+                return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY,
+                                   "FusedAttention KV cache capacity exceeded");
+            }
+        }
+        const float* K = static_cast<const float*>(inputs[1]->GetData());
+        const float* V = static_cast<const float*>(inputs[2]->GetData());
+        float* cache_k = static_cast<float*>(inputs[3]->GetData());
+        float* cache_v = static_cast<float*>(inputs[4]->GetData());
+        ParallelForOuter(ctx, k.batch * k.heads, S * (D + Dv), [&](int64_t begin, int64_t end) {
+            for (int64_t r = begin; r < end; ++r) {
+                const int64_t position = past[r / k.heads];
+                float* dst_k = cache_k + (r * capacity + position) * D;
+                float* dst_v = cache_v + (r * capacity + position) * Dv;
+                for (int64_t j = 0; j < S; ++j) {
+                    const float* src = K + (r * S + j) * D;
+                    if (rope) {
+                        ApplyRotary(*rope, src, dst_k + j * D, D, position + j);
+                    } else {
+                        std::memcpy(dst_k + j * D, src, D * sizeof(float));
+                    }
+                }
+                std::memcpy(dst_v, V + r * S * Dv, S * Dv * sizeof(float));
+            }
+        });
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("FusedAttention", FusedAttentionOperator);
+
+// RotaryEmbedding算子（参考ONNX Runtime contrib的RotaryEmbedding）：
+// 输入x [B, H, S, D]或[B*H, S, D], position_ids INT64 [B, S]、[1, S]或[S],
+//     cos_cache/sin_cache [P, D/2]或[P, D]（预先算好的各位置cos/sin表，前导维度按位置展开）
+// 输出与x同形；属性interleaved同FusedAttention的rotary_interleaved。
+// 融合Pass把导出模型中rotate_half的Slice/Neg/Concat/Mul/Add子图改写为该算子；
+// 每对元素先读后写，可以原地覆盖x
+class RotaryEmbeddingOperator : public Operator {
+public:
+    std::string GetName() const override { return "RotaryEmbedding"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "RotaryEmbedding requires x, position_ids, cos_cache and sin_cache");
+        }
+        HeadLayout x;
+        if (!ParseLayout(inputs[0]->GetShape(), &x) || inputs[0]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "RotaryEmbedding x must be FLOAT32 [B, H, S, D] or [B*H, S, D]");
+        }
+        const int64_t rows = x.batch * x.heads;
+        const int64_t count = static_cast<int64_t>(inputs[1]->GetElementCount());
+        if (inputs[1]->GetDataType() != DataType::INT64 || count % x.length != 0 ||
+            count / x.length == 0 || rows % (count / x.length) != 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "RotaryEmbedding position_ids must be INT64 [B, S] or [S]");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "RotaryEmbedding requires x");
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 每个元素两次乘法与一次加法
+        return EstimateElementwiseCost(inputs, outputs, 3.0);
+    }
+    
+    int GetInPlaceInput() const override { return 0; }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 4 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        HeadLayout x;
+        if (!ParseLayout(inputs[0]->GetShape(), &x) ||
+            outputs[0]->GetElementCount() != inputs[0]->GetElementCount()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "RotaryEmbedding output shape mismatch");
+        }
+        const int64_t* positions = static_cast<const int64_t*>(inputs[1]->GetData());
+        const int64_t count = static_cast<int64_t>(inputs[1]->GetElementCount());
+        int64_t max_position = 0;
+        for (int64_t i = 0; i < count; ++i) {
+            if (positions[i] < 0) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "RotaryEmbedding position_ids must be non-negative");
+            }
+            max_position = std::max(max_position, positions[i]);
+        }
+        RotaryTable rope;
+        Status status = PrepareRotary(inputs[2], inputs[3], x.dim, max_position + 1,
+                                      GetIntAttribute("interleaved", 0) != 0, GetName(), &rope);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        const int64_t S = x.length;
+        const int64_t D = x.dim;
+        // position_ids的每一行由rows / position_rows个相邻的(b, h)行共享
+        const int64_t rows_per_position_row = x.batch * x.heads / (count / S);
+        const float* X = static_cast<const float*>(inputs[0]->GetData());
+        float* Y = static_cast<float*>(outputs[0]->GetData());
+        ParallelForOuter(ctx, x.batch * x.heads, S * D, [&](int64_t begin, int64_t end) {
+            for (int64_t r = begin; r < end; ++r) {
+                const int64_t* row_positions = positions + (r / rows_per_position_row) * S;
+                for (int64_t i = 0; i < S; ++i) {
+                    const int64_t offset = (r * S + i) * D;
+                    ApplyRotary(rope, X + offset, Y + offset, D, row_positions[i]);
+                }
+            }
+        });
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("RotaryEmbedding", RotaryEmbeddingOperator);
+
+} // namespace operators
+} // namespace inferunity
+
+namespace inferunity {
+namespace attention {
+
+namespace {
+
+// query_offsets为空时是[B, H, S, D]布局，否则是打包布局（见PagedAttentionPacked）
+Status RunPagedAttention(const PagedKVCache& cache, size_t layer, const std::vector<int64_t>& sequences,
+                         const std::vector<int64_t>& query_offsets, const Tensor& q, const Tensor& key,
+                         const Tensor& value, Tensor* output, const PagedAttentionOptions& options,
+                         ExecutionContext* ctx) {
+    operators::AttentionProblem problem;
+    operators::HeadLayout k, v;
+    if (layer >= cache.GetNumLayers() || !output ||
+        !operators::ParseLayout(q.GetShape(), &problem.q) || !operators::ParseLayout(key.GetShape(), &k) ||
+        !operators::ParseLayout(value.GetShape(), &v)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "PagedAttention inputs must be [B, H, S, D]");
+    }
+    const operators::HeadLayout& ql = problem.q;
+    const bool packed = !query_offsets.empty();
+    const int64_t S = ql.length;
+    const int64_t D = ql.dim;
+    const int64_t num_seqs = static_cast<int64_t>(sequences.size());
+    if ((packed ? ql.batch != 1 : num_seqs != ql.batch) || k.batch != ql.batch || v.batch != ql.batch ||
+        k.length != S || v.length != S || k.heads != cache.GetKVHeads(layer) || v.heads != k.heads ||
+        k.dim != cache.GetKeyDim(layer) || D != k.dim || v.dim != cache.GetValueDim(layer) ||
+        ql.heads % k.heads != 0 ||
+        output->GetElementCount() != static_cast<size_t>(ql.batch * ql.heads * S * v.dim)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "PagedAttention shapes do not match the KV cache layer");
+    }
+    if (packed) {
+        if (static_cast<int64_t>(query_offsets.size()) != num_seqs + 1 || query_offsets.front() != 0 ||
+            query_offsets.back() != S || !std::is_sorted(query_offsets.begin(), query_offsets.end())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "PagedAttention query offsets do not cover the packed tokens");
+        }
+        problem.query_offsets = query_offsets;
+    }
+    
+    // 第b个序列第j个新位置在K/V中的行与绝对位置
+    auto seq_begin = [&](int64_t b) { return packed ? query_offsets[b] : 0; };
+    auto seq_length = [&](int64_t b) { return packed ? query_offsets[b + 1] - query_offsets[b] : S; };
+    std::vector<const std::vector<int32_t>*> tables;
+    for (int64_t b = 0; b < num_seqs; ++b) {
+        const int64_t seq = sequences[b];
+        const int64_t length = cache.GetSequenceLength(seq);
+        if (!cache.HasSequence(seq) || length < seq_length(b)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "PagedAttention requires AppendSlots before each step");
+        }
+        problem.past.push_back(length - seq_length(b));
+        tables.push_back(&cache.GetBlockTable(seq));
+    }
+    
+    const int64_t block_size = cache.GetBlockSize();
+    problem.kv_heads = k.heads;
+    problem.dv = v.dim;
+    problem.storage = cache.GetStorage();
+    const bool quantized = problem.storage != KVCacheStorage::FLOAT32;
+    problem.locate = [&](int64_t b, int64_t kv_head, int64_t position) {
+        const int32_t block = (*tables[b])[position / block_size];
+        const int64_t offset = kv_head * block_size + position % block_size;
+        operators::KVRun run;
+        run.count = block_size - position % block_size;
+        if (quantized) {
+            run.key_data = cache.GetKeyBlockData(layer, block) + offset * D;
+            run.value_data = cache.GetValueBlockData(layer, block) + offset * problem.dv;
+            run.key_scale = cache.GetKeyScales(layer, block) + offset;
+            run.value_scale = cache.GetValueScales(layer, block) + offset;
+        } else {
+            run.key = cache.GetKeyBlock(layer, block) + offset * D;
+            run.value = cache.GetValueBlock(layer, block) + offset * problem.dv;
+        }
+        return run;
+    };
+    
+    // 新位置写入各自序列的块：任务为(序列, kv头)，打包时K/V的行为(kv头, 打包位置)；量化存储时写入即量化
+    const float* K = static_cast<const float*>(key.GetData());
+    const float* V = static_cast<const float*>(value.GetData());
+    operators::ParallelForOuter(ctx, num_seqs * k.heads, (S / std::max<int64_t>(num_seqs, 1)) * (D + v.dim),
+                                [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            const int64_t b = r / k.heads;
+            const int64_t h = r % k.heads;
+            const int64_t row_base = packed ? h * S + seq_begin(b) : r * S;
+            for (int64_t j = 0; j < seq_length(b); ++j) {
+                const operators::KVRun slot = problem.locate(b, h, problem.past[b] + j);
+                if (quantized) {
+                    QuantizeKVRow(problem.storage, K + (row_base + j) * D, D, const_cast<uint8_t*>(slot.key_data),
+                                  const_cast<float*>(slot.key_scale));
+                    QuantizeKVRow(problem.storage, V + (row_base + j) * v.dim, v.dim,
+                                  const_cast<uint8_t*>(slot.value_data), const_cast<float*>(slot.value_scale));
+                    continue;
+                }
+                std::memcpy(const_cast<float*>(slot.key), K + (row_base + j) * D, D * sizeof(float));
+                std::memcpy(const_cast<float*>(slot.value), V + (row_base + j) * v.dim, v.dim * sizeof(float));
+            }
+        }
+    });
+    
+    problem.Q = static_cast<const float*>(q.GetData());
+    problem.O = static_cast<float*>(output->GetData());
+    problem.scale = options.scale > 0.0f ? options.scale : 1.0f / std::sqrt(static_cast<float>(D));
+    problem.causal = options.causal;
+    operators::RunAttention(problem, ctx);
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+Status PagedAttention(const PagedKVCache& cache, size_t layer, const std::vector<int64_t>& sequences,
+                      const Tensor& q, const Tensor& key, const Tensor& value, Tensor* output,
+                      const PagedAttentionOptions& options, ExecutionContext* ctx) {
+    return RunPagedAttention(cache, layer, sequences, {}, q, key, value, output, options, ctx);
+}
+
+Status PagedAttentionPacked(const PagedKVCache& cache, size_t layer, const std::vector<int64_t>& sequences,
+                            const std::vector<int64_t>& query_offsets, const Tensor& q, const Tensor& key,
+                            const Tensor& value, Tensor* output, const PagedAttentionOptions& options,
+                            ExecutionContext* ctx) {
+    if (query_offsets.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "PagedAttentionPacked requires query offsets");
+    }
+    return RunPagedAttention(cache, layer, sequences, query_offsets, q, key, value, output, options, ctx);
+}
+
+} // namespace attention
+} // namespace inferunity
@@ -0,0 +1,37 @@
+// 分页注意力（PagedAttention）
+// 参考vLLM的paged_attention核：键值按块表从PagedKVCache的物理块读取，
+// 分块在线softmax与FusedAttention共用同一实现，不同序列可以有不同的长度
+
+#pragma once
+
+#include "inferunity/kv_cache.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include <vector>
+
+namespace inferunity {
+namespace attention {
+
+struct PagedAttentionOptions {
+    float scale = 0.0f;   // 0表示1/sqrt(head_dim)
+    bool causal = true;   // 新位置i只看到位置<= length - S + i的键
+};
+
+// q [B, Hq, S, D]，key/value为本次的新位置[B, Hkv, S, D]/[B, Hkv, S, Dv]，output [B, Hq, S, Dv]
+// 第b个样本属于序列sequences[b]，调用前须已对该序列AppendSlots(seq, S)：
+// 新位置写入块表中的[length - S, length)，随后在全部length个位置上计算注意力
+Status PagedAttention(const PagedKVCache& cache, size_t layer, const std::vector<int64_t>& sequences,
+                      const Tensor& q, const Tensor& key, const Tensor& value, Tensor* output,
+                      const PagedAttentionOptions& options, ExecutionContext* ctx);
+
+// 打包（varlen）布局（参考FlashAttention的flash_attn_varlen_func与vLLM的连续批处理）：
+// 各序列本次的新位置沿序列维首尾相接，不做填充。q [1, Hq, T, D]，key/value [1, Hkv, T, D]/[1, Hkv, T, Dv]，
+// output [1, Hq, T, Dv]；第b个序列占[query_offsets[b], query_offsets[b + 1])（size为序列数 + 1，
+// 首项为0、末项为T），长度可以不同，prefill分块与单token解码可以在同一次调用中混合
+Status PagedAttentionPacked(const PagedKVCache& cache, size_t layer, const std::vector<int64_t>& sequences,
+                            const std::vector<int64_t>& query_offsets, const Tensor& q, const Tensor& key,
+                            const Tensor& value, Tensor* output, const PagedAttentionOptions& options,
+                            ExecutionContext* ctx);
+
+} // namespace attention
+} // namespace inferunity
@@ -0,0 +1,118 @@
+// 张量并行的集合通信算子（由TensorParallelShardingPass插入）
+// 参考ONNX Runtime contrib ops的AllReduce/AllGather（collective/nccl_kernels.cc）
+
+#include "inferunity/operator.h"
+#include "inferunity/collectives.h"
+#include "inferunity/tensor.h"
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+Status FindGroup(const Operator& op, std::shared_ptr<CollectiveGroup>* group) {
+    *group = CollectiveGroup::Find(op.GetIntAttribute("group_id", 0));
+    if (!*group) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND,
+                           op.GetName() + ": collective group not found");
+    }
+    if ((*group)->GetWorldSize() != op.GetIntAttribute("world_size", 1)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           op.GetName() + ": world_size does not match the collective group");
+    }
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+// AllReduce算子：各rank的部分和求和（行并行MatMul之后）
+// 属性：group_id, rank, world_size, tag（各rank上同一个集合操作的编号）
+class AllReduceOperator : public Operator {
+public:
+    std::string GetName() const override { return "AllReduce"; }
+
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllReduce requires 1 input");
+        }
+        return Status::Ok();
+    }
+
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::shared_ptr<CollectiveGroup> group;
+        Status status = FindGroup(*this, &group);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return group->AllReduceSum(static_cast<int>(GetIntAttribute("rank", 0)), GetIntAttribute("tag", 0),
+                                   *inputs[0], outputs[0], ctx ? ctx->GetStream() : nullptr);
+    }
+};
+
+REGISTER_OPERATOR("AllReduce", AllReduceOperator);
+
+// AllGather算子：各rank的分片沿axis按rank顺序拼接（列并行的结果交给不能分片执行的算子之前）
+// 属性：group_id, rank, world_size, tag, axis
+class AllGatherOperator : public Operator {
+public:
+    std::string GetName() const override { return "AllGather"; }
+
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllGather requires 1 input");
+        }
+        return Status::Ok();
+    }
+
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Shape shape = inputs[0]->GetShape();
+        int64_t axis = GetIntAttribute("axis", 0);
+        if (axis < 0) {
+            axis += static_cast<int64_t>(shape.dims.size());
+        }
+        if (axis < 0 || axis >= static_cast<int64_t>(shape.dims.size())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "AllGather axis out of range");
+        }
+        if (shape.dims[axis] >= 0) {
+            shape.dims[axis] *= GetIntAttribute("world_size", 1);
+        }
+        output_shapes.push_back(shape);
+        return Status::Ok();
+    }
+
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::shared_ptr<CollectiveGroup> group;
+        Status status = FindGroup(*this, &group);
+        if (!status.IsOk()) {
+            return status;
+        }
+        int64_t axis = GetIntAttribute("axis", 0);
+        if (axis < 0) {
+            axis += static_cast<int64_t>(inputs[0]->GetShape().dims.size());
+        }
+        return group->AllGather(static_cast<int>(GetIntAttribute("rank", 0)), GetIntAttribute("tag", 0),
+                                *inputs[0], axis, outputs[0], ctx ? ctx->GetStream() : nullptr);
+    }
+};
+
+REGISTER_OPERATOR("AllGather", AllGatherOperator);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,617 @@
+// 控制流算子实现：If、Loop、Scan
+// 参考ONNX Runtime的controlflow内核（SubgraphExecutionHelper、Loop的OutputIterator）：
+// 子图在第一次执行时构建执行计划，之后每次执行（与每次迭代）只在复用的ExecutionState上按计划运行；
+// 子图引用的外层值由解析器改写为子图末尾的图输入，节点末尾对应的num_implicit_inputs个输入原样传入。
+// 输出形状取决于运行时的数据，形状推断不给出结果，运行时先放占位张量，执行时替换为真实结果
+
+#include "inferunity/operator.h"
+#include "inferunity/backend.h"
+#include "inferunity/execution_plan.h"
+#include "inferunity/runtime.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 标量（只有一个元素的张量）按其类型读出
+bool ReadScalar(const Tensor* tensor, int64_t* value) {
+    if (!tensor || !tensor->GetData() || tensor->GetElementCount() != 1) {
+        return false;
+    }
+    const void* data = tensor->GetData();
+    switch (tensor->GetDataType()) {
+        case DataType::BOOL:
+        case DataType::UINT8: *value = *static_cast<const uint8_t*>(data); return true;
+        case DataType::INT8: *value = *static_cast<const int8_t*>(data); return true;
+        case DataType::INT32: *value = *static_cast<const int32_t*>(data); return true;
+        case DataType::INT64: *value = *static_cast<const int64_t*>(data); return true;
+        case DataType::FLOAT32: *value = static_cast<int64_t>(*static_cast<const float*>(data)); return true;
+        default: return false;
+    }
+}
+
+// 把子图的结果写进外层的输出张量：外层已按同样形状绑定了缓冲（内存规划或IOBinding）时拷入；
+// 否则外层只是占位张量，owned的结果直接移交存储，其余（直通的输入、常量）复制一份
+Status AssignOutput(const std::shared_ptr<Tensor>& result, bool owned, Tensor* output) {
+    if (output->GetData() && output->GetShape().dims == result->GetShape().dims &&
+        output->GetDataType() == result->GetDataType()) {
+        return result->CopyTo(*output);
+    }
+    if (owned) {
+        *output = std::move(*result);
+        return Status::Ok();
+    }
+    *output = Tensor(Shape(result->GetShape().dims), result->GetDataType());
+    return result->CopyTo(*output);
+}
+
+// 一个子图的预编译执行计划：在独立的CPU执行提供者上构建（已编译内核按节点id缓存，不能与外层图共用），
+// 同一算子实例可能被并发执行，每次执行各取一个ExecutionState，用完放回
+class SubgraphExecutor {
+public:
+    Status Prepare(const std::shared_ptr<Graph>& graph) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (plan_) {
+            return Status::Ok();
+        }
+        if (!graph) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Missing subgraph attribute");
+        }
+        provider_ = ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider");
+        if (!provider_) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "CPU execution provider is not registered");
+        }
+        std::unique_ptr<ExecutionPlan> plan;
+        {
+            // 形状推断等路径会临时创建同一节点的算子实例，图的压缩与拓扑序缓存不是线程安全的
+            static std::mutex build_mutex;
+            std::lock_guard<std::mutex> build_lock(build_mutex);
+            graph->Compact();
+            Status status = ExecutionPlan::Build(graph.get(), {provider_.get()}, ExecutionPlanOptions(), &plan);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        // 只有子图自己产生、且只作为一个输出的值可以从state中移出
+        const std::vector<int>& output_slots = plan->GetOutputSlots();
+        movable_.assign(output_slots.size(), false);
+        for (size_t i = 0; i < output_slots.size(); ++i) {
+            movable_[i] = plan->GetValues()[output_slots[i]]->GetProducer() &&
+                std::count(output_slots.begin(), output_slots.end(), output_slots[i]) == 1;
+        }
+        graph_ = graph;
+        plan_ = std::move(plan);
+        return Status::Ok();
+    }
+    
+    size_t GetNumInputs() const { return plan_->GetInputSlots().size(); }
+    size_t GetNumOutputs() const { return plan_->GetOutputSlots().size(); }
+    
+    Status Acquire(std::unique_ptr<ExecutionState>* state) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_states_.empty()) {
+                *state = std::move(idle_states_.back());
+                idle_states_.pop_back();
+                return Status::Ok();
+            }
+        }
+        return ExecutionState::Create(*plan_, nullptr, state);
+    }
+    
+    void Release(std::unique_ptr<ExecutionState> state) {
+        state->ClearBoundOutputs();
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_states_.push_back(std::move(state));
+    }
+    
+    Status Run(ExecutionState* state, const std::vector<Tensor*>& inputs, ExecutionContext* ctx) {
+        ExecutionOptions options;
+        if (ctx) {
+            options.intra_op_num_threads = ctx->GetIntraOpParallelism().num_threads;
+            options.intra_op_min_work_per_thread = ctx->GetIntraOpParallelism().min_work_per_thread;
+        }
+        Status status = BeginStateRun(*plan_, state, inputs);
+        if (status.IsOk()) {
+            status = ExecuteStateSteps(*plan_, state, 0, plan_->GetSteps().size(), options);
+        }
+        std::vector<Tensor*> outputs;
+        EndStateRun(*plan_, state, status.IsOk(), outputs);
+        return status;
+    }
+    
+    // 第i个输出，在该state下一次执行前有效；写进了绑定的缓冲时为nullptr
+    const std::shared_ptr<Tensor>& GetOutput(ExecutionState* state, size_t i) const {
+        return state->GetTensors()[plan_->GetOutputSlots()[i]];
+    }
+    
+    // 取出第i个输出：子图分配的张量从state中移出（*owned为true，调用方可以写入或移交存储），
+    // 直通的输入、常量与视图只能共享
+    std::shared_ptr<Tensor> TakeOutput(ExecutionState* state, size_t i, bool* owned) const {
+        std::shared_ptr<Tensor>& tensor = state->GetTensors()[plan_->GetOutputSlots()[i]];
+        *owned = movable_[i] && tensor && tensor->IsOwned() && tensor->IsContiguous();
+        return *owned ? std::move(tensor) : tensor;
+    }
+    
+    // 把空闲缓冲放回第i个输出的槽位：下一次执行时形状、类型一致就由内核直接写入，否则照常重新分配
+    void PlaceOutputBuffer(ExecutionState* state, size_t i, const std::shared_ptr<Tensor>& buffer) const {
+        if (movable_[i] && buffer) {
+            state->GetTensors()[plan_->GetOutputSlots()[i]] = buffer;
+        }
+    }
+    
+    int GetOutputSlot(size_t i) const { return plan_->GetOutputSlots()[i]; }
+    bool IsMovable(size_t i) const { return movable_[i]; }
+
+private:
+    std::mutex mutex_;
+    std::shared_ptr<Graph> graph_;
+    std::unique_ptr<ExecutionProvider> provider_;
+    std::unique_ptr<ExecutionPlan> plan_;
+    std::vector<bool> movable_;
+    std::vector<std::unique_ptr<ExecutionState>> idle_states_;
+};
+
+// 取一个ExecutionState，离开作用域时放回
+class StateLease {
+public:
+    explicit StateLease(SubgraphExecutor& executor) : executor_(executor) {}
+    ~StateLease() {
+        if (state_) {
+            executor_.Release(std::move(state_));
+        }
+    }
+    
+    Status Acquire() { return executor_.Acquire(&state_); }
+    ExecutionState* Get() const { return state_.get(); }
+
+private:
+    SubgraphExecutor& executor_;
+    std::unique_ptr<ExecutionState> state_;
+};
+
+// 循环携带的张量（Loop的v、Scan的状态）：每个变量在两块缓冲之间轮换，上一次迭代的结果作为本次的输入，
+// 另一块放回子图的输出槽位由内核直接写入；形状不变时整个循环每个变量只分配两次，不拷贝
+class CarriedTensors {
+public:
+    // 初值是外层的输入，只读共享
+    explicit CarriedTensors(const std::vector<Tensor*>& initial) {
+        for (Tensor* tensor : initial) {
+            current_.push_back(std::shared_ptr<Tensor>(std::shared_ptr<Tensor>(), tensor));
+        }
+        owned_.assign(initial.size(), false);
+        spare_.resize(initial.size());
+    }
+    
+    size_t Size() const { return current_.size(); }
+    Tensor* Get(size_t j) const { return current_[j].get(); }
+    
+    void PlaceBuffers(const SubgraphExecutor& body, ExecutionState* state, size_t first_output) const {
+        for (size_t j = 0; j < spare_.size(); ++j) {
+            body.PlaceOutputBuffer(state, first_output + j, spare_[j]);
+        }
+    }
+    
+    // 取出本次迭代的结果作为下一次的输入；旧的输入不再被任何新结果引用（直通）时成为空闲缓冲
+    void Update(const SubgraphExecutor& body, ExecutionState* state, size_t first_output) {
+        std::vector<std::shared_ptr<Tensor>> next(current_.size());
+        std::vector<bool> next_owned(current_.size(), false);
+        for (size_t j = 0; j < next.size(); ++j) {
+            bool owned = false;
+            next[j] = body.TakeOutput(state, first_output + j, &owned);
+            next_owned[j] = owned;
+        }
+        for (size_t j = 0; j < current_.size(); ++j) {
+            bool referenced = false;
+            for (const auto& tensor : next) {
+                referenced = referenced || tensor.get() == current_[j].get();
+            }
+            if (owned_[j] && !referenced) {
+                spare_[j] = std::move(current_[j]);
+            }
+        }
+        current_ = std::move(next);
+        owned_ = std::move(next_owned);
+    }
+    
+    Status AssignTo(const std::vector<Tensor*>& outputs) const {
+        for (size_t j = 0; j < current_.size(); ++j) {
+            if (!current_[j]) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Loop-carried value was not produced");
+            }
+            Status status = AssignOutput(current_[j], owned_[j], outputs[j]);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::vector<std::shared_ptr<Tensor>> current_;
+    std::vector<bool> owned_;
+    std::vector<std::shared_ptr<Tensor>> spare_;
+};
+
+// 控制流算子的公共部分：输出形状只有执行后才知道
+class ControlFlowOperator : public Operator {
+public:
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        (void)inputs;
+        (void)output_shapes;
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           GetName() + " output shapes depend on runtime data");
+    }
+    
+    // 加载期的形状推断不报错，输出留作未知
+    Status InferOutputInfo(const std::vector<TensorInfo>& inputs,
+                           std::vector<TensorInfo>& outputs) const override {
+        (void)inputs;
+        outputs.clear();
+        return Status::Ok();
+    }
+
+protected:
+    size_t GetNumImplicitInputs() const {
+        return static_cast<size_t>(std::max<int64_t>(GetIntAttribute("num_implicit_inputs", 0), 0));
+    }
+};
+
+} // anonymous namespace
+
+// If：按cond执行then_branch或else_branch，分支的输出即算子的输出
+class IfOperator : public ControlFlowOperator {
+public:
+    std::string GetName() const override { return "If"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 1 + GetNumImplicitInputs()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "If expects a condition input");
+        }
+        int64_t cond = 0;
+        if (!ReadScalar(inputs[0], &cond)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "If condition must be a scalar");
+        }
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        int64_t cond = 0;
+        ReadScalar(inputs[0], &cond);
+        SubgraphExecutor& branch = cond ? then_branch_ : else_branch_;
+        status = branch.Prepare(GetGraphAttribute(cond ? "then_branch" : "else_branch"));
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (branch.GetNumInputs() != inputs.size() - 1 || branch.GetNumOutputs() != outputs.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "If branch does not match the node signature");
+        }
+    
+        StateLease state(branch);
+        status = state.Acquire();
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::vector<Tensor*> branch_inputs(inputs.begin() + 1, inputs.end());
+        status = branch.Run(state.Get(), branch_inputs, ctx);
+        for (size_t i = 0; status.IsOk() && i < outputs.size(); ++i) {
+            bool owned = false;
+            std::shared_ptr<Tensor> result = branch.TakeOutput(state.Get(), i, &owned);
+            status = result ? AssignOutput(result, owned, outputs[i])
+                            : Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "If branch output was not produced");
+        }
+        return status;
+    }
+
+private:
+    SubgraphExecutor then_branch_;
+    SubgraphExecutor else_branch_;
+};
+
+// Loop：body的输入为(迭代号, cond, v...)，输出为(cond, v..., scan...)；
+// 算子输入为(M?, cond?, v_initial...)，M与cond可省略（位置见input_slots），输出为(v_final..., scan...)，
+// 各次迭代的scan输出沿新的第0维拼接
+class LoopOperator : public ControlFlowOperator {
+public:
+    std::string GetName() const override { return "Loop"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < GetNumImplicitInputs()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Loop is missing implicit inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        // 按在ONNX中的位置区分M、cond与循环变量
+        const size_t num_formal = inputs.size() - GetNumImplicitInputs();
+        const std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        const Tensor* max_trip_input = nullptr;
+        const Tensor* cond_input = nullptr;
+        std::vector<Tensor*> initial;
+        for (size_t i = 0; i < num_formal; ++i) {
+            const int64_t position = i < slots.size() ? slots[i] : static_cast<int64_t>(i);
+            if (position == 0) {
+                max_trip_input = inputs[i];
+            } else if (position == 1) {
+                cond_input = inputs[i];
+            } else {
+                initial.push_back(inputs[i]);
+            }
+        }
+        int64_t max_trips = std::numeric_limits<int64_t>::max();
+        int64_t cond = 1;
+        if ((max_trip_input && !ReadScalar(max_trip_input, &max_trips)) ||
+            (cond_input && !ReadScalar(cond_input, &cond))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Loop M and cond must be scalars");
+        }
+    
+        status = body_.Prepare(GetGraphAttribute("body"));
+        if (!status.IsOk()) {
+            return status;
+        }
+        const size_t num_carried = initial.size();
+        if (body_.GetNumInputs() != 2 + num_carried + GetNumImplicitInputs() ||
+            body_.GetNumOutputs() != 1 + outputs.size() || outputs.size() < num_carried) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Loop body does not match the node signature");
+        }
+        const size_t num_scan = outputs.size() - num_carried;
+    
+        StateLease state(body_);
+        status = state.Acquire();
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Shape scalar{std::vector<int64_t>()};
+        std::shared_ptr<Tensor> iteration = CreateTensor(scalar, DataType::INT64);
+        std::shared_ptr<Tensor> condition = CreateTensor(scalar, DataType::BOOL);
+        std::vector<Tensor*> body_inputs(body_.GetNumInputs());
+        body_inputs[0] = iteration.get();
+        body_inputs[1] = condition.get();
+        std::copy(inputs.begin() + num_formal, inputs.end(), body_inputs.begin() + 2 + num_carried);
+        CarriedTensors carried(initial);
+        std::vector<std::vector<std::shared_ptr<Tensor>>> scans(num_scan);
+    
+        for (int64_t i = 0; i < max_trips && cond; ++i) {
+            *static_cast<int64_t*>(iteration->GetData()) = i;
+            *static_cast<uint8_t*>(condition->GetData()) = 1;
+            for (size_t j = 0; j < num_carried; ++j) {
+                body_inputs[2 + j] = carried.Get(j);
+            }
+            carried.PlaceBuffers(body_, state.Get(), 1);
+            status = body_.Run(state.Get(), body_inputs, ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+            // 没有给出cond输入时是计数循环，忽略body输出的条件
+            if (cond_input && !ReadScalar(body_.GetOutput(state.Get(), 0).get(), &cond)) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Loop body condition must be a scalar");
+            }
+            carried.Update(body_, state.Get(), 1);
+            for (size_t k = 0; k < num_scan; ++k) {
+                bool owned = false;
+                std::shared_ptr<Tensor> result = body_.TakeOutput(state.Get(), 1 + num_carried + k, &owned);
+                if (!result) {
+                    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Loop scan output was not produced");
+                }
+                // 共享的结果可能是下一次迭代会被改写的携带缓冲
+                if (!owned) {
+                    std::shared_ptr<Tensor> copy = CreateTensor(Shape(result->GetShape().dims),
+                                                                result->GetDataType());
+                    status = result->CopyTo(*copy);
+                    if (!status.IsOk()) {
+                        return status;
+                    }
+                    result = std::move(copy);
+                }
+                scans[k].push_back(std::move(result));
+            }
+        }
+    
+        status = carried.AssignTo(outputs);
+        for (size_t k = 0; status.IsOk() && k < num_scan; ++k) {
+            status = StackScanOutput(scans[k], outputs[num_carried + k]);
+        }
+        return status;
+    }
+
+private:
+    static Status StackScanOutput(const std::vector<std::shared_ptr<Tensor>>& slices, Tensor* output) {
+        if (slices.empty()) {
+            *output = Tensor(Shape(std::vector<int64_t>{0}), output->GetDataType());
+            return Status::Ok();
+        }
+        const Shape& slice_shape = slices[0]->GetShape();
+        std::vector<int64_t> dims = slice_shape.dims;
+        dims.insert(dims.begin(), static_cast<int64_t>(slices.size()));
+        *output = Tensor(Shape(dims), slices[0]->GetDataType());
+        const size_t bytes = slices[0]->GetSizeInBytes();
+        uint8_t* dst = static_cast<uint8_t*>(output->GetData());
+        for (const auto& slice : slices) {
+            if (slice->GetShape().dims != slice_shape.dims || slice->GetDataType() != output->GetDataType()) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                   "Loop scan output shape changes between iterations");
+            }
+            std::memcpy(dst, slice->GetData(), bytes);
+            dst += bytes;
+        }
+        return Status::Ok();
+    }
+    
+    SubgraphExecutor body_;
+};
+
+// Scan（opset 9+）：算子输入为(状态初值..., 扫描输入...)，扫描输入的个数由num_scan_inputs给出；
+// body的输入为(状态..., 各扫描输入的一个切片...)，输出为(状态..., 扫描输出的切片...)。
+// 只支持沿第0维扫描（scan_input_axes/scan_output_axes为0），方向可以反转
+class ScanOperator : public ControlFlowOperator {
+public:
+    std::string GetName() const override { return "Scan"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        const int64_t num_scan_inputs = GetIntAttribute("num_scan_inputs", 0);
+        if (num_scan_inputs <= 0 || inputs.size() < GetNumImplicitInputs() + static_cast<size_t>(num_scan_inputs)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Scan requires num_scan_inputs scan inputs");
+        }
+        for (int64_t axis : GetIntsAttribute("scan_input_axes", {})) {
+            if (axis != 0) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Scan only supports scan_input_axes = 0");
+            }
+        }
+        for (int64_t axis : GetIntsAttribute("scan_output_axes", {})) {
+            if (axis != 0) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Scan only supports scan_output_axes = 0");
+            }
+        }
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const size_t num_implicit = GetNumImplicitInputs();
+        const size_t num_scan_inputs = static_cast<size_t>(GetIntAttribute("num_scan_inputs", 0));
+        const size_t num_state = inputs.size() - num_implicit - num_scan_inputs;
+        status = body_.Prepare(GetGraphAttribute("body"));
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (body_.GetNumInputs() != inputs.size() || body_.GetNumOutputs() != outputs.size() ||
+            outputs.size() < num_state) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Scan body does not match the node signature");
+        }
+        const size_t num_scan_outputs = outputs.size() - num_state;
+        const std::vector<int64_t> input_directions = GetIntsAttribute("scan_input_directions", {});
+        const std::vector<int64_t> output_directions = GetIntsAttribute("scan_output_directions", {});
+    
+        // 各扫描输入的切片是指向原数据的视图，每次迭代只移动数据指针
+        int64_t length = -1;
+        std::vector<std::unique_ptr<Tensor>> slices;
+        std::vector<size_t> slice_bytes;
+        for (size_t m = 0; m < num_scan_inputs; ++m) {
+            const Tensor* input = inputs[num_state + m];
+            const std::vector<int64_t>& dims = input->GetShape().dims;
+            if (dims.empty() || !input->GetData() || (length >= 0 && dims[0] != length)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Scan inputs must share the length of axis 0");
+            }
+            length = dims[0];
+            const Shape slice_shape(std::vector<int64_t>(dims.begin() + 1, dims.end()));
+            slices.push_back(std::make_unique<Tensor>(slice_shape, input->GetDataType(), nullptr));
+            slice_bytes.push_back(slices.back()->GetSizeInBytes());
+        }
+    
+        StateLease state(body_);
+        status = state.Acquire();
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<Tensor*> body_inputs(inputs.begin(), inputs.end());
+        for (size_t m = 0; m < num_scan_inputs; ++m) {
+            body_inputs[num_state + m] = slices[m].get();
+        }
+        CarriedTensors carried(std::vector<Tensor*>(inputs.begin(), inputs.begin() + num_state));
+    
+        for (int64_t t = 0; t < length; ++t) {
+            for (size_t m = 0; m < num_scan_inputs; ++m) {
+                const bool reverse = m < input_directions.size() && input_directions[m] != 0;
+                const int64_t index = reverse ? length - 1 - t : t;
+                uint8_t* base = static_cast<uint8_t*>(inputs[num_state + m]->GetData());
+                slices[m]->SetData(base + static_cast<size_t>(index) * slice_bytes[m], false);
+            }
+            for (size_t j = 0; j < num_state; ++j) {
+                body_inputs[j] = carried.Get(j);
+            }
+            carried.PlaceBuffers(body_, state.Get(), 0);
+            // 第一次迭代之后输出的形状已知：扫描输出的切片直接绑定为算子输出中对应位置的视图
+            for (size_t k = 0; t > 0 && k < num_scan_outputs; ++k) {
+                if (!body_.IsMovable(num_state + k)) {
+                    continue;
+                }
+                state.Get()->BindOutput(body_.GetOutputSlot(num_state + k),
+                                        OutputSlice(outputs[num_state + k], k, t, length, output_directions));
+            }
+            status = body_.Run(state.Get(), body_inputs, ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+            carried.Update(body_, state.Get(), 0);
+            for (size_t k = 0; k < num_scan_outputs; ++k) {
+                const std::shared_ptr<Tensor>& result = body_.GetOutput(state.Get(), num_state + k);
+                if (t > 0 && !result) {
+                    continue;  // 已写进绑定的视图
+                }
+                if (!result) {
+                    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Scan output was not produced");
+                }
+                if (t == 0) {
+                    std::vector<int64_t> dims = result->GetShape().dims;
+                    dims.insert(dims.begin(), length);
+                    *outputs[num_state + k] = Tensor(Shape(dims), result->GetDataType());
+                }
+                std::shared_ptr<Tensor> slice = OutputSlice(outputs[num_state + k], k, t, length, output_directions);
+                if (slice->GetShape().dims != result->GetShape().dims) {
+                    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                       "Scan output shape changes between iterations");
+                }
+                status = result->CopyTo(*slice);
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+            state.Get()->ClearBoundOutputs();
+        }
+    
+        status = carried.AssignTo(outputs);
+        for (size_t k = 0; status.IsOk() && length <= 0 && k < num_scan_outputs; ++k) {
+            *outputs[num_state + k] = Tensor(Shape(std::vector<int64_t>{0}), outputs[num_state + k]->GetDataType());
+        }
+        return status;
+    }
+
+private:
+    // 扫描输出中第t次迭代的切片（按方向决定位置）
+    static std::shared_ptr<Tensor> OutputSlice(Tensor* output, size_t k, int64_t t, int64_t length,
+                                               const std::vector<int64_t>& directions) {
+        const bool reverse = k < directions.size() && directions[k] != 0;
+        const int64_t index = reverse ? length - 1 - t : t;
+        const std::vector<int64_t>& dims = output->GetShape().dims;
+        const Shape slice_shape(std::vector<int64_t>(dims.begin() + 1, dims.end()));
+        const size_t bytes = output->GetSizeInBytes() / static_cast<size_t>(length);
+        return CreateTensorFromData(slice_shape, output->GetDataType(),
+                                    static_cast<uint8_t*>(output->GetData()) + static_cast<size_t>(index) * bytes);
+    }
+    
+    SubgraphExecutor body_;
+};
+
+REGISTER_OPERATOR("If", IfOperator);
+REGISTER_OPERATOR("Loop", LoopOperator);
+REGISTER_OPERATOR("Scan", ScanOperator);
+
+} // namespace operators
+} // namespace inferunity
@@ -1,8 +1,9 @@
 // Conv算子实现
-// 参考NCNN的卷积实现，但简化版本
+// 参考NCNN的卷积实现：按形状选择im2col+GEMM/1x1/Winograd/深度可分离路径（见conv_kernels.h）
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "conv_kernels.h"
 #include <algorithm>
 #include <cmath>
 #include <cstring>
@@ -34,46 +35,38 @@ public:
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        if (inputs.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
-        }
-        
-        const Shape& input_shape = inputs[0]->GetShape();
-        if (input_shape.dims.size() < 4) {
+        if (inputs.size() < 2) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Conv input must be 4D (NCHW)");
+                               "Conv requires at least 2 inputs (input and weight)");
         }
         
-        // 获取属性
-        int64_t kernel_h = 3, kernel_w = 3;
-        int64_t stride_h = 1, stride_w = 1;
-        int64_t pad_h = 0, pad_w = 0;
-        int64_t dilation_h = 1, dilation_w = 1;
-        
-        // 解析属性（从Node获取，这里简化处理）
-        // 实际应该从Node的attributes获取
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        
-        if (inputs.size() >= 2) {
-            const Shape& weight_shape = inputs[1]->GetShape();
-            if (weight_shape.dims.size() >= 2) {
-                kernel_h = weight_shape.dims[2];
-                kernel_w = weight_shape.dims[3];
-            }
+        // 按strides/pads/dilations/group属性计算输出尺寸
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, inputs[0]->GetShape(),
+                                          inputs[1]->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
         }
         
-        // 计算输出尺寸
-        int64_t out_h = (in_h + 2 * pad_h - dilation_h * (kernel_h - 1) - 1) / stride_h + 1;
-        int64_t out_w = (in_w + 2 * pad_w - dilation_w * (kernel_w - 1) - 1) / stride_w + 1;
-        int64_t out_c = inputs.size() >= 2 ? inputs[1]->GetShape().dims[0] : input_shape.dims[1];
-        
-        output_shapes.push_back(Shape({batch, out_c, out_h, out_w}));
+        output_shapes.push_back(Shape({params.batch, params.out_c, params.out_h, params.out_w}));
         return Status::Ok();
     }
     
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        return EstimateConvCost(inputs, outputs, 1, inputs.size() > 2 ? 1.0 : 0.0);
+    }
+    
+    // 权重（输入1）为常量初始化器时，会话加载时完成Winograd变换/GEMM打包
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        return PrePackConvWeight(*this, &kernel_, input_index, tensor, input_shapes, is_packed);
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateConvMemory(*this, inputs);
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
@@ -86,66 +79,39 @@ public:
         Tensor* bias = inputs.size() > 2 ? inputs[2] : nullptr;
         Tensor* output = outputs[0];
         
-        const Shape& input_shape = input->GetShape();
-        const Shape& weight_shape = weight->GetShape();
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, input->GetShape(), weight->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
         const Shape& output_shape = output->GetShape();
+        if (output_shape.dims.size() != 4 || output_shape.dims[0] != params.batch ||
+            output_shape.dims[1] != params.out_c || output_shape.dims[2] != params.out_h ||
+            output_shape.dims[3] != params.out_w) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Conv output shape does not match attributes");
+        }
         
-        // 简化的卷积实现（参考NCNN，但更基础）
-        // 实际应该使用im2col + GEMM或直接卷积
-        int64_t batch = input_shape.dims[0];
-        int64_t in_c = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        int64_t out_c = output_shape.dims[1];
-        int64_t out_h = output_shape.dims[2];
-        int64_t out_w = output_shape.dims[3];
-        int64_t kernel_h = weight_shape.dims[2];
-        int64_t kernel_w = weight_shape.dims[3];
-        
-        // 获取属性
-        int64_t stride_h = 1, stride_w = 1;
-        int64_t pad_h = 0, pad_w = 0;
-        int64_t dilation_h = 1, dilation_w = 1;
-        
-        float* input_data = static_cast<float*>(input->GetData());
-        float* weight_data = static_cast<float*>(weight->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        float* bias_data = bias ? static_cast<float*>(bias->GetData()) : nullptr;
-        
-        // 初始化输出
-        std::memset(output_data, 0, output->GetSizeInBytes());
+        const float* weight_data = static_cast<const float*>(weight->GetData());
         
-        // 简化的卷积计算（参考NCNN的基础实现）
-        for (int64_t n = 0; n < batch; ++n) {
-            for (int64_t oc = 0; oc < out_c; ++oc) {
-                for (int64_t oh = 0; oh < out_h; ++oh) {
-                    for (int64_t ow = 0; ow < out_w; ++ow) {
-                        float sum = bias_data ? bias_data[oc] : 0.0f;
-                        
-                        for (int64_t ic = 0; ic < in_c; ++ic) {
-                            for (int64_t kh = 0; kh < kernel_h; ++kh) {
-                                for (int64_t kw = 0; kw < kernel_w; ++kw) {
-                                    int64_t ih = oh * stride_h + kh * dilation_h - pad_h;
-                                    int64_t iw = ow * stride_w + kw * dilation_w - pad_w;
-                                    
-                                    if (ih >= 0 && ih < in_h && iw >= 0 && iw < in_w) {
-                                        int64_t input_idx = ((n * in_c + ic) * in_h + ih) * in_w + iw;
-                                        int64_t weight_idx = ((oc * in_c + ic) * kernel_h + kh) * kernel_w + kw;
-                                        sum += input_data[input_idx] * weight_data[weight_idx];
-                                    }
-                                }
-                            }
-                        }
-                        
-                        int64_t output_idx = ((n * out_c + oc) * out_h + oh) * out_w + ow;
-                        output_data[output_idx] = sum;
-                    }
-                }
-            }
+        // 算法选择与权重变换只在形状/权重第一次出现时进行（计划按形状缓存在节点的算子实例中）
+        // 可通过conv_algorithm属性强制指定：im2col/pointwise/winograd_f23/winograd_f43/depthwise
+        ConvAlgorithm requested = ParseConvAlgorithm(GetStringAttribute("conv_algorithm", "auto"));
+        std::shared_ptr<const ConvPlan> plan;
+        status = kernel_.Prepare(params, requested, weight_data, &plan);
+        if (!status.IsOk()) {
+            return status;
         }
         
+        ConvEpilogue epilogue;
+        epilogue.bias = bias ? static_cast<const float*>(bias->GetData()) : nullptr;
+        Conv2DKernel::Run(*plan, static_cast<const float*>(input->GetData()), weight_data,
+                          static_cast<float*>(output->GetData()), epilogue, ctx);
         return Status::Ok();
     }
+
+private:
+    Conv2DKernel kernel_;
 };
 
 REGISTER_OPERATOR("Conv", ConvOperator);
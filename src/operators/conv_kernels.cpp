@@ -0,0 +1,873 @@
+// 卷积计算引擎实现
+// im2col+GEMM参考Caffe/NCNN，Winograd变换矩阵取自Lavin & Gray (2015)
+
+#include "conv_kernels.h"
+#include "gemm.h"
+#include "parallel_utils.h"
+#include "prepacked_weights.h"
+#include "simd_utils.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace inferunity {
+namespace operators {
+
+bool Conv2DParams::operator==(const Conv2DParams& o) const {
+    return batch == o.batch && in_c == o.in_c && in_h == o.in_h && in_w == o.in_w &&
+           out_c == o.out_c && out_h == o.out_h && out_w == o.out_w &&
+           kernel_h == o.kernel_h && kernel_w == o.kernel_w &&
+           stride_h == o.stride_h && stride_w == o.stride_w &&
+           pad_top == o.pad_top && pad_left == o.pad_left &&
+           pad_bottom == o.pad_bottom && pad_right == o.pad_right &&
+           dilation_h == o.dilation_h && dilation_w == o.dilation_w &&
+           group == o.group;
+}
+
+namespace {
+
+// 二元属性（strides/dilations）：支持1个或2个值
+bool GetPair(const Operator& op, const std::string& key, int64_t default_value,
+             int64_t* h, int64_t* w) {
+    std::vector<int64_t> values = op.GetIntsAttribute(key);
+    if (values.empty()) {
+        *h = *w = default_value;
+    } else if (values.size() == 1) {
+        *h = *w = values[0];
+    } else if (values.size() == 2) {
+        *h = values[0];
+        *w = values[1];
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// SAME模式的padding（参考ONNX auto_pad语义）
+void ComputeSamePadding(int64_t in, int64_t stride, int64_t kernel, int64_t dilation,
+                        bool upper, int64_t* pad_begin, int64_t* pad_end) {
+    int64_t out = (in + stride - 1) / stride;
+    int64_t effective_kernel = dilation * (kernel - 1) + 1;
+    int64_t total = std::max<int64_t>(0, (out - 1) * stride + effective_kernel - in);
+    *pad_begin = upper ? total / 2 : total - total / 2;
+    *pad_end = total - *pad_begin;
+}
+
+} // anonymous namespace
+
+Status ParseConv2DParams(const Operator& op, const Shape& input_shape,
+                         const Shape& weight_shape, Conv2DParams* params) {
+    if (input_shape.dims.size() != 4) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv input must be 4D (NCHW)");
+    }
+    if (weight_shape.dims.size() != 4) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv weight must be 4D (OIHW)");
+    }
+    
+    Conv2DParams p;
+    p.batch = input_shape.dims[0];
+    p.in_c = input_shape.dims[1];
+    p.in_h = input_shape.dims[2];
+    p.in_w = input_shape.dims[3];
+    p.out_c = weight_shape.dims[0];
+    p.kernel_h = weight_shape.dims[2];
+    p.kernel_w = weight_shape.dims[3];
+    p.group = op.GetIntAttribute("group", 1);
+    
+    if (!GetPair(op, "strides", 1, &p.stride_h, &p.stride_w) ||
+        !GetPair(op, "dilations", 1, &p.dilation_h, &p.dilation_w)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv strides/dilations must have 1 or 2 values");
+    }
+    if (p.stride_h <= 0 || p.stride_w <= 0 || p.dilation_h <= 0 || p.dilation_w <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv strides/dilations must be positive");
+    }
+    if (p.group <= 0 || p.in_c != weight_shape.dims[1] * p.group || p.out_c % p.group != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv channel count does not match weight shape and group");
+    }
+    
+    std::string auto_pad = op.GetStringAttribute("auto_pad", "NOTSET");
+    if (auto_pad == "SAME_UPPER" || auto_pad == "SAME_LOWER") {
+        bool upper = auto_pad == "SAME_UPPER";
+        ComputeSamePadding(p.in_h, p.stride_h, p.kernel_h, p.dilation_h, upper,
+                           &p.pad_top, &p.pad_bottom);
+        ComputeSamePadding(p.in_w, p.stride_w, p.kernel_w, p.dilation_w, upper,
+                           &p.pad_left, &p.pad_right);
+    } else if (auto_pad != "VALID") {
+        // ONNX pads格式：[top, left, bottom, right]，也接受[h, w]或单值
+        std::vector<int64_t> pads = op.GetIntsAttribute("pads");
+        if (pads.size() == 4) {
+            p.pad_top = pads[0];
+            p.pad_left = pads[1];
+            p.pad_bottom = pads[2];
+            p.pad_right = pads[3];
+        } else if (pads.size() == 2) {
+            p.pad_top = p.pad_bottom = pads[0];
+            p.pad_left = p.pad_right = pads[1];
+        } else if (pads.size() == 1) {
+            p.pad_top = p.pad_bottom = p.pad_left = p.pad_right = pads[0];
+        } else if (!pads.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Conv pads must have 1, 2 or 4 values");
+        }
+    }
+    
+    int64_t effective_kh = p.dilation_h * (p.kernel_h - 1) + 1;
+    int64_t effective_kw = p.dilation_w * (p.kernel_w - 1) + 1;
+    p.out_h = (p.in_h + p.pad_top + p.pad_bottom - effective_kh) / p.stride_h + 1;
+    p.out_w = (p.in_w + p.pad_left + p.pad_right - effective_kw) / p.stride_w + 1;
+    if (p.out_h <= 0 || p.out_w <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Conv output size is not positive");
+    }
+    
+    *params = p;
+    return Status::Ok();
+}
+
+const char* ConvAlgorithmName(ConvAlgorithm algorithm) {
+    switch (algorithm) {
+        case ConvAlgorithm::AUTO: return "auto";
+        case ConvAlgorithm::IM2COL_GEMM: return "im2col";
+        case ConvAlgorithm::POINTWISE: return "pointwise";
+        case ConvAlgorithm::WINOGRAD_F23: return "winograd_f23";
+        case ConvAlgorithm::WINOGRAD_F43: return "winograd_f43";
+        case ConvAlgorithm::DEPTHWISE: return "depthwise";
+    }
+    return "auto";
+}
+
+ConvAlgorithm ParseConvAlgorithm(const std::string& name) {
+    if (name == "im2col") return ConvAlgorithm::IM2COL_GEMM;
+    if (name == "pointwise") return ConvAlgorithm::POINTWISE;
+    if (name == "winograd_f23") return ConvAlgorithm::WINOGRAD_F23;
+    if (name == "winograd_f43" || name == "winograd") return ConvAlgorithm::WINOGRAD_F43;
+    if (name == "depthwise") return ConvAlgorithm::DEPTHWISE;
+    return ConvAlgorithm::AUTO;
+}
+
+bool IsConvAlgorithmApplicable(ConvAlgorithm algorithm, const Conv2DParams& p) {
+    switch (algorithm) {
+        case ConvAlgorithm::AUTO:
+        case ConvAlgorithm::IM2COL_GEMM:
+            return true;
+        case ConvAlgorithm::POINTWISE:
+            return p.kernel_h == 1 && p.kernel_w == 1 &&
+                   p.stride_h == 1 && p.stride_w == 1 &&
+                   p.pad_top == 0 && p.pad_left == 0 && p.pad_bottom == 0 && p.pad_right == 0;
+        case ConvAlgorithm::WINOGRAD_F23:
+        case ConvAlgorithm::WINOGRAD_F43:
+            return p.kernel_h == 3 && p.kernel_w == 3 &&
+                   p.stride_h == 1 && p.stride_w == 1 &&
+                   p.dilation_h == 1 && p.dilation_w == 1 && p.group == 1;
+        case ConvAlgorithm::DEPTHWISE:
+            return p.group == p.in_c && p.out_c % p.in_c == 0;
+    }
+    return false;
+}
+
+ConvAlgorithm SelectConvAlgorithm(const Conv2DParams& p, ConvAlgorithm requested) {
+    if (requested != ConvAlgorithm::AUTO && IsConvAlgorithmApplicable(requested, p)) {
+        return requested;
+    }
+    if (p.group > 1 && IsConvAlgorithmApplicable(ConvAlgorithm::DEPTHWISE, p)) {
+        return ConvAlgorithm::DEPTHWISE;
+    }
+    if (IsConvAlgorithmApplicable(ConvAlgorithm::POINTWISE, p)) {
+        return ConvAlgorithm::POINTWISE;
+    }
+    // Winograd的变换开销在通道数较少时无法摊薄
+    if (IsConvAlgorithmApplicable(ConvAlgorithm::WINOGRAD_F23, p) &&
+        p.in_c >= 8 && p.out_c >= 8 && p.out_h >= 4 && p.out_w >= 4) {
+        return (p.out_h >= 16 && p.out_w >= 16) ? ConvAlgorithm::WINOGRAD_F43
+                                                : ConvAlgorithm::WINOGRAD_F23;
+    }
+    return ConvAlgorithm::IM2COL_GEMM;
+}
+
+ConvAlgorithm ConvPackingFormat(ConvAlgorithm algorithm) {
+    switch (algorithm) {
+        case ConvAlgorithm::WINOGRAD_F23:
+        case ConvAlgorithm::WINOGRAD_F43:
+            return algorithm;
+        case ConvAlgorithm::IM2COL_GEMM:
+        case ConvAlgorithm::POINTWISE:
+            return gemm::UsesExternalBlas() ? ConvAlgorithm::AUTO : ConvAlgorithm::IM2COL_GEMM;
+        default:
+            return ConvAlgorithm::AUTO;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Winograd变换
+// ---------------------------------------------------------------------------
+namespace {
+
+// F(2,3)：alpha = 4
+constexpr float kBT23[4][4] = {
+    {1.0f,  0.0f, -1.0f,  0.0f},
+    {0.0f,  1.0f,  1.0f,  0.0f},
+    {0.0f, -1.0f,  1.0f,  0.0f},
+    {0.0f,  1.0f,  0.0f, -1.0f}};
+constexpr float kG23[4][3] = {
+    {1.0f,  0.0f, 0.0f},
+    {0.5f,  0.5f, 0.5f},
+    {0.5f, -0.5f, 0.5f},
+    {0.0f,  0.0f, 1.0f}};
+constexpr float kAT23[2][4] = {
+    {1.0f, 1.0f,  1.0f,  0.0f},
+    {0.0f, 1.0f, -1.0f, -1.0f}};
+
+// F(4,3)：alpha = 6
+constexpr float kBT43[6][6] = {
+    {4.0f,  0.0f, -5.0f,  0.0f, 1.0f, 0.0f},
+    {0.0f, -4.0f, -4.0f,  1.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f, -4.0f, -1.0f, 1.0f, 0.0f},
+    {0.0f, -2.0f, -1.0f,  2.0f, 1.0f, 0.0f},
+    {0.0f,  2.0f, -1.0f, -2.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f,  0.0f, -5.0f, 0.0f, 1.0f}};
+constexpr float kG43[6][3] = {
+    { 1.0f / 4,   0.0f,       0.0f},
+    {-1.0f / 6,  -1.0f / 6,  -1.0f / 6},
+    {-1.0f / 6,   1.0f / 6,  -1.0f / 6},
+    { 1.0f / 24,  1.0f / 12,  1.0f / 6},
+    { 1.0f / 24, -1.0f / 12,  1.0f / 6},
+    { 0.0f,       0.0f,       1.0f}};
+constexpr float kAT43[4][6] = {
+    {1.0f, 1.0f,  1.0f, 1.0f,  1.0f, 0.0f},
+    {0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.0f},
+    {0.0f, 1.0f,  1.0f, 4.0f,  4.0f, 0.0f},
+    {0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 1.0f}};
+
+template <int M> struct WinogradMatrices;
+template <> struct WinogradMatrices<2> {
+    static constexpr int kAlpha = 4;
+    static const float (&BT())[4][4] { return kBT23; }
+    static const float (&G())[4][3] { return kG23; }
+    static const float (&AT())[2][4] { return kAT23; }
+};
+template <> struct WinogradMatrices<4> {
+    static constexpr int kAlpha = 6;
+    static const float (&BT())[6][6] { return kBT43; }
+    static const float (&G())[6][3] { return kG43; }
+    static const float (&AT())[4][6] { return kAT43; }
+};
+
+// U = G * g * G^T，结果写入 U[pos * stride]
+template <int M>
+void TransformWeightTile(const float* g, float* U, int64_t stride) {
+    constexpr int A = WinogradMatrices<M>::kAlpha;
+    const auto& Gm = WinogradMatrices<M>::G();
+    float tmp[A][3];
+    for (int i = 0; i < A; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            tmp[i][j] = Gm[i][0] * g[j] + Gm[i][1] * g[3 + j] + Gm[i][2] * g[6 + j];
+        }
+    }
+    for (int i = 0; i < A; ++i) {
+        for (int j = 0; j < A; ++j) {
+            U[(i * A + j) * stride] = tmp[i][0] * Gm[j][0] + tmp[i][1] * Gm[j][1] + tmp[i][2] * Gm[j][2];
+        }
+    }
+}
+
+// V = B^T * d * B，结果写入 V[pos * stride]
+template <int M>
+void TransformInputTile(const float (&d)[WinogradMatrices<M>::kAlpha][WinogradMatrices<M>::kAlpha],
+                        float* V, int64_t stride) {
+    constexpr int A = WinogradMatrices<M>::kAlpha;
+    const auto& BT = WinogradMatrices<M>::BT();
+    float tmp[A][A];
+    for (int i = 0; i < A; ++i) {
+        for (int j = 0; j < A; ++j) {
+            float sum = 0.0f;
+            for (int k = 0; k < A; ++k) {
+                sum += BT[i][k] * d[k][j];
+            }
+            tmp[i][j] = sum;
+        }
+    }
+    for (int i = 0; i < A; ++i) {
+        for (int j = 0; j < A; ++j) {
+            float sum = 0.0f;
+            for (int k = 0; k < A; ++k) {
+                sum += tmp[i][k] * BT[j][k];
+            }
+            V[(i * A + j) * stride] = sum;
+        }
+    }
+}
+
+// Y = A^T * m * A
+template <int M>
+void TransformOutputTile(const float* m, int64_t stride, float (&Y)[M][M]) {
+    constexpr int A = WinogradMatrices<M>::kAlpha;
+    const auto& AT = WinogradMatrices<M>::AT();
+    float tmp[M][A];
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < A; ++j) {
+            float sum = 0.0f;
+            for (int k = 0; k < A; ++k) {
+                sum += AT[i][k] * m[(k * A + j) * stride];
+            }
+            tmp[i][j] = sum;
+        }
+    }
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < M; ++j) {
+            float sum = 0.0f;
+            for (int k = 0; k < A; ++k) {
+                sum += tmp[i][k] * AT[j][k];
+            }
+            Y[i][j] = sum;
+        }
+    }
+}
+
+// 每批处理的tile数：控制Winograd工作区大小
+constexpr int64_t kWinogradTileBlock = 128;
+
+template <int M>
+void WinogradConv(const Conv2DParams& p, const float* input, const float* U,
+                  float* V, float* Mbuf, float* output) {
+    constexpr int A = WinogradMatrices<M>::kAlpha;
+    constexpr int A2 = A * A;
+    const int64_t tiles_h = (p.out_h + M - 1) / M;
+    const int64_t tiles_w = (p.out_w + M - 1) / M;
+    const int64_t tiles = tiles_h * tiles_w;
+    
+    for (int64_t n = 0; n < p.batch; ++n) {
+        const float* in_n = input + n * p.in_c * p.in_h * p.in_w;
+        float* out_n = output + n * p.out_c * p.out_h * p.out_w;
+        
+        for (int64_t t0 = 0; t0 < tiles; t0 += kWinogradTileBlock) {
+            const int64_t nt = std::min(kWinogradTileBlock, tiles - t0);
+            
+            // 1. 输入变换：V[pos][ic][t]
+            for (int64_t ic = 0; ic < p.in_c; ++ic) {
+                const float* in_ch = in_n + ic * p.in_h * p.in_w;
+                for (int64_t t = 0; t < nt; ++t) {
+                    int64_t th = (t0 + t) / tiles_w;
+                    int64_t tw = (t0 + t) % tiles_w;
+                    int64_t ih0 = th * M - p.pad_top;
+                    int64_t iw0 = tw * M - p.pad_left;
+                    float d[A][A];
+                    for (int i = 0; i < A; ++i) {
+                        int64_t ih = ih0 + i;
+                        for (int j = 0; j < A; ++j) {
+                            int64_t iw = iw0 + j;
+                            d[i][j] = (ih >= 0 && ih < p.in_h && iw >= 0 && iw < p.in_w)
+                                          ? in_ch[ih * p.in_w + iw] : 0.0f;
+                        }
+                    }
+                    TransformInputTile<M>(d, V + ic * nt + t, p.in_c * nt);
+                }
+            }
+            
+            // 2. 逐频点GEMM：M[pos] = U[pos] (out_c x in_c) * V[pos] (in_c x nt)
+            for (int pos = 0; pos < A2; ++pos) {
+                gemm::Sgemm(false, false, p.out_c, nt, p.in_c, 1.0f,
+                            U + pos * p.out_c * p.in_c, p.in_c,
+                            V + pos * p.in_c * nt, nt,
+                            0.0f, Mbuf + pos * p.out_c * nt, nt);
+            }
+            
+            // 3. 输出变换并写回有效区域
+            for (int64_t oc = 0; oc < p.out_c; ++oc) {
+                float* out_ch = out_n + oc * p.out_h * p.out_w;
+                for (int64_t t = 0; t < nt; ++t) {
+                    int64_t th = (t0 + t) / tiles_w;
+                    int64_t tw = (t0 + t) % tiles_w;
+                    float Y[M][M];
+                    TransformOutputTile<M>(Mbuf + oc * nt + t, p.out_c * nt, Y);
+                    for (int i = 0; i < M; ++i) {
+                        int64_t oh = th * M + i;
+                        if (oh >= p.out_h) break;
+                        for (int j = 0; j < M; ++j) {
+                            int64_t ow = tw * M + j;
+                            if (ow >= p.out_w) break;
+                            out_ch[oh * p.out_w + ow] = Y[i][j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ApplyEpilogue(const Conv2DParams& p, const ConvEpilogue& epilogue, float* output) {
+    if (!epilogue.scale && !epilogue.bias && !epilogue.relu) {
+        return;
+    }
+    const int64_t spatial = p.out_h * p.out_w;
+    for (int64_t n = 0; n < p.batch; ++n) {
+        for (int64_t oc = 0; oc < p.out_c; ++oc) {
+            float* data = output + (n * p.out_c + oc) * spatial;
+            const float s = epilogue.scale ? epilogue.scale[oc] : 1.0f;
+            const float b = epilogue.bias ? epilogue.bias[oc] : 0.0f;
+            if (epilogue.relu) {
+                for (int64_t i = 0; i < spatial; ++i) {
+                    float v = s * data[i] + b;
+                    data[i] = v > 0.0f ? v : 0.0f;
+                }
+            } else {
+                for (int64_t i = 0; i < spatial; ++i) {
+                    data[i] = s * data[i] + b;
+                }
+            }
+        }
+    }
+}
+
+// GEMM路径的逐通道后处理在GEMM写回每个子块时完成，不再单独遍历输出
+gemm::GemmEpilogue MakeGemmEpilogue(const ConvEpilogue& epilogue, int64_t oc_offset) {
+    gemm::GemmEpilogue ep;
+    ep.row_scale = epilogue.scale ? epilogue.scale + oc_offset : nullptr;
+    ep.row_bias = epilogue.bias ? epilogue.bias + oc_offset : nullptr;
+    ep.relu = epilogue.relu;
+    return ep;
+}
+
+// 按格式构建打包权重（权重为OIHW）
+std::shared_ptr<const ConvPackedWeight> BuildPackedWeight(const Conv2DParams& p, ConvAlgorithm format,
+                                                          const float* weight) {
+    auto packed = std::make_shared<ConvPackedWeight>();
+    packed->format = format;
+    packed->out_c = p.out_c;
+    packed->in_c = p.in_c;
+    packed->kernel_h = p.kernel_h;
+    packed->kernel_w = p.kernel_w;
+    packed->group = p.group;
+    
+    if (format == ConvAlgorithm::WINOGRAD_F23 || format == ConvAlgorithm::WINOGRAD_F43) {
+        const int m = format == ConvAlgorithm::WINOGRAD_F43 ? 4 : 2;
+        const int64_t a2 = (m + 2) * (m + 2);
+        packed->winograd.resize(static_cast<size_t>(a2 * p.out_c * p.in_c));
+        // U[pos][oc][ic]
+        const int64_t stride = p.out_c * p.in_c;
+        for (int64_t oc = 0; oc < p.out_c; ++oc) {
+            for (int64_t ic = 0; ic < p.in_c; ++ic) {
+                const float* g = weight + (oc * p.in_c + ic) * 9;
+                float* U = packed->winograd.data() + oc * p.in_c + ic;
+                if (m == 4) {
+                    TransformWeightTile<4>(g, U, stride);
+                } else {
+                    TransformWeightTile<2>(g, U, stride);
+                }
+            }
+        }
+    } else if (format == ConvAlgorithm::IM2COL_GEMM) {
+        const int64_t oc_g = p.out_c / p.group;
+        const int64_t K = (p.in_c / p.group) * p.kernel_h * p.kernel_w;
+        packed->gemm_a.resize(static_cast<size_t>(p.group));
+        for (int64_t g = 0; g < p.group; ++g) {
+            gemm::PackMatrixA(false, oc_g, K, weight + g * oc_g * K, K, &packed->gemm_a[g]);
+        }
+    }
+    return packed;
+}
+
+bool PackedWeightMatches(const ConvPackedWeight& packed, const Conv2DParams& p, ConvAlgorithm format) {
+    return packed.format == format && packed.out_c == p.out_c && packed.in_c == p.in_c &&
+           packed.kernel_h == p.kernel_h && packed.kernel_w == p.kernel_w && packed.group == p.group;
+}
+
+// 算法在暂存区中使用的两段缓冲（float个数）：im2col矩阵，或Winograd的输入/输出变换缓冲
+void ConvScratchFloats(const Conv2DParams& p, ConvAlgorithm algorithm, size_t* first, size_t* second) {
+    *first = 0;
+    *second = 0;
+    switch (algorithm) {
+        case ConvAlgorithm::IM2COL_GEMM:
+            *first = static_cast<size_t>((p.in_c / p.group) * p.kernel_h * p.kernel_w * p.out_h * p.out_w);
+            break;
+        case ConvAlgorithm::WINOGRAD_F23:
+        case ConvAlgorithm::WINOGRAD_F43: {
+            const int64_t m = algorithm == ConvAlgorithm::WINOGRAD_F43 ? 4 : 2;
+            const int64_t a2 = (m + 2) * (m + 2);
+            const int64_t tiles = ((p.out_h + m - 1) / m) * ((p.out_w + m - 1) / m);
+            const int64_t nt = std::min(kWinogradTileBlock, tiles);
+            *first = static_cast<size_t>(a2 * p.in_c * nt);
+            *second = static_cast<size_t>(a2 * p.out_c * nt);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void RunIm2colGemm(const ConvPlan& plan, const float* input, const float* weight, float* output,
+                   const ConvEpilogue& epilogue, float* col) {
+    const Conv2DParams& p = plan.params;
+    const int64_t ic_g = p.in_c / p.group;
+    const int64_t oc_g = p.out_c / p.group;
+    const int64_t spatial = p.out_h * p.out_w;
+    const int64_t K = ic_g * p.kernel_h * p.kernel_w;
+    
+    for (int64_t n = 0; n < p.batch; ++n) {
+        for (int64_t g = 0; g < p.group; ++g) {
+            const float* in_g = input + (n * p.in_c + g * ic_g) * p.in_h * p.in_w;
+            
+            // im2col：col[(c * kh + i) * kw + j][oh * out_w + ow]
+            for (int64_t c = 0; c < ic_g; ++c) {
+                const float* in_ch = in_g + c * p.in_h * p.in_w;
+                for (int64_t kh = 0; kh < p.kernel_h; ++kh) {
+                    for (int64_t kw = 0; kw < p.kernel_w; ++kw) {
+                        float* col_row = col + ((c * p.kernel_h + kh) * p.kernel_w + kw) * spatial;
+                        for (int64_t oh = 0; oh < p.out_h; ++oh) {
+                            int64_t ih = oh * p.stride_h - p.pad_top + kh * p.dilation_h;
+                            float* dst = col_row + oh * p.out_w;
+                            if (ih < 0 || ih >= p.in_h) {
+                                std::memset(dst, 0, static_cast<size_t>(p.out_w) * sizeof(float));
+                                continue;
+                            }
+                            const float* src = in_ch + ih * p.in_w;
+                            int64_t iw = kw * p.dilation_w - p.pad_left;
+                            for (int64_t ow = 0; ow < p.out_w; ++ow, iw += p.stride_w) {
+                                dst[ow] = (iw >= 0 && iw < p.in_w) ? src[iw] : 0.0f;
+                            }
+                        }
+                    }
+                }
+            }
+            
+            // GEMM：out[oc_g, spatial] = W_g[oc_g, K] * col[K, spatial]
+            float* out_g = output + (n * p.out_c + g * oc_g) * spatial;
+            const gemm::GemmEpilogue ep = MakeGemmEpilogue(epilogue, g * oc_g);
+            if (plan.packed) {
+                gemm::SgemmPrepacked(false, false, oc_g, spatial, K, 1.0f,
+                                     nullptr, K, &plan.packed->gemm_a[g],
+                                     col, spatial, nullptr,
+                                     0.0f, out_g, spatial, &ep);
+            } else {
+                gemm::Sgemm(false, false, oc_g, spatial, K, 1.0f,
+                            weight + g * oc_g * K, K,
+                            col, spatial,
+                            0.0f, out_g, spatial, &ep);
+            }
+        }
+    }
+}
+
+void RunPointwise(const ConvPlan& plan, const float* input, const float* weight, float* output,
+                  const ConvEpilogue& epilogue) {
+    // 1x1卷积即 [oc, ic] x [ic, H*W]，输入本身就是GEMM的B矩阵
+    const Conv2DParams& p = plan.params;
+    const int64_t ic_g = p.in_c / p.group;
+    const int64_t oc_g = p.out_c / p.group;
+    const int64_t spatial = p.out_h * p.out_w;
+    
+    for (int64_t n = 0; n < p.batch; ++n) {
+        for (int64_t g = 0; g < p.group; ++g) {
+            const gemm::GemmEpilogue ep = MakeGemmEpilogue(epilogue, g * oc_g);
+            const float* in_g = input + (n * p.in_c + g * ic_g) * spatial;
+            float* out_g = output + (n * p.out_c + g * oc_g) * spatial;
+            if (plan.packed) {
+                gemm::SgemmPrepacked(false, false, oc_g, spatial, ic_g, 1.0f,
+                                     nullptr, ic_g, &plan.packed->gemm_a[g],
+                                     in_g, spatial, nullptr,
+                                     0.0f, out_g, spatial, &ep);
+            } else {
+                gemm::Sgemm(false, false, oc_g, spatial, ic_g, 1.0f,
+                            weight + g * oc_g * ic_g, ic_g,
+                            in_g, spatial,
+                            0.0f, out_g, spatial, &ep);
+            }
+        }
+    }
+}
+
+void RunDepthwise(const ConvPlan& plan, const float* input, const float* weight, float* output,
+                  const ConvEpilogue& epilogue, ExecutionContext* ctx) {
+    const Conv2DParams& p = plan.params;
+    const int64_t multiplier = p.out_c / p.in_c;
+    const int64_t kernel_size = p.kernel_h * p.kernel_w;
+    const int64_t spatial = p.out_h * p.out_w;
+    ParallelForOuter(ctx, p.batch * p.out_c, spatial * kernel_size, [&](int64_t begin, int64_t end) {
+        for (int64_t index = begin; index < end; ++index) {
+            const int64_t n = index / p.out_c;
+            const int64_t oc = index % p.out_c;
+            const float* in_ch = input + (n * p.in_c + oc / multiplier) * p.in_h * p.in_w;
+            DepthwiseConvRows(p, in_ch, weight + oc * kernel_size,
+                              epilogue.scale ? epilogue.scale[oc] : 1.0f,
+                              epilogue.bias ? epilogue.bias[oc] : 0.0f, epilogue.relu,
+                              0, p.out_h, output + index * spatial);
+        }
+    });
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// 深度可分离卷积
+// ---------------------------------------------------------------------------
+void DepthwiseConvRows(const Conv2DParams& p, const float* input, const float* weight,
+                       float scale, float bias, bool relu, int64_t row_begin, int64_t row_end,
+                       float* output) {
+    if (row_begin >= row_end) {
+        return;
+    }
+    // 相位行：phase[s][r][j] = 补零后输入第r行的第j * stride_w + s列，
+    // 抽头(kh, kw)对输出第ow列读取phase[(kw * dilation_w) % stride_w][oh * stride_h + kh * dilation_h]
+    // 的第ow + (kw * dilation_w) / stride_w个元素
+    const int64_t stride = p.stride_w;
+    const int64_t length = p.out_w + (p.kernel_w - 1) * p.dilation_w / stride + 1;
+    const int64_t rows = (row_end - 1 - row_begin) * p.stride_h + (p.kernel_h - 1) * p.dilation_h + 1;
+    const int64_t row0 = row_begin * p.stride_h - p.pad_top;
+    thread_local std::vector<float> phases;
+    thread_local std::vector<size_t> offsets;
+    thread_local std::vector<float> weights;
+    phases.resize(static_cast<size_t>(stride * rows * length));
+    for (int64_t r = 0; r < rows; ++r) {
+        const int64_t ih = row0 + r;
+        if (ih < 0 || ih >= p.in_h) {
+            for (int64_t s = 0; s < stride; ++s) {
+                std::memset(phases.data() + (s * rows + r) * length, 0, static_cast<size_t>(length) * sizeof(float));
+            }
+            continue;
+        }
+        const float* src = input + ih * p.in_w;
+        if (stride == 1) {
+            // 左右补零，中间整段拷贝
+            float* dst = phases.data() + r * length;
+            const int64_t left = std::min<int64_t>(p.pad_left, length);
+            const int64_t copy = std::max<int64_t>(0, std::min<int64_t>(p.in_w, length - p.pad_left));
+            std::memset(dst, 0, static_cast<size_t>(left) * sizeof(float));
+            std::memcpy(dst + left, src, static_cast<size_t>(copy) * sizeof(float));
+            std::memset(dst + left + copy, 0, static_cast<size_t>(length - left - copy) * sizeof(float));
+            continue;
+        }
+        for (int64_t s = 0; s < stride; ++s) {
+            float* dst = phases.data() + (s * rows + r) * length;
+            for (int64_t j = 0; j < length; ++j) {
+                const int64_t iw = j * stride + s - p.pad_left;
+                dst[j] = iw >= 0 && iw < p.in_w ? src[iw] : 0.0f;
+            }
+        }
+    }
+    
+    const int64_t taps = p.kernel_h * p.kernel_w;
+    offsets.resize(static_cast<size_t>(taps));
+    weights.resize(static_cast<size_t>(taps));
+    for (int64_t kh = 0; kh < p.kernel_h; ++kh) {
+        for (int64_t kw = 0; kw < p.kernel_w; ++kw) {
+            const int64_t t = kh * p.kernel_w + kw;
+            const int64_t col = kw * p.dilation_w;
+            offsets[t] = static_cast<size_t>(((col % stride) * rows + kh * p.dilation_h) * length + col / stride);
+            weights[t] = weight[t] * scale;
+        }
+    }
+    for (int64_t oh = row_begin; oh < row_end; ++oh) {
+        const float* base = phases.data() + (oh - row_begin) * p.stride_h * length;
+        simd::DepthwiseConvRowSIMD(base, offsets.data(), weights.data(), static_cast<size_t>(taps),
+                                   bias, relu, output + (oh - row_begin) * p.out_w,
+                                   static_cast<size_t>(p.out_w));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Conv2DKernel
+// ---------------------------------------------------------------------------
+Status Conv2DKernel::Prepare(const Conv2DParams& params, ConvAlgorithm requested,
+                             const float* weight, std::shared_ptr<const ConvPlan>* plan) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& cached : plans_) {
+        if (cached->params == params && cached->requested == requested && cached->weight == weight) {
+            *plan = cached;
+            return Status::Ok();
+        }
+    }
+    
+    auto built = std::make_shared<ConvPlan>();
+    built->params = params;
+    built->requested = requested;
+    built->weight = weight;
+    built->algorithm = SelectConvAlgorithm(params, requested);
+    
+    // 变换后的权重：优先复用会话加载时的预打包结果或其他形状的计划中同格式的打包，否则在这里构建一次
+    const ConvAlgorithm format = ConvPackingFormat(built->algorithm);
+    if (format != ConvAlgorithm::AUTO) {
+        if (prepacked_ && prepacked_source_ == weight && PackedWeightMatches(*prepacked_, params, format)) {
+            built->packed = prepacked_;
+        }
+        for (const auto& cached : plans_) {
+            if (!built->packed && cached->packed && cached->weight == weight &&
+                PackedWeightMatches(*cached->packed, params, format)) {
+                built->packed = cached->packed;
+            }
+        }
+        if (!built->packed) {
+            built->packed = BuildPackedWeight(params, format, weight);
+        }
+    }
+    
+    if (plans_.size() >= kMaxPlans) {
+        plans_.erase(plans_.begin());
+    }
+    plans_.push_back(built);
+    *plan = std::move(built);
+    return Status::Ok();
+}
+
+Status Conv2DKernel::PrePack(const Conv2DParams& params, bool spatial_known, ConvAlgorithm requested,
+                             const float* weight, bool* is_packed) {
+    *is_packed = false;
+    ConvAlgorithm algorithm = ConvAlgorithm::IM2COL_GEMM;
+    if (spatial_known) {
+        algorithm = SelectConvAlgorithm(params, requested);
+    } else if (IsConvAlgorithmApplicable(ConvAlgorithm::DEPTHWISE, params) && params.group > 1) {
+        algorithm = ConvAlgorithm::DEPTHWISE;
+    }
+    const ConvAlgorithm format = ConvPackingFormat(algorithm);
+    if (format == ConvAlgorithm::AUTO) {
+        return Status::Ok();
+    }
+    
+    const size_t count = static_cast<size_t>(params.out_c * (params.in_c / params.group) *
+                                             params.kernel_h * params.kernel_w);
+    std::string layout = std::string("conv_") + ConvAlgorithmName(format);
+    if (format == ConvAlgorithm::IM2COL_GEMM) {
+        layout += std::string("_") + gemm::GetMicroKernelName();
+    }
+    const std::string key = PrepackedWeightCache::MakeKey(
+        layout, {params.out_c, params.in_c, params.kernel_h, params.kernel_w, params.group},
+        weight, count);
+    auto prepacked = PrepackedWeightCache::Instance().GetOrCreate<ConvPackedWeight>(key, [&]() {
+        return BuildPackedWeight(params, format, weight);
+    });
+    std::lock_guard<std::mutex> lock(mutex_);
+    prepacked_ = std::move(prepacked);
+    prepacked_source_ = weight;
+    plans_.clear();  // 之后的Prepare重新构建计划，切换到预打包结果
+    *is_packed = prepacked_ != nullptr;
+    return Status::Ok();
+}
+
+Status PrePackConvWeight(const Operator& op, Conv2DKernel* kernel, int input_index,
+                         const Tensor& tensor, const std::vector<Shape>& input_shapes,
+                         bool* is_packed) {
+    *is_packed = false;
+    const Shape& weight_shape = tensor.GetShape();
+    if (input_index != 1 || tensor.GetDataType() != DataType::FLOAT32 ||
+        weight_shape.dims.size() != 4) {
+        return Status::Ok();
+    }
+    
+    // 输入形状完整时按实际参数选算法；否则只用权重形状与group
+    Conv2DParams params;
+    bool spatial_known = false;
+    if (!input_shapes.empty() && input_shapes[0].dims.size() == 4 &&
+        std::all_of(input_shapes[0].dims.begin(), input_shapes[0].dims.end(),
+                    [](int64_t d) { return d > 0; })) {
+        spatial_known = ParseConv2DParams(op, input_shapes[0], weight_shape, &params).IsOk();
+    }
+    if (!spatial_known) {
+        params = Conv2DParams();
+        params.group = op.GetIntAttribute("group", 1);
+        params.out_c = weight_shape.dims[0];
+        params.in_c = weight_shape.dims[1] * params.group;
+        params.kernel_h = weight_shape.dims[2];
+        params.kernel_w = weight_shape.dims[3];
+        if (params.group <= 0 || params.out_c % params.group != 0) {
+            return Status::Ok();
+        }
+    }
+    ConvAlgorithm requested = ParseConvAlgorithm(op.GetStringAttribute("conv_algorithm", "auto"));
+    return kernel->PrePack(params, spatial_known, requested,
+                           static_cast<const float*>(tensor.GetData()), is_packed);
+}
+
+OperatorMemory EstimateConvMemory(const Operator& op, const std::vector<TensorInfo>& inputs) {
+    OperatorMemory memory;
+    if (inputs.size() < 2 || inputs[1].dtype != DataType::FLOAT32 || inputs[1].shape.dims.size() != 4) {
+        return memory;
+    }
+    const Shape& weight_shape = inputs[1].shape;
+    Conv2DParams params;
+    bool spatial_known = inputs[0].shape.dims.size() == 4 &&
+        std::all_of(inputs[0].shape.dims.begin(), inputs[0].shape.dims.end(), [](int64_t d) { return d > 0; }) &&
+        ParseConv2DParams(op, inputs[0].shape, weight_shape, &params).IsOk();
+    if (!spatial_known) {
+        params = Conv2DParams();
+        params.group = op.GetIntAttribute("group", 1);
+        params.out_c = weight_shape.dims[0];
+        params.in_c = weight_shape.dims[1] * params.group;
+        params.kernel_h = weight_shape.dims[2];
+        params.kernel_w = weight_shape.dims[3];
+        if (params.group <= 0 || params.out_c % params.group != 0) {
+            return memory;
+        }
+    }
+    ConvAlgorithm algorithm = ConvAlgorithm::IM2COL_GEMM;
+    if (spatial_known) {
+        algorithm = SelectConvAlgorithm(params, ParseConvAlgorithm(op.GetStringAttribute("conv_algorithm", "auto")));
+    } else if (IsConvAlgorithmApplicable(ConvAlgorithm::DEPTHWISE, params) && params.group > 1) {
+        algorithm = ConvAlgorithm::DEPTHWISE;
+    }
+    
+    // 与BuildPackedWeight一致
+    const int64_t oc_g = params.out_c / params.group;
+    const int64_t ic_g = params.in_c / params.group;
+    const int64_t K = ic_g * params.kernel_h * params.kernel_w;
+    const ConvAlgorithm format = ConvPackingFormat(algorithm);
+    if (inputs[1].constant) {
+        if (format == ConvAlgorithm::WINOGRAD_F23 || format == ConvAlgorithm::WINOGRAD_F43) {
+            const int64_t m = format == ConvAlgorithm::WINOGRAD_F43 ? 4 : 2;
+            memory.prepacked_bytes = static_cast<size_t>((m + 2) * (m + 2) * params.out_c * params.in_c) * sizeof(float);
+        } else if (format == ConvAlgorithm::IM2COL_GEMM) {
+            memory.prepacked_bytes = static_cast<size_t>(params.group) * gemm::PackedMatrixABytes(oc_g, K);
+        }
+    }
+    if (!spatial_known) {
+        return memory;
+    }
+    
+    // im2col/Winograd缓冲与GEMM的打包缓冲都从调用线程的暂存区切出（见Conv2DKernel::Run）
+    const int64_t spatial = params.out_h * params.out_w;
+    size_t first = 0;
+    size_t second = 0;
+    ConvScratchFloats(params, algorithm, &first, &second);
+    memory.scratch_bytes = (first + second) * sizeof(float);
+    if (algorithm == ConvAlgorithm::IM2COL_GEMM || algorithm == ConvAlgorithm::POINTWISE) {
+        memory.scratch_bytes += gemm::SgemmScratchBytes(oc_g, spatial, K, format == ConvAlgorithm::IM2COL_GEMM, false);
+    }
+    return memory;
+}
+
+void Conv2DKernel::Run(const ConvPlan& plan, const float* input, const float* weight, float* output,
+                       const ConvEpilogue& epilogue, ExecutionContext* ctx) {
+    // 缓冲在返回时回收；并发执行同一节点的线程各用自己的暂存区
+    ScratchScope scratch;
+    size_t first = 0;
+    size_t second = 0;
+    ConvScratchFloats(plan.params, plan.algorithm, &first, &second);
+    switch (plan.algorithm) {
+        case ConvAlgorithm::POINTWISE:
+            RunPointwise(plan, input, weight, output, epilogue);
+            return;
+        case ConvAlgorithm::DEPTHWISE:
+            RunDepthwise(plan, input, weight, output, epilogue, ctx);
+            return;
+        case ConvAlgorithm::WINOGRAD_F23:
+        case ConvAlgorithm::WINOGRAD_F43: {
+            float* V = scratch.GetArena().Allocate<float>(first);
+            float* Mbuf = scratch.GetArena().Allocate<float>(second);
+            if (plan.algorithm == ConvAlgorithm::WINOGRAD_F43) {
+                WinogradConv<4>(plan.params, input, plan.packed->winograd.data(), V, Mbuf, output);
+            } else {
+                WinogradConv<2>(plan.params, input, plan.packed->winograd.data(), V, Mbuf, output);
+            }
+            break;
+        }
+        default:
+            RunIm2colGemm(plan, input, weight, output, epilogue, scratch.GetArena().Allocate<float>(first));
+            return;
+    }
+    ApplyEpilogue(plan.params, epilogue, output);
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,134 @@
+// 卷积计算引擎
+// 参考NCNN/ONNX Runtime的卷积实现：按形状和属性选择im2col+GEMM、1x1直连GEMM、
+// Winograd F(2,3)/F(4,3)或深度可分离卷积，并缓存选择结果与变换后的权重
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include "gemm.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// 二维卷积参数（NCHW，权重为[out_c, in_c/group, kernel_h, kernel_w]）
+struct Conv2DParams {
+    int64_t batch = 0;
+    int64_t in_c = 0, in_h = 0, in_w = 0;
+    int64_t out_c = 0, out_h = 0, out_w = 0;
+    int64_t kernel_h = 1, kernel_w = 1;
+    int64_t stride_h = 1, stride_w = 1;
+    int64_t pad_top = 0, pad_left = 0, pad_bottom = 0, pad_right = 0;
+    int64_t dilation_h = 1, dilation_w = 1;
+    int64_t group = 1;
+    
+    bool operator==(const Conv2DParams& other) const;
+    bool operator!=(const Conv2DParams& other) const { return !(*this == other); }
+};
+
+// 从算子属性（strides/pads/dilations/group/auto_pad）和输入/权重形状解析卷积参数
+Status ParseConv2DParams(const Operator& op, const Shape& input_shape,
+                         const Shape& weight_shape, Conv2DParams* params);
+
+enum class ConvAlgorithm {
+    AUTO,
+    IM2COL_GEMM,    // 通用路径
+    POINTWISE,      // 1x1、stride 1、无padding：直接GEMM，无需im2col
+    WINOGRAD_F23,   // 3x3 stride 1
+    WINOGRAD_F43,   // 3x3 stride 1，大特征图
+    DEPTHWISE       // group == in_c，out_c为in_c的整数倍（通道乘数）
+};
+
+const char* ConvAlgorithmName(ConvAlgorithm algorithm);
+ConvAlgorithm ParseConvAlgorithm(const std::string& name);
+
+// 判断算法是否适用于给定参数
+bool IsConvAlgorithmApplicable(ConvAlgorithm algorithm, const Conv2DParams& params);
+
+// 按形状启发式选择算法；requested非AUTO且适用时优先使用
+ConvAlgorithm SelectConvAlgorithm(const Conv2DParams& params,
+                                  ConvAlgorithm requested = ConvAlgorithm::AUTO);
+
+// 卷积输出的逐通道后处理：y = scale[oc] * x + bias[oc]，可选ReLU
+// 用于Conv的bias以及FusedConvBNReLU折叠后的BN参数
+struct ConvEpilogue {
+    const float* scale = nullptr;
+    const float* bias = nullptr;
+    bool relu = false;
+};
+
+// 卷积权重的打包结果（只读，可在算子实例和会话之间共享）
+struct ConvPackedWeight {
+    ConvAlgorithm format = ConvAlgorithm::AUTO;  // 见ConvPackingFormat
+    int64_t out_c = 0, in_c = 0, kernel_h = 0, kernel_w = 0, group = 1;
+    std::vector<float> winograd;                 // Winograd变换后的权重：[alpha*alpha][out_c][in_c]
+    std::vector<gemm::PackedMatrix> gemm_a;      // GEMM路径每组一个：W_g[oc_g, ic_g*kh*kw]
+};
+
+// 算法对应的权重打包格式：Winograd F(2,3)/F(4,3)各自一种，im2col与1x1共用GEMM的A面板（IM2COL_GEMM），
+// 深度可分离直接读取原始权重（AUTO，表示不打包）；链接外部BLAS时GEMM路径也不打包
+ConvAlgorithm ConvPackingFormat(ConvAlgorithm algorithm);
+
+// 一组卷积参数的执行计划：选定的算法与打包后的权重，构建后只读
+struct ConvPlan {
+    Conv2DParams params;
+    ConvAlgorithm requested = ConvAlgorithm::AUTO;
+    ConvAlgorithm algorithm = ConvAlgorithm::AUTO;
+    const float* weight = nullptr;
+    std::shared_ptr<const ConvPackedWeight> packed;  // 深度可分离或不打包时为空
+};
+
+// 编译后的卷积内核：按形状缓存执行计划（算法选择与变换后的权重）。
+// 同一节点可被并发的运行同时执行：计划的查找与构建在锁内完成，调用方持有取得的计划直到Run返回，
+// im2col矩阵与Winograd变换缓冲在每次Run时从调用线程的暂存区切出
+class Conv2DKernel {
+public:
+    // 取得(params, requested, weight)对应的计划，没有时构建并缓存
+    // 注意：Winograd/GEMM路径缓存了打包后的权重，按权重地址判断是否失效（权重视为常量）
+    Status Prepare(const Conv2DParams& params, ConvAlgorithm requested, const float* weight,
+                   std::shared_ptr<const ConvPlan>* plan);
+    
+    // 会话加载时预打包权重并登记到PrepackedWeightCache；spatial_known为false时params只有通道、
+    // 卷积核与group有效，按GEMM格式打包。之后Prepare遇到同一权重和格式时直接复用
+    Status PrePack(const Conv2DParams& params, bool spatial_known, ConvAlgorithm requested,
+                   const float* weight, bool* is_packed);
+    
+    // ctx非空时深度可分离路径按通道在算子内线程上并行（GEMM路径由GEMM自身并行）
+    static void Run(const ConvPlan& plan, const float* input, const float* weight, float* output,
+                    const ConvEpilogue& epilogue, ExecutionContext* ctx = nullptr);
+
+private:
+    // 形状交替变化（如并发运行的请求批大小不同）时保留的计划数
+    static constexpr size_t kMaxPlans = 4;
+    
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<const ConvPlan>> plans_;  // 按构建先后，满时换出最早的
+    // 会话加载时的预打包结果及其对应的原始权重
+    std::shared_ptr<const ConvPackedWeight> prepacked_;
+    const float* prepacked_source_ = nullptr;
+};
+
+// 深度卷积一个输出通道的输出行[row_begin, row_end)，写入output（行跨度out_w）：
+// input为该通道对应的输入通道平面，weight为该通道的kernel_h * kernel_w个权重。
+// 所需输入行补零并按stride_w拆成相位行后，每个抽头读取的都是连续的一段，由DepthwiseConvRowSIMD
+// 逐行计算（3x3/5x5为展开的专用核）；scale折进权重，bias与ReLU在写回时完成
+void DepthwiseConvRows(const Conv2DParams& params, const float* input, const float* weight,
+                       float scale, float bias, bool relu, int64_t row_begin, int64_t row_end,
+                       float* output);
+
+// Conv/FusedConvBNReLU共用的Operator::EstimateMemory实现：输入形状完整时按选定的算法计入权重打包与
+// 暂存区中的im2col/Winograd缓冲，否则同PrePack按GEMM格式计入打包
+OperatorMemory EstimateConvMemory(const Operator& op, const std::vector<TensorInfo>& inputs);
+
+// Conv/FusedConvBNReLU共用的Operator::PrePack实现：权重为输入1
+Status PrePackConvWeight(const Operator& op, Conv2DKernel* kernel, int input_index,
+                         const Tensor& tensor, const std::vector<Shape>& input_shapes,
+                         bool* is_packed);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,453 @@
+// 检测后处理算子实现：TopK与NonMaxSuppression
+// TopK参考ONNX Runtime的TopK：k远小于行长时维护k个最优元素的堆，SIMD阈值筛选只返回优于堆顶的下标，
+// 否则用nth_element部分选择，都不对整行排序。
+// NonMaxSuppression参考ONNX Runtime与torchvision的nms：按(batch, class)并行，先用SIMD按score_threshold
+// 筛掉低分框，剩余框按分数排序后坐标按分量连续存放；每选出一个框，用SIMD计算它与其余候选的IoU，
+// 并把未被抑制的候选压缩到前部，后续轮次只处理仍存活的框
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// k * kHeapRatio不超过行长时largest走堆筛选，否则部分选择
+constexpr int64_t kHeapRatio = 8;
+// 堆筛选每次处理的元素数，阈值在块之间更新
+constexpr size_t kSelectChunk = 4096;
+
+struct Candidate {
+    float value;
+    int64_t index;
+};
+
+// 值相等时下标小的在前（ONNX TopK的约定）
+inline bool Larger(const Candidate& a, const Candidate& b) {
+    return a.value > b.value || (a.value == b.value && a.index < b.index);
+}
+
+inline bool Smaller(const Candidate& a, const Candidate& b) {
+    return a.value < b.value || (a.value == b.value && a.index < b.index);
+}
+
+// 行中最大的k个元素：最小堆的堆顶是已选出的k个中最差的，按下标递增扫描，
+// 只有严格大于堆顶的元素才能入堆，相等的值自然保留下标小的
+void LargestByHeap(const float* row, int64_t n, int64_t k, std::vector<Candidate>* out,
+                   std::vector<uint32_t>* indices) {
+    out->clear();
+    for (int64_t i = 0; i < k; ++i) {
+        out->push_back({row[i], i});
+    }
+    std::make_heap(out->begin(), out->end(), Larger);
+    const size_t count = static_cast<size_t>(n);
+    indices->resize(std::min(kSelectChunk, count));
+    for (size_t begin = static_cast<size_t>(k); begin < count; begin += kSelectChunk) {
+        const size_t length = std::min(kSelectChunk, count - begin);
+        const size_t selected = simd::SelectGreaterSIMD(row + begin, length, out->front().value, indices->data());
+        for (size_t s = 0; s < selected; ++s) {
+            const int64_t index = static_cast<int64_t>(begin + (*indices)[s]);
+            if (row[index] > out->front().value) {
+                std::pop_heap(out->begin(), out->end(), Larger);
+                out->back() = {row[index], index};
+                std::push_heap(out->begin(), out->end(), Larger);
+            }
+        }
+    }
+}
+
+// 部分选择：前k个为最优的k个（相互之间无序）
+void SelectByPartition(const float* row, int64_t n, int64_t k, bool largest, std::vector<Candidate>* out) {
+    out->resize(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) {
+        (*out)[static_cast<size_t>(i)] = {row[i], i};
+    }
+    if (k < n) {
+        if (largest) {
+            std::nth_element(out->begin(), out->begin() + (k - 1), out->end(), Larger);
+        } else {
+            std::nth_element(out->begin(), out->begin() + (k - 1), out->end(), Smaller);
+        }
+    }
+    out->resize(static_cast<size_t>(k));
+}
+
+// 数据相关形状的输出：已有同形状的缓冲（如IOBinding绑定的输出）时直接写入，否则重新分配
+Status PrepareOutput(const Shape& shape, DataType dtype, Tensor* output) {
+    if (!output->GetData() || output->GetShape().dims != shape.dims || output->GetDataType() != dtype) {
+        *output = Tensor(shape, dtype);
+    }
+    if (!output->GetData() && output->GetElementCount() > 0) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate output");
+    }
+    return Status::Ok();
+}
+
+// 第slot个ONNX输入，省略或为空时为nullptr（可选输入的位置见input_slots）
+const Tensor* InputAt(const Operator& op, const std::vector<Tensor*>& inputs, int64_t slot) {
+    const std::vector<int64_t> slots = op.GetIntsAttribute("input_slots", {});
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const int64_t position = i < slots.size() ? slots[i] : static_cast<int64_t>(i);
+        if (position == slot) {
+            return inputs[i] && inputs[i]->GetElementCount() > 0 ? inputs[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+// TopK算子（ONNX语义）
+// 输入：X（FLOAT32）、K（INT64 [1]，opset 1为属性k）；输出：Values与Indices（INT64），沿axis取k个
+// 属性：axis（默认-1）、largest（默认1）、sorted（默认1，为0时输出顺序不保证）
+class TopKOperator : public Operator {
+public:
+    std::string GetName() const override { return "TopK"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs.size() > 2 || inputs[0]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK requires a FLOAT32 input and K");
+        }
+        std::vector<Shape> shapes;
+        return InferOutputShape(inputs, shapes);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK requires an input");
+        }
+        int64_t axis = 0;
+        Status status = ResolveAxis(inputs[0]->GetShape(), &axis);
+        if (!status.IsOk()) {
+            return status;
+        }
+        int64_t k = 0;
+        status = ResolveK(inputs, &k);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        if (k > dims[static_cast<size_t>(axis)]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK k exceeds the axis length");
+        }
+        dims[static_cast<size_t>(axis)] = k;
+        output_shapes.push_back(Shape(dims));
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        if (output_index == 1) {
+            return DataType::INT64;
+        }
+        return inputs.empty() ? DataType::UNKNOWN : inputs[0]->GetDataType();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK produces values and indices");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+        int64_t axis = 0;
+        int64_t k = 0;
+        ResolveAxis(inputs[0]->GetShape(), &axis);
+        ResolveK(inputs, &k);
+        int64_t outer = 1, inner = 1;
+        for (int64_t i = 0; i < axis; ++i) outer *= dims[static_cast<size_t>(i)];
+        for (size_t i = static_cast<size_t>(axis) + 1; i < dims.size(); ++i) inner *= dims[i];
+        const int64_t n = dims[static_cast<size_t>(axis)];
+        const float* x = static_cast<const float*>(inputs[0]->GetData());
+        float* values = static_cast<float*>(outputs[0]->GetData());
+        int64_t* indices = static_cast<int64_t*>(outputs[1]->GetData());
+        if (k == 0 || outer * inner == 0) {
+            return Status::Ok();
+        }
+        const bool largest = GetIntAttribute("largest", 1) != 0;
+        const bool sorted = GetIntAttribute("sorted", 1) != 0;
+        const bool use_heap = largest && k * kHeapRatio <= n;
+    
+        // 每行为沿axis的n个元素；inner > 1时先把跨步的一列收集到连续缓冲
+        ParallelForOuter(ctx, outer * inner, n, [&](int64_t begin, int64_t end) {
+            std::vector<float> column(inner > 1 ? static_cast<size_t>(n) : 0);
+            std::vector<Candidate> best;
+            std::vector<uint32_t> selected;
+            for (int64_t r = begin; r < end; ++r) {
+                const int64_t o = r / inner;
+                const int64_t j = r % inner;
+                const float* row = x + o * n * inner + j;
+                if (inner > 1) {
+                    for (int64_t i = 0; i < n; ++i) {
+                        column[static_cast<size_t>(i)] = row[i * inner];
+                    }
+                    row = column.data();
+                }
+                if (use_heap) {
+                    LargestByHeap(row, n, k, &best, &selected);
+                } else {
+                    SelectByPartition(row, n, k, largest, &best);
+                }
+                if (sorted) {
+                    std::sort(best.begin(), best.end(), largest ? Larger : Smaller);
+                }
+                const int64_t base = o * k * inner + j;
+                for (int64_t i = 0; i < k; ++i) {
+                    values[base + i * inner] = best[static_cast<size_t>(i)].value;
+                    indices[base + i * inner] = best[static_cast<size_t>(i)].index;
+                }
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    Status ResolveAxis(const Shape& shape, int64_t* axis) const {
+        const int64_t rank = static_cast<int64_t>(shape.dims.size());
+        *axis = GetIntAttribute("axis", -1);
+        if (*axis < 0) {
+            *axis += rank;
+        }
+        if (*axis < 0 || *axis >= rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK axis out of range");
+        }
+        return Status::Ok();
+    }
+    
+    Status ResolveK(const std::vector<Tensor*>& inputs, int64_t* k) const {
+        if (inputs.size() < 2) {
+            *k = GetIntAttribute("k", -1);
+        } else {
+            const Tensor* k_tensor = inputs[1];
+            if (k_tensor->GetDataType() != DataType::INT64 || k_tensor->GetElementCount() != 1) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK K must be a single INT64");
+            }
+            if (!k_tensor->GetData()) {
+                // 加载期形状推断时K由上游算子计算，值未知
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK K is not a constant");
+            }
+            *k = *static_cast<const int64_t*>(k_tensor->GetData());
+        }
+        if (*k < 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "TopK k must be non-negative");
+        }
+        return Status::Ok();
+    }
+};
+
+// NonMaxSuppression算子（ONNX语义）
+// 输入：boxes [B, N, 4]、scores [B, C, N]、max_output_boxes_per_class、iou_threshold、score_threshold
+// （后三个可选，位置见input_slots）；输出：selected_indices [num_selected, 3]（INT64，(batch, class, box)），
+// 按batch、class排列，每类内按选中的先后顺序。属性：center_point_box（0为[y1, x1, y2, x2]，
+// 对角可以互换；1为[x_center, y_center, width, height]）
+class NonMaxSuppressionOperator : public Operator {
+public:
+    std::string GetName() const override { return "NonMaxSuppression"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2 || inputs[0]->GetDataType() != DataType::FLOAT32 ||
+            inputs[1]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NonMaxSuppression requires FLOAT32 boxes and scores");
+        }
+        const auto& boxes = inputs[0]->GetShape().dims;
+        const auto& scores = inputs[1]->GetShape().dims;
+        if (boxes.size() != 3 || boxes[2] != 4 || scores.size() != 3 ||
+            scores[0] != boxes[0] || scores[2] != boxes[1]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NonMaxSuppression expects boxes [B, N, 4] and scores [B, C, N]");
+        }
+        const int64_t center_point_box = GetIntAttribute("center_point_box", 0);
+        if (center_point_box != 0 && center_point_box != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NonMaxSuppression center_point_box must be 0 or 1");
+        }
+        const Tensor* iou = InputAt(*this, inputs, 3);
+        if (iou && (iou->GetDataType() != DataType::FLOAT32 ||
+                    *static_cast<const float*>(iou->GetData()) < 0.0f ||
+                    *static_cast<const float*>(iou->GetData()) > 1.0f)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NonMaxSuppression iou_threshold must be in [0, 1]");
+        }
+        const Tensor* max_boxes = InputAt(*this, inputs, 2);
+        const Tensor* score = InputAt(*this, inputs, 4);
+        if ((max_boxes && max_boxes->GetDataType() != DataType::INT64) ||
+            (score && score->GetDataType() != DataType::FLOAT32)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NonMaxSuppression threshold inputs have the wrong type");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        (void)inputs;
+        (void)output_shapes;
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "NonMaxSuppression output shape depends on runtime data");
+    }
+    
+    // 加载期的形状推断不报错，输出留作未知
+    Status InferOutputInfo(const std::vector<TensorInfo>& inputs,
+                           std::vector<TensorInfo>& outputs) const override {
+        (void)inputs;
+        outputs.clear();
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::INT64;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.size() != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "NonMaxSuppression has one output");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t batch = inputs[0]->GetShape().dims[0];
+        const int64_t num_boxes = inputs[0]->GetShape().dims[1];
+        const int64_t num_classes = inputs[1]->GetShape().dims[1];
+        const Tensor* max_boxes_tensor = InputAt(*this, inputs, 2);
+        const Tensor* iou_tensor = InputAt(*this, inputs, 3);
+        const Tensor* score_tensor = InputAt(*this, inputs, 4);
+        const int64_t max_boxes = max_boxes_tensor
+            ? std::max<int64_t>(*static_cast<const int64_t*>(max_boxes_tensor->GetData()), 0) : 0;
+        const float iou_threshold = iou_tensor ? *static_cast<const float*>(iou_tensor->GetData()) : 0.0f;
+        const bool center = GetIntAttribute("center_point_box", 0) != 0;
+        const float* boxes = static_cast<const float*>(inputs[0]->GetData());
+        const float* scores = static_cast<const float*>(inputs[1]->GetData());
+    
+        // 每个(batch, class)选中的框下标
+        std::vector<std::vector<int64_t>> selected(static_cast<size_t>(batch * num_classes));
+        if (max_boxes > 0 && num_boxes > 0) {
+            ParallelForOuter(ctx, batch * num_classes, num_boxes, [&](int64_t begin, int64_t end) {
+                ClassScratch scratch(static_cast<size_t>(num_boxes));
+                for (int64_t task = begin; task < end; ++task) {
+                    const int64_t b = task / num_classes;
+                    SuppressClass(boxes + b * num_boxes * 4, scores + task * num_boxes, num_boxes,
+                                  score_tensor, iou_threshold, max_boxes, center, &scratch,
+                                  &selected[static_cast<size_t>(task)]);
+                }
+            });
+        }
+    
+        int64_t total = 0;
+        for (const auto& indices : selected) {
+            total += static_cast<int64_t>(indices.size());
+        }
+        status = PrepareOutput(Shape({total, 3}), DataType::INT64, outputs[0]);
+        if (!status.IsOk()) {
+            return status;
+        }
+        int64_t* out = static_cast<int64_t*>(outputs[0]->GetData());
+        for (int64_t task = 0; task < batch * num_classes; ++task) {
+            for (int64_t index : selected[static_cast<size_t>(task)]) {
+                *out++ = task / num_classes;
+                *out++ = task % num_classes;
+                *out++ = index;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    // 一个(batch, class)的候选：按分数排序后的坐标（SoA）、面积与原始下标，以及IoU缓冲
+    struct ClassScratch {
+        explicit ClassScratch(size_t n)
+            : y1(n), x1(n), y2(n), x2(n), area(n), iou(n), order(n), passed(n) {}
+        std::vector<float> y1, x1, y2, x2, area, iou;
+        std::vector<Candidate> order;
+        std::vector<uint32_t> passed;
+    };
+    
+    static void SuppressClass(const float* boxes, const float* scores, int64_t num_boxes,
+                              const Tensor* score_tensor, float iou_threshold, int64_t max_boxes,
+                              bool center, ClassScratch* s, std::vector<int64_t>* selected) {
+        // 1. 分数严格大于score_threshold的框（未给出时全部保留）
+        size_t count = static_cast<size_t>(num_boxes);
+        if (score_tensor) {
+            count = simd::SelectGreaterSIMD(scores, count, *static_cast<const float*>(score_tensor->GetData()),
+                                            s->passed.data());
+        } else {
+            std::iota(s->passed.begin(), s->passed.end(), 0u);
+        }
+        if (count == 0) {
+            return;
+        }
+        // 2. 分数从高到低，相等时下标小的在前
+        for (size_t i = 0; i < count; ++i) {
+            s->order[i] = {scores[s->passed[i]], static_cast<int64_t>(s->passed[i])};
+        }
+        std::sort(s->order.begin(), s->order.begin() + static_cast<std::ptrdiff_t>(count), Larger);
+        for (size_t i = 0; i < count; ++i) {
+            const float* box = boxes + s->order[i].index * 4;
+            float y1, x1, y2, x2;
+            if (center) {
+                y1 = box[1] - box[3] * 0.5f;
+                y2 = box[1] + box[3] * 0.5f;
+                x1 = box[0] - box[2] * 0.5f;
+                x2 = box[0] + box[2] * 0.5f;
+            } else {
+                y1 = std::min(box[0], box[2]);
+                y2 = std::max(box[0], box[2]);
+                x1 = std::min(box[1], box[3]);
+                x2 = std::max(box[1], box[3]);
+            }
+            s->y1[i] = y1;
+            s->x1[i] = x1;
+            s->y2[i] = y2;
+            s->x2[i] = x2;
+            s->area[i] = (y2 - y1) * (x2 - x1);
+        }
+        // 3. 存活的候选始终在[0, live)：选中第0个，其余与它的IoU不超过阈值的压缩到前部
+        size_t live = count;
+        while (live > 0 && static_cast<int64_t>(selected->size()) < max_boxes) {
+            selected->push_back(s->order[0].index);
+            const float head[4] = {s->y1[0], s->x1[0], s->y2[0], s->x2[0]};
+            const size_t rest = live - 1;
+            simd::BoxIoUSIMD(head, s->area[0], s->y1.data() + 1, s->x1.data() + 1, s->y2.data() + 1,
+                             s->x2.data() + 1, s->area.data() + 1, s->iou.data(), rest);
+            size_t kept = 0;
+            for (size_t r = 0; r < rest; ++r) {
+                if (s->iou[r] > iou_threshold) {
+                    continue;
+                }
+                s->y1[kept] = s->y1[r + 1];
+                s->x1[kept] = s->x1[r + 1];
+                s->y2[kept] = s->y2[r + 1];
+                s->x2[kept] = s->x2[r + 1];
+                s->area[kept] = s->area[r + 1];
+                s->order[kept] = s->order[r + 1];
+                ++kept;
+            }
+            live = kept;
+        }
+    }
+};
+
+REGISTER_OPERATOR("TopK", TopKOperator);
+REGISTER_OPERATOR("NonMaxSuppression", NonMaxSuppressionOperator);
+
+} // namespace operators
+} // namespace inferunity
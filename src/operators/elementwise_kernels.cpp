@@ -0,0 +1,143 @@
+// 逐元素运算的广播引擎
+// 参考ONNX Runtime的BroadcastHelper：折叠后的形状决定内层循环，见elementwise_kernels.h
+
+#include "elementwise_kernels.h"
+#include <algorithm>
+#include <string>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 右对齐后第d维（相对输出rank）的长度，缺失的高维为1
+int64_t AlignedDim(const Shape& shape, size_t rank, size_t d) {
+    const size_t offset = rank - shape.dims.size();
+    return d < offset ? 1 : shape.dims[d - offset];
+}
+
+std::string ShapeString(const Shape& shape) {
+    std::string text = "[";
+    for (size_t i = 0; i < shape.dims.size(); ++i) {
+        text += (i ? ", " : "") + std::to_string(shape.dims[i]);
+    }
+    return text + "]";
+}
+
+} // anonymous namespace
+
+Status BroadcastShapes(const std::vector<Shape>& shapes, Shape* output) {
+    size_t rank = 0;
+    for (const Shape& shape : shapes) {
+        rank = std::max(rank, shape.dims.size());
+    }
+    std::vector<int64_t> dims(rank, 1);
+    for (const Shape& shape : shapes) {
+        for (size_t d = 0; d < rank; ++d) {
+            const int64_t dim = AlignedDim(shape, rank, d);
+            if (dim == dims[d] || dim == 1) {
+                continue;
+            }
+            if (dims[d] != 1) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Shapes are not broadcastable: " + ShapeString(shape));
+            }
+            dims[d] = dim;
+        }
+    }
+    *output = Shape(dims);
+    return Status::Ok();
+}
+
+Status PlanBroadcast(const std::vector<Shape>& inputs, const Shape& output, BroadcastPlan* plan) {
+    const size_t num_inputs = inputs.size();
+    const size_t rank = output.dims.size();
+    if (num_inputs == 0 || num_inputs > kMaxBroadcastInputs) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Unsupported number of broadcast inputs");
+    }
+    
+    // 折叠：跳过长度为1的输出维，广播状态与前一维相同的维度并入前一维
+    std::vector<int64_t> dims;
+    std::vector<std::vector<bool>> broadcast;  // [折叠维][操作数]
+    for (size_t d = 0; d < rank; ++d) {
+        const int64_t out_dim = output.dims[d];
+        if (out_dim == 1) {
+            continue;
+        }
+        std::vector<bool> flags(num_inputs);
+        for (size_t i = 0; i < num_inputs; ++i) {
+            if (inputs[i].dims.size() > rank) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Input rank exceeds broadcast output rank");
+            }
+            const int64_t dim = AlignedDim(inputs[i], rank, d);
+            if (dim != out_dim && dim != 1) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Input " + ShapeString(inputs[i]) + " does not broadcast to " +
+                                   ShapeString(output));
+            }
+            flags[i] = dim == 1;
+        }
+        if (!dims.empty() && broadcast.back() == flags) {
+            dims.back() *= out_dim;
+        } else {
+            dims.push_back(out_dim);
+            broadcast.push_back(flags);
+        }
+    }
+    if (dims.empty()) {
+        dims.push_back(1);
+        broadcast.push_back(std::vector<bool>(num_inputs, false));
+    }
+    if (dims.size() > kMaxBroadcastRank) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Broadcast rank too large");
+    }
+    
+    const size_t folded = dims.size();
+    plan->inner = dims.back();
+    plan->outer_dims.assign(dims.begin(), dims.end() - 1);
+    plan->outer = 1;
+    for (int64_t dim : plan->outer_dims) {
+        plan->outer *= dim;
+    }
+    plan->inner_scalar.assign(num_inputs, false);
+    plan->strides.assign(num_inputs, std::vector<int64_t>(folded - 1, 0));
+    for (size_t i = 0; i < num_inputs; ++i) {
+        int64_t stride = 1;
+        for (size_t d = folded; d-- > 0;) {
+            const bool is_broadcast = broadcast[d][i];
+            if (d + 1 == folded) {
+                plan->inner_scalar[i] = is_broadcast;
+            } else {
+                plan->strides[i][d] = is_broadcast ? 0 : stride;
+            }
+            if (!is_broadcast) {
+                stride *= dims[d];
+            }
+        }
+    }
+    
+    // 模式分类
+    bool any_broadcast = false, row = folded == 2, column = folded == 2;
+    for (size_t i = 0; i < num_inputs; ++i) {
+        any_broadcast |= plan->inner_scalar[i];
+        if (folded == 2) {
+            const bool outer_broadcast = broadcast[0][i];
+            row &= !plan->inner_scalar[i];
+            column &= !outer_broadcast;
+        }
+    }
+    if (folded == 1) {
+        plan->pattern = any_broadcast ? BroadcastPattern::SCALAR : BroadcastPattern::SAME;
+    } else if (row) {
+        plan->pattern = BroadcastPattern::ROW;
+    } else if (column) {
+        plan->pattern = BroadcastPattern::COLUMN;
+    } else {
+        plan->pattern = BroadcastPattern::GENERAL;
+    }
+    return Status::Ok();
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,106 @@
+// 逐元素运算的广播引擎（Add/Sub/Mul/Div/Pow/Max/Min/Where共用）
+// 参考ONNX Runtime的BroadcastHelper与MLAS的逐元素核：先把输出与各操作数的形状折叠
+// （去掉长度为1的输出维，合并广播状态相同的相邻维），再把折叠结果归为几种模式一次性选好内层循环：
+// - SAME：各操作数与输出同形，整块连续
+// - SCALAR：折叠后只剩一维，部分操作数只有一个元素
+// - ROW：[outer, inner]，部分操作数沿outer广播（如[M, N] + [N]的偏置）
+// - COLUMN：[outer, inner]，部分操作数沿inner广播（如[M, N] * [M, 1]）
+// - GENERAL：其余情况，外层按各操作数的步长逐段推进
+// 内层每段连续inner个元素调用一次SIMD核，外层按段分给算子内线程
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "parallel_utils.h"
+#include <cstdint>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// numpy风格的多向广播：右对齐，每一维的长度相同或其中一个为1
+Status BroadcastShapes(const std::vector<Shape>& shapes, Shape* output);
+
+constexpr size_t kMaxBroadcastInputs = 3;  // Where的cond/x/y
+constexpr size_t kMaxBroadcastRank = 16;
+
+enum class BroadcastPattern { SAME, SCALAR, ROW, COLUMN, GENERAL };
+
+struct BroadcastPlan {
+    BroadcastPattern pattern = BroadcastPattern::SAME;
+    int64_t outer = 1;                          // 段数
+    int64_t inner = 1;                          // 每段连续的输出元素数
+    std::vector<int64_t> outer_dims;            // 折叠后的外层维度（高维在前）
+    std::vector<std::vector<int64_t>> strides;  // [操作数][外层维]的元素步长，沿该维广播时为0
+    std::vector<bool> inner_scalar;             // [操作数]：段内只读一个元素
+};
+
+// inputs（至多kMaxBroadcastInputs个）按右对齐广播到output（output应为BroadcastShapes的结果）
+Status PlanBroadcast(const std::vector<Shape>& inputs, const Shape& output, BroadcastPlan* plan);
+
+// 按计划遍历输出：fn(offsets, output_offset, count)对每段连续元素调用一次，
+// offsets[i]为第i个操作数的起始元素下标（inner_scalar的操作数在段内保持该元素）；
+// SAME/SCALAR的单段按元素区间切块，其余按段切块
+template <typename Fn>
+void ForEachBroadcastRun(const BroadcastPlan& plan, ExecutionContext* ctx, Fn&& fn) {
+    const size_t num_inputs = plan.inner_scalar.size();
+    if (plan.outer == 1) {
+        ParallelForElements(ctx, plan.inner, [&](int64_t begin, int64_t end) {
+            int64_t offsets[kMaxBroadcastInputs];
+            for (size_t i = 0; i < num_inputs; ++i) {
+                offsets[i] = plan.inner_scalar[i] ? 0 : begin;
+            }
+            fn(offsets, begin, end - begin);
+        });
+        return;
+    }
+    ParallelForOuter(ctx, plan.outer, plan.inner, [&](int64_t begin, int64_t end) {
+        int64_t offsets[kMaxBroadcastInputs];
+        switch (plan.pattern) {
+            case BroadcastPattern::ROW:
+            case BroadcastPattern::COLUMN:
+                // 外层只有一维：全量操作数按段偏移，广播的操作数不动（ROW）或逐段前进一个元素（COLUMN）
+                for (int64_t run = begin; run < end; ++run) {
+                    for (size_t i = 0; i < num_inputs; ++i) {
+                        offsets[i] = run * plan.strides[i][0];
+                    }
+                    fn(offsets, run * plan.inner, plan.inner);
+                }
+                return;
+            default:
+                break;
+        }
+        // GENERAL：把begin分解为外层坐标，之后按进位递增
+        const size_t rank = plan.outer_dims.size();
+        int64_t index[kMaxBroadcastRank] = {};
+        int64_t remaining = begin;
+        for (size_t d = rank; d-- > 0;) {
+            index[d] = remaining % plan.outer_dims[d];
+            remaining /= plan.outer_dims[d];
+        }
+        for (size_t i = 0; i < num_inputs; ++i) {
+            offsets[i] = 0;
+            for (size_t d = 0; d < rank; ++d) {
+                offsets[i] += index[d] * plan.strides[i][d];
+            }
+        }
+        for (int64_t run = begin; run < end; ++run) {
+            fn(offsets, run * plan.inner, plan.inner);
+            for (size_t d = rank; d-- > 0;) {
+                for (size_t i = 0; i < num_inputs; ++i) {
+                    offsets[i] += plan.strides[i][d];
+                }
+                if (++index[d] < plan.outer_dims[d]) {
+                    break;
+                }
+                for (size_t i = 0; i < num_inputs; ++i) {
+                    offsets[i] -= plan.strides[i][d] * plan.outer_dims[d];
+                }
+                index[d] = 0;
+            }
+        }
+    });
+}
+
+} // namespace operators
+} // namespace inferunity
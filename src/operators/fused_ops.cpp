@@ -3,14 +3,118 @@
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "conv_kernels.h"
+#include "matmul_kernels.h"
+#include "parallel_utils.h"
+#include "pooling.h"
 #include "simd_utils.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
 
 namespace inferunity {
 namespace operators {
 
+namespace {
+
+// 按Conv属性校验输出形状并运行卷积引擎（算法选择与权重变换按节点缓存）
+Status RunConvKernel(const Operator& op, Conv2DKernel* kernel, Tensor* input, Tensor* weight,
+                     Tensor* output, const ConvEpilogue& epilogue, ExecutionContext* ctx) {
+    Conv2DParams params;
+    Status status = ParseConv2DParams(op, input->GetShape(), weight->GetShape(), &params);
+    if (!status.IsOk()) {
+        return status;
+    }
+    if (output->GetElementCount() !=
+        static_cast<size_t>(params.batch * params.out_c * params.out_h * params.out_w)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           op.GetName() + " output shape does not match attributes");
+    }
+    
+    const float* weight_data = static_cast<const float*>(weight->GetData());
+    ConvAlgorithm requested = ParseConvAlgorithm(op.GetStringAttribute("conv_algorithm", "auto"));
+    std::shared_ptr<const ConvPlan> plan;
+    status = kernel->Prepare(params, requested, weight_data, &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    Conv2DKernel::Run(*plan, static_cast<const float*>(input->GetData()), weight_data,
+                      static_cast<float*>(output->GetData()), epilogue, ctx);
+    return Status::Ok();
+}
+
+Status InferConvOutputShape(const Operator& op, const std::vector<Tensor*>& inputs,
+                            std::vector<Shape>& output_shapes) {
+    if (inputs.size() < 2) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+    }
+    Conv2DParams params;
+    Status status = ParseConv2DParams(op, inputs[0]->GetShape(), inputs[1]->GetShape(), &params);
+    if (!status.IsOk()) {
+        return status;
+    }
+    output_shapes.push_back(Shape({params.batch, params.out_c, params.out_h, params.out_w}));
+    return Status::Ok();
+}
+
+// C = alpha * op(A) * op(B) + beta * bias（bias单向广播到[..., M, N]），epilogue_relu时写回后取ReLU。
+// beta为1时[N]与[M, 1]的bias在GEMM写回时加上；其余情况先把bias广播写入C，再由GEMM以beta累加
+Status RunMatMulWithBias(const std::string& op_name, const MatMulShape& shape, float alpha, const float* A,
+                         const float* B, const Tensor* bias, float beta, bool epilogue_relu, float* C,
+                         size_t output_count, const gemm::PackedMatrix* packed, const MatMulHalfB* half_b) {
+    const int64_t M = shape.M;
+    const int64_t N = shape.N;
+    const size_t matrix_count = static_cast<size_t>(M * N);
+    const float* bias_data = bias && beta != 0.0f ? static_cast<const float*>(bias->GetData()) : nullptr;
+    const size_t bias_count = bias_data ? bias->GetElementCount() : 0;
+    const std::vector<int64_t> bias_dims = bias_data ? bias->GetShape().dims : std::vector<int64_t>();
+    const bool column_bias = bias_count == static_cast<size_t>(M) && M != 1 &&
+                             bias_dims.size() >= 2 && bias_dims.back() == 1;
+    const bool row_bias = bias_count == static_cast<size_t>(N) && !bias_dims.empty() && bias_dims.back() == N;
+    gemm::GemmEpilogue epilogue;
+    epilogue.relu = epilogue_relu;
+    if (bias_count == 0) {
+        RunBatchedMatMul(shape, alpha, A, B, 0.0f, C, epilogue_relu ? &epilogue : nullptr, packed, half_b);
+    } else if (column_bias && beta == 1.0f) {
+        // 列向量bias [M, 1]
+        epilogue.row_bias = bias_data;
+        RunBatchedMatMul(shape, alpha, A, B, 0.0f, C, &epilogue, packed, half_b);
+    } else if (row_bias && beta == 1.0f) {
+        // 行向量bias [N]（全连接层的常见情况）
+        epilogue.col_bias = bias_data;
+        RunBatchedMatMul(shape, alpha, A, B, 0.0f, C, &epilogue, packed, half_b);
+    } else if (bias_count == 1 || bias_count == matrix_count || bias_count == output_count ||
+               column_bias || row_bias) {
+        // 标量、行/列向量、单个[M, N]或完整输出形状的bias：先写入C，再以beta累加
+        if (bias_count == 1) {
+            std::fill(C, C + output_count, bias_data[0]);
+        } else if (column_bias) {
+            for (size_t row = 0; row < output_count / static_cast<size_t>(N); ++row) {
+                std::fill(C + row * N, C + (row + 1) * N, bias_data[row % static_cast<size_t>(M)]);
+            }
+        } else {
+            for (size_t offset = 0; offset < output_count; offset += bias_count) {
+                std::memcpy(C + offset, bias_data, bias_count * sizeof(float));
+            }
+        }
+        RunBatchedMatMul(shape, alpha, A, B, beta, C, epilogue_relu ? &epilogue : nullptr, packed, half_b);
+    } else {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           op_name + " bias is not broadcastable to [M, N]");
+    }
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
 // FusedConvBNReLU算子：融合Conv+BatchNorm+ReLU
 // 参考NCNN的融合实现
 class FusedConvBNReLUOperator : public Operator {
@@ -28,153 +132,805 @@ public:
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        if (inputs.empty()) {
+        if (inputs.size() < 2) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
         }
-        
-        const Shape& input_shape = inputs[0]->GetShape();
-        if (input_shape.dims.size() < 4) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Input must be 4D (NCHW)");
-        }
-        
-        // 输出形状与输入相同（除了通道数可能不同）
-        int64_t batch = input_shape.dims[0];
-        int64_t out_c = inputs.size() >= 2 ? inputs[1]->GetShape().dims[0] : input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        
-        // 简化的输出尺寸计算
-        int64_t kernel_h = inputs[1]->GetShape().dims[2];
-        int64_t kernel_w = inputs[1]->GetShape().dims[3];
-        int64_t stride_h = 1, stride_w = 1;
-        int64_t pad_h = 0, pad_w = 0;
-        
-        int64_t out_h = (in_h + 2 * pad_h - kernel_h) / stride_h + 1;
-        int64_t out_w = (in_w + 2 * pad_w - kernel_w) / stride_w + 1;
-        
-        output_shapes.push_back(Shape({batch, out_c, out_h, out_w}));
+    
+        // 卷积属性由融合Pass从Conv节点复制而来
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, inputs[0]->GetShape(),
+                                          inputs[1]->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        output_shapes.push_back(Shape({params.batch, params.out_c, params.out_h, params.out_w}));
         return Status::Ok();
     }
     
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 卷积之后逐元素做bias、BN的缩放平移与ReLU
+        return EstimateConvCost(inputs, outputs, 1, 4.0);
+    }
+    
+    // 权重（输入1）为常量初始化器时，会话加载时完成Winograd变换/GEMM打包
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        return PrePackConvWeight(*this, &kernel_, input_index, tensor, input_shapes, is_packed);
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateConvMemory(*this, inputs);
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
         if (inputs.size() < 6 || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
+        // 输入：input, weight, bias(可选), scale, B, mean, var
+        // 6个输入时Conv没有bias，BN参数从下标2开始
+        const size_t bn_offset = inputs.size() >= 7 ? 3 : 2;
         Tensor* input = inputs[0];
         Tensor* weight = inputs[1];
-        Tensor* bias = inputs.size() > 2 ? inputs[2] : nullptr;
-        Tensor* scale = inputs[3];
-        Tensor* B = inputs[4];
-        Tensor* mean = inputs[5];
-        Tensor* var = inputs[6];
+        Tensor* bias = bn_offset == 3 ? inputs[2] : nullptr;
+        Tensor* scale = inputs[bn_offset];
+        Tensor* B = inputs[bn_offset + 1];
+        Tensor* mean = inputs[bn_offset + 2];
+        Tensor* var = inputs[bn_offset + 3];
         Tensor* output = outputs[0];
-        
-        // 融合计算：Conv -> BN -> ReLU
-        // 优化实现：预计算BN参数，优化内存访问模式，单次遍历完成所有计算
-        
-        // 先执行Conv（简化版）
-        const Shape& input_shape = input->GetShape();
-        const Shape& weight_shape = weight->GetShape();
-        const Shape& output_shape = output->GetShape();
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t in_c = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        int64_t out_c = output_shape.dims[1];
-        int64_t out_h = output_shape.dims[2];
-        int64_t out_w = output_shape.dims[3];
-        int64_t kernel_h = weight_shape.dims[2];
-        int64_t kernel_w = weight_shape.dims[3];
-        
-        float* input_data = static_cast<float*>(input->GetData());
-        float* weight_data = static_cast<float*>(weight->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        float* bias_data = bias ? static_cast<float*>(bias->GetData()) : nullptr;
-        float* scale_data = static_cast<float*>(scale->GetData());
-        float* B_data = static_cast<float*>(B->GetData());
-        float* mean_data = static_cast<float*>(mean->GetData());
-        float* var_data = static_cast<float*>(var->GetData());
-        
-        float epsilon = 1e-5f;
-        
+    
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, input->GetShape(), weight->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (output->GetElementCount() !=
+            static_cast<size_t>(params.batch * params.out_c * params.out_h * params.out_w)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedConvBNReLU output shape does not match attributes");
+        }
+        const int64_t out_c = params.out_c;
+    
+        const float* bias_data = bias ? static_cast<const float*>(bias->GetData()) : nullptr;
+        const float* scale_data = static_cast<const float*>(scale->GetData());
+        const float* B_data = static_cast<const float*>(B->GetData());
+        const float* mean_data = static_cast<const float*>(mean->GetData());
+        const float* var_data = static_cast<const float*>(var->GetData());
+    
+        float epsilon = GetFloatAttribute("epsilon", 1e-5f);
+    
         // 优化：预计算BN参数，减少循环内计算
         // BN公式：y = scale * (x - mean) / sqrt(var + eps) + B
         // 可以重写为：y = a * x + b，其中：
         // a = scale / sqrt(var + eps)
         // b = B - scale * mean / sqrt(var + eps)
-        std::vector<float> bn_scale(out_c);
-        std::vector<float> bn_bias(out_c);
+        // 再合并Conv的bias：y = a * conv + (a * conv_bias + b)
+        // 折叠结果放在暂存区：并发执行同一节点的线程各自计算
+        ScratchArena& arena = ScratchArena::ForCurrentThread();
+        float* bn_scale = arena.Allocate<float>(static_cast<size_t>(out_c));
+        float* bn_bias = arena.Allocate<float>(static_cast<size_t>(out_c));
         for (int64_t oc = 0; oc < out_c; ++oc) {
             float inv_std = 1.0f / std::sqrt(var_data[oc] + epsilon);
             bn_scale[oc] = scale_data[oc] * inv_std;
             bn_bias[oc] = B_data[oc] - scale_data[oc] * mean_data[oc] * inv_std;
+            if (bias_data) {
+                bn_bias[oc] += bn_scale[oc] * bias_data[oc];
+            }
+        }
+    
+        // 卷积走与Conv相同的计算引擎，BN和ReLU在逐通道后处理中一次完成
+        const float* weight_data = static_cast<const float*>(weight->GetData());
+        ConvAlgorithm requested = ParseConvAlgorithm(GetStringAttribute("conv_algorithm", "auto"));
+        std::shared_ptr<const ConvPlan> plan;
+        status = kernel_.Prepare(params, requested, weight_data, &plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        ConvEpilogue epilogue;
+        epilogue.scale = bn_scale;
+        epilogue.bias = bn_bias;
+        epilogue.relu = true;
+        Conv2DKernel::Run(*plan, static_cast<const float*>(input->GetData()), weight_data,
+                          static_cast<float*>(output->GetData()), epilogue, ctx);
+        return Status::Ok();
+    }
+
+private:
+    Conv2DKernel kernel_;
+};
+
+REGISTER_OPERATOR("FusedConvBNReLU", FusedConvBNReLUOperator);
+
+// FusedConvReLU算子：融合Conv+ReLU，bias与ReLU在卷积写回时完成
+class FusedConvReLUOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedConvReLU"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        // 输入：input, weight, bias(可选)
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedConvReLU requires at least 2 inputs (input and weight)");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        return InferConvOutputShape(*this, inputs, output_shapes);
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        return EstimateConvCost(inputs, outputs, 1, inputs.size() > 2 ? 2.0 : 1.0);
+    }
+    
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        return PrePackConvWeight(*this, &kernel_, input_index, tensor, input_shapes, is_packed);
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateConvMemory(*this, inputs);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+    
+        ConvEpilogue epilogue;
+        epilogue.bias = inputs.size() > 2 ? static_cast<const float*>(inputs[2]->GetData()) : nullptr;
+        epilogue.relu = true;
+        return RunConvKernel(*this, &kernel_, inputs[0], inputs[1], outputs[0], epilogue, ctx);
+    }
+
+private:
+    Conv2DKernel kernel_;
+};
+
+REGISTER_OPERATOR("FusedConvReLU", FusedConvReLUOperator);
+
+// FusedConvAddReLU算子：融合Conv+Add(残差)+ReLU（ResNet残差块）
+// 卷积结果带bias写回后，残差加与ReLU在同一遍中完成，省去Add输出的一次读写
+class FusedConvAddReLUOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedConvAddReLU"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        // 输入：input, weight, bias(可选), residual
+        if (inputs.size() < 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedConvAddReLU requires input, weight and residual");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        return InferConvOutputShape(*this, inputs, output_shapes);
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        return EstimateConvCost(inputs, outputs, 1, inputs.size() > 3 ? 3.0 : 2.0);
+    }
+    
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        return PrePackConvWeight(*this, &kernel_, input_index, tensor, input_shapes, is_packed);
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateConvMemory(*this, inputs);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 3 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+    
+        Tensor* residual = inputs.back();
+        Tensor* output = outputs[0];
+        const size_t count = output->GetElementCount();
+        if (residual->GetElementCount() != count) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedConvAddReLU residual shape does not match output");
+        }
+    
+        ConvEpilogue epilogue;
+        epilogue.bias = inputs.size() > 3 ? static_cast<const float*>(inputs[2]->GetData()) : nullptr;
+        Status status = RunConvKernel(*this, &kernel_, inputs[0], inputs[1], output, epilogue, ctx);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        const float* residual_data = static_cast<const float*>(residual->GetData());
+        float* output_data = static_cast<float*>(output->GetData());
+        ParallelForElements(ctx, static_cast<int64_t>(count), [&](int64_t begin, int64_t end) {
+            const size_t n = static_cast<size_t>(end - begin);
+            simd::AddSIMD(output_data + begin, residual_data + begin, output_data + begin, n);
+            simd::ReluSIMD(output_data + begin, output_data + begin, n);
+        });
+        return Status::Ok();
+    }
+
+private:
+    Conv2DKernel kernel_;
+};
+
+REGISTER_OPERATOR("FusedConvAddReLU", FusedConvAddReLUOperator);
+
+// FusedDepthwisePointwise算子：融合MobileNet的深度卷积(+ReLU) + 1x1卷积(+ReLU)
+// 参考NCNN/MNN对深度可分离块的融合：按输出行分带，一带中所有通道的深度卷积结果留在缓存大小的工作区，
+// 随即作为1x1卷积GEMM的B矩阵写出该带的输出，深度卷积的完整中间结果不写回内存。
+// 输入：input, dw_weight, dw_bias(可选), pw_weight, pw_bias(可选)，input_slots标出实际提供的输入；
+// 卷积属性（strides/pads/dilations/group/auto_pad）属于深度卷积，dw_activation/activation为"relu"或空
+class FusedDepthwisePointwiseOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedDepthwisePointwise"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (!InputAt(inputs, 0) || !InputAt(inputs, 1) || !InputAt(inputs, 3)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise requires input, dw_weight and pw_weight");
+        }
+        if (InputAt(inputs, 0)->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise only supports FLOAT32");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Conv2DParams params;
+        int64_t out_c = 0;
+        Status status = ParseParams(inputs, &params, &out_c);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape({params.batch, out_c, params.out_h, params.out_w}));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 1x1卷积按pw_weight计，再加上深度卷积每个中间元素kernel_h * kernel_w次乘加
+        const size_t pw_index = InputIndex(inputs.size(), 3);
+        OperatorCost cost = EstimateConvCost(inputs, outputs, pw_index, 2.0);
+        const size_t dw_index = InputIndex(inputs.size(), 1);
+        if (pw_index < inputs.size() && dw_index < inputs.size() && !outputs.empty() &&
+            inputs[pw_index].shape.dims.size() == 4 && inputs[dw_index].shape.dims.size() == 4 &&
+            outputs[0].shape.dims.size() == 4 && inputs[pw_index].shape.dims[0] > 0) {
+            const auto& dw = inputs[dw_index].shape.dims;
+            const auto& out = outputs[0].shape.dims;
+            const double intermediate = static_cast<double>(out[0] * inputs[pw_index].shape.dims[1] * out[2] * out[3]);
+            cost.flops += intermediate * (2.0 * static_cast<double>(dw[2] * dw[3]) + 2.0);
+        }
+        return cost;
+    }
+    
+    // 带缓冲计入暂存区（输入形状完整时）
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        OperatorMemory memory;
+        const size_t dw_index = InputIndex(inputs.size(), 1);
+        Conv2DParams p;
+        if (dw_index < inputs.size() && inputs[0].shape.dims.size() == 4 &&
+            std::all_of(inputs[0].shape.dims.begin(), inputs[0].shape.dims.end(), [](int64_t d) { return d > 0; }) &&
+            ParseConv2DParams(*this, inputs[0].shape, inputs[dw_index].shape, &p).IsOk()) {
+            memory.scratch_bytes = static_cast<size_t>(p.out_c * BandRows(p) * p.out_w) * sizeof(float);
+        }
+        return memory;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        Conv2DParams p;
+        int64_t out_c = 0;
+        status = ParseParams(inputs, &p, &out_c);
+        if (!status.IsOk()) {
+            return status;
+        }
+        Tensor* output = outputs[0];
+        if (output->GetElementCount() != static_cast<size_t>(p.batch * out_c * p.out_h * p.out_w)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise output shape does not match attributes");
+        }
+    
+        const float* input = static_cast<const float*>(InputAt(inputs, 0)->GetData());
+        const float* dw_weight = static_cast<const float*>(InputAt(inputs, 1)->GetData());
+        const Tensor* dw_bias_tensor = InputAt(inputs, 2);
+        const float* dw_bias = dw_bias_tensor ? static_cast<const float*>(dw_bias_tensor->GetData()) : nullptr;
+        const float* pw_weight = static_cast<const float*>(InputAt(inputs, 3)->GetData());
+        const Tensor* pw_bias_tensor = InputAt(inputs, 4);
+        const bool dw_relu = GetStringAttribute("dw_activation", "") == "relu";
+    
+        // 1x1卷积的权重[out_c, mid_c]作为A矩阵打包一次（权重视为常量，按地址判断是否失效）；
+        // 打包结果在锁内替换，本次执行持有取得的结果
+        const int64_t mid_c = p.out_c;
+        std::shared_ptr<const gemm::PackedMatrix> packed_pw;
+        if (!gemm::UsesExternalBlas()) {
+            std::lock_guard<std::mutex> lock(packed_mutex_);
+            if (!packed_pw_ || packed_source_ != pw_weight || packed_pw_->rows != out_c || packed_pw_->cols != mid_c) {
+                auto packed = std::make_shared<gemm::PackedMatrix>();
+                gemm::PackMatrixA(false, out_c, mid_c, pw_weight, mid_c, packed.get());
+                packed_pw_ = std::move(packed);
+                packed_source_ = pw_weight;
+            }
+            packed_pw = packed_pw_;
+        }
+        gemm::GemmEpilogue epilogue;
+        epilogue.row_bias = pw_bias_tensor ? static_cast<const float*>(pw_bias_tensor->GetData()) : nullptr;
+        epilogue.relu = GetStringAttribute("activation", "") == "relu";
+    
+        // 带缓冲从调用线程的暂存区切出，并发执行同一节点的线程互不干扰
+        const int64_t band = BandRows(p);
+        float* mid = ScratchArena::ForCurrentThread().Allocate<float>(static_cast<size_t>(mid_c * band * p.out_w));
+        const int64_t multiplier = p.out_c / p.in_c;
+        const int64_t kernel_size = p.kernel_h * p.kernel_w;
+        const int64_t spatial = p.out_h * p.out_w;
+        float* output_data = static_cast<float*>(output->GetData());
+    
+        for (int64_t n = 0; n < p.batch; ++n) {
+            const float* in_n = input + n * p.in_c * p.in_h * p.in_w;
+            float* out_n = output_data + n * out_c * spatial;
+            for (int64_t row = 0; row < p.out_h; row += band) {
+                const int64_t rows = std::min(band, p.out_h - row);
+                const int64_t cols = rows * p.out_w;
+                ParallelForOuter(ctx, mid_c, cols * kernel_size, [&](int64_t begin, int64_t end) {
+                    for (int64_t c = begin; c < end; ++c) {
+                        DepthwiseConvRows(p, in_n + (c / multiplier) * p.in_h * p.in_w, dw_weight + c * kernel_size,
+                                          1.0f, dw_bias ? dw_bias[c] : 0.0f, dw_relu, row, row + rows,
+                                          mid + c * cols);
+                    }
+                });
+                // out[:, row * out_w ...] = W_pw[out_c, mid_c] * mid[mid_c, cols]
+                float* out_band = out_n + row * p.out_w;
+                if (packed_pw) {
+                    gemm::SgemmPrepacked(false, false, out_c, cols, mid_c, 1.0f,
+                                         nullptr, mid_c, packed_pw.get(), mid, cols, nullptr,
+                                         0.0f, out_band, spatial, &epilogue);
+                } else {
+                    gemm::Sgemm(false, false, out_c, cols, mid_c, 1.0f, pw_weight, mid_c,
+                                mid, cols, 0.0f, out_band, spatial, &epilogue);
+                }
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    // 每带的中间结果[mid_c, band * out_w]不超过kBandBytes，留在L2中
+    static int64_t BandRows(const Conv2DParams& p) {
+        constexpr int64_t kBandBytes = 256 * 1024;
+        const int64_t row_bytes = p.out_c * p.out_w * static_cast<int64_t>(sizeof(float));
+        return std::max<int64_t>(1, std::min<int64_t>(p.out_h, kBandBytes / std::max<int64_t>(row_bytes, 1)));
+    }
+    
+    // 逻辑输入slot（0..4）在实际输入中的下标；没有input_slots属性时输入按slot依次排列
+    size_t InputIndex(size_t input_count, int64_t slot) const {
+        std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        if (slots.empty()) {
+            return static_cast<size_t>(slot);
+        }
+        for (size_t i = 0; i < slots.size() && i < input_count; ++i) {
+            if (slots[i] == slot) {
+                return i;
+            }
+        }
+        return input_count;
+    }
+    
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        const size_t index = InputIndex(inputs.size(), slot);
+        return index < inputs.size() && inputs[index] && inputs[index]->GetElementCount() > 0 ? inputs[index]
+                                                                                                 : nullptr;
+    }
+    
+    // 深度卷积参数（p.out_c为中间通道数）与1x1卷积的输出通道数
+    Status ParseParams(const std::vector<Tensor*>& inputs, Conv2DParams* p, int64_t* out_c) const {
+        const Tensor* input = InputAt(inputs, 0);
+        const Tensor* dw_weight = InputAt(inputs, 1);
+        const Tensor* pw_weight = InputAt(inputs, 3);
+        if (!input || !dw_weight || !pw_weight) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise requires input, dw_weight and pw_weight");
+        }
+        Status status = ParseConv2DParams(*this, input->GetShape(), dw_weight->GetShape(), p);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (!IsConvAlgorithmApplicable(ConvAlgorithm::DEPTHWISE, *p)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise first convolution must be depthwise");
+        }
+        const std::vector<int64_t>& pw = pw_weight->GetShape().dims;
+        if (pw.size() != 4 || pw[1] != p->out_c || pw[2] != 1 || pw[3] != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedDepthwisePointwise pw_weight must be [out_c, mid_c, 1, 1]");
+        }
+        *out_c = pw[0];
+        return Status::Ok();
+    }
+    
+    std::mutex packed_mutex_;
+    std::shared_ptr<const gemm::PackedMatrix> packed_pw_;
+    const float* packed_source_ = nullptr;
+};
+
+REGISTER_OPERATOR("FusedDepthwisePointwise", FusedDepthwisePointwiseOperator);
+
+// FusedTileGroup算子：CNN主干上连续的卷积/池化按深度优先分块执行（参考Halide的compute_at与
+// fused-layer CNN加速器的跨层分块）。最后一级的输出按行分块，逐块反推各级所需的输入行（含窗口重叠的halo行），
+// 依次算出各级的这一段行；中间结果只存在于缓存大小的块缓冲中，完整的中间特征图不写回内存，
+// 代价是相邻块的halo行重复计算。
+// 输入：input，随后每个卷积级依次为weight与可选的bias。各级属性按级展开：
+// stage_types（0卷积、1最大池化、2平均池化）、stage_kernels/stage_strides/stage_dilations各2个、
+// stage_pads各4个（上、左、下、右）、stage_groups/stage_has_bias/stage_relu/stage_count_include_pad各1个。
+// tile_rows为0时按tile_bytes（默认256KB，约为一个核的L2）选工作集放得下的最大块
+class FusedTileGroupOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedTileGroup"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || !inputs[0] || inputs[0]->GetShape().dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup requires a 4-D input");
+        }
+        for (const Tensor* input : inputs) {
+            if (!input || input->GetDataType() != DataType::FLOAT32) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup only supports FLOAT32");
+            }
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        std::vector<Shape> shapes;
+        for (const Tensor* input : inputs) {
+            shapes.push_back(input ? input->GetShape() : Shape());
+        }
+        std::vector<Stage> stages;
+        int64_t batch = 0;
+        Status status = ParseStages(shapes, &stages, &batch);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Conv2DParams& last = stages.back().params;
+        output_shapes.push_back(Shape({batch, last.out_c, last.out_h, last.out_w}));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        OperatorCost cost;
+        std::vector<Shape> shapes;
+        for (const TensorInfo& input : inputs) {
+            shapes.push_back(input.shape);
+        }
+        std::vector<Stage> stages;
+        int64_t batch = 0;
+        if (!ParseStages(shapes, &stages, &batch).IsOk()) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        // 只读输入与权重、只写最终输出；halo行的重复计算不计入
+        for (const Stage& stage : stages) {
+            const Conv2DParams& p = stage.params;
+            const double outputs_count = static_cast<double>(batch * p.out_c * p.out_h * p.out_w);
+            const double window = static_cast<double>(p.kernel_h * p.kernel_w);
+            cost.flops += stage.type == kConvStage ? outputs_count * 2.0 * window * static_cast<double>(p.in_c / p.group)
+                                                   : outputs_count * window;
+        }
+        for (const TensorInfo& input : inputs) {
+            cost.bytes_read += static_cast<size_t>(std::max<int64_t>(0, input.shape.GetElementCount())) * sizeof(float);
+        }
+        for (const TensorInfo& output : outputs) {
+            cost.bytes_written += static_cast<size_t>(std::max<int64_t>(0, output.shape.GetElementCount())) * sizeof(float);
+        }
+        return cost;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<Shape> shapes;
+        for (const Tensor* input : inputs) {
+            shapes.push_back(input->GetShape());
+        }
+        std::vector<Stage> stages;
+        int64_t batch = 0;
+        status = ParseStages(shapes, &stages, &batch);
+        if (!status.IsOk()) {
+            return status;
         }
-        
-        // 融合计算：在卷积循环中直接应用BN和ReLU
-        // 优化：单次遍历，减少内存访问
-        std::memset(output_data, 0, output->GetSizeInBytes());
-        
-        // 优化：按通道处理，改善缓存局部性
+        const Conv2DParams& first = stages.front().params;
+        const Conv2DParams& last = stages.back().params;
+        Tensor* output = outputs[0];
+        if (output->GetElementCount() != static_cast<size_t>(batch * last.out_c * last.out_h * last.out_w)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedTileGroup output shape does not match attributes");
+        }
+    
+        const size_t count = stages.size();
+        const int64_t tile = SelectTileRows(stages);
+        // rows_begin[i]/rows_end[i]为第i级输入在整图中的行范围，下标count为最终输出
+        std::vector<int64_t> rows_begin(count + 1), rows_end(count + 1);
+        // 各级的块缓冲（下标count为最终输出块）每块从暂存区切出，块结束时回收
+        std::vector<float*> buffers(count + 1);
+        const float* input_data = static_cast<const float*>(inputs[0]->GetData());
+        float* output_data = static_cast<float*>(output->GetData());
+    
         for (int64_t n = 0; n < batch; ++n) {
-            for (int64_t oc = 0; oc < out_c; ++oc) {
-                // 预计算BN参数（每个通道只需计算一次）
-                float bn_a = bn_scale[oc];
-                float bn_b = bn_bias[oc];
-                float conv_bias = bias_data ? bias_data[oc] : 0.0f;
-                
-                // 合并BN bias和conv bias
-                float combined_bias = bn_a * conv_bias + bn_b;
-                
-                for (int64_t oh = 0; oh < out_h; ++oh) {
-                    for (int64_t ow = 0; ow < out_w; ++ow) {
-                        float sum = 0.0f;
-                        
-                        // Conv计算（优化内存访问模式）
-                        for (int64_t ic = 0; ic < in_c; ++ic) {
-                            const float* input_channel = input_data + ((n * in_c + ic) * in_h) * in_w;
-                            const float* weight_channel = weight_data + ((oc * in_c + ic) * kernel_h) * kernel_w;
-                            
-                            for (int64_t kh = 0; kh < kernel_h; ++kh) {
-                                int64_t ih = oh + kh;
-                                if (ih < 0 || ih >= in_h) continue;
-                                
-                                const float* input_row = input_channel + ih * in_w;
-                                const float* weight_row = weight_channel + kh * kernel_w;
-                                
-                                for (int64_t kw = 0; kw < kernel_w; ++kw) {
-                                    int64_t iw = ow + kw;
-                                    if (iw >= 0 && iw < in_w) {
-                                        sum += input_row[iw] * weight_row[kw];
-                                    }
-                                }
-                            }
-                        }
-                        
-                        // 融合BN和ReLU：y = max(0, a * (x + conv_bias) + bn_b)
-                        // 由于已经合并了bias，简化为：y = max(0, bn_a * x + combined_bias)
-                        float fused_output = bn_a * sum + combined_bias;
-                        float relu_output = (fused_output > 0.0f) ? fused_output : 0.0f;
-                        
-                        int64_t output_idx = ((n * out_c + oc) * out_h + oh) * out_w + ow;
-                        output_data[output_idx] = relu_output;
+            const float* in_n = input_data + n * first.in_c * first.in_h * first.in_w;
+            float* out_n = output_data + n * last.out_c * last.out_h * last.out_w;
+            for (int64_t row = 0; row < last.out_h; row += tile) {
+                rows_begin[count] = row;
+                rows_end[count] = std::min(row + tile, last.out_h);
+                for (size_t i = count; i-- > 0;) {
+                    const Conv2DParams& p = stages[i].params;
+                    rows_begin[i] = std::max<int64_t>(0, WindowBegin(p, rows_begin[i + 1]));
+                    rows_end[i] = std::min(p.in_h, WindowEnd(p, rows_end[i + 1]));
+                }
+                ScratchScope tile_scratch;
+                buffers[0] = tile_scratch.GetArena().Allocate<float>(
+                    static_cast<size_t>(first.in_c * (rows_end[0] - rows_begin[0]) * first.in_w));
+                CopyRows(in_n, first.in_c, first.in_h, first.in_w, rows_begin[0], rows_end[0], buffers[0]);
+                for (size_t i = 0; i < count; ++i) {
+                    const Conv2DParams& p = stages[i].params;
+                    buffers[i + 1] = tile_scratch.GetArena().Allocate<float>(
+                        static_cast<size_t>(p.out_c * (rows_end[i + 1] - rows_begin[i + 1]) * p.out_w));
+                    status = RunStage(i, stages[i], inputs, rows_begin[i], rows_end[i], rows_begin[i + 1],
+                                      rows_end[i + 1], buffers[i], buffers[i + 1], ctx);
+                    if (!status.IsOk()) {
+                        return status;
                     }
                 }
+                const int64_t rows = rows_end[count] - row;
+                for (int64_t c = 0; c < last.out_c; ++c) {
+                    std::memcpy(out_n + (c * last.out_h + row) * last.out_w, buffers[count] + c * rows * last.out_w,
+                                static_cast<size_t>(rows * last.out_w) * sizeof(float));
+                }
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    static constexpr int64_t kConvStage = 0;
+    static constexpr int64_t kMaxPoolStage = 1;
+    static constexpr int64_t kAveragePoolStage = 2;
+    
+    // 一级的整图参数（batch为1）；池化级同样用Conv2DParams描述窗口，in_c与out_c都是通道数
+    struct Stage {
+        int64_t type = kConvStage;
+        Conv2DParams params;
+        bool relu = false;
+        bool count_include_pad = false;
+        size_t weight_index = 0;   // 卷积级的权重输入下标
+        size_t bias_index = 0;     // 没有bias时为0
+    };
+    
+    // 输出行r的窗口在输入中的起始行与[r_begin, r_end)窗口覆盖的结束行（不截断到整图范围）
+    static int64_t WindowBegin(const Conv2DParams& p, int64_t r_begin) {
+        return r_begin * p.stride_h - p.pad_top;
+    }
+    
+    static int64_t WindowEnd(const Conv2DParams& p, int64_t r_end) {
+        return (r_end - 1) * p.stride_h - p.pad_top + (p.kernel_h - 1) * p.dilation_h + 1;
+    }
+    
+    static void CopyRows(const float* src, int64_t channels, int64_t height, int64_t width, int64_t begin,
+                         int64_t end, float* dst) {
+        const int64_t rows = end - begin;
+        for (int64_t c = 0; c < channels; ++c) {
+            std::memcpy(dst + c * rows * width, src + (c * height + begin) * width,
+                        static_cast<size_t>(rows * width) * sizeof(float));
+        }
+    }
+    
+    Status ParseStages(const std::vector<Shape>& shapes, std::vector<Stage>* stages, int64_t* batch) const {
+        const std::vector<int64_t> types = GetIntsAttribute("stage_types", {});
+        const std::vector<int64_t> kernels = GetIntsAttribute("stage_kernels", {});
+        const std::vector<int64_t> strides = GetIntsAttribute("stage_strides", {});
+        const std::vector<int64_t> dilations = GetIntsAttribute("stage_dilations", {});
+        const std::vector<int64_t> pads = GetIntsAttribute("stage_pads", {});
+        const std::vector<int64_t> groups = GetIntsAttribute("stage_groups", {});
+        const std::vector<int64_t> has_bias = GetIntsAttribute("stage_has_bias", {});
+        const std::vector<int64_t> relu = GetIntsAttribute("stage_relu", {});
+        const std::vector<int64_t> include_pad = GetIntsAttribute("stage_count_include_pad", {});
+        const size_t count = types.size();
+        if (count == 0 || kernels.size() != 2 * count || strides.size() != 2 * count ||
+            dilations.size() != 2 * count || pads.size() != 4 * count || groups.size() != count ||
+            has_bias.size() != count || relu.size() != count || include_pad.size() != count) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup has inconsistent stage attributes");
+        }
+        if (shapes.empty() || shapes[0].dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup requires a 4-D input");
+        }
+        *batch = shapes[0].dims[0];
+        int64_t channels = shapes[0].dims[1];
+        int64_t height = shapes[0].dims[2];
+        int64_t width = shapes[0].dims[3];
+        size_t next_input = 1;
+        stages->clear();
+        for (size_t i = 0; i < count; ++i) {
+            Stage stage;
+            stage.type = types[i];
+            stage.relu = relu[i] != 0;
+            stage.count_include_pad = include_pad[i] != 0;
+            Conv2DParams& p = stage.params;
+            p.batch = 1;
+            p.in_c = channels;
+            p.in_h = height;
+            p.in_w = width;
+            p.kernel_h = kernels[2 * i];
+            p.kernel_w = kernels[2 * i + 1];
+            p.stride_h = strides[2 * i];
+            p.stride_w = strides[2 * i + 1];
+            p.dilation_h = dilations[2 * i];
+            p.dilation_w = dilations[2 * i + 1];
+            p.pad_top = pads[4 * i];
+            p.pad_left = pads[4 * i + 1];
+            p.pad_bottom = pads[4 * i + 2];
+            p.pad_right = pads[4 * i + 3];
+            p.group = groups[i];
+            p.out_c = channels;
+            if (stage.type == kConvStage) {
+                stage.weight_index = next_input++;
+                stage.bias_index = has_bias[i] ? next_input++ : 0;
+                if (stage.weight_index >= shapes.size() || stage.bias_index >= shapes.size()) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup is missing stage weights");
+                }
+                const std::vector<int64_t>& w = shapes[stage.weight_index].dims;
+                if (p.group <= 0 || w.size() != 4 || w[1] * p.group != channels || w[0] % p.group != 0 ||
+                    w[2] != p.kernel_h || w[3] != p.kernel_w) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                       "FusedTileGroup weight shape does not match stage " + std::to_string(i));
+                }
+                p.out_c = w[0];
+            } else if (stage.type != kMaxPoolStage && stage.type != kAveragePoolStage) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedTileGroup stage type " + std::to_string(stage.type) + " is not supported");
+            }
+            if (p.stride_h <= 0 || p.stride_w <= 0 || p.dilation_h <= 0 || p.dilation_w <= 0) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup has invalid strides or dilations");
+            }
+            p.out_h = (height + p.pad_top + p.pad_bottom - (p.kernel_h - 1) * p.dilation_h - 1) / p.stride_h + 1;
+            p.out_w = (width + p.pad_left + p.pad_right - (p.kernel_w - 1) * p.dilation_w - 1) / p.stride_w + 1;
+            if (p.out_h <= 0 || p.out_w <= 0) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedTileGroup stage " + std::to_string(i) + " has an empty output");
+            }
+            channels = p.out_c;
+            height = p.out_h;
+            width = p.out_w;
+            stages->push_back(stage);
+        }
+        if (next_input != shapes.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "FusedTileGroup input count does not match stages");
+        }
+        return Status::Ok();
+    }
+    
+    // 工作集（各级输入块与最终输出块）不超过tile_bytes的最大块行数；块越大halo重复计算越少
+    int64_t SelectTileRows(const std::vector<Stage>& stages) const {
+        const int64_t out_h = stages.back().params.out_h;
+        const int64_t requested = GetIntAttribute("tile_rows", 0);
+        if (requested > 0) {
+            return std::min(requested, out_h);
+        }
+        const int64_t budget = GetIntAttribute("tile_bytes", 256 * 1024);
+        for (int64_t tile = out_h; tile > 1; --tile) {
+            const Conv2DParams& last = stages.back().params;
+            int64_t bytes = last.out_c * tile * last.out_w;
+            int64_t rows = tile;
+            for (size_t i = stages.size(); i-- > 0;) {
+                const Conv2DParams& p = stages[i].params;
+                rows = std::min(p.in_h, (rows - 1) * p.stride_h + (p.kernel_h - 1) * p.dilation_h + 1);
+                bytes += p.in_c * rows * p.in_w;
+            }
+            if (bytes * static_cast<int64_t>(sizeof(float)) <= budget) {
+                return tile;
+            }
+        }
+        return 1;
+    }
+    
+    // 第index级：输入为整图行[in_begin, in_end)，计算输出行[out_begin, out_end)；
+    // 块边界处越过整图的窗口部分按原padding补零，块内部的边界不补零（halo行已在输入块中）
+    Status RunStage(size_t index, const Stage& stage, const std::vector<Tensor*>& inputs, int64_t in_begin,
+                    int64_t in_end, int64_t out_begin, int64_t out_end, const float* input, float* output,
+                    ExecutionContext* ctx) {
+        Conv2DParams p = stage.params;
+        p.pad_top = in_begin - WindowBegin(stage.params, out_begin);
+        p.pad_bottom = WindowEnd(stage.params, out_end) - in_end;
+        p.in_h = in_end - in_begin;
+        p.out_h = out_end - out_begin;
+    
+        if (stage.type == kConvStage) {
+            Conv2DKernel* kernel = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(kernels_mutex_);
+                std::unique_ptr<Conv2DKernel>& slot = kernels_[std::make_tuple(index, p.in_h, p.pad_top, p.pad_bottom)];
+                if (!slot) {
+                    slot = std::make_unique<Conv2DKernel>();
+                }
+                kernel = slot.get();
+            }
+            const float* weight = static_cast<const float*>(inputs[stage.weight_index]->GetData());
+            std::shared_ptr<const ConvPlan> plan;
+            Status status = kernel->Prepare(p, ConvAlgorithm::AUTO, weight, &plan);
+            if (!status.IsOk()) {
+                return status;
+            }
+            ConvEpilogue epilogue;
+            epilogue.bias = stage.bias_index ? static_cast<const float*>(inputs[stage.bias_index]->GetData()) : nullptr;
+            epilogue.relu = stage.relu;
+            Conv2DKernel::Run(*plan, input, weight, output, epilogue, ctx);
+            return Status::Ok();
+        }
+    
+        Pool2DParams pool;
+        pool.batch = 1;
+        pool.channels = p.in_c;
+        pool.in_h = p.in_h;
+        pool.in_w = p.in_w;
+        pool.out_h = p.out_h;
+        pool.out_w = p.out_w;
+        pool.kernel_h = p.kernel_h;
+        pool.kernel_w = p.kernel_w;
+        pool.stride_h = p.stride_h;
+        pool.stride_w = p.stride_w;
+        pool.pad_top = p.pad_top;
+        pool.pad_left = p.pad_left;
+        pool.pad_bottom = p.pad_bottom;
+        pool.pad_right = p.pad_right;
+        pool.count_include_pad = stage.count_include_pad;
+        Pool2DNchw(pool, stage.type == kMaxPoolStage, input, output, ctx);
+        if (stage.relu) {
+            const int64_t size = p.out_c * p.out_h * p.out_w;
+            for (int64_t i = 0; i < size; ++i) {
+                output[i] = std::max(output[i], 0.0f);
             }
         }
-        
         return Status::Ok();
     }
+    
+    // 每级按块形状（首块、中间块、末块的输入行数与补零不同）各缓存一个卷积内核；
+    // 内核一经创建不再删除，查找在锁内，之后的Prepare/Run由内核自身保证并发安全
+    std::mutex kernels_mutex_;
+    std::map<std::tuple<size_t, int64_t, int64_t, int64_t>, std::unique_ptr<Conv2DKernel>> kernels_;
 };
 
-REGISTER_OPERATOR("FusedConvBNReLU", FusedConvBNReLUOperator);
+REGISTER_OPERATOR("FusedTileGroup", FusedTileGroupOperator);
 
 // FusedMatMulAdd算子：融合MatMul+Add（类似GEMM）
-// 参考ONNX Runtime的Gemm融合
+// 参考ONNX Runtime的Gemm融合；A/B的形状语义与MatMul一致（N维批量广播、transA/transB）
 class FusedMatMulAddOperator : public Operator {
 public:
     std::string GetName() const override { return "FusedMatMulAdd"; }
@@ -184,78 +940,642 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "FusedMatMulAdd requires 3 inputs (A, B, bias)");
         }
+        if (!IsSupportedMatMulBType(inputs[1]->GetDataType())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedMatMulAdd B must be FLOAT32/FLOAT16/BFLOAT16");
+        }
         return Status::Ok();
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        const Shape& shape0 = inputs[0]->GetShape();
-        const Shape& shape1 = inputs[1]->GetShape();
-        
-        if (shape0.dims.size() < 2 || shape1.dims.size() < 2) {
+        if (inputs.size() < 2) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Inputs must be at least 2D");
+                               "FusedMatMulAdd requires A and B");
+        }
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(),
+                                           TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
         }
-        
-        // [M, K] x [K, N] = [M, N]
-        std::vector<int64_t> output_dims = {shape0.dims[0], shape1.dims[1]};
-        output_shapes.push_back(Shape(output_dims));
+        output_shapes.push_back(Shape(shape.output_dims));
         return Status::Ok();
     }
     
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        if (inputs.empty() || inputs[0].shape.dims.empty()) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        const auto& dims = inputs[0].shape.dims;
+        const int64_t k = TransA() && dims.size() >= 2 ? dims[dims.size() - 2] : dims.back();
+        const std::string activation = GetStringAttribute("activation", "");
+        const double activation_flops =
+            activation.empty() ? 0.0 : GetElementwiseFlops(activation == "gelu" ? "Gelu" : "Relu");
+        return EstimateMatMulCost(inputs, outputs, k, 1.0 + activation_flops);
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
         if (inputs.size() < 3 || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         Tensor* A = inputs[0];
         Tensor* B = inputs[1];
         Tensor* bias = inputs[2];
         Tensor* output = outputs[0];
-        
-        const Shape& shape0 = A->GetShape();
-        const Shape& shape1 = B->GetShape();
-        
-        int64_t M = shape0.dims[0];
-        int64_t K = shape0.dims[1];
-        int64_t N = shape1.dims[1];
-        
+    
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(A->GetShape(), B->GetShape(), TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (output->GetShape().dims != shape.output_dims) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedMatMulAdd output shape mismatch");
+        }
+    
         const float* A_data = static_cast<const float*>(A->GetData());
-        const float* B_data = static_cast<const float*>(B->GetData());
-        const float* bias_data = static_cast<const float*>(bias->GetData());
         float* C_data = static_cast<float*>(output->GetData());
-        
-        // 融合计算：MatMul + Add（类似GEMM）
-        // 使用SIMD优化（如果可用）
-        if (M * N * K > 1000) {  // 对于大矩阵使用SIMD
-            // 先计算MatMul
-            simd::MatMulSIMD(A_data, B_data, C_data, M, K, N);
-            // 然后添加bias
-            if (bias_data) {
-                for (int64_t i = 0; i < M; ++i) {
-                    simd::AddSIMD(C_data + i * N, bias_data, C_data + i * N, N);
+        const gemm::PackedMatrix* packed = packed_b_.Get(B, shape);
+        MatMulHalfB half_storage;
+        const MatMulHalfB* half_b = packed_b_.GetHalf(B, shape, &half_storage) ? &half_storage : nullptr;
+        const float* B_data = half_b ? nullptr : static_cast<const float*>(B->GetData());
+        const size_t output_count = output->GetElementCount();
+    
+        // 融合计算：MatMul + Add（类似GEMM），bias在GEMM写回时按广播方式加上
+        status = RunMatMulWithBias(GetName(), shape, GetFloatAttribute("alpha", 1.0f), A_data, B_data, bias, 1.0f,
+                                   false, C_data, output_count, packed, half_b);
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        // 融合Pass折叠进来的激活（activation="gelu"/"relu"），在GEMM输出上原位完成
+        const std::string activation = GetStringAttribute("activation", "");
+        if (activation.empty()) {
+            return Status::Ok();
+        }
+        if (activation != "gelu" && activation != "relu") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "FusedMatMulAdd activation not supported: " + activation);
+        }
+        const bool tanh_approximation = GetStringAttribute("approximate", "none") == "tanh";
+        ParallelForElements(ctx, static_cast<int64_t>(output_count), [&](int64_t begin, int64_t end) {
+            const size_t n = static_cast<size_t>(end - begin);
+            if (activation == "gelu") {
+                simd::GeluSIMD(C_data + begin, C_data + begin, n, tanh_approximation);
+            } else {
+                simd::ReluSIMD(C_data + begin, C_data + begin, n);
+            }
+        });
+        return Status::Ok();
+    }
+    
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        return input_index == 1 ? packed_b_.PrePack(tensor, TransB(), is_packed, Bf16Compute())
+                                : Status::Ok();
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateMatMulMemory(inputs, TransB(), Bf16Compute());
+    }
+
+private:
+    bool TransA() const { return GetIntAttribute("transA", 0) != 0; }
+    bool TransB() const { return GetIntAttribute("transB", 0) != 0; }
+    bool Bf16Compute() const { return GetStringAttribute("compute_precision", "") == "bf16"; }
+    
+    MatMulPrepackedB packed_b_;
+};
+
+REGISTER_OPERATOR("FusedMatMulAdd", FusedMatMulAddOperator);
+
+// Gemm算子（ONNX opset 7-13）：Y = alpha * op(A) * op(B) + beta * C，A、B为二维，C可选且单向广播到[M, N]。
+// transA/transB直接交给打包的GEMM（打包时按转置读取，不做物理转置），alpha在微内核中缩放，
+// C作为写回时的bias或以beta累加进输出；融合Pass折叠进来的activation="relu"在写回时完成，"gelu"随后原位计算
+class GemmOperator : public Operator {
+public:
+    std::string GetName() const override { return "Gemm"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2 || inputs[0]->GetShape().dims.size() != 2 || inputs[1]->GetShape().dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Gemm requires 2-D A and B");
+        }
+        if (inputs[0]->GetDataType() != DataType::FLOAT32 || !IsSupportedMatMulBType(inputs[1]->GetDataType()) ||
+            (inputs.size() > 2 && inputs[2] && inputs[2]->GetDataType() != DataType::FLOAT32)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Gemm requires FLOAT32 A/C and FLOAT32/FLOAT16/BFLOAT16 B");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 2 || inputs[0]->GetShape().dims.size() != 2 || inputs[1]->GetShape().dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Gemm requires 2-D A and B");
+        }
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(),
+                                           TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape(shape.output_dims));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        if (inputs.empty() || inputs[0].shape.dims.size() != 2) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        const int64_t k = inputs[0].shape.dims[TransA() ? 0 : 1];
+        const std::string activation = GetStringAttribute("activation", "");
+        const double activation_flops =
+            activation.empty() ? 0.0 : GetElementwiseFlops(activation == "gelu" ? "Gelu" : "Relu");
+        return EstimateMatMulCost(inputs, outputs, k, (inputs.size() > 2 ? 2.0 : 0.0) + activation_flops);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        Tensor* A = inputs[0];
+        Tensor* B = inputs[1];
+        const Tensor* C = inputs.size() > 2 && inputs[2] && inputs[2]->GetElementCount() > 0 ? inputs[2] : nullptr;
+        Tensor* output = outputs[0];
+        MatMulShape shape;
+        status = ComputeMatMulShape(A->GetShape(), B->GetShape(), TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (output->GetShape().dims != shape.output_dims) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Gemm output shape mismatch");
+        }
+        // C的各维须能单向广播到[M, N]
+        if (C) {
+            const std::vector<int64_t>& c_dims = C->GetShape().dims;
+            const int64_t target[2] = {shape.M, shape.N};
+            bool broadcastable = c_dims.size() <= 2;
+            for (size_t i = 0; broadcastable && i < c_dims.size(); ++i) {
+                const int64_t dim = c_dims[c_dims.size() - 1 - i];
+                broadcastable = dim == 1 || dim == target[1 - i];
+            }
+            if (!broadcastable) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Gemm C is not broadcastable to [M, N]");
+            }
+        }
+        const std::string activation = GetStringAttribute("activation", "");
+        if (!activation.empty() && activation != "gelu" && activation != "relu") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Gemm activation not supported: " + activation);
+        }
+    
+        float* Y = static_cast<float*>(output->GetData());
+        const gemm::PackedMatrix* packed = packed_b_.Get(B, shape);
+        MatMulHalfB half_storage;
+        const MatMulHalfB* half_b = packed_b_.GetHalf(B, shape, &half_storage) ? &half_storage : nullptr;
+        const float* B_data = half_b ? nullptr : static_cast<const float*>(B->GetData());
+        const size_t output_count = output->GetElementCount();
+        status = RunMatMulWithBias(GetName(), shape, GetFloatAttribute("alpha", 1.0f),
+                                   static_cast<const float*>(A->GetData()), B_data, C,
+                                   GetFloatAttribute("beta", 1.0f), activation == "relu", Y, output_count,
+                                   packed, half_b);
+        if (!status.IsOk() || activation != "gelu") {
+            return status;
+        }
+        const bool tanh_approximation = GetStringAttribute("approximate", "none") == "tanh";
+        ParallelForElements(ctx, static_cast<int64_t>(output_count), [&](int64_t begin, int64_t end) {
+            simd::GeluSIMD(Y + begin, Y + begin, static_cast<size_t>(end - begin), tanh_approximation);
+        });
+        return Status::Ok();
+    }
+    
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        return input_index == 1 ? packed_b_.PrePack(tensor, TransB(), is_packed, Bf16Compute())
+                                : Status::Ok();
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateMatMulMemory(inputs, TransB(), Bf16Compute());
+    }
+
+private:
+    bool TransA() const { return GetIntAttribute("transA", 0) != 0; }
+    bool TransB() const { return GetIntAttribute("transB", 0) != 0; }
+    bool Bf16Compute() const { return GetStringAttribute("compute_precision", "") == "bf16"; }
+    
+    MatMulPrepackedB packed_b_;
+};
+
+REGISTER_OPERATOR("Gemm", GemmOperator);
+
+// SwiGLU算子：融合LLaMA/Qwen MLP的silu(x * Wg) * (x * Wu)
+// 参考ONNX Runtime contrib的MatMul + SwiGLU与vLLM的gate_up_proj合并：
+// 输入x [..., K]与合并的权重w [K, 2N]（前N列为gate，后N列为up），输出[..., N]。
+// 按行块（行数少的解码步再按列块）切分任务，每块的gate/up GEMM结果留在线程私有的缓冲里，
+// 随即做SiLU与乘法写出，[M, 2N]的中间结果不写回内存
+class SwiGLUOperator : public Operator {
+public:
+    std::string GetName() const override { return "SwiGLU"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SwiGLU requires x and w");
+        }
+        const auto& w = inputs[1]->GetShape().dims;
+        if (inputs[0]->GetDataType() != DataType::FLOAT32 || inputs[1]->GetDataType() != DataType::FLOAT32 ||
+            w.size() != 2 || w[1] % 2 != 0 || inputs[0]->GetShape().dims.empty() ||
+            inputs[0]->GetShape().dims.back() != w[0]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "SwiGLU requires FLOAT32 x [..., K] and w [K, 2N]");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 2 || inputs[0]->GetShape().dims.empty() || inputs[1]->GetShape().dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SwiGLU requires x [..., K] and w [K, 2N]");
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        dims.back() = inputs[1]->GetShape().dims[1] / 2;
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        if (inputs.empty() || inputs[0].shape.dims.empty()) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        // 每个输出元素对应gate与up两个长度K的点积
+        return EstimateMatMulCost(inputs, outputs, 2 * inputs[0].shape.dims.back(),
+                                  GetElementwiseFlops("Silu") + GetElementwiseFlops("Mul"));
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(), false, false, &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t K = shape.K;
+        const int64_t N = shape.N / 2;
+        const int64_t M = static_cast<int64_t>(inputs[0]->GetElementCount()) / std::max<int64_t>(K, 1);
+        if (outputs[0]->GetElementCount() != static_cast<size_t>(M * N)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SwiGLU output shape mismatch");
+        }
+        const float* X = static_cast<const float*>(inputs[0]->GetData());
+        const float* W = static_cast<const float*>(inputs[1]->GetData());
+        float* Y = static_cast<float*>(outputs[0]->GetData());
+        const gemm::PackedMatrix* packed = packed_w_.Get(inputs[1], shape);
+    
+        const int64_t row_blocks = (M + kRowBlock - 1) / kRowBlock;
+        // 行块足够分给各线程时整行计算[rows, 2N]（可用预打包的权重），否则再按列切分gate/up
+        const int64_t column_block = row_blocks >= 4 ? N : std::min(N, kColumnBlock);
+        const int64_t column_blocks = (N + column_block - 1) / column_block;
+        ParallelForOuter(ctx, row_blocks * column_blocks, kRowBlock * column_block * 2 * K,
+                         [&](int64_t begin, int64_t end) {
+            // gate与up的块缓冲取自工作线程的暂存区（大小在EstimateMemory中声明）
+            float* scratch = ScratchArena::ForCurrentThread().Allocate<float>(
+                static_cast<size_t>(std::min(kRowBlock, M) * 2 * column_block));
+            for (int64_t task = begin; task < end; ++task) {
+                const int64_t r0 = (task / column_blocks) * kRowBlock;
+                const int64_t rows = std::min(kRowBlock, M - r0);
+                const int64_t c0 = (task % column_blocks) * column_block;
+                const int64_t cols = std::min(column_block, N - c0);
+                float* gate = scratch;
+                float* up = scratch + rows * cols;
+                if (cols == N) {
+                    // gate与up相邻：一次[rows, 2N]的GEMM
+                    gemm::SgemmPrepacked(false, false, rows, 2 * N, K, 1.0f, X + r0 * K, K, nullptr,
+                                         W, 2 * N, packed, 0.0f, gate, 2 * N);
+                } else {
+                    gemm::Sgemm(false, false, rows, cols, K, 1.0f, X + r0 * K, K,
+                                W + c0, 2 * N, 0.0f, gate, cols);
+                    gemm::Sgemm(false, false, rows, cols, K, 1.0f, X + r0 * K, K,
+                                W + N + c0, 2 * N, 0.0f, up, cols);
+                }
+                for (int64_t r = 0; r < rows; ++r) {
+                    const int64_t stride = cols == N ? 2 * N : cols;
+                    float* g = gate + r * stride;
+                    const float* u = cols == N ? g + N : up + r * cols;
+                    simd::SiluSIMD(g, g, static_cast<size_t>(cols));
+                    simd::MulSIMD(g, u, Y + (r0 + r) * N + c0, static_cast<size_t>(cols));
                 }
             }
-        } else {
-            // 小矩阵使用标准实现
-            for (int64_t i = 0; i < M; ++i) {
-                for (int64_t j = 0; j < N; ++j) {
-                    float sum = bias_data ? bias_data[j] : 0.0f;
-                    for (int64_t k = 0; k < K; ++k) {
-                        sum += A_data[i * K + k] * B_data[k * N + j];
+        });
+        return Status::Ok();
+    }
+    
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        return input_index == 1 && tensor.GetDataType() == DataType::FLOAT32
+                   ? packed_w_.PrePack(tensor, false, is_packed)
+                   : Status::Ok();
+    }
+    
+    // 只打包FP32权重；暂存区另有一个行块的gate/up（按整行计，不超过[kRowBlock, 2N]）
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        if (inputs.size() > 1 && inputs[1].dtype != DataType::FLOAT32) {
+            return OperatorMemory();
+        }
+        OperatorMemory memory = EstimateMatMulMemory(inputs, false, false);
+        if (inputs.size() > 1 && !inputs[1].shape.dims.empty()) {
+            memory.scratch_bytes += static_cast<size_t>(kRowBlock * std::max<int64_t>(inputs[1].shape.dims.back(), 0)) *
+                                    sizeof(float);
+        }
+        return memory;
+    }
+
+private:
+    static constexpr int64_t kRowBlock = 32;
+    static constexpr int64_t kColumnBlock = 256;
+    
+    MatMulPrepackedB packed_w_;
+};
+
+REGISTER_OPERATOR("SwiGLU", SwiGLUOperator);
+
+// FusedElementwise算子：融合Pass合并的逐元素算子链
+// 参考TVM的injective融合：按L1大小的块执行整条链，中间结果不写回内存，
+// 每个输入只读一遍、输出只写一遍；各步骤由SIMD核在块内原位组合（不依赖JIT）
+// inputs[0]为链的起点（与输出同形），其后依次是各二元步骤的另一个操作数；操作数可以与输出同形、
+// 只有一个元素，或沿输出中连续的若干维广播（如[C]之于[N, C]、[C, 1, 1]之于[N, C, H, W]）。
+// ops属性为逗号分隔的步骤：Add/Sub/Mul/Div/RSub/RDiv/Max/Min/Pow（指数为标量）/
+// Relu/Sigmoid/Tanh/Gelu/GeluTanh/Silu/Exp/Log/Sqrt；
+// 二元步骤写成"Op@k"时操作数为已有的inputs[k]（如x * sigmoid(x)写作"Sigmoid,Mul@0"），不占新的输入
+class FusedElementwiseOperator : public Operator {
+public:
+    std::string GetName() const override { return "FusedElementwise"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 整条链每个元素的运算数之和，中间结果不写回内存
+        double flops_per_element = 0.0;
+        std::stringstream ss(GetStringAttribute("ops", ""));
+        std::string token;
+        while (std::getline(ss, token, ',')) {
+            flops_per_element += GetElementwiseFlops(token.substr(0, token.find('@')));
+        }
+        return EstimateElementwiseCost(inputs, outputs, flops_per_element);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ParseSteps(inputs.size());
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        const size_t count = outputs[0]->GetElementCount();
+        if (inputs[0]->GetElementCount() != count) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedElementwise output shape mismatch");
+        }
+        std::vector<Operand> operands(inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!ResolveOperand(*inputs[i], inputs[0]->GetShape(), &operands[i])) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "FusedElementwise operand is not broadcastable");
+            }
+        }
+    
+        const float* x = static_cast<const float*>(inputs[0]->GetData());
+        float* y = static_cast<float*>(outputs[0]->GetData());
+        ParallelForElements(ctx, static_cast<int64_t>(count), [&](int64_t begin, int64_t end) {
+            float gathered[kBlockSize];
+            for (int64_t block = begin; block < end; block += kBlockSize) {
+                const size_t n = static_cast<size_t>(std::min<int64_t>(kBlockSize, end - block));
+                const float* src = x + block;
+                float* dst = y + block;
+                if (steps_.empty()) {
+                    std::memcpy(dst, src, n * sizeof(float));
+                }
+                for (const Step& step : steps_) {
+                    const float* operand = nullptr;
+                    bool scalar = false;
+                    if (step.input >= 0) {
+                        const Operand& o = operands[static_cast<size_t>(step.input)];
+                        scalar = o.size == 1;
+                        operand = o.Data(block, n, gathered);
+                    }
+                    RunStep(step.kind, src, operand, scalar, dst, n);
+                    src = dst;  // 后续步骤在块内原位执行
+                }
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    enum class StepKind {
+        ADD, SUB, RSUB, MUL, DIV, RDIV, MAX, MIN, POW,
+        RELU, SIGMOID, TANH, GELU, GELU_TANH, SILU, EXP, LOG, SQRT
+    };
+    
+    struct Step {
+        StepKind kind;
+        int input;  // 二元步骤的操作数（inputs下标），一元步骤为-1
+    };
+    
+    static constexpr int64_t kBlockSize = 1024;  // 4KB，整条链在L1中完成
+    
+    // 输出第i个元素对应操作数的第(i / repeat) % size个元素：
+    // size == 输出元素数为同形，size == 1为标量，其余为沿连续若干维的广播
+    struct Operand {
+        const float* data = nullptr;
+        int64_t size = 1;
+        int64_t repeat = 1;
+        bool full = false;
+    
+        // 块[offset, offset + n)对应的操作数：同形与标量直接返回指针，广播时展开到buffer
+        const float* Data(int64_t offset, size_t n, float* buffer) const {
+            if (full) return data + offset;
+            if (size == 1) return data;
+            size_t i = 0;
+            while (i < n) {
+                const int64_t pos = offset + static_cast<int64_t>(i);
+                const int64_t index = (pos / repeat) % size;
+                if (repeat == 1) {
+                    const size_t len = std::min(n - i, static_cast<size_t>(size - index));
+                    std::memcpy(buffer + i, data + index, len * sizeof(float));
+                    i += len;
+                } else {
+                    const size_t len = std::min(n - i, static_cast<size_t>(repeat - pos % repeat));
+                    std::fill(buffer + i, buffer + i + len, data[index]);
+                    i += len;
+                }
+            }
+            return buffer;
+        }
+    };
+    
+    // 操作数的非1维（右对齐）必须是输出中连续的一段且长度相同
+    static bool ResolveOperand(const Tensor& tensor, const Shape& output, Operand* operand) {
+        operand->data = static_cast<const float*>(tensor.GetData());
+        operand->size = static_cast<int64_t>(tensor.GetElementCount());
+        const int64_t total = output.GetElementCount();
+        if (operand->size == total || operand->size == 1) {
+            operand->full = operand->size == total && total != 1;
+            return operand->size == 1 || tensor.GetShape().dims.size() <= output.dims.size();
+        }
+        const auto& dims = tensor.GetShape().dims;
+        if (dims.size() > output.dims.size()) {
+            return false;
+        }
+        const size_t offset = output.dims.size() - dims.size();
+        int64_t last = -1;
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (dims[d] == 1) continue;
+            if (dims[d] != output.dims[d + offset] || (last >= 0 && last + 1 != static_cast<int64_t>(d))) {
+                return false;
+            }
+            last = static_cast<int64_t>(d);
+        }
+        operand->repeat = 1;
+        for (size_t d = static_cast<size_t>(last) + 1 + offset; d < output.dims.size(); ++d) {
+            operand->repeat *= output.dims[d];
+        }
+        return true;
+    }
+    
+    // 第一次执行时解析；并发的运行在锁内解析一次，之后只读steps_
+    Status ParseSteps(size_t num_inputs) {
+        if (parsed_.load(std::memory_order_acquire)) {
+            return Status::Ok();
+        }
+        std::lock_guard<std::mutex> lock(parse_mutex_);
+        if (parsed_.load(std::memory_order_relaxed)) {
+            return Status::Ok();
+        }
+        static const std::unordered_map<std::string, StepKind> kBinary = {
+            {"Add", StepKind::ADD}, {"Sub", StepKind::SUB}, {"RSub", StepKind::RSUB},
+            {"Mul", StepKind::MUL}, {"Div", StepKind::DIV}, {"RDiv", StepKind::RDIV},
+            {"Max", StepKind::MAX}, {"Min", StepKind::MIN}, {"Pow", StepKind::POW}
+        };
+        static const std::unordered_map<std::string, StepKind> kUnary = {
+            {"Relu", StepKind::RELU}, {"Sigmoid", StepKind::SIGMOID}, {"Tanh", StepKind::TANH},
+            {"Gelu", StepKind::GELU}, {"GeluTanh", StepKind::GELU_TANH}, {"Silu", StepKind::SILU},
+            {"Exp", StepKind::EXP}, {"Log", StepKind::LOG}, {"Sqrt", StepKind::SQRT}
+        };
+    
+        steps_.clear();
+        int next_input = 1;
+        std::stringstream ss(GetStringAttribute("ops", ""));
+        std::string token;
+        while (std::getline(ss, token, ',')) {
+            const size_t at = token.find('@');
+            const std::string op = token.substr(0, at);
+            auto binary = kBinary.find(op);
+            if (binary != kBinary.end()) {
+                int input = next_input;
+                if (at == std::string::npos) {
+                    ++next_input;
+                } else {
+                    input = std::atoi(token.c_str() + at + 1);
+                    if (input < 0 || static_cast<size_t>(input) >= num_inputs) {
+                        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                           "FusedElementwise operand out of range: " + token);
                     }
-                    C_data[i * N + j] = sum;
                 }
+                steps_.push_back({binary->second, input});
+                continue;
+            }
+            auto unary = kUnary.find(op);
+            if (unary == kUnary.end() || at != std::string::npos) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "FusedElementwise step not supported: " + token);
             }
+            steps_.push_back({unary->second, -1});
+        }
+        if (static_cast<size_t>(next_input) != num_inputs) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "FusedElementwise ops do not match the number of inputs");
         }
-        
+        parsed_.store(true, std::memory_order_release);
         return Status::Ok();
     }
+    
+    // dst可以与src相同；scalar为true时operand只有一个元素
+    static void RunStep(StepKind kind, const float* src, const float* operand, bool scalar,
+                        float* dst, size_t n) {
+        using simd::BinaryOp;
+        switch (kind) {
+            case StepKind::ADD: simd::BinarySIMD(BinaryOp::ADD, src, false, operand, scalar, dst, n); break;
+            case StepKind::SUB: simd::BinarySIMD(BinaryOp::SUB, src, false, operand, scalar, dst, n); break;
+            case StepKind::RSUB: simd::BinarySIMD(BinaryOp::SUB, operand, scalar, src, false, dst, n); break;
+            case StepKind::MUL: simd::BinarySIMD(BinaryOp::MUL, src, false, operand, scalar, dst, n); break;
+            case StepKind::DIV: simd::BinarySIMD(BinaryOp::DIV, src, false, operand, scalar, dst, n); break;
+            case StepKind::RDIV: simd::BinarySIMD(BinaryOp::DIV, operand, scalar, src, false, dst, n); break;
+            case StepKind::MAX: simd::BinarySIMD(BinaryOp::MAX, src, false, operand, scalar, dst, n); break;
+            case StepKind::MIN: simd::BinarySIMD(BinaryOp::MIN, src, false, operand, scalar, dst, n); break;
+            case StepKind::POW:
+                if (scalar && operand[0] == 2.0f) {
+                    simd::MulSIMD(src, src, dst, n);
+                } else {
+                    for (size_t i = 0; i < n; ++i) dst[i] = std::pow(src[i], operand[scalar ? 0 : i]);
+                }
+                break;
+            case StepKind::RELU: simd::ReluSIMD(src, dst, n); break;
+            case StepKind::SIGMOID: simd::SigmoidSIMD(src, dst, n); break;
+            case StepKind::TANH: simd::TanhSIMD(src, dst, n); break;
+            case StepKind::GELU: simd::GeluSIMD(src, dst, n, false); break;
+            case StepKind::GELU_TANH: simd::GeluSIMD(src, dst, n, true); break;
+            case StepKind::SILU: simd::SiluSIMD(src, dst, n); break;
+            case StepKind::EXP: simd::ExpSIMD(src, dst, n); break;
+            case StepKind::LOG: simd::LogSIMD(src, dst, n); break;
+            case StepKind::SQRT:
+                for (size_t i = 0; i < n; ++i) dst[i] = std::sqrt(src[i]);
+                break;
+        }
+    }
+    
+    std::vector<Step> steps_;
+    std::mutex parse_mutex_;
+    std::atomic<bool> parsed_{false};
 };
 
-REGISTER_OPERATOR("FusedMatMulAdd", FusedMatMulAddOperator);
+REGISTER_OPERATOR("FusedElementwise", FusedElementwiseOperator);
 
 } // namespace operators
 } // namespace inferunity
@@ -0,0 +1,292 @@
+// 按行收集实现
+
+#include "gather_kernels.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include "inferunity/embedding_store.h"
+#include "inferunity/memory.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 提前预取的行数：足以覆盖一次DRAM访问的延迟，又不会把当前行挤出L1
+constexpr int64_t kPrefetchDistance = 8;
+// 每行最多预取的缓存行数，大行只预取开头，其余靠硬件顺序预取
+constexpr size_t kMaxPrefetchBytes = 256;
+
+inline void PrefetchRow(const uint8_t* row, size_t row_bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    const size_t bytes = std::min(row_bytes, kMaxPrefetchBytes);
+    for (size_t offset = 0; offset < bytes; offset += 64) {
+        __builtin_prefetch(row + offset, 0, 0);
+    }
+#else
+    (void)row;
+    (void)row_bytes;
+#endif
+}
+
+// 读取并规范化全部下标
+Status NormalizeIndices(const GatherRowsParams& params, std::vector<int64_t>* rows) {
+    rows->resize(static_cast<size_t>(params.index_count));
+    for (int64_t i = 0; i < params.index_count; ++i) {
+        int64_t idx = params.index_type == DataType::INT64
+            ? static_cast<const int64_t*>(params.indices)[i]
+            : static_cast<int64_t>(static_cast<const int32_t*>(params.indices)[i]);
+        if (idx < 0) {
+            idx += params.num_rows;
+        }
+        if (idx < 0 || idx >= params.num_rows) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Gather index out of range: " + std::to_string(idx));
+        }
+        (*rows)[i] = idx;
+    }
+    return Status::Ok();
+}
+
+template <typename T>
+inline int64_t ReadIndex(const void* data, int64_t i) {
+    return static_cast<int64_t>(static_cast<const T*>(data)[i]);
+}
+
+inline int64_t ReadIndex(const void* data, DataType type, int64_t i) {
+    return type == DataType::INT64 ? ReadIndex<int64_t>(data, i) : ReadIndex<int32_t>(data, i);
+}
+
+// acc += weight * row；非FP32的行先在scratch中还原为FP32
+void AccumulateRow(const EmbeddingBagParams& params, int64_t row, float weight, float* scratch, float* acc) {
+    const size_t dim = static_cast<size_t>(params.dim);
+    const size_t offset = static_cast<size_t>(row) * dim;
+    switch (params.table_type) {
+        case DataType::FLOAT32: {
+            const float* values = static_cast<const float*>(params.table) + offset;
+            if (weight == 1.0f) {
+                simd::AddSIMD(acc, values, acc, dim);
+            } else {
+                simd::ScaleAddSIMD(values, weight, acc, dim);
+            }
+            return;
+        }
+        case DataType::FLOAT16:
+            simd::ConvertHalfToFloatSIMD(static_cast<const uint16_t*>(params.table) + offset, scratch, dim);
+            break;
+        case DataType::UINT8: {
+            // 权重并入scale与bias，还原后直接相加
+            const float bias = params.row_biases ? params.row_biases[row] : 0.0f;
+            simd::ConvertU8AffineSIMD(static_cast<const uint8_t*>(params.table) + offset, scratch, dim,
+                                      params.row_scales[row] * weight, bias * weight);
+            simd::AddSIMD(acc, scratch, acc, dim);
+            return;
+        }
+        default: {
+            const int8_t* q = static_cast<const int8_t*>(params.table) + offset;
+            const float scale = params.row_scales[row] * weight;
+            const float bias = (params.row_biases ? params.row_biases[row] : 0.0f) * weight;
+            for (size_t j = 0; j < dim; ++j) {
+                scratch[j] = static_cast<float>(q[j]) * scale + bias;
+            }
+            simd::AddSIMD(acc, scratch, acc, dim);
+            return;
+        }
+    }
+    if (weight == 1.0f) {
+        simd::AddSIMD(acc, scratch, acc, dim);
+    } else {
+        simd::ScaleAddSIMD(scratch, weight, acc, dim);
+    }
+}
+
+} // anonymous namespace
+
+Status GatherRows(const GatherRowsParams& params, ExecutionContext* ctx) {
+    if (params.index_type != DataType::INT64 && params.index_type != DataType::INT32) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Gather indices must be INT32 or INT64");
+    }
+    std::vector<int64_t> rows;
+    Status status = NormalizeIndices(params, &rows);
+    if (!status.IsOk() || params.index_count == 0 || params.row_bytes == 0) {
+        return status;
+    }
+    if (params.store && params.outer == 1) {
+        return params.store->Lookup(rows.data(), params.index_count, params.output);
+    }
+    
+    const uint8_t* table = static_cast<const uint8_t*>(params.table);
+    uint8_t* output = static_cast<uint8_t*>(params.output);
+    const size_t row_bytes = params.row_bytes;
+    const int64_t count = params.index_count;
+    const int64_t row_work = static_cast<int64_t>(row_bytes / sizeof(float)) + 1;
+    
+    if (!params.deduplicate) {
+        // 任务为 outer x 下标，按下标顺序拷贝并预取后面的行
+        ParallelForOuter(ctx, params.outer * count, row_work, [&](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t) {
+                const int64_t o = t / count;
+                const int64_t i = t % count;
+                const uint8_t* base = table + static_cast<size_t>(o * params.num_rows) * row_bytes;
+                if (t + kPrefetchDistance < end) {
+                    const int64_t ahead = (t + kPrefetchDistance) % count;
+                    const int64_t ahead_outer = (t + kPrefetchDistance) / count;
+                    PrefetchRow(table + static_cast<size_t>(ahead_outer * params.num_rows + rows[ahead]) * row_bytes,
+                                row_bytes);
+                }
+                std::memcpy(output + static_cast<size_t>(t) * row_bytes,
+                            base + static_cast<size_t>(rows[i]) * row_bytes, row_bytes);
+            }
+        });
+        return Status::Ok();
+    }
+    
+    // 去重：按(行, 位置)排序后每组的第一个位置从表中读取，其余位置复制该输出行；
+    // 排序后的访问也按表地址递增，更利于硬件预取
+    std::vector<std::pair<int64_t, int64_t>> order(static_cast<size_t>(count));
+    for (int64_t i = 0; i < count; ++i) {
+        order[i] = {rows[i], i};
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<int64_t> group_starts;
+    for (int64_t k = 0; k < count; ++k) {
+        if (k == 0 || order[k].first != order[k - 1].first) {
+            group_starts.push_back(k);
+        }
+    }
+    const int64_t groups = static_cast<int64_t>(group_starts.size());
+    group_starts.push_back(count);
+    const int64_t copies_per_group = (count + groups - 1) / groups;
+    
+    ParallelForOuter(ctx, params.outer * groups, row_work * copies_per_group, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t o = t / groups;
+            const int64_t g = t % groups;
+            const uint8_t* base = table + static_cast<size_t>(o * params.num_rows) * row_bytes;
+            uint8_t* out_base = output + static_cast<size_t>(o * count) * row_bytes;
+            if (g + kPrefetchDistance < groups && t + kPrefetchDistance < end) {
+                PrefetchRow(base + static_cast<size_t>(order[group_starts[g + kPrefetchDistance]].first) * row_bytes,
+                            row_bytes);
+            }
+            const int64_t first = group_starts[g];
+            uint8_t* first_row = out_base + static_cast<size_t>(order[first].second) * row_bytes;
+            std::memcpy(first_row, base + static_cast<size_t>(order[first].first) * row_bytes, row_bytes);
+            for (int64_t k = first + 1; k < group_starts[g + 1]; ++k) {
+                std::memcpy(out_base + static_cast<size_t>(order[k].second) * row_bytes, first_row, row_bytes);
+            }
+        }
+    });
+    return Status::Ok();
+}
+
+Status EmbeddingBag(const EmbeddingBagParams& params, ExecutionContext* ctx) {
+    if (params.index_type != DataType::INT64 && params.index_type != DataType::INT32) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag indices must be INT32 or INT64");
+    }
+    const DataType table_type = params.table_type;
+    const bool row_quantized = table_type == DataType::UINT8 || table_type == DataType::INT8;
+    if (table_type != DataType::FLOAT32 && table_type != DataType::FLOAT16 && !row_quantized) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "EmbeddingBag table must be FLOAT32, FLOAT16, UINT8 or INT8");
+    }
+    if (row_quantized && !params.row_scales) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag 8-bit tables require row scales");
+    }
+    if (params.mean && params.per_sample_weights) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "EmbeddingBag per_sample_weights are only supported with mode sum");
+    }
+    
+    // 袋的边界：bounds[b]到bounds[b + 1]
+    const int64_t num_bags = params.num_bags;
+    std::vector<int64_t> bounds(static_cast<size_t>(num_bags) + 1);
+    if (params.offsets) {
+        if (params.offset_type != DataType::INT64 && params.offset_type != DataType::INT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag offsets must be INT32 or INT64");
+        }
+        for (int64_t b = 0; b < num_bags; ++b) {
+            bounds[b] = ReadIndex(params.offsets, params.offset_type, b);
+        }
+    } else {
+        for (int64_t b = 0; b < num_bags; ++b) {
+            bounds[b] = b * params.bag_size;
+        }
+    }
+    bounds[num_bags] = params.index_count;
+    for (int64_t b = 0; b < num_bags; ++b) {
+        if (bounds[b] < 0 || bounds[b] > bounds[b + 1]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag offsets must be non-decreasing and within indices");
+        }
+    }
+    std::vector<int64_t> rows(static_cast<size_t>(params.index_count));
+    for (int64_t i = 0; i < params.index_count; ++i) {
+        rows[i] = ReadIndex(params.indices, params.index_type, i);
+        if (rows[i] < 0) {
+            rows[i] += params.num_rows;
+        }
+        if (rows[i] < 0 || rows[i] >= params.num_rows) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag index out of range: " + std::to_string(rows[i]));
+        }
+    }
+    if (num_bags == 0 || params.dim == 0) {
+        return Status::Ok();
+    }
+    
+    const size_t dim = static_cast<size_t>(params.dim);
+    const size_t row_bytes = dim * GetDataTypeSize(table_type);
+    const uint8_t* table = static_cast<const uint8_t*>(params.table);
+    const int64_t ids_per_bag = std::max<int64_t>(1, params.index_count / num_bags);
+    ParallelForOuter(ctx, num_bags, ids_per_bag * params.dim, [&](int64_t begin, int64_t end) {
+        // 非FP32的行还原到工作线程的暂存区，块结束时由ParallelForOuter回收
+        float* scratch = table_type == DataType::FLOAT32
+                             ? nullptr : ScratchArena::ForCurrentThread().Allocate<float>(dim);
+        // 预取按块内全部下标的顺序进行，跨越袋的边界
+        const int64_t last = bounds[end];
+        for (int64_t b = begin; b < end; ++b) {
+            float* acc = params.output + static_cast<size_t>(b) * dim;
+            std::fill(acc, acc + dim, 0.0f);
+            for (int64_t i = bounds[b]; i < bounds[b + 1]; ++i) {
+                if (i + kPrefetchDistance < last) {
+                    PrefetchRow(table + static_cast<size_t>(rows[i + kPrefetchDistance]) * row_bytes, row_bytes);
+                }
+                const float weight = params.per_sample_weights ? params.per_sample_weights[i] : 1.0f;
+                AccumulateRow(params, rows[i], weight, scratch, acc);
+            }
+            const int64_t count = bounds[b + 1] - bounds[b];
+            if (params.mean && count > 1) {
+                simd::ScaleSIMD(acc, acc, dim, 1.0f / static_cast<float>(count));
+            }
+        }
+    });
+    return Status::Ok();
+}
+
+Status OpenTieredEmbeddingStore(const Tensor& table, int64_t num_rows, size_t row_bytes, int64_t cache_rows,
+                                std::unique_ptr<TieredEmbeddingStore>* store) {
+    store->reset();
+    const size_t size = static_cast<size_t>(num_rows) * row_bytes;
+    std::string path;
+    uint64_t offset = 0;
+    if (cache_rows <= 0 || num_rows <= cache_rows || !table.GetData() ||
+        !FindMappedFileRegion(table.GetData(), size, &path, &offset)) {
+        return Status::Ok();
+    }
+    EmbeddingStoreOptions options;
+    options.cache_rows = cache_rows;
+    Status status = TieredEmbeddingStore::Open(path, offset, num_rows, row_bytes, options, store);
+    if (status.IsOk()) {
+        // 之后只经存储读行，映射中已读入的页不再需要常驻
+        ReleaseMemory(table.GetData(), size);
+    }
+    return status;
+}
+
+} // namespace operators
+} // namespace inferunity
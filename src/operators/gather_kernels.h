@@ -0,0 +1,68 @@
+// 按行收集（Gather/Embedding共用）
+// 参考ONNX Runtime的GatherCopyData与FBGEMM的EmbeddingSpMDM：先检查全部下标，再按下标整行拷贝，
+// 拷贝时预取后面几行；下标按块分给算子内线程。可选的去重路径按下标排序，
+// 每个不同的行只从表中读取一次，重复出现的位置从第一次写出的输出行复制。
+// 表在SSD上的大文件里时可改从分层存储读行（见TieredEmbeddingStore），只保留热点行在内存中。
+// 嵌入袋（EmbeddingBag，参考PyTorch的nn.EmbeddingBag与Caffe2的SparseLengthsSum）把每个袋的行直接累加进
+// 池化输出，不物化[num_ids, dim]的中间结果；袋分给算子内线程
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace inferunity {
+
+class TieredEmbeddingStore;
+
+namespace operators {
+
+struct GatherRowsParams {
+    const void* table = nullptr;      // [outer, num_rows, row_bytes]
+    int64_t outer = 1;                // 收集轴之前各维的乘积
+    int64_t num_rows = 0;             // 收集轴的长度
+    size_t row_bytes = 0;             // 收集轴之后一个切片的字节数
+    const void* indices = nullptr;    // INT32或INT64，负下标从末尾计数
+    DataType index_type = DataType::INT64;
+    int64_t index_count = 0;
+    void* output = nullptr;           // [outer, index_count, row_bytes]
+    bool deduplicate = false;         // 重复下标较多（推荐模型的热点id）时打开
+    TieredEmbeddingStore* store = nullptr;  // 非空且outer为1时从分层存储读行（总是去重），不访问table
+};
+
+// 下标越界时返回错误且不写输出
+Status GatherRows(const GatherRowsParams& params, ExecutionContext* ctx);
+
+struct EmbeddingBagParams {
+    const void* table = nullptr;      // [num_rows, dim]：FLOAT32、FLOAT16，或按行量化的UINT8/INT8
+    DataType table_type = DataType::FLOAT32;
+    int64_t num_rows = 0;
+    int64_t dim = 0;
+    const float* row_scales = nullptr;  // 8位表必需：value = q * scale + bias，均为[num_rows]
+    const float* row_biases = nullptr;  // 可为空（bias为0）
+    const void* indices = nullptr;    // INT32或INT64，负下标从末尾计数（与Gather一致）
+    DataType index_type = DataType::INT64;
+    int64_t index_count = 0;
+    // 各袋在indices中的起点（INT32或INT64，非递减），袋b为[offsets[b], offsets[b + 1])，最后一袋到index_count；
+    // 为空时indices按bag_size个一袋连续划分
+    const void* offsets = nullptr;
+    DataType offset_type = DataType::INT64;
+    int64_t num_bags = 0;
+    int64_t bag_size = 0;
+    const float* per_sample_weights = nullptr;  // [index_count]，可为空
+    bool mean = false;                // 按袋内下标数取平均（空袋输出0）
+    float* output = nullptr;          // [num_bags, dim]
+};
+
+// 下标或offsets非法时返回错误且不写输出
+Status EmbeddingBag(const EmbeddingBagParams& params, ExecutionContext* ctx);
+
+// 算子PrePack时调用：cache_rows > 0、table是模型文件映射（MappedFile::Open）的视图且行数多于cache_rows时
+// 打开从同一文件读行的分层存储，并让内核回收table已读入的页；条件不满足时*store置空并返回成功
+Status OpenTieredEmbeddingStore(const Tensor& table, int64_t num_rows, size_t row_bytes, int64_t cache_rows,
+                                std::unique_ptr<TieredEmbeddingStore>* store);
+
+} // namespace operators
+} // namespace inferunity
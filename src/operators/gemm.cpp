@@ -0,0 +1,1035 @@
+// 通用矩阵乘法实现
+// 参考BLIS/GotoBLAS的五层循环：NC -> KC -> MC 三级分块分别对应L3/L1/L2缓存，
+// A打包成MR行的条带、B打包成NR列的条带，最内层由MRxNR寄存器分块的微内核完成
+
+#include "gemm.h"
+#include "gemm_bf16_kernels.h"
+#include "simd_utils.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/float16.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#ifdef INFERUNITY_USE_ACCELERATE
+#include <Accelerate/Accelerate.h>
+#elif defined(INFERUNITY_USE_OPENBLAS)
+#include <cblas.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define INFERUNITY_GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define INFERUNITY_GEMM_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace inferunity {
+namespace gemm {
+
+namespace {
+
+// 微内核：计算一个完整的MRxNR子块
+// a为打包后的A条带（kc x MR，按k连续），b为打包后的B条带（kc x NR）
+// c = alpha * (a * b) + beta * c；beta == 0 时不读取c
+using MicroKernelFn = void (*)(int64_t kc, const float* a, const float* b,
+                               float* c, int64_t ldc, float alpha, float beta);
+
+struct MicroKernel {
+    int mr;
+    int nr;
+    MicroKernelFn fn;
+    const char* name;
+};
+
+constexpr int kMaxMR = 8;
+constexpr int kMaxNR = 32;
+
+// 分块大小：KC使A/B条带驻留L1，MC x KC的A面板驻留L2，KC x NC的B面板驻留L3
+constexpr int64_t kBlockK = 256;
+constexpr int64_t kBlockMTarget = 144;
+constexpr int64_t kBlockN = 2048;
+
+// 小矩阵直接计算，避免打包开销
+constexpr int64_t kSmallGemmFlops = 8 * 1024;
+
+// ---------------------------------------------------------------------------
+// 标量微内核（4x8，所有平台可用）
+// ---------------------------------------------------------------------------
+void KernelScalar_4x8(int64_t kc, const float* a, const float* b,
+                      float* c, int64_t ldc, float alpha, float beta) {
+    float acc[4][8] = {};
+    for (int64_t k = 0; k < kc; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            const float ai = a[i];
+            for (int j = 0; j < 8; ++j) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += 4;
+        b += 8;
+    }
+    for (int i = 0; i < 4; ++i) {
+        float* c_row = c + i * ldc;
+        for (int j = 0; j < 8; ++j) {
+            c_row[j] = beta == 0.0f ? alpha * acc[i][j] : alpha * acc[i][j] + beta * c_row[j];
+        }
+    }
+}
+
+#ifdef INFERUNITY_GEMM_X86
+// ---------------------------------------------------------------------------
+// AVX2 + FMA微内核（6x16：12个累加寄存器 + 2个B寄存器 + 1个广播寄存器）
+// ---------------------------------------------------------------------------
+#define INFERUNITY_AVX2_STORE_ROW(row, r0, r1)                                     \
+    do {                                                                           \
+        float* c_row = c + (row) * ldc;                                            \
+        __m256 v0 = _mm256_mul_ps(valpha, r0);                                     \
+        __m256 v1 = _mm256_mul_ps(valpha, r1);                                     \
+        if (beta != 0.0f) {                                                        \
+            v0 = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(c_row), v0);               \
+            v1 = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(c_row + 8), v1);           \
+        }                                                                          \
+        _mm256_storeu_ps(c_row, v0);                                               \
+        _mm256_storeu_ps(c_row + 8, v1);                                           \
+    } while (0)
+
+__attribute__((target("avx2,fma")))
+void KernelAvx2_6x16(int64_t kc, const float* a, const float* b,
+                     float* c, int64_t ldc, float alpha, float beta) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    
+    for (int64_t k = 0; k < kc; ++k) {
+        const __m256 b0 = _mm256_loadu_ps(b);
+        const __m256 b1 = _mm256_loadu_ps(b + 8);
+        __m256 ai;
+        ai = _mm256_broadcast_ss(a + 0);
+        c00 = _mm256_fmadd_ps(ai, b0, c00); c01 = _mm256_fmadd_ps(ai, b1, c01);
+        ai = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(ai, b0, c10); c11 = _mm256_fmadd_ps(ai, b1, c11);
+        ai = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(ai, b0, c20); c21 = _mm256_fmadd_ps(ai, b1, c21);
+        ai = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(ai, b0, c30); c31 = _mm256_fmadd_ps(ai, b1, c31);
+        ai = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(ai, b0, c40); c41 = _mm256_fmadd_ps(ai, b1, c41);
+        ai = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(ai, b0, c50); c51 = _mm256_fmadd_ps(ai, b1, c51);
+        a += 6;
+        b += 16;
+    }
+    
+    const __m256 valpha = _mm256_set1_ps(alpha);
+    const __m256 vbeta = _mm256_set1_ps(beta);
+    INFERUNITY_AVX2_STORE_ROW(0, c00, c01);
+    INFERUNITY_AVX2_STORE_ROW(1, c10, c11);
+    INFERUNITY_AVX2_STORE_ROW(2, c20, c21);
+    INFERUNITY_AVX2_STORE_ROW(3, c30, c31);
+    INFERUNITY_AVX2_STORE_ROW(4, c40, c41);
+    INFERUNITY_AVX2_STORE_ROW(5, c50, c51);
+}
+#undef INFERUNITY_AVX2_STORE_ROW
+
+// ---------------------------------------------------------------------------
+// AVX-512微内核（8x32：16个累加寄存器）
+// ---------------------------------------------------------------------------
+#define INFERUNITY_AVX512_STEP(row, r0, r1)                                        \
+    do {                                                                           \
+        const __m512 ai = _mm512_set1_ps(a[row]);                                  \
+        r0 = _mm512_fmadd_ps(ai, b0, r0);                                          \
+        r1 = _mm512_fmadd_ps(ai, b1, r1);                                          \
+    } while (0)
+
+#define INFERUNITY_AVX512_STORE_ROW(row, r0, r1)                                   \
+    do {                                                                           \
+        float* c_row = c + (row) * ldc;                                            \
+        __m512 v0 = _mm512_mul_ps(valpha, r0);                                     \
+        __m512 v1 = _mm512_mul_ps(valpha, r1);                                     \
+        if (beta != 0.0f) {                                                        \
+            v0 = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(c_row), v0);               \
+            v1 = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(c_row + 16), v1);          \
+        }                                                                          \
+        _mm512_storeu_ps(c_row, v0);                                               \
+        _mm512_storeu_ps(c_row + 16, v1);                                          \
+    } while (0)
+
+__attribute__((target("avx512f")))
+void KernelAvx512_8x32(int64_t kc, const float* a, const float* b,
+                       float* c, int64_t ldc, float alpha, float beta) {
+    __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+    __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+    __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+    __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+    __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+    __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+    __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+    __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+    
+    for (int64_t k = 0; k < kc; ++k) {
+        const __m512 b0 = _mm512_loadu_ps(b);
+        const __m512 b1 = _mm512_loadu_ps(b + 16);
+        INFERUNITY_AVX512_STEP(0, c00, c01);
+        INFERUNITY_AVX512_STEP(1, c10, c11);
+        INFERUNITY_AVX512_STEP(2, c20, c21);
+        INFERUNITY_AVX512_STEP(3, c30, c31);
+        INFERUNITY_AVX512_STEP(4, c40, c41);
+        INFERUNITY_AVX512_STEP(5, c50, c51);
+        INFERUNITY_AVX512_STEP(6, c60, c61);
+        INFERUNITY_AVX512_STEP(7, c70, c71);
+        a += 8;
+        b += 32;
+    }
+    
+    const __m512 valpha = _mm512_set1_ps(alpha);
+    const __m512 vbeta = _mm512_set1_ps(beta);
+    INFERUNITY_AVX512_STORE_ROW(0, c00, c01);
+    INFERUNITY_AVX512_STORE_ROW(1, c10, c11);
+    INFERUNITY_AVX512_STORE_ROW(2, c20, c21);
+    INFERUNITY_AVX512_STORE_ROW(3, c30, c31);
+    INFERUNITY_AVX512_STORE_ROW(4, c40, c41);
+    INFERUNITY_AVX512_STORE_ROW(5, c50, c51);
+    INFERUNITY_AVX512_STORE_ROW(6, c60, c61);
+    INFERUNITY_AVX512_STORE_ROW(7, c70, c71);
+}
+#undef INFERUNITY_AVX512_STEP
+#undef INFERUNITY_AVX512_STORE_ROW
+#endif // INFERUNITY_GEMM_X86
+
+#ifdef INFERUNITY_GEMM_NEON
+// ---------------------------------------------------------------------------
+// NEON微内核（8x8：16个累加寄存器，按lane做FMA）
+// ---------------------------------------------------------------------------
+void KernelNeon_8x8(int64_t kc, const float* a, const float* b,
+                    float* c, int64_t ldc, float alpha, float beta) {
+    float32x4_t acc[8][2];
+    for (int i = 0; i < 8; ++i) {
+        acc[i][0] = vdupq_n_f32(0.0f);
+        acc[i][1] = vdupq_n_f32(0.0f);
+    }
+    for (int64_t k = 0; k < kc; ++k) {
+        const float32x4_t b0 = vld1q_f32(b);
+        const float32x4_t b1 = vld1q_f32(b + 4);
+        const float32x4_t a0 = vld1q_f32(a);
+        const float32x4_t a1 = vld1q_f32(a + 4);
+        acc[0][0] = vfmaq_laneq_f32(acc[0][0], b0, a0, 0); acc[0][1] = vfmaq_laneq_f32(acc[0][1], b1, a0, 0);
+        acc[1][0] = vfmaq_laneq_f32(acc[1][0], b0, a0, 1); acc[1][1] = vfmaq_laneq_f32(acc[1][1], b1, a0, 1);
+        acc[2][0] = vfmaq_laneq_f32(acc[2][0], b0, a0, 2); acc[2][1] = vfmaq_laneq_f32(acc[2][1], b1, a0, 2);
+        acc[3][0] = vfmaq_laneq_f32(acc[3][0], b0, a0, 3); acc[3][1] = vfmaq_laneq_f32(acc[3][1], b1, a0, 3);
+        acc[4][0] = vfmaq_laneq_f32(acc[4][0], b0, a1, 0); acc[4][1] = vfmaq_laneq_f32(acc[4][1], b1, a1, 0);
+        acc[5][0] = vfmaq_laneq_f32(acc[5][0], b0, a1, 1); acc[5][1] = vfmaq_laneq_f32(acc[5][1], b1, a1, 1);
+        acc[6][0] = vfmaq_laneq_f32(acc[6][0], b0, a1, 2); acc[6][1] = vfmaq_laneq_f32(acc[6][1], b1, a1, 2);
+        acc[7][0] = vfmaq_laneq_f32(acc[7][0], b0, a1, 3); acc[7][1] = vfmaq_laneq_f32(acc[7][1], b1, a1, 3);
+        a += 8;
+        b += 8;
+    }
+    for (int i = 0; i < 8; ++i) {
+        float* c_row = c + i * ldc;
+        float32x4_t v0 = vmulq_n_f32(acc[i][0], alpha);
+        float32x4_t v1 = vmulq_n_f32(acc[i][1], alpha);
+        if (beta != 0.0f) {
+            v0 = vfmaq_n_f32(v0, vld1q_f32(c_row), beta);
+            v1 = vfmaq_n_f32(v1, vld1q_f32(c_row + 4), beta);
+        }
+        vst1q_f32(c_row, v0);
+        vst1q_f32(c_row + 4, v1);
+    }
+}
+#endif // INFERUNITY_GEMM_NEON
+
+const MicroKernel kScalarKernel = {4, 8, KernelScalar_4x8, "scalar_4x8"};
+#ifdef INFERUNITY_GEMM_X86
+const MicroKernel kAvx2Kernel = {6, 16, KernelAvx2_6x16, "avx2_6x16"};
+const MicroKernel kAvx512Kernel = {8, 32, KernelAvx512_8x32, "avx512_8x32"};
+#endif
+#ifdef INFERUNITY_GEMM_NEON
+const MicroKernel kNeonKernel = {8, 8, KernelNeon_8x8, "neon_8x8"};
+#endif
+
+bool IsKernelSupported(const MicroKernel* kernel) {
+#ifdef INFERUNITY_GEMM_X86
+    const CpuFeatures& features = GetCpuFeatures();
+    if (kernel == &kAvx512Kernel) return features.avx512f;
+    if (kernel == &kAvx2Kernel) return features.avx2 && features.fma;
+#endif
+    return kernel != nullptr;
+}
+
+const MicroKernel* DetectKernel() {
+#ifdef INFERUNITY_GEMM_X86
+    if (IsKernelSupported(&kAvx512Kernel)) return &kAvx512Kernel;
+    if (IsKernelSupported(&kAvx2Kernel)) return &kAvx2Kernel;
+#endif
+#ifdef INFERUNITY_GEMM_NEON
+    return &kNeonKernel;
+#endif
+    return &kScalarKernel;
+}
+
+const MicroKernel* FindKernel(const char* name) {
+    const MicroKernel* candidates[] = {
+        &kScalarKernel,
+#ifdef INFERUNITY_GEMM_X86
+        &kAvx2Kernel, &kAvx512Kernel,
+#endif
+#ifdef INFERUNITY_GEMM_NEON
+        &kNeonKernel,
+#endif
+    };
+    for (const MicroKernel* kernel : candidates) {
+        if (name && std::strcmp(kernel->name, name) == 0) {
+            return kernel;
+        }
+    }
+    return nullptr;
+}
+
+std::atomic<const MicroKernel*>& ActiveKernel() {
+    static std::atomic<const MicroKernel*> kernel{DetectKernel()};
+    return kernel;
+}
+
+inline int64_t RoundUp(int64_t value, int64_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// 预打包B中(jc, pc)分块的起始偏移：按N方向分块依次存放，块内按K分块依次存放
+int64_t PackedBOffset(int64_t N, int64_t K, int nr, int64_t jc, int64_t pc) {
+    const int64_t nc = std::min(kBlockN, N - jc);
+    return (jc / kBlockN) * RoundUp(kBlockN, nr) * K + RoundUp(nc, nr) * pc;
+}
+
+inline float LoadA(bool trans, const float* A, int64_t lda, int64_t i, int64_t k) {
+    return trans ? A[k * lda + i] : A[i * lda + k];
+}
+
+inline float LoadB(bool trans, const float* B, int64_t ldb, int64_t k, int64_t j) {
+    return trans ? B[j * ldb + k] : B[k * ldb + j];
+}
+
+// 打包A[i0:i0+mc, k0:k0+kc]为MR行条带：dst[strip][k][MR]，不足MR的行补0
+void PackA(bool trans, const float* A, int64_t lda, int64_t i0, int64_t k0,
+           int64_t mc, int64_t kc, int mr, float* dst) {
+    for (int64_t is = 0; is < mc; is += mr) {
+        const int64_t rows = std::min<int64_t>(mr, mc - is);
+        for (int64_t k = 0; k < kc; ++k) {
+            int64_t r = 0;
+            if (!trans) {
+                const float* src = A + (i0 + is) * lda + k0 + k;
+                for (; r < rows; ++r) {
+                    dst[r] = src[r * lda];
+                }
+            } else {
+                const float* src = A + (k0 + k) * lda + i0 + is;
+                for (; r < rows; ++r) {
+                    dst[r] = src[r];
+                }
+            }
+            for (; r < mr; ++r) {
+                dst[r] = 0.0f;
+            }
+            dst += mr;
+        }
+    }
+}
+
+// 打包B[k0:k0+kc, j0:j0+nc]为NR列条带：dst[strip][k][NR]，不足NR的列补0
+void PackB(bool trans, const float* B, int64_t ldb, int64_t k0, int64_t j0,
+           int64_t kc, int64_t nc, int nr, float* dst) {
+    for (int64_t js = 0; js < nc; js += nr) {
+        const int64_t cols = std::min<int64_t>(nr, nc - js);
+        for (int64_t k = 0; k < kc; ++k) {
+            int64_t j = 0;
+            if (!trans) {
+                const float* src = B + (k0 + k) * ldb + j0 + js;
+                std::memcpy(dst, src, static_cast<size_t>(cols) * sizeof(float));
+                j = cols;
+            } else {
+                const float* src = B + (j0 + js) * ldb + k0 + k;
+                for (; j < cols; ++j) {
+                    dst[j] = src[j * ldb];
+                }
+            }
+            for (; j < nr; ++j) {
+                dst[j] = 0.0f;
+            }
+            dst += nr;
+        }
+    }
+}
+
+// 16位浮点的一段连续元素转为FP32
+void ConvertHalfRow(const uint16_t* src, HalfType type, float* dst, int64_t count) {
+    if (type == HalfType::BFLOAT16) {
+        simd::ConvertBFloat16ToFloatSIMD(src, dst, static_cast<size_t>(count));
+    } else {
+        simd::ConvertHalfToFloatSIMD(src, dst, static_cast<size_t>(count));
+    }
+}
+
+// 与PackB相同，B以16位浮点存储：按B的存储行整段转换后再分散到条带，转换保持向量化
+void PackBHalf(bool trans, const uint16_t* B, HalfType type, int64_t ldb, int64_t k0, int64_t j0,
+               int64_t kc, int64_t nc, int nr, float* dst) {
+    thread_local std::vector<float> row;
+    if (!trans) {
+        row.resize(static_cast<size_t>(nc));
+        for (int64_t k = 0; k < kc; ++k) {
+            ConvertHalfRow(B + (k0 + k) * ldb + j0, type, row.data(), nc);
+            for (int64_t js = 0; js < nc; js += nr) {
+                const int64_t cols = std::min<int64_t>(nr, nc - js);
+                float* strip = dst + js * kc + k * nr;
+                std::memcpy(strip, row.data() + js, static_cast<size_t>(cols) * sizeof(float));
+                for (int64_t j = cols; j < nr; ++j) {
+                    strip[j] = 0.0f;
+                }
+            }
+        }
+        return;
+    }
+    row.resize(static_cast<size_t>(kc));
+    for (int64_t js = 0; js < nc; js += nr) {
+        const int64_t cols = std::min<int64_t>(nr, nc - js);
+        float* strip = dst + js * kc;
+        for (int64_t j = 0; j < nr; ++j) {
+            if (j >= cols) {
+                for (int64_t k = 0; k < kc; ++k) {
+                    strip[k * nr + j] = 0.0f;
+                }
+                continue;
+            }
+            ConvertHalfRow(B + (j0 + js + j) * ldb + k0, type, row.data(), kc);
+            for (int64_t k = 0; k < kc; ++k) {
+                strip[k * nr + j] = row[k];
+            }
+        }
+    }
+}
+
+void ApplyEpilogue(const GemmEpilogue& ep, float* C, int64_t ldc,
+                   int64_t row0, int64_t col0, int64_t m, int64_t n) {
+    for (int64_t i = 0; i < m; ++i) {
+        float* c_row = C + (row0 + i) * ldc + col0;
+        const float scale = ep.row_scale ? ep.row_scale[row0 + i] : 1.0f;
+        const float shift = ep.row_bias ? ep.row_bias[row0 + i] : 0.0f;
+        const float* col_bias = ep.col_bias ? ep.col_bias + col0 : nullptr;
+        for (int64_t j = 0; j < n; ++j) {
+            float v = scale * c_row[j] + shift;
+            if (col_bias) v += col_bias[j];
+            if (ep.relu && v < 0.0f) v = 0.0f;
+            c_row[j] = v;
+        }
+    }
+}
+
+bool HasEpilogue(const GemmEpilogue* ep) {
+    return ep && (ep->row_scale || ep->row_bias || ep->col_bias || ep->relu);
+}
+
+void ScaleC(int64_t M, int64_t N, float beta, float* C, int64_t ldc) {
+    for (int64_t i = 0; i < M; ++i) {
+        float* c_row = C + i * ldc;
+        if (beta == 0.0f) {
+            std::memset(c_row, 0, static_cast<size_t>(N) * sizeof(float));
+        } else if (beta != 1.0f) {
+            for (int64_t j = 0; j < N; ++j) {
+                c_row[j] *= beta;
+            }
+        }
+    }
+}
+
+// 小矩阵：i-k-j顺序直接累加
+void SgemmSmall(bool trans_a, bool trans_b, int64_t M, int64_t N, int64_t K,
+                float alpha, const float* A, int64_t lda, const float* B, int64_t ldb,
+                float beta, float* C, int64_t ldc) {
+    ScaleC(M, N, beta, C, ldc);
+    for (int64_t i = 0; i < M; ++i) {
+        float* c_row = C + i * ldc;
+        for (int64_t k = 0; k < K; ++k) {
+            const float a = alpha * LoadA(trans_a, A, lda, i, k);
+            for (int64_t j = 0; j < N; ++j) {
+                c_row[j] += a * LoadB(trans_b, B, ldb, k, j);
+            }
+        }
+    }
+}
+
+// 分块主循环；prepacked_a/prepacked_b非空时直接读取预打包的面板，跳过对应操作数的打包
+void SgemmBlocked(const MicroKernel& kernel, bool trans_a, bool trans_b,
+                  int64_t M, int64_t N, int64_t K,
+                  float alpha,
+                  const float* A, int64_t lda, const PackedMatrix* prepacked_a,
+                  const float* B, int64_t ldb, const PackedMatrix* prepacked_b,
+                  float beta,
+                  float* C, int64_t ldc,
+                  bool has_epilogue, const GemmEpilogue* epilogue,
+                  const uint16_t* half_b = nullptr, HalfType half_type = HalfType::FLOAT16) {
+    const int mr = kernel.mr;
+    const int nr = kernel.nr;
+    const int64_t block_m = std::max<int64_t>(mr, (kBlockMTarget / mr) * mr);
+    
+    // 打包缓冲按线程私有，允许多个线程同时调用
+    thread_local std::vector<float> packed_a;
+    thread_local std::vector<float> packed_b;
+    const int64_t kc_max = std::min(K, kBlockK);
+    const int64_t mc_max = std::min(M, block_m);
+    const int64_t nc_max = std::min(N, kBlockN);
+    if (!prepacked_a) {
+        packed_a.resize(static_cast<size_t>(RoundUp(mc_max, mr) * kc_max));
+    }
+    if (!prepacked_b) {
+        packed_b.resize(static_cast<size_t>(RoundUp(nc_max, nr) * kc_max));
+    }
+    
+    alignas(64) float tile[kMaxMR * kMaxNR];
+    
+    for (int64_t jc = 0; jc < N; jc += kBlockN) {
+        const int64_t nc = std::min(kBlockN, N - jc);
+        for (int64_t pc = 0; pc < K; pc += kBlockK) {
+            const int64_t kc = std::min(kBlockK, K - pc);
+            const float beta_eff = pc == 0 ? beta : 1.0f;
+            const bool last_k = pc + kc == K;
+            const float* panel_b = prepacked_b ? prepacked_b->data.data() + PackedBOffset(N, K, nr, jc, pc)
+                                               : packed_b.data();
+            if (half_b) {
+                PackBHalf(trans_b, half_b, half_type, ldb, pc, jc, kc, nc, nr, packed_b.data());
+            } else if (!prepacked_b) {
+                PackB(trans_b, B, ldb, pc, jc, kc, nc, nr, packed_b.data());
+            }
+    
+            for (int64_t ic = 0; ic < M; ic += block_m) {
+                const int64_t mc = std::min(block_m, M - ic);
+                const float* panel_a = prepacked_a ? prepacked_a->data.data() + RoundUp(M, mr) * pc + ic * kc
+                                                   : packed_a.data();
+                if (!prepacked_a) {
+                    PackA(trans_a, A, lda, ic, pc, mc, kc, mr, packed_a.data());
+                }
+    
+                for (int64_t jr = 0; jr < nc; jr += nr) {
+                    const int64_t n_sub = std::min<int64_t>(nr, nc - jr);
+                    const float* pb = panel_b + jr * kc;
+                    for (int64_t ir = 0; ir < mc; ir += mr) {
+                        const int64_t m_sub = std::min<int64_t>(mr, mc - ir);
+                        const float* pa = panel_a + ir * kc;
+                        float* c_tile = C + (ic + ir) * ldc + jc + jr;
+    
+                        if (m_sub == mr && n_sub == nr) {
+                            kernel.fn(kc, pa, pb, c_tile, ldc, alpha, beta_eff);
+                        } else {
+                            // 边缘子块：先写入临时缓冲再拷回有效区域
+                            kernel.fn(kc, pa, pb, tile, nr, alpha, 0.0f);
+                            for (int64_t i = 0; i < m_sub; ++i) {
+                                float* c_row = c_tile + i * ldc;
+                                const float* t_row = tile + i * nr;
+                                for (int64_t j = 0; j < n_sub; ++j) {
+                                    c_row[j] = beta_eff == 0.0f ? t_row[j]
+                                                                : t_row[j] + beta_eff * c_row[j];
+                                }
+                            }
+                        }
+    
+                        if (last_k && has_epilogue) {
+                            ApplyEpilogue(*epilogue, C, ldc, ic + ir, jc + jr, m_sub, n_sub);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// BF16计算核：AMX-BF16 > AVX-512-BF16 > 无
+struct Bf16Kernel {
+    Bf16GemmFn fn;
+    const char* name;
+};
+
+const Bf16Kernel kNoBf16Kernel = {nullptr, "none"};
+const Bf16Kernel kAvx512Bf16Kernel = {GetAvx512Bf16Gemm(), "avx512_bf16"};
+const Bf16Kernel kAmxBf16Kernel = {GetAmxBf16Gemm(), "amx_bf16"};
+
+bool IsBf16KernelSupported(const Bf16Kernel* kernel) {
+    if (!kernel->fn) return kernel == &kNoBf16Kernel;
+    const CpuFeatures& features = GetCpuFeatures();
+    if (kernel == &kAmxBf16Kernel) return features.amx_bf16;
+    if (kernel == &kAvx512Bf16Kernel) return features.avx512_bf16;
+    return false;
+}
+
+const Bf16Kernel* DetectBf16Kernel() {
+    if (IsBf16KernelSupported(&kAmxBf16Kernel)) return &kAmxBf16Kernel;
+    if (IsBf16KernelSupported(&kAvx512Bf16Kernel)) return &kAvx512Bf16Kernel;
+    return &kNoBf16Kernel;
+}
+
+std::atomic<const Bf16Kernel*>& ActiveBf16Kernel() {
+    static std::atomic<const Bf16Kernel*> kernel{DetectBf16Kernel()};
+    return kernel;
+}
+
+// SgemmBf16每次处理的A行数：A的BF16对与FP32结果缓冲按此大小分配
+constexpr int64_t kBf16BlockM = 64;
+
+// 没有原生核时的标量计算（与原生核同样先舍入到BF16再以FP32累加）
+void GemmBf16Reference(const uint32_t* a, const uint32_t* b, float* c,
+                       int64_t m, int64_t n_pad, int64_t k_pairs) {
+    for (int64_t i = 0; i < m; ++i) {
+        float* c_row = c + i * n_pad;
+        std::memset(c_row, 0, static_cast<size_t>(n_pad) * sizeof(float));
+        for (int64_t p = 0; p < k_pairs; ++p) {
+            const uint32_t pair = a[i * k_pairs + p];
+            const float a0 = BFloat16ToFloat(static_cast<uint16_t>(pair & 0xFFFFu));
+            const float a1 = BFloat16ToFloat(static_cast<uint16_t>(pair >> 16));
+            const uint32_t* b_row = b + p * n_pad;
+            for (int64_t j = 0; j < n_pad; ++j) {
+                c_row[j] += a0 * BFloat16ToFloat(static_cast<uint16_t>(b_row[j] & 0xFFFFu)) +
+                            a1 * BFloat16ToFloat(static_cast<uint16_t>(b_row[j] >> 16));
+            }
+        }
+    }
+}
+
+// 按load(k, j)返回的BF16位打包op(B)
+template <typename Load>
+void PackBf16Pairs(int64_t K, int64_t N, Load load, PackedBf16Matrix* packed) {
+    packed->rows = K;
+    packed->cols = N;
+    packed->k_pairs = RoundUp((K + 1) / 2, 16);
+    packed->n_pad = RoundUp(N, 16);
+    packed->data.assign(static_cast<size_t>(packed->k_pairs * packed->n_pad), 0u);
+    for (int64_t k = 0; k < K; ++k) {
+        uint32_t* row = packed->data.data() + (k / 2) * packed->n_pad;
+        const int shift = (k & 1) ? 16 : 0;
+        for (int64_t j = 0; j < N; ++j) {
+            row[j] |= static_cast<uint32_t>(load(k, j)) << shift;
+        }
+    }
+}
+
+// 瘦矩阵：alpha == 1且beta == 0时内核直接写C，否则先写入线程局部的部分积再合并
+void SgemmSkinnyImpl(bool trans_b, int64_t M, int64_t N, int64_t K, float alpha,
+                     const float* A, int64_t lda, const void* B, int b_type, int64_t ldb,
+                     float beta, float* C, int64_t ldc, const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    if (alpha == 1.0f && beta == 0.0f) {
+        simd::SkinnyGemmSIMD(A, static_cast<size_t>(lda), B, b_type, static_cast<size_t>(ldb), trans_b,
+                             C, static_cast<size_t>(ldc), static_cast<size_t>(M), static_cast<size_t>(N),
+                             static_cast<size_t>(std::max<int64_t>(K, 0)));
+        if (HasEpilogue(epilogue)) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    thread_local std::vector<float> partial;
+    partial.resize(static_cast<size_t>(M * N));
+    simd::SkinnyGemmSIMD(A, static_cast<size_t>(lda), B, b_type, static_cast<size_t>(ldb), trans_b,
+                         partial.data(), static_cast<size_t>(N), static_cast<size_t>(M), static_cast<size_t>(N),
+                         static_cast<size_t>(std::max<int64_t>(K, 0)));
+    const float* partials[1] = {partial.data()};
+    SkinnyGemmReduce(M, N, partials, 1, N, alpha, beta, C, ldc, epilogue);
+}
+
+inline int SkinnyBType(HalfType type) {
+    return type == HalfType::BFLOAT16 ? 2 : 1;
+}
+
+} // anonymous namespace
+
+void SgemmPacked(bool trans_a, bool trans_b,
+                 int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const float* B, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    const bool has_epilogue = HasEpilogue(epilogue);
+    if (K <= 0 || alpha == 0.0f) {
+        ScaleC(M, N, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    if (M * N * K <= kSmallGemmFlops) {
+        SgemmSmall(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    if (!trans_a && M <= kSkinnyMaxRows) {
+        SgemmSkinnyImpl(trans_b, M, N, K, alpha, A, lda, B, 0, ldb, beta, C, ldc, epilogue);
+        return;
+    }
+    
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    SgemmBlocked(kernel, trans_a, trans_b, M, N, K, alpha, A, lda, nullptr, B, ldb, nullptr,
+                 beta, C, ldc, has_epilogue, epilogue);
+}
+
+void Sgemm(bool trans_a, bool trans_b,
+           int64_t M, int64_t N, int64_t K,
+           float alpha,
+           const float* A, int64_t lda,
+           const float* B, int64_t ldb,
+           float beta,
+           float* C, int64_t ldc,
+           const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+#if defined(INFERUNITY_USE_ACCELERATE) || defined(INFERUNITY_USE_OPENBLAS)
+    if (K > 0 && M * N * K > kSmallGemmFlops) {
+        cblas_sgemm(CblasRowMajor,
+                    trans_a ? CblasTrans : CblasNoTrans,
+                    trans_b ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(M), static_cast<int>(N), static_cast<int>(K),
+                    alpha, A, static_cast<int>(lda),
+                    B, static_cast<int>(ldb),
+                    beta, C, static_cast<int>(ldc));
+        if (HasEpilogue(epilogue)) {
+            ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        }
+        return;
+    }
+#endif
+    SgemmPacked(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+}
+
+void PackMatrixA(bool trans_a, int64_t M, int64_t K, const float* A, int64_t lda,
+                 PackedMatrix* packed) {
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    const int mr = kernel.mr;
+    const int64_t m_pad = RoundUp(M, mr);
+    packed->rows = M;
+    packed->cols = K;
+    packed->panel = mr;
+    packed->kernel = kernel.name;
+    packed->data.assign(static_cast<size_t>(m_pad * K), 0.0f);
+    // 每个K分块内整列M一次打包，条带顺序与逐MC块打包一致
+    for (int64_t pc = 0; pc < K; pc += kBlockK) {
+        const int64_t kc = std::min(kBlockK, K - pc);
+        PackA(trans_a, A, lda, 0, pc, M, kc, mr, packed->data.data() + m_pad * pc);
+    }
+}
+
+void PackMatrixB(bool trans_b, int64_t K, int64_t N, const float* B, int64_t ldb,
+                 PackedMatrix* packed) {
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    const int nr = kernel.nr;
+    packed->rows = K;
+    packed->cols = N;
+    packed->panel = nr;
+    packed->kernel = kernel.name;
+    packed->data.clear();
+    if (N <= 0 || K <= 0) {
+        return;
+    }
+    const int64_t last_jc = ((N - 1) / kBlockN) * kBlockN;
+    packed->data.assign(static_cast<size_t>(PackedBOffset(N, K, nr, last_jc, 0) +
+                                            RoundUp(N - last_jc, nr) * K), 0.0f);
+    for (int64_t jc = 0; jc < N; jc += kBlockN) {
+        const int64_t nc = std::min(kBlockN, N - jc);
+        for (int64_t pc = 0; pc < K; pc += kBlockK) {
+            const int64_t kc = std::min(kBlockK, K - pc);
+            PackB(trans_b, B, ldb, pc, jc, kc, nc, nr,
+                  packed->data.data() + PackedBOffset(N, K, nr, jc, pc));
+        }
+    }
+}
+
+size_t PackedMatrixABytes(int64_t M, int64_t K) {
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    return M > 0 && K > 0 ? static_cast<size_t>(RoundUp(M, kernel.mr) * K) * sizeof(float) : 0;
+}
+
+size_t PackedMatrixBBytes(int64_t K, int64_t N) {
+    if (N <= 0 || K <= 0) {
+        return 0;
+    }
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    const int64_t last_jc = ((N - 1) / kBlockN) * kBlockN;
+    return static_cast<size_t>(PackedBOffset(N, K, kernel.nr, last_jc, 0) + RoundUp(N - last_jc, kernel.nr) * K) *
+           sizeof(float);
+}
+
+size_t PackedBf16MatrixBytes(int64_t K, int64_t N) {
+    return K > 0 && N > 0 ? static_cast<size_t>(RoundUp((K + 1) / 2, 16) * RoundUp(N, 16)) * sizeof(uint32_t) : 0;
+}
+
+size_t SgemmScratchBytes(int64_t M, int64_t N, int64_t K, bool prepacked_a, bool prepacked_b) {
+    if (M <= 0 || N <= 0 || K <= 0) {
+        return 0;
+    }
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    const int64_t block_m = std::max<int64_t>(kernel.mr, (kBlockMTarget / kernel.mr) * kernel.mr);
+    const int64_t kc_max = std::min(K, kBlockK);
+    int64_t floats = 0;
+    if (!prepacked_a) {
+        floats += RoundUp(std::min(M, block_m), kernel.mr) * kc_max;
+    }
+    if (!prepacked_b) {
+        floats += RoundUp(std::min(N, kBlockN), kernel.nr) * kc_max;
+    }
+    return static_cast<size_t>(floats) * sizeof(float);
+}
+
+void SgemmPrepacked(bool trans_a, bool trans_b,
+                    int64_t M, int64_t N, int64_t K,
+                    float alpha,
+                    const float* A, int64_t lda, const PackedMatrix* packed_a,
+                    const float* B, int64_t ldb, const PackedMatrix* packed_b,
+                    float beta,
+                    float* C, int64_t ldc,
+                    const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    const bool has_epilogue = HasEpilogue(epilogue);
+    if (K <= 0 || alpha == 0.0f) {
+        ScaleC(M, N, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    // 使用打包时的微内核，面板宽度才能对齐
+    if (packed_a && packed_b && std::strcmp(packed_a->kernel, packed_b->kernel) != 0) {
+        packed_b = nullptr;  // 两侧面板宽度不一致时B退回现场打包
+    }
+    const PackedMatrix* packed = packed_a ? packed_a : packed_b;
+    const MicroKernel* kernel = packed ? FindKernel(packed->kernel) : nullptr;
+    if (!kernel) {
+        kernel = ActiveKernel().load(std::memory_order_relaxed);
+    }
+    SgemmBlocked(*kernel, trans_a, trans_b, M, N, K, alpha, A, lda, packed_a, B, ldb, packed_b,
+                 beta, C, ldc, has_epilogue, epilogue);
+}
+
+void SgemmHalfB(bool trans_a, bool trans_b,
+                int64_t M, int64_t N, int64_t K,
+                float alpha,
+                const float* A, int64_t lda,
+                const uint16_t* B, HalfType b_type, int64_t ldb,
+                float beta,
+                float* C, int64_t ldc,
+                const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    const bool has_epilogue = HasEpilogue(epilogue);
+    if (K <= 0 || alpha == 0.0f) {
+        ScaleC(M, N, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    if (M * N * K <= kSmallGemmFlops) {
+        // 小矩阵：整个op(B)转为FP32（按存储的行，转置关系不变）
+        thread_local std::vector<float> converted;
+        const int64_t rows = trans_b ? N : K;
+        const int64_t cols = trans_b ? K : N;
+        converted.resize(static_cast<size_t>(rows * cols));
+        for (int64_t r = 0; r < rows; ++r) {
+            ConvertHalfRow(B + r * ldb, b_type, converted.data() + r * cols, cols);
+        }
+        SgemmSmall(trans_a, trans_b, M, N, K, alpha, A, lda, converted.data(), cols, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    if (!trans_a && M <= kSkinnyMaxRows) {
+        SgemmSkinnyImpl(trans_b, M, N, K, alpha, A, lda, B, SkinnyBType(b_type), ldb, beta, C, ldc, epilogue);
+        return;
+    }
+    
+    const MicroKernel& kernel = *ActiveKernel().load(std::memory_order_relaxed);
+    SgemmBlocked(kernel, trans_a, trans_b, M, N, K, alpha, A, lda, nullptr, nullptr, ldb, nullptr,
+                 beta, C, ldc, has_epilogue, epilogue, B, b_type);
+}
+
+void SgemmSkinny(bool trans_b, int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const float* B, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue) {
+    SgemmSkinnyImpl(trans_b, M, N, K, alpha, A, lda, B, 0, ldb, beta, C, ldc, epilogue);
+}
+
+void SgemmSkinny(bool trans_b, int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const uint16_t* B, HalfType b_type, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue) {
+    SgemmSkinnyImpl(trans_b, M, N, K, alpha, A, lda, B, SkinnyBType(b_type), ldb, beta, C, ldc, epilogue);
+}
+
+void SkinnyGemmPartial(bool trans_b, int64_t M, int64_t N, int64_t K,
+                       const float* A, int64_t lda,
+                       const float* B, int64_t ldb,
+                       float* P, int64_t ldp) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    simd::SkinnyGemmSIMD(A, static_cast<size_t>(lda), B, 0, static_cast<size_t>(ldb), trans_b,
+                         P, static_cast<size_t>(ldp), static_cast<size_t>(M), static_cast<size_t>(N),
+                         static_cast<size_t>(std::max<int64_t>(K, 0)));
+}
+
+void SkinnyGemmPartial(bool trans_b, int64_t M, int64_t N, int64_t K,
+                       const float* A, int64_t lda,
+                       const uint16_t* B, HalfType b_type, int64_t ldb,
+                       float* P, int64_t ldp) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    simd::SkinnyGemmSIMD(A, static_cast<size_t>(lda), B, SkinnyBType(b_type), static_cast<size_t>(ldb), trans_b,
+                         P, static_cast<size_t>(ldp), static_cast<size_t>(M), static_cast<size_t>(N),
+                         static_cast<size_t>(std::max<int64_t>(K, 0)));
+}
+
+void SkinnyGemmReduce(int64_t M, int64_t N, const float* const* partials, int64_t count, int64_t ldp,
+                      float alpha, float beta, float* C, int64_t ldc,
+                      const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    const size_t n = static_cast<size_t>(N);
+    for (int64_t i = 0; i < M; ++i) {
+        float* c_row = C + i * ldc;
+        if (beta == 0.0f) {
+            std::memset(c_row, 0, n * sizeof(float));
+        } else if (beta != 1.0f) {
+            simd::ScaleSIMD(c_row, c_row, n, beta);
+        }
+        for (int64_t s = 0; s < count; ++s) {
+            simd::ScaleAddSIMD(partials[s] + i * ldp, alpha, c_row, n);
+        }
+    }
+    if (HasEpilogue(epilogue)) {
+        ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+    }
+}
+
+void PackMatrixBBf16(bool trans_b, int64_t K, int64_t N, const float* B, int64_t ldb,
+                     PackedBf16Matrix* packed) {
+    PackBf16Pairs(K, N, [&](int64_t k, int64_t j) {
+        return FloatToBFloat16(LoadB(trans_b, B, ldb, k, j));
+    }, packed);
+}
+
+void PackMatrixBBf16(bool trans_b, int64_t K, int64_t N, const uint16_t* B, HalfType b_type,
+                     int64_t ldb, PackedBf16Matrix* packed) {
+    PackBf16Pairs(K, N, [&](int64_t k, int64_t j) {
+        const uint16_t v = trans_b ? B[j * ldb + k] : B[k * ldb + j];
+        return b_type == HalfType::BFLOAT16 ? v : FloatToBFloat16(HalfToFloat(v));
+    }, packed);
+}
+
+void SgemmBf16(int64_t M, int64_t N, int64_t K,
+               float alpha,
+               const float* A, int64_t lda,
+               const PackedBf16Matrix& B,
+               float beta,
+               float* C, int64_t ldc,
+               const GemmEpilogue* epilogue) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+    const bool has_epilogue = HasEpilogue(epilogue);
+    if (K <= 0 || alpha == 0.0f) {
+        ScaleC(M, N, beta, C, ldc);
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, 0, 0, M, N);
+        return;
+    }
+    const Bf16GemmFn fn = ActiveBf16Kernel().load(std::memory_order_relaxed)->fn;
+    const int64_t k_pairs = B.k_pairs;
+    const int64_t n_pad = B.n_pad;
+    
+    thread_local std::vector<uint16_t> a_row;
+    thread_local std::vector<uint32_t> a_pairs;
+    thread_local std::vector<float> result;
+    a_row.assign(static_cast<size_t>(k_pairs * 2), 0);
+    
+    for (int64_t i0 = 0; i0 < M; i0 += kBf16BlockM) {
+        const int64_t rows = std::min(kBf16BlockM, M - i0);
+        const int64_t rows_pad = RoundUp(rows, 16);
+        // A的行舍入为BF16，k补0到k_pairs对，不足16的行补0
+        a_pairs.assign(static_cast<size_t>(rows_pad * k_pairs), 0u);
+        for (int64_t r = 0; r < rows; ++r) {
+            simd::ConvertFloatToBFloat16SIMD(A + (i0 + r) * lda, a_row.data(), static_cast<size_t>(K));
+            std::memcpy(a_pairs.data() + r * k_pairs, a_row.data(),
+                        static_cast<size_t>(k_pairs) * sizeof(uint32_t));
+        }
+        result.resize(static_cast<size_t>(rows_pad * n_pad));
+        (fn ? fn : GemmBf16Reference)(a_pairs.data(), B.data.data(), result.data(), rows_pad, n_pad, k_pairs);
+    
+        for (int64_t r = 0; r < rows; ++r) {
+            float* c_row = C + (i0 + r) * ldc;
+            const float* t_row = result.data() + r * n_pad;
+            for (int64_t j = 0; j < N; ++j) {
+                c_row[j] = beta == 0.0f ? alpha * t_row[j] : alpha * t_row[j] + beta * c_row[j];
+            }
+        }
+        if (has_epilogue) ApplyEpilogue(*epilogue, C, ldc, i0, 0, rows, N);
+    }
+}
+
+bool HasBf16Compute() {
+    return ActiveBf16Kernel().load(std::memory_order_relaxed)->fn != nullptr;
+}
+
+const char* GetBf16KernelName() {
+    return ActiveBf16Kernel().load(std::memory_order_relaxed)->name;
+}
+
+bool SetBf16Kernel(const char* name) {
+    if (std::strcmp(name, "auto") == 0) {
+        ActiveBf16Kernel().store(DetectBf16Kernel(), std::memory_order_relaxed);
+        return true;
+    }
+    for (const Bf16Kernel* kernel : {&kNoBf16Kernel, &kAvx512Bf16Kernel, &kAmxBf16Kernel}) {
+        if (std::strcmp(kernel->name, name) == 0) {
+            if (!IsBf16KernelSupported(kernel)) return false;
+            ActiveBf16Kernel().store(kernel, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UsesExternalBlas() {
+#if defined(INFERUNITY_USE_ACCELERATE) || defined(INFERUNITY_USE_OPENBLAS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* GetMicroKernelName() {
+    return ActiveKernel().load(std::memory_order_relaxed)->name;
+}
+
+bool SetMicroKernel(const char* name) {
+    if (const MicroKernel* kernel = FindKernel(name)) {
+        if (!IsKernelSupported(kernel)) return false;
+        ActiveKernel().store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+    if (std::strcmp(name, "auto") == 0) {
+        ActiveKernel().store(DetectKernel(), std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+} // namespace gemm
+} // namespace inferunity
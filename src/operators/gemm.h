@@ -0,0 +1,181 @@
+// 通用矩阵乘法（SGEMM）
+// 参考BLAS的sgemm接口和BLIS的分块/打包设计，供MatMul、融合算子和卷积的im2col路径共享
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inferunity {
+namespace gemm {
+
+// 乘法结果写回C之后的逐元素后处理（在每个C子块仍在缓存中时完成）
+// C[i][j] = relu?(row_scale[i] * C[i][j] + row_bias[i] + col_bias[j])
+struct GemmEpilogue {
+    const float* row_scale = nullptr;  // 长度M，如卷积折叠后的BN缩放
+    const float* row_bias = nullptr;   // 长度M，如卷积的输出通道bias
+    const float* col_bias = nullptr;   // 长度N，如全连接层bias
+    bool relu = false;
+};
+
+// 预打包的常量操作数（参考MLAS的MlasGemmPackB）：op(X)按微内核的面板宽度和K分块排布一次，
+// 之后每次调用跳过该操作数的打包；打包结果绑定打包时的微内核
+struct PackedMatrix {
+    int64_t rows = 0;              // A为M，B为K
+    int64_t cols = 0;              // A为K，B为N
+    int panel = 0;                 // A为MR，B为NR
+    const char* kernel = nullptr;  // 微内核名称
+    std::vector<float> data;
+};
+
+// C[M,N] = alpha * op(A)[M,K] * op(B)[K,N] + beta * C（行主序），随后应用epilogue
+// op(X) = trans ? X^T : X；lda/ldb/ldc为各矩阵在内存中的行跨度
+// beta == 0 时不读取C的原有内容
+// 配置了BLAS（OpenBLAS/Accelerate）时调用cblas_sgemm，否则使用内置的SgemmPacked
+void Sgemm(bool trans_a, bool trans_b,
+           int64_t M, int64_t N, int64_t K,
+           float alpha,
+           const float* A, int64_t lda,
+           const float* B, int64_t ldb,
+           float beta,
+           float* C, int64_t ldc,
+           const GemmEpilogue* epilogue = nullptr);
+
+// 内置的打包分块GEMM：A/B面板打包 + MRxNR寄存器分块微内核
+// 微内核在首次调用时按CPU特性选择（AVX-512 / AVX2+FMA / NEON / 标量）
+void SgemmPacked(bool trans_a, bool trans_b,
+                 int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const float* B, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue = nullptr);
+
+// 打包op(A)[M,K] / op(B)[K,N]
+void PackMatrixA(bool trans_a, int64_t M, int64_t K, const float* A, int64_t lda,
+                 PackedMatrix* packed);
+void PackMatrixB(bool trans_b, int64_t K, int64_t N, const float* B, int64_t ldb,
+                 PackedMatrix* packed);
+
+// 内存估计用（不打包）：PackMatrixA/PackMatrixB/PackMatrixBBf16结果的字节数，
+// 以及SgemmPacked每个调用线程的私有打包缓冲的字节数（已预打包的一侧不需要缓冲）
+size_t PackedMatrixABytes(int64_t M, int64_t K);
+size_t PackedMatrixBBytes(int64_t K, int64_t N);
+size_t PackedBf16MatrixBytes(int64_t K, int64_t N);
+size_t SgemmScratchBytes(int64_t M, int64_t N, int64_t K, bool prepacked_a, bool prepacked_b);
+
+// 与SgemmPacked相同，packed_a/packed_b非空时替代对应的A/B（此时指针与跨度被忽略），
+// 其rows/cols须与M、N、K一致。总是使用内置GEMM：打包格式只对内置微内核有意义
+void SgemmPrepacked(bool trans_a, bool trans_b,
+                    int64_t M, int64_t N, int64_t K,
+                    float alpha,
+                    const float* A, int64_t lda, const PackedMatrix* packed_a,
+                    const float* B, int64_t ldb, const PackedMatrix* packed_b,
+                    float beta,
+                    float* C, int64_t ldc,
+                    const GemmEpilogue* epilogue = nullptr);
+
+// 16位浮点存储的B：FLOAT16为IEEE binary16，BFLOAT16为FP32的高16位
+enum class HalfType {
+    FLOAT16,
+    BFLOAT16
+};
+
+// 与SgemmPacked相同，但B以16位浮点存储（权重按半精度存放以减少内存带宽）：
+// 打包B的面板时转换为FP32（x86为F16C/AVX-512的vcvtph2ps，ARM为NEON的fcvtl），累加总是FP32
+void SgemmHalfB(bool trans_a, bool trans_b,
+                int64_t M, int64_t N, int64_t K,
+                float alpha,
+                const float* A, int64_t lda,
+                const uint16_t* B, HalfType b_type, int64_t ldb,
+                float beta,
+                float* C, int64_t ldc,
+                const GemmEpilogue* epilogue = nullptr);
+
+// ---- 瘦矩阵乘（M不超过kSkinnyMaxRows，如LLM解码阶段每步一个或几个token）----
+// 计算受op(B)的内存带宽限制：不打包A、不按大M分块，M行的累加器常驻寄存器，op(B)的每个元素只读一遍
+// 并提前预取，16位浮点的B在寄存器中转换（见simd::SkinnyGemmSIMD）。A不转置且M不超过该值时
+// SgemmPacked与SgemmHalfB自动使用；RunBatchedMatMul在此基础上按N分块、N不够分时再切分K
+constexpr int64_t kSkinnyMaxRows = 8;
+
+// 与SgemmPacked/SgemmHalfB语义相同的瘦矩阵乘，A不转置
+void SgemmSkinny(bool trans_b, int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const float* B, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue = nullptr);
+void SgemmSkinny(bool trans_b, int64_t M, int64_t N, int64_t K,
+                 float alpha,
+                 const float* A, int64_t lda,
+                 const uint16_t* B, HalfType b_type, int64_t ldb,
+                 float beta,
+                 float* C, int64_t ldc,
+                 const GemmEpilogue* epilogue = nullptr);
+
+// K切分的一段：P[M,N] = A[M,K] * op(B)[K,N]，覆盖P且不乘alpha；A、B传入该段起点k0处的指针
+void SkinnyGemmPartial(bool trans_b, int64_t M, int64_t N, int64_t K,
+                       const float* A, int64_t lda,
+                       const float* B, int64_t ldb,
+                       float* P, int64_t ldp);
+void SkinnyGemmPartial(bool trans_b, int64_t M, int64_t N, int64_t K,
+                       const float* A, int64_t lda,
+                       const uint16_t* B, HalfType b_type, int64_t ldb,
+                       float* P, int64_t ldp);
+
+// 合并各段的部分积：C = alpha * sum(partials[s]) + beta * C，随后应用epilogue；
+// partials[s]均为[M,N]、行跨度ldp，不能与C重叠
+void SkinnyGemmReduce(int64_t M, int64_t N, const float* const* partials, int64_t count, int64_t ldp,
+                      float alpha, float beta, float* C, int64_t ldc,
+                      const GemmEpilogue* epilogue = nullptr);
+
+// BF16原生计算（参考oneDNN的brgemm与MLAS的SBGEMM）：op(B)[K,N]转为BF16后按k两两成对打包为
+// [k_pairs][n_pad]（每个uint32为相邻两个k的bf16），k_pairs与n_pad补齐到16的整倍数；
+// A在计算时就近舍入为BF16并按同样方式成对，由vdpbf16ps/tdpbf16ps以FP32累加
+struct PackedBf16Matrix {
+    int64_t rows = 0;     // K
+    int64_t cols = 0;     // N
+    int64_t k_pairs = 0;
+    int64_t n_pad = 0;
+    std::vector<uint32_t> data;
+};
+
+// 从FP32或16位浮点存储的op(B)打包
+void PackMatrixBBf16(bool trans_b, int64_t K, int64_t N, const float* B, int64_t ldb,
+                     PackedBf16Matrix* packed);
+void PackMatrixBBf16(bool trans_b, int64_t K, int64_t N, const uint16_t* B, HalfType b_type,
+                     int64_t ldb, PackedBf16Matrix* packed);
+
+// C[M,N] = alpha * A[M,K] * B + beta * C，A不转置；没有原生核时退化为同样先舍入到BF16的标量计算
+void SgemmBf16(int64_t M, int64_t N, int64_t K,
+               float alpha,
+               const float* A, int64_t lda,
+               const PackedBf16Matrix& B,
+               float beta,
+               float* C, int64_t ldc,
+               const GemmEpilogue* epilogue = nullptr);
+
+// 是否有BF16原生计算核（AMX-BF16或AVX-512-BF16）
+bool HasBf16Compute();
+
+// 当前的BF16计算核名称："amx_bf16"、"avx512_bf16"或"none"（标量）
+const char* GetBf16KernelName();
+
+// 按名称强制指定BF16计算核（"auto"恢复自动选择），CPU不支持时返回false；用于测试和基准对比
+bool SetBf16Kernel(const char* name);
+
+// 是否链接了外部BLAS：此时Sgemm的大矩阵走cblas_sgemm，为内置GEMM预打包常量没有收益
+bool UsesExternalBlas();
+
+// 当前选用的微内核名称，如"avx512_8x32"、"avx2_6x16"
+const char* GetMicroKernelName();
+
+// 按名称强制指定微内核（"auto"恢复自动选择），CPU不支持或名称未知时返回false
+// 主要用于测试和基准对比，不应在推理过程中切换
+bool SetMicroKernel(const char* name);
+
+} // namespace gemm
+} // namespace inferunity
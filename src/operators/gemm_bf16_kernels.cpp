@@ -0,0 +1,103 @@
+// BF16原生计算核（以-mavx512f -mavx512bf16 -mamx-tile -mamx-bf16编译）
+// 参考oneDNN的brgemm：B按k两两成对打包，A的一对k广播到所有通道后与16列点积（vdpbf16ps），
+// AMX上一条tdpbf16ps完成16x16输出块的32个k。本文件只包含计算核，打包与alpha/beta/epilogue见gemm.cpp；
+// 与SIMD核相同，这里不使用std中的内联函数，避免与其他翻译单元合并出带有新指令的副本
+
+#include "gemm_bf16_kernels.h"
+
+#if defined(__x86_64__) && defined(__AVX512F__) && defined(__AVX512BF16__)
+#include <immintrin.h>
+#define INFERUNITY_GEMM_AVX512_BF16 1
+#if defined(__AMX_TILE__) && defined(__AMX_BF16__)
+#define INFERUNITY_GEMM_AMX_BF16 1
+#endif
+#endif
+
+namespace inferunity {
+namespace gemm {
+
+namespace {
+
+#ifdef INFERUNITY_GEMM_AVX512_BF16
+void GemmAvx512Bf16(const uint32_t* a, const uint32_t* b, float* c,
+                    int64_t m, int64_t n_pad, int64_t k_pairs) {
+    constexpr int kRows = 8;
+    for (int64_t i = 0; i < m; i += kRows) {
+        const uint32_t* a_rows = a + i * k_pairs;
+        for (int64_t j = 0; j < n_pad; j += 16) {
+            __m512 acc[kRows];
+            for (int r = 0; r < kRows; ++r) {
+                acc[r] = _mm512_setzero_ps();
+            }
+            const uint32_t* b_col = b + j;
+            for (int64_t p = 0; p < k_pairs; ++p) {
+                const __m512bh vb = (__m512bh)_mm512_loadu_si512(b_col + p * n_pad);
+                for (int r = 0; r < kRows; ++r) {
+                    const __m512bh va = (__m512bh)_mm512_set1_epi32(static_cast<int>(a_rows[r * k_pairs + p]));
+                    acc[r] = _mm512_dpbf16_ps(acc[r], va, vb);
+                }
+            }
+            for (int r = 0; r < kRows; ++r) {
+                _mm512_storeu_ps(c + (i + r) * n_pad + j, acc[r]);
+            }
+        }
+    }
+}
+#endif
+
+#ifdef INFERUNITY_GEMM_AMX_BF16
+// tile配置与amx整数核相同：tmm0为16x16的FP32输出，tmm1为A的16行 x 16对k，tmm2为B的16对k x 16列
+struct alignas(64) AmxTileConfig {
+    uint8_t palette_id;
+    uint8_t start_row;
+    uint8_t reserved[14];
+    uint16_t colsb[16];
+    uint8_t rows[16];
+};
+
+void GemmAmxBf16(const uint32_t* a, const uint32_t* b, float* c,
+                 int64_t m, int64_t n_pad, int64_t k_pairs) {
+    AmxTileConfig config = {};
+    config.palette_id = 1;
+    for (int t = 0; t < 3; ++t) {
+        config.rows[t] = 16;
+        config.colsb[t] = 64;
+    }
+    _tile_loadconfig(&config);
+    const int64_t a_stride = k_pairs * static_cast<int64_t>(sizeof(uint32_t));
+    const int64_t b_stride = n_pad * static_cast<int64_t>(sizeof(uint32_t));
+    for (int64_t i = 0; i < m; i += 16) {
+        for (int64_t j = 0; j < n_pad; j += 16) {
+            _tile_zero(0);
+            for (int64_t p = 0; p < k_pairs; p += 16) {
+                _tile_loadd(1, a + i * k_pairs + p, a_stride);
+                _tile_loadd(2, b + p * n_pad + j, b_stride);
+                _tile_dpbf16ps(0, 1, 2);
+            }
+            _tile_stored(0, c + i * n_pad + j, b_stride);
+        }
+    }
+    _tile_release();
+}
+#endif
+
+} // anonymous namespace
+
+Bf16GemmFn GetAvx512Bf16Gemm() {
+#ifdef INFERUNITY_GEMM_AVX512_BF16
+    return GemmAvx512Bf16;
+#else
+    return nullptr;
+#endif
+}
+
+Bf16GemmFn GetAmxBf16Gemm() {
+#ifdef INFERUNITY_GEMM_AMX_BF16
+    return GemmAmxBf16;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace gemm
+} // namespace inferunity
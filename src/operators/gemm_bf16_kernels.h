@@ -0,0 +1,24 @@
+// BF16原生计算核（供gemm.cpp的SgemmBf16使用）
+// 单独的翻译单元以-mavx512bf16 -mamx-tile -mamx-bf16编译，运行时按CPU特性选择；
+// 编译器或架构不支持时入口返回nullptr
+
+#pragma once
+
+#include <cstdint>
+
+namespace inferunity {
+namespace gemm {
+
+// c[m][n_pad] = a[m][k_pairs] * b[k_pairs][n_pad]（FP32累加，覆盖c）
+// a、b的每个uint32为相邻两个k的bf16（低16位为偶数k）；m、n_pad、k_pairs均为16的整倍数
+using Bf16GemmFn = void (*)(const uint32_t* a, const uint32_t* b, float* c,
+                            int64_t m, int64_t n_pad, int64_t k_pairs);
+
+// AVX-512-BF16：vdpbf16ps，8行 x 16列寄存器分块
+Bf16GemmFn GetAvx512Bf16Gemm();
+
+// AMX-BF16：tdpbf16ps，16x16输出块；调用线程须已获得AMX tile数据的使用权限（见cpu_features.h）
+Bf16GemmFn GetAmxBf16Gemm();
+
+} // namespace gemm
+} // namespace inferunity
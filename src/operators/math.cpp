@@ -1,293 +1,501 @@
 // 基础数学运算算子实现
-// 参考TensorFlow Lite的实现
+// 参考TensorFlow Lite的实现；逐元素二元运算共用elementwise_kernels.h的广播引擎
+// （参考ONNX Runtime的BroadcastHelper），FP32走SIMD核，FP16按块转换为FP32计算，INT32/INT64为标量循环
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "elementwise_kernels.h"
+#include "matmul_kernels.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
-
-// BLAS库支持
-#ifdef INFERUNITY_USE_ACCELERATE
-#include <Accelerate/Accelerate.h>
-#elif defined(INFERUNITY_USE_OPENBLAS)
-#include <cblas.h>
-#endif
+#include <memory>
+#include <string>
 
 namespace inferunity {
 namespace operators {
 
-// Add算子
-class AddOperator : public Operator {
-public:
-    std::string GetName() const override { return "Add"; }
-    
-    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Add requires 2 inputs");
+namespace {
+
+enum class BinaryKind { ADD, SUB, MUL, DIV, POW, MAX, MIN };
+
+bool IsBinarySupportedType(DataType dtype) {
+    return dtype == DataType::FLOAT32 || dtype == DataType::FLOAT16 ||
+           dtype == DataType::INT32 || dtype == DataType::INT64;
+}
+
+// 单个元素按double读出（Pow的指数可以与底数类型不同）
+bool ReadScalar(const Tensor& tensor, double* value) {
+    const void* data = tensor.GetData();
+    switch (tensor.GetDataType()) {
+        case DataType::FLOAT32: *value = *static_cast<const float*>(data); return true;
+        case DataType::FLOAT16: {
+            float f = 0.0f;
+            simd::ConvertHalfToFloatSIMD(static_cast<const uint16_t*>(data), &f, 1);
+            *value = f;
+            return true;
         }
-        return Status::Ok();
+        case DataType::INT32: *value = *static_cast<const int32_t*>(data); return true;
+        case DataType::INT64: *value = static_cast<double>(*static_cast<const int64_t*>(data)); return true;
+        default: return false;
     }
-    
-    Status InferOutputShape(const std::vector<Tensor*>& inputs,
-                           std::vector<Shape>& output_shapes) const override {
-        // 广播规则：输出形状是输入形状的广播结果
-        // 简化：假设形状相同
-        output_shapes.push_back(inputs[0]->GetShape());
-        return Status::Ok();
+}
+
+// 标量指数的Pow：常见的x^2、x^0.5（LayerNorm分解子图）、x^1走专门路径
+void PowScalarExponent(const float* a, bool a_scalar, float exponent, float* c, size_t n) {
+    if (exponent == 2.0f) {
+        simd::BinarySIMD(simd::BinaryOp::MUL, a, a_scalar, a, a_scalar, c, n);
+    } else if (exponent == 1.0f) {
+        simd::BinarySIMD(simd::BinaryOp::MUL, a, a_scalar, &exponent, true, c, n);
+    } else if (exponent == 0.5f) {
+        for (size_t i = 0; i < n; ++i) c[i] = std::sqrt(a[a_scalar ? 0 : i]);
+    } else {
+        for (size_t i = 0; i < n; ++i) c[i] = std::pow(a[a_scalar ? 0 : i], exponent);
     }
-    
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
-        }
-        
-        Tensor* input0 = inputs[0];
-        Tensor* input1 = inputs[1];
-        Tensor* output = outputs[0];
-        
-        size_t count = output->GetElementCount();
-        const float* data0 = static_cast<const float*>(input0->GetData());
-        const float* data1 = static_cast<const float*>(input1->GetData());
-        float* out_data = static_cast<float*>(output->GetData());
-        
-        // 逐元素加法（简化：假设形状相同）
-        // TODO: 添加SIMD优化（使用simd_utils.h中的函数）
-        for (size_t i = 0; i < count; ++i) {
-            out_data[i] = data0[i] + data1[i];
-        }
-        
-        return Status::Ok();
+}
+
+// 一段连续元素的FP32计算，c可以与a相同（原地执行）
+void RunFloatRun(BinaryKind kind, const float* a, bool a_scalar, const float* b, bool b_scalar,
+                 float* c, size_t n) {
+    switch (kind) {
+        case BinaryKind::ADD: simd::BinarySIMD(simd::BinaryOp::ADD, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::SUB: simd::BinarySIMD(simd::BinaryOp::SUB, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::MUL: simd::BinarySIMD(simd::BinaryOp::MUL, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::DIV: simd::BinarySIMD(simd::BinaryOp::DIV, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::MAX: simd::BinarySIMD(simd::BinaryOp::MAX, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::MIN: simd::BinarySIMD(simd::BinaryOp::MIN, a, a_scalar, b, b_scalar, c, n); return;
+        case BinaryKind::POW:
+            if (b_scalar) {
+                PowScalarExponent(a, a_scalar, b[0], c, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) c[i] = std::pow(a[a_scalar ? 0 : i], b[i]);
+            }
+            return;
     }
-};
+}
 
-REGISTER_OPERATOR("Add", AddOperator);
+template <typename T>
+T IntegerBinary(BinaryKind kind, T x, T y) {
+    switch (kind) {
+        case BinaryKind::ADD: return x + y;
+        case BinaryKind::SUB: return x - y;
+        case BinaryKind::MUL: return x * y;
+        case BinaryKind::DIV: return y == 0 ? T(0) : x / y;  // 整数除零没有定义，输出0而不是触发SIGFPE
+        case BinaryKind::POW: return static_cast<T>(std::pow(static_cast<double>(x), static_cast<double>(y)));
+        case BinaryKind::MAX: return std::max(x, y);
+        case BinaryKind::MIN: return std::min(x, y);
+    }
+    return T(0);
+}
 
-// Mul算子
-class MulOperator : public Operator {
-public:
-    std::string GetName() const override { return "Mul"; }
-    
-    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Mul requires 2 inputs");
-        }
-        return Status::Ok();
+template <typename T>
+void RunIntegerRun(BinaryKind kind, const T* a, bool a_scalar, const T* b, bool b_scalar, T* c, size_t n) {
+    const T sa = a[0], sb = b[0];
+    for (size_t i = 0; i < n; ++i) {
+        c[i] = IntegerBinary(kind, a_scalar ? sa : a[i], b_scalar ? sb : b[i]);
     }
-    
-    Status InferOutputShape(const std::vector<Tensor*>& inputs,
-                           std::vector<Shape>& output_shapes) const override {
-        output_shapes.push_back(inputs[0]->GetShape());
-        return Status::Ok();
+}
+
+// FP16：每次转换kHalfBlock个元素到栈上的FP32缓冲计算后再转回
+constexpr size_t kHalfBlock = 256;
+
+void RunHalfRun(BinaryKind kind, const uint16_t* a, bool a_scalar, const uint16_t* b, bool b_scalar,
+                uint16_t* c, size_t n) {
+    float fa[kHalfBlock], fb[kHalfBlock], fc[kHalfBlock];
+    if (a_scalar) simd::ConvertHalfToFloatSIMD(a, fa, 1);
+    if (b_scalar) simd::ConvertHalfToFloatSIMD(b, fb, 1);
+    for (size_t i = 0; i < n; i += kHalfBlock) {
+        const size_t len = std::min(kHalfBlock, n - i);
+        if (!a_scalar) simd::ConvertHalfToFloatSIMD(a + i, fa, len);
+        if (!b_scalar) simd::ConvertHalfToFloatSIMD(b + i, fb, len);
+        RunFloatRun(kind, fa, a_scalar, fb, b_scalar, fc, len);
+        simd::ConvertFloatToHalfSIMD(fc, c + i, len);
     }
-    
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+}
+
+// out = a op b，a/b按广播规则扩展到out的形状；out可以就是a（原地、逐步累积）
+Status RunBinary(BinaryKind kind, const Tensor& a, const Tensor& b, Tensor* out, ExecutionContext* ctx) {
+    BroadcastPlan plan;
+    Status status = PlanBroadcast({a.GetShape(), b.GetShape()}, out->GetShape(), &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const bool as = plan.inner_scalar[0], bs = plan.inner_scalar[1];
+    switch (out->GetDataType()) {
+        case DataType::FLOAT32: {
+            const float* pa = static_cast<const float*>(a.GetData());
+            const float* pb = static_cast<const float*>(b.GetData());
+            float* pc = static_cast<float*>(out->GetData());
+            ForEachBroadcastRun(plan, ctx, [&](const int64_t* offsets, int64_t o, int64_t n) {
+                RunFloatRun(kind, pa + offsets[0], as, pb + offsets[1], bs, pc + o, static_cast<size_t>(n));
+            });
+            return Status::Ok();
         }
-        
-        Tensor* input0 = inputs[0];
-        Tensor* input1 = inputs[1];
-        Tensor* output = outputs[0];
-        
-        size_t count = output->GetElementCount();
-        const float* data0 = static_cast<const float*>(input0->GetData());
-        const float* data1 = static_cast<const float*>(input1->GetData());
-        float* out_data = static_cast<float*>(output->GetData());
-        
-        // 逐元素乘法
-        for (size_t i = 0; i < count; ++i) {
-            out_data[i] = data0[i] * data1[i];
+        case DataType::FLOAT16: {
+            const uint16_t* pa = static_cast<const uint16_t*>(a.GetData());
+            const uint16_t* pb = static_cast<const uint16_t*>(b.GetData());
+            uint16_t* pc = static_cast<uint16_t*>(out->GetData());
+            ForEachBroadcastRun(plan, ctx, [&](const int64_t* offsets, int64_t o, int64_t n) {
+                RunHalfRun(kind, pa + offsets[0], as, pb + offsets[1], bs, pc + o, static_cast<size_t>(n));
+            });
+            return Status::Ok();
         }
-        
-        return Status::Ok();
+        case DataType::INT32: {
+            const int32_t* pa = static_cast<const int32_t*>(a.GetData());
+            const int32_t* pb = static_cast<const int32_t*>(b.GetData());
+            int32_t* pc = static_cast<int32_t*>(out->GetData());
+            ForEachBroadcastRun(plan, ctx, [&](const int64_t* offsets, int64_t o, int64_t n) {
+                RunIntegerRun(kind, pa + offsets[0], as, pb + offsets[1], bs, pc + o, static_cast<size_t>(n));
+            });
+            return Status::Ok();
+        }
+        case DataType::INT64: {
+            const int64_t* pa = static_cast<const int64_t*>(a.GetData());
+            const int64_t* pb = static_cast<const int64_t*>(b.GetData());
+            int64_t* pc = static_cast<int64_t*>(out->GetData());
+            ForEachBroadcastRun(plan, ctx, [&](const int64_t* offsets, int64_t o, int64_t n) {
+                RunIntegerRun(kind, pa + offsets[0], as, pb + offsets[1], bs, pc + o, static_cast<size_t>(n));
+            });
+            return Status::Ok();
+        }
+        default:
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported elementwise data type");
     }
-};
+}
 
-REGISTER_OPERATOR("Mul", MulOperator);
+std::vector<Shape> InputShapes(const std::vector<Tensor*>& inputs) {
+    std::vector<Shape> shapes;
+    for (const Tensor* input : inputs) {
+        shapes.push_back(input->GetShape());
+    }
+    return shapes;
+}
 
-// MatMul算子（矩阵乘法）
-class MatMulOperator : public Operator {
+} // anonymous namespace
+
+// 逐元素二元算子（numpy广播）：Max/Min可以有任意多个输入，依次与已累积的输出合并
+class ElementwiseBinaryOperator : public Operator {
 public:
-    std::string GetName() const override { return "MatMul"; }
+    ElementwiseBinaryOperator(const char* name, BinaryKind kind, bool variadic = false)
+        : name_(name), kind_(kind), variadic_(variadic) {}
+    
+    std::string GetName() const override { return name_; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
+        if (inputs.size() < (variadic_ ? 1u : 2u) || (!variadic_ && inputs.size() > 2)) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "MatMul requires 2 inputs");
+                               name_ + (variadic_ ? " requires at least 1 input" : " requires 2 inputs"));
         }
-        const Shape& shape0 = inputs[0]->GetShape();
-        const Shape& shape1 = inputs[1]->GetShape();
-        if (shape0.dims.size() < 2 || shape1.dims.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "MatMul inputs must be at least 2D");
+        const DataType dtype = inputs[0]->GetDataType();
+        if (!IsBinarySupportedType(dtype)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               name_ + " supports FLOAT32/FLOAT16/INT32/INT64");
         }
-        return Status::Ok();
+        for (size_t i = 1; i < inputs.size(); ++i) {
+            // Pow的指数可以是其他数值类型，但只支持单个元素
+            const bool scalar_exponent = kind_ == BinaryKind::POW && inputs[i]->GetElementCount() == 1 &&
+                                         IsBinarySupportedType(inputs[i]->GetDataType());
+            if (inputs[i]->GetDataType() != dtype && !scalar_exponent) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   name_ + " inputs must have the same data type");
+            }
+        }
+        Shape shape;
+        return BroadcastShapes(InputShapes(inputs), &shape);
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        const Shape& shape0 = inputs[0]->GetShape();
-        const Shape& shape1 = inputs[1]->GetShape();
-        
-        // 简化：假设是2D矩阵 [M, K] x [K, N] = [M, N]
-        std::vector<int64_t> output_dims;
-        if (shape0.dims.size() == 2 && shape1.dims.size() == 2) {
-            output_dims = {shape0.dims[0], shape1.dims[1]};
-        } else {
-            // 处理batch维度
-            output_dims = shape0.dims;
-            output_dims.back() = shape1.dims.back();
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " requires inputs");
         }
-        
-        output_shapes.push_back(Shape(output_dims));
+        Shape shape;
+        Status status = BroadcastShapes(InputShapes(inputs), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(shape);
         return Status::Ok();
     }
     
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
+        if (outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input0 = inputs[0];
-        Tensor* input1 = inputs[1];
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
         Tensor* output = outputs[0];
-        
-        const Shape& shape0 = input0->GetShape();
-        const Shape& shape1 = input1->GetShape();
-        
-        // 简化：2D矩阵乘法
-        int64_t M = shape0.dims[0];
-        int64_t K = shape0.dims[1];
-        int64_t N = shape1.dims[1];
-        
-        const float* A = static_cast<const float*>(input0->GetData());
-        const float* B = static_cast<const float*>(input1->GetData());
-        float* C = static_cast<float*>(output->GetData());
-        
-        // 初始化输出
-        std::memset(C, 0, output->GetSizeInBytes());
-        
-        // 使用BLAS库优化（如果可用）
-#ifdef INFERUNITY_USE_ACCELERATE
-        // macOS Accelerate框架：使用cblas_sgemm
-        // C = alpha * A * B + beta * C
-        // 这里 alpha=1.0, beta=0.0, 所以 C = A * B
-        cblas_sgemm(CblasRowMajor,      // 行主序
-                    CblasNoTrans,       // A不转置
-                    CblasNoTrans,       // B不转置
-                    M,                  // A的行数
-                    N,                  // B的列数
-                    K,                  // A的列数/B的行数
-                    1.0f,               // alpha
-                    A,                  // A矩阵
-                    K,                  // A的leading dimension
-                    B,                  // B矩阵
-                    N,                  // B的leading dimension
-                    0.0f,               // beta
-                    C,                  // C矩阵（输出）
-                    N);                 // C的leading dimension
-#elif defined(INFERUNITY_USE_OPENBLAS)
-        // OpenBLAS：使用cblas_sgemm
-        cblas_sgemm(CblasRowMajor,
-                    CblasNoTrans,
-                    CblasNoTrans,
-                    M, N, K,
-                    1.0f, A, K,
-                    B, N,
-                    0.0f, C, N);
-#else
-        // 朴素实现（fallback）
-        // 矩阵乘法: C = A * B
-        for (int64_t i = 0; i < M; ++i) {
-            for (int64_t j = 0; j < N; ++j) {
-                float sum = 0.0f;
-                for (int64_t k = 0; k < K; ++k) {
-                    sum += A[i * K + k] * B[k * N + j];
-                }
-                C[i * N + j] = sum;
+        Shape shape;
+        BroadcastShapes(InputShapes(inputs), &shape);
+        if (output->GetShape().GetElementCount() != shape.GetElementCount() ||
+            output->GetDataType() != inputs[0]->GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " output shape mismatch");
+        }
+        if (inputs.size() == 1) {
+            // 单输入的Max/Min：按广播复制（形状相同）
+            if (output->GetData() != inputs[0]->GetData()) {
+                std::memcpy(output->GetData(), inputs[0]->GetData(), output->GetSizeInBytes());
             }
+            return Status::Ok();
         }
-#endif
         
+        // 按输出形状执行（输出张量可能只是元素数相同的视图）
+        Tensor view(shape, output->GetDataType(), output->GetData());
+        const Tensor* exponent = inputs[1];
+        std::shared_ptr<Tensor> converted;
+        if (inputs[1]->GetDataType() != inputs[0]->GetDataType()) {
+            status = ConvertScalarExponent(*inputs[1], inputs[0]->GetDataType(), &converted);
+            if (!status.IsOk()) {
+                return status;
+            }
+            exponent = converted.get();
+        }
+        status = RunBinary(kind_, *inputs[0], *exponent, &view, ctx);
+        for (size_t i = 2; i < inputs.size() && status.IsOk(); ++i) {
+            status = RunBinary(kind_, view, *inputs[i], &view, ctx);
+        }
+        return status;
+    }
+
+private:
+    // Pow的单元素指数转换为底数类型
+    static Status ConvertScalarExponent(const Tensor& exponent, DataType dtype, std::shared_ptr<Tensor>* result) {
+        double value = 0.0;
+        if (!ReadScalar(exponent, &value)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Pow exponent type");
+        }
+        auto tensor = CreateTensor(exponent.GetShape(), dtype, DeviceType::CPU);
+        switch (dtype) {
+            case DataType::FLOAT32: *static_cast<float*>(tensor->GetData()) = static_cast<float>(value); break;
+            case DataType::FLOAT16: {
+                const float f = static_cast<float>(value);
+                simd::ConvertFloatToHalfSIMD(&f, static_cast<uint16_t*>(tensor->GetData()), 1);
+                break;
+            }
+            case DataType::INT32: *static_cast<int32_t*>(tensor->GetData()) = static_cast<int32_t>(value); break;
+            case DataType::INT64: *static_cast<int64_t*>(tensor->GetData()) = static_cast<int64_t>(value); break;
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Pow base type");
+        }
+        *result = tensor;
         return Status::Ok();
     }
+    
+    std::string name_;
+    BinaryKind kind_;
+    bool variadic_;
 };
 
-REGISTER_OPERATOR("MatMul", MatMulOperator);
+class AddOperator : public ElementwiseBinaryOperator {
+public:
+    AddOperator() : ElementwiseBinaryOperator("Add", BinaryKind::ADD) {}
+};
+
+class SubOperator : public ElementwiseBinaryOperator {
+public:
+    SubOperator() : ElementwiseBinaryOperator("Sub", BinaryKind::SUB) {}
+};
+
+class MulOperator : public ElementwiseBinaryOperator {
+public:
+    MulOperator() : ElementwiseBinaryOperator("Mul", BinaryKind::MUL) {}
+};
+
+// Div：浮点按IEEE语义（除以0得到inf/NaN，与FusedElementwise一致）
+class DivOperator : public ElementwiseBinaryOperator {
+public:
+    DivOperator() : ElementwiseBinaryOperator("Div", BinaryKind::DIV) {}
+};
 
-// Sub算子（减法）
-class SubOperator : public Operator {
+class PowOperator : public ElementwiseBinaryOperator {
 public:
-    std::string GetName() const override { return "Sub"; }
+    PowOperator() : ElementwiseBinaryOperator("Pow", BinaryKind::POW) {}
+};
+
+class MaxOperator : public ElementwiseBinaryOperator {
+public:
+    MaxOperator() : ElementwiseBinaryOperator("Max", BinaryKind::MAX, true) {}
+};
+
+class MinOperator : public ElementwiseBinaryOperator {
+public:
+    MinOperator() : ElementwiseBinaryOperator("Min", BinaryKind::MIN, true) {}
+};
+
+REGISTER_OPERATOR("Add", AddOperator);
+REGISTER_OPERATOR("Sub", SubOperator);
+REGISTER_OPERATOR("Mul", MulOperator);
+REGISTER_OPERATOR("Div", DivOperator);
+REGISTER_OPERATOR("Pow", PowOperator);
+REGISTER_OPERATOR("Max", MaxOperator);
+REGISTER_OPERATOR("Min", MinOperator);
+
+namespace {
+
+// Where的一段：cond为BOOL，x/y按元素字节数复制
+template <typename T>
+void SelectRun(const uint8_t* cond, bool cond_scalar, const T* x, bool x_scalar, const T* y, bool y_scalar,
+               T* out, size_t n) {
+    if (cond_scalar) {
+        const T* src = cond[0] ? x : y;
+        const bool scalar = cond[0] ? x_scalar : y_scalar;
+        if (scalar) {
+            std::fill(out, out + n, src[0]);
+        } else {
+            std::memcpy(out, src, n * sizeof(T));
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = cond[i] ? x[x_scalar ? 0 : i] : y[y_scalar ? 0 : i];
+    }
+}
+
+template <typename T>
+void RunWhere(const BroadcastPlan& plan, const Tensor& cond, const Tensor& x, const Tensor& y,
+              Tensor* output, ExecutionContext* ctx) {
+    const uint8_t* pc = static_cast<const uint8_t*>(cond.GetData());
+    const T* px = static_cast<const T*>(x.GetData());
+    const T* py = static_cast<const T*>(y.GetData());
+    T* out = static_cast<T*>(output->GetData());
+    ForEachBroadcastRun(plan, ctx, [&](const int64_t* offsets, int64_t o, int64_t n) {
+        SelectRun(pc + offsets[0], plan.inner_scalar[0], px + offsets[1], plan.inner_scalar[1],
+                  py + offsets[2], plan.inner_scalar[2], out + o, static_cast<size_t>(n));
+    });
+}
+
+} // anonymous namespace
+
+// Where算子：out = cond ? x : y，三个输入共同广播；x/y可以是任意定长类型
+class WhereOperator : public Operator {
+public:
+    std::string GetName() const override { return "Where"; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
+        if (inputs.size() != 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Where requires 3 inputs");
+        }
+        if (inputs[0]->GetDataType() != DataType::BOOL) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Where condition must be BOOL");
+        }
+        if (inputs[1]->GetDataType() != inputs[2]->GetDataType()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Sub requires 2 inputs");
+                               "Where inputs X and Y must have the same data type");
         }
-        return Status::Ok();
+        Shape shape;
+        return BroadcastShapes(InputShapes(inputs), &shape);
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        output_shapes.push_back(inputs[0]->GetShape());
+        if (inputs.size() != 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Where requires 3 inputs");
+        }
+        Shape shape;
+        Status status = BroadcastShapes(InputShapes(inputs), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(shape);
         return Status::Ok();
     }
     
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs, size_t output_index) const override {
+        (void)output_index;
+        return inputs.size() > 1 ? inputs[1]->GetDataType() : DataType::FLOAT32;
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
+        if (outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input0 = inputs[0];
-        Tensor* input1 = inputs[1];
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        Shape shape;
+        BroadcastShapes(InputShapes(inputs), &shape);
         Tensor* output = outputs[0];
-        
-        size_t count = output->GetElementCount();
-        const float* data0 = static_cast<const float*>(input0->GetData());
-        const float* data1 = static_cast<const float*>(input1->GetData());
-        float* out_data = static_cast<float*>(output->GetData());
-        
-        // 逐元素减法
-        for (size_t i = 0; i < count; ++i) {
-            out_data[i] = data0[i] - data1[i];
+        if (output->GetShape().GetElementCount() != shape.GetElementCount() ||
+            output->GetDataType() != inputs[1]->GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Where output shape mismatch");
+        }
+        BroadcastPlan plan;
+        status = PlanBroadcast(InputShapes(inputs), shape, &plan);
+        if (!status.IsOk()) {
+            return status;
+        }
+        switch (GetDataTypeSize(output->GetDataType())) {
+            case 1: RunWhere<uint8_t>(plan, *inputs[0], *inputs[1], *inputs[2], output, ctx); break;
+            case 2: RunWhere<uint16_t>(plan, *inputs[0], *inputs[1], *inputs[2], output, ctx); break;
+            case 4: RunWhere<uint32_t>(plan, *inputs[0], *inputs[1], *inputs[2], output, ctx); break;
+            case 8: RunWhere<uint64_t>(plan, *inputs[0], *inputs[1], *inputs[2], output, ctx); break;
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Where data type");
         }
-        
         return Status::Ok();
     }
 };
 
-REGISTER_OPERATOR("Sub", SubOperator);
+REGISTER_OPERATOR("Where", WhereOperator);
 
-// Div算子（除法）
-class DivOperator : public Operator {
+// MatMul算子（矩阵乘法）
+// 支持numpy风格的N维批量广播；transA/transB/alpha属性参考ONNX Runtime的FusedMatMul，
+// 使图优化可以把交换最后两维的Transpose折叠进MatMul而无需物化转置结果
+class MatMulOperator : public Operator {
 public:
-    std::string GetName() const override { return "Div"; }
+    std::string GetName() const override { return "MatMul"; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.size() < 2) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Div requires 2 inputs");
+                               "MatMul requires 2 inputs");
         }
-        return Status::Ok();
+        if (inputs[0]->GetDataType() != DataType::FLOAT32 ||
+            !IsSupportedMatMulBType(inputs[1]->GetDataType())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "MatMul requires FLOAT32 A and FLOAT32/FLOAT16/BFLOAT16 B");
+        }
+        MatMulShape shape;
+        return ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(),
+                                  TransA(), TransB(), &shape);
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        output_shapes.push_back(inputs[0]->GetShape());
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "MatMul requires 2 inputs");
+        }
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(inputs[0]->GetShape(), inputs[1]->GetShape(),
+                                           TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape(shape.output_dims));
         return Status::Ok();
     }
     
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        if (inputs.empty() || inputs[0].shape.dims.empty()) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        const auto& dims = inputs[0].shape.dims;
+        const int64_t k = TransA() && dims.size() >= 2 ? dims[dims.size() - 2] : dims.back();
+        return EstimateMatMulCost(inputs, outputs, k, 0.0);
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
@@ -299,27 +507,62 @@ public:
         Tensor* input1 = inputs[1];
         Tensor* output = outputs[0];
         
-        size_t count = output->GetElementCount();
-        const float* data0 = static_cast<const float*>(input0->GetData());
-        const float* data1 = static_cast<const float*>(input1->GetData());
-        float* out_data = static_cast<float*>(output->GetData());
+        MatMulShape shape;
+        Status status = ComputeMatMulShape(input0->GetShape(), input1->GetShape(),
+                                           TransA(), TransB(), &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (output->GetShape().dims != shape.output_dims) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "MatMul output shape mismatch");
+        }
         
-        // 逐元素除法（避免除零）
-        for (size_t i = 0; i < count; ++i) {
-            float divisor = data1[i];
-            if (std::abs(divisor) < 1e-8f) {
-                out_data[i] = 0.0f;  // 避免除零
-            } else {
-                out_data[i] = data0[i] / divisor;
+        // 逐批次GEMM：被广播的操作数批跨度为0，不拷贝数据；常量权重使用加载时打包的B，
+        // 半精度存储的B在打包面板时转换为FP32
+        MatMulHalfB half_b;
+        const bool use_half = packed_b_.GetHalf(input1, shape, &half_b);
+        RunBatchedMatMul(shape, GetFloatAttribute("alpha", 1.0f),
+                         static_cast<const float*>(input0->GetData()),
+                         use_half ? nullptr : static_cast<const float*>(input1->GetData()),
+                         0.0f, static_cast<float*>(output->GetData()),
+                         nullptr, packed_b_.Get(input1, shape), use_half ? &half_b : nullptr);
+        
+        // 本次运行选用了作用于该权重的LoRA适配器时，在整批的基座结果上按段累加低秩增量
+        const LoraBatch* lora = ctx ? ctx->GetLoraBatch() : nullptr;
+        const LoraDelta* deltas = lora ? lora->Find(GetStringAttribute("lora_target", "")) : nullptr;
+        if (deltas) {
+            if (shape.trans_a) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "LoRA requires a non-transposed MatMul A");
             }
+            return RunLoraSgmv(static_cast<const float*>(input0->GetData()), static_cast<float*>(output->GetData()),
+                               static_cast<int64_t>(output->GetElementCount()) / shape.N, shape.K, shape.N,
+                               deltas, lora->GetNumSegments(), ctx);
         }
-        
         return Status::Ok();
     }
+    
+    // 二维常量B（全连接/投影层权重）在会话加载时打包
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        return input_index == 1 ? packed_b_.PrePack(tensor, TransB(), is_packed, Bf16Compute())
+                                : Status::Ok();
+    }
+    
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        return EstimateMatMulMemory(inputs, TransB(), Bf16Compute());
+    }
+
+private:
+    MatMulPrepackedB packed_b_;
+    bool TransA() const { return GetIntAttribute("transA", 0) != 0; }
+    bool TransB() const { return GetIntAttribute("transB", 0) != 0; }
+    bool Bf16Compute() const { return GetStringAttribute("compute_precision", "") == "bf16"; }
 };
 
-REGISTER_OPERATOR("Div", DivOperator);
+REGISTER_OPERATOR("MatMul", MatMulOperator);
 
 } // namespace operators
 } // namespace inferunity
-
@@ -0,0 +1,439 @@
+// 批量矩阵乘法实现
+// 批次 x M分块的任务划分参考ONNX Runtime MlasGemmBatch的线程切分方式
+
+#include "matmul_kernels.h"
+#include "parallel_utils.h"
+#include "prepacked_weights.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 每个并行任务至少承担的乘加次数，低于此值的任务调度开销超过收益
+constexpr int64_t kMinTaskMacs = 1 << 18;
+// M方向分块行数对齐到该值，与GEMM微内核的MR保持整倍数关系
+constexpr int64_t kRowAlignment = 48;
+// 瘦矩阵的N方向分块列数对齐到该值（寄存器块最宽为4个AVX-512向量）；K切分每段至少kSkinnyMinSplitK
+constexpr int64_t kSkinnyColumnAlignment = 64;
+constexpr int64_t kSkinnyMinSplitK = 256;
+// LoRA增量每个并行任务的行数
+constexpr int64_t kLoraRowBlock = 64;
+
+int64_t BatchOffset(const MatMulShape& s, const std::vector<int64_t>& strides, int64_t batch) {
+    int64_t offset = 0;
+    for (int64_t d = static_cast<int64_t>(s.batch_dims.size()) - 1; d >= 0 && batch > 0; --d) {
+        const int64_t dim = s.batch_dims[d];
+        offset += (batch % dim) * strides[d];
+        batch /= dim;
+    }
+    return offset;
+}
+
+// 瘦矩阵（M <= gemm::kSkinnyMaxRows，批次已并入M）：M方向只有一个任务，改为按N分块；
+// N方向的块不够分给所有线程时（如N小K大的投影层）再把K切成几段，各段部分积写入临时缓冲后合并。
+// b_half非空时B以16位浮点存储
+void RunSkinnyMatMul(const MatMulShape& s, int64_t M, float alpha, const float* A, const float* B,
+                     const MatMulHalfB* b_half, float beta, float* C, const gemm::GemmEpilogue* epilogue) {
+    const int64_t N = s.N;
+    const int64_t K = s.K;
+    auto b_offset = [&](int64_t n0, int64_t k0) { return s.trans_b ? n0 * s.ldb + k0 : k0 * s.ldb + n0; };
+    auto run_columns = [&](int64_t n0, int64_t cols) {
+        gemm::GemmEpilogue ep;
+        if (epilogue) {
+            ep = *epilogue;
+            if (ep.col_bias) ep.col_bias += n0;
+        }
+        if (b_half) {
+            gemm::SgemmSkinny(s.trans_b, M, cols, K, alpha, A, s.lda, b_half->data + b_offset(n0, 0),
+                              b_half->type, s.ldb, beta, C + n0, N, epilogue ? &ep : nullptr);
+        } else {
+            gemm::SgemmSkinny(s.trans_b, M, cols, K, alpha, A, s.lda, B + b_offset(n0, 0), s.ldb,
+                              beta, C + n0, N, epilogue ? &ep : nullptr);
+        }
+    };
+    
+    int64_t cols_per_task = std::max<int64_t>(1, kMinTaskMacs / std::max<int64_t>(1, M * K));
+    cols_per_task = ((cols_per_task + kSkinnyColumnAlignment - 1) / kSkinnyColumnAlignment) * kSkinnyColumnAlignment;
+    cols_per_task = std::min(cols_per_task, N);
+    const int64_t n_tasks = (N + cols_per_task - 1) / cols_per_task;
+    const int64_t threads = static_cast<int64_t>(ThreadPool::GetThreadCount());
+    if (M * N * K < 2 * kMinTaskMacs || threads <= 1) {
+        run_columns(0, N);
+        return;
+    }
+    const int64_t k_splits = std::min((threads + n_tasks - 1) / n_tasks, K / kSkinnyMinSplitK);
+    if (k_splits <= 1) {
+        ThreadPool::ParallelFor(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+            for (int64_t task = begin; task < end; ++task) {
+                const int64_t n0 = task * cols_per_task;
+                run_columns(n0, std::min(cols_per_task, N - n0));
+            }
+        });
+        return;
+    }
+    
+    // K切分：段长对齐到16（向量宽度的整倍数），第s段的部分积为partial[s]
+    int64_t depth = (K + k_splits - 1) / k_splits;
+    depth = (depth + 15) / 16 * 16;
+    const int64_t splits = (K + depth - 1) / depth;
+    std::vector<float> partial(static_cast<size_t>(splits * M * N));
+    ThreadPool::ParallelFor(0, n_tasks * splits, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+            const int64_t n0 = (task / splits) * cols_per_task;
+            const int64_t cols = std::min(cols_per_task, N - n0);
+            const int64_t k0 = (task % splits) * depth;
+            const int64_t len = std::min(depth, K - k0);
+            float* p = partial.data() + (task % splits) * M * N + n0;
+            if (b_half) {
+                gemm::SkinnyGemmPartial(s.trans_b, M, cols, len, A + k0, s.lda, b_half->data + b_offset(n0, k0),
+                                        b_half->type, s.ldb, p, N);
+            } else {
+                gemm::SkinnyGemmPartial(s.trans_b, M, cols, len, A + k0, s.lda, B + b_offset(n0, k0), s.ldb, p, N);
+            }
+        }
+    });
+    std::vector<const float*> partials(static_cast<size_t>(splits));
+    for (int64_t i = 0; i < splits; ++i) {
+        partials[i] = partial.data() + i * M * N;
+    }
+    gemm::SkinnyGemmReduce(M, N, partials.data(), splits, N, alpha, beta, C, N, epilogue);
+}
+
+} // anonymous namespace
+
+Status ComputeMatMulShape(const Shape& a, const Shape& b, bool trans_a, bool trans_b,
+                          MatMulShape* shape) {
+    if (a.dims.empty() || b.dims.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MatMul inputs must be at least 1D");
+    }
+    MatMulShape& s = *shape;
+    s = MatMulShape();
+    
+    // 1D提升为2D：A[K] -> [1, K]，B[K] -> [K, 1]
+    const bool a_vector = a.dims.size() == 1;
+    const bool b_vector = b.dims.size() == 1;
+    std::vector<int64_t> a_dims = a_vector ? std::vector<int64_t>{1, a.dims[0]} : a.dims;
+    std::vector<int64_t> b_dims = b_vector ? std::vector<int64_t>{b.dims[0], 1} : b.dims;
+    s.trans_a = trans_a && !a_vector;
+    s.trans_b = trans_b && !b_vector;
+    
+    const size_t a_rank = a_dims.size();
+    const size_t b_rank = b_dims.size();
+    const int64_t a_rows = a_dims[a_rank - 2], a_cols = a_dims[a_rank - 1];
+    const int64_t b_rows = b_dims[b_rank - 2], b_cols = b_dims[b_rank - 1];
+    s.M = s.trans_a ? a_cols : a_rows;
+    s.K = s.trans_a ? a_rows : a_cols;
+    const int64_t k_b = s.trans_b ? b_cols : b_rows;
+    s.N = s.trans_b ? b_rows : b_cols;
+    s.lda = a_cols;
+    s.ldb = b_cols;
+    if (s.K != k_b) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MatMul inner dimensions mismatch: " + std::to_string(s.K) +
+                           " vs " + std::to_string(k_b));
+    }
+    
+    // 批维度右对齐广播
+    const size_t a_batch_rank = a_rank - 2;
+    const size_t b_batch_rank = b_rank - 2;
+    const size_t batch_rank = std::max(a_batch_rank, b_batch_rank);
+    s.batch_dims.assign(batch_rank, 1);
+    s.a_batch_strides.assign(batch_rank, 0);
+    s.b_batch_strides.assign(batch_rank, 0);
+    int64_t a_stride = a_rows * a_cols;
+    int64_t b_stride = b_rows * b_cols;
+    bool a_full_batch = true;
+    bool b_broadcast = true;
+    for (size_t i = 0; i < batch_rank; ++i) {
+        const size_t d = batch_rank - 1 - i;
+        const int64_t da = i < a_batch_rank ? a_dims[a_batch_rank - 1 - i] : 1;
+        const int64_t db = i < b_batch_rank ? b_dims[b_batch_rank - 1 - i] : 1;
+        if (da != db && da != 1 && db != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "MatMul batch dimensions are not broadcastable");
+        }
+        const int64_t out = da == 1 ? db : da;
+        s.batch_dims[d] = out;
+        s.a_batch_strides[d] = (da == 1) ? 0 : a_stride;
+        s.b_batch_strides[d] = (db == 1) ? 0 : b_stride;
+        if (da != out) a_full_batch = false;
+        if (db != 1) b_broadcast = false;
+        a_stride *= da;
+        b_stride *= db;
+        s.batch_count *= out;
+    }
+    
+    s.output_dims = s.batch_dims;
+    if (!a_vector) s.output_dims.push_back(s.M);
+    if (!b_vector) s.output_dims.push_back(s.N);
+    
+    // 例如[B, S, K] x [K, N]：A的批次在内存中连续，可视为[B*S, K]
+    s.fold_batch_into_m = s.batch_count > 1 && a_full_batch && b_broadcast && !s.trans_a;
+    return Status::Ok();
+}
+
+void RunBatchedMatMul(const MatMulShape& s, float alpha,
+                      const float* A, const float* B, float beta, float* C,
+                      const gemm::GemmEpilogue* epilogue,
+                      const gemm::PackedMatrix* packed_b,
+                      const MatMulHalfB* half_b) {
+    if (s.batch_count == 0 || s.M == 0 || s.N == 0) {
+        return;
+    }
+    const bool b_shared = std::all_of(s.b_batch_strides.begin(), s.b_batch_strides.end(),
+                                      [](int64_t stride) { return stride == 0; });
+    if (packed_b && !b_shared) {
+        packed_b = nullptr;
+    }
+    MatMulHalfB half;
+    if (half_b) {
+        half = *half_b;
+        if (half.bf16 && (!b_shared || s.trans_a)) {
+            half.bf16 = nullptr;
+        }
+        half_b = &half;
+        packed_b = nullptr;
+    }
+    
+    // 批次并入M；epilogue的行向量按每个批次的M解释，此时仍逐批次调用
+    const bool row_epilogue = epilogue && (epilogue->row_scale || epilogue->row_bias);
+    int64_t batch_count = s.batch_count;
+    int64_t M = s.M;
+    if (s.fold_batch_into_m && !row_epilogue) {
+        M *= batch_count;
+        batch_count = 1;
+    }
+    
+    // 解码阶段的瘦矩阵直接读取原始权重：打包格式按大M的微内核排布，BF16原生计算保持调用方的选择
+    if (batch_count == 1 && M <= gemm::kSkinnyMaxRows && !s.trans_a && !(half_b && half_b->bf16) &&
+        (half_b ? half_b->data != nullptr : B != nullptr)) {
+        RunSkinnyMatMul(s, M, alpha, A, B, half_b, beta, C, epilogue);
+        return;
+    }
+    
+    // M方向分块：每块至少kMinTaskMacs次乘加
+    const int64_t row_macs = std::max<int64_t>(1, s.N * s.K);
+    int64_t rows_per_task = std::max<int64_t>(1, kMinTaskMacs / row_macs);
+    rows_per_task = ((rows_per_task + kRowAlignment - 1) / kRowAlignment) * kRowAlignment;
+    rows_per_task = std::min(rows_per_task, M);
+    const int64_t m_tasks = (M + rows_per_task - 1) / rows_per_task;
+    const int64_t total_tasks = batch_count * m_tasks;
+    
+    auto run_tasks = [&](int64_t task_begin, int64_t task_end) {
+        for (int64_t task = task_begin; task < task_end; ++task) {
+            const int64_t batch = task / m_tasks;
+            const int64_t m0 = (task % m_tasks) * rows_per_task;
+            const int64_t rows = std::min(rows_per_task, M - m0);
+    
+            const float* a = A + BatchOffset(s, s.a_batch_strides, batch);
+            const float* b = B ? B + BatchOffset(s, s.b_batch_strides, batch) : nullptr;
+            float* c = C + batch * M * s.N + m0 * s.N;
+            a += s.trans_a ? m0 : m0 * s.lda;
+    
+            gemm::GemmEpilogue ep;
+            if (epilogue) {
+                ep = *epilogue;
+                if (ep.row_scale) ep.row_scale += m0;
+                if (ep.row_bias) ep.row_bias += m0;
+            }
+            if (half_b && half_b->bf16) {
+                gemm::SgemmBf16(rows, s.N, s.K, alpha, a, s.lda, *half_b->bf16,
+                                beta, c, s.N, epilogue ? &ep : nullptr);
+            } else if (half_b) {
+                gemm::SgemmHalfB(s.trans_a, s.trans_b, rows, s.N, s.K, alpha, a, s.lda,
+                                 half_b->data + BatchOffset(s, s.b_batch_strides, batch), half_b->type, s.ldb,
+                                 beta, c, s.N, epilogue ? &ep : nullptr);
+            } else if (packed_b) {
+                gemm::SgemmPrepacked(s.trans_a, s.trans_b, rows, s.N, s.K, alpha,
+                                     a, s.lda, nullptr, nullptr, s.ldb, packed_b,
+                                     beta, c, s.N, epilogue ? &ep : nullptr);
+            } else {
+                gemm::Sgemm(s.trans_a, s.trans_b, rows, s.N, s.K, alpha,
+                            a, s.lda, b, s.ldb, beta, c, s.N, epilogue ? &ep : nullptr);
+            }
+        }
+    };
+    
+    const int64_t total_macs = batch_count * M * s.N * s.K;
+    if (total_tasks == 1 || total_macs < 2 * kMinTaskMacs || ThreadPool::GetThreadCount() <= 1) {
+        run_tasks(0, total_tasks);
+        return;
+    }
+    ThreadPool::ParallelFor(0, total_tasks, 1, run_tasks);
+}
+
+bool IsSupportedMatMulBType(DataType dtype) {
+    return dtype == DataType::FLOAT32 || dtype == DataType::FLOAT16 || dtype == DataType::BFLOAT16;
+}
+
+Status MatMulPrepackedB::PrePack(const Tensor& b, bool trans_b, bool* is_packed, bool bf16_compute) {
+    *is_packed = false;
+    const Shape& shape = b.GetShape();
+    const DataType dtype = b.GetDataType();
+    if (shape.dims.size() != 2 || !IsSupportedMatMulBType(dtype)) {
+        return Status::Ok();
+    }
+    // op(B)为[K, N]
+    const int64_t rows = shape.dims[0];
+    const int64_t cols = shape.dims[1];
+    const int64_t K = trans_b ? cols : rows;
+    const int64_t N = trans_b ? rows : cols;
+    if (K <= 0 || N <= 0) {
+        return Status::Ok();
+    }
+    if (bf16_compute && gemm::HasBf16Compute()) {
+        const size_t bytes = static_cast<size_t>(rows * cols) * GetDataTypeSize(dtype);
+        const std::string key = PrepackedWeightCache::MakeKey(
+            "matmul_b_bf16", {K, N, trans_b ? 1 : 0, static_cast<int64_t>(dtype)}, b.GetData(), bytes);
+        bf16_packed_ = PrepackedWeightCache::Instance().GetOrCreate<gemm::PackedBf16Matrix>(key, [&]() {
+            auto packed = std::make_shared<gemm::PackedBf16Matrix>();
+            if (dtype == DataType::FLOAT32) {
+                gemm::PackMatrixBBf16(trans_b, K, N, static_cast<const float*>(b.GetData()), cols, packed.get());
+            } else {
+                gemm::PackMatrixBBf16(trans_b, K, N, static_cast<const uint16_t*>(b.GetData()),
+                                      dtype == DataType::BFLOAT16 ? gemm::HalfType::BFLOAT16
+                                                                  : gemm::HalfType::FLOAT16,
+                                      cols, packed.get());
+            }
+            return std::shared_ptr<const gemm::PackedBf16Matrix>(std::move(packed));
+        });
+        source_ = b.GetData();
+        trans_b_ = trans_b;
+        *is_packed = bf16_packed_ != nullptr;
+        return Status::Ok();
+    }
+    if (gemm::UsesExternalBlas() || dtype != DataType::FLOAT32) {
+        return Status::Ok();
+    }
+    const float* data = static_cast<const float*>(b.GetData());
+    const std::string key = PrepackedWeightCache::MakeKey(
+        std::string("matmul_b_") + gemm::GetMicroKernelName(), {K, N, trans_b ? 1 : 0},
+        data, static_cast<size_t>(rows * cols));
+    packed_ = PrepackedWeightCache::Instance().GetOrCreate<gemm::PackedMatrix>(key, [&]() {
+        auto packed = std::make_shared<gemm::PackedMatrix>();
+        gemm::PackMatrixB(trans_b, K, N, data, cols, packed.get());
+        return std::shared_ptr<const gemm::PackedMatrix>(std::move(packed));
+    });
+    source_ = data;
+    trans_b_ = trans_b;
+    *is_packed = packed_ != nullptr;
+    return Status::Ok();
+}
+
+size_t MatMulPrepackedB::EstimateBytes(const TensorInfo& b, bool trans_b, bool bf16_compute) {
+    if (!b.constant || b.shape.dims.size() != 2 || !IsSupportedMatMulBType(b.dtype)) {
+        return 0;
+    }
+    const int64_t K = trans_b ? b.shape.dims[1] : b.shape.dims[0];
+    const int64_t N = trans_b ? b.shape.dims[0] : b.shape.dims[1];
+    if (bf16_compute && gemm::HasBf16Compute()) {
+        return gemm::PackedBf16MatrixBytes(K, N);
+    }
+    if (gemm::UsesExternalBlas() || b.dtype != DataType::FLOAT32) {
+        return 0;
+    }
+    return gemm::PackedMatrixBBytes(K, N);
+}
+
+OperatorMemory EstimateMatMulMemory(const std::vector<TensorInfo>& inputs, bool trans_b, bool bf16_compute) {
+    OperatorMemory memory;
+    if (inputs.size() < 2 || inputs[0].shape.dims.empty() || inputs[1].shape.dims.empty()) {
+        return memory;
+    }
+    const auto& b = inputs[1].shape.dims;
+    const int64_t K = std::max<int64_t>(inputs[0].shape.dims.back(), 1);
+    const int64_t N = std::max<int64_t>(b.size() == 2 && trans_b ? b[0] : b.back(), 1);
+    int64_t M = 1;
+    for (size_t d = 0; d + 1 < inputs[0].shape.dims.size(); ++d) {
+        M *= std::max<int64_t>(inputs[0].shape.dims[d], 1);
+    }
+    memory.prepacked_bytes = MatMulPrepackedB::EstimateBytes(inputs[1], trans_b, bf16_compute);
+    if (!gemm::UsesExternalBlas()) {
+        memory.scratch_bytes = gemm::SgemmScratchBytes(M, N, K, false, memory.prepacked_bytes > 0);
+    }
+    return memory;
+}
+
+const gemm::PackedMatrix* MatMulPrepackedB::Get(const Tensor* b, const MatMulShape& shape) const {
+    if (!packed_ || !b || b->GetData() != source_ || shape.trans_b != trans_b_ ||
+        packed_->rows != shape.K || packed_->cols != shape.N) {
+        return nullptr;
+    }
+    return packed_.get();
+}
+
+bool MatMulPrepackedB::GetHalf(const Tensor* b, const MatMulShape& shape, MatMulHalfB* half) const {
+    if (!b) {
+        return false;
+    }
+    *half = MatMulHalfB();
+    if (bf16_packed_ && b->GetData() == source_ && shape.trans_b == trans_b_ &&
+        bf16_packed_->rows == shape.K && bf16_packed_->cols == shape.N) {
+        half->bf16 = bf16_packed_.get();
+    }
+    const DataType dtype = b->GetDataType();
+    if (dtype == DataType::FLOAT16 || dtype == DataType::BFLOAT16) {
+        half->data = static_cast<const uint16_t*>(b->GetData());
+        half->type = dtype == DataType::BFLOAT16 ? gemm::HalfType::BFLOAT16 : gemm::HalfType::FLOAT16;
+        return true;
+    }
+    return half->bf16 != nullptr;
+}
+
+Status RunLoraSgmv(const float* X, float* Y, int64_t rows, int64_t K, int64_t N,
+                   const LoraDelta* deltas, size_t num_segments, ExecutionContext* ctx) {
+    const int64_t segments = static_cast<int64_t>(num_segments);
+    if (segments <= 0 || rows % segments != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "LoRA batch has " + std::to_string(num_segments) +
+                             " segments, which do not evenly divide " + std::to_string(rows) + " rows");
+    }
+    const int64_t segment_rows = rows / segments;
+    struct Block {
+        const LoraDelta* delta;
+        int64_t row_begin;
+        int64_t row_end;
+    };
+    std::vector<Block> blocks;
+    int64_t max_rank = 0;
+    for (int64_t s = 0; s < segments;) {
+        const LoraDelta& delta = deltas[s];
+        int64_t e = s + 1;
+        while (e < segments && deltas[e].a == delta.a && deltas[e].b == delta.b && deltas[e].scale == delta.scale) {
+            ++e;
+        }
+        if (delta.a) {
+            max_rank = std::max(max_rank, delta.rank);
+            for (int64_t r = s * segment_rows; r < e * segment_rows; r += kLoraRowBlock) {
+                blocks.push_back({&delta, r, std::min(r + kLoraRowBlock, e * segment_rows)});
+            }
+        }
+        s = e;
+    }
+    if (blocks.empty()) {
+        return Status::Ok();
+    }
+    ParallelForOuter(ctx, static_cast<int64_t>(blocks.size()), kLoraRowBlock * max_rank * (K + N),
+                     [&](int64_t begin, int64_t end) {
+        float* shrunk = ScratchArena::ForCurrentThread().Allocate<float>(
+            static_cast<size_t>(kLoraRowBlock * max_rank));
+        for (int64_t i = begin; i < end; ++i) {
+            const Block& block = blocks[i];
+            const LoraDelta& delta = *block.delta;
+            const int64_t m = block.row_end - block.row_begin;
+            gemm::Sgemm(false, false, m, delta.rank, K, 1.0f, X + block.row_begin * K, K,
+                        delta.a, delta.rank, 0.0f, shrunk, delta.rank);
+            gemm::Sgemm(false, false, m, N, delta.rank, delta.scale, shrunk, delta.rank,
+                        delta.b, N, 1.0f, Y + block.row_begin * N, N);
+        }
+    });
+    return Status::Ok();
+}
+
+} // namespace operators
+} // namespace inferunity
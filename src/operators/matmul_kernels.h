@@ -0,0 +1,96 @@
+// 批量矩阵乘法
+// 参考numpy.matmul/ONNX MatMul的广播语义和ONNX Runtime的MatMulComputeHelper：
+// 批维度按右对齐广播，被广播的操作数批跨度为0，因此无需物化广播或转置后的张量
+
+#pragma once
+
+#include "inferunity/lora.h"
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include "inferunity/tensor.h"
+#include "gemm.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// MatMul形状解析结果
+struct MatMulShape {
+    int64_t M = 0, N = 0, K = 0;
+    bool trans_a = false, trans_b = false;    // 1D操作数的转置标记被忽略
+    int64_t lda = 0, ldb = 0;                 // 矩阵内部的行跨度（转置时为原始存储的行长）
+    std::vector<int64_t> batch_dims;          // 广播后的批维度
+    std::vector<int64_t> a_batch_strides;     // 每个批维度在A中的元素跨度（广播维为0）
+    std::vector<int64_t> b_batch_strides;
+    int64_t batch_count = 1;
+    std::vector<int64_t> output_dims;         // 1D输入对应的M/N维已去除
+    
+    // B在所有批次间共享且A连续时，可将批次并入M做一次大GEMM
+    bool fold_batch_into_m = false;
+};
+
+// 解析A[..., M, K] x B[..., K, N]（trans_a/trans_b作用于最后两维）
+// 1D的A视为[1, K]、1D的B视为[K, 1]，输出中去除对应维度
+Status ComputeMatMulShape(const Shape& a, const Shape& b, bool trans_a, bool trans_b,
+                          MatMulShape* shape);
+
+// 以FLOAT16/BFLOAT16存储的B（混合精度权重，见MixedPrecisionPass）
+struct MatMulHalfB {
+    const uint16_t* data = nullptr;
+    gemm::HalfType type = gemm::HalfType::FLOAT16;
+    const gemm::PackedBf16Matrix* bf16 = nullptr;  // 非空时以BF16原生计算（B须在批次间共享且A不转置）
+};
+
+// 逐批次执行C = alpha * op(A) * op(B) + beta * C，C为连续的[batch..., M, N]
+// epilogue的行指针按每个批次的[M]解释、列指针按[N]解释
+// packed_b非空时替代B（B须在批次间共享，即二维常量权重）；half_b非空时替代B和packed_b
+// 任务空间为 批次 x M方向分块，工作量足够时分发到线程池
+void RunBatchedMatMul(const MatMulShape& shape, float alpha,
+                      const float* A, const float* B, float beta, float* C,
+                      const gemm::GemmEpilogue* epilogue = nullptr,
+                      const gemm::PackedMatrix* packed_b = nullptr,
+                      const MatMulHalfB* half_b = nullptr);
+
+// MatMul类算子的B是否为GEMM可直接读取的类型（FLOAT32、FLOAT16、BFLOAT16）
+bool IsSupportedMatMulBType(DataType dtype);
+
+// 常量B的预打包（MatMul/FusedMatMulAdd共用）：会话加载时打包op(B)并登记到PrepackedWeightCache，
+// 执行时确认输入仍是同一张量后使用
+// bf16_compute（算子属性compute_precision="bf16"）且CPU有BF16原生计算核时，
+// 二维B（FLOAT32/FLOAT16/BFLOAT16）改为打包成BF16对，执行时走gemm::SgemmBf16
+class MatMulPrepackedB {
+public:
+    // B为二维FLOAT32张量且未链接外部BLAS时打包
+    Status PrePack(const Tensor& b, bool trans_b, bool* is_packed, bool bf16_compute = false);
+    
+    // b仍是预打包时的张量且与shape一致时返回打包结果，否则返回nullptr
+    const gemm::PackedMatrix* Get(const Tensor* b, const MatMulShape& shape) const;
+    
+    // b为FLOAT16/BFLOAT16，或有与之对应的BF16打包时填写half并返回true
+    bool GetHalf(const Tensor* b, const MatMulShape& shape, MatMulHalfB* half) const;
+    
+    // PrePack会为b保存的打包结果的字节数（不打包，用于内存估计）
+    static size_t EstimateBytes(const TensorInfo& b, bool trans_b, bool bf16_compute = false);
+
+private:
+    std::shared_ptr<const gemm::PackedMatrix> packed_;
+    std::shared_ptr<const gemm::PackedBf16Matrix> bf16_packed_;
+    const void* source_ = nullptr;
+    bool trans_b_ = false;
+};
+
+// B为输入1的MatMul类算子的Operator::EstimateMemory：常量B按PrePack的条件计入预打包，
+// GEMM的打包缓冲计入临时缓冲
+OperatorMemory EstimateMatMulMemory(const std::vector<TensorInfo>& inputs, bool trans_b, bool bf16_compute);
+
+// LoRA增量的分段GEMM（参考Punica的SGMV）：Y[rows, N]的行按num_segments等分，第s段加上
+// scale * X_s * A_s * B_s，a为空的段跳过。相邻且增量相同的段合并为一段，各段按行块切分后并行，
+// 每块先收缩到秩r（shrink）再展开到N（expand），中间结果在线程的暂存区中。X为连续的[rows, K]；
+// 行数不能被段数整除时返回ERROR_INVALID_ARGUMENT
+Status RunLoraSgmv(const float* X, float* Y, int64_t rows, int64_t K, int64_t N,
+                   const LoraDelta* deltas, size_t num_segments, ExecutionContext* ctx);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,183 @@
+// 仅权重量化MatMul内核实现
+// 参考MLAS SQNBitGemm的CompFp32路径：GEMV按输出列切分给线程，每组的零点通过sum(a)一次扣除，
+// 内层只剩u4/u8到FP32的转换与FMA（见simd::DotU4SIMD）
+
+#include "matmul_nbits_kernels.h"
+#include "gemm.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include "inferunity/float16.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// A的行数不超过该值时走GEMV（LLM解码阶段每步一个或几个token）
+constexpr int64_t kGemvMaxRows = 4;
+// GEMM路径每次反量化的列数
+constexpr int64_t kDequantizeColumns = 128;
+// GEMV提前预取的字节数：各列的量化块在内存中首尾相接，预取跨过列边界、覆盖DRAM延迟
+constexpr int64_t kPrefetchBytes = 512;
+
+} // anonymous namespace
+
+float MatMulNBitsWeight::ScaleAt(int64_t n, int64_t block) const {
+    const int64_t index = n * blocks_per_col + block;
+    return scales_half ? HalfToFloat(static_cast<const uint16_t*>(scales)[index])
+                       : static_cast<const float*>(scales)[index];
+}
+
+int32_t MatMulNBitsWeight::ZeroPointAt(int64_t n, int64_t block) const {
+    if (!zero_points) {
+        return 1 << (bits - 1);
+    }
+    if (bits == 8) {
+        return zero_points[n * blocks_per_col + block];
+    }
+    const uint8_t byte = zero_points[n * ((blocks_per_col + 1) / 2) + block / 2];
+    return (block & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+Status ResolveMatMulNBitsWeight(int64_t K, int64_t N, int64_t bits, int64_t block_size,
+                                const Tensor& b, const Tensor& scales, const Tensor* zero_points,
+                                MatMulNBitsWeight* weight) {
+    if (K <= 0 || N <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits requires positive K and N");
+    }
+    if (bits != 4 && bits != 8) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "MatMulNBits supports 4 or 8 bits, got " + std::to_string(bits));
+    }
+    if (block_size < 16 || (block_size & (block_size - 1)) != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MatMulNBits block_size must be a power of 2 and >= 16");
+    }
+    MatMulNBitsWeight& w = *weight;
+    w = MatMulNBitsWeight();
+    w.K = K;
+    w.N = N;
+    w.bits = bits;
+    w.block_size = block_size;
+    w.blocks_per_col = (K + block_size - 1) / block_size;
+    w.blob_size = block_size * bits / 8;
+    if (b.GetDataType() != DataType::UINT8 ||
+        static_cast<int64_t>(b.GetElementCount()) != N * w.blocks_per_col * w.blob_size) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MatMulNBits B must be UINT8 [N, blocks_per_col, blob_size]");
+    }
+    if ((scales.GetDataType() != DataType::FLOAT32 && scales.GetDataType() != DataType::FLOAT16) ||
+        static_cast<int64_t>(scales.GetElementCount()) != N * w.blocks_per_col) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MatMulNBits scales must be FLOAT32/FLOAT16 [N * blocks_per_col]");
+    }
+    if (zero_points) {
+        const int64_t per_col = bits == 8 ? w.blocks_per_col : (w.blocks_per_col + 1) / 2;
+        if (zero_points->GetDataType() != DataType::UINT8 ||
+            static_cast<int64_t>(zero_points->GetElementCount()) != N * per_col) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "MatMulNBits zero_points must be packed UINT8");
+        }
+        w.zero_points = static_cast<const uint8_t*>(zero_points->GetData());
+    }
+    w.data = static_cast<const uint8_t*>(b.GetData());
+    w.scales = scales.GetData();
+    w.scales_half = scales.GetDataType() == DataType::FLOAT16;
+    return Status::Ok();
+}
+
+void DequantizeNBitsColumns(const MatMulNBitsWeight& w, int64_t n0, int64_t count, float* output) {
+    for (int64_t c = 0; c < count; ++c) {
+        const int64_t n = n0 + c;
+        float* row = output + c * w.K;
+        for (int64_t block = 0; block < w.blocks_per_col; ++block) {
+            const uint8_t* q = w.data + (n * w.blocks_per_col + block) * w.blob_size;
+            const float scale = w.ScaleAt(n, block);
+            const float zero_point = static_cast<float>(w.ZeroPointAt(n, block));
+            const int64_t k0 = block * w.block_size;
+            const int64_t len = std::min(w.block_size, w.K - k0);
+            for (int64_t i = 0; i < len; ++i) {
+                const int32_t v = w.bits == 8 ? q[i] : ((i & 1) ? (q[i / 2] >> 4) : (q[i / 2] & 0x0F));
+                row[k0 + i] = (static_cast<float>(v) - zero_point) * scale;
+            }
+        }
+    }
+}
+
+Status MatMulNBitsRun(const MatMulNBitsWeight& w, const float* A, int64_t M, const float* bias,
+                      float* Y, ExecutionContext* ctx) {
+    if (M <= 0) {
+        return Status::Ok();
+    }
+    const int64_t K = w.K;
+    const int64_t N = w.N;
+    
+    if (M > kGemvMaxRows) {
+        // 行数多时计算密集：列块反量化为B^T后交给SGEMM，bias在写回时加上
+        const int64_t chunks = (N + kDequantizeColumns - 1) / kDequantizeColumns;
+        ParallelForOuter(ctx, chunks, M * K * kDequantizeColumns, [&](int64_t begin, int64_t end) {
+            thread_local std::vector<float> columns;
+            columns.resize(static_cast<size_t>(kDequantizeColumns * K));
+            for (int64_t chunk = begin; chunk < end; ++chunk) {
+                const int64_t n0 = chunk * kDequantizeColumns;
+                const int64_t count = std::min(kDequantizeColumns, N - n0);
+                DequantizeNBitsColumns(w, n0, count, columns.data());
+                gemm::GemmEpilogue epilogue;
+                epilogue.col_bias = bias ? bias + n0 : nullptr;
+                gemm::Sgemm(false, true, M, count, K, 1.0f, A, K, columns.data(), K,
+                            0.0f, Y + n0, N, bias ? &epilogue : nullptr);
+            }
+        });
+        return Status::Ok();
+    }
+    
+    // GEMV：每行每组的sum(a)只算一次，零点修正为zero_point * sum(a)
+    std::vector<float> a_sums(static_cast<size_t>(M * w.blocks_per_col), 0.0f);
+    for (int64_t r = 0; r < M; ++r) {
+        for (int64_t block = 0; block < w.blocks_per_col; ++block) {
+            const int64_t k0 = block * w.block_size;
+            const int64_t len = std::min(w.block_size, K - k0);
+            const float* a = A + r * K + k0;
+            float sum = 0.0f;
+            for (int64_t i = 0; i < len; ++i) {
+                sum += a[i];
+            }
+            a_sums[r * w.blocks_per_col + block] = sum;
+        }
+    }
+    auto dot = w.bits == 4 ? simd::DotU4SIMD : simd::DotU8SIMD;
+    const uint8_t* data_end = w.data + N * w.blocks_per_col * w.blob_size;
+    ParallelForOuter(ctx, N, M * K, [&](int64_t begin, int64_t end) {
+        for (int64_t n = begin; n < end; ++n) {
+            float acc[kGemvMaxRows] = {};
+            for (int64_t block = 0; block < w.blocks_per_col; ++block) {
+                const uint8_t* q = w.data + (n * w.blocks_per_col + block) * w.blob_size;
+#if defined(__GNUC__) || defined(__clang__)
+                if (data_end - q > kPrefetchBytes) {
+                    __builtin_prefetch(q + kPrefetchBytes, 0, 0);
+                }
+#endif
+                const float scale = w.ScaleAt(n, block);
+                const float zero_point = static_cast<float>(w.ZeroPointAt(n, block));
+                const int64_t k0 = block * w.block_size;
+                const size_t len = static_cast<size_t>(std::min(w.block_size, K - k0));
+                for (int64_t r = 0; r < M; ++r) {
+                    const float d = dot(A + r * K + k0, q, len);
+                    acc[r] += scale * (d - zero_point * a_sums[r * w.blocks_per_col + block]);
+                }
+            }
+            const float b = bias ? bias[n] : 0.0f;
+            for (int64_t r = 0; r < M; ++r) {
+                Y[r * N + n] = acc[r] + b;
+            }
+        }
+    });
+    return Status::Ok();
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,47 @@
+// 仅权重量化的MatMul（MatMulNBits）内核
+// 参考ONNX Runtime contrib算子MatMulNBits与MLAS的SQNBitGemm：B按输出列存储为[N][blocks_per_col][blob_size]，
+// 每列沿K每block_size个元素一组，组内为bits位无符号整数（4位时每字节两个，低4位在前），
+// 每组一个scale与一个零点（缺省为2^(bits-1)），w = (q - zero_point) * scale。
+// 解码阶段（A只有少数几行）走GEMV：每组先求sum(a * q)，再按scale * (dot - zero_point * sum(a))累加，
+// 权重以量化形式直接从内存读取；行数较多时把列块反量化为FP32后调用SGEMM
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include <cstdint>
+
+namespace inferunity {
+namespace operators {
+
+struct MatMulNBitsWeight {
+    int64_t K = 0;
+    int64_t N = 0;
+    int64_t bits = 4;              // 4或8
+    int64_t block_size = 32;       // 2的幂，不小于16
+    int64_t blocks_per_col = 0;    // ceil(K / block_size)
+    int64_t blob_size = 0;         // block_size * bits / 8
+    const uint8_t* data = nullptr;
+    const void* scales = nullptr;  // [N][blocks_per_col]，FLOAT32或FLOAT16
+    bool scales_half = false;
+    // 4位时每列ceil(blocks_per_col / 2)字节（低4位在前），8位时每列blocks_per_col字节；nullptr表示缺省零点
+    const uint8_t* zero_points = nullptr;
+    
+    float ScaleAt(int64_t n, int64_t block) const;
+    int32_t ZeroPointAt(int64_t n, int64_t block) const;
+};
+
+// 按属性K/N/bits/block_size填写并检查各输入的元素个数
+Status ResolveMatMulNBitsWeight(int64_t K, int64_t N, int64_t bits, int64_t block_size,
+                                const Tensor& b, const Tensor& scales, const Tensor* zero_points,
+                                MatMulNBitsWeight* weight);
+
+// 反量化第n0列起的count列为[count][K]的FP32（即B^T的行）
+void DequantizeNBitsColumns(const MatMulNBitsWeight& weight, int64_t n0, int64_t count, float* output);
+
+// Y[M, N] = A[M, K] * B + bias（bias可为nullptr）
+Status MatMulNBitsRun(const MatMulNBitsWeight& weight, const float* A, int64_t M, const float* bias,
+                      float* Y, ExecutionContext* ctx);
+
+} // namespace operators
+} // namespace inferunity
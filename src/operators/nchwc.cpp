@@ -0,0 +1,458 @@
+// NCHWc布局算子
+// 参考ONNX Runtime的com.microsoft.nchwc算子组：ReorderInput/ReorderOutput在NCHW与分块布局之间转换，
+// NchwcConv/NchwcMaxPool/NchwcAveragePool/NchwcBatchNormalization在分块布局上执行，
+// NchwcGlobalMaxPool/NchwcGlobalAveragePool读分块布局、直接输出NCHW。
+// 这些节点由MemoryLayoutOptimizationPass插入，块大小取自分块张量的最后一维
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "nchwc_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 分块张量[N, Cb, H, W, block]对应的逻辑NCHW形状，channels为逻辑通道数
+Status LogicalShape(const Shape& blocked, int64_t channels, Shape* nchw) {
+    if (blocked.dims.size() != 5 || blocked.dims[4] <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "NCHWc tensor must be 5D [N, C/block, H, W, block]");
+    }
+    *nchw = Shape({blocked.dims[0], channels, blocked.dims[2], blocked.dims[3]});
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+// ReorderInput：NCHW -> NCHWc，属性block_size
+class ReorderInputOperator : public Operator {
+public:
+    std::string GetName() const override { return "ReorderInput"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs[0]->GetShape().dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ReorderInput requires a 4D input");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(NchwcShape(inputs[0]->GetShape(), GetIntAttribute("block_size", 8)));
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty() || inputs[0]->GetShape().dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        const Shape& shape = inputs[0]->GetShape();
+        ReorderToNchwc(static_cast<const float*>(inputs[0]->GetData()), shape.dims[0], shape.dims[1],
+                       shape.dims[2] * shape.dims[3], GetIntAttribute("block_size", 8),
+                       static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+};
+
+// ReorderOutput：NCHWc -> NCHW，属性channels为逻辑通道数
+class ReorderOutputOperator : public Operator {
+public:
+    std::string GetName() const override { return "ReorderOutput"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs[0]->GetShape().dims.size() != 5) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ReorderOutput requires a 5D input");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        Shape shape;
+        Status status = LogicalShape(inputs[0]->GetShape(), GetIntAttribute("channels", -1), &shape);
+        if (status.IsOk()) {
+            output_shapes.push_back(shape);
+        }
+        return status;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        const Shape& shape = inputs[0]->GetShape();
+        const int64_t channels = GetIntAttribute("channels", -1);
+        if (shape.dims.size() != 5 || channels <= 0 || channels > shape.dims[1] * shape.dims[4]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ReorderOutput channels mismatch");
+        }
+        ReorderFromNchwc(static_cast<const float*>(inputs[0]->GetData()), shape.dims[0], channels,
+                         shape.dims[2] * shape.dims[3], shape.dims[4],
+                         static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+};
+
+// NchwcConv：输入(x, weight, bias可选, sum可选)，x与sum为分块布局，weight为原始OIHW；
+// 其余属性与Conv相同，另有activation（"Relu"或空）与fuse_sum（1表示最后一个输入是残差）
+class NchwcConvOperator : public Operator {
+public:
+    std::string GetName() const override { return "NchwcConv"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcConv requires at least 2 inputs (input and weight)");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Conv2DParams params;
+        Status status = ParseParams(inputs, &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(NchwcShape(Shape({params.batch, params.out_c, params.out_h, params.out_w}),
+                                           inputs[0]->GetShape().dims[4]));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        const bool fuse_sum = GetIntAttribute("fuse_sum", 0) != 0;
+        const double epilogue = (inputs.size() > (fuse_sum ? 3u : 2u) ? 1.0 : 0.0) + (fuse_sum ? 1.0 : 0.0) +
+                                (GetStringAttribute("activation", "") == "Relu" ? 1.0 : 0.0);
+        return EstimateConvCost(inputs, outputs, 1, epilogue);
+    }
+    
+    // 权重重排只依赖通道与卷积核，输入的块大小已知时在加载期完成
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        *is_packed = false;
+        if (input_index != 1 || input_shapes.empty() || input_shapes[0].dims.size() != 5 ||
+            input_shapes[0].dims[4] <= 0 || tensor.GetShape().dims.size() != 4) {
+            return Status::Ok();
+        }
+        Conv2DParams params;
+        params.in_c = tensor.GetShape().dims[1] * GetIntAttribute("group", 1);
+        params.out_c = tensor.GetShape().dims[0];
+        params.kernel_h = tensor.GetShape().dims[2];
+        params.kernel_w = tensor.GetShape().dims[3];
+        params.group = GetIntAttribute("group", 1);
+        std::shared_ptr<const NchwcPackedWeight> packed;
+        Status status = kernel_.Prepare(params, input_shapes[0].dims[4],
+                                        static_cast<const float*>(tensor.GetData()), &packed);
+        *is_packed = status.IsOk();
+        return status;
+    }
+    
+    // 与NchwcConv2DKernel::Prepare的重排布局一致
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        OperatorMemory memory;
+        if (inputs.size() < 2 || !inputs[1].constant || inputs[0].shape.dims.size() != 5 ||
+            inputs[0].shape.dims[4] <= 0 || inputs[1].shape.dims.size() != 4 || GetIntAttribute("group", 1) != 1) {
+            return memory;
+        }
+        const int64_t block = inputs[0].shape.dims[4];
+        const auto& w = inputs[1].shape.dims;
+        const int64_t ocb_count = (w[0] + block - 1) / block;
+        const int64_t icb_count = (w[1] + block - 1) / block;
+        memory.prepacked_bytes = static_cast<size_t>(ocb_count * icb_count * w[2] * w[3] * block * block) *
+                                 sizeof(float);
+        return memory;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Conv2DParams params;
+        Status status = ParseParams(inputs, &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t block = inputs[0]->GetShape().dims[4];
+        const float* weight = static_cast<const float*>(inputs[1]->GetData());
+        std::shared_ptr<const NchwcPackedWeight> packed;
+        status = kernel_.Prepare(params, block, weight, &packed);
+        if (!status.IsOk()) {
+            return status;
+        }
+        
+        const bool fuse_sum = GetIntAttribute("fuse_sum", 0) != 0;
+        const size_t bias_index = fuse_sum ? 3 : 2;
+        const Tensor* residual = fuse_sum && inputs.size() >= 3 ? inputs.back() : nullptr;
+        const Tensor* bias = inputs.size() > bias_index ? inputs[2] : nullptr;
+        if (residual && residual->GetElementCount() != outputs[0]->GetElementCount()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcConv sum input shape does not match output");
+        }
+        NchwcConv2DKernel::Run(*packed, params, static_cast<const float*>(inputs[0]->GetData()),
+                               bias ? static_cast<const float*>(bias->GetData()) : nullptr,
+                               residual ? static_cast<const float*>(residual->GetData()) : nullptr,
+                               GetStringAttribute("activation", "") == "Relu",
+                               static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+
+private:
+    Status ParseParams(const std::vector<Tensor*>& inputs, Conv2DParams* params) const {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        const Shape& weight_shape = inputs[1]->GetShape();
+        if (weight_shape.dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "NchwcConv weight must be 4D (OIHW)");
+        }
+        const Shape& blocked = inputs[0]->GetShape();
+        const int64_t in_c = weight_shape.dims[1] * GetIntAttribute("group", 1);
+        Shape nchw;
+        Status status = LogicalShape(blocked, in_c, &nchw);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (blocked.dims[1] * blocked.dims[4] < in_c) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcConv input has fewer channels than the weight");
+        }
+        return ParseConv2DParams(*this, nchw, weight_shape, params);
+    }
+    
+    NchwcConv2DKernel kernel_;
+};
+
+// NCHWc池化：窗口属性与MaxPool/AveragePool相同，补齐的通道一并处理
+class NchwcPoolOperator : public Operator {
+public:
+    explicit NchwcPoolOperator(bool max_pool) : max_pool_(max_pool) {}
+    
+    std::string GetName() const override { return max_pool_ ? "NchwcMaxPool" : "NchwcAveragePool"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Pool2DParams params;
+        Status status = ParseParams(inputs, &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Shape& blocked = inputs[0]->GetShape();
+        output_shapes.push_back(Shape({params.batch, blocked.dims[1], params.out_h, params.out_w,
+                                       blocked.dims[4]}));
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Pool2DParams params;
+        Status status = ParseParams(inputs, &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        NchwcPool2D(params, max_pool_, inputs[0]->GetShape().dims[4],
+                    static_cast<const float*>(inputs[0]->GetData()),
+                    static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+
+private:
+    Status ParseParams(const std::vector<Tensor*>& inputs, Pool2DParams* params) const {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        const Shape& blocked = inputs[0]->GetShape();
+        Shape nchw;
+        Status status = LogicalShape(blocked, blocked.dims.size() == 5 ? blocked.dims[1] * blocked.dims[4] : 0,
+                                     &nchw);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return ParsePool2DParams(*this, nchw, params);
+    }
+    
+    bool max_pool_;
+};
+
+class NchwcMaxPoolOperator : public NchwcPoolOperator {
+public:
+    NchwcMaxPoolOperator() : NchwcPoolOperator(true) {}
+};
+
+class NchwcAveragePoolOperator : public NchwcPoolOperator {
+public:
+    NchwcAveragePoolOperator() : NchwcPoolOperator(false) {}
+};
+
+// NCHWc全局池化：输入为分块布局，属性channels为逻辑通道数，输出为NCHW的[N, channels, 1, 1]
+class NchwcGlobalPoolOperator : public Operator {
+public:
+    explicit NchwcGlobalPoolOperator(bool max_pool) : max_pool_(max_pool) {}
+    
+    std::string GetName() const override {
+        return max_pool_ ? "NchwcGlobalMaxPool" : "NchwcGlobalAveragePool";
+    }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Shape nchw;
+        Status status = ParseShape(inputs, &nchw);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape({nchw.dims[0], nchw.dims[1], 1, 1}));
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Shape nchw;
+        Status status = ParseShape(inputs, &nchw);
+        if (!status.IsOk()) {
+            return status;
+        }
+        NchwcGlobalPool(max_pool_, nchw.dims[0], nchw.dims[1], nchw.dims[2] * nchw.dims[3],
+                        inputs[0]->GetShape().dims[4], static_cast<const float*>(inputs[0]->GetData()),
+                        static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+
+private:
+    Status ParseShape(const std::vector<Tensor*>& inputs, Shape* nchw) const {
+        const Shape& blocked = inputs[0]->GetShape();
+        const int64_t channels = GetIntAttribute("channels", 0);
+        Status status = LogicalShape(blocked, channels, nchw);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (channels <= 0 || channels > blocked.dims[1] * blocked.dims[4]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " channels out of range");
+        }
+        return Status::Ok();
+    }
+    
+    bool max_pool_;
+};
+
+class NchwcGlobalMaxPoolOperator : public NchwcGlobalPoolOperator {
+public:
+    NchwcGlobalMaxPoolOperator() : NchwcGlobalPoolOperator(true) {}
+};
+
+class NchwcGlobalAveragePoolOperator : public NchwcGlobalPoolOperator {
+public:
+    NchwcGlobalAveragePoolOperator() : NchwcGlobalPoolOperator(false) {}
+};
+
+// NchwcBatchNormalization：输入与BatchNormalization相同（x为分块布局），activation为"Relu"时写回前做ReLU
+class NchwcBatchNormalizationOperator : public Operator {
+public:
+    std::string GetName() const override { return "NchwcBatchNormalization"; }
+    int GetInPlaceInput() const override { return 0; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 5) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcBatchNormalization requires 5 inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 5 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        const Shape& shape = inputs[0]->GetShape();
+        if (shape.dims.size() != 5) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcBatchNormalization input must be 5D");
+        }
+        const int64_t block = shape.dims[4];
+        const int64_t padded = shape.dims[1] * block;
+        const int64_t channels = static_cast<int64_t>(inputs[1]->GetElementCount());
+        if (channels > padded) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "NchwcBatchNormalization channel count mismatch");
+        }
+        
+        // 折算为逐通道的scale/shift，补齐的通道为0
+        const float epsilon = GetFloatAttribute("epsilon", 1e-5f);
+        const float* gamma = static_cast<const float*>(inputs[1]->GetData());
+        const float* beta = static_cast<const float*>(inputs[2]->GetData());
+        const float* mean = static_cast<const float*>(inputs[3]->GetData());
+        const float* var = static_cast<const float*>(inputs[4]->GetData());
+        // scale/shift放在暂存区：并发执行同一节点的线程各自折算
+        ScratchArena& arena = ScratchArena::ForCurrentThread();
+        float* scale = arena.Allocate<float>(static_cast<size_t>(padded));
+        float* shift = arena.Allocate<float>(static_cast<size_t>(padded));
+        std::fill(scale, scale + padded, 0.0f);
+        std::fill(shift, shift + padded, 0.0f);
+        for (int64_t c = 0; c < channels; ++c) {
+            scale[c] = gamma[c] / std::sqrt(var[c] + epsilon);
+            shift[c] = beta[c] - mean[c] * scale[c];
+        }
+        NchwcChannelAffine(static_cast<const float*>(inputs[0]->GetData()), shape.dims[0], shape.dims[1],
+                           shape.dims[2] * shape.dims[3], block, scale, shift,
+                           GetStringAttribute("activation", "") == "Relu",
+                           static_cast<float*>(outputs[0]->GetData()), ctx);
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("ReorderInput", ReorderInputOperator);
+REGISTER_OPERATOR("ReorderOutput", ReorderOutputOperator);
+REGISTER_OPERATOR("NchwcConv", NchwcConvOperator);
+REGISTER_OPERATOR("NchwcMaxPool", NchwcMaxPoolOperator);
+REGISTER_OPERATOR("NchwcAveragePool", NchwcAveragePoolOperator);
+REGISTER_OPERATOR("NchwcGlobalMaxPool", NchwcGlobalMaxPoolOperator);
+REGISTER_OPERATOR("NchwcGlobalAveragePool", NchwcGlobalAveragePoolOperator);
+REGISTER_OPERATOR("NchwcBatchNormalization", NchwcBatchNormalizationOperator);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,319 @@
+// NCHWc内核实现
+// 卷积的行内划分参考MLAS的MlasNchwcConv：输出行分成左边缘、内部、右边缘三段，
+// 内部像素的全部抽头都落在输入内，同一组抽头偏移可以一次处理整段
+
+#include "nchwc_kernels.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+int64_t CeilDiv(int64_t a, int64_t b) {
+    return (a + b - 1) / b;
+}
+
+} // anonymous namespace
+
+Shape NchwcShape(const Shape& nchw, int64_t block) {
+    std::vector<int64_t> dims = {nchw.dims[0], nchw.dims[1] < 0 ? -1 : CeilDiv(nchw.dims[1], block),
+                                 nchw.dims[2], nchw.dims[3], block};
+    return Shape(dims);
+}
+
+void ReorderToNchwc(const float* input, int64_t batch, int64_t channels, int64_t spatial,
+                    int64_t block, float* output, ExecutionContext* ctx) {
+    const int64_t channel_blocks = CeilDiv(channels, block);
+    // 每个通道块是[valid, spatial] -> [spatial, block]的二维转置
+    ParallelForOuter(ctx, batch * channel_blocks, spatial * block, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t n = t / channel_blocks;
+            const int64_t cb = t % channel_blocks;
+            const int64_t valid = std::min(block, channels - cb * block);
+            float* dst = output + t * spatial * block;
+            simd::Transpose2DSIMD(input + (n * channels + cb * block) * spatial, static_cast<size_t>(spatial),
+                                  dst, static_cast<size_t>(block),
+                                  static_cast<size_t>(valid), static_cast<size_t>(spatial));
+            if (valid < block) {
+                for (int64_t s = 0; s < spatial; ++s) {
+                    std::fill(dst + s * block + valid, dst + (s + 1) * block, 0.0f);
+                }
+            }
+        }
+    });
+}
+
+void ReorderFromNchwc(const float* input, int64_t batch, int64_t channels, int64_t spatial,
+                      int64_t block, float* output, ExecutionContext* ctx) {
+    const int64_t channel_blocks = CeilDiv(channels, block);
+    ParallelForOuter(ctx, batch * channel_blocks, spatial * block, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t n = t / channel_blocks;
+            const int64_t cb = t % channel_blocks;
+            const int64_t valid = std::min(block, channels - cb * block);
+            simd::Transpose2DSIMD(input + t * spatial * block, static_cast<size_t>(block),
+                                  output + (n * channels + cb * block) * spatial, static_cast<size_t>(spatial),
+                                  static_cast<size_t>(spatial), static_cast<size_t>(valid));
+        }
+    });
+}
+
+Status NchwcConv2DKernel::Prepare(const Conv2DParams& params, int64_t block, const float* weight,
+                                  std::shared_ptr<const NchwcPackedWeight>* packed) {
+    if (params.group != 1) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "NCHWc Conv supports group == 1 only");
+    }
+    if (block <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "NCHWc block size must be positive");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (packed_ && weight == weight_ptr_ && block == packed_->block &&
+        params.in_c == params_.in_c && params.out_c == params_.out_c &&
+        params.kernel_h == params_.kernel_h && params.kernel_w == params_.kernel_w) {
+        *packed = packed_;
+        return Status::Ok();
+    }
+    
+    const int64_t ocb_count = CeilDiv(params.out_c, block);
+    const int64_t icb_count = CeilDiv(params.in_c, block);
+    const int64_t kh = params.kernel_h;
+    const int64_t kw = params.kernel_w;
+    auto built = std::make_shared<NchwcPackedWeight>();
+    built->block = block;
+    built->data.assign(static_cast<size_t>(ocb_count * icb_count * kh * kw * block * block), 0.0f);
+    for (int64_t oc = 0; oc < params.out_c; ++oc) {
+        for (int64_t ic = 0; ic < params.in_c; ++ic) {
+            for (int64_t y = 0; y < kh; ++y) {
+                for (int64_t x = 0; x < kw; ++x) {
+                    const int64_t dst = (((((oc / block) * icb_count + ic / block) * kh + y) * kw + x) * block +
+                                         ic % block) * block + oc % block;
+                    built->data[dst] = weight[((oc * params.in_c + ic) * kh + y) * kw + x];
+                }
+            }
+        }
+    }
+    params_ = params;
+    weight_ptr_ = weight;
+    packed_ = built;
+    *packed = std::move(built);
+    return Status::Ok();
+}
+
+void NchwcConv2DKernel::Run(const NchwcPackedWeight& packed, const Conv2DParams& p, const float* input,
+                            const float* bias, const float* residual, bool relu, float* output,
+                            ExecutionContext* ctx) {
+    const int64_t B = packed.block;
+    const int64_t icb_count = CeilDiv(p.in_c, B);
+    const int64_t ocb_count = CeilDiv(p.out_c, B);
+    const int64_t in_plane = p.in_h * p.in_w * B;
+    const int64_t taps_per_pixel = icb_count * p.kernel_h * p.kernel_w * B;
+    
+    // 内部像素：iw0 = ow * stride - pad_left >= 0且最后一个抽头不越过右边界
+    const int64_t x_begin = std::min(p.out_w, CeilDiv(p.pad_left, p.stride_w));
+    const int64_t last_tap = (p.kernel_w - 1) * p.dilation_w;
+    int64_t x_end = x_begin;
+    if (p.in_w - 1 - last_tap + p.pad_left >= 0) {
+        x_end = std::max(x_begin, std::min(p.out_w, (p.in_w - 1 - last_tap + p.pad_left) / p.stride_w + 1));
+    }
+    
+    ParallelForOuter(ctx, p.batch * ocb_count * p.out_h, p.out_w * taps_per_pixel * B,
+                     [&](int64_t begin, int64_t end) {
+        std::vector<size_t> input_offsets;
+        std::vector<size_t> filter_offsets;
+        input_offsets.reserve(static_cast<size_t>(taps_per_pixel));
+        filter_offsets.reserve(static_cast<size_t>(taps_per_pixel));
+        
+        // 收集第oh行、卷积核列[kw_begin, kw_end)的抽头；iw0为相对base的起始列
+        auto build_taps = [&](int64_t oh, int64_t kw_begin, int64_t kw_end, int64_t iw0) {
+            input_offsets.clear();
+            filter_offsets.clear();
+            const int64_t ih0 = oh * p.stride_h - p.pad_top;
+            for (int64_t icb = 0; icb < icb_count; ++icb) {
+                for (int64_t kh = 0; kh < p.kernel_h; ++kh) {
+                    const int64_t ih = ih0 + kh * p.dilation_h;
+                    if (ih < 0 || ih >= p.in_h) {
+                        continue;
+                    }
+                    for (int64_t kw = kw_begin; kw < kw_end; ++kw) {
+                        const int64_t pixel = icb * p.in_h * p.in_w + ih * p.in_w + iw0 + kw * p.dilation_w;
+                        const int64_t filter = ((icb * p.kernel_h + kh) * p.kernel_w + kw) * B * B;
+                        for (int64_t ic = 0; ic < B; ++ic) {
+                            input_offsets.push_back(static_cast<size_t>(pixel * B + ic));
+                            filter_offsets.push_back(static_cast<size_t>(filter + ic * B));
+                        }
+                    }
+                }
+            }
+        };
+        
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t n = t / (ocb_count * p.out_h);
+            const int64_t ocb = (t / p.out_h) % ocb_count;
+            const int64_t oh = t % p.out_h;
+            const float* in = input + n * icb_count * in_plane;
+            const float* filter = packed.data.data() + ocb * icb_count * p.kernel_h * p.kernel_w * B * B;
+            float* row = output + t * p.out_w * B;
+            
+            for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                for (int64_t o = 0; o < B; ++o) {
+                    const int64_t oc = ocb * B + o;
+                    row[ow * B + o] = bias && oc < p.out_c ? bias[oc] : 0.0f;
+                }
+            }
+            
+            // 边缘像素逐个处理，只保留落在输入内的卷积核列
+            for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                if (ow == x_begin && x_end > x_begin) {
+                    ow = x_end - 1;
+                    continue;
+                }
+                const int64_t iw0 = ow * p.stride_w - p.pad_left;
+                int64_t kw_begin = 0;
+                while (kw_begin < p.kernel_w && iw0 + kw_begin * p.dilation_w < 0) {
+                    ++kw_begin;
+                }
+                int64_t kw_end = p.kernel_w;
+                while (kw_end > kw_begin && iw0 + (kw_end - 1) * p.dilation_w >= p.in_w) {
+                    --kw_end;
+                }
+                build_taps(oh, kw_begin, kw_end, iw0);
+                simd::NchwcConvSIMD(in, 0, input_offsets.data(), filter, filter_offsets.data(),
+                                    input_offsets.size(), row + ow * B, 1, static_cast<size_t>(B));
+            }
+            if (x_end > x_begin) {
+                const int64_t iw0 = x_begin * p.stride_w - p.pad_left;
+                build_taps(oh, 0, p.kernel_w, 0);
+                simd::NchwcConvSIMD(in + iw0 * B, static_cast<size_t>(p.stride_w * B), input_offsets.data(),
+                                    filter, filter_offsets.data(), input_offsets.size(),
+                                    row + x_begin * B, static_cast<size_t>(x_end - x_begin),
+                                    static_cast<size_t>(B));
+            }
+            
+            const size_t row_size = static_cast<size_t>(p.out_w * B);
+            if (residual) {
+                simd::AddSIMD(row, residual + t * p.out_w * B, row, row_size);
+            }
+            if (relu) {
+                simd::ReluSIMD(row, row, row_size);
+            }
+        }
+    });
+}
+
+void NchwcPool2D(const Pool2DParams& p, bool max_pool, int64_t block,
+                 const float* input, float* output, ExecutionContext* ctx) {
+    const int64_t channel_blocks = CeilDiv(p.channels, block);
+    // 内部像素：窗口的所有列都落在输入内，同一组抽头偏移处理整段（与卷积的划分相同）
+    const int64_t x_begin = std::min(p.out_w, CeilDiv(p.pad_left, p.stride_w));
+    int64_t x_end = x_begin;
+    if (p.in_w - p.kernel_w + p.pad_left >= 0) {
+        x_end = std::max(x_begin, std::min(p.out_w, (p.in_w - p.kernel_w + p.pad_left) / p.stride_w + 1));
+    }
+    const float full_scale = 1.0f / static_cast<float>(p.kernel_h * p.kernel_w);
+    
+    ParallelForOuter(ctx, p.batch * channel_blocks * p.out_h, p.out_w * p.kernel_h * p.kernel_w * block,
+                     [&](int64_t begin, int64_t end) {
+        std::vector<size_t> offsets;
+        offsets.reserve(static_cast<size_t>(p.kernel_h * p.kernel_w));
+        // 第oh行、窗口列[kw_begin, kw_end)的抽头，iw0为相对base的起始列；返回有效行数
+        auto build_taps = [&](int64_t oh, int64_t kw_begin, int64_t kw_end, int64_t iw0) {
+            offsets.clear();
+            int64_t rows = 0;
+            for (int64_t kh = 0; kh < p.kernel_h; ++kh) {
+                const int64_t ih = oh * p.stride_h + kh - p.pad_top;
+                if (ih < 0 || ih >= p.in_h) {
+                    continue;
+                }
+                ++rows;
+                for (int64_t kw = kw_begin; kw < kw_end; ++kw) {
+                    offsets.push_back(static_cast<size_t>((ih * p.in_w + iw0 + kw) * block));
+                }
+            }
+            return rows;
+        };
+        auto average_scale = [&](int64_t taps) {
+            if (p.count_include_pad) {
+                return full_scale;
+            }
+            return taps > 0 ? 1.0f / static_cast<float>(taps) : 0.0f;
+        };
+        
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t plane = t / p.out_h;
+            const int64_t oh = t % p.out_h;
+            const float* in = input + plane * p.in_h * p.in_w * block;
+            float* row = output + t * p.out_w * block;
+            
+            // 边缘像素逐个处理，只保留落在输入内的窗口列
+            for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                if (ow == x_begin && x_end > x_begin) {
+                    ow = x_end - 1;
+                    continue;
+                }
+                const int64_t iw0 = ow * p.stride_w - p.pad_left;
+                const int64_t kw_begin = std::min(p.kernel_w, std::max<int64_t>(0, -iw0));
+                const int64_t kw_end = std::max(kw_begin, std::min(p.kernel_w, p.in_w - iw0));
+                build_taps(oh, kw_begin, kw_end, iw0);
+                simd::NchwcPoolSIMD(in, 0, offsets.data(), offsets.size(), row + ow * block, 1,
+                                    static_cast<size_t>(block), max_pool,
+                                    average_scale(static_cast<int64_t>(offsets.size())));
+            }
+            if (x_end > x_begin) {
+                const int64_t iw0 = x_begin * p.stride_w - p.pad_left;
+                build_taps(oh, 0, p.kernel_w, 0);
+                simd::NchwcPoolSIMD(in + iw0 * block, static_cast<size_t>(p.stride_w * block), offsets.data(),
+                                    offsets.size(), row + x_begin * block, static_cast<size_t>(x_end - x_begin),
+                                    static_cast<size_t>(block), max_pool,
+                                    average_scale(static_cast<int64_t>(offsets.size())));
+            }
+        }
+    });
+}
+
+void NchwcGlobalPool(bool max_pool, int64_t batch, int64_t channels, int64_t spatial, int64_t block,
+                     const float* input, float* output, ExecutionContext* ctx) {
+    const int64_t channel_blocks = CeilDiv(channels, block);
+    std::vector<size_t> offsets(static_cast<size_t>(spatial));
+    for (int64_t s = 0; s < spatial; ++s) {
+        offsets[s] = static_cast<size_t>(s * block);
+    }
+    const float scale = spatial > 0 ? 1.0f / static_cast<float>(spatial) : 0.0f;
+    ParallelForOuter(ctx, batch * channel_blocks, spatial * block, [&](int64_t begin, int64_t end) {
+        std::vector<float> reduced(static_cast<size_t>(block));
+        for (int64_t t = begin; t < end; ++t) {
+            const int64_t n = t / channel_blocks;
+            const int64_t cb = t % channel_blocks;
+            simd::NchwcPoolSIMD(input + t * spatial * block, 0, offsets.data(), offsets.size(), reduced.data(), 1,
+                                static_cast<size_t>(block), max_pool, scale);
+            const int64_t valid = std::min(block, channels - cb * block);
+            std::copy(reduced.begin(), reduced.begin() + valid, output + n * channels + cb * block);
+        }
+    });
+}
+
+void NchwcChannelAffine(const float* input, int64_t batch, int64_t channel_blocks, int64_t spatial,
+                        int64_t block, const float* scale, const float* shift, bool relu,
+                        float* output, ExecutionContext* ctx) {
+    ParallelForOuter(ctx, batch * channel_blocks, spatial * block, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            const float* a = scale + (t % channel_blocks) * block;
+            const float* b = shift + (t % channel_blocks) * block;
+            const float* in = input + t * spatial * block;
+            float* out = output + t * spatial * block;
+            for (int64_t s = 0; s < spatial; ++s) {
+                for (int64_t o = 0; o < block; ++o) {
+                    const float y = in[s * block + o] * a[o] + b[o];
+                    out[s * block + o] = relu ? std::max(y, 0.0f) : y;
+                }
+            }
+        }
+    });
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,70 @@
+// NCHWc分块通道布局的CPU内核
+// 参考ONNX Runtime的NchwcTransformer与MLAS的NCHWc内核：张量存为[N, ceil(C/c), H, W, c]，
+// c（block）取SIMD寄存器宽度（AVX-512为16，其余为8），一个像素的一组通道正好是一个向量，
+// 卷积按输出通道块向量化、池化与BN逐块处理；通道数不是c的倍数时末块以0补齐
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include "conv_kernels.h"
+#include "pooling.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// 逻辑NCHW形状对应的分块形状[N, ceil(C/block), H, W, block]
+Shape NchwcShape(const Shape& nchw, int64_t block);
+
+// NCHW <-> NCHWc；channels为逻辑通道数，转入时补齐的通道写0
+void ReorderToNchwc(const float* input, int64_t batch, int64_t channels, int64_t spatial,
+                    int64_t block, float* output, ExecutionContext* ctx);
+void ReorderFromNchwc(const float* input, int64_t batch, int64_t channels, int64_t spatial,
+                      int64_t block, float* output, ExecutionContext* ctx);
+
+// NCHWc直接卷积的重排权重，构建后只读
+struct NchwcPackedWeight {
+    int64_t block = 0;
+    std::vector<float> data;
+};
+
+// NCHWc直接卷积（group == 1）：输入输出都是分块布局，权重在Prepare时重排为
+// [out_c/block][ceil(in_c/block)][kernel_h][kernel_w][block(ic)][block(oc)]，补齐的输入通道权重为0。
+// 重排结果在锁内查找与替换，并发执行的调用方各自持有取得的结果直到Run返回
+class NchwcConv2DKernel {
+public:
+    // params的空间尺寸可以未知，权重打包只依赖通道与卷积核；通道、卷积核、block与权重未变时复用上次的结果
+    Status Prepare(const Conv2DParams& params, int64_t block, const float* weight,
+                   std::shared_ptr<const NchwcPackedWeight>* packed);
+    
+    // bias为[out_c]（可为nullptr）；residual非空时与输出同形，在ReLU之前相加
+    static void Run(const NchwcPackedWeight& packed, const Conv2DParams& params, const float* input,
+                    const float* bias, const float* residual, bool relu, float* output, ExecutionContext* ctx);
+
+private:
+    std::mutex mutex_;
+    Conv2DParams params_;
+    const float* weight_ptr_ = nullptr;
+    std::shared_ptr<const NchwcPackedWeight> packed_;
+};
+
+// 分块布局的池化；params为逻辑NCHW的池化参数
+void NchwcPool2D(const Pool2DParams& params, bool max_pool, int64_t block,
+                 const float* input, float* output, ExecutionContext* ctx);
+
+// 分块布局的全局池化：每个通道块的全部像素按通道同时归约（一个向量即是一组通道），
+// 输出直接写成逻辑NCHW的[N, channels, 1, 1]，不需要再转回布局
+void NchwcGlobalPool(bool max_pool, int64_t batch, int64_t channels, int64_t spatial, int64_t block,
+                     const float* input, float* output, ExecutionContext* ctx);
+
+// 分块布局的逐通道仿射：y = x * scale[c] + shift[c]（可选ReLU），scale/shift已按block补齐
+void NchwcChannelAffine(const float* input, int64_t batch, int64_t channel_blocks, int64_t spatial,
+                        int64_t block, const float* scale, const float* shift, bool relu,
+                        float* output, ExecutionContext* ctx);
+
+} // namespace operators
+} // namespace inferunity
@@ -1,18 +1,23 @@
 // 归一化算子实现
-// 参考NCNN的BatchNormalization实现
+// 参考NCNN的BatchNormalization实现；LayerNorm/RMSNorm参考ONNX Runtime的SkipLayerNormalization
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
 #include <algorithm>
 #include <cmath>
 
 namespace inferunity {
 namespace operators {
 
-// BatchNormalization算子
+// BatchNormalization算子（推理模式）；FusedBNReLU复用同一实现并在写回时做ReLU
 class BatchNormalizationOperator : public Operator {
 public:
+    BatchNormalizationOperator() : fused_relu_(false) {}
+    
     std::string GetName() const override { return "BatchNormalization"; }
+    int GetInPlaceInput() const override { return 0; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.size() < 5) {
@@ -28,58 +33,105 @@ public:
         return Status::Ok();
     }
     
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 推理时每个元素一次缩放一次平移（缩放与平移按通道预先合并）
+        return EstimateElementwiseCost(inputs, outputs, fused_relu_ ? 3.0 : 2.0);
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
         if (inputs.size() < 5 || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         Tensor* input = inputs[0];      // X
         Tensor* scale = inputs[1];      // scale (gamma)
         Tensor* bias = inputs[2];       // B (beta)
         Tensor* mean = inputs[3];      // mean
         Tensor* var = inputs[4];        // variance
         Tensor* output = outputs[0];
-        
+    
         const Shape& input_shape = input->GetShape();
         int64_t channels = input_shape.dims[1];
-        
+    
         // 获取epsilon（默认1e-5）
-        float epsilon = 1e-5f;
-        
+        const float epsilon = GetFloatAttribute("epsilon", 1e-5f);
+        const bool fused_relu = fused_relu_;
+    
         const float* input_data = static_cast<const float*>(input->GetData());
         const float* scale_data = static_cast<const float*>(scale->GetData());
         const float* bias_data = static_cast<const float*>(bias->GetData());
         const float* mean_data = static_cast<const float*>(mean->GetData());
         const float* var_data = static_cast<const float*>(var->GetData());
         float* output_data = static_cast<float*>(output->GetData());
-        
+    
         size_t count = input->GetElementCount();
         int64_t spatial_size = count / (input_shape.dims[0] * channels);
-        
+    
         // BatchNorm: y = scale * (x - mean) / sqrt(var + epsilon) + bias
-        for (size_t i = 0; i < count; ++i) {
-            int64_t c = (i / spatial_size) % channels;
-            float normalized = (input_data[i] - mean_data[c]) / std::sqrt(var_data[c] + epsilon);
-            output_data[i] = scale_data[c] * normalized + bias_data[c];
-        }
-        
+        // 按(N, C)平面切分给算子内线程
+        const int64_t num_planes = spatial_size > 0 ? static_cast<int64_t>(count) / spatial_size : 0;
+        ParallelForOuter(ctx, num_planes, spatial_size, [&](int64_t plane_begin, int64_t plane_end) {
+            for (int64_t p = plane_begin; p < plane_end; ++p) {
+                const int64_t c = p % channels;
+                const float* plane_input = input_data + p * spatial_size;
+                float* plane_output = output_data + p * spatial_size;
+                for (int64_t i = 0; i < spatial_size; ++i) {
+                    float normalized = (plane_input[i] - mean_data[c]) / std::sqrt(var_data[c] + epsilon);
+                    const float y = scale_data[c] * normalized + bias_data[c];
+                    plane_output[i] = fused_relu ? std::max(y, 0.0f) : y;
+                }
+            }
+        });
+    
         return Status::Ok();
     }
+
+protected:
+    explicit BatchNormalizationOperator(bool fused_relu) : fused_relu_(fused_relu) {}
+
+private:
+    bool fused_relu_;
 };
 
 REGISTER_OPERATOR("BatchNormalization", BatchNormalizationOperator);
 
-// LayerNormalization算子（Transformer常用）
-class LayerNormalizationOperator : public Operator {
+// FusedBNReLU算子：融合BatchNormalization+ReLU（BN的输入不是可融合的Conv时使用）
+class FusedBNReLUOperator : public BatchNormalizationOperator {
 public:
-    std::string GetName() const override { return "LayerNormalization"; }
+    FusedBNReLUOperator() : BatchNormalizationOperator(true) {}
+    std::string GetName() const override { return "FusedBNReLU"; }
+};
+
+REGISTER_OPERATOR("FusedBNReLU", FusedBNReLUOperator);
+
+// 最后若干维的归一化（LayerNormalization/RMSNorm及融合残差相加的AddLayerNorm/AddRMSNorm，
+// 参考ONNX Runtime的SkipLayerNormalization/SkipSimplifiedLayerNormalization）：
+// 每组一遍读取求统计量（LayerNorm为Welford均值与方差，RMSNorm为平方和），第二遍归一化写回。
+// 融合版本的输入为(a, b, scale[, bias])，x = a + b在第一遍写入可选的第二个输出（下一层的残差），
+// 没有该输出时暂存在y中，相比单独的Add省去一次x的写出与读入
+class NormalizationOperatorBase : public Operator {
+public:
+    NormalizationOperatorBase(const char* name, bool rms, bool fused_add, float default_epsilon)
+        : name_(name), rms_(rms), fused_add_(fused_add), default_epsilon_(default_epsilon) {}
+    
+    std::string GetName() const override { return name_; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
+        const size_t required = fused_add_ ? 3 : 2;
+        if (inputs.size() < required) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "LayerNormalization requires at least 2 inputs (input, scale)");
+                               name_ + (fused_add_ ? " requires inputs (a, b, scale)" : " requires inputs (input, scale)"));
+        }
+        for (Tensor* input : inputs) {
+            if (!input || input->GetDataType() != DataType::FLOAT32) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " only supports FLOAT32");
+            }
+        }
+        if (fused_add_ && inputs[0]->GetShape().dims != inputs[1]->GetShape().dims) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " requires a and b of the same shape");
         }
         return Status::Ok();
     }
@@ -87,192 +139,202 @@ public:
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
         output_shapes.push_back(inputs[0]->GetShape());
+        if (fused_add_) {
+            output_shapes.push_back(inputs[0]->GetShape());  // a + b
+        }
         return Status::Ok();
     }
     
-    Status Execute(const std::vector<Tensor*>& inputs,
-                  const std::vector<Tensor*>& outputs,
-                  ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
-        }
-        
-        Tensor* input = inputs[0];
-        Tensor* scale = inputs[1];
-        Tensor* bias = inputs.size() > 2 ? inputs[2] : nullptr;
-        Tensor* output = outputs[0];
-        
-        // 获取axis属性（默认-1，即最后一个维度）
-        int axis = -1;
-        auto axis_attr = GetAttribute("axis");
-        if (axis_attr.GetType() == AttributeValue::Type::INT) {
-            axis = static_cast<int>(axis_attr.GetInt());
-        }
-        
-        // 获取epsilon属性（默认1e-5）
-        float epsilon = 1e-5f;
-        auto epsilon_attr = GetAttribute("epsilon");
-        if (epsilon_attr.GetType() == AttributeValue::Type::FLOAT) {
-            epsilon = epsilon_attr.GetFloat();
+    void SpecializeForShapes(const std::vector<Shape>& input_shapes) override {
+        specialized_slot_ = -1;
+        if (input_shapes.empty()) {
+            return;
         }
-        
-        const Shape& input_shape = input->GetShape();
-        int rank = static_cast<int>(input_shape.dims.size());
-        
+        const std::vector<int64_t>& dims = input_shapes[0].dims;
+        const int64_t rank = static_cast<int64_t>(dims.size());
+        int64_t axis = GetIntAttribute("axis", -1);
         if (axis < 0) {
             axis += rank;
         }
-        
-        // 计算归一化维度的大小
-        int64_t norm_size = 1;
-        for (int i = axis; i < rank; ++i) {
-            norm_size *= input_shape.dims[i];
+        if (axis < 0 || axis >= rank) {
+            return;
         }
-        
-        const float* input_data = static_cast<const float*>(input->GetData());
-        const float* scale_data = static_cast<const float*>(scale->GetData());
-        const float* bias_data = bias ? static_cast<const float*>(bias->GetData()) : nullptr;
-        float* output_data = static_cast<float*>(output->GetData());
-        
-        size_t total_count = input->GetElementCount();
-        int64_t num_groups = total_count / norm_size;
-        
-        // LayerNorm: y = scale * (x - mean) / sqrt(var + eps) + bias
-        for (int64_t g = 0; g < num_groups; ++g) {
-            const float* group_input = input_data + g * norm_size;
-            float* group_output = output_data + g * norm_size;
-            
-            // 计算mean
-            float mean = 0.0f;
-            for (int64_t i = 0; i < norm_size; ++i) {
-                mean += group_input[i];
-            }
-            mean /= norm_size;
-            
-            // 计算var
-            float var = 0.0f;
-            for (int64_t i = 0; i < norm_size; ++i) {
-                float diff = group_input[i] - mean;
-                var += diff * diff;
-            }
-            var /= norm_size;
-            
-            // 归一化
-            float inv_std = 1.0f / std::sqrt(var + epsilon);
-            for (int64_t i = 0; i < norm_size; ++i) {
-                float normalized = (group_input[i] - mean) * inv_std;
-                float scaled = scale_data[i] * normalized;
-                group_output[i] = bias_data ? scaled + bias_data[i] : scaled;
+        int64_t norm_size = 1;
+        for (int64_t i = axis; i < rank; ++i) {
+            if (dims[i] <= 0) {
+                return;
             }
+            norm_size *= dims[i];
         }
-        
-        return Status::Ok();
-    }
-};
-
-REGISTER_OPERATOR("LayerNormalization", LayerNormalizationOperator);
-
-// RMSNorm算子（Root Mean Square Layer Normalization，部分Transformer模型使用）
-// RMSNorm(x) = (x / sqrt(mean(x^2) + eps)) * scale
-class RMSNormOperator : public Operator {
-public:
-    std::string GetName() const override { return "RMSNorm"; }
-    
-    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "RMSNorm requires at least 2 inputs (input, scale)");
-        }
-        return Status::Ok();
+        specialized_slot_ = simd::FindSpecializedRowSlot(norm_size);
+        specialized_size_ = norm_size;
     }
     
-    Status InferOutputShape(const std::vector<Tensor*>& inputs,
-                           std::vector<Shape>& output_shapes) const override {
-        output_shapes.push_back(inputs[0]->GetShape());
-        return Status::Ok();
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // LayerNorm每个元素：均值与方差的累加（4）、减均值乘倒数（2）、scale与bias（2）；
+        // RMSNorm：平方累加（2）、乘倒数与scale（2），另有计算rms的一次；融合的残差相加再加1
+        return EstimateElementwiseCost(inputs, outputs, (rms_ ? 5.0 : 8.0) + (fused_add_ ? 1.0 : 0.0));
     }
     
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
+        const size_t param_index = fused_add_ ? 2 : 1;
+        if (inputs.size() <= param_index || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         Tensor* input = inputs[0];
-        Tensor* scale = inputs[1];
+        Tensor* residual = fused_add_ ? inputs[1] : nullptr;
+        Tensor* scale = inputs[param_index];
+        // RMSNorm没有bias
+        Tensor* bias = !rms_ && inputs.size() > param_index + 1 ? inputs[param_index + 1] : nullptr;
         Tensor* output = outputs[0];
-        
-        // 获取epsilon属性（默认1e-6）
-        float epsilon = 1e-6f;
-        auto epsilon_attr = GetAttribute("epsilon");
-        if (epsilon_attr.GetType() == AttributeValue::Type::FLOAT) {
-            epsilon = epsilon_attr.GetFloat();
-        }
-        
+        Tensor* sum_output = fused_add_ && outputs.size() > 1 ? outputs[1] : nullptr;
+    
+        // 获取epsilon属性（LayerNorm默认1e-5，RMSNorm默认1e-6）
+        const float epsilon = GetFloatAttribute("epsilon", default_epsilon_);
+    
+        // 获取axis属性（默认-1，即最后一个维度）
         const Shape& input_shape = input->GetShape();
         int rank = static_cast<int>(input_shape.dims.size());
-        
-        // 默认在最后一个维度归一化
-        int axis = rank - 1;
+        int axis = -1;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
-            if (axis < 0) axis += rank;
         }
-        
+        if (axis < 0) {
+            axis += rank;
+        }
+        if (axis < 0 || axis > rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " axis out of range");
+        }
+    
         // 计算归一化维度的大小
         int64_t norm_size = 1;
         for (int i = axis; i < rank; ++i) {
             norm_size *= input_shape.dims[i];
         }
-        
+        if (norm_size <= 0) {
+            return Status::Ok();
+        }
+    
+        // scale/bias的长度可以是norm_size的约数（沿归一化维度广播），展开后交给SIMD内核
+        std::vector<float> gamma_buffer, beta_buffer;
+        const float* gamma = ExpandParameter(scale, norm_size, &gamma_buffer);
+        const float* beta = bias ? ExpandParameter(bias, norm_size, &beta_buffer) : nullptr;
+        if (!gamma || (bias && !beta)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               name_ + " scale/bias size must divide the normalized size");
+        }
+    
         const float* input_data = static_cast<const float*>(input->GetData());
-        const float* scale_data = static_cast<const float*>(scale->GetData());
+        const float* residual_data = residual ? static_cast<const float*>(residual->GetData()) : nullptr;
         float* output_data = static_cast<float*>(output->GetData());
-        
-        size_t total_count = input->GetElementCount();
-        int64_t num_groups = total_count / norm_size;
-        
-        // RMSNorm: y = (x / sqrt(mean(x^2) + eps)) * scale
-        for (int64_t g = 0; g < num_groups; ++g) {
-            const float* group_input = input_data + g * norm_size;
-            float* group_output = output_data + g * norm_size;
-            
-            // 计算mean(x^2)
-            float mean_sq = 0.0f;
-            for (int64_t i = 0; i < norm_size; ++i) {
-                float val = group_input[i];
-                mean_sq += val * val;
-            }
-            mean_sq /= static_cast<float>(norm_size);
-            
-            // 归一化：计算inv_rms，避免除零
-            float rms_sq = mean_sq + epsilon;
-            if (rms_sq <= 0.0f) {
-                rms_sq = epsilon;  // 防止数值问题
-            }
-            float inv_rms = 1.0f / std::sqrt(rms_sq);
-            
-            // 应用归一化和scale
-            // scale的形状应该匹配归一化维度
-            const Shape& scale_shape = scale->GetShape();
-            int64_t scale_size = scale_shape.GetElementCount();
-            
-            for (int64_t i = 0; i < norm_size; ++i) {
-                // scale索引：如果scale_size == norm_size，直接使用i
-                // 否则使用 i % scale_size 来处理广播
-                int64_t scale_idx = (scale_size == norm_size) ? i : (i % scale_size);
-                group_output[i] = group_input[i] * inv_rms * scale_data[scale_idx];
-            }
+        float* sum_data = sum_output ? static_cast<float*>(sum_output->GetData()) : nullptr;
+    
+        const int64_t num_groups = static_cast<int64_t>(input->GetElementCount()) / norm_size;
+        const size_t n = static_cast<size_t>(norm_size);
+        if (specialized_slot_ >= 0 && norm_size == specialized_size_) {
+            const int slot = specialized_slot_;
+            ParallelForOuter(ctx, num_groups, norm_size, [&](int64_t group_begin, int64_t group_end) {
+                for (int64_t g = group_begin; g < group_end; ++g) {
+                    const int64_t offset = g * norm_size;
+                    simd::NormRowFixedSIMD(slot, input_data + offset, residual_data ? residual_data + offset : nullptr,
+                                           sum_data ? sum_data + offset : nullptr, output_data + offset, epsilon,
+                                           gamma, beta, rms_);
+                }
+            });
+            return Status::Ok();
         }
-        
+        ParallelForOuter(ctx, num_groups, norm_size, [&](int64_t group_begin, int64_t group_end) {
+            for (int64_t g = group_begin; g < group_end; ++g) {
+                const float* a = input_data + g * norm_size;
+                const float* b = residual_data ? residual_data + g * norm_size : nullptr;
+                float* y = output_data + g * norm_size;
+                // 融合相加时x = a + b先写到sum（或暂存到y），第二遍从那里读取
+                float* x_sum = b ? (sum_data ? sum_data + g * norm_size : y) : nullptr;
+                const float* x = b ? x_sum : a;
+    
+                if (rms_) {
+                    // RMSNorm: y = (x / sqrt(mean(x^2) + eps)) * scale
+                    const float mean_sq = simd::AddSumSquaresSIMD(a, b, x_sum, n) / static_cast<float>(n);
+                    const float inv_rms = 1.0f / std::sqrt(mean_sq + epsilon);
+                    simd::NormalizeScaleSIMD(x, y, n, 0.0f, inv_rms, gamma, nullptr);
+                } else {
+                    // LayerNorm: y = scale * (x - mean) / sqrt(var + eps) + bias
+                    float mean = 0.0f, m2 = 0.0f;
+                    simd::AddWelfordSIMD(a, b, x_sum, n, &mean, &m2);
+                    const float var = std::max(m2 / static_cast<float>(n), 0.0f);
+                    const float inv_std = 1.0f / std::sqrt(var + epsilon);
+                    simd::NormalizeScaleSIMD(x, y, n, mean, inv_std, gamma, beta);
+                }
+            }
+        });
+    
         return Status::Ok();
     }
+
+private:
+    static const float* ExpandParameter(const Tensor* param, int64_t norm_size, std::vector<float>* buffer) {
+        const int64_t count = static_cast<int64_t>(param->GetElementCount());
+        const float* data = static_cast<const float*>(param->GetData());
+        if (count == norm_size) {
+            return data;
+        }
+        if (count <= 0 || norm_size % count != 0) {
+            return nullptr;
+        }
+        buffer->resize(static_cast<size_t>(norm_size));
+        for (int64_t i = 0; i < norm_size; ++i) {
+            (*buffer)[i] = data[i % count];
+        }
+        return buffer->data();
+    }
+    
+    std::string name_;
+    bool rms_;
+    bool fused_add_;
+    float default_epsilon_;
+    // SpecializeForShapes选定的专用核（见simd::FindSpecializedRowSlot），-1表示通用路径
+    int specialized_slot_ = -1;
+    int64_t specialized_size_ = 0;
+};
+
+// LayerNormalization算子（Transformer常用）
+class LayerNormalizationOperator : public NormalizationOperatorBase {
+public:
+    LayerNormalizationOperator() : NormalizationOperatorBase("LayerNormalization", false, false, 1e-5f) {}
+};
+
+REGISTER_OPERATOR("LayerNormalization", LayerNormalizationOperator);
+
+// RMSNorm算子（Root Mean Square Layer Normalization，部分Transformer模型使用）
+// RMSNorm(x) = (x / sqrt(mean(x^2) + eps)) * scale
+class RMSNormOperator : public NormalizationOperatorBase {
+public:
+    RMSNormOperator() : NormalizationOperatorBase("RMSNorm", true, false, 1e-6f) {}
 };
 
 REGISTER_OPERATOR("RMSNorm", RMSNormOperator);
 
+// AddLayerNorm算子：LayerNormalization(a + b)，第二个输出为a + b
+class AddLayerNormOperator : public NormalizationOperatorBase {
+public:
+    AddLayerNormOperator() : NormalizationOperatorBase("AddLayerNorm", false, true, 1e-5f) {}
+};
+
+REGISTER_OPERATOR("AddLayerNorm", AddLayerNormOperator);
+
+// AddRMSNorm算子：RMSNorm(a + b)，第二个输出为a + b
+class AddRMSNormOperator : public NormalizationOperatorBase {
+public:
+    AddRMSNormOperator() : NormalizationOperatorBase("AddRMSNorm", true, true, 1e-6f) {}
+};
+
+REGISTER_OPERATOR("AddRMSNorm", AddRMSNormOperator);
+
 } // namespace operators
 } // namespace inferunity
 
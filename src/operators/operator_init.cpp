@@ -2,6 +2,7 @@
 // 通过强制链接所有算子源文件来确保静态初始化被执行
 
 #include "inferunity/operator.h"
+#include "simd_utils.h"
 #include <iostream>
 
 namespace inferunity {
@@ -23,6 +24,9 @@ void InitializeOperators() {
     
     // 更好的方法：在CMakeLists.txt中确保所有算子源文件都被链接
     // 或者使用-Wl,--whole-archive来强制包含所有符号
+    
+    // 按CPUID选定SIMD核，避免首次推理时才做检测
+    simd::InitializeSimdDispatch();
 }
 
 } // namespace inferunity
@@ -0,0 +1,54 @@
+// 算子内并行工具
+// 参考ONNX Runtime的ThreadPool::TryParallelFor：按外层维度切块，
+// 每块的工作量不低于min_work_per_thread，工作量不足时直接在调用线程执行；
+// 混合架构上按核的算力多切块（见ThreadPool::GetBalancedChunkCount）。
+// 每块在各自的ScratchScope中执行：块内从暂存区切出的缓冲在块结束时回收
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace inferunity {
+namespace operators {
+
+// 将[0, outer)切分给算子内线程执行fn(begin, end)；work_per_item为每个外层元素对应的内层元素数
+template <typename F>
+void ParallelForOuter(ExecutionContext* ctx, int64_t outer, int64_t work_per_item, F&& fn) {
+    if (outer <= 0) {
+        return;
+    }
+    int64_t max_chunks = 1;
+    if (ctx) {
+        const IntraOpParallelism& config = ctx->GetIntraOpParallelism();
+        const int64_t min_work = std::max<int64_t>(config.min_work_per_thread, 1);
+        const int64_t total_work = outer * std::max<int64_t>(work_per_item, 1);
+        // 混合架构上块数多于线程数，快核动态多领几块
+        const int64_t balanced = static_cast<int64_t>(
+            ThreadPool::GetBalancedChunkCount(static_cast<size_t>(std::max(config.num_threads, 1))));
+        max_chunks = std::min<int64_t>({balanced, total_work / min_work, outer});
+    }
+    const size_t scratch_bytes = ctx ? ctx->GetScratchBytes() : 0;
+    if (max_chunks <= 1 || ThreadPool::GetThreadCount() <= 1) {
+        ScratchScope scope(scratch_bytes);
+        fn(static_cast<int64_t>(0), outer);
+        return;
+    }
+    const int64_t grain = (outer + max_chunks - 1) / max_chunks;
+    ThreadPool::ParallelFor(0, outer, grain, [&](int64_t begin, int64_t end) {
+        ScratchScope scope(scratch_bytes);
+        fn(begin, end);
+    });
+}
+
+// 逐元素算子：按连续元素区间切块
+template <typename F>
+void ParallelForElements(ExecutionContext* ctx, int64_t count, F&& fn) {
+    ParallelForOuter(ctx, count, 1, std::forward<F>(fn));
+}
+
+} // namespace operators
+} // namespace inferunity
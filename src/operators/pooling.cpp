@@ -1,19 +1,190 @@
 // 池化算子实现
-// 参考NCNN的池化实现
+// 参考NCNN的池化实现与MLAS的MlasPool：NCHW窗口按行可分离计算，全局池化为逐平面的SIMD归约
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "pooling.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
 #include <algorithm>
 #include <cmath>
 #include <climits>
+#include <limits>
 
 namespace inferunity {
 namespace operators {
 
-// MaxPool算子
-class MaxPoolOperator : public Operator {
+// 池化窗口解析（NCHW与NCHWc池化共用）
+Status ParsePool2DParams(const Operator& op, const Shape& shape, Pool2DParams* params) {
+    if (shape.dims.size() != 4) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pool input must be 4D (NCHW)");
+    }
+    Pool2DParams p;
+    p.batch = shape.dims[0];
+    p.channels = shape.dims[1];
+    p.in_h = shape.dims[2];
+    p.in_w = shape.dims[3];
+    
+    const std::vector<int64_t> kernel = op.GetIntsAttribute("kernel_shape");
+    if (!kernel.empty()) {
+        p.kernel_h = kernel[0];
+        p.kernel_w = kernel.size() > 1 ? kernel[1] : kernel[0];
+        p.stride_h = p.stride_w = 1;
+    }
+    const std::vector<int64_t> strides = op.GetIntsAttribute("strides");
+    if (!strides.empty()) {
+        p.stride_h = strides[0];
+        p.stride_w = strides.size() > 1 ? strides[1] : strides[0];
+    }
+    // ONNX pads格式：[top, left, bottom, right]
+    const std::vector<int64_t> pads = op.GetIntsAttribute("pads");
+    if (pads.size() == 4) {
+        p.pad_top = pads[0];
+        p.pad_left = pads[1];
+        p.pad_bottom = pads[2];
+        p.pad_right = pads[3];
+    } else if (pads.size() == 2) {
+        p.pad_top = p.pad_bottom = pads[0];
+        p.pad_left = p.pad_right = pads[1];
+    } else if (pads.size() == 1) {
+        p.pad_top = p.pad_bottom = p.pad_left = p.pad_right = pads[0];
+    }
+    if (p.kernel_h <= 0 || p.kernel_w <= 0 || p.stride_h <= 0 || p.stride_w <= 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Pool kernel_shape/strides must be positive");
+    }
+    p.count_include_pad = op.GetIntAttribute("count_include_pad", 0) != 0;
+    
+    const bool ceil_mode = op.GetIntAttribute("ceil_mode", 0) != 0;
+    const int64_t span_h = p.in_h + p.pad_top + p.pad_bottom - p.kernel_h;
+    const int64_t span_w = p.in_w + p.pad_left + p.pad_right - p.kernel_w;
+    p.out_h = (ceil_mode ? (span_h + p.stride_h - 1) : span_h) / p.stride_h + 1;
+    p.out_w = (ceil_mode ? (span_w + p.stride_w - 1) : span_w) / p.stride_w + 1;
+    if (p.in_h > 0 && p.in_w > 0 && (p.out_h <= 0 || p.out_w <= 0)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pool window larger than input");
+    }
+    *params = p;
+    return Status::Ok();
+}
+
+namespace {
+
+// 按行可分离地计算NCHW池化：窗口内的有效输入行先用SIMD逐元素归约成一行，再沿列取窗口；
+// 最常见的2x2s2与3x3s2窗口的列方向展开为固定抽头
+template <int64_t kKernel, int64_t kStride, bool kMax>
+void PoolRowFixed(const float* src, float* out, int64_t count, float scale) {
+    for (int64_t j = 0; j < count; ++j) {
+        const float* x = src + j * kStride;
+        float acc = x[0];
+        for (int64_t k = 1; k < kKernel; ++k) {
+            acc = kMax ? std::max(acc, x[k]) : acc + x[k];
+        }
+        out[j] = kMax ? acc : acc * scale;
+    }
+}
+
+void PoolRow(const float* src, float* out, int64_t count, int64_t kernel, int64_t stride,
+             bool max_pool, float scale) {
+    if (stride == 2 && kernel == 2) {
+        max_pool ? PoolRowFixed<2, 2, true>(src, out, count, scale)
+                 : PoolRowFixed<2, 2, false>(src, out, count, scale);
+        return;
+    }
+    if (stride == 2 && kernel == 3) {
+        max_pool ? PoolRowFixed<3, 2, true>(src, out, count, scale)
+                 : PoolRowFixed<3, 2, false>(src, out, count, scale);
+        return;
+    }
+    for (int64_t j = 0; j < count; ++j) {
+        const float* x = src + j * stride;
+        float acc = x[0];
+        for (int64_t k = 1; k < kernel; ++k) {
+            acc = max_pool ? std::max(acc, x[k]) : acc + x[k];
+        }
+        out[j] = max_pool ? acc : acc * scale;
+    }
+}
+
+} // anonymous namespace
+
+void Pool2DNchw(const Pool2DParams& p, bool max_pool, const float* input, float* output,
+                ExecutionContext* ctx) {
+    const float lowest = -std::numeric_limits<float>::max();
+    // 窗口的所有列都落在输入内的输出列[x_begin, x_end)
+    const int64_t x_begin = std::min(p.out_w, (p.pad_left + p.stride_w - 1) / p.stride_w);
+    int64_t x_end = x_begin;
+    if (p.in_w - p.kernel_w + p.pad_left >= 0) {
+        x_end = std::max(x_begin, std::min(p.out_w, (p.in_w - p.kernel_w + p.pad_left) / p.stride_w + 1));
+    }
+    
+    // 按N×C个平面并行
+    ParallelForOuter(ctx, p.batch * p.channels, p.out_h * p.out_w * p.kernel_h * p.kernel_w,
+                     [&](int64_t begin, int64_t end) {
+        std::vector<float> reduced(static_cast<size_t>(p.in_w));
+        for (int64_t nc = begin; nc < end; ++nc) {
+            const float* plane = input + nc * p.in_h * p.in_w;
+            for (int64_t oh = 0; oh < p.out_h; ++oh) {
+                float* out = output + (nc * p.out_h + oh) * p.out_w;
+                const int64_t ih0 = oh * p.stride_h - p.pad_top;
+                const int64_t h_begin = std::max<int64_t>(0, ih0);
+                const int64_t h_end = std::min(p.in_h, ih0 + p.kernel_h);
+                if (h_end <= h_begin) {
+                    std::fill(out, out + p.out_w, max_pool ? lowest : 0.0f);
+                    continue;
+                }
+    
+                // 列方向：有效行逐元素归约
+                const float* row = plane + h_begin * p.in_w;
+                if (h_end - h_begin > 1) {
+                    const size_t width = static_cast<size_t>(p.in_w);
+                    for (int64_t ih = h_begin + 1; ih < h_end; ++ih) {
+                        const float* a = ih == h_begin + 1 ? row : reduced.data();
+                        if (max_pool) {
+                            simd::MaxSIMD(a, plane + ih * p.in_w, reduced.data(), width);
+                        } else {
+                            simd::AddSIMD(a, plane + ih * p.in_w, reduced.data(), width);
+                        }
+                    }
+                    row = reduced.data();
+                }
+                const int64_t rows = h_end - h_begin;
+    
+                // 行方向：边缘列逐个处理，内部列用固定抽头
+                for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                    if (ow == x_begin && x_end > x_begin) {
+                        ow = x_end - 1;
+                        continue;
+                    }
+                    const int64_t iw0 = ow * p.stride_w - p.pad_left;
+                    const int64_t w_begin = std::max<int64_t>(0, iw0);
+                    const int64_t w_end = std::min(p.in_w, iw0 + p.kernel_w);
+                    if (w_end <= w_begin) {
+                        out[ow] = max_pool ? lowest : 0.0f;
+                        continue;
+                    }
+                    float acc = max_pool ? lowest : 0.0f;
+                    for (int64_t iw = w_begin; iw < w_end; ++iw) {
+                        acc = max_pool ? std::max(acc, row[iw]) : acc + row[iw];
+                    }
+                    const int64_t count = p.count_include_pad ? p.kernel_h * p.kernel_w : rows * (w_end - w_begin);
+                    out[ow] = max_pool ? acc : acc / static_cast<float>(count);
+                }
+                if (x_end > x_begin) {
+                    const int64_t count = p.count_include_pad ? p.kernel_h * p.kernel_w : rows * p.kernel_w;
+                    PoolRow(row + x_begin * p.stride_w - p.pad_left, out + x_begin, x_end - x_begin,
+                            p.kernel_w, p.stride_w, max_pool, 1.0f / static_cast<float>(count));
+                }
+            }
+        }
+    });
+}
+
+// MaxPool/AveragePool算子（NCHW）
+class Pool2DOperator : public Operator {
 public:
-    std::string GetName() const override { return "MaxPool"; }
+    explicit Pool2DOperator(bool max_pool) : max_pool_(max_pool) {}
+    
+    std::string GetName() const override { return max_pool_ ? "MaxPool" : "AveragePool"; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -21,29 +192,19 @@ public:
         }
         if (inputs[0]->GetShape().dims.size() < 4) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "MaxPool input must be 4D (NCHW)");
+                               GetName() + " input must be 4D (NCHW)");
         }
         return Status::Ok();
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        const Shape& input_shape = inputs[0]->GetShape();
-        
-        // 获取属性（简化：默认值）
-        int64_t kernel_h = 2, kernel_w = 2;
-        int64_t stride_h = 2, stride_w = 2;
-        int64_t pad_h = 0, pad_w = 0;
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t channels = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        
-        int64_t out_h = (in_h + 2 * pad_h - kernel_h) / stride_h + 1;
-        int64_t out_w = (in_w + 2 * pad_w - kernel_w) / stride_w + 1;
-        
-        output_shapes.push_back(Shape({batch, channels, out_h, out_w}));
+        Pool2DParams params;
+        Status status = ParsePool2DParams(*this, inputs[0]->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape({params.batch, params.channels, params.out_h, params.out_w}));
         return Status::Ok();
     }
     
@@ -53,92 +214,68 @@ public:
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        const Shape& input_shape = input->GetShape();
-        const Shape& output_shape = output->GetShape();
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t channels = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        int64_t out_h = output_shape.dims[2];
-        int64_t out_w = output_shape.dims[3];
-        
-        // 默认参数
-        int64_t kernel_h = 2, kernel_w = 2;
-        int64_t stride_h = 2, stride_w = 2;
-        int64_t pad_h = 0, pad_w = 0;
-        
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
-        for (int64_t n = 0; n < batch; ++n) {
-            for (int64_t c = 0; c < channels; ++c) {
-                for (int64_t oh = 0; oh < out_h; ++oh) {
-                    for (int64_t ow = 0; ow < out_w; ++ow) {
-                        float max_val = -std::numeric_limits<float>::max();
-                        
-                        for (int64_t kh = 0; kh < kernel_h; ++kh) {
-                            for (int64_t kw = 0; kw < kernel_w; ++kw) {
-                                int64_t ih = oh * stride_h + kh - pad_h;
-                                int64_t iw = ow * stride_w + kw - pad_w;
-                                
-                                if (ih >= 0 && ih < in_h && iw >= 0 && iw < in_w) {
-                                    int64_t idx = ((n * channels + c) * in_h + ih) * in_w + iw;
-                                    max_val = std::max(max_val, input_data[idx]);
-                                }
-                            }
-                        }
-                        
-                        int64_t out_idx = ((n * channels + c) * out_h + oh) * out_w + ow;
-                        output_data[out_idx] = max_val;
-                    }
-                }
-            }
+    
+        Pool2DParams p;
+        Status status = ParsePool2DParams(*this, inputs[0]->GetShape(), &p);
+        if (!status.IsOk()) {
+            return status;
         }
-        
+        Pool2DNchw(p, max_pool_, static_cast<const float*>(inputs[0]->GetData()),
+                   static_cast<float*>(outputs[0]->GetData()), ctx);
         return Status::Ok();
     }
+
+private:
+    bool max_pool_;
 };
 
-REGISTER_OPERATOR("MaxPool", MaxPoolOperator);
+// MaxPool算子
+class MaxPoolOperator : public Pool2DOperator {
+public:
+    MaxPoolOperator() : Pool2DOperator(true) {}
+};
 
 // AveragePool算子
-class AveragePoolOperator : public Operator {
+class AveragePoolOperator : public Pool2DOperator {
 public:
-    std::string GetName() const override { return "AveragePool"; }
+    AveragePoolOperator() : Pool2DOperator(false) {}
+};
+
+// AvgPool：AveragePool的别名（部分导出工具使用）
+class AvgPoolOperator : public AveragePoolOperator {};
+
+REGISTER_OPERATOR("MaxPool", MaxPoolOperator);
+REGISTER_OPERATOR("AveragePool", AveragePoolOperator);
+REGISTER_OPERATOR("AvgPool", AvgPoolOperator);
+
+// GlobalMaxPool/GlobalAveragePool算子：[N, C, spatial...] -> [N, C, 1, ...]，
+// 每个N×C平面连续存放，按平面并行、平面内SIMD归约
+class GlobalPoolOperator : public Operator {
+public:
+    explicit GlobalPoolOperator(bool max_pool) : max_pool_(max_pool) {}
+    
+    std::string GetName() const override { return max_pool_ ? "GlobalMaxPool" : "GlobalAveragePool"; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
         }
-        if (inputs[0]->GetShape().dims.size() < 4) {
+        if (inputs[0]->GetShape().dims.size() < 3) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "AveragePool input must be 4D (NCHW)");
+                               GetName() + " input must be at least 3D (N, C, spatial...)");
         }
         return Status::Ok();
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        const Shape& input_shape = inputs[0]->GetShape();
-        
-        int64_t kernel_h = 2, kernel_w = 2;
-        int64_t stride_h = 2, stride_w = 2;
-        int64_t pad_h = 0, pad_w = 0;
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t channels = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        
-        int64_t out_h = (in_h + 2 * pad_h - kernel_h) / stride_h + 1;
-        int64_t out_w = (in_w + 2 * pad_w - kernel_w) / stride_w + 1;
-        
-        output_shapes.push_back(Shape({batch, channels, out_h, out_w}));
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        std::fill(dims.begin() + 2, dims.end(), 1);
+        output_shapes.push_back(Shape(dims));
         return Status::Ok();
     }
     
@@ -148,60 +285,47 @@ public:
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input = inputs[0];
-        Tensor* output = outputs[0];
-        
-        const Shape& input_shape = input->GetShape();
-        const Shape& output_shape = output->GetShape();
-        
-        int64_t batch = input_shape.dims[0];
-        int64_t channels = input_shape.dims[1];
-        int64_t in_h = input_shape.dims[2];
-        int64_t in_w = input_shape.dims[3];
-        int64_t out_h = output_shape.dims[2];
-        int64_t out_w = output_shape.dims[3];
-        
-        int64_t kernel_h = 2, kernel_w = 2;
-        int64_t stride_h = 2, stride_w = 2;
-        int64_t pad_h = 0, pad_w = 0;
-        
-        const float* input_data = static_cast<const float*>(input->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
-        for (int64_t n = 0; n < batch; ++n) {
-            for (int64_t c = 0; c < channels; ++c) {
-                for (int64_t oh = 0; oh < out_h; ++oh) {
-                    for (int64_t ow = 0; ow < out_w; ++ow) {
-                        float sum = 0.0f;
-                        int count = 0;
-                        
-                        for (int64_t kh = 0; kh < kernel_h; ++kh) {
-                            for (int64_t kw = 0; kw < kernel_w; ++kw) {
-                                int64_t ih = oh * stride_h + kh - pad_h;
-                                int64_t iw = ow * stride_w + kw - pad_w;
-                                
-                                if (ih >= 0 && ih < in_h && iw >= 0 && iw < in_w) {
-                                    int64_t idx = ((n * channels + c) * in_h + ih) * in_w + iw;
-                                    sum += input_data[idx];
-                                    count++;
-                                }
-                            }
-                        }
-                        
-                        int64_t out_idx = ((n * channels + c) * out_h + oh) * out_w + ow;
-                        output_data[out_idx] = count > 0 ? sum / count : 0.0f;
-                    }
-                }
-            }
+        const Shape& shape = inputs[0]->GetShape();
+        const int64_t planes = shape.dims[0] * shape.dims[1];
+        if (planes <= 0) {
+            return Status::Ok();
         }
-        
+        const int64_t spatial = static_cast<int64_t>(inputs[0]->GetElementCount()) / planes;
+        const float* input_data = static_cast<const float*>(inputs[0]->GetData());
+        float* output_data = static_cast<float*>(outputs[0]->GetData());
+        const size_t count = static_cast<size_t>(spatial);
+        const float scale = spatial > 0 ? 1.0f / static_cast<float>(spatial) : 0.0f;
+    
+        ParallelForOuter(ctx, planes, spatial, [&](int64_t begin, int64_t end) {
+            for (int64_t nc = begin; nc < end; ++nc) {
+                const float* plane = input_data + nc * spatial;
+                output_data[nc] = max_pool_ ? simd::ReduceMaxSIMD(plane, count)
+                                            : simd::ReduceSumSIMD(plane, count) * scale;
+            }
+        });
         return Status::Ok();
     }
+
+private:
+    bool max_pool_;
 };
 
-REGISTER_OPERATOR("AveragePool", AveragePoolOperator);
+class GlobalMaxPoolOperator : public GlobalPoolOperator {
+public:
+    GlobalMaxPoolOperator() : GlobalPoolOperator(true) {}
+};
+
+class GlobalAveragePoolOperator : public GlobalPoolOperator {
+public:
+    GlobalAveragePoolOperator() : GlobalPoolOperator(false) {}
+};
+
+// GlobalAvgPool：GlobalAveragePool的别名
+class GlobalAvgPoolOperator : public GlobalAveragePoolOperator {};
+
+REGISTER_OPERATOR("GlobalMaxPool", GlobalMaxPoolOperator);
+REGISTER_OPERATOR("GlobalAveragePool", GlobalAveragePoolOperator);
+REGISTER_OPERATOR("GlobalAvgPool", GlobalAvgPoolOperator);
 
 } // namespace operators
 } // namespace inferunity
-
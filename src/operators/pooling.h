@@ -0,0 +1,32 @@
+// 二维池化参数
+// 与Conv2DParams对应：按kernel_shape/strides/pads/ceil_mode属性解析窗口，NCHW与NCHWc池化共用
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include <cstdint>
+
+namespace inferunity {
+namespace operators {
+
+struct Pool2DParams {
+    int64_t batch = 0, channels = 0;
+    int64_t in_h = 0, in_w = 0;
+    int64_t out_h = 0, out_w = 0;
+    int64_t kernel_h = 2, kernel_w = 2;
+    int64_t stride_h = 2, stride_w = 2;
+    int64_t pad_top = 0, pad_left = 0, pad_bottom = 0, pad_right = 0;
+    bool count_include_pad = false;   // AveragePool：padding位置是否计入除数
+};
+
+// shape为逻辑NCHW形状。未给kernel_shape时沿用2x2、步长2的窗口；给出kernel_shape时strides按ONNX默认为1
+Status ParsePool2DParams(const Operator& op, const Shape& shape, Pool2DParams* params);
+
+// NCHW池化：p.batch * p.channels个[in_h, in_w]平面，ctx非空时按平面并行。
+// 窗口只在[0, in_h)内取值，输入为整图的一段行时由pad_top/pad_bottom表示越过整图边界的部分
+void Pool2DNchw(const Pool2DParams& p, bool max_pool, const float* input, float* output,
+                ExecutionContext* ctx);
+
+} // namespace operators
+} // namespace inferunity
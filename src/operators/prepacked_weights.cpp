@@ -0,0 +1,84 @@
+// 预打包权重缓存实现
+
+#include "prepacked_weights.h"
+#include <cstdio>
+
+namespace inferunity {
+namespace operators {
+
+PrepackedWeightCache& PrepackedWeightCache::Instance() {
+    static PrepackedWeightCache instance;
+    return instance;
+}
+
+std::string PrepackedWeightCache::MakeKey(const std::string& format,
+                                          const std::vector<int64_t>& dims,
+                                          const float* data, size_t count) {
+    return MakeKey(format, dims, static_cast<const void*>(data), count * sizeof(float));
+}
+
+std::string PrepackedWeightCache::MakeKey(const std::string& format,
+                                          const std::vector<int64_t>& dims,
+                                          const void* data, size_t size) {
+    // 两路独立的64位FNV-1a哈希（不同的初始值），连同字节数一起区分权重内容
+    uint64_t h1 = 14695981039346656037ull;
+    uint64_t h2 = 1099511628211ull * 31ull;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h1 = (h1 ^ bytes[i]) * 1099511628211ull;
+        h2 = (h2 ^ bytes[i]) * 1099511628211ull + 0x9e3779b97f4a7c15ull;
+    }
+    
+    std::string key = format;
+    for (int64_t d : dims) {
+        key += ':';
+        key += std::to_string(d);
+    }
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "#%zu#%016llx%016llx", size,
+                  static_cast<unsigned long long>(h1), static_cast<unsigned long long>(h2));
+    key += buffer;
+    return key;
+}
+
+void PrepackedWeightCache::PruneExpiredLocked() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.expired()) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PrepackedWeightCache::FinishBuild(const std::string& key, const std::shared_ptr<PendingBuild>& pending,
+                                       std::shared_ptr<const void> result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (result) {
+        PruneExpiredLocked();
+        entries_[key] = result;
+    }
+    pending->result = std::move(result);
+    pending->done = true;
+    building_.erase(key);
+    build_done_.notify_all();
+}
+
+size_t PrepackedWeightCache::GetLiveEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t live = 0;
+    for (const auto& entry : entries_) {
+        if (!entry.second.expired()) {
+            live++;
+        }
+    }
+    return live;
+}
+
+size_t PrepackedWeightCache::GetHitCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,99 @@
+// 预打包权重缓存
+// 参考ONNX Runtime的PrepackedWeightsContainer：会话加载时把常量权重变换为内核专用布局，
+// 以"打包格式 + 形状参数 + 权重内容哈希"为键在进程内共享，
+// 加载同一模型文件的多个会话（各自持有一份原始权重）复用同一份打包结果
+
+#pragma once
+
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+class PrepackedWeightCache {
+public:
+    static PrepackedWeightCache& Instance();
+    
+    // 生成缓存键；format描述打包格式（含微内核等影响布局的因素），dims为形状参数
+    static std::string MakeKey(const std::string& format, const std::vector<int64_t>& dims,
+                               const float* data, size_t count);
+    // 任意类型的常量数据（量化权重等），bytes为字节数
+    static std::string MakeKey(const std::string& format, const std::vector<int64_t>& dims,
+                               const void* data, size_t bytes);
+    
+    // 命中时返回已有结果，否则调用build并登记。条目只以weak_ptr保存，
+    // 最后一个持有者（算子实例）释放后打包数据随之释放。build在锁外执行，不同权重可以在多个线程上
+    // 同时打包；同一个键正在由其他线程构建时等待其结果，并发加载同一模型时只打包一次
+    template <typename T>
+    std::shared_ptr<const T> GetOrCreate(const std::string& key,
+                                         const std::function<std::shared_ptr<const T>()>& build) {
+        std::shared_ptr<PendingBuild> pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                if (auto existing = it->second.lock()) {
+                    hits_++;
+                    return std::static_pointer_cast<const T>(existing);
+                }
+            }
+            auto building = building_.find(key);
+            if (building != building_.end()) {
+                std::shared_ptr<PendingBuild> other = building->second;
+                build_done_.wait(lock, [&other] { return other->done; });
+                if (other->result) {
+                    hits_++;
+                }
+                return std::static_pointer_cast<const T>(other->result);
+            }
+            pending = std::make_shared<PendingBuild>();
+            building_[key] = pending;
+        }
+        // build失败（返回nullptr或抛出异常）时也要唤醒等待同一个键的线程
+        struct Publish {
+            PrepackedWeightCache* cache;
+            const std::string& key;
+            const std::shared_ptr<PendingBuild>& pending;
+            std::shared_ptr<const void> result;
+            ~Publish() { cache->FinishBuild(key, pending, std::move(result)); }
+        } publish{this, key, pending, nullptr};
+        std::shared_ptr<const T> created = build();
+        publish.result = created;
+        return created;
+    }
+    
+    // 仍被持有的条目数
+    size_t GetLiveEntryCount() const;
+    // 命中次数（统计/测试用）
+    size_t GetHitCount() const;
+
+private:
+    // 正在构建的条目
+    struct PendingBuild {
+        bool done = false;
+        std::shared_ptr<const void> result;
+    };
+    
+    PrepackedWeightCache() = default;
+    void PruneExpiredLocked();
+    // 登记构建结果（非空时）并唤醒等待的线程
+    void FinishBuild(const std::string& key, const std::shared_ptr<PendingBuild>& pending,
+                     std::shared_ptr<const void> result);
+    
+    mutable std::mutex mutex_;
+    std::condition_variable build_done_;
+    std::unordered_map<std::string, std::weak_ptr<const void>> entries_;
+    std::unordered_map<std::string, std::shared_ptr<PendingBuild>> building_;
+    size_t hits_ = 0;
+};
+
+} // namespace operators
+} // namespace inferunity
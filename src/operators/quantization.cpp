@@ -0,0 +1,435 @@
+// 量化算子实现
+// 参考ONNX的QuantizeLinear/DequantizeLinear/QLinearConv/QLinearMatMul定义与ONNX Runtime的CPU实现；
+// 量化图由QuantizeGraph插入Q/DQ、QDQFusionPass折叠而来（见inferunity/quantization.h）
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "conv_kernels.h"
+#include "quantization_kernels.h"
+#include "matmul_nbits_kernels.h"
+#include <cmath>
+#include <limits>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// 单个元素的scale
+bool ScalarScale(const Tensor* tensor, float* scale) {
+    if (!tensor || tensor->GetDataType() != DataType::FLOAT32 || tensor->GetElementCount() != 1 ||
+        !tensor->GetData()) {
+        return false;
+    }
+    *scale = static_cast<const float*>(tensor->GetData())[0];
+    return true;
+}
+
+// 零点的类型决定量化数据的类型，缺省为UINT8（与ONNX一致）
+DataType ZeroPointType(const std::vector<Tensor*>& inputs, size_t index) {
+    return inputs.size() > index && inputs[index] ? inputs[index]->GetDataType() : DataType::UINT8;
+}
+
+Status ScaleError(const std::string& op) {
+    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, op + " requires scalar FLOAT32 scales");
+}
+
+// 折叠进来的激活：activation="Relu"截断到零点，"Clip"把clip_min/clip_max（浮点值）按输出的
+// scale/零点换算到量化域；须在output_scale与output_zero_point确定后调用
+Status ParseActivation(const Operator& op, Requantization* requant) {
+    const std::string activation = op.GetStringAttribute("activation", "");
+    if (activation.empty()) {
+        return Status::Ok();
+    }
+    if (activation == "Relu") {
+        requant->relu = true;
+        return Status::Ok();
+    }
+    if (activation == "Clip") {
+        const float lower = op.GetFloatAttribute("clip_min", -std::numeric_limits<float>::infinity());
+        const float upper = op.GetFloatAttribute("clip_max", std::numeric_limits<float>::infinity());
+        // 超出int32的界限在与输出类型范围取交集时自然失效
+        const auto to_quantized = [&](float value, int32_t unbounded) {
+            const float q = std::nearbyint(value / requant->output_scale) + requant->output_zero_point;
+            return std::isfinite(q) && std::fabs(q) < 1e9f ? static_cast<int32_t>(q) : unbounded;
+        };
+        requant->clip_min = to_quantized(lower, lower < 0 ? std::numeric_limits<int32_t>::min() :
+                                                            std::numeric_limits<int32_t>::max());
+        requant->clip_max = to_quantized(upper, upper < 0 ? std::numeric_limits<int32_t>::min() :
+                                                            std::numeric_limits<int32_t>::max());
+        return Status::Ok();
+    }
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                         op.GetName() + " does not support activation " + activation);
+}
+
+} // anonymous namespace
+
+// QuantizeLinear: y = saturate(round(x / y_scale) + y_zero_point)
+class QuantizeLinearOperator : public Operator {
+public:
+    std::string GetName() const override { return "QuantizeLinear"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "QuantizeLinear requires at least 2 inputs (x and y_scale)");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs, size_t output_index) const override {
+        (void)output_index;
+        return ZeroPointType(inputs, 2);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        if (inputs[0]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "QuantizeLinear input must be FLOAT32");
+        }
+        QuantizeAxis axis;
+        Status status = ResolveQuantizeAxis(inputs[0]->GetShape(), GetIntAttribute("axis", 1),
+                                            static_cast<int64_t>(inputs[1]->GetElementCount()), &axis);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return QuantizeLinearRun(static_cast<const float*>(inputs[0]->GetData()), axis,
+                                 static_cast<const float*>(inputs[1]->GetData()),
+                                 inputs.size() > 2 ? inputs[2] : nullptr, outputs[0]->GetDataType(),
+                                 outputs[0]->GetData(), ctx);
+    }
+};
+
+// DequantizeLinear: y = (x - x_zero_point) * x_scale
+class DequantizeLinearOperator : public Operator {
+public:
+    std::string GetName() const override { return "DequantizeLinear"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "DequantizeLinear requires at least 2 inputs (x and x_scale)");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs, size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::FLOAT32;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        QuantizeAxis axis;
+        Status status = ResolveQuantizeAxis(inputs[0]->GetShape(), GetIntAttribute("axis", 1),
+                                            static_cast<int64_t>(inputs[1]->GetElementCount()), &axis);
+        if (!status.IsOk()) {
+            return status;
+        }
+        return DequantizeLinearRun(inputs[0]->GetData(), inputs[0]->GetDataType(), axis,
+                                   static_cast<const float*>(inputs[1]->GetData()),
+                                   inputs.size() > 2 ? inputs[2] : nullptr,
+                                   static_cast<float*>(outputs[0]->GetData()), ctx);
+    }
+};
+
+// QLinearConv: x, x_scale, x_zero_point, w, w_scale, w_zero_point, y_scale, y_zero_point[, B(INT32)]
+// 卷积属性与Conv相同；activation="Relu"（QDQFusionPass吸收Conv后的Relu时设置）在量化域截断到零点，
+// activation="Clip"按clip_min/clip_max截断
+class QLinearConvOperator : public Operator {
+public:
+    std::string GetName() const override { return "QLinearConv"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 8) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "QLinearConv requires at least 8 inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "QLinearConv requires at least 8 inputs");
+        }
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, inputs[0]->GetShape(), inputs[3]->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape({params.batch, params.out_c, params.out_h, params.out_w}));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 乘加之后逐元素加bias并重新量化
+        return EstimateConvCost(inputs, outputs, 3, inputs.size() > 8 ? 3.0 : 2.0);
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs, size_t output_index) const override {
+        (void)output_index;
+        return ZeroPointType(inputs, 7);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 8 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Conv2DParams params;
+        Status status = ParseConv2DParams(*this, inputs[0]->GetShape(), inputs[3]->GetShape(), &params);
+        if (!status.IsOk()) {
+            return status;
+        }
+        Requantization requant;
+        if (!ScalarScale(inputs[1], &requant.input_scale) || !ScalarScale(inputs[6], &requant.output_scale)) {
+            return ScaleError("QLinearConv");
+        }
+        const int64_t scale_count = static_cast<int64_t>(inputs[4]->GetElementCount());
+        if (scale_count != 1 && scale_count != params.out_c) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "QLinearConv w_scale must be scalar or per output channel");
+        }
+        const Tensor* bias = inputs.size() > 8 ? inputs[8] : nullptr;
+        if (bias && (bias->GetDataType() != DataType::INT32 ||
+                     static_cast<int64_t>(bias->GetElementCount()) != params.out_c)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "QLinearConv bias must be INT32 with one value per output channel");
+        }
+        requant.weight_scale = static_cast<const float*>(inputs[4]->GetData());
+        requant.weight_scale_count = scale_count;
+        requant.bias = bias ? static_cast<const int32_t*>(bias->GetData()) : nullptr;
+        requant.output_zero_point = ZeroPointAt(inputs[7], 0);
+        requant.output_dtype = outputs[0]->GetDataType();
+        status = ParseActivation(*this, &requant);
+        if (!status.IsOk()) {
+            return status;
+        }
+        
+        if (!kernel_.IsPreparedFor(params, inputs[3]->GetData())) {
+            status = kernel_.Prepare(params, *inputs[3], inputs[5]);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return kernel_.Run(params, inputs[0]->GetData(), inputs[0]->GetDataType(), ZeroPointAt(inputs[2], 0),
+                           requant, outputs[0]->GetData(), ctx);
+    }
+
+private:
+    QLinearConvKernel kernel_;
+};
+
+// QLinearMatMul: a, a_scale, a_zero_point, b, b_scale, b_zero_point, y_scale, y_zero_point
+// B为二维矩阵，b_scale/b_zero_point为单个值或按列；activation同QLinearConv
+class QLinearMatMulOperator : public Operator {
+public:
+    std::string GetName() const override { return "QLinearMatMul"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 8) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "QLinearMatMul requires 8 inputs");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "QLinearMatMul requires 8 inputs");
+        }
+        const Shape& a = inputs[0]->GetShape();
+        const Shape& b = inputs[3]->GetShape();
+        if (a.dims.empty() || b.dims.size() != 2 || a.dims.back() != b.dims[0]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "QLinearMatMul requires A[..., K] and a 2D B[K, N]");
+        }
+        Shape output = a;
+        output.dims.back() = b.dims[1];
+        output_shapes.push_back(output);
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        const int64_t k = inputs.empty() || inputs[0].shape.dims.empty() ? 1 : inputs[0].shape.dims.back();
+        return EstimateMatMulCost(inputs, outputs, k, 2.0);
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs, size_t output_index) const override {
+        (void)output_index;
+        return ZeroPointType(inputs, 7);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 8 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::vector<Shape> shapes;
+        Status status = InferOutputShape(inputs, shapes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t k = inputs[3]->GetShape().dims[0];
+        const int64_t n = inputs[3]->GetShape().dims[1];
+        Requantization requant;
+        if (!ScalarScale(inputs[1], &requant.input_scale) || !ScalarScale(inputs[6], &requant.output_scale)) {
+            return ScaleError("QLinearMatMul");
+        }
+        const int64_t scale_count = static_cast<int64_t>(inputs[4]->GetElementCount());
+        if (scale_count != 1 && scale_count != n) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "QLinearMatMul b_scale must be scalar or per column");
+        }
+        requant.weight_scale = static_cast<const float*>(inputs[4]->GetData());
+        requant.weight_scale_count = scale_count;
+        requant.output_zero_point = ZeroPointAt(inputs[7], 0);
+        requant.output_dtype = outputs[0]->GetDataType();
+        status = ParseActivation(*this, &requant);
+        if (!status.IsOk()) {
+            return status;
+        }
+        
+        if (!kernel_.IsPreparedFor(inputs[3]->GetData(), k, n)) {
+            status = kernel_.Prepare(*inputs[3], inputs[5]);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        const int64_t rows = static_cast<int64_t>(inputs[0]->GetElementCount()) / k;
+        return kernel_.Run(inputs[0]->GetData(), inputs[0]->GetDataType(), ZeroPointAt(inputs[2], 0), rows,
+                           requant, outputs[0]->GetData(), ctx);
+    }
+
+private:
+    QLinearMatMulKernel kernel_;
+};
+
+// MatMulNBits（ONNX Runtime的com.microsoft contrib算子）：Y = A * dequantize(B)，
+// A为FLOAT32的[..., K]，B/scales/zero_points见matmul_nbits_kernels.h，可选的bias为[N]。
+// 输入依次为A、B、scales、zero_points、g_idx、bias；省略中间的可选输入时按input_slots属性定位。
+// 不支持g_idx（GPTQ的act-order重排），需要时应在导出时把重排折叠进B
+class MatMulNBitsOperator : public Operator {
+public:
+    std::string GetName() const override { return "MatMulNBits"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (!InputAt(inputs, 0) || !InputAt(inputs, 1) || !InputAt(inputs, 2)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits requires A, B and scales");
+        }
+        if (InputAt(inputs, 0)->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits only supports FLOAT32 A");
+        }
+        if (InputAt(inputs, 4)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "MatMulNBits g_idx is not supported");
+        }
+        const Tensor* bias = InputAt(inputs, 5);
+        if (bias && (bias->GetDataType() != DataType::FLOAT32 ||
+                     static_cast<int64_t>(bias->GetElementCount()) != GetIntAttribute("N", 0))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits bias must be FLOAT32 [N]");
+        }
+        MatMulNBitsWeight weight;
+        return ResolveWeight(inputs, &weight);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        const Tensor* a = InputAt(inputs, 0);
+        if (!a || a->GetShape().dims.empty() || a->GetShape().dims.back() != GetIntAttribute("K", 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits requires A[..., K]");
+        }
+        Shape output = a->GetShape();
+        output.dims.back() = GetIntAttribute("N", 0);
+        output_shapes.push_back(output);
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        return EstimateMatMulCost(inputs, outputs, GetIntAttribute("K", 1), 0.0);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        MatMulNBitsWeight weight;
+        Status status = ResolveWeight(inputs, &weight);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Tensor* a = InputAt(inputs, 0);
+        const Tensor* bias = InputAt(inputs, 5);
+        const int64_t rows = static_cast<int64_t>(a->GetElementCount()) / weight.K;
+        if (static_cast<int64_t>(outputs[0]->GetElementCount()) != rows * weight.N) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "MatMulNBits output shape mismatch");
+        }
+        return MatMulNBitsRun(weight, static_cast<const float*>(a->GetData()), rows,
+                              bias ? static_cast<const float*>(bias->GetData()) : nullptr,
+                              static_cast<float*>(outputs[0]->GetData()), ctx);
+    }
+
+private:
+    // 第slot个ONNX输入，省略时为nullptr
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        const std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        if (slots.empty()) {
+            return slot < static_cast<int64_t>(inputs.size()) ? inputs[slot] : nullptr;
+        }
+        for (size_t i = 0; i < slots.size() && i < inputs.size(); ++i) {
+            if (slots[i] == slot) {
+                return inputs[i];
+            }
+        }
+        return nullptr;
+    }
+    
+    Status ResolveWeight(const std::vector<Tensor*>& inputs, MatMulNBitsWeight* weight) const {
+        return ResolveMatMulNBitsWeight(GetIntAttribute("K", 0), GetIntAttribute("N", 0),
+                                        GetIntAttribute("bits", 4), GetIntAttribute("block_size", 32),
+                                        *InputAt(inputs, 1), *InputAt(inputs, 2), InputAt(inputs, 3), weight);
+    }
+};
+
+REGISTER_OPERATOR("QuantizeLinear", QuantizeLinearOperator);
+REGISTER_OPERATOR("DequantizeLinear", DequantizeLinearOperator);
+REGISTER_OPERATOR("QLinearConv", QLinearConvOperator);
+REGISTER_OPERATOR("QLinearMatMul", QLinearMatMulOperator);
+REGISTER_OPERATOR("MatMulNBits", MatMulNBitsOperator);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,530 @@
+// 量化计算内核实现
+// 参考ONNX Runtime的QLinearConv（im2col + MLAS QGEMM + 逐通道重新量化）与MLAS QGEMM U8S8的零点修正
+
+#include "quantization_kernels.h"
+#include "parallel_utils.h"
+#include "prepacked_weights.h"
+#include "simd_utils.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+struct QuantRange {
+    int32_t min;
+    int32_t max;
+};
+
+bool GetQuantRange(DataType dtype, QuantRange* range) {
+    switch (dtype) {
+        case DataType::INT8: *range = {-128, 127}; return true;
+        case DataType::UINT8: *range = {0, 255}; return true;
+        default: return false;
+    }
+}
+
+// 量化数据的第i个元素
+inline int32_t LoadQuantized(const void* data, DataType dtype, int64_t i) {
+    switch (dtype) {
+        case DataType::INT8: return static_cast<const int8_t*>(data)[i];
+        case DataType::UINT8: return static_cast<const uint8_t*>(data)[i];
+        default: return static_cast<const int32_t*>(data)[i];
+    }
+}
+
+inline void StoreQuantized(void* data, DataType dtype, int64_t i, int32_t value) {
+    if (dtype == DataType::INT8) {
+        static_cast<int8_t*>(data)[i] = static_cast<int8_t>(value);
+    } else {
+        static_cast<uint8_t*>(data)[i] = static_cast<uint8_t>(value);
+    }
+}
+
+// 两个int16拼成QGEMM的一对权重（低16位为偶数k）
+inline int32_t PackPair(int32_t even, int32_t odd) {
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(even)) |
+                                (static_cast<uint32_t>(static_cast<uint16_t>(odd)) << 16));
+}
+
+// 四个s8拼成u8s8 QGEMM的一组权重（最低字节为k % 4 == 0）
+inline int32_t PackQuad(const int32_t* w) {
+    uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i) {
+        packed |= static_cast<uint32_t>(static_cast<uint8_t>(static_cast<int8_t>(w[i]))) << (8 * i);
+    }
+    return static_cast<int32_t>(packed);
+}
+
+// 输出的饱和下界与上界；relu时下界抬到零点，再与clip区间取交集
+QuantRange OutputRange(const Requantization& requant) {
+    QuantRange range{0, 255};
+    GetQuantRange(requant.output_dtype, &range);
+    if (requant.relu) {
+        range.min = std::max(range.min, requant.output_zero_point);
+    }
+    range.min = std::max(range.min, requant.clip_min);
+    range.max = std::min(range.max, requant.clip_max);
+    return range;
+}
+
+inline int32_t RequantizeValue(int32_t acc, float multiplier, float zero_point, const QuantRange& range) {
+    const float scaled = std::nearbyint(static_cast<float>(acc) * multiplier) + zero_point;
+    return static_cast<int32_t>(std::min(std::max(scaled, static_cast<float>(range.min)),
+                                         static_cast<float>(range.max)));
+}
+
+inline float RequantMultiplier(const Requantization& requant, int64_t channel) {
+    const float weight_scale = requant.weight_scale[requant.weight_scale_count == 1 ? 0 : channel];
+    return requant.input_scale * weight_scale / requant.output_scale;
+}
+
+// 同一输出通道channel的count个累加值（Conv的一个输出平面）
+void RequantizeChannel(const int32_t* acc, int64_t count, const Requantization& requant, int64_t channel,
+                       void* output, int64_t output_offset) {
+    const QuantRange range = OutputRange(requant);
+    const float multiplier = RequantMultiplier(requant, channel);
+    const int32_t bias = requant.bias ? requant.bias[channel] : 0;
+    const float zero_point = static_cast<float>(requant.output_zero_point);
+    for (int64_t i = 0; i < count; ++i) {
+        StoreQuantized(output, requant.output_dtype, output_offset + i,
+                       RequantizeValue(acc[i] + bias, multiplier, zero_point, range));
+    }
+}
+
+// 权重行优先的打包：weight(r, kk)返回第r行第kk个k减去零点后的值。
+// 所有值都能表示为s8、并且当前SIMD核精确或相邻两个值满足|w0| + |w1| <= 128时选用U8S8
+template <typename Weight>
+std::shared_ptr<const QuantizedPackedWeight> PackQuantizedWeight(int64_t rows, int64_t k, const Weight& weight) {
+    auto packed = std::make_shared<QuantizedPackedWeight>();
+    packed->rows = rows;
+    packed->k = k;
+    const bool exact = simd::QGemmU8S8IsExact();
+    bool u8s8 = true;
+    for (int64_t r = 0; r < rows && u8s8; ++r) {
+        for (int64_t kk = 0; kk < k && u8s8; ++kk) {
+            const int32_t w = weight(r, kk);
+            u8s8 = w >= -128 && w <= 127;
+            if (u8s8 && !exact && (kk & 1) && std::abs(weight(r, kk - 1)) + std::abs(w) > 128) {
+                u8s8 = false;
+            }
+        }
+    }
+    if (u8s8) {
+        packed->format = QGemmFormat::U8S8;
+        packed->k_groups = (k + 3) / 4;
+        packed->data.assign(rows * packed->k_groups, 0);
+        packed->row_sums.assign(rows, 0);
+        for (int64_t r = 0; r < rows; ++r) {
+            for (int64_t g = 0; g < packed->k_groups; ++g) {
+                int32_t quad[4] = {0, 0, 0, 0};
+                for (int64_t i = 0; i < 4 && g * 4 + i < k; ++i) {
+                    quad[i] = weight(r, g * 4 + i);
+                    packed->row_sums[r] += quad[i];
+                }
+                packed->data[r * packed->k_groups + g] = PackQuad(quad);
+            }
+        }
+    } else {
+        packed->format = QGemmFormat::S16;
+        packed->k_groups = (k + 1) / 2;
+        packed->data.assign(rows * packed->k_groups, 0);
+        for (int64_t r = 0; r < rows; ++r) {
+            for (int64_t g = 0; g < packed->k_groups; ++g) {
+                const int32_t even = weight(r, g * 2);
+                const int32_t odd = g * 2 + 1 < k ? weight(r, g * 2 + 1) : 0;
+                packed->data[r * packed->k_groups + g] = PackPair(even, odd);
+            }
+        }
+    }
+    return packed;
+}
+
+// 缓存键：权重与零点的内容、形状与格式选择的依据（SIMD核是否精确）
+std::string QuantizedWeightKey(const std::string& format, const std::vector<int64_t>& dims,
+                               const Tensor& weight, const Tensor* zero_point) {
+    const size_t element_size = weight.GetDataType() == DataType::INT8 ? sizeof(int8_t) : sizeof(uint8_t);
+    const size_t weight_bytes = weight.GetElementCount() * element_size;
+    std::vector<unsigned char> content(static_cast<const unsigned char*>(weight.GetData()),
+                                       static_cast<const unsigned char*>(weight.GetData()) + weight_bytes);
+    const int64_t zp_count = zero_point ? static_cast<int64_t>(zero_point->GetElementCount()) : 0;
+    for (int64_t i = 0; i < zp_count; ++i) {
+        const int32_t zp = ZeroPointAt(zero_point, i);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&zp);
+        content.insert(content.end(), bytes, bytes + sizeof(zp));
+    }
+    const std::string key_format = format + (simd::QGemmU8S8IsExact() ? ":exact" : ":saturating") +
+                                   (weight.GetDataType() == DataType::INT8 ? ":s8" : ":u8");
+    return PrepackedWeightCache::MakeKey(key_format, dims, content.data(), content.size());
+}
+
+// 激活转换为GEMM右操作数的元素：S16为x - zero_point，U8S8为u8（INT8异或0x80，零点相应加128）
+template <typename T>
+struct ActivationConvert {
+    int32_t zero_point;
+    inline int16_t ToS16(T x) const { return static_cast<int16_t>(static_cast<int32_t>(x) - zero_point); }
+    inline uint8_t ToU8(T x) const { return static_cast<uint8_t>(static_cast<int32_t>(x) + U8Offset()); }
+    static constexpr int32_t U8Offset() { return std::is_signed<T>::value ? 128 : 0; }
+};
+
+// im2col：columns[(kg * P + p) * G + k % G] = convert(x[c][ih][iw])，越界处为pad（量化域的0.0），
+// k超出k_total的补位为0（对应的权重也是0）
+template <typename T, typename Packed, int G, typename Convert>
+void Im2colGroups(const T* x, const Conv2DParams& p, int64_t in_c, int64_t k_groups, Packed pad,
+                  const Convert& convert, Packed* columns, ExecutionContext* ctx) {
+    const int64_t spatial = p.out_h * p.out_w;
+    const int64_t kernel_area = p.kernel_h * p.kernel_w;
+    const int64_t k_total = in_c * kernel_area;
+    ParallelForOuter(ctx, k_groups, spatial * G, [&](int64_t begin, int64_t end) {
+        for (int64_t kg = begin; kg < end; ++kg) {
+            Packed* dst = columns + kg * spatial * G;
+            for (int64_t lane = 0; lane < G; ++lane) {
+                const int64_t k = kg * G + lane;
+                if (k >= k_total) {
+                    for (int64_t q = 0; q < spatial; ++q) {
+                        dst[q * G + lane] = 0;
+                    }
+                    continue;
+                }
+                const int64_t c = k / kernel_area;
+                const int64_t kh = (k % kernel_area) / p.kernel_w;
+                const int64_t kw = k % p.kernel_w;
+                const T* plane = x + c * p.in_h * p.in_w;
+                for (int64_t oh = 0; oh < p.out_h; ++oh) {
+                    const int64_t ih = oh * p.stride_h - p.pad_top + kh * p.dilation_h;
+                    Packed* row = dst + oh * p.out_w * G + lane;
+                    if (ih < 0 || ih >= p.in_h) {
+                        for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                            row[ow * G] = pad;
+                        }
+                        continue;
+                    }
+                    for (int64_t ow = 0; ow < p.out_w; ++ow) {
+                        const int64_t iw = ow * p.stride_w - p.pad_left + kw * p.dilation_w;
+                        row[ow * G] = (iw < 0 || iw >= p.in_w) ? pad : convert(plane[ih * p.in_w + iw]);
+                    }
+                }
+            }
+        }
+    });
+}
+
+// A[rows][k]转置为右操作数：columns[(kg * rows + r) * G + k % G]，k的补位为0
+template <typename T, typename Packed, int G, typename Convert>
+void PackColumns(const T* a, int64_t rows, int64_t k, int64_t k_groups, const Convert& convert,
+                 Packed* columns, ExecutionContext* ctx) {
+    ParallelForOuter(ctx, rows, k, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            const T* src = a + r * k;
+            for (int64_t kg = 0; kg < k_groups; ++kg) {
+                Packed* dst = columns + (kg * rows + r) * G;
+                for (int64_t lane = 0; lane < G; ++lane) {
+                    const int64_t kk = kg * G + lane;
+                    dst[lane] = kk < k ? convert(src[kk]) : 0;
+                }
+            }
+        }
+    });
+}
+
+// S16：行块按4对齐切给算子内线程，每块调用一次整数GEMM
+void ParallelQGemmS16(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+                      int64_t m, int64_t n, int64_t k_pairs, ExecutionContext* ctx) {
+    const int64_t blocks = (m + 3) / 4;
+    ParallelForOuter(ctx, blocks, 4 * n * k_pairs, [&](int64_t begin, int64_t end) {
+        const int64_t row_begin = begin * 4;
+        const int64_t row_end = std::min(end * 4, m);
+        simd::QGemmS16SIMD(a_pairs + row_begin * k_pairs, b_pairs, output + row_begin * n,
+                           static_cast<size_t>(row_end - row_begin), static_cast<size_t>(n),
+                           static_cast<size_t>(k_pairs));
+    });
+}
+
+// U8S8：按16行 x 256列的块二维切分（与AMX的16x16块对齐），行数少时（如MatMul的小N）仍能按列并行
+void ParallelQGemmU8S8(const int32_t* a_quads, const uint8_t* b_quads, int32_t* output,
+                       int64_t m, int64_t n, int64_t k_quads, ExecutionContext* ctx) {
+    constexpr int64_t kRowBlock = 16;
+    constexpr int64_t kColBlock = 256;
+    const int64_t row_blocks = (m + kRowBlock - 1) / kRowBlock;
+    const int64_t col_blocks = (n + kColBlock - 1) / kColBlock;
+    ParallelForOuter(ctx, row_blocks * col_blocks, kRowBlock * kColBlock * k_quads,
+                     [&](int64_t begin, int64_t end) {
+        for (int64_t block = begin; block < end; ++block) {
+            const int64_t i = (block / col_blocks) * kRowBlock;
+            const int64_t j = (block % col_blocks) * kColBlock;
+            simd::QGemmU8S8SIMD(a_quads + i * k_quads, b_quads + j * 4, static_cast<size_t>(n),
+                                output + i * n + j, static_cast<size_t>(n),
+                                static_cast<size_t>(std::min(kRowBlock, m - i)),
+                                static_cast<size_t>(std::min(kColBlock, n - j)),
+                                static_cast<size_t>(k_quads));
+        }
+    });
+}
+
+// 右操作数按打包格式准备后执行GEMM；U8S8时把激活零点的贡献从偏置中扣除（bias写入effective_bias）
+template <typename T, typename Im2col>
+void RunQGemm(const QuantizedPackedWeight& packed, int64_t row_begin, int64_t m, int64_t n,
+              int32_t zero_point, const Im2col& pack_columns, const Requantization& requant,
+              int32_t* accum, std::vector<int32_t>* effective_bias, ExecutionContext* ctx) {
+    const int32_t* a = packed.data.data() + row_begin * packed.k_groups;
+    ActivationConvert<T> convert{zero_point};
+    if (packed.format == QGemmFormat::U8S8) {
+        std::vector<uint8_t> columns(packed.k_groups * n * 4);
+        pack_columns(columns.data(), static_cast<uint8_t>(zero_point + convert.U8Offset()),
+                     [&](T x) { return convert.ToU8(x); });
+        ParallelQGemmU8S8(a, columns.data(), accum, m, n, packed.k_groups, ctx);
+        const int32_t u8_zero_point = zero_point + convert.U8Offset();
+        for (int64_t r = 0; r < m; ++r) {
+            const int64_t row = row_begin + r;
+            (*effective_bias)[row] = (requant.bias ? requant.bias[row] : 0) - u8_zero_point * packed.row_sums[row];
+        }
+    } else {
+        std::vector<int16_t> columns(packed.k_groups * n * 2);
+        pack_columns(columns.data(), static_cast<int16_t>(0), [&](T x) { return convert.ToS16(x); });
+        ParallelQGemmS16(a, columns.data(), accum, m, n, packed.k_groups, ctx);
+        for (int64_t r = 0; r < m; ++r) {
+            const int64_t row = row_begin + r;
+            (*effective_bias)[row] = requant.bias ? requant.bias[row] : 0;
+        }
+    }
+}
+
+} // anonymous namespace
+
+Status ResolveQuantizeAxis(const Shape& shape, int64_t axis, int64_t scale_count, QuantizeAxis* result) {
+    *result = QuantizeAxis();
+    const int64_t total = shape.GetElementCount();
+    if (scale_count <= 1) {
+        result->inner = total;
+        return Status::Ok();
+    }
+    const int64_t rank = static_cast<int64_t>(shape.dims.size());
+    if (axis < 0) {
+        axis += rank;
+    }
+    if (axis < 0 || axis >= rank || shape.dims[axis] != scale_count) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Per-axis quantization scale does not match the input dimension");
+    }
+    for (int64_t i = 0; i < axis; ++i) {
+        result->outer *= shape.dims[i];
+    }
+    result->channels = scale_count;
+    for (int64_t i = axis + 1; i < rank; ++i) {
+        result->inner *= shape.dims[i];
+    }
+    return Status::Ok();
+}
+
+int32_t ZeroPointAt(const Tensor* zero_point, int64_t i) {
+    if (!zero_point || !zero_point->GetData()) {
+        return 0;
+    }
+    const int64_t index = zero_point->GetElementCount() == 1 ? 0 : i;
+    return LoadQuantized(zero_point->GetData(), zero_point->GetDataType(), index);
+}
+
+Status QuantizeLinearRun(const float* x, const QuantizeAxis& axis, const float* scale,
+                         const Tensor* zero_point, DataType dtype, void* y, ExecutionContext* ctx) {
+    QuantRange range;
+    if (!GetQuantRange(dtype, &range)) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "QuantizeLinear output must be INT8 or UINT8");
+    }
+    const int64_t planes = axis.outer * axis.channels;
+    ParallelForOuter(ctx, planes, axis.inner, [&](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; ++plane) {
+            const int64_t c = plane % axis.channels;
+            const float inv_scale = 1.0f / scale[c];
+            const float zp = static_cast<float>(ZeroPointAt(zero_point, c));
+            const float* src = x + plane * axis.inner;
+            for (int64_t i = 0; i < axis.inner; ++i) {
+                const float q = std::nearbyint(src[i] * inv_scale) + zp;
+                const int32_t clamped = static_cast<int32_t>(std::min(std::max(q, static_cast<float>(range.min)),
+                                                                      static_cast<float>(range.max)));
+                StoreQuantized(y, dtype, plane * axis.inner + i, clamped);
+            }
+        }
+    });
+    return Status::Ok();
+}
+
+Status DequantizeLinearRun(const void* x, DataType dtype, const QuantizeAxis& axis, const float* scale,
+                           const Tensor* zero_point, float* y, ExecutionContext* ctx) {
+    if (dtype != DataType::INT8 && dtype != DataType::UINT8 && dtype != DataType::INT32) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "DequantizeLinear input must be INT8, UINT8 or INT32");
+    }
+    const int64_t planes = axis.outer * axis.channels;
+    ParallelForOuter(ctx, planes, axis.inner, [&](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; ++plane) {
+            const int64_t c = plane % axis.channels;
+            const float s = scale[c];
+            const int32_t zp = ZeroPointAt(zero_point, c);
+            for (int64_t i = 0; i < axis.inner; ++i) {
+                const int64_t index = plane * axis.inner + i;
+                y[index] = static_cast<float>(LoadQuantized(x, dtype, index) - zp) * s;
+            }
+        }
+    });
+    return Status::Ok();
+}
+
+// ---- QLinearConv ----
+
+bool QLinearConvKernel::IsPreparedFor(const Conv2DParams& params, const void* weight) const {
+    return weight_ == weight && params_ == params && packed_ && isa_ == simd::GetSimdIsaName();
+}
+
+Status QLinearConvKernel::Prepare(const Conv2DParams& params, const Tensor& weight,
+                                  const Tensor* weight_zero_point) {
+    const DataType dtype = weight.GetDataType();
+    if (dtype != DataType::INT8 && dtype != DataType::UINT8) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "QLinearConv weight must be INT8 or UINT8");
+    }
+    const int64_t k = params.in_c / params.group * params.kernel_h * params.kernel_w;
+    const void* data = weight.GetData();
+    const std::string key = QuantizedWeightKey("qlinearconv", {params.out_c, k}, weight, weight_zero_point);
+    packed_ = PrepackedWeightCache::Instance().GetOrCreate<QuantizedPackedWeight>(key, [&]() {
+        return PackQuantizedWeight(params.out_c, k, [&](int64_t oc, int64_t kk) {
+            return LoadQuantized(data, dtype, oc * k + kk) - ZeroPointAt(weight_zero_point, oc);
+        });
+    });
+    params_ = params;
+    weight_ = data;
+    isa_ = simd::GetSimdIsaName();
+    return Status::Ok();
+}
+
+namespace {
+
+template <typename T>
+void RunQLinearConv(const Conv2DParams& params, const QuantizedPackedWeight& packed, const T* input,
+                    int32_t input_zero_point, const Requantization& requant, void* output,
+                    ExecutionContext* ctx) {
+    const int64_t ic_g = params.in_c / params.group;
+    const int64_t oc_g = params.out_c / params.group;
+    const int64_t spatial = params.out_h * params.out_w;
+    const int64_t in_plane = params.in_h * params.in_w;
+    std::vector<int32_t> accum(oc_g * spatial);
+    std::vector<int32_t> bias(params.out_c);
+    Requantization adjusted = requant;
+    adjusted.bias = bias.data();
+    
+    for (int64_t n = 0; n < params.batch; ++n) {
+        for (int64_t g = 0; g < params.group; ++g) {
+            const T* x = input + (n * params.in_c + g * ic_g) * in_plane;
+            auto im2col = [&](auto* columns, auto pad, const auto& convert) {
+                using Packed = typename std::remove_pointer<decltype(columns)>::type;
+                constexpr int kGroup = sizeof(Packed) == 1 ? 4 : 2;
+                Im2colGroups<T, Packed, kGroup>(x, params, ic_g, packed.k_groups, pad, convert, columns, ctx);
+            };
+            RunQGemm<T>(packed, g * oc_g, oc_g, spatial, input_zero_point, im2col, requant,
+                        accum.data(), &bias, ctx);
+            ParallelForOuter(ctx, oc_g, spatial, [&](int64_t begin, int64_t end) {
+                for (int64_t o = begin; o < end; ++o) {
+                    const int64_t oc = g * oc_g + o;
+                    RequantizeChannel(accum.data() + o * spatial, spatial, adjusted, oc, output,
+                                      (n * params.out_c + oc) * spatial);
+                }
+            });
+        }
+    }
+}
+
+} // anonymous namespace
+
+Status QLinearConvKernel::Run(const Conv2DParams& params, const void* input, DataType input_dtype,
+                              int32_t input_zero_point, const Requantization& requant, void* output,
+                              ExecutionContext* ctx) {
+    if (input_dtype == DataType::INT8) {
+        RunQLinearConv(params, *packed_, static_cast<const int8_t*>(input), input_zero_point, requant, output, ctx);
+    } else if (input_dtype == DataType::UINT8) {
+        RunQLinearConv(params, *packed_, static_cast<const uint8_t*>(input), input_zero_point, requant, output, ctx);
+    } else {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "QLinearConv input must be INT8 or UINT8");
+    }
+    return Status::Ok();
+}
+
+// ---- QLinearMatMul ----
+
+bool QLinearMatMulKernel::IsPreparedFor(const void* b, int64_t k, int64_t n) const {
+    return b_ == b && k_ == k && n_ == n && packed_ && isa_ == simd::GetSimdIsaName();
+}
+
+Status QLinearMatMulKernel::Prepare(const Tensor& b, const Tensor* b_zero_point) {
+    const DataType dtype = b.GetDataType();
+    if ((dtype != DataType::INT8 && dtype != DataType::UINT8) || b.GetShape().dims.size() != 2) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "QLinearMatMul B must be a 2D INT8 or UINT8 matrix");
+    }
+    k_ = b.GetShape().dims[0];
+    n_ = b.GetShape().dims[1];
+    const void* data = b.GetData();
+    const int64_t k = k_, n = n_;
+    const std::string key = QuantizedWeightKey("qlinearmatmul", {k, n}, b, b_zero_point);
+    packed_ = PrepackedWeightCache::Instance().GetOrCreate<QuantizedPackedWeight>(key, [&]() {
+        return PackQuantizedWeight(n, k, [&](int64_t j, int64_t kk) {
+            return LoadQuantized(data, dtype, kk * n + j) - ZeroPointAt(b_zero_point, j);
+        });
+    });
+    b_ = data;
+    isa_ = simd::GetSimdIsaName();
+    return Status::Ok();
+}
+
+namespace {
+
+template <typename T>
+void RunQLinearMatMul(const QuantizedPackedWeight& packed, const T* a, int32_t a_zero_point, int64_t rows,
+                      const Requantization& requant, void* output, ExecutionContext* ctx) {
+    const int64_t k = packed.k;
+    const int64_t n = packed.rows;
+    std::vector<int32_t> accum(n * rows);  // Y^T：[N][rows]
+    std::vector<int32_t> bias(n);
+    auto pack = [&](auto* columns, auto pad, const auto& convert) {
+        (void)pad;
+        using Packed = typename std::remove_pointer<decltype(columns)>::type;
+        constexpr int kGroup = sizeof(Packed) == 1 ? 4 : 2;
+        PackColumns<T, Packed, kGroup>(a, rows, k, packed.k_groups, convert, columns, ctx);
+    };
+    RunQGemm<T>(packed, 0, n, rows, a_zero_point, pack, requant, accum.data(), &bias, ctx);
+    // 重新量化按列（B的输出通道）取scale
+    std::vector<float> multipliers(n);
+    for (int64_t j = 0; j < n; ++j) {
+        multipliers[j] = RequantMultiplier(requant, j);
+    }
+    const QuantRange range = OutputRange(requant);
+    const float zero_point = static_cast<float>(requant.output_zero_point);
+    ParallelForOuter(ctx, rows, n, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            for (int64_t j = 0; j < n; ++j) {
+                StoreQuantized(output, requant.output_dtype, r * n + j,
+                               RequantizeValue(accum[j * rows + r] + bias[j], multipliers[j], zero_point, range));
+            }
+        }
+    });
+}
+
+} // anonymous namespace
+
+Status QLinearMatMulKernel::Run(const void* a, DataType a_dtype, int32_t a_zero_point, int64_t rows,
+                                const Requantization& requant, void* output, ExecutionContext* ctx) {
+    if (a_dtype == DataType::INT8) {
+        RunQLinearMatMul(*packed_, static_cast<const int8_t*>(a), a_zero_point, rows, requant, output, ctx);
+    } else if (a_dtype == DataType::UINT8) {
+        RunQLinearMatMul(*packed_, static_cast<const uint8_t*>(a), a_zero_point, rows, requant, output, ctx);
+    } else {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "QLinearMatMul A must be INT8 or UINT8");
+    }
+    return Status::Ok();
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,115 @@
+// 量化计算内核
+// 参考ONNX Runtime的QuantizeLinear/DequantizeLinear、QLinearConv/QLinearMatMul与MLAS的QGEMM：
+// 常量权重减去零点后作为GEMM的左操作数打包，int32累加，最后按x_scale * w_scale / y_scale重新量化到
+// 输出的零点并饱和；INT8与UINT8的激活和权重都支持。两种打包格式：
+// - U8S8：权重减去零点后能表示为s8时使用，激活转为u8（INT8激活异或0x80、零点加128），沿k每4个一组，
+//   由VNNI/AMX/NEON点积完成（见QGemmU8S8SIMD），激活零点通过每行权重和从偏置中扣除；
+//   AVX2/SSE的maddubs会饱和，只在相邻两个权重满足|w0| + |w1| <= 128时使用
+// - S16：其余情况，激活减去零点后扩展为int16，沿k每2个一组（见QGemmS16SIMD）
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include "inferunity/types.h"
+#include "conv_kernels.h"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// 量化参数沿axis变化时张量看作[outer, channels, inner]；按张量量化时channels为1
+struct QuantizeAxis {
+    int64_t outer = 1;
+    int64_t channels = 1;
+    int64_t inner = 1;
+};
+
+// scale为单个值或axis上的元素个数；按shape与axis求出QuantizeAxis
+Status ResolveQuantizeAxis(const Shape& shape, int64_t axis, int64_t scale_count, QuantizeAxis* result);
+
+// 零点张量的第i个元素（INT8/UINT8/INT32），nullptr表示0
+int32_t ZeroPointAt(const Tensor* zero_point, int64_t i);
+
+// y = saturate(round(x / scale) + zero_point)，y为INT8或UINT8（round为四舍六入五成偶）
+Status QuantizeLinearRun(const float* x, const QuantizeAxis& axis, const float* scale,
+                         const Tensor* zero_point, DataType dtype, void* y, ExecutionContext* ctx);
+
+// y = (x - zero_point) * scale，x为INT8/UINT8/INT32
+Status DequantizeLinearRun(const void* x, DataType dtype, const QuantizeAxis& axis, const float* scale,
+                           const Tensor* zero_point, float* y, ExecutionContext* ctx);
+
+// 输出的重新量化参数：y = saturate(round((acc + bias[c]) * input_scale * weight_scale[c] / output_scale) + zero_point)
+struct Requantization {
+    float input_scale = 1.0f;
+    const float* weight_scale = nullptr;   // weight_scale_count为1时按张量
+    int64_t weight_scale_count = 1;
+    const int32_t* bias = nullptr;         // 按输出通道，可为nullptr
+    float output_scale = 1.0f;
+    int32_t output_zero_point = 0;
+    DataType output_dtype = DataType::UINT8;
+    bool relu = false;                     // 把下界抬到零点（量化域的ReLU）
+    // 量化域的截断区间（Clip激活折叠后由算子按输出的scale/零点换算），与输出类型的范围取交集
+    int32_t clip_min = std::numeric_limits<int32_t>::min();
+    int32_t clip_max = std::numeric_limits<int32_t>::max();
+};
+
+enum class QGemmFormat {
+    S16,   // [rows][k_groups]，每个int32为相邻2个k的int16
+    U8S8   // [rows][k_groups]，每个int32为相邻4个k的s8
+};
+
+// 作为GEMM左操作数打包的常量权重（rows为输出通道），经PrepackedWeightCache在会话间共享
+struct QuantizedPackedWeight {
+    QGemmFormat format = QGemmFormat::S16;
+    int64_t rows = 0;
+    int64_t k = 0;
+    int64_t k_groups = 0;
+    std::vector<int32_t> data;
+    std::vector<int32_t> row_sums;  // U8S8：每行权重（已减零点）之和，用于扣除激活零点
+};
+
+// QLinearConv：权重按组打包为[group][oc_g][k_groups]，同一节点权重不变时复用；
+// Run的工作区是局部的，并发运行可以共享同一个内核
+class QLinearConvKernel {
+public:
+    bool IsPreparedFor(const Conv2DParams& params, const void* weight) const;
+    Status Prepare(const Conv2DParams& params, const Tensor& weight, const Tensor* weight_zero_point);
+    // input为INT8/UINT8的NCHW张量
+    Status Run(const Conv2DParams& params, const void* input, DataType input_dtype,
+               int32_t input_zero_point, const Requantization& requant, void* output,
+               ExecutionContext* ctx);
+    
+    // 当前使用的打包格式（测试用）
+    QGemmFormat GetFormat() const { return packed_ ? packed_->format : QGemmFormat::S16; }
+
+private:
+    Conv2DParams params_;
+    const void* weight_ = nullptr;
+    const char* isa_ = nullptr;  // 打包格式取决于准备时的SIMD核是否精确
+    std::shared_ptr<const QuantizedPackedWeight> packed_;
+};
+
+// QLinearMatMul：B为[K, N]的常量矩阵，按列转置打包为[N][k_groups]；A为[..., M, K]，
+// 计算Y^T = B^T * A^T后按列重新量化写回Y
+class QLinearMatMulKernel {
+public:
+    bool IsPreparedFor(const void* b, int64_t k, int64_t n) const;
+    Status Prepare(const Tensor& b, const Tensor* b_zero_point);
+    // rows = A的行数（各批次合并）
+    Status Run(const void* a, DataType a_dtype, int32_t a_zero_point, int64_t rows,
+               const Requantization& requant, void* output, ExecutionContext* ctx);
+    
+    QGemmFormat GetFormat() const { return packed_ ? packed_->format : QGemmFormat::S16; }
+
+private:
+    const void* b_ = nullptr;
+    const char* isa_ = nullptr;
+    int64_t k_ = 0, n_ = 0;
+    std::shared_ptr<const QuantizedPackedWeight> packed_;
+};
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,691 @@
+// 循环网络算子实现：LSTM与GRU（ONNX语义）
+// 参考ONNX Runtime的DeepCPU LSTM/GRU：所有时间步的输入投影X * W^T + bias在循环前合成一次大GEMM；
+// 循环内每步只剩隐状态与循环权重的乘法，R^T在会话加载时预打包（见PrePack），
+// 每步对一组batch行做一次GEMM后逐行融合门激活（经simd_utils.h的Sigmoid/Tanh）与状态更新。
+// batch各行、双向的两个方向之间没有依赖，按(方向, batch)切块并行，每块独立走完整个序列
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "gemm.h"
+#include "matmul_kernels.h"
+#include "parallel_utils.h"
+#include "prepacked_weights.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+enum class RnnActivation {
+    SIGMOID,
+    TANH,
+    RELU
+};
+
+// 原位激活
+void Activate(RnnActivation activation, float* data, size_t count) {
+    switch (activation) {
+        case RnnActivation::SIGMOID: simd::SigmoidSIMD(data, data, count); break;
+        case RnnActivation::TANH: simd::TanhSIMD(data, data, count); break;
+        case RnnActivation::RELU: simd::ReluSIMD(data, data, count); break;
+    }
+}
+
+void Clip(float* data, size_t count, float clip) {
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = std::min(std::max(data[i], -clip), clip);
+    }
+}
+
+// 序列与张量布局：layout=0时X为[seq, batch, input]，layout=1时为[batch, seq, input]
+struct RnnDims {
+    int64_t seq = 0;
+    int64_t batch = 0;
+    int64_t input = 0;
+    int64_t hidden = 0;
+    int64_t directions = 1;
+    bool batch_first = false;
+    
+    // (t, b)在X与输入投影中的行
+    int64_t Row(int64_t t, int64_t b) const { return batch_first ? b * seq + t : t * batch + b; }
+    // Y：[seq, dirs, batch, H]或[batch, seq, dirs, H]
+    int64_t YOffset(int64_t t, int64_t d, int64_t b) const {
+        return (batch_first ? (b * seq + t) * directions + d : (t * directions + d) * batch + b) * hidden;
+    }
+    // initial_h/Y_h等：[dirs, batch, H]或[batch, dirs, H]
+    int64_t StateOffset(int64_t d, int64_t b) const {
+        return (batch_first ? b * directions + d : d * batch + b) * hidden;
+    }
+};
+
+// 一块连续batch行在某一方向上的循环状态与每步的门缓冲
+struct RnnBlock {
+    int64_t direction = 0;
+    int64_t begin = 0;   // batch行
+    int64_t rows = 0;
+    bool reverse = false;
+    std::vector<int64_t> lengths;  // 每行的有效长度
+    std::vector<float> h;          // [rows, H]
+    std::vector<float> c;          // [rows, H]，只有LSTM使用
+    std::vector<float> gates;      // [rows, gates * H]
+    std::vector<float> scratch;    // GRU的候选隐状态等
+    
+    // 第s步处理的时间步；超出该行有效长度时返回-1
+    int64_t TimeStep(int64_t row, int64_t s) const {
+        const int64_t length = lengths[static_cast<size_t>(row)];
+        if (s >= length) {
+            return -1;
+        }
+        return reverse ? length - 1 - s : s;
+    }
+};
+
+} // anonymous namespace
+
+// LSTM与GRU的公共部分：输入解析、输入投影、循环权重预打包与按(方向, batch)的并行
+class RecurrentOperator : public Operator {
+public:
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        RnnDims dims;
+        return ResolveDims(inputs, &dims);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        RnnDims d;
+        Status status = ResolveDims(inputs, &d);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(d.batch_first ? Shape({d.batch, d.seq, d.directions, d.hidden})
+                                              : Shape({d.seq, d.directions, d.batch, d.hidden}));
+        for (int i = 1; i < NumOutputs(); ++i) {
+            output_shapes.push_back(d.batch_first ? Shape({d.batch, d.directions, d.hidden})
+                                                  : Shape({d.directions, d.batch, d.hidden}));
+        }
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        if (inputs.size() < 3 || inputs[0].shape.dims.size() != 3 || inputs[2].shape.dims.size() != 3) {
+            return Operator::EstimateCost(inputs, outputs);
+        }
+        // 输入投影与循环乘法各为乘加，每个门元素的激活与更新约20次运算
+        const auto& x = inputs[0].shape.dims;
+        const auto& r = inputs[2].shape.dims;
+        const double steps = static_cast<double>(x[0] * x[1]) * static_cast<double>(r[0]);
+        OperatorCost cost;
+        cost.flops = steps * static_cast<double>(r[1]) * (2.0 * static_cast<double>(x[2] + r[2]) + 20.0);
+        for (const TensorInfo& info : inputs) {
+            cost.bytes_read += GetTensorInfoBytes(info);
+        }
+        for (const TensorInfo& info : outputs) {
+            cost.bytes_written += GetTensorInfoBytes(info);
+        }
+        return cost;
+    }
+    
+    // R（输入2）为常量时按方向、按门块打包R^T，循环内每步直接使用
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        const auto& dims = tensor.GetShape().dims;
+        if (input_index != 2 || tensor.GetDataType() != DataType::FLOAT32 || dims.size() != 3 ||
+            gemm::UsesExternalBlas() || dims[1] != NumGates() * dims[2] || dims[2] <= 0) {
+            return Status::Ok();
+        }
+        const int64_t hidden = dims[2];
+        const float* data = static_cast<const float*>(tensor.GetData());
+        const std::vector<std::pair<int64_t, int64_t>> blocks = GetRecurrentBlocks();
+        std::vector<std::shared_ptr<const gemm::PackedMatrix>> packed;
+        for (int64_t d = 0; d < dims[0]; ++d) {
+            for (const auto& block : blocks) {
+                const float* source = data + (d * dims[1] + block.first * hidden) * hidden;
+                const int64_t n = block.second * hidden;
+                const std::string key = PrepackedWeightCache::MakeKey(
+                    std::string("rnn_r_") + gemm::GetMicroKernelName(), {hidden, n},
+                    source, static_cast<size_t>(n * hidden));
+                packed.push_back(PrepackedWeightCache::Instance().GetOrCreate<gemm::PackedMatrix>(key, [&]() {
+                    auto matrix = std::make_shared<gemm::PackedMatrix>();
+                    gemm::PackMatrixB(true, hidden, n, source, hidden, matrix.get());
+                    return std::shared_ptr<const gemm::PackedMatrix>(std::move(matrix));
+                }));
+            }
+        }
+        packed_r_ = std::move(packed);
+        packed_source_ = tensor.GetData();
+        *is_packed = true;
+        return Status::Ok();
+    }
+
+protected:
+    // 门的个数（LSTM为4，GRU为3）、输出个数与各方向的激活函数个数
+    virtual int64_t NumGates() const = 0;
+    virtual int NumOutputs() const = 0;
+    virtual std::vector<std::string> DefaultActivations() const = 0;
+    // 循环乘法按门分成的块：(起始门, 门数)，每块单独打包
+    virtual std::vector<std::pair<int64_t, int64_t>> GetRecurrentBlocks() const = 0;
+    // 输入投影的列bias：[dirs, gates * H]
+    virtual void BuildInputBias(const Tensor* bias, const RnnDims& d, std::vector<float>* out) const = 0;
+    // 一块batch行在一个方向上走完整个序列；h/c已置为初始状态
+    virtual Status RunBlock(const std::vector<Tensor*>& inputs, const RnnDims& d, const float* projection,
+                            RnnBlock* block, float* y) const = 0;
+    
+    // 第slot个ONNX输入，省略或为空时为nullptr（可选输入的位置见input_slots）
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        const std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const int64_t position = i < slots.size() ? slots[i] : static_cast<int64_t>(i);
+            if (position == slot) {
+                return inputs[i] && inputs[i]->GetElementCount() > 0 ? inputs[i] : nullptr;
+            }
+        }
+        return nullptr;
+    }
+    
+    Status ResolveDims(const std::vector<Tensor*>& inputs, RnnDims* d) const {
+        if (inputs.size() < 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " requires X, W and R");
+        }
+        const Tensor* x = inputs[0];
+        const Tensor* w = inputs[1];
+        const Tensor* r = inputs[2];
+        if (x->GetDataType() != DataType::FLOAT32 || w->GetDataType() != DataType::FLOAT32 ||
+            r->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " requires FLOAT32 X, W and R");
+        }
+        const auto& x_dims = x->GetShape().dims;
+        const auto& w_dims = w->GetShape().dims;
+        const auto& r_dims = r->GetShape().dims;
+        if (x_dims.size() != 3 || w_dims.size() != 3 || r_dims.size() != 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " X, W and R must be 3-D");
+        }
+        d->batch_first = GetIntAttribute("layout", 0) != 0;
+        d->seq = d->batch_first ? x_dims[1] : x_dims[0];
+        d->batch = d->batch_first ? x_dims[0] : x_dims[1];
+        d->input = x_dims[2];
+        d->hidden = GetIntAttribute("hidden_size", r_dims[2]);
+        const std::string direction = GetStringAttribute("direction", "forward");
+        if (direction != "forward" && direction != "reverse" && direction != "bidirectional") {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " unknown direction: " + direction);
+        }
+        d->directions = direction == "bidirectional" ? 2 : 1;
+        const int64_t gates = NumGates() * d->hidden;
+        if (w_dims[0] != d->directions || w_dims[1] != gates || w_dims[2] != d->input ||
+            r_dims[0] != d->directions || r_dims[1] != gates || r_dims[2] != d->hidden) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               GetName() + " W/R shapes do not match hidden_size and direction");
+        }
+        const Tensor* bias = InputAt(inputs, 3);
+        if (bias && (bias->GetDataType() != DataType::FLOAT32 ||
+                     bias->GetShape().dims != std::vector<int64_t>({d->directions, 2 * gates}))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " B must be [dirs, 2 * gates * H]");
+        }
+        const Tensor* lengths = InputAt(inputs, 4);
+        if (lengths && ((lengths->GetDataType() != DataType::INT32 && lengths->GetDataType() != DataType::INT64) ||
+                        lengths->GetElementCount() != static_cast<size_t>(d->batch))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " sequence_lens must be [batch]");
+        }
+        const std::vector<int64_t> state_dims = d->batch_first
+            ? std::vector<int64_t>({d->batch, d->directions, d->hidden})
+            : std::vector<int64_t>({d->directions, d->batch, d->hidden});
+        for (int64_t slot : {5, 6}) {
+            const Tensor* state = InputAt(inputs, slot);
+            if (state && (state->GetDataType() != DataType::FLOAT32 || state->GetShape().dims != state_dims)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " initial state shape mismatch");
+            }
+        }
+        std::vector<RnnActivation> activations;
+        return ResolveActivations(d->directions, &activations);
+    }
+    
+    // activations属性（逗号分隔，每个方向依次列出）；只支持Sigmoid、Tanh与Relu
+    Status ResolveActivations(int64_t directions, std::vector<RnnActivation>* out) const {
+        std::vector<std::string> names;
+        std::stringstream ss(GetStringAttribute("activations", ""));
+        for (std::string name; std::getline(ss, name, ',');) {
+            if (!name.empty()) {
+                names.push_back(name);
+            }
+        }
+        const std::vector<std::string> defaults = DefaultActivations();
+        if (names.empty()) {
+            for (int64_t d = 0; d < directions; ++d) {
+                names.insert(names.end(), defaults.begin(), defaults.end());
+            }
+        }
+        if (names.size() != defaults.size() * static_cast<size_t>(directions)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " activations count mismatch");
+        }
+        out->clear();
+        for (const std::string& name : names) {
+            if (name == "Sigmoid") {
+                out->push_back(RnnActivation::SIGMOID);
+            } else if (name == "Tanh") {
+                out->push_back(RnnActivation::TANH);
+            } else if (name == "Relu") {
+                out->push_back(RnnActivation::RELU);
+            } else {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   GetName() + " activation not supported: " + name);
+            }
+        }
+        return Status::Ok();
+    }
+    
+    // C[rows, 块宽] = beta * C + A[rows, H] * R_block^T（+ epilogue），R为常量时使用预打包结果
+    void RecurrentGemm(const Tensor* r, int64_t direction, size_t block, int64_t rows, const float* a,
+                       float beta, float* c, const gemm::GemmEpilogue* epilogue = nullptr) const {
+        const auto& dims = r->GetShape().dims;
+        const int64_t hidden = dims[2];
+        const std::vector<std::pair<int64_t, int64_t>> blocks = GetRecurrentBlocks();
+        const int64_t n = blocks[block].second * hidden;
+        const size_t index = static_cast<size_t>(direction) * blocks.size() + block;
+        if (r->GetData() == packed_source_ && index < packed_r_.size()) {
+            gemm::SgemmPrepacked(false, true, rows, n, hidden, 1.0f, a, hidden, nullptr,
+                                 nullptr, hidden, packed_r_[index].get(), beta, c, n, epilogue);
+            return;
+        }
+        const float* source = static_cast<const float*>(r->GetData()) +
+                              (direction * dims[1] + blocks[block].first * hidden) * hidden;
+        gemm::Sgemm(false, true, rows, n, hidden, 1.0f, a, hidden, source, hidden, beta, c, n, epilogue);
+    }
+    
+    Status Run(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& outputs, ExecutionContext* ctx) {
+        RnnDims d;
+        Status status = ResolveDims(inputs, &d);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t gates = NumGates() * d.hidden;
+        Tensor* y_tensor = !outputs.empty() ? outputs[0] : nullptr;
+        float* y = y_tensor ? static_cast<float*>(y_tensor->GetData()) : nullptr;
+        const Tensor* lengths = InputAt(inputs, 4);
+        if (y && lengths) {
+            // 超出各行有效长度的时间步输出为0
+            status = y_tensor->FillZero();
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        if (d.seq == 0 || d.batch == 0) {
+            return Status::Ok();
+        }
+    
+        // 1. 所有时间步的输入投影：每个方向一次[seq * batch, input] x [input, gates]，bias在写回时加上
+        std::vector<float> bias;
+        BuildInputBias(InputAt(inputs, 3), d, &bias);
+        std::vector<float> projection(static_cast<size_t>(d.directions * d.seq * d.batch * gates));
+        MatMulShape shape;
+        status = ComputeMatMulShape(Shape({d.seq * d.batch, d.input}), Shape({gates, d.input}), false, true, &shape);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const float* x = static_cast<const float*>(inputs[0]->GetData());
+        const float* w = static_cast<const float*>(inputs[1]->GetData());
+        for (int64_t dir = 0; dir < d.directions; ++dir) {
+            gemm::GemmEpilogue epilogue;
+            epilogue.col_bias = bias.data() + dir * gates;
+            RunBatchedMatMul(shape, 1.0f, x, w + dir * gates * d.input, 0.0f,
+                             projection.data() + dir * d.seq * d.batch * gates, &epilogue);
+        }
+    
+        std::vector<int64_t> sequence_lengths(static_cast<size_t>(d.batch), d.seq);
+        if (lengths) {
+            for (int64_t b = 0; b < d.batch; ++b) {
+                const int64_t length = lengths->GetDataType() == DataType::INT32
+                    ? static_cast<const int32_t*>(lengths->GetData())[b]
+                    : static_cast<const int64_t*>(lengths->GetData())[b];
+                if (length < 0 || length > d.seq) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " sequence_lens out of range");
+                }
+                sequence_lengths[static_cast<size_t>(b)] = length;
+            }
+        }
+    
+        // 2. 按(方向, batch行)切块，每块走完整个序列
+        const Tensor* initial_h = InputAt(inputs, 5);
+        const Tensor* initial_c = NumOutputs() == 3 ? InputAt(inputs, 6) : nullptr;
+        const bool reverse_only = GetStringAttribute("direction", "forward") == "reverse";
+        std::vector<Status> errors(static_cast<size_t>(d.directions * d.batch), Status::Ok());
+        ParallelForOuter(ctx, d.directions * d.batch, d.seq * gates * (d.hidden + 4),
+                         [&](int64_t task_begin, int64_t task_end) {
+            for (int64_t task = task_begin; task < task_end;) {
+                // 同一方向内连续的batch行合成一块
+                RnnBlock block;
+                block.direction = task / d.batch;
+                block.begin = task % d.batch;
+                block.rows = std::min(task_end - task, d.batch - block.begin);
+                block.reverse = reverse_only || block.direction == 1;
+                block.lengths.assign(sequence_lengths.begin() + block.begin,
+                                     sequence_lengths.begin() + block.begin + block.rows);
+                block.h.assign(static_cast<size_t>(block.rows * d.hidden), 0.0f);
+                if (NumOutputs() == 3) {
+                    block.c.assign(static_cast<size_t>(block.rows * d.hidden), 0.0f);
+                }
+                for (int64_t r = 0; r < block.rows; ++r) {
+                    const int64_t offset = d.StateOffset(block.direction, block.begin + r);
+                    if (initial_h) {
+                        std::memcpy(block.h.data() + r * d.hidden,
+                                    static_cast<const float*>(initial_h->GetData()) + offset,
+                                    static_cast<size_t>(d.hidden) * sizeof(float));
+                    }
+                    if (initial_c) {
+                        std::memcpy(block.c.data() + r * d.hidden,
+                                    static_cast<const float*>(initial_c->GetData()) + offset,
+                                    static_cast<size_t>(d.hidden) * sizeof(float));
+                    }
+                }
+                Status block_status = RunBlock(inputs, d, projection.data() + block.direction * d.seq * d.batch * gates,
+                                               &block, y);
+                if (!block_status.IsOk()) {
+                    errors[static_cast<size_t>(task)] = block_status;
+                }
+                for (int64_t r = 0; r < block.rows; ++r) {
+                    const int64_t offset = d.StateOffset(block.direction, block.begin + r);
+                    for (size_t o = 1; o < outputs.size() && o < 3; ++o) {
+                        if (!outputs[o] || !outputs[o]->GetData()) {
+                            continue;
+                        }
+                        const std::vector<float>& state = o == 1 ? block.h : block.c;
+                        std::memcpy(static_cast<float*>(outputs[o]->GetData()) + offset,
+                                    state.data() + r * d.hidden, static_cast<size_t>(d.hidden) * sizeof(float));
+                    }
+                }
+                task += block.rows;
+            }
+        });
+        for (const Status& error : errors) {
+            if (!error.IsOk()) {
+                return error;
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::vector<std::shared_ptr<const gemm::PackedMatrix>> packed_r_;
+    const void* packed_source_ = nullptr;
+};
+
+// LSTM（ONNX opset 7-14）
+// 输入：X、W [dirs, 4H, I]、R [dirs, 4H, H]、B [dirs, 8H]、sequence_lens、initial_h、initial_c、P [dirs, 3H]
+// （B之后均可选，位置见input_slots）；输出：Y、Y_h、Y_c。门的顺序为i、o、f、c，peephole的顺序为i、o、f
+// 属性：hidden_size、direction、activations（每个方向f、g、h三个）、clip、input_forget、layout
+class LSTMOperator : public RecurrentOperator {
+public:
+    std::string GetName() const override { return "LSTM"; }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        const Tensor* peephole = InputAt(inputs, 7);
+        if (peephole && peephole->GetElementCount() !=
+                static_cast<size_t>(inputs[2]->GetShape().dims[0] * 3 * inputs[2]->GetShape().dims[2])) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "LSTM P must be [dirs, 3H]");
+        }
+        return Run(inputs, outputs, ctx);
+    }
+
+protected:
+    int64_t NumGates() const override { return 4; }
+    int NumOutputs() const override { return 3; }
+    std::vector<std::string> DefaultActivations() const override { return {"Sigmoid", "Tanh", "Tanh"}; }
+    std::vector<std::pair<int64_t, int64_t>> GetRecurrentBlocks() const override { return {{0, 4}}; }
+    
+    void BuildInputBias(const Tensor* bias, const RnnDims& d, std::vector<float>* out) const override {
+        const int64_t gates = 4 * d.hidden;
+        out->assign(static_cast<size_t>(d.directions * gates), 0.0f);
+        if (!bias) {
+            return;
+        }
+        // Wb与Rb都只是加到门上，合并进输入投影
+        const float* data = static_cast<const float*>(bias->GetData());
+        for (int64_t dir = 0; dir < d.directions; ++dir) {
+            for (int64_t i = 0; i < gates; ++i) {
+                (*out)[static_cast<size_t>(dir * gates + i)] = data[dir * 2 * gates + i] + data[dir * 2 * gates + gates + i];
+            }
+        }
+    }
+    
+    Status RunBlock(const std::vector<Tensor*>& inputs, const RnnDims& d, const float* projection,
+                    RnnBlock* block, float* y) const override {
+        std::vector<RnnActivation> activations;
+        Status status = ResolveActivations(d.directions, &activations);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const RnnActivation f = activations[static_cast<size_t>(block->direction * 3)];
+        const RnnActivation g = activations[static_cast<size_t>(block->direction * 3 + 1)];
+        const RnnActivation h = activations[static_cast<size_t>(block->direction * 3 + 2)];
+        const float clip = GetFloatAttribute("clip", 0.0f);
+        const bool input_forget = GetIntAttribute("input_forget", 0) != 0;
+        const Tensor* peephole = InputAt(inputs, 7);
+        const float* p = peephole ? static_cast<const float*>(peephole->GetData()) + block->direction * 3 * d.hidden
+                                  : nullptr;
+        const int64_t H = d.hidden;
+        const int64_t gates = 4 * H;
+        block->gates.assign(static_cast<size_t>(block->rows * gates), 0.0f);
+        block->scratch.assign(static_cast<size_t>(H), 0.0f);
+        const int64_t steps = *std::max_element(block->lengths.begin(), block->lengths.end());
+    
+        for (int64_t s = 0; s < steps; ++s) {
+            // gates = 输入投影 + h * R^T
+            for (int64_t r = 0; r < block->rows; ++r) {
+                const int64_t t = block->TimeStep(r, s);
+                float* row = block->gates.data() + r * gates;
+                if (t < 0) {
+                    std::fill(row, row + gates, 0.0f);
+                } else {
+                    std::memcpy(row, projection + d.Row(t, block->begin + r) * gates,
+                                static_cast<size_t>(gates) * sizeof(float));
+                }
+            }
+            RecurrentGemm(inputs[2], block->direction, 0, block->rows, block->h.data(), 1.0f, block->gates.data());
+    
+            for (int64_t r = 0; r < block->rows; ++r) {
+                const int64_t t = block->TimeStep(r, s);
+                if (t < 0) {
+                    continue;
+                }
+                float* gi = block->gates.data() + r * gates;
+                float* go = gi + H;
+                float* gf = gi + 2 * H;
+                float* gc = gi + 3 * H;
+                float* c = block->c.data() + r * H;
+                float* hr = block->h.data() + r * H;
+                if (p) {
+                    for (int64_t j = 0; j < H; ++j) {
+                        gi[j] += p[j] * c[j];
+                        gf[j] += p[2 * H + j] * c[j];
+                    }
+                }
+                // 有peephole时o在得到新的c之后才截断
+                if (clip > 0.0f) {
+                    Clip(gi, static_cast<size_t>(p ? H : 2 * H), clip);
+                    Clip(gf, static_cast<size_t>(2 * H), clip);
+                }
+                // 没有peephole时i、o、f相邻，一次激活
+                Activate(f, gi, static_cast<size_t>(p ? H : 3 * H));
+                if (input_forget) {
+                    for (int64_t j = 0; j < H; ++j) {
+                        gf[j] = 1.0f - gi[j];
+                    }
+                } else if (p) {
+                    Activate(f, gf, static_cast<size_t>(H));
+                }
+                Activate(g, gc, static_cast<size_t>(H));
+                for (int64_t j = 0; j < H; ++j) {
+                    c[j] = gf[j] * c[j] + gi[j] * gc[j];
+                }
+                if (p) {
+                    for (int64_t j = 0; j < H; ++j) {
+                        go[j] += p[H + j] * c[j];
+                    }
+                    if (clip > 0.0f) {
+                        Clip(go, static_cast<size_t>(H), clip);
+                    }
+                    Activate(f, go, static_cast<size_t>(H));
+                }
+                float* hc = block->scratch.data();
+                std::memcpy(hc, c, static_cast<size_t>(H) * sizeof(float));
+                Activate(h, hc, static_cast<size_t>(H));
+                simd::MulSIMD(go, hc, hr, static_cast<size_t>(H));
+                if (y) {
+                    std::memcpy(y + d.YOffset(t, block->direction, block->begin + r), hr,
+                                static_cast<size_t>(H) * sizeof(float));
+                }
+            }
+        }
+        return Status::Ok();
+    }
+};
+
+// GRU（ONNX opset 7-14）
+// 输入：X、W [dirs, 3H, I]、R [dirs, 3H, H]、B [dirs, 6H]、sequence_lens、initial_h；输出：Y、Y_h。
+// 门的顺序为z、r、h。属性：hidden_size、direction、activations（每个方向f、g两个）、clip、
+// linear_before_reset（为1时先算h * Rh^T + Rbh再乘r）、layout
+class GRUOperator : public RecurrentOperator {
+public:
+    std::string GetName() const override { return "GRU"; }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        return Run(inputs, outputs, ctx);
+    }
+
+protected:
+    int64_t NumGates() const override { return 3; }
+    int NumOutputs() const override { return 2; }
+    std::vector<std::string> DefaultActivations() const override { return {"Sigmoid", "Tanh"}; }
+    // z、r一起乘；候选隐状态的循环乘法依赖r，单独一块
+    std::vector<std::pair<int64_t, int64_t>> GetRecurrentBlocks() const override { return {{0, 2}, {2, 1}}; }
+    
+    void BuildInputBias(const Tensor* bias, const RnnDims& d, std::vector<float>* out) const override {
+        const int64_t gates = 3 * d.hidden;
+        out->assign(static_cast<size_t>(d.directions * gates), 0.0f);
+        if (!bias) {
+            return;
+        }
+        // z、r的Rb可以合并；linear_before_reset时Rbh在乘r之前加，留在循环内
+        const bool linear_before_reset = LinearBeforeReset();
+        const float* data = static_cast<const float*>(bias->GetData());
+        for (int64_t dir = 0; dir < d.directions; ++dir) {
+            for (int64_t i = 0; i < gates; ++i) {
+                const bool merge = !linear_before_reset || i < 2 * d.hidden;
+                (*out)[static_cast<size_t>(dir * gates + i)] =
+                    data[dir * 2 * gates + i] + (merge ? data[dir * 2 * gates + gates + i] : 0.0f);
+            }
+        }
+    }
+    
+    Status RunBlock(const std::vector<Tensor*>& inputs, const RnnDims& d, const float* projection,
+                    RnnBlock* block, float* y) const override {
+        std::vector<RnnActivation> activations;
+        Status status = ResolveActivations(d.directions, &activations);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const RnnActivation f = activations[static_cast<size_t>(block->direction * 2)];
+        const RnnActivation g = activations[static_cast<size_t>(block->direction * 2 + 1)];
+        const float clip = GetFloatAttribute("clip", 0.0f);
+        const bool linear_before_reset = LinearBeforeReset();
+        const int64_t H = d.hidden;
+        const int64_t gates = 3 * H;
+        const Tensor* bias = InputAt(inputs, 3);
+        gemm::GemmEpilogue recurrent_bias;
+        if (linear_before_reset && bias) {
+            recurrent_bias.col_bias = static_cast<const float*>(bias->GetData()) + block->direction * 2 * gates +
+                                      gates + 2 * H;
+        }
+        const size_t rows = static_cast<size_t>(block->rows);
+        // gates为[rows, 2H]的z、r；scratch前半为候选隐状态[rows, H]，后半为r * h或h * Rh^T
+        block->gates.assign(rows * static_cast<size_t>(2 * H), 0.0f);
+        block->scratch.assign(rows * static_cast<size_t>(2 * H), 0.0f);
+        float* candidate = block->scratch.data();
+        float* recurrent = block->scratch.data() + rows * static_cast<size_t>(H);
+        const int64_t steps = *std::max_element(block->lengths.begin(), block->lengths.end());
+    
+        for (int64_t s = 0; s < steps; ++s) {
+            for (int64_t r = 0; r < block->rows; ++r) {
+                const int64_t t = block->TimeStep(r, s);
+                float* zr = block->gates.data() + r * 2 * H;
+                float* hc = candidate + r * H;
+                if (t < 0) {
+                    std::fill(zr, zr + 2 * H, 0.0f);
+                    std::fill(hc, hc + H, 0.0f);
+                    continue;
+                }
+                const float* source = projection + d.Row(t, block->begin + r) * gates;
+                std::memcpy(zr, source, static_cast<size_t>(2 * H) * sizeof(float));
+                std::memcpy(hc, source + 2 * H, static_cast<size_t>(H) * sizeof(float));
+            }
+            // z、r = f(输入投影 + h * Rzr^T)
+            RecurrentGemm(inputs[2], block->direction, 0, block->rows, block->h.data(), 1.0f, block->gates.data());
+            for (int64_t r = 0; r < block->rows; ++r) {
+                float* zr = block->gates.data() + r * 2 * H;
+                if (clip > 0.0f) {
+                    Clip(zr, static_cast<size_t>(2 * H), clip);
+                }
+                Activate(f, zr, static_cast<size_t>(2 * H));
+            }
+            if (linear_before_reset) {
+                // 候选 += r * (h * Rh^T + Rbh)
+                RecurrentGemm(inputs[2], block->direction, 1, block->rows, block->h.data(), 0.0f, recurrent,
+                              &recurrent_bias);
+                for (int64_t r = 0; r < block->rows; ++r) {
+                    const float* gr = block->gates.data() + r * 2 * H + H;
+                    for (int64_t j = 0; j < H; ++j) {
+                        candidate[r * H + j] += gr[j] * recurrent[r * H + j];
+                    }
+                }
+            } else {
+                // 候选 += (r * h) * Rh^T
+                for (int64_t r = 0; r < block->rows; ++r) {
+                    simd::MulSIMD(block->gates.data() + r * 2 * H + H, block->h.data() + r * H,
+                                  recurrent + r * H, static_cast<size_t>(H));
+                }
+                RecurrentGemm(inputs[2], block->direction, 1, block->rows, recurrent, 1.0f, candidate);
+            }
+    
+            for (int64_t r = 0; r < block->rows; ++r) {
+                const int64_t t = block->TimeStep(r, s);
+                if (t < 0) {
+                    continue;
+                }
+                const float* z = block->gates.data() + r * 2 * H;
+                float* hc = candidate + r * H;
+                float* hr = block->h.data() + r * H;
+                if (clip > 0.0f) {
+                    Clip(hc, static_cast<size_t>(H), clip);
+                }
+                Activate(g, hc, static_cast<size_t>(H));
+                for (int64_t j = 0; j < H; ++j) {
+                    hr[j] = (1.0f - z[j]) * hc[j] + z[j] * hr[j];
+                }
+                if (y) {
+                    std::memcpy(y + d.YOffset(t, block->direction, block->begin + r), hr,
+                                static_cast<size_t>(H) * sizeof(float));
+                }
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    bool LinearBeforeReset() const { return GetIntAttribute("linear_before_reset", 0) != 0; }
+};
+
+REGISTER_OPERATOR("LSTM", LSTMOperator);
+REGISTER_OPERATOR("GRU", GRUOperator);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,408 @@
+// 归约算子：ReduceSum/ReduceMean/ReduceMax/ReduceMin/ReduceSumSquare/ReduceL2
+// 参考ONNX Runtime的reduction_ops（FastReduceKR/RK/KRK）：去掉长度为1的维并合并相邻的同类维后，
+// 形状变为保留(K)与归约(R)交替的若干段，最内段决定内层循环：
+// - 最内段为R：每个输出元素是若干段连续输入的水平归约（ReduceSumSIMD等）
+// - 最内段为K：每个输出行由若干段连续输入逐行纵向累加（AddSIMD/MaxSIMD等）
+// 求和类按块做两级（水平方向为成对）求和以控制舍入误差；输出按行分给算子内线程，
+// 只有一两段（[R]、[R, K]）而输出很少时改为沿归约维切块，各块的部分结果最后合并
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+enum class ReduceKind { SUM, MEAN, MAX, MIN, SUM_SQUARE, L2 };
+
+constexpr size_t kPairwiseBlock = 4096;  // 水平求和：每块单独累加，块之间成对相加
+constexpr int64_t kRowBlock = 32;        // 纵向求和：每kRowBlock行先累加到临时行再并入输出
+constexpr int64_t kSplitWork = 1 << 16;  // 沿归约维切块时每块的输入元素数
+
+class Reducer {
+public:
+    explicit Reducer(ReduceKind kind) : kind_(kind) {}
+    
+    bool IsSum() const { return kind_ != ReduceKind::MAX && kind_ != ReduceKind::MIN; }
+    
+    float Identity() const {
+        if (kind_ == ReduceKind::MAX) return -std::numeric_limits<float>::infinity();
+        if (kind_ == ReduceKind::MIN) return std::numeric_limits<float>::infinity();
+        return 0.0f;
+    }
+    
+    // 一段连续输入的水平归约
+    float Horizontal(const float* x, size_t n) const {
+        switch (kind_) {
+            case ReduceKind::MAX: return simd::ReduceMaxSIMD(x, n);
+            case ReduceKind::MIN: return simd::ReduceMinSIMD(x, n);
+            default: return PairwiseSum(x, n, kind_ == ReduceKind::SUM_SQUARE || kind_ == ReduceKind::L2);
+        }
+    }
+    
+    float Combine(float a, float b) const {
+        if (kind_ == ReduceKind::MAX) return a > b ? a : b;
+        if (kind_ == ReduceKind::MIN) return a < b ? a : b;
+        return a + b;
+    }
+    
+    // acc[i] = acc[i] op f(x[i])
+    void Vertical(const float* x, float* acc, size_t n) const {
+        switch (kind_) {
+            case ReduceKind::MAX: simd::MaxSIMD(acc, x, acc, n); break;
+            case ReduceKind::MIN: simd::BinarySIMD(simd::BinaryOp::MIN, acc, false, x, false, acc, n); break;
+            case ReduceKind::SUM_SQUARE:
+            case ReduceKind::L2: simd::AccumulateSquaresSIMD(x, acc, n); break;
+            default: simd::AddSIMD(acc, x, acc, n); break;
+        }
+    }
+    
+    // 合并两份部分结果（已经过f变换）
+    void CombineRows(const float* partial, float* acc, size_t n) const {
+        switch (kind_) {
+            case ReduceKind::MAX: simd::MaxSIMD(acc, partial, acc, n); break;
+            case ReduceKind::MIN: simd::BinarySIMD(simd::BinaryOp::MIN, acc, false, partial, false, acc, n); break;
+            default: simd::AddSIMD(acc, partial, acc, n); break;
+        }
+    }
+    
+    void Finalize(float* values, size_t n, int64_t reduce_count) const {
+        if (kind_ == ReduceKind::MEAN) {
+            simd::ScaleSIMD(values, values, n, 1.0f / static_cast<float>(reduce_count));
+        } else if (kind_ == ReduceKind::L2) {
+            for (size_t i = 0; i < n; ++i) values[i] = std::sqrt(values[i]);
+        }
+    }
+
+private:
+    static float PairwiseSum(const float* x, size_t n, bool squares) {
+        if (n <= kPairwiseBlock) {
+            return squares ? simd::ReduceSumSquaresSIMD(x, n) : simd::ReduceSumSIMD(x, n);
+        }
+        const size_t half = (n / 2 + kPairwiseBlock - 1) / kPairwiseBlock * kPairwiseBlock;
+        return PairwiseSum(x, half, squares) + PairwiseSum(x + half, n - half, squares);
+    }
+    
+    ReduceKind kind_;
+};
+
+// 折叠后的形状：dims[i]与reduced[i]交替，相邻段类型不同
+struct ReducePlan {
+    std::vector<int64_t> dims;
+    std::vector<bool> reduced;
+    std::vector<int64_t> strides;  // 各段在输入中的元素步长
+    int64_t reduce_count = 1;
+    int64_t output_count = 1;
+};
+
+void BuildReducePlan(const Shape& shape, const std::vector<bool>& reduce_axis, ReducePlan* plan) {
+    for (size_t d = 0; d < shape.dims.size(); ++d) {
+        const int64_t dim = shape.dims[d];
+        (reduce_axis[d] ? plan->reduce_count : plan->output_count) *= dim;
+        if (dim == 1) {
+            continue;
+        }
+        if (!plan->dims.empty() && plan->reduced.back() == reduce_axis[d]) {
+            plan->dims.back() *= dim;
+        } else {
+            plan->dims.push_back(dim);
+            plan->reduced.push_back(reduce_axis[d]);
+        }
+    }
+    if (plan->dims.empty()) {
+        plan->dims.push_back(1);
+        plan->reduced.push_back(false);
+    }
+    plan->strides.assign(plan->dims.size(), 1);
+    for (size_t d = plan->dims.size() - 1; d-- > 0;) {
+        plan->strides[d] = plan->strides[d + 1] * plan->dims[d + 1];
+    }
+}
+
+// 除最内段以外的归约段：按进位遍历，visit(offset)收到每段起始偏移
+template <typename F>
+void ForEachReducedRun(const ReducePlan& plan, const std::vector<size_t>& outer_reduced, F&& visit) {
+    std::vector<int64_t> index(outer_reduced.size(), 0);
+    int64_t offset = 0;
+    while (true) {
+        visit(offset);
+        size_t k = outer_reduced.size();
+        while (k > 0) {
+            const size_t d = outer_reduced[k - 1];
+            offset += plan.strides[d];
+            if (++index[k - 1] < plan.dims[d]) {
+                break;
+            }
+            offset -= plan.strides[d] * plan.dims[d];
+            index[k - 1] = 0;
+            --k;
+        }
+        if (k == 0) {
+            return;
+        }
+    }
+}
+
+// 第row个输出行（最内段为R时即第row个输出元素）在输入中的起始偏移
+int64_t KeptOffset(const ReducePlan& plan, const std::vector<size_t>& outer_kept, int64_t row) {
+    int64_t offset = 0;
+    for (size_t k = outer_kept.size(); k-- > 0;) {
+        const size_t d = outer_kept[k];
+        offset += (row % plan.dims[d]) * plan.strides[d];
+        row /= plan.dims[d];
+    }
+    return offset;
+}
+
+// rows行、每行inner个元素的纵向归约：求和类每kRowBlock行先累加到临时行
+void ReduceRows(const Reducer& reducer, const float* input, int64_t rows, int64_t row_stride,
+                int64_t inner, float* acc) {
+    const size_t n = static_cast<size_t>(inner);
+    if (!reducer.IsSum() || rows <= kRowBlock) {
+        for (int64_t r = 0; r < rows; ++r) {
+            reducer.Vertical(input + r * row_stride, acc, n);
+        }
+        return;
+    }
+    std::vector<float> block(n);
+    for (int64_t r0 = 0; r0 < rows; r0 += kRowBlock) {
+        std::fill(block.begin(), block.end(), 0.0f);
+        const int64_t r1 = std::min(rows, r0 + kRowBlock);
+        for (int64_t r = r0; r < r1; ++r) {
+            reducer.Vertical(input + r * row_stride, block.data(), n);
+        }
+        reducer.CombineRows(block.data(), acc, n);
+    }
+}
+
+Status RunReduce(const Reducer& reducer, const Tensor& input_tensor, const std::vector<bool>& reduce_axis,
+                 float* output, ExecutionContext* ctx) {
+    ReducePlan plan;
+    BuildReducePlan(input_tensor.GetShape(), reduce_axis, &plan);
+    const float* input = static_cast<const float*>(input_tensor.GetData());
+    const size_t out_n = static_cast<size_t>(plan.output_count);
+    std::fill(output, output + out_n, reducer.Identity());
+    if (plan.reduce_count == 0 || plan.output_count == 0) {
+        return Status::Ok();
+    }
+    
+    const size_t last = plan.dims.size() - 1;
+    const int64_t inner = plan.dims[last];
+    const bool inner_reduced = plan.reduced[last];
+    std::vector<size_t> outer_kept, outer_reduced;
+    for (size_t d = 0; d < last; ++d) {
+        (plan.reduced[d] ? outer_reduced : outer_kept).push_back(d);
+    }
+    
+    // [R]或[R, K]：只有一个输出行，沿归约维切块，各块的部分结果最后合并
+    const int64_t total = plan.reduce_count * plan.output_count;
+    const bool single_row = plan.reduced[0] && (plan.dims.size() == 1 ||
+                                                (plan.dims.size() == 2 && !inner_reduced));
+    if (single_row && total >= 2 * kSplitWork) {
+        const int64_t row_len = inner_reduced ? 1 : inner;
+        const int64_t rows = plan.dims[0];
+        const int64_t rows_per_chunk = std::max<int64_t>(1, kSplitWork / row_len);
+        const int64_t chunks = (rows + rows_per_chunk - 1) / rows_per_chunk;
+        std::vector<float> partials(static_cast<size_t>(chunks * plan.output_count), reducer.Identity());
+        ParallelForOuter(ctx, chunks, rows_per_chunk * row_len, [&](int64_t begin, int64_t end) {
+            for (int64_t c = begin; c < end; ++c) {
+                const int64_t r0 = c * rows_per_chunk;
+                const int64_t r1 = std::min(rows, r0 + rows_per_chunk);
+                float* partial = partials.data() + c * plan.output_count;
+                if (inner_reduced) {
+                    partial[0] = reducer.Horizontal(input + r0, static_cast<size_t>(r1 - r0));
+                } else {
+                    ReduceRows(reducer, input + r0 * inner, r1 - r0, inner, inner, partial);
+                }
+            }
+        });
+        for (int64_t c = 0; c < chunks; ++c) {
+            reducer.CombineRows(partials.data() + c * plan.output_count, output, out_n);
+        }
+        reducer.Finalize(output, out_n, plan.reduce_count);
+        return Status::Ok();
+    }
+    
+    if (inner_reduced) {
+        // 水平：每个输出元素归约若干段连续的inner个输入
+        ParallelForOuter(ctx, plan.output_count, plan.reduce_count, [&](int64_t begin, int64_t end) {
+            for (int64_t o = begin; o < end; ++o) {
+                const float* base = input + KeptOffset(plan, outer_kept, o);
+                float value = reducer.Identity();
+                ForEachReducedRun(plan, outer_reduced, [&](int64_t offset) {
+                    value = reducer.Combine(value, reducer.Horizontal(base + offset, static_cast<size_t>(inner)));
+                });
+                output[o] = value;
+            }
+            reducer.Finalize(output + begin, static_cast<size_t>(end - begin), plan.reduce_count);
+        });
+        return Status::Ok();
+    }
+    
+    // 纵向：每个输出行由若干段连续的inner个输入逐行累加；
+    // 只有一个外层归约段时（RK/KRK）按行块累加
+    const int64_t rows = plan.output_count / inner;
+    ParallelForOuter(ctx, rows, plan.reduce_count * inner, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            const float* base = input + KeptOffset(plan, outer_kept, r);
+            float* acc = output + r * inner;
+            if (outer_reduced.size() == 1) {
+                const size_t d = outer_reduced[0];
+                ReduceRows(reducer, base, plan.dims[d], plan.strides[d], inner, acc);
+            } else {
+                ForEachReducedRun(plan, outer_reduced, [&](int64_t offset) {
+                    reducer.Vertical(base + offset, acc, static_cast<size_t>(inner));
+                });
+            }
+            reducer.Finalize(acc, static_cast<size_t>(inner), plan.reduce_count);
+        }
+    });
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+// 归约算子基类：axes来自属性（opset < 18）或第二个输入（INT64），为空时归约全部维度
+// （noop_with_empty_axes = 1时原样输出）；keepdims默认为1
+class ReduceOperatorBase : public Operator {
+public:
+    ReduceOperatorBase(const char* name, ReduceKind kind) : name_(name), kind_(kind) {}
+    
+    std::string GetName() const override { return name_; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs.size() > 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " requires 1 or 2 inputs");
+        }
+        if (inputs[0]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, name_ + " supports FLOAT32 only");
+        }
+        std::vector<bool> reduce_axis;
+        return ResolveAxes(inputs, &reduce_axis);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " requires an input");
+        }
+        std::vector<bool> reduce_axis;
+        Status status = ResolveAxes(inputs, &reduce_axis);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(OutputShape(inputs[0]->GetShape(), reduce_axis));
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<bool> reduce_axis;
+        ResolveAxes(inputs, &reduce_axis);
+        const Shape expected = OutputShape(inputs[0]->GetShape(), reduce_axis);
+        if (outputs[0]->GetShape().GetElementCount() != expected.GetElementCount()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, name_ + " output shape mismatch");
+        }
+        return RunReduce(Reducer(kind_), *inputs[0], reduce_axis,
+                         static_cast<float*>(outputs[0]->GetData()), ctx);
+    }
+
+private:
+    Status ResolveAxes(const std::vector<Tensor*>& inputs, std::vector<bool>* reduce_axis) const {
+        const int64_t rank = static_cast<int64_t>(inputs[0]->GetShape().dims.size());
+        std::vector<int64_t> axes;
+        if (inputs.size() > 1 && inputs[1] && inputs[1]->GetElementCount() > 0) {
+            if (inputs[1]->GetDataType() != DataType::INT64 || !inputs[1]->GetData()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   name_ + " axes input must be a constant INT64 tensor");
+            }
+            const int64_t* data = static_cast<const int64_t*>(inputs[1]->GetData());
+            axes.assign(data, data + inputs[1]->GetElementCount());
+        } else {
+            axes = GetIntsAttribute("axes", {});
+        }
+        const bool noop = GetIntAttribute("noop_with_empty_axes", 0) != 0;
+        reduce_axis->assign(static_cast<size_t>(rank), axes.empty() && !noop);
+        for (int64_t axis : axes) {
+            const int64_t normalized = axis < 0 ? axis + rank : axis;
+            if (normalized < 0 || normalized >= rank || (*reduce_axis)[normalized]) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   name_ + " axis out of range or repeated: " + std::to_string(axis));
+            }
+            (*reduce_axis)[normalized] = true;
+        }
+        return Status::Ok();
+    }
+    
+    Shape OutputShape(const Shape& input, const std::vector<bool>& reduce_axis) const {
+        const bool keepdims = GetIntAttribute("keepdims", 1) != 0;
+        std::vector<int64_t> dims;
+        for (size_t d = 0; d < input.dims.size(); ++d) {
+            if (!reduce_axis[d]) {
+                dims.push_back(input.dims[d]);
+            } else if (keepdims) {
+                dims.push_back(1);
+            }
+        }
+        return Shape(dims);
+    }
+    
+    std::string name_;
+    ReduceKind kind_;
+};
+
+class ReduceSumOperator : public ReduceOperatorBase {
+public:
+    ReduceSumOperator() : ReduceOperatorBase("ReduceSum", ReduceKind::SUM) {}
+};
+
+class ReduceMeanOperator : public ReduceOperatorBase {
+public:
+    ReduceMeanOperator() : ReduceOperatorBase("ReduceMean", ReduceKind::MEAN) {}
+};
+
+class ReduceMaxOperator : public ReduceOperatorBase {
+public:
+    ReduceMaxOperator() : ReduceOperatorBase("ReduceMax", ReduceKind::MAX) {}
+};
+
+class ReduceMinOperator : public ReduceOperatorBase {
+public:
+    ReduceMinOperator() : ReduceOperatorBase("ReduceMin", ReduceKind::MIN) {}
+};
+
+class ReduceSumSquareOperator : public ReduceOperatorBase {
+public:
+    ReduceSumSquareOperator() : ReduceOperatorBase("ReduceSumSquare", ReduceKind::SUM_SQUARE) {}
+};
+
+class ReduceL2Operator : public ReduceOperatorBase {
+public:
+    ReduceL2Operator() : ReduceOperatorBase("ReduceL2", ReduceKind::L2) {}
+};
+
+REGISTER_OPERATOR("ReduceSum", ReduceSumOperator);
+REGISTER_OPERATOR("ReduceMean", ReduceMeanOperator);
+REGISTER_OPERATOR("ReduceMax", ReduceMaxOperator);
+REGISTER_OPERATOR("ReduceMin", ReduceMinOperator);
+REGISTER_OPERATOR("ReduceSumSquare", ReduceSumSquareOperator);
+REGISTER_OPERATOR("ReduceL2", ReduceL2Operator);
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,613 @@
+// Resize算子实现
+// 参考ONNX Runtime的Upsample/Resize与OpenCV的resize：对最后两维（H、W）按轴预先计算每个输出坐标的
+// 源下标与插值权重（nearest 1个、linear 2个、cubic 4个抽头），先沿W按表取数得到各源行的水平插值结果，
+// 再沿H用SIMD对这些行做加权累加。水平结果按源行缓存，相邻输出行共用的源行只计算一次
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "nchwc_kernels.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+constexpr int kMaxTaps = 4;
+
+// 一个轴上每个输出坐标的源下标与权重，均为[out, taps]
+struct AxisTable {
+    int taps = 1;
+    std::vector<int64_t> index;
+    std::vector<float> weight;
+};
+
+struct ResizeParams {
+    std::string mode;                 // nearest / linear / cubic
+    std::string coordinate_mode;      // coordinate_transformation_mode
+    std::string nearest_mode;
+    float cubic_coeff_a = -0.75f;
+    bool exclude_outside = false;
+};
+
+// 输出坐标x映射回输入坐标（ONNX Resize的coordinate_transformation_mode）
+bool OriginalCoordinate(const std::string& mode, float x, float scale, int64_t in, int64_t out, float* original) {
+    if (mode == "half_pixel") {
+        *original = (x + 0.5f) / scale - 0.5f;
+    } else if (mode == "pytorch_half_pixel") {
+        *original = out > 1 ? (x + 0.5f) / scale - 0.5f : 0.0f;
+    } else if (mode == "align_corners") {
+        *original = out > 1 ? x * static_cast<float>(in - 1) / static_cast<float>(out - 1) : 0.0f;
+    } else if (mode == "asymmetric") {
+        *original = x / scale;
+    } else if (mode == "tf_half_pixel_for_nearest") {
+        *original = (x + 0.5f) / scale;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int64_t NearestIndex(const std::string& mode, float x) {
+    const float lower = std::floor(x);
+    if (mode == "floor") {
+        return static_cast<int64_t>(lower);
+    }
+    if (mode == "ceil") {
+        return static_cast<int64_t>(std::ceil(x));
+    }
+    if (x - lower == 0.5f) {
+        return static_cast<int64_t>(mode == "round_prefer_ceil" ? lower + 1.0f : lower);
+    }
+    return static_cast<int64_t>(std::round(x));
+}
+
+// Keys三次卷积核在偏移s ∈ [0, 1)处四个抽头（-1, 0, 1, 2）的系数
+std::array<float, 4> CubicCoefficients(float s, float a) {
+    auto near = [a](float t) { return ((a + 2.0f) * t - (a + 3.0f)) * t * t + 1.0f; };          // |t| <= 1
+    auto far = [a](float t) { return ((a * t - 5.0f * a) * t + 8.0f * a) * t - 4.0f * a; };     // 1 < |t| < 2
+    return {far(s + 1.0f), near(s), near(1.0f - s), far(2.0f - s)};
+}
+
+Status BuildAxisTable(const ResizeParams& params, int64_t in, int64_t out, float scale, AxisTable* table) {
+    table->taps = params.mode == "nearest" ? 1 : (params.mode == "linear" ? 2 : kMaxTaps);
+    table->index.assign(static_cast<size_t>(out * table->taps), 0);
+    table->weight.assign(static_cast<size_t>(out * table->taps), 0.0f);
+    for (int64_t x = 0; x < out; ++x) {
+        float original = 0.0f;
+        if (!OriginalCoordinate(params.coordinate_mode, static_cast<float>(x), scale, in, out, &original)) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "Resize coordinate_transformation_mode not supported: " + params.coordinate_mode);
+        }
+        int64_t* index = table->index.data() + x * table->taps;
+        float* weight = table->weight.data() + x * table->taps;
+        if (table->taps == 1) {
+            index[0] = std::min(std::max<int64_t>(NearestIndex(params.nearest_mode, original), 0), in - 1);
+            weight[0] = 1.0f;
+        } else if (table->taps == 2) {
+            original = std::min(std::max(original, 0.0f), static_cast<float>(in - 1));
+            const int64_t x0 = static_cast<int64_t>(original);
+            index[0] = x0;
+            index[1] = std::min(x0 + 1, in - 1);
+            weight[1] = original - static_cast<float>(x0);
+            weight[0] = 1.0f - weight[1];
+        } else {
+            const float lower = std::floor(original);
+            const std::array<float, 4> coeffs = CubicCoefficients(original - lower, params.cubic_coeff_a);
+            float sum = 0.0f;
+            for (int t = 0; t < kMaxTaps; ++t) {
+                const int64_t i = static_cast<int64_t>(lower) - 1 + t;
+                const bool outside = i < 0 || i >= in;
+                index[t] = std::min(std::max<int64_t>(i, 0), in - 1);  // 边缘复制
+                weight[t] = params.exclude_outside && outside ? 0.0f : coeffs[t];
+                sum += weight[t];
+            }
+            if (params.exclude_outside && sum != 0.0f) {
+                for (int t = 0; t < kMaxTaps; ++t) {
+                    weight[t] /= sum;
+                }
+            }
+        }
+    }
+    return Status::Ok();
+}
+
+// 按表沿W插值一行
+void InterpolateRow(const AxisTable& table, const float* src, float* dst, int64_t width) {
+    const int64_t* index = table.index.data();
+    const float* weight = table.weight.data();
+    switch (table.taps) {
+        case 1:
+            for (int64_t x = 0; x < width; ++x) {
+                dst[x] = src[index[x]];
+            }
+            break;
+        case 2:
+            for (int64_t x = 0; x < width; ++x) {
+                dst[x] = src[index[2 * x]] * weight[2 * x] + src[index[2 * x + 1]] * weight[2 * x + 1];
+            }
+            break;
+        default:
+            for (int64_t x = 0; x < width; ++x) {
+                const int64_t* i = index + 4 * x;
+                const float* w = weight + 4 * x;
+                dst[x] = src[i[0]] * w[0] + src[i[1]] * w[1] + src[i[2]] * w[2] + src[i[3]] * w[3];
+            }
+            break;
+    }
+}
+
+} // anonymous namespace
+
+// Resize算子（ONNX opset 10-19）
+// 输入：X, [roi], [scales], [sizes]（省略的可选输入按input_slots定位；只有两个输入且未标注时第二个为scales）
+// 只缩放最后两维；mode为nearest/linear/cubic，tf_crop_and_resize与antialias不支持
+class ResizeOperator : public Operator {
+public:
+    std::string GetName() const override { return "Resize"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs[0]->GetDataType() != DataType::FLOAT32 ||
+            inputs[0]->GetShape().dims.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Resize requires a FLOAT32 input of rank >= 2");
+        }
+        const std::string mode = GetStringAttribute("mode", "nearest");
+        if (mode != "nearest" && mode != "linear" && mode != "cubic") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Resize mode not supported: " + mode);
+        }
+        if (GetIntAttribute("antialias", 0) != 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Resize antialias is not supported");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        std::vector<int64_t> dims;
+        std::vector<float> scales;
+        Status status = ResolveOutput(inputs, &dims, &scales);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 每个输出元素：水平与垂直各taps次乘加
+        const std::string mode = GetStringAttribute("mode", "nearest");
+        const double taps = mode == "nearest" ? 0.0 : (mode == "linear" ? 2.0 : 4.0);
+        return EstimateElementwiseCost(inputs, outputs, 4.0 * taps);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::vector<int64_t> dims;
+        std::vector<float> scales;
+        Status status = ResolveOutput(inputs, &dims, &scales);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (outputs[0]->GetShape().dims != dims) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Resize output shape mismatch");
+        }
+        const auto& in_dims = inputs[0]->GetShape().dims;
+        const size_t rank = in_dims.size();
+        const int64_t in_h = in_dims[rank - 2], in_w = in_dims[rank - 1];
+        const int64_t out_h = dims[rank - 2], out_w = dims[rank - 1];
+        const int64_t planes = static_cast<int64_t>(outputs[0]->GetElementCount()) / std::max<int64_t>(out_h * out_w, 1);
+        if (planes == 0 || out_h == 0 || out_w == 0) {
+            return Status::Ok();
+        }
+    
+        ResizeParams params;
+        params.mode = GetStringAttribute("mode", "nearest");
+        params.coordinate_mode = GetStringAttribute("coordinate_transformation_mode", "half_pixel");
+        params.nearest_mode = GetStringAttribute("nearest_mode", "round_prefer_floor");
+        params.cubic_coeff_a = GetFloatAttribute("cubic_coeff_a", -0.75f);
+        params.exclude_outside = GetIntAttribute("exclude_outside", 0) != 0;
+        AxisTable rows, cols;
+        status = BuildAxisTable(params, in_h, out_h, scales[rank - 2], &rows);
+        if (status.IsOk()) {
+            status = BuildAxisTable(params, in_w, out_w, scales[rank - 1], &cols);
+        }
+        if (!status.IsOk()) {
+            return status;
+        }
+    
+        const float* X = static_cast<const float*>(inputs[0]->GetData());
+        float* Y = static_cast<float*>(outputs[0]->GetData());
+        const int taps = rows.taps;
+        ParallelForOuter(ctx, planes * out_h, out_w * taps * cols.taps, [&](int64_t begin, int64_t end) {
+            // 最近计算过的源行的水平插值结果：taps个槽位足以容纳一个输出行需要的全部源行
+            thread_local std::vector<float> cache;
+            cache.resize(static_cast<size_t>(taps * out_w));
+            std::array<int64_t, kMaxTaps> cached;  // 槽位中的源行（plane * in_h + 行），-1为空
+            cached.fill(-1);
+            for (int64_t task = begin; task < end; ++task) {
+                const int64_t plane = task / out_h;
+                const int64_t y = task % out_h;
+                const int64_t* src_rows = rows.index.data() + y * taps;
+                const float* weights = rows.weight.data() + y * taps;
+                std::array<const float*, kMaxTaps> horizontal{};
+                for (int t = 0; t < taps; ++t) {
+                    const int64_t key = plane * in_h + src_rows[t];
+                    int slot = static_cast<int>(std::find(cached.begin(), cached.begin() + taps, key) - cached.begin());
+                    if (slot == taps) {
+                        // 替换一个当前输出行不需要的槽位
+                        for (slot = 0; slot < taps; ++slot) {
+                            const int64_t held = cached[slot];
+                            bool needed = false;
+                            for (int u = 0; u < taps; ++u) {
+                                needed = needed || held == plane * in_h + src_rows[u];
+                            }
+                            if (!needed) {
+                                break;
+                            }
+                        }
+                        InterpolateRow(cols, X + key * in_w, cache.data() + slot * out_w, out_w);
+                        cached[slot] = key;
+                    }
+                    horizontal[t] = cache.data() + slot * out_w;
+                }
+                float* dst = Y + task * out_w;
+                if (taps == 1) {
+                    std::memcpy(dst, horizontal[0], static_cast<size_t>(out_w) * sizeof(float));
+                    continue;
+                }
+                simd::ScaleSIMD(horizontal[0], dst, static_cast<size_t>(out_w), weights[0]);
+                for (int t = 1; t < taps; ++t) {
+                    simd::ScaleAddSIMD(horizontal[t], weights[t], dst, static_cast<size_t>(out_w));
+                }
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    // 第slot个ONNX输入（0 X, 1 roi, 2 scales, 3 sizes），省略或为空时为nullptr
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        if (slots.empty()) {
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                slots.push_back(inputs.size() == 2 && i == 1 ? 2 : static_cast<int64_t>(i));  // opset 10
+            }
+        }
+        for (size_t i = 0; i < slots.size() && i < inputs.size(); ++i) {
+            if (slots[i] == slot) {
+                return inputs[i] && inputs[i]->GetElementCount() > 0 ? inputs[i] : nullptr;
+            }
+        }
+        return nullptr;
+    }
+    
+    // 输出形状与各轴的缩放比例（给定sizes时为out / in）
+    Status ResolveOutput(const std::vector<Tensor*>& inputs, std::vector<int64_t>* dims,
+                         std::vector<float>* scales) const {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Resize requires an input");
+        }
+        if (GetStringAttribute("coordinate_transformation_mode", "half_pixel") == "tf_crop_and_resize") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Resize tf_crop_and_resize is not supported");
+        }
+        const auto& in_dims = inputs[0]->GetShape().dims;
+        const size_t rank = in_dims.size();
+        const Tensor* scale_tensor = InputAt(inputs, 2);
+        const Tensor* size_tensor = InputAt(inputs, 3);
+        dims->assign(in_dims.begin(), in_dims.end());
+        scales->assign(rank, 1.0f);
+        if (size_tensor) {
+            if (size_tensor->GetDataType() != DataType::INT64 || !size_tensor->GetData() ||
+                size_tensor->GetElementCount() != rank) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Resize sizes must be a constant INT64 tensor with one entry per axis");
+            }
+            const int64_t* sizes = static_cast<const int64_t*>(size_tensor->GetData());
+            for (size_t d = 0; d < rank; ++d) {
+                (*dims)[d] = sizes[d];
+                (*scales)[d] = in_dims[d] > 0 ? static_cast<float>(sizes[d]) / static_cast<float>(in_dims[d]) : 1.0f;
+            }
+        } else if (scale_tensor) {
+            if (scale_tensor->GetDataType() != DataType::FLOAT32 || !scale_tensor->GetData() ||
+                scale_tensor->GetElementCount() != rank) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Resize scales must be a constant FLOAT32 tensor with one entry per axis");
+            }
+            const float* data = static_cast<const float*>(scale_tensor->GetData());
+            for (size_t d = 0; d < rank; ++d) {
+                if (data[d] <= 0.0f) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Resize scales must be positive");
+                }
+                (*scales)[d] = data[d];
+                (*dims)[d] = in_dims[d] < 0 ? -1
+                    : static_cast<int64_t>(std::floor(static_cast<float>(in_dims[d]) * data[d]));
+            }
+        } else {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Resize requires scales or sizes");
+        }
+        for (size_t d = 0; d + 2 < rank; ++d) {
+            if ((*dims)[d] != in_dims[d]) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Resize only supports the last two axes");
+            }
+        }
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("Resize", ResizeOperator);
+
+// ImagePreprocess算子：uint8 NHWC图像 -> 归一化的FP32/FP16 NCHW或NCHWc（客户端图像的预处理，见preprocess.h）
+// 一遍完成缩放、归一化、HWC->CHW与类型转换：每个源行的字节按通道拆开（留在L1中），逐通道用SIMD把u8
+// 转成(x * scale - mean) / std，缩放时再沿W按表插值、沿H加权累加（插值权重之和为1，与归一化可交换），
+// 结果直接写入输出平面（NCHW FP32）或经行缓冲转成FP16、散布到分块位置，输入字节只读一遍
+// 属性：mean/std（每通道，按输出通道顺序，可为1个或省略）、scale（默认1）、reverse_channels（BGR<->RGB）、
+// height/width（0表示不缩放）、mode（linear/nearest，half_pixel坐标）、layout（NCHW/NCHWc）、block_size（默认8）、
+// to（1为FLOAT，10为FLOAT16）
+class ImagePreprocessOperator : public Operator {
+public:
+    std::string GetName() const override { return "ImagePreprocess"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs[0]->GetDataType() != DataType::UINT8 ||
+            inputs[0]->GetShape().dims.size() != 4) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "ImagePreprocess requires a UINT8 NHWC input");
+        }
+        const int64_t channels = inputs[0]->GetShape().dims[3];
+        const std::vector<float> mean = GetFloats("mean");
+        const std::vector<float> stddev = GetFloats("std");
+        if ((mean.size() > 1 && static_cast<int64_t>(mean.size()) != channels) ||
+            (stddev.size() > 1 && static_cast<int64_t>(stddev.size()) != channels)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "ImagePreprocess mean/std need one entry per channel");
+        }
+        for (float value : stddev) {
+            if (value == 0.0f) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ImagePreprocess std must be non-zero");
+            }
+        }
+        const std::string mode = GetStringAttribute("mode", "linear");
+        const std::string layout = GetStringAttribute("layout", "NCHW");
+        const int64_t to = GetIntAttribute("to", 1);
+        if ((mode != "linear" && mode != "nearest") || (layout != "NCHW" && layout != "NCHWc") ||
+            (to != 1 && to != 10) || GetIntAttribute("block_size", 8) <= 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "ImagePreprocess supports linear/nearest, NCHW/NCHWc and FLOAT/FLOAT16 output");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const auto& dims = inputs[0]->GetShape().dims;
+        const int64_t height = GetIntAttribute("height", 0);
+        const int64_t width = GetIntAttribute("width", 0);
+        Shape nchw({dims[0], dims[3], height > 0 ? height : dims[1], width > 0 ? width : dims[2]});
+        output_shapes.push_back(GetStringAttribute("layout", "NCHW") == "NCHWc"
+            ? NchwcShape(nchw, GetIntAttribute("block_size", 8)) : nchw);
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return GetIntAttribute("to", 1) == 10 ? DataType::FLOAT16 : DataType::FLOAT32;
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        const double taps = GetIntAttribute("height", 0) > 0 || GetIntAttribute("width", 0) > 0
+            ? (GetStringAttribute("mode", "linear") == "linear" ? 2.0 : 0.0) : 0.0;
+        return EstimateElementwiseCost(inputs, outputs, 2.0 + 4.0 * taps);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::vector<Shape> shapes;
+        Status status = InferOutputShape(inputs, shapes);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (outputs[0]->GetShape().dims != shapes[0].dims ||
+            outputs[0]->GetDataType() != InferOutputDataType(inputs, 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ImagePreprocess output mismatch");
+        }
+        const auto& in_dims = inputs[0]->GetShape().dims;
+        const int64_t batch = in_dims[0], in_h = in_dims[1], in_w = in_dims[2], channels = in_dims[3];
+        const int64_t height = GetIntAttribute("height", 0), width = GetIntAttribute("width", 0);
+        const int64_t out_h = height > 0 ? height : in_h;
+        const int64_t out_w = width > 0 ? width : in_w;
+        if (batch == 0 || channels == 0 || out_h == 0 || out_w == 0) {
+            return Status::Ok();
+        }
+        if (in_h == 0 || in_w == 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ImagePreprocess cannot resize an empty image");
+        }
+        
+        // 每个输出通道c：out = x[source[c]] * mul[c] + add[c]
+        const std::vector<float> mean = GetFloats("mean");
+        const std::vector<float> stddev = GetFloats("std");
+        const float scale = GetFloatAttribute("scale", 1.0f);
+        const bool reverse = GetIntAttribute("reverse_channels", 0) != 0;
+        std::vector<float> mul(static_cast<size_t>(channels)), add(static_cast<size_t>(channels));
+        std::vector<int64_t> source(static_cast<size_t>(channels));
+        for (int64_t c = 0; c < channels; ++c) {
+            const float m = mean.empty() ? 0.0f : mean[mean.size() == 1 ? 0 : c];
+            const float s = stddev.empty() ? 1.0f : stddev[stddev.size() == 1 ? 0 : c];
+            mul[c] = scale / s;
+            add[c] = -m / s;
+            source[c] = reverse ? channels - 1 - c : c;
+        }
+        
+        const bool resize = out_h != in_h || out_w != in_w;
+        AxisTable rows, cols;
+        if (resize) {
+            ResizeParams params;
+            params.mode = GetStringAttribute("mode", "linear");
+            params.coordinate_mode = "half_pixel";
+            params.nearest_mode = "round_prefer_floor";
+            status = BuildAxisTable(params, in_h, out_h, static_cast<float>(out_h) / static_cast<float>(in_h), &rows);
+            if (status.IsOk()) {
+                status = BuildAxisTable(params, in_w, out_w, static_cast<float>(out_w) / static_cast<float>(in_w), &cols);
+            }
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        
+        const bool blocked = GetStringAttribute("layout", "NCHW") == "NCHWc";
+        const int64_t block = blocked ? GetIntAttribute("block_size", 8) : 1;
+        const int64_t padded = blocked ? (channels + block - 1) / block * block : channels;
+        const bool half = outputs[0]->GetDataType() == DataType::FLOAT16;
+        const bool direct = !blocked && !half;  // FP32 NCHW：直接写入输出平面
+        const uint8_t* X = static_cast<const uint8_t*>(inputs[0]->GetData());
+        void* Y = outputs[0]->GetData();
+        const int taps = resize ? rows.taps : 1;
+        const int64_t work = out_w * channels * (resize ? 2 * taps * cols.taps : 1);
+        ParallelForOuter(ctx, batch * out_h, work, [&](int64_t begin, int64_t end) {
+            thread_local std::vector<uint8_t> planes;     // 一个源行按通道拆开的字节，[C, in_w]
+            thread_local std::vector<float> converted;    // 一个通道归一化后的源行，[in_w]
+            thread_local std::vector<float> cache;        // 源行的水平插值结果，[taps][C, out_w]
+            thread_local std::vector<float> row;          // 非直接写出时的输出行，[C, out_w]
+            thread_local std::vector<uint16_t> half_row;  // [out_w]
+            planes.resize(static_cast<size_t>(channels * in_w));
+            converted.resize(static_cast<size_t>(in_w));
+            cache.resize(resize ? static_cast<size_t>(taps * channels * out_w) : 0);
+            row.resize(direct ? 0 : static_cast<size_t>(channels * out_w));
+            half_row.resize(half ? static_cast<size_t>(out_w) : 0);
+            std::array<int64_t, kMaxTaps> cached;  // 槽位中的源行（n * in_h + 行），-1为空
+            cached.fill(-1);
+            
+            // 源行key（n * in_h + 行）的像素按通道拆开
+            auto deinterleave = [&](int64_t key) {
+                const uint8_t* pixels = X + key * in_w * channels;
+                for (int64_t c = 0; c < channels; ++c) {
+                    uint8_t* plane = planes.data() + c * in_w;
+                    const int64_t sc = source[c];
+                    for (int64_t x = 0; x < in_w; ++x) {
+                        plane[x] = pixels[x * channels + sc];
+                    }
+                }
+            };
+            for (int64_t task = begin; task < end; ++task) {
+                const int64_t n = task / out_h;
+                const int64_t y = task % out_h;
+                auto dst_row = [&](int64_t c) {
+                    return direct ? static_cast<float*>(Y) + ((n * channels + c) * out_h + y) * out_w
+                                  : row.data() + c * out_w;
+                };
+                if (!resize) {
+                    deinterleave(n * in_h + y);
+                    for (int64_t c = 0; c < channels; ++c) {
+                        simd::ConvertU8AffineSIMD(planes.data() + c * in_w, dst_row(c), static_cast<size_t>(in_w),
+                                                  mul[c], add[c]);
+                    }
+                } else {
+                    const int64_t* src_rows = rows.index.data() + y * taps;
+                    const float* weights = rows.weight.data() + y * taps;
+                    std::array<const float*, kMaxTaps> horizontal{};
+                    for (int t = 0; t < taps; ++t) {
+                        const int64_t key = n * in_h + src_rows[t];
+                        int slot = static_cast<int>(std::find(cached.begin(), cached.begin() + taps, key) - cached.begin());
+                        if (slot == taps) {
+                            // 替换一个当前输出行不需要的槽位
+                            for (slot = 0; slot < taps; ++slot) {
+                                const int64_t held = cached[slot];
+                                bool needed = false;
+                                for (int u = 0; u < taps; ++u) {
+                                    needed = needed || held == n * in_h + src_rows[u];
+                                }
+                                if (!needed) {
+                                    break;
+                                }
+                            }
+                            deinterleave(key);
+                            float* target = cache.data() + slot * channels * out_w;
+                            for (int64_t c = 0; c < channels; ++c) {
+                                simd::ConvertU8AffineSIMD(planes.data() + c * in_w, converted.data(),
+                                                          static_cast<size_t>(in_w), mul[c], add[c]);
+                                InterpolateRow(cols, converted.data(), target + c * out_w, out_w);
+                            }
+                            cached[slot] = key;
+                        }
+                        horizontal[t] = cache.data() + slot * channels * out_w;
+                    }
+                    for (int64_t c = 0; c < channels; ++c) {
+                        float* dst = dst_row(c);
+                        if (taps == 1) {
+                            std::memcpy(dst, horizontal[0] + c * out_w, static_cast<size_t>(out_w) * sizeof(float));
+                            continue;
+                        }
+                        simd::ScaleSIMD(horizontal[0] + c * out_w, dst, static_cast<size_t>(out_w), weights[0]);
+                        for (int t = 1; t < taps; ++t) {
+                            simd::ScaleAddSIMD(horizontal[t] + c * out_w, weights[t], dst, static_cast<size_t>(out_w));
+                        }
+                    }
+                }
+                if (direct) {
+                    continue;
+                }
+                
+                // FP16与分块布局：从行缓冲写出，分块布局末块补齐的通道写0
+                for (int64_t c = 0; c < padded; ++c) {
+                    const float* values = c < channels ? row.data() + c * out_w : nullptr;
+                    if (half && values) {
+                        simd::ConvertFloatToHalfSIMD(values, half_row.data(), static_cast<size_t>(out_w));
+                    }
+                    const int64_t offset = blocked
+                        ? (((n * (padded / block) + c / block) * out_h + y) * out_w) * block + c % block
+                        : ((n * channels + c) * out_h + y) * out_w;
+                    const int64_t step = blocked ? block : 1;
+                    if (half) {
+                        uint16_t* dst = static_cast<uint16_t*>(Y) + offset;
+                        if (!blocked) {
+                            std::memcpy(dst, half_row.data(), static_cast<size_t>(out_w) * sizeof(uint16_t));
+                            continue;
+                        }
+                        for (int64_t x = 0; x < out_w; ++x) {
+                            dst[x * step] = values ? half_row[x] : 0;
+                        }
+                    } else {
+                        float* dst = static_cast<float*>(Y) + offset;
+                        for (int64_t x = 0; x < out_w; ++x) {
+                            dst[x * step] = values ? values[x] : 0.0f;
+                        }
+                    }
+                }
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    std::vector<float> GetFloats(const std::string& key) const {
+        AttributeValue value = GetAttribute(key);
+        return value.GetType() == AttributeValue::Type::FLOATS ? value.GetFloats() : std::vector<float>();
+    }
+};
+
+REGISTER_OPERATOR("ImagePreprocess", ImagePreprocessOperator);
+
+} // namespace operators
+} // namespace inferunity
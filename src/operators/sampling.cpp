@@ -0,0 +1,400 @@
+// 解码采样算子实现：ArgMax与Sampling
+// 参考HuggingFace transformers的LogitsProcessor（重复惩罚 -> 温度 -> top-k -> top-p）与
+// ONNX Runtime contrib的Sampling算子；top-k用SIMD阈值筛选代替整行排序：
+// 维护当前k个最大值的最小堆，SelectGreaterSIMD只返回大于堆顶的下标，堆填满后绝大多数向量一次比较即跳过
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+// top-k筛选每次处理的元素数，阈值在块之间更新
+constexpr size_t kSelectChunk = 4096;
+// 只有top_p时候选集的初始大小，累积概率不足top_p时按4倍扩大
+constexpr int64_t kNucleusInitialCandidates = 64;
+
+struct Candidate {
+    float logit;
+    uint32_t index;
+};
+
+// logit大的在前，相等时下标小的在前（与ArgMax取第一个最大值一致）
+inline bool Better(const Candidate& a, const Candidate& b) {
+    return a.logit > b.logit || (a.logit == b.logit && a.index < b.index);
+}
+
+int64_t ArgMaxRow(const float* x, int64_t n) {
+    const float max_val = simd::ReduceMaxSIMD(x, static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) {
+        if (x[i] == max_val) {
+            return i;
+        }
+    }
+    return 0;  // 全为NaN
+}
+
+// x中最大的k个元素，按Better排序
+void TopK(const float* x, int64_t n, int64_t k, std::vector<Candidate>* out, std::vector<uint32_t>* indices) {
+    out->clear();
+    const size_t count = static_cast<size_t>(n);
+    const size_t keep = static_cast<size_t>(std::min(k, n));
+    for (size_t i = 0; i < keep; ++i) {
+        out->push_back({x[i], static_cast<uint32_t>(i)});
+    }
+    if (keep < count) {
+        // 最小堆：堆顶是已选出的k个中最差的
+        std::make_heap(out->begin(), out->end(), Better);
+        indices->resize(std::min(kSelectChunk, count));
+        for (size_t begin = keep; begin < count; begin += kSelectChunk) {
+            const size_t length = std::min(kSelectChunk, count - begin);
+            const size_t selected = simd::SelectGreaterSIMD(x + begin, length, out->front().logit, indices->data());
+            for (size_t s = 0; s < selected; ++s) {
+                const uint32_t index = static_cast<uint32_t>(begin + (*indices)[s]);
+                if (x[index] > out->front().logit) {
+                    std::pop_heap(out->begin(), out->end(), Better);
+                    out->back() = {x[index], index};
+                    std::push_heap(out->begin(), out->end(), Better);
+                }
+            }
+        }
+    }
+    std::sort(out->begin(), out->end(), Better);
+}
+
+} // anonymous namespace
+
+// ArgMax算子（ONNX语义）
+// 输入：data；输出：INT64，沿axis取最大值的下标
+// 属性：axis（默认0）、keepdims（默认1）、select_last_index（默认0，相等时取第一个）
+class ArgMaxOperator : public Operator {
+public:
+    std::string GetName() const override { return "ArgMax"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 1 || inputs[0]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ArgMax requires one FLOAT32 input");
+        }
+        int64_t axis = 0;
+        return ResolveAxis(inputs[0]->GetShape(), &axis);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ArgMax requires an input");
+        }
+        int64_t axis = 0;
+        Status status = ResolveAxis(inputs[0]->GetShape(), &axis);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        if (GetIntAttribute("keepdims", 1) != 0) {
+            dims[static_cast<size_t>(axis)] = 1;
+        } else {
+            dims.erase(dims.begin() + axis);
+        }
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::INT64;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+        int64_t axis = 0;
+        ResolveAxis(inputs[0]->GetShape(), &axis);
+        int64_t outer = 1, inner = 1;
+        for (int64_t i = 0; i < axis; ++i) outer *= dims[i];
+        for (size_t i = static_cast<size_t>(axis) + 1; i < dims.size(); ++i) inner *= dims[i];
+        const int64_t n = dims[static_cast<size_t>(axis)];
+        const float* x = static_cast<const float*>(inputs[0]->GetData());
+        int64_t* y = static_cast<int64_t*>(outputs[0]->GetData());
+        const bool last = GetIntAttribute("select_last_index", 0) != 0;
+    
+        ParallelForOuter(ctx, outer, n * inner, [&](int64_t begin, int64_t end) {
+            for (int64_t o = begin; o < end; ++o) {
+                const float* block = x + o * n * inner;
+                if (inner == 1 && !last) {
+                    y[o] = ArgMaxRow(block, n);
+                    continue;
+                }
+                for (int64_t j = 0; j < inner; ++j) {
+                    int64_t best = 0;
+                    for (int64_t i = 1; i < n; ++i) {
+                        const float v = block[i * inner + j];
+                        const float b = block[best * inner + j];
+                        if (v > b || (last && v == b)) {
+                            best = i;
+                        }
+                    }
+                    y[o * inner + j] = best;
+                }
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    Status ResolveAxis(const Shape& shape, int64_t* axis) const {
+        const int64_t rank = static_cast<int64_t>(shape.dims.size());
+        *axis = GetIntAttribute("axis", 0);
+        if (*axis < 0) {
+            *axis += rank;
+        }
+        if (*axis < 0 || *axis >= rank || shape.dims[static_cast<size_t>(*axis)] <= 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ArgMax axis out of range");
+        }
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("ArgMax", ArgMaxOperator);
+
+// Sampling算子：对每个batch的最后一个位置的logits采样下一个token
+// 输入：logits [B, V]或[B, S, V]（FLOAT32）、past_tokens（可选，INT64 [B, N]，重复惩罚用，越界的id忽略）、
+//      uniform（可选，FLOAT32 [B]，[0, 1)的随机数；不给时由seed初始化的内部随机数发生器产生）
+// 输出：INT64 [B, 1]，可直接作为下一步的input_ids
+// 属性：temperature（默认1，<= 0为贪心）、top_k（默认0不限制）、top_p（默认1不限制）、
+//      repetition_penalty（默认1；出现过的token正logit除以、负logit乘以该值）、seed
+//
+// 只有温度时直接在整行上做exp并按下标顺序累积（不排序）；有top_k时只在筛选出的k个候选上归一化；
+// 只有top_p时在整行上归一化，候选集从64个开始扩大，直到累积概率达到top_p
+class SamplingOperator : public Operator {
+public:
+    std::string GetName() const override { return "Sampling"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty() || inputs.size() > 3) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Sampling requires logits, optional past_tokens and uniform");
+        }
+        const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+        if (inputs[0]->GetDataType() != DataType::FLOAT32 || dims.size() < 2 || dims.size() > 3 ||
+            dims.front() <= 0 || dims.back() <= 0 || (dims.size() == 3 && dims[1] <= 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Sampling logits must be FLOAT32 [B, V] or [B, S, V]");
+        }
+        const int64_t batch = dims.front();
+        if (inputs.size() > 1) {
+            const std::vector<int64_t>& past = inputs[1]->GetShape().dims;
+            if (inputs[1]->GetDataType() != DataType::INT64 || past.size() != 2 || past[0] != batch) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Sampling past_tokens must be INT64 [B, N]");
+            }
+        }
+        if (inputs.size() > 2 && (inputs[2]->GetDataType() != DataType::FLOAT32 ||
+                                  static_cast<int64_t>(inputs[2]->GetElementCount()) != batch)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Sampling uniform must be FLOAT32 [B]");
+        }
+        if (GetFloatAttribute("top_p", 1.0f) <= 0.0f || GetIntAttribute("top_k", 0) < 0 ||
+            GetFloatAttribute("repetition_penalty", 1.0f) <= 0.0f) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Sampling needs top_p > 0, top_k >= 0 and repetition_penalty > 0");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty() || inputs[0]->GetShape().dims.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Sampling requires logits");
+        }
+        output_shapes.push_back(Shape({inputs[0]->GetShape().dims.front(), 1}));
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::INT64;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+        const int64_t B = dims.front();
+        const int64_t V = dims.back();
+        const int64_t S = dims.size() == 3 ? dims[1] : 1;
+        const float* logits = static_cast<const float*>(inputs[0]->GetData());
+        int64_t* tokens = static_cast<int64_t*>(outputs[0]->GetData());
+    
+        const float temperature = GetFloatAttribute("temperature", 1.0f);
+        const float penalty = GetFloatAttribute("repetition_penalty", 1.0f);
+        const bool greedy = temperature <= 0.0f || GetIntAttribute("top_k", 0) == 1;
+        const Tensor* past = inputs.size() > 1 && penalty != 1.0f ? inputs[1] : nullptr;
+        const int64_t num_past = past ? past->GetShape().dims[1] : 0;
+    
+        // 随机数在并行之前按batch顺序取出，结果与线程数无关
+        std::vector<float> uniform(static_cast<size_t>(B), 0.0f);
+        if (inputs.size() > 2) {
+            const float* u = static_cast<const float*>(inputs[2]->GetData());
+            std::copy(u, u + B, uniform.begin());
+        } else if (!greedy) {
+            std::lock_guard<std::mutex> lock(rng_mutex_);
+            if (!rng_seeded_) {
+                rng_.seed(static_cast<uint64_t>(GetIntAttribute("seed", 0)));
+                rng_seeded_ = true;
+            }
+            std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+            for (float& u : uniform) {
+                u = distribution(rng_);
+            }
+        }
+    
+        ParallelForOuter(ctx, B, V, [&](int64_t begin, int64_t end) {
+            std::vector<float> penalized;
+            std::vector<float> scratch;
+            std::vector<Candidate> candidates;
+            std::vector<uint32_t> indices;
+            for (int64_t b = begin; b < end; ++b) {
+                const float* row = logits + (b * S + S - 1) * V;
+                if (past) {
+                    penalized.assign(row, row + V);
+                    const int64_t* ids = static_cast<const int64_t*>(past->GetData()) + b * num_past;
+                    for (int64_t i = 0; i < num_past; ++i) {
+                        if (ids[i] < 0 || ids[i] >= V) {
+                            continue;
+                        }
+                        float& logit = penalized[static_cast<size_t>(ids[i])];
+                        // 同一token出现多次只惩罚一次：以原值为准
+                        const float original = row[ids[i]];
+                        logit = original > 0.0f ? original / penalty : original * penalty;
+                    }
+                    row = penalized.data();
+                }
+                tokens[b] = greedy ? ArgMaxRow(row, V)
+                                   : SampleRow(row, V, temperature, uniform[static_cast<size_t>(b)],
+                                               &scratch, &candidates, &indices);
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    int64_t SampleRow(const float* row, int64_t V, float temperature, float u, std::vector<float>* scratch,
+                      std::vector<Candidate>* candidates, std::vector<uint32_t>* indices) const {
+        const int64_t top_k = std::min(GetIntAttribute("top_k", 0), V);
+        const float top_p = GetFloatAttribute("top_p", 1.0f);
+        const float inv_temperature = 1.0f / temperature;
+        const size_t count = static_cast<size_t>(V);
+    
+        // 整行的归一化常数：sum(exp((x - max) / T))，scratch中留下未归一化的概率
+        auto full_normalizer = [&]() {
+            scratch->resize(count);
+            simd::ScaleSIMD(row, scratch->data(), count, inv_temperature);
+            const float max_scaled = simd::ReduceMaxSIMD(scratch->data(), count);
+            return simd::ExpShiftSumSIMD(scratch->data(), scratch->data(), count, max_scaled);
+        };
+    
+        if (top_k == 0 && top_p >= 1.0f) {
+            const float total = full_normalizer();
+            const float target = u * total;
+            float cumulative = 0.0f;
+            for (size_t i = 0; i < count; ++i) {
+                cumulative += (*scratch)[i];
+                if (target < cumulative) {
+                    return static_cast<int64_t>(i);
+                }
+            }
+            return ArgMaxRow(row, V);  // 舍入误差
+        }
+    
+        // 候选集及其上的归一化常数（以最大的logit为基准）
+        float normalizer = 0.0f;
+        if (top_k > 0) {
+            TopK(row, V, top_k, candidates, indices);
+        } else {
+            const float total = full_normalizer();
+            for (int64_t k = std::min(kNucleusInitialCandidates, V);; k = std::min(k * 4, V)) {
+                TopK(row, V, k, candidates, indices);
+                float mass = 0.0f;
+                for (const Candidate& c : *candidates) {
+                    mass += std::exp((c.logit - candidates->front().logit) * inv_temperature);
+                }
+                if (mass >= top_p * total || k == V) {
+                    break;
+                }
+            }
+            normalizer = total;
+        }
+        const float max_logit = candidates->front().logit;
+        scratch->resize(candidates->size());
+        float kept_total = 0.0f;
+        for (size_t i = 0; i < candidates->size(); ++i) {
+            (*scratch)[i] = std::exp(((*candidates)[i].logit - max_logit) * inv_temperature);
+            kept_total += (*scratch)[i];
+        }
+        if (top_k > 0) {
+            normalizer = kept_total;
+        }
+    
+        // nucleus：概率从大到小累积到top_p为止（至少保留一个）
+        size_t kept = candidates->size();
+        if (top_p < 1.0f) {
+            const float threshold = top_p * normalizer;
+            float cumulative = 0.0f;
+            for (size_t i = 0; i < candidates->size(); ++i) {
+                cumulative += (*scratch)[i];
+                if (cumulative >= threshold) {
+                    kept = i + 1;
+                    break;
+                }
+            }
+            kept_total = 0.0f;
+            for (size_t i = 0; i < kept; ++i) {
+                kept_total += (*scratch)[i];
+            }
+        }
+        const float target = u * kept_total;
+        float cumulative = 0.0f;
+        for (size_t i = 0; i < kept; ++i) {
+            cumulative += (*scratch)[i];
+            if (target < cumulative) {
+                return (*candidates)[i].index;
+            }
+        }
+        return (*candidates)[kept - 1].index;
+    }
+    
+    std::mutex rng_mutex_;
+    std::mt19937_64 rng_;
+    bool rng_seeded_ = false;
+};
+
+REGISTER_OPERATOR("Sampling", SamplingOperator);
+
+} // namespace operators
+} // namespace inferunity
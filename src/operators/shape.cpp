@@ -3,6 +3,11 @@
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "inferunity/embedding_store.h"
+#include "gather_kernels.h"
+#include "transpose_kernels.h"
+#include "simd_utils.h"
+#include "parallel_utils.h"
 #include <algorithm>
 #include <numeric>
 #include <cstring>
@@ -29,26 +34,31 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, 
                                "Reshape requires at least 2 inputs");
         }
-        
+    
         const Shape& input_shape = inputs[0]->GetShape();
         Tensor* shape_tensor = inputs[1];
-        
+    
         // 从shape tensor获取目标形状
         if (shape_tensor->GetDataType() != DataType::INT64) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Shape tensor must be INT64");
         }
-        
+    
         const int64_t* shape_data = static_cast<const int64_t*>(shape_tensor->GetData());
+        if (!shape_data) {
+            // 加载期形状推断时目标形状由上游算子计算，值未知
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Reshape target shape is not a constant");
+        }
         size_t shape_size = shape_tensor->GetElementCount();
-        
+    
         std::vector<int64_t> target_shape(shape_data, shape_data + shape_size);
-        
+    
         // 处理-1维度（自动推断）
         int64_t total_elements = input_shape.GetElementCount();
         int64_t known_elements = 1;
         int unknown_dim = -1;
-        
+    
         for (size_t i = 0; i < target_shape.size(); ++i) {
             if (target_shape[i] == -1) {
                 if (unknown_dim != -1) {
@@ -60,7 +70,7 @@ public:
                 known_elements *= target_shape[i];
             }
         }
-        
+    
         if (unknown_dim != -1) {
             if (known_elements == 0 || total_elements % known_elements != 0) {
                 return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
@@ -68,18 +78,18 @@ public:
             }
             target_shape[unknown_dim] = total_elements / known_elements;
         }
-        
+    
         // 验证元素总数
         int64_t new_total = 1;
         for (int64_t dim : target_shape) {
             new_total *= dim;
         }
-        
+    
         if (new_total != total_elements) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Shape mismatch: total elements don't match");
         }
-        
+    
         output_shapes.push_back(Shape(target_shape));
         return Status::Ok();
     }
@@ -90,25 +100,38 @@ public:
         if (inputs.size() < 2 || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         // Reshape只是改变视图，不复制数据
         // 实际实现中，Tensor应该支持视图（共享内存）
         Tensor* input = inputs[0];
         Tensor* output = outputs[0];
-        
+    
         // 验证元素总数
         if (input->GetElementCount() != output->GetElementCount()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Element count mismatch");
         }
-        
-        // 如果支持视图，直接共享内存
-        // 否则需要复制数据（简化实现）
+    
+        // 执行计划中的视图步骤不会走到这里；输出已单独分配（如绑定了输出缓冲）时拷贝
         size_t size = input->GetSizeInBytes();
         std::memcpy(output->GetData(), input->GetData(), size);
-        
+    
         return Status::Ok();
     }
+    
+    bool IsViewOperator() const override { return true; }
+    
+    // 连续的输入换个形状即可共享存储；非连续的输入按行主序重新解释需要拷贝
+    std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const override {
+        if (inputs.size() < 2 || !inputs[0] || !inputs[1] || !inputs[0]->IsContiguous()) {
+            return nullptr;
+        }
+        std::vector<Shape> output_shapes;
+        if (!InferOutputShape({inputs[0].get(), inputs[1].get()}, output_shapes).IsOk() || output_shapes.empty()) {
+            return nullptr;
+        }
+        return CreateStridedView(inputs[0], output_shapes[0], {});
+    }
 };
 
 // Concat算子
@@ -129,22 +152,25 @@ public:
         if (inputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
         }
-        
+    
         // 获取axis属性（默认axis=0）
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
-        
+    
         const Shape& first_shape = inputs[0]->GetShape();
+        if (axis < 0) {
+            axis += static_cast<int>(first_shape.dims.size());
+        }
         if (axis < 0 || axis >= static_cast<int>(first_shape.dims.size())) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid axis");
         }
-        
+    
         std::vector<int64_t> output_dims = first_shape.dims;
         int64_t concat_dim = first_shape.dims[axis];
-        
+    
         // 验证所有输入形状（除了axis维度）都相同
         for (size_t i = 1; i < inputs.size(); ++i) {
             const Shape& shape = inputs[i]->GetShape();
@@ -152,17 +178,17 @@ public:
                 return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                    "Shape rank mismatch");
             }
-            
+    
             for (int j = 0; j < static_cast<int>(shape.dims.size()); ++j) {
                 if (j != axis && shape.dims[j] != first_shape.dims[j]) {
                     return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                        "Shape mismatch");
                 }
             }
-            
+    
             concat_dim += shape.dims[axis];
         }
-        
+    
         output_dims[axis] = concat_dim;
         output_shapes.push_back(Shape(output_dims));
         return Status::Ok();
@@ -174,52 +200,60 @@ public:
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
+    
         Tensor* output = outputs[0];
         const Shape& output_shape = output->GetShape();
-        
-        // 计算每个输入在axis维度上的大小
+        if (axis < 0) {
+            axis += static_cast<int>(output_shape.dims.size());
+        }
+        if (axis < 0 || axis >= static_cast<int>(output_shape.dims.size())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid axis");
+        }
+    
+        // 按字节拼接，与数据类型无关；outer为axis之前各维的乘积，inner为axis之后每个切片的字节数
         size_t element_size = GetDataTypeSize(inputs[0]->GetDataType());
-        size_t axis_stride = element_size;
+        size_t outer = 1;
+        for (int i = 0; i < axis; ++i) {
+            outer *= static_cast<size_t>(output_shape.dims[i]);
+        }
+        size_t inner_bytes = element_size;
         for (int i = static_cast<int>(output_shape.dims.size()) - 1; i > axis; --i) {
-            axis_stride *= output_shape.dims[i];
+            inner_bytes *= static_cast<size_t>(output_shape.dims[i]);
         }
-        
-        size_t axis_size = output_shape.dims[axis];
-        size_t axis_offset = 0;
-        
-        // 拼接数据
+    
+        const size_t output_row_bytes = static_cast<size_t>(output_shape.dims[axis]) * inner_bytes;
         uint8_t* output_data = static_cast<uint8_t*>(output->GetData());
-        
+        size_t row_offset = 0;
         for (Tensor* input : inputs) {
-            size_t input_axis_size = input->GetShape().dims[axis];
-            size_t input_size = input_axis_size * axis_stride;
-            
-            for (size_t i = 0; i < axis_stride / element_size; ++i) {
-                size_t src_offset = i * input_axis_size * element_size;
-                size_t dst_offset = (i * axis_size + axis_offset) * element_size;
-                
-                std::memcpy(output_data + dst_offset,
-                           static_cast<uint8_t*>(input->GetData()) + src_offset,
-                           input_axis_size * element_size);
+            const size_t input_row_bytes = static_cast<size_t>(input->GetShape().dims[axis]) * inner_bytes;
+            const uint8_t* input_data = static_cast<const uint8_t*>(input->GetData());
+            // 内存规划把输入放在了输出的对应切片上（见GetSliceAlias）时数据已经就位
+            if (outer != 1 || input_data != output_data + row_offset) {
+                for (size_t o = 0; o < outer; ++o) {
+                    std::memcpy(output_data + o * output_row_bytes + row_offset,
+                               input_data + o * input_row_bytes, input_row_bytes);
+                }
             }
-            
-            axis_offset += input_axis_size;
+            row_offset += input_row_bytes;
         }
-        
+    
         return Status::Ok();
     }
     
+    SliceAlias GetSliceAlias() const override { return SliceAlias::INPUTS_IN_OUTPUT; }
+
 private:
     size_t GetDataTypeSize(DataType dtype) {
         switch (dtype) {
             case DataType::FLOAT32: return 4;
             case DataType::FLOAT16: return 2;
+            case DataType::BFLOAT16: return 2;
             case DataType::INT32: return 4;
             case DataType::INT64: return 8;
             case DataType::INT8: return 1;
@@ -247,32 +281,35 @@ public:
         if (inputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
         }
-        
+    
         // 从属性获取split和axis
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
-        
+    
         std::vector<int64_t> splits;
         auto split_attr = GetAttribute("split");
         if (split_attr.GetType() == AttributeValue::Type::INTS) {
             splits = split_attr.GetInts();
         }
-        
+    
         const Shape& input_shape = inputs[0]->GetShape();
+        if (axis < 0) {
+            axis += static_cast<int>(input_shape.dims.size());
+        }
         if (axis < 0 || axis >= static_cast<int>(input_shape.dims.size())) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid axis");
         }
-        
+    
         // 如果没有指定splits，平均分割
         if (splits.empty()) {
             // 默认分割为2个相等的部分
             int64_t dim_size = input_shape.dims[axis];
             splits = {dim_size / 2, dim_size - dim_size / 2};
         }
-        
+    
         // 验证splits总和
         int64_t total = 0;
         for (int64_t s : splits) {
@@ -282,14 +319,14 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Split sizes don't match axis dimension");
         }
-        
+    
         // 为每个split创建输出形状
         for (int64_t split_size : splits) {
             std::vector<int64_t> output_dims = input_shape.dims;
             output_dims[axis] = split_size;
             output_shapes.push_back(Shape(output_dims));
         }
-        
+    
         return Status::Ok();
     }
     
@@ -299,73 +336,78 @@ public:
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         // 从属性获取axis和splits
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
-        
+    
         std::vector<int64_t> splits;
         auto split_attr = GetAttribute("split");
         if (split_attr.GetType() == AttributeValue::Type::INTS) {
             splits = split_attr.GetInts();
         }
-        
+    
         Tensor* input = inputs[0];
         const Shape& input_shape = input->GetShape();
-        
+        if (axis < 0) {
+            axis += static_cast<int>(input_shape.dims.size());
+        }
+        if (axis < 0 || axis >= static_cast<int>(input_shape.dims.size())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid axis");
+        }
+    
         // 如果没有指定splits，平均分割
         if (splits.empty()) {
             int64_t dim_size = input_shape.dims[axis];
             int64_t num_outputs = outputs.size();
             int64_t base_size = dim_size / num_outputs;
             int64_t remainder = dim_size % num_outputs;
-            
+    
             for (int64_t i = 0; i < num_outputs; ++i) {
                 splits.push_back(base_size + (i < remainder ? 1 : 0));
             }
         }
-        
+    
         // 验证splits数量
         if (splits.size() != outputs.size()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Split sizes don't match output count");
         }
-        
-        // 计算每个输出在axis维度上的大小
+    
+        // 按字节切分：outer为axis之前各维的乘积，inner为axis之后每个切片的字节数
         size_t element_size = Tensor::GetDataTypeSize(input->GetDataType());
-        size_t axis_stride = element_size;
+        size_t outer = 1;
+        for (int i = 0; i < axis; ++i) {
+            outer *= static_cast<size_t>(input_shape.dims[i]);
+        }
+        size_t inner_bytes = element_size;
         for (int i = static_cast<int>(input_shape.dims.size()) - 1; i > axis; --i) {
-            axis_stride *= input_shape.dims[i];
+            inner_bytes *= static_cast<size_t>(input_shape.dims[i]);
         }
-        
-        size_t axis_offset = 0;
+    
+        const size_t input_row_bytes = static_cast<size_t>(input_shape.dims[axis]) * inner_bytes;
         const uint8_t* input_data = static_cast<const uint8_t*>(input->GetData());
-        
-        // 分割数据到各个输出
+        size_t row_offset = 0;
         for (size_t i = 0; i < outputs.size(); ++i) {
-            Tensor* output = outputs[i];
-            size_t output_axis_size = splits[i];
-            size_t output_size = output_axis_size * axis_stride;
-            
-            uint8_t* output_data = static_cast<uint8_t*>(output->GetData());
-            
-            for (size_t j = 0; j < axis_stride / element_size; ++j) {
-                size_t src_offset = (j * input_shape.dims[axis] + axis_offset) * element_size;
-                size_t dst_offset = j * output_axis_size * element_size;
-                
-                std::memcpy(output_data + dst_offset,
-                           input_data + src_offset,
-                           output_axis_size * element_size);
-            }
-            
-            axis_offset += output_axis_size;
-        }
-        
+            const size_t output_row_bytes = static_cast<size_t>(splits[i]) * inner_bytes;
+            uint8_t* output_data = static_cast<uint8_t*>(outputs[i]->GetData());
+            // 内存规划把输出放在了输入的对应切片上（见GetSliceAlias）时数据已经就位
+            if (outer != 1 || output_data != input_data + row_offset) {
+                for (size_t o = 0; o < outer; ++o) {
+                    std::memcpy(output_data + o * output_row_bytes,
+                               input_data + o * input_row_bytes + row_offset, output_row_bytes);
+                }
+            }
+            row_offset += output_row_bytes;
+        }
+    
         return Status::Ok();
     }
+    
+    SliceAlias GetSliceAlias() const override { return SliceAlias::OUTPUTS_IN_INPUT; }
 };
 
 // Transpose算子
@@ -386,28 +428,28 @@ public:
         if (inputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No inputs");
         }
-        
+    
         const Shape& input_shape = inputs[0]->GetShape();
         std::vector<int64_t> perm;
-        
+    
         // 从属性获取perm，如果没有则默认反转
         auto perm_attr = GetAttribute("perm");
         if (perm_attr.GetType() == AttributeValue::Type::INTS) {
             perm = perm_attr.GetInts();
         }
-        
+    
         if (perm.empty()) {
             perm.resize(input_shape.dims.size());
             for (size_t i = 0; i < perm.size(); ++i) {
                 perm[i] = static_cast<int64_t>(perm.size() - 1 - i);
             }
         }
-        
+    
         if (perm.size() != input_shape.dims.size()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Perm size mismatch");
         }
-        
+    
         std::vector<int64_t> output_dims(perm.size());
         for (size_t i = 0; i < perm.size(); ++i) {
             if (perm[i] < 0 || perm[i] >= static_cast<int64_t>(input_shape.dims.size())) {
@@ -416,7 +458,7 @@ public:
             }
             output_dims[i] = input_shape.dims[perm[i]];
         }
-        
+    
         output_shapes.push_back(Shape(output_dims));
         return Status::Ok();
     }
@@ -427,76 +469,77 @@ public:
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         Tensor* input = inputs[0];
         Tensor* output = outputs[0];
-        
-        // 实现通用的转置操作（支持任意维度）
+    
         const Shape& input_shape = input->GetShape();
-        const float* in_data = static_cast<const float*>(input->GetData());
-        float* out_data = static_cast<float*>(output->GetData());
-        
+        const size_t rank = input_shape.dims.size();
+    
         // 获取perm属性
         std::vector<int64_t> perm;
         auto perm_attr = GetAttribute("perm");
         if (perm_attr.GetType() == AttributeValue::Type::INTS) {
             perm = perm_attr.GetInts();
         }
-        
+    
         if (perm.empty()) {
             // 默认反转所有维度
-            perm.resize(input_shape.dims.size());
+            perm.resize(rank);
             for (size_t i = 0; i < perm.size(); ++i) {
                 perm[i] = static_cast<int64_t>(perm.size() - 1 - i);
             }
         }
-        
-        // 计算输入和输出的步长
-        std::vector<int64_t> input_strides(input_shape.dims.size());
-        std::vector<int64_t> output_strides(input_shape.dims.size());
-        
-        int64_t input_stride = 1;
-        int64_t output_stride = 1;
-        for (int i = static_cast<int>(input_shape.dims.size()) - 1; i >= 0; --i) {
-            input_strides[i] = input_stride;
-            input_stride *= input_shape.dims[i];
-            
-            int64_t output_dim = input_shape.dims[perm[i]];
-            output_strides[perm[i]] = output_stride;
-            output_stride *= output_dim;
-        }
-        
-        // 计算输出步长（按perm顺序）
-        std::vector<int64_t> perm_output_strides(input_shape.dims.size());
-        for (size_t i = 0; i < perm.size(); ++i) {
-            perm_output_strides[i] = input_strides[perm[i]];
+    
+        if (perm.size() != rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Perm size mismatch");
         }
-        
-        // 转置数据
-        int64_t total_elements = input_shape.GetElementCount();
-        std::vector<int64_t> indices(input_shape.dims.size(), 0);
-        
-        for (int64_t flat_idx = 0; flat_idx < total_elements; ++flat_idx) {
-            // 计算输入索引
-            int64_t input_idx = 0;
-            int64_t temp = flat_idx;
-            for (int i = static_cast<int>(input_shape.dims.size()) - 1; i >= 0; --i) {
-                indices[i] = temp % input_shape.dims[i];
-                temp /= input_shape.dims[i];
-                input_idx += indices[i] * input_strides[i];
-            }
-            
-            // 计算输出索引（按perm重新排列）
-            int64_t output_idx = 0;
-            for (size_t i = 0; i < perm.size(); ++i) {
-                output_idx += indices[perm[i]] * perm_output_strides[i];
+        std::vector<bool> seen(rank, false);
+        for (int64_t p : perm) {
+            if (p < 0 || p >= static_cast<int64_t>(rank) || seen[p]) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid perm value");
             }
-            
-            out_data[output_idx] = in_data[input_idx];
+            seen[p] = true;
         }
-        
+    
+        TransposeTensor(input->GetData(), input_shape.dims, perm,
+                        GetDataTypeSize(input->GetDataType()), output->GetData(), ctx);
+    
         return Status::Ok();
     }
+    
+    bool IsViewOperator() const override { return true; }
+    
+    // 输出第i维取输入第perm[i]维的长度与步长，不移动数据
+    std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const override {
+        if (inputs.empty() || !inputs[0]) {
+            return nullptr;
+        }
+        std::vector<Shape> output_shapes;
+        if (!InferOutputShape({inputs[0].get()}, output_shapes).IsOk() || output_shapes.empty()) {
+            return nullptr;
+        }
+    
+        const size_t rank = inputs[0]->GetShape().dims.size();
+        std::vector<int64_t> perm;
+        auto perm_attr = GetAttribute("perm");
+        if (perm_attr.GetType() == AttributeValue::Type::INTS) {
+            perm = perm_attr.GetInts();
+        }
+        if (perm.empty()) {
+            perm.resize(rank);
+            for (size_t i = 0; i < rank; ++i) {
+                perm[i] = static_cast<int64_t>(rank - 1 - i);
+            }
+        }
+    
+        const std::vector<int64_t> input_strides = inputs[0]->GetStrides();
+        std::vector<int64_t> strides(rank);
+        for (size_t i = 0; i < rank; ++i) {
+            strides[i] = input_strides[perm[i]];
+        }
+        return CreateStridedView(inputs[0], output_shapes[0], strides);
+    }
 };
 
 // 注册算子（在命名空间内）
@@ -519,26 +562,26 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Gather requires at least 2 inputs");
         }
-        
+    
         const Shape& data_shape = inputs[0]->GetShape();
         const Shape& indices_shape = inputs[1]->GetShape();
-        
+    
         // 获取axis属性（默认为0）
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
-        
+    
         if (axis < 0) {
             axis += static_cast<int>(data_shape.dims.size());
         }
-        
+    
         if (axis < 0 || axis >= static_cast<int>(data_shape.dims.size())) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Invalid axis for Gather");
         }
-        
+    
         // 输出形状 = data_shape的前axis维 + indices_shape + data_shape的后(rank-axis-1)维
         Shape output_shape;
         for (int i = 0; i < axis; ++i) {
@@ -550,7 +593,7 @@ public:
         for (size_t i = axis + 1; i < data_shape.dims.size(); ++i) {
             output_shape.dims.push_back(data_shape.dims[i]);
         }
-        
+    
         output_shapes.push_back(output_shape);
         return Status::Ok();
     }
@@ -562,62 +605,78 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Gather requires at least 2 inputs and 1 output");
         }
-        
+    
         Tensor* data = inputs[0];
         Tensor* indices = inputs[1];
         Tensor* output = outputs[0];
-        
+    
         const Shape& data_shape = data->GetShape();
         const Shape& indices_shape = indices->GetShape();
-        const Shape& output_shape = output->GetShape();
-        
+    
         // 获取axis属性（默认为0）
         int axis = 0;
         auto axis_attr = GetAttribute("axis");
         if (axis_attr.GetType() == AttributeValue::Type::INT) {
             axis = static_cast<int>(axis_attr.GetInt());
         }
-        
+    
         // 支持任意axis（通用实现）
         if (axis < 0) {
             axis += static_cast<int>(data_shape.dims.size());
         }
-        
+    
         if (axis < 0 || axis >= static_cast<int>(data_shape.dims.size())) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Gather axis out of range");
         }
-        
-        const float* data_ptr = static_cast<const float*>(data->GetData());
-        const int64_t* indices_ptr = static_cast<const int64_t*>(indices->GetData());
-        float* output_ptr = static_cast<float*>(output->GetData());
-        // indices_shape和output_shape已在上面定义
-        
-        // 计算每个元素的大小（axis之后的维度）
-        size_t element_size = 1;
+    
+        // 按字节复制，与数据类型无关（常量折叠中常见INT64形状向量的Gather）
+        // outer为axis之前各维的乘积，row_bytes为axis之后一个切片的字节数
+        GatherRowsParams params;
+        params.table = data->GetData();
+        for (int i = 0; i < axis; ++i) {
+            params.outer *= data_shape.dims[i];
+        }
+        params.num_rows = data_shape.dims[axis];
+        params.row_bytes = Tensor::GetDataTypeSize(data->GetDataType());
         for (size_t i = axis + 1; i < data_shape.dims.size(); ++i) {
-            element_size *= data_shape.dims[i];
-        }
-        
-        // 计算stride
-        size_t stride = element_size * data_shape.dims[axis];
-        
-        // 执行Gather
-        size_t indices_count = indices_shape.GetElementCount();
-        for (size_t i = 0; i < indices_count; ++i) {
-            int64_t idx = indices_ptr[i];
-            if (idx < 0 || idx >= data_shape.dims[axis]) {
-                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                                   "Gather index out of range");
-            }
-            
-            const float* src = data_ptr + idx * stride;
-            float* dst = output_ptr + i * element_size;
-            std::memcpy(dst, src, element_size * sizeof(float));
+            params.row_bytes *= static_cast<size_t>(data_shape.dims[i]);
         }
-        
-        return Status::Ok();
+        params.indices = indices->GetData();
+        params.index_type = indices->GetDataType();
+        params.index_count = indices_shape.GetElementCount();
+        params.output = output->GetData();
+        params.deduplicate = GetIntAttribute("deduplicate", 0) != 0;
+        if (store_ && params.table == store_table_ && axis == 0) {
+            params.store = store_.get();
+        }
+        return GatherRows(params, ctx);
     }
+    
+    // 会话设置了hot_row_cache_rows时，按第0轴收集的大常量表改从分层存储读行（见TieredEmbeddingStore）
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        const Shape& shape = tensor.GetShape();
+        const int64_t axis = GetIntAttribute("axis", 0);
+        if (input_index != 0 || shape.dims.empty() || (axis != 0 && axis != -static_cast<int64_t>(shape.dims.size()))) {
+            return Status::Ok();
+        }
+        size_t row_bytes = Tensor::GetDataTypeSize(tensor.GetDataType());
+        for (size_t i = 1; i < shape.dims.size(); ++i) {
+            row_bytes *= static_cast<size_t>(shape.dims[i]);
+        }
+        Status status = OpenTieredEmbeddingStore(tensor, shape.dims[0], row_bytes,
+                                                 GetIntAttribute("hot_row_cache_rows", 0), &store_);
+        store_table_ = store_ ? tensor.GetData() : nullptr;
+        *is_packed = store_ != nullptr;
+        return status;
+    }
+
+private:
+    std::unique_ptr<TieredEmbeddingStore> store_;
+    const void* store_table_ = nullptr;
 };
 
 // Slice算子 - 从输入张量中切片
@@ -639,20 +698,20 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Slice requires at least 1 input");
         }
-        
+    
         const Shape& input_shape = inputs[0]->GetShape();
         int rank = static_cast<int>(input_shape.dims.size());
-        
+    
         // 获取starts, ends, axes, steps属性
         // 支持从属性或输入tensor获取（ONNX Slice格式）
         std::vector<int64_t> starts, ends, axes, steps;
-        
+    
         // 尝试从属性获取
         auto starts_attr = GetAttribute("starts");
         auto ends_attr = GetAttribute("ends");
         auto axes_attr = GetAttribute("axes");
         auto steps_attr = GetAttribute("steps");
-        
+    
         if (starts_attr.GetType() == AttributeValue::Type::INTS) {
             starts = starts_attr.GetInts();
         }
@@ -665,8 +724,14 @@ public:
         if (steps_attr.GetType() == AttributeValue::Type::INTS) {
             steps = steps_attr.GetInts();
         }
-        
+    
         // 如果属性中没有，尝试从输入tensor获取（ONNX Slice可以有starts/ends/axes/steps作为输入）
+        for (size_t i = 1; i < inputs.size(); ++i) {
+            if (!inputs[i]->GetData()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Slice parameters are not constants");
+            }
+        }
         if (starts.empty() && inputs.size() >= 2) {
             Tensor* starts_tensor = inputs[1];
             if (starts_tensor->GetDataType() == DataType::INT64) {
@@ -683,25 +748,25 @@ public:
                 ends.assign(data, data + count);
             }
         }
-        
+    
         // 如果没有指定axes，默认对所有维度切片
         if (axes.empty()) {
             for (int i = 0; i < rank; ++i) {
                 axes.push_back(i);
             }
         }
-        
+    
         // 如果没有指定steps，默认为1
         if (steps.empty()) {
             steps.assign(axes.size(), 1);
         }
-        
+    
         // 验证参数
         if (starts.size() != axes.size() || ends.size() != axes.size()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Slice: starts, ends, and axes must have the same size");
         }
-        
+    
         // 计算输出形状
         Shape output_shape = input_shape;
         for (size_t i = 0; i < axes.size(); ++i) {
@@ -711,20 +776,20 @@ public:
                 return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                    "Slice: invalid axis");
             }
-            
+    
             int64_t dim_size = input_shape.dims[axis];
             int64_t start = starts[i];
             int64_t end = ends[i];
             int64_t step = steps[i];
-            
+    
             // 处理负数索引
             if (start < 0) start += dim_size;
             if (end < 0) end += dim_size;
-            
+    
             // 限制范围
-            start = std::max(0LL, std::min(start, dim_size));
-            end = std::max(0LL, std::min(end, dim_size));
-            
+            start = std::max<int64_t>(0, std::min(start, dim_size));
+            end = std::max<int64_t>(0, std::min(end, dim_size));
+    
             // 计算输出维度
             if (step > 0) {
                 output_shape.dims[axis] = (end - start + step - 1) / step;
@@ -734,10 +799,10 @@ public:
                 return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                    "Slice: step cannot be zero");
             }
-            
-            output_shape.dims[axis] = std::max(0LL, output_shape.dims[axis]);
+    
+            output_shape.dims[axis] = std::max<int64_t>(0, output_shape.dims[axis]);
         }
-        
+    
         output_shapes.push_back(output_shape);
         return Status::Ok();
     }
@@ -749,22 +814,22 @@ public:
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                                "Slice requires at least 1 input and 1 output");
         }
-        
+    
         Tensor* input = inputs[0];
         Tensor* output = outputs[0];
-        
+    
         const Shape& input_shape = input->GetShape();
         const Shape& output_shape = output->GetShape();
         int rank = static_cast<int>(input_shape.dims.size());
-        
+    
         // 获取切片参数（与InferOutputShape相同的逻辑）
         std::vector<int64_t> starts, ends, axes, steps;
-        
+    
         auto starts_attr = GetAttribute("starts");
         auto ends_attr = GetAttribute("ends");
         auto axes_attr = GetAttribute("axes");
         auto steps_attr = GetAttribute("steps");
-        
+    
         if (starts_attr.GetType() == AttributeValue::Type::INTS) {
             starts = starts_attr.GetInts();
         }
@@ -777,7 +842,7 @@ public:
         if (steps_attr.GetType() == AttributeValue::Type::INTS) {
             steps = steps_attr.GetInts();
         }
-        
+    
         // 从输入tensor获取（如果属性中没有）
         if (starts.empty() && inputs.size() >= 2) {
             Tensor* starts_tensor = inputs[1];
@@ -795,7 +860,7 @@ public:
                 ends.assign(data, data + count);
             }
         }
-        
+    
         if (axes.empty()) {
             for (int i = 0; i < rank; ++i) {
                 axes.push_back(i);
@@ -804,7 +869,7 @@ public:
         if (steps.empty()) {
             steps.assign(axes.size(), 1);
         }
-        
+    
         // 如果形状匹配且没有切片，直接拷贝
         if (input_shape.dims == output_shape.dims && 
             std::all_of(steps.begin(), steps.end(), [](int64_t s) { return s == 1; }) &&
@@ -820,31 +885,31 @@ public:
                 return input->CopyTo(*output);
             }
         }
-        
+    
         // 实现完整的切片逻辑
         // 使用Tensor::Slice方法（如果可能）或手动实现
         // 简化实现：对于简单情况使用Tensor::Slice，复杂情况手动实现
-        
+    
         // 检查是否可以使用Tensor::Slice（单维度切片，step=1）
         if (axes.size() == 1 && steps[0] == 1) {
             int axis = static_cast<int>(axes[0]);
             if (axis < 0) axis += rank;
-            
+    
             // 构建starts和ends向量（只对指定axis切片）
             std::vector<int64_t> slice_starts(rank, 0);
             std::vector<int64_t> slice_ends = input_shape.dims;
             slice_starts[axis] = starts[0];
             slice_ends[axis] = ends[0];
-            
+    
             Tensor sliced = input->Slice(slice_starts, slice_ends);
             return sliced.CopyTo(*output);
         }
-        
+    
         // 通用实现：手动切片
         // 这里实现一个通用的切片逻辑
         const float* input_data = static_cast<const float*>(input->GetData());
         float* output_data = static_cast<float*>(output->GetData());
-        
+    
         // 计算输入和输出的strides
         std::vector<size_t> input_strides(rank);
         std::vector<size_t> output_strides(rank);
@@ -854,12 +919,12 @@ public:
             input_strides[i] = input_strides[i + 1] * input_shape.dims[i + 1];
             output_strides[i] = output_strides[i + 1] * output_shape.dims[i + 1];
         }
-        
+    
         // 构建切片映射
         std::vector<int64_t> slice_starts(rank, 0);
         std::vector<int64_t> slice_ends = input_shape.dims;
         std::vector<int64_t> slice_steps(rank, 1);
-        
+    
         for (size_t i = 0; i < axes.size(); ++i) {
             int axis = static_cast<int>(axes[i]);
             if (axis < 0) axis += rank;
@@ -867,7 +932,7 @@ public:
             slice_ends[axis] = ends[i];
             slice_steps[axis] = steps[i];
         }
-        
+    
         // 递归切片（使用迭代方式）
         std::function<void(const std::vector<int64_t>&, size_t)> slice_recursive;
         slice_recursive = [&](const std::vector<int64_t>& indices, size_t dim) {
@@ -882,11 +947,11 @@ public:
                 output_data[output_idx] = input_data[input_idx];
                 return;
             }
-            
+    
             int64_t start = slice_starts[dim];
             int64_t end = slice_ends[dim];
             int64_t step = slice_steps[dim];
-            
+    
             if (step > 0) {
                 for (int64_t i = start; i < end; i += step) {
                     std::vector<int64_t> new_indices = indices;
@@ -901,115 +966,1076 @@ public:
                 }
             }
         };
-        
+    
         slice_recursive({}, 0);
-        
+    
         return Status::Ok();
     }
+    
+    bool IsViewOperator() const override { return true; }
+    
+    // 正步长的切片是输入上的步长视图：起点移到各轴的start，步长乘以step；负步长仍走Execute
+    std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const override {
+        if (inputs.empty() || inputs.size() > 3 || !inputs[0]) {
+            return nullptr;
+        }
+        std::vector<Tensor*> raw;
+        for (const auto& input : inputs) {
+            if (!input) {
+                return nullptr;
+            }
+            raw.push_back(input.get());
+        }
+        std::vector<Shape> output_shapes;
+        if (!InferOutputShape(raw, output_shapes).IsOk() || output_shapes.empty()) {
+            return nullptr;
+        }
+    
+        // 与InferOutputShape相同的参数来源：属性优先，其次是starts/ends输入
+        const Shape& input_shape = inputs[0]->GetShape();
+        const int rank = static_cast<int>(input_shape.dims.size());
+        std::vector<int64_t> starts, axes, steps;
+        auto starts_attr = GetAttribute("starts");
+        auto axes_attr = GetAttribute("axes");
+        auto steps_attr = GetAttribute("steps");
+        if (starts_attr.GetType() == AttributeValue::Type::INTS) {
+            starts = starts_attr.GetInts();
+        }
+        if (axes_attr.GetType() == AttributeValue::Type::INTS) {
+            axes = axes_attr.GetInts();
+        }
+        if (steps_attr.GetType() == AttributeValue::Type::INTS) {
+            steps = steps_attr.GetInts();
+        }
+        if (starts.empty() && inputs.size() >= 2 && inputs[1]->GetDataType() == DataType::INT64) {
+            const int64_t* data = static_cast<const int64_t*>(inputs[1]->GetData());
+            starts.assign(data, data + inputs[1]->GetElementCount());
+        }
+        if (axes.empty()) {
+            for (int i = 0; i < rank; ++i) {
+                axes.push_back(i);
+            }
+        }
+        if (steps.empty()) {
+            steps.assign(axes.size(), 1);
+        }
+        if (starts.size() != axes.size() || steps.size() != axes.size()) {
+            return nullptr;
+        }
+    
+        const std::vector<int64_t> input_strides = inputs[0]->GetStrides();
+        std::vector<int64_t> strides = input_strides;
+        int64_t offset = 0;
+        for (size_t i = 0; i < axes.size(); ++i) {
+            int axis = static_cast<int>(axes[i]);
+            if (axis < 0) axis += rank;
+            if (steps[i] <= 0) {
+                return nullptr;
+            }
+            const int64_t dim_size = input_shape.dims[axis];
+            int64_t start = starts[i] < 0 ? starts[i] + dim_size : starts[i];
+            start = std::max<int64_t>(0, std::min(start, dim_size));
+            if (output_shapes[0].dims[axis] > 0) {
+                offset += start * input_strides[axis];
+            }
+            strides[axis] = input_strides[axis] * steps[i];
+        }
+        return CreateStridedView(inputs[0], output_shapes[0], strides, offset);
+    }
 };
 
-REGISTER_OPERATOR("Reshape", ReshapeOperator);
-REGISTER_OPERATOR("Concat", ConcatOperator);
-REGISTER_OPERATOR("Split", SplitOperator);
-REGISTER_OPERATOR("Transpose", TransposeOperator);
-REGISTER_OPERATOR("Gather", GatherOperator);
-REGISTER_OPERATOR("Slice", SliceOperator);
-
-// Embedding算子 - 词嵌入（Transformer模型必需）
-// Embedding(input_ids, weight) -> embeddings
-// input_ids: [batch_size, seq_len] (INT64)
-// weight: [vocab_size, embedding_dim] (FLOAT)
-// output: [batch_size, seq_len, embedding_dim] (FLOAT)
-class EmbeddingOperator : public Operator {
+// Shape算子 - 输出输入张量的形状（INT64一维张量），支持opset 15的start/end属性
+// 输入为常量或静态形状的图输入时由常量折叠在加载期求值
+class ShapeOperator : public Operator {
 public:
-    std::string GetName() const override { return "Embedding"; }
+    std::string GetName() const override { return "Shape"; }
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
-        if (inputs.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Embedding requires 2 inputs (input_ids, weight)");
-        }
-        if (inputs[0]->GetDataType() != DataType::INT64) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Embedding input_ids must be INT64");
-        }
-        if (inputs[1]->GetDataType() != DataType::FLOAT32) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Embedding weight must be FLOAT32");
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Shape requires 1 input");
         }
         return Status::Ok();
     }
     
     Status InferOutputShape(const std::vector<Tensor*>& inputs,
                            std::vector<Shape>& output_shapes) const override {
-        if (inputs.size() < 2) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Embedding requires 2 inputs");
-        }
-        
-        const Shape& input_ids_shape = inputs[0]->GetShape();
-        const Shape& weight_shape = inputs[1]->GetShape();
-        
-        // 输出形状: [batch_size, seq_len, embedding_dim]
-        std::vector<int64_t> output_dims = input_ids_shape.dims;
-        if (weight_shape.dims.size() >= 2) {
-            output_dims.push_back(weight_shape.dims[1]);  // embedding_dim
-        } else {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                               "Invalid weight shape for Embedding");
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Shape requires 1 input");
         }
-        
-        output_shapes.push_back(Shape(output_dims));
+        int64_t start = 0, end = 0;
+        GetRange(inputs[0]->GetShape(), &start, &end);
+        output_shapes.push_back(Shape({end - start}));
         return Status::Ok();
     }
     
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::INT64;
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
-        if (inputs.size() < 2 || outputs.empty()) {
+        (void)ctx;
+        if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
-        Tensor* input_ids = inputs[0];
-        Tensor* weight = inputs[1];
-        Tensor* output = outputs[0];
-        
-        const Shape& input_ids_shape = input_ids->GetShape();
-        const Shape& weight_shape = weight->GetShape();
-        
-        int64_t batch_size = input_ids_shape.dims[0];
-        int64_t seq_len = input_ids_shape.dims.size() > 1 ? input_ids_shape.dims[1] : 1;
-        int64_t vocab_size = weight_shape.dims[0];
-        int64_t embedding_dim = weight_shape.dims[1];
-        
-        const int64_t* input_ids_data = static_cast<const int64_t*>(input_ids->GetData());
-        const float* weight_data = static_cast<const float*>(weight->GetData());
-        float* output_data = static_cast<float*>(output->GetData());
-        
-        // Embedding查找: output[i, j, :] = weight[input_ids[i, j], :]
-        for (int64_t b = 0; b < batch_size; ++b) {
-            for (int64_t s = 0; s < seq_len; ++s) {
-                int64_t token_id = input_ids_data[b * seq_len + s];
-                
-                // 边界检查
-                if (token_id < 0 || token_id >= vocab_size) {
-                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
-                                       "Token ID out of range: " + std::to_string(token_id));
-                }
-                
-                // 复制embedding向量
-                const float* embedding = weight_data + token_id * embedding_dim;
-                float* output_embedding = output_data + (b * seq_len + s) * embedding_dim;
-                std::memcpy(output_embedding, embedding, embedding_dim * sizeof(float));
-            }
+        if (outputs[0]->GetDataType() != DataType::INT64) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Shape output must be INT64");
         }
-        
-        return Status::Ok();
+        const Shape& input_shape = inputs[0]->GetShape();
+        int64_t start = 0, end = 0;
+        GetRange(input_shape, &start, &end);
+        int64_t* output_data = static_cast<int64_t*>(outputs[0]->GetData());
+        for (int64_t i = start; i < end; ++i) {
+            output_data[i - start] = input_shape.dims[i];
+        }
+        return Status::Ok();
+    }
+
+private:
+    void GetRange(const Shape& shape, int64_t* start, int64_t* end) const {
+        const int64_t rank = static_cast<int64_t>(shape.dims.size());
+        int64_t s = GetIntAttribute("start", 0);
+        int64_t e = GetIntAttribute("end", rank);
+        if (s < 0) s += rank;
+        if (e < 0) e += rank;
+        *start = std::min(std::max<int64_t>(s, 0), rank);
+        *end = std::max(*start, std::min(std::max<int64_t>(e, 0), rank));
+    }
+};
+
+// Cast算子 - 数据类型转换（to为ONNX TensorProto的数据类型编号）
+// 支持FLOAT32/FLOAT16/BFLOAT16/INT32/INT64/INT8/UINT8/BOOL之间的转换（半精度经FP32中转）；
+// 权重侧的Cast由常量折叠在加载期完成
+class CastOperator : public Operator {
+public:
+    std::string GetName() const override { return "Cast"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Cast requires 1 input");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Cast requires 1 input");
+        }
+        if (GetTargetType() == DataType::UNKNOWN) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Cast target type");
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)output_index;
+        const DataType target = GetTargetType();
+        if (target == DataType::UNKNOWN && !inputs.empty()) {
+            return inputs[0]->GetDataType();
+        }
+        return target;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        (void)ctx;
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Tensor* input = inputs[0];
+        Tensor* output = outputs[0];
+        if (input->GetElementCount() != output->GetElementCount()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Element count mismatch");
+        }
+        const size_t count = input->GetElementCount();
+        if (input->GetDataType() == output->GetDataType()) {
+            std::memcpy(output->GetData(), input->GetData(), input->GetSizeInBytes());
+            return Status::Ok();
+        }
+        if (IsHalfType(input->GetDataType()) || IsHalfType(output->GetDataType())) {
+            return CastThroughFloat(input, output, count);
+        }
+        switch (input->GetDataType()) {
+            case DataType::FLOAT32: return CastFrom<float>(input->GetData(), output, count);
+            case DataType::INT32: return CastFrom<int32_t>(input->GetData(), output, count);
+            case DataType::INT64: return CastFrom<int64_t>(input->GetData(), output, count);
+            case DataType::INT8: return CastFrom<int8_t>(input->GetData(), output, count);
+            case DataType::UINT8:
+            case DataType::BOOL: return CastFrom<uint8_t>(input->GetData(), output, count);
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Cast source type");
+        }
+    }
+
+private:
+    DataType GetTargetType() const {
+        switch (GetIntAttribute("to", 0)) {
+            case 1: return DataType::FLOAT32;
+            case 2: return DataType::UINT8;
+            case 3: return DataType::INT8;
+            case 6: return DataType::INT32;
+            case 7: return DataType::INT64;
+            case 9: return DataType::BOOL;
+            case 10: return DataType::FLOAT16;
+            case 16: return DataType::BFLOAT16;
+            default: return DataType::UNKNOWN;
+        }
+    }
+    
+    static bool IsHalfType(DataType dtype) {
+        return dtype == DataType::FLOAT16 || dtype == DataType::BFLOAT16;
+    }
+    
+    // FLOAT16/BFLOAT16经FP32中转：与FP32之间直接用SIMD批量转换，其他类型再走CastFrom
+    static Status CastThroughFloat(Tensor* input, Tensor* output, size_t count) {
+        const DataType src_type = input->GetDataType();
+        const DataType dst_type = output->GetDataType();
+        std::vector<float> buffer;
+        float* floats = dst_type == DataType::FLOAT32 ? static_cast<float*>(output->GetData()) : nullptr;
+        if (src_type == DataType::FLOAT32) {
+            floats = static_cast<float*>(input->GetData());
+        } else {
+            if (!floats) {
+                buffer.resize(count);
+                floats = buffer.data();
+            }
+            const void* data = input->GetData();
+            switch (src_type) {
+                case DataType::FLOAT16:
+                    simd::ConvertHalfToFloatSIMD(static_cast<const uint16_t*>(data), floats, count);
+                    break;
+                case DataType::BFLOAT16:
+                    simd::ConvertBFloat16ToFloatSIMD(static_cast<const uint16_t*>(data), floats, count);
+                    break;
+                case DataType::INT32: Convert(static_cast<const int32_t*>(data), floats, count); break;
+                case DataType::INT64: Convert(static_cast<const int64_t*>(data), floats, count); break;
+                case DataType::INT8: Convert(static_cast<const int8_t*>(data), floats, count); break;
+                case DataType::UINT8:
+                case DataType::BOOL: Convert(static_cast<const uint8_t*>(data), floats, count); break;
+                default:
+                    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Cast source type");
+            }
+        }
+        switch (dst_type) {
+            case DataType::FLOAT32: return Status::Ok();
+            case DataType::FLOAT16:
+                simd::ConvertFloatToHalfSIMD(floats, static_cast<uint16_t*>(output->GetData()), count);
+                return Status::Ok();
+            case DataType::BFLOAT16:
+                simd::ConvertFloatToBFloat16SIMD(floats, static_cast<uint16_t*>(output->GetData()), count);
+                return Status::Ok();
+            default:
+                return CastFrom<float>(floats, output, count);
+        }
+    }
+    
+    template <typename Src, typename Dst>
+    static void Convert(const Src* src, Dst* dst, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = static_cast<Dst>(src[i]);
+        }
+    }
+    
+    template <typename Src>
+    static Status CastFrom(const void* data, Tensor* output, size_t count) {
+        const Src* src = static_cast<const Src*>(data);
+        switch (output->GetDataType()) {
+            case DataType::FLOAT32: Convert(src, static_cast<float*>(output->GetData()), count); break;
+            case DataType::INT32: Convert(src, static_cast<int32_t*>(output->GetData()), count); break;
+            case DataType::INT64: Convert(src, static_cast<int64_t*>(output->GetData()), count); break;
+            case DataType::INT8: Convert(src, static_cast<int8_t*>(output->GetData()), count); break;
+            case DataType::UINT8: Convert(src, static_cast<uint8_t*>(output->GetData()), count); break;
+            case DataType::BOOL: {
+                uint8_t* dst = static_cast<uint8_t*>(output->GetData());
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = src[i] != Src(0) ? 1 : 0;
+                }
+                break;
+            }
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Unsupported Cast target type");
+        }
+        return Status::Ok();
+    }
+};
+
+// Flatten算子：[d0, ..., d(axis-1), ...] -> [d0 × ... × d(axis-1), 其余各维之积]，只改形状元数据
+class FlattenOperator : public Operator {
+public:
+    std::string GetName() const override { return "Flatten"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Flatten requires 1 input");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Flatten requires 1 input");
+        }
+        const std::vector<int64_t>& dims = inputs[0]->GetShape().dims;
+        const int64_t rank = static_cast<int64_t>(dims.size());
+        int64_t axis = GetIntAttribute("axis", 1);
+        if (axis < 0) axis += rank;
+        if (axis < 0 || axis > rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Flatten axis out of range");
+        }
+        // 含未知维度的一侧结果也未知
+        auto product = [&dims](int64_t begin, int64_t end) {
+            int64_t result = 1;
+            for (int64_t d = begin; d < end; ++d) {
+                if (dims[d] < 0) return static_cast<int64_t>(-1);
+                result *= dims[d];
+            }
+            return result;
+        };
+        output_shapes.push_back(Shape({product(0, axis), product(axis, rank)}));
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        (void)ctx;
+        if (inputs.empty() || outputs.empty() ||
+            inputs[0]->GetSizeInBytes() != outputs[0]->GetSizeInBytes()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        // 同Reshape：执行计划中的视图步骤不会走到这里
+        if (outputs[0]->GetData() != inputs[0]->GetData()) {
+            std::memcpy(outputs[0]->GetData(), inputs[0]->GetData(), inputs[0]->GetSizeInBytes());
+        }
+        return Status::Ok();
+    }
+    
+    bool IsViewOperator() const override { return true; }
+    
+    std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const override {
+        if (inputs.empty() || !inputs[0] || !inputs[0]->IsContiguous()) {
+            return nullptr;
+        }
+        std::vector<Shape> output_shapes;
+        if (!InferOutputShape({inputs[0].get()}, output_shapes).IsOk()) {
+            return nullptr;
+        }
+        return CreateStridedView(inputs[0], output_shapes[0], {});
+    }
+};
+
+// Dropout算子（推理模式）：输出即输入，可选的mask输出全为true。
+// 图化简通常已删除推理模式的Dropout（见graph_simplification），这里处理保留下来的节点；
+// training_mode为常量true时报错
+class DropoutOperator : public Operator {
+public:
+    std::string GetName() const override { return "Dropout"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Dropout requires at least 1 input");
+        }
+        const Tensor* training = inputs.size() > 2 ? inputs[2] : nullptr;
+        if (training && training->GetData() && training->GetElementCount() == 1 &&
+            training->GetDataType() == DataType::BOOL && *static_cast<const uint8_t*>(training->GetData()) != 0) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Dropout training_mode is not supported");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Dropout requires at least 1 input");
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        output_shapes.push_back(inputs[0]->GetShape());  // mask
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        if (output_index == 1) {
+            return DataType::BOOL;
+        }
+        return inputs.empty() ? DataType::UNKNOWN : inputs[0]->GetDataType();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        (void)ctx;
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (outputs.empty() || inputs[0]->GetSizeInBytes() != outputs[0]->GetSizeInBytes()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        if (outputs[0]->GetData() != inputs[0]->GetData()) {
+            std::memcpy(outputs[0]->GetData(), inputs[0]->GetData(), inputs[0]->GetSizeInBytes());
+        }
+        if (outputs.size() > 1 && outputs[1]) {
+            std::memset(outputs[1]->GetData(), 1, outputs[1]->GetSizeInBytes());
+        }
+        return Status::Ok();
+    }
+    
+    bool IsViewOperator() const override { return true; }
+    
+    std::shared_ptr<Tensor> CreateOutputView(const std::vector<std::shared_ptr<Tensor>>& inputs) const override {
+        if (inputs.empty() || !inputs[0] || !inputs[0]->IsContiguous()) {
+            return nullptr;
+        }
+        return CreateStridedView(inputs[0], inputs[0]->GetShape(), {});
+    }
+};
+
+// Pad算子（ONNX opset 2-19）：mode为constant/reflect/edge/wrap，pads为[各轴开头..., 各轴末尾...]，可为负（裁剪）。
+// 输入：data, pads（INT64，旧版本为pads属性）, [constant_value]（旧版本为value属性）, [axes]。
+// 只在一个轴上填充且该轴之前各维为1时输入是输出中连续的一块，内存规划把输入直接放进输出（见GetSliceOrigin），
+// 此时只写边框
+class PadOperator : public Operator {
+public:
+    std::string GetName() const override { return "Pad"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad requires at least 1 input");
+        }
+        const std::string mode = GetStringAttribute("mode", "constant");
+        if (mode != "constant" && mode != "reflect" && mode != "edge" && mode != "wrap") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Pad mode not supported: " + mode);
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        std::vector<int64_t> begin, end;
+        Status status = ResolvePads(inputs, &begin, &end);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::vector<int64_t> dims = inputs[0]->GetShape().dims;
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (dims[d] < 0) continue;
+            dims[d] += begin[d] + end[d];
+            if (dims[d] < 0) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad crops more than the input size");
+            }
+        }
+        output_shapes.push_back(Shape(dims));
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        return EstimateElementwiseCost(inputs, outputs, 0.0);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        std::vector<int64_t> begin, end;
+        Status status = ResolvePads(inputs, &begin, &end);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Tensor* input = inputs[0];
+        Tensor* output = outputs[0];
+        const std::vector<int64_t>& in_dims = input->GetShape().dims;
+        const std::vector<int64_t>& out_dims = output->GetShape().dims;
+        const size_t rank = in_dims.size();
+        if (out_dims.size() != rank || output->GetDataType() != input->GetDataType()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad output mismatch");
+        }
+        for (size_t d = 0; d < rank; ++d) {
+            if (out_dims[d] != in_dims[d] + begin[d] + end[d]) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad output shape mismatch");
+            }
+        }
+        if (output->GetElementCount() == 0) {
+            return Status::Ok();
+        }
+        const std::string mode = GetStringAttribute("mode", "constant");
+        if (mode != "constant" && input->GetElementCount() == 0) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad " + mode + " requires a non-empty input");
+        }
+        const size_t elem = GetDataTypeSize(input->GetDataType());
+        std::vector<uint8_t> fill(elem, 0);
+        status = ResolveFill(inputs, input->GetDataType(), &fill);
+        if (!status.IsOk()) {
+            return status;
+        }
+        if (rank == 0) {
+            std::memcpy(output->GetData(), input->GetData(), elem);
+            return Status::Ok();
+        }
+    
+        // 每个轴上输出坐标到输入坐标的映射，-1为常量填充
+        std::vector<std::vector<int64_t>> maps(rank);
+        for (size_t d = 0; d < rank; ++d) {
+            maps[d].resize(static_cast<size_t>(out_dims[d]));
+            for (int64_t o = 0; o < out_dims[d]; ++o) {
+                maps[d][static_cast<size_t>(o)] = MapIndex(mode, o - begin[d], in_dims[d]);
+            }
+        }
+        std::vector<int64_t> in_strides(rank, 1);
+        for (size_t d = rank - 1; d > 0; --d) {
+            in_strides[d - 1] = in_strides[d] * in_dims[d];
+        }
+        const int64_t out_w = out_dims[rank - 1];
+        const int64_t rows = static_cast<int64_t>(output->GetElementCount()) / out_w;
+        // 最后一维上直接对应输入的输出区间
+        const int64_t lo = std::max<int64_t>(begin[rank - 1], 0);
+        const int64_t hi = std::min(out_w, begin[rank - 1] + in_dims[rank - 1]);
+        const std::vector<int64_t>& last = maps[rank - 1];
+        const uint8_t* src = static_cast<const uint8_t*>(input->GetData());
+        uint8_t* dst = static_cast<uint8_t*>(output->GetData());
+        const bool zero_fill = std::all_of(fill.begin(), fill.end(), [](uint8_t b) { return b == 0; });
+        auto fill_span = [&](uint8_t* out, int64_t count) {
+            if (zero_fill) {
+                std::memset(out, 0, static_cast<size_t>(count) * elem);
+                return;
+            }
+            for (int64_t x = 0; x < count; ++x) {
+                std::memcpy(out + x * elem, fill.data(), elem);
+            }
+        };
+    
+        ParallelForOuter(ctx, rows, out_w, [&](int64_t row_begin, int64_t row_end) {
+            for (int64_t row = row_begin; row < row_end; ++row) {
+                uint8_t* out = dst + row * out_w * elem;
+                // 前面各轴的输出坐标映射到输入行
+                int64_t in_row = 0;
+                bool filled = false;
+                for (int64_t d = static_cast<int64_t>(rank) - 2, rest = row; d >= 0; --d) {
+                    const int64_t index = maps[d][static_cast<size_t>(rest % out_dims[d])];
+                    rest /= out_dims[d];
+                    filled = filled || index < 0;
+                    in_row += index * in_strides[d];
+                }
+                if (filled) {
+                    fill_span(out, out_w);
+                    continue;
+                }
+                const uint8_t* in = src + in_row * elem;
+                if (hi > lo && out + lo * elem != in + (lo - begin[rank - 1]) * elem) {
+                    std::memcpy(out + lo * elem, in + (lo - begin[rank - 1]) * elem, static_cast<size_t>(hi - lo) * elem);
+                }
+                for (int64_t x = 0; x < out_w; ++x) {
+                    if (x == lo && hi > lo) {
+                        x = hi - 1;  // 跳过已拷贝的区间
+                        continue;
+                    }
+                    if (last[static_cast<size_t>(x)] < 0) {
+                        std::memcpy(out + x * elem, fill.data(), elem);
+                    } else {
+                        std::memcpy(out + x * elem, in + last[static_cast<size_t>(x)] * elem, elem);
+                    }
+                }
+            }
+        });
+        return Status::Ok();
+    }
+    
+    SliceAlias GetSliceAlias() const override { return SliceAlias::INPUT_INSIDE_OUTPUT; }
+    
+    // pads非负且只在一个轴上非零时输入从该轴的pad_begin处开始；所在位置是否连续由内存规划按形状检查
+    bool GetSliceOrigin(const std::vector<Tensor*>& inputs, int* axis, int64_t* start) const override {
+        std::vector<int64_t> begin, end;
+        if (!ResolvePads(inputs, &begin, &end).IsOk()) {
+            return false;
+        }
+        *axis = 0;
+        *start = 0;
+        int padded = 0;
+        for (size_t d = 0; d < begin.size(); ++d) {
+            if (begin[d] < 0 || end[d] < 0) {
+                return false;
+            }
+            if (begin[d] != 0 || end[d] != 0) {
+                ++padded;
+                *axis = static_cast<int>(d);
+                *start = begin[d];
+            }
+        }
+        return padded <= 1 && !begin.empty();
+    }
+
+private:
+    // 第slot个ONNX输入（0 data, 1 pads, 2 constant_value, 3 axes），省略或为空时为nullptr
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const int64_t position = i < slots.size() ? slots[i] : static_cast<int64_t>(i);
+            if (position == slot) {
+                return inputs[i] && inputs[i]->GetElementCount() > 0 ? inputs[i] : nullptr;
+            }
+        }
+        return nullptr;
+    }
+    
+    Status ResolvePads(const std::vector<Tensor*>& inputs, std::vector<int64_t>* begin,
+                       std::vector<int64_t>* end) const {
+        if (inputs.empty() || !inputs[0]) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad requires an input");
+        }
+        const size_t rank = inputs[0]->GetShape().dims.size();
+        std::vector<int64_t> pads;
+        const Tensor* pads_tensor = InputAt(inputs, 1);
+        if (pads_tensor) {
+            if (pads_tensor->GetDataType() != DataType::INT64 || !pads_tensor->GetData()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad pads must be a constant INT64 tensor");
+            }
+            const int64_t* data = static_cast<const int64_t*>(pads_tensor->GetData());
+            pads.assign(data, data + pads_tensor->GetElementCount());
+        } else {
+            pads = GetIntsAttribute("pads", {});
+        }
+        std::vector<int64_t> axes;
+        if (const Tensor* axes_tensor = InputAt(inputs, 3)) {
+            if (!axes_tensor->GetData() || (axes_tensor->GetDataType() != DataType::INT64 &&
+                                            axes_tensor->GetDataType() != DataType::INT32)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad axes must be a constant integer tensor");
+            }
+            for (size_t i = 0; i < axes_tensor->GetElementCount(); ++i) {
+                int64_t axis = axes_tensor->GetDataType() == DataType::INT64
+                    ? static_cast<const int64_t*>(axes_tensor->GetData())[i]
+                    : static_cast<const int32_t*>(axes_tensor->GetData())[i];
+                if (axis < 0) axis += static_cast<int64_t>(rank);
+                if (axis < 0 || axis >= static_cast<int64_t>(rank)) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad axis out of range");
+                }
+                axes.push_back(axis);
+            }
+        } else {
+            for (size_t d = 0; d < rank; ++d) axes.push_back(static_cast<int64_t>(d));
+        }
+        if (pads.size() != 2 * axes.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Pad pads size must be twice the number of axes");
+        }
+        begin->assign(rank, 0);
+        end->assign(rank, 0);
+        for (size_t i = 0; i < axes.size(); ++i) {
+            (*begin)[static_cast<size_t>(axes[i])] = pads[i];
+            (*end)[static_cast<size_t>(axes[i])] = pads[axes.size() + i];
+        }
+        return Status::Ok();
+    }
+    
+    // 常量填充值的字节：constant_value输入与数据同类型直接取其字节；旧版本的value属性按类型转换
+    Status ResolveFill(const std::vector<Tensor*>& inputs, DataType dtype, std::vector<uint8_t>* fill) const {
+        if (const Tensor* value = InputAt(inputs, 2)) {
+            if (value->GetDataType() != dtype || !value->GetData()) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Pad constant_value must be a constant of the data type");
+            }
+            std::memcpy(fill->data(), value->GetData(), fill->size());
+            return Status::Ok();
+        }
+        const float value = GetFloatAttribute("value", 0.0f);
+        if (value == 0.0f) {
+            return Status::Ok();
+        }
+        auto store = [fill](auto typed) { std::memcpy(fill->data(), &typed, sizeof(typed)); };
+        switch (dtype) {
+            case DataType::FLOAT32: store(value); break;
+            case DataType::INT64: store(static_cast<int64_t>(value)); break;
+            case DataType::INT32: store(static_cast<int32_t>(value)); break;
+            case DataType::INT8: store(static_cast<int8_t>(value)); break;
+            case DataType::UINT8: store(static_cast<uint8_t>(value)); break;
+            default:
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "Pad value attribute is only supported for float and integer data");
+        }
+        return Status::Ok();
+    }
+    
+    static int64_t MapIndex(const std::string& mode, int64_t i, int64_t size) {
+        if (i >= 0 && i < size) {
+            return i;
+        }
+        if (mode == "constant" || size <= 0) {
+            return -1;
+        }
+        if (mode == "edge") {
+            return std::min(std::max<int64_t>(i, 0), size - 1);
+        }
+        if (mode == "wrap") {
+            return ((i % size) + size) % size;
+        }
+        // reflect：以2 × (size - 1)为周期来回反射（不重复边缘元素）
+        if (size == 1) {
+            return 0;
+        }
+        const int64_t period = 2 * (size - 1);
+        const int64_t m = ((i % period) + period) % period;
+        return m < size ? m : period - m;
+    }
+};
+
+REGISTER_OPERATOR("Reshape", ReshapeOperator);
+REGISTER_OPERATOR("Concat", ConcatOperator);
+REGISTER_OPERATOR("Split", SplitOperator);
+REGISTER_OPERATOR("Transpose", TransposeOperator);
+REGISTER_OPERATOR("Gather", GatherOperator);
+REGISTER_OPERATOR("Slice", SliceOperator);
+REGISTER_OPERATOR("Shape", ShapeOperator);
+REGISTER_OPERATOR("Cast", CastOperator);
+REGISTER_OPERATOR("Flatten", FlattenOperator);
+REGISTER_OPERATOR("Dropout", DropoutOperator);
+REGISTER_OPERATOR("Pad", PadOperator);
+
+// Embedding算子 - 词嵌入（Transformer模型必需）
+// Embedding(input_ids, weight) -> embeddings
+// input_ids: [batch_size, seq_len] (INT32/INT64)
+// weight: [vocab_size, embedding_dim] (FLOAT)
+// output: [batch_size, seq_len, embedding_dim] (FLOAT)
+class EmbeddingOperator : public Operator {
+public:
+    std::string GetName() const override { return "Embedding"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Embedding requires 2 inputs (input_ids, weight)");
+        }
+        if (inputs[0]->GetDataType() != DataType::INT64 && inputs[0]->GetDataType() != DataType::INT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Embedding input_ids must be INT32 or INT64");
+        }
+        if (inputs[1]->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Embedding weight must be FLOAT32");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        if (inputs.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Embedding requires 2 inputs");
+        }
+    
+        const Shape& input_ids_shape = inputs[0]->GetShape();
+        const Shape& weight_shape = inputs[1]->GetShape();
+    
+        // 输出形状: [batch_size, seq_len, embedding_dim]
+        std::vector<int64_t> output_dims = input_ids_shape.dims;
+        if (weight_shape.dims.size() >= 2) {
+            output_dims.push_back(weight_shape.dims[1]);  // embedding_dim
+        } else {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Invalid weight shape for Embedding");
+        }
+    
+        output_shapes.push_back(Shape(output_dims));
+        return Status::Ok();
+    }
+    
+    // 输出与weight同为FLOAT32（第一个输入是INT64的input_ids）
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::FLOAT32;
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (inputs.size() < 2 || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+    
+        Tensor* input_ids = inputs[0];
+        Tensor* weight = inputs[1];
+        Tensor* output = outputs[0];
+    
+        const Shape& weight_shape = weight->GetShape();
+        if (weight_shape.dims.size() < 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "Invalid weight shape for Embedding");
+        }
+    
+        // Embedding查找: output[i, :] = weight[input_ids[i], :]，与axis=0的Gather相同但不接受负下标
+        GatherRowsParams params;
+        params.table = weight->GetData();
+        params.num_rows = weight_shape.dims[0];
+        params.row_bytes = static_cast<size_t>(weight_shape.dims[1]) * sizeof(float);
+        params.indices = input_ids->GetData();
+        params.index_type = input_ids->GetDataType();
+        params.index_count = input_ids->GetShape().GetElementCount();
+        params.output = output->GetData();
+        params.deduplicate = GetIntAttribute("deduplicate", 0) != 0;
+        for (int64_t i = 0; i < params.index_count; ++i) {
+            const int64_t token_id = params.index_type == DataType::INT64
+                ? static_cast<const int64_t*>(params.indices)[i]
+                : static_cast<int64_t>(static_cast<const int32_t*>(params.indices)[i]);
+            if (token_id < 0) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "Token ID out of range: " + std::to_string(token_id));
+            }
+        }
+        if (store_ && params.table == store_table_) {
+            params.store = store_.get();
+        }
+        return GatherRows(params, ctx);
     }
+    
+    // 会话设置了hot_row_cache_rows且weight是模型文件映射的大表时，改从分层存储读行（见TieredEmbeddingStore）
+    Status PrePack(int input_index, const Tensor& tensor,
+                   const std::vector<Shape>& input_shapes, bool* is_packed) override {
+        (void)input_shapes;
+        *is_packed = false;
+        const Shape& shape = tensor.GetShape();
+        if (input_index != 1 || shape.dims.size() < 2 || tensor.GetDataType() != DataType::FLOAT32) {
+            return Status::Ok();
+        }
+        Status status = OpenTieredEmbeddingStore(tensor, shape.dims[0],
+                                                 static_cast<size_t>(shape.dims[1]) * sizeof(float),
+                                                 GetIntAttribute("hot_row_cache_rows", 0), &store_);
+        store_table_ = store_ ? tensor.GetData() : nullptr;
+        *is_packed = store_ != nullptr;
+        return status;
+    }
+
+private:
+    std::unique_ptr<TieredEmbeddingStore> store_;
+    const void* store_table_ = nullptr;
 };
 
 REGISTER_OPERATOR("Embedding", EmbeddingOperator);
 
+// EmbeddingBag算子 - 嵌入袋池化（推荐模型的稀疏特征，参考PyTorch的nn.EmbeddingBag与Caffe2的SparseLengthsSum）
+// EmbeddingBag(weight, indices, [offsets], [per_sample_weights], [scales], [biases]) -> pooled
+// weight: [num_rows, dim]，FLOAT32/FLOAT16，或按行量化的UINT8/INT8（value = q * scales[row] + biases[row]）
+// indices: 1维时按offsets（各袋起点，[num_bags]）分袋；2维[num_bags, L]时不带offsets，每行一袋
+// per_sample_weights: [num_ids]，只用于mode=sum
+// output: [num_bags, dim] (FLOAT)；2维indices且keepdims=1时为[num_bags, 1, dim]（与Gather+ReduceSum一致）
+// 属性mode为sum（默认）或mean；省略中间的可选输入时按input_slots属性定位
+class EmbeddingBagOperator : public Operator {
+public:
+    std::string GetName() const override { return "EmbeddingBag"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        const Tensor* weight = InputAt(inputs, 0);
+        const Tensor* indices = InputAt(inputs, 1);
+        if (!weight || !indices) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag requires weight and indices");
+        }
+        if (weight->GetShape().dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag weight must be 2-D");
+        }
+        const size_t rank = indices->GetShape().dims.size();
+        const bool has_offsets = InputAt(inputs, 2) != nullptr;
+        if ((has_offsets && rank != 1) || (!has_offsets && rank != 2)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag requires 1-D indices with offsets or 2-D indices without");
+        }
+        const std::string mode = GetStringAttribute("mode", "sum");
+        if (mode != "sum" && mode != "mean") {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag mode must be sum or mean");
+        }
+        const int64_t num_rows = weight->GetShape().dims[0];
+        const Tensor* per_sample_weights = InputAt(inputs, 3);
+        const Tensor* scales = InputAt(inputs, 4);
+        const Tensor* biases = InputAt(inputs, 5);
+        if (per_sample_weights && (per_sample_weights->GetDataType() != DataType::FLOAT32 ||
+                                   per_sample_weights->GetElementCount() != indices->GetElementCount())) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag per_sample_weights must be FLOAT32 with one weight per index");
+        }
+        for (const Tensor* row_param : {scales, biases}) {
+            if (row_param && (row_param->GetDataType() != DataType::FLOAT32 ||
+                              static_cast<int64_t>(row_param->GetElementCount()) != num_rows)) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "EmbeddingBag scales and biases must be FLOAT32 [num_rows]");
+            }
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        const Tensor* weight = InputAt(inputs, 0);
+        const Tensor* indices = InputAt(inputs, 1);
+        if (!weight || !indices || weight->GetShape().dims.size() != 2) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag requires weight [num_rows, dim] and indices");
+        }
+        const int64_t dim = weight->GetShape().dims[1];
+        const Tensor* offsets = InputAt(inputs, 2);
+        if (offsets) {
+            output_shapes.push_back(Shape({static_cast<int64_t>(offsets->GetElementCount()), dim}));
+        } else if (indices->GetShape().dims.size() == 2) {
+            const int64_t bags = indices->GetShape().dims[0];
+            output_shapes.push_back(GetIntAttribute("keepdims", 0) != 0 ? Shape({bags, 1, dim})
+                                                                        : Shape({bags, dim}));
+        } else {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "EmbeddingBag requires offsets for 1-D indices");
+        }
+        return Status::Ok();
+    }
+    
+    DataType InferOutputDataType(const std::vector<Tensor*>& inputs,
+                                 size_t output_index) const override {
+        (void)inputs;
+        (void)output_index;
+        return DataType::FLOAT32;
+    }
+    
+    // 只读取被引用的行，不按整张表计
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        OperatorCost cost;
+        if (inputs.size() < 2 || inputs[0].shape.dims.size() != 2) {
+            return cost;
+        }
+        const int64_t ids = std::max<int64_t>(inputs[1].shape.GetElementCount(), 0);
+        const int64_t dim = inputs[0].shape.dims[1];
+        cost.flops = static_cast<double>(ids * dim);
+        cost.bytes_read = static_cast<size_t>(ids * dim) * GetDataTypeSize(inputs[0].dtype);
+        for (const TensorInfo& output : outputs) {
+            cost.bytes_written += static_cast<size_t>(std::max<int64_t>(output.shape.GetElementCount(), 0)) *
+                                  sizeof(float);
+        }
+        return cost;
+    }
+
+    // 非FP32的表每个线程需要一行FP32的还原缓冲
+    OperatorMemory EstimateMemory(const std::vector<TensorInfo>& inputs) const override {
+        OperatorMemory memory;
+        if (!inputs.empty() && inputs[0].shape.dims.size() == 2 && inputs[0].dtype != DataType::FLOAT32) {
+            memory.scratch_bytes = static_cast<size_t>(std::max<int64_t>(inputs[0].shape.dims[1], 0)) * sizeof(float);
+        }
+        return memory;
+    }
+
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const Tensor* weight = InputAt(inputs, 0);
+        const Tensor* indices = InputAt(inputs, 1);
+        const Tensor* offsets = InputAt(inputs, 2);
+        const Tensor* per_sample_weights = InputAt(inputs, 3);
+        const Tensor* scales = InputAt(inputs, 4);
+        const Tensor* biases = InputAt(inputs, 5);
+    
+        EmbeddingBagParams params;
+        params.table = weight->GetData();
+        params.table_type = weight->GetDataType();
+        params.num_rows = weight->GetShape().dims[0];
+        params.dim = weight->GetShape().dims[1];
+        params.row_scales = scales ? static_cast<const float*>(scales->GetData()) : nullptr;
+        params.row_biases = biases ? static_cast<const float*>(biases->GetData()) : nullptr;
+        params.indices = indices->GetData();
+        params.index_type = indices->GetDataType();
+        params.index_count = static_cast<int64_t>(indices->GetElementCount());
+        if (offsets) {
+            params.offsets = offsets->GetData();
+            params.offset_type = offsets->GetDataType();
+            params.num_bags = static_cast<int64_t>(offsets->GetElementCount());
+        } else {
+            params.num_bags = indices->GetShape().dims[0];
+            params.bag_size = indices->GetShape().dims[1];
+        }
+        params.per_sample_weights =
+            per_sample_weights ? static_cast<const float*>(per_sample_weights->GetData()) : nullptr;
+        params.mean = GetStringAttribute("mode", "sum") == "mean";
+        if (static_cast<int64_t>(outputs[0]->GetElementCount()) != params.num_bags * params.dim) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "EmbeddingBag output shape mismatch");
+        }
+        params.output = static_cast<float*>(outputs[0]->GetData());
+        return EmbeddingBag(params, ctx);
+    }
+
+private:
+    // 第slot个输入，省略时为nullptr；可选输入（slot >= 2）为空张量时也视为省略
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        const std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const int64_t position = i < slots.size() ? slots[i] : static_cast<int64_t>(i);
+            if (position == slot) {
+                return inputs[i] && (slot < 2 || inputs[i]->GetElementCount() > 0) ? inputs[i] : nullptr;
+            }
+        }
+        return nullptr;
+    }
+};
+
+REGISTER_OPERATOR("EmbeddingBag", EmbeddingBagOperator);
+
+// 跨设备拷贝 (参考ONNX Runtime的MemcpyFromHost/MemcpyToHost)：由图分区在分区边界插入，
+// 形状和类型不变。输出张量的设备由执行它的提供者决定（ExecutionProvider::GetOutputDeviceType），
+// 设备提供者通过Device接口完成主机与设备间的传输；这里的实现只处理同设备的情形
+class MemcpyOperator : public Operator {
+public:
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        if (inputs.size() != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, GetName() + " requires 1 input");
+        }
+        return Status::Ok();
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        Status status = ValidateInputs(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        output_shapes.push_back(inputs[0]->GetShape());
+        return Status::Ok();
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        (void)ctx;
+        if (inputs.empty() || outputs.empty()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        return inputs[0]->CopyTo(*outputs[0]);
+    }
+};
+
+class MemcpyToDeviceOperator : public MemcpyOperator {
+public:
+    std::string GetName() const override { return "MemcpyToDevice"; }
+};
+
+class MemcpyFromDeviceOperator : public MemcpyOperator {
+public:
+    std::string GetName() const override { return "MemcpyFromDevice"; }
+};
+
+REGISTER_OPERATOR("MemcpyToDevice", MemcpyToDeviceOperator);
+REGISTER_OPERATOR("MemcpyFromDevice", MemcpyFromDeviceOperator);
+
 } // namespace operators
 } // namespace inferunity
 
@@ -0,0 +1,188 @@
+// SIMD核函数表
+// 参考ONNX Runtime MLAS的平台分发：每种ISA的核在单独的翻译单元中以对应编译选项构建，
+// 进程启动后按CPUID选择一张函数表，simd_utils.h中的接口经由该表调用
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace inferunity {
+namespace simd {
+
+enum class BinaryOp : uint8_t;  // 见simd_utils.h
+
+// 形状特化内核的行长（见simd_utils.h的FindSpecializedRowSlot）：常见的注意力头维度/序列长度与隐藏维度，
+// 均为各ISA向量宽度的整数倍
+constexpr size_t kSpecializedRowSizes[] = {64, 128, 256, 512, 768, 1024, 4096};
+constexpr size_t kNumSpecializedRowSizes = sizeof(kSpecializedRowSizes) / sizeof(kSpecializedRowSizes[0]);
+
+struct SimdKernelTable {
+    const char* isa;  // "scalar"、"sse42"、"avx2"、"avx512"、"avx512_vnni"、"amx"、"neon"、"neon_dot"、"wasm_simd128"
+    
+    void (*add)(const float* a, const float* b, float* c, size_t count);
+    void (*mul)(const float* a, const float* b, float* c, size_t count);
+    void (*max)(const float* a, const float* b, float* c, size_t count);
+    void (*exp_sub)(const float* a, const float* b, float* c, size_t count);
+    
+    void (*relu)(const float* input, float* output, size_t count);
+    void (*exp)(const float* input, float* output, size_t count);
+    void (*log)(const float* input, float* output, size_t count);
+    void (*tanh)(const float* input, float* output, size_t count);
+    void (*erf)(const float* input, float* output, size_t count);
+    void (*sigmoid)(const float* input, float* output, size_t count);
+    void (*silu)(const float* input, float* output, size_t count);
+    void (*gelu)(const float* input, float* output, size_t count, bool tanh_approximation);
+    
+    float (*reduce_max)(const float* input, size_t count);
+    float (*reduce_sum)(const float* input, size_t count);
+    float (*exp_shift_sum)(const float* input, float* output, size_t count, float shift);
+    void (*online_max_exp_sum)(const float* input, size_t count, float* max_out, float* sum_out);
+    void (*exp_shift_scale)(const float* input, float* output, size_t count, float shift, float scale);
+    void (*scale)(const float* input, float* output, size_t count, float scale);
+    void (*add_scalar)(const float* input, float* output, size_t count, float value);
+    
+    void (*transpose_2d)(const float* input, size_t input_stride, float* output, size_t output_stride,
+                         size_t rows, size_t cols);
+    
+    void (*nchwc_conv)(const float* input, size_t input_step, const size_t* input_offsets,
+                       const float* filter, const size_t* filter_offsets, size_t taps,
+                       float* output, size_t count, size_t block);
+    
+    // 16位整数GEMM：output[m][n] = Σ_k a[m][k] * b[k][n]（int32累加，直接覆盖输出）；
+    // a按行把相邻两个k打包成一个int32（低16位为偶数k），b为[k_pairs][n][2]交错存放的int16
+    void (*qgemm_s16)(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+                      size_t m, size_t n, size_t k_pairs);
+    
+    // u8s8整数GEMM：output[m][n] = Σ_k a[m][k] * b[k][n]（int32累加，直接覆盖输出）；
+    // a为s8，按行把相邻4个k打包成一个int32（最低字节为k % 4 == 0），行跨度为k_quads；
+    // b为u8，[k_quads][ldb][4]交错存放，output的行跨度为ldc
+    void (*qgemm_u8s8)(const int32_t* a_quads, const uint8_t* b_quads, size_t ldb,
+                       int32_t* output, size_t ldc, size_t m, size_t n, size_t k_quads);
+    // false表示qgemm_u8s8的两两相加在int16上饱和（maddubs），只对相邻两个k满足|a0| + |a1| <= 128的a精确
+    bool qgemm_u8s8_exact;
+    
+    // 半精度与FP32的批量转换（FLOAT16为IEEE binary16，BFLOAT16为FP32的高16位，转为半精度时就近舍入到偶数）
+    void (*half_to_float)(const uint16_t* input, float* output, size_t count);
+    void (*float_to_half)(const float* input, uint16_t* output, size_t count);
+    void (*bf16_to_float)(const uint16_t* input, float* output, size_t count);
+    void (*float_to_bf16)(const float* input, uint16_t* output, size_t count);
+    
+    // sum(a[i] * q[i])：q为无符号4位（每字节两个，低4位在前）或8位的量化权重
+    float (*dot_u4)(const float* a, const uint8_t* q, size_t count);
+    float (*dot_u8)(const float* a, const uint8_t* q, size_t count);
+    
+    // LayerNorm/RMSNorm（见simd_utils.h的AddWelfordSIMD等）
+    void (*add_welford)(const float* a, const float* b, float* sum, size_t count, float* mean, float* m2);
+    float (*add_sum_squares)(const float* a, const float* b, float* sum, size_t count);
+    void (*normalize_scale)(const float* input, float* output, size_t count, float shift, float inv_std,
+                            const float* gamma, const float* beta);
+    
+    void (*nchwc_pool)(const float* input, size_t input_step, const size_t* input_offsets, size_t taps,
+                       float* output, size_t count, size_t block, bool max_pool, float scale);
+    
+    // 广播的二元逐元素运算（见simd_utils.h的BinarySIMD）
+    void (*binary)(BinaryOp op, const float* a, bool a_scalar, const float* b, bool b_scalar,
+                   float* c, size_t count);
+    
+    // Reduce*算子（见simd_utils.h的ReduceMinSIMD等）
+    float (*reduce_min)(const float* input, size_t count);
+    float (*reduce_sum_squares)(const float* input, size_t count);
+    void (*accumulate_squares)(const float* input, float* acc, size_t count);
+    
+    // 采样算子的top-k候选筛选（见simd_utils.h的SelectGreaterSIMD）
+    size_t (*select_greater)(const float* input, size_t count, float threshold, uint32_t* indices);
+    
+    // Resize的可分离插值（见simd_utils.h的ScaleAddSIMD）
+    void (*scale_add)(const float* input, float scale, float* acc, size_t count);
+    
+    // 深度卷积的一行输出（见simd_utils.h的DepthwiseConvRowSIMD）
+    void (*depthwise_conv_row)(const float* input, const size_t* offsets, const float* weights, size_t taps,
+                               float bias, bool relu, float* output, size_t count);
+    
+    // NonMaxSuppression的IoU（见simd_utils.h的BoxIoUSIMD）
+    void (*box_iou)(const float* box, float area, const float* y1, const float* x1, const float* y2,
+                    const float* x2, const float* areas, float* iou, size_t count);
+    
+    // 稀疏权重的MatMul（见simd_utils.h的BlockSparseDotSIMD/SparseDot2of4SIMD）
+    void (*block_sparse_dot)(const float* a, const float* values, const int32_t* columns, size_t count,
+                             size_t block, float* out);
+    float (*sparse_dot_2of4)(const float* a, const float* values, const uint8_t* indices, size_t groups);
+    
+    // M <= 8的瘦矩阵乘（见simd_utils.h的SkinnyGemmSIMD）
+    void (*skinny_gemm)(const float* a, size_t lda, const void* b, int b_type, size_t ldb, bool trans_b,
+                        float* c, size_t ldc, size_t m, size_t n, size_t k);
+    
+    // 图像预处理的u8到FP32的仿射变换（见simd_utils.h的ConvertU8AffineSIMD）
+    void (*u8_affine)(const uint8_t* input, float* output, size_t count, float scale, float shift);
+    
+    // 行长为编译期常量的Softmax/LogSoftmax与LayerNorm/RMSNorm，下标同kSpecializedRowSizes
+    //（见simd_utils.h的SoftmaxRowFixedSIMD/NormRowFixedSIMD）
+    void (*softmax_row_fixed[kNumSpecializedRowSizes])(const float* input, float* output, bool log_softmax);
+    void (*norm_row_fixed[kNumSpecializedRowSizes])(const float* a, const float* b, float* sum, float* output,
+                                                    float epsilon, const float* gamma, const float* beta,
+                                                    bool rms);
+};
+
+// 各ISA的函数表；当前目标架构上未编译的ISA返回nullptr
+const SimdKernelTable* GetScalarKernels();
+const SimdKernelTable* GetSse42Kernels();
+const SimdKernelTable* GetAvx2Kernels();
+const SimdKernelTable* GetAvx512Kernels();
+const SimdKernelTable* GetAvx512VnniKernels();
+const SimdKernelTable* GetAmxKernels();
+const SimdKernelTable* GetNeonKernels();
+const SimdKernelTable* GetNeonDotKernels();
+const SimdKernelTable* GetWasmSimdKernels();
+
+// 逼近所用常量，标量Fast*函数与各ISA的向量核共用
+namespace detail {
+
+// 避免在ISA翻译单元中实例化std::numeric_limits
+constexpr float kInfinity = __builtin_inff();
+constexpr float kQuietNaN = __builtin_nanf("");
+constexpr float kMinNormal = 1.17549435e-38f;  // FLT_MIN
+
+// Cephes exp_ps常量：x = n*ln2 + r，ln2拆成两部分以减小舍入误差
+constexpr float kExpHi = 88.3762626647949f;
+constexpr float kExpLo = -88.3762626647949f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kExpP0 = 1.9875691500e-4f;
+constexpr float kExpP1 = 1.3981999507e-3f;
+constexpr float kExpP2 = 8.3334519073e-3f;
+constexpr float kExpP3 = 4.1665795894e-2f;
+constexpr float kExpP4 = 1.6666665459e-1f;
+constexpr float kExpP5 = 5.0000001201e-1f;
+
+// Cephes logf常量
+constexpr float kSqrtHalf = 0.707106781186547524f;
+constexpr float kLogP[9] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+                            -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+                            2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f};
+
+// tanh与erf的有理逼近（参考Eigen的generic_fast_tanh_float/generic_fast_erf_float）
+constexpr float kTanhClamp = 7.90531110763549805f;   // 超出后float精度下tanh为±1
+constexpr float kTanhTiny = 0.0004f;                 // 小于该值时tanh(x) = x
+constexpr float kTanhAlpha[7] = {4.89352455891786e-03f, 6.37261928875436e-04f, 1.48572235717979e-05f,
+                                 5.12229709037114e-08f, -8.60467152213735e-11f, 2.00018790482477e-13f,
+                                 -2.76076847742355e-16f};
+constexpr float kTanhBeta[4] = {4.89352518554385e-03f, 2.26843463243900e-03f, 1.18534705686654e-04f,
+                                1.19825839466702e-06f};
+constexpr float kErfClamp = 4.0f;                    // 超出后float精度下erf为±1
+constexpr float kErfAlpha[7] = {-1.60960333262415e-02f, -2.95459980854025e-03f, -7.34990630326855e-04f,
+                                -5.69250639462346e-05f, -2.10102402082508e-06f, 2.77068142495902e-08f,
+                                -2.72614225801306e-10f};
+constexpr float kErfBeta[5] = {-1.42647390514189e-02f, -7.37332916720468e-03f, -1.68282697438203e-03f,
+                               -2.13374055278905e-04f, -1.45660718464996e-05f};
+
+// GELU常量
+constexpr float kSqrtHalfF = 0.70710678118654752f;   // 1/sqrt(2)
+constexpr float kSqrt2OverPi = 0.7978845608028654f;  // sqrt(2/π)
+constexpr float kGeluCoeff = 0.044715f;
+
+} // namespace detail
+
+} // namespace simd
+} // namespace inferunity
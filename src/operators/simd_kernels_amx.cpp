@@ -0,0 +1,28 @@
+// AMX-INT8 SIMD核（以-mavx512f -mavx512vnni -mamx-tile -mamx-int8编译）：u8s8整数GEMM的16x16块使用tdpbsud，
+// 边缘与其余核同AVX-512 VNNI
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；编译器或架构不支持时只提供返回nullptr的入口
+
+#if defined(__x86_64__) && defined(__AVX512F__) && defined(__AVX512VNNI__) && \
+    defined(__AMX_TILE__) && defined(__AMX_INT8__)
+
+#define INFERUNITY_SIMD_ISA_AVX512 1
+#define INFERUNITY_SIMD_AVX512_VNNI 1
+#define INFERUNITY_SIMD_AMX 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetAmxKernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetAmxKernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
@@ -0,0 +1,28 @@
+// AVX2+FMA SIMD核（8路，以-mavx2 -mfma -mf16c编译）
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；其他架构上只提供返回nullptr的入口
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#if defined(__GNUC__) && (!defined(__AVX2__) || !defined(__FMA__))
+#error "simd_kernels_avx2.cpp must be compiled with the matching ISA flags"
+#endif
+
+#define INFERUNITY_SIMD_ISA_AVX2 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetAvx2Kernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetAvx2Kernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
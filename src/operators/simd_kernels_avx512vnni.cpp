@@ -0,0 +1,25 @@
+// AVX-512 VNNI SIMD核（以-mavx512f -mavx512vnni编译）：浮点核与AVX-512F相同，u8s8整数GEMM使用vpdpbusd
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；编译器或架构不支持时只提供返回nullptr的入口
+
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__AVX512F__) && defined(__AVX512VNNI__)
+
+#define INFERUNITY_SIMD_ISA_AVX512 1
+#define INFERUNITY_SIMD_AVX512_VNNI 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetAvx512VnniKernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetAvx512VnniKernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
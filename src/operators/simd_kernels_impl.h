@@ -0,0 +1,2300 @@
+// SIMD核函数的ISA无关实现
+// 由各simd_kernels_<isa>.cpp在定义INFERUNITY_SIMD_ISA_<ISA>与INFERUNITY_SIMD_TABLE_GETTER后包含；
+// 未定义任何ISA时生成标量版本。本文件中的函数都在匿名命名空间内，并且不调用std中的模板/内联函数，
+// 避免以不同指令集编译的同名内联函数在链接时被合并（ODR），导致在旧CPU上执行到新指令
+
+#include "simd_kernels.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(INFERUNITY_SIMD_ISA_AVX512) || defined(INFERUNITY_SIMD_ISA_AVX2)
+#include <immintrin.h>
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+#include <smmintrin.h>
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+#include <arm_neon.h>
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+#include <wasm_simd128.h>
+#endif
+
+#ifndef INFERUNITY_SIMD_TABLE_GETTER
+#error "INFERUNITY_SIMD_TABLE_GETTER must be defined before including simd_kernels_impl.h"
+#endif
+
+namespace inferunity {
+namespace simd {
+
+namespace {
+
+using namespace detail;
+
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+#define INFERUNITY_SIMD_VEC 1
+using VecF = __m512;
+constexpr size_t kVecWidth = 16;
+inline VecF VLoad(const float* p) { return _mm512_loadu_ps(p); }
+inline void VStore(float* p, VecF v) { _mm512_storeu_ps(p, v); }
+inline VecF VSet1(float x) { return _mm512_set1_ps(x); }
+inline VecF VAdd(VecF a, VecF b) { return _mm512_add_ps(a, b); }
+inline VecF VSub(VecF a, VecF b) { return _mm512_sub_ps(a, b); }
+inline VecF VMul(VecF a, VecF b) { return _mm512_mul_ps(a, b); }
+inline VecF VFma(VecF a, VecF b, VecF c) { return _mm512_fmadd_ps(a, b, c); }  // a*b+c
+inline VecF VMax(VecF a, VecF b) { return _mm512_max_ps(a, b); }
+inline VecF VMin(VecF a, VecF b) { return _mm512_min_ps(a, b); }
+inline VecF VRound(VecF x) { return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF VPow2i(VecF n) {
+    __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+}
+inline float VReduceAdd(VecF v) { return _mm512_reduce_add_ps(v); }
+inline float VReduceMax(VecF v) { return _mm512_reduce_max_ps(v); }
+inline bool VAnyGreater(VecF a, VecF b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ) != 0; }
+using MaskF = __mmask16;
+inline VecF VDiv(VecF a, VecF b) { return _mm512_div_ps(a, b); }
+inline VecF VAbs(VecF x) { return _mm512_abs_ps(x); }
+inline MaskF VLess(VecF a, VecF b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+inline MaskF VEqual(VecF a, VecF b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+inline VecF VSelect(MaskF m, VecF a, VecF b) { return _mm512_mask_blend_ps(m, b, a); }  // m ? a : b
+// x = m * 2^e，m∈[0.5, 1)（x须为正规正数）
+inline VecF VFrexp(VecF x, VecF* e) {
+    __m512i bits = _mm512_castps_si512(x);
+    *e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(126)));
+    bits = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f000000));
+    return _mm512_castsi512_ps(bits);
+}
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+#define INFERUNITY_SIMD_VEC 1
+using VecF = __m256;
+constexpr size_t kVecWidth = 8;
+inline VecF VLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline void VStore(float* p, VecF v) { _mm256_storeu_ps(p, v); }
+inline VecF VSet1(float x) { return _mm256_set1_ps(x); }
+inline VecF VAdd(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+inline VecF VSub(VecF a, VecF b) { return _mm256_sub_ps(a, b); }
+inline VecF VMul(VecF a, VecF b) { return _mm256_mul_ps(a, b); }
+inline VecF VFma(VecF a, VecF b, VecF c) { return _mm256_fmadd_ps(a, b, c); }
+inline VecF VMax(VecF a, VecF b) { return _mm256_max_ps(a, b); }
+inline VecF VMin(VecF a, VecF b) { return _mm256_min_ps(a, b); }
+inline VecF VRound(VecF x) { return _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF VPow2i(VecF n) {
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+inline float VReduceAdd(VecF v) {
+    __m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+    r = _mm_add_ss(r, _mm_movehdup_ps(r));
+    return _mm_cvtss_f32(r);
+}
+inline float VReduceMax(VecF v) {
+    __m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+    r = _mm_max_ss(r, _mm_movehdup_ps(r));
+    return _mm_cvtss_f32(r);
+}
+inline bool VAnyGreater(VecF a, VecF b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)) != 0; }
+using MaskF = __m256;
+inline VecF VDiv(VecF a, VecF b) { return _mm256_div_ps(a, b); }
+inline VecF VAbs(VecF x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+inline MaskF VLess(VecF a, VecF b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline MaskF VEqual(VecF a, VecF b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline VecF VSelect(MaskF m, VecF a, VecF b) { return _mm256_blendv_ps(b, a, m); }
+inline VecF VFrexp(VecF x, VecF* e) {
+    __m256i bits = _mm256_castps_si256(x);
+    *e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    bits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000));
+    return _mm256_castsi256_ps(bits);
+}
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+#define INFERUNITY_SIMD_VEC 1
+using VecF = __m128;
+constexpr size_t kVecWidth = 4;
+inline VecF VLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void VStore(float* p, VecF v) { _mm_storeu_ps(p, v); }
+inline VecF VSet1(float x) { return _mm_set1_ps(x); }
+inline VecF VAdd(VecF a, VecF b) { return _mm_add_ps(a, b); }
+inline VecF VSub(VecF a, VecF b) { return _mm_sub_ps(a, b); }
+inline VecF VMul(VecF a, VecF b) { return _mm_mul_ps(a, b); }
+inline VecF VFma(VecF a, VecF b, VecF c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }  // 无FMA指令
+inline VecF VMax(VecF a, VecF b) { return _mm_max_ps(a, b); }
+inline VecF VMin(VecF a, VecF b) { return _mm_min_ps(a, b); }
+inline VecF VRound(VecF x) { return _mm_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline VecF VPow2i(VecF n) {
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+inline float VReduceAdd(VecF v) {
+    __m128 r = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    r = _mm_add_ss(r, _mm_movehdup_ps(r));
+    return _mm_cvtss_f32(r);
+}
+inline float VReduceMax(VecF v) {
+    __m128 r = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    r = _mm_max_ss(r, _mm_movehdup_ps(r));
+    return _mm_cvtss_f32(r);
+}
+inline bool VAnyGreater(VecF a, VecF b) { return _mm_movemask_ps(_mm_cmpgt_ps(a, b)) != 0; }
+using MaskF = __m128;
+inline VecF VDiv(VecF a, VecF b) { return _mm_div_ps(a, b); }
+inline VecF VAbs(VecF x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+inline MaskF VLess(VecF a, VecF b) { return _mm_cmplt_ps(a, b); }
+inline MaskF VEqual(VecF a, VecF b) { return _mm_cmpeq_ps(a, b); }
+inline VecF VSelect(MaskF m, VecF a, VecF b) { return _mm_blendv_ps(b, a, m); }
+inline VecF VFrexp(VecF x, VecF* e) {
+    __m128i bits = _mm_castps_si128(x);
+    *e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+    bits = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000));
+    return _mm_castsi128_ps(bits);
+}
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+#define INFERUNITY_SIMD_VEC 1
+using VecF = float32x4_t;
+constexpr size_t kVecWidth = 4;
+inline VecF VLoad(const float* p) { return vld1q_f32(p); }
+inline void VStore(float* p, VecF v) { vst1q_f32(p, v); }
+inline VecF VSet1(float x) { return vdupq_n_f32(x); }
+inline VecF VAdd(VecF a, VecF b) { return vaddq_f32(a, b); }
+inline VecF VSub(VecF a, VecF b) { return vsubq_f32(a, b); }
+inline VecF VMul(VecF a, VecF b) { return vmulq_f32(a, b); }
+inline VecF VFma(VecF a, VecF b, VecF c) { return vfmaq_f32(c, a, b); }
+inline VecF VMax(VecF a, VecF b) { return vmaxq_f32(a, b); }
+inline VecF VMin(VecF a, VecF b) { return vminq_f32(a, b); }
+inline VecF VRound(VecF x) { return vrndnq_f32(x); }
+inline VecF VPow2i(VecF n) {
+    int32x4_t e = vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127));
+    return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+}
+inline float VReduceAdd(VecF v) { return vaddvq_f32(v); }
+inline float VReduceMax(VecF v) { return vmaxvq_f32(v); }
+inline bool VAnyGreater(VecF a, VecF b) { return vmaxvq_u32(vcgtq_f32(a, b)) != 0; }
+using MaskF = uint32x4_t;
+inline VecF VDiv(VecF a, VecF b) { return vdivq_f32(a, b); }
+inline VecF VAbs(VecF x) { return vabsq_f32(x); }
+inline MaskF VLess(VecF a, VecF b) { return vcltq_f32(a, b); }
+inline MaskF VEqual(VecF a, VecF b) { return vceqq_f32(a, b); }
+inline VecF VSelect(MaskF m, VecF a, VecF b) { return vbslq_f32(m, a, b); }
+inline VecF VFrexp(VecF x, VecF* e) {
+    uint32x4_t bits = vreinterpretq_u32_f32(x);
+    *e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(126)));
+    bits = vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f000000));
+    return vreinterpretq_f32_u32(bits);
+}
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+#define INFERUNITY_SIMD_VEC 1
+using VecF = v128_t;
+constexpr size_t kVecWidth = 4;
+inline VecF VLoad(const float* p) { return wasm_v128_load(p); }
+inline void VStore(float* p, VecF v) { wasm_v128_store(p, v); }
+inline VecF VSet1(float x) { return wasm_f32x4_splat(x); }
+inline VecF VAdd(VecF a, VecF b) { return wasm_f32x4_add(a, b); }
+inline VecF VSub(VecF a, VecF b) { return wasm_f32x4_sub(a, b); }
+inline VecF VMul(VecF a, VecF b) { return wasm_f32x4_mul(a, b); }
+// 基础SIMD128没有FMA；-mrelaxed-simd时由引擎选择融合或分开的乘加
+#if defined(__wasm_relaxed_simd__)
+inline VecF VFma(VecF a, VecF b, VecF c) { return wasm_f32x4_relaxed_madd(a, b, c); }
+#else
+inline VecF VFma(VecF a, VecF b, VecF c) { return wasm_f32x4_add(wasm_f32x4_mul(a, b), c); }
+#endif
+// pmax/pmin在x86引擎上各是一条maxps/minps，max/min为处理NaN与±0要多出几条指令
+inline VecF VMax(VecF a, VecF b) { return wasm_f32x4_pmax(a, b); }
+inline VecF VMin(VecF a, VecF b) { return wasm_f32x4_pmin(a, b); }
+inline VecF VRound(VecF x) { return wasm_f32x4_nearest(x); }
+inline VecF VPow2i(VecF n) {
+    const v128_t e = wasm_i32x4_add(wasm_i32x4_trunc_sat_f32x4(n), wasm_i32x4_splat(127));
+    return wasm_i32x4_shl(e, 23);
+}
+inline float VReduceAdd(VecF v) {
+    v = wasm_f32x4_add(v, wasm_i32x4_shuffle(v, v, 2, 3, 0, 1));
+    v = wasm_f32x4_add(v, wasm_i32x4_shuffle(v, v, 1, 0, 3, 2));
+    return wasm_f32x4_extract_lane(v, 0);
+}
+inline float VReduceMax(VecF v) {
+    v = wasm_f32x4_pmax(v, wasm_i32x4_shuffle(v, v, 2, 3, 0, 1));
+    v = wasm_f32x4_pmax(v, wasm_i32x4_shuffle(v, v, 1, 0, 3, 2));
+    return wasm_f32x4_extract_lane(v, 0);
+}
+inline bool VAnyGreater(VecF a, VecF b) { return wasm_v128_any_true(wasm_f32x4_gt(a, b)); }
+using MaskF = v128_t;
+inline VecF VDiv(VecF a, VecF b) { return wasm_f32x4_div(a, b); }
+inline VecF VAbs(VecF x) { return wasm_f32x4_abs(x); }
+inline MaskF VLess(VecF a, VecF b) { return wasm_f32x4_lt(a, b); }
+inline MaskF VEqual(VecF a, VecF b) { return wasm_f32x4_eq(a, b); }
+inline VecF VSelect(MaskF m, VecF a, VecF b) { return wasm_v128_bitselect(a, b, m); }
+inline VecF VFrexp(VecF x, VecF* e) {
+    *e = wasm_f32x4_convert_i32x4(wasm_i32x4_sub(wasm_u32x4_shr(x, 23), wasm_i32x4_splat(126)));
+    return wasm_v128_or(wasm_v128_and(x, wasm_i32x4_splat(0x007fffff)), wasm_i32x4_splat(0x3f000000));
+}
+#endif
+
+// 16位整数成对乘加（参考MLAS的QGEMM）：VecP的每个32位通道放相邻两个k上的int16，
+// 与广播的一对权重做点积后累加到int32；AVX-512F不含512位的madd（需要AVX-512BW），沿用256位
+#if defined(INFERUNITY_SIMD_ISA_AVX512) || defined(INFERUNITY_SIMD_ISA_AVX2)
+#define INFERUNITY_SIMD_VECI 1
+using VecI = __m256i;
+using VecP = __m256i;
+constexpr size_t kVecIWidth = 8;
+inline VecI VZeroI() { return _mm256_setzero_si256(); }
+inline VecP VLoadPairs(const int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline void VStoreI(int32_t* p, VecI v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline VecI VMaddPairs(VecI acc, VecP x, int32_t w) {
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(x, _mm256_set1_epi32(w)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+#define INFERUNITY_SIMD_VECI 1
+using VecI = __m128i;
+using VecP = __m128i;
+constexpr size_t kVecIWidth = 4;
+inline VecI VZeroI() { return _mm_setzero_si128(); }
+inline VecP VLoadPairs(const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void VStoreI(int32_t* p, VecI v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline VecI VMaddPairs(VecI acc, VecP x, int32_t w) {
+    return _mm_add_epi32(acc, _mm_madd_epi16(x, _mm_set1_epi32(w)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+#define INFERUNITY_SIMD_VECI 1
+using VecI = int32x4_t;
+using VecP = int16x8_t;
+constexpr size_t kVecIWidth = 4;
+inline VecI VZeroI() { return vdupq_n_s32(0); }
+inline VecP VLoadPairs(const int16_t* p) { return vld1q_s16(p); }
+inline void VStoreI(int32_t* p, VecI v) { vst1q_s32(p, v); }
+inline VecI VMaddPairs(VecI acc, VecP x, int32_t w) {
+    const int16x8_t wv = vreinterpretq_s16_s32(vdupq_n_s32(w));
+    const int32x4_t lo = vmull_s16(vget_low_s16(x), vget_low_s16(wv));
+    const int32x4_t hi = vmull_high_s16(x, wv);
+    return vaddq_s32(acc, vpaddq_s32(lo, hi));
+}
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+#define INFERUNITY_SIMD_VECI 1
+using VecI = v128_t;
+using VecP = v128_t;
+constexpr size_t kVecIWidth = 4;
+inline VecI VZeroI() { return wasm_i32x4_splat(0); }
+inline VecP VLoadPairs(const int16_t* p) { return wasm_v128_load(p); }
+inline void VStoreI(int32_t* p, VecI v) { wasm_v128_store(p, v); }
+inline VecI VMaddPairs(VecI acc, VecP x, int32_t w) {
+    return wasm_i32x4_add(acc, wasm_i32x4_dot_i16x8(x, wasm_i32x4_splat(w)));
+}
+#endif
+
+// u8s8点积（参考MLAS的QGEMM U8S8内核）：VecQ的每个32位通道是一列，b的4个u8（相邻4个k）与广播的
+// 权重a的4个s8做点积后累加。VNNI为vpdpbusd；AVX2/SSE为vpmaddubsw + vpmaddwd，前一步两两相加的
+// int16会饱和（见kQGemmU8S8Exact）；NEON点积指令为s8·s8，把b偏移为b - 128后由kBiasedQuads补回128·Σa
+#if defined(INFERUNITY_SIMD_AVX512_VNNI)
+#define INFERUNITY_SIMD_VECQ 1
+using VecQ = __m512i;
+constexpr size_t kVecQWidth = 16;
+constexpr bool kBiasedQuads = false;
+inline VecQ VZeroQ() { return _mm512_setzero_si512(); }
+inline VecQ VLoadQ(const int32_t* p) { return _mm512_loadu_si512(p); }
+inline VecQ VLoadQuads(const uint8_t* p) { return _mm512_loadu_si512(p); }
+inline void VStoreQ(int32_t* p, VecQ v) { _mm512_storeu_si512(p, v); }
+inline VecQ VAddQ(VecQ a, int32_t b) { return _mm512_add_epi32(a, _mm512_set1_epi32(b)); }
+inline VecQ VDotQuads(VecQ acc, VecQ b, int32_t a) {
+    return _mm512_dpbusd_epi32(acc, b, _mm512_set1_epi32(a));
+}
+#elif defined(INFERUNITY_SIMD_ISA_AVX512) || defined(INFERUNITY_SIMD_ISA_AVX2)
+#define INFERUNITY_SIMD_VECQ 1
+using VecQ = __m256i;
+constexpr size_t kVecQWidth = 8;
+constexpr bool kBiasedQuads = false;
+inline VecQ VZeroQ() { return _mm256_setzero_si256(); }
+inline VecQ VLoadQ(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline VecQ VLoadQuads(const uint8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline void VStoreQ(int32_t* p, VecQ v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline VecQ VAddQ(VecQ a, int32_t b) { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+inline VecQ VDotQuads(VecQ acc, VecQ b, int32_t a) {
+    const __m256i pairs = _mm256_maddubs_epi16(b, _mm256_set1_epi32(a));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+#define INFERUNITY_SIMD_VECQ 1
+using VecQ = __m128i;
+constexpr size_t kVecQWidth = 4;
+constexpr bool kBiasedQuads = false;
+inline VecQ VZeroQ() { return _mm_setzero_si128(); }
+inline VecQ VLoadQ(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline VecQ VLoadQuads(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void VStoreQ(int32_t* p, VecQ v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline VecQ VAddQ(VecQ a, int32_t b) { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+inline VecQ VDotQuads(VecQ acc, VecQ b, int32_t a) {
+    const __m128i pairs = _mm_maddubs_epi16(b, _mm_set1_epi32(a));
+    return _mm_add_epi32(acc, _mm_madd_epi16(pairs, _mm_set1_epi16(1)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+#define INFERUNITY_SIMD_VECQ 1
+using VecQ = int32x4_t;
+constexpr size_t kVecQWidth = 4;
+inline VecQ VZeroQ() { return vdupq_n_s32(0); }
+inline VecQ VLoadQ(const int32_t* p) { return vld1q_s32(p); }
+inline uint8x16_t VLoadQuads(const uint8_t* p) { return vld1q_u8(p); }
+inline void VStoreQ(int32_t* p, VecQ v) { vst1q_s32(p, v); }
+inline VecQ VAddQ(VecQ a, int32_t b) { return vaddq_s32(a, vdupq_n_s32(b)); }
+#if defined(INFERUNITY_SIMD_NEON_DOT)
+constexpr bool kBiasedQuads = true;
+inline VecQ VDotQuads(VecQ acc, uint8x16_t b, int32_t a) {
+    const int8x16_t biased = vreinterpretq_s8_u8(veorq_u8(b, vdupq_n_u8(0x80)));
+    return vdotq_s32(acc, biased, vreinterpretq_s8_s32(vdupq_n_s32(a)));
+}
+#else
+constexpr bool kBiasedQuads = false;
+// 无点积指令时扩展到int16后逐列乘加，两次成对相加得到每列4个k的和
+inline VecQ VDotQuads(VecQ acc, uint8x16_t b, int32_t a) {
+    const int16x8_t w = vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(a)));
+    const int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(b)));
+    const int16x8_t hi = vreinterpretq_s16_u16(vmovl_high_u8(b));
+    const int32x4_t p0 = vmull_s16(vget_low_s16(lo), vget_low_s16(w));
+    const int32x4_t p1 = vmull_high_s16(lo, w);
+    const int32x4_t p2 = vmull_s16(vget_low_s16(hi), vget_low_s16(w));
+    const int32x4_t p3 = vmull_high_s16(hi, w);
+    return vaddq_s32(acc, vpaddq_s32(vpaddq_s32(p0, p1), vpaddq_s32(p2, p3)));
+}
+#endif
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+#define INFERUNITY_SIMD_VECQ 1
+using VecQ = v128_t;
+constexpr size_t kVecQWidth = 4;
+constexpr bool kBiasedQuads = false;
+inline VecQ VZeroQ() { return wasm_i32x4_splat(0); }
+inline VecQ VLoadQ(const int32_t* p) { return wasm_v128_load(p); }
+inline VecQ VLoadQuads(const uint8_t* p) { return wasm_v128_load(p); }
+inline void VStoreQ(int32_t* p, VecQ v) { wasm_v128_store(p, v); }
+inline VecQ VAddQ(VecQ a, int32_t b) { return wasm_i32x4_add(a, wasm_i32x4_splat(b)); }
+// 扩展到int16后用i32x4.dot得到每列两个k的和，再把相邻通道两两相加（不饱和，结果精确）
+inline VecQ VDotQuads(VecQ acc, VecQ b, int32_t a) {
+    const v128_t w = wasm_i16x8_extend_low_i8x16(wasm_i32x4_splat(a));
+    const v128_t lo = wasm_i32x4_dot_i16x8(wasm_u16x8_extend_low_u8x16(b), w);
+    const v128_t hi = wasm_i32x4_dot_i16x8(wasm_u16x8_extend_high_u8x16(b), w);
+    const v128_t sums = wasm_i32x4_add(wasm_i32x4_shuffle(lo, hi, 0, 2, 4, 6), wasm_i32x4_shuffle(lo, hi, 1, 3, 5, 7));
+    return wasm_i32x4_add(acc, sums);
+}
+#endif
+
+// maddubs路径的中间和饱和，只对相邻两个k满足|w0| + |w1| <= 128的权重精确
+#if defined(INFERUNITY_SIMD_VECQ) && !defined(INFERUNITY_SIMD_AVX512_VNNI) && !defined(INFERUNITY_SIMD_ISA_NEON) && \
+    !defined(INFERUNITY_SIMD_ISA_WASM)
+constexpr bool kQGemmU8S8Exact = false;
+#else
+constexpr bool kQGemmU8S8Exact = true;
+#endif
+
+
+#ifdef INFERUNITY_SIMD_VEC
+inline VecF VExp(VecF x) {
+    x = VMin(VMax(x, VSet1(kExpLo)), VSet1(kExpHi));
+    VecF n = VRound(VMul(x, VSet1(kLog2e)));
+    VecF r = VFma(n, VSet1(-kLn2Hi), x);
+    r = VFma(n, VSet1(-kLn2Lo), r);
+    VecF p = VSet1(kExpP0);
+    p = VFma(p, r, VSet1(kExpP1));
+    p = VFma(p, r, VSet1(kExpP2));
+    p = VFma(p, r, VSet1(kExpP3));
+    p = VFma(p, r, VSet1(kExpP4));
+    p = VFma(p, r, VSet1(kExpP5));
+    p = VFma(p, VMul(r, r), VAdd(r, VSet1(1.0f)));
+    return VMul(p, VPow2i(n));
+}
+
+inline VecF VLog(VecF x) {
+    const VecF zero = VSet1(0.0f);
+    const VecF one = VSet1(1.0f);
+    const MaskF negative = VLess(x, zero);
+    const MaskF is_zero = VEqual(x, zero);
+    const MaskF is_inf = VEqual(x, VSet1(kInfinity));
+    
+    VecF e;
+    VecF m = VFrexp(VMax(x, VSet1(kMinNormal)), &e);
+    // m < sqrt(0.5)时改写为2m - 1并让指数减1，使多项式自变量落在[sqrt(0.5)-1, sqrt(2)-1]
+    const MaskF small = VLess(m, VSet1(kSqrtHalf));
+    e = VSelect(small, VSub(e, one), e);
+    VecF r = VSelect(small, VSub(VAdd(m, m), one), VSub(m, one));
+    
+    const VecF z = VMul(r, r);
+    VecF p = VSet1(kLogP[0]);
+    for (int k = 1; k < 9; ++k) {
+        p = VFma(p, r, VSet1(kLogP[k]));
+    }
+    VecF y = VMul(VMul(p, r), z);
+    y = VFma(e, VSet1(kLn2Lo), y);
+    y = VFma(z, VSet1(-0.5f), y);
+    VecF result = VAdd(r, y);
+    result = VFma(e, VSet1(kLn2Hi), result);
+    
+    result = VSelect(is_inf, x, result);
+    result = VSelect(VEqual(x, x), result, x);  // NaN原样返回
+    result = VSelect(is_zero, VSet1(-kInfinity), result);
+    return VSelect(negative, VSet1(kQuietNaN), result);
+}
+
+inline VecF VTanh(VecF a) {
+    const VecF x = VMin(VMax(a, VSet1(-kTanhClamp)), VSet1(kTanhClamp));
+    const VecF x2 = VMul(x, x);
+    VecF p = VSet1(kTanhAlpha[6]);
+    for (int k = 5; k >= 0; --k) {
+        p = VFma(x2, p, VSet1(kTanhAlpha[k]));
+    }
+    p = VMul(x, p);
+    VecF q = VSet1(kTanhBeta[3]);
+    for (int k = 2; k >= 0; --k) {
+        q = VFma(x2, q, VSet1(kTanhBeta[k]));
+    }
+    return VSelect(VLess(VAbs(a), VSet1(kTanhTiny)), a, VDiv(p, q));
+}
+
+inline VecF VErf(VecF a) {
+    const VecF x = VMin(VMax(a, VSet1(-kErfClamp)), VSet1(kErfClamp));
+    const VecF x2 = VMul(x, x);
+    VecF p = VSet1(kErfAlpha[6]);
+    for (int k = 5; k >= 0; --k) {
+        p = VFma(x2, p, VSet1(kErfAlpha[k]));
+    }
+    p = VMul(x, p);
+    VecF q = VSet1(kErfBeta[4]);
+    for (int k = 3; k >= 0; --k) {
+        q = VFma(x2, q, VSet1(kErfBeta[k]));
+    }
+    return VDiv(p, q);
+}
+
+inline VecF VSigmoid(VecF x) {
+    const VecF one = VSet1(1.0f);
+    return VDiv(one, VAdd(one, VExp(VSub(VSet1(0.0f), x))));
+}
+
+inline VecF VGelu(VecF x, bool tanh_approximation) {
+    const VecF half_x = VMul(x, VSet1(0.5f));
+    if (tanh_approximation) {
+        const VecF x3 = VMul(VMul(x, x), x);
+        const VecF inner = VMul(VSet1(kSqrt2OverPi), VFma(x3, VSet1(kGeluCoeff), x));
+        return VFma(half_x, VTanh(inner), half_x);
+    }
+    return VFma(half_x, VErf(VMul(x, VSet1(kSqrtHalfF))), half_x);
+}
+#endif
+
+// 逐元素一元函数的公共循环：尾部补齐到向量宽度后走同一向量路径，
+// 因此每个元素的结果与它在数组中的位置（以及算子内并行的切块方式）无关
+#ifdef INFERUNITY_SIMD_VEC
+#define INFERUNITY_UNARY_LOOP(vec_expr, scalar_expr)                 \
+    size_t i = 0;                                                    \
+    for (; i + kVecWidth <= count; i += kVecWidth) {                 \
+        const VecF v = VLoad(input + i);                             \
+        VStore(output + i, vec_expr);                                \
+    }                                                                \
+    if (i < count) {                                                 \
+        float tail[kVecWidth] = {};                                  \
+        for (size_t t = 0; t < count - i; ++t) tail[t] = input[i + t]; \
+        const VecF v = VLoad(tail);                                  \
+        VStore(tail, vec_expr);                                      \
+        for (size_t t = 0; t < count - i; ++t) output[i + t] = tail[t]; \
+    }
+#define INFERUNITY_BINARY_LOOP(vec_expr, scalar_expr)                \
+    size_t i = 0;                                                    \
+    for (; i + kVecWidth <= count; i += kVecWidth) {                 \
+        const VecF va = VLoad(a + i);                                \
+        const VecF vb = VLoad(b + i);                                \
+        VStore(c + i, vec_expr);                                     \
+    }                                                                \
+    for (; i < count; ++i) {                                         \
+        const float x = a[i];                                        \
+        const float y = b[i];                                        \
+        c[i] = scalar_expr;                                          \
+    }
+#else
+#define INFERUNITY_UNARY_LOOP(vec_expr, scalar_expr)                 \
+    for (size_t i = 0; i < count; ++i) {                             \
+        const float x = input[i];                                    \
+        output[i] = scalar_expr;                                     \
+    }
+#define INFERUNITY_BINARY_LOOP(vec_expr, scalar_expr)                \
+    for (size_t i = 0; i < count; ++i) {                             \
+        const float x = a[i];                                        \
+        const float y = b[i];                                        \
+        c[i] = scalar_expr;                                          \
+    }
+#endif
+
+void Add(const float* a, const float* b, float* c, size_t count) {
+    INFERUNITY_BINARY_LOOP(VAdd(va, vb), x + y)
+}
+
+void Mul(const float* a, const float* b, float* c, size_t count) {
+    INFERUNITY_BINARY_LOOP(VMul(va, vb), x * y)
+}
+
+void Relu(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VMax(v, VSet1(0.0f)), x > 0.0f ? x : 0.0f)
+}
+
+void Exp(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VExp(v), FastExp(x))
+}
+
+float ReduceMax(const float* input, size_t count) {
+    float result = -kInfinity;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (count >= kVecWidth) {
+        VecF vmax = VLoad(input);
+        for (i = kVecWidth; i + kVecWidth <= count; i += kVecWidth) {
+            vmax = VMax(vmax, VLoad(input + i));
+        }
+        result = VReduceMax(vmax);
+    }
+#endif
+    for (; i < count; ++i) {
+        result = input[i] > result ? input[i] : result;
+    }
+    return result;
+}
+
+float ReduceSum(const float* input, size_t count) {
+    float result = 0.0f;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    VecF vsum = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        vsum = VAdd(vsum, VLoad(input + i));
+    }
+    result = VReduceAdd(vsum);
+#endif
+    for (; i < count; ++i) {
+        result += input[i];
+    }
+    return result;
+}
+
+float ReduceMin(const float* input, size_t count) {
+    float result = kInfinity;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (count >= kVecWidth) {
+        VecF vmin = VLoad(input);
+        for (i = kVecWidth; i + kVecWidth <= count; i += kVecWidth) {
+            vmin = VMin(vmin, VLoad(input + i));
+        }
+        float lanes[kVecWidth];
+        VStore(lanes, vmin);
+        for (size_t l = 0; l < kVecWidth; ++l) {
+            result = lanes[l] < result ? lanes[l] : result;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        result = input[i] < result ? input[i] : result;
+    }
+    return result;
+}
+
+float ReduceSumSquares(const float* input, size_t count) {
+    float result = 0.0f;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    VecF vsum = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        const VecF v = VLoad(input + i);
+        vsum = VFma(v, v, vsum);
+    }
+    result = VReduceAdd(vsum);
+#endif
+    for (; i < count; ++i) {
+        result += input[i] * input[i];
+    }
+    return result;
+}
+
+void AccumulateSquares(const float* input, float* acc, size_t count) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        const VecF v = VLoad(input + i);
+        VStore(acc + i, VFma(v, v, VLoad(acc + i)));
+    }
+#endif
+    for (; i < count; ++i) {
+        acc[i] += input[i] * input[i];
+    }
+}
+
+void ScaleAdd(const float* input, float scale, float* acc, size_t count) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vscale = VSet1(scale);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(acc + i, VFma(VLoad(input + i), vscale, VLoad(acc + i)));
+    }
+#endif
+    for (; i < count; ++i) {
+        acc[i] += input[i] * scale;
+    }
+}
+
+// 抽头数为编译期常量（3x3、5x5）时循环完全展开，权重向量留在寄存器中；kTaps为0时按taps运行
+template <size_t kTaps>
+void DepthwiseConvRowTaps(const float* input, const size_t* offsets, const float* weights, size_t taps,
+                          float bias, bool relu, float* output, size_t count) {
+    const size_t n = kTaps ? kTaps : taps;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vbias = VSet1(bias);
+    const VecF vzero = VSet1(0.0f);
+    // 两个向量共用每个抽头的权重，隐藏FMA延迟
+    for (; i + 2 * kVecWidth <= count; i += 2 * kVecWidth) {
+        VecF acc0 = vbias;
+        VecF acc1 = vbias;
+        for (size_t t = 0; t < n; ++t) {
+            const VecF w = VSet1(weights[t]);
+            const float* x = input + offsets[t] + i;
+            acc0 = VFma(VLoad(x), w, acc0);
+            acc1 = VFma(VLoad(x + kVecWidth), w, acc1);
+        }
+        if (relu) {
+            acc0 = VMax(acc0, vzero);
+            acc1 = VMax(acc1, vzero);
+        }
+        VStore(output + i, acc0);
+        VStore(output + i + kVecWidth, acc1);
+    }
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VecF acc = vbias;
+        for (size_t t = 0; t < n; ++t) {
+            acc = VFma(VLoad(input + offsets[t] + i), VSet1(weights[t]), acc);
+        }
+        VStore(output + i, relu ? VMax(acc, vzero) : acc);
+    }
+#endif
+    for (; i < count; ++i) {
+        float sum = bias;
+        for (size_t t = 0; t < n; ++t) {
+            sum += input[offsets[t] + i] * weights[t];
+        }
+        output[i] = relu && sum < 0.0f ? 0.0f : sum;
+    }
+}
+
+void DepthwiseConvRow(const float* input, const size_t* offsets, const float* weights, size_t taps,
+                      float bias, bool relu, float* output, size_t count) {
+    if (taps == 9) {
+        DepthwiseConvRowTaps<9>(input, offsets, weights, taps, bias, relu, output, count);
+    } else if (taps == 25) {
+        DepthwiseConvRowTaps<25>(input, offsets, weights, taps, bias, relu, output, count);
+    } else {
+        DepthwiseConvRowTaps<0>(input, offsets, weights, taps, bias, relu, output, count);
+    }
+}
+
+// 整个向量都不大于threshold时只做一次比较，top-k的阈值升高后绝大多数向量被直接跳过
+size_t SelectGreater(const float* input, size_t count, float threshold, uint32_t* indices) {
+    size_t selected = 0;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vthreshold = VSet1(threshold);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        if (!VAnyGreater(VLoad(input + i), vthreshold)) {
+            continue;
+        }
+        for (size_t l = i; l < i + kVecWidth; ++l) {
+            if (input[l] > threshold) {
+                indices[selected++] = static_cast<uint32_t>(l);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (input[i] > threshold) {
+            indices[selected++] = static_cast<uint32_t>(i);
+        }
+    }
+    return selected;
+}
+
+// 一个框与count个框的IoU；交集宽高截到0，并集不为正时IoU为0
+void BoxIoU(const float* box, float area, const float* y1, const float* x1, const float* y2,
+            const float* x2, const float* areas, float* iou, size_t count) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF by1 = VSet1(box[0]);
+    const VecF bx1 = VSet1(box[1]);
+    const VecF by2 = VSet1(box[2]);
+    const VecF bx2 = VSet1(box[3]);
+    const VecF varea = VSet1(area);
+    const VecF zero = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        const VecF h = VMax(VSub(VMin(VLoad(y2 + i), by2), VMax(VLoad(y1 + i), by1)), zero);
+        const VecF w = VMax(VSub(VMin(VLoad(x2 + i), bx2), VMax(VLoad(x1 + i), bx1)), zero);
+        const VecF inter = VMul(h, w);
+        const VecF uni = VSub(VAdd(VLoad(areas + i), varea), inter);
+        VStore(iou + i, VSelect(VLess(zero, uni), VDiv(inter, uni), zero));
+    }
+#endif
+    for (; i < count; ++i) {
+        const float top = y1[i] > box[0] ? y1[i] : box[0];
+        const float left = x1[i] > box[1] ? x1[i] : box[1];
+        const float bottom = y2[i] < box[2] ? y2[i] : box[2];
+        const float right = x2[i] < box[3] ? x2[i] : box[3];
+        const float h = bottom > top ? bottom - top : 0.0f;
+        const float w = right > left ? right - left : 0.0f;
+        const float inter = h * w;
+        const float uni = areas[i] + area - inter;
+        iou[i] = uni > 0.0f ? inter / uni : 0.0f;
+    }
+}
+
+float ExpShiftSum(const float* input, float* output, size_t count, float shift) {
+    float sum = 0.0f;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vshift = VSet1(shift);
+    VecF vsum = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VecF e = VExp(VSub(VLoad(input + i), vshift));
+        VStore(output + i, e);
+        vsum = VAdd(vsum, e);
+    }
+    sum = VReduceAdd(vsum);
+#endif
+    for (; i < count; ++i) {
+        output[i] = FastExp(input[i] - shift);
+        sum += output[i];
+    }
+    return sum;
+}
+
+void OnlineMaxExpSum(const float* input, size_t count, float* max_out, float* sum_out) {
+    float max_val = -kInfinity;
+    float sum = 0.0f;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (count >= kVecWidth) {
+        // 每个通道维护各自的max与sum，max变大时把已有的sum按exp(old - new)缩放
+        VecF vmax = VLoad(input);
+        VecF vsum = VSet1(1.0f);
+        for (i = kVecWidth; i + kVecWidth <= count; i += kVecWidth) {
+            VecF x = VLoad(input + i);
+            if (VAnyGreater(x, vmax)) {
+                VecF new_max = VMax(vmax, x);
+                vsum = VMul(vsum, VExp(VSub(vmax, new_max)));
+                vmax = new_max;
+            }
+            vsum = VAdd(vsum, VExp(VSub(x, vmax)));
+        }
+        // 合并各通道
+        alignas(64) float lane_max[kVecWidth];
+        alignas(64) float lane_sum[kVecWidth];
+        VStore(lane_max, vmax);
+        VStore(lane_sum, vsum);
+        max_val = VReduceMax(vmax);
+        for (size_t l = 0; l < kVecWidth; ++l) {
+            sum += lane_sum[l] * FastExp(lane_max[l] - max_val);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const float x = input[i];
+        if (x > max_val) {
+            sum = sum * FastExp(max_val - x) + 1.0f;
+            max_val = x;
+        } else {
+            sum += FastExp(x - max_val);
+        }
+    }
+    *max_out = max_val;
+    *sum_out = sum;
+}
+
+void ExpShiftScale(const float* input, float* output, size_t count, float shift, float scale) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vshift = VSet1(shift);
+    const VecF vscale = VSet1(scale);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(output + i, VMul(VExp(VSub(VLoad(input + i), vshift)), vscale));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = FastExp(input[i] - shift) * scale;
+    }
+}
+
+void Scale(const float* input, float* output, size_t count, float scale) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vscale = VSet1(scale);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(output + i, VMul(VLoad(input + i), vscale));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = input[i] * scale;
+    }
+}
+
+void AddScalar(const float* input, float* output, size_t count, float value) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vvalue = VSet1(value);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(output + i, VAdd(VLoad(input + i), vvalue));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = input[i] + value;
+    }
+}
+
+void Max(const float* a, const float* b, float* c, size_t count) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(c + i, VMax(VLoad(a + i), VLoad(b + i)));
+    }
+#endif
+    for (; i < count; ++i) {
+        c[i] = a[i] > b[i] ? a[i] : b[i];
+    }
+}
+
+void ExpSub(const float* a, const float* b, float* c, size_t count) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(c + i, VExp(VSub(VLoad(a + i), VLoad(b + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        c[i] = FastExp(a[i] - b[i]);
+    }
+}
+
+template <BinaryOp kOp>
+inline float BinaryScalar(float x, float y) {
+    switch (kOp) {
+        case BinaryOp::ADD: return x + y;
+        case BinaryOp::SUB: return x - y;
+        case BinaryOp::MUL: return x * y;
+        case BinaryOp::DIV: return x / y;
+        case BinaryOp::MAX: return x > y ? x : y;
+        case BinaryOp::MIN: return x < y ? x : y;
+    }
+    return 0.0f;
+}
+
+#ifdef INFERUNITY_SIMD_VEC
+template <BinaryOp kOp>
+inline VecF BinaryVec(VecF x, VecF y) {
+    switch (kOp) {
+        case BinaryOp::ADD: return VAdd(x, y);
+        case BinaryOp::SUB: return VSub(x, y);
+        case BinaryOp::MUL: return VMul(x, y);
+        case BinaryOp::DIV: return VDiv(x, y);
+        case BinaryOp::MAX: return VMax(x, y);
+        case BinaryOp::MIN: return VMin(x, y);
+    }
+    return x;
+}
+#endif
+
+// 标量操作数先读出，c可以与a或b是同一数组（原地执行）
+template <BinaryOp kOp>
+void BinaryLoop(const float* a, bool a_scalar, const float* b, bool b_scalar, float* c, size_t count) {
+    const float sa = a[0];
+    const float sb = b[0];
+    size_t i = 0;
+    if (a_scalar && b_scalar) {
+        const float value = BinaryScalar<kOp>(sa, sb);
+        for (; i < count; ++i) c[i] = value;
+        return;
+    }
+#ifdef INFERUNITY_SIMD_VEC
+    if (a_scalar) {
+        const VecF va = VSet1(sa);
+        for (; i + kVecWidth <= count; i += kVecWidth) {
+            VStore(c + i, BinaryVec<kOp>(va, VLoad(b + i)));
+        }
+    } else if (b_scalar) {
+        const VecF vb = VSet1(sb);
+        for (; i + kVecWidth <= count; i += kVecWidth) {
+            VStore(c + i, BinaryVec<kOp>(VLoad(a + i), vb));
+        }
+    } else {
+        for (; i + kVecWidth <= count; i += kVecWidth) {
+            VStore(c + i, BinaryVec<kOp>(VLoad(a + i), VLoad(b + i)));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        c[i] = BinaryScalar<kOp>(a_scalar ? sa : a[i], b_scalar ? sb : b[i]);
+    }
+}
+
+void Binary(BinaryOp op, const float* a, bool a_scalar, const float* b, bool b_scalar,
+            float* c, size_t count) {
+    switch (op) {
+        case BinaryOp::ADD: BinaryLoop<BinaryOp::ADD>(a, a_scalar, b, b_scalar, c, count); return;
+        case BinaryOp::SUB: BinaryLoop<BinaryOp::SUB>(a, a_scalar, b, b_scalar, c, count); return;
+        case BinaryOp::MUL: BinaryLoop<BinaryOp::MUL>(a, a_scalar, b, b_scalar, c, count); return;
+        case BinaryOp::DIV: BinaryLoop<BinaryOp::DIV>(a, a_scalar, b, b_scalar, c, count); return;
+        case BinaryOp::MAX: BinaryLoop<BinaryOp::MAX>(a, a_scalar, b, b_scalar, c, count); return;
+        case BinaryOp::MIN: BinaryLoop<BinaryOp::MIN>(a, a_scalar, b, b_scalar, c, count); return;
+    }
+}
+
+void Log(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VLog(v), FastLog(x))
+}
+
+void Tanh(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VTanh(v), FastTanh(x))
+}
+
+void Erf(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VErf(v), FastErf(x))
+}
+
+void Sigmoid(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VSigmoid(v), FastSigmoid(x))
+}
+
+void Silu(const float* input, float* output, size_t count) {
+    INFERUNITY_UNARY_LOOP(VMul(v, VSigmoid(v)), x * FastSigmoid(x))
+}
+
+void Gelu(const float* input, float* output, size_t count, bool tanh_approximation) {
+    INFERUNITY_UNARY_LOOP(VGelu(v, tanh_approximation), (tanh_approximation ? 0.5f * x * (1.0f + FastTanh(kSqrt2OverPi * (x + kGeluCoeff * x * x * x))) : 0.5f * x * (1.0f + FastErf(x * kSqrtHalfF))))
+}
+
+// 寄存器内的方阵转置：读kTransposeTile行、写kTransposeTile行
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+#define INFERUNITY_SIMD_TRANSPOSE 1
+constexpr size_t kTransposeTile = 16;
+inline void TransposeTile(const float* input, size_t input_stride, float* output, size_t output_stride) {
+    __m512 r[16];
+    __m512 t[16];
+    for (int k = 0; k < 16; ++k) {
+        r[k] = _mm512_loadu_ps(input + k * input_stride);
+    }
+    // 每个128位通道内做4x4转置
+    for (int k = 0; k < 16; k += 2) {
+        t[k] = _mm512_unpacklo_ps(r[k], r[k + 1]);
+        t[k + 1] = _mm512_unpackhi_ps(r[k], r[k + 1]);
+    }
+    for (int g = 0; g < 16; g += 4) {
+        r[g] = _mm512_shuffle_ps(t[g], t[g + 2], 0x44);
+        r[g + 1] = _mm512_shuffle_ps(t[g], t[g + 2], 0xEE);
+        r[g + 2] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+        r[g + 3] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0xEE);
+    }
+    // 此时r[4g + c]的第l个通道是第4g..4g+3行的第4l + c列，再跨通道重排
+    for (int c = 0; c < 4; ++c) {
+        const __m512 x0 = _mm512_shuffle_f32x4(r[c], r[4 + c], 0x44);
+        const __m512 x1 = _mm512_shuffle_f32x4(r[c], r[4 + c], 0xEE);
+        const __m512 y0 = _mm512_shuffle_f32x4(r[8 + c], r[12 + c], 0x44);
+        const __m512 y1 = _mm512_shuffle_f32x4(r[8 + c], r[12 + c], 0xEE);
+        _mm512_storeu_ps(output + c * output_stride, _mm512_shuffle_f32x4(x0, y0, 0x88));
+        _mm512_storeu_ps(output + (4 + c) * output_stride, _mm512_shuffle_f32x4(x0, y0, 0xDD));
+        _mm512_storeu_ps(output + (8 + c) * output_stride, _mm512_shuffle_f32x4(x1, y1, 0x88));
+        _mm512_storeu_ps(output + (12 + c) * output_stride, _mm512_shuffle_f32x4(x1, y1, 0xDD));
+    }
+}
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+#define INFERUNITY_SIMD_TRANSPOSE 1
+constexpr size_t kTransposeTile = 8;
+inline void TransposeTile(const float* input, size_t input_stride, float* output, size_t output_stride) {
+    __m256 r[8];
+    __m256 t[8];
+    for (int k = 0; k < 8; ++k) {
+        r[k] = _mm256_loadu_ps(input + k * input_stride);
+    }
+    for (int k = 0; k < 8; k += 2) {
+        t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+        t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+    }
+    for (int g = 0; g < 8; g += 4) {
+        r[g] = _mm256_shuffle_ps(t[g], t[g + 2], 0x44);
+        r[g + 1] = _mm256_shuffle_ps(t[g], t[g + 2], 0xEE);
+        r[g + 2] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+        r[g + 3] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0xEE);
+    }
+    for (int c = 0; c < 4; ++c) {
+        _mm256_storeu_ps(output + c * output_stride, _mm256_permute2f128_ps(r[c], r[4 + c], 0x20));
+        _mm256_storeu_ps(output + (4 + c) * output_stride, _mm256_permute2f128_ps(r[c], r[4 + c], 0x31));
+    }
+}
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+#define INFERUNITY_SIMD_TRANSPOSE 1
+constexpr size_t kTransposeTile = 4;
+inline void TransposeTile(const float* input, size_t input_stride, float* output, size_t output_stride) {
+    __m128 r0 = _mm_loadu_ps(input);
+    __m128 r1 = _mm_loadu_ps(input + input_stride);
+    __m128 r2 = _mm_loadu_ps(input + 2 * input_stride);
+    __m128 r3 = _mm_loadu_ps(input + 3 * input_stride);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(output, r0);
+    _mm_storeu_ps(output + output_stride, r1);
+    _mm_storeu_ps(output + 2 * output_stride, r2);
+    _mm_storeu_ps(output + 3 * output_stride, r3);
+}
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+#define INFERUNITY_SIMD_TRANSPOSE 1
+constexpr size_t kTransposeTile = 4;
+inline void TransposeTile(const float* input, size_t input_stride, float* output, size_t output_stride) {
+    const float32x4x2_t p01 = vtrnq_f32(vld1q_f32(input), vld1q_f32(input + input_stride));
+    const float32x4x2_t p23 = vtrnq_f32(vld1q_f32(input + 2 * input_stride), vld1q_f32(input + 3 * input_stride));
+    vst1q_f32(output, vcombine_f32(vget_low_f32(p01.val[0]), vget_low_f32(p23.val[0])));
+    vst1q_f32(output + output_stride, vcombine_f32(vget_low_f32(p01.val[1]), vget_low_f32(p23.val[1])));
+    vst1q_f32(output + 2 * output_stride, vcombine_f32(vget_high_f32(p01.val[0]), vget_high_f32(p23.val[0])));
+    vst1q_f32(output + 3 * output_stride, vcombine_f32(vget_high_f32(p01.val[1]), vget_high_f32(p23.val[1])));
+}
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+#define INFERUNITY_SIMD_TRANSPOSE 1
+constexpr size_t kTransposeTile = 4;
+inline void TransposeTile(const float* input, size_t input_stride, float* output, size_t output_stride) {
+    const v128_t r0 = wasm_v128_load(input);
+    const v128_t r1 = wasm_v128_load(input + input_stride);
+    const v128_t r2 = wasm_v128_load(input + 2 * input_stride);
+    const v128_t r3 = wasm_v128_load(input + 3 * input_stride);
+    const v128_t t0 = wasm_i32x4_shuffle(r0, r1, 0, 4, 1, 5);
+    const v128_t t1 = wasm_i32x4_shuffle(r0, r1, 2, 6, 3, 7);
+    const v128_t t2 = wasm_i32x4_shuffle(r2, r3, 0, 4, 1, 5);
+    const v128_t t3 = wasm_i32x4_shuffle(r2, r3, 2, 6, 3, 7);
+    wasm_v128_store(output, wasm_i32x4_shuffle(t0, t2, 0, 1, 4, 5));
+    wasm_v128_store(output + output_stride, wasm_i32x4_shuffle(t0, t2, 2, 3, 6, 7));
+    wasm_v128_store(output + 2 * output_stride, wasm_i32x4_shuffle(t1, t3, 0, 1, 4, 5));
+    wasm_v128_store(output + 3 * output_stride, wasm_i32x4_shuffle(t1, t3, 2, 3, 6, 7));
+}
+#endif
+
+// 按kTransposeBlock见方的块遍历（源块与目标块合计约8KB，留在L1中），块内整片做寄存器转置，边缘逐元素
+void Transpose2D(const float* input, size_t input_stride, float* output, size_t output_stride,
+                 size_t rows, size_t cols) {
+    constexpr size_t kTransposeBlock = 32;
+    for (size_t i0 = 0; i0 < rows; i0 += kTransposeBlock) {
+        const size_t i1 = i0 + kTransposeBlock < rows ? i0 + kTransposeBlock : rows;
+        for (size_t j0 = 0; j0 < cols; j0 += kTransposeBlock) {
+            const size_t j1 = j0 + kTransposeBlock < cols ? j0 + kTransposeBlock : cols;
+            size_t i = i0;
+#ifdef INFERUNITY_SIMD_TRANSPOSE
+            for (; i + kTransposeTile <= i1; i += kTransposeTile) {
+                size_t j = j0;
+                for (; j + kTransposeTile <= j1; j += kTransposeTile) {
+                    TransposeTile(input + i * input_stride + j, input_stride,
+                                  output + j * output_stride + i, output_stride);
+                }
+                for (; j < j1; ++j) {
+                    for (size_t r = i; r < i + kTransposeTile; ++r) {
+                        output[j * output_stride + r] = input[r * input_stride + j];
+                    }
+                }
+            }
+#endif
+            for (; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) {
+                    output[j * output_stride + i] = input[i * input_stride + j];
+                }
+            }
+        }
+    }
+}
+
+#undef INFERUNITY_SIMD_TRANSPOSE
+
+void NchwcConv(const float* input, size_t input_step, const size_t* input_offsets,
+               const float* filter, const size_t* filter_offsets, size_t taps,
+               float* output, size_t count, size_t block) {
+    size_t p = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (block == kVecWidth) {
+        // 4个像素共用每个抽头的权重向量，隐藏FMA延迟
+        for (; p + 4 <= count; p += 4) {
+            const float* in = input + p * input_step;
+            float* out = output + p * block;
+            VecF acc0 = VLoad(out);
+            VecF acc1 = VLoad(out + block);
+            VecF acc2 = VLoad(out + 2 * block);
+            VecF acc3 = VLoad(out + 3 * block);
+            for (size_t t = 0; t < taps; ++t) {
+                const VecF w = VLoad(filter + filter_offsets[t]);
+                const float* x = in + input_offsets[t];
+                acc0 = VFma(VSet1(x[0]), w, acc0);
+                acc1 = VFma(VSet1(x[input_step]), w, acc1);
+                acc2 = VFma(VSet1(x[2 * input_step]), w, acc2);
+                acc3 = VFma(VSet1(x[3 * input_step]), w, acc3);
+            }
+            VStore(out, acc0);
+            VStore(out + block, acc1);
+            VStore(out + 2 * block, acc2);
+            VStore(out + 3 * block, acc3);
+        }
+    }
+    if (block % kVecWidth == 0) {
+        for (; p < count; ++p) {
+            const float* in = input + p * input_step;
+            float* out = output + p * block;
+            for (size_t o = 0; o < block; o += kVecWidth) {
+                VecF acc = VLoad(out + o);
+                for (size_t t = 0; t < taps; ++t) {
+                    acc = VFma(VSet1(in[input_offsets[t]]), VLoad(filter + filter_offsets[t] + o), acc);
+                }
+                VStore(out + o, acc);
+            }
+        }
+    }
+#endif
+    for (; p < count; ++p) {
+        const float* in = input + p * input_step;
+        float* out = output + p * block;
+        for (size_t t = 0; t < taps; ++t) {
+            const float x = in[input_offsets[t]];
+            const float* w = filter + filter_offsets[t];
+            for (size_t o = 0; o < block; ++o) {
+                out[o] += x * w[o];
+            }
+        }
+    }
+}
+
+// 没有有效抽头时MaxPool的输出（与NCHW实现一致，取最小的有限值）
+constexpr float kLowestFinite = -3.40282347e+38f;
+
+void NchwcPool(const float* input, size_t input_step, const size_t* input_offsets, size_t taps,
+               float* output, size_t count, size_t block, bool max_pool, float scale) {
+    size_t p = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (block % kVecWidth == 0) {
+        const VecF vinit = VSet1(max_pool ? kLowestFinite : 0.0f);
+        const VecF vscale = VSet1(scale);
+        for (; p < count; ++p) {
+            const float* in = input + p * input_step;
+            float* out = output + p * block;
+            for (size_t o = 0; o < block; o += kVecWidth) {
+                VecF acc = vinit;
+                if (max_pool) {
+                    for (size_t t = 0; t < taps; ++t) {
+                        acc = VMax(acc, VLoad(in + input_offsets[t] + o));
+                    }
+                    VStore(out + o, acc);
+                } else {
+                    for (size_t t = 0; t < taps; ++t) {
+                        acc = VAdd(acc, VLoad(in + input_offsets[t] + o));
+                    }
+                    VStore(out + o, VMul(acc, vscale));
+                }
+            }
+        }
+    }
+#endif
+    for (; p < count; ++p) {
+        const float* in = input + p * input_step;
+        float* out = output + p * block;
+        for (size_t o = 0; o < block; ++o) {
+            float acc = max_pool ? kLowestFinite : 0.0f;
+            for (size_t t = 0; t < taps; ++t) {
+                const float x = in[input_offsets[t] + o];
+                acc = max_pool ? (x > acc ? x : acc) : acc + x;
+            }
+            out[o] = max_pool ? acc : acc * scale;
+        }
+    }
+}
+
+// 一次计算kRows行：b的每个向量读一次，供kRows行的权重对复用
+template <size_t kRows>
+void QGemmRows(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+               size_t n, size_t k_pairs) {
+    size_t j = 0;
+#ifdef INFERUNITY_SIMD_VECI
+    for (; j + kVecIWidth <= n; j += kVecIWidth) {
+        VecI acc[kRows];
+        for (size_t r = 0; r < kRows; ++r) {
+            acc[r] = VZeroI();
+        }
+        for (size_t kp = 0; kp < k_pairs; ++kp) {
+            const VecP x = VLoadPairs(b_pairs + (kp * n + j) * 2);
+            for (size_t r = 0; r < kRows; ++r) {
+                acc[r] = VMaddPairs(acc[r], x, a_pairs[r * k_pairs + kp]);
+            }
+        }
+        for (size_t r = 0; r < kRows; ++r) {
+            VStoreI(output + r * n + j, acc[r]);
+        }
+    }
+#endif
+    for (; j < n; ++j) {
+        for (size_t r = 0; r < kRows; ++r) {
+            int32_t acc = 0;
+            for (size_t kp = 0; kp < k_pairs; ++kp) {
+                const int32_t w = a_pairs[r * k_pairs + kp];
+                const int16_t* x = b_pairs + (kp * n + j) * 2;
+                acc += static_cast<int32_t>(static_cast<int16_t>(w & 0xFFFF)) * x[0] +
+                       static_cast<int32_t>(static_cast<int16_t>(w >> 16)) * x[1];
+            }
+            output[r * n + j] = acc;
+        }
+    }
+}
+
+void QGemmS16(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+              size_t m, size_t n, size_t k_pairs) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        QGemmRows<4>(a_pairs + i * k_pairs, b_pairs, output + i * n, n, k_pairs);
+    }
+    for (; i < m; ++i) {
+        QGemmRows<1>(a_pairs + i * k_pairs, b_pairs, output + i * n, n, k_pairs);
+    }
+}
+
+inline int32_t DotQuadScalar(int32_t a, const uint8_t* b) {
+    return static_cast<int32_t>(static_cast<int8_t>(a & 0xFF)) * b[0] +
+           static_cast<int32_t>(static_cast<int8_t>((a >> 8) & 0xFF)) * b[1] +
+           static_cast<int32_t>(static_cast<int8_t>((a >> 16) & 0xFF)) * b[2] +
+           static_cast<int32_t>(static_cast<int8_t>(a >> 24)) * b[3];
+}
+
+// kRows行 x n列，只累加[kq_begin, kq_end)的k组；accumulate为false时覆盖输出
+template <size_t kRows>
+void QGemmU8S8Rows(const int32_t* a_quads, size_t lda, const uint8_t* b_quads, size_t ldb,
+                   int32_t* output, size_t ldc, size_t n, size_t kq_begin, size_t kq_end, bool accumulate) {
+    size_t j = 0;
+#ifdef INFERUNITY_SIMD_VECQ
+    int32_t bias[kRows];
+    for (size_t r = 0; r < kRows; ++r) {
+        bias[r] = 0;
+        if (kBiasedQuads) {
+            for (size_t kq = kq_begin; kq < kq_end; ++kq) {
+                const int32_t a = a_quads[r * lda + kq];
+                bias[r] += 128 * (static_cast<int8_t>(a & 0xFF) + static_cast<int8_t>((a >> 8) & 0xFF) +
+                                  static_cast<int8_t>((a >> 16) & 0xFF) + static_cast<int8_t>(a >> 24));
+            }
+        }
+    }
+    for (; j + kVecQWidth <= n; j += kVecQWidth) {
+        VecQ acc[kRows];
+        for (size_t r = 0; r < kRows; ++r) {
+            acc[r] = accumulate ? VLoadQ(output + r * ldc + j) : VZeroQ();
+        }
+        for (size_t kq = kq_begin; kq < kq_end; ++kq) {
+            const auto b = VLoadQuads(b_quads + (kq * ldb + j) * 4);
+            for (size_t r = 0; r < kRows; ++r) {
+                acc[r] = VDotQuads(acc[r], b, a_quads[r * lda + kq]);
+            }
+        }
+        for (size_t r = 0; r < kRows; ++r) {
+            VStoreQ(output + r * ldc + j, kBiasedQuads ? VAddQ(acc[r], bias[r]) : acc[r]);
+        }
+    }
+#endif
+    for (; j < n; ++j) {
+        for (size_t r = 0; r < kRows; ++r) {
+            int32_t acc = accumulate ? output[r * ldc + j] : 0;
+            for (size_t kq = kq_begin; kq < kq_end; ++kq) {
+                acc += DotQuadScalar(a_quads[r * lda + kq], b_quads + (kq * ldb + j) * 4);
+            }
+            output[r * ldc + j] = acc;
+        }
+    }
+}
+
+void QGemmU8S8Block(const int32_t* a_quads, size_t lda, const uint8_t* b_quads, size_t ldb,
+                    int32_t* output, size_t ldc, size_t m, size_t n, size_t kq_begin, size_t kq_end,
+                    bool accumulate) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        QGemmU8S8Rows<4>(a_quads + i * lda, lda, b_quads, ldb, output + i * ldc, ldc, n,
+                         kq_begin, kq_end, accumulate);
+    }
+    for (; i < m; ++i) {
+        QGemmU8S8Rows<1>(a_quads + i * lda, lda, b_quads, ldb, output + i * ldc, ldc, n,
+                         kq_begin, kq_end, accumulate);
+    }
+}
+
+#if defined(INFERUNITY_SIMD_AMX)
+// AMX-INT8（参考oneDNN的brgemm）：16x16的int32输出块放在tmm0，权重行块（16行 x 16个k组）放tmm1，
+// b的16个k组 x 16列放tmm2，tdpbsud（a为s8、b为u8）每次完成64个k。tile配置是线程状态，
+// 每次调用时加载并在结束时释放；不足16的行、列与k组由VNNI路径补齐
+struct alignas(64) AmxTileConfig {
+    uint8_t palette_id;
+    uint8_t start_row;
+    uint8_t reserved[14];
+    uint16_t colsb[16];
+    uint8_t rows[16];
+};
+
+void QGemmU8S8(const int32_t* a_quads, const uint8_t* b_quads, size_t ldb, int32_t* output, size_t ldc,
+               size_t m, size_t n, size_t k_quads) {
+    const size_t m_tiles = m / 16 * 16;
+    const size_t n_tiles = n / 16 * 16;
+    const size_t kq_tiles = k_quads / 16 * 16;
+    if (m_tiles == 0 || n_tiles == 0 || kq_tiles == 0) {
+        QGemmU8S8Block(a_quads, k_quads, b_quads, ldb, output, ldc, m, n, 0, k_quads, false);
+        return;
+    }
+    AmxTileConfig config = {};
+    config.palette_id = 1;
+    for (int t = 0; t < 3; ++t) {
+        config.rows[t] = 16;
+        config.colsb[t] = 64;
+    }
+    _tile_loadconfig(&config);
+    for (size_t i = 0; i < m_tiles; i += 16) {
+        for (size_t j = 0; j < n_tiles; j += 16) {
+            _tile_zero(0);
+            for (size_t kq = 0; kq < kq_tiles; kq += 16) {
+                _tile_loadd(1, a_quads + i * k_quads + kq, k_quads * sizeof(int32_t));
+                _tile_loadd(2, b_quads + (kq * ldb + j) * 4, ldb * 4);
+                _tile_dpbsud(0, 1, 2);
+            }
+            _tile_stored(0, output + i * ldc + j, ldc * sizeof(int32_t));
+        }
+    }
+    _tile_release();
+    if (kq_tiles < k_quads) {
+        QGemmU8S8Block(a_quads, k_quads, b_quads, ldb, output, ldc, m_tiles, n_tiles,
+                       kq_tiles, k_quads, true);
+    }
+    if (n_tiles < n) {
+        QGemmU8S8Block(a_quads, k_quads, b_quads + n_tiles * 4, ldb, output + n_tiles, ldc,
+                       m_tiles, n - n_tiles, 0, k_quads, false);
+    }
+    if (m_tiles < m) {
+        QGemmU8S8Block(a_quads + m_tiles * k_quads, k_quads, b_quads, ldb, output + m_tiles * ldc, ldc,
+                       m - m_tiles, n, 0, k_quads, false);
+    }
+}
+#else
+void QGemmU8S8(const int32_t* a_quads, const uint8_t* b_quads, size_t ldb, int32_t* output, size_t ldc,
+               size_t m, size_t n, size_t k_quads) {
+    QGemmU8S8Block(a_quads, k_quads, b_quads, ldb, output, ldc, m, n, 0, k_quads, false);
+}
+#endif
+
+// ---- 低比特权重点积（MatMulNBits的GEMV） ----
+// VLoadU8：kVecWidth个u8扩展为float；VLoadU4：kVecWidth个字节的2*kVecWidth个4位值（低4位在前）
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+inline VecF VLoadU8(const uint8_t* p) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+inline void VLoadU4(const uint8_t* p, VecF* lo, VecF* hi) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i low = _mm_and_si128(bytes, mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+    *lo = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_unpacklo_epi8(low, high)));
+    *hi = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_unpackhi_epi8(low, high)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+inline VecF VLoadU8(const uint8_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+inline void VLoadU4(const uint8_t* p, VecF* lo, VecF* hi) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i values = _mm_unpacklo_epi8(_mm_and_si128(bytes, mask),
+                                             _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+    *lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(values));
+    *hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(values, 8)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+inline __m128i LoadU32(const uint8_t* p) {
+    int32_t bits;
+    __builtin_memcpy(&bits, p, sizeof(bits));
+    return _mm_cvtsi32_si128(bits);
+}
+inline VecF VLoadU8(const uint8_t* p) {
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(LoadU32(p)));
+}
+inline void VLoadU4(const uint8_t* p, VecF* lo, VecF* hi) {
+    const __m128i bytes = LoadU32(p);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i values = _mm_unpacklo_epi8(_mm_and_si128(bytes, mask),
+                                             _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+    *lo = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(values));
+    *hi = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(values, 4)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+inline uint8x8_t LoadU32(const uint8_t* p) {
+    uint32_t bits;
+    __builtin_memcpy(&bits, p, sizeof(bits));
+    return vreinterpret_u8_u32(vdup_n_u32(bits));
+}
+inline VecF VLoadU8(const uint8_t* p) {
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(LoadU32(p)))));
+}
+inline void VLoadU4(const uint8_t* p, VecF* lo, VecF* hi) {
+    const uint8x8_t bytes = LoadU32(p);
+    const uint16x8_t values = vmovl_u8(vzip1_u8(vand_u8(bytes, vdup_n_u8(0x0F)), vshr_n_u8(bytes, 4)));
+    *lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(values)));
+    *hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(values)));
+}
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+inline VecF VLoadU8(const uint8_t* p) {
+    const v128_t bytes = wasm_v128_load32_zero(p);
+    return wasm_f32x4_convert_u32x4(wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(bytes)));
+}
+inline void VLoadU4(const uint8_t* p, VecF* lo, VecF* hi) {
+    const v128_t bytes = wasm_v128_load32_zero(p);
+    const v128_t low = wasm_v128_and(bytes, wasm_i8x16_splat(0x0F));
+    const v128_t high = wasm_u8x16_shr(bytes, 4);
+    const v128_t values = wasm_u16x8_extend_low_u8x16(
+        wasm_i8x16_shuffle(low, high, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23));
+    *lo = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_low_u16x8(values));
+    *hi = wasm_f32x4_convert_u32x4(wasm_u32x4_extend_high_u16x8(values));
+}
+#endif
+
+// sum(a[i] * q[i])，q为u8
+float DotU8(const float* a, const uint8_t* q, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+#ifdef INFERUNITY_SIMD_VEC
+    VecF acc0 = VSet1(0.0f), acc1 = VSet1(0.0f);
+    for (; i + 2 * kVecWidth <= count; i += 2 * kVecWidth) {
+        acc0 = VFma(VLoad(a + i), VLoadU8(q + i), acc0);
+        acc1 = VFma(VLoad(a + i + kVecWidth), VLoadU8(q + i + kVecWidth), acc1);
+    }
+    sum = VReduceAdd(VAdd(acc0, acc1));
+#endif
+    for (; i < count; ++i) {
+        sum += a[i] * static_cast<float>(q[i]);
+    }
+    return sum;
+}
+
+// output[i] = input[i] * scale + shift，input为u8
+void U8Affine(const uint8_t* input, float* output, size_t count, float scale, float shift) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vscale = VSet1(scale);
+    const VecF vshift = VSet1(shift);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VStore(output + i, VFma(VLoadU8(input + i), vscale, vshift));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = static_cast<float>(input[i]) * scale + shift;
+    }
+}
+
+// sum(a[i] * q[i])，q每个字节放两个4位值，第i个在字节i/2的低4位（i为偶数）或高4位
+float DotU4(const float* a, const uint8_t* q, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+#ifdef INFERUNITY_SIMD_VEC
+    VecF acc0 = VSet1(0.0f), acc1 = VSet1(0.0f);
+    for (; i + 2 * kVecWidth <= count; i += 2 * kVecWidth) {
+        VecF lo, hi;
+        VLoadU4(q + i / 2, &lo, &hi);
+        acc0 = VFma(VLoad(a + i), lo, acc0);
+        acc1 = VFma(VLoad(a + i + kVecWidth), hi, acc1);
+    }
+    sum = VReduceAdd(VAdd(acc0, acc1));
+#endif
+    for (; i < count; ++i) {
+        const uint8_t byte = q[i / 2];
+        sum += a[i] * static_cast<float>((i & 1) ? (byte >> 4) : (byte & 0x0F));
+    }
+    return sum;
+}
+
+// ---- 稀疏权重 ----
+
+// 块稀疏CSR一个块行：out[i] = sum(a[columns[e]] * values[e * block + i])，i < block，
+// 每个块为block个连续输出、同一个输入列的block x 1块
+void BlockSparseDot(const float* a, const float* values, const int32_t* columns, size_t count, size_t block,
+                    float* out) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    for (; i + kVecWidth <= block; i += kVecWidth) {
+        VecF acc0 = VSet1(0.0f), acc1 = VSet1(0.0f);
+        size_t e = 0;
+        for (; e + 2 <= count; e += 2) {
+            acc0 = VFma(VSet1(a[columns[e]]), VLoad(values + e * block + i), acc0);
+            acc1 = VFma(VSet1(a[columns[e + 1]]), VLoad(values + (e + 1) * block + i), acc1);
+        }
+        if (e < count) {
+            acc0 = VFma(VSet1(a[columns[e]]), VLoad(values + e * block + i), acc0);
+        }
+        VStore(out + i, VAdd(acc0, acc1));
+    }
+#endif
+    for (; i < block; ++i) {
+        float sum = 0.0f;
+        for (size_t e = 0; e < count; ++e) {
+            sum += a[columns[e]] * values[e * block + i];
+        }
+        out[i] = sum;
+    }
+}
+
+// 2:4结构化稀疏的点积：a每4个连续元素为一组，每组保留2个权重，indices为其组内偏移（0~3）
+float SparseDot2of4(const float* a, const float* values, const uint8_t* indices, size_t groups) {
+    size_t g = 0;
+    float sum = 0.0f;
+#ifdef INFERUNITY_SIMD_VEC
+    // 被选中的a先按偏移收集到连续的缓冲区，乘加仍按向量完成
+    VecF acc = VSet1(0.0f);
+    float gathered[kVecWidth];
+    for (; 2 * g + kVecWidth <= 2 * groups; g += kVecWidth / 2) {
+        for (size_t l = 0; l < kVecWidth; ++l) {
+            gathered[l] = a[4 * (g + l / 2) + indices[2 * g + l]];
+        }
+        acc = VFma(VLoad(values + 2 * g), VLoad(gathered), acc);
+    }
+    sum = VReduceAdd(acc);
+#endif
+    for (; g < groups; ++g) {
+        sum += values[2 * g] * a[4 * g + indices[2 * g]] + values[2 * g + 1] * a[4 * g + indices[2 * g + 1]];
+    }
+    return sum;
+}
+
+// ---- 归一化 ----
+
+// x = a + b（b为nullptr时x = a，此时不写sum）的单遍Welford均值与M2 = sum((x - mean)^2)：
+// 每个通道各自递推，最后按Chan的并行公式合并（各通道元素个数相同）
+void AddWelford(const float* a, const float* b, float* sum, size_t count, float* mean_out, float* m2_out) {
+    float mean = 0.0f;
+    float m2 = 0.0f;
+    size_t n = 0;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    if (count >= kVecWidth) {
+        VecF vmean = VSet1(0.0f);
+        VecF vm2 = VSet1(0.0f);
+        size_t steps = 0;
+        for (; i + kVecWidth <= count; i += kVecWidth) {
+            VecF x = VLoad(a + i);
+            if (b) {
+                x = VAdd(x, VLoad(b + i));
+                if (sum) {
+                    VStore(sum + i, x);
+                }
+            }
+            ++steps;
+            const VecF delta = VSub(x, vmean);
+            vmean = VFma(delta, VSet1(1.0f / static_cast<float>(steps)), vmean);
+            vm2 = VFma(delta, VSub(x, vmean), vm2);
+        }
+        alignas(64) float lane_mean[kVecWidth];
+        alignas(64) float lane_m2[kVecWidth];
+        VStore(lane_mean, vmean);
+        VStore(lane_m2, vm2);
+        for (size_t l = 0; l < kVecWidth; ++l) {
+            mean += lane_mean[l];
+            m2 += lane_m2[l];
+        }
+        mean /= static_cast<float>(kVecWidth);
+        for (size_t l = 0; l < kVecWidth; ++l) {
+            const float d = lane_mean[l] - mean;
+            m2 += static_cast<float>(steps) * d * d;
+        }
+        n = steps * kVecWidth;
+    }
+#endif
+    for (; i < count; ++i) {
+        float x = a[i];
+        if (b) {
+            x += b[i];
+            if (sum) {
+                sum[i] = x;
+            }
+        }
+        ++n;
+        const float delta = x - mean;
+        mean += delta / static_cast<float>(n);
+        m2 += delta * (x - mean);
+    }
+    *mean_out = mean;
+    *m2_out = m2;
+}
+
+// sum(x^2)，x与sum的约定同AddWelford
+float AddSumSquares(const float* a, const float* b, float* sum, size_t count) {
+    float result = 0.0f;
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    VecF vsum = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        VecF x = VLoad(a + i);
+        if (b) {
+            x = VAdd(x, VLoad(b + i));
+            if (sum) {
+                VStore(sum + i, x);
+            }
+        }
+        vsum = VFma(x, x, vsum);
+    }
+    result = VReduceAdd(vsum);
+#endif
+    for (; i < count; ++i) {
+        float x = a[i];
+        if (b) {
+            x += b[i];
+            if (sum) {
+                sum[i] = x;
+            }
+        }
+        result += x * x;
+    }
+    return result;
+}
+
+// y = (x - shift) * inv_std * gamma + beta（beta可为nullptr）
+void NormalizeScale(const float* input, float* output, size_t count, float shift, float inv_std,
+                    const float* gamma, const float* beta) {
+    size_t i = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    const VecF vshift = VSet1(shift);
+    const VecF vinv = VSet1(inv_std);
+    const VecF vzero = VSet1(0.0f);
+    for (; i + kVecWidth <= count; i += kVecWidth) {
+        const VecF normalized = VMul(VSub(VLoad(input + i), vshift), vinv);
+        VStore(output + i, VFma(normalized, VLoad(gamma + i), beta ? VLoad(beta + i) : vzero));
+    }
+#endif
+    for (; i < count; ++i) {
+        const float scaled = (input[i] - shift) * inv_std * gamma[i];
+        output[i] = beta ? scaled + beta[i] : scaled;
+    }
+}
+
+// ---- 形状特化内核 ----
+// 行长kCount为模板参数（取值见kSpecializedRowSizes），循环次数固定，编译器可完全展开；
+// 不超过kResidentVecs个向量的短行整行留在寄存器中，后续各遍不再读内存
+
+template <size_t kCount>
+void SoftmaxRowFixed(const float* input, float* output, bool log_softmax) {
+#ifdef INFERUNITY_SIMD_VEC
+    static_assert(kCount % kVecWidth == 0, "specialized row size must be a multiple of the vector width");
+    constexpr size_t kVecs = kCount / kVecWidth;
+    constexpr size_t kResidentVecs = 8;
+    VecF x[kVecs <= kResidentVecs ? kVecs : 1];
+    VecF vmax = VLoad(input);
+    for (size_t k = 0; k < kVecs; ++k) {
+        const VecF v = VLoad(input + k * kVecWidth);
+        if constexpr (kVecs <= kResidentVecs) {
+            x[k] = v;
+        }
+        vmax = VMax(vmax, v);
+    }
+    const float max_val = VReduceMax(vmax);
+    const VecF vshift = VSet1(max_val);
+    VecF vsum = VSet1(0.0f);
+    for (size_t k = 0; k < kVecs; ++k) {
+        VecF e;
+        if constexpr (kVecs <= kResidentVecs) {
+            e = VExp(VSub(x[k], vshift));
+            x[k] = log_softmax ? x[k] : e;
+        } else {
+            e = VExp(VSub(VLoad(input + k * kVecWidth), vshift));
+            VStore(output + k * kVecWidth, e);  // LogSoftmax时只作临时缓冲
+        }
+        vsum = VAdd(vsum, e);
+    }
+    const float sum = VReduceAdd(vsum);
+    // Softmax乘1/sum；LogSoftmax为x - max - log(sum)
+    const VecF vscale = VSet1(1.0f / sum);
+    const VecF vlog = VSet1(max_val + __builtin_logf(sum));
+    for (size_t k = 0; k < kVecs; ++k) {
+        VecF v;
+        if constexpr (kVecs <= kResidentVecs) {
+            v = x[k];
+        } else {
+            v = log_softmax ? VLoad(input + k * kVecWidth) : VLoad(output + k * kVecWidth);
+        }
+        VStore(output + k * kVecWidth, log_softmax ? VSub(v, vlog) : VMul(v, vscale));
+    }
+#else
+    const float max_val = ReduceMax(input, kCount);
+    const float sum = ExpShiftSum(input, output, kCount, max_val);
+    if (log_softmax) {
+        AddScalar(input, output, kCount, -(max_val + __builtin_logf(sum)));
+    } else {
+        Scale(output, output, kCount, 1.0f / sum);
+    }
+#endif
+}
+
+// 一行LayerNorm/RMSNorm，x = a + b（b为nullptr时x = a，b与sum都不为nullptr时把x写入sum）。
+// 均值与方差按两遍求（行在L1中），rms为true时只求mean(x^2)，shift为0且不加beta
+template <size_t kCount>
+void NormRowFixed(const float* a, const float* b, float* sum, float* output, float epsilon,
+                  const float* gamma, const float* beta, bool rms) {
+    float mean = 0.0f;
+    float inv_std = 0.0f;
+#ifdef INFERUNITY_SIMD_VEC
+    static_assert(kCount % kVecWidth == 0, "specialized row size must be a multiple of the vector width");
+    constexpr size_t kVecs = kCount / kVecWidth;
+    constexpr size_t kResidentVecs = 8;
+    VecF x[kVecs <= kResidentVecs ? kVecs : 1];
+    auto load_x = [&](size_t k) {
+        if constexpr (kVecs <= kResidentVecs) {
+            return x[k];
+        } else {
+            const VecF v = VLoad(a + k * kVecWidth);
+            return b ? VAdd(v, VLoad(b + k * kVecWidth)) : v;
+        }
+    };
+    VecF vacc = VSet1(0.0f);
+    for (size_t k = 0; k < kVecs; ++k) {
+        VecF v = VLoad(a + k * kVecWidth);
+        if (b) {
+            v = VAdd(v, VLoad(b + k * kVecWidth));
+            if (sum) {
+                VStore(sum + k * kVecWidth, v);
+            }
+        }
+        if constexpr (kVecs <= kResidentVecs) {
+            x[k] = v;
+        }
+        vacc = rms ? VFma(v, v, vacc) : VAdd(vacc, v);
+    }
+    const float moment = VReduceAdd(vacc) / static_cast<float>(kCount);  // mean(x)或mean(x^2)
+    float var = moment;
+    if (!rms) {
+        mean = moment;
+        const VecF vmean = VSet1(mean);
+        VecF vm2 = VSet1(0.0f);
+        for (size_t k = 0; k < kVecs; ++k) {
+            const VecF d = VSub(load_x(k), vmean);
+            vm2 = VFma(d, d, vm2);
+        }
+        var = VReduceAdd(vm2) / static_cast<float>(kCount);
+    }
+    inv_std = 1.0f / __builtin_sqrtf(var + epsilon);
+    const VecF vshift = VSet1(mean);
+    const VecF vinv = VSet1(inv_std);
+    for (size_t k = 0; k < kVecs; ++k) {
+        const size_t i = k * kVecWidth;
+        const VecF normalized = VMul(VMul(VSub(load_x(k), vshift), vinv), VLoad(gamma + i));
+        VStore(output + i, !rms && beta ? VAdd(normalized, VLoad(beta + i)) : normalized);
+    }
+#else
+    float acc = 0.0f;
+    for (size_t i = 0; i < kCount; ++i) {
+        const float v = b ? a[i] + b[i] : a[i];
+        if (b && sum) {
+            sum[i] = v;
+        }
+        acc += rms ? v * v : v;
+    }
+    const float moment = acc / static_cast<float>(kCount);
+    float var = moment;
+    if (!rms) {
+        mean = moment;
+        float m2 = 0.0f;
+        for (size_t i = 0; i < kCount; ++i) {
+            const float d = (b ? a[i] + b[i] : a[i]) - mean;
+            m2 += d * d;
+        }
+        var = m2 / static_cast<float>(kCount);
+    }
+    inv_std = 1.0f / __builtin_sqrtf(var + epsilon);
+    for (size_t i = 0; i < kCount; ++i) {
+        const float normalized = ((b ? a[i] + b[i] : a[i]) - mean) * inv_std * gamma[i];
+        output[i] = !rms && beta ? normalized + beta[i] : normalized;
+    }
+#endif
+}
+
+static_assert(kNumSpecializedRowSizes == 7, "update the specialized kernel lists in kKernelTable");
+
+// ---- 半精度转换 ----
+// 标量部分与inferunity/float16.h相同；按本文件的约定在匿名命名空间内另写一份，不共享内联函数
+inline float BitsToFloat(uint32_t bits) {
+    float f;
+    __builtin_memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline uint32_t FloatToBits(float f) {
+    uint32_t bits;
+    __builtin_memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+inline float HalfToFloatScalar(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1Fu;
+    uint32_t mantissa = h & 0x3FFu;
+    if (exponent == 0x1Fu) {
+        return BitsToFloat(sign | 0x7F800000u | (mantissa << 13));
+    }
+    if (exponent != 0) {
+        return BitsToFloat(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+    }
+    if (mantissa == 0) {
+        return BitsToFloat(sign);
+    }
+    uint32_t e = 113;
+    while ((mantissa & 0x400u) == 0) {
+        mantissa <<= 1;
+        --e;
+    }
+    return BitsToFloat(sign | (e << 23) | ((mantissa & 0x3FFu) << 13));
+}
+
+inline uint16_t FloatToHalfScalar(float f) {
+    const uint32_t bits = FloatToBits(f);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t abs = bits & 0x7FFFFFFFu;
+    if (abs >= 0x7F800000u) {
+        return static_cast<uint16_t>(sign | (abs > 0x7F800000u ? 0x7E00u : 0x7C00u));
+    }
+    if (abs >= 0x477FF000u) {
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (abs < 0x38800000u) {
+        if (abs < 0x33000000u) {
+            return sign;
+        }
+        const uint32_t shift = 126u - (abs >> 23);
+        const uint32_t mantissa = (abs & 0x7FFFFFu) | 0x800000u;
+        uint32_t value = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t half = 1u << (shift - 1u);
+        if (remainder > half || (remainder == half && (value & 1u))) {
+            ++value;
+        }
+        return static_cast<uint16_t>(sign | value);
+    }
+    const uint32_t rounded = abs + 0xFFFu + ((abs >> 13) & 1u);
+    return static_cast<uint16_t>(sign | ((rounded - 0x38000000u) >> 13));
+}
+
+inline uint16_t FloatToBFloat16Scalar(float f) {
+    const uint32_t bits = FloatToBits(f);
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<uint16_t>((bits >> 16) | 0x40u);
+    }
+    return static_cast<uint16_t>((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+}
+
+// FLOAT16 -> FP32：x86用F16C/AVX-512的vcvtph2ps，NEON用fcvtl
+void HalfToFloat(const uint16_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(output + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i))));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_AVX2) && defined(__F16C__)
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(output + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(input + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = HalfToFloatScalar(input[i]);
+    }
+}
+
+void FloatToHalf(const float* input, uint16_t* output, size_t count) {
+    size_t i = 0;
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i),
+                            _mm512_cvtps_ph(_mm512_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_AVX2) && defined(__F16C__)
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(output + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(input + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = FloatToHalfScalar(input[i]);
+    }
+}
+
+// BFLOAT16 -> FP32：零扩展后左移16位
+void BFloat16ToFloat(const uint16_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        const __m512i wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)));
+        _mm512_storeu_ps(output + i, _mm512_castsi512_ps(_mm512_slli_epi32(wide, 16)));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        const __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+        _mm256_storeu_ps(output + i, _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16)));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+    for (; i + 4 <= count; i += 4) {
+        const __m128i wide = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i)));
+        _mm_storeu_ps(output + i, _mm_castsi128_ps(_mm_slli_epi32(wide, 16)));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(output + i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(input + i), 16)));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+    for (; i + 4 <= count; i += 4) {
+        wasm_v128_store(output + i, wasm_i32x4_shl(wasm_u32x4_load16x4(input + i), 16));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = BitsToFloat(static_cast<uint32_t>(input[i]) << 16);
+    }
+}
+
+// FP32 -> BFLOAT16：bits + 0x7FFF + 保留位的最低位（就近舍入到偶数），NaN置静默位
+void FloatToBFloat16(const float* input, uint16_t* output, size_t count) {
+    size_t i = 0;
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        const __m512 x = _mm512_loadu_ps(input + i);
+        const __m512i bits = _mm512_castps_si512(x);
+        const __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+        __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF))), 16);
+        const __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+        rounded = _mm512_mask_mov_epi32(rounded, nan, _mm512_or_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(0x40)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm512_cvtepi32_epi16(rounded));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        const __m256 x = _mm256_loadu_ps(input + i);
+        const __m256i bits = _mm256_castps_si256(x);
+        const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+        const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+        rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40)), nan);
+        // packus在128位通道内交错，permute恢复顺序
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm256_castsi256_si128(packed));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(input + i);
+        const __m128i bits = _mm_castps_si128(x);
+        const __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+        __m128i rounded = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF))), 16);
+        const __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(x, x));
+        rounded = _mm_blendv_epi8(rounded, _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x40)), nan);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi32(rounded, rounded));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t x = vld1q_f32(input + i);
+        const uint32x4_t bits = vreinterpretq_u32_f32(x);
+        const uint32x4_t lsb = vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+        const uint32x4_t rounded = vaddq_u32(bits, vaddq_u32(lsb, vdupq_n_u32(0x7FFF)));
+        const uint32x4_t nan = vmvnq_u32(vceqq_f32(x, x));
+        const uint32x4_t result = vbslq_u32(nan, vorrq_u32(bits, vdupq_n_u32(0x400000)), rounded);
+        vst1_u16(output + i, vshrn_n_u32(result, 16));
+    }
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+    for (; i + 4 <= count; i += 4) {
+        const v128_t x = wasm_v128_load(input + i);
+        const v128_t lsb = wasm_v128_and(wasm_u32x4_shr(x, 16), wasm_i32x4_splat(1));
+        v128_t rounded = wasm_u32x4_shr(wasm_i32x4_add(x, wasm_i32x4_add(lsb, wasm_i32x4_splat(0x7FFF))), 16);
+        const v128_t nan = wasm_f32x4_ne(x, x);
+        rounded = wasm_v128_bitselect(wasm_v128_or(wasm_u32x4_shr(x, 16), wasm_i32x4_splat(0x40)), rounded, nan);
+        wasm_v128_store64_lane(output + i, wasm_u16x8_narrow_i32x4(rounded, rounded), 0);
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = FloatToBFloat16Scalar(input[i]);
+    }
+}
+
+// ---- 瘦矩阵乘（M <= 8的解码阶段GEMM/GEMV）----
+// B按类型读取并在寄存器中转为FP32：0/1/2表示FP32/FLOAT16/BFLOAT16
+template <int kBType>
+inline float LoadB(const void* b, size_t i) {
+    if (kBType == 0) {
+        return static_cast<const float*>(b)[i];
+    }
+    const uint16_t h = static_cast<const uint16_t*>(b)[i];
+    return kBType == 1 ? HalfToFloatScalar(h) : BitsToFloat(static_cast<uint32_t>(h) << 16);
+}
+
+// 提前预取的B行数，足以覆盖DRAM延迟；每次只预取当前寄存器块覆盖的缓存行
+constexpr size_t kSkinnyPrefetchRows = 8;
+
+inline void PrefetchBytes(const void* p, size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    for (size_t offset = 0; offset < bytes; offset += 64) {
+        __builtin_prefetch(static_cast<const uint8_t*>(p) + offset, 0, 0);
+    }
+#else
+    (void)p;
+    (void)bytes;
+#endif
+}
+
+#ifdef INFERUNITY_SIMD_VEC
+template <int kBType>
+inline VecF VLoadB(const void* b, size_t i) {
+    if (kBType == 0) {
+        return VLoad(static_cast<const float*>(b) + i);
+    }
+    const uint16_t* h = static_cast<const uint16_t*>(b) + i;
+    if (kBType == 2) {
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+        const __m512i wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(h)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(wide, 16));
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+        const __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+        const __m128i wide = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(h)));
+        return _mm_castsi128_ps(_mm_slli_epi32(wide, 16));
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+        return vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(h), 16));
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+        return wasm_i32x4_shl(wasm_u32x4_load16x4(h), 16);
+#endif
+    }
+#if defined(INFERUNITY_SIMD_ISA_AVX512)
+    return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(h)));
+#elif defined(INFERUNITY_SIMD_ISA_AVX2) && defined(__F16C__)
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+    return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h)));
+#else
+    float lanes[kVecWidth];
+    for (size_t l = 0; l < kVecWidth; ++l) {
+        lanes[l] = HalfToFloatScalar(h[l]);
+    }
+    return VLoad(lanes);
+#endif
+}
+#endif
+
+// B为[k][n]：kRows行的累加器常驻寄存器，沿k逐行读取B的一段列，每个B元素只读一次；
+// 行少时每段多取几个向量，保持足够多的独立FMA链
+template <int kRows, int kBType>
+void SkinnyGemmNN(const float* a, size_t lda, const void* b, size_t ldb, float* c, size_t ldc, size_t n,
+                  size_t k) {
+    size_t j = 0;
+#ifdef INFERUNITY_SIMD_VEC
+    constexpr size_t kBSize = kBType == 0 ? sizeof(float) : sizeof(uint16_t);
+    constexpr size_t kCols = kRows <= 2 ? 4 : (kRows <= 4 ? 2 : 1);
+    for (; j + kCols * kVecWidth <= n; j += kCols * kVecWidth) {
+        VecF acc[kRows][kCols];
+        for (int r = 0; r < kRows; ++r) {
+            for (size_t v = 0; v < kCols; ++v) {
+                acc[r][v] = VSet1(0.0f);
+            }
+        }
+        for (size_t p = 0; p < k; ++p) {
+            if (p + kSkinnyPrefetchRows < k) {
+                PrefetchBytes(static_cast<const uint8_t*>(b) + ((p + kSkinnyPrefetchRows) * ldb + j) * kBSize,
+                              kCols * kVecWidth * kBSize);
+            }
+            VecF bv[kCols];
+            for (size_t v = 0; v < kCols; ++v) {
+                bv[v] = VLoadB<kBType>(b, p * ldb + j + v * kVecWidth);
+            }
+            for (int r = 0; r < kRows; ++r) {
+                const VecF av = VSet1(a[r * lda + p]);
+                for (size_t v = 0; v < kCols; ++v) {
+                    acc[r][v] = VFma(av, bv[v], acc[r][v]);
+                }
+            }
+        }
+        for (int r = 0; r < kRows; ++r) {
+            for (size_t v = 0; v < kCols; ++v) {
+                VStore(c + r * ldc + j + v * kVecWidth, acc[r][v]);
+            }
+        }
+    }
+    for (; j + kVecWidth <= n; j += kVecWidth) {
+        VecF acc[kRows];
+        for (int r = 0; r < kRows; ++r) {
+            acc[r] = VSet1(0.0f);
+        }
+        for (size_t p = 0; p < k; ++p) {
+            const VecF bv = VLoadB<kBType>(b, p * ldb + j);
+            for (int r = 0; r < kRows; ++r) {
+                acc[r] = VFma(VSet1(a[r * lda + p]), bv, acc[r]);
+            }
+        }
+        for (int r = 0; r < kRows; ++r) {
+            VStore(c + r * ldc + j, acc[r]);
+        }
+    }
+#endif
+    for (; j < n; ++j) {
+        float acc[kRows] = {};
+        for (size_t p = 0; p < k; ++p) {
+            const float bv = LoadB<kBType>(b, p * ldb + j);
+            for (int r = 0; r < kRows; ++r) {
+                acc[r] += a[r * lda + p] * bv;
+            }
+        }
+        for (int r = 0; r < kRows; ++r) {
+            c[r * ldc + j] = acc[r];
+        }
+    }
+}
+
+// B为[n][k]：B的每一行与kRows行A同时做点积，B只流式读取一遍；行少时同时处理两行B
+template <int kRows, int kBType>
+void SkinnyGemmNT(const float* a, size_t lda, const void* b, size_t ldb, float* c, size_t ldc, size_t n,
+                  size_t k) {
+    constexpr size_t kJ = kRows <= 4 ? 2 : 1;
+    size_t j = 0;
+    for (; j < n; j += kJ) {
+        const size_t cols = std::min(kJ, n - j);
+        float sums[kRows][kJ] = {};
+        size_t p = 0;
+#ifdef INFERUNITY_SIMD_VEC
+        if (cols == kJ) {
+            constexpr size_t kBSize = kBType == 0 ? sizeof(float) : sizeof(uint16_t);
+            VecF acc[kRows][kJ];
+            for (int r = 0; r < kRows; ++r) {
+                for (size_t v = 0; v < kJ; ++v) {
+                    acc[r][v] = VSet1(0.0f);
+                }
+            }
+            for (; p + kVecWidth <= k; p += kVecWidth) {
+                VecF bv[kJ];
+                for (size_t v = 0; v < kJ; ++v) {
+                    // 下一组B行的同一位置提前取入，行间跳转处硬件预取跟不上
+                    if (j + kJ + v < n) {
+                        PrefetchBytes(static_cast<const uint8_t*>(b) + ((j + kJ + v) * ldb + p) * kBSize,
+                                      kVecWidth * kBSize);
+                    }
+                    bv[v] = VLoadB<kBType>(b, (j + v) * ldb + p);
+                }
+                for (int r = 0; r < kRows; ++r) {
+                    const VecF av = VLoad(a + r * lda + p);
+                    for (size_t v = 0; v < kJ; ++v) {
+                        acc[r][v] = VFma(av, bv[v], acc[r][v]);
+                    }
+                }
+            }
+            for (int r = 0; r < kRows; ++r) {
+                for (size_t v = 0; v < kJ; ++v) {
+                    sums[r][v] = VReduceAdd(acc[r][v]);
+                }
+            }
+        }
+#endif
+        for (; p < k; ++p) {
+            for (size_t v = 0; v < cols; ++v) {
+                const float bv = LoadB<kBType>(b, (j + v) * ldb + p);
+                for (int r = 0; r < kRows; ++r) {
+                    sums[r][v] += a[r * lda + p] * bv;
+                }
+            }
+        }
+        for (int r = 0; r < kRows; ++r) {
+            for (size_t v = 0; v < cols; ++v) {
+                c[r * ldc + j + v] = sums[r][v];
+            }
+        }
+    }
+}
+
+using SkinnyGemmFn = void (*)(const float*, size_t, const void*, size_t, float*, size_t, size_t, size_t);
+
+template <int kBType>
+void SkinnyGemmTyped(const float* a, size_t lda, const void* b, size_t ldb, bool trans_b, float* c, size_t ldc,
+                     size_t m, size_t n, size_t k) {
+    static const SkinnyGemmFn kNN[8] = {
+        SkinnyGemmNN<1, kBType>, SkinnyGemmNN<2, kBType>, SkinnyGemmNN<3, kBType>, SkinnyGemmNN<4, kBType>,
+        SkinnyGemmNN<5, kBType>, SkinnyGemmNN<6, kBType>, SkinnyGemmNN<7, kBType>, SkinnyGemmNN<8, kBType>};
+    static const SkinnyGemmFn kNT[8] = {
+        SkinnyGemmNT<1, kBType>, SkinnyGemmNT<2, kBType>, SkinnyGemmNT<3, kBType>, SkinnyGemmNT<4, kBType>,
+        SkinnyGemmNT<5, kBType>, SkinnyGemmNT<6, kBType>, SkinnyGemmNT<7, kBType>, SkinnyGemmNT<8, kBType>};
+    // 超过8行时按8行一组（调用方通常只在M <= 8时使用）
+    while (m > 0) {
+        const size_t rows = std::min<size_t>(m, 8);
+        (trans_b ? kNT : kNN)[rows - 1](a, lda, b, ldb, c, ldc, n, k);
+        a += rows * lda;
+        c += rows * ldc;
+        m -= rows;
+    }
+}
+
+void SkinnyGemm(const float* a, size_t lda, const void* b, int b_type, size_t ldb, bool trans_b, float* c,
+                size_t ldc, size_t m, size_t n, size_t k) {
+    switch (b_type) {
+        case 1:
+            SkinnyGemmTyped<1>(a, lda, b, ldb, trans_b, c, ldc, m, n, k);
+            break;
+        case 2:
+            SkinnyGemmTyped<2>(a, lda, b, ldb, trans_b, c, ldc, m, n, k);
+            break;
+        default:
+            SkinnyGemmTyped<0>(a, lda, b, ldb, trans_b, c, ldc, m, n, k);
+            break;
+    }
+}
+
+#undef INFERUNITY_UNARY_LOOP
+#undef INFERUNITY_BINARY_LOOP
+#undef INFERUNITY_SIMD_VEC
+#undef INFERUNITY_SIMD_VECI
+#undef INFERUNITY_SIMD_VECQ
+
+#if defined(INFERUNITY_SIMD_AMX)
+constexpr const char* kIsaName = "amx";
+#elif defined(INFERUNITY_SIMD_AVX512_VNNI)
+constexpr const char* kIsaName = "avx512_vnni";
+#elif defined(INFERUNITY_SIMD_ISA_AVX512)
+constexpr const char* kIsaName = "avx512";
+#elif defined(INFERUNITY_SIMD_ISA_AVX2)
+constexpr const char* kIsaName = "avx2";
+#elif defined(INFERUNITY_SIMD_ISA_SSE42)
+constexpr const char* kIsaName = "sse42";
+#elif defined(INFERUNITY_SIMD_NEON_DOT)
+constexpr const char* kIsaName = "neon_dot";
+#elif defined(INFERUNITY_SIMD_ISA_NEON)
+constexpr const char* kIsaName = "neon";
+#elif defined(INFERUNITY_SIMD_ISA_WASM)
+constexpr const char* kIsaName = "wasm_simd128";
+#else
+constexpr const char* kIsaName = "scalar";
+#endif
+
+const SimdKernelTable kKernelTable = {
+    kIsaName,
+    Add, Mul, Max, ExpSub,
+    Relu, Exp, Log, Tanh, Erf, Sigmoid, Silu, Gelu,
+    ReduceMax, ReduceSum, ExpShiftSum, OnlineMaxExpSum, ExpShiftScale, Scale, AddScalar,
+    Transpose2D, NchwcConv, QGemmS16, QGemmU8S8, kQGemmU8S8Exact,
+    HalfToFloat, FloatToHalf, BFloat16ToFloat, FloatToBFloat16,
+    DotU4, DotU8,
+    AddWelford, AddSumSquares, NormalizeScale,
+    NchwcPool,
+    Binary,
+    ReduceMin, ReduceSumSquares, AccumulateSquares,
+    SelectGreater,
+    ScaleAdd,
+    DepthwiseConvRow,
+    BoxIoU,
+    BlockSparseDot, SparseDot2of4,
+    SkinnyGemm,
+    U8Affine,
+    {SoftmaxRowFixed<kSpecializedRowSizes[0]>, SoftmaxRowFixed<kSpecializedRowSizes[1]>,
+     SoftmaxRowFixed<kSpecializedRowSizes[2]>, SoftmaxRowFixed<kSpecializedRowSizes[3]>,
+     SoftmaxRowFixed<kSpecializedRowSizes[4]>, SoftmaxRowFixed<kSpecializedRowSizes[5]>,
+     SoftmaxRowFixed<kSpecializedRowSizes[6]>},
+    {NormRowFixed<kSpecializedRowSizes[0]>, NormRowFixed<kSpecializedRowSizes[1]>,
+     NormRowFixed<kSpecializedRowSizes[2]>, NormRowFixed<kSpecializedRowSizes[3]>,
+     NormRowFixed<kSpecializedRowSizes[4]>, NormRowFixed<kSpecializedRowSizes[5]>,
+     NormRowFixed<kSpecializedRowSizes[6]>},
+};
+
+} // anonymous namespace
+
+const SimdKernelTable* INFERUNITY_SIMD_TABLE_GETTER() {
+    return &kKernelTable;
+}
+
+} // namespace simd
+} // namespace inferunity
@@ -0,0 +1,24 @@
+// AArch64 NEON SIMD核（4路）
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；其他架构上只提供返回nullptr的入口
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+#define INFERUNITY_SIMD_ISA_NEON 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetNeonKernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetNeonKernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
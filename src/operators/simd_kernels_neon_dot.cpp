@@ -0,0 +1,25 @@
+// AArch64 NEON点积SIMD核（以-march=armv8.2-a+dotprod编译）：浮点核与NEON相同，u8s8整数GEMM使用sdot
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；编译器或架构不支持时只提供返回nullptr的入口
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(__ARM_FEATURE_DOTPROD)
+
+#define INFERUNITY_SIMD_ISA_NEON 1
+#define INFERUNITY_SIMD_NEON_DOT 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetNeonDotKernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetNeonDotKernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
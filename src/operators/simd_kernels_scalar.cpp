@@ -0,0 +1,6 @@
+// 标量SIMD核（无向量指令，任何CPU均可运行，作为分发的兜底）
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择
+
+#define INFERUNITY_SIMD_TABLE_GETTER GetScalarKernels
+
+#include "simd_kernels_impl.h"
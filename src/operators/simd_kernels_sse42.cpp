@@ -0,0 +1,28 @@
+// SSE4.2 SIMD核（4路，以-msse4.2编译）
+// 实现见simd_kernels_impl.h，运行时由simd_utils.cpp按CPU特性选择；其他架构上只提供返回nullptr的入口
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#if defined(__GNUC__) && !defined(__SSE4_2__)
+#error "simd_kernels_sse42.cpp must be compiled with the matching ISA flags"
+#endif
+
+#define INFERUNITY_SIMD_ISA_SSE42 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetSse42Kernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetSse42Kernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
@@ -0,0 +1,24 @@
+// WebAssembly SIMD128核（4路）
+// 实现见simd_kernels_impl.h；SIMD128在编译期启用（-msimd128），未启用时只提供返回nullptr的入口
+
+#if defined(__wasm_simd128__)
+
+#define INFERUNITY_SIMD_ISA_WASM 1
+#define INFERUNITY_SIMD_TABLE_GETTER GetWasmSimdKernels
+#include "simd_kernels_impl.h"
+
+#else
+
+#include "simd_kernels.h"
+
+namespace inferunity {
+namespace simd {
+
+const SimdKernelTable* GetWasmSimdKernels() {
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace inferunity
+
+#endif
@@ -1,181 +1,430 @@
 // SIMD工具函数实现
-// 参考NCNN的SIMD实现
+// 参考NCNN的SIMD实现；向量核按ISA拆分在simd_kernels_<isa>.cpp中，
+// 这里按运行时CPU特性（参考ONNX Runtime MLAS的平台分发）选择一张函数表并转发
 
 #include "simd_utils.h"
+#include "simd_kernels.h"
+#include "inferunity/cpu_features.h"
+#include "gemm.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
 
 namespace inferunity {
 namespace simd {
 
-void AddSIMD(const float* a, const float* b, float* c, size_t count) {
-    size_t i = 0;
-    
-#ifdef __AVX__
-    if (HasAVX() && count >= 8) {
-        size_t simd_count = count & ~7;  // 8的倍数
-        for (; i < simd_count; i += 8) {
-            __m256 va = _mm256_loadu_ps(a + i);
-            __m256 vb = _mm256_loadu_ps(b + i);
-            __m256 vc = _mm256_add_ps(va, vb);
-            _mm256_storeu_ps(c + i, vc);
-        }
+using namespace detail;
+
+namespace {
+
+// 按优先级选择当前CPU支持的最宽ISA
+const SimdKernelTable* SelectKernels() {
+    const CpuFeatures& features = GetCpuFeatures();
+    if (features.avx512f && features.avx512_vnni && features.amx_int8 && GetAmxKernels()) {
+        return GetAmxKernels();
     }
-#elif defined(__SSE__)
-    if (HasSSE() && count >= 4) {
-        size_t simd_count = count & ~3;  // 4的倍数
-        for (; i < simd_count; i += 4) {
-            __m128 va = _mm_loadu_ps(a + i);
-            __m128 vb = _mm_loadu_ps(b + i);
-            __m128 vc = _mm_add_ps(va, vb);
-            _mm_storeu_ps(c + i, vc);
-        }
+    if (features.avx512f && features.avx512_vnni && GetAvx512VnniKernels()) {
+        return GetAvx512VnniKernels();
     }
-#elif defined(__ARM_NEON)
-    if (HasNEON() && count >= 4) {
-        size_t simd_count = count & ~3;  // 4的倍数
-        for (; i < simd_count; i += 4) {
-            float32x4_t va = vld1q_f32(a + i);
-            float32x4_t vb = vld1q_f32(b + i);
-            float32x4_t vc = vaddq_f32(va, vb);
-            vst1q_f32(c + i, vc);
-        }
+    if (features.avx512f && GetAvx512Kernels()) {
+        return GetAvx512Kernels();
+    }
+    if (features.avx2 && features.fma && features.f16c && GetAvx2Kernels()) {
+        return GetAvx2Kernels();
+    }
+    if (features.sse42 && GetSse42Kernels()) {
+        return GetSse42Kernels();
+    }
+    if (features.neon && features.neon_dotprod && GetNeonDotKernels()) {
+        return GetNeonDotKernels();
+    }
+    if (features.neon && GetNeonKernels()) {
+        return GetNeonKernels();
     }
-#endif
-    
-    // 处理剩余元素
-    for (; i < count; ++i) {
-        c[i] = a[i] + b[i];
+    if (features.wasm_simd128 && GetWasmSimdKernels()) {
+        return GetWasmSimdKernels();
     }
+    return GetScalarKernels();
 }
 
-void MulSIMD(const float* a, const float* b, float* c, size_t count) {
-    size_t i = 0;
-    
-#ifdef __AVX__
-    if (HasAVX() && count >= 8) {
-        size_t simd_count = count & ~7;
-        for (; i < simd_count; i += 8) {
-            __m256 va = _mm256_loadu_ps(a + i);
-            __m256 vb = _mm256_loadu_ps(b + i);
-            __m256 vc = _mm256_mul_ps(va, vb);
-            _mm256_storeu_ps(c + i, vc);
-        }
-    }
-#elif defined(__SSE__)
-    if (HasSSE() && count >= 4) {
-        size_t simd_count = count & ~3;
-        for (; i < simd_count; i += 4) {
-            __m128 va = _mm_loadu_ps(a + i);
-            __m128 vb = _mm_loadu_ps(b + i);
-            __m128 vc = _mm_mul_ps(va, vb);
-            _mm_storeu_ps(c + i, vc);
-        }
+std::atomic<const SimdKernelTable*>& ActiveKernelSlot() {
+    static std::atomic<const SimdKernelTable*> slot(SelectKernels());
+    return slot;
+}
+
+inline const SimdKernelTable& ActiveKernels() {
+    return *ActiveKernelSlot().load(std::memory_order_relaxed);
+}
+
+} // anonymous namespace
+
+bool HasSSE() {
+    return GetCpuFeatures().sse42;
+}
+
+bool HasAVX() {
+    return GetCpuFeatures().avx;
+}
+
+bool HasNEON() {
+    return GetCpuFeatures().neon;
+}
+
+void InitializeSimdDispatch() {
+    ActiveKernelSlot();
+}
+
+const char* GetSimdIsaName() {
+    return ActiveKernels().isa;
+}
+
+bool SetSimdIsa(const char* name) {
+    if (!name) {
+        return false;
     }
-#elif defined(__ARM_NEON)
-    if (HasNEON() && count >= 4) {
-        size_t simd_count = count & ~3;
-        for (; i < simd_count; i += 4) {
-            float32x4_t va = vld1q_f32(a + i);
-            float32x4_t vb = vld1q_f32(b + i);
-            float32x4_t vc = vmulq_f32(va, vb);
-            vst1q_f32(c + i, vc);
-        }
+    const std::string isa(name);
+    const SimdKernelTable* table = nullptr;
+    const CpuFeatures& features = GetCpuFeatures();
+    if (isa == "auto") {
+        table = SelectKernels();
+    } else if (isa == "scalar") {
+        table = GetScalarKernels();
+    } else if (isa == "sse42") {
+        table = features.sse42 ? GetSse42Kernels() : nullptr;
+    } else if (isa == "avx2") {
+        table = features.avx2 && features.fma && features.f16c ? GetAvx2Kernels() : nullptr;
+    } else if (isa == "avx512") {
+        table = features.avx512f ? GetAvx512Kernels() : nullptr;
+    } else if (isa == "avx512_vnni") {
+        table = features.avx512f && features.avx512_vnni ? GetAvx512VnniKernels() : nullptr;
+    } else if (isa == "amx") {
+        table = features.avx512f && features.avx512_vnni && features.amx_int8 ? GetAmxKernels() : nullptr;
+    } else if (isa == "neon") {
+        table = features.neon ? GetNeonKernels() : nullptr;
+    } else if (isa == "neon_dot") {
+        table = features.neon && features.neon_dotprod ? GetNeonDotKernels() : nullptr;
+    } else if (isa == "wasm_simd128") {
+        table = features.wasm_simd128 ? GetWasmSimdKernels() : nullptr;
     }
-#endif
-    
-    // 处理剩余元素
-    for (; i < count; ++i) {
-        c[i] = a[i] * b[i];
+    if (!table) {
+        return false;
     }
+    ActiveKernelSlot().store(table, std::memory_order_relaxed);
+    return true;
+}
+
+void AddSIMD(const float* a, const float* b, float* c, size_t count) {
+    ActiveKernels().add(a, b, c, count);
+}
+
+void MulSIMD(const float* a, const float* b, float* c, size_t count) {
+    ActiveKernels().mul(a, b, c, count);
 }
 
 void ReluSIMD(const float* input, float* output, size_t count) {
-    size_t i = 0;
-    
-#ifdef __AVX__
-    if (HasAVX() && count >= 8) {
-        __m256 zero = _mm256_setzero_ps();
-        size_t simd_count = count & ~7;
-        for (; i < simd_count; i += 8) {
-            __m256 v = _mm256_loadu_ps(input + i);
-            __m256 result = _mm256_max_ps(v, zero);
-            _mm256_storeu_ps(output + i, result);
+    ActiveKernels().relu(input, output, count);
+}
+
+void MatMulSIMD(const float* A, const float* B, float* C, 
+                int64_t M, int64_t K, int64_t N) {
+    // 委托给打包分块GEMM（寄存器分块微内核见gemm.cpp）
+    gemm::Sgemm(false, false, M, N, K, 1.0f, A, K, B, N, 0.0f, C, N);
+}
+
+// 与向量VExp逐步对应，乘加显式用std::fma，结果不随编译器是否收缩a*b+c而变
+float FastExp(float x) {
+    x = std::min(std::max(x, kExpLo), kExpHi);
+    const float n = std::nearbyint(x * kLog2e);
+    float r = std::fma(n, -kLn2Hi, x);
+    r = std::fma(n, -kLn2Lo, r);
+    float p = kExpP0;
+    p = std::fma(p, r, kExpP1);
+    p = std::fma(p, r, kExpP2);
+    p = std::fma(p, r, kExpP3);
+    p = std::fma(p, r, kExpP4);
+    p = std::fma(p, r, kExpP5);
+    p = std::fma(p, r * r, r + 1.0f);
+    const uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+void ExpSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().exp(input, output, count);
+}
+
+float ReduceMaxSIMD(const float* input, size_t count) {
+    return ActiveKernels().reduce_max(input, count);
+}
+
+float ReduceSumSIMD(const float* input, size_t count) {
+    return ActiveKernels().reduce_sum(input, count);
+}
+
+float ReduceMinSIMD(const float* input, size_t count) {
+    return ActiveKernels().reduce_min(input, count);
+}
+
+float ReduceSumSquaresSIMD(const float* input, size_t count) {
+    return ActiveKernels().reduce_sum_squares(input, count);
+}
+
+void AccumulateSquaresSIMD(const float* input, float* acc, size_t count) {
+    ActiveKernels().accumulate_squares(input, acc, count);
+}
+
+size_t SelectGreaterSIMD(const float* input, size_t count, float threshold, uint32_t* indices) {
+    return ActiveKernels().select_greater(input, count, threshold, indices);
+}
+
+void BoxIoUSIMD(const float* box, float area, const float* y1, const float* x1, const float* y2,
+                const float* x2, const float* areas, float* iou, size_t count) {
+    ActiveKernels().box_iou(box, area, y1, x1, y2, x2, areas, iou, count);
+}
+
+float ExpShiftSumSIMD(const float* input, float* output, size_t count, float shift) {
+    return ActiveKernels().exp_shift_sum(input, output, count, shift);
+}
+
+void OnlineMaxExpSumSIMD(const float* input, size_t count, float* max_out, float* sum_out) {
+    ActiveKernels().online_max_exp_sum(input, count, max_out, sum_out);
+}
+
+void ExpShiftScaleSIMD(const float* input, float* output, size_t count, float shift, float scale) {
+    ActiveKernels().exp_shift_scale(input, output, count, shift, scale);
+}
+
+void ScaleSIMD(const float* input, float* output, size_t count, float scale) {
+    ActiveKernels().scale(input, output, count, scale);
+}
+
+void AddScalarSIMD(const float* input, float* output, size_t count, float value) {
+    ActiveKernels().add_scalar(input, output, count, value);
+}
+
+void ScaleAddSIMD(const float* input, float scale, float* acc, size_t count) {
+    ActiveKernels().scale_add(input, scale, acc, count);
+}
+
+void DepthwiseConvRowSIMD(const float* input, const size_t* offsets, const float* weights, size_t taps,
+                          float bias, bool relu, float* output, size_t count) {
+    ActiveKernels().depthwise_conv_row(input, offsets, weights, taps, bias, relu, output, count);
+}
+
+void MaxSIMD(const float* a, const float* b, float* c, size_t count) {
+    ActiveKernels().max(a, b, c, count);
+}
+
+void BinarySIMD(BinaryOp op, const float* a, bool a_scalar, const float* b, bool b_scalar,
+                float* c, size_t count) {
+    ActiveKernels().binary(op, a, a_scalar, b, b_scalar, c, count);
+}
+
+void ExpSubSIMD(const float* a, const float* b, float* c, size_t count) {
+    ActiveKernels().exp_sub(a, b, c, count);
+}
+
+void Transpose2DSIMD(const float* input, size_t input_stride, float* output, size_t output_stride,
+                     size_t rows, size_t cols) {
+    ActiveKernels().transpose_2d(input, input_stride, output, output_stride, rows, cols);
+}
+
+void NchwcConvSIMD(const float* input, size_t input_step, const size_t* input_offsets,
+                   const float* filter, const size_t* filter_offsets, size_t taps,
+                   float* output, size_t count, size_t block) {
+    ActiveKernels().nchwc_conv(input, input_step, input_offsets, filter, filter_offsets, taps,
+                               output, count, block);
+}
+
+void NchwcPoolSIMD(const float* input, size_t input_step, const size_t* input_offsets, size_t taps,
+                   float* output, size_t count, size_t block, bool max_pool, float scale) {
+    ActiveKernels().nchwc_pool(input, input_step, input_offsets, taps, output, count, block, max_pool, scale);
+}
+
+void QGemmS16SIMD(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+                  size_t m, size_t n, size_t k_pairs) {
+    ActiveKernels().qgemm_s16(a_pairs, b_pairs, output, m, n, k_pairs);
+}
+
+void QGemmU8S8SIMD(const int32_t* a_quads, const uint8_t* b_quads, size_t ldb, int32_t* output,
+                   size_t ldc, size_t m, size_t n, size_t k_quads) {
+    ActiveKernels().qgemm_u8s8(a_quads, b_quads, ldb, output, ldc, m, n, k_quads);
+}
+
+bool QGemmU8S8IsExact() {
+    return ActiveKernels().qgemm_u8s8_exact;
+}
+
+void ConvertHalfToFloatSIMD(const uint16_t* input, float* output, size_t count) {
+    ActiveKernels().half_to_float(input, output, count);
+}
+
+void ConvertFloatToHalfSIMD(const float* input, uint16_t* output, size_t count) {
+    ActiveKernels().float_to_half(input, output, count);
+}
+
+void ConvertBFloat16ToFloatSIMD(const uint16_t* input, float* output, size_t count) {
+    ActiveKernels().bf16_to_float(input, output, count);
+}
+
+void ConvertFloatToBFloat16SIMD(const float* input, uint16_t* output, size_t count) {
+    ActiveKernels().float_to_bf16(input, output, count);
+}
+
+float DotU4SIMD(const float* a, const uint8_t* q, size_t count) {
+    return ActiveKernels().dot_u4(a, q, count);
+}
+
+float DotU8SIMD(const float* a, const uint8_t* q, size_t count) {
+    return ActiveKernels().dot_u8(a, q, count);
+}
+
+void BlockSparseDotSIMD(const float* a, const float* values, const int32_t* columns, size_t count,
+                        size_t block, float* out) {
+    ActiveKernels().block_sparse_dot(a, values, columns, count, block, out);
+}
+
+float SparseDot2of4SIMD(const float* a, const float* values, const uint8_t* indices, size_t groups) {
+    return ActiveKernels().sparse_dot_2of4(a, values, indices, groups);
+}
+
+void SkinnyGemmSIMD(const float* a, size_t lda, const void* b, int b_type, size_t ldb, bool trans_b, float* c,
+                    size_t ldc, size_t m, size_t n, size_t k) {
+    ActiveKernels().skinny_gemm(a, lda, b, b_type, ldb, trans_b, c, ldc, m, n, k);
+}
+
+void ConvertU8AffineSIMD(const uint8_t* input, float* output, size_t count, float scale, float shift) {
+    ActiveKernels().u8_affine(input, output, count, scale, shift);
+}
+
+int FindSpecializedRowSlot(int64_t count) {
+    for (size_t slot = 0; slot < kNumSpecializedRowSizes; ++slot) {
+        if (static_cast<int64_t>(kSpecializedRowSizes[slot]) == count) {
+            return static_cast<int>(slot);
         }
     }
-#elif defined(__SSE__)
-    if (HasSSE() && count >= 4) {
-        __m128 zero = _mm_setzero_ps();
-        size_t simd_count = count & ~3;
-        for (; i < simd_count; i += 4) {
-            __m128 v = _mm_loadu_ps(input + i);
-            __m128 result = _mm_max_ps(v, zero);
-            _mm_storeu_ps(output + i, result);
-        }
+    return -1;
+}
+
+void SoftmaxRowFixedSIMD(int slot, const float* input, float* output, bool log_softmax) {
+    ActiveKernels().softmax_row_fixed[slot](input, output, log_softmax);
+}
+
+void NormRowFixedSIMD(int slot, const float* a, const float* b, float* sum, float* output, float epsilon,
+                      const float* gamma, const float* beta, bool rms) {
+    ActiveKernels().norm_row_fixed[slot](a, b, sum, output, epsilon, gamma, beta, rms);
+}
+
+void AddWelfordSIMD(const float* a, const float* b, float* sum, size_t count, float* mean, float* m2) {
+    ActiveKernels().add_welford(a, b, sum, count, mean, m2);
+}
+
+float AddSumSquaresSIMD(const float* a, const float* b, float* sum, size_t count) {
+    return ActiveKernels().add_sum_squares(a, b, sum, count);
+}
+
+void NormalizeScaleSIMD(const float* input, float* output, size_t count, float shift, float inv_std,
+                        const float* gamma, const float* beta) {
+    ActiveKernels().normalize_scale(input, output, count, shift, inv_std, gamma, beta);
+}
+
+// ---------------------------------------------------------------------------
+// 超越函数
+// ---------------------------------------------------------------------------
+
+float FastLog(float x) {
+    if (std::isnan(x) || x < 0.0f) {
+        return std::numeric_limits<float>::quiet_NaN();
     }
-#elif defined(__ARM_NEON)
-    if (HasNEON() && count >= 4) {
-        float32x4_t zero = vdupq_n_f32(0.0f);
-        size_t simd_count = count & ~3;
-        for (; i < simd_count; i += 4) {
-            float32x4_t v = vld1q_f32(input + i);
-            float32x4_t result = vmaxq_f32(v, zero);
-            vst1q_f32(output + i, result);
-        }
+    if (x == 0.0f) {
+        return -std::numeric_limits<float>::infinity();
+    }
+    if (std::isinf(x)) {
+        return x;
     }
-#endif
-    
-    // 处理剩余元素
-    for (; i < count; ++i) {
-        output[i] = std::max(0.0f, input[i]);
+    int exponent = 0;
+    float m = std::frexp(std::max(x, std::numeric_limits<float>::min()), &exponent);
+    float e = static_cast<float>(exponent);
+    float r;
+    if (m < kSqrtHalf) {
+        e -= 1.0f;
+        r = m + m - 1.0f;
+    } else {
+        r = m - 1.0f;
     }
+    const float z = r * r;
+    float p = kLogP[0];
+    for (int k = 1; k < 9; ++k) {
+        p = p * r + kLogP[k];
+    }
+    float y = p * r * z;
+    y += e * kLn2Lo;
+    y += -0.5f * z;
+    return r + y + e * kLn2Hi;
 }
 
-void MatMulSIMD(const float* A, const float* B, float* C, 
-                int64_t M, int64_t K, int64_t N) {
-    // 简化的SIMD矩阵乘法
-    // 实际应该使用更优化的实现（如分块、转置等）
-    for (int64_t i = 0; i < M; ++i) {
-        for (int64_t j = 0; j < N; ++j) {
-            float sum = 0.0f;
-            
-            // 使用SIMD加速内积计算
-            int64_t k = 0;
-#ifdef __AVX__
-            if (HasAVX() && K >= 8) {
-                __m256 sum_vec = _mm256_setzero_ps();
-                int64_t simd_count = K & ~7;
-                for (; k < simd_count; k += 8) {
-                    __m256 va = _mm256_loadu_ps(A + i * K + k);
-                    __m256 vb = _mm256_loadu_ps(B + k * N + j);
-                    // 注意：这里需要转置B或使用gather指令
-                    // 简化实现：逐元素相乘后求和
-                    for (int kk = 0; kk < 8; ++kk) {
-                        sum += A[i * K + k + kk] * B[(k + kk) * N + j];
-                    }
-                }
-            }
-#elif defined(__SSE__)
-            if (HasSSE() && K >= 4) {
-                int64_t simd_count = K & ~3;
-                for (; k < simd_count; k += 4) {
-                    for (int kk = 0; kk < 4; ++kk) {
-                        sum += A[i * K + k + kk] * B[(k + kk) * N + j];
-                    }
-                }
-            }
-#endif
-            
-            // 处理剩余元素
-            for (; k < K; ++k) {
-                sum += A[i * K + k] * B[k * N + j];
-            }
-            
-            C[i * N + j] = sum;
-        }
+float FastTanh(float a) {
+    if (std::abs(a) < kTanhTiny) {
+        return a;
+    }
+    const float x = std::min(std::max(a, -kTanhClamp), kTanhClamp);
+    const float x2 = x * x;
+    float p = kTanhAlpha[6];
+    for (int k = 5; k >= 0; --k) {
+        p = x2 * p + kTanhAlpha[k];
+    }
+    float q = kTanhBeta[3];
+    for (int k = 2; k >= 0; --k) {
+        q = x2 * q + kTanhBeta[k];
     }
+    return x * p / q;
+}
+
+float FastErf(float a) {
+    const float x = std::min(std::max(a, -kErfClamp), kErfClamp);
+    const float x2 = x * x;
+    float p = kErfAlpha[6];
+    for (int k = 5; k >= 0; --k) {
+        p = x2 * p + kErfAlpha[k];
+    }
+    float q = kErfBeta[4];
+    for (int k = 3; k >= 0; --k) {
+        q = x2 * q + kErfBeta[k];
+    }
+    return x * p / q;
+}
+
+float FastSigmoid(float x) {
+    return 1.0f / (1.0f + FastExp(-x));
+}
+
+void LogSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().log(input, output, count);
+}
+
+void TanhSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().tanh(input, output, count);
+}
+
+void ErfSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().erf(input, output, count);
+}
+
+void SigmoidSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().sigmoid(input, output, count);
+}
+
+void SiluSIMD(const float* input, float* output, size_t count) {
+    ActiveKernels().silu(input, output, count);
+}
+
+void GeluSIMD(const float* input, float* output, size_t count, bool tanh_approximation) {
+    ActiveKernels().gelu(input, output, count, tanh_approximation);
 }
 
 } // namespace simd
 } // namespace inferunity
-
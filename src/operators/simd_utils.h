@@ -3,49 +3,27 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#include <emmintrin.h>
-#endif
-
-#ifdef __AVX__
-#include <immintrin.h>
-#endif
-
-#ifdef __ARM_NEON
-#include <arm_neon.h>
-#endif
-
 namespace inferunity {
 namespace simd {
 
-// SIMD特性检测
-inline bool HasSSE() {
-#ifdef __SSE__
-    return true;
-#else
-    return false;
-#endif
-}
-
-inline bool HasAVX() {
-#ifdef __AVX__
-    return true;
-#else
-    return false;
-#endif
-}
-
-inline bool HasNEON() {
-#ifdef __ARM_NEON
-    return true;
-#else
-    return false;
-#endif
-}
+// SIMD特性检测（运行时CPUID，见cpu_features.h）
+bool HasSSE();   // SSE4.2
+bool HasAVX();
+bool HasNEON();
+
+// 运行时ISA分发：首次调用任一SIMD接口时按CPU特性选择向量核
+// （amx > avx512_vnni > avx512 > avx2+fma+f16c > sse42 > neon_dot > neon > wasm_simd128 > scalar），InitializeOperators会提前完成选择
+void InitializeSimdDispatch();
+const char* GetSimdIsaName();
+
+// 强制使用指定ISA（"scalar"、"sse42"、"avx2"、"avx512"、"avx512_vnni"、"amx"、"neon"、"neon_dot"，
+// "auto"恢复自动选择），
+// 用于测试与基准比较；CPU不支持或未编译该ISA时返回false。应在没有推理运行时调用
+bool SetSimdIsa(const char* name);
 
 // SIMD向量化加法（参考NCNN实现）
 void AddSIMD(const float* a, const float* b, float* c, size_t count);
@@ -60,6 +38,160 @@ void ReluSIMD(const float* input, float* output, size_t count);
 void MatMulSIMD(const float* A, const float* B, float* C, 
                 int64_t M, int64_t K, int64_t N);
 
+// 多项式近似exp（参考Cephes/NCNN的exp_ps）：输入截断到[-88.38, 88.38]，
+// 最大误差1 ULP；标量FastExp使用同一多项式与同样的融合乘加，与有FMA指令的ISA（avx2、avx512、neon等）
+// 的ExpSIMD逐位一致。sse42与wasm_simd128没有融合乘加，乘与加分别舍入，结果与FastExp最多相差1 ULP
+float FastExp(float x);
+void ExpSIMD(const float* input, float* output, size_t count);
+
+// 归约
+float ReduceMaxSIMD(const float* input, size_t count);
+float ReduceSumSIMD(const float* input, size_t count);
+float ReduceMinSIMD(const float* input, size_t count);
+float ReduceSumSquaresSIMD(const float* input, size_t count);  // sum(x[i]^2)
+void AccumulateSquaresSIMD(const float* input, float* acc, size_t count);  // acc[i] += x[i]^2
+
+// 把大于threshold的元素下标依次写入indices（容量至少为count），返回个数
+size_t SelectGreaterSIMD(const float* input, size_t count, float threshold, uint32_t* indices);
+
+// box = {y1, x1, y2, x2}（y1 <= y2，x1 <= x2）与count个框的IoU：其余框的坐标按分量分开存放（SoA），
+// areas为各框面积，area为box的面积；iou[i] = 交集 / 并集，并集不为正时为0
+void BoxIoUSIMD(const float* box, float area, const float* y1, const float* x1, const float* y2,
+                const float* x2, const float* areas, float* iou, size_t count);
+
+// output[i] = exp(input[i] - shift)，返回sum(output)
+float ExpShiftSumSIMD(const float* input, float* output, size_t count, float shift);
+
+// 单遍在线计算max与sum(exp(x - max))，只读一次输入（参考Milakov & Gimelshein, Online normalizer calculation for softmax）
+void OnlineMaxExpSumSIMD(const float* input, size_t count, float* max_out, float* sum_out);
+
+// output[i] = exp(input[i] - shift) * scale
+void ExpShiftScaleSIMD(const float* input, float* output, size_t count, float shift, float scale);
+
+// output[i] = input[i] * scale / output[i] = input[i] + value（允许原地，output == input）
+void ScaleSIMD(const float* input, float* output, size_t count, float scale);
+void AddScalarSIMD(const float* input, float* output, size_t count, float value);
+// acc[i] += input[i] * scale
+void ScaleAddSIMD(const float* input, float scale, float* acc, size_t count);
+
+// 逐元素：c[i] = max(a[i], b[i]) / c[i] = exp(a[i] - b[i])
+void MaxSIMD(const float* a, const float* b, float* c, size_t count);
+void ExpSubSIMD(const float* a, const float* b, float* c, size_t count);
+
+// 二元逐元素运算的广播内层循环：a_scalar/b_scalar为true时该操作数只读第一个元素
+// （行、列广播在算子层按行调用）；除法按IEEE语义，除以0得到inf/NaN
+enum class BinaryOp : uint8_t { ADD, SUB, MUL, DIV, MAX, MIN };
+void BinarySIMD(BinaryOp op, const float* a, bool a_scalar, const float* b, bool b_scalar,
+                float* c, size_t count);
+
+// 超越函数（数组版本的尾部补齐后走向量路径，结果与切块方式无关；标量Fast*与之可能相差末位）
+// 误差为与双精度参考在float范围内抽样测得的上界：
+//   exp:     ≤ 1 ULP（x > -87）
+//   log:     Cephes多项式，正规数上 ≤ 1 ULP；非正规数按FLT_MIN处理，0返回-inf，负数返回NaN
+//   tanh:    [-7.9, 7.9]内有理逼近（参考Eigen），FMA路径 ≤ 4 ULP、无FMA时 ≤ 6 ULP（绝对误差 ≤ 4e-7），|x| < 4e-4时直接返回x
+//   erf:     [-4, 4]内有理逼近（参考Eigen），绝对误差 ≤ 5e-7
+//   sigmoid: 1 / (1 + exp(-x))，≤ 3 ULP（x > -87）
+float FastLog(float x);
+float FastTanh(float x);
+float FastErf(float x);
+float FastSigmoid(float x);
+void LogSIMD(const float* input, float* output, size_t count);
+void TanhSIMD(const float* input, float* output, size_t count);
+void ErfSIMD(const float* input, float* output, size_t count);
+void SigmoidSIMD(const float* input, float* output, size_t count);
+
+// SiLU(x) = x * sigmoid(x)
+void SiluSIMD(const float* input, float* output, size_t count);
+
+// GELU：默认erf精确形式0.5x(1 + erf(x/√2))；tanh_approximation为true时使用
+// 0.5x(1 + tanh(√(2/π)(x + 0.044715x³)))（ONNX Gelu的approximate="tanh"）
+void GeluSIMD(const float* input, float* output, size_t count, bool tanh_approximation);
+
+// 二维转置：output[j * output_stride + i] = input[i * input_stride + j]（i < rows, j < cols）；
+// 按L1大小的块遍历，块内用寄存器转置（AVX-512为16x16、AVX2为8x8、SSE4.2/NEON为4x4），只搬运位模式，
+// 任何4字节元素都适用。输入输出不能重叠
+void Transpose2DSIMD(const float* input, size_t input_stride, float* output, size_t output_stride,
+                     size_t rows, size_t cols);
+
+// 深度卷积的一行输出：output[i] = bias + Σ_t input[offsets[t] + i] * weights[t]，relu时截断到0。
+// 调用方把补零、按stride拆开的输入行放在一起，使每个抽头读取的都是连续的一段；3x3与5x5有展开的专用核
+void DepthwiseConvRowSIMD(const float* input, const size_t* offsets, const float* weights, size_t taps,
+                          float bias, bool relu, float* output, size_t count);
+
+// NCHWc直接卷积的一段输出（参考MLAS的MlasConvNchwcFloatKernel）：对count个输出像素p，
+// output[p * block + o] += Σ_t input[p * input_step + input_offsets[t]] * filter[filter_offsets[t] + o]，o < block。
+// 每个抽头广播一个输入标量、与一行block个输出通道的权重相乘累加；block等于向量宽度时一次处理4个像素
+void NchwcConvSIMD(const float* input, size_t input_step, const size_t* input_offsets,
+                   const float* filter, const size_t* filter_offsets, size_t taps,
+                   float* output, size_t count, size_t block);
+
+// NCHWc池化的一段输出（参考MLAS的MlasPoolFloatKernel）：对count个输出像素p，
+// output[p * block + o] = max_t或scale * Σ_t input[p * input_step + input_offsets[t] + o]，o < block；
+// 没有抽头时MaxPool输出最小的有限值。全局池化取count = 1、抽头为全部像素
+void NchwcPoolSIMD(const float* input, size_t input_step, const size_t* input_offsets, size_t taps,
+                   float* output, size_t count, size_t block, bool max_pool, float scale);
+
+// 整数GEMM（参考MLAS的MlasGemm QGEMM路径）：output[m * n + j] = Σ_k a[m][k] * b[k][j]，int32累加。
+// a_pairs为[m][k_pairs]，每个int32的低16位是a[m][2kp]、高16位是a[m][2kp+1]；
+// b_pairs为[k_pairs][n][2]的int16，k为奇数时补一行0。AVX2/SSE用madd一次完成两个k的乘加
+void QGemmS16SIMD(const int32_t* a_pairs, const int16_t* b_pairs, int32_t* output,
+                  size_t m, size_t n, size_t k_pairs);
+
+// u8s8整数GEMM（参考MLAS的QGEMM U8S8内核）：output[i * ldc + j] = Σ_k a[i][k] * b[k][j]，int32累加。
+// a_quads为[m][k_quads]的s8权重，每个int32打包相邻4个k（最低字节为k % 4 == 0）；
+// b_quads为[k_quads][ldb][4]的u8激活，k不是4的倍数时补0。
+// AVX-512 VNNI用vpdpbusd、AMX用tdpbsud、NEON dotprod用sdot；AVX2/SSE用vpmaddubsw，
+// 其int16中间和会饱和，QGemmU8S8IsExact()为false时调用方须保证相邻两个k的|a0| + |a1| <= 128
+void QGemmU8S8SIMD(const int32_t* a_quads, const uint8_t* b_quads, size_t ldb, int32_t* output,
+                   size_t ldc, size_t m, size_t n, size_t k_quads);
+bool QGemmU8S8IsExact();
+
+// 半精度与FP32的批量转换（标量版本见inferunity/float16.h）：FLOAT16用F16C/AVX-512/NEON的转换指令，
+// BFLOAT16为移位与就近舍入到偶数
+void ConvertHalfToFloatSIMD(const uint16_t* input, float* output, size_t count);
+void ConvertFloatToHalfSIMD(const float* input, uint16_t* output, size_t count);
+void ConvertBFloat16ToFloatSIMD(const uint16_t* input, float* output, size_t count);
+void ConvertFloatToBFloat16SIMD(const float* input, uint16_t* output, size_t count);
+
+// 低比特权重与FP32激活的点积sum(a[i] * q[i])（MatMulNBits的GEMV内核）：
+// U4的q每字节放两个值，第i个在字节i/2的低4位（i为偶数）或高4位；U8每字节一个
+float DotU4SIMD(const float* a, const uint8_t* q, size_t count);
+float DotU8SIMD(const float* a, const uint8_t* q, size_t count);
+
+// 稀疏权重与FP32激活的乘法（SparseMatMul的内核）。BlockSparseDot计算块稀疏CSR的一个块行：
+// out[i] = sum(a[columns[e]] * values[e * block + i])，i < block，e < count；
+// SparseDot2of4为2:4结构化稀疏的点积，a每4个一组、每组2个权重，indices为组内偏移
+void BlockSparseDotSIMD(const float* a, const float* values, const int32_t* columns, size_t count,
+                        size_t block, float* out);
+float SparseDot2of4SIMD(const float* a, const float* values, const uint8_t* indices, size_t groups);
+
+// 瘦矩阵乘（gemm::SkinnyGemmPartial的内核）：c[i][j] = sum_p a[i][p] * op(b)[p][j]，覆盖c，i < m；
+// b_type为0/1/2表示b是FP32/FLOAT16/BFLOAT16，trans_b时b为[n][k]、否则为[k][n]，行跨度ldb（元素）
+void SkinnyGemmSIMD(const float* a, size_t lda, const void* b, int b_type, size_t ldb, bool trans_b, float* c,
+                    size_t ldc, size_t m, size_t n, size_t k);
+
+// output[i] = input[i] * scale + shift（ImagePreprocess的归一化：u8像素转换为FP32的同时减均值、除标准差）
+void ConvertU8AffineSIMD(const uint8_t* input, float* output, size_t count, float scale, float shift);
+
+// 形状特化内核（参考Eigen的固定尺寸内核）：行长为模板参数，循环次数固定、可完全展开，
+// 不超过8个向量的短行整行留在寄存器中、只读一遍输入。FindSpecializedRowSlot在编译节点时按行长查找，
+// 不是kSpecializedRowSizes（simd_kernels.h）之一时返回-1，由调用方使用通用内核。
+// SoftmaxRowFixedSIMD处理一整行连续数据；NormRowFixedSIMD为一行LayerNorm（rms为true时为RMSNorm，忽略beta），
+// x = a + b的约定同AddWelfordSIMD
+int FindSpecializedRowSlot(int64_t count);
+void SoftmaxRowFixedSIMD(int slot, const float* input, float* output, bool log_softmax);
+void NormRowFixedSIMD(int slot, const float* a, const float* b, float* sum, float* output, float epsilon,
+                      const float* gamma, const float* beta, bool rms);
+
+// LayerNorm/RMSNorm的单遍统计：x = a + b，b不为nullptr且sum不为nullptr时把x写入sum（融合的残差相加）；
+// b为nullptr时x = a。AddWelford求均值与M2 = sum((x - mean)^2)（Welford递推，避免E[x^2] - E[x]^2的抵消），
+// AddSumSquares求sum(x^2)
+void AddWelfordSIMD(const float* a, const float* b, float* sum, size_t count, float* mean, float* m2);
+float AddSumSquaresSIMD(const float* a, const float* b, float* sum, size_t count);
+// y = (x - shift) * inv_std * gamma + beta，beta可为nullptr
+void NormalizeScaleSIMD(const float* input, float* output, size_t count, float shift, float inv_std,
+                        const float* gamma, const float* beta);
+
 } // namespace simd
 } // namespace inferunity
 
@@ -1,18 +1,91 @@
-// Softmax算子实现
-// 参考TensorFlow Lite的实现
+// Softmax/LogSoftmax算子实现
+// 参考TensorFlow Lite的实现；向量核见simd_utils.cpp（多项式exp）。
+// 编译节点时axis为最后一维且行长为常见值（64/128/768/1024/4096等）的节点改用行长为模板参数的专用核
 
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace inferunity {
 namespace operators {
 
-// Softmax算子
-class SoftmaxOperator : public Operator {
+namespace {
+
+// 行长度达到该值时使用单遍在线max+sum，少读一遍输入（长序列attention）
+constexpr int64_t kOnlineSoftmaxThreshold = 4096;
+
+// axis最后一维：一行连续数据
+void SoftmaxContiguousRow(const float* x, float* y, int64_t n, bool log_softmax) {
+    const size_t count = static_cast<size_t>(n);
+    float max_val = 0.0f;
+    float sum = 0.0f;
+    if (n >= kOnlineSoftmaxThreshold) {
+        simd::OnlineMaxExpSumSIMD(x, count, &max_val, &sum);
+        if (log_softmax) {
+            simd::AddScalarSIMD(x, y, count, -(max_val + std::log(sum)));
+        } else {
+            simd::ExpShiftScaleSIMD(x, y, count, max_val, 1.0f / sum);
+        }
+        return;
+    }
+    
+    max_val = simd::ReduceMaxSIMD(x, count);
+    sum = simd::ExpShiftSumSIMD(x, y, count, max_val);  // LogSoftmax时y只作临时缓冲
+    if (log_softmax) {
+        // log_softmax(x) = x - max - log(sum(exp(x - max)))
+        simd::AddScalarSIMD(x, y, count, -(max_val + std::log(sum)));
+    } else {
+        simd::ScaleSIMD(y, y, count, 1.0f / sum);
+    }
+}
+
+// axis不是最后一维：一个[axis_size, inner]块，沿inner方向向量化
+// stats为2*inner的临时缓冲（max与sum）
+void SoftmaxStridedBlock(const float* x, float* y, int64_t axis_size, int64_t inner,
+                         bool log_softmax, float* stats) {
+    const size_t width = static_cast<size_t>(inner);
+    float* max_buf = stats;
+    float* sum_buf = stats + inner;
+    
+    std::copy(x, x + inner, max_buf);
+    for (int64_t i = 1; i < axis_size; ++i) {
+        simd::MaxSIMD(max_buf, x + i * inner, max_buf, width);
+    }
+    
+    std::fill(sum_buf, sum_buf + inner, 0.0f);
+    for (int64_t i = 0; i < axis_size; ++i) {
+        float* row = y + i * inner;
+        simd::ExpSubSIMD(x + i * inner, max_buf, row, width);
+        simd::AddSIMD(sum_buf, row, sum_buf, width);
+    }
+    
+    if (log_softmax) {
+        for (int64_t j = 0; j < inner; ++j) {
+            sum_buf[j] = -(max_buf[j] + std::log(sum_buf[j]));
+        }
+        for (int64_t i = 0; i < axis_size; ++i) {
+            simd::AddSIMD(x + i * inner, sum_buf, y + i * inner, width);
+        }
+    } else {
+        for (int64_t j = 0; j < inner; ++j) {
+            sum_buf[j] = 1.0f / sum_buf[j];
+        }
+        for (int64_t i = 0; i < axis_size; ++i) {
+            simd::MulSIMD(y + i * inner, sum_buf, y + i * inner, width);
+        }
+    }
+}
+
+} // anonymous namespace
+
+// Softmax与LogSoftmax共享实现（ONNX opset 13语义：沿单个axis归一化，默认-1）
+class SoftmaxOperatorBase : public Operator {
 public:
-    std::string GetName() const override { return "Softmax"; }
+    explicit SoftmaxOperatorBase(bool log_softmax) : log_softmax_(log_softmax) {}
     
     Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
         if (inputs.empty()) {
@@ -27,70 +100,126 @@ public:
         return Status::Ok();
     }
     
+    void SpecializeForShapes(const std::vector<Shape>& input_shapes) override {
+        specialized_slot_ = -1;
+        if (input_shapes.empty() || input_shapes[0].dims.empty()) {
+            return;
+        }
+        const std::vector<int64_t>& dims = input_shapes[0].dims;
+        const int64_t rank = static_cast<int64_t>(dims.size());
+        int64_t axis = GetIntAttribute("axis", -1);
+        if (axis < 0) {
+            axis += rank;
+        }
+        // 只特化连续行：axis之后的维度都为1
+        if (axis < 0 || axis >= rank ||
+            !std::all_of(dims.begin() + axis + 1, dims.end(), [](int64_t dim) { return dim == 1; })) {
+            return;
+        }
+        specialized_slot_ = simd::FindSpecializedRowSlot(dims[axis]);
+        specialized_size_ = dims[axis];
+    }
+    
     Status Execute(const std::vector<Tensor*>& inputs,
                   const std::vector<Tensor*>& outputs,
                   ExecutionContext* ctx) override {
         if (inputs.empty() || outputs.empty()) {
             return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
         }
-        
+    
         Tensor* input = inputs[0];
         Tensor* output = outputs[0];
-        
+    
         const Shape& input_shape = input->GetShape();
         const float* input_data = static_cast<const float*>(input->GetData());
         float* output_data = static_cast<float*>(output->GetData());
-        
-        // 获取axis（默认-1，最后一个维度）
-        int axis = -1;
-        if (input_shape.dims.size() > 0) {
-            axis = axis < 0 ? input_shape.dims.size() + axis : axis;
+    
+        const int64_t rank = static_cast<int64_t>(input_shape.dims.size());
+        if (rank == 0) {
+            output_data[0] = log_softmax_ ? 0.0f : 1.0f;
+            return Status::Ok();
         }
-        
+    
+        // 获取axis属性（默认-1，最后一个维度）
+        int64_t axis = GetIntAttribute("axis", -1);
+        if (axis < 0) {
+            axis += rank;
+        }
+        if (axis < 0 || axis >= rank) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               GetName() + " axis out of range");
+        }
+    
         // 计算softmax维度
         int64_t outer_size = 1;
         int64_t inner_size = 1;
-        int64_t softmax_size = input_shape.dims[axis];
-        
-        for (int i = 0; i < axis; ++i) {
+        const int64_t softmax_size = input_shape.dims[axis];
+        for (int64_t i = 0; i < axis; ++i) {
             outer_size *= input_shape.dims[i];
         }
-        for (int i = axis + 1; i < static_cast<int>(input_shape.dims.size()); ++i) {
+        for (int64_t i = axis + 1; i < rank; ++i) {
             inner_size *= input_shape.dims[i];
         }
-        
-        // Softmax计算
-        for (int64_t outer = 0; outer < outer_size; ++outer) {
-            for (int64_t inner = 0; inner < inner_size; ++inner) {
-                // 找到最大值（数值稳定性）
-                float max_val = -std::numeric_limits<float>::max();
-                for (int64_t i = 0; i < softmax_size; ++i) {
-                    int64_t idx = (outer * softmax_size + i) * inner_size + inner;
-                    max_val = std::max(max_val, input_data[idx]);
-                }
-                
-                // 计算exp和sum
-                float sum = 0.0f;
-                for (int64_t i = 0; i < softmax_size; ++i) {
-                    int64_t idx = (outer * softmax_size + i) * inner_size + inner;
-                    output_data[idx] = std::exp(input_data[idx] - max_val);
-                    sum += output_data[idx];
+        if (softmax_size <= 0 || inner_size <= 0) {
+            return Status::Ok();
+        }
+    
+        // Softmax计算（按外层维度切分给算子内线程）
+        const int64_t outer_work = softmax_size * inner_size;
+        const bool log_softmax = log_softmax_;
+        if (specialized_slot_ >= 0 && inner_size == 1 && softmax_size == specialized_size_) {
+            const int slot = specialized_slot_;
+            ParallelForOuter(ctx, outer_size, outer_work, [&](int64_t outer_begin, int64_t outer_end) {
+                for (int64_t outer = outer_begin; outer < outer_end; ++outer) {
+                    simd::SoftmaxRowFixedSIMD(slot, input_data + outer * outer_work,
+                                              output_data + outer * outer_work, log_softmax);
                 }
-                
-                // 归一化
-                for (int64_t i = 0; i < softmax_size; ++i) {
-                    int64_t idx = (outer * softmax_size + i) * inner_size + inner;
-                    output_data[idx] /= sum;
+            });
+            return Status::Ok();
+        }
+        ParallelForOuter(ctx, outer_size, outer_work, [&](int64_t outer_begin, int64_t outer_end) {
+            std::vector<float> stats;
+            if (inner_size > 1) {
+                stats.resize(static_cast<size_t>(2 * inner_size));
+            }
+            for (int64_t outer = outer_begin; outer < outer_end; ++outer) {
+                const float* x = input_data + outer * outer_work;
+                float* y = output_data + outer * outer_work;
+                if (inner_size == 1) {
+                    SoftmaxContiguousRow(x, y, softmax_size, log_softmax);
+                } else {
+                    SoftmaxStridedBlock(x, y, softmax_size, inner_size, log_softmax, stats.data());
                 }
             }
-        }
-        
+        });
+    
         return Status::Ok();
     }
+
+private:
+    bool log_softmax_;
+    // SpecializeForShapes选定的专用核（见simd::FindSpecializedRowSlot），-1表示通用路径
+    int specialized_slot_ = -1;
+    int64_t specialized_size_ = 0;
+};
+
+// Softmax算子
+class SoftmaxOperator : public SoftmaxOperatorBase {
+public:
+    SoftmaxOperator() : SoftmaxOperatorBase(false) {}
+    std::string GetName() const override { return "Softmax"; }
 };
 
 REGISTER_OPERATOR("Softmax", SoftmaxOperator);
 
+// LogSoftmax算子
+class LogSoftmaxOperator : public SoftmaxOperatorBase {
+public:
+    LogSoftmaxOperator() : SoftmaxOperatorBase(true) {}
+    std::string GetName() const override { return "LogSoftmax"; }
+};
+
+REGISTER_OPERATOR("LogSoftmax", LogSoftmaxOperator);
+
 } // namespace operators
 } // namespace inferunity
-
@@ -0,0 +1,211 @@
+// 稀疏权重MatMul（内部算子SparseMatMul，由SparseWeightPass改写MatMul/FusedMatMulAdd得到）
+// Y = A * B + bias，B[K, N]以两种稀疏格式之一存放（参考XNNPACK/TFLite的稀疏推理与NVIDIA Ampere的2:4结构化稀疏）：
+//   sparse_format="block"：B^T[N, K]的块稀疏CSR，块为block_size（4或8）个连续输出行 x 1个输入列，
+//     values为[nnz_blocks, block_size]，columns为各块的输入列，row_ptr为各块行在columns中的起止（N不足时末块补零）；
+//     一个块行的输出落在一组向量寄存器里，对每个非零块广播a[column]做FMA（见simd::BlockSparseDotSIMD）
+//   sparse_format="2:4"：B^T每行沿K每4个元素至多2个非零，values与indices均为[N, K / 2]，indices为组内偏移
+// 输入按ONNX槽位：0为A，1为values，2为columns/indices，3为row_ptr（仅block），4为bias，省略时由input_slots标出位置
+
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <algorithm>
+#include <string>
+
+namespace inferunity {
+namespace operators {
+
+class SparseMatMulOperator : public Operator {
+public:
+    std::string GetName() const override { return "SparseMatMul"; }
+    
+    Status ValidateInputs(const std::vector<Tensor*>& inputs) const override {
+        const Tensor* a = InputAt(inputs, 0);
+        if (!a || a->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SparseMatMul requires FLOAT32 A");
+        }
+        const Tensor* bias = InputAt(inputs, 4);
+        if (bias && (bias->GetDataType() != DataType::FLOAT32 ||
+                     static_cast<int64_t>(bias->GetElementCount()) != GetIntAttribute("N", 0))) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SparseMatMul bias must be FLOAT32 [N]");
+        }
+        const std::string activation = GetStringAttribute("activation", "");
+        if (!activation.empty() && activation != "relu" && activation != "gelu") {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "SparseMatMul activation not supported: " + activation);
+        }
+        return CheckWeight(inputs);
+    }
+    
+    Status InferOutputShape(const std::vector<Tensor*>& inputs,
+                           std::vector<Shape>& output_shapes) const override {
+        const Tensor* a = InputAt(inputs, 0);
+        if (!a || a->GetShape().dims.empty() || a->GetShape().dims.back() != GetIntAttribute("K", 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SparseMatMul requires A[..., K]");
+        }
+        Shape output = a->GetShape();
+        output.dims.back() = GetIntAttribute("N", 0);
+        output_shapes.push_back(output);
+        return Status::Ok();
+    }
+    
+    OperatorCost EstimateCost(const std::vector<TensorInfo>& inputs,
+                              const std::vector<TensorInfo>& outputs) const override {
+        // 每个输出元素的乘加次数为平均每个输出列存放的权重个数
+        const int64_t N = std::max<int64_t>(1, GetIntAttribute("N", 1));
+        int64_t stored = GetIntAttribute("K", 1);
+        if (inputs.size() > 1) {
+            stored = std::max<int64_t>(1, inputs[1].shape.GetElementCount() / N);
+        }
+        const std::string activation = GetStringAttribute("activation", "");
+        const double activation_flops =
+            activation.empty() ? 0.0 : GetElementwiseFlops(activation == "gelu" ? "Gelu" : "Relu");
+        return EstimateMatMulCost(inputs, outputs, stored, 1.0 + activation_flops);
+    }
+    
+    Status Execute(const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& outputs,
+                  ExecutionContext* ctx) override {
+        if (outputs.empty() || !InputAt(inputs, 0)) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid inputs/outputs");
+        }
+        Status status = CheckWeight(inputs);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const int64_t K = GetIntAttribute("K", 0);
+        const int64_t N = GetIntAttribute("N", 0);
+        const Tensor* a = InputAt(inputs, 0);
+        const Tensor* bias_tensor = InputAt(inputs, 4);
+        const int64_t M = static_cast<int64_t>(a->GetElementCount()) / K;
+        if (static_cast<int64_t>(outputs[0]->GetElementCount()) != M * N) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "SparseMatMul output shape mismatch");
+        }
+        const float* A = static_cast<const float*>(a->GetData());
+        const float* bias = bias_tensor ? static_cast<const float*>(bias_tensor->GetData()) : nullptr;
+        const float* values = static_cast<const float*>(InputAt(inputs, 1)->GetData());
+        float* Y = static_cast<float*>(outputs[0]->GetData());
+    
+        if (IsBlockFormat()) {
+            // 按块行切分给线程，块行的权重在M行之间复用
+            const int64_t block = GetIntAttribute("block_size", 8);
+            const int32_t* columns = static_cast<const int32_t*>(InputAt(inputs, 2)->GetData());
+            const int32_t* row_ptr = static_cast<const int32_t*>(InputAt(inputs, 3)->GetData());
+            const int64_t block_rows = (N + block - 1) / block;
+            const int64_t work = M * std::max<int64_t>(1, row_ptr[block_rows] / block_rows) * block;
+            ParallelForOuter(ctx, block_rows, work, [&](int64_t begin, int64_t end) {
+                float out[8];
+                for (int64_t j = begin; j < end; ++j) {
+                    const int64_t n0 = j * block;
+                    const int64_t count = std::min(block, N - n0);
+                    const size_t nnz = static_cast<size_t>(row_ptr[j + 1] - row_ptr[j]);
+                    for (int64_t m = 0; m < M; ++m) {
+                        simd::BlockSparseDotSIMD(A + m * K, values + row_ptr[j] * block, columns + row_ptr[j],
+                                                 nnz, static_cast<size_t>(block), out);
+                        float* y = Y + m * N + n0;
+                        for (int64_t i = 0; i < count; ++i) {
+                            y[i] = out[i] + (bias ? bias[n0 + i] : 0.0f);
+                        }
+                    }
+                }
+            });
+        } else {
+            const uint8_t* indices = static_cast<const uint8_t*>(InputAt(inputs, 2)->GetData());
+            const size_t groups = static_cast<size_t>(K / 4);
+            ParallelForOuter(ctx, N, M * K / 2, [&](int64_t begin, int64_t end) {
+                for (int64_t n = begin; n < end; ++n) {
+                    const float* v = values + n * (K / 2);
+                    const uint8_t* idx = indices + n * (K / 2);
+                    const float b = bias ? bias[n] : 0.0f;
+                    for (int64_t m = 0; m < M; ++m) {
+                        Y[m * N + n] = simd::SparseDot2of4SIMD(A + m * K, v, idx, groups) + b;
+                    }
+                }
+            });
+        }
+    
+        // FusedMatMulAdd带过来的激活，在输出上原位完成
+        const std::string activation = GetStringAttribute("activation", "");
+        if (activation.empty()) {
+            return Status::Ok();
+        }
+        const bool tanh_approximation = GetStringAttribute("approximate", "none") == "tanh";
+        ParallelForElements(ctx, M * N, [&](int64_t begin, int64_t end) {
+            const size_t n = static_cast<size_t>(end - begin);
+            if (activation == "gelu") {
+                simd::GeluSIMD(Y + begin, Y + begin, n, tanh_approximation);
+            } else {
+                simd::ReluSIMD(Y + begin, Y + begin, n);
+            }
+        });
+        return Status::Ok();
+    }
+
+private:
+    bool IsBlockFormat() const { return GetStringAttribute("sparse_format", "block") == "block"; }
+    
+    // 第slot个输入，省略时为nullptr
+    const Tensor* InputAt(const std::vector<Tensor*>& inputs, int64_t slot) const {
+        const std::vector<int64_t> slots = GetIntsAttribute("input_slots", {});
+        if (slots.empty()) {
+            return slot < static_cast<int64_t>(inputs.size()) ? inputs[slot] : nullptr;
+        }
+        for (size_t i = 0; i < slots.size() && i < inputs.size(); ++i) {
+            if (slots[i] == slot) {
+                return inputs[i];
+            }
+        }
+        return nullptr;
+    }
+    
+    // 按属性K/N/sparse_format/block_size检查稀疏权重各输入的类型与元素个数
+    Status CheckWeight(const std::vector<Tensor*>& inputs) const {
+        const int64_t K = GetIntAttribute("K", 0);
+        const int64_t N = GetIntAttribute("N", 0);
+        const Tensor* values = InputAt(inputs, 1);
+        const Tensor* indices = InputAt(inputs, 2);
+        if (K <= 0 || N <= 0 || !values || !indices || values->GetDataType() != DataType::FLOAT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "SparseMatMul requires positive K/N and FLOAT32 values");
+        }
+        if (!IsBlockFormat()) {
+            if (GetStringAttribute("sparse_format", "") != "2:4" || K % 4 != 0) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                   "SparseMatMul supports sparse_format block or 2:4 (K % 4 == 0)");
+            }
+            if (static_cast<int64_t>(values->GetElementCount()) != N * K / 2 ||
+                indices->GetDataType() != DataType::UINT8 ||
+                static_cast<int64_t>(indices->GetElementCount()) != N * K / 2) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                   "SparseMatMul 2:4 requires values and UINT8 indices of [N, K / 2]");
+            }
+            return Status::Ok();
+        }
+        const int64_t block = GetIntAttribute("block_size", 8);
+        const Tensor* row_ptr = InputAt(inputs, 3);
+        if (block != 4 && block != 8) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "SparseMatMul block_size must be 4 or 8");
+        }
+        const int64_t block_rows = (N + block - 1) / block;
+        if (!row_ptr || row_ptr->GetDataType() != DataType::INT32 ||
+            static_cast<int64_t>(row_ptr->GetElementCount()) != block_rows + 1 ||
+            indices->GetDataType() != DataType::INT32) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "SparseMatMul block format requires INT32 columns and row_ptr[N / block + 1]");
+        }
+        const int64_t nnz = static_cast<int64_t>(indices->GetElementCount());
+        const int32_t* ptr = static_cast<const int32_t*>(row_ptr->GetData());
+        if (ptr[0] != 0 || ptr[block_rows] != nnz ||
+            static_cast<int64_t>(values->GetElementCount()) != nnz * block) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                               "SparseMatMul values/row_ptr do not match columns");
+        }
+        return Status::Ok();
+    }
+};
+
+REGISTER_OPERATOR("SparseMatMul", SparseMatMulOperator);
+
+} // namespace operators
+} // namespace inferunity
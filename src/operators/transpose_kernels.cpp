@@ -0,0 +1,187 @@
+// 张量转置引擎实现
+
+#include "transpose_kernels.h"
+#include "parallel_utils.h"
+#include "simd_utils.h"
+#include <cstring>
+
+namespace inferunity {
+namespace operators {
+
+namespace {
+
+std::vector<int64_t> ContiguousStrides(const std::vector<int64_t>& dims) {
+    std::vector<int64_t> strides(dims.size(), 1);
+    for (int64_t i = static_cast<int64_t>(dims.size()) - 2; i >= 0; --i) {
+        strides[i] = strides[i + 1] * dims[i + 1];
+    }
+    return strides;
+}
+
+// 将外层线性下标按outer_dims展开，累加对应的偏移
+int64_t OuterOffset(int64_t index, const std::vector<int64_t>& outer_dims,
+                         const std::vector<int64_t>& outer_strides) {
+    int64_t offset = 0;
+    for (int64_t d = static_cast<int64_t>(outer_dims.size()) - 1; d >= 0 && index > 0; --d) {
+        offset += (index % outer_dims[d]) * outer_strides[d];
+        index /= outer_dims[d];
+    }
+    return offset;
+}
+
+} // anonymous namespace
+
+TransposePlan SimplifyTranspose(const std::vector<int64_t>& dims, const std::vector<int64_t>& perm) {
+    // 去掉长度为1的维度，并把perm重新编号
+    std::vector<int64_t> remap(dims.size(), -1);
+    std::vector<int64_t> kept_dims;
+    for (size_t i = 0; i < dims.size(); ++i) {
+        if (dims[i] != 1) {
+            remap[i] = static_cast<int64_t>(kept_dims.size());
+            kept_dims.push_back(dims[i]);
+        }
+    }
+    std::vector<int64_t> kept_perm;
+    for (int64_t p : perm) {
+        if (remap[p] >= 0) {
+            kept_perm.push_back(remap[p]);
+        }
+    }
+    
+    // 输出中相邻的perm[i], perm[i] + 1在输入中也相邻，合并为一维
+    TransposePlan plan;
+    std::vector<int64_t> group_of(kept_dims.size(), -1);
+    std::vector<int64_t> group_heads;
+    for (size_t i = 0; i < kept_perm.size(); ++i) {
+        if (i > 0 && kept_perm[i] == kept_perm[i - 1] + 1) {
+            group_of[kept_perm[i]] = group_of[kept_perm[i - 1]];
+        } else {
+            group_of[kept_perm[i]] = static_cast<int64_t>(group_heads.size());
+            group_heads.push_back(kept_perm[i]);
+        }
+    }
+    // 合并后的输入维度按输入顺序编号
+    std::vector<int64_t> input_rank_of_group(group_heads.size(), -1);
+    for (size_t i = 0; i < kept_dims.size(); ++i) {
+        const int64_t g = group_of[i];
+        if (input_rank_of_group[g] < 0) {
+            input_rank_of_group[g] = static_cast<int64_t>(plan.dims.size());
+            plan.dims.push_back(kept_dims[i]);
+        } else {
+            plan.dims[input_rank_of_group[g]] *= kept_dims[i];
+        }
+    }
+    for (size_t g = 0; g < group_heads.size(); ++g) {
+        plan.perm.push_back(input_rank_of_group[g]);
+    }
+    return plan;
+}
+
+void TransposeTensor(const void* input, const std::vector<int64_t>& dims,
+                     const std::vector<int64_t>& perm, size_t element_size,
+                     void* output, ExecutionContext* ctx) {
+    int64_t total = 1;
+    for (int64_t d : dims) {
+        total *= d;
+    }
+    if (total == 0) {
+        return;
+    }
+    const TransposePlan plan = SimplifyTranspose(dims, perm);
+    const int64_t rank = static_cast<int64_t>(plan.dims.size());
+    const char* src = static_cast<const char*>(input);
+    char* dst = static_cast<char*>(output);
+    
+    bool identity = true;
+    for (int64_t i = 0; i < rank; ++i) {
+        identity = identity && plan.perm[i] == i;
+    }
+    if (identity) {
+        std::memcpy(dst, src, static_cast<size_t>(total) * element_size);
+        return;
+    }
+    
+    const std::vector<int64_t> input_strides = ContiguousStrides(plan.dims);
+    std::vector<int64_t> output_dims(rank);
+    for (int64_t i = 0; i < rank; ++i) {
+        output_dims[i] = plan.dims[plan.perm[i]];
+    }
+    const std::vector<int64_t> output_strides = ContiguousStrides(output_dims);
+    
+    if (plan.perm[rank - 1] == rank - 1) {
+        // 最内层维度不动（如[0, 2, 1, 3]合并后的[1, 0, 2]）：按输出行整行拷贝
+        const int64_t row = plan.dims[rank - 1];
+        const size_t row_bytes = static_cast<size_t>(row) * element_size;
+        std::vector<int64_t> outer_dims(output_dims.begin(), output_dims.end() - 1);
+        std::vector<int64_t> outer_strides(rank - 1);
+        for (int64_t i = 0; i < rank - 1; ++i) {
+            outer_strides[i] = input_strides[plan.perm[i]];
+        }
+        ParallelForOuter(ctx, total / row, row, [&](int64_t begin, int64_t end) {
+            for (int64_t r = begin; r < end; ++r) {
+                const int64_t offset = OuterOffset(r, outer_dims, outer_strides);
+                std::memcpy(dst + r * row_bytes, src + offset * element_size, row_bytes);
+            }
+        });
+        return;
+    }
+    
+    if (element_size == sizeof(float)) {
+        // 二维内核：输入最内层维度c在输出中位于第b维，输出最内层取输入第a维，
+        // 每个外层下标对应一个[dims[a], dims[c]] -> [dims[c], dims[a]]的转置
+        const int64_t a = plan.perm[rank - 1];
+        const int64_t c = rank - 1;
+        int64_t b = 0;
+        while (plan.perm[b] != c) {
+            ++b;
+        }
+        const int64_t rows = plan.dims[a];
+        const int64_t cols = plan.dims[c];
+        // 剩余维度按输出顺序展开，同时记录输入与输出的偏移
+        std::vector<int64_t> outer_dims;
+        std::vector<int64_t> outer_in_strides;
+        std::vector<int64_t> outer_out_strides;
+        for (int64_t i = 0; i < rank; ++i) {
+            if (i == b || i == rank - 1) {
+                continue;
+            }
+            outer_dims.push_back(output_dims[i]);
+            outer_in_strides.push_back(input_strides[plan.perm[i]]);
+            outer_out_strides.push_back(output_strides[i]);
+        }
+        const int64_t outer = total / (rows * cols);
+        const float* in = static_cast<const float*>(input);
+        float* out = static_cast<float*>(output);
+        ParallelForOuter(ctx, outer, rows * cols, [&](int64_t begin, int64_t end) {
+            for (int64_t o = begin; o < end; ++o) {
+                const int64_t in_offset = OuterOffset(o, outer_dims, outer_in_strides);
+                const int64_t out_offset = OuterOffset(o, outer_dims, outer_out_strides);
+                simd::Transpose2DSIMD(in + in_offset, static_cast<size_t>(input_strides[a]),
+                                      out + out_offset, static_cast<size_t>(output_strides[b]),
+                                      static_cast<size_t>(rows), static_cast<size_t>(cols));
+            }
+        });
+        return;
+    }
+    
+    // 其他元素宽度：按输出顺序逐元素拷贝，最内层维度按输入步长推进
+    const int64_t inner = output_dims[rank - 1];
+    const int64_t inner_stride = input_strides[plan.perm[rank - 1]];
+    std::vector<int64_t> outer_dims(output_dims.begin(), output_dims.end() - 1);
+    std::vector<int64_t> outer_strides(rank - 1);
+    for (int64_t i = 0; i < rank - 1; ++i) {
+        outer_strides[i] = input_strides[plan.perm[i]];
+    }
+    ParallelForOuter(ctx, total / inner, inner, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r) {
+            const char* s = src + OuterOffset(r, outer_dims, outer_strides) * element_size;
+            char* d = dst + r * inner * element_size;
+            for (int64_t j = 0; j < inner; ++j) {
+                std::memcpy(d + j * element_size, s + j * inner_stride * element_size, element_size);
+            }
+        }
+    });
+}
+
+} // namespace operators
+} // namespace inferunity
@@ -0,0 +1,31 @@
+// 张量转置引擎
+// 参考ONNX Runtime的TransposeBase与MLAS的MlasTranspose：先合并在输入输出中保持相邻且顺序不变的维度、
+// 去掉长度为1的维度，再按最内层维度是否移动选择整行拷贝或二维分块转置，外层维度分给算子内线程
+
+#pragma once
+
+#include "inferunity/operator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inferunity {
+namespace operators {
+
+// 合并后的转置描述：输出第i维取输入第perm[i]维
+struct TransposePlan {
+    std::vector<int64_t> dims;    // 合并后的输入维度
+    std::vector<int64_t> perm;
+};
+
+// 合并维度；perm须是0..rank-1的排列
+TransposePlan SimplifyTranspose(const std::vector<int64_t>& dims, const std::vector<int64_t>& perm);
+
+// 把连续的input按perm转置到连续的output；element_size为每个元素的字节数
+// 4字节元素且最内层维度移动时走SIMD二维转置，其余情况整行拷贝或逐元素拷贝
+void TransposeTensor(const void* input, const std::vector<int64_t>& dims,
+                     const std::vector<int64_t>& perm, size_t element_size,
+                     void* output, ExecutionContext* ctx);
+
+} // namespace operators
+} // namespace inferunity
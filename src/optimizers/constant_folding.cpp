@@ -1,5 +1,6 @@
 // 常量折叠Pass实现
-// 参考TVM的常量折叠实现
+// 参考ONNX Runtime的ConstantFolding：输入全部是初始化器的节点在优化期用已注册的CPU算子求值，
+// 输出替换为新的初始化器；按拓扑序反复扫描直到没有可折叠的节点（不动点）
 
 #include "inferunity/optimizer.h"
 #include "inferunity/graph.h"
@@ -10,84 +11,136 @@
 
 namespace inferunity {
 
+namespace {
+
+// 初始化器：带数据、没有生产者且不是图输入（图输入在每次运行时重新绑定）
+bool IsInitializer(const Value* value, const std::unordered_set<const Value*>& graph_inputs) {
+    auto tensor = value->GetTensor();
+    return tensor && tensor->GetData() && !value->GetProducer() && !graph_inputs.count(value);
+}
+
+// 形状完全已知：Shape节点只读输入的形状，声明了静态形状的图输入同样可以折叠
+bool HasStaticShape(const Value* value) {
+    auto tensor = value->GetTensor();
+    if (!tensor || tensor->GetShape().dims.empty()) {
+        return false;
+    }
+    const auto& dims = tensor->GetShape().dims;
+    return std::all_of(dims.begin(), dims.end(), [](int64_t d) { return d > 0; });
+}
+
+// 按字节搬运、与数据类型无关的算子；其余算子的CPU实现按FLOAT32读写，只折叠FLOAT32输入
+bool IsTypeAgnostic(const std::string& op_type) {
+    static const std::unordered_set<std::string> kOps = {
+        "Shape", "Cast", "Reshape", "Concat", "Split", "Gather"
+    };
+    return kOps.count(op_type) > 0;
+}
+
+// 用CPU算子求值单个节点；成功时把结果绑定到输出Value并返回true
+bool TryFoldNode(Node* node, const std::unordered_set<const Value*>& graph_inputs) {
+    const auto& inputs = node->GetInputs();
+    const auto& outputs = node->GetOutputs();
+    if (inputs.empty() || outputs.empty()) {
+        return false;
+    }
+    
+    const bool is_shape = node->GetOpType() == "Shape";
+    const bool type_agnostic = IsTypeAgnostic(node->GetOpType());
+    std::vector<Tensor*> input_tensors;
+    input_tensors.reserve(inputs.size());
+    for (Value* input : inputs) {
+        if (!input) {
+            return false;
+        }
+        const bool usable = IsInitializer(input, graph_inputs) ||
+                            (is_shape && graph_inputs.count(input) && HasStaticShape(input));
+        if (!usable) {
+            return false;
+        }
+        Tensor* tensor = input->GetTensor().get();
+        if (!type_agnostic && tensor->GetDataType() != DataType::FLOAT32) {
+            return false;
+        }
+        input_tensors.push_back(tensor);
+    }
+    
+    auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+    if (!op) {
+        return false;
+    }
+    ApplyNodeAttributes(*node, op.get());
+    if (!op->ValidateInputs(input_tensors).IsOk()) {
+        return false;
+    }
+    std::vector<Shape> output_shapes;
+    if (!op->InferOutputShape(input_tensors, output_shapes).IsOk() ||
+        output_shapes.size() < outputs.size()) {
+        return false;
+    }
+    
+    std::vector<std::shared_ptr<Tensor>> results;
+    std::vector<Tensor*> output_tensors;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        results.push_back(CreateTensor(output_shapes[i], op->InferOutputDataType(input_tensors, i),
+                                       DeviceType::CPU));
+        output_tensors.push_back(results.back().get());
+    }
+    ExecutionContext ctx;
+    if (!op->Execute(input_tensors, output_tensors, &ctx).IsOk()) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        outputs[i]->SetTensor(results[i]);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
 Status ConstantFoldingPass::Run(Graph* graph) {
     if (!graph) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
     }
     
-    // 找到所有常量节点（输入是初始值的节点）
-    std::unordered_set<Node*> to_remove;
-    std::unordered_map<Value*, Tensor*> constant_values;
-    
-    // 第一遍：识别常量值（来自initializer的Value）
-    for (const auto& value_ptr : graph->GetValues()) {
-        Value* value = value_ptr.get();
-        if (value->GetTensor() && value->GetProducer() == nullptr) {
-            // 这是一个初始值（常量）
-            constant_values[value] = value->GetTensor().get();
-        }
-    }
+    const std::unordered_set<const Value*> graph_inputs(graph->GetInputs().begin(),
+                                                        graph->GetInputs().end());
+    // 被折叠节点读取过的值，折叠结束后若已无消费者则删除
+    std::vector<Value*> folded_inputs;
+    std::unordered_set<Value*> seen_inputs;
     
-    // 第二遍：找到可以折叠的节点
-    // 如果一个节点的所有输入都是常量，且算子支持常量折叠，则可以折叠
-    for (const auto& node_ptr : graph->GetNodes()) {
-        Node* node = node_ptr.get();
-        
-        // 检查所有输入是否都是常量
-        bool all_constants = true;
-        std::vector<Tensor*> constant_inputs;
-        
-        for (Value* input : node->GetInputs()) {
-            auto it = constant_values.find(input);
-            if (it != constant_values.end()) {
-                constant_inputs.push_back(it->second);
-            } else {
-                all_constants = false;
-                break;
+    // 拓扑序保证一条常量链在一遍内折叠完；再扫描一遍确认没有新的可折叠节点
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (Node* node : graph->GetTopologicalOrder()) {
+            if (!TryFoldNode(node, graph_inputs)) {
+                continue;
             }
-        }
-        
-        if (all_constants && !constant_inputs.empty()) {
-            // 尝试执行常量折叠
-            // 创建算子并执行
-            auto op = OperatorRegistry::Instance().Create(node->GetOpType());
-            if (op) {
-                // 推断输出形状
-                std::vector<Shape> output_shapes;
-                Status status = op->InferOutputShape(constant_inputs, output_shapes);
-                if (status.IsOk() && !output_shapes.empty()) {
-                    // 创建输出张量
-                    auto output_tensor = CreateTensor(output_shapes[0], 
-                                                     constant_inputs[0]->GetDataType());
-                    std::vector<Tensor*> outputs = {output_tensor.get()};
-                    
-                    // 执行计算
-                    ExecutionContext ctx;
-                    status = op->Execute(constant_inputs, outputs, &ctx);
-                    
-                    if (status.IsOk()) {
-                        // 用常量值替换输出Value
-                        if (!node->GetOutputs().empty()) {
-                            Value* output_value = node->GetOutputs()[0];
-                            output_value->SetTensor(output_tensor);
-                            constant_values[output_value] = output_tensor.get();
-                            
-                            // 标记节点为可删除
-                            to_remove.insert(node);
-                        }
-                    }
+            for (Value* input : node->GetInputs()) {
+                if (seen_inputs.insert(input).second) {
+                    folded_inputs.push_back(input);
                 }
             }
+            // 输出Value保留名称，生产者被清空后即成为新的初始化器
+            graph->RemoveNode(node);
+            changed = true;
         }
     }
     
-    // 删除已折叠的节点
-    for (Node* node : to_remove) {
-        graph->RemoveNode(node);
+    // 删除不再被使用的旧初始化器，释放其权重内存
+    std::unordered_set<const Value*> in_use(graph->GetOutputs().begin(), graph->GetOutputs().end());
+    for (const auto& node : graph->GetNodes()) {
+        in_use.insert(node->GetInputs().begin(), node->GetInputs().end());
+    }
+    for (Value* value : folded_inputs) {
+        if (!in_use.count(value) && !value->GetProducer() && !graph_inputs.count(value)) {
+            graph->RemoveValue(value);
+        }
     }
     
     return Status::Ok();
 }
 
 } // namespace inferunity
-
@@ -0,0 +1,148 @@
+// Conv+BatchNormalization折叠Pass实现
+// 参考ONNX Runtime的ConvBNFusion与NCNN的fuse_convolution_batchnorm：
+// 把BN的逐通道仿射变换折算进Conv的权重和bias，推理时省去对激活张量的一遍读写
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cmath>
+
+namespace inferunity {
+
+using fusion::Match;
+
+namespace {
+
+float BatchNormEpsilon(const Node& bn) {
+    const AttributeValue* epsilon = bn.FindAttribute("epsilon");
+    if (epsilon && epsilon->GetType() == AttributeValue::Type::FLOAT) {
+        return epsilon->GetFloat();
+    }
+    if (epsilon && epsilon->GetType() == AttributeValue::Type::INT) {
+        return static_cast<float>(epsilon->GetInt());
+    }
+    return 1e-5f;
+}
+
+// FLOAT32常量且元素个数为count
+const float* ConstantData(const Graph& graph, const Value* value, size_t count) {
+    if (!fusion::IsConstant(graph, value) || value->GetDataType() != DataType::FLOAT32 ||
+        value->GetTensor()->GetElementCount() != count) {
+        return nullptr;
+    }
+    return static_cast<const float*>(value->GetTensor()->GetData());
+}
+
+bool CanFold(const Graph& graph, const Match& match) {
+    const Node* bn = match.nodes[0];
+    const Node* conv = match.nodes[1];
+    const auto& conv_inputs = conv->GetInputs();
+    const Value* weight = conv_inputs[1];
+    if (!fusion::IsConstant(graph, weight) || weight->GetDataType() != DataType::FLOAT32 ||
+        weight->GetShape().dims.size() != 4 || bn->GetInputs()[0] != conv->GetOutputs()[0]) {
+        return false;
+    }
+    const size_t out_c = static_cast<size_t>(weight->GetShape().dims[0]);
+    if (conv_inputs.size() == 3 && !ConstantData(graph, conv_inputs[2], out_c)) {
+        return false;
+    }
+    for (size_t i = 1; i < 5; ++i) {
+        if (!ConstantData(graph, bn->GetInputs()[i], out_c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 改写Conv为x, W', b'并接管BN的输出
+Status FoldBatchNorm(Graph* graph, const Match& match) {
+    Node* bn = match.nodes[0];
+    Node* conv = match.nodes[1];
+    const std::vector<Value*> conv_inputs = conv->GetInputs();
+    const std::vector<Value*> bn_inputs = bn->GetInputs();
+    Value* weight = conv_inputs[1];
+    Value* bias = conv_inputs.size() == 3 ? conv_inputs[2] : nullptr;
+    
+    const Shape& weight_shape = weight->GetShape();
+    const int64_t out_c = weight_shape.dims[0];
+    const int64_t per_channel = static_cast<int64_t>(weight->GetTensor()->GetElementCount()) / out_c;
+    const float epsilon = BatchNormEpsilon(*bn);
+    const float* w = static_cast<const float*>(weight->GetTensor()->GetData());
+    const float* b = bias ? static_cast<const float*>(bias->GetTensor()->GetData()) : nullptr;
+    const float* gamma = static_cast<const float*>(bn_inputs[1]->GetTensor()->GetData());
+    const float* beta = static_cast<const float*>(bn_inputs[2]->GetTensor()->GetData());
+    const float* mean = static_cast<const float*>(bn_inputs[3]->GetTensor()->GetData());
+    const float* var = static_cast<const float*>(bn_inputs[4]->GetTensor()->GetData());
+    
+    // 新建权重而不是原地修改：原权重可能被其他节点共享
+    auto folded_w = CreateTensor(weight_shape, DataType::FLOAT32, DeviceType::CPU);
+    auto folded_b = CreateTensor(Shape({out_c}), DataType::FLOAT32, DeviceType::CPU);
+    float* fw = static_cast<float*>(folded_w->GetData());
+    float* fb = static_cast<float*>(folded_b->GetData());
+    for (int64_t oc = 0; oc < out_c; ++oc) {
+        const float scale = gamma[oc] / std::sqrt(var[oc] + epsilon);
+        for (int64_t i = 0; i < per_channel; ++i) {
+            fw[oc * per_channel + i] = w[oc * per_channel + i] * scale;
+        }
+        fb[oc] = ((b ? b[oc] : 0.0f) - mean[oc]) * scale + beta[oc];
+    }
+    
+    Value* x = conv_inputs[0];
+    for (Value* input : conv_inputs) {
+        conv->RemoveInput(input);
+    }
+    conv->AddInput(x);
+    conv->AddInput(fusion::AddConstant(graph, folded_w, weight->GetName() + "_bn_folded"));
+    conv->AddInput(fusion::AddConstant(graph, folded_b, conv->GetName() + "_bn_folded_bias"));
+    
+    // Conv接管BN的输出
+    Value* conv_output = conv->GetOutputs()[0];
+    const std::vector<Value*> bn_outputs = bn->GetOutputs();
+    graph->RemoveNode(bn);
+    conv->RemoveOutput(conv_output);
+    graph->RemoveValue(conv_output);
+    for (Value* output : bn_outputs) {
+        conv->AddOutput(output);
+    }
+    
+    // 删除不再被使用的原常量
+    std::vector<Value*> candidates(bn_inputs.begin() + 1, bn_inputs.end());
+    candidates.push_back(weight);
+    if (bias) {
+        candidates.push_back(bias);
+    }
+    for (Value* value : candidates) {
+        const auto& outputs = graph->GetOutputs();
+        if (value->GetConsumers().empty() &&
+            std::find(outputs.begin(), outputs.end(), value) == outputs.end()) {
+            graph->RemoveValue(value);
+        }
+    }
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+Status ConvBNFoldingPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    
+    fusion::FusionRule rule;
+    rule.pattern.name = "ConvBatchNormalization";
+    rule.pattern.nodes = {
+        {{"BatchNormalization"}, 5, {{0, 1}}, nullptr},
+        {{"Conv"}, -1, {}, [](const Node& conv) {
+             return conv.GetInputs().size() == 2 || conv.GetInputs().size() == 3;
+         }},
+    };
+    rule.pattern.constraint = CanFold;
+    rule.rewrite = FoldBatchNorm;
+    fusion::ApplyFusionRules(graph, {rule});
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,243 @@
+// 声明式子图模式匹配实现
+// 参考ONNX Runtime的SelectorActionTransformer：从根节点沿输入边回溯匹配，匹配失败时回溯尝试交换律算子的另一个输入
+
+#include "fusion_pattern.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace inferunity {
+namespace fusion {
+
+Value* Match::Input(int index, size_t slot) const {
+    const auto& inputs = nodes[index]->GetInputs();
+    return slot < inputs.size() ? inputs[slot] : nullptr;
+}
+
+Value* Match::OtherInput(int index, int source) const {
+    for (Value* input : nodes[index]->GetInputs()) {
+        if (input->GetProducer() != nodes[source]) {
+            return input;
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+bool NodeMatches(const PatternNode& pattern, const Node* node) {
+    const OpTypeId id = node->GetOpTypeId();
+    if (std::none_of(pattern.op_types.begin(), pattern.op_types.end(),
+                     [id](const OpType& op_type) { return op_type.id == id; })) {
+        return false;
+    }
+    if (pattern.num_inputs >= 0 &&
+        node->GetInputs().size() != static_cast<size_t>(pattern.num_inputs)) {
+        return false;
+    }
+    return !pattern.predicate || pattern.predicate(*node);
+}
+
+// 边(parent, slot) -> source是否成立
+bool EdgeHolds(const Match& match, int parent, const PatternEdge& edge) {
+    const auto& inputs = match.nodes[parent]->GetInputs();
+    Node* source = match.nodes[edge.source];
+    if (edge.slot == kAnyInputSlot) {
+        return std::any_of(inputs.begin(), inputs.end(),
+                           [source](const Value* v) { return v->GetProducer() == source; });
+    }
+    return static_cast<size_t>(edge.slot) < inputs.size() &&
+           inputs[edge.slot]->GetProducer() == source;
+}
+
+// 子图内部的中间值只能被子图内的节点消费，且不能是图输出
+bool IsSelfContained(const Graph& graph, const Match& match) {
+    const std::unordered_set<const Node*> members(match.nodes.begin(), match.nodes.end());
+    const auto& graph_outputs = graph.GetOutputs();
+    for (size_t i = 1; i < match.nodes.size(); ++i) {
+        for (const Value* output : match.nodes[i]->GetOutputs()) {
+            if (std::find(graph_outputs.begin(), graph_outputs.end(), output) != graph_outputs.end()) {
+                return false;
+            }
+            for (const Node* consumer : output->GetConsumers()) {
+                if (!members.count(consumer)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool VerifyMatch(const Graph& graph, const Pattern& pattern, const Match& match) {
+    for (size_t i = 0; i < pattern.nodes.size(); ++i) {
+        for (const PatternEdge& edge : pattern.nodes[i].edges) {
+            if (!EdgeHolds(match, static_cast<int>(i), edge)) {
+                return false;
+            }
+        }
+    }
+    return IsSelfContained(graph, match) &&
+           (!pattern.constraint || pattern.constraint(graph, match));
+}
+
+// 依次为模式节点index寻找候选节点，失败时回溯
+bool MatchFrom(const Graph& graph, const Pattern& pattern, size_t index, Match* match) {
+    if (index == pattern.nodes.size()) {
+        return VerifyMatch(graph, pattern, *match);
+    }
+    
+    // 第一条指向index的边决定候选节点
+    for (size_t parent = 0; parent < index; ++parent) {
+        for (const PatternEdge& edge : pattern.nodes[parent].edges) {
+            if (edge.source != static_cast<int>(index)) {
+                continue;
+            }
+            const auto& inputs = match->nodes[parent]->GetInputs();
+            std::vector<Value*> candidates;
+            if (edge.slot == kAnyInputSlot) {
+                candidates = inputs;
+            } else if (static_cast<size_t>(edge.slot) < inputs.size()) {
+                candidates.push_back(inputs[edge.slot]);
+            }
+            for (Value* value : candidates) {
+                Node* producer = value->GetProducer();
+                if (!producer || !NodeMatches(pattern.nodes[index], producer) ||
+                    std::find(match->nodes.begin(), match->nodes.begin() + index, producer) !=
+                        match->nodes.begin() + index) {
+                    continue;
+                }
+                match->nodes[index] = producer;
+                if (MatchFrom(graph, pattern, index + 1, match)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;  // 模式不连通
+}
+
+} // anonymous namespace
+
+bool MatchPattern(const Graph& graph, const Pattern& pattern, Node* root, Match* match) {
+    if (!root || pattern.nodes.empty() || !NodeMatches(pattern.nodes[0], root)) {
+        return false;
+    }
+    match->nodes.assign(pattern.nodes.size(), nullptr);
+    match->nodes[0] = root;
+    return MatchFrom(graph, pattern, 1, match);
+}
+
+int ApplyFusionRules(Graph* graph, const std::vector<FusionRule>& rules) {
+    int rewrites = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // 被改写删除的节点在本轮剩余的遍历中跳过（新建的融合节点留给下一轮）
+        std::unordered_set<const Node*> removed;
+        for (Node* node : graph->GetTopologicalOrder()) {
+            if (removed.count(node)) {
+                continue;
+            }
+            for (const FusionRule& rule : rules) {
+                Match match;
+                if (!MatchPattern(*graph, rule.pattern, node, &match)) {
+                    continue;
+                }
+                if (rule.rewrite(graph, match).IsOk()) {
+                    removed.insert(match.nodes.begin(), match.nodes.end());
+                    ++rewrites;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return rewrites;
+}
+
+Node* ReplaceMatch(Graph* graph, const Match& match, const std::string& op_type,
+                   const std::vector<Value*>& inputs, const NodeAttributes& attributes) {
+    // Node不支持重复输入，此类子图保持原状
+    std::unordered_set<const Value*> unique_inputs;
+    for (const Value* input : inputs) {
+        if (!input || !unique_inputs.insert(input).second) {
+            return nullptr;
+        }
+    }
+    
+    std::string name;
+    for (auto it = match.nodes.rbegin(); it != match.nodes.rend(); ++it) {
+        name += (*it)->GetName() + "_";
+    }
+    Node* fused = graph->AddNode(op_type, name + "fused");
+    for (const auto& attr : attributes) {
+        fused->SetAttribute(attr.first, attr.second);
+    }
+    for (Value* input : inputs) {
+        fused->AddInput(input);
+    }
+    
+    const std::vector<Value*> outputs = match.Root()->GetOutputs();
+    std::vector<Value*> internal;
+    for (size_t i = 1; i < match.nodes.size(); ++i) {
+        const auto& node_outputs = match.nodes[i]->GetOutputs();
+        internal.insert(internal.end(), node_outputs.begin(), node_outputs.end());
+    }
+    for (Node* node : match.nodes) {
+        graph->RemoveNode(node);
+    }
+    for (Value* output : outputs) {
+        fused->AddOutput(output);
+    }
+    for (Value* value : internal) {
+        graph->RemoveValue(value);
+    }
+    return fused;
+}
+
+bool IsConstant(const Graph& graph, const Value* value) {
+    if (!value || value->GetProducer() || !value->GetTensor() || !value->GetTensor()->GetData()) {
+        return false;
+    }
+    const auto& inputs = graph.GetInputs();
+    return std::find(inputs.begin(), inputs.end(), value) == inputs.end();
+}
+
+Value* AddConstant(Graph* graph, const std::shared_ptr<Tensor>& tensor, const std::string& name) {
+    Value* value = graph->AddValue();
+    value->SetName(name);
+    value->SetTensor(tensor);
+    return value;
+}
+
+bool GetScalarConstant(const Graph& graph, const Value* value, float* scalar) {
+    if (!IsConstant(graph, value)) {
+        return false;
+    }
+    auto tensor = value->GetTensor();
+    if (tensor->GetDataType() != DataType::FLOAT32 || tensor->GetElementCount() != 1) {
+        return false;
+    }
+    *scalar = *static_cast<const float*>(tensor->GetData());
+    return true;
+}
+
+bool HasKnownShape(const Value* value) {
+    if (!value || !value->GetTensor()) {
+        return false;
+    }
+    const auto& dims = value->GetShape().dims;
+    return std::all_of(dims.begin(), dims.end(), [](int64_t d) { return d > 0; });
+}
+
+std::function<bool(const Node&)> AttributeIs(const std::string& key, const std::string& value,
+                                             const std::string& default_value) {
+    return [key, value, default_value](const Node& node) {
+        return node.GetAttribute(key, default_value) == value;
+    };
+}
+
+} // namespace fusion
+} // namespace inferunity
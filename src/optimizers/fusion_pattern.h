@@ -0,0 +1,104 @@
+// 声明式子图模式匹配
+// 参考ONNX Runtime的GraphTransformer/SelectorActionTransformer与TVM的DFPattern：
+// 模式描述算子类型、输入个数、属性谓词以及节点之间的数据流边，匹配后由改写规则替换子图
+
+#pragma once
+
+#include "inferunity/graph.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace fusion {
+
+// 交换律算子（Add/Mul）的边可以来自任一输入位置
+constexpr int kAnyInputSlot = -1;
+
+// 模式节点的第slot个输入由模式节点source产生
+struct PatternEdge {
+    int slot;
+    int source;
+};
+
+struct PatternNode {
+    std::vector<OpType> op_types;                 // 匹配其中任一类型，按驻留ID比较
+    int num_inputs = -1;                          // 精确输入个数，-1表示不检查
+    std::vector<PatternEdge> edges;
+    std::function<bool(const Node&)> predicate;   // 属性谓词，可为空
+};
+
+struct Match;
+
+// nodes[0]为根（子图的输出节点），其余节点沿edges从根向输入方向展开；
+// 每个非根节点第一次出现的入边必须来自下标更小的节点。
+// 非根节点的输出只能被子图内部使用（单消费者约束），且不能是图输出
+struct Pattern {
+    std::string name;
+    std::vector<PatternNode> nodes;
+    std::function<bool(const Graph&, const Match&)> constraint;  // 匹配后的整体约束，可为空
+};
+
+struct Match {
+    std::vector<Node*> nodes;  // 与Pattern::nodes一一对应
+    
+    Node* Root() const { return nodes[0]; }
+    // 模式节点index的第slot个输入
+    Value* Input(int index, size_t slot) const;
+    // 二元节点index中不是由模式节点source产生的另一个输入
+    Value* OtherInput(int index, int source) const;
+};
+
+// 以root为根尝试匹配pattern
+bool MatchPattern(const Graph& graph, const Pattern& pattern, Node* root, Match* match);
+
+// 改写规则：匹配成功后调用rewrite替换子图
+struct FusionRule {
+    Pattern pattern;
+    std::function<Status(Graph*, const Match&)> rewrite;
+};
+
+// 对图按拓扑序应用一组规则直到不再匹配，返回改写次数
+int ApplyFusionRules(Graph* graph, const std::vector<FusionRule>& rules);
+
+// ---- 改写辅助 ----
+
+// 用一个新节点替换匹配到的子图：新节点接管根节点的输出，子图内部的中间值被删除
+Node* ReplaceMatch(Graph* graph, const Match& match, const std::string& op_type,
+                   const std::vector<Value*>& inputs, const NodeAttributes& attributes);
+
+// 初始化器：带张量、没有生产者且不是图输入
+bool IsConstant(const Graph& graph, const Value* value);
+
+// 值是图输出；内联定义，算子库（AOT编译）不链接优化器库也可使用
+inline bool IsGraphOutput(const Graph& graph, const Value* value) {
+    const auto& outputs = graph.GetOutputs();
+    return std::find(outputs.begin(), outputs.end(), value) != outputs.end();
+}
+
+// 值唯一的使用者；值有多个使用者或本身是图输出时返回nullptr
+inline Node* SoleConsumer(const Graph& graph, const Value* value) {
+    const auto& consumers = value->GetConsumers();
+    if (consumers.size() != 1 || IsGraphOutput(graph, value)) {
+        return nullptr;
+    }
+    return consumers[0];
+}
+
+// 新增一个以tensor为数据的常量值
+Value* AddConstant(Graph* graph, const std::shared_ptr<Tensor>& tensor, const std::string& name);
+
+// 只含一个元素的FLOAT32常量
+bool GetScalarConstant(const Graph& graph, const Value* value, float* scalar);
+
+// 值的形状已知（形状推断或初始化器提供）
+bool HasKnownShape(const Value* value);
+
+// 谓词：属性key等于value（缺省时与default_value比较）
+std::function<bool(const Node&)> AttributeIs(const std::string& key, const std::string& value,
+                                             const std::string& default_value = "");
+
+} // namespace fusion
+} // namespace inferunity
@@ -0,0 +1,641 @@
+// 图化简Pass实现：公共子表达式消除、恒等算子消除与转置下沉
+// 参考ONNX Runtime的CommonSubexpressionElimination / EliminateIdentity / EliminateDropout /
+// TransposeOptimizer与onnx-simplifier：导出的图里Shape->Gather->Unsqueeze链按每个消费者重复一遍，
+// 同一输入上的相同Transpose出现多次，Identity/Dropout/无效Reshape原样保留，都会在运行时白白执行
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/model_format.h"
+#include "inferunity/shape_inference.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+// 超过该大小的常量不参与按内容去重（大权重由SharedWeightStore跨会话去重）
+constexpr size_t kMaxCseConstantBytes = 4096;
+
+bool IsGraphInput(const Graph& graph, const Value* value) {
+    const auto& inputs = graph.GetInputs();
+    return std::find(inputs.begin(), inputs.end(), value) != inputs.end();
+}
+
+// 每次执行结果可能不同或带副作用的算子，不能合并
+bool IsNondeterministic(const std::string& op_type) {
+    return op_type == "RandomNormal" || op_type == "RandomUniform" ||
+           op_type == "RandomNormalLike" || op_type == "RandomUniformLike" ||
+           op_type == "Multinomial" || op_type == "Bernoulli" || op_type == "Dropout";
+}
+
+bool SameTensorContents(const Tensor* a, const Tensor* b) {
+    if (a == b) {
+        return true;
+    }
+    if (!a || !b || a->GetDataType() != b->GetDataType() || a->GetShape().dims != b->GetShape().dims ||
+        !a->GetData() || !b->GetData() || !a->IsContiguous() || !b->IsContiguous()) {
+        return false;
+    }
+    return std::memcmp(a->GetData(), b->GetData(), a->GetSizeInBytes()) == 0;
+}
+
+// 张量属性按内容比较，其余属性按值比较
+bool SameAttributes(const Node& a, const Node& b) {
+    const NodeAttributes& lhs = a.GetAttributes();
+    const NodeAttributes& rhs = b.GetAttributes();
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (const auto& entry : lhs) {
+        auto it = rhs.find(entry.first);
+        if (it == rhs.end()) {
+            return false;
+        }
+        if (entry.second.GetType() == AttributeValue::Type::TENSOR &&
+            it->second.GetType() == AttributeValue::Type::TENSOR) {
+            if (!SameTensorContents(entry.second.GetTensor().get(), it->second.GetTensor().get())) {
+                return false;
+            }
+        } else if (entry.second != it->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 节点签名：算子类型、按键排序的带类型属性与输入（已替换为代表值）；
+// 同签名的节点再经SameAttributes确认（张量属性在签名中只有内容哈希）
+std::string NodeSignature(const Node& node) {
+    std::string signature = node.GetOpType();
+    signature += '\0';
+    for (const Value* input : node.GetInputs()) {
+        signature += std::to_string(reinterpret_cast<uintptr_t>(input));
+        signature += ',';
+    }
+    signature += '\0';
+    std::map<std::string, const AttributeValue*> sorted;
+    for (const auto& entry : node.GetAttributes()) {
+        sorted.emplace(entry.first, &entry.second);
+    }
+    for (const auto& entry : sorted) {
+        signature += entry.first;
+        signature += '=';
+        signature += std::to_string(static_cast<int>(entry.second->GetType()));
+        signature += ':';
+        if (entry.second->GetType() == AttributeValue::Type::TENSOR) {
+            const auto& tensor = entry.second->GetTensor();
+            signature += tensor ? std::to_string(HashTensorData(*tensor)) : std::string("null");
+        } else {
+            signature += entry.second->ToString();
+        }
+        signature += ';';
+    }
+    signature += '\0';
+    signature += std::to_string(node.GetOutputs().size());
+    return signature;
+}
+
+// 删除已不被使用的常量输入
+void RemoveUnusedConstants(Graph* graph, const std::vector<Value*>& inputs) {
+    for (Value* input : inputs) {
+        if (input->GetConsumers().empty() && fusion::IsConstant(*graph, input) && !fusion::IsGraphOutput(*graph, input)) {
+            graph->RemoveValue(input);
+        }
+    }
+}
+
+// 相同内容的小常量合并为一个：不同消费者各自携带的同值索引/轴常量合并后，
+// 依赖它们的Gather/Unsqueeze才会有相同的输入
+int MergeDuplicateConstants(Graph* graph) {
+    std::unordered_map<uint64_t, std::vector<Value*>> by_hash;
+    std::vector<Value*> constants;
+    for (const auto& value : graph->GetValues()) {
+        Value* v = value.get();
+        if (!fusion::IsConstant(*graph, v) || fusion::IsGraphOutput(*graph, v) || v->GetConsumers().empty()) {
+            continue;
+        }
+        const auto& tensor = v->GetTensor();
+        if (tensor->GetDeviceType() != DeviceType::CPU || !tensor->GetData() ||
+            tensor->GetSizeInBytes() > kMaxCseConstantBytes) {
+            continue;
+        }
+        constants.push_back(v);
+    }
+    int merged = 0;
+    for (Value* v : constants) {
+        auto& candidates = by_hash[HashTensorData(*v->GetTensor())];
+        Value* representative = nullptr;
+        for (Value* candidate : candidates) {
+            if (SameTensorContents(candidate->GetTensor().get(), v->GetTensor().get())) {
+                representative = candidate;
+                break;
+            }
+        }
+        if (!representative) {
+            candidates.push_back(v);
+            continue;
+        }
+        const std::vector<Node*> consumers = v->GetConsumers();
+        for (Node* consumer : consumers) {
+            consumer->ReplaceInput(v, representative);
+        }
+        graph->RemoveValue(v);
+        ++merged;
+    }
+    return merged;
+}
+
+// 让output的使用者改用source。output是图输出时由source接替并继承名称（输出名是对外接口）；
+// source是图输入、常量或已经是图输出时无法接替，返回false且不修改图
+bool ForwardValue(Graph* graph, Value* output, Value* source) {
+    const bool graph_output = fusion::IsGraphOutput(*graph, output);
+    if (graph_output && (IsGraphInput(*graph, source) || fusion::IsGraphOutput(*graph, source) ||
+                         !source->GetProducer())) {
+        return false;
+    }
+    const std::vector<Node*> consumers = output->GetConsumers();
+    for (Node* consumer : consumers) {
+        consumer->ReplaceInput(output, source);
+    }
+    if (graph_output) {
+        graph->ReplaceOutput(output, source);
+    }
+    return true;
+}
+
+// 节点的第一个输出等于source时删除节点：其余输出必须没有使用者
+bool RemovePassThrough(Graph* graph, Node* node, Value* source) {
+    const std::vector<Value*> outputs = node->GetOutputs();
+    if (outputs.empty()) {
+        return false;
+    }
+    for (size_t i = 1; i < outputs.size(); ++i) {
+        if (!outputs[i]->GetConsumers().empty() || fusion::IsGraphOutput(*graph, outputs[i])) {
+            return false;
+        }
+    }
+    Value* output = outputs[0];
+    const bool rename = fusion::IsGraphOutput(*graph, output);
+    const std::string name = output->GetName();
+    if (!ForwardValue(graph, output, source)) {
+        return false;
+    }
+    const std::vector<Value*> inputs = node->GetInputs();
+    graph->RemoveNode(node);
+    for (Value* value : outputs) {
+        graph->RemoveValue(value);
+    }
+    if (rename) {
+        source->SetName(name);
+    }
+    RemoveUnusedConstants(graph, inputs);
+    return true;
+}
+
+// Cast的to（ONNX TensorProto编号，与CastOperator一致）
+DataType CastTargetType(const Node& node) {
+    const AttributeValue* to = node.FindAttribute("to");
+    if (!to || to->GetType() != AttributeValue::Type::INT) {
+        return DataType::UNKNOWN;
+    }
+    switch (to->GetInt()) {
+        case 1: return DataType::FLOAT32;
+        case 2: return DataType::UINT8;
+        case 3: return DataType::INT8;
+        case 6: return DataType::INT32;
+        case 7: return DataType::INT64;
+        case 9: return DataType::BOOL;
+        case 10: return DataType::FLOAT16;
+        case 16: return DataType::BFLOAT16;
+        default: return DataType::UNKNOWN;
+    }
+}
+
+bool GetPermutation(const Node& node, std::vector<int64_t>* perm) {
+    const AttributeValue* attr = node.FindAttribute("perm");
+    if (!attr || attr->GetType() != AttributeValue::Type::INTS || attr->GetInts().empty()) {
+        return false;
+    }
+    *perm = attr->GetInts();
+    return true;
+}
+
+bool IsIdentityPermutation(const std::vector<int64_t>& perm) {
+    for (size_t i = 0; i < perm.size(); ++i) {
+        if (perm[i] != static_cast<int64_t>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 推理模式的Dropout：没有training_mode输入或其为常量false，且mask输出没有使用者（由RemovePassThrough检查）
+bool IsInferenceDropout(const Graph& graph, const Node& node) {
+    if (node.GetInputs().size() < 3) {
+        return true;
+    }
+    const Value* training = node.GetInputs()[2];
+    if (!fusion::IsConstant(graph, training)) {
+        return false;
+    }
+    const auto& tensor = training->GetTensor();
+    if (!tensor->GetData() || tensor->GetElementCount() != 1) {
+        return false;
+    }
+    const size_t size = Tensor::GetDataTypeSize(tensor->GetDataType());
+    const uint8_t* bytes = static_cast<const uint8_t*>(tensor->GetData());
+    return std::all_of(bytes, bytes + size, [](uint8_t b) { return b == 0; });
+}
+
+// 无效Reshape：输入与输出的形状都已知且相同
+bool IsNoOpReshape(const Node& node) {
+    if (node.GetInputs().empty() || node.GetOutputs().size() != 1) {
+        return false;
+    }
+    const Value* input = node.GetInputs()[0];
+    const Value* output = node.GetOutputs()[0];
+    return fusion::HasKnownShape(input) && fusion::HasKnownShape(output) &&
+           input->GetShape().dims == output->GetShape().dims;
+}
+
+// node是恒等变换时返回它的数据来源，否则返回nullptr
+Value* PassThroughSource(const Graph& graph, Node* node) {
+    const std::string& op_type = node->GetOpType();
+    const auto& inputs = node->GetInputs();
+    if (inputs.empty() || node->GetOutputs().empty()) {
+        return nullptr;
+    }
+    if (op_type == "Identity") {
+        return inputs[0];
+    }
+    if (op_type == "Dropout") {
+        return IsInferenceDropout(graph, *node) ? inputs[0] : nullptr;
+    }
+    if (op_type == "Reshape") {
+        return IsNoOpReshape(*node) ? inputs[0] : nullptr;
+    }
+    if (op_type == "Cast") {
+        const DataType target = CastTargetType(*node);
+        return target != DataType::UNKNOWN && inputs[0]->GetTensor() &&
+               inputs[0]->GetDataType() == target ? inputs[0] : nullptr;
+    }
+    if (op_type == "Transpose") {
+        std::vector<int64_t> perm;
+        if (!GetPermutation(*node, &perm)) {
+            return nullptr;
+        }
+        if (IsIdentityPermutation(perm)) {
+            return inputs[0];
+        }
+        // Transpose(p2)∘Transpose(p1)：结果第j维取自x的第p1[p2[j]]维，复合为恒等时两者互逆
+        Node* inner = inputs[0]->GetProducer();
+        std::vector<int64_t> inner_perm;
+        if (!inner || inner->GetOpType() != "Transpose" || inner->GetInputs().empty() ||
+            !GetPermutation(*inner, &inner_perm) || inner_perm.size() != perm.size()) {
+            return nullptr;
+        }
+        for (size_t j = 0; j < perm.size(); ++j) {
+            if (perm[j] < 0 || perm[j] >= static_cast<int64_t>(perm.size()) ||
+                inner_perm[perm[j]] != static_cast<int64_t>(j)) {
+                return nullptr;
+            }
+        }
+        return inner->GetInputs()[0];
+    }
+    return nullptr;
+}
+
+// 删除所有输出都没有使用者的节点（被绕过的内层Transpose等）
+void RemoveIfDead(Graph* graph, Node* node) {
+    for (Value* output : node->GetOutputs()) {
+        if (!output->GetConsumers().empty() || fusion::IsGraphOutput(*graph, output)) {
+            return;
+        }
+    }
+    const std::vector<Value*> inputs = node->GetInputs();
+    const std::vector<Value*> outputs = node->GetOutputs();
+    graph->RemoveNode(node);
+    for (Value* output : outputs) {
+        graph->RemoveValue(output);
+    }
+    RemoveUnusedConstants(graph, inputs);
+}
+
+// 与轴置换可交换的逐元素算子（含多向广播）：各输入先做同一个置换再计算，等于计算后再置换
+bool CommutesWithTranspose(const std::string& op_type) {
+    static const std::unordered_set<std::string> kOps = {
+        "Relu", "Sigmoid", "Tanh", "Gelu", "Silu", "Exp", "Log", "Sqrt", "Abs", "Neg", "Erf", "Sign",
+        "Reciprocal", "Floor", "Ceil", "Round", "Not", "LeakyRelu", "Elu", "HardSigmoid", "HardSwish",
+        "Softplus", "Cast", "Clip", "Add", "Sub", "Mul", "Div", "Pow", "Max", "Min", "Sum", "Mean", "PRelu",
+        "Equal", "Greater", "Less", "GreaterOrEqual", "LessOrEqual", "And", "Or", "Xor", "Where"};
+    return kOps.count(op_type) > 0;
+}
+
+// 常量按q重排：结果第i维取自原张量的第q[i]维；秩小于q时先在前面补1维（与广播的对齐方式一致）
+std::shared_ptr<Tensor> PermuteConstant(const Tensor& tensor, const std::vector<int64_t>& q) {
+    const size_t rank = q.size();
+    const auto& source_dims = tensor.GetShape().dims;
+    std::vector<int64_t> dims(rank, 1);
+    std::copy(source_dims.begin(), source_dims.end(), dims.begin() + (rank - source_dims.size()));
+    std::vector<int64_t> output_dims(rank);
+    for (size_t i = 0; i < rank; ++i) {
+        output_dims[i] = dims[q[i]];
+    }
+    auto output = CreateTensor(Shape(output_dims), tensor.GetDataType(), DeviceType::CPU);
+    if (!output || !output->GetData()) {
+        return nullptr;
+    }
+    std::vector<int64_t> strides(rank, 1);
+    for (size_t i = rank; i-- > 1;) {
+        strides[i - 1] = strides[i] * dims[i];
+    }
+    const size_t element_size = Tensor::GetDataTypeSize(tensor.GetDataType());
+    const uint8_t* src = static_cast<const uint8_t*>(tensor.GetData());
+    uint8_t* dst = static_cast<uint8_t*>(output->GetData());
+    std::vector<int64_t> index(rank, 0);
+    const int64_t count = output->GetElementCount();
+    for (int64_t n = 0; n < count; ++n) {
+        int64_t offset = 0;
+        for (size_t i = 0; i < rank; ++i) {
+            offset += index[i] * strides[q[i]];
+        }
+        std::memcpy(dst + n * element_size, src + offset * element_size, element_size);
+        for (size_t i = rank; i-- > 0;) {
+            if (++index[i] < output_dims[i]) {
+                break;
+            }
+            index[i] = 0;
+        }
+    }
+    return output;
+}
+
+// 重排元素的代价与大小成正比，只在加载时重排不大的常量（偏置、缩放系数等）
+constexpr int64_t kMaxPermutedConstantElements = 1 << 20;
+
+// 转置下沉（参考ONNX Runtime的TransposeOptimizer）：每次把一个Transpose合并进其输入的Transpose，
+// 或移到它唯一的逐元素使用者之后，直到与另一个Transpose合并抵消、遇到不可交换的算子或到达图输出
+class TransposeSinker {
+public:
+    explicit TransposeSinker(Graph* graph) : graph_(graph) {}
+    
+    // 处理以node为起点的Transpose，返回是否修改了图
+    bool Run(Node* node) {
+        bool changed = false;
+        while (!removed_.count(node) && (MergeWithInput(node) || SinkPastConsumer(node))) {
+            changed = true;
+        }
+        return changed;
+    }
+    
+    bool IsRemoved(Node* node) const { return removed_.count(node) > 0; }
+    int GetNumMerged() const { return merged_; }
+    int GetNumSunk() const { return sunk_; }
+
+private:
+    // Transpose(p2)∘Transpose(p1)合并为一个perm[j] = p1[p2[j]]的Transpose，复合为恒等时整对删除
+    bool MergeWithInput(Node* node) {
+        Value* input = node->GetInputs()[0];
+        Node* inner = input->GetProducer();
+        std::vector<int64_t> perm;
+        std::vector<int64_t> inner_perm;
+        if (!inner || inner->GetOpType() != "Transpose" || inner->GetInputs().empty() ||
+            !GetPermutation(*node, &perm) || !GetPermutation(*inner, &inner_perm) ||
+            inner_perm.size() != perm.size()) {
+            return false;
+        }
+        std::vector<int64_t> composed(perm.size());
+        for (size_t j = 0; j < perm.size(); ++j) {
+            if (perm[j] < 0 || perm[j] >= static_cast<int64_t>(perm.size())) {
+                return false;
+            }
+            composed[j] = inner_perm[perm[j]];
+        }
+        Value* source = inner->GetInputs()[0];
+        if (IsIdentityPermutation(composed)) {
+            if (!RemovePassThrough(graph_, node, source)) {
+                return false;
+            }
+            removed_.insert(node);
+        } else {
+            node->ReplaceInput(input, source);
+            node->SetAttribute("perm", AttributeValue(composed));
+        }
+        Remove(inner);
+        ++merged_;
+        return true;
+    }
+    
+    // Transpose(x) -> E(..) 改写为 E(x, ..) -> Transpose：E的其他输入须是同一perm的Transpose
+    // （改读它的输入）或常量（按逆置换重排，单元素常量不变）
+    bool SinkPastConsumer(Node* node) {
+        Value* transposed = node->GetOutputs()[0];
+        std::vector<int64_t> perm;
+        if (fusion::IsGraphOutput(*graph_, transposed) || transposed->GetConsumers().size() != 1 ||
+            !GetPermutation(*node, &perm)) {
+            return false;
+        }
+        Node* consumer = transposed->GetConsumers()[0];
+        if (!CommutesWithTranspose(consumer->GetOpType()) || consumer->GetOutputs().size() != 1) {
+            return false;
+        }
+        std::vector<int64_t> inverse(perm.size());
+        for (size_t j = 0; j < perm.size(); ++j) {
+            if (perm[j] < 0 || perm[j] >= static_cast<int64_t>(perm.size())) {
+                return false;
+            }
+            inverse[perm[j]] = static_cast<int64_t>(j);
+        }
+        
+        // 先确定每个输入的替换，全部可行后才修改图
+        std::vector<std::pair<Value*, Value*>> replacements;
+        std::vector<Node*> bypassed;
+        for (Value* input : consumer->GetInputs()) {
+            if (input == transposed) {
+                replacements.emplace_back(input, node->GetInputs()[0]);
+                continue;
+            }
+            Node* producer = input->GetProducer();
+            std::vector<int64_t> other_perm;
+            if (producer && producer->GetOpType() == "Transpose" && !producer->GetInputs().empty() &&
+                GetPermutation(*producer, &other_perm) && other_perm == perm) {
+                replacements.emplace_back(input, producer->GetInputs()[0]);
+                bypassed.push_back(producer);
+                continue;
+            }
+            if (!fusion::IsConstant(*graph_, input) || fusion::IsGraphOutput(*graph_, input)) {
+                return false;
+            }
+            const auto& tensor = input->GetTensor();
+            if (!tensor->GetData() || tensor->GetDeviceType() != DeviceType::CPU || !tensor->IsContiguous() ||
+                tensor->GetDataType() == DataType::STRING ||
+                tensor->GetShape().dims.size() > perm.size() ||
+                tensor->GetElementCount() > kMaxPermutedConstantElements) {
+                return false;
+            }
+            if (tensor->GetElementCount() == 1) {
+                continue;
+            }
+            auto permuted = PermuteConstant(*tensor, inverse);
+            if (!permuted) {
+                return false;
+            }
+            Value* constant = graph_->AddValue();
+            constant->SetName(input->GetName() + "_transposed");
+            constant->SetTensor(permuted);
+            replacements.emplace_back(input, constant);
+        }
+        
+        Value* output = consumer->GetOutputs()[0];
+        Value* untransposed = graph_->AddValue();
+        untransposed->SetName(output->GetName() + "_untransposed");
+        const std::vector<Value*> old_inputs = consumer->GetInputs();
+        for (const auto& replacement : replacements) {
+            consumer->ReplaceInput(replacement.first, replacement.second);
+        }
+        consumer->RemoveOutput(output);
+        consumer->AddOutput(untransposed);
+        node->ReplaceInput(node->GetInputs()[0], untransposed);
+        node->RemoveOutput(transposed);
+        node->AddOutput(output);
+        graph_->RemoveValue(transposed);
+        for (Node* other : bypassed) {
+            Remove(other);
+        }
+        RemoveUnusedConstants(graph_, old_inputs);
+        ++sunk_;
+        return true;
+    }
+    
+    // 输出已没有使用者的节点
+    void Remove(Node* node) {
+        for (Value* output : node->GetOutputs()) {
+            if (!output->GetConsumers().empty() || fusion::IsGraphOutput(*graph_, output)) {
+                return;
+            }
+        }
+        RemoveIfDead(graph_, node);
+        removed_.insert(node);
+    }
+    
+    Graph* graph_;
+    std::unordered_set<Node*> removed_;
+    int merged_ = 0;
+    int sunk_ = 0;
+};
+
+} // anonymous namespace
+
+Status CommonSubexpressionEliminationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    const int merged_constants = MergeDuplicateConstants(graph);
+    
+    // 按拓扑序处理：节点的输入在它之前已被替换为代表值，整条重复的链会逐节点合并
+    std::unordered_map<std::string, std::vector<Node*>> representatives;
+    int eliminated = 0;
+    for (Node* node : graph->GetTopologicalOrder()) {
+        if (node->GetOutputs().empty() || IsNondeterministic(node->GetOpType())) {
+            continue;
+        }
+        auto& candidates = representatives[NodeSignature(*node)];
+        Node* match = nullptr;
+        for (Node* candidate : candidates) {
+            if (candidate->GetOpType() == node->GetOpType() && candidate->GetInputs() == node->GetInputs() &&
+                candidate->GetOutputs().size() == node->GetOutputs().size() &&
+                SameAttributes(*candidate, *node)) {
+                match = candidate;
+                break;
+            }
+        }
+        // 重复节点的输出是图输出时保留（两个图输出不能是同一个值）
+        const auto& outputs = node->GetOutputs();
+        const bool keeps_output = std::any_of(outputs.begin(), outputs.end(),
+                                              [&](Value* v) { return fusion::IsGraphOutput(*graph, v); });
+        if (!match || keeps_output) {
+            candidates.push_back(node);
+            continue;
+        }
+        const std::vector<Value*> duplicates = outputs;
+        for (size_t i = 0; i < duplicates.size(); ++i) {
+            const std::vector<Node*> consumers = duplicates[i]->GetConsumers();
+            for (Node* consumer : consumers) {
+                consumer->ReplaceInput(duplicates[i], match->GetOutputs()[i]);
+            }
+        }
+        graph->RemoveNode(node);
+        for (Value* value : duplicates) {
+            graph->RemoveValue(value);
+        }
+        ++eliminated;
+    }
+    
+    if (merged_constants > 0 || eliminated > 0) {
+        LOG_INFO("CSE: merged " + std::to_string(merged_constants) + " constants, eliminated " +
+                 std::to_string(eliminated) + " nodes");
+    }
+    return Status::Ok();
+}
+
+Status IdentityEliminationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    int eliminated = 0;
+    for (Node* node : graph->GetTopologicalOrder()) {
+        Value* source = PassThroughSource(*graph, node);
+        if (!source) {
+            continue;
+        }
+        // 互逆Transpose对：外层被绕过后，内层只在没有其他使用者时删除
+        Node* inner = node->GetOpType() == "Transpose" && source != node->GetInputs()[0]
+            ? node->GetInputs()[0]->GetProducer() : nullptr;
+        if (!RemovePassThrough(graph, node, source)) {
+            continue;
+        }
+        ++eliminated;
+        if (inner) {
+            RemoveIfDead(graph, inner);
+        }
+    }
+    if (eliminated > 0) {
+        LOG_INFO("Identity elimination: removed " + std::to_string(eliminated) + " nodes");
+    }
+    return Status::Ok();
+}
+
+Status TransposeOptimizationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    // 按拓扑序处理：靠前的Transpose先下沉，遇到后面的Transpose时就地合并
+    TransposeSinker sinker(graph);
+    bool changed = false;
+    for (Node* node : graph->GetTopologicalOrder()) {
+        if (node->GetOpType() == "Transpose" && !sinker.IsRemoved(node) &&
+            !node->GetInputs().empty() && node->GetOutputs().size() == 1) {
+            changed = sinker.Run(node) || changed;
+        }
+    }
+    
+    // 新插入的值需要形状，供后续Pass与内存规划使用
+    if (changed) {
+        Status status = InferShapes(graph);
+        (void)status;  // 与会话加载时一样，推断失败只影响内存规划
+        LOG_INFO("Transpose optimization: merged " + std::to_string(sinker.GetNumMerged()) +
+                 " transposes, sunk " + std::to_string(sinker.GetNumSunk()) + " past elementwise ops");
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,345 @@
+// 横向融合Pass实现
+// 同一输入上的多个小GEMM/卷积各自读一遍激活、各自调度一次线程池；合并后激活只读一次，
+// 一个更宽的GEMM更容易分块并行。合并结果沿输出通道切回各分支，切片是视图，不拷贝
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace inferunity {
+
+namespace {
+
+// 连续的FLOAT32常量，rank为0时不限维数
+const Tensor* FloatConstant(const Graph& graph, const Value* value, size_t rank) {
+    if (!fusion::IsConstant(graph, value)) {
+        return nullptr;
+    }
+    const Tensor* tensor = value->GetTensor().get();
+    if (tensor->GetDataType() != DataType::FLOAT32 || !tensor->IsContiguous() ||
+        (rank != 0 && tensor->GetShape().dims.size() != rank)) {
+        return nullptr;
+    }
+    return tensor;
+}
+
+// 沿axis拼接常量，parts[i]为nullptr时该段填零（没有bias的Conv），段宽取widths[i]
+std::shared_ptr<Tensor> ConcatConstants(const std::vector<const Tensor*>& parts, const std::vector<int64_t>& widths,
+                                        const std::vector<int64_t>& dims, size_t axis) {
+    std::vector<int64_t> out_dims = dims;
+    out_dims[axis] = 0;
+    for (int64_t width : widths) {
+        out_dims[axis] += width;
+    }
+    auto result = CreateTensor(Shape(out_dims), DataType::FLOAT32, DeviceType::CPU);
+    size_t outer = 1;
+    for (size_t i = 0; i < axis; ++i) {
+        outer *= static_cast<size_t>(dims[i]);
+    }
+    size_t inner = sizeof(float);
+    for (size_t i = axis + 1; i < dims.size(); ++i) {
+        inner *= static_cast<size_t>(dims[i]);
+    }
+    const size_t out_row = static_cast<size_t>(out_dims[axis]) * inner;
+    uint8_t* dst = static_cast<uint8_t*>(result->GetData());
+    size_t offset = 0;
+    for (size_t p = 0; p < parts.size(); ++p) {
+        const size_t row = static_cast<size_t>(widths[p]) * inner;
+        for (size_t o = 0; o < outer; ++o) {
+            if (parts[p]) {
+                std::memcpy(dst + o * out_row + offset, static_cast<const uint8_t*>(parts[p]->GetData()) + o * row, row);
+            } else {
+                std::memset(dst + o * out_row + offset, 0, row);
+            }
+        }
+        offset += row;
+    }
+    return result;
+}
+
+struct Sibling {
+    Node* node = nullptr;
+    const Tensor* weight = nullptr;
+    const Tensor* bias = nullptr;  // MatMul: 其后Add的常量；Conv: 第三个输入
+    Node* bias_add = nullptr;
+    Node* relu = nullptr;
+    int64_t width = 0;             // 输出通道数
+};
+
+class HorizontalFuser {
+public:
+    explicit HorizontalFuser(Graph* graph) : graph_(graph) {}
+    
+    int Run() {
+        std::vector<Value*> values;
+        for (const auto& value : graph_->GetValues()) {
+            values.push_back(value.get());
+        }
+        for (Value* value : values) {
+            // 分组键：MatMul只有一组；Conv按属性与卷积核形状分组
+            std::map<std::string, std::vector<Sibling>> groups;
+            for (Node* consumer : value->GetConsumers()) {
+                Sibling sibling;
+                if (MatchMatMul(value, consumer, &sibling)) {
+                    AddUnique(&groups["MatMul"], sibling);
+                } else if (MatchConv(value, consumer, &sibling)) {
+                    AddUnique(&groups[ConvKey(*consumer, *sibling.weight)], sibling);
+                }
+            }
+            for (auto& group : groups) {
+                if (group.second.size() < 2) {
+                    continue;
+                }
+                if (group.first == "MatMul" ? FuseMatMuls(value, group.second) : FuseConvs(value, group.second)) {
+                    ++fused_groups_;
+                }
+            }
+        }
+        return fused_groups_;
+    }
+
+private:
+    static void AddUnique(std::vector<Sibling>* group, const Sibling& sibling) {
+        for (const Sibling& existing : *group) {
+            if (existing.node == sibling.node) {
+                return;
+            }
+        }
+        group->push_back(sibling);
+    }
+    
+    bool MatchMatMul(const Value* input, Node* node, Sibling* sibling) const {
+        if (node->GetOpType() != "MatMul" || node->GetInputs().size() != 2 || node->GetOutputs().size() != 1 ||
+            node->GetInputs()[0] != input || node->GetInputs()[1] == input) {
+            return false;
+        }
+        sibling->weight = FloatConstant(*graph_, node->GetInputs()[1], 2);
+        if (!sibling->weight) {
+            return false;
+        }
+        sibling->node = node;
+        sibling->width = sibling->weight->GetShape().dims[1];
+        return sibling->width > 0;
+    }
+    
+    bool MatchConv(const Value* input, Node* node, Sibling* sibling) const {
+        const auto& inputs = node->GetInputs();
+        if (node->GetOpType() != "Conv" || inputs.size() < 2 || inputs.size() > 3 || node->GetOutputs().size() != 1 ||
+            inputs[0] != input || node->GetAttribute("group", "1") != "1") {
+            return false;
+        }
+        sibling->weight = FloatConstant(*graph_, inputs[1], 0);
+        if (!sibling->weight || sibling->weight->GetShape().dims.size() < 3) {
+            return false;
+        }
+        if (inputs.size() == 3) {
+            sibling->bias = FloatConstant(*graph_, inputs[2], 1);
+            if (!sibling->bias) {
+                return false;
+            }
+        }
+        sibling->node = node;
+        sibling->width = sibling->weight->GetShape().dims[0];
+        return sibling->width > 0;
+    }
+    
+    // 输出通道之外的卷积核维度与全部影响输出形状的属性都相同的Conv才能合并
+    static std::string ConvKey(const Node& node, const Tensor& weight) {
+        std::string key = "Conv";
+        const auto& dims = weight.GetShape().dims;
+        for (size_t i = 1; i < dims.size(); ++i) {
+            key += "," + std::to_string(dims[i]);
+        }
+        for (const char* attr : {"kernel_shape", "strides", "pads", "dilations", "auto_pad"}) {
+            key += std::string(";") + attr + "=" + node.GetAttribute(attr);
+        }
+        return key;
+    }
+    
+    // 各分支唯一的使用者都满足match时返回true并由match记录；任一分支不满足时一个也不合并
+    template <typename Match>
+    bool AllSiblings(std::vector<Sibling>& siblings, Match match) const {
+        for (Sibling& sibling : siblings) {
+            Node* consumer = fusion::SoleConsumer(*graph_, sibling.node->GetOutputs()[0]);
+            if (!consumer || consumer->GetOutputs().size() != 1 || !match(consumer, &sibling, false)) {
+                return false;
+            }
+        }
+        for (Sibling& sibling : siblings) {
+            match(fusion::SoleConsumer(*graph_, sibling.node->GetOutputs()[0]), &sibling, true);
+        }
+        return true;
+    }
+    
+    bool FuseMatMuls(Value* input, std::vector<Sibling>& siblings) {
+        const int64_t k = siblings[0].weight->GetShape().dims[0];
+        for (const Sibling& sibling : siblings) {
+            if (sibling.weight->GetShape().dims[0] != k) {
+                return false;
+            }
+        }
+        const bool with_bias = AllSiblings(siblings, [this](Node* add, Sibling* sibling, bool apply) {
+            if (add->GetOpType() != "Add" || add->GetInputs().size() != 2) {
+                return false;
+            }
+            Value* output = sibling->node->GetOutputs()[0];
+            Value* other = add->GetInputs()[0] == output ? add->GetInputs()[1] : add->GetInputs()[0];
+            const Tensor* bias = other != output ? FloatConstant(*graph_, other, 1) : nullptr;
+            if (!bias || bias->GetShape().dims[0] != sibling->width) {
+                return false;
+            }
+            if (apply) {
+                sibling->bias = bias;
+                sibling->bias_add = add;
+            }
+            return true;
+        });
+    
+        std::vector<const Tensor*> weights;
+        std::vector<const Tensor*> biases;
+        std::vector<int64_t> widths;
+        int64_t total = 0;
+        for (const Sibling& sibling : siblings) {
+            weights.push_back(sibling.weight);
+            biases.push_back(sibling.bias);
+            widths.push_back(sibling.width);
+            total += sibling.width;
+        }
+        const Node* first = siblings[0].node;
+        Node* matmul = graph_->AddNode("MatMul", first->GetName() + "_hfused");
+        matmul->AddInput(input);
+        matmul->AddInput(fusion::AddConstant(graph_, ConcatConstants(weights, widths, {k, 0}, 1),
+                                             first->GetInputs()[1]->GetName() + "_hfused"));
+        Value* fused = AddFusedOutput(matmul, first->GetOutputs()[0], -1, total);
+        if (with_bias) {
+            Node* add = graph_->AddNode("Add", siblings[0].bias_add->GetName() + "_hfused");
+            add->AddInput(fused);
+            add->AddInput(fusion::AddConstant(graph_, ConcatConstants(biases, widths, {0}, 0),
+                                              first->GetName() + "_bias_hfused"));
+            fused = AddFusedOutput(add, siblings[0].bias_add->GetOutputs()[0], -1, total);
+        }
+        SplitOutputs(fused, siblings, -1);
+        return true;
+    }
+    
+    bool FuseConvs(Value* input, std::vector<Sibling>& siblings) {
+        AllSiblings(siblings, [](Node* relu, Sibling* sibling, bool apply) {
+            if (relu->GetOpType() != "Relu") {
+                return false;
+            }
+            if (apply) {
+                sibling->relu = relu;
+            }
+            return true;
+        });
+    
+        std::vector<const Tensor*> weights;
+        std::vector<const Tensor*> biases;
+        std::vector<int64_t> widths;
+        int64_t total = 0;
+        bool any_bias = false;
+        for (const Sibling& sibling : siblings) {
+            weights.push_back(sibling.weight);
+            biases.push_back(sibling.bias);
+            widths.push_back(sibling.width);
+            total += sibling.width;
+            any_bias = any_bias || sibling.bias;
+        }
+        const Node* first = siblings[0].node;
+        Node* conv = graph_->AddNode("Conv", first->GetName() + "_hfused");
+        for (const auto& attr : first->GetAttributes()) {
+            conv->SetAttribute(attr.first, attr.second);
+        }
+        conv->AddInput(input);
+        conv->AddInput(fusion::AddConstant(graph_, ConcatConstants(weights, widths, first->GetInputs()[1]->GetShape().dims, 0),
+                                           first->GetInputs()[1]->GetName() + "_hfused"));
+        if (any_bias) {
+            conv->AddInput(fusion::AddConstant(graph_, ConcatConstants(biases, widths, {0}, 0),
+                                               first->GetName() + "_bias_hfused"));
+        }
+        Value* fused = AddFusedOutput(conv, first->GetOutputs()[0], 1, total);
+        if (siblings[0].relu) {
+            Node* relu = graph_->AddNode("Relu", siblings[0].relu->GetName() + "_hfused");
+            relu->AddInput(fused);
+            fused = AddFusedOutput(relu, siblings[0].relu->GetOutputs()[0], 1, total);
+        }
+        SplitOutputs(fused, siblings, 1);
+        return true;
+    }
+    
+    // 合并结果的形状元数据：沿axis为各分支之和（分支形状未知时留给加载时的形状推断）
+    Value* AddFusedOutput(Node* node, const Value* like, int64_t axis, int64_t width) {
+        Value* value = graph_->AddValue();
+        value->SetName(like->GetName() + "_hfused");
+        node->AddOutput(value);
+        auto tensor = like->GetTensor();
+        if (tensor && !tensor->GetShape().dims.empty()) {
+            std::vector<int64_t> dims = tensor->GetShape().dims;
+            const size_t index = axis < 0 ? dims.size() - 1 : static_cast<size_t>(axis);
+            if (index < dims.size()) {
+                dims[index] = width;
+                value->SetTensor(std::make_shared<Tensor>(Shape(dims), tensor->GetDataType(), nullptr));
+            }
+        }
+        return value;
+    }
+    
+    // 各分支最后一个被合并的节点换成从fused切出原输出的Slice，沿用原节点名；合并进来的节点与权重删除
+    void SplitOutputs(Value* fused, const std::vector<Sibling>& siblings, int64_t axis) {
+        int64_t offset = 0;
+        for (const Sibling& sibling : siblings) {
+            Node* last = sibling.relu ? sibling.relu : sibling.bias_add ? sibling.bias_add : sibling.node;
+            Value* output = last->GetOutputs()[0];
+            const std::string name = last->GetName();
+            std::vector<Value*> constants;
+            for (Node* node : {sibling.node, sibling.bias_add, sibling.relu}) {
+                if (!node) {
+                    continue;
+                }
+                for (Value* in : node->GetInputs()) {
+                    if (fusion::IsConstant(*graph_, in)) {
+                        constants.push_back(in);
+                    }
+                }
+                if (node != last) {
+                    Value* intermediate = node->GetOutputs()[0];
+                    graph_->RemoveNode(node);
+                    graph_->RemoveValue(intermediate);
+                }
+            }
+            graph_->RemoveNode(last);
+            for (Value* constant : constants) {
+                if (constant->GetConsumers().empty() && !fusion::IsGraphOutput(*graph_, constant)) {
+                    graph_->RemoveValue(constant);
+                }
+            }
+    
+            Node* slice = graph_->AddNode("Slice", name);
+            slice->SetAttribute("starts", AttributeValue(std::vector<int64_t>{offset}));
+            slice->SetAttribute("ends", AttributeValue(std::vector<int64_t>{offset + sibling.width}));
+            slice->SetAttribute("axes", AttributeValue(std::vector<int64_t>{axis}));
+            slice->AddInput(fused);
+            slice->AddOutput(output);
+            offset += sibling.width;
+        }
+    }
+    
+    Graph* graph_;
+    int fused_groups_ = 0;
+};
+
+} // anonymous namespace
+
+Status HorizontalFusionPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    HorizontalFuser(graph).Run();
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,350 @@
+#include "inferunity/optimizer.h"
+#include "inferunity/logger.h"
+#include "inferunity/tensor.h"
+#include "core/align_utils.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+// 与MemoryPlannerOptions::alignment的默认值一致
+constexpr size_t kAlignment = 64;
+// 精确求解的窗口大小：状态数为2^k
+constexpr size_t kExactWindow = 12;
+// 峰值窗口的精化轮数上限
+constexpr int kMaxRefineRounds = 16;
+
+// 调度模型：节点按初始拓扑序编号，只跟踪静态内存规划会放进arena的张量
+class ScheduleModel {
+public:
+    ScheduleModel(const Graph& graph, const std::vector<Node*>& nodes) : num_nodes_(nodes.size()) {
+        std::unordered_map<const Value*, int> tracked;
+        auto track = [&](const Value* value) -> int {
+            auto it = tracked.find(value);
+            if (it != tracked.end()) {
+                return it->second;
+            }
+            const int id = static_cast<int>(bytes_.size());
+            bytes_.push_back(TrackedBytes(graph, value));
+            producer_.push_back(-1);
+            consumers_.emplace_back();
+            tracked.emplace(value, id);
+            return id;
+        };
+        
+        preds_.resize(num_nodes_);
+        inputs_.resize(num_nodes_);
+        outputs_.resize(num_nodes_);
+        out_bytes_.assign(num_nodes_, 0);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (Value* output : nodes[i]->GetOutputs()) {
+                const int v = track(output);
+                producer_[v] = static_cast<int>(i);
+                outputs_[i].push_back(v);
+                out_bytes_[i] += bytes_[v];
+            }
+        }
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (Value* input : nodes[i]->GetInputs()) {
+                auto it = input ? tracked.find(input) : tracked.end();
+                if (it == tracked.end()) {
+                    continue;  // 图输入或常量
+                }
+                const int v = it->second;
+                if (std::find(inputs_[i].begin(), inputs_[i].end(), v) != inputs_[i].end()) {
+                    continue;
+                }
+                inputs_[i].push_back(v);
+                consumers_[v].push_back(static_cast<int>(i));
+                if (std::find(preds_[i].begin(), preds_[i].end(), producer_[v]) == preds_[i].end()) {
+                    preds_[i].push_back(producer_[v]);
+                }
+            }
+        }
+    }
+    
+    // 每一步执行期间的活跃字节数：输入与新产生的输出同时存活，最后一个使用者执行完后释放
+    std::vector<size_t> Profile(const std::vector<int>& order) const {
+        std::vector<size_t> remaining(bytes_.size());
+        for (size_t v = 0; v < bytes_.size(); ++v) {
+            remaining[v] = consumers_[v].size();
+        }
+        std::vector<size_t> during(order.size());
+        size_t live = 0;
+        for (size_t step = 0; step < order.size(); ++step) {
+            const int node = order[step];
+            live += out_bytes_[node];
+            during[step] = live;
+            for (int v : outputs_[node]) {
+                if (remaining[v] == 0) {
+                    live -= bytes_[v];
+                }
+            }
+            for (int v : inputs_[node]) {
+                if (--remaining[v] == 0) {
+                    live -= bytes_[v];
+                }
+            }
+        }
+        return during;
+    }
+    
+    size_t Peak(const std::vector<int>& order) const {
+        const std::vector<size_t> during = Profile(order);
+        return during.empty() ? 0 : *std::max_element(during.begin(), during.end());
+    }
+    
+    // 列表调度：每次在就绪节点中选运行后活跃内存净增最少的（释放多的优先），相同时保持原有顺序
+    std::vector<int> Greedy() const {
+        std::vector<size_t> remaining(bytes_.size());
+        for (size_t v = 0; v < bytes_.size(); ++v) {
+            remaining[v] = consumers_[v].size();
+        }
+        std::vector<size_t> missing(num_nodes_);
+        std::vector<std::vector<int>> succs(num_nodes_);
+        std::vector<int> ready;
+        for (size_t i = 0; i < num_nodes_; ++i) {
+            missing[i] = preds_[i].size();
+            for (int pred : preds_[i]) {
+                succs[pred].push_back(static_cast<int>(i));
+            }
+            if (missing[i] == 0) {
+                ready.push_back(static_cast<int>(i));
+            }
+        }
+        
+        std::vector<int> order;
+        order.reserve(num_nodes_);
+        while (!ready.empty()) {
+            size_t best = 0;
+            int64_t best_delta = std::numeric_limits<int64_t>::max();
+            for (size_t r = 0; r < ready.size(); ++r) {
+                const int node = ready[r];
+                int64_t delta = static_cast<int64_t>(out_bytes_[node]);
+                for (int v : outputs_[node]) {
+                    if (consumers_[v].empty()) {
+                        delta -= static_cast<int64_t>(bytes_[v]);
+                    }
+                }
+                for (int v : inputs_[node]) {
+                    if (remaining[v] == 1) {
+                        delta -= static_cast<int64_t>(bytes_[v]);
+                    }
+                }
+                if (delta < best_delta || (delta == best_delta && node < ready[best])) {
+                    best = r;
+                    best_delta = delta;
+                }
+            }
+            const int node = ready[best];
+            ready.erase(ready.begin() + best);
+            order.push_back(node);
+            for (int v : inputs_[node]) {
+                --remaining[v];
+            }
+            for (int succ : succs[node]) {
+                if (--missing[succ] == 0) {
+                    ready.push_back(succ);
+                }
+            }
+        }
+        return order;
+    }
+    
+    // 反复把峰值所在的窗口换成窗口内的最优排列。窗口执行完后的活跃集合与排列无关，
+    // 各窗口可以独立求解，全局峰值不会变大
+    void Refine(std::vector<int>* order) const {
+        for (int round = 0; round < kMaxRefineRounds; ++round) {
+            const size_t peak = Peak(*order);
+            bool improved = false;
+            for (size_t start : {size_t(0), kExactWindow / 2}) {
+                const std::vector<size_t> during = Profile(*order);
+                for (size_t begin = start; begin < order->size(); begin += kExactWindow) {
+                    const size_t end = std::min(begin + kExactWindow, order->size());
+                    if (*std::max_element(during.begin() + begin, during.begin() + end) == peak) {
+                        improved = SolveWindow(order, begin, end, during) || improved;
+                    }
+                }
+            }
+            if (!improved || Peak(*order) >= peak) {
+                break;
+            }
+        }
+    }
+
+private:
+    static size_t TrackedBytes(const Graph& graph, const Value* value) {
+        const auto& outputs = graph.GetOutputs();
+        if (std::find(outputs.begin(), outputs.end(), value) != outputs.end()) {
+            return 0;  // 图输出不进入arena
+        }
+        auto tensor = value->GetTensor();
+        if (!tensor || tensor->GetDeviceType() != DeviceType::CPU || tensor->GetShape().IsDynamic()) {
+            return 0;
+        }
+        const size_t bytes = static_cast<size_t>(tensor->GetShape().GetElementCount()) *
+                             GetDataTypeSize(tensor->GetDataType());
+        return AlignUp(bytes, kAlignment);
+    }
+    
+    // 状态压缩DP：状态为窗口内已执行的节点集合（对窗口内依赖封闭），活跃内存只由集合决定；
+    // best[S]为到达S的最小峰值。找到比当前排列更低的峰值时写回并返回true
+    bool SolveWindow(std::vector<int>* order, size_t begin, size_t end,
+                     const std::vector<size_t>& during) const {
+        const size_t k = end - begin;
+        if (k < 2) {
+            return false;
+        }
+        std::vector<int> position(num_nodes_, -1);
+        for (size_t i = 0; i < order->size(); ++i) {
+            position[(*order)[i]] = static_cast<int>(i);
+        }
+        std::vector<uint32_t> pred_mask(k, 0);
+        // 在窗口内释放的张量：候选为各节点的输入与输出，窗口之后不再使用
+        struct Release {
+            size_t bytes;
+            uint32_t consumers;  // 窗口内的使用者
+        };
+        std::vector<std::vector<Release>> releases(k);
+        for (size_t i = 0; i < k; ++i) {
+            const int node = (*order)[begin + i];
+            for (int pred : preds_[node]) {
+                const int p = position[pred];
+                if (p >= static_cast<int>(begin)) {
+                    pred_mask[i] |= 1u << (p - begin);
+                }
+            }
+            auto add_release = [&](int v) {
+                if (bytes_[v] == 0) {
+                    return;
+                }
+                uint32_t mask = 0;
+                for (int consumer : consumers_[v]) {
+                    const int p = position[consumer];
+                    if (p >= static_cast<int>(end)) {
+                        return;
+                    }
+                    if (p >= static_cast<int>(begin)) {
+                        mask |= 1u << (p - begin);
+                    }
+                }
+                releases[i].push_back({bytes_[v], mask});
+            };
+            for (int v : outputs_[node]) {
+                if (consumers_[v].empty()) {
+                    add_release(v);
+                }
+            }
+            for (int v : inputs_[node]) {
+                add_release(v);
+            }
+        }
+        
+        // 活跃内存相对窗口开始时的值
+        const size_t base = during[begin] - out_bytes_[(*order)[begin]];
+        const size_t num_states = size_t(1) << k;
+        const int64_t kUnvisited = std::numeric_limits<int64_t>::max();
+        std::vector<int64_t> best(num_states, kUnvisited);
+        std::vector<int64_t> live(num_states, 0);
+        std::vector<int8_t> last(num_states, -1);
+        best[0] = 0;
+        for (size_t state = 0; state < num_states; ++state) {
+            if (best[state] == kUnvisited) {
+                continue;
+            }
+            for (size_t i = 0; i < k; ++i) {
+                const uint32_t bit = 1u << i;
+                if ((state & bit) || (pred_mask[i] & ~state)) {
+                    continue;
+                }
+                const int node = (*order)[begin + i];
+                const int64_t running = live[state] + static_cast<int64_t>(out_bytes_[node]);
+                const int64_t peak = std::max(best[state], running);
+                const size_t next = state | bit;
+                if (best[next] == kUnvisited) {
+                    int64_t after = running;
+                    for (const Release& release : releases[i]) {
+                        if ((release.consumers & ~next) == 0) {
+                            after -= static_cast<int64_t>(release.bytes);
+                        }
+                    }
+                    live[next] = after;
+                }
+                if (peak < best[next]) {
+                    best[next] = peak;
+                    last[next] = static_cast<int8_t>(i);
+                }
+            }
+        }
+        
+        const size_t full = num_states - 1;
+        const size_t current = *std::max_element(during.begin() + begin, during.begin() + end);
+        if (base + static_cast<size_t>(best[full]) >= current) {
+            return false;
+        }
+        std::vector<int> window(k);
+        for (size_t state = full, slot = k; state != 0; ) {
+            const int i = last[state];
+            window[--slot] = (*order)[begin + i];
+            state &= ~(size_t(1) << i);
+        }
+        std::copy(window.begin(), window.end(), order->begin() + begin);
+        return true;
+    }
+    
+    size_t num_nodes_;
+    std::vector<size_t> bytes_;
+    std::vector<int> producer_;
+    std::vector<std::vector<int>> consumers_;
+    std::vector<std::vector<int>> preds_;
+    std::vector<std::vector<int>> inputs_;
+    std::vector<std::vector<int>> outputs_;
+    std::vector<size_t> out_bytes_;
+};
+
+} // anonymous namespace
+
+Status MemoryAwareSchedulingPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    const std::vector<Node*> nodes = graph->TopologicalSort();
+    if (nodes.size() != graph->GetNodes().size() || nodes.size() < 2) {
+        return Status::Ok();  // 有环的图由Validate报告
+    }
+    
+    ScheduleModel model(*graph, nodes);
+    std::vector<int> order(nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    const size_t original_peak = model.Peak(order);
+    std::vector<int> greedy = model.Greedy();
+    if (greedy.size() == order.size() && model.Peak(greedy) < original_peak) {
+        order = std::move(greedy);
+    }
+    model.Refine(&order);
+    const size_t peak = model.Peak(order);
+    if (peak >= original_peak) {
+        return Status::Ok();
+    }
+    
+    std::vector<Node*> scheduled;
+    scheduled.reserve(order.size());
+    for (int index : order) {
+        scheduled.push_back(nodes[index]);
+    }
+    Status status = graph->ReorderNodes(scheduled);
+    if (!status.IsOk()) {
+        return status;
+    }
+    LOG_INFO("Memory-aware scheduling: peak activation bytes " + std::to_string(original_peak) +
+             " -> " + std::to_string(peak));
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,91 @@
+// 混合精度Pass实现
+// 参考ONNX Runtime的convert_float_to_float16（keep_io_types、op_block_list）：只改写权重的存储精度，
+// 图的输入输出与所有激活仍为FP32，因此LayerNorm/Softmax的均值、方差与指数和都以FP32累加
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "inferunity/float16.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+
+namespace inferunity {
+
+namespace {
+
+// 权重作为B（输入1）直接读取半精度的算子
+bool IsHalfWeightConsumer(const Node* node, const Value* value) {
+    const std::string& type = node->GetOpType();
+    if (type != "MatMul" && type != "FusedMatMulAdd") {
+        return false;
+    }
+    const auto& inputs = node->GetInputs();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i] == value && i != 1) {
+            return false;
+        }
+    }
+    return inputs.size() > 1 && inputs[1] == value;
+}
+
+std::shared_ptr<Tensor> ConvertWeight(const Tensor& weight, DataType dtype) {
+    auto converted = CreateTensor(weight.GetShape(), dtype, DeviceType::CPU);
+    const float* src = static_cast<const float*>(weight.GetData());
+    uint16_t* dst = static_cast<uint16_t*>(converted->GetData());
+    const size_t count = weight.GetElementCount();
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = dtype == DataType::BFLOAT16 ? FloatToBFloat16(src[i]) : FloatToHalf(src[i]);
+    }
+    return converted;
+}
+
+} // anonymous namespace
+
+Status MixedPrecisionPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    if (weight_dtype_ != DataType::FLOAT16 && weight_dtype_ != DataType::BFLOAT16) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "MixedPrecision weight type must be FLOAT16 or BFLOAT16");
+    }
+    
+    for (const auto& node : graph->GetNodes()) {
+        const std::string& type = node->GetOpType();
+        if ((type != "MatMul" && type != "FusedMatMulAdd") || node->GetInputs().size() < 2) {
+            continue;
+        }
+        if (!node_names_.empty() &&
+            std::find(node_names_.begin(), node_names_.end(), node->GetName()) == node_names_.end()) {
+            continue;
+        }
+        Value* weight = node->GetInputs()[1];
+        if (!fusion::IsConstant(*graph, weight)) {
+            continue;
+        }
+        auto tensor = weight->GetTensor();
+        if (tensor->GetDataType() == DataType::FLOAT32) {
+            const auto& outputs = graph->GetOutputs();
+            if (tensor->GetShape().dims.size() != 2 ||
+                std::find(outputs.begin(), outputs.end(), weight) != outputs.end()) {
+                continue;
+            }
+            bool all_half_consumers = true;
+            for (const Node* consumer : weight->GetConsumers()) {
+                all_half_consumers = all_half_consumers && IsHalfWeightConsumer(consumer, weight);
+            }
+            if (!all_half_consumers) {
+                continue;
+            }
+            weight->SetTensor(ConvertWeight(*tensor, weight_dtype_));
+        } else if (tensor->GetDataType() != weight_dtype_) {
+            continue;
+        }
+        if (bf16_compute_) {
+            node->SetAttribute("compute_precision", "bf16");
+        }
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -1,109 +1,21 @@
 // 算子融合Pass实现
-// 参考TVM的算子融合实现
+// 参考TVM的算子融合与ONNX Runtime的GraphTransformer：融合规则由声明式模式（fusion_pattern.h）
+// 和改写函数组成，按阶段应用到不动点
 
 #include "inferunity/optimizer.h"
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
+#include "fusion_pattern.h"
 #include <algorithm>
+#include <sstream>
 #include <unordered_set>
 
 namespace inferunity {
 
-Status OperatorFusionPass::Run(Graph* graph) {
-    if (!graph) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
-    }
-    
-    bool changed = true;
-    int max_iterations = 10;  // 防止无限循环
-    int iteration = 0;
-    
-    while (changed && iteration < max_iterations) {
-        changed = false;
-        iteration++;
-        
-        // 获取拓扑排序的节点列表
-        std::vector<Node*> nodes = graph->TopologicalSort();
-        
-        // 查找融合模式
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            Node* node1 = nodes[i];
-            if (!node1 || node1->GetOutputs().empty()) continue;
-            
-            // 检查Conv+BN+ReLU模式
-            if (node1->GetOpType() == "Conv") {
-                Value* output1 = node1->GetOutputs()[0];
-                if (!output1->GetConsumers().empty()) {
-                    Node* node2 = output1->GetConsumers()[0];
-                    if (node2 && node2->GetOpType() == "BatchNormalization" &&
-                        !node2->GetOutputs().empty()) {
-                        Value* output2 = node2->GetOutputs()[0];
-                        if (!output2->GetConsumers().empty()) {
-                            Node* node3 = output2->GetConsumers()[0];
-                            if (node3 && node3->GetOpType() == "Relu") {
-                                // 找到Conv+BN+ReLU模式，执行融合
-                                if (CanFuseConvBNReLU(node1, node2, node3)) {
-                                    Status status = FuseConvBNReLU(graph, node1, node2, node3);
-                                    if (status.IsOk()) {
-                                        changed = true;
-                                        break;  // 重新开始遍历
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // 检查Conv+ReLU模式（简化融合）
-                    else if (node2 && node2->GetOpType() == "Relu") {
-                        if (CanFuseConvReLU(node1, node2)) {
-                            Status status = FuseConvReLU(graph, node1, node2);
-                            if (status.IsOk()) {
-                                changed = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            // 检查BN+ReLU模式
-            if (node1->GetOpType() == "BatchNormalization") {
-                Value* output1 = node1->GetOutputs()[0];
-                if (!output1->GetConsumers().empty()) {
-                    Node* node2 = output1->GetConsumers()[0];
-                    if (node2 && node2->GetOpType() == "Relu") {
-                        if (CanFuseBNReLU(node1, node2)) {
-                            Status status = FuseBNReLU(graph, node1, node2);
-                            if (status.IsOk()) {
-                                changed = true;
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            // 检查MatMul+Add模式
-            if (node1->GetOpType() == "MatMul") {
-                Value* output1 = node1->GetOutputs()[0];
-                if (!output1->GetConsumers().empty()) {
-                    Node* node2 = output1->GetConsumers()[0];
-                    if (node2 && node2->GetOpType() == "Add") {
-                        // 找到MatMul+Add模式，执行融合
-                        if (CanFuseMatMulAdd(node1, node2)) {
-                            Status status = FuseMatMulAdd(graph, node1, node2);
-                            if (status.IsOk()) {
-                                changed = true;
-                                break;  // 重新开始遍历
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    return Status::Ok();
-}
+using fusion::FusionRule;
+using fusion::Match;
+using fusion::Pattern;
+using fusion::kAnyInputSlot;
 
 bool OperatorFusionPass::CanFuseConvBNReLU(Node* conv, Node* bn, Node* relu) const {
     if (!conv || !bn || !relu) return false;
@@ -127,12 +39,71 @@ bool OperatorFusionPass::CanFuseMatMulAdd(Node* matmul, Node* add) const {
     
     // 检查数据流连接
     if (matmul->GetOutputs().empty() || add->GetInputs().size() < 2) return false;
-    if (matmul->GetOutputs()[0] != add->GetInputs()[0] && 
+    if (matmul->GetOutputs()[0] != add->GetInputs()[0] &&
         matmul->GetOutputs()[0] != add->GetInputs()[1]) return false;
     
     return true;
 }
 
+namespace {
+
+// Transpose的perm属性；未指定时按ONNX语义为维度反转
+bool ParsePerm(const Node* transpose, std::vector<int64_t>* perm) {
+    const AttributeValue* attr = transpose->FindAttribute("perm");
+    perm->clear();
+    if (!attr) {
+        const auto& inputs = transpose->GetInputs();
+        if (inputs.empty() || inputs[0]->GetShape().dims.size() != 2) {
+            return false;  // 秩未知时无法判断默认perm
+        }
+        *perm = {1, 0};
+        return true;
+    }
+    if (attr->GetType() == AttributeValue::Type::INTS) {
+        *perm = attr->GetInts();
+    } else if (attr->GetType() == AttributeValue::Type::INT) {
+        *perm = {attr->GetInt()};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// perm只交换最后两维（其余维度保持原位）
+bool IsLastTwoAxesSwap(const std::vector<int64_t>& perm) {
+    const size_t rank = perm.size();
+    if (rank < 2) return false;
+    for (size_t i = 0; i + 2 < rank; ++i) {
+        if (perm[i] != static_cast<int64_t>(i)) return false;
+    }
+    return perm[rank - 2] == static_cast<int64_t>(rank - 1) &&
+           perm[rank - 1] == static_cast<int64_t>(rank - 2);
+}
+
+} // anonymous namespace
+
+bool OperatorFusionPass::CanFoldTransposeIntoMatMul(Node* transpose, Node* matmul) const {
+    if (!transpose || !matmul) return false;
+    if (transpose->GetOpType() != "Transpose") return false;
+    if (matmul->GetOpType() != "MatMul" && matmul->GetOpType() != "FusedMatMulAdd") return false;
+    if (transpose->GetInputs().size() != 1 || transpose->GetOutputs().size() != 1) return false;
+    
+    // Transpose的结果只被这一个MatMul使用
+    Value* transposed = transpose->GetOutputs()[0];
+    if (transposed->GetConsumers().size() != 1 || transposed->GetConsumers()[0] != matmul) {
+        return false;
+    }
+    
+    const auto& inputs = matmul->GetInputs();
+    if (inputs.size() < 2 || (inputs[0] != transposed && inputs[1] != transposed)) return false;
+    // A与B为同一值时（如X * X^T），折叠后输入会重复，Node不支持重复输入
+    Value* source = transpose->GetInputs()[0];
+    if (std::find(inputs.begin(), inputs.end(), source) != inputs.end()) return false;
+    
+    std::vector<int64_t> perm;
+    return ParsePerm(transpose, &perm) && IsLastTwoAxesSwap(perm);
+}
+
 bool OperatorFusionPass::CanFuseConvReLU(Node* conv, Node* relu) const {
     if (!conv || !relu) return false;
     if (conv->GetOpType() != "Conv") return false;
@@ -157,198 +128,1059 @@ bool OperatorFusionPass::CanFuseBNReLU(Node* bn, Node* relu) const {
     return true;
 }
 
-Status OperatorFusionPass::FuseConvBNReLU(Graph* graph, Node* conv, Node* bn, Node* relu) {
-    if (!graph || !conv || !bn || !relu) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid nodes");
-    }
-    
-    // 1. 创建融合节点
-    std::string fused_name = conv->GetName() + "_" + bn->GetName() + "_" + relu->GetName() + "_fused";
-    Node* fused_node = graph->AddNode("FusedConvBNReLU", fused_name);
+namespace {
+
+Status RewriteFailed(const std::string& pattern) {
+    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, pattern + " rewrite not applicable");
+}
+
+Status Replace(Graph* graph, const Match& match, const std::string& op_type,
+               const std::vector<Value*>& inputs, const NodeAttributes& attributes) {
+    return fusion::ReplaceMatch(graph, match, op_type, inputs, attributes) ? Status::Ok()
+                                                                           : RewriteFailed(op_type);
+}
+
+std::vector<Value*> Concat(std::vector<Value*> head, const std::vector<Value*>& tail) {
+    head.insert(head.end(), tail.begin(), tail.end());
+    return head;
+}
+
+bool IsScalarConstant(const Graph& graph, const Value* value, float expected) {
+    float scalar = 0.0f;
+    return fusion::GetScalarConstant(graph, value, &scalar) && scalar == expected;
+}
+
+bool SameKnownShape(const Value* a, const Value* b) {
+    return fusion::HasKnownShape(a) && fusion::HasKnownShape(b) &&
+           a->GetShape().dims == b->GetShape().dims;
+}
+
+// ---- 阶段1：分解子图还原 ----
+
+// Transpose(交换最后两维) -> MatMul：原地改写MatMul的transA/transB
+Status FoldTransposeIntoMatMul(Graph* graph, const Match& match) {
+    Node* matmul = match.nodes[0];
+    Node* transpose = match.nodes[1];
+    Value* transposed = transpose->GetOutputs()[0];
+    Value* source = transpose->GetInputs()[0];
     
-    // 2. 合并属性（从Conv节点复制）
-    for (const auto& attr : conv->GetAttributes()) {
-        fused_node->SetAttribute(attr.first, attr.second);
+    // 按原顺序重建MatMul的输入，用Transpose的输入替换其输出
+    std::vector<Value*> inputs = matmul->GetInputs();
+    const bool is_a = inputs[0] == transposed;
+    for (Value* input : inputs) {
+        matmul->RemoveInput(input);
     }
-    
-    // 3. 连接输入
-    // Conv的输入：input, weight, bias(可选)
-    // BN的输入：conv_output, scale, B, mean, var
-    // 融合后的输入：input, weight, bias(可选), scale, B, mean, var
-    for (Value* input : conv->GetInputs()) {
-        fused_node->AddInput(input);
-    }
-    // 添加BN的输入（跳过第一个，因为它是conv的输出）
-    const auto& bn_inputs = bn->GetInputs();
-    for (size_t i = 1; i < bn_inputs.size(); ++i) {
-        fused_node->AddInput(bn_inputs[i]);
+    for (Value* input : inputs) {
+        matmul->AddInput(input == transposed ? source : input);
     }
     
-    // 4. 连接输出（使用ReLU的输出）
-    Value* relu_output = relu->GetOutputs()[0];
-    fused_node->AddOutput(relu_output);
-    
-    // 5. 更新输出值的生产者
-    relu_output->SetProducer(fused_node);
-    
-    // 6. 删除原节点（按逆序删除，避免依赖问题）
-    graph->RemoveNode(relu);
-    graph->RemoveNode(bn);
-    graph->RemoveNode(conv);
+    // 翻转对应的转置标记（MatMul可能已经带有transA/transB）
+    const std::string key = is_a ? "transA" : "transB";
+    const bool trans = matmul->GetAttribute(key, "0") != "0";
+    matmul->SetAttribute(key, trans ? "0" : "1");
     
+    graph->RemoveNode(transpose);
+    graph->RemoveValue(transposed);
     return Status::Ok();
 }
 
-Status OperatorFusionPass::FuseMatMulAdd(Graph* graph, Node* matmul, Node* add) {
-    if (!graph || !matmul || !add) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid nodes");
+// ReduceMean沿最后一维且保留维度（keepdims默认1）
+std::function<bool(const Node&)> ReducesLastAxis() {
+    return [](const Node& node) {
+        if (node.GetAttribute("keepdims", "1") == "0") {
+            return false;
+        }
+        const std::string axes = node.GetAttribute("axes");
+        if (axes == "-1") {
+            return true;
+        }
+        const Value* x = node.GetInputs()[0];
+        return fusion::HasKnownShape(x) && !x->GetShape().dims.empty() &&
+               axes == std::to_string(x->GetShape().dims.size() - 1);
+    };
+}
+
+// LayerNorm/RMSNorm的逐元素参数：常量，长度等于最后一维（形状未知时要求为1维）
+bool IsNormParameter(const Graph& graph, const Value* param, const Value* x) {
+    if (!fusion::IsConstant(graph, param) || param->GetDataType() != DataType::FLOAT32) {
+        return false;
     }
-    
-    // 1. 创建融合节点
-    std::string fused_name = matmul->GetName() + "_" + add->GetName() + "_fused";
-    Node* fused_node = graph->AddNode("FusedMatMulAdd", fused_name);
-    
-    // 2. 合并属性（从MatMul节点复制）
-    for (const auto& attr : matmul->GetAttributes()) {
-        fused_node->SetAttribute(attr.first, attr.second);
+    if (fusion::HasKnownShape(x) && !x->GetShape().dims.empty()) {
+        return param->GetTensor()->GetElementCount() ==
+               static_cast<size_t>(x->GetShape().dims.back());
     }
-    
-    // 3. 连接输入
-    // MatMul的输入：A, B
-    // Add的输入：matmul_output, bias
-    // 融合后的输入：A, B, bias
-    for (Value* input : matmul->GetInputs()) {
-        fused_node->AddInput(input);
-    }
-    // 找到Add的另一个输入（bias）
-    const auto& add_inputs = add->GetInputs();
-    Value* matmul_output = matmul->GetOutputs()[0];
-    for (Value* input : add_inputs) {
-        if (input != matmul_output) {
-            fused_node->AddInput(input);  // 这是bias
-            break;
+    return param->GetShape().dims.size() == 1;
+}
+
+// y = (x - mean(x)) / sqrt(mean((x - mean(x))^2) + eps) * gamma + beta
+// 节点：0 Add(beta) 1 Mul(gamma) 2 Div 3 Sub 4 Sqrt 5 ReduceMean(x) 6 Add(eps) 7 ReduceMean 8 Pow
+FusionRule LayerNormRule() {
+    FusionRule rule;
+    rule.pattern.name = "LayerNormalization";
+    rule.pattern.nodes = {
+        {{"Add"}, 2, {{kAnyInputSlot, 1}}, nullptr},
+        {{"Mul"}, 2, {{kAnyInputSlot, 2}}, nullptr},
+        {{"Div"}, 2, {{0, 3}, {1, 4}}, nullptr},
+        {{"Sub"}, 2, {{1, 5}}, nullptr},
+        {{"Sqrt"}, 1, {{0, 6}}, nullptr},
+        {{"ReduceMean"}, 1, {}, ReducesLastAxis()},
+        {{"Add"}, 2, {{kAnyInputSlot, 7}}, nullptr},
+        {{"ReduceMean"}, 1, {{0, 8}}, ReducesLastAxis()},
+        {{"Pow"}, 2, {{0, 3}}, nullptr},
+    };
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        Value* x = m.Input(3, 0);
+        float eps = 0.0f;
+        return m.Input(5, 0) == x &&
+               IsScalarConstant(graph, m.Input(8, 1), 2.0f) &&
+               fusion::GetScalarConstant(graph, m.OtherInput(6, 7), &eps) &&
+               IsNormParameter(graph, m.OtherInput(1, 2), x) &&
+               IsNormParameter(graph, m.OtherInput(0, 1), x);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        float eps = 0.0f;
+        fusion::GetScalarConstant(*graph, m.OtherInput(6, 7), &eps);
+        NodeAttributes attrs = {{"axis", AttributeValue(int64_t(-1))}, {"epsilon", AttributeValue(eps)}};
+        return Replace(graph, m, "LayerNormalization",
+                       {m.Input(3, 0), m.OtherInput(1, 2), m.OtherInput(0, 1)}, attrs);
+    };
+    return rule;
+}
+
+// RMSNorm的分母：sqrt(mean(x^2) + eps)，节点从first开始依次为Sqrt、Add(eps)、ReduceMean、Pow
+void AppendRmsDenominator(Pattern* pattern) {
+    const int first = static_cast<int>(pattern->nodes.size());
+    pattern->nodes.push_back({{"Sqrt"}, 1, {{0, first + 1}}, nullptr});
+    pattern->nodes.push_back({{"Add"}, 2, {{kAnyInputSlot, first + 2}}, nullptr});
+    pattern->nodes.push_back({{"ReduceMean"}, 1, {{0, first + 3}}, ReducesLastAxis()});
+    pattern->nodes.push_back({{"Pow"}, 2, {}, nullptr});
+}
+
+bool RmsDenominatorOf(const Graph& graph, const Match& m, int first, const Value* x, float* eps) {
+    return m.Input(first + 3, 0) == x && IsScalarConstant(graph, m.Input(first + 3, 1), 2.0f) &&
+           fusion::GetScalarConstant(graph, m.OtherInput(first + 1, first + 2), eps);
+}
+
+// y = x / sqrt(mean(x^2) + eps) * gamma
+// 节点：0 Mul(gamma) 1 Div 2.. 分母
+FusionRule RmsNormDivRule() {
+    FusionRule rule;
+    rule.pattern.name = "RMSNorm";
+    rule.pattern.nodes = {
+        {{"Mul"}, 2, {{kAnyInputSlot, 1}}, nullptr},
+        {{"Div"}, 2, {{1, 2}}, nullptr},
+    };
+    AppendRmsDenominator(&rule.pattern);
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        float eps = 0.0f;
+        Value* x = m.Input(1, 0);
+        return RmsDenominatorOf(graph, m, 2, x, &eps) && IsNormParameter(graph, m.OtherInput(0, 1), x);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        float eps = 0.0f;
+        RmsDenominatorOf(*graph, m, 2, m.Input(1, 0), &eps);
+        return Replace(graph, m, "RMSNorm", {m.Input(1, 0), m.OtherInput(0, 1)},
+                       {{"epsilon", AttributeValue(eps)}});
+    };
+    return rule;
+}
+
+// y = x * reciprocal(sqrt(mean(x^2) + eps)) * gamma（LLaMA等模型的导出形式）
+// 节点：0 Mul(gamma) 1 Mul(x) 2 Reciprocal 3.. 分母
+FusionRule RmsNormReciprocalRule() {
+    FusionRule rule;
+    rule.pattern.name = "RMSNorm";
+    rule.pattern.nodes = {
+        {{"Mul"}, 2, {{kAnyInputSlot, 1}}, nullptr},
+        {{"Mul"}, 2, {{kAnyInputSlot, 2}}, nullptr},
+        {{"Reciprocal"}, 1, {{0, 3}}, nullptr},
+    };
+    AppendRmsDenominator(&rule.pattern);
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        float eps = 0.0f;
+        Value* x = m.OtherInput(1, 2);
+        return RmsDenominatorOf(graph, m, 3, x, &eps) && IsNormParameter(graph, m.OtherInput(0, 1), x);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        float eps = 0.0f;
+        RmsDenominatorOf(*graph, m, 3, m.OtherInput(1, 2), &eps);
+        return Replace(graph, m, "RMSNorm", {m.OtherInput(1, 2), m.OtherInput(0, 1)},
+                       {{"epsilon", AttributeValue(eps)}});
+    };
+    return rule;
+}
+
+// 残差相加 -> LayerNormalization/RMSNorm：Add(a, b)的输出通常还是下一层的残差（有其他消费者），
+// 不满足模式匹配的单消费者约束，因此单独改写：归一化节点改为AddLayerNorm/AddRMSNorm，
+// 和有其他消费者或是图输出时作为它的第二个输出，否则删除。要求a、b形状相同（不做广播）
+int FuseResidualNormalization(Graph* graph) {
+    int fused = 0;
+    for (Node* norm : graph->TopologicalSort()) {
+        const std::string& type = norm->GetOpType();
+        if ((type != "LayerNormalization" && type != "RMSNorm") || norm->GetOutputs().size() != 1 ||
+            norm->GetInputs().size() < 2) {
+            continue;
+        }
+        Value* sum = norm->GetInputs()[0];
+        Node* add = sum->GetProducer();
+        if (!add || add->GetOpType() != "Add" || add->GetInputs().size() != 2 || add->GetOutputs().size() != 1) {
+            continue;
+        }
+        Value* a = add->GetInputs()[0];
+        Value* b = add->GetInputs()[1];
+        const std::vector<Value*> params(norm->GetInputs().begin() + 1, norm->GetInputs().end());
+        if (a == b || !SameKnownShape(a, b) || a->GetDataType() != DataType::FLOAT32 ||
+            std::find(params.begin(), params.end(), sum) != params.end()) {
+            continue;
+        }
+        const auto& graph_outputs = graph->GetOutputs();
+        const bool keep_sum = sum->GetConsumers().size() > 1 ||
+                              std::find(graph_outputs.begin(), graph_outputs.end(), sum) != graph_outputs.end();
+        
+        // 先删除原节点，改写后的节点沿用它的名称
+        const std::string name = norm->GetName();
+        const std::string fused_type = type == "RMSNorm" ? "AddRMSNorm" : "AddLayerNorm";
+        const NodeAttributes attributes = norm->GetAttributes();
+        Value* y = norm->GetOutputs()[0];
+        norm->RemoveOutput(y);
+        graph->RemoveNode(norm);
+        Node* fused_node = graph->AddNode(fused_type, name);
+        for (const auto& attr : attributes) {
+            fused_node->SetAttribute(attr.first, attr.second);
         }
+        fused_node->AddInput(a);
+        fused_node->AddInput(b);
+        for (Value* param : params) {
+            fused_node->AddInput(param);
+        }
+        fused_node->AddOutput(y);
+        add->RemoveOutput(sum);
+        graph->RemoveNode(add);
+        if (keep_sum) {
+            fused_node->AddOutput(sum);
+        } else {
+            graph->RemoveValue(sum);
+        }
+        ++fused;
     }
-    
-    // 4. 连接输出（使用Add的输出）
-    Value* add_output = add->GetOutputs()[0];
-    fused_node->AddOutput(add_output);
-    
-    // 5. 更新输出值的生产者
-    add_output->SetProducer(fused_node);
-    
-    // 6. 删除原节点
-    graph->RemoveNode(add);
-    graph->RemoveNode(matmul);
-    
-    return Status::Ok();
+    return fused;
 }
 
-Status OperatorFusionPass::FuseConvReLU(Graph* graph, Node* conv, Node* relu) {
-    if (!graph || !conv || !relu) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid nodes");
+// x * sigmoid(x) -> Silu
+FusionRule SiluRule() {
+    FusionRule rule;
+    rule.pattern.name = "Silu";
+    rule.pattern.nodes = {
+        {{"Mul"}, 2, {{kAnyInputSlot, 1}}, nullptr},
+        {{"Sigmoid"}, 1, {}, nullptr},
+    };
+    rule.pattern.constraint = [](const Graph&, const Match& m) {
+        return m.OtherInput(0, 1) == m.Input(1, 0);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        return Replace(graph, m, "Silu", {m.Input(1, 0)}, {});
+    };
+    return rule;
+}
+
+// Softmax沿最后一维
+bool IsLastAxisSoftmax(const Node& node) {
+    const std::string axis = node.GetAttribute("axis", "-1");
+    if (axis == "-1") {
+        return true;
     }
-    
-    // 创建融合节点（使用FusedConvBNReLU，但BN参数设为单位值）
-    std::string fused_name = conv->GetName() + "_" + relu->GetName() + "_fused";
-    Node* fused_node = graph->AddNode("FusedConvBNReLU", fused_name);
-    
-    // 合并属性
-    for (const auto& attr : conv->GetAttributes()) {
-        fused_node->SetAttribute(attr.first, attr.second);
+    const Value* x = node.GetInputs()[0];
+    return fusion::HasKnownShape(x) && axis == std::to_string(x->GetShape().dims.size() - 1);
+}
+
+// 只要求秩已知：KV cache的past长度等维度可以是动态的（-1）
+bool IsAttentionOperand(const Value* value) {
+    if (!value || value->GetDataType() != DataType::FLOAT32) {
+        return false;
     }
-    
-    // 连接输入（Conv的输入 + 单位BN参数）
-    for (Value* input : conv->GetInputs()) {
-        fused_node->AddInput(input);
+    const size_t rank = value->GetShape().dims.size();
+    return rank == 3 || rank == 4;
+}
+
+// 加性mask：FLOAT32，形状未知或可右对齐广播到scores
+bool IsAttentionMask(const Value* mask, const Value* scores) {
+    if (!mask || mask->GetDataType() != DataType::FLOAT32) {
+        return false;
     }
-    
-    // 创建单位BN参数值（scale=1, B=0, mean=0, var=1）
-    // 获取输出通道数（从Conv的权重形状推断）
-    Value* weight_value = conv->GetInputs().size() > 1 ? conv->GetInputs()[1] : nullptr;
-    int64_t channels = 1;
-    if (weight_value && weight_value->GetTensor()) {
-        const Shape& weight_shape = weight_value->GetShape();
-        if (weight_shape.dims.size() >= 1) {
-            channels = weight_shape.dims[0];  // 输出通道数
+    if (!fusion::HasKnownShape(mask) || !fusion::HasKnownShape(scores)) {
+        return true;
+    }
+    const auto& m = mask->GetShape().dims;
+    const auto& s = scores->GetShape().dims;
+    if (m.size() > s.size()) {
+        return false;
+    }
+    for (size_t i = 1; i <= m.size(); ++i) {
+        if (m[m.size() - i] != 1 && m[m.size() - i] != s[s.size() - i]) {
+            return false;
         }
     }
+    return true;
+}
+
+// MatMul的alpha属性（缺省为1）
+float MatMulAlpha(const Node& node) {
+    const AttributeValue* alpha = node.FindAttribute("alpha");
+    if (!alpha) {
+        return 1.0f;
+    }
+    switch (alpha->GetType()) {
+        case AttributeValue::Type::FLOAT: return alpha->GetFloat();
+        case AttributeValue::Type::INT: return static_cast<float>(alpha->GetInt());
+        default: return 0.0f;  // 类型不符时不参与融合
+    }
+}
+
+// softmax(Q * K^T [/ scale | * scale] [+ mask]) * V -> FusedAttention
+// 节点：0 MatMul(P, V) 1 Softmax [Add(mask)] [Div/Mul(scale)] MatMul(Q, K^T)
+// K^T的Transpose已在同一阶段折叠为QK MatMul的transB=1
+FusionRule AttentionRule(bool has_mask, const std::string& scale_op) {
+    FusionRule rule;
+    rule.pattern.name = "Attention";
+    rule.pattern.nodes = {
+        {{"MatMul"}, 2, {}, [](const Node& n) {
+            return n.GetAttribute("transA", "0") == "0" && n.GetAttribute("transB", "0") == "0" &&
+                   MatMulAlpha(n) == 1.0f;
+        }},
+        {{"Softmax"}, 1, {}, IsLastAxisSoftmax},
+    };
+    if (has_mask) {
+        rule.pattern.nodes.push_back({{"Add"}, 2, {}, nullptr});
+    }
+    if (!scale_op.empty()) {
+        rule.pattern.nodes.push_back({{scale_op}, 2, {}, nullptr});
+    }
+    rule.pattern.nodes.push_back({{"MatMul"}, 2, {}, [](const Node& n) {
+        return n.GetAttribute("transA", "0") == "0" && n.GetAttribute("transB", "0") == "1" &&
+               MatMulAlpha(n) != 0.0f;
+    }});
+    // 单链：Add/Mul可交换，其余算子的链输入在第0个位置（Div的除数在右侧）
+    for (size_t i = 0; i + 1 < rule.pattern.nodes.size(); ++i) {
+        const std::string& op = rule.pattern.nodes[i].op_types[0].GetName();
+        const int slot = (op == "Add" || op == "Mul") ? kAnyInputSlot : 0;
+        rule.pattern.nodes[i].edges = {{slot, static_cast<int>(i) + 1}};
+    }
     
-    // 创建单位BN参数：scale=1, B=0, mean=0, var=1
-    Shape param_shape({channels});
-    auto scale_tensor = CreateTensor(param_shape, DataType::FLOAT32, DeviceType::CPU);
-    auto bias_tensor = CreateTensor(param_shape, DataType::FLOAT32, DeviceType::CPU);
-    auto mean_tensor = CreateTensor(param_shape, DataType::FLOAT32, DeviceType::CPU);
-    auto var_tensor = CreateTensor(param_shape, DataType::FLOAT32, DeviceType::CPU);
+    const int mask_index = has_mask ? 2 : -1;
+    const int scale_index = scale_op.empty() ? -1 : (has_mask ? 3 : 2);
+    const int qk_index = static_cast<int>(rule.pattern.nodes.size()) - 1;
+    // scale = alpha(QK) * 常量（Div时取倒数）
+    auto scale_of = [=](const Graph& graph, const Match& m, float* scale) {
+        float value = 1.0f;
+        if (scale_index >= 0 &&
+            (!fusion::GetScalarConstant(graph, m.OtherInput(scale_index, scale_index + 1), &value) ||
+             value == 0.0f)) {
+            return false;
+        }
+        *scale = MatMulAlpha(*m.nodes[qk_index]) * (scale_op == "Div" ? 1.0f / value : value);
+        return true;
+    };
+    rule.pattern.constraint = [=](const Graph& graph, const Match& m) {
+        float scale = 0.0f;
+        const Value* scores = m.nodes[qk_index]->GetOutputs()[0];
+        return scale_of(graph, m, &scale) &&
+               IsAttentionOperand(m.Input(qk_index, 0)) && IsAttentionOperand(m.Input(qk_index, 1)) &&
+               IsAttentionOperand(m.Input(0, 1)) &&
+               (mask_index < 0 || IsAttentionMask(m.OtherInput(mask_index, mask_index + 1), scores));
+    };
+    rule.rewrite = [=](Graph* graph, const Match& m) {
+        float scale = 0.0f;
+        scale_of(*graph, m, &scale);
+        std::vector<Value*> inputs = {m.Input(qk_index, 0), m.Input(qk_index, 1), m.Input(0, 1)};
+        if (mask_index >= 0) {
+            inputs.push_back(m.OtherInput(mask_index, mask_index + 1));
+        }
+        return Replace(graph, m, "FusedAttention", inputs,
+                       {{"scale", AttributeValue(scale)}, {"causal", AttributeValue(int64_t(0))}});
+    };
+    return rule;
+}
+
+std::vector<FusionRule> AttentionRules() {
+    std::vector<FusionRule> rules;
+    for (bool has_mask : {true, false}) {
+        for (const char* scale_op : {"Div", "Mul", ""}) {
+            rules.push_back(AttentionRule(has_mask, scale_op));
+        }
+    }
+    return rules;
+}
+
+// 最后一维已知的FLOAT32值，返回该维大小（其余维度可以是动态的）
+int64_t LastDim(const Value* value) {
+    if (!value || !value->GetTensor() || value->GetDataType() != DataType::FLOAT32 ||
+        value->GetShape().dims.empty()) {
+        return 0;
+    }
+    return std::max<int64_t>(value->GetShape().dims.back(), 0);
+}
+
+// Slice/Concat的轴是否为秩rank的最后一维
+bool IsLastAxis(int64_t axis, size_t rank) {
+    return axis == -1 || axis == static_cast<int64_t>(rank) - 1;
+}
+
+// Slice的参数：属性（INTS/INT）或第index个常量INT64输入，缺省时为空
+bool SliceParameter(const Graph& graph, const Node& slice, const std::string& key, size_t index,
+                    std::vector<int64_t>* values) {
+    values->clear();
+    if (const AttributeValue* attr = slice.FindAttribute(key)) {
+        if (attr->GetType() == AttributeValue::Type::INTS) {
+            *values = attr->GetInts();
+        } else if (attr->GetType() == AttributeValue::Type::INT) {
+            *values = {attr->GetInt()};
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (index >= slice.GetInputs().size()) {
+        return true;
+    }
+    const Value* input = slice.GetInputs()[index];
+    if (!fusion::IsConstant(graph, input) || input->GetTensor()->GetDataType() != DataType::INT64) {
+        return false;
+    }
+    const int64_t* data = static_cast<const int64_t*>(input->GetTensor()->GetData());
+    values->assign(data, data + input->GetTensor()->GetElementCount());
+    return true;
+}
+
+// Slice沿最后一维（长度dim）取[begin, end)，步长为1
+bool IsLastAxisSlice(const Graph& graph, const Node& slice, int64_t dim, int64_t begin, int64_t end) {
+    const Value* x = slice.GetInputs()[0];
+    std::vector<int64_t> starts, ends, axes, steps;
+    if (x->GetShape().dims.empty() || !SliceParameter(graph, slice, "starts", 1, &starts) ||
+        !SliceParameter(graph, slice, "ends", 2, &ends) || !SliceParameter(graph, slice, "axes", 3, &axes) ||
+        !SliceParameter(graph, slice, "steps", 4, &steps) || starts.size() != 1 || ends.size() != 1 ||
+        axes.size() != 1 || !IsLastAxis(axes[0], x->GetShape().dims.size()) ||
+        (!steps.empty() && (steps.size() != 1 || steps[0] != 1))) {
+        return false;
+    }
+    auto clamp = [dim](int64_t i) { return std::max<int64_t>(0, std::min(i < 0 ? i + dim : i, dim)); };
+    return clamp(starts[0]) == begin && clamp(ends[0]) == end;
+}
+
+// 取负：Neg或乘以标量-1
+bool IsNegation(const Graph& graph, const Node& node) {
+    return node.GetOpType() == "Neg" ||
+           (node.GetInputs().size() == 2 && (IsScalarConstant(graph, node.GetInputs()[0], -1.0f) ||
+                                             IsScalarConstant(graph, node.GetInputs()[1], -1.0f)));
+}
+
+// [P, D]的cos/sin表两半相同（HuggingFace的cat(freqs, freqs)），RotaryEmbedding只需读前D/2列
+bool HasRepeatedHalves(const Tensor& table, int64_t dim) {
+    const float* data = static_cast<const float*>(table.GetData());
+    const int64_t rows = static_cast<int64_t>(table.GetElementCount()) / dim;
+    for (int64_t r = 0; r < rows; ++r) {
+        const float* row = data + r * dim;
+        if (!std::equal(row, row + dim / 2, row + dim / 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// RoPE的cos/sin来源：Gather(常量表[P, D], position_ids)，之后可以经Unsqueeze/Reshape插入头维度；
+// 或是已按序列位置展开的常量[..., S, D]（静态序列长度的导出），此时位置为0..S-1
+struct RotarySource {
+    Value* table = nullptr;
+    Value* positions = nullptr;   // 为空时为0..table_rows-1
+    int64_t table_rows = 0;
+};
+
+bool TraceRotarySource(const Graph& graph, const Value* value, const Value* x, int64_t dim, RotarySource* source) {
+    while (value->GetProducer() &&
+           (value->GetProducer()->GetOpType() == "Unsqueeze" || value->GetProducer()->GetOpType() == "Reshape")) {
+        value = value->GetProducer()->GetInputs()[0];
+    }
+    const Node* gather = value->GetProducer();
+    Value* table = nullptr;
+    if (gather && gather->GetOpType() == "Gather" && gather->GetInputs().size() == 2 &&
+        gather->GetAttribute("axis", "0") == "0") {
+        table = gather->GetInputs()[0];
+        source->positions = gather->GetInputs()[1];
+        if (!fusion::IsConstant(graph, table) || table->GetShape().dims.size() != 2 ||
+            source->positions->GetDataType() != DataType::INT64) {
+            return false;
+        }
+    } else if (fusion::IsConstant(graph, value) && value->GetShape().dims.size() >= 2) {
+        // 常量表的行须与x的序列维一一对应
+        const auto& dims = x->GetShape().dims;
+        table = const_cast<Value*>(value);
+        source->positions = nullptr;
+        const int64_t rows = static_cast<int64_t>(table->GetTensor()->GetElementCount()) / dim;
+        if (dims.size() < 2 || dims[dims.size() - 2] != rows) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    const auto tensor = table->GetTensor();
+    if (tensor->GetDataType() != DataType::FLOAT32 || table->GetShape().dims.back() != dim ||
+        !HasRepeatedHalves(*tensor, dim)) {
+        return false;
+    }
+    source->table = table;
+    source->table_rows = static_cast<int64_t>(tensor->GetElementCount()) / dim;
+    return true;
+}
+
+// x * cos + rotate_half(x) * sin -> RotaryEmbedding（HuggingFace LLaMA/Qwen的apply_rotary_pos_emb）
+// rotate_half(x) = Concat(-x[..., D/2:], x[..., :D/2])
+// 节点：0 Add 1 Mul(x, cos) 2 Mul(rotate_half, sin) 3 Concat 4 Neg 5 Slice(后半) 6 Slice(前半)
+// cos/sin通常被Q与K的旋转共享，不属于子图；两者的Gather在改写后由死代码消除删除
+FusionRule RotaryEmbeddingRule() {
+    FusionRule rule;
+    rule.pattern.name = "RotaryEmbedding";
+    rule.pattern.nodes = {
+        {{"Add"}, 2, {{kAnyInputSlot, 1}, {kAnyInputSlot, 2}}, nullptr},
+        {{"Mul"}, 2, {}, nullptr},
+        {{"Mul"}, 2, {{kAnyInputSlot, 3}}, nullptr},
+        {{"Concat"}, 2, {{0, 4}, {1, 6}}, nullptr},
+        {{"Neg", "Mul"}, -1, {{kAnyInputSlot, 5}}, nullptr},
+        {{"Slice"}, -1, {}, nullptr},
+        {{"Slice"}, -1, {}, nullptr},
+    };
+    auto sources = [](const Graph& graph, const Match& m, RotarySource* cos, RotarySource* sin) {
+        Value* x = m.Input(6, 0);
+        const int64_t dim = LastDim(x);
+        if (dim == 0 || dim % 2 != 0 || m.Input(5, 0) != x || !IsNegation(graph, *m.nodes[4])) {
+            return false;
+        }
+        Value* cos_value = m.Input(1, 0) == x ? m.Input(1, 1) : (m.Input(1, 1) == x ? m.Input(1, 0) : nullptr);
+        if (!cos_value || !TraceRotarySource(graph, cos_value, x, dim, cos) ||
+            !TraceRotarySource(graph, m.OtherInput(2, 3), x, dim, sin)) {
+            return false;
+        }
+        const Node& concat = *m.nodes[3];
+        return cos->positions == sin->positions && cos->table_rows == sin->table_rows &&
+               IsLastAxis(std::stoll(concat.GetAttribute("axis", "0")), x->GetShape().dims.size()) &&
+               IsLastAxisSlice(graph, *m.nodes[5], dim, dim / 2, dim) &&
+               IsLastAxisSlice(graph, *m.nodes[6], dim, 0, dim / 2);
+    };
+    rule.pattern.constraint = [=](const Graph& graph, const Match& m) {
+        RotarySource cos, sin;
+        const size_t rank = m.Input(6, 0)->GetShape().dims.size();
+        return (rank == 3 || rank == 4) && sources(graph, m, &cos, &sin);
+    };
+    rule.rewrite = [=](Graph* graph, const Match& m) {
+        RotarySource cos, sin;
+        if (!sources(*graph, m, &cos, &sin)) {
+            return RewriteFailed("RotaryEmbedding");
+        }
+        Value* positions = cos.positions;
+        if (!positions) {
+            auto arange = CreateTensor(Shape({cos.table_rows}), DataType::INT64, DeviceType::CPU);
+            int64_t* data = static_cast<int64_t*>(arange->GetData());
+            for (int64_t i = 0; i < cos.table_rows; ++i) {
+                data[i] = i;
+            }
+            positions = fusion::AddConstant(graph, arange, m.Root()->GetName() + "_positions");
+        }
+        return Replace(graph, m, "RotaryEmbedding", {m.Input(6, 0), positions, cos.table, sin.table},
+                       {{"interleaved", AttributeValue(int64_t(0))}});
+    };
+    return rule;
+}
+
+// MatMul(transA=transB=0, alpha=1)的二维FLOAT32常量权重
+bool IsPlainMatMul(const Node& node) {
+    return node.GetAttribute("transA", "0") == "0" && node.GetAttribute("transB", "0") == "0" &&
+           MatMulAlpha(node) == 1.0f;
+}
+
+// silu(x * Wg) * (x * Wu) -> SwiGLU(x, [Wg | Wu])（LLaMA/Qwen MLP的gate/up投影）
+// 节点：0 Mul 1 Silu 2 MatMul(up) 3 MatMul(gate)；两个MatMul共享x，权重为同形的二维常量
+FusionRule SwiGLURule() {
+    FusionRule rule;
+    rule.pattern.name = "SwiGLU";
+    rule.pattern.nodes = {
+        {{"Mul"}, 2, {{kAnyInputSlot, 1}, {kAnyInputSlot, 2}}, nullptr},
+        {{"Silu"}, 1, {{0, 3}}, nullptr},
+        {{"MatMul"}, 2, {}, IsPlainMatMul},
+        {{"MatMul"}, 2, {}, IsPlainMatMul},
+    };
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        const Value* x = m.Input(3, 0);
+        const Value* gate = m.Input(3, 1);
+        const Value* up = m.Input(2, 1);
+        return m.Input(2, 0) == x && (x->GetDataType() == DataType::FLOAT32 || x->GetDataType() == DataType::UNKNOWN) && fusion::IsConstant(graph, gate) &&
+               fusion::IsConstant(graph, up) && gate->GetTensor()->GetDataType() == DataType::FLOAT32 &&
+               up->GetTensor()->GetDataType() == DataType::FLOAT32 && gate->GetShape().dims.size() == 2 &&
+               gate->GetShape().dims == up->GetShape().dims;
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        const Tensor& gate = *m.Input(3, 1)->GetTensor();
+        const Tensor& up = *m.Input(2, 1)->GetTensor();
+        const int64_t K = gate.GetShape().dims[0];
+        const int64_t N = gate.GetShape().dims[1];
+        auto merged = CreateTensor(Shape({K, 2 * N}), DataType::FLOAT32, DeviceType::CPU);
+        float* dst = static_cast<float*>(merged->GetData());
+        const float* g = static_cast<const float*>(gate.GetData());
+        const float* u = static_cast<const float*>(up.GetData());
+        for (int64_t k = 0; k < K; ++k) {
+            std::copy(g + k * N, g + (k + 1) * N, dst + k * 2 * N);
+            std::copy(u + k * N, u + (k + 1) * N, dst + k * 2 * N + N);
+        }
+        Value* weight = fusion::AddConstant(graph, merged, m.Input(3, 1)->GetName() + "_gate_up");
+        return Replace(graph, m, "SwiGLU", {m.Input(3, 0), weight}, {});
+    };
+    return rule;
+}
+
+// Gather(表, indices[B, L]) -> ReduceSum/ReduceMean(axes=1) -> EmbeddingBag（DLRM等推荐模型导出的嵌入袋），
+// 按袋直接累加，不物化[B, L, dim]的收集结果
+FusionRule EmbeddingBagRule() {
+    FusionRule rule;
+    rule.pattern.name = "EmbeddingBag";
+    rule.pattern.nodes = {
+        {{"ReduceSum", "ReduceMean"}, 1, {{0, 1}}, [](const Node& node) {
+             const std::string axes = node.GetAttribute("axes");
+             return axes == "1" || axes == "-2";
+         }},
+        {{"Gather"}, 2, {}, fusion::AttributeIs("axis", "0", "0")},
+    };
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        const Value* table = m.Input(1, 0);
+        const Value* indices = m.Input(1, 1);
+        return fusion::IsConstant(graph, table) && table->GetShape().dims.size() == 2 &&
+               table->GetTensor()->GetDataType() == DataType::FLOAT32 && fusion::HasKnownShape(indices) &&
+               indices->GetShape().dims.size() == 2 &&
+               (indices->GetDataType() == DataType::INT64 || indices->GetDataType() == DataType::INT32);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        const bool mean = m.Root()->GetOpType() == "ReduceMean";
+        const int64_t keepdims = m.Root()->GetAttribute("keepdims", "1") == "0" ? 0 : 1;
+        NodeAttributes attributes = {{"mode", AttributeValue(std::string(mean ? "mean" : "sum"))},
+                                     {"keepdims", AttributeValue(keepdims)}};
+        return Replace(graph, m, "EmbeddingBag", {m.Input(1, 0), m.Input(1, 1)}, attributes);
+    };
+    return rule;
+}
+
+// ---- 阶段2：计算密集算子+后处理 ----
+
+bool IsConvWithOptionalBias(const Node& conv) {
+    return conv.GetInputs().size() == 2 || conv.GetInputs().size() == 3;
+}
+
+// Conv+Add(残差)+ReLU：残差为非常量、形状与Conv输出相同，且不是Conv自身的输入
+bool IsResidualOf(const Graph& graph, const Match& m) {
+    Node* conv = m.nodes[2];
+    Value* residual = m.OtherInput(1, 2);
+    const auto& conv_inputs = conv->GetInputs();
+    return residual && !fusion::IsConstant(graph, residual) &&
+           std::find(conv_inputs.begin(), conv_inputs.end(), residual) == conv_inputs.end() &&
+           SameKnownShape(residual, conv->GetOutputs()[0]);
+}
+
+std::vector<FusionRule> PostOpRules(const OperatorFusionPass* pass) {
+    std::vector<FusionRule> rules;
     
-    // 填充单位值
-    scale_tensor->FillValue(1.0f);  // scale = 1
-    bias_tensor->FillValue(0.0f);   // B = 0
-    mean_tensor->FillValue(0.0f);   // mean = 0
-    var_tensor->FillValue(1.0f);    // var = 1
+    // Conv+BN+ReLU：BN折算为逐通道scale/bias，与ReLU一起在卷积写回时完成
+    FusionRule conv_bn_relu;
+    conv_bn_relu.pattern.name = "ConvBNReLU";
+    conv_bn_relu.pattern.nodes = {
+        {{"Relu"}, 1, {{0, 1}}, nullptr},
+        {{"BatchNormalization"}, -1, {{0, 2}}, nullptr},
+        {{"Conv"}, -1, {}, nullptr},
+    };
+    conv_bn_relu.pattern.constraint = [pass](const Graph&, const Match& m) {
+        return pass->CanFuseConvBNReLU(m.nodes[2], m.nodes[1], m.nodes[0]);
+    };
+    conv_bn_relu.rewrite = [](Graph* graph, const Match& m) {
+        Node* bn = m.nodes[1];
+        Node* conv = m.nodes[2];
+        // 输入：input, weight, bias(可选), scale, B, mean, var
+        const auto& bn_inputs = bn->GetInputs();
+        std::vector<Value*> inputs = Concat(conv->GetInputs(),
+                                            std::vector<Value*>(bn_inputs.begin() + 1, bn_inputs.end()));
+        NodeAttributes attrs = conv->GetAttributes();
+        if (bn->HasAttribute("epsilon")) {
+            attrs["epsilon"] = *bn->FindAttribute("epsilon");
+        }
+        return Replace(graph, m, "FusedConvBNReLU", inputs, attrs);
+    };
+    rules.push_back(conv_bn_relu);
     
-    // 创建Value并添加到图中
-    Value* scale_value = graph->AddValue();
-    Value* bias_value = graph->AddValue();
-    Value* mean_value = graph->AddValue();
-    Value* var_value = graph->AddValue();
+    // Conv+Add+ReLU（ResNet残差块）：卷积带bias写回后，残差加与ReLU一遍完成
+    FusionRule conv_add_relu;
+    conv_add_relu.pattern.name = "ConvAddReLU";
+    conv_add_relu.pattern.nodes = {
+        {{"Relu"}, 1, {{0, 1}}, nullptr},
+        {{"Add"}, 2, {{kAnyInputSlot, 2}}, nullptr},
+        {{"Conv"}, -1, {}, IsConvWithOptionalBias},
+    };
+    conv_add_relu.pattern.constraint = IsResidualOf;
+    conv_add_relu.rewrite = [](Graph* graph, const Match& m) {
+        Node* conv = m.nodes[2];
+        // 输入：input, weight, bias(可选), residual
+        return Replace(graph, m, "FusedConvAddReLU",
+                       Concat(conv->GetInputs(), {m.OtherInput(1, 2)}), conv->GetAttributes());
+    };
+    rules.push_back(conv_add_relu);
     
-    scale_value->SetTensor(scale_tensor);
-    bias_value->SetTensor(bias_tensor);
-    mean_value->SetTensor(mean_tensor);
-    var_value->SetTensor(var_tensor);
+    // Conv+ReLU
+    FusionRule conv_relu;
+    conv_relu.pattern.name = "ConvReLU";
+    conv_relu.pattern.nodes = {
+        {{"Relu"}, 1, {{0, 1}}, nullptr},
+        {{"Conv"}, -1, {}, IsConvWithOptionalBias},
+    };
+    conv_relu.pattern.constraint = [pass](const Graph&, const Match& m) {
+        return pass->CanFuseConvReLU(m.nodes[1], m.nodes[0]);
+    };
+    conv_relu.rewrite = [](Graph* graph, const Match& m) {
+        Node* conv = m.nodes[1];
+        return Replace(graph, m, "FusedConvReLU", conv->GetInputs(), conv->GetAttributes());
+    };
+    rules.push_back(conv_relu);
     
-    // 添加到融合节点的输入
-    fused_node->AddInput(scale_value);
-    fused_node->AddInput(bias_value);
-    fused_node->AddInput(mean_value);
-    fused_node->AddInput(var_value);
+    // BN+ReLU（BN的输入不是Conv，或Conv输出有其他消费者）
+    FusionRule bn_relu;
+    bn_relu.pattern.name = "BNReLU";
+    bn_relu.pattern.nodes = {
+        {{"Relu"}, 1, {{0, 1}}, nullptr},
+        {{"BatchNormalization"}, 5, {}, nullptr},
+    };
+    bn_relu.pattern.constraint = [pass](const Graph&, const Match& m) {
+        return pass->CanFuseBNReLU(m.nodes[1], m.nodes[0]);
+    };
+    bn_relu.rewrite = [](Graph* graph, const Match& m) {
+        Node* bn = m.nodes[1];
+        return Replace(graph, m, "FusedBNReLU", bn->GetInputs(), bn->GetAttributes());
+    };
+    rules.push_back(bn_relu);
     
-    // 连接输出
-    Value* relu_output = relu->GetOutputs()[0];
-    fused_node->AddOutput(relu_output);
-    relu_output->SetProducer(fused_node);
+    // MatMul+Add：bias在GEMM写回时加上
+    FusionRule matmul_add;
+    matmul_add.pattern.name = "MatMulAdd";
+    matmul_add.pattern.nodes = {
+        {{"Add"}, 2, {{kAnyInputSlot, 1}}, nullptr},
+        {{"MatMul"}, -1, {}, nullptr},
+    };
+    matmul_add.pattern.constraint = [pass](const Graph&, const Match& m) {
+        const auto& matmul_inputs = m.nodes[1]->GetInputs();
+        Value* bias = m.OtherInput(0, 1);
+        return pass->CanFuseMatMulAdd(m.nodes[1], m.nodes[0]) && bias &&
+               std::find(matmul_inputs.begin(), matmul_inputs.end(), bias) == matmul_inputs.end();
+    };
+    matmul_add.rewrite = [](Graph* graph, const Match& m) {
+        Node* matmul = m.nodes[1];
+        // 输入：A, B, bias
+        return Replace(graph, m, "FusedMatMulAdd", Concat(matmul->GetInputs(), {m.OtherInput(0, 1)}),
+                       matmul->GetAttributes());
+    };
+    rules.push_back(matmul_add);
     
-    // 删除原节点
-    graph->RemoveNode(relu);
-    graph->RemoveNode(conv);
+    // FusedMatMulAdd/Gemm+GELU/ReLU（Transformer FFN第一层、导出的全连接层）：激活在GEMM输出上完成
+    FusionRule matmul_add_act;
+    matmul_add_act.pattern.name = "MatMulAddActivation";
+    matmul_add_act.pattern.nodes = {
+        {{"Gelu", "Relu"}, 1, {{0, 1}}, nullptr},
+        {{"FusedMatMulAdd", "Gemm"}, -1, {}, fusion::AttributeIs("activation", "")},
+    };
+    matmul_add_act.rewrite = [](Graph* graph, const Match& m) {
+        Node* activation = m.nodes[0];
+        Node* gemm = m.nodes[1];
+        NodeAttributes attrs = gemm->GetAttributes();
+        attrs["activation"] = AttributeValue(std::string(activation->GetOpType() == "Gelu" ? "gelu" : "relu"));
+        if (activation->HasAttribute("approximate")) {
+            attrs["approximate"] = *activation->FindAttribute("approximate");
+        }
+        return Replace(graph, m, gemm->GetOpType(), gemm->GetInputs(), attrs);
+    };
+    rules.push_back(matmul_add_act);
     
-    return Status::Ok();
+    return rules;
+}
+
+// ---- 阶段2b：深度可分离块 ----
+
+// INTS属性的所有值都等于expected（缺省视为满足）
+bool AllInts(const Node& node, const std::string& key, int64_t expected) {
+    const AttributeValue* attr = node.FindAttribute(key);
+    if (!attr) return true;
+    if (attr->GetType() == AttributeValue::Type::INT) return attr->GetInt() == expected;
+    if (attr->GetType() != AttributeValue::Type::INTS) return false;
+    const auto& values = attr->GetInts();
+    return std::all_of(values.begin(), values.end(), [expected](int64_t v) { return v == expected; });
+}
+
+int64_t GroupOf(const Node& conv) {
+    const AttributeValue* attr = conv.FindAttribute("group");
+    return attr && attr->GetType() == AttributeValue::Type::INT ? attr->GetInt() : 1;
 }
 
-Status OperatorFusionPass::FuseBNReLU(Graph* graph, Node* bn, Node* relu) {
-    if (!graph || !bn || !relu) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid nodes");
+// 1x1、stride 1、无padding、group 1的卷积（权重形状已知）
+bool IsPointwiseConv(const Node& conv) {
+    if (!IsConvWithOptionalBias(conv) || !fusion::HasKnownShape(conv.GetInputs()[1])) return false;
+    const auto& w = conv.GetInputs()[1]->GetShape().dims;
+    const AttributeValue* auto_pad = conv.FindAttribute("auto_pad");
+    return w.size() == 4 && w[2] == 1 && w[3] == 1 && GroupOf(conv) == 1 &&
+           AllInts(conv, "strides", 1) && AllInts(conv, "pads", 0) &&
+           (!auto_pad || auto_pad->GetString() == "NOTSET" || auto_pad->GetString() == "VALID");
+}
+
+// group等于输入通道数的深度卷积（输入与权重形状已知，允许通道乘数）
+bool IsDepthwiseConv(const Node& conv) {
+    if (!IsConvWithOptionalBias(conv) || !fusion::HasKnownShape(conv.GetInputs()[0]) ||
+        !fusion::HasKnownShape(conv.GetInputs()[1])) {
+        return false;
     }
-    
-    // 创建融合节点（使用FusedConvBNReLU，但Conv部分为空）
-    // 或者创建专门的FusedBNReLU算子
-    // 这里简化：直接合并到BN节点，添加ReLU属性
-    std::string fused_name = bn->GetName() + "_" + relu->GetName() + "_fused";
-    Node* fused_node = graph->AddNode("BatchNormalization", fused_name);  // 使用BN，但添加fused属性
-    
-    // 合并属性
-    for (const auto& attr : bn->GetAttributes()) {
-        fused_node->SetAttribute(attr.first, attr.second);
+    const auto& x = conv.GetInputs()[0]->GetShape().dims;
+    const auto& w = conv.GetInputs()[1]->GetShape().dims;
+    const int64_t group = GroupOf(conv);
+    return x.size() == 4 && w.size() == 4 && group > 1 && x[1] == group && w[1] == 1 && w[0] % group == 0;
+}
+
+// Conv/FusedConvReLU(深度) -> Conv/FusedConvReLU(1x1)，即MobileNet的深度可分离块（BN已由ConvBNFoldingPass折进卷积）
+FusionRule DepthwisePointwiseRule() {
+    FusionRule rule;
+    rule.pattern.name = "DepthwisePointwise";
+    rule.pattern.nodes = {
+        {{"Conv", "FusedConvReLU"}, -1, {{0, 1}}, IsPointwiseConv},
+        {{"Conv", "FusedConvReLU"}, -1, {}, IsDepthwiseConv},
+    };
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        return fusion::IsConstant(graph, m.nodes[0]->GetInputs()[1]) &&
+               fusion::IsConstant(graph, m.nodes[1]->GetInputs()[1]);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        Node* pw = m.nodes[0];
+        Node* dw = m.nodes[1];
+        // 输入：input, dw_weight, dw_bias(可选), pw_weight, pw_bias(可选)
+        std::vector<Value*> inputs = dw->GetInputs();
+        std::vector<int64_t> slots = {0, 1};
+        if (inputs.size() > 2) slots.push_back(2);
+        inputs.push_back(pw->GetInputs()[1]);
+        slots.push_back(3);
+        if (pw->GetInputs().size() > 2) {
+            inputs.push_back(pw->GetInputs()[2]);
+            slots.push_back(4);
+        }
+        NodeAttributes attrs = dw->GetAttributes();
+        if (slots.size() < 5) {
+            attrs["input_slots"] = AttributeValue(slots);
+        }
+        attrs["dw_activation"] = AttributeValue(std::string(dw->GetOpType() == "FusedConvReLU" ? "relu" : ""));
+        attrs["activation"] = AttributeValue(std::string(pw->GetOpType() == "FusedConvReLU" ? "relu" : ""));
+        return Replace(graph, m, "FusedDepthwisePointwise", inputs, attrs);
+    };
+    return rule;
+}
+
+// ---- 阶段3：逐元素算子链 ----
+
+// FusedElementwise：inputs[0]为链的起点，其后依次是各二元步骤的另一个操作数；
+// ops为逗号分隔的步骤列表，RSub/RDiv表示链上的值在右侧，"Op@k"表示操作数为已有的inputs[k]
+struct ElementwiseChain {
+    Value* x0 = nullptr;
+    std::vector<std::string> ops;
+    std::vector<Value*> operands;
+};
+
+const std::unordered_set<std::string>& UnaryElementwiseOps() {
+    static const std::unordered_set<std::string> kOps = {
+        "Relu", "Sigmoid", "Tanh", "Gelu", "Silu", "Exp", "Log", "Sqrt"};
+    return kOps;
+}
+
+const std::unordered_set<std::string>& BinaryElementwiseOps() {
+    static const std::unordered_set<std::string> kOps = {"Add", "Sub", "Mul", "Div", "Max", "Min", "Pow"};
+    return kOps;
+}
+
+bool IsElementwiseNode(const Node& node) {
+    const std::string& op = node.GetOpType();
+    return (UnaryElementwiseOps().count(op) && node.GetInputs().size() == 1) ||
+           (BinaryElementwiseOps().count(op) && node.GetInputs().size() == 2);
+}
+
+std::string UnaryStep(const Node& node) {
+    if (node.GetOpType() == "Gelu" && node.GetAttribute("approximate") == "tanh") {
+        return "GeluTanh";
     }
-    fused_node->SetAttribute("fused_relu", "true");
-    
-    // 连接输入
-    for (Value* input : bn->GetInputs()) {
-        fused_node->AddInput(input);
+    return node.GetOpType();
+}
+
+std::string BinaryStep(const std::string& op, bool chain_on_right) {
+    if (!chain_on_right) return op;
+    if (op == "Sub") return "RSub";
+    if (op == "Div") return "RDiv";
+    return op;  // Add/Mul/Max/Min满足交换律
+}
+
+bool IsFloatOrUnknown(const Value* value) {
+    return value->GetDataType() == DataType::FLOAT32 || value->GetDataType() == DataType::UNKNOWN;
+}
+
+// operand能否逐元素对齐到target：标量常量、形状相同，或operand的非1维（右对齐）
+// 恰为target中连续的一段（如[C]之于[N, C]、[C, 1, 1]之于[N, C, H, W]），与执行器的广播方式一致
+bool BroadcastsOnto(const Graph& graph, const Value* operand, const Value* target) {
+    float scalar = 0.0f;
+    if (fusion::GetScalarConstant(graph, operand, &scalar) || SameKnownShape(operand, target)) {
+        return true;
+    }
+    if (!fusion::HasKnownShape(operand) || !fusion::HasKnownShape(target)) {
+        return false;
+    }
+    const auto& dims = operand->GetShape().dims;
+    const auto& full = target->GetShape().dims;
+    if (dims.size() > full.size()) {
+        return false;
+    }
+    const size_t offset = full.size() - dims.size();
+    int64_t last = -1;
+    for (size_t d = 0; d < dims.size(); ++d) {
+        if (dims[d] == 1) continue;
+        if (dims[d] != full[d + offset] || (last >= 0 && last + 1 != static_cast<int64_t>(d))) {
+            return false;
+        }
+        last = static_cast<int64_t>(d);
+    }
+    return true;
+}
+
+// 在链末尾追加node（chain_value为链上当前的值）；操作数已是FusedElementwise的输入时用"@k"引用
+bool AppendStep(const Graph& graph, const Node& node, const Value* chain_value,
+                ElementwiseChain* chain) {
+    if (node.GetInputs().size() == 1) {
+        chain->ops.push_back(UnaryStep(node));
+        return true;
+    }
+    const auto& inputs = node.GetInputs();
+    const bool on_right = inputs[1] == chain_value;
+    Value* operand = inputs[on_right ? 0 : 1];
+    if (operand == chain_value && chain_value != chain->x0) {
+        return false;  // 中间值不能作为输入（如链中间的x * x）
+    }
+    if ((on_right && node.GetOpType() == "Pow") || !IsFloatOrUnknown(operand)) {
+        return false;  // 链上的值只能作为Pow的底数
+    }
+    std::string step = BinaryStep(node.GetOpType(), on_right);
+    if (operand == chain->x0) {
+        chain->ops.push_back(step + "@0");
+        return true;
+    }
+    auto existing = std::find(chain->operands.begin(), chain->operands.end(), operand);
+    if (existing != chain->operands.end()) {
+        chain->ops.push_back(step + "@" + std::to_string(existing - chain->operands.begin() + 1));
+        return true;
+    }
+    if (!BroadcastsOnto(graph, operand, chain->x0)) {
+        return false;
+    }
+    chain->ops.push_back(step);
+    chain->operands.push_back(operand);
+    return true;
+}
+
+// 以producer开始一条链：FusedElementwise直接展开，其余逐元素算子作为第一步
+bool StartChain(const Graph& graph, const Node& producer, ElementwiseChain* chain) {
+    const auto& inputs = producer.GetInputs();
+    chain->x0 = inputs[0];
+    if (producer.GetOpType() == "FusedElementwise") {
+        std::stringstream ss(producer.GetAttribute("ops"));
+        std::string op;
+        while (std::getline(ss, op, ',')) {
+            chain->ops.push_back(op);
+        }
+        chain->operands.assign(inputs.begin() + 1, inputs.end());
+        return true;
+    }
+    // 左侧为标量常量或广播到右侧的操作数时（如1 - x、bias + x）以另一侧为链起点
+    if (inputs.size() == 2 && producer.GetOpType() != "Pow" &&
+        BroadcastsOnto(graph, inputs[0], inputs[1]) && !BroadcastsOnto(graph, inputs[1], inputs[0])) {
+        chain->x0 = inputs[1];
+    }
+    if (!IsFloatOrUnknown(chain->x0)) {
+        return false;
+    }
+    return AppendStep(graph, producer, chain->x0, chain);
+}
+
+bool BuildChain(const Graph& graph, const Match& m, ElementwiseChain* chain) {
+    return StartChain(graph, *m.nodes[1], chain) &&
+           AppendStep(graph, *m.nodes[0], m.nodes[1]->GetOutputs()[0], chain);
+}
+
+FusionRule ElementwiseChainRule() {
+    FusionRule rule;
+    rule.pattern.name = "ElementwiseChain";
+    rule.pattern.nodes = {
+        {{"Relu", "Sigmoid", "Tanh", "Gelu", "Silu", "Exp", "Log", "Sqrt",
+          "Add", "Sub", "Mul", "Div", "Max", "Min", "Pow"}, -1, {{kAnyInputSlot, 1}}, IsElementwiseNode},
+        {{"Relu", "Sigmoid", "Tanh", "Gelu", "Silu", "Exp", "Log", "Sqrt",
+          "Add", "Sub", "Mul", "Div", "Max", "Min", "Pow", "FusedElementwise"},
+         -1, {}, [](const Node& node) {
+             return node.GetOpType() == "FusedElementwise" || IsElementwiseNode(node);
+         }},
+    };
+    rule.pattern.constraint = [](const Graph& graph, const Match& m) {
+        ElementwiseChain chain;
+        return m.nodes[1]->GetOutputs().size() == 1 && BuildChain(graph, m, &chain);
+    };
+    rule.rewrite = [](Graph* graph, const Match& m) {
+        ElementwiseChain chain;
+        if (!BuildChain(*graph, m, &chain)) {
+            return RewriteFailed("FusedElementwise");
+        }
+        std::string ops;
+        for (const auto& op : chain.ops) {
+            ops += (ops.empty() ? "" : ",") + op;
+        }
+        return Replace(graph, m, "FusedElementwise", Concat({chain.x0}, chain.operands),
+                       {{"ops", AttributeValue(ops)}});
+    };
+    return rule;
+}
+
+} // anonymous namespace
+
+Status OperatorFusionPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
     }
     
-    // 连接输出
-    Value* relu_output = relu->GetOutputs()[0];
-    fused_node->AddOutput(relu_output);
-    relu_output->SetProducer(fused_node);
+    // 分阶段应用：LayerNorm等分解子图先于逐元素链合并，避免被拆进FusedElementwise
+    FusionRule fold_transpose;
+    fold_transpose.pattern.name = "TransposeMatMul";
+    fold_transpose.pattern.nodes = {
+        {{"MatMul", "FusedMatMulAdd"}, -1, {{kAnyInputSlot, 1}}, nullptr},
+        {{"Transpose"}, 1, {}, nullptr},
+    };
+    fold_transpose.pattern.constraint = [this](const Graph&, const Match& m) {
+        return CanFoldTransposeIntoMatMul(m.nodes[1], m.nodes[0]);
+    };
+    fold_transpose.rewrite = FoldTransposeIntoMatMul;
     
-    // 删除原节点
-    graph->RemoveNode(relu);
-    graph->RemoveNode(bn);
+    // 注意力子图依赖Transpose折叠后的QK MatMul(transB=1)，与其同阶段应用
+    std::vector<FusionRule> phase1 = {fold_transpose, LayerNormRule()};
+    for (FusionRule& rule : AttentionRules()) {
+        phase1.push_back(std::move(rule));
+    }
+    
+    // LayerNorm子图内含(x - mean)的RMSNorm形式，须在RMSNorm规则之前单独应用
+    fusion::ApplyFusionRules(graph, phase1);
+    fusion::ApplyFusionRules(graph, {RmsNormDivRule(), RmsNormReciprocalRule(), SiluRule(), RotaryEmbeddingRule()});
+    // SwiGLU匹配Silu规则的结果，且须在MatMul被PostOp规则融合之前
+    fusion::ApplyFusionRules(graph, {SwiGLURule()});
+    fusion::ApplyFusionRules(graph, {EmbeddingBagRule()});
+    // 残差相加须在MatMul+Add融合之前并入归一化，否则会被当作FusedMatMulAdd的bias
+    FuseResidualNormalization(graph);
+    fusion::ApplyFusionRules(graph, PostOpRules(this));
+    // 深度卷积与1x1卷积先各自并入ReLU
+    fusion::ApplyFusionRules(graph, {DepthwisePointwiseRule()});
+    fusion::ApplyFusionRules(graph, {ElementwiseChainRule()});
     
     return Status::Ok();
 }
 
 } // namespace inferunity
-
@@ -1,7 +1,16 @@
 #include "inferunity/optimizer.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/logger.h"
+#include "inferunity/shape_inference.h"
+#include "inferunity/tensor.h"
+#include "inferunity/tracing.h"
+#include "fusion_pattern.h"
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <cmath>
 
 namespace inferunity {
@@ -16,18 +25,128 @@ void Optimizer::RegisterPass(std::unique_ptr<OptimizationPass> pass) {
     pass_map_[name] = ptr;
 }
 
+namespace {
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// 结构指纹：节点的算子类型与输入输出值、值的数据类型以及图输出
+uint64_t GraphFingerprint(const Graph& graph) {
+    uint64_t hash = graph.GetNodes().size();
+    for (const auto& node : graph.GetNodes()) {
+        hash = HashCombine(hash, static_cast<uint64_t>(node->GetId()));
+        hash = HashCombine(hash, node->GetOpTypeId());
+        for (const Value* input : node->GetInputs()) {
+            hash = HashCombine(hash, input ? static_cast<uint64_t>(input->GetId()) : ~0ULL);
+        }
+        for (const Value* output : node->GetOutputs()) {
+            hash = HashCombine(hash, static_cast<uint64_t>(output->GetId()) << 1);
+        }
+    }
+    for (const auto& value : graph.GetValues()) {
+        hash = HashCombine(hash, static_cast<uint64_t>(value->GetDataType()));
+    }
+    for (const Value* output : graph.GetOutputs()) {
+        hash = HashCombine(hash, static_cast<uint64_t>(output->GetId()));
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+Status OptimizationPass::Apply(Graph* graph, bool* modified) {
+    const uint64_t before = graph ? GraphFingerprint(*graph) : 0;
+    Status status = Run(graph);
+    if (modified) {
+        *modified = status.IsOk() && graph && GraphFingerprint(*graph) != before;
+    }
+    return status;
+}
+
+GraphAnalysis GraphAnalysis::Compute(const Graph& graph) {
+    GraphAnalysis analysis;
+    analysis.num_nodes = graph.GetNodes().size();
+    analysis.op_counts.assign(GetOpTypeCount(), 0);
+    for (const auto& node : graph.GetNodes()) {
+        ++analysis.op_counts[node->GetOpTypeId()];
+    }
+    analysis.fingerprint = GraphFingerprint(graph);
+    return analysis;
+}
+
+bool GraphAnalysis::HasAnyOp(const std::vector<std::string>& op_types) const {
+    if (op_types.empty()) {
+        return true;
+    }
+    for (const std::string& op_type : op_types) {
+        // 从未驻留过的类型不可能出现在图中
+        const OpTypeId id = FindOpType(op_type);
+        if (id != kInvalidOpTypeId && GetOpCount(id) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 Status Optimizer::Optimize(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
     // 按依赖关系排序
     std::vector<OptimizationPass*> sorted_passes = SortPasses();
+    statistics_.clear();
+    
+    // 图级分析只算一次，之后只在Pass改变了图时失效重算
+    graph->Compact();
+    GraphAnalysis analysis = GraphAnalysis::Compute(*graph);
     
-    // 运行所有Pass
     for (OptimizationPass* pass : sorted_passes) {
-        Status status = pass->Run(graph);
-        if (!status.IsOk()) {
-            return status;
+        PassStatistics stats;
+        stats.name = pass->GetName();
+        stats.nodes_before = analysis.num_nodes;
+        if (!analysis.HasAnyOp(pass->GetTargetOpTypes())) {
+            stats.skipped = true;
+            stats.nodes_after = analysis.num_nodes;
+            statistics_.push_back(stats);
+            continue;
         }
+        
+        TraceScope trace(TraceCategory::OPTIMIZER, stats.name.c_str());
+        const int max_runs = pass->IsRepeatable() ? max_iterations_ : 1;
+        const auto start = std::chrono::steady_clock::now();
+        bool modified = true;
+        while (modified && stats.runs < max_runs) {
+            modified = false;
+            Status status = pass->Apply(graph, &modified);
+            ++stats.runs;
+            if (!status.IsOk()) {
+                return status;
+            }
+            // 每次运行结束后释放删除留下的墓碑
+            graph->Compact();
+            if (modified) {
+                stats.modified = true;
+                analysis = GraphAnalysis::Compute(*graph);
+            }
+        }
+        stats.converged = !modified || !pass->IsRepeatable();
+        stats.time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.nodes_after = analysis.num_nodes;
+        if (!stats.converged) {
+            LOG_WARNING("Pass " + stats.name + " did not reach a fixed point in " +
+                        std::to_string(max_runs) + " runs");
+        }
+        statistics_.push_back(stats);
     }
     
+    for (const PassStatistics& stats : statistics_) {
+        if (!stats.skipped && (stats.modified || stats.time_ms >= 1.0)) {
+            LOG_INFO("Pass " + stats.name + ": " + std::to_string(stats.runs) + " runs, " +
+                     std::to_string(stats.time_ms) + " ms, nodes " + std::to_string(stats.nodes_before) +
+                     " -> " + std::to_string(stats.nodes_after));
+        }
+    }
     return Status::Ok();
 }
 
@@ -139,119 +258,232 @@ Status DeadCodeEliminationPass::Run(Graph* graph) {
 // 这里保留声明以保持接口一致性
 
 // MemoryLayoutOptimizationPass实现
-Status MemoryLayoutOptimizationPass::Run(Graph* graph) {
-    if (!graph) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+namespace {
+
+// 在分块布局上逐元素执行、结果不变的算子；补齐通道上的0经过它们仍是有限值，
+// 不会经0权重污染后面的卷积（因此不包括Div等可能产生NaN的算子）
+bool IsLayoutAgnosticUnary(const std::string& op_type) {
+    return op_type == "Relu" || op_type == "Sigmoid" || op_type == "Tanh" ||
+           op_type == "Gelu" || op_type == "Silu";
+}
+
+bool IsLayoutAgnosticBinary(const std::string& op_type) {
+    return op_type == "Add" || op_type == "Sub" || op_type == "Mul";
+}
+
+// 已知通道数的4D FLOAT32值
+bool IsNchwValue(const Value* value) {
+    if (!value || !value->GetTensor() || value->GetDataType() != DataType::FLOAT32) {
+        return false;
     }
+    const Shape& shape = value->GetShape();
+    return shape.dims.size() == 4 && shape.dims[1] > 0;
+}
+
+class NchwcRewriter {
+public:
+    NchwcRewriter(Graph* graph, int64_t block) : graph_(graph), block_(block) {}
     
-    // 1. 分析数据流，确定每个节点的最优布局
-    // 策略：
-    // - Conv/Pool等算子偏好NCHW（通道优先）
-    // - 某些算子（如某些激活函数）对布局不敏感
-    // - 在布局不匹配时插入Transpose节点
-    
-    std::unordered_map<Node*, MemoryLayout> node_layouts;
-    std::unordered_map<Value*, MemoryLayout> value_layouts;
+    // 处理一个节点：能在分块布局上执行时改写并返回true
+    bool Rewrite(Node* node) {
+        const std::string& op_type = node->GetOpType();
+        if (node->GetOutputs().size() != 1 || node->GetInputs().empty() ||
+            !IsNchwValue(node->GetOutputs()[0])) {
+            return false;
+        }
+        if (op_type == "Conv" || op_type == "FusedConvReLU" || op_type == "FusedConvAddReLU") {
+            return RewriteConv(node);
+        }
+        if (!blocked_.count(node->GetInputs()[0])) {
+            // 其余算子只在输入已是分块布局时跟随，不为它们单独转换布局
+            return false;
+        }
+        if ((op_type == "MaxPool" || op_type == "AveragePool") && node->GetInputs().size() == 1) {
+            Retarget(node, op_type == "MaxPool" ? "NchwcMaxPool" : "NchwcAveragePool", {0});
+            return true;
+        }
+        // 全局池化的输出只有N*C个元素，直接写成NCHW，省去一次ReorderOutput
+        if ((op_type == "GlobalAveragePool" || op_type == "GlobalAvgPool" || op_type == "GlobalMaxPool") &&
+            node->GetInputs().size() == 1) {
+            Value* input = node->GetInputs()[0];
+            node->SetAttribute("channels", AttributeValue(input->GetShape().dims[1]));
+            node->ReplaceInput(input, Blocked(input));
+            node->SetOpType(op_type == "GlobalMaxPool" ? "NchwcGlobalMaxPool" : "NchwcGlobalAveragePool");
+            return true;
+        }
+        if ((op_type == "BatchNormalization" || op_type == "FusedBNReLU") && node->GetInputs().size() == 5) {
+            if (op_type == "FusedBNReLU") {
+                node->SetAttribute("activation", AttributeValue(std::string("Relu")));
+            }
+            Retarget(node, "NchwcBatchNormalization", {0});
+            return true;
+        }
+        if (IsLayoutAgnosticUnary(op_type) && node->GetInputs().size() == 1) {
+            Retarget(node, op_type, {0});
+            return true;
+        }
+        if (IsLayoutAgnosticBinary(op_type) && node->GetInputs().size() == 2) {
+            Value* a = node->GetInputs()[0];
+            Value* b = node->GetInputs()[1];
+            if (a == b || !IsNchwValue(b) || b->GetShape().dims != a->GetShape().dims ||
+                fusion::IsConstant(*graph_, b)) {
+                return false;
+            }
+            Retarget(node, op_type, {0, 1});
+            return true;
+        }
+        return false;
+    }
     
-    // 获取拓扑排序
-    std::vector<Node*> execution_order = graph->TopologicalSort();
+    // 非分块的消费者或图输出需要逻辑值时插入ReorderOutput
+    void Materialize(Value* value) {
+        if (!detached_.erase(value)) {
+            return;
+        }
+        Node* reorder = graph_->AddNode("ReorderOutput", "nchwc_reorder_output_" + std::to_string(counter_++));
+        reorder->SetAttribute("channels", AttributeValue(channels_[value]));
+        reorder->AddInput(blocked_[value]);
+        reorder->AddOutput(value);
+    }
     
-    // 为输入设置默认布局（NCHW）
-    for (Value* input : graph->GetInputs()) {
-        value_layouts[input] = MemoryLayout::NCHW;
+    // 所有消费者都已改写的逻辑值不再需要
+    void RemoveUnusedValues() {
+        for (Value* value : detached_) {
+            if (value->GetConsumers().empty()) {
+                graph_->RemoveValue(value);
+            }
+        }
+        detached_.clear();
     }
     
-    // 遍历节点，确定布局
-    for (Node* node : execution_order) {
-        MemoryLayout preferred_layout = MemoryLayout::NCHW;
-        std::string op_type = node->GetOpType();
+    bool Changed() const { return counter_ > 0 || !blocked_.empty(); }
+
+private:
+    bool RewriteConv(Node* node) {
+        const auto& inputs = node->GetInputs();
+        Value* x = inputs[0];
+        Value* weight = inputs.size() > 1 ? inputs[1] : nullptr;
+        if (!IsNchwValue(x) || !weight || !fusion::IsConstant(*graph_, weight) ||
+            weight->GetDataType() != DataType::FLOAT32 || weight->GetShape().dims.size() != 4) {
+            return false;
+        }
+        const AttributeValue* group = node->FindAttribute("group");
+        const AttributeValue* algorithm = node->FindAttribute("conv_algorithm");
+        if ((group && group->GetType() == AttributeValue::Type::INT && group->GetInt() != 1) ||
+            (algorithm && algorithm->ToString() != "auto")) {
+            return false;
+        }
+        // 输出通道太少时补齐的浪费超过收益
+        const int64_t out_c = weight->GetShape().dims[0];
+        if (out_c < block_) {
+            return false;
+        }
         
-        // 根据算子类型确定偏好布局
-        if (op_type == "Conv" || op_type == "MaxPool" || op_type == "AvgPool" ||
-            op_type == "BatchNormalization") {
-            preferred_layout = MemoryLayout::NCHW;
-        } else if (op_type == "MatMul" || op_type == "Gemm") {
-            // 矩阵乘法对布局不敏感，但保持输入布局
-            if (!node->GetInputs().empty()) {
-                preferred_layout = value_layouts[node->GetInputs()[0]];
-            }
-        } else {
-            // 其他算子保持输入布局
-            if (!node->GetInputs().empty()) {
-                preferred_layout = value_layouts[node->GetInputs()[0]];
+        const bool fuse_sum = node->GetOpType() == "FusedConvAddReLU";
+        if (fuse_sum) {
+            Value* residual = inputs.back();
+            if (inputs.size() < 3 || residual == x || !IsNchwValue(residual)) {
+                return false;
             }
+            node->ReplaceInput(residual, Blocked(residual));
+            node->SetAttribute("fuse_sum", AttributeValue(static_cast<int64_t>(1)));
         }
+        if (node->GetOpType() != "Conv") {
+            node->SetAttribute("activation", AttributeValue(std::string("Relu")));
+        }
+        Retarget(node, "NchwcConv", {0});
+        return true;
+    }
+    
+    // 把input_slots上的输入换成分块版本，节点改为op_type并输出分块值
+    void Retarget(Node* node, const std::string& op_type, const std::vector<size_t>& input_slots) {
+        for (size_t slot : input_slots) {
+            Value* input = node->GetInputs()[slot];
+            node->ReplaceInput(input, Blocked(input));
+        }
+        node->SetOpType(op_type);
         
-        node_layouts[node] = preferred_layout;
-        
-        // 设置输出布局
-        for (Value* output : node->GetOutputs()) {
-            value_layouts[output] = preferred_layout;
+        Value* output = node->GetOutputs()[0];
+        Value* blocked = graph_->AddValue();
+        blocked->SetName(output->GetName() + "_nchwc");
+        node->RemoveOutput(output);
+        node->AddOutput(blocked);
+        blocked_[output] = blocked;
+        channels_[output] = output->GetShape().dims[1];
+        detached_.insert(output);
+    }
+    
+    // 值的分块版本，第一次需要时插入ReorderInput
+    Value* Blocked(Value* value) {
+        auto it = blocked_.find(value);
+        if (it != blocked_.end()) {
+            return it->second;
+        }
+        // 只给当前节点使用的图像预处理结果：预处理直接写出分块布局，省去ReorderInput
+        Node* producer = value->GetProducer();
+        if (producer && producer->GetOpType() == "ImagePreprocess" && value->GetConsumers().size() == 1 &&
+            producer->GetAttribute("layout", "NCHW") == "NCHW") {
+            producer->SetAttribute("layout", AttributeValue(std::string("NCHWc")));
+            producer->SetAttribute("block_size", AttributeValue(block_));
+            Value* blocked = graph_->AddValue();
+            blocked->SetName(value->GetName() + "_nchwc");
+            producer->RemoveOutput(value);
+            producer->AddOutput(blocked);
+            blocked_[value] = blocked;
+            channels_[value] = value->GetShape().dims[1];
+            detached_.insert(value);
+            return blocked;
         }
+        Node* reorder = graph_->AddNode("ReorderInput", "nchwc_reorder_input_" + std::to_string(counter_++));
+        reorder->SetAttribute("block_size", AttributeValue(block_));
+        Value* blocked = graph_->AddValue();
+        blocked->SetName(value->GetName() + "_nchwc");
+        reorder->AddInput(value);
+        reorder->AddOutput(blocked);
+        blocked_[value] = blocked;
+        return blocked;
     }
     
-    // 2. 检查布局不匹配，插入Transpose节点
-    std::vector<std::pair<Node*, Value*>> transpose_insertions;
+    Graph* graph_;
+    int64_t block_;
+    int counter_ = 0;
+    std::unordered_map<Value*, Value*> blocked_;      // 逻辑NCHW值 -> 分块布局的值
+    std::unordered_map<Value*, int64_t> channels_;    // 被改写节点输出的逻辑通道数
+    std::unordered_set<Value*> detached_;             // 生产者已改为输出分块值、还没转回NCHW的逻辑值
+};
+
+} // namespace
+
+Status MemoryLayoutOptimizationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    const int64_t block = block_size_ > 0 ? block_size_ : (GetCpuFeatures().avx512f ? 16 : 8);
     
-    for (Node* node : execution_order) {
-        MemoryLayout node_layout = node_layouts[node];
-        
-        // 检查输入布局是否匹配
+    // 按拓扑序决定每个节点的布局：能在分块布局上执行的节点就地改写，
+    // 其余节点用到的分块值先转回NCHW（新插入的转换节点不在遍历范围内）
+    NchwcRewriter rewriter(graph, block);
+    for (Node* node : graph->GetTopologicalOrder()) {
+        if (rewriter.Rewrite(node)) {
+            continue;
+        }
         for (Value* input : node->GetInputs()) {
-            MemoryLayout input_layout = value_layouts[input];
-            
-            if (input_layout != node_layout && input_layout != MemoryLayout::UNKNOWN) {
-                // 需要插入Transpose节点
-                transpose_insertions.push_back({node, input});
-            }
+            rewriter.Materialize(input);
         }
     }
-    
-    // 3. 插入Transpose节点
-    for (const auto& insertion : transpose_insertions) {
-        Node* consumer = insertion.first;
-        Value* input_value = insertion.second;
-        MemoryLayout input_layout = value_layouts[input_value];
-        MemoryLayout target_layout = node_layouts[consumer];
-        
-        // 创建中间Value
-        Value* intermediate = graph->AddValue();
-        
-        // 创建Transpose节点
-        Node* transpose = graph->AddNode("Transpose", "layout_transpose_" + 
-                                        std::to_string(transpose_insertions.size()));
-        // 临时：使用简单的perm值，GetTransposePerm函数在后面定义
-        // transpose->SetAttribute("perm", GetTransposePerm(input_layout, target_layout));
-        // TODO: 实现GetTransposePerm函数或使用其他方式获取perm
-        
-        // 连接：input_value -> transpose -> intermediate -> consumer
-        transpose->AddInput(input_value);
-        transpose->AddOutput(intermediate);
-        
-        // 更新consumer的输入
-        consumer->RemoveInput(input_value);
-        consumer->AddInput(intermediate);
-        
-        // 更新布局
-        value_layouts[intermediate] = target_layout;
+    for (Value* output : graph->GetOutputs()) {
+        rewriter.Materialize(output);
     }
+    rewriter.RemoveUnusedValues();
     
+    // 新插入的值需要形状，供内存规划使用
+    if (rewriter.Changed()) {
+        Status status = InferShapes(graph);
+        (void)status;  // 与会话加载时一样，推断失败只影响内存规划
+    }
     return Status::Ok();
 }
 
-namespace {
-// 辅助函数：获取Transpose的perm参数
-std::string GetTransposePerm(MemoryLayout from, MemoryLayout to) {
-    // 简化实现：NCHW <-> NHWC转换
-    if (from == MemoryLayout::NCHW && to == MemoryLayout::NHWC) {
-        return "0,2,3,1";  // NCHW -> NHWC: [N,C,H,W] -> [N,H,W,C]
-    } else if (from == MemoryLayout::NHWC && to == MemoryLayout::NCHW) {
-        return "0,3,1,2";  // NHWC -> NCHW: [N,H,W,C] -> [N,C,H,W]
-    }
-    return "0,1,2,3";  // 默认：不变
-}
-}
-
 // SubgraphReplacementPass实现
 // 子图替换：识别特定模式并用优化版本替换
 // 参考TVM和ONNX Runtime的子图替换实现
@@ -269,7 +501,7 @@ Status SubgraphReplacementPass::Run(Graph* graph) {
         iteration++;
         
         // 获取拓扑排序的节点列表
-        std::vector<Node*> nodes = graph->TopologicalSort();
+        std::vector<Node*> nodes = graph->GetTopologicalOrder();
         
         // 查找可替换的子图模式
         for (size_t i = 0; i < nodes.size(); ++i) {
@@ -330,7 +562,7 @@ Status SubgraphReplacementPass::Run(Graph* graph) {
 
 // 辅助函数：检查张量是否全为0
 bool SubgraphReplacementPass::IsZeroTensor(Tensor* tensor) const {
-    if (!tensor || tensor->GetDataType() != DataType::FLOAT32) {
+    if (!tensor || tensor->GetDataType() != DataType::FLOAT32 || !tensor->GetData()) {
         return false;
     }
     
@@ -1,84 +1,139 @@
-// 性能优化Pass
-// 实现缓存优化、内存对齐、数据布局优化等
+// 性能优化Pass：权重按执行顺序重排与初始化器对齐
+// 参考TensorRT的权重流式布局与MNN/NCNN加载时把权重拷进对齐的连续缓冲：推理时权重按执行顺序被读取一遍，
+// 放在一块地址递增的缓冲里让硬件预取器顺着流读取；每层都会读到的小张量集中放在一起，少占缓存行与TLB项
 
 #include "inferunity/optimizer.h"
 #include "inferunity/graph.h"
+#include "inferunity/logger.h"
 #include "inferunity/tensor.h"
+#include "core/align_utils.h"
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace inferunity {
 
-// 缓存优化Pass
-class CacheOptimizationPass : public OptimizationPass {
-public:
-    std::string GetName() const override { return "CacheOptimization"; }
-    
-    Status Run(Graph* graph) override {
-        if (!graph) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
-        }
-        
-        // 优化数据布局以提高缓存命中率
-        // 1. 分析内存访问模式
-        // 2. 重新排列数据以提高局部性
-        // 3. 优化tensor的内存对齐
-        
-        // 简化实现：确保所有tensor使用对齐的内存
-        for (const auto& value : graph->GetValues()) {
-            if (value->GetTensor()) {
-                auto tensor = value->GetTensor();
-                // 检查内存对齐（简化：假设CreateTensor已经对齐）
-                // 实际可以添加更复杂的对齐检查
+namespace {
+
+// 一条缓存行，同时满足AVX-512的对齐加载
+constexpr size_t kInitializerAlignment = 64;
+
+bool IsAligned(const void* data) {
+    return reinterpret_cast<uintptr_t>(data) % kInitializerAlignment == 0;
+}
+
+// 可以换一块存储的常量：CPU上连续、有数据的非字符串张量
+bool IsRelocatable(const Tensor* tensor) {
+    return tensor && tensor->GetData() && tensor->GetDeviceType() == DeviceType::CPU && tensor->IsContiguous() &&
+           tensor->GetDataType() != DataType::STRING && tensor->GetSizeInBytes() > 0;
+}
+
+// 节点读取的常量初始化器，按执行顺序首次使用的先后排列；同一张量对象只出现一次
+std::vector<std::shared_ptr<Tensor>> InitializersInExecutionOrder(const Graph& graph) {
+    std::unordered_set<const Value*> graph_inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    std::unordered_set<const Tensor*> seen;
+    std::vector<std::shared_ptr<Tensor>> order;
+    for (Node* node : graph.TopologicalSort()) {
+        for (Value* input : node->GetInputs()) {
+            if (!input || input->GetProducer() || graph_inputs.count(input)) {
+                continue;
+            }
+            std::shared_ptr<Tensor> tensor = input->GetTensor();
+            if (IsRelocatable(tensor.get()) && seen.insert(tensor.get()).second) {
+                order.push_back(tensor);
             }
         }
-        
-        return Status::Ok();
     }
-};
+    return order;
+}
 
-// 内存对齐优化Pass
-class MemoryAlignmentPass : public OptimizationPass {
-public:
-    std::string GetName() const override { return "MemoryAlignment"; }
-    
-    Status Run(Graph* graph) override {
-        if (!graph) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+// 把tensors按offsets拷进一块新分配的对齐缓冲（total字节），各张量换成缓冲上的视图；
+// 视图持有整块缓冲，所有视图释放后缓冲才释放
+Status Relocate(Graph* graph, const std::vector<std::shared_ptr<Tensor>>& tensors,
+                const std::vector<size_t>& offsets, size_t total) {
+    auto block = CreateTensor(Shape({static_cast<int64_t>(total + kInitializerAlignment)}), DataType::UINT8);
+    if (!block || !block->GetData()) {
+        return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Cannot allocate the initializer block");
+    }
+    uint8_t* base = static_cast<uint8_t*>(block->GetData());
+    base += AlignUp(reinterpret_cast<uintptr_t>(base), kInitializerAlignment) - reinterpret_cast<uintptr_t>(base);
+    std::unordered_map<const Tensor*, std::shared_ptr<Tensor>> replacement;
+    for (size_t i = 0; i < tensors.size(); ++i) {
+        const Tensor& source = *tensors[i];
+        uint8_t* data = base + offsets[i];
+        std::memcpy(data, source.GetData(), source.GetSizeInBytes());
+        // 与CreateStridedView相同，删除器捕获整块缓冲
+        replacement.emplace(&source, std::shared_ptr<Tensor>(
+            new Tensor(source.GetShape(), source.GetDataType(), data, source.GetLayout(), DeviceType::CPU),
+            [block](Tensor* view) { delete view; }));
+    }
+    for (const auto& value : graph->GetValues()) {
+        if (!value || !value->GetTensor()) {
+            continue;
+        }
+        auto it = replacement.find(value->GetTensor().get());
+        if (it != replacement.end()) {
+            value->SetTensor(it->second);
         }
-        
-        // 确保所有tensor使用对齐的内存（64字节对齐，适合AVX）
-        // 这已经在AllocateMemory中实现，这里主要是验证
-        
-        return Status::Ok();
     }
-};
+    return Status::Ok();
+}
 
-// 数据布局优化Pass（优化内存访问模式）
-class DataLayoutOptimizationPass : public OptimizationPass {
-public:
-    std::string GetName() const override { return "DataLayoutOptimization"; }
+} // namespace
+
+Status CacheOptimizationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    std::vector<std::shared_ptr<Tensor>> order = InitializersInExecutionOrder(*graph);
+    if (order.empty()) {
+        return Status::Ok();
+    }
     
-    Status Run(Graph* graph) override {
-        if (!graph) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
-        }
-        
-        // 分析数据访问模式，优化布局
-        // 1. 识别热点数据
-        // 2. 将频繁访问的数据放在一起
-        // 3. 优化tensor的内存布局（NCHW vs NHWC）
-        
-        // 简化实现：标记需要优化的节点
-        for (const auto& node : graph->GetNodes()) {
-            // 对于Conv等算子，确保使用NCHW布局
-            if (node->GetOpType() == "Conv" || node->GetOpType() == "MaxPool") {
-                // 可以在这里添加布局优化逻辑
-            }
+    // 小张量在前、大权重在后，各自保持执行顺序；每个张量从缓存行边界开始
+    std::stable_partition(order.begin(), order.end(), [this](const std::shared_ptr<Tensor>& tensor) {
+        return tensor->GetSizeInBytes() <= small_tensor_bytes_;
+    });
+    std::vector<size_t> offsets;
+    offsets.reserve(order.size());
+    size_t total = 0;
+    for (const auto& tensor : order) {
+        offsets.push_back(total);
+        total = AlignUp(total + tensor->GetSizeInBytes(), kInitializerAlignment);
+    }
+    Status status = Relocate(graph, order, offsets, total);
+    if (status.IsOk()) {
+        LOG_INFO("Initializers laid out in execution order: " + std::to_string(order.size()) + " tensors, " +
+                 std::to_string(total) + " bytes");
+    }
+    return status;
+}
+
+Status MemoryAlignmentPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    std::vector<std::shared_ptr<Tensor>> misaligned;
+    for (const auto& tensor : InitializersInExecutionOrder(*graph)) {
+        if (!IsAligned(tensor->GetData())) {
+            misaligned.push_back(tensor);
         }
-        
+    }
+    if (misaligned.empty()) {
         return Status::Ok();
     }
-};
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (const auto& tensor : misaligned) {
+        offsets.push_back(total);
+        total = AlignUp(total + tensor->GetSizeInBytes(), kInitializerAlignment);
+    }
+    return Relocate(graph, misaligned, offsets, total);
+}
 
 } // namespace inferunity
@@ -0,0 +1,323 @@
+// Q/DQ折叠Pass实现
+// 参考ONNX Runtime的QDQ SelectorActionTransformer（QDQPropagation/QDQSelectorActionTransformer）：
+// QDQ格式的图在浮点算子两侧带DequantizeLinear/QuantizeLinear，改写为直接读写量化张量的整数算子，
+// 省去激活的反量化-再量化往返
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+namespace inferunity {
+
+using fusion::Match;
+
+namespace {
+
+bool IsQuantizedType(DataType dtype) {
+    return dtype == DataType::INT8 || dtype == DataType::UINT8;
+}
+
+// 量化参数常量：scale为FLOAT32，zero_point（可缺省）为INT8/UINT8，元素个数相同
+bool IsQuantParams(const Graph& graph, const Node& node, size_t* count) {
+    const auto& inputs = node.GetInputs();
+    if (inputs.size() != 2 && inputs.size() != 3) {
+        return false;
+    }
+    const Value* scale = inputs[1];
+    if (!fusion::IsConstant(graph, scale) || scale->GetDataType() != DataType::FLOAT32) {
+        return false;
+    }
+    *count = scale->GetTensor()->GetElementCount();
+    if (inputs.size() == 3) {
+        const Value* zero_point = inputs[2];
+        return fusion::IsConstant(graph, zero_point) && IsQuantizedType(zero_point->GetDataType()) &&
+               zero_point->GetTensor()->GetElementCount() == *count;
+    }
+    return true;
+}
+
+int64_t QuantizeAxisOf(const Node& node, size_t rank) {
+    int64_t axis = 1;
+    const AttributeValue* attr = node.FindAttribute("axis");
+    if (attr && attr->GetType() == AttributeValue::Type::INT) {
+        axis = attr->GetInt();
+    }
+    return axis < 0 ? axis + static_cast<int64_t>(rank) : axis;
+}
+
+// value由按张量量化的DequantizeLinear产生
+Node* ScalarDequantize(const Graph& graph, const Value* value) {
+    Node* dq = value->GetProducer();
+    size_t count = 0;
+    if (!dq || dq->GetOpType() != "DequantizeLinear" || !IsQuantParams(graph, *dq, &count) || count != 1) {
+        return nullptr;
+    }
+    return dq;
+}
+
+// 常量权重的DequantizeLinear：rank维INT8/UINT8常量，scale为单个值或沿axis按通道
+Node* WeightDequantize(const Graph& graph, const Value* value, size_t rank, int64_t axis) {
+    Node* dq = value->GetProducer();
+    size_t count = 0;
+    if (!dq || dq->GetOpType() != "DequantizeLinear" || !IsQuantParams(graph, *dq, &count)) {
+        return nullptr;
+    }
+    const Value* weight = dq->GetInputs()[0];
+    if (!fusion::IsConstant(graph, weight) || !IsQuantizedType(weight->GetDataType()) ||
+        weight->GetShape().dims.size() != rank) {
+        return nullptr;
+    }
+    if (count != 1 && (QuantizeAxisOf(*dq, rank) != axis ||
+                       static_cast<int64_t>(count) != weight->GetShape().dims[axis])) {
+        return nullptr;
+    }
+    return dq;
+}
+
+// 根QuantizeLinear按张量量化
+bool IsScalarQuantize(const Graph& graph, const Node& q) {
+    size_t count = 0;
+    return IsQuantParams(graph, q, &count) && count == 1;
+}
+
+bool SameConstant(const Graph& graph, const Value* a, const Value* b) {
+    if (a == b) {
+        return true;
+    }
+    if (!a || !b || !fusion::IsConstant(graph, a) || !fusion::IsConstant(graph, b)) {
+        return false;
+    }
+    auto ta = a->GetTensor();
+    auto tb = b->GetTensor();
+    return ta->GetDataType() == tb->GetDataType() && ta->GetElementCount() == tb->GetElementCount() &&
+           std::memcmp(ta->GetData(), tb->GetData(), ta->GetSizeInBytes()) == 0;
+}
+
+// 缺省的零点为UINT8的0（ONNX的约定）
+Value* ZeroPointOf(Graph* graph, Node* node) {
+    if (node->GetInputs().size() == 3) {
+        return node->GetInputs()[2];
+    }
+    auto tensor = CreateTensor(Shape({1}), DataType::UINT8, DeviceType::CPU);
+    static_cast<uint8_t*>(tensor->GetData())[0] = 0;
+    return fusion::AddConstant(graph, tensor, node->GetName() + "_zero_point");
+}
+
+// 整数算子的输入不能重复（如x与y共用同一个scale常量）：重复的常量换成共享同一Tensor的新值
+bool MakeDistinct(Graph* graph, std::vector<Value*>* inputs) {
+    std::unordered_set<const Value*> seen;
+    for (Value*& input : *inputs) {
+        if (seen.insert(input).second) {
+            continue;
+        }
+        if (!fusion::IsConstant(*graph, input)) {
+            return false;
+        }
+        input = fusion::AddConstant(graph, input->GetTensor(), input->GetName() + "_copy");
+        seen.insert(input);
+    }
+    return true;
+}
+
+// 删除输出不再被使用的DequantizeLinear及其只供它使用的常量
+void RemoveDeadDequantize(Graph* graph, Node* dq) {
+    for (Value* output : dq->GetOutputs()) {
+        if (!output->GetConsumers().empty() || fusion::IsGraphOutput(*graph, output)) {
+            return;
+        }
+    }
+    const std::vector<Value*> inputs = dq->GetInputs();
+    const std::vector<Value*> outputs = dq->GetOutputs();
+    graph->RemoveNode(dq);
+    for (Value* output : outputs) {
+        graph->RemoveValue(output);
+    }
+    for (Value* input : inputs) {
+        if (input->GetConsumers().empty() && fusion::IsConstant(*graph, input) && !fusion::IsGraphOutput(*graph, input)) {
+            graph->RemoveValue(input);
+        }
+    }
+}
+
+// Q(DQ(v))在量化参数相同时就是v：Q的消费者直接使用v
+int EliminateRoundTrips(Graph* graph) {
+    int eliminated = 0;
+    for (Node* q : graph->TopologicalSort()) {
+        if (q->GetOpType() != "QuantizeLinear" || !IsScalarQuantize(*graph, *q) ||
+            fusion::IsGraphOutput(*graph, q->GetOutputs()[0])) {
+            continue;
+        }
+        Node* dq = ScalarDequantize(*graph, q->GetInputs()[0]);
+        if (!dq) {
+            continue;
+        }
+        const Value* q_zp = q->GetInputs().size() == 3 ? q->GetInputs()[2] : nullptr;
+        const Value* dq_zp = dq->GetInputs().size() == 3 ? dq->GetInputs()[2] : nullptr;
+        if (!SameConstant(*graph, q->GetInputs()[1], dq->GetInputs()[1]) ||
+            !SameConstant(*graph, q_zp, dq_zp)) {
+            continue;
+        }
+        Value* source = dq->GetInputs()[0];
+        Value* quantized = q->GetOutputs()[0];
+        const std::vector<Node*> consumers = quantized->GetConsumers();
+        for (Node* consumer : consumers) {
+            consumer->ReplaceInput(quantized, source);
+        }
+        const std::vector<Value*> params(q->GetInputs().begin() + 1, q->GetInputs().end());
+        graph->RemoveNode(q);
+        graph->RemoveValue(quantized);
+        for (Value* param : params) {
+            if (param->GetConsumers().empty()) {
+                graph->RemoveValue(param);
+            }
+        }
+        RemoveDeadDequantize(graph, dq);
+        ++eliminated;
+    }
+    return eliminated;
+}
+
+// ---- Conv/MatMul ----
+
+Node* ComputeNode(const Match& match) {
+    return match.nodes.back();
+}
+
+bool CanFuseConv(const Graph& graph, const Match& match) {
+    const Node* conv = ComputeNode(match);
+    const auto& inputs = conv->GetInputs();
+    if (!IsScalarQuantize(graph, *match.Root()) || !ScalarDequantize(graph, inputs[0])) {
+        return false;
+    }
+    Node* w_dq = WeightDequantize(graph, inputs[1], 4, 0);
+    if (!w_dq || w_dq == inputs[0]->GetProducer()) {
+        return false;
+    }
+    if (inputs.size() == 3) {
+        const Value* bias = inputs[2];
+        const int64_t out_c = w_dq->GetInputs()[0]->GetShape().dims[0];
+        return fusion::IsConstant(graph, bias) && bias->GetDataType() == DataType::FLOAT32 &&
+               static_cast<int64_t>(bias->GetTensor()->GetElementCount()) == out_c;
+    }
+    return true;
+}
+
+bool CanFuseMatMul(const Graph& graph, const Match& match) {
+    const Node* matmul = ComputeNode(match);
+    const auto& inputs = matmul->GetInputs();
+    if (!IsScalarQuantize(graph, *match.Root()) || !ScalarDequantize(graph, inputs[0])) {
+        return false;
+    }
+    Node* b_dq = WeightDequantize(graph, inputs[1], 2, 1);
+    return b_dq && b_dq != inputs[0]->GetProducer();
+}
+
+// 浮点bias -> INT32：b / (x_scale * w_scale[c])
+std::shared_ptr<Tensor> QuantizeBias(const Value* bias, float x_scale, const Value* w_scale) {
+    const size_t count = bias->GetTensor()->GetElementCount();
+    const size_t scale_count = w_scale->GetTensor()->GetElementCount();
+    const float* b = static_cast<const float*>(bias->GetTensor()->GetData());
+    const float* ws = static_cast<const float*>(w_scale->GetTensor()->GetData());
+    auto tensor = CreateTensor(Shape({static_cast<int64_t>(count)}), DataType::INT32, DeviceType::CPU);
+    int32_t* q = static_cast<int32_t*>(tensor->GetData());
+    for (size_t c = 0; c < count; ++c) {
+        const double scale = static_cast<double>(x_scale) * ws[scale_count == 1 ? 0 : c];
+        q[c] = scale > 0.0 ? static_cast<int32_t>(std::nearbyint(b[c] / scale)) : 0;
+    }
+    return tensor;
+}
+
+// 量化输入x, x_scale, x_zero_point, w, w_scale, w_zero_point, y_scale, y_zero_point[, bias]后替换子图
+Status FuseQuantized(Graph* graph, const Match& match, const std::string& op_type,
+                     const NodeAttributes& attributes) {
+    Node* q = match.Root();
+    Node* compute = ComputeNode(match);
+    Node* x_dq = compute->GetInputs()[0]->GetProducer();
+    Node* w_dq = compute->GetInputs()[1]->GetProducer();
+    Value* bias = compute->GetInputs().size() == 3 ? compute->GetInputs()[2] : nullptr;
+    
+    std::vector<Value*> inputs = {
+        x_dq->GetInputs()[0], x_dq->GetInputs()[1], ZeroPointOf(graph, x_dq),
+        w_dq->GetInputs()[0], w_dq->GetInputs()[1], ZeroPointOf(graph, w_dq),
+        q->GetInputs()[1], ZeroPointOf(graph, q),
+    };
+    if (bias) {
+        const float x_scale = *static_cast<const float*>(x_dq->GetInputs()[1]->GetTensor()->GetData());
+        inputs.push_back(fusion::AddConstant(graph, QuantizeBias(bias, x_scale, w_dq->GetInputs()[1]),
+                                     compute->GetName() + "_quantized_bias"));
+    }
+    if (!MakeDistinct(graph, &inputs) || !fusion::ReplaceMatch(graph, match, op_type, inputs, attributes)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Cannot fuse quantized " + op_type);
+    }
+    
+    if (bias && bias->GetConsumers().empty() && !fusion::IsGraphOutput(*graph, bias)) {
+        graph->RemoveValue(bias);
+    }
+    RemoveDeadDequantize(graph, x_dq);
+    RemoveDeadDequantize(graph, w_dq);
+    return Status::Ok();
+}
+
+Status FuseConv(Graph* graph, const Match& match) {
+    NodeAttributes attributes = ComputeNode(match)->GetAttributes();
+    if (match.nodes.size() == 3) {
+        attributes["activation"] = AttributeValue(std::string("Relu"));
+    }
+    return FuseQuantized(graph, match, "QLinearConv", attributes);
+}
+
+Status FuseMatMul(Graph* graph, const Match& match) {
+    return FuseQuantized(graph, match, "QLinearMatMul", {});
+}
+
+bool HasConvInputs(const Node& conv) {
+    return conv.GetInputs().size() == 2 || conv.GetInputs().size() == 3;
+}
+
+} // anonymous namespace
+
+Status QDQFusionPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    
+    EliminateRoundTrips(graph);
+    
+    fusion::FusionRule conv_relu;
+    conv_relu.pattern.name = "QDQConvRelu";
+    conv_relu.pattern.nodes = {
+        {{"QuantizeLinear"}, -1, {{0, 1}}, nullptr},
+        {{"Relu"}, 1, {{0, 2}}, nullptr},
+        {{"Conv"}, -1, {}, HasConvInputs},
+    };
+    conv_relu.pattern.constraint = CanFuseConv;
+    conv_relu.rewrite = FuseConv;
+    
+    fusion::FusionRule conv;
+    conv.pattern.name = "QDQConv";
+    conv.pattern.nodes = {
+        {{"QuantizeLinear"}, -1, {{0, 1}}, nullptr},
+        {{"Conv"}, -1, {}, HasConvInputs},
+    };
+    conv.pattern.constraint = CanFuseConv;
+    conv.rewrite = FuseConv;
+    
+    fusion::FusionRule matmul;
+    matmul.pattern.name = "QDQMatMul";
+    matmul.pattern.nodes = {
+        {{"QuantizeLinear"}, -1, {{0, 1}}, nullptr},
+        {{"MatMul"}, 2, {}, nullptr},
+    };
+    matmul.pattern.constraint = CanFuseMatMul;
+    matmul.rewrite = FuseMatMul;
+    
+    fusion::ApplyFusionRules(graph, {conv_relu, conv, matmul});
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,246 @@
+// 稀疏权重Pass实现
+// 加载时统计MatMul常量权重的密度，低于阈值的改写为SparseMatMul（格式见src/operators/sparse_matmul.cpp）：
+// 满足2:4结构的权重可直接按2:4存放；块稀疏CSR按8x1与4x1块分别计算存储量，
+// 取权重与索引总字节数最少的格式，不比稠密FP32省内存时保持原样
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+struct SparseEncoding {
+    std::string format;  // "block"或"2:4"
+    int64_t block_size = 0;
+    std::shared_ptr<Tensor> values;
+    std::shared_ptr<Tensor> indices;
+    std::shared_ptr<Tensor> row_ptr;  // 仅block
+};
+
+// weight为[K, N]：B^T第n行中第k列所在的block x 1块是否含非零元素
+int64_t CountNonZeroBlocks(const float* w, int64_t K, int64_t N, int64_t block) {
+    int64_t count = 0;
+    for (int64_t n0 = 0; n0 < N; n0 += block) {
+        const int64_t n1 = std::min(N, n0 + block);
+        for (int64_t k = 0; k < K; ++k) {
+            for (int64_t n = n0; n < n1; ++n) {
+                if (w[k * N + n] != 0.0f) {
+                    ++count;
+                    break;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// B^T每行沿K每4个元素至多2个非零
+bool Is2of4(const float* w, int64_t K, int64_t N) {
+    if (K % 4 != 0) {
+        return false;
+    }
+    for (int64_t k0 = 0; k0 < K; k0 += 4) {
+        for (int64_t n = 0; n < N; ++n) {
+            int nonzero = 0;
+            for (int64_t k = k0; k < k0 + 4; ++k) {
+                nonzero += w[k * N + n] != 0.0f;
+            }
+            if (nonzero > 2) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+SparseEncoding EncodeBlockSparse(const float* w, int64_t K, int64_t N, int64_t block, int64_t nnz_blocks) {
+    const int64_t block_rows = (N + block - 1) / block;
+    SparseEncoding encoding;
+    encoding.format = "block";
+    encoding.block_size = block;
+    encoding.values = CreateTensor(Shape({nnz_blocks, block}), DataType::FLOAT32, DeviceType::CPU);
+    encoding.indices = CreateTensor(Shape({nnz_blocks}), DataType::INT32, DeviceType::CPU);
+    encoding.row_ptr = CreateTensor(Shape({block_rows + 1}), DataType::INT32, DeviceType::CPU);
+    float* values = static_cast<float*>(encoding.values->GetData());
+    int32_t* columns = static_cast<int32_t*>(encoding.indices->GetData());
+    int32_t* row_ptr = static_cast<int32_t*>(encoding.row_ptr->GetData());
+    int64_t e = 0;
+    row_ptr[0] = 0;
+    for (int64_t j = 0; j < block_rows; ++j) {
+        const int64_t n0 = j * block;
+        const int64_t n1 = std::min(N, n0 + block);
+        for (int64_t k = 0; k < K; ++k) {
+            bool nonzero = false;
+            for (int64_t n = n0; n < n1; ++n) {
+                nonzero = nonzero || w[k * N + n] != 0.0f;
+            }
+            if (!nonzero) {
+                continue;
+            }
+            // N不足一个块时末块补零
+            for (int64_t i = 0; i < block; ++i) {
+                values[e * block + i] = n0 + i < n1 ? w[k * N + n0 + i] : 0.0f;
+            }
+            columns[e++] = static_cast<int32_t>(k);
+        }
+        row_ptr[j + 1] = static_cast<int32_t>(e);
+    }
+    return encoding;
+}
+
+SparseEncoding Encode2of4(const float* w, int64_t K, int64_t N) {
+    SparseEncoding encoding;
+    encoding.format = "2:4";
+    encoding.values = CreateTensor(Shape({N, K / 2}), DataType::FLOAT32, DeviceType::CPU);
+    encoding.indices = CreateTensor(Shape({N, K / 2}), DataType::UINT8, DeviceType::CPU);
+    float* values = static_cast<float*>(encoding.values->GetData());
+    uint8_t* indices = static_cast<uint8_t*>(encoding.indices->GetData());
+    for (int64_t n = 0; n < N; ++n) {
+        for (int64_t g = 0; g < K / 4; ++g) {
+            // 非零不足2个时用值为0的位置补齐
+            int64_t slot = n * (K / 2) + 2 * g;
+            int64_t filled = 0;
+            for (int64_t i = 0; i < 4 && filled < 2; ++i) {
+                const bool keep = w[(4 * g + i) * N + n] != 0.0f || 4 - i <= 2 - filled;
+                if (keep) {
+                    values[slot] = w[(4 * g + i) * N + n];
+                    indices[slot] = static_cast<uint8_t>(i);
+                    ++slot;
+                    ++filled;
+                }
+            }
+        }
+    }
+    return encoding;
+}
+
+// 融合Pass折叠进MatMul/FusedMatMulAdd的transA/transB与alpha均为缺省值
+bool HasPlainGemmAttributes(const Node& node) {
+    if (node.GetAttribute("transA", "0") != "0" || node.GetAttribute("transB", "0") != "0") {
+        return false;
+    }
+    const AttributeValue* alpha = node.FindAttribute("alpha");
+    if (!alpha) {
+        return true;
+    }
+    return (alpha->GetType() == AttributeValue::Type::FLOAT && alpha->GetFloat() == 1.0f) ||
+           (alpha->GetType() == AttributeValue::Type::INT && alpha->GetInt() == 1);
+}
+
+// MatMul或FusedMatMulAdd（激活随节点保留），B为二维FLOAT32常量，bias（如有）为[N]的FLOAT32常量
+bool IsSparsifiableMatMul(const Graph& graph, const Node& node) {
+    const std::string& type = node.GetOpType();
+    const auto& inputs = node.GetInputs();
+    if ((type != "MatMul" || inputs.size() != 2) && (type != "FusedMatMulAdd" || inputs.size() != 3)) {
+        return false;
+    }
+    if (!HasPlainGemmAttributes(node)) {
+        return false;
+    }
+    Value* weight = inputs[1];
+    if (!fusion::IsConstant(graph, weight) || fusion::IsGraphOutput(graph, weight)) {
+        return false;
+    }
+    auto tensor = weight->GetTensor();
+    if (tensor->GetDataType() != DataType::FLOAT32 || tensor->GetShape().dims.size() != 2 ||
+        tensor->GetElementCount() == 0) {
+        return false;
+    }
+    if (inputs.size() == 3) {
+        if (!fusion::IsConstant(graph, inputs[2])) {
+            return false;
+        }
+        auto bias = inputs[2]->GetTensor();
+        if (bias->GetDataType() != DataType::FLOAT32 || bias->GetShape().dims.size() != 1 ||
+            bias->GetShape().dims[0] != tensor->GetShape().dims[1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+Status SparseWeightPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    if (!(density_threshold_ > 0.0f && density_threshold_ <= 1.0f)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "SparseWeight density threshold must be in (0, 1]");
+    }
+    
+    for (const auto& node : graph->GetNodes()) {
+        if (!IsSparsifiableMatMul(*graph, *node)) {
+            continue;
+        }
+        const std::vector<Value*> inputs = node->GetInputs();
+        Value* weight = inputs[1];
+        const int64_t K = weight->GetTensor()->GetShape().dims[0];
+        const int64_t N = weight->GetTensor()->GetShape().dims[1];
+        const float* w = static_cast<const float*>(weight->GetTensor()->GetData());
+        const int64_t total = K * N;
+        const int64_t nnz = total - std::count(w, w + total, 0.0f);
+        if (static_cast<double>(nnz) >= static_cast<double>(density_threshold_) * total) {
+            continue;
+        }
+    
+        // 各格式的字节数：块稀疏每块block个FP32与一个INT32列号，2:4每个保留的权重一个FP32与一个字节偏移
+        const int64_t dense_bytes = total * 4;
+        int64_t best_bytes = dense_bytes;
+        int64_t best_block = 0;
+        int64_t best_blocks = 0;
+        for (int64_t block : {8, 4}) {
+            const int64_t blocks = CountNonZeroBlocks(w, K, N, block);
+            const int64_t bytes = blocks * (block + 1) * 4 + ((N + block - 1) / block + 1) * 4;
+            if (bytes < best_bytes) {
+                best_bytes = bytes;
+                best_block = block;
+                best_blocks = blocks;
+            }
+        }
+        const bool use_2of4 = total / 2 * 5 < best_bytes && Is2of4(w, K, N);
+        if (!use_2of4 && best_block == 0) {
+            continue;
+        }
+        SparseEncoding encoding = use_2of4 ? Encode2of4(w, K, N)
+                                           : EncodeBlockSparse(w, K, N, best_block, best_blocks);
+        const std::string prefix = weight->GetName().empty() ? node->GetName() + "_weight" : weight->GetName();
+    
+        // 输入改为A, values, indices[, row_ptr][, bias]；2:4没有row_ptr时由input_slots标出bias的位置
+        for (Value* input : inputs) {
+            node->RemoveInput(input);
+        }
+        node->AddInput(inputs[0]);
+        node->AddInput(fusion::AddConstant(graph, encoding.values, prefix + "_sparse_values"));
+        node->AddInput(fusion::AddConstant(graph, encoding.indices, prefix + "_sparse_indices"));
+        std::vector<int64_t> slots = {0, 1, 2};
+        if (encoding.row_ptr) {
+            node->AddInput(fusion::AddConstant(graph, encoding.row_ptr, prefix + "_sparse_row_ptr"));
+            slots.push_back(3);
+        }
+        if (inputs.size() == 3) {
+            node->AddInput(inputs[2]);
+            slots.push_back(4);
+        }
+        node->SetAttribute("input_slots", AttributeValue(slots));
+        node->SetOpType("SparseMatMul");
+        node->SetAttribute("K", AttributeValue(K));
+        node->SetAttribute("N", AttributeValue(N));
+        node->SetAttribute("sparse_format", AttributeValue(encoding.format));
+        if (encoding.block_size > 0) {
+            node->SetAttribute("block_size", AttributeValue(encoding.block_size));
+        }
+        if (weight->GetConsumers().empty()) {
+            graph->RemoveValue(weight);
+        }
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
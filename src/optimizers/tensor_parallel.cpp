@@ -0,0 +1,497 @@
+// 张量并行切分Pass实现
+// 参考Megatron-LM的ColumnParallelLinear/RowParallelLinear：注意力的Q/K/V投影与MLP的第一层按列切分，
+// 各rank只计算自己的头或中间通道；输出投影与MLP的第二层按行切分，部分和经AllReduce合并。
+// 沿数据流记录每个值被切分的轴，不能分片执行的算子之前用AllGather还原完整张量
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+const std::unordered_set<std::string>& ElementwiseOps() {
+    static const std::unordered_set<std::string> ops = {
+        "Add", "Sub", "Mul", "Div", "Pow", "Max", "Min",
+        "Relu", "LeakyRelu", "Gelu", "Silu", "Sigmoid", "Tanh", "Erf", "Exp", "Sqrt", "Reciprocal",
+        "Neg", "Abs", "Softplus", "HardSigmoid", "HardSwish", "Clip", "Cast", "Identity",
+    };
+    return ops;
+}
+
+const std::vector<int64_t>* GetDims(const Value* value) {
+    auto tensor = value->GetTensor();
+    return tensor ? &tensor->GetShape().dims : nullptr;
+}
+
+// [begin, end)范围内各维的乘积，含未知维度时返回false
+bool KnownProduct(const std::vector<int64_t>& dims, size_t begin, size_t end, int64_t* product) {
+    *product = 1;
+    for (size_t i = begin; i < end; ++i) {
+        if (dims[i] <= 0) {
+            return false;
+        }
+        *product *= dims[i];
+    }
+    return true;
+}
+
+// 沿axis取第rank个分片
+std::shared_ptr<Tensor> SliceTensor(const Tensor& source, int64_t axis, int world_size, int rank) {
+    std::vector<int64_t> dims = source.GetShape().dims;
+    const int64_t full = dims[axis];
+    const int64_t chunk = full / world_size;
+    dims[axis] = chunk;
+    auto slice = CreateTensor(Shape(dims), source.GetDataType(), DeviceType::CPU);
+    size_t outer = 1;
+    for (int64_t i = 0; i < axis; ++i) {
+        outer *= static_cast<size_t>(dims[i]);
+    }
+    const size_t inner = source.GetSizeInBytes() / outer / static_cast<size_t>(full);
+    const uint8_t* src = static_cast<const uint8_t*>(source.GetData());
+    uint8_t* dst = static_cast<uint8_t*>(slice->GetData());
+    for (size_t o = 0; o < outer; ++o) {
+        std::memcpy(dst + o * chunk * inner, src + (o * full + rank * chunk) * inner, chunk * inner);
+    }
+    return slice;
+}
+
+class Sharder {
+public:
+    Sharder(Graph* graph, int world_size, int rank, int64_t group_id)
+        : graph_(graph), world_size_(world_size), rank_(rank), group_id_(group_id) {}
+
+    void Run() {
+        for (Node* node : graph_->GetTopologicalOrder()) {
+            bool has_sharded_input = false;
+            for (Value* input : node->GetInputs()) {
+                has_sharded_input = has_sharded_input || IsSharded(input);
+            }
+            if (!has_sharded_input) {
+                TryColumnParallel(node);
+                continue;
+            }
+            if (!Propagate(node)) {
+                GatherInputs(node);
+            }
+        }
+        // 图输出总是完整张量，沿用原来的输出名
+        const std::vector<Value*> outputs = graph_->GetOutputs();
+        for (Value* output : outputs) {
+            if (!IsSharded(output)) {
+                continue;
+            }
+            Value* gathered = Gather(output);
+            const std::string name = output->GetName();
+            output->SetName(name + "_shard");
+            gathered->SetName(name);
+            graph_->ReplaceOutput(output, gathered);
+        }
+        // 分片值的形状改为分片后的形状（加载时的形状推断会再确认一遍）
+        for (const auto& entry : sharded_) {
+            Value* value = const_cast<Value*>(entry.first);
+            auto tensor = value->GetTensor();
+            if (!tensor || !value->GetProducer()) {
+                continue;
+            }
+            std::vector<int64_t> dims = tensor->GetShape().dims;
+            if (dims[entry.second] > 0) {
+                dims[entry.second] /= world_size_;
+            }
+            value->SetTensor(std::make_shared<Tensor>(Shape(dims), tensor->GetDataType(), nullptr));
+        }
+    }
+
+private:
+    bool IsSharded(const Value* value) const { return sharded_.count(value) != 0; }
+
+    int64_t Rank(const Value* value) const {
+        const std::vector<int64_t>* dims = GetDims(value);
+        return dims ? static_cast<int64_t>(dims->size()) : -1;
+    }
+
+    bool Divisible(int64_t dim) const { return dim >= world_size_ && dim % world_size_ == 0; }
+
+    // node的输入constant换成沿axis切出的本rank分片
+    void ShardConstant(Node* node, Value* constant, int64_t axis) {
+        Value* slice = graph_->AddValue();
+        slice->SetName(constant->GetName().empty() ? "" : constant->GetName() + "_tp" + std::to_string(rank_));
+        slice->SetTensor(SliceTensor(*constant->GetTensor(), axis, world_size_, rank_));
+        node->ReplaceInput(constant, slice);
+        RemoveIfUnused(constant);
+    }
+
+    void RemoveIfUnused(Value* value) {
+        if (value->GetConsumers().empty() && !fusion::IsGraphOutput(*graph_, value)) {
+            graph_->RemoveValue(value);
+        }
+    }
+
+    Node* AddCollective(const std::string& op_type, Value* input, Value* output) {
+        const int64_t tag = next_tag_++;
+        Node* node = graph_->AddNode(op_type, "tp_" + op_type + "_" + std::to_string(tag));
+        node->AddInput(input);
+        node->AddOutput(output);
+        node->SetAttribute("group_id", AttributeValue(group_id_));
+        node->SetAttribute("rank", AttributeValue(static_cast<int64_t>(rank_)));
+        node->SetAttribute("world_size", AttributeValue(static_cast<int64_t>(world_size_)));
+        node->SetAttribute("tag", AttributeValue(tag));
+        return node;
+    }
+
+    // 分片值的完整张量（同一个值的多个使用者共用一个AllGather）
+    Value* Gather(Value* value) {
+        auto it = gathered_.find(value);
+        if (it != gathered_.end()) {
+            return it->second;
+        }
+        Value* gathered = graph_->AddValue();
+        gathered->SetName(value->GetName().empty() ? "" : value->GetName() + "_gathered");
+        if (auto tensor = value->GetTensor()) {
+            gathered->SetTensor(std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr));
+        }
+        Node* node = AddCollective("AllGather", value, gathered);
+        node->SetAttribute("axis", AttributeValue(sharded_[value]));
+        gathered_[value] = gathered;
+        return gathered;
+    }
+
+    void GatherInputs(Node* node) {
+        const std::vector<Value*> inputs = node->GetInputs();
+        for (Value* input : inputs) {
+            if (IsSharded(input)) {
+                node->ReplaceInput(input, Gather(input));
+            }
+        }
+    }
+
+    // node的输出是各rank的部分和，求和后交给原来的使用者
+    void InsertAllReduce(Node* node) {
+        Value* partial = node->GetOutputs()[0];
+        Value* reduced = graph_->AddValue();
+        if (auto tensor = partial->GetTensor()) {
+            reduced->SetTensor(std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr));
+        }
+        const std::vector<Node*> consumers = partial->GetConsumers();
+        for (Node* consumer : consumers) {
+            consumer->ReplaceInput(partial, reduced);
+        }
+        const std::string name = partial->GetName();
+        if (!name.empty()) {
+            partial->SetName(name + "_partial");
+            reduced->SetName(name);
+        }
+        if (fusion::IsGraphOutput(*graph_, partial)) {
+            graph_->ReplaceOutput(partial, reduced);
+        }
+        AddCollective("AllReduce", partial, reduced);
+    }
+
+    // 常量权重B（transB时为[N, K]）的维度下标
+    bool GetConstantWeight(Node* node, int64_t* k_axis, int64_t* n_axis) const {
+        const std::string& type = node->GetOpType();
+        if ((type != "MatMul" && type != "FusedMatMulAdd") || node->GetOutputs().size() != 1) {
+            return false;
+        }
+        const auto& inputs = node->GetInputs();
+        if (inputs.size() < 2 || !fusion::IsConstant(*graph_, inputs[1]) || Rank(inputs[1]) != 2 ||
+            node->GetAttribute("transA", "0") != "0") {
+            return false;
+        }
+        const bool trans_b = node->GetAttribute("transB", "0") != "0";
+        *k_axis = trans_b ? 1 : 0;
+        *n_axis = trans_b ? 0 : 1;
+        return true;
+    }
+
+    // 列并行：B按输出列切分，[N]的bias随之切分，输出沿最后一维分片
+    void TryColumnParallel(Node* node) {
+        int64_t k_axis, n_axis;
+        if (!GetConstantWeight(node, &k_axis, &n_axis)) {
+            return;
+        }
+        const auto& inputs = node->GetInputs();
+        Value* output = node->GetOutputs()[0];
+        const int64_t n = (*GetDims(inputs[1]))[n_axis];
+        if (!Divisible(n) || Rank(inputs[0]) < 1 || Rank(output) < 1) {
+            return;
+        }
+        Value* bias = inputs.size() > 2 ? inputs[2] : nullptr;
+        if (bias && (!fusion::IsConstant(*graph_, bias) || Rank(bias) != 1 || (*GetDims(bias))[0] != n)) {
+            return;
+        }
+        ShardConstant(node, inputs[1], n_axis);
+        if (bias) {
+            ShardConstant(node, bias, 0);
+        }
+        sharded_[output] = Rank(output) - 1;
+    }
+
+    bool Propagate(Node* node) {
+        const std::string& type = node->GetOpType();
+        if (node->GetOutputs().size() != 1 || !GetDims(node->GetOutputs()[0])) {
+            return false;
+        }
+        if (ElementwiseOps().count(type)) {
+            return PropagateElementwise(node);
+        }
+        if (type == "Transpose") {
+            return PropagateTranspose(node);
+        }
+        if (type == "Reshape") {
+            return PropagateReshape(node);
+        }
+        if (type == "Softmax" || type == "LogSoftmax") {
+            return PropagateSoftmax(node);
+        }
+        if (type == "MatMul" || type == "FusedMatMulAdd") {
+            return PropagateMatMul(node);
+        }
+        return false;
+    }
+
+    // 逐元素算子：各输入按广播对齐后分片轴一致；未分片的输入在该轴上广播（维度为1或缺失），
+    // 或是该轴为完整长度的常量（一同切分）
+    bool PropagateElementwise(Node* node) {
+        Value* output = node->GetOutputs()[0];
+        const int64_t rank = Rank(output);
+        int64_t axis = -1;
+        for (Value* input : node->GetInputs()) {
+            if (!IsSharded(input)) {
+                continue;
+            }
+            const int64_t aligned = sharded_[input] + rank - Rank(input);
+            if (axis >= 0 && aligned != axis) {
+                return false;
+            }
+            axis = aligned;
+        }
+        const int64_t full = (*GetDims(output))[axis];
+        std::vector<std::pair<Value*, int64_t>> constants;
+        for (Value* input : node->GetInputs()) {
+            if (IsSharded(input)) {
+                continue;
+            }
+            const int64_t input_rank = Rank(input);
+            if (input_rank < 0) {
+                return false;
+            }
+            const int64_t k = axis - (rank - input_rank);
+            if (k < 0 || (*GetDims(input))[k] == 1) {
+                continue;
+            }
+            if ((*GetDims(input))[k] != full || !fusion::IsConstant(*graph_, input) || !Divisible(full)) {
+                return false;
+            }
+            constants.emplace_back(input, k);
+        }
+        for (const auto& constant : constants) {
+            ShardConstant(node, constant.first, constant.second);
+        }
+        sharded_[output] = axis;
+        return true;
+    }
+
+    bool PropagateTranspose(Node* node) {
+        Value* input = node->GetInputs()[0];
+        const int64_t rank = Rank(input);
+        std::vector<int64_t> perm;
+        if (const AttributeValue* attr = node->FindAttribute("perm")) {
+            perm = attr->GetInts();
+        }
+        if (perm.empty()) {
+            for (int64_t i = rank - 1; i >= 0; --i) {
+                perm.push_back(i);
+            }
+        }
+        auto it = std::find(perm.begin(), perm.end(), sharded_[input]);
+        if (it == perm.end()) {
+            return false;
+        }
+        sharded_[node->GetOutputs()[0]] = it - perm.begin();
+        return true;
+    }
+
+    // 分片轴a是输入中一组相邻维度的最外层、这组维度对应输出中从j开始的一组维度时，输出沿j分片：
+    // 前缀的元素数相同（或维度逐一相同），后缀的元素数相同，且输出第j维可整除。
+    // 覆盖多头注意力的[B,S,H*D] -> [B,S,H,D]拆分与[B,S,H,D] -> [B,S,H*D]合并
+    bool PropagateReshape(Node* node) {
+        const auto& inputs = node->GetInputs();
+        Value* input = inputs[0];
+        if (inputs.size() < 2 || IsSharded(inputs[1]) || !fusion::IsConstant(*graph_, inputs[1]) ||
+            inputs[1]->GetTensor()->GetDataType() != DataType::INT64 || !inputs[1]->GetTensor()->GetData() ||
+            !GetDims(input)) {
+            return false;
+        }
+        const std::vector<int64_t>& in = *GetDims(input);
+        const std::vector<int64_t>& out = *GetDims(node->GetOutputs()[0]);
+        const int64_t a = sharded_[input];
+        const int64_t* target_data = static_cast<const int64_t*>(inputs[1]->GetTensor()->GetData());
+        std::vector<int64_t> target(target_data, target_data + inputs[1]->GetTensor()->GetElementCount());
+        int64_t in_suffix, in_prefix;
+        if (target.size() != out.size() || !KnownProduct(in, a, in.size(), &in_suffix)) {
+            return false;
+        }
+        const bool in_prefix_known = KnownProduct(in, 0, a, &in_prefix);
+        int64_t j = -1;
+        for (size_t candidate = 0; candidate < out.size() && j < 0; ++candidate) {
+            int64_t out_prefix, out_suffix;
+            const bool prefix_match =
+                (in_prefix_known && KnownProduct(out, 0, candidate, &out_prefix) && out_prefix == in_prefix) ||
+                (static_cast<int64_t>(candidate) == a && std::equal(in.begin(), in.begin() + a, out.begin()));
+            if (prefix_match && Divisible(out[candidate]) &&
+                KnownProduct(out, candidate, out.size(), &out_suffix) && out_suffix == in_suffix) {
+                j = static_cast<int64_t>(candidate);
+            }
+        }
+        if (j < 0) {
+            return false;
+        }
+        // 目标形状中的0复制输入的同位维度：分片维只能复制到分片维
+        for (size_t k = 0; k < target.size(); ++k) {
+            if (target[k] == 0 && (static_cast<int64_t>(k) == a) != (static_cast<int64_t>(k) == j)) {
+                return false;
+            }
+        }
+        if (target[j] > 0) {
+            target[j] /= world_size_;
+            auto shape = CreateTensor(Shape({static_cast<int64_t>(target.size())}), DataType::INT64, DeviceType::CPU);
+            std::memcpy(shape->GetData(), target.data(), target.size() * sizeof(int64_t));
+            Value* value = graph_->AddValue();
+            value->SetTensor(shape);
+            Value* old_shape = inputs[1];
+            node->ReplaceInput(old_shape, value);
+            RemoveIfUnused(old_shape);
+        }
+        sharded_[node->GetOutputs()[0]] = j;
+        return true;
+    }
+
+    // 沿最后一维的Softmax，分片在其他维上
+    bool PropagateSoftmax(Node* node) {
+        Value* input = node->GetInputs()[0];
+        const int64_t rank = Rank(input);
+        int64_t axis = std::stoll(node->GetAttribute("axis", "-1"));
+        if (axis < 0) {
+            axis += rank;
+        }
+        if (axis != rank - 1 || sharded_[input] == axis) {
+            return false;
+        }
+        sharded_[node->GetOutputs()[0]] = sharded_[input];
+        return true;
+    }
+
+    bool PropagateMatMul(Node* node) {
+        const auto& inputs = node->GetInputs();
+        Value* a = inputs[0];
+        Value* b = inputs[1];
+        Value* output = node->GetOutputs()[0];
+        const int64_t a_rank = Rank(a);
+        const int64_t b_rank = Rank(b);
+        const int64_t out_rank = Rank(output);
+        if (a_rank < 1 || b_rank < 1 || inputs.size() > 3 ||
+            node->GetAttribute("transA", "0") != "0" || node->GetAttribute("transB", "0") != "0") {
+            return false;
+        }
+        const bool a_sharded = IsSharded(a);
+        const bool b_sharded = IsSharded(b);
+        Value* bias = inputs.size() > 2 ? inputs[2] : nullptr;
+        if (bias && IsSharded(bias)) {
+            return false;
+        }
+
+        // 行并行：A沿K分片、B为常量，各rank得到部分和
+        int64_t k_axis, n_axis;
+        if (a_sharded && !b_sharded && sharded_[a] == a_rank - 1 && GetConstantWeight(node, &k_axis, &n_axis)) {
+            if (!node->GetAttribute("activation").empty()) {
+                return false;
+            }
+            ShardConstant(node, b, k_axis);
+            if (bias && rank_ != 0) {
+                // bias只在rank 0上加一次
+                auto zeros = CreateTensor(bias->GetTensor()->GetShape(), bias->GetTensor()->GetDataType(),
+                                          DeviceType::CPU);
+                std::memset(zeros->GetData(), 0, zeros->GetSizeInBytes());
+                Value* zero_bias = graph_->AddValue();
+                zero_bias->SetTensor(zeros);
+                node->ReplaceInput(bias, zero_bias);
+                RemoveIfUnused(bias);
+            }
+            InsertAllReduce(node);
+            return true;
+        }
+        // bias在输出的分片轴上广播时才能原样保留
+        auto bias_broadcasts = [&](int64_t axis) {
+            if (!bias) {
+                return true;
+            }
+            const int64_t k = axis - (out_rank - Rank(bias));
+            return Rank(bias) >= 0 && (k < 0 || (*GetDims(bias))[k] == 1);
+        };
+        // A沿批维或行分片、B未分片且在该轴上广播：输出沿同一轴分片
+        if (a_sharded && !b_sharded && sharded_[a] < a_rank - 1) {
+            const int64_t axis = sharded_[a] + out_rank - a_rank;
+            const int64_t k = axis - (out_rank - b_rank);
+            if (b_rank >= 2 && k >= 0 && k < b_rank - 2 && (*GetDims(b))[k] != 1) {
+                return false;
+            }
+            if (!bias_broadcasts(axis)) {
+                return false;
+            }
+            sharded_[output] = axis;
+            return true;
+        }
+        // 两个输入沿同一个批维分片（多头注意力的QK^T与PV）
+        if (a_sharded && b_sharded && a_rank >= 3 && b_rank >= 3) {
+            const int64_t axis = sharded_[a] + out_rank - a_rank;
+            if (axis != sharded_[b] + out_rank - b_rank || axis >= out_rank - 2 || !bias_broadcasts(axis)) {
+                return false;
+            }
+            sharded_[output] = axis;
+            return true;
+        }
+        // B沿列分片、A未分片：输出沿最后一维分片
+        if (!a_sharded && b_sharded && b_rank >= 2 && sharded_[b] == b_rank - 1) {
+            if (!bias_broadcasts(out_rank - 1)) {
+                return false;
+            }
+            sharded_[output] = out_rank - 1;
+            return true;
+        }
+        return false;
+    }
+
+    Graph* graph_;
+    int world_size_;
+    int rank_;
+    int64_t group_id_;
+    int64_t next_tag_ = 0;
+    std::unordered_map<const Value*, int64_t> sharded_;  // 分片值 -> 被切分的轴
+    std::unordered_map<const Value*, Value*> gathered_;
+};
+
+} // anonymous namespace
+
+Status TensorParallelShardingPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    if (world_size_ < 1 || rank_ < 0 || rank_ >= world_size_) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "TensorParallelSharding: rank must be in [0, world_size)");
+    }
+    if (world_size_ == 1) {
+        return Status::Ok();
+    }
+    Sharder(graph, world_size_, rank_, group_id_).Run();
+    return Status::Ok();
+}
+
+} // namespace inferunity
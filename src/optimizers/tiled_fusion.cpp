@@ -0,0 +1,248 @@
+// 跨层深度优先分块Pass实现
+// 逐层执行时每个中间特征图都完整写回内存再读回；大分辨率的主干前几层特征图远大于L2，
+// 合并为FusedTileGroup后按输出行分块算完整条链，中间结果只以块的形式留在缓存中
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+// 与FusedTileGroup的stage_types取值一致
+constexpr int64_t kConvStage = 0;
+constexpr int64_t kMaxPoolStage = 1;
+constexpr int64_t kAveragePoolStage = 2;
+
+struct TileStage {
+    int64_t type = kConvStage;
+    int64_t kernel[2] = {1, 1};
+    int64_t stride[2] = {1, 1};
+    int64_t dilation[2] = {1, 1};
+    int64_t pads[4] = {0, 0, 0, 0};
+    int64_t group = 1;
+    bool relu = false;
+    bool count_include_pad = false;
+    std::vector<Value*> params;   // 卷积级的weight与可选的bias
+};
+
+bool IsFloatNchw(const Value* value) {
+    return value && fusion::HasKnownShape(value) && value->GetDataType() == DataType::FLOAT32 &&
+           value->GetShape().dims.size() == 4;
+}
+
+// 读取INT/INTS属性：给出1个值时两维共用，未给出时保持values不变
+bool ReadPair(const Node& node, const std::string& key, int64_t* values) {
+    const AttributeValue* attr = node.FindAttribute(key);
+    if (!attr) return true;
+    if (attr->GetType() == AttributeValue::Type::INT) {
+        values[0] = values[1] = attr->GetInt();
+        return true;
+    }
+    if (attr->GetType() != AttributeValue::Type::INTS) return false;
+    const auto& ints = attr->GetInts();
+    if (ints.size() == 1 || ints.size() == 2) {
+        values[0] = ints[0];
+        values[1] = ints.back();
+        return true;
+    }
+    return ints.empty();
+}
+
+// ONNX pads格式：[top, left, bottom, right]，也接受[h, w]或单值
+bool ReadPads(const Node& node, int64_t* pads) {
+    const AttributeValue* attr = node.FindAttribute("pads");
+    if (!attr) return true;
+    std::vector<int64_t> ints;
+    if (attr->GetType() == AttributeValue::Type::INT) {
+        ints = {attr->GetInt()};
+    } else if (attr->GetType() == AttributeValue::Type::INTS) {
+        ints = attr->GetInts();
+    } else {
+        return false;
+    }
+    if (ints.size() == 4) {
+        std::copy(ints.begin(), ints.end(), pads);
+    } else if (ints.size() == 2) {
+        pads[0] = pads[2] = ints[0];
+        pads[1] = pads[3] = ints[1];
+    } else if (ints.size() == 1) {
+        std::fill(pads, pads + 4, ints[0]);
+    } else {
+        return ints.empty();
+    }
+    return true;
+}
+
+// 节点能作为一级时填写stage：输入输出都是形状已知的NCHW FLOAT32，卷积权重为常量，
+// 按属性推出的输出形状须与形状推断一致（排除SAME填充、ceil_mode等分块未处理的情形）
+bool DescribeStage(const Graph& graph, const Node& node, TileStage* stage) {
+    const auto& inputs = node.GetInputs();
+    const auto& outputs = node.GetOutputs();
+    if (inputs.empty() || outputs.size() != 1 || !IsFloatNchw(inputs[0]) || !IsFloatNchw(outputs[0])) {
+        return false;
+    }
+    const std::string& op_type = node.GetOpType();
+    const std::string auto_pad = node.GetAttribute("auto_pad", "NOTSET");
+    if (auto_pad != "NOTSET" && auto_pad != "VALID") {
+        return false;
+    }
+    if (op_type == "Conv" || op_type == "FusedConvReLU") {
+        if (inputs.size() < 2 || inputs.size() > 3 || node.GetAttribute("conv_algorithm", "auto") != "auto") {
+            return false;
+        }
+        for (size_t i = 1; i < inputs.size(); ++i) {
+            if (!fusion::IsConstant(graph, inputs[i]) || inputs[i]->GetDataType() != DataType::FLOAT32) {
+                return false;
+            }
+        }
+        const auto& w = inputs[1]->GetShape().dims;
+        if (w.size() != 4) {
+            return false;
+        }
+        stage->type = kConvStage;
+        stage->kernel[0] = w[2];
+        stage->kernel[1] = w[3];
+        const AttributeValue* group = node.FindAttribute("group");
+        if (group && group->GetType() != AttributeValue::Type::INT) {
+            return false;
+        }
+        stage->group = group ? group->GetInt() : 1;
+        stage->relu = op_type == "FusedConvReLU";
+        stage->params.assign(inputs.begin() + 1, inputs.end());
+        if (!ReadPair(node, "dilations", stage->dilation)) {
+            return false;
+        }
+    } else if (op_type == "MaxPool" || op_type == "AveragePool") {
+        int64_t dilation[2] = {1, 1};
+        if (inputs.size() != 1 || node.GetAttribute("ceil_mode", "0") != "0" ||
+            !ReadPair(node, "dilations", dilation) || dilation[0] != 1 || dilation[1] != 1) {
+            return false;
+        }
+        stage->type = op_type == "MaxPool" ? kMaxPoolStage : kAveragePoolStage;
+        // 与ParsePool2DParams一致：没有kernel_shape时为2x2、步长2的窗口
+        stage->kernel[0] = stage->kernel[1] = 2;
+        stage->stride[0] = stage->stride[1] = 2;
+        if (node.FindAttribute("kernel_shape")) {
+            stage->stride[0] = stage->stride[1] = 1;
+            if (!ReadPair(node, "kernel_shape", stage->kernel)) {
+                return false;
+            }
+        }
+        stage->count_include_pad = node.GetAttribute("count_include_pad", "0") != "0";
+    } else {
+        return false;
+    }
+    if (!ReadPair(node, "strides", stage->stride) || (auto_pad == "NOTSET" && !ReadPads(node, stage->pads))) {
+        return false;
+    }
+    
+    const auto& x = inputs[0]->GetShape().dims;
+    const auto& y = outputs[0]->GetShape().dims;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (stage->stride[axis] <= 0 || stage->dilation[axis] <= 0) {
+            return false;
+        }
+        const int64_t extent = x[2 + axis] + stage->pads[axis] + stage->pads[axis + 2] -
+                               (stage->kernel[axis] - 1) * stage->dilation[axis] - 1;
+        if (extent < 0 || extent / stage->stride[axis] + 1 != y[2 + axis]) {
+            return false;
+        }
+    }
+    return x[0] == y[0];
+}
+
+int64_t ValueBytes(const Value* value) {
+    const auto& dims = value->GetShape().dims;
+    return dims[1] * dims[2] * dims[3] * static_cast<int64_t>(sizeof(float));
+}
+
+} // namespace
+
+Status DepthFirstTilingPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    
+    // 先按拓扑序找出互不相交的链，再逐条替换（替换会删除节点）
+    std::unordered_set<const Node*> visited;
+    std::vector<std::pair<std::vector<Node*>, std::vector<TileStage>>> chains;
+    for (Node* node : graph->GetTopologicalOrder()) {
+        TileStage stage;
+        if (visited.count(node) || !DescribeStage(*graph, *node, &stage)) {
+            continue;
+        }
+        std::vector<Node*> nodes = {node};
+        std::vector<TileStage> stages = {stage};
+        int64_t largest_intermediate = 0;
+        Node* tail = node;
+        while (stages.size() < max_stages_) {
+            Node* next = fusion::SoleConsumer(*graph, tail->GetOutputs()[0]);
+            if (!next || visited.count(next)) {
+                break;
+            }
+            // 级后的Relu并入该级
+            if (next->GetOpType() == "Relu" && next->GetOutputs().size() == 1) {
+                stages.back().relu = true;
+                nodes.push_back(next);
+                tail = next;
+                continue;
+            }
+            TileStage following;
+            if (!DescribeStage(*graph, *next, &following)) {
+                break;
+            }
+            largest_intermediate = std::max(largest_intermediate, ValueBytes(tail->GetOutputs()[0]));
+            nodes.push_back(next);
+            stages.push_back(following);
+            tail = next;
+        }
+        // 中间结果本来就放得进缓存时分块只带来halo行的重复计算
+        if (stages.size() < 2 || largest_intermediate <= tile_bytes_) {
+            continue;
+        }
+        visited.insert(nodes.begin(), nodes.end());
+        chains.emplace_back(std::move(nodes), std::move(stages));
+    }
+    
+    for (const auto& chain : chains) {
+        const std::vector<Node*>& nodes = chain.first;
+        std::vector<Value*> inputs = {nodes.front()->GetInputs()[0]};
+        std::vector<int64_t> types, kernels, strides, dilations, pads, groups, has_bias, relu, include_pad;
+        for (const TileStage& stage : chain.second) {
+            types.push_back(stage.type);
+            kernels.insert(kernels.end(), stage.kernel, stage.kernel + 2);
+            strides.insert(strides.end(), stage.stride, stage.stride + 2);
+            dilations.insert(dilations.end(), stage.dilation, stage.dilation + 2);
+            pads.insert(pads.end(), stage.pads, stage.pads + 4);
+            groups.push_back(stage.group);
+            has_bias.push_back(stage.params.size() > 1 ? 1 : 0);
+            relu.push_back(stage.relu ? 1 : 0);
+            include_pad.push_back(stage.count_include_pad ? 1 : 0);
+            inputs.insert(inputs.end(), stage.params.begin(), stage.params.end());
+        }
+        NodeAttributes attrs;
+        attrs["stage_types"] = AttributeValue(types);
+        attrs["stage_kernels"] = AttributeValue(kernels);
+        attrs["stage_strides"] = AttributeValue(strides);
+        attrs["stage_dilations"] = AttributeValue(dilations);
+        attrs["stage_pads"] = AttributeValue(pads);
+        attrs["stage_groups"] = AttributeValue(groups);
+        attrs["stage_has_bias"] = AttributeValue(has_bias);
+        attrs["stage_relu"] = AttributeValue(relu);
+        attrs["stage_count_include_pad"] = AttributeValue(include_pad);
+        attrs["tile_bytes"] = AttributeValue(tile_bytes_);
+    
+        // 匹配结果以链尾为根；共用同一权重的级（输入重复）保持原状
+        fusion::Match match;
+        match.nodes.assign(nodes.rbegin(), nodes.rend());
+        fusion::ReplaceMatch(graph, match, "FusedTileGroup", inputs, attrs);
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,169 @@
+// 仅权重量化Pass实现
+// 参考ONNX Runtime的MatMul4BitsQuantizer（RTN算法）：每列沿K每block_size个元素一组，
+// 取包含0的[min, max]求scale与零点，scale以FP16存储，布局与MatMulNBits一致（见matmul_nbits_kernels.h）
+
+#include "inferunity/optimizer.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include "inferunity/float16.h"
+#include "fusion_pattern.h"
+#include <algorithm>
+#include <cmath>
+
+namespace inferunity {
+
+namespace {
+
+struct QuantizedNBits {
+    std::shared_ptr<Tensor> data;
+    std::shared_ptr<Tensor> scales;
+    std::shared_ptr<Tensor> zero_points;
+};
+
+// weight为[K, N]的FLOAT32，按列分组量化
+QuantizedNBits QuantizeBlockwise(const Tensor& weight, int64_t bits, int64_t block_size) {
+    const int64_t K = weight.GetShape().dims[0];
+    const int64_t N = weight.GetShape().dims[1];
+    const int64_t blocks = (K + block_size - 1) / block_size;
+    const int64_t blob_size = block_size * bits / 8;
+    const int64_t zp_per_col = bits == 8 ? blocks : (blocks + 1) / 2;
+    const int32_t qmax = (1 << bits) - 1;
+    
+    QuantizedNBits result;
+    result.data = CreateTensor(Shape({N, blocks, blob_size}), DataType::UINT8, DeviceType::CPU);
+    result.scales = CreateTensor(Shape({N * blocks}), DataType::FLOAT16, DeviceType::CPU);
+    result.zero_points = CreateTensor(Shape({N * zp_per_col}), DataType::UINT8, DeviceType::CPU);
+    const float* src = static_cast<const float*>(weight.GetData());
+    uint8_t* data = static_cast<uint8_t*>(result.data->GetData());
+    uint16_t* scales = static_cast<uint16_t*>(result.scales->GetData());
+    uint8_t* zero_points = static_cast<uint8_t*>(result.zero_points->GetData());
+    std::fill(data, data + result.data->GetElementCount(), 0);
+    std::fill(zero_points, zero_points + result.zero_points->GetElementCount(), 0);
+    
+    for (int64_t n = 0; n < N; ++n) {
+        for (int64_t block = 0; block < blocks; ++block) {
+            const int64_t k0 = block * block_size;
+            const int64_t k1 = std::min(K, k0 + block_size);
+            float vmin = 0.0f, vmax = 0.0f;
+            for (int64_t k = k0; k < k1; ++k) {
+                vmin = std::min(vmin, src[k * N + n]);
+                vmax = std::max(vmax, src[k * N + n]);
+            }
+            // 以存储后的FP16 scale计算量化值，反量化时不再引入额外误差
+            const uint16_t scale_half = FloatToHalf((vmax - vmin) / static_cast<float>(qmax));
+            const float scale = HalfToFloat(scale_half);
+            int32_t zp = 0;
+            if (scale > 0.0f) {
+                zp = std::min(qmax, std::max(0, static_cast<int32_t>(std::lround(-vmin / scale))));
+            }
+            scales[n * blocks + block] = scale_half;
+            if (bits == 8) {
+                zero_points[n * zp_per_col + block] = static_cast<uint8_t>(zp);
+            } else {
+                zero_points[n * zp_per_col + block / 2] |= static_cast<uint8_t>(zp << ((block & 1) * 4));
+            }
+            
+            uint8_t* blob = data + (n * blocks + block) * blob_size;
+            for (int64_t k = k0; k < k1; ++k) {
+                int32_t q = zp;
+                if (scale > 0.0f) {
+                    q = static_cast<int32_t>(std::lround(src[k * N + n] / scale)) + zp;
+                    q = std::min(qmax, std::max(0, q));
+                }
+                const int64_t i = k - k0;
+                if (bits == 8) {
+                    blob[i] = static_cast<uint8_t>(q);
+                } else {
+                    blob[i / 2] |= static_cast<uint8_t>(q << ((i & 1) * 4));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// MatMul或无激活的FusedMatMulAdd，B为二维FLOAT32常量，bias（如有）为[N]的FLOAT32常量
+bool IsQuantizableMatMul(const Graph& graph, const Node& node) {
+    const std::string& type = node.GetOpType();
+    const auto& inputs = node.GetInputs();
+    if (type == "MatMul") {
+        if (inputs.size() != 2) {
+            return false;
+        }
+    } else if (type == "FusedMatMulAdd") {
+        if (inputs.size() != 3 || !node.GetAttribute("activation").empty()) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    Value* weight = inputs[1];
+    if (!fusion::IsConstant(graph, weight) || fusion::IsGraphOutput(graph, weight)) {
+        return false;
+    }
+    auto tensor = weight->GetTensor();
+    if (tensor->GetDataType() != DataType::FLOAT32 || tensor->GetShape().dims.size() != 2) {
+        return false;
+    }
+    if (inputs.size() == 3) {
+        if (!fusion::IsConstant(graph, inputs[2])) {
+            return false;
+        }
+        auto bias = inputs[2]->GetTensor();
+        if (bias->GetDataType() != DataType::FLOAT32 || bias->GetShape().dims.size() != 1 ||
+            bias->GetShape().dims[0] != tensor->GetShape().dims[1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+Status WeightOnlyQuantizationPass::Run(Graph* graph) {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    if (bits_ != 4 && bits_ != 8) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "WeightOnlyQuantization bits must be 4 or 8");
+    }
+    if (block_size_ < 16 || (block_size_ & (block_size_ - 1)) != 0) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "WeightOnlyQuantization block_size must be a power of 2 and >= 16");
+    }
+    
+    for (const auto& node : graph->GetNodes()) {
+        if (!IsQuantizableMatMul(*graph, *node)) {
+            continue;
+        }
+        const std::vector<Value*> inputs = node->GetInputs();
+        Value* weight = inputs[1];
+        const Shape& shape = weight->GetTensor()->GetShape();
+        QuantizedNBits quantized = QuantizeBlockwise(*weight->GetTensor(), bits_, block_size_);
+        const std::string prefix = weight->GetName().empty() ? node->GetName() + "_weight" : weight->GetName();
+        
+        // 输入改为A, B, scales, zero_points[, bias]；缺少g_idx时由input_slots标出bias的位置
+        for (Value* input : inputs) {
+            node->RemoveInput(input);
+        }
+        node->AddInput(inputs[0]);
+        node->AddInput(fusion::AddConstant(graph, quantized.data, prefix + "_quantized"));
+        node->AddInput(fusion::AddConstant(graph, quantized.scales, prefix + "_scales"));
+        node->AddInput(fusion::AddConstant(graph, quantized.zero_points, prefix + "_zero_points"));
+        if (inputs.size() == 3) {
+            node->AddInput(inputs[2]);
+            node->SetAttribute("input_slots", AttributeValue(std::vector<int64_t>{0, 1, 2, 3, 5}));
+        }
+        node->SetOpType("MatMulNBits");
+        node->SetAttribute("K", AttributeValue(shape.dims[0]));
+        node->SetAttribute("N", AttributeValue(shape.dims[1]));
+        node->SetAttribute("bits", AttributeValue(bits_));
+        node->SetAttribute("block_size", AttributeValue(block_size_));
+        if (weight->GetConsumers().empty()) {
+            graph->RemoveValue(weight);
+        }
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
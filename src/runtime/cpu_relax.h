@@ -0,0 +1,23 @@
+// 内部自旋等待工具：线程池与流水线执行器的忙等循环共用
+
+#pragma once
+
+#include <thread>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace inferunity {
+
+// 自旋等待的一次停顿：x86为pause，ARM为yield，其他平台让出时间片
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+} // namespace inferunity
@@ -0,0 +1,461 @@
+// 执行计划构建
+// 参考ONNX Runtime的SequentialPlanner：值按首次出现的顺序编号，
+// 释放点取每个中间值在执行顺序中的最后一个消费者
+
+#include "inferunity/execution_plan.h"
+#include "inferunity/graph.h"
+#include "inferunity/memory.h"
+#include "inferunity/operator.h"
+#include "inferunity/partitioner.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+int AssignSlot(const Value* value, std::vector<Value*>& values,
+               std::unordered_map<const Value*, int>& slot_of) {
+    auto it = slot_of.find(value);
+    if (it != slot_of.end()) {
+        return it->second;
+    }
+    const int slot = static_cast<int>(values.size());
+    values.push_back(const_cast<Value*>(value));
+    slot_of.emplace(value, slot);
+    return slot;
+}
+
+// 多流分配：节点沿数据依赖延续生产者所在的流（同一条链上不需要事件），
+// 其余节点（分支的起点）放到当前累计代价最小的流上，使相互独立的分支落在不同的流；
+// 跨流依赖记为等待，一条流对另一条流只需等待其上最近的生产者（流内按顺序执行）。
+// 不支持多流的提供者在主机上同步执行，读取多流步骤的输出前等待对应的流完成
+int AssignStreams(std::vector<ExecutionStep>& steps, size_t num_slots, int num_streams) {
+    struct StreamState {
+        std::vector<int> tail;                 // 每条流上最后一个步骤
+        std::vector<double> load;              // 每条流上的累计代价
+        std::vector<std::vector<int>> waited;  // waited[s][t]：流s已经等待过的流t上的最大步骤号
+    };
+    std::unordered_map<const ExecutionProvider*, StreamState> states;
+    std::vector<int> producer(num_slots, -1);
+    int used_streams = 1;
+    
+    for (size_t i = 0; i < steps.size(); ++i) {
+        ExecutionStep& step = steps[i];
+        // 主机上求值的形状步骤不在任何流上，它的输出在执行开始前已经就绪
+        if (step.host_shape) {
+            continue;
+        }
+        std::vector<int> preds;
+        for (int slot : step.input_slots) {
+            const int p = producer[slot];
+            if (p >= 0 && std::find(preds.begin(), preds.end(), p) == preds.end()) {
+                preds.push_back(p);
+            }
+        }
+    
+        if (!step.provider->SupportsMultiStream()) {
+            step.wait_steps = preds;
+            continue;
+        }
+    
+        StreamState& state = states[step.provider];
+        if (state.tail.empty()) {
+            state.tail.assign(num_streams, -1);
+            state.load.assign(num_streams, 0.0);
+            state.waited.assign(num_streams, std::vector<int>(num_streams, -1));
+        }
+        int stream = -1;
+        for (int p : preds) {
+            if (steps[p].provider == step.provider && state.tail[steps[p].stream] == p) {
+                stream = steps[p].stream;
+                break;
+            }
+        }
+        if (stream < 0) {
+            stream = static_cast<int>(std::min_element(state.load.begin(), state.load.end()) -
+                                      state.load.begin());
+        }
+        step.stream = stream;
+        for (int p : preds) {
+            // 其他提供者的步骤在主机上同步完成，不需要事件
+            if (steps[p].provider != step.provider || steps[p].stream == stream) {
+                continue;
+            }
+            int& waited = state.waited[stream][steps[p].stream];
+            if (waited >= p) {
+                continue;
+            }
+            waited = p;
+            step.wait_steps.push_back(p);
+            steps[p].record_event = true;
+        }
+        state.tail[stream] = static_cast<int>(i);
+        state.load[stream] += 1.0 + CostModel::EstimateFlops(step.node);
+        for (int slot : step.output_slots) {
+            producer[slot] = static_cast<int>(i);
+        }
+        used_streams = std::max(used_streams, stream + 1);
+    }
+    return used_streams;
+}
+
+} // anonymous namespace
+
+Status ExecutionPlan::Build(const Graph* graph,
+                            const std::vector<ExecutionProvider*>& providers,
+                            const ExecutionPlanOptions& options,
+                            std::unique_ptr<ExecutionPlan>* plan) {
+    if (!graph || !plan) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph or plan is null");
+    }
+    if (providers.empty()) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "No backends available");
+    }
+    
+    std::vector<Node*> order = options.node_order.empty() ? graph->TopologicalSort()
+                                                          : options.node_order;
+    if (order.size() != graph->GetNodes().size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL,
+                           "Execution order does not cover all nodes (cycle in graph?)");
+    }
+    
+    // 裁剪到所需输出的祖先节点，保持原有的相对顺序
+    if (!options.output_values.empty()) {
+        std::unordered_set<const Node*> needed;
+        std::vector<const Value*> pending(options.output_values.begin(), options.output_values.end());
+        while (!pending.empty()) {
+            const Value* value = pending.back();
+            pending.pop_back();
+            const Node* producer = value ? value->GetProducer() : nullptr;
+            if (!producer || !needed.insert(producer).second) {
+                continue;
+            }
+            for (const Value* input : producer->GetInputs()) {
+                pending.push_back(input);
+            }
+        }
+        order.erase(std::remove_if(order.begin(), order.end(),
+                                   [&needed](Node* node) { return !needed.count(node); }),
+                    order.end());
+    }
+    
+    std::unique_ptr<ExecutionPlan> result(new ExecutionPlan());
+    result->graph_ = graph;
+    for (Value* input : graph->GetInputs()) {
+        result->input_slots_.push_back(AssignSlot(input, result->values_, result->slot_of_));
+    }
+    
+    result->steps_.reserve(order.size());
+    for (Node* node : order) {
+        ExecutionStep step;
+        step.node = node;
+        step.op_metrics = GetOpMetrics(node->GetOpType());
+        auto assigned = options.node_providers.find(node);
+        step.provider = assigned != options.node_providers.end()
+            ? assigned->second : ExecutionProviderSelector::SelectProvider(node, providers);
+        if (!step.provider) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND,
+                               "No execution provider available for node: " + node->GetName());
+        }
+        for (Value* input : node->GetInputs()) {
+            step.input_slots.push_back(AssignSlot(input, result->values_, result->slot_of_));
+        }
+        for (Value* output : node->GetOutputs()) {
+            step.output_slots.push_back(AssignSlot(output, result->values_, result->slot_of_));
+        }
+        result->steps_.push_back(std::move(step));
+    }
+    
+    std::vector<bool> is_graph_output(result->values_.size(), false);
+    std::vector<const Value*> outputs(graph->GetOutputs().begin(), graph->GetOutputs().end());
+    if (!options.output_values.empty()) {
+        outputs = options.output_values;
+    }
+    for (const Value* output : outputs) {
+        const int slot = AssignSlot(output, result->values_, result->slot_of_);
+        result->output_slots_.push_back(slot);
+        is_graph_output.resize(result->values_.size(), false);
+        is_graph_output[slot] = true;
+    }
+    
+    if (options.host_shape_evaluation) {
+        result->shape_program_ = ShapeProgram::Build(result->values_, result->input_slots_, is_graph_output,
+                                                     &result->steps_);
+    }
+    
+    if (options.num_streams > 1) {
+        result->num_streams_ = AssignStreams(result->steps_, result->values_.size(), options.num_streams);
+    }
+    
+    // 视图不经过内核，没有可供其他流等待的事件，只在单流执行时启用
+    if (result->num_streams_ <= 1) {
+        for (ExecutionStep& step : result->steps_) {
+            if (step.host_shape || step.provider->GetDeviceType() != DeviceType::CPU || step.output_slots.size() != 1 ||
+                is_graph_output[step.output_slots[0]]) {
+                continue;
+            }
+            std::shared_ptr<Operator> op = step.provider->CreateOperator(step.node->GetOpType());
+            if (op && op->IsViewOperator()) {
+                ApplyNodeAttributes(*step.node, op.get());
+                step.view_op = std::move(op);
+            }
+        }
+    }
+    
+    // 释放点：节点产生的中间值在最后一次被读取（或无人读取时在产生）之后释放
+    if (options.release_intermediates) {
+        const size_t num_slots = result->values_.size();
+        std::vector<int> last_use(num_slots, -1);
+        for (size_t i = 0; i < result->steps_.size(); ++i) {
+            const ExecutionStep& step = result->steps_[i];
+            for (int slot : step.output_slots) {
+                last_use[slot] = std::max(last_use[slot], static_cast<int>(i));
+            }
+            for (int slot : step.input_slots) {
+                last_use[slot] = static_cast<int>(i);
+            }
+        }
+        for (size_t slot = 0; slot < num_slots; ++slot) {
+            const Value* value = result->values_[slot];
+            if (last_use[slot] < 0 || is_graph_output[slot] || !value->GetProducer() ||
+                options.persistent_values.count(value)) {
+                continue;
+            }
+            result->steps_[last_use[slot]].release_slots.push_back(static_cast<int>(slot));
+        }
+    }
+    
+    *plan = std::move(result);
+    return Status::Ok();
+}
+
+int ExecutionPlan::GetSlot(const Value* value) const {
+    auto it = slot_of_.find(value);
+    return it != slot_of_.end() ? it->second : -1;
+}
+
+std::vector<Node*> ExecutionPlan::GetNodeOrder() const {
+    std::vector<Node*> order;
+    order.reserve(steps_.size());
+    for (const auto& step : steps_) {
+        order.push_back(step.node);
+    }
+    return order;
+}
+
+Status ExecutionState::Create(const ExecutionPlan& plan, const MemoryPlan* memory_plan,
+                              std::unique_ptr<ExecutionState>* state,
+                              std::shared_ptr<MemoryAccount> account,
+                              HugePagePolicy huge_pages) {
+    if (!state) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "State is null");
+    }
+    std::unique_ptr<ExecutionState> result(new ExecutionState());
+    result->plan_ = &plan;
+    const std::vector<Value*>& values = plan.GetValues();
+    result->tensors_.resize(values.size());
+    result->bound_.resize(values.size());
+    
+    // 常量（没有生产者且不是图输入）只读共享
+    const std::vector<int>& input_slots = plan.GetInputSlots();
+    std::unordered_set<int> inputs(input_slots.begin(), input_slots.end());
+    for (size_t slot = 0; slot < values.size(); ++slot) {
+        if (!values[slot]->GetProducer() && !inputs.count(static_cast<int>(slot))) {
+            result->tensors_[slot] = values[slot]->GetTensor();
+        }
+    }
+    
+    if (memory_plan && memory_plan->arena_size > 0) {
+        result->arena_ = MemoryArena::Create(memory_plan->arena_size, memory_plan->alignment, std::move(account),
+                                             huge_pages);
+        if (!result->arena_) {
+            return Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate memory arena");
+        }
+        uint8_t* base = static_cast<uint8_t*>(result->arena_->GetBase());
+        std::shared_ptr<MemoryArena> arena = result->arena_;
+        for (const auto& entry : memory_plan->entries) {
+            const int slot = plan.GetSlot(entry.value);
+            if (slot < 0) continue;
+            // 视图按规划时的形状创建（形状特化的计划给出具体形状）
+            result->tensors_[slot] = std::shared_ptr<Tensor>(
+                new Tensor(entry.shape, entry.dtype, base + entry.offset, entry.layout, DeviceType::CPU),
+                [arena](Tensor* tensor) { delete tensor; });
+        }
+    }
+    
+    *state = std::move(result);
+    return Status::Ok();
+}
+
+void ExecutionState::BindOutput(int slot, std::shared_ptr<Tensor> tensor) {
+    bound_[slot] = std::move(tensor);
+}
+
+void ExecutionState::ClearBoundOutputs() {
+    for (auto& tensor : bound_) {
+        tensor.reset();
+    }
+}
+
+WeightStreamingSchedule::WeightStreamingSchedule(const ExecutionPlan& plan, const WeightStreamingOptions& options)
+    : plan_(&plan), options_(options) {
+    const std::vector<ExecutionStep>& steps = plan.GetSteps();
+    loads_.resize(steps.size());
+    load_bytes_.assign(steps.size(), 0);
+    releases_.resize(steps.size());
+    const std::vector<Value*>& graph_inputs = plan.GetGraph()->GetInputs();
+    // 每个映射视图的首次与最后一次使用
+    std::unordered_map<const Tensor*, std::pair<size_t, size_t>> uses;
+    std::vector<const Tensor*> order;
+    for (size_t index = 0; index < steps.size(); ++index) {
+        for (const Value* input : steps[index].node->GetInputs()) {
+            const Tensor* tensor = input ? input->GetTensor().get() : nullptr;
+            if (!tensor || input->GetProducer() || tensor->IsOwned() || !tensor->GetData() ||
+                tensor->GetDeviceType() != DeviceType::CPU || tensor->GetSizeInBytes() == 0 ||
+                std::find(graph_inputs.begin(), graph_inputs.end(), input) != graph_inputs.end()) {
+                continue;
+            }
+            auto inserted = uses.emplace(tensor, std::make_pair(index, index));
+            if (inserted.second) {
+                order.push_back(tensor);
+            } else {
+                inserted.first->second.second = index;
+            }
+        }
+    }
+    for (const Tensor* tensor : order) {
+        const std::pair<size_t, size_t>& use = uses[tensor];
+        const Region region{tensor->GetData(), tensor->GetSizeInBytes(), use.first};
+        loads_[use.first].push_back(region);
+        load_bytes_[use.first] += region.size;
+        releases_[use.second].push_back(region);
+        total_bytes_ += region.size;
+    }
+}
+
+WeightStreamingWindow::WeightStreamingWindow(const WeightStreamingSchedule* schedule, const ExecutionPlan& plan,
+                                             size_t begin, size_t end)
+    : schedule_(schedule && &schedule->GetPlan() == &plan ? schedule : nullptr),
+      begin_(begin), end_(std::min(end, plan.GetSteps().size())), next_(begin) {}
+
+void WeightStreamingWindow::BeforeStep(size_t step) {
+    if (!schedule_) {
+        return;
+    }
+    const WeightStreamingOptions& options = schedule_->GetOptions();
+    const size_t horizon = std::min(end_, step + 1 + static_cast<size_t>(std::max(options.lookahead_steps, 0)));
+    // 当前步骤的权重总要预取；之后的步骤在预算内尽量提前
+    while (next_ < horizon) {
+        const size_t bytes = schedule_->GetLoadBytes(next_);
+        if (next_ > step && options.budget_bytes > 0 && resident_bytes_ + bytes > options.budget_bytes) {
+            break;
+        }
+        for (const WeightStreamingSchedule::Region& region : schedule_->GetLoads(next_)) {
+            PrefetchMemory(region.data, region.size);
+        }
+        resident_bytes_ += bytes;
+        ++next_;
+    }
+    peak_resident_bytes_ = std::max(peak_resident_bytes_, resident_bytes_);
+}
+
+void WeightStreamingWindow::AfterStep(size_t step) {
+    if (!schedule_) {
+        return;
+    }
+    for (const WeightStreamingSchedule::Region& region : schedule_->GetReleases(step)) {
+        // 首次使用在窗口之前的权重（分段执行时）不计入驻留量，也不由本窗口回收
+        if (region.first_step < begin_) {
+            continue;
+        }
+        ReleaseMemory(region.data, region.size);
+        resident_bytes_ -= region.size;
+    }
+}
+
+WeightPrefetcher::WeightPrefetcher(const ExecutionPlan& plan, const WeightPrefetchOptions& options)
+    : plan_(&plan), options_(options) {
+    const std::vector<ExecutionStep>& steps = plan.GetSteps();
+    const std::vector<Value*>& graph_inputs = plan.GetGraph()->GetInputs();
+    regions_.resize(steps.size());
+    for (size_t index = 0; index < steps.size(); ++index) {
+        for (const Value* input : steps[index].node->GetInputs()) {
+            const Tensor* tensor = input ? input->GetTensor().get() : nullptr;
+            if (!tensor || input->GetProducer() || !tensor->GetData() ||
+                tensor->GetDeviceType() != DeviceType::CPU || tensor->GetSizeInBytes() == 0 ||
+                std::find(graph_inputs.begin(), graph_inputs.end(), input) != graph_inputs.end()) {
+                continue;
+            }
+            regions_[index].push_back(
+                Region{static_cast<const uint8_t*>(tensor->GetData()), tensor->GetSizeInBytes(), !tensor->IsOwned()});
+        }
+    }
+    thread_ = std::thread([this]() { Loop(); });
+}
+
+WeightPrefetcher::~WeightPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void WeightPrefetcher::Advance(const ExecutionPlan& plan, size_t step) {
+    if (&plan != plan_) {
+        return;
+    }
+    const size_t lookahead = static_cast<size_t>(std::max(options_.lookahead_steps, 0));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 新的一次运行从头开始，或执行已经越过了尚未预取的步骤
+        if (step == 0 || next_ <= step || next_ > step + 1 + lookahead) {
+            next_ = step + 1;
+        }
+        target_ = std::min(regions_.size(), step + 1 + lookahead);
+        if (next_ >= target_) {
+            return;
+        }
+    }
+    cv_.notify_one();
+}
+
+void WeightPrefetcher::PrefetchStep(size_t step) {
+    size_t cache_budget = options_.cache_bytes_per_step;
+    size_t bytes = 0;
+    for (const Region& region : regions_[step]) {
+        if (region.mapped) {
+            PrefetchMemory(region.data, region.size);
+        }
+        // 只预取开头：大权重放不进缓存，其余靠内核执行时的硬件顺序预取
+        const size_t cached = std::min(region.size, cache_budget);
+#if defined(__GNUC__) || defined(__clang__)
+        for (size_t offset = 0; offset < cached; offset += 64) {
+            __builtin_prefetch(region.data + offset, 0, 1);
+        }
+#endif
+        cache_budget -= cached;
+        bytes += region.size;
+    }
+    prefetched_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    prefetched_steps_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WeightPrefetcher::Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return stop_ || next_ < target_; });
+        if (stop_) {
+            return;
+        }
+        const size_t step = next_++;
+        lock.unlock();
+        PrefetchStep(step);
+        lock.lock();
+    }
+}
+
+} // namespace inferunity
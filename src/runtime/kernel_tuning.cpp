@@ -0,0 +1,181 @@
+// kernel自动调优与调优缓存
+// 参考cuDNN的cudnnFindConvolutionForwardAlgorithm：实测每个候选算法，缓存按形状记录最优结果
+
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace inferunity {
+
+namespace {
+
+const char* kCacheHeader = "# inferunity kernel tuning cache v1";
+
+std::string Sanitize(std::string text) {
+    std::replace_if(text.begin(), text.end(),
+                    [](char c) { return c == '|' || c == '\t' || c == '\n' || c == '\r'; }, '_');
+    return text;
+}
+
+} // anonymous namespace
+
+std::string KernelTuningCache::MakeKey(const std::string& device, const std::string& kernel,
+                                       const std::string& signature, DataType dtype) {
+    return Sanitize(device) + "|" + Sanitize(kernel) + "|" + Sanitize(signature) + "|" +
+           std::to_string(static_cast<int>(dtype));
+}
+
+bool KernelTuningCache::Lookup(const std::string& key, TuningRecord* record) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = records_.find(key);
+    if (it == records_.end()) {
+        return false;
+    }
+    if (record) {
+        *record = it->second;
+    }
+    return true;
+}
+
+void KernelTuningCache::Insert(const std::string& key, const TuningRecord& record) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records_[key] = record;
+        path = path_;
+    }
+    if (!path.empty()) {
+        Status status = Save(path);
+        if (!status.IsOk()) {
+            LOG_WARNING("Failed to save kernel tuning cache: " + status.Message());
+        }
+    }
+}
+
+size_t KernelTuningCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_.size();
+}
+
+void KernelTuningCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.clear();
+}
+
+Status KernelTuningCache::Load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return Status::Ok();
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != kCacheHeader) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Unrecognized kernel tuning cache: " + path);
+    }
+    std::unordered_map<std::string, TuningRecord> loaded;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string key;
+        TuningRecord record;
+        if (!std::getline(fields, key, '\t') || !(fields >> record.algorithm >> record.time_us >> record.workspace_bytes)) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Malformed kernel tuning cache entry: " + line);
+        }
+        loaded[key] = record;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : loaded) {
+        records_[entry.first] = entry.second;
+    }
+    return Status::Ok();
+}
+
+Status KernelTuningCache::Save(const std::string& path) const {
+    std::vector<std::pair<std::string, TuningRecord>> records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records.assign(records_.begin(), records_.end());
+    }
+    std::sort(records.begin(), records.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot write " + temp);
+        }
+        file << kCacheHeader << "\n";
+        for (const auto& entry : records) {
+            file << entry.first << "\t" << entry.second.algorithm << " " << entry.second.time_us << " "
+                 << entry.second.workspace_bytes << "\n";
+        }
+        if (!file) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot write " + temp);
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot replace " + path);
+    }
+    return Status::Ok();
+}
+
+Status KernelTuningCache::SetPath(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = path;
+    }
+    return path.empty() ? Status::Ok() : Load(path);
+}
+
+std::string KernelTuningCache::GetPath() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return path_;
+}
+
+KernelTuningCache& GetKernelTuningCache() {
+    static KernelTuningCache cache;
+    return cache;
+}
+
+Status AutotuneKernel(const std::string& key, const std::vector<int>& candidates,
+                      const std::function<Status(int algorithm, TuningRecord* measured)>& benchmark,
+                      KernelTuningCache* cache, TuningRecord* result) {
+    if (!result) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Result is null");
+    }
+    TuningRecord cached;
+    if (cache && cache->Lookup(key, &cached) &&
+        std::find(candidates.begin(), candidates.end(), cached.algorithm) != candidates.end()) {
+        *result = cached;
+        return Status::Ok();
+    }
+    
+    TuningRecord best;
+    for (int algorithm : candidates) {
+        TuningRecord measured;
+        measured.algorithm = algorithm;
+        if (!benchmark(algorithm, &measured).IsOk()) {
+            continue;
+        }
+        if (best.algorithm < 0 || measured.time_us < best.time_us) {
+            best = measured;
+            best.algorithm = algorithm;
+        }
+    }
+    if (best.algorithm < 0) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "No usable algorithm for " + key);
+    }
+    if (cache) {
+        cache->Insert(key, best);
+    }
+    *result = best;
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -0,0 +1,429 @@
+// 运行时指标实现
+// 分片在线程第一次记录时按轮转分配，线程数不超过kMetricShards时每个线程独占一个分片；
+// 注册表只在登记和拉取时加锁
+
+#include "inferunity/metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+void AtomicAddDouble(std::atomic<double>& target, double delta) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+void AtomicMaxDouble(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+const char* MetricTypeName(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER: return "counter";
+        case MetricType::GAUGE: return "gauge";
+        case MetricType::HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+// Prometheus标签值的转义：反斜杠、双引号与换行
+std::string EscapeLabelValue(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string FormatNumber(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+// {k1="v1",k2="v2"}；extra为直方图桶的le标签
+std::string FormatLabels(const MetricLabels& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) {
+        return "";
+    }
+    std::string text = "{";
+    for (size_t i = 0; i < labels.size(); ++i) {
+        if (i > 0) text += ',';
+        text += labels[i].first + "=\"" + EscapeLabelValue(labels[i].second) + "\"";
+    }
+    if (!extra.empty()) {
+        if (!labels.empty()) text += ',';
+        text += extra;
+    }
+    text += '}';
+    return text;
+}
+
+} // anonymous namespace
+
+size_t MetricShardIndex() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+// Histogram
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)), counts_(bounds_.size() + 1, 0) {}
+
+Histogram::Histogram(std::vector<double> bounds, std::vector<uint64_t> counts, double sum, double max)
+    : bounds_(std::move(bounds)), counts_(std::move(counts)), sum_(sum), max_(max) {
+    counts_.resize(bounds_.size() + 1, 0);
+    for (uint64_t count : counts_) {
+        count_ += count;
+    }
+}
+
+void Histogram::Record(double value) {
+    const size_t bucket = static_cast<size_t>(
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+    ++counts_[bucket];
+    ++count_;
+    sum_ += value;
+    max_ = count_ == 1 ? value : std::max(max_, value);
+}
+
+double Histogram::GetPercentile(double p) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    const double target = p * static_cast<double>(count_);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bounds_.size(); ++i) {
+        cumulative += counts_[i];
+        if (static_cast<double>(cumulative) >= target) {
+            return bounds_[i];
+        }
+    }
+    return max_;
+}
+
+// Counter / Gauge
+
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Counter::Reset() {
+    for (auto& shard : shards_) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Gauge::SetMax(int64_t value) {
+    int64_t current = value_.load(std::memory_order_relaxed);
+    while (value > current &&
+           !value_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// ShardedHistogram
+
+ShardedHistogram::ShardedHistogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    std::sort(bounds_.begin(), bounds_.end());
+    for (auto& shard : shards_) {
+        shard.counts.reset(new std::atomic<uint64_t>[bounds_.size() + 1]);
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            shard.counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ShardedHistogram::Record(double value) {
+    const size_t bucket = static_cast<size_t>(
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+    Shard& shard = shards_[MetricShardIndex()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    AtomicAddDouble(shard.sum, value);
+    AtomicMaxDouble(shard.max, value);
+}
+
+Histogram ShardedHistogram::Snapshot() const {
+    std::vector<uint64_t> counts(bounds_.size() + 1, 0);
+    double sum = 0.0;
+    double max = 0.0;
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+        sum += shard.sum.load(std::memory_order_relaxed);
+        max = std::max(max, shard.max.load(std::memory_order_relaxed));
+    }
+    return Histogram(bounds_, std::move(counts), sum, max);
+}
+
+void ShardedHistogram::Reset() {
+    for (auto& shard : shards_) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            shard.counts[i].store(0, std::memory_order_relaxed);
+        }
+        shard.sum.store(0.0, std::memory_order_relaxed);
+        shard.max.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+// 作用域计时
+
+ScopedLatency::ScopedLatency(ShardedHistogram* histogram)
+    : histogram_(histogram && MetricsRegistry::Instance().IsEnabled() ? histogram : nullptr),
+      start_ns_(histogram_ ? MetricNowNs() : 0) {}
+
+ScopedLatency::~ScopedLatency() {
+    if (histogram_) {
+        histogram_->Record(static_cast<double>(MetricNowNs() - start_ns_) / 1000.0);
+    }
+}
+
+ScopedOpTimer::ScopedOpTimer(const OpMetrics* metrics)
+    : metrics_(metrics && MetricsRegistry::Instance().IsEnabled() ? metrics : nullptr),
+      start_ns_(metrics_ ? MetricNowNs() : 0) {}
+
+// MetricsRegistry
+
+std::string MetricSample::GetLabel(const std::string& key) const {
+    for (const auto& label : labels) {
+        if (label.first == key) {
+            return label.second;
+        }
+    }
+    return "";
+}
+
+long MetricsRegistry::Entry::UseCount() const {
+    switch (type) {
+        case MetricType::COUNTER: return counter.use_count();
+        case MetricType::GAUGE: return gauge.use_count();
+        case MetricType::HISTOGRAM: return histogram.use_count();
+    }
+    return 0;
+}
+
+MetricsRegistry& MetricsRegistry::Instance() {
+    // 有意不析构：静态对象（如线程池）析构时仍可能记录指标
+    static MetricsRegistry* instance = new MetricsRegistry();
+    return *instance;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::FindOrAdd(const std::string& name, const MetricLabels& labels,
+                                                   MetricType type, const std::string& help) {
+    auto key = std::make_pair(name, labels);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        return it->second.type == type ? &it->second : nullptr;
+    }
+    // 同名的指标（标签不同）须为同一类型
+    auto same_name = entries_.lower_bound(std::make_pair(name, MetricLabels()));
+    if (same_name != entries_.end() && same_name->first.first == name && same_name->second.type != type) {
+        return nullptr;
+    }
+    if (!help.empty()) {
+        help_[name] = help;
+    }
+    Entry& entry = entries_[key];
+    entry.name = name;
+    entry.labels = labels;
+    entry.type = type;
+    return &entry;
+}
+
+std::shared_ptr<Counter> MetricsRegistry::GetCounter(const std::string& name, const MetricLabels& labels,
+                                                     const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(name, labels, MetricType::COUNTER, help);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->counter) {
+        entry->counter = std::make_shared<Counter>();
+    }
+    return entry->counter;
+}
+
+std::shared_ptr<Gauge> MetricsRegistry::GetGauge(const std::string& name, const MetricLabels& labels,
+                                                 const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(name, labels, MetricType::GAUGE, help);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->gauge) {
+        entry->gauge = std::make_shared<Gauge>();
+    }
+    return entry->gauge;
+}
+
+std::shared_ptr<ShardedHistogram> MetricsRegistry::GetHistogram(const std::string& name,
+                                                                const std::vector<double>& bounds,
+                                                                const MetricLabels& labels,
+                                                                const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(name, labels, MetricType::HISTOGRAM, help);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->histogram) {
+        entry->histogram = std::make_shared<ShardedHistogram>(bounds);
+    }
+    return entry->histogram;
+}
+
+void MetricsRegistry::Unregister(const std::string& label_key, const std::string& label_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        const MetricLabels& labels = it->second.labels;
+        const bool match = std::find(labels.begin(), labels.end(),
+                                     std::make_pair(label_key, label_value)) != labels.end();
+        if (match && it->second.UseCount() <= 1) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<MetricSample> MetricsRegistry::Collect(const std::string& name_prefix) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MetricSample> samples;
+    for (const auto& item : entries_) {
+        const Entry& entry = item.second;
+        if (entry.name.compare(0, name_prefix.size(), name_prefix) != 0) {
+            continue;
+        }
+        MetricSample sample;
+        sample.name = entry.name;
+        auto help = help_.find(entry.name);
+        if (help != help_.end()) {
+            sample.help = help->second;
+        }
+        sample.labels = entry.labels;
+        sample.type = entry.type;
+        switch (entry.type) {
+            case MetricType::COUNTER:
+                sample.value = static_cast<double>(entry.counter->Value());
+                break;
+            case MetricType::GAUGE:
+                sample.value = static_cast<double>(entry.gauge->Value());
+                break;
+            case MetricType::HISTOGRAM:
+                sample.histogram = entry.histogram->Snapshot();
+                sample.value = static_cast<double>(sample.histogram.GetCount());
+                break;
+        }
+        samples.push_back(std::move(sample));
+    }
+    return samples;
+}
+
+std::string MetricsRegistry::ExportPrometheus() const {
+    std::ostringstream out;
+    std::string current_name;
+    for (const MetricSample& sample : Collect()) {
+        // 同名的时间序列共用一组HELP/TYPE
+        if (sample.name != current_name) {
+            current_name = sample.name;
+            if (!sample.help.empty()) {
+                out << "# HELP " << sample.name << ' ' << sample.help << '\n';
+            }
+            out << "# TYPE " << sample.name << ' ' << MetricTypeName(sample.type) << '\n';
+        }
+        if (sample.type != MetricType::HISTOGRAM) {
+            out << sample.name << FormatLabels(sample.labels) << ' ' << FormatNumber(sample.value) << '\n';
+            continue;
+        }
+        // 桶计数是累计的，最后一个桶为+Inf
+        const Histogram& histogram = sample.histogram;
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < histogram.GetCounts().size(); ++i) {
+            cumulative += histogram.GetCounts()[i];
+            const std::string le = i < histogram.GetBounds().size() ?
+                FormatNumber(histogram.GetBounds()[i]) : std::string("+Inf");
+            out << sample.name << "_bucket" << FormatLabels(sample.labels, "le=\"" + le + "\"") << ' '
+                << cumulative << '\n';
+        }
+        out << sample.name << "_sum" << FormatLabels(sample.labels) << ' '
+            << FormatNumber(histogram.GetSum()) << '\n';
+        out << sample.name << "_count" << FormatLabels(sample.labels) << ' ' << histogram.GetCount() << '\n';
+    }
+    return out.str();
+}
+
+void MetricsRegistry::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : entries_) {
+        if (item.second.counter) {
+            item.second.counter->Reset();
+        }
+        if (item.second.histogram) {
+            item.second.histogram->Reset();
+        }
+    }
+}
+
+const OpMetrics* GetOpMetrics(const std::string& op_type) {
+    static std::mutex mutex;
+    static auto* cache = new std::unordered_map<std::string, std::unique_ptr<OpMetrics>>();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& metrics = (*cache)[op_type];
+    if (!metrics) {
+        MetricsRegistry& registry = MetricsRegistry::Instance();
+        const MetricLabels labels = {{"op_type", op_type}};
+        metrics = std::make_unique<OpMetrics>();
+        // 注册表中的指标也由这里持有，进程内一直有效
+        static auto* owned = new std::vector<std::shared_ptr<Counter>>();
+        owned->push_back(registry.GetCounter("inferunity_op_time_ns_total", labels,
+                                             "Cumulative kernel execution time per operator type"));
+        metrics->time_ns = owned->back().get();
+        owned->push_back(registry.GetCounter("inferunity_op_executions_total", labels,
+                                             "Kernel executions per operator type"));
+        metrics->executions = owned->back().get();
+    }
+    return metrics.get();
+}
+
+std::vector<double> LatencyBucketsUs() {
+    std::vector<double> bounds;
+    for (double scale = 10; scale <= 1e6; scale *= 10) {
+        bounds.push_back(scale);
+        bounds.push_back(scale * 2.5);
+        bounds.push_back(scale * 5);
+    }
+    bounds.push_back(1e7);
+    return bounds;
+}
+
+std::vector<double> BatchSizeBuckets(int max_batch_size) {
+    std::vector<double> bounds;
+    for (int size = 1; size < max_batch_size; size *= 2) {
+        bounds.push_back(static_cast<double>(size));
+    }
+    bounds.push_back(static_cast<double>(std::max(max_batch_size, 1)));
+    return bounds;
+}
+
+} // namespace inferunity
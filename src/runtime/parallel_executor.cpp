@@ -1,12 +1,16 @@
 // 多线程并行执行器
-// 参考ONNX Runtime的并行执行实现
+// 参考ONNX Runtime的ParallelExecutor：依赖计数归零的节点进入就绪队列，
+// 由调用线程与共享线程池中的辅助任务共同消费；就绪节点按关键路径长度优先执行。
+// 就绪集合是按优先级名次索引的原子位图，节点完成后由同一线程接着执行它的后继
 
 #include "inferunity/runtime.h"
 #include "inferunity/backend.h"
 #include "inferunity/graph.h"
+#include "inferunity/tracing.h"
+#include "inferunity/metrics.h"
+#include "inferunity/partitioner.h"
 #include <thread>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
@@ -15,118 +19,411 @@
 
 namespace inferunity {
 
-// ParallelScheduler实现
-ParallelScheduler::ParallelScheduler(int num_threads) 
-    : num_threads_(num_threads == 0 ? std::thread::hardware_concurrency() : num_threads) {
+int64_t EstimateNodeCost(const Node* node) {
+    // 计算与访存取较大者，只搬运数据的算子（FLOPs为0）也按字节数计入
+    const OperatorCost cost = CostModel::EstimateCost(node);
+    const DeviceCostProfile profile;
+    const double time_us = std::max(cost.flops / profile.flops_per_us,
+                                    static_cast<double>(cost.GetBytes()) / profile.bytes_per_us);
+    return std::max<int64_t>(static_cast<int64_t>(time_us * 1000.0), 1);
 }
 
-Status ParallelScheduler::Schedule(const Graph* graph,
-                   const std::vector<Backend*>& backends,
-                   ExecutionContext* ctx) {
-        if (!graph || backends.empty()) {
-            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid arguments");
-        }
-        
-        // 获取拓扑排序
-        std::vector<Node*> execution_order = graph->TopologicalSort();
-        
-        // 计算每个节点的依赖计数
-        std::unordered_map<Node*, int> ready_count;
-        for (Node* node : execution_order) {
-            ready_count[node] = node->GetInputs().size();
-        }
-        
-        // 准备就绪队列（没有依赖的节点）
-        std::queue<Node*> ready_queue;
-        for (Node* node : execution_order) {
-            if (ready_count[node] == 0) {
-                ready_queue.push(node);
+namespace {
+
+inline int LowestSetBit(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// 无锁的多生产者多消费者就绪集合：节点按优先级降序编号（名次），就绪时置位，
+// 取出时从最小的名次扫描并原子地清除该位，取到的总是当前优先级最高的就绪节点。
+// 每个节点在一次运行中只就绪一次，位图足以表示，不需要堆
+class ReadyBitmap {
+public:
+    explicit ReadyBitmap(size_t n) : num_words_((n + 63) / 64), words_(new std::atomic<uint64_t>[num_words_]) {
+        for (size_t w = 0; w < num_words_; ++w) {
+            words_[w].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    void Push(int rank) {
+        words_[rank >> 6].fetch_or(uint64_t(1) << (rank & 63), std::memory_order_seq_cst);
+    }
+    
+    // 没有就绪节点时返回-1
+    int Pop() {
+        for (size_t w = 0; w < num_words_; ++w) {
+            uint64_t bits = words_[w].load(std::memory_order_acquire);
+            while (bits) {
+                const uint64_t mask = uint64_t(1) << LowestSetBit(bits);
+                const uint64_t previous = words_[w].fetch_and(~mask, std::memory_order_seq_cst);
+                if (previous & mask) {
+                    return static_cast<int>(w * 64) + LowestSetBit(mask);
+                }
+                bits = previous & ~mask;  // 被其他线程抢先取走，继续找下一位
             }
         }
-        
-        // 多线程执行
-        std::mutex queue_mutex;
-        std::condition_variable cv;
-        std::atomic<int> completed_count(0);
-        std::vector<std::thread> workers;
-        std::atomic<bool> has_error(false);
-        Status error_status = Status::Ok();
-        
-        for (int i = 0; i < num_threads_; ++i) {
-            workers.emplace_back([&, i]() {
-                while (true) {
-                    Node* node = nullptr;
-                    
-                    // 获取下一个就绪节点
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex);
-                        cv.wait(lock, [&]() {
-                            return !ready_queue.empty() || completed_count.load() == execution_order.size() || has_error.load();
-                        });
-                        
-                        if (completed_count.load() == execution_order.size() || has_error.load()) {
-                            break;  // 所有节点已完成或出错
-                        }
-                        
-                        if (ready_queue.empty()) {
-                            continue;
-                        }
-                        
-                        node = ready_queue.front();
-                        ready_queue.pop();
-                    }
-                    
-                    if (!node) continue;
-                    
-                    // 执行节点
-                    Backend* backend = backends[0];  // 简化：使用第一个backend
-                    Status status = backend->ExecuteNode(node, ctx);
-                    
-                    if (!status.IsOk()) {
-                        has_error = true;
-                        error_status = status;
-                        completed_count = execution_order.size();  // 出错，停止所有线程
-                        cv.notify_all();
-                        break;
-                    }
-                    
-                    // 更新依赖计数，将新就绪的节点加入队列
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex);
-                        completed_count++;
-                        
-                        // 检查该节点的输出，更新消费者的依赖计数
-                        for (Value* output : node->GetOutputs()) {
-                            for (Node* consumer : output->GetConsumers()) {
-                                ready_count[consumer]--;
-                                if (ready_count[consumer] == 0) {
-                                    ready_queue.push(consumer);
-                                }
-                            }
-                        }
-                        
-                        cv.notify_all();
-                    }
+        return -1;
+    }
+    
+    bool Empty() const {
+        for (size_t w = 0; w < num_words_; ++w) {
+            if (words_[w].load(std::memory_order_seq_cst)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    size_t num_words_;
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+};
+
+// 一次Schedule调用的运行时状态；辅助任务持有shared_ptr，可能晚于Schedule返回才退出，
+// 但Schedule返回后不会再有节点开始执行。计数都是原子量，节点之间的调度不加锁；
+// 互斥量只用于调用线程无事可做时的休眠与记录第一个错误
+struct DagRunState {
+    explicit DagRunState(size_t n) : ready(n) {}
+    
+    // 只读的计划数据，由keep_alive保证生命周期
+    std::shared_ptr<const void> keep_alive;
+    const std::vector<Node*>* nodes = nullptr;
+    const std::vector<Backend*>* providers = nullptr;
+    const std::vector<std::vector<int>>* consumers = nullptr;
+    const std::vector<int>* ranks = nullptr;
+    const std::vector<int>* by_rank = nullptr;
+    ExecutionContext* ctx = nullptr;
+    // Schedule调用线程的取消令牌，辅助任务执行节点时同样安装，使节点内的并行循环可以中途停止
+    std::shared_ptr<CancellationToken> cancellation;
+    
+    std::unique_ptr<std::atomic<int>[]> pending;  // 剩余未完成的生产者数
+    ReadyBitmap ready;
+    
+    std::atomic<size_t> completed{0};
+    size_t total = 0;
+    std::atomic<int> running{0};          // 已领取（含正在检查是否失败）的节点数
+    std::atomic<int> helpers{0};          // 已提交、尚未退出的辅助任务数
+    int max_helpers = 0;
+    std::atomic<bool> failed{false};
+    std::atomic<bool> caller_waiting{false};
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    Status error = Status::Ok();
+    
+    bool Finished() const {
+        return completed.load() == total || (failed.load() && running.load() == 0);
+    }
+    
+    // 只在调用线程休眠时加锁通知
+    void WakeCaller() {
+        if (caller_waiting.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+};
+
+Status RunDagNode(DagRunState& state, int index) {
+    Node* node = (*state.nodes)[index];
+    Backend* provider = (*state.providers)[index];
+    if (state.ctx && state.ctx->IsCancelled()) {
+        return state.ctx->GetCancellationToken()->Check();
+    }
+    CancellationScope cancellation_scope(state.cancellation);
+    try {
+        Status status = BindNodeOutputs(node, provider);
+        if (!status.IsOk()) {
+            return status;
+        }
+        TraceScope trace(TraceCategory::NODE, node->GetName().c_str(), node->GetOpType().c_str());
+        ScopedOpTimer op_timer(GetOpMetrics(node->GetOpType()));
+        if (state.ctx && state.ctx->GetDeviceType() == provider->GetDeviceType()) {
+            return provider->ExecuteNode(node, state.ctx);
+        }
+        ExecutionContext local_ctx = state.ctx ? *state.ctx : ExecutionContext();
+        local_ctx.SetDeviceType(provider->GetDeviceType());
+        return provider->ExecuteNode(node, &local_ctx);
+    } catch (const std::exception& e) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                           "Node " + node->GetName() + " threw: " + e.what());
+    }
+}
+
+void DrainReadyNodes(const std::shared_ptr<DagRunState>& state, bool is_caller);
+
+// 为新就绪的节点提交辅助任务，数量受max_helpers限制；已有的辅助任务会继续取就绪节点，不重复唤醒
+void SubmitHelpers(const std::shared_ptr<DagRunState>& state, size_t count) {
+    size_t submit = 0;
+    int helpers = state->helpers.load();
+    while (submit < count && helpers < state->max_helpers) {
+        if (state->helpers.compare_exchange_weak(helpers, helpers + 1)) {
+            helpers++;
+            submit++;
+        }
+    }
+    for (size_t i = 0; i < submit; ++i) {
+        ThreadPool::EnqueueTask([state]() { DrainReadyNodes(state, false); });
+    }
+}
+
+// 领取一个就绪节点：先计入running再检查failed，出错后调用线程看到running为0时不会再有节点开始执行
+int ClaimReadyNode(DagRunState& state) {
+    state.running.fetch_add(1);
+    if (!state.failed.load()) {
+        const int rank = state.ready.Pop();
+        if (rank >= 0) {
+            return (*state.by_rank)[rank];
+        }
+    }
+    if (state.running.fetch_sub(1) == 1 && state.failed.load()) {
+        state.WakeCaller();
+    }
+    return -1;
+}
+
+// 执行index及其后续：完成一个节点后直接接着执行优先级最高的新就绪后继（数据仍在缓存中），
+// 其余后继放入就绪集合并只为它们唤醒辅助任务
+void RunNodeChain(const std::shared_ptr<DagRunState>& state, int index) {
+    while (index >= 0) {
+        Status status = RunDagNode(*state, index);
+        if (!status.IsOk()) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->failed.load()) {
+                    state->error = status;
+                    state->failed.store(true);
                 }
-            });
+            }
+            state->running.fetch_sub(1);
+            state->WakeCaller();
+            return;
         }
-        
-        // 等待所有线程完成
-        for (auto& worker : workers) {
-            worker.join();
+    
+        // 后继按优先级降序排列
+        int next = -1;
+        size_t pushed = 0;
+        for (int consumer : (*state->consumers)[index]) {
+            if (state->pending[consumer].fetch_sub(1, std::memory_order_acq_rel) != 1 ||
+                state->failed.load()) {
+                continue;
+            }
+            if (next < 0) {
+                next = consumer;
+            } else {
+                state->ready.Push((*state->ranks)[consumer]);
+                pushed++;
+            }
         }
-        
-        // 检查是否有错误
-        if (has_error.load()) {
-            return error_status;
+        const bool done = state->completed.fetch_add(1) + 1 == state->total;
+        if (next < 0) {
+            state->running.fetch_sub(1);
         }
-        
+        if (pushed > 0) {
+            SubmitHelpers(state, pushed);
+        }
+        if (done || pushed > 0 || (next < 0 && state->failed.load())) {
+            state->WakeCaller();
+        }
+        index = next;
+    }
+}
+
+// 调用线程一直执行到全部完成（或出错后没有运行中的节点）；辅助任务在就绪集合为空时退出
+void DrainReadyNodes(const std::shared_ptr<DagRunState>& state, bool is_caller) {
+    while (true) {
+        const int index = ClaimReadyNode(*state);
+        if (index >= 0) {
+            RunNodeChain(state, index);
+            continue;
+        }
+        if (!is_caller) {
+            state->helpers.fetch_sub(1);
+            return;
+        }
+        // 先声明将要休眠，再在锁内复查，与WakeCaller配对不会丢失唤醒
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->caller_waiting.store(true);
+        state->cv.wait(lock, [&state] {
+            return state->Finished() || (!state->failed.load() && !state->ready.Empty());
+        });
+        state->caller_waiting.store(false);
+        if (state->Finished()) {
+            return;
+        }
+    }
+}
+
+} // anonymous namespace
+
+// ParallelScheduler实现
+ParallelScheduler::ParallelScheduler(int num_threads)
+    : num_threads_(num_threads == 0 ? static_cast<int>(std::thread::hardware_concurrency()) : num_threads) {
+    if (num_threads_ <= 0) {
+        num_threads_ = 1;
+    }
+}
+
+void ParallelScheduler::Invalidate() {
+    std::lock_guard<std::mutex> lock(plan_mutex_);
+    plan_.reset();
+}
+
+Status ParallelScheduler::BuildPlan(const Graph* graph, const std::vector<Backend*>& backends) {
+    auto plan = std::make_shared<DagPlan>();
+    plan->graph = graph;
+    plan->backends = backends;
+    plan->nodes = graph->TopologicalSort();
+    
+    const size_t n = plan->nodes.size();
+    if (n != graph->GetNodes().size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Graph contains a cycle");
+    }
+    std::unordered_map<const Node*, int> index_of;
+    index_of.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        index_of[plan->nodes[i]] = static_cast<int>(i);
+    }
+    
+    // 依赖边只来自图内的生产者节点；图输入和权重没有生产者，不构成依赖
+    plan->providers.resize(n, nullptr);
+    plan->dependency_counts.assign(n, 0);
+    plan->consumers.assign(n, {});
+    for (size_t i = 0; i < n; ++i) {
+        Node* node = plan->nodes[i];
+        Backend* provider = ExecutionProviderSelector::SelectProvider(node, backends);
+        if (!provider) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND,
+                               "No execution provider available for node: " + node->GetName());
+        }
+        plan->providers[i] = provider;
+    
+        std::vector<int> producers;
+        for (Value* input : node->GetInputs()) {
+            Node* producer = input ? input->GetProducer() : nullptr;
+            if (!producer) continue;
+            auto it = index_of.find(producer);
+            if (it == index_of.end()) continue;
+            if (std::find(producers.begin(), producers.end(), it->second) == producers.end()) {
+                producers.push_back(it->second);
+            }
+        }
+        plan->dependency_counts[i] = static_cast<int>(producers.size());
+        for (int producer : producers) {
+            plan->consumers[producer].push_back(static_cast<int>(i));
+        }
+    }
+    
+    // 逆拓扑序计算关键路径长度
+    plan->priorities.assign(n, 0);
+    for (size_t r = n; r-- > 0;) {
+        int64_t longest = 0;
+        for (int consumer : plan->consumers[r]) {
+            longest = std::max(longest, plan->priorities[consumer]);
+        }
+        plan->priorities[r] = EstimateNodeCost(plan->nodes[r]) + longest;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        auto& consumers = plan->consumers[i];
+        std::stable_sort(consumers.begin(), consumers.end(), [&plan](int a, int b) {
+            return plan->priorities[a] > plan->priorities[b];
+        });
+        if (plan->dependency_counts[i] == 0) {
+            plan->initial_ready.push_back(static_cast<int>(i));
+        }
+    }
+    // 优先级相同时按拓扑序
+    plan->by_rank.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        plan->by_rank[i] = static_cast<int>(i);
+    }
+    std::stable_sort(plan->by_rank.begin(), plan->by_rank.end(), [&plan](int a, int b) {
+        return plan->priorities[a] > plan->priorities[b];
+    });
+    plan->ranks.resize(n);
+    for (size_t r = 0; r < n; ++r) {
+        plan->ranks[plan->by_rank[r]] = static_cast<int>(r);
+    }
+    
+    std::lock_guard<std::mutex> lock(plan_mutex_);
+    plan_ = std::move(plan);
+    return Status::Ok();
+}
+
+Status ParallelScheduler::Schedule(const Graph* graph,
+                   const std::vector<Backend*>& backends,
+                   ExecutionContext* ctx) {
+    if (!graph || backends.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid arguments");
+    }
+    
+    std::shared_ptr<const DagPlan> plan;
+    {
+        std::lock_guard<std::mutex> lock(plan_mutex_);
+        plan = plan_;
+    }
+    if (!plan || plan->graph != graph || plan->backends != backends ||
+        plan->nodes.size() != graph->GetNodes().size()) {
+        Status status = BuildPlan(graph, backends);
+        if (!status.IsOk()) {
+            return status;
+        }
+        std::lock_guard<std::mutex> lock(plan_mutex_);
+        plan = plan_;
+    }
+    
+    const size_t n = plan->nodes.size();
+    if (n == 0) {
         return Status::Ok();
     }
     
+    auto state = std::make_shared<DagRunState>(n);
+    state->keep_alive = plan;
+    state->nodes = &plan->nodes;
+    state->providers = &plan->providers;
+    state->consumers = &plan->consumers;
+    state->ranks = &plan->ranks;
+    state->by_rank = &plan->by_rank;
+    state->ctx = ctx;
+    state->cancellation = CancellationScope::Current();
+    state->total = n;
+    state->pending.reset(new std::atomic<int>[n]);
+    for (size_t i = 0; i < n; ++i) {
+        state->pending[i].store(plan->dependency_counts[i], std::memory_order_relaxed);
+    }
+    for (int index : plan->initial_ready) {
+        state->ready.Push(plan->ranks[index]);
+    }
+    const int pool_threads = static_cast<int>(ThreadPool::GetInterOpThreadCount());
+    state->max_helpers = std::max(0, std::min(num_threads_ - 1, pool_threads));
+    
+    if (plan->initial_ready.size() > 1) {
+        SubmitHelpers(state, plan->initial_ready.size() - 1);
+    }
+    DrainReadyNodes(state, true);
+    
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->failed.load() && ctx && ctx->IsCancelled()) {
+        return ctx->GetCancellationToken()->Check();
+    }
+    return state->failed.load() ? state->error : Status::Ok();
+}
+
 std::vector<Node*> ParallelScheduler::GetExecutionOrder(const Graph* graph) const {
+    std::lock_guard<std::mutex> lock(plan_mutex_);
+    if (plan_ && plan_->graph == graph && plan_->nodes.size() == graph->GetNodes().size()) {
+        return plan_->nodes;
+    }
     return graph->TopologicalSort();
 }
 
 } // namespace inferunity
-
@@ -0,0 +1,674 @@
+// 基于代价模型的图分区实现
+// 参考ONNX Runtime的节点分配与TVM的异构分区：先把每个节点放到预计最快的提供者上，
+// 再在拓扑序上以整段（同一提供者的连续子图）和单个节点为单位做局部搜索，
+// 只接受使"节点耗时 + 边界传输耗时"下降的移动，避免在CPU与设备之间来回搬运数据
+
+#include "inferunity/partitioner.h"
+#include "inferunity/graph.h"
+#include "inferunity/logger.h"
+#include "inferunity/operator.h"
+#include "inferunity/perf_counters.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr int kMaxSearchPasses = 64;
+
+bool IsMemcpyOp(const std::string& op_type) {
+    return op_type == "MemcpyToDevice" || op_type == "MemcpyFromDevice";
+}
+
+size_t ValueBytes(const Value* value) {
+    if (!value) {
+        return 0;
+    }
+    auto tensor = value->GetTensor();
+    if (tensor) {
+        return tensor->GetSizeInBytes();
+    }
+    const int64_t elements = value->GetShape().GetElementCount();
+    return elements > 0 ? static_cast<size_t>(elements) * GetDataTypeSize(value->GetDataType()) : 0;
+}
+
+// 值所在的内存：与主机共享内存的设备（见ExecutionProvider::SharesHostMemory）按主机计，不需要拷贝
+DeviceType MemoryDeviceOf(const ExecutionProvider* provider) {
+    return provider->SharesHostMemory() ? DeviceType::CPU : provider->GetDeviceType();
+}
+
+const char* DeviceSuffix(DeviceType device) {
+    switch (device) {
+        case DeviceType::CPU: return "cpu";
+        case DeviceType::CUDA: return "cuda";
+        case DeviceType::TENSORRT: return "tensorrt";
+        case DeviceType::VULKAN: return "vulkan";
+        case DeviceType::METAL: return "metal";
+        default: return "device";
+    }
+}
+
+} // anonymous namespace
+
+CostModel::CostModel() {
+    // 加载了机器画像（见MachineProfile）时CPU使用实测的全核峰值、内存带宽与线程池派发延迟
+    DeviceCostProfile cpu;
+    MachineProfile machine;
+    if (GetMachineProfile(&machine)) {
+        const RooflinePeaks peaks = machine.GetRooflinePeaks();
+        if (peaks.peak_gflops > 0) {
+            cpu.flops_per_us = peaks.peak_gflops * 1e3;
+        }
+        if (peaks.peak_gbps > 0) {
+            cpu.bytes_per_us = peaks.peak_gbps * 1e3;
+        }
+        if (machine.dispatch_latency_us > 0) {
+            cpu.launch_overhead_us = machine.dispatch_latency_us;
+        }
+    }
+    profiles_[static_cast<int>(DeviceType::CPU)] = cpu;
+    
+    DeviceCostProfile gpu;
+    gpu.flops_per_us = 5.0e6;
+    gpu.bytes_per_us = 3.0e5;
+    gpu.launch_overhead_us = 5.0;
+    profiles_[static_cast<int>(DeviceType::CUDA)] = gpu;
+    profiles_[static_cast<int>(DeviceType::TENSORRT)] = gpu;
+    
+    // 移动端DSP/NPU：算力高于CPU，与CPU共用内存带宽，每次调用有驱动（FastRPC等）开销
+    DeviceCostProfile npu;
+    npu.flops_per_us = 1.0e6;
+    npu.bytes_per_us = cpu.bytes_per_us;
+    npu.launch_overhead_us = 50.0;
+    profiles_[static_cast<int>(DeviceType::SNPE)] = npu;
+    profiles_[static_cast<int>(DeviceType::ARMNN)] = npu;
+}
+
+void CostModel::SetDeviceProfile(DeviceType device, const DeviceCostProfile& profile) {
+    profiles_[static_cast<int>(device)] = profile;
+}
+
+const DeviceCostProfile& CostModel::GetDeviceProfile(DeviceType device) const {
+    auto it = profiles_.find(static_cast<int>(device));
+    if (it == profiles_.end()) {
+        it = profiles_.find(static_cast<int>(DeviceType::CPU));
+    }
+    return it->second;
+}
+
+void CostModel::SetTransferProfile(double bytes_per_us, double latency_us) {
+    transfer_bytes_per_us_ = std::max(bytes_per_us, 1e-9);
+    transfer_latency_us_ = std::max(latency_us, 0.0);
+}
+
+void CostModel::RecordNodeTime(const std::string& provider, const std::string& key, double time_us) {
+    measured_[provider + "/" + key] = std::max(time_us, 0.0);
+}
+
+void CostModel::RecordProfile(const std::string& provider, const ProfilingResult& result) {
+    for (const auto& profile : result.node_profiles) {
+        RecordNodeTime(provider, profile.node_name, profile.execution_time_ms * 1000.0);
+    }
+}
+
+double CostModel::EstimateNodeTime(const Node* node, const ExecutionProvider* provider) const {
+    if (!node || !provider) {
+        return kInfinity;
+    }
+    if (IsMemcpyOp(node->GetOpType())) {
+        return 0.0;
+    }
+    const std::string prefix = provider->GetName() + "/";
+    if (!node->GetName().empty()) {
+        auto it = measured_.find(prefix + node->GetName());
+        if (it != measured_.end()) {
+            return it->second;
+        }
+    }
+    auto it = measured_.find(prefix + node->GetOpType());
+    if (it != measured_.end()) {
+        return it->second;
+    }
+    
+    const DeviceCostProfile& profile = GetDeviceProfile(provider->GetDeviceType());
+    const double compute = EstimateFlops(node) / std::max(profile.flops_per_us, 1e-9);
+    const double memory = static_cast<double>(EstimateBytes(node)) / std::max(profile.bytes_per_us, 1e-9);
+    return profile.launch_overhead_us + std::max(compute, memory);
+}
+
+double CostModel::EstimateTransferTime(size_t bytes, DeviceType src, DeviceType dst) const {
+    if (src == dst) {
+        return 0.0;
+    }
+    if (src != DeviceType::CPU && dst != DeviceType::CPU) {
+        return EstimateTransferTime(bytes, src, DeviceType::CPU) +
+               EstimateTransferTime(bytes, DeviceType::CPU, dst);
+    }
+    return transfer_latency_us_ + static_cast<double>(bytes) / transfer_bytes_per_us_;
+}
+
+OperatorCost CostModel::EstimateCost(const Node* node) {
+    if (!node) {
+        return OperatorCost();
+    }
+    // 已分配张量时用实际形状（如Profile时的动态形状），否则用形状推断的结果
+    auto describe = [](const std::vector<Value*>& values) {
+        std::vector<TensorInfo> infos;
+        infos.reserve(values.size());
+        for (const Value* value : values) {
+            TensorInfo info;
+            auto tensor = value ? value->GetTensor() : nullptr;
+            if (tensor) {
+                info.shape = tensor->GetShape();
+                info.dtype = tensor->GetDataType();
+            } else if (value) {
+                info.shape = value->GetShape();
+                info.dtype = value->GetDataType();
+            }
+            infos.push_back(info);
+        }
+        return infos;
+    };
+    const std::vector<TensorInfo> inputs = describe(node->GetInputs());
+    const std::vector<TensorInfo> outputs = describe(node->GetOutputs());
+    
+    auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+    if (!op) {
+        return EstimateElementwiseCost(inputs, outputs, GetElementwiseFlops(node->GetOpType()));
+    }
+    ApplyNodeAttributes(*node, op.get());
+    return op->EstimateCost(inputs, outputs);
+}
+
+double CostModel::EstimateFlops(const Node* node) {
+    return EstimateCost(node).flops;
+}
+
+size_t CostModel::EstimateBytes(const Node* node) {
+    return EstimateCost(node).GetBytes();
+}
+
+GraphPartitioner::GraphPartitioner(std::shared_ptr<const CostModel> cost_model)
+    : cost_model_(cost_model ? std::move(cost_model) : std::make_shared<CostModel>()) {}
+
+Status GraphPartitioner::Assign(const Graph* graph, const std::vector<ExecutionProvider*>& providers,
+                                PartitionResult* result) const {
+    if (!graph || !result) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph or result is null");
+    }
+    if (providers.empty()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No execution providers to partition across");
+    }
+    *result = PartitionResult();
+    
+    const std::vector<Node*> order = graph->TopologicalSort();
+    const size_t n = order.size();
+    const size_t num_providers = providers.size();
+    
+    // 每个节点在各提供者上的耗时，不支持为无穷大；没有提供者支持时回退到SelectProvider的选择
+    std::vector<std::vector<double>> times(n, std::vector<double>(num_providers, kInfinity));
+    std::vector<size_t> assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        bool supported = false;
+        for (size_t p = 0; p < num_providers; ++p) {
+            if (providers[p]->SupportsOperatorId(order[i]->GetOpTypeId())) {
+                times[i][p] = cost_model_->EstimateNodeTime(order[i], providers[p]);
+                supported = true;
+            }
+        }
+        if (!supported) {
+            ExecutionProvider* fallback = ExecutionProviderSelector::SelectProvider(order[i], providers);
+            const size_t p = static_cast<size_t>(
+                std::find(providers.begin(), providers.end(), fallback) - providers.begin());
+            times[i][p] = cost_model_->EstimateNodeTime(order[i], fallback);
+        }
+        assign[i] = static_cast<size_t>(
+            std::min_element(times[i].begin(), times[i].end()) - times[i].begin());
+    }
+    
+    // 值的编号、字节数与相邻关系；图输入与常量位于主机，图输出需要回到主机
+    const auto& values = graph->GetValues();
+    std::unordered_map<const Value*, size_t> value_index;
+    for (size_t v = 0; v < values.size(); ++v) {
+        value_index[values[v].get()] = v;
+    }
+    std::vector<size_t> value_bytes(values.size(), 0);
+    std::vector<int> producer(values.size(), -1);
+    std::vector<std::vector<size_t>> value_consumers(values.size());
+    std::vector<char> is_output(values.size(), 0);
+    std::vector<std::vector<size_t>> node_values(n);  // 节点的输入与输出值
+    for (size_t v = 0; v < values.size(); ++v) {
+        value_bytes[v] = ValueBytes(values[v].get());
+    }
+    for (const Value* output : graph->GetOutputs()) {
+        auto it = value_index.find(output);
+        if (it != value_index.end()) {
+            is_output[it->second] = 1;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (const Value* input : order[i]->GetInputs()) {
+            auto it = value_index.find(input);
+            if (it == value_index.end()) continue;
+            value_consumers[it->second].push_back(i);
+            node_values[i].push_back(it->second);
+        }
+        for (const Value* output : order[i]->GetOutputs()) {
+            auto it = value_index.find(output);
+            if (it == value_index.end()) continue;
+            producer[it->second] = static_cast<int>(i);
+            node_values[i].push_back(it->second);
+        }
+    }
+    
+    auto device_of = [&](size_t i) { return MemoryDeviceOf(providers[assign[i]]); };
+    // 一个值的传输代价：从所在设备向每个不同的消费设备各搬运一次
+    auto value_cost = [&](size_t v) {
+        const DeviceType home = producer[v] >= 0 ? device_of(static_cast<size_t>(producer[v])) : DeviceType::CPU;
+        std::vector<DeviceType> targets;
+        if (is_output[v]) {
+            targets.push_back(DeviceType::CPU);
+        }
+        for (size_t c : value_consumers[v]) {
+            targets.push_back(device_of(c));
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        double cost = 0.0;
+        for (DeviceType target : targets) {
+            cost += cost_model_->EstimateTransferTime(value_bytes[v], home, target);
+        }
+        return cost;
+    };
+    
+    // 一组节点的局部代价：自身耗时加上相邻值的传输代价（只有这部分随这组节点的移动而变化）
+    std::vector<int> stamp(values.size(), -1);
+    int current_stamp = 0;
+    auto local_cost = [&](size_t begin, size_t end) {
+        ++current_stamp;
+        double cost = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            cost += times[i][assign[i]];
+            for (size_t v : node_values[i]) {
+                if (stamp[v] != current_stamp) {
+                    stamp[v] = current_stamp;
+                    cost += value_cost(v);
+                }
+            }
+        }
+        return cost;
+    };
+    
+    // 把[begin, end)移到提供者p上，代价下降时保留
+    auto try_move = [&](size_t begin, size_t end, size_t p) {
+        for (size_t i = begin; i < end; ++i) {
+            if (times[i][p] == kInfinity) {
+                return false;
+            }
+        }
+        std::vector<size_t> saved(assign.begin() + begin, assign.begin() + end);
+        const double before = local_cost(begin, end);
+        std::fill(assign.begin() + begin, assign.begin() + end, p);
+        const double after = local_cost(begin, end);
+        if (after < before - 1e-9) {
+            return true;
+        }
+        std::copy(saved.begin(), saved.end(), assign.begin() + begin);
+        return false;
+    };
+    
+    auto segments = [&]() {
+        std::vector<std::pair<size_t, size_t>> result_segments;
+        for (size_t i = 0; i < n;) {
+            size_t j = i + 1;
+            while (j < n && assign[j] == assign[i]) ++j;
+            result_segments.emplace_back(i, j);
+            i = j;
+        }
+        return result_segments;
+    };
+    
+    for (int pass = 0; pass < kMaxSearchPasses; ++pass) {
+        bool improved = false;
+        for (const auto& segment : segments()) {
+            for (size_t p = 0; p < num_providers; ++p) {
+                if (p != assign[segment.first] && try_move(segment.first, segment.second, p)) {
+                    improved = true;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t p = 0; p < num_providers; ++p) {
+                if (p != assign[i] && try_move(i, i + 1, p)) {
+                    improved = true;
+                    break;
+                }
+            }
+        }
+        if (!improved) {
+            break;
+        }
+    }
+    
+    double latency = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        latency += times[i][assign[i]];
+        result->assignment[order[i]] = providers[assign[i]];
+    }
+    for (size_t v = 0; v < values.size(); ++v) {
+        latency += value_cost(v);
+    }
+    result->num_partitions = segments().size();
+    result->estimated_latency_us = latency;
+    return Status::Ok();
+}
+
+Status GraphPartitioner::Partition(Graph* graph, const std::vector<ExecutionProvider*>& providers,
+                                   PartitionResult* result) const {
+    Status status = Assign(graph, providers, result);
+    if (!status.IsOk()) {
+        return status;
+    }
+    auto& assignment = result->assignment;
+    auto device_of = [&assignment](const Node* node) {
+        auto it = assignment.find(node);
+        return it != assignment.end() ? MemoryDeviceOf(it->second) : DeviceType::CPU;
+    };
+    
+    // 先收集现有的值，插入拷贝时会追加新值
+    std::vector<Value*> values;
+    for (const auto& value : graph->GetValues()) {
+        values.push_back(value.get());
+    }
+    std::unordered_map<const Value*, char> graph_outputs;
+    for (const Value* output : graph->GetOutputs()) {
+        graph_outputs[output] = 1;
+    }
+    
+    for (Value* value : values) {
+        Node* producer = value->GetProducer();
+        const bool produced = producer && assignment.count(producer);
+        const DeviceType home = produced ? device_of(producer) : DeviceType::CPU;
+        
+        // 同一值在每个设备上最多一份拷贝，由该设备上的所有消费者共享
+        std::unordered_map<int, Value*> copies;
+        copies[static_cast<int>(home)] = value;
+        std::function<Value*(DeviceType, ExecutionProvider*)> get_copy =
+            [&](DeviceType device, ExecutionProvider* target) -> Value* {
+            auto it = copies.find(static_cast<int>(device));
+            if (it != copies.end()) {
+                return it->second;
+            }
+            const std::string base = value->GetName().empty()
+                ? "value" + std::to_string(value->GetId()) : value->GetName();
+            Value* source = value;
+            ExecutionProvider* executor = target;
+            std::string op_type = "MemcpyToDevice";
+            if (device == DeviceType::CPU) {
+                // 设备到主机的拷贝由源设备的提供者执行
+                op_type = "MemcpyFromDevice";
+                executor = assignment[producer];
+            } else if (home != DeviceType::CPU) {
+                source = get_copy(DeviceType::CPU, nullptr);
+            }
+            Node* copy = graph->AddNode(op_type, base + "_to_" + DeviceSuffix(device));
+            Value* copied = graph->AddValue();
+            copied->SetName(copy->GetName());
+            copy->AddInput(source);
+            copy->AddOutput(copied);
+            copy->SetDevice(executor->GetDeviceType());
+            assignment[copy] = executor;
+            ++result->num_copies;
+            copies[static_cast<int>(device)] = copied;
+            return copied;
+        };
+        
+        // 快照消费者列表：ReplaceInput会修改它
+        const std::vector<Node*> consumers = value->GetConsumers();
+        for (Node* consumer : consumers) {
+            auto it = assignment.find(consumer);
+            if (it == assignment.end() || IsMemcpyOp(consumer->GetOpType())) {
+                continue;
+            }
+            const DeviceType device = MemoryDeviceOf(it->second);
+            if (device != home) {
+                consumer->ReplaceInput(value, get_copy(device, it->second));
+            }
+        }
+        
+        // 位于设备上的图输出拷回主机，拷贝沿用原输出名，用户看到的名字不变
+        if (graph_outputs.count(value) && home != DeviceType::CPU) {
+            Value* host = get_copy(DeviceType::CPU, nullptr);
+            graph->ReplaceOutput(value, host);
+            const std::string name = value->GetName();
+            value->SetName(host->GetName());
+            host->SetName(name);
+        }
+    }
+    
+    for (const auto& node : graph->GetNodes()) {
+        auto it = assignment.find(node.get());
+        node->SetDevice(it != assignment.end() ? it->second->GetDeviceType() : DeviceType::CPU);
+    }
+    LOG_INFO("Graph partitioned into " + std::to_string(result->num_partitions) + " partitions with " +
+             std::to_string(result->num_copies) + " copies, estimated latency " +
+             std::to_string(result->estimated_latency_us) + " us");
+    return Status::Ok();
+}
+
+std::shared_ptr<Tensor> MetadataTensor(const Value* value) {
+    const Tensor* tensor = value->GetTensor().get();
+    return tensor ? std::make_shared<Tensor>(tensor->GetShape(), tensor->GetDataType(), nullptr) : nullptr;
+}
+
+namespace {
+
+// 把is_candidate选中的节点生长成子图交给delegate编译；少于min_nodes个节点的子图保留原样
+Status DelegateSubgraphs(Graph* graph, ExecutionProvider* delegate, const std::function<bool(const Node*)>& is_candidate,
+                         size_t min_nodes, const std::string& name_prefix, DelegationResult* result) {
+    if (!graph || !delegate || !result) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph, delegate and result must be non-null");
+    }
+    *result = DelegationResult();
+    
+    // 按拓扑序生长子图：upstream[n]为n的所有上游节点所在的子图。节点并入生产者所在的子图c时，
+    // 它的其余生产者都不能位于c的下游，否则c -> 子图外节点 -> c成环
+    std::unordered_map<const Node*, int> cluster_of;
+    std::unordered_map<const Node*, std::set<int>> upstream;
+    std::vector<std::vector<Node*>> clusters;
+    for (Node* node : graph->TopologicalSort()) {
+        std::set<int>& up = upstream[node];
+        std::vector<int> candidates;
+        for (Value* input : node->GetInputs()) {
+            Node* producer = input->GetProducer();
+            if (!producer) {
+                continue;
+            }
+            const std::set<int>& producer_up = upstream[producer];
+            up.insert(producer_up.begin(), producer_up.end());
+            auto it = cluster_of.find(producer);
+            if (it != cluster_of.end()) {
+                up.insert(it->second);
+                candidates.push_back(it->second);
+            }
+        }
+        if (!is_candidate(node)) {
+            continue;
+        }
+        
+        int chosen = -1;
+        for (int c : candidates) {
+            bool acyclic = true;
+            for (Value* input : node->GetInputs()) {
+                Node* producer = input->GetProducer();
+                if (!producer) {
+                    continue;
+                }
+                auto it = cluster_of.find(producer);
+                if ((it == cluster_of.end() || it->second != c) && upstream[producer].count(c)) {
+                    acyclic = false;
+                    break;
+                }
+            }
+            if (acyclic) {
+                chosen = c;
+                break;
+            }
+        }
+        if (chosen < 0) {
+            chosen = static_cast<int>(clusters.size());
+            clusters.emplace_back();
+        }
+        cluster_of[node] = chosen;
+        clusters[chosen].push_back(node);
+    }
+    
+    const std::unordered_set<const Value*> graph_inputs(graph->GetInputs().begin(), graph->GetInputs().end());
+    const std::unordered_set<const Value*> graph_outputs(graph->GetOutputs().begin(), graph->GetOutputs().end());
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        const std::vector<Node*>& members = clusters[c];
+        if (members.size() < std::max<size_t>(min_nodes, 1)) {
+            continue;
+        }
+        const std::unordered_set<const Node*> inside(members.begin(), members.end());
+        
+        // 子图边界：来自子图外的值作为输入（常量随子图带走），被子图外消费或作为图输出的值作为输出
+        std::vector<Value*> inputs;
+        std::vector<Value*> constants;
+        std::vector<Value*> outputs;
+        std::vector<Value*> internal;
+        std::unordered_set<const Value*> seen;
+        for (Node* node : members) {
+            for (Value* input : node->GetInputs()) {
+                if (inside.count(input->GetProducer()) || !seen.insert(input).second) {
+                    continue;
+                }
+                const Tensor* tensor = input->GetTensor().get();
+                if (!input->GetProducer() && !graph_inputs.count(input) && tensor && tensor->GetData()) {
+                    constants.push_back(input);
+                } else {
+                    inputs.push_back(input);
+                }
+            }
+        }
+        for (Node* node : members) {
+            for (Value* output : node->GetOutputs()) {
+                bool external = graph_outputs.count(output) > 0;
+                for (Node* consumer : output->GetConsumers()) {
+                    external = external || !inside.count(consumer);
+                }
+                (external ? outputs : internal).push_back(output);
+            }
+        }
+        
+        auto subgraph = std::make_unique<Graph>();
+        std::unordered_map<const Value*, Value*> mapped;
+        auto map_value = [&](Value* value) {
+            auto it = mapped.find(value);
+            if (it != mapped.end()) {
+                return it->second;
+            }
+            Value* copy = subgraph->AddValue();
+            copy->SetName(value->GetName().empty() ? "value_" + std::to_string(value->GetId()) : value->GetName());
+            mapped[value] = copy;
+            return copy;
+        };
+        for (Value* input : inputs) {
+            Value* copy = map_value(input);
+            copy->SetTensor(MetadataTensor(input));
+            subgraph->AddInput(copy);
+        }
+        for (Value* constant : constants) {
+            map_value(constant)->SetTensor(constant->GetTensor());
+        }
+        for (Node* node : members) {
+            Node* copy = subgraph->AddNode(node->GetOpType(), node->GetName());
+            for (const auto& attr : node->GetAttributes()) {
+                copy->SetAttribute(attr.first, attr.second);
+            }
+            for (Value* input : node->GetInputs()) {
+                copy->AddInput(map_value(input));
+            }
+            for (Value* output : node->GetOutputs()) {
+                copy->AddOutput(map_value(output));
+            }
+        }
+        for (Value* output : outputs) {
+            Value* copy = map_value(output);
+            copy->SetTensor(MetadataTensor(output));
+            subgraph->AddOutput(copy);
+        }
+        
+        // 编译失败时保留原节点，由后续的提供者分配报告不支持的算子
+        Node* fused = graph->AddNode(kDelegatedSubgraphOp, name_prefix + std::to_string(c));
+        Status status = delegate->CompileSubgraph(fused, std::move(subgraph));
+        if (!status.IsOk()) {
+            LOG_WARNING("Subgraph delegation to " + delegate->GetName() + " failed: " + status.Message());
+            graph->RemoveNode(fused);
+            continue;
+        }
+        
+        for (Node* node : members) {
+            graph->RemoveNode(node);
+        }
+        for (Value* input : inputs) {
+            fused->AddInput(input);
+        }
+        for (Value* output : outputs) {
+            fused->AddOutput(output);
+        }
+        fused->SetDevice(delegate->GetDeviceType());
+        for (Value* value : internal) {
+            graph->RemoveValue(value);
+        }
+        for (Value* constant : constants) {
+            if (constant->GetConsumers().empty() && !graph_outputs.count(constant)) {
+                graph->RemoveValue(constant);
+            }
+        }
+        
+        result->assignment[fused] = delegate;
+        ++result->num_subgraphs;
+        result->num_delegated_nodes += members.size();
+    }
+    
+    if (result->num_subgraphs > 0) {
+        LOG_INFO("Delegated " + std::to_string(result->num_delegated_nodes) + " nodes in " +
+                 std::to_string(result->num_subgraphs) + " subgraphs to " + delegate->GetName());
+    }
+    return Status::Ok();
+}
+
+} // namespace
+
+Status DelegateUnsupportedSubgraphs(Graph* graph, const std::vector<ExecutionProvider*>& native_providers,
+                                    ExecutionProvider* delegate, DelegationResult* result) {
+    auto is_unsupported = [&native_providers](const Node* node) {
+        if (IsMemcpyOp(node->GetOpType())) {
+            return false;
+        }
+        for (ExecutionProvider* provider : native_providers) {
+            if (provider->SupportsOperatorId(node->GetOpTypeId())) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return DelegateSubgraphs(graph, delegate, is_unsupported, 1, "delegated_subgraph_", result);
+}
+
+Status DelegateClaimedSubgraphs(Graph* graph, ExecutionProvider* delegate, size_t min_nodes,
+                                DelegationResult* result) {
+    auto is_claimed = [delegate](const Node* node) {
+        return !IsMemcpyOp(node->GetOpType()) && delegate->CanCompileNode(node);
+    };
+    return DelegateSubgraphs(graph, delegate, is_claimed, min_nodes, "claimed_subgraph_", result);
+}
+
+} // namespace inferunity
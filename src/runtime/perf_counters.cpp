@@ -0,0 +1,450 @@
+// 硬件性能计数器实现
+// 每个线程两组事件：通用组以周期为组长（指令、LLC访问、LLC未命中为成员），
+// 浮点组只在Intel上打开；组内以PERF_FORMAT_GROUP一次读出，多路复用时按time_enabled/time_running缩放
+
+#include "inferunity/perf_counters.h"
+#include "inferunity/cpu_features.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace inferunity {
+
+HardwareCounterValues& HardwareCounterValues::operator+=(const HardwareCounterValues& other) {
+    cycles += other.cycles;
+    instructions += other.instructions;
+    llc_references += other.llc_references;
+    llc_misses += other.llc_misses;
+    fp_ops += other.fp_ops;
+    has_fp_ops = has_fp_ops || other.has_fp_ops;
+    return *this;
+}
+
+HardwareCounterValues operator-(const HardwareCounterValues& end, const HardwareCounterValues& start) {
+    auto diff = [](uint64_t a, uint64_t b) { return a > b ? a - b : 0; };
+    HardwareCounterValues result;
+    result.cycles = diff(end.cycles, start.cycles);
+    result.instructions = diff(end.instructions, start.instructions);
+    result.llc_references = diff(end.llc_references, start.llc_references);
+    result.llc_misses = diff(end.llc_misses, start.llc_misses);
+    result.fp_ops = diff(end.fp_ops, start.fp_ops);
+    result.has_fp_ops = end.has_fp_ops;
+    return result;
+}
+
+#if defined(__linux__)
+
+namespace {
+
+// 组内事件累加到HardwareCounterValues的哪个字段，以及权重（浮点事件的向量宽度）
+enum class CounterField { CYCLES, INSTRUCTIONS, LLC_REFERENCES, LLC_MISSES, FP_OPS };
+
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+    CounterField field;
+    uint64_t weight;
+};
+
+// 打开的一组事件：fields与读出的值一一对应（打开失败的成员不在其中）
+struct EventGroup {
+    int leader = -1;
+    std::vector<int> fds;
+    std::vector<CounterField> fields;
+    std::vector<uint64_t> weights;
+};
+
+long PerfEventOpen(perf_event_attr* attr, pid_t tid, int group_fd) {
+    return syscall(__NR_perf_event_open, attr, tid, -1, group_fd, 0);
+}
+
+bool IsIntelCpu() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    char vendor[13];
+    std::memcpy(vendor, &ebx, 4);
+    std::memcpy(vendor + 4, &edx, 4);
+    std::memcpy(vendor + 8, &ecx, 4);
+    vendor[12] = '\0';
+    return std::strcmp(vendor, "GenuineIntel") == 0;
+#else
+    return false;
+#endif
+}
+
+const std::vector<EventSpec>& GeneralEvents() {
+    static const std::vector<EventSpec> events = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, CounterField::CYCLES, 1},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, CounterField::INSTRUCTIONS, 1},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, CounterField::LLC_REFERENCES, 1},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, CounterField::LLC_MISSES, 1},
+    };
+    return events;
+}
+
+// FP_ARITH_INST_RETIRED（事件0xC7）：标量、128位、256位、512位单精度，权重为每条指令的元素数
+const std::vector<EventSpec>& FloatEvents() {
+    static const std::vector<EventSpec> events = {
+        {PERF_TYPE_RAW, 0x02C7, CounterField::FP_OPS, 1},
+        {PERF_TYPE_RAW, 0x08C7, CounterField::FP_OPS, 4},
+        {PERF_TYPE_RAW, 0x20C7, CounterField::FP_OPS, 8},
+        {PERF_TYPE_RAW, 0x80C7, CounterField::FP_OPS, 16},
+    };
+    return events;
+}
+
+void CloseGroup(EventGroup& group) {
+    for (int fd : group.fds) {
+        close(fd);
+    }
+    group = EventGroup();
+}
+
+// 组长打开失败时返回false并设置errno；成员失败时跳过该事件
+bool OpenGroup(pid_t tid, const std::vector<EventSpec>& events, EventGroup* group) {
+    for (const EventSpec& spec : events) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = spec.type;
+        attr.config = spec.config;
+        attr.disabled = group->leader < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const int fd = static_cast<int>(PerfEventOpen(&attr, tid, group->leader));
+        if (fd < 0) {
+            if (group->leader < 0) {
+                return false;
+            }
+            continue;
+        }
+        if (group->leader < 0) {
+            group->leader = fd;
+        }
+        group->fds.push_back(fd);
+        group->fields.push_back(spec.field);
+        group->weights.push_back(spec.weight);
+    }
+    ioctl(group->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void ReadGroup(const EventGroup& group, HardwareCounterValues* values) {
+    if (group.leader < 0) {
+        return;
+    }
+    // {nr, time_enabled, time_running, value[nr]}
+    std::vector<uint64_t> buffer(3 + group.fds.size(), 0);
+    const ssize_t bytes = read(group.leader, buffer.data(), buffer.size() * sizeof(uint64_t));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return;
+    }
+    const uint64_t count = std::min<uint64_t>(buffer[0], group.fds.size());
+    const double scale = buffer[2] > 0 ? static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]) : 0.0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t value = static_cast<uint64_t>(static_cast<double>(buffer[3 + i]) * scale) *
+                               group.weights[i];
+        switch (group.fields[i]) {
+            case CounterField::CYCLES: values->cycles += value; break;
+            case CounterField::INSTRUCTIONS: values->instructions += value; break;
+            case CounterField::LLC_REFERENCES: values->llc_references += value; break;
+            case CounterField::LLC_MISSES: values->llc_misses += value; break;
+            case CounterField::FP_OPS: values->fp_ops += value; break;
+        }
+    }
+}
+
+std::vector<pid_t> ListThreads() {
+    std::vector<pid_t> threads;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) {
+        threads.push_back(static_cast<pid_t>(syscall(SYS_gettid)));
+        return threads;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            threads.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+        }
+    }
+    closedir(dir);
+    return threads;
+}
+
+} // anonymous namespace
+
+struct HardwareCounters::Impl {
+    std::vector<EventGroup> general;
+    std::vector<EventGroup> fp;
+};
+
+HardwareCounters::HardwareCounters() : impl_(new Impl()) {}
+
+HardwareCounters::~HardwareCounters() {
+    Close();
+}
+
+Status HardwareCounters::Open() {
+    Close();
+    const bool intel = IsIntelCpu();
+    for (pid_t tid : ListThreads()) {
+        EventGroup group;
+        if (!OpenGroup(tid, GeneralEvents(), &group)) {
+            const int error = errno;
+            if (error == ESRCH) {
+                continue;  // 线程在枚举之后退出
+            }
+            Close();
+            if (error == EACCES || error == EPERM) {
+                return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                     "perf_event_open not permitted (check /proc/sys/kernel/perf_event_paranoid)");
+            }
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                 std::string("Hardware counters unavailable: ") + std::strerror(error));
+        }
+        impl_->general.push_back(std::move(group));
+        if (intel) {
+            EventGroup fp_group;
+            if (OpenGroup(tid, FloatEvents(), &fp_group)) {
+                impl_->fp.push_back(std::move(fp_group));
+            }
+        }
+    }
+    if (impl_->general.empty()) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "No threads to count");
+    }
+    return Status::Ok();
+}
+
+void HardwareCounters::Close() {
+    for (auto& group : impl_->general) {
+        CloseGroup(group);
+    }
+    for (auto& group : impl_->fp) {
+        CloseGroup(group);
+    }
+    impl_->general.clear();
+    impl_->fp.clear();
+}
+
+bool HardwareCounters::IsOpen() const {
+    return !impl_->general.empty();
+}
+
+HardwareCounterValues HardwareCounters::Read() const {
+    HardwareCounterValues values;
+    for (const auto& group : impl_->general) {
+        ReadGroup(group, &values);
+    }
+    for (const auto& group : impl_->fp) {
+        ReadGroup(group, &values);
+    }
+    values.has_fp_ops = !impl_->fp.empty();
+    return values;
+}
+
+#else  // !__linux__
+
+struct HardwareCounters::Impl {};
+
+HardwareCounters::HardwareCounters() : impl_(new Impl()) {}
+HardwareCounters::~HardwareCounters() = default;
+
+Status HardwareCounters::Open() {
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Hardware counters require Linux perf_event");
+}
+
+void HardwareCounters::Close() {}
+
+bool HardwareCounters::IsOpen() const {
+    return false;
+}
+
+HardwareCounterValues HardwareCounters::Read() const {
+    return HardwareCounterValues();
+}
+
+#endif
+
+double RooflinePeaks::GetRooflineTimeMs(double flops, double bytes) const {
+    const double compute_ms = peak_gflops > 0 ? flops / (peak_gflops * 1e6) : 0.0;
+    const double memory_ms = peak_gbps > 0 ? bytes / (peak_gbps * 1e6) : 0.0;
+    return std::max(compute_ms, memory_ms);
+}
+
+double EstimatePeakGflops(double cpu_ghz) {
+    const CpuFeatures& features = GetCpuFeatures();
+    const double lanes = features.avx512f ? 16.0 : (features.avx || features.avx2) ? 8.0 : 4.0;
+    const double fma_units = features.fma || features.neon ? 2.0 : 1.0;
+    const double flops_per_cycle = lanes * 2.0 * fma_units;
+    return flops_per_cycle * cpu_ghz * static_cast<double>(ThreadPool::GetThreadCount());
+}
+
+double MeasureMemoryBandwidthGbps() {
+    const size_t bytes = 256u << 20;
+    std::vector<char> src(bytes, 1);
+    std::vector<char> dst(bytes, 0);
+    const int64_t chunk = 1 << 20;
+    const int64_t chunks = static_cast<int64_t>(bytes) / chunk;
+    double best_gbps = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        ThreadPool::ParallelFor(0, chunks, 1, [&](int64_t begin, int64_t end) {
+            std::memcpy(dst.data() + begin * chunk, src.data() + begin * chunk,
+                        static_cast<size_t>((end - begin) * chunk));
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best_gbps = std::max(best_gbps, 2.0 * static_cast<double>(bytes) / seconds / 1e9);
+    }
+    return best_gbps;
+}
+
+namespace {
+
+const char* const kMachineProfileHeader = "# inferunity machine profile v1";
+
+std::mutex g_machine_profile_mutex;
+std::unique_ptr<MachineProfile> g_machine_profile;
+
+} // anonymous namespace
+
+RooflinePeaks MachineProfile::GetRooflinePeaks() const {
+    RooflinePeaks peaks;
+    for (const auto& entry : all_core_peak_gflops) {
+        peaks.peak_gflops = std::max(peaks.peak_gflops, entry.second);
+    }
+    peaks.peak_gbps = dram_gbps;
+    return peaks;
+}
+
+Status MachineProfile::Save(const std::string& path) const {
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot write " + temp);
+        }
+        file.precision(17);
+        file << kMachineProfileHeader << "\n";
+        file << "cpu_model " << cpu_model << "\n";
+        file << "threads " << threads << "\n";
+        for (const auto& entry : core_peak_gflops) {
+            file << "core_peak_gflops." << entry.first << " " << entry.second << "\n";
+        }
+        for (const auto& entry : all_core_peak_gflops) {
+            file << "all_core_peak_gflops." << entry.first << " " << entry.second << "\n";
+        }
+        file << "l1_gbps " << l1_gbps << "\n";
+        file << "l2_gbps " << l2_gbps << "\n";
+        file << "l3_gbps " << l3_gbps << "\n";
+        file << "dram_gbps " << dram_gbps << "\n";
+        file << "dispatch_latency_us " << dispatch_latency_us << "\n";
+        if (!file) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot write " + temp);
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot replace " + path);
+    }
+    return Status::Ok();
+}
+
+Status MachineProfile::Load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_NOT_FOUND, "Cannot open machine profile " + path);
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != kMachineProfileHeader) {
+        return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Unrecognized machine profile: " + path);
+    }
+    MachineProfile loaded;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t space = line.find(' ');
+        const std::string key = line.substr(0, space);
+        const std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+        if (key == "cpu_model") {
+            loaded.cpu_model = value;
+            continue;
+        }
+        std::istringstream fields(value);
+        double number = 0.0;
+        if (!(fields >> number)) {
+            return Status::Error(StatusCode::ERROR_INVALID_MODEL, "Malformed machine profile entry: " + line);
+        }
+        const size_t dot = key.find('.');
+        if (dot != std::string::npos && key.compare(0, dot, "core_peak_gflops") == 0) {
+            loaded.core_peak_gflops[key.substr(dot + 1)] = number;
+        } else if (dot != std::string::npos && key.compare(0, dot, "all_core_peak_gflops") == 0) {
+            loaded.all_core_peak_gflops[key.substr(dot + 1)] = number;
+        } else if (key == "threads") {
+            loaded.threads = static_cast<size_t>(number);
+        } else if (key == "l1_gbps") {
+            loaded.l1_gbps = number;
+        } else if (key == "l2_gbps") {
+            loaded.l2_gbps = number;
+        } else if (key == "l3_gbps") {
+            loaded.l3_gbps = number;
+        } else if (key == "dram_gbps") {
+            loaded.dram_gbps = number;
+        } else if (key == "dispatch_latency_us") {
+            loaded.dispatch_latency_us = number;
+        }
+        // 未知的键来自更新的版本，忽略
+    }
+    *this = std::move(loaded);
+    return Status::Ok();
+}
+
+void SetMachineProfile(const MachineProfile& profile) {
+    std::lock_guard<std::mutex> lock(g_machine_profile_mutex);
+    g_machine_profile = std::make_unique<MachineProfile>(profile);
+}
+
+bool GetMachineProfile(MachineProfile* profile) {
+    std::lock_guard<std::mutex> lock(g_machine_profile_mutex);
+    if (!g_machine_profile) {
+        return false;
+    }
+    *profile = *g_machine_profile;
+    return true;
+}
+
+Status LoadMachineProfile(const std::string& path) {
+    MachineProfile profile;
+    Status status = profile.Load(path);
+    if (status.IsOk()) {
+        SetMachineProfile(profile);
+    }
+    return status;
+}
+
+} // namespace inferunity
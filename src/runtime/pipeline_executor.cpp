@@ -0,0 +1,400 @@
+// 流水线执行
+// 参考GPipe的micro-batch流水线：执行计划按代价切成连续的阶段，每个阶段一个专用线程，
+// 相邻阶段之间是有界的单生产者单消费者环形队列；队列满时上游阶段等待，形成背压。
+// 每个在途的micro-batch持有自己的ExecutionState，阶段之间只传递指针，不拷贝张量
+
+#include "inferunity/runtime.h"
+#include "inferunity/graph.h"
+#include "runtime/cpu_relax.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace inferunity {
+
+namespace {
+
+constexpr int kSpinIterations = 1024;
+
+} // anonymous namespace
+
+std::vector<size_t> PartitionByCost(const std::vector<double>& costs, size_t num_stages) {
+    const size_t n = costs.size();
+    num_stages = std::max<size_t>(num_stages, 1);
+    
+    // 贪心切分：区间代价超过limit时开始新的区间
+    auto greedy = [&costs, num_stages](double limit) {
+        std::vector<size_t> bounds = {0};
+        double sum = 0.0;
+        for (size_t i = 0; i < costs.size(); ++i) {
+            if (sum > 0.0 && sum + costs[i] > limit && bounds.size() < num_stages) {
+                bounds.push_back(i);
+                sum = 0.0;
+            }
+            sum += costs[i];
+        }
+        return bounds;
+    };
+    auto parts_needed = [&costs](double limit) {
+        size_t parts = 1;
+        double sum = 0.0;
+        for (double cost : costs) {
+            if (sum > 0.0 && sum + cost > limit) {
+                ++parts;
+                sum = 0.0;
+            }
+            sum += cost;
+        }
+        return parts;
+    };
+    
+    // 二分查找能切成不超过num_stages个区间的最小区间代价上限
+    double lo = n ? *std::max_element(costs.begin(), costs.end()) : 0.0;
+    double hi = std::accumulate(costs.begin(), costs.end(), 0.0);
+    for (int iter = 0; iter < 64 && hi - lo > 1e-9 * std::max(hi, 1.0); ++iter) {
+        const double mid = 0.5 * (lo + hi);
+        if (parts_needed(mid) <= num_stages) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    std::vector<size_t> bounds = greedy(hi);
+    
+    // 区间不足num_stages个时继续切分代价最大的可切区间（不会增大最大代价）
+    auto part_cost = [&costs](size_t begin, size_t end) {
+        return std::accumulate(costs.begin() + begin, costs.begin() + end, 0.0);
+    };
+    while (bounds.size() < num_stages && bounds.size() < n) {
+        size_t best = 0;
+        double best_cost = -1.0;
+        for (size_t p = 0; p < bounds.size(); ++p) {
+            const size_t end = p + 1 < bounds.size() ? bounds[p + 1] : n;
+            const double cost = part_cost(bounds[p], end);
+            if (end - bounds[p] > 1 && cost > best_cost) {
+                best = p;
+                best_cost = cost;
+            }
+        }
+        const size_t begin = bounds[best];
+        const size_t end = best + 1 < bounds.size() ? bounds[best + 1] : n;
+        // 切在使前半段代价最接近一半之处
+        size_t split = begin + 1;
+        double prefix = costs[begin];
+        while (split + 1 < end && prefix + costs[split] <= best_cost / 2) {
+            prefix += costs[split];
+            ++split;
+        }
+        bounds.insert(bounds.begin() + static_cast<std::ptrdiff_t>(best) + 1, split);
+    }
+    // 元素少于阶段数时，其余阶段为空
+    while (bounds.size() < num_stages) {
+        bounds.push_back(n);
+    }
+    bounds.push_back(n);
+    return bounds;
+}
+
+// PipelineScheduler实现
+PipelineScheduler::PipelineScheduler(int num_stages) : num_stages_(std::max(num_stages, 1)) {}
+
+Status PipelineScheduler::Schedule(const Graph* graph,
+                                  const std::vector<Backend*>& backends,
+                                  ExecutionContext* ctx) {
+    PartitionGraph(graph);
+    (void)backends; (void)ctx;
+    return Status::Ok();
+}
+
+std::vector<Node*> PipelineScheduler::GetExecutionOrder(const Graph* graph) const {
+    if (stages_.empty()) {
+        return graph->TopologicalSort();
+    }
+    std::vector<Node*> order;
+    for (const auto& stage : stages_) {
+        order.insert(order.end(), stage.begin(), stage.end());
+    }
+    return order;
+}
+
+void PipelineScheduler::PartitionGraph(const Graph* graph) {
+    std::vector<Node*> sorted = graph->TopologicalSort();
+    std::vector<double> costs;
+    costs.reserve(sorted.size());
+    for (Node* node : sorted) {
+        auto it = node_costs_.find(node->GetName());
+        costs.push_back(it != node_costs_.end() ? it->second
+                                                : static_cast<double>(EstimateNodeCost(node)));
+    }
+    
+    const std::vector<size_t> bounds = PartitionByCost(costs, static_cast<size_t>(num_stages_));
+    stages_.assign(static_cast<size_t>(num_stages_), {});
+    for (size_t s = 0; s < stages_.size(); ++s) {
+        stages_[s].assign(sorted.begin() + static_cast<std::ptrdiff_t>(bounds[s]),
+                          sorted.begin() + static_cast<std::ptrdiff_t>(bounds[s + 1]));
+    }
+}
+
+struct PipelineExecutor::MicroBatch {
+    size_t index = 0;
+    ExecutionState* state = nullptr;
+    Status status = Status::Ok();
+};
+
+// 单生产者单消费者的有界环形队列：先自旋等待，超过自旋次数后在条件变量上休眠。
+// 下标以seq_cst读写，与waiters_配合保证休眠方不会错过另一端的唤醒
+class PipelineExecutor::Queue {
+public:
+    explicit Queue(size_t capacity) : slots_(capacity + 1, nullptr) {}
+    
+    // 关闭后返回false
+    bool Push(MicroBatch* item) {
+        Wait([this] { return closed_.load() || !Full(); });
+        if (closed_.load()) {
+            return false;
+        }
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        slots_[tail] = item;
+        tail_.store(Next(tail));
+        Notify();
+        return true;
+    }
+    
+    // 关闭且已取空时返回false
+    bool Pop(MicroBatch** item) {
+        Wait([this] { return closed_.load() || !Empty(); });
+        if (Empty()) {
+            return false;
+        }
+        const size_t head = head_.load(std::memory_order_relaxed);
+        *item = slots_[head];
+        head_.store(Next(head));
+        Notify();
+        return true;
+    }
+    
+    void Close() {
+        closed_.store(true);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+
+private:
+    bool Empty() const { return head_.load() == tail_.load(); }
+    bool Full() const { return Next(tail_.load()) == head_.load(); }
+    size_t Next(size_t index) const { return index + 1 == slots_.size() ? 0 : index + 1; }
+    
+    template <typename Ready>
+    void Wait(Ready ready) {
+        for (int i = 0; i < kSpinIterations; ++i) {
+            if (ready()) {
+                return;
+            }
+            CpuRelax();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1);
+        cv_.wait(lock, ready);
+        waiters_.fetch_sub(1);
+    }
+    
+    void Notify() {
+        if (waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+    
+    std::vector<MicroBatch*> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<bool> closed_{false};
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+PipelineExecutor::PipelineExecutor(const ExecutionPlan& plan, const PipelineOptions& options)
+    : plan_(plan), options_(options) {
+    const size_t num_steps = plan_.GetSteps().size();
+    options_.num_stages = std::max<size_t>(std::min(options_.num_stages, num_steps), 1);
+    options_.queue_capacity = std::max<size_t>(options_.queue_capacity, 1);
+    stage_options_.intra_op_num_threads = std::max(options_.intra_op_threads_per_stage, 1);
+    stage_options_.intra_op_min_work_per_thread = options_.intra_op_min_work_per_thread;
+    
+    if (options_.step_costs.size() == num_steps) {
+        costs_ = options_.step_costs;
+    } else {
+        for (const ExecutionStep& step : plan_.GetSteps()) {
+            costs_.push_back(static_cast<double>(EstimateNodeCost(step.node)));
+        }
+    }
+    Repartition();
+}
+
+PipelineExecutor::~PipelineExecutor() {
+    for (auto& queue : queues_) {
+        queue->Close();
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+Status PipelineExecutor::Create(const ExecutionPlan& plan, const MemoryPlan* memory_plan,
+                                const PipelineOptions& options,
+                                std::unique_ptr<PipelineExecutor>* executor) {
+    for (const ExecutionStep& step : plan.GetSteps()) {
+        if (!step.provider->SupportsConcurrentExecution()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                               "Provider " + step.provider->GetName() +
+                               " does not support pipelined execution");
+        }
+    }
+    if (!options.step_costs.empty() && options.step_costs.size() != plan.GetSteps().size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "step_costs must have one entry per execution step");
+    }
+    
+    std::unique_ptr<PipelineExecutor> result(new PipelineExecutor(plan, options));
+    // 每个阶段各有一个正在处理的micro-batch，另外最多queue_capacity个在排队；
+    // 状态用完时调用线程先取回结果再提交，在途数量因此有界
+    const size_t num_stages = result->GetNumStages();
+    const size_t num_states = num_stages + result->options_.queue_capacity;
+    for (size_t i = 0; i < num_states; ++i) {
+        std::unique_ptr<ExecutionState> state;
+        Status status = ExecutionState::Create(plan, memory_plan, &state);
+        if (!status.IsOk()) {
+            return status;
+        }
+        result->states_.push_back(std::move(state));
+    }
+    for (size_t s = 0; s < num_stages; ++s) {
+        result->queues_.push_back(std::make_unique<Queue>(result->options_.queue_capacity));
+    }
+    // 最后一个队列交回调用线程，容量足以放下全部在途的micro-batch，末阶段不会因调用方取结果而停顿
+    result->queues_.push_back(std::make_unique<Queue>(num_states));
+    for (size_t s = 0; s < num_stages; ++s) {
+        result->threads_.emplace_back(&PipelineExecutor::StageLoop, result.get(), s);
+    }
+    *executor = std::move(result);
+    return Status::Ok();
+}
+
+void PipelineExecutor::Repartition() {
+    bounds_ = PartitionByCost(costs_, options_.num_stages);
+}
+
+double PipelineExecutor::GetStageCost(size_t stage) const {
+    if (stage + 1 >= bounds_.size()) {
+        return 0.0;
+    }
+    return std::accumulate(costs_.begin() + static_cast<std::ptrdiff_t>(bounds_[stage]),
+                           costs_.begin() + static_cast<std::ptrdiff_t>(bounds_[stage + 1]), 0.0);
+}
+
+void PipelineExecutor::StageLoop(size_t stage) {
+    Queue& input = *queues_[stage];
+    Queue& output = *queues_[stage + 1];
+    MicroBatch* item = nullptr;
+    while (input.Pop(&item)) {
+        // 前面的阶段已失败的micro-batch直接交给下游，由调用线程汇报错误
+        if (item->status.IsOk()) {
+            try {
+                item->status = ExecuteStateSteps(plan_, item->state, bounds_[stage], bounds_[stage + 1],
+                                                 stage_options_);
+            } catch (const std::exception& e) {
+                item->status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                             "Pipeline stage " + std::to_string(stage) + " threw: " + e.what());
+            }
+        }
+        if (!output.Push(item)) {
+            return;
+        }
+    }
+}
+
+Status PipelineExecutor::Run(const std::vector<std::vector<Tensor*>>& micro_batches,
+                             const CollectFunction& collect) {
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    const size_t n = micro_batches.size();
+    std::vector<MicroBatch> items(n);
+    std::vector<ExecutionState*> idle;
+    for (const auto& state : states_) {
+        idle.push_back(state.get());
+    }
+    
+    Status first_error = Status::Ok();
+    std::vector<Tensor*> outputs;
+    size_t submitted = 0;
+    size_t finished = 0;
+    while (finished < n) {
+        while (submitted < n && !idle.empty()) {
+            MicroBatch& item = items[submitted];
+            item.index = submitted;
+            item.state = idle.back();
+            idle.pop_back();
+            item.status = BeginStateRun(plan_, item.state, micro_batches[submitted]);
+            if (!queues_.front()->Push(&item)) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Pipeline is stopped");
+            }
+            ++submitted;
+        }
+        
+        MicroBatch* item = nullptr;
+        if (!queues_.back()->Pop(&item)) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Pipeline is stopped");
+        }
+        EndStateRun(plan_, item->state, item->status.IsOk(), outputs);
+        if (item->status.IsOk() && collect) {
+            item->status = collect(item->index, item->state);
+        }
+        if (!item->status.IsOk() && first_error.IsOk()) {
+            first_error = item->status;
+        }
+        idle.push_back(item->state);
+        ++finished;
+    }
+    return first_error;
+}
+
+Status PipelineExecutor::Calibrate(const std::vector<Tensor*>& inputs) {
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    const size_t num_steps = plan_.GetSteps().size();
+    ExecutionState* state = states_.front().get();
+    std::vector<Tensor*> outputs;
+    
+    // 先完整执行一次，让中间张量完成分配，计时只包含算子本身
+    Status status = BeginStateRun(plan_, state, inputs);
+    if (status.IsOk()) {
+        status = ExecuteStateSteps(plan_, state, 0, num_steps, stage_options_);
+    }
+    EndStateRun(plan_, state, false, outputs);
+    if (status.IsOk()) {
+        status = BeginStateRun(plan_, state, inputs);
+    }
+    std::vector<double> costs(num_steps, 0.0);
+    for (size_t s = 0; status.IsOk() && s < num_steps; ++s) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        status = ExecuteStateSteps(plan_, state, s, s + 1, stage_options_);
+        const auto end = std::chrono::high_resolution_clock::now();
+        costs[s] = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+    EndStateRun(plan_, state, false, outputs);
+    if (!status.IsOk()) {
+        return status;
+    }
+    // 各阶段线程在下一次Run取到micro-batch时（经队列同步）看到新的划分
+    costs_ = std::move(costs);
+    Repartition();
+    return Status::Ok();
+}
+
+} // namespace inferunity
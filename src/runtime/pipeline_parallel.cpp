@@ -0,0 +1,436 @@
+// 跨设备的流水线并行
+// 阶段的切分复用PipelineScheduler；阶段子图的建立与子图委托（DelegateSubgraphs）相同：
+// 来自阶段外的值作为输入，常量随节点带走，被后面的阶段用到或作为图输出的值作为输出
+
+#include "inferunity/pipeline_parallel.h"
+#include "inferunity/collectives.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/partitioner.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_set>
+
+namespace inferunity {
+
+namespace {
+
+std::string ValueName(const Value* value) {
+    return value->GetName().empty() ? "value_" + std::to_string(value->GetId()) : value->GetName();
+}
+
+size_t IndexOf(const std::vector<std::string>& names, const std::string& name) {
+    return static_cast<size_t>(std::find(names.begin(), names.end(), name) - names.begin());
+}
+
+} // namespace
+
+Status SplitPipelineStages(const Graph& graph, size_t num_stages,
+                           const std::unordered_map<std::string, double>& node_costs,
+                           PipelineStagePartition* partition) {
+    if (num_stages == 0 || graph.GetNodes().size() < num_stages) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Pipeline parallelism needs at least one node per stage (" +
+                             std::to_string(graph.GetNodes().size()) + " nodes, " +
+                             std::to_string(num_stages) + " stages)");
+    }
+    for (const Value* output : graph.GetOutputs()) {
+        if (!output->GetProducer()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "Pipeline parallelism needs every graph output to be produced by a node: " +
+                                 ValueName(output));
+        }
+    }
+
+    PipelineScheduler scheduler(static_cast<int>(num_stages));
+    scheduler.SetNodeCosts(node_costs);
+    Status status = scheduler.Schedule(&graph, {}, nullptr);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const std::vector<std::vector<Node*>>& stage_nodes = scheduler.GetStages();
+    std::unordered_map<const Node*, size_t> stage_of;
+    for (size_t s = 0; s < stage_nodes.size(); ++s) {
+        for (Node* node : stage_nodes[s]) {
+            stage_of[node] = s;
+        }
+    }
+
+    // 边界：阶段p算出、最后被阶段l用到的值由p, ..., l - 1依次发给下一阶段，中间的阶段只是转发
+    const std::unordered_set<const Value*> graph_inputs(graph.GetInputs().begin(), graph.GetInputs().end());
+    const std::unordered_set<const Value*> graph_outputs(graph.GetOutputs().begin(), graph.GetOutputs().end());
+    std::vector<std::vector<Value*>> sent(num_stages);
+    for (const auto& value : graph.GetValues()) {
+        const Node* producer = value->GetProducer();
+        if (!producer || !stage_of.count(producer)) {
+            continue;
+        }
+        const size_t first = stage_of[producer];
+        size_t last = first;
+        for (const Node* consumer : value->GetConsumers()) {
+            auto it = stage_of.find(consumer);
+            if (it != stage_of.end()) {
+                last = std::max(last, it->second);
+            }
+        }
+        for (size_t s = first; s < last; ++s) {
+            sent[s].push_back(value.get());
+        }
+    }
+
+    PipelineStagePartition result;
+    for (const Value* input : graph.GetInputs()) {
+        result.graph_inputs.push_back(ValueName(input));
+    }
+    for (const Value* output : graph.GetOutputs()) {
+        result.graph_outputs.push_back(ValueName(output));
+    }
+    result.stages.resize(num_stages);
+    for (size_t s = 0; s < num_stages; ++s) {
+        PipelineStageGraph& stage = result.stages[s];
+        const std::vector<Node*>& members = stage_nodes[s];
+        const std::unordered_set<const Node*> inside(members.begin(), members.end());
+
+        std::vector<Value*> inputs;
+        std::vector<Value*> constants;
+        std::unordered_set<const Value*> seen;
+        for (Node* node : members) {
+            auto it = node_costs.find(node->GetName());
+            stage.cost += it != node_costs.end() ? it->second : static_cast<double>(EstimateNodeCost(node));
+            for (Value* input : node->GetInputs()) {
+                if (inside.count(input->GetProducer()) || !seen.insert(input).second) {
+                    continue;
+                }
+                if (!input->GetProducer() && !graph_inputs.count(input)) {
+                    constants.push_back(input);
+                } else {
+                    inputs.push_back(input);
+                }
+            }
+        }
+        const std::unordered_set<const Value*> sent_here(sent[s].begin(), sent[s].end());
+        std::vector<Value*> outputs;
+        for (Node* node : members) {
+            for (Value* output : node->GetOutputs()) {
+                if (sent_here.count(output) || graph_outputs.count(output)) {
+                    outputs.push_back(output);
+                }
+            }
+        }
+
+        auto subgraph = std::make_unique<Graph>();
+        std::unordered_map<const Value*, Value*> mapped;
+        auto map_value = [&](Value* value) {
+            auto it = mapped.find(value);
+            if (it != mapped.end()) {
+                return it->second;
+            }
+            Value* copy = subgraph->AddValue();
+            copy->SetName(ValueName(value));
+            mapped[value] = copy;
+            return copy;
+        };
+        for (Value* input : inputs) {
+            Value* copy = map_value(input);
+            copy->SetTensor(MetadataTensor(input));
+            subgraph->AddInput(copy);
+            stage.inputs.push_back(copy->GetName());
+        }
+        for (Value* constant : constants) {
+            map_value(constant)->SetTensor(constant->GetTensor());
+        }
+        for (Node* node : members) {
+            Node* copy = subgraph->AddNode(node->GetOpType(), node->GetName());
+            for (const auto& attr : node->GetAttributes()) {
+                copy->SetAttribute(attr.first, attr.second);
+            }
+            for (Value* input : node->GetInputs()) {
+                copy->AddInput(map_value(input));
+            }
+            for (Value* output : node->GetOutputs()) {
+                copy->AddOutput(map_value(output));
+            }
+        }
+        for (Value* output : outputs) {
+            Value* copy = map_value(output);
+            copy->SetTensor(MetadataTensor(output));
+            subgraph->AddOutput(copy);
+            stage.outputs.push_back(copy->GetName());
+        }
+        stage.graph = std::move(subgraph);
+        for (const Value* value : sent[s]) {
+            stage.sent.push_back(ValueName(value));
+        }
+        if (s > 0) {
+            stage.received = result.stages[s - 1].sent;
+        }
+    }
+    *partition = std::move(result);
+    return Status::Ok();
+}
+
+// 每个阶段的数据来源，Create时按名称解析一次
+struct PipelineParallelExecutor::Route {
+    std::vector<std::pair<bool, size_t>> inputs;  // (是否来自原图输入, 原图输入或received中的下标)
+    std::vector<std::pair<bool, size_t>> sent;    // (是否是本阶段的输出, 子图输出或received中的下标)
+    std::vector<std::vector<size_t>> results;     // 每个子图输出对应的原图输出下标
+};
+
+// 阶段之间的消息：发给发送线程时带着张量，发给下一阶段时只带形状与类型（张量经通信组传递）
+struct PipelineParallelExecutor::Message {
+    size_t index = 0;
+    Status status = Status::Ok();
+    std::vector<std::shared_ptr<Tensor>> tensors;
+    std::vector<Shape> shapes;
+    std::vector<DataType> dtypes;
+};
+
+// 有界阻塞队列；每次Run中每个阶段对每个micro-batch恰好收发一条消息，不需要关闭
+class PipelineParallelExecutor::Channel {
+public:
+    explicit Channel(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+    void Push(std::unique_ptr<Message> message) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+        items_.push_back(std::move(message));
+        not_empty_.notify_one();
+    }
+
+    std::unique_ptr<Message> Pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty(); });
+        std::unique_ptr<Message> message = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return message;
+    }
+
+private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<std::unique_ptr<Message>> items_;
+};
+
+struct PipelineParallelExecutor::RunState {
+    const std::vector<std::vector<Tensor*>>* micro_batches = nullptr;
+    std::vector<std::vector<std::shared_ptr<Tensor>>>* outputs = nullptr;
+    std::vector<Status> statuses;                 // 由最后一个阶段写入
+    std::vector<std::unique_ptr<Channel>> sends;  // 阶段s的计算线程 -> 阶段s的发送线程
+    std::vector<std::unique_ptr<Channel>> links;  // 阶段s的发送线程 -> 阶段s + 1的计算线程
+    std::atomic<bool> aborted{false};
+};
+
+Status PipelineParallelExecutor::Create(PipelineStagePartition partition,
+                                        std::vector<std::unique_ptr<InferenceSession>> sessions,
+                                        std::shared_ptr<CollectiveGroup> group, DeviceType device_type,
+                                        size_t queue_capacity, std::unique_ptr<PipelineParallelExecutor>* executor) {
+    const size_t num_stages = partition.stages.size();
+    if (num_stages == 0 || sessions.size() != num_stages) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Expected one session per pipeline stage");
+    }
+    if (num_stages > 1 && (!group || group->GetWorldSize() != static_cast<int>(num_stages))) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                             "Pipeline parallelism needs a collective group with one rank per stage");
+    }
+    std::unique_ptr<PipelineParallelExecutor> result(new PipelineParallelExecutor());
+    result->routes_.resize(num_stages);
+    for (size_t s = 0; s < num_stages; ++s) {
+        const PipelineStageGraph& stage = partition.stages[s];
+        if (!sessions[s] || sessions[s]->GetInputNames() != stage.inputs ||
+            sessions[s]->GetOutputNames() != stage.outputs) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "Session of pipeline stage " + std::to_string(s) + " does not match its subgraph");
+        }
+        Route& route = result->routes_[s];
+        for (const std::string& name : stage.inputs) {
+            const size_t received = IndexOf(stage.received, name);
+            const size_t graph_input = IndexOf(partition.graph_inputs, name);
+            if (received < stage.received.size()) {
+                route.inputs.emplace_back(false, received);
+            } else if (graph_input < partition.graph_inputs.size()) {
+                route.inputs.emplace_back(true, graph_input);
+            } else {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                     "Input " + name + " of pipeline stage " + std::to_string(s) + " has no source");
+            }
+        }
+        for (const std::string& name : stage.sent) {
+            const size_t output = IndexOf(stage.outputs, name);
+            const size_t received = IndexOf(stage.received, name);
+            if (output < stage.outputs.size()) {
+                route.sent.emplace_back(true, output);
+            } else if (received < stage.received.size()) {
+                route.sent.emplace_back(false, received);
+            } else {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                     "Boundary tensor " + name + " of pipeline stage " + std::to_string(s) +
+                                     " has no source");
+            }
+        }
+        route.results.resize(stage.outputs.size());
+        for (size_t k = 0; k < partition.graph_outputs.size(); ++k) {
+            const size_t output = IndexOf(stage.outputs, partition.graph_outputs[k]);
+            if (output < stage.outputs.size()) {
+                route.results[output].push_back(k);
+            }
+        }
+    }
+    result->stages_ = std::move(partition.stages);
+    result->graph_inputs_ = std::move(partition.graph_inputs);
+    result->graph_outputs_ = std::move(partition.graph_outputs);
+    result->sessions_ = std::move(sessions);
+    result->group_ = std::move(group);
+    result->device_type_ = device_type;
+    result->queue_capacity_ = std::max<size_t>(queue_capacity, 1);
+    *executor = std::move(result);
+    return Status::Ok();
+}
+
+PipelineParallelExecutor::~PipelineParallelExecutor() = default;
+
+Status PipelineParallelExecutor::Run(const std::vector<std::vector<Tensor*>>& micro_batches,
+                                     std::vector<std::vector<std::shared_ptr<Tensor>>>* outputs) {
+    for (const auto& inputs : micro_batches) {
+        if (inputs.size() != graph_inputs_.size()) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                 "Expected " + std::to_string(graph_inputs_.size()) + " inputs, got " +
+                                 std::to_string(inputs.size()));
+        }
+    }
+    std::lock_guard<std::mutex> lock(run_mutex_);
+    outputs->assign(micro_batches.size(), std::vector<std::shared_ptr<Tensor>>(graph_outputs_.size()));
+    if (micro_batches.empty()) {
+        return Status::Ok();
+    }
+
+    RunState run;
+    run.micro_batches = &micro_batches;
+    run.outputs = outputs;
+    run.statuses.assign(micro_batches.size(), Status::Ok());
+    for (size_t s = 0; s + 1 < stages_.size(); ++s) {
+        run.sends.push_back(std::make_unique<Channel>(queue_capacity_));
+        run.links.push_back(std::make_unique<Channel>(queue_capacity_));
+    }
+    std::vector<std::thread> threads;
+    for (size_t s = 0; s < stages_.size(); ++s) {
+        threads.emplace_back(&PipelineParallelExecutor::StageLoop, this, &run, s);
+        if (s + 1 < stages_.size()) {
+            threads.emplace_back(&PipelineParallelExecutor::SendLoop, this, &run, s);
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (run.aborted.load()) {
+        group_->Reset();
+    }
+    for (size_t i = 0; i < run.statuses.size(); ++i) {
+        if (!run.statuses[i].IsOk()) {
+            (*outputs)[i].clear();
+        }
+    }
+    for (const Status& status : run.statuses) {
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    return Status::Ok();
+}
+
+void PipelineParallelExecutor::StageLoop(RunState* run, size_t stage) {
+    const Route& route = routes_[stage];
+    const bool last = stage + 1 == stages_.size();
+    const int rank = static_cast<int>(stage);
+    for (size_t i = 0; i < run->micro_batches->size(); ++i) {
+        // 先收上一阶段的边界张量：元数据经队列先到，数据经通信组按序到达
+        Status status = Status::Ok();
+        std::vector<std::shared_ptr<Tensor>> received;
+        if (stage > 0) {
+            std::unique_ptr<Message> message = run->links[stage - 1]->Pop();
+            status = message->status;
+            const size_t count = stages_[stage].received.size();
+            for (size_t k = 0; k < message->shapes.size() && status.IsOk(); ++k) {
+                auto tensor = CreateTensor(message->shapes[k], message->dtypes[k], device_type_);
+                status = tensor && tensor->GetData()
+                    ? group_->Recv(rank, rank - 1, static_cast<int64_t>(i * count + k), tensor.get())
+                    : Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Failed to allocate a pipeline boundary tensor");
+                if (!status.IsOk()) {
+                    // 信箱里剩下的消息与之后的tag对不上，中止后这一轮之后的micro-batch都失败
+                    run->aborted.store(true);
+                    group_->Abort();
+                }
+                received.push_back(std::move(tensor));
+            }
+        }
+
+        std::vector<std::shared_ptr<Tensor>> stage_outputs;
+        if (status.IsOk()) {
+            const std::vector<Tensor*>& micro_batch = (*run->micro_batches)[i];
+            std::vector<Tensor*> inputs;
+            for (const auto& source : route.inputs) {
+                inputs.push_back(source.first ? micro_batch[source.second] : received[source.second].get());
+            }
+            status = sessions_[stage]->Run(inputs, stage_outputs);
+            if (status.IsOk() && stage_outputs.size() != route.results.size()) {
+                status = Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                       "Pipeline stage " + std::to_string(stage) + " did not produce all outputs");
+            }
+        }
+        if (status.IsOk()) {
+            for (size_t k = 0; k < stage_outputs.size(); ++k) {
+                for (size_t result : route.results[k]) {
+                    (*run->outputs)[i][result] = stage_outputs[k];
+                }
+            }
+        }
+
+        if (last) {
+            run->statuses[i] = status;
+            continue;
+        }
+        auto message = std::make_unique<Message>();
+        message->index = i;
+        message->status = status;
+        if (status.IsOk()) {
+            for (const auto& source : route.sent) {
+                message->tensors.push_back(source.first ? stage_outputs[source.second] : received[source.second]);
+            }
+        }
+        run->sends[stage]->Push(std::move(message));
+    }
+}
+
+void PipelineParallelExecutor::SendLoop(RunState* run, size_t stage) {
+    const int rank = static_cast<int>(stage);
+    const size_t count = stages_[stage].sent.size();
+    for (size_t i = 0; i < run->micro_batches->size(); ++i) {
+        std::unique_ptr<Message> message = run->sends[stage]->Pop();
+        auto metadata = std::make_unique<Message>();
+        metadata->index = message->index;
+        metadata->status = message->status;
+        for (const auto& tensor : message->tensors) {
+            metadata->shapes.push_back(tensor->GetShape());
+            metadata->dtypes.push_back(tensor->GetDataType());
+        }
+        run->links[stage]->Push(std::move(metadata));
+        for (size_t k = 0; k < message->tensors.size(); ++k) {
+            Status status = group_->Send(rank, rank + 1, static_cast<int64_t>(message->index * count + k),
+                                         *message->tensors[k]);
+            if (!status.IsOk()) {
+                // 中止后下一阶段的Recv返回错误，这个micro-batch在那里失败
+                run->aborted.store(true);
+                group_->Abort();
+                break;
+            }
+        }
+    }
+}
+
+} // namespace inferunity
@@ -2,10 +2,14 @@
 #include "inferunity/backend.h"
 #include "inferunity/tensor.h"
 #include "inferunity/operator.h"
+#include "inferunity/tracing.h"
+#include "inferunity/metrics.h"
+#include "inferunity/partitioner.h"
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <future>
+#include <map>
 #include <unordered_map>
 #include <queue>
 #include <mutex>
@@ -28,36 +32,6 @@ std::vector<Node*> TopologicalScheduler::GetExecutionOrder(const Graph* graph) c
     return graph->TopologicalSort();
 }
 
-// PipelineScheduler实现
-Status PipelineScheduler::Schedule(const Graph* graph,
-                                  const std::vector<Backend*>& backends,
-                                  ExecutionContext* ctx) {
-    PartitionGraph(graph);
-    (void)backends; (void)ctx;
-    return Status::Ok();
-}
-
-std::vector<Node*> PipelineScheduler::GetExecutionOrder(const Graph* graph) const {
-    std::vector<Node*> order;
-    for (const auto& stage : stages_) {
-        order.insert(order.end(), stage.begin(), stage.end());
-    }
-    return order;
-}
-
-void PipelineScheduler::PartitionGraph(const Graph* graph) {
-    stages_.clear();
-    stages_.resize(num_stages_);
-    
-    std::vector<Node*> sorted = graph->TopologicalSort();
-    size_t nodes_per_stage = (sorted.size() + num_stages_ - 1) / num_stages_;
-    
-    for (size_t i = 0; i < sorted.size(); ++i) {
-        int stage = std::min(static_cast<int>(i / nodes_per_stage), num_stages_ - 1);
-        stages_[stage].push_back(sorted[i]);
-    }
-}
-
 // ExecutionEngine实现
 ExecutionEngine::ExecutionEngine() {
     scheduler_ = std::make_unique<TopologicalScheduler>();
@@ -132,177 +106,834 @@ Status ExecutionEngine::Execute(const Graph* graph,
                                const std::vector<Tensor*>& inputs,
                                std::vector<Tensor*>& outputs,
                                const ExecutionOptions& options) {
-    return ExecuteInternal(graph, inputs, outputs, options);
+    std::unique_ptr<ExecutionPlan> plan;
+    Status status = BuildTransientPlan(graph, &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return RunPlan(*plan, inputs, outputs, options, nullptr);
 }
 
 std::future<Status> ExecutionEngine::ExecuteAsync(const Graph* graph,
                                                   const std::vector<Tensor*>& inputs,
                                                   std::vector<Tensor*>& outputs,
                                                   const ExecutionOptions& options) {
-    return std::async(std::launch::async, [this, graph, &inputs, &outputs, options]() {
-        return ExecuteInternal(graph, inputs, outputs, options);
+    // 在线程池上执行，输入指针按值捕获；outputs须保持有效直到future就绪
+    auto promise = std::make_shared<std::promise<Status>>();
+    std::future<Status> future = promise->get_future();
+    std::vector<Tensor*>* output_ptr = &outputs;
+    ThreadPool::EnqueueTask([this, graph, inputs, output_ptr, options, promise]() {
+        promise->set_value(Execute(graph, inputs, *output_ptr, options));
     });
+    return future;
 }
 
 Status ExecutionEngine::Profile(const Graph* graph,
                               const std::vector<Tensor*>& inputs,
-                              ProfilingResult& result) {
-    if (!graph) {
-        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+                              ProfilingResult& result,
+                              const ExecutionOptions& options) {
+    std::unique_ptr<ExecutionPlan> plan;
+    Status status = BuildTransientPlan(graph, &plan);
+    if (!status.IsOk()) {
+        return status;
     }
-    
-    ExecutionOptions options;
-    options.enable_profiling = true;
-    
+    return ProfilePlan(*plan, inputs, result, options);
+}
+
+Status ExecutionEngine::ExecutePlan(const ExecutionPlan& plan,
+                                   const std::vector<Tensor*>& inputs,
+                                   std::vector<Tensor*>& outputs,
+                                   const ExecutionOptions& options) {
+    return RunPlan(plan, inputs, outputs, options, nullptr);
+}
+
+std::future<Status> ExecutionEngine::ExecutePlanAsync(const ExecutionPlan& plan,
+                                                      const std::vector<Tensor*>& inputs,
+                                                      std::vector<Tensor*>& outputs,
+                                                      const ExecutionOptions& options) {
+    auto promise = std::make_shared<std::promise<Status>>();
+    std::future<Status> future = promise->get_future();
+    std::vector<Tensor*>* output_ptr = &outputs;
+    ThreadPool::EnqueueTask([this, &plan, inputs, output_ptr, options, promise]() {
+        promise->set_value(ExecutePlan(plan, inputs, *output_ptr, options));
+    });
+    return future;
+}
+
+Status ExecutionEngine::ProfilePlan(const ExecutionPlan& plan,
+                                   const std::vector<Tensor*>& inputs,
+                                   ProfilingResult& result,
+                                   const ExecutionOptions& options) {
     // 清空结果
     result.node_profiles.clear();
     result.total_time_ms = 0.0;
     result.peak_memory_bytes = 0;
+    result.memory_timeline = MemoryTimeline();
+    result.hardware_counters = false;
+    result.hardware_counter_error.clear();
     
-    // 记录开始时间
-    auto start_time = std::chrono::high_resolution_clock::now();
+    // 性能分析按顺序执行，不启用多流
+    ExecutionOptions profile_options = options;
+    profile_options.mode = ExecutionMode::SYNCHRONOUS;
+    profile_options.max_parallel_streams = 1;
+    std::vector<Tensor*> outputs;
+    return RunPlan(plan, inputs, outputs, profile_options, &result);
+}
+
+Status ExecutionEngine::BuildTransientPlan(const Graph* graph,
+                                          std::unique_ptr<ExecutionPlan>* plan) const {
+    if (!graph) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Graph is null");
+    }
+    ExecutionPlanOptions plan_options;
+    plan_options.node_order = scheduler_->GetExecutionOrder(graph);
+    plan_options.release_intermediates = false;
+    return ExecutionPlan::Build(graph, backend_ptrs_, plan_options, plan);
+}
+
+Status BindOutputTensors(Node* node, ExecutionProvider* provider,
+                         const std::vector<Tensor*>& inputs,
+                         std::vector<std::shared_ptr<Tensor>>& outputs) {
+    if (!node || !provider) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node or provider is null");
+    }
     
-    // 获取执行顺序
-    std::vector<Node*> execution_order = scheduler_->GetExecutionOrder(graph);
+    // 先推断输出形状
+    std::vector<Shape> output_shapes;
+    bool inferred = false;
+    auto op = provider->CreateOperator(node->GetOpType());
+    if (op) {
+        ApplyNodeAttributes(*node, op.get());
+        Status shape_status = op->InferOutputShape(inputs, output_shapes);
+        inferred = shape_status.IsOk() && !output_shapes.empty();
+    }
     
-    // 执行每个节点并记录性能
-    size_t peak_memory = 0;
-    for (Node* node : execution_order) {
-        auto node_start = std::chrono::high_resolution_clock::now();
-        
-        // 准备输入
-        std::vector<Tensor*> node_inputs;
-        for (Value* input : node->GetInputs()) {
-            if (input->GetTensor()) {
-                node_inputs.push_back(input->GetTensor().get());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const DeviceType device = provider->GetOutputDeviceType(node, i);
+        if (!inferred) {
+            // 无法创建算子或形状推断失败，使用默认形状
+            outputs[i] = CreateTensor(Shape({1}), DataType::FLOAT32, device);
+            continue;
+        }
+        const Shape& output_shape = i < output_shapes.size() ? output_shapes[i] : output_shapes[0];
+        const DataType output_dtype = op->InferOutputDataType(inputs, i);
+        // 已绑定的张量（如内存规划得到的arena视图）形状一致时直接复用；形状推断留下的只有形状的张量不能复用
+        const auto& existing = outputs[i];
+        if (existing && existing->GetData() && existing->GetShape().dims == output_shape.dims &&
+            existing->GetDataType() == output_dtype &&
+            existing->GetDeviceType() == device) {
+            continue;
+        }
+        outputs[i] = CreateTensor(output_shape, output_dtype, device);
+    }
+    return Status::Ok();
+}
+
+Status BindNodeOutputs(Node* node, ExecutionProvider* provider) {
+    if (!node || !provider) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Node or provider is null");
+    }
+    
+    std::vector<Tensor*> node_inputs;
+    for (Value* input : node->GetInputs()) {
+        if (input->GetTensor()) {
+            node_inputs.push_back(input->GetTensor().get());
+        }
+    }
+    std::vector<std::shared_ptr<Tensor>> tensors;
+    for (Value* output : node->GetOutputs()) {
+        tensors.push_back(output->GetTensor());
+    }
+    Status status = BindOutputTensors(node, provider, node_inputs, tensors);
+    if (!status.IsOk()) {
+        return status;
+    }
+    const auto& outputs = node->GetOutputs();
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (outputs[i]->GetTensor() != tensors[i]) {
+            outputs[i]->SetTensor(tensors[i]);
+        }
+    }
+    return Status::Ok();
+}
+
+namespace {
+
+std::string FormatDims(const std::vector<int64_t>& dims) {
+    std::string text = "[";
+    for (size_t i = 0; i < dims.size(); ++i) {
+        text += (i ? ", " : "") + std::to_string(dims[i]);
+    }
+    return text + "]";
+}
+
+// 一次多流运行使用的流与事件：每个支持多流的提供者从设备的流池取出计划所需的流
+// （0号流也取自流池，并发的运行互不共享流），为被其他流等待的步骤创建事件；
+// 析构时等待所有流完成并归还。流数受max_parallel_streams限制，超出的逻辑流按取模映射
+class StreamRun {
+public:
+    StreamRun(const ExecutionPlan& plan, int max_streams) : plan_(plan) {
+        num_streams_ = std::min(plan.GetNumStreams(), std::max(max_streams, 1));
+        if (num_streams_ <= 1) {
+            return;
+        }
+        for (const ExecutionStep& step : plan.GetSteps()) {
+            if (!step.provider->SupportsMultiStream() || devices_.count(step.provider)) {
+                continue;
+            }
+            DeviceStreams& entry = devices_[step.provider];
+            entry.device = step.provider->GetDevice();
+            for (int i = 0; entry.device && i < num_streams_; ++i) {
+                entry.streams.push_back(entry.device->AcquireStream());
             }
         }
-        
-        // 执行节点
-        ExecutionContext ctx;
-        if (!backend_ptrs_.empty()) {
-            ExecutionProvider* provider = ExecutionProviderSelector::SelectProvider(node, backend_ptrs_);
-            if (provider) {
-                ctx.SetDeviceType(provider->GetDeviceType());
-                Status status = provider->ExecuteNode(node, &ctx);
-                if (!status.IsOk()) {
-                    return status;
+        events_.resize(plan.GetSteps().size(), nullptr);
+    }
+    
+    ~StreamRun() {
+        Synchronize();
+        const std::vector<ExecutionStep>& steps = plan_.GetSteps();
+        for (size_t i = 0; i < events_.size(); ++i) {
+            if (events_[i]) {
+                devices_[steps[i].provider].device->DestroyEvent(events_[i]);
+            }
+        }
+        for (auto& entry : devices_) {
+            for (void* stream : entry.second.streams) {
+                entry.second.device->ReleaseStream(stream);
+            }
+        }
+    }
+    
+    bool IsActive() const { return !devices_.empty(); }
+    
+    // 执行前：等待其他流上的依赖，并把步骤的流交给执行上下文
+    Status BeginStep(size_t index, ExecutionContext* ctx) {
+        const ExecutionStep& step = plan_.GetSteps()[index];
+        void* stream = GetStream(step);
+        for (int wait : step.wait_steps) {
+            const ExecutionStep& producer = plan_.GetSteps()[wait];
+            DeviceStreams& entry = devices_[producer.provider];
+            if (!entry.device) {
+                continue;
+            }
+            // 主机上同步执行的步骤读取前等待生产者的流完成
+            Status status = stream && events_[wait]
+                ? entry.device->StreamWaitEvent(stream, events_[wait])
+                : entry.device->SynchronizeStream(GetStream(producer));
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        ctx->SetStream(stream);
+        return Status::Ok();
+    }
+    
+    // 执行后：为被等待的步骤记录事件
+    Status EndStep(size_t index) {
+        const ExecutionStep& step = plan_.GetSteps()[index];
+        void* stream = GetStream(step);
+        if (!step.record_event || !stream) {
+            return Status::Ok();
+        }
+        const std::shared_ptr<Device>& device = devices_[step.provider].device;
+        if (!events_[index]) {
+            events_[index] = device->CreateEvent();
+        }
+        return device->RecordEvent(events_[index], stream);
+    }
+    
+    // 其他流可能仍在读取已释放的中间张量，运行结束（各流同步）之后才交还分配器
+    void Retain(std::shared_ptr<Tensor> tensor) {
+        if (tensor) {
+            retained_.push_back(std::move(tensor));
+        }
+    }
+    
+    Status Synchronize() {
+        Status result = Status::Ok();
+        for (auto& entry : devices_) {
+            for (void* stream : entry.second.streams) {
+                Status status = entry.second.device->SynchronizeStream(stream);
+                if (!status.IsOk() && result.IsOk()) {
+                    result = status;
                 }
             }
         }
-        
-        auto node_end = std::chrono::high_resolution_clock::now();
-        double node_time_ms = std::chrono::duration<double, std::milli>(node_end - node_start).count();
-        
-        // 估算内存使用（简化：使用张量大小）
-        size_t node_memory = 0;
-        for (Value* output : node->GetOutputs()) {
-            if (output->GetTensor()) {
-                node_memory += output->GetTensor()->GetSizeInBytes();
+        retained_.clear();
+        return result;
+    }
+
+private:
+    struct DeviceStreams {
+        std::shared_ptr<Device> device;
+        std::vector<void*> streams;
+    };
+    
+    void* GetStream(const ExecutionStep& step) {
+        auto it = devices_.find(step.provider);
+        if (it == devices_.end() || it->second.streams.empty()) {
+            return nullptr;
+        }
+        return it->second.streams[step.stream % it->second.streams.size()];
+    }
+    
+    const ExecutionPlan& plan_;
+    int num_streams_ = 1;
+    std::unordered_map<const ExecutionProvider*, DeviceStreams> devices_;
+    std::vector<void*> events_;
+    std::vector<std::shared_ptr<Tensor>> retained_;
+};
+
+// 视图步骤的输出直接是第0个输入存储上的视图；返回nullptr时照常绑定输出并执行内核
+std::shared_ptr<Tensor> CreateStepView(const ExecutionStep& step,
+                                       const std::vector<std::shared_ptr<Tensor>>& inputs) {
+    return step.view_op ? step.view_op->CreateOutputView(inputs) : nullptr;
+}
+
+// 内核只接受连续输入：非连续的视图在第一次被内核读取前拷成连续张量，替换后供后续消费者复用
+Status MakeInputContiguous(std::shared_ptr<Tensor>& tensor) {
+    if (!tensor || tensor->IsContiguous()) {
+        return Status::Ok();
+    }
+    std::shared_ptr<Tensor> dense = MakeContiguous(tensor);
+    if (!dense) {
+        return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                           "Cannot make a strided tensor contiguous on this device");
+    }
+    tensor = std::move(dense);
+    return Status::Ok();
+}
+
+// 性能分析时记录存活张量：中间张量在最后一个使用它的步骤之后记为释放（与arena是否复用无关），
+// 图输入输出一直存活。按缓冲计数，数据落在已存活缓冲内的张量（视图、原地输出）只增加引用，
+// 最后一个引用释放时才记为释放
+class MemoryTimelineRecorder {
+public:
+    MemoryTimelineRecorder(MemoryTimeline* timeline, const ExecutionPlan& plan,
+                           std::chrono::high_resolution_clock::time_point start)
+        : timeline_(timeline), start_(start) {
+        if (!timeline_) {
+            return;
+        }
+        const std::vector<ExecutionStep>& steps = plan.GetSteps();
+        std::vector<int> last_use(plan.GetValues().size(), -1);
+        for (size_t index = 0; index < steps.size(); ++index) {
+            for (int slot : steps[index].input_slots) {
+                last_use[slot] = static_cast<int>(index);
+            }
+            for (int slot : steps[index].output_slots) {
+                last_use[slot] = std::max(last_use[slot], static_cast<int>(index));
+            }
+        }
+        for (int slot : plan.GetInputSlots()) {
+            last_use[slot] = -1;
+        }
+        for (int slot : plan.GetOutputSlots()) {
+            last_use[slot] = -1;
+        }
+        dead_after_.resize(steps.size());
+        for (size_t slot = 0; slot < last_use.size(); ++slot) {
+            if (last_use[slot] >= 0) {
+                dead_after_[last_use[slot]].push_back(plan.GetValues()[slot]);
             }
         }
-        peak_memory = std::max(peak_memory, node_memory);
-        
-        // 记录节点性能
-        ProfilingResult::NodeProfile profile;
-        profile.node_name = node->GetName();
-        profile.op_type = node->GetOpType();
-        profile.execution_time_ms = node_time_ms;
-        profile.memory_used_bytes = node_memory;
-        result.node_profiles.push_back(profile);
     }
     
-    // 记录总时间
-    auto end_time = std::chrono::high_resolution_clock::now();
-    result.total_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-    result.peak_memory_bytes = peak_memory;
+    void Allocate(size_t step, const Node* node, const Value* value) {
+        std::shared_ptr<Tensor> tensor = value->GetTensor();
+        if (!timeline_ || !tensor || !tensor->GetData() || value_buffers_.count(value)) {
+            return;
+        }
+        const char* data = static_cast<const char*>(tensor->GetData());
+        auto it = buffers_.upper_bound(data);
+        if (it != buffers_.begin()) {
+            --it;
+            if (data < it->first + it->second.bytes) {
+                ++it->second.refs;
+                value_buffers_[value] = it->first;
+                return;
+            }
+        }
+        const size_t bytes = tensor->GetSizeInBytes();
+        buffers_[data] = Buffer{bytes, 1, value, node};
+        value_buffers_[value] = data;
+        live_ += bytes;
+        Record(step, node, value, static_cast<int64_t>(bytes));
+    }
+    
+    void Release(size_t step, const Node* node, const Value* value) {
+        auto it = value_buffers_.find(value);
+        if (!timeline_ || it == value_buffers_.end()) {
+            return;
+        }
+        auto buffer = buffers_.find(it->second);
+        value_buffers_.erase(it);
+        if (--buffer->second.refs > 0) {
+            return;
+        }
+        const size_t bytes = buffer->second.bytes;
+        const Value* owner = buffer->second.value;
+        buffers_.erase(buffer);
+        live_ -= bytes;
+        Record(step, node, owner, -static_cast<int64_t>(bytes));
+    }
+    
+    // 节点的输出都已绑定、释放之前调用：存活字节数创新高时记下此刻存活的张量
+    void EndStep(size_t step, const Node* node) {
+        if (!timeline_ || live_ <= timeline_->peak_bytes) {
+            return;
+        }
+        timeline_->peak_bytes = live_;
+        timeline_->peak_step = step;
+        timeline_->peak_node = node ? node->GetName() : std::string();
+        timeline_->live_at_peak.clear();
+        for (const auto& entry : buffers_) {
+            MemoryTimeline::LiveTensor live;
+            live.tensor_name = ValueName(entry.second.value);
+            live.producer = entry.second.producer ? entry.second.producer->GetName() : std::string();
+            live.bytes = entry.second.bytes;
+            timeline_->live_at_peak.push_back(std::move(live));
+        }
+        std::stable_sort(timeline_->live_at_peak.begin(), timeline_->live_at_peak.end(),
+                         [](const MemoryTimeline::LiveTensor& a, const MemoryTimeline::LiveTensor& b) {
+                             return a.bytes > b.bytes;
+                         });
+    }
     
+    // 执行计划的第index步之后释放最后一次使用的张量
+    void ReleaseDead(size_t index, size_t step, const Node* node) {
+        if (!timeline_) {
+            return;
+        }
+        for (const Value* value : dead_after_[index]) {
+            Release(step, node, value);
+        }
+    }
+    
+    size_t GetLiveBytes() const { return live_; }
+
+private:
+    struct Buffer {
+        size_t bytes;
+        int refs;
+        const Value* value;     // 最先绑定该缓冲的值
+        const Node* producer;
+    };
+    
+    static std::string ValueName(const Value* value) {
+        return value->GetName().empty() ? "value_" + std::to_string(value->GetId()) : value->GetName();
+    }
+    
+    void Record(size_t step, const Node* node, const Value* value, int64_t bytes) {
+        MemoryEvent event;
+        event.step = step;
+        event.node_name = node ? node->GetName() : std::string();
+        event.tensor_name = ValueName(value);
+        event.bytes = bytes;
+        event.live_bytes = live_;
+        event.time_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start_).count();
+        timeline_->events.push_back(std::move(event));
+        Tracer::Instance().RecordCounter(TraceCategory::MEMORY, "live_bytes", static_cast<int64_t>(live_));
+    }
+    
+    MemoryTimeline* timeline_;
+    std::chrono::high_resolution_clock::time_point start_;
+    std::map<const char*, Buffer> buffers_;
+    std::unordered_map<const Value*, const char*> value_buffers_;
+    std::vector<std::vector<const Value*>> dead_after_;
+    size_t live_ = 0;
+};
+
+} // anonymous namespace
+
+Status BeginStateRun(const ExecutionPlan& plan, ExecutionState* state,
+                     const std::vector<Tensor*>& inputs) {
+    if (!state || &state->GetPlan() != &plan) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Execution state does not belong to the plan");
+    }
+    const std::vector<int>& input_slots = plan.GetInputSlots();
+    if (inputs.size() != input_slots.size()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                           "Input count mismatch");
+    }
+    
+    // 全部读写都经过state的槽位，不触碰Value上的张量
+    std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        tensors[input_slots[i]] = std::shared_ptr<Tensor>(inputs[i], [](Tensor*){});
+    }
+    // 预先绑定的输出直接作为生产者的输出张量（图输入直通、常量等没有生产者的值不替换）
+    for (size_t slot = 0; slot < tensors.size(); ++slot) {
+        const auto& bound = state->GetBoundOutput(static_cast<int>(slot));
+        if (bound && plan.GetValues()[slot]->GetProducer()) {
+            tensors[slot] = bound;
+        }
+    }
+    if (const ShapeProgram* shapes = plan.GetShapeProgram()) {
+        std::vector<std::shared_ptr<Tensor>> shape_values;
+        Status status = shapes->Evaluate(inputs, &shape_values);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (size_t i = 0; i < shape_values.size(); ++i) {
+            tensors[shapes->GetOutputSlots()[i]] = std::move(shape_values[i]);
+        }
+    }
     return Status::Ok();
 }
 
-Status ExecutionEngine::ExecuteInternal(const Graph* graph,
-                                       const std::vector<Tensor*>& inputs,
-                                       std::vector<Tensor*>& outputs,
-                                       const ExecutionOptions& options) {
+Status ExecuteStateSteps(const ExecutionPlan& plan, ExecutionState* state,
+                         size_t begin, size_t end, const ExecutionOptions& options) {
+    ExecutionContext ctx;
+    IntraOpParallelism intra_op;
+    intra_op.num_threads = options.intra_op_num_threads > 0 ?
+        options.intra_op_num_threads : static_cast<int>(ThreadPool::GetAvailableThreadCount());
+    intra_op.min_work_per_thread = options.intra_op_min_work_per_thread;
+    ctx.SetIntraOpParallelism(intra_op);
+    const CancellationToken* cancellation = options.cancellation.get();
+    ctx.SetCancellationToken(cancellation);
+    CancellationScope cancellation_scope(options.cancellation);
+    ctx.SetLoraBatch(options.lora.get());
+    
+    const std::vector<ExecutionStep>& steps = plan.GetSteps();
+    std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+    std::vector<Tensor*> step_inputs;
+    std::vector<Tensor*> step_outputs;
+    std::vector<std::shared_ptr<Tensor>> bound;
+    std::vector<std::shared_ptr<Tensor>> view_inputs;
+    WeightStreamingWindow weight_window(options.weight_streaming.get(), plan, begin, end);
+    for (size_t s = begin; s < end && s < steps.size(); ++s) {
+        const ExecutionStep& step = steps[s];
+        // 低优先级的运行在节点之间让给进行中的高优先级运行
+        PriorityScope::YieldToHigherPriority(cancellation);
+        if (cancellation && cancellation->IsTriggered()) {
+            return cancellation->Check();
+        }
+        weight_window.BeforeStep(s);
+        if (options.weight_prefetcher) {
+            options.weight_prefetcher->Advance(plan, s);
+        }
+        // 形状步骤已在BeginStateRun中求值
+        if (step.host_shape) {
+            for (int slot : step.release_slots) {
+                tensors[slot].reset();
+            }
+            weight_window.AfterStep(s);
+            continue;
+        }
+        // 绑定了输出缓冲的视图步骤仍要把结果写进该缓冲
+        if (step.view_op && !state->GetBoundOutput(step.output_slots[0])) {
+            view_inputs.clear();
+            for (int slot : step.input_slots) {
+                view_inputs.push_back(tensors[slot]);
+            }
+            if (std::shared_ptr<Tensor> view = CreateStepView(step, view_inputs)) {
+                tensors[step.output_slots[0]] = std::move(view);
+                for (int slot : step.release_slots) {
+                    tensors[slot].reset();
+                }
+                weight_window.AfterStep(s);
+                continue;
+            }
+        }
+    
+        step_inputs.clear();
+        for (int slot : step.input_slots) {
+            Status status = MakeInputContiguous(tensors[slot]);
+            if (!status.IsOk()) {
+                return status;
+            }
+            if (Tensor* tensor = tensors[slot].get()) {
+                step_inputs.push_back(tensor);
+            }
+        }
+        bound.clear();
+        for (int slot : step.output_slots) {
+            bound.push_back(tensors[slot]);
+        }
+        Status status = BindOutputTensors(step.node, step.provider, step_inputs, bound);
+        if (!status.IsOk()) {
+            return status;
+        }
+        step_outputs.clear();
+        for (size_t i = 0; i < bound.size(); ++i) {
+            const int slot = step.output_slots[i];
+            // 绑定的输出缓冲不能被替换：形状、类型或设备不符时在写入前报错
+            const auto& user_buffer = state->GetBoundOutput(slot);
+            if (user_buffer && bound[i] != user_buffer) {
+                return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                     "Bound output buffer for '" + plan.GetValues()[slot]->GetName() +
+                                     "' does not match the produced tensor " +
+                                     FormatDims(bound[i]->GetShape().dims));
+            }
+            tensors[slot] = bound[i];
+            step_outputs.push_back(bound[i].get());
+        }
+    
+        TraceScope trace(TraceCategory::NODE, step.node->GetName().c_str(), step.node->GetOpType().c_str());
+        ScopedOpTimer op_timer(step.op_metrics);
+        ctx.SetDeviceType(step.provider->GetDeviceType());
+        status = step.provider->ExecuteKernel(step.node, step_inputs, step_outputs, &ctx);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (int slot : step.release_slots) {
+            tensors[slot].reset();
+        }
+        weight_window.AfterStep(s);
+    }
+    // 最后一个节点执行期间触发时，其中被跳过的块使输出不完整
+    return cancellation ? cancellation->Check() : Status::Ok();
+}
+
+void EndStateRun(const ExecutionPlan& plan, ExecutionState* state, bool succeeded,
+                 std::vector<Tensor*>& outputs) {
+    std::vector<std::shared_ptr<Tensor>>& tensors = state->GetTensors();
+    outputs.clear();
+    if (succeeded) {
+        for (int slot : plan.GetOutputSlots()) {
+            if (tensors[slot]) {
+                outputs.push_back(tensors[slot].get());
+            }
+        }
+    }
+    // 调用方的输入和绑定的输出缓冲只在本次运行中有效，不留在state里
+    // （直通到图输出的输入保留到调用方取走输出，下一次执行开始时被覆盖）
+    const std::vector<int>& output_slots = plan.GetOutputSlots();
+    for (int slot : plan.GetInputSlots()) {
+        if (std::find(output_slots.begin(), output_slots.end(), slot) == output_slots.end()) {
+            tensors[slot].reset();
+        }
+    }
+    for (size_t slot = 0; slot < tensors.size(); ++slot) {
+        if (tensors[slot] && tensors[slot] == state->GetBoundOutput(static_cast<int>(slot))) {
+            tensors[slot].reset();
+        }
+    }
+}
+
+Status ExecutionEngine::ExecutePlan(const ExecutionPlan& plan,
+                                   ExecutionState* state,
+                                   const std::vector<Tensor*>& inputs,
+                                   std::vector<Tensor*>& outputs,
+                                   const ExecutionOptions& options) {
+    Status status = BeginStateRun(plan, state, inputs);
+    if (!status.IsOk()) {
+        return status;
+    }
+    status = ExecuteStateSteps(plan, state, 0, plan.GetSteps().size(), options);
+    EndStateRun(plan, state, status.IsOk(), outputs);
+    return status;
+}
+
+Status ExecutionEngine::RunPlan(const ExecutionPlan& plan,
+                               const std::vector<Tensor*>& inputs,
+                               std::vector<Tensor*>& outputs,
+                               const ExecutionOptions& options,
+                               ProfilingResult* profile) {
+    const std::vector<Value*>& values = plan.GetValues();
+    const std::vector<int>& input_slots = plan.GetInputSlots();
+    
     // 验证输入
-    if (inputs.size() != graph->GetInputs().size()) {
+    if (inputs.size() != input_slots.size()) {
         return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
                            "Input count mismatch");
     }
     
     // 绑定输入
     for (size_t i = 0; i < inputs.size(); ++i) {
-        graph->GetInputs()[i]->SetTensor(std::shared_ptr<Tensor>(inputs[i], [](Tensor*){}));
+        values[input_slots[i]]->SetTensor(std::shared_ptr<Tensor>(inputs[i], [](Tensor*){}));
+    }
+    // 形状计算分区只依赖输入的维度，在执行任何步骤之前于主机上求出
+    if (const ShapeProgram* shapes = plan.GetShapeProgram()) {
+        std::vector<std::shared_ptr<Tensor>> shape_values;
+        Status status = shapes->Evaluate(inputs, &shape_values);
+        if (!status.IsOk()) {
+            return status;
+        }
+        for (size_t i = 0; i < shape_values.size(); ++i) {
+            values[shapes->GetOutputSlots()[i]]->SetTensor(std::move(shape_values[i]));
+        }
     }
-    
-    // 获取执行顺序
-    std::vector<Node*> execution_order = scheduler_->GetExecutionOrder(graph);
     
     // 创建执行上下文
     ExecutionContext ctx;
+    IntraOpParallelism intra_op;
+    intra_op.num_threads = options.intra_op_num_threads > 0 ?
+        options.intra_op_num_threads : static_cast<int>(ThreadPool::GetAvailableThreadCount());
+    intra_op.min_work_per_thread = options.intra_op_min_work_per_thread;
+    ctx.SetIntraOpParallelism(intra_op);
+    const CancellationToken* cancellation = options.cancellation.get();
+    ctx.SetCancellationToken(cancellation);
+    CancellationScope cancellation_scope(options.cancellation);
+    ctx.SetLoraBatch(options.lora.get());
+    
+    // 硬件计数器在线程池创建之后打开，覆盖算子内并行的工作线程
+    HardwareCounters counters;
+    if (profile && options.profile_hardware_counters) {
+        ThreadPool::GetThreadCount();
+        Status status = counters.Open();
+        profile->hardware_counters = status.IsOk();
+        if (!status.IsOk()) {
+            profile->hardware_counter_error = status.Message();
+        }
+    }
+    
+    auto start_time = std::chrono::high_resolution_clock::now();
+    MemoryTimelineRecorder memory(profile ? &profile->memory_timeline : nullptr, plan, start_time);
+    for (int slot : input_slots) {
+        memory.Allocate(0, nullptr, values[slot]);
+    }
+    
+    // 多流执行：计划把独立分支分到了多条流上时，按步骤的流入队并用事件表达跨流依赖
+    StreamRun streams(plan, options.max_parallel_streams);
+    
+    // 按计划顺序执行每个节点
+    const std::vector<ExecutionStep>& steps = plan.GetSteps();
+    WeightStreamingWindow weight_window(options.weight_streaming.get(), plan, 0, steps.size());
+    for (size_t index = 0; index < steps.size(); ++index) {
+        const ExecutionStep& step = steps[index];
+        PriorityScope::YieldToHigherPriority(cancellation);
+        if (cancellation && cancellation->IsTriggered()) {
+            return cancellation->Check();
+        }
+        weight_window.BeforeStep(index);
+        if (options.weight_prefetcher) {
+            options.weight_prefetcher->Advance(plan, index);
+        }
+        const size_t profile_step = profile ? profile->node_profiles.size() : 0;
+        if (step.host_shape) {
+            memory.ReleaseDead(index, profile_step, step.node);
+            for (int slot : step.release_slots) {
+                if (streams.IsActive()) {
+                    streams.Retain(values[slot]->GetTensor());
+                }
+                values[slot]->SetTensor(nullptr);
+            }
+            weight_window.AfterStep(index);
+            continue;
+        }
+        const HardwareCounterValues counters_start = counters.IsOpen() ? counters.Read() : HardwareCounterValues();
+        auto node_start = std::chrono::high_resolution_clock::now();
     
-    // 执行每个节点
-    for (Node* node : execution_order) {
-        // 选择执行提供者 (参考ONNX Runtime的节点执行)
-        ExecutionProvider* provider = ExecutionProviderSelector::SelectProvider(node, backend_ptrs_);
-        if (!provider) {
-            return Status::Error(StatusCode::ERROR_NOT_FOUND,
-                               "No execution provider available for node: " + node->GetName());
-        }
-        
-        // 准备输入输出张量 (参考ONNX Runtime的IOBinding机制)
-        std::vector<Tensor*> node_inputs;
-        std::vector<Tensor*> node_outputs;
-        
-        for (Value* input : node->GetInputs()) {
-            if (input->GetTensor()) {
-                node_inputs.push_back(input->GetTensor().get());
+        std::shared_ptr<Tensor> view;
+        if (step.view_op) {
+            std::vector<std::shared_ptr<Tensor>> view_inputs;
+            for (int slot : step.input_slots) {
+                view_inputs.push_back(values[slot]->GetTensor());
             }
+            view = CreateStepView(step, view_inputs);
         }
-        
-        for (Value* output : node->GetOutputs()) {
-            // 创建输出张量
-            // 先推断输出形状
-            auto op = provider->CreateOperator(node->GetOpType());
-            if (op) {
-                std::vector<Shape> output_shapes;
-                Status shape_status = op->InferOutputShape(node_inputs, output_shapes);
-                if (shape_status.IsOk() && !output_shapes.empty()) {
-                    Shape output_shape = output_shapes[0];
-                    DataType output_dtype = node_inputs.empty() ? 
-                        DataType::FLOAT32 : node_inputs[0]->GetDataType();
-                    auto tensor = CreateTensor(output_shape, output_dtype, provider->GetDeviceType());
-                    output->SetTensor(tensor);
-                    node_outputs.push_back(tensor.get());
-                } else {
-                    // 形状推断失败，使用默认形状
-                    Shape default_shape({1});  // 默认1D
-                    auto tensor = CreateTensor(default_shape, DataType::FLOAT32, provider->GetDeviceType());
-                    output->SetTensor(tensor);
-                    node_outputs.push_back(tensor.get());
+        if (view) {
+            values[step.output_slots[0]]->SetTensor(view);
+        } else {
+            for (int slot : step.input_slots) {
+                std::shared_ptr<Tensor> tensor = values[slot]->GetTensor();
+                if (tensor && !tensor->IsContiguous()) {
+                    Status status = MakeInputContiguous(tensor);
+                    if (!status.IsOk()) {
+                        return status;
+                    }
+                    values[slot]->SetTensor(tensor);
+                }
+            }
+    
+            // 准备输出张量 (参考ONNX Runtime的IOBinding机制)
+            Status status = BindNodeOutputs(step.node, step.provider);
+            if (!status.IsOk()) {
+                return status;
+            }
+    
+            if (streams.IsActive()) {
+                status = streams.BeginStep(index, &ctx);
+                if (!status.IsOk()) {
+                    return status;
+                }
+            }
+    
+            // 执行节点 (参考ONNX Runtime的节点执行流程)；多流时事件记录在所属流的轨道上
+            TraceScope trace(TraceCategory::NODE, step.node->GetName().c_str(), step.node->GetOpType().c_str(),
+                             streams.IsActive() ? step.stream : -1);
+            ScopedOpTimer op_timer(step.op_metrics);
+            ctx.SetDeviceType(step.provider->GetDeviceType());
+            status = step.provider->ExecuteNode(step.node, &ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+    
+            if (streams.IsActive()) {
+                status = streams.EndStep(index);
+                if (!status.IsOk()) {
+                    return status;
                 }
-            } else {
-                // 无法创建算子，使用默认形状
-                Shape default_shape({1});
-                auto tensor = CreateTensor(default_shape, DataType::FLOAT32, provider->GetDeviceType());
-                output->SetTensor(tensor);
-                node_outputs.push_back(tensor.get());
             }
         }
-        
-        // 执行节点 (参考ONNX Runtime的节点执行流程)
-        ctx.SetDeviceType(provider->GetDeviceType());
-        Status status = provider->ExecuteNode(node, &ctx);
+    
+        if (profile) {
+            auto node_end = std::chrono::high_resolution_clock::now();
+    
+            // 节点输出的大小；存活字节数按缓冲计入时间线
+            size_t node_memory = 0;
+            for (int slot : step.output_slots) {
+                if (values[slot]->GetTensor()) {
+                    node_memory += values[slot]->GetTensor()->GetSizeInBytes();
+                }
+                memory.Allocate(profile_step, step.node, values[slot]);
+            }
+            memory.EndStep(profile_step, step.node);
+    
+            // 记录节点性能
+            ProfilingResult::NodeProfile node_profile;
+            node_profile.node_name = step.node->GetName();
+            node_profile.op_type = step.node->GetOpType();
+            node_profile.execution_time_ms =
+                std::chrono::duration<double, std::milli>(node_end - node_start).count();
+            node_profile.memory_used_bytes = node_memory;
+            node_profile.live_bytes = memory.GetLiveBytes();
+            const OperatorCost cost = CostModel::EstimateCost(step.node);
+            node_profile.estimated_flops = cost.flops;
+            node_profile.estimated_bytes = cost.GetBytes();
+            if (counters.IsOpen()) {
+                node_profile.counters = counters.Read() - counters_start;
+            }
+            profile->node_profiles.push_back(node_profile);
+        }
+    
+        // 释放最后一次使用后的中间张量
+        memory.ReleaseDead(index, profile_step, step.node);
+        for (int slot : step.release_slots) {
+            if (streams.IsActive()) {
+                streams.Retain(values[slot]->GetTensor());
+            }
+            values[slot]->SetTensor(nullptr);
+        }
+        weight_window.AfterStep(index);
+    }
+    
+    if (streams.IsActive()) {
+        Status status = streams.Synchronize();
         if (!status.IsOk()) {
             return status;
         }
     }
+    if (cancellation && cancellation->IsTriggered()) {
+        return cancellation->Check();
+    }
+    
+    if (profile) {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        profile->total_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        profile->peak_memory_bytes = profile->memory_timeline.peak_bytes;
+    }
     
     // 收集输出
     outputs.clear();
-    for (Value* output_value : graph->GetOutputs()) {
-        if (output_value->GetTensor()) {
-            outputs.push_back(output_value->GetTensor().get());
+    for (int slot : plan.GetOutputSlots()) {
+        if (values[slot]->GetTensor()) {
+            outputs.push_back(values[slot]->GetTensor().get());
         }
     }
     
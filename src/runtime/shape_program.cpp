@@ -0,0 +1,450 @@
+// 形状计算分区：构建计划时编译只计算形状的节点，绑定输入时在主机上用标量解释器求值
+// 每个值最多几个INT64元素，指令逐个元素计算，不经过算子、执行提供者与线程池
+
+#include "inferunity/execution_plan.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+namespace inferunity {
+
+namespace {
+
+// 作为形状计算输入的整数常量的元素上限，更大的常量不是形状
+constexpr size_t kMaxShapeConstantElements = 64;
+
+bool IsShapeDataType(DataType dtype) {
+    return dtype == DataType::INT64 || dtype == DataType::INT32;
+}
+
+int64_t GetIntAttribute(const Node& node, const std::string& key, int64_t default_value) {
+    const AttributeValue* attr = node.FindAttribute(key);
+    return attr && attr->GetType() == AttributeValue::Type::INT ? attr->GetInt() : default_value;
+}
+
+// ONNX Slice的边界规则：负数加上长度后，起点截到[0, n]（步长为负时[0, n-1]），终点截到[0, n]（步长为负时[-1, n-1]）
+void ClampSliceRange(int64_t n, int64_t step, int64_t* start, int64_t* end) {
+    if (*start < 0) *start += n;
+    if (*end < 0) *end += n;
+    if (step > 0) {
+        *start = std::min(std::max<int64_t>(*start, 0), n);
+        *end = std::min(std::max<int64_t>(*end, 0), n);
+    } else {
+        *start = std::min(std::max<int64_t>(*start, 0), n - 1);
+        *end = std::min(std::max<int64_t>(*end, -1), n - 1);
+    }
+}
+
+} // anonymous namespace
+
+std::unique_ptr<ShapeProgram> ShapeProgram::Build(const std::vector<Value*>& values,
+                                                  const std::vector<int>& input_slots,
+                                                  const std::vector<bool>& is_graph_output,
+                                                  std::vector<ExecutionStep>* steps) {
+    std::unique_ptr<ShapeProgram> program(new ShapeProgram());
+    std::vector<int> reg_of_slot(values.size(), -1);
+    std::vector<DataType> reg_dtype;
+    
+    // 图输入的槽位与其动态维度上的符号：符号 -> (图输入下标, 维度)
+    std::unordered_map<int, int> input_of_slot;
+    std::unordered_map<std::string, std::pair<int, int>> symbol_dims;
+    for (size_t i = 0; i < input_slots.size(); ++i) {
+        input_of_slot.emplace(input_slots[i], static_cast<int>(i));
+        const Shape& shape = values[input_slots[i]]->GetShape();
+        for (size_t d = 0; d < shape.dims.size() && d < shape.symbols.size(); ++d) {
+            if (!shape.symbols[d].empty()) {
+                symbol_dims.emplace(shape.symbols[d], std::make_pair(static_cast<int>(i), static_cast<int>(d)));
+            }
+        }
+    }
+    
+    // 形状推断给出的维度 -> DimTerm：静态维度为系数，动态维度须是符号与整数的乘积（如"2*batch*seq"）
+    auto parse_dim = [&symbol_dims](const Shape& shape, size_t d, DimTerm* term) {
+        const bool dynamic = shape.dims[d] < 0 || (d < shape.is_dynamic.size() && shape.is_dynamic[d]);
+        if (!dynamic) {
+            term->coefficient = shape.dims[d];
+            return true;
+        }
+        const std::string expr = d < shape.symbols.size() ? shape.symbols[d] : std::string();
+        if (expr.empty()) {
+            return false;
+        }
+        size_t pos = 0;
+        while (pos <= expr.size()) {
+            const size_t next = std::min(expr.find('*', pos), expr.size());
+            const std::string token = expr.substr(pos, next - pos);
+            if (token.empty()) {
+                return false;
+            }
+            if (std::all_of(token.begin(), token.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                term->coefficient *= std::stoll(token);
+            } else {
+                auto it = symbol_dims.find(token);
+                if (it == symbol_dims.end()) {
+                    return false;
+                }
+                term->factors.push_back(it->second);
+            }
+            pos = next + 1;
+        }
+        return true;
+    };
+    
+    auto add_register = [&](Register reg, DataType dtype) {
+        program->initial_.push_back(std::move(reg));
+        reg_dtype.push_back(dtype);
+        return static_cast<int>(program->initial_.size()) - 1;
+    };
+    
+    // 输入的寄存器：已编译节点的输出，或小整数常量（载入为初值）；都不是时返回-1
+    auto resolve_input = [&](int slot) {
+        if (reg_of_slot[slot] >= 0) {
+            return reg_of_slot[slot];
+        }
+        const Value* value = values[slot];
+        const Tensor* tensor = value->GetTensor().get();
+        if (value->GetProducer() || input_of_slot.count(slot) || !tensor || !tensor->GetData() ||
+            !IsShapeDataType(tensor->GetDataType()) || tensor->GetShape().dims.size() > 1 ||
+            tensor->GetElementCount() > kMaxShapeConstantElements) {
+            return -1;
+        }
+        Register reg;
+        reg.rank = static_cast<int>(tensor->GetShape().dims.size());
+        const size_t count = tensor->GetElementCount();
+        reg.data.resize(count);
+        for (size_t k = 0; k < count; ++k) {
+            reg.data[k] = tensor->GetDataType() == DataType::INT64
+                ? static_cast<const int64_t*>(tensor->GetData())[k]
+                : static_cast<const int32_t*>(tensor->GetData())[k];
+        }
+        reg_of_slot[slot] = add_register(std::move(reg), tensor->GetDataType());
+        return reg_of_slot[slot];
+    };
+    
+    static const std::unordered_map<std::string, OpCode> kOpCodes = {
+        {"Shape", OpCode::SHAPE}, {"Gather", OpCode::GATHER}, {"Concat", OpCode::CONCAT},
+        {"Slice", OpCode::SLICE}, {"Cast", OpCode::CAST}, {"Add", OpCode::ADD}, {"Sub", OpCode::SUB},
+        {"Mul", OpCode::MUL}, {"Div", OpCode::DIV}, {"Max", OpCode::MAX}, {"Min", OpCode::MIN},
+    };
+    
+    for (ExecutionStep& step : *steps) {
+        const Node& node = *step.node;
+        auto code = kOpCodes.find(node.GetOpType());
+        if (code == kOpCodes.end() || step.output_slots.size() != 1 || step.input_slots.empty() ||
+            is_graph_output[step.output_slots[0]]) {
+            continue;
+        }
+        // 失败时丢弃本节点新增的常量寄存器
+        const size_t num_registers = program->initial_.size();
+        std::vector<int> touched_slots;
+        auto rollback = [&]() {
+            program->initial_.resize(num_registers);
+            reg_dtype.resize(num_registers);
+            for (int slot : touched_slots) {
+                reg_of_slot[slot] = -1;
+            }
+        };
+    
+        Instruction instruction;
+        instruction.code = code->second;
+        Register result;
+        DataType dtype = DataType::INT64;
+        bool ok = true;
+        if (instruction.code == OpCode::SHAPE) {
+            // Shape只读输入的维度：图输入在运行时直接取实际维度，常量取静态形状，中间值取形状推断的结果
+            const int slot = step.input_slots[0];
+            const Value* input = values[slot];
+            const Tensor* tensor = input->GetTensor().get();
+            auto graph_input = input_of_slot.find(slot);
+            std::vector<DimTerm> dims;
+            if (graph_input != input_of_slot.end()) {
+                for (size_t d = 0; d < input->GetShape().dims.size(); ++d) {
+                    DimTerm term;
+                    term.factors.emplace_back(graph_input->second, static_cast<int>(d));
+                    dims.push_back(term);
+                }
+                ok = tensor != nullptr;
+            } else if (tensor && (!tensor->GetData() || !input->GetProducer())) {
+                // 有数据的中间值是上一次运行留下的张量，其形状不代表本次运行
+                const Shape& shape = tensor->GetShape();
+                for (size_t d = 0; d < shape.dims.size() && ok; ++d) {
+                    DimTerm term;
+                    ok = parse_dim(shape, d, &term);
+                    dims.push_back(term);
+                }
+            } else {
+                ok = false;
+            }
+            if (ok) {
+                const int64_t rank = static_cast<int64_t>(dims.size());
+                int64_t start = GetIntAttribute(node, "start", 0);
+                int64_t end = GetIntAttribute(node, "end", rank);
+                if (start < 0) start += rank;
+                if (end < 0) end += rank;
+                start = std::min(std::max<int64_t>(start, 0), rank);
+                end = std::max(start, std::min(std::max<int64_t>(end, 0), rank));
+                instruction.dims.assign(dims.begin() + start, dims.begin() + end);
+            }
+        } else {
+            for (int slot : step.input_slots) {
+                const bool was_resolved = reg_of_slot[slot] >= 0;
+                const int reg = resolve_input(slot);
+                if (reg < 0) {
+                    ok = false;
+                    break;
+                }
+                if (!was_resolved) {
+                    touched_slots.push_back(slot);
+                }
+                instruction.inputs.push_back(reg);
+            }
+        }
+    
+        // 秩与类型：所有值的秩不超过1，算术与拼接的操作数类型一致
+        if (ok && instruction.code != OpCode::SHAPE) {
+            const std::vector<int>& in = instruction.inputs;
+            dtype = reg_dtype[in[0]];
+            switch (instruction.code) {
+                case OpCode::GATHER: {
+                    const int64_t axis = GetIntAttribute(node, "axis", 0);
+                    ok = in.size() == 2 && program->initial_[in[0]].rank == 1 && (axis == 0 || axis == -1);
+                    result.rank = ok ? program->initial_[in[1]].rank : 1;
+                    break;
+                }
+                case OpCode::CONCAT: {
+                    const int64_t axis = GetIntAttribute(node, "axis", 0);
+                    ok = axis == 0 || axis == -1;
+                    for (int reg : in) {
+                        ok = ok && program->initial_[reg].rank == 1 && reg_dtype[reg] == dtype;
+                    }
+                    break;
+                }
+                case OpCode::SLICE: {
+                    // 属性形式（opset < 10）的starts/ends/axes/steps转成常量寄存器，与输入形式统一
+                    ok = program->initial_[in[0]].rank == 1;
+                    static const char* kSliceAttributes[] = {"starts", "ends", "axes", "steps"};
+                    for (size_t k = 0; k < 4 && ok; ++k) {
+                        const AttributeValue* attr = node.FindAttribute(kSliceAttributes[k]);
+                        if (attr && attr->GetType() == AttributeValue::Type::INTS) {
+                            Register param;
+                            param.data = attr->GetInts();
+                            const int reg = add_register(std::move(param), DataType::INT64);
+                            if (instruction.inputs.size() > k + 1) {
+                                instruction.inputs[k + 1] = reg;
+                            } else if (instruction.inputs.size() == k + 1) {
+                                instruction.inputs.push_back(reg);
+                            } else {
+                                ok = false;
+                            }
+                        }
+                    }
+                    ok = ok && instruction.inputs.size() >= 3;
+                    for (size_t k = 1; k < instruction.inputs.size() && ok; ++k) {
+                        ok = program->initial_[instruction.inputs[k]].rank == 1;
+                    }
+                    break;
+                }
+                case OpCode::CAST: {
+                    switch (GetIntAttribute(node, "to", 0)) {
+                        case 6: dtype = DataType::INT32; break;
+                        case 7: dtype = DataType::INT64; break;
+                        default: ok = false; break;
+                    }
+                    result.rank = program->initial_[in[0]].rank;
+                    break;
+                }
+                default: {
+                    // 逐元素算术：广播只允许单元素对任意长度
+                    ok = in.size() >= 2 && (in.size() == 2 || instruction.code == OpCode::MAX ||
+                                            instruction.code == OpCode::MIN);
+                    result.rank = 0;
+                    for (int reg : in) {
+                        ok = ok && reg_dtype[reg] == dtype;
+                        result.rank = std::max(result.rank, program->initial_[reg].rank);
+                    }
+                    break;
+                }
+            }
+        }
+        if (!ok) {
+            rollback();
+            continue;
+        }
+    
+        instruction.dtype = dtype;
+        instruction.output = add_register(result, dtype);
+        reg_of_slot[step.output_slots[0]] = instruction.output;
+        program->instructions_.push_back(std::move(instruction));
+        step.host_shape = true;
+        step.wait_steps.clear();
+        ++program->num_nodes_;
+    }
+    if (program->num_nodes_ == 0) {
+        return nullptr;
+    }
+    
+    // 被其他步骤读取的值在求值后放进槽位；生产者分配在设备提供者上时上传到该设备，消费者照常读取设备张量
+    std::vector<bool> read_by_kernel(values.size(), false);
+    for (const ExecutionStep& step : *steps) {
+        if (!step.host_shape) {
+            for (int slot : step.input_slots) {
+                read_by_kernel[slot] = true;
+            }
+        }
+    }
+    for (const ExecutionStep& step : *steps) {
+        const int slot = step.output_slots[0];
+        if (!step.host_shape || !read_by_kernel[slot]) {
+            continue;
+        }
+        Output output;
+        output.reg = reg_of_slot[slot];
+        output.dtype = reg_dtype[output.reg];
+        output.device = step.provider->GetDeviceType();
+        program->outputs_.push_back(output);
+        program->output_slots_.push_back(slot);
+    }
+    return program;
+}
+
+Status ShapeProgram::Evaluate(const std::vector<Tensor*>& inputs,
+                              std::vector<std::shared_ptr<Tensor>>* outputs) const {
+    std::vector<Register> regs = initial_;
+    for (const Instruction& instruction : instructions_) {
+        Register& out = regs[instruction.output];
+        out.data.clear();
+        auto in = [&](size_t k) -> const Register& { return regs[instruction.inputs[k]]; };
+        switch (instruction.code) {
+            case OpCode::SHAPE: {
+                for (const DimTerm& term : instruction.dims) {
+                    int64_t dim = term.coefficient;
+                    for (const auto& factor : term.factors) {
+                        const Tensor* input = factor.first < static_cast<int>(inputs.size()) ? inputs[factor.first] : nullptr;
+                        if (!input || factor.second >= static_cast<int>(input->GetShape().dims.size())) {
+                            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                                 "Input rank does not match the model for shape computation");
+                        }
+                        dim *= input->GetShape().dims[factor.second];
+                    }
+                    out.data.push_back(dim);
+                }
+                break;
+            }
+            case OpCode::GATHER: {
+                const int64_t n = static_cast<int64_t>(in(0).data.size());
+                for (int64_t index : in(1).data) {
+                    if (index < -n || index >= n) {
+                        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                             "Gather index out of range in shape computation");
+                    }
+                    out.data.push_back(in(0).data[index < 0 ? index + n : index]);
+                }
+                break;
+            }
+            case OpCode::CONCAT: {
+                for (size_t k = 0; k < instruction.inputs.size(); ++k) {
+                    out.data.insert(out.data.end(), in(k).data.begin(), in(k).data.end());
+                }
+                break;
+            }
+            case OpCode::SLICE: {
+                // 1维数据上只有axes为0（或-1）的切片有意义
+                const std::vector<int64_t>& starts = in(1).data;
+                const std::vector<int64_t>& ends = in(2).data;
+                const bool has_axes = instruction.inputs.size() > 3;
+                const bool has_steps = instruction.inputs.size() > 4;
+                if (starts.size() != 1 || ends.size() != 1 || (has_axes && in(3).data.size() != 1) ||
+                    (has_axes && in(3).data[0] != 0 && in(3).data[0] != -1) ||
+                    (has_steps && (in(4).data.size() != 1 || in(4).data[0] == 0))) {
+                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                         "Unsupported Slice parameters in shape computation");
+                }
+                const int64_t step = has_steps ? in(4).data[0] : 1;
+                int64_t start = starts[0];
+                int64_t end = ends[0];
+                ClampSliceRange(static_cast<int64_t>(in(0).data.size()), step, &start, &end);
+                for (int64_t i = start; step > 0 ? i < end : i > end; i += step) {
+                    out.data.push_back(in(0).data[i]);
+                }
+                break;
+            }
+            case OpCode::CAST: {
+                out.data = in(0).data;
+                if (instruction.dtype == DataType::INT32) {
+                    for (int64_t& v : out.data) {
+                        v = static_cast<int32_t>(v);
+                    }
+                }
+                break;
+            }
+            default: {
+                size_t length = 1;
+                for (size_t k = 0; k < instruction.inputs.size(); ++k) {
+                    const size_t n = in(k).data.size();
+                    if (n != 1 && length != 1 && n != length) {
+                        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                             "Incompatible shapes in shape computation");
+                    }
+                    length = n != 1 ? n : length;
+                }
+                out.data.assign(length, 0);
+                for (size_t i = 0; i < length; ++i) {
+                    auto at = [&](size_t k) { return in(k).data.size() == 1 ? in(k).data[0] : in(k).data[i]; };
+                    int64_t acc = at(0);
+                    for (size_t k = 1; k < instruction.inputs.size(); ++k) {
+                        const int64_t v = at(k);
+                        switch (instruction.code) {
+                            case OpCode::ADD: acc += v; break;
+                            case OpCode::SUB: acc -= v; break;
+                            case OpCode::MUL: acc *= v; break;
+                            case OpCode::DIV:
+                                if (v == 0) {
+                                    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT,
+                                                         "Division by zero in shape computation");
+                                }
+                                acc /= v;
+                                break;
+                            case OpCode::MAX: acc = std::max(acc, v); break;
+                            default: acc = std::min(acc, v); break;
+                        }
+                    }
+                    out.data[i] = acc;
+                }
+                break;
+            }
+        }
+    }
+    
+    outputs->clear();
+    outputs->reserve(outputs_.size());
+    for (const Output& output : outputs_) {
+        const Register& reg = regs[output.reg];
+        const Shape shape = reg.rank == 0 ? Shape() : Shape({static_cast<int64_t>(reg.data.size())});
+        if (reg.rank == 0 && reg.data.size() != 1) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Scalar shape value has multiple elements");
+        }
+        std::shared_ptr<Tensor> host = CreateTensor(shape, output.dtype);
+        for (size_t i = 0; i < reg.data.size(); ++i) {
+            if (output.dtype == DataType::INT64) {
+                static_cast<int64_t*>(host->GetData())[i] = reg.data[i];
+            } else {
+                static_cast<int32_t*>(host->GetData())[i] = static_cast<int32_t>(reg.data[i]);
+            }
+        }
+        if (output.device != DeviceType::CPU) {
+            std::shared_ptr<Tensor> device = CreateTensor(shape, output.dtype, output.device);
+            Status status = device ? device->CopyFrom(*host)
+                                   : Status::Error(StatusCode::ERROR_OUT_OF_MEMORY, "Cannot allocate shape tensor");
+            if (!status.IsOk()) {
+                return status;
+            }
+            host = std::move(device);
+        }
+        outputs->push_back(std::move(host));
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
@@ -1,31 +1,640 @@
 // 线程池实现
-// 参考 ONNX Runtime 和 TensorFlow 的线程池设计
+// 参考 TBB/Eigen ThreadPool 的工作窃取设计：
+// 每个工作线程持有一个Chase-Lev双端队列（Lê等人2013年的C11内存模型版本），
+// 本线程从底部压入/弹出，其他线程从顶部随机窃取；外部线程提交的任务进入全局注入队列，
+// 空闲线程先自旋寻找任务，超过自旋次数后才在条件变量上休眠；突发模式（见ThreadPoolBurst）期间
+// 再按时间自旋一段，推理中算子之间的空闲不经过休眠/唤醒。
+// NUMA感知时每个节点一组工作线程（绑定在该节点的CPU上），注入队列、休眠与窃取都在组内进行，
+// 绑定到节点的线程提交的任务只由该节点的线程执行。
+// 混合架构上可只用性能核；否则按线程所在核的算力把并行循环多切几块，由线程动态领取。
+// 任务带有提交线程的优先级（见PriorityScope）：注入队列按优先级分开，LOW任务不进入工作线程自己的队列，
+// 保留的工作线程只执行HIGH任务。
+// 调度统计（见ThreadPoolStats）：每个工作线程在自己的缓存行上累计任务来源、排队等待、自旋与休眠的时间，
+// ParallelFor的最后一个执行者释放共享状态时记录该区域的不均衡度
 
 #include "inferunity/runtime.h"
 #include "inferunity/logger.h"
+#include "inferunity/tracing.h"
+#include "inferunity/metrics.h"
+#include "inferunity/numa.h"
+#include "inferunity/memory.h"
+#include "runtime/cpu_relax.h"
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <condition_variable>
-#include <queue>
+#include <deque>
 #include <atomic>
 #include <vector>
 #include <functional>
+#include <cerrno>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 namespace inferunity {
 
-// 线程池实现
+namespace {
+
+// 队列中的任务：通过函数指针调用，ParallelFor的辅助任务无需std::function
+struct Task {
+    void (*run)(Task* task) = nullptr;
+    RunPriority priority = RunPriority::NORMAL;  // 提交时设置
+    int64_t submit_ns = 0;                       // 提交时刻（指标开启时），用于排队等待时间
+};
+
+constexpr size_t kPriorityCount = 3;
+
+struct FunctionTask : Task {
+    std::function<void()> fn;
+    
+    explicit FunctionTask(std::function<void()> f) : fn(std::move(f)) {
+        run = [](Task* task) {
+            FunctionTask* self = static_cast<FunctionTask*>(task);
+            try {
+                self->fn();
+            } catch (const std::exception& e) {
+                LOG_ERROR("Thread pool task exception: " + std::string(e.what()));
+            }
+            delete self;
+        };
+    }
+};
+
+// 固定容量的Chase-Lev工作窃取队列；满时由调用方改投注入队列
+class WorkStealingDeque {
+public:
+    static constexpr int64_t kCapacity = 4096;
+    
+    WorkStealingDeque() {
+        for (auto& slot : buffer_) {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    
+    // 仅所有者线程调用
+    bool Push(Task* task) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t >= kCapacity) {
+            return false;
+        }
+        buffer_[b & (kCapacity - 1)].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // 仅所有者线程调用
+    Task* Pop() {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Task* task = buffer_[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // 最后一个元素，与窃取者竞争
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+    
+    // 任意线程调用
+    Task* Steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Task* task = buffer_[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+    
+    size_t Size() const {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Task*> buffer_[kCapacity];
+};
+
+// 当前线程所属的线程池及其工作线程编号（非工作线程为-1）
+thread_local ThreadPoolImpl* tls_pool = nullptr;
+thread_local int tls_worker_index = -1;
+
+// 突发模式：进行中的作用域数与最近一次设置的自旋时长，对所有线程池生效（Configure重建后仍然有效）
+std::atomic<int> g_burst_count{0};
+std::atomic<int64_t> g_burst_spin_ns{0};
+// 当前线程发起的ParallelFor由自己先执行第一块（见ThreadPoolBurst）
+thread_local bool tls_caller_runs_first = false;
+// 当前线程最内层的ThreadPoolScope及其给出的intra-op/inter-op池（nullptr表示全局线程池）
+thread_local ThreadPoolScope* tls_scope = nullptr;
+thread_local ThreadPoolImpl* tls_intra_op_pool = nullptr;
+thread_local ThreadPoolImpl* tls_inter_op_pool = nullptr;
+// 当前线程最内层的CancellationScope给出的令牌
+thread_local std::shared_ptr<CancellationToken> tls_cancellation;
+// 当前线程最内层的PriorityScope给出的优先级（DEFAULT表示没有给出），工作线程执行任务期间为任务的优先级
+thread_local RunPriority tls_priority = RunPriority::DEFAULT;
+// 进行中的HIGH作用域数；LOW运行在节点边界等待其归零
+std::atomic<int> g_active_high_runs{0};
+std::mutex g_priority_mutex;
+std::condition_variable g_priority_condition;
+
+inline RunPriority CurrentPriority() {
+    return tls_priority == RunPriority::DEFAULT ? RunPriority::NORMAL : tls_priority;
+}
+
+uint32_t NextRandom() {
+    thread_local uint32_t state = static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// 所有存活的线程池（全局线程池与ThreadPoolInstance），fork前后由InstallForkHandlers的处理函数停止/重启
+// 其工作线程；创建线程池时持锁启动线程，fork期间不会出现未登记的工作线程
+std::mutex g_live_pools_mutex;
+std::vector<ThreadPoolImpl*> g_live_pools;
+
+} // anonymous namespace
+
+// 线程池实现（在匿名命名空间之外，ThreadPoolInstance/ThreadPoolScope持有它的shared_ptr）
 class ThreadPoolImpl {
 private:
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    mutable std::mutex queue_mutex_;  // 标记为mutable以便const方法使用
-    std::condition_variable condition_;
-    std::condition_variable finished_condition_;
-    std::atomic<bool> stop_{false};
-    std::atomic<size_t> active_tasks_{0};  // 正在执行的任务数
+    // 只由所属的工作线程累加，GetStats/ResetStats从其他线程读写
+    struct alignas(64) WorkerCounters {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> local_tasks{0};
+        std::atomic<uint64_t> injected_tasks{0};
+        std::atomic<uint64_t> stolen_tasks{0};
+        std::atomic<int64_t> busy_ns{0};
+        std::atomic<int64_t> queue_wait_ns{0};
+        std::atomic<int64_t> spin_ns{0};
+        std::atomic<int64_t> sleep_ns{0};
+    };
+    
+    struct alignas(64) Worker {
+        WorkStealingDeque deque;
+        std::thread thread;
+        size_t group = 0;
+        bool high_priority_only = false;  // 为HIGH任务保留的线程
+        WorkerCounters counters;
+    };
+    
+    // 工作线程组：不启用NUMA感知时只有一组，包含全部工作线程
+    struct Group {
+        int numa_node = -1;             // 组所在的节点，-1表示不区分节点
+        std::vector<int> cpus;          // 组内线程绑定的CPU集合（numa_node >= 0时）
+        std::vector<size_t> members;    // 组内的工作线程编号
+    
+        size_t reserved = 0;            // 组内只执行HIGH任务的线程数
+    
+        // 组外线程提交的任务与LOW任务，按优先级各一个队列
+        std::mutex inject_mutex;
+        std::deque<Task*> inject_queues[kPriorityCount];
+        std::atomic<size_t> inject_sizes[kPriorityCount] = {};
+    
+        // 休眠/唤醒：work_epoch在每次提交后递增，休眠线程以其变化作为唤醒条件
+        std::mutex park_mutex;
+        std::condition_variable park_condition;
+        std::atomic<uint64_t> work_epoch{0};
+        std::atomic<int> sleepers{0};
+    };
+    
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Group>> groups_;
+    std::vector<int> node_groups_;  // 节点 -> 组，没有工作线程的节点为-1
+    std::atomic<size_t> next_group_{0};  // 未绑定节点的线程提交时轮流选组
     size_t thread_count_;
+    int spin_iterations_;
+    // 只用性能核时工作线程可运行的CPU，否则为空
+    std::vector<int> restricted_cpus_;
+    // 混合架构上并行循环的块数相对线程数的放大倍数（见GetBalancedChunkCount）
+    double chunk_scale_ = 1.0;
+    bool pin_threads_ = false;
+    size_t reserved_ = 0;  // 只执行HIGH任务的线程数
+    std::atomic<bool> stop_{false};
+    
+    // 已提交但尚未执行完成的任务数，用于WaitAll
+    std::atomic<size_t> outstanding_{0};
+    std::mutex finished_mutex_;
+    std::condition_variable finished_condition_;
+    
+    // 常驻指标：利用率 = rate(busy_ns) / 1e9 / threads（所有线程池合计）
+    std::shared_ptr<Counter> busy_metric_;
+    std::shared_ptr<Counter> tasks_metric_;
+    std::shared_ptr<Gauge> threads_metric_;
+    std::shared_ptr<Counter> queue_wait_metric_;
+    std::shared_ptr<Counter> spin_metric_;
+    std::shared_ptr<Counter> sleep_metric_;
+    std::shared_ptr<Counter> steals_metric_;
+    std::shared_ptr<ShardedHistogram> imbalance_metric_;
+    
+    // 并行区域的不均衡度（千分比）的累计
+    std::atomic<uint64_t> parallel_regions_{0};
+    std::atomic<uint64_t> imbalance_sum_milli_{0};
+    std::atomic<uint64_t> imbalance_max_milli_{0};
+    
+    void Inject(Group& group, Task* task) {
+        const size_t priority = static_cast<size_t>(task->priority);
+        std::lock_guard<std::mutex> lock(group.inject_mutex);
+        group.inject_queues[priority].push_back(task);
+        group.inject_sizes[priority].fetch_add(1, std::memory_order_release);
+    }
+    
+    Task* PopInjected(Group& group, RunPriority priority) {
+        const size_t index = static_cast<size_t>(priority);
+        if (group.inject_sizes[index].load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(group.inject_mutex);
+        std::deque<Task*>& queue = group.inject_queues[index];
+        if (queue.empty()) {
+            return nullptr;
+        }
+        Task* task = queue.front();
+        queue.pop_front();
+        group.inject_sizes[index].fetch_sub(1, std::memory_order_release);
+        return task;
+    }
+    
+    // 工作线程只把NORMAL任务压入自己的队列：HIGH任务进入注入队列，任何线程（包括保留线程）都先取它；
+    // LOW任务进入LOW队列，只在没有其他任务时执行
+    bool PushLocal(Task* task) {
+        return tls_pool == this && task->priority == RunPriority::NORMAL &&
+               workers_[tls_worker_index]->deque.Push(task);
+    }
+    
+    void Wake(Group& group, size_t count) {
+        group.work_epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (group.sleepers.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(group.park_mutex);
+        // 有保留线程时notify_one可能唤醒一个不执行该任务的保留线程
+        if (count > 1 || group.reserved > 0) {
+            group.park_condition.notify_all();
+        } else {
+            group.park_condition.notify_one();
+        }
+    }
+    
+    // HIGH注入队列 -> 自己的队列 -> NORMAL注入队列 -> 从随机起点依次窃取组内其他线程 -> LOW注入队列；
+    // 保留线程只取前两者
+    Task* FindTask(int index) {
+        Worker& worker = *workers_[index];
+        Group& group = *groups_[worker.group];
+        WorkerCounters& counters = worker.counters;
+        if (Task* task = PopInjected(group, RunPriority::HIGH)) {
+            counters.injected_tasks.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+        if (Task* task = worker.deque.Pop()) {
+            counters.local_tasks.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+        if (worker.high_priority_only) {
+            return nullptr;
+        }
+        if (Task* task = PopInjected(group, RunPriority::NORMAL)) {
+            counters.injected_tasks.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+        const size_t n = group.members.size();
+        const size_t start = NextRandom() % n;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t victim = group.members[(start + i) % n];
+            if (static_cast<int>(victim) == index) continue;
+            if (Task* task = workers_[victim]->deque.Steal()) {
+                counters.stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+                steals_metric_->Add();
+                return task;
+            }
+        }
+        Task* task = PopInjected(group, RunPriority::LOW);
+        if (task) {
+            counters.injected_tasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+    
+    // 调用线程对应的组：工作线程为自己的组，绑定到节点的外部线程为该节点的组，否则为-1
+    int CallerGroup() const {
+        if (tls_pool == this) {
+            return static_cast<int>(workers_[tls_worker_index]->group);
+        }
+        const int node = GetCurrentNumaNode();
+        if (groups_.size() > 1 && node >= 0 && static_cast<size_t>(node) < node_groups_.size()) {
+            return node_groups_[node];
+        }
+        return -1;
+    }
+    
+    size_t NextGroup() {
+        return next_group_.fetch_add(1, std::memory_order_relaxed) % groups_.size();
+    }
+    
+    void RunTask(Task* task) {
+        WorkerCounters& counters = workers_[tls_worker_index]->counters;
+        counters.tasks.fetch_add(1, std::memory_order_relaxed);
+        {
+            // 工作线程轨道上任务之间的空白即为空闲（自旋或休眠）
+            TraceScope trace(TraceCategory::THREAD_POOL, "Task");
+            const bool record = MetricsRegistry::Instance().IsEnabled();
+            const int64_t start_ns = record ? MetricNowNs() : 0;
+            if (record && task->submit_ns > 0) {
+                const int64_t wait_ns = std::max<int64_t>(0, start_ns - task->submit_ns);
+                counters.queue_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+                queue_wait_metric_->Add(static_cast<uint64_t>(wait_ns));
+                Tracer::Instance().RecordCounter(TraceCategory::THREAD_POOL, "task_queue_wait_us", wait_ns / 1000);
+            }
+            // 任务中再提交的任务继承它的优先级
+            tls_priority = task->priority;
+            task->run(task);
+            tls_priority = RunPriority::DEFAULT;
+            if (record) {
+                const int64_t busy_ns = MetricNowNs() - start_ns;
+                counters.busy_ns.fetch_add(busy_ns, std::memory_order_relaxed);
+                busy_metric_->Add(static_cast<uint64_t>(busy_ns));
+                tasks_metric_->Add();
+            }
+        }
+        if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(finished_mutex_);
+            finished_condition_.notify_all();
+        }
+    }
+    
+    void WorkerLoop(int index, bool pin) {
+        tls_pool = this;
+        tls_worker_index = index;
+        Group& group = *groups_[workers_[index]->group];
+        Tracer::SetCurrentThreadName("ThreadPool worker " + std::to_string(index));
+        // 组内线程的分配优先来自本节点的内存池
+        SetCurrentNumaNode(group.numa_node);
+#if defined(__linux__)
+        if (group.numa_node >= 0 || pin || !restricted_cpus_.empty()) {
+            // NUMA分组：绑定到节点的全部CPU，pin时再固定到节点内的第i个CPU；只用性能核时同样对待性能核集合
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (group.numa_node >= 0 || !restricted_cpus_.empty()) {
+                const std::vector<int>& cpus = group.numa_node >= 0 ? group.cpus : restricted_cpus_;
+                const size_t rank = static_cast<size_t>(
+                    std::find(group.members.begin(), group.members.end(), static_cast<size_t>(index)) -
+                    group.members.begin());
+                for (size_t i = 0; i < cpus.size(); ++i) {
+                    if (!pin || i == rank % cpus.size()) {
+                        CPU_SET(cpus[i], &set);
+                    }
+                }
+            } else {
+                const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+                CPU_SET(static_cast<unsigned>(index) % cpus, &set);
+            }
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+                LOG_WARNING("Failed to pin thread pool worker " + std::to_string(index));
+            }
+        }
+#else
+        (void)pin;
+#endif
+    
+        WorkerCounters& counters = workers_[index]->counters;
+        // 从找不到任务到找到任务或开始休眠的时间计为自旋
+        auto end_spin = [this, &counters](int64_t idle_start_ns) {
+            if (idle_start_ns > 0) {
+                const int64_t spin_ns = MetricNowNs() - idle_start_ns;
+                counters.spin_ns.fetch_add(spin_ns, std::memory_order_relaxed);
+                spin_metric_->Add(static_cast<uint64_t>(spin_ns));
+            }
+        };
+        while (true) {
+            if (Task* task = FindTask(index)) {
+                RunTask(task);
+                continue;
+            }
+            const int64_t idle_start_ns = MetricsRegistry::Instance().IsEnabled() ? MetricNowNs() : 0;
+    
+            // 自旋阶段：短暂空闲时避免休眠/唤醒的系统调用开销
+            Task* task = nullptr;
+            for (int i = 0; i < spin_iterations_ && !task; ++i) {
+                CpuRelax();
+                if ((i & 15) == 15) {
+                    task = FindTask(index);
+                }
+            }
+            if (task) {
+                end_spin(idle_start_ns);
+                RunTask(task);
+                continue;
+            }
+    
+            // 突发阶段：推理进行中时按时间再自旋一段，每次执行完任务后重新计时；
+            // 间或让出CPU，与调用线程共享核时不至于饿死它
+            if (g_burst_count.load(std::memory_order_relaxed) > 0) {
+                const auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::nanoseconds(g_burst_spin_ns.load(std::memory_order_relaxed));
+                for (int i = 0; !task && g_burst_count.load(std::memory_order_relaxed) > 0; ++i) {
+                    CpuRelax();
+                    if ((i & 15) != 15) {
+                        continue;
+                    }
+                    task = FindTask(index);
+                    if (!task && (i & 1023) == 1023) {
+                        if (stop_.load(std::memory_order_acquire) ||
+                            std::chrono::steady_clock::now() >= deadline) {
+                            break;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+                if (task) {
+                    end_spin(idle_start_ns);
+                    RunTask(task);
+                    continue;
+                }
+            }
+    
+            // 休眠阶段：先记录epoch再检查一次，避免丢失唤醒
+            const uint64_t epoch = group.work_epoch.load(std::memory_order_seq_cst);
+            task = FindTask(index);
+            end_spin(idle_start_ns);
+            if (task) {
+                RunTask(task);
+                continue;
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                return;
+            }
+            const int64_t sleep_start_ns = idle_start_ns > 0 ? MetricNowNs() : 0;
+            {
+                std::unique_lock<std::mutex> lock(group.park_mutex);
+                group.sleepers.fetch_add(1, std::memory_order_seq_cst);
+                group.park_condition.wait(lock, [this, &group, epoch] {
+                    return stop_.load(std::memory_order_acquire) ||
+                           group.work_epoch.load(std::memory_order_seq_cst) != epoch;
+                });
+                group.sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            }
+            if (sleep_start_ns > 0) {
+                const int64_t sleep_ns = MetricNowNs() - sleep_start_ns;
+                counters.sleep_ns.fetch_add(sleep_ns, std::memory_order_relaxed);
+                sleep_metric_->Add(static_cast<uint64_t>(sleep_ns));
+            }
+        }
+    }
+    
+    void StartWorkers() {
+        stop_.store(false, std::memory_order_release);
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i]->thread = std::thread(&ThreadPoolImpl::WorkerLoop, this, static_cast<int>(i), pin_threads_);
+        }
+    }
+    
+    void StopWorkers() {
+        stop_.store(true, std::memory_order_release);
+        for (auto& group : groups_) {
+            std::lock_guard<std::mutex> lock(group->park_mutex);
+            group->park_condition.notify_all();
+        }
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+    
+    // 每个节点一组，线程数按节点的CPU数分配（每组至少一个线程）
+    void CreateNumaGroups(const NumaTopology& topology) {
+        const size_t num_nodes = topology.nodes.size();
+        size_t total_cpus = 0;
+        for (const NumaNode& node : topology.nodes) {
+            total_cpus += node.cpus.size();
+        }
+        std::vector<size_t> counts(num_nodes, 1);
+        size_t assigned = num_nodes;
+        for (size_t n = 0; n < num_nodes; ++n) {
+            const size_t share = thread_count_ * topology.nodes[n].cpus.size() / std::max<size_t>(total_cpus, 1);
+            const size_t extra = std::min(share > 0 ? share - 1 : 0, thread_count_ - assigned);
+            counts[n] += extra;
+            assigned += extra;
+        }
+        // 整除剩下的线程依次补给各组
+        for (size_t n = 0; assigned < thread_count_; n = (n + 1) % num_nodes) {
+            ++counts[n];
+            ++assigned;
+        }
+        size_t next_worker = 0;
+        for (size_t n = 0; n < num_nodes; ++n) {
+            auto group = std::make_unique<Group>();
+            group->numa_node = static_cast<int>(n);
+            group->cpus = topology.nodes[n].cpus;
+            if (!restricted_cpus_.empty()) {
+                // 节点上没有性能核时保留节点的全部CPU
+                std::vector<int> cpus;
+                for (int cpu : group->cpus) {
+                    if (std::find(restricted_cpus_.begin(), restricted_cpus_.end(), cpu) != restricted_cpus_.end()) {
+                        cpus.push_back(cpu);
+                    }
+                }
+                if (!cpus.empty()) {
+                    group->cpus = std::move(cpus);
+                }
+            }
+            for (size_t i = 0; i < counts[n]; ++i) {
+                workers_[next_worker]->group = n;
+                group->members.push_back(next_worker++);
+            }
+            node_groups_.push_back(static_cast<int>(n));
+            groups_.push_back(std::move(group));
+        }
+    }
+    
+    // 从编号最大的线程起保留，每组至少留一个普通线程
+    void ReserveHighPriorityWorkers(size_t count) {
+        for (size_t i = workers_.size(); i > 0 && reserved_ < count; --i) {
+            Worker& worker = *workers_[i - 1];
+            Group& group = *groups_[worker.group];
+            if (group.reserved + 1 < group.members.size()) {
+                worker.high_priority_only = true;
+                ++group.reserved;
+                ++reserved_;
+            }
+        }
+    }
     
+    // 各线程所在核的算力之和除以其中最慢核的算力，再除以线程数。固定到CPU时线程所在的核是确定的；
+    // 否则假设调度器先用算力高的核
+    void ComputeChunkScale(const CpuCoreTopology& topology, bool pin) {
+        if (!topology.hybrid) {
+            return;
+        }
+        std::vector<int> capacities;
+        if (pin && restricted_cpus_.empty()) {
+            const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < thread_count_; ++i) {
+                capacities.push_back(topology.CapacityOf(static_cast<int>(i % cpus)));
+            }
+        } else {
+            std::vector<int> available;
+            for (const CpuCore& core : topology.cores) {
+                if (restricted_cpus_.empty() || core.type == CoreType::PERFORMANCE) {
+                    available.push_back(core.capacity);
+                }
+            }
+            std::sort(available.begin(), available.end(), std::greater<int>());
+            for (size_t i = 0; i < thread_count_ && !available.empty(); ++i) {
+                capacities.push_back(available[i % available.size()]);
+            }
+        }
+        if (capacities.empty()) {
+            return;
+        }
+        const int slowest = std::max(1, *std::min_element(capacities.begin(), capacities.end()));
+        double total = 0.0;
+        for (int capacity : capacities) {
+            total += static_cast<double>(capacity) / slowest;
+        }
+        chunk_scale_ = total / static_cast<double>(capacities.size());
+    }
+
 public:
-    ThreadPoolImpl(size_t num_threads = 0) {
+    explicit ThreadPoolImpl(const ThreadPoolOptions& options) {
+        const CpuCoreTopology& cores = GetCpuCoreTopology();
+        if (options.performance_cores_only && cores.hybrid) {
+            restricted_cpus_ = cores.PerformanceCpus();
+        }
+        size_t num_threads = options.num_threads;
+        if (num_threads == 0 && !restricted_cpus_.empty()) {
+            num_threads = restricted_cpus_.size();
+        }
         if (num_threads == 0) {
             // 使用硬件并发数
             num_threads = std::thread::hardware_concurrency();
@@ -33,131 +642,788 @@ public:
                 num_threads = 4;  // 默认4个线程
             }
         }
+#if defined(__EMSCRIPTEN__) && defined(INFERUNITY_WASM_THREAD_POOL_SIZE)
+        // Web Worker只能预先创建：超出PTHREAD_POOL_SIZE的线程要等创建者回到事件循环才启动，
+        // 创建者同步等待它们时会死锁
+        num_threads = std::min<size_t>(num_threads, std::max(1, INFERUNITY_WASM_THREAD_POOL_SIZE));
+#endif
         thread_count_ = num_threads;
-        
-        // 创建工作线程
+        spin_iterations_ = std::max(0, options.spin_iterations);
+        ComputeChunkScale(cores, options.pin_threads);
+        MetricsRegistry& registry = MetricsRegistry::Instance();
+        busy_metric_ = registry.GetCounter("inferunity_thread_pool_busy_ns_total", {},
+                                           "Time thread pool workers spent running tasks");
+        tasks_metric_ = registry.GetCounter("inferunity_thread_pool_tasks_total", {},
+                                            "Tasks executed by thread pool workers");
+        threads_metric_ = registry.GetGauge("inferunity_thread_pool_threads", {},
+                                            "Worker threads in live thread pools");
+        threads_metric_->Add(static_cast<int64_t>(num_threads));
+        queue_wait_metric_ = registry.GetCounter("inferunity_thread_pool_queue_wait_ns_total", {},
+                                                 "Time tasks waited in thread pool queues before running");
+        spin_metric_ = registry.GetCounter("inferunity_thread_pool_spin_ns_total", {},
+                                           "Time idle thread pool workers spent spinning for work");
+        sleep_metric_ = registry.GetCounter("inferunity_thread_pool_sleep_ns_total", {},
+                                            "Time idle thread pool workers spent sleeping");
+        steals_metric_ = registry.GetCounter("inferunity_thread_pool_steals_total", {},
+                                             "Tasks stolen from other workers' queues");
+        imbalance_metric_ = registry.GetHistogram("inferunity_thread_pool_parallel_for_imbalance",
+                                                  {1.05, 1.1, 1.25, 1.5, 2.0, 3.0, 5.0, 10.0}, {},
+                                                  "Busiest participant time / mean participant time per ParallelFor");
+    
+        // 先创建全部队列与分组，再启动线程，保证窃取时workers_与groups_不再变化
         for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        condition_.wait(lock, [this] {
-                            return stop_ || !tasks_.empty();
-                        });
-                        
-                        if (stop_ && tasks_.empty()) {
-                            return;
-                        }
-                        
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                        active_tasks_++;
-                    }
-                    
-                    // 执行任务
-                    try {
-                        task();
-                    } catch (const std::exception& e) {
-                        LOG_ERROR("Thread pool task exception: " + std::string(e.what()));
-                    }
-                    
-                    // 任务完成，减少计数
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        active_tasks_--;
-                        if (active_tasks_ == 0 && tasks_.empty()) {
-                            finished_condition_.notify_all();
-                        }
-                    }
-                }
-            });
+            workers_.push_back(std::make_unique<Worker>());
         }
-        
-        LOG_INFO("Thread pool created with " + std::to_string(num_threads) + " threads");
+        const NumaTopology& topology = GetNumaTopology();
+        if (options.numa_aware && topology.nodes.size() > 1 && num_threads >= topology.nodes.size()) {
+            CreateNumaGroups(topology);
+        } else {
+            groups_.push_back(std::make_unique<Group>());
+            for (size_t i = 0; i < num_threads; ++i) {
+                groups_[0]->members.push_back(i);
+            }
+        }
+        ReserveHighPriorityWorkers(options.reserved_high_priority_threads);
+        pin_threads_ = options.pin_threads;
+        {
+            std::lock_guard<std::mutex> lock(g_live_pools_mutex);
+            StartWorkers();
+            g_live_pools.push_back(this);
+        }
+    
+        LOG_INFO("Thread pool created with " + std::to_string(num_threads) + " threads" +
+                 (groups_.size() > 1 ? " in " + std::to_string(groups_.size()) + " NUMA groups" : "") +
+                 (!restricted_cpus_.empty() ? " on " + std::to_string(restricted_cpus_.size()) +
+                  " performance cores" : "") +
+                 (reserved_ > 0 ? ", " + std::to_string(reserved_) + " reserved for high priority" : ""));
     }
     
-    template<typename F>
-    void Enqueue(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (stop_) {
-                LOG_WARNING("Thread pool is stopped, cannot enqueue task");
-                return;
+    // 工作线程提交到自己的队列，其他线程提交到所在组（未绑定节点时轮流选组）的注入队列
+    void Submit(Task* task) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        task->priority = CurrentPriority();
+        task->submit_ns = MetricsRegistry::Instance().IsEnabled() ? MetricNowNs() : 0;
+        const int caller = CallerGroup();
+        Group& group = *groups_[caller >= 0 ? static_cast<size_t>(caller) : NextGroup()];
+        if (!PushLocal(task)) {
+            Inject(group, task);
+        }
+        Wake(group, 1);
+    }
+    
+    // 未绑定节点的外部线程提交的一批任务分散到各组
+    void SubmitBatch(Task* const* tasks, size_t count) {
+        outstanding_.fetch_add(count, std::memory_order_relaxed);
+        const RunPriority priority = CurrentPriority();
+        const int64_t submit_ns = MetricsRegistry::Instance().IsEnabled() ? MetricNowNs() : 0;
+        for (size_t i = 0; i < count; ++i) {
+            tasks[i]->priority = priority;
+            tasks[i]->submit_ns = submit_ns;
+        }
+        const int caller = CallerGroup();
+        if (caller >= 0) {
+            Group& group = *groups_[caller];
+            for (size_t i = 0; i < count; ++i) {
+                if (!PushLocal(tasks[i])) {
+                    Inject(group, tasks[i]);
+                }
             }
-            tasks_.emplace(std::forward<F>(f));
+            Wake(group, count);
+            return;
+        }
+        const size_t first = NextGroup();
+        const size_t num_groups = std::min(groups_.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            Inject(*groups_[(first + i) % groups_.size()], tasks[i]);
+        }
+        for (size_t g = 0; g < num_groups; ++g) {
+            Wake(*groups_[(first + g) % groups_.size()], (count + num_groups - 1 - g) / num_groups);
+        }
+    }
+    
+    // 唤醒所有休眠的线程（突发模式开始时），它们找不到任务时进入突发自旋而不是立即再休眠
+    void WakeAll() {
+        for (auto& group : groups_) {
+            Wake(*group, group->members.size());
         }
-        condition_.notify_one();
+    }
+    
+    void Enqueue(std::function<void()> f) {
+        if (stop_.load(std::memory_order_acquire)) {
+            LOG_WARNING("Thread pool is stopped, cannot enqueue task");
+            return;
+        }
+        Submit(new FunctionTask(std::move(f)));
     }
     
     void WaitAll() {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
+        std::unique_lock<std::mutex> lock(finished_mutex_);
         finished_condition_.wait(lock, [this] {
-            return tasks_.empty() && active_tasks_ == 0;
+            return outstanding_.load(std::memory_order_acquire) == 0;
         });
     }
     
+    bool IsWorkerThread() const {
+        return tls_pool == this;
+    }
+    
     size_t GetThreadCount() const {
         return thread_count_;
     }
     
+    size_t GetGroupCount() const {
+        return groups_.size();
+    }
+    
+    size_t GetBalancedChunkCount(size_t threads) const {
+        return std::max(threads, static_cast<size_t>(static_cast<double>(threads) * chunk_scale_ + 0.5));
+    }
+    
+    // 调用线程提交的任务可由多少个工作线程执行：保留线程只计入HIGH优先级的调用
+    size_t GetAvailableThreadCount() const {
+        const int caller = CallerGroup();
+        const bool high = CurrentPriority() == RunPriority::HIGH;
+        if (caller >= 0) {
+            const Group& group = *groups_[caller];
+            return group.members.size() - (high ? 0 : group.reserved);
+        }
+        return thread_count_ - (high ? 0 : reserved_);
+    }
+    
     size_t GetPendingTaskCount() const {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        return tasks_.size();
+        size_t pending = 0;
+        for (const auto& group : groups_) {
+            for (const auto& size : group->inject_sizes) {
+                pending += size.load(std::memory_order_relaxed);
+            }
+        }
+        for (const auto& worker : workers_) {
+            pending += worker->deque.Size();
+        }
+        return pending;
+    }
+    
+    void RecordParallelRegion(double imbalance) {
+        const uint64_t milli = static_cast<uint64_t>(imbalance * 1000.0 + 0.5);
+        parallel_regions_.fetch_add(1, std::memory_order_relaxed);
+        imbalance_sum_milli_.fetch_add(milli, std::memory_order_relaxed);
+        uint64_t max = imbalance_max_milli_.load(std::memory_order_relaxed);
+        while (milli > max && !imbalance_max_milli_.compare_exchange_weak(max, milli, std::memory_order_relaxed)) {
+        }
+        imbalance_metric_->Record(imbalance);
+        Tracer::Instance().RecordCounter(TraceCategory::THREAD_POOL, "parallel_for_imbalance_pct",
+                                         static_cast<int64_t>(milli / 10));
+    }
+    
+    ThreadPoolStats GetStats() const {
+        ThreadPoolStats stats;
+        for (const auto& worker : workers_) {
+            const WorkerCounters& counters = worker->counters;
+            ThreadPoolWorkerStats entry;
+            entry.tasks = counters.tasks.load(std::memory_order_relaxed);
+            entry.local_tasks = counters.local_tasks.load(std::memory_order_relaxed);
+            entry.injected_tasks = counters.injected_tasks.load(std::memory_order_relaxed);
+            entry.stolen_tasks = counters.stolen_tasks.load(std::memory_order_relaxed);
+            entry.busy_ns = counters.busy_ns.load(std::memory_order_relaxed);
+            entry.queue_wait_ns = counters.queue_wait_ns.load(std::memory_order_relaxed);
+            entry.spin_ns = counters.spin_ns.load(std::memory_order_relaxed);
+            entry.sleep_ns = counters.sleep_ns.load(std::memory_order_relaxed);
+            stats.workers.push_back(entry);
+        }
+        stats.parallel_regions = parallel_regions_.load(std::memory_order_relaxed);
+        if (stats.parallel_regions > 0) {
+            stats.mean_imbalance = static_cast<double>(imbalance_sum_milli_.load(std::memory_order_relaxed)) /
+                                   1000.0 / static_cast<double>(stats.parallel_regions);
+            stats.max_imbalance = static_cast<double>(imbalance_max_milli_.load(std::memory_order_relaxed)) / 1000.0;
+        }
+        return stats;
+    }
+    
+    void ResetStats() {
+        for (auto& worker : workers_) {
+            WorkerCounters& counters = worker->counters;
+            for (auto* counter : {&counters.tasks, &counters.local_tasks, &counters.injected_tasks,
+                                  &counters.stolen_tasks}) {
+                counter->store(0, std::memory_order_relaxed);
+            }
+            for (auto* counter : {&counters.busy_ns, &counters.queue_wait_ns, &counters.spin_ns,
+                                  &counters.sleep_ns}) {
+                counter->store(0, std::memory_order_relaxed);
+            }
+        }
+        parallel_regions_.store(0, std::memory_order_relaxed);
+        imbalance_sum_milli_.store(0, std::memory_order_relaxed);
+        imbalance_max_milli_.store(0, std::memory_order_relaxed);
+    }
+    
+    // fork前：工作线程执行完能找到的任务后退出，再锁住外部线程提交时使用的锁，
+    // 子进程中不会留下被已不存在的线程持有的锁
+    void SuspendForFork() {
+        StopWorkers();
+        for (auto& group : groups_) {
+            group->inject_mutex.lock();
+            group->park_mutex.lock();
+        }
+        finished_mutex_.lock();
+    }
+    
+    // fork后（父子进程都调用）：解锁并按原配置重新启动工作线程；fork期间提交的任务留在队列中，由新线程执行
+    void ResumeAfterFork() {
+        finished_mutex_.unlock();
+        for (auto& group : groups_) {
+            group->park_mutex.unlock();
+            group->inject_mutex.unlock();
+        }
+        StartWorkers();
     }
     
     ~ThreadPoolImpl() {
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
+            std::lock_guard<std::mutex> lock(g_live_pools_mutex);
+            g_live_pools.erase(std::remove(g_live_pools.begin(), g_live_pools.end(), this), g_live_pools.end());
+        }
+        // 已提交的任务会在线程退出前全部执行完
+        WaitAll();
+        StopWorkers();
+        threads_metric_->Add(-static_cast<int64_t>(thread_count_));
+    
+        LOG_INFO("Thread pool destroyed");
+    }
+};
+
+namespace {
+
+// ParallelFor的共享状态：一次调用只分配一次，辅助任务内嵌其中
+// 调用方与每个辅助任务各持有一个引用，最后释放者负责删除
+struct ParallelForState {
+    struct Helper : Task {
+        ParallelForState* state = nullptr;
+    };
+    
+    int64_t begin = 0, end = 0, grain = 1, chunks = 0;
+    ThreadPool::RangeFunction fn = nullptr;
+    void* context = nullptr;
+    // 指标开启时记录各执行者的耗时，最后释放者计算不均衡度并交给pool
+    ThreadPoolImpl* pool = nullptr;
+    bool record = false;
+    int64_t participants = 0;
+    std::atomic<int64_t> busy_sum_ns{0};
+    std::atomic<int64_t> busy_max_ns{0};
+    // 发起线程的取消令牌；调用方等待全部块完成后才返回，令牌在此期间有效
+    const CancellationToken* cancellation = nullptr;
+    alignas(64) std::atomic<int64_t> next{0};
+    alignas(64) std::atomic<int64_t> done{0};
+    std::atomic<int64_t> refs{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::vector<Helper> helpers;
+    
+    // 块通过原子计数器领取；迟到的辅助任务领不到块时直接返回，不会再访问fn。返回是否执行了块
+    bool RunChunks() {
+        bool ran = false;
+        while (true) {
+            const int64_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunks) {
+                return ran;
+            }
+            RunChunk(chunk);
+            ran = true;
+        }
+    }
+    
+    void RecordParticipant(int64_t busy_ns) {
+        busy_sum_ns.fetch_add(busy_ns, std::memory_order_relaxed);
+        int64_t max = busy_max_ns.load(std::memory_order_relaxed);
+        while (busy_ns > max && !busy_max_ns.compare_exchange_weak(max, busy_ns, std::memory_order_relaxed)) {
         }
-        condition_.notify_all();
-        
-        for (std::thread& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
+    }
+    
+    // 运行已取消时跳过，仍计入完成数
+    void RunChunk(int64_t chunk) {
+        const int64_t chunk_begin = begin + chunk * grain;
+        try {
+            if (!cancellation || !cancellation->IsTriggered()) {
+                fn(context, chunk_begin, std::min(end, chunk_begin + grain));
             }
+        } catch (const std::exception& e) {
+            LOG_ERROR("ParallelFor chunk exception: " + std::string(e.what()));
         }
-        
-        LOG_INFO("Thread pool destroyed");
+        if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+    
+    // 此时所有执行者都已记录耗时；辅助任务在其工作线程的任务内释放，pool仍然存活
+    void Release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            const int64_t sum = busy_sum_ns.load(std::memory_order_relaxed);
+            if (record && sum > 0) {
+                pool->RecordParallelRegion(static_cast<double>(busy_max_ns.load(std::memory_order_relaxed)) *
+                                           static_cast<double>(participants) / static_cast<double>(sum));
+            }
+            delete this;
+        }
+    }
+    
+    static void RunHelper(Task* task) {
+        ParallelForState* state = static_cast<Helper*>(task)->state;
+        const int64_t start_ns = state->record ? MetricNowNs() : 0;
+        if (state->RunChunks() && state->record) {
+            state->RecordParticipant(MetricNowNs() - start_ns);
+        }
+        state->Release();
     }
 };
 
-// 全局线程池实例
-static std::unique_ptr<ThreadPoolImpl> g_thread_pool = nullptr;
-static std::once_flag g_pool_init_flag;
-static std::once_flag g_pool_destroy_flag;
+// 全局线程池实例；Configure可在空闲时重建
+std::mutex g_pool_mutex;
+std::unique_ptr<ThreadPoolImpl> g_thread_pool;
+std::atomic<ThreadPoolImpl*> g_thread_pool_ptr{nullptr};
+ThreadPoolOptions g_pool_options;
 
-ThreadPoolImpl* GetThreadPool(size_t num_threads = 0) {
-    std::call_once(g_pool_init_flag, [num_threads]() {
-        g_thread_pool = std::make_unique<ThreadPoolImpl>(num_threads);
-        // 注册退出时清理函数
+void CreateThreadPoolLocked() {
+    static std::once_flag atexit_flag;
+    g_thread_pool = std::make_unique<ThreadPoolImpl>(g_pool_options);
+    g_thread_pool_ptr.store(g_thread_pool.get(), std::memory_order_release);
+    // 注册退出时清理函数
+    std::call_once(atexit_flag, []() {
         std::atexit([]() {
-            if (g_thread_pool) {
-                g_thread_pool.reset();
-            }
+            std::lock_guard<std::mutex> lock(g_pool_mutex);
+            g_thread_pool_ptr.store(nullptr, std::memory_order_release);
+            g_thread_pool.reset();
         });
     });
+}
+
+ThreadPoolImpl* GetThreadPool() {
+    ThreadPoolImpl* pool = g_thread_pool_ptr.load(std::memory_order_acquire);
+    if (pool) {
+        return pool;
+    }
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+    if (!g_thread_pool) {
+        CreateThreadPoolLocked();
+    }
     return g_thread_pool.get();
 }
 
+// 调用线程的intra-op池：作用域给出的池，其次是所在的工作线程的池，最后是全局线程池
+ThreadPoolImpl* IntraOpPool() {
+    if (tls_intra_op_pool) {
+        return tls_intra_op_pool;
+    }
+    return tls_pool ? tls_pool : GetThreadPool();
+}
+
+ThreadPoolImpl* InterOpPool() {
+    return tls_inter_op_pool ? tls_inter_op_pool : GetThreadPool();
+}
+
+// 最后一个引用可能在该池自己的工作线程上释放（例如作用域位于其任务内部），
+// 此时析构会等待自己，改由一个分离的线程销毁
+std::shared_ptr<ThreadPoolImpl> MakeThreadPool(const ThreadPoolOptions& options) {
+    return std::shared_ptr<ThreadPoolImpl>(new ThreadPoolImpl(options), [](ThreadPoolImpl* pool) {
+        if (tls_pool == pool) {
+            std::thread([pool]() { delete pool; }).detach();
+        } else {
+            delete pool;
+        }
+    });
+}
+
+#ifndef _WIN32
+// fork前：先停线程池（工作线程退出时线程缓存归还内存池），再停内存池与日志的后台线程并持有各自的锁；
+// 持有g_pool_mutex使进行中的Configure与全局线程池的首次创建不会被fork截断
+void PrepareFork() {
+    g_pool_mutex.lock();
+    g_live_pools_mutex.lock();
+    for (ThreadPoolImpl* pool : g_live_pools) {
+        pool->SuspendForFork();
+    }
+    MemoryPoolBeforeFork();
+    Logger::Instance().BeforeFork();
+}
+
+// fork后（父子进程相同）：按相反顺序恢复
+void ResumeAfterFork() {
+    Logger::Instance().AfterFork();
+    MemoryPoolAfterFork();
+    for (ThreadPoolImpl* pool : g_live_pools) {
+        pool->ResumeAfterFork();
+    }
+    g_live_pools_mutex.unlock();
+    g_pool_mutex.unlock();
+}
+#endif
+
+} // anonymous namespace
+
+void InstallForkHandlers() {
+#ifndef _WIN32
+    static std::once_flag install_flag;
+    std::call_once(install_flag, []() {
+        // 先初始化日志与内存池的单例，处理函数中不再发生首次构造
+        Logger::Instance();
+        FreeMemory(AllocateMemory(1, 64));
+        if (pthread_atfork(&PrepareFork, &ResumeAfterFork, &ResumeAfterFork) != 0) {
+            LOG_ERROR("pthread_atfork failed, fork is not safe while thread pools are running");
+        }
+    });
+#endif
+}
+
+Status ForkWorkers(size_t num_workers, const std::function<int(size_t worker_index)>& worker_main,
+                   std::vector<int>* worker_pids) {
+#ifdef _WIN32
+    (void)num_workers;
+    (void)worker_main;
+    (void)worker_pids;
+    return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "fork is not available on this platform");
+#else
+    if (!worker_main || !worker_pids) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "ForkWorkers requires worker_main and worker_pids");
+    }
+    if (tls_pool) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "ForkWorkers cannot be called from a thread pool worker");
+    }
+    InstallForkHandlers();
+    worker_pids->clear();
+    for (size_t i = 0; i < num_workers; ++i) {
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR,
+                                 "fork failed for worker " + std::to_string(i) + ", errno " + std::to_string(errno));
+        }
+        if (pid == 0) {
+            int exit_code = 1;
+            try {
+                exit_code = worker_main(i);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Worker " + std::to_string(i) + " exception: " + std::string(e.what()));
+            }
+            // _exit不运行父进程注册的atexit与静态析构，子进程自己的输出在此写出
+            Logger::Instance().Flush();
+            std::cout.flush();
+            std::cerr.flush();
+            ::_exit(exit_code);
+        }
+        worker_pids->push_back(static_cast<int>(pid));
+    }
+    LOG_INFO("Forked " + std::to_string(num_workers) + " workers");
+    return Status::Ok();
+#endif
+}
+
 // 公共接口实现
+void ThreadPool::Configure(const ThreadPoolOptions& options) {
+    std::unique_ptr<ThreadPoolImpl> old_pool;
+    {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        g_pool_options = options;
+        if (g_thread_pool) {
+            old_pool = std::move(g_thread_pool);
+            CreateThreadPoolLocked();
+        }
+    }
+    // 旧线程池在析构中等待已提交任务完成；在锁外销毁，期间提交的新任务进入新线程池
+    old_pool.reset();
+}
+
 void ThreadPool::EnqueueTask(std::function<void()> task) {
-    GetThreadPool()->Enqueue(std::move(task));
+    ThreadPoolScope* scope = tls_scope;
+    if (scope) {
+        // 任务在工作线程上恢复提交时的线程池设置，并在执行完之前保持这些池存活
+        task = [task = std::move(task), intra_op = scope->intra_op_, inter_op = scope->inter_op_]() {
+            ThreadPoolScope restore(intra_op, inter_op);
+            task();
+        };
+    }
+    InterOpPool()->Enqueue(std::move(task));
 }
 
 void ThreadPool::WaitAll() {
-    GetThreadPool()->WaitAll();
+    InterOpPool()->WaitAll();
 }
 
 size_t ThreadPool::GetThreadCount() {
-    return GetThreadPool()->GetThreadCount();
+    return IntraOpPool()->GetThreadCount();
+}
+
+size_t ThreadPool::GetInterOpThreadCount() {
+    return InterOpPool()->GetThreadCount();
+}
+
+size_t ThreadPool::GetAvailableThreadCount() {
+    return IntraOpPool()->GetAvailableThreadCount();
+}
+
+size_t ThreadPool::GetNumaGroupCount() {
+    return IntraOpPool()->GetGroupCount();
+}
+
+size_t ThreadPool::GetBalancedChunkCount(size_t threads) {
+    return IntraOpPool()->GetBalancedChunkCount(threads);
+}
+
+bool ThreadPool::IsWorkerThread() {
+    return IntraOpPool()->IsWorkerThread();
 }
 
 size_t ThreadPool::GetPendingTaskCount() {
-    return GetThreadPool()->GetPendingTaskCount();
+    return IntraOpPool()->GetPendingTaskCount();
 }
 
-} // namespace inferunity
+ThreadPoolStats ThreadPool::GetStats() {
+    return IntraOpPool()->GetStats();
+}
+
+void ThreadPool::ResetStats() {
+    IntraOpPool()->ResetStats();
+}
+
+std::string ThreadPoolStats::ToString() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << std::left << std::setw(8) << "Worker" << std::right << std::setw(10) << "Tasks" << std::setw(10) << "Local"
+        << std::setw(10) << "Injected" << std::setw(10) << "Stolen" << std::setw(12) << "Busy(ms)"
+        << std::setw(12) << "Wait(ms)" << std::setw(12) << "Spin(ms)" << std::setw(12) << "Sleep(ms)" << "\n";
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const ThreadPoolWorkerStats& w = workers[i];
+        out << std::left << std::setw(8) << i << std::right << std::setw(10) << w.tasks << std::setw(10)
+            << w.local_tasks << std::setw(10) << w.injected_tasks << std::setw(10) << w.stolen_tasks
+            << std::setw(12) << w.busy_ns / 1e6 << std::setw(12) << w.queue_wait_ns / 1e6
+            << std::setw(12) << w.spin_ns / 1e6 << std::setw(12) << w.sleep_ns / 1e6 << "\n";
+    }
+    out << "ParallelFor regions: " << parallel_regions << ", imbalance mean " << mean_imbalance
+        << ", max " << max_imbalance << "\n";
+    return out.str();
+}
+
+void ThreadPool::BeginBurst(int64_t spin_us) {
+    g_burst_spin_ns.store(std::max<int64_t>(spin_us, 0) * 1000, std::memory_order_relaxed);
+    g_burst_count.fetch_add(1, std::memory_order_seq_cst);
+    // 请求到达时预先唤醒，第一个ParallelFor不再等待休眠线程被唤醒
+    IntraOpPool()->WakeAll();
+}
+
+void ThreadPool::EndBurst() {
+    g_burst_count.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+ThreadPoolBurst::ThreadPoolBurst(int64_t spin_us, bool caller_runs_first)
+    : active_(spin_us > 0), previous_caller_runs_first_(tls_caller_runs_first) {
+    tls_caller_runs_first = caller_runs_first;
+    if (active_) {
+        ThreadPool::BeginBurst(spin_us);
+    }
+}
 
+ThreadPoolBurst::~ThreadPoolBurst() {
+    if (active_) {
+        ThreadPool::EndBurst();
+    }
+    tls_caller_runs_first = previous_caller_runs_first_;
+}
+
+ThreadPoolInstance::ThreadPoolInstance(const ThreadPoolOptions& options)
+    : options_(options), impl_(MakeThreadPool(options)) {}
+
+ThreadPoolInstance::~ThreadPoolInstance() = default;
+
+std::shared_ptr<ThreadPoolInstance> ThreadPoolInstance::Create(const ThreadPoolOptions& options) {
+    return std::make_shared<ThreadPoolInstance>(options);
+}
+
+void ThreadPoolInstance::Reconfigure(const ThreadPoolOptions& options) {
+    std::shared_ptr<ThreadPoolImpl> replacement = MakeThreadPool(options);
+    std::shared_ptr<ThreadPoolImpl> old_pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        old_pool = std::move(impl_);
+        impl_ = std::move(replacement);
+    }
+    // 没有进行中的作用域时旧池在这里等待已提交任务完成后销毁，否则由最后一个作用域销毁
+    old_pool.reset();
+}
+
+void ThreadPoolInstance::Resize(size_t num_threads) {
+    ThreadPoolOptions options = GetOptions();
+    options.num_threads = num_threads;
+    Reconfigure(options);
+}
+
+ThreadPoolOptions ThreadPoolInstance::GetOptions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+size_t ThreadPoolInstance::GetThreadCount() const {
+    return Acquire()->GetThreadCount();
+}
+
+std::shared_ptr<ThreadPoolImpl> ThreadPoolInstance::Acquire() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return impl_;
+}
+
+ThreadPoolScope::ThreadPoolScope(const std::shared_ptr<ThreadPoolInstance>& intra_op,
+                                 const std::shared_ptr<ThreadPoolInstance>& inter_op)
+    : ThreadPoolScope(intra_op ? intra_op->Acquire() : nullptr,
+                      inter_op ? inter_op->Acquire() : nullptr) {}
+
+ThreadPoolScope::ThreadPoolScope(std::shared_ptr<ThreadPoolImpl> intra_op,
+                                 std::shared_ptr<ThreadPoolImpl> inter_op)
+    : intra_op_(std::move(intra_op)), inter_op_(std::move(inter_op)), previous_(tls_scope) {
+    // 未给出的池沿用外层作用域，任务只需捕获最内层作用域
+    if (previous_) {
+        if (!intra_op_) {
+            intra_op_ = previous_->intra_op_;
+        }
+        if (!inter_op_) {
+            inter_op_ = previous_->inter_op_;
+        }
+    }
+    tls_scope = this;
+    tls_intra_op_pool = intra_op_.get();
+    tls_inter_op_pool = inter_op_.get();
+}
+
+ThreadPoolScope::~ThreadPoolScope() {
+    tls_scope = previous_;
+    tls_intra_op_pool = previous_ ? previous_->intra_op_.get() : nullptr;
+    tls_inter_op_pool = previous_ ? previous_->inter_op_.get() : nullptr;
+}
+
+CancellationScope::CancellationScope(std::shared_ptr<CancellationToken> token) : previous_(tls_cancellation) {
+    if (token) {
+        tls_cancellation = std::move(token);
+    }
+}
+
+CancellationScope::~CancellationScope() {
+    tls_cancellation = std::move(previous_);
+}
+
+const std::shared_ptr<CancellationToken>& CancellationScope::Current() {
+    return tls_cancellation;
+}
+
+PriorityScope::PriorityScope(RunPriority priority, bool fallback) : previous_(tls_priority) {
+    if (priority == RunPriority::DEFAULT || (fallback && previous_ != RunPriority::DEFAULT)) {
+        return;
+    }
+    tls_priority = priority;
+    if (priority == RunPriority::HIGH) {
+        g_active_high_runs.fetch_add(1, std::memory_order_acq_rel);
+        counted_ = true;
+    }
+}
+
+PriorityScope::~PriorityScope() {
+    tls_priority = previous_;
+    if (counted_ && g_active_high_runs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(g_priority_mutex);
+        g_priority_condition.notify_all();
+    }
+}
+
+RunPriority PriorityScope::Current() {
+    return CurrentPriority();
+}
+
+int PriorityScope::ActiveHighPriorityRuns() {
+    return g_active_high_runs.load(std::memory_order_acquire);
+}
+
+void PriorityScope::YieldToHigherPriority(const CancellationToken* cancellation) {
+    if (tls_priority != RunPriority::LOW || g_active_high_runs.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    TraceScope trace(TraceCategory::THREAD_POOL, "PriorityYield");
+    // 按1ms的间隔检查取消
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    std::unique_lock<std::mutex> lock(g_priority_mutex);
+    while (g_active_high_runs.load(std::memory_order_acquire) > 0 &&
+           !(cancellation && cancellation->IsTriggered()) && std::chrono::steady_clock::now() < deadline) {
+        g_priority_condition.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+void ThreadPool::ParallelForRange(int64_t begin, int64_t end, int64_t grain,
+                                  RangeFunction fn, void* context) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<int64_t>(grain, 1);
+    const int64_t chunks = (end - begin + grain - 1) / grain;
+    ThreadPoolImpl* pool = IntraOpPool();
+    const int64_t threads = static_cast<int64_t>(pool->GetAvailableThreadCount());
+    const CancellationToken* cancellation = tls_cancellation.get();
+    if (chunks == 1 || threads <= 1) {
+        if (cancellation) {
+            // 单线程执行时仍按块检查取消，长循环可以中途停止
+            for (int64_t chunk_begin = begin; chunk_begin < end && !cancellation->IsTriggered();
+                 chunk_begin += grain) {
+                fn(context, chunk_begin, std::min(end, chunk_begin + grain));
+            }
+            return;
+        }
+        fn(context, begin, end);
+        return;
+    }
+    
+    // 工作线程调用时自身占用一个线程，外部线程调用时所在组（未绑定节点时为全部）的工作线程都可协助；
+    // caller_runs_first时外部调用线程同样算作一个执行者，并在提交辅助任务前先领走第一块
+    const bool caller_first = tls_caller_runs_first && !pool->IsWorkerThread();
+    const int64_t available = pool->IsWorkerThread() || caller_first ? threads - 1 : threads;
+    const int64_t helpers = std::min<int64_t>(chunks - 1, available);
+    
+    ParallelForState* state = new ParallelForState();
+    state->begin = begin;
+    state->end = end;
+    state->grain = grain;
+    state->chunks = chunks;
+    state->fn = fn;
+    state->context = context;
+    state->cancellation = cancellation;
+    state->pool = pool;
+    state->record = helpers > 0 && MetricsRegistry::Instance().IsEnabled();
+    state->participants = helpers + 1;
+    state->next.store(caller_first ? 1 : 0, std::memory_order_relaxed);
+    state->refs.store(helpers + 1, std::memory_order_relaxed);
+    state->helpers.resize(static_cast<size_t>(helpers));
+    std::vector<Task*> tasks(static_cast<size_t>(helpers));
+    for (int64_t i = 0; i < helpers; ++i) {
+        state->helpers[i].run = &ParallelForState::RunHelper;
+        state->helpers[i].state = state;
+        tasks[i] = &state->helpers[i];
+    }
+    if (helpers > 0) {
+        pool->SubmitBatch(tasks.data(), tasks.size());
+    }
+    
+    const int64_t start_ns = state->record ? MetricNowNs() : 0;
+    if (caller_first) {
+        state->RunChunk(0);
+    }
+    state->RunChunks();
+    if (state->record) {
+        state->RecordParticipant(MetricNowNs() - start_ns);
+    }
+    
+    // 先短暂自旋等待其他线程完成剩余的块，再休眠
+    for (int i = 0; i < 1024 && state->done.load(std::memory_order_acquire) != chunks; ++i) {
+        CpuRelax();
+    }
+    if (state->done.load(std::memory_order_acquire) != chunks) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [state, chunks] {
+            return state->done.load(std::memory_order_acquire) == chunks;
+        });
+    }
+    state->Release();
+}
+
+} // namespace inferunity
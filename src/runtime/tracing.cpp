@@ -0,0 +1,318 @@
+// 分层追踪实现
+// 参考ONNX Runtime的Profiler：每个线程第一次记录时登记一个环形缓冲，之后只由该线程写入；
+// 导出时按Chrome Trace Event格式输出完整事件（"ph":"X"）、计数器（"ph":"C"）与线程名称元数据
+
+#include "inferunity/tracing.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace inferunity {
+
+namespace {
+
+// 流没有自己的线程，放在这些虚拟线程号的轨道上
+constexpr uint32_t kStreamTrackBase = 1u << 20;
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CopyTruncated(char* dst, size_t max_length, const char* src) {
+    if (!src) {
+        dst[0] = '\0';
+        return;
+    }
+    size_t length = std::strlen(src);
+    length = std::min(length, max_length);
+    std::memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+void AppendJsonString(std::ostringstream& out, const char* text) {
+    out << '"';
+    for (const char* p = text; *p; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out << '\\' << *p;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << *p;
+        }
+    }
+    out << '"';
+}
+
+// Chrome trace的时间单位是微秒
+void AppendMicros(std::ostringstream& out, int64_t ns) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", static_cast<double>(ns) / 1000.0);
+    out << text;
+}
+
+std::atomic<uint32_t> g_next_thread_id{1};
+thread_local uint32_t tls_thread_id = 0;
+thread_local std::string tls_thread_name;
+
+} // anonymous namespace
+
+const char* TraceCategoryName(TraceCategory category) {
+    switch (category) {
+        case TraceCategory::SESSION: return "session";
+        case TraceCategory::OPTIMIZER: return "optimizer";
+        case TraceCategory::MEMORY: return "memory";
+        case TraceCategory::NODE: return "node";
+        case TraceCategory::THREAD_POOL: return "thread_pool";
+    }
+    return "unknown";
+}
+
+// written单调递增，第i个事件写在events[i % capacity]；写完一个事件后才发布计数
+struct Tracer::ThreadBuffer {
+    uint32_t thread_id = 0;
+    std::string thread_name;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0};
+};
+
+Tracer& Tracer::Instance() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::Start(size_t events_per_thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_.store(false, std::memory_order_relaxed);
+    buffers_.clear();
+    capacity_ = std::max<size_t>(1, events_per_thread);
+    epoch_ns_.store(SteadyNowNs(), std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracer::Stop() {
+    enabled_.store(false, std::memory_order_release);
+}
+
+int64_t Tracer::Now() const {
+    return SteadyNowNs() - epoch_ns_.load(std::memory_order_relaxed);
+}
+
+void Tracer::SetCurrentThreadName(const std::string& name) {
+    tls_thread_name = name;
+}
+
+Tracer::ThreadBuffer* Tracer::GetThreadBuffer() {
+    // 缓冲同时由登记表持有，线程退出后事件仍可导出
+    static thread_local std::shared_ptr<ThreadBuffer> tls_buffer;
+    static thread_local uint64_t tls_generation = 0;
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (tls_buffer && tls_generation == generation) {
+        return tls_buffer.get();
+    }
+    auto buffer = std::make_shared<ThreadBuffer>();
+    if (tls_thread_id == 0) {
+        tls_thread_id = g_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+    }
+    buffer->thread_id = tls_thread_id;
+    buffer->thread_name = tls_thread_name.empty() ?
+        "thread " + std::to_string(tls_thread_id) : tls_thread_name;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->events.resize(capacity_);
+        buffers_.push_back(buffer);
+    }
+    tls_buffer = buffer;
+    tls_generation = generation;
+    return buffer.get();
+}
+
+void Tracer::RecordComplete(TraceCategory category, const char* name, const char* detail,
+                            int stream, int64_t start_ns, int64_t end_ns) {
+    if (!IsEnabled()) {
+        return;
+    }
+    ThreadBuffer* buffer = GetThreadBuffer();
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[index % buffer->events.size()];
+    event.category = category;
+    event.counter = false;
+    event.stream = stream;
+    event.thread_id = buffer->thread_id;
+    event.start_ns = start_ns;
+    event.duration_ns = std::max<int64_t>(0, end_ns - start_ns);
+    event.value = 0;
+    CopyTruncated(event.name, TraceEvent::kMaxNameLength, name);
+    CopyTruncated(event.detail, TraceEvent::kMaxDetailLength, detail);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::RecordCounter(TraceCategory category, const char* name, int64_t value) {
+    if (!IsEnabled()) {
+        return;
+    }
+    ThreadBuffer* buffer = GetThreadBuffer();
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[index % buffer->events.size()];
+    event.category = category;
+    event.counter = true;
+    event.stream = -1;
+    event.thread_id = buffer->thread_id;
+    event.start_ns = Now();
+    event.duration_ns = 0;
+    event.value = value;
+    CopyTruncated(event.name, TraceEvent::kMaxNameLength, name);
+    event.detail[0] = '\0';
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> Tracer::Collect() const {
+    std::vector<TraceEvent> events;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t capacity = buffer->events.size();
+        const uint64_t first = written > capacity ? written - capacity : 0;
+        for (uint64_t i = first; i < written; ++i) {
+            events.push_back(buffer->events[i % capacity]);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.start_ns < b.start_ns;
+    });
+    return events;
+}
+
+uint64_t Tracer::GetDroppedEventCount() const {
+    uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        dropped += written > buffer->events.size() ? written - buffer->events.size() : 0;
+    }
+    return dropped;
+}
+
+std::string Tracer::ExportChromeTrace() const {
+    const std::vector<TraceEvent> events = Collect();
+    std::ostringstream out;
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    
+    // 线程与流的轨道名称
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"args\":{\"name\":";
+            AppendJsonString(out, buffer->thread_name.c_str());
+            out << "}}";
+        }
+    }
+    std::vector<int> streams;
+    for (const TraceEvent& event : events) {
+        if (event.stream >= 0 && std::find(streams.begin(), streams.end(), event.stream) == streams.end()) {
+            streams.push_back(event.stream);
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                << kStreamTrackBase + static_cast<uint32_t>(event.stream)
+                << ",\"args\":{\"name\":\"stream " << event.stream << "\"}}";
+        }
+    }
+    
+    for (const TraceEvent& event : events) {
+        separator();
+        const uint32_t tid = event.stream >= 0 ?
+            kStreamTrackBase + static_cast<uint32_t>(event.stream) : event.thread_id;
+        out << "{\"ph\":\"" << (event.counter ? "C" : "X") << "\",\"cat\":\""
+            << TraceCategoryName(event.category) << "\",\"name\":";
+        AppendJsonString(out, event.name);
+        out << ",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+        AppendMicros(out, event.start_ns);
+        if (event.counter) {
+            out << ",\"args\":{\"value\":" << event.value << "}}";
+            continue;
+        }
+        out << ",\"dur\":";
+        AppendMicros(out, event.duration_ns);
+        out << ",\"args\":{\"thread\":" << event.thread_id;
+        if (event.detail[0] != '\0') {
+            out << ",\"" << (event.category == TraceCategory::NODE ? "op_type" : "detail") << "\":";
+            AppendJsonString(out, event.detail);
+        }
+        if (event.stream >= 0) {
+            out << ",\"stream\":" << event.stream;
+        }
+        out << "}}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":"
+        << GetDroppedEventCount() << "}}\n";
+    return out.str();
+}
+
+Status Tracer::WriteChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to open trace file: " + path);
+    }
+    file << ExportChromeTrace();
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to write trace file: " + path);
+    }
+    return Status::Ok();
+}
+
+std::string MemoryTimeline::ToJson() const {
+    std::ostringstream out;
+    out << "{\"peak_bytes\":" << peak_bytes << ",\"peak_step\":" << peak_step << ",\"peak_node\":";
+    AppendJsonString(out, peak_node.c_str());
+    out << ",\n\"live_at_peak\":[";
+    for (size_t i = 0; i < live_at_peak.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "{\"tensor\":";
+        AppendJsonString(out, live_at_peak[i].tensor_name.c_str());
+        out << ",\"producer\":";
+        AppendJsonString(out, live_at_peak[i].producer.c_str());
+        out << ",\"bytes\":" << live_at_peak[i].bytes << "}";
+    }
+    out << "\n],\n\"events\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const MemoryEvent& event = events[i];
+        out << (i ? ",\n" : "\n") << "{\"step\":" << event.step << ",\"node\":";
+        AppendJsonString(out, event.node_name.c_str());
+        out << ",\"tensor\":";
+        AppendJsonString(out, event.tensor_name.c_str());
+        out << ",\"bytes\":" << event.bytes << ",\"live_bytes\":" << event.live_bytes << ",\"time_ms\":";
+        char time[32];
+        std::snprintf(time, sizeof(time), "%.3f", event.time_ms);
+        out << time << "}";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+Status MemoryTimeline::WriteJson(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to open memory timeline file: " + path);
+    }
+    file << ToJson();
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to write memory timeline file: " + path);
+    }
+    return Status::Ok();
+}
+
+} // namespace inferunity
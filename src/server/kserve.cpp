@@ -0,0 +1,685 @@
+// KServe v2推理协议的编解码实现
+// JSON按游标逐个读取：请求对象的键顺序任意，data数组先记下位置，形状与类型都读到后再直接解析进张量
+
+#include "server/kserve.h"
+#include "inferunity/float16.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace inferunity {
+namespace server {
+
+namespace {
+
+constexpr int kMaxJsonDepth = 64;
+
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    void SkipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+            ++p_;
+        }
+    }
+    bool Peek(char c) {
+        SkipSpace();
+        return p_ < end_ && *p_ == c;
+    }
+    bool Consume(char c) {
+        if (!Peek(c)) {
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+    bool AtEnd() {
+        SkipSpace();
+        return p_ == end_;
+    }
+    const char* Position() const { return p_; }
+
+    bool ReadString(std::string* out) {
+        if (!Consume('"')) {
+            return false;
+        }
+        out->clear();
+        while (p_ < end_ && *p_ != '"') {
+            if (*p_ != '\\') {
+                out->push_back(*p_++);
+                continue;
+            }
+            if (++p_ == end_) {
+                return false;
+            }
+            const char escape = *p_++;
+            switch (escape) {
+                case '"': case '\\': case '/': out->push_back(escape); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'n': out->push_back('\n'); break;
+                case 'r': out->push_back('\r'); break;
+                case 't': out->push_back('\t'); break;
+                case 'u': {
+                    // 只处理基本多文种平面，代理对按两个码位各自编码
+                    uint32_t code = 0;
+                    if (end_ - p_ < 4 || std::from_chars(p_, p_ + 4, code, 16).ptr != p_ + 4) {
+                        return false;
+                    }
+                    p_ += 4;
+                    if (code < 0x80) {
+                        out->push_back(static_cast<char>(code));
+                    } else if (code < 0x800) {
+                        out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    } else {
+                        out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    break;
+                }
+                default: return false;
+            }
+        }
+        if (p_ == end_) {
+            return false;
+        }
+        ++p_;
+        return true;
+    }
+
+    bool ReadInt64(int64_t* value) {
+        SkipSpace();
+        const auto result = std::from_chars(p_, end_, *value);
+        if (result.ec != std::errc() || (result.ptr < end_ && (*result.ptr == '.' || *result.ptr == 'e' ||
+                                                               *result.ptr == 'E'))) {
+            return false;
+        }
+        p_ = result.ptr;
+        return true;
+    }
+
+    bool ReadBool(bool* value) {
+        SkipSpace();
+        if (end_ - p_ >= 4 && std::memcmp(p_, "true", 4) == 0) {
+            p_ += 4;
+            *value = true;
+            return true;
+        }
+        if (end_ - p_ >= 5 && std::memcmp(p_, "false", 5) == 0) {
+            p_ += 5;
+            *value = false;
+            return true;
+        }
+        return false;
+    }
+
+    // 跳过任意一个值（嵌套深度有上限，防止恶意请求耗尽栈）
+    bool SkipValue(int depth = 0) {
+        SkipSpace();
+        if (p_ == end_ || depth > kMaxJsonDepth) {
+            return false;
+        }
+        if (*p_ == '"') {
+            std::string ignored;
+            return ReadString(&ignored);
+        }
+        if (*p_ == '{' || *p_ == '[') {
+            const char close = *p_ == '{' ? '}' : ']';
+            const bool object = *p_ == '{';
+            ++p_;
+            if (Consume(close)) {
+                return true;
+            }
+            do {
+                if (object) {
+                    std::string key;
+                    if (!ReadString(&key) || !Consume(':')) {
+                        return false;
+                    }
+                }
+                if (!SkipValue(depth + 1)) {
+                    return false;
+                }
+            } while (Consume(','));
+            return Consume(close);
+        }
+        // 数字、true、false、null
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && *p_ != ' ' && *p_ != '\n' &&
+               *p_ != '\r' && *p_ != '\t') {
+            ++p_;
+        }
+        return p_ > start;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+// 依次把对象的每个键交给member，由它读取或跳过对应的值
+template <typename F>
+bool ForEachMember(JsonCursor& cursor, F member) {
+    if (!cursor.Consume('{')) {
+        return false;
+    }
+    if (cursor.Consume('}')) {
+        return true;
+    }
+    do {
+        std::string key;
+        if (!cursor.ReadString(&key) || !cursor.Consume(':') || !member(key)) {
+            return false;
+        }
+    } while (cursor.Consume(','));
+    return cursor.Consume('}');
+}
+
+template <typename F>
+bool ForEachElement(JsonCursor& cursor, F element) {
+    if (!cursor.Consume('[')) {
+        return false;
+    }
+    if (cursor.Consume(']')) {
+        return true;
+    }
+    do {
+        if (!element()) {
+            return false;
+        }
+    } while (cursor.Consume(','));
+    return cursor.Consume(']');
+}
+
+bool IsFloatType(DataType dtype) {
+    return dtype == DataType::FLOAT32 || dtype == DataType::FLOAT16 || dtype == DataType::BFLOAT16;
+}
+
+// 把一个数写成dtype的元素；整数类型要求值是整数
+template <typename T>
+void Store(uint8_t* dst, T value) {
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+// data数组（可按形状嵌套，按行主序展平）直接解析进count个元素
+bool ParseData(const char* begin, const char* end, DataType dtype, uint8_t* dst, size_t count) {
+    const size_t element_size = GetDataTypeSize(dtype);
+    size_t parsed = 0;
+    const char* p = begin;
+    while (p < end) {
+        const char c = *p;
+        if (c == '[' || c == ']' || c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            ++p;
+            continue;
+        }
+        if (parsed == count) {
+            return false;
+        }
+        uint8_t* out = dst + parsed * element_size;
+        if (dtype == DataType::BOOL && (c == 't' || c == 'f')) {
+            JsonCursor cursor(p, end);
+            bool value = false;
+            if (!cursor.ReadBool(&value)) {
+                return false;
+            }
+            *out = value ? 1 : 0;
+            p = cursor.Position();
+        } else if (IsFloatType(dtype)) {
+            double value = 0.0;
+            const auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc()) {
+                return false;
+            }
+            p = result.ptr;
+            const float f = static_cast<float>(value);
+            switch (dtype) {
+                case DataType::FLOAT32: Store(out, f); break;
+                case DataType::FLOAT16: Store(out, FloatToHalf(f)); break;
+                default: Store(out, FloatToBFloat16(f)); break;
+            }
+        } else if (dtype == DataType::UINT64) {
+            uint64_t value = 0;
+            const auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc()) {
+                return false;
+            }
+            p = result.ptr;
+            Store(out, value);
+        } else {
+            int64_t value = 0;
+            const auto result = std::from_chars(p, end, value);
+            if (result.ec != std::errc()) {
+                return false;
+            }
+            p = result.ptr;
+            switch (dtype) {
+                case DataType::INT8: Store(out, static_cast<int8_t>(value)); break;
+                case DataType::INT16: Store(out, static_cast<int16_t>(value)); break;
+                case DataType::INT32: Store(out, static_cast<int32_t>(value)); break;
+                case DataType::INT64: Store(out, value); break;
+                case DataType::UINT8: Store(out, static_cast<uint8_t>(value)); break;
+                case DataType::UINT16: Store(out, static_cast<uint16_t>(value)); break;
+                case DataType::UINT32: Store(out, static_cast<uint32_t>(value)); break;
+                case DataType::BOOL: Store(out, static_cast<uint8_t>(value != 0)); break;
+                default: return false;
+            }
+        }
+        ++parsed;
+        // 数与数之间必须有分隔符
+        if (p < end && *p != ',' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+            return false;
+        }
+    }
+    return parsed == count;
+}
+
+void AppendNumber(std::string* out, double value) {
+    if (std::isnan(value)) {
+        out->append("NaN");
+        return;
+    }
+    if (std::isinf(value)) {
+        out->append(value > 0 ? "Infinity" : "-Infinity");
+        return;
+    }
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<float>(value));
+    out->append(buffer, result.ptr);
+}
+
+template <typename T>
+void AppendInteger(std::string* out, T value) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out->append(buffer, result.ptr);
+}
+
+template <typename T>
+T Load(const uint8_t* src) {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return value;
+}
+
+void AppendData(std::string* out, const Tensor& tensor) {
+    const DataType dtype = tensor.GetDataType();
+    const size_t element_size = GetDataTypeSize(dtype);
+    const uint8_t* data = static_cast<const uint8_t*>(tensor.GetData());
+    const size_t count = tensor.GetElementCount();
+    out->push_back('[');
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out->push_back(',');
+        }
+        const uint8_t* src = data + i * element_size;
+        switch (dtype) {
+            case DataType::FLOAT32: AppendNumber(out, Load<float>(src)); break;
+            case DataType::FLOAT16: AppendNumber(out, HalfToFloat(Load<uint16_t>(src))); break;
+            case DataType::BFLOAT16: AppendNumber(out, BFloat16ToFloat(Load<uint16_t>(src))); break;
+            case DataType::INT8: AppendInteger(out, Load<int8_t>(src)); break;
+            case DataType::INT16: AppendInteger(out, Load<int16_t>(src)); break;
+            case DataType::INT32: AppendInteger(out, Load<int32_t>(src)); break;
+            case DataType::INT64: AppendInteger(out, Load<int64_t>(src)); break;
+            case DataType::UINT8: AppendInteger(out, Load<uint8_t>(src)); break;
+            case DataType::UINT16: AppendInteger(out, Load<uint16_t>(src)); break;
+            case DataType::UINT32: AppendInteger(out, Load<uint32_t>(src)); break;
+            case DataType::UINT64: AppendInteger(out, Load<uint64_t>(src)); break;
+            case DataType::BOOL: out->append(*src ? "true" : "false"); break;
+            default: break;
+        }
+    }
+    out->push_back(']');
+}
+
+Status InvalidRequest(const std::string& message) {
+    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, message);
+}
+
+} // anonymous namespace
+
+DataType ParseKServeDatatype(const std::string& name) {
+    static const std::unordered_map<std::string, DataType> kTypes = {
+        {"BOOL", DataType::BOOL}, {"UINT8", DataType::UINT8}, {"UINT16", DataType::UINT16},
+        {"UINT32", DataType::UINT32}, {"UINT64", DataType::UINT64}, {"INT8", DataType::INT8},
+        {"INT16", DataType::INT16}, {"INT32", DataType::INT32}, {"INT64", DataType::INT64},
+        {"FP16", DataType::FLOAT16}, {"BF16", DataType::BFLOAT16}, {"FP32", DataType::FLOAT32},
+    };
+    auto it = kTypes.find(name);
+    return it != kTypes.end() ? it->second : DataType::UNKNOWN;
+}
+
+const char* KServeDatatypeName(DataType dtype) {
+    switch (dtype) {
+        case DataType::BOOL: return "BOOL";
+        case DataType::UINT8: return "UINT8";
+        case DataType::UINT16: return "UINT16";
+        case DataType::UINT32: return "UINT32";
+        case DataType::UINT64: return "UINT64";
+        case DataType::INT8: return "INT8";
+        case DataType::INT16: return "INT16";
+        case DataType::INT32: return "INT32";
+        case DataType::INT64: return "INT64";
+        case DataType::FLOAT16: return "FP16";
+        case DataType::BFLOAT16: return "BF16";
+        case DataType::FLOAT32: return "FP32";
+        default: return nullptr;
+    }
+}
+
+Status DecodeInferRequest(const uint8_t* body, size_t size, size_t json_size, std::shared_ptr<const void> owner,
+                          const std::vector<std::string>& input_names, DecodedInferRequest* request) {
+    if (json_size > size) {
+        return InvalidRequest("Inference header length exceeds the request body");
+    }
+    *request = DecodedInferRequest();
+    request->inputs.resize(input_names.size());
+    std::unordered_map<std::string, size_t> input_index;
+    for (size_t i = 0; i < input_names.size(); ++i) {
+        input_index[input_names[i]] = i;
+    }
+
+    const char* json = reinterpret_cast<const char*>(body);
+    JsonCursor cursor(json, json + json_size);
+    size_t binary_offset = json_size;
+    std::string error;
+
+    auto parse_input = [&]() -> bool {
+        std::string name;
+        std::string datatype;
+        std::vector<int64_t> dims;
+        bool has_shape = false;
+        const char* data_begin = nullptr;
+        const char* data_end = nullptr;
+        int64_t binary_size = -1;
+        const bool ok = ForEachMember(cursor, [&](const std::string& key) {
+            if (key == "name") {
+                return cursor.ReadString(&name);
+            }
+            if (key == "datatype") {
+                return cursor.ReadString(&datatype);
+            }
+            if (key == "shape") {
+                has_shape = true;
+                return ForEachElement(cursor, [&]() {
+                    int64_t dim = 0;
+                    if (!cursor.ReadInt64(&dim)) {
+                        return false;
+                    }
+                    dims.push_back(dim);
+                    return true;
+                });
+            }
+            if (key == "data") {
+                cursor.SkipSpace();
+                data_begin = cursor.Position();
+                const bool skipped = cursor.SkipValue();
+                data_end = cursor.Position();
+                return skipped;
+            }
+            if (key == "parameters") {
+                return ForEachMember(cursor, [&](const std::string& parameter) {
+                    if (parameter == "binary_data_size") {
+                        return cursor.ReadInt64(&binary_size);
+                    }
+                    return cursor.SkipValue();
+                });
+            }
+            return cursor.SkipValue();
+        });
+        if (!ok) {
+            error = "Malformed input object";
+            return false;
+        }
+        auto it = input_index.find(name);
+        if (it == input_index.end()) {
+            error = "Unknown input: " + name;
+            return false;
+        }
+        if (request->inputs[it->second]) {
+            error = "Duplicate input: " + name;
+            return false;
+        }
+        const DataType dtype = ParseKServeDatatype(datatype);
+        if (dtype == DataType::UNKNOWN) {
+            error = "Unsupported datatype for input " + name + ": " + datatype;
+            return false;
+        }
+        if (!has_shape) {
+            error = "Input " + name + " has no shape";
+            return false;
+        }
+        size_t count = 1;
+        for (int64_t dim : dims) {
+            if (dim <= 0 || count > std::numeric_limits<size_t>::max() / 16 / static_cast<size_t>(dim)) {
+                error = "Invalid shape for input " + name;
+                return false;
+            }
+            count *= static_cast<size_t>(dim);
+        }
+        const size_t bytes = count * GetDataTypeSize(dtype);
+        const Shape shape(dims);
+
+        if (binary_size >= 0) {
+            if (data_begin) {
+                error = "Input " + name + " has both data and binary_data_size";
+                return false;
+            }
+            if (static_cast<uint64_t>(binary_size) != bytes || bytes > size - binary_offset) {
+                error = "Binary data size does not match the shape of input " + name;
+                return false;
+            }
+            uint8_t* data = const_cast<uint8_t*>(body) + binary_offset;
+            binary_offset += bytes;
+            if (reinterpret_cast<uintptr_t>(data) % GetDataTypeSize(dtype) == 0) {
+                // 接收缓冲内的视图：删除器持有缓冲，运行结束、张量释放后缓冲才归还
+                request->inputs[it->second].reset(new Tensor(shape, dtype, data, MemoryLayout::NCHW, DeviceType::CPU),
+                                                  [owner](Tensor* view) { delete view; });
+                request->zero_copy_bytes += bytes;
+            } else {
+                auto tensor = CreateTensor(shape, dtype);
+                std::memcpy(tensor->GetData(), data, bytes);
+                request->inputs[it->second] = std::move(tensor);
+                request->copied_bytes += bytes;
+            }
+            return true;
+        }
+        if (!data_begin) {
+            error = "Input " + name + " has no data";
+            return false;
+        }
+        auto tensor = CreateTensor(shape, dtype);
+        if (!ParseData(data_begin, data_end, dtype, static_cast<uint8_t*>(tensor->GetData()), count)) {
+            error = "Data of input " + name + " does not match its shape and datatype";
+            return false;
+        }
+        request->inputs[it->second] = std::move(tensor);
+        return true;
+    };
+
+    auto parse_output = [&]() -> bool {
+        RequestedOutput output;
+        bool has_binary = false;
+        const bool ok = ForEachMember(cursor, [&](const std::string& key) {
+            if (key == "name") {
+                return cursor.ReadString(&output.name);
+            }
+            if (key == "parameters") {
+                return ForEachMember(cursor, [&](const std::string& parameter) {
+                    if (parameter == "binary_data") {
+                        has_binary = true;
+                        return cursor.ReadBool(&output.binary);
+                    }
+                    return cursor.SkipValue();
+                });
+            }
+            return cursor.SkipValue();
+        });
+        if (!ok) {
+            error = "Malformed output object";
+            return false;
+        }
+        // 未单独指定时沿用请求级的binary_data_output，等整个请求读完后再补上
+        output.binary = has_binary ? output.binary : false;
+        request->outputs.push_back(std::move(output));
+        return true;
+    };
+    std::vector<bool> output_binary_given;
+
+    const bool ok = ForEachMember(cursor, [&](const std::string& key) {
+        if (key == "id") {
+            return cursor.ReadString(&request->id);
+        }
+        if (key == "inputs") {
+            return ForEachElement(cursor, parse_input);
+        }
+        if (key == "outputs") {
+            return ForEachElement(cursor, [&]() {
+                const size_t before = request->outputs.size();
+                if (!parse_output()) {
+                    return false;
+                }
+                output_binary_given.push_back(request->outputs[before].binary);
+                return true;
+            });
+        }
+        if (key == "parameters") {
+            return ForEachMember(cursor, [&](const std::string& parameter) {
+                if (parameter == "binary_data_output") {
+                    return cursor.ReadBool(&request->binary_data_output);
+                }
+                if (parameter == "timeout") {
+                    return cursor.ReadInt64(&request->timeout_us);
+                }
+                return cursor.SkipValue();
+            });
+        }
+        return cursor.SkipValue();
+    });
+    if (!ok || !cursor.AtEnd()) {
+        return InvalidRequest(error.empty() ? "Malformed inference request" : error);
+    }
+    for (size_t i = 0; i < request->outputs.size(); ++i) {
+        if (!output_binary_given[i]) {
+            request->outputs[i].binary = request->binary_data_output;
+        }
+    }
+    for (size_t i = 0; i < input_names.size(); ++i) {
+        if (!request->inputs[i]) {
+            return InvalidRequest("Missing input: " + input_names[i]);
+        }
+    }
+    if (binary_offset != size) {
+        return InvalidRequest("Request body has unused binary data");
+    }
+    return Status::Ok();
+}
+
+Status EncodeInferResponse(const std::string& model_name, const std::string& model_version,
+                           const DecodedInferRequest& request, const std::vector<std::string>& output_names,
+                           const std::vector<std::shared_ptr<Tensor>>& outputs, EncodedInferResponse* response) {
+    std::vector<RequestedOutput> selected = request.outputs;
+    if (selected.empty()) {
+        for (const std::string& name : output_names) {
+            selected.push_back({name, request.binary_data_output});
+        }
+    }
+
+    std::string& json = response->json;
+    json.clear();
+    response->binary.clear();
+    response->binary_size = 0;
+    json.append("{\"model_name\":");
+    AppendJsonString(&json, model_name);
+    json.append(",\"model_version\":");
+    AppendJsonString(&json, model_version);
+    if (!request.id.empty()) {
+        json.append(",\"id\":");
+        AppendJsonString(&json, request.id);
+    }
+    json.append(",\"outputs\":[");
+    for (size_t s = 0; s < selected.size(); ++s) {
+        size_t index = output_names.size();
+        for (size_t i = 0; i < output_names.size(); ++i) {
+            if (output_names[i] == selected[s].name) {
+                index = i;
+                break;
+            }
+        }
+        if (index == output_names.size() || index >= outputs.size() || !outputs[index]) {
+            return Status::Error(StatusCode::ERROR_NOT_FOUND, "Unknown output: " + selected[s].name);
+        }
+        const std::shared_ptr<Tensor>& tensor = outputs[index];
+        const char* datatype = KServeDatatypeName(tensor->GetDataType());
+        if (!datatype || tensor->GetDeviceType() != DeviceType::CPU || !tensor->IsContiguous()) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED,
+                                 "Output " + selected[s].name + " cannot be encoded");
+        }
+        if (s > 0) {
+            json.push_back(',');
+        }
+        json.append("{\"name\":");
+        AppendJsonString(&json, selected[s].name);
+        json.append(",\"datatype\":\"");
+        json.append(datatype);
+        json.append("\",\"shape\":[");
+        const auto& dims = tensor->GetShape().dims;
+        for (size_t d = 0; d < dims.size(); ++d) {
+            if (d > 0) {
+                json.push_back(',');
+            }
+            AppendInteger(&json, dims[d]);
+        }
+        json.push_back(']');
+        if (selected[s].binary) {
+            const size_t bytes = tensor->GetSizeInBytes();
+            json.append(",\"parameters\":{\"binary_data_size\":");
+            AppendInteger(&json, bytes);
+            json.push_back('}');
+            response->binary.push_back(tensor);
+            response->binary_size += bytes;
+        } else {
+            json.append(",\"data\":");
+            AppendData(&json, *tensor);
+        }
+        json.push_back('}');
+    }
+    json.append("]}");
+    return Status::Ok();
+}
+
+std::string EncodeError(const std::string& message) {
+    std::string json = "{\"error\":";
+    AppendJsonString(&json, message);
+    json.push_back('}');
+    return json;
+}
+
+void AppendJsonString(std::string* out, const std::string& value) {
+    out->push_back('"');
+    for (const char c : value) {
+        switch (c) {
+            case '"': out->append("\\\""); break;
+            case '\\': out->append("\\\\"); break;
+            case '\n': out->append("\\n"); break;
+            case '\r': out->append("\\r"); break;
+            case '\t': out->append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out->append(escaped);
+                } else {
+                    out->push_back(c);
+                }
+        }
+    }
+    out->push_back('"');
+}
+
+} // namespace server
+} // namespace inferunity
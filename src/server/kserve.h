@@ -0,0 +1,62 @@
+// KServe v2推理协议的编解码（参考Triton的HTTP前端与其二进制张量扩展）
+// 请求体是JSON，带二进制扩展时JSON之后紧跟各输入的原始字节（Inference-Header-Content-Length给出JSON长度，
+// 输入的parameters.binary_data_size给出各自的字节数，按JSON中的输入顺序排列）。
+// 解码不建立JSON的DOM：二进制输入直接成为接收缓冲内的张量视图，JSON的data数组直接解析进目标张量
+
+#pragma once
+
+#include "inferunity/tensor.h"
+#include "inferunity/types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace server {
+
+// KServe的数据类型名（"FP32"、"INT64"等）与DataType互转；BYTES与不认识的名称返回UNKNOWN
+DataType ParseKServeDatatype(const std::string& name);
+const char* KServeDatatypeName(DataType dtype);
+
+struct RequestedOutput {
+    std::string name;
+    bool binary = false;  // 以二进制扩展返回（parameters.binary_data）
+};
+
+struct DecodedInferRequest {
+    std::string id;
+    std::vector<std::shared_ptr<Tensor>> inputs;  // 按input_names的顺序
+    std::vector<RequestedOutput> outputs;         // 为空表示按图输出顺序返回全部输出
+    bool binary_data_output = false;              // 未单独指定的输出也以二进制返回
+    int64_t timeout_us = -1;                      // parameters.timeout（微秒），-1表示未给出
+    size_t zero_copy_bytes = 0;                   // 作为接收缓冲视图的二进制输入字节数
+    size_t copied_bytes = 0;                      // 地址未按元素对齐而拷贝的二进制输入字节数
+};
+
+// body的前json_size字节是JSON（json_size == size表示没有二进制部分），之后是二进制输入。
+// 二进制输入的张量持有owner（接收缓冲），请求处理期间缓冲不会释放。
+// input_names为模型的图输入，请求须按名称给出每一个输入
+Status DecodeInferRequest(const uint8_t* body, size_t size, size_t json_size, std::shared_ptr<const void> owner,
+                          const std::vector<std::string>& input_names, DecodedInferRequest* request);
+
+// 编码后的响应：JSON之后按顺序接binary中张量的原始字节（发送时直接引用张量数据，不拷贝）
+struct EncodedInferResponse {
+    std::string json;
+    std::vector<std::shared_ptr<Tensor>> binary;
+    size_t binary_size = 0;
+};
+
+// outputs按output_names（图输出）顺序；只编码请求的输出
+Status EncodeInferResponse(const std::string& model_name, const std::string& model_version,
+                           const DecodedInferRequest& request, const std::vector<std::string>& output_names,
+                           const std::vector<std::shared_ptr<Tensor>>& outputs, EncodedInferResponse* response);
+
+// {"error": message}
+std::string EncodeError(const std::string& message);
+// 把字符串写成带引号的JSON字符串
+void AppendJsonString(std::string* out, const std::string& value);
+
+} // namespace server
+} // namespace inferunity
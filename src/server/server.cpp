@@ -0,0 +1,1041 @@
+// 推理服务前端实现
+// 每个事件循环线程独占自己的连接，连接状态只在该线程上访问；推理的回调在工作线程上编码响应，
+// 经加锁的完成队列与eventfd交回事件循环。一个连接同一时刻只处理一个请求，流水线上的后续请求留在输入缓冲中，
+// 等当前响应发完再解析。请求体按Content-Length一次分配，recv直接写入其中
+
+#include "inferunity/server.h"
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/memory.h"
+#include "inferunity/metrics.h"
+#include "inferunity/operator.h"
+#include "server/kserve.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef INFERUNITY_VERSION
+#define INFERUNITY_VERSION "unknown"
+#endif
+
+namespace inferunity {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64_t kListenerTag = 0;
+constexpr uint64_t kWakeupTag = 1;
+constexpr size_t kBodyAlignment = 64;
+constexpr size_t kMaxIovecs = 256;
+
+const char* ReasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "Unknown";
+    }
+}
+
+int HttpStatusFor(const Status& status) {
+    switch (status.Code()) {
+        case StatusCode::SUCCESS: return 200;
+        case StatusCode::ERROR_INVALID_ARGUMENT:
+        case StatusCode::ERROR_INVALID_MODEL: return 400;
+        case StatusCode::ERROR_NOT_FOUND: return 404;
+        case StatusCode::ERROR_OVERLOADED:
+        case StatusCode::ERROR_RESOURCE_EXHAUSTED:
+        case StatusCode::ERROR_CANCELLED: return 503;
+        case StatusCode::ERROR_TIMEOUT: return 504;
+        default: return 500;
+    }
+}
+
+bool EqualsIgnoreCase(const std::string& a, const char* b) {
+    const size_t length = std::strlen(b);
+    if (a.size() != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+bool ParseSize(const std::string& value, size_t* out) {
+    if (value.empty() || value.size() > 19) {
+        return false;
+    }
+    size_t result = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + static_cast<size_t>(c - '0');
+    }
+    *out = result;
+    return true;
+}
+
+std::vector<std::string> SplitPath(const std::string& path) {
+    std::vector<std::string> segments;
+    size_t begin = 0;
+    while (begin < path.size()) {
+        size_t end = path.find('/', begin);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (end > begin) {
+            segments.push_back(path.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return segments;
+}
+
+void AppendTensorMetadata(std::string* json, const Value* value, const std::string& name) {
+    const char* datatype = server::KServeDatatypeName(value->GetDataType());
+    json->append("{\"name\":");
+    server::AppendJsonString(json, name);
+    json->append(",\"datatype\":\"");
+    json->append(datatype ? datatype : "BYTES");
+    json->append("\",\"shape\":[");
+    const Shape& shape = value->GetShape();
+    for (size_t d = 0; d < shape.dims.size(); ++d) {
+        if (d > 0) {
+            json->push_back(',');
+        }
+        const bool dynamic = (d < shape.is_dynamic.size() && shape.is_dynamic[d]) || shape.dims[d] <= 0;
+        json->append(dynamic ? "-1" : std::to_string(shape.dims[d]));
+    }
+    json->append("]}");
+}
+
+Status SocketError(const std::string& what) {
+    return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, what + ": " + std::strerror(errno));
+}
+
+} // anonymous namespace
+
+struct InferenceServer::Model {
+    std::string name;
+    ServedModelOptions options;
+    InferenceSession* session = nullptr;
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    std::string metadata;  // GET /v2/models/{name}的响应体
+    std::unique_ptr<DynamicBatcher> batcher;
+    std::shared_ptr<Counter> success_metric;
+    std::shared_ptr<Counter> failure_metric;
+    std::shared_ptr<ShardedHistogram> latency_metric;
+};
+
+namespace {
+
+// 待发送的响应：头部、JSON（或文本）之后接二进制输出张量的数据，发送时直接引用这些缓冲
+struct Response {
+    std::string head;
+    std::string body;
+    std::vector<std::shared_ptr<Tensor>> tensors;
+    bool close = false;
+};
+
+std::unique_ptr<Response> MakeResponse(int code, const char* content_type, std::string body, bool close,
+                                       const std::string& extra_headers = "", size_t binary_size = 0) {
+    auto response = std::make_unique<Response>();
+    response->close = close;
+    response->body = std::move(body);
+    std::string& head = response->head;
+    head.append("HTTP/1.1 ").append(std::to_string(code)).append(" ").append(ReasonPhrase(code)).append("\r\n");
+    if (content_type) {
+        head.append("Content-Type: ").append(content_type).append("\r\n");
+    }
+    head.append("Content-Length: ").append(std::to_string(response->body.size() + binary_size)).append("\r\n");
+    head.append(extra_headers);
+    if (close) {
+        head.append("Connection: close\r\n");
+    }
+    head.append("\r\n");
+    return response;
+}
+
+std::unique_ptr<Response> MakeError(int code, const std::string& message, bool close) {
+    return MakeResponse(code, "application/json", server::EncodeError(message), close);
+}
+
+struct Connection {
+    int fd = -1;
+    uint64_t id = 0;
+    uint32_t events = 0;
+    std::string input;  // 尚未解析的字节：请求头，及流水线上的后续请求
+
+    // 当前请求
+    bool has_request = false;
+    std::string method;
+    std::string path;
+    bool keep_alive = true;
+    size_t content_length = 0;
+    size_t json_size = 0;
+    std::shared_ptr<uint8_t> body_owner;
+    uint8_t* body = nullptr;
+    size_t body_received = 0;
+
+    bool in_flight = false;
+    std::shared_ptr<CancellationToken> cancellation;
+    bool peer_closed = false;  // 对端已半关闭，发完当前响应后关闭
+
+    // 正在发送的响应
+    std::unique_ptr<Response> response;
+    std::vector<iovec> iov;
+    size_t iov_index = 0;
+
+    void ResetRequest() {
+        has_request = false;
+        method.clear();
+        path.clear();
+        keep_alive = true;
+        content_length = 0;
+        json_size = 0;
+        body_owner.reset();
+        body = nullptr;
+        body_received = 0;
+        cancellation.reset();
+    }
+};
+
+} // anonymous namespace
+
+class InferenceServer::EventLoop {
+public:
+    EventLoop(InferenceServer* server, int listen_fd) : server_(server), listen_fd_(listen_fd) {}
+
+    ~EventLoop() {
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+        }
+        if (wakeup_fd_ >= 0) {
+            ::close(wakeup_fd_);
+        }
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+        }
+    }
+
+    Status Init() {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            return SocketError("epoll_create1");
+        }
+        wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_fd_ < 0) {
+            return SocketError("eventfd");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kWakeupTag;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) != 0) {
+            return SocketError("epoll_ctl");
+        }
+        event.data.u64 = kListenerTag;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) != 0) {
+            return SocketError("epoll_ctl");
+        }
+        return Status::Ok();
+    }
+
+    void Start() { thread_ = std::thread(&EventLoop::Run, this); }
+
+    void RequestStop() {
+        stop_.store(true, std::memory_order_release);
+        Wakeup();
+    }
+
+    void Join() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // 等待所有已提交的推理回调返回
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    void AddStats(ServerStats* stats) const {
+        stats->connections += connections_.load(std::memory_order_relaxed);
+        stats->requests += requests_.load(std::memory_order_relaxed);
+        stats->infer_requests += infer_requests_.load(std::memory_order_relaxed);
+        stats->infer_failures += infer_failures_.load(std::memory_order_relaxed);
+        stats->zero_copy_bytes += zero_copy_bytes_.load(std::memory_order_relaxed);
+        stats->copied_bytes += copied_bytes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Wakeup() {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(wakeup_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    // 工作线程交回推理的响应；持锁完成全部访问，WaitIdle返回后不再触碰本对象
+    void Post(uint64_t connection_id, std::unique_ptr<Response> response) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions_.emplace_back(connection_id, std::move(response));
+        Wakeup();
+        --pending_;
+        idle_cv_.notify_all();
+    }
+
+    void Run() {
+        epoll_event events[128];
+        while (!stop_.load(std::memory_order_acquire)) {
+            const int count = ::epoll_wait(epoll_fd_, events, 128, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                const uint64_t tag = events[i].data.u64;
+                if (tag == kListenerTag) {
+                    Accept();
+                } else if (tag == kWakeupTag) {
+                    uint64_t value = 0;
+                    ssize_t ignored = ::read(wakeup_fd_, &value, sizeof(value));
+                    (void)ignored;
+                    DrainCompletions();
+                } else {
+                    auto it = connections_by_id_.find(tag);
+                    if (it != connections_by_id_.end()) {
+                        HandleEvent(*it->second, events[i].events);
+                    }
+                }
+            }
+        }
+        // 停止：取消在途推理，关闭全部连接与监听套接字；之后到达的完成直接丢弃
+        for (auto& entry : connections_by_id_) {
+            if (entry.second->cancellation) {
+                entry.second->cancellation->Cancel();
+            }
+            ::close(entry.second->fd);
+        }
+        connections_by_id_.clear();
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    void Accept() {
+        for (;;) {
+            const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            const int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            connection->id = next_id_++;
+            connection->events = EPOLLIN | EPOLLRDHUP;
+            epoll_event event{};
+            event.events = connection->events;
+            event.data.u64 = connection->id;
+            if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            connections_.fetch_add(1, std::memory_order_relaxed);
+            connections_by_id_[connection->id] = std::move(connection);
+        }
+    }
+
+    // 关闭连接；在途的推理被取消，其响应到达时丢弃
+    void Close(Connection& connection) {
+        if (connection.cancellation) {
+            connection.cancellation->Cancel();
+        }
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        connections_by_id_.erase(connection.id);
+    }
+
+    void UpdateEvents(Connection& connection) {
+        uint32_t events = connection.peer_closed ? 0u : static_cast<uint32_t>(EPOLLRDHUP);
+        if (connection.response) {
+            events |= EPOLLOUT;
+        } else if (!connection.in_flight) {
+            events |= EPOLLIN;
+        }
+        if (events == connection.events) {
+            return;
+        }
+        connection.events = events;
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = connection.id;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    // 以下返回false表示连接已关闭，之后不能再访问connection
+    void HandleEvent(Connection& connection, uint32_t events) {
+        if ((events & (EPOLLERR | EPOLLHUP)) || ((events & EPOLLRDHUP) && connection.in_flight)) {
+            // 客户端断开：取消还在执行的推理
+            Close(connection);
+            return;
+        }
+        if (events & EPOLLRDHUP) {
+            if (!(events & EPOLLIN) && !connection.response) {
+                Close(connection);
+                return;
+            }
+            connection.peer_closed = true;
+            connection.keep_alive = false;
+        }
+        if ((events & EPOLLIN) && !OnReadable(connection)) {
+            return;
+        }
+        if ((events & EPOLLOUT) && connection.response) {
+            if (!WriteResponse(connection)) {
+                return;
+            }
+            if (!connection.response && !Process(connection)) {
+                return;
+            }
+        }
+        UpdateEvents(connection);
+    }
+
+    bool OnReadable(Connection& connection) {
+        while (!connection.in_flight && !connection.response) {
+            ssize_t received;
+            const bool direct = connection.has_request && connection.body_received < connection.content_length;
+            if (direct) {
+                // 请求体直接收进张量将引用的缓冲
+                received = ::recv(connection.fd, connection.body + connection.body_received,
+                                  connection.content_length - connection.body_received, 0);
+            } else {
+                char buffer[16384];
+                received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+                if (received > 0) {
+                    connection.input.append(buffer, static_cast<size_t>(received));
+                }
+            }
+            if (received == 0) {
+                Close(connection);
+                return false;
+            }
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                Close(connection);
+                return false;
+            }
+            if (direct) {
+                connection.body_received += static_cast<size_t>(received);
+            }
+            if (!Process(connection)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 解析并处理缓冲中已完整的请求，直到需要更多数据或有请求在途/响应待发
+    bool Process(Connection& connection) {
+        while (!connection.in_flight && !connection.response) {
+            if (!connection.has_request && !ParseHeader(connection)) {
+                break;
+            }
+            if (!connection.response) {
+                if (connection.body_received < connection.content_length) {
+                    break;
+                }
+                requests_.fetch_add(1, std::memory_order_relaxed);
+                Dispatch(connection);
+            }
+            if (connection.response && !WriteResponse(connection)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 请求头完整时返回true（出错时已设置错误响应）
+    bool ParseHeader(Connection& connection) {
+        const size_t end = connection.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            if (connection.input.size() > server_->options_.max_header_bytes) {
+                SetResponse(connection, MakeError(431, "Request header too large", true));
+                return true;
+            }
+            return false;
+        }
+        if (end > server_->options_.max_header_bytes) {
+            SetResponse(connection, MakeError(431, "Request header too large", true));
+            return true;
+        }
+        connection.has_request = true;
+        const std::string header = connection.input.substr(0, end);
+        connection.input.erase(0, end + 4);
+
+        size_t line_end = header.find("\r\n");
+        const std::string request_line = header.substr(0, line_end);
+        const size_t first_space = request_line.find(' ');
+        const size_t second_space = request_line.find(' ', first_space + 1);
+        if (first_space == std::string::npos || second_space == std::string::npos) {
+            SetResponse(connection, MakeError(400, "Malformed request line", true));
+            return true;
+        }
+        connection.method = request_line.substr(0, first_space);
+        connection.path = request_line.substr(first_space + 1, second_space - first_space - 1);
+        const size_t query = connection.path.find('?');
+        if (query != std::string::npos) {
+            connection.path.resize(query);
+        }
+        const std::string version = request_line.substr(second_space + 1);
+        connection.keep_alive = version != "HTTP/1.0";
+
+        bool has_json_size = false;
+        bool expect_continue = false;
+        while (line_end != std::string::npos) {
+            const size_t begin = line_end + 2;
+            line_end = header.find("\r\n", begin);
+            const std::string line = header.substr(begin, line_end == std::string::npos ? std::string::npos
+                                                                                         : line_end - begin);
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            const std::string name = line.substr(0, colon);
+            const std::string value = Trim(line.substr(colon + 1));
+            if (EqualsIgnoreCase(name, "Content-Length")) {
+                if (!ParseSize(value, &connection.content_length)) {
+                    SetResponse(connection, MakeError(400, "Invalid Content-Length", true));
+                    return true;
+                }
+            } else if (EqualsIgnoreCase(name, "Inference-Header-Content-Length")) {
+                if (!ParseSize(value, &connection.json_size)) {
+                    SetResponse(connection, MakeError(400, "Invalid Inference-Header-Content-Length", true));
+                    return true;
+                }
+                has_json_size = true;
+            } else if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+                SetResponse(connection, MakeError(411, "Chunked request bodies are not supported", true));
+                return true;
+            } else if (EqualsIgnoreCase(name, "Connection")) {
+                if (EqualsIgnoreCase(value, "close")) {
+                    connection.keep_alive = false;
+                } else if (EqualsIgnoreCase(value, "keep-alive")) {
+                    connection.keep_alive = true;
+                }
+            } else if (EqualsIgnoreCase(name, "Expect")) {
+                expect_continue = EqualsIgnoreCase(value, "100-continue");
+            }
+        }
+        if (connection.content_length > server_->options_.max_request_bytes) {
+            SetResponse(connection, MakeError(413, "Request body too large", true));
+            return true;
+        }
+        if (!has_json_size) {
+            connection.json_size = connection.content_length;
+        }
+        if (connection.json_size > connection.content_length) {
+            SetResponse(connection, MakeError(400, "Inference-Header-Content-Length exceeds Content-Length", true));
+            return true;
+        }
+        if (connection.content_length == 0) {
+            return true;
+        }
+
+        // JSON之后的二进制部分按64字节对齐，张量视图满足SIMD内核的对齐要求
+        const size_t padding = (kBodyAlignment - connection.json_size % kBodyAlignment) % kBodyAlignment;
+        uint8_t* base = static_cast<uint8_t*>(AllocateMemory(connection.content_length + padding, kBodyAlignment));
+        if (!base) {
+            SetResponse(connection, MakeError(503, "Out of memory for the request body", true));
+            return true;
+        }
+        connection.body_owner.reset(base, [](uint8_t* p) { FreeMemory(p); });
+        connection.body = base + padding;
+        // 与请求头同一次recv收到的部分只能拷贝，其余直接收进body
+        const size_t buffered = std::min(connection.input.size(), connection.content_length);
+        std::memcpy(connection.body, connection.input.data(), buffered);
+        connection.input.erase(0, buffered);
+        connection.body_received = buffered;
+        if (expect_continue && connection.body_received < connection.content_length) {
+            static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+            ssize_t ignored = ::send(connection.fd, kContinue, sizeof(kContinue) - 1, MSG_NOSIGNAL);
+            (void)ignored;
+        }
+        return true;
+    }
+
+    void SetResponse(Connection& connection, std::unique_ptr<Response> response) {
+        connection.has_request = true;
+        connection.keep_alive = connection.keep_alive && !response->close;
+        connection.response = std::move(response);
+        Response& r = *connection.response;
+        connection.iov.clear();
+        connection.iov_index = 0;
+        connection.iov.push_back({const_cast<char*>(r.head.data()), r.head.size()});
+        if (!r.body.empty()) {
+            connection.iov.push_back({const_cast<char*>(r.body.data()), r.body.size()});
+        }
+        for (const auto& tensor : r.tensors) {
+            if (tensor->GetSizeInBytes() > 0) {
+                connection.iov.push_back({tensor->GetData(), tensor->GetSizeInBytes()});
+            }
+        }
+    }
+
+    // 尽量发送；发完后结束当前请求（需要时关闭连接）
+    bool WriteResponse(Connection& connection) {
+        while (connection.iov_index < connection.iov.size()) {
+            msghdr message{};
+            message.msg_iov = connection.iov.data() + connection.iov_index;
+            message.msg_iovlen = std::min(connection.iov.size() - connection.iov_index, kMaxIovecs);
+            const ssize_t sent = ::sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                Close(connection);
+                return false;
+            }
+            size_t remaining = static_cast<size_t>(sent);
+            while (remaining > 0 && connection.iov_index < connection.iov.size()) {
+                iovec& segment = connection.iov[connection.iov_index];
+                const size_t step = std::min(remaining, segment.iov_len);
+                segment.iov_base = static_cast<char*>(segment.iov_base) + step;
+                segment.iov_len -= step;
+                remaining -= step;
+                if (segment.iov_len == 0) {
+                    ++connection.iov_index;
+                }
+            }
+        }
+        const bool keep_alive = connection.keep_alive && !connection.peer_closed;
+        connection.response.reset();
+        connection.iov.clear();
+        connection.ResetRequest();
+        if (!keep_alive) {
+            Close(connection);
+            return false;
+        }
+        return true;
+    }
+
+    void DrainCompletions() {
+        std::deque<std::pair<uint64_t, std::unique_ptr<Response>>> completions;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completions.swap(completions_);
+        }
+        for (auto& completion : completions) {
+            auto it = connections_by_id_.find(completion.first);
+            if (it == connections_by_id_.end()) {
+                continue;  // 客户端已断开
+            }
+            Connection& connection = *it->second;
+            connection.in_flight = false;
+            SetResponse(connection, std::move(completion.second));
+            if (!WriteResponse(connection)) {
+                continue;
+            }
+            if (!connection.response && !Process(connection)) {
+                continue;
+            }
+            UpdateEvents(connection);
+        }
+    }
+
+    void Dispatch(Connection& connection) {
+        const bool close = !connection.keep_alive;
+        const bool get = connection.method == "GET";
+        const std::string& path = connection.path;
+        if (path == "/metrics" && server_->options_.expose_metrics) {
+            if (!get) {
+                SetResponse(connection, MakeError(405, "Method not allowed", close));
+                return;
+            }
+            SetResponse(connection, MakeResponse(200, "text/plain; version=0.0.4",
+                                                 MetricsRegistry::Instance().ExportPrometheus(), close));
+            return;
+        }
+
+        const std::vector<std::string> segments = SplitPath(path);
+        if (segments.empty() || segments[0] != "v2") {
+            SetResponse(connection, MakeError(404, "Unknown endpoint: " + path, close));
+            return;
+        }
+        const bool infer = segments.size() >= 4 && segments[1] == "models" && segments.back() == "infer";
+        if (infer ? connection.method != "POST" : !get) {
+            SetResponse(connection, MakeError(405, "Method not allowed", close));
+            return;
+        }
+        if (segments.size() == 1) {
+            std::string json = "{\"name\":\"inferunity\",\"version\":\"" INFERUNITY_VERSION
+                               "\",\"extensions\":[\"binary_tensor_data\"]}";
+            SetResponse(connection, MakeResponse(200, "application/json", std::move(json), close));
+            return;
+        }
+        if (segments[1] == "health" && segments.size() == 3) {
+            if (segments[2] == "live") {
+                SetResponse(connection, MakeResponse(200, nullptr, "", close));
+                return;
+            }
+            if (segments[2] == "ready") {
+                const bool ready = server_->IsRunning();
+                SetResponse(connection, MakeResponse(ready ? 200 : 503, nullptr, "", close));
+                return;
+            }
+        }
+        if (segments[1] != "models" || segments.size() < 3) {
+            SetResponse(connection, MakeError(404, "Unknown endpoint: " + path, close));
+            return;
+        }
+
+        // /v2/models/{name}[/versions/{version}][/ready|/infer]
+        const Model* model = server_->FindModel(segments[2]);
+        if (!model) {
+            SetResponse(connection, MakeError(404, "Unknown model: " + segments[2], close));
+            return;
+        }
+        size_t next = 3;
+        if (next < segments.size() && segments[next] == "versions") {
+            if (next + 1 >= segments.size() || segments[next + 1] != model->options.version) {
+                SetResponse(connection, MakeError(404, "Unknown version of model " + model->name, close));
+                return;
+            }
+            next += 2;
+        }
+        const std::string action = next < segments.size() ? segments[next] : "";
+        if (next + 1 < segments.size() || (!action.empty() && action != "ready" && action != "infer")) {
+            SetResponse(connection, MakeError(404, "Unknown endpoint: " + path, close));
+            return;
+        }
+        if (action.empty()) {
+            SetResponse(connection, MakeResponse(200, "application/json", model->metadata, close));
+        } else if (action == "ready") {
+            SetResponse(connection, MakeResponse(server_->IsRunning() ? 200 : 503, nullptr, "", close));
+        } else {
+            HandleInfer(connection, *model);
+        }
+    }
+
+    void HandleInfer(Connection& connection, const Model& model) {
+        const bool close = !connection.keep_alive;
+        infer_requests_.fetch_add(1, std::memory_order_relaxed);
+        auto request = std::make_shared<server::DecodedInferRequest>();
+        Status status = server::DecodeInferRequest(connection.body, connection.content_length, connection.json_size,
+                                                   connection.body_owner, model.input_names, request.get());
+        // 输入视图各自持有接收缓冲，连接不再引用它
+        connection.body_owner.reset();
+        connection.body = nullptr;
+        if (!status.IsOk()) {
+            infer_failures_.fetch_add(1, std::memory_order_relaxed);
+            model.failure_metric->Add();
+            SetResponse(connection, MakeError(HttpStatusFor(status), status.Message(), close));
+            return;
+        }
+        size_t input_bytes = 0;
+        for (const auto& input : request->inputs) {
+            input_bytes += input->GetSizeInBytes();
+        }
+        zero_copy_bytes_.fetch_add(request->zero_copy_bytes, std::memory_order_relaxed);
+        copied_bytes_.fetch_add(input_bytes - request->zero_copy_bytes, std::memory_order_relaxed);
+
+        const int64_t timeout_us = request->timeout_us > 0 ? request->timeout_us
+                                                           : server_->options_.default_timeout_us;
+        std::vector<std::shared_ptr<Tensor>> inputs = std::move(request->inputs);
+        request->inputs.clear();
+        const uint64_t connection_id = connection.id;
+        const Clock::time_point start = Clock::now();
+        const Model* served = &model;
+        auto finish = [this, connection_id, served, request, start, close](Status result,
+                                                                            std::vector<std::shared_ptr<Tensor>> outputs) {
+            std::unique_ptr<Response> response;
+            if (result.IsOk()) {
+                server::EncodedInferResponse encoded;
+                result = server::EncodeInferResponse(served->name, served->options.version, *request,
+                                                      served->output_names, outputs, &encoded);
+                if (result.IsOk()) {
+                    const bool binary = encoded.binary_size > 0;
+                    const std::string extra = binary ? "Inference-Header-Content-Length: " +
+                                                           std::to_string(encoded.json.size()) + "\r\n"
+                                                     : "";
+                    response = MakeResponse(200, binary ? "application/octet-stream" : "application/json",
+                                            std::move(encoded.json), close, extra, encoded.binary_size);
+                    response->tensors = std::move(encoded.binary);
+                }
+            }
+            if (result.IsOk()) {
+                served->success_metric->Add();
+            } else {
+                infer_failures_.fetch_add(1, std::memory_order_relaxed);
+                served->failure_metric->Add();
+                response = MakeError(HttpStatusFor(result), result.Message(), close);
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+            served->latency_metric->Record(static_cast<double>(elapsed.count()));
+            Post(connection_id, std::move(response));
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++pending_;
+        }
+        connection.in_flight = true;
+        if (model.batcher) {
+            // 批处理器的时限只约束排队时间；未受理时回调在本线程上立即调用，响应在下一轮事件中发出
+            model.batcher->Submit(
+                std::move(inputs),
+                [finish](BatchResult result) { finish(std::move(result.status), std::move(result.outputs)); },
+                timeout_us > 0 ? timeout_us : -1);
+            return;
+        }
+        RunOptions run_options;
+        run_options.cancellation = timeout_us > 0 ? CancellationToken::WithTimeout(std::chrono::microseconds(timeout_us))
+                                                  : CancellationToken::Create();
+        connection.cancellation = run_options.cancellation;
+        Status accepted = model.session->RunAsync(run_options, std::move(inputs), finish);
+        if (!accepted.IsOk()) {
+            finish(accepted, {});
+        }
+    }
+
+    InferenceServer* server_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wakeup_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    uint64_t next_id_ = 2;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_by_id_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::deque<std::pair<uint64_t, std::unique_ptr<Response>>> completions_;
+    int64_t pending_ = 0;  // 已提交、回调尚未返回的推理数
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> infer_requests_{0};
+    std::atomic<uint64_t> infer_failures_{0};
+    std::atomic<uint64_t> zero_copy_bytes_{0};
+    std::atomic<uint64_t> copied_bytes_{0};
+};
+
+InferenceServer::InferenceServer(const ServerOptions& options) : options_(options) {}
+
+InferenceServer::~InferenceServer() {
+    Stop();
+}
+
+Status InferenceServer::AddModel(const std::string& name, InferenceSession* session,
+                                 const ServedModelOptions& options) {
+    if (IsRunning()) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Models must be added before the server starts");
+    }
+    if (!session || !session->GetGraph()) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Session is not initialized");
+    }
+    if (name.empty() || name.find('/') != std::string::npos) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Invalid model name: " + name);
+    }
+    if (FindModel(name)) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Model already added: " + name);
+    }
+
+    auto model = std::make_unique<Model>();
+    model->name = name;
+    model->options = options;
+    model->session = session;
+    model->input_names = session->GetInputNames();
+    model->output_names = session->GetOutputNames();
+
+    std::string& json = model->metadata;
+    json.append("{\"name\":");
+    server::AppendJsonString(&json, name);
+    json.append(",\"versions\":[");
+    server::AppendJsonString(&json, options.version);
+    json.append("],\"platform\":\"inferunity\",\"inputs\":[");
+    const Graph* graph = session->GetGraph();
+    for (size_t i = 0; i < graph->GetInputs().size() && i < model->input_names.size(); ++i) {
+        if (i > 0) {
+            json.push_back(',');
+        }
+        AppendTensorMetadata(&json, graph->GetInputs()[i], model->input_names[i]);
+    }
+    json.append("],\"outputs\":[");
+    for (size_t i = 0; i < graph->GetOutputs().size() && i < model->output_names.size(); ++i) {
+        if (i > 0) {
+            json.push_back(',');
+        }
+        AppendTensorMetadata(&json, graph->GetOutputs()[i], model->output_names[i]);
+    }
+    json.append("]}");
+
+    auto& registry = MetricsRegistry::Instance();
+    model->success_metric = registry.GetCounter("inferunity_server_infer_requests_total",
+                                                {{"model", name}, {"outcome", "success"}},
+                                                "Inference requests served over HTTP");
+    model->failure_metric = registry.GetCounter("inferunity_server_infer_requests_total",
+                                                {{"model", name}, {"outcome", "failure"}},
+                                                "Inference requests served over HTTP");
+    model->latency_metric = registry.GetHistogram("inferunity_server_infer_latency_us", LatencyBucketsUs(),
+                                                  {{"model", name}},
+                                                  "Time from decoding an inference request to encoding its response");
+    models_.push_back(std::move(model));
+    return Status::Ok();
+}
+
+const InferenceServer::Model* InferenceServer::FindModel(const std::string& name) const {
+    for (const auto& model : models_) {
+        if (model->name == name) {
+            return model.get();
+        }
+    }
+    return nullptr;
+}
+
+Status InferenceServer::Start() {
+    if (IsRunning()) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Server is already running");
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* address = nullptr;
+    if (::getaddrinfo(options_.host.c_str(), nullptr, &hints, &address) != 0 || !address) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Cannot resolve host: " + options_.host);
+    }
+    sockaddr_in bind_address;
+    std::memcpy(&bind_address, address->ai_addr, sizeof(bind_address));
+    ::freeaddrinfo(address);
+    bind_address.sin_port = htons(static_cast<uint16_t>(options_.port));
+
+    // 每个事件循环一个SO_REUSEPORT监听套接字；端口为0时第一个套接字取得的端口供其余套接字使用
+    const int num_loops = std::max(1, options_.num_io_threads);
+    Status status = Status::Ok();
+    for (int i = 0; i < num_loops && status.IsOk(); ++i) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            status = SocketError("socket");
+            break;
+        }
+        const int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&bind_address), sizeof(bind_address)) != 0 ||
+            ::listen(fd, options_.backlog) != 0) {
+            status = SocketError("bind " + options_.host + ":" + std::to_string(ntohs(bind_address.sin_port)));
+            ::close(fd);
+            break;
+        }
+        if (i == 0) {
+            socklen_t length = sizeof(bind_address);
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&bind_address), &length);
+            bound_port_ = ntohs(bind_address.sin_port);
+        }
+        auto loop = std::make_unique<EventLoop>(this, fd);
+        status = loop->Init();
+        loops_.push_back(std::move(loop));
+    }
+    if (!status.IsOk()) {
+        loops_.clear();
+        return status;
+    }
+
+    for (auto& model : models_) {
+        if (model->options.dynamic_batching) {
+            model->batcher = std::make_unique<DynamicBatcher>(model->session, model->options.batching);
+        }
+    }
+    running_.store(true, std::memory_order_release);
+    for (auto& loop : loops_) {
+        loop->Start();
+    }
+    return Status::Ok();
+}
+
+void InferenceServer::Stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    // 先停事件循环（取消在途推理、关闭连接），再让批处理器拒绝排队的请求，最后等所有回调返回
+    for (auto& loop : loops_) {
+        loop->RequestStop();
+    }
+    for (auto& loop : loops_) {
+        loop->Join();
+    }
+    for (auto& model : models_) {
+        if (model->batcher) {
+            model->batcher->Stop();
+        }
+    }
+    for (auto& loop : loops_) {
+        loop->WaitIdle();
+        loop->AddStats(&stopped_stats_);
+    }
+    loops_.clear();
+    for (auto& model : models_) {
+        model->batcher.reset();
+    }
+}
+
+ServerStats InferenceServer::GetStats() const {
+    ServerStats stats = stopped_stats_;
+    for (const auto& loop : loops_) {
+        loop->AddStats(&stats);
+    }
+    return stats;
+}
+
+} // namespace inferunity
@@ -0,0 +1,43 @@
+// 构建时生成AOT测试模型：aot_generate_test_model <output_prefix>
+// 对aot_test_model.h的测试图做形状推断与内存规划后写出<prefix>.h/.cpp/_weights.cpp，由test_aot_compiler链接
+
+#include "aot_test_model.h"
+#include "inferunity/aot_compiler.h"
+#include "inferunity/memory_planner.h"
+#include <fstream>
+#include <iostream>
+
+namespace inferunity {
+    Status InferShapes(Graph* graph);
+}
+
+using namespace inferunity;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output_prefix>" << std::endl;
+        return 1;
+    }
+    const std::string prefix = argv[1];
+    auto graph = aot_test::BuildAotTestGraph();
+    Status status = InferShapes(graph.get());
+    MemoryPlan plan;
+    if (status.IsOk()) {
+        status = PlanMemory(graph.get(), MemoryPlannerOptions(), &plan);
+    }
+    AotCompileOptions options;
+    options.function_name = aot_test::kFunctionName;
+    options.header_name = prefix.substr(prefix.find_last_of("/\\") + 1) + ".h";
+    AotCompileResult result;
+    if (status.IsOk()) {
+        status = CompileGraphToSource(*graph, plan, options, &result);
+    }
+    if (!status.IsOk()) {
+        std::cerr << "AOT compilation failed: " << status.Message() << std::endl;
+        return 1;
+    }
+    std::ofstream(prefix + ".h") << result.header;
+    std::ofstream(prefix + ".cpp") << result.source;
+    std::ofstream(prefix + "_weights.cpp") << result.weights_source;
+    return 0;
+}
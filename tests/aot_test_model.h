@@ -0,0 +1,99 @@
+// AOT编译测试共用的测试图：构建时的生成器（aot_generate_test_model.cpp）与test_aot_compiler.cpp
+// 各自构建同一张图，前者生成C++源文件，后者用会话运行作为参考结果
+//   x[2,3,8,8] -> Conv3x3+Relu -> MaxPool2x2 -> Conv1x1 -> 深度Conv3x3+ReLU -> GlobalAveragePool
+//   -> Flatten（输出features）-> Gemm -> LayerNorm -> Gelu -> Concat(·, Gemm) -> MatMul + Add -> Softmax（输出probs）
+
+#pragma once
+
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+namespace aot_test {
+
+constexpr const char* kFunctionName = "inferunity_aot_test_model";
+
+inline std::shared_ptr<Tensor> MakeTestTensor(const std::vector<int64_t>& dims, float seed, float scale) {
+    auto tensor = CreateTensor(Shape(dims), DataType::FLOAT32, DeviceType::CPU);
+    float* data = static_cast<float*>(tensor->GetData());
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        data[i] = scale * std::sin(seed * 12.9898f + static_cast<float>(i) * 0.7853f);
+    }
+    return tensor;
+}
+
+inline std::unique_ptr<Graph> BuildAotTestGraph() {
+    auto graph = std::make_unique<Graph>();
+    auto value = [&](const std::string& name) {
+        Value* v = graph->AddValue();
+        v->SetName(name);
+        return v;
+    };
+    auto constant = [&](const std::string& name, const std::vector<int64_t>& dims, float seed, float scale) {
+        Value* v = value(name);
+        v->SetTensor(MakeTestTensor(dims, seed, scale));
+        return v;
+    };
+    auto node = [&](const std::string& type, const std::string& name, const std::vector<Value*>& inputs,
+                    Value* output) {
+        Node* n = graph->AddNode(type, name);
+        for (Value* input : inputs) {
+            n->AddInput(input);
+        }
+        n->AddOutput(output);
+        return n;
+    };
+    
+    Value* x = value("x");
+    x->SetTensor(CreateTensor(Shape({2, 3, 8, 8}), DataType::FLOAT32, DeviceType::CPU));
+    graph->AddInput(x);
+    
+    Value* conv1 = value("conv1_out");
+    node("Conv", "conv1", {x, constant("w1", {8, 3, 3, 3}, 1.0f, 0.3f), constant("b1", {8}, 2.0f, 0.1f)}, conv1)
+        ->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    Value* relu1 = value("relu1_out");
+    node("Relu", "relu1", {conv1}, relu1);
+    Value* pool = value("pool_out");
+    Node* pool_node = node("MaxPool", "pool", {relu1}, pool);
+    pool_node->SetAttribute("kernel_shape", AttributeValue(std::vector<int64_t>{2, 2}));
+    pool_node->SetAttribute("strides", AttributeValue(std::vector<int64_t>{2, 2}));
+    Value* pw = value("pw_out");
+    node("Conv", "pw", {pool, constant("w2", {8, 8, 1, 1}, 3.0f, 0.3f)}, pw);
+    Value* dw = value("dw_out");
+    Node* dw_node = node("FusedConvReLU", "dw", {pw, constant("w3", {8, 1, 3, 3}, 4.0f, 0.4f),
+                                                 constant("b3", {8}, 5.0f, 0.1f)}, dw);
+    dw_node->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    dw_node->SetAttribute("group", AttributeValue(static_cast<int64_t>(8)));
+    Value* gap = value("gap_out");
+    node("GlobalAveragePool", "gap", {dw}, gap);
+    Value* features = value("features");
+    node("Flatten", "flatten", {gap}, features)->SetAttribute("axis", AttributeValue(static_cast<int64_t>(1)));
+    
+    Value* fc1 = value("fc1_out");
+    node("Gemm", "fc1", {features, constant("w4", {16, 8}, 6.0f, 0.5f), constant("b4", {16}, 7.0f, 0.1f)}, fc1)
+        ->SetAttribute("transB", AttributeValue(static_cast<int64_t>(1)));
+    Value* ln = value("ln_out");
+    node("LayerNormalization", "ln", {fc1, constant("gamma", {16}, 8.0f, 1.0f), constant("beta", {16}, 9.0f, 0.2f)},
+         ln);
+    Value* gelu = value("gelu_out");
+    node("Gelu", "gelu", {ln}, gelu);
+    Value* cat = value("cat_out");
+    node("Concat", "cat", {gelu, fc1}, cat)->SetAttribute("axis", AttributeValue(static_cast<int64_t>(1)));
+    Value* fc2 = value("fc2_out");
+    node("MatMul", "fc2", {cat, constant("w5", {32, 10}, 10.0f, 0.4f)}, fc2);
+    Value* logits = value("logits");
+    node("Add", "bias", {fc2, constant("b5", {10}, 11.0f, 0.1f)}, logits);
+    Value* probs = value("probs");
+    node("Softmax", "softmax", {logits}, probs);
+    
+    graph->AddOutput(features);
+    graph->AddOutput(probs);
+    return graph;
+}
+
+} // namespace aot_test
+} // namespace inferunity
@@ -3,8 +3,12 @@
 #include "inferunity/tensor.h"
 #include "inferunity/operator.h"
 #include "inferunity/types.h"
+#include "operators/simd_utils.h"
 #include <vector>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <string>
 
 using namespace inferunity;
 
@@ -127,3 +131,356 @@ TEST_F(ActivationOperatorsTest, SiluOperator) {
     EXPECT_GT(out_data[1], 0.0f);
 }
 
+
+// Softmax/LogSoftmax测试：与双精度参考比较，覆盖短行、在线单遍长行和非最后一维axis
+namespace {
+
+void ReferenceSoftmax(const std::vector<float>& x, const std::vector<int64_t>& dims,
+                      int64_t axis, bool log_softmax, std::vector<double>& y) {
+    int64_t outer = 1, inner = 1;
+    for (int64_t i = 0; i < axis; ++i) outer *= dims[i];
+    for (size_t i = axis + 1; i < dims.size(); ++i) inner *= dims[i];
+    const int64_t n = dims[axis];
+    y.assign(x.size(), 0.0);
+    for (int64_t o = 0; o < outer; ++o) {
+        for (int64_t j = 0; j < inner; ++j) {
+            double max_val = -1e30;
+            for (int64_t i = 0; i < n; ++i) {
+                max_val = std::max(max_val, static_cast<double>(x[(o * n + i) * inner + j]));
+            }
+            double sum = 0.0;
+            for (int64_t i = 0; i < n; ++i) {
+                sum += std::exp(x[(o * n + i) * inner + j] - max_val);
+            }
+            for (int64_t i = 0; i < n; ++i) {
+                const size_t idx = (o * n + i) * inner + j;
+                y[idx] = log_softmax ? x[idx] - max_val - std::log(sum)
+                                     : std::exp(x[idx] - max_val) / sum;
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST_F(ActivationOperatorsTest, SoftmaxAndLogSoftmax) {
+    auto& registry = OperatorRegistry::Instance();
+    
+    struct Case {
+        std::vector<int64_t> dims;
+        int64_t axis;
+    };
+    const std::vector<Case> cases = {
+        {{2, 3}, -1},
+        {{3, 17}, 1},
+        {{2, 5000}, -1},    // 在线单遍路径
+        {{2, 5, 19}, 1},    // 非最后一维
+        {{4, 6}, 0},
+    };
+    
+    for (bool log_softmax : {false, true}) {
+        for (const auto& c : cases) {
+            auto op = registry.Create(log_softmax ? "LogSoftmax" : "Softmax");
+            ASSERT_NE(op, nullptr);
+            op->SetAttribute("axis", AttributeValue(c.axis));
+    
+            Shape shape(c.dims);
+            auto input = CreateTensor(shape, DataType::FLOAT32);
+            auto output = CreateTensor(shape, DataType::FLOAT32);
+            const size_t count = input->GetElementCount();
+            std::vector<float> values(count);
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = 12.0f * std::sin(0.731f * static_cast<float>(i)) + 0.001f * static_cast<float>(i);
+            }
+            std::copy(values.begin(), values.end(), static_cast<float*>(input->GetData()));
+    
+            std::vector<Tensor*> inputs = {input.get()};
+            std::vector<Tensor*> outputs = {output.get()};
+            ASSERT_TRUE(op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    
+            const int64_t axis = c.axis < 0 ? c.axis + static_cast<int64_t>(c.dims.size()) : c.axis;
+            std::vector<double> expected;
+            ReferenceSoftmax(values, c.dims, axis, log_softmax, expected);
+            const float* out_data = static_cast<const float*>(output->GetData());
+            for (size_t i = 0; i < count; ++i) {
+                const double tolerance = log_softmax ? 1e-4 : 1e-6 + 1e-5 * expected[i];
+                ASSERT_NEAR(out_data[i], expected[i], tolerance)
+                    << (log_softmax ? "LogSoftmax" : "Softmax") << " case axis=" << c.axis << " index " << i;
+            }
+        }
+    }
+    
+    // axis越界
+    auto op = registry.Create("Softmax");
+    op->SetAttribute("axis", AttributeValue(static_cast<int64_t>(3)));
+    auto input = CreateTensor(Shape({2, 3}), DataType::FLOAT32);
+    auto output = CreateTensor(Shape({2, 3}), DataType::FLOAT32);
+    std::vector<Tensor*> inputs = {input.get()};
+    std::vector<Tensor*> outputs = {output.get()};
+    EXPECT_FALSE(op->Execute(inputs, outputs, ctx_.get()).IsOk());
+}
+
+// 编译节点时按行长选定的专用核与通用路径结果一致；行长不符时回退到通用路径
+TEST_F(ActivationOperatorsTest, SoftmaxSpecializedRows) {
+    auto& registry = OperatorRegistry::Instance();
+    EXPECT_GE(simd::FindSpecializedRowSlot(64), 0);
+    EXPECT_GE(simd::FindSpecializedRowSlot(4096), 0);
+    EXPECT_EQ(simd::FindSpecializedRowSlot(100), -1);
+    
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (bool log_softmax : {false, true}) {
+            for (int64_t cols : {64, 128, 768, 4096}) {
+                const Shape shape({3, 1, cols});
+                auto input = CreateTensor(shape, DataType::FLOAT32);
+                float* data = static_cast<float*>(input->GetData());
+                for (size_t i = 0; i < input->GetElementCount(); ++i) {
+                    data[i] = 9.0f * std::sin(0.37f * static_cast<float>(i)) - 0.002f * static_cast<float>(i);
+                }
+                auto generic = registry.Create(log_softmax ? "LogSoftmax" : "Softmax");
+                auto specialized = registry.Create(log_softmax ? "LogSoftmax" : "Softmax");
+                specialized->SpecializeForShapes({shape});
+                auto expected = CreateTensor(shape, DataType::FLOAT32);
+                auto output = CreateTensor(shape, DataType::FLOAT32);
+                ASSERT_TRUE(generic->Execute({input.get()}, {expected.get()}, ctx_.get()).IsOk());
+                ASSERT_TRUE(specialized->Execute({input.get()}, {output.get()}, ctx_.get()).IsOk());
+                const float* want = static_cast<const float*>(expected->GetData());
+                const float* got = static_cast<const float*>(output->GetData());
+                for (size_t i = 0; i < output->GetElementCount(); ++i) {
+                    ASSERT_NEAR(got[i], want[i], 1e-5f + 1e-5f * std::fabs(want[i]))
+                        << isa << " cols=" << cols << " index " << i;
+                }
+    
+                // 特化时的行长与执行时不同
+                auto other = CreateTensor(Shape({2, 100}), DataType::FLOAT32);
+                auto other_out = CreateTensor(Shape({2, 100}), DataType::FLOAT32);
+                std::fill(static_cast<float*>(other->GetData()), static_cast<float*>(other->GetData()) + 200, 1.0f);
+                ASSERT_TRUE(specialized->Execute({other.get()}, {other_out.get()}, ctx_.get()).IsOk());
+                EXPECT_NEAR(static_cast<const float*>(other_out->GetData())[7], log_softmax ? -std::log(100.0f) : 0.01f,
+                            1e-5f);
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 多项式exp与std::exp的相对误差；有融合乘加的ISA与标量FastExp逐位一致
+TEST_F(ActivationOperatorsTest, FastExpAccuracy) {
+    std::vector<float> input;
+    for (float x = -87.0f; x <= 88.0f; x += 0.0137f) {
+        input.push_back(x);
+    }
+    std::vector<float> output(input.size());
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        const bool fused = std::string(isa) != "sse42";
+        simd::ExpSIMD(input.data(), output.data(), input.size());
+        for (size_t i = 0; i < input.size(); ++i) {
+            const double expected = std::exp(static_cast<double>(input[i]));
+            ASSERT_NEAR(output[i] / expected, 1.0, 1e-6) << isa << " x=" << input[i];
+            if (fused) {
+                ASSERT_EQ(output[i], simd::FastExp(input[i])) << isa << " x=" << input[i];
+            } else {
+                ASSERT_NEAR(output[i] / simd::FastExp(input[i]), 1.0f, 2e-7f) << isa << " x=" << input[i];
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 向量化超越函数：与std::对应函数及标量版本比较
+TEST_F(ActivationOperatorsTest, SimdTranscendentalAccuracy) {
+    std::vector<float> input;
+    for (float x = -12.0f; x <= 12.0f; x += 0.00731f) {
+        input.push_back(x);
+    }
+    std::vector<float> output(input.size());
+    
+    // 数组版本逐元素结果与位置无关：从奇数偏移开始计算同一段数据
+    std::vector<float> shifted(input.size());
+    simd::GeluSIMD(input.data(), output.data(), input.size(), false);
+    simd::GeluSIMD(input.data() + 3, shifted.data() + 3, input.size() - 3, false);
+    for (size_t i = 3; i < input.size(); ++i) {
+        ASSERT_EQ(output[i], shifted[i]) << "x=" << input[i];
+    }
+    
+    simd::TanhSIMD(input.data(), output.data(), input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        ASSERT_NEAR(output[i], std::tanh(static_cast<double>(input[i])), 5e-7) << "tanh x=" << input[i];
+        ASSERT_NEAR(output[i], simd::FastTanh(input[i]), 2e-7f);
+    }
+    simd::ErfSIMD(input.data(), output.data(), input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        ASSERT_NEAR(output[i], std::erf(static_cast<double>(input[i])), 5e-7) << "erf x=" << input[i];
+        ASSERT_NEAR(output[i], simd::FastErf(input[i]), 2e-7f);
+    }
+    simd::SigmoidSIMD(input.data(), output.data(), input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        const double expected = 1.0 / (1.0 + std::exp(-static_cast<double>(input[i])));
+        ASSERT_NEAR(output[i] / expected, 1.0, 1e-6) << "sigmoid x=" << input[i];
+        ASSERT_NEAR(output[i], simd::FastSigmoid(input[i]), 2e-7f);
+    }
+    
+    std::vector<float> positive;
+    for (float x = 1e-30f; x < 1e30f; x *= 1.37f) {
+        positive.push_back(x);
+    }
+    positive.push_back(0.0f);
+    positive.push_back(-1.0f);
+    output.resize(positive.size());
+    simd::LogSIMD(positive.data(), output.data(), positive.size());
+    for (size_t i = 0; i + 2 < positive.size(); ++i) {
+        ASSERT_NEAR(output[i], std::log(static_cast<double>(positive[i])),
+                    2e-7 * std::max(1.0, std::fabs(std::log(static_cast<double>(positive[i])))))
+            << "log x=" << positive[i];
+    }
+    EXPECT_TRUE(std::isinf(output[positive.size() - 2]) && output[positive.size() - 2] < 0.0f);
+    EXPECT_TRUE(std::isnan(output[positive.size() - 1]));
+}
+
+// GELU：默认erf精确形式，approximate="tanh"时使用tanh近似
+TEST_F(ActivationOperatorsTest, GeluApproximationModes) {
+    auto& registry = OperatorRegistry::Instance();
+    
+    Shape shape({37});
+    auto input = CreateTensor(shape, DataType::FLOAT32);
+    auto output = CreateTensor(shape, DataType::FLOAT32);
+    float* data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 37; ++i) {
+        data[i] = -6.0f + 0.33f * static_cast<float>(i);
+    }
+    std::vector<Tensor*> inputs = {input.get()};
+    std::vector<Tensor*> outputs = {output.get()};
+    const float* out_data = static_cast<const float*>(output->GetData());
+    
+    auto exact_op = registry.Create("Gelu");
+    ASSERT_TRUE(exact_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    for (int i = 0; i < 37; ++i) {
+        const double x = data[i];
+        EXPECT_NEAR(out_data[i], 0.5 * x * (1.0 + std::erf(x / std::sqrt(2.0))), 2e-6) << "x=" << x;
+    }
+    
+    auto tanh_op = registry.Create("Gelu");
+    tanh_op->SetAttribute("approximate", AttributeValue(std::string("tanh")));
+    ASSERT_TRUE(tanh_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    for (int i = 0; i < 37; ++i) {
+        const double x = data[i];
+        const double inner = std::sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x);
+        EXPECT_NEAR(out_data[i], 0.5 * x * (1.0 + std::tanh(inner)), 2e-6) << "x=" << x;
+    }
+}
+
+// 运行时ISA分发：每种可用ISA的结果与标量核一致，SetSimdIsa("auto")恢复自动选择
+TEST_F(ActivationOperatorsTest, SimdIsaDispatchAgreesWithScalar) {
+    const std::string auto_isa = simd::GetSimdIsaName();
+    EXPECT_FALSE(simd::SetSimdIsa("no_such_isa"));
+    EXPECT_EQ(auto_isa, simd::GetSimdIsaName());
+    
+    const size_t n = 203;  // 不是任何向量宽度的倍数，覆盖尾部
+    std::vector<float> a(n), b(n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = -9.0f + 0.09f * static_cast<float>(i);
+        b[i] = 0.5f + 0.01f * static_cast<float>(i);
+    }
+    auto run_all = [&](std::vector<std::vector<float>>& results, std::vector<float>& scalars) {
+        results.assign(7, std::vector<float>(n));
+        simd::AddSIMD(a.data(), b.data(), results[0].data(), n);
+        simd::ExpSIMD(a.data(), results[1].data(), n);
+        simd::LogSIMD(b.data(), results[2].data(), n);
+        simd::TanhSIMD(a.data(), results[3].data(), n);
+        simd::GeluSIMD(a.data(), results[4].data(), n, false);
+        simd::SiluSIMD(a.data(), results[5].data(), n);
+        float max_val = 0.0f;
+        float sum = 0.0f;
+        simd::OnlineMaxExpSumSIMD(a.data(), n, &max_val, &sum);
+        const float shifted_sum = simd::ExpShiftSumSIMD(a.data(), results[6].data(), n, max_val);
+        scalars = {simd::ReduceMaxSIMD(a.data(), n), simd::ReduceSumSIMD(b.data(), n),
+                   max_val, sum, shifted_sum};
+    };
+    
+    ASSERT_TRUE(simd::SetSimdIsa("scalar"));
+    EXPECT_STREQ("scalar", simd::GetSimdIsaName());
+    std::vector<std::vector<float>> expected;
+    std::vector<float> expected_scalars;
+    run_all(expected, expected_scalars);
+    
+    for (const char* isa : {"sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;  // 当前CPU不支持或未编译
+        }
+        EXPECT_STREQ(isa, simd::GetSimdIsaName());
+        std::vector<std::vector<float>> actual;
+        std::vector<float> actual_scalars;
+        run_all(actual, actual_scalars);
+        for (size_t k = 0; k < expected.size(); ++k) {
+            for (size_t i = 0; i < n; ++i) {
+                const float ref = expected[k][i];
+                EXPECT_NEAR(actual[k][i], ref, 1e-6f + 4e-6f * std::abs(ref))
+                    << isa << " kernel " << k << " i=" << i;
+            }
+        }
+        for (size_t k = 0; k < expected_scalars.size(); ++k) {
+            EXPECT_NEAR(actual_scalars[k], expected_scalars[k], 1e-5f * (1.0f + std::abs(expected_scalars[k])))
+                << isa << " reduction " << k;
+        }
+    }
+    
+    ASSERT_TRUE(simd::SetSimdIsa("auto"));
+    EXPECT_EQ(auto_isa, simd::GetSimdIsaName());
+}
+
+// 视图调用约定：ExecuteViews与经适配的Execute结果一致，视图的步长与元素数来自张量；
+// 执行上下文的资源按类型槽位存取
+TEST_F(ActivationOperatorsTest, TensorViewExecution) {
+    const Shape shape({2, 3, 5});
+    auto input = CreateTensor(shape, DataType::FLOAT32);
+    float* data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 30; ++i) {
+        data[i] = static_cast<float>(i - 15) * 0.25f;
+    }
+    
+    TensorView view;
+    ASSERT_TRUE(MakeTensorView(*input, &view));
+    EXPECT_EQ(view.ndims, 3);
+    EXPECT_EQ(view.GetElementCount(), 30);
+    EXPECT_TRUE(view.contiguous);
+    EXPECT_EQ(view.strides[0], 15);
+    EXPECT_EQ(view.strides[1], 5);
+    EXPECT_EQ(view.strides[2], 1);
+    
+    for (const char* op_type : {"Relu", "Sigmoid", "Tanh", "Gelu", "Silu"}) {
+        auto op = OperatorRegistry::Instance().Create(op_type);
+        ASSERT_NE(op, nullptr);
+        ASSERT_TRUE(op->SupportsViewExecution()) << op_type;
+        auto expected = CreateTensor(shape, DataType::FLOAT32);
+        ASSERT_TRUE(op->Execute({input.get()}, {expected.get()}, ctx_.get()).IsOk());
+    
+        auto actual = CreateTensor(shape, DataType::FLOAT32);
+        TensorView views[2];
+        ASSERT_TRUE(MakeTensorView(*input, &views[0]));
+        ASSERT_TRUE(MakeTensorView(*actual, &views[1]));
+        ASSERT_TRUE(op->ExecuteViews(TensorViewSpan{views, 1}, TensorViewSpan{views + 1, 1}, ctx_.get()).IsOk());
+        EXPECT_EQ(std::memcmp(expected->GetData(), actual->GetData(), 30 * sizeof(float)), 0) << op_type;
+    }
+    
+    auto matmul = OperatorRegistry::Instance().Create("MatMul");
+    ASSERT_NE(matmul, nullptr);
+    EXPECT_FALSE(matmul->SupportsViewExecution());
+    EXPECT_FALSE(matmul->ExecuteViews(TensorViewSpan{}, TensorViewSpan{}, ctx_.get()).IsOk());
+    
+    struct BlasHandle { int id; };
+    struct StreamPool { int id; };
+    BlasHandle handle{1};
+    StreamPool pool{2};
+    EXPECT_EQ(ctx_->GetDeviceResource<BlasHandle>(), nullptr);
+    ctx_->SetDeviceResource(&handle);
+    ctx_->SetDeviceResource(&pool);
+    EXPECT_EQ(ctx_->GetDeviceResource<BlasHandle>(), &handle);
+    EXPECT_EQ(ctx_->GetDeviceResource<StreamPool>(), &pool);
+    ExecutionContext other;
+    EXPECT_EQ(other.GetDeviceResource<StreamPool>(), nullptr);
+}
@@ -0,0 +1,114 @@
+// 静态图AOT编译测试
+// 构建时生成的aot_test_model（见aot_generate_test_model.cpp）与会话运行同一张图的结果比较
+
+#include <gtest/gtest.h>
+#include "aot_test_model.h"
+#include "aot_test_model_generated.h"
+#include "inferunity/aot_compiler.h"
+#include "inferunity/engine.h"
+#include "inferunity/memory_planner.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace inferunity {
+    Status InferShapes(Graph* graph);
+}
+
+using namespace inferunity;
+
+namespace {
+
+Status CompileTestGraph(Graph* graph, AotCompileResult* result) {
+    Status status = InferShapes(graph);
+    if (!status.IsOk()) {
+        return status;
+    }
+    MemoryPlan plan;
+    status = PlanMemory(graph, MemoryPlannerOptions(), &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    AotCompileOptions options;
+    options.function_name = aot_test::kFunctionName;
+    return CompileGraphToSource(*graph, plan, options, result);
+}
+
+} // anonymous namespace
+
+TEST(AotCompilerTest, GeneratedModelMatchesSession) {
+    auto input = aot_test::MakeTestTensor({2, 3, 8, 8}, 42.0f, 1.0f);
+    
+    auto session = InferenceSession::Create(SessionOptions());
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(aot_test::BuildAotTestGraph()).IsOk());
+    std::vector<Tensor*> inputs = {input.get()};
+    std::vector<Tensor*> expected;
+    ASSERT_TRUE(session->Run(inputs, expected).IsOk());
+    ASSERT_EQ(expected.size(), 2u);
+    
+    // 生成的函数：调用方提供64字节对齐的arena
+    const size_t arena_size = inferunity_aot_test_model_arena_size();
+    void* arena = std::aligned_alloc(64, (arena_size + 63) / 64 * 64 + 64);
+    ASSERT_NE(arena, nullptr);
+    std::vector<float> features(16, -1.0f), probs(20, -1.0f);
+    const float* aot_inputs[] = {static_cast<const float*>(input->GetData())};
+    float* aot_outputs[] = {features.data(), probs.data()};
+    inferunity_aot_test_model(aot_inputs, aot_outputs, arena);
+    // 再次调用结果不变（arena内容不需要保留）
+    inferunity_aot_test_model(aot_inputs, aot_outputs, arena);
+    std::free(arena);
+    
+    ASSERT_EQ(expected[0]->GetElementCount(), features.size());
+    ASSERT_EQ(expected[1]->GetElementCount(), probs.size());
+    const float* ref_features = static_cast<const float*>(expected[0]->GetData());
+    const float* ref_probs = static_cast<const float*>(expected[1]->GetData());
+    for (size_t i = 0; i < features.size(); ++i) {
+        EXPECT_NEAR(features[i], ref_features[i], 1e-4f) << "features[" << i << "]";
+    }
+    for (size_t i = 0; i < probs.size(); ++i) {
+        EXPECT_NEAR(probs[i], ref_probs[i], 1e-5f) << "probs[" << i << "]";
+    }
+}
+
+TEST(AotCompilerTest, SourceCallsKernelsDirectly) {
+    auto graph = aot_test::BuildAotTestGraph();
+    AotCompileResult result;
+    Status status = CompileTestGraph(graph.get(), &result);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    
+    // 与构建时生成的代码一致；每个计算节点一次调用，Flatten作为图输出时是一次拷贝
+    EXPECT_EQ(result.arena_size, inferunity_aot_test_model_arena_size());
+    EXPECT_EQ(result.num_kernel_calls, 14u);
+    EXPECT_NE(result.source.find("aot::Conv2D("), std::string::npos);
+    EXPECT_NE(result.source.find("aot::Copy("), std::string::npos);
+    EXPECT_EQ(result.source.find("Registry"), std::string::npos);
+    EXPECT_EQ(result.source.find("Tensor"), std::string::npos);
+    // 权重：6个权重与7个bias/scale，各自64字节对齐
+    EXPECT_GE(result.weights.size(), (8 * 3 * 9 + 8 * 8 + 8 * 9 + 16 * 8 + 32 * 10) * sizeof(float));
+    EXPECT_NE(result.weights_source.find("alignas(64)"), std::string::npos);
+}
+
+TEST(AotCompilerTest, RejectsUnsupportedOperators) {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({2, 3}), DataType::FLOAT32, DeviceType::CPU));
+    Value* t = graph->AddValue();
+    Value* y = graph->AddValue();
+    Node* transpose = graph->AddNode("Transpose", "transpose1");
+    transpose->AddInput(x);
+    transpose->AddOutput(t);
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(t);
+    relu->AddOutput(y);
+    graph->AddInput(x);
+    graph->AddOutput(y);
+    
+    AotCompileResult result;
+    Status status = CompileTestGraph(graph.get(), &result);
+    EXPECT_EQ(status.Code(), StatusCode::ERROR_NOT_IMPLEMENTED);
+    EXPECT_NE(status.Message().find("transpose1 (Transpose)"), std::string::npos) << status.Message();
+    // 不支持的节点之后的节点不因缺少输入而另外报错
+    EXPECT_EQ(status.Message().find("relu1"), std::string::npos) << status.Message();
+}
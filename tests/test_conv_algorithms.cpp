@@ -0,0 +1,929 @@
+// 卷积算法测试
+// 各算法路径（im2col/1x1/Winograd/深度可分离）与朴素参考实现对比
+
+#include <gtest/gtest.h>
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "operators/conv_kernels.h"
+#include "operators/gemm.h"
+#include "operators/prepacked_weights.h"
+#include "operators/quantization_kernels.h"
+#include "operators/simd_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace inferunity;
+using namespace inferunity::operators;
+
+namespace {
+
+struct ConvCase {
+    int64_t batch, in_c, in_h, in_w, out_c, kernel;
+    int64_t stride, pad, dilation, group;
+};
+
+std::shared_ptr<Tensor> RandomTensor(const Shape& shape, uint32_t seed) {
+    auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    float* data = static_cast<float*>(tensor->GetData());
+    uint32_t state = seed;
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = static_cast<float>((state >> 8) & 0xFFFF) / 65535.0f - 0.5f;
+    }
+    return tensor;
+}
+
+// 朴素参考实现（直接按定义计算）
+std::vector<float> ReferenceConv(const ConvCase& c, const float* x, const float* w,
+                                 const float* b, int64_t out_h, int64_t out_w) {
+    const int64_t ic_g = c.in_c / c.group;
+    const int64_t oc_g = c.out_c / c.group;
+    std::vector<float> y(c.batch * c.out_c * out_h * out_w, 0.0f);
+    for (int64_t n = 0; n < c.batch; ++n)
+    for (int64_t oc = 0; oc < c.out_c; ++oc)
+    for (int64_t oh = 0; oh < out_h; ++oh)
+    for (int64_t ow = 0; ow < out_w; ++ow) {
+        const int64_t g = oc / oc_g;
+        float sum = b ? b[oc] : 0.0f;
+        for (int64_t ic = 0; ic < ic_g; ++ic)
+        for (int64_t kh = 0; kh < c.kernel; ++kh)
+        for (int64_t kw = 0; kw < c.kernel; ++kw) {
+            int64_t ih = oh * c.stride - c.pad + kh * c.dilation;
+            int64_t iw = ow * c.stride - c.pad + kw * c.dilation;
+            if (ih < 0 || ih >= c.in_h || iw < 0 || iw >= c.in_w) continue;
+            sum += x[((n * c.in_c + g * ic_g + ic) * c.in_h + ih) * c.in_w + iw] *
+                   w[((oc * ic_g + ic) * c.kernel + kh) * c.kernel + kw];
+        }
+        y[((n * c.out_c + oc) * out_h + oh) * out_w + ow] = sum;
+    }
+    return y;
+}
+
+void RunConvCase(const ConvCase& c, const std::string& algorithm) {
+    auto op = OperatorRegistry::Instance().Create("Conv");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("strides", AttributeValue(std::vector<int64_t>{c.stride, c.stride}));
+    op->SetAttribute("pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad}));
+    op->SetAttribute("dilations", AttributeValue(std::vector<int64_t>{c.dilation, c.dilation}));
+    op->SetAttribute("group", AttributeValue(c.group));
+    op->SetAttribute("conv_algorithm", AttributeValue(algorithm));
+    
+    auto x = RandomTensor(Shape({c.batch, c.in_c, c.in_h, c.in_w}), 1);
+    auto w = RandomTensor(Shape({c.out_c, c.in_c / c.group, c.kernel, c.kernel}), 2);
+    auto b = RandomTensor(Shape({c.out_c}), 3);
+    
+    std::vector<Tensor*> inputs = {x.get(), w.get(), b.get()};
+    std::vector<Shape> output_shapes;
+    ASSERT_TRUE(op->InferOutputShape(inputs, output_shapes).IsOk());
+    ASSERT_EQ(output_shapes.size(), 1u);
+    const Shape& out_shape = output_shapes[0];
+    
+    auto y = CreateTensor(out_shape, DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> outputs = {y.get()};
+    ExecutionContext ctx;
+    // 执行两次：第二次走缓存的内核
+    for (int run = 0; run < 2; ++run) {
+        ASSERT_TRUE(op->Execute(inputs, outputs, &ctx).IsOk());
+    }
+    
+    auto expected = ReferenceConv(c, static_cast<const float*>(x->GetData()),
+                                  static_cast<const float*>(w->GetData()),
+                                  static_cast<const float*>(b->GetData()),
+                                  out_shape.dims[2], out_shape.dims[3]);
+    const float* actual = static_cast<const float*>(y->GetData());
+    ASSERT_EQ(expected.size(), y->GetElementCount());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_NEAR(actual[i], expected[i], 1e-3f) << algorithm << " mismatch at " << i;
+    }
+}
+
+// 按属性创建并执行一个算子，返回第一个输出
+std::shared_ptr<Tensor> RunOperator(const std::string& op_type,
+                                    const std::vector<std::pair<std::string, AttributeValue>>& attrs,
+                                    const std::vector<Tensor*>& inputs) {
+    auto op = OperatorRegistry::Instance().Create(op_type);
+    if (!op) return nullptr;
+    for (const auto& attr : attrs) {
+        op->SetAttribute(attr.first, attr.second);
+    }
+    std::vector<Shape> shapes;
+    if (!op->InferOutputShape(inputs, shapes).IsOk() || shapes.empty()) return nullptr;
+    auto y = CreateTensor(shapes[0], DataType::FLOAT32, DeviceType::CPU);
+    ExecutionContext ctx;
+    if (!op->Execute(inputs, {y.get()}, &ctx).IsOk()) return nullptr;
+    return y;
+}
+
+} // anonymous namespace
+
+TEST(ConvAlgorithmsTest, OutputShapeUsesAttributes) {
+    auto op = OperatorRegistry::Instance().Create("Conv");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("strides", AttributeValue(std::vector<int64_t>{2, 2}));
+    op->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    
+    auto x = CreateTensor(Shape({1, 3, 224, 224}), DataType::FLOAT32, DeviceType::CPU);
+    auto w = CreateTensor(Shape({64, 3, 3, 3}), DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> inputs = {x.get(), w.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, 64, 112, 112}));
+}
+
+TEST(ConvAlgorithmsTest, AutoSelection) {
+    Conv2DParams p;
+    p.batch = 1; p.in_c = 64; p.in_h = p.in_w = 56; p.out_c = 64;
+    p.kernel_h = p.kernel_w = 3; p.out_h = p.out_w = 56;
+    p.pad_top = p.pad_left = p.pad_bottom = p.pad_right = 1;
+    EXPECT_EQ(SelectConvAlgorithm(p), ConvAlgorithm::WINOGRAD_F43);
+    
+    p.in_h = p.in_w = p.out_h = p.out_w = 7;
+    EXPECT_EQ(SelectConvAlgorithm(p), ConvAlgorithm::WINOGRAD_F23);
+    
+    p.stride_h = p.stride_w = 2;
+    EXPECT_EQ(SelectConvAlgorithm(p), ConvAlgorithm::IM2COL_GEMM);
+    
+    p.stride_h = p.stride_w = 1;
+    p.group = 64;
+    EXPECT_EQ(SelectConvAlgorithm(p), ConvAlgorithm::DEPTHWISE);
+    
+    p.group = 1;
+    p.kernel_h = p.kernel_w = 1;
+    p.pad_top = p.pad_left = p.pad_bottom = p.pad_right = 0;
+    EXPECT_EQ(SelectConvAlgorithm(p), ConvAlgorithm::POINTWISE);
+    
+    // 不适用的强制算法回退到自动选择
+    EXPECT_EQ(SelectConvAlgorithm(p, ConvAlgorithm::WINOGRAD_F23), ConvAlgorithm::POINTWISE);
+}
+
+TEST(ConvAlgorithmsTest, Im2colGeneral) {
+    RunConvCase({2, 6, 11, 9, 8, 3, 2, 1, 1, 1}, "im2col");
+    RunConvCase({1, 4, 10, 10, 6, 3, 1, 2, 2, 1}, "im2col");   // 空洞卷积
+    RunConvCase({1, 8, 9, 9, 12, 3, 1, 1, 1, 4}, "im2col");    // 分组卷积
+    RunConvCase({1, 3, 17, 17, 5, 5, 3, 2, 1, 1}, "im2col");
+}
+
+TEST(ConvAlgorithmsTest, Pointwise) {
+    RunConvCase({2, 16, 7, 5, 24, 1, 1, 0, 1, 1}, "pointwise");
+    RunConvCase({1, 8, 6, 6, 8, 1, 1, 0, 1, 2}, "pointwise");
+}
+
+TEST(ConvAlgorithmsTest, WinogradF23) {
+    RunConvCase({1, 8, 9, 11, 16, 3, 1, 1, 1, 1}, "winograd_f23");
+    RunConvCase({2, 3, 6, 6, 4, 3, 1, 0, 1, 1}, "winograd_f23");
+}
+
+TEST(ConvAlgorithmsTest, WinogradF43) {
+    RunConvCase({1, 16, 20, 18, 16, 3, 1, 1, 1, 1}, "winograd_f43");
+    RunConvCase({1, 4, 13, 7, 5, 3, 1, 0, 1, 1}, "winograd_f43");
+}
+
+TEST(ConvAlgorithmsTest, Depthwise) {
+    RunConvCase({1, 16, 14, 14, 16, 3, 1, 1, 1, 16}, "depthwise");
+    RunConvCase({2, 8, 15, 15, 8, 3, 2, 1, 1, 8}, "depthwise");
+    RunConvCase({1, 4, 12, 12, 4, 5, 1, 4, 2, 4}, "depthwise");
+    RunConvCase({1, 6, 19, 37, 6, 5, 2, 2, 1, 6}, "depthwise");    // 5x5 stride 2，行宽覆盖向量主循环
+    RunConvCase({1, 3, 9, 40, 3, 3, 1, 1, 1, 3}, "depthwise");
+    RunConvCase({2, 8, 11, 13, 16, 3, 2, 1, 1, 8}, "depthwise");   // 通道乘数2
+    RunConvCase({1, 8, 11, 13, 24, 3, 1, 0, 1, 8}, "auto");
+}
+
+TEST(ConvAlgorithmsTest, FusedDepthwisePointwiseMatchesReference) {
+    struct FusedCase {
+        ConvCase dw;
+        int64_t out_c;
+        bool dw_bias, pw_bias;
+    };
+    // 第一组的中间结果超过一带的工作区，按多带计算
+    const FusedCase cases[] = {
+        {{1, 32, 40, 40, 64, 3, 1, 1, 1, 32}, 24, true, true},
+        {{2, 8, 23, 21, 8, 3, 2, 1, 1, 8}, 12, false, false},
+        {{1, 6, 15, 15, 12, 5, 2, 2, 1, 6}, 5, true, false},
+    };
+    for (const FusedCase& f : cases) {
+        const ConvCase& c = f.dw;
+        auto x = RandomTensor(Shape({c.batch, c.in_c, c.in_h, c.in_w}), 11);
+        auto dw_w = RandomTensor(Shape({c.out_c, 1, c.kernel, c.kernel}), 12);
+        auto dw_b = RandomTensor(Shape({c.out_c}), 13);
+        auto pw_w = RandomTensor(Shape({f.out_c, c.out_c, 1, 1}), 14);
+        auto pw_b = RandomTensor(Shape({f.out_c}), 15);
+        std::vector<Tensor*> inputs = {x.get(), dw_w.get()};
+        std::vector<int64_t> slots = {0, 1};
+        if (f.dw_bias) {
+            inputs.push_back(dw_b.get());
+            slots.push_back(2);
+        }
+        inputs.push_back(pw_w.get());
+        slots.push_back(3);
+        if (f.pw_bias) {
+            inputs.push_back(pw_b.get());
+            slots.push_back(4);
+        }
+        auto y = RunOperator("FusedDepthwisePointwise",
+                             {{"strides", AttributeValue(std::vector<int64_t>{c.stride, c.stride})},
+                              {"pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad})},
+                              {"group", AttributeValue(c.group)},
+                              {"input_slots", AttributeValue(slots)},
+                              {"dw_activation", AttributeValue(std::string("relu"))},
+                              {"activation", AttributeValue(std::string("relu"))}},
+                             inputs);
+        ASSERT_NE(y, nullptr);
+        const int64_t out_h = (c.in_h + 2 * c.pad - c.kernel) / c.stride + 1;
+        const int64_t out_w = (c.in_w + 2 * c.pad - c.kernel) / c.stride + 1;
+        ASSERT_EQ(y->GetShape().dims, (std::vector<int64_t>{c.batch, f.out_c, out_h, out_w}));
+    
+        std::vector<float> mid = ReferenceConv(c, static_cast<const float*>(x->GetData()),
+                                               static_cast<const float*>(dw_w->GetData()),
+                                               f.dw_bias ? static_cast<const float*>(dw_b->GetData()) : nullptr,
+                                               out_h, out_w);
+        for (float& v : mid) {
+            v = std::max(v, 0.0f);
+        }
+        const ConvCase pw = {c.batch, c.out_c, out_h, out_w, f.out_c, 1, 1, 0, 1, 1};
+        std::vector<float> expected = ReferenceConv(pw, mid.data(), static_cast<const float*>(pw_w->GetData()),
+                                                    f.pw_bias ? static_cast<const float*>(pw_b->GetData()) : nullptr,
+                                                    out_h, out_w);
+        const float* actual = static_cast<const float*>(y->GetData());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_NEAR(actual[i], std::max(expected[i], 0.0f), 1e-3f) << "mismatch at " << i;
+        }
+    }
+}
+
+TEST(ConvAlgorithmsTest, AutoMatchesReference) {
+    RunConvCase({1, 32, 24, 24, 32, 3, 1, 1, 1, 1}, "auto");
+    RunConvCase({1, 32, 8, 8, 32, 3, 1, 1, 1, 32}, "auto");
+}
+
+TEST(ConvAlgorithmsTest, PrePackedWeightsSharedAcrossInstances) {
+    // 两个算子实例持有内容相同的不同权重张量（相当于两个会话各自加载同一模型）
+    const ConvCase c = {1, 16, 20, 18, 16, 3, 1, 1, 1, 1};
+    auto x = RandomTensor(Shape({c.batch, c.in_c, c.in_h, c.in_w}), 1);
+    auto b = RandomTensor(Shape({c.out_c}), 3);
+    const std::vector<std::string> algorithms = {"winograd_f43", "im2col"};
+    for (const auto& algorithm : algorithms) {
+        std::vector<std::shared_ptr<Tensor>> weights;
+        std::vector<std::unique_ptr<Operator>> ops;
+        const size_t hits_before = PrepackedWeightCache::Instance().GetHitCount();
+        for (int instance = 0; instance < 2; ++instance) {
+            auto op = OperatorRegistry::Instance().Create("Conv");
+            ASSERT_NE(op, nullptr);
+            op->SetAttribute("pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad}));
+            op->SetAttribute("conv_algorithm", AttributeValue(algorithm));
+            auto w = RandomTensor(Shape({c.out_c, c.in_c, c.kernel, c.kernel}), 2);
+            bool is_packed = false;
+            ASSERT_TRUE(op->PrePack(1, *w, {x->GetShape(), w->GetShape(), b->GetShape()},
+                                    &is_packed).IsOk());
+            // GEMM打包只在使用内置GEMM时进行；Winograd变换总是预先完成
+            const bool expect_packed = algorithm != "im2col" || !gemm::UsesExternalBlas();
+            EXPECT_EQ(is_packed, expect_packed) << algorithm;
+            weights.push_back(w);
+            ops.push_back(std::move(op));
+        }
+        const bool expect_packed = algorithm != "im2col" || !gemm::UsesExternalBlas();
+        if (expect_packed) {
+            EXPECT_GT(PrepackedWeightCache::Instance().GetHitCount(), hits_before) << algorithm;
+            EXPECT_GE(PrepackedWeightCache::Instance().GetLiveEntryCount(), 1u);
+        }
+    
+        for (size_t instance = 0; instance < ops.size(); ++instance) {
+            std::vector<Tensor*> inputs = {x.get(), weights[instance].get(), b.get()};
+            std::vector<Shape> output_shapes;
+            ASSERT_TRUE(ops[instance]->InferOutputShape(inputs, output_shapes).IsOk());
+            auto y = CreateTensor(output_shapes[0], DataType::FLOAT32, DeviceType::CPU);
+            std::vector<Tensor*> outputs = {y.get()};
+            ExecutionContext ctx;
+            ASSERT_TRUE(ops[instance]->Execute(inputs, outputs, &ctx).IsOk());
+            auto expected = ReferenceConv(c, static_cast<const float*>(x->GetData()),
+                                          static_cast<const float*>(weights[instance]->GetData()),
+                                          static_cast<const float*>(b->GetData()),
+                                          output_shapes[0].dims[2], output_shapes[0].dims[3]);
+            const float* actual = static_cast<const float*>(y->GetData());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_NEAR(actual[i], expected[i], 1e-3f) << algorithm << " mismatch at " << i;
+            }
+        }
+    }
+}
+
+// FusedConvBNReLU在Conv没有bias（6个输入）时也应正确取到BN参数
+TEST(ConvAlgorithmsTest, FusedConvBNReLUWithoutBias) {
+    auto op = OperatorRegistry::Instance().Create("FusedConvBNReLU");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    
+    ConvCase c{1, 8, 10, 10, 8, 3, 1, 1, 1, 1};
+    auto x = RandomTensor(Shape({1, 8, 10, 10}), 4);
+    auto w = RandomTensor(Shape({8, 8, 3, 3}), 5);
+    auto scale = RandomTensor(Shape({8}), 6);
+    auto B = RandomTensor(Shape({8}), 7);
+    auto mean = RandomTensor(Shape({8}), 8);
+    auto var = CreateTensor(Shape({8}), DataType::FLOAT32, DeviceType::CPU);
+    var->FillValue(1.0f);
+    
+    std::vector<Tensor*> inputs = {x.get(), w.get(), scale.get(), B.get(), mean.get(), var.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, 8, 10, 10}));
+    
+    auto y = CreateTensor(shapes[0], DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> outputs = {y.get()};
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute(inputs, outputs, &ctx).IsOk());
+    
+    auto conv = ReferenceConv(c, static_cast<const float*>(x->GetData()),
+                              static_cast<const float*>(w->GetData()), nullptr, 10, 10);
+    const float* s = static_cast<const float*>(scale->GetData());
+    const float* b = static_cast<const float*>(B->GetData());
+    const float* m = static_cast<const float*>(mean->GetData());
+    const float* actual = static_cast<const float*>(y->GetData());
+    for (int64_t oc = 0; oc < 8; ++oc) {
+        for (int64_t i = 0; i < 100; ++i) {
+            float v = s[oc] * (conv[oc * 100 + i] - m[oc]) / std::sqrt(1.0f + 1e-5f) + b[oc];
+            ASSERT_NEAR(actual[oc * 100 + i], std::max(v, 0.0f), 1e-3f);
+        }
+    }
+}
+
+// NCHWc分块布局：ReorderInput -> NchwcConv -> ReorderOutput与NCHW参考卷积一致，
+// 覆盖需要补零的通道数、步长、膨胀、无内部像素的窄输入以及融合的残差与ReLU
+TEST(ConvAlgorithmsTest, NchwcConvMatchesReference) {
+    const ConvCase cases[] = {
+        {1, 3, 9, 11, 16, 3, 1, 1, 1, 1},
+        {2, 16, 8, 8, 32, 1, 1, 0, 1, 1},
+        {1, 32, 10, 9, 16, 3, 2, 1, 1, 1},
+        {1, 16, 12, 12, 24, 3, 1, 2, 2, 1},
+        {1, 8, 5, 2, 8, 3, 1, 1, 1, 1},
+    };
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (int64_t block : {8, 16}) {
+            for (const ConvCase& c : cases) {
+                const int64_t out_h = (c.in_h + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+                const int64_t out_w = (c.in_w + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+                auto x = RandomTensor(Shape({c.batch, c.in_c, c.in_h, c.in_w}), 11);
+                auto w = RandomTensor(Shape({c.out_c, c.in_c, c.kernel, c.kernel}), 12);
+                auto b = RandomTensor(Shape({c.out_c}), 13);
+                auto sum = RandomTensor(Shape({c.batch, c.out_c, out_h, out_w}), 14);
+                auto expected = ReferenceConv(c, static_cast<const float*>(x->GetData()),
+                                              static_cast<const float*>(w->GetData()),
+                                              static_cast<const float*>(b->GetData()), out_h, out_w);
+    
+                auto xb = RunOperator("ReorderInput", {{"block_size", AttributeValue(block)}}, {x.get()});
+                auto sumb = RunOperator("ReorderInput", {{"block_size", AttributeValue(block)}}, {sum.get()});
+                ASSERT_NE(xb, nullptr);
+                ASSERT_NE(sumb, nullptr);
+                EXPECT_EQ(xb->GetShape().dims,
+                          (std::vector<int64_t>{c.batch, (c.in_c + block - 1) / block, c.in_h, c.in_w, block}));
+                const std::vector<std::pair<std::string, AttributeValue>> conv_attrs = {
+                    {"strides", AttributeValue(std::vector<int64_t>{c.stride, c.stride})},
+                    {"pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad})},
+                    {"dilations", AttributeValue(std::vector<int64_t>{c.dilation, c.dilation})},
+                };
+                auto fused_attrs = conv_attrs;
+                fused_attrs.emplace_back("fuse_sum", AttributeValue(int64_t(1)));
+                fused_attrs.emplace_back("activation", AttributeValue(std::string("Relu")));
+    
+                for (int fused = 0; fused < 2; ++fused) {
+                    auto yb = fused
+                        ? RunOperator("NchwcConv", fused_attrs, {xb.get(), w.get(), b.get(), sumb.get()})
+                        : RunOperator("NchwcConv", conv_attrs, {xb.get(), w.get(), b.get()});
+                    ASSERT_NE(yb, nullptr);
+                    auto y = RunOperator("ReorderOutput", {{"channels", AttributeValue(c.out_c)}}, {yb.get()});
+                    ASSERT_NE(y, nullptr);
+                    ASSERT_EQ(y->GetElementCount(), expected.size());
+                    const float* actual = static_cast<const float*>(y->GetData());
+                    const float* residual = static_cast<const float*>(sum->GetData());
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        const float ref = fused ? std::max(expected[i] + residual[i], 0.0f) : expected[i];
+                        ASSERT_NEAR(actual[i], ref, 1e-3f)
+                            << isa << " block " << block << " in_c " << c.in_c << " fused " << fused << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 分块池化与NCHW池化一致（含补零通道、pads与ceil_mode）
+TEST(ConvAlgorithmsTest, NchwcPoolMatchesNchw) {
+    auto x = RandomTensor(Shape({2, 12, 9, 10}), 21);
+    const std::vector<std::pair<std::string, AttributeValue>> attrs = {
+        {"kernel_shape", AttributeValue(std::vector<int64_t>{3, 3})},
+        {"strides", AttributeValue(std::vector<int64_t>{2, 2})},
+        {"pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1})},
+        {"ceil_mode", AttributeValue(int64_t(1))},
+    };
+    for (const char* pool : {"MaxPool", "AveragePool"}) {
+        auto expected = RunOperator(pool, attrs, {x.get()});
+        ASSERT_NE(expected, nullptr);
+        EXPECT_EQ(expected->GetShape().dims, (std::vector<int64_t>{2, 12, 5, 6}));
+        auto xb = RunOperator("ReorderInput", {{"block_size", AttributeValue(int64_t(8))}}, {x.get()});
+        ASSERT_NE(xb, nullptr);
+        auto yb = RunOperator(std::string("Nchwc") + pool, attrs, {xb.get()});
+        ASSERT_NE(yb, nullptr);
+        auto y = RunOperator("ReorderOutput", {{"channels", AttributeValue(int64_t(12))}}, {yb.get()});
+        ASSERT_NE(y, nullptr);
+        ASSERT_EQ(y->GetShape().dims, expected->GetShape().dims);
+        const float* actual = static_cast<const float*>(y->GetData());
+        const float* ref = static_cast<const float*>(expected->GetData());
+        for (size_t i = 0; i < y->GetElementCount(); ++i) {
+            ASSERT_NEAR(actual[i], ref[i], 1e-5f) << pool << " at " << i;
+        }
+    }
+}
+
+namespace {
+
+// 按属性创建并执行一个算子，输出类型由算子推断（量化算子的输出为INT8/UINT8）
+std::shared_ptr<Tensor> RunTypedOperator(const std::string& op_type,
+                                         const std::vector<std::pair<std::string, AttributeValue>>& attrs,
+                                         const std::vector<Tensor*>& inputs) {
+    auto op = OperatorRegistry::Instance().Create(op_type);
+    if (!op) return nullptr;
+    for (const auto& attr : attrs) {
+        op->SetAttribute(attr.first, attr.second);
+    }
+    std::vector<Shape> shapes;
+    if (!op->InferOutputShape(inputs, shapes).IsOk() || shapes.empty()) return nullptr;
+    auto y = CreateTensor(shapes[0], op->InferOutputDataType(inputs, 0), DeviceType::CPU);
+    ExecutionContext ctx;
+    if (!op->Execute(inputs, {y.get()}, &ctx).IsOk()) return nullptr;
+    return y;
+}
+
+template<typename T>
+std::shared_ptr<Tensor> QuantizedTensor(const Shape& shape, DataType dtype, const std::vector<T>& values) {
+    auto tensor = CreateTensor(shape, dtype, DeviceType::CPU);
+    std::copy(values.begin(), values.end(), static_cast<T*>(tensor->GetData()));
+    return tensor;
+}
+
+template<typename T>
+std::vector<T> RandomIntegers(size_t count, int lo, int hi, uint32_t seed) {
+    std::vector<T> values(count);
+    uint32_t state = seed;
+    for (T& v : values) {
+        state = state * 1664525u + 1013904223u;
+        v = static_cast<T>(lo + static_cast<int>((state >> 8) % static_cast<uint32_t>(hi - lo + 1)));
+    }
+    return values;
+}
+
+// 浮点参考结果按输出参数量化
+uint8_t QuantizeReference(float y, float scale, int zero_point, bool relu) {
+    float q = std::nearbyint(y / scale) + static_cast<float>(zero_point);
+    q = std::min(std::max(q, relu ? static_cast<float>(zero_point) : 0.0f), 255.0f);
+    return static_cast<uint8_t>(q);
+}
+
+} // anonymous namespace
+
+// QuantizeLinear/DequantizeLinear：按张量与按通道往返误差不超过半个量化步长，饱和到类型范围
+TEST(ConvAlgorithmsTest, QuantizeDequantizeRoundTrip) {
+    auto x = RandomTensor(Shape({2, 3, 4, 5}), 21);
+    float* data = static_cast<float*>(x->GetData());
+    data[0] = 10.0f;  // 超出范围，饱和
+    auto scale = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {0.004f});
+    auto zp = QuantizedTensor<uint8_t>(Shape({1}), DataType::UINT8, {128});
+    auto q = RunTypedOperator("QuantizeLinear", {}, {x.get(), scale.get(), zp.get()});
+    ASSERT_NE(q, nullptr);
+    ASSERT_EQ(q->GetDataType(), DataType::UINT8);
+    EXPECT_EQ(static_cast<const uint8_t*>(q->GetData())[0], 255);
+    auto y = RunTypedOperator("DequantizeLinear", {}, {q.get(), scale.get(), zp.get()});
+    ASSERT_NE(y, nullptr);
+    ASSERT_EQ(y->GetDataType(), DataType::FLOAT32);
+    const float* out = static_cast<const float*>(y->GetData());
+    for (size_t i = 1; i < x->GetElementCount(); ++i) {
+        ASSERT_NEAR(out[i], data[i], 0.002f + 1e-6f) << "per-tensor at " << i;
+    }
+    
+    auto channel_scale = QuantizedTensor<float>(Shape({3}), DataType::FLOAT32, {0.01f, 0.006f, 0.005f});
+    auto channel_zp = QuantizedTensor<int8_t>(Shape({3}), DataType::INT8, {0, -3, 5});
+    const std::vector<std::pair<std::string, AttributeValue>> axis = {{"axis", AttributeValue(int64_t(1))}};
+    auto qc = RunTypedOperator("QuantizeLinear", axis, {x.get(), channel_scale.get(), channel_zp.get()});
+    ASSERT_NE(qc, nullptr);
+    ASSERT_EQ(qc->GetDataType(), DataType::INT8);
+    auto yc = RunTypedOperator("DequantizeLinear", axis, {qc.get(), channel_scale.get(), channel_zp.get()});
+    ASSERT_NE(yc, nullptr);
+    out = static_cast<const float*>(yc->GetData());
+    const float scales[] = {0.01f, 0.006f, 0.005f};
+    for (size_t i = 1; i < x->GetElementCount(); ++i) {
+        const size_t c = (i / 20) % 3;
+        ASSERT_NEAR(out[i], data[i], scales[c] * 0.5f + 1e-6f) << "per-channel at " << i;
+    }
+}
+
+// QLinearConv与反量化后的浮点卷积再量化的结果相差不超过1（各ISA、分组、按通道权重、ReLU）
+TEST(ConvAlgorithmsTest, QLinearConvMatchesReference) {
+    const ConvCase cases[] = {
+        {1, 3, 9, 11, 8, 3, 1, 1, 1, 1},
+        {2, 8, 6, 6, 16, 1, 1, 0, 1, 1},
+        {1, 4, 10, 9, 6, 3, 2, 1, 2, 2},
+        {1, 5, 7, 7, 3, 3, 1, 1, 1, 1},
+    };
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "avx512_vnni", "amx", "neon", "neon_dot"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (const ConvCase& c : cases) {
+            const int64_t ic_g = c.in_c / c.group;
+            const size_t x_count = c.batch * c.in_c * c.in_h * c.in_w;
+            const size_t w_count = c.out_c * ic_g * c.kernel * c.kernel;
+            const float x_scale = 0.02f, y_scale = 0.05f;
+            const int x_zp = 120, y_zp = 100;
+            auto xq = RandomIntegers<uint8_t>(x_count, 0, 255, 31);
+            auto wq = RandomIntegers<int8_t>(w_count, -127, 127, 32);
+            auto bias = RandomIntegers<int32_t>(c.out_c, -500, 500, 33);
+            std::vector<float> w_scale(c.out_c);
+            for (int64_t oc = 0; oc < c.out_c; ++oc) {
+                w_scale[oc] = 0.001f * static_cast<float>(oc + 1);
+            }
+    
+            std::vector<float> x(x_count), w(w_count), b(c.out_c);
+            for (size_t i = 0; i < x_count; ++i) x[i] = (static_cast<int>(xq[i]) - x_zp) * x_scale;
+            for (size_t i = 0; i < w_count; ++i) w[i] = wq[i] * w_scale[i / (w_count / c.out_c)];
+            for (int64_t oc = 0; oc < c.out_c; ++oc) b[oc] = bias[oc] * x_scale * w_scale[oc];
+            const int64_t out_h = (c.in_h + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+            const int64_t out_w = (c.in_w + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+            auto expected = ReferenceConv(c, x.data(), w.data(), b.data(), out_h, out_w);
+    
+            auto x_t = QuantizedTensor(Shape({c.batch, c.in_c, c.in_h, c.in_w}), DataType::UINT8, xq);
+            auto w_t = QuantizedTensor(Shape({c.out_c, ic_g, c.kernel, c.kernel}), DataType::INT8, wq);
+            auto b_t = QuantizedTensor(Shape({c.out_c}), DataType::INT32, bias);
+            auto xs_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {x_scale});
+            auto xzp_t = QuantizedTensor<uint8_t>(Shape({1}), DataType::UINT8, {static_cast<uint8_t>(x_zp)});
+            auto ws_t = QuantizedTensor(Shape({c.out_c}), DataType::FLOAT32, w_scale);
+            auto wzp_t = QuantizedTensor(Shape({c.out_c}), DataType::INT8, std::vector<int8_t>(c.out_c, 0));
+            auto ys_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {y_scale});
+            auto yzp_t = QuantizedTensor<uint8_t>(Shape({1}), DataType::UINT8, {static_cast<uint8_t>(y_zp)});
+    
+            for (bool relu : {false, true}) {
+                std::vector<std::pair<std::string, AttributeValue>> attrs = {
+                    {"strides", AttributeValue(std::vector<int64_t>{c.stride, c.stride})},
+                    {"pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad})},
+                    {"dilations", AttributeValue(std::vector<int64_t>{c.dilation, c.dilation})},
+                    {"group", AttributeValue(c.group)},
+                };
+                if (relu) {
+                    attrs.emplace_back("activation", AttributeValue(std::string("Relu")));
+                }
+                auto y = RunTypedOperator("QLinearConv", attrs,
+                                          {x_t.get(), xs_t.get(), xzp_t.get(), w_t.get(), ws_t.get(), wzp_t.get(),
+                                           ys_t.get(), yzp_t.get(), b_t.get()});
+                ASSERT_NE(y, nullptr) << isa;
+                ASSERT_EQ(y->GetDataType(), DataType::UINT8);
+                ASSERT_EQ(y->GetElementCount(), expected.size());
+                const uint8_t* actual = static_cast<const uint8_t*>(y->GetData());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    const int ref = QuantizeReference(expected[i], y_scale, y_zp, relu);
+                    ASSERT_LE(std::abs(static_cast<int>(actual[i]) - ref), 1)
+                        << isa << " in_c " << c.in_c << " relu " << relu << " at " << i;
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// QLinearMatMul：INT8激活、按列量化的权重（K为奇数时走补零的配对）
+TEST(ConvAlgorithmsTest, QLinearMatMulMatchesReference) {
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "avx512_vnni", "amx", "neon", "neon_dot"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (int64_t k : {1, 7, 64}) {
+            const int64_t batch = 2, m = 5, n = 19;
+            const float a_scale = 0.03f, y_scale = 0.1f;
+            const int a_zp = -4, y_zp = 3;
+            auto aq = RandomIntegers<int8_t>(batch * m * k, -128, 127, 41);
+            auto bq = RandomIntegers<int8_t>(k * n, -127, 127, 42);
+            std::vector<float> b_scale(n);
+            for (int64_t j = 0; j < n; ++j) {
+                b_scale[j] = 0.002f * static_cast<float>(j % 4 + 1);
+            }
+            auto a_t = QuantizedTensor(Shape({batch, m, k}), DataType::INT8, aq);
+            auto as_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {a_scale});
+            auto azp_t = QuantizedTensor<int8_t>(Shape({1}), DataType::INT8, {static_cast<int8_t>(a_zp)});
+            auto b_t = QuantizedTensor(Shape({k, n}), DataType::INT8, bq);
+            auto bs_t = QuantizedTensor(Shape({n}), DataType::FLOAT32, b_scale);
+            auto bzp_t = QuantizedTensor(Shape({n}), DataType::INT8, std::vector<int8_t>(n, 0));
+            auto ys_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {y_scale});
+            auto yzp_t = QuantizedTensor<int8_t>(Shape({1}), DataType::INT8, {static_cast<int8_t>(y_zp)});
+            auto y = RunTypedOperator("QLinearMatMul", {},
+                                      {a_t.get(), as_t.get(), azp_t.get(), b_t.get(), bs_t.get(), bzp_t.get(),
+                                       ys_t.get(), yzp_t.get()});
+            ASSERT_NE(y, nullptr) << isa;
+            ASSERT_EQ(y->GetDataType(), DataType::INT8);
+            EXPECT_EQ(y->GetShape().dims, (std::vector<int64_t>{batch, m, n}));
+            const int8_t* actual = static_cast<const int8_t*>(y->GetData());
+            for (int64_t row = 0; row < batch * m; ++row) {
+                for (int64_t j = 0; j < n; ++j) {
+                    float sum = 0.0f;
+                    for (int64_t p = 0; p < k; ++p) {
+                        sum += (aq[row * k + p] - a_zp) * a_scale * bq[p * n + j] * b_scale[j];
+                    }
+                    const float q = std::min(std::max(std::nearbyint(sum / y_scale) + y_zp, -128.0f), 127.0f);
+                    ASSERT_LE(std::abs(actual[row * n + j] - static_cast<int>(q)), 1)
+                        << isa << " k " << k << " at " << row << "," << j;
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// u8s8整数GEMM与标量参考逐元素相等：形状覆盖AMX的16x16块、k组余数与行列边缘；
+// maddubs路径（不精确的ISA）的权重限制在相邻两个之和不超过128
+TEST(ConvAlgorithmsTest, QGemmU8S8MatchesReference) {
+    struct GemmCase { size_t m, n, k_quads; };
+    const GemmCase cases[] = {{1, 1, 1}, {3, 5, 2}, {16, 16, 16}, {37, 45, 35}, {20, 70, 40}};
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "avx512_vnni", "amx", "neon", "neon_dot"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        const int limit = simd::QGemmU8S8IsExact() ? 127 : 64;
+        for (const GemmCase& c : cases) {
+            auto a = RandomIntegers<int8_t>(c.m * c.k_quads * 4, -limit, limit, 51);
+            auto b = RandomIntegers<uint8_t>(c.k_quads * c.n * 4, 0, 255, 52);
+            std::vector<int32_t> a_quads(c.m * c.k_quads);
+            std::copy(a.begin(), a.end(), reinterpret_cast<int8_t*>(a_quads.data()));
+            std::vector<int32_t> out(c.m * c.n, -1);
+            simd::QGemmU8S8SIMD(a_quads.data(), b.data(), c.n, out.data(), c.n, c.m, c.n, c.k_quads);
+            for (size_t i = 0; i < c.m; ++i) {
+                for (size_t j = 0; j < c.n; ++j) {
+                    int32_t expected = 0;
+                    for (size_t k = 0; k < c.k_quads * 4; ++k) {
+                        expected += a[i * c.k_quads * 4 + k] * b[((k / 4) * c.n + j) * 4 + k % 4];
+                    }
+                    ASSERT_EQ(out[i * c.n + j], expected) << isa << " " << c.m << "x" << c.n << "x" << c.k_quads
+                                                          << " at " << i << "," << j;
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 7位权重在所有ISA上都走u8s8；INT8激活（异或0x80）与Clip激活的重新量化截断
+TEST(ConvAlgorithmsTest, QLinearMatMulClipWithReducedRangeWeights) {
+    const int64_t rows = 6, k = 33, n = 21;
+    const float a_scale = 0.05f, b_scale = 0.01f, y_scale = 0.08f;
+    const int a_zp = 7, y_zp = -10;
+    const float clip_min = -1.5f, clip_max = 2.0f;
+    auto aq = RandomIntegers<int8_t>(rows * k, -128, 127, 61);
+    auto bq = RandomIntegers<int8_t>(k * n, -63, 63, 62);
+    auto a_t = QuantizedTensor(Shape({rows, k}), DataType::INT8, aq);
+    auto as_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {a_scale});
+    auto azp_t = QuantizedTensor<int8_t>(Shape({1}), DataType::INT8, {static_cast<int8_t>(a_zp)});
+    auto b_t = QuantizedTensor(Shape({k, n}), DataType::INT8, bq);
+    auto bs_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {b_scale});
+    auto bzp_t = QuantizedTensor<int8_t>(Shape({1}), DataType::INT8, {0});
+    auto ys_t = QuantizedTensor<float>(Shape({1}), DataType::FLOAT32, {y_scale});
+    auto yzp_t = QuantizedTensor<int8_t>(Shape({1}), DataType::INT8, {static_cast<int8_t>(y_zp)});
+    const float q_min = std::nearbyint(clip_min / y_scale) + y_zp;
+    const float q_max = std::nearbyint(clip_max / y_scale) + y_zp;
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "avx512_vnni", "amx", "neon", "neon_dot"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        QLinearMatMulKernel kernel;
+        ASSERT_TRUE(kernel.Prepare(*b_t, bzp_t.get()).IsOk());
+        EXPECT_EQ(kernel.GetFormat(), QGemmFormat::U8S8) << isa;
+    
+        auto y = RunTypedOperator("QLinearMatMul",
+                                  {{"activation", AttributeValue(std::string("Clip"))},
+                                   {"clip_min", AttributeValue(clip_min)},
+                                   {"clip_max", AttributeValue(clip_max)}},
+                                  {a_t.get(), as_t.get(), azp_t.get(), b_t.get(), bs_t.get(), bzp_t.get(),
+                                   ys_t.get(), yzp_t.get()});
+        ASSERT_NE(y, nullptr) << isa;
+        const int8_t* actual = static_cast<const int8_t*>(y->GetData());
+        for (int64_t r = 0; r < rows; ++r) {
+            for (int64_t j = 0; j < n; ++j) {
+                float sum = 0.0f;
+                for (int64_t p = 0; p < k; ++p) {
+                    sum += (aq[r * k + p] - a_zp) * a_scale * bq[p * n + j] * b_scale;
+                }
+                const float q = std::min(std::max(std::nearbyint(sum / y_scale) + y_zp, q_min), q_max);
+                ASSERT_GE(actual[r * n + j], q_min) << isa;
+                ASSERT_LE(actual[r * n + j], q_max) << isa;
+                ASSERT_LE(std::abs(actual[r * n + j] - static_cast<int>(q)), 1) << isa << " at " << r << "," << j;
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+namespace {
+
+struct PoolCase {
+    int64_t kernel, stride, pad;
+    bool ceil_mode, count_include_pad;
+};
+
+// 池化的朴素参考实现（NCHW，pads四边相同）
+std::vector<float> ReferencePool(const Tensor& x, const PoolCase& c, bool max_pool,
+                                 int64_t* out_h, int64_t* out_w) {
+    const auto& d = x.GetShape().dims;
+    const int64_t n = d[0], ch = d[1], h = d[2], w = d[3];
+    auto out_dim = [&](int64_t in) {
+        int64_t span = in + 2 * c.pad - c.kernel;
+        int64_t o = (c.ceil_mode ? (span + c.stride - 1) / c.stride : span / c.stride) + 1;
+        // ceil_mode下最后一个窗口必须从输入或左填充内开始
+        if (c.ceil_mode && (o - 1) * c.stride >= in + c.pad) --o;
+        return o;
+    };
+    *out_h = out_dim(h);
+    *out_w = out_dim(w);
+    const float* in = static_cast<const float*>(x.GetData());
+    std::vector<float> out(static_cast<size_t>(n * ch * *out_h * *out_w));
+    size_t idx = 0;
+    for (int64_t p = 0; p < n * ch; ++p) {
+        const float* plane = in + p * h * w;
+        for (int64_t oh = 0; oh < *out_h; ++oh) {
+            for (int64_t ow = 0; ow < *out_w; ++ow) {
+                float acc = max_pool ? -std::numeric_limits<float>::infinity() : 0.0f;
+                int64_t count = 0;
+                for (int64_t kh = 0; kh < c.kernel; ++kh) {
+                    for (int64_t kw = 0; kw < c.kernel; ++kw) {
+                        int64_t ih = oh * c.stride - c.pad + kh;
+                        int64_t iw = ow * c.stride - c.pad + kw;
+                        if (ih < 0 || ih >= h || iw < 0 || iw >= w) continue;
+                        float v = plane[ih * w + iw];
+                        acc = max_pool ? std::max(acc, v) : acc + v;
+                        ++count;
+                    }
+                }
+                if (!max_pool) {
+                    acc /= static_cast<float>(c.count_include_pad ? c.kernel * c.kernel : count);
+                }
+                out[idx++] = acc;
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<std::pair<std::string, AttributeValue>> PoolAttributes(const PoolCase& c) {
+    return {
+        {"kernel_shape", AttributeValue(std::vector<int64_t>{c.kernel, c.kernel})},
+        {"strides", AttributeValue(std::vector<int64_t>{c.stride, c.stride})},
+        {"pads", AttributeValue(std::vector<int64_t>{c.pad, c.pad, c.pad, c.pad})},
+        {"ceil_mode", AttributeValue(int64_t(c.ceil_mode ? 1 : 0))},
+        {"count_include_pad", AttributeValue(int64_t(c.count_include_pad ? 1 : 0))},
+    };
+}
+
+} // namespace
+
+TEST(ConvAlgorithmsTest, PoolMatchesReference) {
+    const std::vector<PoolCase> cases = {
+        {2, 2, 0, false, false},  // 2x2s2特化
+        {3, 2, 1, true, false},   // 3x3s2特化，带填充与ceil_mode
+        {3, 2, 1, false, true},   // count_include_pad
+        {3, 1, 1, false, false},  // 通用路径
+        {5, 3, 2, true, false},
+    };
+    auto x = RandomTensor(Shape({2, 12, 17, 23}), 31);
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) continue;
+        for (const auto& c : cases) {
+            for (bool max_pool : {true, false}) {
+                int64_t oh = 0, ow = 0;
+                auto ref = ReferencePool(*x, c, max_pool, &oh, &ow);
+                const std::string pool = max_pool ? "MaxPool" : "AveragePool";
+                auto attrs = PoolAttributes(c);
+                auto y = RunOperator(pool, attrs, {x.get()});
+                ASSERT_NE(y, nullptr) << pool;
+                ASSERT_EQ(y->GetShape().dims, (std::vector<int64_t>{2, 12, oh, ow})) << pool << " k" << c.kernel;
+                const float* actual = static_cast<const float*>(y->GetData());
+                for (size_t i = 0; i < ref.size(); ++i) {
+                    ASSERT_NEAR(actual[i], ref[i], 1e-5f) << isa << " " << pool << " k" << c.kernel
+                                                          << "s" << c.stride << " at " << i;
+                }
+                for (int64_t block : {int64_t(8), int64_t(16)}) {
+                    auto xb = RunOperator("ReorderInput", {{"block_size", AttributeValue(block)}}, {x.get()});
+                    ASSERT_NE(xb, nullptr);
+                    auto yb = RunOperator("Nchwc" + pool, attrs, {xb.get()});
+                    ASSERT_NE(yb, nullptr);
+                    auto yn = RunOperator("ReorderOutput", {{"channels", AttributeValue(int64_t(12))}}, {yb.get()});
+                    ASSERT_NE(yn, nullptr);
+                    ASSERT_EQ(yn->GetShape().dims, y->GetShape().dims);
+                    const float* blocked = static_cast<const float*>(yn->GetData());
+                    for (size_t i = 0; i < ref.size(); ++i) {
+                        ASSERT_NEAR(blocked[i], ref[i], 1e-5f) << isa << " Nchwc" << pool << " block "
+                                                               << block << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+TEST(ConvAlgorithmsTest, GlobalPoolMatchesReference) {
+    auto x = RandomTensor(Shape({2, 12, 7, 9}), 37);
+    const float* in = static_cast<const float*>(x->GetData());
+    const int64_t planes = 24, spatial = 63;
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) continue;
+        for (const char* pool : {"GlobalMaxPool", "GlobalAveragePool", "GlobalAvgPool"}) {
+            const bool max_pool = std::string(pool) == "GlobalMaxPool";
+            std::vector<float> ref(planes);
+            for (int64_t p = 0; p < planes; ++p) {
+                float acc = max_pool ? in[p * spatial] : 0.0f;
+                for (int64_t i = 0; i < spatial; ++i) {
+                    float v = in[p * spatial + i];
+                    acc = max_pool ? std::max(acc, v) : acc + v;
+                }
+                ref[p] = max_pool ? acc : acc / static_cast<float>(spatial);
+            }
+            auto y = RunOperator(pool, {}, {x.get()});
+            ASSERT_NE(y, nullptr) << pool;
+            ASSERT_EQ(y->GetShape().dims, (std::vector<int64_t>{2, 12, 1, 1}));
+            const float* actual = static_cast<const float*>(y->GetData());
+            for (int64_t p = 0; p < planes; ++p) {
+                ASSERT_NEAR(actual[p], ref[p], 1e-5f) << isa << " " << pool << " at " << p;
+            }
+            // NCHWc的全局池化直接输出NCHW，不需要ReorderOutput
+            const std::string nchwc = max_pool ? "NchwcGlobalMaxPool" : "NchwcGlobalAveragePool";
+            auto xb = RunOperator("ReorderInput", {{"block_size", AttributeValue(int64_t(8))}}, {x.get()});
+            ASSERT_NE(xb, nullptr);
+            auto yb = RunOperator(nchwc, {{"channels", AttributeValue(int64_t(12))}}, {xb.get()});
+            ASSERT_NE(yb, nullptr) << nchwc;
+            ASSERT_EQ(yb->GetShape().dims, (std::vector<int64_t>{2, 12, 1, 1}));
+            const float* blocked = static_cast<const float*>(yb->GetData());
+            for (int64_t p = 0; p < planes; ++p) {
+                ASSERT_NEAR(blocked[p], ref[p], 1e-5f) << isa << " " << nchwc << " at " << p;
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 深度优先分块：conv3x3+ReLU -> 深度conv3x3 s2 -> MaxPool3x3 s2 -> conv1x1 -> AveragePool，与逐层执行对比。
+// 块行数覆盖单行块、不整除的块与按tile_bytes自动选择
+TEST(ConvAlgorithmsTest, FusedTileGroupMatchesLayerByLayer) {
+    auto x = RandomTensor(Shape({2, 4, 37, 29}), 41);
+    auto w0 = RandomTensor(Shape({8, 4, 3, 3}), 42);
+    auto b0 = RandomTensor(Shape({8}), 43);
+    auto w1 = RandomTensor(Shape({8, 1, 3, 3}), 44);
+    auto w2 = RandomTensor(Shape({6, 8, 1, 1}), 45);
+    auto b2 = RandomTensor(Shape({6}), 46);
+    auto ints = [](std::vector<int64_t> v) { return AttributeValue(v); };
+    
+    auto y0 = RunOperator("FusedConvReLU", {{"pads", ints({1, 1, 1, 1})}}, {x.get(), w0.get(), b0.get()});
+    ASSERT_NE(y0, nullptr);
+    auto y1 = RunOperator("Conv", {{"strides", ints({2, 2})}, {"pads", ints({1, 1, 1, 1})},
+                                   {"group", AttributeValue(int64_t(8))}}, {y0.get(), w1.get()});
+    ASSERT_NE(y1, nullptr);
+    auto y2 = RunOperator("MaxPool", {{"kernel_shape", ints({3, 3})}, {"strides", ints({2, 2})},
+                                      {"pads", ints({1, 0, 1, 0})}}, {y1.get()});
+    ASSERT_NE(y2, nullptr);
+    auto y3 = RunOperator("Conv", {}, {y2.get(), w2.get(), b2.get()});
+    ASSERT_NE(y3, nullptr);
+    auto expected = RunOperator("AveragePool", {{"kernel_shape", ints({3, 2})}, {"pads", ints({1, 0, 1, 1})}},
+                                {y3.get()});
+    ASSERT_NE(expected, nullptr);
+    
+    const std::vector<std::pair<std::string, AttributeValue>> stages = {
+        {"stage_types", ints({0, 0, 1, 0, 2})},
+        {"stage_kernels", ints({3, 3, 3, 3, 3, 3, 1, 1, 3, 2})},
+        {"stage_strides", ints({1, 1, 2, 2, 2, 2, 1, 1, 1, 1})},
+        {"stage_dilations", ints({1, 1, 1, 1, 1, 1, 1, 1, 1, 1})},
+        {"stage_pads", ints({1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 1})},
+        {"stage_groups", ints({1, 8, 1, 1, 1})},
+        {"stage_has_bias", ints({1, 0, 0, 1, 0})},
+        {"stage_relu", ints({1, 0, 0, 0, 0})},
+        {"stage_count_include_pad", ints({0, 0, 0, 0, 0})},
+    };
+    const std::vector<std::pair<std::string, AttributeValue>> tilings = {
+        {"tile_rows", AttributeValue(int64_t(1))},
+        {"tile_rows", AttributeValue(int64_t(3))},
+        {"tile_bytes", AttributeValue(int64_t(8 * 1024))},
+        {"tile_bytes", AttributeValue(int64_t(1 << 30))},
+    };
+    for (const auto& tiling : tilings) {
+        auto attrs = stages;
+        attrs.push_back(tiling);
+        auto y = RunOperator("FusedTileGroup", attrs,
+                             {x.get(), w0.get(), b0.get(), w1.get(), w2.get(), b2.get()});
+        ASSERT_NE(y, nullptr) << tiling.first;
+        ASSERT_EQ(y->GetShape().dims, expected->GetShape().dims);
+        const float* actual = static_cast<const float*>(y->GetData());
+        const float* reference = static_cast<const float*>(expected->GetData());
+        for (size_t i = 0; i < expected->GetElementCount(); ++i) {
+            ASSERT_NEAR(actual[i], reference[i], 1e-4f) << tiling.first << "=" << tiling.second.ToString()
+                                                        << " at " << i;
+        }
+    }
+}
@@ -0,0 +1,201 @@
+// 协程接口测试（C++20，见coroutine.h）
+// co_await RunCoro在给定的executor上恢复、InlineExecutor在线程池线程上直接恢复、未受理的请求不挂起
+
+#include <gtest/gtest.h>
+#include "inferunity/coroutine.h"
+#include "inferunity/graph.h"
+#include "inferunity/tensor.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace inferunity;
+
+#ifdef INFERUNITY_HAS_COROUTINES
+
+namespace {
+
+// 立即开始、结束后自行销毁的协程
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// 单线程executor：投递的操作按顺序在自己的线程上执行
+class ThreadExecutor {
+public:
+    ThreadExecutor() : thread_([this] { Loop(); }) {}
+    ~ThreadExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    void Post(std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(fn));
+        }
+        cv_.notify_one();
+    }
+
+    std::thread::id GetThreadId() const { return thread_.get_id(); }
+
+private:
+    void Loop() {
+        for (;;) {
+            std::function<void()> fn;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                fn = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            fn();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> queue_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+std::unique_ptr<InferenceSession> CreateReluSession(const SessionOptions& options = SessionOptions()) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({1, 4}), DataType::FLOAT32));
+    auto session = InferenceSession::Create(options);
+    if (!session || !session->LoadModelFromGraph(std::move(graph)).IsOk()) {
+        return nullptr;
+    }
+    return session;
+}
+
+std::shared_ptr<Tensor> MakeInput(float value) {
+    auto tensor = CreateTensor(Shape({1, 4}), DataType::FLOAT32);
+    tensor->FillValue(value);
+    return tensor;
+}
+
+struct CoroOutcome {
+    RunResult result;
+    std::thread::id resumed_on;
+};
+
+template <typename Executor>
+DetachedTask RunOnce(InferenceSession* session, float value, Executor executor, std::promise<CoroOutcome>* done) {
+    // 输入先放进局部变量：GCC 12不接受co_await操作数中的花括号初始化列表
+    std::vector<std::shared_ptr<Tensor>> inputs = {MakeInput(value)};
+    CoroOutcome outcome;
+    outcome.result = co_await session->RunCoro(std::move(inputs), std::move(executor));
+    outcome.resumed_on = std::this_thread::get_id();
+    done->set_value(std::move(outcome));
+}
+
+DetachedTask RunInline(InferenceSession* session, float value, std::promise<CoroOutcome>* done) {
+    std::vector<std::shared_ptr<Tensor>> inputs = {MakeInput(value)};
+    CoroOutcome outcome;
+    outcome.result = co_await session->RunCoro(std::move(inputs));
+    outcome.resumed_on = std::this_thread::get_id();
+    done->set_value(std::move(outcome));
+}
+
+} // anonymous namespace
+
+TEST(CoroutineTest, ResumesOnSuppliedExecutor) {
+    auto session = CreateReluSession();
+    ASSERT_NE(session, nullptr);
+    ThreadExecutor executor;
+
+    std::promise<CoroOutcome> done;
+    auto future = done.get_future();
+    RunOnce(session.get(), -2.0f, [&executor](std::function<void()> fn) { executor.Post(std::move(fn)); }, &done);
+    CoroOutcome outcome = future.get();
+    ASSERT_TRUE(outcome.result.status.IsOk()) << outcome.result.status.Message();
+    EXPECT_EQ(outcome.resumed_on, executor.GetThreadId());
+    ASSERT_EQ(outcome.result.outputs.size(), 1u);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outcome.result.outputs[0]->GetData())[3], 0.0f);
+
+    std::promise<CoroOutcome> second;
+    future = second.get_future();
+    RunOnce(session.get(), 1.5f, [&executor](std::function<void()> fn) { executor.Post(std::move(fn)); }, &second);
+    outcome = future.get();
+    ASSERT_TRUE(outcome.result.status.IsOk());
+    EXPECT_EQ(outcome.resumed_on, executor.GetThreadId());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outcome.result.outputs[0]->GetData())[0], 1.5f);
+}
+
+TEST(CoroutineTest, InlineExecutorResumesOnWorker) {
+    auto session = CreateReluSession();
+    ASSERT_NE(session, nullptr);
+
+    std::promise<CoroOutcome> done;
+    auto future = done.get_future();
+    RunInline(session.get(), 3.0f, &done);
+    CoroOutcome outcome = future.get();
+    ASSERT_TRUE(outcome.result.status.IsOk()) << outcome.result.status.Message();
+    ASSERT_EQ(outcome.result.outputs.size(), 1u);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outcome.result.outputs[0]->GetData())[2], 3.0f);
+    // 在完成推理的线程池线程上恢复，而不是发起协程的线程
+    EXPECT_NE(outcome.resumed_on, std::this_thread::get_id());
+}
+
+TEST(CoroutineTest, RejectedRunDoesNotSuspend) {
+    SessionOptions options;
+    options.max_inflight_async_runs = 1;
+    auto session = CreateReluSession(options);
+    ASSERT_NE(session, nullptr);
+
+    // 一个回调阻塞的运行占满在途上限
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> finished;
+    ASSERT_TRUE(session->RunAsync({MakeInput(1.0f)},
+        [released, &finished](Status, std::vector<std::shared_ptr<Tensor>>) {
+            released.wait();
+            finished.set_value();
+        }).IsOk());
+
+    // await_suspend返回false：协程不挂起，在调用线程上同步得到错误
+    std::promise<CoroOutcome> done;
+    auto future = done.get_future();
+    RunOnce(session.get(), 2.0f, InlineExecutor(), &done);
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    CoroOutcome outcome = future.get();
+    EXPECT_EQ(outcome.result.status.Code(), StatusCode::ERROR_RESOURCE_EXHAUSTED);
+    EXPECT_TRUE(outcome.result.outputs.empty());
+    EXPECT_EQ(outcome.resumed_on, std::this_thread::get_id());
+
+    release.set_value();
+    finished.get_future().wait();
+}
+
+#else
+
+TEST(CoroutineTest, DISABLED_RequiresCpp20Coroutines) {}
+
+#endif
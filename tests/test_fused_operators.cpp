@@ -1,13 +1,19 @@
 // 融合算子单元测试
-// 测试FusedConvBNReLU和FusedMatMulAdd
+// 测试FusedConvBNReLU、FusedMatMulAdd及融合Pass生成的其他融合算子
 
 #include <gtest/gtest.h>
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
+#include "inferunity/continuous_batching.h"
+#include "inferunity/float16.h"
+#include "operators/attention.h"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <unordered_map>
 
 using namespace inferunity;
 
@@ -39,11 +45,11 @@ protected:
         const auto& shape_b = b->GetShape();
         if (shape_a.dims != shape_b.dims) return false;
         if (a->GetDataType() != b->GetDataType()) return false;
-        
+    
         size_t count = a->GetElementCount();
         const float* data_a = static_cast<const float*>(a->GetData());
         const float* data_b = static_cast<const float*>(b->GetData());
-        
+    
         for (size_t i = 0; i < count; ++i) {
             if (std::abs(data_a[i] - data_b[i]) > tolerance) {
                 return false;
@@ -181,3 +187,1096 @@ TEST_F(FusedOperatorsTest, OperatorRegistration) {
     EXPECT_EQ(op2->GetName(), "FusedMatMulAdd");
 }
 
+
+// 测试FusedConvReLU/FusedConvAddReLU与Conv + Add + Relu的逐元素结果一致
+TEST_F(FusedOperatorsTest, FusedConvAddReLUMatchesUnfused) {
+    auto conv = OperatorRegistry::Instance().Create("Conv");
+    auto fused_relu = OperatorRegistry::Instance().Create("FusedConvReLU");
+    auto fused_add_relu = OperatorRegistry::Instance().Create("FusedConvAddReLU");
+    ASSERT_NE(conv, nullptr);
+    ASSERT_NE(fused_relu, nullptr);
+    ASSERT_NE(fused_add_relu, nullptr);
+    for (Operator* op : {conv.get(), fused_relu.get(), fused_add_relu.get()}) {
+        op->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    }
+    
+    // input [1, 2, 5, 5], weight [3, 2, 3, 3], bias [3]，输出 [1, 3, 5, 5]
+    std::vector<float> data_input(50), data_weight(54), data_bias = {0.5f, -0.25f, 0.0f};
+    for (size_t i = 0; i < data_input.size(); ++i) data_input[i] = std::sin(0.37f * i);
+    for (size_t i = 0; i < data_weight.size(); ++i) data_weight[i] = std::cos(0.11f * i) * 0.5f;
+    std::vector<float> data_residual(75);
+    for (size_t i = 0; i < data_residual.size(); ++i) data_residual[i] = std::sin(0.53f * i + 1.0f);
+    
+    auto input = CreateTestTensor(Shape({1, 2, 5, 5}), DataType::FLOAT32, data_input);
+    auto weight = CreateTestTensor(Shape({3, 2, 3, 3}), DataType::FLOAT32, data_weight);
+    auto bias = CreateTestTensor(Shape({3}), DataType::FLOAT32, data_bias);
+    auto residual = CreateTestTensor(Shape({1, 3, 5, 5}), DataType::FLOAT32, data_residual);
+    auto reference = CreateTestTensor(Shape({1, 3, 5, 5}), DataType::FLOAT32);
+    auto relu_out = CreateTestTensor(Shape({1, 3, 5, 5}), DataType::FLOAT32);
+    auto add_relu_out = CreateTestTensor(Shape({1, 3, 5, 5}), DataType::FLOAT32);
+    
+    ExecutionContext ctx;
+    ASSERT_TRUE(conv->Execute({input.get(), weight.get(), bias.get()}, {reference.get()}, &ctx).IsOk());
+    ASSERT_TRUE(fused_relu->Execute({input.get(), weight.get(), bias.get()}, {relu_out.get()}, &ctx).IsOk());
+    ASSERT_TRUE(fused_add_relu->Execute({input.get(), weight.get(), bias.get(), residual.get()},
+                                        {add_relu_out.get()}, &ctx).IsOk());
+    
+    const float* ref = static_cast<const float*>(reference->GetData());
+    const float* y_relu = static_cast<const float*>(relu_out->GetData());
+    const float* y_add_relu = static_cast<const float*>(add_relu_out->GetData());
+    for (size_t i = 0; i < reference->GetElementCount(); ++i) {
+        EXPECT_NEAR(y_relu[i], std::max(ref[i], 0.0f), 1e-5f);
+        EXPECT_NEAR(y_add_relu[i], std::max(ref[i] + data_residual[i], 0.0f), 1e-5f);
+    }
+}
+
+// 测试FusedBNReLU：BN结果为负的位置被截断为0，且读取epsilon属性
+TEST_F(FusedOperatorsTest, FusedBNReLU) {
+    auto op = OperatorRegistry::Instance().Create("FusedBNReLU");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("epsilon", AttributeValue(0.0f));
+    
+    auto input = CreateTestTensor(Shape({1, 2, 1, 2}), DataType::FLOAT32, {1.0f, -3.0f, 2.0f, 6.0f});
+    auto scale = CreateTestTensor(Shape({2}), DataType::FLOAT32, {2.0f, 1.0f});
+    auto B = CreateTestTensor(Shape({2}), DataType::FLOAT32, {0.0f, -1.0f});
+    auto mean = CreateTestTensor(Shape({2}), DataType::FLOAT32, {0.0f, 2.0f});
+    auto var = CreateTestTensor(Shape({2}), DataType::FLOAT32, {1.0f, 4.0f});
+    auto output = CreateTestTensor(Shape({1, 2, 1, 2}), DataType::FLOAT32);
+    
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute({input.get(), scale.get(), B.get(), mean.get(), var.get()},
+                            {output.get()}, &ctx).IsOk());
+    const float* y = static_cast<const float*>(output->GetData());
+    EXPECT_FLOAT_EQ(y[0], 2.0f);   // 2 * 1
+    EXPECT_FLOAT_EQ(y[1], 0.0f);   // 2 * -3 -> relu
+    EXPECT_FLOAT_EQ(y[2], 0.0f);   // (2 - 2) / 2 - 1 -> relu
+    EXPECT_FLOAT_EQ(y[3], 1.0f);   // (6 - 2) / 2 - 1
+}
+
+// 测试FusedElementwise：整条链与逐步计算一致（覆盖多个块、标量广播与右操作数步骤）
+TEST_F(FusedOperatorsTest, FusedElementwiseChain) {
+    auto op = OperatorRegistry::Instance().Create("FusedElementwise");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("ops", AttributeValue(std::string("Add,Sigmoid,RSub,Mul,Relu,GeluTanh")));
+    
+    const size_t count = 2500;
+    std::vector<float> data_x(count), data_y(count);
+    for (size_t i = 0; i < count; ++i) {
+        data_x[i] = std::sin(0.01f * i) * 4.0f;
+        data_y[i] = std::cos(0.02f * i);
+    }
+    auto x = CreateTestTensor(Shape({1, static_cast<int64_t>(count)}), DataType::FLOAT32, data_x);
+    auto y = CreateTestTensor(Shape({1, static_cast<int64_t>(count)}), DataType::FLOAT32, data_y);
+    auto one = CreateTestTensor(Shape({1}), DataType::FLOAT32, {1.0f});
+    auto three = CreateTestTensor(Shape({1}), DataType::FLOAT32, {3.0f});
+    auto output = CreateTestTensor(Shape({1, static_cast<int64_t>(count)}), DataType::FLOAT32);
+    
+    ExecutionContext ctx;
+    // ((1 - sigmoid(x + y)) * 3) -> relu -> gelu(tanh)
+    ASSERT_TRUE(op->ValidateInputs({x.get(), y.get(), one.get(), three.get()}).IsOk());
+    ASSERT_TRUE(op->Execute({x.get(), y.get(), one.get(), three.get()}, {output.get()}, &ctx).IsOk());
+    
+    const float* out = static_cast<const float*>(output->GetData());
+    for (size_t i = 0; i < count; ++i) {
+        float v = (1.0f - 1.0f / (1.0f + std::exp(-(data_x[i] + data_y[i])))) * 3.0f;
+        v = std::max(v, 0.0f);
+        v = 0.5f * v * (1.0f + std::tanh(0.7978845608f * (v + 0.044715f * v * v * v)));
+        EXPECT_NEAR(out[i], v, 1e-4f) << "i=" << i;
+    }
+    
+    // 操作数个数与ops不一致时报错
+    auto bad = OperatorRegistry::Instance().Create("FusedElementwise");
+    bad->SetAttribute("ops", AttributeValue(std::string("Add,Mul")));
+    EXPECT_FALSE(bad->Execute({x.get(), y.get()}, {output.get()}, &ctx).IsOk());
+}
+
+// 测试FusedElementwise的广播操作数、"@k"引用与Exp/Sqrt/Min/RDiv步骤：
+// y = min(sqrt(exp(x) * row), 2) / x，row为[N]沿[M, N]广播，col为[M, 1]
+TEST_F(FusedOperatorsTest, FusedElementwiseBroadcastOperands) {
+    auto op = OperatorRegistry::Instance().Create("FusedElementwise");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("ops", AttributeValue(std::string("Exp,Mul,Sqrt,Min,Div@0,Sub")));
+    
+    const int64_t m = 37, n = 129;
+    std::vector<float> data_x(m * n), data_row(n), data_col(m);
+    for (int64_t i = 0; i < m * n; ++i) data_x[i] = 1.0f + 0.5f * std::sin(0.01f * i);
+    for (int64_t j = 0; j < n; ++j) data_row[j] = 1.0f + 0.03f * j;
+    for (int64_t r = 0; r < m; ++r) data_col[r] = 0.1f * r;
+    auto x = CreateTestTensor(Shape({m, n}), DataType::FLOAT32, data_x);
+    auto row = CreateTestTensor(Shape({n}), DataType::FLOAT32, data_row);
+    auto two = CreateTestTensor(Shape({1}), DataType::FLOAT32, {2.0f});
+    auto col = CreateTestTensor(Shape({m, 1}), DataType::FLOAT32, data_col);
+    auto output = CreateTestTensor(Shape({m, n}), DataType::FLOAT32);
+    
+    ExecutionContext ctx;
+    IntraOpParallelism intra_op;
+    intra_op.num_threads = 4;
+    intra_op.min_work_per_thread = 1000;
+    ctx.SetIntraOpParallelism(intra_op);
+    ASSERT_TRUE(op->Execute({x.get(), row.get(), two.get(), col.get()}, {output.get()}, &ctx).IsOk());
+    const float* out = static_cast<const float*>(output->GetData());
+    for (int64_t r = 0; r < m; ++r) {
+        for (int64_t j = 0; j < n; ++j) {
+            const float xv = data_x[r * n + j];
+            const float v = std::min(std::sqrt(std::exp(xv) * data_row[j]), 2.0f) / xv - data_col[r];
+            EXPECT_NEAR(out[r * n + j], v, 1e-4f) << "r=" << r << " j=" << j;
+        }
+    }
+    
+    // [M, 1, 1]沿后两维广播可以执行；非1维不连续的操作数与越界的"@k"报错
+    auto channel = CreateTestTensor(Shape({m, 1, 1}), DataType::FLOAT32, data_col);
+    auto x3 = CreateTestTensor(Shape({m, 3, 43}), DataType::FLOAT32, data_x);
+    auto mul = OperatorRegistry::Instance().Create("FusedElementwise");
+    mul->SetAttribute("ops", AttributeValue(std::string("Mul")));
+    ASSERT_TRUE(mul->Execute({x3.get(), channel.get()}, {output.get()}, &ctx).IsOk());
+    EXPECT_FLOAT_EQ(out[5 * 129 + 7], data_x[5 * 129 + 7] * data_col[5]);
+    auto gap = CreateTestTensor(Shape({m, 1, 43}), DataType::FLOAT32, std::vector<float>(m * 43, 1.0f));
+    auto bad2 = OperatorRegistry::Instance().Create("FusedElementwise");
+    bad2->SetAttribute("ops", AttributeValue(std::string("Mul")));
+    EXPECT_FALSE(bad2->Execute({x3.get(), gap.get()}, {output.get()}, &ctx).IsOk());
+    auto bad3 = OperatorRegistry::Instance().Create("FusedElementwise");
+    bad3->SetAttribute("ops", AttributeValue(std::string("Add@2")));
+    EXPECT_FALSE(bad3->Execute({x.get()}, {output.get()}, &ctx).IsOk());
+}
+
+// 测试FusedMatMulAdd的activation属性（MatMul+Add+GELU融合）
+TEST_F(FusedOperatorsTest, FusedMatMulAddActivation) {
+    auto op = OperatorRegistry::Instance().Create("FusedMatMulAdd");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("activation", AttributeValue(std::string("gelu")));
+    
+    // A [2, 2] = I，B [2, 2]，bias [2]：输出为gelu(B + bias)
+    auto A = CreateTestTensor(Shape({2, 2}), DataType::FLOAT32, {1.0f, 0.0f, 0.0f, 1.0f});
+    auto B = CreateTestTensor(Shape({2, 2}), DataType::FLOAT32, {-2.0f, 0.5f, 1.0f, 3.0f});
+    auto bias = CreateTestTensor(Shape({2}), DataType::FLOAT32, {0.5f, -0.5f});
+    auto output = CreateTestTensor(Shape({2, 2}), DataType::FLOAT32);
+    
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute({A.get(), B.get(), bias.get()}, {output.get()}, &ctx).IsOk());
+    const float expected_pre[] = {-1.5f, 0.0f, 1.5f, 2.5f};
+    const float* out = static_cast<const float*>(output->GetData());
+    for (int i = 0; i < 4; ++i) {
+        const float x = expected_pre[i];
+        EXPECT_NEAR(out[i], 0.5f * x * (1.0f + std::erf(x / std::sqrt(2.0f))), 1e-4f);
+    }
+}
+
+namespace {
+
+// 朴素注意力参考实现：物化[S, T]分数矩阵；K/V头按GQA共享，rope为空时不做旋转
+void NaiveAttention(const std::vector<float>& q, const std::vector<float>& k,
+                    const std::vector<float>& v, const std::vector<float>* mask,
+                    int64_t B, int64_t Hq, int64_t Hkv, int64_t S, int64_t T, int64_t D,
+                    float scale, bool causal, std::vector<float>* out) {
+    out->assign(B * Hq * S * D, 0.0f);
+    std::vector<float> scores(T);
+    for (int64_t b = 0; b < B; ++b) {
+        for (int64_t h = 0; h < Hq; ++h) {
+            const int64_t kv = b * Hkv + h / (Hq / Hkv);
+            for (int64_t i = 0; i < S; ++i) {
+                float max_score = -INFINITY;
+                for (int64_t j = 0; j < T; ++j) {
+                    float s = 0.0f;
+                    for (int64_t d = 0; d < D; ++d) {
+                        s += q[((b * Hq + h) * S + i) * D + d] * k[(kv * T + j) * D + d];
+                    }
+                    s *= scale;
+                    if (mask) s += (*mask)[(b * S + i) * T + j];  // mask [B, 1, S, T]
+                    if (causal && j > i + T - S) s = -INFINITY;
+                    scores[j] = s;
+                    max_score = std::max(max_score, s);
+                }
+                float sum = 0.0f;
+                for (int64_t j = 0; j < T; ++j) {
+                    scores[j] = std::exp(scores[j] - max_score);
+                    sum += scores[j];
+                }
+                for (int64_t j = 0; j < T; ++j) {
+                    for (int64_t d = 0; d < D; ++d) {
+                        (*out)[((b * Hq + h) * S + i) * D + d] += scores[j] / sum * v[(kv * T + j) * D + d];
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<float> PseudoRandom(size_t count, uint32_t seed) {
+    std::vector<float> data(count);
+    for (auto& x : data) {
+        seed = seed * 1664525u + 1013904223u;
+        x = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * 2.0f - 1.0f;
+    }
+    return data;
+}
+
+} // anonymous namespace
+
+// 测试Gemm：各种transA/transB、alpha/beta与C的广播形状下与朴素实现一致，预打包的B与fused activation结果相同
+TEST_F(FusedOperatorsTest, GemmMatchesNaive) {
+    const int64_t M = 37, N = 45, K = 29;
+    const std::vector<float> a = PseudoRandom(M * K, 1);
+    const std::vector<float> b = PseudoRandom(K * N, 2);
+    const std::vector<float> c = PseudoRandom(M * N, 3);
+    struct Case {
+        bool trans_a, trans_b;
+        float alpha, beta;
+        std::vector<int64_t> c_dims;  // 空为没有C
+        std::string activation;
+        bool prepack;
+    };
+    const std::vector<Case> cases = {
+        {false, false, 1.0f, 1.0f, {N}, "", false},
+        {false, true, 1.0f, 1.0f, {1, N}, "relu", true},
+        {true, false, 0.5f, 1.0f, {M, 1}, "", false},
+        {true, true, 2.0f, 0.25f, {M, N}, "gelu", true},
+        {false, true, 1.5f, -1.0f, {N}, "", true},
+        {false, false, 1.0f, 3.0f, {1}, "relu", false},
+        {true, false, 1.0f, 0.5f, {M, 1}, "", true},
+        {false, false, 0.75f, 1.0f, {}, "", true},
+    };
+    for (const Case& t : cases) {
+        // op(A)[m, k] = A[k, m]（transA）或A[m, k]；B同理
+        auto A = CreateTestTensor(t.trans_a ? Shape({K, M}) : Shape({M, K}), DataType::FLOAT32, a);
+        auto B = CreateTestTensor(t.trans_b ? Shape({N, K}) : Shape({K, N}), DataType::FLOAT32, b);
+        int64_t c_count = 1;
+        for (int64_t d : t.c_dims) c_count *= d;
+        auto C = CreateTestTensor(Shape(t.c_dims), DataType::FLOAT32, c);
+    
+        auto op = OperatorRegistry::Instance().Create("Gemm");
+        ASSERT_NE(op, nullptr);
+        op->SetAttribute("transA", AttributeValue(static_cast<int64_t>(t.trans_a)));
+        op->SetAttribute("transB", AttributeValue(static_cast<int64_t>(t.trans_b)));
+        op->SetAttribute("alpha", AttributeValue(t.alpha));
+        op->SetAttribute("beta", AttributeValue(t.beta));
+        if (!t.activation.empty()) {
+            op->SetAttribute("activation", AttributeValue(t.activation));
+        }
+        std::vector<Tensor*> inputs = {A.get(), B.get()};
+        if (!t.c_dims.empty()) inputs.push_back(C.get());
+        if (t.prepack) {
+            bool packed = false;
+            ASSERT_TRUE(op->PrePack(1, *B, {A->GetShape(), B->GetShape()}, &packed).IsOk());
+        }
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+        ASSERT_EQ(shapes[0].dims, std::vector<int64_t>({M, N}));
+        auto output = CreateTestTensor(shapes[0], DataType::FLOAT32);
+        ExecutionContext ctx;
+        ASSERT_TRUE(op->Execute(inputs, {output.get()}, &ctx).IsOk());
+        const float* out = static_cast<const float*>(output->GetData());
+        for (int64_t m = 0; m < M; ++m) {
+            for (int64_t n = 0; n < N; ++n) {
+                float sum = 0.0f;
+                for (int64_t k = 0; k < K; ++k) {
+                    sum += a[t.trans_a ? k * M + m : m * K + k] * b[t.trans_b ? n * K + k : k * N + n];
+                }
+                float expected = t.alpha * sum;
+                if (c_count == M * N) expected += t.beta * c[m * N + n];
+                else if (c_count == N) expected += t.beta * c[n];
+                else if (!t.c_dims.empty() && t.c_dims.back() == 1 && c_count == M) expected += t.beta * c[m];
+                else if (!t.c_dims.empty()) expected += t.beta * c[0];
+                if (t.activation == "relu") expected = std::max(expected, 0.0f);
+                if (t.activation == "gelu") expected = 0.5f * expected * (1.0f + std::erf(expected / std::sqrt(2.0f)));
+                ASSERT_NEAR(out[m * N + n], expected, 1e-4f)
+                    << "transA=" << t.trans_a << " transB=" << t.trans_b << " at " << m << "," << n;
+            }
+        }
+    }
+    
+    // C不能单向广播到[M, N]
+    auto op = OperatorRegistry::Instance().Create("Gemm");
+    auto A = CreateTestTensor(Shape({M, K}), DataType::FLOAT32, a);
+    auto B = CreateTestTensor(Shape({K, N}), DataType::FLOAT32, b);
+    auto C = CreateTestTensor(Shape({M}), DataType::FLOAT32, c);
+    auto output = CreateTestTensor(Shape({M, N}), DataType::FLOAT32);
+    EXPECT_FALSE(op->Execute({A.get(), B.get(), C.get()}, {output.get()}, nullptr).IsOk());
+}
+
+// 测试FusedAttention：分块在线softmax与朴素实现一致（GQA、causal、加性mask，跨越多个Br/Bc分块）
+TEST_F(FusedOperatorsTest, FusedAttentionMatchesNaive) {
+    const int64_t B = 2, Hq = 4, Hkv = 2, S = 37, T = 101, D = 16;
+    const auto q = PseudoRandom(B * Hq * S * D, 1);
+    const auto k = PseudoRandom(B * Hkv * T * D, 2);
+    const auto v = PseudoRandom(B * Hkv * T * D, 3);
+    auto mask = PseudoRandom(B * S * T, 4);
+    for (int64_t i = 0; i < S; ++i) {
+        mask[i * T + 5] = -INFINITY;  // 第0个样本屏蔽第5个键（padding）
+    }
+    auto Q = CreateTestTensor(Shape({B, Hq, S, D}), DataType::FLOAT32, q);
+    auto K = CreateTestTensor(Shape({B, Hkv, T, D}), DataType::FLOAT32, k);
+    auto V = CreateTestTensor(Shape({B, Hkv, T, D}), DataType::FLOAT32, v);
+    auto M = CreateTestTensor(Shape({B, 1, S, T}), DataType::FLOAT32, mask);
+    
+    for (bool causal : {false, true}) {
+        for (bool with_mask : {false, true}) {
+            auto op = OperatorRegistry::Instance().Create("FusedAttention");
+            ASSERT_NE(op, nullptr);
+            op->SetAttribute("causal", AttributeValue(static_cast<int64_t>(causal)));
+            std::vector<Tensor*> inputs = {Q.get(), K.get(), V.get()};
+            if (with_mask) inputs.push_back(M.get());
+    
+            std::vector<Shape> shapes;
+            ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+            EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{B, Hq, S, D}));
+            auto output = CreateTestTensor(shapes[0], DataType::FLOAT32);
+            ExecutionContext ctx;
+            ASSERT_TRUE(op->Execute(inputs, {output.get()}, &ctx).IsOk());
+    
+            std::vector<float> expected;
+            NaiveAttention(q, k, v, with_mask ? &mask : nullptr, B, Hq, Hkv, S, T, D,
+                           1.0f / std::sqrt(static_cast<float>(D)), causal, &expected);
+            const float* out = static_cast<const float*>(output->GetData());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_NEAR(out[i], expected[i], 1e-4f) << "causal=" << causal << " mask=" << with_mask;
+            }
+        }
+    }
+}
+
+// 测试FusedAttention的rotary输入：等价于先对Q/K做RoPE（NeoX半分布局）再做注意力
+TEST_F(FusedOperatorsTest, FusedAttentionRotary) {
+    const int64_t S = 3, T = 5, D = 8, P = 8;
+    const auto q = PseudoRandom(S * D, 5);
+    const auto k = PseudoRandom(T * D, 6);
+    const auto v = PseudoRandom(T * D, 7);
+    std::vector<float> cos_table(P * D / 2), sin_table(P * D / 2);
+    for (int64_t p = 0; p < P; ++p) {
+        for (int64_t i = 0; i < D / 2; ++i) {
+            const float theta = p * std::pow(10000.0f, -2.0f * i / D);
+            cos_table[p * D / 2 + i] = std::cos(theta);
+            sin_table[p * D / 2 + i] = std::sin(theta);
+        }
+    }
+    auto rotate = [&](const std::vector<float>& x, int64_t rows, int64_t first_pos) {
+        std::vector<float> y(x.size());
+        for (int64_t r = 0; r < rows; ++r) {
+            const int64_t p = first_pos + r;
+            for (int64_t i = 0; i < D / 2; ++i) {
+                const float c = cos_table[p * D / 2 + i], s = sin_table[p * D / 2 + i];
+                const float x0 = x[r * D + i], x1 = x[r * D + i + D / 2];
+                y[r * D + i] = x0 * c - x1 * s;
+                y[r * D + i + D / 2] = x1 * c + x0 * s;
+            }
+        }
+        return y;
+    };
+    
+    auto op = OperatorRegistry::Instance().Create("FusedAttention");
+    ASSERT_NE(op, nullptr);
+    op->SetAttribute("rotary", AttributeValue(static_cast<int64_t>(1)));
+    op->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+    auto Q = CreateTestTensor(Shape({1, S, D}), DataType::FLOAT32, q);
+    auto K = CreateTestTensor(Shape({1, T, D}), DataType::FLOAT32, k);
+    auto V = CreateTestTensor(Shape({1, T, D}), DataType::FLOAT32, v);
+    auto Cos = CreateTestTensor(Shape({P, D / 2}), DataType::FLOAT32, cos_table);
+    auto Sin = CreateTestTensor(Shape({P, D / 2}), DataType::FLOAT32, sin_table);
+    auto output = CreateTestTensor(Shape({1, S, D}), DataType::FLOAT32);
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute({Q.get(), K.get(), V.get(), Cos.get(), Sin.get()},
+                            {output.get()}, &ctx).IsOk());
+    
+    // 查询位置从T - S开始（KV cache场景）
+    std::vector<float> expected;
+    NaiveAttention(rotate(q, S, T - S), rotate(k, T, 0), v, nullptr, 1, 1, 1, S, T, D,
+                   1.0f / std::sqrt(static_cast<float>(D)), true, &expected);
+    const float* out = static_cast<const float*>(output->GetData());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(out[i], expected[i], 1e-4f);
+    }
+    
+    // 表长度不足以覆盖全部位置时报错
+    auto ShortCos = CreateTestTensor(Shape({2, D / 2}), DataType::FLOAT32, cos_table);
+    auto ShortSin = CreateTestTensor(Shape({2, D / 2}), DataType::FLOAT32, sin_table);
+    EXPECT_FALSE(op->Execute({Q.get(), K.get(), V.get(), ShortCos.get(), ShortSin.get()},
+                             {output.get()}, &ctx).IsOk());
+}
+
+// 测试RotaryEmbedding：与HuggingFace的x * cos + rotate_half(x) * sin一致（[P, D]表、逐样本的position_ids、原地执行）
+TEST_F(FusedOperatorsTest, RotaryEmbeddingMatchesRotateHalf) {
+    const int64_t B = 2, H = 3, S = 4, D = 8, P = 16;
+    std::vector<float> cos_table(P * D), sin_table(P * D);
+    for (int64_t p = 0; p < P; ++p) {
+        for (int64_t i = 0; i < D; ++i) {
+            const float theta = p * std::pow(10000.0f, -2.0f * (i % (D / 2)) / D);
+            cos_table[p * D + i] = std::cos(theta);
+            sin_table[p * D + i] = std::sin(theta);
+        }
+    }
+    const auto x = PseudoRandom(B * H * S * D, 11);
+    auto X = CreateTestTensor(Shape({B, H, S, D}), DataType::FLOAT32, x);
+    auto positions = CreateTensor(Shape({B, S}), DataType::INT64, DeviceType::CPU);
+    int64_t* pos = static_cast<int64_t*>(positions->GetData());
+    for (int64_t i = 0; i < B * S; ++i) {
+        pos[i] = (i / S) * 7 + i % S;  // 第1个样本从位置7开始
+    }
+    auto Cos = CreateTestTensor(Shape({P, D}), DataType::FLOAT32, cos_table);
+    auto Sin = CreateTestTensor(Shape({P, D}), DataType::FLOAT32, sin_table);
+    
+    auto op = OperatorRegistry::Instance().Create("RotaryEmbedding");
+    ASSERT_NE(op, nullptr);
+    EXPECT_EQ(op->GetInPlaceInput(), 0);
+    const std::vector<Tensor*> inputs = {X.get(), positions.get(), Cos.get(), Sin.get()};
+    ASSERT_TRUE(op->ValidateInputs(inputs).IsOk());
+    auto output = CreateTestTensor(X->GetShape(), DataType::FLOAT32);
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute(inputs, {output.get()}, &ctx).IsOk());
+    const float* out = static_cast<const float*>(output->GetData());
+    for (int64_t r = 0; r < B * H * S; ++r) {
+        const int64_t p = pos[(r / (H * S)) * S + r % S];
+        for (int64_t i = 0; i < D; ++i) {
+            const float rotated = i < D / 2 ? -x[r * D + i + D / 2] : x[r * D + i - D / 2];
+            const float expected = x[r * D + i] * cos_table[p * D + i] + rotated * sin_table[p * D + i];
+            ASSERT_NEAR(out[r * D + i], expected, 1e-5f);
+        }
+    }
+    
+    // 原地执行得到相同结果
+    ASSERT_TRUE(op->Execute(inputs, {X.get()}, &ctx).IsOk());
+    EXPECT_TRUE(CompareTensors(X.get(), output.get(), 0.0f));
+    
+    // 位置超出表长时报错
+    pos[0] = P;
+    EXPECT_FALSE(op->Execute(inputs, {output.get()}, &ctx).IsOk());
+}
+
+// 测试SwiGLU：silu(x * Wg) * (x * Wu)，覆盖按列切分（行少）与整行GEMM（行多、预打包权重）两种分块
+TEST_F(FusedOperatorsTest, SwiGLUMatchesUnfused) {
+    const int64_t K = 24, N = 300;
+    const auto w = PseudoRandom(K * 2 * N, 12);
+    auto W = CreateTestTensor(Shape({K, 2 * N}), DataType::FLOAT32, w);
+    for (int64_t M : {int64_t(1), int64_t(37), int64_t(130)}) {
+        for (bool prepack : {false, true}) {
+            const auto x = PseudoRandom(M * K, 13);
+            auto X = CreateTestTensor(Shape({1, M, K}), DataType::FLOAT32, x);
+            auto op = OperatorRegistry::Instance().Create("SwiGLU");
+            ASSERT_NE(op, nullptr);
+            const std::vector<Tensor*> inputs = {X.get(), W.get()};
+            ASSERT_TRUE(op->ValidateInputs(inputs).IsOk());
+            std::vector<Shape> shapes;
+            ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+            EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, M, N}));
+            if (prepack) {
+                bool is_packed = false;
+                ASSERT_TRUE(op->PrePack(1, *W, {X->GetShape(), W->GetShape()}, &is_packed).IsOk());
+            }
+            auto output = CreateTestTensor(shapes[0], DataType::FLOAT32);
+            ExecutionContext ctx;
+            ASSERT_TRUE(op->Execute(inputs, {output.get()}, &ctx).IsOk());
+            const float* out = static_cast<const float*>(output->GetData());
+            for (int64_t m = 0; m < M; ++m) {
+                for (int64_t n = 0; n < N; ++n) {
+                    float gate = 0.0f, up = 0.0f;
+                    for (int64_t k = 0; k < K; ++k) {
+                        gate += x[m * K + k] * w[k * 2 * N + n];
+                        up += x[m * K + k] * w[k * 2 * N + N + n];
+                    }
+                    const float expected = gate / (1.0f + std::exp(-gate)) * up;
+                    ASSERT_NEAR(out[m * N + n], expected, 1e-4f) << "M=" << M << " prepack=" << prepack;
+                }
+            }
+        }
+    }
+    
+    // 权重须为[K, 2N]
+    auto odd = CreateTestTensor(Shape({K, 3}), DataType::FLOAT32);
+    auto X = CreateTestTensor(Shape({2, K}), DataType::FLOAT32);
+    auto op = OperatorRegistry::Instance().Create("SwiGLU");
+    EXPECT_FALSE(op->ValidateInputs({X.get(), odd.get()}).IsOk());
+}
+
+// 测试FusedAttention的kv_cache模式：分两次追加（含RoPE、causal、GQA）与一次性计算完整序列一致
+TEST_F(FusedOperatorsTest, FusedAttentionKVCacheAppend) {
+    const int64_t Hq = 4, Hkv = 2, T = 6, D = 8, capacity = 8;
+    const auto q = PseudoRandom(Hq * T * D, 11);
+    const auto k = PseudoRandom(Hkv * T * D, 12);
+    const auto v = PseudoRandom(Hkv * T * D, 13);
+    std::vector<float> cos_table(capacity * D / 2), sin_table(capacity * D / 2);
+    for (size_t i = 0; i < cos_table.size(); ++i) {
+        cos_table[i] = std::cos(0.1f * i);
+        sin_table[i] = std::sin(0.1f * i);
+    }
+    auto Cos = CreateTestTensor(Shape({capacity, D / 2}), DataType::FLOAT32, cos_table);
+    auto Sin = CreateTestTensor(Shape({capacity, D / 2}), DataType::FLOAT32, sin_table);
+    auto make_op = [](bool kv_cache) {
+        auto op = OperatorRegistry::Instance().Create("FusedAttention");
+        op->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+        op->SetAttribute("rotary", AttributeValue(static_cast<int64_t>(1)));
+        op->SetAttribute("kv_cache", AttributeValue(static_cast<int64_t>(kv_cache)));
+        return op;
+    };
+    // 取每个头的[begin, end)位置
+    auto slice = [&](const std::vector<float>& x, int64_t heads, int64_t begin, int64_t end) {
+        std::vector<float> y;
+        for (int64_t h = 0; h < heads; ++h) {
+            y.insert(y.end(), x.begin() + (h * T + begin) * D, x.begin() + (h * T + end) * D);
+        }
+        return y;
+    };
+    
+    ExecutionContext ctx;
+    auto full_op = make_op(false);
+    auto Q = CreateTestTensor(Shape({1, Hq, T, D}), DataType::FLOAT32, q);
+    auto K = CreateTestTensor(Shape({1, Hkv, T, D}), DataType::FLOAT32, k);
+    auto V = CreateTestTensor(Shape({1, Hkv, T, D}), DataType::FLOAT32, v);
+    auto expected = CreateTestTensor(Shape({1, Hq, T, D}), DataType::FLOAT32);
+    ASSERT_TRUE(full_op->Execute({Q.get(), K.get(), V.get(), Cos.get(), Sin.get()},
+                                 {expected.get()}, &ctx).IsOk());
+    
+    auto cache_op = make_op(true);
+    auto cache_k = CreateTestTensor(Shape({1, Hkv, capacity, D}), DataType::FLOAT32);
+    auto cache_v = CreateTestTensor(Shape({1, Hkv, capacity, D}), DataType::FLOAT32);
+    auto lengths = inferunity::CreateTensor(Shape({1}), DataType::INT64, DeviceType::CPU);
+    lengths->FillZero();
+    const float* ref = static_cast<const float*>(expected->GetData());
+    for (auto range : {std::make_pair<int64_t, int64_t>(0, 4), std::make_pair<int64_t, int64_t>(4, 6)}) {
+        const int64_t S = range.second - range.first;
+        auto q_step = CreateTestTensor(Shape({1, Hq, S, D}), DataType::FLOAT32,
+                                       slice(q, Hq, range.first, range.second));
+        auto k_step = CreateTestTensor(Shape({1, Hkv, S, D}), DataType::FLOAT32,
+                                       slice(k, Hkv, range.first, range.second));
+        auto v_step = CreateTestTensor(Shape({1, Hkv, S, D}), DataType::FLOAT32,
+                                       slice(v, Hkv, range.first, range.second));
+        auto output = CreateTestTensor(Shape({1, Hq, S, D}), DataType::FLOAT32);
+        ASSERT_TRUE(cache_op->Execute({q_step.get(), k_step.get(), v_step.get(), cache_k.get(),
+                                       cache_v.get(), lengths.get(), Cos.get(), Sin.get()},
+                                      {output.get()}, &ctx).IsOk());
+        EXPECT_EQ(static_cast<const int64_t*>(lengths->GetData())[0], range.second);
+        const float* out = static_cast<const float*>(output->GetData());
+        for (int64_t h = 0; h < Hq; ++h) {
+            for (int64_t i = 0; i < S * D; ++i) {
+                EXPECT_NEAR(out[h * S * D + i], ref[(h * T + range.first) * D + i], 1e-4f);
+            }
+        }
+    }
+    
+    // 超出缓冲容量时报错
+    auto q_big = CreateTestTensor(Shape({1, Hq, 3, D}), DataType::FLOAT32, q);
+    auto k_big = CreateTestTensor(Shape({1, Hkv, 3, D}), DataType::FLOAT32, k);
+    auto v_big = CreateTestTensor(Shape({1, Hkv, 3, D}), DataType::FLOAT32, v);
+    auto output = CreateTestTensor(Shape({1, Hq, 3, D}), DataType::FLOAT32);
+    EXPECT_FALSE(cache_op->Execute({q_big.get(), k_big.get(), v_big.get(), cache_k.get(),
+                                    cache_v.get(), lengths.get(), Cos.get(), Sin.get()},
+                                   {output.get()}, &ctx).IsOk());
+}
+
+// 测试PagedAttention：长度不同的序列通过块表读取键值，结果与连续存储的FusedAttention一致
+TEST_F(FusedOperatorsTest, PagedAttentionMatchesContiguous) {
+    const int64_t Hq = 4, Hkv = 2, D = 8;
+    PagedKVCacheOptions options;
+    options.block_size = 4;
+    PagedKVCache cache(options);
+    ASSERT_TRUE(cache.AddLayer(Hkv, D, D).IsOk());
+    
+    // 两个序列共享前5个位置（system prompt），之后各自解码
+    const int64_t prompt = 5;
+    const auto prompt_q = PseudoRandom(Hq * prompt * D, 21);
+    const auto prompt_k = PseudoRandom(Hkv * prompt * D, 22);
+    const auto prompt_v = PseudoRandom(Hkv * prompt * D, 23);
+    ASSERT_TRUE(cache.AddSequence(0).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(0, prompt).IsOk());
+    auto q0 = CreateTestTensor(Shape({1, Hq, prompt, D}), DataType::FLOAT32, prompt_q);
+    auto k0 = CreateTestTensor(Shape({1, Hkv, prompt, D}), DataType::FLOAT32, prompt_k);
+    auto v0 = CreateTestTensor(Shape({1, Hkv, prompt, D}), DataType::FLOAT32, prompt_v);
+    auto out0 = CreateTestTensor(Shape({1, Hq, prompt, D}), DataType::FLOAT32);
+    ExecutionContext ctx;
+    attention::PagedAttentionOptions attention_options;
+    ASSERT_TRUE(attention::PagedAttention(cache, 0, {0}, *q0, *k0, *v0, out0.get(),
+                                          attention_options, &ctx).IsOk());
+    ASSERT_TRUE(cache.Fork(0, 1).IsOk());
+    
+    // 每个序列的完整键值（按头连续），用于连续存储的参考计算
+    std::vector<std::vector<float>> keys(2, prompt_k), values(2, prompt_v);
+    std::vector<int64_t> lengths = {prompt, prompt};
+    auto append = [&](std::vector<float>& full, const std::vector<float>& step, int64_t length) {
+        std::vector<float> merged;
+        for (int64_t h = 0; h < Hkv; ++h) {
+            merged.insert(merged.end(), full.begin() + h * length * D, full.begin() + (h + 1) * length * D);
+            merged.insert(merged.end(), step.begin() + h * D, step.begin() + (h + 1) * D);
+        }
+        full.swap(merged);
+    };
+    
+    // 序列1比序列0多解码2步，使两者长度不同且跨越块边界
+    for (int step = 0; step < 6; ++step) {
+        std::vector<int64_t> active = step < 2 ? std::vector<int64_t>{1} : std::vector<int64_t>{0, 1};
+        const int64_t B = static_cast<int64_t>(active.size());
+        const auto q = PseudoRandom(B * Hq * D, 100 + step);
+        const auto k = PseudoRandom(B * Hkv * D, 200 + step);
+        const auto v = PseudoRandom(B * Hkv * D, 300 + step);
+        for (int64_t seq : active) {
+            ASSERT_TRUE(cache.AppendSlots(seq, 1).IsOk());
+        }
+        auto tq = CreateTestTensor(Shape({B, Hq, 1, D}), DataType::FLOAT32, q);
+        auto tk = CreateTestTensor(Shape({B, Hkv, 1, D}), DataType::FLOAT32, k);
+        auto tv = CreateTestTensor(Shape({B, Hkv, 1, D}), DataType::FLOAT32, v);
+        auto output = CreateTestTensor(Shape({B, Hq, 1, D}), DataType::FLOAT32);
+        ASSERT_TRUE(attention::PagedAttention(cache, 0, active, *tq, *tk, *tv, output.get(),
+                                              attention_options, &ctx).IsOk());
+    
+        for (int64_t b = 0; b < B; ++b) {
+            const int64_t seq = active[b];
+            append(keys[seq], std::vector<float>(k.begin() + b * Hkv * D, k.begin() + (b + 1) * Hkv * D),
+                   lengths[seq]);
+            append(values[seq], std::vector<float>(v.begin() + b * Hkv * D, v.begin() + (b + 1) * Hkv * D),
+                   lengths[seq]);
+            ++lengths[seq];
+            EXPECT_EQ(cache.GetSequenceLength(seq), lengths[seq]);
+    
+            auto op = OperatorRegistry::Instance().Create("FusedAttention");
+            op->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+            auto rq = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32,
+                                       std::vector<float>(q.begin() + b * Hq * D, q.begin() + (b + 1) * Hq * D));
+            auto rk = CreateTestTensor(Shape({1, Hkv, lengths[seq], D}), DataType::FLOAT32, keys[seq]);
+            auto rv = CreateTestTensor(Shape({1, Hkv, lengths[seq], D}), DataType::FLOAT32, values[seq]);
+            auto expected = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32);
+            ASSERT_TRUE(op->Execute({rq.get(), rk.get(), rv.get()}, {expected.get()}, &ctx).IsOk());
+            const float* out = static_cast<const float*>(output->GetData()) + b * Hq * D;
+            const float* ref = static_cast<const float*>(expected->GetData());
+            for (int64_t i = 0; i < Hq * D; ++i) {
+                EXPECT_NEAR(out[i], ref[i], 1e-4f) << "step " << step << " seq " << seq;
+            }
+        }
+    }
+    // 前缀块仍被两个序列共享
+    EXPECT_EQ(cache.GetBlockTable(0)[0], cache.GetBlockTable(1)[0]);
+    
+    // 未预留位置时报错
+    auto tq = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32);
+    auto tk = CreateTestTensor(Shape({1, Hkv, 1, D}), DataType::FLOAT32);
+    auto output = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32);
+    ASSERT_TRUE(cache.AddSequence(5).IsOk());
+    EXPECT_FALSE(attention::PagedAttention(cache, 0, {5}, *tq, *tk, *tk, output.get(),
+                                           attention_options, &ctx).IsOk());
+}
+
+// 测试长上下文的单token解码：键值切成几段分给线程、按log-sum-exp合并，
+// 连续与分页KV cache上的结果都与直接计算一致
+TEST_F(FusedOperatorsTest, DecodeAttentionSplitsLongContext) {
+    const int64_t Hq = 2, Hkv = 1, D = 16, past = 1500, capacity = 1600;
+    const int64_t total = past + 1;
+    const auto keys = PseudoRandom(Hkv * total * D, 31);  // [Hkv, total, D]，最后一个位置为本次的新键
+    const auto values = PseudoRandom(Hkv * total * D, 32);
+    const auto q = PseudoRandom(Hq * D, 33);
+    std::vector<float> expected(Hq * D, 0.0f);
+    const double scale = 1.0 / std::sqrt(static_cast<double>(D));
+    for (int64_t h = 0; h < Hq; ++h) {
+        const int64_t kv = h / (Hq / Hkv);
+        std::vector<double> scores(total);
+        double max_score = -std::numeric_limits<double>::infinity();
+        for (int64_t j = 0; j < total; ++j) {
+            double dot = 0.0;
+            for (int64_t d = 0; d < D; ++d) {
+                dot += static_cast<double>(q[h * D + d]) * keys[(kv * total + j) * D + d];
+            }
+            scores[j] = dot * scale;
+            max_score = std::max(max_score, scores[j]);
+        }
+        double sum = 0.0;
+        std::vector<double> out(D, 0.0);
+        for (int64_t j = 0; j < total; ++j) {
+            const double w = std::exp(scores[j] - max_score);
+            sum += w;
+            for (int64_t d = 0; d < D; ++d) {
+                out[d] += w * values[(kv * total + j) * D + d];
+            }
+        }
+        for (int64_t d = 0; d < D; ++d) {
+            expected[h * D + d] = static_cast<float>(out[d] / sum);
+        }
+    }
+    // 取每个头[begin, end)位置的键值
+    auto positions = [&](const std::vector<float>& x, int64_t begin, int64_t end) {
+        std::vector<float> y;
+        for (int64_t h = 0; h < Hkv; ++h) {
+            y.insert(y.end(), x.begin() + (h * total + begin) * D, x.begin() + (h * total + end) * D);
+        }
+        return y;
+    };
+    
+    ExecutionContext ctx;
+    IntraOpParallelism intra_op;
+    intra_op.num_threads = 8;
+    intra_op.min_work_per_thread = 1000;
+    ctx.SetIntraOpParallelism(intra_op);
+    auto tq = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32, q);
+    auto tk = CreateTestTensor(Shape({1, Hkv, 1, D}), DataType::FLOAT32, positions(keys, past, total));
+    auto tv = CreateTestTensor(Shape({1, Hkv, 1, D}), DataType::FLOAT32, positions(values, past, total));
+    
+    // 连续KV cache：前past个位置预先写入缓冲
+    auto op = OperatorRegistry::Instance().Create("FusedAttention");
+    op->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+    op->SetAttribute("kv_cache", AttributeValue(static_cast<int64_t>(1)));
+    auto cache_k = CreateTestTensor(Shape({1, Hkv, capacity, D}), DataType::FLOAT32);
+    auto cache_v = CreateTestTensor(Shape({1, Hkv, capacity, D}), DataType::FLOAT32);
+    for (int64_t h = 0; h < Hkv; ++h) {
+        std::memcpy(static_cast<float*>(cache_k->GetData()) + h * capacity * D, keys.data() + h * total * D,
+                    past * D * sizeof(float));
+        std::memcpy(static_cast<float*>(cache_v->GetData()) + h * capacity * D, values.data() + h * total * D,
+                    past * D * sizeof(float));
+    }
+    auto lengths = inferunity::CreateTensor(Shape({1}), DataType::INT64, DeviceType::CPU);
+    static_cast<int64_t*>(lengths->GetData())[0] = past;
+    auto output = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32);
+    ASSERT_TRUE(op->Execute({tq.get(), tk.get(), tv.get(), cache_k.get(), cache_v.get(), lengths.get()},
+                            {output.get()}, &ctx).IsOk());
+    const float* out = static_cast<const float*>(output->GetData());
+    for (int64_t i = 0; i < Hq * D; ++i) {
+        EXPECT_NEAR(out[i], expected[i], 1e-4f) << "contiguous at " << i;
+    }
+    
+    // 分页KV cache：prefill前past个位置后解码一步，键值跨越多个物理块
+    PagedKVCache cache;
+    ASSERT_TRUE(cache.AddLayer(Hkv, D, D).IsOk());
+    ASSERT_TRUE(cache.AddSequence(0).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(0, past).IsOk());
+    auto pq = CreateTestTensor(Shape({1, Hq, past, D}), DataType::FLOAT32, PseudoRandom(Hq * past * D, 34));
+    auto pk = CreateTestTensor(Shape({1, Hkv, past, D}), DataType::FLOAT32, positions(keys, 0, past));
+    auto pv = CreateTestTensor(Shape({1, Hkv, past, D}), DataType::FLOAT32, positions(values, 0, past));
+    auto prefill = CreateTestTensor(Shape({1, Hq, past, D}), DataType::FLOAT32);
+    attention::PagedAttentionOptions options;
+    ASSERT_TRUE(attention::PagedAttention(cache, 0, {0}, *pq, *pk, *pv, prefill.get(), options, &ctx).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(0, 1).IsOk());
+    ASSERT_TRUE(attention::PagedAttention(cache, 0, {0}, *tq, *tk, *tv, output.get(), options, &ctx).IsOk());
+    for (int64_t i = 0; i < Hq * D; ++i) {
+        EXPECT_NEAR(out[i], expected[i], 1e-4f) << "paged at " << i;
+    }
+}
+
+TEST_F(FusedOperatorsTest, QuantizedKVCacheMatchesFloat) {
+    // FP8 E4M3：除NaN外的全部编码都能精确往返，超出范围饱和到±448
+    for (int code = 0; code < 256; ++code) {
+        if ((code & 0x7F) == 0x7F) {
+            EXPECT_TRUE(std::isnan(Fp8E4M3ToFloat(static_cast<uint8_t>(code))));
+            continue;
+        }
+        EXPECT_EQ(FloatToFp8E4M3(Fp8E4M3ToFloat(static_cast<uint8_t>(code))), code) << "code " << code;
+    }
+    EXPECT_EQ(Fp8E4M3ToFloat(FloatToFp8E4M3(1000.0f)), kFp8E4M3Max);
+    EXPECT_EQ(Fp8E4M3ToFloat(FloatToFp8E4M3(-1000.0f)), -kFp8E4M3Max);
+    
+    // prefill 40个位置后解码一步，量化存储的输出与FP32存储的一致（量化误差内）
+    const int64_t Hq = 4, Hkv = 2, D = 32, prefill = 40;
+    auto run = [&](KVCacheStorage storage, std::vector<float>* decode_out, size_t* block_bytes) {
+        PagedKVCacheOptions cache_options;
+        cache_options.storage = storage;
+        PagedKVCache cache(cache_options);
+        ASSERT_TRUE(cache.AddLayer(Hkv, D, D).IsOk());
+        ASSERT_TRUE(cache.AddSequence(0).IsOk());
+        *block_bytes = cache.GetBlockBytes();
+        attention::PagedAttentionOptions options;
+        ASSERT_TRUE(cache.AppendSlots(0, prefill).IsOk());
+        auto q = CreateTestTensor(Shape({1, Hq, prefill, D}), DataType::FLOAT32, PseudoRandom(Hq * prefill * D, 41));
+        auto k = CreateTestTensor(Shape({1, Hkv, prefill, D}), DataType::FLOAT32, PseudoRandom(Hkv * prefill * D, 42));
+        auto v = CreateTestTensor(Shape({1, Hkv, prefill, D}), DataType::FLOAT32, PseudoRandom(Hkv * prefill * D, 43));
+        auto o = CreateTestTensor(Shape({1, Hq, prefill, D}), DataType::FLOAT32);
+        ASSERT_TRUE(attention::PagedAttention(cache, 0, {0}, *q, *k, *v, o.get(), options, nullptr).IsOk());
+        ASSERT_TRUE(cache.AppendSlots(0, 1).IsOk());
+        auto dq = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32, PseudoRandom(Hq * D, 44));
+        auto dk = CreateTestTensor(Shape({1, Hkv, 1, D}), DataType::FLOAT32, PseudoRandom(Hkv * D, 45));
+        auto dv = CreateTestTensor(Shape({1, Hkv, 1, D}), DataType::FLOAT32, PseudoRandom(Hkv * D, 46));
+        auto dout = CreateTestTensor(Shape({1, Hq, 1, D}), DataType::FLOAT32);
+        ASSERT_TRUE(attention::PagedAttention(cache, 0, {0}, *dq, *dk, *dv, dout.get(), options, nullptr).IsOk());
+        const float* out = static_cast<const float*>(dout->GetData());
+        decode_out->assign(out, out + Hq * D);
+    };
+    std::vector<float> reference, int8_out, fp8_out;
+    size_t float_bytes = 0, int8_bytes = 0, fp8_bytes = 0;
+    run(KVCacheStorage::FLOAT32, &reference, &float_bytes);
+    run(KVCacheStorage::INT8, &int8_out, &int8_bytes);
+    run(KVCacheStorage::FP8_E4M3, &fp8_out, &fp8_bytes);
+    EXPECT_LT(int8_bytes * 3, float_bytes);
+    EXPECT_EQ(fp8_bytes, int8_bytes);
+    for (int64_t i = 0; i < Hq * D; ++i) {
+        EXPECT_NEAR(int8_out[i], reference[i], 2e-2f) << "int8 at " << i;
+        EXPECT_NEAR(fp8_out[i], reference[i], 8e-2f) << "fp8 at " << i;
+    }
+}
+
+namespace {
+
+// 单层注意力的玩具语言模型：token嵌入直接作为Q/K/V（K叠加位置），在分页KV cache上执行打包注意力，
+// 下一个token取输出与各嵌入内积最大者
+class TinyPagedModel {
+public:
+    static constexpr int64_t kVocab = 16, kHq = 2, kHkv = 1, kDim = 8;
+    
+    explicit TinyPagedModel(PagedKVCache* cache) : cache_(cache), embedding_(PseudoRandom(kVocab * kDim, 7)) {}
+    
+    Status Step(const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+        const int64_t T = static_cast<int64_t>(batch.GetNumTokens());
+        auto q = CreateTensor(Shape({1, kHq, T, kDim}), DataType::FLOAT32, DeviceType::CPU);
+        auto k = CreateTensor(Shape({1, kHkv, T, kDim}), DataType::FLOAT32, DeviceType::CPU);
+        auto v = CreateTensor(Shape({1, kHkv, T, kDim}), DataType::FLOAT32, DeviceType::CPU);
+        auto o = CreateTensor(Shape({1, kHq, T, kDim}), DataType::FLOAT32, DeviceType::CPU);
+        float* qd = static_cast<float*>(q->GetData());
+        float* kd = static_cast<float*>(k->GetData());
+        float* vd = static_cast<float*>(v->GetData());
+        for (int64_t t = 0; t < T; ++t) {
+            const float* e = embedding_.data() + batch.tokens[t] * kDim;
+            for (int64_t d = 0; d < kDim; ++d) {
+                for (int64_t h = 0; h < kHq; ++h) {
+                    qd[(h * T + t) * kDim + d] = e[d] * static_cast<float>(h + 1);
+                }
+                kd[t * kDim + d] = e[d] + 0.05f * static_cast<float>(batch.positions[t] % 5);
+                vd[t * kDim + d] = e[d];
+            }
+        }
+        ExecutionContext ctx;
+        Status status = attention::PagedAttentionPacked(*cache_, 0, batch.sequences, batch.query_offsets,
+                                                        *q, *k, *v, o.get(), attention::PagedAttentionOptions(),
+                                                        &ctx);
+        if (!status.IsOk()) {
+            return status;
+        }
+        const float* od = static_cast<const float*>(o->GetData());
+        for (size_t b = 0; b < batch.sequences.size(); ++b) {
+            const int64_t last = batch.query_offsets[b + 1] - 1;
+            float best = -std::numeric_limits<float>::infinity();
+            for (int32_t token = 0; token < kVocab; ++token) {
+                float score = 0.0f;
+                for (int64_t d = 0; d < kDim; ++d) {
+                    const float mixed = od[last * kDim + d] + od[(T + last) * kDim + d];
+                    score += mixed * embedding_[token * kDim + d];
+                }
+                if (score > best) {
+                    best = score;
+                    (*sampled)[b] = token;
+                }
+            }
+        }
+        return Status::Ok();
+    }
+
+private:
+    PagedKVCache* cache_;
+    std::vector<float> embedding_;
+};
+
+std::vector<GenerationRequest> TinyRequests() {
+    std::vector<GenerationRequest> requests;
+    for (int64_t id = 0; id < 5; ++id) {
+        GenerationRequest request;
+        request.id = id;
+        for (int64_t i = 0; i < 3 + id * 2 + (id % 2); ++i) {
+            request.prompt.push_back(static_cast<int32_t>((id * 5 + i * 3) % TinyPagedModel::kVocab));
+        }
+        request.max_new_tokens = 2 + id;
+        requests.push_back(request);
+    }
+    return requests;
+}
+
+} // anonymous namespace
+
+// 测试迭代级批处理：prefill分块与解码token打包在同一步，KV块不足时换出后重新计算，
+// 每个请求的生成结果与单独执行时相同
+TEST_F(FusedOperatorsTest, ContinuousBatchingMatchesSequential) {
+    using Model = TinyPagedModel;
+    std::unordered_map<int64_t, std::vector<int32_t>> expected;
+    size_t sequential_steps = 0;
+    for (const GenerationRequest& request : TinyRequests()) {
+        PagedKVCache cache;
+        ASSERT_TRUE(cache.AddLayer(Model::kHkv, Model::kDim, Model::kDim).IsOk());
+        Model model(&cache);
+        ContinuousBatchingOptions options;
+        options.max_num_sequences = 1;
+        ContinuousBatchScheduler scheduler(&cache, options);
+        ASSERT_TRUE(scheduler.AddRequest(request).IsOk());
+        std::vector<GenerationResult> finished;
+        while (scheduler.HasPendingRequests()) {
+            ASSERT_TRUE(scheduler.Step([&](const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+                return model.Step(batch, sampled);
+            }, &finished).IsOk());
+            ++sequential_steps;
+        }
+        ASSERT_EQ(finished.size(), 1u);
+        ASSERT_TRUE(finished[0].status.IsOk());
+        EXPECT_EQ(finished[0].tokens.size(), static_cast<size_t>(request.max_new_tokens));
+        expected[request.id] = finished[0].tokens;
+    }
+    
+    // 28个位置放不下全部请求，运行中会发生换出
+    PagedKVCacheOptions cache_options;
+    cache_options.block_size = 4;
+    cache_options.max_blocks = 7;
+    PagedKVCache cache(cache_options);
+    ASSERT_TRUE(cache.AddLayer(Model::kHkv, Model::kDim, Model::kDim).IsOk());
+    Model model(&cache);
+    ContinuousBatchingOptions options;
+    options.max_num_tokens = 8;
+    options.max_prefill_chunk = 4;
+    ContinuousBatchScheduler scheduler(&cache, options);
+    const auto requests = TinyRequests();
+    ASSERT_TRUE(scheduler.AddRequest(requests[0]).IsOk());
+    ASSERT_TRUE(scheduler.AddRequest(requests[1]).IsOk());
+    
+    bool mixed = false;
+    size_t next_request = 2;
+    std::vector<GenerationResult> finished;
+    auto step = [&](const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+        EXPECT_LE(static_cast<int64_t>(batch.GetNumTokens()), options.max_num_tokens);
+        bool has_decode = false, has_prefill = false;
+        for (size_t b = 0; b < batch.sequences.size(); ++b) {
+            const int64_t tokens = batch.query_offsets[b + 1] - batch.query_offsets[b];
+            EXPECT_LE(tokens, options.max_prefill_chunk);
+            (tokens == 1 && batch.positions[batch.query_offsets[b]] > 0 ? has_decode : has_prefill) = true;
+        }
+        mixed = mixed || (has_decode && has_prefill);
+        return model.Step(batch, sampled);
+    };
+    for (int iteration = 0; scheduler.HasPendingRequests() || next_request < requests.size(); ++iteration) {
+        ASSERT_LT(iteration, 200);
+        // 运行过程中陆续到达的请求在下一步加入
+        if (next_request < requests.size() && iteration % 2 == 1) {
+            ASSERT_TRUE(scheduler.AddRequest(requests[next_request++]).IsOk());
+        }
+        ASSERT_TRUE(scheduler.Step(step, &finished).IsOk());
+    }
+    
+    ASSERT_EQ(finished.size(), requests.size());
+    for (const GenerationResult& result : finished) {
+        ASSERT_TRUE(result.status.IsOk());
+        EXPECT_EQ(result.tokens, expected[result.id]) << "request " << result.id;
+    }
+    const ContinuousBatchingStats stats = scheduler.GetStats();
+    EXPECT_TRUE(mixed);
+    EXPECT_GT(stats.num_preemptions, 0u);
+    EXPECT_LT(stats.num_steps, sequential_steps);
+    EXPECT_EQ(stats.num_finished, requests.size());
+    // 全部序列退出后块都已归还
+    EXPECT_EQ(cache.GetNumFreeBlocks(), cache.GetNumBlocks());
+    
+    // 取消的请求以错误结束
+    finished.clear();
+    ASSERT_TRUE(scheduler.AddRequest(requests[4]).IsOk());
+    ASSERT_TRUE(scheduler.Step(step, &finished).IsOk());
+    scheduler.AbortRequest(requests[4].id);
+    ASSERT_TRUE(scheduler.Step(step, &finished).IsOk());
+    ASSERT_EQ(finished.size(), 1u);
+    EXPECT_FALSE(finished[0].status.IsOk());
+    EXPECT_FALSE(scheduler.HasPendingRequests());
+}
+
+// 测试调度器的KV换出：块池不足时被抢占的序列换出到交换区，换回后从原位置继续，
+// 不重新prefill，生成结果与单独运行一致
+TEST_F(FusedOperatorsTest, ContinuousBatchingSwapPreemption) {
+    using Model = TinyPagedModel;
+    const auto requests = TinyRequests();
+    std::unordered_map<int64_t, std::vector<int32_t>> expected;
+    for (const GenerationRequest& request : requests) {
+        PagedKVCache cache;
+        ASSERT_TRUE(cache.AddLayer(Model::kHkv, Model::kDim, Model::kDim).IsOk());
+        Model model(&cache);
+        ContinuousBatchScheduler scheduler(&cache);
+        ASSERT_TRUE(scheduler.AddRequest(request).IsOk());
+        std::vector<GenerationResult> finished;
+        while (scheduler.HasPendingRequests()) {
+            ASSERT_TRUE(scheduler.Step([&](const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+                return model.Step(batch, sampled);
+            }, &finished).IsOk());
+        }
+        ASSERT_EQ(finished.size(), 1u);
+        expected[request.id] = finished[0].tokens;
+    }
+    
+    ContinuousBatchingStats stats[2];
+    for (int swap = 0; swap < 2; ++swap) {
+        PagedKVCacheOptions cache_options;
+        cache_options.block_size = 4;
+        cache_options.max_blocks = 7;
+        cache_options.max_swap_blocks = swap ? 16 : 0;
+        PagedKVCache cache(cache_options);
+        ASSERT_TRUE(cache.AddLayer(Model::kHkv, Model::kDim, Model::kDim).IsOk());
+        Model model(&cache);
+        ContinuousBatchingOptions options;
+        options.max_num_tokens = 8;
+        options.max_prefill_chunk = 4;
+        ContinuousBatchScheduler scheduler(&cache, options);
+        for (const GenerationRequest& request : requests) {
+            ASSERT_TRUE(scheduler.AddRequest(request).IsOk());
+        }
+        std::vector<GenerationResult> finished;
+        for (int iteration = 0; scheduler.HasPendingRequests(); ++iteration) {
+            ASSERT_LT(iteration, 200);
+            ASSERT_TRUE(scheduler.Step([&](const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+                for (int64_t seq : batch.sequences) {
+                    EXPECT_FALSE(cache.IsSwappedOut(seq));
+                }
+                return model.Step(batch, sampled);
+            }, &finished).IsOk());
+        }
+        ASSERT_EQ(finished.size(), requests.size());
+        for (const GenerationResult& result : finished) {
+            ASSERT_TRUE(result.status.IsOk());
+            EXPECT_EQ(result.tokens, expected[result.id]) << "request " << result.id << " swap " << swap;
+        }
+        stats[swap] = scheduler.GetStats();
+        EXPECT_EQ(cache.GetNumFreeBlocks(), cache.GetNumBlocks());
+        EXPECT_EQ(cache.GetNumFreeSwapBlocks(), static_cast<size_t>(cache_options.max_swap_blocks));
+    }
+    EXPECT_GT(stats[0].num_preemptions, 0u);
+    EXPECT_EQ(stats[0].num_swap_outs, 0u);
+    EXPECT_GT(stats[1].num_swap_outs, 0u);
+    EXPECT_EQ(stats[1].num_swap_ins, stats[1].num_swap_outs);
+    EXPECT_EQ(stats[1].num_preemptions, 0u);
+    // 换回的序列不重新prefill
+    EXPECT_LT(stats[1].num_prefill_tokens, stats[0].num_prefill_tokens);
+}
+
+// 测试调度器的前缀缓存：共享system prompt的请求只prefill各自的后缀，生成结果不变
+TEST_F(FusedOperatorsTest, ContinuousBatchingPrefixCache) {
+    using Model = TinyPagedModel;
+    const std::vector<int32_t> system_prompt = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8};
+    std::vector<GenerationRequest> requests;
+    for (int64_t id = 0; id < 4; ++id) {
+        GenerationRequest request;
+        request.id = id;
+        request.prompt = system_prompt;
+        request.prompt.push_back(static_cast<int32_t>(id));
+        request.prompt.push_back(static_cast<int32_t>(id * 3 % Model::kVocab));
+        request.max_new_tokens = 3;
+        requests.push_back(request);
+    }
+    
+    std::vector<std::vector<int32_t>> outputs[2];
+    ContinuousBatchingStats stats[2];
+    PrefixCacheStats prefix;
+    for (int caching = 0; caching < 2; ++caching) {
+        PagedKVCacheOptions cache_options;
+        cache_options.block_size = 4;
+        cache_options.enable_prefix_caching = caching == 1;
+        PagedKVCache cache(cache_options);
+        ASSERT_TRUE(cache.AddLayer(Model::kHkv, Model::kDim, Model::kDim).IsOk());
+        Model model(&cache);
+        ContinuousBatchScheduler scheduler(&cache);
+        std::vector<GenerationResult> finished;
+        auto step = [&](const ScheduledBatch& batch, std::vector<int32_t>* sampled) {
+            return model.Step(batch, sampled);
+        };
+        // 第一个请求完成后其余请求才到达，命中它登记的前缀块
+        ASSERT_TRUE(scheduler.AddRequest(requests[0]).IsOk());
+        while (scheduler.HasPendingRequests()) {
+            ASSERT_TRUE(scheduler.Step(step, &finished).IsOk());
+        }
+        for (size_t i = 1; i < requests.size(); ++i) {
+            ASSERT_TRUE(scheduler.AddRequest(requests[i]).IsOk());
+        }
+        while (scheduler.HasPendingRequests()) {
+            ASSERT_TRUE(scheduler.Step(step, &finished).IsOk());
+        }
+        ASSERT_EQ(finished.size(), requests.size());
+        outputs[caching].resize(requests.size());
+        for (const GenerationResult& result : finished) {
+            ASSERT_TRUE(result.status.IsOk());
+            outputs[caching][result.id] = result.tokens;
+        }
+        stats[caching] = scheduler.GetStats();
+        prefix = cache.GetPrefixCacheStats();
+    }
+    EXPECT_EQ(outputs[1], outputs[0]);
+    // 后三个请求各复用system prompt的3个整块
+    EXPECT_EQ(prefix.cached_tokens, 3u * 12u);
+    EXPECT_EQ(prefix.num_hits, 3u);
+    EXPECT_EQ(stats[1].num_prefill_tokens + prefix.cached_tokens, stats[0].num_prefill_tokens);
+}
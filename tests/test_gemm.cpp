@@ -0,0 +1,548 @@
+// SGEMM测试
+// 打包分块GEMM的各个微内核与朴素参考实现对比（覆盖边缘子块、转置、alpha/beta和epilogue）
+
+#include <gtest/gtest.h>
+#include "inferunity/operator.h"
+#include "inferunity/tensor.h"
+#include "operators/gemm.h"
+#include "operators/matmul_kernels.h"
+#include "operators/matmul_nbits_kernels.h"
+#include "operators/simd_utils.h"
+#include "inferunity/float16.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace inferunity;
+
+namespace {
+
+std::vector<float> RandomVector(size_t count, uint32_t seed) {
+    std::vector<float> data(count);
+    uint32_t state = seed;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = static_cast<float>((state >> 8) & 0xFFFF) / 65535.0f - 0.5f;
+    }
+    return data;
+}
+
+void ReferenceGemm(bool trans_a, bool trans_b, int64_t M, int64_t N, int64_t K,
+                   float alpha, const float* A, int64_t lda, const float* B, int64_t ldb,
+                   float beta, float* C, int64_t ldc, const gemm::GemmEpilogue* ep) {
+    for (int64_t i = 0; i < M; ++i) {
+        for (int64_t j = 0; j < N; ++j) {
+            double sum = 0.0;
+            for (int64_t k = 0; k < K; ++k) {
+                float a = trans_a ? A[k * lda + i] : A[i * lda + k];
+                float b = trans_b ? B[j * ldb + k] : B[k * ldb + j];
+                sum += static_cast<double>(a) * b;
+            }
+            float v = alpha * static_cast<float>(sum) + (beta == 0.0f ? 0.0f : beta * C[i * ldc + j]);
+            if (ep) {
+                if (ep->row_scale) v *= ep->row_scale[i];
+                if (ep->row_bias) v += ep->row_bias[i];
+                if (ep->col_bias) v += ep->col_bias[j];
+                if (ep->relu) v = std::max(v, 0.0f);
+            }
+            C[i * ldc + j] = v;
+        }
+    }
+}
+
+struct GemmCase {
+    int64_t M, N, K;
+    bool trans_a, trans_b;
+    float alpha, beta;
+};
+
+void RunGemmCase(const GemmCase& c, const gemm::GemmEpilogue* ep = nullptr) {
+    // 行跨度比实际宽度多出几列，验证lda/ldb/ldc的处理
+    const int64_t lda = (c.trans_a ? c.M : c.K) + 3;
+    const int64_t ldb = (c.trans_b ? c.K : c.N) + 5;
+    const int64_t ldc = c.N + 2;
+    auto A = RandomVector(static_cast<size_t>((c.trans_a ? c.K : c.M) * lda), 11);
+    auto B = RandomVector(static_cast<size_t>((c.trans_b ? c.N : c.K) * ldb), 12);
+    auto C = RandomVector(static_cast<size_t>(c.M * ldc), 13);
+    auto expected = C;
+    
+    gemm::SgemmPacked(c.trans_a, c.trans_b, c.M, c.N, c.K, c.alpha,
+                      A.data(), lda, B.data(), ldb, c.beta, C.data(), ldc, ep);
+    ReferenceGemm(c.trans_a, c.trans_b, c.M, c.N, c.K, c.alpha,
+                  A.data(), lda, B.data(), ldb, c.beta, expected.data(), ldc, ep);
+    
+    const float tolerance = 1e-4f * static_cast<float>(std::max<int64_t>(c.K, 1));
+    for (int64_t i = 0; i < c.M; ++i) {
+        for (int64_t j = 0; j < ldc; ++j) {
+            ASSERT_NEAR(C[i * ldc + j], expected[i * ldc + j], tolerance)
+                << gemm::GetMicroKernelName() << " M=" << c.M << " N=" << c.N << " K=" << c.K
+                << " at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+const char* kKernelNames[] = {"scalar_4x8", "avx2_6x16", "avx512_8x32", "neon_8x8"};
+
+} // anonymous namespace
+
+TEST(GemmTest, AllMicroKernelsMatchReference) {
+    const std::vector<GemmCase> cases = {
+        {1, 1, 1, false, false, 1.0f, 0.0f},
+        {7, 13, 5, false, false, 1.0f, 0.0f},          // 小矩阵直接计算
+        {37, 70, 45, false, false, 1.0f, 0.0f},        // 边缘子块
+        {64, 96, 300, false, false, 0.5f, 1.0f},       // 跨KC分块累加
+        {50, 33, 129, true, false, 1.0f, 0.5f},
+        {45, 61, 77, false, true, -1.0f, 0.0f},
+        {30, 150, 40, true, true, 2.0f, -1.0f},
+        {150, 40, 64, false, false, 1.0f, 0.0f},       // 跨MC分块
+    };
+    
+    int tested = 0;
+    for (const char* name : kKernelNames) {
+        if (!gemm::SetMicroKernel(name)) {
+            continue;
+        }
+        ++tested;
+        EXPECT_EQ(std::string(gemm::GetMicroKernelName()), name);
+        for (const auto& c : cases) {
+            RunGemmCase(c);
+        }
+    }
+    gemm::SetMicroKernel("auto");
+    EXPECT_GE(tested, 1);  // 标量内核总是可用
+}
+
+TEST(GemmTest, EpilogueMatchesReference) {
+    auto row_scale = RandomVector(80, 21);
+    auto row_bias = RandomVector(80, 22);
+    auto col_bias = RandomVector(90, 23);
+    
+    gemm::GemmEpilogue ep;
+    ep.row_scale = row_scale.data();
+    ep.row_bias = row_bias.data();
+    ep.relu = true;
+    RunGemmCase({80, 90, 70, false, false, 1.0f, 0.0f}, &ep);
+    RunGemmCase({80, 90, 300, false, false, 1.0f, 0.0f}, &ep);  // epilogue只在最后一个K块后应用
+    
+    gemm::GemmEpilogue fc;
+    fc.col_bias = col_bias.data();
+    RunGemmCase({80, 90, 70, false, true, 1.0f, 0.0f}, &fc);
+    RunGemmCase({3, 5, 4, false, false, 1.0f, 0.0f}, &fc);
+}
+
+TEST(GemmTest, DegenerateShapes) {
+    // K == 0：C = beta * C
+    std::vector<float> C = {1.0f, 2.0f, 3.0f, 4.0f};
+    gemm::SgemmPacked(false, false, 2, 2, 0, 1.0f, nullptr, 1, nullptr, 2, 0.5f, C.data(), 2);
+    EXPECT_FLOAT_EQ(C[0], 0.5f);
+    EXPECT_FLOAT_EQ(C[3], 2.0f);
+    
+    RunGemmCase({33, 47, 20, false, false, 0.0f, 1.0f});
+    EXPECT_FALSE(gemm::SetMicroKernel("unknown_kernel"));
+}
+
+TEST(GemmTest, FusedMatMulAddBroadcastsBias) {
+    const int64_t M = 20, K = 30, N = 40;
+    auto A = CreateTensor(Shape({M, K}), DataType::FLOAT32, DeviceType::CPU);
+    auto B = CreateTensor(Shape({K, N}), DataType::FLOAT32, DeviceType::CPU);
+    auto a_data = RandomVector(M * K, 31);
+    auto b_data = RandomVector(K * N, 32);
+    std::copy(a_data.begin(), a_data.end(), static_cast<float*>(A->GetData()));
+    std::copy(b_data.begin(), b_data.end(), static_cast<float*>(B->GetData()));
+    
+    const std::vector<Shape> bias_shapes = {Shape({N}), Shape({M, N}), Shape({M, 1}), Shape({1})};
+    for (const auto& bias_shape : bias_shapes) {
+        auto bias = CreateTensor(bias_shape, DataType::FLOAT32, DeviceType::CPU);
+        auto bias_data = RandomVector(bias->GetElementCount(), 33);
+        std::copy(bias_data.begin(), bias_data.end(), static_cast<float*>(bias->GetData()));
+    
+        auto op = OperatorRegistry::Instance().Create("FusedMatMulAdd");
+        ASSERT_NE(op, nullptr);
+        auto C = CreateTensor(Shape({M, N}), DataType::FLOAT32, DeviceType::CPU);
+        std::vector<Tensor*> inputs = {A.get(), B.get(), bias.get()};
+        std::vector<Tensor*> outputs = {C.get()};
+        ExecutionContext ctx;
+        ASSERT_TRUE(op->Execute(inputs, outputs, &ctx).IsOk());
+    
+        std::vector<float> expected(M * N, 0.0f);
+        ReferenceGemm(false, false, M, N, K, 1.0f, a_data.data(), K, b_data.data(), N,
+                      0.0f, expected.data(), N, nullptr);
+        const float* actual = static_cast<const float*>(C->GetData());
+        for (int64_t i = 0; i < M; ++i) {
+            for (int64_t j = 0; j < N; ++j) {
+                float b = bias_data.size() == 1 ? bias_data[0]
+                        : bias_data.size() == static_cast<size_t>(N) ? bias_data[j]
+                        : bias_data.size() == static_cast<size_t>(M) ? bias_data[i]
+                        : bias_data[i * N + j];
+                ASSERT_NEAR(actual[i * N + j], expected[i * N + j] + b, 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(GemmTest, PrepackedOperandsMatchReference) {
+    const std::vector<GemmCase> cases = {
+        {7, 13, 5, false, false, 1.0f, 0.0f},
+        {150, 70, 300, false, false, 1.0f, 0.0f},      // 跨MC与KC分块
+        {45, 61, 77, true, true, -1.0f, 0.5f},
+        {9, 2100, 40, false, true, 1.0f, 0.0f},        // 跨NC分块
+    };
+    auto row_bias = RandomVector(150, 41);
+    gemm::GemmEpilogue ep;
+    ep.row_bias = row_bias.data();
+    ep.relu = true;
+    
+    int tested = 0;
+    for (const char* name : kKernelNames) {
+        if (!gemm::SetMicroKernel(name)) {
+            continue;
+        }
+        ++tested;
+        for (const auto& c : cases) {
+            const int64_t lda = c.trans_a ? c.M : c.K;
+            const int64_t ldb = c.trans_b ? c.K : c.N;
+            auto A = RandomVector(static_cast<size_t>(c.M * c.K), 42);
+            auto B = RandomVector(static_cast<size_t>(c.K * c.N), 43);
+            auto C0 = RandomVector(static_cast<size_t>(c.M * c.N), 44);
+            gemm::PackedMatrix packed_a, packed_b;
+            gemm::PackMatrixA(c.trans_a, c.M, c.K, A.data(), lda, &packed_a);
+            gemm::PackMatrixB(c.trans_b, c.K, c.N, B.data(), ldb, &packed_b);
+            // 打包后切换微内核不影响结果：执行时使用打包记录的内核
+            gemm::SetMicroKernel("scalar_4x8");
+    
+            auto expected = C0;
+            ReferenceGemm(c.trans_a, c.trans_b, c.M, c.N, c.K, c.alpha, A.data(), lda,
+                          B.data(), ldb, c.beta, expected.data(), c.N, &ep);
+            const gemm::PackedMatrix* a_options[] = {&packed_a, nullptr, &packed_a};
+            const gemm::PackedMatrix* b_options[] = {nullptr, &packed_b, &packed_b};
+            for (int v = 0; v < 3; ++v) {
+                auto C = C0;
+                gemm::SgemmPrepacked(c.trans_a, c.trans_b, c.M, c.N, c.K, c.alpha,
+                                     A.data(), lda, a_options[v], B.data(), ldb, b_options[v],
+                                     c.beta, C.data(), c.N, &ep);
+                const float tolerance = 1e-4f * static_cast<float>(c.K);
+                for (size_t i = 0; i < C.size(); ++i) {
+                    ASSERT_NEAR(C[i], expected[i], tolerance)
+                        << name << " variant=" << v << " M=" << c.M << " N=" << c.N
+                        << " K=" << c.K << " at " << i;
+                }
+            }
+            gemm::SetMicroKernel(name);
+        }
+    }
+    gemm::SetMicroKernel("auto");
+    EXPECT_GE(tested, 1);
+}
+
+TEST(GemmTest, BatchedMatMulWithPrepackedB) {
+    // A[3, 10, K] x 常量B[K, N]：批次并入M，使用预打包的B
+    const int64_t batch = 3, M = 10, K = 70, N = 45;
+    auto A = RandomVector(static_cast<size_t>(batch * M * K), 51);
+    auto B = RandomVector(static_cast<size_t>(K * N), 52);
+    operators::MatMulShape shape;
+    ASSERT_TRUE(operators::ComputeMatMulShape(Shape({batch, M, K}), Shape({K, N}),
+                                              false, false, &shape).IsOk());
+    gemm::PackedMatrix packed_b;
+    gemm::PackMatrixB(false, K, N, B.data(), N, &packed_b);
+    
+    std::vector<float> C(static_cast<size_t>(batch * M * N), 0.0f);
+    operators::RunBatchedMatMul(shape, 1.0f, A.data(), B.data(), 0.0f, C.data(), nullptr, &packed_b);
+    std::vector<float> expected(C.size(), 0.0f);
+    ReferenceGemm(false, false, batch * M, N, K, 1.0f, A.data(), K, B.data(), N,
+                  0.0f, expected.data(), N, nullptr);
+    for (size_t i = 0; i < C.size(); ++i) {
+        ASSERT_NEAR(C[i], expected[i], 1e-3f) << "at " << i;
+    }
+}
+
+TEST(GemmTest, HalfConversionsMatchScalar) {
+    // 覆盖舍入到偶数、非规格化数、溢出、无穷与NaN；长度不是向量宽度的整倍数
+    std::vector<float> values = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 65520.0f, 1e6f, -1e6f,
+                                 6.1e-5f, 5.96e-8f, 2.98e-8f, 1e-10f, 1.0009765625f, 1.00048828125f,
+                                 3.14159265f, std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::quiet_NaN(), 1.00390625f, 1.01171875f};
+    auto noise = RandomVector(45, 61);
+    for (float v : noise) {
+        values.push_back(v * 1000.0f);
+    }
+    const size_t count = values.size();
+    
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        std::vector<uint16_t> half(count), bf16(count);
+        std::vector<float> half_back(count), bf16_back(count);
+        simd::ConvertFloatToHalfSIMD(values.data(), half.data(), count);
+        simd::ConvertFloatToBFloat16SIMD(values.data(), bf16.data(), count);
+        simd::ConvertHalfToFloatSIMD(half.data(), half_back.data(), count);
+        simd::ConvertBFloat16ToFloatSIMD(bf16.data(), bf16_back.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(half[i], FloatToHalf(values[i])) << isa << " value " << values[i];
+            EXPECT_EQ(bf16[i], FloatToBFloat16(values[i])) << isa << " value " << values[i];
+            const float h = HalfToFloat(half[i]);
+            const float b = BFloat16ToFloat(bf16[i]);
+            EXPECT_TRUE(half_back[i] == h || (std::isnan(half_back[i]) && std::isnan(h))) << isa;
+            EXPECT_TRUE(bf16_back[i] == b || (std::isnan(bf16_back[i]) && std::isnan(b))) << isa;
+        }
+    }
+    simd::SetSimdIsa("auto");
+    
+    EXPECT_EQ(FloatToHalf(1.0f), 0x3C00);
+    EXPECT_EQ(FloatToHalf(65520.0f), 0x7C00);          // 超过最大有限值一半ulp时溢出为无穷
+    EXPECT_EQ(FloatToHalf(1.00048828125f), 0x3C00);    // 恰好一半时舍入到偶数
+    EXPECT_EQ(FloatToHalf(5.96046448e-8f), 0x0001);   // 最小非规格化数
+    EXPECT_FLOAT_EQ(HalfToFloat(0x0001), 5.96046448e-8f);
+    EXPECT_EQ(FloatToBFloat16(1.00390625f), 0x3F80);   // 1 + 2^-8舍入到偶数
+    EXPECT_EQ(FloatToBFloat16(1.01171875f), 0x3F82);
+    EXPECT_TRUE(std::isnan(BFloat16ToFloat(FloatToBFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(GemmTest, HalfWeightGemmMatchesReference) {
+    const std::vector<GemmCase> cases = {
+        {5, 7, 9, false, false, 1.0f, 0.0f},           // 小矩阵：整体转换
+        {37, 70, 45, false, false, 1.0f, 0.0f},
+        {20, 45, 300, false, true, 0.5f, 1.0f},        // 跨KC分块、转置B
+        {1, 130, 64, false, false, 1.0f, 0.0f},        // 解码阶段的单行A
+    };
+    for (gemm::HalfType type : {gemm::HalfType::FLOAT16, gemm::HalfType::BFLOAT16}) {
+        for (const auto& c : cases) {
+            const int64_t lda = c.K;
+            const int64_t ldb = (c.trans_b ? c.K : c.N) + 3;
+            auto A = RandomVector(static_cast<size_t>(c.M * lda), 71);
+            auto B = RandomVector(static_cast<size_t>((c.trans_b ? c.N : c.K) * ldb), 72);
+            std::vector<uint16_t> B_half(B.size());
+            for (size_t i = 0; i < B.size(); ++i) {
+                B_half[i] = type == gemm::HalfType::BFLOAT16 ? FloatToBFloat16(B[i]) : FloatToHalf(B[i]);
+                B[i] = type == gemm::HalfType::BFLOAT16 ? BFloat16ToFloat(B_half[i]) : HalfToFloat(B_half[i]);
+            }
+            auto C = RandomVector(static_cast<size_t>(c.M * c.N), 73);
+            auto expected = C;
+            auto col_bias = RandomVector(static_cast<size_t>(c.N), 74);
+            gemm::GemmEpilogue ep;
+            ep.col_bias = col_bias.data();
+            gemm::SgemmHalfB(false, c.trans_b, c.M, c.N, c.K, c.alpha, A.data(), lda,
+                             B_half.data(), type, ldb, c.beta, C.data(), c.N, &ep);
+            ReferenceGemm(false, c.trans_b, c.M, c.N, c.K, c.alpha, A.data(), lda, B.data(), ldb,
+                          c.beta, expected.data(), c.N, &ep);
+            for (size_t i = 0; i < C.size(); ++i) {
+                ASSERT_NEAR(C[i], expected[i], 1e-4f * static_cast<float>(c.K))
+                    << "M=" << c.M << " N=" << c.N << " K=" << c.K << " at " << i;
+            }
+        }
+    }
+}
+
+TEST(GemmTest, SkinnyGemmMatchesReference) {
+    // M <= 8的瘦矩阵内核：各ISA、FP32/FLOAT16/BFLOAT16的B、B是否转置；N、K不是向量宽度的整倍数
+    const int64_t N = 75, K = 53;
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (int b_type = 0; b_type < 3; ++b_type) {
+            for (bool trans_b : {false, true}) {
+                for (int64_t M = 1; M <= gemm::kSkinnyMaxRows; ++M) {
+                    const int64_t lda = K + 1;
+                    const int64_t ldb = (trans_b ? K : N) + 3;
+                    auto A = RandomVector(static_cast<size_t>(M * lda), 81);
+                    auto B = RandomVector(static_cast<size_t>((trans_b ? N : K) * ldb), 82);
+                    std::vector<uint16_t> B_half(B.size());
+                    for (size_t i = 0; i < B.size() && b_type != 0; ++i) {
+                        B_half[i] = b_type == 2 ? FloatToBFloat16(B[i]) : FloatToHalf(B[i]);
+                        B[i] = b_type == 2 ? BFloat16ToFloat(B_half[i]) : HalfToFloat(B_half[i]);
+                    }
+                    auto C = RandomVector(static_cast<size_t>(M * N), 83);
+                    auto expected = C;
+                    auto col_bias = RandomVector(static_cast<size_t>(N), 84);
+                    gemm::GemmEpilogue ep;
+                    ep.col_bias = col_bias.data();
+                    const float beta = M % 2 == 0 ? 0.5f : 0.0f;
+                    if (b_type == 0) {
+                        gemm::SgemmSkinny(trans_b, M, N, K, 1.5f, A.data(), lda, B.data(), ldb,
+                                          beta, C.data(), N, &ep);
+                    } else {
+                        gemm::SgemmSkinny(trans_b, M, N, K, 1.5f, A.data(), lda, B_half.data(),
+                                          b_type == 2 ? gemm::HalfType::BFLOAT16 : gemm::HalfType::FLOAT16,
+                                          ldb, beta, C.data(), N, &ep);
+                    }
+                    ReferenceGemm(false, trans_b, M, N, K, 1.5f, A.data(), lda, B.data(), ldb,
+                                  beta, expected.data(), N, &ep);
+                    for (size_t i = 0; i < C.size(); ++i) {
+                        ASSERT_NEAR(C[i], expected[i], 1e-4f * static_cast<float>(K))
+                            << isa << " b_type=" << b_type << " trans_b=" << trans_b << " M=" << M << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+    
+    // RunBatchedMatMul：N分块（N大）与K切分（N小K大）两种并行方式
+    const std::vector<std::vector<int64_t>> shapes = {{3, 1000, 512}, {1, 64, 8192}};
+    for (const auto& dims : shapes) {
+        const int64_t M = dims[0], cols = dims[1], depth = dims[2];
+        auto A = RandomVector(static_cast<size_t>(M * depth), 85);
+        auto B = RandomVector(static_cast<size_t>(depth * cols), 86);
+        auto bias = RandomVector(static_cast<size_t>(cols), 87);
+        operators::MatMulShape shape;
+        ASSERT_TRUE(operators::ComputeMatMulShape(Shape({M, depth}), Shape({depth, cols}),
+                                                  false, false, &shape).IsOk());
+        gemm::GemmEpilogue ep;
+        ep.col_bias = bias.data();
+        ep.relu = true;
+        std::vector<float> C(static_cast<size_t>(M * cols), 0.0f);
+        operators::RunBatchedMatMul(shape, 1.0f, A.data(), B.data(), 0.0f, C.data(), &ep);
+        std::vector<float> expected(C.size(), 0.0f);
+        ReferenceGemm(false, false, M, cols, depth, 1.0f, A.data(), depth, B.data(), cols,
+                      0.0f, expected.data(), cols, &ep);
+        for (size_t i = 0; i < C.size(); ++i) {
+            ASSERT_NEAR(C[i], expected[i], 1e-3f) << "M=" << M << " K=" << depth << " at " << i;
+        }
+    }
+}
+
+TEST(GemmTest, Bf16ComputeMatchesReference) {
+    // 参考结果使用舍入到BF16后的A、B以double累加；原生核以FP32累加，误差由累加顺序决定
+    const int64_t M = 37, N = 45, K = 75;
+    auto A = RandomVector(static_cast<size_t>(M * K), 81);
+    auto B = RandomVector(static_cast<size_t>(N * K), 82);  // 存储为[N, K]，按trans_b打包
+    std::vector<float> A_rounded(A.size()), B_rounded(B.size());
+    for (size_t i = 0; i < A.size(); ++i) A_rounded[i] = BFloat16ToFloat(FloatToBFloat16(A[i]));
+    for (size_t i = 0; i < B.size(); ++i) B_rounded[i] = BFloat16ToFloat(FloatToBFloat16(B[i]));
+    gemm::PackedBf16Matrix packed;
+    gemm::PackMatrixBBf16(true, K, N, B.data(), K, &packed);
+    EXPECT_EQ(packed.k_pairs % 16, 0);
+    EXPECT_EQ(packed.n_pad % 16, 0);
+    
+    auto row_bias = RandomVector(static_cast<size_t>(M), 83);
+    gemm::GemmEpilogue ep;
+    ep.row_bias = row_bias.data();
+    ep.relu = true;
+    std::vector<float> expected = RandomVector(static_cast<size_t>(M * N), 84);
+    const auto C0 = expected;
+    ReferenceGemm(false, true, M, N, K, 0.5f, A_rounded.data(), K, B_rounded.data(), K,
+                  1.0f, expected.data(), N, &ep);
+    
+    int tested = 0;
+    for (const char* name : {"none", "avx512_bf16", "amx_bf16"}) {
+        if (!gemm::SetBf16Kernel(name)) {
+            continue;
+        }
+        ++tested;
+        EXPECT_EQ(std::string(gemm::GetBf16KernelName()), name);
+        auto C = C0;
+        gemm::SgemmBf16(M, N, K, 0.5f, A.data(), K, packed, 1.0f, C.data(), N, &ep);
+        for (size_t i = 0; i < C.size(); ++i) {
+            ASSERT_NEAR(C[i], expected[i], 1e-4f * K) << name << " at " << i;
+        }
+    }
+    gemm::SetBf16Kernel("auto");
+    EXPECT_GE(tested, 1);
+    EXPECT_FALSE(gemm::SetBf16Kernel("unknown_kernel"));
+    
+    // 以BFLOAT16存储的B直接按位打包，与从FP32舍入打包的结果一致
+    std::vector<uint16_t> B_bf16(B.size());
+    for (size_t i = 0; i < B.size(); ++i) B_bf16[i] = FloatToBFloat16(B[i]);
+    gemm::PackedBf16Matrix packed_from_half;
+    gemm::PackMatrixBBf16(true, K, N, B_bf16.data(), gemm::HalfType::BFLOAT16, K, &packed_from_half);
+    EXPECT_EQ(packed_from_half.data, packed.data);
+}
+
+TEST(GemmTest, DotU4U8MatchScalar) {
+    // 长度覆盖向量宽度的整倍数与奇数尾部（4位时最后一个字节只用低4位）
+    for (size_t count : {1u, 7u, 16u, 31u, 32u, 64u, 77u, 128u}) {
+        auto a = RandomVector(count, 71);
+        std::vector<uint8_t> q(count);
+        for (size_t i = 0; i < count; ++i) q[i] = static_cast<uint8_t>((i * 37 + 11) & 0xFF);
+        double expected_u8 = 0.0, expected_u4 = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            expected_u8 += static_cast<double>(a[i]) * q[i];
+            const int v = (i & 1) ? (q[i / 2] >> 4) : (q[i / 2] & 0x0F);
+            expected_u4 += static_cast<double>(a[i]) * v;
+        }
+        for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+            if (!simd::SetSimdIsa(isa)) {
+                continue;
+            }
+            EXPECT_NEAR(simd::DotU8SIMD(a.data(), q.data(), count), expected_u8, 1e-3) << isa << " " << count;
+            EXPECT_NEAR(simd::DotU4SIMD(a.data(), q.data(), count), expected_u4, 1e-4) << isa << " " << count;
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+TEST(GemmTest, MatMulNBitsMatchesDequantizedReference) {
+    // K不是block_size的整倍数；M覆盖GEMV（<= 4行）与反量化后SGEMM两条路径
+    const int64_t K = 75, N = 133;
+    for (int64_t bits : {4, 8}) {
+        for (int64_t block_size : {16, 32}) {
+            for (bool with_zero_points : {false, true}) {
+                const int64_t blocks = (K + block_size - 1) / block_size;
+                const int64_t blob_size = block_size * bits / 8;
+                const int64_t zp_per_col = bits == 8 ? blocks : (blocks + 1) / 2;
+                auto b = CreateTensor(Shape({N, blocks, blob_size}), DataType::UINT8, DeviceType::CPU);
+                auto scales = CreateTensor(Shape({N * blocks}), DataType::FLOAT16, DeviceType::CPU);
+                auto zero_points = CreateTensor(Shape({N * zp_per_col}), DataType::UINT8, DeviceType::CPU);
+                uint8_t* q = static_cast<uint8_t*>(b->GetData());
+                for (size_t i = 0; i < b->GetElementCount(); ++i) q[i] = static_cast<uint8_t>((i * 131 + 7) & 0xFF);
+                auto scale_values = RandomVector(scales->GetElementCount(), 72);
+                uint16_t* scale_data = static_cast<uint16_t*>(scales->GetData());
+                for (size_t i = 0; i < scale_values.size(); ++i) {
+                    scale_data[i] = FloatToHalf(0.01f + std::fabs(scale_values[i]) * 0.05f);
+                }
+                uint8_t* zp = static_cast<uint8_t*>(zero_points->GetData());
+                for (size_t i = 0; i < zero_points->GetElementCount(); ++i) zp[i] = static_cast<uint8_t>((i * 29 + 3) & 0xFF);
+    
+                operators::MatMulNBitsWeight weight;
+                ASSERT_TRUE(operators::ResolveMatMulNBitsWeight(K, N, bits, block_size, *b, *scales,
+                                                                with_zero_points ? zero_points.get() : nullptr,
+                                                                &weight).IsOk());
+                // 参考：逐元素反量化 w = (q - zp) * scale
+                std::vector<float> dense(static_cast<size_t>(K * N));
+                for (int64_t n = 0; n < N; ++n) {
+                    for (int64_t k = 0; k < K; ++k) {
+                        const int64_t block = k / block_size, i = k % block_size;
+                        const uint8_t* blob = q + (n * blocks + block) * blob_size;
+                        const int32_t v = bits == 8 ? blob[i] : ((i & 1) ? (blob[i / 2] >> 4) : (blob[i / 2] & 0x0F));
+                        int32_t z = 1 << (bits - 1);
+                        if (with_zero_points) {
+                            z = bits == 8 ? zp[n * zp_per_col + block]
+                                          : ((block & 1) ? (zp[n * zp_per_col + block / 2] >> 4)
+                                                         : (zp[n * zp_per_col + block / 2] & 0x0F));
+                        }
+                        dense[k * N + n] = static_cast<float>(v - z) * HalfToFloat(scale_data[n * blocks + block]);
+                    }
+                }
+                auto bias = RandomVector(static_cast<size_t>(N), 73);
+                for (int64_t M : {1, 3, 9}) {
+                    auto A = RandomVector(static_cast<size_t>(M * K), 74);
+                    std::vector<float> expected(static_cast<size_t>(M * N)), Y(expected.size());
+                    gemm::GemmEpilogue ep;
+                    ep.col_bias = bias.data();
+                    ReferenceGemm(false, false, M, N, K, 1.0f, A.data(), K, dense.data(), N,
+                                  0.0f, expected.data(), N, &ep);
+                    ASSERT_TRUE(operators::MatMulNBitsRun(weight, A.data(), M, bias.data(), Y.data(), nullptr).IsOk());
+                    // 8位权重的幅值可达127 * scale，误差随之放大
+                    const float tolerance = (bits == 8 ? 1e-3f : 1e-4f) * K;
+                    for (size_t i = 0; i < Y.size(); ++i) {
+                        ASSERT_NEAR(Y[i], expected[i], tolerance)
+                            << "bits=" << bits << " block=" << block_size << " zp=" << with_zero_points
+                            << " M=" << M << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+    
+    auto b = CreateTensor(Shape({4, 2, 16}), DataType::UINT8, DeviceType::CPU);
+    auto scales = CreateTensor(Shape({8}), DataType::FLOAT32, DeviceType::CPU);
+    operators::MatMulNBitsWeight weight;
+    EXPECT_TRUE(operators::ResolveMatMulNBitsWeight(64, 4, 4, 32, *b, *scales, nullptr, &weight).IsOk());
+    EXPECT_FALSE(operators::ResolveMatMulNBitsWeight(64, 4, 3, 32, *b, *scales, nullptr, &weight).IsOk());
+    EXPECT_FALSE(operators::ResolveMatMulNBitsWeight(64, 4, 4, 24, *b, *scales, nullptr, &weight).IsOk());
+    EXPECT_FALSE(operators::ResolveMatMulNBitsWeight(96, 4, 4, 32, *b, *scales, nullptr, &weight).IsOk());
+}
@@ -5,6 +5,17 @@
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
+#include "inferunity/model_format.h"
+#include "inferunity/engine.h"
+#include "inferunity/backend.h"
+#include "inferunity/op_type.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
 #include <vector>
 
 using namespace inferunity;
@@ -151,7 +162,85 @@ TEST_F(GraphTest, CloneGraph) {
     EXPECT_EQ(cloned.GetNodes().size(), 1);
 }
 
+// 测试克隆共享权重：常量按引用共享并写时复制，激活换成新的张量对象
+TEST_F(GraphTest, CloneSharesInitializers) {
+    Value* x = graph_->AddValue();
+    x->SetTensor(std::make_shared<Tensor>(Shape({2, 3}), DataType::FLOAT32, nullptr));
+    Value* w = graph_->AddValue();
+    w->SetTensor(CreateTensor(Shape({2, 3}), DataType::FLOAT32));
+    float* w_data = static_cast<float*>(w->GetTensor()->GetData());
+    for (int i = 0; i < 6; ++i) {
+        w_data[i] = static_cast<float>(i);
+    }
+    Value* y = graph_->AddValue();
+    y->SetTensor(CreateTensor(Shape({2, 3}), DataType::FLOAT32));
+    Node* add = graph_->AddNode("Add", "add");
+    add->AddInput(x);
+    add->AddInput(w);
+    add->AddOutput(y);
+    graph_->AddInput(x);
+    graph_->AddOutput(y);
+    
+    Graph cloned = graph_->Clone();
+    Value* cloned_w = cloned.GetValue(w->GetId());
+    Value* cloned_y = cloned.GetValue(y->GetId());
+    ASSERT_NE(cloned_w, nullptr);
+    ASSERT_NE(cloned_y, nullptr);
+    EXPECT_EQ(cloned_w->GetTensor(), w->GetTensor());
+    EXPECT_TRUE(cloned_w->IsTensorShared());
+    EXPECT_TRUE(w->IsTensorShared());
+    // 激活只保留形状与类型，不共享原图的缓冲
+    EXPECT_NE(cloned_y->GetTensor(), y->GetTensor());
+    EXPECT_EQ(cloned_y->GetShape().dims, y->GetShape().dims);
+    EXPECT_EQ(cloned_y->GetTensor()->GetData(), nullptr);
+    EXPECT_FALSE(cloned_y->IsTensorShared());
+    
+    // 写时复制：副本改写自己的权重，原图不受影响
+    auto mutable_w = cloned_w->GetMutableTensor();
+    ASSERT_NE(mutable_w, nullptr);
+    EXPECT_NE(mutable_w, w->GetTensor());
+    EXPECT_FALSE(cloned_w->IsTensorShared());
+    static_cast<float*>(mutable_w->GetData())[0] = 42.0f;
+    EXPECT_EQ(w_data[0], 0.0f);
+    EXPECT_EQ(static_cast<float*>(mutable_w->GetData())[5], 5.0f);
+    // 不再共享时直接返回自己的张量
+    EXPECT_EQ(cloned_w->GetMutableTensor(), mutable_w);
+}
+
 // 测试图序列化
+TEST_F(GraphTest, InternedOpTypeIds) {
+    // 同一字符串总是得到同一ID，ID稠密且能反查名字
+    const OpTypeId relu = InternOpType("Relu");
+    EXPECT_EQ(InternOpType(std::string("Relu")), relu);
+    EXPECT_EQ(FindOpType("Relu"), relu);
+    EXPECT_LT(relu, GetOpTypeCount());
+    EXPECT_EQ(GetOpTypeName(relu), "Relu");
+    EXPECT_EQ(FindOpType("NeverRegisteredOpForTest"), kInvalidOpTypeId);
+    EXPECT_EQ(OpType("Relu"), OpType(std::string("Relu")));
+    EXPECT_NE(OpType("Relu"), OpType("Sigmoid"));
+    
+    // 节点的ID随SetOpType更新
+    Node* node = graph_->AddNode("Relu", "relu");
+    EXPECT_EQ(node->GetOpTypeId(), relu);
+    node->SetOpType("Sigmoid");
+    EXPECT_EQ(node->GetOpTypeId(), OpType("Sigmoid").id);
+    EXPECT_EQ(GetOpTypeName(node->GetOpTypeId()), "Sigmoid");
+    
+    // 注册表按ID创建，提供者按ID查询的结果与按字符串一致
+    auto op = OperatorRegistry::Instance().Create(relu);
+    ASSERT_NE(op, nullptr);
+    EXPECT_EQ(op->GetName(), "Relu");
+    EXPECT_EQ(OperatorRegistry::Instance().Create(InternOpType("NoSuchOpForTest")), nullptr);
+    auto provider = ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider");
+    ASSERT_NE(provider, nullptr);
+    for (const char* op_type : {"Relu", "Conv", "MatMul", "NoSuchOpForTest"}) {
+        for (int repeat = 0; repeat < 2; ++repeat) {
+            EXPECT_EQ(provider->SupportsOperatorId(InternOpType(op_type)), provider->SupportsOperator(op_type))
+                << op_type;
+        }
+    }
+}
+
 TEST_F(GraphTest, SerializeGraph) {
     Value* input = graph_->AddValue();
     Value* output = graph_->AddValue();
@@ -228,3 +317,371 @@ TEST_F(GraphTest, NodeAttributes) {
     EXPECT_FALSE(node->HasAttribute("nonexistent"));
 }
 
+// 测试名称/id索引与墓碑删除：删除后查找立即失效，压缩保持其余节点顺序，改名与重名按添加顺序
+TEST_F(GraphTest, IndexedLookupAndTombstones) {
+    const int count = 20000;
+    std::vector<Node*> nodes;
+    Value* prev = graph_->AddValue();
+    prev->SetName("v0");
+    graph_->AddInput(prev);
+    for (int i = 0; i < count; ++i) {
+        Node* node = graph_->AddNode("Relu", "n" + std::to_string(i));
+        Value* out = graph_->AddValue();
+        out->SetName("v" + std::to_string(i + 1));
+        node->AddInput(prev);
+        node->AddOutput(out);
+        nodes.push_back(node);
+        prev = out;
+    }
+    graph_->AddOutput(prev);
+    
+    EXPECT_EQ(graph_->GetNodeByName("n12345"), nodes[12345]);
+    EXPECT_EQ(graph_->GetNode(nodes[777]->GetId()), nodes[777]);
+    EXPECT_EQ(graph_->FindValueByName("v20000"), prev);
+    
+    // 删除偶数下标的节点：O(1)墓碑，之后按名称和id都查不到
+    for (int i = 0; i < count; i += 2) {
+        graph_->RemoveNode(nodes[i]);
+    }
+    EXPECT_EQ(graph_->GetNodeByName("n100"), nullptr);
+    EXPECT_EQ(graph_->GetNode(nodes[100]->GetId()), nullptr);
+    EXPECT_EQ(graph_->GetNodeByName("n101"), nodes[101]);
+    EXPECT_EQ(graph_->TopologicalSort().size(), static_cast<size_t>(count / 2));
+    const auto& compacted = graph_->GetNodes();
+    ASSERT_EQ(compacted.size(), static_cast<size_t>(count / 2));
+    for (size_t i = 0; i < compacted.size(); ++i) {
+        EXPECT_EQ(compacted[i].get(), nodes[2 * i + 1]);
+    }
+    
+    // 改名更新索引；重名时返回最早添加的节点，删除它之后返回下一个
+    nodes[1]->SetName("renamed");
+    EXPECT_EQ(graph_->GetNodeByName("n1"), nullptr);
+    EXPECT_EQ(graph_->GetNodeByName("renamed"), nodes[1]);
+    nodes[5]->SetName("dup");
+    nodes[3]->SetName("dup");
+    EXPECT_EQ(graph_->GetNodeByName("dup"), nodes[3]);
+    graph_->RemoveNode(nodes[3]);
+    EXPECT_EQ(graph_->GetNodeByName("dup"), nodes[5]);
+    
+    // 移动后的图仍能维护索引
+    Graph moved = std::move(*graph_);
+    nodes[7]->SetName("after_move");
+    EXPECT_EQ(moved.GetNodeByName("after_move"), nodes[7]);
+    EXPECT_EQ(moved.FindValueByName("v20000"), prev);
+    Graph cloned = moved.Clone();
+    EXPECT_NE(cloned.GetNodeByName("after_move"), nullptr);
+    EXPECT_EQ(cloned.GetNode(nodes[9]->GetId())->GetName(), "n9");
+}
+
+// 测试增量拓扑序：插入违反当前顺序的边后只重排受影响区间，结果仍是合法拓扑序
+TEST_F(GraphTest, IncrementalTopologicalOrder) {
+    auto is_topological = [](const std::vector<Node*>& order) {
+        std::unordered_map<const Node*, size_t> position;
+        for (size_t i = 0; i < order.size(); ++i) {
+            position[order[i]] = i;
+        }
+        for (const Node* node : order) {
+            for (const Value* input : node->GetInputs()) {
+                const Node* producer = input->GetProducer();
+                if (producer && position.at(producer) >= position.at(node)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    
+    // x -> a -> b -> c
+    Value* x = graph_->AddValue();
+    graph_->AddInput(x);
+    std::vector<Node*> chain;
+    Value* prev = x;
+    for (const char* name : {"a", "b", "c"}) {
+        Node* node = graph_->AddNode("Relu", name);
+        Value* out = graph_->AddValue();
+        node->AddInput(prev);
+        node->AddOutput(out);
+        chain.push_back(node);
+        prev = out;
+    }
+    graph_->AddOutput(prev);
+    EXPECT_EQ(graph_->GetTopologicalOrder(), graph_->TopologicalSort());
+    
+    // 新节点d追加在末尾，然后让a消费d的输出：d必须移到a之前
+    Node* d = graph_->AddNode("Relu", "d");
+    Value* d_out = graph_->AddValue();
+    d->AddInput(x);
+    d->AddOutput(d_out);
+    chain[0]->AddInput(d_out);
+    std::vector<Node*> order = graph_->GetTopologicalOrder();
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_TRUE(is_topological(order));
+    EXPECT_EQ(order[0], d);
+    
+    // 删除节点后顺序仍然有效，压缩后不含墓碑
+    graph_->RemoveNode(chain[1]);
+    order = graph_->GetTopologicalOrder();
+    EXPECT_EQ(order.size(), 3u);
+    graph_->Compact();
+    EXPECT_EQ(graph_->GetTopologicalOrder(), order);
+    
+    // 形成环时回退为完整排序（环上的节点不在结果中）
+    Value* c_out = chain[2]->GetOutputs()[0];
+    d->AddInput(c_out);
+    chain[2]->AddInput(d_out);
+    EXPECT_EQ(graph_->GetTopologicalOrder().size(), graph_->TopologicalSort().size());
+    EXPECT_LT(graph_->GetTopologicalOrder().size(), 3u);
+}
+
+// 测试属性按类型保存：单元素列表仍是INTS，张量属性在克隆与紧凑格式往返后保留类型和数据
+TEST_F(GraphTest, TypedAttributes) {
+    Value* x = graph_->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({1, 3}), DataType::FLOAT32));
+    Value* y = graph_->AddValue();
+    y->SetName("y");
+    Node* node = graph_->AddNode("Custom", "custom");
+    node->AddInput(x);
+    node->AddOutput(y);
+    graph_->AddInput(x);
+    graph_->AddOutput(y);
+    
+    node->SetAttribute("axes", AttributeValue(std::vector<int64_t>{1}));
+    node->SetAttribute("alpha", AttributeValue(0.25f));
+    node->SetAttribute("scales", AttributeValue(std::vector<float>{1.0f, 2.5f}));
+    node->SetAttribute("mode", "linear");
+    auto value = CreateTensor(Shape({2}), DataType::INT64);
+    static_cast<int64_t*>(value->GetData())[0] = 7;
+    static_cast<int64_t*>(value->GetData())[1] = -3;
+    node->SetAttribute("value", AttributeValue(value));
+    
+    ASSERT_NE(node->FindAttribute("axes"), nullptr);
+    EXPECT_EQ(node->FindAttribute("axes")->GetType(), AttributeValue::Type::INTS);
+    EXPECT_EQ(node->GetAttribute("axes"), "1");
+    EXPECT_EQ(node->GetAttribute("alpha"), "0.25");
+    EXPECT_EQ(node->FindAttribute("mode")->GetType(), AttributeValue::Type::STRING);
+    EXPECT_EQ(node->FindAttribute("value")->GetTensor(), value);
+    
+    Graph cloned = graph_->Clone();
+    EXPECT_EQ(*cloned.GetNodeByName("custom")->FindAttribute("axes"), *node->FindAttribute("axes"));
+    EXPECT_EQ(cloned.GetNodeByName("custom")->FindAttribute("value")->GetTensor(), value);
+    
+    const std::string path = "/tmp/test_graph_typed_attributes.ium";
+    ASSERT_TRUE(SaveCompactModel(*graph_, path).IsOk());
+    std::unique_ptr<Graph> loaded;
+    ASSERT_TRUE(LoadCompactModel(path, loaded).IsOk());
+    const Node* loaded_node = loaded->GetNodeByName("custom");
+    ASSERT_NE(loaded_node, nullptr);
+    for (const char* key : {"axes", "alpha", "scales", "mode"}) {
+        ASSERT_NE(loaded_node->FindAttribute(key), nullptr) << key;
+        EXPECT_EQ(*loaded_node->FindAttribute(key), *node->FindAttribute(key)) << key;
+    }
+    const AttributeValue* loaded_value = loaded_node->FindAttribute("value");
+    ASSERT_NE(loaded_value, nullptr);
+    ASSERT_EQ(loaded_value->GetType(), AttributeValue::Type::TENSOR);
+    ASSERT_NE(loaded_value->GetTensor(), nullptr);
+    EXPECT_EQ(loaded_value->GetTensor()->GetDataType(), DataType::INT64);
+    EXPECT_EQ(loaded_value->GetTensor()->GetShape().dims, std::vector<int64_t>({2}));
+    EXPECT_EQ(std::memcmp(loaded_value->GetTensor()->GetData(), value->GetData(), 2 * sizeof(int64_t)), 0);
+    EXPECT_EQ(HashGraph(*loaded), HashGraph(*graph_));
+    std::remove(path.c_str());
+}
+
+// 测试紧凑二进制格式：往返后结构一致，权重是映射内64字节对齐的视图，可直接加载推理
+TEST_F(GraphTest, CompactModelRoundTrip) {
+    Value* x = graph_->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({2, 4}), DataType::FLOAT32));
+    Value* w = graph_->AddValue();
+    w->SetName("w");
+    w->SetTensor(CreateTensor(Shape({4, 3}), DataType::FLOAT32));
+    float* w_data = static_cast<float*>(w->GetTensor()->GetData());
+    for (int i = 0; i < 12; ++i) {
+        w_data[i] = static_cast<float>(i);
+    }
+    Value* bias = graph_->AddValue();
+    bias->SetName("bias");
+    bias->SetTensor(CreateTensor(Shape({3}), DataType::FLOAT32));
+    float* bias_data = static_cast<float*>(bias->GetTensor()->GetData());
+    for (int i = 0; i < 3; ++i) {
+        bias_data[i] = 0.5f;
+    }
+    Value* mm = graph_->AddValue();
+    mm->SetName("mm");
+    Value* y = graph_->AddValue();
+    y->SetName("y");
+    
+    Node* matmul = graph_->AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    matmul->AddOutput(mm);
+    Node* add = graph_->AddNode("Add", "add");
+    add->SetAttribute("note", "bias add");
+    add->AddInput(mm);
+    add->AddInput(bias);
+    add->AddOutput(y);
+    graph_->AddInput(x);
+    graph_->AddOutput(y);
+    
+    const std::string path = "/tmp/test_graph_compact.ium";
+    ASSERT_TRUE(SaveCompactModel(*graph_, path).IsOk());
+    EXPECT_TRUE(IsCompactModelFile(path));
+    
+    std::unique_ptr<Graph> loaded;
+    ASSERT_TRUE(LoadCompactModel(path, loaded).IsOk());
+    ASSERT_EQ(loaded->GetNodes().size(), 2u);
+    ASSERT_EQ(loaded->GetValues().size(), 5u);
+    ASSERT_EQ(loaded->GetInputs().size(), 1u);
+    ASSERT_EQ(loaded->GetOutputs().size(), 1u);
+    EXPECT_EQ(loaded->GetInputs()[0]->GetName(), "x");
+    EXPECT_EQ(loaded->GetOutputs()[0]->GetName(), "y");
+    Node* loaded_add = loaded->GetNodeByName("add");
+    ASSERT_NE(loaded_add, nullptr);
+    EXPECT_EQ(loaded_add->GetOpType(), "Add");
+    EXPECT_EQ(loaded_add->GetAttribute("note"), "bias add");
+    ASSERT_EQ(loaded_add->GetInputs().size(), 2u);
+    EXPECT_EQ(loaded_add->GetInputs()[0]->GetProducer(), loaded->GetNodeByName("matmul"));
+    
+    for (const char* name : {"w", "bias"}) {
+        auto weight = loaded->FindValueByName(name)->GetTensor();
+        ASSERT_NE(weight, nullptr);
+        EXPECT_FALSE(weight->IsOwned());
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(weight->GetData()) % kCompactModelWeightAlignment, 0u);
+    }
+    auto loaded_w = loaded->FindValueByName("w")->GetTensor();
+    EXPECT_EQ(loaded_w->GetShape().dims, std::vector<int64_t>({4, 3}));
+    EXPECT_EQ(std::memcmp(loaded_w->GetData(), w_data, 12 * sizeof(float)), 0);
+    EXPECT_EQ(loaded->FindValueByName("x")->GetTensor()->GetShape().dims, std::vector<int64_t>({2, 4}));
+    EXPECT_EQ(loaded->FindValueByName("mm")->GetTensor(), nullptr);
+    
+    // 会话按魔数识别紧凑格式
+    auto session = InferenceSession::Create(SessionOptions());
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModel(path).IsOk());
+    auto input = CreateTensor(Shape({2, 4}), DataType::FLOAT32);
+    float* input_data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 8; ++i) {
+        input_data[i] = 1.0f;
+    }
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* result = static_cast<const float*>(outputs[0]->GetData());
+    for (int j = 0; j < 3; ++j) {
+        // 每列之和 j + (j + 3) + (j + 6) + (j + 9) 加偏置
+        EXPECT_FLOAT_EQ(result[j], 4.0f * j + 18.0f + 0.5f);
+    }
+
+    // 内存中的模型字节（没有文件映射的平台上由宿主读入）：复制到对齐的自有缓冲，源缓冲可立即释放
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        EXPECT_TRUE(IsCompactModelBuffer(bytes.data(), bytes.size()));
+        std::unique_ptr<Graph> from_memory;
+        ASSERT_TRUE(LoadCompactModelFromMemory(bytes.data(), bytes.size(), from_memory).IsOk());
+        auto memory_w = from_memory->FindValueByName("w")->GetTensor();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(memory_w->GetData()) % kCompactModelWeightAlignment, 0u);
+
+        auto memory_session = InferenceSession::Create(SessionOptions());
+        ASSERT_NE(memory_session, nullptr);
+        ASSERT_TRUE(memory_session->LoadModelFromMemory(bytes.data(), bytes.size()).IsOk());
+        bytes.assign(bytes.size(), '\0');
+        std::vector<std::shared_ptr<Tensor>> memory_outputs;
+        ASSERT_TRUE(memory_session->Run({input.get()}, memory_outputs).IsOk());
+        ASSERT_EQ(memory_outputs.size(), 1u);
+        EXPECT_EQ(std::memcmp(memory_outputs[0]->GetData(), result, 3 * sizeof(float)), 0);
+    }
+
+    // 截断的文件报错而不是越界读取
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+    }
+    std::unique_ptr<Graph> truncated;
+    EXPECT_EQ(LoadCompactModel(path, truncated).Code(), StatusCode::ERROR_INVALID_MODEL);
+    std::remove(path.c_str());
+}
+
+// 压缩的权重段：多块并行压缩与解压后逐字节一致，不可压缩的块按原样存放，文件明显变小，推理结果不变
+TEST_F(GraphTest, CompactModelCompressedWeights) {
+    const int64_t K = 256, N = 512;
+    Value* x = graph_->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({2, K}), DataType::FLOAT32));
+    Value* w = graph_->AddValue();
+    w->SetName("w");
+    w->SetTensor(CreateTensor(Shape({K, N}), DataType::FLOAT32));
+    float* w_data = static_cast<float*>(w->GetTensor()->GetData());
+    for (int64_t i = 0; i < K * N; ++i) {
+        w_data[i] = 0.25f * static_cast<float>((i * 7) % 17) - 2.0f;  // 取值很少的量化式权重
+    }
+    Value* bias = graph_->AddValue();
+    bias->SetName("bias");
+    bias->SetTensor(CreateTensor(Shape({N}), DataType::FLOAT32));
+    float* bias_data = static_cast<float*>(bias->GetTensor()->GetData());
+    uint32_t state = 12345;
+    for (int64_t i = 0; i < N; ++i) {
+        state = state * 1664525u + 1013904223u;
+        bias_data[i] = static_cast<float>(state) / 4294967296.0f;  // 近似随机，压不小
+    }
+    Value* mm = graph_->AddValue();
+    Value* y = graph_->AddValue();
+    y->SetName("y");
+    Node* matmul = graph_->AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    matmul->AddOutput(mm);
+    Node* add = graph_->AddNode("Add", "add");
+    add->AddInput(mm);
+    add->AddInput(bias);
+    add->AddOutput(y);
+    graph_->AddInput(x);
+    graph_->AddOutput(y);
+    
+    const std::string plain_path = "/tmp/test_graph_plain.ium";
+    const std::string compressed_path = "/tmp/test_graph_compressed.ium";
+    ASSERT_TRUE(SaveCompactModel(*graph_, plain_path).IsOk());
+    CompactModelSaveOptions options;
+    options.compression = WeightCompression::LZ4;
+    options.chunk_size = 64 * 1024;  // w切成8块
+    ASSERT_TRUE(SaveCompactModel(*graph_, compressed_path, options).IsOk());
+    const auto plain_size = std::filesystem::file_size(plain_path);
+    const auto compressed_size = std::filesystem::file_size(compressed_path);
+    EXPECT_LT(compressed_size * 4, plain_size);
+    
+    std::unique_ptr<Graph> loaded;
+    ASSERT_TRUE(LoadCompactModel(compressed_path, loaded).IsOk());
+    for (const auto& entry : {std::make_pair("w", w->GetTensor()), std::make_pair("bias", bias->GetTensor())}) {
+        auto weight = loaded->FindValueByName(entry.first)->GetTensor();
+        ASSERT_NE(weight, nullptr);
+        EXPECT_EQ(weight->GetShape().dims, entry.second->GetShape().dims);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(weight->GetData()) % kCompactModelWeightAlignment, 0u);
+        EXPECT_EQ(std::memcmp(weight->GetData(), entry.second->GetData(), entry.second->GetSizeInBytes()), 0)
+            << entry.first;
+    }
+    
+    auto input = CreateTensor(Shape({2, K}), DataType::FLOAT32);
+    float* input_data = static_cast<float*>(input->GetData());
+    for (int64_t i = 0; i < 2 * K; ++i) {
+        input_data[i] = std::sin(0.1f * static_cast<float>(i));
+    }
+    std::vector<std::shared_ptr<Tensor>> expected, actual;
+    for (const std::string* path : {&plain_path, &compressed_path}) {
+        auto session = InferenceSession::Create(SessionOptions());
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModel(*path).IsOk());
+        ASSERT_TRUE(session->Run({input.get()}, path == &plain_path ? expected : actual).IsOk());
+    }
+    ASSERT_EQ(actual.size(), 1u);
+    ASSERT_EQ(expected.size(), 1u);
+    EXPECT_EQ(std::memcmp(actual[0]->GetData(), expected[0]->GetData(), actual[0]->GetSizeInBytes()), 0);
+    
+    // 截断的压缩文件同样报错
+    std::filesystem::resize_file(compressed_path, compressed_size - 100);
+    std::unique_ptr<Graph> truncated;
+    EXPECT_EQ(LoadCompactModel(compressed_path, truncated).Code(), StatusCode::ERROR_INVALID_MODEL);
+    std::remove(plain_path.c_str());
+    std::remove(compressed_path.c_str());
+}
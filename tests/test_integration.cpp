@@ -4,12 +4,28 @@
 #include <gtest/gtest.h>
 #include "inferunity/engine.h"
 #include "inferunity/graph.h"
+#include "inferunity/kernel_tuning.h"
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
 #include "inferunity/optimizer.h"
 #include "inferunity/memory.h"
+#include "inferunity/metrics.h"
+#include "inferunity/batcher.h"
+#include "inferunity/batch_pipeline.h"
+#include "inferunity/model_ensemble.h"
+#include "inferunity/model_repository.h"
+#include "inferunity/model_zoo.h"
+#include "inferunity/speculative_decoding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <vector>
 #include <memory>
+#include <future>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
 
 using namespace inferunity;
 
@@ -159,6 +175,553 @@ TEST_F(IntegrationTest, BatchInference) {
     }
 }
 
+// 测试零拷贝批推理：槽位直接作为批输入，输出为合并结果的视图，且不被后续Run覆盖
+TEST_F(IntegrationTest, BatchInferenceZeroCopy) {
+    auto graph = CreateSimpleGraph();
+    graph->GetInputs()[0]->SetTensor(CreateTensor(Shape({1, 4}), DataType::FLOAT32));
+    auto session = InferenceSession::Create(SessionOptions());
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    
+    auto make_batch = [](std::vector<std::shared_ptr<Tensor>> slots, float start) {
+        std::vector<std::vector<std::shared_ptr<Tensor>>> batch;
+        for (size_t b = 0; b < slots.size(); ++b) {
+            slots[b]->FillValue(start - static_cast<float>(b));
+            batch.push_back({slots[b]});
+        }
+        return batch;
+    };
+    
+    auto slots = session->CreateBatchInputTensors(0, 3);
+    ASSERT_EQ(slots.size(), 3u);
+    std::vector<std::shared_ptr<Tensor>> separate = {session->CreateInputTensor(0), session->CreateInputTensor(0)};
+    std::vector<std::vector<std::shared_ptr<Tensor>>> outputs;
+    ASSERT_TRUE(session->RunBatchOptimized(make_batch(slots, 1.0f), outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 3u);
+    
+    // 各样本的输出相邻，共享同一块合并输出
+    const size_t sample_bytes = outputs[0][0]->GetSizeInBytes();
+    EXPECT_EQ(static_cast<const uint8_t*>(outputs[1][0]->GetData()),
+              static_cast<const uint8_t*>(outputs[0][0]->GetData()) + sample_bytes);
+    
+    // 下一次推理不覆盖已返回的结果
+    std::vector<std::vector<std::shared_ptr<Tensor>>> next;
+    ASSERT_TRUE(session->RunBatchOptimized(make_batch(slots, 5.0f), next).IsOk());
+    for (size_t b = 0; b < 3; ++b) {
+        const float* first = static_cast<const float*>(outputs[b][0]->GetData());
+        const float* second = static_cast<const float*>(next[b][0]->GetData());
+        EXPECT_FLOAT_EQ(first[0], std::max(1.0f - static_cast<float>(b), 0.0f));
+        EXPECT_FLOAT_EQ(second[0], 5.0f - static_cast<float>(b));
+    }
+    
+    // 非相邻的独立张量仍可合并执行
+    std::vector<std::vector<std::shared_ptr<Tensor>>> separate_outputs;
+    ASSERT_TRUE(session->RunBatchOptimized(make_batch(separate, 0.5f), separate_outputs).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(separate_outputs[0][0]->GetData())[0], 0.5f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(separate_outputs[1][0]->GetData())[0], 0.0f);
+}
+
+// 测试同一会话上的并发推理：各线程使用独立的执行状态，共享图和权重
+TEST_F(IntegrationTest, ConcurrentRun) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* hidden = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu1 = graph->AddNode("Relu", "relu1");
+    relu1->AddInput(input);
+    relu1->AddOutput(hidden);
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid1");
+    sigmoid->AddInput(hidden);
+    sigmoid->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({2, 8}), DataType::FLOAT32));
+    
+    SessionOptions options;
+    options.execution_state_pool_size = 2;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;  // 保留中间张量
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_TRUE(session->SupportsConcurrentRun());
+    // 中间张量进入arena，每个执行状态持有自己的一份
+    EXPECT_EQ(session->GetMemoryPlan().entries.size(), 1u);
+    
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 50;
+    std::vector<int> failures(kThreads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int it = 0; it < kIterations; ++it) {
+                auto tensor = CreateTensor(Shape({2, 8}), DataType::FLOAT32);
+                float* data = static_cast<float*>(tensor->GetData());
+                for (int i = 0; i < 16; ++i) {
+                    data[i] = static_cast<float>(t * 100 + it * 16 + i) * (i % 2 ? 0.001f : -0.001f);
+                }
+                std::vector<std::shared_ptr<Tensor>> outputs;
+                if (!session->Run({tensor.get()}, outputs).IsOk() || outputs.size() != 1) {
+                    ++failures[t];
+                    continue;
+                }
+                const float* result = static_cast<const float*>(outputs[0]->GetData());
+                for (int i = 0; i < 16; ++i) {
+                    const float expected = 1.0f / (1.0f + std::exp(-std::max(data[i], 0.0f)));
+                    if (std::fabs(result[i] - expected) > 1e-4f) {
+                        ++failures[t];
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (int t = 0; t < kThreads; ++t) {
+        EXPECT_EQ(failures[t], 0) << "thread " << t;
+    }
+    
+    // 空闲状态放回池中复用，不超过池大小
+    EXPECT_GE(session->GetNumIdleExecutionStates(), 1u);
+    EXPECT_LE(session->GetNumIdleExecutionStates(), 2u);
+    
+    // 串行接口仍然可用
+    auto tensor = CreateTensor(Shape({2, 8}), DataType::FLOAT32);
+    tensor->FillValue(-3.0f);
+    std::vector<Tensor*> outputs;
+    ASSERT_TRUE(session->Run({tensor.get()}, outputs).IsOk());
+    EXPECT_NEAR(static_cast<const float*>(outputs[0]->GetData())[0], 0.5f, 1e-4f);
+}
+
+// 测试并发运行共享同一个节点的算子实例：各线程的输入形状不同（卷积计划与工作区、注意力的分块缓冲都按形状变化），
+// 结果与串行运行一致
+TEST_F(IntegrationTest, ConcurrentRunWithDifferentShapes) {
+    auto fill = [](const std::shared_ptr<Tensor>& tensor, int seed) {
+        float* data = static_cast<float*>(tensor->GetData());
+        for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+            data[i] = static_cast<float>((static_cast<int>(i) * 7 + seed * 13) % 23 - 11) * 0.05f;
+        }
+        return tensor;
+    };
+    constexpr int64_t kChannels = 4;
+    constexpr int64_t kFilters = 8;
+    constexpr int64_t kDim = 8;
+    
+    auto graph = std::make_unique<Graph>();
+    auto dynamic_input = [&](const std::string& name, Shape shape) {
+        Value* value = graph->AddValue();
+        value->SetName(name);
+        value->SetTensor(std::make_shared<Tensor>(shape, DataType::FLOAT32, nullptr));
+        graph->AddInput(value);
+        return value;
+    };
+    Shape image_shape({1, kChannels, -1, -1}, {false, false, true, true});
+    image_shape.symbols = {"", "", "height", "width"};
+    Value* image = dynamic_input("image", image_shape);
+    Shape sequence_shape({1, -1, kDim}, {false, true, false});
+    sequence_shape.symbols = {"", "length", ""};
+    Value* q = dynamic_input("q", sequence_shape);
+    Value* k = dynamic_input("k", sequence_shape);
+    Value* v = dynamic_input("v", sequence_shape);
+    
+    // 两个卷积：im2col与自动选择（3x3 stride 1时为Winograd）
+    std::vector<Value*> outputs;
+    for (const char* algorithm : {"im2col", "auto"}) {
+        Value* weight = graph->AddValue();
+        weight->SetTensor(fill(CreateTensor(Shape({kFilters, kChannels, 3, 3}), DataType::FLOAT32), kFilters));
+        Value* output = graph->AddValue();
+        Node* conv = graph->AddNode("Conv", std::string("conv_") + algorithm);
+        conv->AddInput(image);
+        conv->AddInput(weight);
+        conv->AddOutput(output);
+        conv->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+        conv->SetAttribute("conv_algorithm", AttributeValue(std::string(algorithm)));
+        graph->AddOutput(output);
+        outputs.push_back(output);
+    }
+    // 两个因果注意力：不带与带RoPE（旋转后的K放在暂存区）
+    constexpr int64_t kPositions = 64;
+    std::vector<float> angles(kPositions * kDim / 2);
+    for (int64_t p = 0; p < kPositions; ++p) {
+        for (int64_t i = 0; i < kDim / 2; ++i) {
+            angles[p * kDim / 2 + i] = static_cast<float>(p) * std::pow(10000.0f, -2.0f * i / kDim);
+        }
+    }
+    auto rotary_table = [&](float (*fn)(float)) {
+        auto table = CreateTensor(Shape({kPositions, kDim / 2}), DataType::FLOAT32);
+        float* data = static_cast<float*>(table->GetData());
+        for (size_t i = 0; i < angles.size(); ++i) {
+            data[i] = fn(angles[i]);
+        }
+        Value* value = graph->AddValue();
+        value->SetTensor(table);
+        return value;
+    };
+    for (bool rotary : {false, true}) {
+        Value* attended = graph->AddValue();
+        Node* attention = graph->AddNode("FusedAttention", rotary ? "attention_rope" : "attention");
+        attention->AddInput(q);
+        attention->AddInput(k);
+        attention->AddInput(v);
+        if (rotary) {
+            attention->AddInput(rotary_table([](float x) { return std::cos(x); }));
+            attention->AddInput(rotary_table([](float x) { return std::sin(x); }));
+            attention->SetAttribute("rotary", AttributeValue(static_cast<int64_t>(1)));
+        }
+        attention->AddOutput(attended);
+        attention->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+        graph->AddOutput(attended);
+    }
+    
+    SessionOptions options;
+    options.execution_state_pool_size = 4;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_TRUE(session->SupportsConcurrentRun());
+    
+    // 每个线程一种形状与输入，先串行运行得到参考结果
+    constexpr int kThreads = 6;
+    constexpr int kIterations = 50;
+    const int64_t sizes[] = {5, 12, 23};
+    std::vector<std::vector<std::shared_ptr<Tensor>>> inputs(kThreads);
+    std::vector<std::vector<std::vector<float>>> expected(kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+        const int64_t size = sizes[t % 3];
+        const int64_t length = 3 + 17 * (t % 3) + t;
+        inputs[t] = {fill(CreateTensor(Shape({1, kChannels, size, size + t}), DataType::FLOAT32), t),
+                     fill(CreateTensor(Shape({1, length, kDim}), DataType::FLOAT32), t + 1),
+                     fill(CreateTensor(Shape({1, length, kDim}), DataType::FLOAT32), t + 2),
+                     fill(CreateTensor(Shape({1, length, kDim}), DataType::FLOAT32), t + 3)};
+        std::vector<std::shared_ptr<Tensor>> results;
+        ASSERT_TRUE(session->Run({inputs[t][0].get(), inputs[t][1].get(), inputs[t][2].get(), inputs[t][3].get()},
+                                 results).IsOk());
+        ASSERT_EQ(results.size(), 4u);
+        for (const auto& result : results) {
+            const float* data = static_cast<const float*>(result->GetData());
+            expected[t].emplace_back(data, data + result->GetElementCount());
+        }
+    }
+    
+    std::vector<int> failures(kThreads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int it = 0; it < kIterations; ++it) {
+                std::vector<std::shared_ptr<Tensor>> results;
+                if (!session->Run({inputs[t][0].get(), inputs[t][1].get(), inputs[t][2].get(), inputs[t][3].get()},
+                                  results).IsOk() || results.size() != expected[t].size()) {
+                    ++failures[t];
+                    continue;
+                }
+                for (size_t o = 0; o < results.size(); ++o) {
+                    const float* data = static_cast<const float*>(results[o]->GetData());
+                    if (results[o]->GetElementCount() != expected[t][o].size() ||
+                        !std::equal(expected[t][o].begin(), expected[t][o].end(), data)) {
+                        ++failures[t];
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (int t = 0; t < kThreads; ++t) {
+        EXPECT_EQ(failures[t], 0) << "thread " << t;
+    }
+}
+
+// 测试异步推理：线程池执行、回调完成、在途上限
+TEST_F(IntegrationTest, AsyncRunWithBackpressure) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({1, 4}), DataType::FLOAT32));
+    
+    SessionOptions options;
+    options.max_inflight_async_runs = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    
+    auto make_input = [](float value) {
+        auto tensor = CreateTensor(Shape({1, 4}), DataType::FLOAT32);
+        tensor->FillValue(value);
+        return tensor;
+    };
+    
+    // 两个回调阻塞时在途运行已满，第三个请求被拒绝而不是排队
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::mutex mutex;
+    std::vector<float> results;
+    for (float value : {1.0f, -2.0f}) {
+        Status status = session->RunAsync({make_input(value)},
+            [&, released](Status run_status, std::vector<std::shared_ptr<Tensor>> outputs) {
+                released.wait();
+                std::lock_guard<std::mutex> lock(mutex);
+                results.push_back(run_status.IsOk() && outputs.size() == 1
+                    ? static_cast<const float*>(outputs[0]->GetData())[3] : -1.0f);
+            });
+        ASSERT_TRUE(status.IsOk());
+    }
+    EXPECT_EQ(session->GetNumInflightRuns(), 2u);
+    EXPECT_EQ(session->RunAsync({make_input(3.0f)}, [](Status, std::vector<std::shared_ptr<Tensor>>) {}).Code(),
+              StatusCode::ERROR_RESOURCE_EXHAUSTED);
+    auto rejected = session->RunAsync({make_input(3.0f)});
+    EXPECT_EQ(rejected.get().status.Code(), StatusCode::ERROR_RESOURCE_EXHAUSTED);
+    
+    release.set_value();
+    session->WaitForAsyncRuns();
+    EXPECT_EQ(session->GetNumInflightRuns(), 0u);
+    std::sort(results.begin(), results.end());
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_FLOAT_EQ(results[0], 0.0f);
+    EXPECT_FLOAT_EQ(results[1], 1.0f);
+    
+    // future形式：调用方不再持有输入
+    auto future = session->RunAsync({make_input(5.0f)});
+    RunResult result = future.get();
+    ASSERT_TRUE(result.status.IsOk());
+    ASSERT_EQ(result.outputs.size(), 1u);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(result.outputs[0]->GetData())[0], 5.0f);
+    
+    // 旧接口：输入向量在返回后即可销毁
+    auto legacy_input = make_input(-1.0f);
+    std::vector<Tensor*> legacy_outputs;
+    std::future<Status> legacy;
+    {
+        std::vector<Tensor*> inputs = {legacy_input.get()};
+        legacy = session->RunAsync(inputs, legacy_outputs);
+    }
+    ASSERT_TRUE(legacy.get().IsOk());
+    ASSERT_EQ(legacy_outputs.size(), 1u);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(legacy_outputs[0]->GetData())[0], 0.0f);
+}
+
+// 测试IOBinding：结果直接写入调用方绑定的缓冲，跨运行复用
+TEST_F(IntegrationTest, IOBindingPreallocatedBuffers) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* hidden = graph->AddValue();
+    Value* output = graph->AddValue();
+    input->SetName("x");
+    output->SetName("y");
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(input);
+    relu->AddOutput(hidden);
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid1");
+    sigmoid->AddInput(hidden);
+    sigmoid->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({2, 4}), DataType::FLOAT32));
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    
+    auto binding = session->CreateIOBinding();
+    auto x = CreateTensor(Shape({2, 4}), DataType::FLOAT32);
+    auto y = CreateTensor(Shape({2, 4}), DataType::FLOAT32);
+    ASSERT_TRUE(binding->BindInput("x", x).IsOk());
+    ASSERT_TRUE(binding->BindOutput("y", y).IsOk());
+    EXPECT_EQ(binding->BindInput("missing", x).Code(), StatusCode::ERROR_NOT_FOUND);
+    EXPECT_FALSE(binding->BindInput("x", CreateTensor(Shape({2, 4}), DataType::INT64)).IsOk());
+    EXPECT_FALSE(binding->BindInput("x", CreateTensor(Shape({8}), DataType::FLOAT32)).IsOk());
+    
+    float* x_data = static_cast<float*>(x->GetData());
+    const float* y_data = static_cast<const float*>(y->GetData());
+    for (float scale : {1.0f, 2.0f}) {
+        for (int i = 0; i < 8; ++i) {
+            x_data[i] = scale * static_cast<float>(i - 4);
+        }
+        ASSERT_TRUE(session->Run(*binding).IsOk());
+        // 结果写在绑定的缓冲里，没有另行分配
+        EXPECT_EQ(binding->GetOutput("y"), y);
+        for (int i = 0; i < 8; ++i) {
+            EXPECT_NEAR(y_data[i], 1.0f / (1.0f + std::exp(-std::max(x_data[i], 0.0f))), 1e-5f);
+        }
+    }
+    
+    // 缓冲形状与推断结果不符时在写入前报错
+    auto wrong = CreateTensor(Shape({3, 4}), DataType::FLOAT32);
+    wrong->FillValue(7.0f);
+    ASSERT_TRUE(binding->BindOutput("y", wrong).IsOk());
+    EXPECT_EQ(session->Run(*binding).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(wrong->GetData())[0], 7.0f);
+    
+    // 未绑定的输出由会话分配
+    binding->ClearBoundOutputs();
+    ASSERT_TRUE(session->Run(*binding).IsOk());
+    auto allocated = binding->GetOutput("y");
+    ASSERT_NE(allocated, nullptr);
+    EXPECT_NE(allocated, y);
+    EXPECT_NEAR(static_cast<const float*>(allocated->GetData())[7], 1.0f / (1.0f + std::exp(-6.0f)), 1e-5f);
+    
+    // 缺少输入
+    binding->ClearBoundInputs();
+    EXPECT_FALSE(session->Run(*binding).IsOk());
+}
+
+// 测试流式推理：状态（这里是累加和）由会话持有并在块之间延续，调用方只传入新的块
+TEST_F(IntegrationTest, StreamingSessionState) {
+    auto build_graph = []() {
+        auto graph = std::make_unique<Graph>();
+        Value* chunk = graph->AddValue();
+        Value* state = graph->AddValue();
+        Value* state_out = graph->AddValue();
+        Value* output = graph->AddValue();
+        chunk->SetName("chunk");
+        state->SetName("cache");
+        state_out->SetName("cache_out");
+        output->SetName("y");
+        Node* add = graph->AddNode("Add", "accumulate");
+        add->AddInput(state);
+        add->AddInput(chunk);
+        add->AddOutput(state_out);
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(state_out);
+        relu->AddOutput(output);
+        graph->AddInput(chunk);
+        graph->AddInput(state);
+        graph->AddOutput(output);
+        graph->AddOutput(state_out);
+        chunk->SetTensor(CreateTensor(Shape({1, 4}), DataType::FLOAT32));
+        state->SetTensor(CreateTensor(Shape({1, 4}), DataType::FLOAT32));
+        return graph;
+    };
+    
+    SessionOptions options;
+    options.streaming_states = {{"cache", "cache_out"}};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(build_graph()).IsOk());
+    
+    auto chunk = CreateTensor(Shape({1, 4}), DataType::FLOAT32);
+    float* chunk_data = static_cast<float*>(chunk->GetData());
+    for (int i = 0; i < 4; ++i) chunk_data[i] = static_cast<float>(i);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    for (int step = 1; step <= 3; ++step) {
+        ASSERT_TRUE(session->RunStreaming({chunk.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);  // 只有非状态输出
+        const float* y = static_cast<const float*>(outputs[0]->GetData());
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_FLOAT_EQ(y[i], static_cast<float>(step * i));
+        }
+    }
+    auto state = session->GetStreamingState("cache");
+    ASSERT_NE(state, nullptr);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(state->GetData())[3], 9.0f);
+    
+    // 状态在块之间原地交换，不重新分配
+    ASSERT_TRUE(session->RunStreaming({chunk.get()}, outputs).IsOk());
+    ASSERT_TRUE(session->RunStreaming({chunk.get()}, outputs).IsOk());
+    EXPECT_EQ(session->GetStreamingState("cache"), state);
+    
+    // 重置后从零开始；SetStreamingState给出初始上下文
+    ASSERT_TRUE(session->ResetStreamingState().IsOk());
+    ASSERT_TRUE(session->RunStreaming({chunk.get()}, outputs).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outputs[0]->GetData())[2], 2.0f);
+    auto initial = CreateTensor(Shape({1, 4}), DataType::FLOAT32);
+    ASSERT_TRUE(initial->FillValue(-10.0f).IsOk());
+    ASSERT_TRUE(session->SetStreamingState("cache", *initial).IsOk());
+    ASSERT_TRUE(session->RunStreaming({chunk.get()}, outputs).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outputs[0]->GetData())[3], 0.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(session->GetStreamingState("cache")->GetData())[3], -7.0f);
+    
+    // 输入个数不符时报错且状态不变
+    EXPECT_EQ(session->RunStreaming({chunk.get(), chunk.get()}, outputs).Code(),
+              StatusCode::ERROR_INVALID_ARGUMENT);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(session->GetStreamingState("cache")->GetData())[3], -7.0f);
+    EXPECT_EQ(session->SetStreamingState("missing", *initial).Code(), StatusCode::ERROR_NOT_FOUND);
+    
+    // 状态名不存在或未配置状态时报错
+    SessionOptions bad_options;
+    bad_options.streaming_states = {{"cache", "no_such_output"}};
+    auto bad = InferenceSession::Create(bad_options);
+    ASSERT_TRUE(bad->LoadModelFromGraph(build_graph()).IsOk());
+    EXPECT_EQ(bad->RunStreaming({chunk.get()}, outputs).Code(), StatusCode::ERROR_NOT_FOUND);
+    auto plain = InferenceSession::Create(SessionOptions());
+    ASSERT_TRUE(plain->LoadModelFromGraph(build_graph()).IsOk());
+    EXPECT_FALSE(plain->RunStreaming({chunk.get()}, outputs).IsOk());
+}
+
+// 测试只计算部分输出：未请求的分支不执行，裁剪后的计划按输出集合缓存
+TEST_F(IntegrationTest, RunRequestedOutputsOnly) {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    Value* embedding = graph->AddValue();
+    Value* hidden = graph->AddValue();
+    Value* logits = graph->AddValue();
+    x->SetName("x");
+    embedding->SetName("embedding");
+    logits->SetName("logits");
+    Node* relu = graph->AddNode("Relu", "embed");
+    relu->AddInput(x);
+    relu->AddOutput(embedding);
+    Node* tanh1 = graph->AddNode("Tanh", "head1");
+    tanh1->AddInput(embedding);
+    tanh1->AddOutput(hidden);
+    Node* tanh2 = graph->AddNode("Tanh", "head2");
+    tanh2->AddInput(hidden);
+    tanh2->AddOutput(logits);
+    graph->AddInput(x);
+    graph->AddOutput(embedding);
+    graph->AddOutput(logits);
+    x->SetTensor(CreateTensor(Shape({2, 8}), DataType::FLOAT32));
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    
+    auto input = CreateTensor(Shape({2, 8}), DataType::FLOAT32);
+    float* data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 16; ++i) data[i] = static_cast<float>(i - 8) * 0.25f;
+    
+    const OpMetrics* tanh_metrics = GetOpMetrics("Tanh");
+    const uint64_t tanh_before = tanh_metrics->executions->Value();
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    for (int run = 0; run < 3; ++run) {
+        ASSERT_TRUE(session->Run({input.get()}, {"embedding"}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        for (int i = 0; i < 16; ++i) {
+            EXPECT_FLOAT_EQ(out[i], std::max(data[i], 0.0f));
+        }
+    }
+    EXPECT_EQ(tanh_metrics->executions->Value(), tanh_before);
+    EXPECT_EQ(session->GetNumPrunedPlans(), 1u);
+    
+    // 输出按请求的顺序
+    ASSERT_TRUE(session->Run({input.get()}, {"logits", "embedding"}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 2u);
+    EXPECT_EQ(tanh_metrics->executions->Value(), tanh_before + 2);
+    const float* head = static_cast<const float*>(outputs[0]->GetData());
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_NEAR(head[i], std::tanh(std::tanh(std::max(data[i], 0.0f))), 1e-5f);
+    }
+    EXPECT_EQ(session->GetNumPrunedPlans(), 2u);
+    
+    // 为空时计算全部输出；未知的输出名报错
+    ASSERT_TRUE(session->Run({input.get()}, std::vector<std::string>(), outputs).IsOk());
+    EXPECT_EQ(outputs.size(), 2u);
+    EXPECT_EQ(session->Run({input.get()}, {"missing"}, outputs).Code(), StatusCode::ERROR_NOT_FOUND);
+}
+
 // 测试内存管理
 TEST_F(IntegrationTest, MemoryManagement) {
     auto graph = CreateSimpleGraph();
@@ -182,3 +745,1127 @@ TEST_F(IntegrationTest, MemoryManagement) {
     EXPECT_GE(stats_after.allocated_bytes, stats_before.allocated_bytes);
 }
 
+
+namespace {
+
+// 单头数据的注意力参考实现：q [S, D]，k/v [T, D]，无mask
+std::vector<float> ReferenceAttention(const std::vector<float>& q, const std::vector<float>& k,
+                                      const std::vector<float>& v, int64_t D) {
+    const int64_t S = static_cast<int64_t>(q.size()) / D;
+    const int64_t T = static_cast<int64_t>(k.size()) / D;
+    std::vector<float> out(S * D, 0.0f);
+    for (int64_t i = 0; i < S; ++i) {
+        std::vector<float> p(T);
+        float max_score = -1e30f, sum = 0.0f;
+        for (int64_t j = 0; j < T; ++j) {
+            for (int64_t d = 0; d < D; ++d) p[j] += q[i * D + d] * k[j * D + d];
+            max_score = std::max(max_score, p[j]);
+        }
+        for (float& x : p) sum += (x = std::exp(x - max_score));
+        for (int64_t j = 0; j < T; ++j) {
+            for (int64_t d = 0; d < D; ++d) out[i * D + d] += p[j] / sum * v[j * D + d];
+        }
+    }
+    return out;
+}
+
+std::vector<float> Sequence(size_t count, float start) {
+    std::vector<float> data(count);
+    for (size_t i = 0; i < count; ++i) data[i] = std::sin(start + 0.37f * i);
+    return data;
+}
+
+} // anonymous namespace
+
+// 测试KV cache：present = Concat(past, new)的注意力层改写为会话持有的缓冲，逐token追加、截断与复制序列
+TEST_F(IntegrationTest, KVCacheDecoding) {
+    const int64_t D = 8;
+    auto graph = std::make_unique<Graph>();
+    auto add_input = [&](const std::string& name, const Shape& shape) {
+        Value* value = graph->AddValue();
+        value->SetName(name);
+        value->SetTensor(CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU));
+        graph->AddInput(value);
+        return value;
+    };
+    auto add_node = [&](const std::string& op, const std::vector<Value*>& inputs, const Shape& shape,
+                        const std::vector<std::pair<std::string, std::string>>& attrs = {}) {
+        Node* node = graph->AddNode(op, op + std::to_string(graph->GetNodes().size()));
+        for (const auto& attr : attrs) node->SetAttribute(attr.first, attr.second);
+        for (Value* input : inputs) node->AddInput(input);
+        Value* output = graph->AddValue();
+        output->SetTensor(CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU));
+        node->AddOutput(output);
+        return output;
+    };
+    Value* q = add_input("q", Shape({1, 1, 3, D}));
+    Value* k = add_input("k", Shape({1, 1, 3, D}));
+    Value* v = add_input("v", Shape({1, 1, 3, D}));
+    Value* past_k = add_input("past_key", Shape({1, 1, 2, D}));
+    Value* past_v = add_input("past_value", Shape({1, 1, 2, D}));
+    Value* present_k = add_node("Concat", {past_k, k}, Shape({1, 1, 5, D}), {{"axis", "2"}});
+    Value* present_v = add_node("Concat", {past_v, v}, Shape({1, 1, 5, D}), {{"axis", "2"}});
+    Value* kt = add_node("Transpose", {present_k}, Shape({1, 1, D, 5}), {{"perm", "0,1,3,2"}});
+    Value* scores = add_node("MatMul", {q, kt}, Shape({1, 1, 3, 5}));
+    Value* probs = add_node("Softmax", {scores}, Shape({1, 1, 3, 5}), {{"axis", "-1"}});
+    Value* y = add_node("MatMul", {probs, present_v}, Shape({1, 1, 3, D}));
+    y->SetName("y");
+    present_k->SetName("present_key");
+    present_v->SetName("present_value");
+    graph->AddOutput(y);
+    graph->AddOutput(present_k);
+    graph->AddOutput(present_v);
+    
+    SessionOptions options;
+    options.enable_kv_cache = true;
+    options.kv_cache_max_sequence_length = 16;
+    options.max_batch_size = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    KVCache* cache = session->GetKVCache();
+    ASSERT_NE(cache, nullptr);
+    ASSERT_EQ(cache->GetNumLayers(), 1u);
+    EXPECT_EQ(cache->GetLayer(0).past_key_name, "past_key");
+    EXPECT_EQ(cache->GetLayer(0).present_value_name, "present_value");
+    EXPECT_EQ(session->GetInputNames(), (std::vector<std::string>{"q", "k", "v"}));
+    EXPECT_EQ(session->GetOutputNames(), (std::vector<std::string>{"y"}));
+    
+    std::vector<float> all_k, all_v;
+    auto step = [&](int64_t tokens, float seed, std::vector<float>* q_out) {
+        *q_out = Sequence(tokens * D, seed);
+        const auto k_new = Sequence(tokens * D, seed + 1.0f);
+        const auto v_new = Sequence(tokens * D, seed + 2.0f);
+        all_k.insert(all_k.end(), k_new.begin(), k_new.end());
+        all_v.insert(all_v.end(), v_new.begin(), v_new.end());
+        auto make = [&](const std::vector<float>& data) {
+            auto tensor = CreateTensor(Shape({1, 1, tokens, D}), DataType::FLOAT32, DeviceType::CPU);
+            std::copy(data.begin(), data.end(), static_cast<float*>(tensor->GetData()));
+            return tensor;
+        };
+        auto tq = make(*q_out), tk = make(k_new), tv = make(v_new);
+        std::vector<Tensor*> inputs = {tq.get(), tk.get(), tv.get()};
+        std::vector<Tensor*> outputs;
+        EXPECT_TRUE(session->Run(inputs, outputs).IsOk());
+        EXPECT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        return std::vector<float>(out, out + tokens * D);
+    };
+    auto expect_matches = [&](const std::vector<float>& actual, const std::vector<float>& q_rows) {
+        const auto expected = ReferenceAttention(q_rows, all_k, all_v, D);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) EXPECT_NEAR(actual[i], expected[i], 1e-4f);
+    };
+    
+    // prefill 3个位置，再逐个解码2个位置
+    std::vector<float> q_rows;
+    expect_matches(step(3, 0.0f, &q_rows), q_rows);
+    EXPECT_EQ(cache->GetSequenceLength(0), 3);
+    for (int i = 0; i < 2; ++i) {
+        expect_matches(step(1, 10.0f * (i + 1), &q_rows), q_rows);
+    }
+    EXPECT_EQ(cache->GetSequenceLength(0), 5);
+    
+    // 回退最后一个位置后重新生成
+    ASSERT_TRUE(cache->Trim(0, 4).IsOk());
+    all_k.resize(4 * D);
+    all_v.resize(4 * D);
+    expect_matches(step(1, 42.0f, &q_rows), q_rows);
+    EXPECT_EQ(cache->GetSequenceLength(0), 5);
+    EXPECT_FALSE(cache->Trim(0, 6).IsOk());
+    
+    // 复制到序列1：长度与缓冲内容一致
+    ASSERT_TRUE(cache->Fork(0, 1).IsOk());
+    EXPECT_EQ(cache->GetSequenceLength(1), 5);
+    const float* key = static_cast<const float*>(cache->GetLayer(0).key->GetData());
+    for (int64_t i = 0; i < 5 * D; ++i) {
+        EXPECT_EQ(key[16 * D + i], key[i]);
+    }
+    EXPECT_FALSE(cache->Fork(0, 2).IsOk());
+    
+    cache->Reset();
+    EXPECT_EQ(cache->GetSequenceLength(0), 0);
+    all_k.clear();
+    all_v.clear();
+    expect_matches(step(2, 7.0f, &q_rows), q_rows);
+}
+
+namespace {
+
+// 单层单头的小语言模型：input_ids [1, S] -> Gather(embedding) -> Q/K/V投影 -> [1, 1, S, D] ->
+// Concat(past, new)的因果FusedAttention -> 输出投影 -> logits [1, S, vocab]；weight_seed区分目标与draft模型
+std::unique_ptr<Graph> BuildTinyLanguageModel(int64_t vocab, float weight_seed) {
+    const int64_t D = 8;
+    auto graph = std::make_unique<Graph>();
+    auto add_input = [&](const std::string& name, const Shape& shape, DataType dtype) {
+        Value* value = graph->AddValue();
+        value->SetName(name);
+        value->SetTensor(CreateTensor(shape, dtype, DeviceType::CPU));
+        graph->AddInput(value);
+        return value;
+    };
+    auto constant = [&](const Shape& shape, float seed) {
+        auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        const auto data = Sequence(tensor->GetElementCount(), seed);
+        std::copy(data.begin(), data.end(), static_cast<float*>(tensor->GetData()));
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto shape = [&](const std::vector<int64_t>& dims) {
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(dims.size())}), DataType::INT64, DeviceType::CPU);
+        std::copy(dims.begin(), dims.end(), static_cast<int64_t*>(tensor->GetData()));
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto apply = [&](const std::string& op, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op, op + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) node->AddInput(input);
+        Value* output = graph->AddValue();
+        output->SetName(node->GetName() + "_out");
+        node->AddOutput(output);
+        return output;
+    };
+    Value* ids = add_input("input_ids", Shape({1, 3}), DataType::INT64);
+    Value* past_k = add_input("past_key", Shape({1, 1, 2, D}), DataType::FLOAT32);
+    Value* past_v = add_input("past_value", Shape({1, 1, 2, D}), DataType::FLOAT32);
+    Value* x = apply("Gather", {constant(Shape({vocab, D}), weight_seed), ids});
+    auto head = [&](float seed) {
+        return apply("Reshape", {apply("MatMul", {x, constant(Shape({D, D}), weight_seed + seed)}),
+                                 shape({1, 1, -1, D})});
+    };
+    Value* q = head(3.0f);
+    Value* present_k = apply("Concat", {past_k, head(5.0f)});
+    Value* present_v = apply("Concat", {past_v, head(7.0f)});
+    for (Value* present : {present_k, present_v}) {
+        present->GetProducer()->SetAttribute("axis", AttributeValue(static_cast<int64_t>(2)));
+    }
+    Value* context = apply("FusedAttention", {q, present_k, present_v});
+    context->GetProducer()->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+    Value* logits = apply("MatMul", {apply("Reshape", {context, shape({1, -1, D})}),
+                                     constant(Shape({D, vocab}), weight_seed + 11.0f)});
+    logits->SetName("logits");
+    present_k->SetName("present_key");
+    present_v->SetName("present_value");
+    graph->AddOutput(logits);
+    graph->AddOutput(present_k);
+    graph->AddOutput(present_v);
+    return graph;
+}
+
+std::unique_ptr<InferenceSession> CreateLanguageModelSession(int64_t vocab, float weight_seed) {
+    SessionOptions options;
+    options.enable_kv_cache = true;
+    options.kv_cache_max_sequence_length = 32;
+    options.max_batch_size = 1;
+    auto session = InferenceSession::Create(options);
+    if (session && !session->LoadModelFromGraph(BuildTinyLanguageModel(vocab, weight_seed)).IsOk()) {
+        session.reset();
+    }
+    return session;
+}
+
+} // anonymous namespace
+
+// 测试投机解码：贪心时输出与目标模型逐token贪心解码一致；draft与目标相同时全部接受，
+// 每轮产生k + 1个token；接受-拒绝采样的输出服从目标分布
+TEST_F(IntegrationTest, SpeculativeDecoding) {
+    const int64_t vocab = 11;
+    auto target = CreateLanguageModelSession(vocab, 0.0f);
+    auto draft = CreateLanguageModelSession(vocab, 0.05f);
+    auto same = CreateLanguageModelSession(vocab, 0.0f);
+    ASSERT_NE(target, nullptr);
+    ASSERT_NE(draft, nullptr);
+    ASSERT_NE(same, nullptr);
+    ASSERT_EQ(target->GetInputNames(), std::vector<std::string>{"input_ids"});
+    const std::vector<int64_t> prompt = {1, 4, 7};
+    
+    // 参考：目标模型每次前向一个token
+    std::vector<int64_t> expected;
+    {
+        KVCache* cache = target->GetKVCache();
+        ASSERT_NE(cache, nullptr);
+        cache->Reset();
+        std::vector<int64_t> feed = prompt;
+        while (expected.size() < 12) {
+            auto ids = CreateTensor(Shape({1, static_cast<int64_t>(feed.size())}), DataType::INT64, DeviceType::CPU);
+            std::copy(feed.begin(), feed.end(), static_cast<int64_t*>(ids->GetData()));
+            std::vector<Tensor*> inputs = {ids.get()}, outputs;
+            ASSERT_TRUE(target->Run(inputs, outputs).IsOk());
+            const float* row = static_cast<const float*>(outputs[0]->GetData()) + (feed.size() - 1) * vocab;
+            expected.push_back(std::max_element(row, row + vocab) - row);
+            feed.assign(1, expected.back());
+        }
+    }
+    
+    SpeculativeDecodingOptions options;
+    options.num_draft_tokens = 3;
+    options.max_new_tokens = 12;
+    std::vector<int64_t> generated;
+    SpeculativeDecoder decoder(target.get(), draft.get(), options);
+    ASSERT_TRUE(decoder.Generate(prompt, &generated).IsOk());
+    EXPECT_EQ(generated, expected);
+    EXPECT_EQ(decoder.GetStats().num_generated, 12u);
+    EXPECT_GT(decoder.GetStats().num_proposed, 0u);
+    // 部分接受：每轮平均产生多于一个token
+    EXPECT_GT(decoder.GetStats().num_accepted, 0u);
+    EXPECT_LT(decoder.GetStats().num_rounds, 12u);
+    // 再次生成时从头开始
+    ASSERT_TRUE(decoder.Generate(prompt, &generated).IsOk());
+    EXPECT_EQ(generated, expected);
+    
+    SpeculativeDecoder self_draft(target.get(), same.get(), options);
+    ASSERT_TRUE(self_draft.Generate(prompt, &generated).IsOk());
+    EXPECT_EQ(generated, expected);
+    EXPECT_DOUBLE_EQ(self_draft.GetStats().GetAcceptanceRate(), 1.0);
+    EXPECT_EQ(self_draft.GetStats().num_rounds, 3u);
+    EXPECT_EQ(target->GetKVCache()->GetSequenceLength(0), static_cast<int64_t>(prompt.size()) + 11);
+    
+    // 带温度采样时相同的模型同样全部接受
+    options.temperature = 0.8f;
+    options.seed = 7;
+    SpeculativeDecoder sampling(target.get(), same.get(), options);
+    ASSERT_TRUE(sampling.Generate(prompt, &generated).IsOk());
+    ASSERT_EQ(generated.size(), 12u);
+    for (int64_t token : generated) {
+        EXPECT_TRUE(token >= 0 && token < vocab);
+    }
+    EXPECT_DOUBLE_EQ(sampling.GetStats().GetAcceptanceRate(), 1.0);
+    
+    // eos提前结束；没有KV cache的会话被拒绝
+    options.temperature = 0.0f;
+    options.eos_token = expected[4];
+    SpeculativeDecoder eos(target.get(), draft.get(), options);
+    ASSERT_TRUE(eos.Generate(prompt, &generated).IsOk());
+    const size_t eos_index = std::find(expected.begin(), expected.end(), expected[4]) - expected.begin();
+    EXPECT_EQ(generated, std::vector<int64_t>(expected.begin(), expected.begin() + eos_index + 1));
+    auto plain = InferenceSession::Create(SessionOptions());
+    ASSERT_NE(plain, nullptr);
+    EXPECT_FALSE(SpeculativeDecoder(target.get(), plain.get(), options).Generate(prompt, &generated).IsOk());
+    
+    // x ~ q经接受-拒绝后的分布为p
+    const std::vector<float> p = {0.5f, 0.3f, 0.15f, 0.05f, 0.0f};
+    const std::vector<float> q = {0.1f, 0.2f, 0.3f, 0.3f, 0.1f};
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::discrete_distribution<int64_t> draw(q.begin(), q.end());
+    const int samples = 200000;
+    std::vector<int> counts(p.size(), 0);
+    int accepted = 0;
+    for (int i = 0; i < samples; ++i) {
+        int64_t token = -1;
+        const float u = uniform(rng);
+        accepted += SpeculativeAcceptToken(p, q, draw(rng), u, uniform(rng), &token) ? 1 : 0;
+        ASSERT_TRUE(token >= 0 && token < static_cast<int64_t>(p.size()));
+        ++counts[token];
+    }
+    for (size_t i = 0; i < p.size(); ++i) {
+        EXPECT_NEAR(static_cast<double>(counts[i]) / samples, p[i], 0.01) << "token " << i;
+    }
+    // 接受率为sum(min(p, q))
+    EXPECT_NEAR(static_cast<double>(accepted) / samples, 0.1 + 0.2 + 0.15 + 0.05, 0.01);
+}
+
+// 测试采样头：会话只输出next_tokens，贪心时等于logits最后一个位置的argmax；重复惩罚增加past_tokens输入
+TEST_F(IntegrationTest, SamplingHead) {
+    const int64_t vocab = 11;
+    auto plain = CreateLanguageModelSession(vocab, 0.0f);
+    ASSERT_NE(plain, nullptr);
+    SessionOptions options;
+    options.enable_kv_cache = true;
+    options.enable_sampling_head = true;
+    options.sampling.temperature = 0.0f;
+    auto head = InferenceSession::Create(options);
+    ASSERT_NE(head, nullptr);
+    ASSERT_TRUE(head->LoadModelFromGraph(BuildTinyLanguageModel(vocab, 0.0f)).IsOk());
+    EXPECT_EQ(head->GetOutputNames(), std::vector<std::string>{"next_tokens"});
+    
+    std::vector<int64_t> feed = {2, 9, 5};
+    for (int step = 0; step < 4; ++step) {
+        auto ids = CreateTensor(Shape({1, static_cast<int64_t>(feed.size())}), DataType::INT64, DeviceType::CPU);
+        std::copy(feed.begin(), feed.end(), static_cast<int64_t*>(ids->GetData()));
+        std::vector<Tensor*> inputs = {ids.get()}, logits, tokens;
+        ASSERT_TRUE(plain->Run(inputs, logits).IsOk());
+        ASSERT_TRUE(head->Run(inputs, tokens).IsOk());
+        ASSERT_EQ(tokens.size(), 1u);
+        ASSERT_EQ(tokens[0]->GetDataType(), DataType::INT64);
+        ASSERT_EQ(tokens[0]->GetElementCount(), 1u);
+        const float* row = static_cast<const float*>(logits[0]->GetData()) + (feed.size() - 1) * vocab;
+        const int64_t token = static_cast<const int64_t*>(tokens[0]->GetData())[0];
+        EXPECT_EQ(token, std::max_element(row, row + vocab) - row) << "step " << step;
+        feed.assign(1, token);
+    }
+    
+    options.sampling.repetition_penalty = 1.5f;
+    auto penalized = InferenceSession::Create(options);
+    ASSERT_NE(penalized, nullptr);
+    ASSERT_TRUE(penalized->LoadModelFromGraph(BuildTinyLanguageModel(vocab, 0.0f)).IsOk());
+    EXPECT_EQ(penalized->GetInputNames(), (std::vector<std::string>{"input_ids", "past_tokens"}));
+}
+
+// 测试动态批处理：并发请求合并执行、按样本拆回结果、超时剔除
+TEST_F(IntegrationTest, DynamicBatching) {
+    SessionOptions options;
+    options.max_batch_size = 4;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(CreateSimpleGraph()).IsOk());
+    
+    DynamicBatcherOptions batcher_options;
+    batcher_options.max_delay_us = 50000;
+    DynamicBatcher batcher(session.get(), batcher_options);
+    EXPECT_EQ(batcher.GetOptions().max_batch_size, 4);
+    
+    auto make_input = [](int64_t rows, int64_t cols, float start) {
+        auto tensor = CreateTensor(Shape({rows, cols}), DataType::FLOAT32);
+        float* data = static_cast<float*>(tensor->GetData());
+        for (int64_t i = 0; i < rows * cols; ++i) {
+            data[i] = start - static_cast<float>(i);
+        }
+        return tensor;
+    };
+    auto expect_relu = [](const BatchResult& result, int64_t rows, int64_t cols, float start) {
+        ASSERT_TRUE(result.status.IsOk()) << result.status.Message();
+        ASSERT_EQ(result.outputs.size(), 1u);
+        ASSERT_EQ(result.outputs[0]->GetShape().dims, std::vector<int64_t>({rows, cols}));
+        const float* data = static_cast<const float*>(result.outputs[0]->GetData());
+        for (int64_t i = 0; i < rows * cols; ++i) {
+            EXPECT_FLOAT_EQ(data[i], std::max(start - static_cast<float>(i), 0.0f));
+        }
+    };
+    
+    // 4个单样本请求凑满一批，不必等待max_delay
+    std::vector<std::future<BatchResult>> futures;
+    std::vector<std::thread> clients;
+    std::mutex futures_mutex;
+    for (int r = 0; r < 4; ++r) {
+        clients.emplace_back([&, r] {
+            auto future = batcher.Submit({make_input(1, 4, 2.0f + r)});
+            std::lock_guard<std::mutex> lock(futures_mutex);
+            futures.push_back(std::move(future));
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    std::vector<BatchResult> results;
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    std::sort(results.begin(), results.end(), [](const BatchResult& a, const BatchResult& b) {
+        return static_cast<const float*>(a.outputs[0]->GetData())[0] <
+               static_cast<const float*>(b.outputs[0]->GetData())[0];
+    });
+    for (int r = 0; r < 4; ++r) {
+        expect_relu(results[r], 1, 4, 2.0f + r);
+    }
+    DynamicBatcherStats stats = batcher.GetStats();
+    EXPECT_EQ(stats.num_batches, 1u);
+    EXPECT_EQ(stats.num_requests, 4u);
+    EXPECT_EQ(stats.batch_size.GetCount(), 1u);
+    EXPECT_DOUBLE_EQ(stats.batch_size.GetMax(), 4.0);
+    EXPECT_EQ(stats.queue_time_us.GetCount(), 4u);
+    
+    // 形状不兼容的请求分批执行；多样本请求按第0维拆分
+    auto wide = batcher.Submit({make_input(2, 4, 5.0f)});
+    auto narrow = batcher.Submit({make_input(1, 3, 1.0f)});
+    expect_relu(wide.get(), 2, 4, 5.0f);
+    expect_relu(narrow.get(), 1, 3, 1.0f);
+    
+    // 等待max_delay期间超时的请求不会执行
+    auto expired = batcher.Submit({make_input(1, 4, 1.0f)}, 1);
+    BatchResult timeout = expired.get();
+    EXPECT_EQ(timeout.status.Code(), StatusCode::ERROR_TIMEOUT);
+    EXPECT_TRUE(timeout.outputs.empty());
+    
+    stats = batcher.GetStats();
+    EXPECT_EQ(stats.num_batches, 3u);
+    EXPECT_EQ(stats.num_timeouts, 1u);
+    EXPECT_TRUE(batcher.Submit({}).get().status.Code() == StatusCode::ERROR_INVALID_ARGUMENT);
+    
+    batcher.Stop();
+    EXPECT_FALSE(batcher.Submit({make_input(1, 4, 1.0f)}).get().status.IsOk());
+    EXPECT_EQ(batcher.GetStats().num_rejected, 1u);
+}
+
+// 测试变长序列的成批：BUCKET按桶补齐后截回原长度，PACKED首尾相接并生成段号输入
+TEST_F(IntegrationTest, SequenceBucketingAndPacking) {
+    auto make_sequence = [](int64_t length, float start) {
+        auto tensor = CreateTensor(Shape({1, length}), DataType::FLOAT32);
+        float* data = static_cast<float*>(tensor->GetData());
+        for (int64_t i = 0; i < length; ++i) {
+            data[i] = start - static_cast<float>(i);
+        }
+        return tensor;
+    };
+    const std::vector<int64_t> lengths = {3, 5, 7};
+    
+    {
+        SessionOptions options;
+        options.max_batch_size = 8;
+        auto session = InferenceSession::Create(options);
+        ASSERT_TRUE(session->LoadModelFromGraph(CreateSimpleGraph()).IsOk());
+        DynamicBatcherOptions batcher_options;
+        batcher_options.max_delay_us = 50000;
+        batcher_options.sequence.mode = SequenceBatchingMode::BUCKET;
+        batcher_options.sequence.buckets = {4, 8};
+        batcher_options.sequence.pad_values = {-100.0};
+        DynamicBatcher batcher(session.get(), batcher_options);
+        std::vector<std::future<BatchResult>> futures;
+        for (int64_t length : lengths) {
+            futures.push_back(batcher.Submit({make_sequence(length, 2.0f)}));
+        }
+        for (size_t r = 0; r < lengths.size(); ++r) {
+            BatchResult result = futures[r].get();
+            ASSERT_TRUE(result.status.IsOk()) << result.status.Message();
+            ASSERT_EQ(result.outputs[0]->GetShape().dims, std::vector<int64_t>({1, lengths[r]}));
+            const float* data = static_cast<const float*>(result.outputs[0]->GetData());
+            for (int64_t i = 0; i < lengths[r]; ++i) {
+                EXPECT_FLOAT_EQ(data[i], std::max(2.0f - static_cast<float>(i), 0.0f));
+            }
+        }
+        // 长度3落在桶4，5与7同在桶8中成批
+        DynamicBatcherStats stats = batcher.GetStats();
+        EXPECT_EQ(stats.num_batches, 2u);
+        EXPECT_EQ(stats.sequence_tokens, 15u);
+        EXPECT_EQ(stats.computed_tokens, 20u);
+    }
+    
+    {
+        // x -> Relu -> y；段号 -> Cast -> s
+        auto graph = std::make_unique<Graph>();
+        Value* x = graph->AddValue();
+        Value* segments = graph->AddValue();
+        Value* y = graph->AddValue();
+        Value* s = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(x);
+        relu->AddOutput(y);
+        Node* cast = graph->AddNode("Cast", "cast");
+        cast->SetAttribute("to", AttributeValue(int64_t(1)));
+        cast->AddInput(segments);
+        cast->AddOutput(s);
+        graph->AddInput(x);
+        graph->AddInput(segments);
+        graph->AddOutput(y);
+        graph->AddOutput(s);
+        SessionOptions options;
+        options.max_batch_size = 8;
+        auto session = InferenceSession::Create(options);
+        ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+        DynamicBatcherOptions batcher_options;
+        batcher_options.max_delay_us = 50000;
+        batcher_options.sequence.mode = SequenceBatchingMode::PACKED;
+        batcher_options.sequence.segment_ids_input = 1;
+        DynamicBatcher batcher(session.get(), batcher_options);
+        std::vector<std::future<BatchResult>> futures;
+        for (int64_t length : lengths) {
+            futures.push_back(batcher.Submit({make_sequence(length, 1.0f)}));
+        }
+        for (size_t r = 0; r < lengths.size(); ++r) {
+            BatchResult result = futures[r].get();
+            ASSERT_TRUE(result.status.IsOk()) << result.status.Message();
+            ASSERT_EQ(result.outputs.size(), 2u);
+            ASSERT_EQ(result.outputs[0]->GetShape().dims, std::vector<int64_t>({1, lengths[r]}));
+            const float* data = static_cast<const float*>(result.outputs[0]->GetData());
+            const float* segment = static_cast<const float*>(result.outputs[1]->GetData());
+            for (int64_t i = 0; i < lengths[r]; ++i) {
+                EXPECT_FLOAT_EQ(data[i], std::max(1.0f - static_cast<float>(i), 0.0f));
+                EXPECT_FLOAT_EQ(segment[i], static_cast<float>(r));
+            }
+        }
+        DynamicBatcherStats stats = batcher.GetStats();
+        EXPECT_EQ(stats.num_batches, 1u);
+        EXPECT_EQ(stats.computed_tokens, stats.sequence_tokens);
+    }
+}
+
+// 测试多LoRA适配器：同一批的样本选用不同的适配器，基座权重共用，结果等于各自合并权重后的MatMul
+TEST_F(IntegrationTest, BatchedLoraAdapters) {
+    const int64_t K = 8, N = 6, T = 2;
+    auto make_tensor = [](const Shape& shape, float step) {
+        auto tensor = CreateTensor(shape, DataType::FLOAT32);
+        float* data = static_cast<float*>(tensor->GetData());
+        for (int64_t i = 0; i < static_cast<int64_t>(tensor->GetElementCount()); ++i) {
+            data[i] = step * static_cast<float>(i % 5 - 2);
+        }
+        return tensor;
+    };
+    auto make_matrix = [&make_tensor](int64_t rows, int64_t cols, float step) {
+        return make_tensor(Shape({rows, cols}), step);
+    };
+    auto weight = make_matrix(K, N, 0.1f);
+    auto create_graph = [&weight]() {
+        auto graph = std::make_unique<Graph>();
+        Value* x = graph->AddValue();
+        Value* w = graph->AddValue();
+        Value* y = graph->AddValue();
+        w->SetName("w");
+        w->SetTensor(weight);
+        Node* matmul = graph->AddNode("MatMul", "proj");
+        matmul->AddInput(x);
+        matmul->AddInput(w);
+        matmul->AddOutput(y);
+        graph->AddInput(x);
+        graph->AddOutput(y);
+        return graph;
+    };
+    LoraAdapter first;
+    first.scale = 0.5f;
+    first.weights["w"] = {make_matrix(K, 2, 0.3f), make_matrix(2, N, -0.2f)};
+    LoraAdapter second;
+    second.weights["w"] = {make_matrix(K, 1, 0.7f), make_matrix(1, N, 0.4f)};
+    
+    // 参考：y = x * (W + scale * A * B)
+    auto reference = [&](const float* x, const LoraAdapter* adapter, int64_t n) {
+        float sum = 0.0f;
+        for (int64_t k = 0; k < K; ++k) {
+            float w = static_cast<const float*>(weight->GetData())[k * N + n];
+            if (adapter) {
+                const LoraWeights& lora = adapter->weights.at("w");
+                const int64_t rank = lora.a->GetShape().dims[1];
+                for (int64_t r = 0; r < rank; ++r) {
+                    w += adapter->scale * static_cast<const float*>(lora.a->GetData())[k * rank + r] *
+                         static_cast<const float*>(lora.b->GetData())[r * N + n];
+                }
+            }
+            sum += x[k] * w;
+        }
+        return sum;
+    };
+    
+    SessionOptions options;
+    options.enable_lora = true;
+    options.max_batch_size = 4;
+    auto session = InferenceSession::Create(options);
+    ASSERT_TRUE(session->LoadModelFromGraph(create_graph()).IsOk());
+    ASSERT_TRUE(session->RegisterLoraAdapter("first", first).IsOk());
+    ASSERT_TRUE(session->RegisterLoraAdapter("second", second).IsOk());
+    EXPECT_EQ(session->GetLoraAdapterIds(), std::vector<std::string>({"first", "second"}));
+    
+    // 形状不匹配或不是MatMul权重的适配器被拒绝
+    LoraAdapter wrong_shape;
+    wrong_shape.weights["w"] = {make_matrix(K + 1, 2, 0.1f), make_matrix(2, N, 0.1f)};
+    EXPECT_FALSE(session->RegisterLoraAdapter("wrong", wrong_shape).IsOk());
+    LoraAdapter wrong_target;
+    wrong_target.weights["missing"] = first.weights["w"];
+    EXPECT_FALSE(session->RegisterLoraAdapter("wrong", wrong_target).IsOk());
+    
+    // 4个样本 x 2个token，依次选用first、基座、second、first
+    auto x = make_tensor(Shape({4, T, K}), 0.25f);
+    const std::vector<const LoraAdapter*> selected = {&first, nullptr, &second, &first};
+    RunOptions run_options;
+    run_options.lora_adapters = {"first", "", "second", "first"};
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    Status status = session->Run(run_options, {x.get()}, outputs);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    ASSERT_EQ(outputs[0]->GetShape().dims, std::vector<int64_t>({4, T, N}));
+    const float* x_data = static_cast<const float*>(x->GetData());
+    const float* y_data = static_cast<const float*>(outputs[0]->GetData());
+    for (int64_t row = 0; row < 4 * T; ++row) {
+        for (int64_t n = 0; n < N; ++n) {
+            EXPECT_NEAR(y_data[row * N + n], reference(x_data + row * K, selected[row / T], n), 1e-4f);
+        }
+    }
+    
+    // 未注册的适配器、段数不能整除行数时运行失败
+    run_options.lora_adapters = {"third"};
+    EXPECT_FALSE(session->Run(run_options, {x.get()}, outputs).IsOk());
+    run_options.lora_adapters = {"first", "second", "first"};
+    EXPECT_FALSE(session->Run(run_options, {x.get()}, outputs).IsOk());
+    
+    // 动态批处理：不同适配器的请求合成一批
+    {
+        DynamicBatcherOptions batcher_options;
+        batcher_options.max_delay_us = 50000;
+        DynamicBatcher batcher(session.get(), batcher_options);
+        const std::vector<std::string> ids = {"second", "", "first"};
+        std::vector<std::shared_ptr<Tensor>> requests;
+        std::vector<std::future<BatchResult>> futures;
+        for (size_t r = 0; r < ids.size(); ++r) {
+            auto request = make_tensor(Shape({1, T, K}), 0.1f * static_cast<float>(r + 1));
+            requests.push_back(request);
+            futures.push_back(batcher.Submit({request}, -1, ids[r]));
+        }
+        for (size_t r = 0; r < ids.size(); ++r) {
+            BatchResult result = futures[r].get();
+            ASSERT_TRUE(result.status.IsOk()) << result.status.Message();
+            const LoraAdapter* adapter = ids[r] == "first" ? &first : ids[r] == "second" ? &second : nullptr;
+            const float* request_data = static_cast<const float*>(requests[r]->GetData());
+            const float* data = static_cast<const float*>(result.outputs[0]->GetData());
+            for (int64_t t = 0; t < T; ++t) {
+                for (int64_t n = 0; n < N; ++n) {
+                    EXPECT_NEAR(data[t * N + n], reference(request_data + t * K, adapter, n), 1e-4f);
+                }
+            }
+        }
+        EXPECT_EQ(batcher.GetStats().num_batches, 1u);
+    }
+    
+    // 注销后不能再选用；未启用LoRA的会话不接受注册
+    ASSERT_TRUE(session->UnregisterLoraAdapter("second").IsOk());
+    run_options.lora_adapters = {"second"};
+    EXPECT_FALSE(session->Run(run_options, {x.get()}, outputs).IsOk());
+    auto plain = InferenceSession::Create(SessionOptions());
+    ASSERT_TRUE(plain->LoadModelFromGraph(create_graph()).IsOk());
+    EXPECT_FALSE(plain->RegisterLoraAdapter("first", first).IsOk());
+}
+
+// 测试离线批量推理流水线：记录按批推理、按读取顺序写出，失败的记录计数后继续，各阶段统计齐全
+TEST_F(IntegrationTest, OfflineBatchPipeline) {
+    auto session = InferenceSession::Create(SessionOptions());
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(CreateSimpleGraph()).IsOk());
+    
+    const int num_records = 103;
+    int next = 0;
+    std::vector<std::string> written;
+    BatchPipelineStages stages;
+    stages.reader = [&](BatchRecord* record) {
+        if (next >= num_records) {
+            return false;
+        }
+        record->data = std::to_string(next++);
+        return true;
+    };
+    stages.preprocess = [](BatchRecord& record) {
+        const int value = std::stoi(record.data);
+        if (value == 50) {
+            return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "bad record");
+        }
+        auto input = CreateTensor(Shape({1, 2}), DataType::FLOAT32);
+        float* data = static_cast<float*>(input->GetData());
+        data[0] = static_cast<float>(value);
+        data[1] = -static_cast<float>(value);
+        record.inputs.push_back(std::move(input));
+        return Status::Ok();
+    };
+    stages.postprocess = [](BatchRecord& record) {
+        const float* y = static_cast<const float*>(record.outputs[0]->GetData());
+        record.result = std::to_string(static_cast<int>(y[0])) + "," + std::to_string(static_cast<int>(y[1]));
+        return Status::Ok();
+    };
+    stages.writer = [&](BatchRecord& record) {
+        written.push_back(record.status.IsOk() ? record.result : "error");
+        return Status::Ok();
+    };
+    BatchPipelineOptions options;
+    options.batch_size = 8;
+    options.preprocess_threads = 3;
+    options.postprocess_threads = 2;
+    options.preserve_order = true;
+    BatchInferencePipeline pipeline(session.get(), stages, options);
+    BatchPipelineStats stats;
+    ASSERT_TRUE(pipeline.Run(&stats).IsOk());
+    
+    ASSERT_EQ(written.size(), static_cast<size_t>(num_records));
+    for (int i = 0; i < num_records; ++i) {
+        EXPECT_EQ(written[i], i == 50 ? "error" : std::to_string(i) + ",0") << i;
+    }
+    EXPECT_EQ(stats.records, static_cast<uint64_t>(num_records));
+    EXPECT_EQ(stats.failed_records, 1u);
+    EXPECT_GE(stats.batches, 13u);  // 102条成功的记录，每批最多8条
+    ASSERT_EQ(stats.stages.size(), 6u);
+    EXPECT_EQ(stats.stages[0].name, "reader");
+    EXPECT_EQ(stats.stages[1].threads, 3u);
+    EXPECT_EQ(stats.stages[3].name, "infer");
+    EXPECT_EQ(stats.stages[3].items, stats.batches);
+    EXPECT_GT(stats.stages[3].busy_ms, 0.0);
+    EXPECT_NE(stats.ToString().find("busiest stage"), std::string::npos);
+    
+    // stop_on_error：第一个失败的记录停止流水线并返回其错误
+    next = 0;
+    written.clear();
+    options.stop_on_error = true;
+    BatchInferencePipeline strict(session.get(), stages, options);
+    Status status = strict.Run();
+    EXPECT_EQ(status.Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    EXPECT_LT(written.size(), static_cast<size_t>(num_records));
+    
+    // 写出失败总是停止流水线
+    next = 0;
+    options.stop_on_error = false;
+    stages.writer = [](BatchRecord&) { return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "disk full"); };
+    BatchInferencePipeline failing(session.get(), stages, options);
+    EXPECT_EQ(failing.Run().Message(), "disk full");
+}
+
+namespace {
+
+// 单个算子的图，输入输出按给定的名称命名
+std::unique_ptr<Graph> CreateNamedOpGraph(const std::string& op_type, const std::vector<std::string>& input_names,
+                                          const std::string& output_name) {
+    auto graph = std::make_unique<Graph>();
+    Node* node = graph->AddNode(op_type, op_type + "_0");
+    for (const std::string& name : input_names) {
+        Value* input = graph->AddValue();
+        input->SetName(name);
+        node->AddInput(input);
+        graph->AddInput(input);
+    }
+    Value* output = graph->AddValue();
+    output->SetName(output_name);
+    node->AddOutput(output);
+    graph->AddOutput(output);
+    return graph;
+}
+
+std::shared_ptr<Tensor> MakeVector(const std::vector<float>& values) {
+    auto tensor = CreateTensor(Shape({static_cast<int64_t>(values.size())}), DataType::FLOAT32);
+    std::copy(values.begin(), values.end(), static_cast<float*>(tensor->GetData()));
+    return tensor;
+}
+
+} // namespace
+
+// 测试多模型集成：步骤按依赖排序，上游输出直接交给下游，多个条目按条目独立推进
+TEST_F(IntegrationTest, ModelEnsembleDag) {
+    auto detector = InferenceSession::Create(SessionOptions());
+    auto other = InferenceSession::Create(SessionOptions());
+    auto head = InferenceSession::Create(SessionOptions());
+    ASSERT_TRUE(detector->LoadModelFromGraph(CreateNamedOpGraph("Relu", {"x"}, "y")).IsOk());
+    ASSERT_TRUE(other->LoadModelFromGraph(CreateNamedOpGraph("Sigmoid", {"x"}, "y")).IsOk());
+    ASSERT_TRUE(head->LoadModelFromGraph(CreateNamedOpGraph("Add", {"a", "b"}, "sum")).IsOk());
+    
+    // 步骤给出的顺序与依赖相反
+    std::vector<EnsembleStep> steps = {
+        {"head", head.get(), {"detector:y", "other:y"}},
+        {"detector", detector.get(), {"image"}},
+        {"other", other.get(), {"side"}},
+    };
+    ModelEnsembleOptions options;
+    options.input_names = {"image", "side"};
+    options.output_names = {"head:sum", "detector:y"};
+    options.max_inflight_items = 4;
+    std::unique_ptr<ModelEnsemble> ensemble;
+    ASSERT_TRUE(ModelEnsemble::Create(steps, options, &ensemble).IsOk());
+    EXPECT_EQ(ensemble->GetStepNames(), (std::vector<std::string>{"detector", "other", "head"}));
+    
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(ensemble->Run({MakeVector({-1.0f, 2.0f}), MakeVector({0.0f, 0.0f})}, &outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 2u);
+    const float* sum = static_cast<const float*>(outputs[0]->GetData());
+    const float* relu = static_cast<const float*>(outputs[1]->GetData());
+    EXPECT_FLOAT_EQ(sum[0], 0.5f);
+    EXPECT_FLOAT_EQ(sum[1], 2.5f);
+    EXPECT_FLOAT_EQ(relu[0], 0.0f);
+    
+    // 流式：20个条目，最多4个同时推进；第7个条目缺少输入而失败，不影响其他条目
+    const size_t num_items = 20;
+    std::vector<std::vector<std::shared_ptr<Tensor>>> items;
+    for (size_t i = 0; i < num_items; ++i) {
+        items.push_back({MakeVector({static_cast<float>(i)}), MakeVector({0.0f})});
+    }
+    items[7].pop_back();
+    std::mutex mutex;
+    std::vector<float> results(num_items, -1.0f);
+    size_t failures = 0;
+    Status status = ensemble->RunStream(items, [&](size_t index, Status item_status,
+                                                   std::vector<std::shared_ptr<Tensor>> item_outputs) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!item_status.IsOk()) {
+            ++failures;
+            return;
+        }
+        results[index] = static_cast<const float*>(item_outputs[0]->GetData())[0];
+    });
+    EXPECT_EQ(status.Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(failures, 1u);
+    for (size_t i = 0; i < num_items; ++i) {
+        if (i != 7) {
+            EXPECT_FLOAT_EQ(results[i], static_cast<float>(i) + 0.5f) << i;
+        }
+    }
+    ModelEnsembleStats stats = ensemble->GetStats();
+    EXPECT_EQ(stats.items, num_items + 1);
+    EXPECT_EQ(stats.failed_items, 1u);
+    EXPECT_EQ(stats.step_runs, 3u * num_items);
+    EXPECT_EQ(stats.peak_inflight_items, 4u);
+    
+    // 有环与未知的来源在创建时拒绝
+    std::vector<EnsembleStep> cyclic = {
+        {"a", detector.get(), {"b:y"}},
+        {"b", other.get(), {"a:y"}},
+    };
+    options.output_names = {"a:y"};
+    EXPECT_EQ(ModelEnsemble::Create(cyclic, options, &ensemble).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    std::vector<EnsembleStep> unknown = {{"a", detector.get(), {"missing"}}};
+    EXPECT_EQ(ModelEnsemble::Create(unknown, options, &ensemble).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+}
+
+namespace {
+
+// x[2, 32] * W[32, 32] + b[32] -> Relu -> Sigmoid；W取整数值，偏置与变体编号相关
+std::unique_ptr<Graph> CreateVariantGraph(float weight_scale, float bias) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* weight = graph->AddValue();
+    Value* bias_value = graph->AddValue();
+    Value* matmul_out = graph->AddValue();
+    Value* add_out = graph->AddValue();
+    Value* relu_out = graph->AddValue();
+    Value* output = graph->AddValue();
+    input->SetTensor(CreateTensor(Shape({2, 32}), DataType::FLOAT32));
+    
+    auto w = CreateTensor(Shape({32, 32}), DataType::FLOAT32);
+    float* w_data = static_cast<float*>(w->GetData());
+    for (int i = 0; i < 32 * 32; ++i) {
+        w_data[i] = weight_scale * static_cast<float>(i % 7 - 3) * 0.01f;
+    }
+    weight->SetTensor(w);
+    auto b = CreateTensor(Shape({32}), DataType::FLOAT32);
+    b->FillValue(bias);
+    bias_value->SetTensor(b);
+    
+    Node* matmul = graph->AddNode("MatMul", "matmul");
+    matmul->AddInput(input);
+    matmul->AddInput(weight);
+    matmul->AddOutput(matmul_out);
+    Node* add = graph->AddNode("Add", "add");
+    add->AddInput(matmul_out);
+    add->AddInput(bias_value);
+    add->AddOutput(add_out);
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(add_out);
+    relu->AddOutput(relu_out);
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid");
+    sigmoid->AddInput(relu_out);
+    sigmoid->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    return graph;
+}
+
+float VariantReference(float weight_scale, float bias, int row, int col) {
+    float sum = bias;
+    for (int k = 0; k < 32; ++k) {
+        const float x = static_cast<float>(row * 32 + k) * 0.01f;
+        sum += x * weight_scale * static_cast<float>((k * 32 + col) % 7 - 3) * 0.01f;
+    }
+    return 1.0f / (1.0f + std::exp(-std::max(sum, 0.0f)));
+}
+
+} // anonymous namespace
+
+// 测试多模型托管：相同的权重跨会话只保留一份只读副本，激活内存超出预算时释放最久未用的空闲会话
+TEST_F(IntegrationTest, ModelRepositorySharedWeightsAndBudget) {
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    
+    auto input = CreateTensor(Shape({2, 32}), DataType::FLOAT32);
+    float* input_data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 64; ++i) {
+        input_data[i] = static_cast<float>(i) * 0.01f;
+    }
+    auto run_and_check = [&input](ModelRepository& repository, const std::string& name,
+                                  float weight_scale, float bias) {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        Status status = repository.Run(name, {input.get()}, outputs);
+        ASSERT_TRUE(status.IsOk()) << status.Message();
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        for (int r = 0; r < 2; ++r) {
+            for (int c = 0; c < 32; ++c) {
+                EXPECT_NEAR(data[r * 32 + c], VariantReference(weight_scale, bias, r, c), 1e-4f) << name;
+            }
+        }
+    };
+    
+    // 单个会话运行后的激活内存，作为下面预算的单位
+    size_t session_bytes = 0;
+    {
+        ModelRepository repository;
+        ASSERT_TRUE(repository.LoadModelFromGraph("probe", CreateVariantGraph(1.0f, 0.0f), options).IsOk());
+        run_and_check(repository, "probe", 1.0f, 0.0f);
+        session_bytes = repository.GetActivationMemoryBytes();
+    }
+    ASSERT_GT(session_bytes, 0u);
+    
+    ModelRepositoryOptions repository_options;
+    repository_options.memory_budget_bytes = session_bytes / 2;
+    ModelRepository repository(repository_options);
+    ASSERT_TRUE(repository.LoadModelFromGraph("a", CreateVariantGraph(1.0f, 0.1f), options).IsOk());
+    ASSERT_TRUE(repository.LoadModelFromGraph("b", CreateVariantGraph(1.0f, 0.2f), options).IsOk());
+    ASSERT_TRUE(repository.LoadModelFromGraph("c", CreateVariantGraph(2.0f, 0.1f), options).IsOk());
+    EXPECT_FALSE(repository.LoadModelFromGraph("a", CreateVariantGraph(1.0f, 0.1f), options).IsOk());
+    EXPECT_EQ(repository.GetModelNames(), std::vector<std::string>({"a", "b", "c"}));
+    
+    // a与b的W相同，只驻留一份；偏置小于共享阈值，保持私有
+    const SharedWeightStore& store = repository.GetWeightStore();
+    EXPECT_EQ(store.GetNumTensors(), 2u);
+    EXPECT_EQ(store.GetResidentBytes(), 2u * 32 * 32 * sizeof(float));
+    EXPECT_EQ(store.GetDeduplicatedBytes(), 32u * 32 * sizeof(float));
+    ModelMemoryUsage usage;
+    ASSERT_TRUE(repository.GetMemoryUsage("a", &usage).IsOk());
+    EXPECT_EQ(usage.weight_bytes, 32u * 32 * sizeof(float) + 32 * sizeof(float));
+    EXPECT_EQ(usage.shared_weight_bytes, 32u * 32 * sizeof(float));
+    ASSERT_TRUE(repository.GetMemoryUsage("c", &usage).IsOk());
+    EXPECT_EQ(usage.shared_weight_bytes, 0u);
+    EXPECT_FALSE(repository.GetMemoryUsage("missing", &usage).IsOk());
+    
+    auto shared_weight = [](const InferenceSession& session) -> const Tensor* {
+        for (const auto& value : session.GetGraph()->GetValues()) {
+            auto tensor = value->GetTensor();
+            if (!value->GetProducer() && tensor && tensor->GetShape().dims == std::vector<int64_t>({32, 32})) {
+                return tensor.get();
+            }
+        }
+        return nullptr;
+    };
+    const Tensor* weight_a = shared_weight(*repository.GetSession("a"));
+    ASSERT_NE(weight_a, nullptr);
+    EXPECT_EQ(weight_a, shared_weight(*repository.GetSession("b")));
+    EXPECT_NE(weight_a, shared_weight(*repository.GetSession("c")));
+    EXPECT_FALSE(weight_a->IsOwned());
+    
+    // 预算只容得下一个会话的一块arena：运行后其他空闲会话的arena都被释放，再次运行时重新分配
+    run_and_check(repository, "a", 1.0f, 0.1f);
+    run_and_check(repository, "b", 1.0f, 0.2f);
+    EXPECT_EQ(repository.GetSession("a")->GetMemoryStats().allocated_bytes, 0u);
+    EXPECT_GT(repository.GetSession("b")->GetMemoryStats().allocated_bytes, 0u);
+    run_and_check(repository, "c", 2.0f, 0.1f);
+    run_and_check(repository, "a", 1.0f, 0.1f);
+    EXPECT_EQ(repository.GetSession("b")->GetMemoryStats().allocated_bytes, 0u);
+    EXPECT_EQ(repository.GetSession("c")->GetMemoryStats().allocated_bytes, 0u);
+    EXPECT_EQ(repository.GetActivationMemoryBytes(), repository.GetSession("a")->GetMemoryStats().allocated_bytes);
+    EXPECT_GE(repository.GetNumEvictions(), 3u);
+    
+    // 会话的记账：释放过的arena计入free_count，峰值不随释放下降
+    MemoryStats stats = repository.GetSession("a")->GetMemoryStats();
+    EXPECT_GT(stats.free_count, 0u);
+    EXPECT_GE(stats.allocation_count, stats.free_count);
+    EXPECT_GE(stats.peak_allocated_bytes, stats.allocated_bytes);
+    
+    // 串行接口在arena被释放后重新分配并绑定
+    std::vector<Tensor*> serial_outputs;
+    ASSERT_TRUE(repository.GetSession("c")->Run({input.get()}, serial_outputs).IsOk());
+    ASSERT_EQ(serial_outputs.size(), 1u);
+    EXPECT_NEAR(static_cast<const float*>(serial_outputs[0]->GetData())[5], VariantReference(2.0f, 0.1f, 0, 5), 1e-4f);
+    EXPECT_GT(repository.GetSession("c")->GetMemoryStats().allocated_bytes, 0u);
+    
+    // 卸载后共享副本仍被b引用
+    ASSERT_TRUE(repository.UnloadModel("a").IsOk());
+    EXPECT_FALSE(repository.HasModel("a"));
+    EXPECT_EQ(store.GetNumTensors(), 2u);
+    ASSERT_TRUE(repository.UnloadModel("b").IsOk());
+    EXPECT_EQ(store.GetNumTensors(), 1u);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    EXPECT_EQ(repository.Run("a", {input.get()}, outputs).Code(), StatusCode::ERROR_NOT_FOUND);
+}
+
+// 测试CPU算子自动调优：调优后结果不变，(算子, 形状)的最优配置写入调优缓存，重启后命中缓存
+TEST_F(IntegrationTest, CpuAutotuningPersistsResults) {
+    const std::string path = ::testing::TempDir() + "inferunity_cpu_tuning.cache";
+    std::remove(path.c_str());
+    GetKernelTuningCache().Clear();
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.enable_cpu_autotuning = true;
+    options.kernel_tuning_cache_path = path;
+    auto input = CreateTensor(Shape({2, 32}), DataType::FLOAT32);
+    float* input_data = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 64; ++i) {
+        input_data[i] = static_cast<float>(i) * 0.01f;
+    }
+    
+    for (int restart = 0; restart < 2; ++restart) {
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(CreateVariantGraph(1.0f, 0.1f)).IsOk());
+        EXPECT_EQ(GetKernelTuningCache().Size(), 1u);  // 只有MatMul参与调优
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        for (int r = 0; r < 2; ++r) {
+            for (int c = 0; c < 32; ++c) {
+                EXPECT_NEAR(data[r * 32 + c], VariantReference(1.0f, 0.1f, r, c), 1e-4f);
+            }
+        }
+        // 第二次加载前只保留磁盘上的记录
+        GetKernelTuningCache().Clear();
+    }
+    
+    KernelTuningCache persisted;
+    ASSERT_TRUE(persisted.Load(path).IsOk());
+    EXPECT_EQ(persisted.Size(), 1u);
+    ASSERT_TRUE(GetKernelTuningCache().SetPath("").IsOk());
+    std::remove(path.c_str());
+}
+
+// 测试基准模型库：缩小的各模型在优化前后都能执行且结果一致，同一种子生成相同的权重，规格字符串可解析
+TEST_F(IntegrationTest, ModelZooBuildsRunnableModels) {
+    ZooModelOptions options;
+    options.batch_size = 2;
+    options.sequence_length = 16;
+    options.image_size = 64;
+    options.width = 0.25;
+    options.depth = 0.1;
+    options.vocab_size = 512;
+    const std::map<std::string, Shape> expected_shapes = {
+        {"resnet50", Shape({2, 1000})}, {"mobilenet_v3", Shape({2, 1000})}, {"bert_base", Shape({2, 16, 192})},
+        {"qwen_0.5b", Shape({2, 16, 512})}, {"dlrm", Shape({2, 1})}};
+    ASSERT_EQ(GetZooModels().size(), expected_shapes.size());
+    
+    for (const auto& model : GetZooModels()) {
+        SCOPED_TRACE(model.name);
+        std::vector<std::vector<std::shared_ptr<Tensor>>> results;
+        for (auto level : {SessionOptions::GraphOptimizationLevel::NONE, SessionOptions::GraphOptimizationLevel::ALL}) {
+            std::unique_ptr<Graph> graph;
+            ASSERT_TRUE(BuildZooModel(model.name, options, &graph).IsOk());
+            // 图输入带有合法的示例输入
+            std::vector<std::shared_ptr<Tensor>> inputs;
+            std::vector<Tensor*> input_ptrs;
+            for (Value* input : graph->GetInputs()) {
+                ASSERT_NE(input->GetTensor(), nullptr);
+                inputs.push_back(input->GetTensor());
+                input_ptrs.push_back(inputs.back().get());
+            }
+            SessionOptions session_options;
+            session_options.graph_optimization_level = level;
+            auto session = InferenceSession::Create(session_options);
+            ASSERT_NE(session, nullptr);
+            ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            Status status = session->Run(input_ptrs, outputs);
+            ASSERT_TRUE(status.IsOk()) << status.Message();
+            ASSERT_EQ(outputs.size(), 1u);
+            EXPECT_EQ(outputs[0]->GetShape(), expected_shapes.at(model.name));
+            results.push_back(outputs);
+        }
+        const float* reference = static_cast<const float*>(results[0][0]->GetData());
+        const float* optimized = static_cast<const float*>(results[1][0]->GetData());
+        for (size_t i = 0; i < results[0][0]->GetElementCount(); ++i) {
+            ASSERT_TRUE(std::isfinite(reference[i]));
+            ASSERT_NEAR(optimized[i], reference[i], 1e-3f * std::max(1.0f, std::fabs(reference[i])));
+        }
+    }
+    
+    // 同一种子逐位相同，不同种子不同
+    auto first_weight = [](uint64_t seed) {
+        ZooModelOptions small;
+        small.width = 0.25;
+        small.depth = 0.1;
+        small.seed = seed;
+        std::unique_ptr<Graph> graph;
+        EXPECT_TRUE(BuildZooModel("resnet50", small, &graph).IsOk());
+        auto tensor = graph->FindValueByName("conv1.weight")->GetTensor();
+        const float* data = static_cast<const float*>(tensor->GetData());
+        return std::vector<float>(data, data + tensor->GetElementCount());
+    };
+    EXPECT_EQ(first_weight(7), first_weight(7));
+    EXPECT_NE(first_weight(7), first_weight(8));
+    
+    std::string name;
+    ZooModelOptions parsed;
+    ASSERT_TRUE(ParseZooModelSpec("bert_base:batch=8,seq=384,width=0.5", &name, &parsed).IsOk());
+    EXPECT_EQ(name, "bert_base");
+    EXPECT_EQ(parsed.batch_size, 8);
+    EXPECT_EQ(parsed.sequence_length, 384);
+    EXPECT_DOUBLE_EQ(parsed.width, 0.5);
+    EXPECT_FALSE(ParseZooModelSpec("bert_base:heads=4", &name, &parsed).IsOk());
+    std::unique_ptr<Graph> graph;
+    EXPECT_EQ(BuildZooModel("alexnet", ZooModelOptions(), &graph).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+}
@@ -3,8 +3,12 @@
 #include "inferunity/tensor.h"
 #include "inferunity/operator.h"
 #include "inferunity/types.h"
+#include "operators/elementwise_kernels.h"
+#include "operators/simd_utils.h"
+#include <algorithm>
 #include <vector>
 #include <cmath>
+#include <string>
 
 using namespace inferunity;
 
@@ -177,3 +181,468 @@ TEST_F(MathOperatorsTest, AddInputValidation) {
     ASSERT_FALSE(status.IsOk());
 }
 
+
+namespace {
+
+void FillSequence(Tensor* tensor, float scale) {
+    float* data = static_cast<float*>(tensor->GetData());
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        data[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * scale;
+    }
+}
+
+} // anonymous namespace
+
+// 批量广播MatMul测试：[2, 3, M, K] x [3, K, N]，并与逐矩阵朴素计算对比
+TEST_F(MathOperatorsTest, MatMulBatchedBroadcast) {
+    const int64_t M = 5, K = 4, N = 6;
+    auto matmul_op = OperatorRegistry::Instance().Create("MatMul");
+    ASSERT_NE(matmul_op, nullptr);
+    
+    auto a = CreateTensor(Shape({2, 3, M, K}), DataType::FLOAT32);
+    auto b = CreateTensor(Shape({3, K, N}), DataType::FLOAT32);
+    FillSequence(a.get(), 0.5f);
+    FillSequence(b.get(), 0.25f);
+    
+    std::vector<Tensor*> inputs = {a.get(), b.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(matmul_op->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{2, 3, M, N}));
+    
+    auto output = CreateTensor(shapes[0], DataType::FLOAT32);
+    std::vector<Tensor*> outputs = {output.get()};
+    ASSERT_TRUE(matmul_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    
+    const float* A = static_cast<const float*>(a->GetData());
+    const float* B = static_cast<const float*>(b->GetData());
+    const float* C = static_cast<const float*>(output->GetData());
+    for (int64_t n = 0; n < 2; ++n)
+    for (int64_t h = 0; h < 3; ++h)
+    for (int64_t i = 0; i < M; ++i)
+    for (int64_t j = 0; j < N; ++j) {
+        float sum = 0.0f;
+        for (int64_t k = 0; k < K; ++k) {
+            sum += A[((n * 3 + h) * M + i) * K + k] * B[(h * K + k) * N + j];
+        }
+        EXPECT_NEAR(C[((n * 3 + h) * M + i) * N + j], sum, 1e-4f);
+    }
+}
+
+// 转置属性测试：[B, H, S, D] x [B, H, S, D]^T（注意力分数），无需物化Transpose
+TEST_F(MathOperatorsTest, MatMulTransposedOperand) {
+    const int64_t S = 7, D = 5;
+    auto matmul_op = OperatorRegistry::Instance().Create("MatMul");
+    ASSERT_NE(matmul_op, nullptr);
+    matmul_op->SetAttribute("transB", AttributeValue(static_cast<int64_t>(1)));
+    matmul_op->SetAttribute("alpha", AttributeValue(0.5f));
+    
+    auto q = CreateTensor(Shape({1, 2, S, D}), DataType::FLOAT32);
+    auto k = CreateTensor(Shape({1, 2, S, D}), DataType::FLOAT32);
+    FillSequence(q.get(), 1.0f);
+    FillSequence(k.get(), -0.5f);
+    
+    std::vector<Tensor*> inputs = {q.get(), k.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(matmul_op->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, 2, S, S}));
+    
+    auto output = CreateTensor(shapes[0], DataType::FLOAT32);
+    std::vector<Tensor*> outputs = {output.get()};
+    ASSERT_TRUE(matmul_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    
+    const float* Q = static_cast<const float*>(q->GetData());
+    const float* Kd = static_cast<const float*>(k->GetData());
+    const float* C = static_cast<const float*>(output->GetData());
+    for (int64_t h = 0; h < 2; ++h)
+    for (int64_t i = 0; i < S; ++i)
+    for (int64_t j = 0; j < S; ++j) {
+        float sum = 0.0f;
+        for (int64_t d = 0; d < D; ++d) {
+            sum += Q[(h * S + i) * D + d] * Kd[(h * S + j) * D + d];
+        }
+        EXPECT_NEAR(C[(h * S + i) * S + j], 0.5f * sum, 1e-4f);
+    }
+}
+
+// 1D操作数与不可广播的批维度
+TEST_F(MathOperatorsTest, MatMulVectorAndInvalidShapes) {
+    auto matmul_op = OperatorRegistry::Instance().Create("MatMul");
+    ASSERT_NE(matmul_op, nullptr);
+    
+    auto a = CreateTensor(Shape({3, 2, 4}), DataType::FLOAT32);
+    auto v = CreateTensor(Shape({4}), DataType::FLOAT32);
+    FillSequence(a.get(), 1.0f);
+    v->FillValue(1.0f);
+    
+    std::vector<Tensor*> inputs = {a.get(), v.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(matmul_op->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{3, 2}));
+    
+    auto output = CreateTensor(shapes[0], DataType::FLOAT32);
+    std::vector<Tensor*> outputs = {output.get()};
+    ASSERT_TRUE(matmul_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    const float* A = static_cast<const float*>(a->GetData());
+    const float* C = static_cast<const float*>(output->GetData());
+    for (int64_t r = 0; r < 6; ++r) {
+        EXPECT_FLOAT_EQ(C[r], A[r * 4] + A[r * 4 + 1] + A[r * 4 + 2] + A[r * 4 + 3]);
+    }
+    
+    auto bad_a = CreateTensor(Shape({2, 3, 4}), DataType::FLOAT32);
+    auto bad_b = CreateTensor(Shape({3, 4, 5}), DataType::FLOAT32);
+    std::vector<Tensor*> bad_inputs = {bad_a.get(), bad_b.get()};
+    shapes.clear();
+    EXPECT_FALSE(matmul_op->InferOutputShape(bad_inputs, shapes).IsOk());
+}
+
+// 广播模式分类：折叠后的形状决定内层循环
+TEST_F(MathOperatorsTest, BroadcastPatternClassification) {
+    using operators::BroadcastPattern;
+    struct Case {
+        Shape a, b;
+        BroadcastPattern pattern;
+        int64_t outer, inner;
+    };
+    const std::vector<Case> cases = {
+        {Shape({4, 5}), Shape({4, 5}), BroadcastPattern::SAME, 1, 20},
+        {Shape({4, 5}), Shape({1}), BroadcastPattern::SCALAR, 1, 20},
+        {Shape({2, 4, 5}), Shape({5}), BroadcastPattern::ROW, 8, 5},
+        {Shape({4, 5}), Shape({4, 1}), BroadcastPattern::COLUMN, 4, 5},
+        {Shape({4, 1}), Shape({1, 5}), BroadcastPattern::GENERAL, 4, 5},
+        {Shape({2, 3, 4}), Shape({3, 1}), BroadcastPattern::GENERAL, 6, 4},
+        {Shape({1, 1}), Shape({1}), BroadcastPattern::SAME, 1, 1},
+    };
+    for (const auto& c : cases) {
+        Shape output;
+        ASSERT_TRUE(operators::BroadcastShapes({c.a, c.b}, &output).IsOk());
+        operators::BroadcastPlan plan;
+        ASSERT_TRUE(operators::PlanBroadcast({c.a, c.b}, output, &plan).IsOk());
+        EXPECT_EQ(plan.pattern, c.pattern) << c.a.dims.size() << "D + " << c.b.dims.size() << "D";
+        EXPECT_EQ(plan.outer, c.outer);
+        EXPECT_EQ(plan.inner, c.inner);
+    }
+    Shape output;
+    EXPECT_FALSE(operators::BroadcastShapes({Shape({4, 5}), Shape({4})}, &output).IsOk());
+}
+
+namespace {
+
+// 按输出的多维下标计算被广播操作数的线性下标
+int64_t BroadcastIndex(const Shape& shape, const Shape& output, int64_t linear) {
+    const size_t rank = output.dims.size();
+    const size_t offset = rank - shape.dims.size();
+    int64_t index = 0, stride = 1;
+    for (size_t d = rank; d-- > 0;) {
+        const int64_t coord = linear % output.dims[d];
+        linear /= output.dims[d];
+        if (d >= offset) {
+            const int64_t dim = shape.dims[d - offset];
+            index += (dim == 1 ? 0 : coord) * stride;
+            stride *= dim;
+        }
+    }
+    return index;
+}
+
+float ReferenceBinary(const std::string& op, float x, float y) {
+    if (op == "Add") return x + y;
+    if (op == "Sub") return x - y;
+    if (op == "Mul") return x * y;
+    if (op == "Div") return x / y;
+    if (op == "Pow") return std::pow(x, y);
+    if (op == "Max") return std::max(x, y);
+    return std::min(x, y);
+}
+
+std::shared_ptr<Tensor> RunElementwise(const std::string& op_type, const std::vector<Tensor*>& inputs,
+                                       ExecutionContext* ctx) {
+    auto op = OperatorRegistry::Instance().Create(op_type);
+    if (!op || !op->ValidateInputs(inputs).IsOk()) return nullptr;
+    std::vector<Shape> shapes;
+    if (!op->InferOutputShape(inputs, shapes).IsOk()) return nullptr;
+    auto output = CreateTensor(shapes[0], op->InferOutputDataType(inputs, 0));
+    if (!op->Execute(inputs, {output.get()}, ctx).IsOk()) return nullptr;
+    return output;
+}
+
+} // anonymous namespace
+
+// 各广播模式、各ISA的FP32结果与逐元素参考一致
+TEST_F(MathOperatorsTest, BinaryBroadcastMatchesReference) {
+    const std::vector<std::pair<Shape, Shape>> shapes = {
+        {Shape({3, 37}), Shape({3, 37})},
+        {Shape({3, 37}), Shape({1})},
+        {Shape({1}), Shape({3, 37})},
+        {Shape({2, 5, 19}), Shape({19})},
+        {Shape({5, 19}), Shape({5, 1})},
+        {Shape({6, 1}), Shape({1, 23})},
+        {Shape({2, 3, 1, 7}), Shape({3, 4, 1})},
+    };
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) continue;
+        for (const char* op : {"Add", "Sub", "Mul", "Div", "Pow", "Max", "Min"}) {
+            for (const auto& pair : shapes) {
+                auto a = CreateTensor(pair.first, DataType::FLOAT32);
+                auto b = CreateTensor(pair.second, DataType::FLOAT32);
+                float* pa = static_cast<float*>(a->GetData());
+                float* pb = static_cast<float*>(b->GetData());
+                for (size_t i = 0; i < a->GetElementCount(); ++i) pa[i] = 0.25f + 0.1f * static_cast<float>(i % 13);
+                for (size_t i = 0; i < b->GetElementCount(); ++i) pb[i] = 0.5f + 0.2f * static_cast<float>(i % 7);
+                auto y = RunElementwise(op, {a.get(), b.get()}, ctx_.get());
+                ASSERT_NE(y, nullptr) << op;
+                Shape expected_shape;
+                ASSERT_TRUE(operators::BroadcastShapes({pair.first, pair.second}, &expected_shape).IsOk());
+                ASSERT_EQ(y->GetShape().dims, expected_shape.dims);
+                const float* out = static_cast<const float*>(y->GetData());
+                for (int64_t i = 0; i < expected_shape.GetElementCount(); ++i) {
+                    const float x = pa[BroadcastIndex(pair.first, expected_shape, i)];
+                    const float v = pb[BroadcastIndex(pair.second, expected_shape, i)];
+                    ASSERT_NEAR(out[i], ReferenceBinary(op, x, v), 1e-5f) << isa << " " << op << " at " << i;
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// INT32/INT64/FP16与Pow的标量指数
+TEST_F(MathOperatorsTest, BinaryIntegerAndHalfTypes) {
+    auto a = CreateTensor(Shape({2, 3}), DataType::INT64);
+    auto b = CreateTensor(Shape({3}), DataType::INT64);
+    int64_t* pa = static_cast<int64_t*>(a->GetData());
+    int64_t* pb = static_cast<int64_t*>(b->GetData());
+    for (int i = 0; i < 6; ++i) pa[i] = 10 * i;
+    for (int i = 0; i < 3; ++i) pb[i] = i;
+    auto sum = RunElementwise("Add", {a.get(), b.get()}, ctx_.get());
+    ASSERT_NE(sum, nullptr);
+    ASSERT_EQ(sum->GetDataType(), DataType::INT64);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(static_cast<const int64_t*>(sum->GetData())[i], 10 * i + i % 3);
+    }
+    
+    // 整数除法向零截断，除以0输出0
+    auto x = CreateTensor(Shape({4}), DataType::INT32);
+    auto d = CreateTensor(Shape({4}), DataType::INT32);
+    const int32_t xs[] = {7, -7, 9, 5}, ds[] = {2, 2, 0, -5};
+    std::copy(xs, xs + 4, static_cast<int32_t*>(x->GetData()));
+    std::copy(ds, ds + 4, static_cast<int32_t*>(d->GetData()));
+    auto quotient = RunElementwise("Div", {x.get(), d.get()}, ctx_.get());
+    ASSERT_NE(quotient, nullptr);
+    const int32_t expected_q[] = {3, -3, 0, -1};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(static_cast<const int32_t*>(quotient->GetData())[i], expected_q[i]);
+    }
+    
+    // FP16：按块转换为FP32计算
+    auto h = CreateTensor(Shape({3, 300}), DataType::FLOAT16);
+    auto hs = CreateTensor(Shape({3, 1}), DataType::FLOAT16);
+    std::vector<float> hv(900), hsv = {0.5f, 2.0f, -1.0f};
+    for (size_t i = 0; i < hv.size(); ++i) hv[i] = static_cast<float>(i % 17) * 0.125f;
+    simd::ConvertFloatToHalfSIMD(hv.data(), static_cast<uint16_t*>(h->GetData()), hv.size());
+    simd::ConvertFloatToHalfSIMD(hsv.data(), static_cast<uint16_t*>(hs->GetData()), 3);
+    auto product = RunElementwise("Mul", {h.get(), hs.get()}, ctx_.get());
+    ASSERT_NE(product, nullptr);
+    ASSERT_EQ(product->GetDataType(), DataType::FLOAT16);
+    std::vector<float> result(900);
+    simd::ConvertHalfToFloatSIMD(static_cast<const uint16_t*>(product->GetData()), result.data(), 900);
+    for (size_t i = 0; i < 900; ++i) {
+        EXPECT_FLOAT_EQ(result[i], hv[i] * hsv[i / 300]) << "at " << i;
+    }
+    
+    // Pow的指数为INT64单元素（导出图里的x ** 2）
+    auto base = CreateTensor(Shape({5}), DataType::FLOAT32);
+    auto exponent = CreateTensor(Shape(std::vector<int64_t>{}), DataType::INT64);
+    for (int i = 0; i < 5; ++i) static_cast<float*>(base->GetData())[i] = static_cast<float>(i) - 2.0f;
+    *static_cast<int64_t*>(exponent->GetData()) = 2;
+    auto squared = RunElementwise("Pow", {base.get(), exponent.get()}, ctx_.get());
+    ASSERT_NE(squared, nullptr);
+    for (int i = 0; i < 5; ++i) {
+        const float v = static_cast<float>(i) - 2.0f;
+        EXPECT_FLOAT_EQ(static_cast<const float*>(squared->GetData())[i], v * v);
+    }
+}
+
+// 多输入Max/Min与三方广播的Where
+TEST_F(MathOperatorsTest, VariadicMaxMinAndWhere) {
+    auto a = CreateTensor(Shape({2, 4}), DataType::FLOAT32);
+    auto b = CreateTensor(Shape({4}), DataType::FLOAT32);
+    auto c = CreateTensor(Shape({2, 1}), DataType::FLOAT32);
+    FillSequence(a.get(), 1.0f);
+    FillSequence(b.get(), -0.5f);
+    static_cast<float*>(c->GetData())[0] = 0.5f;
+    static_cast<float*>(c->GetData())[1] = -2.0f;
+    const float* pa = static_cast<const float*>(a->GetData());
+    const float* pb = static_cast<const float*>(b->GetData());
+    const float* pc = static_cast<const float*>(c->GetData());
+    auto max = RunElementwise("Max", {a.get(), b.get(), c.get()}, ctx_.get());
+    auto min = RunElementwise("Min", {a.get(), b.get(), c.get()}, ctx_.get());
+    ASSERT_NE(max, nullptr);
+    ASSERT_NE(min, nullptr);
+    EXPECT_EQ(max->GetShape().dims, (std::vector<int64_t>{2, 4}));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_FLOAT_EQ(static_cast<const float*>(max->GetData())[i],
+                        std::max({pa[i], pb[i % 4], pc[i / 4]}));
+        EXPECT_FLOAT_EQ(static_cast<const float*>(min->GetData())[i],
+                        std::min({pa[i], pb[i % 4], pc[i / 4]}));
+    }
+    auto single = RunElementwise("Max", {a.get()}, ctx_.get());
+    ASSERT_NE(single, nullptr);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(single->GetData())[5], pa[5]);
+    
+    // cond[2, 1] ? x[2, 4] : y[4]（注意力掩码的常见形式）
+    auto cond = CreateTensor(Shape({2, 1}), DataType::BOOL);
+    static_cast<uint8_t*>(cond->GetData())[0] = 1;
+    static_cast<uint8_t*>(cond->GetData())[1] = 0;
+    auto selected = RunElementwise("Where", {cond.get(), a.get(), b.get()}, ctx_.get());
+    ASSERT_NE(selected, nullptr);
+    ASSERT_EQ(selected->GetShape().dims, (std::vector<int64_t>{2, 4}));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_FLOAT_EQ(static_cast<const float*>(selected->GetData())[i], i < 4 ? pa[i] : pb[i % 4]);
+    }
+    auto cond_full = CreateTensor(Shape({4}), DataType::BOOL);
+    for (int i = 0; i < 4; ++i) static_cast<uint8_t*>(cond_full->GetData())[i] = i % 2;
+    auto masked = RunElementwise("Where", {cond_full.get(), a.get(), c.get()}, ctx_.get());
+    ASSERT_NE(masked, nullptr);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_FLOAT_EQ(static_cast<const float*>(masked->GetData())[i], (i % 2) ? pa[i] : pc[i / 4]);
+    }
+}
+
+namespace {
+
+// 归约的双精度参考实现：按输出下标枚举全部被归约的输入
+std::vector<double> ReferenceReduce(const std::string& op, const std::vector<float>& x, const Shape& shape,
+                                    const std::vector<bool>& reduce_axis) {
+    const size_t rank = shape.dims.size();
+    int64_t out_count = 1;
+    for (size_t d = 0; d < rank; ++d) {
+        if (!reduce_axis[d]) out_count *= shape.dims[d];
+    }
+    const bool is_max = op == "ReduceMax", is_min = op == "ReduceMin";
+    std::vector<double> acc(static_cast<size_t>(out_count),
+                            is_max ? -INFINITY : (is_min ? INFINITY : 0.0));
+    std::vector<int64_t> counts(static_cast<size_t>(out_count), 0);
+    for (size_t i = 0; i < x.size(); ++i) {
+        int64_t rem = static_cast<int64_t>(i), out = 0, stride = 1;
+        for (size_t d = rank; d-- > 0;) {
+            const int64_t coord = rem % shape.dims[d];
+            rem /= shape.dims[d];
+            if (!reduce_axis[d]) {
+                out += coord * stride;
+                stride *= shape.dims[d];
+            }
+        }
+        const double v = x[i];
+        double& a = acc[static_cast<size_t>(out)];
+        if (is_max) a = std::max(a, v);
+        else if (is_min) a = std::min(a, v);
+        else if (op == "ReduceSumSquare" || op == "ReduceL2") a += v * v;
+        else a += v;
+        ++counts[static_cast<size_t>(out)];
+    }
+    for (size_t o = 0; o < acc.size(); ++o) {
+        if (op == "ReduceMean") acc[o] /= static_cast<double>(counts[o]);
+        if (op == "ReduceL2") acc[o] = std::sqrt(acc[o]);
+    }
+    return acc;
+}
+
+} // anonymous namespace
+
+// Reduce*：各种轴组合（KR/RK/KRK/其他交替）与keepdims，各ISA与参考一致
+TEST_F(MathOperatorsTest, ReduceMatchesReference) {
+    const Shape shape({3, 4, 5, 6});
+    auto x = CreateTensor(shape, DataType::FLOAT32);
+    std::vector<float> values(x->GetElementCount());
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(static_cast<int>((i * 37) % 23) - 11) * 0.125f;
+    }
+    std::copy(values.begin(), values.end(), static_cast<float*>(x->GetData()));
+    const std::vector<std::vector<int64_t>> axis_sets = {
+        {}, {0}, {1}, {3}, {-1}, {1, 2}, {0, 2}, {0, 3}, {1, 3}, {0, 1, 2, 3}
+    };
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) continue;
+        for (const char* op : {"ReduceSum", "ReduceMean", "ReduceMax", "ReduceMin", "ReduceSumSquare", "ReduceL2"}) {
+            for (const auto& axes : axis_sets) {
+                for (int64_t keepdims : {0, 1}) {
+                    auto reduce = OperatorRegistry::Instance().Create(op);
+                    ASSERT_NE(reduce, nullptr) << op;
+                    if (!axes.empty()) reduce->SetAttribute("axes", AttributeValue(axes));
+                    reduce->SetAttribute("keepdims", AttributeValue(keepdims));
+                    std::vector<Tensor*> inputs = {x.get()};
+                    std::vector<Shape> shapes;
+                    ASSERT_TRUE(reduce->InferOutputShape(inputs, shapes).IsOk());
+                    
+                    std::vector<bool> reduce_axis(4, axes.empty());
+                    for (int64_t axis : axes) reduce_axis[static_cast<size_t>(axis < 0 ? axis + 4 : axis)] = true;
+                    std::vector<int64_t> expected_dims;
+                    for (size_t d = 0; d < 4; ++d) {
+                        if (!reduce_axis[d]) expected_dims.push_back(shape.dims[d]);
+                        else if (keepdims) expected_dims.push_back(1);
+                    }
+                    ASSERT_EQ(shapes[0].dims, expected_dims);
+                    
+                    auto y = CreateTensor(shapes[0], DataType::FLOAT32);
+                    ASSERT_TRUE(reduce->Execute(inputs, {y.get()}, ctx_.get()).IsOk());
+                    auto ref = ReferenceReduce(op, values, shape, reduce_axis);
+                    ASSERT_EQ(static_cast<size_t>(y->GetElementCount()), ref.size());
+                    const float* out = static_cast<const float*>(y->GetData());
+                    for (size_t i = 0; i < ref.size(); ++i) {
+                        ASSERT_NEAR(out[i], ref[i], 1e-4 * std::max(1.0, std::abs(ref[i])))
+                            << isa << " " << op << " axes " << axes.size() << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// 大张量沿归约维切块、axes来自输入（opset 18）与noop_with_empty_axes
+TEST_F(MathOperatorsTest, ReduceLargeTensorsAndAxesInput) {
+    // 全部归约：分块的部分和成对合并，误差远小于逐个累加
+    auto x = CreateTensor(Shape({1 << 20}), DataType::FLOAT32);
+    float* data = static_cast<float*>(x->GetData());
+    double expected = 0.0;
+    for (size_t i = 0; i < x->GetElementCount(); ++i) {
+        data[i] = 0.1f + static_cast<float>(i % 10) * 0.01f;
+        expected += data[i];
+    }
+    auto sum = OperatorRegistry::Instance().Create("ReduceSum");
+    ASSERT_NE(sum, nullptr);
+    sum->SetAttribute("keepdims", AttributeValue(int64_t(0)));
+    auto y = CreateTensor(Shape(std::vector<int64_t>{}), DataType::FLOAT32);
+    ASSERT_TRUE(sum->Execute({x.get()}, {y.get()}, ctx_.get()).IsOk());
+    EXPECT_NEAR(*static_cast<const float*>(y->GetData()), expected, expected * 1e-6);
+    
+    // [R, K]：axes作为INT64输入
+    auto m = CreateTensor(Shape({40000, 8}), DataType::FLOAT32);
+    float* md = static_cast<float*>(m->GetData());
+    for (size_t i = 0; i < m->GetElementCount(); ++i) md[i] = static_cast<float>(i % 8) + 0.5f;
+    auto axes = CreateTensor(Shape({1}), DataType::INT64);
+    *static_cast<int64_t*>(axes->GetData()) = 0;
+    auto mean = OperatorRegistry::Instance().Create("ReduceMean");
+    ASSERT_NE(mean, nullptr);
+    std::vector<Tensor*> inputs = {m.get(), axes.get()};
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(mean->InferOutputShape(inputs, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, 8}));
+    auto column_mean = CreateTensor(shapes[0], DataType::FLOAT32);
+    ASSERT_TRUE(mean->Execute(inputs, {column_mean.get()}, ctx_.get()).IsOk());
+    for (int c = 0; c < 8; ++c) {
+        EXPECT_NEAR(static_cast<const float*>(column_mean->GetData())[c], c + 0.5f, 1e-5f);
+    }
+    
+    // noop_with_empty_axes：没有axes时原样输出
+    auto noop = OperatorRegistry::Instance().Create("ReduceMax");
+    ASSERT_NE(noop, nullptr);
+    noop->SetAttribute("noop_with_empty_axes", AttributeValue(int64_t(1)));
+    shapes.clear();
+    ASSERT_TRUE(noop->InferOutputShape({m.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, m->GetShape().dims);
+    
+    auto bad = OperatorRegistry::Instance().Create("ReduceSum");
+    bad->SetAttribute("axes", AttributeValue(std::vector<int64_t>{0, -2}));
+    EXPECT_FALSE(bad->ValidateInputs({m.get()}).IsOk());
+}
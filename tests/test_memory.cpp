@@ -3,9 +3,17 @@
 
 #include <gtest/gtest.h>
 #include "inferunity/memory.h"
+#include "inferunity/kv_cache.h"
+#include "inferunity/memory_planner.h"
+#include "inferunity/operator.h"
 #include "inferunity/tensor.h"
 #include "inferunity/graph.h"
 #include "inferunity/types.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace inferunity;
@@ -126,3 +134,736 @@ TEST_F(MemoryTest, MemoryReuse) {
     EXPECT_EQ(graph->GetValues().size(), 2);
 }
 
+
+namespace {
+
+// 构造一条Relu链：x -> t0 -> t1 -> ... -> y，另加一个贯穿全图的旁路张量
+// 中间张量大小交替，便于观察复用
+std::unique_ptr<Graph> BuildChainGraph(int length, std::vector<Value*>* intermediates) {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetTensor(CreateTensor(Shape({1, 64}), DataType::FLOAT32, DeviceType::CPU));
+    graph->AddInput(x);
+    
+    Value* prev = x;
+    Value* skip = nullptr;
+    for (int i = 0; i < length; ++i) {
+        Value* out = graph->AddValue();
+        const int64_t width = (i % 2 == 0) ? 256 : 64;
+        out->SetTensor(CreateTensor(Shape({1, width}), DataType::FLOAT32, DeviceType::CPU));
+        Node* node = graph->AddNode("Relu", "relu" + std::to_string(i));
+        node->AddInput(prev);
+        if (i == length - 1 && skip) {
+            node->AddInput(skip);
+        }
+        node->AddOutput(out);
+        intermediates->push_back(out);
+        if (i == 0) skip = out;
+        prev = out;
+    }
+    graph->AddOutput(prev);
+    return graph;
+}
+
+// 沿shares_with找到张量所在的最外层缓冲
+const Value* RootOf(const MemoryPlan& plan, const Value* value) {
+    for (;;) {
+        auto it = std::find_if(plan.entries.begin(), plan.entries.end(),
+                               [value](const MemoryPlanEntry& entry) { return entry.value == value; });
+        if (it == plan.entries.end() || !it->shares_with) return value;
+        value = it->shares_with;
+    }
+}
+
+void ExpectNoConflicts(const MemoryPlan& plan) {
+    for (size_t i = 0; i < plan.entries.size(); ++i) {
+        const auto& a = plan.entries[i];
+        EXPECT_EQ(a.offset % plan.alignment, 0u);
+        EXPECT_LE(a.offset + a.size, plan.arena_size);
+        for (size_t j = i + 1; j < plan.entries.size(); ++j) {
+            const auto& b = plan.entries[j];
+            // 原地执行的输出、Concat/Split的切片与所在的缓冲有意重叠
+            if (RootOf(plan, a.value) == RootOf(plan, b.value)) continue;
+            bool live_together = a.birth <= b.death && b.birth <= a.death;
+            bool memory_overlap = a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+            EXPECT_FALSE(live_together && memory_overlap)
+                << "entries " << i << " and " << j << " overlap";
+        }
+    }
+}
+
+} // anonymous namespace
+
+// 测试静态内存规划：两种策略都不冲突，且峰值介于下界与朴素总和之间
+TEST_F(MemoryTest, MemoryPlannerStrategies) {
+    std::vector<Value*> intermediates;
+    auto graph = BuildChainGraph(8, &intermediates);
+    
+    for (auto strategy : {MemoryPlanStrategy::GREEDY_BY_SIZE,
+                          MemoryPlanStrategy::GREEDY_BY_BREADTH,
+                          MemoryPlanStrategy::AUTO}) {
+        MemoryPlannerOptions options;
+        options.strategy = strategy;
+        MemoryPlan plan;
+        ASSERT_TRUE(PlanMemory(graph.get(), options, &plan).IsOk());
+        
+        // 图输出默认不参与规划
+        EXPECT_EQ(plan.entries.size(), intermediates.size() - 1);
+        ExpectNoConflicts(plan);
+        EXPECT_GE(plan.arena_size, plan.lower_bound);
+        EXPECT_LT(plan.arena_size, plan.naive_size);
+        EXPECT_NE(plan.strategy, MemoryPlanStrategy::AUTO);
+    }
+}
+
+// 测试arena绑定：规划内的张量都成为arena中的视图，arena随最后一个视图释放
+TEST_F(MemoryTest, MemoryPlanBinding) {
+    std::vector<Value*> intermediates;
+    auto graph = BuildChainGraph(5, &intermediates);
+    
+    MemoryPlan plan;
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    auto arena = MemoryArena::Create(plan.arena_size, plan.alignment);
+    ASSERT_NE(arena, nullptr);
+    ASSERT_TRUE(BindMemoryPlan(plan, arena).IsOk());
+    
+    const uint8_t* base = static_cast<const uint8_t*>(arena->GetBase());
+    for (const auto& entry : plan.entries) {
+        auto tensor = entry.value->GetTensor();
+        ASSERT_NE(tensor, nullptr);
+        EXPECT_FALSE(tensor->IsOwned());
+        EXPECT_EQ(static_cast<const uint8_t*>(tensor->GetData()), base + entry.offset);
+    }
+    
+    std::weak_ptr<MemoryArena> weak_arena = arena;
+    arena.reset();
+    EXPECT_FALSE(weak_arena.expired());  // 视图仍持有arena
+    graph.reset();
+    EXPECT_TRUE(weak_arena.expired());
+}
+
+// 测试原地执行的规划：输入之后不再被读取时输出复用其缓冲，链式复用归到同一块
+TEST_F(MemoryTest, InPlaceMemoryPlan) {
+    // x -> Relu -> a -> Relu -> b -> Add(b, a) -> c -> Relu -> d -> Relu -> y
+    auto graph = std::make_unique<Graph>();
+    auto make_value = [&graph]() {
+        Value* value = graph->AddValue();
+        value->SetTensor(CreateTensor(Shape({1, 64}), DataType::FLOAT32, DeviceType::CPU));
+        return value;
+    };
+    Value* x = make_value();
+    graph->AddInput(x);
+    Value* a = make_value();
+    Value* b = make_value();
+    Value* c = make_value();
+    Value* d = make_value();
+    Value* y = make_value();
+    auto add_node = [&graph](const std::string& op_type, std::vector<Value*> inputs, Value* output) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) node->AddInput(input);
+        node->AddOutput(output);
+    };
+    add_node("Relu", {x}, a);
+    add_node("Relu", {a}, b);
+    add_node("Add", {b, a}, c);
+    add_node("Relu", {c}, d);
+    add_node("Relu", {d}, y);
+    graph->AddOutput(y);
+    
+    std::unordered_map<const Value*, TensorLifetime> lifetimes;
+    for (const auto& lifetime : AnalyzeTensorLifetimes(graph.get())) {
+        lifetimes[static_cast<const Value*>(lifetime.value_ptr)] = lifetime;
+    }
+    EXPECT_EQ(lifetimes[a].inplace_of, nullptr);  // 图输入不复用
+    EXPECT_EQ(lifetimes[b].inplace_of, nullptr);  // a之后还被Add读取
+    EXPECT_EQ(lifetimes[c].inplace_of, b);
+    EXPECT_EQ(lifetimes[d].inplace_of, c);
+    EXPECT_EQ(lifetimes[y].inplace_of, nullptr);  // 图输出单独分配
+    
+    MemoryPlan plan;
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    std::unordered_map<const Value*, MemoryPlanEntry> entries;
+    for (const auto& entry : plan.entries) entries[entry.value] = entry;
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[c].shares_with, b);
+    EXPECT_EQ(entries[d].shares_with, b);
+    EXPECT_EQ(entries[c].offset, entries[b].offset);
+    EXPECT_EQ(entries[d].offset, entries[b].offset);
+    EXPECT_EQ(entries[b].death, entries[d].death);
+    ExpectNoConflicts(plan);
+    // a与b/c/d的合并块各占一份
+    EXPECT_EQ(plan.arena_size, 2 * entries[a].size);
+}
+
+// 测试切片别名：Concat的输入直接写在输出的相邻切片上，Split的输出是输入中的切片，两者都不再拷贝
+TEST_F(MemoryTest, SliceAliasMemoryPlan) {
+    // x -> Relu -> a, x -> Sigmoid -> b, Concat(a, b) -> c, Split(c) -> p, q, Add(p, q) -> y
+    auto graph = std::make_unique<Graph>();
+    auto make_value = [&graph](int64_t width) {
+        Value* value = graph->AddValue();
+        value->SetTensor(CreateTensor(Shape({1, width}), DataType::FLOAT32, DeviceType::CPU));
+        return value;
+    };
+    Value* x = make_value(16);
+    graph->AddInput(x);
+    Value* a = make_value(16);
+    Value* b = make_value(16);
+    Value* c = make_value(32);
+    Value* p = make_value(16);
+    Value* q = make_value(16);
+    Value* y = make_value(16);
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(x);
+    relu->AddOutput(a);
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid");
+    sigmoid->AddInput(x);
+    sigmoid->AddOutput(b);
+    Node* concat = graph->AddNode("Concat", "concat");
+    concat->AddInput(a);
+    concat->AddInput(b);
+    concat->AddOutput(c);
+    concat->SetAttribute("axis", AttributeValue(static_cast<int64_t>(1)));
+    Node* split = graph->AddNode("Split", "split");
+    split->AddInput(c);
+    split->AddOutput(p);
+    split->AddOutput(q);
+    split->SetAttribute("axis", AttributeValue(static_cast<int64_t>(1)));
+    split->SetAttribute("split", AttributeValue(std::vector<int64_t>{16, 16}));
+    Node* add = graph->AddNode("Add", "add");
+    add->AddInput(p);
+    add->AddInput(q);
+    add->AddOutput(y);
+    graph->AddOutput(y);
+    
+    std::unordered_map<const Value*, TensorLifetime> lifetimes;
+    for (const auto& lifetime : AnalyzeTensorLifetimes(graph.get())) {
+        lifetimes[static_cast<const Value*>(lifetime.value_ptr)] = lifetime;
+    }
+    EXPECT_EQ(lifetimes[a].slice_of, c);
+    EXPECT_EQ(lifetimes[b].slice_of, c);
+    EXPECT_EQ(lifetimes[b].slice_index, 1);
+    EXPECT_EQ(lifetimes[p].slice_of, c);
+    EXPECT_EQ(lifetimes[q].slice_index, 1);
+    EXPECT_EQ(lifetimes[c].slice_of, nullptr);
+    EXPECT_EQ(lifetimes[y].inplace_of, nullptr);  // 图输出单独分配
+    
+    MemoryPlan plan;
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    std::unordered_map<const Value*, MemoryPlanEntry> entries;
+    for (const auto& entry : plan.entries) entries[entry.value] = entry;
+    ASSERT_EQ(entries.size(), 5u);
+    EXPECT_EQ(entries[a].shares_with, c);
+    EXPECT_EQ(entries[b].alias_offset, 16 * sizeof(float));
+    EXPECT_EQ(entries[a].offset, entries[c].offset);
+    EXPECT_EQ(entries[b].offset, entries[c].offset + 16 * sizeof(float));
+    EXPECT_EQ(entries[p].offset, entries[a].offset);
+    EXPECT_EQ(entries[q].offset, entries[b].offset);
+    // 整块的生命周期从a出生到p/q最后被读取
+    EXPECT_EQ(entries[c].birth, entries[a].birth);
+    EXPECT_EQ(entries[c].death, entries[p].death);
+    ExpectNoConflicts(plan);
+    EXPECT_EQ(plan.arena_size, entries[c].size);
+    
+    // 绑定arena后内核直接在原位读写：Concat与Split都跳过拷贝，结果仍然正确
+    auto arena = MemoryArena::Create(plan.arena_size, plan.alignment);
+    ASSERT_NE(arena, nullptr);
+    ASSERT_TRUE(BindMemoryPlan(plan, arena).IsOk());
+    float* a_data = static_cast<float*>(a->GetTensor()->GetData());
+    float* b_data = static_cast<float*>(b->GetTensor()->GetData());
+    for (int i = 0; i < 16; ++i) {
+        a_data[i] = static_cast<float>(i);
+        b_data[i] = static_cast<float>(100 + i);
+    }
+    auto run = [](Node* node) {
+        auto op = OperatorRegistry::Instance().Create(node->GetOpType());
+        for (const auto& attribute : node->GetAttributes()) {
+            op->SetAttribute(attribute.first, attribute.second);
+        }
+        std::vector<Tensor*> inputs;
+        std::vector<Tensor*> outputs;
+        for (Value* input : node->GetInputs()) inputs.push_back(input->GetTensor().get());
+        for (Value* output : node->GetOutputs()) outputs.push_back(output->GetTensor().get());
+        return op->Execute(inputs, outputs, nullptr);
+    };
+    ASSERT_TRUE(run(concat).IsOk());
+    ASSERT_TRUE(run(split).IsOk());
+    const float* c_data = static_cast<const float*>(c->GetTensor()->GetData());
+    const float* q_data = static_cast<const float*>(q->GetTensor()->GetData());
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_EQ(c_data[i], static_cast<float>(i));
+        EXPECT_EQ(c_data[16 + i], static_cast<float>(100 + i));
+        EXPECT_EQ(q_data[i], static_cast<float>(100 + i));
+    }
+    
+    // 切分轴之前有非1的维度时切片不连续，照常独立分配
+    for (Value* value : {x, a, b, p, q, y}) {
+        value->SetTensor(CreateTensor(Shape({2, 16}), DataType::FLOAT32, DeviceType::CPU));
+    }
+    c->SetTensor(CreateTensor(Shape({2, 32}), DataType::FLOAT32, DeviceType::CPU));
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    for (const auto& entry : plan.entries) {
+        EXPECT_EQ(entry.shares_with, nullptr);
+    }
+    ExpectNoConflicts(plan);
+}
+
+// 测试Pad的输入放在输出内部：只在第0轴填充时输入直接写到输出的内部，Pad只写边框
+TEST_F(MemoryTest, PadInteriorMemoryPlan) {
+    // x -> Relu -> a [4, 16], Pad(a, pads) -> b [7, 16], Sigmoid(b) -> y
+    auto graph = std::make_unique<Graph>();
+    auto make_value = [&graph](int64_t rows) {
+        Value* value = graph->AddValue();
+        value->SetTensor(CreateTensor(Shape({rows, 16}), DataType::FLOAT32, DeviceType::CPU));
+        return value;
+    };
+    Value* x = make_value(4);
+    graph->AddInput(x);
+    Value* a = make_value(4);
+    Value* b = make_value(7);
+    Value* y = make_value(7);
+    Value* pads = graph->AddValue();
+    auto pads_tensor = CreateTensor(Shape({4}), DataType::INT64, DeviceType::CPU);
+    const int64_t pad_values[] = {2, 0, 1, 0};
+    std::memcpy(pads_tensor->GetData(), pad_values, sizeof(pad_values));
+    pads->SetTensor(pads_tensor);
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(x);
+    relu->AddOutput(a);
+    Node* pad = graph->AddNode("Pad", "pad");
+    pad->AddInput(a);
+    pad->AddInput(pads);
+    pad->AddOutput(b);
+    pad->SetAttribute("mode", AttributeValue(std::string("edge")));
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid");
+    sigmoid->AddInput(b);
+    sigmoid->AddOutput(y);
+    graph->AddOutput(y);
+    
+    std::unordered_map<const Value*, TensorLifetime> lifetimes;
+    for (const auto& lifetime : AnalyzeTensorLifetimes(graph.get())) {
+        lifetimes[static_cast<const Value*>(lifetime.value_ptr)] = lifetime;
+    }
+    EXPECT_EQ(lifetimes[a].slice_of, b);
+    EXPECT_EQ(lifetimes[a].slice_axis, 0);
+    EXPECT_EQ(lifetimes[a].slice_start, 2);
+    
+    MemoryPlan plan;
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    std::unordered_map<const Value*, MemoryPlanEntry> entries;
+    for (const auto& entry : plan.entries) entries[entry.value] = entry;
+    EXPECT_EQ(entries[a].shares_with, b);
+    EXPECT_EQ(entries[a].alias_offset, 2 * 16 * sizeof(float));
+    EXPECT_EQ(entries[a].offset, entries[b].offset + 2 * 16 * sizeof(float));
+    ExpectNoConflicts(plan);
+    
+    auto arena = MemoryArena::Create(plan.arena_size, plan.alignment);
+    ASSERT_NE(arena, nullptr);
+    ASSERT_TRUE(BindMemoryPlan(plan, arena).IsOk());
+    float* a_data = static_cast<float*>(a->GetTensor()->GetData());
+    for (int i = 0; i < 64; ++i) {
+        a_data[i] = static_cast<float>(i);
+    }
+    auto op = OperatorRegistry::Instance().Create("Pad");
+    op->SetAttribute("mode", AttributeValue(std::string("edge")));
+    ASSERT_TRUE(op->Execute({a->GetTensor().get(), pads_tensor.get()}, {b->GetTensor().get()}, nullptr).IsOk());
+    const float* b_data = static_cast<const float*>(b->GetTensor()->GetData());
+    for (int row = 0; row < 7; ++row) {
+        const int source = std::min(std::max(row - 2, 0), 3);
+        for (int col = 0; col < 16; ++col) {
+            EXPECT_EQ(b_data[row * 16 + col], static_cast<float>(source * 16 + col));
+        }
+    }
+    
+    // 填充在第1轴上时输入在输出中不连续，照常独立分配
+    const int64_t column_pads[] = {0, 2, 0, 1};
+    std::memcpy(pads_tensor->GetData(), column_pads, sizeof(column_pads));
+    b->SetTensor(CreateTensor(Shape({4, 19}), DataType::FLOAT32, DeviceType::CPU));
+    ASSERT_TRUE(PlanMemory(graph.get(), MemoryPlannerOptions(), &plan).IsOk());
+    for (const auto& entry : plan.entries) {
+        EXPECT_EQ(entry.shares_with, nullptr);
+    }
+}
+
+// 测试分页KV cache的块分配：按需分配块、Fork共享前缀、写入共享末块时copy-on-write、释放后复用
+TEST_F(MemoryTest, PagedKVCacheBlocks) {
+    PagedKVCacheOptions options;
+    options.block_size = 4;
+    options.max_blocks = 6;
+    PagedKVCache cache(options);
+    ASSERT_TRUE(cache.AddLayer(2, 8, 8).IsOk());
+    
+    // system prompt占用6个位置：2个块
+    ASSERT_TRUE(cache.AddSequence(0).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(0, 6).IsOk());
+    EXPECT_EQ(cache.GetSequenceLength(0), 6);
+    ASSERT_EQ(cache.GetBlockTable(0).size(), 2u);
+    EXPECT_FALSE(cache.AddLayer(1, 8, 8).IsOk());
+    cache.GetKeyBlock(0, cache.GetBlockTable(0)[1])[0] = 3.0f;
+    
+    // 两个请求共享前缀：不分配新块
+    ASSERT_TRUE(cache.Fork(0, 1).IsOk());
+    ASSERT_TRUE(cache.Fork(0, 2).IsOk());
+    EXPECT_FALSE(cache.Fork(0, 2).IsOk());
+    EXPECT_EQ(cache.GetNumBlocks(), 2u);
+    EXPECT_EQ(cache.GetNumSharedBlocks(), 2u);
+    EXPECT_EQ(cache.GetBlockRefCount(cache.GetBlockTable(0)[0]), 3);
+    
+    // 序列1追加：共享的未满末块被复制，满块继续共享
+    ASSERT_TRUE(cache.AppendSlots(1, 1).IsOk());
+    const auto& table1 = cache.GetBlockTable(1);
+    EXPECT_EQ(table1[0], cache.GetBlockTable(0)[0]);
+    EXPECT_NE(table1[1], cache.GetBlockTable(0)[1]);
+    EXPECT_EQ(cache.GetKeyBlock(0, table1[1])[0], 3.0f);
+    EXPECT_EQ(cache.GetBlockRefCount(cache.GetBlockTable(0)[1]), 2);
+    
+    // 块不足时失败且不修改状态
+    ASSERT_TRUE(cache.AppendSlots(2, 2).IsOk());  // 复制末块：共4块
+    EXPECT_EQ(cache.GetNumBlocks(), 4u);
+    EXPECT_FALSE(cache.AppendSlots(2, 12).IsOk());
+    EXPECT_EQ(cache.GetSequenceLength(2), 8);
+    EXPECT_EQ(cache.GetBlockTable(2).size(), 2u);
+    
+    // 截断与删除释放块，新分配优先复用空闲块
+    ASSERT_TRUE(cache.Trim(2, 4).IsOk());
+    EXPECT_EQ(cache.GetNumFreeBlocks(), 1u);
+    ASSERT_TRUE(cache.RemoveSequence(1).IsOk());
+    EXPECT_EQ(cache.GetNumFreeBlocks(), 2u);
+    ASSERT_TRUE(cache.AppendSlots(2, 8).IsOk());
+    EXPECT_EQ(cache.GetNumFreeBlocks(), 0u);
+    EXPECT_EQ(cache.GetNumBlocks(), 4u);
+    EXPECT_FALSE(cache.AppendSlots(7, 1).IsOk());
+}
+
+// 测试KV块的换出与换入：换出释放块池中的块，换回新的块后内容与长度不变；交换区不足时不做修改
+TEST_F(MemoryTest, PagedKVCacheSwap) {
+    PagedKVCacheOptions options;
+    options.block_size = 4;
+    options.max_blocks = 3;
+    options.max_swap_blocks = 2;
+    PagedKVCache cache(options);
+    ASSERT_TRUE(cache.AddLayer(2, 8, 8).IsOk());
+    ASSERT_TRUE(cache.AddSequence(0).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(0, 6).IsOk());
+    for (int32_t i = 0; i < 2; ++i) {
+        cache.GetKeyBlock(0, cache.GetBlockTable(0)[i])[1] = 10.0f + static_cast<float>(i);
+        cache.GetValueBlock(0, cache.GetBlockTable(0)[i])[5] = 20.0f + static_cast<float>(i);
+    }
+    EXPECT_FALSE(cache.SwapIn(0).IsOk());
+    
+    // 换出后块池空出，另一个序列可以占满
+    ASSERT_TRUE(cache.SwapOut(0).IsOk());
+    EXPECT_TRUE(cache.IsSwappedOut(0));
+    EXPECT_EQ(cache.GetSequenceLength(0), 6);
+    EXPECT_TRUE(cache.GetBlockTable(0).empty());
+    EXPECT_EQ(cache.GetNumFreeSwapBlocks(), 0u);
+    EXPECT_FALSE(cache.AppendSlots(0, 1).IsOk());
+    EXPECT_FALSE(cache.Fork(0, 5).IsOk());
+    ASSERT_TRUE(cache.AddSequence(1).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(1, 12).IsOk());
+    cache.GetKeyBlock(0, cache.GetBlockTable(1)[0])[1] = -1.0f;
+    EXPECT_FALSE(cache.CanSwapIn(0));
+    EXPECT_FALSE(cache.SwapIn(0).IsOk());
+    EXPECT_FALSE(cache.SwapOut(1).IsOk());  // 交换区已满
+    EXPECT_EQ(cache.GetBlockTable(1).size(), 3u);
+    
+    ASSERT_TRUE(cache.RemoveSequence(1).IsOk());
+    ASSERT_TRUE(cache.CanSwapIn(0));
+    ASSERT_TRUE(cache.SwapIn(0).IsOk());
+    cache.WaitForSwaps();
+    EXPECT_FALSE(cache.IsSwappedOut(0));
+    EXPECT_EQ(cache.GetNumFreeSwapBlocks(), 2u);
+    ASSERT_EQ(cache.GetBlockTable(0).size(), 2u);
+    for (int32_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(cache.GetKeyBlock(0, cache.GetBlockTable(0)[i])[1], 10.0f + static_cast<float>(i));
+        EXPECT_EQ(cache.GetValueBlock(0, cache.GetBlockTable(0)[i])[5], 20.0f + static_cast<float>(i));
+    }
+    ASSERT_TRUE(cache.AppendSlots(0, 2).IsOk());
+    EXPECT_EQ(cache.GetSequenceLength(0), 8);
+    EXPECT_EQ(cache.GetSwapStats().num_swap_outs, 1u);
+    EXPECT_EQ(cache.GetSwapStats().swapped_in_blocks, 2u);
+    
+    // 换出的序列被删除时交换区块直接归还
+    ASSERT_TRUE(cache.SwapOut(0).IsOk());
+    ASSERT_TRUE(cache.RemoveSequence(0).IsOk());
+    EXPECT_EQ(cache.GetNumFreeSwapBlocks(), 2u);
+    EXPECT_EQ(cache.GetNumFreeBlocks(), cache.GetNumBlocks());
+}
+
+// 测试前缀缓存：写满的块登记后被相同前缀的序列按引用复用，引用归零后留在LRU中，块不足时才回收
+TEST_F(MemoryTest, PagedKVCachePrefixCaching) {
+    PagedKVCacheOptions options;
+    options.block_size = 4;
+    options.max_blocks = 4;
+    options.enable_prefix_caching = true;
+    PagedKVCache cache(options);
+    ASSERT_TRUE(cache.AddLayer(1, 4, 4).IsOk());
+    
+    std::vector<int32_t> prompt = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int64_t cached = -1;
+    ASSERT_TRUE(cache.AddSequence(0, prompt, &cached).IsOk());
+    EXPECT_EQ(cached, 0);
+    ASSERT_TRUE(cache.AppendSlots(0, 10).IsOk());
+    cache.GetKeyBlock(0, cache.GetBlockTable(0)[1])[0] = 5.0f;
+    ASSERT_TRUE(cache.CachePrefix(0, prompt, 10).IsOk());
+    EXPECT_EQ(cache.GetNumCachedBlocks(), 2u);
+    
+    // 前8个token相同：复用两个整块；末尾不同的token不影响
+    std::vector<int32_t> other = {0, 1, 2, 3, 4, 5, 6, 7, 12, 13};
+    ASSERT_TRUE(cache.AddSequence(1, other, &cached).IsOk());
+    EXPECT_EQ(cached, 8);
+    EXPECT_EQ(cache.GetSequenceLength(1), 8);
+    EXPECT_EQ(cache.GetBlockTable(1)[1], cache.GetBlockTable(0)[1]);
+    EXPECT_EQ(cache.GetBlockRefCount(cache.GetBlockTable(0)[0]), 2);
+    ASSERT_TRUE(cache.AppendSlots(1, 2).IsOk());
+    
+    // 前缀不同则链式哈希不同，第一块就不命中
+    std::vector<int32_t> shifted = {9, 0, 1, 2, 3, 4, 5, 6, 7};
+    ASSERT_TRUE(cache.AddSequence(2, shifted, &cached).IsOk());
+    EXPECT_EQ(cached, 0);
+    ASSERT_TRUE(cache.RemoveSequence(2).IsOk());
+    
+    // 释放后缓存块进入可回收列表，再次到达的相同prompt仍然命中；最后一个token总是留给调用方计算
+    ASSERT_TRUE(cache.RemoveSequence(0).IsOk());
+    ASSERT_TRUE(cache.RemoveSequence(1).IsOk());
+    EXPECT_EQ(cache.GetNumEvictableBlocks(), 2u);
+    std::vector<int32_t> exact(prompt.begin(), prompt.begin() + 8);
+    ASSERT_TRUE(cache.AddSequence(3, exact, &cached).IsOk());
+    EXPECT_EQ(cached, 4);
+    ASSERT_TRUE(cache.RemoveSequence(3).IsOk());
+    ASSERT_TRUE(cache.AddSequence(4, prompt, &cached).IsOk());
+    EXPECT_EQ(cached, 8);
+    EXPECT_EQ(cache.GetKeyBlock(0, cache.GetBlockTable(4)[1])[0], 5.0f);
+    EXPECT_EQ(cache.GetNumEvictableBlocks(), 0u);
+    ASSERT_TRUE(cache.RemoveSequence(4).IsOk());
+    
+    // 预算用尽时按LRU回收缓存块
+    ASSERT_TRUE(cache.AddSequence(5).IsOk());
+    ASSERT_TRUE(cache.AppendSlots(5, 16).IsOk());
+    EXPECT_EQ(cache.GetNumBlocks(), 4u);
+    EXPECT_EQ(cache.GetNumCachedBlocks(), 0u);
+    
+    const PrefixCacheStats& stats = cache.GetPrefixCacheStats();
+    EXPECT_EQ(stats.num_queries, 5u);
+    EXPECT_EQ(stats.num_hits, 3u);
+    EXPECT_EQ(stats.cached_tokens, 20u);
+    EXPECT_EQ(stats.num_evictions, 2u);
+    EXPECT_NEAR(stats.GetHitRate(), 20.0 / 47.0, 1e-9);
+}
+
+namespace {
+
+// 计数分配器：验证替换的分配器被张量使用并持有
+class CountingAllocator : public MemoryAllocator {
+public:
+    void* Allocate(size_t size) override { ++allocations; return AllocateMemory(size); }
+    void Free(void* ptr) override { ++frees; FreeMemory(ptr); }
+    size_t allocations = 0;
+    size_t frees = 0;
+};
+
+} // anonymous namespace
+
+// 测试统一的分配器接口：默认分配器即内存池，可替换、可按张量指定（arena、固定块池）
+TEST_F(MemoryTest, UnifiedAllocatorInterface) {
+    // 默认分配器常驻，不参与引用计数，统计就是内存池的统计
+    auto cpu = GetMemoryAllocator(DeviceType::CPU);
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_EQ(cpu.use_count(), 0);
+    EXPECT_EQ(GetMemoryAllocator(DeviceType::CPU).get(), cpu.get());
+    std::shared_ptr<MemoryAllocator> owner;
+    EXPECT_EQ(ResolveMemoryAllocator(DeviceType::CPU, &owner), cpu.get());
+    EXPECT_EQ(owner, nullptr);
+    MemoryStats allocator_stats{};
+    ASSERT_TRUE(cpu->GetStats(&allocator_stats));
+    EXPECT_EQ(allocator_stats.allocation_count, GetMemoryStats().allocation_count);
+    void* aligned = cpu->AllocateAligned(1000, 256);
+    ASSERT_NE(aligned, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0u);
+    cpu->Free(aligned);
+    
+    // 替换的分配器由张量持有，恢复默认后仍用它释放
+    auto counting = std::make_shared<CountingAllocator>();
+    SetMemoryAllocator(DeviceType::CPU, counting);
+    auto tensor = CreateTensor(Shape({16, 16}), DataType::FLOAT32);
+    SetMemoryAllocator(DeviceType::CPU, nullptr);
+    EXPECT_EQ(ResolveMemoryAllocator(DeviceType::CPU, &owner), cpu.get());
+    EXPECT_EQ(counting->allocations, 1u);
+    EXPECT_EQ(counting.use_count(), 2);
+    tensor.reset();
+    EXPECT_EQ(counting->frees, 1u);
+    EXPECT_EQ(counting.use_count(), 1);
+    
+    // arena分配器：依次切出，溢出时转交内存池，Reset后复用
+    auto arena = MemoryArena::Create(4096);
+    ASSERT_NE(arena, nullptr);
+    auto arena_allocator = std::make_shared<ArenaAllocator>(arena);
+    auto a = CreateTensorWithAllocator(Shape({256}), DataType::FLOAT32, arena_allocator);
+    auto b = CreateTensorWithAllocator(Shape({256}), DataType::FLOAT32, arena_allocator);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->GetData(), arena->GetBase());
+    EXPECT_EQ(static_cast<uint8_t*>(b->GetData()), static_cast<uint8_t*>(arena->GetBase()) + 1024);
+    auto overflow = CreateTensorWithAllocator(Shape({1024}), DataType::FLOAT32, arena_allocator);
+    ASSERT_NE(overflow, nullptr);
+    EXPECT_EQ(arena_allocator->GetOverflowCount(), 1u);
+    EXPECT_NE(overflow->GetData(), nullptr);
+    ASSERT_TRUE(overflow->FillValue(1.0f).IsOk());
+    a.reset();
+    b.reset();
+    overflow.reset();
+    EXPECT_EQ(arena_allocator->GetUsedBytes(), 2048u);
+    arena_allocator->Reset();
+    auto c = CreateTensorWithAllocator(Shape({8}), DataType::FLOAT32, arena_allocator);
+    EXPECT_EQ(c->GetData(), arena->GetBase());
+    
+    // 固定块池：同样实现MemoryAllocator，释放的块被复用
+    auto blocks = std::make_shared<MemoryPool>(1024, 2);
+    auto d = CreateTensorWithAllocator(Shape({64}), DataType::FLOAT32, blocks);
+    void* d_data = d->GetData();
+    d.reset();
+    auto e = CreateTensorWithAllocator(Shape({128}), DataType::FLOAT32, blocks);
+    EXPECT_EQ(e->GetData(), d_data);
+    auto large = CreateTensorWithAllocator(Shape({1024}), DataType::FLOAT32, blocks);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(large.use_count(), 1);
+}
+
+// 测试dma-buf共享分配器：有dma-heap时按地址反查到所在的dma-buf，没有时退回内存池且查不到
+TEST_F(MemoryTest, DmaBufAllocator) {
+    auto allocator = DmaBufAllocator::Instance();
+    ASSERT_NE(allocator, nullptr);
+    EXPECT_EQ(DmaBufAllocator::Instance().get(), allocator.get());
+    
+    auto tensor = CreateTensorWithAllocator(Shape({3, 1000}), DataType::FLOAT32, allocator);
+    ASSERT_NE(tensor, nullptr);
+    ASSERT_NE(tensor->GetData(), nullptr);
+    ASSERT_TRUE(tensor->FillValue(2.0f).IsOk());
+    EXPECT_EQ(static_cast<float*>(tensor->GetData())[2999], 2.0f);
+    
+    const uint8_t* data = static_cast<const uint8_t*>(tensor->GetData());
+    DmaBufRegion region;
+    EXPECT_EQ(FindDmaBufRegion(data + 4000, 8000, &region), allocator->IsAvailable());
+    if (allocator->IsAvailable()) {
+        EXPECT_GE(region.fd, 0);
+        EXPECT_EQ(region.base, tensor->GetData());
+        EXPECT_EQ(region.offset, 4000u);
+        EXPECT_GE(region.size, tensor->GetSizeInBytes());
+        EXPECT_FALSE(FindDmaBufRegion(data + 4000, region.size, &region));
+        EXPECT_TRUE(SyncDmaBuf(region.fd, true, true).IsOk());
+        EXPECT_TRUE(SyncDmaBuf(region.fd, false, true).IsOk());
+    }
+    
+    // 释放后不再能查到
+    tensor.reset();
+    EXPECT_FALSE(FindDmaBufRegion(data, 4, &region));
+    int on_stack = 0;
+    EXPECT_FALSE(FindDmaBufRegion(&on_stack, sizeof(on_stack), &region));
+}
+
+// 测试激活内存预算：跨过峰值的廉价张量在使用前重新计算，放不进预算时在规划时报错
+TEST_F(MemoryTest, ActivationBudgetRecomputation) {
+    // x -> Sigmoid -> s, Add(x, s) -> m1 -> Softmax -> m2 -> Softmax -> m3, Add(m3, s) -> y
+    auto graph = std::make_unique<Graph>();
+    auto make_value = [&graph]() {
+        Value* value = graph->AddValue();
+        value->SetTensor(CreateTensor(Shape({1, 1024}), DataType::FLOAT32, DeviceType::CPU));
+        return value;
+    };
+    Value* x = make_value();
+    graph->AddInput(x);
+    auto add_node = [&graph, &make_value](const std::string& op_type, std::vector<Value*> inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) node->AddInput(input);
+        Value* output = make_value();
+        node->AddOutput(output);
+        return output;
+    };
+    Value* s = add_node("Sigmoid", {x});
+    Value* m1 = add_node("Add", {x, s});
+    Value* m2 = add_node("Softmax", {m1});
+    Value* m3 = add_node("Softmax", {m2});
+    Value* y = add_node("Add", {m3, s});
+    graph->AddOutput(y);
+    
+    MemoryPlan plan;
+    ASSERT_TRUE(PlanMemoryWithinBudget(graph.get(), 0, MemoryPlannerOptions(), &plan).IsOk());
+    EXPECT_EQ(plan.arena_size, 3 * 4096u);
+    
+    std::vector<std::pair<Node*, const Node*>> recomputed;
+    ASSERT_TRUE(PlanMemoryWithinBudget(graph.get(), 2 * 4096, MemoryPlannerOptions(), &plan, &recomputed).IsOk());
+    EXPECT_LE(plan.arena_size, 2 * 4096u);
+    ExpectNoConflicts(plan);
+    ASSERT_EQ(recomputed.size(), 1u);
+    Node* clone = recomputed[0].first;
+    EXPECT_EQ(recomputed[0].second, s->GetProducer());
+    EXPECT_EQ(clone->GetOpType(), "Sigmoid");
+    EXPECT_EQ(clone->GetInputs(), std::vector<Value*>{x});
+    EXPECT_EQ(y->GetProducer()->GetInputs()[1], clone->GetOutputs()[0]);
+    EXPECT_EQ(s->GetConsumers(), std::vector<Node*>{m1->GetProducer()});
+    std::vector<Node*> order = graph->TopologicalSort();
+    ASSERT_EQ(order.size(), 6u);
+    EXPECT_EQ(order[4], clone);  // 紧挨在Add之前
+    EXPECT_TRUE(graph->Validate().IsOk());
+    
+    // Softmax的输入输出同时存活，无法放进一个张量的预算
+    Status status = PlanMemoryWithinBudget(graph.get(), 4096, MemoryPlannerOptions(), &plan);
+    EXPECT_EQ(status.Code(), StatusCode::ERROR_OUT_OF_MEMORY);
+}
+
+// 线程私有暂存区：对齐切出、作用域回收、溢出后扩大主块，且不经过内存池
+TEST_F(MemoryTest, ScratchArenaPerThread) {
+    std::thread worker([] {
+        ScratchArena& arena = ScratchArena::ForCurrentThread();
+        EXPECT_EQ(&arena, &ScratchArena::ForCurrentThread());
+        arena.Reserve(4096);
+        EXPECT_GE(arena.GetCapacity(), 4096u);
+        
+        const MemoryStats before = GetMemoryStats();
+        void* first = nullptr;
+        {
+            ScratchScope scope;
+            first = scope.GetArena().Allocate(10);
+            float* second = scope.GetArena().Allocate<float>(100);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % ScratchArena::kAlignment, 0u);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % ScratchArena::kAlignment, 0u);
+            EXPECT_EQ(reinterpret_cast<uint8_t*>(second), static_cast<uint8_t*>(first) + 64);
+            {
+                ScratchScope nested;
+                EXPECT_NE(nested.GetArena().Allocate(256), nullptr);
+            }
+            // 内层作用域结束后回到外层的位置
+            EXPECT_EQ(arena.GetUsedBytes(), 64u + 400u);
+        }
+        EXPECT_EQ(arena.GetUsedBytes(), 0u);
+        const MemoryStats after = GetMemoryStats();
+        EXPECT_EQ(after.allocation_count, before.allocation_count);
+        
+        // 放不下的请求走溢出块，回到空闲后主块扩大到峰值，同样的请求不再溢出
+        {
+            ScratchScope scope;
+            EXPECT_EQ(scope.GetArena().Allocate(4000), first);
+            uint8_t* big = static_cast<uint8_t*>(scope.GetArena().Allocate(8192, 256));
+            ASSERT_NE(big, nullptr);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 256, 0u);
+            std::memset(big, 1, 8192);
+            EXPECT_EQ(arena.GetOverflowCount(), 1u);
+        }
+        EXPECT_GE(arena.GetCapacity(), 4000u + 8192u);
+        {
+            ScratchScope scope;
+            scope.GetArena().Allocate(4000);
+            EXPECT_NE(scope.GetArena().Allocate(8192, 256), nullptr);
+            EXPECT_EQ(arena.GetOverflowCount(), 1u);
+        }
+        
+        // ExecutionContext按声明的字节数记录需求，AllocateScratch取自调用线程的暂存区
+        ExecutionContext ctx;
+        ctx.SetScratchBytes(1 << 16);
+        ScratchScope scope(ctx.GetScratchBytes());
+        EXPECT_GE(arena.GetCapacity(), size_t(1) << 16);
+        int32_t* values = ctx.AllocateScratch<int32_t>(16);
+        ASSERT_NE(values, nullptr);
+        EXPECT_EQ(arena.GetUsedBytes(), 64u);
+    });
+    worker.join();
+}
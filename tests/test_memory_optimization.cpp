@@ -4,6 +4,9 @@
 #include "inferunity/tensor.h"
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstring>
 
 using namespace inferunity;
 
@@ -154,3 +157,232 @@ TEST_F(MemoryOptimizationTest, ReusePerformance) {
     EXPECT_GT(iterations, 0);  // 基本验证
 }
 
+
+// 测试分级分配：同一级别的请求重用刚释放的块
+TEST_F(MemoryOptimizationTest, SizeClassReuse) {
+    void* ptr1 = AllocateMemory(1000, 16);
+    ASSERT_NE(ptr1, nullptr);
+    FreeMemory(ptr1);
+    
+    // 1000和900都落在1024级别
+    void* ptr2 = AllocateMemory(900, 16);
+    EXPECT_EQ(ptr1, ptr2);
+    
+    // 不同级别不会复用
+    void* ptr3 = AllocateMemory(4000, 16);
+    EXPECT_NE(ptr3, ptr2);
+    
+    FreeMemory(ptr2);
+    FreeMemory(ptr3);
+    
+    MemoryStats stats = GetMemoryStats();
+    EXPECT_GE(stats.free_count, 2u);
+    EXPECT_GE(stats.allocated_bytes, 1024u + 4096u);
+}
+
+// 测试对齐：不超过64字节的对齐由缓存块满足，更大的对齐走直接分配
+TEST_F(MemoryOptimizationTest, SizeClassAlignment) {
+    for (size_t alignment : {16u, 32u, 64u, 128u, 4096u}) {
+        void* ptr = AllocateMemory(100, alignment);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0u);
+        std::memset(ptr, 0xAB, 100);
+        FreeMemory(ptr);
+    }
+    
+    // 非本池指针与重复释放只记录警告
+    int64_t local = 0;
+    FreeMemory(&local);
+    void* ptr = AllocateMemory(64, 16);
+    FreeMemory(ptr);
+    FreeMemory(ptr);
+}
+
+// 测试跨线程释放：其他线程分配的块归还后可在本线程重用
+TEST_F(MemoryOptimizationTest, CrossThreadFree) {
+    std::vector<void*> ptrs(64, nullptr);
+    std::thread producer([&ptrs]() {
+        for (auto& p : ptrs) {
+            p = AllocateMemory(256, 16);
+        }
+    });
+    producer.join();
+    
+    MemoryStats stats_before = GetMemoryStats();
+    for (void* p : ptrs) {
+        ASSERT_NE(p, nullptr);
+        FreeMemory(p);
+    }
+    MemoryStats stats_after = GetMemoryStats();
+    EXPECT_EQ(stats_after.allocation_count, stats_before.allocation_count);
+    EXPECT_EQ(stats_after.free_count, stats_before.free_count + ptrs.size());
+    
+    ReleaseUnusedMemory();
+    MemoryStats stats_released = GetMemoryStats();
+    EXPECT_LE(stats_released.allocated_bytes + ptrs.size() * 256, stats_after.allocated_bytes);
+}
+
+// 测试空闲内存归还：闲置的大块先decommit、复用时恢复，超过TTL后整块释放，后台线程按间隔执行
+TEST_F(MemoryOptimizationTest, IdleMemoryTrimming) {
+    const size_t block_size = 1024 * 1024;  // 超过线程缓存上限，直接进出中心池
+    void* ptr = AllocateMemory(block_size, 16);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0x5a, block_size);
+    FreeMemory(ptr);
+    
+    // 只decommit：块留在池中，物理页归还
+    MemoryTrimOptions decommit_only;
+    decommit_only.idle_ttl_ms = 3600 * 1000;
+    decommit_only.decommit_after_ms = 0;
+    MemoryReturnStats before = GetMemoryReturnStats();
+    const size_t blocks_before = GetMemoryStats().allocation_count;
+    EXPECT_GT(TrimMemory(decommit_only), 0u);
+    MemoryReturnStats decommitted = GetMemoryReturnStats();
+    EXPECT_GT(decommitted.decommitted_blocks, before.decommitted_blocks);
+    EXPECT_GE(decommitted.decommitted_resident, block_size);
+    EXPECT_EQ(GetMemoryStats().allocation_count, blocks_before);
+    EXPECT_EQ(decommitted.trim_passes, before.trim_passes + 1);
+    
+    // 复用decommit的块：内容为零页，可正常读写
+    void* reused = AllocateMemory(block_size, 16);
+    ASSERT_EQ(reused, ptr);
+    EXPECT_EQ(GetMemoryReturnStats().decommitted_resident, decommitted.decommitted_resident - block_size);
+    std::memset(reused, 0x11, block_size);
+    EXPECT_EQ(static_cast<unsigned char*>(reused)[block_size - 1], 0x11);
+    FreeMemory(reused);
+    
+    // TTL为0：全部空闲块整块释放
+    MemoryTrimOptions release_all;
+    release_all.idle_ttl_ms = 0;
+    EXPECT_GE(TrimMemory(release_all), block_size);
+    MemoryReturnStats released = GetMemoryReturnStats();
+    EXPECT_GE(released.released_bytes, decommitted.released_bytes + block_size);
+    EXPECT_EQ(released.decommitted_resident, 0u);
+    EXPECT_LT(GetMemoryStats().allocation_count, blocks_before);
+    
+    // 后台线程
+    MemoryTrimOptions background;
+    background.idle_ttl_ms = 0;
+    background.interval_ms = 0;
+    EXPECT_FALSE(StartMemoryTrimmer(background).IsOk());
+    background.interval_ms = 5;
+    ASSERT_TRUE(StartMemoryTrimmer(background).IsOk());
+    EXPECT_TRUE(IsMemoryTrimmerRunning());
+    FreeMemory(AllocateMemory(block_size, 16));
+    const size_t passes = GetMemoryReturnStats().trim_passes;
+    for (int i = 0; i < 200 && GetMemoryReturnStats().trim_passes < passes + 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    StopMemoryTrimmer();
+    EXPECT_FALSE(IsMemoryTrimmerRunning());
+    EXPECT_GE(GetMemoryReturnStats().trim_passes, passes + 2);
+    EXPECT_GE(GetMemoryReturnStats().released_bytes, released.released_bytes + block_size);
+}
+
+namespace {
+
+// 主机内存模拟设备：记录底层分配次数，事件在complete置位后才完成
+struct FakeDeviceMemory {
+    size_t raw_allocations = 0;
+    size_t raw_frees = 0;
+    bool events_complete = false;
+    size_t fail_above = 0;  // 非0时拒绝超过该大小的底层分配
+};
+
+class FakeDeviceBackend : public DeviceMemoryBackend {
+public:
+    explicit FakeDeviceBackend(FakeDeviceMemory* memory) : memory_(memory) {}
+    
+    void* RawAllocate(size_t size) override {
+        if (memory_->fail_above > 0 && size > memory_->fail_above) {
+            return nullptr;
+        }
+        ++memory_->raw_allocations;
+        return std::aligned_alloc(256, size);
+    }
+    void RawFree(void* ptr) override {
+        ++memory_->raw_frees;
+        std::free(ptr);
+    }
+    void* RecordEvent(void* stream) override { return stream; }
+    bool QueryEvent(void* event) override { (void)event; return memory_->events_complete; }
+    void SynchronizeDevice() override { memory_->events_complete = true; }
+
+private:
+    FakeDeviceMemory* memory_;
+};
+
+} // anonymous namespace
+
+// 测试设备缓存分配器：段缓存复用、切分与合并、按流复用与事件等待
+TEST_F(MemoryOptimizationTest, CachingDeviceAllocator) {
+    FakeDeviceMemory memory;
+    auto allocator = std::make_shared<CachingDeviceAllocator>(std::make_unique<FakeDeviceBackend>(&memory));
+    
+    // 小请求从同一个2MB段中切分，释放后合并并复用，不再向设备申请
+    char* a = static_cast<char*>(allocator->Allocate(1000));
+    char* b = static_cast<char*>(allocator->Allocate(4096));
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(b, a + 1024);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 256, 0u);
+    EXPECT_EQ(allocator->GetAllocatedSize(a), 1000u);
+    EXPECT_EQ(memory.raw_allocations, 1u);
+    allocator->Free(a);
+    allocator->Free(b);
+    EXPECT_EQ(allocator->Allocate(2048), static_cast<void*>(a));
+    EXPECT_EQ(memory.raw_allocations, 1u);
+    CachingAllocatorStats stats = allocator->GetCachingStats();
+    EXPECT_EQ(stats.reserved_bytes, size_t(2) << 20);
+    EXPECT_GE(stats.merges, 2u);
+    EXPECT_EQ(stats.cache_hits, 2u);
+    allocator->Free(a);
+    
+    // 大请求使用20MB段，剩余部分切分出来供后续请求使用
+    char* large = static_cast<char*>(allocator->Allocate(5 << 20));
+    char* next = static_cast<char*>(allocator->Allocate(3 << 20));
+    EXPECT_EQ(next, large + (5 << 20));
+    EXPECT_EQ(memory.raw_allocations, 2u);
+    MemoryStats memory_stats;
+    ASSERT_TRUE(allocator->GetStats(&memory_stats));
+    EXPECT_EQ(memory_stats.allocated_bytes, size_t(8) << 20);
+    allocator->Free(large);
+    allocator->Free(next);
+    
+    // 块只在分配流上复用；被其他流使用过的块等事件完成后才回到缓存
+    int stream1 = 0;
+    int stream2 = 0;
+    void* s1 = allocator->AllocateOnStream(4096, &stream1);
+    EXPECT_EQ(memory.raw_allocations, 3u);
+    allocator->RecordStream(s1, &stream2);
+    allocator->Free(s1);
+    EXPECT_EQ(allocator->GetCachingStats().pending_frees, 1u);
+    void* s1_again = allocator->AllocateOnStream(4096, &stream1);
+    EXPECT_NE(s1_again, s1);
+    allocator->Free(s1_again);
+    memory.events_complete = true;
+    void* reused = allocator->AllocateOnStream(4096, &stream1);
+    EXPECT_EQ(allocator->GetCachingStats().pending_frees, 0u);
+    EXPECT_TRUE(reused == s1 || reused == s1_again);
+    allocator->Free(reused);
+    
+    // 设备内存不足时先归还缓存的空闲段再重试；EmptyCache归还全部
+    memory.fail_above = size_t(30) << 20;
+    EXPECT_EQ(allocator->Allocate(size_t(40) << 20), nullptr);
+    EXPECT_EQ(allocator->GetCachingStats().reserved_bytes, 0u);
+    void* again = allocator->Allocate(1000);
+    ASSERT_NE(again, nullptr);
+    allocator->Free(again);
+    allocator->EmptyCache();
+    EXPECT_EQ(allocator->GetCachingStats().reserved_bytes, 0u);
+    EXPECT_EQ(memory.raw_frees, memory.raw_allocations);
+    
+    // 注册为设备分配器后，该设备上的张量共享缓存，GetMemoryStats报告它的统计
+    SetMemoryAllocator(DeviceType::CUDA, allocator);
+    {
+        auto tensor = CreateTensor(Shape({256}), DataType::FLOAT32, DeviceType::CUDA);
+        EXPECT_EQ(GetMemoryStats(DeviceType::CUDA).allocated_bytes, 1024u);
+    }
+    EXPECT_EQ(GetMemoryStats(DeviceType::CUDA).allocated_bytes, 0u);
+    SetMemoryAllocator(DeviceType::CUDA, nullptr);
+}
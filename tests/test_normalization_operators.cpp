@@ -4,8 +4,11 @@
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
 #include "inferunity/graph.h"
+#include "inferunity/runtime.h"
+#include "operators/simd_utils.h"
 #include <gtest/gtest.h>
 #include <cmath>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -36,11 +39,11 @@ protected:
         if (a->GetShape().GetElementCount() != b->GetElementCount()) {
             return false;
         }
-        
+    
         const float* data_a = static_cast<const float*>(a->GetData());
         const float* data_b = static_cast<const float*>(b->GetData());
         size_t count = a->GetElementCount();
-        
+    
         for (size_t i = 0; i < count; ++i) {
             if (std::abs(data_a[i] - data_b[i]) > tolerance) {
                 return false;
@@ -231,3 +234,212 @@ TEST_F(NormalizationOperatorsTest, RMSNormShapeInference) {
     EXPECT_EQ(output_shapes[0].dims, input->GetShape().dims);
 }
 
+// 测试算子内并行：多线程结果与单线程逐位一致
+TEST_F(NormalizationOperatorsTest, IntraOpParallelMatchesSerial) {
+    ThreadPoolOptions pool_options;
+    pool_options.num_threads = 4;
+    ThreadPool::Configure(pool_options);
+    
+    const int64_t rows = 64;
+    const int64_t cols = 96;
+    std::vector<float> input_values(rows * cols);
+    for (size_t i = 0; i < input_values.size(); ++i) {
+        input_values[i] = std::sin(0.37f * static_cast<float>(i)) * 3.0f;
+    }
+    std::vector<float> scale_values(cols), bias_values(cols);
+    for (int64_t i = 0; i < cols; ++i) {
+        scale_values[i] = 0.5f + 0.01f * static_cast<float>(i);
+        bias_values[i] = -0.2f + 0.003f * static_cast<float>(i);
+    }
+    std::vector<float> channel_mean(cols, 0.1f), channel_var(cols, 2.0f);
+    
+    auto input = CreateTestTensor(Shape({rows, cols}), input_values);
+    auto image = CreateTestTensor(Shape({2, cols, 4, 8}), input_values);
+    auto scale = CreateTestTensor(Shape({cols}), scale_values);
+    auto bias = CreateTestTensor(Shape({cols}), bias_values);
+    auto mean = CreateTestTensor(Shape({cols}), channel_mean);
+    auto var = CreateTestTensor(Shape({cols}), channel_var);
+    
+    struct Case {
+        std::string op_type;
+        std::vector<Tensor*> inputs;
+    };
+    std::vector<Case> cases = {
+        {"LayerNormalization", {input.get(), scale.get(), bias.get()}},
+        {"RMSNorm", {input.get(), scale.get()}},
+        {"BatchNormalization", {image.get(), scale.get(), bias.get(), mean.get(), var.get()}},
+        {"Softmax", {input.get()}},
+        {"Gelu", {input.get()}},
+        {"Add", {input.get(), input.get()}},
+    };
+    
+    ExecutionContext serial_ctx;
+    ExecutionContext parallel_ctx;
+    IntraOpParallelism intra_op;
+    intra_op.num_threads = 4;
+    intra_op.min_work_per_thread = 256;
+    parallel_ctx.SetIntraOpParallelism(intra_op);
+    
+    for (const auto& c : cases) {
+        auto op = OperatorRegistry::Instance().Create(c.op_type);
+        ASSERT_NE(op, nullptr) << c.op_type;
+        const Shape& shape = c.inputs[0]->GetShape();
+        auto expected = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        auto actual = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        ASSERT_TRUE(op->Execute(c.inputs, {expected.get()}, &serial_ctx).IsOk()) << c.op_type;
+        ASSERT_TRUE(op->Execute(c.inputs, {actual.get()}, &parallel_ctx).IsOk()) << c.op_type;
+        EXPECT_TRUE(TensorNear(expected.get(), actual.get(), 0.0f)) << c.op_type;
+    }
+    
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试 AddLayerNorm/AddRMSNorm 与 Add + LayerNormalization/RMSNorm 一致，并覆盖各ISA的单遍统计
+TEST_F(NormalizationOperatorsTest, FusedAddNormalizationMatchesUnfused) {
+    // 均值远大于标准差时E[x^2] - E[x]^2会严重抵消，Welford仍应准确；列数不是向量宽度的整倍数
+    const int64_t rows = 5;
+    const int64_t cols = 77;
+    std::vector<float> a_values(rows * cols), b_values(rows * cols);
+    for (size_t i = 0; i < a_values.size(); ++i) {
+        a_values[i] = 1000.0f + std::sin(0.37f * static_cast<float>(i));
+        b_values[i] = std::cos(0.11f * static_cast<float>(i)) * 0.5f;
+    }
+    std::vector<float> scale_values(cols), bias_values(cols);
+    for (int64_t i = 0; i < cols; ++i) {
+        scale_values[i] = 0.5f + 0.01f * static_cast<float>(i);
+        bias_values[i] = -0.2f + 0.003f * static_cast<float>(i);
+    }
+    auto a = CreateTestTensor(Shape({rows, cols}), a_values);
+    auto b = CreateTestTensor(Shape({rows, cols}), b_values);
+    auto scale = CreateTestTensor(Shape({cols}), scale_values);
+    auto bias = CreateTestTensor(Shape({cols}), bias_values);
+    
+    for (bool rms : {false, true}) {
+        // 双精度参考
+        std::vector<float> sum_ref(a_values.size()), y_ref(a_values.size());
+        for (int64_t r = 0; r < rows; ++r) {
+            double mean = 0.0, var = 0.0;
+            for (int64_t c = 0; c < cols; ++c) {
+                sum_ref[r * cols + c] = a_values[r * cols + c] + b_values[r * cols + c];
+                mean += sum_ref[r * cols + c];
+            }
+            mean = rms ? 0.0 : mean / cols;
+            for (int64_t c = 0; c < cols; ++c) {
+                const double d = sum_ref[r * cols + c] - mean;
+                var += d * d;
+            }
+            const double inv_std = 1.0 / std::sqrt(var / cols + (rms ? 1e-6 : 1e-5));
+            for (int64_t c = 0; c < cols; ++c) {
+                const double v = (sum_ref[r * cols + c] - mean) * inv_std * scale_values[c];
+                y_ref[r * cols + c] = static_cast<float>(rms ? v : v + bias_values[c]);
+            }
+        }
+        const float tolerance = rms ? 1e-5f : 2e-3f;  // x约为1000，FP32加法本身的舍入约为6e-5
+    
+        for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+            if (!simd::SetSimdIsa(isa)) {
+                continue;
+            }
+            auto fused_op = OperatorRegistry::Instance().Create(rms ? "AddRMSNorm" : "AddLayerNorm");
+            auto norm_op = OperatorRegistry::Instance().Create(rms ? "RMSNorm" : "LayerNormalization");
+            ASSERT_NE(fused_op, nullptr);
+            ASSERT_NE(norm_op, nullptr);
+            std::vector<Tensor*> fused_inputs = {a.get(), b.get(), scale.get()};
+            if (!rms) {
+                fused_inputs.push_back(bias.get());
+            }
+            ASSERT_TRUE(fused_op->ValidateInputs(fused_inputs).IsOk());
+            std::vector<Shape> shapes;
+            ASSERT_TRUE(fused_op->InferOutputShape(fused_inputs, shapes).IsOk());
+            ASSERT_EQ(shapes.size(), 2u);
+    
+            auto y = inferunity::CreateTensor(a->GetShape(), DataType::FLOAT32, DeviceType::CPU);
+            auto sum = inferunity::CreateTensor(a->GetShape(), DataType::FLOAT32, DeviceType::CPU);
+            auto y_only = inferunity::CreateTensor(a->GetShape(), DataType::FLOAT32, DeviceType::CPU);
+            ASSERT_TRUE(fused_op->Execute(fused_inputs, {y.get(), sum.get()}, nullptr).IsOk());
+            // 没有第二个输出时a + b暂存在y中
+            ASSERT_TRUE(fused_op->Execute(fused_inputs, {y_only.get()}, nullptr).IsOk());
+    
+            auto sum_in = CreateTestTensor(a->GetShape(), sum_ref);
+            auto y_unfused = inferunity::CreateTensor(a->GetShape(), DataType::FLOAT32, DeviceType::CPU);
+            std::vector<Tensor*> norm_inputs = {sum_in.get(), scale.get()};
+            if (!rms) {
+                norm_inputs.push_back(bias.get());
+            }
+            ASSERT_TRUE(norm_op->Execute(norm_inputs, {y_unfused.get()}, nullptr).IsOk());
+    
+            const float* y_data = static_cast<const float*>(y->GetData());
+            const float* sum_data = static_cast<const float*>(sum->GetData());
+            for (size_t i = 0; i < y_ref.size(); ++i) {
+                ASSERT_EQ(sum_data[i], sum_ref[i]) << isa << " at " << i;
+                ASSERT_NEAR(y_data[i], y_ref[i], tolerance) << isa << " rms=" << rms << " at " << i;
+            }
+            EXPECT_TRUE(TensorNear(y.get(), y_only.get(), 0.0f)) << isa;
+            EXPECT_TRUE(TensorNear(y.get(), y_unfused.get(), 0.0f)) << isa;
+        }
+    }
+    simd::SetSimdIsa("auto");
+    
+    auto mismatched = CreateTestTensor(Shape({1, cols}), scale_values);
+    auto op = OperatorRegistry::Instance().Create("AddLayerNorm");
+    EXPECT_FALSE(op->ValidateInputs({a.get(), mismatched.get(), scale.get()}).IsOk());
+}
+
+// 编译节点时按归一化长度选定的专用核（含融合残差相加）与通用路径结果一致
+TEST_F(NormalizationOperatorsTest, SpecializedRowsMatchGeneric) {
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (const char* name : {"LayerNormalization", "RMSNorm", "AddLayerNorm", "AddRMSNorm"}) {
+            const bool fused = name[0] == 'A';
+            const bool rms = std::string(name).find("RMS") != std::string::npos;
+            for (int64_t cols : {64, 768, 1024}) {
+                const Shape shape({4, cols});
+                std::vector<float> a(4 * cols), b(4 * cols), scale(cols), bias(cols);
+                for (size_t i = 0; i < a.size(); ++i) {
+                    a[i] = 3.0f * std::sin(0.11f * static_cast<float>(i)) + 0.5f;
+                    b[i] = std::cos(0.07f * static_cast<float>(i));
+                }
+                for (int64_t i = 0; i < cols; ++i) {
+                    scale[i] = 1.0f + 0.01f * static_cast<float>(i % 13);
+                    bias[i] = 0.1f * static_cast<float>(i % 5) - 0.2f;
+                }
+                auto ta = CreateTestTensor(shape, a);
+                auto tb = CreateTestTensor(shape, b);
+                auto tscale = CreateTestTensor(Shape({cols}), scale);
+                auto tbias = CreateTestTensor(Shape({cols}), bias);
+                std::vector<Tensor*> inputs = {ta.get()};
+                if (fused) {
+                    inputs.push_back(tb.get());
+                }
+                inputs.push_back(tscale.get());
+                if (!rms) {
+                    inputs.push_back(tbias.get());
+                }
+    
+                auto generic = OperatorRegistry::Instance().Create(name);
+                auto specialized = OperatorRegistry::Instance().Create(name);
+                ASSERT_NE(specialized, nullptr);
+                specialized->SpecializeForShapes({shape});
+                auto want = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+                auto want_sum = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+                auto got = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+                auto got_sum = inferunity::CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+                std::vector<Tensor*> want_outputs = {want.get()};
+                std::vector<Tensor*> got_outputs = {got.get()};
+                if (fused) {
+                    want_outputs.push_back(want_sum.get());
+                    got_outputs.push_back(got_sum.get());
+                }
+                ASSERT_TRUE(generic->Execute(inputs, want_outputs, nullptr).IsOk());
+                ASSERT_TRUE(specialized->Execute(inputs, got_outputs, nullptr).IsOk());
+                EXPECT_TRUE(TensorNear(got.get(), want.get(), 1e-4f)) << isa << " " << name << " " << cols;
+                if (fused) {
+                    EXPECT_TRUE(TensorNear(got_sum.get(), want_sum.get(), 0.0f)) << isa << " " << name;
+                }
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
@@ -4,6 +4,15 @@
 #include <gtest/gtest.h>
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
+#include "inferunity/engine.h"
+#include "frontend/onnx_exporter.h"
+#include "frontend/onnx_parser.h"
+#ifdef INFERUNITY_USE_ONNX_PROTOBUF
+#include "onnx.pb.h"
+#endif
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -61,3 +70,485 @@ TEST_F(ONNXParserTest, GraphValidation) {
     EXPECT_TRUE(status.IsOk());
 }
 
+
+// 测试ONNX导出：导出的模型能被解析器还原出节点、属性、initializer与输入输出
+TEST_F(ONNXParserTest, ExportRoundTrip) {
+    Graph graph;
+    Value* x = graph.AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({1, 2, 4, 4}), DataType::FLOAT32, nullptr));
+    graph.AddInput(x);
+    Value* w = graph.AddValue();
+    w->SetName("w");
+    auto weight = CreateTensor(Shape({3, 2, 1, 1}), DataType::FLOAT32);
+    float* weight_data = static_cast<float*>(weight->GetData());
+    for (size_t i = 0; i < weight->GetElementCount(); ++i) {
+        weight_data[i] = static_cast<float>(i) * 0.5f;
+    }
+    w->SetTensor(weight);
+    Value* conv_out = graph.AddValue();  // 无名称
+    Node* conv = graph.AddNode("Conv", "conv");
+    conv->SetAttribute("kernel_shape", "1,1");
+    conv->SetAttribute("strides", "1");
+    conv->SetAttribute("group", "1");
+    conv->AddInput(x);
+    conv->AddInput(w);
+    conv->AddOutput(conv_out);
+    Value* y = graph.AddValue();
+    y->SetName("y");
+    Node* leaky = graph.AddNode("LeakyRelu", "leaky");
+    leaky->SetAttribute("alpha", "0.100000");
+    leaky->AddInput(conv_out);
+    leaky->AddOutput(y);
+    graph.AddOutput(y);
+    
+    std::string bytes;
+    Status status = frontend::ExportToONNX(graph, &bytes);
+    if (status.Code() == StatusCode::ERROR_NOT_IMPLEMENTED) {
+        GTEST_SKIP() << "ONNX protobuf not available";
+    }
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    
+    frontend::ONNXParser parser;
+    ASSERT_TRUE(parser.LoadFromMemory(bytes.data(), bytes.size()).IsOk());
+    std::unique_ptr<Graph> parsed;
+    ASSERT_TRUE(parser.ConvertToGraph(parsed).IsOk());
+    ASSERT_EQ(parsed->GetInputs().size(), 1u);
+    ASSERT_EQ(parsed->GetOutputs().size(), 1u);
+    EXPECT_EQ(parser.GetInputNames(), std::vector<std::string>({"x"}));
+    EXPECT_EQ(parser.GetOutputNames(), std::vector<std::string>({"y"}));
+    ASSERT_NE(parsed->GetInputs()[0]->GetTensor(), nullptr);
+    EXPECT_EQ(parsed->GetInputs()[0]->GetShape().dims, std::vector<int64_t>({1, 2, 4, 4}));
+    
+    Node* parsed_conv = parsed->GetNodeByName("conv");
+    Node* parsed_leaky = parsed->GetNodeByName("leaky");
+    ASSERT_NE(parsed_conv, nullptr);
+    ASSERT_NE(parsed_leaky, nullptr);
+    EXPECT_EQ(parsed_conv->GetAttribute("kernel_shape"), "1,1");
+    EXPECT_EQ(parsed_conv->GetAttribute("strides"), "1");
+    EXPECT_EQ(parsed_conv->GetAttribute("group"), "1");
+    EXPECT_FLOAT_EQ(std::stof(parsed_leaky->GetAttribute("alpha")), 0.1f);
+    ASSERT_EQ(parsed_leaky->GetInputs().size(), 1u);
+    EXPECT_EQ(parsed_leaky->GetInputs()[0], parsed_conv->GetOutputs()[0]);
+    
+    // 权重作为initializer导出
+    ASSERT_EQ(parsed_conv->GetInputs().size(), 2u);
+    const Tensor* parsed_weight = parsed_conv->GetInputs()[1]->GetTensor().get();
+    ASSERT_NE(parsed_weight, nullptr);
+    EXPECT_EQ(parsed_weight->GetShape().dims, std::vector<int64_t>({3, 2, 1, 1}));
+    EXPECT_EQ(std::memcmp(parsed_weight->GetData(), weight->GetData(), weight->GetSizeInBytes()), 0);
+}
+
+// 测试从文件加载：initializer是文件映射的视图，解析器销毁后仍然有效，改写只影响本进程的副本
+TEST_F(ONNXParserTest, MappedInitializers) {
+    Graph graph;
+    Value* x = graph.AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({2, 8}), DataType::FLOAT32, nullptr));
+    graph.AddInput(x);
+    Value* w = graph.AddValue();
+    w->SetName("w");
+    auto weight = CreateTensor(Shape({8, 4}), DataType::FLOAT32);
+    float* weight_data = static_cast<float*>(weight->GetData());
+    for (size_t i = 0; i < weight->GetElementCount(); ++i) {
+        weight_data[i] = static_cast<float>(i) - 10.0f;
+    }
+    w->SetTensor(weight);
+    Value* y = graph.AddValue();
+    y->SetName("y");
+    Node* matmul = graph.AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    matmul->AddOutput(y);
+    graph.AddOutput(y);
+    Value* table = graph.AddValue();
+    table->SetName("lut");
+    auto lut = CreateTensor(Shape({16}), DataType::UINT8);
+    for (size_t i = 0; i < 16; ++i) {
+        static_cast<uint8_t*>(lut->GetData())[i] = static_cast<uint8_t>(i * 3);
+    }
+    table->SetTensor(lut);
+    Value* z = graph.AddValue();
+    z->SetName("z");
+    Node* lookup = graph.AddNode("Identity", "lookup");
+    lookup->AddInput(table);
+    lookup->AddOutput(z);
+    graph.AddOutput(z);
+    
+    std::string bytes;
+    Status status = frontend::ExportToONNX(graph, &bytes);
+    if (status.Code() == StatusCode::ERROR_NOT_IMPLEMENTED) {
+        GTEST_SKIP() << "ONNX protobuf not available";
+    }
+    ASSERT_TRUE(status.IsOk());
+    const std::string path = "mapped_initializers_test.onnx";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    
+    std::unique_ptr<Graph> parsed;
+    {
+        frontend::ONNXParser parser;
+        ASSERT_TRUE(parser.LoadFromFile(path).IsOk());
+        ASSERT_TRUE(parser.ConvertToGraph(parsed).IsOk());
+    }
+    Node* parsed_matmul = parsed->GetNodeByName("matmul");
+    ASSERT_NE(parsed_matmul, nullptr);
+    ASSERT_EQ(parsed_matmul->GetInputs().size(), 2u);
+    std::shared_ptr<Tensor> parsed_weight = parsed_matmul->GetInputs()[1]->GetTensor();
+    ASSERT_NE(parsed_weight, nullptr);
+    EXPECT_EQ(parsed_weight->GetShape().dims, std::vector<int64_t>({8, 4}));
+    EXPECT_EQ(std::memcmp(parsed_weight->GetData(), weight->GetData(), weight->GetSizeInBytes()), 0);
+    // raw_data在文件中按元素对齐时为视图，否则拷贝；单字节类型总是视图
+    const Tensor* parsed_lut = parsed->GetNodeByName("lookup")->GetInputs()[0]->GetTensor().get();
+    ASSERT_NE(parsed_lut, nullptr);
+    EXPECT_FALSE(parsed_lut->IsOwned());
+    EXPECT_EQ(std::memcmp(parsed_lut->GetData(), lut->GetData(), lut->GetSizeInBytes()), 0);
+    static_cast<float*>(parsed_weight->GetData())[0] = 42.0f;
+    
+    // 文件内容不受改写影响
+    frontend::ONNXParser reparser;
+    ASSERT_TRUE(reparser.LoadFromFile(path).IsOk());
+    std::unique_ptr<Graph> reparsed;
+    ASSERT_TRUE(reparser.ConvertToGraph(reparsed).IsOk());
+    const Tensor* reparsed_weight = reparsed->GetNodeByName("matmul")->GetInputs()[1]->GetTensor().get();
+    EXPECT_FLOAT_EQ(static_cast<const float*>(reparsed_weight->GetData())[0], -10.0f);
+    
+    EXPECT_FALSE(frontend::ONNXParser().LoadFromFile("does_not_exist.onnx").IsOk());
+    std::remove(path.c_str());
+}
+
+#ifdef INFERUNITY_USE_ONNX_PROTOBUF
+// 测试外部数据：initializer为外部数据文件映射的视图，不拷贝
+TEST_F(ONNXParserTest, MappedExternalData) {
+    Graph graph;
+    Value* x = graph.AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({2, 4}), DataType::FLOAT32, nullptr));
+    graph.AddInput(x);
+    Value* w = graph.AddValue();
+    w->SetName("w");
+    auto weight = CreateTensor(Shape({4, 4}), DataType::FLOAT32);
+    float* weight_data = static_cast<float*>(weight->GetData());
+    for (size_t i = 0; i < weight->GetElementCount(); ++i) {
+        weight_data[i] = static_cast<float>(i) * 0.25f;
+    }
+    w->SetTensor(weight);
+    Value* y = graph.AddValue();
+    y->SetName("y");
+    Node* matmul = graph.AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    matmul->AddOutput(y);
+    graph.AddOutput(y);
+    
+    std::string bytes;
+    ASSERT_TRUE(frontend::ExportToONNX(graph, &bytes).IsOk());
+    onnx::ModelProto model;
+    ASSERT_TRUE(model.ParseFromString(bytes));
+    ASSERT_EQ(model.graph().initializer_size(), 1);
+    
+    // 权重放在外部文件的偏移64处
+    const std::string data_path = "mapped_external_test.bin";
+    const std::string model_path = "mapped_external_test.onnx";
+    {
+        std::string padding(64, '\0');
+        std::ofstream data(data_path, std::ios::binary);
+        data.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        data.write(static_cast<const char*>(weight->GetData()),
+                   static_cast<std::streamsize>(weight->GetSizeInBytes()));
+    }
+    onnx::TensorProto* init = model.mutable_graph()->mutable_initializer(0);
+    init->clear_raw_data();
+    init->set_data_location(onnx::TensorProto::EXTERNAL);
+    auto* location = init->add_external_data();
+    location->set_key("location");
+    location->set_value(data_path);
+    auto* offset = init->add_external_data();
+    offset->set_key("offset");
+    offset->set_value("64");
+    {
+        std::ofstream file(model_path, std::ios::binary);
+        ASSERT_TRUE(model.SerializeToOstream(&file));
+    }
+    
+    std::unique_ptr<Graph> parsed;
+    {
+        frontend::ONNXParser parser;
+        ASSERT_TRUE(parser.LoadFromFile(model_path).IsOk());
+        ASSERT_TRUE(parser.ConvertToGraph(parsed).IsOk());
+    }
+    const Tensor* parsed_weight = parsed->GetNodeByName("matmul")->GetInputs()[1]->GetTensor().get();
+    ASSERT_NE(parsed_weight, nullptr);
+    EXPECT_FALSE(parsed_weight->IsOwned());
+    EXPECT_EQ(std::memcmp(parsed_weight->GetData(), weight->GetData(), weight->GetSizeInBytes()), 0);
+    
+    // 映射的权重直接参与推理，加载时按执行顺序预取
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.prefetch_weights = true;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(parsed)).IsOk());
+    auto input = CreateTensor(Shape({2, 4}), DataType::FLOAT32);
+    float* input_data = static_cast<float*>(input->GetData());
+    for (size_t i = 0; i < input->GetElementCount(); ++i) {
+        input_data[i] = 1.0f;
+    }
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* result = static_cast<const float*>(outputs[0]->GetData());
+    for (int j = 0; j < 4; ++j) {
+        // 每列之和：0.25 * (j + (j + 4) + (j + 8) + (j + 12))
+        EXPECT_FLOAT_EQ(result[j], 0.25f * (4 * j + 24));
+    }
+    
+    // 越界的外部数据报错
+    offset->set_value("4096");
+    {
+        std::ofstream file(model_path, std::ios::binary);
+        ASSERT_TRUE(model.SerializeToOstream(&file));
+    }
+    EXPECT_EQ(frontend::ONNXParser().LoadFromFile(model_path).Code(), StatusCode::ERROR_INVALID_MODEL);
+    std::remove(model_path.c_str());
+    std::remove(data_path.c_str());
+}
+// 大图并行构图：节点、名称、属性与连接和串行构造一致
+TEST_F(ONNXParserTest, ParallelConversion) {
+    const int num_nodes = 3000;
+    const int num_weights = 64;
+    onnx::ModelProto model;
+    model.set_ir_version(7);
+    model.add_opset_import()->set_version(13);
+    onnx::GraphProto* onnx_graph = model.mutable_graph();
+    auto* input = onnx_graph->add_input();
+    input->set_name("x");
+    input->mutable_type()->mutable_tensor_type()->set_elem_type(onnx::TensorProto::FLOAT);
+    input->mutable_type()->mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(4);
+    for (int w = 0; w < num_weights; ++w) {
+        onnx::TensorProto* init = onnx_graph->add_initializer();
+        init->set_name("w" + std::to_string(w));
+        init->set_data_type(onnx::TensorProto::FLOAT);
+        init->add_dims(4);
+        std::vector<float> data(4, static_cast<float>(w));
+        init->set_raw_data(data.data(), data.size() * sizeof(float));
+    }
+    std::string previous = "x";
+    for (int i = 0; i < num_nodes; ++i) {
+        onnx::NodeProto* node = onnx_graph->add_node();
+        node->set_name("add" + std::to_string(i));
+        node->set_op_type("Add");
+        node->add_input(previous);
+        node->add_input("w" + std::to_string(i % num_weights));
+        previous = "t" + std::to_string(i);
+        node->add_output(previous);
+        auto* attr = node->add_attribute();
+        attr->set_name("axes");
+        attr->set_type(onnx::AttributeProto::INTS);
+        attr->add_ints(i);
+        attr->add_ints(-1);
+    }
+    onnx_graph->add_output()->set_name(previous);
+    std::string bytes;
+    ASSERT_TRUE(model.SerializeToString(&bytes));
+    
+    frontend::ONNXParser parser;
+    ASSERT_TRUE(parser.LoadFromMemory(bytes.data(), bytes.size()).IsOk());
+    std::unique_ptr<Graph> graph;
+    ASSERT_TRUE(parser.ConvertToGraph(graph).IsOk());
+    ASSERT_EQ(graph->GetNodes().size(), static_cast<size_t>(num_nodes));
+    EXPECT_EQ(graph->GetValues().size(), static_cast<size_t>(1 + num_weights + num_nodes));
+    ASSERT_EQ(graph->GetOutputs().size(), 1u);
+    EXPECT_EQ(graph->GetOutputs()[0]->GetName(), previous);
+    EXPECT_EQ(parser.GetInputNames(), std::vector<std::string>({"x"}));
+    
+    const Value* chain = graph->GetInputs()[0];
+    EXPECT_EQ(chain->GetName(), "x");
+    for (int i = 0; i < num_nodes; ++i) {
+        const Node* node = graph->GetNodes()[i].get();
+        ASSERT_EQ(node->GetName(), "add" + std::to_string(i));
+        ASSERT_EQ(node->GetAttribute("axes"), std::to_string(i) + ",-1");
+        ASSERT_EQ(node->GetInputs().size(), 2u);
+        ASSERT_EQ(node->GetInputs()[0], chain);
+        const Value* weight = node->GetInputs()[1];
+        ASSERT_EQ(weight->GetName(), "w" + std::to_string(i % num_weights));
+        ASSERT_NE(weight->GetTensor(), nullptr);
+        ASSERT_FLOAT_EQ(static_cast<const float*>(weight->GetTensor()->GetData())[3],
+                        static_cast<float>(i % num_weights));
+        chain = node->GetOutputs()[0];
+    }
+}
+
+// 控制流子图：If/Loop/Scan的GRAPH属性转换为子图，外层引用成为末尾的隐式输入，执行时运行子图的执行计划
+TEST_F(ONNXParserTest, ControlFlowSubgraphs) {
+    auto add_info = [](google::protobuf::RepeatedPtrField<onnx::ValueInfoProto>* infos, const std::string& name,
+                       int elem_type, const std::vector<int64_t>& dims) {
+        onnx::ValueInfoProto* info = infos->Add();
+        info->set_name(name);
+        auto* tensor_type = info->mutable_type()->mutable_tensor_type();
+        tensor_type->set_elem_type(elem_type);
+        auto* shape = tensor_type->mutable_shape();
+        for (int64_t dim : dims) {
+            shape->add_dim()->set_dim_value(dim);
+        }
+    };
+    auto add_node = [](onnx::GraphProto* graph, const std::string& op_type, const std::vector<std::string>& inputs,
+                       const std::vector<std::string>& outputs) {
+        onnx::NodeProto* node = graph->add_node();
+        node->set_op_type(op_type);
+        node->set_name(outputs[0]);
+        for (const auto& input : inputs) {
+            node->add_input(input);
+        }
+        for (const auto& output : outputs) {
+            node->add_output(output);
+        }
+        return node;
+    };
+    auto add_initializer = [](onnx::GraphProto* graph, const std::string& name, const std::vector<int64_t>& dims,
+                              const std::vector<float>& data) {
+        onnx::TensorProto* init = graph->add_initializer();
+        init->set_name(name);
+        init->set_data_type(onnx::TensorProto::FLOAT);
+        for (int64_t dim : dims) {
+            init->add_dims(dim);
+        }
+        init->set_raw_data(data.data(), data.size() * sizeof(float));
+    };
+    auto add_graph_attribute = [](onnx::NodeProto* node, const std::string& name) {
+        onnx::AttributeProto* attr = node->add_attribute();
+        attr->set_name(name);
+        attr->set_type(onnx::AttributeProto::GRAPH);
+        return attr->mutable_g();
+    };
+    
+    onnx::ModelProto model;
+    model.set_ir_version(7);
+    model.add_opset_import()->set_version(13);
+    onnx::GraphProto* graph = model.mutable_graph();
+    add_info(graph->mutable_input(), "x", onnx::TensorProto::FLOAT, {4});
+    add_info(graph->mutable_input(), "flag", onnx::TensorProto::BOOL, {});
+    add_info(graph->mutable_input(), "trips", onnx::TensorProto::INT64, {});
+    add_initializer(graph, "seq", {3, 4}, {1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3});
+    
+    // If：then分支 x + x，else分支 x + 10（分支自己的初始值）
+    onnx::NodeProto* if_node = add_node(graph, "If", {"flag"}, {"branch"});
+    onnx::GraphProto* then_branch = add_graph_attribute(if_node, "then_branch");
+    add_node(then_branch, "Add", {"x", "x"}, {"then_out"});
+    add_info(then_branch->mutable_output(), "then_out", onnx::TensorProto::FLOAT, {4});
+    onnx::GraphProto* else_branch = add_graph_attribute(if_node, "else_branch");
+    add_initializer(else_branch, "ten", {4}, {10, 10, 10, 10});
+    add_node(else_branch, "Add", {"x", "ten"}, {"else_out"});
+    add_info(else_branch->mutable_output(), "else_out", onnx::TensorProto::FLOAT, {4});
+    
+    // Loop（只给出M）：v <- v + x，每次迭代输出v * v
+    onnx::NodeProto* loop_node = add_node(graph, "Loop", {"trips", "", "x"}, {"acc", "squares"});
+    onnx::GraphProto* body = add_graph_attribute(loop_node, "body");
+    add_info(body->mutable_input(), "i", onnx::TensorProto::INT64, {});
+    add_info(body->mutable_input(), "c", onnx::TensorProto::BOOL, {});
+    add_info(body->mutable_input(), "v", onnx::TensorProto::FLOAT, {4});
+    add_node(body, "Add", {"v", "x"}, {"v_next"});
+    add_node(body, "Mul", {"v", "v"}, {"square"});
+    add_info(body->mutable_output(), "c", onnx::TensorProto::BOOL, {});
+    add_info(body->mutable_output(), "v_next", onnx::TensorProto::FLOAT, {4});
+    add_info(body->mutable_output(), "square", onnx::TensorProto::FLOAT, {4});
+    
+    // Scan：s <- s + seq[t]，每步输出2 * s
+    onnx::NodeProto* scan_node = add_node(graph, "Scan", {"x", "seq"}, {"state", "doubled"});
+    onnx::AttributeProto* num_scan_inputs = scan_node->add_attribute();
+    num_scan_inputs->set_name("num_scan_inputs");
+    num_scan_inputs->set_type(onnx::AttributeProto::INT);
+    num_scan_inputs->set_i(1);
+    onnx::GraphProto* scan_body = add_graph_attribute(scan_node, "body");
+    add_info(scan_body->mutable_input(), "s", onnx::TensorProto::FLOAT, {4});
+    add_info(scan_body->mutable_input(), "row", onnx::TensorProto::FLOAT, {4});
+    add_node(scan_body, "Add", {"s", "row"}, {"s_next"});
+    add_node(scan_body, "Add", {"s_next", "s_next"}, {"twice"});
+    add_info(scan_body->mutable_output(), "s_next", onnx::TensorProto::FLOAT, {4});
+    add_info(scan_body->mutable_output(), "twice", onnx::TensorProto::FLOAT, {4});
+    
+    for (const std::string name : {"branch", "acc", "squares", "state", "doubled"}) {
+        graph->add_output()->set_name(name);
+    }
+    std::string bytes;
+    ASSERT_TRUE(model.SerializeToString(&bytes));
+    
+    std::unique_ptr<Graph> parsed;
+    {
+        frontend::ONNXParser parser;
+        ASSERT_TRUE(parser.LoadFromMemory(bytes.data(), bytes.size()).IsOk());
+        ASSERT_TRUE(parser.ConvertToGraph(parsed).IsOk());
+    }
+    const Node* parsed_if = parsed->GetNodeByName("branch");
+    ASSERT_NE(parsed_if, nullptr);
+    const AttributeValue* then_attr = parsed_if->FindAttribute("then_branch");
+    ASSERT_NE(then_attr, nullptr);
+    ASSERT_EQ(then_attr->GetType(), AttributeValue::Type::GRAPH);
+    // 两个分支都接收外层的x作为唯一的图输入，节点的输入为(flag, x)
+    EXPECT_EQ(then_attr->GetGraph()->GetInputs().size(), 1u);
+    EXPECT_EQ(parsed_if->FindAttribute("else_branch")->GetGraph()->GetInputs().size(), 1u);
+    ASSERT_EQ(parsed_if->GetInputs().size(), 2u);
+    EXPECT_EQ(parsed_if->GetInputs()[1]->GetName(), "x");
+    EXPECT_EQ(parsed_if->GetAttribute("num_implicit_inputs"), "1");
+    const Node* parsed_loop = parsed->GetNodeByName("acc");
+    ASSERT_EQ(parsed_loop->GetInputs().size(), 3u);
+    EXPECT_EQ(parsed_loop->GetAttribute("input_slots"), "0,2,3");
+    EXPECT_EQ(parsed_loop->FindAttribute("body")->GetGraph()->GetInputs().size(), 4u);
+    // 含子图的模型不能导出为ONNX
+    std::string exported;
+    EXPECT_EQ(frontend::ExportToONNX(*parsed, &exported).Code(), StatusCode::ERROR_NOT_IMPLEMENTED);
+    
+    auto session = InferenceSession::Create();
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(parsed)).IsOk());
+    auto x = CreateTensor(Shape({4}), DataType::FLOAT32);
+    auto flag = CreateTensor(Shape(std::vector<int64_t>()), DataType::BOOL);
+    auto trips = CreateTensor(Shape(std::vector<int64_t>()), DataType::INT64);
+    float* x_data = static_cast<float*>(x->GetData());
+    for (int i = 0; i < 4; ++i) {
+        x_data[i] = static_cast<float>(i + 1);
+    }
+    *static_cast<uint8_t*>(flag->GetData()) = 1;
+    *static_cast<int64_t*>(trips->GetData()) = 3;
+    
+    for (int run = 0; run < 2; ++run) {
+        const bool then = run == 0;
+        *static_cast<uint8_t*>(flag->GetData()) = then ? 1 : 0;
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        Status status = session->Run({x.get(), flag.get(), trips.get()}, outputs);
+        ASSERT_TRUE(status.IsOk()) << status.Message();
+        ASSERT_EQ(outputs.size(), 5u);
+        ASSERT_EQ(outputs[0]->GetShape().dims, std::vector<int64_t>({4}));
+        ASSERT_EQ(outputs[2]->GetShape().dims, std::vector<int64_t>({3, 4}));
+        ASSERT_EQ(outputs[4]->GetShape().dims, std::vector<int64_t>({3, 4}));
+        const float* branch = static_cast<const float*>(outputs[0]->GetData());
+        const float* acc = static_cast<const float*>(outputs[1]->GetData());
+        const float* squares = static_cast<const float*>(outputs[2]->GetData());
+        const float* state = static_cast<const float*>(outputs[3]->GetData());
+        const float* doubled = static_cast<const float*>(outputs[4]->GetData());
+        for (int i = 0; i < 4; ++i) {
+            const float v = x_data[i];
+            EXPECT_FLOAT_EQ(branch[i], then ? 2 * v : v + 10);
+            EXPECT_FLOAT_EQ(acc[i], 4 * v);
+            EXPECT_FLOAT_EQ(state[i], v + 6);
+            for (int t = 0; t < 3; ++t) {
+                EXPECT_FLOAT_EQ(squares[t * 4 + i], (t + 1) * (t + 1) * v * v);
+            }
+            EXPECT_FLOAT_EQ(doubled[i], 2 * (v + 1));
+            EXPECT_FLOAT_EQ(doubled[4 + i], 2 * (v + 3));
+            EXPECT_FLOAT_EQ(doubled[8 + i], 2 * (v + 6));
+        }
+    }
+    
+    // M为0时不执行循环体，循环变量为初值，scan输出沿第0维为空
+    *static_cast<int64_t*>(trips->GetData()) = 0;
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({x.get(), flag.get(), trips.get()}, outputs).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(outputs[1]->GetData())[2], 3.0f);
+    EXPECT_EQ(outputs[2]->GetShape().dims, std::vector<int64_t>({0}));
+}
+
+
+#endif
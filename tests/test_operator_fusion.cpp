@@ -1,11 +1,16 @@
 // 算子融合Pass单元测试
-// 测试Conv+BN+ReLU和MatMul+Add融合
+// 测试Conv+BN+ReLU、MatMul+Add等融合模式及逐元素链合并
 
 #include <gtest/gtest.h>
+#include "inferunity/engine.h"
 #include "inferunity/graph.h"
+#include "inferunity/memory_planner.h"
 #include "inferunity/optimizer.h"
 #include "inferunity/tensor.h"
 #include "inferunity/operator.h"
+#include <cmath>
+#include <cstdint>
+#include <map>
 #include <vector>
 
 using namespace inferunity;
@@ -20,6 +25,42 @@ protected:
         graph_.reset();
     }
     
+    // 常量初始化器
+    Value* Constant(const Shape& shape, float fill) {
+        Value* value = graph_->AddValue();
+        auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+        tensor->FillValue(fill);
+        value->SetTensor(tensor);
+        return value;
+    }
+    
+    // 带静态形状的图输入
+    Value* Input(const Shape& shape) {
+        Value* value = graph_->AddValue();
+        value->SetTensor(CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU));
+        graph_->AddInput(value);
+        return value;
+    }
+    
+    // 添加单输出节点；shape非空时模拟形状推断的结果
+    Value* Apply(const std::string& op_type, const std::vector<Value*>& inputs,
+                 const Shape& shape = Shape(),
+                 const std::vector<std::pair<std::string, std::string>>& attrs = {}) {
+        Node* node = graph_->AddNode(op_type, op_type + std::to_string(graph_->GetNodes().size()));
+        for (const auto& attr : attrs) {
+            node->SetAttribute(attr.first, attr.second);
+        }
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph_->AddValue();
+        if (!shape.dims.empty()) {
+            output->SetTensor(CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU));
+        }
+        node->AddOutput(output);
+        return output;
+    }
+    
     std::unique_ptr<Graph> graph_;
 };
 
@@ -209,3 +250,1083 @@ TEST_F(OperatorFusionTest, MultipleFusions) {
     EXPECT_EQ(graph_->GetNodes().size(), 1);
 }
 
+
+// 测试Transpose折叠进MatMul：交换最后两维的Transpose变为transB属性
+TEST_F(OperatorFusionTest, FoldTransposeIntoMatMul) {
+    Value* q = graph_->AddValue();
+    Value* k = graph_->AddValue();
+    Value* k_t = graph_->AddValue();
+    Value* scores = graph_->AddValue();
+    
+    Node* transpose = graph_->AddNode("Transpose", "transpose_k");
+    transpose->SetAttribute("perm", "0,1,3,2");
+    transpose->AddInput(k);
+    transpose->AddOutput(k_t);
+    
+    Node* matmul = graph_->AddNode("MatMul", "qk");
+    matmul->AddInput(q);
+    matmul->AddInput(k_t);
+    matmul->AddOutput(scores);
+    graph_->AddOutput(scores);
+    
+    OperatorFusionPass fusion_pass;
+    EXPECT_TRUE(fusion_pass.CanFoldTransposeIntoMatMul(transpose, matmul));
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* folded = graph_->GetNodes()[0].get();
+    EXPECT_EQ(folded->GetOpType(), "MatMul");
+    ASSERT_EQ(folded->GetInputs().size(), 2u);
+    EXPECT_EQ(folded->GetInputs()[0], q);
+    EXPECT_EQ(folded->GetInputs()[1], k);
+    EXPECT_EQ(folded->GetAttribute("transB"), "1");
+}
+
+// 非最后两维交换的Transpose不折叠
+TEST_F(OperatorFusionTest, KeepGeneralTranspose) {
+    Value* x = graph_->AddValue();
+    Value* x_t = graph_->AddValue();
+    Value* w = graph_->AddValue();
+    Value* y = graph_->AddValue();
+    
+    Node* transpose = graph_->AddNode("Transpose", "transpose_x");
+    transpose->SetAttribute("perm", "0,2,1,3");
+    transpose->AddInput(x);
+    transpose->AddOutput(x_t);
+    
+    Node* matmul = graph_->AddNode("MatMul", "mm");
+    matmul->AddInput(x_t);
+    matmul->AddInput(w);
+    matmul->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    EXPECT_FALSE(fusion_pass.CanFoldTransposeIntoMatMul(transpose, matmul));
+}
+
+// 常量折叠：Shape->Gather->Concat链与权重侧Transpose在优化期求值，读取图输入的节点保留
+TEST_F(OperatorFusionTest, ConstantFoldingEvaluatesConstantSubgraphs) {
+    Value* x = graph_->AddValue();
+    x->SetTensor(CreateTensor(Shape({2, 3, 4}), DataType::FLOAT32, DeviceType::CPU));
+    graph_->AddInput(x);
+    
+    auto MakeInt64 = [this](const std::vector<int64_t>& values) {
+        Value* value = graph_->AddValue();
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(values.size())}),
+                                   DataType::INT64, DeviceType::CPU);
+        std::copy(values.begin(), values.end(), static_cast<int64_t*>(tensor->GetData()));
+        value->SetTensor(tensor);
+        return value;
+    };
+    
+    // shape = Concat(Gather(Shape(x), [0]), [-1])
+    Value* dims = graph_->AddValue();
+    Node* shape = graph_->AddNode("Shape", "shape");
+    shape->AddInput(x);
+    shape->AddOutput(dims);
+    Value* batch = graph_->AddValue();
+    Node* gather = graph_->AddNode("Gather", "gather");
+    gather->AddInput(dims);
+    gather->AddInput(MakeInt64({0}));
+    gather->AddOutput(batch);
+    Value* target = graph_->AddValue();
+    Node* concat = graph_->AddNode("Concat", "concat");
+    concat->SetAttribute("axis", "0");
+    concat->AddInput(batch);
+    concat->AddInput(MakeInt64({-1}));
+    concat->AddOutput(target);
+    Value* flat = graph_->AddValue();
+    Node* reshape = graph_->AddNode("Reshape", "reshape");
+    reshape->AddInput(x);
+    reshape->AddInput(target);
+    reshape->AddOutput(flat);
+    
+    // 权重侧Transpose：W[12, 5] -> W^T[5, 12]
+    Value* w = graph_->AddValue();
+    auto w_tensor = CreateTensor(Shape({12, 5}), DataType::FLOAT32, DeviceType::CPU);
+    float* w_data = static_cast<float*>(w_tensor->GetData());
+    for (int i = 0; i < 60; ++i) w_data[i] = static_cast<float>(i);
+    w->SetTensor(w_tensor);
+    Value* w_t = graph_->AddValue();
+    Node* transpose = graph_->AddNode("Transpose", "transpose_w");
+    transpose->SetAttribute("perm", "1,0");
+    transpose->AddInput(w);
+    transpose->AddOutput(w_t);
+    Value* y = graph_->AddValue();
+    Node* matmul = graph_->AddNode("MatMul", "mm");
+    matmul->SetAttribute("transB", "1");
+    matmul->AddInput(flat);
+    matmul->AddInput(w_t);
+    matmul->AddOutput(y);
+    graph_->AddOutput(y);
+    
+    const size_t values_before = graph_->GetValues().size();
+    ConstantFoldingPass pass;
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    
+    ASSERT_EQ(graph_->GetNodes().size(), 2u);
+    EXPECT_EQ(graph_->GetNodes()[0]->GetOpType(), "Reshape");
+    EXPECT_EQ(graph_->GetNodes()[1]->GetOpType(), "MatMul");
+    
+    // Reshape的目标形状成为INT64初始化器[2, -1]
+    ASSERT_NE(target->GetTensor(), nullptr);
+    EXPECT_EQ(target->GetProducer(), nullptr);
+    EXPECT_EQ(target->GetDataType(), DataType::INT64);
+    ASSERT_EQ(target->GetTensor()->GetElementCount(), 2u);
+    const int64_t* target_data = static_cast<const int64_t*>(target->GetTensor()->GetData());
+    EXPECT_EQ(target_data[0], 2);
+    EXPECT_EQ(target_data[1], -1);
+    
+    // 转置后的权重，原始W与中间常量被删除
+    ASSERT_NE(w_t->GetTensor(), nullptr);
+    EXPECT_EQ(w_t->GetTensor()->GetShape().dims, (std::vector<int64_t>{5, 12}));
+    const float* w_t_data = static_cast<const float*>(w_t->GetTensor()->GetData());
+    EXPECT_FLOAT_EQ(w_t_data[1], 5.0f);   // W^T[0][1] = W[1][0]
+    EXPECT_FLOAT_EQ(w_t_data[12], 1.0f);  // W^T[1][0] = W[0][1]
+    EXPECT_EQ(graph_->GetValues().size(), values_before - 5);  // W、Shape与Gather的输出、两个INT64常量
+    EXPECT_EQ(graph_->GetInputs().size(), 1u);
+}
+
+// 测试Conv+Add(残差)+ReLU融合为FusedConvAddReLU
+TEST_F(OperatorFusionTest, FuseConvAddReLUResidual) {
+    const Shape feature({1, 4, 8, 8});
+    Value* x = Input(feature);
+    Value* residual = Input(feature);
+    Value* weight = Constant(Shape({4, 4, 3, 3}), 0.1f);
+    Value* bias = Constant(Shape({4}), 0.0f);
+    Value* conv = Apply("Conv", {x, weight, bias}, feature, {{"pads", "1,1,1,1"}});
+    Value* sum = Apply("Add", {residual, conv}, feature);
+    Value* y = Apply("Relu", {sum}, feature);
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "FusedConvAddReLU");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{x, weight, bias, residual}));
+    EXPECT_EQ(fused->GetAttribute("pads"), "1,1,1,1");
+    EXPECT_EQ(y->GetProducer(), fused);
+    EXPECT_EQ(graph_->GetValues().size(), 5u);  // Conv与Add的中间结果已删除
+}
+
+// 测试MobileNet深度可分离块：深度卷积+ReLU -> 1x1卷积+ReLU融合为FusedDepthwisePointwise
+TEST_F(OperatorFusionTest, FuseDepthwisePointwiseBlock) {
+    Value* x = Input(Shape({1, 8, 16, 16}));
+    Value* dw_weight = Constant(Shape({8, 1, 3, 3}), 0.1f);
+    Value* dw_bias = Constant(Shape({8}), 0.0f);
+    Value* pw_weight = Constant(Shape({16, 8, 1, 1}), 0.2f);
+    Value* dw = Apply("Conv", {x, dw_weight, dw_bias}, Shape({1, 8, 8, 8}),
+                      {{"group", "8"}, {"strides", "2,2"}, {"pads", "1,1,1,1"}});
+    Value* dw_relu = Apply("Relu", {dw}, Shape({1, 8, 8, 8}));
+    Value* pw = Apply("Conv", {dw_relu, pw_weight}, Shape({1, 16, 8, 8}));
+    Value* y = Apply("Relu", {pw}, Shape({1, 16, 8, 8}));
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "FusedDepthwisePointwise");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{x, dw_weight, dw_bias, pw_weight}));
+    EXPECT_EQ(fused->GetAttribute("input_slots"), "0,1,2,3");
+    EXPECT_EQ(fused->GetAttribute("strides"), "2,2");
+    EXPECT_EQ(fused->GetAttribute("dw_activation"), "relu");
+    EXPECT_EQ(fused->GetAttribute("activation"), "relu");
+    EXPECT_EQ(y->GetProducer(), fused);
+}
+
+// 测试深度优先分块：中间特征图超过tile_bytes的Conv+ReLU -> Conv -> MaxPool链合并为FusedTileGroup
+TEST_F(OperatorFusionTest, DepthFirstTilingGroupsConvChain) {
+    Value* x = Input(Shape({1, 16, 64, 64}));
+    Value* w0 = Constant(Shape({16, 16, 3, 3}), 0.1f);
+    Value* b0 = Constant(Shape({16}), 0.0f);
+    Value* w1 = Constant(Shape({16, 16, 3, 3}), 0.2f);
+    Value* conv0 = Apply("Conv", {x, w0, b0}, Shape({1, 16, 64, 64}), {{"pads", "1,1,1,1"}});
+    Value* relu = Apply("Relu", {conv0}, Shape({1, 16, 64, 64}));
+    Value* conv1 = Apply("Conv", {relu, w1}, Shape({1, 16, 64, 64}), {{"pads", "1,1,1,1"}});
+    Value* y = Apply("MaxPool", {conv1}, Shape({1, 16, 32, 32}), {{"kernel_shape", "2,2"}, {"strides", "2,2"}});
+    graph_->AddOutput(y);
+    
+    // 中间结果（256KB）放得进预算时不分块
+    DepthFirstTilingPass large_budget(1 << 20);
+    ASSERT_TRUE(large_budget.Run(graph_.get()).IsOk());
+    EXPECT_EQ(graph_->GetNodes().size(), 4u);
+    
+    DepthFirstTilingPass tiling(64 * 1024);
+    ASSERT_TRUE(tiling.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "FusedTileGroup");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{x, w0, b0, w1}));
+    EXPECT_EQ(fused->GetAttribute("stage_types"), "0,0,1");
+    EXPECT_EQ(fused->GetAttribute("stage_has_bias"), "1,0,0");
+    EXPECT_EQ(fused->GetAttribute("stage_relu"), "1,0,0");
+    EXPECT_EQ(fused->GetAttribute("stage_strides"), "1,1,1,1,2,2");
+    EXPECT_EQ(y->GetProducer(), fused);
+}
+
+// 中间结果还有其他消费者或是图输出时不融合（单消费者约束）
+TEST_F(OperatorFusionTest, SkipFusionWhenIntermediateIsShared) {
+    const Shape feature({1, 2, 4, 4});
+    Value* x = Input(feature);
+    Value* weight = Constant(Shape({2, 2, 1, 1}), 0.5f);
+    Value* conv = Apply("Conv", {x, weight}, feature);
+    Value* y = Apply("Relu", {conv}, feature);
+    graph_->AddOutput(y);
+    graph_->AddOutput(conv);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 2u);
+    EXPECT_EQ(conv->GetProducer()->GetOpType(), "Conv");
+    EXPECT_EQ(y->GetProducer()->GetOpType(), "Relu");
+}
+
+// 测试LayerNorm分解子图（ReduceMean/Sub/Pow/Sqrt/Div）还原为LayerNormalization
+TEST_F(OperatorFusionTest, FuseLayerNormDecomposition) {
+    const Shape hidden({2, 8, 16});
+    const Shape reduced({2, 8, 1});
+    Value* x = Input(hidden);
+    Value* gamma = Constant(Shape({16}), 1.5f);
+    Value* beta = Constant(Shape({16}), 0.25f);
+    const std::vector<std::pair<std::string, std::string>> last_axis = {{"axes", "-1"}};
+    Value* mean = Apply("ReduceMean", {x}, reduced, last_axis);
+    Value* centered = Apply("Sub", {x, mean}, hidden);
+    Value* squared = Apply("Pow", {centered, Constant(Shape({1}), 2.0f)}, hidden);
+    Value* var = Apply("ReduceMean", {squared}, reduced, last_axis);
+    Value* var_eps = Apply("Add", {var, Constant(Shape({1}), 1e-5f)}, reduced);
+    Value* std_dev = Apply("Sqrt", {var_eps}, reduced);
+    Value* normalized = Apply("Div", {centered, std_dev}, hidden);
+    Value* scaled = Apply("Mul", {normalized, gamma}, hidden);
+    Value* y = Apply("Add", {scaled, beta}, hidden);
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "LayerNormalization");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{x, gamma, beta}));
+    EXPECT_EQ(fused->GetAttribute("axis"), "-1");
+    EXPECT_FLOAT_EQ(std::stof(fused->GetAttribute("epsilon")), 1e-5f);
+    EXPECT_EQ(y->GetProducer(), fused);
+}
+
+// 测试RMSNorm（x * reciprocal(sqrt(mean(x^2) + eps)) * gamma）与x * sigmoid(x)的识别
+TEST_F(OperatorFusionTest, FuseRMSNormAndSilu) {
+    const Shape hidden({4, 32});
+    const Shape reduced({4, 1});
+    Value* x = Input(hidden);
+    Value* gamma = Constant(Shape({32}), 1.0f);
+    Value* squared = Apply("Pow", {x, Constant(Shape({1}), 2.0f)}, hidden);
+    Value* mean_sq = Apply("ReduceMean", {squared}, reduced, {{"axes", "1"}});
+    Value* shifted = Apply("Add", {Constant(Shape({1}), 1e-6f), mean_sq}, reduced);
+    Value* rms = Apply("Sqrt", {shifted}, reduced);
+    Value* inv_rms = Apply("Reciprocal", {rms}, reduced);
+    Value* normalized = Apply("Mul", {x, inv_rms}, hidden);
+    Value* h = Apply("Mul", {gamma, normalized}, hidden);
+    Value* gate = Apply("Sigmoid", {h}, hidden);
+    Value* y = Apply("Mul", {h, gate}, hidden);
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 2u);
+    Node* norm = h->GetProducer();
+    ASSERT_NE(norm, nullptr);
+    EXPECT_EQ(norm->GetOpType(), "RMSNorm");
+    EXPECT_EQ(norm->GetInputs(), (std::vector<Value*>{x, gamma}));
+    EXPECT_FLOAT_EQ(std::stof(norm->GetAttribute("epsilon")), 1e-6f);
+    ASSERT_NE(y->GetProducer(), nullptr);
+    EXPECT_EQ(y->GetProducer()->GetOpType(), "Silu");
+    EXPECT_EQ(y->GetProducer()->GetInputs(), (std::vector<Value*>{h}));
+}
+
+// 测试LLaMA/Qwen的RoPE（rotate_half）与SwiGLU MLP子图识别：两个MatMul的权重合并为[K, 2N]
+TEST_F(OperatorFusionTest, FuseRotaryEmbeddingAndSwiGLU) {
+    const Shape heads({1, 2, 4, 8});
+    const Shape half({1, 2, 4, 4});
+    Value* q = Input(heads);
+    Value* positions = graph_->AddValue();
+    positions->SetTensor(CreateTensor(Shape({1, 4}), DataType::INT64, DeviceType::CPU));
+    graph_->AddInput(positions);
+    Value* cos_table = Constant(Shape({16, 8}), 0.5f);
+    Value* sin_table = Constant(Shape({16, 8}), 0.25f);
+    Value* cos = Apply("Unsqueeze", {Apply("Gather", {cos_table, positions}, Shape({1, 4, 8}))},
+                       Shape({1, 1, 4, 8}), {{"axes", "1"}});
+    Value* sin = Apply("Unsqueeze", {Apply("Gather", {sin_table, positions}, Shape({1, 4, 8}))},
+                       Shape({1, 1, 4, 8}), {{"axes", "1"}});
+    auto int64_constant = [this](int64_t v) {
+        Value* value = graph_->AddValue();
+        auto tensor = CreateTensor(Shape({1}), DataType::INT64, DeviceType::CPU);
+        *static_cast<int64_t*>(tensor->GetData()) = v;
+        value->SetTensor(tensor);
+        return value;
+    };
+    Value* last_axis = int64_constant(-1);
+    Value* x1 = Apply("Slice", {q, int64_constant(0), int64_constant(4), last_axis}, half);
+    Value* x2 = Apply("Slice", {q, int64_constant(4), int64_constant(INT64_MAX), last_axis}, half);
+    Value* rotated = Apply("Concat", {Apply("Neg", {x2}, half), x1}, heads, {{"axis", "-1"}});
+    Value* q_embed = Apply("Add", {Apply("Mul", {q, cos}, heads), Apply("Mul", {rotated, sin}, heads)}, heads);
+    graph_->AddOutput(q_embed);
+    
+    const Shape hidden({4, 16});
+    const Shape intermediate({4, 32});
+    Value* x = Input(hidden);
+    Value* w_gate = Constant(Shape({16, 32}), 0.1f);
+    Value* w_up = Constant(Shape({16, 32}), 0.2f);
+    Value* gate = Apply("MatMul", {x, w_gate}, intermediate);
+    Value* up = Apply("MatMul", {x, w_up}, intermediate);
+    Value* activated = Apply("Mul", {gate, Apply("Sigmoid", {gate}, intermediate)}, intermediate);
+    Value* mlp = Apply("Mul", {activated, up}, intermediate);
+    graph_->AddOutput(mlp);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    Node* rope = q_embed->GetProducer();
+    ASSERT_NE(rope, nullptr);
+    EXPECT_EQ(rope->GetOpType(), "RotaryEmbedding");
+    EXPECT_EQ(rope->GetInputs(), (std::vector<Value*>{q, positions, cos_table, sin_table}));
+    // cos/sin的Gather不再被使用，留给死代码消除
+    EXPECT_TRUE(cos->GetConsumers().empty());
+    
+    Node* swiglu = mlp->GetProducer();
+    ASSERT_NE(swiglu, nullptr);
+    EXPECT_EQ(swiglu->GetOpType(), "SwiGLU");
+    ASSERT_EQ(swiglu->GetInputs().size(), 2u);
+    EXPECT_EQ(swiglu->GetInputs()[0], x);
+    auto merged = swiglu->GetInputs()[1]->GetTensor();
+    ASSERT_NE(merged, nullptr);
+    EXPECT_EQ(merged->GetShape().dims, (std::vector<int64_t>{16, 64}));
+    const float* data = static_cast<const float*>(merged->GetData());
+    EXPECT_FLOAT_EQ(data[31], 0.1f);
+    EXPECT_FLOAT_EQ(data[32], 0.2f);
+    
+    // cos表两半不同（不是rotate_half格式）时不融合
+    graph_ = std::make_unique<Graph>();
+    q = Input(heads);
+    Value* table = graph_->AddValue();
+    auto tensor = CreateTensor(Shape({4, 8}), DataType::FLOAT32, DeviceType::CPU);
+    float* t = static_cast<float*>(tensor->GetData());
+    for (int i = 0; i < 32; ++i) {
+        t[i] = static_cast<float>(i);
+    }
+    table->SetTensor(tensor);
+    last_axis = int64_constant(-1);
+    x1 = Apply("Slice", {q, int64_constant(0), int64_constant(4), last_axis}, half);
+    x2 = Apply("Slice", {q, int64_constant(4), int64_constant(8), last_axis}, half);
+    rotated = Apply("Concat", {Apply("Neg", {x2}, half), x1}, heads, {{"axis", "3"}});
+    q_embed = Apply("Add", {Apply("Mul", {q, table}, heads), Apply("Mul", {rotated, table}, heads)}, heads);
+    graph_->AddOutput(q_embed);
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    EXPECT_NE(q_embed->GetProducer()->GetOpType(), "RotaryEmbedding");
+}
+
+// 测试残差Add并入其后的归一化：和还被下一个残差使用时作为第二个输出，否则删除
+TEST_F(OperatorFusionTest, FuseResidualAddIntoNormalization) {
+    const Shape hidden({2, 4, 32});
+    Value* x = Input(hidden);
+    Value* attn = Input(hidden);
+    Value* gamma = Constant(Shape({32}), 1.0f);
+    Value* beta = Constant(Shape({32}), 0.0f);
+    Value* residual = Apply("Add", {x, attn}, hidden);
+    Value* normed = Apply("LayerNormalization", {residual, gamma, beta}, hidden,
+                          {{"axis", "-1"}, {"epsilon", "1e-5"}});
+    Value* ffn = Apply("Relu", {normed}, hidden);
+    Value* residual2 = Apply("Add", {residual, ffn}, hidden);
+    Value* y = Apply("RMSNorm", {residual2, gamma}, hidden, {{"epsilon", "1e-6"}});
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 3u);
+    Node* first = normed->GetProducer();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->GetOpType(), "AddLayerNorm");
+    EXPECT_EQ(first->GetInputs(), (std::vector<Value*>{x, attn, gamma, beta}));
+    EXPECT_EQ(first->GetOutputs(), (std::vector<Value*>{normed, residual}));
+    EXPECT_FLOAT_EQ(std::stof(first->GetAttribute("epsilon")), 1e-5f);
+    Node* second = y->GetProducer();
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second->GetOpType(), "AddRMSNorm");
+    EXPECT_EQ(second->GetInputs(), (std::vector<Value*>{residual, ffn, gamma}));
+    EXPECT_EQ(second->GetOutputs(), (std::vector<Value*>{y}));
+    
+    // 需要广播的Add保持不变
+    graph_ = std::make_unique<Graph>();
+    Value* wide = Input(hidden);
+    Value* row = Input(Shape({32}));
+    Value* broadcast = Apply("Add", {wide, row}, hidden);
+    Value* out = Apply("RMSNorm", {broadcast, Constant(Shape({32}), 1.0f)}, hidden);
+    graph_->AddOutput(out);
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    EXPECT_EQ(out->GetProducer()->GetOpType(), "RMSNorm");
+}
+
+// 测试MatMul+Add+GELU融合为带activation的FusedMatMulAdd
+TEST_F(OperatorFusionTest, FuseMatMulAddGelu) {
+    Value* a = Input(Shape({8, 16}));
+    Value* w = Constant(Shape({16, 32}), 0.01f);
+    Value* b = Constant(Shape({32}), 0.0f);
+    Value* mm = Apply("MatMul", {a, w}, Shape({8, 32}));
+    Value* biased = Apply("Add", {mm, b}, Shape({8, 32}));
+    Value* y = Apply("Gelu", {biased}, Shape({8, 32}), {{"approximate", "tanh"}});
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "FusedMatMulAdd");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{a, w, b}));
+    EXPECT_EQ(fused->GetAttribute("activation"), "gelu");
+    EXPECT_EQ(fused->GetAttribute("approximate"), "tanh");
+}
+
+// 测试导出的全连接层Gemm+Relu融合为带activation的Gemm
+TEST_F(OperatorFusionTest, FuseGemmRelu) {
+    Value* a = Input(Shape({8, 16}));
+    Value* w = Constant(Shape({16, 32}), 0.01f);
+    Value* b = Constant(Shape({32}), 0.0f);
+    Value* fc = Apply("Gemm", {a, w, b}, Shape({8, 32}));
+    Value* y = Apply("Relu", {fc}, Shape({8, 32}));
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "Gemm");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{a, w, b}));
+    EXPECT_EQ(fused->GetAttribute("activation"), "relu");
+}
+
+// 测试逐元素链合并：标量常量与同形操作数进入FusedElementwise，广播操作数打断链
+TEST_F(OperatorFusionTest, FuseElementwiseChain) {
+    const Shape shape({4, 64});
+    Value* x = Input(shape);
+    Value* y = Input(shape);
+    Value* expand = Input(Shape({2, 1, 64}));
+    Value* t0 = Apply("Sub", {Constant(Shape({1}), 1.0f), x}, shape);  // 1 - x
+    Value* t1 = Apply("Mul", {t0, y}, shape);
+    Value* t2 = Apply("Tanh", {t1}, shape);
+    Value* t3 = Apply("Div", {t2, Constant(Shape({1}), 2.0f)}, shape);
+    Value* out = Apply("Add", {t3, expand}, Shape({2, 4, 64}));  // 广播扩大了输出，不并入链
+    graph_->AddOutput(out);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 2u);
+    Node* chain = t3->GetProducer();
+    ASSERT_NE(chain, nullptr);
+    EXPECT_EQ(chain->GetOpType(), "FusedElementwise");
+    EXPECT_EQ(chain->GetAttribute("ops"), "RSub,Mul,Tanh,Div");
+    ASSERT_EQ(chain->GetInputs().size(), 4u);
+    EXPECT_EQ(chain->GetInputs()[0], x);
+    EXPECT_EQ(chain->GetInputs()[2], y);
+    EXPECT_EQ(out->GetProducer()->GetOpType(), "Add");
+    
+    // 融合后的节点可以直接由CPU算子执行
+    auto op = OperatorRegistry::Instance().Create("FusedElementwise");
+    ASSERT_NE(op, nullptr);
+    ApplyNodeAttributes(*chain, op.get());
+    std::vector<Tensor*> inputs;
+    for (Value* input : chain->GetInputs()) {
+        inputs.push_back(input->GetTensor().get());
+    }
+    static_cast<float*>(inputs[0]->GetData())[0] = 0.5f;
+    static_cast<float*>(inputs[2]->GetData())[0] = 3.0f;
+    auto result = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute(inputs, {result.get()}, &ctx).IsOk());
+    EXPECT_NEAR(static_cast<const float*>(result->GetData())[0], std::tanh(1.5f) / 2.0f, 1e-5f);
+}
+
+// 测试逐元素链合并广播操作数与已有输入：
+// y = pow(max(bias + tanh(x) + x) * scale, 0), 2)，scale/bias为[C, 1, 1]，x同时是链起点与Add的操作数
+TEST_F(OperatorFusionTest, FuseBroadcastElementwiseChain) {
+    const Shape shape({2, 8, 4, 4});
+    Value* x = Input(shape);
+    Value* scale = Constant(Shape({8, 1, 1}), 0.5f);
+    Value* bias = Constant(Shape({8, 1, 1}), -0.25f);
+    Value* t0 = Apply("Tanh", {x}, shape);
+    Value* t1 = Apply("Add", {t0, x}, shape);
+    Value* t2 = Apply("Mul", {t1, scale}, shape);
+    Value* t3 = Apply("Add", {bias, t2}, shape);
+    Value* t4 = Apply("Max", {t3, Constant(Shape({1}), 0.0f)}, shape);
+    Value* out = Apply("Pow", {t4, Constant(Shape({1}), 2.0f)}, shape);
+    graph_->AddOutput(out);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* chain = out->GetProducer();
+    ASSERT_NE(chain, nullptr);
+    EXPECT_EQ(chain->GetOpType(), "FusedElementwise");
+    EXPECT_EQ(chain->GetAttribute("ops"), "Tanh,Add@0,Mul,Add,Max,Pow");
+    ASSERT_EQ(chain->GetInputs().size(), 5u);
+    EXPECT_EQ(chain->GetInputs()[0], x);
+    EXPECT_EQ(chain->GetInputs()[1], scale);
+    EXPECT_EQ(chain->GetInputs()[2], bias);
+    
+    auto op = OperatorRegistry::Instance().Create("FusedElementwise");
+    ASSERT_NE(op, nullptr);
+    ApplyNodeAttributes(*chain, op.get());
+    std::vector<Tensor*> inputs;
+    for (Value* input : chain->GetInputs()) {
+        inputs.push_back(input->GetTensor().get());
+    }
+    float* x_data = static_cast<float*>(inputs[0]->GetData());
+    for (int64_t i = 0; i < shape.GetElementCount(); ++i) x_data[i] = std::sin(0.05f * i);
+    float* scale_data = static_cast<float*>(inputs[1]->GetData());
+    for (int c = 0; c < 8; ++c) scale_data[c] = 0.25f * (c + 1);
+    auto result = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    ExecutionContext ctx;
+    ASSERT_TRUE(op->Execute(inputs, {result.get()}, &ctx).IsOk());
+    const float* y = static_cast<const float*>(result->GetData());
+    for (int64_t i = 0; i < shape.GetElementCount(); ++i) {
+        const int64_t c = (i / 16) % 8;
+        const float v = std::max((std::tanh(x_data[i]) + x_data[i]) * scale_data[c] - 0.25f, 0.0f);
+        EXPECT_NEAR(y[i], v * v, 1e-5f) << "i=" << i;
+    }
+}
+
+// 测试BN折叠进Conv权重：结果与Conv + BatchNormalization一致，随后Conv+ReLU继续融合
+TEST_F(OperatorFusionTest, FoldBatchNormIntoConv) {
+    const Shape input_shape({1, 2, 4, 4});
+    const Shape output_shape({1, 3, 4, 4});
+    Value* x = Input(input_shape);
+    float* x_data = static_cast<float*>(x->GetTensor()->GetData());
+    for (int i = 0; i < 32; ++i) x_data[i] = std::sin(0.3f * i);
+    Value* weight = Constant(Shape({3, 2, 3, 3}), 0.0f);
+    float* w_data = static_cast<float*>(weight->GetTensor()->GetData());
+    for (int i = 0; i < 54; ++i) w_data[i] = std::cos(0.17f * i);
+    Value* bias = Constant(Shape({3}), 0.1f);
+    Value* gamma = Constant(Shape({3}), 1.5f);
+    Value* beta = Constant(Shape({3}), -0.2f);
+    Value* mean = Constant(Shape({3}), 0.3f);
+    Value* var = Constant(Shape({3}), 2.0f);
+    Value* conv = Apply("Conv", {x, weight, bias}, output_shape, {{"pads", "1,1,1,1"}});
+    Value* bn = Apply("BatchNormalization", {conv, gamma, beta, mean, var}, output_shape,
+                      {{"epsilon", "0.001"}});
+    Value* y = Apply("Relu", {bn}, output_shape);
+    graph_->AddOutput(y);
+    
+    // 参考结果：Conv -> BN
+    auto Run = [](const Node& node, const std::vector<Tensor*>& inputs, Tensor* output) {
+        auto op = OperatorRegistry::Instance().Create(node.GetOpType());
+        ApplyNodeAttributes(node, op.get());
+        ExecutionContext ctx;
+        return op->Execute(inputs, {output}, &ctx);
+    };
+    auto conv_ref = CreateTensor(output_shape, DataType::FLOAT32, DeviceType::CPU);
+    auto bn_ref = CreateTensor(output_shape, DataType::FLOAT32, DeviceType::CPU);
+    ASSERT_TRUE(Run(*conv->GetProducer(), {x->GetTensor().get(), weight->GetTensor().get(),
+                                           bias->GetTensor().get()}, conv_ref.get()).IsOk());
+    ASSERT_TRUE(Run(*bn->GetProducer(), {conv_ref.get(), gamma->GetTensor().get(),
+                                         beta->GetTensor().get(), mean->GetTensor().get(),
+                                         var->GetTensor().get()}, bn_ref.get()).IsOk());
+    
+    ConvBNFoldingPass folding_pass;
+    ASSERT_TRUE(folding_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 2u);
+    Node* folded = bn->GetProducer();
+    ASSERT_NE(folded, nullptr);
+    EXPECT_EQ(folded->GetOpType(), "Conv");
+    ASSERT_EQ(folded->GetInputs().size(), 3u);
+    EXPECT_EQ(folded->GetInputs()[0], x);
+    EXPECT_EQ(graph_->GetValues().size(), 5u);  // x、W'、b'、BN输出、ReLU输出
+    
+    auto folded_out = CreateTensor(output_shape, DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> folded_inputs;
+    for (Value* input : folded->GetInputs()) {
+        folded_inputs.push_back(input->GetTensor().get());
+    }
+    ASSERT_TRUE(Run(*folded, folded_inputs, folded_out.get()).IsOk());
+    const float* expected = static_cast<const float*>(bn_ref->GetData());
+    const float* actual = static_cast<const float*>(folded_out->GetData());
+    for (size_t i = 0; i < folded_out->GetElementCount(); ++i) {
+        EXPECT_NEAR(actual[i], expected[i], 1e-4f);
+    }
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    EXPECT_EQ(graph_->GetNodes()[0]->GetOpType(), "FusedConvReLU");
+}
+
+// 测试注意力子图融合：Transpose(K)折叠后，MatMul -> Div -> Add(mask) -> Softmax -> MatMul合并为FusedAttention
+TEST_F(OperatorFusionTest, FuseAttentionSubgraph) {
+    Value* q = Input(Shape({1, 2, 4, 8}));
+    Value* k = Input(Shape({1, 2, 6, 8}));
+    Value* v = Input(Shape({1, 2, 6, 8}));
+    Value* mask = Input(Shape({1, 1, 4, 6}));
+    const Shape scores_shape({1, 2, 4, 6});
+    Value* kt = Apply("Transpose", {k}, Shape({1, 2, 8, 6}), {{"perm", "0,1,3,2"}});
+    Value* scores = Apply("MatMul", {q, kt}, scores_shape);
+    Value* scaled = Apply("Div", {scores, Constant(Shape({1}), 4.0f)}, scores_shape);
+    Value* masked = Apply("Add", {mask, scaled}, scores_shape);
+    Value* probs = Apply("Softmax", {masked}, scores_shape, {{"axis", "-1"}});
+    Value* y = Apply("MatMul", {probs, v}, Shape({1, 2, 4, 8}));
+    graph_->AddOutput(y);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    ASSERT_EQ(graph_->GetNodes().size(), 1u);
+    Node* fused = graph_->GetNodes()[0].get();
+    EXPECT_EQ(fused->GetOpType(), "FusedAttention");
+    EXPECT_EQ(fused->GetInputs(), (std::vector<Value*>{q, k, v, mask}));
+    EXPECT_EQ(fused->GetOutputs()[0], y);
+    EXPECT_EQ(fused->GetAttribute("scale"), "0.25");
+}
+
+// 注意力概率被其他节点使用（如输出attention weights）时不融合
+TEST_F(OperatorFusionTest, KeepAttentionWhenProbabilitiesAreUsed) {
+    Value* q = Input(Shape({2, 4, 8}));
+    Value* k = Input(Shape({2, 4, 8}));
+    Value* v = Input(Shape({2, 4, 8}));
+    Value* scores = Apply("MatMul", {q, k}, Shape({2, 4, 4}), {{"transB", "1"}});
+    Value* probs = Apply("Softmax", {scores}, Shape({2, 4, 4}));
+    Value* y = Apply("MatMul", {probs, v}, Shape({2, 4, 8}));
+    graph_->AddOutput(y);
+    graph_->AddOutput(probs);
+    
+    OperatorFusionPass fusion_pass;
+    ASSERT_TRUE(fusion_pass.Run(graph_.get()).IsOk());
+    for (const auto& node : graph_->GetNodes()) {
+        EXPECT_NE(node->GetOpType(), "FusedAttention");
+    }
+}
+
+// 公共子表达式消除：各消费者各自的Shape->Gather->Unsqueeze链（索引常量值相同）与同一输入上的相同Transpose合并
+TEST_F(OperatorFusionTest, EliminateCommonSubexpressions) {
+    Value* x = Input(Shape({2, 3, 4}));
+    Value* shape_a = Apply("Shape", {x});
+    Value* shape_b = Apply("Shape", {x});
+    Value* dim_a = Apply("Gather", {shape_a, Constant(Shape({1}), 0.0f)}, Shape(), {{"axis", "0"}});
+    Value* dim_b = Apply("Gather", {shape_b, Constant(Shape({1}), 0.0f)}, Shape(), {{"axis", "0"}});
+    Value* unsq_a = Apply("Unsqueeze", {dim_a}, Shape(), {{"axes", "0"}});
+    Value* unsq_b = Apply("Unsqueeze", {dim_b}, Shape(), {{"axes", "0"}});
+    // 属性不同的Gather不合并
+    Value* dim_c = Apply("Gather", {shape_b, Constant(Shape({1}), 0.0f)}, Shape(), {{"axis", "1"}});
+    Value* t_a = Apply("Transpose", {x}, Shape({4, 3, 2}), {{"perm", "2,1,0"}});
+    Value* t_b = Apply("Transpose", {x}, Shape({4, 3, 2}), {{"perm", "2,1,0"}});
+    Value* sum = Apply("Add", {t_a, t_b}, Shape({4, 3, 2}));
+    Value* concat = Apply("Concat", {unsq_a, unsq_b, dim_c}, Shape(), {{"axis", "0"}});
+    graph_->AddOutput(sum);
+    graph_->AddOutput(concat);
+    // 输出是图输出的重复节点保留
+    Value* relu_a = Apply("Relu", {x}, Shape({2, 3, 4}));
+    Value* relu_b = Apply("Relu", {x}, Shape({2, 3, 4}));
+    graph_->AddOutput(relu_a);
+    graph_->AddOutput(relu_b);
+    
+    CommonSubexpressionEliminationPass cse;
+    ASSERT_TRUE(cse.Run(graph_.get()).IsOk());
+    std::map<std::string, int> counts;
+    for (const auto& node : graph_->GetNodes()) {
+        ++counts[node->GetOpType()];
+    }
+    EXPECT_EQ(counts["Shape"], 1);
+    EXPECT_EQ(counts["Gather"], 2);
+    EXPECT_EQ(counts["Unsqueeze"], 1);
+    EXPECT_EQ(counts["Transpose"], 1);
+    EXPECT_EQ(counts["Relu"], 2);
+    Node* add = sum->GetProducer();
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->GetInputs()[0], add->GetInputs()[1]);
+    Node* cat = concat->GetProducer();
+    EXPECT_EQ(cat->GetInputs()[0], cat->GetInputs()[1]);
+    EXPECT_NE(cat->GetInputs()[2], cat->GetInputs()[0]);
+    // 三个同值索引常量只剩一个
+    EXPECT_EQ(dim_c->GetProducer()->GetInputs()[1], cat->GetInputs()[0]->GetProducer()->GetInputs()[0]->GetProducer()->GetInputs()[1]);
+    Status valid = graph_->Validate();
+    EXPECT_TRUE(valid.IsOk()) << valid.Message();
+}
+
+// 恒等算子消除：Identity、推理Dropout、同形Reshape、互逆Transpose对与同类型Cast
+TEST_F(OperatorFusionTest, EliminateIdentityOps) {
+    Value* x = Input(Shape({2, 3, 4}));
+    Value* relu = Apply("Relu", {x}, Shape({2, 3, 4}));
+    Value* id = Apply("Identity", {relu}, Shape({2, 3, 4}));
+    Value* drop = Apply("Dropout", {id}, Shape({2, 3, 4}));
+    Value* same = Apply("Reshape", {drop, Constant(Shape({3}), 0.0f)}, Shape({2, 3, 4}));
+    Value* t1 = Apply("Transpose", {same}, Shape({4, 2, 3}), {{"perm", "2,0,1"}});
+    Value* t2 = Apply("Transpose", {t1}, Shape({2, 3, 4}), {{"perm", "1,2,0"}});
+    Value* cast = Apply("Cast", {t2}, Shape({2, 3, 4}), {{"to", "1"}});
+    Value* y = Apply("Sigmoid", {cast}, Shape({2, 3, 4}));
+    // 真正改变形状的Reshape、非互逆的Transpose与改变类型的Cast保留
+    Value* flat = Apply("Reshape", {relu, Constant(Shape({1}), 24.0f)}, Shape({24}));
+    Value* perm = Apply("Transpose", {x}, Shape({3, 2, 4}), {{"perm", "1,0,2"}});
+    Value* perm2 = Apply("Transpose", {perm}, Shape({3, 4, 2}), {{"perm", "0,2,1"}});
+    Value* to_half = Apply("Cast", {x}, Shape({2, 3, 4}), {{"to", "10"}});
+    graph_->AddOutput(flat);
+    graph_->AddOutput(perm2);
+    graph_->AddOutput(to_half);
+    // 图输出上的Identity：由其输入接替并沿用输出名
+    Value* tail = Apply("Identity", {y}, Shape({2, 3, 4}));
+    tail->SetName("output");
+    graph_->AddOutput(tail);
+    
+    const size_t values_before = graph_->GetValues().size();
+    IdentityEliminationPass pass;
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    std::map<std::string, int> counts;
+    for (const auto& node : graph_->GetNodes()) {
+        ++counts[node->GetOpType()];
+    }
+    EXPECT_EQ(counts["Identity"], 0);
+    EXPECT_EQ(counts["Dropout"], 0);
+    EXPECT_EQ(counts["Reshape"], 1);
+    EXPECT_EQ(counts["Transpose"], 2);
+    EXPECT_EQ(counts["Cast"], 1);
+    ASSERT_EQ(graph_->GetOutputs().size(), 4u);
+    EXPECT_EQ(graph_->GetOutputs()[3], y);
+    EXPECT_EQ(y->GetName(), "output");
+    Node* sigmoid = y->GetProducer();
+    ASSERT_NE(sigmoid, nullptr);
+    EXPECT_EQ(sigmoid->GetInputs()[0], relu);
+    // 被删节点的输出与只供它们使用的形状常量一并删除
+    EXPECT_LT(graph_->GetValues().size(), values_before);
+    EXPECT_TRUE(graph_->Validate().IsOk());
+}
+
+// 测试转置下沉：Transpose越过逐元素算子后与另一个Transpose抵消，相邻的Transpose合并，常量按逆置换重排
+TEST_F(OperatorFusionTest, SinkTransposes) {
+    Value* x = Input(Shape({2, 3, 4}));
+    Value* z = Input(Shape({3, 2, 4}));
+    // T -> Relu -> Add(bias[3]) -> T⁻¹：两个Transpose都消失，bias重排为[1, 3, 1]
+    Value* bias = graph_->AddValue();
+    auto bias_tensor = CreateTensor(Shape({3}), DataType::FLOAT32, DeviceType::CPU);
+    float* bias_data = static_cast<float*>(bias_tensor->GetData());
+    for (int i = 0; i < 3; ++i) bias_data[i] = static_cast<float>(i + 1);
+    bias->SetTensor(bias_tensor);
+    Value* t = Apply("Transpose", {x}, Shape({2, 4, 3}), {{"perm", "0,2,1"}});
+    Value* relu = Apply("Relu", {t}, Shape({2, 4, 3}));
+    Value* biased = Apply("Add", {relu, bias}, Shape({2, 4, 3}));
+    Value* back = Apply("Transpose", {biased}, Shape({2, 3, 4}), {{"perm", "0,2,1"}});
+    Value* y = Apply("Sigmoid", {back}, Shape({2, 3, 4}));
+    graph_->AddOutput(y);
+    // 两个同perm的Transpose相乘：改为先相乘再转置一次，图输出仍是同一个Value
+    Value* p = Apply("Transpose", {x}, Shape({3, 2, 4}), {{"perm", "1,0,2"}});
+    Value* q = Apply("Transpose", {z}, Shape({2, 3, 4}), {{"perm", "1,0,2"}});
+    Value* product = Apply("Mul", {p, q}, Shape({3, 2, 4}));
+    graph_->AddOutput(product);
+    // 相邻的Transpose合并：perm[j] = p1[p2[j]]
+    Value* w = Apply("Transpose", {x}, Shape({4, 2, 3}), {{"perm", "2,0,1"}});
+    Value* w2 = Apply("Transpose", {w}, Shape({4, 3, 2}), {{"perm", "0,2,1"}});
+    graph_->AddOutput(w2);
+    // 不可交换的算子挡住下沉
+    Value* s = Apply("Transpose", {x}, Shape({3, 2, 4}), {{"perm", "1,0,2"}});
+    Value* soft = Apply("Softmax", {s}, Shape({3, 2, 4}), {{"axis", "1"}});
+    graph_->AddOutput(soft);
+    
+    TransposeOptimizationPass pass;
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    std::map<std::string, int> counts;
+    for (const auto& node : graph_->GetNodes()) {
+        ++counts[node->GetOpType()];
+    }
+    EXPECT_EQ(counts["Transpose"], 3);
+    
+    Node* sigmoid = y->GetProducer();
+    ASSERT_NE(sigmoid, nullptr);
+    Node* add = sigmoid->GetInputs()[0]->GetProducer();
+    ASSERT_NE(add, nullptr);
+    ASSERT_EQ(add->GetOpType(), "Add");
+    Node* relu_node = add->GetInputs()[0]->GetProducer();
+    ASSERT_NE(relu_node, nullptr);
+    EXPECT_EQ(relu_node->GetInputs()[0], x);
+    auto permuted = add->GetInputs()[1]->GetTensor();
+    ASSERT_NE(permuted, nullptr);
+    EXPECT_EQ(permuted->GetShape().dims, (std::vector<int64_t>{1, 3, 1}));
+    EXPECT_FLOAT_EQ(static_cast<const float*>(permuted->GetData())[2], 3.0f);
+    EXPECT_EQ(sigmoid->GetInputs()[0]->GetShape().dims, (std::vector<int64_t>{2, 3, 4}));
+    
+    Node* tail = product->GetProducer();
+    ASSERT_NE(tail, nullptr);
+    EXPECT_EQ(tail->GetOpType(), "Transpose");
+    Node* mul = tail->GetInputs()[0]->GetProducer();
+    ASSERT_NE(mul, nullptr);
+    EXPECT_EQ(mul->GetInputs(), (std::vector<Value*>{x, z}));
+    
+    Node* merged = w2->GetProducer();
+    ASSERT_NE(merged, nullptr);
+    EXPECT_EQ(merged->GetInputs()[0], x);
+    EXPECT_EQ(merged->FindAttribute("perm")->GetInts(), (std::vector<int64_t>{2, 1, 0}));
+    
+    EXPECT_EQ(soft->GetProducer()->GetInputs()[0], s);
+    EXPECT_TRUE(graph_->Validate().IsOk());
+}
+
+// 可重复的Pass迭代到不动点，没有目标算子的Pass被跳过
+TEST_F(OperatorFusionTest, PassManagerFixedPoint) {
+    Value* x = Input(Shape({2, 4}));
+    Value* dead = Apply("Relu", {x}, Shape({2, 4}));
+    dead = Apply("Sigmoid", {dead}, Shape({2, 4}));
+    Apply("Tanh", {dead}, Shape({2, 4}));
+    graph_->AddOutput(Apply("Neg", {x}, Shape({2, 4})));
+    
+    Optimizer optimizer;
+    optimizer.RegisterPass(std::make_unique<DeadCodeEliminationPass>());
+    optimizer.RegisterPass(std::make_unique<ConvBNFoldingPass>());
+    ASSERT_TRUE(optimizer.Optimize(graph_.get()).IsOk());
+    EXPECT_EQ(graph_->GetNodes().size(), 1u);
+    
+    const auto& stats = optimizer.GetPassStatistics();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].name, "DeadCodeElimination");
+    EXPECT_EQ(stats[0].runs, 4);  // 每次删一层，最后一次确认不再变化
+    EXPECT_TRUE(stats[0].modified);
+    EXPECT_TRUE(stats[0].converged);
+    EXPECT_EQ(stats[0].nodes_before, 4u);
+    EXPECT_EQ(stats[0].nodes_after, 1u);
+    EXPECT_GE(stats[0].time_ms, 0.0);
+    EXPECT_TRUE(stats[1].skipped);
+    EXPECT_EQ(stats[1].runs, 0);
+    
+    // 迭代上限内未收敛
+    dead = Apply("Relu", {x}, Shape({2, 4}));
+    Apply("Sigmoid", {dead}, Shape({2, 4}));
+    optimizer.SetMaxIterations(1);
+    ASSERT_TRUE(optimizer.Optimize(graph_.get()).IsOk());
+    EXPECT_EQ(optimizer.GetPassStatistics()[0].runs, 1);
+    EXPECT_FALSE(optimizer.GetPassStatistics()[0].converged);
+    EXPECT_EQ(graph_->GetNodes().size(), 2u);
+}
+
+// 两个分支各自产生大张量再归约：交替执行时两个大张量同时存活，逐分支执行时峰值减半
+TEST_F(OperatorFusionTest, MemoryAwareScheduling) {
+    Value* x = Input(Shape({1024}));
+    Value* b1 = Apply("Relu", {x}, Shape({1024}));
+    Value* b2 = Apply("Sigmoid", {x}, Shape({1024}));
+    Value* s1 = Apply("ReduceSum", {b1}, Shape({1}));
+    Value* s2 = Apply("ReduceSum", {b2}, Shape({1}));
+    graph_->AddOutput(Apply("Add", {s1, s2}, Shape({1})));
+    
+    MemoryPlan before;
+    ASSERT_TRUE(PlanMemory(graph_.get(), MemoryPlannerOptions(), &before).IsOk());
+    MemoryAwareSchedulingPass pass;
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    
+    std::vector<Node*> order = graph_->TopologicalSort();
+    ASSERT_EQ(order.size(), 5u);
+    EXPECT_EQ(order[0], b1->GetProducer());
+    EXPECT_EQ(order[1], s1->GetProducer());
+    EXPECT_EQ(order[2], b2->GetProducer());
+    EXPECT_EQ(order[3], s2->GetProducer());
+    MemoryPlan after;
+    ASSERT_TRUE(PlanMemory(graph_.get(), MemoryPlannerOptions(), &after).IsOk());
+    EXPECT_EQ(before.arena_size, 2 * 4096u + 64u);
+    EXPECT_LT(after.arena_size, before.arena_size);
+    EXPECT_TRUE(graph_->Validate().IsOk());
+    
+    // 已是最优顺序时不再改写
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    EXPECT_EQ(graph_->TopologicalSort(), order);
+}
+
+// 测试权重按执行顺序重排：小张量集中在缓冲开头，大权重按首次使用的顺序排在其后，全部64字节对齐且内容不变
+TEST_F(OperatorFusionTest, CacheOptimizationLaysOutWeightsInExecutionOrder) {
+    Value* x = Input(Shape({4, 256}));
+    // 先创建第二层的权重，原有的分配顺序与执行顺序相反
+    Value* w2 = Constant(Shape({256, 256}), 2.0f);
+    Value* w1 = Constant(Shape({256, 256}), 1.0f);
+    Value* b1 = Constant(Shape({256}), 0.5f);
+    Value* b2 = Constant(Shape({256}), -0.5f);
+    Value* h = Apply("Gemm", {x, w1, b1}, Shape({4, 256}));
+    Value* r = Apply("Relu", {h}, Shape({4, 256}));
+    Value* shared = Apply("Gemm", {r, w2, b2}, Shape({4, 256}));
+    graph_->AddOutput(Apply("Gemm", {shared, w2, b1}, Shape({4, 256})));  // 重复使用的权重只放一份
+    
+    CacheOptimizationPass pass;
+    ASSERT_TRUE(pass.Run(graph_.get()).IsOk());
+    auto address = [](Value* value) { return reinterpret_cast<uintptr_t>(value->GetTensor()->GetData()); };
+    for (Value* value : {w1, w2, b1, b2}) {
+        EXPECT_EQ(address(value) % 64, 0u);
+    }
+    EXPECT_EQ(address(b2), address(b1) + 256 * sizeof(float));
+    EXPECT_EQ(address(w1), address(b2) + 256 * sizeof(float));
+    EXPECT_EQ(address(w2), address(w1) + 256 * 256 * sizeof(float));
+    EXPECT_FLOAT_EQ(static_cast<const float*>(w1->GetTensor()->GetData())[256 * 256 - 1], 1.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(w2->GetTensor()->GetData())[0], 2.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(b2->GetTensor()->GetData())[7], -0.5f);
+    
+    // 起始地址未对齐的权重（外部数据中的任意偏移）被拷到对齐的缓冲，已对齐的不动
+    std::vector<float> storage(256 + 16, 3.0f);
+    float* misaligned = storage.data();
+    while (reinterpret_cast<uintptr_t>(misaligned) % 64 == 0) ++misaligned;
+    b1->SetTensor(CreateTensorFromData(Shape({256}), DataType::FLOAT32, misaligned));
+    const uintptr_t w1_address = address(w1);
+    MemoryAlignmentPass alignment;
+    ASSERT_TRUE(alignment.Run(graph_.get()).IsOk());
+    EXPECT_EQ(address(b1) % 64, 0u);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(b1->GetTensor()->GetData())[255], 3.0f);
+    EXPECT_EQ(address(w1), w1_address);
+}
+
+// 测试横向融合：同输入的Q/K/V MatMul（带bias）合并为一个MatMul+Add，同属性的1x1 Conv+ReLU合并，
+// 结果由Slice切回；合并后再经纵向融合，输出与不融合时一致
+TEST_F(OperatorFusionTest, HorizontalFusionOfSiblingMatMulsAndConvs) {
+    auto build = []() {
+        auto graph = std::make_unique<Graph>();
+        int seed = 0;
+        auto constant = [&](const std::vector<int64_t>& dims) {
+            Value* value = graph->AddValue();
+            auto tensor = CreateTensor(Shape(dims), DataType::FLOAT32, DeviceType::CPU);
+            float* data = static_cast<float*>(tensor->GetData());
+            ++seed;
+            for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+                data[i] = 0.5f * std::sin(0.37f * static_cast<float>(i) + static_cast<float>(seed));
+            }
+            value->SetTensor(tensor);
+            return value;
+        };
+        auto input = [&](const std::string& name, const std::vector<int64_t>& dims) {
+            Value* value = graph->AddValue();
+            value->SetName(name);
+            value->SetTensor(CreateTensor(Shape(dims), DataType::FLOAT32, DeviceType::CPU));
+            graph->AddInput(value);
+            return value;
+        };
+        auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+            Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+            for (Value* in : inputs) {
+                node->AddInput(in);
+            }
+            Value* output = graph->AddValue();
+            node->AddOutput(output);
+            return output;
+        };
+        Value* x = input("x", {2, 3, 8});
+        for (int64_t width : {6, 6, 4}) {
+            graph->AddOutput(apply("Add", {apply("MatMul", {x, constant({8, width})}), constant({width})}));
+        }
+        Value* image = input("image", {1, 4, 5, 5});
+        graph->AddOutput(apply("Relu", {apply("Conv", {image, constant({3, 4, 1, 1}), constant({3})})}));
+        graph->AddOutput(apply("Relu", {apply("Conv", {image, constant({2, 4, 1, 1})})}));
+        Value* conv3x3 = apply("Conv", {image, constant({2, 4, 3, 3})});
+        conv3x3->GetProducer()->SetAttribute("pads", "1,1,1,1");
+        graph->AddOutput(conv3x3);
+        return graph;
+    };
+    auto count = [](const Graph& graph) {
+        std::map<std::string, int> counts;
+        for (const auto& node : graph.GetNodes()) {
+            ++counts[node->GetOpType()];
+        }
+        return counts;
+    };
+    
+    auto graph = build();
+    HorizontalFusionPass pass;
+    ASSERT_TRUE(pass.Run(graph.get()).IsOk());
+    EXPECT_TRUE(graph->Validate().IsOk());
+    auto counts = count(*graph);
+    EXPECT_EQ(counts["MatMul"], 1);
+    EXPECT_EQ(counts["Add"], 1);
+    EXPECT_EQ(counts["Conv"], 2);  // 合并的1x1与单独的3x3
+    EXPECT_EQ(counts["Relu"], 1);
+    EXPECT_EQ(counts["Slice"], 5);
+    OperatorFusionPass fusion;
+    ASSERT_TRUE(fusion.Run(graph.get()).IsOk());
+    counts = count(*graph);
+    EXPECT_EQ(counts["FusedMatMulAdd"], 1);
+    EXPECT_EQ(counts["FusedConvReLU"], 1);
+    
+    // 端到端：关闭融合的会话作为参考
+    auto x = CreateTensor(Shape({2, 3, 8}), DataType::FLOAT32, DeviceType::CPU);
+    auto image = CreateTensor(Shape({1, 4, 5, 5}), DataType::FLOAT32, DeviceType::CPU);
+    for (Tensor* tensor : {x.get(), image.get()}) {
+        float* data = static_cast<float*>(tensor->GetData());
+        for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+            data[i] = std::cos(0.23f * static_cast<float>(i));
+        }
+    }
+    auto run = [&](bool fuse, std::vector<std::shared_ptr<Tensor>>* outputs) {
+        SessionOptions options;
+        options.enable_operator_fusion = fuse;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(build()).IsOk());
+        ASSERT_TRUE(session->Run({x.get(), image.get()}, *outputs).IsOk());
+    };
+    std::vector<std::shared_ptr<Tensor>> expected, actual;
+    run(false, &expected);
+    run(true, &actual);
+    ASSERT_EQ(actual.size(), 6u);
+    ASSERT_EQ(expected.size(), 6u);
+    for (size_t o = 0; o < actual.size(); ++o) {
+        ASSERT_EQ(actual[o]->GetShape().dims, expected[o]->GetShape().dims);
+        auto dense = MakeContiguous(actual[o]);
+        const float* a = static_cast<const float*>(dense->GetData());
+        const float* e = static_cast<const float*>(expected[o]->GetData());
+        for (size_t i = 0; i < dense->GetElementCount(); ++i) {
+            EXPECT_NEAR(a[i], e[i], 1e-4f) << "output " << o << " element " << i;
+        }
+    }
+}
+
+// DLRM式的Gather(表, [B, L]) + ReduceSum(axes=1)还原为EmbeddingBag，输出形状（keepdims）与数值不变
+TEST_F(OperatorFusionTest, FuseGatherReduceSumIntoEmbeddingBag) {
+    const int64_t rows = 31, dim = 12, batch = 3, pooling = 5;
+    auto build = [&]() {
+        auto graph = std::make_unique<Graph>();
+        Value* table = graph->AddValue();
+        auto table_tensor = CreateTensor(Shape({rows, dim}), DataType::FLOAT32, DeviceType::CPU);
+        float* data = static_cast<float*>(table_tensor->GetData());
+        for (int64_t i = 0; i < rows * dim; ++i) {
+            data[i] = std::cos(0.11f * static_cast<float>(i));
+        }
+        table->SetTensor(table_tensor);
+        Value* ids = graph->AddValue();
+        ids->SetTensor(CreateTensor(Shape({batch, pooling}), DataType::INT64, DeviceType::CPU));
+        graph->AddInput(ids);
+        Value* gathered = graph->AddValue();
+        Node* gather = graph->AddNode("Gather", "emb");
+        gather->AddInput(table);
+        gather->AddInput(ids);
+        gather->AddOutput(gathered);
+        Value* pooled = graph->AddValue();
+        pooled->SetTensor(CreateTensor(Shape({batch, 1, dim}), DataType::FLOAT32, DeviceType::CPU));
+        Node* sum = graph->AddNode("ReduceSum", "emb.sum");
+        sum->SetAttribute("axes", AttributeValue(std::vector<int64_t>{1}));
+        sum->SetAttribute("keepdims", AttributeValue(int64_t(1)));
+        sum->AddInput(gathered);
+        sum->AddOutput(pooled);
+        graph->AddOutput(pooled);
+        return graph;
+    };
+    
+    auto graph = build();
+    OperatorFusionPass fusion;
+    ASSERT_TRUE(fusion.Run(graph.get()).IsOk());
+    ASSERT_EQ(graph->GetNodes().size(), 1u);
+    EXPECT_EQ(graph->GetNodes()[0]->GetOpType(), "EmbeddingBag");
+    
+    auto ids = CreateTensor(Shape({batch, pooling}), DataType::INT64, DeviceType::CPU);
+    int64_t* id_data = static_cast<int64_t*>(ids->GetData());
+    for (int64_t i = 0; i < batch * pooling; ++i) {
+        id_data[i] = (i * 7) % rows;
+    }
+    auto run = [&](bool fuse, std::vector<std::shared_ptr<Tensor>>* outputs) {
+        SessionOptions options;
+        options.enable_operator_fusion = fuse;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(build()).IsOk());
+        ASSERT_TRUE(session->Run({ids.get()}, *outputs).IsOk());
+    };
+    std::vector<std::shared_ptr<Tensor>> expected, actual;
+    run(false, &expected);
+    run(true, &actual);
+    ASSERT_EQ(actual.size(), 1u);
+    ASSERT_EQ(expected.size(), 1u);
+    ASSERT_EQ(actual[0]->GetShape().dims, (std::vector<int64_t>{batch, 1, dim}));
+    ASSERT_EQ(actual[0]->GetShape().dims, expected[0]->GetShape().dims);
+    const float* a = static_cast<const float*>(actual[0]->GetData());
+    const float* e = static_cast<const float*>(expected[0]->GetData());
+    for (int64_t i = 0; i < batch * dim; ++i) {
+        EXPECT_NEAR(a[i], e[i], 1e-5f) << "element " << i;
+    }
+}
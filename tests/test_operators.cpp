@@ -5,9 +5,12 @@
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
+#include "operators/simd_utils.h"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <cstring>
+#include <random>
 
 using namespace inferunity;
 
@@ -204,3 +207,692 @@ TEST_F(OperatorsTest, MatMulOperator) {
     EXPECT_GT(out_data[0], 0.0f);
 }
 
+
+namespace {
+
+// 参考实现：整行排序后依次做top-k、温度softmax、top-p与逆CDF采样；
+// 不截断候选时算子按下标顺序累积，不排序
+int64_t ReferenceSample(const std::vector<float>& logits, float temperature, int64_t top_k, float top_p, float u) {
+    std::vector<int64_t> order(logits.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int64_t>(i);
+    if (top_k > 0 || top_p < 1.0f) {
+        std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) { return logits[a] > logits[b]; });
+    }
+    if (top_k > 0) order.resize(static_cast<size_t>(top_k));
+    const float max_logit = *std::max_element(logits.begin(), logits.end());
+    std::vector<double> probs;
+    double total = 0.0;
+    for (int64_t index : order) {
+        probs.push_back(std::exp((logits[index] - max_logit) / temperature));
+        total += probs.back();
+    }
+    size_t kept = probs.size();
+    double cumulative = 0.0;
+    for (size_t i = 0; i < probs.size() && top_p < 1.0f; ++i) {
+        cumulative += probs[i];
+        if (cumulative >= top_p * total) {
+            kept = i + 1;
+            break;
+        }
+    }
+    double kept_total = 0.0;
+    for (size_t i = 0; i < kept; ++i) kept_total += probs[i];
+    cumulative = 0.0;
+    for (size_t i = 0; i < kept; ++i) {
+        cumulative += probs[i];
+        if (u * kept_total < cumulative) return order[i];
+    }
+    return order[kept - 1];
+}
+
+} // anonymous namespace
+
+// 测试ArgMax与Sampling：贪心取第一个最大值，top-k/top-p/温度与排序后的参考实现一致，重复惩罚改变结果
+TEST_F(OperatorsTest, SamplingOperators) {
+    auto& registry = OperatorRegistry::Instance();
+    const int64_t B = 6, S = 2, V = 5003;
+    std::vector<float> data(B * S * V);
+    uint32_t state = 12345;
+    for (float& x : data) {
+        state = state * 1664525u + 1013904223u;
+        x = static_cast<float>(state >> 8) / 16777216.0f * 8.0f - 4.0f;
+    }
+    data[(0 * S + 1) * V + 700] = 9.0f;   // 第0行的最大值出现两次，取第一个
+    data[(0 * S + 1) * V + 4000] = 9.0f;
+    auto logits = CreateTensor(Shape({B, S, V}), DataType::FLOAT32, data);
+    auto output = inferunity::CreateTensor(Shape({B, 1}), DataType::INT64, DeviceType::CPU);
+    const int64_t* tokens = static_cast<const int64_t*>(output->GetData());
+    auto last_row = [&](int64_t b) {
+        const float* row = data.data() + (b * S + S - 1) * V;
+        return std::vector<float>(row, row + V);
+    };
+    
+    auto argmax = registry.Create("ArgMax");
+    ASSERT_NE(argmax, nullptr);
+    argmax->SetAttribute("axis", AttributeValue(static_cast<int64_t>(-1)));
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(argmax->InferOutputShape({logits.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, std::vector<int64_t>({B, S, 1}));
+    auto indices = inferunity::CreateTensor(shapes[0], DataType::INT64, DeviceType::CPU);
+    ASSERT_TRUE(argmax->Execute({logits.get()}, {indices.get()}, nullptr).IsOk());
+    EXPECT_EQ(static_cast<const int64_t*>(indices->GetData())[1], 700);
+    
+    // 贪心：每个batch取最后一个位置
+    auto sampling = registry.Create("Sampling");
+    ASSERT_NE(sampling, nullptr);
+    sampling->SetAttribute("temperature", AttributeValue(0.0f));
+    ASSERT_TRUE(sampling->InferOutputShape({logits.get()}, shapes = {}).IsOk());
+    EXPECT_EQ(shapes[0].dims, std::vector<int64_t>({B, 1}));
+    ASSERT_TRUE(sampling->Execute({logits.get()}, {output.get()}, nullptr).IsOk());
+    for (int64_t b = 0; b < B; ++b) {
+        const auto row = last_row(b);
+        EXPECT_EQ(tokens[b], std::max_element(row.begin(), row.end()) - row.begin());
+    }
+    
+    // 重复惩罚：第0行的两个最大值都出现过，改为第三大的值
+    auto past = inferunity::CreateTensor(Shape({B, 3}), DataType::INT64, DeviceType::CPU);
+    int64_t* past_ids = static_cast<int64_t*>(past->GetData());
+    std::fill(past_ids, past_ids + B * 3, static_cast<int64_t>(-1));
+    past_ids[0] = 700;
+    past_ids[1] = 4000;
+    past_ids[2] = 700;
+    sampling->SetAttribute("repetition_penalty", AttributeValue(10.0f));
+    ASSERT_TRUE(sampling->Execute({logits.get(), past.get()}, {output.get()}, nullptr).IsOk());
+    auto row0 = last_row(0);
+    row0[700] = row0[4000] = -100.0f;
+    EXPECT_EQ(tokens[0], std::max_element(row0.begin(), row0.end()) - row0.begin());
+    
+    // 温度、top-k与top-p的各种组合与参考实现一致
+    struct Config { float temperature; int64_t top_k; float top_p; };
+    const Config configs[] = {{0.7f, 0, 1.0f}, {1.0f, 40, 1.0f}, {0.8f, 0, 0.9f}, {1.3f, 100, 0.5f}, {0.5f, 1, 1.0f}};
+    auto uniform = inferunity::CreateTensor(Shape({B}), DataType::FLOAT32, DeviceType::CPU);
+    float* u = static_cast<float*>(uniform->GetData());
+    for (const Config& config : configs) {
+        auto op = registry.Create("Sampling");
+        op->SetAttribute("temperature", AttributeValue(config.temperature));
+        op->SetAttribute("top_k", AttributeValue(config.top_k));
+        op->SetAttribute("top_p", AttributeValue(config.top_p));
+        auto empty_past = inferunity::CreateTensor(Shape({B, 0}), DataType::INT64, DeviceType::CPU);
+        for (int trial = 0; trial < 4; ++trial) {
+            for (int64_t b = 0; b < B; ++b) u[b] = std::fmod(0.137f * (b + 1) + 0.29f * trial, 1.0f);
+            ASSERT_TRUE(op->Execute({logits.get(), empty_past.get(), uniform.get()}, {output.get()}, nullptr).IsOk());
+            for (int64_t b = 0; b < B; ++b) {
+                EXPECT_EQ(tokens[b], ReferenceSample(last_row(b), config.temperature, config.top_k,
+                                                     config.top_p, u[b]))
+                    << "temperature " << config.temperature << " top_k " << config.top_k << " top_p "
+                    << config.top_p << " batch " << b;
+            }
+        }
+    }
+    
+    // 内部随机数：同一seed的结果可复现
+    auto first = registry.Create("Sampling");
+    auto second = registry.Create("Sampling");
+    for (auto* op : {first.get(), second.get()}) {
+        op->SetAttribute("top_k", AttributeValue(static_cast<int64_t>(20)));
+        op->SetAttribute("seed", AttributeValue(static_cast<int64_t>(9)));
+    }
+    auto other = inferunity::CreateTensor(Shape({B, 1}), DataType::INT64, DeviceType::CPU);
+    ASSERT_TRUE(first->Execute({logits.get()}, {output.get()}, nullptr).IsOk());
+    ASSERT_TRUE(second->Execute({logits.get()}, {other.get()}, nullptr).IsOk());
+    EXPECT_EQ(std::vector<int64_t>(tokens, tokens + B),
+              std::vector<int64_t>(static_cast<const int64_t*>(other->GetData()),
+                                   static_cast<const int64_t*>(other->GetData()) + B));
+    sampling->SetAttribute("top_p", AttributeValue(0.0f));
+    EXPECT_FALSE(sampling->Execute({logits.get()}, {output.get()}, nullptr).IsOk());
+}
+
+// Resize：手算的双线性放大，以及各种mode/坐标变换/缩放方向与逐像素直接插值的参考实现一致
+TEST_F(OperatorsTest, ResizeMatchesReference) {
+    auto& registry = OperatorRegistry::Instance();
+    auto make_floats = [this](const std::vector<float>& values) {
+        return CreateTensor(Shape({static_cast<int64_t>(values.size())}), DataType::FLOAT32, values);
+    };
+    
+    // asymmetric坐标下2倍双线性放大[[1, 2], [3, 4]]，越界的坐标截到边缘
+    {
+        auto resize = registry.Create("Resize");
+        ASSERT_NE(resize, nullptr);
+        resize->SetAttribute("mode", AttributeValue(std::string("linear")));
+        resize->SetAttribute("coordinate_transformation_mode", AttributeValue(std::string("asymmetric")));
+        auto x = CreateTensor(Shape({1, 1, 2, 2}), DataType::FLOAT32, {1, 2, 3, 4});
+        auto scales = make_floats({1, 1, 2, 2});
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(resize->InferOutputShape({x.get(), scales.get()}, shapes).IsOk());
+        ASSERT_EQ(shapes[0].dims, std::vector<int64_t>({1, 1, 4, 4}));
+        auto y = CreateTensor(shapes[0], DataType::FLOAT32);
+        ASSERT_TRUE(resize->Execute({x.get(), scales.get()}, {y.get()}, nullptr).IsOk());
+        const std::vector<float> expected = {1, 1.5f, 2, 2, 2, 2.5f, 3, 3, 3, 3.5f, 4, 4, 3, 3.5f, 4, 4};
+        const float* out = static_cast<const float*>(y->GetData());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_FLOAT_EQ(out[i], expected[i]) << i;
+        }
+    }
+    
+    // 参考实现：每个输出像素直接按坐标变换与插值核求和
+    auto original = [](const std::string& mode, int64_t x, float scale, int64_t in, int64_t out) {
+        const float fx = static_cast<float>(x);
+        if (mode == "align_corners") return out > 1 ? fx * (in - 1) / static_cast<float>(out - 1) : 0.0f;
+        if (mode == "asymmetric") return fx / scale;
+        if (mode == "pytorch_half_pixel") return out > 1 ? (fx + 0.5f) / scale - 0.5f : 0.0f;
+        return (fx + 0.5f) / scale - 0.5f;
+    };
+    auto cubic = [](float t, float a) {
+        t = std::abs(t);
+        if (t <= 1.0f) return ((a + 2) * t - (a + 3)) * t * t + 1;
+        if (t < 2.0f) return ((a * t - 5 * a) * t + 8 * a) * t - 4 * a;
+        return 0.0f;
+    };
+    // 一个轴上的(下标, 权重)列表
+    auto taps = [&](const std::string& mode, const std::string& coord, bool exclude, int64_t o, float scale,
+                    int64_t in, int64_t out) {
+        std::vector<std::pair<int64_t, float>> result;
+        float c = original(coord, o, scale, in, out);
+        if (mode == "nearest") {
+            const float lower = std::floor(c);
+            int64_t i = c - lower == 0.5f ? static_cast<int64_t>(lower) : static_cast<int64_t>(std::round(c));
+            result.push_back({std::min(std::max<int64_t>(i, 0), in - 1), 1.0f});
+        } else if (mode == "linear") {
+            c = std::min(std::max(c, 0.0f), static_cast<float>(in - 1));
+            const int64_t i = static_cast<int64_t>(c);
+            result.push_back({i, 1.0f - (c - i)});
+            result.push_back({std::min(i + 1, in - 1), c - i});
+        } else {
+            const int64_t base = static_cast<int64_t>(std::floor(c));
+            float sum = 0.0f;
+            for (int64_t i = base - 1; i <= base + 2; ++i) {
+                const bool outside = i < 0 || i >= in;
+                const float w = exclude && outside ? 0.0f : cubic(c - static_cast<float>(i), -0.75f);
+                result.push_back({std::min(std::max<int64_t>(i, 0), in - 1), w});
+                sum += w;
+            }
+            if (exclude) {
+                for (auto& tap : result) tap.second /= sum;
+            }
+        }
+        return result;
+    };
+    
+    struct Case {
+        std::string mode;
+        std::string coord;
+        bool exclude;
+        int64_t in_h, in_w, out_h, out_w;
+    };
+    const std::vector<Case> cases = {
+        {"nearest", "half_pixel", false, 5, 7, 11, 16},
+        {"nearest", "asymmetric", false, 9, 6, 4, 3},
+        {"linear", "half_pixel", false, 5, 7, 13, 19},
+        {"linear", "align_corners", false, 8, 9, 3, 20},
+        {"linear", "pytorch_half_pixel", false, 6, 37, 6, 74},
+        {"cubic", "half_pixel", false, 5, 6, 12, 9},
+        {"cubic", "asymmetric", true, 7, 7, 15, 4},
+    };
+    const int64_t planes = 3;
+    for (const Case& c : cases) {
+        std::vector<float> input(planes * c.in_h * c.in_w);
+        for (size_t i = 0; i < input.size(); ++i) {
+            input[i] = std::sin(0.37f * static_cast<float>(i)) * 4.0f;
+        }
+        auto x = CreateTensor(Shape({1, planes, c.in_h, c.in_w}), DataType::FLOAT32, input);
+        auto sizes = inferunity::CreateTensor(Shape({4}), DataType::INT64, DeviceType::CPU);
+        int64_t* size_data = static_cast<int64_t*>(sizes->GetData());
+        size_data[0] = 1;
+        size_data[1] = planes;
+        size_data[2] = c.out_h;
+        size_data[3] = c.out_w;
+        auto resize = registry.Create("Resize");
+        resize->SetAttribute("mode", AttributeValue(c.mode));
+        resize->SetAttribute("coordinate_transformation_mode", AttributeValue(c.coord));
+        resize->SetAttribute("exclude_outside", AttributeValue(static_cast<int64_t>(c.exclude)));
+        resize->SetAttribute("input_slots", AttributeValue(std::vector<int64_t>{0, 3}));  // Resize(X, "", "", sizes)
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(resize->InferOutputShape({x.get(), sizes.get()}, shapes).IsOk());
+        ASSERT_EQ(shapes[0].dims, std::vector<int64_t>({1, planes, c.out_h, c.out_w}));
+        auto y = CreateTensor(shapes[0], DataType::FLOAT32);
+        ASSERT_TRUE(resize->Execute({x.get(), sizes.get()}, {y.get()}, nullptr).IsOk());
+        const float* out = static_cast<const float*>(y->GetData());
+        const float scale_h = static_cast<float>(c.out_h) / c.in_h;
+        const float scale_w = static_cast<float>(c.out_w) / c.in_w;
+        for (int64_t p = 0; p < planes; ++p) {
+            for (int64_t oy = 0; oy < c.out_h; ++oy) {
+                for (int64_t ox = 0; ox < c.out_w; ++ox) {
+                    float expected = 0.0f;
+                    for (const auto& ty : taps(c.mode, c.coord, c.exclude, oy, scale_h, c.in_h, c.out_h)) {
+                        for (const auto& tx : taps(c.mode, c.coord, c.exclude, ox, scale_w, c.in_w, c.out_w)) {
+                            expected += ty.second * tx.second * input[(p * c.in_h + ty.first) * c.in_w + tx.first];
+                        }
+                    }
+                    EXPECT_NEAR(out[(p * c.out_h + oy) * c.out_w + ox], expected, 1e-4f)
+                        << c.mode << "/" << c.coord << " at " << p << "," << oy << "," << ox;
+                }
+            }
+        }
+    }
+    
+    auto resize = registry.Create("Resize");
+    resize->SetAttribute("mode", AttributeValue(std::string("linear")));
+    auto x = CreateTensor(Shape({2, 3, 4}), DataType::FLOAT32);
+    auto scales = make_floats({2, 1, 1});
+    std::vector<Shape> shapes;
+    EXPECT_FALSE(resize->InferOutputShape({x.get(), scales.get()}, shapes).IsOk());  // 只缩放最后两维
+}
+
+// ImagePreprocess：一遍完成的uint8 NHWC -> 归一化NCHW与分开的归一化、转置、Resize、Cast结果一致，
+// 分块布局补齐的通道为0
+TEST_F(OperatorsTest, ImagePreprocessMatchesSeparatePasses) {
+    auto& registry = OperatorRegistry::Instance();
+    const int64_t n = 2, h = 5, w = 19, c = 3;
+    const std::vector<float> mean = {0.485f, 0.456f, 0.406f};
+    const std::vector<float> stddev = {0.229f, 0.224f, 0.225f};
+    const float scale = 1.0f / 255.0f;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> dist(0, 255);
+    auto image = inferunity::CreateTensor(Shape({n, h, w, c}), DataType::UINT8, DeviceType::CPU);
+    uint8_t* pixels = static_cast<uint8_t*>(image->GetData());
+    for (size_t i = 0; i < image->GetElementCount(); ++i) {
+        pixels[i] = static_cast<uint8_t>(dist(rng));
+    }
+    // 分开的几遍：BGR -> RGB、归一化、HWC -> CHW
+    auto reference = CreateTensor(Shape({n, c, h, w}), DataType::FLOAT32);
+    float* ref = static_cast<float*>(reference->GetData());
+    for (int64_t b = 0; b < n; ++b) {
+        for (int64_t ch = 0; ch < c; ++ch) {
+            for (int64_t i = 0; i < h * w; ++i) {
+                const float x = pixels[(b * h * w + i) * c + (c - 1 - ch)];
+                ref[(b * c + ch) * h * w + i] = (x * scale - mean[ch]) / stddev[ch];
+            }
+        }
+    }
+    auto run = [&](const std::vector<std::pair<std::string, AttributeValue>>& attributes) {
+        auto op = registry.Create("ImagePreprocess");
+        EXPECT_NE(op, nullptr);
+        op->SetAttribute("mean", AttributeValue(mean));
+        op->SetAttribute("std", AttributeValue(stddev));
+        op->SetAttribute("scale", AttributeValue(scale));
+        op->SetAttribute("reverse_channels", AttributeValue(int64_t(1)));
+        for (const auto& attribute : attributes) {
+            op->SetAttribute(attribute.first, attribute.second);
+        }
+        std::vector<Shape> shapes;
+        EXPECT_TRUE(op->InferOutputShape({image.get()}, shapes).IsOk());
+        auto y = inferunity::CreateTensor(shapes[0], op->InferOutputDataType({image.get()}, 0), DeviceType::CPU);
+        EXPECT_TRUE(op->Execute({image.get()}, {y.get()}, nullptr).IsOk());
+        return y;
+    };
+    
+    auto nchw = run({});
+    ASSERT_EQ(nchw->GetShape().dims, std::vector<int64_t>({n, c, h, w}));
+    const float* out = static_cast<const float*>(nchw->GetData());
+    for (size_t i = 0; i < reference->GetElementCount(); ++i) {
+        ASSERT_NEAR(out[i], ref[i], 1e-5f) << "at " << i;
+    }
+    
+    auto half = run({{"to", AttributeValue(int64_t(10))}});
+    ASSERT_EQ(half->GetDataType(), DataType::FLOAT16);
+    std::vector<float> widened(half->GetElementCount());
+    simd::ConvertHalfToFloatSIMD(static_cast<const uint16_t*>(half->GetData()), widened.data(), widened.size());
+    for (size_t i = 0; i < widened.size(); ++i) {
+        ASSERT_NEAR(widened[i], ref[i], 2e-3f) << "at " << i;
+    }
+    
+    const int64_t block = 8;
+    auto blocked = run({{"layout", AttributeValue(std::string("NCHWc"))}, {"block_size", AttributeValue(block)}});
+    ASSERT_EQ(blocked->GetShape().dims, std::vector<int64_t>({n, 1, h, w, block}));
+    const float* b_out = static_cast<const float*>(blocked->GetData());
+    for (int64_t b = 0; b < n; ++b) {
+        for (int64_t i = 0; i < h * w; ++i) {
+            for (int64_t ch = 0; ch < block; ++ch) {
+                const float expected = ch < c ? ref[(b * c + ch) * h * w + i] : 0.0f;
+                ASSERT_NEAR(b_out[(b * h * w + i) * block + ch], expected, 1e-5f);
+            }
+        }
+    }
+    
+    // 缩放：与先预处理、再做half_pixel的Resize一致
+    for (const std::string mode : {"linear", "nearest"}) {
+        auto resized = run({{"height", AttributeValue(int64_t(8))}, {"width", AttributeValue(int64_t(7))},
+                            {"mode", AttributeValue(mode)}});
+        ASSERT_EQ(resized->GetShape().dims, std::vector<int64_t>({n, c, 8, 7}));
+        auto resize = registry.Create("Resize");
+        resize->SetAttribute("mode", AttributeValue(mode));
+        resize->SetAttribute("input_slots", AttributeValue(std::vector<int64_t>{0, 3}));
+        auto sizes = inferunity::CreateTensor(Shape({4}), DataType::INT64, DeviceType::CPU);
+        int64_t* size_data = static_cast<int64_t*>(sizes->GetData());
+        size_data[0] = n;
+        size_data[1] = c;
+        size_data[2] = 8;
+        size_data[3] = 7;
+        auto expected = CreateTensor(Shape({n, c, 8, 7}), DataType::FLOAT32);
+        ASSERT_TRUE(resize->Execute({reference.get(), sizes.get()}, {expected.get()}, nullptr).IsOk());
+        const float* got = static_cast<const float*>(resized->GetData());
+        const float* want = static_cast<const float*>(expected->GetData());
+        for (size_t i = 0; i < expected->GetElementCount(); ++i) {
+            ASSERT_NEAR(got[i], want[i], 1e-4f) << mode << " at " << i;
+        }
+    }
+    
+    auto op = registry.Create("ImagePreprocess");
+    op->SetAttribute("mean", AttributeValue(std::vector<float>{0.5f, 0.5f}));
+    EXPECT_FALSE(op->ValidateInputs({image.get()}).IsOk());  // mean须每通道一个
+}
+
+// TopK：堆筛选（k远小于行长）与部分选择两条路径都与整行排序的结果一致，相等值取下标小的
+TEST_F(OperatorsTest, TopKMatchesSort) {
+    auto& registry = OperatorRegistry::Instance();
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(0, 63);  // 取值范围小，制造大量相等值
+    struct Case {
+        std::vector<int64_t> dims;
+        int64_t axis, k;
+        bool largest;
+    };
+    const std::vector<Case> cases = {
+        {{3, 5000}, -1, 5, true},    // 堆筛选，跨越多个筛选块
+        {{3, 100}, 1, 40, true},     // 部分选择
+        {{3, 100}, -1, 7, false},
+        {{6, 9, 4}, 1, 3, true},     // axis不在最内层
+        {{6, 9, 4}, 0, 6, false},
+    };
+    for (const Case& c : cases) {
+        auto op = registry.Create("TopK");
+        ASSERT_NE(op, nullptr);
+        op->SetAttribute("axis", AttributeValue(c.axis));
+        op->SetAttribute("largest", AttributeValue(static_cast<int64_t>(c.largest ? 1 : 0)));
+        auto x = CreateTensor(Shape(c.dims), DataType::FLOAT32);
+        float* px = static_cast<float*>(x->GetData());
+        for (size_t i = 0; i < x->GetElementCount(); ++i) px[i] = static_cast<float>(dist(rng));
+        auto k = CreateTensor(Shape({1}), DataType::INT64);
+        *static_cast<int64_t*>(k->GetData()) = c.k;
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(op->InferOutputShape({x.get(), k.get()}, shapes).IsOk());
+        ASSERT_EQ(shapes.size(), 2u);
+        auto values = CreateTensor(shapes[0], DataType::FLOAT32);
+        auto indices = CreateTensor(shapes[1], DataType::INT64);
+        ASSERT_TRUE(op->Execute({x.get(), k.get()}, {values.get(), indices.get()}, nullptr).IsOk());
+    
+        const int64_t rank = static_cast<int64_t>(c.dims.size());
+        const int64_t axis = c.axis < 0 ? c.axis + rank : c.axis;
+        int64_t outer = 1, inner = 1;
+        for (int64_t i = 0; i < axis; ++i) outer *= c.dims[i];
+        for (int64_t i = axis + 1; i < rank; ++i) inner *= c.dims[i];
+        const int64_t n = c.dims[axis];
+        const float* pv = static_cast<const float*>(values->GetData());
+        const int64_t* pi = static_cast<const int64_t*>(indices->GetData());
+        for (int64_t o = 0; o < outer; ++o) {
+            for (int64_t j = 0; j < inner; ++j) {
+                std::vector<int64_t> order(n);
+                for (int64_t i = 0; i < n; ++i) order[i] = i;
+                std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+                    const float va = px[(o * n + a) * inner + j];
+                    const float vb = px[(o * n + b) * inner + j];
+                    return c.largest ? va > vb : va < vb;
+                });
+                for (int64_t i = 0; i < c.k; ++i) {
+                    const int64_t at = (o * c.k + i) * inner + j;
+                    EXPECT_EQ(pi[at], order[i]) << "case k=" << c.k << " row " << o << "," << j;
+                    EXPECT_EQ(pv[at], px[(o * n + order[i]) * inner + j]);
+                }
+            }
+        }
+    }
+}
+
+// NonMaxSuppression：ONNX参考用例，以及随机框与逐对计算IoU的贪心参考实现在各ISA上一致
+TEST_F(OperatorsTest, NonMaxSuppressionMatchesReference) {
+    auto& registry = OperatorRegistry::Instance();
+    auto run = [&](Operator* op, const std::vector<Tensor*>& inputs) {
+        Tensor output;
+        EXPECT_TRUE(op->Execute(inputs, {&output}, nullptr).IsOk());
+        const int64_t* data = static_cast<const int64_t*>(output.GetData());
+        std::vector<int64_t> result;
+        if (!output.GetShape().dims.empty() && output.GetShape().dims[0] > 0) {
+            result.assign(data, data + output.GetShape().dims[0] * 3);
+        }
+        return result;
+    };
+    auto max_boxes = CreateTensor(Shape({1}), DataType::INT64);
+    *static_cast<int64_t*>(max_boxes->GetData()) = 3;
+    auto iou = CreateTensor(Shape({1}), DataType::FLOAT32, {0.5f});
+    auto score = CreateTensor(Shape({1}), DataType::FLOAT32, {0.0f});
+    auto high_score = CreateTensor(Shape({1}), DataType::FLOAT32, {0.4f});
+    auto scores = CreateTensor(Shape({1, 1, 6}), DataType::FLOAT32, {0.9f, 0.75f, 0.6f, 0.95f, 0.5f, 0.3f});
+    {
+        auto nms = registry.Create("NonMaxSuppression");
+        ASSERT_NE(nms, nullptr);
+        auto boxes = CreateTensor(Shape({1, 6, 4}), DataType::FLOAT32,
+                                  {0, 0, 1, 1, 0, 0.1f, 1, 1.1f, 0, -0.1f, 1, 0.9f,
+                                   0, 10, 1, 11, 0, 10.1f, 1, 11.1f, 0, 100, 1, 101});
+        EXPECT_EQ(run(nms.get(), {boxes.get(), scores.get(), max_boxes.get(), iou.get(), score.get()}),
+                  std::vector<int64_t>({0, 0, 3, 0, 0, 0, 0, 0, 5}));
+        EXPECT_EQ(run(nms.get(), {boxes.get(), scores.get(), max_boxes.get(), iou.get(), high_score.get()}),
+                  std::vector<int64_t>({0, 0, 3, 0, 0, 0}));
+        // 省略max_output_boxes_per_class时不输出任何框
+        EXPECT_TRUE(run(nms.get(), {boxes.get(), scores.get()}).empty());
+    }
+    {
+        auto nms = registry.Create("NonMaxSuppression");
+        nms->SetAttribute("center_point_box", AttributeValue(static_cast<int64_t>(1)));
+        auto boxes = CreateTensor(Shape({1, 6, 4}), DataType::FLOAT32,
+                                  {0.5f, 0.5f, 1, 1, 0.5f, 0.6f, 1, 1, 0.5f, 0.4f, 1, 1,
+                                   0.5f, 10.5f, 1, 1, 0.5f, 10.6f, 1, 1, 0.5f, 100.5f, 1, 1});
+        EXPECT_EQ(run(nms.get(), {boxes.get(), scores.get(), max_boxes.get(), iou.get(), score.get()}),
+                  std::vector<int64_t>({0, 0, 3, 0, 0, 0, 0, 0, 5}));
+    }
+    
+    // 随机框：2个batch、3个类别、150个框，对角顺序随机互换
+    const int64_t B = 2, C = 3, N = 150;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> pos(0.0f, 20.0f);
+    std::uniform_real_distribution<float> size(1.0f, 6.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto boxes = CreateTensor(Shape({B, N, 4}), DataType::FLOAT32);
+    auto rand_scores = CreateTensor(Shape({B, C, N}), DataType::FLOAT32);
+    float* pb = static_cast<float*>(boxes->GetData());
+    float* ps = static_cast<float*>(rand_scores->GetData());
+    for (int64_t i = 0; i < B * N; ++i) {
+        const float y = pos(rng), x = pos(rng), h = size(rng), w = size(rng);
+        const bool flip = unit(rng) < 0.5f;
+        pb[i * 4 + 0] = flip ? y + h : y;
+        pb[i * 4 + 1] = flip ? x + w : x;
+        pb[i * 4 + 2] = flip ? y : y + h;
+        pb[i * 4 + 3] = flip ? x : x + w;
+    }
+    for (int64_t i = 0; i < B * C * N; ++i) ps[i] = std::round(unit(rng) * 50.0f) / 50.0f;
+    auto reference_iou = [](const float* a, const float* b) {
+        const float ay1 = std::min(a[0], a[2]), ay2 = std::max(a[0], a[2]);
+        const float ax1 = std::min(a[1], a[3]), ax2 = std::max(a[1], a[3]);
+        const float by1 = std::min(b[0], b[2]), by2 = std::max(b[0], b[2]);
+        const float bx1 = std::min(b[1], b[3]), bx2 = std::max(b[1], b[3]);
+        const float h = std::max(0.0f, std::min(ay2, by2) - std::max(ay1, by1));
+        const float w = std::max(0.0f, std::min(ax2, bx2) - std::max(ax1, bx1));
+        const float inter = h * w;
+        const float uni = (ay2 - ay1) * (ax2 - ax1) + (by2 - by1) * (bx2 - bx1) - inter;
+        return uni > 0.0f ? inter / uni : 0.0f;
+    };
+    std::vector<int64_t> expected;
+    const float iou_threshold = 0.3f, score_threshold = 0.2f;
+    const int64_t limit = 20;
+    for (int64_t b = 0; b < B; ++b) {
+        for (int64_t c = 0; c < C; ++c) {
+            const float* s = ps + (b * C + c) * N;
+            std::vector<int64_t> order;
+            for (int64_t i = 0; i < N; ++i) {
+                if (s[i] > score_threshold) order.push_back(i);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](int64_t x, int64_t y) { return s[x] > s[y]; });
+            std::vector<int64_t> kept;
+            for (int64_t i : order) {
+                if (static_cast<int64_t>(kept.size()) == limit) break;
+                bool suppressed = false;
+                for (int64_t j : kept) {
+                    suppressed = suppressed || reference_iou(pb + (b * N + i) * 4, pb + (b * N + j) * 4) > iou_threshold;
+                }
+                if (!suppressed) {
+                    kept.push_back(i);
+                    expected.insert(expected.end(), {b, c, i});
+                }
+            }
+        }
+    }
+    *static_cast<int64_t*>(max_boxes->GetData()) = limit;
+    auto rand_iou = CreateTensor(Shape({1}), DataType::FLOAT32, {iou_threshold});
+    auto rand_score = CreateTensor(Shape({1}), DataType::FLOAT32, {score_threshold});
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) continue;
+        auto nms = registry.Create("NonMaxSuppression");
+        EXPECT_EQ(run(nms.get(), {boxes.get(), rand_scores.get(), max_boxes.get(), rand_iou.get(), rand_score.get()}),
+                  expected) << isa;
+    }
+    simd::SetSimdIsa("auto");
+}
+
+// LSTM/GRU：双向、sequence_lens、初始状态、peephole、clip与两种布局下与逐步按ONNX公式计算的参考一致；
+// 循环权重预打包与否结果相同
+TEST_F(OperatorsTest, RecurrentMatchesReference) {
+    auto& registry = OperatorRegistry::Instance();
+    const int64_t S = 4, B = 3, I = 3, H = 5, D = 2;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-0.8f, 0.8f);
+    auto random = [&](const Shape& shape) {
+        auto t = CreateTensor(shape, DataType::FLOAT32);
+        float* p = static_cast<float*>(t->GetData());
+        for (size_t i = 0; i < t->GetElementCount(); ++i) p[i] = dist(rng);
+        return t;
+    };
+    auto sigmoid = [](float x) { return 1.0f / (1.0f + std::exp(-x)); };
+    auto lengths = CreateTensor(Shape({B}), DataType::INT32);
+    const std::vector<int32_t> lens = {4, 2, 3};
+    std::memcpy(lengths->GetData(), lens.data(), sizeof(int32_t) * B);
+    
+    for (const char* op_type : {"LSTM", "GRU"}) {
+        const bool lstm = std::string(op_type) == "LSTM";
+        const int64_t G = (lstm ? 4 : 3) * H;
+        for (int variant = 0; variant < 4; ++variant) {
+            // variant的第0位：layout=1；第1位：lstm为peephole + clip，gru为linear_before_reset
+            const bool batch_first = (variant & 1) != 0;
+            const bool extra = (variant & 2) != 0;
+            auto x = random(batch_first ? Shape({B, S, I}) : Shape({S, B, I}));
+            auto w = random(Shape({D, G, I}));
+            auto r = random(Shape({D, G, H}));
+            auto bias = random(Shape({D, 2 * G}));
+            auto h0 = random(batch_first ? Shape({B, D, H}) : Shape({D, B, H}));
+            auto c0 = random(batch_first ? Shape({B, D, H}) : Shape({D, B, H}));
+            auto peephole = random(Shape({D, 3 * H}));
+            const float clip = 0.9f;
+            const float* px = static_cast<const float*>(x->GetData());
+            const float* pw = static_cast<const float*>(w->GetData());
+            const float* pr = static_cast<const float*>(r->GetData());
+            const float* pb = static_cast<const float*>(bias->GetData());
+            const float* pp = static_cast<const float*>(peephole->GetData());
+            auto state_at = [&](int64_t d, int64_t b) { return (batch_first ? b * D + d : d * B + b) * H; };
+            auto y_at = [&](int64_t t, int64_t d, int64_t b) {
+                return (batch_first ? (b * S + t) * D + d : (t * D + d) * B + b) * H;
+            };
+    
+            // 参考实现
+            std::vector<float> ref_y(S * D * B * H, 0.0f), ref_h(D * B * H), ref_c(D * B * H);
+            for (int64_t d = 0; d < D; ++d) {
+                for (int64_t b = 0; b < B; ++b) {
+                    std::vector<float> h(static_cast<const float*>(h0->GetData()) + state_at(d, b),
+                                         static_cast<const float*>(h0->GetData()) + state_at(d, b) + H);
+                    std::vector<float> c(static_cast<const float*>(c0->GetData()) + state_at(d, b),
+                                         static_cast<const float*>(c0->GetData()) + state_at(d, b) + H);
+                    for (int64_t s = 0; s < lens[b]; ++s) {
+                        const int64_t t = d == 0 ? s : lens[b] - 1 - s;
+                        const float* xt = px + (batch_first ? b * S + t : t * B + b) * I;
+                        // gate(g, j, hidden)：第g个门第j个元素的 x * W^T + Wb + hidden * R^T（+ Rb）
+                        auto gate = [&](int64_t g, int64_t j, const std::vector<float>& hidden, bool with_rb) {
+                            const int64_t row = g * H + j;
+                            float v = pb[d * 2 * G + row] + (with_rb ? pb[d * 2 * G + G + row] : 0.0f);
+                            for (int64_t k = 0; k < I; ++k) v += xt[k] * pw[(d * G + row) * I + k];
+                            for (int64_t k = 0; k < H; ++k) v += hidden[k] * pr[(d * G + row) * H + k];
+                            return v;
+                        };
+                        auto cl = [&](float v) { return extra ? std::min(std::max(v, -clip), clip) : v; };
+                        std::vector<float> next(H);
+                        if (lstm) {
+                            std::vector<float> c_next(H);
+                            for (int64_t j = 0; j < H; ++j) {
+                                const float pi = extra ? pp[d * 3 * H + j] : 0.0f;
+                                const float po = extra ? pp[d * 3 * H + H + j] : 0.0f;
+                                const float pf = extra ? pp[d * 3 * H + 2 * H + j] : 0.0f;
+                                const float it = sigmoid(cl(gate(0, j, h, true) + pi * c[j]));
+                                const float ft = sigmoid(cl(gate(2, j, h, true) + pf * c[j]));
+                                const float ct = std::tanh(cl(gate(3, j, h, true)));
+                                c_next[j] = ft * c[j] + it * ct;
+                                const float ot = sigmoid(cl(gate(1, j, h, true) + po * c_next[j]));
+                                next[j] = ot * std::tanh(c_next[j]);
+                            }
+                            c = c_next;
+                        } else {
+                            std::vector<float> z(H), rg(H), rh(H);
+                            for (int64_t j = 0; j < H; ++j) {
+                                z[j] = sigmoid(gate(0, j, h, true));
+                                rg[j] = sigmoid(gate(1, j, h, true));
+                                rh[j] = rg[j] * h[j];
+                            }
+                            for (int64_t j = 0; j < H; ++j) {
+                                float pre;
+                                if (extra) {
+                                    // linear_before_reset：Wbh + x * Wh^T + r * (h * Rh^T + Rbh)
+                                    const std::vector<float> zero(H, 0.0f);
+                                    float recurrent = pb[d * 2 * G + G + 2 * H + j];
+                                    for (int64_t k = 0; k < H; ++k) recurrent += h[k] * pr[(d * G + 2 * H + j) * H + k];
+                                    pre = gate(2, j, zero, false) + rg[j] * recurrent;
+                                } else {
+                                    pre = gate(2, j, rh, true);
+                                }
+                                next[j] = (1.0f - z[j]) * std::tanh(pre) + z[j] * h[j];
+                            }
+                        }
+                        h = next;
+                        std::copy(h.begin(), h.end(), ref_y.begin() + y_at(t, d, b));
+                    }
+                    std::copy(h.begin(), h.end(), ref_h.begin() + state_at(d, b));
+                    std::copy(c.begin(), c.end(), ref_c.begin() + state_at(d, b));
+                }
+            }
+    
+            for (bool prepack : {false, true}) {
+                auto op = registry.Create(op_type);
+                ASSERT_NE(op, nullptr);
+                op->SetAttribute("direction", AttributeValue(std::string("bidirectional")));
+                op->SetAttribute("hidden_size", AttributeValue(H));
+                op->SetAttribute("layout", AttributeValue(static_cast<int64_t>(batch_first ? 1 : 0)));
+                std::vector<Tensor*> inputs = {x.get(), w.get(), r.get(), bias.get(), lengths.get(), h0.get()};
+                if (lstm) {
+                    inputs.push_back(c0.get());
+                    if (extra) {
+                        inputs.push_back(peephole.get());
+                        op->SetAttribute("clip", AttributeValue(clip));
+                    }
+                } else if (extra) {
+                    op->SetAttribute("linear_before_reset", AttributeValue(static_cast<int64_t>(1)));
+                }
+                if (prepack) {
+                    bool packed = false;
+                    ASSERT_TRUE(op->PrePack(2, *r, {}, &packed).IsOk());
+                }
+                std::vector<Shape> shapes;
+                ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk());
+                ASSERT_EQ(shapes.size(), lstm ? 3u : 2u);
+                std::vector<std::shared_ptr<Tensor>> outputs;
+                std::vector<Tensor*> raw;
+                for (const Shape& shape : shapes) {
+                    outputs.push_back(CreateTensor(shape, DataType::FLOAT32));
+                    raw.push_back(outputs.back().get());
+                }
+                ASSERT_TRUE(op->Execute(inputs, raw, nullptr).IsOk());
+                const std::vector<const std::vector<float>*> expected = {&ref_y, &ref_h, &ref_c};
+                for (size_t o = 0; o < raw.size(); ++o) {
+                    const float* out = static_cast<const float*>(raw[o]->GetData());
+                    for (size_t i = 0; i < expected[o]->size(); ++i) {
+                        ASSERT_NEAR(out[i], (*expected[o])[i], 2e-4f)
+                            << op_type << " variant " << variant << " output " << o << " at " << i;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -3,10 +3,43 @@
 
 #include <gtest/gtest.h>
 #include "inferunity/engine.h"
+#include "inferunity/backend.h"
+#include "inferunity/collectives.h"
 #include "inferunity/graph.h"
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
+#include "inferunity/runtime.h"
+#include "inferunity/partitioner.h"
+#include "inferunity/perf_counters.h"
+#include "inferunity/kernel_tuning.h"
+#include "inferunity/memory.h"
+#include "inferunity/model_format.h"
+#include "inferunity/optimizer.h"
+#include "inferunity/quantization.h"
+#include "inferunity/shape_inference.h"
+#include "inferunity/tracing.h"
+#include "inferunity/logger.h"
+#include "inferunity/metrics.h"
+#include "inferunity/numa.h"
+#include "operators/simd_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
 #include <vector>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace inferunity;
 
@@ -194,3 +227,4212 @@ TEST_F(RuntimeTest, GraphOptimization) {
     // 注意：这需要访问内部图结构，简化测试
 }
 
+
+// 测试CPU执行提供者的内核缓存：重复执行同一节点、重新绑定输入后结果正确
+TEST_F(RuntimeTest, CPUProviderKernelCache) {
+    InitializeExecutionProviders();
+    auto provider = ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider");
+    ASSERT_NE(provider, nullptr);
+    
+    Graph graph;
+    Value* input = graph.AddValue();
+    Value* output = graph.AddValue();
+    Node* transpose = graph.AddNode("Transpose", "transpose1");
+    transpose->SetAttribute("perm", "0,2,1");
+    transpose->AddInput(input);
+    transpose->AddOutput(output);
+    graph.AddInput(input);
+    graph.AddOutput(output);
+    
+    auto out_tensor = CreateTensor(Shape({1, 3, 2}), DataType::FLOAT32, DeviceType::CPU);
+    output->SetTensor(out_tensor);
+    ASSERT_TRUE(provider->PrepareExecution(&graph).IsOk());
+    
+    for (int run = 0; run < 3; ++run) {
+        // 每次运行绑定新的输入张量，缓存的内核必须使用新指针
+        auto in_tensor = CreateTensor(Shape({1, 2, 3}), DataType::FLOAT32, DeviceType::CPU);
+        float* in_data = static_cast<float*>(in_tensor->GetData());
+        for (int i = 0; i < 6; ++i) {
+            in_data[i] = static_cast<float>(i + run * 10);
+        }
+        input->SetTensor(in_tensor);
+    
+        ExecutionContext ctx;
+        ASSERT_TRUE(provider->ExecuteNode(transpose, &ctx).IsOk());
+    
+        // perm=(0,2,1)：out[0][c][r] = in[0][r][c]
+        const float* out_data = static_cast<const float*>(out_tensor->GetData());
+        for (int r = 0; r < 2; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_FLOAT_EQ(out_data[c * 2 + r], in_data[r * 3 + c]);
+            }
+        }
+    }
+}
+
+// 测试工作窃取线程池：ParallelFor覆盖每个下标恰好一次，嵌套调用与WaitAll正常完成
+TEST_F(RuntimeTest, WorkStealingThreadPool) {
+    ThreadPoolOptions options;
+    options.num_threads = 4;
+    options.spin_iterations = 64;
+    ThreadPool::Configure(options);
+    ASSERT_EQ(ThreadPool::GetThreadCount(), 4u);
+    
+    std::vector<int> hits(10007, 0);
+    ThreadPool::ParallelFor(0, static_cast<int64_t>(hits.size()), 13,
+                            [&hits](int64_t begin, int64_t end) {
+                                for (int64_t i = begin; i < end; ++i) hits[i]++;
+                            });
+    for (int h : hits) {
+        ASSERT_EQ(h, 1);
+    }
+    
+    // 从线程池任务内部嵌套ParallelFor
+    std::atomic<int64_t> sum{0};
+    for (int t = 0; t < 16; ++t) {
+        ThreadPool::EnqueueTask([&sum]() {
+            ThreadPool::ParallelFor(0, 1000, 7, [&sum](int64_t begin, int64_t end) {
+                int64_t local = 0;
+                for (int64_t i = begin; i < end; ++i) local += i;
+                sum.fetch_add(local);
+            });
+        });
+    }
+    ThreadPool::WaitAll();
+    EXPECT_EQ(sum.load(), 16 * (999 * 1000 / 2));
+    EXPECT_EQ(ThreadPool::GetPendingTaskCount(), 0u);
+    
+    // 空区间与单块区间在调用线程内直接执行
+    int calls = 0;
+    ThreadPool::ParallelFor(5, 5, 1, [&calls](int64_t, int64_t) { calls++; });
+    ThreadPool::ParallelFor(0, 3, 8, [&calls](int64_t begin, int64_t end) {
+        EXPECT_EQ(begin, 0);
+        EXPECT_EQ(end, 3);
+        calls++;
+    });
+    EXPECT_EQ(calls, 1);
+    
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试突发模式：作用域内ParallelFor结果不变，caller_runs_first时第一块在调用线程执行，作用域可嵌套
+TEST_F(RuntimeTest, ThreadPoolBurstMode) {
+    ThreadPoolOptions options;
+    options.num_threads = 4;
+    options.spin_iterations = 16;
+    ThreadPool::Configure(options);
+    
+    const std::thread::id caller = std::this_thread::get_id();
+    {
+        ThreadPoolBurst burst(200, true);
+        for (int round = 0; round < 50; ++round) {
+            std::vector<int> hits(4096, 0);
+            std::atomic<bool> first_on_caller{false};
+            ThreadPool::ParallelFor(0, static_cast<int64_t>(hits.size()), 64,
+                                    [&](int64_t begin, int64_t end) {
+                                        if (begin == 0) {
+                                            first_on_caller = std::this_thread::get_id() == caller;
+                                        }
+                                        for (int64_t i = begin; i < end; ++i) hits[i]++;
+                                    });
+            ASSERT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<int64_t>(hits.size()));
+            ASSERT_TRUE(first_on_caller.load());
+        }
+        {
+            // 嵌套的作用域结束后外层仍然有效
+            ThreadPoolBurst inner(50);
+            std::atomic<int64_t> sum{0};
+            ThreadPool::ParallelFor(0, 1000, 10, [&sum](int64_t begin, int64_t end) {
+                for (int64_t i = begin; i < end; ++i) sum.fetch_add(i);
+            });
+            EXPECT_EQ(sum.load(), 999 * 1000 / 2);
+        }
+    }
+    
+    // 会话选项：Run期间进入突发模式，结果与普通模式相同
+    SessionOptions session_options;
+    session_options.thread_pool_burst_spin_us = 100;
+    session_options.run_first_task_on_caller = true;
+    auto session = InferenceSession::Create(session_options);
+    ASSERT_NE(session, nullptr);
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({64, 1024}), DataType::FLOAT32));
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    auto x = CreateTensor(Shape({64, 1024}), DataType::FLOAT32);
+    float* x_data = static_cast<float*>(x->GetData());
+    for (int i = 0; i < 64 * 1024; ++i) {
+        x_data[i] = static_cast<float>(i % 7) - 3.0f;
+    }
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* y = static_cast<const float*>(outputs[0]->GetData());
+    for (int i = 0; i < 64 * 1024; ++i) {
+        ASSERT_FLOAT_EQ(y[i], std::max(x_data[i], 0.0f));
+    }
+    
+    session.reset();
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试独立的intra-op/inter-op线程池：作用域内的并行循环与任务分别进入给定的池，任务继承提交时的设置，
+// 池可以Resize；会话可以使用私有的池或与其他会话共享同一个池
+TEST_F(RuntimeTest, SeparateIntraInterOpThreadPools) {
+    ThreadPoolOptions intra_options;
+    intra_options.num_threads = 3;
+    auto intra_pool = ThreadPoolInstance::Create(intra_options);
+    ThreadPoolOptions inter_options;
+    inter_options.num_threads = 2;
+    auto inter_pool = ThreadPoolInstance::Create(inter_options);
+    const size_t global_threads = ThreadPool::GetThreadCount();
+    {
+        ThreadPoolScope scope(intra_pool, inter_pool);
+        EXPECT_EQ(ThreadPool::GetThreadCount(), 3u);
+        EXPECT_EQ(ThreadPool::GetInterOpThreadCount(), 2u);
+    
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        std::atomic<int64_t> sum{0};
+        ThreadPool::ParallelFor(0, 4096, 16, [&](int64_t begin, int64_t end) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            for (int64_t i = begin; i < end; ++i) sum.fetch_add(i);
+        });
+        EXPECT_EQ(sum.load(), 4095 * 4096 / 2);
+        EXPECT_LE(threads.size(), 4u);  // 3个工作线程加调用线程
+    
+        // 任务在inter-op池上执行，其中的并行循环仍使用intra-op池
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<size_t> task_intra_threads{0};
+        std::atomic<bool> task_on_worker{false};
+        ThreadPool::EnqueueTask([&]() {
+            task_intra_threads = ThreadPool::GetThreadCount();
+            task_on_worker = std::this_thread::get_id() != caller;
+        });
+        ThreadPool::WaitAll();
+        EXPECT_EQ(task_intra_threads.load(), 3u);
+        EXPECT_TRUE(task_on_worker.load());
+    
+        {
+            // 内层作用域只替换intra-op池
+            ThreadPoolOptions nested_options;
+            nested_options.num_threads = 1;
+            auto nested = ThreadPoolInstance::Create(nested_options);
+            ThreadPoolScope inner(nested, nullptr);
+            EXPECT_EQ(ThreadPool::GetThreadCount(), 1u);
+            EXPECT_EQ(ThreadPool::GetInterOpThreadCount(), 2u);
+        }
+        EXPECT_EQ(ThreadPool::GetThreadCount(), 3u);
+    }
+    EXPECT_EQ(ThreadPool::GetThreadCount(), global_threads);
+    
+    intra_pool->Resize(5);
+    EXPECT_EQ(intra_pool->GetThreadCount(), 5u);
+    {
+        ThreadPoolScope scope(intra_pool, nullptr);
+        EXPECT_EQ(ThreadPool::GetThreadCount(), 5u);
+        EXPECT_EQ(ThreadPool::GetInterOpThreadCount(), global_threads);
+    }
+    
+    auto make_relu_graph = []() {
+        auto graph = std::make_unique<Graph>();
+        Value* input = graph->AddValue();
+        Value* output = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(input);
+        relu->AddOutput(output);
+        graph->AddInput(input);
+        graph->AddOutput(output);
+        input->SetTensor(CreateTensor(Shape({64, 1024}), DataType::FLOAT32));
+        return graph;
+    };
+    auto x = CreateTensor(Shape({64, 1024}), DataType::FLOAT32);
+    float* x_data = static_cast<float*>(x->GetData());
+    for (int i = 0; i < 64 * 1024; ++i) {
+        x_data[i] = static_cast<float>(i % 5) - 2.0f;
+    }
+    auto check_run = [&](InferenceSession* session) {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* y = static_cast<const float*>(outputs[0]->GetData());
+        for (int i = 0; i < 64 * 1024; ++i) {
+            ASSERT_FLOAT_EQ(y[i], std::max(x_data[i], 0.0f));
+        }
+        RunResult result = session->RunAsync({x}).get();
+        ASSERT_TRUE(result.status.IsOk());
+        ASSERT_EQ(result.outputs.size(), 1u);
+    };
+    
+    // 会话私有的池
+    SessionOptions private_options;
+    private_options.use_per_session_threads = true;
+    private_options.intra_op_pool_size = 2;
+    private_options.inter_op_pool_size = 1;
+    auto private_session = InferenceSession::Create(private_options);
+    ASSERT_NE(private_session, nullptr);
+    ASSERT_NE(private_session->GetIntraOpThreadPool(), nullptr);
+    EXPECT_EQ(private_session->GetIntraOpThreadPool()->GetThreadCount(), 2u);
+    EXPECT_EQ(private_session->GetInterOpThreadPool()->GetThreadCount(), 1u);
+    ASSERT_TRUE(private_session->LoadModelFromGraph(make_relu_graph()).IsOk());
+    check_run(private_session.get());
+    
+    // 两个会话显式共享intra-op池，Resize后两者都使用新的线程数
+    SessionOptions shared_options;
+    shared_options.intra_op_thread_pool = intra_pool;
+    auto first = InferenceSession::Create(shared_options);
+    auto second = InferenceSession::Create(shared_options);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(first->GetIntraOpThreadPool(), second->GetIntraOpThreadPool());
+    EXPECT_EQ(first->GetInterOpThreadPool(), nullptr);
+    ASSERT_TRUE(first->LoadModelFromGraph(make_relu_graph()).IsOk());
+    ASSERT_TRUE(second->LoadModelFromGraph(make_relu_graph()).IsOk());
+    check_run(first.get());
+    intra_pool->Resize(2);
+    check_run(second.get());
+    EXPECT_EQ(second->GetIntraOpThreadPool()->GetThreadCount(), 2u);
+}
+
+#ifndef _WIN32
+// 测试预fork服务：父进程加载并预热会话后fork，子进程中全局线程池与会话私有的池都重新启动，
+// 并行循环与推理结果正确；fork之后父进程的线程池照常工作
+TEST_F(RuntimeTest, PreforkWorkersShareWarmSession) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    input->SetTensor(CreateTensor(Shape({16, 256}), DataType::FLOAT32));
+    SessionOptions options;
+    options.use_per_session_threads = true;
+    options.intra_op_pool_size = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_TRUE(session->Warmup().IsOk());
+    auto x = CreateTensor(Shape({16, 256}), DataType::FLOAT32);
+    float* x_data = static_cast<float*>(x->GetData());
+    for (int i = 0; i < 16 * 256; ++i) {
+        x_data[i] = static_cast<float>(i % 7) - 3.0f;
+    }
+    auto parallel_sum = []() {
+        std::atomic<int64_t> sum{0};
+        ThreadPool::ParallelFor(0, 4096, 16, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) sum.fetch_add(i);
+        });
+        return sum.load();
+    };
+    ASSERT_EQ(parallel_sum(), 4095 * 4096 / 2);
+    
+    std::vector<int> pids;
+    ASSERT_TRUE(ForkWorkers(2, [&](size_t) {
+        if (parallel_sum() != 4095 * 4096 / 2 || ThreadPool::GetThreadCount() == 0) {
+            return 2;
+        }
+        void* block = AllocateMemory(4096, 64);
+        FreeMemory(block);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        if (!session->Run({x.get()}, outputs).IsOk() || outputs.size() != 1) {
+            return 3;
+        }
+        const float* y = static_cast<const float*>(outputs[0]->GetData());
+        for (int i = 0; i < 16 * 256; ++i) {
+            if (y[i] != std::max(x_data[i], 0.0f)) {
+                return 4;
+            }
+        }
+        LOG_INFO("Prefork worker finished");
+        return 0;
+    }, &pids).IsOk());
+    ASSERT_EQ(pids.size(), 2u);
+    for (int pid : pids) {
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+    
+    EXPECT_EQ(parallel_sum(), 4095 * 4096 / 2);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    EXPECT_TRUE(session->Run({x.get()}, outputs).IsOk());
+}
+#endif
+
+// 测试NUMA感知：拓扑覆盖可用CPU，节点作用域可嵌套恢复，分组线程池与绑定节点的会话结果不变
+TEST_F(RuntimeTest, NumaAwareExecution) {
+    const NumaTopology& topology = GetNumaTopology();
+    ASSERT_GE(topology.nodes.size(), 1u);
+    for (const NumaNode& node : topology.nodes) {
+        EXPECT_FALSE(node.cpus.empty());
+    }
+    
+    EXPECT_EQ(GetCurrentNumaNode(), -1);
+    {
+        NumaNodeScope outer(0);
+        EXPECT_EQ(GetCurrentNumaNode(), 0);
+        {
+            // 不存在的节点不改变首选节点
+            NumaNodeScope missing(static_cast<int>(topology.nodes.size()));
+            EXPECT_EQ(GetCurrentNumaNode(), 0);
+        }
+        EXPECT_EQ(GetCurrentNumaNode(), 0);
+    }
+    EXPECT_EQ(GetCurrentNumaNode(), -1);
+    
+    // 节点池中分配的块释放后回到原来的槽，未绑定的线程照常复用
+    void* block = nullptr;
+    {
+        NumaNodeScope scope(0);
+        block = AllocateMemory(256 * 1024, 64);
+        ASSERT_NE(block, nullptr);
+    }
+    std::memset(block, 1, 256 * 1024);
+    FreeMemory(block);
+    
+    ThreadPoolOptions options;
+    options.num_threads = 4;
+    options.numa_aware = true;
+    ThreadPool::Configure(options);
+    const size_t expected_groups = topology.nodes.size() > 1 && topology.nodes.size() <= 4
+        ? topology.nodes.size() : 1;
+    EXPECT_EQ(ThreadPool::GetNumaGroupCount(), expected_groups);
+    EXPECT_EQ(ThreadPool::GetAvailableThreadCount(), 4u);
+    for (int node = -1; node < static_cast<int>(topology.nodes.size()); ++node) {
+        NumaNodeScope scope(node);
+        EXPECT_LE(ThreadPool::GetAvailableThreadCount(), 4u);
+        std::vector<int> hits(4099, 0);
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(hits.size()), 11,
+                                [&hits](int64_t begin, int64_t end) {
+                                    for (int64_t i = begin; i < end; ++i) hits[i]++;
+                                });
+        EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<int64_t>(hits.size()));
+    
+        std::atomic<int> tasks{0};
+        for (int t = 0; t < 8; ++t) {
+            ThreadPool::EnqueueTask([&tasks]() { tasks.fetch_add(1); });
+        }
+        ThreadPool::WaitAll();
+        EXPECT_EQ(tasks.load(), 8);
+    }
+    
+    auto make_graph = [](std::shared_ptr<Tensor>* weight_tensor) {
+        auto graph = std::make_unique<Graph>();
+        Value* input = graph->AddValue();
+        Value* weight = graph->AddValue();
+        Value* hidden = graph->AddValue();
+        Value* output = graph->AddValue();
+        auto w = CreateTensor(Shape({16, 16}), DataType::FLOAT32);
+        float* w_data = static_cast<float*>(w->GetData());
+        for (int i = 0; i < 256; ++i) w_data[i] = static_cast<float>(i % 5 - 2) * 0.25f;
+        weight->SetTensor(w);
+        *weight_tensor = w;
+        Node* matmul = graph->AddNode("MatMul", "matmul");
+        matmul->AddInput(input);
+        matmul->AddInput(weight);
+        matmul->AddOutput(hidden);
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(hidden);
+        relu->AddOutput(output);
+        graph->AddInput(input);
+        graph->AddOutput(output);
+        return graph;
+    };
+    auto input = CreateTensor(Shape({4, 16}), DataType::FLOAT32);
+    float* in = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 64; ++i) in[i] = static_cast<float>(i % 9) * 0.1f - 0.3f;
+    
+    std::vector<std::vector<float>> results;
+    for (int bound = 0; bound < 2; ++bound) {
+        SessionOptions session_options;
+        session_options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+        session_options.numa_node = bound ? 0 : -1;
+        session_options.numa_replicate_weights = bound != 0;
+        auto session = InferenceSession::Create(session_options);
+        ASSERT_NE(session, nullptr);
+        std::shared_ptr<Tensor> original;
+        ASSERT_TRUE(session->LoadModelFromGraph(make_graph(&original)).IsOk());
+        // 复制到节点本地后常量不再指向原来的张量
+        bool replaced = true;
+        for (const auto& value : session->GetGraph()->GetValues()) {
+            if (!value->GetProducer() && value->GetTensor() == original) {
+                replaced = false;
+            }
+        }
+        EXPECT_EQ(replaced, bound != 0);
+    
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(out, out + 64);
+    
+        RunResult async = session->RunAsync({input}).get();
+        ASSERT_TRUE(async.status.IsOk()) << async.status.Message();
+        ASSERT_EQ(async.outputs.size(), 1u);
+        const float* async_out = static_cast<const float*>(async.outputs[0]->GetData());
+        EXPECT_EQ(std::vector<float>(async_out, async_out + 64), results.back());
+    }
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(GetCurrentNumaNode(), -1);
+    
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试混合架构调度：拓扑覆盖可用CPU且最快核算力为1024；只用性能核的池线程数等于性能核数，
+// 同构核上块数不放大，混合架构上块数不少于线程数；只用性能核的会话结果不变
+TEST_F(RuntimeTest, HybridCoreScheduling) {
+    const CpuCoreTopology& topology = GetCpuCoreTopology();
+    ASSERT_FALSE(topology.cores.empty());
+    int max_capacity = 0;
+    bool has_efficiency = false;
+    for (const CpuCore& core : topology.cores) {
+        EXPECT_GT(core.capacity, 0);
+        EXPECT_LE(core.capacity, 1024);
+        max_capacity = std::max(max_capacity, core.capacity);
+        has_efficiency = has_efficiency || core.type == CoreType::EFFICIENCY;
+    }
+    EXPECT_EQ(max_capacity, 1024);
+    EXPECT_EQ(topology.hybrid, has_efficiency);
+    EXPECT_FALSE(topology.PerformanceCpus().empty());
+    
+    ThreadPoolOptions options;
+    options.performance_cores_only = true;
+    auto pool = ThreadPoolInstance::Create(options);
+    if (topology.hybrid) {
+        EXPECT_EQ(pool->GetThreadCount(), topology.PerformanceCpus().size());
+    }
+    {
+        ThreadPoolScope scope(pool, nullptr);
+        const size_t threads = ThreadPool::GetThreadCount();
+        const size_t chunks = ThreadPool::GetBalancedChunkCount(threads);
+        EXPECT_GE(chunks, threads);
+        std::vector<int> hits(4099, 0);
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(hits.size()), 7,
+                                [&hits](int64_t begin, int64_t end) {
+                                    for (int64_t i = begin; i < end; ++i) hits[i]++;
+                                });
+        EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), static_cast<int64_t>(hits.size()));
+    }
+    if (!topology.hybrid) {
+        EXPECT_EQ(ThreadPool::GetBalancedChunkCount(4), 4u);
+    }
+    
+    auto make_graph = []() {
+        auto graph = std::make_unique<Graph>();
+        Value* input = graph->AddValue();
+        Value* output = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(input);
+        relu->AddOutput(output);
+        graph->AddInput(input);
+        graph->AddOutput(output);
+        return graph;
+    };
+    auto input = CreateTensor(Shape({64, 1024}), DataType::FLOAT32);
+    float* in = static_cast<float*>(input->GetData());
+    for (int i = 0; i < 64 * 1024; ++i) in[i] = static_cast<float>(i % 7) - 3.0f;
+    SessionOptions session_options;
+    session_options.performance_cores_only = true;
+    auto session = InferenceSession::Create(session_options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(make_graph()).IsOk());
+    EXPECT_EQ(session->GetIntraOpThreadPool() != nullptr, topology.hybrid);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* out = static_cast<const float*>(outputs[0]->GetData());
+    for (int i = 0; i < 64 * 1024; ++i) {
+        ASSERT_EQ(out[i], std::max(in[i], 0.0f));
+    }
+}
+
+// 测试大页：区域按2MB对齐并计入统计，小区域与NONE策略不使用大页；会话的arena与大权重放在大页上后结果不变
+TEST_F(RuntimeTest, HugePageBacking) {
+    EXPECT_EQ(HugePageRegion::Allocate(kHugePageSize / 2, HugePagePolicy::TRANSPARENT), nullptr);
+    EXPECT_EQ(HugePageRegion::Allocate(4 * kHugePageSize, HugePagePolicy::NONE), nullptr);
+    auto mapped_bytes = [](const HugePageStats& stats) {
+        return stats.hugetlb_1gb_bytes + stats.hugetlb_2mb_bytes + stats.transparent_bytes + stats.fallback_bytes;
+    };
+    const size_t before = mapped_bytes(GetHugePageStats());
+    for (HugePagePolicy policy : {HugePagePolicy::TRANSPARENT, HugePagePolicy::HUGETLB_2MB}) {
+        auto region = HugePageRegion::Allocate(kHugePageSize + 1, policy);
+        ASSERT_NE(region, nullptr) << HugePagePolicyName(policy);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(region->GetData()) % kHugePageSize, 0u);
+        EXPECT_GE(region->GetSize(), kHugePageSize + 1);
+        std::memset(region->GetData(), 1, region->GetSize());
+        EXPECT_EQ(mapped_bytes(GetHugePageStats()), before + region->GetSize());
+    }
+    EXPECT_EQ(mapped_bytes(GetHugePageStats()), before);
+    
+    auto arena = MemoryArena::Create(3 * kHugePageSize, 64, nullptr, HugePagePolicy::TRANSPARENT);
+    ASSERT_NE(arena, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(arena->GetBase()) % kHugePageSize, 0u);
+    EXPECT_EQ(MemoryArena::Create(1024, 64, nullptr, HugePagePolicy::TRANSPARENT)->GetBacking(),
+              HugePageBacking::NORMAL);
+    arena.reset();
+    
+    // input + W -> Relu -> Sigmoid，W与两个中间张量各4MB
+    const int64_t rows = 1024, cols = 1024;
+    auto make_graph = [rows, cols]() {
+        auto graph = std::make_unique<Graph>();
+        Value* input = graph->AddValue();
+        Value* weight = graph->AddValue();
+        Value* sum = graph->AddValue();
+        Value* hidden = graph->AddValue();
+        Value* output = graph->AddValue();
+        // 只有形状的输入张量，内存规划据此求出中间张量的大小
+        input->SetTensor(std::make_shared<Tensor>(Shape({rows, cols}), DataType::FLOAT32, nullptr));
+        auto w = CreateTensor(Shape({rows, cols}), DataType::FLOAT32);
+        float* w_data = static_cast<float*>(w->GetData());
+        for (int64_t i = 0; i < rows * cols; ++i) w_data[i] = static_cast<float>(i % 13 - 6) * 0.1f;
+        weight->SetTensor(w);
+        Node* add = graph->AddNode("Add", "add");
+        add->AddInput(input);
+        add->AddInput(weight);
+        add->AddOutput(sum);
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(sum);
+        relu->AddOutput(hidden);
+        Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid");
+        sigmoid->AddInput(hidden);
+        sigmoid->AddOutput(output);
+        graph->AddInput(input);
+        graph->AddOutput(output);
+        return graph;
+    };
+    auto input = CreateTensor(Shape({rows, cols}), DataType::FLOAT32);
+    float* in = static_cast<float*>(input->GetData());
+    for (int64_t i = 0; i < rows * cols; ++i) in[i] = static_cast<float>(i % 7 - 3) * 0.2f;
+    
+    std::vector<std::vector<float>> results;
+    for (HugePagePolicy policy : {HugePagePolicy::NONE, HugePagePolicy::TRANSPARENT, HugePagePolicy::HUGETLB_2MB}) {
+        SessionOptions options;
+        options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+        options.huge_page_policy = policy;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        const size_t loaded_before = mapped_bytes(GetHugePageStats());
+        ASSERT_TRUE(session->LoadModelFromGraph(make_graph()).IsOk());
+        const size_t loaded = mapped_bytes(GetHugePageStats()) - loaded_before;
+        // 串行arena至少容纳一个4MB中间张量；HUGETLB策略下权重复制进大页区域
+        if (policy == HugePagePolicy::NONE) {
+            EXPECT_EQ(loaded, 0u);
+        } else if (policy == HugePagePolicy::TRANSPARENT) {
+            EXPECT_GE(loaded, static_cast<size_t>(rows * cols * sizeof(float)));
+        } else {
+            EXPECT_GE(loaded, static_cast<size_t>(2 * rows * cols * sizeof(float)));
+        }
+    
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(out, out + rows * cols);
+    }
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(results[0], results[2]);
+}
+
+// 测试权重流式驻留：映射文件中的权重按执行顺序预取与回收，已预取未回收的字节不超过预算，结果与常驻时一致
+TEST_F(RuntimeTest, WeightStreaming) {
+    const int64_t layers = 6, rows = 16, cols = 256;
+    const size_t weight_bytes = static_cast<size_t>(rows * cols) * sizeof(float);
+    const std::string path = ::testing::TempDir() + "inferunity_streamed_weights.bin";
+    {
+        std::vector<float> data(static_cast<size_t>(layers * rows * cols));
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<float>(i % 11) * 0.125f;
+        }
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+    }
+    std::shared_ptr<MappedFile> mapped;
+    ASSERT_TRUE(MappedFile::Open(path, &mapped).IsOk());
+    
+    // x -> Add(W0) -> Add(W1) -> ... ，W_i是映射文件的视图
+    auto make_graph = [&]() {
+        auto graph = std::make_unique<Graph>();
+        Value* input = graph->AddValue();
+        input->SetTensor(std::make_shared<Tensor>(Shape({rows, cols}), DataType::FLOAT32, nullptr));
+        graph->AddInput(input);
+        Value* hidden = input;
+        for (int64_t i = 0; i < layers; ++i) {
+            Value* weight = graph->AddValue();
+            float* data = reinterpret_cast<float*>(const_cast<uint8_t*>(mapped->GetData())) + i * rows * cols;
+            weight->SetTensor(std::make_shared<Tensor>(Shape({rows, cols}), DataType::FLOAT32, data));
+            Value* output = graph->AddValue();
+            Node* add = graph->AddNode("Add", "add" + std::to_string(i));
+            add->AddInput(hidden);
+            add->AddInput(weight);
+            add->AddOutput(output);
+            hidden = output;
+        }
+        graph->AddOutput(hidden);
+        return graph;
+    };
+    auto input = CreateTensor(Shape({rows, cols}), DataType::FLOAT32);
+    float* in = static_cast<float*>(input->GetData());
+    for (int64_t i = 0; i < rows * cols; ++i) in[i] = static_cast<float>(i % 5) - 2.0f;
+    
+    std::vector<std::vector<float>> results;
+    for (size_t budget : {size_t(0), 2 * weight_bytes}) {
+        SessionOptions options;
+        options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+        options.weight_streaming_budget = budget;
+        options.weight_streaming_lookahead = 4;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(make_graph()).IsOk());
+        const WeightStreamingSchedule* schedule = session->GetWeightStreamingSchedule();
+        if (budget == 0) {
+            EXPECT_EQ(schedule, nullptr);
+        } else {
+            ASSERT_NE(schedule, nullptr);
+            EXPECT_EQ(schedule->GetTotalBytes(), layers * weight_bytes);
+            // 按顺序走一遍窗口：预取不超过预算，最后全部回收
+            const ExecutionPlan* plan = session->GetExecutionPlan();
+            WeightStreamingWindow window(schedule, *plan, 0, plan->GetSteps().size());
+            for (size_t step = 0; step < plan->GetSteps().size(); ++step) {
+                window.BeforeStep(step);
+                EXPECT_GE(window.GetResidentBytes(), weight_bytes);
+                window.AfterStep(step);
+            }
+            EXPECT_EQ(window.GetPeakResidentBytes(), budget);
+            EXPECT_EQ(window.GetResidentBytes(), 0u);
+        }
+        for (int run = 0; run < 2; ++run) {
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+            ASSERT_EQ(outputs.size(), 1u);
+            const float* out = static_cast<const float*>(outputs[0]->GetData());
+            results.emplace_back(out, out + rows * cols);
+        }
+    }
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(results[0], results[2]);
+    EXPECT_EQ(results[0], results[3]);
+    const float* weights = reinterpret_cast<const float*>(mapped->GetData());
+    for (int64_t i = 0; i < rows * cols; i += 97) {
+        float expected = in[i];
+        for (int64_t l = 0; l < layers; ++l) {
+            expected += weights[l * rows * cols + i];
+        }
+        EXPECT_FLOAT_EQ(results[2][i], expected);
+    }
+    mapped.reset();
+    std::remove(path.c_str());
+}
+
+// 测试跨节点的权重预取：启用时结果不变，辅助线程预取推进点之后lookahead个步骤的常量
+TEST_F(RuntimeTest, WeightPrefetchAcrossNodes) {
+    const int64_t layers = 4, size = 1024;
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    input->SetTensor(std::make_shared<Tensor>(Shape({size}), DataType::FLOAT32, nullptr));
+    graph->AddInput(input);
+    Value* hidden = input;
+    for (int64_t i = 0; i < layers; ++i) {
+        Value* weight = graph->AddValue();
+        auto w = CreateTensor(Shape({size}), DataType::FLOAT32);
+        std::fill_n(static_cast<float*>(w->GetData()), size, static_cast<float>(i + 1));
+        weight->SetTensor(w);
+        Value* output = graph->AddValue();
+        Node* mul = graph->AddNode("Mul", "mul" + std::to_string(i));
+        mul->AddInput(hidden);
+        mul->AddInput(weight);
+        mul->AddOutput(output);
+        hidden = output;
+    }
+    graph->AddOutput(hidden);
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.weight_prefetch_lookahead = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_NE(session->GetWeightPrefetcher(), nullptr);
+    
+    auto x = CreateTensor(Shape({size}), DataType::FLOAT32);
+    std::fill_n(static_cast<float*>(x->GetData()), size, 0.5f);
+    for (int run = 0; run < 3; ++run) {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        for (int64_t i = 0; i < size; ++i) {
+            ASSERT_FLOAT_EQ(out[i], 0.5f * 24.0f);
+        }
+    }
+    // 执行很快时辅助线程跳过已被越过的步骤；单独推进一次，等它预取完之后的lookahead个步骤
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    WeightPrefetchOptions prefetch_options;
+    prefetch_options.lookahead_steps = 2;
+    WeightPrefetcher prefetcher(*plan, prefetch_options);
+    prefetcher.Advance(*plan, 0);
+    for (int wait = 0; wait < 1000 && prefetcher.GetPrefetchedSteps() < 2; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(prefetcher.GetPrefetchedSteps(), 2u);
+    EXPECT_EQ(prefetcher.GetPrefetchedBytes(), 2 * size * sizeof(float));
+}
+
+// 测试DAG并行调度：权重输入不计入依赖，多分支图结果正确，计划在多次调用间复用
+
+// 结果缓存：相同输入命中时不执行图，返回的副本可以修改；容量按最久未用淘汰，TTL过期后重新执行
+TEST_F(RuntimeTest, ResultCache) {
+    // XXH64的公开测试向量（覆盖短输入与32字节分组的路径）
+    EXPECT_EQ(XXHash64("", 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(XXHash64("abc", 3), 0x44BC2CF5AD770999ULL);
+    const std::string text = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(XXHash64(text.data(), text.size()), 0xFBCEA83C8A378BF1ULL);
+    
+    const int64_t size = 256;
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    input->SetTensor(std::make_shared<Tensor>(Shape({size}), DataType::FLOAT32, nullptr));
+    graph->AddInput(input);
+    Value* weight = graph->AddValue();
+    auto w = CreateTensor(Shape({size}), DataType::FLOAT32);
+    std::fill_n(static_cast<float*>(w->GetData()), size, 2.0f);
+    weight->SetTensor(w);
+    Value* output = graph->AddValue();
+    Node* mul = graph->AddNode("Mul", "mul");
+    mul->AddInput(input);
+    mul->AddInput(weight);
+    mul->AddOutput(output);
+    graph->AddOutput(output);
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.result_cache_bytes = 2 * size * sizeof(float);  // 两个条目
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ResultCache* cache = session->GetResultCache();
+    ASSERT_NE(cache, nullptr);
+    
+    std::vector<std::shared_ptr<Tensor>> inputs;
+    for (int i = 0; i < 3; ++i) {
+        inputs.push_back(CreateTensor(Shape({size}), DataType::FLOAT32));
+        std::fill_n(static_cast<float*>(inputs.back()->GetData()), size, static_cast<float>(i + 1));
+    }
+    auto run = [&](int i, float expected) {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({inputs[i].get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        float* out = static_cast<float*>(outputs[0]->GetData());
+        for (int64_t k = 0; k < size; ++k) {
+            ASSERT_FLOAT_EQ(out[k], expected);
+        }
+        out[0] = -1.0f;  // 修改返回的副本不影响缓存
+    };
+    run(0, 2.0f);
+    run(0, 2.0f);
+    ResultCacheStats stats = cache->GetStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    
+    // 第三个不同的输入淘汰最久未用的输入0
+    run(1, 4.0f);
+    run(2, 6.0f);
+    stats = cache->GetStats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(stats.bytes, static_cast<size_t>(2 * size * sizeof(float)));
+    run(1, 4.0f);
+    run(0, 2.0f);
+    stats = cache->GetStats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_DOUBLE_EQ(stats.GetHitRate(), 2.0 / 6.0);
+    
+    // 过期的条目不再命中
+    ResultCacheOptions short_lived;
+    short_lived.ttl_ms = 1.0;
+    ResultCache expiring(short_lived);
+    uint64_t key = 0;
+    ASSERT_TRUE(ResultCache::ComputeKey({inputs[0].get()}, &key));
+    expiring.Insert(key, {inputs[0]});
+    std::vector<std::shared_ptr<Tensor>> cached;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(expiring.Lookup(key, &cached));
+    EXPECT_EQ(expiring.GetStats().expirations, 1u);
+    EXPECT_EQ(expiring.GetStats().entries, 0u);
+}
+
+TEST_F(RuntimeTest, OutputBufferRecycling) {
+    const int64_t size = 256;
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    input->SetTensor(std::make_shared<Tensor>(Shape({size}), DataType::FLOAT32, nullptr));
+    graph->AddInput(input);
+    Value* weight = graph->AddValue();
+    auto w = CreateTensor(Shape({size}), DataType::FLOAT32);
+    std::fill_n(static_cast<float*>(w->GetData()), size, 2.0f);
+    weight->SetTensor(w);
+    Value* output = graph->AddValue();
+    Node* mul = graph->AddNode("Mul", "mul");
+    mul->AddInput(input);
+    mul->AddInput(weight);
+    mul->AddOutput(output);
+    graph->AddOutput(output);
+
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.output_buffer_pool_size = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_TRUE(session->SupportsConcurrentRun());
+    const OutputBufferPool* pool = session->GetOutputBufferPool();
+    ASSERT_NE(pool, nullptr);
+
+    auto x = CreateTensor(Shape({size}), DataType::FLOAT32);
+    auto run = [&](float value, std::vector<std::shared_ptr<Tensor>>* outputs) {
+        std::fill_n(static_cast<float*>(x->GetData()), size, value);
+        ASSERT_TRUE(session->Run({x.get()}, *outputs).IsOk());
+        ASSERT_EQ(outputs->size(), 1u);
+        const float* out = static_cast<const float*>((*outputs)[0]->GetData());
+        for (int64_t k = 0; k < size; ++k) {
+            ASSERT_FLOAT_EQ(out[k], 2.0f * value);
+        }
+    };
+
+    // 释放句柄后缓冲回到池中，下一次运行直接写入同一块内存
+    std::vector<std::shared_ptr<Tensor>> first;
+    run(1.0f, &first);
+    const void* first_data = first[0]->GetData();
+    first.clear();
+    EXPECT_EQ(pool->GetStats().returned, 1u);
+    EXPECT_EQ(pool->GetStats().free_buffers, 1u);
+    std::vector<std::shared_ptr<Tensor>> second;
+    run(3.0f, &second);
+    EXPECT_EQ(second[0]->GetData(), first_data);
+    EXPECT_EQ(pool->GetStats().reused, 1u);
+    EXPECT_EQ(pool->GetStats().free_buffers, 0u);
+
+    // 调用方仍持有的输出不会被之后的运行覆盖
+    std::vector<std::shared_ptr<Tensor>> third;
+    run(5.0f, &third);
+    EXPECT_NE(third[0]->GetData(), second[0]->GetData());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(second[0]->GetData())[0], 6.0f);
+
+    // 并发的运行各自持有独占的输出
+    std::vector<std::thread> threads;
+    std::vector<int> ok(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            auto local = CreateTensor(Shape({size}), DataType::FLOAT32);
+            std::fill_n(static_cast<float*>(local->GetData()), size, static_cast<float>(t));
+            bool all = true;
+            for (int iter = 0; iter < 50 && all; ++iter) {
+                std::vector<std::shared_ptr<Tensor>> outputs;
+                all = session->Run({local.get()}, outputs).IsOk() && outputs.size() == 1;
+                const float* out = all ? static_cast<const float*>(outputs[0]->GetData()) : nullptr;
+                for (int64_t k = 0; all && k < size; ++k) {
+                    all = out[k] == 2.0f * static_cast<float>(t);
+                }
+            }
+            ok[t] = all ? 1 : 0;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < 4; ++t) {
+        EXPECT_TRUE(ok[t]) << "thread " << t;
+    }
+    EXPECT_LE(pool->GetStats().free_buffers, 2u);
+
+    // 会话销毁后仍可安全地释放句柄
+    session.reset();
+    third.clear();
+    second.clear();
+}
+TEST_F(RuntimeTest, ParallelSchedulerDag) {
+    InitializeExecutionProviders();
+    std::shared_ptr<ExecutionProvider> provider =
+        ExecutionProviderRegistry::Instance().Create("CPUExecutionProvider");
+    ASSERT_NE(provider, nullptr);
+    
+    ThreadPoolOptions options;
+    options.num_threads = 4;
+    ThreadPool::Configure(options);
+    
+    // x -> Add(x, w_i) 共8个分支 -> 逐级Add汇总
+    const int branches = 8;
+    Graph graph;
+    Value* x = graph.AddValue();
+    graph.AddInput(x);
+    auto x_tensor = CreateTensor(Shape({4, 16}), DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Value*> partials;
+    for (int b = 0; b < branches; ++b) {
+        Value* w = graph.AddValue();
+        auto w_tensor = CreateTensor(Shape({4, 16}), DataType::FLOAT32, DeviceType::CPU);
+        float* data = static_cast<float*>(w_tensor->GetData());
+        for (int i = 0; i < 64; ++i) data[i] = static_cast<float>(b);
+        w->SetTensor(w_tensor);
+    
+        Value* out = graph.AddValue();
+        Node* add = graph.AddNode("Add", "branch" + std::to_string(b));
+        add->AddInput(x);
+        add->AddInput(w);
+        add->AddOutput(out);
+        partials.push_back(out);
+    }
+    while (partials.size() > 1) {
+        std::vector<Value*> next;
+        for (size_t i = 0; i + 1 < partials.size(); i += 2) {
+            Value* out = graph.AddValue();
+            Node* add = graph.AddNode("Add", "sum" + std::to_string(graph.GetNodes().size()));
+            add->AddInput(partials[i]);
+            add->AddInput(partials[i + 1]);
+            add->AddOutput(out);
+            next.push_back(out);
+        }
+        partials.swap(next);
+    }
+    graph.AddOutput(partials[0]);
+    ASSERT_TRUE(provider->PrepareExecution(&graph).IsOk());
+    
+    ParallelScheduler scheduler(4);
+    std::vector<Backend*> backends = {provider.get()};
+    for (int run = 0; run < 3; ++run) {
+        float* x_data = static_cast<float*>(x_tensor->GetData());
+        for (int i = 0; i < 64; ++i) x_data[i] = static_cast<float>(i + run);
+        x->SetTensor(x_tensor);
+    
+        ExecutionContext ctx;
+        ASSERT_TRUE(scheduler.Schedule(&graph, backends, &ctx).IsOk());
+    
+        // sum_b (x + b) = 8x + 28
+        auto result = partials[0]->GetTensor();
+        ASSERT_NE(result, nullptr);
+        const float* out = static_cast<const float*>(result->GetData());
+        for (int i = 0; i < 64; ++i) {
+            ASSERT_FLOAT_EQ(out[i], 8.0f * (i + run) + 28.0f);
+        }
+    }
+    EXPECT_EQ(scheduler.GetExecutionOrder(&graph).size(), graph.GetNodes().size());
+    
+    // 节点失败时返回错误，不会挂起
+    Node* bad = graph.AddNode("NoSuchOperator", "bad");
+    bad->AddInput(partials[0]);
+    bad->AddOutput(graph.AddValue());
+    ExecutionContext ctx;
+    EXPECT_FALSE(scheduler.Schedule(&graph, backends, &ctx).IsOk());
+    
+    // 超过64个节点的就绪集合跨多个位图字：150条Add->Relu分支，其中一条分支中途失败时返回错误
+    Graph wide;
+    Value* y = wide.AddValue();
+    wide.AddInput(y);
+    auto y_tensor = CreateTensor(Shape({16}), DataType::FLOAT32, DeviceType::CPU);
+    float* y_data = static_cast<float*>(y_tensor->GetData());
+    for (int i = 0; i < 16; ++i) y_data[i] = static_cast<float>(i);
+    y->SetTensor(y_tensor);
+    std::vector<Value*> wide_outputs;
+    for (int b = 0; b < 150; ++b) {
+        Value* w = wide.AddValue();
+        auto w_tensor = CreateTensor(Shape({16}), DataType::FLOAT32, DeviceType::CPU);
+        float* data = static_cast<float*>(w_tensor->GetData());
+        for (int i = 0; i < 16; ++i) data[i] = static_cast<float>(-b);
+        w->SetTensor(w_tensor);
+        Value* sum = wide.AddValue();
+        Node* add = wide.AddNode("Add", "wide_add" + std::to_string(b));
+        add->AddInput(y);
+        add->AddInput(w);
+        add->AddOutput(sum);
+        Value* out = wide.AddValue();
+        Node* relu = wide.AddNode("Relu", "wide_relu" + std::to_string(b));
+        relu->AddInput(sum);
+        relu->AddOutput(out);
+        wide.AddOutput(out);
+        wide_outputs.push_back(out);
+    }
+    ASSERT_TRUE(provider->PrepareExecution(&wide).IsOk());
+    ParallelScheduler wide_scheduler(4);
+    for (int run = 0; run < 5; ++run) {
+        ExecutionContext wide_ctx;
+        ASSERT_TRUE(wide_scheduler.Schedule(&wide, backends, &wide_ctx).IsOk());
+        for (int b = 0; b < 150; ++b) {
+            const float* out = static_cast<const float*>(wide_outputs[b]->GetTensor()->GetData());
+            for (int i = 0; i < 16; ++i) {
+                ASSERT_FLOAT_EQ(out[i], std::max(static_cast<float>(i - b), 0.0f));
+            }
+        }
+    }
+    Node* wide_bad = wide.AddNode("NoSuchOperator", "wide_bad");
+    wide_bad->AddInput(wide_outputs[70]);
+    Value* wide_bad_out = wide.AddValue();
+    wide_bad->AddOutput(wide_bad_out);
+    Node* after_bad = wide.AddNode("Relu", "after_bad");
+    after_bad->AddInput(wide_bad_out);
+    after_bad->AddOutput(wide.AddValue());
+    wide_scheduler.Invalidate();
+    for (int run = 0; run < 5; ++run) {
+        ExecutionContext wide_ctx;
+        EXPECT_FALSE(wide_scheduler.Schedule(&wide, backends, &wide_ctx).IsOk());
+    }
+    
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试会话的执行计划：加载时编译一次，Run按计划执行并在最后一次使用后释放中间张量
+TEST_F(RuntimeTest, SessionExecutionPlan) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* hidden = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(input);
+    relu->AddOutput(hidden);
+    Node* add = graph->AddNode("Add", "add1");
+    add->AddInput(hidden);
+    add->AddInput(input);
+    add->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.enable_memory_planning = false;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    ASSERT_NE(plan, nullptr);
+    ASSERT_EQ(plan->GetSteps().size(), 2u);
+    EXPECT_EQ(plan->GetSteps()[0].node, relu);
+    EXPECT_EQ(plan->GetSteps()[1].node, add);
+    ASSERT_EQ(plan->GetSteps()[1].input_slots.size(), 2u);
+    EXPECT_EQ(plan->GetSteps()[1].input_slots[0], plan->GetSlot(hidden));
+    EXPECT_TRUE(plan->GetSteps()[0].release_slots.empty());
+    ASSERT_EQ(plan->GetSteps()[1].release_slots.size(), 1u);
+    EXPECT_EQ(plan->GetSteps()[1].release_slots[0], plan->GetSlot(hidden));
+    
+    for (int run = 0; run < 2; ++run) {
+        auto input_tensor = CreateTensor(Shape({2, 3}), DataType::FLOAT32, DeviceType::CPU);
+        float* in = static_cast<float*>(input_tensor->GetData());
+        for (int i = 0; i < 6; ++i) in[i] = static_cast<float>(i - 3 + run);
+    
+        std::vector<Tensor*> inputs = {input_tensor.get()};
+        std::vector<Tensor*> outputs;
+        ASSERT_TRUE(session->Run(inputs, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* out = static_cast<const float*>(outputs[0]->GetData());
+        for (int i = 0; i < 6; ++i) {
+            EXPECT_FLOAT_EQ(out[i], std::max(0.0f, in[i]) + in[i]);
+        }
+        // 中间张量在Add之后被释放
+        EXPECT_EQ(hidden->GetTensor(), nullptr);
+    }
+    
+    ProfilingResult profile;
+    ASSERT_TRUE(session->Profile(profile).IsOk());
+    EXPECT_EQ(profile.node_profiles.size(), 2u);
+}
+
+// 测试取消与截止时间：已触发的令牌使并行循环跳过剩余的块，运行返回ERROR_CANCELLED/ERROR_TIMEOUT，
+// 执行状态归还后之后的运行照常；排队中已取消的异步运行不执行
+TEST_F(RuntimeTest, RunCancellation) {
+    ThreadPoolOptions pool_options;
+    pool_options.num_threads = 4;
+    ThreadPool::Configure(pool_options);
+    {
+        auto token = CancellationToken::Create();
+        CancellationScope scope(token);
+        std::atomic<int> executed{0};
+        ThreadPool::ParallelFor(0, 1000, 1, [&](int64_t, int64_t) {
+            executed.fetch_add(1);
+            token->Cancel();
+        });
+        EXPECT_GE(executed.load(), 1);
+        EXPECT_LT(executed.load(), 1000);
+    }
+    EXPECT_EQ(CancellationScope::Current(), nullptr);
+    
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    graph->AddInput(input);
+    Value* current = input;
+    for (int i = 0; i < 8; ++i) {
+        Value* next = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu" + std::to_string(i));
+        relu->AddInput(current);
+        relu->AddOutput(next);
+        current = next;
+    }
+    graph->AddOutput(current);
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    auto x = CreateTensor(Shape({256, 256}), DataType::FLOAT32, DeviceType::CPU);
+    float* in = static_cast<float*>(x->GetData());
+    for (int i = 0; i < 256 * 256; ++i) in[i] = static_cast<float>(i % 5) - 2.0f;
+    
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    RunOptions cancelled;
+    cancelled.cancellation = CancellationToken::Create();
+    cancelled.cancellation->Cancel();
+    EXPECT_EQ(session->Run(cancelled, {x.get()}, outputs).Code(), StatusCode::ERROR_CANCELLED);
+    EXPECT_TRUE(outputs.empty());
+    RunOptions expired;
+    expired.cancellation = CancellationToken::WithTimeout(std::chrono::nanoseconds(0));
+    EXPECT_EQ(session->Run(expired, {x.get()}, outputs).Code(), StatusCode::ERROR_TIMEOUT);
+    
+    // 截止时间未到的令牌不影响结果
+    RunOptions relaxed;
+    relaxed.cancellation = CancellationToken::WithTimeout(std::chrono::seconds(60));
+    ASSERT_TRUE(session->Run(relaxed, {x.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* out = static_cast<const float*>(outputs[0]->GetData());
+    for (int i = 0; i < 256 * 256; ++i) {
+        ASSERT_EQ(out[i], std::max(in[i], 0.0f));
+    }
+    if (session->SupportsConcurrentRun()) {
+        EXPECT_GE(session->GetNumIdleExecutionStates(), 1u);
+    }
+    
+    RunResult async = session->RunAsync(cancelled, {x}).get();
+    EXPECT_EQ(async.status.Code(), StatusCode::ERROR_CANCELLED);
+    EXPECT_TRUE(async.outputs.empty());
+    async = session->RunAsync(relaxed, {x}).get();
+    EXPECT_TRUE(async.status.IsOk()) << async.status.Message();
+    
+    ThreadPool::Configure(ThreadPoolOptions());
+}
+
+// 测试优先级：单线程池上HIGH任务先于NORMAL、NORMAL先于LOW执行，任务继承提交时的优先级；保留线程只执行
+// HIGH任务；LOW运行在节点边界等待进行中的HIGH运行结束
+TEST_F(RuntimeTest, PriorityClassesAndPreemption) {
+    EXPECT_EQ(PriorityScope::Current(), RunPriority::NORMAL);
+    {
+        PriorityScope low(RunPriority::LOW);
+        PriorityScope session_default(RunPriority::HIGH, true);  // 外层已给出，不生效
+        EXPECT_EQ(PriorityScope::Current(), RunPriority::LOW);
+        EXPECT_EQ(PriorityScope::ActiveHighPriorityRuns(), 0);
+    }
+    
+    auto wait_for = [](const std::atomic<bool>& flag) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!flag.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return flag.load();
+    };
+    
+    ThreadPoolOptions single;
+    single.num_threads = 1;
+    auto pool = ThreadPoolInstance::Create(single);
+    {
+        ThreadPoolScope scope(nullptr, pool);
+        std::atomic<bool> started{false}, release{false};
+        ThreadPool::EnqueueTask([&]() {
+            started = true;
+            while (!release.load()) std::this_thread::yield();
+        });
+        ASSERT_TRUE(wait_for(started));
+        std::mutex mutex;
+        std::vector<RunPriority> order;
+        auto enqueue = [&](RunPriority priority) {
+            PriorityScope priority_scope(priority);
+            ThreadPool::EnqueueTask([&]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(PriorityScope::Current());
+            });
+        };
+        enqueue(RunPriority::LOW);
+        enqueue(RunPriority::NORMAL);
+        enqueue(RunPriority::HIGH);
+        release = true;
+        ThreadPool::WaitAll();
+        EXPECT_EQ(order, (std::vector<RunPriority>{RunPriority::HIGH, RunPriority::NORMAL, RunPriority::LOW}));
+    }
+    
+    ThreadPoolOptions reserved_options;
+    reserved_options.num_threads = 2;
+    reserved_options.reserved_high_priority_threads = 1;
+    auto reserved_pool = ThreadPoolInstance::Create(reserved_options);
+    {
+        ThreadPoolScope scope(reserved_pool, reserved_pool);
+        EXPECT_EQ(ThreadPool::GetAvailableThreadCount(), 1u);
+        std::atomic<bool> started{false}, release{false}, normal_done{false}, high_done{false};
+        ThreadPool::EnqueueTask([&]() {
+            started = true;
+            while (!release.load()) std::this_thread::yield();
+        });
+        ASSERT_TRUE(wait_for(started));
+        ThreadPool::EnqueueTask([&]() { normal_done = true; });
+        {
+            PriorityScope high(RunPriority::HIGH);
+            EXPECT_EQ(ThreadPool::GetAvailableThreadCount(), 2u);
+            ThreadPool::EnqueueTask([&]() { high_done = true; });
+        }
+        // 普通线程被占用时HIGH任务由保留线程执行，NORMAL任务继续等待
+        EXPECT_TRUE(wait_for(high_done));
+        EXPECT_FALSE(normal_done.load());
+        release = true;
+        ThreadPool::WaitAll();
+        EXPECT_TRUE(normal_done.load());
+    }
+    
+    std::atomic<bool> yielded{false};
+    std::thread low_run;
+    {
+        PriorityScope high(RunPriority::HIGH);
+        EXPECT_EQ(PriorityScope::ActiveHighPriorityRuns(), 1);
+        low_run = std::thread([&]() {
+            PriorityScope low(RunPriority::LOW);
+            PriorityScope::YieldToHigherPriority(nullptr);
+            yielded = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_FALSE(yielded.load());
+    }
+    low_run.join();
+    EXPECT_TRUE(yielded.load());
+    EXPECT_EQ(PriorityScope::ActiveHighPriorityRuns(), 0);
+    
+    // 会话的默认优先级与单次运行的优先级
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    SessionOptions options;
+    options.priority = RunPriority::LOW;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    auto x = CreateTensor(Shape({4, 4}), DataType::FLOAT32, DeviceType::CPU);
+    x->FillZero();
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    EXPECT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    RunOptions interactive;
+    interactive.priority = RunPriority::HIGH;
+    EXPECT_TRUE(session->Run(interactive, {x.get()}, outputs).IsOk());
+    EXPECT_TRUE(session->RunAsync(interactive, {x}).get().status.IsOk());
+    EXPECT_EQ(PriorityScope::ActiveHighPriorityRuns(), 0);
+}
+
+// 测试准入控制：按在途运行数与运行耗时的估计预测完成时间，超过截止时间的请求在受理时拒绝，排队后剩余时间
+// 不够一次运行的请求在开始前放弃；会话的RunAsync返回ERROR_OVERLOADED
+TEST_F(RuntimeTest, AdmissionControlShedsLoad) {
+    using Clock = AdmissionController::Clock;
+    AdmissionOptions admission_options;
+    admission_options.latency_smoothing = 0.5;
+    AdmissionController controller(admission_options);
+    // 尚无运行耗时的估计时全部受理
+    ASSERT_TRUE(controller.Admit(Clock::now(), 1).IsOk());
+    ASSERT_TRUE(controller.Start(Clock::time_point::max()).IsOk());
+    controller.Finish(10.0);
+    ASSERT_TRUE(controller.Admit(Clock::now() + std::chrono::seconds(1), 1).IsOk());
+    ASSERT_TRUE(controller.Start(Clock::time_point::max()).IsOk());
+    controller.Finish(20.0);
+    EXPECT_DOUBLE_EQ(controller.GetStats().service_time_ms, 15.0);
+    
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(controller.Admit(Clock::time_point::max(), 1).IsOk());
+    }
+    // 前面排着3个运行：预测45ms排队加15ms运行；两个并发时排队减半
+    EXPECT_DOUBLE_EQ(controller.PredictQueueDelayMs(1), 45.0);
+    EXPECT_DOUBLE_EQ(controller.PredictQueueDelayMs(2), 15.0);
+    EXPECT_EQ(controller.Admit(Clock::now() + std::chrono::milliseconds(50), 1).Code(), StatusCode::ERROR_OVERLOADED);
+    EXPECT_TRUE(controller.Admit(Clock::now() + std::chrono::milliseconds(50), 2).IsOk());
+    // 开始时剩余时间已不够一次运行的请求被放弃
+    EXPECT_EQ(controller.Start(Clock::now() + std::chrono::milliseconds(5)).Code(), StatusCode::ERROR_OVERLOADED);
+    controller.Withdraw();
+    AdmissionStats stats = controller.GetStats();
+    EXPECT_EQ(stats.admitted, 6u);
+    EXPECT_EQ(stats.rejected, 1u);
+    EXPECT_EQ(stats.shed, 1u);
+    EXPECT_EQ(stats.queued, 2u);
+    EXPECT_EQ(stats.running, 0u);
+    
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    SessionOptions options;
+    options.enable_admission_control = true;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    auto x = CreateTensor(Shape({64, 64}), DataType::FLOAT32, DeviceType::CPU);
+    x->FillZero();
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(session->RunAsync({x}).get().status.IsOk());
+    }
+    ASSERT_NE(session->GetAdmissionController(), nullptr);
+    EXPECT_GT(session->GetAdmissionController()->GetStats().service_time_ms, 0.0);
+    
+    // 截止时间已到的请求在受理时拒绝，callback不被调用；没有截止时间的请求照常执行
+    RunOptions expired;
+    expired.cancellation = CancellationToken::WithTimeout(std::chrono::nanoseconds(0));
+    bool called = false;
+    EXPECT_EQ(session->RunAsync(expired, {x}, [&](Status, std::vector<std::shared_ptr<Tensor>>) { called = true; })
+                  .Code(), StatusCode::ERROR_OVERLOADED);
+    EXPECT_EQ(session->RunAsync(expired, {x}).get().status.Code(), StatusCode::ERROR_OVERLOADED);
+    EXPECT_TRUE(session->RunAsync({x}).get().status.IsOk());
+    session->WaitForAsyncRuns();
+    EXPECT_FALSE(called);
+    stats = session->GetAdmissionController()->GetStats();
+    EXPECT_EQ(stats.rejected, 2u);
+    EXPECT_EQ(stats.completed, 4u);
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_EQ(session->GetNumInflightRuns(), 0u);
+}
+
+// 测试流水线阶段划分：按代价而非节点数切分
+TEST_F(RuntimeTest, PipelinePartitionByCost) {
+    EXPECT_EQ(PartitionByCost({1, 1, 1, 1, 8}, 2), (std::vector<size_t>{0, 4, 5}));
+    EXPECT_EQ(PartitionByCost({4, 1, 1, 1, 1}, 2), (std::vector<size_t>{0, 1, 5}));
+    EXPECT_EQ(PartitionByCost({1, 1, 1, 1, 1, 1}, 3), (std::vector<size_t>{0, 2, 4, 6}));
+    // 元素少于阶段数时多出的阶段为空；单个阶段包含全部元素
+    EXPECT_EQ(PartitionByCost({2, 3}, 3), (std::vector<size_t>{0, 1, 2, 2}));
+    EXPECT_EQ(PartitionByCost({2, 3}, 1), (std::vector<size_t>{0, 2}));
+    EXPECT_EQ(PartitionByCost({}, 2), (std::vector<size_t>{0, 0, 0}));
+    
+    Graph graph;
+    Value* value = graph.AddValue();
+    graph.AddInput(value);
+    for (int i = 0; i < 4; ++i) {
+        Value* next = graph.AddValue();
+        Node* relu = graph.AddNode("Relu", "relu" + std::to_string(i));
+        relu->AddInput(value);
+        relu->AddOutput(next);
+        value = next;
+    }
+    graph.AddOutput(value);
+    PipelineScheduler scheduler(2);
+    scheduler.SetNodeCosts({{"relu0", 10.0}, {"relu1", 1.0}, {"relu2", 1.0}, {"relu3", 1.0}});
+    ExecutionContext ctx;
+    ASSERT_TRUE(scheduler.Schedule(&graph, {}, &ctx).IsOk());
+    ASSERT_EQ(scheduler.GetStages().size(), 2u);
+    EXPECT_EQ(scheduler.GetStages()[0].size(), 1u);
+    EXPECT_EQ(scheduler.GetStages()[1].size(), 3u);
+    EXPECT_EQ(scheduler.GetExecutionOrder(&graph).size(), 4u);
+}
+
+// 测试流水线推理：多个micro-batch流过各阶段，结果与逐个Run一致
+TEST_F(RuntimeTest, PipelinedRun) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* value = input;
+    for (int i = 0; i < 4; ++i) {
+        Value* relu_out = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu" + std::to_string(i));
+        relu->AddInput(value);
+        relu->AddOutput(relu_out);
+        Value* add_out = graph->AddValue();
+        Node* add = graph->AddNode("Add", "add" + std::to_string(i));
+        add->AddInput(relu_out);
+        add->AddInput(input);
+        add->AddOutput(add_out);
+        value = add_out;
+    }
+    graph->AddInput(input);
+    graph->AddOutput(value);
+    input->SetTensor(CreateTensor(Shape({2, 8}), DataType::FLOAT32));
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.pipeline_num_stages = 3;
+    options.pipeline_queue_capacity = 1;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    ASSERT_TRUE(session->SupportsConcurrentRun());
+    
+    constexpr int kMicroBatches = 16;
+    std::vector<std::vector<std::shared_ptr<Tensor>>> micro_batches;
+    for (int b = 0; b < kMicroBatches; ++b) {
+        auto tensor = CreateTensor(Shape({2, 8}), DataType::FLOAT32);
+        float* data = static_cast<float*>(tensor->GetData());
+        for (int i = 0; i < 16; ++i) {
+            data[i] = static_cast<float>(b - i) * 0.5f;
+        }
+        micro_batches.push_back({tensor});
+    }
+    
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<std::vector<std::shared_ptr<Tensor>>> outputs;
+        ASSERT_TRUE(session->RunPipelined(micro_batches, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), static_cast<size_t>(kMicroBatches));
+        for (int b = 0; b < kMicroBatches; ++b) {
+            std::vector<std::shared_ptr<Tensor>> expected;
+            ASSERT_TRUE(session->Run({micro_batches[b][0].get()}, expected).IsOk());
+            ASSERT_EQ(outputs[b].size(), 1u);
+            const float* got = static_cast<const float*>(outputs[b][0]->GetData());
+            const float* want = static_cast<const float*>(expected[0]->GetData());
+            for (int i = 0; i < 16; ++i) {
+                ASSERT_FLOAT_EQ(got[i], want[i]);
+            }
+        }
+        // 第二轮在实测耗时上重新划分
+        ASSERT_TRUE(session->CalibratePipeline(micro_batches[0]).IsOk());
+    }
+    
+    const PipelineExecutor* pipeline = session->GetPipelineExecutor();
+    ASSERT_NE(pipeline, nullptr);
+    ASSERT_EQ(pipeline->GetNumStages(), 3u);
+    EXPECT_EQ(pipeline->GetStageBounds().front(), 0u);
+    EXPECT_EQ(pipeline->GetStageBounds().back(), session->GetExecutionPlan()->GetSteps().size());
+    
+    // 输入个数不符的micro-batch报错，其余照常完成
+    std::vector<std::vector<std::shared_ptr<Tensor>>> bad_batches = {micro_batches[0], {}, micro_batches[1]};
+    std::vector<std::vector<std::shared_ptr<Tensor>>> outputs;
+    EXPECT_EQ(session->RunPipelined(bad_batches, outputs).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(outputs[0].size(), 1u);
+    EXPECT_TRUE(outputs[1].empty());
+    EXPECT_EQ(outputs[2].size(), 1u);
+}
+
+namespace {
+
+// 模拟设备：声明为CUDA、只支持部分算子，计算委托给CPU提供者（张量留在主机内存中）
+bool g_fake_device_available = false;
+
+class FakeDeviceProvider : public ExecutionProvider {
+public:
+    FakeDeviceProvider() : cpu_(ExecutionProviderRegistry::Instance().Create("CPU")) {}
+    
+    std::string GetName() const override { return "FakeDevice"; }
+    DeviceType GetDeviceType() const override { return DeviceType::CUDA; }
+    bool IsAvailable() const override { return g_fake_device_available && cpu_; }
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override { return cpu_->GetDevice(device_id); }
+    int GetDeviceCount() const override { return 1; }
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == "MatMul" || op_type == "Relu" ||
+               op_type == "MemcpyToDevice" || op_type == "MemcpyFromDevice";
+    }
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        return cpu_->CreateOperator(op_type);
+    }
+    Status OptimizeGraph(Graph* graph) override { (void)graph; return Status::Ok(); }
+    Status CompileNode(Node* node) override { return cpu_->CompileNode(node); }
+    Status PrepareExecution(Graph* graph) override { (void)graph; return Status::Ok(); }
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override { return cpu_->ExecuteNode(node, ctx); }
+    DeviceType GetOutputDeviceType(const Node* node, size_t output_index) const override {
+        (void)node; (void)output_index;
+        return DeviceType::CPU;
+    }
+    bool SupportsConcurrentExecution() const override { return cpu_->SupportsConcurrentExecution(); }
+    Status ExecuteKernel(Node* node, const std::vector<Tensor*>& inputs,
+                         const std::vector<Tensor*>& outputs, ExecutionContext* ctx) override {
+        return cpu_->ExecuteKernel(node, inputs, outputs, ctx);
+    }
+
+protected:
+    std::unique_ptr<ExecutionProvider> cpu_;
+};
+
+int g_fake_captures = 0;
+int g_fake_replays = 0;
+
+// 模拟整图捕获：捕获期间只记录节点与其张量地址，重放时按记录执行并检查地址未变
+class FakeCaptureProvider : public FakeDeviceProvider {
+public:
+    std::string GetName() const override { return "FakeCaptureDevice"; }
+    bool IsGraphCaptureEnabled() const override { return true; }
+    bool IsGraphCaptured() const override { return captured_; }
+    Status CaptureBegin() override {
+        recorded_.clear();
+        capturing_ = true;
+        return Status::Ok();
+    }
+    Status CaptureEnd() override {
+        capturing_ = false;
+        captured_ = true;
+        ++g_fake_captures;
+        return Status::Ok();
+    }
+    Status ReplayGraph() override {
+        ++g_fake_replays;
+        ExecutionContext ctx;
+        for (const auto& record : recorded_) {
+            if (Addresses(record.first) != record.second) {
+                return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Captured address changed");
+            }
+            Status status = cpu_->ExecuteNode(record.first, &ctx);
+            if (!status.IsOk()) {
+                return status;
+            }
+        }
+        return Status::Ok();
+    }
+    void ResetGraph() override {
+        captured_ = false;
+        recorded_.clear();
+    }
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        if (capturing_) {
+            recorded_.emplace_back(node, Addresses(node));
+            return Status::Ok();
+        }
+        return cpu_->ExecuteNode(node, ctx);
+    }
+    bool SupportsConcurrentExecution() const override { return false; }
+
+private:
+    static std::vector<const void*> Addresses(const Node* node) {
+        std::vector<const void*> addresses;
+        for (const Value* value : node->GetInputs()) {
+            addresses.push_back(value->GetTensor() ? value->GetTensor()->GetData() : nullptr);
+        }
+        for (const Value* value : node->GetOutputs()) {
+            addresses.push_back(value->GetTensor() ? value->GetTensor()->GetData() : nullptr);
+        }
+        return addresses;
+    }
+    
+    bool capturing_ = false;
+    bool captured_ = false;
+    std::vector<std::pair<Node*, std::vector<const void*>>> recorded_;
+};
+
+std::shared_ptr<Tensor> FilledTensor(const Shape& shape, float scale) {
+    auto tensor = CreateTensor(shape, DataType::FLOAT32);
+    float* data = static_cast<float*>(tensor->GetData());
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        data[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * scale;
+    }
+    return tensor;
+}
+
+// x -> MatMul(w1) -> Relu -> MatMul(w2) -> Sigmoid -> y，设备不支持Sigmoid
+std::unique_ptr<Graph> BuildPartitionGraph(int64_t rows, int64_t dim) {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(FilledTensor(Shape({rows, dim}), 0.1f));
+    graph->AddInput(x);
+    Value* value = x;
+    for (int i = 0; i < 2; ++i) {
+        Value* weight = graph->AddValue();
+        weight->SetName("w" + std::to_string(i));
+        weight->SetTensor(FilledTensor(Shape({dim, dim}), 0.01f));
+        Value* product = graph->AddValue();
+        Node* matmul = graph->AddNode("MatMul", "matmul" + std::to_string(i));
+        matmul->AddInput(value);
+        matmul->AddInput(weight);
+        matmul->AddOutput(product);
+        value = product;
+        if (i == 0) {
+            Value* relu_out = graph->AddValue();
+            Node* relu = graph->AddNode("Relu", "relu");
+            relu->AddInput(value);
+            relu->AddOutput(relu_out);
+            value = relu_out;
+        }
+    }
+    Value* y = graph->AddValue();
+    y->SetName("y");
+    Node* sigmoid = graph->AddNode("Sigmoid", "sigmoid");
+    sigmoid->AddInput(value);
+    sigmoid->AddOutput(y);
+    graph->AddOutput(y);
+    return graph;
+}
+
+size_t CountMemcpyNodes(const Graph& graph) {
+    size_t count = 0;
+    for (const auto& node : graph.GetNodes()) {
+        if (node->GetOpType() == "MemcpyToDevice" || node->GetOpType() == "MemcpyFromDevice") {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // anonymous namespace
+
+// 测试代价模型分区：大矩阵乘放到设备上，设备不支持的算子留在CPU，只在分区边界拷贝
+TEST_F(RuntimeTest, CostBasedPartitioning) {
+    auto cpu = ExecutionProviderRegistry::Instance().Create("CPU");
+    ASSERT_NE(cpu, nullptr);
+    FakeDeviceProvider device;
+    std::vector<ExecutionProvider*> providers = {cpu.get(), &device};
+    
+    auto graph = BuildPartitionGraph(64, 256);
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    GraphPartitioner partitioner;
+    PartitionResult result;
+    ASSERT_TRUE(partitioner.Partition(graph.get(), providers, &result).IsOk());
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("matmul0")), &device);
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("relu")), &device);
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("matmul1")), &device);
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("sigmoid")), cpu.get());
+    EXPECT_EQ(result.num_partitions, 2u);
+    // x、w0、w1拷到设备，matmul1的结果拷回主机
+    EXPECT_EQ(result.num_copies, 4u);
+    EXPECT_EQ(CountMemcpyNodes(*graph), 4u);
+    EXPECT_EQ(graph->GetNodeByName("relu")->GetInputs()[0]->GetProducer(), graph->GetNodeByName("matmul0"));
+    EXPECT_EQ(graph->GetNodeByName("sigmoid")->GetInputs()[0]->GetProducer()->GetOpType(), "MemcpyFromDevice");
+    EXPECT_EQ(graph->GetOutputs()[0]->GetName(), "y");
+    EXPECT_TRUE(graph->Validate().IsOk());
+    
+    // 小张量上的来回搬运不划算：全部留在CPU，不插入拷贝
+    auto small = BuildPartitionGraph(1, 4);
+    ASSERT_TRUE(InferShapes(small.get()).IsOk());
+    ASSERT_TRUE(partitioner.Partition(small.get(), providers, &result).IsOk());
+    EXPECT_EQ(result.num_partitions, 1u);
+    EXPECT_EQ(result.num_copies, 0u);
+    EXPECT_EQ(CountMemcpyNodes(*small), 0u);
+    for (const auto& node : small->GetNodes()) {
+        EXPECT_EQ(result.assignment.at(node.get()), cpu.get());
+    }
+    
+    // 实测耗时优先于解析估计：设备上的MatMul很慢时整个图留在CPU
+    auto measured = std::make_shared<CostModel>();
+    measured->RecordNodeTime("FakeDevice", "MatMul", 1e6);
+    GraphPartitioner measured_partitioner(measured);
+    auto slow = BuildPartitionGraph(64, 256);
+    ASSERT_TRUE(InferShapes(slow.get()).IsOk());
+    ASSERT_TRUE(measured_partitioner.Assign(slow.get(), providers, &result).IsOk());
+    EXPECT_EQ(result.assignment.at(slow->GetNodeByName("matmul0")), cpu.get());
+    EXPECT_EQ(result.assignment.at(slow->GetNodeByName("matmul1")), cpu.get());
+    EXPECT_EQ(result.num_copies, 0u);
+}
+
+// 与主机共享内存的设备（移动SoC上的NPU）：分区边界不插入拷贝，节点仍标记为设备上的节点
+TEST_F(RuntimeTest, SharedMemoryDevicePartitioning) {
+    class SharedMemoryProvider : public FakeDeviceProvider {
+    public:
+        std::string GetName() const override { return "FakeSharedMemoryDevice"; }
+        DeviceType GetDeviceType() const override { return DeviceType::SNPE; }
+        bool SharesHostMemory() const override { return true; }
+    };
+    auto cpu = ExecutionProviderRegistry::Instance().Create("CPU");
+    ASSERT_NE(cpu, nullptr);
+    SharedMemoryProvider device;
+    std::vector<ExecutionProvider*> providers = {cpu.get(), &device};
+    
+    auto graph = BuildPartitionGraph(64, 256);
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    GraphPartitioner partitioner;
+    PartitionResult result;
+    ASSERT_TRUE(partitioner.Partition(graph.get(), providers, &result).IsOk());
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("matmul0")), &device);
+    EXPECT_EQ(result.assignment.at(graph->GetNodeByName("sigmoid")), cpu.get());
+    EXPECT_EQ(result.num_copies, 0u);
+    EXPECT_EQ(CountMemcpyNodes(*graph), 0u);
+    EXPECT_EQ(graph->GetNodeByName("matmul0")->GetDevice(), DeviceType::SNPE);
+    EXPECT_EQ(graph->GetNodeByName("sigmoid")->GetInputs()[0]->GetProducer(), graph->GetNodeByName("matmul1"));
+    EXPECT_TRUE(graph->Validate().IsOk());
+}
+
+// 测试会话内的分区执行：结果与只用CPU时一致
+TEST_F(RuntimeTest, PartitionedSessionRun) {
+    ExecutionProviderRegistry::Instance().Register("FakeDevice", []() {
+        return std::unique_ptr<ExecutionProvider>(new FakeDeviceProvider());
+    });
+    g_fake_device_available = true;
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.execution_providers = {"CPU", "FakeDevice"};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildPartitionGraph(64, 256)).IsOk());
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    ASSERT_NE(plan, nullptr);
+    size_t copies = 0;
+    size_t device_steps = 0;
+    for (const ExecutionStep& step : plan->GetSteps()) {
+        const std::string& op = step.node->GetOpType();
+        copies += (op == "MemcpyToDevice" || op == "MemcpyFromDevice") ? 1 : 0;
+        device_steps += step.provider->GetName() == "FakeDevice" ? 1 : 0;
+    }
+    EXPECT_EQ(copies, 4u);
+    EXPECT_GE(device_steps, 3u);
+    
+    options.execution_providers = {"CPU"};
+    auto reference = InferenceSession::Create(options);
+    ASSERT_NE(reference, nullptr);
+    ASSERT_TRUE(reference->LoadModelFromGraph(BuildPartitionGraph(64, 256)).IsOk());
+    g_fake_device_available = false;
+    
+    auto input = FilledTensor(Shape({64, 256}), 0.2f);
+    std::vector<std::shared_ptr<Tensor>> got;
+    std::vector<std::shared_ptr<Tensor>> want;
+    ASSERT_TRUE(session->Run({input.get()}, got).IsOk());
+    ASSERT_TRUE(reference->Run({input.get()}, want).IsOk());
+    ASSERT_EQ(got.size(), 1u);
+    ASSERT_EQ(want.size(), 1u);
+    ASSERT_EQ(got[0]->GetElementCount(), want[0]->GetElementCount());
+    const float* a = static_cast<const float*>(got[0]->GetData());
+    const float* b = static_cast<const float*>(want[0]->GetData());
+    for (size_t i = 0; i < got[0]->GetElementCount(); ++i) {
+        ASSERT_FLOAT_EQ(a[i], b[i]);
+    }
+}
+
+// 测试整图捕获与重放：首次运行捕获，之后重放；输入形状变化时重新捕获，输出不被重放覆盖
+TEST_F(RuntimeTest, GraphCaptureReplay) {
+    ExecutionProviderRegistry::Instance().Register("FakeCaptureDevice", []() {
+        return std::unique_ptr<ExecutionProvider>(new FakeCaptureProvider());
+    });
+    g_fake_device_available = true;
+    
+    auto build = []() {
+        auto graph = std::make_unique<Graph>();
+        Value* x = graph->AddValue();
+        x->SetTensor(FilledTensor(Shape({64, 256}), 0.1f));
+        graph->AddInput(x);
+        Value* w = graph->AddValue();
+        w->SetTensor(FilledTensor(Shape({256, 256}), 0.01f));
+        Value* product = graph->AddValue();
+        Node* matmul = graph->AddNode("MatMul", "matmul");
+        matmul->AddInput(x);
+        matmul->AddInput(w);
+        matmul->AddOutput(product);
+        Value* y = graph->AddValue();
+        Node* relu = graph->AddNode("Relu", "relu");
+        relu->AddInput(product);
+        relu->AddOutput(y);
+        graph->AddOutput(y);
+        return graph;
+    };
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.execution_providers = {"FakeCaptureDevice"};
+    options.enable_cuda_graph = true;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(build()).IsOk());
+    EXPECT_TRUE(session->IsGraphCaptureEnabled());
+    EXPECT_FALSE(session->SupportsConcurrentRun());
+    g_fake_device_available = false;
+    
+    options.execution_providers = {"CPU"};
+    options.enable_cuda_graph = false;
+    auto reference = InferenceSession::Create(options);
+    ASSERT_NE(reference, nullptr);
+    ASSERT_TRUE(reference->LoadModelFromGraph(build()).IsOk());
+    
+    auto check = [&](const std::shared_ptr<Tensor>& input) {
+        std::vector<std::shared_ptr<Tensor>> got;
+        std::vector<std::shared_ptr<Tensor>> want;
+        EXPECT_TRUE(session->Run({input.get()}, got).IsOk());
+        EXPECT_TRUE(reference->Run({input.get()}, want).IsOk());
+        EXPECT_EQ(got.size(), 1u);
+        EXPECT_EQ(want.size(), 1u);
+        if (got.size() != 1 || want.size() != 1) {
+            return std::shared_ptr<Tensor>();
+        }
+        EXPECT_EQ(got[0]->GetShape().dims, want[0]->GetShape().dims);
+        const float* a = static_cast<const float*>(got[0]->GetData());
+        const float* b = static_cast<const float*>(want[0]->GetData());
+        for (size_t i = 0; i < want[0]->GetElementCount(); ++i) {
+            EXPECT_FLOAT_EQ(a[i], b[i]);
+        }
+        return got[0];
+    };
+    
+    g_fake_captures = 0;
+    g_fake_replays = 0;
+    auto first = check(FilledTensor(Shape({64, 256}), 0.2f));
+    ASSERT_NE(first, nullptr);
+    std::vector<float> first_values(static_cast<const float*>(first->GetData()),
+                                    static_cast<const float*>(first->GetData()) + first->GetElementCount());
+    check(FilledTensor(Shape({64, 256}), -0.3f));
+    check(FilledTensor(Shape({64, 256}), 0.5f));
+    EXPECT_EQ(g_fake_captures, 1);
+    EXPECT_EQ(g_fake_replays, 3);
+    // 之前返回的输出是拷贝，不被后续重放覆盖
+    EXPECT_TRUE(std::equal(first_values.begin(), first_values.end(),
+                           static_cast<const float*>(first->GetData())));
+    
+    check(FilledTensor(Shape({32, 256}), 0.7f));
+    check(FilledTensor(Shape({32, 256}), 0.1f));
+    EXPECT_EQ(g_fake_captures, 2);
+    EXPECT_EQ(g_fake_replays, 5);
+}
+
+namespace {
+
+int g_fake_stream_waits = 0;
+
+// 模拟多流设备：流与事件只是编号，记录事件的录制与等待，其余操作委托给CPU设备
+class FakeStreamDevice : public Device {
+public:
+    explicit FakeStreamDevice(std::shared_ptr<Device> cpu) : cpu_(std::move(cpu)) {}
+    
+    DeviceType GetType() const override { return DeviceType::CUDA; }
+    std::string GetName() const override { return "FakeStreamDevice"; }
+    void* Allocate(size_t size) override { return cpu_->Allocate(size); }
+    void Free(void* ptr) override { cpu_->Free(ptr); }
+    void* AllocateAligned(size_t size, size_t alignment) override { return cpu_->AllocateAligned(size, alignment); }
+    Status Copy(void* dst, const void* src, size_t size) override { return cpu_->Copy(dst, src, size); }
+    Status CopyFromHost(void* dst, const void* src, size_t size) override { return cpu_->CopyFromHost(dst, src, size); }
+    Status CopyToHost(void* dst, const void* src, size_t size) override { return cpu_->CopyToHost(dst, src, size); }
+    Status Synchronize() override { return Status::Ok(); }
+    void* CreateStream() override { return reinterpret_cast<void*>(++next_handle_); }
+    void DestroyStream(void* stream) override { (void)stream; }
+    Status SynchronizeStream(void* stream) override { (void)stream; return Status::Ok(); }
+    void* AcquireStream() override {
+        ++acquired_;
+        return CreateStream();
+    }
+    void ReleaseStream(void* stream) override {
+        (void)stream;
+        ++released_;
+    }
+    void* CreateEvent() override { return reinterpret_cast<void*>(++next_handle_); }
+    void DestroyEvent(void* event) override { recorded_.erase(event); }
+    Status RecordEvent(void* event, void* stream) override {
+        recorded_[event] = stream;
+        return Status::Ok();
+    }
+    Status StreamWaitEvent(void* stream, void* event) override {
+        auto it = recorded_.find(event);
+        if (it == recorded_.end() || it->second == stream) {
+            return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Waiting on an unrecorded event");
+        }
+        ++g_fake_stream_waits;
+        return Status::Ok();
+    }
+    
+    int acquired_ = 0;
+    int released_ = 0;
+
+private:
+    std::shared_ptr<Device> cpu_;
+    uintptr_t next_handle_ = 0;
+    std::unordered_map<void*, void*> recorded_;
+};
+
+// 支持多流的模拟设备：记录每个节点执行时所在的流
+class FakeStreamProvider : public FakeDeviceProvider {
+public:
+    FakeStreamProvider() : device_(std::make_shared<FakeStreamDevice>(cpu_->GetDevice())) {}
+    
+    std::string GetName() const override { return "FakeStreamDevice"; }
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override {
+        (void)device_id;
+        return device_;
+    }
+    bool SupportsOperator(const std::string& op_type) const override {
+        return op_type == "MatMul" || op_type == "Relu" || op_type == "Add";
+    }
+    bool SupportsConcurrentExecution() const override { return false; }
+    bool SupportsMultiStream() const override { return true; }
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        streams_[node->GetName()] = ctx->GetStream();
+        return cpu_->ExecuteNode(node, ctx);
+    }
+    
+    std::shared_ptr<FakeStreamDevice> device_;
+    std::unordered_map<std::string, void*> streams_;
+};
+
+// x -> relu_a -> matmul_a，x -> matmul_b -> relu_b，两条分支在add汇合
+std::unique_ptr<Graph> BuildBranchGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetTensor(FilledTensor(Shape({32, 64}), 0.1f));
+    graph->AddInput(x);
+    auto unary = [&](const std::string& op, const std::string& name, Value* input) {
+        Value* output = graph->AddValue();
+        Node* node = graph->AddNode(op, name);
+        node->AddInput(input);
+        node->AddOutput(output);
+        return output;
+    };
+    auto matmul = [&](const std::string& name, Value* input, float scale) {
+        Value* w = graph->AddValue();
+        w->SetTensor(FilledTensor(Shape({64, 64}), scale));
+        Value* output = graph->AddValue();
+        Node* node = graph->AddNode("MatMul", name);
+        node->AddInput(input);
+        node->AddInput(w);
+        node->AddOutput(output);
+        return output;
+    };
+    Value* a = matmul("matmul_a", unary("Relu", "relu_a", x), 0.02f);
+    Value* b = unary("Relu", "relu_b", matmul("matmul_b", x, 0.03f));
+    Value* y = graph->AddValue();
+    Node* add = graph->AddNode("Add", "add");
+    add->AddInput(a);
+    add->AddInput(b);
+    add->AddOutput(y);
+    graph->AddOutput(y);
+    return graph;
+}
+
+} // anonymous namespace
+
+// 测试多流执行：独立分支分到不同的流，汇合处只等待一次另一条流的事件，结果与顺序执行一致
+TEST_F(RuntimeTest, MultiStreamExecution) {
+    ExecutionProviderRegistry::Instance().Register("FakeStreamDevice", []() {
+        return std::unique_ptr<ExecutionProvider>(new FakeStreamProvider());
+    });
+    g_fake_device_available = true;
+    
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.execution_providers = {"FakeStreamDevice"};
+    options.max_parallel_streams = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildBranchGraph()).IsOk());
+    g_fake_device_available = false;
+    
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    ASSERT_NE(plan, nullptr);
+    ASSERT_FALSE(plan->GetSteps().empty());
+    auto* provider = static_cast<FakeStreamProvider*>(plan->GetSteps()[0].provider);
+    EXPECT_EQ(plan->GetNumStreams(), 2);
+    std::unordered_map<std::string, const ExecutionStep*> steps;
+    for (const ExecutionStep& step : plan->GetSteps()) {
+        steps[step.node->GetName()] = &step;
+    }
+    EXPECT_EQ(steps["relu_a"]->stream, steps["matmul_a"]->stream);
+    EXPECT_EQ(steps["matmul_b"]->stream, steps["relu_b"]->stream);
+    EXPECT_NE(steps["relu_a"]->stream, steps["matmul_b"]->stream);
+    EXPECT_EQ(steps["add"]->wait_steps.size(), 1u);
+    
+    options.execution_providers = {"CPU"};
+    options.max_parallel_streams = 1;
+    auto reference = InferenceSession::Create(options);
+    ASSERT_NE(reference, nullptr);
+    ASSERT_TRUE(reference->LoadModelFromGraph(BuildBranchGraph()).IsOk());
+    
+    g_fake_stream_waits = 0;
+    auto input = FilledTensor(Shape({32, 64}), 0.1f);
+    for (int run = 0; run < 2; ++run) {
+        std::vector<std::shared_ptr<Tensor>> got;
+        std::vector<std::shared_ptr<Tensor>> want;
+        ASSERT_TRUE(session->Run({input.get()}, got).IsOk());
+        ASSERT_TRUE(reference->Run({input.get()}, want).IsOk());
+        ASSERT_EQ(got.size(), 1u);
+        ASSERT_EQ(want.size(), 1u);
+        const float* a = static_cast<const float*>(got[0]->GetData());
+        const float* b = static_cast<const float*>(want[0]->GetData());
+        for (size_t i = 0; i < got[0]->GetElementCount(); ++i) {
+            ASSERT_FLOAT_EQ(a[i], b[i]);
+        }
+    }
+    EXPECT_EQ(g_fake_stream_waits, 2);
+    EXPECT_NE(provider->streams_["relu_a"], nullptr);
+    EXPECT_EQ(provider->streams_["relu_a"], provider->streams_["matmul_a"]);
+    EXPECT_EQ(provider->streams_["matmul_b"], provider->streams_["relu_b"]);
+    EXPECT_NE(provider->streams_["relu_a"], provider->streams_["matmul_b"]);
+    // 每次运行取两条流，运行结束后全部归还
+    EXPECT_EQ(provider->device_->acquired_, 4);
+    EXPECT_EQ(provider->device_->released_, 4);
+}
+
+// 测试kernel自动调优：选出最快的候选并写入缓存，持久化后重新加载时命中缓存、不再实测
+TEST(KernelTuningTest, AutotuneAndPersist) {
+    const std::string path = ::testing::TempDir() + "inferunity_tuning_cache.txt";
+    std::remove(path.c_str());
+    const std::string key = KernelTuningCache::MakeKey("Fake GPU|A", "gemm", "m64n64k64", DataType::FLOAT32);
+    EXPECT_EQ(key.find("GPU|A"), std::string::npos);
+    
+    int benchmarks = 0;
+    auto benchmark = [&benchmarks](int algorithm, TuningRecord* measured) {
+        ++benchmarks;
+        if (algorithm == 3) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "unavailable");
+        }
+        measured->time_us = algorithm == 2 ? 5.0 : 10.0 + algorithm;
+        measured->workspace_bytes = static_cast<size_t>(algorithm) * 1024;
+        return Status::Ok();
+    };
+    
+    KernelTuningCache cache;
+    ASSERT_TRUE(cache.SetPath(path).IsOk());
+    TuningRecord best;
+    ASSERT_TRUE(AutotuneKernel(key, {0, 1, 2, 3}, benchmark, &cache, &best).IsOk());
+    EXPECT_EQ(best.algorithm, 2);
+    EXPECT_DOUBLE_EQ(best.time_us, 5.0);
+    EXPECT_EQ(best.workspace_bytes, 2048u);
+    EXPECT_EQ(benchmarks, 4);
+    
+    // 热启动：从磁盘读入，不再实测
+    KernelTuningCache restarted;
+    ASSERT_TRUE(restarted.Load(path).IsOk());
+    EXPECT_EQ(restarted.Size(), 1u);
+    TuningRecord cached;
+    ASSERT_TRUE(AutotuneKernel(key, {0, 1, 2, 3}, benchmark, &restarted, &cached).IsOk());
+    EXPECT_EQ(cached.algorithm, 2);
+    EXPECT_EQ(cached.workspace_bytes, 2048u);
+    EXPECT_EQ(benchmarks, 4);
+    
+    // 记录的算法不在候选中（如库版本变化）时重新调优
+    ASSERT_TRUE(AutotuneKernel(key, {0, 1}, benchmark, &restarted, &cached).IsOk());
+    EXPECT_EQ(cached.algorithm, 0);
+    EXPECT_EQ(benchmarks, 6);
+    
+    TuningRecord none;
+    EXPECT_EQ(AutotuneKernel("other", {3}, benchmark, &restarted, &none).Code(), StatusCode::ERROR_NOT_FOUND);
+    
+    // 损坏的缓存文件报错而不是静默使用
+    {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        ASSERT_NE(file, nullptr);
+        std::fputs("garbage\n", file);
+        std::fclose(file);
+    }
+    KernelTuningCache corrupted;
+    EXPECT_FALSE(corrupted.Load(path).IsOk());
+    std::remove(path.c_str());
+}
+
+namespace {
+
+bool g_fake_delegate_available = false;
+
+// 模拟编译型提供者：CompileSubgraph保存子图，ExecuteNode在主机上逐节点解释执行
+// （支持CustomScale2: 2x、CustomOffset1: x+1、CustomAdd: a+b）
+class FakeSubgraphProvider : public ExecutionProvider {
+public:
+    FakeSubgraphProvider() : cpu_(ExecutionProviderRegistry::Instance().Create("CPU")) {}
+    
+    std::string GetName() const override { return "FakeSubgraph"; }
+    DeviceType GetDeviceType() const override { return DeviceType::CPU; }
+    bool IsAvailable() const override { return g_fake_delegate_available && cpu_; }
+    std::shared_ptr<Device> GetDevice(int device_id = 0) override { return cpu_->GetDevice(device_id); }
+    int GetDeviceCount() const override { return 1; }
+    bool SupportsOperator(const std::string& op_type) const override { return op_type == kDelegatedSubgraphOp; }
+    std::unique_ptr<Operator> CreateOperator(const std::string& op_type) override {
+        (void)op_type;
+        return nullptr;
+    }
+    Status OptimizeGraph(Graph* graph) override { (void)graph; return Status::Ok(); }
+    Status CompileNode(Node* node) override { (void)node; return Status::Ok(); }
+    Status PrepareExecution(Graph* graph) override { (void)graph; return Status::Ok(); }
+    
+    bool SupportsSubgraphCompilation() const override { return true; }
+    Status CompileSubgraph(Node* fused_node, std::unique_ptr<Graph> subgraph) override {
+        subgraphs_[fused_node] = std::move(subgraph);
+        return Status::Ok();
+    }
+    const Graph* GetSubgraph(const Node* fused_node) const {
+        auto it = subgraphs_.find(fused_node);
+        return it != subgraphs_.end() ? it->second.get() : nullptr;
+    }
+    
+    Status ExecuteNode(Node* node, ExecutionContext* ctx) override {
+        (void)ctx;
+        const Graph* subgraph = GetSubgraph(node);
+        if (!subgraph) {
+            return Status::Error(StatusCode::ERROR_NOT_IMPLEMENTED, "Not a delegated subgraph");
+        }
+        std::unordered_map<const Value*, std::shared_ptr<Tensor>> tensors;
+        for (size_t i = 0; i < subgraph->GetInputs().size(); ++i) {
+            tensors[subgraph->GetInputs()[i]] = node->GetInputs()[i]->GetTensor();
+        }
+        for (Node* inner : subgraph->TopologicalSort()) {
+            const Tensor* a = tensors[inner->GetInputs()[0]].get();
+            const Tensor* b = inner->GetInputs().size() > 1 ? tensors[inner->GetInputs()[1]].get() : nullptr;
+            auto out = CreateTensor(a->GetShape(), DataType::FLOAT32);
+            const float* x = static_cast<const float*>(a->GetData());
+            float* y = static_cast<float*>(out->GetData());
+            for (size_t i = 0; i < a->GetElementCount(); ++i) {
+                if (inner->GetOpType() == "CustomScale2") {
+                    y[i] = 2.0f * x[i];
+                } else if (inner->GetOpType() == "CustomOffset1") {
+                    y[i] = x[i] + 1.0f;
+                } else {
+                    y[i] = x[i] + static_cast<const float*>(b->GetData())[i];
+                }
+            }
+            tensors[inner->GetOutputs()[0]] = out;
+        }
+        for (size_t i = 0; i < subgraph->GetOutputs().size(); ++i) {
+            node->GetOutputs()[i]->SetTensor(tensors[subgraph->GetOutputs()[i]]);
+        }
+        return Status::Ok();
+    }
+
+private:
+    std::unique_ptr<ExecutionProvider> cpu_;
+    std::unordered_map<const Node*, std::unique_ptr<Graph>> subgraphs_;
+};
+
+// x -> Relu -> CustomScale2 -> CustomOffset1 -> Relu -> CustomAdd(offset, relu) -> Relu -> y
+// CustomAdd经由原生的Relu依赖前一个子图，不能与它合并
+std::unique_ptr<Graph> BuildDelegationGraph() {
+    auto graph = std::make_unique<Graph>();
+    auto add_node = [&graph](const std::string& op, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op, op + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        node->AddOutput(output);
+        return output;
+    };
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({4}), DataType::FLOAT32));
+    graph->AddInput(x);
+    Value* r = add_node("Relu", {x});
+    Value* offset = add_node("CustomOffset1", {add_node("CustomScale2", {r})});
+    Value* sum = add_node("CustomAdd", {offset, add_node("Relu", {offset})});
+    Value* y = add_node("Relu", {sum});
+    y->SetName("y");
+    graph->AddOutput(y);
+    return graph;
+}
+
+} // namespace
+
+// 测试子图委托：原生提供者不支持的连通子图换成融合节点交给编译型提供者，合并不产生环
+TEST_F(RuntimeTest, SubgraphDelegation) {
+    auto graph = BuildDelegationGraph();
+    auto cpu = ExecutionProviderRegistry::Instance().Create("CPU");
+    ASSERT_NE(cpu, nullptr);
+    FakeSubgraphProvider delegate;
+    DelegationResult result;
+    ASSERT_TRUE(DelegateUnsupportedSubgraphs(graph.get(), {cpu.get()}, &delegate, &result).IsOk());
+    EXPECT_EQ(result.num_subgraphs, 2u);
+    EXPECT_EQ(result.num_delegated_nodes, 3u);
+    EXPECT_EQ(graph->GetNodes().size(), 5u);
+    EXPECT_TRUE(graph->Validate().IsOk());
+    for (const auto& entry : result.assignment) {
+        EXPECT_EQ(entry.first->GetOpType(), kDelegatedSubgraphOp);
+        EXPECT_EQ(entry.second, &delegate);
+        const Graph* subgraph = delegate.GetSubgraph(entry.first);
+        ASSERT_NE(subgraph, nullptr);
+        EXPECT_EQ(subgraph->GetInputs().size(), entry.first->GetInputs().size());
+        EXPECT_EQ(subgraph->GetOutputs().size(), entry.first->GetOutputs().size());
+        EXPECT_EQ(subgraph->GetNodes().size(), entry.first->GetInputs().size() == 1 ? 2u : 1u);
+    }
+    
+    // 会话内：融合节点由编译型提供者执行，其余节点留在CPU上
+    ExecutionProviderRegistry::Instance().Register("FakeSubgraph", []() {
+        return std::unique_ptr<ExecutionProvider>(new FakeSubgraphProvider());
+    });
+    g_fake_delegate_available = true;
+    SessionOptions options;
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    options.execution_providers = {"CPU", "FakeSubgraph"};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildDelegationGraph()).IsOk());
+    g_fake_delegate_available = false;
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    ASSERT_NE(plan, nullptr);
+    ASSERT_EQ(plan->GetSteps().size(), 5u);
+    size_t delegated_steps = 0;
+    for (const ExecutionStep& step : plan->GetSteps()) {
+        const bool fused = step.node->GetOpType() == kDelegatedSubgraphOp;
+        delegated_steps += fused ? 1 : 0;
+        EXPECT_EQ(step.provider->GetName(), fused ? "FakeSubgraph" : "CPU");
+    }
+    EXPECT_EQ(delegated_steps, 2u);
+    
+    auto input = CreateTensor(Shape({4}), DataType::FLOAT32);
+    const float values[4] = {-1.0f, 0.5f, 1.0f, 2.0f};
+    std::memcpy(input->GetData(), values, sizeof(values));
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    ASSERT_EQ(outputs[0]->GetElementCount(), 4u);
+    // relu -> 2x -> +1 得到t，CustomAdd(t, relu(t)) = 2t
+    const float expected[4] = {2.0f, 4.0f, 6.0f, 10.0f};
+    const float* got = static_cast<const float*>(outputs[0]->GetData());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FLOAT_EQ(got[i], expected[i]);
+    }
+}
+
+// 测试优先认领：认领的节点即使原生提供者支持也交给编译型提供者，过小的子图留给原生提供者
+TEST_F(RuntimeTest, ClaimedSubgraphDelegation) {
+    class ClaimingProvider : public FakeSubgraphProvider {
+    public:
+        bool ClaimsSubgraphs() const override { return true; }
+        bool CanCompileNode(const Node* node) const override { return node->GetOpType() != "CustomAdd"; }
+    };
+    
+    // CustomAdd不认领：前面的Relu、CustomScale2、CustomOffset1、Relu成一个子图，末尾的Relu只有一个节点
+    auto graph = BuildDelegationGraph();
+    ClaimingProvider delegate;
+    DelegationResult result;
+    ASSERT_TRUE(DelegateClaimedSubgraphs(graph.get(), &delegate, 2, &result).IsOk());
+    EXPECT_EQ(result.num_subgraphs, 1u);
+    EXPECT_EQ(result.num_delegated_nodes, 4u);
+    EXPECT_EQ(graph->GetNodes().size(), 3u);
+    EXPECT_TRUE(graph->Validate().IsOk());
+    ASSERT_EQ(result.assignment.size(), 1u);
+    const Graph* subgraph = delegate.GetSubgraph(result.assignment.begin()->first);
+    ASSERT_NE(subgraph, nullptr);
+    EXPECT_EQ(subgraph->GetOutputs().size(), 2u);
+    
+    // 不足min_nodes的子图保持原样
+    auto small = BuildDelegationGraph();
+    ASSERT_TRUE(DelegateClaimedSubgraphs(small.get(), &delegate, 5, &result).IsOk());
+    EXPECT_EQ(result.num_subgraphs, 0u);
+    EXPECT_EQ(small->GetNodes().size(), 6u);
+}
+
+// x -> MatMul(Mul(a, b)) -> y，另有一个不影响输出的Relu；常量折叠与死代码消除后只剩MatMul
+std::unique_ptr<Graph> BuildFoldableGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(CreateTensor(Shape({2, 4}), DataType::FLOAT32));
+    graph->AddInput(x);
+    Value* a = graph->AddValue();
+    a->SetName("a");
+    a->SetTensor(FilledTensor(Shape({4, 4}), 0.5f));
+    Value* b = graph->AddValue();
+    b->SetName("b");
+    b->SetTensor(FilledTensor(Shape({4, 4}), 2.0f));
+    Value* c = graph->AddValue();
+    Node* mul = graph->AddNode("Mul", "mul");
+    mul->AddInput(a);
+    mul->AddInput(b);
+    mul->AddOutput(c);
+    Value* y = graph->AddValue();
+    y->SetName("y");
+    Node* matmul = graph->AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(c);
+    matmul->AddOutput(y);
+    Value* unused = graph->AddValue();
+    Node* relu = graph->AddNode("Relu", "unused_relu");
+    relu->AddInput(x);
+    relu->AddOutput(unused);
+    graph->AddOutput(y);
+    return graph;
+}
+
+TEST_F(RuntimeTest, OptimizedModelCache) {
+    // 每次测试使用新的目录，避免命中上一次运行留下的缓存
+    const std::filesystem::path cache_dir = std::filesystem::path(::testing::TempDir()) /
+        ("inferunity_model_cache_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+         "_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+    std::filesystem::remove_all(cache_dir);
+    ASSERT_TRUE(std::filesystem::create_directories(cache_dir));
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.optimized_model_cache_dir = cache_dir.string();
+    // 权重重排会把首次加载的权重也换成对齐缓冲上的视图，这里只检查缓存映射
+    options.enable_weight_reordering = false;
+    
+    auto input = FilledTensor(Shape({2, 4}), 1.0f);
+    std::vector<std::vector<float>> results;
+    std::vector<size_t> node_counts;
+    std::string cache_file;
+    for (int run = 0; run < 2; ++run) {
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildFoldableGraph()).IsOk());
+        node_counts.push_back(session->GetGraph()->GetNodes().size());
+    
+        // 第二次加载命中缓存：折叠出的权重是缓存文件的映射视图
+        const Tensor* weight = session->GetGraph()->GetNodes()[0]->GetInputs()[1]->GetTensor().get();
+        ASSERT_NE(weight, nullptr);
+        EXPECT_EQ(weight->IsOwned(), run == 0);
+    
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(data, data + outputs[0]->GetElementCount());
+    }
+    EXPECT_EQ(node_counts[0], 1u);
+    EXPECT_EQ(node_counts[1], node_counts[0]);
+    EXPECT_EQ(results[1], results[0]);
+    
+    // 影响优化的选项不同时使用另一个缓存文件
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto unoptimized = InferenceSession::Create(options);
+    ASSERT_NE(unoptimized, nullptr);
+    ASSERT_TRUE(unoptimized->LoadModelFromGraph(BuildFoldableGraph()).IsOk());
+    EXPECT_EQ(unoptimized->GetGraph()->GetNodes().size(), 3u);
+    size_t cached_models = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir)) {
+        cached_models += entry.path().extension() == ".ium";
+    }
+    EXPECT_EQ(cached_models, 2u);
+    std::filesystem::remove_all(cache_dir);
+}
+
+// 测试共享内存发布：工作会话映射发布方优化后的图，权重是映射的视图，跳过优化Pass
+TEST_F(RuntimeTest, SharedMemoryModelPublish) {
+    const std::string name = "/inferunity_test_" + std::to_string(::getpid()) + "_" +
+                             std::to_string(reinterpret_cast<uintptr_t>(this));
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.shared_model_name = name;
+    auto publisher = InferenceSession::Create(options);
+    ASSERT_NE(publisher, nullptr);
+    ASSERT_TRUE(publisher->LoadModelFromGraph(BuildFoldableGraph()).IsOk());
+    
+    auto input = FilledTensor(Shape({2, 4}), 1.0f);
+    std::vector<std::shared_ptr<Tensor>> expected;
+    ASSERT_TRUE(publisher->Run({input.get()}, expected).IsOk());
+    ASSERT_EQ(expected.size(), 1u);
+    
+    SessionOptions worker_options = options;
+    worker_options.shared_model_name.clear();
+    worker_options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto worker = InferenceSession::Create(worker_options);
+    ASSERT_NE(worker, nullptr);
+    ASSERT_TRUE(worker->LoadModelFromSharedMemory(name).IsOk());
+    EXPECT_EQ(worker->GetGraph()->GetNodes().size(), publisher->GetGraph()->GetNodes().size());
+    const Tensor* weight = worker->GetGraph()->GetNodes()[0]->GetInputs()[1]->GetTensor().get();
+    ASSERT_NE(weight, nullptr);
+    EXPECT_FALSE(weight->IsOwned());
+    
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(worker->Run({input.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    ASSERT_EQ(outputs[0]->GetElementCount(), expected[0]->GetElementCount());
+    EXPECT_EQ(std::memcmp(outputs[0]->GetData(), expected[0]->GetData(), outputs[0]->GetSizeInBytes()), 0);
+    
+    // 删除名称后已连接的会话不受影响，新的连接失败
+    ASSERT_TRUE(UnlinkSharedCompactModel(name).IsOk());
+    ASSERT_TRUE(worker->Run({input.get()}, outputs).IsOk());
+    auto late = InferenceSession::Create(worker_options);
+    EXPECT_FALSE(late->LoadModelFromSharedMemory(name).IsOk());
+
+#if defined(__linux__)
+    // memfd发布：封印后不能再写入，映射得到同样的图
+    int fd = -1;
+    ASSERT_TRUE(PublishCompactModelToMemfd(*publisher->GetGraph(), &fd).IsOk());
+    const char byte = 0;
+    EXPECT_LT(::pwrite(fd, &byte, 1, 0), 0);
+    std::unique_ptr<Graph> graph;
+    ASSERT_TRUE(LoadCompactModelFromDescriptor(fd, graph).IsOk());
+    ::close(fd);
+    EXPECT_EQ(graph->GetNodes().size(), publisher->GetGraph()->GetNodes().size());
+#endif
+}
+
+namespace {
+
+// x[batch, 4] -> MatMul(w[4, 3]) -> Relu -> Reshape([-1]) -> y[3*batch]
+std::unique_ptr<Graph> BuildSymbolicGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    Shape x_shape({-1, 4}, {true, false});
+    x_shape.symbols = {"batch", ""};
+    x->SetTensor(std::make_shared<Tensor>(x_shape, DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    Value* w = graph->AddValue();
+    w->SetName("w");
+    w->SetTensor(FilledTensor(Shape({4, 3}), 0.5f));
+    Value* target = graph->AddValue();
+    target->SetName("target");
+    auto target_tensor = CreateTensor(Shape({1}), DataType::INT64);
+    static_cast<int64_t*>(target_tensor->GetData())[0] = -1;
+    target->SetTensor(target_tensor);
+    
+    Value* h = graph->AddValue();
+    h->SetName("h");
+    Value* r = graph->AddValue();
+    r->SetName("r");
+    Value* y = graph->AddValue();
+    y->SetName("y");
+    Node* matmul = graph->AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    matmul->AddOutput(h);
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(h);
+    relu->AddOutput(r);
+    Node* reshape = graph->AddNode("Reshape", "reshape");
+    reshape->AddInput(r);
+    reshape->AddInput(target);
+    reshape->AddOutput(y);
+    graph->AddOutput(y);
+    return graph;
+}
+
+std::vector<float> SymbolicGraphReference(const Tensor& x) {
+    auto w = FilledTensor(Shape({4, 3}), 0.5f);
+    const float* xd = static_cast<const float*>(x.GetData());
+    const float* wd = static_cast<const float*>(w->GetData());
+    const int64_t rows = x.GetShape().dims[0];
+    std::vector<float> y(static_cast<size_t>(rows * 3));
+    for (int64_t i = 0; i < rows; ++i) {
+        for (int64_t j = 0; j < 3; ++j) {
+            float sum = 0.0f;
+            for (int64_t k = 0; k < 4; ++k) {
+                sum += xd[i * 4 + k] * wd[k * 3 + j];
+            }
+            y[static_cast<size_t>(i * 3 + j)] = std::max(sum, 0.0f);
+        }
+    }
+    return y;
+}
+
+} // anonymous namespace
+
+// 测试符号形状推断：图输入的动态维度作为符号传播，乘积形式的维度记录为表达式
+TEST_F(RuntimeTest, SymbolicShapeInference) {
+    auto graph = BuildSymbolicGraph();
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    
+    const Shape& h = graph->FindValueByName("h")->GetShape();
+    ASSERT_EQ(h.dims.size(), 2u);
+    EXPECT_TRUE(h.is_dynamic[0]);
+    EXPECT_EQ(h.symbols[0], "batch");
+    EXPECT_FALSE(h.is_dynamic[1]);
+    EXPECT_EQ(h.dims[1], 3);
+    const Shape& y = graph->FindValueByName("y")->GetShape();
+    ASSERT_EQ(y.dims.size(), 1u);
+    EXPECT_TRUE(y.is_dynamic[0]);
+    EXPECT_EQ(y.symbols[0], "3*batch");
+    
+    ShapeSymbolBindings bindings;
+    auto x = FilledTensor(Shape({5, 4}), 1.0f);
+    ASSERT_TRUE(BindShapeSymbols(*graph, {x.get()}, &bindings).IsOk());
+    EXPECT_EQ(bindings.at("batch"), 5);
+    Shape resolved;
+    ASSERT_TRUE(ResolveSymbolicShape(y, bindings, &resolved));
+    EXPECT_EQ(resolved.dims, std::vector<int64_t>({15}));
+    EXPECT_EQ(EvaluateSymbolicDim("2*batch*batch", bindings), 50);
+    EXPECT_EQ(EvaluateSymbolicDim("seq", bindings), -1);
+    
+    // 秩与声明不符
+    auto wrong_rank = FilledTensor(Shape({5}), 1.0f);
+    ShapeSymbolBindings unused;
+    EXPECT_FALSE(BindShapeSymbols(*graph, {wrong_rank.get()}, &unused).IsOk());
+}
+
+// 测试形状特化的计划：每种输入形状规划一次，再次出现时命中缓存
+TEST_F(RuntimeTest, ShapeSpecializedPlans) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.max_shape_specialized_plans = 2;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSymbolicGraph()).IsOk());
+    EXPECT_EQ(session->GetInputShapes()[0].symbols[0], "batch");
+    
+    const std::vector<int64_t> batches = {2, 5, 2, 7, 5};
+    for (int64_t batch : batches) {
+        auto x = FilledTensor(Shape({batch, 4}), 0.25f);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        EXPECT_EQ(std::vector<float>(data, data + outputs[0]->GetElementCount()), SymbolicGraphReference(*x));
+    
+        // 串行路径使用同一个计划
+        std::vector<Tensor*> sequential;
+        ASSERT_TRUE(session->Run(std::vector<Tensor*>{x.get()}, sequential).IsOk());
+        ASSERT_EQ(sequential.size(), 1u);
+        data = static_cast<const float*>(sequential[0]->GetData());
+        EXPECT_EQ(std::vector<float>(data, data + sequential[0]->GetElementCount()), SymbolicGraphReference(*x));
+    }
+    // 2、5各规划一次后2命中；7淘汰最久未用的5，最后的5重新规划
+    EXPECT_EQ(session->GetNumShapeSpecializedPlans(), 2u);
+    EXPECT_EQ(session->GetShapeSpecializedPlanHits(), 6u);
+}
+
+// 测试预热：加载时按给定的形状桶运行，之后的请求命中已有的特化计划与执行状态
+TEST_F(RuntimeTest, WarmupBuildsShapeBuckets) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.warmup_on_load = true;
+    options.warmup_input_shapes = {{Shape({2, 4})}, {Shape({5, 4})}};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSymbolicGraph()).IsOk());
+    EXPECT_TRUE(session->IsWarm());
+    EXPECT_EQ(session->GetNumShapeSpecializedPlans(), 2u);
+    
+    WarmupStats stats;
+    ASSERT_TRUE(session->Warmup(&stats).IsOk());
+    EXPECT_EQ(stats.shapes, 2u);
+    EXPECT_EQ(stats.runs, 4u);
+    EXPECT_GE(stats.touched_weight_bytes, 4u * 3u * sizeof(float));
+    if (session->SupportsConcurrentRun()) {
+        EXPECT_EQ(stats.prepared_states, 2u * options.execution_state_pool_size);
+    }
+    
+    // 预热过的形状直接命中，结果不受预热的零输入影响
+    const uint64_t hits = session->GetShapeSpecializedPlanHits();
+    auto x = FilledTensor(Shape({5, 4}), 0.25f);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    const float* data = static_cast<const float*>(outputs[0]->GetData());
+    EXPECT_EQ(std::vector<float>(data, data + outputs[0]->GetElementCount()), SymbolicGraphReference(*x));
+    EXPECT_EQ(session->GetShapeSpecializedPlanHits(), hits + 1);
+    EXPECT_EQ(session->GetNumShapeSpecializedPlans(), 2u);
+    
+    // 形状个数与图输入不符时报错；重新加载后回到未预热
+    SessionOptions bad_options = options;
+    bad_options.warmup_input_shapes = {{Shape({2, 4}), Shape({2, 4})}};
+    session->SetOptions(bad_options);
+    EXPECT_FALSE(session->Warmup().IsOk());
+    bad_options.warmup_on_load = false;
+    session->SetOptions(bad_options);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSymbolicGraph()).IsOk());
+    EXPECT_FALSE(session->IsWarm());
+}
+
+// 测试形状计算分区：Shape -> Gather -> Mul -> Concat在绑定输入时于主机上求值，计划中不再执行这些步骤
+TEST_F(RuntimeTest, HostShapeEvaluation) {
+    // x[batch, 4] -> Relu -> r；r的形状[batch, 4] -> [2*batch, 2] -> Reshape -> y
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    Shape x_shape({-1, 4}, {true, false});
+    x_shape.symbols = {"batch", ""};
+    x->SetTensor(std::make_shared<Tensor>(x_shape, DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    auto int_constant = [&graph](const char* name, const std::vector<int64_t>& data) {
+        Value* value = graph->AddValue();
+        value->SetName(name);
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(data.size())}), DataType::INT64);
+        std::copy(data.begin(), data.end(), static_cast<int64_t*>(tensor->GetData()));
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto add_node = [&graph](const char* op_type, std::vector<Value*> inputs, const char* output_name) {
+        Node* node = graph->AddNode(op_type, output_name);
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        output->SetName(output_name);
+        node->AddOutput(output);
+        return node;
+    };
+    Value* r = add_node("Relu", {x}, "r")->GetOutputs()[0];
+    Value* s = add_node("Shape", {r}, "s")->GetOutputs()[0];
+    Value* g = add_node("Gather", {s, int_constant("index", {0})}, "g")->GetOutputs()[0];
+    Value* m = add_node("Mul", {g, int_constant("two", {2})}, "m")->GetOutputs()[0];
+    Node* concat = add_node("Concat", {m, int_constant("last", {2})}, "t");
+    concat->SetAttribute("axis", AttributeValue(int64_t(0)));
+    Value* y = add_node("Reshape", {r, concat->GetOutputs()[0]}, "y")->GetOutputs()[0];
+    graph->AddOutput(y);
+    
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    const ExecutionPlan* plan = session->GetExecutionPlan();
+    ASSERT_NE(plan, nullptr);
+    ASSERT_NE(plan->GetShapeProgram(), nullptr);
+    EXPECT_EQ(plan->GetShapeProgram()->GetNumNodes(), 4u);
+    EXPECT_EQ(plan->GetShapeProgram()->GetOutputSlots().size(), 1u);  // 只有Reshape读取
+    size_t host_steps = 0;
+    for (const ExecutionStep& step : plan->GetSteps()) {
+        host_steps += step.host_shape ? 1 : 0;
+    }
+    EXPECT_EQ(host_steps, 4u);
+    
+    for (int64_t batch : {3, 5}) {
+        auto input = CreateTensor(Shape({batch, 4}), DataType::FLOAT32);
+        float* data = static_cast<float*>(input->GetData());
+        for (int64_t i = 0; i < batch * 4; ++i) {
+            data[i] = static_cast<float>(i % 3) - 1.0f;
+        }
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({input.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0]->GetShape().dims, std::vector<int64_t>({2 * batch, 2}));
+        std::vector<Tensor*> sequential;
+        ASSERT_TRUE(session->Run(std::vector<Tensor*>{input.get()}, sequential).IsOk());
+        ASSERT_EQ(sequential.size(), 1u);
+        EXPECT_EQ(sequential[0]->GetShape().dims, std::vector<int64_t>({2 * batch, 2}));
+        const float* result = static_cast<const float*>(sequential[0]->GetData());
+        for (int64_t i = 0; i < batch * 4; ++i) {
+            EXPECT_EQ(result[i], std::max(data[i], 0.0f));
+        }
+    }
+}
+
+TEST_F(RuntimeTest, LoadStageTimings) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.warmup_on_load = true;
+    options.warmup_input_shapes = {{Shape({2, 4})}};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSymbolicGraph()).IsOk());
+    
+    std::vector<std::string> stages;
+    for (const auto& timing : session->GetLoadStageTimings()) {
+        EXPECT_GE(timing.second, 0.0) << timing.first;
+        stages.push_back(timing.first);
+    }
+    for (const char* stage : {"Validate", "InferShapes", "Optimize", "PartitionGraph",
+                              "PrepareExecution:CPU", "BuildExecutionPlan", "Warmup"}) {
+        EXPECT_NE(std::find(stages.begin(), stages.end(), stage), stages.end()) << stage;
+    }
+    EXPECT_EQ(stages.back(), "Warmup");
+    
+    // 重新加载时清空上一次的计时
+    const size_t count = stages.size();
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSymbolicGraph()).IsOk());
+    EXPECT_EQ(session->GetLoadStageTimings().size(), count);
+}
+
+namespace {
+
+// x[2,3,4] -> Relu -> Transpose(0,2,1) -> Slice(axis 1, 1:4:2) -> Reshape([4,3]) -> Relu -> y
+std::unique_ptr<Graph> BuildLayoutGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({2, 3, 4}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    Value* target = graph->AddValue();
+    target->SetName("target");
+    auto target_tensor = CreateTensor(Shape({2}), DataType::INT64);
+    static_cast<int64_t*>(target_tensor->GetData())[0] = 4;
+    static_cast<int64_t*>(target_tensor->GetData())[1] = 3;
+    target->SetTensor(target_tensor);
+    
+    const char* names[] = {"a", "t", "s", "r", "y"};
+    Value* values[5];
+    for (int i = 0; i < 5; ++i) {
+        values[i] = graph->AddValue();
+        values[i]->SetName(names[i]);
+    }
+    Node* relu = graph->AddNode("Relu", "relu");
+    relu->AddInput(x);
+    relu->AddOutput(values[0]);
+    Node* transpose = graph->AddNode("Transpose", "transpose");
+    transpose->SetAttribute("perm", AttributeValue(std::vector<int64_t>{0, 2, 1}));
+    transpose->AddInput(values[0]);
+    transpose->AddOutput(values[1]);
+    Node* slice = graph->AddNode("Slice", "slice");
+    slice->SetAttribute("starts", AttributeValue(std::vector<int64_t>{1}));
+    slice->SetAttribute("ends", AttributeValue(std::vector<int64_t>{4}));
+    slice->SetAttribute("axes", AttributeValue(std::vector<int64_t>{1}));
+    slice->SetAttribute("steps", AttributeValue(std::vector<int64_t>{2}));
+    slice->AddInput(values[1]);
+    slice->AddOutput(values[2]);
+    Node* reshape = graph->AddNode("Reshape", "reshape");
+    reshape->AddInput(values[2]);
+    reshape->AddInput(target);
+    reshape->AddOutput(values[3]);
+    Node* relu_out = graph->AddNode("Relu", "relu_out");
+    relu_out->AddInput(values[3]);
+    relu_out->AddOutput(values[4]);
+    graph->AddOutput(values[4]);
+    return graph;
+}
+
+std::vector<float> LayoutGraphReference(const Tensor& x) {
+    const float* xd = static_cast<const float*>(x.GetData());
+    std::vector<float> y;
+    for (int64_t n = 0; n < 2; ++n) {
+        for (int64_t w = 1; w < 4; w += 2) {
+            for (int64_t c = 0; c < 3; ++c) {
+                y.push_back(std::max(xd[(n * 3 + c) * 4 + w], 0.0f));
+            }
+        }
+    }
+    return y;
+}
+
+} // anonymous namespace
+
+// 测试视图步骤：Transpose/Slice输出为步长视图，Reshape遇到非连续输入时先拷成连续张量再执行
+TEST_F(RuntimeTest, StridedViewSteps) {
+    auto graph = BuildLayoutGraph();
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    std::unordered_map<std::string, TensorLifetime> lifetimes;
+    for (const auto& lifetime : AnalyzeTensorLifetimes(graph.get())) {
+        lifetimes[static_cast<Value*>(lifetime.value_ptr)->GetName()] = lifetime;
+    }
+    EXPECT_FALSE(lifetimes["a"].is_alias);
+    EXPECT_TRUE(lifetimes["t"].is_alias);
+    EXPECT_TRUE(lifetimes["s"].is_alias);
+    EXPECT_FALSE(lifetimes["y"].is_alias);
+    // a的存储要保留到最后一个视图被读取
+    EXPECT_EQ(lifetimes["a"].death, lifetimes["r"].death);
+    
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildLayoutGraph()).IsOk());
+    
+    for (float scale : {0.5f, -1.0f}) {
+        auto x = FilledTensor(Shape({2, 3, 4}), scale);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0]->GetShape().dims, std::vector<int64_t>({4, 3}));
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        EXPECT_EQ(std::vector<float>(data, data + outputs[0]->GetElementCount()), LayoutGraphReference(*x));
+    
+        std::vector<Tensor*> sequential;
+        ASSERT_TRUE(session->Run(std::vector<Tensor*>{x.get()}, sequential).IsOk());
+        ASSERT_EQ(sequential.size(), 1u);
+        data = static_cast<const float*>(sequential[0]->GetData());
+        EXPECT_EQ(std::vector<float>(data, data + sequential[0]->GetElementCount()), LayoutGraphReference(*x));
+    }
+}
+
+namespace {
+
+// x[1,3,12,12] -> Conv(16) -> Relu -> MaxPool(2x2) -> Conv(16) -> Add(pool) -> Relu -> y
+std::unique_ptr<Graph> BuildCnnBlockGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({1, 3, 12, 12}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    auto constant = [&](const Shape& shape, float scale) {
+        Value* value = graph->AddValue();
+        value->SetTensor(FilledTensor(shape, scale));
+        return value;
+    };
+    auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        node->AddOutput(output);
+        return node;
+    };
+    Node* conv1 = apply("Conv", {x, constant(Shape({16, 3, 3, 3}), 0.1f), constant(Shape({16}), 0.05f)});
+    conv1->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    Node* relu1 = apply("Relu", {conv1->GetOutputs()[0]});
+    Node* pool = apply("MaxPool", {relu1->GetOutputs()[0]});
+    pool->SetAttribute("kernel_shape", AttributeValue(std::vector<int64_t>{2, 2}));
+    pool->SetAttribute("strides", AttributeValue(std::vector<int64_t>{2, 2}));
+    Node* conv2 = apply("Conv", {pool->GetOutputs()[0], constant(Shape({16, 16, 3, 3}), 0.02f)});
+    conv2->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    Node* add = apply("Add", {conv2->GetOutputs()[0], pool->GetOutputs()[0]});
+    Node* relu2 = apply("Relu", {add->GetOutputs()[0]});
+    relu2->GetOutputs()[0]->SetName("y");
+    graph->AddOutput(relu2->GetOutputs()[0]);
+    return graph;
+}
+
+} // anonymous namespace
+
+// 分块通道布局：卷积链在NCHWc布局上执行，只在图输入输出处重排，结果与NCHW执行一致
+TEST_F(RuntimeTest, BlockedLayoutMatchesNchw) {
+    auto graph = BuildCnnBlockGraph();
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    MemoryLayoutOptimizationPass pass(8);
+    ASSERT_TRUE(pass.Run(graph.get()).IsOk());
+    std::unordered_map<std::string, int> op_counts;
+    for (const auto& node : graph->GetNodes()) {
+        ++op_counts[node->GetOpType()];
+    }
+    EXPECT_EQ(op_counts["ReorderInput"], 1);
+    EXPECT_EQ(op_counts["ReorderOutput"], 1);
+    EXPECT_EQ(op_counts["NchwcConv"], 2);
+    EXPECT_EQ(op_counts["NchwcMaxPool"], 1);
+    EXPECT_EQ(op_counts["Conv"], 0);
+    EXPECT_EQ(graph->GetOutputs()[0]->GetTensor()->GetShape().dims, (std::vector<int64_t>{1, 16, 6, 6}));
+    
+    auto x = FilledTensor(Shape({1, 3, 12, 12}), 0.25f);
+    std::vector<std::vector<float>> results;
+    for (bool blocked : {false, true}) {
+        SessionOptions options;
+        options.execution_providers = {"CPUExecutionProvider"};
+        options.enable_blocked_layout = blocked;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+        bool has_reorder = false;
+        for (const auto& node : session->GetGraph()->GetNodes()) {
+            has_reorder |= node->GetOpType() == "ReorderInput";
+        }
+        EXPECT_EQ(has_reorder, blocked);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0]->GetShape().dims, (std::vector<int64_t>{1, 16, 6, 6}));
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(data, data + outputs[0]->GetElementCount());
+    }
+    ASSERT_EQ(results[0].size(), results[1].size());
+    for (size_t i = 0; i < results[0].size(); ++i) {
+        ASSERT_NEAR(results[1][i], results[0][i], 1e-4f) << "at " << i;
+    }
+}
+
+// 图像预处理：会话直接接受uint8 NHWC图像，与调用方先归一化、转置再Run的结果一致；
+// 分块布局下预处理直接写出NCHWc，不再插入ReorderInput
+TEST_F(RuntimeTest, ImagePreprocessFeedsBlockedLayout) {
+    const int64_t h = 12, w = 12, c = 3;
+    std::vector<uint8_t> pixels(static_cast<size_t>(h * w * c));
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<uint8_t>((i * 37) % 251);
+    }
+    auto image = CreateTensor(Shape({1, h, w, c}), DataType::UINT8);
+    std::memcpy(image->GetData(), pixels.data(), pixels.size());
+    auto normalized = CreateTensor(Shape({1, c, h, w}), DataType::FLOAT32);
+    float* x = static_cast<float*>(normalized->GetData());
+    for (int64_t ch = 0; ch < c; ++ch) {
+        for (int64_t i = 0; i < h * w; ++i) {
+            x[ch * h * w + i] = (pixels[i * c + ch] / 255.0f - 0.5f) / 0.25f;
+        }
+    }
+    
+    std::vector<std::vector<float>> results;
+    for (bool preprocess : {false, true}) {
+        SessionOptions options;
+        options.execution_providers = {"CPUExecutionProvider"};
+        options.enable_blocked_layout = true;
+        options.enable_image_preprocess = preprocess;
+        options.image_preprocess.scale = 1.0f / 255.0f;
+        options.image_preprocess.mean = {0.5f};
+        options.image_preprocess.std = {0.25f};
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+        std::unordered_map<std::string, int> op_counts;
+        for (const auto& node : session->GetGraph()->GetNodes()) {
+            ++op_counts[node->GetOpType()];
+            if (node->GetOpType() == "ImagePreprocess") {
+                EXPECT_EQ(node->GetAttribute("layout"), "NCHWc");
+            }
+        }
+        EXPECT_EQ(op_counts["ImagePreprocess"], preprocess ? 1 : 0);
+        EXPECT_EQ(op_counts["ReorderInput"], preprocess ? 0 : 1);
+        EXPECT_EQ(session->GetGraph()->GetInputs()[0]->GetDataType(), preprocess ? DataType::UINT8 : DataType::FLOAT32);
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({preprocess ? image.get() : normalized.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(data, data + outputs[0]->GetElementCount());
+    }
+    ASSERT_EQ(results[0].size(), results[1].size());
+    for (size_t i = 0; i < results[0].size(); ++i) {
+        ASSERT_NEAR(results[1][i], results[0][i], 1e-3f) << "at " << i;
+    }
+}
+
+// 内存估计不分配arena：激活内存与按相同输入形状加载的会话的规划一致，权重为优化后图中的常量
+TEST_F(RuntimeTest, EstimateMemoryMatchesLoadedSession) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    const Shape batch2({2, 3, 12, 12});
+    MemoryEstimate estimate;
+    ASSERT_TRUE(InferenceSession::EstimateMemory(BuildCnnBlockGraph(), options, {batch2}, &estimate).IsOk());
+    EXPECT_FALSE(InferenceSession::EstimateMemory(BuildCnnBlockGraph(), options, {batch2, batch2}, &estimate).IsOk());
+    
+    auto graph = BuildCnnBlockGraph();
+    graph->GetInputs()[0]->SetTensor(std::make_shared<Tensor>(batch2, DataType::FLOAT32, nullptr));
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(graph)).IsOk());
+    size_t weights = 0;
+    for (const auto& value : session->GetGraph()->GetValues()) {
+        if (!value->GetProducer() && value->GetTensor() && value->GetTensor()->GetData() &&
+            value.get() != session->GetGraph()->GetInputs()[0]) {
+            weights += value->GetTensor()->GetSizeInBytes();
+        }
+    }
+    EXPECT_EQ(estimate.activation_arena, session->GetMemoryPlan().arena_size);
+    EXPECT_GT(estimate.activation_arena, 0u);
+    EXPECT_EQ(estimate.weights, weights);
+    EXPECT_EQ(estimate.outputs, static_cast<size_t>(2 * 16 * 6 * 6) * sizeof(float));
+    EXPECT_GT(estimate.prepacked_weights, 0u);
+    EXPECT_EQ(estimate.kv_cache, 0u);
+    EXPECT_EQ(estimate.Total(), estimate.weights + estimate.prepacked_weights + estimate.activation_arena +
+                                estimate.outputs + estimate.scratch);
+    EXPECT_NE(estimate.ToString().find("activation_arena"), std::string::npos);
+}
+
+// 分块布局上的全局池化直接输出NCHW的[N, C, 1, 1]，图输出前不再需要ReorderOutput
+TEST_F(RuntimeTest, BlockedLayoutGlobalPoolWritesNchw) {
+    auto build = [] {
+        auto graph = BuildCnnBlockGraph();
+        Value* y = graph->GetOutputs()[0];
+        y->SetName("features");
+        Node* pool = graph->AddNode("GlobalAveragePool", "gap");
+        pool->AddInput(y);
+        Value* output = graph->AddValue();
+        output->SetName("y");
+        pool->AddOutput(output);
+        graph->ReplaceOutput(y, output);
+        return graph;
+    };
+    auto graph = build();
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    MemoryLayoutOptimizationPass pass(8);
+    ASSERT_TRUE(pass.Run(graph.get()).IsOk());
+    std::unordered_map<std::string, int> op_counts;
+    for (const auto& node : graph->GetNodes()) {
+        ++op_counts[node->GetOpType()];
+    }
+    EXPECT_EQ(op_counts["NchwcGlobalAveragePool"], 1);
+    EXPECT_EQ(op_counts["GlobalAveragePool"], 0);
+    EXPECT_EQ(op_counts["ReorderOutput"], 0);
+    
+    auto x = FilledTensor(Shape({1, 3, 12, 12}), 0.25f);
+    std::vector<std::vector<float>> results;
+    for (bool blocked : {false, true}) {
+        SessionOptions options;
+        options.execution_providers = {"CPUExecutionProvider"};
+        options.enable_blocked_layout = blocked;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(build()).IsOk());
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+        ASSERT_EQ(outputs.size(), 1u);
+        EXPECT_EQ(outputs[0]->GetShape().dims, (std::vector<int64_t>{1, 16, 1, 1}));
+        const float* data = static_cast<const float*>(outputs[0]->GetData());
+        results.emplace_back(data, data + outputs[0]->GetElementCount());
+    }
+    for (size_t i = 0; i < results[0].size(); ++i) {
+        ASSERT_NEAR(results[1][i], results[0][i], 1e-4f) << "at " << i;
+    }
+}
+
+namespace {
+
+std::shared_ptr<Tensor> PseudoRandomTensor(const Shape& shape, float scale, uint32_t seed) {
+    auto tensor = CreateTensor(shape, DataType::FLOAT32);
+    float* data = static_cast<float*>(tensor->GetData());
+    uint32_t state = seed;
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = (static_cast<float>((state >> 8) & 0xFFFF) / 65535.0f - 0.5f) * 2.0f * scale;
+    }
+    return tensor;
+}
+
+// x[1,3,10,10] -> Conv(8, 3x3, bias) -> Relu -> Conv(4, 1x1) -> Reshape[4,100] -> Transpose -> MatMul(w[4,6]) -> y
+std::unique_ptr<Graph> BuildQuantizableGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({1, 3, 10, 10}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    auto constant = [&](const std::shared_ptr<Tensor>& tensor) {
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        output->SetName(node->GetName() + "_out");
+        node->AddOutput(output);
+        return node;
+    };
+    Node* conv1 = apply("Conv", {x, constant(PseudoRandomTensor(Shape({8, 3, 3, 3}), 0.4f, 1)),
+                                 constant(PseudoRandomTensor(Shape({8}), 0.1f, 2))});
+    conv1->SetAttribute("pads", AttributeValue(std::vector<int64_t>{1, 1, 1, 1}));
+    Node* relu = apply("Relu", {conv1->GetOutputs()[0]});
+    Node* conv2 = apply("Conv", {relu->GetOutputs()[0], constant(PseudoRandomTensor(Shape({4, 8, 1, 1}), 0.5f, 3))});
+    auto shape = CreateTensor(Shape({2}), DataType::INT64);
+    static_cast<int64_t*>(shape->GetData())[0] = 4;
+    static_cast<int64_t*>(shape->GetData())[1] = 100;
+    Node* reshape = apply("Reshape", {conv2->GetOutputs()[0], constant(shape)});
+    Node* transpose = apply("Transpose", {reshape->GetOutputs()[0]});
+    transpose->SetAttribute("perm", AttributeValue(std::vector<int64_t>{1, 0}));
+    Node* matmul = apply("MatMul", {transpose->GetOutputs()[0], constant(PseudoRandomTensor(Shape({4, 6}), 0.5f, 4))});
+    matmul->GetOutputs()[0]->SetName("y");
+    graph->AddOutput(matmul->GetOutputs()[0]);
+    return graph;
+}
+
+// x[8,16] -> MatMul(w[16,4]) -> y
+std::unique_ptr<Graph> BuildSingleMatMulGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({8, 16}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    Value* w = graph->AddValue();
+    w->SetTensor(PseudoRandomTensor(Shape({16, 4}), 0.5f, 5));
+    Node* matmul = graph->AddNode("MatMul", "matmul");
+    matmul->AddInput(x);
+    matmul->AddInput(w);
+    Value* y = graph->AddValue();
+    y->SetName("y");
+    matmul->AddOutput(y);
+    graph->AddOutput(y);
+    return graph;
+}
+
+} // anonymous namespace
+
+// 校准：MinMax保留离群值，Percentile与Entropy把它截掉；范围总是包含0
+TEST_F(RuntimeTest, CalibrationMethods) {
+    auto graph = BuildSingleMatMulGraph();
+    std::vector<std::vector<std::shared_ptr<Tensor>>> dataset;
+    for (uint32_t seed = 0; seed < 4; ++seed) {
+        auto x = PseudoRandomTensor(Shape({8, 16}), 1.0f, 100 + seed);
+        if (seed == 0) {
+            static_cast<float*>(x->GetData())[3] = 50.0f;
+        }
+        dataset.push_back({x});
+    }
+    std::unordered_map<int, TensorRange> ranges;
+    for (CalibrationMethod method : {CalibrationMethod::MIN_MAX, CalibrationMethod::PERCENTILE,
+                                     CalibrationMethod::ENTROPY}) {
+        QuantizationOptions options;
+        options.calibration_method = method;
+        options.percentile = 99.0f;
+        CalibrationTable table;
+        ASSERT_TRUE(CalibrationRunner(options).Run(*graph, dataset, &table).IsOk());
+        ASSERT_EQ(table.count("x"), 1u);
+        ASSERT_EQ(table.count("y"), 1u);
+        EXPECT_LE(table["y"].min, 0.0f);
+        EXPECT_GE(table["y"].max, 0.0f);
+        ranges[static_cast<int>(method)] = table["x"];
+    }
+    EXPECT_FLOAT_EQ(ranges[static_cast<int>(CalibrationMethod::MIN_MAX)].max, 50.0f);
+    EXPECT_LT(ranges[static_cast<int>(CalibrationMethod::PERCENTILE)].max, 2.0f);
+    EXPECT_LT(ranges[static_cast<int>(CalibrationMethod::ENTROPY)].max, 10.0f);
+    EXPECT_GT(ranges[static_cast<int>(CalibrationMethod::ENTROPY)].max, 0.5f);
+    EXPECT_LT(ranges[static_cast<int>(CalibrationMethod::PERCENTILE)].min, -0.5f);
+}
+
+// 训练后量化：校准后的会话把Conv(+Relu)/MatMul折叠为QLinearConv/QLinearMatMul，结果接近浮点
+TEST_F(RuntimeTest, PostTrainingQuantization) {
+    std::vector<std::vector<std::shared_ptr<Tensor>>> dataset;
+    for (uint32_t seed = 0; seed < 8; ++seed) {
+        dataset.push_back({PseudoRandomTensor(Shape({1, 3, 10, 10}), 1.0f, 200 + seed)});
+    }
+    auto table = std::make_shared<CalibrationTable>();
+    auto graph = BuildQuantizableGraph();
+    ASSERT_TRUE(CalibrationRunner().Run(*graph, dataset, table.get()).IsOk());
+    
+    SessionOptions float_options;
+    float_options.execution_providers = {"CPUExecutionProvider"};
+    auto float_session = InferenceSession::Create(float_options);
+    ASSERT_NE(float_session, nullptr);
+    ASSERT_TRUE(float_session->LoadModelFromGraph(BuildQuantizableGraph()).IsOk());
+    
+    for (DataType dtype : {DataType::INT8, DataType::UINT8}) {
+        SessionOptions options = float_options;
+        options.enable_quantization = true;
+        options.quantization_dtype = dtype;
+        options.quantization_calibration = table;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildQuantizableGraph()).IsOk());
+        std::unordered_map<std::string, int> op_counts;
+        for (const auto& node : session->GetGraph()->GetNodes()) {
+            ++op_counts[node->GetOpType()];
+        }
+        EXPECT_EQ(op_counts["QLinearConv"], 2);
+        EXPECT_EQ(op_counts["QLinearMatMul"], 1);
+        EXPECT_EQ(op_counts["Conv"] + op_counts["MatMul"] + op_counts["Relu"], 0);
+        EXPECT_EQ(op_counts["QuantizeLinear"], 2);  // 图输入与Transpose之后（Reshape/Transpose在浮点上执行）
+    
+        const TensorRange& y_range = table->at("y");
+        const float tolerance = 0.05f * (y_range.max - y_range.min);
+        for (const auto& sample : dataset) {
+            std::vector<std::shared_ptr<Tensor>> expected, actual;
+            ASSERT_TRUE(float_session->Run({sample[0].get()}, expected).IsOk());
+            ASSERT_TRUE(session->Run({sample[0].get()}, actual).IsOk());
+            ASSERT_EQ(actual.size(), 1u);
+            ASSERT_EQ(actual[0]->GetDataType(), DataType::FLOAT32);
+            ASSERT_EQ(actual[0]->GetShape().dims, (std::vector<int64_t>{100, 6}));
+            const float* e = static_cast<const float*>(expected[0]->GetData());
+            const float* a = static_cast<const float*>(actual[0]->GetData());
+            for (size_t i = 0; i < actual[0]->GetElementCount(); ++i) {
+                ASSERT_NEAR(a[i], e[i], tolerance) << "at " << i;
+            }
+        }
+    }
+}
+
+// 混合精度搜索：宽松的误差预算下各层都降低精度，结果图以原生格式写出后可直接加载；
+// 预算过严时保持FP32
+TEST_F(RuntimeTest, MixedPrecisionSearch) {
+    std::vector<std::vector<std::shared_ptr<Tensor>>> dataset;
+    for (uint32_t seed = 0; seed < 4; ++seed) {
+        dataset.push_back({PseudoRandomTensor(Shape({1, 3, 10, 10}), 1.0f, 300 + seed)});
+    }
+    auto graph = BuildQuantizableGraph();
+    const std::string path = (std::filesystem::path(::testing::TempDir()) / "inferunity_mixed_precision.ium").string();
+    
+    PrecisionSearchOptions options;
+    options.tolerance = 0.2;
+    options.output_path = path;
+    std::unique_ptr<Graph> lowered;
+    PrecisionSearchResult result;
+    ASSERT_TRUE(SearchMixedPrecision(*graph, dataset, options, &lowered, &result).IsOk());
+    ASSERT_NE(lowered, nullptr);
+    ASSERT_EQ(result.layers.size(), 3u);
+    for (const LayerPrecision& layer : result.layers) {
+        EXPECT_NE(layer.precision, DataType::FLOAT32) << layer.node_name;
+    }
+    EXPECT_LE(result.accuracy, 0.2);
+    EXPECT_GE(result.evaluations, 3u);
+    
+    std::unique_ptr<Graph> loaded;
+    ASSERT_TRUE(LoadCompactModel(path, loaded).IsOk());
+    std::remove(path.c_str());
+    SessionOptions session_options;
+    session_options.execution_providers = {"CPUExecutionProvider"};
+    auto float_session = InferenceSession::Create(session_options);
+    ASSERT_TRUE(float_session->LoadModelFromGraph(BuildQuantizableGraph()).IsOk());
+    session_options.enable_quantization = true;
+    auto session = InferenceSession::Create(session_options);
+    ASSERT_TRUE(session->LoadModelFromGraph(std::move(loaded)).IsOk());
+    std::vector<std::shared_ptr<Tensor>> expected, actual;
+    ASSERT_TRUE(float_session->Run({dataset[0][0].get()}, expected).IsOk());
+    ASSERT_TRUE(session->Run({dataset[0][0].get()}, actual).IsOk());
+    ASSERT_EQ(actual[0]->GetElementCount(), expected[0]->GetElementCount());
+    const float* e = static_cast<const float*>(expected[0]->GetData());
+    const float* a = static_cast<const float*>(actual[0]->GetData());
+    float scale = 0.0f;
+    for (size_t i = 0; i < expected[0]->GetElementCount(); ++i) {
+        scale = std::max(scale, std::fabs(e[i]));
+    }
+    for (size_t i = 0; i < expected[0]->GetElementCount(); ++i) {
+        ASSERT_NEAR(a[i], e[i], 0.2f * scale) << "at " << i;
+    }
+    
+    // 只有MatMul可以转为BF16，误差超出预算时保持FP32
+    options.tolerance = 1e-9;
+    options.candidates = {DataType::BFLOAT16};
+    options.output_path.clear();
+    ASSERT_TRUE(SearchMixedPrecision(*graph, dataset, options, &lowered, &result).IsOk());
+    ASSERT_EQ(result.layers.size(), 1u);
+    EXPECT_EQ(result.layers[0].op_type, "MatMul");
+    EXPECT_EQ(result.layers[0].precision, DataType::FLOAT32);
+    EXPECT_EQ(result.evaluations, 1u);
+    EXPECT_EQ(lowered->GetNodeByName(result.layers[0].node_name)->GetInputs()[1]->GetDataType(), DataType::FLOAT32);
+}
+
+// x[32,64] -> MatMul(w1) -> Add(b1) -> Softmax -> MatMul(w2) -> y；w3被MatMul和Add共用，保持FP32
+std::unique_ptr<Graph> BuildMixedPrecisionGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({32, 64}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    auto constant = [&](const std::shared_ptr<Tensor>& tensor) {
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        output->SetName(node->GetName() + "_out");
+        node->AddOutput(output);
+        return node;
+    };
+    Node* mm1 = apply("MatMul", {x, constant(PseudoRandomTensor(Shape({64, 96}), 0.5f, 31))});
+    Node* add = apply("Add", {mm1->GetOutputs()[0], constant(PseudoRandomTensor(Shape({96}), 0.1f, 32))});
+    Node* softmax = apply("Softmax", {add->GetOutputs()[0]});
+    softmax->SetAttribute("axis", AttributeValue(static_cast<int64_t>(-1)));
+    Node* mm2 = apply("MatMul", {softmax->GetOutputs()[0], constant(PseudoRandomTensor(Shape({96, 32}), 4.0f, 33))});
+    Value* shared = constant(PseudoRandomTensor(Shape({32, 32}), 0.5f, 34));
+    Node* mm3 = apply("MatMul", {mm2->GetOutputs()[0], shared});
+    Node* residual = apply("Add", {mm3->GetOutputs()[0], shared});
+    residual->GetOutputs()[0]->SetName("y");
+    graph->AddOutput(residual->GetOutputs()[0]);
+    return graph;
+}
+
+TEST_F(RuntimeTest, MixedPrecisionWeights) {
+    SessionOptions float_options;
+    float_options.execution_providers = {"CPUExecutionProvider"};
+    auto float_session = InferenceSession::Create(float_options);
+    ASSERT_NE(float_session, nullptr);
+    ASSERT_TRUE(float_session->LoadModelFromGraph(BuildMixedPrecisionGraph()).IsOk());
+    auto x = PseudoRandomTensor(Shape({32, 64}), 1.0f, 35);
+    std::vector<std::shared_ptr<Tensor>> expected;
+    ASSERT_TRUE(float_session->Run({x.get()}, expected).IsOk());
+    ASSERT_EQ(expected.size(), 1u);
+    
+    struct Config {
+        DataType dtype;
+        bool bf16_compute;
+        float tolerance;
+    };
+    for (const Config& config : {Config{DataType::FLOAT16, false, 2e-2f},
+                                 Config{DataType::BFLOAT16, false, 1e-1f},
+                                 Config{DataType::BFLOAT16, true, 1e-1f}}) {
+        SessionOptions options = float_options;
+        options.mixed_precision_weight_dtype = config.dtype;
+        options.allow_bf16_compute = config.bf16_compute;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildMixedPrecisionGraph()).IsOk());
+    
+        // MatMul(+Add)的独占权重转为半精度，与Add共用的权重、bias保持FP32
+        int half_weights = 0, float_weights = 0;
+        for (const auto& node : session->GetGraph()->GetNodes()) {
+            const std::string& type = node->GetOpType();
+            if (type != "MatMul" && type != "FusedMatMulAdd") {
+                continue;
+            }
+            const DataType w = node->GetInputs()[1]->GetDataType();
+            if (w == config.dtype) {
+                ++half_weights;
+                EXPECT_EQ(node->GetAttribute("compute_precision"),
+                          config.bf16_compute ? "bf16" : "");
+            } else {
+                EXPECT_EQ(w, DataType::FLOAT32);
+                ++float_weights;
+            }
+            if (type == "FusedMatMulAdd") {
+                EXPECT_EQ(node->GetInputs()[2]->GetDataType(), DataType::FLOAT32);
+            }
+        }
+        EXPECT_EQ(half_weights, 2);
+        EXPECT_EQ(float_weights, 1);
+    
+        std::vector<std::shared_ptr<Tensor>> actual;
+        ASSERT_TRUE(session->Run({x.get()}, actual).IsOk());
+        ASSERT_EQ(actual.size(), 1u);
+        ASSERT_EQ(actual[0]->GetDataType(), DataType::FLOAT32);
+        const float* e = static_cast<const float*>(expected[0]->GetData());
+        const float* a = static_cast<const float*>(actual[0]->GetData());
+        for (size_t i = 0; i < actual[0]->GetElementCount(); ++i) {
+            ASSERT_NEAR(a[i], e[i], config.tolerance * (1.0f + std::fabs(e[i]))) << "at " << i;
+        }
+    }
+}
+
+TEST_F(RuntimeTest, WeightOnlyQuantization) {
+    SessionOptions float_options;
+    float_options.execution_providers = {"CPUExecutionProvider"};
+    auto float_session = InferenceSession::Create(float_options);
+    ASSERT_NE(float_session, nullptr);
+    ASSERT_TRUE(float_session->LoadModelFromGraph(BuildMixedPrecisionGraph()).IsOk());
+    auto x = PseudoRandomTensor(Shape({32, 64}), 1.0f, 36);
+    std::vector<std::shared_ptr<Tensor>> expected;
+    ASSERT_TRUE(float_session->Run({x.get()}, expected).IsOk());
+    ASSERT_EQ(expected.size(), 1u);
+    
+    // 均匀分布的权重在4位RTN下单层相对误差约7%，三层串联后按整体相对误差比较
+    for (int bits : {4, 8}) {
+        SessionOptions options = float_options;
+        options.weight_only_quantization_bits = bits;
+        options.weight_only_quantization_block_size = 32;
+        auto session = InferenceSession::Create(options);
+        ASSERT_NE(session, nullptr);
+        ASSERT_TRUE(session->LoadModelFromGraph(BuildMixedPrecisionGraph()).IsOk());
+    
+        int quantized = 0;
+        for (const auto& node : session->GetGraph()->GetNodes()) {
+            EXPECT_NE(node->GetOpType(), "MatMul");
+            if (node->GetOpType() == "MatMulNBits") {
+                ++quantized;
+                EXPECT_EQ(node->GetInputs()[1]->GetDataType(), DataType::UINT8);
+                EXPECT_EQ(node->GetInputs()[2]->GetDataType(), DataType::FLOAT16);
+            }
+        }
+        EXPECT_EQ(quantized, 3);
+    
+        std::vector<std::shared_ptr<Tensor>> actual;
+        ASSERT_TRUE(session->Run({x.get()}, actual).IsOk());
+        ASSERT_EQ(actual.size(), 1u);
+        ASSERT_EQ(actual[0]->GetElementCount(), expected[0]->GetElementCount());
+        const float* e = static_cast<const float*>(expected[0]->GetData());
+        const float* a = static_cast<const float*>(actual[0]->GetData());
+        double error = 0.0, norm = 0.0;
+        for (size_t i = 0; i < actual[0]->GetElementCount(); ++i) {
+            error += (a[i] - e[i]) * (a[i] - e[i]);
+            norm += e[i] * e[i];
+        }
+        EXPECT_LT(std::sqrt(error / norm), bits == 4 ? 0.2 : 0.02) << "bits=" << bits;
+    
+        // 解码阶段的单行输入走GEMV
+        auto row = PseudoRandomTensor(Shape({1, 64}), 1.0f, 37);
+        std::vector<std::shared_ptr<Tensor>> single;
+        EXPECT_TRUE(session->Run({row.get()}, single).IsOk());
+    }
+}
+
+namespace {
+
+// x[5,64] -> MatMul(w1) -> Add(b1) -> Relu -> MatMul(w2) -> MatMul(w3) -> y：
+// w1[64,44]满足2:4结构，w2[44,38]按4x1块、w3[38,24]按8x1块稀疏（块沿输出维，w2的N不是块大小的整数倍）
+std::unique_ptr<Graph> BuildSparseWeightGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({5, 64}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    auto constant = [&](const std::shared_ptr<Tensor>& tensor) {
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        output->SetName(node->GetName() + "_out");
+        node->AddOutput(output);
+        return node;
+    };
+    auto w1 = PseudoRandomTensor(Shape({64, 44}), 0.5f, 51);
+    float* w1_data = static_cast<float*>(w1->GetData());
+    for (int64_t k = 0; k < 64; ++k) {
+        for (int64_t n = 0; n < 44; ++n) {
+            const int64_t drop = (k / 4 + n) % 4;
+            if (k % 4 == drop || k % 4 == (drop + 1) % 4) {
+                w1_data[k * 44 + n] = 0.0f;
+            }
+        }
+    }
+    // 每个块按伪随机序列保留约1/6
+    auto block_sparse = [](const std::shared_ptr<Tensor>& w, int64_t block, uint32_t seed) {
+        const int64_t K = w->GetShape().dims[0];
+        const int64_t N = w->GetShape().dims[1];
+        float* data = static_cast<float*>(w->GetData());
+        uint32_t state = seed;
+        for (int64_t k = 0; k < K; ++k) {
+            for (int64_t n0 = 0; n0 < N; n0 += block) {
+                state = state * 1664525u + 1013904223u;
+                if ((state >> 16) % 6 != 0) {
+                    for (int64_t n = n0; n < std::min(N, n0 + block); ++n) {
+                        data[k * N + n] = 0.0f;
+                    }
+                }
+            }
+        }
+        return w;
+    };
+    Node* mm1 = apply("MatMul", {x, constant(w1)});
+    Node* add = apply("Add", {mm1->GetOutputs()[0], constant(PseudoRandomTensor(Shape({44}), 0.1f, 52))});
+    Node* relu = apply("Relu", {add->GetOutputs()[0]});
+    Node* mm2 = apply("MatMul", {relu->GetOutputs()[0],
+                                 constant(block_sparse(PseudoRandomTensor(Shape({44, 38}), 0.5f, 53), 4, 54))});
+    Node* mm3 = apply("MatMul", {mm2->GetOutputs()[0],
+                                 constant(block_sparse(PseudoRandomTensor(Shape({38, 24}), 0.5f, 55), 8, 56))});
+    mm3->GetOutputs()[0]->SetName("y");
+    graph->AddOutput(mm3->GetOutputs()[0]);
+    return graph;
+}
+
+} // anonymous namespace
+
+TEST_F(RuntimeTest, SparseWeights) {
+    SessionOptions dense_options;
+    dense_options.execution_providers = {"CPUExecutionProvider"};
+    auto dense_session = InferenceSession::Create(dense_options);
+    ASSERT_NE(dense_session, nullptr);
+    ASSERT_TRUE(dense_session->LoadModelFromGraph(BuildSparseWeightGraph()).IsOk());
+    
+    SessionOptions options = dense_options;
+    options.sparse_weight_density_threshold = 0.6f;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildSparseWeightGraph()).IsOk());
+    
+    // 2:4的权重按2:4存放，其余两层各自选中与稀疏结构一致的块大小
+    std::multiset<std::string> formats;
+    for (const auto& node : session->GetGraph()->GetNodes()) {
+        EXPECT_NE(node->GetOpType(), "MatMul");
+        if (node->GetOpType() == "SparseMatMul") {
+            formats.insert(node->GetAttribute("sparse_format") + "/" + node->GetAttribute("block_size", "-"));
+        }
+    }
+    EXPECT_EQ(formats, (std::multiset<std::string>{"2:4/-", "block/4", "block/8"}));
+    
+    // 多行走块行内复用权重的路径，单行为解码阶段的GEMV；块宽4/8与各ISA的向量宽度组合不同
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (int64_t rows : {5, 1}) {
+            auto x = PseudoRandomTensor(Shape({rows, 64}), 1.0f, 57);
+            std::vector<std::shared_ptr<Tensor>> expected, actual;
+            ASSERT_TRUE(dense_session->Run({x.get()}, expected).IsOk());
+            ASSERT_TRUE(session->Run({x.get()}, actual).IsOk());
+            ASSERT_EQ(actual.size(), 1u);
+            ASSERT_EQ(actual[0]->GetShape().dims, expected[0]->GetShape().dims);
+            const float* e = static_cast<const float*>(expected[0]->GetData());
+            const float* a = static_cast<const float*>(actual[0]->GetData());
+            for (size_t i = 0; i < actual[0]->GetElementCount(); ++i) {
+                ASSERT_NEAR(a[i], e[i], 1e-4f * (1.0f + std::fabs(e[i])))
+                    << isa << " rows=" << rows << " at " << i;
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+}
+
+namespace {
+
+// 一层Transformer：多头注意力（4头，投影带bias）接两层MLP
+// x[1,6,16] -> Q/K/V投影 -> [1,4,6,4]的多头 -> softmax(QK^T/2)V -> 合并头 -> 输出投影 -> MatMul-Relu-MatMul -> y
+std::unique_ptr<Graph> BuildTransformerBlockGraph() {
+    auto graph = std::make_unique<Graph>();
+    Value* x = graph->AddValue();
+    x->SetName("x");
+    x->SetTensor(std::make_shared<Tensor>(Shape({1, 6, 16}), DataType::FLOAT32, nullptr));
+    graph->AddInput(x);
+    uint32_t seed = 40;
+    auto constant = [&](const std::shared_ptr<Tensor>& tensor) {
+        Value* value = graph->AddValue();
+        value->SetTensor(tensor);
+        return value;
+    };
+    auto shape = [&](const std::vector<int64_t>& dims) {
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(dims.size())}), DataType::INT64);
+        std::copy(dims.begin(), dims.end(), static_cast<int64_t*>(tensor->GetData()));
+        return constant(tensor);
+    };
+    auto apply = [&](const std::string& op_type, const std::vector<Value*>& inputs) {
+        Node* node = graph->AddNode(op_type, op_type + std::to_string(graph->GetNodes().size()));
+        for (Value* input : inputs) {
+            node->AddInput(input);
+        }
+        Value* output = graph->AddValue();
+        output->SetName(node->GetName() + "_out");
+        node->AddOutput(output);
+        return node->GetOutputs()[0];
+    };
+    auto transpose = [&](Value* input, const std::vector<int64_t>& perm) {
+        Value* output = apply("Transpose", {input});
+        output->GetProducer()->SetAttribute("perm", AttributeValue(perm));
+        return output;
+    };
+    auto linear = [&](Value* input, int64_t k, int64_t n) {
+        Value* product = apply("MatMul", {input, constant(PseudoRandomTensor(Shape({k, n}), 0.5f, seed++))});
+        return apply("Add", {product, constant(PseudoRandomTensor(Shape({n}), 0.1f, seed++))});
+    };
+    auto heads = [&](Value* input) { return apply("Reshape", {input, shape({1, 6, 4, 4})}); };
+    Value* q = transpose(heads(linear(x, 16, 16)), {0, 2, 1, 3});
+    Value* k = transpose(heads(linear(x, 16, 16)), {0, 2, 3, 1});
+    Value* v = transpose(heads(linear(x, 16, 16)), {0, 2, 1, 3});
+    auto scale = CreateTensor(Shape({1}), DataType::FLOAT32);
+    static_cast<float*>(scale->GetData())[0] = 0.5f;
+    Value* scores = apply("Mul", {apply("MatMul", {q, k}), constant(scale)});
+    Value* probs = apply("Softmax", {scores});
+    probs->GetProducer()->SetAttribute("axis", AttributeValue(static_cast<int64_t>(-1)));
+    Value* context = transpose(apply("MatMul", {probs, v}), {0, 2, 1, 3});
+    Value* attention = linear(apply("Reshape", {context, shape({1, 6, 16})}), 16, 16);
+    Value* hidden = apply("Relu", {linear(attention, 16, 32)});
+    Value* y = linear(hidden, 32, 16);
+    y->SetName("y");
+    graph->AddOutput(y);
+    return graph;
+}
+
+} // anonymous namespace
+
+// 张量并行：Q/K/V与MLP第一层列并行、输出投影与MLP第二层行并行，每层只需一次AllReduce；
+// 两个rank同步执行的结果与单设备一致
+TEST_F(RuntimeTest, TensorParallelSharding) {
+    auto sharded = BuildTransformerBlockGraph();
+    ASSERT_TRUE(InferShapes(sharded.get()).IsOk());
+    ASSERT_TRUE(TensorParallelShardingPass(2, 1, 0).Run(sharded.get()).IsOk());
+    int all_reduce = 0, all_gather = 0;
+    size_t weight_elements = 0;
+    for (const auto& node : sharded->GetNodes()) {
+        all_reduce += node->GetOpType() == "AllReduce";
+        all_gather += node->GetOpType() == "AllGather";
+        if (node->GetOpType() == "MatMul" && !node->GetInputs()[1]->GetProducer()) {
+            weight_elements += node->GetInputs()[1]->GetTensor()->GetElementCount();
+        }
+    }
+    // 每个rank只保留一半的投影与MLP权重
+    EXPECT_EQ(weight_elements, (4 * 16 * 16 + 2 * 16 * 32) / 2);
+    EXPECT_EQ(all_reduce, 2);
+    EXPECT_EQ(all_gather, 0);
+    
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    auto single = InferenceSession::Create(options);
+    ASSERT_NE(single, nullptr);
+    ASSERT_TRUE(single->LoadModelFromGraph(BuildTransformerBlockGraph()).IsOk());
+    options.tensor_parallel_size = 2;
+    auto parallel = InferenceSession::Create(options);
+    ASSERT_NE(parallel, nullptr);
+    ASSERT_TRUE(parallel->LoadModelFromGraph(BuildTransformerBlockGraph()).IsOk());
+    EXPECT_EQ(parallel->GetOutputNames(), std::vector<std::string>{"y"});
+    
+    for (uint32_t step = 0; step < 3; ++step) {
+        auto x = PseudoRandomTensor(Shape({1, 6, 16}), 1.0f, 60 + step);
+        std::vector<std::shared_ptr<Tensor>> expected, actual;
+        ASSERT_TRUE(single->Run({x.get()}, expected).IsOk());
+        ASSERT_TRUE(parallel->Run({x.get()}, actual).IsOk());
+        ASSERT_EQ(actual.size(), 1u);
+        ASSERT_EQ(actual[0]->GetElementCount(), expected[0]->GetElementCount());
+        const float* e = static_cast<const float*>(expected[0]->GetData());
+        const float* a = static_cast<const float*>(actual[0]->GetData());
+        for (size_t i = 0; i < actual[0]->GetElementCount(); ++i) {
+            ASSERT_NEAR(a[i], e[i], 1e-4f) << "step " << step << " at " << i;
+        }
+    }
+}
+
+// 流水线并行：三个阶段各由一个会话执行，边界张量经主机通信组的Send/Recv传递；
+// Run与多个micro-batch的RunPipelined都与单设备一致，协调会话不再持有权重
+TEST_F(RuntimeTest, PipelineParallelStages) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    auto single = InferenceSession::Create(options);
+    ASSERT_NE(single, nullptr);
+    ASSERT_TRUE(single->LoadModelFromGraph(BuildTransformerBlockGraph()).IsOk());
+    options.pipeline_parallel_size = 3;
+    auto parallel = InferenceSession::Create(options);
+    ASSERT_NE(parallel, nullptr);
+    ASSERT_TRUE(parallel->LoadModelFromGraph(BuildTransformerBlockGraph()).IsOk());
+    EXPECT_EQ(parallel->GetOutputNames(), std::vector<std::string>{"y"});
+    PipelineParallelExecutor* executor = parallel->GetPipelineParallelExecutor();
+    ASSERT_NE(executor, nullptr);
+    ASSERT_EQ(executor->GetNumStages(), 3u);
+    EXPECT_FALSE(executor->GetStage(1).received.empty());
+    EXPECT_EQ(executor->GetStage(1).received, executor->GetStage(0).sent);
+    EXPECT_EQ(executor->GetStage(2).outputs, std::vector<std::string>{"y"});
+    for (size_t s = 0; s < 3; ++s) {
+        EXPECT_GT(executor->GetStage(s).cost, 0.0);
+    }
+
+    std::vector<std::shared_ptr<Tensor>> xs;
+    std::vector<std::vector<std::shared_ptr<Tensor>>> expected(5);
+    for (uint32_t i = 0; i < expected.size(); ++i) {
+        xs.push_back(PseudoRandomTensor(Shape({1, 6, 16}), 1.0f, 80 + i));
+        ASSERT_TRUE(single->Run({xs[i].get()}, expected[i]).IsOk());
+    }
+    auto check = [&](const std::vector<std::shared_ptr<Tensor>>& actual, size_t i) {
+        ASSERT_EQ(actual.size(), 1u);
+        ASSERT_EQ(actual[0]->GetElementCount(), expected[i][0]->GetElementCount());
+        const float* e = static_cast<const float*>(expected[i][0]->GetData());
+        const float* a = static_cast<const float*>(actual[0]->GetData());
+        for (size_t j = 0; j < actual[0]->GetElementCount(); ++j) {
+            ASSERT_NEAR(a[j], e[j], 1e-4f) << "micro-batch " << i << " at " << j;
+        }
+    };
+    std::vector<std::shared_ptr<Tensor>> actual;
+    ASSERT_TRUE(parallel->Run({xs[0].get()}, actual).IsOk());
+    check(actual, 0);
+
+    std::vector<std::vector<std::shared_ptr<Tensor>>> micro_batches, outputs;
+    for (const auto& x : xs) {
+        micro_batches.push_back({x});
+    }
+    ASSERT_TRUE(parallel->RunPipelined(micro_batches, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), xs.size());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        check(outputs[i], i);
+    }
+
+    // 一个micro-batch的输入形状不对只让它自己失败，通信组随后仍可用
+    micro_batches[2] = {PseudoRandomTensor(Shape({1, 6, 8}), 1.0f, 99)};
+    EXPECT_FALSE(parallel->RunPipelined(micro_batches, outputs).IsOk());
+    EXPECT_TRUE(outputs[2].empty());
+    check(outputs[4], 4);
+    ASSERT_TRUE(parallel->Run({xs[1].get()}, actual).IsOk());
+    check(actual, 1);
+
+    std::unique_ptr<IOBinding> binding = parallel->CreateIOBinding();
+    if (binding) {
+        EXPECT_FALSE(parallel->Run(*binding).IsOk());
+    }
+    options.tensor_parallel_size = 2;
+    auto both = InferenceSession::Create(options);
+    ASSERT_NE(both, nullptr);
+    EXPECT_FALSE(both->LoadModelFromGraph(BuildTransformerBlockGraph()).IsOk());
+}
+
+// 主机通信组：点对点消息按发送顺序到达，tag或大小不符时报错
+TEST(CollectivesTest, HostSendRecv) {
+    auto group = CollectiveGroup::Create(DeviceType::CPU, {0, 1});
+    ASSERT_NE(group, nullptr);
+    auto first = CreateTensor(Shape({4}), DataType::FLOAT32);
+    auto second = CreateTensor(Shape({4}), DataType::FLOAT32);
+    for (int i = 0; i < 4; ++i) {
+        static_cast<float*>(first->GetData())[i] = static_cast<float>(i);
+        static_cast<float*>(second->GetData())[i] = static_cast<float>(10 + i);
+    }
+    auto received = CreateTensor(Shape({4}), DataType::FLOAT32);
+    Status status;
+    std::thread receiver([&]() { status = group->Recv(1, 0, 0, received.get()); });
+    ASSERT_TRUE(group->Send(0, 1, 0, *first).IsOk());
+    receiver.join();
+    ASSERT_TRUE(status.IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(received->GetData())[3], 3.0f);
+
+    ASSERT_TRUE(group->Send(0, 1, 1, *second).IsOk());
+    ASSERT_TRUE(group->Send(0, 1, 2, *first).IsOk());
+    ASSERT_TRUE(group->Recv(1, 0, 1, received.get()).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(received->GetData())[0], 10.0f);
+    EXPECT_FALSE(group->Recv(1, 0, 5, received.get()).IsOk());
+    EXPECT_FALSE(group->Send(0, 0, 3, *first).IsOk());
+
+    std::thread aborter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        group->Abort();
+    });
+    EXPECT_FALSE(group->Recv(0, 1, 4, received.get()).IsOk());
+    aborter.join();
+    group->Reset();
+}
+
+// 主机通信组：AllGather沿非最外层的轴交错拼接；一个rank中止后另一个rank不再阻塞，Reset后恢复
+TEST(CollectivesTest, HostAllGatherAndAbort) {
+    auto group = CollectiveGroup::Create(DeviceType::CPU, {0, 1});
+    ASSERT_NE(group, nullptr);
+    EXPECT_EQ(CollectiveGroup::Find(group->GetId()), group);
+    std::vector<std::shared_ptr<Tensor>> inputs, outputs;
+    for (int r = 0; r < 2; ++r) {
+        inputs.push_back(CreateTensor(Shape({2, 2}), DataType::FLOAT32));
+        outputs.push_back(CreateTensor(Shape({2, 4}), DataType::FLOAT32));
+        float* data = static_cast<float*>(inputs[r]->GetData());
+        for (int i = 0; i < 4; ++i) {
+            data[i] = static_cast<float>(r * 10 + i);
+        }
+    }
+    std::vector<Status> statuses(2);
+    std::thread peer([&]() { statuses[1] = group->AllGather(1, 0, *inputs[1], 1, outputs[1].get()); });
+    statuses[0] = group->AllGather(0, 0, *inputs[0], 1, outputs[0].get());
+    peer.join();
+    ASSERT_TRUE(statuses[0].IsOk());
+    ASSERT_TRUE(statuses[1].IsOk());
+    const std::vector<float> expected = {0, 1, 10, 11, 2, 3, 12, 13};
+    for (int r = 0; r < 2; ++r) {
+        const float* data = static_cast<const float*>(outputs[r]->GetData());
+        EXPECT_EQ(std::vector<float>(data, data + 8), expected);
+    }
+    
+    std::thread aborter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        group->Abort();
+    });
+    EXPECT_FALSE(group->AllReduceSum(0, 1, *inputs[0], outputs[0].get()).IsOk());
+    aborter.join();
+    group->Reset();
+    
+    auto reduced = CreateTensor(Shape({2, 2}), DataType::FLOAT32);
+    std::thread reducer([&]() { statuses[1] = group->AllReduceSum(1, 2, *inputs[1], inputs[1].get()); });
+    statuses[0] = group->AllReduceSum(0, 2, *inputs[0], reduced.get());
+    reducer.join();
+    ASSERT_TRUE(statuses[0].IsOk());
+    ASSERT_TRUE(statuses[1].IsOk());
+    const float* data = static_cast<const float*>(reduced->GetData());
+    EXPECT_FLOAT_EQ(data[3], 3.0f + 13.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(inputs[1]->GetData())[0], 10.0f);
+}
+
+// 追踪器：各线程的环形缓冲只保留最新的事件，Collect按开始时刻合并，导出为Chrome trace
+TEST(TracingTest, RingBufferKeepsNewestEvents) {
+    Tracer& tracer = Tracer::Instance();
+    tracer.Start(4);
+    for (int i = 0; i < 10; ++i) {
+        const std::string name = "event" + std::to_string(i);
+        tracer.RecordComplete(TraceCategory::NODE, name.c_str(), "Relu", -1, i * 100, i * 100 + 50);
+    }
+    std::thread worker([] {
+        Tracer::SetCurrentThreadName("tracing worker");
+        TraceScope scope(TraceCategory::THREAD_POOL, "worker \"task\"");
+    });
+    worker.join();
+    tracer.RecordComplete(TraceCategory::NODE, "streamed", "Conv", 1, 2000, 2100);
+    tracer.Stop();
+    tracer.RecordComplete(TraceCategory::NODE, "ignored", nullptr, -1, 0, 1);
+    
+    std::vector<TraceEvent> events = tracer.Collect();
+    ASSERT_EQ(events.size(), 5u);
+    EXPECT_EQ(tracer.GetDroppedEventCount(), 7u);
+    std::vector<std::string> names;
+    for (const auto& event : events) {
+        names.push_back(event.name);
+        EXPECT_LE(events.front().start_ns, event.start_ns);
+    }
+    EXPECT_NE(std::find(names.begin(), names.end(), "event9"), names.end());
+    EXPECT_NE(std::find(names.begin(), names.end(), "worker \"task\""), names.end());
+    EXPECT_EQ(std::find(names.begin(), names.end(), "event6"), names.end());
+    EXPECT_EQ(std::find(names.begin(), names.end(), "ignored"), names.end());
+    
+    const std::string json = tracer.ExportChromeTrace();
+    EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"tracing worker\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"worker \\\"task\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"stream 1\""), std::string::npos);
+    EXPECT_NE(json.find("\"op_type\":\"Conv\",\"stream\":1"), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\":7"), std::string::npos);
+}
+
+// 异步日志：多线程的消息经后台线程写入文件，缓冲满时INFO被丢弃计数，级别不够时不求值
+TEST(LoggerTest, AsyncBackend) {
+    Logger& logger = Logger::Instance();
+    const LogLevel saved_level = logger.GetLevel();
+    const std::string path = (std::filesystem::path(::testing::TempDir()) /
+        ("inferunity_log_" + std::to_string(reinterpret_cast<uintptr_t>(&logger)) + ".txt")).string();
+    std::remove(path.c_str());
+    logger.SetLevel(LogLevel::INFO);
+    logger.SetConsoleOutput(false);
+    logger.SetFileOutput(path);
+    auto count_lines = [&](const std::string& tag) {
+        logger.Flush();
+        std::ifstream file(path);
+        size_t count = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            count += line.find(tag) != std::string::npos ? 1 : 0;
+        }
+        return count;
+    };
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 100; ++i) {
+                LOG_INFO("async " + std::to_string(t) + ":" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(count_lines("] async "), 400u);
+    
+    // 级别不够时消息表达式不求值
+    int evaluated = 0;
+    auto message = [&] { ++evaluated; return std::string("filtered"); };
+    logger.SetLevel(LogLevel::WARNING);
+    LOG_INFO(message());
+    EXPECT_EQ(evaluated, 0);
+    LOG_WARNING(message());
+    EXPECT_EQ(evaluated, 1);
+    logger.SetLevel(LogLevel::INFO);
+    
+    // 容量为1的缓冲：多数INFO被丢弃计数，WARNING不丢
+    logger.SetBufferCapacity(1);
+    const uint64_t dropped_before = logger.GetDroppedCount();
+    std::thread producer([] {
+        for (int i = 0; i < 1000; ++i) {
+            LOG_INFO("burst-info " + std::to_string(i));
+        }
+        for (int i = 0; i < 10; ++i) {
+            LOG_WARNING("burst-warning " + std::to_string(i));
+        }
+    });
+    producer.join();
+    logger.SetBufferCapacity(1024);
+    const uint64_t dropped = logger.GetDroppedCount() - dropped_before;
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(count_lines("] burst-info ") + dropped, 1000u);
+    EXPECT_EQ(count_lines("burst-warning"), 10u);
+    EXPECT_GE(count_lines("log messages dropped"), 1u);
+    
+    // 同步模式：返回时已写出
+    logger.SetAsync(false);
+    LOG_INFO("sync message");
+    {
+        std::ifstream file(path);
+        const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        EXPECT_NE(text.find("sync message"), std::string::npos);
+        EXPECT_NE(text.find("[INFO] ["), std::string::npos);
+    }
+    logger.SetAsync(true);
+    
+    logger.SetFileOutput("");
+    logger.SetConsoleOutput(true);
+    logger.SetLevel(saved_level);
+    std::remove(path.c_str());
+}
+
+// 分片计数器与直方图：多线程记录后求和，导出为Prometheus文本格式
+TEST(MetricsTest, ShardedMetricsAndPrometheusExport) {
+    MetricsRegistry& registry = MetricsRegistry::Instance();
+    auto counter = registry.GetCounter("test_metrics_events_total", {{"kind", "a\"b"}}, "Test events");
+    auto histogram = registry.GetHistogram("test_metrics_latency_us", {10, 100, 1000}, {}, "Test latency");
+    ASSERT_NE(counter, nullptr);
+    ASSERT_NE(histogram, nullptr);
+    EXPECT_EQ(registry.GetCounter("test_metrics_events_total", {{"kind", "a\"b"}}), counter);
+    EXPECT_EQ(registry.GetGauge("test_metrics_latency_us"), nullptr);  // 同名不同类型
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                counter->Add();
+                histogram->Record(i % 10 == 0 ? 500.0 : 5.0);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter->Value(), 8000u);
+    const Histogram snapshot = histogram->Snapshot();
+    EXPECT_EQ(snapshot.GetCount(), 8000u);
+    EXPECT_EQ(snapshot.GetCounts()[0], 7200u);
+    EXPECT_EQ(snapshot.GetCounts()[2], 800u);
+    EXPECT_DOUBLE_EQ(snapshot.GetPercentile(0.5), 10.0);
+    EXPECT_DOUBLE_EQ(snapshot.GetPercentile(0.99), 1000.0);
+    EXPECT_DOUBLE_EQ(snapshot.GetMax(), 500.0);
+    
+    const std::string text = registry.ExportPrometheus();
+    EXPECT_NE(text.find("# HELP test_metrics_events_total Test events\n"
+                        "# TYPE test_metrics_events_total counter\n"
+                        "test_metrics_events_total{kind=\"a\\\"b\"} 8000\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_metrics_latency_us histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_metrics_latency_us_bucket{le=\"10\"} 7200\n"), std::string::npos);
+    EXPECT_NE(text.find("test_metrics_latency_us_bucket{le=\"100\"} 7200\n"), std::string::npos);
+    EXPECT_NE(text.find("test_metrics_latency_us_bucket{le=\"+Inf\"} 8000\n"), std::string::npos);
+    EXPECT_NE(text.find("test_metrics_latency_us_count 8000\n"), std::string::npos);
+}
+
+// 会话的常驻指标：运行延迟、算子类型耗时与arena高水位，会话销毁后注销
+TEST_F(RuntimeTest, SessionMetrics) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.session_id = "metrics_test_session";
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    EXPECT_EQ(session->GetSessionId(), "metrics_test_session");
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+    const OpMetrics* conv = GetOpMetrics("NchwcConv");
+    const uint64_t conv_before = conv->executions->Value();
+    auto x = FilledTensor(Shape({1, 3, 12, 12}), 0.25f);
+    for (int i = 0; i < 3; ++i) {
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    }
+    EXPECT_GE(conv->executions->Value(), conv_before + 3);
+    EXPECT_GT(conv->time_ns->Value(), 0u);
+    
+    auto find = [](const std::string& name) {
+        for (const MetricSample& sample : MetricsRegistry::Instance().Collect(name)) {
+            if (sample.name == name && sample.GetLabel("session") == "metrics_test_session") {
+                return sample;
+            }
+        }
+        return MetricSample();
+    };
+    const MetricSample latency = find("inferunity_session_run_latency_us");
+    EXPECT_EQ(latency.type, MetricType::HISTOGRAM);
+    EXPECT_EQ(latency.histogram.GetCount(), 3u);
+    EXPECT_GT(latency.histogram.GetPercentile(0.99), 0.0);
+    const MetricSample arena = find("inferunity_session_arena_high_water_bytes");
+    EXPECT_EQ(arena.type, MetricType::GAUGE);
+    EXPECT_EQ(arena.value, static_cast<double>(session->GetMemoryPlan().arena_size));
+    
+    // 关闭后不再记录
+    MetricsRegistry::Instance().SetEnabled(false);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    MetricsRegistry::Instance().SetEnabled(true);
+    EXPECT_EQ(find("inferunity_session_run_latency_us").histogram.GetCount(), 3u);
+    
+    session.reset();
+    EXPECT_TRUE(find("inferunity_session_run_latency_us").name.empty());
+    EXPECT_NE(MetricsRegistry::Instance().ExportPrometheus().find("inferunity_op_time_ns_total{op_type=\"NchwcConv\"}"),
+              std::string::npos);
+}
+
+// 逐节点硬件计数器：可用时各节点带有周期与指令数，不可用时给出原因；FLOP/字节的解析估计总是填写
+TEST_F(RuntimeTest, ProfileHardwareCounters) {
+    HardwareCounterValues a;
+    a.cycles = 10;
+    a.instructions = 30;
+    a.llc_misses = 2;
+    HardwareCounterValues b = a;
+    b += a;
+    EXPECT_EQ((b - a).instructions, 30u);
+    EXPECT_EQ((a - b).cycles, 0u);
+    EXPECT_DOUBLE_EQ(a.GetIpc(), 3.0);
+    EXPECT_EQ(a.GetLlcMissBytes(), 128u);
+    
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.profile_hardware_counters = true;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+    ProfilingResult profile;
+    ASSERT_TRUE(session->Profile(profile).IsOk());
+    ASSERT_FALSE(profile.node_profiles.empty());
+    
+    double conv_flops = 0.0;
+    HardwareCounterValues total;
+    for (const auto& node : profile.node_profiles) {
+        EXPECT_GT(node.estimated_bytes, 0u) << node.node_name;
+        if (node.op_type.find("Conv") != std::string::npos) {
+            conv_flops = std::max(conv_flops, node.estimated_flops);
+        }
+        total += node.counters;
+    }
+    // 第二个卷积：16x6x6个输出，每个16*3*3次乘加
+    EXPECT_GE(conv_flops, 2.0 * 16 * 6 * 6 * 16 * 9);
+    if (profile.hardware_counters) {
+        EXPECT_GT(total.cycles, 0u);
+        EXPECT_GT(total.instructions, 0u);
+        EXPECT_TRUE(profile.hardware_counter_error.empty());
+    } else {
+        EXPECT_FALSE(profile.hardware_counter_error.empty());
+        EXPECT_EQ(total.cycles, 0u);
+    }
+}
+
+// 算子的解析代价：MatMul/Conv按乘加、归一化与逐元素按每个元素的运算数、注意力按分数矩阵，
+// 代价模型与节点代价估计使用同一份数字
+TEST_F(RuntimeTest, OperatorCostEstimates) {
+    auto info = [](std::vector<int64_t> dims) { return TensorInfo{Shape(dims), DataType::FLOAT32, nullptr}; };
+    auto create = [](const std::string& op_type) {
+        auto op = OperatorRegistry::Instance().Create(op_type);
+        EXPECT_NE(op, nullptr) << op_type;
+        return op;
+    };
+    
+    auto matmul = create("MatMul");
+    OperatorCost cost = matmul->EstimateCost({info({4, 8}), info({8, 16})}, {info({4, 16})});
+    EXPECT_DOUBLE_EQ(cost.flops, 2.0 * 4 * 16 * 8);
+    EXPECT_EQ(cost.bytes_read, (32u + 128u) * 4);
+    EXPECT_EQ(cost.bytes_written, 64u * 4);
+    EXPECT_DOUBLE_EQ(cost.GetArithmeticIntensity(), cost.flops / 896.0);
+    
+    // 每个输出27次乘加，另加bias
+    auto conv = create("Conv");
+    cost = conv->EstimateCost({info({1, 3, 8, 8}), info({16, 3, 3, 3}), info({16})}, {info({1, 16, 6, 6})});
+    EXPECT_DOUBLE_EQ(cost.flops, 576.0 * (2 * 27 + 1));
+    
+    auto layer_norm = create("LayerNormalization");
+    auto rms_norm = create("RMSNorm");
+    const OperatorCost ln = layer_norm->EstimateCost({info({2, 64}), info({64}), info({64})}, {info({2, 64})});
+    const OperatorCost rms = rms_norm->EstimateCost({info({2, 64}), info({64})}, {info({2, 64})});
+    EXPECT_GT(ln.flops, rms.flops);
+    EXPECT_GT(rms.flops, 128.0);
+    
+    // 逐元素：Relu每个元素1次，超越函数更多；只搬运数据的算子没有运算
+    auto relu = create("Relu");
+    auto gelu = create("Gelu");
+    EXPECT_DOUBLE_EQ(relu->EstimateCost({info({10})}, {info({10})}).flops, 10.0);
+    EXPECT_GT(gelu->EstimateCost({info({10})}, {info({10})}).flops, 10.0);
+    auto transpose = create("Transpose");
+    cost = transpose->EstimateCost({info({4, 8})}, {info({8, 4})});
+    EXPECT_DOUBLE_EQ(cost.flops, 0.0);
+    EXPECT_EQ(cost.GetBytes(), 256u);
+    // 归约按输入元素数
+    auto reduce = create("ReduceSum");
+    EXPECT_DOUBLE_EQ(reduce->EstimateCost({info({4, 8})}, {info({4, 1})}).flops, 32.0);
+    
+    // 注意力：[B, H, S, T]个分数，每个做D次QK乘加与Dv次PV乘加；因果mask约一半
+    auto attention = create("FusedAttention");
+    const std::vector<TensorInfo> qkv = {info({1, 2, 4, 8}), info({1, 2, 4, 8}), info({1, 2, 4, 8})};
+    const OperatorCost full = attention->EstimateCost(qkv, {info({1, 2, 4, 8})});
+    EXPECT_DOUBLE_EQ(full.flops, 32.0 * (16 + 16 + GetElementwiseFlops("Softmax")));
+    attention->SetAttribute("causal", AttributeValue(static_cast<int64_t>(1)));
+    EXPECT_DOUBLE_EQ(attention->EstimateCost(qkv, {info({1, 2, 4, 8})}).flops, full.flops * 2.5 / 4.0);
+    
+    // 代价模型按节点属性与推断的形状调用同一实现
+    auto graph = BuildPartitionGraph(64, 256);
+    ASSERT_TRUE(InferShapes(graph.get()).IsOk());
+    const Node* matmul0 = graph->GetNodeByName("matmul0");
+    const Node* relu_node = graph->GetNodeByName("relu");
+    EXPECT_DOUBLE_EQ(CostModel::EstimateFlops(matmul0), 2.0 * 64 * 256 * 256);
+    EXPECT_EQ(CostModel::EstimateBytes(matmul0), (64u * 256 * 2 + 256u * 256) * 4);
+    EXPECT_DOUBLE_EQ(CostModel::EstimateFlops(relu_node), 64.0 * 256);
+    EXPECT_GT(EstimateNodeCost(matmul0), EstimateNodeCost(relu_node));
+    
+    RooflinePeaks peaks;
+    peaks.peak_gflops = 100.0;
+    peaks.peak_gbps = 10.0;
+    EXPECT_DOUBLE_EQ(peaks.GetRidgePoint(), 10.0);
+    // 1 GFLOP在100 GFLOP/s下10ms；10MB在10GB/s下1ms
+    EXPECT_DOUBLE_EQ(peaks.GetRooflineTimeMs(1e9, 1e7), 10.0);
+    EXPECT_DOUBLE_EQ(peaks.GetRooflineTimeMs(1e6, 1e8), 10.0);
+}
+
+// 机器画像：保存后读回一致；屋顶线取最高的全核峰值，之后创建的CostModel按实测值设置CPU的代价参数
+TEST_F(RuntimeTest, MachineProfileRoundTrip) {
+    MachineProfile profile;
+    profile.cpu_model = "Test CPU @ 3.00GHz";
+    profile.threads = 8;
+    profile.core_peak_gflops["sse"] = 24.0;
+    profile.core_peak_gflops["avx2"] = 96.0;
+    profile.all_core_peak_gflops["sse"] = 180.0;
+    profile.all_core_peak_gflops["avx2"] = 720.0;
+    profile.l1_gbps = 2000.0;
+    profile.l2_gbps = 800.0;
+    profile.l3_gbps = 300.0;
+    profile.dram_gbps = 40.0;
+    profile.dispatch_latency_us = 6.5;
+    const std::string path = ::testing::TempDir() + "inferunity_machine_profile.txt";
+    ASSERT_TRUE(profile.Save(path).IsOk());
+    
+    MachineProfile loaded;
+    ASSERT_TRUE(loaded.Load(path).IsOk());
+    EXPECT_EQ(loaded.cpu_model, profile.cpu_model);
+    EXPECT_EQ(loaded.threads, 8u);
+    EXPECT_EQ(loaded.core_peak_gflops, profile.core_peak_gflops);
+    EXPECT_EQ(loaded.all_core_peak_gflops, profile.all_core_peak_gflops);
+    EXPECT_DOUBLE_EQ(loaded.l2_gbps, 800.0);
+    EXPECT_DOUBLE_EQ(loaded.dram_gbps, 40.0);
+    EXPECT_DOUBLE_EQ(loaded.dispatch_latency_us, 6.5);
+    const RooflinePeaks peaks = loaded.GetRooflinePeaks();
+    EXPECT_DOUBLE_EQ(peaks.peak_gflops, 720.0);
+    EXPECT_DOUBLE_EQ(peaks.peak_gbps, 40.0);
+    
+    ASSERT_TRUE(LoadMachineProfile(path).IsOk());
+    CostModel model;
+    EXPECT_DOUBLE_EQ(model.GetDeviceProfile(DeviceType::CPU).flops_per_us, 720.0 * 1e3);
+    EXPECT_DOUBLE_EQ(model.GetDeviceProfile(DeviceType::CPU).bytes_per_us, 40.0 * 1e3);
+    EXPECT_DOUBLE_EQ(model.GetDeviceProfile(DeviceType::CPU).launch_overhead_us, 6.5);
+    // 空画像不覆盖默认参数
+    SetMachineProfile(MachineProfile());
+    EXPECT_DOUBLE_EQ(CostModel().GetDeviceProfile(DeviceType::CPU).flops_per_us,
+                     DeviceCostProfile().flops_per_us);
+    
+    // 版本头不符的文件被拒绝
+    {
+        std::ofstream out(path);
+        out << "not a profile\n";
+    }
+    EXPECT_FALSE(loaded.Load(path).IsOk());
+    std::remove(path.c_str());
+}
+
+// 内存时间线：中间张量在最后一次使用后释放，峰值时存活的张量按字节数排序，与是否使用arena无关
+TEST_F(RuntimeTest, ProfileMemoryTimeline) {
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::NONE;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+    ProfilingResult profile;
+    ASSERT_TRUE(session->Profile(profile).IsOk());
+    
+    const MemoryTimeline& timeline = profile.memory_timeline;
+    ASSERT_FALSE(timeline.events.empty());
+    EXPECT_EQ(profile.peak_memory_bytes, timeline.peak_bytes);
+    int64_t live = 0;
+    size_t max_live = 0;
+    for (const MemoryEvent& event : timeline.events) {
+        live += event.bytes;
+        EXPECT_EQ(static_cast<size_t>(live), event.live_bytes);
+        max_live = std::max(max_live, event.live_bytes);
+    }
+    EXPECT_EQ(timeline.peak_bytes, max_live);
+    // 运行结束时只剩图输入x与输出y
+    EXPECT_EQ(timeline.events.back().live_bytes, (3 * 12 * 12 + 16 * 6 * 6) * sizeof(float));
+    
+    // 峰值在第一个卷积的输出仍存活时，它是峰值时最大的张量
+    const size_t conv1_bytes = 16 * 12 * 12 * sizeof(float);
+    ASSERT_FALSE(timeline.live_at_peak.empty());
+    EXPECT_EQ(timeline.live_at_peak[0].bytes, conv1_bytes);
+    EXPECT_EQ(timeline.live_at_peak[0].producer, "Conv0");
+    size_t peak_sum = 0;
+    for (const auto& tensor : timeline.live_at_peak) {
+        peak_sum += tensor.bytes;
+    }
+    EXPECT_EQ(peak_sum, timeline.peak_bytes);
+    ASSERT_LT(timeline.peak_step, profile.node_profiles.size());
+    EXPECT_EQ(profile.node_profiles[timeline.peak_step].node_name, timeline.peak_node);
+    EXPECT_EQ(profile.node_profiles[timeline.peak_step].live_bytes, timeline.peak_bytes);
+    
+    const std::string json = timeline.ToJson();
+    EXPECT_NE(json.find("\"live_at_peak\""), std::string::npos);
+    EXPECT_NE(json.find("\"producer\":\"Conv0\""), std::string::npos);
+}
+
+// 会话的分层追踪：加载、优化Pass、内存规划与运行中的节点都写入trace文件
+TEST_F(RuntimeTest, SessionProfilingTrace) {
+    const std::string prefix = (std::filesystem::path(::testing::TempDir()) /
+        ("inferunity_trace_" + std::to_string(reinterpret_cast<uintptr_t>(this)))).string();
+    SessionOptions options;
+    options.execution_providers = {"CPUExecutionProvider"};
+    options.enable_profiling = true;
+    options.profile_file_prefix = prefix;
+    auto session = InferenceSession::Create(options);
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(Tracer::Instance().IsEnabled());
+    ASSERT_TRUE(session->LoadModelFromGraph(BuildCnnBlockGraph()).IsOk());
+    auto x = FilledTensor(Shape({1, 3, 12, 12}), 0.25f);
+    std::vector<std::shared_ptr<Tensor>> outputs;
+    ASSERT_TRUE(session->Run({x.get()}, outputs).IsOk());
+    
+    const std::string path = session->EndProfiling();
+    ASSERT_FALSE(path.empty());
+    EXPECT_FALSE(Tracer::Instance().IsEnabled());
+    EXPECT_EQ(path.rfind(prefix, 0), 0u);
+    std::ifstream file(path);
+    ASSERT_TRUE(file.is_open());
+    const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    for (const char* expected : {"\"name\":\"LoadAndOptimizeGraph\"", "\"name\":\"OperatorFusion\"",
+                                 "\"name\":\"PlanSessionMemory\"", "\"name\":\"arena_bytes\"",
+                                 "\"name\":\"Run\"", "\"op_type\":\"NchwcConv\"", "\"cat\":\"node\""}) {
+        EXPECT_NE(json.find(expected), std::string::npos) << expected;
+    }
+    file.close();
+    std::remove(path.c_str());
+}
+
+TEST_F(RuntimeTest, ThreadPoolSchedulerStats) {
+    ThreadPoolOptions options;
+    options.num_threads = 4;
+    auto pool = ThreadPoolInstance::Create(options);
+    ThreadPoolScope scope(pool, nullptr);
+    ThreadPool::ResetStats();
+    
+    // 第0块远慢于其他块：最慢的执行者决定区域的耗时
+    std::atomic<int64_t> total{0};
+    ThreadPool::ParallelFor(0, 64, 1, [&total](int64_t begin, int64_t end) {
+        if (begin == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        total.fetch_add(end - begin);
+    });
+    EXPECT_EQ(total.load(), 64);
+    // 区域由最后释放共享状态的执行者记录，可能晚于ParallelFor返回
+    ThreadPoolStats stats = ThreadPool::GetStats();
+    for (int i = 0; i < 1000 && stats.parallel_regions == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = ThreadPool::GetStats();
+    }
+    ASSERT_EQ(stats.workers.size(), 4u);
+    EXPECT_EQ(stats.parallel_regions, 1u);
+    EXPECT_GT(stats.max_imbalance, 1.5);
+    EXPECT_DOUBLE_EQ(stats.mean_imbalance, stats.max_imbalance);
+    uint64_t tasks = 0;
+    for (const auto& worker : stats.workers) {
+        EXPECT_EQ(worker.tasks, worker.local_tasks + worker.injected_tasks + worker.stolen_tasks);
+        EXPECT_GE(worker.queue_wait_ns, 0);
+        tasks += worker.tasks;
+    }
+    EXPECT_GT(tasks, 0u);
+    EXPECT_NE(stats.ToString().find("ParallelFor regions: 1"), std::string::npos);
+    
+    ThreadPool::ResetStats();
+    stats = ThreadPool::GetStats();
+    EXPECT_EQ(stats.parallel_regions, 0u);
+    EXPECT_EQ(stats.max_imbalance, 0.0);
+    for (const auto& worker : stats.workers) {
+        EXPECT_EQ(worker.tasks, 0u);
+        EXPECT_EQ(worker.busy_ns, 0);
+    }
+}
@@ -0,0 +1,367 @@
+// 推理服务前端测试
+// KServe v2请求的解码（JSON数据、二进制输入的零拷贝视图）与响应编码，
+// 以及本机回环上的端到端请求（直接执行与经动态批处理器）
+
+#include <gtest/gtest.h>
+#include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/memory.h"
+#include "inferunity/server.h"
+#include "server/kserve.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace inferunity;
+using namespace inferunity::server;
+
+namespace {
+
+Status Decode(const std::string& body, size_t json_size, const std::vector<std::string>& names,
+              DecodedInferRequest* request) {
+    return DecodeInferRequest(reinterpret_cast<const uint8_t*>(body.data()), body.size(), json_size, nullptr, names,
+                              request);
+}
+
+// y = Relu(x)，输入输出带名称
+std::unique_ptr<InferenceSession> CreateReluSession(const SessionOptions& options = SessionOptions()) {
+    auto graph = std::make_unique<Graph>();
+    Value* input = graph->AddValue();
+    Value* output = graph->AddValue();
+    input->SetName("x");
+    output->SetName("y");
+    Node* relu = graph->AddNode("Relu", "relu1");
+    relu->AddInput(input);
+    relu->AddOutput(output);
+    graph->AddInput(input);
+    graph->AddOutput(output);
+    auto session = InferenceSession::Create(options);
+    if (!session || !session->LoadModelFromGraph(std::move(graph)).IsOk()) {
+        return nullptr;
+    }
+    return session;
+}
+
+struct HttpResponse {
+    int status = 0;
+    std::string headers;
+    std::string body;
+};
+
+class HttpClient {
+public:
+    explicit HttpClient(int port) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        connected_ = ::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+    ~HttpClient() { ::close(fd_); }
+
+    bool Connected() const { return connected_; }
+
+    HttpResponse Request(const std::string& method, const std::string& path, const std::string& body = "",
+                         const std::string& extra_headers = "") {
+        std::string request = method + " " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+        request += "Content-Length: " + std::to_string(body.size()) + "\r\n" + extra_headers + "\r\n" + body;
+        size_t sent = 0;
+        while (sent < request.size()) {
+            const ssize_t n = ::send(fd_, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return {};
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return ReadResponse();
+    }
+
+    HttpResponse ReadResponse() {
+        HttpResponse response;
+        size_t header_end;
+        while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!Fill()) {
+                return response;
+            }
+        }
+        response.headers = buffer_.substr(0, header_end + 2);
+        buffer_.erase(0, header_end + 4);
+        response.status = std::stoi(response.headers.substr(9, 3));
+        size_t length = 0;
+        const size_t field = response.headers.find("Content-Length: ");
+        if (field != std::string::npos) {
+            length = std::stoul(response.headers.substr(field + 16));
+        }
+        while (buffer_.size() < length) {
+            if (!Fill()) {
+                return response;
+            }
+        }
+        response.body = buffer_.substr(0, length);
+        buffer_.erase(0, length);
+        return response;
+    }
+
+private:
+    bool Fill() {
+        char chunk[4096];
+        const ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd_ = -1;
+    bool connected_ = false;
+    std::string buffer_;
+};
+
+} // anonymous namespace
+
+TEST(KServeCodecTest, DecodesJsonData) {
+    const std::string body =
+        R"({"id":"req-1","inputs":[{"name":"b","shape":[2],"datatype":"INT64","data":[7,-3]},)"
+        R"({"name":"a","shape":[2,2],"datatype":"FP32","data":[[1.5,-2],[3e2,0.25]],"parameters":{"x":{"y":[1]}}}],)"
+        R"("outputs":[{"name":"out","parameters":{"binary_data":true}}],"parameters":{"timeout":2500}})";
+    DecodedInferRequest request;
+    Status status = Decode(body, body.size(), {"a", "b"}, &request);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    EXPECT_EQ(request.id, "req-1");
+    EXPECT_EQ(request.timeout_us, 2500);
+    ASSERT_EQ(request.outputs.size(), 1u);
+    EXPECT_EQ(request.outputs[0].name, "out");
+    EXPECT_TRUE(request.outputs[0].binary);
+
+    // 输入按模型的输入顺序排列，与请求中的顺序无关
+    ASSERT_EQ(request.inputs.size(), 2u);
+    EXPECT_EQ(request.inputs[0]->GetShape().dims, std::vector<int64_t>({2, 2}));
+    const float* a = static_cast<const float*>(request.inputs[0]->GetData());
+    EXPECT_FLOAT_EQ(a[0], 1.5f);
+    EXPECT_FLOAT_EQ(a[1], -2.0f);
+    EXPECT_FLOAT_EQ(a[2], 300.0f);
+    EXPECT_FLOAT_EQ(a[3], 0.25f);
+    ASSERT_EQ(request.inputs[1]->GetDataType(), DataType::INT64);
+    EXPECT_EQ(static_cast<const int64_t*>(request.inputs[1]->GetData())[1], -3);
+    EXPECT_EQ(request.zero_copy_bytes, 0u);
+
+    // 元素个数与形状不符、缺少输入、未知输入、类型不支持都是INVALID_ARGUMENT
+    const std::vector<std::string> bad_bodies = {
+        R"({"inputs":[{"name":"a","shape":[3],"datatype":"FP32","data":[1,2]}]})",
+        R"({"inputs":[]})",
+        R"({"inputs":[{"name":"c","shape":[1],"datatype":"FP32","data":[1]}]})",
+        R"({"inputs":[{"name":"a","shape":[1],"datatype":"BYTES","data":["x"]}]})",
+        R"({"inputs":[{"name":"a","shape":[1],"datatype":"FP32","data":[1]})",
+    };
+    for (const std::string& bad : bad_bodies) {
+        DecodedInferRequest rejected;
+        EXPECT_EQ(Decode(bad, bad.size(), {"a"}, &rejected).Code(), StatusCode::ERROR_INVALID_ARGUMENT) << bad;
+    }
+}
+
+TEST(KServeCodecTest, BinaryInputIsZeroCopyView) {
+    const std::string json = R"({"inputs":[{"name":"x","shape":[1,4],"datatype":"FP32",)"
+                             R"("parameters":{"binary_data_size":16}}],"parameters":{"binary_data_output":true}})";
+    const float values[4] = {1.0f, -1.0f, 2.0f, -2.0f};
+
+    // 与服务器相同：二进制部分从64字节对齐的地址开始
+    const size_t padding = (64 - json.size() % 64) % 64;
+    uint8_t* base = static_cast<uint8_t*>(AllocateMemory(padding + json.size() + sizeof(values), 64));
+    std::shared_ptr<uint8_t> owner(base, [](uint8_t* p) { FreeMemory(p); });
+    uint8_t* body = base + padding;
+    std::memcpy(body, json.data(), json.size());
+    std::memcpy(body + json.size(), values, sizeof(values));
+
+    DecodedInferRequest request;
+    Status status = DecodeInferRequest(body, json.size() + sizeof(values), json.size(), owner, {"x"}, &request);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    EXPECT_TRUE(request.binary_data_output);
+    ASSERT_EQ(request.inputs.size(), 1u);
+    EXPECT_EQ(request.inputs[0]->GetData(), body + json.size());
+    EXPECT_EQ(request.zero_copy_bytes, sizeof(values));
+    EXPECT_EQ(request.copied_bytes, 0u);
+
+    // 视图持有接收缓冲
+    std::weak_ptr<uint8_t> weak = owner;
+    owner.reset();
+    EXPECT_FALSE(weak.expired());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(request.inputs[0]->GetData())[2], 2.0f);
+    request.inputs.clear();
+    EXPECT_TRUE(weak.expired());
+
+    // 多出的二进制数据或大小与形状不符时拒绝
+    std::string extra = json + std::string(reinterpret_cast<const char*>(values), sizeof(values)) + "xx";
+    EXPECT_EQ(Decode(extra, json.size(), {"x"}, &request).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    std::string truncated = json + std::string(reinterpret_cast<const char*>(values), 8);
+    EXPECT_EQ(Decode(truncated, json.size(), {"x"}, &request).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+}
+
+TEST(KServeCodecTest, MisalignedBinaryInputIsCopied) {
+    const std::string json = R"({"inputs":[{"name":"x","shape":[2],"datatype":"INT32",)"
+                             R"("parameters":{"binary_data_size":8}}]})";
+    const int32_t values[2] = {5, -6};
+    std::vector<uint8_t> storage(json.size() + sizeof(values) + 8);
+    // 让二进制部分落在奇数地址上
+    uint8_t* body = storage.data();
+    if ((reinterpret_cast<uintptr_t>(body) + json.size()) % 2 == 0) {
+        ++body;
+    }
+    std::memcpy(body, json.data(), json.size());
+    std::memcpy(body + json.size(), values, sizeof(values));
+
+    DecodedInferRequest request;
+    ASSERT_TRUE(DecodeInferRequest(body, json.size() + sizeof(values), json.size(), nullptr, {"x"}, &request).IsOk());
+    EXPECT_EQ(request.zero_copy_bytes, 0u);
+    EXPECT_EQ(request.copied_bytes, sizeof(values));
+    EXPECT_NE(request.inputs[0]->GetData(), body + json.size());
+    EXPECT_EQ(static_cast<const int32_t*>(request.inputs[0]->GetData())[1], -6);
+}
+
+TEST(KServeCodecTest, EncodesJsonAndBinaryOutputs) {
+    auto first = CreateTensor(Shape({2}), DataType::FLOAT32);
+    static_cast<float*>(first->GetData())[0] = 0.5f;
+    static_cast<float*>(first->GetData())[1] = -1.0f;
+    auto second = CreateTensor(Shape({1, 3}), DataType::INT32);
+    int32_t* ints = static_cast<int32_t*>(second->GetData());
+    ints[0] = 1;
+    ints[1] = 2;
+    ints[2] = 3;
+
+    DecodedInferRequest request;
+    request.id = "r\"1";
+    request.outputs = {{"second", true}, {"first", false}};
+    EncodedInferResponse response;
+    ASSERT_TRUE(EncodeInferResponse("m", "1", request, {"first", "second"}, {first, second}, &response).IsOk());
+    EXPECT_EQ(response.json,
+              R"({"model_name":"m","model_version":"1","id":"r\"1","outputs":[)"
+              R"({"name":"second","datatype":"INT32","shape":[1,3],"parameters":{"binary_data_size":12}},)"
+              R"({"name":"first","datatype":"FP32","shape":[2],"data":[0.5,-1]}]})");
+    ASSERT_EQ(response.binary.size(), 1u);
+    EXPECT_EQ(response.binary[0], second);
+    EXPECT_EQ(response.binary_size, 12u);
+
+    request.outputs = {{"missing", false}};
+    EXPECT_EQ(EncodeInferResponse("m", "1", request, {"first", "second"}, {first, second}, &response).Code(),
+              StatusCode::ERROR_NOT_FOUND);
+}
+
+TEST(InferenceServerTest, ServesInferenceOverHttp) {
+    auto session = CreateReluSession();
+    ASSERT_NE(session, nullptr);
+    ServerOptions options;
+    options.host = "127.0.0.1";
+    options.port = 0;
+    options.num_io_threads = 2;
+    InferenceServer server(options);
+    ASSERT_TRUE(server.AddModel("relu", session.get()).IsOk());
+    EXPECT_EQ(server.AddModel("relu", session.get()).Code(), StatusCode::ERROR_INVALID_ARGUMENT);
+    ASSERT_TRUE(server.Start().IsOk());
+    ASSERT_GT(server.GetPort(), 0);
+
+    HttpClient client(server.GetPort());
+    ASSERT_TRUE(client.Connected());
+    EXPECT_EQ(client.Request("GET", "/v2/health/live").status, 200);
+    EXPECT_EQ(client.Request("GET", "/v2/health/ready").status, 200);
+    EXPECT_EQ(client.Request("GET", "/v2/models/relu/ready").status, 200);
+    HttpResponse metadata = client.Request("GET", "/v2/models/relu");
+    EXPECT_EQ(metadata.status, 200);
+    EXPECT_NE(metadata.body.find(R"("inputs":[{"name":"x")"), std::string::npos) << metadata.body;
+
+    // JSON请求与响应，同一连接上连续处理
+    HttpResponse json = client.Request(
+        "POST", "/v2/models/relu/infer",
+        R"({"id":"a","inputs":[{"name":"x","shape":[1,4],"datatype":"FP32","data":[1,-2,3,-4]}]})");
+    EXPECT_EQ(json.status, 200) << json.body;
+    EXPECT_EQ(json.body, R"({"model_name":"relu","model_version":"1","id":"a","outputs":[)"
+                         R"({"name":"y","datatype":"FP32","shape":[1,4],"data":[1,0,3,0]}]})");
+
+    // 二进制扩展：输入直接作为接收缓冲的视图，输出以原始字节跟在JSON之后
+    const std::string header = R"({"inputs":[{"name":"x","shape":[1,4],"datatype":"FP32",)"
+                               R"("parameters":{"binary_data_size":16}}],"parameters":{"binary_data_output":true}})";
+    const float values[4] = {-1.0f, 2.5f, -3.0f, 4.0f};
+    HttpResponse binary = client.Request(
+        "POST", "/v2/models/relu/versions/1/infer",
+        header + std::string(reinterpret_cast<const char*>(values), sizeof(values)),
+        "Inference-Header-Content-Length: " + std::to_string(header.size()) + "\r\n");
+    ASSERT_EQ(binary.status, 200) << binary.body;
+    const size_t field = binary.headers.find("Inference-Header-Content-Length: ");
+    ASSERT_NE(field, std::string::npos);
+    const size_t json_size = std::stoul(binary.headers.substr(field + 33));
+    ASSERT_EQ(binary.body.size(), json_size + 16);
+    EXPECT_NE(binary.body.find(R"("binary_data_size":16)"), std::string::npos);
+    float result[4];
+    std::memcpy(result, binary.body.data() + json_size, sizeof(result));
+    EXPECT_FLOAT_EQ(result[0], 0.0f);
+    EXPECT_FLOAT_EQ(result[1], 2.5f);
+    EXPECT_FLOAT_EQ(result[3], 4.0f);
+
+    // 错误映射到HTTP状态码
+    EXPECT_EQ(client.Request("POST", "/v2/models/relu/infer", "{").status, 400);
+    EXPECT_EQ(client.Request("POST", "/v2/models/other/infer", "{}").status, 404);
+    EXPECT_EQ(client.Request("GET", "/v2/models/relu/versions/2").status, 404);
+    EXPECT_EQ(client.Request("GET", "/v2/models/relu/infer").status, 405);
+
+    // 同一端口上的指标
+    HttpResponse metrics = client.Request("GET", "/metrics");
+    EXPECT_EQ(metrics.status, 200);
+    EXPECT_NE(metrics.body.find("inferunity_server_infer_requests_total"), std::string::npos);
+
+    server.Stop();
+    const ServerStats stats = server.GetStats();
+    EXPECT_EQ(stats.infer_requests, 3u);
+    EXPECT_EQ(stats.infer_failures, 1u);
+    EXPECT_EQ(stats.zero_copy_bytes, 16u);
+    EXPECT_GE(stats.connections, 1u);
+}
+
+TEST(InferenceServerTest, RoutesRequestsThroughDynamicBatcher) {
+    SessionOptions session_options;
+    session_options.max_batch_size = 4;
+    auto session = CreateReluSession(session_options);
+    ASSERT_NE(session, nullptr);
+    ServerOptions options;
+    options.host = "127.0.0.1";
+    options.port = 0;
+    InferenceServer server(options);
+    ServedModelOptions model_options;
+    model_options.dynamic_batching = true;
+    model_options.batching.max_delay_us = 20000;
+    ASSERT_TRUE(server.AddModel("relu", session.get(), model_options).IsOk());
+    ASSERT_TRUE(server.Start().IsOk());
+
+    // 各客户端一个连接，并发的请求合成一批执行，结果按样本拆回
+    constexpr int kClients = 4;
+    std::vector<std::string> bodies(kClients);
+    std::vector<int> statuses(kClients);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < kClients; ++c) {
+        clients.emplace_back([&, c] {
+            HttpClient client(server.GetPort());
+            const std::string value = std::to_string(c - 1);
+            HttpResponse response = client.Request(
+                "POST", "/v2/models/relu/infer",
+                R"({"inputs":[{"name":"x","shape":[1,2],"datatype":"FP32","data":[)" + value + "," + value + "]}]}");
+            statuses[c] = response.status;
+            bodies[c] = response.body;
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    for (int c = 0; c < kClients; ++c) {
+        ASSERT_EQ(statuses[c], 200) << bodies[c];
+        const std::string expected = std::to_string(std::max(c - 1, 0));
+        EXPECT_NE(bodies[c].find("\"data\":[" + expected + "," + expected + "]"), std::string::npos) << bodies[c];
+    }
+    server.Stop();
+    EXPECT_EQ(server.GetStats().infer_requests, static_cast<uint64_t>(kClients));
+    EXPECT_EQ(server.GetStats().infer_failures, 0u);
+}
@@ -1,9 +1,17 @@
 // 形状操作算子测试
 // 测试 Gather, Slice, Transpose, Reshape 等形状操作算子
 
+#include "inferunity/embedding_store.h"
+#include "inferunity/float16.h"
+#include "inferunity/memory.h"
 #include "inferunity/operator.h"
 #include "inferunity/tensor.h"
+#include "operators/simd_utils.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <vector>
 #include <memory>
 
@@ -205,3 +213,560 @@ TEST_F(ShapeOperatorsTest, ReshapeInputValidation) {
     // 可能成功或失败，取决于Reshape的实现
 }
 
+
+// Gather按字节复制：INT64数据、axis=1、负索引
+TEST_F(ShapeOperatorsTest, GatherInt64InnerAxis) {
+    auto gather_op = OperatorRegistry::Instance().Create("Gather");
+    ASSERT_NE(gather_op, nullptr);
+    gather_op->SetAttribute("axis", AttributeValue(static_cast<int64_t>(1)));
+    
+    auto data = CreateTensor(Shape({2, 3}), DataType::INT64, DeviceType::CPU);
+    int64_t* d = static_cast<int64_t*>(data->GetData());
+    for (int64_t i = 0; i < 6; ++i) d[i] = 10 * i;
+    auto indices = CreateTensor(Shape({2}), DataType::INT64, DeviceType::CPU);
+    static_cast<int64_t*>(indices->GetData())[0] = -1;
+    static_cast<int64_t*>(indices->GetData())[1] = 0;
+    
+    std::vector<Tensor*> inputs = {data.get(), indices.get()};
+    std::vector<Shape> output_shapes;
+    ASSERT_TRUE(gather_op->InferOutputShape(inputs, output_shapes).IsOk());
+    EXPECT_EQ(output_shapes[0].dims, (std::vector<int64_t>{2, 2}));
+    EXPECT_EQ(gather_op->InferOutputDataType(inputs, 0), DataType::INT64);
+    
+    auto output = CreateTensor(output_shapes[0], DataType::INT64, DeviceType::CPU);
+    std::vector<Tensor*> outputs = {output.get()};
+    ASSERT_TRUE(gather_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    const int64_t* out = static_cast<const int64_t*>(output->GetData());
+    EXPECT_EQ(out[0], 20);
+    EXPECT_EQ(out[1], 0);
+    EXPECT_EQ(out[2], 50);
+    EXPECT_EQ(out[3], 30);
+}
+
+// 非首维Concat：逐个外层切片交错拼接
+TEST_F(ShapeOperatorsTest, ConcatInnerAxis) {
+    auto concat_op = OperatorRegistry::Instance().Create("Concat");
+    ASSERT_NE(concat_op, nullptr);
+    concat_op->SetAttribute("axis", AttributeValue(static_cast<int64_t>(-1)));
+    
+    auto a = CreateTestTensor(Shape({2, 2}), {1.0f, 2.0f, 3.0f, 4.0f});
+    auto b = CreateTestTensor(Shape({2, 1}), {5.0f, 6.0f});
+    std::vector<Tensor*> inputs = {a.get(), b.get()};
+    std::vector<Shape> output_shapes;
+    ASSERT_TRUE(concat_op->InferOutputShape(inputs, output_shapes).IsOk());
+    EXPECT_EQ(output_shapes[0].dims, (std::vector<int64_t>{2, 3}));
+    
+    auto output = CreateTensor(output_shapes[0], DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> outputs = {output.get()};
+    ASSERT_TRUE(concat_op->Execute(inputs, outputs, ctx_.get()).IsOk());
+    const std::vector<float> expected = {1.0f, 2.0f, 5.0f, 3.0f, 4.0f, 6.0f};
+    const float* out = static_cast<const float*>(output->GetData());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_FLOAT_EQ(out[i], expected[i]);
+    }
+}
+
+// Shape输出INT64形状向量，Cast按to属性转换类型
+TEST_F(ShapeOperatorsTest, ShapeAndCastOperators) {
+    auto shape_op = OperatorRegistry::Instance().Create("Shape");
+    auto cast_op = OperatorRegistry::Instance().Create("Cast");
+    ASSERT_NE(shape_op, nullptr);
+    ASSERT_NE(cast_op, nullptr);
+    
+    auto x = CreateTestTensor(Shape({2, 3, 4}), {});
+    std::vector<Tensor*> inputs = {x.get()};
+    std::vector<Shape> output_shapes;
+    shape_op->SetAttribute("start", AttributeValue(static_cast<int64_t>(1)));
+    ASSERT_TRUE(shape_op->InferOutputShape(inputs, output_shapes).IsOk());
+    EXPECT_EQ(output_shapes[0].dims, (std::vector<int64_t>{2}));
+    EXPECT_EQ(shape_op->InferOutputDataType(inputs, 0), DataType::INT64);
+    auto dims = CreateTensor(output_shapes[0], DataType::INT64, DeviceType::CPU);
+    std::vector<Tensor*> shape_outputs = {dims.get()};
+    ASSERT_TRUE(shape_op->Execute(inputs, shape_outputs, ctx_.get()).IsOk());
+    EXPECT_EQ(static_cast<const int64_t*>(dims->GetData())[0], 3);
+    EXPECT_EQ(static_cast<const int64_t*>(dims->GetData())[1], 4);
+    
+    cast_op->SetAttribute("to", AttributeValue(static_cast<int64_t>(1)));  // FLOAT
+    std::vector<Tensor*> cast_inputs = {dims.get()};
+    EXPECT_EQ(cast_op->InferOutputDataType(cast_inputs, 0), DataType::FLOAT32);
+    auto as_float = CreateTensor(Shape({2}), DataType::FLOAT32, DeviceType::CPU);
+    std::vector<Tensor*> cast_outputs = {as_float.get()};
+    ASSERT_TRUE(cast_op->Execute(cast_inputs, cast_outputs, ctx_.get()).IsOk());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(as_float->GetData())[0], 3.0f);
+    EXPECT_FLOAT_EQ(static_cast<const float*>(as_float->GetData())[1], 4.0f);
+}
+
+// 测试只有元数据的形状/类型推断：输入描述不带数据，常量输入带上张量
+TEST_F(ShapeOperatorsTest, MetadataOnlyInference) {
+    auto shape_op = OperatorRegistry::Instance().Create("Shape");
+    auto reshape_op = OperatorRegistry::Instance().Create("Reshape");
+    ASSERT_NE(shape_op, nullptr);
+    ASSERT_NE(reshape_op, nullptr);
+    
+    // 大激活只有描述，推断时不分配数据
+    TensorInfo x{Shape({1024, 1024, 256}), DataType::FLOAT16, nullptr};
+    std::vector<TensorInfo> outputs;
+    ASSERT_TRUE(shape_op->InferOutputInfo({x}, outputs).IsOk());
+    ASSERT_EQ(outputs.size(), 1u);
+    EXPECT_EQ(outputs[0].shape.dims, (std::vector<int64_t>{3}));
+    EXPECT_EQ(outputs[0].dtype, DataType::INT64);
+    
+    auto target = CreateTensor(Shape({2}), DataType::INT64, DeviceType::CPU);
+    static_cast<int64_t*>(target->GetData())[0] = 1024;
+    static_cast<int64_t*>(target->GetData())[1] = -1;
+    TensorInfo target_info{target->GetShape(), DataType::INT64, target.get()};
+    ASSERT_TRUE(reshape_op->InferOutputInfo({x, target_info}, outputs).IsOk());
+    EXPECT_EQ(outputs[0].shape.dims, (std::vector<int64_t>{1024, 262144}));
+    EXPECT_EQ(outputs[0].dtype, DataType::FLOAT16);
+    
+    // 目标形状不是常量时无法推断
+    target_info.constant = nullptr;
+    EXPECT_FALSE(reshape_op->InferOutputInfo({x, target_info}, outputs).IsOk());
+}
+
+// 转置引擎：各种perm与不是向量宽度倍数的形状在每种ISA下都与逐元素参考一致
+TEST_F(ShapeOperatorsTest, TransposeEngineMatchesReference) {
+    auto transpose_op = OperatorRegistry::Instance().Create("Transpose");
+    ASSERT_NE(transpose_op, nullptr);
+    
+    struct Case {
+        std::vector<int64_t> dims;
+        std::vector<int64_t> perm;
+    };
+    const std::vector<Case> cases = {
+        {{37, 53}, {1, 0}},
+        {{2, 19, 7, 11}, {0, 2, 3, 1}},      // NCHW -> NHWC
+        {{2, 7, 11, 19}, {0, 3, 1, 2}},      // NHWC -> NCHW
+        {{3, 5, 17, 4}, {0, 2, 1, 3}},       // 最内层维度不动
+        {{4, 1, 6, 35}, {3, 1, 0, 2}},       // 含长度为1的维度
+        {{5, 6, 7}, {0, 1, 2}},              // 恒等
+        {{16, 48}, {1, 0}},
+    };
+    
+    auto reference = [](const std::vector<float>& in, const std::vector<int64_t>& dims,
+                        const std::vector<int64_t>& perm) {
+        const size_t rank = dims.size();
+        std::vector<int64_t> strides(rank, 1);
+        for (int64_t i = static_cast<int64_t>(rank) - 2; i >= 0; --i) {
+            strides[i] = strides[i + 1] * dims[i + 1];
+        }
+        std::vector<float> out(in.size());
+        std::vector<int64_t> index(rank, 0);
+        for (size_t flat = 0; flat < out.size(); ++flat) {
+            int64_t src = 0;
+            for (size_t i = 0; i < rank; ++i) {
+                src += index[i] * strides[perm[i]];
+            }
+            out[flat] = in[src];
+            for (int64_t i = static_cast<int64_t>(rank) - 1; i >= 0; --i) {
+                if (++index[i] < dims[perm[i]]) {
+                    break;
+                }
+                index[i] = 0;
+            }
+        }
+        return out;
+    };
+    
+    for (const char* isa : {"scalar", "sse42", "avx2", "avx512", "neon"}) {
+        if (!simd::SetSimdIsa(isa)) {
+            continue;
+        }
+        for (const Case& c : cases) {
+            Shape shape(c.dims);
+            std::vector<float> data(shape.GetElementCount());
+            for (size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<float>(i);
+            }
+            std::vector<int64_t> out_dims;
+            for (int64_t p : c.perm) {
+                out_dims.push_back(c.dims[p]);
+            }
+            auto input = CreateTestTensor(shape, data);
+            auto output = CreateTestTensor(Shape(out_dims), {});
+            transpose_op->SetAttribute("perm", AttributeValue(c.perm));
+            ASSERT_TRUE(transpose_op->Execute({input.get()}, {output.get()}, ctx_.get()).IsOk());
+    
+            const std::vector<float> expected = reference(data, c.dims, c.perm);
+            const float* actual = static_cast<const float*>(output->GetData());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQ(actual[i], expected[i]) << isa << " case rank " << c.dims.size() << " at " << i;
+            }
+        }
+    }
+    simd::SetSimdIsa("auto");
+    
+    // 非法perm返回错误
+    auto input = CreateTestTensor(Shape({2, 3}), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+    auto output = CreateTestTensor(Shape({3, 2}), {});
+    transpose_op->SetAttribute("perm", AttributeValue(std::vector<int64_t>{1, 1}));
+    EXPECT_FALSE(transpose_op->Execute({input.get()}, {output.get()}, ctx_.get()).IsOk());
+}
+
+// 行收集：INT32下标、重复的热点id、去重路径与逐行拷贝结果一致，Embedding与Gather共用
+TEST_F(ShapeOperatorsTest, GatherRowsDeduplicatedMatchesDirect) {
+    auto gather_op = OperatorRegistry::Instance().Create("Gather");
+    auto embedding_op = OperatorRegistry::Instance().Create("Embedding");
+    ASSERT_NE(gather_op, nullptr);
+    ASSERT_NE(embedding_op, nullptr);
+    
+    const int64_t vocab = 97;
+    const int64_t dim = 13;
+    std::vector<float> table_data(vocab * dim);
+    for (size_t i = 0; i < table_data.size(); ++i) {
+        table_data[i] = static_cast<float>(i);
+    }
+    auto table = CreateTestTensor(Shape({vocab, dim}), table_data);
+    
+    const int64_t count = 300;
+    auto ids = CreateTensor(Shape({3, count / 3}), DataType::INT32, DeviceType::CPU);
+    int32_t* id_data = static_cast<int32_t*>(ids->GetData());
+    for (int64_t i = 0; i < count; ++i) {
+        id_data[i] = static_cast<int32_t>(i % 7 == 0 ? 5 : (i * 31) % vocab);  // 5是热点id
+    }
+    
+    for (Operator* op : {gather_op.get(), embedding_op.get()}) {
+        for (int dedup : {0, 1}) {
+            op->SetAttribute("deduplicate", AttributeValue(static_cast<int64_t>(dedup)));
+            auto output = CreateTestTensor(Shape({3, count / 3, dim}), {});
+            std::vector<Tensor*> inputs = {table.get(), ids.get()};
+            if (op == embedding_op.get()) {
+                inputs = {ids.get(), table.get()};
+            }
+            ASSERT_TRUE(op->Execute(inputs, {output.get()}, ctx_.get()).IsOk());
+            const float* out = static_cast<const float*>(output->GetData());
+            for (int64_t i = 0; i < count; ++i) {
+                for (int64_t j = 0; j < dim; ++j) {
+                    ASSERT_EQ(out[i * dim + j], table_data[id_data[i] * dim + j])
+                        << op->GetName() << " dedup=" << dedup << " id " << i;
+                }
+            }
+        }
+    }
+    
+    // 越界下标返回错误
+    id_data[count - 1] = static_cast<int32_t>(vocab);
+    auto output = CreateTestTensor(Shape({3, count / 3, dim}), {});
+    EXPECT_FALSE(gather_op->Execute({table.get(), ids.get()}, {output.get()}, ctx_.get()).IsOk());
+    EXPECT_FALSE(embedding_op->Execute({ids.get(), table.get()}, {output.get()}, ctx_.get()).IsOk());
+}
+
+// 嵌入袋：offsets分袋（含空袋）、逐样本权重、mean模式、FLOAT16与按行量化的UINT8/INT8表，与逐行累加的参考一致
+TEST_F(ShapeOperatorsTest, EmbeddingBagMatchesReference) {
+    const int64_t rows = 53;
+    const int64_t dim = 19;
+    std::vector<float> table_data(rows * dim);
+    for (size_t i = 0; i < table_data.size(); ++i) {
+        table_data[i] = std::sin(0.37f * static_cast<float>(i));
+    }
+    auto table = CreateTestTensor(Shape({rows, dim}), table_data);
+    
+    const std::vector<int64_t> id_values = {3, 7, 3, 52, 0, 11, -1, 29, 7, 7, 40, 18};
+    const std::vector<int64_t> offset_values = {0, 3, 3, 8, 9};  // 第1袋为空
+    auto ids = CreateTensor(Shape({static_cast<int64_t>(id_values.size())}), DataType::INT64, DeviceType::CPU);
+    std::copy(id_values.begin(), id_values.end(), static_cast<int64_t*>(ids->GetData()));
+    auto offsets = CreateTensor(Shape({static_cast<int64_t>(offset_values.size())}), DataType::INT32,
+                                DeviceType::CPU);
+    for (size_t b = 0; b < offset_values.size(); ++b) {
+        static_cast<int32_t*>(offsets->GetData())[b] = static_cast<int32_t>(offset_values[b]);
+    }
+    std::vector<float> weight_values(id_values.size());
+    for (size_t i = 0; i < weight_values.size(); ++i) {
+        weight_values[i] = 0.25f * static_cast<float>(i) - 1.0f;
+    }
+    auto weights = CreateTestTensor(Shape({static_cast<int64_t>(weight_values.size())}), weight_values);
+    
+    // 按行量化：UINT8为[min, max]的非对称量化，INT8为对称量化
+    auto u8_table = CreateTensor(Shape({rows, dim}), DataType::UINT8, DeviceType::CPU);
+    auto s8_table = CreateTensor(Shape({rows, dim}), DataType::INT8, DeviceType::CPU);
+    auto f16_table = CreateTensor(Shape({rows, dim}), DataType::FLOAT16, DeviceType::CPU);
+    std::vector<float> u8_scales(rows), u8_biases(rows), s8_scales(rows);
+    std::vector<float> u8_values(table_data.size()), s8_values(table_data.size()), f16_values(table_data.size());
+    for (int64_t r = 0; r < rows; ++r) {
+        const float* row = table_data.data() + r * dim;
+        const float lo = *std::min_element(row, row + dim);
+        const float hi = *std::max_element(row, row + dim);
+        const float amax = std::max(std::fabs(lo), std::fabs(hi));
+        u8_scales[r] = (hi - lo) / 255.0f;
+        u8_biases[r] = lo;
+        s8_scales[r] = amax / 127.0f;
+        for (int64_t j = 0; j < dim; ++j) {
+            const size_t i = static_cast<size_t>(r * dim + j);
+            const uint8_t u = static_cast<uint8_t>(std::lround((row[j] - lo) / u8_scales[r]));
+            const int8_t q = static_cast<int8_t>(std::lround(row[j] / s8_scales[r]));
+            static_cast<uint8_t*>(u8_table->GetData())[i] = u;
+            static_cast<int8_t*>(s8_table->GetData())[i] = q;
+            static_cast<uint16_t*>(f16_table->GetData())[i] = FloatToHalf(row[j]);
+            u8_values[i] = u * u8_scales[r] + u8_biases[r];
+            s8_values[i] = q * s8_scales[r];
+            f16_values[i] = HalfToFloat(FloatToHalf(row[j]));
+        }
+    }
+    auto u8_scale_tensor = CreateTestTensor(Shape({rows}), u8_scales);
+    auto u8_bias_tensor = CreateTestTensor(Shape({rows}), u8_biases);
+    auto s8_scale_tensor = CreateTestTensor(Shape({rows}), s8_scales);
+    
+    auto reference = [&](const std::vector<float>& values, bool weighted, bool mean) {
+        const size_t bags = offset_values.size();
+        std::vector<float> out(bags * dim, 0.0f);
+        for (size_t b = 0; b < bags; ++b) {
+            const int64_t end = b + 1 < bags ? offset_values[b + 1] : static_cast<int64_t>(id_values.size());
+            for (int64_t i = offset_values[b]; i < end; ++i) {
+                const int64_t row = id_values[i] < 0 ? id_values[i] + rows : id_values[i];
+                for (int64_t j = 0; j < dim; ++j) {
+                    out[b * dim + j] += (weighted ? weight_values[i] : 1.0f) * values[row * dim + j];
+                }
+            }
+            const int64_t count = end - offset_values[b];
+            for (int64_t j = 0; mean && count > 0 && j < dim; ++j) {
+                out[b * dim + j] /= static_cast<float>(count);
+            }
+        }
+        return out;
+    };
+    auto check = [&](const std::vector<Tensor*>& inputs, const std::vector<float>& expected,
+                     const std::string& mode, const std::vector<int64_t>& slots, const char* label) {
+        auto op = OperatorRegistry::Instance().Create("EmbeddingBag");
+        ASSERT_NE(op, nullptr);
+        op->SetAttribute("mode", AttributeValue(mode));
+        if (!slots.empty()) {
+            op->SetAttribute("input_slots", AttributeValue(slots));
+        }
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(op->InferOutputShape(inputs, shapes).IsOk()) << label;
+        ASSERT_EQ(shapes[0].dims, (std::vector<int64_t>{static_cast<int64_t>(offset_values.size()), dim}));
+        auto output = CreateTestTensor(shapes[0], {});
+        ASSERT_TRUE(op->Execute(inputs, {output.get()}, ctx_.get()).IsOk()) << label;
+        const float* out = static_cast<const float*>(output->GetData());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_NEAR(out[i], expected[i], 1e-4f) << label << " element " << i;
+        }
+    };
+    check({table.get(), ids.get(), offsets.get()}, reference(table_data, false, false), "sum", {}, "sum");
+    check({table.get(), ids.get(), offsets.get()}, reference(table_data, false, true), "mean", {}, "mean");
+    check({table.get(), ids.get(), offsets.get(), weights.get()}, reference(table_data, true, false), "sum", {},
+          "weighted");
+    check({f16_table.get(), ids.get(), offsets.get(), weights.get()}, reference(f16_values, true, false), "sum",
+          {}, "fp16");
+    check({u8_table.get(), ids.get(), offsets.get(), weights.get(), u8_scale_tensor.get(), u8_bias_tensor.get()},
+          reference(u8_values, true, false), "sum", {}, "uint8");
+    // 省略per_sample_weights与biases，scales按input_slots定位
+    check({s8_table.get(), ids.get(), offsets.get(), s8_scale_tensor.get()}, reference(s8_values, false, true),
+          "mean", {0, 1, 2, 4}, "int8");
+    
+    // 越界下标与递减的offsets返回错误
+    auto op = OperatorRegistry::Instance().Create("EmbeddingBag");
+    auto output = CreateTestTensor(Shape({static_cast<int64_t>(offset_values.size()), dim}), {});
+    static_cast<int64_t*>(ids->GetData())[5] = rows;
+    EXPECT_FALSE(op->Execute({table.get(), ids.get(), offsets.get()}, {output.get()}, ctx_.get()).IsOk());
+    static_cast<int64_t*>(ids->GetData())[5] = 1;
+    static_cast<int32_t*>(offsets->GetData())[2] = 1;
+    EXPECT_FALSE(op->Execute({table.get(), ids.get(), offsets.get()}, {output.get()}, ctx_.get()).IsOk());
+}
+
+// 分层嵌入表：去重后只查一次，相邻的未命中行合并读盘；缓存满后冷门行不准入，热点行保持命中；
+// 映射文件视图上的Embedding经PrePack改从分层存储读行，结果与直接读表一致
+TEST_F(ShapeOperatorsTest, TieredEmbeddingStoreHotRows) {
+    const int64_t vocab = 256;
+    const int64_t dim = 8;
+    const size_t header = 64;
+    const std::string path = ::testing::TempDir() + "inferunity_embedding_table.bin";
+    std::vector<float> table_data(vocab * dim);
+    for (size_t i = 0; i < table_data.size(); ++i) {
+        table_data[i] = static_cast<float>(i) * 0.5f;
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        const std::vector<char> padding(header, 0);
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char*>(table_data.data()), table_data.size() * sizeof(float));
+    }
+    const size_t row_bytes = dim * sizeof(float);
+    
+    EmbeddingStoreOptions options;
+    options.cache_rows = 4;
+    std::unique_ptr<TieredEmbeddingStore> store;
+    ASSERT_TRUE(TieredEmbeddingStore::Open(path, header, vocab, row_bytes, options, &store).IsOk());
+    auto check = [&](const std::vector<int64_t>& rows) {
+        std::vector<float> out(rows.size() * dim);
+        ASSERT_TRUE(store->Lookup(rows.data(), static_cast<int64_t>(rows.size()), out.data()).IsOk());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            for (int64_t j = 0; j < dim; ++j) {
+                ASSERT_EQ(out[i * dim + j], table_data[rows[i] * dim + j]) << "row " << rows[i];
+            }
+        }
+    };
+    
+    // 7个下标、4个不同的行：10与11相邻，合并为一次读
+    check({10, 11, 10, 200, 3, 11, 3});
+    EmbeddingStoreStats stats = store->GetStats();
+    EXPECT_EQ(stats.lookups, 7u);
+    EXPECT_EQ(stats.unique_rows, 4u);
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.reads, 3u);
+    EXPECT_EQ(stats.bytes_read, 4 * row_bytes);
+    EXPECT_EQ(stats.admissions, 4u);
+    EXPECT_EQ(stats.cached_rows, 4);
+    
+    // 热点行再访问几次后全部命中；只出现一次的冷门行频率不高于淘汰候选，不替换热点行
+    for (int i = 0; i < 3; ++i) {
+        check({3, 10, 11, 200});
+    }
+    check({50, 51, 52});
+    check({3, 10, 11, 200});
+    stats = store->GetStats();
+    EXPECT_EQ(stats.hits, 16u);
+    EXPECT_EQ(stats.rejections, 3u);
+    EXPECT_EQ(stats.cached_rows, 4);
+    
+    std::vector<float> out(dim);
+    const int64_t bad = vocab;
+    EXPECT_FALSE(store->Lookup(&bad, 1, out.data()).IsOk());
+    
+    // 算子路径：表是映射文件的视图
+    std::shared_ptr<MappedFile> mapped;
+    ASSERT_TRUE(MappedFile::Open(path, &mapped).IsOk());
+    auto table = CreateTensorFromData(Shape({vocab, dim}), DataType::FLOAT32,
+                                      const_cast<uint8_t*>(mapped->GetData()) + header);
+    auto embedding_op = OperatorRegistry::Instance().Create("Embedding");
+    ASSERT_NE(embedding_op, nullptr);
+    bool is_packed = false;
+    ASSERT_TRUE(embedding_op->PrePack(1, *table, {Shape({2, 3}), table->GetShape()}, &is_packed).IsOk());
+    EXPECT_FALSE(is_packed);  // 未设置hot_row_cache_rows
+    embedding_op->SetAttribute("hot_row_cache_rows", AttributeValue(static_cast<int64_t>(16)));
+    ASSERT_TRUE(embedding_op->PrePack(1, *table, {Shape({2, 3}), table->GetShape()}, &is_packed).IsOk());
+    EXPECT_TRUE(is_packed);
+    
+    auto ids = CreateTensor(Shape({2, 3}), DataType::INT64, DeviceType::CPU);
+    const std::vector<int64_t> id_values = {7, 255, 7, 0, 128, 129};
+    std::copy(id_values.begin(), id_values.end(), static_cast<int64_t*>(ids->GetData()));
+    auto output = CreateTestTensor(Shape({2, 3, dim}), {});
+    ASSERT_TRUE(embedding_op->Execute({ids.get(), table.get()}, {output.get()}, ctx_.get()).IsOk());
+    const float* result = static_cast<const float*>(output->GetData());
+    for (size_t i = 0; i < id_values.size(); ++i) {
+        for (int64_t j = 0; j < dim; ++j) {
+            ASSERT_EQ(result[i * dim + j], table_data[id_values[i] * dim + j]) << "id " << i;
+        }
+    }
+    table.reset();
+    mapped.reset();
+    std::remove(path.c_str());
+}
+
+// Pad的四种模式（按行手算的结果）、负的pads裁剪与只给部分轴的axes输入
+TEST_F(ShapeOperatorsTest, PadModes) {
+    auto x = CreateTestTensor(Shape({2, 3}), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+    auto make_ints = [](const std::vector<int64_t>& values) {
+        auto tensor = CreateTensor(Shape({static_cast<int64_t>(values.size())}), DataType::INT64, DeviceType::CPU);
+        std::copy(values.begin(), values.end(), static_cast<int64_t*>(tensor->GetData()));
+        return tensor;
+    };
+    auto run = [&](const std::string& mode, const std::vector<Tensor*>& inputs, const std::vector<int64_t>& dims,
+                   const std::vector<float>& expected) {
+        auto pad_op = OperatorRegistry::Instance().Create("Pad");
+        ASSERT_NE(pad_op, nullptr);
+        pad_op->SetAttribute("mode", AttributeValue(mode));
+        if (inputs.size() == 3 && inputs[2]->GetDataType() == DataType::INT64) {
+            pad_op->SetAttribute("input_slots", AttributeValue(std::vector<int64_t>{0, 1, 3}));
+        }
+        std::vector<Shape> shapes;
+        ASSERT_TRUE(pad_op->InferOutputShape(inputs, shapes).IsOk()) << mode;
+        EXPECT_EQ(shapes[0].dims, dims) << mode;
+        auto output = CreateTestTensor(shapes[0], {});
+        ASSERT_TRUE(pad_op->Execute(inputs, {output.get()}, ctx_.get()).IsOk()) << mode;
+        const float* out = static_cast<const float*>(output->GetData());
+        ASSERT_EQ(output->GetElementCount(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_FLOAT_EQ(out[i], expected[i]) << mode << " at " << i;
+        }
+    };
+    
+    // 开头[1, 2]、末尾[0, 1] -> [3, 6]
+    auto pads = make_ints({1, 2, 0, 1});
+    auto value = CreateTestTensor(Shape(std::vector<int64_t>{}), {9.0f});
+    run("constant", {x.get(), pads.get(), value.get()}, {3, 6},
+        {9, 9, 9, 9, 9, 9, 9, 9, 1, 2, 3, 9, 9, 9, 4, 5, 6, 9});
+    run("reflect", {x.get(), pads.get()}, {3, 6},
+        {6, 5, 4, 5, 6, 5, 3, 2, 1, 2, 3, 2, 6, 5, 4, 5, 6, 5});
+    run("edge", {x.get(), pads.get()}, {3, 6},
+        {1, 1, 1, 2, 3, 3, 1, 1, 1, 2, 3, 3, 4, 4, 4, 5, 6, 6});
+    run("wrap", {x.get(), pads.get()}, {3, 6},
+        {5, 6, 4, 5, 6, 4, 2, 3, 1, 2, 3, 1, 5, 6, 4, 5, 6, 4});
+    
+    auto crop = make_ints({0, -1, 0, 0});
+    run("constant", {x.get(), crop.get()}, {2, 2}, {2, 3, 5, 6});
+    
+    // Pad(x, pads, "", axes)：省略constant_value，只填充最后一维
+    auto last_pads = make_ints({1, 1});
+    auto axes = make_ints({-1});
+    run("constant", {x.get(), last_pads.get(), axes.get()}, {2, 5}, {0, 1, 2, 3, 0, 0, 4, 5, 6, 0});
+    
+    // 只在第0轴填充时输入是输出中连续的一块；输入已在输出内时只写边框
+    auto pad_op = OperatorRegistry::Instance().Create("Pad");
+    auto rows = make_ints({1, 0, 2, 0});
+    int axis = -1;
+    int64_t start = -1;
+    ASSERT_TRUE(pad_op->GetSliceOrigin({x.get(), rows.get()}, &axis, &start));
+    EXPECT_EQ(axis, 0);
+    EXPECT_EQ(start, 1);
+    EXPECT_FALSE(pad_op->GetSliceOrigin({x.get(), pads.get()}, &axis, &start));
+    EXPECT_FALSE(pad_op->GetSliceOrigin({x.get(), crop.get()}, &axis, &start));
+    auto whole = CreateTestTensor(Shape({5, 3}), {});
+    float* data = static_cast<float*>(whole->GetData());
+    std::fill(data, data + 15, -1.0f);
+    std::copy(static_cast<const float*>(x->GetData()), static_cast<const float*>(x->GetData()) + 6, data + 3);
+    auto inside = CreateTensorFromData(Shape({2, 3}), DataType::FLOAT32, data + 3);
+    ASSERT_TRUE(pad_op->Execute({inside.get(), rows.get()}, {whole.get()}, ctx_.get()).IsOk());
+    const std::vector<float> expected = {0, 0, 0, 1, 2, 3, 4, 5, 6, 0, 0, 0, 0, 0, 0};
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_FLOAT_EQ(data[i], expected[i]);
+    }
+}
+
+// Flatten与推理模式的Dropout只改元数据：输出是输入的视图，Dropout的mask全为true
+TEST_F(ShapeOperatorsTest, FlattenAndDropout) {
+    auto flatten_op = OperatorRegistry::Instance().Create("Flatten");
+    auto dropout_op = OperatorRegistry::Instance().Create("Dropout");
+    ASSERT_NE(flatten_op, nullptr);
+    ASSERT_NE(dropout_op, nullptr);
+    std::vector<float> values(24);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i);
+    auto x = CreateTestTensor(Shape({2, 3, 4}), values);
+    
+    std::vector<Shape> shapes;
+    ASSERT_TRUE(flatten_op->InferOutputShape({x.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{2, 12}));
+    flatten_op->SetAttribute("axis", AttributeValue(static_cast<int64_t>(-1)));
+    shapes.clear();
+    ASSERT_TRUE(flatten_op->InferOutputShape({x.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{6, 4}));
+    flatten_op->SetAttribute("axis", AttributeValue(static_cast<int64_t>(0)));
+    shapes.clear();
+    ASSERT_TRUE(flatten_op->InferOutputShape({x.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, (std::vector<int64_t>{1, 24}));
+    EXPECT_TRUE(flatten_op->IsViewOperator());
+    auto view = flatten_op->CreateOutputView({x});
+    ASSERT_NE(view, nullptr);
+    EXPECT_EQ(view->GetData(), x->GetData());
+    EXPECT_EQ(view->GetShape().dims, (std::vector<int64_t>{1, 24}));
+    
+    shapes.clear();
+    ASSERT_TRUE(dropout_op->InferOutputShape({x.get()}, shapes).IsOk());
+    EXPECT_EQ(shapes[0].dims, x->GetShape().dims);
+    EXPECT_EQ(dropout_op->InferOutputDataType({x.get()}, 0), DataType::FLOAT32);
+    EXPECT_EQ(dropout_op->InferOutputDataType({x.get()}, 1), DataType::BOOL);
+    auto output = CreateTestTensor(x->GetShape(), {});
+    auto mask = CreateTensor(x->GetShape(), DataType::BOOL, DeviceType::CPU);
+    ASSERT_TRUE(dropout_op->Execute({x.get()}, {output.get(), mask.get()}, ctx_.get()).IsOk());
+    const float* out = static_cast<const float*>(output->GetData());
+    const uint8_t* keep = static_cast<const uint8_t*>(mask->GetData());
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_FLOAT_EQ(out[i], values[i]);
+        EXPECT_EQ(keep[i], 1);
+    }
+    
+    auto ratio = CreateTestTensor(Shape(std::vector<int64_t>{}), {0.5f});
+    auto training = CreateTensor(Shape(std::vector<int64_t>{}), DataType::BOOL, DeviceType::CPU);
+    *static_cast<uint8_t*>(training->GetData()) = 1;
+    EXPECT_FALSE(dropout_op->ValidateInputs({x.get(), ratio.get(), training.get()}).IsOk());
+}
@@ -4,9 +4,13 @@
 #include <gtest/gtest.h>
 #include "inferunity/tensor.h"
 #include "inferunity/types.h"
+#include "inferunity/data_transfer.h"
+#include "inferunity/tensor_wire.h"
 #include <vector>
 #include <cmath>
 #include <cstring>
+#include <future>
+#include <unistd.h>
 
 using namespace inferunity;
 
@@ -22,18 +26,18 @@ protected:
     bool CompareTensors(const Tensor& a, const Tensor& b, float tolerance = 1e-5f) {
         const Shape& shape_a = a.GetShape();
         const Shape& shape_b = b.GetShape();
-        
+    
         if (shape_a.dims.size() != shape_b.dims.size()) return false;
         for (size_t i = 0; i < shape_a.dims.size(); ++i) {
             if (shape_a.dims[i] != shape_b.dims[i]) return false;
         }
-        
+    
         if (a.GetDataType() != b.GetDataType()) return false;
-        
+    
         size_t count = a.GetElementCount();
         const float* data_a = static_cast<const float*>(a.GetData());
         const float* data_b = static_cast<const float*>(b.GetData());
-        
+    
         for (size_t i = 0; i < count; ++i) {
             if (std::abs(data_a[i] - data_b[i]) > tolerance) {
                 return false;
@@ -216,3 +220,263 @@ TEST_F(TensorTest, SliceNegativeIndices) {
     EXPECT_FLOAT_EQ(slice_data[0], 10.0f);
 }
 
+
+// 测试批组装：SplitBatch视图共享缓冲，相邻槽位ConcatBatch不拷贝
+TEST_F(TensorTest, SplitAndConcatBatch) {
+    auto batch = CreateTensor(Shape({4, 3}), DataType::FLOAT32, DeviceType::CPU);
+    float* data = static_cast<float*>(batch->GetData());
+    for (size_t i = 0; i < 12; ++i) {
+        data[i] = static_cast<float>(i);
+    }
+    
+    auto views = SplitBatch(batch, {1, 3});
+    ASSERT_EQ(views.size(), 2u);
+    EXPECT_EQ(views[1]->GetShape().dims, std::vector<int64_t>({3, 3}));
+    EXPECT_EQ(views[1]->GetData(), data + 3);
+    EXPECT_TRUE(SplitBatch(batch, {1, 2}).empty());
+    
+    // 视图持有批缓冲的引用
+    const void* base = batch->GetData();
+    batch.reset();
+    EXPECT_FLOAT_EQ(static_cast<const float*>(views[1]->GetData())[0], 3.0f);
+    
+    auto merged = ConcatBatch({views[0].get(), views[1].get()});
+    ASSERT_NE(merged, nullptr);
+    EXPECT_EQ(merged->GetShape().dims, std::vector<int64_t>({4, 3}));
+    EXPECT_EQ(merged->GetData(), base);
+    EXPECT_FALSE(merged->IsOwned());
+    
+    // 顺序颠倒时不相邻，拷贝到新张量
+    auto copied = ConcatBatch({views[1].get(), views[0].get()});
+    ASSERT_NE(copied, nullptr);
+    EXPECT_TRUE(copied->IsOwned());
+    const float* copied_data = static_cast<const float*>(copied->GetData());
+    EXPECT_FLOAT_EQ(copied_data[0], 3.0f);
+    EXPECT_FLOAT_EQ(copied_data[9], 0.0f);
+    
+    auto other = CreateTensor(Shape({1, 2}), DataType::FLOAT32, DeviceType::CPU);
+    EXPECT_EQ(ConcatBatch({views[0].get(), other.get()}), nullptr);
+}
+
+namespace {
+
+// 模拟设备的数据传输：设备内存就是主机内存，异步拷贝在后台线程上进行
+class FakeAsyncTransfer : public DataTransfer {
+public:
+    class Event : public TransferEvent {
+    public:
+        explicit Event(std::shared_future<void> done) : done_(std::move(done)) {}
+        bool IsComplete() override {
+            return done_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+        Status Wait() override {
+            done_.wait();
+            return Status::Ok();
+        }
+    
+    private:
+        std::shared_future<void> done_;
+    };
+    
+    Status CopyHostToDevice(void* dst, const void* src, size_t size) override {
+        ++sync_copies;
+        std::memcpy(dst, src, size);
+        return Status::Ok();
+    }
+    Status CopyDeviceToHost(void* dst, const void* src, size_t size) override {
+        ++sync_copies;
+        std::memcpy(dst, src, size);
+        return Status::Ok();
+    }
+    Status CopyDeviceToDevice(void* dst, const void* src, size_t size) override {
+        std::memcpy(dst, src, size);
+        return Status::Ok();
+    }
+    Status CopyHostToDeviceAsync(void* dst, const void* src, size_t size, void* stream,
+                                 std::shared_ptr<TransferEvent>* event) override {
+        (void)stream;
+        // 与真实实现一样先暂存源数据，返回后调用方即可复用src
+        auto staging = std::make_shared<std::vector<uint8_t>>(
+            static_cast<const uint8_t*>(src), static_cast<const uint8_t*>(src) + size);
+        *event = Launch([dst, staging]() { std::memcpy(dst, staging->data(), staging->size()); });
+        return Status::Ok();
+    }
+    Status CopyDeviceToHostAsync(void* dst, const void* src, size_t size, void* stream,
+                                 std::shared_ptr<TransferEvent>* event) override {
+        (void)stream;
+        *event = Launch([dst, src, size]() { std::memcpy(dst, src, size); });
+        return Status::Ok();
+    }
+    
+    int sync_copies = 0;
+    int async_copies = 0;
+    std::promise<void> gate;  // 异步拷贝等到放行才执行，用来观察未完成的事件
+
+private:
+    std::shared_ptr<TransferEvent> Launch(std::function<void()> copy) {
+        ++async_copies;
+        std::shared_future<void> open = gate_future_;
+        auto done = std::async(std::launch::async, [open, copy]() {
+            open.wait();
+            copy();
+        }).share();
+        return std::make_shared<Event>(done);
+    }
+    
+    std::shared_future<void> gate_future_ = gate.get_future().share();
+};
+
+} // anonymous namespace
+
+// 测试跨设备拷贝：同步拷贝经由注册的DataTransfer，异步拷贝立即返回事件，等待后数据可用
+TEST_F(TensorTest, AsyncDeviceCopy) {
+    Shape shape({4, 8});
+    auto host = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    auto device = CreateTensor(shape, DataType::FLOAT32, DeviceType::CUDA);
+    auto back = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
+    float* host_data = static_cast<float*>(host->GetData());
+    for (size_t i = 0; i < host->GetElementCount(); ++i) {
+        host_data[i] = static_cast<float>(i) * 0.5f;
+    }
+    
+    // 没有注册数据传输时无法跨设备拷贝
+    EXPECT_EQ(host->CopyTo(*device).Code(), StatusCode::ERROR_NOT_IMPLEMENTED);
+    
+    auto transfer = std::make_shared<FakeAsyncTransfer>();
+    SetDataTransfer(DeviceType::CUDA, transfer);
+    
+    std::shared_ptr<TransferEvent> upload;
+    ASSERT_TRUE(host->CopyToAsync(*device, &upload).IsOk());
+    ASSERT_NE(upload, nullptr);
+    EXPECT_FALSE(upload->IsComplete());
+    // 源数据已经暂存，上传完成前覆盖不影响结果
+    host_data[0] = -1.0f;
+    transfer->gate.set_value();
+    ASSERT_TRUE(upload->Wait().IsOk());
+    EXPECT_TRUE(upload->IsComplete());
+    EXPECT_FLOAT_EQ(static_cast<const float*>(device->GetData())[0], 0.0f);
+    
+    std::shared_ptr<TransferEvent> download;
+    ASSERT_TRUE(back->CopyFromAsync(*device, &download).IsOk());
+    ASSERT_TRUE(download->Wait().IsOk());
+    EXPECT_EQ(transfer->async_copies, 2);
+    const float* back_data = static_cast<const float*>(back->GetData());
+    for (size_t i = 1; i < back->GetElementCount(); ++i) {
+        ASSERT_FLOAT_EQ(back_data[i], static_cast<float>(i) * 0.5f);
+    }
+    
+    // 同步拷贝与主机内拷贝
+    ASSERT_TRUE(back->CopyTo(*device).IsOk());
+    EXPECT_EQ(transfer->sync_copies, 1);
+    std::shared_ptr<TransferEvent> local;
+    ASSERT_TRUE(host->CopyToAsync(*back, &local).IsOk());
+    EXPECT_TRUE(local->IsComplete());
+    EXPECT_FLOAT_EQ(back_data[0], -1.0f);
+    
+    auto mismatched = CreateTensor(Shape({2, 8}), DataType::FLOAT32, DeviceType::CUDA);
+    EXPECT_FALSE(host->CopyToAsync(*mismatched, &local).IsOk());
+    
+    SetDataTransfer(DeviceType::CUDA, nullptr);
+}
+
+// 测试步长视图：转置与切片只改元数据，需要连续数据时按行主序拷贝
+TEST_F(TensorTest, StridedViews) {
+    auto base = CreateTensor(Shape({2, 3}), DataType::FLOAT32, DeviceType::CPU);
+    float* data = static_cast<float*>(base->GetData());
+    for (size_t i = 0; i < 6; ++i) {
+        data[i] = static_cast<float>(i);
+    }
+    EXPECT_TRUE(base->IsContiguous());
+    EXPECT_EQ(base->GetStrides(), std::vector<int64_t>({3, 1}));
+    
+    auto transposed = CreateStridedView(base, Shape({3, 2}), {1, 3});
+    ASSERT_NE(transposed, nullptr);
+    EXPECT_FALSE(transposed->IsContiguous());
+    EXPECT_EQ(transposed->GetData(), base->GetData());
+    auto dense = MakeContiguous(transposed);
+    ASSERT_NE(dense, nullptr);
+    EXPECT_TRUE(dense->IsContiguous());
+    const float* dense_data = static_cast<const float*>(dense->GetData());
+    EXPECT_EQ(std::vector<float>(dense_data, dense_data + 6), std::vector<float>({0, 3, 1, 4, 2, 5}));
+    EXPECT_EQ(MakeContiguous(dense), dense);
+    
+    // 序列化按逻辑顺序写出
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(transposed->Serialize(buffer).IsOk());
+    Tensor restored;
+    ASSERT_TRUE(restored.Deserialize(buffer).IsOk());
+    EXPECT_TRUE(CompareTensors(restored, *dense));
+    
+    // 切片视图的起点偏移，长度为1的维度不影响连续性
+    auto column = CreateStridedView(base, Shape({2, 2}), {3, 1}, 1);
+    ASSERT_NE(column, nullptr);
+    auto column_dense = CreateTensor(Shape({2, 2}), DataType::FLOAT32, DeviceType::CPU);
+    ASSERT_TRUE(column->CopyTo(*column_dense).IsOk());
+    const float* column_data = static_cast<const float*>(column_dense->GetData());
+    EXPECT_EQ(std::vector<float>(column_data, column_data + 4), std::vector<float>({1, 2, 4, 5}));
+    auto row = CreateStridedView(base, Shape({1, 3}), {6, 1}, 3);
+    ASSERT_NE(row, nullptr);
+    EXPECT_TRUE(row->IsContiguous());
+    EXPECT_EQ(CreateStridedView(base, Shape({2, 3}), {}, 1), nullptr);
+    EXPECT_EQ(CreateStridedView(base, Shape({2, 2}), {3, 3}), nullptr);
+    
+    // 视图持有base的引用
+    base.reset();
+    EXPECT_FLOAT_EQ(static_cast<const float*>(transposed->GetData())[1], 1.0f);
+}
+
+TEST_F(TensorTest, WireFormatZeroCopy) {
+    auto tensor = CreateTensor(Shape({2, 3, 4}), DataType::FLOAT32, DeviceType::CPU);
+    float* data = static_cast<float*>(tensor->GetData());
+    for (size_t i = 0; i < tensor->GetElementCount(); ++i) {
+        data[i] = static_cast<float>(i) * 0.5f;
+    }
+    
+    // 发送侧：载荷段直接指向张量数据
+    TensorWireMessage message;
+    ASSERT_TRUE(EncodeTensorWire(*tensor, &message).IsOk());
+    EXPECT_EQ(message.payload, tensor->GetData());
+    EXPECT_EQ(message.GetTotalSize(), sizeof(TensorWireHeader) + tensor->GetSizeInBytes());
+    struct iovec iov[2];
+    ASSERT_EQ(message.FillIovec(iov), 2);
+    EXPECT_EQ(iov[0].iov_len, sizeof(TensorWireHeader));
+    EXPECT_EQ(iov[1].iov_base, tensor->GetData());
+    
+    // Serialize产生同一格式，接收侧包装为指向缓冲内载荷的张量
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(tensor->Serialize(buffer).IsOk());
+    EXPECT_EQ(buffer.size(), message.GetTotalSize());
+    EXPECT_EQ(std::memcmp(buffer.data(), &message.header, sizeof(TensorWireHeader)), 0);
+    std::shared_ptr<Tensor> view;
+    size_t consumed = 0;
+    ASSERT_TRUE(DecodeTensorWire(buffer.data(), buffer.size(), &view, &consumed).IsOk());
+    EXPECT_EQ(consumed, buffer.size());
+    EXPECT_EQ(view->GetData(), buffer.data() + sizeof(TensorWireHeader));
+    EXPECT_FALSE(view->IsOwned());
+    EXPECT_TRUE(CompareTensors(*view, *tensor));
+    
+    // 持有owner的视图在缓冲的其余引用释放后仍然有效
+    auto owned = std::make_shared<std::vector<uint8_t>>(buffer);
+    std::shared_ptr<Tensor> kept;
+    ASSERT_TRUE(DecodeTensorWire(owned->data(), owned->size(), owned, &kept).IsOk());
+    owned.reset();
+    EXPECT_TRUE(CompareTensors(*kept, *tensor));
+    
+    // 截断、伪造的头被拒绝
+    EXPECT_FALSE(DecodeTensorWire(buffer.data(), buffer.size() - 1, &view).IsOk());
+    std::vector<uint8_t> forged = buffer;
+    reinterpret_cast<TensorWireHeader*>(forged.data())->dims[0] = 1000;
+    EXPECT_FALSE(DecodeTensorWire(forged.data(), forged.size(), &view).IsOk());
+    Tensor rejected;
+    EXPECT_FALSE(rejected.Deserialize(forged).IsOk());
+    
+    // writev写出、读端直接读入张量
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_TRUE(WriteTensorWire(fds[1], *tensor).IsOk());
+    close(fds[1]);
+    std::shared_ptr<Tensor> received;
+    ASSERT_TRUE(ReadTensorWire(fds[0], &received).IsOk());
+    close(fds[0]);
+    EXPECT_TRUE(CompareTensors(*received, *tensor));
+}
@@ -0,0 +1,170 @@
+// 静态图AOT编译工具
+// 把ONNX或紧凑格式模型优化、做内存规划后生成独立的C++推理函数（见inferunity/aot_compiler.h）：
+//   <prefix>.h           接口声明
+//   <prefix>.cpp         按执行顺序直接调用内核的模型函数
+//   <prefix>_weights.cpp 常量权重字节数组
+// 生成的源文件与inferunity_operators一起编译链接即可运行，不需要会话或算子注册表
+
+#include "inferunity/aot_compiler.h"
+#include "inferunity/graph.h"
+#include "inferunity/memory_planner.h"
+#include "inferunity/model_format.h"
+#include "inferunity/optimizer.h"
+#include "inferunity/tensor.h"
+#include "frontend/onnx_parser.h"
+// 前向声明形状推断函数
+namespace inferunity {
+    Status InferShapes(Graph* graph);
+}
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace inferunity;
+using namespace inferunity::frontend;
+
+namespace {
+
+Status LoadGraph(const std::string& path, std::unique_ptr<Graph>& graph) {
+    if (IsCompactModelFile(path)) {
+        return LoadCompactModel(path, graph);
+    }
+    ONNXParser parser;
+    Status status = parser.LoadFromFile(path);
+    if (!status.IsOk()) {
+        return status;
+    }
+    return parser.ConvertToGraph(graph);
+}
+
+// "name=d0,d1,..."：把图输入固定为给定形状（模型的批维度等为动态时）
+Status ApplyInputShape(Graph* graph, const std::string& spec) {
+    const size_t eq = spec.find('=');
+    if (eq == std::string::npos) {
+        return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "Expected --shape name=d0,d1,...: " + spec);
+    }
+    const std::string name = spec.substr(0, eq);
+    std::vector<int64_t> dims;
+    std::stringstream stream(spec.substr(eq + 1));
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        dims.push_back(std::stoll(item));
+    }
+    for (Value* input : graph->GetInputs()) {
+        if (input->GetName() == name) {
+            input->SetTensor(CreateTensor(Shape(dims), DataType::FLOAT32, DeviceType::CPU));
+            return Status::Ok();
+        }
+    }
+    return Status::Error(StatusCode::ERROR_INVALID_ARGUMENT, "No graph input named " + name);
+}
+
+Status WriteFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Cannot write " + path);
+    }
+    file << content;
+    return file ? Status::Ok() : Status::Error(StatusCode::ERROR_RUNTIME_ERROR, "Failed to write " + path);
+}
+
+Status CompileModel(const std::string& model_path, const std::string& prefix, const std::string& name,
+                    const std::vector<std::string>& shapes) {
+    std::unique_ptr<Graph> graph;
+    Status status = LoadGraph(model_path, graph);
+    if (!status.IsOk()) {
+        return status;
+    }
+    for (const std::string& spec : shapes) {
+        status = ApplyInputShape(graph.get(), spec);
+        if (!status.IsOk()) {
+            return status;
+        }
+    }
+    status = InferShapes(graph.get());
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    // 只用不改变算子集合的Pass：融合产生的多数算子没有AOT内核
+    Optimizer optimizer;
+    optimizer.RegisterPass(std::make_unique<ConstantFoldingPass>());
+    optimizer.RegisterPass(std::make_unique<IdentityEliminationPass>());
+    optimizer.RegisterPass(std::make_unique<DeadCodeEliminationPass>());
+    optimizer.RegisterPass(std::make_unique<ConvBNFoldingPass>());
+    status = optimizer.Optimize(graph.get());
+    if (!status.IsOk()) {
+        std::cerr << "Warning: Graph optimization failed: " << status.Message() << std::endl;
+    }
+    status = InferShapes(graph.get());
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    MemoryPlan plan;
+    status = PlanMemory(graph.get(), MemoryPlannerOptions(), &plan);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    AotCompileOptions options;
+    options.function_name = name;
+    options.header_name = prefix.substr(prefix.find_last_of("/\\") + 1) + ".h";
+    AotCompileResult result;
+    status = CompileGraphToSource(*graph, plan, options, &result);
+    if (!status.IsOk()) {
+        return status;
+    }
+    status = WriteFile(prefix + ".h", result.header);
+    if (status.IsOk()) status = WriteFile(prefix + ".cpp", result.source);
+    if (status.IsOk()) status = WriteFile(prefix + "_weights.cpp", result.weights_source);
+    if (!status.IsOk()) {
+        return status;
+    }
+    
+    std::cout << "AOT compilation successful!" << std::endl;
+    std::cout << "  Function:     " << name << std::endl;
+    std::cout << "  Kernel calls: " << result.num_kernel_calls << std::endl;
+    std::cout << "  Arena:        " << result.arena_size << " bytes" << std::endl;
+    std::cout << "  Weights:      " << result.weights.size() << " bytes" << std::endl;
+    std::cout << "  Output:       " << prefix << ".h, " << prefix << ".cpp, " << prefix << "_weights.cpp"
+              << std::endl;
+    return Status::Ok();
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <model_path> <output_prefix> [options]" << std::endl;
+        std::cerr << "\nOptions:" << std::endl;
+        std::cerr << "  --name <identifier>        Generated function name (default: inferunity_model)" << std::endl;
+        std::cerr << "  --shape <name=d0,d1,...>   Fix the shape of a graph input (repeatable)" << std::endl;
+        return 1;
+    }
+    
+    const std::string model_path = argv[1];
+    const std::string prefix = argv[2];
+    std::string name = "inferunity_model";
+    std::vector<std::string> shapes;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--shape" && i + 1 < argc) {
+            shapes.push_back(argv[++i]);
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    Status status = CompileModel(model_path, prefix, name, shapes);
+    if (!status.IsOk()) {
+        std::cerr << "AOT compilation failed: " << status.Message() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,14 +1,28 @@
 // 性能基准测试工具
-// 用于测试InferUnity的推理性能
+// 用于测试InferUnity的推理性能：默认为单线程顺序执行的延迟；
+// --load为并发负载模式（参考Triton的perf_analyzer与MLPerf LoadGen的Server场景）：
+// closed为N个客户端线程各自循环发请求，open为按泊松过程以目标QPS到达、由工作线程执行，
+// 开环的延迟从计划到达时刻算起（含排队），避免协调遗漏（coordinated omission）
 
 #include "inferunity/engine.h"
 #include "inferunity/tensor.h"
 #include "inferunity/memory.h"
+#include "inferunity/batcher.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
 #include <vector>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace inferunity;
 using namespace std::chrono;
@@ -120,23 +134,318 @@ void PrintResults(const BenchmarkResult& result) {
     std::cout << "=======================================" << std::endl;
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <model_path> [warmup_iterations] [test_iterations]" << std::endl;
-        return 1;
+// ---------------- 并发负载模式 ----------------
+
+struct LoadOptions {
+    std::string mode;                   // "closed"或"open"，为空时只做顺序测量
+    std::vector<int> clients = {1};     // 闭环的客户端线程数；开环时为执行请求的工作线程数
+    std::vector<double> qps;            // 开环的目标到达率（每秒请求数）
+    double duration_s = 10.0;           // 每种配置的测量时长
+    int sessions = 1;                   // 会话池大小，1为所有线程共享一个会话
+    bool batcher = false;               // 经每个会话的DynamicBatcher提交
+    DynamicBatcherOptions batcher_options;
+    double slo_ms = 0.0;                // 延迟SLO，0为不检查
+    std::string output_csv;
+};
+
+struct LoadResult {
+    std::string mode;
+    int clients = 0;
+    double target_qps = 0.0;
+    size_t completed = 0;
+    size_t errors = 0;
+    double wall_s = 0.0;
+    double throughput = 0.0;            // 完成的请求数 / 墙钟时间
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double p999_ms = 0.0;
+    double max_ms = 0.0;
+    double cpu_utilization = 0.0;       // 进程CPU时间 / (墙钟时间 × 硬件线程数)，百分比
+    double slo_attainment = 0.0;        // 延迟不超过SLO的请求比例，百分比
+};
+
+// 请求的执行目标：共享会话或会话池，可选经动态批处理器；线程i固定使用第i % N个会话
+class LoadTarget {
+public:
+    LoadTarget(std::vector<std::unique_ptr<InferenceSession>> sessions,
+               std::vector<std::shared_ptr<Tensor>> inputs,
+               bool use_batcher, const DynamicBatcherOptions& batcher_options)
+        : sessions_(std::move(sessions)), inputs_(std::move(inputs)) {
+        for (const auto& tensor : inputs_) {
+            input_ptrs_.push_back(tensor.get());
+        }
+        if (use_batcher) {
+            for (const auto& session : sessions_) {
+                batchers_.push_back(std::make_unique<DynamicBatcher>(session.get(), batcher_options));
+            }
+        }
     }
     
-    std::string model_path = argv[1];
-    int warmup_iterations = (argc > 2) ? std::stoi(argv[2]) : 10;
-    int test_iterations = (argc > 3) ? std::stoi(argv[3]) : 100;
+    Status Execute(size_t worker) {
+        const size_t index = worker % sessions_.size();
+        if (!batchers_.empty()) {
+            return batchers_[index]->Submit(inputs_).get().status;
+        }
+        std::vector<std::shared_ptr<Tensor>> outputs;
+        return sessions_[index]->Run(input_ptrs_, outputs);
+    }
     
-    std::cout << "InferUnity Benchmark Tool" << std::endl;
-    std::cout << "Model: " << model_path << std::endl;
-    std::cout << "Warmup iterations: " << warmup_iterations << std::endl;
-    std::cout << "Test iterations: " << test_iterations << std::endl;
+    size_t GetSessionCount() const { return sessions_.size(); }
+
+private:
+    std::vector<std::unique_ptr<InferenceSession>> sessions_;
+    std::vector<std::shared_ptr<Tensor>> inputs_;
+    std::vector<Tensor*> input_ptrs_;
+    std::vector<std::unique_ptr<DynamicBatcher>> batchers_;
+};
+
+double PercentileMs(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double position = p * static_cast<double>(sorted.size() - 1);
+    const size_t lower = static_cast<size_t>(position);
+    const size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - static_cast<double>(lower));
+}
+
+void SummarizeLatencies(std::vector<double> latencies, double slo_ms, LoadResult* result) {
+    std::sort(latencies.begin(), latencies.end());
+    result->completed = latencies.size();
+    result->throughput = result->wall_s > 0 ? static_cast<double>(latencies.size()) / result->wall_s : 0.0;
+    if (latencies.empty()) {
+        return;
+    }
+    double sum = 0.0;
+    size_t within_slo = 0;
+    for (double latency : latencies) {
+        sum += latency;
+        within_slo += latency <= slo_ms ? 1 : 0;
+    }
+    result->mean_ms = sum / static_cast<double>(latencies.size());
+    result->p50_ms = PercentileMs(latencies, 0.5);
+    result->p90_ms = PercentileMs(latencies, 0.9);
+    result->p99_ms = PercentileMs(latencies, 0.99);
+    result->p999_ms = PercentileMs(latencies, 0.999);
+    result->max_ms = latencies.back();
+    result->slo_attainment = slo_ms > 0 ? 100.0 * static_cast<double>(within_slo) / latencies.size() : 0.0;
+}
+
+// 闭环：每个客户端完成一个请求后立即发下一个，到达率由系统自身的延迟决定
+LoadResult RunClosedLoop(LoadTarget* target, int clients, const LoadOptions& options) {
+    LoadResult result;
+    result.mode = "closed";
+    result.clients = clients;
+    
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<size_t> errors{0};
+    const auto start = steady_clock::now();
+    const auto deadline = start + duration<double>(options.duration_s);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c]() {
+            while (steady_clock::now() < deadline) {
+                const auto begin = steady_clock::now();
+                Status status = target->Execute(static_cast<size_t>(c));
+                const auto end = steady_clock::now();
+                if (status.IsOk()) {
+                    latencies[c].push_back(duration<double, std::milli>(end - begin).count());
+                } else {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.wall_s = duration<double>(steady_clock::now() - start).count();
+    result.errors = errors.load();
+    
+    std::vector<double> merged;
+    for (const auto& per_client : latencies) {
+        merged.insert(merged.end(), per_client.begin(), per_client.end());
+    }
+    SummarizeLatencies(std::move(merged), options.slo_ms, &result);
+    return result;
+}
+
+// 开环：调度线程按指数分布的间隔生成到达时刻并入队，workers个工作线程取出执行；
+// 工作线程都忙时请求在队列中等待，等待时间计入延迟。到达在duration_s内截止，之后排空队列
+LoadResult RunOpenLoop(LoadTarget* target, double qps, int workers, const LoadOptions& options) {
+    LoadResult result;
+    result.mode = "open";
+    result.clients = workers;
+    result.target_qps = qps;
+    
+    using TimePoint = steady_clock::time_point;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<TimePoint> arrivals;
+    bool done = false;
+    
+    std::vector<std::vector<double>> latencies(workers);
+    std::atomic<size_t> errors{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w]() {
+            while (true) {
+                TimePoint scheduled;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return done || !arrivals.empty(); });
+                    if (arrivals.empty()) {
+                        return;
+                    }
+                    scheduled = arrivals.front();
+                    arrivals.pop_front();
+                }
+                Status status = target->Execute(static_cast<size_t>(w));
+                const auto end = steady_clock::now();
+                if (status.IsOk()) {
+                    latencies[w].push_back(duration<double, std::milli>(end - scheduled).count());
+                } else {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    
+    std::mt19937_64 rng(42);
+    std::exponential_distribution<double> interval(qps);
+    const auto start = steady_clock::now();
+    const auto deadline = start + duration<double>(options.duration_s);
+    auto next = start;
+    while (true) {
+        next += duration_cast<steady_clock::duration>(duration<double>(interval(rng)));
+        if (next >= deadline) {
+            break;
+        }
+        std::this_thread::sleep_until(next);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            arrivals.push_back(next);
+        }
+        cv.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    cv.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.wall_s = duration<double>(steady_clock::now() - start).count();
+    result.errors = errors.load();
+    
+    std::vector<double> merged;
+    for (const auto& per_worker : latencies) {
+        merged.insert(merged.end(), per_worker.begin(), per_worker.end());
+    }
+    SummarizeLatencies(std::move(merged), options.slo_ms, &result);
+    return result;
+}
+
+// 运行一种配置并统计进程CPU利用率（std::clock为进程所有线程的CPU时间）
+LoadResult RunLoadConfiguration(LoadTarget* target, int clients, double qps, const LoadOptions& options) {
+    const std::clock_t cpu_start = std::clock();
+    LoadResult result = options.mode == "open" ? RunOpenLoop(target, qps, clients, options)
+                                               : RunClosedLoop(target, clients, options);
+    const double cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    const double hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    result.cpu_utilization = result.wall_s > 0 ? 100.0 * cpu_s / (result.wall_s * hardware_threads) : 0.0;
+    return result;
+}
+
+void PrintLoadResults(const std::vector<LoadResult>& results, const LoadOptions& options) {
+    std::cout << "\n========== Load Test Results ==========" << std::endl;
+    std::cout << "Mode: " << options.mode << ", sessions: " << options.sessions
+              << ", batcher: " << (options.batcher ? "on" : "off")
+              << ", duration: " << options.duration_s << " s" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(8) << "Clients" << std::setw(11) << "Target QPS" << std::setw(12) << "Throughput"
+              << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms"
+              << std::setw(11) << "p99.9 ms" << std::setw(10) << "max ms" << std::setw(8) << "Errors"
+              << std::setw(8) << "CPU %";
+    if (options.slo_ms > 0) {
+        std::cout << std::setw(10) << "In SLO %";
+    }
     std::cout << std::endl;
+    for (const auto& r : results) {
+        std::cout << std::setw(8) << r.clients;
+        if (r.mode == "open") {
+            std::cout << std::setw(11) << r.target_qps;
+        } else {
+            std::cout << std::setw(11) << "-";
+        }
+        std::cout << std::setw(12) << r.throughput << std::setw(10) << r.p50_ms << std::setw(10) << r.p90_ms
+                  << std::setw(10) << r.p99_ms << std::setw(11) << r.p999_ms << std::setw(10) << r.max_ms
+                  << std::setw(8) << r.errors << std::setw(8) << r.cpu_utilization;
+        if (options.slo_ms > 0) {
+            std::cout << std::setw(10) << r.slo_attainment;
+        }
+        std::cout << std::endl;
+    }
     
-    // 创建会话
+    // 满足SLO（p99不超过SLO且无错误）的配置中吞吐量最高的一个
+    if (options.slo_ms > 0) {
+        const LoadResult* best = nullptr;
+        for (const auto& r : results) {
+            if (r.errors == 0 && r.completed > 0 && r.p99_ms <= options.slo_ms &&
+                (!best || r.throughput > best->throughput)) {
+                best = &r;
+            }
+        }
+        if (best) {
+            std::cout << "Max throughput with p99 <= " << options.slo_ms << " ms: " << best->throughput
+                      << " req/s (" << best->clients << " clients"
+                      << (best->mode == "open" ? ", " + std::to_string(best->target_qps) + " QPS" : std::string())
+                      << ")" << std::endl;
+        } else {
+            std::cout << "No configuration met p99 <= " << options.slo_ms << " ms" << std::endl;
+        }
+    }
+    std::cout << "=======================================" << std::endl;
+}
+
+void SaveLoadResults(const std::vector<LoadResult>& results, const LoadOptions& options) {
+    std::ofstream file(options.output_csv);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open output file: " << options.output_csv << std::endl;
+        return;
+    }
+    file << "Mode,Sessions,Batcher,Clients,Target QPS,Completed,Errors,Throughput (req/s),"
+         << "Mean (ms),P50 (ms),P90 (ms),P99 (ms),P99.9 (ms),Max (ms),CPU (%),In SLO (%)\n";
+    for (const auto& r : results) {
+        file << r.mode << "," << options.sessions << "," << (options.batcher ? 1 : 0) << ","
+             << r.clients << "," << r.target_qps << "," << r.completed << "," << r.errors << ","
+             << r.throughput << "," << r.mean_ms << "," << r.p50_ms << "," << r.p90_ms << ","
+             << r.p99_ms << "," << r.p999_ms << "," << r.max_ms << "," << r.cpu_utilization << ","
+             << r.slo_attainment << "\n";
+    }
+    std::cout << "Results saved to: " << options.output_csv << std::endl;
+}
+
+template <typename T>
+std::vector<T> ParseList(const std::string& text) {
+    std::vector<T> values;
+    std::istringstream iss(text);
+    std::string token;
+    while (std::getline(iss, token, ',')) {
+        if (!token.empty()) {
+            std::istringstream value(token);
+            T parsed{};
+            value >> parsed;
+            values.push_back(parsed);
+        }
+    }
+    return values;
+}
+
+std::unique_ptr<InferenceSession> CreateBenchmarkSession(const std::string& model_path) {
     SessionOptions options;
     options.execution_providers = {"CPUExecutionProvider"};
     options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::ALL;
@@ -144,13 +453,99 @@ int main(int argc, char* argv[]) {
     auto session = InferenceSession::Create(options);
     if (!session) {
         std::cerr << "Failed to create inference session" << std::endl;
-        return 1;
+        return nullptr;
     }
-    
-    // 加载模型
     auto status = session->LoadModel(model_path);
     if (!status.IsOk()) {
         std::cerr << "Failed to load model: " << status.Message() << std::endl;
+        return nullptr;
+    }
+    return session;
+}
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <model_path> [warmup_iterations] [test_iterations] [load options]"
+              << std::endl;
+    std::cerr << "\nLoad options:" << std::endl;
+    std::cerr << "  --load closed|open   Concurrent load instead of sequential latency" << std::endl;
+    std::cerr << "  --clients N[,N...]   Closed-loop clients / open-loop workers (default: 1)" << std::endl;
+    std::cerr << "  --qps X[,X...]       Open-loop Poisson arrival rates (required for open)" << std::endl;
+    std::cerr << "  --duration S         Seconds per configuration (default: 10)" << std::endl;
+    std::cerr << "  --sessions N         Session pool size, 1 = one shared session (default: 1)" << std::endl;
+    std::cerr << "  --batcher            Submit through a DynamicBatcher per session" << std::endl;
+    std::cerr << "  --max-batch N        Batcher max batch size (default: 8)" << std::endl;
+    std::cerr << "  --max-delay-us N     Batcher max queue delay (default: 1000)" << std::endl;
+    std::cerr << "  --slo-ms X           Latency SLO for attainment and best-throughput report" << std::endl;
+    std::cerr << "  --csv FILE           Write per-configuration results as CSV" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // 选项可以出现在任意位置，其余为位置参数
+    std::vector<std::string> args;
+    LoadOptions load;
+    load.batcher_options.max_batch_size = 8;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--batcher") {
+            load.batcher = true;
+        } else if (arg == "--load" && has_value) {
+            load.mode = argv[++i];
+        } else if (arg == "--clients" && has_value) {
+            load.clients = ParseList<int>(argv[++i]);
+        } else if (arg == "--qps" && has_value) {
+            load.qps = ParseList<double>(argv[++i]);
+        } else if (arg == "--duration" && has_value) {
+            load.duration_s = std::stod(argv[++i]);
+        } else if (arg == "--sessions" && has_value) {
+            load.sessions = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--max-batch" && has_value) {
+            load.batcher_options.max_batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--max-delay-us" && has_value) {
+            load.batcher_options.max_delay_us = std::stoll(argv[++i]);
+        } else if (arg == "--slo-ms" && has_value) {
+            load.slo_ms = std::stod(argv[++i]);
+        } else if (arg == "--csv" && has_value) {
+            load.output_csv = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (!load.mode.empty() && load.mode != "closed" && load.mode != "open") {
+        std::cerr << "--load must be closed or open" << std::endl;
+        return 1;
+    }
+    if (load.mode == "open" && load.qps.empty()) {
+        std::cerr << "--load open requires --qps" << std::endl;
+        return 1;
+    }
+    if (load.clients.empty()) {
+        load.clients = {1};
+    }
+    
+    std::string model_path = args[0];
+    int warmup_iterations = (args.size() > 1) ? std::stoi(args[1]) : 10;
+    int test_iterations = (args.size() > 2) ? std::stoi(args[2]) : 100;
+    
+    std::cout << "InferUnity Benchmark Tool" << std::endl;
+    std::cout << "Model: " << model_path << std::endl;
+    std::cout << "Warmup iterations: " << warmup_iterations << std::endl;
+    if (load.mode.empty()) {
+        std::cout << "Test iterations: " << test_iterations << std::endl;
+    }
+    std::cout << std::endl;
+    
+    // 创建会话并加载模型
+    auto session = CreateBenchmarkSession(model_path);
+    if (!session) {
         return 1;
     }
     
@@ -186,12 +581,57 @@ int main(int argc, char* argv[]) {
         inputs.push_back(tensor);
     }
     
-    // 运行基准测试
-    BenchmarkResult result = RunBenchmark(session.get(), inputs, warmup_iterations, test_iterations);
+    if (load.mode.empty()) {
+        // 运行基准测试
+        BenchmarkResult result = RunBenchmark(session.get(), inputs, warmup_iterations, test_iterations);
+        
+        // 打印结果
+        PrintResults(result);
+        return 0;
+    }
     
-    // 打印结果
-    PrintResults(result);
+    // 会话池：每个会话各自预热
+    std::vector<std::unique_ptr<InferenceSession>> sessions;
+    sessions.push_back(std::move(session));
+    while (static_cast<int>(sessions.size()) < load.sessions) {
+        auto extra = CreateBenchmarkSession(model_path);
+        if (!extra) {
+            return 1;
+        }
+        sessions.push_back(std::move(extra));
+    }
+    std::vector<Tensor*> input_ptrs;
+    for (auto& tensor : inputs) {
+        input_ptrs.push_back(tensor.get());
+    }
+    for (auto& pooled : sessions) {
+        for (int i = 0; i < warmup_iterations; ++i) {
+            std::vector<std::shared_ptr<Tensor>> outputs;
+            auto status = pooled->Run(input_ptrs, outputs);
+            if (!status.IsOk()) {
+                std::cerr << "Warmup failed: " << status.Message() << std::endl;
+                return 1;
+            }
+        }
+    }
     
+    LoadTarget target(std::move(sessions), inputs, load.batcher, load.batcher_options);
+    std::vector<LoadResult> results;
+    const std::vector<double> rates = load.mode == "open" ? load.qps : std::vector<double>{0.0};
+    for (int clients : load.clients) {
+        for (double qps : rates) {
+            std::cout << "Running " << load.mode << " loop: " << clients << " clients";
+            if (load.mode == "open") {
+                std::cout << ", " << qps << " QPS";
+            }
+            std::cout << " (" << load.duration_s << " s)..." << std::endl;
+            results.push_back(RunLoadConfiguration(&target, std::max(clients, 1), qps, load));
+        }
+    }
+    
+    PrintLoadResults(results, load);
+    if (!load.output_csv.empty()) {
+        SaveLoadResults(results, load);
+    }
     return 0;
 }
-
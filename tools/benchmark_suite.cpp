@@ -1,7 +1,12 @@
 // 基准测试套件
-// 参考ONNX Runtime的benchmark实现
+// 参考ONNX Runtime的benchmark实现与Google Benchmark/criterion的统计方法：
+// 迭代次数自适应（直到均值95%置信区间的相对半宽低于目标或达到上限），按中位数绝对偏差剔除离群值，
+// 报告p50/p90/p99/p99.9分位数；对比模式用Mann-Whitney U检验判断与基线的差异是否显著。
+// 结果为JSON或CSV（按输出文件扩展名），两者都保存原始样本，可直接作为下次对比的基线
 
 #include "inferunity/engine.h"
+#include "inferunity/graph.h"
+#include "inferunity/model_zoo.h"
 #include "inferunity/tensor.h"
 #include "inferunity/memory.h"
 #include <iostream>
@@ -13,39 +18,354 @@
 #include <chrono>
 #include <cmath>
 #include <algorithm>
+#include <numeric>
 #include <sstream>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 using namespace inferunity;
 using namespace std::chrono;
 
+// 测量控制
+struct HarnessOptions {
+    int warmup_iterations = 10;
+    int min_iterations = 20;
+    int max_iterations = 1000;
+    double max_time_s = 10.0;          // 单个模型的测量时间上限
+    double target_ci = 0.01;           // 目标：95%置信区间半宽 / 均值
+    double outlier_threshold = 3.5;    // 修正z分数（0.6745 × |x - 中位数| / MAD）超过它的样本剔除
+    bool cold_cache = false;           // 每次运行前写一遍大于末级缓存的缓冲，冲掉权重与激活
+    size_t flush_bytes = 128u << 20;
+    int threads = 0;                   // 线程池线程数，0为默认
+    bool pin_threads = false;          // 工作线程绑核
+    int pin_main_cpu = -1;             // 调用Run的线程绑定到该CPU，-1为不绑定
+    std::string governor;              // 非空时尝试把各CPU的cpufreq调速器设为它（需要root）
+    double alpha = 0.05;               // 显著性水平
+    double max_slowdown = 1.02;        // 中位数变慢超过它且显著时判为退化
+    double max_memory_increase = 1.2;
+};
+
+// 剔除离群值后的样本统计
+struct SampleStats {
+    size_t count = 0;
+    size_t outliers = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double ci95 = 0.0;  // 均值95%置信区间的半宽
+    
+    double GetRelativeCi() const { return mean > 0 ? ci95 / mean : 0.0; }
+};
+
 struct ModelBenchmark {
     std::string model_name;
     std::string model_path;
     std::vector<Shape> input_shapes;
     std::vector<Shape> output_shapes;
-    double avg_time_ms;
-    double min_time_ms;
-    double max_time_ms;
-    double throughput;
-    size_t memory_used_mb;
-    bool success;
+    std::vector<double> samples_ms;  // 全部测量样本（含离群值），对比时使用
+    SampleStats stats;
+    double throughput = 0.0;
+    double memory_used_mb = 0.0;
+    // 一次Profile运行的逐节点结果与屋顶线汇总：达到的GFLOP/s，
+    // 以及以峰值算力与带宽执行全部节点的最短耗时占实测节点耗时的比例
+    ProfilingResult profile;
+    double gflops = 0.0;
+    double roofline_efficiency = 0.0;
+    bool success = false;
     std::string error_message;
 };
 
 struct ComparisonResult {
     std::string model_name;
-    double baseline_time_ms;
-    double current_time_ms;
-    double speedup;
-    double memory_baseline_mb;
-    double memory_current_mb;
-    double memory_change_percent;
+    double baseline_p50_ms = 0.0;
+    double current_p50_ms = 0.0;
+    double change_percent = 0.0;  // 中位数的变化，正数为变慢
+    double p_value = 1.0;         // 没有基线样本时为1
+    bool has_samples = false;
+    double memory_baseline_mb = 0.0;
+    double memory_current_mb = 0.0;
+    double memory_change_percent = 0.0;
+};
+
+// 测量环境（写入JSON结果）
+struct HarnessEnvironment {
+    size_t threads = 0;
+    bool pin_threads = false;
+    int pin_main_cpu = -1;
+    std::string governor;
+    std::string turbo;
+    double cpu_mhz = 0.0;
+    bool cold_cache = false;
 };
 
+// ---------------- 统计 ----------------
+
+// 线性插值分位数（Hyndman-Fan第7种），sorted须升序
+double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double position = p * static_cast<double>(sorted.size() - 1);
+    const size_t lower = static_cast<size_t>(position);
+    const size_t upper = std::min(lower + 1, sorted.size() - 1);
+    const double fraction = position - static_cast<double>(lower);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+// 双侧95%的t分布临界值
+double TCritical95(size_t degrees) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (degrees == 0) {
+        return 0.0;
+    }
+    if (degrees <= 30) {
+        return table[degrees - 1];
+    }
+    return 1.960 + 2.4 / static_cast<double>(degrees);
+}
+
+// 按修正z分数剔除离群值（Iglewicz-Hoaglin），MAD为0时全部保留
+std::vector<double> RejectOutliers(const std::vector<double>& samples, double threshold, size_t* rejected) {
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double median = Percentile(sorted, 0.5);
+    std::vector<double> deviations;
+    deviations.reserve(sorted.size());
+    for (double x : sorted) {
+        deviations.push_back(std::fabs(x - median));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    const double mad = Percentile(deviations, 0.5);
+    
+    std::vector<double> kept;
+    kept.reserve(sorted.size());
+    for (double x : sorted) {
+        if (mad <= 0.0 || 0.6745 * std::fabs(x - median) / mad <= threshold) {
+            kept.push_back(x);
+        }
+    }
+    *rejected = sorted.size() - kept.size();
+    return kept;
+}
+
+SampleStats ComputeStats(const std::vector<double>& samples, double outlier_threshold) {
+    SampleStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+    const std::vector<double> kept = RejectOutliers(samples, outlier_threshold, &stats.outliers);
+    stats.count = kept.size();
+    stats.min = kept.front();
+    stats.max = kept.back();
+    stats.mean = std::accumulate(kept.begin(), kept.end(), 0.0) / static_cast<double>(kept.size());
+    double squares = 0.0;
+    for (double x : kept) {
+        squares += (x - stats.mean) * (x - stats.mean);
+    }
+    stats.stddev = kept.size() > 1 ? std::sqrt(squares / static_cast<double>(kept.size() - 1)) : 0.0;
+    stats.ci95 = kept.size() > 1 ?
+        TCritical95(kept.size() - 1) * stats.stddev / std::sqrt(static_cast<double>(kept.size())) : 0.0;
+    stats.p50 = Percentile(kept, 0.5);
+    stats.p90 = Percentile(kept, 0.9);
+    stats.p99 = Percentile(kept, 0.99);
+    stats.p999 = Percentile(kept, 0.999);
+    return stats;
+}
+
+// Mann-Whitney U检验的双侧p值（正态近似，含并列校正与连续性校正）；
+// 不假设延迟服从正态分布，对长尾与少量离群值稳健
+double MannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b) {
+    const size_t n1 = a.size();
+    const size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+    std::vector<std::pair<double, int>> pooled;
+    pooled.reserve(n1 + n2);
+    for (double x : a) pooled.emplace_back(x, 0);
+    for (double x : b) pooled.emplace_back(x, 1);
+    std::sort(pooled.begin(), pooled.end());
+    
+    const double n = static_cast<double>(n1 + n2);
+    double rank_sum_a = 0.0;
+    double tie_term = 0.0;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) {
+            ++j;
+        }
+        // 秩从1开始，并列的样本取平均秩
+        const double average_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+        for (size_t k = i; k < j; ++k) {
+            if (pooled[k].second == 0) {
+                rank_sum_a += average_rank;
+            }
+        }
+        const double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+    const double u = rank_sum_a - static_cast<double>(n1) * static_cast<double>(n1 + 1) / 2.0;
+    const double mu = static_cast<double>(n1) * static_cast<double>(n2) / 2.0;
+    const double variance = static_cast<double>(n1) * static_cast<double>(n2) / 12.0 *
+                            ((n + 1.0) - tie_term / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    const double z = std::max(std::fabs(u - mu) - 0.5, 0.0) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+// ---------------- 测量环境 ----------------
+
+std::string ReadFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int CountCpus() {
+    int count = 0;
+    while (std::ifstream("/sys/devices/system/cpu/cpu" + std::to_string(count) + "/online").good() ||
+           std::ifstream("/sys/devices/system/cpu/cpu" + std::to_string(count) + "/cpufreq/scaling_governor").good()) {
+        ++count;
+    }
+    return count;
+}
+
+// 把各CPU的调速器设为governor（如performance），返回成功设置的CPU数
+int SetGovernor(const std::string& governor) {
+    int changed = 0;
+    const int cpus = std::max(CountCpus(), 1);
+    for (int cpu = 0; cpu < cpus; ++cpu) {
+        std::ofstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor");
+        if (file && (file << governor) && file.flush()) {
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+// 绑定调用线程到cpu（仅Linux）
+bool PinCurrentThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// 应用线程、绑核与调速器设置，并记录测量环境；调速器不是performance时频率波动会放大方差
+HarnessEnvironment PrepareEnvironment(const HarnessOptions& options) {
+    if (options.threads > 0 || options.pin_threads) {
+        ThreadPoolOptions pool;
+        pool.num_threads = static_cast<size_t>(std::max(options.threads, 0));
+        pool.pin_threads = options.pin_threads;
+        ThreadPool::Configure(pool);
+    }
+    if (options.pin_main_cpu >= 0 && !PinCurrentThread(options.pin_main_cpu)) {
+        std::cerr << "Warning: failed to pin the benchmark thread to CPU " << options.pin_main_cpu << std::endl;
+    }
+    if (!options.governor.empty() && SetGovernor(options.governor) == 0) {
+        std::cerr << "Warning: failed to set cpufreq governor to " << options.governor
+                  << " (requires root)" << std::endl;
+    }
+    
+    HarnessEnvironment env;
+    env.threads = ThreadPool::GetThreadCount();
+    env.pin_threads = options.pin_threads;
+    env.pin_main_cpu = options.pin_main_cpu;
+    env.cold_cache = options.cold_cache;
+    env.governor = ReadFirstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    const std::string no_turbo = ReadFirstLine("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    const std::string boost = ReadFirstLine("/sys/devices/system/cpu/cpufreq/boost");
+    if (!no_turbo.empty()) {
+        env.turbo = no_turbo == "1" ? "off" : "on";
+    } else if (!boost.empty()) {
+        env.turbo = boost == "1" ? "on" : "off";
+    }
+    const std::string khz = ReadFirstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    env.cpu_mhz = khz.empty() ? 0.0 : std::atof(khz.c_str()) / 1000.0;
+    if (!env.governor.empty() && env.governor != "performance") {
+        std::cerr << "Warning: cpufreq governor is '" << env.governor
+                  << "'; use --governor performance for stable results" << std::endl;
+    }
+    return env;
+}
+
+// ---------------- 测量 ----------------
+
+// 逐节点的解析代价（Operator::EstimateCost）对照屋顶线，汇总到result
+void ComputeRoofline(const RooflinePeaks& peaks, ModelBenchmark* result) {
+    double node_ms = 0.0;
+    double roofline_ms = 0.0;
+    double flops = 0.0;
+    for (const auto& node : result->profile.node_profiles) {
+        node_ms += node.execution_time_ms;
+        roofline_ms += peaks.GetRooflineTimeMs(node.estimated_flops, static_cast<double>(node.estimated_bytes));
+        flops += node.estimated_flops;
+    }
+    result->gflops = node_ms > 0 ? flops / node_ms / 1e6 : 0.0;
+    result->roofline_efficiency = node_ms > 0 ? roofline_ms / node_ms * 100.0 : 0.0;
+}
+
+// 打印耗时最多的top_n个节点的屋顶线效率
+void PrintNodeEfficiency(const ModelBenchmark& result, const RooflinePeaks& peaks, size_t top_n = 10) {
+    std::vector<ProfilingResult::NodeProfile> nodes = result.profile.node_profiles;
+    std::sort(nodes.begin(), nodes.end(),
+              [](const ProfilingResult::NodeProfile& a, const ProfilingResult::NodeProfile& b) {
+                  return a.execution_time_ms > b.execution_time_ms;
+              });
+    nodes.resize(std::min(nodes.size(), top_n));
+    
+    std::cout << "  " << std::setw(30) << "Node"
+              << std::setw(20) << "Op Type"
+              << std::setw(12) << "Time (ms)"
+              << std::setw(12) << "GFLOP/s"
+              << std::setw(12) << "FLOP/byte"
+              << std::setw(10) << "% Roof" << std::endl;
+    for (const auto& node : nodes) {
+        const double bytes = static_cast<double>(node.estimated_bytes);
+        const double roofline_ms = peaks.GetRooflineTimeMs(node.estimated_flops, bytes);
+        const double ms = node.execution_time_ms;
+        std::cout << "  " << std::setw(30) << node.node_name
+                  << std::setw(20) << node.op_type
+                  << std::setw(12) << ms
+                  << std::setw(12) << (ms > 0 ? node.estimated_flops / ms / 1e6 : 0.0)
+                  << std::setw(12) << (bytes > 0 ? node.estimated_flops / bytes : 0.0)
+                  << std::setw(9) << (ms > 0 ? roofline_ms / ms * 100.0 : 0.0) << "%" << std::endl;
+    }
+}
+
+// 冷缓存模式：每次运行前写读一遍flush缓冲，把模型的权重与激活挤出各级缓存
+void FlushCaches(std::vector<char>* buffer) {
+    volatile char sink = 0;
+    for (size_t i = 0; i < buffer->size(); i += 64) {
+        (*buffer)[i] = static_cast<char>((*buffer)[i] + 1);
+        sink = sink + (*buffer)[i];
+    }
+    (void)sink;
+}
+
 // 运行单个模型基准测试
-ModelBenchmark RunModelBenchmark(const std::string& model_path, 
-                                int warmup_iterations = 10,
-                                int test_iterations = 100) {
+ModelBenchmark RunModelBenchmark(const std::string& model_path,
+                                 const HarnessOptions& harness,
+                                 const RooflinePeaks& peaks = RooflinePeaks()) {
     ModelBenchmark result;
     result.model_name = model_path;
     result.model_path = model_path;
@@ -63,8 +383,26 @@ ModelBenchmark RunModelBenchmark(const std::string& model_path,
             return result;
         }
         
-        // 加载模型
-        auto status = session->LoadModel(model_path);
+        // 加载模型；"zoo:"前缀的条目由基准模型库生成，图输入带有合法的示例输入
+        std::vector<std::shared_ptr<Tensor>> zoo_inputs;
+        Status status;
+        if (model_path.compare(0, 4, "zoo:") == 0) {
+            std::string zoo_name;
+            ZooModelOptions zoo_options;
+            std::unique_ptr<Graph> graph;
+            status = ParseZooModelSpec(model_path.substr(4), &zoo_name, &zoo_options);
+            if (status.IsOk()) {
+                status = BuildZooModel(zoo_name, zoo_options, &graph);
+            }
+            if (status.IsOk()) {
+                for (Value* input : graph->GetInputs()) {
+                    zoo_inputs.push_back(input->GetTensor());
+                }
+                status = session->LoadModelFromGraph(std::move(graph));
+            }
+        } else {
+            status = session->LoadModel(model_path);
+        }
         if (!status.IsOk()) {
             result.error_message = "Failed to load model: " + status.Message();
             return result;
@@ -78,7 +416,12 @@ ModelBenchmark RunModelBenchmark(const std::string& model_path,
         std::vector<std::shared_ptr<Tensor>> inputs;
         std::vector<Tensor*> input_ptrs;
         
-        for (const auto& shape : result.input_shapes) {
+        for (const auto& tensor : zoo_inputs) {
+            inputs.push_back(tensor);
+            input_ptrs.push_back(tensor.get());
+        }
+        for (size_t i = zoo_inputs.size(); i < result.input_shapes.size(); ++i) {
+            const Shape& shape = result.input_shapes[i];
             auto tensor = CreateTensor(shape, DataType::FLOAT32, DeviceType::CPU);
             if (!tensor) {
                 result.error_message = "Failed to create input tensor";
@@ -98,50 +441,59 @@ ModelBenchmark RunModelBenchmark(const std::string& model_path,
         
         // Warmup
         std::vector<Tensor*> outputs;
-        for (int i = 0; i < warmup_iterations; ++i) {
+        for (int i = 0; i < harness.warmup_iterations; ++i) {
             session->Run(input_ptrs, outputs);
         }
         
         // 获取初始内存
         MemoryStats initial_stats = GetMemoryStats(DeviceType::CPU);
         
-        // 运行测试
-        std::vector<double> times;
-        times.reserve(test_iterations);
-        
-        for (int i = 0; i < test_iterations; ++i) {
-            auto start = high_resolution_clock::now();
+        // 自适应迭代：至少min_iterations次，之后每次检查剔除离群值后的置信区间，
+        // 足够窄、达到max_iterations或超出max_time_s时停止
+        std::vector<char> flush_buffer(harness.cold_cache ? harness.flush_bytes : 0);
+        const auto deadline = steady_clock::now() + duration<double>(harness.max_time_s);
+        while (static_cast<int>(result.samples_ms.size()) < harness.max_iterations) {
+            if (harness.cold_cache) {
+                FlushCaches(&flush_buffer);
+            }
+            auto start = steady_clock::now();
             status = session->Run(input_ptrs, outputs);
-            auto end = high_resolution_clock::now();
+            auto end = steady_clock::now();
             
             if (!status.IsOk()) {
                 result.error_message = "Run failed: " + status.Message();
                 return result;
             }
+            result.samples_ms.push_back(duration<double, std::milli>(end - start).count());
             
-            auto duration = duration_cast<microseconds>(end - start);
-            times.push_back(duration.count() / 1000.0);
+            if (static_cast<int>(result.samples_ms.size()) < harness.min_iterations) {
+                continue;
+            }
+            if (end >= deadline) {
+                break;
+            }
+            const SampleStats stats = ComputeStats(result.samples_ms, harness.outlier_threshold);
+            if (stats.count > 1 && stats.GetRelativeCi() <= harness.target_ci) {
+                break;
+            }
         }
         
         // 获取最终内存
         MemoryStats final_stats = GetMemoryStats(DeviceType::CPU);
         
         // 计算统计信息
-        double sum = 0.0;
-        result.min_time_ms = times[0];
-        result.max_time_ms = times[0];
+        result.stats = ComputeStats(result.samples_ms, harness.outlier_threshold);
+        result.throughput = result.stats.mean > 0 ? 1000.0 / result.stats.mean : 0.0;
+        result.memory_used_mb = final_stats.peak_allocated_bytes > initial_stats.allocated_bytes ?
+            (final_stats.peak_allocated_bytes - initial_stats.allocated_bytes) / 1024.0 / 1024.0 : 0.0;
         
-        for (double time : times) {
-            sum += time;
-            if (time < result.min_time_ms) result.min_time_ms = time;
-            if (time > result.max_time_ms) result.max_time_ms = time;
+        // 逐节点耗时（一次Profile运行）用于屋顶线效率
+        status = session->Profile(result.profile);
+        if (status.IsOk()) {
+            ComputeRoofline(peaks, &result);
         }
-        
-        result.avg_time_ms = sum / test_iterations;
-        result.throughput = 1000.0 / result.avg_time_ms;
-        result.memory_used_mb = (final_stats.peak_allocated_bytes - initial_stats.allocated_bytes) / 1024.0 / 1024.0;
         result.success = true;
-        
+    
     } catch (const std::exception& e) {
         result.error_message = std::string("Exception: ") + e.what();
     }
@@ -176,71 +528,205 @@ std::vector<std::string> LoadModelList(const std::string& list_file) {
     return models;
 }
 
-// 保存基准测试结果
-void SaveBenchmarkResults(const std::vector<ModelBenchmark>& results, 
-                         const std::string& output_file) {
+// ---------------- 结果输出 ----------------
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void SaveJson(const std::vector<ModelBenchmark>& results, const HarnessEnvironment& env,
+              const RooflinePeaks& peaks, std::ostream& out) {
+    out << std::setprecision(9);
+    out << "{\n  \"environment\": {\"threads\": " << env.threads
+        << ", \"pin_threads\": " << (env.pin_threads ? "true" : "false")
+        << ", \"pin_main_cpu\": " << env.pin_main_cpu
+        << ", \"governor\": \"" << JsonEscape(env.governor) << "\""
+        << ", \"turbo\": \"" << env.turbo << "\""
+        << ", \"cpu_mhz\": " << env.cpu_mhz
+        << ", \"cache\": \"" << (env.cold_cache ? "cold" : "warm") << "\""
+        << ", \"peak_gflops\": " << peaks.peak_gflops
+        << ", \"peak_gbps\": " << peaks.peak_gbps << "},\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ModelBenchmark& r = results[i];
+        const SampleStats& s = r.stats;
+        out << (i ? ",\n" : "\n") << "    {\"model\": \"" << JsonEscape(r.model_name) << "\""
+            << ", \"success\": " << (r.success ? "true" : "false");
+        if (!r.success) {
+            out << ", \"error\": \"" << JsonEscape(r.error_message) << "\"}";
+            continue;
+        }
+        out << ", \"iterations\": " << r.samples_ms.size() << ", \"outliers\": " << s.outliers
+            << ", \"mean_ms\": " << s.mean << ", \"stddev_ms\": " << s.stddev << ", \"ci95_ms\": " << s.ci95
+            << ", \"min_ms\": " << s.min << ", \"p50_ms\": " << s.p50 << ", \"p90_ms\": " << s.p90
+            << ", \"p99_ms\": " << s.p99 << ", \"p999_ms\": " << s.p999 << ", \"max_ms\": " << s.max
+            << ", \"throughput\": " << r.throughput << ", \"memory_mb\": " << r.memory_used_mb
+            << ", \"gflops\": " << r.gflops << ", \"roofline_efficiency\": " << r.roofline_efficiency
+            << ", \"samples_ms\": [";
+        for (size_t j = 0; j < r.samples_ms.size(); ++j) {
+            out << (j ? ", " : "") << r.samples_ms[j];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void SaveCsv(const std::vector<ModelBenchmark>& results, std::ostream& out) {
+    out << "Model,Iterations,Outliers,Mean (ms),Stddev (ms),CI95 (ms),Min (ms),P50 (ms),P90 (ms),P99 (ms),"
+        << "P99.9 (ms),Max (ms),Throughput (inferences/sec),Memory (MB),GFLOP/s,Roofline Efficiency (%),"
+        << "Status,Samples (ms)\n";
+    out << std::setprecision(9);
+    for (const auto& r : results) {
+        const SampleStats& s = r.stats;
+        out << r.model_name << "," << r.samples_ms.size() << "," << s.outliers << ","
+            << s.mean << "," << s.stddev << "," << s.ci95 << "," << s.min << ","
+            << s.p50 << "," << s.p90 << "," << s.p99 << "," << s.p999 << "," << s.max << ","
+            << r.throughput << "," << r.memory_used_mb << "," << r.gflops << "," << r.roofline_efficiency << ","
+            << (r.success ? "SUCCESS" : "FAILED") << ",";
+        for (size_t j = 0; j < r.samples_ms.size(); ++j) {
+            out << (j ? ";" : "") << r.samples_ms[j];
+        }
+        out << "\n";
+    }
+}
+
+// 保存基准测试结果：.json为JSON，其余为CSV
+void SaveBenchmarkResults(const std::vector<ModelBenchmark>& results, const HarnessEnvironment& env,
+                          const RooflinePeaks& peaks, const std::string& output_file) {
     std::ofstream file(output_file);
     if (!file.is_open()) {
         std::cerr << "Failed to open output file: " << output_file << std::endl;
         return;
     }
-    
-    // CSV格式
-    file << "Model,Avg Time (ms),Min Time (ms),Max Time (ms),Throughput (inferences/sec),Memory (MB),Status\n";
-    
-    for (const auto& result : results) {
-        file << result.model_name << ","
-             << result.avg_time_ms << ","
-             << result.min_time_ms << ","
-             << result.max_time_ms << ","
-             << result.throughput << ","
-             << result.memory_used_mb << ","
-             << (result.success ? "SUCCESS" : "FAILED") << "\n";
+    if (EndsWith(output_file, ".json")) {
+        SaveJson(results, env, peaks, file);
+    } else {
+        SaveCsv(results, file);
     }
-    
     file.close();
     std::cout << "Results saved to: " << output_file << std::endl;
 }
 
-// 加载基准结果（用于对比）
-std::map<std::string, ModelBenchmark> LoadBaselineResults(const std::string& baseline_file) {
-    std::map<std::string, ModelBenchmark> baseline;
-    std::ifstream file(baseline_file);
-    
-    if (!file.is_open()) {
-        return baseline;
+// ---------------- 基线读取 ----------------
+
+std::vector<double> ParseNumbers(const std::string& text, char separator) {
+    std::vector<double> values;
+    std::istringstream iss(text);
+    std::string token;
+    while (std::getline(iss, token, separator)) {
+        if (token.find_first_not_of(" \t\n[]") != std::string::npos) {
+            values.push_back(std::atof(token.c_str()));
+        }
     }
-    
+    return values;
+}
+
+// 读取本工具写出的JSON：每个结果对象的model、memory_mb与samples_ms
+void LoadJsonBaseline(const std::string& text, std::map<std::string, ModelBenchmark>* baseline) {
+    const std::string model_key = "\"model\": \"";
+    size_t pos = text.find(model_key);
+    while (pos != std::string::npos) {
+        const size_t name_begin = pos + model_key.size();
+        const size_t name_end = text.find('"', name_begin);
+        const size_t next = text.find(model_key, name_end);
+        const std::string object = text.substr(name_end, next == std::string::npos ? std::string::npos : next - name_end);
+        
+        ModelBenchmark result;
+        result.model_name = text.substr(name_begin, name_end - name_begin);
+        result.success = object.find("\"success\": true") != std::string::npos;
+        const size_t memory = object.find("\"memory_mb\": ");
+        if (memory != std::string::npos) {
+            result.memory_used_mb = std::atof(object.c_str() + memory + 13);
+        }
+        const size_t samples = object.find("\"samples_ms\": [");
+        if (samples != std::string::npos) {
+            const size_t begin = samples + 15;
+            result.samples_ms = ParseNumbers(object.substr(begin, object.find(']', begin) - begin), ',');
+        }
+        if (result.success) {
+            (*baseline)[result.model_name] = result;
+        }
+        pos = next;
+    }
+}
+
+// 按表头读取CSV；只有旧格式的平均耗时（无样本）时以它作为中位数，不做显著性检验
+void LoadCsvBaseline(std::istream& file, std::map<std::string, ModelBenchmark>* baseline) {
     std::string line;
-    std::getline(file, line);  // 跳过头部
+    std::getline(file, line);
+    std::map<std::string, size_t> columns;
+    {
+        std::istringstream header(line);
+        std::string name;
+        for (size_t i = 0; std::getline(header, name, ','); ++i) {
+            columns[name] = i;
+        }
+    }
+    auto column = [&columns](const std::vector<std::string>& fields, const std::string& name) {
+        auto it = columns.find(name);
+        return it != columns.end() && it->second < fields.size() ? fields[it->second] : std::string();
+    };
     
     while (std::getline(file, line)) {
+        std::vector<std::string> fields;
         std::istringstream iss(line);
         std::string token;
+        while (std::getline(iss, token, ',')) {
+            fields.push_back(token);
+        }
         ModelBenchmark result;
-        
-        std::getline(iss, result.model_name, ',');
-        std::getline(iss, token, ',');
-        result.avg_time_ms = std::stod(token);
-        std::getline(iss, token, ',');
-        result.min_time_ms = std::stod(token);
-        std::getline(iss, token, ',');
-        result.max_time_ms = std::stod(token);
-        std::getline(iss, token, ',');
-        result.throughput = std::stod(token);
-        std::getline(iss, token, ',');
-        result.memory_used_mb = std::stod(token);
-        
-        baseline[result.model_name] = result;
+        result.model_name = column(fields, "Model");
+        result.success = column(fields, "Status") != "FAILED";
+        result.memory_used_mb = std::atof(column(fields, "Memory (MB)").c_str());
+        result.samples_ms = ParseNumbers(column(fields, "Samples (ms)"), ';');
+        const std::string p50 = column(fields, "P50 (ms)");
+        result.stats.p50 = std::atof((p50.empty() ? column(fields, "Avg Time (ms)") : p50).c_str());
+        if (!result.model_name.empty() && result.success) {
+            (*baseline)[result.model_name] = result;
+        }
+    }
+}
+
+std::map<std::string, ModelBenchmark> LoadBaselineResults(const std::string& baseline_file,
+                                                          const HarnessOptions& harness) {
+    std::map<std::string, ModelBenchmark> baseline;
+    std::ifstream file(baseline_file);
+    if (!file.is_open()) {
+        std::cerr << "Warning: Cannot open baseline file: " << baseline_file << std::endl;
+        return baseline;
+    }
+    if (EndsWith(baseline_file, ".json")) {
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        LoadJsonBaseline(buffer.str(), &baseline);
+    } else {
+        LoadCsvBaseline(file, &baseline);
+    }
+    for (auto& pair : baseline) {
+        if (!pair.second.samples_ms.empty()) {
+            pair.second.stats = ComputeStats(pair.second.samples_ms, harness.outlier_threshold);
+        }
     }
-    
     return baseline;
 }
 
-// 性能对比
+// ---------------- 对比 ----------------
+
 std::vector<ComparisonResult> CompareResults(
     const std::vector<ModelBenchmark>& current,
-    const std::map<std::string, ModelBenchmark>& baseline) {
+    const std::map<std::string, ModelBenchmark>& baseline,
+    const HarnessOptions& harness) {
     
     std::vector<ComparisonResult> comparisons;
     
@@ -252,14 +738,23 @@ std::vector<ComparisonResult> CompareResults(
         
         ComparisonResult comp;
         comp.model_name = current_result.model_name;
-        comp.baseline_time_ms = it->second.avg_time_ms;
-        comp.current_time_ms = current_result.avg_time_ms;
-        comp.speedup = comp.baseline_time_ms / comp.current_time_ms;
+        comp.baseline_p50_ms = it->second.stats.p50;
+        comp.current_p50_ms = current_result.stats.p50;
+        comp.change_percent = comp.baseline_p50_ms > 0 ?
+            (comp.current_p50_ms - comp.baseline_p50_ms) / comp.baseline_p50_ms * 100.0 : 0.0;
+        comp.has_samples = !it->second.samples_ms.empty();
+        if (comp.has_samples) {
+            // 两侧都先剔除离群值，检验的是主体分布是否移动
+            size_t rejected = 0;
+            comp.p_value = MannWhitneyPValue(
+                RejectOutliers(current_result.samples_ms, harness.outlier_threshold, &rejected),
+                RejectOutliers(it->second.samples_ms, harness.outlier_threshold, &rejected));
+        }
         comp.memory_baseline_mb = it->second.memory_used_mb;
         comp.memory_current_mb = current_result.memory_used_mb;
         
         if (comp.memory_baseline_mb > 0) {
-            comp.memory_change_percent = 
+            comp.memory_change_percent =
                 (comp.memory_current_mb - comp.memory_baseline_mb) / comp.memory_baseline_mb * 100.0;
         } else {
             comp.memory_change_percent = 0.0;
@@ -271,34 +766,55 @@ std::vector<ComparisonResult> CompareResults(
     return comparisons;
 }
 
+// 差异显著（或没有样本可检验）时按中位数变化的方向判定
+const char* Verdict(const ComparisonResult& comp, const HarnessOptions& harness) {
+    if (comp.has_samples && comp.p_value >= harness.alpha) {
+        return "no change";
+    }
+    if (comp.change_percent > (harness.max_slowdown - 1.0) * 100.0) {
+        return "slower";
+    }
+    if (comp.change_percent < -(harness.max_slowdown - 1.0) * 100.0) {
+        return "faster";
+    }
+    return "no change";
+}
+
 // 打印对比结果
-void PrintComparison(const std::vector<ComparisonResult>& comparisons) {
+void PrintComparison(const std::vector<ComparisonResult>& comparisons, const HarnessOptions& harness) {
     std::cout << "\n========== Performance Comparison ==========" << std::endl;
     std::cout << std::fixed << std::setprecision(3);
     
     std::cout << std::setw(30) << "Model"
-              << std::setw(15) << "Baseline (ms)"
-              << std::setw(15) << "Current (ms)"
-              << std::setw(15) << "Speedup"
-              << std::setw(15) << "Memory Δ%" << std::endl;
-    std::cout << std::string(90, '-') << std::endl;
+              << std::setw(15) << "Baseline p50"
+              << std::setw(15) << "Current p50"
+              << std::setw(12) << "Change %"
+              << std::setw(12) << "p-value"
+              << std::setw(12) << "Verdict"
+              << std::setw(15) << "Memory %" << std::endl;
+    std::cout << std::string(111, '-') << std::endl;
     
     for (const auto& comp : comparisons) {
         std::cout << std::setw(30) << comp.model_name
-                  << std::setw(15) << comp.baseline_time_ms
-                  << std::setw(15) << comp.current_time_ms
-                  << std::setw(15) << comp.speedup << "x"
-                  << std::setw(15) << comp.memory_change_percent << "%" << std::endl;
+                  << std::setw(15) << comp.baseline_p50_ms
+                  << std::setw(15) << comp.current_p50_ms
+                  << std::setw(11) << comp.change_percent << "%";
+        if (comp.has_samples) {
+            std::cout << std::setw(12) << std::setprecision(4) << comp.p_value << std::setprecision(3);
+        } else {
+            std::cout << std::setw(12) << "n/a";
+        }
+        std::cout << std::setw(12) << Verdict(comp, harness)
+                  << std::setw(14) << comp.memory_change_percent << "%" << std::endl;
     }
     
-    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::string(111, '-') << std::endl;
+    std::cout << "Mann-Whitney U test, alpha " << harness.alpha << ", threshold "
+              << (harness.max_slowdown - 1.0) * 100.0 << "%" << std::endl;
 }
 
-// 回归测试（检查性能是否退化）
-bool RunRegressionTest(const std::vector<ComparisonResult>& comparisons,
-                      double max_slowdown = 1.1,  // 允许10%的减速
-                      double max_memory_increase = 1.2) {  // 允许20%的内存增加
-    
+// 回归测试（检查性能是否退化）：中位数显著变慢超过阈值，或内存增长超过阈值
+bool RunRegressionTest(const std::vector<ComparisonResult>& comparisons, const HarnessOptions& harness) {
     bool passed = true;
     
     std::cout << "\n========== Regression Test ==========" << std::endl;
@@ -308,14 +824,19 @@ bool RunRegressionTest(const std::vector<ComparisonResult>& comparisons,
         std::string issues;
         
         // 检查性能退化
-        if (comp.speedup < 1.0 / max_slowdown) {
+        if (std::string(Verdict(comp, harness)) == "slower") {
             model_passed = false;
-            issues += "Performance regression (slowdown: " + 
-                     std::to_string(1.0 / comp.speedup) + "x); ";
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2) << "Performance regression (p50 +" << comp.change_percent << "%";
+            if (comp.has_samples) {
+                oss << std::setprecision(4) << ", p=" << comp.p_value;
+            }
+            oss << "); ";
+            issues += oss.str();
         }
         
         // 检查内存增加
-        if (comp.memory_change_percent > (max_memory_increase - 1.0) * 100.0) {
+        if (comp.memory_change_percent > (harness.max_memory_increase - 1.0) * 100.0) {
             model_passed = false;
             issues += "Memory increase: " + std::to_string(comp.memory_change_percent) + "%; ";
         }
@@ -333,105 +854,176 @@ bool RunRegressionTest(const std::vector<ComparisonResult>& comparisons,
     return passed;
 }
 
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <command> [options]" << std::endl;
+    std::cerr << "\nCommands:" << std::endl;
+    std::cerr << "  run <model_list> [output]         Run benchmark on models (.json or .csv output)" << std::endl;
+    std::cerr << "  compare <model_list> <baseline>   Benchmark models and compare against a stored result" << std::endl;
+    std::cerr << "  regression <model_list> <baseline> Like compare; exit code 1 on a significant slowdown" << std::endl;
+    std::cerr << "\nModel list entries are file paths or generated models, zoo:<name>[:key=value,...]" << std::endl;
+    std::cerr << "(see tools/model_zoo.txt); models:";
+    for (const auto& model : GetZooModels()) {
+        std::cerr << " " << model.name;
+    }
+    std::cerr << std::endl;
+    std::cerr << "\nMeasurement options:" << std::endl;
+    std::cerr << "  --warmup N          Warmup runs (default: 10)" << std::endl;
+    std::cerr << "  --min-iters N       Minimum timed runs (default: 20)" << std::endl;
+    std::cerr << "  --max-iters N       Maximum timed runs (default: 1000)" << std::endl;
+    std::cerr << "  --max-time S        Time budget per model in seconds (default: 10)" << std::endl;
+    std::cerr << "  --target-ci X       Stop when the 95% CI half-width / mean <= X (default: 0.01)" << std::endl;
+    std::cerr << "  --outlier-z X       Reject samples with modified z-score > X (default: 3.5)" << std::endl;
+    std::cerr << "  --cold-cache        Evict caches before every run (default: warm)" << std::endl;
+    std::cerr << "  --flush-mb N        Size of the eviction buffer in MB (default: 128)" << std::endl;
+    std::cerr << "  --threads N         Thread pool size (default: hardware concurrency)" << std::endl;
+    std::cerr << "  --pin-threads       Pin worker threads to CPUs" << std::endl;
+    std::cerr << "  --pin-main CPU      Pin the benchmark thread to CPU" << std::endl;
+    std::cerr << "  --governor NAME     Set the cpufreq governor (e.g. performance, needs root)" << std::endl;
+    std::cerr << "\nComparison options:" << std::endl;
+    std::cerr << "  --alpha X           Significance level (default: 0.05)" << std::endl;
+    std::cerr << "  --threshold PCT     Smallest median change reported as a regression (default: 2)" << std::endl;
+    std::cerr << "\nRoofline options:" << std::endl;
+    std::cerr << "  --peak-gflops X     Peak compute (default: estimated from CPU features)" << std::endl;
+    std::cerr << "  --peak-gbps X       Peak memory bandwidth (default: measured copy bandwidth)" << std::endl;
+    std::cerr << "  --cpu-ghz X         Clock used for the peak compute estimate (default: 3.0)" << std::endl;
+    std::cerr << "  --machine-profile FILE  Peaks measured by inferunity_calibrate" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <command> [options]" << std::endl;
-        std::cerr << "\nCommands:" << std::endl;
-        std::cerr << "  run <model_list> [output]     Run benchmark on models" << std::endl;
-        std::cerr << "  compare <current> <baseline> Compare current vs baseline" << std::endl;
-        std::cerr << "  regression <current> <baseline> Run regression test" << std::endl;
+        PrintUsage(argv[0]);
         return 1;
     }
     
-    std::string command = argv[1];
+    // 选项可以出现在任意位置，其余为位置参数
+    std::vector<std::string> args;
+    HarnessOptions harness;
+    RooflinePeaks peaks;
+    double cpu_ghz = 3.0;
+    std::string machine_profile;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--cold-cache") {
+            harness.cold_cache = true;
+        } else if (arg == "--pin-threads") {
+            harness.pin_threads = true;
+        } else if (arg == "--governor" && has_value) {
+            harness.governor = argv[++i];
+        } else if (arg == "--machine-profile" && has_value) {
+            machine_profile = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0 && has_value) {
+            const double value = std::stod(argv[++i]);
+            if (arg == "--warmup") harness.warmup_iterations = static_cast<int>(value);
+            else if (arg == "--min-iters") harness.min_iterations = std::max(static_cast<int>(value), 2);
+            else if (arg == "--max-iters") harness.max_iterations = static_cast<int>(value);
+            else if (arg == "--max-time") harness.max_time_s = value;
+            else if (arg == "--target-ci") harness.target_ci = value;
+            else if (arg == "--outlier-z") harness.outlier_threshold = value;
+            else if (arg == "--flush-mb") harness.flush_bytes = static_cast<size_t>(value) << 20;
+            else if (arg == "--threads") harness.threads = static_cast<int>(value);
+            else if (arg == "--pin-main") harness.pin_main_cpu = static_cast<int>(value);
+            else if (arg == "--alpha") harness.alpha = value;
+            else if (arg == "--threshold") harness.max_slowdown = 1.0 + value / 100.0;
+            else if (arg == "--peak-gflops") peaks.peak_gflops = value;
+            else if (arg == "--peak-gbps") peaks.peak_gbps = value;
+            else if (arg == "--cpu-ghz") cpu_ghz = value;
+            else {
+                std::cerr << "Error: Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    harness.max_iterations = std::max(harness.max_iterations, harness.min_iterations);
+    if (args.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
     
+    std::string command = args[0];
+    if (command != "run" && command != "compare" && command != "regression") {
+        std::cerr << "Error: Unknown command: " << command << std::endl;
+        return 1;
+    }
+    if (args.size() < (command == "run" ? 2u : 3u)) {
+        std::cerr << (command == "run" ? "Error: Missing model list file" : "Error: Missing model list or baseline file")
+                  << std::endl;
+        return 1;
+    }
+    
+    const HarnessEnvironment env = PrepareEnvironment(harness);
+    std::string model_list = args[1];
+    std::cout << "Loading model list from: " << model_list << std::endl;
+    auto models = LoadModelList(model_list);
+    if (models.empty()) {
+        std::cerr << "No models found in list" << std::endl;
+        return 1;
+    }
     if (command == "run") {
-        if (argc < 3) {
-            std::cerr << "Error: Missing model list file" << std::endl;
-            return 1;
-        }
-        
-        std::string model_list = argv[2];
-        std::string output_file = (argc > 3) ? argv[3] : "benchmark_results.csv";
-        
-        std::cout << "Loading model list from: " << model_list << std::endl;
-        auto models = LoadModelList(model_list);
-        
-        if (models.empty()) {
-            std::cerr << "No models found in list" << std::endl;
-            return 1;
-        }
-        
-        std::cout << "Found " << models.size() << " models" << std::endl;
-        std::cout << "Running benchmarks..." << std::endl;
-        
-        std::vector<ModelBenchmark> results;
-        for (size_t i = 0; i < models.size(); ++i) {
-            std::cout << "\n[" << (i + 1) << "/" << models.size() << "] " 
-                      << models[i] << std::endl;
-            
-            auto result = RunModelBenchmark(models[i]);
-            results.push_back(result);
-            
-            if (result.success) {
-                std::cout << "  Avg time: " << result.avg_time_ms << " ms" << std::endl;
-                std::cout << "  Throughput: " << result.throughput << " inferences/sec" << std::endl;
-                std::cout << "  Memory: " << result.memory_used_mb << " MB" << std::endl;
-            } else {
-                std::cout << "  FAILED: " << result.error_message << std::endl;
+        if (!machine_profile.empty()) {
+            Status status = LoadMachineProfile(machine_profile);
+            if (!status.IsOk()) {
+                std::cerr << "Failed to load machine profile: " << status.Message() << std::endl;
+                return 1;
             }
+            MachineProfile profile;
+            GetMachineProfile(&profile);
+            const RooflinePeaks measured = profile.GetRooflinePeaks();
+            if (peaks.peak_gflops <= 0) peaks.peak_gflops = measured.peak_gflops;
+            if (peaks.peak_gbps <= 0) peaks.peak_gbps = measured.peak_gbps;
         }
-        
-        SaveBenchmarkResults(results, output_file);
-        
-    } else if (command == "compare") {
-        if (argc < 4) {
-            std::cerr << "Error: Missing current or baseline file" << std::endl;
-            return 1;
+        if (peaks.peak_gflops <= 0) {
+            peaks.peak_gflops = EstimatePeakGflops(cpu_ghz);
         }
-        
-        std::string current_file = argv[2];
-        std::string baseline_file = argv[3];
-        
-        // 加载结果
-        auto current_models = LoadModelList(current_file);
-        std::vector<ModelBenchmark> current_results;
-        for (const auto& model : current_models) {
-            current_results.push_back(RunModelBenchmark(model, 5, 20));
+        if (peaks.peak_gbps <= 0) {
+            peaks.peak_gbps = MeasureMemoryBandwidthGbps();
         }
+    }
+    
+    std::cout << "Found " << models.size() << " models" << std::endl;
+    std::cout << "Running benchmarks (" << (harness.cold_cache ? "cold" : "warm") << " cache, "
+              << env.threads << " threads)..." << std::endl;
+    
+    std::vector<ModelBenchmark> results;
+    for (size_t i = 0; i < models.size(); ++i) {
+        std::cout << "\n[" << (i + 1) << "/" << models.size() << "] " << models[i] << std::endl;
         
-        auto baseline = LoadBaselineResults(baseline_file);
-        auto comparisons = CompareResults(current_results, baseline);
-        
-        PrintComparison(comparisons);
+        auto result = RunModelBenchmark(models[i], harness, peaks);
+        results.push_back(result);
         
-    } else if (command == "regression") {
-        if (argc < 4) {
-            std::cerr << "Error: Missing current or baseline file" << std::endl;
-            return 1;
+        if (!result.success) {
+            std::cout << "  FAILED: " << result.error_message << std::endl;
+            continue;
         }
-        
-        std::string current_file = argv[2];
-        std::string baseline_file = argv[3];
-        
-        // 加载结果
-        auto current_models = LoadModelList(current_file);
-        std::vector<ModelBenchmark> current_results;
-        for (const auto& model : current_models) {
-            current_results.push_back(RunModelBenchmark(model, 5, 20));
+        const SampleStats& s = result.stats;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "  Runs: " << result.samples_ms.size() << " (" << s.outliers << " outliers rejected)"
+                  << ", mean " << s.mean << " ms ± " << s.ci95 << " (95% CI, "
+                  << s.GetRelativeCi() * 100.0 << "%)" << std::endl;
+        std::cout << "  p50 " << s.p50 << " / p90 " << s.p90 << " / p99 " << s.p99 << " / p99.9 " << s.p999
+                  << " ms, min " << s.min << ", max " << s.max << std::endl;
+        std::cout << "  Throughput: " << result.throughput << " inferences/sec" << std::endl;
+        std::cout << "  Memory: " << result.memory_used_mb << " MB" << std::endl;
+        if (command == "run") {
+            std::cout << "  Compute: " << result.gflops << " GFLOP/s, "
+                      << result.roofline_efficiency << "% of roofline (peak " << peaks.peak_gflops
+                      << " GFLOP/s, " << peaks.peak_gbps << " GB/s)" << std::endl;
+            PrintNodeEfficiency(result, peaks);
         }
-        
-        auto baseline = LoadBaselineResults(baseline_file);
-        auto comparisons = CompareResults(current_results, baseline);
-        
-        bool passed = RunRegressionTest(comparisons);
-        return passed ? 0 : 1;
-        
-    } else {
-        std::cerr << "Error: Unknown command: " << command << std::endl;
-        return 1;
     }
     
+    if (command == "run") {
+        SaveBenchmarkResults(results, env, peaks, args.size() > 2 ? args[2] : "benchmark_results.json");
+        return 0;
+    }
+    
+    auto baseline = LoadBaselineResults(args[2], harness);
+    auto comparisons = CompareResults(results, baseline, harness);
+    PrintComparison(comparisons, harness);
+    if (command == "regression") {
+        return RunRegressionTest(comparisons, harness) ? 0 : 1;
+    }
     return 0;
 }
-
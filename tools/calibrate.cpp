@@ -0,0 +1,382 @@
+// 机器能力标定工具（参考Empirical Roofline Toolkit与STREAM）
+// 测量本机各指令集的FP32 FMA峰值（单核与全部线程）、工作集分别落在L1/L2/L3/内存时的读写带宽、
+// 线程池派发一次并行循环的延迟，写出机器画像（见inferunity/perf_counters.h的MachineProfile）。
+// inferunity_profiler与inferunity_benchmark_suite用--machine-profile加载它作为屋顶线的峰值，
+// 应用调用LoadMachineProfile后默认的CostModel（图分区）按实测值估计CPU上的节点耗时
+
+#include "inferunity/cpu_features.h"
+#include "inferunity/perf_counters.h"
+#include "inferunity/runtime.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace inferunity;
+
+namespace {
+
+// 独立的累加链数：覆盖FMA的延迟（4~5周期）× 每周期可发射的FMA数（2）
+constexpr int kChains = 12;
+
+using Clock = std::chrono::steady_clock;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 各指令集的内核：执行iterations轮，每轮每条链一次乘加，返回浮点运算数；结果写入sink防止被优化掉。
+// 标量内核只在没有SIMD内核的平台上使用（编译器可能把它向量化）
+#if !defined(__x86_64__) && !defined(_M_X64) && !defined(__i386__) && !defined(__aarch64__)
+double ScalarKernel(int64_t iterations, float* sink) {
+    float acc[kChains];
+    for (int c = 0; c < kChains; ++c) acc[c] = static_cast<float>(c);
+    const float a = 0.999f, b = 0.001f;
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (int c = 0; c < kChains; ++c) acc[c] = acc[c] * a + b;
+    }
+    float sum = 0.0f;
+    for (int c = 0; c < kChains; ++c) sum += acc[c];
+    *sink = sum;
+    return 2.0 * kChains * static_cast<double>(iterations);
+}
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+double SseKernel(int64_t iterations, float* sink) {
+    __m128 acc[kChains];
+    for (int c = 0; c < kChains; ++c) acc[c] = _mm_set1_ps(static_cast<float>(c));
+    const __m128 a = _mm_set1_ps(0.999f), b = _mm_set1_ps(0.001f);
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (int c = 0; c < kChains; ++c) acc[c] = _mm_add_ps(_mm_mul_ps(acc[c], a), b);
+    }
+    __m128 sum = _mm_setzero_ps();
+    for (int c = 0; c < kChains; ++c) sum = _mm_add_ps(sum, acc[c]);
+    *sink = _mm_cvtss_f32(sum);
+    return 2.0 * 4 * kChains * static_cast<double>(iterations);
+}
+
+__attribute__((target("avx2,fma")))
+double Avx2Kernel(int64_t iterations, float* sink) {
+    __m256 acc[kChains];
+    for (int c = 0; c < kChains; ++c) acc[c] = _mm256_set1_ps(static_cast<float>(c));
+    const __m256 a = _mm256_set1_ps(0.999f), b = _mm256_set1_ps(0.001f);
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (int c = 0; c < kChains; ++c) acc[c] = _mm256_fmadd_ps(acc[c], a, b);
+    }
+    __m256 sum = _mm256_setzero_ps();
+    for (int c = 0; c < kChains; ++c) sum = _mm256_add_ps(sum, acc[c]);
+    *sink = _mm256_cvtss_f32(sum);
+    return 2.0 * 8 * kChains * static_cast<double>(iterations);
+}
+
+__attribute__((target("avx512f")))
+double Avx512Kernel(int64_t iterations, float* sink) {
+    __m512 acc[kChains];
+    for (int c = 0; c < kChains; ++c) acc[c] = _mm512_set1_ps(static_cast<float>(c));
+    const __m512 a = _mm512_set1_ps(0.999f), b = _mm512_set1_ps(0.001f);
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (int c = 0; c < kChains; ++c) acc[c] = _mm512_fmadd_ps(acc[c], a, b);
+    }
+    __m512 sum = _mm512_setzero_ps();
+    for (int c = 0; c < kChains; ++c) sum = _mm512_add_ps(sum, acc[c]);
+    *sink = _mm512_reduce_add_ps(sum);
+    return 2.0 * 16 * kChains * static_cast<double>(iterations);
+}
+#endif
+
+#if defined(__aarch64__)
+double NeonKernel(int64_t iterations, float* sink) {
+    float32x4_t acc[kChains];
+    for (int c = 0; c < kChains; ++c) acc[c] = vdupq_n_f32(static_cast<float>(c));
+    const float32x4_t a = vdupq_n_f32(0.999f), b = vdupq_n_f32(0.001f);
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (int c = 0; c < kChains; ++c) acc[c] = vfmaq_f32(b, acc[c], a);
+    }
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int c = 0; c < kChains; ++c) sum = vaddq_f32(sum, acc[c]);
+    *sink = vaddvq_f32(sum);
+    return 2.0 * 4 * kChains * static_cast<double>(iterations);
+}
+#endif
+
+struct IsaKernel {
+    const char* name;
+    double (*run)(int64_t iterations, float* sink);
+};
+
+std::vector<IsaKernel> AvailableKernels() {
+    std::vector<IsaKernel> kernels;
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    const CpuFeatures& features = GetCpuFeatures();
+    kernels.push_back({"sse", &SseKernel});
+    if (features.avx2 && features.fma) {
+        kernels.push_back({"avx2", &Avx2Kernel});
+    }
+    if (features.avx512f) {
+        kernels.push_back({"avx512", &Avx512Kernel});
+    }
+#elif defined(__aarch64__)
+    kernels.push_back({"neon", &NeonKernel});
+#else
+    kernels.push_back({"scalar", &ScalarKernel});
+#endif
+    return kernels;
+}
+
+// 运行次数加倍直到单次耗时超过min_seconds，取repeats次中最快的GFLOP/s
+double MeasureKernelGflops(const IsaKernel& kernel, double min_seconds, int repeats) {
+    float sink = 0.0f;
+    int64_t iterations = 1 << 12;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        kernel.run(iterations, &sink);
+        if (SecondsSince(start) >= min_seconds || iterations >= (int64_t(1) << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        const Clock::time_point start = Clock::now();
+        const double flops = kernel.run(iterations, &sink);
+        best = std::max(best, flops / SecondsSince(start) / 1e9);
+    }
+    return best;
+}
+
+// 全部线程同时运行内核，总运算数除以墙钟时间
+double MeasureAllCoreGflops(const IsaKernel& kernel, size_t threads, double min_seconds, int repeats) {
+    float sink = 0.0f;
+    int64_t iterations = 1 << 12;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        kernel.run(iterations, &sink);
+        if (SecondsSince(start) >= min_seconds || iterations >= (int64_t(1) << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        std::vector<double> flops(threads, 0.0);
+        std::vector<float> sinks(threads, 0.0f);
+        const Clock::time_point start = Clock::now();
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(threads), 1, [&](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t) {
+                flops[t] = kernel.run(iterations, &sinks[t]);
+            }
+        });
+        const double seconds = SecondsSince(start);
+        double total = 0.0;
+        for (double f : flops) total += f;
+        best = std::max(best, total / seconds / 1e9);
+    }
+    return best;
+}
+
+struct CacheSizes {
+    size_t l1 = 32u << 10;
+    size_t l2 = 1u << 20;
+    size_t l3 = 16u << 20;
+};
+
+// Linux上读sysfs中cpu0的数据缓存与统一缓存大小，读不到时保留默认值
+CacheSizes DetectCacheSizes() {
+    CacheSizes sizes;
+#if defined(__linux__)
+    for (int index = 0; index < 8; ++index) {
+        const std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+        int level = 0;
+        std::string type, size_text;
+        if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size_text) || type == "Instruction") {
+            continue;
+        }
+        size_t bytes = std::stoul(size_text);
+        if (!size_text.empty() && size_text.back() == 'K') bytes <<= 10;
+        if (!size_text.empty() && size_text.back() == 'M') bytes <<= 20;
+        if (level == 1) sizes.l1 = bytes;
+        if (level == 2) sizes.l2 = bytes;
+        if (level == 3) sizes.l3 = bytes;
+    }
+#endif
+    return sizes;
+}
+
+// 每个线程在自己的缓冲上反复执行b[i] = s * a[i]（STREAM的Scale），按读+写计字节
+double MeasureBandwidthGbps(size_t bytes_per_thread, size_t threads, double min_seconds, int repeats) {
+    const size_t count = std::max<size_t>(bytes_per_thread / (2 * sizeof(float)), 64);
+    std::vector<std::vector<float>> a(threads), b(threads);
+    // 由执行线程首次写入，页面分配在其所在的节点
+    ThreadPool::ParallelFor(0, static_cast<int64_t>(threads), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+            a[t].assign(count, 1.0f);
+            b[t].assign(count, 0.0f);
+        }
+    });
+    auto scale_passes = [&](int64_t passes) {
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(threads), 1, [&](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t) {
+                float* dst = b[t].data();
+                const float* src = a[t].data();
+                for (int64_t p = 0; p < passes; ++p) {
+                    const float s = 1.0f + static_cast<float>(p & 1) * 1e-7f;
+                    for (size_t i = 0; i < count; ++i) dst[i] = s * src[i];
+                    // 阻止编译器合并各轮
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                }
+            }
+        });
+    };
+    int64_t passes = 1;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        scale_passes(passes);
+        if (SecondsSince(start) >= min_seconds || passes >= (int64_t(1) << 30)) {
+            break;
+        }
+        passes *= 2;
+    }
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        const Clock::time_point start = Clock::now();
+        scale_passes(passes);
+        const double bytes = 2.0 * sizeof(float) * static_cast<double>(count) * static_cast<double>(passes) *
+                             static_cast<double>(threads);
+        best = std::max(best, bytes / SecondsSince(start) / 1e9);
+    }
+    return best;
+}
+
+// 每个线程一块的空并行循环的往返耗时（微秒），取中位数
+double MeasureDispatchLatencyUs(size_t threads, int samples) {
+    std::vector<double> times;
+    std::atomic<int64_t> counter{0};
+    for (int i = 0; i < samples + 100; ++i) {
+        const Clock::time_point start = Clock::now();
+        ThreadPool::ParallelFor(0, static_cast<int64_t>(threads), 1, [&](int64_t begin, int64_t end) {
+            counter.fetch_add(end - begin, std::memory_order_relaxed);
+        });
+        if (i >= 100) {
+            times.push_back(SecondsSince(start) * 1e6);
+        }
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+std::string CpuModelName() {
+#if defined(__linux__)
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+#endif
+    return "unknown";
+}
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  -o, --output FILE   Machine profile to write (default: machine_profile.txt)" << std::endl;
+    std::cerr << "  -t, --threads N     Threads for the all-core measurements (default: thread pool size)" << std::endl;
+    std::cerr << "  --quick             Shorter measurements (less stable)" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::string output_file = "machine_profile.txt";
+    size_t threads = 0;
+    bool quick = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) {
+            threads = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--quick") {
+            quick = true;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads > 0) {
+        ThreadPoolOptions pool_options;
+        pool_options.num_threads = threads;
+        ThreadPool::Configure(pool_options);
+    }
+    // 调用线程也参与并行循环
+    threads = ThreadPool::GetThreadCount();
+    const double min_seconds = quick ? 0.02 : 0.2;
+    const int repeats = quick ? 2 : 5;
+    
+    MachineProfile profile;
+    profile.cpu_model = CpuModelName();
+    profile.threads = threads;
+    std::cout << "CPU: " << profile.cpu_model << ", " << threads << " threads" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    
+    std::cout << "\nFP32 FMA peak (GFLOP/s):" << std::endl;
+    std::cout << std::setw(10) << "ISA" << std::setw(14) << "1 core" << std::setw(14) << "all cores" << std::endl;
+    for (const IsaKernel& kernel : AvailableKernels()) {
+        const double core = MeasureKernelGflops(kernel, min_seconds, repeats);
+        const double all = MeasureAllCoreGflops(kernel, threads, min_seconds, repeats);
+        profile.core_peak_gflops[kernel.name] = core;
+        profile.all_core_peak_gflops[kernel.name] = all;
+        std::cout << std::setw(10) << kernel.name << std::setw(14) << core << std::setw(14) << all << std::endl;
+    }
+    
+    // 每个线程的工作集取该级容量的一半；L3由全部线程共享，工作集装不下时（每线程份额不超过L2）不测
+    const CacheSizes caches = DetectCacheSizes();
+    std::cout << "\nBandwidth, read + write (GB/s, all threads):" << std::endl;
+    profile.l1_gbps = MeasureBandwidthGbps(caches.l1 / 2, threads, min_seconds, repeats);
+    profile.l2_gbps = MeasureBandwidthGbps(caches.l2 / 2, threads, min_seconds, repeats);
+    const size_t l3_share = caches.l3 / 2 / threads;
+    if (l3_share > caches.l2) {
+        profile.l3_gbps = MeasureBandwidthGbps(l3_share, threads, min_seconds, repeats);
+    }
+    const size_t dram_total = std::max<size_t>(caches.l3 * 8, size_t(256) << 20);
+    profile.dram_gbps = MeasureBandwidthGbps(dram_total / threads, threads, min_seconds, repeats);
+    std::cout << "  L1   (" << (caches.l1 >> 10) << " KB):  " << profile.l1_gbps << std::endl;
+    std::cout << "  L2   (" << (caches.l2 >> 10) << " KB):  " << profile.l2_gbps << std::endl;
+    std::ostringstream l3;
+    l3 << std::fixed << std::setprecision(1) << profile.l3_gbps;
+    std::cout << "  L3   (" << (caches.l3 >> 10) << " KB):  " << (profile.l3_gbps > 0 ? l3.str() : "n/a") << std::endl;
+    std::cout << "  DRAM (" << (dram_total >> 20) << " MB):  " << profile.dram_gbps << std::endl;
+    
+    profile.dispatch_latency_us = MeasureDispatchLatencyUs(threads, quick ? 200 : 2000);
+    std::cout << std::setprecision(2);
+    std::cout << "\nThread pool dispatch latency: " << profile.dispatch_latency_us << " us" << std::endl;
+    
+    const RooflinePeaks peaks = profile.GetRooflinePeaks();
+    std::cout << "Roofline: " << peaks.peak_gflops << " GFLOP/s, " << peaks.peak_gbps << " GB/s, ridge point "
+              << peaks.GetRidgePoint() << " FLOP/byte" << std::endl;
+    
+    Status status = profile.Save(output_file);
+    if (!status.IsOk()) {
+        std::cerr << "Error: " << status.Message() << std::endl;
+        return 1;
+    }
+    std::cout << "Machine profile written to: " << output_file << std::endl;
+    return 0;
+}
@@ -3,12 +3,14 @@
 
 #include "inferunity/engine.h"
 #include "inferunity/graph.h"
+#include "inferunity/model_format.h"
 #include "inferunity/optimizer.h"
 #include "frontend/onnx_parser.h"
 // 前向声明形状推断函数
 namespace inferunity {
     Status InferShapes(Graph* graph);
 }
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -56,7 +58,8 @@ Status ValidateModel(const std::string& model_path) {
 }
 
 // 转换模型格式
-Status ConvertModel(const std::string& input_path, const std::string& output_path) {
+Status ConvertModel(const std::string& input_path, const std::string& output_path,
+                    const CompactModelSaveOptions& save_options) {
     std::cout << "Converting model:" << std::endl;
     std::cout << "  Input:  " << input_path << std::endl;
     std::cout << "  Output: " << output_path << std::endl;
@@ -79,16 +82,21 @@ Status ConvertModel(const std::string& input_path, const std::string& output_pat
     Optimizer optimizer;
     // 注册优化Pass
     optimizer.RegisterPass(std::make_unique<ConstantFoldingPass>());
+    optimizer.RegisterPass(std::make_unique<TransposeOptimizationPass>());
+    optimizer.RegisterPass(std::make_unique<IdentityEliminationPass>());
+    optimizer.RegisterPass(std::make_unique<CommonSubexpressionEliminationPass>());
     optimizer.RegisterPass(std::make_unique<DeadCodeEliminationPass>());
+    optimizer.RegisterPass(std::make_unique<ConvBNFoldingPass>());
     optimizer.RegisterPass(std::make_unique<OperatorFusionPass>());
+    optimizer.RegisterPass(std::make_unique<MemoryAwareSchedulingPass>());
     
     status = optimizer.Optimize(graph.get());
     if (!status.IsOk()) {
         std::cerr << "Warning: Graph optimization failed: " << status.Message() << std::endl;
     }
     
-    // 序列化图
-    status = graph->Serialize(output_path);
+    // 写出原生紧凑格式，InferenceSession::LoadModel直接映射加载（压缩时加载时并行解压）
+    status = SaveCompactModel(*graph, output_path, save_options);
     if (!status.IsOk()) {
         return status;
     }
@@ -169,7 +177,9 @@ int main(int argc, char* argv[]) {
         std::cerr << "Usage: " << argv[0] << " <command> [options]" << std::endl;
         std::cerr << "\nCommands:" << std::endl;
         std::cerr << "  validate <model_path>     Validate ONNX model" << std::endl;
-        std::cerr << "  convert <input> <output>  Convert ONNX to internal format" << std::endl;
+        std::cerr << "  convert <input> <output> [--compress lz4] [--chunk-size BYTES]" << std::endl;
+        std::cerr << "                            Convert ONNX to compact binary format, optionally with" << std::endl;
+        std::cerr << "                            chunked LZ4-compressed weights (default chunk 1 MiB)" << std::endl;
         std::cerr << "  info <model_path>         Print model information" << std::endl;
         return 1;
     }
@@ -194,7 +204,25 @@ int main(int argc, char* argv[]) {
         }
         std::string input_path = argv[2];
         std::string output_path = argv[3];
-        Status status = ConvertModel(input_path, output_path);
+        CompactModelSaveOptions save_options;
+        for (int i = 4; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--compress" && i + 1 < argc) {
+                const std::string codec = argv[++i];
+                if (codec == "lz4") {
+                    save_options.compression = WeightCompression::LZ4;
+                } else if (codec != "none") {
+                    std::cerr << "Error: Unknown compression: " << codec << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--chunk-size" && i + 1 < argc) {
+                save_options.chunk_size = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+            } else {
+                std::cerr << "Error: Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+        Status status = ConvertModel(input_path, output_path, save_options);
         if (!status.IsOk()) {
             std::cerr << "Conversion failed: " << status.Message() << std::endl;
             return 1;
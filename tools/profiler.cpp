@@ -9,11 +9,29 @@
 #include <fstream>
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 
 using namespace inferunity;
 
+// 节点的浮点运算数与访存字节：有硬件浮点事件时用实测值，否则用解析估计；
+// 访存字节有计数器时取LLC未命中×缓存行（实际的DRAM流量）
+double NodeFlops(const ProfilingResult& result, const ProfilingResult::NodeProfile& profile) {
+    if (result.hardware_counters && profile.counters.has_fp_ops && profile.counters.fp_ops > 0) {
+        return static_cast<double>(profile.counters.fp_ops);
+    }
+    return profile.estimated_flops;
+}
+
+double NodeBytes(const ProfilingResult& result, const ProfilingResult::NodeProfile& profile) {
+    if (result.hardware_counters) {
+        return static_cast<double>(profile.counters.GetLlcMissBytes());
+    }
+    return static_cast<double>(profile.estimated_bytes);
+}
+
 // 打印性能分析结果
-void PrintProfilingResults(const ProfilingResult& result, bool verbose = false) {
+void PrintProfilingResults(const ProfilingResult& result, bool verbose = false,
+                           const RooflinePeaks& peaks = RooflinePeaks()) {
     std::cout << "\n========== Performance Profiling Results ==========" << std::endl;
     std::cout << std::fixed << std::setprecision(3);
     
@@ -28,8 +46,10 @@ void PrintProfilingResults(const ProfilingResult& result, bool verbose = false)
                   << std::setw(20) << "Op Type"
                   << std::setw(15) << "Time (ms)"
                   << std::setw(15) << "Memory (MB)"
-                  << std::setw(15) << "Time %" << std::endl;
-        std::cout << std::string(95, '-') << std::endl;
+                  << std::setw(15) << "Time %"
+                  << std::setw(12) << "GFLOP/s"
+                  << std::setw(10) << "% Roof" << std::endl;
+        std::cout << std::string(117, '-') << std::endl;
         
         // 按执行时间排序
         std::vector<ProfilingResult::NodeProfile> sorted_profiles = result.node_profiles;
@@ -42,21 +62,36 @@ void PrintProfilingResults(const ProfilingResult& result, bool verbose = false)
             double time_percent = (result.total_time_ms > 0) ? 
                 (profile.execution_time_ms / result.total_time_ms * 100.0) : 0.0;
             
+            // 屋顶线效率：以峰值算力与带宽执行该节点的最短耗时 / 实测耗时
+            const double flops = NodeFlops(result, profile);
+            const double gflops = profile.execution_time_ms > 0 ? flops / profile.execution_time_ms / 1e6 : 0.0;
+            const double roofline_ms = peaks.GetRooflineTimeMs(flops, NodeBytes(result, profile));
+            const double efficiency = profile.execution_time_ms > 0 ?
+                roofline_ms / profile.execution_time_ms * 100.0 : 0.0;
+            
             std::cout << std::setw(30) << profile.node_name
                       << std::setw(20) << profile.op_type
                       << std::setw(15) << profile.execution_time_ms
                       << std::setw(15) << (profile.memory_used_bytes / 1024.0 / 1024.0)
-                      << std::setw(15) << time_percent << "%" << std::endl;
+                      << std::setw(14) << time_percent << "%"
+                      << std::setw(12) << gflops
+                      << std::setw(9) << efficiency << "%" << std::endl;
         }
         
         // 统计各算子类型的总时间
         std::cout << "\nOperator Type Statistics:" << std::endl;
         std::unordered_map<std::string, double> op_type_times;
         std::unordered_map<std::string, int> op_type_counts;
+        std::unordered_map<std::string, double> op_type_flops;
+        std::unordered_map<std::string, double> op_type_bytes;
+        std::unordered_map<std::string, HardwareCounterValues> op_type_counters;
         
         for (const auto& profile : result.node_profiles) {
             op_type_times[profile.op_type] += profile.execution_time_ms;
             op_type_counts[profile.op_type]++;
+            op_type_flops[profile.op_type] += NodeFlops(result, profile);
+            op_type_bytes[profile.op_type] += NodeBytes(result, profile);
+            op_type_counters[profile.op_type] += profile.counters;
         }
         
         std::vector<std::pair<std::string, double>> sorted_ops;
@@ -69,19 +104,63 @@ void PrintProfilingResults(const ProfilingResult& result, bool verbose = false)
                      return a.second > b.second;
                  });
         
+        // 屋顶线：达到的GFLOP/s与峰值的比例、每FLOP的访存字节；
+        // 算术强度低于脊点(peak_gflops / peak_gbps)的算子受带宽限制
+        const bool counters = result.hardware_counters;
         std::cout << std::setw(20) << "Op Type"
                   << std::setw(15) << "Total Time (ms)"
                   << std::setw(15) << "Count"
-                  << std::setw(15) << "Avg Time (ms)" << std::endl;
-        std::cout << std::string(65, '-') << std::endl;
+                  << std::setw(15) << "Avg Time (ms)"
+                  << std::setw(12) << "GFLOP/s"
+                  << std::setw(10) << "% Peak"
+                  << std::setw(12) << "Bytes/FLOP"
+                  << std::setw(10) << "Bound";
+        if (counters) {
+            std::cout << std::setw(8) << "IPC"
+                      << std::setw(12) << "LLC Miss%"
+                      << std::setw(10) << "GB/s";
+        }
+        std::cout << std::endl;
+        std::cout << std::string(counters ? 159 : 129, '-') << std::endl;
         
+        const double ridge = peaks.GetRidgePoint();
         for (const auto& pair : sorted_ops) {
-            double avg_time = op_type_times[pair.first] / op_type_counts[pair.first];
-            std::cout << std::setw(20) << pair.first
-                      << std::setw(15) << op_type_times[pair.first]
-                      << std::setw(15) << op_type_counts[pair.first]
-                      << std::setw(15) << avg_time << std::endl;
+            const std::string& op = pair.first;
+            double avg_time = op_type_times[op] / op_type_counts[op];
+            const double seconds = op_type_times[op] / 1000.0;
+            const double gflops = seconds > 0 ? op_type_flops[op] / seconds / 1e9 : 0.0;
+            const double bytes_per_flop = op_type_flops[op] > 0 ? op_type_bytes[op] / op_type_flops[op] : 0.0;
+            const char* bound = "-";
+            if (ridge > 0 && bytes_per_flop > 0) {
+                bound = 1.0 / bytes_per_flop < ridge ? "memory" : "compute";
+            }
+            std::cout << std::setw(20) << op
+                      << std::setw(15) << op_type_times[op]
+                      << std::setw(15) << op_type_counts[op]
+                      << std::setw(15) << avg_time
+                      << std::setw(12) << gflops
+                      << std::setw(9) << (peaks.peak_gflops > 0 ? gflops / peaks.peak_gflops * 100.0 : 0.0) << "%"
+                      << std::setw(12) << bytes_per_flop
+                      << std::setw(10) << bound;
+            if (counters) {
+                const HardwareCounterValues& values = op_type_counters[op];
+                const double miss_rate = values.llc_references > 0 ?
+                    static_cast<double>(values.llc_misses) / static_cast<double>(values.llc_references) * 100.0 : 0.0;
+                std::cout << std::setw(8) << values.GetIpc()
+                          << std::setw(11) << miss_rate << "%"
+                          << std::setw(10) << (seconds > 0 ? op_type_bytes[op] / seconds / 1e9 : 0.0);
+            }
+            std::cout << std::endl;
         }
+        std::cout << "\nRoofline: peak " << peaks.peak_gflops << " GFLOP/s, " << peaks.peak_gbps
+                  << " GB/s, ridge " << ridge << " FLOP/byte" << std::endl;
+        std::cout << "  FLOPs: " << (counters && !result.node_profiles.empty() &&
+                                     result.node_profiles.front().counters.has_fp_ops
+                                     ? "FP_ARITH_INST_RETIRED" : "analytic estimate")
+                  << ", bytes: " << (counters ? "LLC misses x 64B" : "analytic tensor bytes") << std::endl;
+    }
+    if (!result.hardware_counter_error.empty()) {
+        std::cout << "\nHardware counters unavailable: " << result.hardware_counter_error << std::endl;
     }
     
     std::cout << "\n===================================================" << std::endl;
@@ -96,7 +175,11 @@ void ExportToCSV(const ProfilingResult& result, const std::string& filename) {
     }
     
     // 写入CSV头部
-    file << "Node Name,Op Type,Execution Time (ms),Memory Used (bytes),Time %\n";
+    file << "Node Name,Op Type,Execution Time (ms),Memory Used (bytes),Time %,FLOPs,Bytes";
+    if (result.hardware_counters) {
+        file << ",Cycles,Instructions,LLC References,LLC Misses,FP Ops";
+    }
+    file << "\n";
     
     // 写入数据
     for (const auto& profile : result.node_profiles) {
@@ -107,7 +190,15 @@ void ExportToCSV(const ProfilingResult& result, const std::string& filename) {
              << profile.op_type << ","
              << profile.execution_time_ms << ","
              << profile.memory_used_bytes << ","
-             << time_percent << "\n";
+             << time_percent << ","
+             << NodeFlops(result, profile) << ","
+             << NodeBytes(result, profile);
+        if (result.hardware_counters) {
+            const HardwareCounterValues& values = profile.counters;
+            file << "," << values.cycles << "," << values.instructions << "," << values.llc_references
+                 << "," << values.llc_misses << "," << values.fp_ops;
+        }
+        file << "\n";
     }
     
     file.close();
@@ -121,13 +212,24 @@ int main(int argc, char* argv[]) {
         std::cerr << "  -v, --verbose     Show detailed node-by-node breakdown" << std::endl;
         std::cerr << "  -o, --output FILE Export results to CSV file" << std::endl;
         std::cerr << "  -i, --iterations N Number of profiling iterations (default: 10)" << std::endl;
+        std::cerr << "  -t, --trace PREFIX Write a Chrome trace (PREFIX_<time>.json, viewable in Perfetto)" << std::endl;
+        std::cerr << "  -c, --counters    Collect per-node hardware counters (Linux perf_event)" << std::endl;
+        std::cerr << "  --peak-gflops X   Peak compute for the roofline (default: estimated from CPU features)" << std::endl;
+        std::cerr << "  --peak-gbps X     Peak memory bandwidth for the roofline (default: measured copy bandwidth)" << std::endl;
+        std::cerr << "  --cpu-ghz X       Clock used for the peak compute estimate (default: 3.0)" << std::endl;
+        std::cerr << "  --machine-profile FILE Roofline peaks measured by inferunity_calibrate" << std::endl;
         return 1;
     }
     
     std::string model_path = argv[1];
     bool verbose = false;
     std::string output_file;
+    std::string trace_prefix;
     int iterations = 10;
+    bool hardware_counters = false;
+    RooflinePeaks peaks;
+    double cpu_ghz = 3.0;
+    std::string machine_profile;
     
     // 解析命令行参数
     for (int i = 2; i < argc; ++i) {
@@ -138,6 +240,28 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 output_file = argv[++i];
             }
+        } else if (arg == "-t" || arg == "--trace") {
+            if (i + 1 < argc) {
+                trace_prefix = argv[++i];
+            }
+        } else if (arg == "-c" || arg == "--counters") {
+            hardware_counters = true;
+        } else if (arg == "--peak-gflops") {
+            if (i + 1 < argc) {
+                peaks.peak_gflops = std::stod(argv[++i]);
+            }
+        } else if (arg == "--peak-gbps") {
+            if (i + 1 < argc) {
+                peaks.peak_gbps = std::stod(argv[++i]);
+            }
+        } else if (arg == "--cpu-ghz") {
+            if (i + 1 < argc) {
+                cpu_ghz = std::stod(argv[++i]);
+            }
+        } else if (arg == "--machine-profile") {
+            if (i + 1 < argc) {
+                machine_profile = argv[++i];
+            }
         } else if (arg == "-i" || arg == "--iterations") {
             if (i + 1 < argc) {
                 iterations = std::stoi(argv[++i]);
@@ -155,6 +279,10 @@ int main(int argc, char* argv[]) {
     options.execution_providers = {"CPUExecutionProvider"};
     options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::ALL;
     options.enable_profiling = true;
+    options.profile_hardware_counters = hardware_counters;
+    if (!trace_prefix.empty()) {
+        options.profile_file_prefix = trace_prefix;
+    }
     
     auto session = InferenceSession::Create(options);
     if (!session) {
@@ -231,6 +359,7 @@ int main(int argc, char* argv[]) {
                             j < result.node_profiles.size(); ++j) {
                 aggregated_result.node_profiles[j].execution_time_ms += 
                     result.node_profiles[j].execution_time_ms;
+                aggregated_result.node_profiles[j].counters += result.node_profiles[j].counters;
             }
         }
     }
@@ -239,16 +368,56 @@ int main(int argc, char* argv[]) {
     aggregated_result.total_time_ms /= iterations;
     for (auto& profile : aggregated_result.node_profiles) {
         profile.execution_time_ms /= iterations;
+        HardwareCounterValues& values = profile.counters;
+        values.cycles /= iterations;
+        values.instructions /= iterations;
+        values.llc_references /= iterations;
+        values.llc_misses /= iterations;
+        values.fp_ops /= iterations;
+    }
+    
+    // 校准得到的峰值优先于估计值，命令行显式给出的峰值不被覆盖
+    if (!machine_profile.empty()) {
+        Status profile_status = LoadMachineProfile(machine_profile);
+        if (!profile_status.IsOk()) {
+            std::cerr << "Failed to load machine profile: " << profile_status.Message() << std::endl;
+            return 1;
+        }
+        MachineProfile profile;
+        GetMachineProfile(&profile);
+        const RooflinePeaks measured = profile.GetRooflinePeaks();
+        if (peaks.peak_gflops <= 0) {
+            peaks.peak_gflops = measured.peak_gflops;
+        }
+        if (peaks.peak_gbps <= 0) {
+            peaks.peak_gbps = measured.peak_gbps;
+        }
+    }
+    if (peaks.peak_gflops <= 0) {
+        peaks.peak_gflops = EstimatePeakGflops(cpu_ghz);
+    }
+    if (peaks.peak_gbps <= 0) {
+        peaks.peak_gbps = MeasureMemoryBandwidthGbps();
     }
     
     // 打印结果
-    PrintProfilingResults(aggregated_result, verbose);
+    PrintProfilingResults(aggregated_result, verbose, peaks);
     
     // 导出CSV
     if (!output_file.empty()) {
         ExportToCSV(aggregated_result, output_file);
     }
     
+    // 分层追踪：加载、优化Pass、内存规划、warmup与各次分析运行的逐节点/逐线程事件
+    if (!trace_prefix.empty()) {
+        const std::string trace_file = session->EndProfiling();
+        if (trace_file.empty()) {
+            std::cerr << "Failed to write trace" << std::endl;
+        } else {
+            std::cout << "Chrome trace written to: " << trace_file << std::endl;
+        }
+    }
+    
     return 0;
 }
 
@@ -0,0 +1,135 @@
+// 推理服务（KServe v2 HTTP协议，见inferunity/server.h）
+// 加载一个或多个模型后在同一端口提供推理、健康检查、模型元数据与/metrics，收到SIGINT/SIGTERM时停止
+
+#include "inferunity/engine.h"
+#include "inferunity/server.h"
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+using namespace inferunity;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " --model [NAME=]PATH [--model ...] [options]" << std::endl;
+        std::cerr << "Options:" << std::endl;
+        std::cerr << "  -m, --model [NAME=]PATH  Serve a model (name defaults to the file name without extension)" << std::endl;
+        std::cerr << "  --host HOST              Address to listen on (default: 0.0.0.0)" << std::endl;
+        std::cerr << "  -p, --port N             Port to listen on (default: 8000)" << std::endl;
+        std::cerr << "  --io-threads N           Event loop threads (default: 1)" << std::endl;
+        std::cerr << "  --batching               Route requests through the dynamic batcher" << std::endl;
+        std::cerr << "  --max-batch-size N       Dynamic batch size limit (default: session max_batch_size)" << std::endl;
+        std::cerr << "  --max-delay-us N         Longest a request waits for a batch to fill (default: 1000)" << std::endl;
+        std::cerr << "  --timeout-us N           Default request timeout, 0 for none (default: 0)" << std::endl;
+        std::cerr << "  --admission-control      Reject requests predicted to miss their deadline" << std::endl;
+        std::cerr << "  --no-metrics             Do not serve /metrics" << std::endl;
+        return 1;
+    }
+
+    ServerOptions server_options;
+    ServedModelOptions model_options;
+    bool admission_control = false;
+    std::vector<std::pair<std::string, std::string>> models;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-m" || arg == "--model") && i + 1 < argc) {
+            std::string spec = argv[++i];
+            std::string name;
+            const size_t equals = spec.find('=');
+            if (equals != std::string::npos) {
+                name = spec.substr(0, equals);
+                spec = spec.substr(equals + 1);
+            } else {
+                const size_t slash = spec.find_last_of('/');
+                name = slash == std::string::npos ? spec : spec.substr(slash + 1);
+                const size_t dot = name.find_last_of('.');
+                if (dot != std::string::npos && dot > 0) {
+                    name.resize(dot);
+                }
+            }
+            models.emplace_back(name, spec);
+        } else if (arg == "--host" && i + 1 < argc) {
+            server_options.host = argv[++i];
+        } else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            server_options.port = std::stoi(argv[++i]);
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            server_options.num_io_threads = std::stoi(argv[++i]);
+        } else if (arg == "--batching") {
+            model_options.dynamic_batching = true;
+        } else if (arg == "--max-batch-size" && i + 1 < argc) {
+            model_options.batching.max_batch_size = std::stoi(argv[++i]);
+        } else if (arg == "--max-delay-us" && i + 1 < argc) {
+            model_options.batching.max_delay_us = std::stoll(argv[++i]);
+        } else if (arg == "--timeout-us" && i + 1 < argc) {
+            server_options.default_timeout_us = std::stoll(argv[++i]);
+        } else if (arg == "--admission-control") {
+            admission_control = true;
+        } else if (arg == "--no-metrics") {
+            server_options.expose_metrics = false;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (models.empty()) {
+        std::cerr << "No model given" << std::endl;
+        return 1;
+    }
+
+    // 创建会话
+    SessionOptions session_options;
+    session_options.execution_providers = {"CPUExecutionProvider"};
+    session_options.graph_optimization_level = SessionOptions::GraphOptimizationLevel::ALL;
+    session_options.enable_admission_control = admission_control;
+
+    InferenceServer server(server_options);
+    std::vector<std::unique_ptr<InferenceSession>> sessions;
+    for (const auto& model : models) {
+        auto session = InferenceSession::Create(session_options);
+        if (!session) {
+            std::cerr << "Failed to create inference session" << std::endl;
+            return 1;
+        }
+        Status status = session->LoadModel(model.second);
+        if (!status.IsOk()) {
+            std::cerr << "Failed to load model " << model.second << ": " << status.Message() << std::endl;
+            return 1;
+        }
+        status = server.AddModel(model.first, session.get(), model_options);
+        if (!status.IsOk()) {
+            std::cerr << "Failed to add model " << model.first << ": " << status.Message() << std::endl;
+            return 1;
+        }
+        std::cout << "Model " << model.first << ": " << model.second << std::endl;
+        sessions.push_back(std::move(session));
+    }
+
+    // 事件循环与运行时线程继承信号掩码，SIGINT/SIGTERM只由主线程的sigwait接收
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Status status = server.Start();
+    if (!status.IsOk()) {
+        std::cerr << "Failed to start server: " << status.Message() << std::endl;
+        return 1;
+    }
+    std::cout << "Listening on " << server_options.host << ":" << server.GetPort() << std::endl;
+
+    int received = 0;
+    sigwait(&signals, &received);
+    std::cout << "Shutting down" << std::endl;
+    server.Stop();
+
+    const ServerStats stats = server.GetStats();
+    std::cout << "Served " << stats.infer_requests << " inference requests (" << stats.infer_failures
+              << " failed) on " << stats.connections << " connections" << std::endl;
+    return 0;
+}